@@ -132,11 +132,24 @@ typedef struct {
 	uintptr_t dstarg;
 } irq_cmd_t;
 
+/** Merge an interrupt into a notification which has not been received yet.
+ *
+ * The payload arguments of the merged interrupts are ORed together and the
+ * notification counter is advanced, so the receiver can tell how many
+ * interrupts a single notification stands for.
+ */
+#define IRQ_CODE_COALESCE  (1 << 0)
+
+/** Any CPU may service the interrupt. */
+#define IRQ_CPU_ANY  ((unsigned int) -1)
+
 typedef struct {
 	size_t rangecount;
 	irq_pio_range_t *ranges;
 	size_t cmdcount;
 	irq_cmd_t *cmds;
+	/** IRQ_CODE_* flags. */
+	unsigned int flags;
 } irq_code_t;
 
 #endif
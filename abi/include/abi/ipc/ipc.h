@@ -52,6 +52,9 @@ enum {
 	/** Maximum active async calls per phone */
 	IPC_MAX_ASYNC_CALLS = 64,
 
+	/** Maximum number of calls received or answered by one batch syscall */
+	IPC_MAX_BATCH = 32,
+
 	/**
 	 * Maximum buffer size allowed for IPC_M_DATA_WRITE and
 	 * IPC_M_DATA_READ requests.
@@ -214,6 +214,17 @@ enum {
 	 * - other arguments are specific to the debug method
 	 */
 	IPC_M_DEBUG,
+
+	/** Signal the peer of a shared-memory ring channel.
+	 *
+	 * The ring itself is an address space area shared by the client
+	 * using IPC_M_SHARE_OUT. Requests and answers are exchanged through
+	 * the shared area and this method is only used to wake up a peer
+	 * which went to sleep. The kernel does not interpret the arguments.
+	 *
+	 * - ARG1 - ring operation (kick the server or arm the client wakeup)
+	 */
+	IPC_M_RING,
 };
 
 /** Last system IPC method */
@@ -57,6 +57,14 @@ typedef enum {
 	Lingering
 } state_t;
 
+/** Thread scheduling classes */
+typedef enum {
+	/** Time-sharing threads, prioritized by their sleep/run history. */
+	SCHED_CLASS_TS,
+	/** Real-time threads, run in FIFO order before time-sharing threads. */
+	SCHED_CLASS_FIFO
+} sched_class_t;
+
 #endif
 
 /** @}
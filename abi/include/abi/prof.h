@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup abi_generic
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _ABI_PROF_H_
+#define _ABI_PROF_H_
+
+#include <stdint.h>
+#include <abi/proc/task.h>
+#include <abi/proc/thread.h>
+
+/** Maximum number of program counters recorded in a sample */
+#define PROF_STACK_DEPTH  16
+
+typedef enum {
+	/** Start sampling every @c arg clock ticks */
+	PROF_START,
+	/** Stop sampling and discard samples which were not read */
+	PROF_STOP,
+	/** Read and remove samples from the buffers */
+	PROF_READ,
+	/** Look up the kernel symbol containing address @c arg */
+	PROF_SYMBOL
+} prof_operation_t;
+
+/** Sample flags */
+typedef enum {
+	/** The processor was idle, no thread was running */
+	PROF_SAMPLE_IDLE = 1 << 0,
+	/** The thread was interrupted in userspace */
+	PROF_SAMPLE_USPACE = 1 << 1
+} prof_sample_flags_t;
+
+/** A single profiler sample
+ *
+ * The first program counter is the interrupted one, the others are
+ * return addresses of the calling functions. Only the interrupted
+ * program counter is recorded for userspace samples.
+ *
+ */
+typedef struct {
+	task_id_t task_id;               /**< Interrupted task */
+	thread_id_t thread_id;           /**< Interrupted thread */
+	uint32_t cpu;                    /**< Processor ID */
+	uint32_t flags;                  /**< Sample flags */
+	uint32_t depth;                  /**< Number of valid entries in pcs */
+	uint64_t pcs[PROF_STACK_DEPTH];  /**< Program counters */
+} prof_sample_t;
+
+#endif
+
+/** @}
+ */
@@ -54,7 +54,11 @@ typedef enum {
 	SYS_TASK_SET_NAME,
 	SYS_TASK_KILL,
 	SYS_TASK_EXIT,
+	SYS_TASK_SET_SCHED_CLASS,
+	SYS_CPUSET_SET,
+	SYS_CPUSET_GET,
 	SYS_PROGRAM_SPAWN_LOADER,
+	SYS_PROGRAM_CLONE,
 
 	SYS_WAITQ_CREATE,
 	SYS_WAITQ_SLEEP,
@@ -74,9 +78,11 @@ typedef enum {
 	SYS_IPC_CALL_ASYNC_SLOW,
 	SYS_IPC_ANSWER_FAST,
 	SYS_IPC_ANSWER_SLOW,
+	SYS_IPC_ANSWER_BATCH,
 	SYS_IPC_FORWARD_FAST,
 	SYS_IPC_FORWARD_SLOW,
 	SYS_IPC_WAIT,
+	SYS_IPC_WAIT_BATCH,
 	SYS_IPC_POKE,
 	SYS_IPC_HANGUP,
 	SYS_IPC_CONNECT_KBOX,
@@ -97,6 +103,7 @@ typedef enum {
 
 	SYS_IPC_IRQ_SUBSCRIBE,
 	SYS_IPC_IRQ_UNSUBSCRIBE,
+	SYS_IPC_IRQ_SET_AFFINITY,
 
 	SYS_SYSINFO_GET_KEYS_SIZE,
 	SYS_SYSINFO_GET_KEYS,
@@ -107,7 +114,13 @@ typedef enum {
 
 	SYS_DEBUG_CONSOLE,
 
-	SYS_KLOG
+	SYS_KLOG,
+
+	SYS_PROF,
+
+	SYS_ENTROPY_GET,
+
+	SYSCALL_END
 } syscall_t;
 
 #endif
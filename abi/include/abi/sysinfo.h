@@ -39,7 +39,9 @@
 #include <stdbool.h>
 #include <abi/proc/task.h>
 #include <abi/proc/thread.h>
+#include <abi/syscall.h>
 #include <stdint.h>
+#include <_bits/native.h>
 
 enum {
 	/** Number of load components */
@@ -48,6 +50,8 @@ enum {
 	/** Maximum name sizes */
 	TASK_NAME_BUFLEN = 64,
 	EXC_NAME_BUFLEN  = 20,
+	SLAB_NAME_BUFLEN = 32,
+	LOCK_NAME_BUFLEN = 48,
 };
 
 /** Item value type
@@ -61,6 +65,15 @@ typedef enum {
 	SYSINFO_VAL_FUNCTION_DATA = 4  /**< Generated binary data */
 } sysinfo_item_val_type_t;
 
+/** Number of buckets in the TLB shootdown latency histogram
+ *
+ * Bucket 0 counts shootdowns which took less than 1024 cycles,
+ * each following bucket covers four times as many cycles as the
+ * previous one and the last bucket counts all slower shootdowns.
+ *
+ */
+#define STATS_TLB_LATENCY_BUCKETS  8
+
 /** Statistics about a single CPU
  *
  */
@@ -70,6 +83,18 @@ typedef struct {
 	uint16_t frequency_mhz;  /**< Frequency in MHz */
 	uint64_t idle_cycles;    /**< Number of idle cycles */
 	uint64_t busy_cycles;    /**< Number of busy cycles */
+	uint64_t sched_count;    /**< Number of scheduler thread selections */
+	uint64_t sched_cycles;   /**< Cycles spent selecting threads */
+	uint64_t steals;         /**< Threads stolen by the idle CPU */
+	uint64_t steals_failed;  /**< Failed attempts to steal a thread */
+	uint64_t migrations;     /**< Threads migrated by load balancing */
+	uint64_t tick_stops;     /**< Idle periods without the clock tick */
+	uint64_t tlb_shootdowns; /**< TLB shootdowns initiated */
+	uint64_t tlb_ipis;       /**< TLB shootdown IPIs received */
+	uint64_t tlb_lazy;       /**< TLB shootdowns deferred until AS switch */
+
+	/** Histogram of IPI acknowledgement latencies of initiated shootdowns */
+	uint64_t tlb_latency[STATS_TLB_LATENCY_BUCKETS];
 } stats_cpu_t;
 
 /** Physical memory statistics
@@ -94,6 +119,10 @@ typedef struct {
 	uint64_t answer_received;     /**< IPC answers received */
 	uint64_t irq_notif_received;  /**< IPC IRQ notifications */
 	uint64_t forwarded;           /**< IPC messages forwarded */
+	uint64_t data_written;        /**< Bytes sent by IPC_M_DATA_WRITE */
+	uint64_t data_written_pinned; /**< ... of which without a bounce buffer */
+	uint64_t data_read;           /**< Bytes sent in IPC_M_DATA_READ answers */
+	uint64_t data_read_pinned;    /**< ... of which without a bounce buffer */
 } stats_ipc_t;
 
 /** Statistics about a single task
@@ -104,12 +133,63 @@ typedef struct {
 	char name[TASK_NAME_BUFLEN];  /**< Task name (in kernel) */
 	size_t virtmem;               /**< Size of VAS (bytes) */
 	size_t resmem;                /**< Size of resident (used) memory (bytes) */
+	size_t large_pages;           /**< Number of large pages mapped */
+	uint64_t page_faults;         /**< Number of serviced page faults */
+	uint64_t fault_around;        /**< Pages mapped ahead of page faults */
 	size_t threads;               /**< Number of threads */
 	uint64_t ucycles;             /**< Number of CPU cycles in user space */
 	uint64_t kcycles;             /**< Number of CPU cycles in kernel */
 	stats_ipc_t ipc_info;         /**< IPC statistics */
 } stats_task_t;
 
+/** Number of interface slots in the IPC profile of a task */
+#define STATS_IPC_PROF_IFACES  16
+
+/** Number of answer latency histogram buckets */
+#define STATS_IPC_PROF_LATENCIES  20
+
+/** Upper bound of the first latency bucket (log2 of CPU cycles) */
+#define STATS_IPC_PROF_LATENCY_SHIFT  10
+
+/** IPC profile of a single interface
+ *
+ * Slot 0 of the task profile collects calls on phones
+ * without a known interface and calls on interfaces
+ * which did not fit into the other slots.
+ *
+ */
+typedef struct {
+	uint32_t iface;            /**< Interface (0 for slot 0) */
+	uint64_t calls;            /**< Calls sent */
+	uint64_t answers;          /**< Answers received */
+	uint64_t bytes;            /**< Bytes moved by data transfers */
+	uint64_t latency;          /**< Total answer latency (cycles) */
+
+	/**
+	 * Answer latency histogram. Bucket i counts answers which took
+	 * less than 2^(STATS_IPC_PROF_LATENCY_SHIFT + i) cycles,
+	 * the last bucket counts all slower answers.
+	 */
+	uint64_t latencies[STATS_IPC_PROF_LATENCIES];
+} stats_ipc_iface_t;
+
+/** Profile of a single syscall
+ *
+ */
+typedef struct {
+	uint64_t count;   /**< Number of invocations */
+	uint64_t cycles;  /**< CPU cycles spent in the syscall (including sleep) */
+} stats_syscall_t;
+
+/** IPC and syscall profile of a single task
+ *
+ */
+typedef struct {
+	task_id_t task_id;                                /**< Task ID */
+	stats_ipc_iface_t ifaces[STATS_IPC_PROF_IFACES];  /**< Interfaces */
+	stats_syscall_t syscalls[SYSCALL_END];            /**< Syscalls */
+} stats_task_ipc_t;
+
 /** Statistics about a single thread
  *
  */
@@ -120,6 +200,12 @@ typedef struct {
 	int priority;           /**< Thread priority */
 	uint64_t ucycles;       /**< Number of CPU cycles in user space */
 	uint64_t kcycles;       /**< Number of CPU cycles in kernel */
+	uint64_t rqcycles;      /**< Cycles spent ready in a run queue */
+	uint64_t ipc_cycles;    /**< Cycles spent blocked in IPC */
+	uint64_t futex_cycles;  /**< Cycles spent blocked on futexes */
+	uint64_t sleep_cycles;  /**< Cycles spent blocked otherwise */
+	uint64_t vcsw;          /**< Voluntary context switches */
+	uint64_t ivcsw;         /**< Involuntary context switches */
 	bool on_cpu;            /**< Associated with a CPU */
 	unsigned int cpu;       /**< Associated CPU ID (if on_cpu is true) */
 } stats_thread_t;
@@ -132,6 +218,18 @@ typedef struct {
 	task_id_t callee;  /**< Target task ID */
 } stats_ipcc_t;
 
+/** Statistics about a single IRQ subscription
+ *
+ */
+typedef struct {
+	task_id_t task;      /**< Subscribed task ID */
+	int inr;             /**< IRQ number */
+	unsigned int cpu;    /**< Routing CPU ID or IRQ_CPU_ANY */
+	uint64_t count;      /**< Number of accepted interrupts */
+	uint64_t coalesced;  /**< Interrupts merged into queued notifications */
+	uint64_t dropped;    /**< Notifications lost for lack of memory */
+} stats_irq_t;
+
 /** Statistics about a single exception
  *
  */
@@ -143,9 +241,76 @@ typedef struct {
 	uint64_t count;              /**< Number of handled exceptions */
 } stats_exc_t;
 
+/** Slab cache statistics
+ *
+ */
+typedef struct {
+	char name[SLAB_NAME_BUFLEN];  /**< Cache name */
+	size_t size;                  /**< Object size */
+	size_t slabs;                 /**< Number of allocated slabs */
+	size_t allocated;             /**< Number of allocated objects */
+	size_t cached;                /**< Number of objects in magazines */
+	size_t mag_size;              /**< Current magazine size */
+	uint64_t hits;                /**< Allocations served by magazines */
+	uint64_t misses;              /**< Allocations served by slabs */
+	uint64_t depot_accesses;      /**< Accesses to the magazine depot */
+	uint64_t depot_contention;    /**< Contended depot accesses */
+} stats_slab_t;
+
+/** Lock class kind
+ *
+ */
+typedef enum {
+	STATS_LOCK_SPINLOCK,
+	STATS_LOCK_MUTEX,
+	STATS_LOCK_WAITQ,
+	STATS_LOCK_KINDS
+} stats_lock_kind_t;
+
+/** Lock class statistics
+ *
+ * Spinlock classes are identified by the name of the lock, mutex and
+ * wait queue classes by the code location which initialized them.
+ *
+ */
+typedef struct {
+	char name[LOCK_NAME_BUFLEN];  /**< Class name */
+	stats_lock_kind_t kind;       /**< Class kind */
+	uint64_t acquired;            /**< Number of acquisitions */
+	uint64_t contended;           /**< Acquisitions which had to wait */
+	uint64_t wait_cycles;         /**< Cycles spent waiting */
+	uint64_t hold_cycles;         /**< Cycles the lock was held */
+} stats_lock_t;
+
 /** Load fixed-point value */
 typedef uint32_t load_t;
 
+/** Header of thread statistics changed since a generation
+ *
+ * Followed by @c count stats_thread_t structures.
+ *
+ */
+typedef struct {
+	uint64_t generation;  /**< Generation to ask for next time */
+	uint64_t count;       /**< Number of threads following */
+	bool full;            /**< All threads are included */
+} stats_delta_t;
+
+/** Read-only statistics page
+ *
+ * The page can be mapped by physmem_map() using the physical
+ * address from the "system.stats.faddr" sysinfo item. The values
+ * are updated by the kernel without any synchronization with the
+ * readers.
+ *
+ */
+typedef struct {
+	sysarg_t tasks;           /**< Number of tasks */
+	sysarg_t threads;         /**< Number of threads */
+	sysarg_t ready;           /**< Number of ready threads (sampled) */
+	load_t load[LOAD_STEPS];  /**< System load (sampled) */
+} stats_page_t;
+
 #endif
 
 /** @}
@@ -150,7 +150,25 @@ typedef enum { /* udebug_method_t */
 	 * - ARG4 - size of receiving buffer in bytes
 	 *
 	 */
-	UDEBUG_M_MEM_READ
+	UDEBUG_M_MEM_READ,
+
+	/** Take a snapshot of an address space area of the debugged task.
+	 *
+	 * The area is copied and the copy is mapped read-only into the
+	 * caller's address space. The snapshot stays valid after the
+	 * debugged task is resumed or the session is ended. The caller
+	 * unmaps it with as_area_destroy().
+	 *
+	 * - ARG2 - base address of the area in the recipient's address space
+	 * - ARG3 - size of the area in bytes
+	 * - ARG4 - lowest address bound for the snapshot in the caller's
+	 *          address space
+	 *
+	 * Returns:
+	 * - ARG1 - base address of the snapshot in the caller's address space
+	 *
+	 */
+	UDEBUG_M_MEM_SNAPSHOT
 } udebug_method_t;
 
 typedef enum {
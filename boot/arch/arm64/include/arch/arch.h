@@ -42,7 +42,13 @@
 #define BOOT_OFFSET  0x80000
 
 #ifndef __ASSEMBLER__
+#include <arch/regutils.h>
+
 #define KA2PA(x)  (((uintptr_t) (x)) - UINT64_C(0xffffffff00000000))
+
+/** Microseconds from the generic timer, used for boot time statistics */
+#define ARCH_TIMER_USEC() \
+	(CNTVCT_EL0_read() * 1000000 / CNTFRQ_EL0_read())
 #endif
 
 #endif
@@ -29,8 +29,9 @@
 #ifndef BOOT_INFLATE_H_
 #define BOOT_INFLATE_H_
 
+#include <errno.h>
 #include <stddef.h>
 
-extern int inflate(const void *, size_t, void *, size_t);
+extern errno_t inflate(const void *, size_t, void *, size_t);
 
 #endif
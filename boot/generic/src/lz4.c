@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file
+ * @brief LZ4 frame decompression
+ *
+ * Decoder for the LZ4 frame format. LZ4 trades compression ratio for
+ * decompression speed: the data is a sequence of literal runs and
+ * byte-aligned back-references, so expanding it is little more than
+ * a series of memory copies.
+ *
+ * The frame must carry the content size (lz4 --content-size), since the
+ * boot loader needs to know where to place the next component before
+ * expanding this one. Checksums are skipped, just like the gzip CRC.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+#include <memstr.h>
+#include <lz4.h>
+
+#define LZ4_MAGIC  UINT32_C(0x184d2204)
+
+#define LZ4_FLG_VERSION_MASK    UINT8_C(0xc0)
+#define LZ4_FLG_VERSION         UINT8_C(0x40)
+#define LZ4_FLG_BLOCK_CHECKSUM  UINT8_C(1 << 4)
+#define LZ4_FLG_CONTENT_SIZE    UINT8_C(1 << 3)
+#define LZ4_FLG_DICT_ID         UINT8_C(1 << 0)
+
+/** Block size field flag marking an uncompressed block */
+#define LZ4_BLOCK_UNCOMPRESSED  UINT32_C(0x80000000)
+
+/** Shortest match */
+#define LZ4_MIN_MATCH  4
+
+/** Size of magic, FLG, BD, content size and header checksum */
+#define LZ4_HEADER_SIZE  15
+
+static uint32_t get_le32(const uint8_t *p)
+{
+	return (uint32_t) p[0] | ((uint32_t) p[1] << 8) |
+	    ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint64_t get_le64(const uint8_t *p)
+{
+	return (uint64_t) get_le32(p) | ((uint64_t) get_le32(p + 4) << 32);
+}
+
+/** Check LZ4 frame signature
+ *
+ * Checks whether the source buffer starts with an LZ4 frame header
+ * that carries the content size.
+ *
+ * @param[in] src    Source data buffer.
+ * @param[in] srclen Source buffer size (bytes).
+ *
+ * @return True if a usable LZ4 frame header was found.
+ *
+ */
+bool lz4_check(const void *src, size_t srclen)
+{
+	const uint8_t *p = src;
+
+	if (srclen < LZ4_HEADER_SIZE)
+		return false;
+
+	if (get_le32(p) != LZ4_MAGIC)
+		return false;
+
+	if ((p[4] & LZ4_FLG_VERSION_MASK) != LZ4_FLG_VERSION)
+		return false;
+
+	if ((p[4] & LZ4_FLG_CONTENT_SIZE) == 0)
+		return false;
+
+	return true;
+}
+
+/** Get uncompressed size
+ *
+ * The size is read from the frame header, so (as with gzip) the source
+ * needs to be trusted.
+ *
+ * @param[in] src    Source data buffer.
+ * @param[in] srclen Source buffer size (bytes).
+ *
+ * @return Uncompressed size.
+ *
+ */
+size_t lz4_size(const void *src, size_t srclen)
+{
+	if (!lz4_check(src, srclen))
+		return 0;
+
+	return (size_t) get_le64((const uint8_t *) src + 6);
+}
+
+/** Read an LZ4 length extension
+ *
+ * @param[in,out] src    Position in the block.
+ * @param[in]     end    End of the block.
+ * @param[in,out] len    Length to extend.
+ *
+ * @return True on success, false if the block ends prematurely.
+ *
+ */
+static bool lz4_ext_len(const uint8_t **src, const uint8_t *end, size_t *len)
+{
+	uint8_t b;
+
+	do {
+		if (*src >= end)
+			return false;
+
+		b = *(*src)++;
+		*len += b;
+	} while (b == 255);
+
+	return true;
+}
+
+/** Decode one compressed block
+ *
+ * Matches may reach back into blocks decoded before, since the whole
+ * output is kept in the destination buffer.
+ *
+ * @param[in]     src    Block data.
+ * @param[in]     srclen Block size (bytes).
+ * @param[in]     dest   Start of the destination buffer.
+ * @param[in,out] pos    Position in the destination buffer.
+ * @param[in]     destlen Destination buffer size (bytes).
+ *
+ * @return EOK on success.
+ * @return ENOENT on offset too large.
+ * @return ELIMIT on input buffer overrun.
+ * @return ENOMEM on output buffer overrun.
+ *
+ */
+static int lz4_block(const uint8_t *src, size_t srclen, uint8_t *dest,
+    size_t *pos, size_t destlen)
+{
+	const uint8_t *end = src + srclen;
+	uint8_t *out = dest + *pos;
+	uint8_t *out_end = dest + destlen;
+
+	while (src < end) {
+		uint8_t token = *src++;
+
+		/* Literals */
+		size_t len = token >> 4;
+		if ((len == 15) && (!lz4_ext_len(&src, end, &len)))
+			return ELIMIT;
+
+		if (len > (size_t) (end - src))
+			return ELIMIT;
+
+		if (len > (size_t) (out_end - out))
+			return ENOMEM;
+
+		memcpy(out, src, len);
+		out += len;
+		src += len;
+
+		/* The last sequence has no match */
+		if (src == end)
+			break;
+
+		/* Match */
+		if (end - src < 2)
+			return ELIMIT;
+
+		size_t offset = src[0] | (src[1] << 8);
+		src += 2;
+
+		if ((offset == 0) || (offset > (size_t) (out - dest)))
+			return ENOENT;
+
+		len = token & 0x0f;
+		if ((len == 15) && (!lz4_ext_len(&src, end, &len)))
+			return ELIMIT;
+
+		len += LZ4_MIN_MATCH;
+		if (len > (size_t) (out_end - out))
+			return ENOMEM;
+
+		const uint8_t *from = out - offset;
+		if (offset >= len) {
+			memcpy(out, from, len);
+			out += len;
+		} else {
+			/* Overlapping copy repeats the pattern */
+			while (len-- > 0)
+				*out++ = *from++;
+		}
+	}
+
+	*pos = out - dest;
+	return EOK;
+}
+
+/** Expand LZ4 compressed data
+ *
+ * @param[in]  src     Source data buffer.
+ * @param[in]  srclen  Source buffer size (bytes).
+ * @param[out] dest    Destination data buffer.
+ * @param[out] destlen Destination buffer size (bytes).
+ *
+ * @return EOK on success.
+ * @return ENOENT on offset too large.
+ * @return EINVAL on invalid frame.
+ * @return ELIMIT on input buffer overrun.
+ * @return ENOMEM on output buffer overrun.
+ *
+ */
+int lz4_expand(const void *src, size_t srclen, void *dest, size_t destlen)
+{
+	const uint8_t *p = src;
+	const uint8_t *end = p + srclen;
+	size_t pos = 0;
+
+	if (!lz4_check(src, srclen))
+		return EINVAL;
+
+	if (destlen != lz4_size(src, srclen))
+		return EINVAL;
+
+	uint8_t flg = p[4];
+	p += LZ4_HEADER_SIZE;
+
+	if ((flg & LZ4_FLG_DICT_ID) != 0) {
+		/* Dictionaries are not supported */
+		return EINVAL;
+	}
+
+	while (true) {
+		if (end - p < 4)
+			return ELIMIT;
+
+		uint32_t bsize = get_le32(p);
+		p += 4;
+
+		if (bsize == 0)
+			break;
+
+		bool uncompressed = (bsize & LZ4_BLOCK_UNCOMPRESSED) != 0;
+		bsize &= ~LZ4_BLOCK_UNCOMPRESSED;
+
+		if (bsize > (size_t) (end - p))
+			return ELIMIT;
+
+		if (uncompressed) {
+			if (bsize > destlen - pos)
+				return ENOMEM;
+
+			memcpy((uint8_t *) dest + pos, p, bsize);
+			pos += bsize;
+		} else {
+			int rc = lz4_block(p, bsize, dest, &pos, destlen);
+			if (rc != EOK)
+				return rc;
+		}
+
+		p += bsize;
+
+		if ((flg & LZ4_FLG_BLOCK_CHECKSUM) != 0) {
+			if (end - p < 4)
+				return ELIMIT;
+
+			p += 4;
+		}
+	}
+
+	if (pos != destlen)
+		return EINVAL;
+
+	return EOK;
+}
@@ -34,6 +34,7 @@
 #include <arch/arch.h>
 #include <tar.h>
 #include <gzip.h>
+#include <lz4.h>
 #include <stdbool.h>
 #include <memstr.h>
 #include <errno.h>
@@ -60,10 +61,45 @@ static const char *ext(const char *s)
 static void basename(char *s)
 {
 	char *e = (char *) ext(s);
-	if ((e != NULL) && (str_cmp(e, ".gz") == 0))
+	if ((e != NULL) &&
+	    ((str_cmp(e, ".gz") == 0) || (str_cmp(e, ".lz4") == 0)))
 		*e = '\0';
 }
 
+/** Component compression format */
+typedef enum {
+	/** Stored as is */
+	cf_none,
+	/** gzip */
+	cf_gzip,
+	/** LZ4 frame */
+	cf_lz4
+} comp_format_t;
+
+static comp_format_t comp_format(const uint8_t *data, size_t packed_size)
+{
+	if (gzip_check(data, packed_size))
+		return cf_gzip;
+
+	if (lz4_check(data, packed_size))
+		return cf_lz4;
+
+	return cf_none;
+}
+
+static size_t comp_size(comp_format_t format, const uint8_t *data,
+    size_t packed_size)
+{
+	switch (format) {
+	case cf_gzip:
+		return gzip_size(data, packed_size);
+	case cf_lz4:
+		return lz4_size(data, packed_size);
+	default:
+		return packed_size;
+	}
+}
+
 static bool overlaps(uint8_t *start1, uint8_t *end1,
     uint8_t *start2, uint8_t *end2)
 {
@@ -83,8 +119,8 @@ static bool extract_component(uint8_t **cstart, uint8_t *cend,
 	const uint8_t *data = *cstart + TAR_BLOCK_SIZE;
 	*cstart += TAR_BLOCK_SIZE + ALIGN_UP(packed_size, TAR_BLOCK_SIZE);
 
-	bool gz = gzip_check(data, packed_size);
-	size_t unpacked_size = gz ? gzip_size(data, packed_size) : packed_size;
+	comp_format_t format = comp_format(data, packed_size);
+	size_t unpacked_size = comp_size(format, data, packed_size);
 
 	/* Components must be page-aligned. */
 	uint8_t *new_ustart = (uint8_t *) ALIGN_UP((uintptr_t) ustart, PAGE_SIZE);
@@ -115,21 +151,39 @@ static bool extract_component(uint8_t **cstart, uint8_t *cend,
 		task->addr = (void *) actual_ustart;
 		task->size = unpacked_size;
 		str_cpy(task->name, BOOTINFO_TASK_NAME_BUFLEN, name);
-		/* Remove .gz extension */
-		if (gz)
+		/* Remove .gz or .lz4 extension */
+		if (format != cf_none)
 			basename(task->name);
 	}
 
-	if (gz) {
-		int rc = gzip_expand(data, packed_size, ustart, unpacked_size);
-		if (rc != EOK) {
-			printf("\n%s: Inflating error %d\n", name, rc);
-			halt();
-		}
-	} else {
+#ifdef ARCH_TIMER_USEC
+	uint64_t start_usec = ARCH_TIMER_USEC();
+#endif
+
+	int rc;
+	switch (format) {
+	case cf_gzip:
+		rc = gzip_expand(data, packed_size, ustart, unpacked_size);
+		break;
+	case cf_lz4:
+		rc = lz4_expand(data, packed_size, ustart, unpacked_size);
+		break;
+	default:
 		memcpy(ustart, data, unpacked_size);
+		rc = EOK;
+		break;
+	}
+
+	if (rc != EOK) {
+		printf("\n%s: Inflating error %d\n", name, rc);
+		halt();
 	}
 
+#ifdef ARCH_TIMER_USEC
+	printf("  extracted in %llu us\n",
+	    (unsigned long long) (ARCH_TIMER_USEC() - start_usec));
+#endif
+
 	if (clear_cache)
 		clear_cache(ustart, unpacked_size);
 
@@ -145,11 +199,11 @@ size_t payload_unpacked_size(void)
 	size_t packed_size;
 
 	while (tar_info(start, payload_end, &name, &packed_size)) {
+		const uint8_t *data = start + TAR_BLOCK_SIZE;
+
 		sz = ALIGN_UP(sz, PAGE_SIZE);
-		if (gzip_check(start + TAR_BLOCK_SIZE, packed_size))
-			sz += gzip_size(start + TAR_BLOCK_SIZE, packed_size);
-		else
-			sz += packed_size;
+		sz += comp_size(comp_format(data, packed_size), data,
+		    packed_size);
 
 		start += TAR_BLOCK_SIZE + ALIGN_UP(packed_size, TAR_BLOCK_SIZE);
 	}
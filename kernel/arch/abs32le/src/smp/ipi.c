@@ -35,11 +35,16 @@
 #ifdef CONFIG_SMP
 
 #include <smp/ipi.h>
+#include <cpu.h>
 
 void ipi_broadcast_arch(int ipi)
 {
 }
 
+void ipi_send_arch(cpu_t *cpu, int ipi)
+{
+}
+
 #endif /* CONFIG_SMP */
 
 /** @}
@@ -90,6 +90,7 @@ typedef struct {
 	tss_t *tss;
 
 	unsigned int id; /** CPU's local, ie physical, APIC ID. */
+	uint32_t timer_period; /** Local APIC timer count per clock tick. */
 
 	size_t iomapver_copy;  /** Copy of TASK's I/O Permission bitmap generation count. */
 } cpu_arch_t;
@@ -36,14 +36,20 @@
 #define KERN_amd64_CPUID_H_
 
 #define AMD_CPUID_EXTENDED  0x80000001
+#define AMD_CPUID_SIZES     0x80000008
+#define AMD_CPUID_TOPOLOGY  0x8000001e
 #define AMD_EXT_NOEXECUTE   20
 #define AMD_EXT_LONG_MODE   29
+#define AMD_EXT_TOPOEXT     22
 
 #define INTEL_CPUID_LEVEL     0x00000000
 #define INTEL_CPUID_STANDARD  0x00000001
+#define INTEL_CPUID_CACHE     0x00000004
 #define INTEL_CPUID_EXTENDED  0x80000000
 #define INTEL_SSE2            26
 #define INTEL_FXSAVE          24
+#define INTEL_HTT             28
+#define INTEL_RDRAND          30
 
 #ifndef __ASSEMBLER__
 
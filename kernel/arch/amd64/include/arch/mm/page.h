@@ -154,6 +154,18 @@
 #define PTE_EXECUTABLE_ARCH(p) \
 	((p)->no_execute == 0)
 
+/* Large (2 MiB) pages mapped directly by PTL2 entries. */
+#define LARGE_PAGE_WIDTH_ARCH  21
+
+#define IS_LARGE_PAGE_ARCH(ptl2, i) \
+	(((pte_t *) (ptl2))[(i)].size != 0)
+#define GET_LARGE_PAGE_FLAGS_ARCH(ptl2, i) \
+	get_pt_flags((pte_t *) (ptl2), (size_t) (i))
+#define SET_LARGE_PAGE_FLAGS_ARCH(ptl2, i, x) \
+	set_pt_large_flags((pte_t *) (ptl2), (size_t) (i), (x))
+#define LARGE_PAGE_TO_PTE_ARCH(p) \
+	((p)->size = 0)
+
 #ifndef __ASSEMBLER__
 
 #include <arch/interrupt.h>
@@ -191,7 +203,7 @@ typedef struct {
 	unsigned int page_cache_disable : 1;
 	unsigned int accessed : 1;
 	unsigned int dirty : 1;
-	unsigned int unused : 1;
+	unsigned int size : 1;  /**< Large page (in PTL2 entries only). */
 	unsigned int global : 1;
 	unsigned int soft_valid : 1;  /**< Valid content even if present bit is cleared. */
 	unsigned int avl : 2;
@@ -237,6 +249,12 @@ _NO_TRACE static inline void set_pt_flags(pte_t *pt, size_t i, int flags)
 	p->soft_valid = 1;
 }
 
+_NO_TRACE static inline void set_pt_large_flags(pte_t *pt, size_t i, int flags)
+{
+	set_pt_flags(pt, i, flags);
+	pt[i].size = 1;
+}
+
 _NO_TRACE static inline void set_pt_present(pte_t *pt, size_t i)
 {
 	pte_t *p = &pt[i];
@@ -46,6 +46,7 @@
 #include <arch/drivers/i8254.h>
 #include <arch/syscall.h>
 #include <genarch/acpi/acpi.h>
+#include <genarch/acpi/srat.h>
 #include <genarch/drivers/ega/ega.h>
 #include <genarch/drivers/i8042/i8042.h>
 #include <genarch/drivers/i8259/i8259.h>
@@ -57,6 +58,7 @@
 #include <genarch/multiboot/multiboot.h>
 #include <genarch/multiboot/multiboot2.h>
 #include <arch/pm.h>
+#include <arch/cpuid.h>
 #include <arch/vreg.h>
 #include <arch/kseg.h>
 #include <genarch/pic/pic_ops.h>
@@ -70,17 +72,22 @@ static void amd64_post_mm_init(void);
 static void amd64_post_cpu_init(void);
 static void amd64_pre_smp_init(void);
 static void amd64_post_smp_init(void);
+static bool amd64_hw_random(uint64_t *);
 
 arch_ops_t amd64_ops = {
 	.pre_mm_init = amd64_pre_mm_init,
 	.post_mm_init = amd64_post_mm_init,
 	.post_cpu_init = amd64_post_cpu_init,
 	.pre_smp_init = amd64_pre_smp_init,
-	.post_smp_init = amd64_post_smp_init
+	.post_smp_init = amd64_post_smp_init,
+	.hw_random = amd64_hw_random
 };
 
 arch_ops_t *arch_ops = &amd64_ops;
 
+/** Whether the processor implements the RDRAND instruction */
+static bool rdrand_present = false;
+
 /** Perform amd64-specific initialization before main_bsp() is called.
  *
  * @param signature Multiboot signature.
@@ -135,11 +142,15 @@ void amd64_post_mm_init(void)
 
 	if (config.cpu_active == 1) {
 		/* Initialize IRQ routing */
-		irq_init(IRQ_COUNT, IRQ_COUNT);
+		irq_init(IRQ_COUNT + MSI_COUNT, IRQ_COUNT + MSI_COUNT);
 
 		/* hard clock */
 		i8254_init();
 
+		cpu_info_t info;
+		cpuid(INTEL_CPUID_STANDARD, &info);
+		rdrand_present = (info.cpuid_ecx & (1 << INTEL_RDRAND)) != 0;
+
 #if (defined(CONFIG_FB) || defined(CONFIG_EGA))
 		bool bfb = false;
 #endif
@@ -156,7 +167,16 @@ void amd64_post_mm_init(void)
 		}
 #endif
 
-		/* Merge all memory zones to 1 big zone */
+#ifdef CONFIG_SMP
+		/*
+		 * Find the ACPI tables before merging the memory zones so
+		 * that the zones can be assigned to NUMA nodes first.
+		 */
+		acpi_init();
+		acpi_srat_parse();
+#endif /* CONFIG_SMP */
+
+		/* Merge memory zones within each NUMA node */
 		zone_merge_all();
 	}
 
@@ -164,6 +184,39 @@ void amd64_post_mm_init(void)
 	syscall_setup_cpu();
 }
 
+/** Read a random number using the RDRAND instruction.
+ *
+ * @param val Place to store the random number.
+ *
+ * @return True on success, false if RDRAND is not available or kept
+ *         failing.
+ *
+ */
+bool amd64_hw_random(uint64_t *val)
+{
+	if (!rdrand_present)
+		return false;
+
+	for (unsigned int retry = 0; retry < 10; retry++) {
+		uint64_t v;
+		uint8_t ok;
+
+		asm volatile (
+		    "rdrand %[v]\n"
+		    "setc %[ok]\n"
+		    : [v] "=r" (v), [ok] "=qm" (ok)
+		    :: "cc"
+		);
+
+		if (ok) {
+			*val = v;
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void amd64_post_cpu_init(void)
 {
 #ifdef CONFIG_SMP
@@ -176,11 +229,7 @@ void amd64_post_cpu_init(void)
 
 void amd64_pre_smp_init(void)
 {
-	if (config.cpu_active == 1) {
-#ifdef CONFIG_SMP
-		acpi_init();
-#endif /* CONFIG_SMP */
-	}
+	/* ACPI tables have already been found in amd64_post_mm_init(). */
 }
 
 void amd64_post_smp_init(void)
@@ -38,9 +38,14 @@
 #include <arch/pm.h>
 
 #include <arch.h>
+#include <bitops.h>
 #include <stdio.h>
 #include <fpu_context.h>
 
+#ifdef CONFIG_ACPI
+#include <genarch/acpi/srat.h>
+#endif
+
 /*
  * Identification of CPUs.
  * Contains only non-MP-Specification specific SMP code.
@@ -101,6 +106,70 @@ void cpu_arch_init(void)
 	CPU->fpu_owner = NULL;
 }
 
+/** Number of bits needed to represent @a count distinct IDs. */
+static unsigned int id_bits(unsigned int count)
+{
+	return (count <= 1) ? 0 : fnzb32(count - 1) + 1;
+}
+
+/** Identify processor topology
+ *
+ * Split the initial APIC ID of the processor into the SMT, core and
+ * package fields and look up the NUMA node in the ACPI SRAT.
+ *
+ * @param max_std Highest supported standard CPUID leaf.
+ * @param max_ext Highest supported extended CPUID leaf.
+ *
+ */
+static void cpu_identify_topology(uint32_t max_std, uint32_t max_ext)
+{
+	cpu_info_t info;
+
+	cpuid(INTEL_CPUID_STANDARD, &info);
+	unsigned int apic_id = info.cpuid_ebx >> 24;
+	unsigned int threads = 1;
+	if (info.cpuid_edx & (1 << INTEL_HTT))
+		threads = (info.cpuid_ebx >> 16) & 0xff;
+
+	unsigned int cores = 1;
+	if ((CPU->arch.vendor == VendorIntel) &&
+	    (max_std >= INTEL_CPUID_CACHE)) {
+		cpuid(INTEL_CPUID_CACHE, &info);
+		cores = (info.cpuid_eax >> 26) + 1;
+	} else if ((CPU->arch.vendor == VendorAMD) &&
+	    (max_ext >= AMD_CPUID_SIZES)) {
+		cpuid(AMD_CPUID_SIZES, &info);
+		cores = (info.cpuid_ecx & 0xff) + 1;
+
+		/*
+		 * With topology extensions, the number above counts
+		 * threads rather than cores.
+		 */
+		cpuid(AMD_CPUID_EXTENDED, &info);
+		if ((info.cpuid_ecx & (1 << AMD_EXT_TOPOEXT)) &&
+		    (max_ext >= AMD_CPUID_TOPOLOGY)) {
+			cpuid(AMD_CPUID_TOPOLOGY, &info);
+			cores /= ((info.cpuid_ebx >> 8) & 0xff) + 1;
+		}
+	}
+
+	if (cores == 0)
+		cores = 1;
+
+	if (threads < cores)
+		threads = cores;
+
+	unsigned int smt_bits = id_bits(threads / cores);
+	unsigned int core_bits = id_bits(cores);
+
+	CPU->core_id = (apic_id >> smt_bits) & ((1 << core_bits) - 1);
+	CPU->package_id = apic_id >> (smt_bits + core_bits);
+
+#ifdef CONFIG_ACPI
+	CPU->numa_node = acpi_srat_cpu_node(apic_id);
+#endif
+}
+
 void cpu_identify(void)
 {
 	cpu_info_t info;
@@ -108,6 +177,7 @@ void cpu_identify(void)
 	CPU->arch.vendor = VendorUnknown;
 	if (has_cpuid()) {
 		cpuid(INTEL_CPUID_LEVEL, &info);
+		uint32_t max_std = info.cpuid_eax;
 
 		/*
 		 * Check for AMD processor.
@@ -131,6 +201,11 @@ void cpu_identify(void)
 		CPU->arch.family = (info.cpuid_eax >> 8) & 0xf;
 		CPU->arch.model = (info.cpuid_eax >> 4) & 0xf;
 		CPU->arch.stepping = (info.cpuid_eax >> 0) & 0xf;
+
+		cpuid(INTEL_CPUID_EXTENDED, &info);
+		uint32_t max_ext = info.cpuid_eax;
+
+		cpu_identify_topology(max_std, max_ext);
 	}
 }
 
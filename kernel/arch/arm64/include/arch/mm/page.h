@@ -158,6 +158,18 @@ extern uintptr_t physmem_base;
 #define PTE_EXECUTABLE_ARCH(pte) \
 	get_pt_executable((pte_t *) (pte))
 
+/* Large (2 MiB) pages mapped by level 2 block descriptors. */
+#define LARGE_PAGE_WIDTH_ARCH  PTL2_VA_SHIFT
+
+#define IS_LARGE_PAGE_ARCH(ptl2, i) \
+	(((pte_t *) (ptl2))[(i)].type == PTE_L012_TYPE_BLOCK)
+#define GET_LARGE_PAGE_FLAGS_ARCH(ptl2, i) \
+	get_pt_level3_flags((pte_t *) (ptl2), (size_t) (i))
+#define SET_LARGE_PAGE_FLAGS_ARCH(ptl2, i, x) \
+	set_pt_block_flags((pte_t *) (ptl2), (size_t) (i), (x))
+#define LARGE_PAGE_TO_PTE_ARCH(pte) \
+	(((pte_t *) (pte))->type = PTE_L3_TYPE_PAGE)
+
 /* Level 3 access permissions. */
 
 /** Data access permission. User mode: no access, privileged mode: read/write.
@@ -209,8 +221,8 @@ extern uintptr_t physmem_base;
 #define PTE_L3_TYPE_PAGE  1
 
 /** HelenOS descriptor type. Table for level 0, 1, 2 page translation tables,
- * page for level 3 tables. Block descriptors are not used by HelenOS during
- * normal processing.
+ * page for level 3 tables. Block descriptors are used only by level 2 tables
+ * for large pages.
  */
 #define PTE_L0123_TYPE_HELENOS  1
 
@@ -244,8 +256,8 @@ extern uintptr_t physmem_base;
 /** Page Table Entry.
  *
  * HelenOS model:
- * * Level 0, 1, 2 translation tables hold next-level table descriptors. Block
- *   descriptors are not used during normal processing.
+ * * Level 0, 1, 2 translation tables hold next-level table descriptors. Level
+ *   2 tables can also hold 2MB block descriptors for large pages.
  * * Level 3 tables store 4kB page descriptors.
  */
 typedef struct {
@@ -377,6 +389,19 @@ _NO_TRACE static inline void set_pt_level3_flags(pte_t *pt, size_t i,
 	p->not_global = (flags & PAGE_GLOBAL) == 0;
 }
 
+/** Sets flags of level 2 block descriptor.
+ *
+ * @param pt    Level 2 page table.
+ * @param i     Index of the entry to be changed.
+ * @param flags New flags.
+ */
+_NO_TRACE static inline void set_pt_block_flags(pte_t *pt, size_t i,
+    int flags)
+{
+	set_pt_level3_flags(pt, i, flags);
+	pt[i].type = PTE_L012_TYPE_BLOCK;
+}
+
 /** Sets the present flag of page table entry.
  *
  * @param pt Level 0, 1, 2, 3 page table.
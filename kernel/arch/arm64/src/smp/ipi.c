@@ -35,6 +35,7 @@
 #ifdef CONFIG_SMP
 
 #include <smp/ipi.h>
+#include <cpu.h>
 #include <panic.h>
 
 /** Deliver IPI to all processors except the current one.
@@ -46,6 +47,16 @@ void ipi_broadcast_arch(int ipi)
 	panic("broadcast IPI not implemented.");
 }
 
+/** Deliver IPI to a single processor.
+ *
+ * @param cpu Target processor.
+ * @param ipi IPI number.
+ */
+void ipi_send_arch(cpu_t *cpu, int ipi)
+{
+	panic("unicast IPI not implemented.");
+}
+
 #endif /* CONFIG_SMP */
 
 /** @}
@@ -77,6 +77,7 @@ typedef struct {
 	cpuid_feature_info_t fi;
 
 	unsigned int id; /** CPU's local, ie physical, APIC ID. */
+	uint32_t timer_period; /** Local APIC timer count per clock tick. */
 
 	tss_t *tss;
 
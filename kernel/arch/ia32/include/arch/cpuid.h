@@ -39,6 +39,7 @@
 #define INTEL_CPUID_STANDARD  0x00000001
 #define INTEL_PSE             3
 #define INTEL_SEP             11
+#define INTEL_RDRAND          30
 
 #ifndef __ASSEMBLER__
 
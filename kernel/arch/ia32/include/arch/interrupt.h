@@ -44,10 +44,18 @@
 
 #define EXC_COUNT  32
 #define IRQ_COUNT  16
+#define MSI_COUNT  11
 
 #define IVT_EXCBASE   0
 #define IVT_IRQBASE   (IVT_EXCBASE + EXC_COUNT)
 #define IVT_FREEBASE  (IVT_IRQBASE + IRQ_COUNT)
+#define IVT_MSIBASE   (IVT_FREEBASE + 4)
+
+/*
+ * Message signalled interrupts are numbered after the legacy IRQs, the MSI
+ * vector window starts right after the syscall and IPI vectors.
+ */
+#define IRQ_MSIBASE  IRQ_COUNT
 
 #define EXC_DE 0
 #define EXC_DB 1
@@ -73,6 +81,10 @@
 #error Wrong definition of VECTOR_APIC_SPUR
 #endif
 
+#if (IVT_MSIBASE + MSI_COUNT > VECTOR_APIC_SPUR)
+#error Wrong definition of the MSI vector window
+#endif
+
 #define VECTOR_DE                 (IVT_EXCBASE + EXC_DE)
 #define VECTOR_DB                 (IVT_EXCBASE + EXC_DB)
 #define VECTOR_NM                 (IVT_EXCBASE + EXC_NM)
@@ -86,6 +98,7 @@
 #define VECTOR_SYSCALL            IVT_FREEBASE
 #define VECTOR_TLB_SHOOTDOWN_IPI  (IVT_FREEBASE + 1)
 #define VECTOR_DEBUG_IPI          (IVT_FREEBASE + 2)
+#define VECTOR_WAKEUP_IPI         (IVT_FREEBASE + 3)
 
 extern void interrupt_init(void);
 
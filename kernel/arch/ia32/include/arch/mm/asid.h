@@ -51,6 +51,12 @@ typedef int32_t asid_t;
 #define asid_get()  (ASID_START + 1)
 #define asid_put(asid)
 
+/*
+ * Loading a new page table flushes all non-global TLB entries, so a processor
+ * keeps no translations of the address space it has switched away from.
+ */
+#define ASID_FLUSH_ON_SWITCH
+
 #endif
 
 /** @}
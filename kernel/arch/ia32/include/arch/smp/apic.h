@@ -38,6 +38,11 @@
 #define L_APIC_BASE	0xfee00000
 #define IO_APIC_BASE	0xfec00000
 
+/** Physical address targeted by message signalled interrupts */
+#define MSI_ADDRESS		0xfee00000
+/** Shift of the destination APIC ID within the MSI address */
+#define MSI_ADDRESS_DEST_SHIFT	12
+
 #ifndef __ASSEMBLER__
 
 #include <cpu.h>
@@ -50,6 +50,7 @@
 #include <arch/cpuid.h>
 #include <arch.h>
 #include <ddi/irq.h>
+#include <synch/spinlock.h>
 
 #define CLK_PORT1  ((ioport8_t *) 0x40U)
 #define CLK_PORT4  ((ioport8_t *) 0x43U)
@@ -62,6 +63,10 @@
 
 static irq_t i8254_irq;
 
+/** Serializes delay loop calibration of CPUs booting in parallel */
+IRQ_SPINLOCK_STATIC_INITIALIZE_NAME(i8254_calibration_lock,
+    "i8254_calibration_lock");
+
 static irq_ownership_t i8254_claim(irq_t *irq)
 {
 	return IRQ_ACCEPT;
@@ -107,6 +112,8 @@ void i8254_calibrate_delay_loop(void)
 	 * One-shot timer. Count-down from 0xffff at 1193180Hz
 	 * MAGIC_NUMBER is the magic value for 1ms.
 	 */
+	irq_spinlock_lock(&i8254_calibration_lock, true);
+
 	pio_write_8(CLK_PORT4, 0x30);
 	pio_write_8(CLK_PORT1, 0xff);
 	pio_write_8(CLK_PORT1, 0xff);
@@ -142,6 +149,8 @@ void i8254_calibrate_delay_loop(void)
 	uint32_t o2 = pio_read_8(CLK_PORT1);
 	o2 |= pio_read_8(CLK_PORT1) << 8;
 
+	irq_spinlock_unlock(&i8254_calibration_lock, true);
+
 	uint32_t delta = (t1 - t2) - (o1 - o2);
 	if (!delta)
 		delta = 1;
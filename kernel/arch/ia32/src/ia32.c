@@ -59,6 +59,7 @@
 #include <genarch/multiboot/multiboot2.h>
 #include <genarch/pic/pic_ops.h>
 #include <arch/pm.h>
+#include <arch/cpuid.h>
 #include <arch/vreg.h>
 
 #ifdef CONFIG_SMP
@@ -70,6 +71,7 @@ static void ia32_post_mm_init(void);
 static void ia32_post_cpu_init(void);
 static void ia32_pre_smp_init(void);
 static void ia32_post_smp_init(void);
+static bool ia32_hw_random(uint64_t *);
 
 arch_ops_t ia32_ops = {
 	.pre_mm_init = ia32_pre_mm_init,
@@ -77,10 +79,14 @@ arch_ops_t ia32_ops = {
 	.post_cpu_init = ia32_post_cpu_init,
 	.pre_smp_init = ia32_pre_smp_init,
 	.post_smp_init = ia32_post_smp_init,
+	.hw_random = ia32_hw_random
 };
 
 arch_ops_t *arch_ops = &ia32_ops;
 
+/** Whether the processor implements the RDRAND instruction */
+static bool rdrand_present = false;
+
 /** Perform ia32-specific initialization before main_bsp() is called.
  *
  * @param signature Multiboot signature.
@@ -123,11 +129,18 @@ void ia32_post_mm_init(void)
 
 	if (config.cpu_active == 1) {
 		/* Initialize IRQ routing */
-		irq_init(IRQ_COUNT, IRQ_COUNT);
+		irq_init(IRQ_COUNT + MSI_COUNT, IRQ_COUNT + MSI_COUNT);
 
 		/* hard clock */
 		i8254_init();
 
+		if (has_cpuid()) {
+			cpu_info_t info;
+			cpuid(INTEL_CPUID_STANDARD, &info);
+			rdrand_present =
+			    (info.cpuid_ecx & (1 << INTEL_RDRAND)) != 0;
+		}
+
 #if (defined(CONFIG_FB) || defined(CONFIG_EGA))
 		bool bfb = false;
 #endif
@@ -149,6 +162,44 @@ void ia32_post_mm_init(void)
 	}
 }
 
+/** Read a random number using the RDRAND instruction.
+ *
+ * @param val Place to store the random number.
+ *
+ * @return True on success, false if RDRAND is not available or kept
+ *         failing.
+ *
+ */
+bool ia32_hw_random(uint64_t *val)
+{
+	if (!rdrand_present)
+		return false;
+
+	uint32_t half[2];
+	unsigned int got = 0;
+
+	for (unsigned int retry = 0; (retry < 10) && (got < 2); retry++) {
+		uint32_t v;
+		uint8_t ok;
+
+		asm volatile (
+		    "rdrand %[v]\n"
+		    "setc %[ok]\n"
+		    : [v] "=r" (v), [ok] "=qm" (ok)
+		    :: "cc"
+		);
+
+		if (ok)
+			half[got++] = v;
+	}
+
+	if (got < 2)
+		return false;
+
+	*val = ((uint64_t) half[1] << 32) | half[0];
+	return true;
+}
+
 void ia32_post_cpu_init(void)
 {
 #ifdef CONFIG_SMP
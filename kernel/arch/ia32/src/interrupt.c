@@ -172,6 +172,15 @@ static void tlb_shootdown_ipi(unsigned int n __attribute__((unused)),
 }
 #endif
 
+#ifdef CONFIG_TICKLESS
+static void wakeup_ipi(unsigned int n __attribute__((unused)),
+    istate_t *istate __attribute__((unused)))
+{
+	/* The tick is restarted by exc_dispatch(), nothing else to do. */
+	pic_ops->eoi(0);
+}
+#endif
+
 /** Handler of IRQ exceptions */
 static void irq_interrupt(unsigned int n, istate_t *istate __attribute__((unused)))
 {
@@ -221,6 +230,35 @@ static void pic_spurious(unsigned int n, istate_t *istate)
 #endif
 }
 
+#ifdef CONFIG_SMP
+/** Handler of message signalled interrupts.
+ *
+ * MSI vectors are delivered by the local APIC directly, there is no IO APIC
+ * pin to acknowledge and the interrupt is always edge triggered.
+ *
+ */
+static void msi_interrupt(unsigned int n, istate_t *istate)
+{
+	assert(n >= IVT_MSIBASE);
+
+	unsigned int inum = IRQ_MSIBASE + (n - IVT_MSIBASE);
+	assert(inum < IRQ_MSIBASE + MSI_COUNT);
+
+	irq_t *irq = irq_dispatch_and_lock(inum);
+	if (irq) {
+		irq->handler(irq);
+		irq_spinlock_unlock(&irq->lock, false);
+	} else {
+#ifdef CONFIG_DEBUG
+		log(LF_ARCH, LVL_DEBUG, "cpu%u: unhandled MSI %u", CPU->id,
+		    inum);
+#endif
+	}
+
+	pic_ops->eoi(0);
+}
+#endif
+
 void interrupt_init(void)
 {
 	unsigned int i;
@@ -249,6 +287,16 @@ void interrupt_init(void)
 #ifdef CONFIG_SMP
 	exc_register(VECTOR_TLB_SHOOTDOWN_IPI, "tlb_shootdown", true,
 	    (iroutine_t) tlb_shootdown_ipi);
+
+	for (i = 0; i < MSI_COUNT; i++) {
+		exc_register(IVT_MSIBASE + i, "msi", true,
+		    (iroutine_t) msi_interrupt);
+	}
+#endif
+
+#ifdef CONFIG_TICKLESS
+	exc_register(VECTOR_WAKEUP_IPI, "wakeup", true,
+	    (iroutine_t) wakeup_ipi);
 #endif
 }
 
@@ -47,6 +47,11 @@
 #include <arch.h>
 #include <ddi/irq.h>
 #include <genarch/pic/pic_ops.h>
+#include <time/clock.h>
+#include <cpu.h>
+#include <errno.h>
+#include <synch/spinlock.h>
+#include <sysinfo/sysinfo.h>
 
 #ifdef CONFIG_SMP
 
@@ -93,6 +98,15 @@ uint8_t bsp_l_apic = 0;
 
 static irq_t l_apic_timer_irq;
 
+/** Serializes accesses to the IO APIC register window. */
+IRQ_SPINLOCK_STATIC_INITIALIZE_NAME(io_apic_lock, "io_apic_lock");
+
+static errno_t io_apic_set_affinity(inr_t, unsigned int);
+
+static irq_route_ops_t io_apic_route_ops = {
+	.set_affinity = io_apic_set_affinity
+};
+
 static int apic_poll_errors(void);
 
 #ifdef LAPIC_VERBOSE
@@ -168,8 +182,83 @@ static irq_ownership_t l_apic_timer_claim(irq_t *irq)
 	return IRQ_ACCEPT;
 }
 
+#ifdef CONFIG_TICKLESS
+static void l_apic_timer_program(unsigned int mode, uint32_t count)
+{
+	lvt_tm_t tm;
+
+	tm.value = l_apic[LVT_Tm];
+	tm.mode = mode;
+	l_apic[LVT_Tm] = tm.value;
+	l_apic[ICRT] = count;
+}
+
+/** Replace the periodic tick by a one-shot interrupt.
+ *
+ * The one-shot interrupt is aligned to the tick boundary at which
+ * the ticks-th periodic interrupt would have arrived.
+ *
+ */
+static void l_apic_tick_stop(uint64_t ticks)
+{
+	uint32_t period = CPU->arch.timer_period;
+	uint32_t remaining = l_apic[CCRT];
+
+	l_apic_timer_program(TIMER_ONESHOT, (ticks - 1) * period + remaining);
+}
+
+static uint64_t l_apic_tick_restart(uint64_t ticks)
+{
+	uint32_t period = CPU->arch.timer_period;
+	uint32_t remaining = l_apic[CCRT];
+
+	if (remaining == 0) {
+		/*
+		 * The one-shot interrupt has arrived (or is pending) and the
+		 * subsequent clock() accounts for the last tick.
+		 */
+		l_apic_timer_program(TIMER_PERIODIC, period);
+		return ticks - 1;
+	}
+
+	/*
+	 * Woken up by another interrupt. Arrange for the next interrupt
+	 * to arrive at the next tick boundary. The timer handler switches
+	 * back to the periodic mode from there.
+	 */
+	uint64_t pending = (remaining + period - 1) / period;
+	l_apic_timer_program(TIMER_ONESHOT, ((remaining - 1) % period) + 1);
+
+	return ticks - pending;
+}
+
+static void l_apic_tick_wakeup(cpu_t *cpu)
+{
+	(void) l_apic_send_custom_ipi((uint8_t) cpu->arch.id,
+	    VECTOR_WAKEUP_IPI);
+}
+
+static clock_tick_ops_t l_apic_tick_ops = {
+	.max_ticks = HZ,
+	.stop = l_apic_tick_stop,
+	.restart = l_apic_tick_restart,
+	.wakeup = l_apic_tick_wakeup
+};
+#endif /* CONFIG_TICKLESS */
+
 static void l_apic_timer_irq_handler(irq_t *irq)
 {
+#ifdef CONFIG_TICKLESS
+	/*
+	 * This is the interrupt which realigned the clock after an idle
+	 * period. Continue with the periodic tick.
+	 */
+	lvt_tm_t tm;
+	tm.value = l_apic[LVT_Tm];
+	if ((tm.mode == TIMER_ONESHOT) && (CPU->tick_stopped == 0))
+		l_apic_timer_program(TIMER_PERIODIC, CPU->arch.timer_period);
+#endif
+
 	/*
 	 * Holding a spinlock could prevent clock() from preempting
 	 * the current thread. In this case, we don't need to hold the
@@ -200,6 +289,7 @@ void apic_init(void)
 	    (iroutine_t) apic_spurious);
 
 	pic_ops = &apic_pic_ops;
+	irq_route_ops = &io_apic_route_ops;
 
 	/*
 	 * Configure interrupt routing.
@@ -215,6 +305,10 @@ void apic_init(void)
 	l_apic_timer_irq.handler = l_apic_timer_irq_handler;
 	irq_register(&l_apic_timer_irq);
 
+#ifdef CONFIG_TICKLESS
+	clock_tick_ops = &l_apic_tick_ops;
+#endif
+
 	uint8_t i;
 	for (i = 0; i < IRQ_COUNT; i++) {
 		int pin;
@@ -246,6 +340,17 @@ void apic_init(void)
 	l_apic_debug();
 
 	bsp_l_apic = l_apic_id();
+
+	/*
+	 * Advertise the MSI vector window. Messages are delivered to the BSP
+	 * in fixed mode, the data of the n-th vector is the base data plus n.
+	 */
+	sysinfo_set_item_val("msi", NULL, true);
+	sysinfo_set_item_val("msi.inr", NULL, IRQ_MSIBASE);
+	sysinfo_set_item_val("msi.count", NULL, MSI_COUNT);
+	sysinfo_set_item_val("msi.address", NULL, MSI_ADDRESS |
+	    ((uint32_t) bsp_l_apic << MSI_ADDRESS_DEST_SHIFT));
+	sysinfo_set_item_val("msi.data", NULL, IVT_MSIBASE);
 }
 
 /** Poll for APIC errors.
@@ -511,6 +616,14 @@ void l_apic_init(void)
 	uint32_t t2 = l_apic[CCRT];
 
 	l_apic[ICRT] = t1 - t2;
+	CPU->arch.timer_period = t1 - t2;
+
+#ifdef CONFIG_TICKLESS
+	/* The one-shot count must fit into the initial count register. */
+	uint64_t max_ticks = UINT32_MAX / CPU->arch.timer_period - 1;
+	if (max_ticks < l_apic_tick_ops.max_ticks)
+		l_apic_tick_ops.max_ticks = max_ticks;
+#endif
 
 	/* Program Logical Destination Register. */
 	assert(CPU->id < 8);
@@ -620,6 +733,8 @@ void io_apic_change_ioredtbl(uint8_t pin, uint8_t dest, uint8_t vec,
 	else
 		dlvr = DELMOD_FIXED;
 
+	irq_spinlock_lock(&io_apic_lock, true);
+
 	io_redirection_reg_t reg;
 	reg.lo = io_apic_read((uint8_t) (IOREDTBL + pin * 2));
 	reg.hi = io_apic_read((uint8_t) (IOREDTBL + pin * 2 + 1));
@@ -633,6 +748,41 @@ void io_apic_change_ioredtbl(uint8_t pin, uint8_t dest, uint8_t vec,
 
 	io_apic_write((uint8_t) (IOREDTBL + pin * 2), reg.lo);
 	io_apic_write((uint8_t) (IOREDTBL + pin * 2 + 1), reg.hi);
+
+	irq_spinlock_unlock(&io_apic_lock, true);
+}
+
+/** Route an IRQ to a CPU.
+ *
+ * @param inr IRQ number.
+ * @param cpu CPU ID or IRQ_CPU_ANY for the lowest priority CPU.
+ *
+ * @return EOK on success, ENOENT if the IRQ is not wired to the IO APIC,
+ *         ENOTSUP if the CPU cannot be addressed.
+ *
+ */
+static errno_t io_apic_set_affinity(inr_t inr, unsigned int cpu)
+{
+	if ((inr < 0) || (inr >= IRQ_COUNT))
+		return ENOENT;
+
+	int pin = smp_irq_to_pin((unsigned int) inr);
+	if (pin == -1)
+		return ENOENT;
+
+	if (cpu == IRQ_CPU_ANY) {
+		io_apic_change_ioredtbl((uint8_t) pin, DEST_ALL,
+		    (uint8_t) (IVT_IRQBASE + inr), LOPRI);
+		return EOK;
+	}
+
+	/* The flat logical destination model addresses only eight CPUs. */
+	if (cpu >= 8)
+		return ENOTSUP;
+
+	io_apic_change_ioredtbl((uint8_t) pin, (uint8_t) (1 << cpu),
+	    (uint8_t) (IVT_IRQBASE + inr), 0);
+	return EOK;
 }
 
 /** Mask IRQs in IO APIC.
@@ -653,9 +803,11 @@ void io_apic_disable_irqs(uint16_t irqmask)
 			if (pin != -1) {
 				io_redirection_reg_t reg;
 
+				irq_spinlock_lock(&io_apic_lock, true);
 				reg.lo = io_apic_read((uint8_t) (IOREDTBL + pin * 2));
 				reg.masked = true;
 				io_apic_write((uint8_t) (IOREDTBL + pin * 2), reg.lo);
+				irq_spinlock_unlock(&io_apic_lock, true);
 			}
 
 		}
@@ -680,9 +832,11 @@ void io_apic_enable_irqs(uint16_t irqmask)
 			if (pin != -1) {
 				io_redirection_reg_t reg;
 
+				irq_spinlock_lock(&io_apic_lock, true);
 				reg.lo = io_apic_read((uint8_t) (IOREDTBL + pin * 2));
 				reg.masked = false;
 				io_apic_write((uint8_t) (IOREDTBL + pin * 2), reg.lo);
+				irq_spinlock_unlock(&io_apic_lock, true);
 			}
 
 		}
@@ -36,12 +36,18 @@
 
 #include <smp/ipi.h>
 #include <arch/smp/apic.h>
+#include <cpu.h>
 
 void ipi_broadcast_arch(int ipi)
 {
 	(void) l_apic_broadcast_custom_ipi((uint8_t) ipi);
 }
 
+void ipi_send_arch(cpu_t *cpu, int ipi)
+{
+	(void) l_apic_send_custom_ipi((uint8_t) cpu->arch.id, (uint8_t) ipi);
+}
+
 #endif /* CONFIG_SMP */
 
 /** @}
@@ -173,9 +173,10 @@ void kmp(void *arg __attribute__((unused)))
 
 		if (l_apic_send_init_ipi(ops->cpu_apic_id(i))) {
 			/*
-			 * There may be just one AP being initialized at
-			 * the time. After it comes completely up, it is
-			 * supposed to wake us up.
+			 * There may be just one AP using the boot stack
+			 * and the GDT prepared above at the time. After
+			 * it switches to its own stack, it is supposed to
+			 * wake us up.
 			 */
 			if (semaphore_down_timeout(&ap_completion_semaphore, 1000000) != EOK) {
 				log(LF_ARCH, LVL_NOTE, "%s: waiting for cpu%u "
@@ -39,6 +39,7 @@
 #include <interrupt.h>
 #include <arch/asm.h>
 #include <typedefs.h>
+#include <cpu.h>
 
 static irq_t dorder_irq;
 
@@ -49,6 +50,11 @@ void ipi_broadcast_arch(int ipi)
 	pio_write_32(((ioport32_t *) MSIM_DORDER_ADDRESS), 0x7fffffff);
 }
 
+void ipi_send_arch(cpu_t *cpu, int ipi)
+{
+	pio_write_32(((ioport32_t *) MSIM_DORDER_ADDRESS), 1 << cpu->id);
+}
+
 #endif
 
 static irq_ownership_t dorder_claim(irq_t *irq)
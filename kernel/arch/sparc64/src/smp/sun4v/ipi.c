@@ -121,5 +121,25 @@ void ipi_broadcast_arch(int ipi)
 	ipi_brodcast_to(func, ipi_cpu_list[CPU->arch.id], idx);
 }
 
+/*
+ * Deliver IPI to a single processor other than the current one.
+ *
+ * We assume that interrupts are disabled.
+ *
+ * @param cpu Target processor.
+ * @param ipi IPI number.
+ */
+void ipi_send_arch(cpu_t *cpu, int ipi)
+{
+	switch (ipi) {
+	case IPI_TLB_SHOOTDOWN:
+		ipi_unicast_to(tlb_shootdown_ipi_recv, (uint16_t) cpu->id);
+		break;
+	default:
+		panic("Unknown IPI (%d).\n", ipi);
+		break;
+	}
+}
+
 /** @}
  */
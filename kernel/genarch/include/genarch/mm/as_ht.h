@@ -36,7 +36,7 @@
 #define KERN_AS_HT_H_
 
 #include <mm/mm.h>
-#include <adt/hash_table.h>
+#include <atomic.h>
 #include <typedefs.h>
 
 typedef struct {
@@ -45,7 +45,7 @@ typedef struct {
 struct as;
 
 typedef struct pte {
-	ht_link_t link;		/**< Page hash table link. */
+	_Atomic(struct pte *) next;	/**< Next PTE in the hash chain. */
 	struct as *as;		/**< Address space. */
 	uintptr_t page;		/**< Virtual memory page. */
 	uintptr_t frame;	/**< Physical memory frame. */
@@ -43,10 +43,6 @@
 #include <mm/as.h>
 #include <mm/page.h>
 #include <mm/slab.h>
-#include <adt/hash_table.h>
-
-#define KEY_AS        0
-#define KEY_PAGE      1
 
 /* Macros for querying page hash table PTEs. */
 #define PTE_VALID(pte)       ((void *) (pte) != NULL)
@@ -60,8 +56,8 @@ extern const as_operations_t as_ht_operations;
 extern const page_mapping_operations_t ht_mapping_operations;
 
 extern slab_cache_t *pte_cache;
-extern hash_table_t page_ht;
-extern const hash_table_ops_t ht_ops;
+
+extern void page_ht_init(void);
 
 #endif
 
@@ -139,6 +139,22 @@
 #define PTE_WRITABLE(p)    PTE_WRITABLE_ARCH((p))
 #define PTE_EXECUTABLE(p)  PTE_EXECUTABLE_ARCH((p))
 
+/*
+ * Large pages mapped directly by PTL2 entries (optional).
+ *
+ */
+#ifdef LARGE_PAGE_WIDTH_ARCH
+
+#define LARGE_PAGE_WIDTH  LARGE_PAGE_WIDTH_ARCH
+#define LARGE_PAGE_SIZE   (UINT64_C(1) << LARGE_PAGE_WIDTH)
+
+#define IS_LARGE_PAGE(ptl2, i)            IS_LARGE_PAGE_ARCH(ptl2, i)
+#define GET_LARGE_PAGE_FLAGS(ptl2, i)     GET_LARGE_PAGE_FLAGS_ARCH(ptl2, i)
+#define SET_LARGE_PAGE_FLAGS(ptl2, i, x)  SET_LARGE_PAGE_FLAGS_ARCH(ptl2, i, x)
+#define LARGE_PAGE_TO_PTE(p)              LARGE_PAGE_TO_PTE_ARCH((p))
+
+#endif /* LARGE_PAGE_WIDTH_ARCH */
+
 extern const as_operations_t as_pt_operations;
 extern const page_mapping_operations_t pt_mapping_operations;
 
@@ -37,6 +37,7 @@
 
 #include <genarch/acpi/acpi.h>
 #include <genarch/acpi/madt.h>
+#include <genarch/acpi/srat.h>
 #include <arch/bios/bios.h>
 #include <debug.h>
 #include <mm/page.h>
@@ -62,6 +63,11 @@ struct acpi_signature_map signature_map[] = {
 		(uint8_t *) "APIC",
 		(void *) &acpi_madt,
 		"Multiple APIC Description Table"
+	},
+	{
+		(uint8_t *) "SRAT",
+		(void *) &acpi_srat,
+		"System Resource Affinity Table"
 	}
 };
 
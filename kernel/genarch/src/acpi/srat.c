@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_genarch
+ * @{
+ */
+/**
+ * @file
+ * @brief System Resource Affinity Table (SRAT) parsing.
+ *
+ * The SRAT describes which processors and memory ranges belong to which
+ * proximity domain. Proximity domains are mapped to dense NUMA node
+ * numbers in the order of their discovery.
+ */
+
+#include <genarch/acpi/acpi.h>
+#include <genarch/acpi/srat.h>
+#include <mm/frame.h>
+#include <align.h>
+#include <debug.h>
+#include <log.h>
+
+struct acpi_srat *acpi_srat = NULL;
+
+/** Proximity domains indexed by NUMA node number */
+static uint32_t srat_domains[SRAT_NODES_MAX];
+static unsigned int srat_domain_cnt = 0;
+
+/** NUMA nodes of processors indexed by local APIC ID */
+static uint8_t srat_cpu_nodes[256];
+
+static unsigned int srat_domain_node(uint32_t domain)
+{
+	for (unsigned int i = 0; i < srat_domain_cnt; i++) {
+		if (srat_domains[i] == domain)
+			return i;
+	}
+
+	if (srat_domain_cnt == SRAT_NODES_MAX) {
+		log(LF_ARCH, LVL_WARN, "SRAT: Too many proximity domains, "
+		    "treating domain %" PRIu32 " as node 0", domain);
+		return 0;
+	}
+
+	srat_domains[srat_domain_cnt] = domain;
+	return srat_domain_cnt++;
+}
+
+static void srat_l_apic_affinity_entry(struct srat_l_apic_affinity *la)
+{
+	if (!(la->flags & SRAT_FLAG_ENABLED))
+		return;
+
+	uint32_t domain = la->proximity_domain_lo |
+	    (la->proximity_domain_hi[0] << 8) |
+	    (la->proximity_domain_hi[1] << 16) |
+	    (la->proximity_domain_hi[2] << 24);
+
+	srat_cpu_nodes[la->apic_id] = srat_domain_node(domain);
+}
+
+static void srat_x2apic_affinity_entry(struct srat_x2apic_affinity *xa)
+{
+	if (!(xa->flags & SRAT_FLAG_ENABLED))
+		return;
+
+	/* Only xAPIC IDs are currently supported. */
+	if (xa->x2apic_id >= sizeof(srat_cpu_nodes))
+		return;
+
+	srat_cpu_nodes[xa->x2apic_id] = srat_domain_node(xa->proximity_domain);
+}
+
+static void srat_memory_affinity_entry(struct srat_memory_affinity *ma)
+{
+	if (!(ma->flags & SRAT_FLAG_ENABLED))
+		return;
+
+	uint64_t base = ((uint64_t) ma->base_hi << 32) | ma->base_lo;
+	uint64_t length = ((uint64_t) ma->length_hi << 32) | ma->length_lo;
+
+	unsigned int node = srat_domain_node(ma->proximity_domain);
+
+	LOG("SRAT: %#" PRIx64 " - %#" PRIx64 " in node %u", base,
+	    base + length, node);
+
+	zone_set_node(ADDR2PFN(ALIGN_UP(base, FRAME_SIZE)),
+	    SIZE2FRAMES(length), node);
+}
+
+/** Parse the SRAT
+ *
+ * Record the NUMA nodes of processors and label the existing frame
+ * zones with the NUMA nodes of the memory they contain.
+ *
+ */
+void acpi_srat_parse(void)
+{
+	if (acpi_srat == NULL)
+		return;
+
+	struct srat_header *end = (struct srat_header *)
+	    (((uint8_t *) acpi_srat) + acpi_srat->header.length);
+
+	for (struct srat_header *hdr = acpi_srat->srat_header; hdr < end;
+	    hdr = (struct srat_header *) (((uint8_t *) hdr) + hdr->length)) {
+		if (hdr->length == 0)
+			break;
+
+		switch (hdr->type) {
+		case SRAT_L_APIC_AFFINITY:
+			srat_l_apic_affinity_entry(
+			    (struct srat_l_apic_affinity *) hdr);
+			break;
+		case SRAT_MEMORY_AFFINITY:
+			srat_memory_affinity_entry(
+			    (struct srat_memory_affinity *) hdr);
+			break;
+		case SRAT_X2APIC_AFFINITY:
+			srat_x2apic_affinity_entry(
+			    (struct srat_x2apic_affinity *) hdr);
+			break;
+		default:
+			log(LF_ARCH, LVL_NOTE,
+			    "SRAT: Skipping entry (type=%" PRIu8 ")",
+			    hdr->type);
+			break;
+		}
+	}
+
+	LOG("SRAT: %u NUMA node(s)", srat_domain_cnt);
+}
+
+/** Get the NUMA node of a processor
+ *
+ * @param apic_id Local APIC ID of the processor.
+ *
+ * @return NUMA node of the processor (0 if unknown).
+ *
+ */
+unsigned int acpi_srat_cpu_node(uint32_t apic_id)
+{
+	if (apic_id >= sizeof(srat_cpu_nodes))
+		return 0;
+
+	return srat_cpu_nodes[apic_id];
+}
+
+/** @}
+ */
@@ -42,7 +42,6 @@
 #include <mm/frame.h>
 #include <mm/slab.h>
 #include <typedefs.h>
-#include <adt/hash_table.h>
 #include <synch/mutex.h>
 
 static pte_t *ht_create(unsigned int);
@@ -73,7 +72,7 @@ const as_operations_t as_ht_operations = {
 pte_t *ht_create(unsigned int flags)
 {
 	if (flags & FLAG_AS_KERNEL) {
-		hash_table_create(&page_ht, 0, 0, &ht_ops);
+		page_ht_init();
 		pte_cache = slab_cache_create("pte_t", sizeof(pte_t), 0,
 		    NULL, NULL, SLAB_CACHE_MAGDEFERRED);
 	}
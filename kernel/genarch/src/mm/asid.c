@@ -109,12 +109,6 @@ asid_t asid_get(void)
 		asid = as->asid;
 		assert(asid != ASID_INVALID);
 
-		/*
-		 * Notify the address space from wich the ASID
-		 * was stolen by invalidating its asid member.
-		 */
-		as->asid = ASID_INVALID;
-
 		/*
 		 * If the architecture uses some software cache
 		 * of TLB entries (e.g. TSB on sparc64), the
@@ -123,11 +117,19 @@ asid_t asid_get(void)
 		as_invalidate_translation_cache(as, 0, (size_t) -1);
 
 		/*
-		 * Get the system rid of the stolen ASID.
+		 * Get the system rid of the stolen ASID. Only the
+		 * processors which have run the address space can
+		 * hold its TLB entries.
 		 */
-		ipl_t ipl = tlb_shootdown_start(TLB_INVL_ASID, asid, 0, 0);
+		ipl_t ipl = tlb_shootdown_start_as(as, TLB_INVL_ASID, 0, 0);
 		tlb_invalidate_asid(asid);
 		tlb_shootdown_finalize(ipl);
+
+		/*
+		 * Notify the address space from wich the ASID
+		 * was stolen by invalidating its asid member.
+		 */
+		as->asid = ASID_INVALID;
 	} else {
 
 		/*
@@ -44,18 +44,61 @@
 #include <arch/mm/asid.h>
 #include <typedefs.h>
 #include <arch/asm.h>
-#include <barrier.h>
+#include <atomic.h>
+#include <preemption.h>
 #include <synch/spinlock.h>
 #include <arch.h>
 #include <assert.h>
 #include <adt/hash.h>
-#include <adt/hash_table.h>
 #include <align.h>
-
-static size_t ht_hash(const ht_link_t *);
-static size_t ht_key_hash(const void *);
-static bool ht_key_equal(const void *, const ht_link_t *);
-static void ht_remove_callback(ht_link_t *);
+#include <panic.h>
+#include <stdlib.h>
+
+/** Number of page hash table shards, a power of two. */
+#define PAGE_HT_SHARDS  16
+
+/** Initial number of buckets of each shard, a power of two. */
+#define PAGE_HT_MIN_BUCKETS  64
+
+/** A shard grows when the average load per bucket exceeds this number. */
+#define PAGE_HT_MAX_LOAD  2
+
+/** Number of old buckets moved by one update while a shard grows. */
+#define PAGE_HT_MIGRATE_STEP  8
+
+/** Bucket array of a page hash table shard. */
+typedef struct page_ht_table {
+	/** Number of buckets, a power of two. */
+	size_t size;
+	/** Smaller table whose buckets are being moved here or NULL. */
+	_Atomic(struct page_ht_table *) old;
+	/** Number of buckets of the old table moved so far. */
+	size_t migrated;
+	/** Singly-linked bucket chains. */
+	_Atomic(pte_t *) buckets[];
+} page_ht_table_t;
+
+/** Page hash table shard.
+ *
+ * Updates of a shard are serialized by its lock, which must be acquired
+ * after the address space lock and after any address space area locks.
+ * Lookups take no lock at all. Instead, they announce themselves in one of
+ * the two reader epochs and a PTE or a bucket array unlinked by an update is
+ * freed only after ht_synchronize() has waited for all readers which might
+ * still see it.
+ *
+ */
+typedef struct {
+	IRQ_SPINLOCK_DECLARE(lock);
+	/** Current bucket array. */
+	_Atomic(page_ht_table_t *) table;
+	/** Number of PTEs in the shard. */
+	size_t items;
+	/** Number of lockless readers in each of the two reader epochs. */
+	atomic_size_t readers[2];
+	/** Current reader epoch, changed only under the lock. */
+	atomic_size_t epoch;
+} page_ht_shard_t;
 
 static void ht_mapping_insert(as_t *, uintptr_t, uintptr_t, unsigned int);
 static void ht_mapping_remove(as_t *, uintptr_t);
@@ -65,28 +108,8 @@ static void ht_mapping_make_global(uintptr_t, size_t);
 
 slab_cache_t *pte_cache = NULL;
 
-/**
- * This lock protects the page hash table. It must be acquired
- * after address space lock and after any address space area
- * locks.
- *
- */
-IRQ_SPINLOCK_STATIC_INITIALIZE(page_ht_lock);
-
-/** Page hash table.
- *
- * The page hash table may be accessed only when page_ht_lock is held.
- *
- */
-hash_table_t page_ht;
-
-/** Hash table operations for page hash table. */
-const hash_table_ops_t ht_ops = {
-	.hash = ht_hash,
-	.key_hash = ht_key_hash,
-	.key_equal = ht_key_equal,
-	.remove_callback = ht_remove_callback
-};
+/** Page hash table shards, selected by the hash of the mapping. */
+static page_ht_shard_t page_ht[PAGE_HT_SHARDS];
 
 /** Page mapping operations for page hash table architectures. */
 const page_mapping_operations_t ht_mapping_operations = {
@@ -97,46 +120,307 @@ const page_mapping_operations_t ht_mapping_operations = {
 	.mapping_make_global = ht_mapping_make_global
 };
 
-/** Return the hash of the key stored in the item */
-size_t ht_hash(const ht_link_t *item)
+/** Allocate an empty bucket array.
+ *
+ * @param size Number of buckets, a power of two.
+ *
+ * @return New bucket array or NULL if there is not enough memory.
+ *
+ */
+static page_ht_table_t *ht_table_alloc(size_t size)
+{
+	page_ht_table_t *table = malloc(sizeof(page_ht_table_t) +
+	    size * sizeof(table->buckets[0]));
+	if (!table)
+		return NULL;
+
+	table->size = size;
+	atomic_init(&table->old, NULL);
+	table->migrated = 0;
+	for (size_t i = 0; i < size; i++)
+		atomic_init(&table->buckets[i], NULL);
+
+	return table;
+}
+
+/** Initialize the page hash table. */
+void page_ht_init(void)
 {
-	pte_t *pte = hash_table_get_inst(item, pte_t, link);
-	size_t hash = 0;
-	hash = hash_combine(hash, (uintptr_t) pte->as);
-	hash = hash_combine(hash, pte->page >> PAGE_WIDTH);
-	return hash;
+	for (size_t i = 0; i < PAGE_HT_SHARDS; i++) {
+		page_ht_shard_t *shard = &page_ht[i];
+
+		irq_spinlock_initialize(&shard->lock, "page_ht.shard.lock");
+		page_ht_table_t *table = ht_table_alloc(PAGE_HT_MIN_BUCKETS);
+		if (!table)
+			panic("Cannot allocate page hash table.");
+		atomic_init(&shard->table, table);
+		shard->items = 0;
+		atomic_init(&shard->readers[0], 0);
+		atomic_init(&shard->readers[1], 0);
+		atomic_init(&shard->epoch, 0);
+	}
 }
 
-/** Return the hash of the key. */
-size_t ht_key_hash(const void *arg)
+/** Compute the hash of a mapping. */
+static size_t ht_hash(as_t *as, uintptr_t page)
 {
-	const uintptr_t *key = arg;
 	size_t hash = 0;
-	hash = hash_combine(hash, key[KEY_AS]);
-	hash = hash_combine(hash, key[KEY_PAGE] >> PAGE_WIDTH);
-	return hash;
+	hash = hash_combine(hash, (uintptr_t) as);
+	hash = hash_combine(hash, page >> PAGE_WIDTH);
+	return hash_mix(hash);
+}
+
+/** Return the shard holding mappings with the given hash. */
+static page_ht_shard_t *ht_shard(size_t hash)
+{
+	return &page_ht[hash % PAGE_HT_SHARDS];
+}
+
+/** Return the bucket chain for the given hash. */
+static _Atomic(pte_t *) *ht_bucket(page_ht_table_t *table, size_t hash)
+{
+	return &table->buckets[(hash / PAGE_HT_SHARDS) & (table->size - 1)];
+}
+
+/** Enter a lockless read section of a shard.
+ *
+ * Preemption is disabled so that ht_synchronize() never waits for a reader
+ * which is not running.
+ *
+ * @return Reader epoch to be passed to ht_read_exit().
+ *
+ */
+static size_t ht_read_enter(page_ht_shard_t *shard)
+{
+	preemption_disable();
+	size_t epoch = atomic_load_explicit(&shard->epoch,
+	    memory_order_relaxed) & 1;
+	atomic_inc(&shard->readers[epoch]);
+	return epoch;
+}
+
+/** Leave a lockless read section of a shard. */
+static void ht_read_exit(page_ht_shard_t *shard, size_t epoch)
+{
+	atomic_fetch_sub_explicit(&shard->readers[epoch], 1,
+	    memory_order_release);
+	preemption_enable();
+}
+
+/** Wait for lockless readers of a shard.
+ *
+ * When this function returns, all readers which might have seen a PTE or
+ * a bucket array unlinked before the call are gone. New readers are steered
+ * to the other epoch, so a stream of TLB refills cannot delay the waiting
+ * indefinitely.
+ *
+ * @param shard Page hash table shard. Its lock must be held.
+ *
+ */
+static void ht_synchronize(page_ht_shard_t *shard)
+{
+	assert(irq_spinlock_locked(&shard->lock));
+
+	/* Make the preceding removal visible to all new readers */
+	atomic_thread_fence(memory_order_seq_cst);
+
+	for (unsigned int i = 0; i < 2; i++) {
+		size_t epoch = atomic_load_explicit(&shard->epoch,
+		    memory_order_relaxed);
+		atomic_store(&shard->epoch, epoch ^ 1);
+
+		while (atomic_load(&shard->readers[epoch & 1]) != 0)
+			cpu_spin_hint();
+	}
 }
 
-/** Return true if the key is equal to the item's lookup key. */
-bool ht_key_equal(const void *arg, const ht_link_t *item)
+/** Find a PTE in a bucket chain. */
+static pte_t *ht_chain_find(_Atomic(pte_t *) *head, as_t *as, uintptr_t page)
 {
-	const uintptr_t *key = arg;
-	pte_t *pte = hash_table_get_inst(item, pte_t, link);
-	return (key[KEY_AS] == (uintptr_t) pte->as) &&
-	    (key[KEY_PAGE] == pte->page);
+	pte_t *pte = atomic_load_explicit(head, memory_order_acquire);
+	while (pte) {
+		if ((pte->as == as) && (pte->page == page))
+			return pte;
+
+		pte = atomic_load_explicit(&pte->next, memory_order_acquire);
+	}
+
+	return NULL;
 }
 
-/** Callback on page hash table item removal.
+/** Unlink a PTE from a bucket chain.
+ *
+ * The PTE must not be freed until the lockless readers are synchronized.
  *
- * @param item Page hash table item being removed.
+ * @return Unlinked PTE or NULL if there was no such PTE in the chain.
  *
  */
-void ht_remove_callback(ht_link_t *item)
+static pte_t *ht_chain_unlink(_Atomic(pte_t *) *head, as_t *as,
+    uintptr_t page)
 {
-	assert(item);
+	_Atomic(pte_t *) *link = head;
+	pte_t *pte;
+
+	while ((pte = atomic_load_explicit(link, memory_order_relaxed))) {
+		if ((pte->as == as) && (pte->page == page)) {
+			atomic_store_explicit(link, atomic_load_explicit(
+			    &pte->next, memory_order_relaxed),
+			    memory_order_release);
+			return pte;
+		}
+
+		link = &pte->next;
+	}
 
-	pte_t *pte = hash_table_get_inst(item, pte_t, link);
-	slab_free(pte_cache, pte);
+	return NULL;
+}
+
+/** Publish a fully initialized PTE at the head of a bucket chain. */
+static void ht_chain_push(_Atomic(pte_t *) *head, pte_t *pte)
+{
+	atomic_store_explicit(&pte->next, atomic_load_explicit(head,
+	    memory_order_relaxed), memory_order_relaxed);
+	atomic_store_explicit(head, pte, memory_order_release);
+}
+
+/** Find a PTE in a shard.
+ *
+ * The caller must either hold the shard lock or be in a read section.
+ *
+ */
+static pte_t *ht_shard_find(page_ht_shard_t *shard, size_t hash, as_t *as,
+    uintptr_t page)
+{
+	page_ht_table_t *table = atomic_load_explicit(&shard->table,
+	    memory_order_acquire);
+	page_ht_table_t *old = atomic_load_explicit(&table->old,
+	    memory_order_acquire);
+
+	/*
+	 * A moved bucket has its copies published before it is emptied, so
+	 * the old table must be searched first.
+	 */
+	if (old) {
+		pte_t *pte = ht_chain_find(ht_bucket(old, hash), as, page);
+		if (pte)
+			return pte;
+	}
+
+	return ht_chain_find(ht_bucket(table, hash), as, page);
+}
+
+/** Copy one bucket chain of the old table into the current table.
+ *
+ * @return False if there was not enough memory, in which case nothing has
+ *         been published.
+ *
+ */
+static bool ht_chain_copy(page_ht_table_t *table, pte_t *chain)
+{
+	pte_t *copies = NULL;
+
+	for (pte_t *pte = chain; pte; pte = atomic_load_explicit(&pte->next,
+	    memory_order_relaxed)) {
+		pte_t *copy = slab_alloc(pte_cache,
+		    FRAME_LOWMEM | FRAME_ATOMIC);
+		if (!copy) {
+			while (copies) {
+				pte_t *next = atomic_load_explicit(
+				    &copies->next, memory_order_relaxed);
+				slab_free(pte_cache, copies);
+				copies = next;
+			}
+
+			return false;
+		}
+
+		*copy = *pte;
+		atomic_init(&copy->next, copies);
+		copies = copy;
+	}
+
+	while (copies) {
+		pte_t *next = atomic_load_explicit(&copies->next,
+		    memory_order_relaxed);
+		ht_chain_push(ht_bucket(table, ht_hash(copies->as,
+		    copies->page)), copies);
+		copies = next;
+	}
+
+	return true;
+}
+
+/** Grow a shard which became too loaded, one step at a time.
+ *
+ * Each call moves at most PAGE_HT_MIGRATE_STEP buckets of the old table
+ * so that no single update has to rehash the whole shard.
+ *
+ * @param shard Page hash table shard. Its lock must be held.
+ *
+ */
+static void ht_shard_grow(page_ht_shard_t *shard)
+{
+	page_ht_table_t *table = atomic_load_explicit(&shard->table,
+	    memory_order_relaxed);
+	page_ht_table_t *old = atomic_load_explicit(&table->old,
+	    memory_order_relaxed);
+
+	if (!old) {
+		if (shard->items <= PAGE_HT_MAX_LOAD * table->size)
+			return;
+
+		page_ht_table_t *grown = ht_table_alloc(2 * table->size);
+		if (!grown)
+			return;
+
+		atomic_init(&grown->old, table);
+		atomic_store_explicit(&shard->table, grown,
+		    memory_order_release);
+
+		/* Readers of the previous table do not look into the new one */
+		ht_synchronize(shard);
+
+		old = table;
+		table = grown;
+	}
+
+	pte_t *retired[PAGE_HT_MIGRATE_STEP];
+	size_t count = 0;
+
+	while ((count < PAGE_HT_MIGRATE_STEP) &&
+	    (table->migrated < old->size)) {
+		_Atomic(pte_t *) *head = &old->buckets[table->migrated];
+		pte_t *chain = atomic_load_explicit(head, memory_order_relaxed);
+
+		if ((chain) && (!ht_chain_copy(table, chain)))
+			break;
+
+		atomic_store_explicit(head, NULL, memory_order_release);
+		retired[count++] = chain;
+		table->migrated++;
+	}
+
+	bool done = (table->migrated == old->size);
+	if (done)
+		atomic_store_explicit(&table->old, NULL, memory_order_release);
+
+	if ((count == 0) && (!done))
+		return;
+
+	ht_synchronize(shard);
+
+	for (size_t i = 0; i < count; i++) {
+		pte_t *pte = retired[i];
+		while (pte) {
+			pte_t *next = atomic_load_explicit(&pte->next,
+			    memory_order_relaxed);
+			slab_free(pte_cache, pte);
+			pte = next;
+		}
+	}
+
+	if (done)
+		free(old);
 }
 
 /** Map page to frame using page hash table.
@@ -153,16 +437,15 @@ void ht_remove_callback(ht_link_t *item)
 void ht_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
     unsigned int flags)
 {
-	uintptr_t key[2] = {
-		[KEY_AS] = (uintptr_t) as,
-		[KEY_PAGE] = ALIGN_DOWN(page, PAGE_SIZE)
-	};
+	page = ALIGN_DOWN(page, PAGE_SIZE);
+	size_t hash = ht_hash(as, page);
+	page_ht_shard_t *shard = ht_shard(hash);
 
 	assert(page_table_locked(as));
 
-	irq_spinlock_lock(&page_ht_lock, true);
+	irq_spinlock_lock(&shard->lock, true);
 
-	if (!hash_table_find(&page_ht, key)) {
+	if (!ht_shard_find(shard, hash, as, page)) {
 		pte_t *pte = slab_alloc(pte_cache, FRAME_LOWMEM | FRAME_ATOMIC);
 		assert(pte != NULL);
 
@@ -176,19 +459,23 @@ void ht_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
 		pte->d = false;
 
 		pte->as = as;
-		pte->page = ALIGN_DOWN(page, PAGE_SIZE);
+		pte->page = page;
 		pte->frame = ALIGN_DOWN(frame, FRAME_SIZE);
 
 		/*
-		 * Make sure that a concurrent ht_mapping_find() will see the
-		 * new entry only after it is fully initialized.
+		 * New mappings always go to the current table. The release
+		 * store makes sure that a concurrent ht_mapping_find() will
+		 * see the new entry only after it is fully initialized.
 		 */
-		write_barrier();
-
-		hash_table_insert(&page_ht, &pte->link);
+		page_ht_table_t *table = atomic_load_explicit(&shard->table,
+		    memory_order_relaxed);
+		ht_chain_push(ht_bucket(table, hash), pte);
+		shard->items++;
 	}
 
-	irq_spinlock_unlock(&page_ht_lock, true);
+	ht_shard_grow(shard);
+
+	irq_spinlock_unlock(&shard->lock, true);
 }
 
 /** Remove mapping of page from page hash table.
@@ -203,41 +490,42 @@ void ht_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
  */
 void ht_mapping_remove(as_t *as, uintptr_t page)
 {
-	uintptr_t key[2] = {
-		[KEY_AS] = (uintptr_t) as,
-		[KEY_PAGE] = ALIGN_DOWN(page, PAGE_SIZE)
-	};
+	page = ALIGN_DOWN(page, PAGE_SIZE);
+	size_t hash = ht_hash(as, page);
+	page_ht_shard_t *shard = ht_shard(hash);
 
 	assert(page_table_locked(as));
 
-	irq_spinlock_lock(&page_ht_lock, true);
+	irq_spinlock_lock(&shard->lock, true);
 
-	/*
-	 * Note that removed PTE's will be freed
-	 * by remove_callback().
-	 */
-	hash_table_remove(&page_ht, key);
+	page_ht_table_t *table = atomic_load_explicit(&shard->table,
+	    memory_order_relaxed);
+	page_ht_table_t *old = atomic_load_explicit(&table->old,
+	    memory_order_relaxed);
 
-	irq_spinlock_unlock(&page_ht_lock, true);
-}
+	pte_t *pte = NULL;
+	if (old)
+		pte = ht_chain_unlink(ht_bucket(old, hash), as, page);
+	if (!pte)
+		pte = ht_chain_unlink(ht_bucket(table, hash), as, page);
 
-static pte_t *ht_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
-{
-	uintptr_t key[2] = {
-		[KEY_AS] = (uintptr_t) as,
-		[KEY_PAGE] = ALIGN_DOWN(page, PAGE_SIZE)
-	};
+	if (pte) {
+		shard->items--;
 
-	assert(nolock || page_table_locked(as));
+		/* Lockless readers may still be looking at the PTE */
+		ht_synchronize(shard);
+		slab_free(pte_cache, pte);
+	}
 
-	ht_link_t *cur = hash_table_find(&page_ht, key);
-	if (cur)
-		return hash_table_get_inst(cur, pte_t, link);
+	ht_shard_grow(shard);
 
-	return NULL;
+	irq_spinlock_unlock(&shard->lock, true);
 }
 
 /** Find mapping for virtual page in page hash table.
+ *
+ * The lookup does not take any lock, so TLB refills never wait for updates
+ * of the page hash table running on other CPUs.
  *
  * @param as       Address space to which page belongs.
  * @param page     Virtual page.
@@ -248,13 +536,19 @@ static pte_t *ht_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
  */
 bool ht_mapping_find(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 {
-	irq_spinlock_lock(&page_ht_lock, true);
+	page = ALIGN_DOWN(page, PAGE_SIZE);
+	size_t hash = ht_hash(as, page);
+	page_ht_shard_t *shard = ht_shard(hash);
+
+	assert(nolock || page_table_locked(as));
+
+	size_t epoch = ht_read_enter(shard);
 
-	pte_t *t = ht_mapping_find_internal(as, page, nolock);
+	pte_t *t = ht_shard_find(shard, hash, as, page);
 	if (t)
 		*pte = *t;
 
-	irq_spinlock_unlock(&page_ht_lock, true);
+	ht_read_exit(shard, epoch);
 
 	return t != NULL;
 }
@@ -268,9 +562,15 @@ bool ht_mapping_find(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
  */
 void ht_mapping_update(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 {
-	irq_spinlock_lock(&page_ht_lock, true);
+	page = ALIGN_DOWN(page, PAGE_SIZE);
+	size_t hash = ht_hash(as, page);
+	page_ht_shard_t *shard = ht_shard(hash);
+
+	assert(nolock || page_table_locked(as));
+
+	irq_spinlock_lock(&shard->lock, true);
 
-	pte_t *t = ht_mapping_find_internal(as, page, nolock);
+	pte_t *t = ht_shard_find(shard, hash, as, page);
 	if (!t)
 		panic("Updating non-existent PTE");
 
@@ -287,7 +587,7 @@ void ht_mapping_update(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 	t->a = pte->a;
 	t->d = pte->d;
 
-	irq_spinlock_unlock(&page_ht_lock, true);
+	irq_spinlock_unlock(&shard->lock, true);
 }
 
 void ht_mapping_make_global(uintptr_t base, size_t size)
@@ -57,32 +57,35 @@ static bool pt_mapping_find(as_t *, uintptr_t, bool, pte_t *pte);
 static void pt_mapping_update(as_t *, uintptr_t, bool, pte_t *pte);
 static void pt_mapping_make_global(uintptr_t, size_t);
 
+#ifdef LARGE_PAGE_WIDTH
+static bool pt_mapping_insert_large(as_t *, uintptr_t, uintptr_t,
+    unsigned int);
+#endif
+
 const page_mapping_operations_t pt_mapping_operations = {
 	.mapping_insert = pt_mapping_insert,
 	.mapping_remove = pt_mapping_remove,
 	.mapping_find = pt_mapping_find,
 	.mapping_update = pt_mapping_update,
-	.mapping_make_global = pt_mapping_make_global
+	.mapping_make_global = pt_mapping_make_global,
+#ifdef LARGE_PAGE_WIDTH
+	.mapping_insert_large = pt_mapping_insert_large,
+	.large_page_size = LARGE_PAGE_SIZE
+#endif
 };
 
-/** Map page to frame using hierarchical page tables.
+/** Find PTL2 for a page, allocate the missing page tables on the way.
  *
- * Map virtual address page to physical address frame
- * using flags.
+ * @param as   Address space to wich page belongs.
+ * @param page Virtual address of the page.
  *
- * @param as    Address space to wich page belongs.
- * @param page  Virtual address of the page to be mapped.
- * @param frame Physical address of memory frame to which the mapping is done.
- * @param flags Flags to be used for mapping.
+ * @return PTL2 holding the PTL3 pointer for the page.
  *
  */
-void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
-    unsigned int flags)
+static pte_t *pt_ptl2_get(as_t *as, uintptr_t page)
 {
 	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
 
-	assert(page_table_locked(as));
-
 	if (GET_PTL1_FLAGS(ptl0, PTL0_INDEX(page)) & PAGE_NOT_PRESENT) {
 		pte_t *newpt = (pte_t *)
 		    PA2KA(frame_alloc(PTL1_FRAMES, FRAME_LOWMEM, PTL1_SIZE - 1));
@@ -117,7 +120,109 @@ void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
 		SET_PTL2_PRESENT(ptl1, PTL1_INDEX(page));
 	}
 
-	pte_t *ptl2 = (pte_t *) PA2KA(GET_PTL2_ADDRESS(ptl1, PTL1_INDEX(page)));
+	return (pte_t *) PA2KA(GET_PTL2_ADDRESS(ptl1, PTL1_INDEX(page)));
+}
+
+#ifdef LARGE_PAGE_WIDTH
+
+/** Split a large page into a PTL3 full of equivalent base pages.
+ *
+ * The translation does not change, so no TLB shootdown is needed
+ * other than the one which follows the change of the base page.
+ *
+ * @param as   Address space to wich the large page belongs.
+ * @param ptl2 PTL2 holding the large page entry.
+ * @param i    Index of the large page entry.
+ *
+ */
+static void pt_large_page_split(as_t *as, pte_t *ptl2, size_t i)
+{
+	uintptr_t frame = (uintptr_t) GET_PTL3_ADDRESS(ptl2, i);
+	unsigned int flags = GET_LARGE_PAGE_FLAGS(ptl2, i);
+
+	pte_t *newpt = (pte_t *)
+	    PA2KA(frame_alloc(PTL3_FRAMES, FRAME_LOWMEM, PTL3_SIZE - 1));
+	memsetb(newpt, PTL3_SIZE, 0);
+
+	for (size_t j = 0; j < PTL3_ENTRIES; j++) {
+		SET_FRAME_ADDRESS(newpt, j, frame + j * PAGE_SIZE);
+		SET_FRAME_FLAGS(newpt, j, flags);
+	}
+
+	/*
+	 * Make the new PTL3 visible only after it is fully initialized.
+	 */
+	write_barrier();
+
+	pte_t entry;
+	memsetb(&entry, sizeof(pte_t), 0);
+	SET_PTL3_ADDRESS(&entry, 0, KA2PA(newpt));
+	SET_PTL3_FLAGS(&entry, 0,
+	    PAGE_PRESENT | PAGE_USER | PAGE_EXEC | PAGE_CACHEABLE |
+	    PAGE_WRITE);
+	ptl2[i] = entry;
+
+	as->large_pages--;
+}
+
+/** Map large page to contiguous frames using hierarchical page tables.
+ *
+ * @param as    Address space to wich page belongs.
+ * @param page  Virtual address of the large page to be mapped.
+ * @param frame Physical address of the first frame.
+ * @param flags Flags to be used for mapping.
+ *
+ * @return False if some base page of the range is already mapped.
+ *
+ */
+bool pt_mapping_insert_large(as_t *as, uintptr_t page, uintptr_t frame,
+    unsigned int flags)
+{
+	assert(page_table_locked(as));
+
+	pte_t *ptl2 = pt_ptl2_get(as, page);
+
+	if (!(GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT))
+		return false;
+
+	SET_PTL3_ADDRESS(ptl2, PTL2_INDEX(page), frame);
+	SET_LARGE_PAGE_FLAGS(ptl2, PTL2_INDEX(page), flags | PAGE_NOT_PRESENT);
+	/*
+	 * Make the new mapping visible only after it is fully initialized.
+	 */
+	write_barrier();
+	SET_PTL3_PRESENT(ptl2, PTL2_INDEX(page));
+
+	as->large_pages++;
+
+	return true;
+}
+
+#endif /* LARGE_PAGE_WIDTH */
+
+/** Map page to frame using hierarchical page tables.
+ *
+ * Map virtual address page to physical address frame
+ * using flags.
+ *
+ * @param as    Address space to wich page belongs.
+ * @param page  Virtual address of the page to be mapped.
+ * @param frame Physical address of memory frame to which the mapping is done.
+ * @param flags Flags to be used for mapping.
+ *
+ */
+void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
+    unsigned int flags)
+{
+	assert(page_table_locked(as));
+
+	pte_t *ptl2 = pt_ptl2_get(as, page);
+
+#ifdef LARGE_PAGE_WIDTH
+	if (!(GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT) &&
+	    IS_LARGE_PAGE(ptl2, PTL2_INDEX(page)))
+		pt_large_page_split(as, ptl2, PTL2_INDEX(page));
+#endif
 
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT) {
 		pte_t *newpt = (pte_t *)
@@ -177,6 +282,12 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT)
 		return;
 
+#ifdef LARGE_PAGE_WIDTH
+	/* Keep the rest of the large page mapped */
+	if (IS_LARGE_PAGE(ptl2, PTL2_INDEX(page)))
+		pt_large_page_split(as, ptl2, PTL2_INDEX(page));
+#endif
+
 	pte_t *ptl3 = (pte_t *) PA2KA(GET_PTL3_ADDRESS(ptl2, PTL2_INDEX(page)));
 
 	/*
@@ -291,8 +402,11 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 #endif /* PTL1_ENTRIES != 0 */
 }
 
-static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
+static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock,
+    bool *large)
 {
+	*large = false;
+
 	assert(nolock || page_table_locked(as));
 
 	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
@@ -316,6 +430,13 @@ static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT)
 		return NULL;
 
+#ifdef LARGE_PAGE_WIDTH
+	if (IS_LARGE_PAGE(ptl2, PTL2_INDEX(page))) {
+		*large = true;
+		return &ptl2[PTL2_INDEX(page)];
+	}
+#endif
+
 #if (PTL2_ENTRIES != 0)
 	/*
 	 * Always read ptl3 only after we are sure it is present.
@@ -339,10 +460,25 @@ static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
  */
 bool pt_mapping_find(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 {
-	pte_t *t = pt_mapping_find_internal(as, page, nolock);
-	if (t)
-		*pte = *t;
-	return t != NULL;
+	bool large;
+	pte_t *t = pt_mapping_find_internal(as, page, nolock, &large);
+	if (!t)
+		return false;
+
+	*pte = *t;
+
+#ifdef LARGE_PAGE_WIDTH
+	if (large) {
+		/* Produce the PTE of the base page within the large page. */
+		uintptr_t frame = (uintptr_t) GET_PTL3_ADDRESS(t, 0) +
+		    (page & (LARGE_PAGE_SIZE - 1));
+
+		LARGE_PAGE_TO_PTE(pte);
+		SET_FRAME_ADDRESS(pte, 0, frame);
+	}
+#endif
+
+	return true;
 }
 
 /** Update mapping for virtual page in hierarchical page tables.
@@ -354,10 +490,18 @@ bool pt_mapping_find(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
  */
 void pt_mapping_update(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 {
-	pte_t *t = pt_mapping_find_internal(as, page, nolock);
+	bool large;
+	pte_t *t = pt_mapping_find_internal(as, page, nolock, &large);
 	if (!t)
 		panic("Updating non-existent PTE");
 
+	/*
+	 * Only the architectures which do not use large pages need
+	 * to update the PTEs.
+	 */
+	if (large)
+		panic("Updating large page PTE");
+
 	assert(PTE_VALID(t) == PTE_VALID(pte));
 	assert(PTE_PRESENT(t) == PTE_PRESENT(pte));
 	assert(PTE_GET_FRAME(t) == PTE_GET_FRAME(pte));
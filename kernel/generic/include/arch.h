@@ -88,6 +88,9 @@ typedef struct {
 	void (*post_cpu_init)(void);
 	void (*pre_smp_init)(void);
 	void (*post_smp_init)(void);
+
+	/** Read a hardware random number, return false if not available */
+	bool (*hw_random)(uint64_t *);
 } arch_ops_t;
 
 extern arch_ops_t *arch_ops;
@@ -98,6 +98,19 @@ _NO_TRACE static inline uint8_t fnzb64(uint64_t arg)
 	return n + fnzb32((uint32_t) arg);
 }
 
+/** Return position of last non-zero bit from left (32b variant).
+ *
+ * In other words, return the position of the least significant
+ * non-zero bit.
+ *
+ * @return 0 (if the number is zero) or the index of the lowest set bit.
+ *
+ */
+_NO_TRACE static inline uint8_t lnzb32(uint32_t arg)
+{
+	return fnzb32(arg & -arg);
+}
+
 #endif
 
 /** @}
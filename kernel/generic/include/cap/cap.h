@@ -38,10 +38,9 @@
 #include <abi/cap.h>
 #include <typedefs.h>
 #include <adt/list.h>
-#include <adt/hash.h>
-#include <adt/hash_table.h>
 #include <lib/ra.h>
 #include <synch/mutex.h>
+#include <synch/rcu.h>
 #include <atomic.h>
 
 typedef enum {
@@ -75,11 +74,14 @@ extern kobject_ops_t *kobject_ops[];
 
 /*
  * Everything in kobject_t except for the atomic reference count, the capability
- * list and its lock is imutable.
+ * list and its lock is imutable. The kobject_t is freed only after an RCU grace
+ * period, lockless readers never take a reference once it dropped to zero.
  */
 typedef struct kobject {
 	kobject_type_t type;
 	atomic_size_t refcnt;
+	/** Deferred freeing of the kobject_t */
+	rcu_item_t rcu;
 
 	/** Mutex protecting caps_list */
 	mutex_t caps_list_lock;
@@ -110,18 +112,39 @@ typedef struct cap {
 	/* Link to the task's capabilities of the same kobject type. */
 	link_t type_link;
 
-	ht_link_t caps_link;
-
 	/* The underlying kernel object. */
 	kobject_t *kobject;
 } cap_t;
 
+typedef struct {
+	/** Capability, protected by the cap_info_t lock. */
+	cap_t *cap;
+	/**
+	 * Kernel object of a published capability, NULL otherwise. It is
+	 * read without holding any lock by kobject_get().
+	 */
+	_Atomic(kobject_t *) kobject;
+} cap_slot_t;
+
+/** Capability table indexed by capability handles. */
+typedef struct {
+	/** Deferred freeing of a replaced table */
+	rcu_item_t rcu;
+	size_t size;
+	cap_slot_t slots[];
+} cap_table_t;
+
 typedef struct cap_info {
 	mutex_t lock;
 
 	list_t type_list[KOBJECT_TYPE_MAX];
 
-	hash_table_t caps;
+	/**
+	 * Capability table. It is only replaced under the lock, but RCU
+	 * readers may still be using the previous table.
+	 */
+	_Atomic(cap_table_t *) table;
+
 	ra_arena_t *handles;
 } cap_info_t;
 
@@ -133,6 +156,7 @@ extern bool caps_apply_to_kobject_type(struct task *, kobject_type_t,
     bool (*)(cap_t *, void *), void *);
 
 extern errno_t cap_alloc(struct task *, cap_handle_t *);
+extern errno_t cap_alloc_at(struct task *, cap_handle_t);
 extern void cap_publish(struct task *, cap_handle_t, kobject_t *);
 extern kobject_t *cap_unpublish(struct task *, cap_handle_t, kobject_type_t);
 extern void cap_revoke(kobject_t *);
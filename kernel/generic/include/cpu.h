@@ -35,16 +35,32 @@
 #ifndef KERN_CPU_H_
 #define KERN_CPU_H_
 
+#include <mm/frame.h>
 #include <mm/tlb.h>
+#include <abi/sysinfo.h>
 #include <synch/spinlock.h>
 #include <proc/scheduler.h>
 #include <arch/cpu.h>
 #include <arch/context.h>
 #include <adt/list.h>
+#include <adt/twheel.h>
 #include <arch.h>
 
 #define CPU                  CURRENT->cpu
 
+/** Scheduling domains
+ *
+ * The smallest domain shared by two processors determines how expensive
+ * it is to migrate threads between them.
+ */
+typedef enum {
+	CPU_DOMAIN_CORE,     /**< SMT siblings sharing a core */
+	CPU_DOMAIN_PACKAGE,  /**< Cores sharing a physical package */
+	CPU_DOMAIN_NODE,     /**< Packages sharing a NUMA node */
+	CPU_DOMAIN_SYSTEM,   /**< All processors */
+	CPU_DOMAIN_COUNT
+} cpu_domain_t;
+
 /** CPU structure.
  *
  * There is one structure like this for every processor.
@@ -58,8 +74,24 @@ typedef struct cpu {
 	atomic_size_t nrdy;
 	runq_t rq[RQ_COUNT];
 
+	/**
+	 * Bitmap of non-empty run queues. Bit i is set iff rq[i] is not
+	 * empty. The bit is only changed while holding rq[i].lock, but
+	 * it can be read without any lock to find the best queue quickly.
+	 */
+	atomic_uint rq_bitmap;
+
 	IRQ_SPINLOCK_DECLARE(timeoutlock);
-	list_t timeout_active_list;
+	/** Active timeouts, by the tick in which they expire */
+	twheel_t timeout_wheel;
+	/** Expired timeouts whose handlers have not run yet */
+	list_t timeout_expired;
+
+	/** RCU callbacks queued on this processor, see synch/rcu.c */
+	IRQ_SPINLOCK_DECLARE(rcu_lock);
+	list_t rcu_cbs;
+	/** Last RCU grace period in which this processor was quiescent */
+	atomic_size_t rcu_qs;
 
 	/**
 	 * When system clock loses a tick, it is
@@ -74,20 +106,80 @@ typedef struct cpu {
 	uint64_t current_clock_tick;
 	uint64_t preempt_deadline;  /* < when should the currently running thread be preempted */
 	uint64_t relink_deadline;
+	/** Preempt the running thread at the next tick, ignoring the deadline */
+	atomic_bool preempt_request;
+
+	/**
+	 * Number of ticks for which the periodic tick of this idle CPU has
+	 * been stopped or zero if the tick is running.
+	 */
+	uint64_t tick_stopped;
+	uint64_t tick_stops;  /**< Number of times the tick was stopped */
+
+#ifdef CONFIG_PROFILER
+	/** Protects prof_ring */
+	IRQ_SPINLOCK_DECLARE(prof_lock);
+	/** Profiler sample buffer, NULL if the profiler is stopped */
+	struct prof_ring *prof_ring;
+	/** Clock ticks since the last sample, accessed by this CPU only */
+	unsigned int prof_ticks;
+#endif
+
+	/** Free frames for single-frame allocations on this CPU */
+	frame_cache_t frame_cache;
+
+	/** Kernel log of this CPU */
+	struct log_cpu *log;
 
 	/**
 	 * Processor cycle accounting.
 	 */
 	bool idle;
+	/** Excluded from load balancing and from threads without a CPU set. */
+	bool isolated;
 	uint64_t last_cycle;
 	uint64_t idle_cycles;
 	uint64_t busy_cycles;
 
+	/**
+	 * Scheduler accounting. Can only be modified by the CPU represented
+	 * by this structure when interrupts are disabled.
+	 */
+	uint64_t sched_count;   /**< Number of thread selections */
+	uint64_t sched_cycles;  /**< Cycles spent selecting threads */
+	uint64_t steals;        /**< Threads stolen when going idle */
+	uint64_t steals_failed; /**< Unsuccessful attempts to steal a thread */
+	uint64_t migrations;    /**< Threads migrated here by kcpulb */
+
+	/**
+	 * TLB shootdown accounting. Can only be modified by the CPU
+	 * represented by this structure when interrupts are disabled.
+	 */
+	uint64_t tlb_shootdowns;  /**< Shootdowns initiated */
+	uint64_t tlb_ipis;        /**< Shootdown IPIs received */
+	uint64_t tlb_lazy;        /**< Queued shootdowns handled on AS switch */
+	uint64_t tlb_latency[STATS_TLB_LATENCY_BUCKETS];
+
+	/**
+	 * Address space installed on this processor. Protected by the TLB
+	 * shootdown lock.
+	 */
+	struct as *tlb_as;
+
 	/**
 	 * Processor ID assigned by kernel.
 	 */
 	unsigned int id;
 
+	/**
+	 * Processor topology as detected by cpu_identify(). By default,
+	 * each processor is a separate core of a single package in a
+	 * single NUMA node.
+	 */
+	unsigned int core_id;     /**< Core ID (unique within the package) */
+	unsigned int package_id;  /**< Physical package ID */
+	unsigned int numa_node;   /**< NUMA node */
+
 	bool active;
 	volatile bool tlb_active;
 
@@ -98,6 +190,13 @@ typedef struct cpu {
 
 	struct thread *fpu_owner;
 
+	/**
+	 * Interrupt timing pool, folded into the global entropy pool every
+	 * few samples. Only accessed with interrupts disabled.
+	 */
+	uint32_t entropy_fast[4];
+	unsigned int entropy_samples;
+
 	/**
 	 * Stack used by scheduler when there is no running thread.
 	 */
@@ -108,6 +207,7 @@ extern cpu_t *cpus;
 
 extern void cpu_init(void);
 extern void cpu_list(void);
+extern cpu_domain_t cpu_domain(cpu_t *, cpu_t *);
 
 extern void cpu_arch_init(void);
 extern void cpu_identify(void);
@@ -38,7 +38,7 @@
 #include <typedefs.h>
 #include <abi/ddi/irq.h>
 #include <adt/list.h>
-#include <adt/hash_table.h>
+#include <synch/rcu.h>
 #include <synch/spinlock.h>
 #include <proc/task.h>
 #include <ipc/ipc.h>
@@ -70,7 +70,7 @@ typedef void (*cir_t)(void *, inr_t);
 typedef struct {
 	/** When false, notifications are not sent. */
 	bool notify;
-	/** True if the structure is in irq_uspace_hash_table_table */
+	/** True if the structure is in one of the IRQ hash tables */
 	bool hashed_in;
 	/** Answerbox for notifications. */
 	answerbox_t *answerbox;
@@ -82,6 +82,14 @@ typedef struct {
 	irq_code_t *code;
 	/** Counter. */
 	size_t counter;
+	/** Coalescing notification still waiting in the answerbox. */
+	call_t *pending;
+	/** Number of interrupts merged into a pending notification. */
+	size_t coalesced;
+	/** Number of notifications lost for lack of memory. */
+	size_t dropped;
+	/** CPU the interrupt is routed to or IRQ_CPU_ANY. */
+	unsigned int cpu;
 } ipc_notif_cfg_t;
 
 /** Structure representing one device IRQ.
@@ -90,11 +98,13 @@ typedef struct {
  * instantions.
  */
 typedef struct irq {
-	/** Hash table link. */
-	ht_link_t link;
+	/** Next IRQ in the hash table chain, followed by RCU readers. */
+	_Atomic(struct irq *) next;
+	/** Deferred freeing of the structure. */
+	rcu_item_t rcu;
 
 	/** Lock protecting everything in this structure
-	 *  except the link member. When both the IRQ
+	 *  except the next member. When both the IRQ
 	 *  hash table lock and this lock are to be acquired,
 	 *  this lock must not be taken first.
 	 */
@@ -128,8 +138,15 @@ typedef struct irq {
 	ipc_notif_cfg_t notif_cfg;
 } irq_t;
 
+/** Interrupt routing operations provided by the interrupt controller. */
+typedef struct {
+	/** Route an interrupt to a CPU or to any CPU (IRQ_CPU_ANY). */
+	errno_t (*set_affinity)(inr_t, unsigned int);
+} irq_route_ops_t;
+
+extern irq_route_ops_t *irq_route_ops;
+
 IRQ_SPINLOCK_EXTERN(irq_uspace_hash_table_lock);
-extern hash_table_t irq_uspace_hash_table;
 
 extern slab_cache_t *irq_cache;
 
@@ -138,6 +155,8 @@ extern inr_t last_inr;
 extern void irq_init(size_t, size_t);
 extern void irq_initialize(irq_t *);
 extern void irq_register(irq_t *);
+extern void irq_uspace_insert(irq_t *);
+extern void irq_uspace_remove(irq_t *);
 extern irq_t *irq_dispatch_and_lock(inr_t);
 
 #endif
@@ -48,6 +48,13 @@ struct answerbox;
 struct task;
 struct call;
 
+/**
+ * IPC_M_DATA_WRITE and IPC_M_DATA_READ transfers of at least this many bytes
+ * copy the data directly from the pinned source frames to the destination.
+ * Smaller transfers go through a kernel bounce buffer.
+ */
+#define DATA_XFER_PIN_THRESHOLD  (16 * 1024)
+
 typedef enum {
 	/** Phone is free and can be allocated */
 	IPC_PHONE_FREE = 0,
@@ -73,6 +80,10 @@ typedef struct phone {
 	atomic_size_t active_calls;
 	/** User-defined label */
 	sysarg_t label;
+#ifdef CONFIG_IPC_PROFILE
+	/** Interface the phone was connected to (for profiling) */
+	sysarg_t iface;
+#endif
 	kobject_t *kobject;
 } phone_t;
 
@@ -165,6 +176,25 @@ typedef struct call {
 
 	/** Buffer for IPC_M_DATA_WRITE and IPC_M_DATA_READ. */
 	uint8_t *buffer;
+
+	/**
+	 * Frames of the source buffer pinned instead of copying it to
+	 * @c buffer.
+	 */
+	uintptr_t *frames;
+	/** Number of pinned frames. */
+	size_t frames_count;
+	/** Offset of the data within the first pinned frame. */
+	size_t frames_offset;
+
+#ifdef CONFIG_IPC_PROFILE
+	/** True if the answer should be accounted in the sender's profile. */
+	bool profiled;
+	/** Slot of the sender's IPC profile the call is accounted to. */
+	size_t prof_slot;
+	/** Cycle counter when the call was sent. */
+	uint64_t prof_start;
+#endif
 } call_t;
 
 extern slab_cache_t *phone_cache;
@@ -195,6 +225,10 @@ extern void ipc_backsend_err(phone_t *, call_t *, errno_t);
 extern void ipc_answerbox_slam_phones(answerbox_t *, bool);
 extern void ipc_cleanup_call_list(answerbox_t *, list_t *);
 
+extern errno_t ipc_call_buffer_pin(call_t *, uspace_addr_t, size_t);
+extern errno_t ipc_call_buffer_copy_out(call_t *, uspace_addr_t, size_t);
+extern void ipc_call_buffer_release(call_t *);
+
 extern void ipc_print_task(task_id_t);
 
 #endif
@@ -55,6 +55,8 @@ extern void ipc_irq_top_half_handler(irq_t *);
 extern errno_t ipc_irq_subscribe(answerbox_t *, inr_t, sysarg_t, uspace_ptr_irq_code_t,
     uspace_ptr_cap_irq_handle_t);
 extern errno_t ipc_irq_unsubscribe(answerbox_t *, cap_irq_handle_t);
+extern errno_t ipc_irq_set_affinity(answerbox_t *, cap_irq_handle_t,
+    unsigned int);
 
 /*
  * User friendly wrappers for ipc_irq_send_msg(). They are in the form
@@ -48,7 +48,10 @@ extern sys_errno_t sys_ipc_call_async_slow(cap_phone_handle_t, uspace_ptr_ipc_da
 extern sys_errno_t sys_ipc_answer_fast(cap_call_handle_t, sysarg_t, sysarg_t,
     sysarg_t, sysarg_t, sysarg_t);
 extern sys_errno_t sys_ipc_answer_slow(cap_call_handle_t, uspace_ptr_ipc_data_t);
+extern sys_errno_t sys_ipc_answer_batch(uspace_ptr_ipc_data_t, size_t);
 extern sys_errno_t sys_ipc_wait_for_call(uspace_ptr_ipc_data_t, uint32_t, unsigned int);
+extern sys_errno_t sys_ipc_wait_for_calls(uspace_ptr_ipc_data_t, size_t,
+    uint32_t, unsigned int, uspace_ptr_size_t);
 extern sys_errno_t sys_ipc_poke(void);
 extern sys_errno_t sys_ipc_forward_fast(cap_call_handle_t, cap_phone_handle_t,
     sysarg_t, sysarg_t, sysarg_t, unsigned int);
@@ -59,6 +62,7 @@ extern sys_errno_t sys_ipc_hangup(cap_phone_handle_t);
 extern sys_errno_t sys_ipc_irq_subscribe(inr_t, sysarg_t, uspace_ptr_irq_code_t,
     uspace_ptr_cap_irq_handle_t);
 extern sys_errno_t sys_ipc_irq_unsubscribe(cap_irq_handle_t);
+extern sys_errno_t sys_ipc_irq_set_affinity(cap_irq_handle_t, sysarg_t);
 
 extern sys_errno_t sys_ipc_connect_kbox(uspace_ptr_task_id_t, uspace_ptr_cap_phone_handle_t);
 
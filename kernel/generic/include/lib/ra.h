@@ -40,9 +40,14 @@
 #include <adt/hash_table.h>
 #include <synch/spinlock.h>
 
+struct ra_qcache;
+
 typedef struct {
 	IRQ_SPINLOCK_DECLARE(lock);
 	list_t spans;		/**< List of arena's spans. */
+
+	size_t quantum;			/**< Quantum of the quantum caches. */
+	struct ra_qcache *qcache;	/**< Per-CPU quantum caches or NULL. */
 } ra_arena_t;
 
 typedef struct {
@@ -52,6 +57,7 @@ typedef struct {
 
 	size_t max_order;	/**< Base 2 logarithm of span's size. */
 	list_t *free;		/**< max_order segment free lists. */
+	uint64_t free_map;	/**< Bitmap of non-empty free lists. */
 
 	hash_table_t used;
 
@@ -89,7 +95,9 @@ extern ra_arena_t *ra_arena_create(void);
 extern void ra_arena_destroy(ra_arena_t *);
 extern bool ra_span_add(ra_arena_t *, uintptr_t, size_t);
 extern bool ra_alloc(ra_arena_t *, size_t, size_t, uintptr_t *);
+extern bool ra_alloc_at(ra_arena_t *, uintptr_t, size_t);
 extern void ra_free(ra_arena_t *, uintptr_t, size_t);
+extern bool ra_qcache_enable(ra_arena_t *, size_t);
 
 #endif
 
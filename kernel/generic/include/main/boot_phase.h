@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_BOOT_PHASE_H_
+#define KERN_BOOT_PHASE_H_
+
+/** Kernel boot phases.
+ *
+ * Each phase is stamped with the cycle counter when it is reached and the
+ * stamps are exported in sysinfo as boot.phase.<name>.
+ */
+typedef enum {
+	/** main_bsp() switched to the kernel stack */
+	BOOT_PHASE_ENTRY,
+	/** Memory management is initialized */
+	BOOT_PHASE_MM,
+	/** Bootstrap processor is initialized */
+	BOOT_PHASE_CPU,
+	/** kinit thread started */
+	BOOT_PHASE_KINIT,
+	/** All application processors were started */
+	BOOT_PHASE_SMP,
+	/** Last application processor finished its initialization */
+	BOOT_PHASE_AP_READY,
+	/** Init tasks were started */
+	BOOT_PHASE_USPACE,
+	/** Deferred kernel initialization finished */
+	BOOT_PHASE_DEFERRED,
+	BOOT_PHASE_COUNT
+} boot_phase_t;
+
+extern void boot_phase_mark(boot_phase_t);
+extern void boot_phase_init(void);
+
+#endif
+
+/** @}
+ */
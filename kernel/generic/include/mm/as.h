@@ -126,6 +126,25 @@ typedef struct as {
 	 */
 	odict_t as_areas;
 
+	/** Number of large pages mapped. Protected by the page table lock. */
+	size_t large_pages;
+
+	/** Number of serviced page faults. Protected by the page table lock. */
+	uint64_t page_faults;
+
+	/**
+	 * Number of pages mapped ahead of sequentially faulting pages.
+	 * Protected by the page table lock.
+	 */
+	uint64_t fault_around;
+
+	/**
+	 * Processors which may hold TLB entries of this address space or
+	 * NULL if TLB shootdowns must reach all processors. Protected by
+	 * the TLB shootdown lock.
+	 */
+	struct cpu_mask *tlb_cpus;
+
 	/** Non-generic content. */
 	as_genarch_t genarch;
 
@@ -316,6 +335,7 @@ extern void as_hold(as_t *);
 extern void as_release(as_t *);
 extern void as_switch(as_t *, as_t *);
 extern int as_page_fault(uintptr_t, pf_access_t, istate_t *);
+extern errno_t as_prefault(uintptr_t, size_t, pf_access_t);
 
 extern as_area_t *as_area_create(as_t *, unsigned int, size_t, unsigned int,
     mem_backend_t *, mem_backend_data_t *, uintptr_t *, uintptr_t);
@@ -324,6 +344,8 @@ extern errno_t as_area_resize(as_t *, uintptr_t, size_t, unsigned int);
 extern errno_t as_area_share(as_t *, uintptr_t, size_t, as_t *, unsigned int,
     uintptr_t *, uintptr_t);
 extern errno_t as_area_change_flags(as_t *, unsigned int, uintptr_t);
+extern errno_t as_clone(as_t *, as_t *);
+extern bool as_page_cow_break(as_area_t *, uintptr_t, uintptr_t *);
 extern as_area_t *as_area_first(as_t *);
 extern as_area_t *as_area_next(as_area_t *);
 
@@ -41,12 +41,19 @@
 #include <adt/bitmap.h>
 #include <adt/list.h>
 #include <synch/spinlock.h>
+#include <atomic.h>
 #include <arch/mm/page.h>
 #include <arch/mm/frame.h>
 
 /** Maximum number of zones in the system. */
 #define ZONES_MAX  32
 
+/** Number of free frames a CPU can keep for itself. */
+#define FRAME_CACHE_SIZE   64
+
+/** Number of frames moved between a CPU frame cache and the zones at once. */
+#define FRAME_CACHE_BATCH  16
+
 typedef uint8_t frame_flags_t;
 
 #define FRAME_NONE        0x00
@@ -90,10 +97,23 @@ typedef uint8_t zone_flags_t;
 	    (((zf) & ~ZONE_EF_MASK) & (f)))
 
 typedef struct {
-	size_t refcount;  /**< Tracking of shared frames */
-	void *parent;     /**< If allocated by slab, this points there */
+	atomic_size_t refcount;  /**< Tracking of shared frames */
+	void *parent;            /**< If allocated by slab, this points there */
 } frame_t;
 
+/** Per-CPU cache of free frames
+ *
+ * The cached frames remain allocated in their zones, each holding a single
+ * reference owned by the cache. For the purpose of memory reservations,
+ * they are considered free.
+ *
+ */
+typedef struct {
+	IRQ_SPINLOCK_DECLARE(lock);
+	size_t count;                  /**< Number of cached frames */
+	pfn_t frames[FRAME_CACHE_SIZE];
+} frame_cache_t;
+
 typedef struct {
 	/** Frame_no of the first frame in the frames array */
 	pfn_t base;
@@ -110,6 +130,9 @@ typedef struct {
 	/** Type of the zone */
 	zone_flags_t flags;
 
+	/** NUMA node the zone belongs to */
+	unsigned int node;
+
 	/** Frame bitmap */
 	bitmap_t bitmap;
 
@@ -125,6 +148,9 @@ typedef struct {
 	IRQ_SPINLOCK_DECLARE(lock);
 	size_t count;
 	zone_t info[ZONES_MAX];
+
+	/** Number of NUMA nodes the zones belong to */
+	unsigned int nodes;
 } zones_t;
 
 extern zones_t zones;
@@ -138,6 +164,10 @@ extern void frame_free_generic(uintptr_t, size_t, frame_flags_t);
 extern void frame_free(uintptr_t, size_t);
 extern void frame_free_noreserve(uintptr_t, size_t);
 extern void frame_reference_add(pfn_t);
+extern bool frame_reference_add_lowmem(pfn_t);
+extern size_t frame_reference_count(pfn_t);
+extern void frame_cache_init(frame_cache_t *);
+extern size_t frame_cache_drain_all(void);
 extern size_t frame_total_free_get(void);
 
 extern size_t find_zone(pfn_t, size_t, size_t);
@@ -149,6 +179,7 @@ extern size_t zone_conf_size(size_t);
 extern pfn_t zone_external_conf_alloc(size_t);
 extern bool zone_merge(size_t, size_t);
 extern void zone_merge_all(void);
+extern void zone_set_node(pfn_t, size_t, unsigned int);
 extern uint64_t zones_total_size(void);
 extern void zones_stats(uint64_t *, uint64_t *, uint64_t *, uint64_t *);
 
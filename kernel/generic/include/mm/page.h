@@ -50,6 +50,11 @@ typedef struct {
 	bool (*mapping_find)(as_t *, uintptr_t, bool, pte_t *);
 	void (*mapping_update)(as_t *, uintptr_t, bool, pte_t *);
 	void (*mapping_make_global)(uintptr_t, size_t);
+
+	/** Map a large page, NULL if large pages are not supported. */
+	bool (*mapping_insert_large)(as_t *, uintptr_t, uintptr_t, unsigned int);
+	/** Size of a large page. */
+	size_t large_page_size;
 } page_mapping_operations_t;
 
 extern const page_mapping_operations_t *page_mapping_operations;
@@ -63,6 +68,9 @@ extern void page_mapping_remove(as_t *, uintptr_t);
 extern bool page_mapping_find(as_t *, uintptr_t, bool, pte_t *);
 extern void page_mapping_update(as_t *, uintptr_t, bool, pte_t *);
 extern void page_mapping_make_global(uintptr_t, size_t);
+extern bool page_mapping_insert_large(as_t *, uintptr_t, uintptr_t,
+    unsigned int);
+extern size_t page_large_size(void);
 extern pte_t *page_table_create(unsigned int);
 extern void page_table_destroy(pte_t *);
 
@@ -38,11 +38,24 @@
 #include <adt/list.h>
 #include <synch/spinlock.h>
 #include <atomic.h>
+#include <abi/sysinfo.h>
 #include <mm/frame.h>
 
-/** Initial Magazine size (TODO: dynamically growing magazines) */
+/** Initial Magazine size */
 #define SLAB_MAG_SIZE  4
 
+/** Number of magazine sizes, each one twice the previous */
+#define SLAB_MAG_CLASSES  5
+
+/** Maximum Magazine size */
+#define SLAB_MAG_SIZE_MAX  (SLAB_MAG_SIZE << (SLAB_MAG_CLASSES - 1))
+
+/** Number of depot accesses over which the contention rate is measured */
+#define SLAB_DEPOT_WINDOW  256
+
+/** Contended depot accesses per window which make the magazines grow */
+#define SLAB_DEPOT_CONTENTION  8
+
 /** If object size is less, store control structure inside SLAB */
 #define SLAB_INSIDE_SIZE  (PAGE_SIZE >> 3)
 
@@ -71,10 +84,20 @@ typedef struct {
 	void *objs[];  /**< Slots in magazine */
 } slab_magazine_t;
 
+/** Per-CPU magazines
+ *
+ * Only the owning CPU touches the magazines (with interrupts disabled),
+ * others just ask it to flush them to the slabs.
+ *
+ */
 typedef struct {
 	slab_magazine_t *current;
 	slab_magazine_t *last;
-	IRQ_SPINLOCK_DECLARE(lock);
+	atomic_bool flush;  /**< Flush requested by slab_reclaim() */
+
+	/* Statistics */
+	size_t hits;    /**< Allocations satisfied from a magazine */
+	size_t misses;  /**< Allocations which went to the slabs */
 } slab_mag_cache_t;
 
 typedef struct {
@@ -103,6 +126,10 @@ typedef struct {
 	atomic_size_t cached_objs;
 	/** How many magazines in magazines list */
 	atomic_size_t magazine_counter;
+	/** Depot accesses, protected by maglock */
+	size_t depot_accesses;
+	/** Depot accesses which found maglock locked, protected by maglock */
+	size_t depot_contention;
 
 	/* Slabs */
 	list_t full_slabs;     /**< List of full slabs */
@@ -112,6 +139,11 @@ typedef struct {
 	list_t magazines;  /**< List o full magazines */
 	IRQ_SPINLOCK_DECLARE(maglock);
 
+	/** Size of newly allocated magazines, grows on depot contention */
+	size_t mag_size;
+	/** Contended depot accesses in the current window */
+	size_t depot_window_contention;
+
 	/** CPU cache */
 	slab_mag_cache_t *mag_cache;
 } slab_cache_t;
@@ -131,6 +163,7 @@ extern void slab_enable_cpucache(void);
 
 /* kconsole debug */
 extern void slab_print_list(void);
+extern size_t slab_stats(stats_slab_t *, size_t);
 
 #endif
 
@@ -39,6 +39,8 @@
 #include <arch/mm/asid.h>
 #include <typedefs.h>
 
+struct as;
+
 /**
  * Number of TLB shootdown messages that can be queued in processor tlb_messages
  * queue.
@@ -70,12 +72,17 @@ extern void tlb_init(void);
 #ifdef CONFIG_SMP
 extern ipl_t tlb_shootdown_start(tlb_invalidate_type_t, asid_t, uintptr_t,
     size_t);
+extern ipl_t tlb_shootdown_start_as(struct as *, tlb_invalidate_type_t,
+    uintptr_t, size_t);
 extern void tlb_shootdown_finalize(ipl_t);
 extern void tlb_shootdown_ipi_recv(void);
+extern void tlb_shootdown_switch(struct as *, struct as *);
 #else
 #define tlb_shootdown_start(w, x, y, z)	interrupts_disable()
+#define tlb_shootdown_start_as(w, x, y, z)	interrupts_disable()
 #define tlb_shootdown_finalize(i)	(interrupts_restore(i));
 #define tlb_shootdown_ipi_recv()
+#define tlb_shootdown_switch(x, y)
 #endif /* CONFIG_SMP */
 
 /* Export TLB interface that each architecture must implement. */
@@ -57,9 +57,12 @@ extern void *program_loader;
 extern errno_t program_create(as_t *, uspace_addr_t, char *, program_t *);
 extern errno_t program_create_from_image(void *, char *, program_t *);
 extern errno_t program_create_loader(program_t *, char *);
+extern errno_t program_create_clone(uspace_arg_t *, char *, program_t *);
 extern void program_ready(program_t *);
 
 extern sys_errno_t sys_program_spawn_loader(uspace_ptr_char, size_t);
+extern sys_errno_t sys_program_clone(uspace_ptr_uspace_arg_t,
+    uspace_ptr_char, size_t, uspace_ptr_task_id_t);
 
 #endif
 
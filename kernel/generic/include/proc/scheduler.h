@@ -36,14 +36,42 @@
 #define KERN_SCHEDULER_H_
 
 #include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
 #include <synch/spinlock.h>
 #include <time/clock.h>
 #include <atomic.h>
 #include <adt/list.h>
 
 #define RQ_COUNT          16
+#define RQ_BIT(i)         (1U << (i))
 #define NEEDS_RELINK_MAX  (HZ)
 
+/** Run queue reserved for threads of the real-time FIFO class. */
+#define RQ_FIFO           0
+/** Highest-priority run queue of time-sharing threads. */
+#define RQ_TS_FIRST       1
+
+/**
+ * Number of run queues a time-sharing thread can wake up to, depending
+ * on how much it ran compared to how much it slept recently.
+ */
+#define RQ_WAKEUP_LEVELS  (RQ_COUNT / 2)
+
+/**
+ * Weight of the history in the running averages of the run and sleep
+ * times of a thread. A new sample contributes 1/SCHED_AVG_WEIGHT.
+ */
+#define SCHED_AVG_WEIGHT  4
+
+/** Default time quantum of a run queue in microseconds. */
+#define RQ_QUANTUM_DEFAULT(i)  ((((i) > 0) ? (i) : 1) * 10000)
+/** Minimum time quantum of a run queue in microseconds. */
+#define RQ_QUANTUM_MIN         1000
+
+/** Maximum number of busy CPUs probed by an idle CPU looking for work. */
+#define STEAL_ATTEMPTS_MAX  4
+
 /** Scheduler run queue structure. */
 typedef struct {
 	IRQ_SPINLOCK_DECLARE(lock);
@@ -53,6 +81,8 @@ typedef struct {
 
 extern atomic_size_t nrdy;
 extern void scheduler_init(void);
+extern errno_t scheduler_quantum_set(unsigned int, uint32_t);
+extern uint32_t scheduler_quantum_get(unsigned int);
 
 extern void scheduler_fpu_lazy_request(void);
 extern void scheduler(void);
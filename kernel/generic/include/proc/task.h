@@ -41,6 +41,7 @@
 #include <ipc/kbox.h>
 #include <synch/spinlock.h>
 #include <synch/mutex.h>
+#include <synch/rcu.h>
 #include <adt/list.h>
 #include <adt/odict.h>
 #include <security/perm.h>
@@ -54,6 +55,7 @@
 #include <udebug/udebug.h>
 #include <mm/as.h>
 #include <abi/proc/task.h>
+#include <abi/proc/thread.h>
 #include <abi/sysinfo.h>
 #include <arch.h>
 #include <cap/cap.h>
@@ -67,6 +69,10 @@ struct cap;
 typedef struct task {
 	/** Link to @c tasks ordered dictionary */
 	odlink_t ltasks;
+	/** Next task in the chain of the task hash, followed by RCU readers */
+	_Atomic(struct task *) hash_next;
+	/** Deferred freeing of the structure */
+	rcu_item_t rcu;
 
 	/** Task lock.
 	 *
@@ -93,6 +99,16 @@ typedef struct task {
 
 	/** Task permissions. */
 	perm_t perms;
+	/** Scheduling class of the task's userspace threads. */
+	sched_class_t sched_class;
+	/**
+	 * CPUs the task's userspace threads may run on, NULL if not
+	 * restricted. Points to affinity_buf when set, so that it can be
+	 * read without holding the task lock.
+	 */
+	_Atomic(struct cpu_mask *) affinity;
+	/** Buffer for the CPU set, allocated when it is first set. */
+	struct cpu_mask *affinity_buf;
 
 	/** Capabilities */
 	cap_info_t *cap_info;
@@ -116,6 +132,11 @@ typedef struct task {
 	/** IPC statistics */
 	stats_ipc_t ipc_info;
 
+#ifdef CONFIG_IPC_PROFILE
+	/** IPC and syscall profile, protected by lock */
+	stats_task_ipc_t ipc_profile;
+#endif
+
 #ifdef CONFIG_UDEBUG
 	/** Debugging stuff. */
 	udebug_task_t udebug;
@@ -144,6 +165,7 @@ extern void task_destroy(task_t *);
 extern void task_hold(task_t *);
 extern void task_release(task_t *);
 extern task_t *task_find_by_id(task_id_t);
+extern task_t *task_get_by_id(task_id_t);
 extern size_t task_count(void);
 extern task_t *task_first(void);
 extern task_t *task_next(task_t *);
@@ -174,6 +196,7 @@ extern sysarg_t sys_task_get_id(void);
 extern sys_errno_t sys_task_set_name(uspace_ptr_const_char, size_t);
 extern sys_errno_t sys_task_kill(uspace_ptr_task_id_t);
 extern sys_errno_t sys_task_exit(sysarg_t);
+extern sys_errno_t sys_task_set_sched_class(sysarg_t);
 
 #endif
 
@@ -67,6 +67,15 @@ typedef enum {
 	THREAD_FLAG_UNCOUNTED = (1 << 2)
 } thread_flags_t;
 
+/** Reason of a thread being blocked, for scheduling accounting. */
+typedef enum {
+	THREAD_BLOCK_OTHER = 0,
+	/** Waiting for an IPC call or answer */
+	THREAD_BLOCK_IPC,
+	/** Waiting on a userspace futex (syswaitq) */
+	THREAD_BLOCK_FUTEX
+} thread_block_t;
+
 /** Thread structure. There is one per thread. */
 typedef struct thread {
 	atomic_refcount_t refcount;
@@ -150,6 +159,8 @@ typedef struct thread {
 	task_t *task;
 	/** Thread is wired to CPU. */
 	bool wired;
+	/** CPUs the thread may run on, NULL to use the CPU set of the task */
+	struct cpu_mask *affinity;
 	/** Thread was migrated to another CPU and has not run yet. */
 	bool stolen;
 	/** Thread is executed in user space. */
@@ -163,8 +174,43 @@ typedef struct thread {
 	/** Thread doesn't affect accumulated accounting. */
 	bool uncounted;
 
+	/** Scheduling accounting (cycles). */
+	uint64_t rqcycles;      /**< Ready in a run queue */
+	uint64_t ipc_cycles;    /**< Blocked in IPC */
+	uint64_t futex_cycles;  /**< Blocked on a futex */
+	uint64_t sleep_cycles;  /**< Blocked for other reasons */
+	/** Cycle of the last transition to the Ready or Sleeping state. */
+	uint64_t state_cycle;
+	/** Number of voluntary context switches (thread went to sleep). */
+	uint64_t vcsw;
+	/** Number of involuntary context switches (thread was preempted). */
+	uint64_t ivcsw;
+	/**
+	 * Why the thread is going to block. Written only by the thread
+	 * itself before it goes to sleep.
+	 */
+	thread_block_t block_reason;
+	/** Statistics generation in which the thread last changed. */
+	size_t stats_gen;
+
+	/** Scheduling class of the thread. */
+	sched_class_t sched_class;
 	/** Thread's priority. Implemented as index to CPU->rq */
 	int priority;
+	/** Running average of the time run between two sleeps (cycles). */
+	uint64_t avg_run;
+	/** Running average of the time slept (cycles). */
+	uint64_t avg_sleep;
+	/** Value of ucycles + kcycles when the thread last went to sleep. */
+	uint64_t burst_start;
+	/**
+	 * Priority inherited from threads waiting for a mutex held by this
+	 * thread, RQ_COUNT if none. The thread is never queued with a lower
+	 * priority (i.e. a higher index) than this.
+	 */
+	int inherited_priority;
+	/** Thread is running on a processor. Read without locking. */
+	atomic_bool on_cpu;
 	/** Thread ID. */
 	thread_id_t tid;
 
@@ -197,6 +243,8 @@ extern void thread_attach(thread_t *, task_t *);
 extern void thread_ready(thread_t *);
 extern void thread_exit(void) __attribute__((noreturn));
 extern void thread_interrupt(thread_t *);
+extern void thread_priority_inherit(thread_t *, int);
+extern void thread_priority_restore(void);
 
 typedef enum {
 	THREAD_OK,
@@ -211,6 +259,7 @@ typedef enum {
 extern thread_termination_state_t thread_wait_start(void);
 extern thread_wait_result_t thread_wait_finish(deadline_t);
 extern void thread_wakeup(thread_t *);
+extern void thread_wakeup_handoff(thread_t *);
 
 static inline thread_t *thread_ref(thread_t *thread)
 {
@@ -70,6 +70,12 @@
  */
 #define PERM_IRQ_REG     (1 << 3)
 
+/**
+ * PERM_SCHED allows its holder to run threads in the real-time scheduling
+ * class.
+ */
+#define PERM_SCHED       (1 << 4)
+
 typedef uint32_t perm_t;
 
 #ifdef __32_BITS__
@@ -37,12 +37,17 @@
 
 #ifdef CONFIG_SMP
 
+struct cpu;
+
 extern void ipi_broadcast(int);
 extern void ipi_broadcast_arch(int);
+extern void ipi_send(struct cpu *, int);
+extern void ipi_send_arch(struct cpu *, int);
 
 #else
 
 #define ipi_broadcast(ipi)
+#define ipi_send(cpu, ipi)
 
 #endif /* CONFIG_SMP */
 
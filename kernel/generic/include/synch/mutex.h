@@ -51,8 +51,13 @@ struct thread;
 typedef struct {
 	mutex_type_t type;
 	semaphore_t sem;
-	struct thread *owner;
+	/** Owner, read without locking by the threads waiting for the mutex */
+	_Atomic(struct thread *) owner;
 	unsigned nesting;
+#ifdef CONFIG_LOCKSTAT
+	/** Cycle count when the mutex was acquired */
+	uint64_t lockstat_since;
+#endif
 } mutex_t;
 
 extern void mutex_initialize(mutex_t *, mutex_type_t);
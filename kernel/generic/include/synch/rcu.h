@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_sync
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_RCU_H_
+#define KERN_RCU_H_
+
+#include <adt/list.h>
+#include <preemption.h>
+#include <stdatomic.h>
+
+struct cpu;
+struct rcu_item;
+
+typedef void (*rcu_func_t)(struct rcu_item *);
+
+/** Callback waiting for the end of a grace period. */
+typedef struct rcu_item {
+	link_t link;
+	rcu_func_t func;
+} rcu_item_t;
+
+/** Publish a pointer to an initialized object for RCU readers.
+ *
+ * @a ptr must be an _Atomic pointer, updaters serialize among themselves.
+ */
+#define rcu_assign(ptr, value) \
+	atomic_store_explicit(&(ptr), (value), memory_order_release)
+
+/** Load a pointer published by rcu_assign() in a read-side section. */
+#define rcu_access(ptr) \
+	atomic_load_explicit(&(ptr), memory_order_acquire)
+
+/** Enter an RCU read-side critical section.
+ *
+ * Read-side sections may nest and must not sleep. Any section of code
+ * running with preemption disabled, including code holding a spinlock,
+ * is a read-side section as well.
+ */
+static inline void rcu_read_lock(void)
+{
+	preemption_disable();
+}
+
+/** Leave an RCU read-side critical section. */
+static inline void rcu_read_unlock(void)
+{
+	preemption_enable();
+}
+
+extern void rcu_init(void);
+extern void rcu_quiescent(void);
+extern void call_rcu(rcu_item_t *, rcu_func_t);
+extern void rcu_synchronize(void);
+extern void krcu(void *);
+
+#endif
+
+/** @}
+ */
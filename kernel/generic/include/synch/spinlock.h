@@ -38,6 +38,7 @@
 
 #include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <arch/types.h>
 #include <assert.h>
@@ -66,13 +67,22 @@
 
 #endif /* CONFIG_DEBUG_SPINLOCK */
 
+struct lockstat_class;
+
 typedef struct spinlock {
 #ifdef CONFIG_SMP
 	atomic_flag flag;
 
-#ifdef CONFIG_DEBUG_SPINLOCK
+#if defined(CONFIG_DEBUG_SPINLOCK) || defined(CONFIG_LOCKSTAT)
 	const char *name;
-#endif /* CONFIG_DEBUG_SPINLOCK */
+#endif
+
+#ifdef CONFIG_LOCKSTAT
+	/** Lock class, looked up on first acquisition */
+	_Atomic(struct lockstat_class *) lockstat;
+	/** Cycle count when the lock was acquired */
+	uint64_t lockstat_since;
+#endif /* CONFIG_LOCKSTAT */
 #endif
 } spinlock_t;
 
@@ -84,7 +94,7 @@ typedef struct spinlock {
 #define SPINLOCK_EXTERN(lock_name)   extern spinlock_t lock_name
 
 #ifdef CONFIG_SMP
-#ifdef CONFIG_DEBUG_SPINLOCK
+#if defined(CONFIG_DEBUG_SPINLOCK) || defined(CONFIG_LOCKSTAT)
 #define SPINLOCK_INITIALIZER(desc_name) { .name = (desc_name), .flag = ATOMIC_FLAG_INIT }
 #else
 #define SPINLOCK_INITIALIZER(desc_name) { .flag = ATOMIC_FLAG_INIT }
@@ -60,6 +60,11 @@ typedef struct waitq {
 	list_t sleepers;
 
 	bool closed;
+
+#ifdef CONFIG_LOCKSTAT
+	/** Lock class the sleeps are accounted to, may be NULL. */
+	struct lockstat_class *lockstat;
+#endif
 } waitq_t;
 
 typedef struct wait_guard {
@@ -67,6 +72,7 @@ typedef struct wait_guard {
 } wait_guard_t;
 
 struct thread;
+struct lockstat_class;
 
 extern void waitq_initialize(waitq_t *);
 extern void waitq_initialize_with_count(waitq_t *, int);
@@ -78,6 +84,7 @@ extern errno_t waitq_sleep_unsafe(waitq_t *, wait_guard_t);
 extern errno_t waitq_sleep_timeout_unsafe(waitq_t *, uint32_t, unsigned int, wait_guard_t);
 
 extern void waitq_wake_one(waitq_t *);
+extern void waitq_wake_one_handoff(waitq_t *);
 extern void waitq_wake_all(waitq_t *);
 extern void waitq_signal(waitq_t *);
 extern void waitq_close(waitq_t *);
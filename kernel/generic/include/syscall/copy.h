@@ -43,8 +43,20 @@ extern char memcpy_from_uspace_failover_address;
 /** Label within memcpy_to_uspace() that contains return -1. */
 extern char memcpy_to_uspace_failover_address;
 
+/** Block of data to be copied between kernel and userspace. */
+typedef struct {
+	/** Kernel buffer. */
+	void *kernel;
+	/** Userspace buffer. */
+	uspace_addr_t uspace;
+	/** Size of both buffers. */
+	size_t size;
+} copy_iovec_t;
+
 extern errno_t copy_from_uspace(void *dst, uspace_addr_t uspace_src, size_t size);
 extern errno_t copy_to_uspace(uspace_addr_t dst_uspace, const void *src, size_t size);
+extern errno_t copy_from_uspace_vec(const copy_iovec_t *, size_t);
+extern errno_t copy_to_uspace_vec(const copy_iovec_t *, size_t);
 
 /*
  * This interface must be implemented by each architecture.
@@ -35,8 +35,23 @@
 #ifndef KERN_STATS_H_
 #define KERN_STATS_H_
 
+#include <atomic.h>
+#include <stddef.h>
+
+/** Current thread statistics generation */
+extern atomic_size_t stats_generation;
+
+/** Generation in which a thread was last removed */
+extern atomic_size_t stats_removed_generation;
+
+/** Get the current thread statistics generation */
+#define STATS_GENERATION() \
+	atomic_load_explicit(&stats_generation, memory_order_relaxed)
+
 extern void kload(void *arg);
 extern void stats_init(void);
+extern void stats_page_set_tasks(size_t);
+extern void stats_page_set_threads(size_t);
 
 #endif
 
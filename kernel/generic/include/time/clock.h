@@ -48,8 +48,41 @@ typedef struct {
 
 extern uptime_t *uptime;
 
+struct cpu;
+
+/** Operations of a clock source able to stop the periodic tick
+ *
+ * All operations are called on the processor whose tick is being
+ * manipulated, with interrupts disabled.
+ *
+ */
+typedef struct {
+	/** Maximum number of ticks the periodic tick can be stopped for */
+	uint64_t max_ticks;
+
+	/** Stop the periodic tick and interrupt after the given number of ticks. */
+	void (*stop)(uint64_t);
+
+	/**
+	 * Restart the periodic tick stopped for the given number of ticks.
+	 *
+	 * Return the number of ticks that elapsed while the tick was stopped,
+	 * not counting the tick of a clock interrupt which is already being
+	 * (or is about to be) delivered.
+	 */
+	uint64_t (*restart)(uint64_t);
+
+	/** Wake up an idle processor with a stopped tick. */
+	void (*wakeup)(struct cpu *);
+} clock_tick_ops_t;
+
+extern clock_tick_ops_t *clock_tick_ops;
+
 extern void clock(void);
 extern void clock_counter_init(void);
+extern void clock_tick_stop(void);
+extern void clock_tick_restart(void);
+extern void clock_tick_kick(struct cpu *);
 
 #endif
 
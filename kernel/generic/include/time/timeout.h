@@ -36,6 +36,7 @@
 #define KERN_TIMEOUT_H_
 
 #include <adt/list.h>
+#include <adt/twheel.h>
 #include <cpu.h>
 #include <stdint.h>
 
@@ -45,9 +46,9 @@ typedef uint64_t deadline_t;
 #define DEADLINE_NEVER ((deadline_t) UINT64_MAX)
 
 typedef struct {
-	/** Link to the list of active timeouts on timeout->cpu */
-	link_t link;
-	/** Timeout will be activated when current clock tick reaches this value. */
+	/** Timer on the timeout wheel of timeout->cpu */
+	twheel_timer_t timer;
+	/** Timeout will be activated in the first clock tick past this. */
 	deadline_t deadline;
 	/** Function that will be called on timeout activation. */
 	timeout_handler_t handler;
@@ -64,6 +65,8 @@ typedef struct {
 extern deadline_t timeout_deadline_in_usec(uint32_t us);
 
 extern void timeout_init(void);
+extern deadline_t timeout_next_deadline(void);
+extern void timeout_expire(uint64_t);
 extern void timeout_initialize(timeout_t *);
 extern void timeout_register(timeout_t *, uint64_t, timeout_handler_t, void *);
 extern void timeout_register_deadline(timeout_t *, deadline_t, timeout_handler_t, void *);
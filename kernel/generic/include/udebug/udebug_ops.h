@@ -36,6 +36,7 @@
 #define KERN_UDEBUG_OPS_H_
 
 #include <ipc/ipc.h>
+#include <mm/as.h>
 #include <proc/thread.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -55,6 +56,8 @@ errno_t udebug_args_read(thread_t *t, void **buffer);
 errno_t udebug_regs_read(thread_t *t, void **buffer);
 
 errno_t udebug_mem_read(uspace_addr_t uspace_addr, size_t n, void **buffer);
+errno_t udebug_mem_snapshot(uspace_addr_t uspace_addr, size_t n, as_t *dst_as,
+    uintptr_t bound, uintptr_t *dst_base);
 
 #endif
 
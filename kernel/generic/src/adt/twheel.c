@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic_adt
+ * @{
+ */
+/**
+ * @file
+ * @brief Hierarchical timer wheel.
+ *
+ * This is the kernel counterpart of the libc timer wheel. Times are kept
+ * in clock ticks, so there is no rounding and timers expiring in the same
+ * tick are kept in the order in which they were inserted.
+ */
+
+#include <adt/list.h>
+#include <adt/twheel.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Number of tick bits below the given level. */
+static unsigned int twheel_shift(unsigned int level)
+{
+	if (level == 0)
+		return 0;
+
+	return TWHEEL_ROOT_BITS + (level - 1) * TWHEEL_LEVEL_BITS;
+}
+
+/** Number of slots of the given level. */
+static uint64_t twheel_nslots(unsigned int level)
+{
+	return (level == 0) ? TWHEEL_ROOT_SLOTS : TWHEEL_LEVEL_SLOTS;
+}
+
+/** Slot of the given level covering the given tick. */
+static list_t *twheel_slot(twheel_t *wheel, unsigned int level, uint64_t tick)
+{
+	if (level == 0)
+		return &wheel->root[tick & (TWHEEL_ROOT_SLOTS - 1)];
+
+	return &wheel->slots[level - 1][(tick >> twheel_shift(level)) &
+	    (TWHEEL_LEVEL_SLOTS - 1)];
+}
+
+/** Put a timer into the slot matching its expiration tick. */
+static void twheel_place(twheel_t *wheel, twheel_timer_t *timer)
+{
+	uint64_t tick = timer->expires;
+	if (tick <= wheel->now)
+		tick = wheel->now + 1;
+
+	unsigned int level;
+	for (level = 0; level < TWHEEL_LEVELS; level++) {
+		unsigned int shift = twheel_shift(level);
+		if ((tick >> shift) - (wheel->now >> shift) < twheel_nslots(level))
+			break;
+	}
+
+	if (level == TWHEEL_LEVELS) {
+		/* Too far away, park it in the last slot of the last level. */
+		level = TWHEEL_LEVELS - 1;
+		unsigned int shift = twheel_shift(level);
+		tick = ((wheel->now >> shift) + twheel_nslots(level) - 1) << shift;
+	}
+
+	timer->level = level;
+	wheel->count[level]++;
+	list_append(&timer->link, twheel_slot(wheel, level, tick));
+}
+
+/** Move the timers of the current slot of a level to lower levels.
+ *
+ * @param wheel   Timer wheel.
+ * @param level   Level to cascade, must be greater than zero.
+ * @param expired List to which timers that already expired are appended.
+ */
+static void twheel_cascade(twheel_t *wheel, unsigned int level,
+    list_t *expired)
+{
+	list_t *slot = twheel_slot(wheel, level, wheel->now);
+
+	while (!list_empty(slot)) {
+		twheel_timer_t *timer = list_get_instance(list_first(slot),
+		    twheel_timer_t, link);
+		list_remove(&timer->link);
+		wheel->count[level]--;
+
+		if (timer->expires <= wheel->now) {
+			timer->level = TWHEEL_LEVELS;
+			list_append(&timer->link, expired);
+		} else {
+			twheel_place(wheel, timer);
+		}
+	}
+}
+
+/** Initialize a timer wheel.
+ *
+ * @param wheel Timer wheel.
+ * @param now   Current tick.
+ */
+void twheel_initialize(twheel_t *wheel, uint64_t now)
+{
+	wheel->now = now;
+
+	for (unsigned int level = 0; level < TWHEEL_LEVELS; level++)
+		wheel->count[level] = 0;
+
+	for (unsigned int i = 0; i < TWHEEL_ROOT_SLOTS; i++)
+		list_initialize(&wheel->root[i]);
+
+	for (unsigned int level = 0; level < TWHEEL_LEVELS - 1; level++) {
+		for (unsigned int i = 0; i < TWHEEL_LEVEL_SLOTS; i++)
+			list_initialize(&wheel->slots[level][i]);
+	}
+}
+
+/** Restart an empty timer wheel at the given tick.
+ *
+ * The wheel does not advance while it is empty, so restarting it before
+ * inserting a timer keeps timers on the lowest levels possible.
+ *
+ * @param wheel Timer wheel, must be empty.
+ * @param now   Current tick.
+ */
+void twheel_restart(twheel_t *wheel, uint64_t now)
+{
+	assert(twheel_empty(wheel));
+
+	if (now > wheel->now)
+		wheel->now = now;
+}
+
+/** Check whether there are no timers on a wheel.
+ *
+ * @param wheel Timer wheel.
+ * @return True if there are no timers on the wheel.
+ */
+bool twheel_empty(twheel_t *wheel)
+{
+	for (unsigned int level = 0; level < TWHEEL_LEVELS; level++) {
+		if (wheel->count[level] > 0)
+			return false;
+	}
+
+	return true;
+}
+
+/** Insert a timer into a timer wheel.
+ *
+ * A timer expiring in a tick that was already processed expires in the
+ * next one.
+ *
+ * @param wheel   Timer wheel.
+ * @param timer   Timer, not on any wheel.
+ * @param expires Tick in which the timer expires.
+ */
+void twheel_insert(twheel_t *wheel, twheel_timer_t *timer, uint64_t expires)
+{
+	timer->expires = expires;
+	twheel_place(wheel, timer);
+}
+
+/** Remove a timer from a timer wheel.
+ *
+ * A timer that is not on the wheel is left alone. A timer that expired
+ * is removed from the list of expired timers it was put on.
+ *
+ * @param wheel Timer wheel.
+ * @param timer Timer.
+ */
+void twheel_remove(twheel_t *wheel, twheel_timer_t *timer)
+{
+	if (!link_in_use(&timer->link))
+		return;
+
+	list_remove(&timer->link);
+
+	if (timer->level < TWHEEL_LEVELS)
+		wheel->count[timer->level]--;
+}
+
+/** Advance a timer wheel and collect its expired timers.
+ *
+ * All ticks up to @a now are processed in one go, skipping the ticks
+ * in which nothing can happen.
+ *
+ * @param wheel   Timer wheel.
+ * @param now     Current tick.
+ * @param expired List to which the expired timers are appended, in the
+ *                order in which they expired.
+ */
+void twheel_advance(twheel_t *wheel, uint64_t now, list_t *expired)
+{
+	while (wheel->now < now) {
+		unsigned int level = 0;
+		while (level < TWHEEL_LEVELS && wheel->count[level] == 0)
+			level++;
+
+		if (level == TWHEEL_LEVELS) {
+			wheel->now = now;
+			return;
+		}
+
+		unsigned int shift = twheel_shift(level);
+		uint64_t next = ((wheel->now >> shift) + 1) << shift;
+		if (next > now) {
+			wheel->now = now;
+			return;
+		}
+
+		wheel->now = next;
+
+		for (level = 1; level < TWHEEL_LEVELS; level++) {
+			uint64_t mask = ((uint64_t) 1 << twheel_shift(level)) - 1;
+			if ((wheel->now & mask) != 0)
+				break;
+
+			twheel_cascade(wheel, level, expired);
+		}
+
+		list_t *slot = twheel_slot(wheel, 0, wheel->now);
+		while (!list_empty(slot)) {
+			twheel_timer_t *timer = list_get_instance(list_first(slot),
+			    twheel_timer_t, link);
+			list_remove(&timer->link);
+			wheel->count[0]--;
+
+			timer->level = TWHEEL_LEVELS;
+			list_append(&timer->link, expired);
+		}
+	}
+}
+
+/** Find the tick of the next event on a timer wheel.
+ *
+ * The returned tick is a lower bound of the tick the next timer expires
+ * in. Calling twheel_advance() in that tick either expires timers or
+ * moves them closer to expiration.
+ *
+ * @param wheel Timer wheel.
+ * @param next  Place to store the tick of the next event.
+ * @return False if there are no timers on the wheel.
+ */
+bool twheel_next(twheel_t *wheel, uint64_t *next)
+{
+	uint64_t tick = UINT64_MAX;
+
+	for (unsigned int level = 1; level < TWHEEL_LEVELS; level++) {
+		if (wheel->count[level] > 0) {
+			unsigned int shift = twheel_shift(level);
+			tick = ((wheel->now >> shift) + 1) << shift;
+			break;
+		}
+	}
+
+	if (wheel->count[0] > 0) {
+		for (uint64_t t = wheel->now + 1; t < tick &&
+		    t <= wheel->now + TWHEEL_ROOT_SLOTS; t++) {
+			if (!list_empty(twheel_slot(wheel, 0, t))) {
+				tick = t;
+				break;
+			}
+		}
+	}
+
+	if (tick == UINT64_MAX)
+		return false;
+
+	*next = tick;
+	return true;
+}
+
+/** @}
+ */
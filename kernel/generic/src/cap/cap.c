@@ -73,6 +73,15 @@
  * kobject_get() or kobject_add_ref(). When the kernel object is removed from
  * the container, the reference count should go down via a call to
  * kobject_put().
+ *
+ * Capabilities of a task are kept in a flat table indexed by the capability
+ * handle. The table and the capabilities are modified under the task's
+ * cap_info_t lock, but kobject_get(), which is called on every IPC syscall,
+ * reads the published kernel object from the table in an RCU read-side
+ * section without taking any lock. It only takes a reference to a kernel
+ * object whose reference count has not dropped to zero yet. Replaced tables
+ * and kobject_t structures are freed after a grace period, so the reader
+ * never touches freed memory.
  */
 
 #include <cap/cap.h>
@@ -82,6 +91,10 @@
 #include <abi/errno.h>
 #include <mm/slab.h>
 #include <adt/list.h>
+#include <arch/asm.h>
+#include <atomic.h>
+#include <member.h>
+#include <synch/rcu.h>
 #include <synch/syswaitq.h>
 #include <ipc/ipcrsc.h>
 #include <ipc/ipc.h>
@@ -95,6 +108,11 @@
 #define CAPS_SIZE	(INT_MAX - (int) CAPS_START)
 #define CAPS_LAST	(CAPS_SIZE - 1)
 
+/** Initial size of the capability table (bytes) */
+#define CAPS_TABLE_INITIAL	1024
+/** Maximum size of the capability table, the largest block malloc() gives */
+#define CAPS_TABLE_MAX		(1 << 22)
+
 static slab_cache_t *cap_cache;
 static slab_cache_t *kobject_cache;
 
@@ -105,31 +123,39 @@ kobject_ops_t *kobject_ops[KOBJECT_TYPE_MAX] = {
 	[KOBJECT_TYPE_WAITQ] = &waitq_kobject_ops
 };
 
-static size_t caps_hash(const ht_link_t *item)
+/** Allocate an empty capability table
+ *
+ * @param bytes  Size of the table including its header. The number of slots
+ *               is whatever fits.
+ *
+ * @return New table or NULL if there is not enough memory.
+ */
+static cap_table_t *cap_table_alloc(size_t bytes)
 {
-	cap_t *cap = hash_table_get_inst(item, cap_t, caps_link);
-	return hash_mix(cap_handle_raw(cap->handle));
+	cap_table_t *table = malloc(bytes);
+	if (!table)
+		return NULL;
+
+	size_t size = (bytes - sizeof(cap_table_t)) / sizeof(cap_slot_t);
+	table->size = size;
+	for (size_t i = 0; i < size; i++) {
+		table->slots[i].cap = NULL;
+		atomic_init(&table->slots[i].kobject, NULL);
+	}
+
+	return table;
 }
 
-static size_t caps_key_hash(const void *key)
+static void cap_table_free_rcu(rcu_item_t *item)
 {
-	const cap_handle_t *handle = key;
-	return hash_mix(cap_handle_raw(*handle));
+	free(member_to_inst(item, cap_table_t, rcu));
 }
 
-static bool caps_key_equal(const void *key, const ht_link_t *item)
+static void kobject_free_rcu(rcu_item_t *item)
 {
-	const cap_handle_t *handle = key;
-	cap_t *cap = hash_table_get_inst(item, cap_t, caps_link);
-	return *handle == cap->handle;
+	kobject_free(member_to_inst(item, kobject_t, rcu));
 }
 
-static const hash_table_ops_t caps_ops = {
-	.hash = caps_hash,
-	.key_hash = caps_key_hash,
-	.key_equal = caps_key_equal
-};
-
 void caps_init(void)
 {
 	cap_cache = slab_cache_create("cap_t", sizeof(cap_t), 0, NULL,
@@ -152,8 +178,10 @@ errno_t caps_task_alloc(task_t *task)
 		goto error_handles;
 	if (!ra_span_add(task->cap_info->handles, CAPS_START, CAPS_SIZE))
 		goto error_span;
-	if (!hash_table_create(&task->cap_info->caps, 0, 0, &caps_ops))
+	cap_table_t *table = cap_table_alloc(CAPS_TABLE_INITIAL);
+	if (!table)
 		goto error_span;
+	atomic_init(&task->cap_info->table, table);
 	return EOK;
 
 error_span:
@@ -181,7 +209,7 @@ void caps_task_init(task_t *task)
  */
 void caps_task_free(task_t *task)
 {
-	hash_table_destroy(&task->cap_info->caps);
+	free(atomic_load(&task->cap_info->table));
 	ra_arena_destroy(task->cap_info->handles);
 	free(task->cap_info);
 }
@@ -242,27 +270,64 @@ static cap_t *cap_get(task_t *task, cap_handle_t handle, cap_state_t state)
 {
 	assert(mutex_locked(&task->cap_info->lock));
 
+	cap_table_t *table = atomic_load_explicit(&task->cap_info->table,
+	    memory_order_relaxed);
+
 	if ((cap_handle_raw(handle) < CAPS_START) ||
-	    (cap_handle_raw(handle) > CAPS_LAST))
-		return NULL;
-	ht_link_t *link = hash_table_find(&task->cap_info->caps, &handle);
-	if (!link)
+	    ((size_t) cap_handle_raw(handle) >= table->size))
 		return NULL;
-	cap_t *cap = hash_table_get_inst(link, cap_t, caps_link);
-	if (cap->state != state)
+	cap_t *cap = table->slots[cap_handle_raw(handle)].cap;
+	if ((!cap) || (cap->state != state))
 		return NULL;
 	return cap;
 }
 
-/** Allocate new capability
- *
- * @param task  Task for which to allocate the new capability.
+/** Make sure the capability table has a slot for a handle
  *
- * @param[out] handle  New capability handle on success.
+ * @param info    Capability info structure. Its lock must be held.
+ * @param handle  Capability handle.
  *
- * @return An error code in case of error.
+ * @return Capability table with a slot for the handle.
+ * @return NULL if there is not enough memory to grow the table.
  */
-errno_t cap_alloc(task_t *task, cap_handle_t *handle)
+static cap_table_t *cap_table_reserve(cap_info_t *info, cap_handle_t handle)
+{
+	cap_table_t *table = atomic_load_explicit(&info->table,
+	    memory_order_relaxed);
+	size_t index = (size_t) cap_handle_raw(handle);
+
+	if (index < table->size)
+		return table;
+
+	/* Keep the table size a power of two to avoid wasting memory */
+	size_t bytes = CAPS_TABLE_INITIAL;
+	while ((bytes - sizeof(cap_table_t)) / sizeof(cap_slot_t) <= index) {
+		bytes *= 2;
+		if (bytes > CAPS_TABLE_MAX)
+			return NULL;
+	}
+
+	cap_table_t *grown = cap_table_alloc(bytes);
+	if (!grown)
+		return NULL;
+
+	for (size_t i = 0; i < table->size; i++) {
+		grown->slots[i].cap = table->slots[i].cap;
+		atomic_init(&grown->slots[i].kobject,
+		    atomic_load_explicit(&table->slots[i].kobject,
+		    memory_order_relaxed));
+	}
+
+	rcu_assign(info->table, grown);
+
+	/* The old table must not be freed under the feet of its readers */
+	call_rcu(&table->rcu, cap_table_free_rcu);
+
+	return grown;
+}
+
+static errno_t cap_alloc_internal(task_t *task, cap_handle_t *handle,
+    bool fixed)
 {
 	mutex_lock(&task->cap_info->lock);
 	cap_t *cap = slab_alloc(cap_cache, FRAME_ATOMIC);
@@ -270,14 +335,28 @@ errno_t cap_alloc(task_t *task, cap_handle_t *handle)
 		mutex_unlock(&task->cap_info->lock);
 		return ENOMEM;
 	}
-	uintptr_t hbase;
-	if (!ra_alloc(task->cap_info->handles, 1, 1, &hbase)) {
+	uintptr_t hbase = cap_handle_raw(*handle);
+	if (fixed) {
+		if (!ra_alloc_at(task->cap_info->handles, hbase, 1)) {
+			slab_free(cap_cache, cap);
+			mutex_unlock(&task->cap_info->lock);
+			return EEXIST;
+		}
+	} else if (!ra_alloc(task->cap_info->handles, 1, 1, &hbase)) {
+		slab_free(cap_cache, cap);
+		mutex_unlock(&task->cap_info->lock);
+		return ENOMEM;
+	}
+	cap_table_t *table = cap_table_reserve(task->cap_info,
+	    (cap_handle_t) hbase);
+	if (!table) {
+		ra_free(task->cap_info->handles, hbase, 1);
 		slab_free(cap_cache, cap);
 		mutex_unlock(&task->cap_info->lock);
 		return ENOMEM;
 	}
 	cap_initialize(cap, task, (cap_handle_t) hbase);
-	hash_table_insert(&task->cap_info->caps, &cap->caps_link);
+	table->slots[hbase].cap = cap;
 
 	cap->state = CAP_STATE_ALLOCATED;
 	*handle = cap->handle;
@@ -286,6 +365,36 @@ errno_t cap_alloc(task_t *task, cap_handle_t *handle)
 	return EOK;
 }
 
+/** Allocate new capability
+ *
+ * @param task  Task for which to allocate the new capability.
+ *
+ * @param[out] handle  New capability handle on success.
+ *
+ * @return An error code in case of error.
+ */
+errno_t cap_alloc(task_t *task, cap_handle_t *handle)
+{
+	*handle = CAP_NIL;
+	return cap_alloc_internal(task, handle, false);
+}
+
+/** Allocate new capability with a given handle
+ *
+ * This is used to give a clone of a task the same handles as the original
+ * task had.
+ *
+ * @param task    Task for which to allocate the new capability.
+ * @param handle  Requested capability handle.
+ *
+ * @return EEXIST if the handle is already in use, ENOMEM if there is not
+ *         enough memory, EOK otherwise.
+ */
+errno_t cap_alloc_at(task_t *task, cap_handle_t handle)
+{
+	return cap_alloc_internal(task, &handle, true);
+}
+
 /** Publish allocated capability
  *
  * The kernel object is moved into the capability. In other words, its reference
@@ -308,12 +417,21 @@ cap_publish(task_t *task, cap_handle_t handle, kobject_t *kobj)
 	cap->kobject = kobj;
 	list_append(&cap->kobj_link, &kobj->caps_list);
 	list_append(&cap->type_link, &task->cap_info->type_list[kobj->type]);
+	cap_table_t *table = atomic_load_explicit(&task->cap_info->table,
+	    memory_order_relaxed);
+	atomic_store_explicit(&table->slots[cap_handle_raw(handle)].kobject,
+	    kobj, memory_order_release);
 	mutex_unlock(&task->cap_info->lock);
 	mutex_unlock(&kobj->caps_list_lock);
 }
 
 static void cap_unpublish_unsafe(cap_t *cap)
 {
+	cap_table_t *table = atomic_load_explicit(&cap->task->cap_info->table,
+	    memory_order_relaxed);
+	atomic_store_explicit(&table->slots[cap_handle_raw(cap->handle)].kobject,
+	    NULL, memory_order_relaxed);
+
 	cap->kobject = NULL;
 	list_remove(&cap->kobj_link);
 	list_remove(&cap->type_link);
@@ -379,7 +497,10 @@ void cap_revoke(kobject_t *kobj)
 		cap_t *cap = list_get_instance(cur, cap_t, kobj_link);
 		mutex_lock(&cap->task->cap_info->lock);
 		cap_unpublish_unsafe(cap);
-		/* Drop the reference for the unpublished capability */
+		/*
+		 * Drop the reference for the unpublished capability, the
+		 * caller's reference keeps the kobject alive.
+		 */
 		kobject_put(kobj);
 		mutex_unlock(&cap->task->cap_info->lock);
 	}
@@ -401,7 +522,9 @@ void cap_free(task_t *task, cap_handle_t handle)
 
 	assert(cap);
 
-	hash_table_remove_item(&task->cap_info->caps, &cap->caps_link);
+	cap_table_t *table = atomic_load_explicit(&task->cap_info->table,
+	    memory_order_relaxed);
+	table->slots[cap_handle_raw(handle)].cap = NULL;
 	ra_free(task->cap_info->handles, cap_handle_raw(handle), 1);
 	slab_free(cap_cache, cap);
 	mutex_unlock(&task->cap_info->lock);
@@ -447,17 +570,38 @@ void kobject_initialize(kobject_t *kobj, kobject_type_t type, void *raw)
 kobject_t *
 kobject_get(struct task *task, cap_handle_t handle, kobject_type_t type)
 {
+	cap_info_t *info = task->cap_info;
 	kobject_t *kobj = NULL;
 
-	mutex_lock(&task->cap_info->lock);
-	cap_t *cap = cap_get(task, handle, CAP_STATE_PUBLISHED);
-	if (cap) {
-		if (cap->kobject->type == type) {
-			kobj = cap->kobject;
-			atomic_inc(&kobj->refcnt);
+	if (cap_handle_raw(handle) < CAPS_START)
+		return NULL;
+
+	rcu_read_lock();
+
+	cap_table_t *table = rcu_access(info->table);
+	if ((size_t) cap_handle_raw(handle) < table->size) {
+		kobj = rcu_access(table->slots[cap_handle_raw(handle)].kobject);
+		if ((kobj) && (kobj->type == type)) {
+			/*
+			 * The capability may have been unpublished and the
+			 * last reference dropped in the meantime.
+			 */
+			size_t refcnt = atomic_load_explicit(&kobj->refcnt,
+			    memory_order_relaxed);
+			do {
+				if (refcnt == 0) {
+					kobj = NULL;
+					break;
+				}
+			} while (!atomic_compare_exchange_weak_explicit(
+			    &kobj->refcnt, &refcnt, refcnt + 1,
+			    memory_order_acquire, memory_order_relaxed));
+		} else {
+			kobj = NULL;
 		}
 	}
-	mutex_unlock(&task->cap_info->lock);
+
+	rcu_read_unlock();
 
 	return kobj;
 }
@@ -482,7 +626,7 @@ void kobject_put(kobject_t *kobj)
 {
 	if (atomic_postdec(&kobj->refcnt) == 1) {
 		KOBJECT_OP(kobj)->destroy(kobj->raw);
-		kobject_free(kobj);
+		call_rcu(&kobj->rcu, kobject_free_rcu);
 	}
 }
 
@@ -68,6 +68,7 @@
 #include <ipc/irq.h>
 #include <ipc/event.h>
 #include <sysinfo/sysinfo.h>
+#include <synch/lockstat.h>
 #include <symtab.h>
 #include <errno.h>
 #include <stdlib.h>
@@ -495,6 +496,25 @@ static cmd_info_t sched_info = {
 	.argc = 0
 };
 
+/* Data and methods for 'quantum' command */
+static int cmd_quantum(cmd_arg_t *argv);
+static cmd_arg_t quantum_argv[] = {
+	{
+		.type = ARG_TYPE_INT
+	},
+	{
+		.type = ARG_TYPE_INT
+	}
+};
+
+static cmd_info_t quantum_info = {
+	.name = "quantum",
+	.description = "<rq> <usec> Set the time quantum of a run queue.",
+	.func = cmd_quantum,
+	.argc = 2,
+	.argv = quantum_argv
+};
+
 static int cmd_caches(cmd_arg_t *argv);
 static cmd_info_t caches_info = {
 	.name = "caches",
@@ -503,6 +523,25 @@ static cmd_info_t caches_info = {
 	.argc = 0
 };
 
+#ifdef CONFIG_LOCKSTAT
+
+/* Data and methods for 'locks' command */
+static int cmd_locks(cmd_arg_t *argv);
+static cmd_arg_t locks_argv = {
+	.type = ARG_TYPE_STRING_OPTIONAL,
+	.buffer = flag_buf,
+	.len = sizeof(flag_buf)
+};
+static cmd_info_t locks_info = {
+	.name = "locks",
+	.description = "List lock contention statistics (use -r to reset them).",
+	.func = cmd_locks,
+	.argc = 1,
+	.argv = &locks_argv
+};
+
+#endif /* CONFIG_LOCKSTAT */
+
 static int cmd_sysinfo(cmd_arg_t *argv);
 static cmd_info_t sysinfo_info = {
 	.name = "sysinfo",
@@ -597,6 +636,7 @@ static cmd_info_t *basic_commands[] = {
 	&ipc_info,
 	&kill_info,
 	&physmem_info,
+	&quantum_info,
 	&reboot_info,
 	&sched_info,
 	&set4_info,
@@ -615,6 +655,9 @@ static cmd_info_t *basic_commands[] = {
 #endif
 #ifdef CONFIG_UDEBUG
 	&btrace_info,
+#endif
+#ifdef CONFIG_LOCKSTAT
+	&locks_info,
 #endif
 	&pio_read_8_info,
 	&pio_read_16_info,
@@ -1203,6 +1246,28 @@ int cmd_caches(cmd_arg_t *argv)
 	return 1;
 }
 
+#ifdef CONFIG_LOCKSTAT
+
+/** Command for listing lock contention statistics
+ *
+ * @param argv Ignored
+ *
+ * @return Always 1
+ */
+int cmd_locks(cmd_arg_t *argv)
+{
+	if (str_cmp(flag_buf, "-r") == 0)
+		lockstat_reset();
+	else if (str_cmp(flag_buf, "") == 0)
+		lockstat_print_list();
+	else
+		printf("Unknown argument \"%s\".\n", flag_buf);
+
+	return 1;
+}
+
+#endif /* CONFIG_LOCKSTAT */
+
 /** Command for dumping sysinfo
  *
  * @param argv Ignores
@@ -1280,6 +1345,24 @@ int cmd_sched(cmd_arg_t *argv)
 	return 1;
 }
 
+/** Command for setting the time quantum of a run queue
+ *
+ * @param argv Run queue index and time quantum in microseconds.
+ *
+ * @return 1 on success, 0 if the arguments are out of range.
+ */
+int cmd_quantum(cmd_arg_t *argv)
+{
+	if ((argv[0].intval >= RQ_COUNT) ||
+	    (scheduler_quantum_set(argv[0].intval, argv[1].intval) != EOK)) {
+		printf("Run queue index must be less than %d and the quantum "
+		    "at least %d us.\n", RQ_COUNT, RQ_QUANTUM_MIN);
+		return 0;
+	}
+
+	return 1;
+}
+
 /** Command for listing memory zones
  *
  * @param argv Ignored
@@ -84,6 +84,12 @@ void cpu_init(void)
 			cpus[i].id = i;
 
 			irq_spinlock_initialize(&cpus[i].lock, "cpus[].lock");
+			frame_cache_init(&cpus[i].frame_cache);
+
+#ifdef CONFIG_PROFILER
+			irq_spinlock_initialize(&cpus[i].prof_lock,
+			    "cpus[].prof_lock");
+#endif
 
 			for (unsigned int j = 0; j < RQ_COUNT; j++) {
 				irq_spinlock_initialize(&cpus[i].rq[j].lock, "cpus[].rq[].lock");
@@ -105,6 +111,10 @@ void cpu_init(void)
 	CPU->idle_cycles = 0;
 	CPU->busy_cycles = 0;
 
+	CPU->core_id = CPU->id;
+	CPU->package_id = 0;
+	CPU->numa_node = 0;
+
 	cpu_identify();
 	cpu_arch_init();
 }
@@ -115,12 +125,37 @@ void cpu_list(void)
 	unsigned int i;
 
 	for (i = 0; i < config.cpu_count; i++) {
-		if (cpus[i].active)
+		if (cpus[i].active) {
 			cpu_print_report(&cpus[i]);
-		else
+			printf("cpu%u: node=%u package=%u core=%u\n", i,
+			    cpus[i].numa_node, cpus[i].package_id,
+			    cpus[i].core_id);
+		} else
 			printf("cpu%u: not active\n", i);
 	}
 }
 
+/** Get the smallest scheduling domain shared by two processors.
+ *
+ * @param a First processor.
+ * @param b Second processor.
+ *
+ * @return Smallest scheduling domain containing both processors.
+ *
+ */
+cpu_domain_t cpu_domain(cpu_t *a, cpu_t *b)
+{
+	if (a->numa_node != b->numa_node)
+		return CPU_DOMAIN_SYSTEM;
+
+	if (a->package_id != b->package_id)
+		return CPU_DOMAIN_NODE;
+
+	if (a->core_id != b->core_id)
+		return CPU_DOMAIN_PACKAGE;
+
+	return CPU_DOMAIN_CORE;
+}
+
 /** @}
  */
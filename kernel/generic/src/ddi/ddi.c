@@ -48,6 +48,7 @@
 #include <mm/km.h>
 #include <mm/page.h>
 #include <synch/mutex.h>
+#include <synch/rcu.h>
 #include <syscall/copy.h>
 #include <adt/odict.h>
 #include <arch.h>
@@ -216,6 +217,12 @@ _NO_TRACE static errno_t physmem_map(uintptr_t phys, size_t pages,
 map:
 	backend_data.parea = parea;
 
+	/* Suitably aligned regions can be mapped by large pages. */
+	size_t large = page_large_size();
+	if ((large > 0) && IS_ALIGNED(phys, large) &&
+	    (FRAMES2SIZE(pages) >= large))
+		flags |= AS_AREA_LARGE_PAGES;
+
 	if (!as_area_create(TASK->as, flags, FRAMES2SIZE(pages),
 	    AS_AREA_ATTR_NONE, &phys_backend, &backend_data, virt, bound)) {
 		/*
@@ -335,7 +342,7 @@ _NO_TRACE static errno_t iospace_enable(task_id_t id, uintptr_t ioaddr, size_t s
 	if (!(perms & PERM_IO_MANAGER))
 		return EPERM;
 
-	irq_spinlock_lock(&tasks_lock, true);
+	rcu_read_lock();
 
 	task_t *task = task_find_by_id(id);
 
@@ -345,12 +352,13 @@ _NO_TRACE static errno_t iospace_enable(task_id_t id, uintptr_t ioaddr, size_t s
 		 * or the task belongs to a different security
 		 * context.
 		 */
-		irq_spinlock_unlock(&tasks_lock, true);
+		rcu_read_unlock();
 		return ENOENT;
 	}
 
-	/* Lock the task and release the lock protecting tasks dictionary. */
-	irq_spinlock_exchange(&tasks_lock, &task->lock);
+	/* The task lock keeps the task from being freed. */
+	irq_spinlock_lock(&task->lock, true);
+	rcu_read_unlock();
 	errno_t rc = ddi_iospace_enable_arch(task, ioaddr, size);
 	irq_spinlock_unlock(&task->lock, true);
 
@@ -376,7 +384,7 @@ _NO_TRACE static errno_t iospace_disable(task_id_t id, uintptr_t ioaddr, size_t
 	if (!(perms & PERM_IO_MANAGER))
 		return EPERM;
 
-	irq_spinlock_lock(&tasks_lock, true);
+	rcu_read_lock();
 
 	task_t *task = task_find_by_id(id);
 
@@ -386,12 +394,13 @@ _NO_TRACE static errno_t iospace_disable(task_id_t id, uintptr_t ioaddr, size_t
 		 * or the task belongs to a different security
 		 * context.
 		 */
-		irq_spinlock_unlock(&tasks_lock, true);
+		rcu_read_unlock();
 		return ENOENT;
 	}
 
-	/* Lock the task and release the lock protecting tasks dictionary. */
-	irq_spinlock_exchange(&tasks_lock, &task->lock);
+	/* The task lock keeps the task from being freed. */
+	irq_spinlock_lock(&task->lock, true);
+	rcu_read_unlock();
 	errno_t rc = ddi_iospace_disable_arch(task, ioaddr, size);
 	irq_spinlock_unlock(&task->lock, true);
 
@@ -447,7 +456,19 @@ _NO_TRACE static errno_t dmamem_map_anonymous(size_t size, uintptr_t constraint,
 		return EINVAL;
 
 	// FIXME: probably need to ensure that the memory is suitable for DMA
-	*phys = frame_alloc(frames, FRAME_ATOMIC, constraint);
+	*phys = 0;
+
+	/* Prefer frames which can be mapped by large pages. */
+	size_t large = page_large_size();
+	if ((large > 0) && (size >= large)) {
+		*phys = frame_alloc(frames, FRAME_ATOMIC, constraint |
+		    (large - 1));
+		if (*phys != 0)
+			map_flags |= AS_AREA_LARGE_PAGES;
+	}
+
+	if (*phys == 0)
+		*phys = frame_alloc(frames, FRAME_ATOMIC, constraint);
 	if (*phys == 0)
 		return ENOMEM;
 
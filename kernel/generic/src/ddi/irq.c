@@ -36,17 +36,24 @@
  * This file provides means of connecting IRQs with respective device drivers
  * and logic for dispatching interrupts to IRQ handlers defined by those
  * drivers.
+ *
+ * The IRQ hash tables have a fixed number of chains. They are modified under
+ * their locks, but searched by irq_dispatch_and_lock() in an RCU read-side
+ * section, so an interrupt does not contend on a global lock. Removed IRQ
+ * structures must be freed only after a grace period.
  */
 
 #include <ddi/irq.h>
 #include <adt/hash.h>
-#include <adt/hash_table.h>
 #include <mm/slab.h>
+#include <stdlib.h>
+#include <synch/rcu.h>
 #include <typedefs.h>
 #include <synch/spinlock.h>
 #include <console/console.h>
 #include <interrupt.h>
 #include <mem.h>
+#include <panic.h>
 #include <arch.h>
 
 slab_cache_t *irq_cache = NULL;
@@ -59,7 +66,7 @@ slab_cache_t *irq_cache = NULL;
 IRQ_SPINLOCK_STATIC_INITIALIZE(irq_kernel_hash_table_lock);
 
 /** The kernel IRQ hash table. */
-static hash_table_t irq_kernel_hash_table;
+static _Atomic(irq_t *) *irq_kernel_hash_table;
 
 /** Spinlock protecting the uspace IRQ hash table
  *
@@ -69,23 +76,17 @@ static hash_table_t irq_kernel_hash_table;
 IRQ_SPINLOCK_INITIALIZE(irq_uspace_hash_table_lock);
 
 /** The uspace IRQ hash table */
-hash_table_t irq_uspace_hash_table;
-
-static size_t irq_ht_hash(const ht_link_t *);
-static size_t irq_ht_key_hash(const void *);
-static bool irq_ht_equal(const ht_link_t *, const ht_link_t *);
-static bool irq_ht_key_equal(const void *, const ht_link_t *);
+static _Atomic(irq_t *) *irq_uspace_hash_table;
 
-static const hash_table_ops_t irq_ht_ops = {
-	.hash = irq_ht_hash,
-	.key_hash = irq_ht_key_hash,
-	.equal = irq_ht_equal,
-	.key_equal = irq_ht_key_equal
-};
+/** Number of chains in each IRQ hash table */
+static size_t irq_chains;
 
 /** Last valid INR */
 inr_t last_inr = 0;
 
+/** Interrupt routing operations, NULL if routing cannot be changed. */
+irq_route_ops_t *irq_route_ops = NULL;
+
 /** Initialize IRQ subsystem
  *
  * @param inrs    Numbers of unique IRQ numbers or INRs.
@@ -100,8 +101,53 @@ void irq_init(size_t inrs, size_t chains)
 	    FRAME_ATOMIC);
 	assert(irq_cache);
 
-	hash_table_create(&irq_uspace_hash_table, chains, 0, &irq_ht_ops);
-	hash_table_create(&irq_kernel_hash_table, chains, 0, &irq_ht_ops);
+	irq_chains = chains;
+	irq_uspace_hash_table = malloc(chains * sizeof(_Atomic(irq_t *)));
+	irq_kernel_hash_table = malloc(chains * sizeof(_Atomic(irq_t *)));
+	if ((!irq_uspace_hash_table) || (!irq_kernel_hash_table))
+		panic("Cannot allocate IRQ hash tables.");
+
+	for (size_t i = 0; i < chains; i++) {
+		atomic_init(&irq_uspace_hash_table[i], NULL);
+		atomic_init(&irq_kernel_hash_table[i], NULL);
+	}
+}
+
+/** Get the hash table chain for an INR */
+static _Atomic(irq_t *) *irq_chain(_Atomic(irq_t *) *table, inr_t inr)
+{
+	return &table[hash_mix(inr) % irq_chains];
+}
+
+/** Insert an IRQ into a hash table, the table lock must be held */
+static void irq_table_insert(_Atomic(irq_t *) *table, irq_t *irq)
+{
+	_Atomic(irq_t *) *chain = irq_chain(table, irq->inr);
+
+	atomic_init(&irq->next,
+	    atomic_load_explicit(chain, memory_order_relaxed));
+	rcu_assign(*chain, irq);
+}
+
+/** Remove an IRQ from a hash table, the table lock must be held
+ *
+ * The IRQ keeps pointing to its successor, so that readers which still
+ * see it can carry on with the search.
+ */
+static void irq_table_remove(_Atomic(irq_t *) *table, irq_t *irq)
+{
+	_Atomic(irq_t *) *link = irq_chain(table, irq->inr);
+
+	while (true) {
+		irq_t *cur = atomic_load_explicit(link, memory_order_relaxed);
+		assert(cur != NULL);
+		if (cur == irq)
+			break;
+		link = &cur->next;
+	}
+
+	rcu_assign(*link, atomic_load_explicit(&irq->next,
+	    memory_order_relaxed));
 }
 
 /** Initialize one IRQ structure
@@ -130,29 +176,73 @@ void irq_register(irq_t *irq)
 {
 	irq_spinlock_lock(&irq_kernel_hash_table_lock, true);
 	irq_spinlock_lock(&irq->lock, false);
-	hash_table_insert(&irq_kernel_hash_table, &irq->link);
+	irq->notif_cfg.hashed_in = true;
+	irq_table_insert(irq_kernel_hash_table, irq);
 	irq_spinlock_unlock(&irq->lock, false);
 	irq_spinlock_unlock(&irq_kernel_hash_table_lock, true);
 }
 
+/** Insert IRQ into the uspace IRQ hash table
+ *
+ * The uspace IRQ hash table lock and the IRQ lock must be held.
+ *
+ * @param irq  IRQ structure with the INR filled in.
+ *
+ */
+void irq_uspace_insert(irq_t *irq)
+{
+	assert(irq_spinlock_locked(&irq_uspace_hash_table_lock));
+	assert(irq_spinlock_locked(&irq->lock));
+
+	irq->notif_cfg.hashed_in = true;
+	irq_table_insert(irq_uspace_hash_table, irq);
+}
+
+/** Remove IRQ from the uspace IRQ hash table
+ *
+ * The uspace IRQ hash table lock and the IRQ lock must be held. The IRQ
+ * structure may be freed only after an RCU grace period.
+ *
+ * @param irq  IRQ structure in the uspace IRQ hash table.
+ *
+ */
+void irq_uspace_remove(irq_t *irq)
+{
+	assert(irq_spinlock_locked(&irq_uspace_hash_table_lock));
+	assert(irq_spinlock_locked(&irq->lock));
+	assert(irq->notif_cfg.hashed_in);
+
+	irq_table_remove(irq_uspace_hash_table, irq);
+	irq->notif_cfg.hashed_in = false;
+}
+
 /** Search and lock an IRQ hash table */
-static irq_t *
-irq_dispatch_and_lock_table(hash_table_t *h, irq_spinlock_t *l, inr_t inr)
+static irq_t *irq_dispatch_and_lock_table(_Atomic(irq_t *) *table, inr_t inr)
 {
-	irq_spinlock_lock(l, false);
-	ht_link_t *first = hash_table_find(h, &inr);
-	for (ht_link_t *lnk = first; lnk;
-	    lnk = hash_table_find_next(h, first, lnk)) {
-		irq_t *irq = hash_table_get_inst(lnk, irq_t, link);
+	rcu_read_lock();
+
+	for (irq_t *irq = rcu_access(*irq_chain(table, inr)); irq;
+	    irq = rcu_access(irq->next)) {
+		if (irq->inr != inr)
+			continue;
+
 		irq_spinlock_lock(&irq->lock, false);
-		if (irq->claim(irq) == IRQ_ACCEPT) {
-			/* leave irq locked */
-			irq_spinlock_unlock(l, false);
+
+		/* Skip an IRQ which has been removed after we found it. */
+		if ((irq->notif_cfg.hashed_in) &&
+		    (irq->claim(irq) == IRQ_ACCEPT)) {
+			/*
+			 * Leave irq locked, holding its lock keeps the
+			 * structure from being freed.
+			 */
+			rcu_read_unlock();
 			return irq;
 		}
+
 		irq_spinlock_unlock(&irq->lock, false);
 	}
-	irq_spinlock_unlock(l, false);
+
+	rcu_read_unlock();
 
 	return NULL;
 }
@@ -181,52 +271,19 @@ irq_t *irq_dispatch_and_lock(inr_t inr)
 	 */
 
 	if (console_override) {
-		irq_t *irq = irq_dispatch_and_lock_table(&irq_kernel_hash_table,
-		    &irq_kernel_hash_table_lock, inr);
+		irq_t *irq = irq_dispatch_and_lock_table(irq_kernel_hash_table,
+		    inr);
 		if (irq)
 			return irq;
 
-		return irq_dispatch_and_lock_table(&irq_uspace_hash_table,
-		    &irq_uspace_hash_table_lock, inr);
+		return irq_dispatch_and_lock_table(irq_uspace_hash_table, inr);
 	}
 
-	irq_t *irq = irq_dispatch_and_lock_table(&irq_uspace_hash_table,
-	    &irq_uspace_hash_table_lock, inr);
+	irq_t *irq = irq_dispatch_and_lock_table(irq_uspace_hash_table, inr);
 	if (irq)
 		return irq;
 
-	return irq_dispatch_and_lock_table(&irq_kernel_hash_table,
-	    &irq_kernel_hash_table_lock, inr);
-}
-
-/** Return the hash of the key stored in the item. */
-size_t irq_ht_hash(const ht_link_t *item)
-{
-	irq_t *irq = hash_table_get_inst(item, irq_t, link);
-	return hash_mix(irq->inr);
-}
-
-/** Return the hash of the key. */
-size_t irq_ht_key_hash(const void *key)
-{
-	const inr_t *inr = key;
-	return hash_mix(*inr);
-}
-
-/** Return true if the items have the same lookup key. */
-bool irq_ht_equal(const ht_link_t *item1, const ht_link_t *item2)
-{
-	irq_t *irq1 = hash_table_get_inst(item1, irq_t, link);
-	irq_t *irq2 = hash_table_get_inst(item2, irq_t, link);
-	return irq1->inr == irq2->inr;
-}
-
-/** Return true if the key is equal to the item's lookup key. */
-bool irq_ht_key_equal(const void *key, const ht_link_t *item)
-{
-	const inr_t *inr = key;
-	irq_t *irq = hash_table_get_inst(item, irq_t, link);
-	return irq->inr == *inr;
+	return irq_dispatch_and_lock_table(irq_kernel_hash_table, inr);
 }
 
 /** @}
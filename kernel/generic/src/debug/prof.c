@@ -0,0 +1,416 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic_debug
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Sampling profiler.
+ *
+ * While the profiler is running, every processor takes a sample once in
+ * a given number of clock ticks. A sample identifies the interrupted task
+ * and thread and records the interrupted program counter. For threads
+ * interrupted in the kernel, the return addresses found by following the
+ * frame pointers on the kernel stack are recorded too. Userspace stacks
+ * are not walked, because reading them may fault and the clock interrupt
+ * cannot wait for the fault to be resolved.
+ *
+ * The interrupted state is the one recorded by exc_dispatch() for udebug,
+ * which is why the profiler depends on CONFIG_UDEBUG.
+ *
+ * Samples are kept in per-processor ring buffers until they are read by
+ * userspace. When a buffer is full, the oldest sample is overwritten.
+ */
+
+#include <prof.h>
+#include <abi/prof.h>
+#include <arch.h>
+#include <atomic.h>
+#include <config.h>
+#include <cpu.h>
+#include <errno.h>
+#include <interrupt.h>
+#include <macros.h>
+#include <proc/task.h>
+#include <proc/thread.h>
+#include <stacktrace.h>
+#include <stdlib.h>
+#include <str.h>
+#include <symtab_lookup.h>
+#include <synch/mutex.h>
+#include <synch/spinlock.h>
+#include <syscall/copy.h>
+#include <time/clock.h>
+#include <mm/page.h>
+
+#ifdef CONFIG_PROFILER
+
+/** Number of samples in the buffer of each processor */
+#define PROF_RING_SIZE  1024
+
+/** Number of samples moved to userspace at once */
+#define PROF_READ_CHUNK  32
+
+/** Maximum sampling interval (clock ticks) */
+#define PROF_INTERVAL_MAX  HZ
+
+typedef struct prof_ring {
+	/** Index of the oldest sample */
+	size_t head;
+	/** Number of samples in the buffer */
+	size_t count;
+	prof_sample_t samples[PROF_RING_SIZE];
+} prof_ring_t;
+
+/** Serializes starting and stopping the profiler and reading samples */
+static mutex_t prof_lock;
+
+/** Sampling interval (clock ticks), zero if the profiler is stopped */
+static atomic_uint prof_interval;
+
+/** Initialize the profiler */
+void prof_init(void)
+{
+	mutex_initialize(&prof_lock, MUTEX_PASSIVE);
+	atomic_store(&prof_interval, 0);
+}
+
+/** Record the kernel stack of the current thread
+ *
+ * @param istate Interrupted state.
+ * @param pcs    Array to store the program counters to.
+ *
+ * @return Number of recorded program counters.
+ *
+ */
+static uint32_t prof_kernel_stack(istate_t *istate, uint64_t *pcs)
+{
+	uintptr_t stack = (uintptr_t) THREAD->kstack;
+	stack_trace_context_t ctx = {
+		.fp = istate_get_fp(istate),
+		.pc = istate_get_pc(istate),
+		.istate = istate
+	};
+
+	uint32_t depth = 0;
+	pcs[depth++] = ctx.pc;
+
+	while (depth < PROF_STACK_DEPTH) {
+		/* Never follow a frame pointer out of the thread's stack */
+		if ((ctx.fp < stack) || (ctx.fp >= stack + STACK_SIZE) ||
+		    (!kst_ops.stack_trace_context_validate(&ctx)))
+			break;
+
+		uintptr_t pc;
+		uintptr_t fp;
+		if ((!kst_ops.return_address_get(&ctx, &pc)) ||
+		    (!kst_ops.frame_pointer_prev(&ctx, &fp)))
+			break;
+
+		pcs[depth++] = pc;
+		ctx.fp = fp;
+		ctx.pc = pc;
+	}
+
+	return depth;
+}
+
+/** Fill in a sample of the current processor
+ *
+ * @param sample Sample to fill in.
+ *
+ */
+static void prof_sample(prof_sample_t *sample)
+{
+	sample->cpu = CPU->id;
+	sample->depth = 0;
+
+	if (!THREAD) {
+		sample->task_id = 0;
+		sample->thread_id = 0;
+		sample->flags = PROF_SAMPLE_IDLE;
+		return;
+	}
+
+	sample->task_id = TASK->taskid;
+	sample->thread_id = THREAD->tid;
+	sample->flags = 0;
+
+	istate_t *istate = THREAD->udebug.uspace_state;
+	if (!istate)
+		return;
+
+	if (istate_from_uspace(istate)) {
+		sample->flags |= PROF_SAMPLE_USPACE;
+		sample->pcs[0] = istate_get_pc(istate);
+		sample->depth = 1;
+	} else
+		sample->depth = prof_kernel_stack(istate, sample->pcs);
+}
+
+/** Take a sample if it is due
+ *
+ * Called from the clock interrupt handler with interrupts disabled.
+ *
+ */
+void prof_tick(void)
+{
+	unsigned int interval = atomic_load_explicit(&prof_interval,
+	    memory_order_relaxed);
+	if (interval == 0)
+		return;
+
+	if (++CPU->prof_ticks < interval)
+		return;
+
+	CPU->prof_ticks = 0;
+
+	irq_spinlock_lock(&CPU->prof_lock, false);
+
+	prof_ring_t *ring = CPU->prof_ring;
+	if (ring) {
+		size_t idx = (ring->head + ring->count) % PROF_RING_SIZE;
+
+		if (ring->count < PROF_RING_SIZE)
+			ring->count++;
+		else
+			ring->head = (ring->head + 1) % PROF_RING_SIZE;
+
+		prof_sample(&ring->samples[idx]);
+	}
+
+	irq_spinlock_unlock(&CPU->prof_lock, false);
+}
+
+/** Remove the sample buffers of all processors
+ *
+ * The caller must hold prof_lock.
+ *
+ */
+static void prof_rings_free(void)
+{
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		irq_spinlock_lock(&cpus[i].prof_lock, true);
+		prof_ring_t *ring = cpus[i].prof_ring;
+		cpus[i].prof_ring = NULL;
+		irq_spinlock_unlock(&cpus[i].prof_lock, true);
+
+		free(ring);
+	}
+}
+
+static errno_t prof_start(sysarg_t interval)
+{
+	if ((interval == 0) || (interval > PROF_INTERVAL_MAX))
+		return EINVAL;
+
+	mutex_lock(&prof_lock);
+
+	if (atomic_load(&prof_interval) != 0) {
+		mutex_unlock(&prof_lock);
+		return EBUSY;
+	}
+
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		prof_ring_t *ring = malloc(sizeof(prof_ring_t));
+		if (!ring) {
+			prof_rings_free();
+			mutex_unlock(&prof_lock);
+			return ENOMEM;
+		}
+
+		ring->head = 0;
+		ring->count = 0;
+
+		irq_spinlock_lock(&cpus[i].prof_lock, true);
+		cpus[i].prof_ring = ring;
+		cpus[i].prof_ticks = 0;
+		irq_spinlock_unlock(&cpus[i].prof_lock, true);
+	}
+
+	atomic_store(&prof_interval, (unsigned int) interval);
+
+	mutex_unlock(&prof_lock);
+	return EOK;
+}
+
+static void prof_stop(void)
+{
+	mutex_lock(&prof_lock);
+	atomic_store(&prof_interval, 0);
+	prof_rings_free();
+	mutex_unlock(&prof_lock);
+}
+
+/** Move samples to userspace
+ *
+ * @param buf          Userspace buffer.
+ * @param size         Size of the buffer.
+ * @param uspace_nread Place to store the number of bytes read.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+static errno_t prof_read(uspace_addr_t buf, size_t size,
+    uspace_ptr_size_t uspace_nread)
+{
+	size_t max = size / sizeof(prof_sample_t);
+	if (max == 0)
+		return ELIMIT;
+
+	prof_sample_t *chunk = malloc(PROF_READ_CHUNK * sizeof(prof_sample_t));
+	if (!chunk)
+		return ENOMEM;
+
+	errno_t rc = EOK;
+	size_t read = 0;
+
+	mutex_lock(&prof_lock);
+
+	for (unsigned int i = 0; (i < config.cpu_count) && (read < max); i++) {
+		size_t cnt;
+
+		do {
+			irq_spinlock_lock(&cpus[i].prof_lock, true);
+
+			prof_ring_t *ring = cpus[i].prof_ring;
+			cnt = (ring) ? min3(ring->count, max - read,
+			    PROF_READ_CHUNK) : 0;
+
+			for (size_t j = 0; j < cnt; j++) {
+				chunk[j] = ring->samples[ring->head];
+				ring->head = (ring->head + 1) % PROF_RING_SIZE;
+				ring->count--;
+			}
+
+			irq_spinlock_unlock(&cpus[i].prof_lock, true);
+
+			if (cnt > 0) {
+				rc = copy_to_uspace(buf +
+				    read * sizeof(prof_sample_t), chunk,
+				    cnt * sizeof(prof_sample_t));
+				if (rc != EOK)
+					break;
+
+				read += cnt;
+			}
+		} while ((cnt > 0) && (read < max));
+
+		if (rc != EOK)
+			break;
+	}
+
+	mutex_unlock(&prof_lock);
+	free(chunk);
+
+	if (rc != EOK)
+		return rc;
+
+	size_t nread = read * sizeof(prof_sample_t);
+	return copy_to_uspace(uspace_nread, &nread, sizeof(nread));
+}
+
+/** Look up a kernel symbol for userspace
+ *
+ * @param addr         Kernel address.
+ * @param buf          Userspace buffer for the symbol name.
+ * @param size         Size of the buffer.
+ * @param uspace_offs  Place to store the offset of the address within
+ *                     the symbol.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+static errno_t prof_symbol(uintptr_t addr, uspace_addr_t buf, size_t size,
+    uspace_ptr_size_t uspace_offs)
+{
+	if ((size == 0) || (size > PAGE_SIZE))
+		return ELIMIT;
+
+	const char *name;
+	uintptr_t offs;
+	errno_t rc = symtab_name_lookup(addr, &name, &offs);
+	if (rc != EOK)
+		return rc;
+
+	char *data = malloc(size);
+	if (!data)
+		return ENOMEM;
+
+	str_cpy(data, size, name);
+	rc = copy_to_uspace(buf, data, str_size(data) + 1);
+	free(data);
+
+	if (rc != EOK)
+		return rc;
+
+	size_t offset = offs;
+	return copy_to_uspace(uspace_offs, &offset, sizeof(offset));
+}
+
+#endif /* CONFIG_PROFILER */
+
+/** Control the profiler from userspace
+ *
+ * @param operation    Operation, see prof_operation_t.
+ * @param arg          Sampling interval for PROF_START, address for
+ *                     PROF_SYMBOL.
+ * @param buf          Buffer for PROF_READ and PROF_SYMBOL.
+ * @param size         Size of the buffer.
+ * @param uspace_nread Number of bytes read for PROF_READ, symbol offset
+ *                     for PROF_SYMBOL.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+sys_errno_t sys_prof(sysarg_t operation, sysarg_t arg, uspace_addr_t buf,
+    size_t size, uspace_ptr_size_t uspace_nread)
+{
+#ifdef CONFIG_PROFILER
+	switch (operation) {
+	case PROF_START:
+		return (sys_errno_t) prof_start(arg);
+	case PROF_STOP:
+		prof_stop();
+		return EOK;
+	case PROF_READ:
+		return (sys_errno_t) prof_read(buf, size, uspace_nread);
+	case PROF_SYMBOL:
+		return (sys_errno_t) prof_symbol(arg, buf, size, uspace_nread);
+	default:
+		return (sys_errno_t) ENOTSUP;
+	}
+#else
+	return (sys_errno_t) ENOTSUP;
+#endif
+}
+
+/** @}
+ */
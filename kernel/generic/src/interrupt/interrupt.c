@@ -45,6 +45,7 @@
 #include <console/console.h>
 #include <console/cmd.h>
 #include <synch/mutex.h>
+#include <time/clock.h>
 #include <time/delay.h>
 #include <macros.h>
 #include <panic.h>
@@ -52,6 +53,7 @@
 #include <stdarg.h>
 #include <symtab.h>
 #include <proc/thread.h>
+#include <security/entropy.h>
 #include <arch/cycle.h>
 #include <arch/stack.h>
 #include <str.h>
@@ -119,9 +121,13 @@ _NO_TRACE void exc_dispatch(unsigned int n, istate_t *istate)
 		CPU->last_cycle = now;
 		CPU->idle = false;
 		irq_spinlock_unlock(&CPU->lock, false);
+
+		/* Catch up with the time spent sleeping without a tick */
+		clock_tick_restart();
 	}
 
 	uint64_t begin_cycle = get_cycle();
+	entropy_sample(begin_cycle ^ ((uint64_t) n << 48));
 
 #ifdef CONFIG_UDEBUG
 	if (THREAD)
@@ -51,6 +51,14 @@
 #include <ipc/sysipc_priv.h>
 #include <errno.h>
 #include <mm/slab.h>
+#include <mm/as.h>
+#include <mm/frame.h>
+#include <mm/page.h>
+#include <genarch/mm/page_pt.h>
+#include <genarch/mm/page_ht.h>
+#include <syscall/copy.h>
+#include <align.h>
+#include <macros.h>
 #include <arch.h>
 #include <proc/task.h>
 #include <mem.h>
@@ -59,9 +67,13 @@
 #include <proc/thread.h>
 #include <arch/interrupt.h>
 #include <ipc/irq.h>
+#include <ipc/profile.h>
 #include <cap/cap.h>
 #include <stdlib.h>
 
+/** Maximum number of pages copied out of a pinned buffer in one batch. */
+#define IPC_COPY_BATCH  16
+
 static void ipc_forget_call(call_t *);
 
 /** Answerbox that new tasks are automatically connected to */
@@ -86,14 +98,14 @@ static void _ipc_call_init(call_t *call)
 	call->sender = NULL;
 	call->callerbox = NULL;
 	call->buffer = NULL;
+	call->frames = NULL;
 }
 
 static void call_destroy(void *arg)
 {
 	call_t *call = (call_t *) arg;
 
-	if (call->buffer)
-		free(call->buffer);
+	ipc_call_buffer_release(call);
 	if (call->caller_phone)
 		kobject_put(call->caller_phone->kobject);
 	slab_free(call_cache, call);
@@ -103,6 +115,171 @@ kobject_ops_t call_kobject_ops = {
 	.destroy = call_destroy
 };
 
+/** Pin a frame backing a page of the current address space.
+ *
+ * @param addr  Readable address within the page.
+ * @param frame Place to store the physical address of the frame.
+ *
+ * @return EOK on success, error code otherwise.
+ *
+ */
+static errno_t ipc_page_pin(uspace_addr_t addr, uintptr_t *frame)
+{
+	/*
+	 * Touch the page first. This checks the access rights and faults
+	 * in the page if it is not mapped yet.
+	 */
+	uint8_t byte;
+	errno_t rc = copy_from_uspace(&byte, addr, 1);
+	if (rc != EOK)
+		return rc;
+
+	page_table_lock(AS, true);
+
+	pte_t pte;
+	bool found = page_mapping_find(AS, ALIGN_DOWN(addr, PAGE_SIZE), false,
+	    &pte);
+	if ((!found) || (!PTE_PRESENT(&pte))) {
+		/* The page has been unmapped in the meantime */
+		page_table_unlock(AS, true);
+		return ENOENT;
+	}
+
+	*frame = PTE_GET_FRAME(&pte);
+	if (!frame_reference_add_lowmem(ADDR2PFN(*frame)))
+		rc = ENOTSUP;
+
+	page_table_unlock(AS, true);
+	return rc;
+}
+
+/** Pin the source buffer of a data transfer.
+ *
+ * Add a reference to each frame backing the buffer in the current
+ * address space, so that the data can be copied directly from the
+ * frames to the destination when the transfer completes.
+ *
+ * @param call Call carrying the data transfer.
+ * @param src  Source buffer in the current address space.
+ * @param size Size of the buffer.
+ *
+ * @return EOK on success. On failure, nothing is pinned and the caller
+ *         is expected to copy the buffer instead.
+ *
+ */
+errno_t ipc_call_buffer_pin(call_t *call, uspace_addr_t src, size_t size)
+{
+	assert(!call->buffer);
+	assert(!call->frames);
+	assert(size > 0);
+
+	size_t offset = src - ALIGN_DOWN(src, PAGE_SIZE);
+	size_t count = SIZE2FRAMES(offset + size);
+
+	uintptr_t *frames = malloc(sizeof(uintptr_t) * count);
+	if (!frames)
+		return ENOMEM;
+
+	errno_t rc = EOK;
+	size_t i;
+	for (i = 0; i < count; i++) {
+		uspace_addr_t addr = (i == 0) ? src :
+		    ALIGN_DOWN(src, PAGE_SIZE) + P2SZ(i);
+
+		rc = ipc_page_pin(addr, &frames[i]);
+		if (rc != EOK)
+			break;
+	}
+
+	if (rc != EOK) {
+		while (i > 0)
+			frame_free_noreserve(frames[--i], 1);
+
+		free(frames);
+		return rc;
+	}
+
+	call->frames = frames;
+	call->frames_count = count;
+	call->frames_offset = offset;
+
+	return EOK;
+}
+
+/** Copy the data of a data transfer to the destination.
+ *
+ * The data are taken either from the bounce buffer or from the pinned
+ * frames of the source buffer.
+ *
+ * @param call Call carrying the data transfer.
+ * @param dst  Destination buffer in the current address space.
+ * @param size Number of bytes to copy.
+ *
+ * @return EOK on success, error code otherwise.
+ *
+ */
+errno_t ipc_call_buffer_copy_out(call_t *call, uspace_addr_t dst, size_t size)
+{
+	if (!call->frames)
+		return copy_to_uspace(dst, call->buffer, size);
+
+	assert(call->frames_offset + size <= FRAMES2SIZE(call->frames_count));
+
+	/*
+	 * Copy the pages in batches to avoid setting up the copy
+	 * for each page separately.
+	 */
+	copy_iovec_t iov[IPC_COPY_BATCH];
+	size_t offset = call->frames_offset;
+	size_t done = 0;
+	size_t i = 0;
+
+	while (done < size) {
+		size_t count;
+
+		for (count = 0; (count < IPC_COPY_BATCH) && (done < size);
+		    count++) {
+			size_t chunk = min(PAGE_SIZE - offset, size - done);
+
+			iov[count].kernel =
+			    (void *) (PA2KA(call->frames[i++]) + offset);
+			iov[count].uspace = dst + done;
+			iov[count].size = chunk;
+
+			done += chunk;
+			offset = 0;
+		}
+
+		errno_t rc = copy_to_uspace_vec(iov, count);
+		if (rc != EOK)
+			return rc;
+	}
+
+	return EOK;
+}
+
+/** Release the data of a data transfer.
+ *
+ * @param call Call carrying the data transfer.
+ *
+ */
+void ipc_call_buffer_release(call_t *call)
+{
+	if (call->buffer) {
+		free(call->buffer);
+		call->buffer = NULL;
+	}
+
+	if (call->frames) {
+		for (size_t i = 0; i < call->frames_count; i++)
+			frame_free_noreserve(call->frames[i], 1);
+
+		free(call->frames);
+		call->frames = NULL;
+		call->frames_count = 0;
+	}
+}
+
 /** Allocate and initialize a call structure.
  *
  * The call is initialized, so that the reply will be directed to
@@ -200,6 +377,9 @@ void ipc_phone_init(phone_t *phone, task_t *caller)
 	phone->state = IPC_PHONE_FREE;
 	atomic_store(&phone->active_calls, 0);
 	phone->label = 0;
+#ifdef CONFIG_IPC_PROFILE
+	phone->iface = 0;
+#endif
 	phone->kobject = NULL;
 }
 
@@ -325,7 +505,21 @@ void _ipc_answer_free_call(call_t *call, bool selflocked)
 	if (do_lock)
 		irq_spinlock_unlock(&callerbox->lock, true);
 
-	waitq_wake_one(&callerbox->wq);
+	/*
+	 * If there are no more calls to serve, the answering thread is most
+	 * likely going to wait for the next one, so let the caller run on
+	 * this CPU right away.
+	 */
+	if (!selflocked)
+		irq_spinlock_lock(&TASK->answerbox.lock, true);
+	bool handoff = list_empty(&TASK->answerbox.calls);
+	if (!selflocked)
+		irq_spinlock_unlock(&TASK->answerbox.lock, true);
+
+	if (handoff)
+		waitq_wake_one_handoff(&callerbox->wq);
+	else
+		waitq_wake_one(&callerbox->wq);
 }
 
 /** Answer a message which is in a callee queue.
@@ -406,16 +600,36 @@ static void _ipc_call(phone_t *phone, answerbox_t *box, call_t *call,
 	/* Count sent ipc call */
 	irq_spinlock_lock(&caller->lock, true);
 	caller->ipc_info.call_sent++;
+#ifdef CONFIG_IPC_PROFILE
+	if (!(call->flags & IPC_CALL_FORWARDED))
+		ipc_profile_call(caller, phone, call);
+#endif
 	irq_spinlock_unlock(&caller->lock, true);
 
-	if (!(call->flags & IPC_CALL_FORWARDED))
+	bool handoff = false;
+	if (!(call->flags & IPC_CALL_FORWARDED)) {
 		_ipc_call_actions_internal(phone, call, preforget);
 
+		/*
+		 * A caller with no other outstanding calls is most likely
+		 * going to wait for the answer, so let the callee run on this
+		 * CPU right away. Callers which keep more calls in flight are
+		 * better off when the callee runs in parallel.
+		 */
+		answerbox_t *callerbox = call->callerbox ? call->callerbox :
+		    &caller->answerbox;
+		handoff = ((!preforget) &&
+		    (atomic_load(&callerbox->active_calls) == 1));
+	}
+
 	irq_spinlock_lock(&box->lock, true);
 	list_append(&call->ab_link, &box->calls);
 	irq_spinlock_unlock(&box->lock, true);
 
-	waitq_wake_one(&box->wq);
+	if (handoff)
+		waitq_wake_one_handoff(&box->wq);
+	else
+		waitq_wake_one(&box->wq);
 }
 
 /** Send an asynchronous request using a phone to an answerbox.
@@ -554,7 +768,9 @@ errno_t ipc_wait_for_call(answerbox_t *box, uint32_t usec, unsigned int flags,
 	uint64_t call_cnt = 0;
 	errno_t rc;
 
+	THREAD->block_reason = THREAD_BLOCK_IPC;
 	rc = _waitq_sleep_timeout(&box->wq, usec, flags);
+	THREAD->block_reason = THREAD_BLOCK_OTHER;
 	if (rc != EOK)
 		return rc;
 
@@ -966,14 +1182,9 @@ static bool print_task_phone_cb(cap_t *cap, void *arg)
  */
 void ipc_print_task(task_id_t taskid)
 {
-	irq_spinlock_lock(&tasks_lock, true);
-	task_t *task = task_find_by_id(taskid);
-	if (!task) {
-		irq_spinlock_unlock(&tasks_lock, true);
+	task_t *task = task_get_by_id(taskid);
+	if (!task)
 		return;
-	}
-	task_hold(task);
-	irq_spinlock_unlock(&tasks_lock, true);
 
 	printf("[phone cap] [calls] [state\n");
 
@@ -65,7 +65,10 @@
 #include <console/console.h>
 #include <macros.h>
 #include <cap/cap.h>
+#include <config.h>
 #include <stdlib.h>
+#include <member.h>
+#include <synch/rcu.h>
 
 static void ranges_unmap(irq_pio_range_t *ranges, size_t rangecount)
 {
@@ -235,22 +238,32 @@ static irq_code_t *code_from_uspace(uspace_ptr_irq_code_t ucode)
 		goto error;
 
 	if ((code->rangecount > IRQ_MAX_RANGE_COUNT) ||
-	    (code->cmdcount > IRQ_MAX_PROG_SIZE))
+	    (code->cmdcount > IRQ_MAX_PROG_SIZE) ||
+	    (code->flags & ~IRQ_CODE_COALESCE))
 		goto error;
 
 	ranges = malloc(sizeof(code->ranges[0]) * code->rangecount);
 	if (!ranges)
 		goto error;
-	rc = copy_from_uspace(ranges, (uintptr_t) code->ranges,
-	    sizeof(code->ranges[0]) * code->rangecount);
-	if (rc != EOK)
-		goto error;
 
 	cmds = malloc(sizeof(code->cmds[0]) * code->cmdcount);
 	if (!cmds)
 		goto error;
-	rc = copy_from_uspace(cmds, (uintptr_t) code->cmds,
-	    sizeof(code->cmds[0]) * code->cmdcount);
+
+	copy_iovec_t iov[] = {
+		{
+			.kernel = ranges,
+			.uspace = (uintptr_t) code->ranges,
+			.size = sizeof(code->ranges[0]) * code->rangecount
+		},
+		{
+			.kernel = cmds,
+			.uspace = (uintptr_t) code->cmds,
+			.size = sizeof(code->cmds[0]) * code->cmdcount
+		}
+	};
+
+	rc = copy_from_uspace_vec(iov, sizeof(iov) / sizeof(iov[0]));
 	if (rc != EOK)
 		goto error;
 
@@ -284,25 +297,34 @@ static void irq_hash_out(irq_t *irq)
 	irq_spinlock_lock(&irq_uspace_hash_table_lock, true);
 	irq_spinlock_lock(&irq->lock, false);
 
-	if (irq->notif_cfg.hashed_in) {
-		/* Remove the IRQ from the uspace IRQ hash table. */
-		hash_table_remove_item(&irq_uspace_hash_table, &irq->link);
-		irq->notif_cfg.hashed_in = false;
-	}
+	/* Remove the IRQ from the uspace IRQ hash table. */
+	if (irq->notif_cfg.hashed_in)
+		irq_uspace_remove(irq);
 
 	irq_spinlock_unlock(&irq->lock, false);
 	irq_spinlock_unlock(&irq_uspace_hash_table_lock, true);
 }
 
+static void irq_free_rcu(rcu_item_t *item)
+{
+	slab_free(irq_cache, member_to_inst(item, irq_t, rcu));
+}
+
 static void irq_destroy(void *arg)
 {
 	irq_t *irq = (irq_t *) arg;
 
 	irq_hash_out(irq);
 
+	/* Drop the reference to the last coalescing notification. */
+	if (irq->notif_cfg.pending)
+		kobject_put(irq->notif_cfg.pending->kobject);
+
 	/* Free up the IRQ code and associated structures. */
 	code_free(irq->notif_cfg.code);
-	slab_free(irq_cache, irq);
+
+	/* Interrupt dispatch might still be looking at the structure. */
+	call_rcu(&irq->rcu, irq_free_rcu);
 }
 
 kobject_ops_t irq_kobject_ops = {
@@ -371,6 +393,8 @@ errno_t ipc_irq_subscribe(answerbox_t *box, inr_t inr, sysarg_t imethod,
 	irq->notif_cfg.imethod = imethod;
 	irq->notif_cfg.code = code;
 	irq->notif_cfg.counter = 0;
+	irq->notif_cfg.pending = NULL;
+	irq->notif_cfg.cpu = IRQ_CPU_ANY;
 
 	/*
 	 * Insert the IRQ structure into the uspace IRQ hash table.
@@ -378,8 +402,7 @@ errno_t ipc_irq_subscribe(answerbox_t *box, inr_t inr, sysarg_t imethod,
 	irq_spinlock_lock(&irq_uspace_hash_table_lock, true);
 	irq_spinlock_lock(&irq->lock, false);
 
-	irq->notif_cfg.hashed_in = true;
-	hash_table_insert(&irq_uspace_hash_table, &irq->link);
+	irq_uspace_insert(irq);
 
 	irq_spinlock_unlock(&irq->lock, false);
 	irq_spinlock_unlock(&irq_uspace_hash_table_lock, true);
@@ -414,6 +437,45 @@ errno_t ipc_irq_unsubscribe(answerbox_t *box, cap_irq_handle_t handle)
 	return EOK;
 }
 
+/** Route an IRQ to a CPU.
+ *
+ * The routing belongs to the interrupt line, so it also affects other
+ * handlers sharing the same IRQ number.
+ *
+ * @param box     Answerbox associated with the notification.
+ * @param handle  IRQ capability handle.
+ * @param cpu     CPU ID or IRQ_CPU_ANY.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t ipc_irq_set_affinity(answerbox_t *box, cap_irq_handle_t handle,
+    unsigned int cpu)
+{
+	if ((cpu != IRQ_CPU_ANY) && (cpu >= config.cpu_count))
+		return EINVAL;
+
+	if ((!irq_route_ops) || (!irq_route_ops->set_affinity))
+		return ENOTSUP;
+
+	kobject_t *kobj = kobject_get(TASK, handle, KOBJECT_TYPE_IRQ);
+	if (!kobj)
+		return ENOENT;
+
+	irq_t *irq = kobj->irq;
+	assert(irq->notif_cfg.answerbox == box);
+
+	errno_t rc = irq_route_ops->set_affinity(irq->inr, cpu);
+	if (rc == EOK) {
+		irq_spinlock_lock(&irq->lock, true);
+		irq->notif_cfg.cpu = cpu;
+		irq_spinlock_unlock(&irq->lock, true);
+	}
+
+	kobject_put(kobj);
+	return rc;
+}
+
 /** Add a call to the proper answerbox queue.
  *
  * Assume irq->lock is locked and interrupts disabled.
@@ -514,6 +576,50 @@ irq_ownership_t ipc_irq_top_half_claim(irq_t *irq)
 	return IRQ_DECLINE;
 }
 
+/** Merge an interrupt into the pending notification.
+ *
+ * Assume irq->lock is locked and interrupts disabled.
+ *
+ * @param irq IRQ structure.
+ *
+ * @return True if the interrupt was merged into a notification which is still
+ *         waiting in the answerbox, false if a new one needs to be sent.
+ *
+ */
+static bool notif_coalesce(irq_t *irq)
+{
+	call_t *call = irq->notif_cfg.pending;
+	if (!call)
+		return false;
+
+	answerbox_t *box = irq->notif_cfg.answerbox;
+	uint32_t *scratch = irq->notif_cfg.scratch;
+
+	/*
+	 * The call leaves irq_notifs under irq_lock, so once we see it still
+	 * linked, the receiver cannot pick it up until we are done with it.
+	 */
+	irq_spinlock_lock(&box->irq_lock, false);
+	bool queued = link_in_use(&call->ab_link);
+	if (queued) {
+		call->priv = ++irq->notif_cfg.counter;
+
+		/* Arguments 1 to 5 carry the payload, argument 0 the method. */
+		for (size_t i = 1; i < IPC_CALL_LEN; i++)
+			call->data.args[i] |= scratch[i];
+	}
+	irq_spinlock_unlock(&box->irq_lock, false);
+
+	if (queued) {
+		irq->notif_cfg.coalesced++;
+		return true;
+	}
+
+	irq->notif_cfg.pending = NULL;
+	kobject_put(call->kobject);
+	return false;
+}
+
 /** IRQ top-half handler.
  *
  * We expect interrupts to be disabled and the irq->lock already held.
@@ -529,9 +635,14 @@ void ipc_irq_top_half_handler(irq_t *irq)
 	assert(irq_spinlock_locked(&irq->lock));
 
 	if (irq->notif_cfg.answerbox) {
+		if (notif_coalesce(irq))
+			return;
+
 		call_t *call = ipc_call_alloc();
-		if (!call)
+		if (!call) {
+			irq->notif_cfg.dropped++;
 			return;
+		}
 
 		call->flags |= IPC_CALL_NOTIF;
 		/* Put a counter to the message */
@@ -545,6 +656,13 @@ void ipc_irq_top_half_handler(irq_t *irq)
 		ipc_set_arg4(&call->data, irq->notif_cfg.scratch[4]);
 		ipc_set_arg5(&call->data, irq->notif_cfg.scratch[5]);
 
+		/* Keep the call around so that later interrupts can join it. */
+		if ((irq->notif_cfg.code) &&
+		    (irq->notif_cfg.code->flags & IRQ_CODE_COALESCE)) {
+			kobject_add_ref(call->kobject);
+			irq->notif_cfg.pending = call;
+		}
+
 		send_call(irq, call);
 	}
 }
@@ -567,6 +685,7 @@ void ipc_irq_send_msg(irq_t *irq, sysarg_t a1, sysarg_t a2, sysarg_t a3,
 	if (irq->notif_cfg.answerbox) {
 		call_t *call = ipc_call_alloc();
 		if (!call) {
+			irq->notif_cfg.dropped++;
 			irq_spinlock_unlock(&irq->lock, true);
 			return;
 		}
@@ -89,6 +89,11 @@ static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 	/* Set the recipient-assigned label */
 	pobj->phone->label = ipc_get_arg5(&answer->data);
 
+#ifdef CONFIG_IPC_PROFILE
+	/* Remember the interface the phone connects to */
+	pobj->phone->iface = ipc_get_arg1(olddata);
+#endif
+
 	/* Restore phone handle in answer's ARG5 */
 	ipc_set_arg5(&answer->data, ipc_get_arg5(olddata));
 
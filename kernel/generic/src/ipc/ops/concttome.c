@@ -49,6 +49,11 @@ static int request_process(call_t *call, answerbox_t *box)
 		 * Set the sender-assigned label to the new phone.
 		 */
 		pobj->phone->label = ipc_get_arg5(&call->data);
+
+#ifdef CONFIG_IPC_PROFILE
+		/* Remember the interface of the callback connection */
+		pobj->phone->iface = ipc_get_arg1(&call->data);
+#endif
 	}
 	call->priv = (sysarg_t) pobj;
 	ipc_set_arg5(&call->data, cap_handle_raw(phandle));
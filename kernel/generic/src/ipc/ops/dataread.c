@@ -39,6 +39,8 @@
 #include <abi/errno.h>
 #include <syscall/copy.h>
 #include <config.h>
+#include <proc/task.h>
+#include <arch.h>
 
 static errno_t request_preprocess(call_t *call, phone_t *phone)
 {
@@ -59,6 +61,7 @@ static errno_t request_preprocess(call_t *call, phone_t *phone)
 static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 {
 	assert(!answer->buffer);
+	assert(!answer->frames);
 
 	if (!ipc_get_retval(&answer->data)) {
 		/* The recipient agreed to send data. */
@@ -74,6 +77,18 @@ static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 			 */
 			ipc_set_arg1(&answer->data, dst);
 
+			TASK->ipc_info.data_read += size;
+
+			/*
+			 * Large buffers are not copied now, the caller
+			 * copies the data directly from the pinned frames.
+			 */
+			if ((size >= DATA_XFER_PIN_THRESHOLD) &&
+			    (ipc_call_buffer_pin(answer, src, size) == EOK)) {
+				TASK->ipc_info.data_read_pinned += size;
+				return EOK;
+			}
+
 			answer->buffer = malloc(size);
 			if (!answer->buffer) {
 				ipc_set_retval(&answer->data, ENOMEM);
@@ -101,14 +116,17 @@ static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 
 static errno_t answer_process(call_t *answer)
 {
-	if (answer->buffer) {
+	if ((answer->buffer) || (answer->frames)) {
 		uspace_addr_t dst = ipc_get_arg1(&answer->data);
 		size_t size = ipc_get_arg2(&answer->data);
 		errno_t rc;
 
-		rc = copy_to_uspace(dst, answer->buffer, size);
+		rc = ipc_call_buffer_copy_out(answer, dst, size);
 		if (rc)
 			ipc_set_retval(&answer->data, rc);
+
+		/* The data are not needed any more. */
+		ipc_call_buffer_release(answer);
 	}
 
 	return EOK;
@@ -39,6 +39,8 @@
 #include <abi/errno.h>
 #include <syscall/copy.h>
 #include <config.h>
+#include <proc/task.h>
+#include <arch.h>
 
 static errno_t request_preprocess(call_t *call, phone_t *phone)
 {
@@ -55,6 +57,18 @@ static errno_t request_preprocess(call_t *call, phone_t *phone)
 			return ELIMIT;
 	}
 
+	TASK->ipc_info.data_written += size;
+
+	/*
+	 * Large buffers are not copied now, the recipient copies the data
+	 * directly from the pinned frames.
+	 */
+	if ((size >= DATA_XFER_PIN_THRESHOLD) &&
+	    (ipc_call_buffer_pin(call, src, size) == EOK)) {
+		TASK->ipc_info.data_written_pinned += size;
+		return EOK;
+	}
+
 	call->buffer = (uint8_t *) malloc(size);
 	if (!call->buffer)
 		return ENOMEM;
@@ -72,7 +86,7 @@ static errno_t request_preprocess(call_t *call, phone_t *phone)
 
 static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 {
-	assert(answer->buffer);
+	assert((answer->buffer) || (answer->frames));
 
 	if (!ipc_get_retval(&answer->data)) {
 		/* The recipient agreed to receive data. */
@@ -81,8 +95,8 @@ static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 		size_t max_size = ipc_get_arg2(olddata);
 
 		if (size <= max_size) {
-			errno_t rc = copy_to_uspace(dst,
-			    answer->buffer, size);
+			errno_t rc = ipc_call_buffer_copy_out(answer, dst,
+			    size);
 			if (rc)
 				ipc_set_retval(&answer->data, rc);
 		} else {
@@ -90,6 +104,9 @@ static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 		}
 	}
 
+	/* The data are not needed any more. */
+	ipc_call_buffer_release(answer);
+
 	return EOK;
 }
 
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic_ipc
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Per-task IPC and syscall profiling.
+ *
+ * Every task keeps a small table of interfaces it sends calls to. For each
+ * interface the number of calls, the number of bytes moved by data transfers
+ * and a histogram of answer latencies is kept. The interface of a call is
+ * the interface its phone was connected to. Calls on phones with no
+ * interface (e.g. the initial phones and phones to the kernel) and calls on
+ * interfaces which do not fit into the table are accounted to slot 0.
+ *
+ * All counters are protected by the task lock.
+ */
+
+#include <ipc/profile.h>
+#include <abi/ipc/methods.h>
+#include <abi/sysinfo.h>
+#include <adt/hash.h>
+#include <arch/cycle.h>
+#include <bitops.h>
+#include <macros.h>
+#include <mem.h>
+#include <proc/task.h>
+
+/** Initialize the IPC profile of a new task.
+ *
+ * @param task Task to initialize.
+ *
+ */
+void ipc_profile_init(task_t *task)
+{
+	memsetb(&task->ipc_profile, sizeof(task->ipc_profile), 0);
+}
+
+/** Find or allocate the profile slot of an interface.
+ *
+ * @param task  Task whose profile is searched. Its lock must be held.
+ * @param iface Interface.
+ *
+ * @return Slot index.
+ *
+ */
+static size_t ipc_profile_slot(task_t *task, sysarg_t iface)
+{
+	if (iface == 0)
+		return 0;
+
+	stats_ipc_iface_t *ifaces = task->ipc_profile.ifaces;
+	size_t start = hash_mix(iface) % (STATS_IPC_PROF_IFACES - 1);
+
+	for (size_t i = 0; i < STATS_IPC_PROF_IFACES - 1; i++) {
+		size_t slot = 1 + (start + i) % (STATS_IPC_PROF_IFACES - 1);
+
+		if (ifaces[slot].iface == (uint32_t) iface)
+			return slot;
+
+		if (ifaces[slot].iface == 0) {
+			ifaces[slot].iface = (uint32_t) iface;
+			return slot;
+		}
+	}
+
+	/* The table is full */
+	return 0;
+}
+
+/** Account a call being sent.
+ *
+ * @param caller Task sending the call. Its lock must be held.
+ * @param phone  Phone the call is sent through.
+ * @param call   The request.
+ *
+ */
+void ipc_profile_call(task_t *caller, phone_t *phone, call_t *call)
+{
+	size_t slot = ipc_profile_slot(caller, phone->iface);
+	stats_ipc_iface_t *prof = &caller->ipc_profile.ifaces[slot];
+
+	prof->calls++;
+	if (call->request_method == IPC_M_DATA_WRITE)
+		prof->bytes += ipc_get_arg2(&call->data);
+
+	call->profiled = true;
+	call->prof_slot = slot;
+	call->prof_start = get_cycle();
+}
+
+/** Account an answer received by the current task.
+ *
+ * @param answer The answer, already processed by the kernel.
+ *
+ */
+void ipc_profile_answer(call_t *answer)
+{
+	if ((!answer->profiled) || (answer->sender != TASK))
+		return;
+
+	uint64_t latency = get_cycle() - answer->prof_start;
+
+	unsigned int bucket = 0;
+	if ((latency >> STATS_IPC_PROF_LATENCY_SHIFT) != 0) {
+		bucket = min(fnzb64(latency) - STATS_IPC_PROF_LATENCY_SHIFT + 1,
+		    STATS_IPC_PROF_LATENCIES - 1);
+	}
+
+	irq_spinlock_lock(&TASK->lock, true);
+
+	stats_ipc_iface_t *prof = &TASK->ipc_profile.ifaces[answer->prof_slot];
+
+	prof->answers++;
+	prof->latency += latency;
+	prof->latencies[bucket]++;
+
+	if ((answer->request_method == IPC_M_DATA_READ) &&
+	    (ipc_get_retval(&answer->data) == EOK))
+		prof->bytes += ipc_get_arg2(&answer->data);
+
+	irq_spinlock_unlock(&TASK->lock, true);
+}
+
+/** Account a syscall of the current task.
+ *
+ * @param id     Syscall number.
+ * @param cycles Cycles spent in the syscall.
+ *
+ */
+void ipc_profile_syscall(sysarg_t id, uint64_t cycles)
+{
+	if (id >= SYSCALL_END)
+		return;
+
+	irq_spinlock_lock(&TASK->lock, true);
+
+	TASK->ipc_profile.syscalls[id].count++;
+	TASK->ipc_profile.syscalls[id].cycles += cycles;
+
+	irq_spinlock_unlock(&TASK->lock, true);
+}
+
+/** @}
+ */
@@ -45,6 +45,7 @@
 #include <ipc/ipcrsc.h>
 #include <ipc/event.h>
 #include <ipc/kbox.h>
+#include <ipc/profile.h>
 #include <synch/waitq.h>
 #include <arch/interrupt.h>
 #include <syscall/copy.h>
@@ -242,6 +243,10 @@ static void process_answer(call_t *call)
 		ipc_set_retval(&call->data, EFORWARD);
 
 	SYSIPC_OP(answer_process, call);
+
+#ifdef CONFIG_IPC_PROFILE
+	ipc_profile_answer(call);
+#endif
 }
 
 /** Do basic kernel processing of received call request.
@@ -636,23 +641,16 @@ sys_errno_t sys_ipc_forward_slow(cap_call_handle_t chandle,
 	    ipc_get_arg4(&newdata), ipc_get_arg5(&newdata), mode, true);
 }
 
-/** Answer an IPC call - fast version.
+/** Answer an IPC call with a payload stored in kernel memory.
  *
- * This function can handle only two return arguments of payload, but is faster
- * than the generic sys_ipc_answer().
- *
- * @param chandle  Call handle to be answered.
- * @param retval   Return value of the answer.
- * @param arg1     Service-defined return value.
- * @param arg2     Service-defined return value.
- * @param arg3     Service-defined return value.
- * @param arg4     Service-defined return value.
+ * @param chandle Call handle to be answered.
+ * @param args    Return value and return arguments of the answer.
  *
  * @return 0 on success, otherwise an error code.
  *
  */
-sys_errno_t sys_ipc_answer_fast(cap_call_handle_t chandle, sysarg_t retval,
-    sysarg_t arg1, sysarg_t arg2, sysarg_t arg3, sysarg_t arg4)
+static errno_t answer_call(cap_call_handle_t chandle,
+    const sysarg_t args[IPC_CALL_LEN])
 {
 	kobject_t *kobj = cap_unpublish(TASK, chandle, KOBJECT_TYPE_CALL);
 	if (!kobj)
@@ -670,17 +668,8 @@ sys_errno_t sys_ipc_answer_fast(cap_call_handle_t chandle, sysarg_t retval,
 	} else
 		saved = false;
 
-	ipc_set_retval(&call->data, retval);
-	ipc_set_arg1(&call->data, arg1);
-	ipc_set_arg2(&call->data, arg2);
-	ipc_set_arg3(&call->data, arg3);
-	ipc_set_arg4(&call->data, arg4);
+	memcpy(call->data.args, args, sizeof(call->data.args));
 
-	/*
-	 * To achieve deterministic behavior, zero out arguments that are beyond
-	 * the limits of the fast version.
-	 */
-	ipc_set_arg5(&call->data, 0);
 	errno_t rc = answer_preprocess(call, saved ? &saved_data : NULL);
 
 	ipc_answer(&TASK->answerbox, call);
@@ -691,6 +680,33 @@ sys_errno_t sys_ipc_answer_fast(cap_call_handle_t chandle, sysarg_t retval,
 	return rc;
 }
 
+/** Answer an IPC call - fast version.
+ *
+ * This function can handle only two return arguments of payload, but is faster
+ * than the generic sys_ipc_answer().
+ *
+ * @param chandle  Call handle to be answered.
+ * @param retval   Return value of the answer.
+ * @param arg1     Service-defined return value.
+ * @param arg2     Service-defined return value.
+ * @param arg3     Service-defined return value.
+ * @param arg4     Service-defined return value.
+ *
+ * @return 0 on success, otherwise an error code.
+ *
+ */
+sys_errno_t sys_ipc_answer_fast(cap_call_handle_t chandle, sysarg_t retval,
+    sysarg_t arg1, sysarg_t arg2, sysarg_t arg3, sysarg_t arg4)
+{
+	/*
+	 * To achieve deterministic behavior, zero out arguments that are beyond
+	 * the limits of the fast version.
+	 */
+	sysarg_t args[IPC_CALL_LEN] = { retval, arg1, arg2, arg3, arg4, 0 };
+
+	return answer_call(chandle, args);
+}
+
 /** Answer an IPC call.
  *
  * @param chandle Call handle to be answered.
@@ -701,40 +717,50 @@ sys_errno_t sys_ipc_answer_fast(cap_call_handle_t chandle, sysarg_t retval,
  */
 sys_errno_t sys_ipc_answer_slow(cap_call_handle_t chandle, uspace_ptr_ipc_data_t data)
 {
-	kobject_t *kobj = cap_unpublish(TASK, chandle, KOBJECT_TYPE_CALL);
-	if (!kobj)
-		return ENOENT;
+	sysarg_t args[IPC_CALL_LEN];
 
-	call_t *call = kobj->call;
-	assert(!(call->flags & IPC_CALL_ANSWERED));
+	errno_t rc = copy_from_uspace(args, data + offsetof(ipc_data_t, args),
+	    sizeof(args));
+	if (rc != EOK)
+		return rc;
 
-	ipc_data_t saved_data;
-	bool saved;
+	return answer_call(chandle, args);
+}
 
-	if (answer_need_old(call)) {
-		memcpy(&saved_data, &call->data, sizeof(call->data));
-		saved = true;
-	} else
-		saved = false;
+/** Answer a batch of IPC calls.
+ *
+ * Each element of the array carries the handle of the call being answered
+ * and the payload of the answer. A failed answer does not prevent the
+ * following ones, but the batch ends at the first element which cannot be
+ * read from userspace.
+ *
+ * @param data  Userspace address of an array of answers.
+ * @param count Number of answers in the array, at most IPC_MAX_BATCH.
+ *
+ * @return 0 on success or the error code of the first failed answer.
+ *
+ */
+sys_errno_t sys_ipc_answer_batch(uspace_ptr_ipc_data_t data, size_t count)
+{
+	if (count > IPC_MAX_BATCH)
+		return EINVAL;
 
-	errno_t rc = copy_from_uspace(&call->data.args, data + offsetof(ipc_data_t, args),
-	    sizeof(call->data.args));
-	if (rc != EOK) {
-		/*
-		 * Republish the capability so that the call does not get lost.
-		 */
-		cap_publish(TASK, chandle, kobj);
-		return rc;
-	}
+	errno_t ret = EOK;
 
-	rc = answer_preprocess(call, saved ? &saved_data : NULL);
+	for (size_t i = 0; i < count; i++) {
+		ipc_data_t answer;
 
-	ipc_answer(&TASK->answerbox, call);
+		errno_t rc = copy_from_uspace(&answer,
+		    data + i * sizeof(ipc_data_t), sizeof(answer));
+		if (rc != EOK)
+			return (ret != EOK) ? ret : rc;
 
-	kobject_put(kobj);
-	cap_free(TASK, chandle);
+		rc = answer_call(answer.cap_handle, answer.args);
+		if ((rc != EOK) && (ret == EOK))
+			ret = rc;
+	}
 
-	return rc;
+	return ret;
 }
 
 /** Hang up a phone.
@@ -865,6 +891,52 @@ error:
 	return rc;
 }
 
+/** Wait for a batch of incoming IPC calls or answers.
+ *
+ * The syscall waits for the first call as sys_ipc_wait_for_call() does
+ * and then collects calls which are already pending without blocking.
+ *
+ * @param calldata Userspace address of an array of call data buffers.
+ * @param count    Number of buffers in the array. At most IPC_MAX_BATCH
+ *                 calls are received.
+ * @param usec     Timeout for the first call. See waitq_sleep_timeout()
+ *                 for explanation.
+ * @param flags    Select mode of sleep operation for the first call. See
+ *                 waitq_sleep_timeout() for explanation.
+ * @param received Userspace address where the number of received calls
+ *                 is stored.
+ *
+ * @return An error code on error.
+ *
+ */
+sys_errno_t sys_ipc_wait_for_calls(uspace_ptr_ipc_data_t calldata, size_t count,
+    uint32_t usec, unsigned int flags, uspace_ptr_size_t received)
+{
+	if (count == 0)
+		return EINVAL;
+
+	if (count > IPC_MAX_BATCH)
+		count = IPC_MAX_BATCH;
+
+	size_t n = 0;
+	errno_t rc = (errno_t) sys_ipc_wait_for_call(calldata, usec, flags);
+
+	while (rc == EOK) {
+		n++;
+		if (n == count)
+			break;
+
+		rc = (errno_t) sys_ipc_wait_for_call(calldata +
+		    n * sizeof(ipc_data_t), SYNCH_NO_TIMEOUT,
+		    flags | SYNCH_FLAGS_NON_BLOCKING);
+	}
+
+	if (n == 0)
+		return rc;
+
+	return copy_to_uspace(received, &n, sizeof(n));
+}
+
 /** Interrupt one thread from sys_ipc_wait_for_call().
  *
  */
@@ -912,6 +984,24 @@ sys_errno_t sys_ipc_irq_unsubscribe(cap_irq_handle_t handle)
 	return 0;
 }
 
+/** Route an IRQ to a CPU.
+ *
+ * @param handle  IRQ capability handle.
+ * @param cpu     CPU ID or IRQ_CPU_ANY.
+ *
+ * @return EPERM
+ * @return Error code returned by ipc_irq_set_affinity().
+ *
+ */
+sys_errno_t sys_ipc_irq_set_affinity(cap_irq_handle_t handle, sysarg_t cpu)
+{
+	if (!(perm_get(TASK) & PERM_IRQ_REG))
+		return EPERM;
+
+	return ipc_irq_set_affinity(&TASK->answerbox, handle,
+	    (unsigned int) cpu);
+}
+
 /** Syscall connect to a task by ID
  *
  * @return Error code.
@@ -54,8 +54,30 @@
 #include <align.h>
 #include <macros.h>
 #include <synch/spinlock.h>
+#include <arch.h>
+#include <config.h>
+#include <cpu.h>
 #include <stdlib.h>
 
+/** Number of quantum cache size classes, from one quantum up. */
+#define RA_QCACHE_CLASSES	4
+
+/** Number of ranges of each size class a quantum cache can hold. */
+#define RA_QCACHE_ROUNDS	16
+
+/** Per-CPU cache of small ranges of an arena
+ *
+ * Allocations of up to RA_QCACHE_CLASSES quanta are served from the cache
+ * of the current CPU without touching the arena. The cache exchanges half
+ * of its rounds with the arena at a time, so that the arena lock is taken
+ * only once per RA_QCACHE_ROUNDS / 2 operations.
+ */
+typedef struct ra_qcache {
+	IRQ_SPINLOCK_DECLARE(lock);
+	size_t count[RA_QCACHE_CLASSES];
+	uintptr_t base[RA_QCACHE_CLASSES][RA_QCACHE_ROUNDS];
+} ra_qcache_t;
+
 static slab_cache_t *ra_segment_cache;
 
 /** Return the hash of the key stored in the item */
@@ -118,6 +140,25 @@ static void ra_segment_destroy(ra_segment_t *seg)
 	slab_free(ra_segment_cache, seg);
 }
 
+/** Put a free segment on the free list matching its current size. */
+static void ra_fl_insert(ra_span_t *span, ra_segment_t *seg)
+{
+	size_t order = fnzb(ra_segment_size_get(seg));
+
+	list_append(&seg->fl_link, &span->free[order]);
+	span->free_map |= (uint64_t) 1 << order;
+}
+
+/** Take a segment off its free list before its size changes. */
+static void ra_fl_remove(ra_span_t *span, ra_segment_t *seg)
+{
+	size_t order = fnzb(ra_segment_size_get(seg));
+
+	list_remove(&seg->fl_link);
+	if (list_empty(&span->free[order]))
+		span->free_map &= ~((uint64_t) 1 << order);
+}
+
 static ra_span_t *ra_span_create(uintptr_t base, size_t size)
 {
 	ra_span_t *span;
@@ -171,6 +212,7 @@ static ra_span_t *ra_span_create(uintptr_t base, size_t size)
 
 	for (i = 0; i <= span->max_order; i++)
 		list_initialize(&span->free[i]);
+	span->free_map = 0;
 
 	/* Insert the first segment into the list of segments. */
 	list_append(&seg->segment_link, &span->segments);
@@ -178,7 +220,7 @@ static ra_span_t *ra_span_create(uintptr_t base, size_t size)
 	list_append(&lastseg->segment_link, &span->segments);
 
 	/* Insert the first segment into the respective free list. */
-	list_append(&seg->fl_link, &span->free[span->max_order]);
+	ra_fl_insert(span, seg);
 
 	return span;
 }
@@ -210,6 +252,8 @@ ra_arena_t *ra_arena_create(void)
 
 	irq_spinlock_initialize(&arena->lock, "arena_lock");
 	list_initialize(&arena->spans);
+	arena->quantum = 0;
+	arena->qcache = NULL;
 
 	return arena;
 }
@@ -226,6 +270,8 @@ void ra_arena_destroy(ra_arena_t *arena)
 		ra_span_destroy(span);
 	}
 
+	if (arena->qcache)
+		free(arena->qcache);
 	free(arena);
 }
 
@@ -256,81 +302,126 @@ ra_span_alloc(ra_span_t *span, size_t size, size_t align, uintptr_t *base)
 	size_t order = ispwr2(needed) ? fnzb(needed) : fnzb(needed) + 1;
 	ra_segment_t *pred = NULL;
 	ra_segment_t *succ = NULL;
+	ra_segment_t *seg;
+	uintptr_t newbase;
+
+	if (order > span->max_order)
+		return false;
 
 	/*
-	 * Find the free list of the smallest order which can satisfy this
-	 * request.
+	 * Every segment on a free list of at least this order can satisfy the
+	 * request, so the smallest such non-empty list is found directly in
+	 * the bitmap.
 	 */
-	for (; order <= span->max_order; order++) {
-		ra_segment_t *seg;
-		uintptr_t newbase;
+	uint64_t avail = span->free_map & ~(((uint64_t) 1 << order) - 1);
+	if (!avail)
+		return false;
+	order = fnzb64(avail & -avail);
 
-		if (list_empty(&span->free[order]))
-			continue;
+	/* Take the first segment from the free list. */
+	seg = list_get_instance(list_first(&span->free[order]), ra_segment_t,
+	    fl_link);
 
-		/* Take the first segment from the free list. */
-		seg = list_get_instance(list_first(&span->free[order]),
-		    ra_segment_t, fl_link);
+	assert(seg->flags & RA_SEGMENT_FREE);
 
-		assert(seg->flags & RA_SEGMENT_FREE);
+	/*
+	 * See if we need to allocate new segments for the chopped-off parts
+	 * of this segment.
+	 */
+	if (!IS_ALIGNED(seg->base, align)) {
+		pred = ra_segment_create(seg->base);
+		if (!pred) {
+			/* Fail as we are unable to split the segment. */
+			return false;
+		}
+		pred->flags |= RA_SEGMENT_FREE;
+	}
+	newbase = ALIGN_UP(seg->base, align);
+	if (newbase + size != seg->base + ra_segment_size_get(seg)) {
+		assert(newbase + (size - 1) < seg->base +
+		    (ra_segment_size_get(seg) - 1));
+		succ = ra_segment_create(newbase + size);
+		if (!succ) {
+			if (pred)
+				ra_segment_destroy(pred);
+			/* Fail as we are unable to split the segment. */
+			return false;
+		}
+		succ->flags |= RA_SEGMENT_FREE;
+	}
 
-		/*
-		 * See if we need to allocate new segments for the chopped-off
-		 * parts of this segment.
-		 */
-		if (!IS_ALIGNED(seg->base, align)) {
+	/* Now remove the found segment from the free list. */
+	ra_fl_remove(span, seg);
+	seg->base = newbase;
+	seg->flags &= ~RA_SEGMENT_FREE;
+
+	/* Put unneeded parts back. */
+	if (pred) {
+		list_insert_before(&pred->segment_link, &seg->segment_link);
+		ra_fl_insert(span, pred);
+	}
+	if (succ) {
+		list_insert_after(&succ->segment_link, &seg->segment_link);
+		ra_fl_insert(span, succ);
+	}
+
+	/* Hash-in the segment into the used hash. */
+	hash_table_insert(&span->used, &seg->uh_link);
+
+	*base = newbase;
+	return true;
+}
+
+static bool ra_span_alloc_at(ra_span_t *span, uintptr_t base, size_t size)
+{
+	ra_segment_t *pred = NULL;
+	ra_segment_t *succ = NULL;
+
+	/*
+	 * Find the free segment which contains the requested range. The
+	 * sentinel at the end of the segment list is never free.
+	 */
+	list_foreach(span->segments, segment_link, ra_segment_t, seg) {
+		if (!(seg->flags & RA_SEGMENT_FREE))
+			continue;
+
+		size_t segsize = ra_segment_size_get(seg);
+		if (!iswithin(seg->base, segsize, base, size))
+			continue;
+
+		if (seg->base != base) {
 			pred = ra_segment_create(seg->base);
-			if (!pred) {
-				/*
-				 * Fail as we are unable to split the segment.
-				 */
-				break;
-			}
+			if (!pred)
+				return false;
 			pred->flags |= RA_SEGMENT_FREE;
 		}
-		newbase = ALIGN_UP(seg->base, align);
-		if (newbase + size != seg->base + ra_segment_size_get(seg)) {
-			assert(newbase + (size - 1) < seg->base +
-			    (ra_segment_size_get(seg) - 1));
-			succ = ra_segment_create(newbase + size);
+		if (base + size != seg->base + segsize) {
+			succ = ra_segment_create(base + size);
 			if (!succ) {
 				if (pred)
 					ra_segment_destroy(pred);
-				/*
-				 * Fail as we are unable to split the segment.
-				 */
-				break;
+				return false;
 			}
 			succ->flags |= RA_SEGMENT_FREE;
 		}
 
+		ra_fl_remove(span, seg);
+		seg->base = base;
+		seg->flags &= ~RA_SEGMENT_FREE;
+
 		/* Put unneeded parts back. */
 		if (pred) {
-			size_t pred_order;
-
 			list_insert_before(&pred->segment_link,
 			    &seg->segment_link);
-			pred_order = fnzb(ra_segment_size_get(pred));
-			list_append(&pred->fl_link, &span->free[pred_order]);
+			ra_fl_insert(span, pred);
 		}
 		if (succ) {
-			size_t succ_order;
-
 			list_insert_after(&succ->segment_link,
 			    &seg->segment_link);
-			succ_order = fnzb(ra_segment_size_get(succ));
-			list_append(&succ->fl_link, &span->free[succ_order]);
+			ra_fl_insert(span, succ);
 		}
 
-		/* Now remove the found segment from the free list. */
-		list_remove(&seg->fl_link);
-		seg->base = newbase;
-		seg->flags &= ~RA_SEGMENT_FREE;
-
-		/* Hash-in the segment into the used hash. */
 		hash_table_insert(&span->used, &seg->uh_link);
-
-		*base = newbase;
 		return true;
 	}
 
@@ -344,7 +435,6 @@ static void ra_span_free(ra_span_t *span, size_t base, size_t size)
 	ra_segment_t *seg;
 	ra_segment_t *pred;
 	ra_segment_t *succ;
-	size_t order;
 
 	/*
 	 * Locate the segment in the used hash table.
@@ -381,7 +471,7 @@ static void ra_span_free(ra_span_t *span, size_t base, size_t size)
 			 * lists, rebase the segment and throw the predecessor
 			 * away.
 			 */
-			list_remove(&pred->fl_link);
+			ra_fl_remove(span, pred);
 			list_remove(&pred->segment_link);
 			seg->base = pred->base;
 			ra_segment_destroy(pred);
@@ -400,15 +490,167 @@ static void ra_span_free(ra_span_t *span, size_t base, size_t size)
 		 * Remove the successor from the free and segment lists
 		 * and throw it away.
 		 */
-		list_remove(&succ->fl_link);
+		ra_fl_remove(span, succ);
 		list_remove(&succ->segment_link);
 		ra_segment_destroy(succ);
 	}
 
 	/* Put the segment on the appropriate free list. */
 	seg->flags |= RA_SEGMENT_FREE;
-	order = fnzb(ra_segment_size_get(seg));
-	list_append(&seg->fl_link, &span->free[order]);
+	ra_fl_insert(span, seg);
+}
+
+/** Allocate resources from the spans of an arena.
+ *
+ * The arena lock must be held.
+ */
+static bool ra_arena_alloc(ra_arena_t *arena, size_t size, size_t alignment,
+    uintptr_t *base)
+{
+	list_foreach(arena->spans, span_link, ra_span_t, span) {
+		if (ra_span_alloc(span, size, alignment, base))
+			return true;
+	}
+
+	return false;
+}
+
+/** Return resources to the spans of an arena.
+ *
+ * The arena lock must be held.
+ */
+static void ra_arena_free(ra_arena_t *arena, uintptr_t base, size_t size)
+{
+	list_foreach(arena->spans, span_link, ra_span_t, span) {
+		if (iswithin(span->base, span->size, base, size)) {
+			ra_span_free(span, base, size);
+			return;
+		}
+	}
+
+	panic("Freeing to wrong arena (base=%" PRIxPTR ", size=%zd).",
+	    base, size);
+}
+
+/** Return the quantum cache size class of a request or -1 if uncached. */
+static int ra_qcache_class(ra_arena_t *arena, size_t size, size_t alignment)
+{
+	if ((!arena->qcache) || (alignment > arena->quantum) ||
+	    (!IS_ALIGNED(size, arena->quantum)) ||
+	    (size > RA_QCACHE_CLASSES * arena->quantum))
+		return -1;
+
+	return (int) (size / arena->quantum) - 1;
+}
+
+/** Allocate a range from the quantum cache of the current CPU. */
+static bool ra_qcache_alloc(ra_arena_t *arena, int class, size_t size,
+    uintptr_t *base)
+{
+	ipl_t ipl = interrupts_disable();
+	ra_qcache_t *qcache = &arena->qcache[CPU->id];
+	irq_spinlock_lock(&qcache->lock, false);
+
+	size_t *count = &qcache->count[class];
+	if (*count == 0) {
+		/* Import half of the rounds at once */
+		irq_spinlock_lock(&arena->lock, false);
+		while ((*count < RA_QCACHE_ROUNDS / 2) &&
+		    (ra_arena_alloc(arena, size, arena->quantum,
+		    &qcache->base[class][*count])))
+			(*count)++;
+		irq_spinlock_unlock(&arena->lock, false);
+	}
+
+	bool success = (*count > 0);
+	if (success)
+		*base = qcache->base[class][--(*count)];
+
+	irq_spinlock_unlock(&qcache->lock, false);
+	interrupts_restore(ipl);
+
+	return success;
+}
+
+/** Return a range to the quantum cache of the current CPU. */
+static void ra_qcache_free(ra_arena_t *arena, int class, size_t size,
+    uintptr_t base)
+{
+	ipl_t ipl = interrupts_disable();
+	ra_qcache_t *qcache = &arena->qcache[CPU->id];
+	irq_spinlock_lock(&qcache->lock, false);
+
+	size_t *count = &qcache->count[class];
+	if (*count == RA_QCACHE_ROUNDS) {
+		/* Give half of the rounds back at once */
+		irq_spinlock_lock(&arena->lock, false);
+		while (*count > RA_QCACHE_ROUNDS / 2)
+			ra_arena_free(arena, qcache->base[class][--(*count)],
+			    size);
+		irq_spinlock_unlock(&arena->lock, false);
+	}
+
+	qcache->base[class][(*count)++] = base;
+
+	irq_spinlock_unlock(&qcache->lock, false);
+	interrupts_restore(ipl);
+}
+
+/** Return all ranges held by the quantum caches to the arena. */
+static void ra_qcache_purge(ra_arena_t *arena)
+{
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		ra_qcache_t *qcache = &arena->qcache[i];
+
+		irq_spinlock_lock(&qcache->lock, true);
+		irq_spinlock_lock(&arena->lock, false);
+
+		for (int class = 0; class < RA_QCACHE_CLASSES; class++) {
+			size_t size = (class + 1) * arena->quantum;
+
+			while (qcache->count[class] > 0) {
+				ra_arena_free(arena, qcache->base[class][
+				    --qcache->count[class]], size);
+			}
+		}
+
+		irq_spinlock_unlock(&arena->lock, false);
+		irq_spinlock_unlock(&qcache->lock, true);
+	}
+}
+
+/** Enable quantum caches of an arena
+ *
+ * Must be called only once the number of CPUs is known. Ranges which are
+ * cached are unavailable to ra_alloc_at().
+ *
+ * @param arena   Arena.
+ * @param quantum Power of two size unit of the cached ranges. Ranges of up
+ *                to RA_QCACHE_CLASSES quanta with alignment not exceeding
+ *                the quantum are cached.
+ *
+ * @return False if there was not enough memory for the caches.
+ */
+bool ra_qcache_enable(ra_arena_t *arena, size_t quantum)
+{
+	assert(ispwr2(quantum));
+
+	ra_qcache_t *qcache = malloc(sizeof(ra_qcache_t) * config.cpu_count);
+	if (!qcache)
+		return false;
+
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		irq_spinlock_initialize(&qcache[i].lock, "ra_qcache_lock");
+		for (int class = 0; class < RA_QCACHE_CLASSES; class++)
+			qcache[i].count[class] = 0;
+	}
+
+	irq_spinlock_lock(&arena->lock, true);
+	arena->quantum = quantum;
+	arena->qcache = qcache;
+	irq_spinlock_unlock(&arena->lock, true);
+
+	return true;
 }
 
 /** Allocate resources from arena. */
@@ -421,32 +663,64 @@ ra_alloc(ra_arena_t *arena, size_t size, size_t alignment, uintptr_t *base)
 	assert(alignment >= 1);
 	assert(ispwr2(alignment));
 
+	int class = ra_qcache_class(arena, size, alignment);
+	if ((class >= 0) && (ra_qcache_alloc(arena, class, size, base)))
+		return true;
+
 	irq_spinlock_lock(&arena->lock, true);
-	list_foreach(arena->spans, span_link, ra_span_t, span) {
-		success = ra_span_alloc(span, size, alignment, base);
-		if (success)
-			break;
-	}
+	success = ra_arena_alloc(arena, size, alignment, base);
 	irq_spinlock_unlock(&arena->lock, true);
 
+	if ((!success) && (arena->qcache)) {
+		/* The missing resources may be held by the quantum caches */
+		ra_qcache_purge(arena);
+
+		irq_spinlock_lock(&arena->lock, true);
+		success = ra_arena_alloc(arena, size, alignment, base);
+		irq_spinlock_unlock(&arena->lock, true);
+	}
+
 	return success;
 }
 
-/* Return resources to arena. */
-void ra_free(ra_arena_t *arena, uintptr_t base, size_t size)
+/** Allocate a specific range of resources from arena.
+ *
+ * @param arena Arena to allocate from.
+ * @param base  Base of the requested range.
+ * @param size  Size of the requested range.
+ *
+ * @return True if the whole range was free and has been allocated.
+ */
+bool ra_alloc_at(ra_arena_t *arena, uintptr_t base, size_t size)
 {
+	bool success = false;
+
+	assert(size >= 1);
+
 	irq_spinlock_lock(&arena->lock, true);
 	list_foreach(arena->spans, span_link, ra_span_t, span) {
 		if (iswithin(span->base, span->size, base, size)) {
-			ra_span_free(span, base, size);
-			irq_spinlock_unlock(&arena->lock, true);
-			return;
+			success = ra_span_alloc_at(span, base, size);
+			break;
 		}
 	}
 	irq_spinlock_unlock(&arena->lock, true);
 
-	panic("Freeing to wrong arena (base=%" PRIxPTR ", size=%zd).",
-	    base, size);
+	return success;
+}
+
+/* Return resources to arena. */
+void ra_free(ra_arena_t *arena, uintptr_t base, size_t size)
+{
+	int class = ra_qcache_class(arena, size, 1);
+	if ((class >= 0) && (IS_ALIGNED(base, arena->quantum))) {
+		ra_qcache_free(arena, class, size, base);
+		return;
+	}
+
+	irq_spinlock_lock(&arena->lock, true);
+	ra_arena_free(arena, base, size);
+	irq_spinlock_unlock(&arena->lock, true);
 }
 
 void ra_init(void)
@@ -53,138 +53,294 @@
 #include <console/console.h>
 #include <abi/log.h>
 #include <stdlib.h>
+#include <cpu.h>
+#include <config.h>
+#include <mem.h>
 
-#define LOG_PAGES    8
-#define LOG_LENGTH   (LOG_PAGES * PAGE_SIZE)
-#define LOG_ENTRY_HEADER_LENGTH (sizeof(size_t) + sizeof(uint32_t))
+#define LOG_PAGES      8
+#define LOG_LENGTH     (LOG_PAGES * PAGE_SIZE)
+#define LOG_CPU_PAGES  4
+#define LOG_CPU_LENGTH (LOG_CPU_PAGES * PAGE_SIZE)
 
-/** Cyclic buffer holding the data for kernel log */
-uint8_t log_buffer[LOG_LENGTH] __attribute__((aligned(PAGE_SIZE)));
+/** Length of the header of a log entry (length, counter, facility, level) */
+#define LOG_ENTRY_HEADER_LENGTH (sizeof(size_t) + 3 * sizeof(uint32_t))
 
-/** Kernel log initialized */
-static atomic_bool log_inited = false;
+/** Maximum length of a log entry including the header
+ *
+ * Entries are limited so that they can always be handed to uspace,
+ * which reads at most PAGE_SIZE bytes at once.
+ */
+#define LOG_ENTRY_LENGTH  PAGE_SIZE
 
-/** Position in the cyclic buffer where the first log entry starts */
-size_t log_start = 0;
+/** Kernel log of a single processor
+ *
+ * Each processor appends entries only to its own cyclic buffer, so loggers
+ * on different processors never contend. The lock is only taken by the
+ * owning processor when an entry is complete and by readers.
+ */
+typedef struct log_cpu {
+	/** Protects the cyclic buffer */
+	IRQ_SPINLOCK_DECLARE(lock);
 
-/** Sum of length of all log entries currently stored in the cyclic buffer */
-size_t log_used = 0;
+	/** Cyclic buffer holding the entries */
+	uint8_t *buffer;
+	size_t length;
 
-/** Log spinlock */
-SPINLOCK_STATIC_INITIALIZE_NAME(log_lock, "log_lock");
+	/** Position in the cyclic buffer where the first log entry starts */
+	size_t start;
 
-/** Overall count of logged messages, which may overflow as needed */
-static uint32_t log_counter = 0;
+	/** Sum of length of all log entries currently stored in the buffer */
+	size_t used;
 
-/** Starting position of the entry currently being written to the log */
-static size_t log_current_start = 0;
+	/** Start of the next entry to be handed to uspace, relative to start */
+	size_t next_for_uspace;
 
-/** Length (including header) of the entry currently being written to the log */
-static size_t log_current_len = 0;
+	/** Entry currently being written, accessed by the owner only */
+	uint8_t entry[LOG_ENTRY_LENGTH];
+	size_t entry_len;
 
-/** Start of the next entry to be handed to uspace starting from log_start */
-static size_t next_for_uspace = 0;
+	/** Interrupt level to restore when the entry is finished */
+	ipl_t ipl;
+} log_cpu_t;
+
+/** Cyclic buffer of the boot processor */
+static uint8_t log_buffer[LOG_LENGTH] __attribute__((aligned(PAGE_SIZE)));
+
+/** Log of the boot processor, also used before the processors are set up */
+static log_cpu_t log_boot = {
+	.lock = IRQ_SPINLOCK_INITIALIZER("log_boot.lock"),
+	.buffer = log_buffer,
+	.length = LOG_LENGTH
+};
+
+/** Kernel log initialized */
+static atomic_bool log_inited = false;
+
+/** Overall count of logged messages, which may overflow as needed
+ *
+ * Entries are numbered while the log of the processor is locked, so
+ * merging the logs of all processors by this number gives the order
+ * in which the entries were finished.
+ */
+static atomic_uint log_counter = 0;
+
+/** A notification was sent and not yet acknowledged by unmasking */
+static atomic_bool log_notified = false;
 
 static void log_update(void *);
 
 /** Initialize kernel logging facility
+ *
+ * The boot processor keeps the log it started with, the other processors
+ * get their own logs.
  *
  */
 void log_init(void)
 {
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		if (&cpus[i] == CPU) {
+			cpus[i].log = &log_boot;
+			continue;
+		}
+
+		log_cpu_t *log = malloc(sizeof(log_cpu_t));
+		uint8_t *buffer = malloc(LOG_CPU_LENGTH);
+		if ((!log) || (!buffer))
+			panic("Cannot allocate kernel log.");
+
+		irq_spinlock_initialize(&log->lock, "log_cpu.lock");
+		log->buffer = buffer;
+		log->length = LOG_CPU_LENGTH;
+		log->start = 0;
+		log->used = 0;
+		log->next_for_uspace = 0;
+		log->entry_len = 0;
+
+		cpus[i].log = log;
+	}
+
 	event_set_unmask_callback(EVENT_KLOG, log_update);
 	atomic_store(&log_inited, true);
 }
 
-static size_t log_copy_from(uint8_t *data, size_t pos, size_t len)
+/** Get the log of the current processor */
+static log_cpu_t *log_cpu(void)
+{
+	if ((CPU) && (CPU->log))
+		return CPU->log;
+
+	return &log_boot;
+}
+
+/** Get the number of processor logs */
+static unsigned int log_cpu_count(void)
+{
+	return atomic_load(&log_inited) ? config.cpu_count : 1;
+}
+
+/** Get the log of a processor
+ *
+ * @param i Index of the processor, less than log_cpu_count().
+ *
+ */
+static log_cpu_t *log_cpu_get(unsigned int i)
 {
-	for (size_t i = 0; i < len; i++, pos = (pos + 1) % LOG_LENGTH) {
-		data[i] = log_buffer[pos];
+	return atomic_load(&log_inited) ? cpus[i].log : &log_boot;
+}
+
+static size_t log_copy_from(log_cpu_t *log, uint8_t *data, size_t pos,
+    size_t len)
+{
+	for (size_t i = 0; i < len; i++, pos = (pos + 1) % log->length) {
+		data[i] = log->buffer[pos];
 	}
 	return pos;
 }
 
-static size_t log_copy_to(const uint8_t *data, size_t pos, size_t len)
+static size_t log_copy_to(log_cpu_t *log, const uint8_t *data, size_t pos,
+    size_t len)
 {
-	for (size_t i = 0; i < len; i++, pos = (pos + 1) % LOG_LENGTH) {
-		log_buffer[pos] = data[i];
+	for (size_t i = 0; i < len; i++, pos = (pos + 1) % log->length) {
+		log->buffer[pos] = data[i];
 	}
 	return pos;
 }
 
 /** Append data to the currently open log entry.
  *
- * This function requires that the log_lock is acquired by the caller.
+ * This function requires that an entry has been started using log_begin().
  */
 static void log_append(const uint8_t *data, size_t len)
 {
-	/* Cap the length so that the entry entirely fits into the buffer */
-	if (len > LOG_LENGTH - log_current_len) {
-		len = LOG_LENGTH - log_current_len;
-	}
+	log_cpu_t *log = log_cpu();
 
-	if (len == 0)
-		return;
+	/* Cap the length so that the entry can be handed to uspace */
+	if (len > LOG_ENTRY_LENGTH - log->entry_len)
+		len = LOG_ENTRY_LENGTH - log->entry_len;
 
-	size_t log_free = LOG_LENGTH - log_used - log_current_len;
+	memcpy(log->entry + log->entry_len, data, len);
+	log->entry_len += len;
+}
+
+/** Store the finished entry in the cyclic buffer.
+ *
+ * This function requires that the lock of the log is held by the caller.
+ */
+static void log_commit(log_cpu_t *log)
+{
+	size_t log_free = log->length - log->used;
 
 	/* Discard older entries to make space, if necessary */
-	while (len > log_free) {
+	while (log->entry_len > log_free) {
 		size_t entry_len;
-		log_copy_from((uint8_t *) &entry_len, log_start, sizeof(size_t));
-		log_start = (log_start + entry_len) % LOG_LENGTH;
-		log_used -= entry_len;
+		log_copy_from(log, (uint8_t *) &entry_len, log->start,
+		    sizeof(size_t));
+		log->start = (log->start + entry_len) % log->length;
+		log->used -= entry_len;
 		log_free += entry_len;
-		next_for_uspace -= entry_len;
+
+		/* Unread entries are lost */
+		if (log->next_for_uspace > entry_len)
+			log->next_for_uspace -= entry_len;
+		else
+			log->next_for_uspace = 0;
 	}
 
-	size_t pos = (log_current_start + log_current_len) % LOG_LENGTH;
-	log_copy_to(data, pos, len);
-	log_current_len += len;
+	size_t pos = (log->start + log->used) % log->length;
+	log_copy_to(log, log->entry, pos, log->entry_len);
+	log->used += log->entry_len;
 }
 
 /** Begin writing an entry to the log.
  *
- * This acquires the log and output buffer locks, so only calls to log_* functions should
+ * This disables interrupts, so only calls to log_* functions should
  * be used until calling log_end.
  */
 void log_begin(log_facility_t fac, log_level_t level)
 {
-	spinlock_lock(&log_lock);
-	spinlock_lock(&kio_lock);
-
-	log_current_start = (log_start + log_used) % LOG_LENGTH;
-	log_current_len = 0;
-
-	/* Write header of the log entry, the length will be written in log_end() */
-	log_append((uint8_t *) &log_current_len, sizeof(size_t));
-	log_append((uint8_t *) &log_counter, sizeof(uint32_t));
+	ipl_t ipl = interrupts_disable();
+	log_cpu_t *log = log_cpu();
+
+	log->ipl = ipl;
+	log->entry_len = 0;
+
+	/*
+	 * Write header of the log entry, the length and the counter will
+	 * be written in log_end()
+	 */
+	size_t len = 0;
+	uint32_t counter = 0;
 	uint32_t fac32 = fac;
 	uint32_t lvl32 = level;
+	log_append((uint8_t *) &len, sizeof(size_t));
+	log_append((uint8_t *) &counter, sizeof(uint32_t));
 	log_append((uint8_t *) &fac32, sizeof(uint32_t));
 	log_append((uint8_t *) &lvl32, sizeof(uint32_t));
-
-	log_counter++;
 }
 
 /** Finish writing an entry to the log.
  *
- * This releases the log and output buffer locks.
+ * This stores the entry, prints it to the output buffer and restores
+ * interrupts.
  */
 void log_end(void)
 {
+	log_cpu_t *log = log_cpu();
+
 	/* Set the length in the header to correct value */
-	log_copy_to((uint8_t *) &log_current_len, log_current_start, sizeof(size_t));
-	log_used += log_current_len;
+	memcpy(log->entry, &log->entry_len, sizeof(size_t));
+
+	irq_spinlock_lock(&log->lock, false);
+
+	uint32_t counter = atomic_fetch_add_explicit(&log_counter, 1,
+	    memory_order_relaxed);
+	memcpy(log->entry + sizeof(size_t), &counter, sizeof(uint32_t));
+	log_commit(log);
+
+	irq_spinlock_unlock(&log->lock, false);
+
+	/* Print the message without the header */
+	size_t offset = LOG_ENTRY_HEADER_LENGTH;
+
+	spinlock_lock(&kio_lock);
+
+	while (offset < log->entry_len) {
+		kio_push_char(str_decode((const char *) log->entry, &offset,
+		    log->entry_len));
+	}
 
 	kio_push_char('\n');
 	spinlock_unlock(&kio_lock);
-	spinlock_unlock(&log_lock);
+
+	interrupts_restore(log->ipl);
 
 	/* This has to be called after we released the locks above */
 	kio_flush();
 	kio_update(NULL);
-	log_update(NULL);
+
+	/* Do not notify again until the notifications are unmasked */
+	if ((atomic_load(&log_inited)) &&
+	    (!atomic_exchange(&log_notified, true))) {
+		if (event_notify_0(EVENT_KLOG, true) != EOK)
+			atomic_store(&log_notified, false);
+	}
+}
+
+/** Check whether there are entries not handed to uspace yet */
+static bool log_unread(void)
+{
+	for (unsigned int i = 0; i < log_cpu_count(); i++) {
+		log_cpu_t *log = log_cpu_get(i);
+
+		irq_spinlock_lock(&log->lock, true);
+		bool unread = (log->next_for_uspace < log->used);
+		irq_spinlock_unlock(&log->lock, true);
+
+		if (unread)
+			return true;
+	}
+
+	return false;
 }
 
 static void log_update(void *event)
@@ -192,10 +348,44 @@ static void log_update(void *event)
 	if (!atomic_load(&log_inited))
 		return;
 
-	spinlock_lock(&log_lock);
-	if (next_for_uspace < log_used)
-		event_notify_0(EVENT_KLOG, true);
-	spinlock_unlock(&log_lock);
+	atomic_store(&log_notified, false);
+
+	if ((log_unread()) && (!atomic_exchange(&log_notified, true))) {
+		if (event_notify_0(EVENT_KLOG, true) != EOK)
+			atomic_store(&log_notified, false);
+	}
+}
+
+/** Find the log with the oldest entry not handed to uspace yet
+ *
+ * The locks of all logs must be held by the caller.
+ *
+ * @return Log or NULL if there are no unread entries.
+ *
+ */
+static log_cpu_t *log_oldest_unread(void)
+{
+	log_cpu_t *oldest = NULL;
+	uint32_t oldest_counter = 0;
+
+	for (unsigned int i = 0; i < log_cpu_count(); i++) {
+		log_cpu_t *log = log_cpu_get(i);
+		if (log->next_for_uspace >= log->used)
+			continue;
+
+		size_t pos = (log->start + log->next_for_uspace + sizeof(size_t)) %
+		    log->length;
+		uint32_t counter;
+		log_copy_from(log, (uint8_t *) &counter, pos, sizeof(uint32_t));
+
+		/* The counter wraps around */
+		if ((!oldest) || ((int32_t) (counter - oldest_counter) < 0)) {
+			oldest = log;
+			oldest_counter = counter;
+		}
+	}
+
+	return oldest;
 }
 
 static int log_printf_str_write(const char *str, size_t size, void *data)
@@ -204,7 +394,7 @@ static int log_printf_str_write(const char *str, size_t size, void *data)
 	size_t chars = 0;
 
 	while (offset < size) {
-		kio_push_char(str_decode(str, &offset, size));
+		str_decode(str, &offset, size);
 		chars++;
 	}
 
@@ -220,8 +410,6 @@ static int log_printf_wstr_write(const char32_t *wstr, size_t size, void *data)
 	size_t chars = 0;
 
 	for (offset = 0; offset < size; offset += sizeof(char32_t), chars++) {
-		kio_push_char(wstr[chars]);
-
 		size_t buffer_offset = 0;
 		errno_t rc = chr_encode(wstr[chars], buffer, &buffer_offset, 16);
 		if (rc != EOK) {
@@ -333,24 +521,18 @@ sys_errno_t sys_klog(sysarg_t operation, uspace_addr_t buf, size_t size,
 
 		rc = EOK;
 
-		spinlock_lock(&log_lock);
-
-		while (next_for_uspace < log_used) {
-			size_t pos = (log_start + next_for_uspace) % LOG_LENGTH;
-			log_copy_from((uint8_t *) &entry_len, pos, sizeof(size_t));
-
-			if (entry_len > PAGE_SIZE) {
-				/*
-				 * Since we limit data transfer
-				 * to uspace to a maximum of PAGE_SIZE
-				 * bytes, skip any entries larger
-				 * than this limit to prevent
-				 * userspace being stuck trying to
-				 * read them.
-				 */
-				next_for_uspace += entry_len;
-				continue;
-			}
+		ipl_t ipl = interrupts_disable();
+
+		for (unsigned int i = 0; i < log_cpu_count(); i++)
+			irq_spinlock_lock(&log_cpu_get(i)->lock, false);
+
+		/* Merge the logs of all processors in the order of the entries */
+		log_cpu_t *log;
+		while ((log = log_oldest_unread()) != NULL) {
+			size_t pos = (log->start + log->next_for_uspace) %
+			    log->length;
+			log_copy_from(log, (uint8_t *) &entry_len, pos,
+			    sizeof(size_t));
 
 			if (size < copied + entry_len) {
 				if (copied == 0)
@@ -358,12 +540,16 @@ sys_errno_t sys_klog(sysarg_t operation, uspace_addr_t buf, size_t size,
 				break;
 			}
 
-			log_copy_from((uint8_t *) (data + copied), pos, entry_len);
+			log_copy_from(log, (uint8_t *) (data + copied), pos,
+			    entry_len);
 			copied += entry_len;
-			next_for_uspace += entry_len;
+			log->next_for_uspace += entry_len;
 		}
 
-		spinlock_unlock(&log_lock);
+		for (unsigned int i = log_cpu_count(); i > 0; i--)
+			irq_spinlock_unlock(&log_cpu_get(i - 1)->lock, false);
+
+		interrupts_restore(ipl);
 
 		if (rc != EOK) {
 			free(data);
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Boot phase timestamps.
+ *
+ * The stamps are exported as boot.phase.<name> in sysinfo. Each value is
+ * the time elapsed since BOOT_PHASE_ENTRY in microseconds if the frequency
+ * of the bootstrap processor's cycle counter is known, or in counter ticks
+ * otherwise. boot.phase.cycle_mhz holds the frequency used for the
+ * conversion (zero if unknown). Phases that were not reached read as zero.
+ */
+
+#include <main/boot_phase.h>
+#include <stdint.h>
+#include <arch/cycle.h>
+#include <cpu.h>
+#include <stdio.h>
+#include <synch/spinlock.h>
+#include <sysinfo/sysinfo.h>
+
+static const char *boot_phase_names[BOOT_PHASE_COUNT] = {
+	[BOOT_PHASE_ENTRY] = "entry",
+	[BOOT_PHASE_MM] = "mm",
+	[BOOT_PHASE_CPU] = "cpu",
+	[BOOT_PHASE_KINIT] = "kinit",
+	[BOOT_PHASE_SMP] = "smp",
+	[BOOT_PHASE_AP_READY] = "ap_ready",
+	[BOOT_PHASE_USPACE] = "uspace",
+	[BOOT_PHASE_DEFERRED] = "deferred"
+};
+
+IRQ_SPINLOCK_STATIC_INITIALIZE_NAME(boot_phase_lock, "boot_phase_lock");
+
+/** Cycle counter values, zero for phases not reached yet */
+static uint64_t boot_phase_cycles[BOOT_PHASE_COUNT];
+
+/** Record that a boot phase was reached.
+ *
+ * Phases marked by several processors keep the stamp of the last caller.
+ *
+ * @param phase Boot phase.
+ */
+void boot_phase_mark(boot_phase_t phase)
+{
+	uint64_t now = get_cycle();
+
+	irq_spinlock_lock(&boot_phase_lock, true);
+	boot_phase_cycles[phase] = now;
+	irq_spinlock_unlock(&boot_phase_lock, true);
+}
+
+static unsigned int boot_phase_mhz(void)
+{
+	return (cpus != NULL) ? cpus[0].frequency_mhz : 0;
+}
+
+static sysarg_t boot_phase_get(sysinfo_item_t *item, void *data)
+{
+	boot_phase_t phase = (boot_phase_t) (uintptr_t) data;
+
+	irq_spinlock_lock(&boot_phase_lock, true);
+	uint64_t entry = boot_phase_cycles[BOOT_PHASE_ENTRY];
+	uint64_t stamp = boot_phase_cycles[phase];
+	irq_spinlock_unlock(&boot_phase_lock, true);
+
+	if ((stamp == 0) || (stamp < entry))
+		return 0;
+
+	uint64_t elapsed = stamp - entry;
+	unsigned int mhz = boot_phase_mhz();
+	if (mhz != 0)
+		elapsed /= mhz;
+
+	return (sysarg_t) elapsed;
+}
+
+static sysarg_t boot_phase_get_mhz(sysinfo_item_t *item, void *data)
+{
+	return boot_phase_mhz();
+}
+
+/** Export boot phase stamps in sysinfo. */
+void boot_phase_init(void)
+{
+	char name[32];
+
+	for (unsigned int i = 0; i < BOOT_PHASE_COUNT; i++) {
+		snprintf(name, sizeof(name), "boot.phase.%s",
+		    boot_phase_names[i]);
+		sysinfo_set_item_gen_val(name, NULL, boot_phase_get,
+		    (void *) (uintptr_t) i);
+	}
+
+	sysinfo_set_item_gen_val("boot.phase.cycle_mhz", NULL,
+	    boot_phase_get_mhz, NULL);
+}
+
+/** @}
+ */
@@ -43,6 +43,7 @@
 
 #include <assert.h>
 #include <main/kinit.h>
+#include <main/boot_phase.h>
 #include <config.h>
 #include <arch.h>
 #include <proc/scheduler.h>
@@ -58,6 +59,7 @@
 #include <mm/as.h>
 #include <mm/frame.h>
 #include <mm/km.h>
+#include <mm/zero.h>
 #include <stdio.h>
 #include <log.h>
 #include <mem.h>
@@ -77,6 +79,7 @@
 #include <smp/smp.h>
 #endif /* CONFIG_SMP */
 
+#include <synch/rcu.h>
 #include <synch/waitq.h>
 #include <synch/spinlock.h>
 
@@ -89,6 +92,87 @@ static char alive[ALIVE_CHARS] = "-\\|/";
 #define INIT_PREFIX      "init:"
 #define INIT_PREFIX_LEN  5
 
+#ifdef CONFIG_SMP
+
+/** Create load balancing threads for all CPUs which are not isolated. */
+static void kinit_kcpulb(void)
+{
+	if (config.cpu_count < 2)
+		return;
+
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		if (cpus[i].isolated)
+			continue;
+
+		thread_t *thread = thread_create(kcpulb, NULL, TASK,
+		    THREAD_FLAG_UNCOUNTED, "kcpulb");
+		if (thread != NULL) {
+			thread_wire(thread, &cpus[i]);
+			thread_ready(thread);
+		} else
+			log(LF_OTHER, LVL_ERROR,
+			    "Unable to create kcpulb thread for cpu%u", i);
+	}
+}
+
+#endif /* CONFIG_SMP */
+
+/** Start thread computing system load. */
+static void kinit_kload(void)
+{
+	thread_t *thread = thread_create(kload, NULL, TASK, THREAD_FLAG_NONE,
+	    "kload");
+	if (thread != NULL)
+		thread_ready(thread);
+	else
+		log(LF_OTHER, LVL_ERROR, "Unable to create kload thread");
+}
+
+/** Start thread preparing zeroed frames for anonymous memory. */
+static void kinit_kzero(void)
+{
+	thread_t *thread = thread_create(kzero, NULL, TASK, THREAD_FLAG_NONE,
+	    "kzero");
+	if (thread != NULL)
+		thread_ready(thread);
+	else
+		log(LF_OTHER, LVL_ERROR, "Unable to create kzero thread");
+}
+
+#ifdef CONFIG_KCONSOLE
+
+/** Create kernel console. */
+static void kinit_kconsole(void)
+{
+	if (!stdin)
+		return;
+
+	thread_t *thread = thread_create(kconsole_thread, NULL, TASK,
+	    THREAD_FLAG_NONE, "kconsole");
+	if (thread != NULL)
+		thread_ready(thread);
+	else
+		log(LF_OTHER, LVL_ERROR, "Unable to create kconsole thread");
+}
+
+#endif /* CONFIG_KCONSOLE */
+
+/** Initialization deferred until the init tasks are running.
+ *
+ * Nothing the init tasks depend on may be listed here. The items run in
+ * order in the kinit thread right after the init tasks are started.
+ */
+static void (*const kinit_deferred[])(void) = {
+#ifdef CONFIG_SMP
+	kinit_kcpulb,
+#endif
+	kinit_kload,
+	kinit_kzero,
+#ifdef CONFIG_KCONSOLE
+	kinit_kconsole,
+#endif
+};
+
 /** Kernel initialization thread.
  *
  * kinit takes care of higher level kernel
@@ -101,6 +185,7 @@ void kinit(void *arg)
 {
 	thread_t *thread;
 
+	boot_phase_mark(BOOT_PHASE_KINIT);
 	interrupts_disable();
 
 #ifdef CONFIG_SMP
@@ -109,9 +194,10 @@ void kinit(void *arg)
 
 		/*
 		 * Create the kmp thread and wait for its completion.
-		 * cpu1 through cpuN-1 will come up consecutively and
-		 * not mess together with kcpulb threads.
-		 * Just a beautification.
+		 * kmp starts cpu1 through cpuN-1 one after another, but
+		 * only waits for each of them to leave the shared boot
+		 * stack. The rest of their initialization proceeds in
+		 * parallel.
 		 */
 		thread = thread_create(kmp, NULL, TASK,
 		    THREAD_FLAG_UNCOUNTED, "kmp");
@@ -122,52 +208,24 @@ void kinit(void *arg)
 		thread_ready(thread_ref(thread));
 		thread_join(thread);
 		thread_put(thread);
-
-		/*
-		 * For each CPU, create its load balancing thread.
-		 */
-		unsigned int i;
-
-		for (i = 0; i < config.cpu_count; i++) {
-			thread = thread_create(kcpulb, NULL, TASK,
-			    THREAD_FLAG_UNCOUNTED, "kcpulb");
-			if (thread != NULL) {
-				thread_wire(thread, &cpus[i]);
-				thread_ready(thread);
-			} else
-				log(LF_OTHER, LVL_ERROR,
-				    "Unable to create kcpulb thread for cpu%u", i);
-		}
 	}
 #endif /* CONFIG_SMP */
 
+	boot_phase_mark(BOOT_PHASE_SMP);
+
 	/*
 	 * At this point SMP, if present, is configured.
 	 */
 	ARCH_OP(post_smp_init);
 
-	/* Start thread computing system load */
-	thread = thread_create(kload, NULL, TASK, THREAD_FLAG_NONE,
-	    "kload");
-	if (thread != NULL)
-		thread_ready(thread);
-	else
-		log(LF_OTHER, LVL_ERROR, "Unable to create kload thread");
+	/* Start thread running RCU callbacks */
+	thread = thread_create(krcu, NULL, TASK, THREAD_FLAG_NONE, "krcu");
+	if (thread == NULL)
+		panic("Unable to create krcu thread.");
+	thread_ready(thread);
 
-#ifdef CONFIG_KCONSOLE
-	if (stdin) {
-		/*
-		 * Create kernel console.
-		 */
-		thread = thread_create(kconsole_thread, NULL, TASK,
-		    THREAD_FLAG_NONE, "kconsole");
-		if (thread != NULL)
-			thread_ready(thread);
-		else
-			log(LF_OTHER, LVL_ERROR,
-			    "Unable to create kconsole thread");
-	}
-#endif /* CONFIG_KCONSOLE */
+	/* The pool is empty until kzero is started. */
+	zero_pool_init();
 
 	/*
 	 * Store the default stack size in sysinfo so that uspace can create
@@ -264,7 +322,7 @@ void kinit(void *arg)
 			 */
 			perm_set(programs[i].task,
 			    PERM_PERM | PERM_MEM_MANAGER |
-			    PERM_IO_MANAGER | PERM_IRQ_REG);
+			    PERM_IO_MANAGER | PERM_IRQ_REG | PERM_SCHED);
 
 			if (!ipc_box_0) {
 				ipc_box_0 = &programs[i].task->answerbox;
@@ -298,6 +356,13 @@ void kinit(void *arg)
 			program_ready(&programs[i]);
 	}
 
+	boot_phase_mark(BOOT_PHASE_USPACE);
+
+	for (i = 0; i < sizeof(kinit_deferred) / sizeof(kinit_deferred[0]); i++)
+		kinit_deferred[i]();
+
+	boot_phase_mark(BOOT_PHASE_DEFERRED);
+
 #ifdef CONFIG_KCONSOLE
 	if (!stdin) {
 		thread_sleep(10);
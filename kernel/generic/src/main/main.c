@@ -58,6 +58,8 @@
 #include <proc/scheduler.h>
 #include <proc/thread.h>
 #include <proc/task.h>
+#include <proc/cpuset.h>
+#include <main/boot_phase.h>
 #include <main/kinit.h>
 #include <main/version.h>
 #include <console/kconsole.h>
@@ -77,6 +79,8 @@
 #include <mm/reserve.h>
 #include <synch/waitq.h>
 #include <synch/syswaitq.h>
+#include <synch/lockstat.h>
+#include <synch/rcu.h>
 #include <arch/arch.h>
 #include <arch.h>
 #include <arch/faddr.h>
@@ -88,6 +92,8 @@
 #include <ipc/event.h>
 #include <sysinfo/sysinfo.h>
 #include <sysinfo/stats.h>
+#include <prof.h>
+#include <security/entropy.h>
 #include <lib/ra.h>
 #include <cap/cap.h>
 
@@ -216,6 +222,7 @@ void main_bsp_separated_stack(void)
 {
 	/* Keep this the first thing. */
 	current_initialize(CURRENT);
+	boot_phase_mark(BOOT_PHASE_ENTRY);
 
 	version_print();
 
@@ -256,11 +263,13 @@ void main_bsp_separated_stack(void)
 	ddi_init();
 	ARCH_OP(post_mm_init);
 	reserve_init();
+	boot_phase_mark(BOOT_PHASE_MM);
 	ARCH_OP(pre_smp_init);
 	smp_init();
 
 	/* Slab must be initialized after we know the number of processors. */
 	slab_enable_cpucache();
+	km_enable_cpucache();
 
 	uint64_t size;
 	const char *size_suffix;
@@ -269,8 +278,14 @@ void main_bsp_separated_stack(void)
 	    config.cpu_count, size, size_suffix);
 
 	cpu_init();
+	cpuset_init();
+	rcu_init();
+#ifdef CONFIG_LOCKSTAT
+	lockstat_init();
+#endif
 	calibrate_delay_loop();
 	ARCH_OP(post_cpu_init);
+	boot_phase_mark(BOOT_PHASE_CPU);
 
 	clock_counter_init();
 	timeout_init();
@@ -295,6 +310,11 @@ void main_bsp_separated_stack(void)
 	kio_init();
 	log_init();
 	stats_init();
+	boot_phase_init();
+	entropy_init();
+#ifdef CONFIG_PROFILER
+	prof_init();
+#endif
 
 	/*
 	 * Create kernel task.
@@ -353,8 +373,6 @@ void main_ap(void)
 	ARCH_OP(post_mm_init);
 
 	cpu_init();
-	calibrate_delay_loop();
-	ARCH_OP(post_cpu_init);
 
 	current_copy(CURRENT, (current_t *) CPU->stack);
 
@@ -362,6 +380,8 @@ void main_ap(void)
 	 * If we woke kmp up before we left the kernel stack, we could
 	 * collide with another CPU coming up. To prevent this, we
 	 * switch to this cpu's private stack prior to waking kmp up.
+	 * The rest of the initialization does not touch any state shared
+	 * with the next CPU and runs in parallel with its startup.
 	 */
 	context_t ctx;
 	context_save(&ctx);
@@ -378,12 +398,18 @@ void main_ap(void)
  */
 void main_ap_separated_stack(void)
 {
+	/* Let kmp start the next CPU. */
+	semaphore_up(&ap_completion_semaphore);
+
+	calibrate_delay_loop();
+	ARCH_OP(post_cpu_init);
+
 	/*
 	 * Configure timeouts for this cpu.
 	 */
 	timeout_init();
 
-	semaphore_up(&ap_completion_semaphore);
+	boot_phase_mark(BOOT_PHASE_AP_READY);
 	scheduler();
 	/* not reached */
 }
@@ -51,8 +51,11 @@
 #include <arch/mm/as.h>
 #include <mm/page.h>
 #include <mm/frame.h>
+#include <mm/km.h>
+#include <mm/reserve.h>
 #include <mm/slab.h>
 #include <mm/tlb.h>
+#include <cpu/cpu_mask.h>
 #include <arch/mm/page.h>
 #include <genarch/mm/page_pt.h>
 #include <genarch/mm/page_ht.h>
@@ -183,6 +186,20 @@ as_t *as_create(unsigned int flags)
 
 	refcount_init(&as->refcount);
 	as->cpu_refcount = 0;
+	as->large_pages = 0;
+	as->page_faults = 0;
+	as->fault_around = 0;
+
+	/*
+	 * Without the mask, TLB shootdowns of this address space are
+	 * simply broadcast.
+	 */
+	as->tlb_cpus = NULL;
+	if (!(flags & FLAG_AS_KERNEL)) {
+		as->tlb_cpus = malloc(cpu_mask_size());
+		if (as->tlb_cpus)
+			cpu_mask_none(as->tlb_cpus);
+	}
 
 #ifdef AS_PAGE_TABLE
 	as->genarch.page_table = page_table_create(flags);
@@ -246,6 +263,15 @@ retry:
 	spinlock_unlock(&asidlock);
 	interrupts_restore(ipl);
 
+	/*
+	 * The address space is not installed anywhere and its ASID, if any,
+	 * has been released and will be purged from all TLBs before reuse.
+	 * No processor needs to be notified about the destruction of its
+	 * mappings then. Nobody else can access the mask any more.
+	 */
+	if (as->tlb_cpus)
+		cpu_mask_none(as->tlb_cpus);
+
 	/*
 	 * Destroy address space areas of the address space.
 	 * Need to start from the beginning each time since we are destroying
@@ -269,6 +295,7 @@ retry:
 	page_table_destroy(NULL);
 #endif
 
+	free(as->tlb_cpus);
 	slab_free(as_cache, as);
 }
 
@@ -467,6 +494,7 @@ _NO_TRACE static bool check_area_conflicts(as_t *as, uintptr_t addr,
  * @param as      Address space.
  * @param bound   Lowest address bound.
  * @param size    Requested size of the allocation.
+ * @param align   Required alignment of the allocation (at least PAGE_SIZE).
  * @param guarded True if the allocation must be protected by guard pages.
  *
  * @return Address of the beginning of unmapped address space area.
@@ -474,7 +502,7 @@ _NO_TRACE static bool check_area_conflicts(as_t *as, uintptr_t addr,
  *
  */
 _NO_TRACE static uintptr_t as_get_unmapped_area(as_t *as, uintptr_t bound,
-    size_t size, bool guarded)
+    size_t size, size_t align, bool guarded)
 {
 	assert(mutex_locked(&as->lock));
 
@@ -505,7 +533,9 @@ _NO_TRACE static uintptr_t as_get_unmapped_area(as_t *as, uintptr_t bound,
 			addr += P2SZ(1);
 		}
 
-		if (check_area_conflicts(as, addr, pages, guarded, NULL))
+		addr = ALIGN_UP(addr, align);
+		if ((addr >= bound) &&
+		    (check_area_conflicts(as, addr, pages, guarded, NULL)))
 			return addr;
 	}
 
@@ -524,6 +554,8 @@ _NO_TRACE static uintptr_t as_get_unmapped_area(as_t *as, uintptr_t bound,
 			addr += P2SZ(1);
 		}
 
+		addr = ALIGN_UP(addr, align);
+
 		bool avail =
 		    ((addr >= bound) && (addr >= area->base) &&
 		    (check_area_conflicts(as, addr, pages, guarded, area)));
@@ -758,10 +790,19 @@ as_area_t *as_area_create(as_t *as, unsigned int flags, size_t size,
 
 	bool const guarded = flags & AS_AREA_GUARD;
 
+	/*
+	 * Areas which want large pages must be placed so that at least
+	 * some of their pages can be large.
+	 */
+	size_t align = PAGE_SIZE;
+	if ((flags & AS_AREA_LARGE_PAGES) && (page_large_size() > 0) &&
+	    (size >= page_large_size()))
+		align = page_large_size();
+
 	mutex_lock(&as->lock);
 
 	if (*base == (uintptr_t) AS_AREA_ANY) {
-		*base = as_get_unmapped_area(as, bound, size, guarded);
+		*base = as_get_unmapped_area(as, bound, size, align, guarded);
 		if (*base == (uintptr_t) -1) {
 			mutex_unlock(&as->lock);
 			return NULL;
@@ -954,8 +995,8 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 		 * Start TLB shootdown sequence.
 		 */
 
-		ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES,
-		    as->asid, area->base + P2SZ(pages),
+		ipl_t ipl = tlb_shootdown_start_as(as,
+		    TLB_INVL_PAGES, area->base + P2SZ(pages),
 		    area->pages - pages);
 
 		/*
@@ -1104,7 +1145,7 @@ errno_t as_area_destroy(as_t *as, uintptr_t address)
 	/*
 	 * Start TLB shootdown sequence.
 	 */
-	ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES, as->asid, area->base,
+	ipl_t ipl = tlb_shootdown_start_as(as, TLB_INVL_PAGES, area->base,
 	    area->pages);
 
 	/*
@@ -1346,6 +1387,264 @@ _NO_TRACE static unsigned int area_flags_to_page_flags(unsigned int aflags)
 	return flags;
 }
 
+/** Clone an address space area shared by its backend.
+ *
+ * The source address space and area must be already locked.
+ *
+ * @param area Source address space area.
+ * @param dst  Destination address space.
+ *
+ * @return Zero on success or a value from @ref errno.h on failure.
+ */
+static errno_t as_area_clone_shared(as_area_t *area, as_t *dst)
+{
+	if (!area->backend->is_shareable(area))
+		return ENOTSUP;
+
+	share_info_t *sh_info = area->sh_info;
+
+	mutex_lock(&sh_info->lock);
+	sh_info->refcount++;
+	bool shared = sh_info->shared;
+	sh_info->shared = true;
+	mutex_unlock(&sh_info->lock);
+
+	if (!shared)
+		area->backend->share(area);
+
+	uintptr_t base = area->base;
+	as_area_t *dst_area = as_area_create(dst, area->flags,
+	    P2SZ(area->pages), AS_AREA_ATTR_PARTIAL, area->backend,
+	    &area->backend_data, &base, 0);
+	if (!dst_area) {
+		sh_info_remove_reference(sh_info);
+		return ENOMEM;
+	}
+
+	mutex_lock(&dst->lock);
+	mutex_lock(&dst_area->lock);
+	dst_area->attributes &= ~AS_AREA_ATTR_PARTIAL;
+	dst_area->sh_info = sh_info;
+	mutex_unlock(&dst_area->lock);
+	mutex_unlock(&dst->lock);
+
+	return EOK;
+}
+
+/** Clone a private address space area copy-on-write.
+ *
+ * The frames of all used pages are referenced from both areas. If the area
+ * is writable, the pages are mapped read-only in both address spaces and the
+ * first write to a page gives the writer its own copy of the frame.
+ *
+ * The source address space and area must be already locked.
+ *
+ * @param area Source address space area.
+ * @param dst  Destination address space.
+ *
+ * @return Zero on success or a value from @ref errno.h on failure.
+ */
+static errno_t as_area_clone_private(as_area_t *area, as_t *dst)
+{
+	as_t *src = area->as;
+	bool writable = area->flags & AS_AREA_WRITE;
+	unsigned int page_flags = area_flags_to_page_flags(area->flags) &
+	    ~PAGE_WRITE;
+
+	uintptr_t base = area->base;
+	as_area_t *dst_area = as_area_create(dst, area->flags,
+	    P2SZ(area->pages), AS_AREA_ATTR_NONE, area->backend,
+	    &area->backend_data, &base, 0);
+	if (!dst_area)
+		return ENOMEM;
+
+	size_t pages = area->used_space.pages;
+	if (pages == 0)
+		return EOK;
+
+	/* An array for storing frame numbers */
+	uintptr_t *frames = malloc(pages * sizeof(uintptr_t));
+	if (!frames)
+		return ENOMEM;
+
+	page_table_lock(src, false);
+
+	/*
+	 * The pages of a writable area must not be written to through the
+	 * old mappings once the frames are shared.
+	 */
+	ipl_t ipl = 0;
+	if (writable) {
+		ipl = tlb_shootdown_start_as(src, TLB_INVL_PAGES, area->base,
+		    area->pages);
+	}
+
+	size_t frame_idx = 0;
+
+	used_space_ival_t *ival = used_space_first(&area->used_space);
+	while (ival != NULL) {
+		for (size_t i = 0; i < ival->count; i++) {
+			pte_t pte;
+			bool found = page_mapping_find(src,
+			    ival->page + P2SZ(i), false, &pte);
+
+			(void) found;
+			assert(found);
+			assert(PTE_VALID(&pte));
+			assert(PTE_PRESENT(&pte));
+
+			frames[frame_idx++] = PTE_GET_FRAME(&pte);
+
+			if (writable)
+				page_mapping_remove(src, ival->page + P2SZ(i));
+		}
+
+		ival = used_space_next(ival);
+	}
+
+	if (writable) {
+		tlb_invalidate_pages(src->asid, area->base, area->pages);
+		as_invalidate_translation_cache(src, area->base, area->pages);
+		tlb_shootdown_finalize(ipl);
+	}
+
+	mutex_lock(&dst->lock);
+	mutex_lock(&dst_area->lock);
+	page_table_lock(dst, false);
+
+	frame_idx = 0;
+
+	ival = used_space_first(&area->used_space);
+	while (ival != NULL) {
+		for (size_t i = 0; i < ival->count; i++) {
+			uintptr_t page = ival->page + P2SZ(i);
+			uintptr_t frame = frames[frame_idx++];
+
+			frame_reference_add(ADDR2PFN(frame));
+
+			if (writable) {
+				page_mapping_insert(src, page, frame,
+				    page_flags);
+			}
+			page_mapping_insert(dst, page, frame, page_flags);
+		}
+
+		if (!used_space_insert(&dst_area->used_space, ival->page,
+		    ival->count))
+			panic("Cannot insert used space.");
+
+		ival = used_space_next(ival);
+	}
+
+	page_table_unlock(dst, false);
+	mutex_unlock(&dst_area->lock);
+	mutex_unlock(&dst->lock);
+
+	page_table_unlock(src, false);
+
+	free(frames);
+	return EOK;
+}
+
+/** Clone an address space.
+ *
+ * Private anonymous areas and writable areas backed by an ELF image are
+ * cloned copy-on-write. All other areas, e.g. read-only ELF segments, are
+ * shared with the clone in the same way as_area_share() would share them.
+ *
+ * @param src Address space to be cloned.
+ * @param dst Address space without any address space areas. It is not
+ *            cleaned up on failure, which is left to its destruction.
+ *
+ * @return Zero on success or a value from @ref errno.h on failure.
+ *
+ */
+errno_t as_clone(as_t *src, as_t *dst)
+{
+	errno_t rc = EOK;
+
+	mutex_lock(&src->lock);
+
+	as_area_t *area = as_area_first(src);
+	while ((area != NULL) && (rc == EOK)) {
+		mutex_lock(&area->lock);
+
+		if (!area->backend) {
+			rc = ENOTSUP;
+		} else {
+			mutex_lock(&area->sh_info->lock);
+			bool shared = area->sh_info->shared;
+			mutex_unlock(&area->sh_info->lock);
+
+			if (!shared && ((area->backend == &anon_backend) ||
+			    ((area->backend == &elf_backend) &&
+			    (area->flags & AS_AREA_WRITE))))
+				rc = as_area_clone_private(area, dst);
+			else
+				rc = as_area_clone_shared(area, dst);
+		}
+
+		mutex_unlock(&area->lock);
+		area = as_area_next(area);
+	}
+
+	mutex_unlock(&src->lock);
+
+	return rc;
+}
+
+/** Resolve a copy-on-write mapping of a page.
+ *
+ * If the frame mapped at @a page is still referenced from a clone of the
+ * address space, its contents are copied to a new frame. The page is then
+ * mapped with the full access rights of the area.
+ *
+ * The address space area and page tables must be already locked.
+ *
+ * @param area  Address space area containing the page.
+ * @param page  Virtual page mapped read-only.
+ * @param frame Frame currently mapped at @a page. Updated to the frame
+ *              which is mapped there on return.
+ *
+ * @return False if memory for the copy could not be reserved.
+ *
+ */
+bool as_page_cow_break(as_area_t *area, uintptr_t page, uintptr_t *frame)
+{
+	as_t *as = area->as;
+	uintptr_t old_frame = *frame;
+
+	assert(page_table_locked(as));
+	assert(mutex_locked(&area->lock));
+
+	if (frame_reference_count(ADDR2PFN(old_frame)) > 1) {
+		if ((area->flags & AS_AREA_LATE_RESERVE) &&
+		    !reserve_try_alloc(1))
+			return false;
+
+		uintptr_t src = km_map(old_frame, PAGE_SIZE, PAGE_SIZE,
+		    PAGE_READ | PAGE_CACHEABLE);
+		uintptr_t dst = km_temporary_page_get(frame, FRAME_NO_RESERVE);
+		memcpy((void *) dst, (void *) src, PAGE_SIZE);
+		km_temporary_page_put(dst);
+		km_unmap(src, PAGE_SIZE);
+	}
+
+	ipl_t ipl = tlb_shootdown_start_as(as, TLB_INVL_PAGES, page, 1);
+	page_mapping_remove(as, page);
+	tlb_invalidate_pages(as->asid, page, 1);
+	as_invalidate_translation_cache(as, page, 1);
+	tlb_shootdown_finalize(ipl);
+
+	page_mapping_insert(as, page, *frame,
+	    area_flags_to_page_flags(area->flags));
+
+	if (*frame != old_frame)
+		area->backend->frame_free(area, page, old_frame);
+
+	return true;
+}
+
 /** Change address space area flags.
  *
  * The idea is to have the same data, but with a different access mode.
@@ -1404,7 +1703,7 @@ errno_t as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 	/*
 	 * Start TLB shootdown sequence.
 	 */
-	ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES, as->asid, area->base,
+	ipl_t ipl = tlb_shootdown_start_as(as, TLB_INVL_PAGES, area->base,
 	    area->pages);
 
 	/*
@@ -1472,9 +1771,18 @@ errno_t as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 		for (size = 0; size < ival->count; size++) {
 			page_table_lock(as, false);
 
-			/* Insert the new mapping */
-			page_mapping_insert(as, ptr + P2SZ(size),
-			    old_frame[frame_idx++], page_flags);
+			/*
+			 * Insert the new mapping. Frames shared with a clone
+			 * of the address space stay copy-on-write.
+			 */
+			uintptr_t frame = old_frame[frame_idx++];
+			unsigned int pflags = page_flags;
+			if ((pflags & PAGE_WRITE) &&
+			    (frame_reference_count(ADDR2PFN(frame)) > 1))
+				pflags &= ~PAGE_WRITE;
+
+			page_mapping_insert(as, ptr + P2SZ(size), frame,
+			    pflags);
 
 			page_table_unlock(as, false);
 		}
@@ -1490,35 +1798,24 @@ errno_t as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 	return 0;
 }
 
-/** Handle page fault within the current address space.
- *
- * This is the high-level page fault handler. It decides whether the page fault
- * can be resolved by any backend and if so, it invokes the backend to resolve
- * the page fault.
+/** Resolve a page fault within the current address space.
  *
- * Interrupts are assumed disabled.
+ * @param page   Faulting page.
+ * @param access Access mode that caused the page fault.
  *
- * @param address Faulting address.
- * @param access  Access mode that caused the page fault (i.e.
- *                read/write/exec).
- * @param istate  Pointer to the interrupted state.
- *
- * @return AS_PF_FAULT on page fault.
- * @return AS_PF_OK on success.
- * @return AS_PF_DEFER if the fault was caused by copy_to_uspace()
- *         or copy_from_uspace().
+ * @return AS_PF_OK if the page has been mapped, AS_PF_FAULT or
+ *         AS_PF_SILENT otherwise.
  *
  */
-int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
+static int as_page_fault_resolve(uintptr_t page, pf_access_t access)
 {
-	uintptr_t page = ALIGN_DOWN(address, PAGE_SIZE);
-	int rc = AS_PF_FAULT;
+	int rc;
 
 	if (!THREAD)
-		goto page_fault;
+		return AS_PF_FAULT;
 
 	if (!AS)
-		goto page_fault;
+		return AS_PF_FAULT;
 
 	mutex_lock(&AS->lock);
 	as_area_t *area = find_area_and_lock(AS, page);
@@ -1528,7 +1825,7 @@ int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
 		 * Signal page fault to low-level handler.
 		 */
 		mutex_unlock(&AS->lock);
-		goto page_fault;
+		return AS_PF_FAULT;
 	}
 
 	if (area->attributes & AS_AREA_ATTR_PARTIAL) {
@@ -1538,7 +1835,7 @@ int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
 		 */
 		mutex_unlock(&area->lock);
 		mutex_unlock(&AS->lock);
-		goto page_fault;
+		return AS_PF_FAULT;
 	}
 
 	if ((!area->backend) || (!area->backend->page_fault)) {
@@ -1548,7 +1845,7 @@ int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
 		 */
 		mutex_unlock(&area->lock);
 		mutex_unlock(&AS->lock);
-		goto page_fault;
+		return AS_PF_FAULT;
 	}
 
 	page_table_lock(AS, false);
@@ -1571,22 +1868,106 @@ int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
 	}
 
 	/*
-	 * Resort to the backend page fault handler.
+	 * A present read-only page of a writable private area is shared
+	 * copy-on-write with a clone of the address space. Otherwise, resort
+	 * to the backend page fault handler.
 	 */
-	rc = area->backend->page_fault(area, page, access);
-	if (rc != AS_PF_OK) {
-		page_table_unlock(AS, false);
-		mutex_unlock(&area->lock);
-		mutex_unlock(&AS->lock);
-		goto page_fault;
+	bool cow = false;
+	if (found && PTE_PRESENT(&pte) && (access == PF_ACCESS_WRITE) &&
+	    as_area_check_access(area, access)) {
+		mutex_lock(&area->sh_info->lock);
+		cow = !area->sh_info->shared;
+		mutex_unlock(&area->sh_info->lock);
 	}
 
+	if (cow) {
+		uintptr_t frame = PTE_GET_FRAME(&pte);
+		rc = as_page_cow_break(area, page, &frame) ? AS_PF_OK :
+		    AS_PF_SILENT;
+	} else {
+		rc = area->backend->page_fault(area, page, access);
+	}
+
+	if (rc == AS_PF_OK)
+		AS->page_faults++;
+
 	page_table_unlock(AS, false);
 	mutex_unlock(&area->lock);
 	mutex_unlock(&AS->lock);
-	return AS_PF_OK;
+	return rc;
+}
+
+/** Fault in a userspace buffer of the current address space.
+ *
+ * Make sure all pages of the buffer are mapped with the requested access
+ * rights, so that a subsequent copy to or from the buffer does not fault.
+ * This is useful before entering a region in which a page fault would be
+ * expensive, or before a batch of copies.
+ *
+ * Note that the pages may still be unmapped by another thread of the task
+ * before the buffer is accessed. The copy functions handle that case, this
+ * function is merely an optimization.
+ *
+ * @param base   Start of the buffer.
+ * @param size   Size of the buffer.
+ * @param access Access mode to fault the pages in for.
+ *
+ * @return EOK if all pages of the buffer are mapped.
+ * @return EFAULT if some page of the buffer is not accessible.
+ * @return ENOMEM if there was not enough memory to map the pages.
+ *
+ */
+errno_t as_prefault(uintptr_t base, size_t size, pf_access_t access)
+{
+	if (size == 0)
+		return EOK;
+
+	if (overflows(base, size))
+		return EFAULT;
+
+	uintptr_t page = ALIGN_DOWN(base, PAGE_SIZE);
+	uintptr_t end = ALIGN_UP(base + size, PAGE_SIZE);
+
+	for (; page != end; page += PAGE_SIZE) {
+		ipl_t ipl = interrupts_disable();
+		int rc = as_page_fault_resolve(page, access);
+		interrupts_restore(ipl);
+
+		if (rc == AS_PF_SILENT)
+			return ENOMEM;
+
+		if (rc != AS_PF_OK)
+			return EFAULT;
+	}
+
+	return EOK;
+}
+
+/** Handle page fault within the current address space.
+ *
+ * This is the high-level page fault handler. It decides whether the page fault
+ * can be resolved by any backend and if so, it invokes the backend to resolve
+ * the page fault.
+ *
+ * Interrupts are assumed disabled.
+ *
+ * @param address Faulting address.
+ * @param access  Access mode that caused the page fault (i.e.
+ *                read/write/exec).
+ * @param istate  Pointer to the interrupted state.
+ *
+ * @return AS_PF_FAULT on page fault.
+ * @return AS_PF_OK on success.
+ * @return AS_PF_DEFER if the fault was caused by copy_to_uspace()
+ *         or copy_from_uspace().
+ *
+ */
+int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
+{
+	int rc = as_page_fault_resolve(ALIGN_DOWN(address, PAGE_SIZE), access);
+	if (rc == AS_PF_OK)
+		return AS_PF_OK;
 
-page_fault:
 	if (THREAD && THREAD->in_copy_from_uspace) {
 		THREAD->in_copy_from_uspace = false;
 		istate_set_retaddr(istate,
@@ -1685,6 +2066,11 @@ retry:
 	 */
 	as_install_arch(new_as);
 
+	/*
+	 * Let TLB shootdowns know about the change.
+	 */
+	tlb_shootdown_switch(old_as, new_as);
+
 	spinlock_unlock(&asidlock);
 
 	AS = new_as;
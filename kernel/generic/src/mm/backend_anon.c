@@ -45,6 +45,7 @@
 #include <mm/frame.h>
 #include <mm/slab.h>
 #include <mm/km.h>
+#include <mm/zero.h>
 #include <synch/mutex.h>
 #include <adt/list.h>
 #include <errno.h>
@@ -53,6 +54,9 @@
 #include <mem.h>
 #include <arch.h>
 
+/** Maximum number of pages mapped ahead on sequential faults. */
+#define ANON_FAULT_AROUND  16
+
 static bool anon_create(as_area_t *);
 static bool anon_resize(as_area_t *, size_t);
 static void anon_share(as_area_t *);
@@ -139,12 +143,21 @@ void anon_share(as_area_t *area)
 			assert(PTE_VALID(&pte));
 			assert(PTE_PRESENT(&pte));
 
+			/*
+			 * Copy-on-write pages of a cloned area must get their
+			 * own frame before everybody can write to them.
+			 */
+			uintptr_t frame = PTE_GET_FRAME(&pte);
+			if ((area->flags & AS_AREA_WRITE) &&
+			    !PTE_WRITABLE(&pte))
+				(void) as_page_cow_break(area, base + P2SZ(j),
+				    &frame);
+
 			as_pagemap_insert(&area->sh_info->pagemap,
-			    (base + P2SZ(j)) - area->base, PTE_GET_FRAME(&pte));
+			    (base + P2SZ(j)) - area->base, frame);
 			page_table_unlock(area->as, false);
 
-			pfn_t pfn = ADDR2PFN(PTE_GET_FRAME(&pte));
-			frame_reference_add(pfn);
+			frame_reference_add(ADDR2PFN(frame));
 		}
 
 		ival = used_space_next(ival);
@@ -170,6 +183,119 @@ bool anon_is_shareable(as_area_t *area)
 	return !(area->flags & AS_AREA_LATE_RESERVE);
 }
 
+/** Allocate a zeroed frame for an anonymous page.
+ *
+ * The memory must have been reserved already. A frame from the pool of
+ * pre-zeroed frames is used when available.
+ *
+ * @return Physical address of the frame.
+ */
+static uintptr_t anon_frame_alloc(void)
+{
+	uintptr_t frame = zero_pool_get();
+	if (frame != 0)
+		return frame;
+
+	uintptr_t kpage = km_temporary_page_get(&frame, FRAME_NO_RESERVE);
+	memsetb((void *) kpage, PAGE_SIZE, 0);
+	km_temporary_page_put(kpage);
+
+	return frame;
+}
+
+/** Map pages following a sequentially faulting page.
+ *
+ * When the page preceding @a upage is already used, the area is likely being
+ * accessed sequentially and we map up to ANON_FAULT_AROUND following pages,
+ * stopping at the first page which is already used. Only private areas with
+ * memory reserved in advance are considered.
+ *
+ * The address space area and page tables must be already locked.
+ *
+ * @param area  Pointer to the address space area.
+ * @param upage Faulting virtual page, not yet marked in the used space.
+ *
+ * @return Number of pages mapped after @a upage.
+ */
+static size_t anon_fault_around(as_area_t *area, uintptr_t upage)
+{
+	if ((area->flags & AS_AREA_LATE_RESERVE) || (upage == area->base))
+		return 0;
+
+	used_space_ival_t *ival = used_space_find_gteq(&area->used_space,
+	    upage - PAGE_SIZE);
+	if ((ival == NULL) || (ival->page > upage - PAGE_SIZE) ||
+	    (ival->page + P2SZ(ival->count) > upage))
+		return 0;
+
+	uintptr_t end = area->base + P2SZ(area->pages);
+	ival = used_space_next(ival);
+	if ((ival != NULL) && (ival->page < end))
+		end = ival->page;
+
+	size_t count = 0;
+	uintptr_t page = upage + PAGE_SIZE;
+	while ((count < ANON_FAULT_AROUND) && (page < end)) {
+		page_mapping_insert(AS, page, anon_frame_alloc(),
+		    as_area_get_flags(area));
+		page += PAGE_SIZE;
+		count++;
+	}
+
+	AS->fault_around += count;
+	return count;
+}
+
+/** Try to back the faulting page by a large page.
+ *
+ * This is done only for private areas which ask for it and only if no
+ * page within the large page has been touched yet. If there are no
+ * suitably aligned contiguous frames, the caller falls back to a base
+ * page.
+ *
+ * @param area  Pointer to the address space area.
+ * @param upage Faulting virtual page.
+ *
+ * @return True if a large page has been mapped.
+ */
+static bool anon_large_page_fault(as_area_t *area, uintptr_t upage)
+{
+	size_t size = page_large_size();
+
+	if ((size == 0) || !(area->flags & AS_AREA_LARGE_PAGES) ||
+	    (area->flags & AS_AREA_LATE_RESERVE))
+		return false;
+
+	uintptr_t base = ALIGN_DOWN(upage, size);
+	if ((base < area->base) ||
+	    (base - area->base + size > P2SZ(area->pages)))
+		return false;
+
+	used_space_ival_t *ival = used_space_find_gteq(&area->used_space,
+	    base);
+	if ((ival != NULL) && (ival->page < base + size))
+		return false;
+
+	/* The memory is already reserved for the whole area. */
+	uintptr_t frame = frame_alloc(SIZE2FRAMES(size),
+	    FRAME_LOWMEM | FRAME_ATOMIC | FRAME_NO_RESERVE, size - 1);
+	if (frame == 0)
+		return false;
+
+	memsetb((void *) PA2KA(frame), size, 0);
+
+	if (!page_mapping_insert_large(AS, base, frame,
+	    as_area_get_flags(area))) {
+		frame_free_noreserve(frame, SIZE2FRAMES(size));
+		return false;
+	}
+
+	if (!used_space_insert(&area->used_space, base, SIZE2FRAMES(size)))
+		panic("Cannot insert used space.");
+
+	return true;
+}
+
 /** Service a page fault in the anonymous memory address space area.
  *
  * The address space area and page tables must be already locked.
@@ -183,7 +309,6 @@ bool anon_is_shareable(as_area_t *area)
  */
 int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 {
-	uintptr_t kpage;
 	uintptr_t frame;
 
 	assert(page_table_locked(AS));
@@ -206,10 +331,7 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		    upage - area->base, &frame);
 		if (rc != EOK) {
 			/* Need to allocate the frame */
-			kpage = km_temporary_page_get(&frame,
-			    FRAME_NO_RESERVE);
-			memsetb((void *) kpage, PAGE_SIZE, 0);
-			km_temporary_page_put(kpage);
+			frame = anon_frame_alloc();
 
 			/*
 			 * Insert the address of the newly allocated
@@ -236,6 +358,11 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		 *   the different causes
 		 */
 
+		if (anon_large_page_fault(area, upage)) {
+			mutex_unlock(&area->sh_info->lock);
+			return AS_PF_OK;
+		}
+
 		if (area->flags & AS_AREA_LATE_RESERVE) {
 			/*
 			 * Reserve the memory for this page now.
@@ -246,10 +373,9 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 			}
 		}
 
-		kpage = km_temporary_page_get(&frame, FRAME_NO_RESERVE);
-		memsetb((void *) kpage, PAGE_SIZE, 0);
-		km_temporary_page_put(kpage);
+		frame = anon_frame_alloc();
 	}
+	bool shared = area->sh_info->shared;
 	mutex_unlock(&area->sh_info->lock);
 
 	/*
@@ -258,7 +384,9 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 	 * being inserted into page tables.
 	 */
 	page_mapping_insert(AS, upage, frame, as_area_get_flags(area));
-	if (!used_space_insert(&area->used_space, upage, 1))
+
+	size_t around = shared ? 0 : anon_fault_around(area, upage);
+	if (!used_space_insert(&area->used_space, upage, 1 + around))
 		panic("Cannot insert used space.");
 
 	return AS_PF_OK;
@@ -143,6 +143,34 @@ int phys_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		return AS_PF_FAULT;
 
 	assert(upage - area->base < area->backend_data.frames * FRAME_SIZE);
+
+	/*
+	 * Map a whole large page if it fits in the area and both the virtual
+	 * and the physical address are suitably aligned.
+	 */
+	size_t size = page_large_size();
+	if (size > 0) {
+		uintptr_t lpage = ALIGN_DOWN(upage, size);
+		uintptr_t lframe = base + (lpage - area->base);
+
+		if ((lpage >= area->base) && IS_ALIGNED(lframe, size) &&
+		    (lpage - area->base + size <=
+		    area->backend_data.frames * FRAME_SIZE)) {
+			used_space_ival_t *ival =
+			    used_space_find_gteq(&area->used_space, lpage);
+
+			if (((ival == NULL) || (ival->page >= lpage + size)) &&
+			    page_mapping_insert_large(AS, lpage, lframe,
+			    as_area_get_flags(area))) {
+				if (!used_space_insert(&area->used_space, lpage,
+				    SIZE2FRAMES(size)))
+					panic("Cannot insert used space.");
+
+				return AS_PF_OK;
+			}
+		}
+	}
+
 	page_mapping_insert(AS, upage, base + (upage - area->base),
 	    as_area_get_flags(area));
 
@@ -61,6 +61,7 @@
 #include <config.h>
 #include <str.h>
 #include <proc/thread.h> /* THREAD */
+#include <cpu.h>
 
 zones_t zones;
 
@@ -570,11 +571,12 @@ bool zone_merge(size_t z1, size_t z2)
 
 	/*
 	 * We can join only 2 zones with none existing inbetween,
-	 * the zones have to be available and with the same
-	 * set of flags
+	 * the zones have to be available, with the same
+	 * set of flags and in the same NUMA node
 	 */
 	if ((z1 >= zones.count) || (z2 >= zones.count) || (z2 - z1 != 1) ||
-	    (zones.info[z1].flags != zones.info[z2].flags)) {
+	    (zones.info[z1].flags != zones.info[z2].flags) ||
+	    (zones.info[z1].node != zones.info[z2].node)) {
 		ret = false;
 		goto errout;
 	}
@@ -641,6 +643,52 @@ void zone_merge_all(void)
 	}
 }
 
+/** Assign zones to a NUMA node.
+ *
+ * All zones starting within the given range of frames are
+ * considered to belong to the NUMA node @a node. This should
+ * be called before the zones are merged, because zones from
+ * different NUMA nodes are never merged together.
+ *
+ * @param base  First frame of the range.
+ * @param count Number of frames in the range.
+ * @param node  NUMA node.
+ *
+ */
+void zone_set_node(pfn_t base, size_t count, unsigned int node)
+{
+	irq_spinlock_lock(&zones.lock, true);
+
+	for (size_t i = 0; i < zones.count; i++) {
+		if (iswithin(base, count, zones.info[i].base, 1))
+			zones.info[i].node = node;
+	}
+
+	zones.nodes = max(zones.nodes, node + 1);
+
+	irq_spinlock_unlock(&zones.lock, true);
+}
+
+/** Find the first zone of a NUMA node.
+ *
+ * Assume interrupts are disabled and zones lock is
+ * locked.
+ *
+ * @param node NUMA node.
+ *
+ * @return Zone index or 0 if the node has no zones.
+ *
+ */
+_NO_TRACE static size_t find_node_zone(unsigned int node)
+{
+	for (size_t i = 0; i < zones.count; i++) {
+		if (zones.info[i].node == node)
+			return i;
+	}
+
+	return 0;
+}
+
 /** Create new frame zone.
  *
  * @param zone     Zone to construct.
@@ -658,6 +706,7 @@ _NO_TRACE static void zone_construct(zone_t *zone, pfn_t start, size_t count,
 	zone->base = start;
 	zone->count = count;
 	zone->flags = flags;
+	zone->node = 0;
 	zone->free_count = count;
 	zone->busy_count = 0;
 
@@ -859,6 +908,207 @@ static size_t try_find_zone(size_t count, bool lowmem,
 	    frame_constraint, hint);
 }
 
+/*
+ * Per-CPU frame caches
+ */
+
+/** Initialize a CPU frame cache
+ *
+ */
+void frame_cache_init(frame_cache_t *cache)
+{
+	irq_spinlock_initialize(&cache->lock, "frame.cache.lock");
+	cache->count = 0;
+}
+
+/** Return frames from a CPU frame cache to their zones
+ *
+ * Assume the cache is locked.
+ *
+ * @param cache Frame cache.
+ * @param count Maximum number of frames to return.
+ *
+ * @return Number of frames returned.
+ *
+ */
+_NO_TRACE static size_t frame_cache_flush(frame_cache_t *cache, size_t count)
+{
+	assert(irq_spinlock_locked(&cache->lock));
+
+	count = min(count, cache->count);
+
+	irq_spinlock_lock(&zones.lock, false);
+
+	for (size_t i = 0; i < count; i++) {
+		pfn_t pfn = cache->frames[--cache->count];
+		size_t znum = find_zone(pfn, 1, 0);
+
+		assert(znum != (size_t) -1);
+
+		size_t freed = zone_frame_free(&zones.info[znum],
+		    pfn - zones.info[znum].base);
+
+		(void) freed;
+		assert(freed == 1);
+	}
+
+	irq_spinlock_unlock(&zones.lock, false);
+
+	return count;
+}
+
+/** Take a batch of frames from the zones into a CPU frame cache
+ *
+ * Assume the cache is locked.
+ *
+ */
+_NO_TRACE static void frame_cache_refill(frame_cache_t *cache)
+{
+	assert(irq_spinlock_locked(&cache->lock));
+
+	irq_spinlock_lock(&zones.lock, false);
+
+	size_t hint = 0;
+	if (zones.nodes > 1)
+		hint = find_node_zone(CPU->numa_node);
+
+	while (cache->count < FRAME_CACHE_BATCH) {
+		size_t znum = find_free_zone(1, ZONE_LOWMEM | ZONE_AVAILABLE,
+		    0, hint);
+		if (znum == (size_t) -1)
+			break;
+
+		cache->frames[cache->count++] = zones.info[znum].base +
+		    zone_frame_alloc(&zones.info[znum], 1, 0);
+		hint = znum;
+	}
+
+	irq_spinlock_unlock(&zones.lock, false);
+}
+
+/** Allocate a single frame from the cache of the current CPU
+ *
+ * @return Physical address of the allocated frame or zero if the
+ *         cache is empty and cannot be refilled.
+ *
+ */
+_NO_TRACE static uintptr_t frame_cache_alloc(void)
+{
+	ipl_t ipl = interrupts_disable();
+
+	/* The caches are not used until all zones are set up. */
+	if (!CPU) {
+		interrupts_restore(ipl);
+		return 0;
+	}
+
+	frame_cache_t *cache = &CPU->frame_cache;
+	irq_spinlock_lock(&cache->lock, false);
+
+	if (cache->count == 0)
+		frame_cache_refill(cache);
+
+	/* The first frame is never allocated */
+	pfn_t pfn = 0;
+	if (cache->count > 0)
+		pfn = cache->frames[--cache->count];
+
+	irq_spinlock_unlock(&cache->lock, false);
+	interrupts_restore(ipl);
+
+	return PFN2ADDR(pfn);
+}
+
+/** Release a frame into the cache of the current CPU
+ *
+ * Drop a reference to the frame. If it was the last one, keep the frame
+ * in the cache.
+ *
+ * @param pfn   Frame to be released.
+ * @param freed Number of frames which became free.
+ *
+ * @return False if the frame must be released the usual way.
+ *
+ */
+_NO_TRACE static bool frame_cache_free(pfn_t pfn, size_t *freed)
+{
+	/*
+	 * Let frame_free_generic() wake up the waiting allocators.
+	 * An unlocked read is fine, the waiters drain the caches
+	 * before they go to sleep.
+	 */
+	if (mem_avail_req > 0)
+		return false;
+
+	ipl_t ipl = interrupts_disable();
+
+	if (!CPU) {
+		interrupts_restore(ipl);
+		return false;
+	}
+
+	/* The zones are not going to change anymore, no need to lock them. */
+	size_t znum = find_zone(pfn, 1, 0);
+	assert(znum != (size_t) -1);
+
+	zone_t *zone = &zones.info[znum];
+	if ((zone->flags & (ZONE_AVAILABLE | ZONE_LOWMEM)) !=
+	    (ZONE_AVAILABLE | ZONE_LOWMEM)) {
+		interrupts_restore(ipl);
+		return false;
+	}
+
+	frame_t *frame = zone_get_frame(zone, pfn - zone->base);
+	assert(atomic_load(&frame->refcount) > 0);
+
+	*freed = 0;
+	if (atomic_fetch_sub(&frame->refcount, 1) > 1) {
+		/* Still shared */
+		interrupts_restore(ipl);
+		return true;
+	}
+
+	/* The cache takes over the last reference */
+	atomic_store(&frame->refcount, 1);
+
+	frame_cache_t *cache = &CPU->frame_cache;
+	irq_spinlock_lock(&cache->lock, false);
+
+	if (cache->count == FRAME_CACHE_SIZE)
+		(void) frame_cache_flush(cache, FRAME_CACHE_BATCH);
+
+	cache->frames[cache->count++] = pfn;
+
+	irq_spinlock_unlock(&cache->lock, false);
+	interrupts_restore(ipl);
+
+	*freed = 1;
+	return true;
+}
+
+/** Return all frames from the CPU frame caches to the zones
+ *
+ * @return Number of frames returned.
+ *
+ */
+size_t frame_cache_drain_all(void)
+{
+	if (!cpus)
+		return 0;
+
+	size_t drained = 0;
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		frame_cache_t *cache = &cpus[i].frame_cache;
+
+		irq_spinlock_lock(&cache->lock, true);
+		drained += frame_cache_flush(cache, cache->count);
+		irq_spinlock_unlock(&cache->lock, true);
+	}
+
+	return drained;
+}
+
 /** Allocate frames of physical memory.
  *
  * @param count      Number of continuous frames to allocate.
@@ -884,17 +1134,47 @@ uintptr_t frame_alloc_generic(size_t count, frame_flags_t flags,
 	if (!(flags & FRAME_NO_RESERVE))
 		reserve_force_alloc(count);
 
+	// TODO: Print diagnostic if neither is explicitly specified.
+	bool lowmem = (flags & FRAME_LOWMEM) || !(flags & FRAME_HIGHMEM);
+
+	/*
+	 * Single frames without special requirements come from
+	 * the frame cache of the current CPU.
+	 */
+	if ((count == 1) && (lowmem) && (constraint == 0) && (!pzone)) {
+		uintptr_t frame = frame_cache_alloc();
+		if (frame != 0)
+			return frame;
+	}
+
 loop:
 	irq_spinlock_lock(&zones.lock, true);
 
-	// TODO: Print diagnostic if neither is explicitly specified.
-	bool lowmem = (flags & FRAME_LOWMEM) || !(flags & FRAME_HIGHMEM);
+	/*
+	 * Without an explicit preference, start searching in the zones
+	 * local to the NUMA node of the current CPU.
+	 */
+	if ((!pzone) && (zones.nodes > 1) && (CPU))
+		hint = find_node_zone(CPU->numa_node);
 
 	/*
 	 * First, find suitable frame zone.
 	 */
 	size_t znum = try_find_zone(count, lowmem, frame_constraint, hint);
 
+	/*
+	 * If no memory, take back the frames cached by the CPUs.
+	 */
+	if (znum == (size_t) -1) {
+		irq_spinlock_unlock(&zones.lock, true);
+		size_t drained = frame_cache_drain_all();
+		irq_spinlock_lock(&zones.lock, true);
+
+		if (drained > 0)
+			znum = try_find_zone(count, lowmem,
+			    frame_constraint, hint);
+	}
+
 	/*
 	 * If no memory, reclaim some slab memory,
 	 * if it does not help, reclaim all.
@@ -1006,6 +1286,13 @@ void frame_free_generic(uintptr_t start, size_t count, frame_flags_t flags)
 {
 	size_t freed = 0;
 
+	if ((count == 1) && (frame_cache_free(ADDR2PFN(start), &freed))) {
+		if (!(flags & FRAME_NO_RESERVE))
+			reserve_free(freed);
+
+		return;
+	}
+
 	irq_spinlock_lock(&zones.lock, true);
 
 	for (size_t i = 0; i < count; i++) {
@@ -1082,6 +1369,62 @@ _NO_TRACE void frame_reference_add(pfn_t pfn)
 	irq_spinlock_unlock(&zones.lock, true);
 }
 
+/** Add reference to frame in low memory.
+ *
+ * Unlike frame_reference_add(), this function can be used for any
+ * physical address.
+ *
+ * @param pfn Frame number of the frame.
+ *
+ * @return True if a reference was added, i.e. the frame is managed by
+ *         the frame allocator and it is identity-mapped in the kernel.
+ *
+ */
+_NO_TRACE bool frame_reference_add_lowmem(pfn_t pfn)
+{
+	irq_spinlock_lock(&zones.lock, true);
+
+	size_t znum = find_zone(pfn, 1, 0);
+	bool added = false;
+
+	if ((znum != (size_t) -1) &&
+	    ((zones.info[znum].flags & (ZONE_AVAILABLE | ZONE_LOWMEM)) ==
+	    (ZONE_AVAILABLE | ZONE_LOWMEM))) {
+		zones.info[znum].frames[pfn - zones.info[znum].base].refcount++;
+		added = true;
+	}
+
+	irq_spinlock_unlock(&zones.lock, true);
+
+	return added;
+}
+
+/** Get the number of references to a frame.
+ *
+ * The result is only a snapshot unless the caller prevents new references
+ * from being added, e.g. by holding the lock of the only address space area
+ * which maps the frame.
+ *
+ * @param pfn Frame number of the frame.
+ *
+ * @return Reference count of the frame.
+ *
+ */
+_NO_TRACE size_t frame_reference_count(pfn_t pfn)
+{
+	irq_spinlock_lock(&zones.lock, true);
+
+	size_t znum = find_zone(pfn, 1, 0);
+	assert(znum != (size_t) -1);
+
+	size_t refcount =
+	    zones.info[znum].frames[pfn - zones.info[znum].base].refcount;
+
+	irq_spinlock_unlock(&zones.lock, true);
+
+	return refcount;
+}
+
 /** Mark given range unavailable in frame zones.
  *
  */
@@ -1109,6 +1452,7 @@ void frame_init(void)
 {
 	if (config.cpu_active == 1) {
 		zones.count = 0;
+		zones.nodes = 1;
 		irq_spinlock_initialize(&zones.lock, "frame.zones.lock");
 		mutex_initialize(&mem_avail_mtx, MUTEX_ACTIVE);
 		condvar_initialize(&mem_avail_cv);
@@ -1377,6 +1721,7 @@ void zone_print_one(size_t num)
 	size_t count = zones.info[znum].count;
 	size_t free_count = zones.info[znum].free_count;
 	size_t busy_count = zones.info[znum].busy_count;
+	unsigned int node = zones.info[znum].node;
 
 	bool available = ((flags & ZONE_AVAILABLE) != 0);
 	bool lowmem = ((flags & ZONE_LOWMEM) != 0);
@@ -1426,6 +1771,7 @@ void zone_print_one(size_t num)
 	    (flags & ZONE_FIRMWARE) ? 'F' : '-',
 	    (flags & ZONE_LOWMEM) ? 'L' : '-',
 	    (flags & ZONE_HIGHMEM) ? 'H' : '-');
+	printf("Zone NUMA node:          %u\n", node);
 
 	if (available) {
 		bin_order_suffix(FRAMES2SIZE(busy_count), &size, &size_suffix,
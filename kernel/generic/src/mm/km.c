@@ -52,27 +52,48 @@
 
 static ra_arena_t *km_ni_arena;
 
+/** Unmapped range whose TLB invalidation has been deferred. */
+typedef struct {
+	uintptr_t base;
+	size_t size;
+} km_deferred_t;
+
+#define DEFERRED_RANGES_MAX	(PAGE_SIZE / sizeof(km_deferred_t))
 #define DEFERRED_PAGES_MAX	(PAGE_SIZE / sizeof(uintptr_t))
 
-/** Number of freed pages in the deferred buffer. */
-static volatile unsigned deferred_pages;
-/** Buffer of deferred freed pages. */
-static uintptr_t deferred_page[DEFERRED_PAGES_MAX];
+/** Number of unmapped ranges in the deferred buffer. */
+static volatile unsigned deferred_ranges;
+/** Number of unmapped pages in the deferred buffer. */
+static size_t deferred_pages;
+/** Buffer of deferred unmapped ranges. */
+static km_deferred_t deferred_range[DEFERRED_RANGES_MAX];
 
-/** Flush the buffer of deferred freed pages.
+/** Flush the buffer of deferred unmapped ranges.
+ *
+ * The mappings of all the ranges are removed and invalidated by a single
+ * TLB shootdown and only then is the virtual address space returned to
+ * the arena, so that no stale translation can alias a new mapping.
+ *
+ * Page tables of the kernel address space must be locked.
  *
- * @return		Number of freed pages.
+ * @return		Number of freed ranges.
  */
 static unsigned km_flush_deferred(void)
 {
 	unsigned i = 0;
 	ipl_t ipl;
 
+	if (deferred_ranges == 0)
+		return 0;
+
 	ipl = tlb_shootdown_start(TLB_INVL_ASID, ASID_KERNEL, 0, 0);
 
-	for (i = 0; i < deferred_pages; i++) {
-		page_mapping_remove(AS_KERNEL, deferred_page[i]);
-		km_page_free(deferred_page[i], PAGE_SIZE);
+	for (i = 0; i < deferred_ranges; i++) {
+		for (size_t offs = 0; offs < deferred_range[i].size;
+		    offs += PAGE_SIZE) {
+			page_mapping_remove(AS_KERNEL,
+			    deferred_range[i].base + offs);
+		}
 	}
 
 	tlb_invalidate_asid(ASID_KERNEL);
@@ -80,6 +101,12 @@ static unsigned km_flush_deferred(void)
 	as_invalidate_translation_cache(AS_KERNEL, 0, -1);
 	tlb_shootdown_finalize(ipl);
 
+	for (i = 0; i < deferred_ranges; i++)
+		km_page_free(deferred_range[i].base, deferred_range[i].size);
+
+	deferred_ranges = 0;
+	deferred_pages = 0;
+
 	return i;
 }
 
@@ -104,6 +131,15 @@ bool km_is_non_identity(uintptr_t addr)
 	return km_is_non_identity_arch(addr);
 }
 
+/** Enable per-CPU caching of small non-identity ranges.
+ *
+ * Must be called once the number of CPUs is known.
+ */
+void km_enable_cpucache(void)
+{
+	(void) ra_qcache_enable(km_ni_arena, PAGE_SIZE);
+}
+
 void km_non_identity_span_add(uintptr_t base, size_t size)
 {
 	bool span_added;
@@ -120,8 +156,16 @@ uintptr_t km_page_alloc(size_t size, size_t align)
 	uintptr_t base;
 	if (ra_alloc(km_ni_arena, size, align, &base))
 		return base;
-	else
-		panic("Kernel ran out of virtual address space.");
+
+	/* Reclaim the address space held by deferred unmaps */
+	page_table_lock(AS_KERNEL, true);
+	(void) km_flush_deferred();
+	page_table_unlock(AS_KERNEL, true);
+
+	if (ra_alloc(km_ni_arena, size, align, &base))
+		return base;
+
+	panic("Kernel ran out of virtual address space.");
 }
 
 void km_page_free(uintptr_t page, size_t size)
@@ -155,29 +199,40 @@ km_map_aligned(uintptr_t paddr, size_t size, size_t align, unsigned int flags)
 	return vaddr;
 }
 
-static void km_unmap_aligned(uintptr_t vaddr, size_t size)
+/** Unmap kernel non-identity range.
+ *
+ * The range is unmapped lazily. Its address space stays allocated until
+ * the buffer of deferred ranges is flushed, which amortizes the cost of a
+ * TLB shootdown over many unmaps.
+ *
+ * @param[in] vaddr	Page aligned base of the range.
+ * @param[in] size	Page aligned size of the range.
+ */
+static void km_unmap_deferred(uintptr_t vaddr, size_t size)
 {
-	uintptr_t offs;
-	ipl_t ipl;
-
-	assert(ALIGN_DOWN(vaddr, PAGE_SIZE) == vaddr);
-	assert(ALIGN_UP(size, PAGE_SIZE) == size);
-
 	page_table_lock(AS_KERNEL, true);
 
-	size_t pages = size >> PAGE_WIDTH;
-	ipl = tlb_shootdown_start(TLB_INVL_PAGES, ASID_KERNEL, vaddr, pages);
+	if (deferred_ranges == DEFERRED_RANGES_MAX)
+		(void) km_flush_deferred();
 
-	for (offs = 0; offs < size; offs += PAGE_SIZE)
-		page_mapping_remove(AS_KERNEL, vaddr + offs);
+	deferred_range[deferred_ranges].base = vaddr;
+	deferred_range[deferred_ranges].size = size;
+	deferred_ranges++;
+	deferred_pages += size >> PAGE_WIDTH;
 
-	tlb_invalidate_pages(ASID_KERNEL, vaddr, pages);
+	/* Do not let large unmapped ranges linger */
+	if (deferred_pages >= DEFERRED_PAGES_MAX)
+		(void) km_flush_deferred();
 
-	as_invalidate_translation_cache(AS_KERNEL, 0, -1);
-	tlb_shootdown_finalize(ipl);
 	page_table_unlock(AS_KERNEL, true);
+}
+
+static void km_unmap_aligned(uintptr_t vaddr, size_t size)
+{
+	assert(ALIGN_DOWN(vaddr, PAGE_SIZE) == vaddr);
+	assert(ALIGN_UP(size, PAGE_SIZE) == size);
 
-	km_page_free(vaddr, size);
+	km_unmap_deferred(vaddr, size);
 }
 
 /** Map a piece of physical address space into the virtual address space.
@@ -215,24 +270,6 @@ void km_unmap(uintptr_t vaddr, size_t size)
 	    ALIGN_UP(size + offs, PAGE_SIZE));
 }
 
-/** Unmap kernel non-identity page.
- *
- * @param[in] page	Non-identity page to be unmapped.
- */
-static void km_unmap_deferred(uintptr_t page)
-{
-	page_table_lock(AS_KERNEL, true);
-
-	if (deferred_pages == DEFERRED_PAGES_MAX) {
-		(void) km_flush_deferred();
-		deferred_pages = 0;
-	}
-
-	deferred_page[deferred_pages++] = page;
-
-	page_table_unlock(AS_KERNEL, true);
-}
-
 /** Create a temporary page.
  *
  * The page is mapped read/write to a newly allocated frame of physical memory.
@@ -282,7 +319,7 @@ void km_temporary_page_put(uintptr_t page)
 	assert(THREAD);
 
 	if (km_is_non_identity(page))
-		km_unmap_deferred(page);
+		km_unmap_deferred(page, PAGE_SIZE);
 }
 
 /** @}
@@ -109,6 +109,54 @@ _NO_TRACE void page_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
 	memory_barrier();
 }
 
+/** Insert mapping of a large page to contiguous frames.
+ *
+ * @param as    Address space to which page belongs.
+ * @param page  Virtual address of the large page, aligned to its size.
+ * @param frame Physical address of the first frame, aligned likewise.
+ * @param flags Flags to be used for mapping.
+ *
+ * @return True if the large page has been mapped. False if large pages
+ *         are not supported or some page of the range is already mapped.
+ *
+ */
+_NO_TRACE bool page_mapping_insert_large(as_t *as, uintptr_t page,
+    uintptr_t frame, unsigned int flags)
+{
+	assert(page_table_locked(as));
+
+	assert(page_mapping_operations);
+
+	if (!page_mapping_operations->mapping_insert_large)
+		return false;
+
+	assert(IS_ALIGNED(page, page_mapping_operations->large_page_size));
+	assert(IS_ALIGNED(frame, page_mapping_operations->large_page_size));
+
+	bool inserted = page_mapping_operations->mapping_insert_large(as, page,
+	    frame, flags);
+
+	/* Repel prefetched accesses to the old mapping. */
+	memory_barrier();
+
+	return inserted;
+}
+
+/** Return the size of a large page.
+ *
+ * @return Size of a large page or zero if large pages are not supported.
+ *
+ */
+size_t page_large_size(void)
+{
+	assert(page_mapping_operations);
+
+	if (!page_mapping_operations->mapping_insert_large)
+		return 0;
+
+	return page_mapping_operations->large_page_size;
+}
+
 /** Remove mapping of page.
  *
  * Remove any mapping of page within address space as.
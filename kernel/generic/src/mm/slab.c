@@ -66,6 +66,15 @@
  * size boundary. LIFO order is enforced, which should avoid fragmentation
  * as much as possible.
  *
+ * The CPU-bound magazines are accessed only by their CPU with interrupts
+ * disabled, so the fast path needs no locking at all. Other CPUs which
+ * want the objects back (slab_reclaim()) only ask the owner to flush
+ * its magazines.
+ *
+ * The cpu-shared list of magazines (the depot) is protected by a cache-wide
+ * lock. If the lock is contended too often, the cache starts using larger
+ * magazines so that the depot is visited less frequently.
+ *
  * Every cache contains list of full slabs and list of partially full slabs.
  * Empty slabs are immediately freed (thrashing will be avoided because
  * of magazines).
@@ -86,12 +95,12 @@
  * @todo
  * For better CPU-scaling the magazine allocation strategy should
  * be extended. Currently, if the cache does not have magazine, it asks
- * for non-cpu cached magazine cache to provide one. It might be feasible
- * to add cpu-cached magazine cache (which would allocate it's magazines
- * from non-cpu-cached mag. cache). This would provide a nice per-cpu
- * buffer. The other possibility is to use the per-cache
- * 'empty-magazine-list', which decreases competing for 1 per-system
- * magazine cache.
+ * for non-cpu cached magazine cache (of the respective size) to provide
+ * one. It might be feasible to add cpu-cached magazine cache (which would
+ * allocate it's magazines from non-cpu-cached mag. cache). This would
+ * provide a nice per-cpu buffer. The other possibility is to use the
+ * per-cache 'empty-magazine-list', which decreases competing for 1
+ * per-system magazine cache.
  *
  * @todo
  * It might be good to add granularity of locks even to slab level,
@@ -116,12 +125,22 @@
 #include <macros.h>
 #include <cpu.h>
 #include <stdlib.h>
+#include <str.h>
+#include <inttypes.h>
 
 IRQ_SPINLOCK_STATIC_INITIALIZE(slab_cache_lock);
 static LIST_INITIALIZE(slab_cache_list);
 
-/** Magazine cache */
-static slab_cache_t mag_cache;
+/** Magazine caches, one for each magazine size */
+static slab_cache_t mag_cache[SLAB_MAG_CLASSES];
+
+static const char *mag_cache_names[SLAB_MAG_CLASSES] = {
+	"slab_magazine_t[4]",
+	"slab_magazine_t[8]",
+	"slab_magazine_t[16]",
+	"slab_magazine_t[32]",
+	"slab_magazine_t[64]"
+};
 
 /** Cache for cache descriptors */
 static slab_cache_t slab_cache_cache;
@@ -326,6 +345,48 @@ _NO_TRACE static void *slab_obj_create(slab_cache_t *cache, unsigned int flags)
  * CPU-Cache slab functions
  */
 
+/** Lock the magazine list of a cache
+ *
+ * Keep track of how often the lock is contended. If it happens too often,
+ * let the CPUs use larger magazines so that they come here less often.
+ *
+ * @return Interrupt level to be passed to depot_unlock().
+ *
+ */
+_NO_TRACE static ipl_t depot_lock(slab_cache_t *cache)
+{
+	ipl_t ipl = interrupts_disable();
+
+	bool contended = !irq_spinlock_trylock(&cache->maglock);
+	if (contended)
+		irq_spinlock_lock(&cache->maglock, false);
+
+	cache->depot_accesses++;
+	if (contended) {
+		cache->depot_contention++;
+		cache->depot_window_contention++;
+	}
+
+	if ((cache->depot_accesses % SLAB_DEPOT_WINDOW) == 0) {
+		if ((cache->depot_window_contention >= SLAB_DEPOT_CONTENTION) &&
+		    (cache->mag_size < SLAB_MAG_SIZE_MAX))
+			cache->mag_size <<= 1;
+
+		cache->depot_window_contention = 0;
+	}
+
+	return ipl;
+}
+
+/** Unlock the magazine list of a cache
+ *
+ */
+_NO_TRACE static void depot_unlock(slab_cache_t *cache, ipl_t ipl)
+{
+	irq_spinlock_unlock(&cache->maglock, false);
+	interrupts_restore(ipl);
+}
+
 /** Find a full magazine in cache, take it from list and return it
  *
  * @param first If true, return first, else last mag.
@@ -337,7 +398,7 @@ _NO_TRACE static slab_magazine_t *get_mag_from_cache(slab_cache_t *cache,
 	slab_magazine_t *mag = NULL;
 	link_t *cur;
 
-	irq_spinlock_lock(&cache->maglock, true);
+	ipl_t ipl = depot_lock(cache);
 	if (!list_empty(&cache->magazines)) {
 		if (first)
 			cur = list_first(&cache->magazines);
@@ -348,7 +409,7 @@ _NO_TRACE static slab_magazine_t *get_mag_from_cache(slab_cache_t *cache,
 		list_remove(&mag->link);
 		atomic_dec(&cache->magazine_counter);
 	}
-	irq_spinlock_unlock(&cache->maglock, true);
+	depot_unlock(cache, ipl);
 
 	return mag;
 }
@@ -359,12 +420,12 @@ _NO_TRACE static slab_magazine_t *get_mag_from_cache(slab_cache_t *cache,
 _NO_TRACE static void put_mag_to_cache(slab_cache_t *cache,
     slab_magazine_t *mag)
 {
-	irq_spinlock_lock(&cache->maglock, true);
+	ipl_t ipl = depot_lock(cache);
 
 	list_prepend(&mag->link, &cache->magazines);
 	atomic_inc(&cache->magazine_counter);
 
-	irq_spinlock_unlock(&cache->maglock, true);
+	depot_unlock(cache, ipl);
 }
 
 /** Free all objects in magazine and free memory associated with magazine
@@ -383,28 +444,68 @@ _NO_TRACE static size_t magazine_destroy(slab_cache_t *cache,
 		atomic_dec(&cache->cached_objs);
 	}
 
-	slab_free(&mag_cache, mag);
+	slab_free(&mag_cache[fnzb(mag->size / SLAB_MAG_SIZE)], mag);
 
 	return frames;
 }
 
-/** Find full magazine, set it as current and return it
+/** Destroy both magazines of a CPU
+ *
+ * @return Number of freed pages
+ *
+ */
+_NO_TRACE static size_t magcache_destroy(slab_cache_t *cache,
+    slab_mag_cache_t *mcache)
+{
+	size_t frames = 0;
+
+	if (mcache->current)
+		frames += magazine_destroy(cache, mcache->current);
+	mcache->current = NULL;
+
+	if (mcache->last)
+		frames += magazine_destroy(cache, mcache->last);
+	mcache->last = NULL;
+
+	return frames;
+}
+
+/** Return the magazines of the current CPU
+ *
+ * Flush them first if requested by slab_reclaim().
  *
  */
-_NO_TRACE static slab_magazine_t *get_full_current_mag(slab_cache_t *cache)
+_NO_TRACE static slab_mag_cache_t *magcache_get(slab_cache_t *cache)
 {
-	slab_magazine_t *cmag = cache->mag_cache[CPU->id].current;
-	slab_magazine_t *lastmag = cache->mag_cache[CPU->id].last;
+	assert(interrupts_disabled());
+
+	slab_mag_cache_t *mcache = &cache->mag_cache[CPU->id];
 
-	assert(irq_spinlock_locked(&cache->mag_cache[CPU->id].lock));
+	if (atomic_load_explicit(&mcache->flush, memory_order_relaxed)) {
+		atomic_store_explicit(&mcache->flush, false,
+		    memory_order_relaxed);
+		(void) magcache_destroy(cache, mcache);
+	}
+
+	return mcache;
+}
+
+/** Find full magazine, set it as current and return it
+ *
+ */
+_NO_TRACE static slab_magazine_t *get_full_current_mag(slab_cache_t *cache,
+    slab_mag_cache_t *mcache)
+{
+	slab_magazine_t *cmag = mcache->current;
+	slab_magazine_t *lastmag = mcache->last;
 
 	if (cmag) { /* First try local CPU magazines */
 		if (cmag->busy)
 			return cmag;
 
 		if ((lastmag) && (lastmag->busy)) {
-			cache->mag_cache[CPU->id].current = lastmag;
-			cache->mag_cache[CPU->id].last = cmag;
+			mcache->current = lastmag;
+			mcache->last = cmag;
 			return lastmag;
 		}
 	}
@@ -417,8 +518,8 @@ _NO_TRACE static slab_magazine_t *get_full_current_mag(slab_cache_t *cache)
 	if (lastmag)
 		magazine_destroy(cache, lastmag);
 
-	cache->mag_cache[CPU->id].last = cmag;
-	cache->mag_cache[CPU->id].current = newmag;
+	mcache->last = cmag;
+	mcache->current = newmag;
 
 	return newmag;
 }
@@ -433,16 +534,16 @@ _NO_TRACE static void *magazine_obj_get(slab_cache_t *cache)
 	if (!CPU)
 		return NULL;
 
-	irq_spinlock_lock(&cache->mag_cache[CPU->id].lock, true);
+	slab_mag_cache_t *mcache = magcache_get(cache);
 
-	slab_magazine_t *mag = get_full_current_mag(cache);
+	slab_magazine_t *mag = get_full_current_mag(cache, mcache);
 	if (!mag) {
-		irq_spinlock_unlock(&cache->mag_cache[CPU->id].lock, true);
+		mcache->misses++;
 		return NULL;
 	}
 
 	void *obj = mag->objs[--mag->busy];
-	irq_spinlock_unlock(&cache->mag_cache[CPU->id].lock, true);
+	mcache->hits++;
 
 	atomic_dec(&cache->cached_objs);
 
@@ -458,20 +559,19 @@ _NO_TRACE static void *magazine_obj_get(slab_cache_t *cache)
  * If full, put to magazines list.
  *
  */
-_NO_TRACE static slab_magazine_t *make_empty_current_mag(slab_cache_t *cache)
+_NO_TRACE static slab_magazine_t *make_empty_current_mag(slab_cache_t *cache,
+    slab_mag_cache_t *mcache)
 {
-	slab_magazine_t *cmag = cache->mag_cache[CPU->id].current;
-	slab_magazine_t *lastmag = cache->mag_cache[CPU->id].last;
-
-	assert(irq_spinlock_locked(&cache->mag_cache[CPU->id].lock));
+	slab_magazine_t *cmag = mcache->current;
+	slab_magazine_t *lastmag = mcache->last;
 
 	if (cmag) {
 		if (cmag->busy < cmag->size)
 			return cmag;
 
 		if ((lastmag) && (lastmag->busy < lastmag->size)) {
-			cache->mag_cache[CPU->id].last = cmag;
-			cache->mag_cache[CPU->id].current = lastmag;
+			mcache->last = cmag;
+			mcache->current = lastmag;
 			return lastmag;
 		}
 	}
@@ -484,12 +584,14 @@ _NO_TRACE static slab_magazine_t *make_empty_current_mag(slab_cache_t *cache)
 	 * this would deadlock.
 	 *
 	 */
-	slab_magazine_t *newmag = slab_alloc(&mag_cache,
+	size_t size = cache->mag_size;
+	slab_magazine_t *newmag = slab_alloc(
+	    &mag_cache[fnzb(size / SLAB_MAG_SIZE)],
 	    FRAME_ATOMIC | FRAME_NO_RECLAIM);
 	if (!newmag)
 		return NULL;
 
-	newmag->size = SLAB_MAG_SIZE;
+	newmag->size = size;
 	newmag->busy = 0;
 
 	/* Flush last to magazine list */
@@ -497,8 +599,8 @@ _NO_TRACE static slab_magazine_t *make_empty_current_mag(slab_cache_t *cache)
 		put_mag_to_cache(cache, lastmag);
 
 	/* Move current as last, save new as current */
-	cache->mag_cache[CPU->id].last = cmag;
-	cache->mag_cache[CPU->id].current = newmag;
+	mcache->last = cmag;
+	mcache->current = newmag;
 
 	return newmag;
 }
@@ -513,18 +615,13 @@ _NO_TRACE static int magazine_obj_put(slab_cache_t *cache, void *obj)
 	if (!CPU)
 		return -1;
 
-	irq_spinlock_lock(&cache->mag_cache[CPU->id].lock, true);
-
-	slab_magazine_t *mag = make_empty_current_mag(cache);
-	if (!mag) {
-		irq_spinlock_unlock(&cache->mag_cache[CPU->id].lock, true);
+	slab_magazine_t *mag = make_empty_current_mag(cache,
+	    magcache_get(cache));
+	if (!mag)
 		return -1;
-	}
 
 	mag->objs[mag->busy++] = obj;
 
-	irq_spinlock_unlock(&cache->mag_cache[CPU->id].lock, true);
-
 	atomic_inc(&cache->cached_objs);
 
 	return 0;
@@ -571,12 +668,8 @@ _NO_TRACE static bool make_magcache(slab_cache_t *cache)
 	if (!cache->mag_cache)
 		return false;
 
-	size_t i;
-	for (i = 0; i < config.cpu_count; i++) {
-		memsetb(&cache->mag_cache[i], sizeof(cache->mag_cache[i]), 0);
-		irq_spinlock_initialize(&cache->mag_cache[i].lock,
-		    "slab.cache.mag_cache[].lock");
-	}
+	memsetb(cache->mag_cache, sizeof(*cache->mag_cache) * config.cpu_count,
+	    0);
 
 	return true;
 }
@@ -602,6 +695,7 @@ _NO_TRACE static void _slab_cache_create(slab_cache_t *cache, const char *name,
 	cache->constructor = constructor;
 	cache->destructor = destructor;
 	cache->flags = flags;
+	cache->mag_size = SLAB_MAG_SIZE;
 
 	list_initialize(&cache->full_slabs);
 	list_initialize(&cache->partial_slabs);
@@ -680,24 +774,22 @@ _NO_TRACE static size_t _slab_reclaim(slab_cache_t *cache, unsigned int flags)
 	}
 
 	if (flags & SLAB_RECLAIM_ALL) {
-		/* Free cpu-bound magazines */
-		/* Destroy CPU magazines */
+		/*
+		 * Destroy the magazines of this CPU, the other CPUs
+		 * will destroy theirs on their next access to the cache.
+		 */
+		ipl_t ipl = interrupts_disable();
+
 		size_t i;
 		for (i = 0; i < config.cpu_count; i++) {
-			irq_spinlock_lock(&cache->mag_cache[i].lock, true);
-
-			mag = cache->mag_cache[i].current;
-			if (mag)
-				frames += magazine_destroy(cache, mag);
-			cache->mag_cache[i].current = NULL;
-
-			mag = cache->mag_cache[i].last;
-			if (mag)
-				frames += magazine_destroy(cache, mag);
-			cache->mag_cache[i].last = NULL;
-
-			irq_spinlock_unlock(&cache->mag_cache[i].lock, true);
+			if ((CPU) && (i == CPU->id))
+				frames += magcache_destroy(cache,
+				    &cache->mag_cache[i]);
+			else
+				atomic_store(&cache->mag_cache[i].flush, true);
 		}
+
+		interrupts_restore(ipl);
 	}
 
 	return frames;
@@ -744,6 +836,12 @@ void slab_cache_destroy(slab_cache_t *cache)
 	/* Destroy all magazines */
 	_slab_reclaim(cache, SLAB_RECLAIM_ALL);
 
+	if (!(cache->flags & SLAB_CACHE_NOMAGAZINE)) {
+		size_t i;
+		for (i = 0; i < config.cpu_count; i++)
+			(void) magcache_destroy(cache, &cache->mag_cache[i]);
+	}
+
 	/* All slabs must be empty */
 	if ((!list_empty(&cache->full_slabs)) ||
 	    (!list_empty(&cache->partial_slabs)))
@@ -803,11 +901,28 @@ size_t slab_reclaim(unsigned int flags)
 	return frames;
 }
 
+/** Sum up the magazine hits and misses of all CPUs */
+static void magcache_stats(slab_cache_t *cache, uint64_t *hits,
+    uint64_t *misses)
+{
+	*hits = 0;
+	*misses = 0;
+
+	if ((cache->flags & SLAB_CACHE_NOMAGAZINE) || (!cache->mag_cache))
+		return;
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		*hits += cache->mag_cache[i].hits;
+		*misses += cache->mag_cache[i].misses;
+	}
+}
+
 /* Print list of caches */
 void slab_print_list(void)
 {
 	printf("[cache name      ] [size  ] [pages ] [obj/pg] [slabs ]"
-	    " [cached] [alloc ] [ctl]\n");
+	    " [cached] [alloc ] [ctl] [mag] [hits    ] [misses  ]"
+	    " [depot   ] [contend ]\n");
 
 	size_t skip = 0;
 	while (true) {
@@ -860,23 +975,71 @@ void slab_print_list(void)
 		long cached_objs = atomic_load(&cache->cached_objs);
 		long allocated_objs = atomic_load(&cache->allocated_objs);
 		unsigned int flags = cache->flags;
+		size_t mag_size = cache->mag_size;
+		uint64_t depot_accesses = cache->depot_accesses;
+		uint64_t depot_contention = cache->depot_contention;
+		uint64_t hits;
+		uint64_t misses;
+		magcache_stats(cache, &hits, &misses);
 
 		irq_spinlock_unlock(&slab_cache_lock, true);
 
-		printf("%-18s %8zu %8zu %8zu %8ld %8ld %8ld %-5s\n",
+		printf("%-18s %8zu %8zu %8zu %8ld %8ld %8ld %-5s %5zu"
+		    " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n",
 		    name, size, frames, objects, allocated_slabs,
 		    cached_objs, allocated_objs,
-		    flags & SLAB_CACHE_SLINSIDE ? "in" : "out");
+		    flags & SLAB_CACHE_SLINSIDE ? "in" : "out", mag_size,
+		    hits, misses, depot_accesses, depot_contention);
+	}
+}
+
+/** Gather statistics of slab caches
+ *
+ * @param stats Array to store the statistics into (or NULL).
+ * @param count Number of items in the array.
+ *
+ * @return Number of slab caches in the system, possibly more than
+ *         the number of items filled in.
+ *
+ */
+size_t slab_stats(stats_slab_t *stats, size_t count)
+{
+	irq_spinlock_lock(&slab_cache_lock, true);
+
+	size_t i = 0;
+	list_foreach(slab_cache_list, link, slab_cache_t, cache) {
+		if (i < count) {
+			stats_slab_t *stat = &stats[i];
+
+			str_cpy(stat->name, SLAB_NAME_BUFLEN, cache->name);
+			stat->size = cache->size;
+			stat->slabs = atomic_load(&cache->allocated_slabs);
+			stat->allocated = atomic_load(&cache->allocated_objs);
+			stat->cached = atomic_load(&cache->cached_objs);
+			stat->mag_size = cache->mag_size;
+			stat->depot_accesses = cache->depot_accesses;
+			stat->depot_contention = cache->depot_contention;
+			magcache_stats(cache, &stat->hits, &stat->misses);
+		}
+
+		i++;
 	}
+
+	irq_spinlock_unlock(&slab_cache_lock, true);
+
+	return i;
 }
 
 void slab_cache_init(void)
 {
-	/* Initialize magazine cache */
-	_slab_cache_create(&mag_cache, "slab_magazine_t",
-	    sizeof(slab_magazine_t) + SLAB_MAG_SIZE * sizeof(void *),
-	    sizeof(uintptr_t), NULL, NULL, SLAB_CACHE_NOMAGAZINE |
-	    SLAB_CACHE_SLINSIDE);
+	/* Initialize magazine caches */
+	for (size_t i = 0; i < SLAB_MAG_CLASSES; i++) {
+		_slab_cache_create(&mag_cache[i], mag_cache_names[i],
+		    sizeof(slab_magazine_t) +
+		    (SLAB_MAG_SIZE << i) * sizeof(void *),
+		    sizeof(uintptr_t), NULL, NULL, SLAB_CACHE_NOMAGAZINE |
+		    SLAB_CACHE_SLINSIDE);
+	}
 
 	/* Initialize slab_cache cache */
 	_slab_cache_create(&slab_cache_cache, "slab_cache_cache",
@@ -35,8 +35,10 @@
  * @brief Generic TLB shootdown algorithm.
  *
  * The algorithm implemented here is based on the CMU TLB shootdown
- * algorithm and is further simplified (e.g. all CPUs receive all TLB
- * shootdown messages).
+ * algorithm. Shootdowns of user address spaces are delivered only to
+ * processors which may hold translations of the address space and only
+ * those which have it installed are interrupted. The others process
+ * the queued messages before the next address space switch.
  */
 
 #include <mm/tlb.h>
@@ -51,6 +53,13 @@
 #include <arch.h>
 #include <panic.h>
 #include <cpu.h>
+#include <cpu/cpu_mask.h>
+#include <mm/as.h>
+#include <mm/page.h>
+#include <arch/cycle.h>
+#include <bitops.h>
+#include <macros.h>
+#include <abi/sysinfo.h>
 
 void tlb_init(void)
 {
@@ -67,11 +76,128 @@ void tlb_init(void)
  */
 IRQ_SPINLOCK_STATIC_INITIALIZE(tlblock);
 
-/** Send TLB shootdown message.
+/** Queue TLB shootdown message for a processor.
  *
- * This function attempts to deliver TLB shootdown message
- * to all other processors.
+ * Messages which are already covered by a queued message are dropped and
+ * adjacent page ranges of the same address space are merged, so that a
+ * whole batch of invalidations usually occupies a single queue slot.
+ *
+ * @param cpu   Target processor (locked).
+ * @param type  Type describing scope of shootdown.
+ * @param asid  Address space, if required by type.
+ * @param page  Virtual page address, if required by type.
+ * @param count Number of pages, if required by type.
+ *
+ */
+static void tlb_message_enqueue(cpu_t *cpu, tlb_invalidate_type_t type,
+    asid_t asid, uintptr_t page, size_t count)
+{
+	for (size_t i = 0; i < cpu->tlb_messages_count; i++) {
+		tlb_shootdown_msg_t *msg = &cpu->tlb_messages[i];
+
+		if (msg->type == TLB_INVL_ALL)
+			return;
+
+		if ((type == TLB_INVL_ALL) || (msg->asid != asid))
+			continue;
+
+		if (msg->type == TLB_INVL_ASID)
+			return;
+
+		if ((type == TLB_INVL_PAGES) && (msg->type == TLB_INVL_PAGES) &&
+		    (page <= msg->page + P2SZ(msg->count)) &&
+		    (msg->page <= page + P2SZ(count))) {
+			uintptr_t end = max(msg->page + P2SZ(msg->count),
+			    page + P2SZ(count));
+
+			msg->page = min(msg->page, page);
+			msg->count = (end - msg->page) >> PAGE_WIDTH;
+			return;
+		}
+	}
+
+	if (cpu->tlb_messages_count == TLB_MESSAGE_QUEUE_LEN) {
+		/*
+		 * The message queue is full.
+		 * Erase the queue and store one TLB_INVL_ALL message.
+		 */
+		cpu->tlb_messages_count = 1;
+		cpu->tlb_messages[0].type = TLB_INVL_ALL;
+		cpu->tlb_messages[0].asid = ASID_INVALID;
+		cpu->tlb_messages[0].page = 0;
+		cpu->tlb_messages[0].count = 0;
+	} else {
+		/*
+		 * Enqueue the message.
+		 */
+		size_t idx = cpu->tlb_messages_count++;
+		cpu->tlb_messages[idx].type = type;
+		cpu->tlb_messages[idx].asid = asid;
+		cpu->tlb_messages[idx].page = page;
+		cpu->tlb_messages[idx].count = count;
+	}
+}
+
+/** Process TLB shootdown messages queued for the current processor. */
+static void tlb_messages_process(void)
+{
+	irq_spinlock_lock(&CPU->lock, false);
+	assert(CPU->tlb_messages_count <= TLB_MESSAGE_QUEUE_LEN);
+
+	size_t i;
+	for (i = 0; i < CPU->tlb_messages_count; i++) {
+		tlb_invalidate_type_t type = CPU->tlb_messages[i].type;
+		asid_t asid = CPU->tlb_messages[i].asid;
+		uintptr_t page = CPU->tlb_messages[i].page;
+		size_t count = CPU->tlb_messages[i].count;
+
+		switch (type) {
+		case TLB_INVL_ALL:
+			tlb_invalidate_all();
+			break;
+		case TLB_INVL_ASID:
+			tlb_invalidate_asid(asid);
+			break;
+		case TLB_INVL_PAGES:
+			assert(count);
+			tlb_invalidate_pages(asid, page, count);
+			break;
+		default:
+			panic("Unknown type (%d).", type);
+			break;
+		}
+
+		if (type == TLB_INVL_ALL)
+			break;
+	}
+
+	CPU->tlb_messages_count = 0;
+	irq_spinlock_unlock(&CPU->lock, false);
+}
+
+/** Account TLB shootdown latency.
+ *
+ * @param cycles Cycles spent waiting for the recipients.
  *
+ */
+static void tlb_latency_account(uint64_t cycles)
+{
+	size_t bucket = 0;
+	if (cycles >= 1024)
+		bucket = min((size_t) (fnzb64(cycles) - 10) / 2 + 1,
+		    (size_t) STATS_TLB_LATENCY_BUCKETS - 1);
+
+	CPU->tlb_latency[bucket]++;
+}
+
+/** Deliver TLB shootdown message.
+ *
+ * If @a as is NULL, the message is delivered to all other processors.
+ * Otherwise it is queued only for the processors which may hold TLB entries
+ * of @a as and only those which have @a as installed are interrupted. The
+ * rest processes the message lazily before switching to any address space.
+ *
+ * @param as    Address space or NULL.
  * @param type  Type describing scope of shootdown.
  * @param asid  Address space, if required by type.
  * @param page  Virtual page address, if required by type.
@@ -80,55 +206,115 @@ IRQ_SPINLOCK_STATIC_INITIALIZE(tlblock);
  * @return The interrupt priority level as it existed prior to this call.
  *
  */
-ipl_t tlb_shootdown_start(tlb_invalidate_type_t type, asid_t asid,
-    uintptr_t page, size_t count)
+static ipl_t tlb_shootdown_deliver(as_t *as, tlb_invalidate_type_t type,
+    asid_t asid, uintptr_t page, size_t count)
 {
 	ipl_t ipl = interrupts_disable();
 	CPU->tlb_active = false;
 	irq_spinlock_lock(&tlblock, false);
 
+	CPU->tlb_shootdowns++;
+
+	DEFINE_CPU_MASK(interrupted);
+	cpu_mask_none(interrupted);
+	bool broadcast = ((as == NULL) || (as->tlb_cpus == NULL));
+
 	size_t i;
 	for (i = 0; i < config.cpu_count; i++) {
 		if (i == CPU->id)
 			continue;
 
+		if ((!broadcast) && (!cpu_mask_is_set(as->tlb_cpus, i)))
+			continue;
+
 		cpu_t *cpu = &cpus[i];
 
 		irq_spinlock_lock(&cpu->lock, false);
-		if (cpu->tlb_messages_count == TLB_MESSAGE_QUEUE_LEN) {
-			/*
-			 * The message queue is full.
-			 * Erase the queue and store one TLB_INVL_ALL message.
-			 */
-			cpu->tlb_messages_count = 1;
-			cpu->tlb_messages[0].type = TLB_INVL_ALL;
-			cpu->tlb_messages[0].asid = ASID_INVALID;
-			cpu->tlb_messages[0].page = 0;
-			cpu->tlb_messages[0].count = 0;
-		} else {
-			/*
-			 * Enqueue the message.
-			 */
-			size_t idx = cpu->tlb_messages_count++;
-			cpu->tlb_messages[idx].type = type;
-			cpu->tlb_messages[idx].asid = asid;
-			cpu->tlb_messages[idx].page = page;
-			cpu->tlb_messages[idx].count = count;
-		}
+		tlb_message_enqueue(cpu, type, asid, page, count);
 		irq_spinlock_unlock(&cpu->lock, false);
+
+		if ((broadcast) || (cpu->tlb_as == as))
+			cpu_mask_set(interrupted, i);
+	}
+
+	if ((!broadcast) && (type == TLB_INVL_ASID)) {
+		/*
+		 * Only the processors which have the address space installed
+		 * can load its translations again.
+		 */
+		cpu_mask_none(as->tlb_cpus);
+		cpu_mask_for_each(*interrupted, id) {
+			cpu_mask_set(as->tlb_cpus, id);
+		}
+
+		if (CPU->tlb_as == as)
+			cpu_mask_set(as->tlb_cpus, CPU->id);
 	}
 
-	tlb_shootdown_ipi_send();
+	if (cpu_mask_is_none(interrupted))
+		return ipl;
+
+	uint64_t begin = get_cycle();
+
+	if (broadcast) {
+		tlb_shootdown_ipi_send();
+	} else {
+		cpu_mask_for_each(*interrupted, id) {
+			ipi_send(&cpus[id], VECTOR_TLB_SHOOTDOWN_IPI);
+		}
+	}
 
 busy_wait:
-	for (i = 0; i < config.cpu_count; i++) {
-		if (cpus[i].tlb_active)
+	cpu_mask_for_each(*interrupted, id) {
+		if (cpus[id].tlb_active)
 			goto busy_wait;
 	}
 
+	tlb_latency_account(get_cycle() - begin);
+
 	return ipl;
 }
 
+/** Send TLB shootdown message.
+ *
+ * This function attempts to deliver TLB shootdown message
+ * to all other processors.
+ *
+ * @param type  Type describing scope of shootdown.
+ * @param asid  Address space, if required by type.
+ * @param page  Virtual page address, if required by type.
+ * @param count Number of pages, if required by type.
+ *
+ * @return The interrupt priority level as it existed prior to this call.
+ *
+ */
+ipl_t tlb_shootdown_start(tlb_invalidate_type_t type, asid_t asid,
+    uintptr_t page, size_t count)
+{
+	return tlb_shootdown_deliver(NULL, type, asid, page, count);
+}
+
+/** Send TLB shootdown message concerning one address space.
+ *
+ * This function delivers TLB shootdown message only to the processors
+ * which may hold TLB entries of the address space.
+ *
+ * @param as    Address space.
+ * @param type  Type describing scope of shootdown (other than TLB_INVL_ALL).
+ * @param page  Virtual page address, if required by type.
+ * @param count Number of pages, if required by type.
+ *
+ * @return The interrupt priority level as it existed prior to this call.
+ *
+ */
+ipl_t tlb_shootdown_start_as(as_t *as, tlb_invalidate_type_t type,
+    uintptr_t page, size_t count)
+{
+	assert(type != TLB_INVL_ALL);
+
+	return tlb_shootdown_deliver(as, type, as->asid, page, count);
+}
+
 /** Finish TLB shootdown sequence.
  *
  * @param ipl Previous interrupt priority level.
@@ -157,38 +343,47 @@ void tlb_shootdown_ipi_recv(void)
 	irq_spinlock_lock(&tlblock, false);
 	irq_spinlock_unlock(&tlblock, false);
 
-	irq_spinlock_lock(&CPU->lock, false);
-	assert(CPU->tlb_messages_count <= TLB_MESSAGE_QUEUE_LEN);
+	CPU->tlb_ipis++;
+	tlb_messages_process();
+	CPU->tlb_active = true;
+}
 
-	size_t i;
-	for (i = 0; i < CPU->tlb_messages_count; i++) {
-		tlb_invalidate_type_t type = CPU->tlb_messages[i].type;
-		asid_t asid = CPU->tlb_messages[i].asid;
-		uintptr_t page = CPU->tlb_messages[i].page;
-		size_t count = CPU->tlb_messages[i].count;
+/** Track address space switch for TLB shootdown.
+ *
+ * Waits for any TLB shootdown in progress to finish, so that the new address
+ * space is not installed while its mappings are being changed, and processes
+ * the messages queued for this processor while the address spaces it has
+ * translations of were not installed.
+ *
+ * Interrupts must be disabled.
+ *
+ * @param old_as Old address space or NULL.
+ * @param new_as New address space.
+ *
+ */
+void tlb_shootdown_switch(as_t *old_as, as_t *new_as)
+{
+	assert(interrupts_disabled());
 
-		switch (type) {
-		case TLB_INVL_ALL:
-			tlb_invalidate_all();
-			break;
-		case TLB_INVL_ASID:
-			tlb_invalidate_asid(asid);
-			break;
-		case TLB_INVL_PAGES:
-			assert(count);
-			tlb_invalidate_pages(asid, page, count);
-			break;
-		default:
-			panic("Unknown type (%d).", type);
-			break;
-		}
+	CPU->tlb_active = false;
+	irq_spinlock_lock(&tlblock, false);
 
-		if (type == TLB_INVL_ALL)
-			break;
+#ifdef ASID_FLUSH_ON_SWITCH
+	if ((old_as) && (old_as->tlb_cpus))
+		cpu_mask_reset(old_as->tlb_cpus, CPU->id);
+#endif
+
+	if (new_as->tlb_cpus)
+		cpu_mask_set(new_as->tlb_cpus, CPU->id);
+
+	CPU->tlb_as = new_as;
+	irq_spinlock_unlock(&tlblock, false);
+
+	if (CPU->tlb_messages_count > 0) {
+		CPU->tlb_lazy++;
+		tlb_messages_process();
 	}
 
-	CPU->tlb_messages_count = 0;
-	irq_spinlock_unlock(&CPU->lock, false);
 	CPU->tlb_active = true;
 }
 
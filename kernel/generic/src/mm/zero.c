@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic_mm
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Pool of pre-zeroed frames.
+ *
+ * Anonymous memory must be cleared before it is mapped to userspace. To keep
+ * the clearing out of the page fault path, the kzero thread prepares zeroed
+ * frames in advance whenever its CPU has nothing else to run.
+ *
+ * Frames in the pool hold their own memory reservation. The reservation is
+ * given back when a frame leaves the pool, as the callers allocate memory for
+ * areas which have already been reserved for.
+ */
+
+#include <arch.h>
+#include <cpu.h>
+#include <mem.h>
+#include <mm/frame.h>
+#include <mm/page.h>
+#include <mm/reserve.h>
+#include <mm/zero.h>
+#include <proc/scheduler.h>
+#include <synch/semaphore.h>
+#include <synch/spinlock.h>
+
+/** Period of retries when the pool could not be refilled (in microseconds). */
+#define ZERO_POOL_RETRY  1000000
+
+IRQ_SPINLOCK_STATIC_INITIALIZE_NAME(zero_pool_lock, "zero_pool_lock");
+
+/** Zeroed frames, protected by zero_pool_lock. */
+static uintptr_t zero_pool[ZERO_POOL_SIZE];
+static size_t zero_pool_count = 0;
+
+/** Wakes up kzero when the pool runs low. */
+static semaphore_t zero_pool_sem;
+
+void zero_pool_init(void)
+{
+	semaphore_initialize(&zero_pool_sem, 0);
+}
+
+/** Take a zeroed frame from the pool.
+ *
+ * Frames in the pool hold a reservation of their own, which is released
+ * when the frame is handed out. The caller must already have reserved the
+ * memory for the frame, and that reservation takes over. The frame is
+ * then freed with frame_free() like any other reserved frame.
+ *
+ * @return Physical address of a zeroed low memory frame or zero when the pool
+ *         is empty.
+ */
+uintptr_t zero_pool_get(void)
+{
+	uintptr_t frame = 0;
+	bool refill = false;
+
+	irq_spinlock_lock(&zero_pool_lock, true);
+	if (zero_pool_count > 0) {
+		frame = zero_pool[--zero_pool_count];
+		refill = (zero_pool_count == ZERO_POOL_LOW);
+	}
+	irq_spinlock_unlock(&zero_pool_lock, true);
+
+	if (frame != 0)
+		reserve_free(1);
+	if (refill)
+		semaphore_up(&zero_pool_sem);
+
+	return frame;
+}
+
+/** Zero one frame and add it to the pool.
+ *
+ * @return False if the pool is full or no more memory can be spared.
+ */
+static bool zero_pool_refill_one(void)
+{
+	/* Unlocked check, the pool is checked again before adding the frame. */
+	if (zero_pool_count >= ZERO_POOL_SIZE)
+		return false;
+
+	if (!reserve_try_alloc(1))
+		return false;
+
+	uintptr_t frame = frame_alloc(1, FRAME_LOWMEM | FRAME_ATOMIC |
+	    FRAME_NO_RESERVE, 0);
+	if (frame == 0) {
+		reserve_free(1);
+		return false;
+	}
+
+	memsetb((void *) PA2KA(frame), PAGE_SIZE, 0);
+
+	irq_spinlock_lock(&zero_pool_lock, true);
+	bool added = (zero_pool_count < ZERO_POOL_SIZE);
+	if (added)
+		zero_pool[zero_pool_count++] = frame;
+	irq_spinlock_unlock(&zero_pool_lock, true);
+
+	if (!added)
+		frame_free(frame, 1);
+
+	return added;
+}
+
+/** Kernel thread filling the pool of zeroed frames.
+ *
+ * The thread steps aside whenever other threads are ready on its CPU so that
+ * the zeroing is done in otherwise idle time.
+ *
+ * @param arg Not used.
+ */
+void kzero(void *arg)
+{
+	while (true) {
+		while (zero_pool_refill_one()) {
+			if (atomic_load(&CPU->nrdy) > 0)
+				scheduler();
+		}
+
+		/*
+		 * Periodically retry even without a request, the refill may
+		 * have failed for lack of memory.
+		 */
+		(void) semaphore_down_timeout(&zero_pool_sem, ZERO_POOL_RETRY);
+	}
+}
+
+/** @}
+ */
@@ -0,0 +1,408 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic_proc
+ * @{
+ */
+
+/**
+ * @file
+ * @brief CPU sets of threads and tasks.
+ *
+ * A CPU set restricts the processors a thread may run on. It can be set
+ * for a single userspace thread or for all userspace threads of a task,
+ * the CPU set of the thread taking precedence. Both the placement of
+ * threads which become ready and the load balancing honour the CPU sets.
+ *
+ * Processors can be isolated with the isolcpus=<list> boot argument,
+ * where the list consists of processor IDs and ranges, e.g. 2,4-7.
+ * Isolated processors do not run threads without a CPU set, so only
+ * the threads explicitly placed there compete for them. They also do
+ * not run the load balancing thread, and since the threads register
+ * their timeouts on the processor they run on, no unrelated timeouts
+ * expire there either.
+ */
+
+#include <assert.h>
+#include <proc/cpuset.h>
+#include <proc/scheduler.h>
+#include <proc/thread.h>
+#include <proc/task.h>
+#include <cpu/cpu_mask.h>
+#include <abi/proc/cpuset.h>
+#include <syscall/copy.h>
+#include <config.h>
+#include <cpu.h>
+#include <arch.h>
+#include <errno.h>
+#include <log.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdlib.h>
+#include <str.h>
+
+/** Number of bytes of a CPU set in the userspace format. */
+#define CPUSET_BYTES  ((config.cpu_count + 7) / 8)
+
+/** Isolate processors from a list of IDs and ranges of IDs.
+ *
+ * @param list List of processors, e.g. 2,4-7. Parsing stops at the first
+ *             character which does not belong to the list.
+ *
+ */
+static void cpuset_isolate(const char *list)
+{
+	const char *str = list;
+
+	while (true) {
+		uint64_t first;
+		uint64_t last;
+		char *end;
+
+		if (str_uint64_t(str, &end, 10, false, &first) != EOK)
+			break;
+
+		last = first;
+		if ((*end == '-') &&
+		    (str_uint64_t(end + 1, &end, 10, false, &last) != EOK))
+			break;
+
+		for (uint64_t id = first; (id <= last) &&
+		    (id < config.cpu_count); id++) {
+			/*
+			 * The bootstrap processor runs the kernel
+			 * initialization and general kernel threads.
+			 */
+			if (id == 0)
+				continue;
+
+			cpus[id].isolated = true;
+			log(LF_OTHER, LVL_NOTE, "cpu%" PRIu64 ": isolated", id);
+		}
+
+		if (*end != ',')
+			break;
+
+		str = end + 1;
+	}
+}
+
+/** Initialize CPU sets.
+ *
+ * Isolate the processors listed in the boot arguments.
+ *
+ */
+void cpuset_init(void)
+{
+	const char *arg = bargs;
+
+	while (arg != NULL) {
+		if (str_lcmp(arg, "isolcpus=", 9) == 0)
+			cpuset_isolate(arg + 9);
+
+		arg = str_chr(arg, ' ');
+		if (arg != NULL)
+			arg++;
+	}
+}
+
+/** Check whether a CPU set allows a processor.
+ *
+ * @param mask CPU set or NULL if not restricted.
+ * @param cpu  Processor.
+ *
+ * @return True if the processor is allowed.
+ *
+ */
+static bool cpuset_mask_allows(cpu_mask_t *mask, cpu_t *cpu)
+{
+	if (mask != NULL)
+		return cpu_mask_is_set(mask, cpu->id);
+
+	return !cpu->isolated;
+}
+
+/** Get the CPU set of a thread.
+ *
+ * @param thread Locked thread.
+ *
+ * @return CPU set which applies to the thread or NULL if not restricted.
+ *
+ */
+static cpu_mask_t *cpuset_thread_mask(thread_t *thread)
+{
+	assert(irq_spinlock_locked(&thread->lock));
+
+	if (thread->affinity != NULL)
+		return thread->affinity;
+
+	if (!thread->uspace)
+		return NULL;
+
+	return atomic_load_explicit(&thread->task->affinity,
+	    memory_order_acquire);
+}
+
+/** Check whether a thread may run on a processor.
+ *
+ * The CPU set of the task may be changed concurrently, in which case
+ * either the old or the new value is observed. Wired threads are not
+ * subject to CPU sets, which is up to the caller to check.
+ *
+ * @param thread Locked thread.
+ * @param cpu    Processor.
+ *
+ * @return True if the thread may run on the processor.
+ *
+ */
+bool cpuset_allows(thread_t *thread, cpu_t *cpu)
+{
+	return cpuset_mask_allows(cpuset_thread_mask(thread), cpu);
+}
+
+/** Choose a processor for a thread.
+ *
+ * @param thread Locked thread.
+ *
+ * @return The least loaded active processor the thread may run on or NULL
+ *         if there is none.
+ *
+ */
+cpu_t *cpuset_pick(thread_t *thread)
+{
+	cpu_mask_t *mask = cpuset_thread_mask(thread);
+	cpu_t *best = NULL;
+	size_t best_nrdy = 0;
+
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		cpu_t *cpu = &cpus[i];
+
+		if ((!cpu->active) || (!cpuset_mask_allows(mask, cpu)))
+			continue;
+
+		size_t nrdy = atomic_load(&cpu->nrdy);
+		if ((best == NULL) || (nrdy < best_nrdy)) {
+			best = cpu;
+			best_nrdy = nrdy;
+		}
+	}
+
+	return best;
+}
+
+/** Copy a CPU set from userspace.
+ *
+ * Bit i of byte j of the userspace CPU set stands for processor
+ * 8 * j + i. Bits of processors which do not exist are ignored.
+ *
+ * @param uspace_mask CPU set in userspace.
+ * @param size        Size of the CPU set in bytes.
+ * @param mask        Place to store the newly allocated CPU set.
+ *
+ * @return EOK on success.
+ * @return EINVAL if the CPU set contains no active processor.
+ * @return ENOMEM if there is not enough memory.
+ * @return Error code of copy_from_uspace() otherwise.
+ *
+ */
+static errno_t cpuset_from_uspace(uspace_addr_t uspace_mask, size_t size,
+    cpu_mask_t **mask)
+{
+	size_t bytes = min(size, CPUSET_BYTES);
+
+	uint8_t *buf = malloc(bytes);
+	if (buf == NULL)
+		return ENOMEM;
+
+	errno_t rc = copy_from_uspace(buf, uspace_mask, bytes);
+	if (rc != EOK) {
+		free(buf);
+		return rc;
+	}
+
+	cpu_mask_t *new = malloc(cpu_mask_size());
+	if (new == NULL) {
+		free(buf);
+		return ENOMEM;
+	}
+
+	cpu_mask_none(new);
+
+	bool active = false;
+	for (unsigned int i = 0; (i < 8 * bytes) && (i < config.cpu_count);
+	    i++) {
+		if (!(buf[i / 8] & (1 << (i % 8))))
+			continue;
+
+		cpu_mask_set(new, i);
+		if (cpus[i].active)
+			active = true;
+	}
+
+	free(buf);
+
+	if (!active) {
+		free(new);
+		return EINVAL;
+	}
+
+	*mask = new;
+	return EOK;
+}
+
+/** Move the current thread off a processor it may not run on anymore. */
+static void cpuset_migrate(void)
+{
+	irq_spinlock_lock(&THREAD->lock, true);
+	bool allowed = (THREAD->wired) || (cpuset_allows(THREAD, CPU));
+	irq_spinlock_unlock(&THREAD->lock, true);
+
+	/* Being ready again, the thread gets placed on an allowed processor */
+	if (!allowed)
+		scheduler();
+}
+
+/** Set the CPU set of the current thread or task (syscall).
+ *
+ * If the current thread may not run on the current processor anymore,
+ * it is migrated right away. Other threads are migrated the next time
+ * they become ready.
+ *
+ * @param scope       Whether to set the CPU set of the thread or the task.
+ * @param uspace_mask CPU set in the format described at
+ *                    cpuset_from_uspace().
+ * @param size        Size of the CPU set in bytes. Zero lifts the
+ *                    restriction.
+ *
+ * @return EOK on success, error code otherwise.
+ *
+ */
+sys_errno_t sys_cpuset_set(sysarg_t scope, uspace_addr_t uspace_mask,
+    size_t size)
+{
+	if ((scope != CPUSET_SCOPE_THREAD) && (scope != CPUSET_SCOPE_TASK))
+		return EINVAL;
+
+	cpu_mask_t *mask = NULL;
+	if (size > 0) {
+		errno_t rc = cpuset_from_uspace(uspace_mask, size, &mask);
+		if (rc != EOK)
+			return (sys_errno_t) rc;
+	}
+
+	if (scope == CPUSET_SCOPE_THREAD) {
+		irq_spinlock_lock(&THREAD->lock, true);
+		cpu_mask_t *old = THREAD->affinity;
+		THREAD->affinity = mask;
+		irq_spinlock_unlock(&THREAD->lock, true);
+
+		mask = old;
+	} else {
+		irq_spinlock_lock(&TASK->lock, true);
+
+		if (mask != NULL) {
+			/*
+			 * The buffer is never freed while the task exists,
+			 * so the readers need not lock the task.
+			 */
+			if (TASK->affinity_buf == NULL) {
+				TASK->affinity_buf = mask;
+				mask = NULL;
+			} else {
+				memcpy(TASK->affinity_buf, mask,
+				    cpu_mask_size());
+			}
+		}
+
+		atomic_store_explicit(&TASK->affinity,
+		    (size > 0) ? TASK->affinity_buf : NULL,
+		    memory_order_release);
+
+		irq_spinlock_unlock(&TASK->lock, true);
+	}
+
+	if (mask != NULL)
+		free(mask);
+
+	cpuset_migrate();
+	return EOK;
+}
+
+/** Get the CPU set of the current thread or task (syscall).
+ *
+ * The CPU set returned for the thread is the one which applies to it,
+ * i.e. the CPU set of the task if the thread has none. If there is no
+ * restriction, the processors which are not isolated are returned.
+ *
+ * @param scope       Whether to get the CPU set of the thread or the task.
+ * @param uspace_mask Buffer for the CPU set in the format described at
+ *                    cpuset_from_uspace(). Bytes beyond the number of
+ *                    processors are not written.
+ * @param size        Size of the buffer in bytes.
+ *
+ * @return EOK on success, error code otherwise.
+ *
+ */
+sys_errno_t sys_cpuset_get(sysarg_t scope, uspace_addr_t uspace_mask,
+    size_t size)
+{
+	if ((scope != CPUSET_SCOPE_THREAD) && (scope != CPUSET_SCOPE_TASK))
+		return EINVAL;
+
+	size_t bytes = min(size, CPUSET_BYTES);
+	if (bytes == 0)
+		return EOK;
+
+	uint8_t *buf = malloc(bytes);
+	if (buf == NULL)
+		return ENOMEM;
+
+	memset(buf, 0, bytes);
+
+	irq_spinlock_lock(&THREAD->lock, true);
+
+	cpu_mask_t *mask = (scope == CPUSET_SCOPE_THREAD) ?
+	    cpuset_thread_mask(THREAD) :
+	    atomic_load_explicit(&TASK->affinity, memory_order_acquire);
+
+	for (unsigned int i = 0; (i < 8 * bytes) && (i < config.cpu_count);
+	    i++) {
+		if (cpuset_mask_allows(mask, &cpus[i]))
+			buf[i / 8] |= 1 << (i % 8);
+	}
+
+	irq_spinlock_unlock(&THREAD->lock, true);
+
+	errno_t rc = copy_to_uspace(uspace_mask, buf, bytes);
+	free(buf);
+
+	return (sys_errno_t) rc;
+}
+
+/** @}
+ */
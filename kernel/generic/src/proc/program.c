@@ -46,6 +46,7 @@
 #include <ipc/ipc.h>
 #include <ipc/ipcrsc.h>
 #include <security/perm.h>
+#include <synch/syswaitq.h>
 #include <lib/elf_load.h>
 #include <str.h>
 #include <log.h>
@@ -193,6 +194,57 @@ errno_t program_create_loader(program_t *prg, char *name)
 	    name, prg);
 }
 
+/** Create a copy-on-write clone of the current task.
+ *
+ * The new task gets a clone of the address space of the current task and
+ * copies of its waitqs. Its main thread starts as described by @a uarg.
+ * Other capabilities are not inherited, the new task is only connected to
+ * the naming service like every other task.
+ *
+ * @param uarg Arguments of the main thread. Freed in uinit() on success.
+ * @param name Name of the new task.
+ * @param prg  Buffer for storing program info.
+ *
+ * @return EOK on success or an error code from @ref errno.h.
+ *
+ */
+errno_t program_create_clone(uspace_arg_t *uarg, char *name, program_t *prg)
+{
+	as_t *as = as_create(0);
+	if (!as)
+		return ENOMEM;
+
+	errno_t rc = as_clone(AS, as);
+	if (rc != EOK) {
+		as_release(as);
+		return rc;
+	}
+
+	prg->loader_status = EOK;
+	prg->task = task_create(as, name);
+	if (!prg->task) {
+		as_release(as);
+		return ELIMIT;
+	}
+
+	rc = sys_waitq_task_clone(prg->task);
+	if (rc != EOK) {
+		task_destroy(prg->task);
+		prg->task = NULL;
+		return rc;
+	}
+
+	prg->main_thread = thread_create(uinit, uarg, prg->task,
+	    THREAD_FLAG_USPACE, "uinit");
+	if (!prg->main_thread) {
+		task_destroy(prg->task);
+		prg->task = NULL;
+		return ELIMIT;
+	}
+
+	return EOK;
+}
+
 /** Make program ready.
  *
  * Switch program's main thread to the ready state.
@@ -244,5 +296,61 @@ sys_errno_t sys_program_spawn_loader(uspace_ptr_char uspace_name, size_t name_le
 	return EOK;
 }
 
+/** Syscall for cloning the current task.
+ *
+ * @param uspace_uarg    Arguments of the main thread of the clone, which
+ *                       must be valid in the cloned address space.
+ * @param uspace_name    Name to set on the new task.
+ * @param name_len       Length of the name.
+ * @param uspace_task_id Userspace address where the ID of the new task is
+ *                       stored.
+ *
+ * @return EOK on success or an error code from @ref errno.h.
+ *
+ */
+sys_errno_t sys_program_clone(uspace_ptr_uspace_arg_t uspace_uarg,
+    uspace_ptr_char uspace_name, size_t name_len,
+    uspace_ptr_task_id_t uspace_task_id)
+{
+	/* Cap length of name and copy it from userspace. */
+	if (name_len > TASK_NAME_BUFLEN - 1)
+		name_len = TASK_NAME_BUFLEN - 1;
+
+	char namebuf[TASK_NAME_BUFLEN];
+	errno_t rc = copy_from_uspace(namebuf, uspace_name, name_len);
+	if (rc != EOK)
+		return (sys_errno_t) rc;
+
+	namebuf[name_len] = 0;
+
+	uspace_arg_t *kernel_uarg =
+	    (uspace_arg_t *) malloc(sizeof(uspace_arg_t));
+	if (!kernel_uarg)
+		return (sys_errno_t) ENOMEM;
+
+	rc = copy_from_uspace(kernel_uarg, uspace_uarg, sizeof(uspace_arg_t));
+	if (rc != EOK) {
+		free(kernel_uarg);
+		return (sys_errno_t) rc;
+	}
+
+	program_t prg;
+	rc = program_create_clone(kernel_uarg, namebuf, &prg);
+	if (rc != EOK) {
+		free(kernel_uarg);
+		return (sys_errno_t) rc;
+	}
+
+	task_id_t taskid = prg.task->taskid;
+
+	// FIXME: control the permissions
+	perm_set(prg.task, perm_get(TASK));
+	program_ready(&prg);
+
+	/* The clone is running already, a failed copy cannot undo that. */
+	return (sys_errno_t) copy_to_uspace(uspace_task_id, &taskid,
+	    sizeof(taskid));
+}
+
 /** @}
  */
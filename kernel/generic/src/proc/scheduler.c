@@ -40,9 +40,11 @@
 
 #include <assert.h>
 #include <atomic.h>
+#include <bitops.h>
 #include <proc/scheduler.h>
 #include <proc/thread.h>
 #include <proc/task.h>
+#include <proc/cpuset.h>
 #include <mm/frame.h>
 #include <mm/page.h>
 #include <mm/as.h>
@@ -52,6 +54,7 @@
 #include <arch/faddr.h>
 #include <arch/cycle.h>
 #include <atomic.h>
+#include <synch/rcu.h>
 #include <synch/spinlock.h>
 #include <config.h>
 #include <context.h>
@@ -64,11 +67,18 @@
 #include <stdio.h>
 #include <log.h>
 #include <stacktrace.h>
+#include <sysinfo/stats.h>
 
 static void scheduler_separated_stack(void);
+#ifdef CONFIG_SMP
+static bool steal_work(void);
+#endif
 
 atomic_size_t nrdy;  /**< Number of ready threads in the system. */
 
+/** Time quantum of threads taken from each run queue in microseconds. */
+static atomic_uint rq_quantum[RQ_COUNT];
+
 /** Carry out actions before new task runs. */
 static void before_task_runs(void)
 {
@@ -170,6 +180,43 @@ void scheduler_fpu_lazy_request(void)
  */
 void scheduler_init(void)
 {
+	for (unsigned int i = 0; i < RQ_COUNT; i++)
+		atomic_init(&rq_quantum[i], RQ_QUANTUM_DEFAULT(i));
+}
+
+/** Set the time quantum of a run queue
+ *
+ * The new quantum applies to threads scheduled from the run queue from
+ * now on. It has no effect on real-time threads, which run until they
+ * sleep or yield.
+ *
+ * @param rq   Run queue index.
+ * @param usec Time quantum in microseconds.
+ *
+ * @return EOK on success, EINVAL if the run queue index or the quantum
+ *         is out of range.
+ *
+ */
+errno_t scheduler_quantum_set(unsigned int rq, uint32_t usec)
+{
+	if ((rq >= RQ_COUNT) || (usec < RQ_QUANTUM_MIN))
+		return EINVAL;
+
+	atomic_store_explicit(&rq_quantum[rq], usec, memory_order_relaxed);
+	return EOK;
+}
+
+/** Get the time quantum of a run queue
+ *
+ * @param rq Run queue index.
+ *
+ * @return Time quantum in microseconds.
+ *
+ */
+uint32_t scheduler_quantum_get(unsigned int rq)
+{
+	assert(rq < RQ_COUNT);
+	return atomic_load_explicit(&rq_quantum[rq], memory_order_relaxed);
 }
 
 /** Get thread to be scheduled
@@ -186,6 +233,21 @@ static thread_t *find_best_thread(void)
 	assert(CPU != NULL);
 
 loop:
+	/*
+	 * No thread runs on this processor now, so it cannot be in an RCU
+	 * read-side section. This is also reached on every wakeup while
+	 * the processor is idle.
+	 */
+	rcu_quiescent();
+
+#ifdef CONFIG_SMP
+	/*
+	 * Before going idle, try to steal some work from a busy CPU
+	 * instead of waiting for kcpulb to balance the load.
+	 */
+	if ((atomic_load(&CPU->nrdy) == 0) && (steal_work()))
+		goto loop;
+#endif
 
 	if (atomic_load(&CPU->nrdy) == 0) {
 		/*
@@ -196,6 +258,13 @@ loop:
 		irq_spinlock_lock(&CPU->lock, false);
 		CPU->idle = true;
 		irq_spinlock_unlock(&CPU->lock, false);
+
+		/*
+		 * There is no need to be woken up by the periodic tick
+		 * until the nearest timeout expires.
+		 */
+		clock_tick_stop();
+
 		interrupts_enable();
 
 		/*
@@ -210,20 +279,38 @@ loop:
 
 	assert(!CPU->idle);
 
-	unsigned int i;
-	for (i = 0; i < RQ_COUNT; i++) {
+	uint64_t begin_cycle = get_cycle();
+
+	/*
+	 * Whichever thread is chosen, a pending preemption request has been
+	 * served. Clear it before looking at the run queues so that a
+	 * real-time thread readied in the meantime gets its request seen.
+	 */
+	atomic_store_explicit(&CPU->preempt_request, false,
+	    memory_order_relaxed);
+
+	/*
+	 * Instead of probing all the run queues in turn, find the
+	 * highest-priority non-empty queue in the bitmap and lock just
+	 * that one. The bitmap is read without holding any lock, so the
+	 * queue might have been emptied in the meantime (e.g. by kcpulb
+	 * or relink_rq()). In that case, simply try the next one.
+	 */
+	unsigned int mask = atomic_load(&CPU->rq_bitmap);
+	while (mask != 0) {
+		unsigned int i = lnzb32(mask);
+		mask &= ~RQ_BIT(i);
+
 		irq_spinlock_lock(&(CPU->rq[i].lock), false);
 		if (CPU->rq[i].n == 0) {
-			/*
-			 * If this queue is empty, try a lower-priority queue.
-			 */
 			irq_spinlock_unlock(&(CPU->rq[i].lock), false);
 			continue;
 		}
 
 		atomic_dec(&CPU->nrdy);
 		atomic_dec(&nrdy);
-		CPU->rq[i].n--;
+		if (--CPU->rq[i].n == 0)
+			atomic_fetch_and(&CPU->rq_bitmap, ~RQ_BIT(i));
 
 		/*
 		 * Take the first thread from the queue.
@@ -237,11 +324,20 @@ loop:
 		thread->cpu = CPU;
 		thread->priority = i;  /* Correct rq index */
 
-		/* Time allocation in microseconds. */
-		uint64_t time_to_run = (i + 1) * 10000;
-
-		/* This is safe because interrupts are disabled. */
-		CPU->preempt_deadline = CPU->current_clock_tick + us2ticks(time_to_run);
+		/*
+		 * This is safe because interrupts are disabled.
+		 * Real-time threads run until they sleep or yield.
+		 */
+		if (thread->sched_class == SCHED_CLASS_FIFO) {
+			CPU->preempt_deadline = UINT64_MAX;
+		} else {
+			/* Time allocation in microseconds. */
+			uint64_t time_to_run = atomic_load_explicit(
+			    &rq_quantum[i], memory_order_relaxed);
+
+			CPU->preempt_deadline = CPU->current_clock_tick +
+			    us2ticks(time_to_run);
+		}
 
 		/*
 		 * Clear the stolen flag so that it can be migrated
@@ -250,6 +346,10 @@ loop:
 		thread->stolen = false;
 		irq_spinlock_unlock(&thread->lock, false);
 
+		/* This is safe because interrupts are disabled. */
+		CPU->sched_count++;
+		CPU->sched_cycles += get_cycle() - begin_cycle;
+
 		return thread;
 	}
 
@@ -263,6 +363,7 @@ loop:
  * When the function decides to relink rq's, it reconnects
  * respective pointers so that in result threads with 'pri'
  * greater or equal start are moved to a higher-priority queue.
+ * Time-sharing threads are never moved to the real-time queue.
  *
  * @param start Threshold priority.
  *
@@ -274,6 +375,9 @@ static void relink_rq(int start)
 
 	CPU->relink_deadline = CPU->current_clock_tick + NEEDS_RELINK_MAX;
 
+	if (start < RQ_TS_FIRST)
+		start = RQ_TS_FIRST;
+
 	list_t list;
 	list_initialize(&list);
 
@@ -286,6 +390,7 @@ static void relink_rq(int start)
 		list_concat(&list, &CPU->rq[i + 1].rq);
 		size_t n = CPU->rq[i + 1].n;
 		CPU->rq[i + 1].n = 0;
+		atomic_fetch_and(&CPU->rq_bitmap, ~RQ_BIT(i + 1));
 		irq_spinlock_unlock(&CPU->rq[i + 1].lock, false);
 
 		/* Append rq[i + 1] to rq[i] */
@@ -293,6 +398,8 @@ static void relink_rq(int start)
 		irq_spinlock_lock(&CPU->rq[i].lock, false);
 		list_concat(&CPU->rq[i].rq, &list);
 		CPU->rq[i].n += n;
+		if (CPU->rq[i].n > 0)
+			atomic_fetch_or(&CPU->rq_bitmap, RQ_BIT(i));
 		irq_spinlock_unlock(&CPU->rq[i].lock, false);
 	}
 
@@ -412,11 +519,17 @@ void scheduler_separated_stack(void)
 		as_hold(old_as);
 
 	if (THREAD) {
+		uint64_t burst;
+
 		/* Must be run after the switch to scheduler stack */
 		after_thread_ran();
+		THREAD->stats_gen = STATS_GENERATION();
+		atomic_store_explicit(&THREAD->on_cpu, false,
+		    memory_order_relaxed);
 
 		switch (THREAD->state) {
 		case Running:
+			THREAD->ivcsw++;
 			irq_spinlock_unlock(&THREAD->lock, false);
 			thread_ready(THREAD);
 			break;
@@ -435,9 +548,17 @@ void scheduler_separated_stack(void)
 
 		case Sleeping:
 			/*
-			 * Prefer the thread after it's woken up.
+			 * Remember how long the thread ran since it last went
+			 * to sleep. The thread's priority after it wakes up
+			 * is derived from that.
 			 */
-			THREAD->priority = -1;
+			burst = THREAD->ucycles + THREAD->kcycles;
+			THREAD->avg_run = (THREAD->avg_run *
+			    (SCHED_AVG_WEIGHT - 1) + burst -
+			    THREAD->burst_start) / SCHED_AVG_WEIGHT;
+			THREAD->burst_start = burst;
+			THREAD->vcsw++;
+			THREAD->state_cycle = get_cycle();
 			irq_spinlock_unlock(&THREAD->lock, false);
 			break;
 
@@ -492,6 +613,12 @@ void scheduler_separated_stack(void)
 
 	irq_spinlock_lock(&THREAD->lock, false);
 	THREAD->state = Running;
+	atomic_store_explicit(&THREAD->on_cpu, true, memory_order_relaxed);
+
+	/* Account the time the thread waited in the run queue */
+	uint64_t now = get_cycle();
+	if (now > THREAD->state_cycle)
+		THREAD->rqcycles += now - THREAD->state_cycle;
 
 #ifdef SCHEDULER_VERBOSE
 	log(LF_OTHER, LVL_DEBUG,
@@ -522,6 +649,149 @@ void scheduler_separated_stack(void)
 }
 
 #ifdef CONFIG_SMP
+/** Steal a thread from another CPU
+ *
+ * Search the run queue @a rq of @a cpu from the back for a thread
+ * which can be migrated and remove it from the run queue. The thread
+ * is marked as stolen so that thread_ready() readies it to the
+ * current CPU.
+ *
+ * @param cpu CPU to steal from.
+ * @param rq  Index of the run queue to search.
+ *
+ * @return Stolen thread which is to be passed to thread_ready() or NULL
+ *         if there was no suitable thread.
+ *
+ */
+static thread_t *steal_thread(cpu_t *cpu, int rq)
+{
+	irq_spinlock_lock(&(cpu->rq[rq].lock), true);
+	if (cpu->rq[rq].n == 0) {
+		irq_spinlock_unlock(&(cpu->rq[rq].lock), true);
+		return NULL;
+	}
+
+	thread_t *thread = NULL;
+
+	/* Search rq from the back */
+	link_t *link = list_last(&cpu->rq[rq].rq);
+
+	while (link != NULL) {
+		thread = (thread_t *) list_get_instance(link, thread_t,
+		    rq_link);
+
+		/*
+		 * Do not steal CPU-wired threads, threads already stolen,
+		 * threads for which migration was temporarily disabled,
+		 * threads whose FPU context is still in the CPU or threads
+		 * whose CPU set does not include the current CPU.
+		 */
+		irq_spinlock_lock(&thread->lock, false);
+
+		if ((!thread->wired) && (!thread->stolen) &&
+		    (!thread->nomigrate) && (!thread->fpu_context_engaged) &&
+		    (cpuset_allows(thread, CPU))) {
+			/*
+			 * Remove thread from ready queue.
+			 */
+			irq_spinlock_unlock(&thread->lock, false);
+
+			atomic_dec(&cpu->nrdy);
+			atomic_dec(&nrdy);
+
+			if (--cpu->rq[rq].n == 0)
+				atomic_fetch_and(&cpu->rq_bitmap, ~RQ_BIT(rq));
+			list_remove(&thread->rq_link);
+
+			break;
+		}
+
+		irq_spinlock_unlock(&thread->lock, false);
+
+		link = list_prev(link, &cpu->rq[rq].rq);
+		thread = NULL;
+	}
+
+	if (thread == NULL) {
+		irq_spinlock_unlock(&(cpu->rq[rq].lock), true);
+		return NULL;
+	}
+
+	irq_spinlock_pass(&(cpu->rq[rq].lock), &thread->lock);
+
+#ifdef KCPULB_VERBOSE
+	log(LF_OTHER, LVL_DEBUG,
+	    "cpu%u: TID %" PRIu64 " -> cpu%u, nrdy=%ld, avg=%ld",
+	    cpu->id, thread->tid, CPU->id, atomic_load(&CPU->nrdy),
+	    atomic_load(&nrdy) / config.cpu_active);
+#endif
+
+	thread->stolen = true;
+	thread->state = Entering;
+
+	irq_spinlock_unlock(&thread->lock, true);
+
+	return thread;
+}
+
+/** Steal work for an idle CPU
+ *
+ * Called by find_best_thread() when the local run queues are empty.
+ * Busy CPUs are probed starting with the nearest one, i.e. SMT siblings
+ * first, then CPUs in the same package, then CPUs in the same NUMA node
+ * and only then the rest of the system. The number of probes is limited
+ * by STEAL_ATTEMPTS_MAX so that an idle CPU does not spend too much time
+ * (and cache traffic) on remote run queues.
+ *
+ * Interrupts must be disabled.
+ *
+ * @return True if a thread was stolen and readied to the current CPU.
+ *
+ */
+static bool steal_work(void)
+{
+	size_t attempts = 0;
+
+	for (cpu_domain_t dom = 0; dom < CPU_DOMAIN_COUNT; dom++) {
+		for (size_t dist = 1; dist < config.cpu_active; dist++) {
+			cpu_t *cpu = &cpus[(CPU->id + dist) % config.cpu_active];
+
+			if (cpu_domain(CPU, cpu) != dom)
+				continue;
+
+			/*
+			 * Only consider CPUs which have some thread waiting
+			 * in addition to the one they are running.
+			 */
+			if (atomic_load(&cpu->nrdy) == 0)
+				continue;
+
+			if (attempts++ == STEAL_ATTEMPTS_MAX)
+				goto failed;
+
+			/* Steal from the lowest-priority queue first. */
+			unsigned int mask = atomic_load(&cpu->rq_bitmap);
+			while (mask != 0) {
+				int rq = fnzb32(mask);
+				mask &= ~RQ_BIT(rq);
+
+				thread_t *thread = steal_thread(cpu, rq);
+				if (thread) {
+					thread_ready(thread);
+					CPU->steals++;
+					return true;
+				}
+			}
+		}
+	}
+
+failed:
+	if (attempts > 0)
+		CPU->steals_failed++;
+
+	return false;
+}
+
 /** Load balancing thread
  *
  * SMP load balancing thread, supervising thread supplies
@@ -558,111 +828,50 @@ not_satisfied:
 
 	/*
 	 * Searching least priority queues on all CPU's first and most priority
-	 * queues on all CPU's last.
+	 * queues on all CPU's last. Within each priority, prefer the CPUs
+	 * from the smallest scheduling domain shared with this CPU.
 	 */
 	size_t acpu;
 	size_t acpu_bias = 0;
 	int rq;
 
 	for (rq = RQ_COUNT - 1; rq >= 0; rq--) {
-		for (acpu = 0; acpu < config.cpu_active; acpu++) {
-			cpu_t *cpu = &cpus[(acpu + acpu_bias) % config.cpu_active];
-
-			/*
-			 * Not interested in ourselves.
-			 * Doesn't require interrupt disabling for kcpulb has
-			 * THREAD_FLAG_WIRED.
-			 *
-			 */
-			if (CPU == cpu)
-				continue;
+		for (cpu_domain_t dom = 0; dom < CPU_DOMAIN_COUNT; dom++) {
+			for (acpu = 0; acpu < config.cpu_active; acpu++) {
+				cpu_t *cpu = &cpus[(acpu + acpu_bias) %
+				    config.cpu_active];
 
-			if (atomic_load(&cpu->nrdy) <= average)
-				continue;
-
-			irq_spinlock_lock(&(cpu->rq[rq].lock), true);
-			if (cpu->rq[rq].n == 0) {
-				irq_spinlock_unlock(&(cpu->rq[rq].lock), true);
-				continue;
-			}
+				/*
+				 * Not interested in ourselves.
+				 * Doesn't require interrupt disabling for
+				 * kcpulb has THREAD_FLAG_WIRED.
+				 *
+				 */
+				if (CPU == cpu)
+					continue;
 
-			thread_t *thread = NULL;
+				if (cpu_domain(CPU, cpu) != dom)
+					continue;
 
-			/* Search rq from the back */
-			link_t *link = list_last(&cpu->rq[rq].rq);
+				if (atomic_load(&cpu->nrdy) <= average)
+					continue;
 
-			while (link != NULL) {
-				thread = (thread_t *) list_get_instance(link,
-				    thread_t, rq_link);
+				thread_t *thread = steal_thread(cpu, rq);
+				if (thread) {
+					thread_ready(thread);
+					CPU->migrations++;
 
-				/*
-				 * Do not steal CPU-wired threads, threads
-				 * already stolen, threads for which migration
-				 * was temporarily disabled or threads whose
-				 * FPU context is still in the CPU.
-				 */
-				irq_spinlock_lock(&thread->lock, false);
+					if (--count == 0)
+						goto satisfied;
 
-				if ((!thread->wired) && (!thread->stolen) &&
-				    (!thread->nomigrate) &&
-				    (!thread->fpu_context_engaged)) {
 					/*
-					 * Remove thread from ready queue.
+					 * We are not satisfied yet, focus on
+					 * another CPU next time.
+					 *
 					 */
-					irq_spinlock_unlock(&thread->lock,
-					    false);
-
-					atomic_dec(&cpu->nrdy);
-					atomic_dec(&nrdy);
-
-					cpu->rq[rq].n--;
-					list_remove(&thread->rq_link);
-
-					break;
+					acpu_bias++;
 				}
-
-				irq_spinlock_unlock(&thread->lock, false);
-
-				link = list_prev(link, &cpu->rq[rq].rq);
-				thread = NULL;
 			}
-
-			if (thread) {
-				/*
-				 * Ready thread on local CPU
-				 */
-
-				irq_spinlock_pass(&(cpu->rq[rq].lock),
-				    &thread->lock);
-
-#ifdef KCPULB_VERBOSE
-				log(LF_OTHER, LVL_DEBUG,
-				    "kcpulb%u: TID %" PRIu64 " -> cpu%u, "
-				    "nrdy=%ld, avg=%ld", CPU->id, thread->tid,
-				    CPU->id, atomic_load(&CPU->nrdy),
-				    atomic_load(&nrdy) / config.cpu_active);
-#endif
-
-				thread->stolen = true;
-				thread->state = Entering;
-
-				irq_spinlock_unlock(&thread->lock, true);
-				thread_ready(thread);
-
-				if (--count == 0)
-					goto satisfied;
-
-				/*
-				 * We are not satisfied yet, focus on another
-				 * CPU next time.
-				 *
-				 */
-				acpu_bias++;
-
-				continue;
-			} else
-				irq_spinlock_unlock(&(cpu->rq[rq].lock), true);
-
 		}
 	}
 
@@ -703,9 +912,10 @@ void sched_print_list(void)
 		/* Technically a data race, but we don't really care in this case. */
 		int needs_relink = cpus[cpu].relink_deadline - cpus[cpu].current_clock_tick;
 
-		printf("cpu%u: address=%p, nrdy=%zu, needs_relink=%d\n",
-		    cpus[cpu].id, &cpus[cpu], atomic_load(&cpus[cpu].nrdy),
-		    needs_relink);
+		printf("cpu%u: address=%p, nrdy=%zu, needs_relink=%d, "
+		    "rq_bitmap=%#x\n", cpus[cpu].id, &cpus[cpu],
+		    atomic_load(&cpus[cpu].nrdy), needs_relink,
+		    atomic_load(&cpus[cpu].rq_bitmap));
 
 		unsigned int i;
 		for (i = 0; i < RQ_COUNT; i++) {
@@ -715,7 +925,8 @@ void sched_print_list(void)
 				continue;
 			}
 
-			printf("\trq[%u]: ", i);
+			printf("\trq[%u] (quantum %" PRIu32 " us): ", i,
+			    scheduler_quantum_get(i));
 			list_foreach(cpus[cpu].rq[i].rq, rq_link, thread_t,
 			    thread) {
 				printf("%" PRIu64 "(%s) ", thread->tid,
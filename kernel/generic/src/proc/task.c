@@ -42,6 +42,7 @@
 #include <mm/as.h>
 #include <mm/slab.h>
 #include <atomic.h>
+#include <synch/rcu.h>
 #include <synch/spinlock.h>
 #include <synch/waitq.h>
 #include <arch.h>
@@ -52,12 +53,16 @@
 #include <ipc/ipc.h>
 #include <ipc/ipcrsc.h>
 #include <ipc/event.h>
+#include <ipc/profile.h>
 #include <stdio.h>
 #include <errno.h>
 #include <halt.h>
 #include <str.h>
 #include <syscall/copy.h>
+#include <sysinfo/stats.h>
 #include <macros.h>
+#include <member.h>
+#include <stdlib.h>
 
 /** Spinlock protecting the @c tasks ordered dictionary. */
 IRQ_SPINLOCK_INITIALIZE(tasks_lock);
@@ -77,6 +82,19 @@ IRQ_SPINLOCK_INITIALIZE(tasks_lock);
  */
 odict_t tasks;
 
+/** Number of chains of the task hash, a power of two */
+#define TASKS_HASH_CHAINS  256
+
+/** Hash of active tasks by task ID.
+ *
+ * The hash holds the same tasks as the @c tasks dictionary and is modified
+ * along with it under tasks_lock, but task_find_by_id() searches it without
+ * the lock in an RCU read-side section. Task structures are freed only after
+ * a grace period.
+ *
+ */
+static _Atomic(task_t *) tasks_hash[TASKS_HASH_CHAINS];
+
 static task_id_t task_counter = 0;
 
 static slab_cache_t *task_cache;
@@ -89,6 +107,17 @@ static size_t tsk_destructor(void *);
 static void *tasks_getkey(odlink_t *);
 static int tasks_cmp(void *, void *);
 
+/** Get the chain of the task hash for a task ID. */
+static _Atomic(task_t *) *task_hash_chain(task_id_t id)
+{
+	return &tasks_hash[id & (TASKS_HASH_CHAINS - 1)];
+}
+
+static void task_free_rcu(rcu_item_t *item)
+{
+	slab_free(task_cache, member_to_inst(item, task_t, rcu));
+}
+
 /** Initialize kernel tasks support.
  *
  */
@@ -208,6 +237,9 @@ task_t *task_create(as_t *as, const char *name)
 
 	task->container = CONTAINER;
 	task->perms = 0;
+	task->sched_class = SCHED_CLASS_TS;
+	atomic_init(&task->affinity, NULL);
+	task->affinity_buf = NULL;
 	task->ucycles = 0;
 	task->kcycles = 0;
 
@@ -219,6 +251,14 @@ task_t *task_create(as_t *as, const char *name)
 	task->ipc_info.answer_received = 0;
 	task->ipc_info.irq_notif_received = 0;
 	task->ipc_info.forwarded = 0;
+	task->ipc_info.data_written = 0;
+	task->ipc_info.data_written_pinned = 0;
+	task->ipc_info.data_read = 0;
+	task->ipc_info.data_read_pinned = 0;
+
+#ifdef CONFIG_IPC_PROFILE
+	ipc_profile_init(task);
+#endif
 
 	event_task_init(task);
 
@@ -254,6 +294,11 @@ task_t *task_create(as_t *as, const char *name)
 	task->taskid = ++task_counter;
 	odlink_initialize(&task->ltasks);
 	odict_insert(&task->ltasks, &tasks, NULL);
+	_Atomic(task_t *) *chain = task_hash_chain(task->taskid);
+	atomic_init(&task->hash_next,
+	    atomic_load_explicit(chain, memory_order_relaxed));
+	rcu_assign(*chain, task);
+	stats_page_set_tasks(task_count());
 
 	irq_spinlock_unlock(&tasks_lock, true);
 
@@ -272,6 +317,14 @@ void task_destroy(task_t *task)
 	 */
 	irq_spinlock_lock(&tasks_lock, true);
 	odict_remove(&task->ltasks);
+	_Atomic(task_t *) *link = task_hash_chain(task->taskid);
+	task_t *cur;
+	while ((cur = atomic_load_explicit(link, memory_order_relaxed)) != task)
+		link = &cur->hash_next;
+	/* RCU readers which still see the task can carry on with the search. */
+	rcu_assign(*link, atomic_load_explicit(&task->hash_next,
+	    memory_order_relaxed));
+	stats_page_set_tasks(task_count());
 	irq_spinlock_unlock(&tasks_lock, true);
 
 	/*
@@ -284,7 +337,11 @@ void task_destroy(task_t *task)
 	 */
 	as_release(task->as);
 
-	slab_free(task_cache, task);
+	if (task->affinity_buf != NULL)
+		free(task->affinity_buf);
+
+	/* task_find_by_id() might still be looking at the structure. */
+	call_rcu(&task->rcu, task_free_rcu);
 }
 
 /** Hold a reference to a task.
@@ -413,8 +470,10 @@ sys_errno_t sys_task_kill(uspace_ptr_task_id_t uspace_taskid)
 
 /** Find task structure corresponding to task ID.
  *
- * The tasks_lock must be already held by the caller of this function and
- * interrupts must be disabled.
+ * The caller must either hold the tasks_lock or be in an RCU read-side
+ * section. The task structure stays valid until the lock is released or
+ * the read-side section is left, unless a reference is taken. An RCU
+ * reader may find a task which is being destroyed.
  *
  * @param id Task ID.
  *
@@ -423,16 +482,48 @@ sys_errno_t sys_task_kill(uspace_ptr_task_id_t uspace_taskid)
  */
 task_t *task_find_by_id(task_id_t id)
 {
-	assert(interrupts_disabled());
-	assert(irq_spinlock_locked(&tasks_lock));
+	assert(PREEMPTION_DISABLED);
 
-	odlink_t *odlink = odict_find_eq(&tasks, &id, NULL);
-	if (odlink != NULL)
-		return odict_get_instance(odlink, task_t, ltasks);
+	for (task_t *task = rcu_access(*task_hash_chain(id)); task != NULL;
+	    task = rcu_access(task->hash_next)) {
+		if (task->taskid == id)
+			return task;
+	}
 
 	return NULL;
 }
 
+/** Find task by ID and hold a reference to it.
+ *
+ * @param id Task ID.
+ *
+ * @return Held task or NULL if there is no such task or the task is
+ *         being destroyed.
+ *
+ */
+task_t *task_get_by_id(task_id_t id)
+{
+	rcu_read_lock();
+
+	task_t *task = task_find_by_id(id);
+	if (task != NULL) {
+		size_t refcount = atomic_load_explicit(&task->refcount,
+		    memory_order_relaxed);
+		do {
+			if (refcount == 0) {
+				task = NULL;
+				break;
+			}
+		} while (!atomic_compare_exchange_weak_explicit(&task->refcount,
+		    &refcount, refcount + 1, memory_order_acquire,
+		    memory_order_relaxed));
+	}
+
+	rcu_read_unlock();
+
+	return task;
+}
+
 /** Get count of tasks.
  *
  * @return Number of tasks in the system
@@ -611,6 +702,47 @@ sys_errno_t sys_task_exit(sysarg_t notify)
 	unreachable();
 }
 
+/** Syscall for setting the scheduling class of the current task.
+ *
+ * The class applies to all userspace threads of the task, including those
+ * created later. A thread switches to the new class the next time it
+ * becomes ready.
+ *
+ * @param sched_class New scheduling class.
+ *
+ * @return EOK on success.
+ * @return EINVAL if the scheduling class is not valid.
+ * @return EPERM if the task is not entitled to use the real-time class.
+ *
+ */
+sys_errno_t sys_task_set_sched_class(sysarg_t sched_class)
+{
+	if ((sched_class != SCHED_CLASS_TS) &&
+	    (sched_class != SCHED_CLASS_FIFO))
+		return EINVAL;
+
+	if ((sched_class == SCHED_CLASS_FIFO) &&
+	    (!(perm_get(TASK) & PERM_SCHED)))
+		return EPERM;
+
+	irq_spinlock_lock(&TASK->lock, true);
+
+	TASK->sched_class = (sched_class_t) sched_class;
+
+	list_foreach(TASK->threads, th_link, thread_t, thread) {
+		if (!thread->uspace)
+			continue;
+
+		irq_spinlock_lock(&thread->lock, false);
+		thread->sched_class = (sched_class_t) sched_class;
+		irq_spinlock_unlock(&thread->lock, false);
+	}
+
+	irq_spinlock_unlock(&TASK->lock, true);
+
+	return EOK;
+}
+
 static void task_print(task_t *task, bool additional)
 {
 	irq_spinlock_lock(&task->lock, false);
@@ -40,6 +40,7 @@
 #include <proc/scheduler.h>
 #include <proc/thread.h>
 #include <proc/task.h>
+#include <proc/cpuset.h>
 #include <mm/frame.h>
 #include <mm/page.h>
 #include <arch/asm.h>
@@ -66,6 +67,7 @@
 #include <stdlib.h>
 #include <main/uinit.h>
 #include <syscall/copy.h>
+#include <sysinfo/stats.h>
 #include <errno.h>
 #include <debug.h>
 #include <halt.h>
@@ -256,14 +258,40 @@ static void before_thread_is_ready(thread_t *thread)
 	assert(irq_spinlock_locked(&thread->lock));
 }
 
+/** Get the run queue of a time-sharing thread which has just woken up
+ *
+ * A thread which spends most of its time sleeping (e.g. waiting for user
+ * input and then quickly reacting to it) is considered interactive and
+ * gets to the highest-priority queue. A thread which mostly runs and only
+ * sleeps briefly from time to time gets a lower-priority queue, so that
+ * it cannot monopolize the processor by sleeping just before its quantum
+ * expires.
+ *
+ * @param thread Thread which has just woken up.
+ *
+ * @return Run queue index.
+ *
+ */
+static int thread_wakeup_rq(thread_t *thread)
+{
+	uint64_t total = thread->avg_run + thread->avg_sleep;
+	if (total == 0)
+		return RQ_TS_FIRST;
+
+	return RQ_TS_FIRST +
+	    (int) ((thread->avg_run * RQ_WAKEUP_LEVELS) / (total + 1));
+}
+
 /** Make thread ready
  *
  * Switch thread to the ready state. Consumes reference passed by the caller.
  *
- * @param thread Thread to make ready.
+ * @param thread  Thread to make ready.
+ * @param handoff If true and the thread can run on the current CPU, queue
+ *                it there in front of other threads of the same priority.
  *
  */
-void thread_ready(thread_t *thread)
+static void _thread_ready(thread_t *thread, bool handoff)
 {
 	irq_spinlock_lock(&thread->lock, true);
 
@@ -271,8 +299,52 @@ void thread_ready(thread_t *thread)
 
 	before_thread_is_ready(thread);
 
-	int i = (thread->priority < RQ_COUNT - 1) ?
-	    ++thread->priority : thread->priority;
+	bool preempted = (thread->state == Running);
+
+	/* Account the time the thread was blocked */
+	uint64_t now = get_cycle();
+	if (thread->state == Sleeping && now > thread->state_cycle) {
+		uint64_t blocked = now - thread->state_cycle;
+
+		thread->avg_sleep = (thread->avg_sleep *
+		    (SCHED_AVG_WEIGHT - 1) + blocked) / SCHED_AVG_WEIGHT;
+
+		/* Prefer the thread after it's woken up */
+		thread->priority = thread_wakeup_rq(thread) - 1;
+
+		switch (thread->block_reason) {
+		case THREAD_BLOCK_IPC:
+			thread->ipc_cycles += blocked;
+			break;
+		case THREAD_BLOCK_FUTEX:
+			thread->futex_cycles += blocked;
+			break;
+		default:
+			thread->sleep_cycles += blocked;
+			break;
+		}
+	}
+	thread->state_cycle = now;
+	thread->stats_gen = STATS_GENERATION();
+
+	/*
+	 * Real-time threads always go to their own run queue, time-sharing
+	 * threads are demoted each time they get ready without sleeping.
+	 */
+	bool fifo = (thread->sched_class == SCHED_CLASS_FIFO);
+	int i;
+	if (fifo) {
+		i = RQ_FIFO;
+		thread->priority = i;
+	} else {
+		i = (thread->priority < RQ_COUNT - 1) ?
+		    ++thread->priority : thread->priority;
+	}
+
+	if (thread->inherited_priority < i) {
+		i = thread->inherited_priority;
+		thread->priority = i;
+	}
 
 	cpu_t *cpu;
 	if (thread->wired || thread->nomigrate || thread->fpu_context_engaged) {
@@ -280,31 +352,71 @@ void thread_ready(thread_t *thread)
 		assert(thread->cpu != NULL);
 		cpu = thread->cpu;
 	} else if (thread->stolen) {
-		/* Ready to the stealing CPU */
+		/* Ready to the stealing CPU, which checked the CPU set */
+		cpu = CPU;
+	} else if ((handoff) && (CPU) && (cpuset_allows(thread, CPU))) {
+		/* The current CPU is about to be handed off to the thread */
 		cpu = CPU;
-	} else if (thread->cpu) {
+	} else if ((thread->cpu) && (cpuset_allows(thread, thread->cpu))) {
 		/* Prefer the CPU on which the thread ran last */
-		assert(thread->cpu != NULL);
 		cpu = thread->cpu;
-	} else {
+	} else if (cpuset_allows(thread, CPU)) {
 		cpu = CPU;
+	} else {
+		/* Pick an allowed CPU, stay here if none is active */
+		cpu = cpuset_pick(thread);
+		if (cpu == NULL)
+			cpu = CPU;
 	}
 
 	thread->state = Ready;
 
+	/* Remember where the thread is queued for thread_priority_inherit() */
+	thread->cpu = cpu;
+
 	irq_spinlock_pass(&thread->lock, &(cpu->rq[i].lock));
 
 	/*
 	 * Append thread to respective ready queue
-	 * on respective processor.
+	 * on respective processor. A preempted real-time
+	 * thread stays in front of its queue.
 	 */
 
-	list_append(&thread->rq_link, &cpu->rq[i].rq);
-	cpu->rq[i].n++;
+	if (((handoff) && (cpu == CPU)) || ((fifo) && (preempted)))
+		list_prepend(&thread->rq_link, &cpu->rq[i].rq);
+	else
+		list_append(&thread->rq_link, &cpu->rq[i].rq);
+	if (cpu->rq[i].n++ == 0)
+		atomic_fetch_or(&cpu->rq_bitmap, RQ_BIT(i));
 	irq_spinlock_unlock(&(cpu->rq[i].lock), true);
 
 	atomic_inc(&nrdy);
 	atomic_inc(&cpu->nrdy);
+
+	/*
+	 * Do not let a real-time thread wait for the end of the quantum of
+	 * a time-sharing thread. If the processor is running a real-time
+	 * thread already, that thread gets preempted and immediately
+	 * rescheduled from the front of the queue.
+	 */
+	if ((fifo) && (!preempted))
+		atomic_store_explicit(&cpu->preempt_request, true,
+		    memory_order_relaxed);
+
+	/* The processor might be sleeping with its tick stopped. */
+	clock_tick_kick(cpu);
+}
+
+/** Make thread ready
+ *
+ * Switch thread to the ready state. Consumes reference passed by the caller.
+ *
+ * @param thread Thread to make ready.
+ *
+ */
+void thread_ready(thread_t *thread)
+{
+	_thread_ready(thread, false);
 }
 
 /** Create new thread
@@ -359,11 +471,27 @@ thread_t *thread_create(void (*func)(void *), void *arg, task_t *task,
 	thread->thread_arg = arg;
 	thread->ucycles = 0;
 	thread->kcycles = 0;
+	thread->rqcycles = 0;
+	thread->ipc_cycles = 0;
+	thread->futex_cycles = 0;
+	thread->sleep_cycles = 0;
+	thread->state_cycle = 0;
+	thread->vcsw = 0;
+	thread->ivcsw = 0;
+	thread->block_reason = THREAD_BLOCK_OTHER;
+	thread->stats_gen = STATS_GENERATION();
 	thread->uncounted =
 	    ((flags & THREAD_FLAG_UNCOUNTED) == THREAD_FLAG_UNCOUNTED);
-	thread->priority = -1;          /* Start in rq[0] */
+	thread->sched_class = SCHED_CLASS_TS;
+	thread->priority = RQ_TS_FIRST - 1;  /* Start in rq[RQ_TS_FIRST] */
+	thread->avg_run = 0;
+	thread->avg_sleep = 0;
+	thread->burst_start = 0;
+	thread->inherited_priority = RQ_COUNT;
+	atomic_init(&thread->on_cpu, false);
 	thread->cpu = NULL;
 	thread->wired = false;
+	thread->affinity = NULL;
 	thread->stolen = false;
 	thread->uspace =
 	    ((flags & THREAD_FLAG_USPACE) == THREAD_FLAG_USPACE);
@@ -426,6 +554,9 @@ static void thread_destroy(void *obj)
 	/* Remove thread from global list. */
 	irq_spinlock_lock(&threads_lock, false);
 	odict_remove(&thread->lthreads);
+	atomic_store_explicit(&stats_removed_generation, STATS_GENERATION(),
+	    memory_order_relaxed);
+	stats_page_set_threads(thread_count());
 	irq_spinlock_unlock(&threads_lock, false);
 
 	/* Clear cpu->fpu_owner if set to this thread. */
@@ -449,6 +580,9 @@ static void thread_destroy(void *obj)
 	task_release(thread->task);
 	thread->task = NULL;
 
+	if (thread->affinity != NULL)
+		free(thread->affinity);
+
 	slab_free(thread_cache, thread);
 }
 
@@ -481,8 +615,10 @@ void thread_attach(thread_t *thread, task_t *task)
 	task_hold(task);
 
 	/* Must not count kbox thread into lifecount */
-	if (thread->uspace)
+	if (thread->uspace) {
 		atomic_inc(&task->lifecount);
+		thread->sched_class = task->sched_class;
+	}
 
 	list_append(&thread->th_link, &task->threads);
 
@@ -493,6 +629,7 @@ void thread_attach(thread_t *thread, task_t *task)
 	 */
 	irq_spinlock_lock(&threads_lock, false);
 	odict_insert(&thread->lthreads, &threads, NULL);
+	stats_page_set_threads(thread_count());
 	irq_spinlock_unlock(&threads_lock, false);
 
 	interrupts_restore(ipl);
@@ -558,6 +695,113 @@ void thread_interrupt(thread_t *thread)
 	thread_wakeup(thread);
 }
 
+/** Move a ready thread to a higher-priority run queue
+ *
+ * The run queue holding the thread is not known, so the lower-priority
+ * queues of its processor are searched. If the thread is not found, it
+ * has already been scheduled (or migrated) and will be queued with its
+ * inherited priority the next time it becomes ready.
+ *
+ * @param thread   Thread. It is not dereferenced unless it is found
+ *                 in a run queue.
+ * @param cpu      Processor the thread was readied to.
+ * @param priority New run queue index.
+ *
+ */
+static void thread_requeue(thread_t *thread, cpu_t *cpu, int priority)
+{
+	ipl_t ipl = interrupts_disable();
+
+	for (int i = RQ_COUNT - 1; i > priority; i--) {
+		runq_t *rq = &cpu->rq[i];
+		bool found = false;
+
+		irq_spinlock_lock(&rq->lock, false);
+
+		list_foreach(rq->rq, rq_link, thread_t, queued) {
+			if (queued == thread) {
+				found = true;
+				break;
+			}
+		}
+
+		if (found) {
+			list_remove(&thread->rq_link);
+			if (--rq->n == 0)
+				atomic_fetch_and(&cpu->rq_bitmap, ~RQ_BIT(i));
+		}
+
+		irq_spinlock_unlock(&rq->lock, false);
+
+		if (found) {
+			rq = &cpu->rq[priority];
+
+			irq_spinlock_lock(&rq->lock, false);
+			list_append(&thread->rq_link, &rq->rq);
+			if (rq->n++ == 0)
+				atomic_fetch_or(&cpu->rq_bitmap, RQ_BIT(priority));
+			irq_spinlock_unlock(&rq->lock, false);
+			break;
+		}
+	}
+
+	interrupts_restore(ipl);
+}
+
+/** Lend the priority of the current thread to another thread
+ *
+ * Used when the current thread is about to wait for a resource held by
+ * the other thread, so that a low-priority holder does not keep a
+ * high-priority waiter blocked. If the other thread is waiting in a run
+ * queue, it is moved to the queue corresponding to the priority.
+ *
+ * The caller must guarantee that the thread is not destroyed during the
+ * call, e.g. by holding the lock of the wait queue the thread is going
+ * to wake up.
+ *
+ * @param thread   Thread holding the resource.
+ * @param priority Priority of the waiting thread (run queue index).
+ *
+ */
+void thread_priority_inherit(thread_t *thread, int priority)
+{
+	if (priority < 0)
+		priority = 0;
+
+	irq_spinlock_lock(&thread->lock, true);
+
+	if (priority >= thread->inherited_priority) {
+		irq_spinlock_unlock(&thread->lock, true);
+		return;
+	}
+
+	thread->inherited_priority = priority;
+
+	bool ready = (thread->state == Ready);
+	cpu_t *cpu = thread->cpu;
+
+	irq_spinlock_unlock(&thread->lock, true);
+
+	/* Run queue locks must not be acquired while holding a thread lock */
+	if ((ready) && (cpu))
+		thread_requeue(thread, cpu, priority);
+}
+
+/** Drop the priority inherited by the current thread
+ *
+ * Called when the current thread releases a resource other threads might
+ * have been waiting for. The thread keeps running with its current
+ * priority and only the next time it is queued, the inherited priority
+ * is not applied anymore.
+ *
+ */
+void thread_priority_restore(void)
+{
+	irq_spinlock_lock(&THREAD->lock, true);
+	THREAD->inherited_priority = RQ_COUNT;
+	irq_spinlock_unlock(&THREAD->lock, true);
+}
+
 /** Prepare for putting the thread to sleep.
  *
  * @returns whether the thread is currently terminating. If THREAD_OK
@@ -676,7 +920,7 @@ thread_wait_result_t thread_wait_finish(deadline_t deadline)
 	}
 }
 
-void thread_wakeup(thread_t *thread)
+static void _thread_wakeup(thread_t *thread, bool handoff)
 {
 	assert(thread != NULL);
 
@@ -689,10 +933,30 @@ void thread_wakeup(thread_t *thread)
 		 * The reference consumed here is the reference implicitly passed to
 		 * the waking thread by the sleeper in thread_wait_finish().
 		 */
-		thread_ready(thread);
+		_thread_ready(thread, handoff);
 	}
 }
 
+void thread_wakeup(thread_t *thread)
+{
+	_thread_wakeup(thread, false);
+}
+
+/** Wake up a thread and hand off the current CPU to it
+ *
+ * Works like thread_wakeup(), but the woken thread is readied to the
+ * current CPU, if it can run there, and it is scheduled next. This avoids
+ * a cross-CPU wakeup and a pass through the run queues when the current
+ * thread is going to block right away, e.g. waiting for an IPC answer.
+ *
+ * @param thread Thread to wake up.
+ *
+ */
+void thread_wakeup_handoff(thread_t *thread)
+{
+	_thread_wakeup(thread, true);
+}
+
 /** Prevent the current thread from being migrated to another processor. */
 void thread_migration_disable(void)
 {
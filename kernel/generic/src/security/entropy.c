@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic
+ * @{
+ */
+
+/**
+ * @file entropy.c
+ * @brief Kernel entropy pool.
+ *
+ * @see entropy.h
+ */
+
+#include <security/entropy.h>
+#include <synch/spinlock.h>
+#include <syscall/copy.h>
+#include <arch/cycle.h>
+#include <arch.h>
+#include <cpu.h>
+#include <errno.h>
+#include <macros.h>
+#include <mem.h>
+
+/** Number of samples gathered per CPU before folding into the global pool */
+#define ENTROPY_FOLD_SAMPLES  64
+
+/** Size of one ChaCha20 block in bytes */
+#define CHACHA_BLOCK_SIZE  64
+
+/** Number of requested hardware random words mixed in per reseed */
+#define ENTROPY_HW_WORDS  4
+
+#define ROTL32(v, n)  (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define QUARTER_ROUND(x, a, b, c, d) \
+	do { \
+		x[a] += x[b]; x[d] = ROTL32(x[d] ^ x[a], 16); \
+		x[c] += x[d]; x[b] = ROTL32(x[b] ^ x[c], 12); \
+		x[a] += x[b]; x[d] = ROTL32(x[d] ^ x[a], 8); \
+		x[c] += x[d]; x[b] = ROTL32(x[b] ^ x[c], 7); \
+	} while (0)
+
+IRQ_SPINLOCK_STATIC_INITIALIZE(entropy_lock);
+
+/** Global pool. Protected by entropy_lock. */
+static uint32_t entropy_pool[16];
+
+/** Position in the global pool where the next per-CPU pool is folded */
+static unsigned int entropy_pos;
+
+/** ChaCha20 generator key. Protected by entropy_lock. */
+static uint32_t entropy_key[8];
+
+/** ChaCha20 block counter. Protected by entropy_lock. */
+static uint64_t entropy_counter;
+
+/** Perform the given number of ChaCha double rounds on a state.
+ *
+ * @param x      State of 16 words.
+ * @param rounds Number of double rounds.
+ *
+ */
+static void chacha_permute(uint32_t *x, unsigned int rounds)
+{
+	for (unsigned int i = 0; i < rounds; i++) {
+		QUARTER_ROUND(x, 0, 4, 8, 12);
+		QUARTER_ROUND(x, 1, 5, 9, 13);
+		QUARTER_ROUND(x, 2, 6, 10, 14);
+		QUARTER_ROUND(x, 3, 7, 11, 15);
+		QUARTER_ROUND(x, 0, 5, 10, 15);
+		QUARTER_ROUND(x, 1, 6, 11, 12);
+		QUARTER_ROUND(x, 2, 7, 8, 13);
+		QUARTER_ROUND(x, 3, 4, 9, 14);
+	}
+}
+
+/** Produce one ChaCha20 block from the generator key.
+ *
+ * Must be called with entropy_lock held.
+ *
+ * @param out Output block of CHACHA_BLOCK_SIZE bytes.
+ *
+ */
+static void chacha_block(uint8_t *out)
+{
+	uint32_t state[16] = {
+		0x61707865, 0x3320646e, 0x79622d32, 0x6b206574
+	};
+	uint32_t x[16];
+
+	for (unsigned int i = 0; i < 8; i++)
+		state[4 + i] = entropy_key[i];
+
+	state[12] = (uint32_t) entropy_counter;
+	state[13] = (uint32_t) (entropy_counter >> 32);
+	entropy_counter++;
+
+	memcpy(x, state, sizeof(x));
+	chacha_permute(x, 10);
+
+	for (unsigned int i = 0; i < 16; i++) {
+		uint32_t w = x[i] + state[i];
+
+		out[4 * i] = w & 0xff;
+		out[4 * i + 1] = (w >> 8) & 0xff;
+		out[4 * i + 2] = (w >> 16) & 0xff;
+		out[4 * i + 3] = (w >> 24) & 0xff;
+	}
+
+	memset(x, 0, sizeof(x));
+	memset(state, 0, sizeof(state));
+}
+
+/** Stir the per-CPU fast pool.
+ *
+ * @param s Fast pool of four words.
+ *
+ */
+static void fast_mix(uint32_t *s)
+{
+	s[0] += s[1];
+	s[1] = ROTL32(s[1], 6) ^ s[0];
+	s[2] += s[3];
+	s[3] = ROTL32(s[3], 27) ^ s[2];
+	s[0] += s[3];
+	s[3] = ROTL32(s[3], 16) ^ s[0];
+	s[2] += s[1];
+	s[1] = ROTL32(s[1], 11) ^ s[2];
+}
+
+/** Mix hardware random numbers into the global pool.
+ *
+ * Must be called with entropy_lock held.
+ *
+ */
+static void entropy_mix_hw(void)
+{
+	if (!arch_ops->hw_random)
+		return;
+
+	for (unsigned int i = 0; i < ENTROPY_HW_WORDS; i++) {
+		uint64_t val;
+
+		if (!arch_ops->hw_random(&val))
+			break;
+
+		entropy_pool[2 * i] ^= (uint32_t) val;
+		entropy_pool[2 * i + 1] ^= (uint32_t) (val >> 32);
+	}
+}
+
+/** Initialize the entropy pool.
+ *
+ * Seeds the pool with the cycle counter and, where the architecture
+ * provides one, the hardware random number generator. The pool keeps
+ * accumulating interrupt timing afterwards.
+ *
+ */
+void entropy_init(void)
+{
+	irq_spinlock_lock(&entropy_lock, true);
+
+	uint64_t cycle = get_cycle();
+	entropy_pool[14] ^= (uint32_t) cycle;
+	entropy_pool[15] ^= (uint32_t) (cycle >> 32);
+
+	entropy_mix_hw();
+	chacha_permute(entropy_pool, 10);
+
+	irq_spinlock_unlock(&entropy_lock, true);
+}
+
+/** Add an interrupt timing sample.
+ *
+ * Called from the exception dispatcher with interrupts disabled. The sample
+ * is stirred into the per-CPU pool, which gets folded into the global pool
+ * every ENTROPY_FOLD_SAMPLES samples unless the global pool is busy.
+ *
+ * @param data Sample data, e.g. the cycle counter xored with the vector.
+ *
+ */
+void entropy_sample(uint64_t data)
+{
+	if (!CPU)
+		return;
+
+	uint32_t *fast = CPU->entropy_fast;
+
+	fast[0] ^= (uint32_t) data;
+	fast[1] ^= (uint32_t) (data >> 32);
+	fast[2] ^= (uint32_t) get_cycle();
+	fast_mix(fast);
+
+	if (++CPU->entropy_samples < ENTROPY_FOLD_SAMPLES)
+		return;
+
+	if (!irq_spinlock_trylock(&entropy_lock))
+		return;
+
+	for (unsigned int i = 0; i < 4; i++)
+		entropy_pool[entropy_pos + i] ^= fast[i];
+
+	entropy_pos = (entropy_pos + 4) % 16;
+	if (entropy_pos == 0)
+		chacha_permute(entropy_pool, 1);
+
+	irq_spinlock_unlock(&entropy_lock, false);
+
+	CPU->entropy_samples = 0;
+}
+
+/** Get random bytes.
+ *
+ * The global pool and fresh hardware random numbers are mixed into the
+ * generator key, the output is produced by ChaCha20 and the key is replaced
+ * with a fresh block afterwards so that earlier output cannot be
+ * reconstructed from the generator state.
+ *
+ * @param buf  Destination buffer.
+ * @param size Number of bytes to produce.
+ *
+ */
+void entropy_get(void *buf, size_t size)
+{
+	uint8_t *dst = (uint8_t *) buf;
+	uint8_t block[CHACHA_BLOCK_SIZE];
+
+	irq_spinlock_lock(&entropy_lock, true);
+
+	entropy_mix_hw();
+	chacha_permute(entropy_pool, 1);
+	for (unsigned int i = 0; i < 8; i++)
+		entropy_key[i] ^= entropy_pool[i] ^ entropy_pool[8 + i];
+
+	while (size > 0) {
+		size_t len = min(size, (size_t) CHACHA_BLOCK_SIZE);
+
+		chacha_block(block);
+		memcpy(dst, block, len);
+		dst += len;
+		size -= len;
+	}
+
+	/* Fast key erasure */
+	chacha_block(block);
+	memcpy(entropy_key, block, sizeof(entropy_key));
+
+	irq_spinlock_unlock(&entropy_lock, true);
+
+	memset(block, 0, sizeof(block));
+}
+
+/** Copy random bytes to userspace.
+ *
+ * @param buf  Userspace destination buffer.
+ * @param size Number of bytes to produce.
+ *
+ * @return EOK on success or an error code from copy_to_uspace().
+ *
+ */
+sys_errno_t sys_entropy_get(uspace_addr_t buf, size_t size)
+{
+	uint8_t block[CHACHA_BLOCK_SIZE];
+	errno_t rc = EOK;
+
+	while (size > 0) {
+		size_t len = min(size, (size_t) CHACHA_BLOCK_SIZE);
+
+		entropy_get(block, len);
+		rc = copy_to_uspace(buf, block, len);
+		if (rc != EOK)
+			break;
+
+		buf += len;
+		size -= len;
+	}
+
+	memset(block, 0, sizeof(block));
+	return (sys_errno_t) rc;
+}
+
+/** @}
+ */
@@ -39,6 +39,8 @@
 
 #include <smp/ipi.h>
 #include <config.h>
+#include <assert.h>
+#include <cpu.h>
 
 /** Broadcast IPI message
  *
@@ -59,6 +61,21 @@ void ipi_broadcast(int ipi)
 		ipi_broadcast_arch(ipi);
 }
 
+/** Send IPI message
+ *
+ * Send IPI message to a single CPU other than the current one.
+ *
+ * @param cpu Target CPU.
+ * @param ipi Message to send.
+ *
+ */
+void ipi_send(cpu_t *cpu, int ipi)
+{
+	assert(cpu != CPU);
+
+	ipi_send_arch(cpu, ipi);
+}
+
 #endif /* CONFIG_SMP */
 
 /** @}
@@ -40,6 +40,8 @@
 #include <synch/spinlock.h>
 #include <synch/waitq.h>
 #include <arch.h>
+#include <debug.h>
+#include <synch/lockstat.h>
 
 /** Initialize condition variable.
  *
@@ -48,6 +50,10 @@
 void condvar_initialize(condvar_t *cv)
 {
 	waitq_initialize(&cv->wq);
+
+#ifdef CONFIG_LOCKSTAT
+	cv->wq.lockstat = lockstat_class_get(STATS_LOCK_WAITQ, NULL, CALLER);
+#endif
 }
 
 /** Signal the condition has become true to the first waiting thread by waking
@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_sync
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Lock contention statistics.
+ *
+ * Locks are grouped into classes. Spinlocks are classified by their name,
+ * mutexes and wait queues by the code location which initialized them,
+ * as they have no names. For each class and processor, the number of
+ * acquisitions, the number of acquisitions which had to wait, the number
+ * of cycles spent waiting and the number of cycles the locks were held
+ * are counted.
+ *
+ * The class table is populated without locking so that looking up a class
+ * never acquires a lock itself. If it becomes full, further locks are
+ * accounted in a catch-all class of their kind.
+ */
+
+#include <synch/lockstat.h>
+#include <adt/hash.h>
+#include <arch.h>
+#include <arch/asm.h>
+#include <arch/cycle.h>
+#include <atomic.h>
+#include <config.h>
+#include <cpu.h>
+#include <gsort.h>
+#include <macros.h>
+#include <mem.h>
+#include <print.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <symtab_lookup.h>
+
+/** Number of lock classes, must be a power of two */
+#define LOCKSTAT_CLASSES  1024
+
+/** Number of lock classes including the catch-all ones */
+#define LOCKSTAT_SLOTS  (LOCKSTAT_CLASSES + STATS_LOCK_KINDS)
+
+typedef enum {
+	CLASS_FREE,
+	CLASS_BUSY,
+	CLASS_READY
+} lockstat_class_state_t;
+
+struct lockstat_class {
+	atomic_int state;
+	stats_lock_kind_t kind;
+	/** Code location which initialized the locks, if they have no name */
+	uintptr_t site;
+	char name[LOCK_NAME_BUFLEN];
+};
+
+typedef struct {
+	uint64_t acquired;
+	uint64_t contended;
+	uint64_t wait_cycles;
+	uint64_t hold_cycles;
+} lockstat_counters_t;
+
+static lockstat_class_t classes[LOCKSTAT_SLOTS] = {
+	[LOCKSTAT_CLASSES + STATS_LOCK_SPINLOCK] = {
+		.state = CLASS_READY,
+		.kind = STATS_LOCK_SPINLOCK,
+		.name = "[other]"
+	},
+	[LOCKSTAT_CLASSES + STATS_LOCK_MUTEX] = {
+		.state = CLASS_READY,
+		.kind = STATS_LOCK_MUTEX,
+		.name = "[other]"
+	},
+	[LOCKSTAT_CLASSES + STATS_LOCK_WAITQ] = {
+		.state = CLASS_READY,
+		.kind = STATS_LOCK_WAITQ,
+		.name = "[other]"
+	}
+};
+
+/** Counters of all processors, LOCKSTAT_SLOTS entries for each of them */
+static lockstat_counters_t *counters = NULL;
+
+static const char *kind_names[STATS_LOCK_KINDS] = {
+	[STATS_LOCK_SPINLOCK] = "spinlock",
+	[STATS_LOCK_MUTEX] = "mutex",
+	[STATS_LOCK_WAITQ] = "waitq"
+};
+
+/** Allocate the counters
+ *
+ * Must be called after the number of processors is known and before
+ * the application processors are started. Lock operations before this
+ * point are not accounted.
+ *
+ */
+void lockstat_init(void)
+{
+	size_t size = config.cpu_count * LOCKSTAT_SLOTS *
+	    sizeof(lockstat_counters_t);
+
+	lockstat_counters_t *cnt = malloc(size);
+	if (!cnt) {
+		printf("Not enough memory for lock statistics\n");
+		return;
+	}
+
+	memsetb(cnt, size, 0);
+	counters = cnt;
+}
+
+static size_t class_hash(stats_lock_kind_t kind, const char *name,
+    uintptr_t site)
+{
+	size_t hash = site;
+
+	if (name) {
+		while (*name != '\0')
+			hash = hash * 31 + (uint8_t) *name++;
+	}
+
+	return hash_mix(hash ^ kind);
+}
+
+static bool class_match(lockstat_class_t *cls, stats_lock_kind_t kind,
+    const char *name, uintptr_t site)
+{
+	if ((cls->kind != kind) || (cls->site != site))
+		return false;
+
+	if (name)
+		return str_lcmp(cls->name, name, LOCK_NAME_BUFLEN - 1) == 0;
+
+	return cls->name[0] == '\0';
+}
+
+/** Find or create a lock class
+ *
+ * Never sleeps nor acquires any lock.
+ *
+ * @param kind Kind of the lock.
+ * @param name Name of the lock or NULL if it has none.
+ * @param site Code location which initialized the lock if it has no name,
+ *             zero otherwise.
+ *
+ * @return Lock class or NULL if the lock cannot be classified.
+ *
+ */
+lockstat_class_t *lockstat_class_get(stats_lock_kind_t kind, const char *name,
+    uintptr_t site)
+{
+	if ((!name) && (site == 0))
+		return NULL;
+
+	size_t hash = class_hash(kind, name, site);
+
+	for (size_t i = 0; i < LOCKSTAT_CLASSES; i++) {
+		lockstat_class_t *cls = &classes[(hash + i) & (LOCKSTAT_CLASSES - 1)];
+		int state = atomic_load_explicit(&cls->state, memory_order_acquire);
+
+		if (state == CLASS_FREE) {
+			if (atomic_compare_exchange_strong_explicit(&cls->state,
+			    &state, CLASS_BUSY, memory_order_acquire,
+			    memory_order_acquire)) {
+				cls->kind = kind;
+				cls->site = site;
+				if (name)
+					str_cpy(cls->name, LOCK_NAME_BUFLEN, name);
+
+				atomic_store_explicit(&cls->state, CLASS_READY,
+				    memory_order_release);
+				return cls;
+			}
+		}
+
+		/* Another processor is filling in the slot */
+		while (state == CLASS_BUSY) {
+			cpu_spin_hint();
+			state = atomic_load_explicit(&cls->state,
+			    memory_order_acquire);
+		}
+
+		if (class_match(cls, kind, name, site))
+			return cls;
+	}
+
+	return &classes[LOCKSTAT_CLASSES + kind];
+}
+
+/** Get the counters of a class on the current processor
+ *
+ * Interrupts must be disabled.
+ *
+ */
+static lockstat_counters_t *class_counters(lockstat_class_t *cls)
+{
+	return &counters[CPU->id * LOCKSTAT_SLOTS + (cls - classes)];
+}
+
+/** Get the number of cycles elapsed since a cycle count
+ *
+ * The thread may have migrated to a processor whose cycle counter is
+ * behind, in which case zero is returned.
+ *
+ */
+static uint64_t cycles_since(uint64_t start)
+{
+	uint64_t now = get_cycle();
+	return (now > start) ? now - start : 0;
+}
+
+/** Account an acquisition of a lock
+ *
+ * @param cls        Lock class, may be NULL.
+ * @param contended  Whether the lock had to be waited for.
+ * @param wait_start Cycle count when the wait started.
+ *
+ */
+void lockstat_acquired(lockstat_class_t *cls, bool contended,
+    uint64_t wait_start)
+{
+	if ((!cls) || (!counters))
+		return;
+
+	uint64_t wait_cycles = contended ? cycles_since(wait_start) : 0;
+
+	ipl_t ipl = interrupts_disable();
+	lockstat_counters_t *cnt = class_counters(cls);
+
+	cnt->acquired++;
+	if (contended) {
+		cnt->contended++;
+		cnt->wait_cycles += wait_cycles;
+	}
+
+	interrupts_restore(ipl);
+}
+
+/** Account a release of a lock
+ *
+ * @param cls   Lock class, may be NULL.
+ * @param since Cycle count when the lock was acquired.
+ *
+ */
+void lockstat_released(lockstat_class_t *cls, uint64_t since)
+{
+	if ((!cls) || (!counters))
+		return;
+
+	uint64_t hold_cycles = cycles_since(since);
+
+	ipl_t ipl = interrupts_disable();
+	class_counters(cls)->hold_cycles += hold_cycles;
+	interrupts_restore(ipl);
+}
+
+static void class_name(lockstat_class_t *cls, char *buf, size_t size)
+{
+	const char *sym;
+	uintptr_t offs;
+
+	if (cls->name[0] != '\0')
+		str_cpy(buf, size, cls->name);
+	else if (symtab_name_lookup(cls->site, &sym, &offs) == EOK)
+		snprintf(buf, size, "%s+%#" PRIxPTR, sym, offs);
+	else
+		snprintf(buf, size, "%p", (void *) cls->site);
+}
+
+/** Get statistics of all lock classes which were acquired
+ *
+ * The counters are read without synchronization, so the statistics
+ * of a class may be slightly inconsistent.
+ *
+ * @param stats Array to store the statistics to.
+ * @param count Capacity of the array.
+ *
+ * @return Number of lock classes which were acquired. If it is greater
+ *         than count, only the first count classes were stored.
+ *
+ */
+size_t lockstat_stats(stats_lock_t *stats, size_t count)
+{
+	if (!counters)
+		return 0;
+
+	size_t n = 0;
+
+	for (size_t i = 0; i < LOCKSTAT_SLOTS; i++) {
+		lockstat_class_t *cls = &classes[i];
+		if (atomic_load_explicit(&cls->state, memory_order_acquire) !=
+		    CLASS_READY)
+			continue;
+
+		stats_lock_t stat = {
+			.kind = cls->kind
+		};
+
+		for (unsigned int cpu = 0; cpu < config.cpu_count; cpu++) {
+			lockstat_counters_t *cnt =
+			    &counters[cpu * LOCKSTAT_SLOTS + i];
+
+			stat.acquired += cnt->acquired;
+			stat.contended += cnt->contended;
+			stat.wait_cycles += cnt->wait_cycles;
+			stat.hold_cycles += cnt->hold_cycles;
+		}
+
+		if (stat.acquired == 0)
+			continue;
+
+		if (n < count) {
+			class_name(cls, stat.name, LOCK_NAME_BUFLEN);
+			stats[n] = stat;
+		}
+
+		n++;
+	}
+
+	return n;
+}
+
+/** Reset the counters of all lock classes */
+void lockstat_reset(void)
+{
+	if (!counters)
+		return;
+
+	memsetb(counters, config.cpu_count * LOCKSTAT_SLOTS *
+	    sizeof(lockstat_counters_t), 0);
+}
+
+static int lockstat_cmp(void *a, void *b, void *arg)
+{
+	stats_lock_t *sa = (stats_lock_t *) a;
+	stats_lock_t *sb = (stats_lock_t *) b;
+
+	if (sa->wait_cycles != sb->wait_cycles)
+		return (sa->wait_cycles < sb->wait_cycles) ? 1 : -1;
+
+	if (sa->contended != sb->contended)
+		return (sa->contended < sb->contended) ? 1 : -1;
+
+	return 0;
+}
+
+/** Print the lock classes ordered by the time spent waiting for them */
+void lockstat_print_list(void)
+{
+	size_t count = lockstat_stats(NULL, 0);
+	if (count == 0) {
+		printf("No lock statistics available.\n");
+		return;
+	}
+
+	/* Leave some space for classes created in the meantime */
+	count += 16;
+
+	stats_lock_t *stats = malloc(count * sizeof(stats_lock_t));
+	if (!stats) {
+		printf("Not enough memory.\n");
+		return;
+	}
+
+	count = min(count, lockstat_stats(stats, count));
+	gsort(stats, count, sizeof(stats_lock_t), lockstat_cmp, NULL);
+
+	printf("[kind  ] [acquired ] [contended] [wait cycles    ]"
+	    " [hold cycles    ] [name\n");
+
+	for (size_t i = 0; i < count; i++) {
+		printf("%-8s %11" PRIu64 " %11" PRIu64 " %17" PRIu64
+		    " %17" PRIu64 " %s\n", kind_names[stats[i].kind],
+		    stats[i].acquired, stats[i].contended,
+		    stats[i].wait_cycles, stats[i].hold_cycles,
+		    stats[i].name);
+	}
+
+	free(stats);
+}
+
+/** @}
+ */
@@ -44,6 +44,19 @@
 #include <stacktrace.h>
 #include <cpu.h>
 #include <proc/thread.h>
+#include <debug.h>
+#include <synch/lockstat.h>
+#include <arch/cycle.h>
+#include <arch/asm.h>
+#include <config.h>
+#include <proc/scheduler.h>
+#include <synch/waitq.h>
+
+/**
+ * Number of times a thread checks whether a mutex owner running on another
+ * processor has released the mutex before it goes to sleep.
+ */
+#define MUTEX_SPIN_MAX  10000
 
 /** Initialize mutex.
  *
@@ -53,9 +66,15 @@
 void mutex_initialize(mutex_t *mtx, mutex_type_t type)
 {
 	mtx->type = type;
-	mtx->owner = NULL;
+	atomic_init(&mtx->owner, NULL);
 	mtx->nesting = 0;
 	semaphore_initialize(&mtx->sem, 1);
+
+#ifdef CONFIG_LOCKSTAT
+	/* Acquisitions are accounted by the wait queue of the semaphore */
+	mtx->sem.wq.lockstat = lockstat_class_get(STATS_LOCK_MUTEX, NULL,
+	    CALLER);
+#endif
 }
 
 /** Find out whether the mutex is currently locked.
@@ -73,6 +92,14 @@ bool mutex_locked(mutex_t *mtx)
 	return rc != EOK;
 }
 
+/** Remember when the mutex was acquired for lock statistics. */
+static inline void mutex_lockstat_acquired(mutex_t *mtx)
+{
+#ifdef CONFIG_LOCKSTAT
+	mtx->lockstat_since = get_cycle();
+#endif
+}
+
 static void mutex_lock_active(mutex_t *mtx)
 {
 	assert((mtx->type == MUTEX_ACTIVE) || !THREAD);
@@ -94,13 +121,82 @@ static void mutex_lock_active(mutex_t *mtx)
 		printf("cpu%u: not deadlocked\n", CPU->id);
 }
 
+static inline thread_t *mutex_owner(mutex_t *mtx)
+{
+	return atomic_load_explicit(&mtx->owner, memory_order_relaxed);
+}
+
+/** Spin while the owner of a mutex is running on another processor.
+ *
+ * The owner is likely to release the mutex soon, sooner than it would
+ * take the current thread to go to sleep and be woken up again.
+ *
+ * The owner structure might be destroyed while it is being inspected,
+ * but thread structures are allocated from a slab cache in identity-mapped
+ * memory, so reading a stale structure cannot fault and the owner is
+ * re-read in every iteration.
+ *
+ * @return True if the mutex was acquired.
+ */
+static bool mutex_lock_spin(mutex_t *mtx)
+{
+#ifdef CONFIG_SMP
+	if (config.cpu_active == 1)
+		return false;
+
+	for (unsigned int i = 0; i < MUTEX_SPIN_MAX; i++) {
+		thread_t *owner = mutex_owner(mtx);
+
+		if (owner == NULL) {
+			/* Released or just acquired by another thread */
+			if (semaphore_trydown(&mtx->sem) == EOK)
+				return true;
+		} else if (!atomic_load_explicit(&owner->on_cpu,
+		    memory_order_relaxed)) {
+			break;
+		}
+
+		cpu_spin_hint();
+	}
+#endif
+
+	return false;
+}
+
+/** Sleep until the mutex is acquired.
+ *
+ * The priority of the current thread is lent to the owner, so that
+ * the owner is not kept from releasing the mutex by threads with
+ * a lower priority than the current thread.
+ */
+static void mutex_lock_sleep(mutex_t *mtx)
+{
+	wait_guard_t guard = waitq_sleep_prepare(&mtx->sem.wq);
+
+	/*
+	 * The owner clears the owner field before waking up waiters, which
+	 * requires the wait queue lock. As we are holding that lock now,
+	 * the owner cannot be gone yet if the field is still set.
+	 */
+	thread_t *owner = mutex_owner(mtx);
+	if ((owner != NULL) && (owner != THREAD))
+		thread_priority_inherit(owner, THREAD->priority);
+
+	errno_t rc = waitq_sleep_unsafe(&mtx->sem.wq, guard);
+	assert(rc == EOK);
+	(void) rc;
+}
+
 /** Acquire mutex.
  *
  * This operation is uninterruptible and cannot fail.
+ *
+ * Unless the mutex is active, the current thread spins while the owner
+ * is running on another processor and sleeps otherwise.
  */
 void mutex_lock(mutex_t *mtx)
 {
-	if (mtx->type == MUTEX_RECURSIVE && mtx->owner == THREAD) {
+	if (mtx->type == MUTEX_RECURSIVE && mutex_owner(mtx) == THREAD) {
 		assert(THREAD);
 		mtx->nesting++;
 		return;
@@ -108,12 +204,16 @@ void mutex_lock(mutex_t *mtx)
 
 	if (mtx->type == MUTEX_ACTIVE || !THREAD) {
 		mutex_lock_active(mtx);
+		mutex_lockstat_acquired(mtx);
 		return;
 	}
 
-	semaphore_down(&mtx->sem);
-	mtx->owner = THREAD;
+	if ((semaphore_trydown(&mtx->sem) != EOK) && (!mutex_lock_spin(mtx)))
+		mutex_lock_sleep(mtx);
+
+	atomic_store_explicit(&mtx->owner, THREAD, memory_order_relaxed);
 	mtx->nesting = 1;
+	mutex_lockstat_acquired(mtx);
 }
 
 /** Acquire mutex with timeout.
@@ -130,7 +230,7 @@ errno_t mutex_lock_timeout(mutex_t *mtx, uint32_t usec)
 		assert(THREAD);
 	}
 
-	if (mtx->type == MUTEX_RECURSIVE && mtx->owner == THREAD) {
+	if (mtx->type == MUTEX_RECURSIVE && mutex_owner(mtx) == THREAD) {
 		assert(THREAD);
 		mtx->nesting++;
 		return EOK;
@@ -138,8 +238,9 @@ errno_t mutex_lock_timeout(mutex_t *mtx, uint32_t usec)
 
 	errno_t rc = semaphore_down_timeout(&mtx->sem, usec);
 	if (rc == EOK) {
-		mtx->owner = THREAD;
+		atomic_store_explicit(&mtx->owner, THREAD, memory_order_relaxed);
 		mtx->nesting = 1;
+		mutex_lockstat_acquired(mtx);
 	}
 	return rc;
 }
@@ -160,12 +261,21 @@ errno_t mutex_trylock(mutex_t *mtx)
 void mutex_unlock(mutex_t *mtx)
 {
 	if (mtx->type == MUTEX_RECURSIVE) {
-		assert(mtx->owner == THREAD);
+		assert(mutex_owner(mtx) == THREAD);
 		if (--mtx->nesting > 0)
 			return;
-		mtx->owner = NULL;
 	}
+
+	atomic_store_explicit(&mtx->owner, NULL, memory_order_relaxed);
+
+#ifdef CONFIG_LOCKSTAT
+	lockstat_released(mtx->sem.wq.lockstat, mtx->lockstat_since);
+#endif
+
 	semaphore_up(&mtx->sem);
+
+	if ((THREAD) && (THREAD->inherited_priority < RQ_COUNT))
+		thread_priority_restore();
 }
 
 /** @}
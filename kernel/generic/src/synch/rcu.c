@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_sync
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Read-copy-update.
+ *
+ * RCU lets readers of a data structure go without any locks or atomic
+ * operations. Updaters unlink objects from the structure and defer their
+ * freeing with call_rcu() until a grace period elapses, i.e. until all
+ * readers which might have seen the objects are gone.
+ *
+ * Readers run with preemption disabled, so a processor which goes through
+ * the scheduler, or which takes a clock interrupt in preemptible code, is
+ * in a quiescent state and is no longer running any reader that started
+ * before. Such processors record the number of the grace period they have
+ * seen in rcu_quiescent(). The krcu thread collects queued callbacks from
+ * all processors, starts a new grace period, waits until every active
+ * processor reports it and then runs the callbacks. Idle processors with
+ * their tick stopped are woken up to report.
+ */
+
+#include <arch.h>
+#include <assert.h>
+#include <config.h>
+#include <cpu.h>
+#include <member.h>
+#include <proc/thread.h>
+#include <synch/rcu.h>
+#include <synch/semaphore.h>
+#include <synch/spinlock.h>
+#include <time/clock.h>
+
+/** Period of checks for processors which have not been quiescent (usec). */
+#define RCU_POLL_USEC  1000
+
+/** Number of the current grace period. */
+static atomic_size_t rcu_gp;
+
+/** Set when krcu has been told about new callbacks. */
+static atomic_bool rcu_kicked;
+
+/** Wakes up krcu when there are new callbacks. */
+static semaphore_t rcu_sem;
+
+/** Callback of rcu_synchronize(). */
+typedef struct {
+	rcu_item_t item;
+	atomic_bool done;
+} rcu_sync_t;
+
+/** Initialize RCU
+ *
+ * Must be called after the processor structures are set up.
+ *
+ */
+void rcu_init(void)
+{
+	atomic_init(&rcu_gp, 0);
+	atomic_init(&rcu_kicked, false);
+	semaphore_initialize(&rcu_sem, 0);
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		irq_spinlock_initialize(&cpus[i].rcu_lock, "cpus[].rcu_lock");
+		list_initialize(&cpus[i].rcu_cbs);
+		atomic_init(&cpus[i].rcu_qs, 0);
+	}
+}
+
+/** Report a quiescent state of the current processor
+ *
+ * Must be called with interrupts disabled at a point where no read-side
+ * section is in progress on the current processor.
+ *
+ */
+void rcu_quiescent(void)
+{
+	assert(interrupts_disabled());
+
+	/* Pairs with the start of the grace period in rcu_wait_gp(). */
+	size_t gp = atomic_load(&rcu_gp);
+
+	if (atomic_load_explicit(&CPU->rcu_qs, memory_order_relaxed) != gp)
+		atomic_store_explicit(&CPU->rcu_qs, gp, memory_order_release);
+}
+
+/** Queue a callback to run after the next grace period
+ *
+ * The callback runs in the krcu thread and may sleep. It can be queued
+ * from any context.
+ *
+ * @param item Callback item, usually embedded in the object to free.
+ * @param func Function to call with @a item.
+ *
+ */
+void call_rcu(rcu_item_t *item, rcu_func_t func)
+{
+	item->func = func;
+	link_initialize(&item->link);
+
+	ipl_t ipl = interrupts_disable();
+	irq_spinlock_lock(&CPU->rcu_lock, false);
+	list_append(&item->link, &CPU->rcu_cbs);
+	irq_spinlock_unlock(&CPU->rcu_lock, false);
+	interrupts_restore(ipl);
+
+	if (!atomic_exchange(&rcu_kicked, true))
+		semaphore_up(&rcu_sem);
+}
+
+static void rcu_sync_done(rcu_item_t *item)
+{
+	rcu_sync_t *sync = member_to_inst(item, rcu_sync_t, item);
+	atomic_store_explicit(&sync->done, true, memory_order_release);
+}
+
+/** Wait for a grace period
+ *
+ * When this function returns, all read-side sections which were in
+ * progress at the time of the call are finished.
+ *
+ */
+void rcu_synchronize(void)
+{
+	assert(PREEMPTION_ENABLED);
+
+	rcu_sync_t sync;
+	atomic_init(&sync.done, false);
+	call_rcu(&sync.item, rcu_sync_done);
+
+	while (!atomic_load_explicit(&sync.done, memory_order_acquire))
+		thread_usleep(RCU_POLL_USEC);
+}
+
+/** Move the callbacks queued on all processors to a list. */
+static void rcu_collect(list_t *batch)
+{
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		irq_spinlock_lock(&cpus[i].rcu_lock, true);
+		list_concat(batch, &cpus[i].rcu_cbs);
+		irq_spinlock_unlock(&cpus[i].rcu_lock, true);
+	}
+}
+
+/** Start a grace period and wait until all processors report it. */
+static void rcu_wait_gp(void)
+{
+	/*
+	 * Orders the unlinking of the objects whose callbacks have been
+	 * collected before the start of the grace period.
+	 */
+	size_t gp = atomic_fetch_add(&rcu_gp, 1) + 1;
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		cpu_t *cpu = &cpus[i];
+
+		while ((cpu->active) && (atomic_load_explicit(&cpu->rcu_qs,
+		    memory_order_acquire) != gp)) {
+			ipl_t ipl = interrupts_disable();
+			clock_tick_kick(cpu);
+			interrupts_restore(ipl);
+
+			thread_usleep(RCU_POLL_USEC);
+		}
+	}
+}
+
+/** Kernel thread running RCU callbacks.
+ *
+ * @param arg Not used.
+ */
+void krcu(void *arg)
+{
+	list_t batch;
+	list_initialize(&batch);
+
+	while (true) {
+		semaphore_down(&rcu_sem);
+
+		/* Callbacks queued from now on need another round. */
+		atomic_store(&rcu_kicked, false);
+
+		rcu_collect(&batch);
+		if (list_empty(&batch))
+			continue;
+
+		rcu_wait_gp();
+
+		link_t *link;
+		while ((link = list_first(&batch)) != NULL) {
+			rcu_item_t *item = list_get_instance(link, rcu_item_t,
+			    link);
+			list_remove(link);
+			item->func(item);
+		}
+	}
+}
+
+/** @}
+ */
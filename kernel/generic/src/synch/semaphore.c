@@ -40,6 +40,8 @@
 #include <synch/spinlock.h>
 #include <arch/asm.h>
 #include <arch.h>
+#include <debug.h>
+#include <synch/lockstat.h>
 
 /** Initialize semaphore
  *
@@ -52,6 +54,10 @@
 void semaphore_initialize(semaphore_t *sem, int val)
 {
 	waitq_initialize_with_count(&sem->wq, val);
+
+#ifdef CONFIG_LOCKSTAT
+	sem->wq.lockstat = lockstat_class_get(STATS_LOCK_WAITQ, NULL, CALLER);
+#endif
 }
 
 errno_t semaphore_trydown(semaphore_t *sem)
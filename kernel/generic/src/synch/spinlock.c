@@ -47,6 +47,8 @@
 #include <symtab.h>
 #include <stacktrace.h>
 #include <cpu.h>
+#include <synch/lockstat.h>
+#include <arch/cycle.h>
 
 /** Initialize spinlock
  *
@@ -57,12 +59,43 @@ void spinlock_initialize(spinlock_t *lock, const char *name)
 {
 #ifdef CONFIG_SMP
 	atomic_flag_clear_explicit(&lock->flag, memory_order_relaxed);
-#ifdef CONFIG_DEBUG_SPINLOCK
+#if defined(CONFIG_DEBUG_SPINLOCK) || defined(CONFIG_LOCKSTAT)
 	lock->name = name;
 #endif
+#ifdef CONFIG_LOCKSTAT
+	atomic_store_explicit(&lock->lockstat, NULL, memory_order_relaxed);
+#endif
 #endif
 }
 
+#if defined(CONFIG_SMP) && defined(CONFIG_LOCKSTAT)
+
+/** Account an acquisition of a spinlock
+ *
+ * Must be called with the spinlock held.
+ *
+ * @param lock       Spinlock.
+ * @param contended  Whether the spinlock was busy.
+ * @param spin_start Cycle count when the spinning started.
+ *
+ */
+static void spinlock_lockstat_acquired(spinlock_t *lock, bool contended,
+    uint64_t spin_start)
+{
+	lockstat_class_t *cls = atomic_load_explicit(&lock->lockstat,
+	    memory_order_relaxed);
+	if (!cls) {
+		cls = lockstat_class_get(STATS_LOCK_SPINLOCK, lock->name, 0);
+		atomic_store_explicit(&lock->lockstat, cls,
+		    memory_order_relaxed);
+	}
+
+	lockstat_acquired(cls, contended, spin_start);
+	lock->lockstat_since = get_cycle();
+}
+
+#endif /* CONFIG_SMP && CONFIG_LOCKSTAT */
+
 /** Lock spinlock
  *
  * @param lock Pointer to spinlock_t structure.
@@ -76,7 +109,19 @@ void spinlock_lock(spinlock_t *lock)
 	bool deadlock_reported = false;
 	size_t i = 0;
 
+#ifdef CONFIG_LOCKSTAT
+	bool contended = false;
+	uint64_t spin_start = 0;
+#endif
+
 	while (atomic_flag_test_and_set_explicit(&lock->flag, memory_order_acquire)) {
+#ifdef CONFIG_LOCKSTAT
+		if (!contended) {
+			contended = true;
+			spin_start = get_cycle();
+		}
+#endif
+
 		cpu_spin_hint();
 
 #ifdef CONFIG_DEBUG_SPINLOCK
@@ -120,6 +165,9 @@ void spinlock_lock(spinlock_t *lock)
 	if (deadlock_reported)
 		printf("cpu%u: not deadlocked\n", CPU->id);
 
+#ifdef CONFIG_LOCKSTAT
+	spinlock_lockstat_acquired(lock, contended, spin_start);
+#endif
 #endif
 }
 
@@ -134,6 +182,11 @@ void spinlock_unlock(spinlock_t *lock)
 	ASSERT_SPINLOCK(spinlock_locked(lock), lock);
 #endif
 
+#ifdef CONFIG_LOCKSTAT
+	lockstat_released(atomic_load_explicit(&lock->lockstat,
+	    memory_order_relaxed), lock->lockstat_since);
+#endif
+
 	atomic_flag_clear_explicit(&lock->flag, memory_order_release);
 #endif
 
@@ -159,6 +212,11 @@ bool spinlock_trylock(spinlock_t *lock)
 	if (!ret)
 		preemption_enable();
 
+#ifdef CONFIG_LOCKSTAT
+	if (ret)
+		spinlock_lockstat_acquired(lock, false, 0);
+#endif
+
 	return ret;
 #else
 	return true;
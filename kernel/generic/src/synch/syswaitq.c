@@ -41,6 +41,7 @@
 #include <cap/cap.h>
 #include <mm/slab.h>
 #include <proc/task.h>
+#include <proc/thread.h>
 #include <syscall/copy.h>
 
 #include <stdint.h>
@@ -80,6 +81,74 @@ void sys_waitq_task_cleanup(void)
 	    waitq_cap_cleanup_cb, NULL);
 }
 
+typedef struct {
+	task_t *task;
+	errno_t rc;
+} waitq_clone_arg_t;
+
+static bool waitq_cap_clone_cb(cap_t *cap, void *arg)
+{
+	waitq_clone_arg_t *clone = (waitq_clone_arg_t *) arg;
+	waitq_t *src = cap->kobject->waitq;
+
+	waitq_t *wq = slab_alloc(waitq_cache, FRAME_ATOMIC);
+	if (!wq) {
+		clone->rc = ENOMEM;
+		return false;
+	}
+	waitq_initialize(wq);
+
+	irq_spinlock_lock(&src->lock, true);
+	wq->wakeup_balance = src->wakeup_balance;
+	irq_spinlock_unlock(&src->lock, true);
+
+	kobject_t *kobj = kobject_alloc(0);
+	if (!kobj) {
+		slab_free(waitq_cache, wq);
+		clone->rc = ENOMEM;
+		return false;
+	}
+	kobject_initialize(kobj, KOBJECT_TYPE_WAITQ, wq);
+
+	clone->rc = cap_alloc_at(clone->task, cap->handle);
+	if (clone->rc != EOK) {
+		kobject_free(kobj);
+		slab_free(waitq_cache, wq);
+		return false;
+	}
+
+	cap_publish(clone->task, cap->handle, kobj);
+	return true;
+}
+
+/** Give a clone of the current task copies of all its waitqs
+ *
+ * The copies keep the capability handles and the wakeup balance of the
+ * originals so that the futexes in the cloned address space remain usable.
+ * Nobody can sleep in the copies yet.
+ *
+ * @param task  Clone of the current task which does not run yet.
+ *
+ * @return      Error code.
+ */
+errno_t sys_waitq_task_clone(task_t *task)
+{
+	waitq_clone_arg_t clone = {
+		.task = task,
+		.rc = EOK
+	};
+
+	caps_apply_to_kobject_type(TASK, KOBJECT_TYPE_WAITQ,
+	    waitq_cap_clone_cb, &clone);
+
+	if (clone.rc != EOK) {
+		caps_apply_to_kobject_type(task, KOBJECT_TYPE_WAITQ,
+		    waitq_cap_cleanup_cb, NULL);
+	}
+
+	return clone.rc;
+}
+
 /** Create a waitq for the current task
  *
  * @param[out] whandle  Userspace address of the destination buffer that will
@@ -158,8 +227,10 @@ sys_errno_t sys_waitq_sleep(cap_waitq_handle_t whandle, uint32_t timeout,
 	udebug_stoppable_begin();
 #endif
 
+	THREAD->block_reason = THREAD_BLOCK_FUTEX;
 	errno_t rc = _waitq_sleep_timeout(kobj->waitq, timeout,
 	    SYNCH_FLAGS_INTERRUPTIBLE | flags);
+	THREAD->block_reason = THREAD_BLOCK_OTHER;
 
 #ifdef CONFIG_UDEBUG
 	udebug_stoppable_end();
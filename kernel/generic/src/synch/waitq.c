@@ -58,6 +58,8 @@
 #include <context.h>
 #include <adt/list.h>
 #include <arch/cycle.h>
+#include <debug.h>
+#include <synch/lockstat.h>
 #include <mem.h>
 
 /** Initialize wait queue
@@ -72,6 +74,10 @@ void waitq_initialize(waitq_t *wq)
 	memsetb(wq, sizeof(*wq), 0);
 	irq_spinlock_initialize(&wq->lock, "wq.lock");
 	list_initialize(&wq->sleepers);
+
+#ifdef CONFIG_LOCKSTAT
+	wq->lockstat = lockstat_class_get(STATS_LOCK_WAITQ, NULL, CALLER);
+#endif
 }
 
 /**
@@ -82,6 +88,10 @@ void waitq_initialize_with_count(waitq_t *wq, int count)
 {
 	waitq_initialize(wq);
 	wq->wakeup_balance = count;
+
+#ifdef CONFIG_LOCKSTAT
+	wq->lockstat = lockstat_class_get(STATS_LOCK_WAITQ, NULL, CALLER);
+#endif
 }
 
 #define PARAM_NON_BLOCKING(flags, usec) \
@@ -184,6 +194,11 @@ errno_t waitq_sleep_timeout_unsafe(waitq_t *wq, uint32_t usec, unsigned int flag
 	bool sleep_composable = (flags & SYNCH_FLAGS_FUTEX);
 	bool interruptible = (flags & SYNCH_FLAGS_INTERRUPTIBLE);
 
+#ifdef CONFIG_LOCKSTAT
+	bool blocked = false;
+	uint64_t sleep_start = 0;
+#endif
+
 	if (wq->closed) {
 		rc = EOK;
 		goto exit;
@@ -203,6 +218,11 @@ errno_t waitq_sleep_timeout_unsafe(waitq_t *wq, uint32_t usec, unsigned int flag
 		goto exit;
 	}
 
+#ifdef CONFIG_LOCKSTAT
+	blocked = true;
+	sleep_start = get_cycle();
+#endif
+
 	/* Just for debugging output. */
 	atomic_store_explicit(&THREAD->sleep_queue, wq, memory_order_relaxed);
 
@@ -267,17 +287,26 @@ exit:
 	if (THREAD)
 		atomic_store_explicit(&THREAD->sleep_queue, NULL, memory_order_relaxed);
 
+#ifdef CONFIG_LOCKSTAT
+	if (rc == EOK)
+		lockstat_acquired(wq->lockstat, blocked, sleep_start);
+#endif
+
 	irq_spinlock_unlock(&wq->lock, false);
 	interrupts_restore(guard.ipl);
 	return rc;
 }
 
-static void _wake_one(waitq_t *wq)
+static void _wake_one(waitq_t *wq, bool handoff)
 {
 	/* Pop one thread from the queue and wake it up. */
 	thread_t *thread = list_get_instance(list_first(&wq->sleepers), thread_t, wq_link);
 	list_remove(&thread->wq_link);
-	thread_wakeup(thread);
+
+	if (handoff)
+		thread_wakeup_handoff(thread);
+	else
+		thread_wakeup(thread);
 }
 
 /**
@@ -290,7 +319,7 @@ void waitq_signal(waitq_t *wq)
 	irq_spinlock_lock(&wq->lock, true);
 
 	if (!list_empty(&wq->sleepers))
-		_wake_one(wq);
+		_wake_one(wq, false);
 
 	irq_spinlock_unlock(&wq->lock, true);
 }
@@ -309,7 +338,27 @@ void waitq_wake_one(waitq_t *wq)
 		if (wq->wakeup_balance < 0 || list_empty(&wq->sleepers))
 			wq->wakeup_balance++;
 		else
-			_wake_one(wq);
+			_wake_one(wq, false);
+	}
+
+	irq_spinlock_unlock(&wq->lock, true);
+}
+
+/**
+ * Wakes up one thread sleeping on this waitq and hands off the current
+ * processor to it (see thread_wakeup_handoff()). Otherwise works like
+ * waitq_wake_one(). Meant to be used when the current thread is going
+ * to block right away.
+ */
+void waitq_wake_one_handoff(waitq_t *wq)
+{
+	irq_spinlock_lock(&wq->lock, true);
+
+	if (!wq->closed) {
+		if (wq->wakeup_balance < 0 || list_empty(&wq->sleepers))
+			wq->wakeup_balance++;
+		else
+			_wake_one(wq, true);
 	}
 
 	irq_spinlock_unlock(&wq->lock, true);
@@ -318,7 +367,7 @@ void waitq_wake_one(waitq_t *wq)
 static void _wake_all(waitq_t *wq)
 {
 	while (!list_empty(&wq->sleepers))
-		_wake_one(wq);
+		_wake_one(wq, false);
 }
 
 /**
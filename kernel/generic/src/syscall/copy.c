@@ -46,6 +46,39 @@
 #include <arch.h>
 #include <errno.h>
 
+/** Check whether a userspace block may be accessed by the copy functions.
+ *
+ * @param uspace_addr Userspace address of the block.
+ * @param size        Size of the block.
+ *
+ * @return True if the block lies entirely in userspace.
+ */
+static bool copy_uspace_range_valid(uspace_addr_t uspace_addr, size_t size)
+{
+	if (!KERNEL_ADDRESS_SPACE_SHADOWED) {
+		if (overlaps(uspace_addr, size,
+		    KERNEL_ADDRESS_SPACE_START,
+		    KERNEL_ADDRESS_SPACE_END - KERNEL_ADDRESS_SPACE_START)) {
+			/*
+			 * The userspace block conflicts with kernel address
+			 * space.
+			 */
+			return false;
+		}
+	}
+
+#ifdef ADDRESS_SPACE_HOLE_START
+	/*
+	 * Check whether the address is outside the address space hole.
+	 */
+	if (overlaps(uspace_addr, size, ADDRESS_SPACE_HOLE_START,
+	    ADDRESS_SPACE_HOLE_END - ADDRESS_SPACE_HOLE_START))
+		return false;
+#endif
+
+	return true;
+}
+
 /** Copy data from userspace to kernel.
  *
  * Provisions are made to return value even after page fault.
@@ -59,37 +92,77 @@
  * @return EOK on success or an error code from @ref errno.h.
  */
 errno_t copy_from_uspace(void *dst, uspace_addr_t uspace_src, size_t size)
+{
+	copy_iovec_t iov = {
+		.kernel = dst,
+		.uspace = uspace_src,
+		.size = size
+	};
+
+	return copy_from_uspace_vec(&iov, 1);
+}
+
+/** Copy data from kernel to userspace.
+ *
+ * Provisions are made to return value even after page fault.
+ *
+ * This function can be called only from syscall.
+ *
+ * @param uspace_dst Destination userspace address.
+ * @param src Source kernel address.
+ * @param size Size of the data to be copied.
+ *
+ * @return 0 on success or an error code from @ref errno.h.
+ */
+errno_t copy_to_uspace(uspace_addr_t uspace_dst, const void *src, size_t size)
+{
+	copy_iovec_t iov = {
+		.kernel = (void *) src,
+		.uspace = uspace_dst,
+		.size = size
+	};
+
+	return copy_to_uspace_vec(&iov, 1);
+}
+
+/** Copy several blocks of data from userspace to kernel.
+ *
+ * All userspace blocks are validated before anything is copied and the
+ * copy state is set up only once for the whole batch. The blocks are
+ * copied in order and the copying stops at the first block which cannot
+ * be read, in which case the contents of the remaining kernel buffers
+ * are undefined.
+ *
+ * This function can be called only from syscall.
+ *
+ * @param iov   Array of blocks to copy.
+ * @param count Number of blocks in the array.
+ *
+ * @return EOK on success or an error code from @ref errno.h.
+ */
+errno_t copy_from_uspace_vec(const copy_iovec_t *iov, size_t count)
 {
 	ipl_t ipl;
-	errno_t rc;
+	errno_t rc = EOK;
 
 	assert(THREAD);
 	assert(!THREAD->in_copy_from_uspace);
 
-	if (!KERNEL_ADDRESS_SPACE_SHADOWED) {
-		if (overlaps(uspace_src, size,
-		    KERNEL_ADDRESS_SPACE_START,
-		    KERNEL_ADDRESS_SPACE_END - KERNEL_ADDRESS_SPACE_START)) {
-			/*
-			 * The userspace source block conflicts with kernel address space.
-			 */
+	for (size_t i = 0; i < count; i++) {
+		if (!copy_uspace_range_valid(iov[i].uspace, iov[i].size))
 			return EPERM;
-		}
 	}
 
-#ifdef ADDRESS_SPACE_HOLE_START
-	/*
-	 * Check whether the address is outside the address space hole.
-	 */
-	if (overlaps(uspace_src, size, ADDRESS_SPACE_HOLE_START,
-	    ADDRESS_SPACE_HOLE_END - ADDRESS_SPACE_HOLE_START))
-		return EPERM;
-#endif
-
 	ipl = interrupts_disable();
 	THREAD->in_copy_from_uspace = true;
 
-	rc = !memcpy_from_uspace(dst, uspace_src, size) ? EPERM : EOK;
+	for (size_t i = 0; i < count; i++) {
+		if (!memcpy_from_uspace(iov[i].kernel, iov[i].uspace,
+		    iov[i].size)) {
+			rc = EPERM;
+			break;
+		}
+	}
 
 	THREAD->in_copy_from_uspace = false;
 
@@ -97,50 +170,43 @@ errno_t copy_from_uspace(void *dst, uspace_addr_t uspace_src, size_t size)
 	return rc;
 }
 
-/** Copy data from kernel to userspace.
+/** Copy several blocks of data from kernel to userspace.
  *
- * Provisions are made to return value even after page fault.
+ * All userspace blocks are validated before anything is copied and the
+ * copy state is set up only once for the whole batch. The blocks are
+ * copied in order and the copying stops at the first block which cannot
+ * be written, in which case the blocks before it have been copied.
  *
  * This function can be called only from syscall.
  *
- * @param uspace_dst Destination userspace address.
- * @param src Source kernel address.
- * @param size Size of the data to be copied.
+ * @param iov   Array of blocks to copy.
+ * @param count Number of blocks in the array.
  *
- * @return 0 on success or an error code from @ref errno.h.
+ * @return EOK on success or an error code from @ref errno.h.
  */
-errno_t copy_to_uspace(uspace_addr_t uspace_dst, const void *src, size_t size)
+errno_t copy_to_uspace_vec(const copy_iovec_t *iov, size_t count)
 {
 	ipl_t ipl;
-	errno_t rc;
+	errno_t rc = EOK;
 
 	assert(THREAD);
 	assert(!THREAD->in_copy_to_uspace);
 
-	if (!KERNEL_ADDRESS_SPACE_SHADOWED) {
-		if (overlaps(uspace_dst, size,
-		    KERNEL_ADDRESS_SPACE_START,
-		    KERNEL_ADDRESS_SPACE_END - KERNEL_ADDRESS_SPACE_START)) {
-			/*
-			 * The userspace destination block conflicts with kernel address space.
-			 */
+	for (size_t i = 0; i < count; i++) {
+		if (!copy_uspace_range_valid(iov[i].uspace, iov[i].size))
 			return EPERM;
-		}
 	}
 
-#ifdef ADDRESS_SPACE_HOLE_START
-	/*
-	 * Check whether the address is outside the address space hole.
-	 */
-	if (overlaps(uspace_dst, size, ADDRESS_SPACE_HOLE_START,
-	    ADDRESS_SPACE_HOLE_END - ADDRESS_SPACE_HOLE_START))
-		return EPERM;
-#endif
-
 	ipl = interrupts_disable();
 	THREAD->in_copy_to_uspace = true;
 
-	rc = !memcpy_to_uspace(uspace_dst, src, size) ? EPERM : EOK;
+	for (size_t i = 0; i < count; i++) {
+		if (!memcpy_to_uspace(iov[i].uspace, iov[i].kernel,
+		    iov[i].size)) {
+			rc = EPERM;
+			break;
+		}
+	}
 
 	THREAD->in_copy_to_uspace = false;
 
@@ -39,8 +39,10 @@
 #include <proc/thread.h>
 #include <proc/task.h>
 #include <proc/program.h>
+#include <proc/cpuset.h>
 #include <mm/as.h>
 #include <mm/page.h>
+#include <arch/cycle.h>
 #include <arch.h>
 #include <debug.h>
 #include <interrupt.h>
@@ -49,11 +51,14 @@
 #include <synch/syswaitq.h>
 #include <ddi/ddi.h>
 #include <ipc/event.h>
+#include <ipc/profile.h>
+#include <security/entropy.h>
 #include <security/perm.h>
 #include <sysinfo/sysinfo.h>
 #include <console/console.h>
 #include <udebug/udebug.h>
 #include <log.h>
+#include <prof.h>
 
 static syshandler_t syscall_table[] = {
 	/* System management syscalls. */
@@ -70,7 +75,11 @@ static syshandler_t syscall_table[] = {
 	[SYS_TASK_SET_NAME] = (syshandler_t) sys_task_set_name,
 	[SYS_TASK_KILL] = (syshandler_t) sys_task_kill,
 	[SYS_TASK_EXIT] = (syshandler_t) sys_task_exit,
+	[SYS_TASK_SET_SCHED_CLASS] = (syshandler_t) sys_task_set_sched_class,
+	[SYS_CPUSET_SET] = (syshandler_t) sys_cpuset_set,
+	[SYS_CPUSET_GET] = (syshandler_t) sys_cpuset_get,
 	[SYS_PROGRAM_SPAWN_LOADER] = (syshandler_t) sys_program_spawn_loader,
+	[SYS_PROGRAM_CLONE] = (syshandler_t) sys_program_clone,
 
 	/* Synchronization related syscalls. */
 	[SYS_WAITQ_CREATE] = (syshandler_t) sys_waitq_create,
@@ -94,9 +103,11 @@ static syshandler_t syscall_table[] = {
 	[SYS_IPC_CALL_ASYNC_SLOW] = (syshandler_t) sys_ipc_call_async_slow,
 	[SYS_IPC_ANSWER_FAST] = (syshandler_t) sys_ipc_answer_fast,
 	[SYS_IPC_ANSWER_SLOW] = (syshandler_t) sys_ipc_answer_slow,
+	[SYS_IPC_ANSWER_BATCH] = (syshandler_t) sys_ipc_answer_batch,
 	[SYS_IPC_FORWARD_FAST] = (syshandler_t) sys_ipc_forward_fast,
 	[SYS_IPC_FORWARD_SLOW] = (syshandler_t) sys_ipc_forward_slow,
 	[SYS_IPC_WAIT] = (syshandler_t) sys_ipc_wait_for_call,
+	[SYS_IPC_WAIT_BATCH] = (syshandler_t) sys_ipc_wait_for_calls,
 	[SYS_IPC_POKE] = (syshandler_t) sys_ipc_poke,
 	[SYS_IPC_HANGUP] = (syshandler_t) sys_ipc_hangup,
 	[SYS_IPC_CONNECT_KBOX] = (syshandler_t) sys_ipc_connect_kbox,
@@ -120,6 +131,7 @@ static syshandler_t syscall_table[] = {
 
 	[SYS_IPC_IRQ_SUBSCRIBE] = (syshandler_t) sys_ipc_irq_subscribe,
 	[SYS_IPC_IRQ_UNSUBSCRIBE] = (syshandler_t) sys_ipc_irq_unsubscribe,
+	[SYS_IPC_IRQ_SET_AFFINITY] = (syshandler_t) sys_ipc_irq_set_affinity,
 
 	/* Sysinfo syscalls. */
 	[SYS_SYSINFO_GET_KEYS_SIZE] = (syshandler_t) sys_sysinfo_get_keys_size,
@@ -133,6 +145,12 @@ static syshandler_t syscall_table[] = {
 	[SYS_DEBUG_CONSOLE] = (syshandler_t) sys_debug_console,
 
 	[SYS_KLOG] = (syshandler_t) sys_klog,
+
+	/* Profiler syscalls. */
+	[SYS_PROF] = (syshandler_t) sys_prof,
+
+	/* Entropy syscalls. */
+	[SYS_ENTROPY_GET] = (syshandler_t) sys_entropy_get,
 };
 
 /** Dispatch system call */
@@ -160,6 +178,10 @@ sysarg_t syscall_handler(sysarg_t a1, sysarg_t a2, sysarg_t a3,
 		udebug_syscall_event(a1, a2, a3, a4, a5, a6, id, 0, false);
 #endif
 
+#ifdef CONFIG_IPC_PROFILE
+	uint64_t start = get_cycle();
+#endif
+
 	sysarg_t rc;
 	if (id < sizeof_array(syscall_table)) {
 		rc = syscall_table[id](a1, a2, a3, a4, a5, a6);
@@ -169,6 +191,10 @@ sysarg_t syscall_handler(sysarg_t a1, sysarg_t a2, sysarg_t a3,
 		task_kill_self(true);
 	}
 
+#ifdef CONFIG_IPC_PROFILE
+	ipc_profile_syscall(id, get_cycle() - start);
+#endif
+
 	if (THREAD->interrupted)
 		thread_exit();
 
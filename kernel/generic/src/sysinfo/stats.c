@@ -41,8 +41,15 @@
 #include <sysinfo/sysinfo.h>
 #include <synch/spinlock.h>
 #include <synch/mutex.h>
+#include <synch/rcu.h>
 #include <time/clock.h>
 #include <mm/frame.h>
+#include <mm/slab.h>
+#include <mm/page.h>
+#include <ddi/ddi.h>
+#include <ddi/irq.h>
+#include <synch/lockstat.h>
+#include <macros.h>
 #include <proc/task.h>
 #include <proc/thread.h>
 #include <interrupt.h>
@@ -52,6 +59,7 @@
 #include <cpu.h>
 #include <arch.h>
 #include <stdlib.h>
+#include <mem.h>
 
 /** Bits of fixed-point precision for load */
 #define LOAD_FIXED_SHIFT  11
@@ -76,6 +84,15 @@ typedef struct {
 	stats_ipcc_t *data;
 } ipccs_state_t;
 
+/** IRQ statistics state */
+typedef struct {
+	bool counting;
+	size_t count;
+	size_t i;
+	task_id_t task;
+	stats_irq_t *data;
+} irqs_state_t;
+
 /** Fixed-point representation of
  *
  * 1 / exp(5 sec / 1 min)
@@ -91,6 +108,22 @@ static load_t avenrdy[LOAD_STEPS] = { 0, 0, 0 };
 /** Load calculation lock */
 static mutex_t load_lock;
 
+/*
+ * Thread statistics generations
+ *
+ * Each thread remembers the generation in which it last changed (was
+ * readied or left a processor). A delta query returns the threads which
+ * changed in or after a given generation and starts a new generation.
+ */
+atomic_size_t stats_generation = 1;
+atomic_size_t stats_removed_generation = 0;
+
+/** Read-only statistics page */
+static stats_page_t *stats_page = NULL;
+
+/** Physical memory area of the statistics page */
+static parea_t stats_parea;
+
 /** Get statistics of all CPUs
  *
  * @param item    Sysinfo item (unused).
@@ -125,6 +158,17 @@ static void *get_stats_cpus(struct sysinfo_item *item, size_t *size,
 		stats_cpus[i].frequency_mhz = cpus[i].frequency_mhz;
 		stats_cpus[i].busy_cycles = cpus[i].busy_cycles;
 		stats_cpus[i].idle_cycles = cpus[i].idle_cycles;
+		stats_cpus[i].sched_count = cpus[i].sched_count;
+		stats_cpus[i].sched_cycles = cpus[i].sched_cycles;
+		stats_cpus[i].steals = cpus[i].steals;
+		stats_cpus[i].steals_failed = cpus[i].steals_failed;
+		stats_cpus[i].migrations = cpus[i].migrations;
+		stats_cpus[i].tick_stops = cpus[i].tick_stops;
+		stats_cpus[i].tlb_shootdowns = cpus[i].tlb_shootdowns;
+		stats_cpus[i].tlb_ipis = cpus[i].tlb_ipis;
+		stats_cpus[i].tlb_lazy = cpus[i].tlb_lazy;
+		memcpy(stats_cpus[i].tlb_latency, cpus[i].tlb_latency,
+		    sizeof(stats_cpus[i].tlb_latency));
 
 		irq_spinlock_unlock(&cpus[i].lock, true);
 	}
@@ -223,6 +267,9 @@ static void produce_stats_task(task_t *task, stats_task_t *stats_task)
 	str_cpy(stats_task->name, TASK_NAME_BUFLEN, task->name);
 	stats_task->virtmem = get_task_virtmem(task->as);
 	stats_task->resmem = get_task_resmem(task->as);
+	stats_task->large_pages = task->as->large_pages;
+	stats_task->page_faults = task->as->page_faults;
+	stats_task->fault_around = task->as->fault_around;
 	stats_task->threads = atomic_load(&task->refcount);
 	task_get_accounting(task, &(stats_task->ucycles),
 	    &(stats_task->kcycles));
@@ -309,6 +356,12 @@ static void produce_stats_thread(thread_t *thread, stats_thread_t *stats_thread)
 	stats_thread->priority = thread->priority;
 	stats_thread->ucycles = thread->ucycles;
 	stats_thread->kcycles = thread->kcycles;
+	stats_thread->rqcycles = thread->rqcycles;
+	stats_thread->ipc_cycles = thread->ipc_cycles;
+	stats_thread->futex_cycles = thread->futex_cycles;
+	stats_thread->sleep_cycles = thread->sleep_cycles;
+	stats_thread->vcsw = thread->vcsw;
+	stats_thread->ivcsw = thread->ivcsw;
 
 	if (thread->cpu != NULL) {
 		stats_thread->on_cpu = true;
@@ -380,6 +433,96 @@ static void *get_stats_threads(struct sysinfo_item *item, size_t *size,
 	return ((void *) stats_threads);
 }
 
+/** Get statistics of threads changed since a generation
+ *
+ * @param name    Generation (as a string).
+ * @param dry_run Do not get the data, just calculate the size.
+ * @param data    Unused.
+ *
+ * @return Sysinfo return holder. The data contain a stats_delta_t header
+ *         followed by the stats_thread_t structures of threads which
+ *         changed in or after the given generation. If some thread was
+ *         removed since then, all threads are returned and the header's
+ *         @c full flag is set.
+ *
+ *         The dry run returns an upper bound of the size without starting
+ *         a new generation. Repeating the query with the same generation
+ *         is harmless, it returns a superset of the previous result.
+ *
+ */
+static sysinfo_return_t get_stats_threads_delta(const char *name,
+    bool dry_run, void *data)
+{
+	sysinfo_return_t ret;
+	ret.tag = SYSINFO_VAL_UNDEFINED;
+
+	/* Parse the generation */
+	uint64_t since;
+	if (str_uint64_t(name, NULL, 0, true, &since) != EOK)
+		return ret;
+
+	/* Messing with threads structures */
+	irq_spinlock_lock(&threads_lock, true);
+
+	size_t count = thread_count();
+	size_t size = sizeof(stats_delta_t) + sizeof(stats_thread_t) * count;
+
+	if (dry_run) {
+		irq_spinlock_unlock(&threads_lock, true);
+
+		ret.tag = SYSINFO_VAL_FUNCTION_DATA;
+		ret.data.data = NULL;
+		ret.data.size = size;
+		return ret;
+	}
+
+	stats_delta_t *delta = (stats_delta_t *) malloc(size);
+	if (delta == NULL) {
+		irq_spinlock_unlock(&threads_lock, true);
+		return ret;
+	}
+
+	stats_thread_t *stats_threads = (stats_thread_t *) (delta + 1);
+
+	/* Changes from now on belong to the next generation */
+	size_t gen = atomic_fetch_add_explicit(&stats_generation, 1,
+	    memory_order_relaxed);
+
+	delta->generation = gen + 1;
+	delta->full = (since == 0) || (atomic_load_explicit(
+	    &stats_removed_generation, memory_order_relaxed) >= since);
+
+	size_t i = 0;
+
+	thread_t *thread = thread_first();
+	while (thread != NULL) {
+		/* Interrupts are already disabled */
+		irq_spinlock_lock(&thread->lock, false);
+
+		/* A running thread changes all the time */
+		if (delta->full || thread->stats_gen >= since ||
+		    atomic_load_explicit(&thread->on_cpu,
+		    memory_order_relaxed)) {
+			produce_stats_thread(thread, &stats_threads[i]);
+			i++;
+		}
+
+		irq_spinlock_unlock(&thread->lock, false);
+
+		thread = thread_next(thread);
+	}
+
+	irq_spinlock_unlock(&threads_lock, true);
+
+	delta->count = i;
+
+	ret.tag = SYSINFO_VAL_FUNCTION_DATA;
+	ret.data.data = (void *) delta;
+	ret.data.size = sizeof(stats_delta_t) + sizeof(stats_thread_t) * i;
+
+	return ret;
+}
+
 /** Produce IPC connection statistics
  *
  * Summarize IPC connection information into IPC connection statistics.
@@ -495,11 +638,179 @@ static void *get_stats_ipccs(struct sysinfo_item *item, size_t *size,
 	return ((void *) state.data);
 }
 
+/** Produce IRQ statistics
+ *
+ * Summarize IRQ subscription information into IRQ statistics.
+ *
+ * @param cap IRQ capability.
+ * @param arg State variable.
+ *
+ */
+static bool produce_stats_irq_cb(cap_t *cap, void *arg)
+{
+	irq_t *irq = cap->kobject->irq;
+	irqs_state_t *state = (irqs_state_t *) arg;
+
+	if (state->counting) {
+		state->count++;
+		return true;
+	}
+
+	if ((state->data == NULL) || (state->i >= state->count))
+		return true;
+
+	stats_irq_t *stats_irq = &state->data[state->i];
+
+	irq_spinlock_lock(&irq->lock, true);
+
+	stats_irq->task = state->task;
+	stats_irq->inr = irq->inr;
+	stats_irq->cpu = irq->notif_cfg.cpu;
+	stats_irq->count = irq->notif_cfg.counter;
+	stats_irq->coalesced = irq->notif_cfg.coalesced;
+	stats_irq->dropped = irq->notif_cfg.dropped;
+
+	irq_spinlock_unlock(&irq->lock, true);
+
+	state->i++;
+	return true;
+}
+
+/** Get IRQ statistics
+ *
+ * @param item    Sysinfo item (unused).
+ * @param size    Size of the returned data.
+ * @param dry_run Do not get the data, just calculate the size.
+ * @param data    Unused.
+ *
+ * @return Data containing several stats_irq_t structures.
+ *         If the return value is not NULL, it should be freed
+ *         in the context of the sysinfo request.
+ *
+ */
+static void *get_stats_irqs(struct sysinfo_item *item, size_t *size,
+    bool dry_run, void *data)
+{
+	/* Messing with tasks structures, avoid deadlock */
+	irq_spinlock_lock(&tasks_lock, true);
+
+	irqs_state_t state = {
+		.counting = true,
+		.count = 0,
+		.i = 0,
+		.data = NULL
+	};
+
+	/* Compute the number of IRQ subscriptions */
+	task_t *task = task_first();
+	while (task != NULL) {
+		task_hold(task);
+		irq_spinlock_unlock(&tasks_lock, true);
+
+		caps_apply_to_kobject_type(task, KOBJECT_TYPE_IRQ,
+		    produce_stats_irq_cb, &state);
+
+		irq_spinlock_lock(&tasks_lock, true);
+
+		task = task_next(task);
+	}
+
+	state.counting = false;
+	*size = sizeof(stats_irq_t) * state.count;
+
+	if (!dry_run)
+		state.data = (stats_irq_t *) malloc(*size);
+
+	/* Gather the statistics for each task */
+	task = task_first();
+	while (task != NULL) {
+		/* We already hold a reference to the task */
+		state.task = task->taskid;
+		irq_spinlock_unlock(&tasks_lock, true);
+
+		caps_apply_to_kobject_type(task, KOBJECT_TYPE_IRQ,
+		    produce_stats_irq_cb, &state);
+
+		irq_spinlock_lock(&tasks_lock, true);
+
+		task_t *prev_task = task;
+		task = task_next(prev_task);
+		task_release(prev_task);
+	}
+
+	irq_spinlock_unlock(&tasks_lock, true);
+
+	/* Subscriptions may have vanished since they were counted */
+	if (state.data != NULL)
+		*size = sizeof(stats_irq_t) * state.i;
+
+	return ((void *) state.data);
+}
+
+#ifdef CONFIG_IPC_PROFILE
+
+/** Get IPC profile of a single task
+ *
+ * @param task_id Task ID.
+ * @param dry_run Do not get the data, just calculate the size.
+ *
+ * @return Sysinfo return holder, see get_stats_task().
+ *
+ */
+static sysinfo_return_t get_stats_task_ipc(task_id_t task_id, bool dry_run)
+{
+	/* Initially no return value */
+	sysinfo_return_t ret;
+	ret.tag = SYSINFO_VAL_UNDEFINED;
+
+	/* The profile is large, allocate it before taking any spinlocks */
+	stats_task_ipc_t *stats_ipc = NULL;
+	if (!dry_run) {
+		stats_ipc = (stats_task_ipc_t *) malloc(sizeof(stats_task_ipc_t));
+		if (stats_ipc == NULL)
+			return ret;
+	}
+
+	/* The task stays valid while in the read-side section */
+	rcu_read_lock();
+
+	task_t *task = task_find_by_id(task_id);
+	if (task == NULL) {
+		/* No task with this ID */
+		rcu_read_unlock();
+		free(stats_ipc);
+		return ret;
+	}
+
+	ret.tag = SYSINFO_VAL_FUNCTION_DATA;
+	ret.data.data = (void *) stats_ipc;
+	ret.data.size = sizeof(stats_task_ipc_t);
+
+	if (dry_run) {
+		rcu_read_unlock();
+		return ret;
+	}
+
+	irq_spinlock_lock(&task->lock, true);
+	rcu_read_unlock();
+
+	memcpy(stats_ipc, &task->ipc_profile, sizeof(stats_task_ipc_t));
+	stats_ipc->task_id = task->taskid;
+
+	irq_spinlock_unlock(&task->lock, true);
+
+	return ret;
+}
+
+#endif /* CONFIG_IPC_PROFILE */
+
 /** Get a single task statistics
  *
  * Get statistics of a given task. The task ID is passed
  * as a string (current limitation of the sysinfo interface,
  * but it is still reasonable for the given purpose).
+ * The IPC profile of the task is available as the "ipc"
+ * item below the task.
  *
  * @param name    Task ID (string-encoded number).
  * @param dry_run Do not get the data, just calculate the size.
@@ -522,16 +833,25 @@ static sysinfo_return_t get_stats_task(const char *name, bool dry_run,
 
 	/* Parse the task ID */
 	task_id_t task_id;
-	if (str_uint64_t(name, NULL, 0, true, &task_id) != EOK)
+	char *rest;
+	if (str_uint64_t(name, &rest, 0, false, &task_id) != EOK)
 		return ret;
 
-	/* Messing with task structures, avoid deadlock */
-	irq_spinlock_lock(&tasks_lock, true);
+#ifdef CONFIG_IPC_PROFILE
+	if (str_cmp(rest, ".ipc") == 0)
+		return get_stats_task_ipc(task_id, dry_run);
+#endif
+
+	if (*rest != 0)
+		return ret;
+
+	/* The task stays valid while in the read-side section */
+	rcu_read_lock();
 
 	task_t *task = task_find_by_id(task_id);
 	if (task == NULL) {
 		/* No task with this ID */
-		irq_spinlock_unlock(&tasks_lock, true);
+		rcu_read_unlock();
 		return ret;
 	}
 
@@ -540,13 +860,13 @@ static sysinfo_return_t get_stats_task(const char *name, bool dry_run,
 		ret.data.data = NULL;
 		ret.data.size = sizeof(stats_task_t);
 
-		irq_spinlock_unlock(&tasks_lock, true);
+		rcu_read_unlock();
 	} else {
 		/* Allocate stats_task_t structure */
 		stats_task_t *stats_task =
 		    (stats_task_t *) malloc(sizeof(stats_task_t));
 		if (stats_task == NULL) {
-			irq_spinlock_unlock(&tasks_lock, true);
+			rcu_read_unlock();
 			return ret;
 		}
 
@@ -555,8 +875,8 @@ static sysinfo_return_t get_stats_task(const char *name, bool dry_run,
 		ret.data.data = (void *) stats_task;
 		ret.data.size = sizeof(stats_task_t);
 
-		/* Hand-over-hand locking */
-		irq_spinlock_exchange(&tasks_lock, &task->lock);
+		irq_spinlock_lock(&task->lock, true);
+		rcu_read_unlock();
 
 		produce_stats_task(task, stats_task);
 
@@ -793,6 +1113,78 @@ static void *get_stats_physmem(struct sysinfo_item *item, size_t *size,
 	return ((void *) stats_physmem);
 }
 
+/** Get slab cache statistics
+ *
+ * @param item    Sysinfo item (unused).
+ * @param size    Size of the returned data.
+ * @param dry_run Do not get the data, just calculate the size.
+ * @param data    Unused.
+ *
+ * @return Data containing several stats_slab_t structures.
+ *         If the return value is not NULL, it should be freed
+ *         in the context of the sysinfo request.
+ */
+static void *get_stats_slabs(struct sysinfo_item *item, size_t *size,
+    bool dry_run, void *data)
+{
+	size_t count = slab_stats(NULL, 0);
+	*size = sizeof(stats_slab_t) * count;
+
+	if (dry_run)
+		return NULL;
+
+	stats_slab_t *stats_slabs = (stats_slab_t *) malloc(*size);
+	if (stats_slabs == NULL) {
+		/* No free space for allocation */
+		*size = 0;
+		return NULL;
+	}
+
+	/* Caches destroyed in the meantime shorten the list */
+	count = min(count, slab_stats(stats_slabs, count));
+	*size = sizeof(stats_slab_t) * count;
+
+	return ((void *) stats_slabs);
+}
+
+#ifdef CONFIG_LOCKSTAT
+
+/** Get lock contention statistics
+ *
+ * @param item    Sysinfo item (unused).
+ * @param size    Size of the returned data.
+ * @param dry_run Do not get the data, just calculate the size.
+ * @param data    Unused.
+ *
+ * @return Data containing several stats_lock_t structures.
+ *         If the return value is not NULL, it should be freed
+ *         in the context of the sysinfo request.
+ */
+static void *get_stats_locks(struct sysinfo_item *item, size_t *size,
+    bool dry_run, void *data)
+{
+	size_t count = lockstat_stats(NULL, 0);
+	*size = sizeof(stats_lock_t) * count;
+
+	if (dry_run)
+		return NULL;
+
+	stats_lock_t *stats_locks = (stats_lock_t *) malloc(*size);
+	if (stats_locks == NULL) {
+		/* No free space for allocation */
+		*size = 0;
+		return NULL;
+	}
+
+	/* Classes acquired for the first time in the meantime are omitted */
+	count = min(count, lockstat_stats(stats_locks, count));
+	*size = sizeof(stats_lock_t) * count;
+
+	return ((void *) stats_locks);
+}
+
+#endif /* CONFIG_LOCKSTAT */
+
 /** Get system load
  *
  * @param item    Sysinfo item (unused).
@@ -859,12 +1251,73 @@ void kload(void *arg)
 		for (i = 0; i < LOAD_STEPS; i++)
 			avenrdy[i] = load_calc(avenrdy[i], load_exp[i], ready);
 
+		if (stats_page != NULL) {
+			stats_page->ready = ready;
+			for (i = 0; i < LOAD_STEPS; i++)
+				stats_page->load[i] = avenrdy[i];
+		}
+
 		mutex_unlock(&load_lock);
 
 		thread_sleep(LOAD_INTERVAL);
 	}
 }
 
+/** Update the number of tasks in the statistics page
+ *
+ * @param count Number of tasks.
+ *
+ */
+void stats_page_set_tasks(size_t count)
+{
+	if (stats_page != NULL)
+		stats_page->tasks = count;
+}
+
+/** Update the number of threads in the statistics page
+ *
+ * @param count Number of threads.
+ *
+ */
+void stats_page_set_threads(size_t count)
+{
+	if (stats_page != NULL)
+		stats_page->threads = count;
+}
+
+/** Set up the read-only statistics page
+ *
+ */
+static void stats_page_init(void)
+{
+	uintptr_t faddr = frame_alloc(1, FRAME_LOWMEM | FRAME_ATOMIC, 0);
+	if (faddr == 0) {
+		/* Not fatal, the page is just not available */
+		return;
+	}
+
+	stats_page_t *page = (stats_page_t *) PA2KA(faddr);
+	memsetb(page, FRAME_SIZE, 0);
+
+	irq_spinlock_lock(&tasks_lock, true);
+	page->tasks = task_count();
+	irq_spinlock_unlock(&tasks_lock, true);
+
+	irq_spinlock_lock(&threads_lock, true);
+	page->threads = thread_count();
+	stats_page = page;
+	irq_spinlock_unlock(&threads_lock, true);
+
+	ddi_parea_init(&stats_parea);
+	stats_parea.pbase = faddr;
+	stats_parea.frames = 1;
+	stats_parea.unpriv = true;
+	stats_parea.mapped = false;
+	ddi_parea_register(&stats_parea);
+
+	sysinfo_set_item_val("system.stats.faddr", NULL, (sysarg_t) faddr);
+}
+
 /** Register sysinfo statistical items
  *
  */
@@ -872,15 +1325,24 @@ void stats_init(void)
 {
 	mutex_initialize(&load_lock, MUTEX_PASSIVE);
 
+	stats_page_init();
+
 	sysinfo_set_item_gen_data("system.cpus", NULL, get_stats_cpus, NULL);
 	sysinfo_set_item_gen_data("system.physmem", NULL, get_stats_physmem, NULL);
 	sysinfo_set_item_gen_data("system.load", NULL, get_stats_load, NULL);
 	sysinfo_set_item_gen_data("system.tasks", NULL, get_stats_tasks, NULL);
 	sysinfo_set_item_gen_data("system.threads", NULL, get_stats_threads, NULL);
 	sysinfo_set_item_gen_data("system.ipccs", NULL, get_stats_ipccs, NULL);
+	sysinfo_set_item_gen_data("system.irqs", NULL, get_stats_irqs, NULL);
 	sysinfo_set_item_gen_data("system.exceptions", NULL, get_stats_exceptions, NULL);
+	sysinfo_set_item_gen_data("system.slabs", NULL, get_stats_slabs, NULL);
+#ifdef CONFIG_LOCKSTAT
+	sysinfo_set_item_gen_data("system.locks", NULL, get_stats_locks, NULL);
+#endif
 	sysinfo_set_subtree_fn("system.tasks", NULL, get_stats_task, NULL);
 	sysinfo_set_subtree_fn("system.threads", NULL, get_stats_thread, NULL);
+	sysinfo_set_subtree_fn("system.threads_delta", NULL,
+	    get_stats_threads_delta, NULL);
 	sysinfo_set_subtree_fn("system.exceptions", NULL, get_stats_exception, NULL);
 }
 
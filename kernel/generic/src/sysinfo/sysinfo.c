@@ -816,6 +816,35 @@ _NO_TRACE static sysinfo_return_t sysinfo_get_keys_uspace(uspace_addr_t ptr, siz
 	return ret;
 }
 
+/** Copy binary data and their size to userspace.
+ *
+ * @param buffer_ptr Destination buffer in userspace.
+ * @param data       Data to copy.
+ * @param size       Size of the data.
+ * @param size_ptr   Destination for the size of the data in userspace.
+ *
+ * @return Error code (EOK in case of no error).
+ *
+ */
+static errno_t sysinfo_data_copy_out(uspace_addr_t buffer_ptr, void *data,
+    size_t size, uspace_ptr_size_t size_ptr)
+{
+	copy_iovec_t iov[] = {
+		{
+			.kernel = data,
+			.uspace = buffer_ptr,
+			.size = size
+		},
+		{
+			.kernel = &size,
+			.uspace = size_ptr,
+			.size = sizeof(size)
+		}
+	};
+
+	return copy_to_uspace_vec(iov, sizeof(iov) / sizeof(iov[0]));
+}
+
 /** Get the sysinfo keys size (syscall)
  *
  * The path string passed from the user space has
@@ -890,9 +919,8 @@ sys_errno_t sys_sysinfo_get_keys(uspace_addr_t path_ptr, size_t path_size,
 	/* Check return data tag */
 	if (ret.tag == SYSINFO_VAL_DATA) {
 		size_t size = min(ret.data.size, buffer_size);
-		rc = copy_to_uspace(buffer_ptr, ret.data.data, size);
-		if (rc == EOK)
-			rc = copy_to_uspace(size_ptr, &size, sizeof(size));
+		rc = sysinfo_data_copy_out(buffer_ptr, ret.data.data, size,
+		    size_ptr);
 
 		free(ret.data.data);
 	} else
@@ -1048,9 +1076,8 @@ sys_errno_t sys_sysinfo_get_data(uspace_addr_t path_ptr, size_t path_size,
 	if ((ret.tag == SYSINFO_VAL_DATA) ||
 	    (ret.tag == SYSINFO_VAL_FUNCTION_DATA)) {
 		size_t size = min(ret.data.size, buffer_size);
-		rc = copy_to_uspace(buffer_ptr, ret.data.data, size);
-		if (rc == EOK)
-			rc = copy_to_uspace(size_ptr, &size, sizeof(size));
+		rc = sysinfo_data_copy_out(buffer_ptr, ret.data.data, size,
+		    size_ptr);
 	} else
 		rc = EINVAL;
 
@@ -41,9 +41,11 @@
  *
  */
 
+#include <assert.h>
 #include <time/clock.h>
 #include <time/timeout.h>
 #include <config.h>
+#include <synch/rcu.h>
 #include <synch/spinlock.h>
 #include <synch/waitq.h>
 #include <halt.h>
@@ -59,10 +61,14 @@
 #include <ddi/ddi.h>
 #include <arch/cycle.h>
 #include <preemption.h>
+#include <prof.h>
 
 /* Pointer to variable with uptime */
 uptime_t *uptime;
 
+/** Clock source able to stop the tick on idle processors (if any) */
+clock_tick_ops_t *clock_tick_ops = NULL;
+
 /** Physical memory area of the real time clock */
 static parea_t clock_parea;
 
@@ -129,6 +135,93 @@ static void cpu_update_accounting(void)
 	irq_spinlock_unlock(&CPU->lock, false);
 }
 
+/** Stop the periodic tick on an idle processor
+ *
+ * Called by the scheduler right before the processor goes to sleep
+ * with interrupts disabled. The tick is replaced by a single clock
+ * interrupt which will arrive at the earliest timeout deadline. The
+ * processor which maintains the public uptime counters never stops
+ * its tick.
+ *
+ */
+void clock_tick_stop(void)
+{
+#ifdef CONFIG_TICKLESS
+	assert(interrupts_disabled());
+
+	if ((clock_tick_ops == NULL) || (CPU->id == 0) ||
+	    (CPU->tick_stopped > 0))
+		return;
+
+	deadline_t deadline = timeout_next_deadline();
+
+	/* Expired timeouts are still being handled. */
+	if (deadline < CPU->current_clock_tick)
+		return;
+
+	/*
+	 * Timeouts expire in the first tick past their deadline.
+	 */
+	uint64_t ticks = clock_tick_ops->max_ticks;
+	if (deadline < CPU->current_clock_tick + ticks)
+		ticks = deadline + 1 - CPU->current_clock_tick;
+
+	/* Not worth it, the next tick is coming anyway. */
+	if (ticks <= 1)
+		return;
+
+	/*
+	 * Pairs with clock_tick_kick(). Either we see a thread that has
+	 * just been readied to this processor, or its readier sees our
+	 * tick stopped and wakes us up.
+	 */
+	CPU->tick_stopped = ticks;
+	memory_barrier();
+	if (atomic_load(&CPU->nrdy) > 0) {
+		CPU->tick_stopped = 0;
+		return;
+	}
+
+	CPU->tick_stops++;
+	clock_tick_ops->stop(ticks);
+#endif
+}
+
+/** Restart the periodic tick after an idle period
+ *
+ * Called on the first interrupt after the processor woke up. Advance
+ * the processor's clock by the ticks that elapsed while it was sleeping
+ * so that interrupt handlers see the correct time.
+ *
+ */
+void clock_tick_restart(void)
+{
+#ifdef CONFIG_TICKLESS
+	if (CPU->tick_stopped == 0)
+		return;
+
+	uint64_t ticks = clock_tick_ops->restart(CPU->tick_stopped);
+	CPU->tick_stopped = 0;
+	CPU->current_clock_tick += ticks;
+#endif
+}
+
+/** Make sure an idle processor notices new work
+ *
+ * If @a cpu has its periodic tick stopped, it would otherwise sleep
+ * until its next timeout.
+ *
+ * @param cpu Processor which has been given a thread to run.
+ *
+ */
+void clock_tick_kick(cpu_t *cpu)
+{
+#ifdef CONFIG_TICKLESS
+	if ((cpu != CPU) && (cpu->tick_stopped > 0))
+		clock_tick_ops->wakeup(cpu);
+#endif
+}
+
 /** Clock routine
  *
  * Clock routine executed from clock interrupt handler
@@ -148,38 +241,16 @@ void clock(void)
 	/* Account CPU usage */
 	cpu_update_accounting();
 
-	/*
-	 * To avoid lock ordering problems,
-	 * run all expired timeouts as you visit them.
-	 *
-	 */
-
-	irq_spinlock_lock(&CPU->timeoutlock, false);
-
-	link_t *cur;
-	while ((cur = list_first(&CPU->timeout_active_list)) != NULL) {
-		timeout_t *timeout = list_get_instance(cur, timeout_t, link);
-
-		if (current_clock_tick <= timeout->deadline) {
-			break;
-		}
-
-		list_remove(cur);
-		timeout_handler_t handler = timeout->handler;
-		void *arg = timeout->arg;
-		atomic_bool *finished = &timeout->finished;
-
-		irq_spinlock_unlock(&CPU->timeoutlock, false);
-
-		handler(arg);
-
-		/* Signal that the handler is finished. */
-		atomic_store_explicit(finished, true, memory_order_release);
+#ifdef CONFIG_PROFILER
+	prof_tick();
+#endif
 
-		irq_spinlock_lock(&CPU->timeoutlock, false);
-	}
+	/* A preemptible interrupted context is not an RCU reader. */
+	if (PREEMPTION_ENABLED)
+		rcu_quiescent();
 
-	irq_spinlock_unlock(&CPU->timeoutlock, false);
+	/* Run all timeouts expired since the last tick, missed ticks too. */
+	timeout_expire(current_clock_tick);
 
 	/*
 	 * Do CPU usage accounting and find out whether to preempt THREAD.
@@ -187,7 +258,11 @@ void clock(void)
 	 */
 
 	if (THREAD) {
-		if (current_clock_tick >= CPU->preempt_deadline && PREEMPTION_ENABLED) {
+		bool preempt = (current_clock_tick >= CPU->preempt_deadline) ||
+		    atomic_load_explicit(&CPU->preempt_request,
+		    memory_order_relaxed);
+
+		if (preempt && PREEMPTION_ENABLED) {
 			scheduler();
 #ifdef CONFIG_UDEBUG
 			/*
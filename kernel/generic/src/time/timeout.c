@@ -37,6 +37,8 @@
  */
 
 #include <time/timeout.h>
+#include <adt/twheel.h>
+#include <assert.h>
 #include <typedefs.h>
 #include <config.h>
 #include <panic.h>
@@ -54,7 +56,80 @@
 void timeout_init(void)
 {
 	irq_spinlock_initialize(&CPU->timeoutlock, "cpu.timeoutlock");
-	list_initialize(&CPU->timeout_active_list);
+	twheel_initialize(&CPU->timeout_wheel, CPU->current_clock_tick);
+	list_initialize(&CPU->timeout_expired);
+}
+
+/** Get the earliest deadline on the current CPU
+ *
+ * The returned deadline is a lower bound, timeouts far away are only
+ * known to the precision of the level of the timeout wheel they are on.
+ * Interrupts must be disabled.
+ *
+ * @return Earliest deadline or DEADLINE_NEVER if there are no timeouts.
+ *
+ */
+deadline_t timeout_next_deadline(void)
+{
+	assert(interrupts_disabled());
+
+	deadline_t deadline = DEADLINE_NEVER;
+
+	irq_spinlock_lock(&CPU->timeoutlock, false);
+
+	uint64_t next;
+	if (!list_empty(&CPU->timeout_expired))
+		deadline = 0;
+	else if (twheel_next(&CPU->timeout_wheel, &next))
+		deadline = next - 1;
+
+	irq_spinlock_unlock(&CPU->timeoutlock, false);
+
+	return deadline;
+}
+
+/** Run expired timeouts on the current CPU
+ *
+ * All ticks up to @a tick are processed in a single pass over the timeout
+ * wheel, the handlers of the collected timeouts then run one by one with
+ * the timeout lock released. Interrupts must be disabled.
+ *
+ * @param tick Current clock tick.
+ *
+ */
+void timeout_expire(uint64_t tick)
+{
+	assert(interrupts_disabled());
+
+	irq_spinlock_lock(&CPU->timeoutlock, false);
+
+	twheel_advance(&CPU->timeout_wheel, tick, &CPU->timeout_expired);
+
+	link_t *cur;
+	while ((cur = list_first(&CPU->timeout_expired)) != NULL) {
+		timeout_t *timeout =
+		    list_get_instance(cur, timeout_t, timer.link);
+
+		list_remove(cur);
+		timeout_handler_t handler = timeout->handler;
+		void *arg = timeout->arg;
+		atomic_bool *finished = &timeout->finished;
+
+		/*
+		 * To avoid lock ordering problems, the handler runs without
+		 * the timeout lock.
+		 */
+		irq_spinlock_unlock(&CPU->timeoutlock, false);
+
+		handler(arg);
+
+		/* Signal that the handler is finished. */
+		atomic_store_explicit(finished, true, memory_order_release);
+
+		irq_spinlock_lock(&CPU->timeoutlock, false);
+	}
+
+	irq_spinlock_unlock(&CPU->timeoutlock, false);
 }
 
 /** Initialize timeout
@@ -66,7 +141,7 @@ void timeout_init(void)
  */
 void timeout_initialize(timeout_t *timeout)
 {
-	link_initialize(&timeout->link);
+	link_initialize(&timeout->timer.link);
 	timeout->cpu = NULL;
 }
 
@@ -82,7 +157,7 @@ deadline_t timeout_deadline_in_usec(uint32_t usec)
 static void timeout_register_deadline_locked(timeout_t *timeout, deadline_t deadline,
     timeout_handler_t handler, void *arg)
 {
-	assert(!link_in_use(&timeout->link));
+	assert(!link_in_use(&timeout->timer.link));
 
 	*timeout = (timeout_t) {
 		.cpu = CPU,
@@ -92,21 +167,17 @@ static void timeout_register_deadline_locked(timeout_t *timeout, deadline_t dead
 		.finished = ATOMIC_VAR_INIT(false),
 	};
 
-	/* Insert timeout into the active timeouts list according to timeout->deadline. */
-
-	link_t *last = list_last(&CPU->timeout_active_list);
-	if (last == NULL || timeout->deadline >= list_get_instance(last, timeout_t, link)->deadline) {
-		list_append(&timeout->link, &CPU->timeout_active_list);
-	} else {
-		for (link_t *cur = list_first(&CPU->timeout_active_list); cur != NULL;
-		    cur = list_next(cur, &CPU->timeout_active_list)) {
-
-			if (timeout->deadline < list_get_instance(cur, timeout_t, link)->deadline) {
-				list_insert_before(&timeout->link, cur);
-				break;
-			}
-		}
-	}
+	/*
+	 * The wheel only advances in clock(), move an idle one to the
+	 * current tick so that the timeout lands on its lowest level.
+	 */
+	if (twheel_empty(&CPU->timeout_wheel))
+		twheel_restart(&CPU->timeout_wheel, CPU->current_clock_tick);
+
+	/* Timeouts expire in the first tick past their deadline. */
+	uint64_t expires = (deadline == DEADLINE_NEVER) ?
+	    deadline : deadline + 1;
+	twheel_insert(&CPU->timeout_wheel, &timeout->timer, expires);
 }
 
 /** Register timeout
@@ -139,7 +210,8 @@ void timeout_register_deadline(timeout_t *timeout, deadline_t deadline,
 
 /** Unregister timeout
  *
- * Remove timeout from timeout list.
+ * Remove timeout from the timeout wheel, or from the list of expired
+ * timeouts if its handler has not started yet.
  *
  * @param timeout Timeout to unregister.
  *
@@ -156,10 +228,9 @@ bool timeout_unregister(timeout_t *timeout)
 
 	irq_spinlock_lock(&timeout->cpu->timeoutlock, true);
 
-	bool success = link_in_use(&timeout->link);
-	if (success) {
-		list_remove(&timeout->link);
-	}
+	bool success = link_in_use(&timeout->timer.link);
+	if (success)
+		twheel_remove(&timeout->cpu->timeout_wheel, &timeout->timer);
 
 	irq_spinlock_unlock(&timeout->cpu->timeoutlock, true);
 
@@ -435,6 +435,35 @@ static void udebug_receive_mem_read(call_t *call)
 	ipc_answer(&TASK->kb.box, call);
 }
 
+/** Process a MEM_SNAPSHOT call.
+ *
+ * Takes a snapshot of memory of the current (debugged) task and maps it
+ * into the address space of the debugger.
+ * @param call	The call structure.
+ */
+static void udebug_receive_mem_snapshot(call_t *call)
+{
+	uspace_addr_t uspace_src;
+	size_t size;
+	uintptr_t bound;
+	uintptr_t dst_base = (uintptr_t) AS_AREA_ANY;
+	errno_t rc;
+
+	uspace_src = ipc_get_arg2(&call->data);
+	size = ipc_get_arg3(&call->data);
+	bound = ipc_get_arg4(&call->data);
+
+	irq_spinlock_lock(&call->sender->lock, true);
+	as_t *as = call->sender->as;
+	irq_spinlock_unlock(&call->sender->lock, true);
+
+	rc = udebug_mem_snapshot(uspace_src, size, as, bound, &dst_base);
+
+	ipc_set_retval(&call->data, rc);
+	ipc_set_arg1(&call->data, dst_base);
+	ipc_answer(&TASK->kb.box, call);
+}
+
 /** Handle a debug call received on the kernel answerbox.
  *
  * This is called by the kbox servicing thread. Verifies that the sender
@@ -495,6 +524,9 @@ void udebug_call_receive(call_t *call)
 	case UDEBUG_M_MEM_READ:
 		udebug_receive_mem_read(call);
 		break;
+	case UDEBUG_M_MEM_SNAPSHOT:
+		udebug_receive_mem_snapshot(call);
+		break;
 	}
 }
 
@@ -39,6 +39,7 @@
  * when servicing udebug IPC messages.
  */
 
+#include <align.h>
 #include <debug.h>
 #include <proc/task.h>
 #include <proc/thread.h>
@@ -48,6 +49,7 @@
 #include <str.h>
 #include <syscall/copy.h>
 #include <ipc/ipc.h>
+#include <mm/as.h>
 #include <udebug/udebug.h>
 #include <udebug/udebug_ops.h>
 #include <mem.h>
@@ -573,5 +575,85 @@ errno_t udebug_mem_read(uspace_addr_t uspace_addr, size_t n, void **buffer)
 	return EOK;
 }
 
+/** Take a snapshot of the memory of the debugged task.
+ *
+ * Copies @a n bytes starting at @a uspace_addr into a new anonymous area
+ * and shares the copy read-only into @a dst_as. The copy is made in the
+ * address space of the debugged task and is unmapped from it before
+ * returning, so the snapshot stays valid no matter what the debugged task
+ * does after it is resumed.
+ *
+ * @param uspace_addr Page-aligned address from where to start copying.
+ * @param n           Number of bytes to copy.
+ * @param dst_as      Address space to map the snapshot into.
+ * @param bound       Lowest address bound for the snapshot in @a dst_as.
+ * @param dst_base    Place to store the base address of the snapshot.
+ *
+ * @return EOK on success, EBUSY if the task is not being debugged,
+ *         EINVAL if @a uspace_addr is not aligned, ENOMEM if out of
+ *         memory or an error code from copying or sharing the area.
+ *
+ */
+errno_t udebug_mem_snapshot(uspace_addr_t uspace_addr, size_t n, as_t *dst_as,
+    uintptr_t bound, uintptr_t *dst_base)
+{
+	if (!IS_ALIGNED(uspace_addr, PAGE_SIZE) || (n == 0))
+		return EINVAL;
+
+	/* Verify task state */
+	mutex_lock(&TASK->udebug.lock);
+
+	if (TASK->udebug.dt_state != UDEBUG_TS_ACTIVE) {
+		mutex_unlock(&TASK->udebug.lock);
+		return EBUSY;
+	}
+
+	size_t size = ALIGN_UP(n, PAGE_SIZE);
+	uintptr_t copy = (uintptr_t) AS_AREA_ANY;
+
+	as_area_t *area = as_area_create(AS, AS_AREA_READ | AS_AREA_WRITE |
+	    AS_AREA_CACHEABLE, size, AS_AREA_ATTR_NONE, &anon_backend, NULL,
+	    &copy, uspace_addr + size);
+	if (area == NULL) {
+		mutex_unlock(&TASK->udebug.lock);
+		return ENOMEM;
+	}
+
+	void *page = malloc(PAGE_SIZE);
+	if (page == NULL) {
+		mutex_unlock(&TASK->udebug.lock);
+		(void) as_area_destroy(AS, copy);
+		return ENOMEM;
+	}
+
+	/*
+	 * The pages of the copy are allocated as they are written. Pages of
+	 * the source which are not present are faulted in, just like when
+	 * reading them with udebug_mem_read().
+	 */
+	errno_t rc = EOK;
+	for (size_t off = 0; off < size; off += PAGE_SIZE) {
+		rc = copy_from_uspace(page, uspace_addr + off, PAGE_SIZE);
+		if (rc != EOK)
+			break;
+
+		rc = copy_to_uspace(copy + off, page, PAGE_SIZE);
+		if (rc != EOK)
+			break;
+	}
+
+	free(page);
+	mutex_unlock(&TASK->udebug.lock);
+
+	if (rc == EOK) {
+		rc = as_area_share(AS, copy, size, dst_as, AS_AREA_READ,
+		    dst_base, bound);
+	}
+
+	/* The frames stay referenced by the shared copy in dst_as. */
+	(void) as_area_destroy(AS, copy);
+	return rc;
+}
+
 /** @}
  */
@@ -28,7 +28,6 @@
  */
 
 #include <stdbool.h>
-#include <dirent.h>
 #include <errno.h>
 #include <macros.h>
 #include <stdlib.h>
@@ -39,6 +38,7 @@
 #include "scli.h"
 #include "cmds/cmds.h"
 #include "compl.h"
+#include "dircache.h"
 #include "exec.h"
 #include "tok.h"
 #include "util.h"
@@ -77,8 +77,10 @@ typedef struct {
 	const char *const *path;
 	/** If not @c NULL, should be freed in the end. */
 	char **path_list;
-	/** Current open directory */
-	DIR *dir;
+	/** Listing of the current directory */
+	dircache_dir_t *dir;
+	/** Index of the next entry in @c dir */
+	size_t dir_pos;
 
 	char *last_compl;
 
@@ -317,7 +319,7 @@ static bool compl_match_prefix(compl_t *cs, const char *compl)
 static errno_t compl_get_next(void *state, char **compl)
 {
 	compl_t *cs = (compl_t *) state;
-	struct dirent *dent;
+	dircache_ent_t *dent;
 
 	*compl = NULL;
 
@@ -374,58 +376,53 @@ static errno_t compl_get_next(void *state, char **compl)
 		}
 	}
 
-	/* Files and directories. We scan entries from a set of directories. */
+	/*
+	 * Files and directories. We scan entries from a set of directories,
+	 * their listings are cached across completions.
+	 */
 	if (cs->path != NULL) {
 		while (*compl == NULL) {
-			/* Open next directory */
+			/* Get listing of next directory */
 			while (cs->dir == NULL) {
 				if (*cs->path == NULL)
 					break;
 
-				cs->dir = opendir(*cs->path);
-
-				/* Skip directories that we fail to open. */
-				if (cs->dir == NULL)
+				/* Skip directories that we fail to read. */
+				if (dircache_get(*cs->path, &cs->dir) != EOK)
 					cs->path++;
+				cs->dir_pos = 0;
 			}
 
 			/* If it was the last one, we are done */
 			if (cs->dir == NULL)
 				break;
 
-			/* Read next directory entry */
-			dent = readdir(cs->dir);
-			if (dent == NULL) {
-				/* Error. Close directory, go to next one */
-				closedir(cs->dir);
+			/* Take next directory entry */
+			if (cs->dir_pos >= cs->dir->count) {
+				/* Done with this one, go to next one */
 				cs->dir = NULL;
 				cs->path++;
 				continue;
 			}
 
-			if (compl_match_prefix(cs, dent->d_name)) {
-				/* Construct pathname */
-				char *ent_path;
-				asprintf(&ent_path, "%s/%s", *cs->path, dent->d_name);
-				vfs_stat_t ent_stat;
-				if (vfs_stat_path(ent_path, &ent_stat) != EOK) {
+			dent = cs->dir->ents[cs->dir_pos++];
+
+			if (compl_match_prefix(cs, dent->name)) {
+				if (dircache_stat(cs->dir, dent) != EOK) {
 					/* Error */
-					free(ent_path);
 					continue;
 				}
 
-				free(ent_path);
-
 				/* prevents multiple listing of an overriden cmd */
-				if (cs->is_command && !ent_stat.is_directory) {
-					odlink_t *alias_link = odict_find_eq(&alias_dict, (void *)dent->d_name, NULL);
+				if (cs->is_command && !dent->is_directory) {
+					odlink_t *alias_link = odict_find_eq(&alias_dict, (void *)dent->name, NULL);
 					if (alias_link != NULL) {
 						continue;
 					}
 				}
 
-				asprintf(compl, "%s%c", dent->d_name,
-				    ent_stat.is_directory ? '/' : ' ');
+				asprintf(compl, "%s%c", dent->name,
+				    dent->is_directory ? '/' : ' ');
 				cs->last_compl = *compl;
 				if (*compl == NULL)
 					return ENOMEM;
@@ -455,8 +452,6 @@ static void compl_fini(void *state)
 
 	if (cs->last_compl != NULL)
 		free(cs->last_compl);
-	if (cs->dir != NULL)
-		closedir(cs->dir);
 
 	free(cs->prefix);
 	free(cs);
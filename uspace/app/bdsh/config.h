@@ -46,6 +46,11 @@
 #define HUBS_MAX 20
 #endif
 
+/* define maximal number of commands in a pipeline */
+#ifndef PIPELINE_MAX
+#define PIPELINE_MAX 16
+#endif
+
 /* Used in many places */
 #define SMALL_BUFLEN 256
 #define LARGE_BUFLEN 1024
@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Cache of directory listings. Resolving a command name against the search
+ * directories and completing names on the command line used to cost a VFS
+ * round trip per probed path or per directory entry. The listings are now
+ * read once and reused until they expire or the shell runs a command which
+ * might have changed them.
+ *
+ * There are no directory change notifications, so the listings of the
+ * search directories are only trusted for DIRCACHE_TTL seconds. Callers
+ * must be prepared for a stale listing, e.g. by probing the file system for
+ * names missing from the listing.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <dirent.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <time.h>
+#include <vfs/vfs.h>
+
+#include "dircache.h"
+
+/** Cached listings, most recently used first */
+static LIST_INITIALIZE(dircache_dirs);
+
+/** Number of cached listings */
+static size_t dircache_cnt;
+
+static size_t dircache_name_hash(const char *name)
+{
+	size_t hash = 0;
+
+	while (*name != '\0')
+		hash = hash_combine(hash, (uint8_t) *name++);
+
+	return hash;
+}
+
+static size_t dircache_ent_key_hash(const void *key)
+{
+	return dircache_name_hash(key);
+}
+
+static size_t dircache_ent_hash(const ht_link_t *item)
+{
+	dircache_ent_t *ent = hash_table_get_inst(item, dircache_ent_t, link);
+	return dircache_name_hash(ent->name);
+}
+
+static bool dircache_ent_key_equal(const void *key, const ht_link_t *item)
+{
+	dircache_ent_t *ent = hash_table_get_inst(item, dircache_ent_t, link);
+	return str_cmp(ent->name, key) == 0;
+}
+
+static void dircache_ent_remove_callback(ht_link_t *item)
+{
+	dircache_ent_t *ent = hash_table_get_inst(item, dircache_ent_t, link);
+
+	free(ent->name);
+	free(ent);
+}
+
+static const hash_table_ops_t dircache_ent_ops = {
+	.hash = dircache_ent_hash,
+	.key_hash = dircache_ent_key_hash,
+	.key_equal = dircache_ent_key_equal,
+	.equal = NULL,
+	.remove_callback = dircache_ent_remove_callback
+};
+
+/** Free a cached listing, it must not be in the list of listings. */
+static void dircache_dir_free(dircache_dir_t *dir)
+{
+	/* The remove callback frees the entries. */
+	hash_table_destroy(&dir->names);
+	free(dir->ents);
+	free(dir->path);
+	free(dir);
+}
+
+/** Remove a listing from the cache and free it. */
+static void dircache_drop(dircache_dir_t *dir)
+{
+	list_remove(&dir->link);
+	dircache_cnt--;
+	dircache_dir_free(dir);
+}
+
+/** Read the listing of a directory.
+ *
+ * @param path	Absolute path of the directory, consumed by this function
+ * @param rdir	Place to store the new listing
+ *
+ * @return	EOK on success or an error code
+ */
+static errno_t dircache_load(char *path, dircache_dir_t **rdir)
+{
+	dircache_dir_t *dir;
+	struct dirent *dent;
+	size_t alloc = 0;
+	errno_t rc;
+
+	dir = calloc(1, sizeof(dircache_dir_t));
+	if (dir == NULL) {
+		free(path);
+		return ENOMEM;
+	}
+
+	link_initialize(&dir->link);
+	dir->path = path;
+	if (!hash_table_create(&dir->names, 0, 0, &dircache_ent_ops)) {
+		free(path);
+		free(dir);
+		return ENOMEM;
+	}
+
+	DIR *d = opendir(path);
+	if (d == NULL) {
+		rc = errno != EOK ? errno : EIO;
+		goto error;
+	}
+
+	while ((dent = readdir(d)) != NULL) {
+		if (dir->count == alloc) {
+			size_t nalloc = (alloc == 0) ? 16 : 2 * alloc;
+			dircache_ent_t **ents = realloc(dir->ents,
+			    nalloc * sizeof(dircache_ent_t *));
+			if (ents == NULL) {
+				rc = ENOMEM;
+				goto error_close;
+			}
+
+			dir->ents = ents;
+			alloc = nalloc;
+		}
+
+		dircache_ent_t *ent = calloc(1, sizeof(dircache_ent_t));
+		if (ent == NULL) {
+			rc = ENOMEM;
+			goto error_close;
+		}
+
+		ent->name = str_dup(dent->d_name);
+		if (ent->name == NULL) {
+			free(ent);
+			rc = ENOMEM;
+			goto error_close;
+		}
+
+		hash_table_insert(&dir->names, &ent->link);
+		dir->ents[dir->count++] = ent;
+	}
+
+	closedir(d);
+	getuptime(&dir->loaded);
+	*rdir = dir;
+	return EOK;
+
+error_close:
+	closedir(d);
+error:
+	dircache_dir_free(dir);
+	return rc;
+}
+
+/** Get the listing of a directory.
+ *
+ * The listing is read from the file system unless there is a fresh one in
+ * the cache. It is valid until the next call to dircache_get() or
+ * dircache_flush().
+ *
+ * @param path	Path of the directory
+ * @param rdir	Place to store the listing
+ *
+ * @return	EOK on success or an error code
+ */
+errno_t dircache_get(const char *path, dircache_dir_t **rdir)
+{
+	struct timespec now;
+	dircache_dir_t *dir = NULL;
+	errno_t rc;
+
+	char *apath = vfs_absolutize(path, NULL);
+	if (apath == NULL)
+		return ENOMEM;
+
+	getuptime(&now);
+
+	list_foreach_safe(dircache_dirs, cur, next) {
+		dir = list_get_instance(cur, dircache_dir_t, link);
+		if (str_cmp(dir->path, apath) != 0)
+			continue;
+
+		if (NSEC2SEC(ts_sub_diff(&now, &dir->loaded)) < DIRCACHE_TTL) {
+			free(apath);
+			list_remove(&dir->link);
+			list_prepend(&dir->link, &dircache_dirs);
+			*rdir = dir;
+			return EOK;
+		}
+
+		dircache_drop(dir);
+		break;
+	}
+
+	rc = dircache_load(apath, &dir);
+	if (rc != EOK)
+		return rc;
+
+	if (dircache_cnt == DIRCACHE_MAX) {
+		dircache_drop(list_get_instance(list_last(&dircache_dirs),
+		    dircache_dir_t, link));
+	}
+
+	list_prepend(&dir->link, &dircache_dirs);
+	dircache_cnt++;
+	*rdir = dir;
+	return EOK;
+}
+
+/** Look up an entry of a listing by name.
+ *
+ * @param dir	Listing
+ * @param name	Name of the entry
+ *
+ * @return	Entry or @c NULL if the listing has no such entry
+ */
+dircache_ent_t *dircache_lookup(dircache_dir_t *dir, const char *name)
+{
+	ht_link_t *link = hash_table_find(&dir->names, name);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, dircache_ent_t, link);
+}
+
+/** Make sure the type of an entry of a listing is known.
+ *
+ * The entries are only stat'ed on demand so that reading a listing costs
+ * no more than reading the directory.
+ *
+ * @param dir	Listing
+ * @param ent	Entry of @a dir, its @c is_directory and @c is_file are valid
+ *		on success
+ *
+ * @return	EOK on success or an error code
+ */
+errno_t dircache_stat(dircache_dir_t *dir, dircache_ent_t *ent)
+{
+	vfs_stat_t st;
+	char *path;
+	errno_t rc;
+
+	if (ent->stat_valid)
+		return EOK;
+
+	if (asprintf(&path, "%s/%s", dir->path, ent->name) < 0)
+		return ENOMEM;
+
+	rc = vfs_stat_path(path, &st);
+	free(path);
+	if (rc != EOK)
+		return rc;
+
+	ent->is_directory = st.is_directory;
+	ent->is_file = st.is_file;
+	ent->stat_valid = true;
+	return EOK;
+}
+
+/** Drop cached listings.
+ *
+ * Meant to be called whenever the shell has run commands which might have
+ * changed the file system.
+ *
+ * @param keep	NULL-terminated array of paths of the directories whose
+ *		listings are kept until they expire or @c NULL
+ */
+void dircache_flush(const char *const *keep)
+{
+	list_foreach_safe(dircache_dirs, cur, next) {
+		dircache_dir_t *dir = list_get_instance(cur, dircache_dir_t,
+		    link);
+		bool kept = false;
+
+		for (size_t i = 0; keep != NULL && keep[i] != NULL; i++) {
+			if (str_cmp(dir->path, keep[i]) == 0) {
+				kept = true;
+				break;
+			}
+		}
+
+		if (!kept)
+			dircache_drop(dir);
+	}
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DIRCACHE_H
+#define DIRCACHE_H
+
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+/** How long a cached directory listing is trusted (seconds) */
+#define DIRCACHE_TTL 5
+
+/** Maximum number of cached directory listings */
+#define DIRCACHE_MAX 8
+
+/** Entry of a cached directory listing */
+typedef struct {
+	/** Link in dircache_dir_t.names */
+	ht_link_t link;
+	/** Name of the entry */
+	char *name;
+	/** @c is_directory and @c is_file are valid */
+	bool stat_valid;
+	/** Entry is a directory */
+	bool is_directory;
+	/** Entry is a regular file */
+	bool is_file;
+} dircache_ent_t;
+
+/** Cached directory listing */
+typedef struct {
+	/** Link in the list of cached listings, most recently used first */
+	link_t link;
+	/** Absolute path of the directory */
+	char *path;
+	/** Time when the listing was read */
+	struct timespec loaded;
+	/** Entries in the order of the directory */
+	dircache_ent_t **ents;
+	/** Number of entries */
+	size_t count;
+	/** Entries hashed by name */
+	hash_table_t names;
+} dircache_dir_t;
+
+extern errno_t dircache_get(const char *, dircache_dir_t **);
+extern dircache_ent_t *dircache_lookup(dircache_dir_t *, const char *);
+extern errno_t dircache_stat(dircache_dir_t *, dircache_ent_t *);
+extern void dircache_flush(const char *const *);
+
+#endif
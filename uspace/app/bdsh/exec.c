@@ -42,6 +42,7 @@
 #include <vfs/vfs.h>
 
 #include "config.h"
+#include "dircache.h"
 #include "util.h"
 #include "exec.h"
 #include "errors.h"
@@ -88,7 +89,11 @@ static errno_t find_command(char *cmd, char **found)
 		return ENOMEM;
 	}
 
-	/* We now have n places to look for the command */
+	/*
+	 * We now have n places to look for the command. Look the name up in
+	 * the cached listings of the directories first, only names missing
+	 * from them are probed as the listing might be stale.
+	 */
 	size_t i;
 	size_t cmd_length = str_length(cmd);
 	for (i = 0; search_dir[i] != NULL; i++) {
@@ -97,6 +102,19 @@ static errno_t find_command(char *cmd, char **found)
 			return ENOMEM;
 		}
 
+		memset(*found, 0, PATH_MAX);
+		snprintf(*found, PATH_MAX, "%s/%s", search_dir[i], cmd);
+
+		dircache_dir_t *dir;
+		if (dircache_get(search_dir[i], &dir) == EOK) {
+			dircache_ent_t *ent = dircache_lookup(dir, cmd);
+			if (ent != NULL && dircache_stat(dir, ent) == EOK &&
+			    ent->is_file)
+				return EOK;
+		}
+	}
+
+	for (i = 0; search_dir[i] != NULL; i++) {
 		memset(*found, 0, PATH_MAX);
 		snprintf(*found, PATH_MAX, "%s/%s", search_dir[i], cmd);
 		if (-1 != try_access(*found)) {
@@ -110,26 +128,33 @@ static errno_t find_command(char *cmd, char **found)
 	return EOK;
 }
 
-unsigned int try_exec(char *cmd, char **argv, iostate_t *io)
+/** Spawn a command without waiting for it to finish
+ *
+ * @param cmd	Name or path of the command
+ * @param argv	Arguments of the command
+ * @param io	Standard streams of the command
+ * @param twait	Place to store the wait structure for try_wait()
+ *
+ * @return	EOK on success or an error code, which has been reported
+ */
+errno_t try_spawn(char *cmd, char **argv, iostate_t *io, task_wait_t *twait)
 {
 	task_id_t tid;
-	task_wait_t twait;
-	task_exit_t texit;
 	char *tmp;
 	errno_t rc;
-	int retval, i;
+	int i;
 	int file_handles[3] = { -1, -1, -1 };
 	FILE *files[3];
 
 	rc = find_command(cmd, &tmp);
 	if (rc != EOK) {
 		cli_error(CL_ENOMEM, "%s: failure executing find_command()", progname);
-		return 1;
+		return rc;
 	}
 
 	if (tmp == NULL) {
 		cli_error(CL_EEXEC, "%s: Command not found '%s'", progname, cmd);
-		return 1;
+		return ENOENT;
 	}
 
 	files[0] = io->stdin;
@@ -140,17 +165,34 @@ unsigned int try_exec(char *cmd, char **argv, iostate_t *io)
 		vfs_fhandle(files[i], &file_handles[i]);
 	}
 
-	rc = task_spawnvf(&tid, &twait, tmp, (const char **) argv,
+	rc = task_spawnvf(&tid, twait, tmp, (const char **) argv,
 	    file_handles[0], file_handles[1], file_handles[2]);
 	free(tmp);
 
 	if (rc != EOK) {
 		cli_error(CL_EEXEC, "%s: Cannot spawn `%s' (%s)", progname, cmd,
 		    str_error(rc));
-		return 1;
+		/* The command may have been found in a stale listing. */
+		dircache_flush(NULL);
+		return rc;
 	}
 
-	rc = task_wait(&twait, &texit, &retval);
+	return EOK;
+}
+
+/** Wait for a command spawned by try_spawn() to finish
+ *
+ * @param twait	Wait structure filled in by try_spawn()
+ *
+ * @return	0 if the command succeeded, 1 otherwise
+ */
+unsigned int try_wait(task_wait_t *twait)
+{
+	task_exit_t texit;
+	errno_t rc;
+	int retval;
+
+	rc = task_wait(twait, &texit, &retval);
 	if (rc != EOK) {
 		printf("%s: Failed waiting for command (%s)\n", progname,
 		    str_error(rc));
@@ -166,3 +208,13 @@ unsigned int try_exec(char *cmd, char **argv, iostate_t *io)
 
 	return 0;
 }
+
+unsigned int try_exec(char *cmd, char **argv, iostate_t *io)
+{
+	task_wait_t twait;
+
+	if (try_spawn(cmd, argv, io, &twait) != EOK)
+		return 1;
+
+	return try_wait(&twait);
+}
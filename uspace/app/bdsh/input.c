@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
+#include <str_error.h>
 #include <io/console.h>
 #include <io/keycode.h>
 #include <io/style.h>
@@ -48,6 +49,7 @@
 
 #include "config.h"
 #include "compl.h"
+#include "dircache.h"
 #include "util.h"
 #include "scli.h"
 #include "input.h"
@@ -62,6 +64,7 @@ static tinput_t *tinput;
 
 /* Private helpers */
 static int run_command(char **, cliuser_t *, iostate_t *);
+static int run_pipeline(char **[], size_t, cliuser_t *, iostate_t *);
 static void print_pipe_usage(void);
 
 typedef struct {
@@ -97,11 +100,13 @@ static errno_t process_input_nohup(cliuser_t *usr, list_t *alias_hups, size_t co
 		return ENOMEM;
 	token_t *tokens = tokens_buf;
 
-	char *cmd[WORD_MAX];
+	char *cmd[WORD_MAX + 1];
+	char **stages[PIPELINE_MAX];
+	size_t stage_count;
 	errno_t rc = EOK;
 	tokenizer_t tok;
 	unsigned int i, pipe_count, processed_pipes;
-	unsigned int pipe_pos[2];
+	unsigned int pipe_pos[PIPELINE_MAX + 1];
 	char *redir_from = NULL;
 	char *redir_to = NULL;
 
@@ -131,16 +136,19 @@ static errno_t process_input_nohup(cliuser_t *usr, list_t *alias_hups, size_t co
 	}
 
 	/*
-	 * Until full support for pipes is implemented, allow for a simple case:
-	 * [from <file> |] command [| to <file>]
+	 * The command line is a pipeline of commands, optionally reading
+	 * from and writing to files:
+	 * [from <file> |] command [| command ...] [| to <file>]
 	 *
-	 * First find the pipes and check that there are no more
+	 * First find the pipes and check that there are not too many
 	 */
 	for (i = 0, pipe_count = 0; i < tokens_length; i++) {
 		if (tokens[i].type == TOKTYPE_PIPE) {
-			if (pipe_count >= 2) {
-				print_pipe_usage();
-				rc = ENOTSUP;
+			if (pipe_count >= PIPELINE_MAX + 1) {
+				cli_error(CL_EFAIL, "%s: at most %d commands "
+				    "can be joined in a pipeline", PACKAGE_NAME,
+				    PIPELINE_MAX);
+				rc = ELIMIT;
 				goto finit;
 			}
 			pipe_pos[pipe_count] = i;
@@ -161,37 +169,48 @@ static errno_t process_input_nohup(cliuser_t *usr, list_t *alias_hups, size_t co
 		processed_pipes++;
 	}
 
-	/* Check if the second part (| to <file>) is present */
+	/* Check if the last part (| to <file>) is present */
 	if ((pipe_count - processed_pipes) > 0 &&
-	    (pipe_pos[processed_pipes] == tokens_length - 4 ||
-	    (pipe_pos[processed_pipes] == tokens_length - 5 &&
+	    (pipe_pos[pipe_count - 1] == tokens_length - 4 ||
+	    (pipe_pos[pipe_count - 1] == tokens_length - 5 &&
 	    tokens[tokens_length - 4].type == TOKTYPE_SPACE)) &&
 	    str_cmp(tokens[tokens_length - 3].text, "to") == 0) {
 		/* Ignore the last three tokens (pipe, to, file) and set to */
 		redir_to = tokens[tokens_length - 1].text;
-		cmd_token_end = pipe_pos[processed_pipes];
-		processed_pipes++;
+		cmd_token_end = pipe_pos[pipe_count - 1];
+		pipe_count--;
 	}
 
-	if (processed_pipes != pipe_count) {
-		print_pipe_usage();
-		rc = ENOTSUP;
+	if (pipe_count - processed_pipes >= PIPELINE_MAX) {
+		cli_error(CL_EFAIL, "%s: at most %d commands can be joined "
+		    "in a pipeline", PACKAGE_NAME, PIPELINE_MAX);
+		rc = ELIMIT;
 		goto finit;
 	}
 
-	/* Convert tokens of the command to string array */
+	/*
+	 * Convert tokens of the commands to string arrays, each terminated
+	 * by NULL, the remaining pipes separate the commands
+	 */
 	unsigned int cmd_pos = 0;
+	stage_count = 0;
+	stages[stage_count++] = &cmd[0];
 	for (i = cmd_token_start; i < cmd_token_end; i++) {
-		if (tokens[i].type != TOKTYPE_SPACE) {
+		if (tokens[i].type == TOKTYPE_PIPE) {
+			cmd[cmd_pos++] = NULL;
+			stages[stage_count++] = &cmd[cmd_pos];
+		} else if (tokens[i].type != TOKTYPE_SPACE) {
 			cmd[cmd_pos++] = tokens[i].text;
 		}
 	}
 	cmd[cmd_pos++] = NULL;
 
-	if (cmd[0] == NULL) {
-		print_pipe_usage();
-		rc = ENOTSUP;
-		goto finit;
+	for (i = 0; i < stage_count; i++) {
+		if (stages[i][0] == NULL) {
+			print_pipe_usage();
+			rc = ENOTSUP;
+			goto finit;
+		}
 	}
 
 	/* test if the passed cmd is an alias */
@@ -273,7 +292,19 @@ static errno_t process_input_nohup(cliuser_t *usr, list_t *alias_hups, size_t co
 		new_iostate.stdout = to;
 	}
 
-	if (run_command(cmd, usr, &new_iostate) == 0) {
+	int retval;
+	if (stage_count == 1)
+		retval = run_command(cmd, usr, &new_iostate);
+	else
+		retval = run_pipeline(stages, stage_count, usr, &new_iostate);
+
+	/*
+	 * The commands might have changed any directory, only the listings
+	 * of the search directories are trusted until they expire.
+	 */
+	dircache_flush(search_dir);
+
+	if (retval == 0) {
 		rc = EOK;
 	} else {
 		rc = EINVAL;
@@ -316,7 +347,8 @@ errno_t process_input(cliuser_t *usr)
 void print_pipe_usage(void)
 {
 	printf("Invalid syntax!\n");
-	printf("Usage of redirection (pipes in the future):\n");
+	printf("Usage of pipes and redirection:\n");
+	printf("command ... | command ...\n");
 	printf("from filename | command ...\n");
 	printf("from filename | command ... | to filename\n");
 	printf("command ... | to filename\n");
@@ -346,6 +378,144 @@ int run_command(char **cmd, cliuser_t *usr, iostate_t *new_iostate)
 	return try_exec(cmd[0], cmd, new_iostate);
 }
 
+/** Run a pipeline of commands
+ *
+ * Consecutive commands are connected by pipes and all the external
+ * commands run concurrently. Built-in commands and modules run within the
+ * shell, so at most one of them can be part of a pipeline. It is run once
+ * all the external commands have been spawned.
+ *
+ * @param stages	Arguments of the commands
+ * @param count		Number of the commands, at least two
+ * @param usr		Shell user
+ * @param iostate	Standard input of the first and standard output of
+ *			the last command and standard error of all commands
+ *
+ * @return		0 if the last command succeeded, non-zero otherwise
+ */
+static int run_pipeline(char **stages[], size_t count, cliuser_t *usr,
+    iostate_t *iostate)
+{
+	FILE *pin[PIPELINE_MAX];
+	FILE *pout[PIPELINE_MAX];
+	task_wait_t twait[PIPELINE_MAX];
+	bool spawned[PIPELINE_MAX];
+	size_t internal = count;
+	size_t i;
+	int retval = 1;
+	errno_t rc;
+
+	assert(count >= 2 && count <= PIPELINE_MAX);
+
+	for (i = 0; i < count; i++) {
+		if (is_builtin(stages[i][0]) < 0 && is_module(stages[i][0]) < 0)
+			continue;
+
+		if (internal < count) {
+			cli_error(CL_EFAIL, "%s: at most one built-in command "
+			    "or module can be part of a pipeline",
+			    PACKAGE_NAME);
+			return CL_EFAIL;
+		}
+
+		internal = i;
+	}
+
+	/* pin[i] is read by command i + 1, pout[i] is written by command i */
+	for (i = 0; i + 1 < count; i++) {
+		pin[i] = NULL;
+		pout[i] = NULL;
+		spawned[i] = false;
+	}
+	spawned[count - 1] = false;
+
+	for (i = 0; i + 1 < count; i++) {
+		int rfd, wfd;
+
+		rc = vfs_pipe(&rfd, &wfd);
+		if (rc != EOK) {
+			cli_error(CL_EFAIL, "%s: cannot create pipe (%s)",
+			    PACKAGE_NAME, str_error(rc));
+			goto close;
+		}
+
+		pin[i] = fdopen(rfd, "r");
+		if (pin[i] == NULL) {
+			vfs_put(rfd);
+			vfs_put(wfd);
+			goto close;
+		}
+
+		pout[i] = fdopen(wfd, "w");
+		if (pout[i] == NULL) {
+			vfs_put(wfd);
+			goto close;
+		}
+	}
+
+	/* Spawn all external commands before any of them can fill a pipe */
+	for (i = 0; i < count; i++) {
+		iostate_t io = {
+			.stdin = (i == 0) ? iostate->stdin : pin[i - 1],
+			.stdout = (i + 1 == count) ? iostate->stdout : pout[i],
+			.stderr = iostate->stderr
+		};
+
+		if (i == internal)
+			continue;
+
+		if (try_spawn(stages[i][0], stages[i], &io, &twait[i]) != EOK)
+			goto close;
+
+		spawned[i] = true;
+	}
+
+	/*
+	 * The commands hold their own handles to the pipes, the shell must
+	 * close its ones so that the ends of file and broken pipes propagate.
+	 */
+	for (i = 0; i + 1 < count; i++) {
+		if (i + 1 != internal) {
+			fclose(pin[i]);
+			pin[i] = NULL;
+		}
+		if (i != internal) {
+			fclose(pout[i]);
+			pout[i] = NULL;
+		}
+	}
+
+	if (internal < count) {
+		iostate_t io = {
+			.stdin = (internal == 0) ?
+			    iostate->stdin : pin[internal - 1],
+			.stdout = (internal + 1 == count) ?
+			    iostate->stdout : pout[internal],
+			.stderr = iostate->stderr
+		};
+
+		retval = run_command(stages[internal], usr, &io);
+	}
+
+close:
+	for (i = 0; i + 1 < count; i++) {
+		if (pin[i] != NULL)
+			fclose(pin[i]);
+		if (pout[i] != NULL)
+			fclose(pout[i]);
+	}
+
+	for (i = 0; i < count; i++) {
+		if (spawned[i]) {
+			unsigned int rv = try_wait(&twait[i]);
+			if (i + 1 == count)
+				retval = rv;
+		}
+	}
+
+	return retval;
+}
+
 void get_input(cliuser_t *usr)
 {
 	char *str;
@@ -47,10 +47,12 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <deque>
 #include <exception>
+#include <execution>
 #include <fstream>
 #include <functional>
 #include <initializer_list>
@@ -121,6 +123,7 @@ int main()
     ts.add<std::test::functional_test>();
     ts.add<std::test::algorithm_test>();
     ts.add<std::test::future_test>();
+    ts.add<std::test::atomic_test>();
 
     return ts.run(true) ? 0 : 1;
 }
@@ -25,7 +25,6 @@
  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
-
 /** @addtogroup download
  * @{
  */
@@ -33,15 +32,23 @@
 /** @file
  * Download a file from a HTTP server
  *
+ * When writing to a file, the resource is fetched in pieces over several
+ * connections in parallel if the server supports range requests. Each
+ * connection writes its pieces right at their offsets in the file and is
+ * kept open for the next piece.
  */
 
 #include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
 #include <str_error.h>
 #include <task.h>
 #include <macros.h>
+#include <vfs/vfs.h>
 
 #include <http/http.h>
 #include <uri.h>
@@ -54,27 +61,338 @@
 #endif
 #define USER_AGENT "HelenOS-" NAME "/" VERSION
 
+/** Size of the pieces fetched by individual range requests */
+#define DOWNLOAD_PIECE (1024 * 1024)
+/** Default number of parallel connections */
+#define DOWNLOAD_CONNS 4
+/** Maximum number of parallel connections */
+#define DOWNLOAD_MAX_CONNS 16
+/** Size of the receive buffer of each connection */
+#define DOWNLOAD_BUF_SIZE (64 * 1024)
+
+/** Download in progress */
+typedef struct {
+	const char *host;
+	uint16_t port;
+	const char *path;
+	/** Output file or -1 for standard output */
+	int fd;
+	/** Size of the resource, if fetched in pieces */
+	uint64_t size;
+
+	/** Protects the fields below */
+	fibril_mutex_t lock;
+	/** Signalled when a connection fibril terminates */
+	fibril_condvar_t done_cv;
+	/** Offset of the first byte not assigned to a connection yet */
+	uint64_t next;
+	/** Number of running connection fibrils */
+	unsigned running;
+	/** First error encountered by any of the connections */
+	errno_t rc;
+} download_t;
+
 static void syntax_print(void)
 {
-	fprintf(stderr, "Usage: download [-o <outfile>] <url>\n");
+	fprintf(stderr, "Usage: download [-o <outfile> [-j <conns>]] <url>\n");
 	fprintf(stderr, "  Without -o, data will be written to stdout, so you may want\n");
 	fprintf(stderr, "  to redirect the output, e.g.\n");
 	fprintf(stderr, "\n");
 	fprintf(stderr, "    download http://helenos.org/ | to helenos.html\n\n");
+	fprintf(stderr, "  With -o, the file is fetched over up to <conns>\n");
+	fprintf(stderr, "  parallel connections (default %d) if the server\n",
+	    DOWNLOAD_CONNS);
+	fprintf(stderr, "  supports it.\n");
+}
+
+static void download_set_error(download_t *dl, errno_t rc)
+{
+	fibril_mutex_lock(&dl->lock);
+	if (dl->rc == EOK)
+		dl->rc = rc;
+	fibril_mutex_unlock(&dl->lock);
+}
+
+/** Send a request for the resource and receive the response headers.
+ *
+ * The connection is established first unless it is kept open from the
+ * previous request.
+ *
+ * @param dl     Download
+ * @param http   HTTP connection
+ * @param ranged Request only the range from @a first to @a last
+ * @param first  Offset of the first byte requested
+ * @param last   Offset of the last byte requested
+ * @param resp   Place to store the response
+ * @return EOK on success or an error code
+ */
+static errno_t download_request(download_t *dl, http_t *http, bool ranged,
+    uint64_t first, uint64_t last, http_response_t **resp)
+{
+	http_request_t *req = http_request_create("GET", dl->path);
+	if (req == NULL) {
+		fprintf(stderr, "Failed creating request\n");
+		return ENOMEM;
+	}
+
+	errno_t rc = http_headers_append(&req->headers, "Host", dl->host);
+	if (rc != EOK) {
+		fprintf(stderr, "Failed setting Host header: %s\n", str_error(rc));
+		goto out;
+	}
+
+	rc = http_headers_append(&req->headers, "User-Agent", USER_AGENT);
+	if (rc != EOK) {
+		fprintf(stderr, "Failed creating User-Agent header: %s\n", str_error(rc));
+		goto out;
+	}
+
+	if (ranged) {
+		rc = http_request_set_range(req, first, last);
+		if (rc != EOK) {
+			fprintf(stderr, "Failed setting Range header: %s\n",
+			    str_error(rc));
+			goto out;
+		}
+	}
+
+	if (http->conn == NULL) {
+		rc = http_connect(http);
+		if (rc != EOK) {
+			fprintf(stderr, "Failed connecting: %s\n",
+			    str_error(rc));
+			rc = EIO;
+			goto out;
+		}
+	}
+
+	rc = http_send_request(http, req);
+	if (rc != EOK) {
+		fprintf(stderr, "Failed sending request: %s\n", str_error(rc));
+		rc = EIO;
+		goto out;
+	}
+
+	rc = http_receive_response(&http->recv_buffer, resp, 16 * 1024, 100);
+	if (rc != EOK) {
+		fprintf(stderr, "Failed receiving response: %s\n",
+		    str_error(rc));
+		rc = EIO;
+		goto out;
+	}
+
+out:
+	http_request_destroy(req);
+	return rc;
+}
+
+/** Write received data to the output.
+ *
+ * @param dl   Download
+ * @param pos  Offset of the data in the resource
+ * @param buf  Data
+ * @param size Size of the data
+ * @return EOK on success or an error code
+ */
+static errno_t download_write(download_t *dl, uint64_t pos, const void *buf,
+    size_t size)
+{
+	if (dl->fd < 0) {
+		if (fwrite(buf, 1, size, stdout) != size)
+			return EIO;
+		return EOK;
+	}
+
+	aoff64_t off = pos;
+	size_t nwritten;
+	return vfs_write(dl->fd, &off, buf, size, &nwritten);
+}
+
+/** Receive a response body and write it to the output.
+ *
+ * The connection is closed unless it can carry another request.
+ *
+ * @param dl   Download
+ * @param http HTTP connection
+ * @param resp Response whose body is to be received
+ * @param pos  Offset of the body in the resource
+ * @param buf  Receive buffer of DOWNLOAD_BUF_SIZE bytes
+ * @return EOK on success or an error code
+ */
+static errno_t download_body(download_t *dl, http_t *http,
+    http_response_t *resp, uint64_t pos, void *buf)
+{
+	http_body_t body;
+	errno_t rc;
+
+	http_body_init(&body, http, resp);
+
+	while (true) {
+		size_t nread;
+		rc = http_body_read(&body, buf, DOWNLOAD_BUF_SIZE, &nread);
+		if (rc != EOK || nread == 0)
+			break;
+
+		rc = download_write(dl, pos, buf, nread);
+		if (rc != EOK)
+			break;
+
+		pos += nread;
+	}
+
+	if (rc != EOK || !http_body_reusable(&body))
+		(void) http_close(http);
+
+	return rc;
+}
+
+/** Fetch one piece of the resource.
+ *
+ * @param dl    Download
+ * @param http  HTTP connection
+ * @param first Offset of the first byte of the piece
+ * @param last  Offset of the last byte of the piece
+ * @param buf   Receive buffer of DOWNLOAD_BUF_SIZE bytes
+ * @return EOK on success or an error code
+ */
+static errno_t download_piece(download_t *dl, http_t *http, uint64_t first,
+    uint64_t last, void *buf)
+{
+	http_response_t *resp = NULL;
+	uint64_t rfirst, rlast, total;
+
+	errno_t rc = download_request(dl, http, true, first, last, &resp);
+	if (rc != EOK) {
+		(void) http_close(http);
+		return rc;
+	}
+
+	if (resp->status != 206 ||
+	    http_response_content_range(resp, &rfirst, &rlast, &total) != EOK ||
+	    rfirst != first || rlast != last) {
+		fprintf(stderr, "Server returned an unexpected range\n");
+		(void) http_close(http);
+		rc = EIO;
+	} else {
+		rc = download_body(dl, http, resp, first, buf);
+	}
+
+	http_response_destroy(resp);
+	return rc;
+}
+
+/** Fetch pieces of the resource until none is left.
+ *
+ * @param dl   Download
+ * @param http HTTP connection
+ * @param buf  Receive buffer of DOWNLOAD_BUF_SIZE bytes
+ */
+static void download_pieces(download_t *dl, http_t *http, void *buf)
+{
+	while (true) {
+		fibril_mutex_lock(&dl->lock);
+		if (dl->rc != EOK || dl->next >= dl->size) {
+			fibril_mutex_unlock(&dl->lock);
+			return;
+		}
+
+		uint64_t first = dl->next;
+		uint64_t last = min(first + DOWNLOAD_PIECE, dl->size) - 1;
+		dl->next = last + 1;
+		fibril_mutex_unlock(&dl->lock);
+
+		errno_t rc = download_piece(dl, http, first, last, buf);
+		if (rc != EOK) {
+			download_set_error(dl, rc);
+			return;
+		}
+	}
+}
+
+/** Fibril fetching pieces of the resource over a connection of its own. */
+static errno_t download_fibril(void *arg)
+{
+	download_t *dl = (download_t *) arg;
+
+	http_t *http = http_create(dl->host, dl->port);
+	void *buf = malloc(DOWNLOAD_BUF_SIZE);
+	if (http != NULL && buf != NULL)
+		download_pieces(dl, http, buf);
+	else
+		download_set_error(dl, ENOMEM);
+
+	free(buf);
+	if (http != NULL)
+		http_destroy(http);
+
+	fibril_mutex_lock(&dl->lock);
+	dl->running--;
+	fibril_condvar_broadcast(&dl->done_cv);
+	fibril_mutex_unlock(&dl->lock);
+	return EOK;
+}
+
+/** Fetch the rest of the resource in parallel.
+ *
+ * The first piece has already been requested over @a http.
+ *
+ * @param dl    Download
+ * @param http  HTTP connection
+ * @param resp  Response carrying the first piece
+ * @param conns Number of connections to use
+ * @param buf   Receive buffer of DOWNLOAD_BUF_SIZE bytes
+ * @return EOK on success or an error code
+ */
+static errno_t download_parallel(download_t *dl, http_t *http,
+    http_response_t *resp, unsigned conns, void *buf)
+{
+	uint64_t pieces = (dl->size - dl->next + DOWNLOAD_PIECE - 1) /
+	    DOWNLOAD_PIECE;
+
+	errno_t rc = vfs_resize(dl->fd, dl->size);
+	if (rc != EOK)
+		return rc;
+
+	for (unsigned i = 1; i < conns && i <= pieces; i++) {
+		fid_t fid = fibril_create(download_fibril, dl);
+		if (fid == 0)
+			break;
+
+		dl->running++;
+		fibril_add_ready(fid);
+	}
+
+	rc = download_body(dl, http, resp, 0, buf);
+	if (rc != EOK)
+		download_set_error(dl, rc);
+	else
+		download_pieces(dl, http, buf);
+
+	fibril_mutex_lock(&dl->lock);
+	while (dl->running > 0)
+		fibril_condvar_wait(&dl->done_cv, &dl->lock);
+	rc = dl->rc;
+	fibril_mutex_unlock(&dl->lock);
+
+	return rc;
 }
 
 int main(int argc, char *argv[])
 {
 	int i;
 	char *ofname = NULL;
-	FILE *ofile = NULL;
-	size_t buf_size = 4096;
+	uint32_t conns = DOWNLOAD_CONNS;
 	void *buf = NULL;
 	uri_t *uri = NULL;
 	http_t *http = NULL;
+	http_response_t *response = NULL;
+	char *server_path = NULL;
+	download_t dl;
 	errno_t rc;
 	int ret;
 
+	dl.fd = -1;
+
 	if (argc < 2) {
 		syntax_print();
 		rc = EINVAL;
@@ -83,21 +401,31 @@ int main(int argc, char *argv[])
 
 	i = 1;
 
-	if (str_cmp(argv[i], "-o") == 0) {
-		++i;
-		if (argc < i + 1) {
+	while (i < argc && argv[i][0] == '-') {
+		if (argc < i + 2) {
 			syntax_print();
 			rc = EINVAL;
 			goto error;
 		}
 
-		ofname = argv[i++];
-		ofile = fopen(ofname, "wb");
-		if (ofile == NULL) {
-			fprintf(stderr, "Error creating '%s'.\n", ofname);
+		if (str_cmp(argv[i], "-o") == 0) {
+			ofname = argv[i + 1];
+		} else if (str_cmp(argv[i], "-j") == 0) {
+			rc = str_uint32_t(argv[i + 1], NULL, 10, true, &conns);
+			if (rc != EOK || conns == 0 ||
+			    conns > DOWNLOAD_MAX_CONNS) {
+				fprintf(stderr, "Invalid number of "
+				    "connections: %s\n", argv[i + 1]);
+				rc = EINVAL;
+				goto error;
+			}
+		} else {
+			syntax_print();
 			rc = EINVAL;
 			goto error;
 		}
+
+		i += 2;
 	}
 
 	if (argc != i + 1) {
@@ -106,6 +434,24 @@ int main(int argc, char *argv[])
 		goto error;
 	}
 
+	if (ofname != NULL) {
+		rc = vfs_lookup_open(ofname, WALK_REGULAR | WALK_MAY_CREATE,
+		    MODE_WRITE, &dl.fd);
+		if (rc == EOK) {
+			rc = vfs_resize(dl.fd, 0);
+			if (rc != EOK) {
+				vfs_put(dl.fd);
+				dl.fd = -1;
+			}
+		}
+
+		if (rc != EOK) {
+			fprintf(stderr, "Error creating '%s'.\n", ofname);
+			rc = EINVAL;
+			goto error;
+		}
+	}
+
 	uri = uri_parse(argv[i]);
 	if (uri == NULL) {
 		fprintf(stderr, "Failed parsing URI\n");
@@ -146,7 +492,6 @@ int main(int argc, char *argv[])
 	const char *path = uri->path;
 	if (path == NULL || *path == 0)
 		path = "/";
-	char *server_path = NULL;
 	if (uri->query == NULL) {
 		server_path = str_dup(path);
 		if (server_path == NULL) {
@@ -163,25 +508,15 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	http_request_t *req = http_request_create("GET", server_path);
-	free(server_path);
-	if (req == NULL) {
-		fprintf(stderr, "Failed creating request\n");
-		rc = ENOMEM;
-		goto error;
-	}
-
-	rc = http_headers_append(&req->headers, "Host", uri->host);
-	if (rc != EOK) {
-		fprintf(stderr, "Failed setting Host header: %s\n", str_error(rc));
-		goto error;
-	}
-
-	rc = http_headers_append(&req->headers, "User-Agent", USER_AGENT);
-	if (rc != EOK) {
-		fprintf(stderr, "Failed creating User-Agent header: %s\n", str_error(rc));
-		goto error;
-	}
+	dl.host = uri->host;
+	dl.port = port;
+	dl.path = server_path;
+	dl.size = 0;
+	fibril_mutex_initialize(&dl.lock);
+	fibril_condvar_initialize(&dl.done_cv);
+	dl.next = 0;
+	dl.running = 0;
+	dl.rc = EOK;
 
 	http = http_create(uri->host, port);
 	if (http == NULL) {
@@ -190,67 +525,66 @@ int main(int argc, char *argv[])
 		goto error;
 	}
 
-	rc = http_connect(http);
-	if (rc != EOK) {
-		fprintf(stderr, "Failed connecting: %s\n", str_error(rc));
-		rc = EIO;
-		goto error;
-	}
-
-	rc = http_send_request(http, req);
-	if (rc != EOK) {
-		fprintf(stderr, "Failed sending request: %s\n", str_error(rc));
-		rc = EIO;
+	buf = malloc(DOWNLOAD_BUF_SIZE);
+	if (buf == NULL) {
+		fprintf(stderr, "Failed allocating buffer\n");
+		rc = ENOMEM;
 		goto error;
 	}
 
-	http_response_t *response = NULL;
-	rc = http_receive_response(&http->recv_buffer, &response, 16 * 1024,
-	    100);
-	if (rc != EOK) {
-		fprintf(stderr, "Failed receiving response: %s\n", str_error(rc));
-		rc = EIO;
+	/*
+	 * Ask for the first piece only when fetching in parallel. A server
+	 * which does not support ranges ignores the request and sends the
+	 * whole resource.
+	 */
+	bool ranged = (dl.fd >= 0 && conns > 1);
+	rc = download_request(&dl, http, ranged, 0, DOWNLOAD_PIECE - 1,
+	    &response);
+	if (rc != EOK)
 		goto error;
-	}
 
-	if (response->status != 200) {
+	uint64_t first, last, total;
+	if (ranged && response->status == 206 &&
+	    http_response_content_range(response, &first, &last,
+	    &total) == EOK && first == 0 && total != UINT64_MAX) {
+		dl.size = total;
+		dl.next = last + 1;
+		rc = download_parallel(&dl, http, response, conns, buf);
+	} else if (response->status == 200) {
+		rc = download_body(&dl, http, response, 0, buf);
+	} else {
 		fprintf(stderr, "Server returned status %d %s\n", response->status,
 		    response->message);
-	} else {
-		buf = malloc(buf_size);
-		if (buf == NULL) {
-			fprintf(stderr, "Failed allocating buffer\n)");
-			rc = ENOMEM;
-			goto error;
-		}
-
-		size_t body_size;
-		while ((rc = recv_buffer(&http->recv_buffer, buf, buf_size, &body_size)) == EOK && body_size > 0) {
-			fwrite(buf, 1, body_size, ofile != NULL ? ofile : stdout);
-		}
+		rc = EOK;
+	}
 
-		if (rc != EOK) {
-			fprintf(stderr, "Failed receiving body: %s", str_error(rc));
-		}
+	if (rc != EOK) {
+		fprintf(stderr, "Failed receiving body: %s\n", str_error(rc));
+		goto error;
 	}
 
+	http_response_destroy(response);
 	free(buf);
+	free(server_path);
 	http_destroy(http);
 	uri_destroy(uri);
-	if (ofile != NULL && fclose(ofile) != 0) {
+	if (dl.fd >= 0 && vfs_put(dl.fd) != EOK) {
 		printf("Error writing '%s'.\n", ofname);
 		return EIO;
 	}
 
 	return EOK;
 error:
+	if (response != NULL)
+		http_response_destroy(response);
 	free(buf);
+	free(server_path);
 	if (http != NULL)
 		http_destroy(http);
 	if (uri != NULL)
 		uri_destroy(uri);
-	if (ofile != NULL)
-		fclose(ofile);
+	if (dl.fd >= 0)
+		vfs_put(dl.fd);
 	return rc;
 }
 
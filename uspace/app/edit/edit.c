@@ -52,6 +52,7 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <str.h>
 #include <types/common.h>
 #include <ui/control.h>
 #include <ui/filedialog.h>
@@ -159,6 +160,7 @@ static pane_t pane;
 
 #define ROW_BUF_SIZE 4096
 #define BUF_SIZE 64
+#define INS_BUF_SIZE 4096
 #define TAB_WIDTH 8
 
 /** Maximum filename length that can be entered. */
@@ -948,22 +950,26 @@ static void file_save_as(void)
 /** Insert file at caret position.
  *
  * Reads in the contents of a file and inserts them at the current position
- * of the caret.
+ * of the caret. The text is inserted in blocks of up to INS_BUF_SIZE bytes.
  */
 static errno_t file_insert(char *fname)
 {
 	FILE *f;
 	char32_t c;
 	char buf[BUF_SIZE];
+	char ibuf[INS_BUF_SIZE + 1];
 	int bcnt;
 	int n_read;
 	size_t off;
+	size_t ipos;
+	spt_t pt;
 
 	f = fopen(fname, "rt");
 	if (f == NULL)
 		return EINVAL;
 
 	bcnt = 0;
+	ipos = 0;
 
 	while (true) {
 		if (bcnt < STR_BOUNDS(1)) {
@@ -979,9 +985,21 @@ static errno_t file_insert(char *fname)
 		bcnt -= off;
 		memmove(buf, buf + off, bcnt);
 
-		insert_char(c);
+		if (ipos + STR_BOUNDS(1) > INS_BUF_SIZE) {
+			ibuf[ipos] = '\0';
+			tag_get_pt(&pane.caret_pos, &pt);
+			(void) sheet_insert(doc.sh, &pt, dir_before, ibuf);
+			ipos = 0;
+		}
+
+		(void) chr_encode(c, ibuf, &ipos, INS_BUF_SIZE);
 	}
 
+	ibuf[ipos] = '\0';
+	tag_get_pt(&pane.caret_pos, &pt);
+	(void) sheet_insert(doc.sh, &pt, dir_before, ibuf);
+	pane.rflags |= REDRAW_TEXT;
+
 	fclose(f);
 
 	return EOK;
@@ -1760,57 +1778,6 @@ static void caret_go_to_line_ask(void)
 	ui_prompt_dialog_set_cb(dialog, &go_to_line_dialog_cb, &edit);
 }
 
-/* Search operations */
-static errno_t search_spt_producer(void *data, char32_t *ret)
-{
-	assert(data != NULL);
-	assert(ret != NULL);
-	spt_t *spt = data;
-	*ret = spt_next_char(*spt, spt);
-	return EOK;
-}
-
-static errno_t search_spt_reverse_producer(void *data, char32_t *ret)
-{
-	assert(data != NULL);
-	assert(ret != NULL);
-	spt_t *spt = data;
-	*ret = spt_prev_char(*spt, spt);
-	return EOK;
-}
-
-static errno_t search_spt_mark(void *data, void **mark)
-{
-	assert(data != NULL);
-	assert(mark != NULL);
-	spt_t *spt = data;
-	spt_t *new = calloc(1, sizeof(spt_t));
-	*mark = new;
-	if (new == NULL)
-		return ENOMEM;
-	*new = *spt;
-	return EOK;
-}
-
-static void search_spt_mark_free(void *data)
-{
-	free(data);
-}
-
-static search_ops_t search_spt_ops = {
-	.equals = char_exact_equals,
-	.producer = search_spt_producer,
-	.mark = search_spt_mark,
-	.mark_free = search_spt_mark_free,
-};
-
-static search_ops_t search_spt_reverse_ops = {
-	.equals = char_exact_equals,
-	.producer = search_spt_reverse_producer,
-	.mark = search_spt_mark,
-	.mark_free = search_spt_mark_free,
-};
-
 /** Ask for line and go to it. */
 static void search_prompt(bool reverse)
 {
@@ -1850,7 +1817,7 @@ static void search(char *pattern, bool reverse)
 {
 	status_display("Searching...");
 
-	spt_t sp, producer_pos;
+	spt_t sp;
 	tag_get_pt(&pane.caret_pos, &sp);
 
 	/* Start searching on the position before/after caret */
@@ -1859,42 +1826,28 @@ static void search(char *pattern, bool reverse)
 	} else {
 		spt_prev_char(sp, &sp);
 	}
-	producer_pos = sp;
 
-	search_ops_t ops = search_spt_ops;
-	if (reverse)
-		ops = search_spt_reverse_ops;
-
-	search_t *search = search_init(pattern, &producer_pos, ops, reverse);
+	search_t *search = search_init(pattern, reverse);
 	if (search == NULL) {
 		status_display("Failed initializing search.");
 		return;
 	}
 
 	match_t match;
-	errno_t rc = search_next_match(search, &match);
-	if (rc != EOK) {
-		status_display("Failed searching.");
-		search_fini(search);
-	}
-
-	if (match.end) {
+	errno_t rc = search_next_match(search, doc.sh, &sp, &match);
+	if (rc == EOK) {
 		status_display("Match found.");
-		assert(match.end != NULL);
-		spt_t *end = match.end;
-		caret_move(*end, false, true);
-		while (match.length > 0) {
-			match.length--;
-			if (reverse) {
-				spt_next_char(*end, end);
-			} else {
-				spt_prev_char(*end, end);
-			}
+		if (reverse) {
+			caret_move(match.start, false, true);
+			caret_move(match.end, true, true);
+		} else {
+			caret_move(match.end, false, true);
+			caret_move(match.start, true, true);
 		}
-		caret_move(*end, true, true);
-		free(end);
-	} else {
+	} else if (rc == ENOENT) {
 		status_display("Not found.");
+	} else {
+		status_display("Failed searching.");
 	}
 
 	search_fini(search);
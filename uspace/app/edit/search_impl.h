@@ -36,18 +36,20 @@
 #ifndef SEARCH_IMPL_H__
 #define SEARCH_IMPL_H__
 
+#include <str_search.h>
+
 #include "search.h"
 
 /** Search state */
 struct search {
 	/* Note: This structure is opaque for the user. */
 
-	char32_t *pattern;
-	size_t pattern_length;
-	ssize_t *back_table;
-	size_t pattern_pos;
-	void *client_data;
-	search_ops_t ops;
+	/** Pattern, referenced by @c ss */
+	char *pattern;
+	/** Prepared substring search */
+	str_search_t ss;
+	/** Search backwards */
+	bool reverse;
 };
 
 #endif
@@ -31,7 +31,7 @@
  */
 /**
  * @file
- * @brief Prototype implementation of Sheet data structure.
+ * @brief Sheet data structure.
  *
  * The sheet is an abstract data structure representing a piece of text.
  * On top of this data structure we can implement a text editor. It is
@@ -43,17 +43,22 @@
  * versa. The text that is inserted or deleted can contain tabs and newlines
  * which are interpreted and properly acted upon.
  *
- * This is a trivial implementation with poor efficiency with O(N+n)
- * insertion and deletion and O(N) mapping (in both directions), where
- * N is the size of the file and n is the size of the inserted/deleted text.
+ * The text is kept in pieces of at most PIECE_MAX bytes, which are the nodes
+ * of a balanced tree. Every node knows the size of the text and the number
+ * of newlines in its subtree, which serves as the line index. Insertion and
+ * deletion of n bytes take O(n + log N) time, where N is the size of the
+ * file. Mapping between coordinates and positions takes O(log N + w) time,
+ * where w is the width of the row.
  */
 
+#include <assert.h>
 #include <stdlib.h>
 #include <str.h>
 #include <errno.h>
 #include <adt/list.h>
 #include <align.h>
 #include <macros.h>
+#include <mem.h>
 
 #include "sheet.h"
 #include "sheet_impl.h"
@@ -61,10 +66,440 @@
 enum {
 	TAB_WIDTH	= 8,
 
-	/** Initial  of dat buffer in bytes */
-	INITIAL_SIZE	= 32
+	/** Maximum size of a piece in bytes */
+	PIECE_MAX	= 4096,
+	/** Size up to which new pieces are filled, leaving room for typing */
+	PIECE_FILL	= 3072,
+
+	/** Number of bytes searched at a time */
+	SEARCH_WINDOW	= 16384
 };
 
+/** New pieces being filled with text, linked through their right pointers */
+typedef struct {
+	sheet_piece_t *first;
+	sheet_piece_t *last;
+} piece_list_t;
+
+/** Cursor for decoding the text of a sheet sequentially */
+typedef struct {
+	sheet_t *sh;
+	/** Piece containing the current offset, NULL if the sheet is empty */
+	sheet_piece_t *piece;
+	/** Offset of the piece */
+	size_t start;
+	/** Current offset */
+	size_t off;
+} sheet_cursor_t;
+
+static int piece_height(sheet_piece_t *p)
+{
+	return (p != NULL) ? p->height : 0;
+}
+
+static size_t piece_count(sheet_piece_t *p)
+{
+	return (p != NULL) ? p->sub_count : 0;
+}
+
+static size_t piece_size(sheet_piece_t *p)
+{
+	return (p != NULL) ? p->sub_size : 0;
+}
+
+static size_t piece_nl(sheet_piece_t *p)
+{
+	return (p != NULL) ? p->sub_nl : 0;
+}
+
+/** Count newlines in a buffer. */
+static size_t count_nl(const char *text, size_t size)
+{
+	size_t nl = 0;
+
+	for (size_t i = 0; i < size; i++) {
+		if (text[i] == '\n')
+			nl++;
+	}
+
+	return nl;
+}
+
+/** Recompute the totals of a node from its children. */
+static void piece_update(sheet_piece_t *p)
+{
+	p->height = 1 + max(piece_height(p->left), piece_height(p->right));
+	p->sub_count = 1 + piece_count(p->left) + piece_count(p->right);
+	p->sub_size = p->size + piece_size(p->left) + piece_size(p->right);
+	p->sub_nl = p->nl + piece_nl(p->left) + piece_nl(p->right);
+}
+
+static sheet_piece_t *piece_rotate_right(sheet_piece_t *p)
+{
+	sheet_piece_t *l = p->left;
+
+	p->left = l->right;
+	l->right = p;
+	piece_update(p);
+	piece_update(l);
+	return l;
+}
+
+static sheet_piece_t *piece_rotate_left(sheet_piece_t *p)
+{
+	sheet_piece_t *r = p->right;
+
+	p->right = r->left;
+	r->left = p;
+	piece_update(p);
+	piece_update(r);
+	return r;
+}
+
+/** Update a node and restore the AVL property at it. */
+static sheet_piece_t *piece_balance(sheet_piece_t *p)
+{
+	piece_update(p);
+
+	int bal = piece_height(p->left) - piece_height(p->right);
+	if (bal > 1) {
+		if (piece_height(p->left->left) < piece_height(p->left->right))
+			p->left = piece_rotate_left(p->left);
+		return piece_rotate_right(p);
+	}
+
+	if (bal < -1) {
+		if (piece_height(p->right->right) <
+		    piece_height(p->right->left))
+			p->right = piece_rotate_right(p->right);
+		return piece_rotate_left(p);
+	}
+
+	return p;
+}
+
+/** Insert a piece into a subtree so that it becomes its idx-th piece. */
+static sheet_piece_t *piece_insert(sheet_piece_t *p, size_t idx,
+    sheet_piece_t *np)
+{
+	if (p == NULL) {
+		np->left = NULL;
+		np->right = NULL;
+		piece_update(np);
+		return np;
+	}
+
+	size_t lc = piece_count(p->left);
+	if (idx <= lc)
+		p->left = piece_insert(p->left, idx, np);
+	else
+		p->right = piece_insert(p->right, idx - lc - 1, np);
+
+	return piece_balance(p);
+}
+
+/** Remove the first piece of a non-empty subtree. */
+static sheet_piece_t *piece_remove_first(sheet_piece_t *p,
+    sheet_piece_t **first)
+{
+	if (p->left == NULL) {
+		*first = p;
+		return p->right;
+	}
+
+	p->left = piece_remove_first(p->left, first);
+	return piece_balance(p);
+}
+
+/** Remove the idx-th piece of a subtree. */
+static sheet_piece_t *piece_remove(sheet_piece_t *p, size_t idx,
+    sheet_piece_t **removed)
+{
+	size_t lc = piece_count(p->left);
+
+	if (idx < lc) {
+		p->left = piece_remove(p->left, idx, removed);
+	} else if (idx > lc) {
+		p->right = piece_remove(p->right, idx - lc - 1, removed);
+	} else {
+		*removed = p;
+		if (p->left == NULL)
+			return p->right;
+		if (p->right == NULL)
+			return p->left;
+
+		sheet_piece_t *first;
+		sheet_piece_t *right = piece_remove_first(p->right, &first);
+		first->left = p->left;
+		first->right = right;
+		p = first;
+	}
+
+	return piece_balance(p);
+}
+
+/** Recompute the totals on the path to the idx-th piece of a subtree. */
+static void piece_refresh(sheet_piece_t *p, size_t idx)
+{
+	size_t lc = piece_count(p->left);
+
+	if (idx < lc)
+		piece_refresh(p->left, idx);
+	else if (idx > lc)
+		piece_refresh(p->right, idx - lc - 1);
+
+	piece_update(p);
+}
+
+static void piece_free(sheet_piece_t *p)
+{
+	free(p->text);
+	free(p);
+}
+
+/** Append text to a list of new pieces.
+ *
+ * The text is split into pieces of up to PIECE_FILL bytes, never inside
+ * a character.
+ */
+static errno_t piece_list_append(piece_list_t *pl, const char *src, size_t n)
+{
+	while (n > 0) {
+		sheet_piece_t *p = pl->last;
+		size_t chunk = (p != NULL) ? min(n, PIECE_FILL - p->size) : 0;
+
+		/* Do not split a character. */
+		while (chunk > 0 && chunk < n && (src[chunk] & 0xc0) == 0x80)
+			--chunk;
+
+		if (chunk == 0) {
+			p = calloc(1, sizeof(sheet_piece_t));
+			if (p == NULL)
+				return ENOMEM;
+
+			p->text = malloc(PIECE_MAX);
+			if (p->text == NULL) {
+				free(p);
+				return ENOMEM;
+			}
+
+			if (pl->last != NULL)
+				pl->last->right = p;
+			else
+				pl->first = p;
+			pl->last = p;
+			continue;
+		}
+
+		memcpy(p->text + p->size, src, chunk);
+		p->size += chunk;
+		p->nl += count_nl(src, chunk);
+		src += chunk;
+		n -= chunk;
+	}
+
+	return EOK;
+}
+
+static void piece_list_free(piece_list_t *pl)
+{
+	while (pl->first != NULL) {
+		sheet_piece_t *p = pl->first;
+		pl->first = p->right;
+		piece_free(p);
+	}
+
+	pl->last = NULL;
+}
+
+/** Find the piece containing a byte offset.
+ *
+ * An offset on the boundary of two pieces belongs to the latter one, the
+ * end of the text belongs to the last piece.
+ *
+ * @param sh	Sheet.
+ * @param off	Byte offset, at most the size of the text.
+ * @param start	Place to store the offset of the piece.
+ * @param idx	Place to store the index of the piece or NULL.
+ * @param nl	Place to store the number of newlines before the piece
+ *		or NULL.
+ *
+ * @return	The piece or NULL if the sheet is empty.
+ */
+static sheet_piece_t *sheet_find(sheet_t *sh, size_t off, size_t *start,
+    size_t *idx, size_t *nl)
+{
+	sheet_piece_t *p = sh->root;
+	size_t base = 0;
+	size_t bidx = 0;
+	size_t bnl = 0;
+
+	while (p != NULL) {
+		size_t ls = piece_size(p->left);
+		if (off < ls) {
+			p = p->left;
+			continue;
+		}
+
+		off -= ls;
+		base += ls;
+		bidx += piece_count(p->left);
+		bnl += piece_nl(p->left);
+
+		if (off < p->size || p->right == NULL)
+			break;
+
+		off -= p->size;
+		base += p->size;
+		bidx += 1;
+		bnl += p->nl;
+		p = p->right;
+	}
+
+	*start = base;
+	if (idx != NULL)
+		*idx = bidx;
+	if (nl != NULL)
+		*nl = bnl;
+	return p;
+}
+
+/** Get the idx-th piece of a sheet. */
+static sheet_piece_t *sheet_piece_at(sheet_t *sh, size_t idx)
+{
+	sheet_piece_t *p = sh->root;
+
+	while (p != NULL) {
+		size_t lc = piece_count(p->left);
+		if (idx == lc)
+			break;
+
+		if (idx < lc) {
+			p = p->left;
+		} else {
+			idx -= lc + 1;
+			p = p->right;
+		}
+	}
+
+	return p;
+}
+
+/** Get the number of newlines before a byte offset. */
+static size_t sheet_nl_before(sheet_t *sh, size_t off)
+{
+	size_t start, nl;
+	sheet_piece_t *p = sheet_find(sh, off, &start, NULL, &nl);
+
+	if (p == NULL)
+		return 0;
+
+	return nl + count_nl(p->text, off - start);
+}
+
+/** Get the byte offset following the k-th newline (counting from one). */
+static size_t sheet_nl_end(sheet_t *sh, size_t k)
+{
+	sheet_piece_t *p = sh->root;
+	size_t base = 0;
+
+	assert(k >= 1 && k <= piece_nl(sh->root));
+
+	while (true) {
+		size_t ln = piece_nl(p->left);
+		if (k <= ln) {
+			p = p->left;
+			continue;
+		}
+
+		k -= ln;
+		base += piece_size(p->left);
+
+		if (k <= p->nl)
+			break;
+
+		k -= p->nl;
+		base += p->size;
+		p = p->right;
+	}
+
+	size_t i = 0;
+	while (true) {
+		if (p->text[i] == '\n' && --k == 0)
+			break;
+		++i;
+	}
+
+	return base + i + 1;
+}
+
+/** Merge the idx-th piece with the following one if they are small. */
+static void sheet_merge_pair(sheet_t *sh, size_t idx)
+{
+	sheet_piece_t *a = sheet_piece_at(sh, idx);
+	sheet_piece_t *b = sheet_piece_at(sh, idx + 1);
+	sheet_piece_t *removed;
+
+	if (a == NULL || b == NULL || a->size + b->size > PIECE_FILL)
+		return;
+
+	memcpy(a->text + a->size, b->text, b->size);
+	a->size += b->size;
+	a->nl += b->nl;
+
+	sh->root = piece_remove(sh->root, idx + 1, &removed);
+	piece_free(removed);
+	piece_refresh(sh->root, idx);
+}
+
+/** Copy bytes out of a sheet. */
+static void sheet_read(sheet_t *sh, size_t off, size_t size, char *buf)
+{
+	sheet_piece_t *p;
+	size_t start, o, n;
+
+	while (size > 0) {
+		p = sheet_find(sh, off, &start, NULL, NULL);
+		o = off - start;
+		n = min(size, p->size - o);
+
+		memcpy(buf, p->text + o, n);
+		buf += n;
+		off += n;
+		size -= n;
+	}
+}
+
+static void sheet_cursor_init(sheet_cursor_t *cur, sheet_t *sh, size_t off)
+{
+	cur->sh = sh;
+	cur->off = off;
+	cur->piece = sheet_find(sh, off, &cur->start, NULL, NULL);
+}
+
+/** Decode the character at a cursor and advance past it.
+ *
+ * @return	The character or zero at the end of the text.
+ */
+static char32_t sheet_cursor_next(sheet_cursor_t *cur)
+{
+	size_t o;
+	char32_t c;
+
+	if (cur->off >= cur->sh->text_size)
+		return '\0';
+
+	if (cur->off - cur->start >= cur->piece->size) {
+		cur->piece = sheet_find(cur->sh, cur->off, &cur->start, NULL,
+		    NULL);
+	}
+
+	o = cur->off - cur->start;
+	c = str_decode(cur->piece->text, &o, cur->piece->size);
+	cur->off = cur->start + o;
+	return c;
+}
+
 /** Initialize an empty sheet. */
 errno_t sheet_create(sheet_t **rsh)
 {
@@ -74,14 +509,8 @@ errno_t sheet_create(sheet_t **rsh)
 	if (sh == NULL)
 		return ENOMEM;
 
-	sh->dbuf_size = INITIAL_SIZE;
 	sh->text_size = 0;
-
-	sh->data = malloc(sh->dbuf_size);
-	if (sh->data == NULL) {
-		free(sh);
-		return ENOMEM;
-	}
+	sh->root = NULL;
 
 	list_initialize(&sh->tags);
 
@@ -104,26 +533,53 @@ errno_t sheet_create(sheet_t **rsh)
  */
 errno_t sheet_insert(sheet_t *sh, spt_t *pos, enum dir_spec dir, char *str)
 {
-	char *ipp;
+	sheet_piece_t *p;
+	sheet_piece_t *removed;
+	size_t start, idx, o;
 	size_t sz;
-	char *newp;
+	errno_t rc;
 
 	sz = str_size(str);
-	if (sh->text_size + sz > sh->dbuf_size) {
-		/* Enlarge data buffer. */
-		newp = realloc(sh->data, sh->dbuf_size * 2);
-		if (newp == NULL)
-			return ELIMIT;
-
-		sh->data = newp;
-		sh->dbuf_size = sh->dbuf_size * 2;
-	}
+	p = sheet_find(sh, pos->b_off, &start, &idx, NULL);
+	o = pos->b_off - start;
+
+	if (p != NULL && p->size + sz <= PIECE_MAX) {
+		/* The text fits into the piece. */
+		memmove(p->text + o + sz, p->text + o, p->size - o);
+		memcpy(p->text + o, str, sz);
+		p->size += sz;
+		p->nl += count_nl(str, sz);
+		piece_refresh(sh->root, idx);
+	} else {
+		/* Replace the piece with new ones. */
+		piece_list_t pl = { NULL, NULL };
+
+		rc = EOK;
+		if (p != NULL)
+			rc = piece_list_append(&pl, p->text, o);
+		if (rc == EOK)
+			rc = piece_list_append(&pl, str, sz);
+		if (rc == EOK && p != NULL)
+			rc = piece_list_append(&pl, p->text + o, p->size - o);
+		if (rc != EOK) {
+			piece_list_free(&pl);
+			return ENOMEM;
+		}
 
-	ipp = sh->data + pos->b_off;
+		if (p != NULL) {
+			sh->root = piece_remove(sh->root, idx, &removed);
+			piece_free(removed);
+		} else {
+			idx = 0;
+		}
+
+		while (pl.first != NULL) {
+			p = pl.first;
+			pl.first = p->right;
+			sh->root = piece_insert(sh->root, idx++, p);
+		}
+	}
 
-	/* Copy data. */
-	memmove(ipp + sz, ipp, sh->text_size - pos->b_off);
-	memcpy(ipp, str, sz);
 	sh->text_size += sz;
 
 	/* Adjust tags. */
@@ -150,17 +606,42 @@ errno_t sheet_insert(sheet_t *sh, spt_t *pos, enum dir_spec dir, char *str)
  */
 errno_t sheet_delete(sheet_t *sh, spt_t *spos, spt_t *epos)
 {
-	char *spp;
-	size_t sz;
-	char *newp;
-	size_t shrink_size;
+	sheet_piece_t *p;
+	sheet_piece_t *removed;
+	size_t start, idx, o;
+	size_t sz, left, n;
 
-	spp = sh->data + spos->b_off;
 	sz = epos->b_off - spos->b_off;
 
-	memmove(spp, spp + sz, sh->text_size - (spos->b_off + sz));
+	left = sz;
+	while (left > 0) {
+		p = sheet_find(sh, spos->b_off, &start, &idx, NULL);
+		o = spos->b_off - start;
+		n = min(left, p->size - o);
+
+		if (n == p->size) {
+			sh->root = piece_remove(sh->root, idx, &removed);
+			piece_free(removed);
+		} else {
+			p->nl -= count_nl(p->text + o, n);
+			memmove(p->text + o, p->text + o + n, p->size - o - n);
+			p->size -= n;
+			piece_refresh(sh->root, idx);
+		}
+
+		left -= n;
+	}
+
 	sh->text_size -= sz;
 
+	/* Do not let repeated deletions fragment the text. */
+	p = sheet_find(sh, spos->b_off, &start, &idx, NULL);
+	if (p != NULL) {
+		sheet_merge_pair(sh, idx);
+		if (idx > 0)
+			sheet_merge_pair(sh, idx - 1);
+	}
+
 	/* Adjust tags. */
 	list_foreach(sh->tags, link, tag_t, tag) {
 		if (tag->b_off >= epos->b_off)
@@ -169,20 +650,6 @@ errno_t sheet_delete(sheet_t *sh, spt_t *spos, spt_t *epos)
 			tag->b_off = spos->b_off;
 	}
 
-	/* See if we should free up some memory. */
-	shrink_size = max(sh->dbuf_size / 4, INITIAL_SIZE);
-	if (sh->text_size <= shrink_size && sh->dbuf_size > INITIAL_SIZE) {
-		/* Shrink data buffer. */
-		newp = realloc(sh->data, shrink_size);
-		if (newp == NULL) {
-			/* Failed to shrink buffer... no matter. */
-			return EOK;
-		}
-
-		sh->data = newp;
-		sh->dbuf_size = shrink_size;
-	}
-
 	return EOK;
 }
 
@@ -190,30 +657,113 @@ errno_t sheet_delete(sheet_t *sh, spt_t *spos, spt_t *epos)
 void sheet_copy_out(sheet_t *sh, spt_t const *spos, spt_t const *epos,
     char *buf, size_t bufsize, spt_t *fpos)
 {
-	char *spp;
-	size_t range_sz;
-	size_t copy_sz;
-	size_t off, prev;
-	char32_t c;
+	sheet_piece_t *p;
+	size_t start, o, n;
+	size_t off, bpos;
+
+	off = spos->b_off;
+	bpos = 0;
+
+	while (off < epos->b_off && bpos < bufsize - 1) {
+		p = sheet_find(sh, off, &start, NULL, NULL);
+		o = off - start;
+		n = min(epos->b_off - off, p->size - o);
+
+		if (n > bufsize - 1 - bpos) {
+			/* Crop down to the last full character. */
+			n = bufsize - 1 - bpos;
+			while (n > 0 && (p->text[o + n] & 0xc0) == 0x80)
+				--n;
+
+			memcpy(buf + bpos, p->text + o, n);
+			bpos += n;
+			off += n;
+			break;
+		}
+
+		memcpy(buf + bpos, p->text + o, n);
+		bpos += n;
+		off += n;
+	}
+
+	buf[bpos] = '\0';
+
+	fpos->b_off = off;
+	fpos->sh = sh;
+}
+
+/** Search for a pattern in a sheet.
+ *
+ * The text is searched in windows of SEARCH_WINDOW bytes, which overlap
+ * by one byte less than the size of the pattern so that matches crossing
+ * their boundaries are not missed.
+ *
+ * @param sh		Sheet to search.
+ * @param ss		Prepared search.
+ * @param pos		Where to start. A forward search finds the first
+ *			match starting at or after @a pos, a reverse search
+ *			the last match ending at or before @a pos.
+ * @param reverse	Search backwards.
+ * @param mstart	Place to store the start of the match.
+ * @param mend		Place to store the end of the match.
+ *
+ * @return		EOK on success, ENOENT if there is no match or
+ *			ENOMEM if out of memory.
+ */
+errno_t sheet_search(sheet_t *sh, const str_search_t *ss, spt_t const *pos,
+    bool reverse, spt_t *mstart, spt_t *mend)
+{
+	const char *match;
+	size_t m, start, end, len;
+	char *buf;
 
-	spp = sh->data + spos->b_off;
-	range_sz = epos->b_off - spos->b_off;
-	copy_sz = (range_sz < bufsize - 1) ? range_sz : bufsize - 1;
+	m = ss->size;
+	if (m == 0 || m > sh->text_size)
+		return ENOENT;
 
-	prev = off = 0;
-	do {
-		prev = off;
-		c = str_decode(spp, &off, copy_sz);
-	} while (c != '\0');
+	buf = malloc(SEARCH_WINDOW + m - 1);
+	if (buf == NULL)
+		return ENOMEM;
 
-	/* Crop copy_sz down to the last full character. */
-	copy_sz = prev;
+	match = NULL;
+	start = end = pos->b_off;
+	if (!reverse) {
+		while (start + m <= sh->text_size) {
+			len = min(sh->text_size - start, SEARCH_WINDOW + m - 1);
+			sheet_read(sh, start, len, buf);
 
-	memcpy(buf, spp, copy_sz);
-	buf[copy_sz] = '\0';
+			match = str_search_first(ss, buf, len);
+			if (match != NULL || start + len == sh->text_size)
+				break;
 
-	fpos->b_off = spos->b_off + copy_sz;
-	fpos->sh = sh;
+			start += len - (m - 1);
+		}
+	} else {
+		while (end >= m) {
+			len = min(end, SEARCH_WINDOW + m - 1);
+			start = end - len;
+			sheet_read(sh, start, len, buf);
+
+			match = str_search_last(ss, buf, len);
+			if (match != NULL || start == 0)
+				break;
+
+			end = start + m - 1;
+		}
+	}
+
+	if (match == NULL) {
+		free(buf);
+		return ENOENT;
+	}
+
+	mstart->sh = sh;
+	mstart->b_off = start + (match - buf);
+	mend->sh = sh;
+	mend->b_off = mstart->b_off + m;
+
+	free(buf);
+	return EOK;
 }
 
 /** Get point preceding or following character cell. */
@@ -221,11 +771,28 @@ void sheet_get_cell_pt(sheet_t *sh, coord_t const *coord, enum dir_spec dir,
     spt_t *pt)
 {
 	size_t cur_pos, prev_pos;
+	sheet_cursor_t cur;
 	char32_t c;
 	coord_t cc;
+	int rows;
+
+	/*
+	 * Skip the rows before the requested one using the line index and
+	 * carry on as if the newline ending the previous row had just been
+	 * decoded.
+	 */
+	sheet_get_num_rows(sh, &rows);
+	cc.row = min(max(coord->row, 1), rows);
+	cc.column = 1;
+	if (cc.row > 1) {
+		cur_pos = sheet_nl_end(sh, cc.row - 1);
+		prev_pos = cur_pos - 1;
+	} else {
+		cur_pos = prev_pos = 0;
+	}
+
+	sheet_cursor_init(&cur, sh, cur_pos);
 
-	cc.row = cc.column = 1;
-	cur_pos = prev_pos = 0;
 	while (true) {
 		if (prev_pos >= sh->text_size) {
 			/* Cannot advance any further. */
@@ -240,7 +807,8 @@ void sheet_get_cell_pt(sheet_t *sh, coord_t const *coord, enum dir_spec dir,
 
 		prev_pos = cur_pos;
 
-		c = str_decode(sh->data, &cur_pos, sh->text_size);
+		c = sheet_cursor_next(&cur);
+		cur_pos = cur.off;
 		if (c == '\n') {
 			++cc.row;
 			cc.column = 1;
@@ -273,32 +841,28 @@ void sheet_get_row_width(sheet_t *sh, int row, int *length)
 /** Get the number of rows in a sheet. */
 void sheet_get_num_rows(sheet_t *sh, int *rows)
 {
-	int cnt;
-	size_t bo;
-
-	cnt = 1;
-	for (bo = 0; bo < sh->dbuf_size; ++bo) {
-		if (sh->data[bo] == '\n')
-			cnt += 1;
-	}
-
-	*rows = cnt;
+	*rows = 1 + piece_nl(sh->root);
 }
 
 /** Get the coordinates of an s-point. */
 void spt_get_coord(spt_t const *pos, coord_t *coord)
 {
-	size_t off;
+	sheet_cursor_t cur;
+	size_t nl;
 	coord_t cc;
 	char32_t c;
 	sheet_t *sh;
 
 	sh = pos->sh;
-	cc.row = cc.column = 1;
 
-	off = 0;
-	while (off < pos->b_off && off < sh->text_size) {
-		c = str_decode(sh->data, &off, sh->text_size);
+	/* Start at the beginning of the row, found in the line index. */
+	nl = sheet_nl_before(sh, min(pos->b_off, sh->text_size));
+	cc.row = 1 + nl;
+	cc.column = 1;
+
+	sheet_cursor_init(&cur, sh, (nl > 0) ? sheet_nl_end(sh, nl) : 0);
+	while (cur.off < pos->b_off && cur.off < sh->text_size) {
+		c = sheet_cursor_next(&cur);
 		if (c == '\n') {
 			++cc.row;
 			cc.column = 1;
@@ -321,7 +885,12 @@ bool spt_equal(spt_t const *a, spt_t const *b)
 /** Get a character at spt and return next spt */
 char32_t spt_next_char(spt_t spt, spt_t *next)
 {
-	char32_t ch = str_decode(spt.sh->data, &spt.b_off, spt.sh->text_size);
+	sheet_cursor_t cur;
+	char32_t ch;
+
+	sheet_cursor_init(&cur, spt.sh, spt.b_off);
+	ch = sheet_cursor_next(&cur);
+	spt.b_off = cur.off;
 	if (next)
 		*next = spt;
 	return ch;
@@ -329,7 +898,18 @@ char32_t spt_next_char(spt_t spt, spt_t *next)
 
 char32_t spt_prev_char(spt_t spt, spt_t *prev)
 {
-	char32_t ch = str_decode_reverse(spt.sh->data, &spt.b_off, spt.sh->text_size);
+	sheet_piece_t *p;
+	size_t start, o;
+	char32_t ch = '\0';
+
+	if (spt.b_off > 0) {
+		/* Characters never cross piece boundaries. */
+		p = sheet_find(spt.sh, spt.b_off - 1, &start, NULL, NULL);
+		o = spt.b_off - start;
+		ch = str_decode_reverse(p->text, &o, p->size);
+		spt.b_off = start + o;
+	}
+
 	if (prev)
 		*prev = spt;
 	return ch;
@@ -39,6 +39,7 @@
 #include <adt/list.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <str_search.h>
 
 /** Direction (in linear space) */
 enum dir_spec {
@@ -94,6 +95,8 @@ extern errno_t sheet_insert(sheet_t *, spt_t *, enum dir_spec, char *);
 extern errno_t sheet_delete(sheet_t *, spt_t *, spt_t *);
 extern void sheet_copy_out(sheet_t *, spt_t const *, spt_t const *, char *,
     size_t, spt_t *);
+extern errno_t sheet_search(sheet_t *, const str_search_t *, spt_t const *,
+    bool, spt_t *, spt_t *);
 extern void sheet_get_cell_pt(sheet_t *, coord_t const *, enum dir_spec,
     spt_t *);
 extern void sheet_get_row_width(sheet_t *, int, int *);
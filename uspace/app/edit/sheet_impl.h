@@ -36,15 +36,43 @@
 #ifndef SHEET_IMPL_H__
 #define SHEET_IMPL_H__
 
+#include <stddef.h>
 #include "sheet.h"
 
+/** Piece of the text of a sheet
+ *
+ * Pieces are the nodes of an AVL tree ordered by their position in the
+ * text. Each node also keeps the totals of its subtree, so that byte
+ * offsets and rows can be looked up in logarithmic time.
+ */
+typedef struct sheet_piece {
+	struct sheet_piece *left;
+	struct sheet_piece *right;
+	/** Height of the subtree */
+	int height;
+
+	/** Text of the piece, never split inside a character */
+	char *text;
+	/** Size of the text in bytes, never zero */
+	size_t size;
+	/** Number of newlines in the text */
+	size_t nl;
+
+	/** Number of pieces in the subtree */
+	size_t sub_count;
+	/** Size of the text in the subtree in bytes */
+	size_t sub_size;
+	/** Number of newlines in the subtree */
+	size_t sub_nl;
+} sheet_piece_t;
+
 /** Sheet */
 struct sheet {
 	/* Note: This structure is opaque for the user. */
 
 	size_t text_size;
-	size_t dbuf_size;
-	char *data;
+	/** Root of the tree of pieces, NULL if the sheet is empty */
+	sheet_piece_t *root;
 
 	list_t tags;
 };
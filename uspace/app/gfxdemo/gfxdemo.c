@@ -315,6 +315,7 @@ static errno_t demo_rects(gfx_context_t *gc, gfx_coord_t w, gfx_coord_t h)
 
 		gfx_color_delete(color);
 
+		(void) gfx_update(gc);
 		fibril_usleep(500 * 1000);
 
 		if (quit)
@@ -477,6 +478,7 @@ static errno_t demo_bitmap(gfx_context_t *gc, gfx_coord_t w, gfx_coord_t h)
 			rc = gfx_bitmap_render(bitmap, &srect, &offs);
 			if (rc != EOK)
 				goto error;
+			(void) gfx_update(gc);
 			fibril_usleep(250 * 1000);
 
 			if (quit)
@@ -538,6 +540,7 @@ static errno_t demo_bitmap2(gfx_context_t *gc, gfx_coord_t w, gfx_coord_t h)
 				goto error;
 		}
 
+		(void) gfx_update(gc);
 		fibril_usleep(500 * 1000);
 
 		if (quit)
@@ -599,6 +602,7 @@ static errno_t demo_bitmap_kc(gfx_context_t *gc, gfx_coord_t w, gfx_coord_t h)
 				goto error;
 		}
 
+		(void) gfx_update(gc);
 		fibril_usleep(500 * 1000);
 
 		if (quit)
@@ -790,6 +794,7 @@ static errno_t demo_text(gfx_context_t *gc, gfx_coord_t w, gfx_coord_t h)
 	}
 
 	for (i = 0; i < 10; i++) {
+		(void) gfx_update(gc);
 		fibril_usleep(500 * 1000);
 		if (quit)
 			break;
@@ -871,6 +876,7 @@ static errno_t demo_text_abbr(gfx_context_t *gc, gfx_coord_t w, gfx_coord_t h)
 	}
 
 	for (i = 0; i < 10; i++) {
+		(void) gfx_update(gc);
 		fibril_usleep(500 * 1000);
 		if (quit)
 			break;
@@ -968,6 +974,7 @@ static errno_t demo_clip(gfx_context_t *gc, gfx_coord_t w, gfx_coord_t h)
 				goto error;
 		}
 
+		(void) gfx_update(gc);
 		fibril_usleep(500 * 1000);
 
 		if (quit)
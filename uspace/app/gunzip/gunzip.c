@@ -34,91 +34,145 @@
 
 #include <errno.h>
 #include <gzip.h>
+#include <inflate.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-int main(int argc, char *argv[])
+/** Size of input and output buffer */
+#define BUF_SIZE 65536
+
+/** Stream-decompress GZIP file
+ *
+ * @param f      Source file
+ * @param fname  Source file name
+ * @param wf     Destination file
+ * @param wfname Destination file name
+ * @return Zero on success, non-zero on error
+ */
+static int gunzip(FILE *f, const char *fname, FILE *wf, const char *wfname)
 {
+	inflate_t *inf = NULL;
+	uint8_t *ibuf = NULL;
+	uint8_t *obuf = NULL;
+	size_t ilen, ipos;
+	size_t hdr_size;
+	size_t consumed, produced;
+	size_t nread;
+	bool eof;
 	errno_t rc;
-	void *data, *ddata;
-	size_t size, dsize;
-	size_t nread, nwr;
-	long len;
-	FILE *f, *wf;
+	int ret = 1;
 
-	if (argc != 3) {
-		printf("syntax: gunzip <src.gz> <dest>\n");
-		return 1;
+	ibuf = malloc(BUF_SIZE);
+	obuf = malloc(BUF_SIZE);
+	if (ibuf == NULL || obuf == NULL) {
+		printf("Out of memory.\n");
+		goto out;
 	}
 
-	f = fopen(argv[1], "rb");
-	if (f == NULL) {
-		printf("Error opening '%s'\n", argv[1]);
-		return 1;
+	rc = inflate_init(&inf);
+	if (rc != EOK) {
+		printf("Out of memory.\n");
+		goto out;
 	}
 
-	if (fseek(f, 0, SEEK_END) < 0) {
-		printf("Error determining size of '%s'\n", argv[1]);
-		fclose(f);
-		return 1;
+	/* Read until the whole header is available */
+	ilen = 0;
+	while (true) {
+		nread = fread(ibuf + ilen, 1, BUF_SIZE - ilen, f);
+		if (ferror(f)) {
+			printf("Error reading '%s'\n", fname);
+			goto out;
+		}
+
+		ilen += nread;
+		eof = feof(f);
+
+		rc = gzip_header_size(ibuf, ilen, &hdr_size);
+		if (rc == EOK)
+			break;
+
+		if (rc != ELIMIT || eof || ilen == BUF_SIZE) {
+			printf("Error decompressing data.\n");
+			goto out;
+		}
 	}
 
-	len = ftell(f);
-	if (len < 0) {
-		printf("Error determining size of '%s'\n", argv[1]);
-		fclose(f);
-		return 1;
-	}
+	ipos = hdr_size;
 
-	if (fseek(f, 0, SEEK_SET) < 0) {
-		printf ("Error rewinding '%s'\n", argv[1]);
-		fclose(f);
-		return 1;
-	}
+	/* Decompress data chunk by chunk */
+	do {
+		if (ipos == ilen && !eof) {
+			ilen = fread(ibuf, 1, BUF_SIZE, f);
+			if (ferror(f)) {
+				printf("Error reading '%s'\n", fname);
+				goto out;
+			}
 
-	data = malloc(len);
-	if (data == NULL) {
-		printf("Error allocating %ld bytes.\n", len);
-		fclose(f);
-		return 1;
-	}
+			eof = feof(f);
+			ipos = 0;
+		}
 
-	nread = fread(data, 1, len, f);
-	if (nread != (size_t)len) {
-		printf("Error reading '%s'\n", argv[1]);
-		fclose(f);
-		return 1;
-	}
+		rc = inflate_step(inf, ibuf + ipos, ilen - ipos, &consumed,
+		    obuf, BUF_SIZE, &produced);
+		ipos += consumed;
 
-	fclose(f);
+		if (fwrite(obuf, 1, produced, wf) != produced) {
+			printf("Error writing '%s'\n", wfname);
+			goto out;
+		}
 
-	size = (size_t) len;
+		if (rc == EAGAIN && produced == 0 && ipos == ilen && eof) {
+			/* Truncated stream */
+			rc = ELIMIT;
+		}
+	} while (rc == EAGAIN);
 
-	rc = gzip_expand(data, size, &ddata, &dsize);
 	if (rc != EOK) {
 		printf("Error decompressing data.\n");
+		goto out;
+	}
+
+	ret = 0;
+out:
+	inflate_destroy(inf);
+	free(ibuf);
+	free(obuf);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	FILE *f, *wf;
+	int ret;
+
+	if (argc != 3) {
+		printf("syntax: gunzip <src.gz> <dest>\n");
+		return 1;
+	}
+
+	f = fopen(argv[1], "rb");
+	if (f == NULL) {
+		printf("Error opening '%s'\n", argv[1]);
 		return 1;
 	}
 
 	wf = fopen(argv[2], "wb");
 	if (wf == NULL) {
 		printf("Error creating file '%s'\n", argv[2]);
+		fclose(f);
 		return 1;
 	}
 
-	nwr = fwrite(ddata, 1, dsize, wf);
-	if (nwr != dsize) {
-		printf("Error writing '%s'\n", argv[2]);
-		fclose(wf);
-		return 1;
-	}
+	ret = gunzip(f, argv[1], wf, argv[2]);
+	fclose(f);
 
-	if (fclose(wf) != 0) {
+	if (fclose(wf) != 0 && ret == 0) {
 		printf("Error writing '%s'\n", argv[2]);
 		return 1;
 	}
 
-	return 0;
+	return ret;
 }
 
 /** @}
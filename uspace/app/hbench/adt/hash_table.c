@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/ohash_table.h>
+#include <stdlib.h>
+#include <str.h>
+#include "../hbench.h"
+
+typedef struct {
+	ht_link_t link;
+	uint64_t key;
+} bench_item_t;
+
+static size_t item_key_hash(const void *key)
+{
+	return *(const uint64_t *) key;
+}
+
+static size_t item_hash(const ht_link_t *item)
+{
+	bench_item_t *bi = hash_table_get_inst(item, bench_item_t, link);
+	return item_key_hash(&bi->key);
+}
+
+static bool item_key_equal(const void *key, const ht_link_t *item)
+{
+	bench_item_t *bi = hash_table_get_inst(item, bench_item_t, link);
+	return bi->key == *(const uint64_t *) key;
+}
+
+static const hash_table_ops_t item_ops = {
+	.hash = item_hash,
+	.key_hash = item_key_hash,
+	.key_equal = item_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Allocate items with keys spread over a range twice their count. */
+static bench_item_t *items_create(bench_env_t *env, bench_run_t *run,
+    size_t *count)
+{
+	const char *param = bench_env_param_get(env, "count", "10000");
+	uint64_t value;
+
+	if (str_uint64_t(param, NULL, 10, true, &value) != EOK || value == 0) {
+		bench_run_fail(run, "invalid item count '%s'", param);
+		return NULL;
+	}
+
+	bench_item_t *items = calloc(value, sizeof(bench_item_t));
+	if (items == NULL) {
+		bench_run_fail(run, "failed to allocate %" PRIu64 " items",
+		    value);
+		return NULL;
+	}
+
+	for (size_t i = 0; i < value; i++)
+		items[i].key = 2 * i;
+
+	*count = value;
+	return items;
+}
+
+/** Key of the i-th lookup, hitting present and missing keys alike. */
+static inline uint64_t lookup_key(uint64_t i, size_t count)
+{
+	return hash_mix(i) % (2 * count);
+}
+
+static bool runner_hash_table(bench_env_t *env, bench_run_t *run,
+    uint64_t size)
+{
+	size_t count;
+	bench_item_t *items = items_create(env, run, &count);
+	if (items == NULL)
+		return false;
+
+	hash_table_t h;
+	if (!hash_table_create(&h, 0, 0, &item_ops)) {
+		free(items);
+		return bench_run_fail(run, "failed to create hash table");
+	}
+
+	for (size_t i = 0; i < count; i++)
+		hash_table_insert(&h, &items[i].link);
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		uint64_t key = lookup_key(i, count);
+		(void) hash_table_find(&h, &key);
+	}
+	bench_run_stop(run);
+
+	hash_table_destroy(&h);
+	free(items);
+
+	return true;
+}
+
+static bool runner_ohash_table(bench_env_t *env, bench_run_t *run,
+    uint64_t size)
+{
+	size_t count;
+	bench_item_t *items = items_create(env, run, &count);
+	if (items == NULL)
+		return false;
+
+	ohash_table_t h;
+	if (!ohash_table_create(&h, 0, &item_ops)) {
+		free(items);
+		return bench_run_fail(run, "failed to create hash table");
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (ohash_table_insert(&h, &items[i].link) != EOK) {
+			ohash_table_destroy(&h);
+			free(items);
+			return bench_run_fail(run, "failed to insert item");
+		}
+	}
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		uint64_t key = lookup_key(i, count);
+		(void) ohash_table_find(&h, &key);
+	}
+	bench_run_stop(run);
+
+	ohash_table_destroy(&h);
+	free(items);
+
+	return true;
+}
+
+benchmark_t benchmark_hash_table = {
+	.name = "hash_table",
+	.desc = "Look up keys in a chained hash table (use 'count' param to alter the default of 10000 items)",
+	.entry = &runner_hash_table,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+benchmark_t benchmark_ohash_table = {
+	.name = "ohash_table",
+	.desc = "Look up keys in an open-addressing hash table (use 'count' param to alter the default of 10000 items)",
+	.entry = &runner_ohash_table,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
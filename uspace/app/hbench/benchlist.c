@@ -38,13 +38,37 @@
 #include "hbench.h"
 
 benchmark_t *benchmarks[] = {
+	&benchmark_as_area,
+	&benchmark_context_switch,
 	&benchmark_dir_read,
 	&benchmark_fibril_mutex,
 	&benchmark_file_read,
+	&benchmark_gfx_blit,
+	&benchmark_gfx_blit_key,
+	&benchmark_gfx_fill,
+	&benchmark_gsort,
+	&benchmark_hash_table,
+	&benchmark_http_get,
 	&benchmark_malloc1,
+	&benchmark_malloc1_mt,
 	&benchmark_malloc2,
+	&benchmark_malloc2_mt,
+	&benchmark_memcpy,
+	&benchmark_memset,
 	&benchmark_ns_ping,
-	&benchmark_ping_pong
+	&benchmark_ohash_table,
+	&benchmark_page_fault,
+	&benchmark_ping_pong,
+	&benchmark_pixconv_pixel,
+	&benchmark_pixconv_row,
+	&benchmark_qsort,
+	&benchmark_syscall,
+	&benchmark_tcp_connect,
+	&benchmark_tcp_rr,
+	&benchmark_tcp_stream,
+	&benchmark_tlb_shootdown,
+	&benchmark_udp_echo,
+	&benchmark_wakeup_latency
 };
 
 size_t benchmark_count = sizeof(benchmarks) / sizeof(benchmarks[0]);
@@ -35,10 +35,24 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <str.h>
 #include "hbench.h"
 
+/** Maximum length of a line in the baseline CSV. */
+#define CSV_LINE_LENGTH 256
+
+/** Single measured run loaded from the baseline report. */
+typedef struct {
+	char *name;
+	uint64_t size;
+	nsec_t duration;
+} csv_baseline_entry_t;
+
 static FILE *csv_output = NULL;
 
+static csv_baseline_entry_t *baseline = NULL;
+static size_t baseline_count = 0;
+
 /** Open CSV benchmark report.
  *
  * @param filename Filename where to store the CSV.
@@ -51,7 +65,7 @@ errno_t csv_report_open(const char *filename)
 		return errno;
 	}
 
-	fprintf(csv_output, "benchmark,run,size,duration_nanos\n");
+	fprintf(csv_output, "benchmark,run,size,duration_nanos,cycles\n");
 
 	return EOK;
 }
@@ -73,9 +87,9 @@ void csv_report_add_entry(bench_run_t *run, int run_index,
 		return;
 	}
 
-	fprintf(csv_output, "%s,%d,%" PRIu64 ",%lld\n",
+	fprintf(csv_output, "%s,%d,%" PRIu64 ",%lld,%" PRIu64 "\n",
 	    bench->name, run_index, workload_size,
-	    (long long) stopwatch_get_nanos(&run->stopwatch));
+	    (long long) stopwatch_get_nanos(&run->stopwatch), run->cycles);
 }
 
 /** Close CSV report.
@@ -90,5 +104,142 @@ void csv_report_close(void)
 	}
 }
 
+/** Parse one line of the CSV report.
+ *
+ * Warm-up runs and the header are skipped, the cycles column is
+ * optional so that reports of older versions can be used as well.
+ *
+ * @param line Line to parse (modified).
+ * @param entry Where to store the parsed run.
+ * @return Whether the line describes a measured run.
+ */
+static bool csv_parse_line(char *line, csv_baseline_entry_t *entry)
+{
+	char *next = NULL;
+	char *name = str_tok(line, ",", &next);
+	char *run = str_tok(next, ",", &next);
+	char *size = str_tok(next, ",", &next);
+	char *duration = str_tok(next, ",\r\n", &next);
+
+	if (name == NULL || run == NULL || size == NULL || duration == NULL)
+		return false;
+
+	char *end;
+	long run_index = strtol(run, &end, 10);
+	if (*end != '\0' || run_index < 0)
+		return false;
+
+	if (str_uint64_t(size, NULL, 10, true, &entry->size) != EOK ||
+	    entry->size == 0)
+		return false;
+
+	long long nanos = strtoll(duration, &end, 10);
+	if (*end != '\0' || nanos <= 0)
+		return false;
+
+	entry->duration = nanos;
+	entry->name = str_dup(name);
+	return entry->name != NULL;
+}
+
+/** Load baseline report for comparison.
+ *
+ * @param filename CSV created by csv_report_open() in a previous run.
+ * @return Error code.
+ */
+errno_t csv_baseline_load(const char *filename)
+{
+	size_t capacity = 0;
+	char line[CSV_LINE_LENGTH];
+	errno_t rc = EOK;
+
+	FILE *f = fopen(filename, "r");
+	if (f == NULL)
+		return errno;
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		csv_baseline_entry_t entry;
+		if (!csv_parse_line(line, &entry))
+			continue;
+
+		if (baseline_count == capacity) {
+			size_t ncap = capacity == 0 ? 64 : 2 * capacity;
+			csv_baseline_entry_t *nbase = realloc(baseline,
+			    ncap * sizeof(csv_baseline_entry_t));
+			if (nbase == NULL) {
+				free(entry.name);
+				rc = ENOMEM;
+				break;
+			}
+			baseline = nbase;
+			capacity = ncap;
+		}
+
+		baseline[baseline_count++] = entry;
+	}
+
+	if (rc == EOK && ferror(f))
+		rc = EIO;
+
+	fclose(f);
+
+	if (rc != EOK)
+		csv_baseline_free();
+
+	return rc;
+}
+
+/** Get baseline runs of given benchmark.
+ *
+ * @param name Benchmark name.
+ * @param nanos Where to store newly allocated array with durations of
+ *		the runs in nanoseconds per operation (NULL when none found).
+ * @return Number of runs found.
+ */
+size_t csv_baseline_get(const char *name, double **nanos)
+{
+	size_t count = 0;
+
+	*nanos = NULL;
+
+	for (size_t i = 0; i < baseline_count; i++) {
+		if (str_cmp(baseline[i].name, name) == 0)
+			count++;
+	}
+
+	if (count == 0)
+		return 0;
+
+	*nanos = calloc(count, sizeof(double));
+	if (*nanos == NULL)
+		return 0;
+
+	size_t pos = 0;
+	for (size_t i = 0; i < baseline_count; i++) {
+		if (str_cmp(baseline[i].name, name) != 0)
+			continue;
+
+		(*nanos)[pos++] = (double) baseline[i].duration /
+		    baseline[i].size;
+	}
+
+	return count;
+}
+
+/** Free loaded baseline report.
+ *
+ * When csv_baseline_load() was not called or failed, the function does
+ * nothing.
+ */
+void csv_baseline_free(void)
+{
+	for (size_t i = 0; i < baseline_count; i++)
+		free(baseline[i].name);
+
+	free(baseline);
+	baseline = NULL;
+	baseline_count = 0;
+}
+
 /** @}
  */
@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+/**
+ * @file Memory GC rendering benchmarks
+ *
+ * Each operation renders one frame of 'width' x 'height' pixels into
+ * a memory GC. With the default size of 1024x1024 one frame is one
+ * megapixel (2^20 pixels), so the reported ops/s read as Mpix/s.
+ */
+
+#include <errno.h>
+#include <gfx/bitmap.h>
+#include <gfx/color.h>
+#include <gfx/context.h>
+#include <gfx/render.h>
+#include <io/pixel.h>
+#include <memgfx/memgc.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/** Benchmark frame */
+typedef struct {
+	/** Memory GC */
+	mem_gc_t *mgc;
+	/** Generic graphic context */
+	gfx_context_t *gc;
+	/** Frame rectangle */
+	gfx_rect_t rect;
+	/** Frame pixels */
+	pixel_t *pixels;
+} gfx_frame_t;
+
+static void frame_invalidate(void *arg, gfx_rect_t *rect)
+{
+}
+
+static void frame_update(void *arg)
+{
+}
+
+static errno_t frame_cursor_get_pos(void *arg, gfx_coord2_t *pos)
+{
+	return ENOTSUP;
+}
+
+static errno_t frame_cursor_set_pos(void *arg, gfx_coord2_t *pos)
+{
+	return ENOTSUP;
+}
+
+static errno_t frame_cursor_set_visible(void *arg, bool visible)
+{
+	return ENOTSUP;
+}
+
+static mem_gc_cb_t frame_mem_gc_cb = {
+	.invalidate = frame_invalidate,
+	.update = frame_update,
+	.cursor_get_pos = frame_cursor_get_pos,
+	.cursor_set_pos = frame_cursor_set_pos,
+	.cursor_set_visible = frame_cursor_set_visible
+};
+
+/** Get frame dimension from parameter. */
+static bool get_dim(bench_env_t *env, bench_run_t *run, const char *name,
+    gfx_coord_t *dim)
+{
+	const char *param = bench_env_param_get(env, name, "1024");
+	uint64_t value;
+
+	if (str_uint64_t(param, NULL, 10, true, &value) != EOK ||
+	    value == 0 || value > 16384) {
+		return bench_run_fail(run, "invalid %s '%s'", name, param);
+	}
+
+	*dim = value;
+	return true;
+}
+
+/** Create frame of the size given by 'width' and 'height' parameters. */
+static bool frame_create(bench_env_t *env, bench_run_t *run,
+    gfx_frame_t *frame)
+{
+	gfx_bitmap_alloc_t alloc;
+	errno_t rc;
+
+	frame->rect.p0.x = 0;
+	frame->rect.p0.y = 0;
+	if (!get_dim(env, run, "width", &frame->rect.p1.x))
+		return false;
+	if (!get_dim(env, run, "height", &frame->rect.p1.y))
+		return false;
+
+	frame->pixels = calloc((size_t) frame->rect.p1.x * frame->rect.p1.y,
+	    sizeof(pixel_t));
+	if (frame->pixels == NULL) {
+		return bench_run_fail(run, "failed to allocate %dx%d frame",
+		    frame->rect.p1.x, frame->rect.p1.y);
+	}
+
+	alloc.pitch = frame->rect.p1.x * sizeof(pixel_t);
+	alloc.off0 = 0;
+	alloc.pixels = frame->pixels;
+
+	rc = mem_gc_create(&frame->rect, &alloc, &frame_mem_gc_cb, NULL,
+	    &frame->mgc);
+	if (rc != EOK) {
+		free(frame->pixels);
+		return bench_run_fail(run, "failed creating memory GC: %s",
+		    str_error(rc));
+	}
+
+	frame->gc = mem_gc_get_ctx(frame->mgc);
+	return true;
+}
+
+static void frame_destroy(gfx_frame_t *frame)
+{
+	mem_gc_delete(frame->mgc);
+	free(frame->pixels);
+}
+
+static bool runner_gfx_fill(bench_env_t *env, bench_run_t *run,
+    uint64_t size)
+{
+	gfx_frame_t frame;
+	gfx_color_t *color;
+	errno_t rc;
+
+	if (!frame_create(env, run, &frame))
+		return false;
+
+	rc = gfx_color_new_rgb_i16(0x8000, 0x4000, 0x2000, &color);
+	if (rc != EOK) {
+		frame_destroy(&frame);
+		return bench_run_fail(run, "failed creating color: %s",
+		    str_error(rc));
+	}
+
+	rc = gfx_set_color(frame.gc, color);
+	if (rc != EOK)
+		goto error;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		rc = gfx_fill_rect(frame.gc, &frame.rect);
+		if (rc != EOK)
+			break;
+	}
+	bench_run_stop(run);
+
+	if (rc != EOK)
+		goto error;
+
+	gfx_color_delete(color);
+	frame_destroy(&frame);
+	return true;
+error:
+	gfx_color_delete(color);
+	frame_destroy(&frame);
+	return bench_run_fail(run, "failed filling rectangle: %s",
+	    str_error(rc));
+}
+
+/** Repeatedly render a frame-sized bitmap.
+ *
+ * @param env Benchmark environment
+ * @param run Benchmark run
+ * @param size Number of frames to render
+ * @param flags Bitmap flags
+ */
+static bool gfx_blit(bench_env_t *env, bench_run_t *run, uint64_t size,
+    gfx_bitmap_flags_t flags)
+{
+	gfx_frame_t frame;
+	gfx_bitmap_params_t params;
+	gfx_bitmap_alloc_t alloc;
+	gfx_bitmap_t *bitmap;
+	pixel_t *pixels;
+	size_t npixels;
+	errno_t rc;
+
+	if (!frame_create(env, run, &frame))
+		return false;
+
+	gfx_bitmap_params_init(&params);
+	params.rect = frame.rect;
+	params.flags = flags;
+	params.key_color = PIXEL(0, 255, 0, 255);
+
+	rc = gfx_bitmap_create(frame.gc, &params, NULL, &bitmap);
+	if (rc != EOK) {
+		frame_destroy(&frame);
+		return bench_run_fail(run, "failed creating bitmap: %s",
+		    str_error(rc));
+	}
+
+	rc = gfx_bitmap_get_alloc(bitmap, &alloc);
+	if (rc != EOK)
+		goto error;
+
+	/* Make every fourth pixel transparent when using color key */
+	pixels = alloc.pixels;
+	npixels = (size_t) frame.rect.p1.x * frame.rect.p1.y;
+	for (size_t i = 0; i < npixels; i++)
+		pixels[i] = (i % 4 == 0) ? params.key_color : PIXEL(0, i, 0, 0);
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		rc = gfx_bitmap_render(bitmap, NULL, NULL);
+		if (rc != EOK)
+			break;
+	}
+	bench_run_stop(run);
+
+	if (rc != EOK)
+		goto error;
+
+	gfx_bitmap_destroy(bitmap);
+	frame_destroy(&frame);
+	return true;
+error:
+	gfx_bitmap_destroy(bitmap);
+	frame_destroy(&frame);
+	return bench_run_fail(run, "failed rendering bitmap: %s",
+	    str_error(rc));
+}
+
+static bool runner_gfx_blit(bench_env_t *env, bench_run_t *run,
+    uint64_t size)
+{
+	return gfx_blit(env, run, size, 0);
+}
+
+static bool runner_gfx_blit_key(bench_env_t *env, bench_run_t *run,
+    uint64_t size)
+{
+	return gfx_blit(env, run, size, bmpf_color_key);
+}
+
+benchmark_t benchmark_gfx_fill = {
+	.name = "gfx_fill",
+	.desc = "Fill a frame in memory GC (use 'width' and 'height' params to alter the default of 1024x1024)",
+	.entry = &runner_gfx_fill,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+benchmark_t benchmark_gfx_blit = {
+	.name = "gfx_blit",
+	.desc = "Render an opaque bitmap to a frame in memory GC (use 'width' and 'height' params to alter the default of 1024x1024)",
+	.entry = &runner_gfx_blit,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+benchmark_t benchmark_gfx_blit_key = {
+	.name = "gfx_blit_key",
+	.desc = "Render a color-keyed bitmap to a frame in memory GC (use 'width' and 'height' params to alter the default of 1024x1024)",
+	.entry = &runner_gfx_blit_key,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
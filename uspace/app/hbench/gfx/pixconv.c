@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+/**
+ * @file Pixel conversion benchmarks
+ *
+ * Each operation converts one frame of 'width' x 'height' pixels to the
+ * visual given by the 'visual' parameter, either pixel by pixel or row by
+ * row. With the default size of 1024x1024 one frame is one megapixel, so
+ * the reported ops/s read as Mpix/s.
+ */
+
+#include <io/pixel.h>
+#include <pixconv.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <str.h>
+#include "../hbench.h"
+
+/** Visual that can be benchmarked */
+typedef struct {
+	/** Name of the visual */
+	const char *name;
+	/** Bytes per pixel */
+	size_t bytes;
+	/** Convert single pixel */
+	pixel2visual_t pixel2visual;
+	/** Convert row of pixels */
+	pixconv_row_t pixel2visual_row;
+} pixconv_visual_t;
+
+#define PIXCONV_VISUAL(name, bytes) \
+	{ #name, bytes, pixel2##name, pixel2##name##_row }
+
+static pixconv_visual_t visuals[] = {
+	PIXCONV_VISUAL(argb_8888, 4),
+	PIXCONV_VISUAL(abgr_8888, 4),
+	PIXCONV_VISUAL(rgba_8888, 4),
+	PIXCONV_VISUAL(bgra_8888, 4),
+	PIXCONV_VISUAL(rgb_0888, 4),
+	PIXCONV_VISUAL(bgr_0888, 4),
+	PIXCONV_VISUAL(rgb_8880, 4),
+	PIXCONV_VISUAL(bgr_8880, 4),
+	PIXCONV_VISUAL(rgb_888, 3),
+	PIXCONV_VISUAL(bgr_888, 3),
+	PIXCONV_VISUAL(rgb_555_be, 2),
+	PIXCONV_VISUAL(rgb_555_le, 2),
+	PIXCONV_VISUAL(rgb_565_be, 2),
+	PIXCONV_VISUAL(rgb_565_le, 2),
+	PIXCONV_VISUAL(bgr_323, 1),
+	PIXCONV_VISUAL(gray_8, 1)
+};
+
+/** Benchmark frame */
+typedef struct {
+	/** Visual */
+	pixconv_visual_t *visual;
+	/** Width in pixels */
+	size_t width;
+	/** Height in pixels */
+	size_t height;
+	/** Source pixels */
+	pixel_t *pixels;
+	/** Destination in visual format */
+	uint8_t *data;
+} pixconv_frame_t;
+
+/** Get frame dimension from parameter. */
+static bool get_dim(bench_env_t *env, bench_run_t *run, const char *name,
+    size_t *dim)
+{
+	const char *param = bench_env_param_get(env, name, "1024");
+	uint64_t value;
+
+	if (str_uint64_t(param, NULL, 10, true, &value) != EOK ||
+	    value == 0 || value > 16384) {
+		return bench_run_fail(run, "invalid %s '%s'", name, param);
+	}
+
+	*dim = value;
+	return true;
+}
+
+/** Create frame as given by the 'visual', 'width' and 'height' params. */
+static bool frame_create(bench_env_t *env, bench_run_t *run,
+    pixconv_frame_t *frame)
+{
+	const char *name = bench_env_param_get(env, "visual", "bgr_8880");
+	size_t npixels;
+	size_t i;
+
+	frame->visual = NULL;
+	for (i = 0; i < sizeof(visuals) / sizeof(visuals[0]); i++) {
+		if (str_cmp(visuals[i].name, name) == 0)
+			frame->visual = &visuals[i];
+	}
+
+	if (frame->visual == NULL)
+		return bench_run_fail(run, "unknown visual '%s'", name);
+
+	if (!get_dim(env, run, "width", &frame->width))
+		return false;
+	if (!get_dim(env, run, "height", &frame->height))
+		return false;
+
+	npixels = frame->width * frame->height;
+	frame->pixels = malloc(npixels * sizeof(pixel_t));
+	frame->data = malloc(npixels * frame->visual->bytes);
+	if (frame->pixels == NULL || frame->data == NULL) {
+		free(frame->pixels);
+		free(frame->data);
+		return bench_run_fail(run, "failed to allocate %zux%zu frame",
+		    frame->width, frame->height);
+	}
+
+	for (i = 0; i < npixels; i++)
+		frame->pixels[i] = PIXEL(255, i, i >> 8, i >> 16);
+
+	return true;
+}
+
+static void frame_destroy(pixconv_frame_t *frame)
+{
+	free(frame->pixels);
+	free(frame->data);
+}
+
+static bool runner_pixconv_pixel(bench_env_t *env, bench_run_t *run,
+    uint64_t size)
+{
+	pixconv_frame_t frame;
+	pixel2visual_t p2v;
+	size_t npixels;
+	size_t bytes;
+
+	if (!frame_create(env, run, &frame))
+		return false;
+
+	p2v = frame.visual->pixel2visual;
+	bytes = frame.visual->bytes;
+	npixels = frame.width * frame.height;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		for (size_t j = 0; j < npixels; j++)
+			p2v(frame.data + j * bytes, frame.pixels[j]);
+	}
+	bench_run_stop(run);
+
+	frame_destroy(&frame);
+	return true;
+}
+
+static bool runner_pixconv_row(bench_env_t *env, bench_run_t *run,
+    uint64_t size)
+{
+	pixconv_frame_t frame;
+	pixconv_row_t row;
+	size_t pitch;
+
+	if (!frame_create(env, run, &frame))
+		return false;
+
+	row = frame.visual->pixel2visual_row;
+	pitch = frame.width * frame.visual->bytes;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		for (size_t y = 0; y < frame.height; y++) {
+			row(frame.data + y * pitch,
+			    frame.pixels + y * frame.width, frame.width);
+		}
+	}
+	bench_run_stop(run);
+
+	frame_destroy(&frame);
+	return true;
+}
+
+benchmark_t benchmark_pixconv_pixel = {
+	.name = "pixconv_pixel",
+	.desc = "Convert a frame to a visual pixel by pixel (use 'visual', 'width' and 'height' params to alter the default of bgr_8880 1024x1024)",
+	.entry = &runner_pixconv_pixel,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+benchmark_t benchmark_pixconv_row = {
+	.name = "pixconv_row",
+	.desc = "Convert a frame to a visual row by row (use 'visual', 'width' and 'height' params to alter the default of bgr_8880 1024x1024)",
+	.entry = &runner_pixconv_row,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
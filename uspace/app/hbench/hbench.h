@@ -38,16 +38,24 @@
 
 #include <adt/hash_table.h>
 #include <errno.h>
+#include <inet/endpoint.h>
 #include <stdbool.h>
 #include <perf.h>
 
 #define DEFAULT_RUN_COUNT 10
 #define DEFAULT_MIN_RUN_DURATION_SEC 10
+#define DEFAULT_WARMUP_COUNT 1
+
+/** Default minimal slowdown against baseline reported as regression (%). */
+#define DEFAULT_REGRESSION_THRESHOLD 5
+
+/** Default base port of the network benchmark peer */
+#define NET_PEER_PORT 7070
 
 /** Single run information.
  *
- * Used to store both performance information (now, only wall-clock
- * time) as well as information about error.
+ * Used to store both performance information (wall-clock time and
+ * CPU cycles consumed by the task) as well as information about error.
  *
  * Use proper access functions when modifying data inside this structure.
  *
@@ -56,6 +64,8 @@
  */
 typedef struct {
 	stopwatch_t stopwatch;
+	uint64_t cycles_start;
+	uint64_t cycles;
 	char *error_message;
 	size_t error_message_buffer_size;
 } bench_run_t;
@@ -70,7 +80,10 @@ typedef struct {
 typedef struct {
 	hash_table_t parameters;
 	size_t run_count;
+	size_t warmup_count;
 	nsec_t minimal_run_duration_nanos;
+	/** Minimal slowdown against baseline to report (in percent). */
+	unsigned int regression_threshold;
 } bench_env_t;
 
 /** Actual benchmark runner.
@@ -89,6 +102,12 @@ typedef bool (*benchmark_entry_t)(bench_env_t *, bench_run_t *, uint64_t);
  */
 typedef bool (*benchmark_helper_t)(bench_env_t *, bench_run_t *);
 
+/** Worker of a benchmark running in several threads.
+ *
+ * Executes the given number of iterations, without measuring them.
+ */
+typedef bool (*benchmark_worker_t)(bench_run_t *, uint64_t);
+
 typedef struct {
 	const char *name;
 	const char *desc;
@@ -97,8 +116,32 @@ typedef struct {
 	benchmark_helper_t teardown;
 } benchmark_t;
 
+/** Statistics of per-operation cost over a set of runs.
+ *
+ * All durations are in nanoseconds per single operation (i.e. duration
+ * of the run divided by workload size) so that runs with different
+ * workload sizes can be compared.
+ */
+typedef struct {
+	size_t count;
+	double mean;
+	double sigma;
+	/** Half-width of the 95% confidence interval of the mean. */
+	double confidence;
+	double median;
+	double p95;
+	double p99;
+	/** Mean CPU cycles per operation (zero when not available). */
+	double cycles;
+} bench_stats_t;
+
 extern void bench_run_init(bench_run_t *, char *, size_t);
+extern uint64_t bench_task_cycles(void);
 extern bool bench_run_fail(bench_run_t *, const char *, ...);
+extern bool bench_run_parallel(bench_env_t *, bench_run_t *, uint64_t,
+    benchmark_worker_t);
+extern int bench_env_threads(bench_env_t *);
+extern bool bench_spawn_runners(int);
 
 /*
  * We keep the following two functions inline to ensure that we start
@@ -106,38 +149,77 @@ extern bool bench_run_fail(bench_run_t *, const char *, ...);
  * this inlining is done at least on the level of individual wrappers
  * (this one and the one provided by stopwatch_t) to pass the control
  * as fast as possible to the actual timer used.
+ *
+ * Reading task cycles is considerably more expensive, thus it is done
+ * outside of the interval measured by the stopwatch.
  */
 
 static inline void bench_run_start(bench_run_t *run)
 {
+	run->cycles_start = bench_task_cycles();
 	stopwatch_start(&run->stopwatch);
 }
 
 static inline void bench_run_stop(bench_run_t *run)
 {
 	stopwatch_stop(&run->stopwatch);
+	run->cycles = bench_task_cycles() - run->cycles_start;
 }
 
+extern void bench_stats_compute(bench_stats_t *, double *, double *, size_t);
+extern int bench_stats_compare(bench_stats_t *, bench_stats_t *,
+    unsigned int);
+
 extern errno_t csv_report_open(const char *);
 extern void csv_report_add_entry(bench_run_t *, int, benchmark_t *, uint64_t);
 extern void csv_report_close(void);
+extern errno_t csv_baseline_load(const char *);
+extern size_t csv_baseline_get(const char *, double **);
+extern void csv_baseline_free(void);
 
 extern errno_t bench_env_init(bench_env_t *);
 extern errno_t bench_env_param_set(bench_env_t *, const char *, const char *);
 extern const char *bench_env_param_get(bench_env_t *, const char *, const char *);
 extern void bench_env_cleanup(bench_env_t *);
 
+extern errno_t net_peer_start(uint16_t);
+extern bool net_peer_ep(bench_env_t *, bench_run_t *, uint16_t, inet_ep_t *);
+
 extern benchmark_t *benchmarks[];
 extern size_t benchmark_count;
 
 /* Put your benchmark descriptors here (and also to benchlist.c). */
+extern benchmark_t benchmark_as_area;
+extern benchmark_t benchmark_context_switch;
 extern benchmark_t benchmark_dir_read;
 extern benchmark_t benchmark_fibril_mutex;
 extern benchmark_t benchmark_file_read;
+extern benchmark_t benchmark_gfx_blit;
+extern benchmark_t benchmark_gfx_blit_key;
+extern benchmark_t benchmark_gfx_fill;
+extern benchmark_t benchmark_gsort;
+extern benchmark_t benchmark_hash_table;
+extern benchmark_t benchmark_http_get;
 extern benchmark_t benchmark_malloc1;
+extern benchmark_t benchmark_malloc1_mt;
 extern benchmark_t benchmark_malloc2;
+extern benchmark_t benchmark_malloc2_mt;
+extern benchmark_t benchmark_memcpy;
+extern benchmark_t benchmark_memset;
 extern benchmark_t benchmark_ns_ping;
+extern benchmark_t benchmark_ohash_table;
+extern benchmark_t benchmark_page_fault;
 extern benchmark_t benchmark_ping_pong;
+extern benchmark_t benchmark_pixconv_pixel;
+extern benchmark_t benchmark_pixconv_row;
+extern benchmark_t benchmark_qsort;
+extern benchmark_t benchmark_syscall;
+extern benchmark_t benchmark_tcp_connect;
+extern benchmark_t benchmark_tcp_rr;
+extern benchmark_t benchmark_tcp_stream;
+extern benchmark_t benchmark_tlb_shootdown;
+extern benchmark_t benchmark_udp_echo;
+extern benchmark_t benchmark_wakeup_latency;
 
 #endif
 
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <as.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <stdatomic.h>
+#include "../hbench.h"
+
+/*
+ * Address space benchmarks. All of them use anonymous unpaged areas,
+ * i.e. physical frames are allocated on the first access to each page.
+ */
+
+/** Number of pages of a single area in the page fault benchmark. */
+#define PAGE_FAULT_CHUNK 256
+
+#define AREA_FLAGS (AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE)
+
+/** Shared state of fibrils keeping other CPUs busy in our address space. */
+typedef struct {
+	atomic_int running;
+	atomic_bool stop;
+	fibril_semaphore_t done;
+} spinners_t;
+
+static void *area_create(size_t pages)
+{
+	return as_area_create(AS_AREA_ANY, PAGES2SIZE(pages), AREA_FLAGS,
+	    AS_AREA_UNPAGED);
+}
+
+static void area_touch(void *area, size_t pages)
+{
+	volatile uint8_t *p = area;
+
+	for (size_t i = 0; i < pages; i++)
+		p[PAGES2SIZE(i)] = 1;
+}
+
+/** Measure anonymous page faults.
+ *
+ * New area is created and destroyed every PAGE_FAULT_CHUNK pages so the
+ * results include the amortized cost of these operations as well.
+ */
+static bool runner_fault(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	bench_run_start(run);
+	for (uint64_t done = 0; done < size; done += PAGE_FAULT_CHUNK) {
+		size_t pages = PAGE_FAULT_CHUNK;
+		if (size - done < pages)
+			pages = size - done;
+
+		void *area = area_create(pages);
+		if (area == AS_MAP_FAILED)
+			return bench_run_fail(run, "failed to create area");
+
+		area_touch(area, pages);
+
+		errno_t rc = as_area_destroy(area);
+		if (rc != EOK)
+			return bench_run_fail(run, "failed to destroy area");
+	}
+	bench_run_stop(run);
+
+	return true;
+}
+
+static bool runner_area(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		void *area = area_create(1);
+		if (area == AS_MAP_FAILED)
+			return bench_run_fail(run, "failed to create area");
+
+		errno_t rc = as_area_destroy(area);
+		if (rc != EOK)
+			return bench_run_fail(run, "failed to destroy area");
+	}
+	bench_run_stop(run);
+
+	return true;
+}
+
+static errno_t spinner_fibril(void *arg)
+{
+	spinners_t *spinners = arg;
+
+	atomic_fetch_add(&spinners->running, 1);
+	while (!atomic_load_explicit(&spinners->stop, memory_order_relaxed)) {
+		/* Keep this CPU in our address space. */
+	}
+
+	fibril_semaphore_up(&spinners->done);
+	return EOK;
+}
+
+static void spinners_stop(spinners_t *spinners, int count)
+{
+	atomic_store(&spinners->stop, true);
+	for (int i = 0; i < count; i++)
+		fibril_semaphore_down(&spinners->done);
+}
+
+/** Measure unmapping of a page while other threads run in the same AS.
+ *
+ * Destroying the area requires a TLB shootdown on all CPUs the other
+ * threads run on. Run with threads=1 to get cost of the same work without
+ * the shootdown.
+ */
+static bool runner_shootdown(bench_env_t *env, bench_run_t *run,
+    uint64_t size)
+{
+	int threads = bench_env_threads(env);
+	if (threads == 0)
+		return bench_run_fail(run, "invalid number of threads");
+
+	int others = threads - 1;
+	if (!bench_spawn_runners(others))
+		return bench_run_fail(run, "failed to spawn runner threads");
+
+	spinners_t spinners;
+	atomic_init(&spinners.running, 0);
+	atomic_init(&spinners.stop, false);
+	fibril_semaphore_initialize(&spinners.done, 0);
+
+	for (int i = 0; i < others; i++) {
+		fid_t fid = fibril_create(spinner_fibril, &spinners);
+		if (fid == 0) {
+			spinners_stop(&spinners, i);
+			return bench_run_fail(run, "failed to create fibril");
+		}
+		fibril_add_ready(fid);
+	}
+
+	while (atomic_load(&spinners.running) < others)
+		fibril_yield();
+
+	bool ok = true;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		void *area = area_create(1);
+		if (area == AS_MAP_FAILED) {
+			ok = bench_run_fail(run, "failed to create area");
+			break;
+		}
+
+		area_touch(area, 1);
+
+		if (as_area_destroy(area) != EOK) {
+			ok = bench_run_fail(run, "failed to destroy area");
+			break;
+		}
+	}
+	bench_run_stop(run);
+
+	spinners_stop(&spinners, others);
+	return ok;
+}
+
+benchmark_t benchmark_page_fault = {
+	.name = "page_fault",
+	.desc = "Anonymous page fault (first write to a fresh page)",
+	.entry = &runner_fault,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+benchmark_t benchmark_as_area = {
+	.name = "as_area",
+	.desc = "Create and destroy a single-page address space area",
+	.entry = &runner_area,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+benchmark_t benchmark_tlb_shootdown = {
+	.name = "tlb_shootdown",
+	.desc = "Unmap a page while other threads run in the same address space (use 'threads' param to alter the default)",
+	.entry = &runner_shootdown,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
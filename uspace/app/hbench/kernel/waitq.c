@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <abi/cap.h>
+#include <abi/synch.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <libc.h>
+#include <stats.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Thread switching benchmarks. The benchmarking fibril talks to a partner
+ * fibril through kernel wait queues directly (i.e. without the futex fast
+ * path) so that every operation really blocks the thread. The partner
+ * therefore has to run in another fibril runner thread.
+ *
+ * Return values of the wait queue operations inside the loops are not
+ * checked: they can only fail on invalid handles and we would be unable
+ * to stop the partner anyway.
+ */
+
+typedef struct {
+	cap_waitq_handle_t ping;
+	cap_waitq_handle_t pong;
+	uint64_t size;
+	atomic_uint_fast64_t acked;
+	fibril_semaphore_t done;
+} partner_t;
+
+static void waitq_sleep(cap_waitq_handle_t wq)
+{
+	(void) __SYSCALL3(SYS_WAITQ_SLEEP, (sysarg_t) wq,
+	    (sysarg_t) SYNCH_NO_TIMEOUT, (sysarg_t) SYNCH_FLAGS_NONE);
+}
+
+static void waitq_wakeup(cap_waitq_handle_t wq)
+{
+	(void) __SYSCALL1(SYS_WAITQ_WAKEUP, (sysarg_t) wq);
+}
+
+/** Answer each ping with a pong. */
+static errno_t pong_fibril(void *arg)
+{
+	partner_t *partner = arg;
+
+	for (uint64_t i = 0; i < partner->size; i++) {
+		waitq_sleep(partner->ping);
+		waitq_wakeup(partner->pong);
+	}
+
+	fibril_semaphore_up(&partner->done);
+	return EOK;
+}
+
+/** Acknowledge each ping by updating shared counter. */
+static errno_t ack_fibril(void *arg)
+{
+	partner_t *partner = arg;
+
+	for (uint64_t i = 0; i < partner->size; i++) {
+		waitq_sleep(partner->ping);
+		atomic_store_explicit(&partner->acked, i + 1,
+		    memory_order_release);
+	}
+
+	fibril_semaphore_up(&partner->done);
+	return EOK;
+}
+
+static bool partner_start(partner_t *partner, bench_run_t *run,
+    uint64_t size, errno_t (*fn)(void *))
+{
+	partner->size = size;
+	partner->ping = CAP_NIL;
+	partner->pong = CAP_NIL;
+	atomic_init(&partner->acked, 0);
+	fibril_semaphore_initialize(&partner->done, 0);
+
+	if (!bench_spawn_runners(1))
+		return bench_run_fail(run, "failed to spawn runner thread");
+
+	errno_t rc = __SYSCALL1(SYS_WAITQ_CREATE, (sysarg_t) &partner->ping);
+	if (rc == EOK)
+		rc = __SYSCALL1(SYS_WAITQ_CREATE, (sysarg_t) &partner->pong);
+	if (rc != EOK)
+		goto error;
+
+	fid_t fid = fibril_create(fn, partner);
+	if (fid == 0) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	fibril_add_ready(fid);
+	return true;
+
+error:
+	if (partner->ping != CAP_NIL)
+		(void) __SYSCALL1(SYS_WAITQ_DESTROY, (sysarg_t) partner->ping);
+	return bench_run_fail(run, "failed to create wait queue: %s",
+	    str_error(rc));
+}
+
+static void partner_finish(partner_t *partner)
+{
+	fibril_semaphore_down(&partner->done);
+
+	(void) __SYSCALL1(SYS_WAITQ_DESTROY, (sysarg_t) partner->ping);
+	(void) __SYSCALL1(SYS_WAITQ_DESTROY, (sysarg_t) partner->pong);
+}
+
+static bool runner_switch(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	partner_t partner;
+
+	if (!partner_start(&partner, run, size, pong_fibril))
+		return false;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		waitq_wakeup(partner.ping);
+		waitq_sleep(partner.pong);
+	}
+	bench_run_stop(run);
+
+	partner_finish(&partner);
+	return true;
+}
+
+static bool runner_wakeup(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	size_t cpus;
+	stats_cpu_t *stats = stats_get_cpus(&cpus);
+	if (stats == NULL)
+		return bench_run_fail(run, "failed to get CPU count");
+	free(stats);
+
+	/* We busy wait for the partner to run. */
+	if (cpus < 2)
+		return bench_run_fail(run, "at least two CPUs are needed");
+
+	partner_t partner;
+
+	if (!partner_start(&partner, run, size, ack_fibril))
+		return false;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		waitq_wakeup(partner.ping);
+		while (atomic_load_explicit(&partner.acked,
+		    memory_order_acquire) != i + 1) {
+			/* Busy wait */
+		}
+	}
+	bench_run_stop(run);
+
+	partner_finish(&partner);
+	return true;
+}
+
+benchmark_t benchmark_context_switch = {
+	.name = "context_switch",
+	.desc = "Thread-to-thread switch round trip via kernel wait queues",
+	.entry = &runner_switch,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+benchmark_t benchmark_wakeup_latency = {
+	.name = "wakeup_latency",
+	.desc = "Latency of waking up a thread sleeping on another CPU",
+	.entry = &runner_wakeup,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
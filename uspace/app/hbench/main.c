@@ -35,6 +35,7 @@
  */
 
 #include <assert.h>
+#include <async.h>
 #include <getopt.h>
 #include <math.h>
 #include <stdio.h>
@@ -44,12 +45,19 @@
 #include <time.h>
 #include <errno.h>
 #include <str_error.h>
+#include <task.h>
 #include <perf.h>
 #include <types/casting.h>
 #include "hbench.h"
 
 #define MAX_ERROR_STR_LENGTH 1024
 
+/** Whether runs are compared with a baseline report. */
+static bool baseline_loaded = false;
+
+/** Number of benchmarks significantly slower than baseline. */
+static size_t regression_count = 0;
+
 static void short_report(bench_run_t *info, int run_index,
     benchmark_t *bench, uint64_t workload_size)
 {
@@ -68,85 +76,90 @@ static void short_report(bench_run_t *info, int run_index,
 	}
 }
 
-/** Estimate square root value.
- *
- * @param value The value to compute square root of.
- * @param precision Required precision (e.g. 0.00001).
- *
- * @details
- *
- * This is a temporary solution until we have proper sqrt() implementation
- * in libmath.
+/** Compute and print statistics of the measured runs.
  *
- * The algorithm uses Babylonian method [1].
- *
- * [1] https://en.wikipedia.org/wiki/Methods_of_computing_square_roots#Babylonian_method
- */
-static double estimate_square_root(double value, double precision)
-{
-	double estimate = 1.;
-	double prev_estimate = estimate + 10 * precision;
-
-	while (fabs(estimate - prev_estimate) > precision) {
-		prev_estimate = estimate;
-		estimate = (prev_estimate + value / prev_estimate) / 2.;
-	}
-
-	return estimate;
-}
-
-/** Compute available statistics from given stopwatches.
- *
- * We compute normal mean for average duration of the workload and geometric
- * mean for average thruput. Note that geometric mean is necessary to compute
- * average throughput correctly - consider the following example:
+ * We compute mean, median and high percentiles of the per-operation
+ * duration. Average thruput is derived from the mean per-operation duration
+ * which is equivalent to the harmonic mean of thruputs of individual runs.
+ * Note that this is necessary to compute average throughput correctly -
+ * consider the following example:
  *  - we run always 60 operations,
  *  - first run executes in 30 s (i.e. 2 ops/s)
  *  - and second one in 10 s (6 ops/s).
  * Then, naively, average throughput would be (2+6)/2 = 4 [ops/s]. However, we
  * actually executed 60 + 60 ops in 30 + 10 seconds. So the actual average
- * throughput is 3 ops/s (which is exactly what geometric mean means).
+ * throughput is 3 ops/s.
+ *
+ * When a baseline was loaded, the runs are compared with it as well.
  *
+ * @return Whether the statistics could be computed.
  */
-static void compute_stats(bench_run_t *runs, size_t run_count,
-    uint64_t workload_size, double precision, double *out_duration_avg,
-    double *out_duration_sigma, double *out_thruput_avg)
+static bool summary_stats(bench_env_t *env, bench_run_t *runs,
+    size_t run_count, benchmark_t *bench, uint64_t workload_size)
 {
-	double inv_thruput_sum = 0.0;
-	double nanos_sum = 0.0;
-	double nanos_sum2 = 0.0;
+	double *nanos = calloc(run_count, sizeof(double));
+	double *cycles = calloc(run_count, sizeof(double));
+	if (nanos == NULL || cycles == NULL) {
+		free(nanos);
+		free(cycles);
+		return false;
+	}
 
 	for (size_t i = 0; i < run_count; i++) {
-		double nanos = stopwatch_get_nanos(&runs[i].stopwatch);
-		double thruput = (double) workload_size / nanos;
-
-		inv_thruput_sum += 1.0 / thruput;
-		nanos_sum += nanos;
-		nanos_sum2 += nanos * nanos;
-	}
-	*out_duration_avg = nanos_sum / run_count;
-	double sigma2 = (nanos_sum2 - nanos_sum * (*out_duration_avg)) /
-	    ((double) run_count - 1);
-	// FIXME: implement sqrt properly
-	if (run_count > 1) {
-		*out_duration_sigma = estimate_square_root(sigma2, precision);
-	} else {
-		*out_duration_sigma = NAN;
+		nanos[i] = (double) stopwatch_get_nanos(&runs[i].stopwatch) /
+		    workload_size;
+		cycles[i] = (double) runs[i].cycles / workload_size;
 	}
-	*out_thruput_avg = 1.0 / (inv_thruput_sum / run_count);
-}
 
-static void summary_stats(bench_run_t *runs, size_t run_count,
-    benchmark_t *bench, uint64_t workload_size)
-{
-	double duration_avg, duration_sigma, thruput_avg;
-	compute_stats(runs, run_count, workload_size, 0.001,
-	    &duration_avg, &duration_sigma, &thruput_avg);
+	bench_stats_t stats;
+	bench_stats_compute(&stats, nanos, cycles, run_count);
+	free(nanos);
+	free(cycles);
 
 	printf("Average: %" PRIu64 " ops in %.0f us (sd %.0f us); "
 	    "%.0f ops/s; Samples: %zu\n",
-	    workload_size, duration_avg / 1000.0, duration_sigma / 1000.0,
-	    thruput_avg * 1000000000.0, run_count);
+	    workload_size, stats.mean * workload_size / 1000.0,
+	    stats.sigma * workload_size / 1000.0,
+	    1000000000.0 / stats.mean, run_count);
+	printf("Per op: %.3f ns (95%% CI +-%.3f ns); median %.3f ns, "
+	    "p95 %.3f ns, p99 %.3f ns; %.1f cycles\n",
+	    stats.mean, stats.confidence, stats.median, stats.p95, stats.p99,
+	    stats.cycles);
+
+	if (!baseline_loaded)
+		return true;
+
+	double *base_nanos;
+	size_t base_count = csv_baseline_get(bench->name, &base_nanos);
+	if (base_count == 0) {
+		printf("Baseline: no runs of %s found.\n", bench->name);
+		return true;
+	}
+
+	bench_stats_t base_stats;
+	bench_stats_compute(&base_stats, base_nanos, NULL, base_count);
+	free(base_nanos);
+
+	printf("Baseline: %.3f ns (95%% CI +-%.3f ns); Samples: %zu; "
+	    "change %+.1f %%",
+	    base_stats.mean, base_stats.confidence, base_count,
+	    (stats.mean - base_stats.mean) * 100.0 / base_stats.mean);
+
+	switch (bench_stats_compare(&stats, &base_stats,
+	    env->regression_threshold)) {
+	case 1:
+		printf(" -- REGRESSION\n");
+		regression_count++;
+		break;
+	case -1:
+		printf(" -- improvement\n");
+		break;
+	default:
+		printf(" -- no significant change\n");
+		break;
+	}
+
+	return true;
 }
 
 static bool run_benchmark(bench_env_t *env, benchmark_t *bench)
@@ -203,8 +216,20 @@ static bool run_benchmark(bench_env_t *env, benchmark_t *bench)
 		}
 	}
 
-	printf("Workload size set to %" PRIu64 ", measuring %zu samples.\n",
-	    workload_size, env->run_count);
+	printf("Workload size set to %" PRIu64 ", %zu warm-up runs, "
+	    "measuring %zu samples.\n",
+	    workload_size, env->warmup_count, env->run_count);
+
+	for (size_t i = 0; i < env->warmup_count; i++) {
+		bench_run_t run;
+		bench_run_init(&run, error_msg, MAX_ERROR_STR_LENGTH);
+
+		bool ok = bench->entry(env, &run, workload_size);
+		if (!ok) {
+			goto leave_error;
+		}
+		csv_report_add_entry(&run, -1, bench, workload_size);
+	}
 
 	bench_run_t *runs = calloc(env->run_count, sizeof(bench_run_t));
 	if (runs == NULL) {
@@ -222,7 +247,11 @@ static bool run_benchmark(bench_env_t *env, benchmark_t *bench)
 		short_report(&runs[i], i, bench, workload_size);
 	}
 
-	summary_stats(runs, env->run_count, bench, workload_size);
+	if (!summary_stats(env, runs, env->run_count, bench, workload_size)) {
+		free(runs);
+		snprintf(error_msg, MAX_ERROR_STR_LENGTH, "failed allocating memory");
+		goto leave_error;
+	}
 	printf("\nBenchmark completed\n");
 
 	free(runs);
@@ -312,10 +341,18 @@ static void print_usage(const char *progname)
 	    "Set minimal run duration (milliseconds)\n");
 	printf("-n, --count N              "
 	    "Set number of measured runs\n");
+	printf("-w, --warmup N             "
+	    "Set number of warm-up runs before measuring\n");
+	printf("-b, --baseline old.csv     "
+	    "Compare results with a previously stored CSV\n");
+	printf("-t, --threshold PERCENT    "
+	    "Minimal slowdown against baseline to report\n");
 	printf("-o, --output filename.csv  "
 	    "Store machine-readable data in filename.csv\n");
 	printf("-p, --param KEY=VALUE      "
 	    "Additional parameters for the benchmark\n");
+	printf("-s, --serve                "
+	    "Serve network benchmarks run on another node\n");
 	printf("<benchmark> is one of the following:\n");
 	list_benchmarks();
 }
@@ -327,6 +364,36 @@ static void handle_param_arg(bench_env_t *env, char *arg)
 	bench_env_param_set(env, key, value);
 }
 
+/** Serve network benchmarks until terminated.
+ *
+ * The base port can be set with the 'port' parameter.
+ */
+static int serve_net_peer(bench_env_t *env)
+{
+	const char *port_str = bench_env_param_get(env, "port", NULL);
+	uint16_t port = NET_PEER_PORT;
+
+	if (port_str != NULL &&
+	    str_uint16_t(port_str, NULL, 10, true, &port) != EOK) {
+		fprintf(stderr, "Invalid port number '%s'.\n", port_str);
+		return -3;
+	}
+
+	errno_t rc = net_peer_start(port);
+	if (rc != EOK) {
+		fprintf(stderr, "Failed to start serving on port %" PRIu16 ": %s\n",
+		    port, str_error(rc));
+		return -4;
+	}
+
+	printf("Serving network benchmarks on port %" PRIu16 ".\n", port);
+	task_retval(0);
+	async_manager();
+
+	/* Not reached */
+	return 0;
+}
+
 int main(int argc, char *argv[])
 {
 	bench_env_t bench_env;
@@ -337,21 +404,31 @@ int main(int argc, char *argv[])
 		return -5;
 	}
 
-	const char *short_options = "ho:p:n:d:";
+	const char *short_options = "ho:p:n:d:sw:b:t:";
 	struct option long_options[] = {
+		{ "baseline", required_argument, NULL, 'b' },
 		{ "duration", required_argument, NULL, 'd' },
 		{ "help", optional_argument, NULL, 'h' },
 		{ "count", required_argument, NULL, 'n' },
 		{ "output", required_argument, NULL, 'o' },
 		{ "param", required_argument, NULL, 'p' },
+		{ "serve", no_argument, NULL, 's' },
+		{ "threshold", required_argument, NULL, 't' },
+		{ "warmup", required_argument, NULL, 'w' },
 		{ 0, 0, NULL, 0 }
 	};
 
 	char *csv_output_filename = NULL;
+	char *csv_baseline_filename = NULL;
+	bool serve = false;
+	uint32_t threshold;
 
 	int opt = 0;
 	while ((opt = getopt_long(argc, argv, short_options, long_options, NULL)) > 0) {
 		switch (opt) {
+		case 'b':
+			csv_baseline_filename = optarg;
+			break;
 		case 'd':
 			errno = EOK;
 			bench_env.minimal_run_duration_nanos = MSEC2NSEC(atoll(optarg));
@@ -377,12 +454,33 @@ int main(int argc, char *argv[])
 		case 'p':
 			handle_param_arg(&bench_env, optarg);
 			break;
+		case 's':
+			serve = true;
+			break;
+		case 't':
+			if (str_uint32_t(optarg, NULL, 10, true,
+			    &threshold) != EOK) {
+				fprintf(stderr, "Invalid -t argument.\n");
+				return -3;
+			}
+			bench_env.regression_threshold = threshold;
+			break;
+		case 'w':
+			if (str_size_t(optarg, NULL, 10, true,
+			    &bench_env.warmup_count) != EOK) {
+				fprintf(stderr, "Invalid -w argument.\n");
+				return -3;
+			}
+			break;
 		case -1:
 		default:
 			break;
 		}
 	}
 
+	if (serve)
+		return serve_net_peer(&bench_env);
+
 	if (optind + 1 != argc) {
 		print_usage(*argv);
 		fprintf(stderr, "Error: specify one benchmark to run or * for all.\n");
@@ -400,6 +498,17 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (csv_baseline_filename != NULL) {
+		errno_t rc = csv_baseline_load(csv_baseline_filename);
+		if (rc != EOK) {
+			fprintf(stderr, "Failed to load baseline '%s': %s\n",
+			    csv_baseline_filename, str_error(rc));
+			csv_report_close();
+			return -4;
+		}
+		baseline_loaded = true;
+	}
+
 	int exit_code = 0;
 
 	if (str_cmp(benchmark, "*") == 0) {
@@ -419,7 +528,15 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (regression_count > 0) {
+		printf("%zu benchmark(s) significantly slower than baseline.\n",
+		    regression_count);
+		if (exit_code == 0)
+			exit_code = -6;
+	}
+
 	csv_report_close();
+	csv_baseline_free();
 	bench_env_cleanup(&bench_env);
 
 	return exit_code;
@@ -35,9 +35,8 @@
 #include <stdlib.h>
 #include "../hbench.h"
 
-static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+static bool worker(bench_run_t *run, uint64_t size)
 {
-	bench_run_start(run);
 	for (uint64_t i = 0; i < size; i++) {
 		void *p = malloc(1);
 		if (p == NULL) {
@@ -47,11 +46,24 @@ static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
 		}
 		free(p);
 	}
-	bench_run_stop(run);
 
 	return true;
 }
 
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	bench_run_start(run);
+	bool ok = worker(run, size);
+	bench_run_stop(run);
+
+	return ok;
+}
+
+static bool runner_mt(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	return bench_run_parallel(env, run, size, worker);
+}
+
 benchmark_t benchmark_malloc1 = {
 	.name = "malloc1",
 	.desc = "User-space memory allocator benchmark, repeatedly allocate one block",
@@ -60,5 +72,13 @@ benchmark_t benchmark_malloc1 = {
 	.teardown = NULL
 };
 
+benchmark_t benchmark_malloc1_mt = {
+	.name = "malloc1_mt",
+	.desc = "Like malloc1, but in several threads at once (use 'threads' param to alter the default)",
+	.entry = &runner_mt,
+	.setup = NULL,
+	.teardown = NULL
+};
+
 /** @}
  */
@@ -34,10 +34,8 @@
 #include <stdio.h>
 #include "../hbench.h"
 
-static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+static bool worker(bench_run_t *run, uint64_t niter)
 {
-	bench_run_start(run);
-
 	void **p = malloc(niter * sizeof(void *));
 	if (p == NULL) {
 		return bench_run_fail(run, "failed to allocate backend array (%" PRIu64 "B)",
@@ -62,9 +60,21 @@ static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
 
 	free(p);
 
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	bench_run_start(run);
+	bool ok = worker(run, niter);
 	bench_run_stop(run);
 
-	return true;
+	return ok;
+}
+
+static bool runner_mt(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	return bench_run_parallel(env, run, niter, worker);
 }
 
 benchmark_t benchmark_malloc2 = {
@@ -75,5 +85,13 @@ benchmark_t benchmark_malloc2 = {
 	.teardown = NULL
 };
 
+benchmark_t benchmark_malloc2_mt = {
+	.name = "malloc2_mt",
+	.desc = "Like malloc2, but in several threads at once (use 'threads' param to alter the default)",
+	.entry = &runner_mt,
+	.setup = NULL,
+	.teardown = NULL
+};
+
 /** @}
  */
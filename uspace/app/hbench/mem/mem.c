@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <mem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include "../hbench.h"
+
+/** Get the block size from the 'blocksize' parameter. */
+static bool get_block_size(bench_env_t *env, bench_run_t *run, size_t *size)
+{
+	const char *param = bench_env_param_get(env, "blocksize", "4096");
+	uint64_t value;
+
+	if (str_uint64_t(param, NULL, 10, true, &value) != EOK || value == 0) {
+		return bench_run_fail(run, "invalid block size '%s'", param);
+	}
+
+	*size = value;
+	return true;
+}
+
+static bool runner_memcpy(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	size_t block_size;
+	if (!get_block_size(env, run, &block_size))
+		return false;
+
+	char *src = malloc(block_size);
+	char *dst = malloc(block_size);
+	if (src == NULL || dst == NULL) {
+		free(src);
+		free(dst);
+		return bench_run_fail(run, "failed to allocate 2x%zuB buffers",
+		    block_size);
+	}
+
+	memset(src, 0x5a, block_size);
+	memset(dst, 0, block_size);
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++)
+		memcpy(dst, src, block_size);
+	bench_run_stop(run);
+
+	free(src);
+	free(dst);
+	return true;
+}
+
+static bool runner_memset(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	size_t block_size;
+	if (!get_block_size(env, run, &block_size))
+		return false;
+
+	char *dst = malloc(block_size);
+	if (dst == NULL) {
+		return bench_run_fail(run, "failed to allocate %zuB buffer",
+		    block_size);
+	}
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++)
+		memset(dst, (int) i, block_size);
+	bench_run_stop(run);
+
+	free(dst);
+	return true;
+}
+
+benchmark_t benchmark_memcpy = {
+	.name = "memcpy",
+	.desc = "Repeatedly copy a memory block (use 'blocksize' param to alter the default of 4096, up to 16M)",
+	.entry = &runner_memcpy,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+benchmark_t benchmark_memset = {
+	.name = "memset",
+	.desc = "Repeatedly fill a memory block (use 'blocksize' param to alter the default of 4096, up to 16M)",
+	.entry = &runner_memset,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <http/http.h>
+#include <macros.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+#define BUFFER_SIZE 4096
+
+static http_t *http = NULL;
+static http_request_t *req = NULL;
+static char *buf = NULL;
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *host = bench_env_param_get(env, "host", "127.0.0.1");
+	const char *port_str = bench_env_param_get(env, "port", "8080");
+	const char *path = bench_env_param_get(env, "path", "/");
+	uint16_t port;
+	errno_t rc;
+
+	rc = str_uint16_t(port_str, NULL, 10, true, &port);
+	if (rc != EOK)
+		return bench_run_fail(run, "invalid port number: %s", port_str);
+
+	buf = malloc(BUFFER_SIZE);
+	req = http_request_create("GET", path);
+	if (buf == NULL || req == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	rc = http_headers_append(&req->headers, "Host", host);
+	if (rc != EOK)
+		return bench_run_fail(run, "out of memory");
+
+	http = http_create(host, port);
+	if (http == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	/* All requests are sent over one persistent connection */
+	rc = http_connect(http);
+	if (rc != EOK) {
+		return bench_run_fail(run,
+		    "failed connecting to %s:%s (have you run websrv?): %s (%d)",
+		    host, port_str, str_error(rc), rc);
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	if (http != NULL)
+		http_destroy(http);
+	if (req != NULL)
+		http_request_destroy(req);
+	free(buf);
+
+	http = NULL;
+	req = NULL;
+	buf = NULL;
+	return true;
+}
+
+/** Receive response body.
+ *
+ * The server must send the content length to keep the connection open.
+ */
+static bool receive_body(bench_run_t *run, http_response_t *resp)
+{
+	http_header_t *header;
+	size_t length;
+	size_t nrecv;
+	errno_t rc;
+
+	rc = http_headers_find_single(&resp->headers, "Content-Length",
+	    &header);
+	if (rc != EOK)
+		return bench_run_fail(run, "response has no content length");
+
+	rc = str_size_t(header->value, NULL, 10, true, &length);
+	if (rc != EOK)
+		return bench_run_fail(run, "invalid content length: %s",
+		    header->value);
+
+	while (length > 0) {
+		rc = recv_buffer(&http->recv_buffer, buf,
+		    min(length, (size_t) BUFFER_SIZE), &nrecv);
+		if (rc != EOK || nrecv == 0) {
+			return bench_run_fail(run, "failed receiving body: %s",
+			    str_error(rc));
+		}
+
+		length -= nrecv;
+	}
+
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	http_response_t *resp;
+	errno_t rc;
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		rc = http_send_request(http, req);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed sending request: %s (%d)",
+			    str_error(rc), rc);
+		}
+
+		rc = http_receive_response(&http->recv_buffer, &resp,
+		    16 * 1024, 100);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed receiving response: %s (%d)",
+			    str_error(rc), rc);
+		}
+
+		if (resp->status != 200) {
+			bench_run_fail(run, "server returned status %d %s",
+			    resp->status, resp->message);
+			http_response_destroy(resp);
+			return false;
+		}
+
+		bool ok = receive_body(run, resp);
+		http_response_destroy(resp);
+		if (!ok)
+			return false;
+	}
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_http_get = {
+	.name = "http_get",
+	.desc = "HTTP requests over one connection (use 'host', 'port' and 'path' params to alter the defaults).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+/**
+ * @file Peer of the network benchmarks.
+ *
+ * The peer serves TCP echo on the base port, TCP discard on the base
+ * port plus one and UDP echo on the base port. Unless the benchmarks are
+ * pointed to a remote host, the peer runs in the benchmarking task itself
+ * and is reached over loopback. For measurements between two nodes, run
+ * hbench with the --serve option on the remote node.
+ */
+
+#include <errno.h>
+#include <fibril_synch.h>
+#include <inet/endpoint.h>
+#include <inet/host.h>
+#include <inet/tcp.h>
+#include <inet/udp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+#define PEER_BUF_SIZE 16384
+#define PEER_UDP_BUF_SIZE 2048
+
+static void peer_echo_new_conn(tcp_listener_t *, tcp_conn_t *);
+static void peer_discard_new_conn(tcp_listener_t *, tcp_conn_t *);
+static void peer_udp_recv_msg(udp_assoc_t *, udp_rmsg_t *);
+
+static tcp_listen_cb_t peer_echo_lcb = {
+	.new_conn = peer_echo_new_conn
+};
+
+static tcp_listen_cb_t peer_discard_lcb = {
+	.new_conn = peer_discard_new_conn
+};
+
+static tcp_cb_t peer_conn_cb = {
+	.connected = NULL
+};
+
+static udp_cb_t peer_udp_cb = {
+	.recv_msg = peer_udp_recv_msg
+};
+
+static FIBRIL_MUTEX_INITIALIZE(peer_lock);
+static bool peer_started = false;
+static tcp_t *peer_tcp = NULL;
+static udp_t *peer_udp = NULL;
+
+/** Serve one TCP connection of the peer until the other side closes it.
+ *
+ * @param conn Connection
+ * @param echo @c true to send received data back, @c false to discard it
+ */
+static void peer_serve_conn(tcp_conn_t *conn, bool echo)
+{
+	uint8_t *buf;
+	size_t nrecv;
+	errno_t rc;
+
+	buf = malloc(PEER_BUF_SIZE);
+	if (buf == NULL) {
+		(void) tcp_conn_reset(conn);
+		return;
+	}
+
+	while (true) {
+		rc = tcp_conn_recv_wait(conn, buf, PEER_BUF_SIZE, &nrecv);
+		if (rc != EOK)
+			goto error;
+
+		if (nrecv == 0)
+			break;
+
+		if (echo) {
+			rc = tcp_conn_send(conn, buf, nrecv);
+			if (rc != EOK)
+				goto error;
+		}
+	}
+
+	(void) tcp_conn_send_fin(conn);
+	free(buf);
+	return;
+error:
+	(void) tcp_conn_reset(conn);
+	free(buf);
+}
+
+static void peer_echo_new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
+{
+	peer_serve_conn(conn, true);
+}
+
+static void peer_discard_new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
+{
+	peer_serve_conn(conn, false);
+}
+
+/** Send received UDP message back to its sender. */
+static void peer_udp_recv_msg(udp_assoc_t *assoc, udp_rmsg_t *rmsg)
+{
+	uint8_t buf[PEER_UDP_BUF_SIZE];
+	inet_ep_t ep;
+	size_t size;
+
+	size = udp_rmsg_size(rmsg);
+	if (size > PEER_UDP_BUF_SIZE)
+		return;
+
+	if (udp_rmsg_read(rmsg, 0, buf, size) != EOK)
+		return;
+
+	udp_rmsg_remote_ep(rmsg, &ep);
+	(void) udp_assoc_send_msg(assoc, &ep, buf, size);
+}
+
+/** Start the peer of the network benchmarks.
+ *
+ * The peer is started only once and runs until the task terminates.
+ *
+ * @param port Base port number
+ * @return EOK on success or an error code
+ */
+errno_t net_peer_start(uint16_t port)
+{
+	tcp_listener_t *echo_lst = NULL;
+	tcp_listener_t *discard_lst = NULL;
+	udp_assoc_t *assoc;
+	inet_ep2_t epp;
+	inet_ep_t ep;
+	errno_t rc;
+
+	fibril_mutex_lock(&peer_lock);
+
+	if (peer_started) {
+		fibril_mutex_unlock(&peer_lock);
+		return EOK;
+	}
+
+	rc = tcp_create(&peer_tcp);
+	if (rc != EOK)
+		goto error;
+
+	inet_ep_init(&ep);
+	ep.port = port;
+	rc = tcp_listener_create(peer_tcp, &ep, &peer_echo_lcb, NULL,
+	    &peer_conn_cb, NULL, &echo_lst);
+	if (rc != EOK)
+		goto error;
+
+	ep.port = port + 1;
+	rc = tcp_listener_create(peer_tcp, &ep, &peer_discard_lcb, NULL,
+	    &peer_conn_cb, NULL, &discard_lst);
+	if (rc != EOK)
+		goto error;
+
+	rc = udp_create(&peer_udp);
+	if (rc != EOK)
+		goto error;
+
+	inet_ep2_init(&epp);
+	epp.local.port = port;
+	rc = udp_assoc_create(peer_udp, &epp, &peer_udp_cb, NULL, &assoc);
+	if (rc != EOK)
+		goto error;
+
+	peer_started = true;
+	fibril_mutex_unlock(&peer_lock);
+	return EOK;
+error:
+	if (discard_lst != NULL)
+		tcp_listener_destroy(discard_lst);
+	if (echo_lst != NULL)
+		tcp_listener_destroy(echo_lst);
+	if (peer_udp != NULL)
+		udp_destroy(peer_udp);
+	if (peer_tcp != NULL)
+		tcp_destroy(peer_tcp);
+	peer_udp = NULL;
+	peer_tcp = NULL;
+	fibril_mutex_unlock(&peer_lock);
+	return rc;
+}
+
+/** Get endpoint of the peer of a network benchmark.
+ *
+ * The peer is the host given by the 'host' parameter. If there is no such
+ * parameter, the peer is started in this task and reached over loopback.
+ * The base port number can be set with the 'port' parameter.
+ *
+ * @param env    Benchmark environment
+ * @param run    Benchmark run for reporting errors
+ * @param offset Offset of the service port from the base port
+ * @param ep     Place to store the endpoint
+ * @return @c true on success, @c false on failure
+ */
+bool net_peer_ep(bench_env_t *env, bench_run_t *run, uint16_t offset,
+    inet_ep_t *ep)
+{
+	const char *host = bench_env_param_get(env, "host", NULL);
+	const char *port_str = bench_env_param_get(env, "port", NULL);
+	uint16_t port = NET_PEER_PORT;
+	errno_t rc;
+
+	if (port_str != NULL) {
+		rc = str_uint16_t(port_str, NULL, 10, true, &port);
+		if (rc != EOK)
+			return bench_run_fail(run, "invalid port number: %s",
+			    port_str);
+	}
+
+	inet_ep_init(ep);
+	ep->port = port + offset;
+
+	if (host == NULL) {
+		rc = net_peer_start(port);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed starting peer: %s (%d)",
+			    str_error(rc), rc);
+		}
+
+		host = "127.0.0.1";
+	}
+
+	rc = inet_host_plookup_one(host, ip_any, &ep->addr, NULL, NULL);
+	if (rc != EOK)
+		return bench_run_fail(run, "cannot resolve host '%s'", host);
+
+	return true;
+}
+
+/** @}
+ */
@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+/**
+ * @file TCP benchmarks.
+ */
+
+#include <errno.h>
+#include <inet/endpoint.h>
+#include <inet/tcp.h>
+#include <mem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+static tcp_t *tcp = NULL;
+static tcp_conn_t *rr_conn = NULL;
+static inet_ep_t echo_ep;
+static inet_ep_t discard_ep;
+static uint8_t *buf = NULL;
+static size_t buf_size;
+
+static bool setup_common(bench_env_t *env, bench_run_t *run,
+    const char *default_size)
+{
+	const char *param = bench_env_param_get(env, "size", default_size);
+	uint64_t value;
+	errno_t rc;
+
+	if (str_uint64_t(param, NULL, 10, true, &value) != EOK || value == 0)
+		return bench_run_fail(run, "invalid size '%s'", param);
+
+	buf_size = value;
+	buf = malloc(buf_size);
+	if (buf == NULL)
+		return bench_run_fail(run, "failed to allocate %zuB buffer",
+		    buf_size);
+
+	memset(buf, 0x5a, buf_size);
+
+	if (!net_peer_ep(env, run, 0, &echo_ep))
+		return false;
+	if (!net_peer_ep(env, run, 1, &discard_ep))
+		return false;
+
+	rc = tcp_create(&tcp);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to initialize TCP: %s (%d)",
+		    str_error(rc), rc);
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	if (rr_conn != NULL)
+		tcp_conn_destroy(rr_conn);
+	tcp_destroy(tcp);
+	free(buf);
+
+	rr_conn = NULL;
+	tcp = NULL;
+	buf = NULL;
+	return true;
+}
+
+static bool conn_open(bench_run_t *run, inet_ep_t *ep, tcp_conn_t **rconn)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	errno_t rc;
+
+	inet_ep2_init(&epp);
+	epp.remote = *ep;
+
+	rc = tcp_conn_create(tcp, &epp, NULL, NULL, &conn);
+	if (rc == EOK) {
+		rc = tcp_conn_wait_connected(conn);
+		if (rc != EOK)
+			tcp_conn_destroy(conn);
+	}
+
+	if (rc != EOK) {
+		return bench_run_fail(run,
+		    "failed connecting to peer: %s (%d)", str_error(rc), rc);
+	}
+
+	*rconn = conn;
+	return true;
+}
+
+/** Receive exactly @a size bytes from connection. */
+static bool conn_recv(bench_run_t *run, tcp_conn_t *conn, size_t size)
+{
+	size_t nrecv;
+	errno_t rc;
+
+	while (size > 0) {
+		rc = tcp_conn_recv_wait(conn, buf, size, &nrecv);
+		if (rc != EOK || nrecv == 0) {
+			return bench_run_fail(run, "failed receiving data: %s",
+			    rc != EOK ? str_error(rc) : "connection closed");
+		}
+
+		size -= nrecv;
+	}
+
+	return true;
+}
+
+/** Close connection and wait until the peer closes it too. */
+static bool conn_close(bench_run_t *run, tcp_conn_t *conn)
+{
+	size_t nrecv;
+	errno_t rc;
+
+	rc = tcp_conn_send_fin(conn);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed sending FIN: %s",
+		    str_error(rc));
+	}
+
+	do {
+		rc = tcp_conn_recv_wait(conn, buf, buf_size, &nrecv);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed closing connection: %s",
+			    str_error(rc));
+		}
+	} while (nrecv > 0);
+
+	return true;
+}
+
+static bool setup_stream(bench_env_t *env, bench_run_t *run)
+{
+	return setup_common(env, run, "16384");
+}
+
+/** Send data to the discard service.
+ *
+ * The time includes waiting for the peer to close the connection after
+ * it read all of the data, but not the connection setup.
+ */
+static bool runner_stream(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	tcp_conn_t *conn;
+	errno_t rc;
+
+	if (!conn_open(run, &discard_ep, &conn))
+		return false;
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		rc = tcp_conn_send(conn, buf, buf_size);
+		if (rc != EOK) {
+			bench_run_fail(run, "failed sending data: %s (%d)",
+			    str_error(rc), rc);
+			goto error;
+		}
+	}
+
+	if (!conn_close(run, conn))
+		goto error;
+
+	bench_run_stop(run);
+
+	tcp_conn_destroy(conn);
+	return true;
+error:
+	tcp_conn_destroy(conn);
+	return false;
+}
+
+static bool setup_rr(bench_env_t *env, bench_run_t *run)
+{
+	if (!setup_common(env, run, "1"))
+		return false;
+
+	/* All transactions use one connection */
+	return conn_open(run, &echo_ep, &rr_conn);
+}
+
+/** Send request to the echo service and wait for the response. */
+static bool runner_rr(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	errno_t rc;
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		rc = tcp_conn_send(rr_conn, buf, buf_size);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed sending data: %s (%d)",
+			    str_error(rc), rc);
+		}
+
+		if (!conn_recv(run, rr_conn, buf_size))
+			return false;
+	}
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+static bool setup_connect(bench_env_t *env, bench_run_t *run)
+{
+	return setup_common(env, run, "1");
+}
+
+/** Open connection, exchange one request and response and close it. */
+static bool runner_connect(bench_env_t *env, bench_run_t *run,
+    uint64_t niter)
+{
+	tcp_conn_t *conn;
+	errno_t rc;
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		if (!conn_open(run, &echo_ep, &conn))
+			return false;
+
+		rc = tcp_conn_send(conn, buf, buf_size);
+		if (rc != EOK) {
+			bench_run_fail(run, "failed sending data: %s (%d)",
+			    str_error(rc), rc);
+			tcp_conn_destroy(conn);
+			return false;
+		}
+
+		if (!conn_recv(run, conn, buf_size) || !conn_close(run, conn)) {
+			tcp_conn_destroy(conn);
+			return false;
+		}
+
+		tcp_conn_destroy(conn);
+	}
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_tcp_stream = {
+	.name = "tcp_stream",
+	.desc = "TCP throughput, one operation sends 'size' bytes (default 16384) to the peer (see 'host' and 'port' params).",
+	.entry = &runner_stream,
+	.setup = &setup_stream,
+	.teardown = &teardown
+};
+
+benchmark_t benchmark_tcp_rr = {
+	.name = "tcp_rr",
+	.desc = "TCP request/response over one connection, 'size' bytes each way (default 1).",
+	.entry = &runner_rr,
+	.setup = &setup_rr,
+	.teardown = &teardown
+};
+
+benchmark_t benchmark_tcp_connect = {
+	.name = "tcp_connect",
+	.desc = "TCP connection setup, one request/response and teardown.",
+	.entry = &runner_connect,
+	.setup = &setup_connect,
+	.teardown = &teardown
+};
+
+/** @}
+ */
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+/**
+ * @file UDP benchmarks.
+ */
+
+#include <errno.h>
+#include <evqueue.h>
+#include <inet/endpoint.h>
+#include <inttypes.h>
+#include <inet/udp.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/** How long to wait for outstanding echoes before counting them lost */
+#define ECHO_TIMEOUT_USEC 200000
+
+/** Maximum message size, so that messages are not fragmented */
+#define MAX_MSG_SIZE 1472
+
+static udp_t *udp = NULL;
+static udp_assoc_t *assoc = NULL;
+static evqueue_t *evq = NULL;
+static udp_smsg_t *msgs = NULL;
+static uint8_t *buf = NULL;
+static size_t msg_size;
+static size_t batch_size;
+
+static bool get_param(bench_env_t *env, bench_run_t *run, const char *name,
+    const char *def, size_t max, size_t *rvalue)
+{
+	const char *param = bench_env_param_get(env, name, def);
+	uint64_t value;
+
+	if (str_uint64_t(param, NULL, 10, true, &value) != EOK ||
+	    value == 0 || value > max)
+		return bench_run_fail(run, "invalid %s '%s'", name, param);
+
+	*rvalue = value;
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	inet_ep2_t epp;
+	errno_t rc;
+
+	if (!get_param(env, run, "size", "64", MAX_MSG_SIZE, &msg_size))
+		return false;
+	if (!get_param(env, run, "batch", "32", 1024, &batch_size))
+		return false;
+
+	inet_ep2_init(&epp);
+	if (!net_peer_ep(env, run, 0, &epp.remote))
+		return false;
+
+	buf = malloc(msg_size);
+	msgs = calloc(batch_size, sizeof(udp_smsg_t));
+	if (buf == NULL || msgs == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	memset(buf, 0x5a, msg_size);
+
+	/* All messages of a batch carry the same data */
+	for (size_t i = 0; i < batch_size; i++) {
+		msgs[i].dest = NULL;
+		msgs[i].data = buf;
+		msgs[i].size = msg_size;
+	}
+
+	rc = udp_create(&udp);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to initialize UDP: %s (%d)",
+		    str_error(rc), rc);
+	}
+
+	/* Without callbacks, received messages are queued for us */
+	rc = udp_assoc_create(udp, &epp, NULL, NULL, &assoc);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed creating association: %s (%d)",
+		    str_error(rc), rc);
+	}
+
+	rc = evqueue_create(&evq);
+	if (rc == EOK)
+		rc = evqueue_add(evq, udp_assoc_evsrc(assoc), EVQUEUE_READ, NULL);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed creating event queue: %s (%d)",
+		    str_error(rc), rc);
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	if (evq != NULL) {
+		if (assoc != NULL)
+			evqueue_remove(udp_assoc_evsrc(assoc));
+		evqueue_destroy(evq);
+	}
+	if (assoc != NULL)
+		udp_assoc_destroy(assoc);
+	udp_destroy(udp);
+	free(msgs);
+	free(buf);
+
+	evq = NULL;
+	assoc = NULL;
+	udp = NULL;
+	msgs = NULL;
+	buf = NULL;
+	return true;
+}
+
+/** Wait for echoes of @a count messages.
+ *
+ * @return Number of echoes that did not arrive in time
+ */
+static size_t recv_echoes(size_t count)
+{
+	evqueue_event_t ev;
+	size_t nevents;
+	size_t size;
+	errno_t rc;
+
+	while (count > 0) {
+		rc = udp_assoc_recv(assoc, buf, msg_size, &size, NULL);
+		if (rc == EOK) {
+			--count;
+			continue;
+		}
+
+		rc = evqueue_wait(evq, &ev, 1, ECHO_TIMEOUT_USEC, &nevents);
+		if (rc == ETIMEOUT)
+			break;
+	}
+
+	return count;
+}
+
+/** Send batches of messages to the echo service and receive the echoes.
+ *
+ * Each operation is one message sent and echoed. Lost messages are not
+ * sent again, but more than one in a hundred fails the run.
+ */
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	uint64_t lost = 0;
+	size_t nsent;
+	size_t n;
+	errno_t rc;
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count += n) {
+		n = min(niter - count, (uint64_t) batch_size);
+
+		nsent = 0;
+		rc = udp_assoc_send_msgs(assoc, msgs, n, &nsent);
+		if (rc != EOK && nsent == 0) {
+			return bench_run_fail(run, "failed sending messages: %s (%d)",
+			    str_error(rc), rc);
+		}
+
+		lost += (n - nsent) + recv_echoes(nsent);
+	}
+
+	bench_run_stop(run);
+
+	if (lost > niter / 100) {
+		return bench_run_fail(run, "%" PRIu64 " of %" PRIu64 " messages lost",
+		    lost, niter);
+	}
+
+	return true;
+}
+
+benchmark_t benchmark_udp_echo = {
+	.name = "udp_echo",
+	.desc = "UDP packet rate, 'batch' messages (default 32) of 'size' bytes (default 64) in flight (see 'host' and 'port' params).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
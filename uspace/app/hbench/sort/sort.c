@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <gsort.h>
+#include <mem.h>
+#include <qsort.h>
+#include <stdlib.h>
+#include <str.h>
+#include "../hbench.h"
+
+/** Prepared input shared by the sorting benchmarks. */
+typedef struct {
+	int *orig;
+	int *data;
+	size_t count;
+} sort_input_t;
+
+/** Prepare the input according to the 'count' and 'pattern' parameters. */
+static bool sort_input_init(bench_env_t *env, bench_run_t *run,
+    sort_input_t *input)
+{
+	const char *count_param = bench_env_param_get(env, "count", "10000");
+	const char *pattern = bench_env_param_get(env, "pattern", "random");
+	uint64_t count;
+
+	if (str_uint64_t(count_param, NULL, 10, true, &count) != EOK ||
+	    count == 0) {
+		return bench_run_fail(run, "invalid element count '%s'",
+		    count_param);
+	}
+
+	input->count = count;
+	input->orig = calloc(count, sizeof(int));
+	input->data = calloc(count, sizeof(int));
+	if (input->orig == NULL || input->data == NULL) {
+		free(input->orig);
+		free(input->data);
+		return bench_run_fail(run, "failed to allocate 2x%zu elements",
+		    input->count);
+	}
+
+	for (size_t i = 0; i < input->count; i++) {
+		if (str_cmp(pattern, "sorted") == 0) {
+			input->orig[i] = i;
+		} else if (str_cmp(pattern, "reversed") == 0) {
+			input->orig[i] = input->count - i;
+		} else if (str_cmp(pattern, "equal") == 0) {
+			input->orig[i] = 0;
+		} else if (str_cmp(pattern, "random") == 0) {
+			input->orig[i] = rand();
+		} else {
+			free(input->orig);
+			free(input->data);
+			return bench_run_fail(run, "unknown pattern '%s'", pattern);
+		}
+	}
+
+	return true;
+}
+
+static void sort_input_fini(sort_input_t *input)
+{
+	free(input->orig);
+	free(input->data);
+}
+
+static int cmp_qsort(const void *a, const void *b)
+{
+	int x = *(const int *) a;
+	int y = *(const int *) b;
+
+	return (x > y) - (x < y);
+}
+
+static int cmp_gsort(void *a, void *b, void *arg)
+{
+	return cmp_qsort(a, b);
+}
+
+static bool runner_qsort(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	sort_input_t input;
+	if (!sort_input_init(env, run, &input))
+		return false;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		memcpy(input.data, input.orig, input.count * sizeof(int));
+		qsort(input.data, input.count, sizeof(int), cmp_qsort);
+	}
+	bench_run_stop(run);
+
+	sort_input_fini(&input);
+	return true;
+}
+
+static bool runner_gsort(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	sort_input_t input;
+	if (!sort_input_init(env, run, &input))
+		return false;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		memcpy(input.data, input.orig, input.count * sizeof(int));
+		if (!gsort(input.data, input.count, sizeof(int), cmp_gsort,
+		    NULL)) {
+			bench_run_stop(run);
+			sort_input_fini(&input);
+			return bench_run_fail(run, "gsort() failed");
+		}
+	}
+	bench_run_stop(run);
+
+	sort_input_fini(&input);
+	return true;
+}
+
+benchmark_t benchmark_qsort = {
+	.name = "qsort",
+	.desc = "Repeatedly sort an array of integers using qsort() (use 'count' and 'pattern' (random, sorted, reversed, equal) params)",
+	.entry = &runner_qsort,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+benchmark_t benchmark_gsort = {
+	.name = "gsort",
+	.desc = "Repeatedly sort an array of integers using gsort() (use 'count' and 'pattern' (random, sorted, reversed, equal) params)",
+	.entry = &runner_gsort,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
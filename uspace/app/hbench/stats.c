@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+/**
+ * @file
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "hbench.h"
+
+/** Two-sided 95% quantiles of Student's t-distribution.
+ *
+ * Indexed by degrees of freedom minus one, larger degrees of freedom use
+ * the normal approximation.
+ */
+static const double t_quantiles[] = {
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+#define T_QUANTILE_NORMAL 1.960
+
+/** Estimate square root value.
+ *
+ * @param value The value to compute square root of.
+ * @param precision Required relative precision (e.g. 0.00001).
+ *
+ * @details
+ *
+ * This is a temporary solution until we have proper sqrt() implementation
+ * in libmath.
+ *
+ * The algorithm uses Babylonian method [1].
+ *
+ * [1] https://en.wikipedia.org/wiki/Methods_of_computing_square_roots#Babylonian_method
+ */
+static double estimate_square_root(double value, double precision)
+{
+	double estimate = 1.;
+	double prev_estimate = estimate + 10 * precision;
+
+	if (value <= 0.)
+		return 0.;
+
+	while (fabs(estimate - prev_estimate) > precision * estimate) {
+		prev_estimate = estimate;
+		estimate = (prev_estimate + value / prev_estimate) / 2.;
+	}
+
+	return estimate;
+}
+
+static double t_quantile(double dof)
+{
+	size_t count = sizeof(t_quantiles) / sizeof(t_quantiles[0]);
+
+	if (dof < 1.)
+		return t_quantiles[0];
+	if (dof > count)
+		return T_QUANTILE_NORMAL;
+
+	/* Round down to stay on the conservative side. */
+	return t_quantiles[(size_t) dof - 1];
+}
+
+static int double_cmp(const void *a, const void *b)
+{
+	double da = *(const double *) a;
+	double db = *(const double *) b;
+
+	if (da < db)
+		return -1;
+	return da > db ? 1 : 0;
+}
+
+/** Get percentile of sorted samples using the nearest-rank method. */
+static double percentile(double *sorted, size_t count, unsigned int pct)
+{
+	size_t rank = (pct * count + 99) / 100;
+	if (rank == 0)
+		rank = 1;
+
+	return sorted[rank - 1];
+}
+
+/** Compute statistics of per-operation cost.
+ *
+ * @param stats Where to store the statistics.
+ * @param nanos Duration of individual runs in nanoseconds per operation.
+ *		The array is sorted in place.
+ * @param cycles CPU cycles per operation of individual runs, can be NULL.
+ * @param count Number of runs (at least one).
+ */
+void bench_stats_compute(bench_stats_t *stats, double *nanos, double *cycles,
+    size_t count)
+{
+	double sum = 0.;
+	double sum2 = 0.;
+	double cycles_sum = 0.;
+
+	for (size_t i = 0; i < count; i++) {
+		sum += nanos[i];
+		sum2 += nanos[i] * nanos[i];
+		if (cycles != NULL)
+			cycles_sum += cycles[i];
+	}
+
+	stats->count = count;
+	stats->mean = sum / count;
+	stats->cycles = cycles_sum / count;
+
+	if (count > 1) {
+		double sigma2 = (sum2 - sum * stats->mean) / ((double) count - 1);
+		// FIXME: implement sqrt properly
+		stats->sigma = estimate_square_root(sigma2, 0.00001);
+		stats->confidence = t_quantile(count - 1) * stats->sigma /
+		    estimate_square_root(count, 0.00001);
+	} else {
+		stats->sigma = NAN;
+		stats->confidence = NAN;
+	}
+
+	qsort(nanos, count, sizeof(double), double_cmp);
+	stats->median = (count % 2 == 1) ? nanos[count / 2] :
+	    (nanos[count / 2 - 1] + nanos[count / 2]) / 2.;
+	stats->p95 = percentile(nanos, count, 95);
+	stats->p99 = percentile(nanos, count, 99);
+}
+
+/** Compare statistics of current runs with baseline.
+ *
+ * The difference of means is tested with Welch's t-test at the 95%
+ * level and must also exceed the given relative threshold to be
+ * reported.
+ *
+ * @param current Statistics of current runs.
+ * @param baseline Statistics of baseline runs.
+ * @param threshold Minimal relative difference (in percent).
+ * @retval 1 Current runs are significantly slower.
+ * @retval -1 Current runs are significantly faster.
+ * @retval 0 No significant difference.
+ */
+int bench_stats_compare(bench_stats_t *current, bench_stats_t *baseline,
+    unsigned int threshold)
+{
+	if (current->count < 2 || baseline->count < 2 || baseline->mean <= 0.)
+		return 0;
+
+	double diff = current->mean - baseline->mean;
+	if (fabs(diff) * 100. < threshold * baseline->mean)
+		return 0;
+
+	double var_cur = current->sigma * current->sigma / current->count;
+	double var_base = baseline->sigma * baseline->sigma / baseline->count;
+	double var = var_cur + var_base;
+
+	if (var > 0.) {
+		/* Welch-Satterthwaite approximation of degrees of freedom. */
+		double dof = var * var /
+		    (var_cur * var_cur / (current->count - 1) +
+		    var_base * var_base / (baseline->count - 1));
+		double t = diff / estimate_square_root(var, 0.00001);
+
+		if (fabs(t) < t_quantile(dof))
+			return 0;
+	}
+
+	return diff > 0. ? 1 : -1;
+}
+
+/** @}
+ */
@@ -33,10 +33,35 @@
  * @file
  */
 
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stats.h>
+#include <stdlib.h>
+#include <str.h>
+#include <task.h>
 #include "hbench.h"
 
+/** Default number of threads of parallel benchmarks. */
+#define DEFAULT_THREAD_COUNT  4
+
+/** Size of the error message buffer of a parallel worker. */
+#define WORKER_ERROR_LENGTH  256
+
+/** Shared state of a parallel benchmark run. */
+typedef struct {
+	benchmark_worker_t worker;
+	uint64_t size;
+	bench_run_t *run;
+	fibril_semaphore_t done;
+	atomic_bool failed;
+} parallel_run_t;
+
+/** Number of runner threads spawned for parallel benchmarks so far. */
+static int runners_spawned = 0;
+
 /** Initialize bench run structure.
  *
  * @param run Structure to intialize.
@@ -46,10 +71,31 @@
 void bench_run_init(bench_run_t *run, char *error_buffer, size_t error_buffer_size)
 {
 	stopwatch_init(&run->stopwatch);
+	run->cycles_start = 0;
+	run->cycles = 0;
 	run->error_message = error_buffer;
 	run->error_message_buffer_size = error_buffer_size;
 }
 
+/** Get number of CPU cycles consumed by the current task so far.
+ *
+ * The value is taken from the kernel task accounting and covers all
+ * threads of the task (both user and kernel cycles).
+ *
+ * @return Number of cycles or zero when the information is not available.
+ */
+uint64_t bench_task_cycles(void)
+{
+	stats_task_t *stats = stats_get_task(task_get_id());
+	if (stats == NULL)
+		return 0;
+
+	uint64_t cycles = stats->ucycles + stats->kcycles;
+	free(stats);
+
+	return cycles;
+}
+
 /** Format error message on benchmark failure.
  *
  * This function always returns false so it can be easily used in benchmark
@@ -75,5 +121,117 @@ bool bench_run_fail(bench_run_t *run, const char *fmt, ...)
 	return false;
 }
 
+/** Get number of threads of multi-threaded benchmarks.
+ *
+ * The number is given by the 'threads' parameter.
+ *
+ * @param env Benchmark environment.
+ * @return Number of threads or zero when the parameter is invalid.
+ */
+int bench_env_threads(bench_env_t *env)
+{
+	const char *threads_str = bench_env_param_get(env, "threads", NULL);
+	int threads = DEFAULT_THREAD_COUNT;
+
+	if (threads_str != NULL)
+		threads = atoi(threads_str);
+
+	return threads > 0 ? threads : 0;
+}
+
+/** Make sure that enough fibril runner threads exist.
+ *
+ * Note that the calling thread is not counted, i.e. to execute @a count
+ * fibrils in parallel with the caller, @a count runners are needed.
+ *
+ * @param count Number of runner threads needed.
+ * @return Whether the runners exist.
+ */
+bool bench_spawn_runners(int count)
+{
+	if (runners_spawned < count) {
+		runners_spawned += fibril_test_spawn_runners(count -
+		    runners_spawned);
+	}
+
+	return runners_spawned >= count;
+}
+
+static errno_t parallel_fibril(void *arg)
+{
+	parallel_run_t *prun = arg;
+	char error_buffer[WORKER_ERROR_LENGTH];
+	bench_run_t run;
+
+	bench_run_init(&run, error_buffer, sizeof(error_buffer));
+
+	if (!prun->worker(&run, prun->size) &&
+	    !atomic_exchange(&prun->failed, true)) {
+		/* Report the first failure only. */
+		str_cpy(prun->run->error_message,
+		    prun->run->error_message_buffer_size, run.error_message);
+	}
+
+	fibril_semaphore_up(&prun->done);
+	return EOK;
+}
+
+/** Run benchmark worker in several threads at once.
+ *
+ * The number of threads is given by the 'threads' parameter. Each
+ * of them executes all @a size iterations, the run is measured from
+ * starting the first worker until all of them finish.
+ *
+ * @param env Benchmark environment.
+ * @param run Current benchmark run.
+ * @param size Number of iterations executed by each worker.
+ * @param worker Worker to execute.
+ * @return Whether all workers succeeded.
+ */
+bool bench_run_parallel(bench_env_t *env, bench_run_t *run, uint64_t size,
+    benchmark_worker_t worker)
+{
+	int threads = bench_env_threads(env);
+	if (threads == 0)
+		return bench_run_fail(run, "invalid number of threads");
+
+	/* The calling thread runs workers as well. */
+	(void) bench_spawn_runners(threads - 1);
+
+	fid_t *fids = calloc(threads, sizeof(fid_t));
+	if (fids == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	parallel_run_t prun = {
+		.worker = worker,
+		.size = size,
+		.run = run
+	};
+	fibril_semaphore_initialize(&prun.done, 0);
+	atomic_store(&prun.failed, false);
+
+	for (int i = 0; i < threads; i++) {
+		fids[i] = fibril_create(parallel_fibril, &prun);
+		if (fids[i] == 0) {
+			for (int j = 0; j < i; j++)
+				fibril_destroy(fids[j]);
+			free(fids);
+			return bench_run_fail(run, "failed to create fibril");
+		}
+	}
+
+	bench_run_start(run);
+
+	for (int i = 0; i < threads; i++)
+		fibril_add_ready(fids[i]);
+	for (int i = 0; i < threads; i++)
+		fibril_semaphore_down(&prun.done);
+
+	bench_run_stop(run);
+
+	free(fids);
+	return !atomic_load(&prun.failed);
+}
+
 /** @}
  */
@@ -34,6 +34,7 @@
  */
 
 #include <fibril.h>
+#include <fibril_synch.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <vfs/vfs.h>
@@ -45,6 +46,7 @@
 #include <str.h>
 #include <loc.h>
 #include <str_error.h>
+#include <time.h>
 #include <config.h>
 #include <io/logctl.h>
 #include <vfs/vfs.h>
@@ -64,6 +66,9 @@
 #define TMPFS_FS_TYPE      "tmpfs"
 #define TMPFS_MOUNT_POINT  "/tmp"
 
+#define PIPEFS_FS_TYPE      "pipefs"
+#define PIPEFS_MOUNT_POINT  "/pipe"
+
 #define SRV_CONSOLE  "/srv/hid/console"
 #define APP_GETTERM  "/app/getterm"
 
@@ -75,6 +80,90 @@
 #define srv_start(path, ...) \
 	srv_startl(path, path, ##__VA_ARGS__, NULL)
 
+/** Maximum number of dependencies of a server */
+#define SRV_DEPS_MAX  4
+
+/** Server started by init */
+typedef struct {
+	/** Path to the server binary */
+	const char *path;
+	/** Argument passed to the server or @c NULL */
+	const char *arg;
+	/** Root file system type the server provides (not started then) */
+	const char *root_fs;
+	/** Paths of servers (in the same table) that must be ready first */
+	const char *deps[SRV_DEPS_MAX];
+} init_srv_t;
+
+/** Servers needed to mount locfs, tmpfs and pipefs */
+static const init_srv_t early_srvs[] = {
+	{ .path = "/srv/fs/tmpfs", .root_fs = "tmpfs" },
+	{ .path = "/srv/fs/exfat", .root_fs = "exfat" },
+	{ .path = "/srv/fs/fat", .root_fs = "fat" },
+	{ .path = "/srv/fs/cdfs" },
+	{ .path = "/srv/fs/mfs" },
+	{ .path = "/srv/klog" },
+	{ .path = "/srv/fs/locfs" },
+	{ .path = "/srv/fs/pipefs" },
+	{ .path = "/srv/taskmon" }
+};
+
+/** Servers started once the file systems are mounted */
+static const init_srv_t srvs[] = {
+	{ .path = "/srv/devman" },
+	{ .path = "/srv/hid/s3c24xx_uart" },
+	{ .path = "/srv/hid/s3c24xx_ts" },
+
+	{ .path = "/srv/bd/vbd" },
+	{ .path = "/srv/volsrv", .deps = { "/srv/bd/vbd" } },
+
+	{ .path = "/srv/net/loopip" },
+	{ .path = "/srv/net/ethip" },
+	{
+		.path = "/srv/net/inetsrv",
+		.deps = { "/srv/net/loopip", "/srv/net/ethip" }
+	},
+	{ .path = "/srv/net/tcp", .deps = { "/srv/net/inetsrv" } },
+	{ .path = "/srv/net/udp", .deps = { "/srv/net/inetsrv" } },
+	{ .path = "/srv/net/dnsrsrv", .deps = { "/srv/net/udp" } },
+	{ .path = "/srv/net/dhcp", .deps = { "/srv/net/udp" } },
+	{
+		.path = "/srv/net/nconfsrv",
+		.deps = { "/srv/net/dhcp", "/srv/net/dnsrsrv" }
+	},
+
+	{ .path = "/srv/clipboard" },
+	{ .path = "/srv/hid/remcons", .deps = { "/srv/net/tcp" } },
+
+	{ .path = "/srv/hid/input", .arg = HID_INPUT },
+	{ .path = "/srv/hid/output", .arg = HID_OUTPUT },
+	{ .path = "/srv/audio/hound" }
+};
+
+/** State of a server start in progress */
+typedef struct {
+	/** Launch the server belongs to */
+	struct srv_launch *launch;
+	/** Server description */
+	const init_srv_t *srv;
+	/** Server is ready (or failed to start) */
+	bool done;
+} srv_state_t;
+
+/** Parallel start of a table of servers */
+typedef struct srv_launch {
+	/** Protects @c done of all servers and @c running */
+	fibril_mutex_t lock;
+	/** Signalled when a server is done */
+	fibril_condvar_t cv;
+	/** State of each server */
+	srv_state_t *state;
+	/** Number of servers */
+	size_t cnt;
+	/** Number of server fibrils which have not finished yet */
+	size_t running;
+} srv_launch_t;
+
 static const char *sys_dirs[] = {
 	"/w/cfg",
 	"/w/data"
@@ -249,6 +338,124 @@ static errno_t srv_startl(const char *path, ...)
 	return retval == 0 ? EOK : EPARTY;
 }
 
+/** Find state of the server with the given path in a launch. */
+static srv_state_t *srv_launch_find(srv_launch_t *launch, const char *path)
+{
+	for (size_t i = 0; i < launch->cnt; i++) {
+		if (str_cmp(launch->state[i].srv->path, path) == 0)
+			return &launch->state[i];
+	}
+
+	return NULL;
+}
+
+/** Start one server once its dependencies are ready. */
+static errno_t srv_launch_fibril(void *arg)
+{
+	srv_state_t *state = (srv_state_t *) arg;
+	srv_launch_t *launch = state->launch;
+	const init_srv_t *srv = state->srv;
+	struct timespec start;
+	struct timespec end;
+	errno_t rc;
+
+	fibril_mutex_lock(&launch->lock);
+
+	for (size_t i = 0; i < SRV_DEPS_MAX && srv->deps[i] != NULL; i++) {
+		srv_state_t *dep = srv_launch_find(launch, srv->deps[i]);
+
+		/* A dependency which failed to start does not stop us. */
+		while (dep != NULL && !dep->done)
+			fibril_condvar_wait(&launch->cv, &launch->lock);
+	}
+
+	fibril_mutex_unlock(&launch->lock);
+
+	getuptime(&start);
+
+	if (srv->arg != NULL)
+		rc = srv_startl(srv->path, srv->path, srv->arg, NULL);
+	else
+		rc = srv_startl(srv->path, srv->path, NULL);
+
+	getuptime(&end);
+
+	if (rc == EOK) {
+		printf("%s: %s ready in %lld ms\n", NAME, srv->path,
+		    NSEC2MSEC(ts_sub_diff(&end, &start)));
+	}
+
+	fibril_mutex_lock(&launch->lock);
+	state->done = true;
+	launch->running--;
+	fibril_condvar_broadcast(&launch->cv);
+	fibril_mutex_unlock(&launch->lock);
+
+	return EOK;
+}
+
+/** Start servers in parallel.
+ *
+ * Each server is started in a fibril of its own as soon as the servers it
+ * depends on are ready. A server is ready when it has set its return value
+ * (see task_retval()). Returns when all servers are ready or have failed.
+ *
+ * @param srv	Table of servers
+ * @param cnt	Number of servers in the table
+ */
+static void srv_start_all(const init_srv_t *srv, size_t cnt)
+{
+	srv_launch_t launch;
+	struct timespec start;
+	struct timespec end;
+
+	launch.state = calloc(cnt, sizeof(srv_state_t));
+	oom_check(launch.state == NULL ? ENOMEM : EOK, srv[0].path);
+
+	fibril_mutex_initialize(&launch.lock);
+	fibril_condvar_initialize(&launch.cv);
+	launch.cnt = cnt;
+	launch.running = 0;
+
+	getuptime(&start);
+
+	for (size_t i = 0; i < cnt; i++) {
+		launch.state[i].launch = &launch;
+		launch.state[i].srv = &srv[i];
+
+		/* Servers providing the root file system are running. */
+		if (srv[i].root_fs != NULL &&
+		    str_cmp(STRING(RDFMT), srv[i].root_fs) == 0) {
+			launch.state[i].done = true;
+			continue;
+		}
+
+		fibril_mutex_lock(&launch.lock);
+		launch.running++;
+		fibril_mutex_unlock(&launch.lock);
+
+		fid_t fid = fibril_create(srv_launch_fibril, &launch.state[i]);
+		if (fid == 0) {
+			/* Start it from here in the worst case. */
+			srv_launch_fibril(&launch.state[i]);
+			continue;
+		}
+
+		fibril_add_ready(fid);
+	}
+
+	fibril_mutex_lock(&launch.lock);
+	while (launch.running > 0)
+		fibril_condvar_wait(&launch.cv, &launch.lock);
+	fibril_mutex_unlock(&launch.lock);
+
+	getuptime(&end);
+	printf("%s: %zu servers started in %lld ms\n", NAME, cnt,
+	    NSEC2MSEC(ts_sub_diff(&end, &start)));
+
+	free(launch.state);
+}
+
 static errno_t console(const char *isvc, const char *osvc)
 {
 	/* Wait for the input service to be ready */
@@ -340,6 +547,14 @@ static bool mount_tmpfs(void)
 	    TMPFS_FS_TYPE, NULL, rc);
 }
 
+static bool mount_pipefs(void)
+{
+	errno_t rc = vfs_mount_path(PIPEFS_MOUNT_POINT, PIPEFS_FS_TYPE, "", "",
+	    0, 0);
+	return mount_report("Pipe file system", PIPEFS_MOUNT_POINT,
+	    PIPEFS_FS_TYPE, NULL, rc);
+}
+
 /** Init system volume.
  *
  * See if system volume is configured. If so, try to wait for it to become
@@ -426,18 +641,7 @@ int main(int argc, char *argv[])
 	}
 
 	/* Make sure file systems are running. */
-	if (str_cmp(STRING(RDFMT), "tmpfs") != 0)
-		srv_start("/srv/fs/tmpfs");
-	if (str_cmp(STRING(RDFMT), "exfat") != 0)
-		srv_start("/srv/fs/exfat");
-	if (str_cmp(STRING(RDFMT), "fat") != 0)
-		srv_start("/srv/fs/fat");
-	srv_start("/srv/fs/cdfs");
-	srv_start("/srv/fs/mfs");
-
-	srv_start("/srv/klog");
-	srv_start("/srv/fs/locfs");
-	srv_start("/srv/taskmon");
+	srv_start_all(early_srvs, ARRAY_SIZE(early_srvs));
 
 	if (!mount_locfs()) {
 		printf("%s: Exiting\n", NAME);
@@ -445,29 +649,9 @@ int main(int argc, char *argv[])
 	}
 
 	mount_tmpfs();
+	mount_pipefs();
 
-	srv_start("/srv/devman");
-	srv_start("/srv/hid/s3c24xx_uart");
-	srv_start("/srv/hid/s3c24xx_ts");
-
-	srv_start("/srv/bd/vbd");
-	srv_start("/srv/volsrv");
-
-	srv_start("/srv/net/loopip");
-	srv_start("/srv/net/ethip");
-	srv_start("/srv/net/inetsrv");
-	srv_start("/srv/net/tcp");
-	srv_start("/srv/net/udp");
-	srv_start("/srv/net/dnsrsrv");
-	srv_start("/srv/net/dhcp");
-	srv_start("/srv/net/nconfsrv");
-
-	srv_start("/srv/clipboard");
-	srv_start("/srv/hid/remcons");
-
-	srv_start("/srv/hid/input", HID_INPUT);
-	srv_start("/srv/hid/output", HID_OUTPUT);
-	srv_start("/srv/audio/hound");
+	srv_start_all(srvs, ARRAY_SIZE(srvs));
 
 	init_sysvol();
 
@@ -34,7 +34,9 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <hound/protocol.h>
 #include <loc.h>
+#include <stdlib.h>
 #include <str_error.h>
 #include <str.h>
 #include <audio_mixer_iface.h>
@@ -125,6 +127,47 @@ static void get_level(async_exch_t *exch, int argc, char *argv[])
 	printf("Control item %u level: %u.\n", item, value);
 }
 
+/**
+ * Print playback statistics of all devices used by the sound server.
+ * @return Exit code.
+ */
+static int print_stats(void)
+{
+	hound_sess_t *sess = hound_service_connect(HOUND_SERVICE);
+	if (!sess) {
+		printf("Failed to connect to the sound server.\n");
+		return 1;
+	}
+
+	char **names = NULL;
+	size_t count = 0;
+	errno_t ret = hound_service_get_list_all(sess, &names, &count,
+	    HOUND_SINK_DEVS);
+	if (ret != EOK) {
+		printf("Failed to get device list: %s.\n", str_error(ret));
+		hound_service_disconnect(sess);
+		return 1;
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		hound_stats_t stats;
+		/* Application sinks have no statistics */
+		ret = hound_service_get_stats(sess, names[i], &stats);
+		if (ret == EOK) {
+			printf("Device `%s': %zu periods, %zu xruns.\n",
+			    names[i], stats.periods, stats.xruns);
+			printf("  period %lld us, latency %lld us, "
+			    "mixing %lld us (max %lld us).\n",
+			    stats.period_usec, stats.latency_usec,
+			    stats.mix_usec_last, stats.mix_usec_max);
+		}
+		free(names[i]);
+	}
+	free(names);
+	hound_service_disconnect(sess);
+	return 0;
+}
+
 int main(int argc, char *argv[])
 {
 	const char *service = DEFAULT_SERVICE;
@@ -142,6 +185,9 @@ int main(int argc, char *argv[])
 			service = argv[1];
 	}
 
+	if (argc == 2 && str_cmp(argv[1], "stats") == 0)
+		return print_stats();
+
 	if ((argc == 2 && command == NULL))
 		service = argv[1];
 
@@ -175,6 +221,8 @@ int main(int argc, char *argv[])
 		    "settings\n", argv[0]);
 		printf("Use '%s setlevel idx' command to change "
 		    "settings\n", argv[0]);
+		printf("Use '%s stats' command to show sound server "
+		    "playback statistics\n", argv[0]);
 	}
 
 	async_exchange_end(exch);
@@ -42,6 +42,7 @@
 #include <stddef.h>
 #include <str.h>
 #include <str_error.h>
+#include <time.h>
 
 #define NAME  "nic"
 
@@ -53,6 +54,9 @@ typedef struct {
 	nic_unicast_mode_t unicast_mode;
 	nic_multicast_mode_t multicast_mode;
 	nic_broadcast_mode_t broadcast_mode;
+	nic_poll_mode_t poll_mode;
+	struct timespec poll_period;
+	nic_device_stats_t stats;
 	int speed;
 } nic_info_t;
 
@@ -69,6 +73,7 @@ static void print_syntax(void)
 	printf("\tunicast <block|default|list|promisc> - set unicast receive filtering\n");
 	printf("\tmulticast <block|list|promisc> - set multicast receive filtering\n");
 	printf("\tbroadcast <block|allow> - block or allow incoming broadcast frames\n");
+	printf("\tpoll <immediate|demand|periodic|software> [<usec>] - set interrupt/poll mode\n");
 }
 
 static async_sess_t *get_nic_by_index(size_t i)
@@ -174,6 +179,20 @@ static errno_t nic_get_info(service_id_t svc_id, char *svc_name,
 		goto error;
 	}
 
+	rc = nic_poll_get_mode(sess, &info->poll_mode, &info->poll_period);
+	if (rc != EOK) {
+		printf("Error getting NIC poll mode.\n");
+		rc = EIO;
+		goto error;
+	}
+
+	rc = nic_get_stats(sess, &info->stats);
+	if (rc != EOK) {
+		printf("Error getting NIC statistics.\n");
+		rc = EIO;
+		goto error;
+	}
+
 	return EOK;
 error:
 	return rc;
@@ -260,6 +279,23 @@ static const char *nic_broadcast_mode_str(nic_broadcast_mode_t mode)
 	}
 }
 
+static const char *nic_poll_mode_str(nic_poll_mode_t mode)
+{
+	switch (mode) {
+	case NIC_POLL_IMMEDIATE:
+		return "immediate";
+	case NIC_POLL_ON_DEMAND:
+		return "on demand";
+	case NIC_POLL_PERIODIC:
+		return "periodic";
+	case NIC_POLL_SOFTWARE_PERIODIC:
+		return "software periodic";
+	default:
+		assert(false);
+		return NULL;
+	}
+}
+
 static char *nic_addr_format(nic_address_t *a)
 {
 	int rc;
@@ -330,6 +366,19 @@ static errno_t nic_list(void)
 		printf("\tBroadcast receive mode: %s\n",
 		    nic_broadcast_mode_str(nic_info.broadcast_mode));
 
+		if (nic_info.poll_mode == NIC_POLL_PERIODIC ||
+		    nic_info.poll_mode == NIC_POLL_SOFTWARE_PERIODIC) {
+			printf("\tPoll mode: %s, %lld us\n",
+			    nic_poll_mode_str(nic_info.poll_mode),
+			    (long long) nic_info.poll_period.tv_sec * 1000000 +
+			    NSEC2USEC(nic_info.poll_period.tv_nsec));
+		} else {
+			printf("\tPoll mode: %s\n",
+			    nic_poll_mode_str(nic_info.poll_mode));
+		}
+		printf("\tInterrupts: %lu, polls: %lu\n",
+		    nic_info.stats.interrupts, nic_info.stats.polls);
+
 		if (nic_info.link_state == NIC_CS_PLUGGED) {
 			printf("\tSpeed: %dMbps %s\n", nic_info.speed,
 			    nic_duplex_mode_str(nic_info.duplex));
@@ -554,6 +603,65 @@ static errno_t nic_set_rx_broadcast(int i, char *str)
 	return EINVAL;
 }
 
+static errno_t nic_set_poll(int i, char *str, char *period_str)
+{
+	async_sess_t *sess;
+	nic_poll_mode_t mode;
+	struct timespec period;
+	uint32_t usec = 0;
+	errno_t rc;
+
+	if (str == NULL) {
+		printf("Poll mode not specified.\n");
+		return EINVAL;
+	}
+
+	if (!str_cmp(str, "immediate")) {
+		mode = NIC_POLL_IMMEDIATE;
+	} else if (!str_cmp(str, "demand")) {
+		mode = NIC_POLL_ON_DEMAND;
+	} else if (!str_cmp(str, "periodic")) {
+		mode = NIC_POLL_PERIODIC;
+	} else if (!str_cmp(str, "software")) {
+		mode = NIC_POLL_SOFTWARE_PERIODIC;
+	} else {
+		printf("Invalid pameter - should be one of: immediate, demand, "
+		    "periodic, software\n");
+		return EINVAL;
+	}
+
+	if (mode == NIC_POLL_PERIODIC || mode == NIC_POLL_SOFTWARE_PERIODIC) {
+		if (period_str == NULL) {
+			printf("Poll period not specified.\n");
+			return EINVAL;
+		}
+
+		rc = str_uint32_t(period_str, NULL, 10, false, &usec);
+		if (rc != EOK || usec == 0) {
+			printf("Poll period must be a positive number of "
+			    "microseconds.\n");
+			return EINVAL;
+		}
+	}
+
+	period.tv_sec = usec / 1000000;
+	period.tv_nsec = USEC2NSEC(usec % 1000000);
+
+	sess = get_nic_by_index(i);
+	if (sess == NULL) {
+		printf("Specified NIC doesn't exist or cannot connect to it.\n");
+		return EINVAL;
+	}
+
+	rc = nic_poll_set_mode(sess, mode, &period);
+	if (rc != EOK) {
+		printf("Error setting poll mode: %s\n", str_error(rc));
+		return rc;
+	}
+
+	return EOK;
+}
+
 int main(int argc, char *argv[])
 {
 	errno_t rc;
@@ -592,6 +700,9 @@ int main(int argc, char *argv[])
 		if (!str_cmp(argv[2], "broadcast"))
 			return nic_set_rx_broadcast(index, argv[3]);
 
+		if (!str_cmp(argv[2], "poll"))
+			return nic_set_poll(index, argv[3], argc > 4 ? argv[4] : NULL);
+
 	} else {
 		printf(NAME ": Invalid argument.\n");
 		print_syntax();
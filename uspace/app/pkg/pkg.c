@@ -104,7 +104,6 @@ static errno_t pkg_install(int argc, char *argv[])
 	char *pkg_name;
 	char *src_uri;
 	char *fname;
-	char *fnunpack;
 	errno_t rc;
 	int ret;
 
@@ -130,12 +129,6 @@ static errno_t pkg_install(int argc, char *argv[])
 		return ENOMEM;
 	}
 
-	ret = asprintf(&fnunpack, "/tmp/%s-for-helenos-" STRING(UARCH) ".tar",
-	    pkg_name);
-	if (ret < 0) {
-		printf("Out of memory.\n");
-		return ENOMEM;
-	}
 	/* XXX error cleanup */
 
 	printf("Downloading '%s'.\n", src_uri);
@@ -149,24 +142,14 @@ static errno_t pkg_install(int argc, char *argv[])
 
 	printf("Extracting package\n");
 
-	rc = cmd_runl("/app/gunzip", "/app/gunzip", fname, fnunpack, NULL);
-	if (rc != EOK) {
-		printf("Error uncompressing package archive.\n");
-		return rc;
-	}
-
-	if (remove(fname) != 0) {
-		printf("Error deleting package archive.\n");
-		return rc;
-	}
-
-	rc = cmd_runl("/app/untar", "/app/untar", fnunpack, NULL);
+	/* untar decompresses the archive on the fly */
+	rc = cmd_runl("/app/untar", "/app/untar", fname, NULL);
 	if (rc != EOK) {
 		printf("Error extracting package archive.\n");
 		return rc;
 	}
 
-	if (remove(fnunpack) != 0) {
+	if (remove(fname) != 0) {
 		printf("Error deleting package archive.\n");
 		return rc;
 	}
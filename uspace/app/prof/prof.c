@@ -0,0 +1,607 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup prof
+ * @{
+ */
+/** @file Sampling profiler.
+ *
+ * Runs the kernel sampling profiler for a given time and prints the
+ * functions where the processors spent the most time. Kernel addresses
+ * are resolved by the kernel, userspace addresses are resolved using the
+ * symbol table of the executable the task was started from.
+ */
+
+#include <adt/hash_table.h>
+#include <errno.h>
+#include <fibril.h>
+#include <inttypes.h>
+#include <prof.h>
+#include <stats.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include <symtab.h>
+#include <time.h>
+
+#define NAME  "prof"
+
+/** Default sampling interval (clock ticks) */
+#define DEFAULT_INTERVAL  1
+
+/** How often samples are moved from the kernel (microseconds) */
+#define READ_PERIOD  100000
+
+/** Number of samples moved from the kernel at once */
+#define READ_CHUNK  256
+
+/** Maximum length of a symbol name */
+#define SYM_BUFLEN  128
+
+/** Number of functions shown in the flat profile */
+#define FLAT_LINES  40
+
+/** Task which appeared in the samples */
+typedef struct {
+	ht_link_t link;
+	task_id_t task_id;
+	char name[TASK_NAME_BUFLEN];
+	/** Symbol table of the executable or NULL if it is not available */
+	symtab_t *symtab;
+} prof_task_t;
+
+/** Function which appeared in the samples */
+typedef struct {
+	ht_link_t link;
+	task_id_t task_id;
+	bool kernel;
+	char *name;
+	/** Samples taken in the function itself */
+	size_t self;
+	/** Samples taken in the function or in its callees */
+	size_t total;
+	/** Sample which last counted this function in total */
+	size_t last;
+} prof_func_t;
+
+/** Call stack which appeared in the samples */
+typedef struct {
+	ht_link_t link;
+	char *stack;
+	size_t count;
+} prof_stack_t;
+
+typedef struct {
+	task_id_t task_id;
+	bool kernel;
+	const char *name;
+} prof_func_key_t;
+
+static prof_sample_t *samples;
+static size_t samples_count;
+static size_t samples_size;
+
+static hash_table_t tasks;
+static hash_table_t funcs;
+static hash_table_t stacks;
+
+static size_t str_hash(const char *str)
+{
+	size_t hash = 0;
+
+	while (*str != '\0')
+		hash = hash * 31 + (uint8_t) *str++;
+
+	return hash;
+}
+
+static size_t tasks_key_hash(const void *key)
+{
+	return *(const task_id_t *) key;
+}
+
+static size_t tasks_hash(const ht_link_t *item)
+{
+	prof_task_t *task = hash_table_get_inst(item, prof_task_t, link);
+	return tasks_key_hash(&task->task_id);
+}
+
+static bool tasks_key_equal(const void *key, const ht_link_t *item)
+{
+	prof_task_t *task = hash_table_get_inst(item, prof_task_t, link);
+	return task->task_id == *(const task_id_t *) key;
+}
+
+static const hash_table_ops_t tasks_ops = {
+	.hash = tasks_hash,
+	.key_hash = tasks_key_hash,
+	.key_equal = tasks_key_equal
+};
+
+static size_t funcs_key_hash(const void *key)
+{
+	const prof_func_key_t *fkey = key;
+	return str_hash(fkey->name) ^ fkey->task_id ^ fkey->kernel;
+}
+
+static size_t funcs_hash(const ht_link_t *item)
+{
+	prof_func_t *func = hash_table_get_inst(item, prof_func_t, link);
+	prof_func_key_t key = {
+		.task_id = func->task_id,
+		.kernel = func->kernel,
+		.name = func->name
+	};
+
+	return funcs_key_hash(&key);
+}
+
+static bool funcs_key_equal(const void *key, const ht_link_t *item)
+{
+	const prof_func_key_t *fkey = key;
+	prof_func_t *func = hash_table_get_inst(item, prof_func_t, link);
+
+	return (func->task_id == fkey->task_id) &&
+	    (func->kernel == fkey->kernel) &&
+	    (str_cmp(func->name, fkey->name) == 0);
+}
+
+static const hash_table_ops_t funcs_ops = {
+	.hash = funcs_hash,
+	.key_hash = funcs_key_hash,
+	.key_equal = funcs_key_equal
+};
+
+static size_t stacks_key_hash(const void *key)
+{
+	return str_hash(key);
+}
+
+static size_t stacks_hash(const ht_link_t *item)
+{
+	prof_stack_t *stack = hash_table_get_inst(item, prof_stack_t, link);
+	return str_hash(stack->stack);
+}
+
+static bool stacks_key_equal(const void *key, const ht_link_t *item)
+{
+	prof_stack_t *stack = hash_table_get_inst(item, prof_stack_t, link);
+	return str_cmp(stack->stack, key) == 0;
+}
+
+static const hash_table_ops_t stacks_ops = {
+	.hash = stacks_hash,
+	.key_hash = stacks_key_hash,
+	.key_equal = stacks_key_equal
+};
+
+static void print_syntax(void)
+{
+	printf("Syntax: %s [-i <ticks>] [-g] <seconds>\n", NAME);
+	printf("\t-i <ticks>  Take a sample every <ticks> clock ticks "
+	    "(default %u)\n", DEFAULT_INTERVAL);
+	printf("\t-g          Print the sampled call stacks in folded "
+	    "format\n");
+}
+
+/** Move the samples taken so far from the kernel
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+static errno_t samples_read(void)
+{
+	while (true) {
+		if (samples_size - samples_count < READ_CHUNK) {
+			size_t size = samples_size + 16 * READ_CHUNK;
+			prof_sample_t *new = realloc(samples,
+			    size * sizeof(prof_sample_t));
+			if (!new)
+				return ENOMEM;
+
+			samples = new;
+			samples_size = size;
+		}
+
+		size_t read;
+		errno_t rc = prof_read(samples + samples_count, READ_CHUNK,
+		    &read);
+		if (rc != EOK)
+			return rc;
+
+		samples_count += read;
+		if (read < READ_CHUNK)
+			return EOK;
+	}
+}
+
+/** Find the task a sample was taken in
+ *
+ * @param task_id Task ID.
+ *
+ * @return Task structure or NULL if out of memory.
+ *
+ */
+static prof_task_t *task_get(task_id_t task_id)
+{
+	ht_link_t *link = hash_table_find(&tasks, &task_id);
+	if (link)
+		return hash_table_get_inst(link, prof_task_t, link);
+
+	prof_task_t *task = calloc(1, sizeof(prof_task_t));
+	if (!task)
+		return NULL;
+
+	task->task_id = task_id;
+	task->symtab = NULL;
+
+	stats_task_t *stats = stats_get_task(task_id);
+	if (stats) {
+		str_cpy(task->name, TASK_NAME_BUFLEN, stats->name);
+		free(stats);
+
+		/* The task name is the path of its executable */
+		if (symtab_load(task->name, &task->symtab) != EOK)
+			task->symtab = NULL;
+	} else
+		snprintf(task->name, TASK_NAME_BUFLEN, "[%" PRIu64 "]", task_id);
+
+	hash_table_insert(&tasks, &task->link);
+	return task;
+}
+
+/** Find the function an address belongs to
+ *
+ * @param task   Task the sample was taken in.
+ * @param kernel The address is a kernel address.
+ * @param pc     Address.
+ *
+ * @return Function structure or NULL if out of memory.
+ *
+ */
+static prof_func_t *func_get(prof_task_t *task, bool kernel, uintptr_t pc)
+{
+	char buf[SYM_BUFLEN];
+	const char *name = NULL;
+	size_t offs;
+
+	if (pc == 0) {
+		/* No interrupted state was recorded */
+		name = "[unknown]";
+	} else if (kernel) {
+		if (prof_symbol(pc, buf, SYM_BUFLEN, &offs) == EOK)
+			name = buf;
+	} else if (task->symtab) {
+		char *sname;
+		if (symtab_addr_to_name(task->symtab, pc, &sname, &offs) == EOK)
+			name = sname;
+	}
+
+	if (!name) {
+		snprintf(buf, SYM_BUFLEN, "%p", (void *) pc);
+		name = buf;
+	}
+
+	prof_func_key_t key = {
+		.task_id = kernel ? 0 : task->task_id,
+		.kernel = kernel,
+		.name = name
+	};
+
+	ht_link_t *link = hash_table_find(&funcs, &key);
+	if (link)
+		return hash_table_get_inst(link, prof_func_t, link);
+
+	prof_func_t *func = calloc(1, sizeof(prof_func_t));
+	if (!func)
+		return NULL;
+
+	func->name = str_dup(name);
+	if (!func->name) {
+		free(func);
+		return NULL;
+	}
+
+	func->task_id = key.task_id;
+	func->kernel = kernel;
+	func->last = (size_t) -1;
+
+	hash_table_insert(&funcs, &func->link);
+	return func;
+}
+
+/** Account a call stack in the folded profile
+ *
+ * @param str Call stack, outermost caller first.
+ *
+ * @return EOK on success or ENOMEM.
+ *
+ */
+static errno_t stack_add(const char *str)
+{
+	ht_link_t *link = hash_table_find(&stacks, str);
+	if (link) {
+		hash_table_get_inst(link, prof_stack_t, link)->count++;
+		return EOK;
+	}
+
+	prof_stack_t *stack = malloc(sizeof(prof_stack_t));
+	if (!stack)
+		return ENOMEM;
+
+	stack->stack = str_dup(str);
+	if (!stack->stack) {
+		free(stack);
+		return ENOMEM;
+	}
+
+	stack->count = 1;
+	hash_table_insert(&stacks, &stack->link);
+	return EOK;
+}
+
+/** Account a sample
+ *
+ * @param idx    Index of the sample.
+ * @param folded Account the call stack in the folded profile.
+ *
+ * @return EOK on success or ENOMEM.
+ *
+ */
+static errno_t sample_add(size_t idx, bool folded)
+{
+	prof_sample_t *sample = &samples[idx];
+	prof_func_t *frames[PROF_STACK_DEPTH];
+	size_t depth;
+
+	prof_task_t *task = task_get(sample->task_id);
+	if (!task)
+		return ENOMEM;
+
+	bool kernel = (sample->flags & PROF_SAMPLE_USPACE) == 0;
+	depth = min(sample->depth, PROF_STACK_DEPTH);
+
+	for (size_t i = 0; i < depth; i++) {
+		frames[i] = func_get(task, kernel, sample->pcs[i]);
+		if (!frames[i])
+			return ENOMEM;
+	}
+
+	if (depth == 0) {
+		/* The thread was not interrupted in an exception */
+		frames[0] = func_get(task, true, 0);
+		if (!frames[0])
+			return ENOMEM;
+
+		depth = 1;
+	}
+
+	frames[0]->self++;
+
+	/* Count recursive functions only once */
+	for (size_t i = 0; i < depth; i++) {
+		if (frames[i]->last != idx) {
+			frames[i]->last = idx;
+			frames[i]->total++;
+		}
+	}
+
+	if (!folded)
+		return EOK;
+
+	size_t size = str_size(task->name) + 1;
+	for (size_t i = 0; i < depth; i++)
+		size += str_size(frames[i]->name) + sizeof("[k];");
+
+	char *str = malloc(size);
+	if (!str)
+		return ENOMEM;
+
+	str_cpy(str, size, task->name);
+	for (size_t i = depth; i > 0; i--) {
+		str_append(str, size, ";");
+		str_append(str, size, frames[i - 1]->name);
+		if (frames[i - 1]->kernel)
+			str_append(str, size, "[k]");
+	}
+
+	errno_t rc = stack_add(str);
+	free(str);
+	return rc;
+}
+
+static bool funcs_collect(ht_link_t *item, void *arg)
+{
+	prof_func_t ***next = arg;
+
+	**next = hash_table_get_inst(item, prof_func_t, link);
+	(*next)++;
+	return true;
+}
+
+static int funcs_cmp(const void *a, const void *b)
+{
+	const prof_func_t *fa = *(prof_func_t *const *) a;
+	const prof_func_t *fb = *(prof_func_t *const *) b;
+
+	if (fa->self != fb->self)
+		return (fa->self < fb->self) ? 1 : -1;
+
+	if (fa->total != fb->total)
+		return (fa->total < fb->total) ? 1 : -1;
+
+	return 0;
+}
+
+static bool stacks_print(ht_link_t *item, void *arg)
+{
+	prof_stack_t *stack = hash_table_get_inst(item, prof_stack_t, link);
+
+	printf("%s %zu\n", stack->stack, stack->count);
+	return true;
+}
+
+/** Print the flat profile
+ *
+ * @param count Number of samples which were not idle.
+ *
+ * @return EOK on success or ENOMEM.
+ *
+ */
+static errno_t print_flat(size_t count)
+{
+	size_t nfuncs = hash_table_size(&funcs);
+	prof_func_t **list = malloc(nfuncs * sizeof(prof_func_t *));
+	if ((!list) && (nfuncs > 0))
+		return ENOMEM;
+
+	prof_func_t **next = list;
+	hash_table_apply(&funcs, funcs_collect, &next);
+	qsort(list, nfuncs, sizeof(prof_func_t *), funcs_cmp);
+
+	printf("%6s %6s %8s %8s %-20s %s\n", "self%", "total%", "self",
+	    "total", "task", "function");
+
+	for (size_t i = 0; (i < nfuncs) && (i < FLAT_LINES); i++) {
+		prof_func_t *func = list[i];
+		const char *task_name = "kernel";
+
+		if (!func->kernel) {
+			prof_task_t *task = task_get(func->task_id);
+			if (task)
+				task_name = task->name;
+		}
+
+		printf("%5zu%% %5zu%% %8zu %8zu %-20s %s\n",
+		    func->self * 100 / count, func->total * 100 / count,
+		    func->self, func->total, task_name, func->name);
+	}
+
+	free(list);
+	return EOK;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t interval = DEFAULT_INTERVAL;
+	bool folded = false;
+	int i = 1;
+
+	while ((i < argc) && (argv[i][0] == '-')) {
+		if (str_cmp(argv[i], "-g") == 0) {
+			folded = true;
+			i++;
+		} else if ((str_cmp(argv[i], "-i") == 0) && (i + 1 < argc)) {
+			if ((str_uint32_t(argv[i + 1], NULL, 10, true,
+			    &interval) != EOK) || (interval == 0)) {
+				printf("%s: Invalid sampling interval '%s'\n",
+				    NAME, argv[i + 1]);
+				return 1;
+			}
+
+			i += 2;
+		} else {
+			print_syntax();
+			return 1;
+		}
+	}
+
+	uint32_t seconds;
+	if ((i + 1 != argc) ||
+	    (str_uint32_t(argv[i], NULL, 10, true, &seconds) != EOK)) {
+		print_syntax();
+		return 1;
+	}
+
+	if ((!hash_table_create(&tasks, 0, 0, &tasks_ops)) ||
+	    (!hash_table_create(&funcs, 0, 0, &funcs_ops)) ||
+	    (!hash_table_create(&stacks, 0, 0, &stacks_ops))) {
+		printf("%s: Out of memory\n", NAME);
+		return 2;
+	}
+
+	errno_t rc = prof_start(interval);
+	if (rc != EOK) {
+		printf("%s: Error starting the profiler: %s\n", NAME,
+		    str_error(rc));
+		return 2;
+	}
+
+	usec_t remaining = SEC2USEC(seconds);
+	while (remaining > 0) {
+		usec_t period = min(remaining, READ_PERIOD);
+
+		fibril_usleep(period);
+		remaining -= period;
+
+		rc = samples_read();
+		if (rc != EOK)
+			break;
+	}
+
+	prof_stop();
+
+	if (rc != EOK) {
+		printf("%s: Error reading samples: %s\n", NAME, str_error(rc));
+		return 2;
+	}
+
+	size_t count = 0;
+	for (size_t idx = 0; idx < samples_count; idx++) {
+		if ((samples[idx].flags & PROF_SAMPLE_IDLE) != 0)
+			continue;
+
+		rc = sample_add(idx, folded);
+		if (rc != EOK) {
+			printf("%s: Out of memory\n", NAME);
+			return 2;
+		}
+
+		count++;
+	}
+
+	printf("%zu samples, %zu idle\n", samples_count,
+	    samples_count - count);
+
+	if (count == 0)
+		return 0;
+
+	if (folded)
+		hash_table_apply(&stacks, stacks_print, NULL);
+	else if (print_flat(count) != EOK) {
+		printf("%s: Out of memory\n", NAME);
+		return 2;
+	}
+
+	return 0;
+}
+
+/** @}
+ */
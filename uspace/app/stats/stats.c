@@ -44,6 +44,7 @@
 #include <stdbool.h>
 #include <str.h>
 #include <arg_parse.h>
+#include <fibril.h>
 
 #define NAME  "stats"
 
@@ -59,6 +60,8 @@ typedef enum {
 	LIST_THREADS,
 	LIST_IPCCS,
 	LIST_CPUS,
+	LIST_SHOOTDOWNS,
+	LIST_IRQS,
 	PRINT_LOAD,
 	PRINT_UPTIME,
 	PRINT_ARCH
@@ -74,7 +77,7 @@ static void list_tasks(void)
 		return;
 	}
 
-	printf("[taskid] [thrds] [resident] [virtual] [ucycles]"
+	printf("[taskid] [thrds] [resident] [virtual] [large] [faults] [ucycles]"
 	    " [kcycles] [name\n");
 
 	for (size_t i = 0; i < count; i++) {
@@ -82,20 +85,24 @@ static void list_tasks(void)
 		uint64_t virtmem;
 		uint64_t ucycles;
 		uint64_t kcycles;
+		uint64_t faults;
 		const char *resmem_suffix;
 		const char *virtmem_suffix;
 		char usuffix;
 		char ksuffix;
+		char fsuffix;
 
 		bin_order_suffix(stats_tasks[i].resmem, &resmem, &resmem_suffix, true);
 		bin_order_suffix(stats_tasks[i].virtmem, &virtmem, &virtmem_suffix, true);
 		order_suffix(stats_tasks[i].ucycles, &ucycles, &usuffix);
 		order_suffix(stats_tasks[i].kcycles, &kcycles, &ksuffix);
+		order_suffix(stats_tasks[i].page_faults, &faults, &fsuffix);
 
-		printf("%-8" PRIu64 " %7zu %7" PRIu64 "%s %6" PRIu64 "%s"
-		    " %8" PRIu64 "%c %8" PRIu64 "%c %s\n",
+		printf("%-8" PRIu64 " %7zu %7" PRIu64 "%s %6" PRIu64 "%s %7zu"
+		    " %7" PRIu64 "%c %8" PRIu64 "%c %8" PRIu64 "%c %s\n",
 		    stats_tasks[i].task_id, stats_tasks[i].threads,
 		    resmem, resmem_suffix, virtmem, virtmem_suffix,
+		    stats_tasks[i].large_pages, faults, fsuffix,
 		    ucycles, usuffix, kcycles, ksuffix, stats_tasks[i].name);
 	}
 
@@ -172,20 +179,31 @@ static void list_cpus(void)
 		return;
 	}
 
-	printf("[id] [MHz     ] [busy cycles] [idle cycles]\n");
+	printf("[id] [MHz     ] [busy cycles] [idle cycles] [sched count]"
+	    " [cycles/sched] [steals] [failed] [migrations]"
+	    " [tick stops]\n");
 
 	for (size_t i = 0; i < count; i++) {
 		printf("%-4u ", cpus[i].id);
 		if (cpus[i].active) {
-			uint64_t bcycles, icycles;
-			char bsuffix, isuffix;
+			uint64_t bcycles, icycles, scount;
+			char bsuffix, isuffix, ssuffix;
 
 			order_suffix(cpus[i].busy_cycles, &bcycles, &bsuffix);
 			order_suffix(cpus[i].idle_cycles, &icycles, &isuffix);
+			order_suffix(cpus[i].sched_count, &scount, &ssuffix);
 
-			printf("%10" PRIu16 " %12" PRIu64 "%c %12" PRIu64 "%c\n",
+			uint64_t scycles = 0;
+			if (cpus[i].sched_count > 0)
+				scycles = cpus[i].sched_cycles / cpus[i].sched_count;
+
+			printf("%10" PRIu16 " %12" PRIu64 "%c %12" PRIu64 "%c"
+			    " %12" PRIu64 "%c %14" PRIu64 " %8" PRIu64
+			    " %8" PRIu64 " %12" PRIu64 " %12" PRIu64 "\n",
 			    cpus[i].frequency_mhz, bcycles, bsuffix,
-			    icycles, isuffix);
+			    icycles, isuffix, scount, ssuffix, scycles,
+			    cpus[i].steals, cpus[i].steals_failed,
+			    cpus[i].migrations, cpus[i].tick_stops);
 		} else
 			printf("inactive\n");
 	}
@@ -193,6 +211,90 @@ static void list_cpus(void)
 	free(cpus);
 }
 
+static void list_shootdowns(void)
+{
+	size_t count;
+	stats_cpu_t *cpus = stats_get_cpus(&count);
+
+	if (cpus == NULL) {
+		fprintf(stderr, "%s: Unable to get CPU statistics\n", NAME);
+		return;
+	}
+
+	printf("[id] [shootdowns] [IPIs     ] [lazy     ]"
+	    " [latency histogram in cycles: <1K <4K <16K <64K <256K <1M"
+	    " <4M >=4M]\n");
+
+	for (size_t i = 0; i < count; i++) {
+		printf("%-4u ", cpus[i].id);
+		if (!cpus[i].active) {
+			printf("inactive\n");
+			continue;
+		}
+
+		printf("%12" PRIu64 " %11" PRIu64 " %11" PRIu64,
+		    cpus[i].tlb_shootdowns, cpus[i].tlb_ipis, cpus[i].tlb_lazy);
+
+		for (size_t j = 0; j < STATS_TLB_LATENCY_BUCKETS; j++)
+			printf(" %" PRIu64, cpus[i].tlb_latency[j]);
+
+		printf("\n");
+	}
+
+	free(cpus);
+}
+
+static void list_irqs(void)
+{
+	size_t count;
+	stats_irq_t *before = stats_get_irqs(&count);
+
+	if (before == NULL) {
+		fprintf(stderr, "%s: Unable to get IRQ statistics\n", NAME);
+		return;
+	}
+
+	/* Sample again to compute the interrupt rate */
+	fibril_sleep(1);
+
+	size_t count_after;
+	stats_irq_t *after = stats_get_irqs(&count_after);
+
+	if (after == NULL) {
+		fprintf(stderr, "%s: Unable to get IRQ statistics\n", NAME);
+		free(before);
+		return;
+	}
+
+	printf("[task    ] [inr] [cpu] [count     ] [rate/s  ] [coalesced ]"
+	    " [dropped ]\n");
+
+	for (size_t i = 0; i < count_after; i++) {
+		uint64_t rate = 0;
+		for (size_t j = 0; j < count; j++) {
+			if ((before[j].task == after[i].task) &&
+			    (before[j].inr == after[i].inr)) {
+				rate = after[i].count - before[j].count;
+				break;
+			}
+		}
+
+		printf("%-10" PRIu64 " %5d ", after[i].task, after[i].inr);
+
+		if (after[i].cpu == IRQ_CPU_ANY)
+			printf("%5s ", "any");
+		else
+			printf("%5u ", after[i].cpu);
+
+		printf("%12" PRIu64 " %10" PRIu64 " %12" PRIu64 " %10" PRIu64
+		    "\n", after[i].count, rate, after[i].coalesced,
+		    after[i].dropped);
+	}
+
+	free(before);
+	free(after);
+}
+
 static void print_load(void)
 {
 	size_t count;
@@ -367,7 +469,8 @@ static void print_arch(void)
 static void usage(const char *name)
 {
 	printf(
-	    "Usage: %s [-t task_id] [-i task_id] [-at] [-ai] [-c] [-l] [-u] [-d]\n"
+	    "Usage: %s [-t task_id] [-i task_id] [-at] [-ai] [-c] [-s] [-r]"
+	    " [-l] [-u] [-d]\n"
 	    "\n"
 	    "Options:\n"
 	    "\t-t task_id | --task=task_id\n"
@@ -385,6 +488,12 @@ static void usage(const char *name)
 	    "\t-c | --cpus\n"
 	    "\t\tList CPUs\n"
 	    "\n"
+	    "\t-s | --shootdowns\n"
+	    "\t\tList TLB shootdown statistics of CPUs\n"
+	    "\n"
+	    "\t-r | --irqs\n"
+	    "\t\tList IRQ subscriptions and their interrupt rates\n"
+	    "\n"
 	    "\t-l | --load\n"
 	    "\t\tPrint system load\n"
 	    "\n"
@@ -468,6 +577,18 @@ int main(int argc, char *argv[])
 			continue;
 		}
 
+		/* TLB shootdowns */
+		if ((off = arg_parse_short_long(argv[i], "-s", "--shootdowns")) != -1) {
+			output_toggle = LIST_SHOOTDOWNS;
+			continue;
+		}
+
+		/* IRQs */
+		if ((off = arg_parse_short_long(argv[i], "-r", "--irqs")) != -1) {
+			output_toggle = LIST_IRQS;
+			continue;
+		}
+
 		/* Load */
 		if ((off = arg_parse_short_long(argv[i], "-l", "--load")) != -1) {
 			output_toggle = PRINT_LOAD;
@@ -500,6 +621,12 @@ int main(int argc, char *argv[])
 	case LIST_CPUS:
 		list_cpus();
 		break;
+	case LIST_SHOOTDOWNS:
+		list_shootdowns();
+		break;
+	case LIST_IRQS:
+		list_irqs();
+		break;
 	case PRINT_LOAD:
 		print_load();
 		break;
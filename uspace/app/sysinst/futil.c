@@ -43,9 +43,12 @@
 
 #include "futil.h"
 
-#define BUF_SIZE 16384
+#define BUF_SIZE 65536
 static char buf[BUF_SIZE];
 
+/** Number of bytes copied by futil_copy_file() */
+static uint64_t futil_copied;
+
 /** Copy file.
  *
  * @param srcp Source path
@@ -59,6 +62,7 @@ errno_t futil_copy_file(const char *srcp, const char *destp)
 	size_t nr, nw;
 	errno_t rc;
 	aoff64_t posr = 0, posw = 0;
+	vfs_stat_t st;
 
 	printf("Copy '%s' to '%s'.\n", srcp, destp);
 
@@ -67,8 +71,19 @@ errno_t futil_copy_file(const char *srcp, const char *destp)
 		return EIO;
 
 	rc = vfs_lookup_open(destp, WALK_REGULAR | WALK_MAY_CREATE, MODE_WRITE, &df);
-	if (rc != EOK)
+	if (rc != EOK) {
+		vfs_put(sf);
 		return EIO;
+	}
+
+	/* Allocate the destination file at once */
+	rc = vfs_stat(sf, &st);
+	if (rc != EOK)
+		goto error;
+
+	rc = vfs_resize(df, st.size);
+	if (rc != EOK)
+		goto error;
 
 	do {
 		rc = vfs_read(sf, &posr, buf, BUF_SIZE, &nr);
@@ -81,6 +96,7 @@ errno_t futil_copy_file(const char *srcp, const char *destp)
 		if (rc != EOK)
 			goto error;
 
+		futil_copied += nw;
 	} while (nr == BUF_SIZE);
 
 	(void) vfs_put(sf);
@@ -148,6 +164,15 @@ errno_t futil_rcopy_contents(const char *srcdir, const char *destdir)
 	return EOK;
 }
 
+/** Return number of bytes copied so far.
+ *
+ * @return Total size of data copied by futil_copy_file()
+ */
+uint64_t futil_get_copied(void)
+{
+	return futil_copied;
+}
+
 /** Return file contents as a heap-allocated block of bytes.
  *
  * @param srcp File path
@@ -39,9 +39,11 @@
 
 #include <ipc/loc.h>
 #include <stddef.h>
+#include <stdint.h>
 
 extern errno_t futil_copy_file(const char *, const char *);
 extern errno_t futil_rcopy_contents(const char *, const char *);
+extern uint64_t futil_get_copied(void);
 extern errno_t futil_get_file(const char *, void **, size_t *);
 
 #endif
@@ -40,11 +40,13 @@
 #include <capa.h>
 #include <errno.h>
 #include <fdisk.h>
+#include <inttypes.h>
 #include <loc.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
 #include <str_error.h>
+#include <time.h>
 #include <vfs/vfs.h>
 #include <vol.h>
 
@@ -212,13 +214,24 @@ error:
  */
 static errno_t sysinst_copy_boot_files(void)
 {
+	struct timespec start, end;
+	uint64_t copied;
+	uint64_t msec;
 	errno_t rc;
 
 	printf("sysinst_copy_boot_files(): copy bootloader files\n");
+	getuptime(&start);
 	rc = futil_rcopy_contents(BOOT_FILES_SRC, MOUNT_POINT);
 	if (rc != EOK)
 		return rc;
 
+	getuptime(&end);
+	copied = futil_get_copied();
+	msec = NSEC2MSEC(ts_sub_diff(&end, &start));
+
+	printf("sysinst_copy_boot_files(): copied %" PRIu64 " KiB in %"
+	    PRIu64 " ms (%" PRIu64 " KiB/s)\n", copied / 1024, msec,
+	    msec > 0 ? copied * 1000 / 1024 / msec : 0);
 	printf("sysinst_copy_boot_files(): OK\n");
 	return EOK;
 }
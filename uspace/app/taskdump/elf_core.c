@@ -46,14 +46,19 @@
  * with zeroes).
  */
 
+#include <adt/checksum.h>
 #include <align.h>
+#include <assert.h>
+#include <deflate.h>
 #include <elf/elf.h>
 #include <elf/elf_linux.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stddef.h>
 #include <errno.h>
+#include <gzip.h>
 #include <str_error.h>
 #include <mem.h>
 #include <as.h>
@@ -65,18 +70,44 @@
 
 #include "elf_core.h"
 
+/** Core file output */
+typedef struct {
+	/** File descriptor */
+	int fd;
+	/** Position in the file */
+	aoff64_t pos;
+	/** Amount of core image data written so far */
+	aoff64_t cpos;
+	/** Deflate state or @c NULL if the core file is not compressed */
+	deflate_t *deflate;
+	/** CRC32 of the core image written so far */
+	uint32_t crc;
+} core_out_t;
+
 static off64_t align_foff_up(off64_t, uintptr_t, size_t);
-static errno_t write_mem_area(int, aoff64_t *, as_area_info_t *, async_sess_t *);
+static errno_t core_out_write(core_out_t *, aoff64_t, const void *, size_t);
+static errno_t write_mem_area(core_out_t *, aoff64_t, as_area_info_t *,
+    const void *, async_sess_t *);
 
-#define BUFFER_SIZE 0x1000
+#define BUFFER_SIZE 0x10000
 static uint8_t buffer[BUFFER_SIZE];
+static uint8_t out_buffer[BUFFER_SIZE];
+static const uint8_t zeros[PAGE_SIZE];
 
 /** Save ELF core file.
+ *
+ * The contents of the memory areas are taken from @a snapshot where
+ * available and read from the task through @a sess otherwise.
  *
  * @param file_name Name of file to save to.
  * @param ainfo     Array of @a n memory area info structures.
  * @param n         Number of memory areas.
- * @param sess      Debugging session.
+ * @param snapshot  NULL or array of @a n local copies of the memory areas
+ *                  (entries may be NULL).
+ * @param sess      Debugging session (only used for areas without a
+ *                  snapshot).
+ * @param istate    Register state to store in the core file.
+ * @param compress  Write the core file in GZIP format.
  *
  * @return EOK on sucess.
  * @return ENOENT if file cannot be created.
@@ -84,8 +115,9 @@ static uint8_t buffer[BUFFER_SIZE];
  * @return EIO on write error.
  *
  */
-errno_t elf_core_save(const char *file_name, as_area_info_t *ainfo, unsigned int n,
-    async_sess_t *sess, istate_t *istate)
+errno_t elf_core_save(const char *file_name, as_area_info_t *ainfo,
+    unsigned int n, void **snapshot, async_sess_t *sess, istate_t *istate,
+    bool compress)
 {
 	elf_header_t elf_hdr;
 	off64_t foff;
@@ -96,6 +128,8 @@ errno_t elf_core_save(const char *file_name, as_area_info_t *ainfo, unsigned int
 	elf_note_t note;
 	size_t word_size;
 	aoff64_t pos = 0;
+	core_out_t out;
+	uint8_t footer[GZIP_FOOTER_SIZE];
 
 	int fd;
 	errno_t rc;
@@ -124,14 +158,38 @@ errno_t elf_core_save(const char *file_name, as_area_info_t *ainfo, unsigned int
 		return ENOMEM;
 	}
 
+	memset(&out, 0, sizeof(out));
+	if (compress) {
+		rc = deflate_init(&out.deflate, DEFLATE_LEVEL_DEFAULT);
+		if (rc != EOK) {
+			printf("Failed allocating memory.\n");
+			free(p_hdr);
+			return ENOMEM;
+		}
+	}
+
 	rc = vfs_lookup_open(file_name, WALK_REGULAR | WALK_MAY_CREATE,
 	    MODE_WRITE, &fd);
 	if (rc != EOK) {
 		printf("Failed opening file '%s': %s.\n", file_name, str_error(rc));
+		if (out.deflate != NULL)
+			deflate_destroy(out.deflate);
 		free(p_hdr);
 		return ENOENT;
 	}
 
+	out.fd = fd;
+
+	if (compress) {
+		gzip_header_write(out_buffer);
+		rc = vfs_write(fd, &out.pos, out_buffer, GZIP_HEADER_SIZE,
+		    &nwr);
+		if (rc != EOK) {
+			printf("Failed writing GZIP header.\n");
+			goto error;
+		}
+	}
+
 	/*
 	 * File layout:
 	 *
@@ -208,20 +266,22 @@ errno_t elf_core_save(const char *file_name, as_area_info_t *ainfo, unsigned int
 		foff += ainfo[i].size;
 	}
 
-	rc = vfs_write(fd, &pos, &elf_hdr, sizeof(elf_hdr), &nwr);
+	rc = core_out_write(&out, pos, &elf_hdr, sizeof(elf_hdr));
 	if (rc != EOK) {
 		printf("Failed writing ELF header.\n");
-		free(p_hdr);
-		return EIO;
+		goto error;
 	}
 
+	pos += sizeof(elf_hdr);
+
 	for (i = 0; i < n_ph; ++i) {
-		rc = vfs_write(fd, &pos, &p_hdr[i], sizeof(p_hdr[i]), &nwr);
+		rc = core_out_write(&out, pos, &p_hdr[i], sizeof(p_hdr[i]));
 		if (rc != EOK) {
 			printf("Failed writing program header.\n");
-			free(p_hdr);
-			return EIO;
+			goto error;
 		}
+
+		pos += sizeof(p_hdr[i]);
 	}
 
 	pos = p_hdr[0].p_offset;
@@ -233,41 +293,64 @@ errno_t elf_core_save(const char *file_name, as_area_info_t *ainfo, unsigned int
 	note.descsz = sizeof(elf_prstatus_t);
 	note.type = NT_PRSTATUS;
 
-	rc = vfs_write(fd, &pos, &note, sizeof(elf_note_t), &nwr);
+	rc = core_out_write(&out, pos, &note, sizeof(elf_note_t));
 	if (rc != EOK) {
 		printf("Failed writing note header.\n");
-		free(p_hdr);
-		return EIO;
+		goto error;
 	}
 
-	rc = vfs_write(fd, &pos, "CORE", note.namesz, &nwr);
+	pos += sizeof(elf_note_t);
+
+	rc = core_out_write(&out, pos, "CORE", note.namesz);
 	if (rc != EOK) {
 		printf("Failed writing note header.\n");
-		free(p_hdr);
-		return EIO;
+		goto error;
 	}
 
-	pos = ALIGN_UP(pos, word_size);
+	pos = ALIGN_UP(pos + note.namesz, word_size);
 
-	rc = vfs_write(fd, &pos, &pr_status, sizeof(elf_prstatus_t), &nwr);
+	rc = core_out_write(&out, pos, &pr_status, sizeof(elf_prstatus_t));
 	if (rc != EOK) {
 		printf("Failed writing register data.\n");
-		free(p_hdr);
-		return EIO;
+		goto error;
 	}
 
 	for (i = 1; i < n_ph; ++i) {
-		pos = p_hdr[i].p_offset;
-		if (write_mem_area(fd, &pos, &ainfo[i - 1], sess) != EOK) {
+		rc = write_mem_area(&out, p_hdr[i].p_offset, &ainfo[i - 1],
+		    snapshot != NULL ? snapshot[i - 1] : NULL, sess);
+		if (rc != EOK) {
 			printf("Failed writing memory data.\n");
-			free(p_hdr);
-			return EIO;
+			goto error;
 		}
 	}
 
+	if (compress) {
+		rc = core_out_write(&out, out.cpos, NULL, 0);
+		if (rc != EOK) {
+			printf("Failed writing compressed data.\n");
+			goto error;
+		}
+
+		gzip_footer_write(footer, out.crc, (uint32_t) out.cpos);
+		rc = vfs_write(fd, &out.pos, footer, sizeof(footer), &nwr);
+		if (rc != EOK) {
+			printf("Failed writing GZIP footer.\n");
+			goto error;
+		}
+
+		deflate_destroy(out.deflate);
+	}
+
+	vfs_put(fd);
 	free(p_hdr);
 
 	return EOK;
+error:
+	if (out.deflate != NULL)
+		deflate_destroy(out.deflate);
+	vfs_put(fd);
+	free(p_hdr);
+	return EIO;
 }
 
 /** Align file offset up to be congruent with vaddr modulo page size. */
@@ -282,24 +365,118 @@ static off64_t align_foff_up(off64_t foff, uintptr_t vaddr, size_t page_size)
 	return (foff + (page_size + (rva - rfo)));
 }
 
+/** Compress data and write it to the core file.
+ *
+ * @param out    Core file output.
+ * @param data   Data to compress.
+ * @param size   Size of @a data in bytes.
+ * @param finish Terminate the compressed stream.
+ *
+ * @return EOK on success, EIO on failure.
+ *
+ */
+static errno_t core_out_deflate(core_out_t *out, const void *data,
+    size_t size, bool finish)
+{
+	const uint8_t *src = data;
+	size_t consumed;
+	size_t produced;
+	size_t nwr;
+	errno_t rc;
+	errno_t wrc;
+
+	do {
+		rc = deflate_step(out->deflate, src, size, &consumed,
+		    out_buffer, BUFFER_SIZE, &produced, finish);
+
+		wrc = vfs_write(out->fd, &out->pos, out_buffer, produced,
+		    &nwr);
+		if (wrc != EOK)
+			return EIO;
+
+		src += consumed;
+		size -= consumed;
+	} while (rc == EAGAIN && (size > 0 || finish));
+
+	return EOK;
+}
+
+/** Write data to the core file.
+ *
+ * Data must be written in order of increasing offsets. The gaps between
+ * them are left unwritten in plain core files and filled with zeroes in
+ * compressed ones.
+ *
+ * @param out  Core file output.
+ * @param off  Offset in the core image.
+ * @param data Data to write.
+ * @param size Size of @a data in bytes. Writing zero bytes at the end of
+ *             the image terminates a compressed stream.
+ *
+ * @return EOK on success, EIO on failure.
+ *
+ */
+static errno_t core_out_write(core_out_t *out, aoff64_t off, const void *data,
+    size_t size)
+{
+	size_t nwr;
+	size_t n;
+	errno_t rc;
+
+	assert(off >= out->cpos);
+
+	if (out->deflate == NULL) {
+		aoff64_t pos = off;
+
+		rc = vfs_write(out->fd, &pos, data, size, &nwr);
+		if (rc != EOK)
+			return EIO;
+
+		out->cpos = off + size;
+		return EOK;
+	}
+
+	while (out->cpos < off) {
+		n = min(off - out->cpos, sizeof(zeros));
+		rc = core_out_deflate(out, zeros, n, false);
+		if (rc != EOK)
+			return rc;
+
+		out->crc = compute_crc32_seed((uint8_t *) zeros, n, out->crc);
+		out->cpos += n;
+	}
+
+	rc = core_out_deflate(out, data, size, size == 0);
+	if (rc != EOK)
+		return rc;
+
+	if (size > 0)
+		out->crc = compute_crc32_seed((uint8_t *) data, size, out->crc);
+	out->cpos += size;
+	return EOK;
+}
+
 /** Write memory area from application to core file.
  *
- * @param fd   File to write to.
- * @param pos  Pointer to the position to write to.
- * @param area Memory area info structure.
- * @param sess Debugging session.
+ * @param out      Core file output.
+ * @param off      Offset to write to.
+ * @param area     Memory area info structure.
+ * @param snapshot NULL or local copy of the memory area.
+ * @param sess     Debugging session.
  *
  * @return EOK on success, EIO on failure.
  *
  */
-static errno_t write_mem_area(int fd, aoff64_t *pos, as_area_info_t *area,
-    async_sess_t *sess)
+static errno_t write_mem_area(core_out_t *out, aoff64_t off,
+    as_area_info_t *area, const void *snapshot, async_sess_t *sess)
 {
 	size_t to_copy;
 	size_t total;
 	uintptr_t addr;
 	errno_t rc;
-	size_t nwr;
+
+	if (snapshot != NULL)
+		return core_out_write(out, off, snapshot, area->size);
 
 	addr = area->start_addr;
 	total = 0;
@@ -312,7 +489,7 @@ static errno_t write_mem_area(int fd, aoff64_t *pos, as_area_info_t *area,
 			return EIO;
 		}
 
-		rc = vfs_write(fd, pos, buffer, to_copy, &nwr);
+		rc = core_out_write(out, off + total, buffer, to_copy);
 		if (rc != EOK) {
 			printf("Failed writing memory contents.\n");
 			return EIO;
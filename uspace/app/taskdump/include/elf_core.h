@@ -38,9 +38,10 @@
 #include <async.h>
 #include <elf/elf_linux.h>
 #include <libarch/istate.h>
+#include <stdbool.h>
 
 extern errno_t elf_core_save(const char *, as_area_info_t *, unsigned int,
-    async_sess_t *, istate_t *);
+    void **, async_sess_t *, istate_t *, bool);
 
 #endif
 
@@ -60,16 +60,27 @@
 static async_sess_t *sess;
 static task_id_t task_id;
 static bool write_core_file;
+static bool compress_core_file;
 static char *core_file_name;
 static char *app_name;
 static symtab_t *app_symtab;
 
+/** Areas to store in the core file */
+static as_area_info_t *core_areas;
+static size_t core_n_areas;
+/** Snapshots of the areas (entries are NULL where none could be taken) */
+static void **core_snapshot;
+static bool core_snapshot_complete;
+
 static errno_t connect_task(task_id_t task_id);
 static int parse_args(int argc, char *argv[]);
 static void print_syntax(void);
 static errno_t threads_dump(void);
 static errno_t thread_dump(uintptr_t thash);
 static errno_t areas_dump(void);
+static void core_snapshot_take(void);
+static void core_snapshot_free(void);
+static void core_file_write(void);
 static errno_t td_read_uintptr(void *arg, uintptr_t addr, uintptr_t *value);
 
 static void autoload_syms(void);
@@ -88,6 +99,7 @@ int main(int argc, char *argv[])
 
 	printf("Task Dump Utility\n");
 	write_core_file = false;
+	compress_core_file = false;
 
 	if (parse_args(argc, argv) < 0)
 		return 1;
@@ -117,9 +129,20 @@ int main(int argc, char *argv[])
 	if (rc != EOK)
 		printf("Failed dumping fibrils.\n");
 
+	/*
+	 * Areas without a snapshot are read from the task while writing
+	 * the core file. Otherwise the task can be released first.
+	 */
+	if (write_core_file && !core_snapshot_complete)
+		core_file_write();
+
 	udebug_end(sess);
 	async_hangup(sess);
 
+	if (write_core_file && core_snapshot_complete)
+		core_file_write();
+
+	core_snapshot_free();
 	return 0;
 }
 
@@ -181,6 +204,8 @@ static int parse_args(int argc, char *argv[])
 				--argc;
 				++argv;
 				core_file_name = *argv;
+			} else if (arg[1] == 'z' && arg[2] == '\0') {
+				compress_core_file = true;
 			} else {
 				printf("Uknown option '%c'\n", arg[0]);
 				print_syntax();
@@ -211,8 +236,9 @@ static int parse_args(int argc, char *argv[])
 
 static void print_syntax(void)
 {
-	printf("Syntax: taskdump [-c <core_file>] -t <task_id>\n");
+	printf("Syntax: taskdump [-c <core_file> [-z]] -t <task_id>\n");
 	printf("\t-c <core_file_id>\tName of core file to write.\n");
+	printf("\t-z\tCompress the core file with gzip.\n");
 	printf("\t-t <task_id>\tWhich task to dump.\n");
 }
 
@@ -310,20 +336,74 @@ static errno_t areas_dump(void)
 	putchar('\n');
 
 	if (write_core_file) {
-		printf("Writing core file '%s'\n", core_file_name);
+		core_areas = ainfo_buf;
+		core_n_areas = n_areas;
+		core_snapshot_take();
+	} else {
+		free(ainfo_buf);
+	}
+
+	return 0;
+}
 
-		rc = elf_core_save(core_file_name, ainfo_buf, n_areas, sess,
-		    &reg_state);
+/** Take snapshots of the areas to be stored in the core file.
+ *
+ * The kernel copies each area and maps the copy in our address space,
+ * which is much faster than reading it piece by piece and lets us
+ * release the task before writing the core file.
+ */
+static void core_snapshot_take(void)
+{
+	size_t i;
+	errno_t rc;
+
+	core_snapshot = calloc(core_n_areas, sizeof(void *));
+	if (core_snapshot == NULL)
+		return;
 
+	core_snapshot_complete = true;
+	for (i = 0; i < core_n_areas; i++) {
+		rc = udebug_mem_snapshot(sess, core_areas[i].start_addr,
+		    core_areas[i].size, &core_snapshot[i]);
 		if (rc != EOK) {
-			printf("Failed writing core file.\n");
-			return EIO;
+			core_snapshot[i] = NULL;
+			core_snapshot_complete = false;
+		}
+	}
+}
+
+/** Unmap the snapshots and free the area list. */
+static void core_snapshot_free(void)
+{
+	size_t i;
+
+	if (core_snapshot != NULL) {
+		for (i = 0; i < core_n_areas; i++) {
+			if (core_snapshot[i] != NULL)
+				as_area_destroy(core_snapshot[i]);
 		}
+
+		free(core_snapshot);
+		core_snapshot = NULL;
 	}
 
-	free(ainfo_buf);
+	free(core_areas);
+	core_areas = NULL;
+}
+
+static void core_file_write(void)
+{
+	errno_t rc;
 
-	return 0;
+	if (core_areas == NULL)
+		return;
+
+	printf("Writing core file '%s'\n", core_file_name);
+
+	rc = elf_core_save(core_file_name, core_areas, core_n_areas,
+	    core_snapshot, sess, &reg_state, compress_core_file);
+	if (rc != EOK)
+		printf("Failed writing core file.\n");
 }
 
 errno_t td_stacktrace(uintptr_t fp, uintptr_t pc)
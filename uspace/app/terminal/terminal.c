@@ -48,6 +48,7 @@
 #include <io/concaps.h>
 #include <io/console.h>
 #include <io/pixelmap.h>
+#include <mem.h>
 #include <task.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -67,6 +68,12 @@
 
 #define APP_GETTERM  "/app/getterm"
 
+/** Minimum interval between terminal updates caused by output (us) */
+#define TERM_FRAME_USEC  16667
+
+/** Number of characters decoded at a time when writing */
+#define WRITE_DECODE_CHUNK  64
+
 #define TERM_CAPS \
 	(CONSOLE_CAP_STYLE | CONSOLE_CAP_INDEXED | CONSOLE_CAP_RGB)
 
@@ -250,44 +257,60 @@ static void term_update_char(terminal_t *term, pixelmap_t *pixelmap,
 	term_update_region(term, bx, by, FONT_WIDTH, FONT_SCANLINES);
 }
 
-static bool term_update_scroll(terminal_t *term, pixelmap_t *pixelmap,
+/** Update terminal after its contents have been scrolled.
+ *
+ * The rows which are still visible are moved up in the pixel map with
+ * a single copy, only the rows that appeared at the bottom are drawn.
+ *
+ * @param term Terminal
+ * @param pixelmap Pixel map
+ * @param sx X coordinate of the character grid
+ * @param sy Y coordinate of the character grid
+ */
+static void term_update_scroll(terminal_t *term, pixelmap_t *pixelmap,
     sysarg_t sx, sysarg_t sy)
 {
 	sysarg_t top_row = chargrid_get_top_row(term->frontbuf);
+	sysarg_t lines = (top_row + term->rows - term->top_row) % term->rows;
+	sysarg_t col;
+	sysarg_t row;
 
-	if (term->top_row == top_row) {
-		return false;
-	}
+	if (lines == 0)
+		return;
 
 	term->top_row = top_row;
 
-	for (sysarg_t row = 0; row < term->rows; row++) {
-		for (sysarg_t col = 0; col < term->cols; col++) {
+	/* The cursor must not move along with the contents */
+	if (chargrid_get_cursor_visibility(term->backbuf)) {
+		chargrid_set_cursor_visibility(term->backbuf, false);
+		chargrid_get_cursor(term->backbuf, &col, &row);
+		term_update_char(term, pixelmap, sx, sy, col, row);
+	}
+
+	size_t row_pixels = pixelmap->width * FONT_SCANLINES;
+	pixel_t *dst = pixelmap->data + sy * pixelmap->width;
+
+	memmove(dst, dst + lines * row_pixels,
+	    (term->rows - lines) * row_pixels * sizeof(pixel_t));
+	chargrid_scroll_up(term->backbuf, lines);
+
+	for (row = term->rows - lines; row < term->rows; row++) {
+		for (col = 0; col < term->cols; col++) {
 			charfield_t *front_field =
 			    chargrid_charfield_at(term->frontbuf, col, row);
 			charfield_t *back_field =
 			    chargrid_charfield_at(term->backbuf, col, row);
-			bool update = false;
-
-			if (front_field->ch != back_field->ch) {
-				back_field->ch = front_field->ch;
-				update = true;
-			}
-
-			if (!attrs_same(front_field->attrs, back_field->attrs)) {
-				back_field->attrs = front_field->attrs;
-				update = true;
-			}
 
+			back_field->ch = front_field->ch;
+			back_field->attrs = front_field->attrs;
 			front_field->flags &= ~CHAR_FLAG_DIRTY;
 
-			if (update) {
-				term_update_char(term, pixelmap, sx, sy, col, row);
-			}
+			term_update_char(term, pixelmap, sx, sy, col, row);
 		}
 	}
 
-	return true;
+	term_update_region(term, sx, sy, term->cols * FONT_WIDTH,
+	    term->rows * FONT_SCANLINES);
 }
 
 static bool term_update_cursor(terminal_t *term, pixelmap_t *pixelmap,
@@ -343,49 +366,50 @@ static void term_update(terminal_t *term)
 	pixelmap.height = term->h;
 	pixelmap.data = alloc.pixels;
 
-	bool update = false;
 	sysarg_t sx = 0;
 	sysarg_t sy = 0;
+	sysarg_t r0;
+	sysarg_t r1;
 
-	if (term_update_scroll(term, &pixelmap, sx, sy)) {
-		update = true;
-	} else {
-		for (sysarg_t y = 0; y < term->rows; y++) {
-			for (sysarg_t x = 0; x < term->cols; x++) {
-				charfield_t *front_field =
-				    chargrid_charfield_at(term->frontbuf, x, y);
-				charfield_t *back_field =
-				    chargrid_charfield_at(term->backbuf, x, y);
-				bool cupdate = false;
-
-				if ((front_field->flags & CHAR_FLAG_DIRTY) ==
-				    CHAR_FLAG_DIRTY) {
-					if (front_field->ch != back_field->ch) {
-						back_field->ch = front_field->ch;
-						cupdate = true;
-					}
-
-					if (!attrs_same(front_field->attrs,
-					    back_field->attrs)) {
-						back_field->attrs = front_field->attrs;
-						cupdate = true;
-					}
-
-					front_field->flags &= ~CHAR_FLAG_DIRTY;
-				}
-
-				if (cupdate) {
-					term_update_char(term, &pixelmap, sx, sy, x, y);
-					update = true;
-				}
+	term_update_scroll(term, &pixelmap, sx, sy);
+
+	/* Only rows with dirty fields need to be examined */
+	chargrid_get_dirty_rows(term->frontbuf, &r0, &r1);
+
+	for (sysarg_t y = r0; y < r1; y++) {
+		for (sysarg_t x = 0; x < term->cols; x++) {
+			charfield_t *front_field =
+			    chargrid_charfield_at(term->frontbuf, x, y);
+			charfield_t *back_field =
+			    chargrid_charfield_at(term->backbuf, x, y);
+			bool cupdate = false;
+
+			if ((front_field->flags & CHAR_FLAG_DIRTY) !=
+			    CHAR_FLAG_DIRTY)
+				continue;
+
+			if (front_field->ch != back_field->ch) {
+				back_field->ch = front_field->ch;
+				cupdate = true;
 			}
+
+			if (!attrs_same(front_field->attrs,
+			    back_field->attrs)) {
+				back_field->attrs = front_field->attrs;
+				cupdate = true;
+			}
+
+			front_field->flags &= ~CHAR_FLAG_DIRTY;
+
+			if (cupdate)
+				term_update_char(term, &pixelmap, sx, sy, x, y);
 		}
 	}
 
-	if (term_update_cursor(term, &pixelmap, sx, sy))
-		update = true;
+	chargrid_reset_dirty_rows(term->frontbuf);
+	term_update_cursor(term, &pixelmap, sx, sy);
 
-	if (update) {
+	if (!gfx_rect_is_empty(&term->update)) {
 		pos.x = 4;
 		pos.y = 26;
 		(void) gfx_bitmap_render(term->bmp, &term->update, &pos);
@@ -396,6 +420,7 @@ static void term_update(terminal_t *term)
 		term->update.p1.y = 0;
 	}
 
+	getuptime(&term->last_update);
 	fibril_mutex_unlock(&term->mtx);
 }
 
@@ -420,23 +445,24 @@ static void term_repaint(terminal_t *term)
 	sysarg_t sx = 0;
 	sysarg_t sy = 0;
 
-	if (!term_update_scroll(term, &pixelmap, sx, sy)) {
-		for (sysarg_t y = 0; y < term->rows; y++) {
-			for (sysarg_t x = 0; x < term->cols; x++) {
-				charfield_t *front_field =
-				    chargrid_charfield_at(term->frontbuf, x, y);
-				charfield_t *back_field =
-				    chargrid_charfield_at(term->backbuf, x, y);
+	term->top_row = chargrid_get_top_row(term->frontbuf);
 
-				back_field->ch = front_field->ch;
-				back_field->attrs = front_field->attrs;
-				front_field->flags &= ~CHAR_FLAG_DIRTY;
+	for (sysarg_t y = 0; y < term->rows; y++) {
+		for (sysarg_t x = 0; x < term->cols; x++) {
+			charfield_t *front_field =
+			    chargrid_charfield_at(term->frontbuf, x, y);
+			charfield_t *back_field =
+			    chargrid_charfield_at(term->backbuf, x, y);
 
-				term_update_char(term, &pixelmap, sx, sy, x, y);
-			}
+			back_field->ch = front_field->ch;
+			back_field->attrs = front_field->attrs;
+			front_field->flags &= ~CHAR_FLAG_DIRTY;
+
+			term_update_char(term, &pixelmap, sx, sy, x, y);
 		}
 	}
 
+	chargrid_reset_dirty_rows(term->frontbuf);
 	term_update_cursor(term, &pixelmap, sx, sy);
 
 	fibril_mutex_unlock(&term->mtx);
@@ -503,41 +529,81 @@ static errno_t term_read(con_srv_t *srv, void *buf, size_t size, size_t *nread)
 
 static void term_write_char(terminal_t *term, wchar_t ch)
 {
-	sysarg_t updated = 0;
-
-	fibril_mutex_lock(&term->mtx);
-
 	switch (ch) {
 	case '\n':
-		updated = chargrid_newline(term->frontbuf);
+		chargrid_newline(term->frontbuf);
 		break;
 	case '\r':
 		break;
 	case '\t':
-		updated = chargrid_tabstop(term->frontbuf, 8);
+		chargrid_tabstop(term->frontbuf, 8);
 		break;
 	case '\b':
-		updated = chargrid_backspace(term->frontbuf);
+		chargrid_backspace(term->frontbuf);
 		break;
 	default:
-		updated = chargrid_putuchar(term->frontbuf, ch, true);
+		chargrid_putuchar(term->frontbuf, ch, true);
 	}
+}
+
+/** Terminal update timer handler.
+ *
+ * @param arg Terminal
+ */
+static void term_update_timer(void *arg)
+{
+	terminal_t *term = (terminal_t *) arg;
 
+	fibril_mutex_lock(&term->mtx);
+	term->update_pending = false;
 	fibril_mutex_unlock(&term->mtx);
 
-	if (updated > 1)
-		term_update(term);
+	term_update(term);
+	gfx_update(term->gc);
 }
 
 static errno_t term_write(con_srv_t *srv, void *data, size_t size, size_t *nwritten)
 {
 	terminal_t *term = srv_to_terminal(srv);
-
+	struct timespec now;
+	usec_t elapsed;
+	bool update = false;
+	char32_t buf[WRITE_DECODE_CHUNK];
 	size_t off = 0;
-	while (off < size)
-		term_write_char(term, str_decode(data, &off, size));
+	size_t n, i;
+
+	fibril_mutex_lock(&term->mtx);
+
+	while (off < size) {
+		n = str_decode_buf(data, &off, size, buf, WRITE_DECODE_CHUNK);
+		for (i = 0; i < n; i++)
+			term_write_char(term, buf[i]);
+	}
+
+	/*
+	 * Output arriving within one frame of the previous update is
+	 * coalesced and drawn by the update timer.
+	 */
+	if (!term->update_pending) {
+		getuptime(&now);
+		elapsed = NSEC2USEC(ts_sub_diff(&now, &term->last_update));
+		if (elapsed >= TERM_FRAME_USEC) {
+			update = true;
+		} else {
+			term->update_pending = true;
+			fibril_timer_set_locked(term->update_timer,
+			    TERM_FRAME_USEC - elapsed, term_update_timer,
+			    term);
+		}
+	}
+
+	fibril_mutex_unlock(&term->mtx);
+
+	if (update) {
+		term_update(term);
+		gfx_update(term->gc);
+	}
 
-	gfx_update(term->gc);
 	*nwritten = size;
 	return EOK;
 }
@@ -782,9 +848,11 @@ static void term_buf_update(con_srv_t *srv, sysarg_t c0, sysarg_t r0,
 		for (col = c0; col < c1; col++) {
 			ch = chargrid_charfield_at(term->frontbuf, col, row);
 			*ch = term->ubuf[row * term->ucols + col];
+			ch->flags |= CHAR_FLAG_DIRTY;
 		}
 	}
 
+	chargrid_set_dirty_rows(term->frontbuf, r0, r1);
 	fibril_mutex_unlock(&term->mtx);
 
 	/* Update terminal */
@@ -796,6 +864,11 @@ static void deinit_terminal(terminal_t *term)
 {
 	list_remove(&term->link);
 
+	if (term->update_timer != NULL) {
+		fibril_timer_clear(term->update_timer);
+		fibril_timer_destroy(term->update_timer);
+	}
+
 	if (term->frontbuf)
 		chargrid_destroy(term->frontbuf);
 
@@ -947,6 +1020,13 @@ errno_t terminal_create(const char *display_spec, sysarg_t width,
 	term->frontbuf = NULL;
 	term->backbuf = NULL;
 
+	term->update_timer = fibril_timer_create(&term->mtx);
+	if (term->update_timer == NULL) {
+		printf("Out of memory.\n");
+		rc = ENOMEM;
+		goto error;
+	}
+
 	term->frontbuf = chargrid_create(term->cols, term->rows,
 	    CHARGRID_FLAG_NONE);
 	if (!term->frontbuf) {
@@ -1070,6 +1150,8 @@ error:
 		chargrid_destroy(term->frontbuf);
 	if (term->backbuf != NULL)
 		chargrid_destroy(term->backbuf);
+	if (term->update_timer != NULL)
+		fibril_timer_destroy(term->update_timer);
 	free(term);
 	return rc;
 }
@@ -50,6 +50,7 @@
 #include <stdatomic.h>
 #include <str.h>
 #include <task.h>
+#include <time.h>
 #include <ui/ui.h>
 #include <ui/window.h>
 
@@ -86,6 +87,10 @@ typedef struct {
 	chargrid_t *backbuf;
 	sysarg_t top_row;
 
+	fibril_timer_t *update_timer;
+	bool update_pending;
+	struct timespec last_update;
+
 	sysarg_t ucols;
 	sysarg_t urows;
 	charfield_t *ubuf;
@@ -314,6 +314,15 @@ static inline void print_help(void)
 	printf(" i .. IPC statistics");
 	screen_newline();
 
+	printf(" p .. IPC profile by interface");
+	screen_newline();
+
+	printf(" y .. syscall profile");
+	screen_newline();
+
+	printf(" w .. thread scheduling delay and wait time");
+	screen_newline();
+
 	printf(" e .. exceptions statistics");
 	screen_newline();
 
@@ -407,6 +416,9 @@ static inline void print_table(const table_t *table)
 		case FIELD_UINT:
 			printf("%*" PRIu64, width, field->uint);
 			break;
+		case FIELD_UINT_HEX:
+			printf("%*" PRIx64, width, field->uint);
+			break;
 		case FIELD_UINT_SUFFIX_BIN:
 			val = field->uint;
 			width -= 3;
@@ -56,6 +56,9 @@
 typedef enum {
 	OP_TASKS,
 	OP_IPC,
+	OP_IPC_PROFILE,
+	OP_SYSCALLS,
+	OP_THREADS,
 	OP_EXCS,
 } op_mode_t;
 
@@ -91,6 +94,10 @@ static const column_t ipc_columns[] = {
 	{ "ans snt", 'a', 9 },
 	{ "ans rcv", 'A', 9 },
 	{ "forward", 'f', 9 },
+	{ "data wr", 'w', 9 },
+	{ "pinned",  'W', 9 },
+	{ "data rd", 'r', 9 },
+	{ "pinned",  'R', 9 },
 	{ "name",    'd', 0 },
 };
 
@@ -101,10 +108,85 @@ enum {
 	IPC_COL_ANS_SNT,
 	IPC_COL_ANS_RCV,
 	IPC_COL_FORWARD,
+	IPC_COL_DATA_WR,
+	IPC_COL_DATA_WR_PIN,
+	IPC_COL_DATA_RD,
+	IPC_COL_DATA_RD_PIN,
 	IPC_COL_NAME,
 	IPC_NUM_COLUMNS,
 };
 
+static const column_t ipc_profile_columns[] = {
+	{ "taskid",  't',  8 },
+	{ "iface",   'i', 10 },
+	{ "calls",   'c',  9 },
+	{ "answers", 'a',  9 },
+	{ "bytes",   'b',  9 },
+	{ "avg lat", 'l',  9 },
+	{ "p50 lat", 'm',  9 },
+	{ "p99 lat", 'M',  9 },
+	{ "name",    'd',  0 },
+};
+
+enum {
+	IPC_PROFILE_COL_TASKID = 0,
+	IPC_PROFILE_COL_IFACE,
+	IPC_PROFILE_COL_CALLS,
+	IPC_PROFILE_COL_ANSWERS,
+	IPC_PROFILE_COL_BYTES,
+	IPC_PROFILE_COL_AVG_LATENCY,
+	IPC_PROFILE_COL_P50_LATENCY,
+	IPC_PROFILE_COL_P99_LATENCY,
+	IPC_PROFILE_COL_NAME,
+	IPC_PROFILE_NUM_COLUMNS,
+};
+
+static const column_t syscall_columns[] = {
+	{ "taskid",  't',  8 },
+	{ "syscall", 'y',  9 },
+	{ "count",   'n', 10 },
+	{ "cycles",  'c', 10 },
+	{ "avg cyc", 'a', 10 },
+	{ "name",    'd',  0 },
+};
+
+enum {
+	SYSCALL_COL_TASKID = 0,
+	SYSCALL_COL_ID,
+	SYSCALL_COL_COUNT,
+	SYSCALL_COL_CYCLES,
+	SYSCALL_COL_AVG_CYCLES,
+	SYSCALL_COL_NAME,
+	SYSCALL_NUM_COLUMNS,
+};
+
+static const column_t thread_columns[] = {
+	{ "thrid",   'i',  8 },
+	{ "taskid",  't',  8 },
+	{ "state",   'S', 10 },
+	{ "rq wait", 'w', 10 },
+	{ "ipc",     'c', 10 },
+	{ "futex",   'f', 10 },
+	{ "sleep",   'l', 10 },
+	{ "vcsw",    'v',  8 },
+	{ "ivcsw",   'V',  8 },
+	{ "name",    'd',  0 },
+};
+
+enum {
+	THREAD_COL_ID = 0,
+	THREAD_COL_TASKID,
+	THREAD_COL_STATE,
+	THREAD_COL_RQ_WAIT,
+	THREAD_COL_IPC,
+	THREAD_COL_FUTEX,
+	THREAD_COL_SLEEP,
+	THREAD_COL_VCSW,
+	THREAD_COL_IVCSW,
+	THREAD_COL_NAME,
+	THREAD_NUM_COLUMNS,
+};
+
 static const column_t exception_columns[] = {
 	{ "exc",         'e',  8 },
 	{ "count",       'n', 10 },
@@ -139,6 +221,7 @@ static const char *read_data(data_t *target)
 	target->tasks = NULL;
 	target->tasks_perc = NULL;
 	target->threads = NULL;
+	target->threads_diff = NULL;
 	target->exceptions = NULL;
 	target->exceptions_perc = NULL;
 	target->physmem = NULL;
@@ -199,6 +282,11 @@ static const char *read_data(data_t *target)
 	if (target->threads == NULL)
 		return "Cannot get threads";
 
+	target->threads_diff = calloc(target->threads_count,
+	    sizeof(diff_thread_t));
+	if (target->threads_diff == NULL)
+		return "Not enough memory for thread statistics";
+
 	/* Get Exceptions */
 	target->exceptions = stats_get_exceptions(&(target->exceptions_count));
 	if (target->exceptions == NULL)
@@ -313,6 +401,39 @@ static void compute_percentages(data_t *old_data, data_t *new_data)
 		    new_data->kcycles_diff[i] * 100, kcycles_total);
 	}
 
+	/* For all threads compute differencies of scheduling statistics */
+
+	for (i = 0; i < new_data->threads_count; i++) {
+		stats_thread_t *thread = &new_data->threads[i];
+		diff_thread_t *diff = &new_data->threads_diff[i];
+
+		/* Match thread with the previous instance */
+
+		bool found = false;
+		size_t j;
+		for (j = 0; j < old_data->threads_count; j++) {
+			if (old_data->threads[j].thread_id ==
+			    thread->thread_id) {
+				found = true;
+				break;
+			}
+		}
+
+		if (!found) {
+			/* This is a new thread, ignore it */
+			memset(diff, 0, sizeof(diff_thread_t));
+			continue;
+		}
+
+		stats_thread_t *old = &old_data->threads[j];
+		diff->rqcycles = thread->rqcycles - old->rqcycles;
+		diff->ipc_cycles = thread->ipc_cycles - old->ipc_cycles;
+		diff->futex_cycles = thread->futex_cycles - old->futex_cycles;
+		diff->sleep_cycles = thread->sleep_cycles - old->sleep_cycles;
+		diff->vcsw = thread->vcsw - old->vcsw;
+		diff->ivcsw = thread->ivcsw - old->ivcsw;
+	}
+
 	/* For all exceptions compute sum and differencies of cycles */
 
 	uint64_t ecycles_total = 0;
@@ -374,6 +495,7 @@ static int cmp_data(void *a, void *b, void *arg)
 	switch (fa->type) {
 	case FIELD_EMPTY:
 		return 0;
+	case FIELD_UINT_HEX: /* fallthrough */
 	case FIELD_UINT_SUFFIX_BIN: /* fallthrough */
 	case FIELD_UINT_SUFFIX_DEC: /* fallthrough */
 	case FIELD_UINT:
@@ -470,6 +592,16 @@ static const char *fill_ipc_table(data_t *data)
 		field[IPC_COL_ANS_RCV].uint = data->tasks[i].ipc_info.answer_received;
 		field[IPC_COL_FORWARD].type = FIELD_UINT_SUFFIX_DEC;
 		field[IPC_COL_FORWARD].uint = data->tasks[i].ipc_info.forwarded;
+		field[IPC_COL_DATA_WR].type = FIELD_UINT_SUFFIX_BIN;
+		field[IPC_COL_DATA_WR].uint = data->tasks[i].ipc_info.data_written;
+		field[IPC_COL_DATA_WR_PIN].type = FIELD_UINT_SUFFIX_BIN;
+		field[IPC_COL_DATA_WR_PIN].uint =
+		    data->tasks[i].ipc_info.data_written_pinned;
+		field[IPC_COL_DATA_RD].type = FIELD_UINT_SUFFIX_BIN;
+		field[IPC_COL_DATA_RD].uint = data->tasks[i].ipc_info.data_read;
+		field[IPC_COL_DATA_RD_PIN].type = FIELD_UINT_SUFFIX_BIN;
+		field[IPC_COL_DATA_RD_PIN].uint =
+		    data->tasks[i].ipc_info.data_read_pinned;
 		field[IPC_COL_NAME].type = FIELD_STRING;
 		field[IPC_COL_NAME].string = data->tasks[i].name;
 		field += IPC_NUM_COLUMNS;
@@ -478,6 +610,205 @@ static const char *fill_ipc_table(data_t *data)
 	return NULL;
 }
 
+/** Estimate a percentile of answer latency from the histogram
+ *
+ * @param prof    Interface profile.
+ * @param percent Percentile (0 .. 100).
+ *
+ * @return Upper bound of the latency bucket containing
+ *         the percentile (in cycles).
+ *
+ */
+static uint64_t latency_percentile(const stats_ipc_iface_t *prof,
+    unsigned int percent)
+{
+	uint64_t threshold = (prof->answers * percent + 99) / 100;
+	uint64_t sum = 0;
+
+	size_t i;
+	for (i = 0; i < STATS_IPC_PROF_LATENCIES - 1; i++) {
+		sum += prof->latencies[i];
+		if (sum >= threshold)
+			break;
+	}
+
+	return ((uint64_t) 1) << (STATS_IPC_PROF_LATENCY_SHIFT + i);
+}
+
+static const char *fill_ipc_profile_table(data_t *data)
+{
+	data->table.name = "IPC profile";
+	data->table.num_columns = IPC_PROFILE_NUM_COLUMNS;
+	data->table.columns = ipc_profile_columns;
+	data->table.num_fields = data->tasks_count * STATS_IPC_PROF_IFACES *
+	    IPC_PROFILE_NUM_COLUMNS;
+	data->table.fields = calloc(data->table.num_fields, sizeof(field_t));
+	if (data->table.fields == NULL)
+		return "Not enough memory for table fields";
+
+	bool available = false;
+	field_t *field = data->table.fields;
+	for (size_t i = 0; i < data->tasks_count; i++) {
+		stats_task_ipc_t *profile =
+		    stats_get_task_ipc(data->tasks[i].task_id);
+		if (profile == NULL)
+			continue;
+
+		available = true;
+
+		for (size_t j = 0; j < STATS_IPC_PROF_IFACES; j++) {
+			stats_ipc_iface_t *prof = &profile->ifaces[j];
+			if (prof->calls == 0)
+				continue;
+
+			field[IPC_PROFILE_COL_TASKID].type = FIELD_UINT;
+			field[IPC_PROFILE_COL_TASKID].uint = data->tasks[i].task_id;
+			field[IPC_PROFILE_COL_IFACE].type = FIELD_UINT_HEX;
+			field[IPC_PROFILE_COL_IFACE].uint = prof->iface;
+			field[IPC_PROFILE_COL_CALLS].type = FIELD_UINT_SUFFIX_DEC;
+			field[IPC_PROFILE_COL_CALLS].uint = prof->calls;
+			field[IPC_PROFILE_COL_ANSWERS].type = FIELD_UINT_SUFFIX_DEC;
+			field[IPC_PROFILE_COL_ANSWERS].uint = prof->answers;
+			field[IPC_PROFILE_COL_BYTES].type = FIELD_UINT_SUFFIX_BIN;
+			field[IPC_PROFILE_COL_BYTES].uint = prof->bytes;
+
+			if (prof->answers != 0) {
+				field[IPC_PROFILE_COL_AVG_LATENCY].type =
+				    FIELD_UINT_SUFFIX_DEC;
+				field[IPC_PROFILE_COL_AVG_LATENCY].uint =
+				    prof->latency / prof->answers;
+				field[IPC_PROFILE_COL_P50_LATENCY].type =
+				    FIELD_UINT_SUFFIX_DEC;
+				field[IPC_PROFILE_COL_P50_LATENCY].uint =
+				    latency_percentile(prof, 50);
+				field[IPC_PROFILE_COL_P99_LATENCY].type =
+				    FIELD_UINT_SUFFIX_DEC;
+				field[IPC_PROFILE_COL_P99_LATENCY].uint =
+				    latency_percentile(prof, 99);
+			}
+
+			field[IPC_PROFILE_COL_NAME].type = FIELD_STRING;
+			field[IPC_PROFILE_COL_NAME].string = data->tasks[i].name;
+			field += IPC_PROFILE_NUM_COLUMNS;
+		}
+
+		free(profile);
+	}
+
+	/* Only interfaces which were used are shown */
+	data->table.num_fields = field - data->table.fields;
+
+	if (!available)
+		show_warning("IPC profiling is not enabled in the kernel");
+
+	return NULL;
+}
+
+static const char *fill_syscall_table(data_t *data)
+{
+	data->table.name = "Syscalls";
+	data->table.num_columns = SYSCALL_NUM_COLUMNS;
+	data->table.columns = syscall_columns;
+	data->table.num_fields = data->tasks_count * SYSCALL_END *
+	    SYSCALL_NUM_COLUMNS;
+	data->table.fields = calloc(data->table.num_fields, sizeof(field_t));
+	if (data->table.fields == NULL)
+		return "Not enough memory for table fields";
+
+	bool available = false;
+	field_t *field = data->table.fields;
+	for (size_t i = 0; i < data->tasks_count; i++) {
+		stats_task_ipc_t *profile =
+		    stats_get_task_ipc(data->tasks[i].task_id);
+		if (profile == NULL)
+			continue;
+
+		available = true;
+
+		for (size_t j = 0; j < SYSCALL_END; j++) {
+			stats_syscall_t *prof = &profile->syscalls[j];
+			if (prof->count == 0)
+				continue;
+
+			field[SYSCALL_COL_TASKID].type = FIELD_UINT;
+			field[SYSCALL_COL_TASKID].uint = data->tasks[i].task_id;
+			field[SYSCALL_COL_ID].type = FIELD_UINT;
+			field[SYSCALL_COL_ID].uint = j;
+			field[SYSCALL_COL_COUNT].type = FIELD_UINT_SUFFIX_DEC;
+			field[SYSCALL_COL_COUNT].uint = prof->count;
+			field[SYSCALL_COL_CYCLES].type = FIELD_UINT_SUFFIX_DEC;
+			field[SYSCALL_COL_CYCLES].uint = prof->cycles;
+			field[SYSCALL_COL_AVG_CYCLES].type = FIELD_UINT_SUFFIX_DEC;
+			field[SYSCALL_COL_AVG_CYCLES].uint =
+			    prof->cycles / prof->count;
+			field[SYSCALL_COL_NAME].type = FIELD_STRING;
+			field[SYSCALL_COL_NAME].string = data->tasks[i].name;
+			field += SYSCALL_NUM_COLUMNS;
+		}
+
+		free(profile);
+	}
+
+	/* Only syscalls which were invoked are shown */
+	data->table.num_fields = field - data->table.fields;
+
+	if (!available)
+		show_warning("IPC profiling is not enabled in the kernel");
+
+	return NULL;
+}
+
+static const char *thread_task_name(data_t *data, task_id_t task_id)
+{
+	for (size_t i = 0; i < data->tasks_count; i++) {
+		if (data->tasks[i].task_id == task_id)
+			return data->tasks[i].name;
+	}
+
+	return "";
+}
+
+static const char *fill_thread_table(data_t *data)
+{
+	data->table.name = "Threads";
+	data->table.num_columns = THREAD_NUM_COLUMNS;
+	data->table.columns = thread_columns;
+	data->table.num_fields = data->threads_count * THREAD_NUM_COLUMNS;
+	data->table.fields = calloc(data->table.num_fields, sizeof(field_t));
+	if (data->table.fields == NULL)
+		return "Not enough memory for table fields";
+
+	field_t *field = data->table.fields;
+	for (size_t i = 0; i < data->threads_count; i++) {
+		stats_thread_t *thread = &data->threads[i];
+		diff_thread_t *diff = &data->threads_diff[i];
+		field[THREAD_COL_ID].type = FIELD_UINT;
+		field[THREAD_COL_ID].uint = thread->thread_id;
+		field[THREAD_COL_TASKID].type = FIELD_UINT;
+		field[THREAD_COL_TASKID].uint = thread->task_id;
+		field[THREAD_COL_STATE].type = FIELD_STRING;
+		field[THREAD_COL_STATE].string = thread_get_state(thread->state);
+		field[THREAD_COL_RQ_WAIT].type = FIELD_UINT_SUFFIX_DEC;
+		field[THREAD_COL_RQ_WAIT].uint = diff->rqcycles;
+		field[THREAD_COL_IPC].type = FIELD_UINT_SUFFIX_DEC;
+		field[THREAD_COL_IPC].uint = diff->ipc_cycles;
+		field[THREAD_COL_FUTEX].type = FIELD_UINT_SUFFIX_DEC;
+		field[THREAD_COL_FUTEX].uint = diff->futex_cycles;
+		field[THREAD_COL_SLEEP].type = FIELD_UINT_SUFFIX_DEC;
+		field[THREAD_COL_SLEEP].uint = diff->sleep_cycles;
+		field[THREAD_COL_VCSW].type = FIELD_UINT_SUFFIX_DEC;
+		field[THREAD_COL_VCSW].uint = diff->vcsw;
+		field[THREAD_COL_IVCSW].type = FIELD_UINT_SUFFIX_DEC;
+		field[THREAD_COL_IVCSW].uint = diff->ivcsw;
+		field[THREAD_COL_NAME].type = FIELD_STRING;
+		field[THREAD_COL_NAME].string =
+		    thread_task_name(data, thread->task_id);
+		field += THREAD_NUM_COLUMNS;
+	}
+
+	return NULL;
+}
+
 static const char *fill_exception_table(data_t *data)
 {
 	data->table.name = "Exceptions";
@@ -526,6 +857,12 @@ static const char *fill_table(data_t *data)
 		return fill_task_table(data);
 	case OP_IPC:
 		return fill_ipc_table(data);
+	case OP_IPC_PROFILE:
+		return fill_ipc_profile_table(data);
+	case OP_SYSCALLS:
+		return fill_syscall_table(data);
+	case OP_THREADS:
+		return fill_thread_table(data);
 	case OP_EXCS:
 		return fill_exception_table(data);
 	}
@@ -552,6 +889,9 @@ static void free_data(data_t *target)
 	if (target->threads != NULL)
 		free(target->threads);
 
+	if (target->threads_diff != NULL)
+		free(target->threads_diff);
+
 	if (target->exceptions != NULL)
 		free(target->exceptions);
 
@@ -641,6 +981,18 @@ int main(int argc, char *argv[])
 		case 'i':
 			op_mode = OP_IPC;
 			break;
+		case 'p':
+			op_mode = OP_IPC_PROFILE;
+			break;
+		case 'y':
+			op_mode = OP_SYSCALLS;
+			break;
+		case 'w':
+			/* Threads waiting longest to be scheduled first */
+			op_mode = OP_THREADS;
+			sort_column = THREAD_COL_RQ_WAIT;
+			sort_reverse = -1;
+			break;
 		case 'e':
 			op_mode = OP_EXCS;
 			break;
@@ -79,9 +79,20 @@ typedef struct {
 	fixed_float count;
 } perc_exc_t;
 
+/** Thread scheduling statistics over the last update interval */
+typedef struct {
+	uint64_t rqcycles;
+	uint64_t ipc_cycles;
+	uint64_t futex_cycles;
+	uint64_t sleep_cycles;
+	uint64_t vcsw;
+	uint64_t ivcsw;
+} diff_thread_t;
+
 typedef enum {
 	FIELD_EMPTY,
 	FIELD_UINT,
+	FIELD_UINT_HEX,
 	FIELD_UINT_SUFFIX_BIN,
 	FIELD_UINT_SUFFIX_DEC,
 	FIELD_PERCENT,
@@ -134,6 +145,7 @@ typedef struct {
 
 	size_t threads_count;
 	stats_thread_t *threads;
+	diff_thread_t *threads_diff;
 
 	size_t exceptions_count;
 	stats_exc_t *exceptions;
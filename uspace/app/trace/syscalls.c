@@ -51,6 +51,9 @@ const sc_desc_t syscall_desc[] = {
 	[SYS_TASK_SET_NAME] = { "task_set_name", 2, V_ERRNO },
 	[SYS_TASK_KILL] = { "task_kill", 1, V_ERRNO },
 	[SYS_TASK_EXIT] = { "task_exit", 1, V_ERRNO },
+	[SYS_TASK_SET_SCHED_CLASS] = { "task_set_sched_class", 1, V_ERRNO },
+	[SYS_CPUSET_SET] = { "cpuset_set", 3, V_ERRNO },
+	[SYS_CPUSET_GET] = { "cpuset_get", 3, V_ERRNO },
 	[SYS_PROGRAM_SPAWN_LOADER] = { "program_spawn_loader", 2, V_ERRNO },
 
 	/* Synchronization related syscalls. */
@@ -75,9 +78,11 @@ const sc_desc_t syscall_desc[] = {
 	[SYS_IPC_CALL_ASYNC_SLOW] = { "ipc_call_async_slow", 3, V_HASH },
 	[SYS_IPC_ANSWER_FAST] = { "ipc_answer_fast", 6, V_ERRNO },
 	[SYS_IPC_ANSWER_SLOW] = { "ipc_answer_slow", 2, V_ERRNO },
+	[SYS_IPC_ANSWER_BATCH] = { "ipc_answer_batch", 2, V_ERRNO },
 	[SYS_IPC_FORWARD_FAST] = { "ipc_forward_fast", 6, V_ERRNO },
 	[SYS_IPC_FORWARD_SLOW] = { "ipc_forward_slow", 3, V_ERRNO },
 	[SYS_IPC_WAIT] = { "ipc_wait_for_call", 3, V_HASH },
+	[SYS_IPC_WAIT_BATCH] = { "ipc_wait_for_calls", 5, V_ERRNO },
 	[SYS_IPC_POKE] = { "ipc_poke", 0, V_ERRNO },
 	[SYS_IPC_HANGUP] = { "ipc_hangup", 1, V_ERRNO },
 	[SYS_IPC_CONNECT_KBOX] = { "ipc_connect_kbox", 2, V_ERRNO },
@@ -113,7 +118,11 @@ const sc_desc_t syscall_desc[] = {
 	/* Kernel console syscalls. */
 	[SYS_DEBUG_CONSOLE] = { "debug_console", 0, V_ERRNO },
 
-	[SYS_KLOG] = { "klog", 5, V_ERRNO }
+	[SYS_KLOG] = { "klog", 5, V_ERRNO },
+
+	[SYS_PROF] = { "prof", 5, V_ERRNO },
+
+	[SYS_ENTROPY_GET] = { "entropy_get", 2, V_ERRNO }
 };
 
 const size_t syscall_desc_len = (sizeof(syscall_desc) / sizeof(sc_desc_t));
@@ -34,7 +34,7 @@
  */
 
 #include <errno.h>
-#include <gfximage/tga.h>
+#include <gfximage/imgcache.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -43,7 +43,6 @@
 #include <ui/ui.h>
 #include <ui/wdecor.h>
 #include <ui/window.h>
-#include <vfs/vfs.h>
 
 #define NAME  "viewer"
 
@@ -62,6 +61,11 @@ static gfx_context_t *window_gc;
 
 static gfx_rect_t img_rect;
 
+/** Decode images at reduced size to fit within img_maxdim */
+static bool img_fit = false;
+/** Maximum image dimensions if img_fit is true */
+static gfx_coord2_t img_maxdim;
+
 static bool img_load(gfx_context_t *gc, const char *, gfx_bitmap_t **,
     gfx_rect_t *);
 static bool img_setup(gfx_context_t *, gfx_bitmap_t *, gfx_rect_t *);
@@ -130,41 +134,12 @@ static void wnd_kbd_event(ui_window_t *window, void *arg,
 static bool img_load(gfx_context_t *gc, const char *fname,
     gfx_bitmap_t **rbitmap, gfx_rect_t *rect)
 {
-	int fd;
-	errno_t rc = vfs_lookup_open(fname, WALK_REGULAR, MODE_READ, &fd);
-	if (rc != EOK)
-		return false;
-
-	vfs_stat_t stat;
-	rc = vfs_stat(fd, &stat);
-	if (rc != EOK) {
-		vfs_put(fd);
-		return false;
-	}
-
-	void *tga = malloc(stat.size);
-	if (tga == NULL) {
-		vfs_put(fd);
-		return false;
-	}
-
-	size_t nread;
-	rc = vfs_read(fd, (aoff64_t []) { 0 }, tga, stat.size, &nread);
-	if (rc != EOK || nread != stat.size) {
-		free(tga);
-		vfs_put(fd);
-		return false;
-	}
-
-	vfs_put(fd);
+	errno_t rc;
 
-	rc = decode_tga(gc, tga, stat.size, rbitmap, rect);
-	if (rc != EOK) {
-		free(tga);
+	rc = gfximage_load(gc, fname, img_fit ? &img_maxdim : NULL, rbitmap,
+	    rect);
+	if (rc != EOK)
 		return false;
-	}
-
-	free(tga);
 
 	img_rect = *rect;
 	return true;
@@ -304,6 +279,13 @@ int main(int argc, char *argv[])
 
 	ui_window_set_cb(window, &window_cb, (void *) &viewer);
 
+	if (fullscreen) {
+		/* Decode large images at reduced size to fit the screen */
+		ui_window_get_app_rect(window, &rect);
+		gfx_rect_dims(&rect, &img_maxdim);
+		img_fit = true;
+	}
+
 	if (!img_load(window_gc, imgs[imgs_current], &lbitmap, &lrect)) {
 		printf("Cannot load image \"%s\".\n", imgs[imgs_current]);
 		return 1;
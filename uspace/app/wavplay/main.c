@@ -50,6 +50,7 @@
 
 #define READ_SIZE   (32 * 1024)
 #define STREAM_BUFFER_SIZE   (64 * 1024)
+#define RING_PERIOD_SIZE   (4 * 1024)
 
 /**
  * Play audio file using a new stream on provided context.
@@ -94,8 +95,21 @@ static errno_t hplay_ctx(hound_context_t *ctx, const char *filename)
 		fclose(source);
 		return ENOMEM;
 	}
-	hound_stream_t *stream = hound_stream_create(ctx,
-	    HOUND_STREAM_DRAIN_ON_EXIT, format, STREAM_BUFFER_SIZE);
+	/* Prefer a shared ring, fall back to sending data over IPC */
+	const size_t period = RING_PERIOD_SIZE -
+	    RING_PERIOD_SIZE % pcm_format_frame_size(&format);
+	hound_stream_t *stream = hound_stream_create_ring(ctx,
+	    HOUND_STREAM_DRAIN_ON_EXIT, format, period,
+	    STREAM_BUFFER_SIZE / period);
+	if (!stream)
+		stream = hound_stream_create(ctx, HOUND_STREAM_DRAIN_ON_EXIT,
+		    format, STREAM_BUFFER_SIZE);
+	if (!stream) {
+		printf("Failed to create hound stream.\n");
+		free(buffer);
+		fclose(source);
+		return ENOMEM;
+	}
 
 	/* Read and play */
 	while ((read = fread(buffer, sizeof(char), READ_SIZE, source)) > 0) {
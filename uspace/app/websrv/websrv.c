@@ -44,6 +44,9 @@
 
 #include <vfs/vfs.h>
 
+#include <http/http.h>
+#include <http/receive-buffer.h>
+
 #include <inet/addr.h>
 #include <inet/endpoint.h>
 #include <inet/tcp.h>
@@ -59,8 +62,14 @@
 
 #define WEB_ROOT  "/data/web"
 
-/** Buffer for receiving the request. */
-#define BUFFER_SIZE  1024
+/** Buffer for receiving the requests. */
+#define BUFFER_SIZE  4096
+
+/** Maximum size of request headers */
+#define HEADERS_SIZE_MAX  (16 * 1024)
+
+/** Maximum number of request headers */
+#define HEADERS_COUNT_MAX  100
 
 static void websrv_new_conn(tcp_listener_t *, tcp_conn_t *);
 
@@ -74,28 +83,24 @@ static tcp_cb_t conn_cb = {
 
 static uint16_t port = DEFAULT_PORT;
 
+/** Client connection */
 typedef struct {
 	tcp_conn_t *conn;
-
-	char rbuf[BUFFER_SIZE];
-	size_t rbuf_out;
-	size_t rbuf_in;
-
+	/** Buffered request data, requests can be pipelined */
+	receive_buffer_t rbuf;
+	/** Received line */
 	char lbuf[BUFFER_SIZE + 1];
-	size_t lbuf_used;
-} recv_t;
+	/** @c true if the connection is closed after the response */
+	bool close;
+	/** @c true if only headers of the response are sent */
+	bool head;
+} websrv_conn_t;
 
 static bool verbose = false;
 
 /** Responses to send to client. */
 
-static const char *msg_ok =
-    "HTTP/1.0 200 OK\r\n"
-    "\r\n";
-
 static const char *msg_bad_request =
-    "HTTP/1.0 400 Bad Request\r\n"
-    "\r\n"
     "<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\r\n"
     "<html><head>\r\n"
     "<title>400 Bad Request</title>\r\n"
@@ -107,8 +112,6 @@ static const char *msg_bad_request =
     "</html>\r\n";
 
 static const char *msg_not_found =
-    "HTTP/1.0 404 Not Found\r\n"
-    "\r\n"
     "<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\r\n"
     "<html><head>\r\n"
     "<title>404 Not Found</title>\r\n"
@@ -120,8 +123,6 @@ static const char *msg_not_found =
     "</html>\r\n";
 
 static const char *msg_not_implemented =
-    "HTTP/1.0 501 Not Implemented\r\n"
-    "\r\n"
     "<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\r\n"
     "<html><head>\r\n"
     "<title>501 Not Implemented</title>\r\n"
@@ -132,77 +133,57 @@ static const char *msg_not_implemented =
     "</body>\r\n"
     "</html>\r\n";
 
-static errno_t recv_create(tcp_conn_t *conn, recv_t **rrecv)
+/** Receive data for the receive buffer.
+ *
+ * @return EOK on success, ENOENT if the client closed the connection or
+ *         an error code
+ */
+static errno_t websrv_receive(void *arg, void *buf, size_t bsize,
+    size_t *nrecv)
 {
-	recv_t *recv;
+	websrv_conn_t *wconn = (websrv_conn_t *) arg;
+	errno_t rc;
 
-	recv = calloc(1, sizeof(recv_t));
-	if (recv == NULL)
-		return ENOMEM;
+	rc = tcp_conn_recv_wait(wconn->conn, buf, bsize, nrecv);
+	if (rc != EOK) {
+		fprintf(stderr, "tcp_conn_recv() failed: %s\n", str_error(rc));
+		return rc;
+	}
 
-	recv->conn = conn;
-	recv->rbuf_out = 0;
-	recv->rbuf_in = 0;
-	recv->lbuf_used = 0;
+	if (*nrecv == 0)
+		return ENOENT;
 
-	*rrecv = recv;
 	return EOK;
 }
 
-static void recv_destroy(recv_t *recv)
-{
-	free(recv);
-}
-
-/** Receive one character (with buffering) */
-static errno_t recv_char(recv_t *recv, char *c)
+static errno_t websrv_conn_create(tcp_conn_t *conn, websrv_conn_t **rwconn)
 {
-	size_t nrecv;
+	websrv_conn_t *wconn;
 	errno_t rc;
 
-	if (recv->rbuf_out == recv->rbuf_in) {
-		recv->rbuf_out = 0;
-		recv->rbuf_in = 0;
+	wconn = calloc(1, sizeof(websrv_conn_t));
+	if (wconn == NULL)
+		return ENOMEM;
 
-		rc = tcp_conn_recv_wait(recv->conn, recv->rbuf, BUFFER_SIZE, &nrecv);
-		if (rc != EOK) {
-			fprintf(stderr, "tcp_conn_recv() failed: %s\n", str_error(rc));
-			return rc;
-		}
+	wconn->conn = conn;
 
-		recv->rbuf_in = nrecv;
+	rc = recv_buffer_init(&wconn->rbuf, BUFFER_SIZE, websrv_receive, wconn);
+	if (rc != EOK) {
+		free(wconn);
+		return rc;
 	}
 
-	*c = recv->rbuf[recv->rbuf_out++];
+	*rwconn = wconn;
 	return EOK;
 }
 
-/** Receive one line with length limit */
-static errno_t recv_line(recv_t *recv, char **rbuf)
+static void websrv_conn_destroy(websrv_conn_t *wconn)
 {
-	char *bp = recv->lbuf;
-	char c = '\0';
-
-	while (bp < recv->lbuf + BUFFER_SIZE) {
-		char prev = c;
-		errno_t rc = recv_char(recv, &c);
+	if (wconn == NULL)
+		return;
 
-		if (rc != EOK)
-			return rc;
-
-		*bp++ = c;
-		if ((prev == '\r') && (c == '\n'))
-			break;
-	}
-
-	recv->lbuf_used = bp - recv->lbuf;
-	*bp = '\0';
-
-	if (bp == recv->lbuf + BUFFER_SIZE)
-		return ELIMIT;
-
-	*rbuf = recv->lbuf;
-	return EOK;
+	recv_buffer_fini(&wconn->rbuf);
+	free(wconn);
 }
 
 static bool uri_is_valid(char *uri)
@@ -224,14 +205,33 @@ static bool uri_is_valid(char *uri)
 	return true;
 }
 
-static errno_t send_response(tcp_conn_t *conn, const char *msg)
+/** Send status line and headers.
+ *
+ * @param wconn  Connection
+ * @param status Status code and reason phrase
+ * @param length Content length
+ */
+static errno_t send_headers(websrv_conn_t *wconn, const char *status,
+    aoff64_t length)
 {
-	size_t response_size = str_size(msg);
+	char *hdrs;
+	int rv;
+	errno_t rc;
+
+	rv = asprintf(&hdrs,
+	    "HTTP/1.1 %s\r\n"
+	    "Content-Length: %" PRIu64 "\r\n"
+	    "Connection: %s\r\n"
+	    "\r\n", status, length, wconn->close ? "close" : "keep-alive");
+	if (rv < 0)
+		return ENOMEM;
 
 	if (verbose)
 		fprintf(stderr, "Sending response\n");
 
-	errno_t rc = tcp_conn_send(conn, (void *) msg, response_size);
+	rc = tcp_conn_send(wconn->conn, hdrs, str_size(hdrs));
+	free(hdrs);
+
 	if (rc != EOK) {
 		fprintf(stderr, "tcp_conn_send() failed\n");
 		return rc;
@@ -240,20 +240,33 @@ static errno_t send_response(tcp_conn_t *conn, const char *msg)
 	return EOK;
 }
 
-static errno_t uri_get(const char *uri, tcp_conn_t *conn)
+static errno_t send_response(websrv_conn_t *wconn, const char *status,
+    const char *msg)
 {
-	char *fbuf = NULL;
-	char *fname = NULL;
+	size_t msg_size = str_size(msg);
 	errno_t rc;
-	size_t nr;
-	int fd = -1;
 
-	fbuf = calloc(BUFFER_SIZE, 1);
-	if (fbuf == NULL) {
-		rc = ENOMEM;
-		goto out;
+	rc = send_headers(wconn, status, msg_size);
+	if (rc != EOK || wconn->head)
+		return rc;
+
+	rc = tcp_conn_send(wconn->conn, (void *) msg, msg_size);
+	if (rc != EOK) {
+		fprintf(stderr, "tcp_conn_send() failed\n");
+		return rc;
 	}
 
+	return EOK;
+}
+
+static errno_t uri_get(const char *uri, websrv_conn_t *wconn)
+{
+	char *fname = NULL;
+	vfs_stat_t stat;
+	errno_t rc;
+	size_t nsent;
+	int fd = -1;
+
 	if (str_cmp(uri, "/") == 0)
 		uri = "/index.html";
 
@@ -264,31 +277,33 @@ static errno_t uri_get(const char *uri, tcp_conn_t *conn)
 
 	rc = vfs_lookup_open(fname, WALK_REGULAR, MODE_READ, &fd);
 	if (rc != EOK) {
-		rc = send_response(conn, msg_not_found);
+		rc = send_response(wconn, "404 Not Found", msg_not_found);
 		goto out;
 	}
 
 	free(fname);
 	fname = NULL;
 
-	rc = send_response(conn, msg_ok);
+	rc = vfs_stat(fd, &stat);
 	if (rc != EOK)
 		goto out;
 
-	aoff64_t pos = 0;
-	while (true) {
-		rc = vfs_read(fd, &pos, fbuf, BUFFER_SIZE, &nr);
-		if (rc != EOK)
-			goto out;
+	rc = send_headers(wconn, "200 OK", stat.size);
+	if (rc != EOK || wconn->head)
+		goto out;
 
-		if (nr == 0)
-			break;
+	/* The file goes from the file system straight to the TCP connection */
+	aoff64_t pos = 0;
+	rc = tcp_conn_send_file(wconn->conn, fd, &pos, stat.size, &nsent);
+	if (rc != EOK) {
+		fprintf(stderr, "tcp_conn_send_file() failed\n");
+		goto out;
+	}
 
-		rc = tcp_conn_send(conn, fbuf, nr);
-		if (rc != EOK) {
-			fprintf(stderr, "tcp_conn_send() failed\n");
-			goto out;
-		}
+	/* The length has been announced, the file must not have shrunk */
+	if (nsent != stat.size) {
+		rc = EIO;
+		goto out;
 	}
 
 	rc = EOK;
@@ -296,45 +311,104 @@ out:
 	if (fd >= 0)
 		vfs_put(fd);
 	free(fname);
-	free(fbuf);
 	return rc;
 }
 
-static errno_t req_process(tcp_conn_t *conn, recv_t *recv)
+/** Decide whether the connection persists after the request.
+ *
+ * HTTP/1.1 connections persist unless the client asks otherwise,
+ * HTTP/1.0 ones only if the client asks for it.
+ */
+static bool req_keep_alive(http_headers_t *headers, bool http11)
 {
-	char *reqline = NULL;
+	http_header_t *header;
+	errno_t rc;
+
+	rc = http_headers_find_single(headers, "Connection", &header);
+	if (rc != EOK)
+		return http11;
 
-	errno_t rc = recv_line(recv, &reqline);
+	if (str_casecmp(header->value, "close") == 0)
+		return false;
+	if (str_casecmp(header->value, "keep-alive") == 0)
+		return true;
+
+	return http11;
+}
+
+/** Receive and process one request.
+ *
+ * @return EOK on success, ENOENT if the client closed the connection
+ *         before sending a request or an error code
+ */
+static errno_t req_process(websrv_conn_t *wconn)
+{
+	http_headers_t headers;
+	char *reqline = wconn->lbuf;
+	size_t nrecv;
+	bool http11;
+	errno_t rc;
+
+	rc = recv_line(&wconn->rbuf, reqline, BUFFER_SIZE, &nrecv);
 	if (rc != EOK) {
-		fprintf(stderr, "recv_line() failed\n");
+		if (rc != ENOENT)
+			fprintf(stderr, "recv_line() failed\n");
 		return rc;
 	}
 
+	/* Ignore empty lines between requests (RFC 7230 3.5) */
+	if (reqline[0] == '\0')
+		return EOK;
+
 	if (verbose)
-		fprintf(stderr, "Request: %s", reqline);
+		fprintf(stderr, "Request: %s\n", reqline);
 
-	if (str_lcmp(reqline, "GET ", 4) != 0) {
-		rc = send_response(conn, msg_not_implemented);
+	http_headers_init(&headers);
+	rc = http_headers_receive(&wconn->rbuf, &headers, HEADERS_SIZE_MAX,
+	    HEADERS_COUNT_MAX);
+	if (rc == EOK)
+		rc = recv_eol(&wconn->rbuf, &nrecv);
+	if (rc != EOK) {
+		http_headers_clear(&headers);
+		wconn->close = true;
+		wconn->head = false;
+		if (rc == ELIMIT)
+			return send_response(wconn, "400 Bad Request", msg_bad_request);
 		return rc;
 	}
 
-	char *uri = reqline + 4;
-	char *end_uri = str_chr(uri, ' ');
-	if (end_uri == NULL) {
-		end_uri = reqline + str_size(reqline) - 2;
-		assert(*end_uri == '\r');
+	wconn->head = str_lcmp(reqline, "HEAD ", 5) == 0;
+	char *uri;
+	if (str_lcmp(reqline, "GET ", 4) == 0) {
+		uri = reqline + 4;
+	} else if (wconn->head) {
+		uri = reqline + 5;
+	} else {
+		http_headers_clear(&headers);
+		wconn->close = true;
+		return send_response(wconn, "501 Not Implemented",
+		    msg_not_implemented);
 	}
 
-	*end_uri = '\0';
+	char *version = str_chr(uri, ' ');
+	if (version != NULL) {
+		*version++ = '\0';
+		http11 = str_cmp(version, "HTTP/1.1") == 0;
+	} else {
+		/* HTTP/0.9 simple request */
+		http11 = false;
+	}
+
+	wconn->close = !req_keep_alive(&headers, http11);
+	http_headers_clear(&headers);
+
 	if (verbose)
 		fprintf(stderr, "Requested URI: %s\n", uri);
 
-	if (!uri_is_valid(uri)) {
-		rc = send_response(conn, msg_bad_request);
-		return rc;
-	}
+	if (!uri_is_valid(uri))
+		return send_response(wconn, "400 Bad Request", msg_bad_request);
 
-	return uri_get(uri, conn);
+	return uri_get(uri, wconn);
 }
 
 static void usage(void)
@@ -402,22 +476,28 @@ static errno_t parse_option(int argc, char *argv[], int *index)
 static void websrv_new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
 {
 	errno_t rc;
-	recv_t *recv = NULL;
+	websrv_conn_t *wconn = NULL;
 
 	if (verbose)
 		fprintf(stderr, "New connection, waiting for request\n");
 
-	rc = recv_create(conn, &recv);
+	rc = websrv_conn_create(conn, &wconn);
 	if (rc != EOK) {
 		fprintf(stderr, "Out of memory.\n");
 		goto error;
 	}
 
-	rc = req_process(conn, recv);
-	if (rc != EOK) {
-		fprintf(stderr, "Error processing request (%s)\n",
-		    str_error(rc));
-		goto error;
+	/* Serve requests until the client or we close the connection */
+	while (!wconn->close) {
+		rc = req_process(wconn);
+		if (rc == ENOENT)
+			break;
+
+		if (rc != EOK) {
+			fprintf(stderr, "Error processing request (%s)\n",
+			    str_error(rc));
+			goto error;
+		}
 	}
 
 	rc = tcp_conn_send_fin(conn);
@@ -426,14 +506,14 @@ static void websrv_new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
 		goto error;
 	}
 
-	recv_destroy(recv);
+	websrv_conn_destroy(wconn);
 	return;
 error:
 	rc = tcp_conn_reset(conn);
 	if (rc != EOK)
 		fprintf(stderr, "Error resetting connection.\n");
 
-	recv_destroy(recv);
+	websrv_conn_destroy(wconn);
 }
 
 int main(int argc, char *argv[])
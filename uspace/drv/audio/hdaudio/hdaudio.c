@@ -239,6 +239,7 @@ static errno_t hda_dev_add(ddf_dev_t *dev)
 	irq_code.ranges = hdaudio_irq_pio_ranges;
 	irq_code.cmdcount = ncmds;
 	irq_code.cmds = cmds;
+	irq_code.flags = 0;
 
 	hda_regs_t *rphys = (hda_regs_t *)(uintptr_t)hda->rwbase;
 	hdaudio_irq_pio_ranges[0].base = (uintptr_t)hda->rwbase;
@@ -111,7 +111,8 @@ static unsigned hda_query_cap(ddf_fun_t *fun, audio_cap_t cap)
 		/* Yes if we have an input converter */
 		return hda->ctl->codec->in_aw >= 0;
 	case AUDIO_CAP_BUFFER_POS:
-		return 0;
+		/* Link position in buffer register */
+		return 1;
 	case AUDIO_CAP_MAX_BUFFER:
 		return max_buffer_size;
 	case AUDIO_CAP_INTERRUPT_MIN_FRAMES:
@@ -184,8 +185,23 @@ static errno_t hda_get_buffer(ddf_fun_t *fun, void **buffer, size_t *size)
 
 static errno_t hda_get_buffer_position(ddf_fun_t *fun, size_t *pos)
 {
-	ddf_msg(LVL_DEBUG, "hda_get_buffer_position()");
-	return ENOTSUP;
+	hda_t *hda = fun_to_hda(fun);
+
+	ddf_msg(LVL_DEBUG2, "hda_get_buffer_position()");
+	hda_lock(hda);
+
+	if (hda->pcm_buffers == NULL) {
+		hda_unlock(hda);
+		return ENOENT;
+	}
+
+	/* The buffer is not played or recorded until a stream is started */
+	*pos = 0;
+	if (hda->pcm_stream != NULL)
+		*pos = hda_stream_get_position(hda->pcm_stream);
+
+	hda_unlock(hda);
+	return EOK;
 }
 
 static errno_t hda_set_event_session(ddf_fun_t *fun, async_sess_t *sess)
@@ -274,6 +274,19 @@ void hda_stream_stop(hda_stream_t *stream)
 	hda_stream_set_run(stream, false);
 }
 
+/** Get stream position in the cyclic buffer.
+ *
+ * @param stream Stream
+ * @return Byte offset of the DMA position from the start of the buffer
+ */
+size_t hda_stream_get_position(hda_stream_t *stream)
+{
+	hda_sdesc_regs_t *sdregs;
+
+	sdregs = &stream->hda->regs->sdesc[stream->sdid];
+	return hda_reg32_read(&sdregs->lpib);
+}
+
 void hda_stream_reset(hda_stream_t *stream)
 {
 	ddf_msg(LVL_DEBUG, "hda_stream_reset()");
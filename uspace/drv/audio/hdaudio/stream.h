@@ -84,6 +84,7 @@ extern void hda_stream_destroy(hda_stream_t *);
 extern void hda_stream_start(hda_stream_t *);
 extern void hda_stream_stop(hda_stream_t *);
 extern void hda_stream_reset(hda_stream_t *);
+extern size_t hda_stream_get_position(hda_stream_t *);
 
 #endif
 
@@ -31,7 +31,9 @@
  */
 
 #include <as.h>
+#include <assert.h>
 #include <errno.h>
+#include <macros.h>
 #include <stdio.h>
 #include <ddf/interrupt.h>
 #include <ddf/log.h>
@@ -45,6 +47,12 @@
 
 #define NAME  "ahci"
 
+/** Maximum number of blocks transferred by one command. */
+#define AHCI_MAX_XFER_BLOCKS  256
+
+/** Maximum size of the bounce buffer of one read or write request. */
+#define AHCI_MAX_BUF_BYTES  (1024 * 1024)
+
 #define LO(ptr) \
 	((uint32_t) (((uint64_t) ((uintptr_t) (ptr))) & 0xffffffff))
 
@@ -116,8 +124,9 @@ static errno_t write_blocks(ddf_fun_t *, uint64_t, size_t, void *);
 
 static errno_t ahci_identify_device(sata_dev_t *);
 static errno_t ahci_set_highest_ultra_dma_mode(sata_dev_t *);
-static errno_t ahci_rb_fpdma(sata_dev_t *, uintptr_t, uint64_t);
-static errno_t ahci_wb_fpdma(sata_dev_t *, uintptr_t, uint64_t);
+static errno_t ahci_rw_fpdma_start(sata_dev_t *, bool, uintptr_t, uint64_t,
+    size_t, unsigned int *);
+static errno_t ahci_rw_fpdma_wait(sata_dev_t *, bool, unsigned int);
 
 static void ahci_sata_devices_create(ahci_dev_t *, ddf_dev_t *);
 static ahci_dev_t *ahci_ahci_create(ddf_dev_t *);
@@ -214,49 +223,125 @@ static errno_t get_block_size(ddf_fun_t *fun, size_t *block_size)
 	return EOK;
 }
 
-/** Read data blocks into SATA device.
+/** Wait for the commands started by rw_blocks().
  *
- * @param fun      Device function handling the call.
+ * @param sata   SATA device structure.
+ * @param write  True to write, false to read.
+ * @param slot   Command slots of the commands.
+ * @param nslots Number of commands, set to zero on return.
+ *
+ * @return EOK if all commands succeeded, error code otherwise
+ *
+ */
+static errno_t rw_blocks_wait(sata_dev_t *sata, bool write,
+    unsigned int *slot, unsigned int *nslots)
+{
+	errno_t rc = EOK;
+
+	for (unsigned int i = 0; i < *nslots; i++) {
+		errno_t wrc = ahci_rw_fpdma_wait(sata, write, slot[i]);
+		if (wrc != EOK && rc == EOK)
+			rc = wrc;
+	}
+
+	*nslots = 0;
+	return rc;
+}
+
+/** Read or write data blocks of SATA device.
+ *
+ * The transfer goes through a bounce buffer of up to AHCI_MAX_BUF_BYTES.
+ * The commands needed to transfer one buffer are queued in the device
+ * together, each in a command slot of its own, before waiting for any of
+ * them.
+ *
+ * @param sata     SATA device structure.
+ * @param write    True to write, false to read.
  * @param blocknum Number of first block.
- * @param count    Number of blocks to read.
+ * @param count    Number of blocks.
  * @param buf      Buffer for data.
  *
  * @return EOK if succeed, error code otherwise
  *
  */
-static errno_t read_blocks(ddf_fun_t *fun, uint64_t blocknum,
+static errno_t rw_blocks(sata_dev_t *sata, bool write, uint64_t blocknum,
     size_t count, void *buf)
 {
-	sata_dev_t *sata = fun_sata_dev(fun);
+	size_t max_cnt = min(count,
+	    max((size_t) AHCI_MAX_BUF_BYTES / sata->block_size,
+	    (size_t) AHCI_MAX_XFER_BLOCKS));
+	unsigned int slot[AHCI_MAX_BUF_BYTES / 512 / AHCI_MAX_XFER_BLOCKS];
+	unsigned int window = min(sata->slots,
+	    (unsigned int) (sizeof(slot) / sizeof(slot[0])));
+	errno_t rc;
 
 	uintptr_t phys;
 	void *ibuf = AS_AREA_ANY;
-	errno_t rc = dmamem_map_anonymous(sata->block_size, DMAMEM_4GiB,
-	    AS_AREA_READ | AS_AREA_WRITE, 0, &phys, &ibuf);
+	rc = dmamem_map_anonymous(max_cnt * sata->block_size,
+	    DMAMEM_4GiB, AS_AREA_READ | AS_AREA_WRITE, 0, &phys, &ibuf);
 	if (rc != EOK) {
-		ddf_msg(LVL_ERROR, "Cannot allocate read buffer.");
+		ddf_msg(LVL_ERROR, "Cannot allocate %s buffer.",
+		    write ? "write" : "read");
 		return rc;
 	}
 
-	memset(buf, 0, sata->block_size);
+	for (size_t cur = 0; cur < count && rc == EOK; cur += max_cnt) {
+		size_t cnt = min(count - cur, max_cnt);
+		uint8_t *data = (uint8_t *) buf + sata->block_size * cur;
+		unsigned int nslots = 0;
+
+		if (write)
+			memcpy(ibuf, data, sata->block_size * cnt);
+
+		for (size_t i = 0; i < cnt && rc == EOK;
+		    i += AHCI_MAX_XFER_BLOCKS) {
+			size_t n = min(cnt - i, (size_t) AHCI_MAX_XFER_BLOCKS);
+
+			/*
+			 * Never hold more slots than the device has, they
+			 * are only released by waiting for the commands.
+			 */
+			if (nslots == window)
+				rc = rw_blocks_wait(sata, write, slot, &nslots);
+			if (rc != EOK)
+				break;
+
+			rc = ahci_rw_fpdma_start(sata, write,
+			    phys + i * sata->block_size, blocknum + cur + i, n,
+			    &slot[nslots]);
+			if (rc == EOK)
+				nslots++;
+		}
 
-	fibril_mutex_lock(&sata->lock);
+		errno_t wrc = rw_blocks_wait(sata, write, slot, &nslots);
+		if (rc == EOK)
+			rc = wrc;
 
-	for (size_t cur = 0; cur < count; cur++) {
-		rc = ahci_rb_fpdma(sata, phys, blocknum + cur);
-		if (rc != EOK)
-			break;
-
-		memcpy((void *) (((uint8_t *) buf) + (sata->block_size * cur)),
-		    ibuf, sata->block_size);
+		if (rc == EOK && !write)
+			memcpy(data, ibuf, sata->block_size * cnt);
 	}
 
-	fibril_mutex_unlock(&sata->lock);
 	dmamem_unmap_anonymous(ibuf);
 
 	return rc;
 }
 
+/** Read data blocks from SATA device.
+ *
+ * @param fun      Device function handling the call.
+ * @param blocknum Number of first block.
+ * @param count    Number of blocks to read.
+ * @param buf      Buffer for data.
+ *
+ * @return EOK if succeed, error code otherwise
+ *
+ */
+static errno_t read_blocks(ddf_fun_t *fun, uint64_t blocknum,
+    size_t count, void *buf)
+{
+	return rw_blocks(fun_sata_dev(fun), false, blocknum, count, buf);
+}
+
 /** Write data blocks into SATA device.
  *
  * @param fun      Device function handling the call.
@@ -270,31 +355,7 @@ static errno_t read_blocks(ddf_fun_t *fun, uint64_t blocknum,
 static errno_t write_blocks(ddf_fun_t *fun, uint64_t blocknum,
     size_t count, void *buf)
 {
-	sata_dev_t *sata = fun_sata_dev(fun);
-
-	uintptr_t phys;
-	void *ibuf = AS_AREA_ANY;
-	errno_t rc = dmamem_map_anonymous(sata->block_size, DMAMEM_4GiB,
-	    AS_AREA_READ | AS_AREA_WRITE, 0, &phys, &ibuf);
-	if (rc != EOK) {
-		ddf_msg(LVL_ERROR, "Cannot allocate write buffer.");
-		return rc;
-	}
-
-	fibril_mutex_lock(&sata->lock);
-
-	for (size_t cur = 0; cur < count; cur++) {
-		memcpy(ibuf, (void *) (((uint8_t *) buf) + (sata->block_size * cur)),
-		    sata->block_size);
-		rc = ahci_wb_fpdma(sata, phys, blocknum + cur);
-		if (rc != EOK)
-			break;
-	}
-
-	fibril_mutex_unlock(&sata->lock);
-	dmamem_unmap_anonymous(ibuf);
-
-	return rc;
+	return rw_blocks(fun_sata_dev(fun), true, blocknum, count, buf);
 }
 
 /*
@@ -469,6 +530,9 @@ static errno_t ahci_identify_device(sata_dev_t *sata)
 
 	ahci_get_model_name(idata->model_name, sata->model);
 
+	/* Number of outstanding NCQ commands the device accepts. */
+	sata->queue_depth = (idata->queue_depth & 0x1f) + 1;
+
 	/*
 	 * Due to QEMU limitation (as of 2012-06-22),
 	 * only NCQ FPDMA mode is supported.
@@ -668,23 +732,27 @@ error:
 	return EINTR;
 }
 
-/** Set AHCI registers for reading one sector from the SATA device using FPDMA.
+/** Set up a command slot for reading or writing sectors using FPDMA.
  *
  * @param sata     SATA device structure.
+ * @param slot     Command slot, also used as the NCQ tag.
+ * @param write    True to write, false to read.
  * @param phys     Physical address of buffer for sector data.
- * @param blocknum Block number to read.
+ * @param blocknum Number of first block.
+ * @param count    Number of blocks.
  *
  */
-static void ahci_rb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
-    uint64_t blocknum)
+static void ahci_rw_fpdma_cmd(sata_dev_t *sata, unsigned int slot, bool write,
+    uintptr_t phys, uint64_t blocknum, size_t count)
 {
+	volatile uint32_t *table = sata->slot_table[slot];
 	volatile sata_ncq_command_frame_t *cmd =
-	    (sata_ncq_command_frame_t *) sata->cmd_table;
+	    (sata_ncq_command_frame_t *) table;
 
 	cmd->fis_type = SATA_CMD_FIS_TYPE;
 	cmd->c = SATA_CMD_FIS_COMMAND_INDICATOR;
-	cmd->command = 0x60;
-	cmd->tag = 0;
+	cmd->command = write ? 0x61 : 0x60;
+	cmd->tag = slot << 3;
 	cmd->control = 0;
 
 	cmd->reserved1 = 0;
@@ -694,8 +762,8 @@ static void ahci_rb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
 	cmd->reserved5 = 0;
 	cmd->reserved6 = 0;
 
-	cmd->sector_count_low = 1;
-	cmd->sector_count_high = 0;
+	cmd->sector_count_low = count & 0xff;
+	cmd->sector_count_high = (count >> 8) & 0xff;
 
 	cmd->lba0 = blocknum & 0xff;
 	cmd->lba1 = (blocknum >> 8) & 0xff;
@@ -705,140 +773,143 @@ static void ahci_rb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
 	cmd->lba5 = (blocknum >> 40) & 0xff;
 
 	volatile ahci_cmd_prdt_t *prdt =
-	    (ahci_cmd_prdt_t *) (&sata->cmd_table[0x20]);
+	    (ahci_cmd_prdt_t *) (&table[0x20]);
 
 	prdt->data_address_low = LO(phys);
 	prdt->data_address_upper = HI(phys);
 	prdt->reserved1 = 0;
-	prdt->dbc = sata->block_size - 1;
+	prdt->dbc = count * sata->block_size - 1;
 	prdt->reserved2 = 0;
 	prdt->ioc = 0;
 
-	sata->cmd_header->prdtl = 1;
-	sata->cmd_header->flags =
+	volatile ahci_cmdhdr_t *hdr = &sata->cmd_header[slot];
+
+	hdr->prdtl = 1;
+	hdr->flags =
 	    AHCI_CMDHDR_FLAGS_CLEAR_BUSY_UPON_OK |
+	    (write ? AHCI_CMDHDR_FLAGS_WRITE : 0) |
 	    AHCI_CMDHDR_FLAGS_5DWCMD;
-	sata->cmd_header->bytesprocessed = 0;
-
-	sata->port->pxsact |= 1;
-	sata->port->pxci |= 1;
+	hdr->bytesprocessed = 0;
 }
 
-/** Read one sector from the SATA device using FPDMA.
+/** Start reading or writing sectors using FPDMA.
+ *
+ * Each command uses a command slot of its own, so that up to sata->slots
+ * commands can be queued in the device at the same time. The caller waits
+ * for the command using ahci_rw_fpdma_wait().
  *
  * @param sata     SATA device structure.
+ * @param write    True to write, false to read.
  * @param phys     Physical address of buffer for sector data.
- * @param blocknum Block number to read.
+ * @param blocknum Number of first block.
+ * @param count    Number of blocks, at most AHCI_MAX_XFER_BLOCKS.
+ * @param rslot    Place to store the command slot used.
  *
  * @return EOK if succeed, error code otherwise
  *
  */
-static errno_t ahci_rb_fpdma(sata_dev_t *sata, uintptr_t phys, uint64_t blocknum)
+static errno_t ahci_rw_fpdma_start(sata_dev_t *sata, bool write,
+    uintptr_t phys, uint64_t blocknum, size_t count, unsigned int *rslot)
 {
+	uint32_t slots_mask = (sata->slots >= AHCI_MAX_SLOTS) ? 0xffffffff :
+	    (1U << sata->slots) - 1;
+	unsigned int slot;
+
 	if (sata->is_invalid_device) {
-		ddf_msg(LVL_ERROR,
-		    "%s: FPDMA read from invalid device", sata->model);
+		ddf_msg(LVL_ERROR, "%s: FPDMA %s invalid device", sata->model,
+		    write ? "write to" : "read from");
 		return EINTR;
 	}
 
-	ahci_rb_fpdma_cmd(sata, phys, blocknum);
-	ahci_port_is_t pxis = ahci_wait_event(sata);
+	assert(count > 0 && count <= AHCI_MAX_XFER_BLOCKS);
 
-	if ((sata->is_invalid_device) || (ahci_port_is_error(pxis))) {
-		ddf_msg(LVL_ERROR,
-		    "%s: Unrecoverable error during FPDMA read", sata->model);
-		return EINTR;
+	/* Allocate a command slot. */
+	fibril_mutex_lock(&sata->slot_lock);
+	while ((sata->slots_busy & slots_mask) == slots_mask)
+		fibril_condvar_wait(&sata->slot_condvar, &sata->slot_lock);
+
+	for (slot = 0; slot < sata->slots; slot++) {
+		if ((sata->slots_busy & (1U << slot)) == 0)
+			break;
 	}
 
+	sata->slots_busy |= 1U << slot;
+	fibril_mutex_unlock(&sata->slot_lock);
+
+	ahci_rw_fpdma_cmd(sata, slot, write, phys, blocknum, count);
+
+	/* Issue the command. */
+	fibril_mutex_lock(&sata->slot_lock);
+	sata->slots_issued |= 1U << slot;
+	sata->port->pxsact = 1U << slot;
+	sata->port->pxci = 1U << slot;
+	fibril_mutex_unlock(&sata->slot_lock);
+
+	*rslot = slot;
 	return EOK;
 }
 
-/** Set AHCI registers for writing one sector to the SATA device, use FPDMA.
+/** Wait for the completion of a command started by ahci_rw_fpdma_start().
  *
- * @param sata     SATA device structure.
- * @param phys     Physical address of buffer with sector data.
- * @param blocknum Block number to write.
+ * @param sata  SATA device structure.
+ * @param write True if the command writes, false if it reads.
+ * @param slot  Command slot of the command.
  *
  * @return EOK if succeed, error code otherwise
  *
  */
-static void ahci_wb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
-    uint64_t blocknum)
+static errno_t ahci_rw_fpdma_wait(sata_dev_t *sata, bool write,
+    unsigned int slot)
 {
-	volatile sata_ncq_command_frame_t *cmd =
-	    (sata_ncq_command_frame_t *) sata->cmd_table;
+	bool failed;
 
-	cmd->fis_type = SATA_CMD_FIS_TYPE;
-	cmd->c = SATA_CMD_FIS_COMMAND_INDICATOR;
-	cmd->command = 0x61;
-	cmd->tag = 0;
-	cmd->control = 0;
+	fibril_mutex_lock(&sata->slot_lock);
 
-	cmd->reserved1 = 0;
-	cmd->reserved2 = 0;
-	cmd->reserved3 = 0;
-	cmd->reserved4 = 0;
-	cmd->reserved5 = 0;
-	cmd->reserved6 = 0;
+	while ((sata->slots_issued & (1U << slot)) != 0)
+		fibril_condvar_wait(&sata->slot_condvar, &sata->slot_lock);
 
-	cmd->sector_count_low = 1;
-	cmd->sector_count_high = 0;
+	failed = (sata->slots_failed & (1U << slot)) != 0;
+	sata->slots_failed &= ~(1U << slot);
+	sata->slots_busy &= ~(1U << slot);
+	fibril_condvar_broadcast(&sata->slot_condvar);
 
-	cmd->lba0 = blocknum & 0xff;
-	cmd->lba1 = (blocknum >> 8) & 0xff;
-	cmd->lba2 = (blocknum >> 16) & 0xff;
-	cmd->lba3 = (blocknum >> 24) & 0xff;
-	cmd->lba4 = (blocknum >> 32) & 0xff;
-	cmd->lba5 = (blocknum >> 40) & 0xff;
-
-	volatile ahci_cmd_prdt_t *prdt =
-	    (ahci_cmd_prdt_t *) (&sata->cmd_table[0x20]);
+	fibril_mutex_unlock(&sata->slot_lock);
 
-	prdt->data_address_low = LO(phys);
-	prdt->data_address_upper = HI(phys);
-	prdt->reserved1 = 0;
-	prdt->dbc = sata->block_size - 1;
-	prdt->reserved2 = 0;
-	prdt->ioc = 0;
-
-	sata->cmd_header->prdtl = 1;
-	sata->cmd_header->flags =
-	    AHCI_CMDHDR_FLAGS_CLEAR_BUSY_UPON_OK |
-	    AHCI_CMDHDR_FLAGS_WRITE |
-	    AHCI_CMDHDR_FLAGS_5DWCMD;
-	sata->cmd_header->bytesprocessed = 0;
+	if ((sata->is_invalid_device) || failed) {
+		ddf_msg(LVL_ERROR, "%s: Unrecoverable error during FPDMA %s",
+		    sata->model, write ? "write" : "read");
+		return EINTR;
+	}
 
-	sata->port->pxsact |= 1;
-	sata->port->pxci |= 1;
+	return EOK;
 }
 
-/** Write one sector into the SATA device, use FPDMA.
- *
- * @param sata     SATA device structure.
- * @param phys     Physical address of buffer with sector data.
- * @param blocknum Block number to write.
+/** Complete issued FPDMA commands.
  *
- * @return EOK if succeed, error code otherwise
+ * @param sata SATA device structure.
+ * @param pxis Value of interrupt state register.
  *
  */
-static errno_t ahci_wb_fpdma(sata_dev_t *sata, uintptr_t phys, uint64_t blocknum)
+static void ahci_complete_slots(sata_dev_t *sata, ahci_port_is_t pxis)
 {
-	if (sata->is_invalid_device) {
-		ddf_msg(LVL_ERROR,
-		    "%s: FPDMA write to invalid device", sata->model);
-		return EINTR;
-	}
-
-	ahci_wb_fpdma_cmd(sata, phys, blocknum);
-	ahci_port_is_t pxis = ahci_wait_event(sata);
+	fibril_mutex_lock(&sata->slot_lock);
 
-	if ((sata->is_invalid_device) || (ahci_port_is_error(pxis))) {
-		ddf_msg(LVL_ERROR,
-		    "%s: Unrecoverable error during FPDMA write", sata->model);
-		return EINTR;
+	if (ahci_port_is_error(pxis)) {
+		/* Fail all outstanding commands. */
+		sata->slots_failed |= sata->slots_issued;
+		sata->slots_issued = 0;
+	} else {
+		/*
+		 * A command is complete once the HBA has cleared its PxCI
+		 * bit and the device its PxSACT bit. Every command which
+		 * completed since the last interrupt is reaped here, so one
+		 * interrupt covers a whole batch of completions.
+		 */
+		sata->slots_issued &= sata->port->pxsact | sata->port->pxci;
 	}
 
-	return EOK;
+	fibril_condvar_broadcast(&sata->slot_condvar);
+	fibril_mutex_unlock(&sata->slot_lock);
 }
 
 /*
@@ -915,6 +986,8 @@ static void ahci_interrupt(ipc_call_t *icall, ddf_dev_t *dev)
 		fibril_condvar_signal(&sata->event_condvar);
 
 		fibril_mutex_unlock(&sata->event_lock);
+
+		ahci_complete_slots(sata, pxis);
 	}
 }
 
@@ -978,9 +1051,30 @@ static sata_dev_t *ahci_sata_allocate(ahci_dev_t *ahci, volatile ahci_port_t *po
 	sata->cmd_header->cmdtableu = HI(phys);
 	sata->cmd_header->cmdtable = LO(phys);
 	sata->cmd_table = (uint32_t *) virt_table;
+	sata->slot_table[0] = sata->cmd_table;
+
+	/* Allocate and init command tables of the other command slots. */
+	sata->slot_tables = AS_AREA_ANY;
+	rc = dmamem_map_anonymous(AHCI_MAX_SLOTS * AHCI_SLOT_TABLE_SIZE,
+	    DMAMEM_4GiB, AS_AREA_READ | AS_AREA_WRITE, 0, &phys,
+	    &sata->slot_tables);
+	if (rc != EOK)
+		goto error_slots;
+
+	memset(sata->slot_tables, 0, AHCI_MAX_SLOTS * AHCI_SLOT_TABLE_SIZE);
+	for (unsigned int slot = 1; slot < AHCI_MAX_SLOTS; slot++) {
+		uintptr_t offs = slot * AHCI_SLOT_TABLE_SIZE;
+
+		sata->cmd_header[slot].cmdtableu = HI(phys + offs);
+		sata->cmd_header[slot].cmdtable = LO(phys + offs);
+		sata->slot_table[slot] =
+		    (uint32_t *) ((uint8_t *) sata->slot_tables + offs);
+	}
 
 	return sata;
 
+error_slots:
+	dmamem_unmap(virt_table, size);
 error_table:
 	dmamem_unmap(virt_cmd, size);
 error_cmd:
@@ -1056,6 +1150,8 @@ static errno_t ahci_sata_create(ahci_dev_t *ahci, ddf_dev_t *dev,
 	fibril_mutex_initialize(&sata->lock);
 	fibril_mutex_initialize(&sata->event_lock);
 	fibril_condvar_initialize(&sata->event_condvar);
+	fibril_mutex_initialize(&sata->slot_lock);
+	fibril_condvar_initialize(&sata->slot_condvar);
 
 	ahci_sata_hw_start(sata);
 
@@ -1067,6 +1163,15 @@ static errno_t ahci_sata_create(ahci_dev_t *ahci, ddf_dev_t *dev,
 	if (ahci_set_highest_ultra_dma_mode(sata) != EOK)
 		goto error;
 
+	/*
+	 * Non-queued commands above use command slot 0. From now on, only
+	 * FPDMA commands are issued and each uses a slot of its own.
+	 */
+	ahci_ghc_cap_t cap;
+	cap.u32 = ahci->memregs->ghc.cap;
+	sata->slots = min((unsigned int) cap.ncs + 1,
+	    (unsigned int) sata->queue_depth);
+
 	/* Add device to the system */
 	char sata_dev_name[16];
 	snprintf(sata_dev_name, 16, "ahci_%u", sata_devices_count);
@@ -1182,6 +1287,7 @@ static ahci_dev_t *ahci_ahci_create(ddf_dev_t *dev)
 	ct.cmds = ahci_cmds;
 	ct.rangecount = sizeof(ahci_ranges) / sizeof(irq_pio_range_t);
 	ct.ranges = ahci_ranges;
+	ct.flags = 0;
 
 	cap_irq_handle_t irq_cap;
 	errno_t rc = register_interrupt_handler(dev,
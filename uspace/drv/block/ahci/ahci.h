@@ -40,6 +40,12 @@
 #include <stdint.h>
 #include "ahci_hw.h"
 
+/** Maximum number of command slots of a port. */
+#define AHCI_MAX_SLOTS  32
+
+/** Size of the command table of one command slot. */
+#define AHCI_SLOT_TABLE_SIZE  256
+
 /** AHCI Device. */
 typedef struct {
 	/** Pointer to ddf device. */
@@ -78,6 +84,30 @@ typedef struct {
 	/** Pointer to command table. */
 	volatile uint32_t *cmd_table;
 
+	/** Command tables of the other command slots. */
+	volatile uint32_t *slot_table[AHCI_MAX_SLOTS];
+
+	/** Virtual address of the command tables of the other slots. */
+	void *slot_tables;
+
+	/** Number of command slots used for NCQ commands. */
+	unsigned int slots;
+
+	/** Mutex for command slot allocation and completion. */
+	fibril_mutex_t slot_lock;
+
+	/** Signalled when a command slot completes or becomes free. */
+	fibril_condvar_t slot_condvar;
+
+	/** Command slots in use. */
+	uint32_t slots_busy;
+
+	/** Command slots issued to the device and not completed yet. */
+	uint32_t slots_issued;
+
+	/** Command slots completed with an error. */
+	uint32_t slots_failed;
+
 	/** Mutex for single operation on device. */
 	fibril_mutex_t lock;
 
@@ -104,6 +134,9 @@ typedef struct {
 
 	/** Highest UDMA mode supported. */
 	uint8_t highest_udma_mode;
+
+	/** NCQ queue depth of the device. */
+	unsigned int queue_depth;
 } sata_dev_t;
 
 #endif
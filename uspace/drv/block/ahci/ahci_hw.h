@@ -1004,6 +1004,8 @@ typedef volatile struct {
 	uint32_t cmdtable;
 	/** Command Table Descriptor Base Address Upper 32-bits. */
 	uint32_t cmdtableu;
+	/** Reserved. */
+	uint32_t reserved[4];
 } ahci_cmdhdr_t;
 
 /** Clear Busy upon R_OK (C) flag. */
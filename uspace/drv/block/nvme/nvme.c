@@ -0,0 +1,1228 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup nvme
+ * @{
+ */
+/** @file NVM Express driver
+ *
+ * The admin queues are only used during initialization and their commands
+ * are polled. One I/O queue pair is created per CPU, each with its own
+ * MSI-X vector if the device and the platform support it. Every command
+ * slot of an I/O queue owns a physically contiguous data buffer which is
+ * described by a PRP list, or by a single SGL data block descriptor if the
+ * controller supports SGLs.
+ */
+
+#include <as.h>
+#include <assert.h>
+#include <barrier.h>
+#include <byteorder.h>
+#include <ddf/driver.h>
+#include <ddf/interrupt.h>
+#include <ddf/log.h>
+#include <device/hw_res.h>
+#include <device/hw_res_parsed.h>
+#include <errno.h>
+#include <fibril.h>
+#include <macros.h>
+#include <mem.h>
+#include <stats.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+
+#include "nvme.h"
+
+#define NAME	"nvme"
+
+static errno_t nvme_dev_add(ddf_dev_t *);
+static void nvme_io_complete(nvme_t *, nvme_queue_t *, uint16_t);
+
+static driver_ops_t nvme_driver_ops = {
+	.dev_add = nvme_dev_add
+};
+
+static driver_t nvme_driver = {
+	.name = NAME,
+	.driver_ops = &nvme_driver_ops
+};
+
+/** Allocate a zeroed DMA buffer. */
+static errno_t nvme_dma_alloc(size_t size, void **virt, uintptr_t *phys)
+{
+	*virt = AS_AREA_ANY;
+	errno_t rc = dmamem_map_anonymous(size, 0, AS_AREA_READ | AS_AREA_WRITE,
+	    0, phys, virt);
+	if (rc != EOK) {
+		*virt = NULL;
+		return rc;
+	}
+
+	memset(*virt, 0, size);
+	return EOK;
+}
+
+/** Free a DMA buffer allocated by nvme_dma_alloc(). */
+static void nvme_dma_free(void **virt)
+{
+	if (*virt != NULL) {
+		dmamem_unmap_anonymous(*virt);
+		*virt = NULL;
+	}
+}
+
+/** Get the doorbell register of a queue.
+ *
+ * @param nvme	Controller
+ * @param qid	Queue identifier
+ * @param cq	@c true for the completion queue head doorbell, @c false for
+ *		the submission queue tail doorbell
+ */
+static ioport32_t *nvme_doorbell(nvme_t *nvme, uint16_t qid, bool cq)
+{
+	return (ioport32_t *) ((uint8_t *) nvme->regs + NVME_DOORBELL_OFFSET +
+	    (2 * qid + (cq ? 1 : 0)) * nvme->db_stride);
+}
+
+/** Translate the status field of a completion to an error code. */
+static errno_t nvme_status_errno(uint16_t status)
+{
+	if (status == 0)
+		return EOK;
+
+	ddf_msg(LVL_DEBUG, "Command failed, status type %u, code 0x%02x",
+	    (status >> 8) & 0x7, status & 0xff);
+	return EIO;
+}
+
+/** Allocate the rings of a queue pair. */
+static errno_t nvme_queue_alloc(nvme_t *nvme, nvme_queue_t *q, uint16_t qid,
+    uint16_t size)
+{
+	errno_t rc;
+
+	q->qid = qid;
+	q->size = size;
+	q->sq_tail = 0;
+	q->cq_head = 0;
+	q->phase = 1;
+	q->sq_db = nvme_doorbell(nvme, qid, false);
+	q->cq_db = nvme_doorbell(nvme, qid, true);
+
+	rc = nvme_dma_alloc(size * sizeof(nvme_sqe_t), (void **) &q->sq,
+	    &q->sq_p);
+	if (rc != EOK)
+		return rc;
+
+	return nvme_dma_alloc(size * sizeof(nvme_cqe_t), (void **) &q->cq,
+	    &q->cq_p);
+}
+
+/** Free all DMA memory of a queue pair. */
+static void nvme_queue_fini(nvme_queue_t *q)
+{
+	nvme_dma_free((void **) &q->sq);
+	nvme_dma_free((void **) &q->cq);
+	nvme_dma_free(&q->buf[0]);
+	nvme_dma_free((void **) &q->prp_list[0]);
+}
+
+/** Put a command on the submission queue.
+ *
+ * Must be called with the queue lock held. The controller is not notified,
+ * the caller needs to call nvme_queue_ring() after a batch of commands.
+ */
+static void nvme_queue_put(nvme_queue_t *q, const nvme_sqe_t *cmd)
+{
+	memcpy(&q->sq[q->sq_tail], cmd, sizeof(nvme_sqe_t));
+	q->sq_tail = (q->sq_tail + 1) % q->size;
+}
+
+/** Notify the controller of new commands on the submission queue.
+ *
+ * Must be called with the queue lock held.
+ */
+static void nvme_queue_ring(nvme_queue_t *q)
+{
+	write_barrier();
+	pio_write_le32(q->sq_db, q->sq_tail);
+}
+
+/** Get the next completion of a queue if there is one.
+ *
+ * Must be called with the queue lock held. The completion is consumed, but
+ * the head doorbell is not written.
+ *
+ * @return @c true if a completion was consumed
+ */
+static bool nvme_queue_consume(nvme_queue_t *q, nvme_cqe_t *cqe)
+{
+	nvme_cqe_t *entry = &q->cq[q->cq_head];
+
+	if ((uint16_t_le2host(entry->status) & 1) != q->phase)
+		return false;
+
+	read_barrier();
+	memcpy(cqe, entry, sizeof(nvme_cqe_t));
+	cqe->cid = uint16_t_le2host(cqe->cid);
+	cqe->status = uint16_t_le2host(cqe->status) >> 1;
+	cqe->result = uint32_t_le2host(cqe->result);
+
+	if (++q->cq_head == q->size) {
+		q->cq_head = 0;
+		q->phase ^= 1;
+	}
+
+	return true;
+}
+
+/** Execute an admin command and wait for its completion.
+ *
+ * @param nvme		Controller
+ * @param cmd		Command, the command identifier is filled in
+ * @param[out] result	Place to store command specific result or @c NULL
+ *
+ * @return EOK on success, ETIMEOUT if the controller does not respond, EIO
+ *         if the command fails
+ */
+static errno_t nvme_admin_cmd(nvme_t *nvme, nvme_sqe_t *cmd, uint32_t *result)
+{
+	nvme_queue_t *q = &nvme->admin;
+	nvme_cqe_t cqe;
+	unsigned waited = 0;
+
+	fibril_mutex_lock(&nvme->admin_lock);
+
+	cmd->cdw0 = host2uint32_t_le(uint32_t_le2host(cmd->cdw0) |
+	    ((uint32_t) q->sq_tail << 16));
+	nvme_queue_put(q, cmd);
+	nvme_queue_ring(q);
+
+	while (!nvme_queue_consume(q, &cqe)) {
+		if (waited >= nvme->timeout) {
+			fibril_mutex_unlock(&nvme->admin_lock);
+			ddf_msg(LVL_ERROR, "Admin command 0x%02x timed out",
+			    uint32_t_le2host(cmd->cdw0) & 0xff);
+			return ETIMEOUT;
+		}
+
+		fibril_usleep(1000);
+		waited++;
+	}
+
+	pio_write_le32(q->cq_db, q->cq_head);
+	fibril_mutex_unlock(&nvme->admin_lock);
+
+	if (result != NULL)
+		*result = cqe.result;
+
+	return nvme_status_errno(cqe.status);
+}
+
+/** Wait for the controller to reach the requested ready state. */
+static errno_t nvme_wait_ready(nvme_t *nvme, bool ready)
+{
+	unsigned waited = 0;
+
+	while (true) {
+		uint32_t csts = pio_read_le32(&nvme->regs->csts);
+
+		if ((csts & NVME_CSTS_CFS) != 0 && ready) {
+			ddf_msg(LVL_ERROR, "Controller fatal status");
+			return EIO;
+		}
+
+		if (((csts & NVME_CSTS_RDY) != 0) == ready)
+			return EOK;
+
+		if (waited >= nvme->timeout)
+			return ETIMEOUT;
+
+		fibril_usleep(1000);
+		waited++;
+	}
+}
+
+/** Complete the commands reported on a completion queue.
+ *
+ * @param nvme	Controller
+ * @param q	I/O queue pair
+ */
+static void nvme_queue_reap(nvme_t *nvme, nvme_queue_t *q)
+{
+	uint16_t done[NVME_IO_QUEUE_DEPTH];
+	size_t ndone = 0;
+	bool consumed = false;
+	nvme_cqe_t cqe;
+
+	fibril_mutex_lock(&q->lock);
+
+	while (nvme_queue_consume(q, &cqe)) {
+		consumed = true;
+
+		if (cqe.cid >= NVME_IO_QUEUE_DEPTH)
+			continue;
+
+		q->status[cqe.cid] = cqe.status;
+
+		if (q->io[cqe.cid] != NULL) {
+			assert(ndone < NVME_IO_QUEUE_DEPTH);
+			done[ndone++] = cqe.cid;
+			continue;
+		}
+
+		q->done[cqe.cid] = true;
+		fibril_condvar_signal(&q->done_cv[cqe.cid]);
+	}
+
+	if (consumed)
+		pio_write_le32(q->cq_db, q->cq_head);
+
+	fibril_mutex_unlock(&q->lock);
+
+	/* Complete the vectored requests outside of the queue lock. */
+	for (size_t i = 0; i < ndone; i++)
+		nvme_io_complete(nvme, q, done[i]);
+}
+
+static void nvme_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+{
+	nvme_t *nvme = (nvme_t *) ddf_dev_data_get(dev);
+	unsigned vector = ipc_get_arg1(icall);
+
+	for (unsigned i = 0; i < nvme->num_queues; i++) {
+		nvme_queue_t *q = &nvme->queues[i];
+
+		if (q->vector == vector)
+			nvme_queue_reap(nvme, q);
+	}
+
+	/* The pin-based interrupt has been masked by the IRQ code. */
+	if (!nvme->msi)
+		pio_write_le32(&nvme->regs->intmc, 1);
+}
+
+/** Register the interrupt handlers.
+ *
+ * One vector per I/O queue pair is requested. If message signalled
+ * interrupts are not available, the legacy interrupt is shared by all
+ * queues.
+ */
+static errno_t nvme_register_interrupts(nvme_t *nvme, hw_res_list_parsed_t *res,
+    unsigned nq)
+{
+	irq_pio_range_t pio_ranges[] = {
+		{
+			.base = RNGABS(res->mem_ranges.ranges[0]),
+			.size = sizeof(nvme_regs_t)
+		}
+	};
+	irq_cmd_t irq_cmds[] = {
+		{
+			/* Mask the pin-based interrupt until it is handled */
+			.cmd = CMD_PIO_WRITE_32,
+			.addr = (void *) (RNGABS(res->mem_ranges.ranges[0]) +
+			    offsetof(nvme_regs_t, intms)),
+			.value = host2uint32_t_le(1)
+		},
+		{
+			/* Pass the vector number to the handler */
+			.cmd = CMD_LOAD,
+			.dstarg = 1
+		},
+		{
+			.cmd = CMD_ACCEPT
+		}
+	};
+	irq_code_t irq_code;
+	size_t count = nq + 1;
+	errno_t rc;
+
+	rc = hw_res_msi_setup(nvme->parent_sess, &count, &nvme->irq);
+	if (rc == EOK) {
+		nvme->msi = true;
+		nvme->nvec = count;
+	} else {
+		if (res->irqs.count < 1)
+			return EINVAL;
+
+		nvme->msi = false;
+		nvme->nvec = 1;
+		nvme->irq = res->irqs.irqs[0];
+	}
+
+	if (nvme->msi) {
+		/* Message signalled interrupts need no acknowledgement. */
+		irq_code.rangecount = 0;
+		irq_code.ranges = NULL;
+		irq_code.cmdcount = ARRAY_SIZE(irq_cmds) - 1;
+		irq_code.cmds = &irq_cmds[1];
+	} else {
+		irq_code.rangecount = ARRAY_SIZE(pio_ranges);
+		irq_code.ranges = pio_ranges;
+		irq_code.cmdcount = ARRAY_SIZE(irq_cmds);
+		irq_code.cmds = irq_cmds;
+	}
+
+	for (size_t v = 0; v < nvme->nvec; v++) {
+		irq_cmds[1].value = v;
+
+		rc = register_interrupt_handler(nvme->dev, nvme->irq + v,
+		    nvme_irq_handler, &irq_code, &nvme->irq_handle[v]);
+		if (rc != EOK) {
+			ddf_msg(LVL_ERROR, "Failed registering interrupt "
+			    "handler.");
+			return rc;
+		}
+
+		rc = hw_res_enable_interrupt(nvme->parent_sess, nvme->irq + v);
+		if (rc != EOK) {
+			ddf_msg(LVL_ERROR, "Failed enabling interrupt.");
+			return rc;
+		}
+	}
+
+	ddf_msg(LVL_NOTE, "Using %zu %s interrupt vector(s) from IRQ %d",
+	    nvme->nvec, nvme->msi ? "message signalled" : "pin-based",
+	    nvme->irq);
+	return EOK;
+}
+
+/** Create an I/O queue pair and its command slots.
+ *
+ * @param nvme	Controller
+ * @param i	Index of the queue pair, its queue identifier is @a i + 1
+ */
+static errno_t nvme_io_queue_init(nvme_t *nvme, unsigned i)
+{
+	nvme_queue_t *q = &nvme->queues[i];
+	size_t pages = NVME_XFER_SIZE / NVME_PAGE_SIZE;
+	nvme_sqe_t cmd;
+	void *buf;
+	void *prp;
+	uintptr_t buf_p;
+	uintptr_t prp_p;
+	errno_t rc;
+
+	/* One entry is always left free so that a full ring can be told. */
+	rc = nvme_queue_alloc(nvme, q, i + 1, NVME_IO_QUEUE_DEPTH + 1);
+	if (rc != EOK)
+		return rc;
+
+	q->vector = (i + 1) % nvme->nvec;
+
+	rc = nvme_dma_alloc(NVME_IO_QUEUE_DEPTH * NVME_XFER_SIZE, &buf, &buf_p);
+	if (rc != EOK)
+		return rc;
+
+	q->buf[0] = buf;
+
+	rc = nvme_dma_alloc(NVME_IO_QUEUE_DEPTH * NVME_PAGE_SIZE, &prp, &prp_p);
+	if (rc != EOK)
+		return rc;
+
+	/*
+	 * The PRP list of a slot lists all but the first page of its buffer,
+	 * the first page goes to PRP1. The buffers never move, so the lists
+	 * are filled in once here.
+	 */
+	for (unsigned j = 0; j < NVME_IO_QUEUE_DEPTH; j++) {
+		q->buf[j] = buf + j * NVME_XFER_SIZE;
+		q->buf_p[j] = buf_p + j * NVME_XFER_SIZE;
+		q->prp_list[j] = prp + j * NVME_PAGE_SIZE;
+		q->prp_list_p[j] = prp_p + j * NVME_PAGE_SIZE;
+
+		for (size_t k = 1; k < pages; k++) {
+			q->prp_list[j][k - 1] = host2uint64_t_le(q->buf_p[j] +
+			    k * NVME_PAGE_SIZE);
+		}
+
+		q->free_next[j] = j + 1;
+	}
+
+	q->free_head = 0;
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.cdw0 = host2uint32_t_le(NVME_ADMIN_CREATE_CQ);
+	cmd.dptr.prp.prp1 = host2uint64_t_le(q->cq_p);
+	cmd.cdw10 = host2uint32_t_le(((uint32_t) (q->size - 1) << 16) | q->qid);
+	cmd.cdw11 = host2uint32_t_le((q->vector << 16) | NVME_QUEUE_IEN |
+	    NVME_QUEUE_PC);
+	rc = nvme_admin_cmd(nvme, &cmd, NULL);
+	if (rc != EOK) {
+		ddf_msg(LVL_ERROR, "Failed creating completion queue %u",
+		    q->qid);
+		return rc;
+	}
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.cdw0 = host2uint32_t_le(NVME_ADMIN_CREATE_SQ);
+	cmd.dptr.prp.prp1 = host2uint64_t_le(q->sq_p);
+	cmd.cdw10 = host2uint32_t_le(((uint32_t) (q->size - 1) << 16) | q->qid);
+	cmd.cdw11 = host2uint32_t_le(((uint32_t) q->qid << 16) | NVME_QUEUE_PC);
+	rc = nvme_admin_cmd(nvme, &cmd, NULL);
+	if (rc != EOK) {
+		ddf_msg(LVL_ERROR, "Failed creating submission queue %u",
+		    q->qid);
+		return rc;
+	}
+
+	return EOK;
+}
+
+/** Choose the I/O queue pair for a new command.
+ *
+ * The driver cannot tell which CPU it is running on, so the queue pairs are
+ * used in turn to spread the commands over them.
+ */
+static nvme_queue_t *nvme_queue_get(nvme_t *nvme)
+{
+	fibril_mutex_lock(&nvme->io_lock);
+	nvme_queue_t *q = &nvme->queues[nvme->next_queue];
+	nvme->next_queue = (nvme->next_queue + 1) % nvme->num_queues;
+	fibril_mutex_unlock(&nvme->io_lock);
+
+	return q;
+}
+
+/** Allocate a command slot, waiting for one to become free.
+ *
+ * Must be called with the queue lock held.
+ */
+static uint16_t nvme_slot_alloc(nvme_queue_t *q)
+{
+	while (q->free_head == NVME_IO_QUEUE_DEPTH) {
+		/*
+		 * Commands put on the ring but not yet rung for would
+		 * otherwise never complete and free a slot.
+		 */
+		nvme_queue_ring(q);
+		fibril_condvar_wait(&q->free_cv, &q->lock);
+	}
+
+	uint16_t cid = q->free_head;
+	q->free_head = q->free_next[cid];
+	return cid;
+}
+
+/** Free a command slot.
+ *
+ * Must be called with the queue lock held.
+ */
+static void nvme_slot_free(nvme_queue_t *q, uint16_t cid)
+{
+	q->free_next[cid] = q->free_head;
+	q->free_head = cid;
+	fibril_condvar_signal(&q->free_cv);
+}
+
+/** Put an NVM command using the buffer of a slot on the submission queue.
+ *
+ * Must be called with the queue lock held.
+ *
+ * @param ns		Namespace
+ * @param q		I/O queue pair
+ * @param cid		Command slot
+ * @param opcode	NVM command opcode
+ * @param ba		Address of the first block
+ * @param len		Length of the data, at most nvme_t.max_xfer
+ */
+static void nvme_cmd_start(nvme_ns_t *ns, nvme_queue_t *q, uint16_t cid,
+    uint8_t opcode, aoff64_t ba, size_t len)
+{
+	nvme_t *nvme = ns->nvme;
+	nvme_sqe_t cmd;
+	uint32_t cdw0;
+
+	assert(len <= nvme->max_xfer);
+
+	memset(&cmd, 0, sizeof(cmd));
+	cdw0 = opcode | ((uint32_t) cid << 16);
+	cmd.nsid = host2uint32_t_le(ns->nsid);
+
+	if (len > 0 && nvme->sgl) {
+		cdw0 |= NVME_CDW0_PSDT_SGL;
+		cmd.dptr.sgl.addr = host2uint64_t_le(q->buf_p[cid]);
+		cmd.dptr.sgl.len = host2uint32_t_le(len);
+		cmd.dptr.sgl.type = NVME_SGL_DATA_BLOCK;
+	} else if (len > 0) {
+		size_t pages = (len + NVME_PAGE_SIZE - 1) / NVME_PAGE_SIZE;
+
+		cmd.dptr.prp.prp1 = host2uint64_t_le(q->buf_p[cid]);
+		if (pages == 2) {
+			cmd.dptr.prp.prp2 = host2uint64_t_le(q->buf_p[cid] +
+			    NVME_PAGE_SIZE);
+		} else if (pages > 2) {
+			cmd.dptr.prp.prp2 =
+			    host2uint64_t_le(q->prp_list_p[cid]);
+		}
+	}
+
+	if (opcode != NVME_CMD_FLUSH) {
+		cmd.cdw10 = host2uint32_t_le(LOWER32(ba));
+		cmd.cdw11 = host2uint32_t_le(UPPER32(ba));
+		cmd.cdw12 = host2uint32_t_le(len / ns->block_size - 1);
+	}
+
+	cmd.cdw0 = host2uint32_t_le(cdw0);
+	nvme_queue_put(q, &cmd);
+}
+
+/** Execute an NVM command and wait for its completion.
+ *
+ * @param ns		Namespace
+ * @param opcode	NVM command opcode
+ * @param ba		Address of the first block
+ * @param buf		Data buffer
+ * @param len		Length of the data, at most nvme_t.max_xfer
+ */
+static errno_t nvme_cmd_sync(nvme_ns_t *ns, uint8_t opcode, aoff64_t ba,
+    void *buf, size_t len)
+{
+	nvme_queue_t *q = nvme_queue_get(ns->nvme);
+	errno_t rc;
+
+	fibril_mutex_lock(&q->lock);
+	uint16_t cid = nvme_slot_alloc(q);
+
+	if (opcode == NVME_CMD_WRITE)
+		memcpy(q->buf[cid], buf, len);
+
+	q->io[cid] = NULL;
+	q->done[cid] = false;
+	nvme_cmd_start(ns, q, cid, opcode, ba, len);
+	nvme_queue_ring(q);
+
+	while (!q->done[cid])
+		fibril_condvar_wait(&q->done_cv[cid], &q->lock);
+
+	rc = nvme_status_errno(q->status[cid]);
+
+	if (rc == EOK && opcode == NVME_CMD_READ)
+		memcpy(buf, q->buf[cid], len);
+
+	nvme_slot_free(q, cid);
+	fibril_mutex_unlock(&q->lock);
+	return rc;
+}
+
+static errno_t nvme_bd_open(bd_srvs_t *bds, bd_srv_t *bd)
+{
+	return EOK;
+}
+
+static errno_t nvme_bd_close(bd_srv_t *bd)
+{
+	return EOK;
+}
+
+static errno_t nvme_bd_rw_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
+    void *buf, size_t size, bool read)
+{
+	nvme_ns_t *ns = (nvme_ns_t *) bd->srvs->sarg;
+	size_t xfer_blocks = ns->nvme->max_xfer / ns->block_size;
+	errno_t rc;
+
+	if (size != cnt * ns->block_size)
+		return EINVAL;
+
+	if (ba + cnt > ns->blocks)
+		return ELIMIT;
+
+	for (size_t i = 0; i < cnt; i += xfer_blocks) {
+		size_t n = min(cnt - i, xfer_blocks);
+
+		rc = nvme_cmd_sync(ns, read ? NVME_CMD_READ : NVME_CMD_WRITE,
+		    ba + i, buf + i * ns->block_size, n * ns->block_size);
+		if (rc != EOK)
+			return rc;
+	}
+
+	return EOK;
+}
+
+static errno_t nvme_bd_read_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
+    void *buf, size_t size)
+{
+	return nvme_bd_rw_blocks(bd, ba, cnt, buf, size, true);
+}
+
+static errno_t nvme_bd_write_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
+    const void *buf, size_t size)
+{
+	return nvme_bd_rw_blocks(bd, ba, cnt, (void *) buf, size, false);
+}
+
+static errno_t nvme_bd_sync_cache(bd_srv_t *bd, aoff64_t ba, size_t cnt)
+{
+	nvme_ns_t *ns = (nvme_ns_t *) bd->srvs->sarg;
+
+	/* The whole volatile write cache of the namespace is flushed. */
+	return nvme_cmd_sync(ns, NVME_CMD_FLUSH, 0, NULL, 0);
+}
+
+/** Drop a reference to a vectored request, completing it with the last. */
+static void nvme_io_put(nvme_t *nvme, nvme_io_t *nio, errno_t rc)
+{
+	fibril_mutex_lock(&nvme->io_lock);
+	if (rc != EOK && nio->rc == EOK)
+		nio->rc = rc;
+	bool last = --nio->pending == 0;
+	fibril_mutex_unlock(&nvme->io_lock);
+
+	if (last) {
+		bd_io_done(nio->io, nio->rc);
+		free(nio);
+	}
+}
+
+/** Complete a command which is part of a vectored request. */
+static void nvme_io_complete(nvme_t *nvme, nvme_queue_t *q, uint16_t cid)
+{
+	fibril_mutex_lock(&q->lock);
+
+	nvme_io_t *nio = q->io[cid];
+	errno_t rc = nvme_status_errno(q->status[cid]);
+
+	if (rc == EOK && q->read[cid])
+		memcpy(q->data[cid], q->buf[cid], q->len[cid]);
+
+	q->io[cid] = NULL;
+	nvme_slot_free(q, cid);
+	fibril_mutex_unlock(&q->lock);
+
+	nvme_io_put(nvme, nio, rc);
+}
+
+/** Start a vectored request.
+ *
+ * The extents are split into commands of up to nvme_t.max_xfer bytes which
+ * are all put on one I/O queue without waiting, so that up to
+ * NVME_IO_QUEUE_DEPTH of them are in flight. The doorbell is written once
+ * for the whole batch. The vectored request completes when the last of the
+ * commands does.
+ */
+static errno_t nvme_bd_submit(bd_srv_t *bd, bd_io_t *io)
+{
+	nvme_ns_t *ns = (nvme_ns_t *) bd->srvs->sarg;
+	nvme_t *nvme = ns->nvme;
+	size_t xfer_blocks = nvme->max_xfer / ns->block_size;
+	nvme_queue_t *q;
+	nvme_io_t *nio;
+
+	for (size_t i = 0; i < io->nvec; i++) {
+		if (io->vec[i].ba + io->vec[i].cnt > ns->blocks)
+			return ELIMIT;
+	}
+
+	nio = calloc(1, sizeof(nvme_io_t));
+	if (nio == NULL)
+		return ENOMEM;
+
+	nio->io = io;
+	nio->pending = 1;
+	nio->rc = EOK;
+
+	q = nvme_queue_get(nvme);
+	fibril_mutex_lock(&q->lock);
+
+	for (size_t i = 0; i < io->nvec; i++) {
+		uint8_t *data = bd_io_buf(io, i);
+
+		for (aoff64_t j = 0; j < io->vec[i].cnt; j += xfer_blocks) {
+			size_t n = min(io->vec[i].cnt - j,
+			    (aoff64_t) xfer_blocks);
+			uint16_t cid = nvme_slot_alloc(q);
+
+			q->io[cid] = nio;
+			q->data[cid] = data + j * ns->block_size;
+			q->len[cid] = n * ns->block_size;
+			q->read[cid] = !io->write;
+
+			if (io->write)
+				memcpy(q->buf[cid], q->data[cid], q->len[cid]);
+
+			fibril_mutex_lock(&nvme->io_lock);
+			nio->pending++;
+			fibril_mutex_unlock(&nvme->io_lock);
+
+			nvme_cmd_start(ns, q, cid, io->write ? NVME_CMD_WRITE :
+			    NVME_CMD_READ, io->vec[i].ba + j, q->len[cid]);
+		}
+	}
+
+	nvme_queue_ring(q);
+	fibril_mutex_unlock(&q->lock);
+
+	/* Drop the reference held while submitting. */
+	nvme_io_put(nvme, nio, EOK);
+	return EOK;
+}
+
+static errno_t nvme_bd_get_block_size(bd_srv_t *bd, size_t *size)
+{
+	nvme_ns_t *ns = (nvme_ns_t *) bd->srvs->sarg;
+
+	*size = ns->block_size;
+	return EOK;
+}
+
+static errno_t nvme_bd_get_num_blocks(bd_srv_t *bd, aoff64_t *nb)
+{
+	nvme_ns_t *ns = (nvme_ns_t *) bd->srvs->sarg;
+
+	*nb = ns->blocks;
+	return EOK;
+}
+
+static bd_ops_t nvme_bd_ops = {
+	.open = nvme_bd_open,
+	.close = nvme_bd_close,
+	.read_blocks = nvme_bd_read_blocks,
+	.write_blocks = nvme_bd_write_blocks,
+	.sync_cache = nvme_bd_sync_cache,
+	.get_block_size = nvme_bd_get_block_size,
+	.get_num_blocks = nvme_bd_get_num_blocks,
+	.submit = nvme_bd_submit
+};
+
+/** Issue an Identify command into the identify buffer. */
+static errno_t nvme_identify(nvme_t *nvme, uint8_t cns, uint32_t nsid)
+{
+	nvme_sqe_t cmd;
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.cdw0 = host2uint32_t_le(NVME_ADMIN_IDENTIFY);
+	cmd.nsid = host2uint32_t_le(nsid);
+	cmd.dptr.prp.prp1 = host2uint64_t_le(nvme->id_buf_p);
+	cmd.cdw10 = host2uint32_t_le(cns);
+
+	return nvme_admin_cmd(nvme, &cmd, NULL);
+}
+
+/** Read a little-endian 32-bit value from the identify buffer. */
+static uint32_t nvme_id_get32(nvme_t *nvme, size_t offs)
+{
+	uint32_t val;
+
+	memcpy(&val, (uint8_t *) nvme->id_buf + offs, sizeof(val));
+	return uint32_t_le2host(val);
+}
+
+/** Read a little-endian 64-bit value from the identify buffer. */
+static uint64_t nvme_id_get64(nvme_t *nvme, size_t offs)
+{
+	uint64_t val;
+
+	memcpy(&val, (uint8_t *) nvme->id_buf + offs, sizeof(val));
+	return uint64_t_le2host(val);
+}
+
+/** Identify the controller and determine the transfer parameters.
+ *
+ * @param nvme	Controller
+ * @param[out] nn Number of namespaces
+ */
+static errno_t nvme_identify_ctrl(nvme_t *nvme, uint32_t *nn)
+{
+	char model[NVME_ID_CTRL_MN_LEN + 1];
+	uint8_t mdts;
+	errno_t rc;
+
+	rc = nvme_identify(nvme, NVME_IDENTIFY_CTRL, 0);
+	if (rc != EOK)
+		return rc;
+
+	memcpy(model, (uint8_t *) nvme->id_buf + NVME_ID_CTRL_MN,
+	    NVME_ID_CTRL_MN_LEN);
+	model[NVME_ID_CTRL_MN_LEN] = '\0';
+	str_rtrim(model, ' ');
+
+	mdts = ((uint8_t *) nvme->id_buf)[NVME_ID_CTRL_MDTS];
+	*nn = nvme_id_get32(nvme, NVME_ID_CTRL_NN);
+	nvme->sgl = NVME_SGLS_SUPPORTED(nvme_id_get32(nvme,
+	    NVME_ID_CTRL_SGLS));
+
+	/* MDTS is a power of two in units of the minimum page size. */
+	nvme->max_xfer = NVME_XFER_SIZE;
+	if (mdts != 0 && mdts < 8 * sizeof(size_t) - 12 &&
+	    ((size_t) NVME_PAGE_SIZE << mdts) < nvme->max_xfer)
+		nvme->max_xfer = (size_t) NVME_PAGE_SIZE << mdts;
+
+	ddf_msg(LVL_NOTE, "Controller '%s', %" PRIu32 " namespace(s), "
+	    "%zu bytes per command, %s", model, *nn, nvme->max_xfer,
+	    nvme->sgl ? "SGL" : "PRP");
+	return EOK;
+}
+
+/** Identify a namespace.
+ *
+ * @return EOK if the namespace is usable, ENOENT if it is inactive, or an
+ *         error code
+ */
+static errno_t nvme_identify_ns(nvme_t *nvme, nvme_ns_t *ns, uint32_t nsid)
+{
+	uint8_t flbas;
+	uint32_t lbaf;
+	unsigned lbads;
+	errno_t rc;
+
+	rc = nvme_identify(nvme, NVME_IDENTIFY_NS, nsid);
+	if (rc != EOK)
+		return rc;
+
+	ns->nvme = nvme;
+	ns->nsid = nsid;
+	ns->blocks = nvme_id_get64(nvme, NVME_ID_NS_NSZE);
+	if (ns->blocks == 0)
+		return ENOENT;
+
+	flbas = ((uint8_t *) nvme->id_buf)[NVME_ID_NS_FLBAS];
+	lbaf = nvme_id_get32(nvme, NVME_ID_NS_LBAF + 4 * (flbas & 0xf));
+	lbads = (lbaf >> 16) & 0xff;
+
+	if (lbads < 9 || ((size_t) 1 << lbads) > nvme->max_xfer) {
+		ddf_msg(LVL_WARN, "Namespace %" PRIu32 ": unsupported block "
+		    "size 2^%u", nsid, lbads);
+		return ENOTSUP;
+	}
+
+	ns->block_size = (size_t) 1 << lbads;
+
+	bd_srvs_init(&ns->bds);
+	ns->bds.ops = &nvme_bd_ops;
+	ns->bds.sarg = ns;
+
+	ddf_msg(LVL_NOTE, "Namespace %" PRIu32 ": %" PRIu64 " blocks of %zu "
+	    "bytes", nsid, ns->blocks, ns->block_size);
+	return EOK;
+}
+
+/** Determine the number of I/O queue pairs to use.
+ *
+ * One queue pair per CPU is requested from the controller, limited by
+ * NVME_MAX_QUEUES.
+ */
+static errno_t nvme_num_queues(nvme_t *nvme, unsigned *nq)
+{
+	nvme_sqe_t cmd;
+	uint32_t result;
+	unsigned want = 1;
+	errno_t rc;
+
+	size_t cpus;
+	stats_cpu_t *stats = stats_get_cpus(&cpus);
+	if (stats != NULL) {
+		free(stats);
+		want = max(cpus, 1);
+	}
+
+	want = min(want, NVME_MAX_QUEUES);
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.cdw0 = host2uint32_t_le(NVME_ADMIN_SET_FEATURES);
+	cmd.cdw10 = host2uint32_t_le(NVME_FEAT_NUM_QUEUES);
+	cmd.cdw11 = host2uint32_t_le(((want - 1) << 16) | (want - 1));
+	rc = nvme_admin_cmd(nvme, &cmd, &result);
+	if (rc != EOK)
+		return rc;
+
+	/* The controller reports how many queues it has allocated. */
+	*nq = min(want, min((result & 0xffff) + 1, (result >> 16) + 1));
+	return EOK;
+}
+
+/** Reset and enable the controller with the admin queues set up. */
+static errno_t nvme_ctrl_enable(nvme_t *nvme)
+{
+	uint64_t cap = pio_read_le64(&nvme->regs->cap);
+	errno_t rc;
+
+	nvme->db_stride = (size_t) 4 << NVME_CAP_DSTRD(cap);
+	nvme->timeout = max(NVME_CAP_TO(cap), 1) * NVME_TIMEOUT_UNIT;
+
+	if (!NVME_CAP_CSS_NVM(cap) || NVME_CAP_MPSMIN(cap) != 0) {
+		ddf_msg(LVL_ERROR, "Unsupported controller capabilities "
+		    "0x%" PRIx64, cap);
+		return ENOTSUP;
+	}
+
+	/* Disable the controller */
+	pio_write_le32(&nvme->regs->cc, 0);
+	rc = nvme_wait_ready(nvme, false);
+	if (rc != EOK) {
+		ddf_msg(LVL_ERROR, "Controller reset timed out");
+		return rc;
+	}
+
+	rc = nvme_queue_alloc(nvme, &nvme->admin, 0, min(NVME_ADMIN_QUEUE_SIZE,
+	    NVME_CAP_MQES(cap) + 1));
+	if (rc != EOK)
+		return rc;
+
+	pio_write_le32(&nvme->regs->aqa,
+	    ((uint32_t) (nvme->admin.size - 1) << 16) | (nvme->admin.size - 1));
+	pio_write_le64(&nvme->regs->asq, nvme->admin.sq_p);
+	pio_write_le64(&nvme->regs->acq, nvme->admin.cq_p);
+
+	/* Mask the pin-based interrupt while the admin queues are polled */
+	pio_write_le32(&nvme->regs->intms, 1);
+
+	pio_write_le32(&nvme->regs->cc, NVME_CC_IOSQES(6) | NVME_CC_IOCQES(4) |
+	    NVME_CC_EN);
+	rc = nvme_wait_ready(nvme, true);
+	if (rc != EOK) {
+		ddf_msg(LVL_ERROR, "Controller failed to become ready");
+		return rc;
+	}
+
+	return EOK;
+}
+
+static errno_t nvme_initialize(ddf_dev_t *dev, nvme_t *nvme)
+{
+	hw_res_list_parsed_t res;
+	uint32_t nn;
+	unsigned nq;
+	errno_t rc;
+
+	nvme->dev = dev;
+	fibril_mutex_initialize(&nvme->admin_lock);
+	fibril_mutex_initialize(&nvme->io_lock);
+
+	for (unsigned i = 0; i < NVME_MAX_QUEUES; i++) {
+		nvme_queue_t *q = &nvme->queues[i];
+
+		fibril_mutex_initialize(&q->lock);
+		fibril_condvar_initialize(&q->free_cv);
+		for (unsigned j = 0; j < NVME_IO_QUEUE_DEPTH; j++)
+			fibril_condvar_initialize(&q->done_cv[j]);
+	}
+
+	nvme->parent_sess = ddf_dev_parent_sess_get(dev);
+	if (nvme->parent_sess == NULL)
+		return ENOMEM;
+
+	hw_res_list_parsed_init(&res);
+	rc = hw_res_get_list_parsed(nvme->parent_sess, &res, 0);
+	if (rc != EOK)
+		return rc;
+
+	if (res.mem_ranges.count < 1) {
+		rc = EINVAL;
+		goto error;
+	}
+
+	nvme->regs_size = RNGSZ(res.mem_ranges.ranges[0]);
+	rc = pio_enable_range(&res.mem_ranges.ranges[0],
+	    (void **) &nvme->regs);
+	if (rc != EOK) {
+		ddf_msg(LVL_ERROR, "Failed to map controller registers");
+		nvme->regs = NULL;
+		goto error;
+	}
+
+	rc = nvme_dma_alloc(NVME_PAGE_SIZE, &nvme->id_buf, &nvme->id_buf_p);
+	if (rc != EOK)
+		goto error;
+
+	rc = nvme_ctrl_enable(nvme);
+	if (rc != EOK)
+		goto error;
+
+	rc = nvme_identify_ctrl(nvme, &nn);
+	if (rc != EOK)
+		goto error;
+
+	rc = nvme_num_queues(nvme, &nq);
+	if (rc != EOK)
+		goto error;
+
+	rc = nvme_register_interrupts(nvme, &res, nq);
+	if (rc != EOK)
+		goto error;
+
+	for (unsigned i = 0; i < nq; i++) {
+		rc = nvme_io_queue_init(nvme, i);
+		if (rc != EOK)
+			goto error;
+	}
+
+	/* Go live */
+	nvme->num_queues = nq;
+
+	if (!nvme->msi)
+		pio_write_le32(&nvme->regs->intmc, 1);
+
+	ddf_msg(LVL_NOTE, "Using %u I/O queue pair(s) of depth %u", nq,
+	    NVME_IO_QUEUE_DEPTH);
+
+	for (uint32_t nsid = 1; nsid <= nn && nvme->num_ns < NVME_MAX_NS;
+	    nsid++) {
+		nvme_ns_t *ns = &nvme->ns[nvme->num_ns];
+
+		if (nvme_identify_ns(nvme, ns, nsid) == EOK)
+			nvme->num_ns++;
+	}
+
+	hw_res_list_parsed_clean(&res);
+	return EOK;
+
+error:
+	hw_res_list_parsed_clean(&res);
+	return rc;
+}
+
+static void nvme_uninitialize(nvme_t *nvme)
+{
+	nvme->num_queues = 0;
+
+	if (nvme->regs != NULL)
+		pio_write_le32(&nvme->regs->cc, 0);
+
+	for (size_t v = 0; v < nvme->nvec; v++) {
+		if (cap_handle_valid(nvme->irq_handle[v]))
+			unregister_interrupt_handler(nvme->dev,
+			    nvme->irq_handle[v]);
+	}
+
+	if (nvme->msi)
+		hw_res_msi_release(nvme->parent_sess);
+
+	for (unsigned i = 0; i < NVME_MAX_QUEUES; i++)
+		nvme_queue_fini(&nvme->queues[i]);
+
+	nvme_queue_fini(&nvme->admin);
+	nvme_dma_free(&nvme->id_buf);
+
+	if (nvme->regs != NULL)
+		pio_disable(nvme->regs, nvme->regs_size);
+}
+
+static void nvme_bd_connection(ipc_call_t *icall, void *arg)
+{
+	nvme_ns_t **data = (nvme_ns_t **) ddf_fun_data_get((ddf_fun_t *) arg);
+
+	bd_conn(icall, &(*data)->bds);
+}
+
+/** Expose a namespace as a disk function. */
+static errno_t nvme_ns_expose(nvme_ns_t *ns)
+{
+	nvme_ns_t **data;
+	char *name;
+	errno_t rc;
+
+	if (asprintf(&name, "ns%" PRIu32, ns->nsid) < 0)
+		return ENOMEM;
+
+	ns->fun = ddf_fun_create(ns->nvme->dev, fun_exposed, name);
+	free(name);
+	if (ns->fun == NULL)
+		return ENOMEM;
+
+	data = ddf_fun_data_alloc(ns->fun, sizeof(nvme_ns_t *));
+	if (data == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	*data = ns;
+	ddf_fun_set_conn_handler(ns->fun, nvme_bd_connection);
+
+	rc = ddf_fun_bind(ns->fun);
+	if (rc != EOK) {
+		ddf_msg(LVL_ERROR, "Failed binding function %s",
+		    ddf_fun_get_name(ns->fun));
+		goto error;
+	}
+
+	rc = ddf_fun_add_to_category(ns->fun, "disk");
+	if (rc != EOK) {
+		ddf_msg(LVL_ERROR, "Failed adding function %s to category",
+		    ddf_fun_get_name(ns->fun));
+		ddf_fun_unbind(ns->fun);
+		goto error;
+	}
+
+	return EOK;
+
+error:
+	ddf_fun_destroy(ns->fun);
+	ns->fun = NULL;
+	return rc;
+}
+
+static errno_t nvme_dev_add(ddf_dev_t *dev)
+{
+	nvme_t *nvme;
+	unsigned exposed = 0;
+	errno_t rc;
+
+	ddf_msg(LVL_NOTE, "%s %s (handle = %zu)", __func__,
+	    ddf_dev_get_name(dev), ddf_dev_get_handle(dev));
+
+	nvme = ddf_dev_data_alloc(dev, sizeof(nvme_t));
+	if (nvme == NULL)
+		return ENOMEM;
+
+	rc = nvme_initialize(dev, nvme);
+	if (rc != EOK)
+		goto error;
+
+	for (unsigned i = 0; i < nvme->num_ns; i++) {
+		if (nvme_ns_expose(&nvme->ns[i]) == EOK)
+			exposed++;
+	}
+
+	if (exposed == 0) {
+		ddf_msg(LVL_ERROR, "No usable namespaces");
+		rc = ENOENT;
+		goto error;
+	}
+
+	ddf_msg(LVL_NOTE, "The %s device has been successfully initialized.",
+	    ddf_dev_get_name(dev));
+	return EOK;
+
+error:
+	nvme_uninitialize(nvme);
+	return rc;
+}
+
+int main(void)
+{
+	printf("%s: HelenOS NVM Express driver\n", NAME);
+
+	(void) ddf_log_init(NAME);
+	return ddf_driver_main(&nvme_driver);
+}
+
+/** @}
+ */
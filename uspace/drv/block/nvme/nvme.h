@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup nvme
+ * @{
+ */
+/** @file NVM Express driver
+ */
+
+#ifndef _NVME_H_
+#define _NVME_H_
+
+#include <abi/cap.h>
+#include <async.h>
+#include <bd_srv.h>
+#include <ddf/driver.h>
+#include <ddi.h>
+#include <fibril_synch.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Memory page size used by the driver (CC.MPS = 0) */
+#define NVME_PAGE_SIZE		4096
+
+/** Number of entries of the admin queues */
+#define NVME_ADMIN_QUEUE_SIZE	32
+
+/** Number of commands in flight on one I/O queue */
+#define NVME_IO_QUEUE_DEPTH	64
+
+/** Size of the data buffer of one I/O command */
+#define NVME_XFER_SIZE		(8 * NVME_PAGE_SIZE)
+
+/** Maximum number of I/O queue pairs used */
+#define NVME_MAX_QUEUES		8
+
+/** Maximum number of namespaces exposed */
+#define NVME_MAX_NS		16
+
+/** Controller timeout unit in milliseconds (CAP.TO) */
+#define NVME_TIMEOUT_UNIT	500
+
+/** Controller registers */
+typedef struct {
+	ioport64_t cap;
+	ioport32_t vs;
+	ioport32_t intms;
+	ioport32_t intmc;
+	ioport32_t cc;
+	ioport32_t reserved;
+	ioport32_t csts;
+	ioport32_t nssr;
+	ioport32_t aqa;
+	ioport64_t asq;
+	ioport64_t acq;
+} nvme_regs_t;
+
+/** Offset of the doorbell registers */
+#define NVME_DOORBELL_OFFSET	0x1000
+
+#define NVME_CAP_MQES(cap)	((cap) & 0xffff)
+#define NVME_CAP_TO(cap)	(((cap) >> 24) & 0xff)
+#define NVME_CAP_DSTRD(cap)	(((cap) >> 32) & 0xf)
+#define NVME_CAP_CSS_NVM(cap)	(((cap) >> 37) & 0x1)
+#define NVME_CAP_MPSMIN(cap)	(((cap) >> 48) & 0xf)
+
+#define NVME_CC_EN		0x00000001
+#define NVME_CC_IOSQES(n)	((n) << 16)
+#define NVME_CC_IOCQES(n)	((n) << 20)
+
+#define NVME_CSTS_RDY		0x00000001
+#define NVME_CSTS_CFS		0x00000002
+
+/* Admin command opcodes */
+#define NVME_ADMIN_DELETE_SQ	0x00
+#define NVME_ADMIN_CREATE_SQ	0x01
+#define NVME_ADMIN_DELETE_CQ	0x04
+#define NVME_ADMIN_CREATE_CQ	0x05
+#define NVME_ADMIN_IDENTIFY	0x06
+#define NVME_ADMIN_SET_FEATURES	0x09
+
+/* NVM command opcodes */
+#define NVME_CMD_FLUSH		0x00
+#define NVME_CMD_WRITE		0x01
+#define NVME_CMD_READ		0x02
+
+/* Identify CNS values */
+#define NVME_IDENTIFY_NS	0x00
+#define NVME_IDENTIFY_CTRL	0x01
+
+/** Number of Queues feature */
+#define NVME_FEAT_NUM_QUEUES	0x07
+
+/* Queue creation flags */
+#define NVME_QUEUE_PC		0x0001
+#define NVME_QUEUE_IEN		0x0002
+
+/* Identify controller data */
+#define NVME_ID_CTRL_MN		24
+#define NVME_ID_CTRL_MN_LEN	40
+#define NVME_ID_CTRL_MDTS	77
+#define NVME_ID_CTRL_NN		516
+#define NVME_ID_CTRL_SGLS	536
+
+/* Identify namespace data */
+#define NVME_ID_NS_NSZE		0
+#define NVME_ID_NS_FLBAS	26
+#define NVME_ID_NS_LBAF		128
+
+/** Data pointer is an SGL (CDW0.PSDT) */
+#define NVME_CDW0_PSDT_SGL	(1 << 14)
+
+/** SGL data block descriptor type */
+#define NVME_SGL_DATA_BLOCK	0x00
+
+/** SGL support for NVM commands (Identify SGLS) */
+#define NVME_SGLS_SUPPORTED(s)	(((s) & 0x3) != 0)
+
+/** SGL descriptor */
+typedef struct {
+	uint64_t addr;
+	uint32_t len;
+	uint8_t reserved[3];
+	uint8_t type;
+} __attribute__((packed)) nvme_sgl_desc_t;
+
+/** Submission queue entry */
+typedef struct {
+	/** Opcode, PSDT and command identifier */
+	uint32_t cdw0;
+	uint32_t nsid;
+	uint32_t reserved[2];
+	uint64_t mptr;
+	union {
+		struct {
+			uint64_t prp1;
+			uint64_t prp2;
+		} prp;
+		nvme_sgl_desc_t sgl;
+	} dptr;
+	uint32_t cdw10;
+	uint32_t cdw11;
+	uint32_t cdw12;
+	uint32_t cdw13;
+	uint32_t cdw14;
+	uint32_t cdw15;
+} __attribute__((packed)) nvme_sqe_t;
+
+/** Completion queue entry */
+typedef struct {
+	uint32_t result;
+	uint32_t reserved;
+	uint16_t sq_head;
+	uint16_t sq_id;
+	uint16_t cid;
+	/** Phase tag in bit 0, status field in bits 15:1 */
+	uint16_t status;
+} __attribute__((packed)) nvme_cqe_t;
+
+/** Vectored request split into commands */
+typedef struct {
+	/** Vectored request of the client */
+	bd_io_t *io;
+	/** Number of commands in flight, plus one while submitting */
+	unsigned pending;
+	/** Result of the request */
+	errno_t rc;
+} nvme_io_t;
+
+/** Submission / completion queue pair */
+typedef struct {
+	/** Queue identifier, zero for the admin queues */
+	uint16_t qid;
+	/** Interrupt vector of the completion queue */
+	unsigned vector;
+	/** Number of entries of each queue */
+	uint16_t size;
+
+	nvme_sqe_t *sq;
+	uintptr_t sq_p;
+	nvme_cqe_t *cq;
+	uintptr_t cq_p;
+
+	ioport32_t *sq_db;
+	ioport32_t *cq_db;
+
+	uint16_t sq_tail;
+	uint16_t cq_head;
+	/** Expected phase tag of the next completion */
+	uint16_t phase;
+
+	/** Protects the queue state and the command slots */
+	fibril_mutex_t lock;
+	/** Signalled when a command slot is freed */
+	fibril_condvar_t free_cv;
+	/** First free command slot or NVME_IO_QUEUE_DEPTH */
+	uint16_t free_head;
+	uint16_t free_next[NVME_IO_QUEUE_DEPTH];
+
+	/** Data buffers, one per command slot */
+	void *buf[NVME_IO_QUEUE_DEPTH];
+	uintptr_t buf_p[NVME_IO_QUEUE_DEPTH];
+	/** PRP lists describing the data buffers */
+	uint64_t *prp_list[NVME_IO_QUEUE_DEPTH];
+	uintptr_t prp_list_p[NVME_IO_QUEUE_DEPTH];
+
+	/** Signalled when the command completes */
+	fibril_condvar_t done_cv[NVME_IO_QUEUE_DEPTH];
+	bool done[NVME_IO_QUEUE_DEPTH];
+	/** Status field of the completed command */
+	uint16_t status[NVME_IO_QUEUE_DEPTH];
+
+	/** Vectored request the command belongs to or NULL */
+	nvme_io_t *io[NVME_IO_QUEUE_DEPTH];
+	/** Where to copy data read by the command */
+	void *data[NVME_IO_QUEUE_DEPTH];
+	/** Length of the data of the command */
+	size_t len[NVME_IO_QUEUE_DEPTH];
+	/** Command reads from the device */
+	bool read[NVME_IO_QUEUE_DEPTH];
+} nvme_queue_t;
+
+struct nvme;
+
+/** Namespace */
+typedef struct {
+	struct nvme *nvme;
+	uint32_t nsid;
+	/** Number of logical blocks */
+	uint64_t blocks;
+	/** Logical block size */
+	size_t block_size;
+	bd_srvs_t bds;
+	ddf_fun_t *fun;
+} nvme_ns_t;
+
+/** NVMe controller */
+typedef struct nvme {
+	ddf_dev_t *dev;
+	async_sess_t *parent_sess;
+
+	nvme_regs_t *regs;
+	size_t regs_size;
+	/** Doorbell stride in bytes */
+	size_t db_stride;
+	/** Controller timeout in milliseconds */
+	unsigned timeout;
+
+	/** Admin queues, commands are polled */
+	nvme_queue_t admin;
+	fibril_mutex_t admin_lock;
+	/** Buffer for identify data */
+	void *id_buf;
+	uintptr_t id_buf_p;
+
+	/** Use SGLs rather than PRPs for I/O commands */
+	bool sgl;
+	/** Maximum size of data of one command */
+	size_t max_xfer;
+
+	/** Number of I/O queue pairs used */
+	unsigned num_queues;
+	nvme_queue_t queues[NVME_MAX_QUEUES];
+	/** Protects nvme_io_t.pending and next_queue */
+	fibril_mutex_t io_lock;
+	/** Queue to use for the next command */
+	unsigned next_queue;
+
+	/** Using message signalled interrupts */
+	bool msi;
+	/** IRQ number of the first vector */
+	int irq;
+	/** Number of interrupt vectors */
+	size_t nvec;
+	cap_irq_handle_t irq_handle[NVME_MAX_QUEUES + 1];
+
+	/** Number of namespaces exposed */
+	unsigned num_ns;
+	nvme_ns_t ns[NVME_MAX_NS];
+} nvme_t;
+
+#endif
+
+/** @}
+ */
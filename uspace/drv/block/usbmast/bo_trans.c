@@ -36,6 +36,8 @@
 
 #include <stdbool.h>
 #include <errno.h>
+#include <macros.h>
+#include <mem.h>
 #include <str_error.h>
 #include <usb/debug.h>
 #include <usb/dev/request.h>
@@ -47,7 +49,63 @@
 #define MASTLOG(format, ...) \
 	usb_log_debug2("USB cl08: " format, ##__VA_ARGS__)
 
+/** Size of the DMA buffer for command block and status wrappers */
+#define BO_CMD_BUF_SIZE \
+	max(sizeof(usb_massstor_cbw_t), sizeof(usb_massstor_csw_t))
+
+/** Largest data phase transferred through the DMA data buffer */
+#define BO_DATA_BUF_MAX (64 * 1024)
+
+static errno_t bo_cmd_locked(usbmast_fun_t *, uint32_t, scsi_cmd_t *);
+
+/** Get the DMA data buffer, growing it to @a size bytes if needed.
+ *
+ * The buffers are allocated with the constraints the host controller
+ * imposes, so that it can transfer to and from them directly. Must be
+ * called with the command lock held.
+ *
+ * @param mdev		Mass storage device
+ * @param size		Size of the data phase in bytes
+ *
+ * @return		DMA buffer or @c NULL if the data phase is too large
+ *			or there is not enough memory
+ */
+static void *bo_data_buf(usbmast_dev_t *mdev, size_t size)
+{
+	if (size > BO_DATA_BUF_MAX)
+		return NULL;
+
+	if (size > mdev->data_buf_size) {
+		usb_pipe_t *pipe = mdev->bulk_in_pipe;
+
+		if (mdev->data_buf != NULL)
+			usb_pipe_free_buffer(pipe, mdev->data_buf);
+		mdev->data_buf = usb_pipe_alloc_buffer(pipe, size);
+		mdev->data_buf_size = mdev->data_buf != NULL ? size : 0;
+	}
+
+	return mdev->data_buf;
+}
+
+/** Release the DMA buffers of a mass storage device.
+ *
+ * @param mdev		Mass storage device
+ */
+void usb_massstor_fini(usbmast_dev_t *mdev)
+{
+	if (mdev->cmd_buf != NULL)
+		usb_pipe_free_buffer(mdev->bulk_out_pipe, mdev->cmd_buf);
+	if (mdev->data_buf != NULL)
+		usb_pipe_free_buffer(mdev->bulk_in_pipe, mdev->data_buf);
+	mdev->cmd_buf = NULL;
+	mdev->data_buf = NULL;
+	mdev->data_buf_size = 0;
+}
+
 /** Send command via bulk-only transport.
+ *
+ * Commands of all LUNs of the device are serialized, as the CBW, data
+ * and CSW phases of one command must not interleave with another.
  *
  * @param mfun		Mass storage function
  * @param tag		Command block wrapper tag (automatically compared
@@ -63,6 +121,19 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 	if (cmd->data_in && cmd->data_out)
 		return EINVAL;
 
+	fibril_mutex_lock(&mfun->mdev->cmd_lock);
+	rc = bo_cmd_locked(mfun, tag, cmd);
+	fibril_mutex_unlock(&mfun->mdev->cmd_lock);
+
+	return rc;
+}
+
+/** Send command via bulk-only transport with the command lock held. */
+static errno_t bo_cmd_locked(usbmast_fun_t *mfun, uint32_t tag,
+    scsi_cmd_t *cmd)
+{
+	errno_t rc;
+
 	usb_pipe_t *bulk_in_pipe = mfun->mdev->bulk_in_pipe;
 	usb_pipe_t *bulk_out_pipe = mfun->mdev->bulk_out_pipe;
 
@@ -76,6 +147,15 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 		dpipe = bulk_in_pipe;
 	}
 
+	if (mfun->mdev->cmd_buf == NULL) {
+		mfun->mdev->cmd_buf = usb_pipe_alloc_buffer(bulk_out_pipe,
+		    BO_CMD_BUF_SIZE);
+		if (mfun->mdev->cmd_buf == NULL)
+			return ENOMEM;
+	}
+	void *cmd_buf = mfun->mdev->cmd_buf;
+	void *data_buf = bo_data_buf(mfun->mdev, dbuf_size);
+
 	/* Prepare CBW - command block wrapper */
 	usb_massstor_cbw_t cbw;
 	usb_massstor_cbw_prepare(&cbw, tag, dbuf_size, ddir, mfun->lun,
@@ -83,7 +163,8 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 
 	/* Send the CBW. */
 	MASTLOG("Sending CBW.\n");
-	rc = usb_pipe_write(bulk_out_pipe, &cbw, sizeof(cbw));
+	memcpy(cmd_buf, &cbw, sizeof(cbw));
+	rc = usb_pipe_write_dma(bulk_out_pipe, cmd_buf, cmd_buf, sizeof(cbw));
 	MASTLOG("CBW '%s' sent: %s.\n",
 	    usb_debug_str_buffer((uint8_t *) &cbw, sizeof(cbw), 0),
 	    str_error(rc));
@@ -96,15 +177,29 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 	if (cmd->data_in) {
 		size_t act_size;
 		/* Recieve data from the device. */
-		rc = usb_pipe_read(dpipe, cmd->data_in, cmd->data_in_size,
-		    &act_size);
+		if (data_buf != NULL) {
+			rc = usb_pipe_read_dma(dpipe, data_buf, data_buf,
+			    cmd->data_in_size, &act_size);
+			if (rc == EOK)
+				memcpy(cmd->data_in, data_buf, act_size);
+		} else {
+			rc = usb_pipe_read(dpipe, cmd->data_in,
+			    cmd->data_in_size, &act_size);
+		}
 		MASTLOG("Received %zu bytes (%s): %s.\n", act_size,
 		    usb_debug_str_buffer(cmd->data_in, act_size, 0),
 		    str_error(rc));
 	}
 	if (cmd->data_out) {
 		/* Send data to the device. */
-		rc = usb_pipe_write(dpipe, cmd->data_out, cmd->data_out_size);
+		if (data_buf != NULL) {
+			memcpy(data_buf, cmd->data_out, cmd->data_out_size);
+			rc = usb_pipe_write_dma(dpipe, data_buf, data_buf,
+			    cmd->data_out_size);
+		} else {
+			rc = usb_pipe_write(dpipe, cmd->data_out,
+			    cmd->data_out_size);
+		}
 		MASTLOG("Sent %zu bytes (%s): %s.\n", cmd->data_out_size,
 		    usb_debug_str_buffer(cmd->data_out, cmd->data_out_size, 0),
 		    str_error(rc));
@@ -123,7 +218,10 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 	usb_massstor_csw_t csw;
 	size_t csw_size;
 	MASTLOG("Reading CSW.\n");
-	rc = usb_pipe_read(bulk_in_pipe, &csw, sizeof(csw), &csw_size);
+	rc = usb_pipe_read_dma(bulk_in_pipe, cmd_buf, cmd_buf, sizeof(csw),
+	    &csw_size);
+	if (rc == EOK)
+		memcpy(&csw, cmd_buf, min(csw_size, sizeof(csw)));
 	MASTLOG("CSW '%s' received (%zu bytes): %s.\n",
 	    usb_debug_str_buffer((uint8_t *) &csw, csw_size, 0), csw_size,
 	    str_error(rc));
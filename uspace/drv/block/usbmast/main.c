@@ -39,7 +39,10 @@
 #include <as.h>
 #include <async.h>
 #include <bd_srv.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <macros.h>
+#include <stdlib.h>
 #include <usb/dev/driver.h>
 #include <usb/debug.h>
 #include <usb/classes/classes.h>
@@ -54,6 +57,9 @@
 
 #define NAME "usbmast"
 
+/** Maximum size of one read or write command built from merged extents */
+#define USBMAST_RUN_MAX_SIZE (256 * 1024)
+
 static const usb_endpoint_description_t bulk_in_ep = {
 	.transfer_type = USB_TRANSFER_BULK,
 	.direction = USB_DIRECTION_IN,
@@ -87,6 +93,7 @@ static errno_t usbmast_bd_sync_cache(bd_srv_t *, aoff64_t, size_t);
 static errno_t usbmast_bd_write_blocks(bd_srv_t *, aoff64_t, size_t, const void *, size_t);
 static errno_t usbmast_bd_get_block_size(bd_srv_t *, size_t *);
 static errno_t usbmast_bd_get_num_blocks(bd_srv_t *, aoff64_t *);
+static errno_t usbmast_bd_submit(bd_srv_t *, bd_io_t *);
 
 static bd_ops_t usbmast_bd_ops = {
 	.open = usbmast_bd_open,
@@ -95,7 +102,8 @@ static bd_ops_t usbmast_bd_ops = {
 	.sync_cache = usbmast_bd_sync_cache,
 	.write_blocks = usbmast_bd_write_blocks,
 	.get_block_size = usbmast_bd_get_block_size,
-	.get_num_blocks = usbmast_bd_get_num_blocks
+	.get_num_blocks = usbmast_bd_get_num_blocks,
+	.submit = usbmast_bd_submit
 };
 
 static usbmast_fun_t *bd_srv_usbmast(bd_srv_t *bd)
@@ -124,6 +132,7 @@ static errno_t usbmast_device_gone(usb_device_t *dev)
 		mdev->luns[i] = NULL;
 	}
 	free(mdev->luns);
+	usb_massstor_fini(mdev);
 	return EOK;
 }
 
@@ -167,6 +176,10 @@ static errno_t usbmast_device_add(usb_device_t *dev)
 	}
 
 	mdev->usb_dev = dev;
+	fibril_mutex_initialize(&mdev->cmd_lock);
+	fibril_mutex_initialize(&mdev->io_lock);
+	list_initialize(&mdev->io_queue);
+	mdev->io_running = false;
 
 	usb_log_info("Initializing mass storage `%s'.",
 	    usb_device_get_name(dev));
@@ -205,6 +218,7 @@ error:
 		ddf_fun_destroy(mdev->luns[i]);
 	}
 	free(mdev->luns);
+	usb_massstor_fini(mdev);
 	return rc;
 }
 
@@ -393,6 +407,120 @@ static errno_t usbmast_bd_get_num_blocks(bd_srv_t *bd, aoff64_t *rnb)
 	return EOK;
 }
 
+/** Carry out one vectored request.
+ *
+ * Extents which follow each other both on the device and in the shared
+ * buffer are merged into a single command, saving the command and status
+ * phases of the others.
+ */
+static errno_t usbmast_io_run(usbmast_fun_t *mfun, bd_io_t *io)
+{
+	size_t max_blocks = min(USBMAST_RUN_MAX_SIZE / mfun->block_size,
+	    UINT16_MAX);
+	size_t i = 0;
+	errno_t rc;
+
+	if (max_blocks == 0)
+		max_blocks = 1;
+
+	while (i < io->nvec) {
+		uint64_t ba = io->vec[i].ba;
+		uint64_t cnt = io->vec[i].cnt;
+		uint64_t offs = io->vec[i].offs;
+		void *data = bd_io_buf(io, i);
+
+		for (i++; i < io->nvec; i++) {
+			if (io->vec[i].ba != ba + cnt ||
+			    io->vec[i].offs != offs + cnt * mfun->block_size ||
+			    cnt + io->vec[i].cnt > max_blocks)
+				break;
+			cnt += io->vec[i].cnt;
+		}
+
+		if (ba + cnt < ba || ba + cnt > mfun->nblocks)
+			return ELIMIT;
+
+		/* An extent larger than one command is split. */
+		while (cnt > 0) {
+			size_t n = min(cnt, max_blocks);
+
+			if (io->write)
+				rc = usbmast_write(mfun, ba, n, data);
+			else
+				rc = usbmast_read(mfun, ba, n, data);
+			if (rc != EOK)
+				return rc;
+
+			ba += n;
+			cnt -= n;
+			data = (uint8_t *) data + n * mfun->block_size;
+		}
+	}
+
+	return EOK;
+}
+
+/** Fibril carrying out queued vectored requests of a device.
+ *
+ * Terminates when the queue is drained, usbmast_bd_submit() starts a new
+ * one when needed.
+ */
+static errno_t usbmast_io_fibril(void *arg)
+{
+	usbmast_dev_t *mdev = (usbmast_dev_t *) arg;
+	bd_io_t *io;
+	errno_t rc;
+
+	fibril_mutex_lock(&mdev->io_lock);
+
+	while (!list_empty(&mdev->io_queue)) {
+		io = list_get_instance(list_first(&mdev->io_queue), bd_io_t,
+		    link);
+		list_remove(&io->link);
+		fibril_mutex_unlock(&mdev->io_lock);
+
+		rc = usbmast_io_run((usbmast_fun_t *) io->arg, io);
+		bd_io_done(io, rc);
+
+		fibril_mutex_lock(&mdev->io_lock);
+	}
+
+	mdev->io_running = false;
+	fibril_mutex_unlock(&mdev->io_lock);
+	return EOK;
+}
+
+/** Start a vectored request.
+ *
+ * The request is queued and carried out by the I/O fibril of the device,
+ * so the client can keep submitting requests while the device is busy.
+ */
+static errno_t usbmast_bd_submit(bd_srv_t *bd, bd_io_t *io)
+{
+	usbmast_fun_t *mfun = bd_srv_usbmast(bd);
+	usbmast_dev_t *mdev = mfun->mdev;
+	fid_t fid;
+
+	io->arg = mfun;
+
+	fibril_mutex_lock(&mdev->io_lock);
+
+	if (!mdev->io_running) {
+		fid = fibril_create(usbmast_io_fibril, mdev);
+		if (fid == 0) {
+			fibril_mutex_unlock(&mdev->io_lock);
+			return ENOMEM;
+		}
+
+		mdev->io_running = true;
+		fibril_add_ready(fid);
+	}
+
+	list_append(&io->link, &mdev->io_queue);
+	fibril_mutex_unlock(&mdev->io_lock);
+	return EOK;
+}
+
 /** USB mass storage driver ops. */
 static const usb_driver_ops_t usbmast_driver_ops = {
 	.device_add = usbmast_device_add,
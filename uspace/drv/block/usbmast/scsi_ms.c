@@ -105,7 +105,9 @@ static errno_t usb_massstor_unit_ready(usbmast_fun_t *mfun)
 
 /** Run SCSI command.
  *
- * Run command and repeat in case of unit attention.
+ * Run command and repeat in case of unit attention. Unit readiness is only
+ * tested before the first command and after a failed one, a unit attention
+ * is reported by the command itself anyway.
  * XXX This is too simplified.
  */
 static errno_t usbmast_run_cmd(usbmast_fun_t *mfun, scsi_cmd_t *cmd)
@@ -115,20 +117,26 @@ static errno_t usbmast_run_cmd(usbmast_fun_t *mfun, scsi_cmd_t *cmd)
 	errno_t rc;
 
 	do {
-		rc = usb_massstor_unit_ready(mfun);
-		if (rc != EOK) {
-			usb_log_error("Inquiry transport failed, device %s: %s.",
-			    usb_device_get_name(mfun->mdev->usb_dev), str_error(rc));
-			return rc;
+		if (!mfun->unit_ready) {
+			rc = usb_massstor_unit_ready(mfun);
+			if (rc != EOK) {
+				usb_log_error("Inquiry transport failed, "
+				    "device %s: %s.",
+				    usb_device_get_name(mfun->mdev->usb_dev),
+				    str_error(rc));
+				return rc;
+			}
 		}
 
 		rc = usb_massstor_cmd(mfun, 0xDEADBEEF, cmd);
 		if (rc != EOK) {
+			mfun->unit_ready = false;
 			usb_log_error("Inquiry transport failed, device %s: %s.",
 			    usb_device_get_name(mfun->mdev->usb_dev), str_error(rc));
 			return rc;
 		}
 
+		mfun->unit_ready = (cmd->status == CMDS_GOOD);
 		if (cmd->status == CMDS_GOOD)
 			return EOK;
 
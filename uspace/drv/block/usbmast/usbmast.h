@@ -36,7 +36,10 @@
 #ifndef USBMAST_H_
 #define USBMAST_H_
 
+#include <adt/list.h>
 #include <bd_srv.h>
+#include <fibril_synch.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <usb/usb.h>
@@ -53,6 +56,20 @@ typedef struct usbmast_dev {
 	usb_pipe_t *bulk_in_pipe;
 	/** Data write pipe */
 	usb_pipe_t *bulk_out_pipe;
+	/** Serializes commands, bulk-only transport has one at a time */
+	fibril_mutex_t cmd_lock;
+	/** Protects @c io_queue and @c io_running */
+	fibril_mutex_t io_lock;
+	/** Vectored requests waiting for the I/O fibril (bd_io_t) */
+	list_t io_queue;
+	/** @c true while the I/O fibril is running */
+	bool io_running;
+	/** DMA buffer for command block and status wrappers */
+	void *cmd_buf;
+	/** DMA buffer for data, allocated on demand */
+	void *data_buf;
+	/** Size of @c data_buf in bytes */
+	size_t data_buf_size;
 } usbmast_dev_t;
 
 /** Mass storage function.
@@ -70,6 +87,8 @@ typedef struct {
 	uint64_t nblocks;
 	/** Block size in bytes */
 	size_t block_size;
+	/** Last command succeeded, no need to test unit readiness */
+	bool unit_ready;
 	/** Block device service structure */
 	bd_srvs_t bds;
 } usbmast_fun_t;
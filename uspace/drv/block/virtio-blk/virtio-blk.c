@@ -32,11 +32,13 @@
 #include <stdint.h>
 
 #include <as.h>
+#include <macros.h>
 #include <ddf/driver.h>
 #include <ddf/interrupt.h>
 #include <ddf/log.h>
 #include <pci_dev_iface.h>
 #include <fibril_synch.h>
+#include <stats.h>
 
 #include <bd_srv.h>
 
@@ -44,10 +46,6 @@
 
 #define NAME	"virtio-blk"
 
-#define VIRTIO_BLK_NUM_QUEUES	1
-
-#define RQ_QUEUE	0
-
 /*
  * VIRTIO_BLK requests need at least two descriptors so that device-read-only
  * buffers are separated from device-writable buffers. For convenience, we
@@ -56,12 +54,24 @@
  * used for request headers, the following RQ_BUFFERS descriptors are used
  * for in/out buffers and the last RQ_BUFFERS descriptors are used for request
  * footers.
+ *
+ * If the device supports indirect descriptors, the three descriptors live in
+ * a per-request table instead and the virtqueue only has RQ_BUFFERS
+ * descriptors, each pointing to one table.
+ *
+ * The descriptor chains are built when the queue is set up, a request only
+ * updates the length and direction of its buffer descriptor.
  */
 #define REQ_HEADER_DESC(descno)	(0 * RQ_BUFFERS + (descno))
 #define REQ_BUFFER_DESC(descno)	(1 * RQ_BUFFERS + (descno))
 #define REQ_FOOTER_DESC(descno)	(2 * RQ_BUFFERS + (descno))
 
+/** Number of descriptors of one request */
+#define REQ_DESCS	3
+
 static errno_t virtio_blk_dev_add(ddf_dev_t *dev);
+static void virtio_blk_io_complete(virtio_blk_t *, virtio_blk_queue_t *,
+    uint16_t, virtio_blk_io_t *);
 
 static driver_ops_t virtio_blk_driver_ops = {
 	.dev_add = virtio_blk_dev_add
@@ -80,11 +90,28 @@ static void virtio_blk_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 	uint16_t descno;
 	uint32_t len;
 
-	while (virtio_virtq_consume_used(vdev, RQ_QUEUE, &descno, &len)) {
-		assert(descno < RQ_BUFFERS);
-		fibril_mutex_lock(&virtio_blk->completion_lock[descno]);
-		fibril_condvar_signal(&virtio_blk->completion_cv[descno]);
-		fibril_mutex_unlock(&virtio_blk->completion_lock[descno]);
+	/* All request queues share the interrupt. */
+	for (unsigned i = 0; i < virtio_blk->num_queues; i++) {
+		virtio_blk_queue_t *q = &virtio_blk->queues[i];
+
+		while (virtio_virtq_consume_used(vdev, q->num, &descno, &len)) {
+			assert(descno < RQ_BUFFERS);
+
+			fibril_mutex_lock(&virtio_blk->io_lock);
+			virtio_blk_io_t *vio = q->rq_io[descno];
+			q->rq_io[descno] = NULL;
+			fibril_mutex_unlock(&virtio_blk->io_lock);
+
+			if (vio != NULL) {
+				virtio_blk_io_complete(virtio_blk, q, descno,
+				    vio);
+				continue;
+			}
+
+			fibril_mutex_lock(&q->completion_lock[descno]);
+			fibril_condvar_signal(&q->completion_cv[descno]);
+			fibril_mutex_unlock(&q->completion_lock[descno]);
+		}
 	}
 }
 
@@ -157,34 +184,84 @@ static errno_t virtio_blk_bd_close(bd_srv_t *bd)
 	return EOK;
 }
 
-static errno_t virtio_blk_rw_block(virtio_blk_t *virtio_blk, bool read,
-    aoff64_t ba, void *buf)
+/** Choose the request queue for a new request.
+ *
+ * The driver cannot tell which CPU it is running on, so the queues are used
+ * in turn to spread the requests over them.
+ */
+static virtio_blk_queue_t *virtio_blk_queue_get(virtio_blk_t *virtio_blk)
+{
+	fibril_mutex_lock(&virtio_blk->io_lock);
+	virtio_blk_queue_t *q = &virtio_blk->queues[virtio_blk->next_queue];
+	virtio_blk->next_queue = (virtio_blk->next_queue + 1) %
+	    virtio_blk->num_queues;
+	fibril_mutex_unlock(&virtio_blk->io_lock);
+
+	return q;
+}
+
+/** Allocate a descriptor, waiting for one to become free.
+ *
+ * The allocated descno will determine the header descriptor
+ * (REQ_HEADER_DESC), the buffer descriptor (REQ_BUFFER_DESC) and the
+ * footer (REQ_FOOTER_DESC) descriptor.
+ */
+static uint16_t virtio_blk_desc_alloc(virtio_blk_t *virtio_blk,
+    virtio_blk_queue_t *q)
 {
 	virtio_dev_t *vdev = &virtio_blk->virtio_dev;
 
-	/*
-	 * Allocate a descriptor.
-	 *
-	 * The allocated descno will determine the header descriptor
-	 * (REQ_HEADER_DESC), the buffer descriptor (REQ_BUFFER_DESC) and the
-	 * footer (REQ_FOOTER_DESC) descriptor.
-	 */
-	fibril_mutex_lock(&virtio_blk->free_lock);
-	uint16_t descno = virtio_alloc_desc(vdev, RQ_QUEUE,
-	    &virtio_blk->rq_free_head);
-	while (descno == (uint16_t) -1U) {
-		fibril_condvar_wait(&virtio_blk->free_cv,
-		    &virtio_blk->free_lock);
-		descno = virtio_alloc_desc(vdev, RQ_QUEUE,
-		    &virtio_blk->rq_free_head);
+	fibril_mutex_lock(&q->free_lock);
+	while (q->rq_nfree == 0) {
+		/*
+		 * Requests added but not yet notified would otherwise never
+		 * complete and free a descriptor.
+		 */
+		virtio_virtq_notify(vdev, q->num);
+		fibril_condvar_wait(&q->free_cv, &q->free_lock);
 	}
-	fibril_mutex_unlock(&virtio_blk->free_lock);
+	uint16_t descno = q->rq_free[--q->rq_nfree];
+	fibril_mutex_unlock(&q->free_lock);
 
 	assert(descno < RQ_BUFFERS);
+	return descno;
+}
+
+/** Free the descriptor and buffer */
+static void virtio_blk_desc_free(virtio_blk_t *virtio_blk,
+    virtio_blk_queue_t *q, uint16_t descno)
+{
+	fibril_mutex_lock(&q->free_lock);
+	assert(q->rq_nfree < RQ_BUFFERS);
+	q->rq_free[q->rq_nfree++] = descno;
+	fibril_condvar_signal(&q->free_cv);
+	fibril_mutex_unlock(&q->free_lock);
+}
+
+/** Set up a request in a descriptor and put it on the available ring.
+ *
+ * The device is not notified, the caller needs to call virtio_virtq_notify()
+ * after setting up a batch of requests.
+ *
+ * @param virtio_blk	Device
+ * @param q		Request queue
+ * @param descno	Allocated descriptor
+ * @param read		@c true to read, @c false to write
+ * @param ba		Address of first block
+ * @param buf		Data to write, unused when reading
+ * @param len		Length of the data, at most RQ_BUF_SIZE
+ */
+static void virtio_blk_desc_start(virtio_blk_t *virtio_blk,
+    virtio_blk_queue_t *q, uint16_t descno, bool read, aoff64_t ba,
+    const void *buf, size_t len)
+{
+	virtio_dev_t *vdev = &virtio_blk->virtio_dev;
+
+	assert(len <= RQ_BUF_SIZE);
 
 	/* Setup the request header */
 	virtio_blk_req_header_t *req_header =
-	    (virtio_blk_req_header_t *) virtio_blk->rq_header[descno];
+	    (virtio_blk_req_header_t *) q->rq_header[descno];
 	memset(req_header, 0, sizeof(virtio_blk_req_header_t));
 	pio_write_le32(&req_header->type,
 	    read ? VIRTIO_BLK_T_IN : VIRTIO_BLK_T_OUT);
@@ -192,63 +269,72 @@ static errno_t virtio_blk_rw_block(virtio_blk_t *virtio_blk, bool read,
 
 	/* Copy write data to the request. */
 	if (!read)
-		memcpy(virtio_blk->rq_buf[descno], buf, VIRTIO_BLK_BLOCK_SIZE);
-
-	fibril_mutex_lock(&virtio_blk->completion_lock[descno]);
-
-	/*
-	 * Set the descriptors, chain them in the virtqueue and notify the
-	 * device.
-	 */
-	virtio_virtq_desc_set(vdev, RQ_QUEUE, REQ_HEADER_DESC(descno),
-	    virtio_blk->rq_header_p[descno], sizeof(virtio_blk_req_header_t),
-	    VIRTQ_DESC_F_NEXT, REQ_BUFFER_DESC(descno));
-	virtio_virtq_desc_set(vdev, RQ_QUEUE, REQ_BUFFER_DESC(descno),
-	    virtio_blk->rq_buf_p[descno], VIRTIO_BLK_BLOCK_SIZE,
-	    VIRTQ_DESC_F_NEXT | (read ? VIRTQ_DESC_F_WRITE : 0),
-	    REQ_FOOTER_DESC(descno));
-	virtio_virtq_desc_set(vdev, RQ_QUEUE, REQ_FOOTER_DESC(descno),
-	    virtio_blk->rq_footer_p[descno], sizeof(virtio_blk_req_footer_t),
-	    VIRTQ_DESC_F_WRITE, 0);
-	virtio_virtq_produce_available(vdev, RQ_QUEUE, descno);
+		memcpy(q->rq_buf[descno], buf, len);
+
+	uint16_t bflags = read ? VIRTQ_DESC_F_WRITE : 0;
+
+	/* The rest of the chain has been set up by virtio_blk_queue_init(). */
+	if (vdev->features & VIRTIO_F_INDIRECT_DESC) {
+		virtio_virtq_indirect_set(vdev, q->rq_indirect[descno], 1,
+		    q->rq_buf_p[descno], len, VIRTQ_DESC_F_NEXT | bflags);
+	} else {
+		virtio_virtq_desc_set(vdev, q->num, REQ_BUFFER_DESC(descno),
+		    q->rq_buf_p[descno], len, VIRTQ_DESC_F_NEXT | bflags,
+		    REQ_FOOTER_DESC(descno));
+	}
 
-	/*
-	 * Wait for the completion of the request.
-	 */
-	fibril_condvar_wait(&virtio_blk->completion_cv[descno],
-	    &virtio_blk->completion_lock[descno]);
-	fibril_mutex_unlock(&virtio_blk->completion_lock[descno]);
+	virtio_virtq_add_available(vdev, q->num, descno);
+}
 
-	errno_t rc;
+/** Get the result of a completed request. */
+static errno_t virtio_blk_desc_status(virtio_blk_queue_t *q, uint16_t descno)
+{
 	virtio_blk_req_footer_t *footer =
-	    (virtio_blk_req_footer_t *) virtio_blk->rq_footer[descno];
+	    (virtio_blk_req_footer_t *) q->rq_footer[descno];
+
 	switch (footer->status) {
 	case VIRTIO_BLK_S_OK:
-		rc = EOK;
-		break;
+		return EOK;
 	case VIRTIO_BLK_S_IOERR:
-		rc = EIO;
-		break;
+		return EIO;
 	case VIRTIO_BLK_S_UNSUPP:
-		rc = ENOTSUP;
-		break;
+		return ENOTSUP;
 	default:
 		ddf_msg(LVL_DEBUG, "device returned unknown status=%d\n",
 		    (int) footer->status);
-		rc = EIO;
-		break;
+		return EIO;
 	}
+}
+
+static errno_t virtio_blk_rw_block(virtio_blk_t *virtio_blk, bool read,
+    aoff64_t ba, void *buf, size_t len)
+{
+	virtio_blk_queue_t *q = virtio_blk_queue_get(virtio_blk);
+	uint16_t descno = virtio_blk_desc_alloc(virtio_blk, q);
+
+	fibril_mutex_lock(&virtio_blk->io_lock);
+	q->rq_io[descno] = NULL;
+	fibril_mutex_unlock(&virtio_blk->io_lock);
+
+	fibril_mutex_lock(&q->completion_lock[descno]);
+
+	virtio_blk_desc_start(virtio_blk, q, descno, read, ba, buf, len);
+	virtio_virtq_notify(&virtio_blk->virtio_dev, q->num);
+
+	/*
+	 * Wait for the completion of the request.
+	 */
+	fibril_condvar_wait(&q->completion_cv[descno],
+	    &q->completion_lock[descno]);
+	fibril_mutex_unlock(&q->completion_lock[descno]);
+
+	errno_t rc = virtio_blk_desc_status(q, descno);
 
 	/* Copy read data from the request */
 	if (rc == EOK && read)
-		memcpy(buf, virtio_blk->rq_buf[descno], VIRTIO_BLK_BLOCK_SIZE);
-
-	/* Free the descriptor and buffer */
-	fibril_mutex_lock(&virtio_blk->free_lock);
-	virtio_free_desc(vdev, RQ_QUEUE, &virtio_blk->rq_free_head, descno);
-	fibril_condvar_signal(&virtio_blk->free_cv);
-	fibril_mutex_unlock(&virtio_blk->free_lock);
+		memcpy(buf, q->rq_buf[descno], len);
 
+	virtio_blk_desc_free(virtio_blk, q, descno);
 	return rc;
 }
 
@@ -262,9 +348,11 @@ static errno_t virtio_blk_bd_rw_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
 	if (size != cnt * VIRTIO_BLK_BLOCK_SIZE)
 		return EINVAL;
 
-	for (i = 0; i < cnt; i++) {
+	for (i = 0; i < cnt; i += RQ_BUF_BLOCKS) {
+		size_t n = min(cnt - i, (aoff64_t) RQ_BUF_BLOCKS);
+
 		rc = virtio_blk_rw_block(virtio_blk, read, ba + i,
-		    buf + i * VIRTIO_BLK_BLOCK_SIZE);
+		    buf + i * VIRTIO_BLK_BLOCK_SIZE, n * VIRTIO_BLK_BLOCK_SIZE);
 		if (rc != EOK)
 			return rc;
 	}
@@ -272,6 +360,87 @@ static errno_t virtio_blk_bd_rw_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
 	return EOK;
 }
 
+/** Drop a reference to a vectored request, completing it with the last. */
+static void virtio_blk_io_put(virtio_blk_t *virtio_blk, virtio_blk_io_t *vio,
+    errno_t rc)
+{
+	fibril_mutex_lock(&virtio_blk->io_lock);
+	if (rc != EOK && vio->rc == EOK)
+		vio->rc = rc;
+	bool last = --vio->pending == 0;
+	fibril_mutex_unlock(&virtio_blk->io_lock);
+
+	if (last) {
+		bd_io_done(vio->io, vio->rc);
+		free(vio);
+	}
+}
+
+/** Complete a device request which is part of a vectored request. */
+static void virtio_blk_io_complete(virtio_blk_t *virtio_blk,
+    virtio_blk_queue_t *q, uint16_t descno, virtio_blk_io_t *vio)
+{
+	errno_t rc = virtio_blk_desc_status(q, descno);
+
+	if (rc == EOK && q->rq_read[descno])
+		memcpy(q->rq_data[descno], q->rq_buf[descno], q->rq_len[descno]);
+
+	virtio_blk_desc_free(virtio_blk, q, descno);
+	virtio_blk_io_put(virtio_blk, vio, rc);
+}
+
+/** Start a vectored request.
+ *
+ * The extents are split into device requests of up to RQ_BUF_SIZE bytes
+ * which are all put on one request queue without waiting, so that up to
+ * RQ_BUFFERS of them are in flight. The device is notified once for the
+ * whole batch. The vectored request completes when the last of them does.
+ */
+static errno_t virtio_blk_bd_submit(bd_srv_t *bd, bd_io_t *io)
+{
+	virtio_blk_t *virtio_blk = (virtio_blk_t *) bd->srvs->sarg;
+	virtio_blk_queue_t *q;
+	virtio_blk_io_t *vio;
+
+	vio = calloc(1, sizeof(virtio_blk_io_t));
+	if (vio == NULL)
+		return ENOMEM;
+
+	vio->io = io;
+	vio->pending = 1;
+	vio->rc = EOK;
+
+	q = virtio_blk_queue_get(virtio_blk);
+
+	for (size_t i = 0; i < io->nvec; i++) {
+		uint8_t *data = bd_io_buf(io, i);
+
+		for (aoff64_t j = 0; j < io->vec[i].cnt; j += RQ_BUF_BLOCKS) {
+			size_t n = min(io->vec[i].cnt - j,
+			    (aoff64_t) RQ_BUF_BLOCKS);
+			uint16_t descno = virtio_blk_desc_alloc(virtio_blk, q);
+
+			fibril_mutex_lock(&virtio_blk->io_lock);
+			q->rq_io[descno] = vio;
+			q->rq_data[descno] = data + j * VIRTIO_BLK_BLOCK_SIZE;
+			q->rq_len[descno] = n * VIRTIO_BLK_BLOCK_SIZE;
+			q->rq_read[descno] = !io->write;
+			vio->pending++;
+			fibril_mutex_unlock(&virtio_blk->io_lock);
+
+			virtio_blk_desc_start(virtio_blk, q, descno, !io->write,
+			    io->vec[i].ba + j, q->rq_data[descno],
+			    q->rq_len[descno]);
+		}
+	}
+
+	virtio_virtq_notify(&virtio_blk->virtio_dev, q->num);
+
+	/* Drop the reference held while submitting. */
+	virtio_blk_io_put(virtio_blk, vio, EOK);
+	return EOK;
+}
+
 static errno_t virtio_blk_bd_read_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
     void *buf, size_t size)
 {
@@ -305,8 +474,129 @@ bd_ops_t virtio_blk_bd_ops = {
 	.write_blocks = virtio_blk_bd_write_blocks,
 	.get_block_size = virtio_blk_bd_get_block_size,
 	.get_num_blocks = virtio_blk_bd_get_num_blocks,
+	.submit = virtio_blk_bd_submit
 };
 
+/** Free the DMA buffers of a request queue. */
+static void virtio_blk_queue_fini(virtio_blk_queue_t *q)
+{
+	virtio_teardown_dma_bufs(q->rq_header);
+	virtio_teardown_dma_bufs(q->rq_buf);
+	virtio_teardown_dma_bufs(q->rq_footer);
+	virtio_teardown_dma_bufs(q->rq_indirect);
+}
+
+/** Set up a request queue and its DMA buffers. */
+static errno_t virtio_blk_queue_init(virtio_blk_t *virtio_blk, uint16_t num)
+{
+	virtio_dev_t *vdev = &virtio_blk->virtio_dev;
+	virtio_blk_queue_t *q = &virtio_blk->queues[num];
+	bool indirect = (vdev->features & VIRTIO_F_INDIRECT_DESC) != 0;
+	errno_t rc;
+
+	q->num = num;
+
+	/*
+	 * For each in/out request we need 3 descriptors, unless they are in
+	 * an indirect table.
+	 */
+	rc = virtio_virtq_setup(vdev, num,
+	    indirect ? RQ_BUFFERS : REQ_DESCS * RQ_BUFFERS);
+	if (rc != EOK)
+		return rc;
+
+	/*
+	 * Setup DMA buffers
+	 */
+	rc = virtio_setup_dma_bufs(RQ_BUFFERS, sizeof(virtio_blk_req_header_t),
+	    true, q->rq_header, q->rq_header_p);
+	if (rc != EOK)
+		return rc;
+	rc = virtio_setup_dma_bufs(RQ_BUFFERS, RQ_BUF_SIZE,
+	    true, q->rq_buf, q->rq_buf_p);
+	if (rc != EOK)
+		return rc;
+	rc = virtio_setup_dma_bufs(RQ_BUFFERS, sizeof(virtio_blk_req_footer_t),
+	    false, q->rq_footer, q->rq_footer_p);
+	if (rc != EOK)
+		return rc;
+	if (indirect) {
+		rc = virtio_setup_dma_bufs(RQ_BUFFERS,
+		    REQ_DESCS * sizeof(virtq_desc_t), true, q->rq_indirect,
+		    q->rq_indirect_p);
+		if (rc != EOK)
+			return rc;
+	}
+
+	/*
+	 * Build the descriptor chains of all requests. The chains never change
+	 * except for the buffer descriptor, see virtio_blk_desc_start().
+	 */
+	for (uint16_t i = 0; i < RQ_BUFFERS; i++) {
+		if (indirect) {
+			void *table = q->rq_indirect[i];
+
+			virtio_virtq_indirect_set(vdev, table, 0,
+			    q->rq_header_p[i], sizeof(virtio_blk_req_header_t),
+			    VIRTQ_DESC_F_NEXT);
+			virtio_virtq_indirect_set(vdev, table, 1,
+			    q->rq_buf_p[i], 0, VIRTQ_DESC_F_NEXT);
+			virtio_virtq_indirect_set(vdev, table, 2,
+			    q->rq_footer_p[i], sizeof(virtio_blk_req_footer_t),
+			    VIRTQ_DESC_F_WRITE);
+			virtio_virtq_desc_set(vdev, num, i, q->rq_indirect_p[i],
+			    REQ_DESCS * sizeof(virtq_desc_t),
+			    VIRTQ_DESC_F_INDIRECT, 0);
+		} else {
+			virtio_virtq_desc_set(vdev, num, REQ_HEADER_DESC(i),
+			    q->rq_header_p[i], sizeof(virtio_blk_req_header_t),
+			    VIRTQ_DESC_F_NEXT, REQ_BUFFER_DESC(i));
+			virtio_virtq_desc_set(vdev, num, REQ_BUFFER_DESC(i),
+			    q->rq_buf_p[i], 0, VIRTQ_DESC_F_NEXT,
+			    REQ_FOOTER_DESC(i));
+			virtio_virtq_desc_set(vdev, num, REQ_FOOTER_DESC(i),
+			    q->rq_footer_p[i], sizeof(virtio_blk_req_footer_t),
+			    VIRTQ_DESC_F_WRITE, 0);
+		}
+	}
+
+	/*
+	 * Put all requests on the free stack. Because of the correspondence
+	 * between the request, buffer and footer descriptors, we only need to
+	 * manage allocations for one set: the request header descriptors.
+	 */
+	for (uint16_t i = 0; i < RQ_BUFFERS; i++)
+		q->rq_free[i] = RQ_BUFFERS - 1 - i;
+	q->rq_nfree = RQ_BUFFERS;
+	return EOK;
+}
+
+/** Determine the number of request queues to use.
+ *
+ * One queue per CPU is used, limited by what the device offers and by
+ * VIRTIO_BLK_MAX_QUEUES.
+ */
+static unsigned virtio_blk_num_queues(virtio_blk_t *virtio_blk)
+{
+	virtio_dev_t *vdev = &virtio_blk->virtio_dev;
+	virtio_blk_cfg_t *blkcfg = vdev->device_cfg;
+	unsigned nq = 1;
+
+	if (vdev->features & VIRTIO_BLK_F_MQ)
+		nq = pio_read_le16(&blkcfg->num_queues);
+
+	size_t cpus;
+	stats_cpu_t *stats = stats_get_cpus(&cpus);
+	if (stats != NULL) {
+		free(stats);
+		nq = min(nq, (unsigned) cpus);
+	}
+
+	nq = min(nq, pio_read_le16(&vdev->common_cfg->num_queues));
+	nq = min(nq, VIRTIO_BLK_MAX_QUEUES);
+	return max(nq, 1);
+}
+
 static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 {
 	virtio_blk_t *virtio_blk = ddf_dev_data_alloc(dev,
@@ -314,12 +604,18 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 	if (!virtio_blk)
 		return ENOMEM;
 
-	fibril_mutex_initialize(&virtio_blk->free_lock);
-	fibril_condvar_initialize(&virtio_blk->free_cv);
+	fibril_mutex_initialize(&virtio_blk->io_lock);
+
+	for (unsigned i = 0; i < VIRTIO_BLK_MAX_QUEUES; i++) {
+		virtio_blk_queue_t *q = &virtio_blk->queues[i];
+
+		fibril_mutex_initialize(&q->free_lock);
+		fibril_condvar_initialize(&q->free_cv);
 
-	for (unsigned i = 0; i < RQ_BUFFERS; i++) {
-		fibril_mutex_initialize(&virtio_blk->completion_lock[i]);
-		fibril_condvar_initialize(&virtio_blk->completion_cv[i]);
+		for (unsigned j = 0; j < RQ_BUFFERS; j++) {
+			fibril_mutex_initialize(&q->completion_lock[j]);
+			fibril_condvar_initialize(&q->completion_cv[j]);
+		}
 	}
 
 	bd_srvs_init(&virtio_blk->bds);
@@ -341,17 +637,18 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 		goto fail;
 
 	/* Reset the device and negotiate the feature bits */
-	rc = virtio_device_setup_start(vdev, 0);
+	rc = virtio_device_setup_start_opt(vdev, 0,
+	    VIRTIO_F_INDIRECT_DESC | VIRTIO_F_EVENT_IDX | VIRTIO_BLK_F_MQ);
 	if (rc != EOK)
 		goto fail;
 
 	/* Perform device-specific setup */
 
 	/*
-	 * Discover and configure the virtqueue
+	 * Discover and configure the virtqueues
 	 */
 	uint16_t num_queues = pio_read_le16(&cfg->num_queues);
-	if (num_queues != VIRTIO_BLK_NUM_QUEUES) {
+	if (num_queues < 1) {
 		ddf_msg(LVL_NOTE, "Unsupported number of virtqueues: %u",
 		    num_queues);
 		rc = ELIMIT;
@@ -364,35 +661,17 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 		goto fail;
 	}
 
-	/* For each in/out request we need 3 descriptors */
-	rc = virtio_virtq_setup(vdev, RQ_QUEUE, 3 * RQ_BUFFERS);
-	if (rc != EOK)
-		goto fail;
-
-	/*
-	 * Setup DMA buffers
-	 */
-	rc = virtio_setup_dma_bufs(RQ_BUFFERS, sizeof(virtio_blk_req_header_t),
-	    true, virtio_blk->rq_header, virtio_blk->rq_header_p);
-	if (rc != EOK)
-		goto fail;
-	rc = virtio_setup_dma_bufs(RQ_BUFFERS, VIRTIO_BLK_BLOCK_SIZE,
-	    true, virtio_blk->rq_buf, virtio_blk->rq_buf_p);
-	if (rc != EOK)
-		goto fail;
-	rc = virtio_setup_dma_bufs(RQ_BUFFERS, sizeof(virtio_blk_req_footer_t),
-	    false, virtio_blk->rq_footer, virtio_blk->rq_footer_p);
-	if (rc != EOK)
-		goto fail;
+	unsigned nq = virtio_blk_num_queues(virtio_blk);
+	for (unsigned i = 0; i < nq; i++) {
+		rc = virtio_blk_queue_init(virtio_blk, i);
+		if (rc != EOK)
+			goto fail;
+	}
 
-	/*
-	 * Put all request descriptors on a free list. Because of the
-	 * correspondence between the request, buffer and footer descriptors,
-	 * we only need to manage allocations for one set: the request header
-	 * descriptors.
-	 */
-	virtio_create_desc_free_list(vdev, RQ_QUEUE, RQ_BUFFERS,
-	    &virtio_blk->rq_free_head);
+	ddf_msg(LVL_NOTE, "Using %u request queue(s)%s%s", nq,
+	    (vdev->features & VIRTIO_F_INDIRECT_DESC) ?
+	    ", indirect descriptors" : "",
+	    (vdev->features & VIRTIO_F_EVENT_IDX) ? ", event index" : "");
 
 	/*
 	 * Enable IRQ
@@ -407,14 +686,14 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 	ddf_msg(LVL_NOTE, "Registered IRQ %d", virtio_blk->irq);
 
 	/* Go live */
+	virtio_blk->num_queues = nq;
 	virtio_device_setup_finalize(vdev);
 
 	return EOK;
 
 fail:
-	virtio_teardown_dma_bufs(virtio_blk->rq_header);
-	virtio_teardown_dma_bufs(virtio_blk->rq_buf);
-	virtio_teardown_dma_bufs(virtio_blk->rq_footer);
+	for (unsigned i = 0; i < VIRTIO_BLK_MAX_QUEUES; i++)
+		virtio_blk_queue_fini(&virtio_blk->queues[i]);
 
 	virtio_device_setup_fail(vdev);
 	virtio_pci_dev_cleanup(vdev);
@@ -425,9 +704,8 @@ static void virtio_blk_uninitialize(ddf_dev_t *dev)
 {
 	virtio_blk_t *virtio_blk = (virtio_blk_t *) ddf_dev_data_get(dev);
 
-	virtio_teardown_dma_bufs(virtio_blk->rq_header);
-	virtio_teardown_dma_bufs(virtio_blk->rq_buf);
-	virtio_teardown_dma_bufs(virtio_blk->rq_footer);
+	for (unsigned i = 0; i < virtio_blk->num_queues; i++)
+		virtio_blk_queue_fini(&virtio_blk->queues[i]);
 
 	virtio_device_setup_fail(&virtio_blk->virtio_dev);
 	virtio_pci_dev_cleanup(&virtio_blk->virtio_dev);
@@ -48,8 +48,17 @@
 
 #define RQ_BUFFERS	32
 
+/** Size of the data buffer of one request. */
+#define RQ_BUF_SIZE	4096
+#define RQ_BUF_BLOCKS	(RQ_BUF_SIZE / VIRTIO_BLK_BLOCK_SIZE)
+
+/** Maximum number of request queues used. */
+#define VIRTIO_BLK_MAX_QUEUES	8
+
 /** Device is read-only. */
 #define VIRTIO_BLK_F_RO		(1U << 5)
+/** Device has multiple request queues. */
+#define VIRTIO_BLK_F_MQ		(1U << 12)
 
 typedef struct {
 	uint32_t type;
@@ -63,10 +72,40 @@ typedef struct {
 
 typedef struct {
 	uint64_t capacity;
+	uint32_t size_max;
+	uint32_t seg_max;
+	struct {
+		uint16_t cylinders;
+		uint8_t heads;
+		uint8_t sectors;
+	} geometry;
+	uint32_t blk_size;
+	struct {
+		uint8_t physical_block_exp;
+		uint8_t alignment_offset;
+		uint16_t min_io_size;
+		uint32_t opt_io_size;
+	} topology;
+	uint8_t writeback;
+	uint8_t unused0;
+	/** Number of request queues, valid with VIRTIO_BLK_F_MQ. */
+	uint16_t num_queues;
 } virtio_blk_cfg_t;
 
+/** Vectored request split into requests to the device. */
 typedef struct {
-	virtio_dev_t virtio_dev;
+	/** Vectored request of the client. */
+	bd_io_t *io;
+	/** Number of device requests in flight, plus one while submitting. */
+	unsigned pending;
+	/** Result of the request. */
+	errno_t rc;
+} virtio_blk_io_t;
+
+/** Request queue. */
+typedef struct {
+	/** Index of the virtqueue. */
+	uint16_t num;
 
 	void *rq_header[RQ_BUFFERS];
 	uintptr_t rq_header_p[RQ_BUFFERS];
@@ -77,18 +116,46 @@ typedef struct {
 	void *rq_footer[RQ_BUFFERS];
 	uintptr_t rq_footer_p[RQ_BUFFERS];
 
-	uint16_t rq_free_head;
-
-	int irq;
-	cap_irq_handle_t irq_handle;
+	/** Indirect descriptor tables, with VIRTIO_F_INDIRECT_DESC. */
+	void *rq_indirect[RQ_BUFFERS];
+	uintptr_t rq_indirect_p[RQ_BUFFERS];
 
-	bd_srvs_t bds;
+	/** Stack of free request descriptors. */
+	uint16_t rq_free[RQ_BUFFERS];
+	unsigned rq_nfree;
 
 	fibril_mutex_t free_lock;
 	fibril_condvar_t free_cv;
 
 	fibril_mutex_t completion_lock[RQ_BUFFERS];
 	fibril_condvar_t completion_cv[RQ_BUFFERS];
+
+	/** Vectored request the descriptor belongs to or NULL. */
+	virtio_blk_io_t *rq_io[RQ_BUFFERS];
+	/** Where to copy data read by the descriptor. */
+	void *rq_data[RQ_BUFFERS];
+	/** Length of the data of the descriptor. */
+	size_t rq_len[RQ_BUFFERS];
+	/** Descriptor reads from the device. */
+	bool rq_read[RQ_BUFFERS];
+} virtio_blk_queue_t;
+
+typedef struct {
+	virtio_dev_t virtio_dev;
+
+	int irq;
+	cap_irq_handle_t irq_handle;
+
+	bd_srvs_t bds;
+
+	/** Number of request queues used. */
+	unsigned num_queues;
+	virtio_blk_queue_t queues[VIRTIO_BLK_MAX_QUEUES];
+
+	/** Protects rq_io, virtio_blk_io_t.pending and next_queue. */
+	fibril_mutex_t io_lock;
+	/** Queue to use for the next request. */
+	unsigned next_queue;
 } virtio_blk_t;
 
 #endif
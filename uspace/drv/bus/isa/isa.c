@@ -698,22 +698,17 @@ static void isa_functions_add(isa_bus_t *isa)
 
 static errno_t isa_read_pci_cfg(isa_bus_t *isa, async_sess_t *sess)
 {
-	errno_t rc;
-
-	rc = pci_config_space_read_16(sess, PCI_VENDOR_ID, &isa->pci_vendor_id);
-	if (rc != EOK)
-		return rc;
-	rc = pci_config_space_read_16(sess, PCI_DEVICE_ID, &isa->pci_device_id);
-	if (rc != EOK)
-		return rc;
-	rc = pci_config_space_read_8(sess, PCI_BASE_CLASS, &isa->pci_class);
-	if (rc != EOK)
-		return rc;
-	rc = pci_config_space_read_8(sess, PCI_SUB_CLASS, &isa->pci_subclass);
-	if (rc != EOK)
-		return rc;
-
-	return EOK;
+	ddf_batch_t batch;
+
+	ddf_batch_begin(&batch, sess);
+	pci_config_space_batch_read_16(&batch, PCI_VENDOR_ID,
+	    &isa->pci_vendor_id);
+	pci_config_space_batch_read_16(&batch, PCI_DEVICE_ID,
+	    &isa->pci_device_id);
+	pci_config_space_batch_read_8(&batch, PCI_BASE_CLASS, &isa->pci_class);
+	pci_config_space_batch_read_8(&batch, PCI_SUB_CLASS,
+	    &isa->pci_subclass);
+	return ddf_batch_end(&batch);
 }
 
 static errno_t isa_dev_add(ddf_dev_t *dev)
@@ -0,0 +1,484 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @addtogroup pciintel
+ * @{
+ */
+
+/** @file Message signalled interrupts
+ *
+ * The kernel reserves a window of interrupt vectors for message signalled
+ * interrupts and advertises it in sysinfo. This driver is the only consumer
+ * of the window, it hands out blocks of vectors to PCI functions and
+ * programs their MSI-X or MSI capability accordingly.
+ */
+
+#include <assert.h>
+#include <byteorder.h>
+#include <ddf/log.h>
+#include <ddi.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <macros.h>
+#include <pci_dev_iface.h>
+#include <stdint.h>
+#include <sysinfo.h>
+
+#include "msi.h"
+#include "pci.h"
+#include "pci_regs.h"
+
+/** Maximum number of vectors tracked by the allocator */
+#define MSI_MAX_VECTORS 32
+
+/** Maximum number of capabilities in the configuration space */
+#define PCI_CAP_MAX 48
+
+/** Serializes access to the vector allocator */
+static FIBRIL_MUTEX_INITIALIZE(msi_lock);
+
+/** @c true if the vector window has been read from sysinfo */
+static bool msi_probed;
+/** IRQ number of the first vector in the window */
+static sysarg_t msi_inr;
+/** Number of vectors in the window, zero if MSI is not available */
+static size_t msi_count;
+/** Message address and data of the first vector */
+static sysarg_t msi_address;
+static sysarg_t msi_data;
+/** Bitmap of allocated vectors */
+static uint32_t msi_used;
+
+/** Read the MSI vector window from sysinfo.
+ *
+ * Must be called with @c msi_lock held.
+ */
+static void pci_msi_probe(void)
+{
+	sysarg_t avail;
+	sysarg_t count;
+
+	if (msi_probed)
+		return;
+
+	msi_probed = true;
+
+	if (sysinfo_get_value("msi", &avail) != EOK || !avail)
+		return;
+
+	if (sysinfo_get_value("msi.inr", &msi_inr) != EOK ||
+	    sysinfo_get_value("msi.count", &count) != EOK ||
+	    sysinfo_get_value("msi.address", &msi_address) != EOK ||
+	    sysinfo_get_value("msi.data", &msi_data) != EOK)
+		return;
+
+	msi_count = min(count, MSI_MAX_VECTORS);
+	ddf_msg(LVL_NOTE, "%zu MSI vectors starting at IRQ %" PRIun ".",
+	    msi_count, msi_inr);
+}
+
+/** Allocate a block of consecutive vectors.
+ *
+ * Must be called with @c msi_lock held.
+ *
+ * @param count Number of vectors
+ * @param align Required alignment of the message data of the first vector
+ * @param[out] first Index of the first vector within the window
+ *
+ * @return EOK on success, ENOMEM if there is no suitable free block
+ */
+static errno_t pci_msi_alloc(size_t count, size_t align, size_t *first)
+{
+	uint32_t mask = (count < 32) ? (UINT32_C(1) << count) - 1 : UINT32_MAX;
+
+	for (size_t i = 0; i + count <= msi_count; i++) {
+		if ((msi_data + i) % align != 0)
+			continue;
+
+		if ((msi_used & (mask << i)) == 0) {
+			msi_used |= mask << i;
+			*first = i;
+			return EOK;
+		}
+	}
+
+	return ENOMEM;
+}
+
+/** Free a block of vectors allocated by pci_msi_alloc().
+ *
+ * Must be called with @c msi_lock held.
+ */
+static void pci_msi_free(size_t first, size_t count)
+{
+	uint32_t mask = (count < 32) ? (UINT32_C(1) << count) - 1 : UINT32_MAX;
+
+	msi_used &= ~(mask << first);
+}
+
+/** Find the MSI and MSI-X capabilities of a function.
+ *
+ * @param fun PCI function
+ */
+void pci_read_caps(pci_fun_t *fun)
+{
+	uint8_t ptr;
+	unsigned int i;
+
+	if ((pci_conf_read_16(fun, PCI_STATUS) & PCI_STATUS_CAP_LIST) == 0)
+		return;
+
+	ptr = pci_conf_read_8(fun, PCI_CAP_PTR) & ~3;
+	for (i = 0; ptr >= 0x40 && i < PCI_CAP_MAX; i++) {
+		switch (pci_conf_read_8(fun, PCI_CAP_ID(ptr))) {
+		case PCI_CAP_MSI:
+			fun->msi_cap = ptr;
+			break;
+		case PCI_CAP_MSIX:
+			fun->msix_cap = ptr;
+			break;
+		}
+
+		ptr = pci_conf_read_8(fun, PCI_CAP_NEXT(ptr)) & ~3;
+	}
+
+	if (fun->msi_cap != 0 || fun->msix_cap != 0) {
+		ddf_msg(LVL_DEBUG, "Function %s supports%s%s.",
+		    ddf_fun_get_name(fun->fnode),
+		    fun->msix_cap != 0 ? " MSI-X" : "",
+		    fun->msi_cap != 0 ? " MSI" : "");
+	}
+}
+
+/** Get the physical address of a memory BAR.
+ *
+ * @param fun PCI function
+ * @param bir BAR index
+ * @return Physical address or zero if the BAR is not a memory BAR
+ */
+static uint64_t pci_msix_bar_addr(pci_fun_t *fun, unsigned int bir)
+{
+	int reg = PCI_BASE_ADDR_0 + bir * 4;
+	uint32_t val;
+	uint64_t addr;
+
+	if (bir > 5)
+		return 0;
+
+	val = pci_conf_read_32(fun, reg);
+	if ((val & 1) != 0)
+		return 0;
+
+	addr = val & 0xfffffff0;
+	if (((val >> 1) & 3) == 2 && bir < 5)
+		addr |= (uint64_t) pci_conf_read_32(fun, reg + 4) << 32;
+
+	return addr;
+}
+
+/** Program the MSI-X capability of a function.
+ *
+ * All table entries are left masked.
+ *
+ * @param fun PCI function
+ * @param[in,out] count Number of requested / allocated vectors
+ * @param[out] first Index of the first allocated vector within the window
+ * @return EOK on success or an error code
+ */
+static errno_t pci_msix_setup(pci_fun_t *fun, size_t *count, size_t *first)
+{
+	uint16_t ctl = pci_conf_read_16(fun, fun->msix_cap + PCI_MSIX_CONTROL);
+	uint32_t table = pci_conf_read_32(fun, fun->msix_cap + PCI_MSIX_TABLE);
+	size_t entries = PCI_MSIX_CONTROL_SIZE(ctl);
+	uint64_t addr;
+	size_t n;
+	size_t i;
+	void *virt;
+	errno_t rc;
+
+	addr = pci_msix_bar_addr(fun, table & PCI_MSIX_BIR_MASK);
+	if (addr == 0)
+		return ENOTSUP;
+	addr += table & ~PCI_MSIX_BIR_MASK;
+
+	n = min(min(*count, entries), msi_count);
+	while (n > 0 && pci_msi_alloc(n, 1, first) != EOK)
+		n--;
+	if (n == 0)
+		return ENOMEM;
+
+	fun->msix_table_size = entries * PCI_MSIX_ENTRY_WORDS *
+	    sizeof(ioport32_t);
+	rc = pio_enable((void *) (uintptr_t) addr, fun->msix_table_size, &virt);
+	if (rc != EOK) {
+		pci_msi_free(*first, n);
+		return rc;
+	}
+
+	fun->msix_table = virt;
+
+	/* Enable MSI-X with all vectors masked while setting up the table */
+	ctl |= PCI_MSIX_CONTROL_ENABLE | PCI_MSIX_CONTROL_FMASK;
+	pci_conf_write_16(fun, fun->msix_cap + PCI_MSIX_CONTROL, ctl);
+
+	for (i = 0; i < entries; i++) {
+		ioport32_t *entry = &fun->msix_table[i * PCI_MSIX_ENTRY_WORDS];
+
+		pio_write_32(&entry[PCI_MSIX_ENTRY_CTL],
+		    host2uint32_t_le(PCI_MSIX_ENTRY_CTL_MASK));
+		if (i >= n)
+			continue;
+
+		pio_write_32(&entry[PCI_MSIX_ENTRY_ADDR_LO],
+		    host2uint32_t_le(msi_address));
+		pio_write_32(&entry[PCI_MSIX_ENTRY_ADDR_HI], 0);
+		pio_write_32(&entry[PCI_MSIX_ENTRY_DATA],
+		    host2uint32_t_le(msi_data + *first + i));
+	}
+
+	ctl &= ~PCI_MSIX_CONTROL_FMASK;
+	pci_conf_write_16(fun, fun->msix_cap + PCI_MSIX_CONTROL, ctl);
+
+	*count = n;
+	return EOK;
+}
+
+/** Program the MSI capability of a function.
+ *
+ * If the function supports per-vector masking, all vectors are left masked.
+ *
+ * @param fun PCI function
+ * @param[in,out] count Number of requested / allocated vectors
+ * @param[out] first Index of the first allocated vector within the window
+ * @return EOK on success or an error code
+ */
+static errno_t pci_msi_cap_setup(pci_fun_t *fun, size_t *count, size_t *first)
+{
+	int cap = fun->msi_cap;
+	uint16_t ctl = pci_conf_read_16(fun, cap + PCI_MSI_CONTROL);
+	bool addr64 = (ctl & PCI_MSI_CONTROL_64BIT) != 0;
+	unsigned int order = PCI_MSI_CONTROL_MMC(ctl);
+	uint16_t data;
+
+	/*
+	 * Multiple messages are signalled by modifying the low bits of the
+	 * message data, so the block must be a power of two and aligned.
+	 */
+	while (order > 0 && (((size_t) 1 << order) > *count ||
+	    ((size_t) 1 << order) > msi_count))
+		order--;
+
+	while (pci_msi_alloc((size_t) 1 << order, (size_t) 1 << order,
+	    first) != EOK) {
+		if (order == 0)
+			return ENOMEM;
+		order--;
+	}
+
+	data = msi_data + *first;
+
+	pci_conf_write_32(fun, cap + PCI_MSI_ADDR_LO, msi_address);
+	if (addr64) {
+		pci_conf_write_32(fun, cap + PCI_MSI_ADDR_HI, 0);
+		pci_conf_write_16(fun, cap + PCI_MSI_DATA_64, data);
+	} else {
+		pci_conf_write_16(fun, cap + PCI_MSI_DATA_32, data);
+	}
+
+	if ((ctl & PCI_MSI_CONTROL_MASKABLE) != 0) {
+		pci_conf_write_32(fun, cap + (addr64 ? PCI_MSI_MASK_64 :
+		    PCI_MSI_MASK_32), UINT32_MAX);
+	}
+
+	ctl &= ~PCI_MSI_CONTROL_MME_MASK;
+	ctl |= PCI_MSI_CONTROL_MME(order) | PCI_MSI_CONTROL_ENABLE;
+	pci_conf_write_16(fun, cap + PCI_MSI_CONTROL, ctl);
+
+	*count = (size_t) 1 << order;
+	return EOK;
+}
+
+/** Switch a function to message signalled interrupts.
+ *
+ * MSI-X is preferred over MSI. The legacy INTx interrupt of the function is
+ * disabled on success.
+ *
+ * @param fun PCI function
+ * @param[in,out] count Number of requested / allocated vectors
+ * @param[out] irq IRQ number of the first allocated vector
+ * @return EOK on success, ENOTSUP if MSI is not available, EBUSY if the
+ *         function already uses MSI, ENOMEM if out of vectors
+ */
+errno_t pci_msi_setup(pci_fun_t *fun, size_t *count, int *irq)
+{
+	size_t first;
+	size_t n = *count;
+	errno_t rc;
+
+	if (n == 0)
+		return EINVAL;
+
+	if (fun->msi_count != 0)
+		return EBUSY;
+
+	if (fun->msi_cap == 0 && fun->msix_cap == 0)
+		return ENOTSUP;
+
+	fibril_mutex_lock(&msi_lock);
+	pci_msi_probe();
+
+	if (msi_count == 0) {
+		fibril_mutex_unlock(&msi_lock);
+		return ENOTSUP;
+	}
+
+	rc = ENOTSUP;
+	if (fun->msix_cap != 0)
+		rc = pci_msix_setup(fun, &n, &first);
+	if (rc == ENOTSUP && fun->msi_cap != 0) {
+		n = *count;
+		rc = pci_msi_cap_setup(fun, &n, &first);
+	}
+
+	fibril_mutex_unlock(&msi_lock);
+
+	if (rc != EOK)
+		return rc;
+
+	fun->command |= PCI_COMMAND_INTX_DISABLE;
+	pci_conf_write_16(fun, PCI_COMMAND, fun->command);
+
+	fun->msi_irq = msi_inr + first;
+	fun->msi_count = n;
+
+	ddf_msg(LVL_NOTE, "Function %s uses %s IRQs %d-%d.",
+	    ddf_fun_get_name(fun->fnode),
+	    fun->msix_table != NULL ? "MSI-X" : "MSI",
+	    fun->msi_irq, fun->msi_irq + (int) n - 1);
+
+	*count = n;
+	*irq = fun->msi_irq;
+	return EOK;
+}
+
+/** Switch a function back to its legacy INTx interrupt.
+ *
+ * @param fun PCI function
+ * @return EOK on success, ENOENT if the function does not use MSI
+ */
+errno_t pci_msi_release(pci_fun_t *fun)
+{
+	uint16_t ctl;
+
+	if (fun->msi_count == 0)
+		return ENOENT;
+
+	if (fun->msix_table != NULL) {
+		ctl = pci_conf_read_16(fun, fun->msix_cap + PCI_MSIX_CONTROL);
+		ctl &= ~PCI_MSIX_CONTROL_ENABLE;
+		pci_conf_write_16(fun, fun->msix_cap + PCI_MSIX_CONTROL, ctl);
+
+		pio_disable((void *) fun->msix_table, fun->msix_table_size);
+		fun->msix_table = NULL;
+	} else {
+		ctl = pci_conf_read_16(fun, fun->msi_cap + PCI_MSI_CONTROL);
+		ctl &= ~PCI_MSI_CONTROL_ENABLE;
+		pci_conf_write_16(fun, fun->msi_cap + PCI_MSI_CONTROL, ctl);
+	}
+
+	fun->command &= ~PCI_COMMAND_INTX_DISABLE;
+	pci_conf_write_16(fun, PCI_COMMAND, fun->command);
+
+	fibril_mutex_lock(&msi_lock);
+	pci_msi_free(fun->msi_irq - msi_inr, fun->msi_count);
+	fibril_mutex_unlock(&msi_lock);
+
+	fun->msi_count = 0;
+	return EOK;
+}
+
+/** Determine whether an IRQ is one of the message signalled vectors of
+ * a function.
+ *
+ * @param fun PCI function
+ * @param irq IRQ number
+ */
+bool pci_msi_owns_interrupt(pci_fun_t *fun, int irq)
+{
+	return fun->msi_count != 0 && irq >= fun->msi_irq &&
+	    (size_t) (irq - fun->msi_irq) < fun->msi_count;
+}
+
+/** Mask or unmask a message signalled vector.
+ *
+ * @param fun PCI function
+ * @param irq IRQ number of the vector
+ * @param mask @c true to mask the vector, @c false to unmask it
+ * @return EOK on success, ENOTSUP if the vector cannot be masked
+ */
+errno_t pci_msi_mask(pci_fun_t *fun, int irq, bool mask)
+{
+	size_t i = irq - fun->msi_irq;
+	uint16_t ctl;
+	uint32_t bits;
+	int reg;
+
+	assert(pci_msi_owns_interrupt(fun, irq));
+
+	if (fun->msix_table != NULL) {
+		ioport32_t *ectl = &fun->msix_table[i * PCI_MSIX_ENTRY_WORDS +
+		    PCI_MSIX_ENTRY_CTL];
+
+		bits = uint32_t_le2host(pio_read_32(ectl));
+		if (mask)
+			bits |= PCI_MSIX_ENTRY_CTL_MASK;
+		else
+			bits &= ~PCI_MSIX_ENTRY_CTL_MASK;
+		pio_write_32(ectl, host2uint32_t_le(bits));
+		return EOK;
+	}
+
+	ctl = pci_conf_read_16(fun, fun->msi_cap + PCI_MSI_CONTROL);
+	if ((ctl & PCI_MSI_CONTROL_MASKABLE) == 0)
+		return mask ? ENOTSUP : EOK;
+
+	reg = fun->msi_cap + ((ctl & PCI_MSI_CONTROL_64BIT) != 0 ?
+	    PCI_MSI_MASK_64 : PCI_MSI_MASK_32);
+	bits = pci_conf_read_32(fun, reg);
+	if (mask)
+		bits |= UINT32_C(1) << i;
+	else
+		bits &= ~(UINT32_C(1) << i);
+	pci_conf_write_32(fun, reg, bits);
+	return EOK;
+}
+
+/**
+ * @}
+ */
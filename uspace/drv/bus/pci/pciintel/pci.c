@@ -58,6 +58,7 @@
 #include <pci_dev_iface.h>
 
 #include "ctl.h"
+#include "msi.h"
 #include "pci.h"
 #include "pci_regs.h"
 
@@ -116,6 +117,9 @@ static errno_t pciintel_enable_interrupt(ddf_fun_t *fnode, int irq)
 {
 	pci_fun_t *fun = pci_fun(fnode);
 
+	if (pci_msi_owns_interrupt(fun, irq))
+		return pci_msi_mask(fun, irq, false);
+
 	if (!pciintel_fun_owns_interrupt(fun, irq))
 		return EINVAL;
 
@@ -126,6 +130,9 @@ static errno_t pciintel_disable_interrupt(ddf_fun_t *fnode, int irq)
 {
 	pci_fun_t *fun = pci_fun(fnode);
 
+	if (pci_msi_owns_interrupt(fun, irq))
+		return pci_msi_mask(fun, irq, true);
+
 	if (!pciintel_fun_owns_interrupt(fun, irq))
 		return EINVAL;
 
@@ -136,12 +143,26 @@ static errno_t pciintel_clear_interrupt(ddf_fun_t *fnode, int irq)
 {
 	pci_fun_t *fun = pci_fun(fnode);
 
+	/* Message signalled interrupts are acknowledged by the kernel. */
+	if (pci_msi_owns_interrupt(fun, irq))
+		return EOK;
+
 	if (!pciintel_fun_owns_interrupt(fun, irq))
 		return EINVAL;
 
 	return irc_clear_interrupt(irq);
 }
 
+static errno_t pciintel_msi_setup(ddf_fun_t *fnode, size_t *count, int *irq)
+{
+	return pci_msi_setup(pci_fun(fnode), count, irq);
+}
+
+static errno_t pciintel_msi_release(ddf_fun_t *fnode)
+{
+	return pci_msi_release(pci_fun(fnode));
+}
+
 static pio_window_t *pciintel_get_pio_window(ddf_fun_t *fnode)
 {
 	pci_fun_t *fun = pci_fun(fnode);
@@ -210,6 +231,8 @@ static hw_res_ops_t pciintel_hw_res_ops = {
 	.enable_interrupt = &pciintel_enable_interrupt,
 	.disable_interrupt = &pciintel_disable_interrupt,
 	.clear_interrupt = &pciintel_clear_interrupt,
+	.msi_setup = &pciintel_msi_setup,
+	.msi_release = &pciintel_msi_release,
 };
 
 static pio_window_ops_t pciintel_pio_window_ops = {
@@ -690,6 +713,8 @@ errno_t pci_bus_scan(pci_bus_t *bus, int bus_num)
 			pci_alloc_resource_list(fun);
 			pci_read_bars(fun);
 			pci_read_interrupt(fun);
+			if (header_type != PCI_HEADER_TYPE_CARDBUS)
+				pci_read_caps(fun);
 
 			/* Propagate the PIO window to the function. */
 			fun->pio_window = bus->pio_win;
@@ -40,6 +40,8 @@
 #include <ddi.h>
 #include <ddf/driver.h>
 #include <fibril_synch.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 #define PCI_MAX_HW_RES 10
 
@@ -74,6 +76,19 @@ typedef struct pci_fun_data {
 	hw_resource_list_t hw_resources;
 	hw_resource_t resources[PCI_MAX_HW_RES];
 	pio_window_t pio_window;
+
+	/** Offset of the MSI capability or zero if there is none */
+	uint8_t msi_cap;
+	/** Offset of the MSI-X capability or zero if there is none */
+	uint8_t msix_cap;
+	/** IRQ number of the first allocated message signalled vector */
+	int msi_irq;
+	/** Number of allocated vectors, zero if using INTx */
+	size_t msi_count;
+	/** Mapped MSI-X table if MSI-X is in use */
+	ioport32_t *msix_table;
+	/** Size of the mapped MSI-X table */
+	size_t msix_table_size;
 } pci_fun_t;
 
 extern pci_bus_t *pci_bus(ddf_dev_t *);
@@ -107,6 +107,41 @@
 #define PCI_COMMAND_FAST_BACK     0x200
 #define PCI_COMMAND_INTX_DISABLE  0x400
 
+/* MSI capability */
+#define PCI_MSI_CONTROL		0x02
+#define PCI_MSI_ADDR_LO		0x04
+#define PCI_MSI_ADDR_HI		0x08
+#define PCI_MSI_DATA_32		0x08
+#define PCI_MSI_DATA_64		0x0C
+#define PCI_MSI_MASK_32		0x0C
+#define PCI_MSI_MASK_64		0x10
+
+#define PCI_MSI_CONTROL_ENABLE	0x0001
+#define PCI_MSI_CONTROL_MMC(c)	(((c) >> 1) & 0x7)
+#define PCI_MSI_CONTROL_MME(n)	(((n) & 0x7) << 4)
+#define PCI_MSI_CONTROL_MME_MASK	0x0070
+#define PCI_MSI_CONTROL_64BIT	0x0080
+#define PCI_MSI_CONTROL_MASKABLE	0x0100
+
+/* MSI-X capability */
+#define PCI_MSIX_CONTROL	0x02
+#define PCI_MSIX_TABLE		0x04
+#define PCI_MSIX_PBA		0x08
+
+#define PCI_MSIX_CONTROL_SIZE(c)	(((c) & 0x7ff) + 1)
+#define PCI_MSIX_CONTROL_FMASK	0x4000
+#define PCI_MSIX_CONTROL_ENABLE	0x8000
+#define PCI_MSIX_BIR_MASK	0x7
+
+/* MSI-X table entry (in 32-bit words) */
+#define PCI_MSIX_ENTRY_WORDS	4
+#define PCI_MSIX_ENTRY_ADDR_LO	0
+#define PCI_MSIX_ENTRY_ADDR_HI	1
+#define PCI_MSIX_ENTRY_DATA	2
+#define PCI_MSIX_ENTRY_CTL	3
+
+#define PCI_MSIX_ENTRY_CTL_MASK	0x1
+
 #endif
 
 /**
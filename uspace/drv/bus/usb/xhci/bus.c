@@ -58,6 +58,7 @@ static const bus_ops_t xhci_bus_ops = {
 	.batch_schedule = xhci_transfer_schedule,
 	.batch_create = xhci_transfer_create,
 	.batch_destroy = xhci_transfer_destroy,
+	.batch_recycle = xhci_transfer_recycle,
 };
 
 /** Initialize XHCI bus.
@@ -34,6 +34,7 @@
  */
 
 #include <errno.h>
+#include <macros.h>
 #include <str_error.h>
 #include <usb/debug.h>
 #include <usb/host/endpoint.h>
@@ -46,6 +47,28 @@
 #include "transfers.h"
 #include "trb_ring.h"
 
+/**
+ * Number of segments of the primary event ring. A bulk stream completing
+ * one event per TRB would otherwise fill a single segment between two
+ * runs of the event worker and make the HC stall on a full ring.
+ */
+#define EVENT_RING_SEGMENTS 4
+
+/**
+ * Interrupt moderation interval in 250 ns units (section 5.5.2.2). The reset
+ * default of 4000 (1 ms) adds up to a millisecond of latency to every
+ * completed transfer; 40 us still coalesces bursts of completions into one
+ * interrupt.
+ */
+#define EVENT_INTERRUPT_MODERATION 160
+
+/**
+ * Number of events handled before the ERDP is advanced. Writing the register
+ * after every event costs an uncached MMIO write each; the HC only needs to
+ * learn about the freed space before the ring runs full.
+ */
+#define EVENT_ERDP_BATCH 32
+
 /**
  * Default USB Speed ID mapping: Table 157
  */
@@ -268,7 +291,10 @@ errno_t hc_init_memory(xhci_hc_t *hc, ddf_dev_t *device)
 	if (!hc->event_worker)
 		goto err_dcbaa;
 
-	if ((err = xhci_event_ring_init(&hc->event_ring, 1)))
+	const size_t erst_max =
+	    1 << XHCI_REG_RD(hc->cap_regs, XHCI_CAP_ERST_MAX);
+	if ((err = xhci_event_ring_init(&hc->event_ring,
+	    min(EVENT_RING_SEGMENTS, erst_max))))
 		goto err_worker;
 
 	if ((err = xhci_scratchpad_alloc(hc)))
@@ -492,6 +518,7 @@ errno_t hc_start(xhci_hc_t *hc)
 
 	const uintptr_t erstba_phys = dma_buffer_phys_base(&hc->event_ring.erst);
 	XHCI_REG_WR(intr0, XHCI_INTR_ERSTBA, erstba_phys);
+	XHCI_REG_WR(intr0, XHCI_INTR_IMI, EVENT_INTERRUPT_MODERATION);
 
 	if (cap_handle_valid(hc->base.irq_handle)) {
 		XHCI_REG_SET(intr0, XHCI_INTR_IE, 1);
@@ -659,6 +686,7 @@ static void hc_run_event_ring(xhci_hc_t *hc, xhci_event_ring_t *event_ring,
     xhci_interrupter_regs_t *intr)
 {
 	errno_t err;
+	unsigned handled = 0;
 
 	xhci_trb_t trb;
 	hc->event_handler = fibril_get_id();
@@ -668,7 +696,10 @@ static void hc_run_event_ring(xhci_hc_t *hc, xhci_event_ring_t *event_ring,
 			usb_log_error("Failed to handle event in interrupt: %s", str_error(err));
 		}
 
-		XHCI_REG_WR(intr, XHCI_INTR_ERDP, hc->event_ring.dequeue_ptr);
+		if (++handled % EVENT_ERDP_BATCH == 0) {
+			XHCI_REG_WR(intr, XHCI_INTR_ERDP,
+			    hc->event_ring.dequeue_ptr);
+		}
 	}
 
 	hc->event_handler = 0;
@@ -113,6 +113,18 @@ void xhci_transfer_destroy(usb_transfer_batch_t *batch)
 	free(transfer);
 }
 
+/**
+ * Reset a finished xHCI transfer, so that the library can reuse it.
+ */
+void xhci_transfer_recycle(usb_transfer_batch_t *batch)
+{
+	xhci_transfer_t *transfer = xhci_transfer_from_batch(batch);
+
+	link_initialize(&transfer->link);
+	transfer->direction = 0;
+	transfer->interrupt_trb_phys = 0;
+}
+
 static xhci_trb_ring_t *get_ring(xhci_transfer_t *transfer)
 {
 	xhci_endpoint_t *xhci_ep = xhci_endpoint_get(transfer->batch.ep);
@@ -57,6 +57,7 @@ extern errno_t xhci_transfer_schedule(usb_transfer_batch_t *);
 
 extern errno_t xhci_handle_transfer_event(xhci_hc_t *, xhci_trb_t *);
 extern void xhci_transfer_destroy(usb_transfer_batch_t *);
+extern void xhci_transfer_recycle(usb_transfer_batch_t *);
 
 static inline xhci_transfer_t *xhci_transfer_from_batch(
     usb_transfer_batch_t *batch)
@@ -320,18 +320,20 @@ size_t xhci_trb_ring_size(xhci_trb_ring_t *ring)
 /**
  * Initializes an event ring.
  *
- * @param[in] initial_size A number of free slots on the ring, 0 leaves the
- * choice on a reasonable default (one page-sized segment).
+ * Every segment is page-sized and gets its own ERST entry, so the caller is
+ * responsible for not exceeding the ERST size supported by the HC.
+ *
+ * @param[in] segment_count A number of segments of the ring, 0 leaves the
+ * choice on a reasonable default (one segment).
  */
-errno_t xhci_event_ring_init(xhci_event_ring_t *ring, size_t initial_size)
+errno_t xhci_event_ring_init(xhci_event_ring_t *ring, size_t segment_count)
 {
 	errno_t err;
-	if (initial_size == 0)
-		initial_size = SEGMENT_TRB_COUNT;
+	if (segment_count == 0)
+		segment_count = 1;
 
 	list_initialize(&ring->segments);
 
-	size_t segment_count = (initial_size + SEGMENT_TRB_COUNT - 1) / SEGMENT_TRB_COUNT;
 	size_t erst_size = segment_count * sizeof(xhci_erst_entry_t);
 
 	if (dma_buffer_alloc(&ring->erst, erst_size)) {
@@ -51,6 +51,7 @@
 #include <gfx/coord.h>
 #include <io/pixelmap.h>
 #include <ipcgfx/server.h>
+#include <macros.h>
 #include <mem.h>
 #include <pixconv.h>
 #include <stddef.h>
@@ -74,6 +75,7 @@ typedef struct {
 	visual_t visual;
 
 	pixel2visual_t pixel2visual;
+	pixconv_row_t pixel2visual_row;
 	visual2pixel_t visual2pixel;
 	visual_mask_t visual_mask;
 	size_t pixel_bytes;
@@ -81,6 +83,9 @@ typedef struct {
 	size_t size;
 	uint8_t *addr;
 
+	/** One row of visual pixels used for filling */
+	uint8_t *row;
+
 	/** Current drawing color */
 	pixel_t color;
 } kfb_t;
@@ -188,17 +193,27 @@ static errno_t kfb_gc_fill_rect(void *arg, gfx_rect_t *rect)
 {
 	kfb_t *kfb = (kfb_t *) arg;
 	gfx_rect_t crect;
-	gfx_coord_t x, y;
+	gfx_coord_t y;
+	size_t len;
+	size_t n;
 
 	/* Make sure we have a sorted, clipped rectangle */
 	gfx_rect_clip(rect, &kfb->rect, &crect);
+	if (gfx_rect_is_empty(&crect))
+		return EOK;
 
-	for (y = crect.p0.y; y < crect.p1.y; y++) {
-		for (x = crect.p0.x; x < crect.p1.x; x++) {
-			kfb->pixel2visual(kfb->addr + FB_POS(kfb, x, y),
-			    kfb->color);
-		}
-	}
+	/*
+	 * Convert the color once and replicate it to a row in memory,
+	 * doubling the filled part in each step. Then copy the row to
+	 * the frame buffer, which we'd rather not read from.
+	 */
+	len = (crect.p1.x - crect.p0.x) * kfb->pixel_bytes;
+	kfb->pixel2visual(kfb->row, kfb->color);
+	for (n = kfb->pixel_bytes; n < len; n *= 2)
+		memcpy(kfb->row + n, kfb->row, min(n, len - n));
+
+	for (y = crect.p0.y; y < crect.p1.y; y++)
+		memcpy(kfb->addr + FB_POS(kfb, crect.p0.x, y), kfb->row, len);
 
 	return EOK;
 }
@@ -291,8 +306,11 @@ static errno_t kfb_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 	gfx_coord2_t sp;
 	gfx_coord2_t dp;
 	gfx_coord2_t pos;
+	gfx_coord_t x, x0;
+	gfx_coord_t w;
 	pixelmap_t pbm;
-	pixel_t color;
+	pixel_t *src;
+	uint8_t *dst;
 
 	/* Clip source rectangle to bitmap bounds */
 
@@ -326,43 +344,35 @@ static errno_t kfb_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 	 */
 	gfx_rect_clip(&srect, &skfbrect, &crect);
 
-	if ((kfbbm->flags & bmpf_color_key) != 0) {
-		/* Simple copy */
-		for (pos.y = crect.p0.y; pos.y < crect.p1.y; pos.y++) {
-			for (pos.x = crect.p0.x; pos.x < crect.p1.x; pos.x++) {
-				gfx_coord2_subtract(&pos, &kfbbm->rect.p0, &sp);
-				gfx_coord2_add(&pos, &offs, &dp);
-
-				color = pixelmap_get_pixel(&pbm, sp.x, sp.y);
-				if (color != kfbbm->key_color) {
-					kfb->pixel2visual(kfb->addr +
-					    FB_POS(kfb, dp.x, dp.y), color);
-				}
-			}
-		}
-	} else if ((kfbbm->flags & bmpf_colorize) != 0) {
-		/* Color key */
-		for (pos.y = crect.p0.y; pos.y < crect.p1.y; pos.y++) {
-			for (pos.x = crect.p0.x; pos.x < crect.p1.x; pos.x++) {
-				gfx_coord2_subtract(&pos, &kfbbm->rect.p0, &sp);
-				gfx_coord2_add(&pos, &offs, &dp);
-
-				color = pixelmap_get_pixel(&pbm, sp.x, sp.y);
-				kfb->pixel2visual(kfb->addr +
-				    FB_POS(kfb, dp.x, dp.y), color);
-			}
+	w = crect.p1.x - crect.p0.x;
+
+	pos.x = crect.p0.x;
+	for (pos.y = crect.p0.y; pos.y < crect.p1.y; pos.y++) {
+		gfx_coord2_subtract(&pos, &kfbbm->rect.p0, &sp);
+		gfx_coord2_add(&pos, &offs, &dp);
+
+		src = (pixel_t *) pbm.data + sp.y * pbm.width + sp.x;
+		dst = kfb->addr + FB_POS(kfb, dp.x, dp.y);
+
+		if ((kfbbm->flags & bmpf_color_key) == 0) {
+			kfb->pixel2visual_row(dst, src, w);
+			continue;
 		}
-	} else {
-		/* Color key & colorize */
-		for (pos.y = crect.p0.y; pos.y < crect.p1.y; pos.y++) {
-			for (pos.x = crect.p0.x; pos.x < crect.p1.x; pos.x++) {
-				gfx_coord2_subtract(&pos, &kfbbm->rect.p0, &sp);
-				gfx_coord2_add(&pos, &offs, &dp);
-
-				color = pixelmap_get_pixel(&pbm, sp.x, sp.y);
-				kfb->pixel2visual(kfb->addr +
-				    FB_POS(kfb, dp.x, dp.y), color);
+
+		/* Convert runs of pixels between those matching color key */
+		x = 0;
+		while (x < w) {
+			if (src[x] == kfbbm->key_color) {
+				++x;
+				continue;
 			}
+
+			x0 = x;
+			while (x < w && src[x] != kfbbm->key_color)
+				++x;
+
+			kfb->pixel2visual_row(dst + x0 * kfb->pixel_bytes,
+			    src + x0, x - x0);
 		}
 	}
 
@@ -526,66 +536,77 @@ errno_t port_init(ddf_dev_t *dev)
 	switch (visual) {
 	case VISUAL_INDIRECT_8:
 		kfb->pixel2visual = pixel2bgr_323;
+		kfb->pixel2visual_row = pixel2bgr_323_row;
 		kfb->visual2pixel = bgr_323_2pixel;
 		kfb->visual_mask = visual_mask_323;
 		kfb->pixel_bytes = 1;
 		break;
 	case VISUAL_RGB_5_5_5_LE:
 		kfb->pixel2visual = pixel2rgb_555_le;
+		kfb->pixel2visual_row = pixel2rgb_555_le_row;
 		kfb->visual2pixel = rgb_555_le_2pixel;
 		kfb->visual_mask = visual_mask_555;
 		kfb->pixel_bytes = 2;
 		break;
 	case VISUAL_RGB_5_5_5_BE:
 		kfb->pixel2visual = pixel2rgb_555_be;
+		kfb->pixel2visual_row = pixel2rgb_555_be_row;
 		kfb->visual2pixel = rgb_555_be_2pixel;
 		kfb->visual_mask = visual_mask_555;
 		kfb->pixel_bytes = 2;
 		break;
 	case VISUAL_RGB_5_6_5_LE:
 		kfb->pixel2visual = pixel2rgb_565_le;
+		kfb->pixel2visual_row = pixel2rgb_565_le_row;
 		kfb->visual2pixel = rgb_565_le_2pixel;
 		kfb->visual_mask = visual_mask_565;
 		kfb->pixel_bytes = 2;
 		break;
 	case VISUAL_RGB_5_6_5_BE:
 		kfb->pixel2visual = pixel2rgb_565_be;
+		kfb->pixel2visual_row = pixel2rgb_565_be_row;
 		kfb->visual2pixel = rgb_565_be_2pixel;
 		kfb->visual_mask = visual_mask_565;
 		kfb->pixel_bytes = 2;
 		break;
 	case VISUAL_RGB_8_8_8:
 		kfb->pixel2visual = pixel2rgb_888;
+		kfb->pixel2visual_row = pixel2rgb_888_row;
 		kfb->visual2pixel = rgb_888_2pixel;
 		kfb->visual_mask = visual_mask_888;
 		kfb->pixel_bytes = 3;
 		break;
 	case VISUAL_BGR_8_8_8:
 		kfb->pixel2visual = pixel2bgr_888;
+		kfb->pixel2visual_row = pixel2bgr_888_row;
 		kfb->visual2pixel = bgr_888_2pixel;
 		kfb->visual_mask = visual_mask_888;
 		kfb->pixel_bytes = 3;
 		break;
 	case VISUAL_RGB_8_8_8_0:
 		kfb->pixel2visual = pixel2rgb_8880;
+		kfb->pixel2visual_row = pixel2rgb_8880_row;
 		kfb->visual2pixel = rgb_8880_2pixel;
 		kfb->visual_mask = visual_mask_8880;
 		kfb->pixel_bytes = 4;
 		break;
 	case VISUAL_RGB_0_8_8_8:
 		kfb->pixel2visual = pixel2rgb_0888;
+		kfb->pixel2visual_row = pixel2rgb_0888_row;
 		kfb->visual2pixel = rgb_0888_2pixel;
 		kfb->visual_mask = visual_mask_0888;
 		kfb->pixel_bytes = 4;
 		break;
 	case VISUAL_BGR_0_8_8_8:
 		kfb->pixel2visual = pixel2bgr_0888;
+		kfb->pixel2visual_row = pixel2bgr_0888_row;
 		kfb->visual2pixel = bgr_0888_2pixel;
 		kfb->visual_mask = visual_mask_0888;
 		kfb->pixel_bytes = 4;
 		break;
 	case VISUAL_BGR_8_8_8_0:
 		kfb->pixel2visual = pixel2bgr_8880;
+		kfb->pixel2visual_row = pixel2bgr_8880_row;
 		kfb->visual2pixel = bgr_8880_2pixel;
 		kfb->visual_mask = visual_mask_8880;
 		kfb->pixel_bytes = 4;
@@ -594,6 +615,12 @@ errno_t port_init(ddf_dev_t *dev)
 		return EINVAL;
 	}
 
+	kfb->row = malloc(width * kfb->pixel_bytes);
+	if (kfb->row == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
+
 	kfb->size = scanline * height;
 	kfb->addr = AS_AREA_ANY;
 
@@ -609,6 +636,8 @@ errno_t port_init(ddf_dev_t *dev)
 
 	return EOK;
 error:
+	if (kfb != NULL)
+		free(kfb->row);
 	if (fun != NULL)
 		ddf_fun_destroy(fun);
 	return rc;
@@ -0,0 +1,964 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup virtio-gpu
+ * @{
+ */
+/** @file VIRTIO GPU driver
+ *
+ * Only the 2D command set is used. The device has no fill or blit
+ * commands: drawing goes to the guest memory backing the scanout
+ * resource and the dirty part is transferred to the host and flushed
+ * on update. The display server need not keep a back buffer of its own
+ * for this device, saving one full copy of every change.
+ */
+
+#include <align.h>
+#include <as.h>
+#include <byteorder.h>
+#include <ddev_srv.h>
+#include <ddev/info.h>
+#include <ddf/driver.h>
+#include <ddf/interrupt.h>
+#include <ddf/log.h>
+#include <errno.h>
+#include <gfx/bitmap.h>
+#include <gfx/color.h>
+#include <gfx/context.h>
+#include <gfx/coord.h>
+#include <inttypes.h>
+#include <ipcgfx/server.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "virtio-gpu.h"
+
+#define NAME	"virtio-gpu"
+
+typedef struct {
+	virtio_gpu_t *vgpu;
+	gfx_bitmap_alloc_t alloc;
+	gfx_rect_t rect;
+	gfx_bitmap_flags_t flags;
+	pixel_t key_color;
+	bool myalloc;
+} virtio_gpu_bitmap_t;
+
+static errno_t virtio_gpu_dev_add(ddf_dev_t *dev);
+
+static errno_t virtio_gpu_ddev_get_gc(void *, sysarg_t *, sysarg_t *);
+static errno_t virtio_gpu_ddev_get_info(void *, ddev_info_t *);
+
+static errno_t virtio_gpu_gc_set_clip_rect(void *, gfx_rect_t *);
+static errno_t virtio_gpu_gc_set_color(void *, gfx_color_t *);
+static errno_t virtio_gpu_gc_fill_rect(void *, gfx_rect_t *);
+static errno_t virtio_gpu_gc_update(void *);
+static errno_t virtio_gpu_gc_bitmap_create(void *, gfx_bitmap_params_t *,
+    gfx_bitmap_alloc_t *, void **);
+static errno_t virtio_gpu_gc_bitmap_destroy(void *);
+static errno_t virtio_gpu_gc_bitmap_render(void *, gfx_rect_t *,
+    gfx_coord2_t *);
+static errno_t virtio_gpu_gc_bitmap_get_alloc(void *, gfx_bitmap_alloc_t *);
+
+static driver_ops_t virtio_gpu_driver_ops = {
+	.dev_add = virtio_gpu_dev_add
+};
+
+static driver_t virtio_gpu_driver = {
+	.name = NAME,
+	.driver_ops = &virtio_gpu_driver_ops
+};
+
+static ddev_ops_t virtio_gpu_ddev_ops = {
+	.get_gc = virtio_gpu_ddev_get_gc,
+	.get_info = virtio_gpu_ddev_get_info
+};
+
+static gfx_context_ops_t virtio_gpu_gc_ops = {
+	.set_clip_rect = virtio_gpu_gc_set_clip_rect,
+	.set_color = virtio_gpu_gc_set_color,
+	.fill_rect = virtio_gpu_gc_fill_rect,
+	.update = virtio_gpu_gc_update,
+	.bitmap_create = virtio_gpu_gc_bitmap_create,
+	.bitmap_destroy = virtio_gpu_gc_bitmap_destroy,
+	.bitmap_render = virtio_gpu_gc_bitmap_render,
+	.bitmap_get_alloc = virtio_gpu_gc_bitmap_get_alloc
+};
+
+static void virtio_gpu_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+{
+	virtio_gpu_t *vgpu = (virtio_gpu_t *) ddf_dev_data_get(dev);
+	virtio_dev_t *vdev = &vgpu->virtio_dev;
+	uint16_t descno;
+	uint32_t len;
+
+	while (virtio_virtq_consume_used(vdev, VIRTIO_GPU_CONTROLQ, &descno,
+	    &len)) {
+		fibril_mutex_lock(&vgpu->done_lock);
+		vgpu->cmd_done = true;
+		fibril_condvar_signal(&vgpu->done_cv);
+		fibril_mutex_unlock(&vgpu->done_lock);
+	}
+}
+
+static errno_t virtio_gpu_register_interrupt(ddf_dev_t *dev)
+{
+	virtio_gpu_t *vgpu = (virtio_gpu_t *) ddf_dev_data_get(dev);
+	virtio_dev_t *vdev = &vgpu->virtio_dev;
+
+	async_sess_t *parent_sess = ddf_dev_parent_sess_get(dev);
+	if (parent_sess == NULL)
+		return ENOMEM;
+
+	hw_res_list_parsed_t res;
+	hw_res_list_parsed_init(&res);
+
+	errno_t rc = hw_res_get_list_parsed(parent_sess, &res, 0);
+	if (rc != EOK)
+		return rc;
+
+	if (res.irqs.count < 1) {
+		hw_res_list_parsed_clean(&res);
+		return EINVAL;
+	}
+
+	vgpu->irq = res.irqs.irqs[0];
+	hw_res_list_parsed_clean(&res);
+
+	irq_pio_range_t pio_ranges[] = {
+		{
+			.base = vdev->isr_phys,
+			.size = sizeof(vdev->isr_phys),
+		}
+	};
+
+	irq_cmd_t irq_commands[] = {
+		{
+			.cmd = CMD_PIO_READ_8,
+			.addr = (void *) vdev->isr_phys,
+			.dstarg = 2
+		},
+		{
+			.cmd = CMD_PREDICATE,
+			.value = 1,
+			.srcarg = 2
+		},
+		{
+			.cmd = CMD_ACCEPT
+		}
+	};
+
+	irq_code_t irq_code = {
+		.rangecount = sizeof(pio_ranges) / sizeof(irq_pio_range_t),
+		.ranges = pio_ranges,
+		.cmdcount = sizeof(irq_commands) / sizeof(irq_cmd_t),
+		.cmds = irq_commands
+	};
+
+	return register_interrupt_handler(dev, vgpu->irq,
+	    virtio_gpu_irq_handler, &irq_code, &vgpu->irq_handle);
+}
+
+/** Execute control command.
+ *
+ * The command is copied to the command buffer and the caller waits
+ * until the device has written the response.
+ *
+ * @param vgpu VIRTIO GPU
+ * @param cmd Command (starting with a control header)
+ * @param cmd_size Size of the command in bytes
+ * @param resp Place to store the response or @c NULL
+ * @param resp_size Size of the response in bytes
+ * @return EOK on success, EIO if the device reports an error
+ */
+static errno_t virtio_gpu_cmd(virtio_gpu_t *vgpu, void *cmd, size_t cmd_size,
+    void *resp, size_t resp_size)
+{
+	virtio_dev_t *vdev = &vgpu->virtio_dev;
+	virtio_gpu_ctrl_hdr_t *rhdr;
+	uint32_t rtype;
+
+	assert(cmd_size <= VIRTIO_GPU_CMD_BUF_SIZE);
+	assert(resp_size >= sizeof(virtio_gpu_ctrl_hdr_t));
+	assert(resp_size <= VIRTIO_GPU_CMD_BUF_SIZE);
+
+	fibril_mutex_lock(&vgpu->cmd_lock);
+
+	memcpy(vgpu->cmd_buf[0], cmd, cmd_size);
+	rhdr = (virtio_gpu_ctrl_hdr_t *) vgpu->resp_buf[0];
+	memset(rhdr, 0, sizeof(virtio_gpu_ctrl_hdr_t));
+
+	fibril_mutex_lock(&vgpu->done_lock);
+	vgpu->cmd_done = false;
+
+	virtio_virtq_desc_set(vdev, VIRTIO_GPU_CONTROLQ, 0, vgpu->cmd_buf_p[0],
+	    cmd_size, VIRTQ_DESC_F_NEXT, 1);
+	virtio_virtq_desc_set(vdev, VIRTIO_GPU_CONTROLQ, 1,
+	    vgpu->resp_buf_p[0], resp_size, VIRTQ_DESC_F_WRITE, 0);
+	virtio_virtq_add_available(vdev, VIRTIO_GPU_CONTROLQ, 0);
+	virtio_virtq_notify(vdev, VIRTIO_GPU_CONTROLQ);
+
+	while (!vgpu->cmd_done)
+		fibril_condvar_wait(&vgpu->done_cv, &vgpu->done_lock);
+	fibril_mutex_unlock(&vgpu->done_lock);
+
+	rtype = uint32_t_le2host(rhdr->type);
+	if (resp != NULL)
+		memcpy(resp, vgpu->resp_buf[0], resp_size);
+
+	fibril_mutex_unlock(&vgpu->cmd_lock);
+
+	if (rtype != VIRTIO_GPU_RESP_OK_NODATA &&
+	    rtype != VIRTIO_GPU_RESP_OK_DISPLAY_INFO) {
+		ddf_msg(LVL_ERROR, "Command 0x%x failed, response 0x%x.",
+		    (unsigned) uint32_t_le2host(((virtio_gpu_ctrl_hdr_t *)
+		    cmd)->type), (unsigned) rtype);
+		return EIO;
+	}
+
+	return EOK;
+}
+
+/** Initialize control header.
+ *
+ * @param hdr Control header
+ * @param type Command type
+ */
+static void virtio_gpu_hdr_init(virtio_gpu_ctrl_hdr_t *hdr, uint32_t type)
+{
+	memset(hdr, 0, sizeof(virtio_gpu_ctrl_hdr_t));
+	hdr->type = host2uint32_t_le(type);
+}
+
+/** Convert gfx rectangle to VIRTIO GPU rectangle.
+ *
+ * @param rect Sorted, non-negative rectangle
+ * @param vrect Place to store VIRTIO GPU rectangle
+ */
+static void virtio_gpu_rect_from_gfx(gfx_rect_t *rect,
+    virtio_gpu_rect_t *vrect)
+{
+	vrect->x = host2uint32_t_le(rect->p0.x);
+	vrect->y = host2uint32_t_le(rect->p0.y);
+	vrect->width = host2uint32_t_le(rect->p1.x - rect->p0.x);
+	vrect->height = host2uint32_t_le(rect->p1.y - rect->p0.y);
+}
+
+/** Transfer part of the frame buffer to the host.
+ *
+ * @param vgpu VIRTIO GPU
+ * @param rect Rectangle (clipped to display rectangle)
+ * @return EOK on success or an error code
+ */
+static errno_t virtio_gpu_transfer(virtio_gpu_t *vgpu, gfx_rect_t *rect)
+{
+	virtio_gpu_transfer_to_host_2d_t cmd;
+	virtio_gpu_ctrl_hdr_t resp;
+	gfx_coord2_t dims;
+
+	virtio_gpu_hdr_init(&cmd.hdr, VIRTIO_GPU_CMD_TRANSFER_TO_HOST_2D);
+	virtio_gpu_rect_from_gfx(rect, &cmd.r);
+	cmd.offset = host2uint64_t_le(rect->p0.y * vgpu->pitch +
+	    rect->p0.x * sizeof(pixel_t));
+	cmd.resource_id = host2uint32_t_le(VIRTIO_GPU_FB_RESOURCE);
+	cmd.padding = 0;
+
+	gfx_rect_dims(rect, &dims);
+	++vgpu->stats.transfers;
+	vgpu->stats.transfer_pixels += (uint64_t) dims.x * dims.y;
+
+	return virtio_gpu_cmd(vgpu, &cmd, sizeof(cmd), &resp, sizeof(resp));
+}
+
+/** Flush part of the scanout resource to the screen.
+ *
+ * @param vgpu VIRTIO GPU
+ * @param rect Rectangle (clipped to display rectangle)
+ * @return EOK on success or an error code
+ */
+static errno_t virtio_gpu_flush(virtio_gpu_t *vgpu, gfx_rect_t *rect)
+{
+	virtio_gpu_resource_flush_t cmd;
+	virtio_gpu_ctrl_hdr_t resp;
+
+	virtio_gpu_hdr_init(&cmd.hdr, VIRTIO_GPU_CMD_RESOURCE_FLUSH);
+	virtio_gpu_rect_from_gfx(rect, &cmd.r);
+	cmd.resource_id = host2uint32_t_le(VIRTIO_GPU_FB_RESOURCE);
+	cmd.padding = 0;
+
+	++vgpu->stats.flushes;
+
+	return virtio_gpu_cmd(vgpu, &cmd, sizeof(cmd), &resp, sizeof(resp));
+}
+
+/** Mark part of the frame buffer as changed.
+ *
+ * @param vgpu VIRTIO GPU
+ * @param rect Changed rectangle (clipped to display rectangle)
+ */
+static void virtio_gpu_invalidate(virtio_gpu_t *vgpu, gfx_rect_t *rect)
+{
+	gfx_region_add_rect(&vgpu->dirty, rect);
+}
+
+/** Present changed part of the frame buffer.
+ *
+ * Each dirty rectangle is transferred to the host and their envelope
+ * is flushed to the screen.
+ *
+ * @param vgpu VIRTIO GPU
+ * @return EOK on success or an error code
+ */
+static errno_t virtio_gpu_present(virtio_gpu_t *vgpu)
+{
+	gfx_rect_t env;
+	size_t i;
+	errno_t rc;
+
+	if (gfx_region_is_empty(&vgpu->dirty))
+		return EOK;
+
+	for (i = 0; i < vgpu->dirty.count; i++) {
+		rc = virtio_gpu_transfer(vgpu, &vgpu->dirty.rects[i]);
+		if (rc != EOK)
+			return rc;
+	}
+
+	gfx_region_envelope(&vgpu->dirty, &env);
+	gfx_region_init(&vgpu->dirty);
+
+	return virtio_gpu_flush(vgpu, &env);
+}
+
+static errno_t virtio_gpu_ddev_get_gc(void *arg, sysarg_t *arg2,
+    sysarg_t *arg3)
+{
+	virtio_gpu_t *vgpu = (virtio_gpu_t *) arg;
+
+	*arg2 = ddf_fun_get_handle(vgpu->fun);
+	*arg3 = 42;
+	return EOK;
+}
+
+static errno_t virtio_gpu_ddev_get_info(void *arg, ddev_info_t *info)
+{
+	virtio_gpu_t *vgpu = (virtio_gpu_t *) arg;
+
+	ddev_info_init(info);
+	info->rect = vgpu->rect;
+	info->caps = ddev_cap_fill | ddev_cap_copy | ddev_cap_buffered;
+	return EOK;
+}
+
+/** Set clipping rectangle on VIRTIO GPU.
+ *
+ * @param arg VIRTIO GPU
+ * @param rect Rectangle or @c NULL
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t virtio_gpu_gc_set_clip_rect(void *arg, gfx_rect_t *rect)
+{
+	virtio_gpu_t *vgpu = (virtio_gpu_t *) arg;
+
+	if (rect != NULL)
+		gfx_rect_clip(rect, &vgpu->rect, &vgpu->clip_rect);
+	else
+		vgpu->clip_rect = vgpu->rect;
+
+	return EOK;
+}
+
+/** Set color on VIRTIO GPU.
+ *
+ * @param arg VIRTIO GPU
+ * @param color Color
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t virtio_gpu_gc_set_color(void *arg, gfx_color_t *color)
+{
+	virtio_gpu_t *vgpu = (virtio_gpu_t *) arg;
+	uint16_t r, g, b;
+
+	gfx_color_get_rgb_i16(color, &r, &g, &b);
+	vgpu->color = PIXEL(0, r >> 8, g >> 8, b >> 8);
+	return EOK;
+}
+
+/** Fill rectangle on VIRTIO GPU.
+ *
+ * @param arg VIRTIO GPU
+ * @param rect Rectangle
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t virtio_gpu_gc_fill_rect(void *arg, gfx_rect_t *rect)
+{
+	virtio_gpu_t *vgpu = (virtio_gpu_t *) arg;
+	gfx_rect_t crect;
+	gfx_coord_t x, y;
+	pixel_t *row0;
+	size_t len;
+
+	/* Make sure we have a sorted, clipped rectangle */
+	gfx_rect_clip(rect, &vgpu->clip_rect, &crect);
+	if (gfx_rect_is_empty(&crect))
+		return EOK;
+
+	/* Fill the first row, then replicate it. */
+	len = (crect.p1.x - crect.p0.x) * sizeof(pixel_t);
+	row0 = (pixel_t *) (vgpu->fb[0] + crect.p0.y * vgpu->pitch) +
+	    crect.p0.x;
+	for (x = 0; x < crect.p1.x - crect.p0.x; x++)
+		row0[x] = vgpu->color;
+
+	for (y = crect.p0.y + 1; y < crect.p1.y; y++) {
+		memcpy((pixel_t *) (vgpu->fb[0] + y * vgpu->pitch) +
+		    crect.p0.x, row0, len);
+	}
+
+	++vgpu->stats.fill_ops;
+	vgpu->stats.fill_pixels += (uint64_t) (crect.p1.x - crect.p0.x) *
+	    (crect.p1.y - crect.p0.y);
+
+	virtio_gpu_invalidate(vgpu, &crect);
+	return EOK;
+}
+
+/** Update display on VIRTIO GPU.
+ *
+ * @param arg VIRTIO GPU
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t virtio_gpu_gc_update(void *arg)
+{
+	virtio_gpu_t *vgpu = (virtio_gpu_t *) arg;
+
+	return virtio_gpu_present(vgpu);
+}
+
+/** Create bitmap in VIRTIO GPU GC.
+ *
+ * @param arg VIRTIO GPU
+ * @param params Bitmap params
+ * @param alloc Bitmap allocation info or @c NULL
+ * @param rbm Place to store pointer to new bitmap
+ * @return EOK on success or an error code
+ */
+static errno_t virtio_gpu_gc_bitmap_create(void *arg,
+    gfx_bitmap_params_t *params, gfx_bitmap_alloc_t *alloc, void **rbm)
+{
+	virtio_gpu_t *vgpu = (virtio_gpu_t *) arg;
+	virtio_gpu_bitmap_t *vbm = NULL;
+	gfx_coord2_t dim;
+
+	/* Check that we support all required flags */
+	if ((params->flags & ~(bmpf_color_key | bmpf_colorize)) != 0)
+		return ENOTSUP;
+
+	vbm = calloc(1, sizeof(virtio_gpu_bitmap_t));
+	if (vbm == NULL)
+		return ENOMEM;
+
+	gfx_coord2_subtract(&params->rect.p1, &params->rect.p0, &dim);
+	vbm->rect = params->rect;
+	vbm->flags = params->flags;
+	vbm->key_color = params->key_color;
+
+	if (alloc == NULL) {
+		vbm->alloc.pitch = dim.x * sizeof(uint32_t);
+		vbm->alloc.off0 = 0;
+		vbm->alloc.pixels = malloc(vbm->alloc.pitch * dim.y);
+		vbm->myalloc = true;
+
+		if (vbm->alloc.pixels == NULL) {
+			free(vbm);
+			return ENOMEM;
+		}
+	} else {
+		vbm->alloc = *alloc;
+	}
+
+	vbm->vgpu = vgpu;
+	*rbm = (void *)vbm;
+	return EOK;
+}
+
+/** Destroy bitmap in VIRTIO GPU GC.
+ *
+ * @param bm Bitmap
+ * @return EOK on success or an error code
+ */
+static errno_t virtio_gpu_gc_bitmap_destroy(void *bm)
+{
+	virtio_gpu_bitmap_t *vbm = (virtio_gpu_bitmap_t *)bm;
+
+	if (vbm->myalloc)
+		free(vbm->alloc.pixels);
+	free(vbm);
+	return EOK;
+}
+
+/** Render bitmap in VIRTIO GPU GC.
+ *
+ * @param bm Bitmap
+ * @param srect0 Source rectangle or @c NULL
+ * @param offs0 Offset or @c NULL
+ * @return EOK on success or an error code
+ */
+static errno_t virtio_gpu_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
+    gfx_coord2_t *offs0)
+{
+	virtio_gpu_bitmap_t *vbm = (virtio_gpu_bitmap_t *)bm;
+	virtio_gpu_t *vgpu = vbm->vgpu;
+	gfx_rect_t srect;
+	gfx_rect_t drect;
+	gfx_rect_t sclip;
+	gfx_rect_t crect;
+	gfx_coord2_t offs;
+	gfx_coord2_t sp;
+	gfx_coord2_t dp;
+	gfx_coord2_t pos;
+	gfx_coord_t x, w;
+	pixel_t *src;
+	pixel_t *dst;
+
+	/* Clip source rectangle to bitmap bounds */
+
+	if (srect0 != NULL)
+		gfx_rect_clip(srect0, &vbm->rect, &srect);
+	else
+		srect = vbm->rect;
+
+	if (offs0 != NULL) {
+		offs = *offs0;
+	} else {
+		offs.x = 0;
+		offs.y = 0;
+	}
+
+	/*
+	 * Transform clipping rectangle back to bitmap coordinate system
+	 * and clip the source rectangle so that the destination lies
+	 * within it.
+	 */
+	gfx_rect_rtranslate(&offs, &vgpu->clip_rect, &sclip);
+	gfx_rect_clip(&srect, &sclip, &crect);
+	if (gfx_rect_is_empty(&crect))
+		return EOK;
+
+	w = crect.p1.x - crect.p0.x;
+
+	pos.x = crect.p0.x;
+	for (pos.y = crect.p0.y; pos.y < crect.p1.y; pos.y++) {
+		gfx_coord2_subtract(&pos, &vbm->rect.p0, &sp);
+		gfx_coord2_add(&pos, &offs, &dp);
+
+		src = (pixel_t *) (vbm->alloc.pixels +
+		    sp.y * vbm->alloc.pitch) + sp.x;
+		dst = (pixel_t *) (vgpu->fb[0] + dp.y * vgpu->pitch) + dp.x;
+
+		if ((vbm->flags & bmpf_color_key) == 0) {
+			memcpy(dst, src, w * sizeof(pixel_t));
+			continue;
+		}
+
+		for (x = 0; x < w; x++) {
+			if (src[x] != vbm->key_color)
+				dst[x] = src[x];
+		}
+	}
+
+	gfx_rect_translate(&offs, &crect, &drect);
+
+	++vgpu->stats.render_ops;
+	vgpu->stats.render_pixels += (uint64_t) w * (crect.p1.y - crect.p0.y);
+
+	virtio_gpu_invalidate(vgpu, &drect);
+	return EOK;
+}
+
+/** Get allocation info for bitmap in VIRTIO GPU GC.
+ *
+ * @param bm Bitmap
+ * @param alloc Place to store allocation info
+ * @return EOK on success or an error code
+ */
+static errno_t virtio_gpu_gc_bitmap_get_alloc(void *bm,
+    gfx_bitmap_alloc_t *alloc)
+{
+	virtio_gpu_bitmap_t *vbm = (virtio_gpu_bitmap_t *)bm;
+
+	*alloc = vbm->alloc;
+	return EOK;
+}
+
+static void virtio_gpu_client_conn(ipc_call_t *icall, void *arg)
+{
+	virtio_gpu_t *vgpu;
+	ddev_srv_t srv;
+	sysarg_t gc_id;
+	gfx_context_t *gc;
+	errno_t rc;
+
+	vgpu = (virtio_gpu_t *) ddf_dev_data_get(ddf_fun_get_dev(
+	    (ddf_fun_t *) arg));
+
+	gc_id = ipc_get_arg3(icall);
+
+	if (gc_id == 0) {
+		/* Set up protocol structure */
+		ddev_srv_initialize(&srv);
+		srv.ops = &virtio_gpu_ddev_ops;
+		srv.arg = vgpu;
+
+		/* Handle connection */
+		ddev_conn(icall, &srv);
+		return;
+	}
+
+	assert(gc_id == 42);
+
+	if (vgpu->gc_active) {
+		/* There already is a GC connection */
+		async_answer_0(icall, EBUSY);
+		return;
+	}
+
+	rc = gfx_context_new(&virtio_gpu_gc_ops, vgpu, &gc);
+	if (rc != EOK) {
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	vgpu->gc_active = true;
+	vgpu->clip_rect = vgpu->rect;
+
+	/* GC connection */
+	gc_conn(icall, gc);
+
+	gfx_context_delete(gc);
+	vgpu->gc_active = false;
+
+	ddf_msg(LVL_NOTE, "GC closed: %" PRIu64 " fills (%" PRIu64
+	    " pixels), %" PRIu64 " renders (%" PRIu64 " pixels), %" PRIu64
+	    " transfers (%" PRIu64 " pixels), %" PRIu64 " flushes.",
+	    vgpu->stats.fill_ops, vgpu->stats.fill_pixels,
+	    vgpu->stats.render_ops, vgpu->stats.render_pixels,
+	    vgpu->stats.transfers, vgpu->stats.transfer_pixels,
+	    vgpu->stats.flushes);
+}
+
+/** Determine the scanout to use and its dimensions.
+ *
+ * @param vgpu VIRTIO GPU
+ * @return EOK on success or an error code
+ */
+static errno_t virtio_gpu_get_display_info(virtio_gpu_t *vgpu)
+{
+	virtio_gpu_ctrl_hdr_t cmd;
+	virtio_gpu_resp_display_info_t *resp;
+	uint32_t width = VIRTIO_GPU_DEF_WIDTH;
+	uint32_t height = VIRTIO_GPU_DEF_HEIGHT;
+	unsigned i;
+	errno_t rc;
+
+	resp = calloc(1, sizeof(virtio_gpu_resp_display_info_t));
+	if (resp == NULL)
+		return ENOMEM;
+
+	virtio_gpu_hdr_init(&cmd, VIRTIO_GPU_CMD_GET_DISPLAY_INFO);
+	rc = virtio_gpu_cmd(vgpu, &cmd, sizeof(cmd), resp,
+	    sizeof(virtio_gpu_resp_display_info_t));
+	if (rc != EOK) {
+		free(resp);
+		return rc;
+	}
+
+	vgpu->scanout = 0;
+	for (i = 0; i < VIRTIO_GPU_MAX_SCANOUTS; i++) {
+		if (uint32_t_le2host(resp->pmodes[i].enabled) != 0) {
+			vgpu->scanout = i;
+			width = uint32_t_le2host(resp->pmodes[i].r.width);
+			height = uint32_t_le2host(resp->pmodes[i].r.height);
+			break;
+		}
+	}
+
+	free(resp);
+
+	vgpu->rect.p0.x = 0;
+	vgpu->rect.p0.y = 0;
+	vgpu->rect.p1.x = width;
+	vgpu->rect.p1.y = height;
+	vgpu->clip_rect = vgpu->rect;
+
+	ddf_msg(LVL_NOTE, "Using scanout %u, %ux%u.", (unsigned) vgpu->scanout,
+	    (unsigned) width, (unsigned) height);
+	return EOK;
+}
+
+/** Set up the scanout resource with guest memory backing.
+ *
+ * @param vgpu VIRTIO GPU
+ * @return EOK on success or an error code
+ */
+static errno_t virtio_gpu_scanout_init(virtio_gpu_t *vgpu)
+{
+	virtio_gpu_resource_create_2d_t create;
+	virtio_gpu_resource_attach_backing_t attach;
+	virtio_gpu_set_scanout_t scanout;
+	virtio_gpu_ctrl_hdr_t resp;
+	gfx_coord2_t dims;
+	errno_t rc;
+
+	gfx_rect_dims(&vgpu->rect, &dims);
+	vgpu->pitch = dims.x * sizeof(pixel_t);
+	vgpu->fb_size = vgpu->pitch * dims.y;
+
+	rc = virtio_setup_dma_bufs(1, ALIGN_UP(vgpu->fb_size, PAGE_SIZE),
+	    true, vgpu->fb, vgpu->fb_p);
+	if (rc != EOK)
+		return rc;
+
+	memset(vgpu->fb[0], 0, vgpu->fb_size);
+
+	virtio_gpu_hdr_init(&create.hdr, VIRTIO_GPU_CMD_RESOURCE_CREATE_2D);
+	create.resource_id = host2uint32_t_le(VIRTIO_GPU_FB_RESOURCE);
+	create.format = host2uint32_t_le(VIRTIO_GPU_FORMAT_B8G8R8X8_UNORM);
+	create.width = host2uint32_t_le(dims.x);
+	create.height = host2uint32_t_le(dims.y);
+
+	rc = virtio_gpu_cmd(vgpu, &create, sizeof(create), &resp,
+	    sizeof(resp));
+	if (rc != EOK)
+		goto error;
+
+	virtio_gpu_hdr_init(&attach.hdr,
+	    VIRTIO_GPU_CMD_RESOURCE_ATTACH_BACKING);
+	attach.resource_id = host2uint32_t_le(VIRTIO_GPU_FB_RESOURCE);
+	attach.nr_entries = host2uint32_t_le(1);
+	attach.entry.addr = host2uint64_t_le(vgpu->fb_p[0]);
+	attach.entry.length = host2uint32_t_le(vgpu->fb_size);
+	attach.entry.padding = 0;
+
+	rc = virtio_gpu_cmd(vgpu, &attach, sizeof(attach), &resp,
+	    sizeof(resp));
+	if (rc != EOK)
+		goto error;
+
+	virtio_gpu_hdr_init(&scanout.hdr, VIRTIO_GPU_CMD_SET_SCANOUT);
+	virtio_gpu_rect_from_gfx(&vgpu->rect, &scanout.r);
+	scanout.scanout_id = host2uint32_t_le(vgpu->scanout);
+	scanout.resource_id = host2uint32_t_le(VIRTIO_GPU_FB_RESOURCE);
+
+	rc = virtio_gpu_cmd(vgpu, &scanout, sizeof(scanout), &resp,
+	    sizeof(resp));
+	if (rc != EOK)
+		goto error;
+
+	/* Show the cleared screen */
+	gfx_region_init(&vgpu->dirty);
+	virtio_gpu_invalidate(vgpu, &vgpu->rect);
+	rc = virtio_gpu_present(vgpu);
+	if (rc != EOK)
+		goto error;
+
+	return EOK;
+error:
+	virtio_teardown_dma_bufs(vgpu->fb);
+	return rc;
+}
+
+static errno_t virtio_gpu_initialize(ddf_dev_t *dev)
+{
+	virtio_gpu_t *vgpu = ddf_dev_data_alloc(dev, sizeof(virtio_gpu_t));
+	if (!vgpu)
+		return ENOMEM;
+
+	fibril_mutex_initialize(&vgpu->cmd_lock);
+	fibril_mutex_initialize(&vgpu->done_lock);
+	fibril_condvar_initialize(&vgpu->done_cv);
+
+	errno_t rc = virtio_pci_dev_initialize(dev, &vgpu->virtio_dev);
+	if (rc != EOK)
+		return rc;
+
+	virtio_dev_t *vdev = &vgpu->virtio_dev;
+	virtio_pci_common_cfg_t *cfg = vgpu->virtio_dev.common_cfg;
+
+	/*
+	 * Register IRQ
+	 */
+	rc = virtio_gpu_register_interrupt(dev);
+	if (rc != EOK)
+		goto fail;
+
+	/* Reset the device and negotiate the feature bits */
+	rc = virtio_device_setup_start(vdev, 0);
+	if (rc != EOK)
+		goto fail;
+
+	/*
+	 * Discover and configure the virtqueues. We only use the control
+	 * queue, with a single request of two descriptors (command and
+	 * response) in flight.
+	 */
+	uint16_t num_queues = pio_read_le16(&cfg->num_queues);
+	if (num_queues < 1) {
+		ddf_msg(LVL_NOTE, "Unsupported number of virtqueues: %u",
+		    num_queues);
+		rc = ELIMIT;
+		goto fail;
+	}
+
+	vdev->queues = calloc(sizeof(virtq_t), num_queues);
+	if (!vdev->queues) {
+		rc = ENOMEM;
+		goto fail;
+	}
+
+	rc = virtio_virtq_setup(vdev, VIRTIO_GPU_CONTROLQ, 2);
+	if (rc != EOK)
+		goto fail;
+
+	rc = virtio_setup_dma_bufs(1, VIRTIO_GPU_CMD_BUF_SIZE, true,
+	    vgpu->cmd_buf, vgpu->cmd_buf_p);
+	if (rc != EOK)
+		goto fail;
+
+	rc = virtio_setup_dma_bufs(1, VIRTIO_GPU_CMD_BUF_SIZE, false,
+	    vgpu->resp_buf, vgpu->resp_buf_p);
+	if (rc != EOK)
+		goto fail;
+
+	/*
+	 * Enable IRQ
+	 */
+	rc = hw_res_enable_interrupt(ddf_dev_parent_sess_get(dev), vgpu->irq);
+	if (rc != EOK) {
+		ddf_msg(LVL_NOTE, "Failed to enable interrupt");
+		goto fail;
+	}
+
+	ddf_msg(LVL_NOTE, "Registered IRQ %d", vgpu->irq);
+
+	/* Go live */
+	virtio_device_setup_finalize(vdev);
+
+	rc = virtio_gpu_get_display_info(vgpu);
+	if (rc != EOK)
+		goto fail;
+
+	rc = virtio_gpu_scanout_init(vgpu);
+	if (rc != EOK)
+		goto fail;
+
+	return EOK;
+
+fail:
+	virtio_teardown_dma_bufs(vgpu->cmd_buf);
+	virtio_teardown_dma_bufs(vgpu->resp_buf);
+	virtio_device_setup_fail(vdev);
+	virtio_pci_dev_cleanup(vdev);
+	return rc;
+}
+
+static void virtio_gpu_uninitialize(ddf_dev_t *dev)
+{
+	virtio_gpu_t *vgpu = (virtio_gpu_t *) ddf_dev_data_get(dev);
+
+	virtio_device_setup_fail(&vgpu->virtio_dev);
+	virtio_teardown_dma_bufs(vgpu->fb);
+	virtio_teardown_dma_bufs(vgpu->cmd_buf);
+	virtio_teardown_dma_bufs(vgpu->resp_buf);
+	virtio_pci_dev_cleanup(&vgpu->virtio_dev);
+}
+
+static errno_t virtio_gpu_dev_add(ddf_dev_t *dev)
+{
+	virtio_gpu_t *vgpu;
+
+	ddf_msg(LVL_NOTE, "%s %s (handle = %zu)", __func__,
+	    ddf_dev_get_name(dev), ddf_dev_get_handle(dev));
+
+	errno_t rc = virtio_gpu_initialize(dev);
+	if (rc != EOK)
+		return rc;
+
+	vgpu = (virtio_gpu_t *) ddf_dev_data_get(dev);
+
+	ddf_fun_t *fun = ddf_fun_create(dev, fun_exposed, "gpu");
+	if (fun == NULL) {
+		rc = ENOMEM;
+		goto uninitialize;
+	}
+
+	vgpu->fun = fun;
+	ddf_fun_set_conn_handler(fun, virtio_gpu_client_conn);
+
+	rc = ddf_fun_bind(fun);
+	if (rc != EOK) {
+		ddf_msg(LVL_ERROR, "Failed binding device function");
+		goto destroy;
+	}
+
+	rc = ddf_fun_add_to_category(fun, "display-device");
+	if (rc != EOK) {
+		ddf_msg(LVL_ERROR, "Failed adding function to category");
+		goto unbind;
+	}
+
+	ddf_msg(LVL_NOTE, "The %s device has been successfully initialized.",
+	    ddf_dev_get_name(dev));
+
+	return EOK;
+
+unbind:
+	ddf_fun_unbind(fun);
+destroy:
+	ddf_fun_destroy(fun);
+uninitialize:
+	virtio_gpu_uninitialize(dev);
+	return rc;
+}
+
+int main(void)
+{
+	printf("%s: HelenOS virtio-gpu driver\n", NAME);
+
+	(void) ddf_log_init(NAME);
+	return ddf_driver_main(&virtio_gpu_driver);
+}
+
+/** @}
+ */
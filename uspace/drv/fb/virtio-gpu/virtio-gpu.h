@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup virtio-gpu
+ * @{
+ */
+/** @file VIRTIO GPU driver
+ */
+
+#ifndef _VIRTIO_GPU_H_
+#define _VIRTIO_GPU_H_
+
+#include <abi/cap.h>
+#include <ddf/driver.h>
+#include <fibril_synch.h>
+#include <gfx/coord.h>
+#include <gfx/region.h>
+#include <io/pixel.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <virtio-pci.h>
+
+/** Control virtqueue */
+#define VIRTIO_GPU_CONTROLQ	0
+
+/** Maximum number of scanouts */
+#define VIRTIO_GPU_MAX_SCANOUTS	16
+
+/** Size of the command and response buffers */
+#define VIRTIO_GPU_CMD_BUF_SIZE	4096
+
+/** Resource ID of the frame buffer */
+#define VIRTIO_GPU_FB_RESOURCE	1
+
+/* 2D commands */
+#define VIRTIO_GPU_CMD_GET_DISPLAY_INFO		0x0100
+#define VIRTIO_GPU_CMD_RESOURCE_CREATE_2D	0x0101
+#define VIRTIO_GPU_CMD_RESOURCE_UNREF		0x0102
+#define VIRTIO_GPU_CMD_SET_SCANOUT		0x0103
+#define VIRTIO_GPU_CMD_RESOURCE_FLUSH		0x0104
+#define VIRTIO_GPU_CMD_TRANSFER_TO_HOST_2D	0x0105
+#define VIRTIO_GPU_CMD_RESOURCE_ATTACH_BACKING	0x0106
+
+/* Responses */
+#define VIRTIO_GPU_RESP_OK_NODATA		0x1100
+#define VIRTIO_GPU_RESP_OK_DISPLAY_INFO		0x1101
+#define VIRTIO_GPU_RESP_ERR_OUT_OF_MEMORY	0x1201
+
+/** 32-bit format with bytes B, G, R, X in memory (same as pixel_t on LE) */
+#define VIRTIO_GPU_FORMAT_B8G8R8X8_UNORM	2
+
+/** Default display width if the device reports no enabled scanout */
+#define VIRTIO_GPU_DEF_WIDTH	1024
+/** Default display height if the device reports no enabled scanout */
+#define VIRTIO_GPU_DEF_HEIGHT	768
+
+/** Control header of every request and response */
+typedef struct {
+	uint32_t type;
+	uint32_t flags;
+	uint64_t fence_id;
+	uint32_t ctx_id;
+	uint8_t ring_idx;
+	uint8_t padding[3];
+} virtio_gpu_ctrl_hdr_t;
+
+typedef struct {
+	uint32_t x;
+	uint32_t y;
+	uint32_t width;
+	uint32_t height;
+} virtio_gpu_rect_t;
+
+typedef struct {
+	virtio_gpu_ctrl_hdr_t hdr;
+	struct {
+		virtio_gpu_rect_t r;
+		uint32_t enabled;
+		uint32_t flags;
+	} pmodes[VIRTIO_GPU_MAX_SCANOUTS];
+} virtio_gpu_resp_display_info_t;
+
+typedef struct {
+	virtio_gpu_ctrl_hdr_t hdr;
+	uint32_t resource_id;
+	uint32_t format;
+	uint32_t width;
+	uint32_t height;
+} virtio_gpu_resource_create_2d_t;
+
+typedef struct {
+	virtio_gpu_ctrl_hdr_t hdr;
+	virtio_gpu_rect_t r;
+	uint32_t scanout_id;
+	uint32_t resource_id;
+} virtio_gpu_set_scanout_t;
+
+typedef struct {
+	virtio_gpu_ctrl_hdr_t hdr;
+	virtio_gpu_rect_t r;
+	uint32_t resource_id;
+	uint32_t padding;
+} virtio_gpu_resource_flush_t;
+
+typedef struct {
+	virtio_gpu_ctrl_hdr_t hdr;
+	virtio_gpu_rect_t r;
+	uint64_t offset;
+	uint32_t resource_id;
+	uint32_t padding;
+} virtio_gpu_transfer_to_host_2d_t;
+
+typedef struct {
+	uint64_t addr;
+	uint32_t length;
+	uint32_t padding;
+} virtio_gpu_mem_entry_t;
+
+/** Attach backing with a single memory entry */
+typedef struct {
+	virtio_gpu_ctrl_hdr_t hdr;
+	uint32_t resource_id;
+	uint32_t nr_entries;
+	virtio_gpu_mem_entry_t entry;
+} virtio_gpu_resource_attach_backing_t;
+
+/** Device configuration */
+typedef struct {
+	uint32_t events_read;
+	uint32_t events_clear;
+	uint32_t num_scanouts;
+	uint32_t num_capsets;
+} virtio_gpu_cfg_t;
+
+/** Operation counters */
+typedef struct {
+	/** Number of rectangle fills */
+	uint64_t fill_ops;
+	/** Number of pixels filled */
+	uint64_t fill_pixels;
+	/** Number of bitmap renders */
+	uint64_t render_ops;
+	/** Number of pixels rendered */
+	uint64_t render_pixels;
+	/** Number of transfers to host */
+	uint64_t transfers;
+	/** Number of pixels transferred to host */
+	uint64_t transfer_pixels;
+	/** Number of resource flushes */
+	uint64_t flushes;
+} virtio_gpu_stats_t;
+
+typedef struct {
+	virtio_dev_t virtio_dev;
+
+	int irq;
+	cap_irq_handle_t irq_handle;
+
+	/** Exposed function */
+	ddf_fun_t *fun;
+
+	/** Command buffer (device-readable) */
+	void *cmd_buf[1];
+	uintptr_t cmd_buf_p[1];
+	/** Response buffer (device-writable) */
+	void *resp_buf[1];
+	uintptr_t resp_buf_p[1];
+
+	/** Serializes commands */
+	fibril_mutex_t cmd_lock;
+	/** Protects @c cmd_done */
+	fibril_mutex_t done_lock;
+	/** Signalled when a command is completed */
+	fibril_condvar_t done_cv;
+	/** Current command has been completed */
+	bool cmd_done;
+
+	/** Scanout to display on */
+	uint32_t scanout;
+	/** Display rectangle */
+	gfx_rect_t rect;
+	/** Clipping rectangle */
+	gfx_rect_t clip_rect;
+	/** Current drawing color */
+	pixel_t color;
+
+	/** Frame buffer (resource backing) */
+	void *fb[1];
+	uintptr_t fb_p[1];
+	/** Size of the frame buffer in bytes */
+	size_t fb_size;
+	/** Frame buffer pitch in bytes */
+	size_t pitch;
+
+	/** Region rendered to, but not transferred to host yet */
+	gfx_region_t dirty;
+	/** There is a GC connection */
+	bool gc_active;
+
+	/** Operation counters */
+	virtio_gpu_stats_t stats;
+} virtio_gpu_t;
+
+#endif
+
+/** @}
+ */
@@ -42,6 +42,7 @@
 #include <usb/hid/usages/core.h>
 #include <errno.h>
 #include <async.h>
+#include <fibril_synch.h>
 #include <stdbool.h>
 #include <str_error.h>
 #include <ipc/mouseev.h>
@@ -74,6 +75,14 @@ const char *HID_MOUSE_CATEGORY = "mouse";
 /** Default idle rate for mouses. */
 static const uint8_t IDLE_RATE = 0;
 
+/**
+ * Default interval for coalescing motion (us). A mouse polled at 1000 Hz
+ * would otherwise make the input and display servers handle a motion
+ * event each millisecond, many times more than the screen is updated.
+ * Reports arriving less often than this are forwarded without delay.
+ */
+static const usec_t MOVE_INTERVAL = 8000;
+
 static const uint8_t USB_MOUSE_BOOT_REPORT_DESCRIPTOR[] = {
 	0x05, 0x01,                    // USAGE_PAGE (Generic Desktop)
 	0x09, 0x02,                    // USAGE (Mouse)
@@ -143,6 +152,89 @@ static void default_connection_handler(ddf_fun_t *fun, ipc_call_t *icall)
 	}
 }
 
+/** Send the pending motion to the consumer.
+ *
+ * @param mouse_dev Mouse device, with @c move_lock held.
+ */
+static void usb_mouse_flush_move(usb_mouse_t *mouse_dev)
+{
+	assert(fibril_mutex_is_locked(&mouse_dev->move_lock));
+
+	if (!mouse_dev->abs_pending && mouse_dev->move_dx == 0 &&
+	    mouse_dev->move_dy == 0 && mouse_dev->move_dz == 0)
+		return;
+
+	if (mouse_dev->mouse_sess == NULL)
+		return;
+
+	async_exch_t *exch = async_exchange_begin(mouse_dev->mouse_sess);
+	if (exch == NULL)
+		return;
+
+	if (mouse_dev->abs_pending) {
+		async_msg_4(exch, MOUSEEV_ABS_MOVE_EVENT,
+		    mouse_dev->abs_x, mouse_dev->abs_y,
+		    mouse_dev->abs_max_x, mouse_dev->abs_max_y);
+	}
+
+	if (mouse_dev->move_dx || mouse_dev->move_dy || mouse_dev->move_dz) {
+		async_msg_3(exch, MOUSEEV_MOVE_EVENT, mouse_dev->move_dx,
+		    mouse_dev->move_dy, mouse_dev->move_dz);
+	}
+
+	async_exchange_end(exch);
+
+	mouse_dev->abs_pending = false;
+	mouse_dev->move_dx = 0;
+	mouse_dev->move_dy = 0;
+	mouse_dev->move_dz = 0;
+	getuptime(&mouse_dev->move_sent);
+}
+
+/** Send motion left over at the end of a coalescing interval. */
+static void usb_mouse_move_timeout(void *arg)
+{
+	usb_mouse_t *mouse_dev = (usb_mouse_t *) arg;
+
+	fibril_mutex_lock(&mouse_dev->move_lock);
+	mouse_dev->move_timer_armed = false;
+	usb_mouse_flush_move(mouse_dev);
+	fibril_mutex_unlock(&mouse_dev->move_lock);
+}
+
+/** Send the pending motion if the coalescing interval has elapsed.
+ *
+ * Otherwise arm the timer to send it at the end of the interval.
+ *
+ * @param mouse_dev Mouse device, with @c move_lock held.
+ */
+static void usb_mouse_update_move(usb_mouse_t *mouse_dev)
+{
+	struct timespec now;
+	usec_t elapsed;
+
+	getuptime(&now);
+	elapsed = NSEC2USEC(ts_sub_diff(&now, &mouse_dev->move_sent));
+
+	if (elapsed >= mouse_dev->move_interval ||
+	    mouse_dev->move_timer == NULL) {
+		usb_mouse_flush_move(mouse_dev);
+		return;
+	}
+
+	/*
+	 * An armed timer sends whatever is pending when it fires, even if
+	 * motion has been sent in between.
+	 */
+	if (mouse_dev->move_timer_armed)
+		return;
+
+	mouse_dev->move_timer_armed = true;
+	fibril_timer_set_locked(mouse_dev->move_timer,
+	    mouse_dev->move_interval - elapsed, usb_mouse_move_timeout,
+	    mouse_dev);
+}
+
 static const usb_hid_report_field_t *get_mouse_axis_move_field(uint8_t rid, usb_hid_report_t *report,
     int32_t usage)
 {
@@ -194,41 +286,36 @@ static void usb_mouse_process_report(usb_hid_dev_t *hid_dev,
 	int shift_y = move_y ? move_y->value : 0;
 	int shift_z =  wheel ?  wheel->value : 0;
 
+	fibril_mutex_lock(&mouse_dev->move_lock);
+
 	if (absolute_x && absolute_y) {
-		async_exch_t *exch =
-		    async_exchange_begin(mouse_dev->mouse_sess);
-		if (exch != NULL) {
-			async_msg_4(exch, MOUSEEV_ABS_MOVE_EVENT,
-			    shift_x, shift_y, move_x->logical_maximum, move_y->logical_maximum);
-			async_exchange_end(exch);
-		}
+		/* Only the latest position matters */
+		mouse_dev->abs_pending = true;
+		mouse_dev->abs_x = shift_x;
+		mouse_dev->abs_y = shift_y;
+		mouse_dev->abs_max_x = move_x->logical_maximum;
+		mouse_dev->abs_max_y = move_y->logical_maximum;
 
 		// Even if we move the mouse absolutely, we need to resolve wheel
 		shift_x = shift_y = 0;
 	}
 
-	if (shift_x || shift_y || shift_z) {
-		async_exch_t *exch =
-		    async_exchange_begin(mouse_dev->mouse_sess);
-		if (exch != NULL) {
-			async_msg_3(exch, MOUSEEV_MOVE_EVENT,
-			    shift_x, shift_y, shift_z);
-			async_exchange_end(exch);
-		}
-	}
+	mouse_dev->move_dx += shift_x;
+	mouse_dev->move_dy += shift_y;
+	mouse_dev->move_dz += shift_z;
 
 	/* Buttons */
 	usb_hid_report_path_t *path = usb_hid_report_path();
 	if (path == NULL) {
 		usb_log_warning("Failed to create USB HID report path.");
-		return;
+		goto out;
 	}
 	errno_t ret =
 	    usb_hid_report_path_append_item(path, USB_HIDUT_PAGE_BUTTON, 0);
 	if (ret != EOK) {
 		usb_hid_report_path_free(path);
 		usb_log_warning("Failed to add buttons to report path.");
-		return;
+		goto out;
 	}
 	usb_hid_report_path_set_report_id(path, hid_dev->report_id);
 
@@ -244,6 +331,9 @@ static void usb_mouse_process_report(usb_hid_dev_t *hid_dev,
 		assert(index < mouse_dev->buttons_count);
 
 		if (mouse_dev->buttons[index] != field->value) {
+			/* The press must not overtake preceding motion */
+			usb_mouse_flush_move(mouse_dev);
+
 			async_exch_t *exch =
 			    async_exchange_begin(mouse_dev->mouse_sess);
 			if (exch != NULL) {
@@ -261,6 +351,10 @@ static void usb_mouse_process_report(usb_hid_dev_t *hid_dev,
 	}
 
 	usb_hid_report_path_free(path);
+
+out:
+	usb_mouse_update_move(mouse_dev);
+	fibril_mutex_unlock(&mouse_dev->move_lock);
 }
 
 #define FUN_UNBIND_DESTROY(fun) \
@@ -331,6 +425,15 @@ static errno_t mouse_dev_init(usb_mouse_t *mouse_dev, usb_hid_dev_t *hid_dev)
 		return ENOMEM;
 	}
 
+	fibril_mutex_initialize(&mouse_dev->move_lock);
+	mouse_dev->move_interval = MOVE_INTERVAL;
+	getuptime(&mouse_dev->move_sent);
+
+	/* Without the timer, motion is not coalesced. */
+	mouse_dev->move_timer = fibril_timer_create(&mouse_dev->move_lock);
+	if (mouse_dev->move_timer == NULL)
+		usb_log_warning(NAME ": failed to create motion timer.");
+
 	// TODO: how to know if the device supports the request???
 	usbhid_req_set_idle(usb_device_get_default_pipe(hid_dev->usb_dev),
 	    usb_device_get_iface_number(hid_dev->usb_dev), IDLE_RATE);
@@ -420,6 +523,11 @@ void usb_mouse_deinit(usb_hid_dev_t *hid_dev, void *data)
 
 	usb_mouse_t *mouse_dev = data;
 
+	if (mouse_dev->move_timer != NULL) {
+		fibril_timer_clear(mouse_dev->move_timer);
+		fibril_timer_destroy(mouse_dev->move_timer);
+	}
+
 	/* Hangup session to the console */
 	if (mouse_dev->mouse_sess != NULL)
 		async_hangup(mouse_dev->mouse_sess);
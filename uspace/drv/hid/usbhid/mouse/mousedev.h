@@ -38,6 +38,9 @@
 
 #include <usb/dev/driver.h>
 #include <async.h>
+#include <fibril_synch.h>
+#include <stdbool.h>
+#include <time.h>
 #include "../usbhid.h"
 
 /** Container for USB mouse device. */
@@ -51,6 +54,27 @@ typedef struct {
 
 	/** DDF mouse function */
 	ddf_fun_t *mouse_fun;
+
+	/** Protects the pending motion below */
+	fibril_mutex_t move_lock;
+	/** Timer flushing motion left over at the end of an interval */
+	fibril_timer_t *move_timer;
+	/** @c true while @c move_timer is set */
+	bool move_timer_armed;
+	/** Minimum time between two motion events sent to the consumer */
+	usec_t move_interval;
+	/** Time the last motion event was sent */
+	struct timespec move_sent;
+	/** Relative motion not sent yet */
+	int move_dx;
+	int move_dy;
+	int move_dz;
+	/** Absolute position not sent yet (valid if @c abs_pending) */
+	bool abs_pending;
+	int abs_x;
+	int abs_y;
+	int abs_max_x;
+	int abs_max_y;
 } usb_mouse_t;
 
 extern const usb_endpoint_description_t usb_hid_mouse_poll_endpoint_description;
@@ -372,11 +372,27 @@ static errno_t ar9271_ieee80211_bssid_change(ieee80211_dev_t *ieee80211_dev,
 		nic_address_t bssid;
 		ieee80211_query_bssid(ieee80211_dev, &bssid);
 
+		uint16_t ht_cap;
+		uint8_t ampdu_params;
+		bool ht = ieee80211_query_ht(ieee80211_dev, &ht_cap,
+		    &ampdu_params);
+
 		htc_sta_msg_t sta_msg;
 		memset(&sta_msg, 0, sizeof(htc_sta_msg_t));
 		sta_msg.is_vif_sta = 0;
 		sta_msg.max_ampdu =
 		    host2uint16_t_be(1 << IEEE80211_MAX_AMPDU_FACTOR);
+
+		if (ht) {
+			unsigned int factor =
+			    ampdu_params & IEEE80211_HT_AMPDU_FACTOR_MASK;
+
+			sta_msg.flags = host2uint16_t_be(HTC_STA_HT);
+			sta_msg.ht_cap = host2uint16_t_be(ht_cap);
+			sta_msg.max_ampdu = host2uint16_t_be(
+			    (1 << (IEEE80211_MAX_AMPDU_FACTOR + factor)) - 1);
+		}
+
 		sta_msg.sta_index = 1;
 		sta_msg.vif_index = 0;
 		memcpy(&sta_msg.addr, bssid.address, ETH_ADDR);
@@ -393,6 +409,21 @@ static errno_t ar9271_ieee80211_bssid_change(ieee80211_dev_t *ieee80211_dev,
 		    ieee80211bg_data_rates,
 		    ARRAY_SIZE(ieee80211bg_data_rates));
 
+		/*
+		 * Rate control runs in firmware, so it only needs to know
+		 * which MCS rates the station can use.
+		 */
+		if (ht) {
+			uint32_t cap_flags = HTC_RATE_CAP_HT;
+			if (ht_cap & IEEE80211_HT_CAP_SGI_20)
+				cap_flags |= HTC_RATE_CAP_SGI;
+
+			rate_msg.cap_flags = host2uint32_t_be(cap_flags);
+			rate_msg.ht_rates_count = IEEE80211_HT_MCS_COUNT;
+			for (uint8_t i = 0; i < IEEE80211_HT_MCS_COUNT; i++)
+				rate_msg.ht_rates[i] = i;
+		}
+
 		wmi_send_command(ar9271->htc_device, WMI_RC_RATE_UPDATE,
 		    (uint8_t *) &rate_msg, sizeof(rate_msg), NULL);
 
@@ -930,6 +961,10 @@ static errno_t ar9271_add_device(ddf_dev_t *dev)
 		return rc;
 	}
 
+	ieee80211_set_ht_cap(ar9271->ieee80211_dev, AR9271_HT_CAP_INFO,
+	    AR9271_HT_AMPDU_FACTOR |
+	    (AR9271_HT_AMPDU_DENSITY << IEEE80211_HT_AMPDU_DENSITY_SHIFT));
+
 	nic_set_filtering_change_handlers(nic_get_from_ddf_dev(dev),
 	    ar9271_on_unicast_mode_change, ar9271_on_multicast_mode_change,
 	    ar9271_on_broadcast_mode_change, NULL, NULL);
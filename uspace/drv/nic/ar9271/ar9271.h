@@ -55,6 +55,15 @@
 /** Key index used for device in station mode. */
 #define AR9271_STA_KEY_INDEX  4
 
+/** HT capabilities announced by device (single spatial stream, 20 MHz). */
+#define AR9271_HT_CAP_INFO \
+	(IEEE80211_HT_CAP_SM_PS_DISABLED | IEEE80211_HT_CAP_SGI_20 | \
+	IEEE80211_HT_CAP_RX_STBC_1)
+
+/** HT A-MPDU parameters (64 KiB max length, 8 us min spacing). */
+#define AR9271_HT_AMPDU_FACTOR   3
+#define AR9271_HT_AMPDU_DENSITY  6
+
 /* HW encryption key indicator. */
 enum ath9k_key_type {
 	AR9271_KEY_TYPE_CLEAR,
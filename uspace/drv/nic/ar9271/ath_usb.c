@@ -35,7 +35,10 @@
 
 #include <usb/dev/pipes.h>
 #include <usb/debug.h>
+#include <align.h>
+#include <fibril.h>
 #include <stdlib.h>
+#include <str_error.h>
 #include <errno.h>
 #include "ath_usb.h"
 
@@ -51,6 +54,49 @@ static ath_ops_t ath_usb_ops = {
 	.read_data_message = ath_usb_read_data_message
 };
 
+/** TX fibril sending batched data frames.
+ *
+ * The data frames are sent in stream mode, which lets the device take
+ * several frames from one USB transfer. Frames queued while a transfer
+ * is in progress are sent together in the next one.
+ *
+ * @param arg Atheros USB wifi device structure.
+ *
+ * @return EOK, never returns in fact.
+ *
+ */
+static errno_t ath_usb_tx_fibril(void *arg)
+{
+	ath_usb_t *ath_usb = (ath_usb_t *) arg;
+
+	fibril_mutex_lock(&ath_usb->tx_lock);
+
+	while (true) {
+		while (ath_usb->tx_length == 0)
+			fibril_condvar_wait(&ath_usb->tx_cv, &ath_usb->tx_lock);
+
+		void *buffer = ath_usb->tx_buffer[ath_usb->tx_fill];
+		size_t length = ath_usb->tx_length;
+
+		ath_usb->tx_fill ^= 1;
+		ath_usb->tx_length = 0;
+		ath_usb->tx_frames = 0;
+		fibril_condvar_broadcast(&ath_usb->tx_cv);
+
+		fibril_mutex_unlock(&ath_usb->tx_lock);
+
+		errno_t rc = usb_pipe_write_dma(ath_usb->output_data_pipe,
+		    buffer, buffer, length);
+		if (rc != EOK)
+			usb_log_warning("Failed to send TX stream: %s.",
+			    str_error(rc));
+
+		fibril_mutex_lock(&ath_usb->tx_lock);
+	}
+
+	return EOK;
+}
+
 /** Initialize Atheros WiFi USB device.
  *
  * @param ath Generic Atheros WiFi device structure.
@@ -69,6 +115,8 @@ errno_t ath_usb_init(ath_t *ath, usb_device_t *usb_device, const usb_endpoint_de
 	}
 
 	ath_usb->usb_device = usb_device;
+	ath_usb->tx_buffer[0] = NULL;
+	ath_usb->tx_buffer[1] = NULL;
 
 	int rc;
 
@@ -89,6 +137,29 @@ errno_t ath_usb_init(ath_t *ath, usb_device_t *usb_device, const usb_endpoint_de
 
 #undef _MAP_EP
 
+	for (unsigned i = 0; i < 2; i++) {
+		ath_usb->tx_buffer[i] = usb_pipe_alloc_buffer(
+		    ath_usb->output_data_pipe, ATH_USB_TX_BUF_SIZE);
+		if (!ath_usb->tx_buffer[i]) {
+			usb_log_error("Failed to allocate TX stream buffer.");
+			rc = ENOMEM;
+			goto err_tx_buffer;
+		}
+	}
+
+	ath_usb->tx_fill = 0;
+	ath_usb->tx_length = 0;
+	ath_usb->tx_frames = 0;
+	fibril_mutex_initialize(&ath_usb->tx_lock);
+	fibril_condvar_initialize(&ath_usb->tx_cv);
+
+	fid_t tx_fibril = fibril_create(ath_usb_tx_fibril, ath_usb);
+	if (tx_fibril == 0) {
+		rc = ENOMEM;
+		goto err_tx_buffer;
+	}
+	fibril_add_ready(tx_fibril);
+
 	ath->ctrl_response_length = 64;
 	ath->data_response_length = 512;
 
@@ -96,6 +167,12 @@ errno_t ath_usb_init(ath_t *ath, usb_device_t *usb_device, const usb_endpoint_de
 	ath->ops = &ath_usb_ops;
 
 	return EOK;
+err_tx_buffer:
+	for (unsigned i = 0; i < 2; i++) {
+		if (ath_usb->tx_buffer[i])
+			usb_pipe_free_buffer(ath_usb->output_data_pipe,
+			    ath_usb->tx_buffer[i]);
+	}
 err_ath_usb:
 	free(ath_usb);
 	return rc;
@@ -140,30 +217,50 @@ static errno_t ath_usb_read_ctrl_message(ath_t *ath, void *buffer,
  * @param buffer      Buffer with data to send.
  * @param buffer_size Buffer size.
  *
+ * The message is queued in the TX stream buffer and sent by the TX
+ * fibril, possibly batched with other messages.
+ *
  * @return EOK if succeed, error code otherwise.
  *
  */
 static errno_t ath_usb_send_data_message(ath_t *ath, void *buffer,
     size_t buffer_size)
 {
-	size_t complete_buffer_size = buffer_size +
-	    sizeof(ath_usb_data_header_t);
-	void *complete_buffer = malloc(complete_buffer_size);
-	memcpy(complete_buffer + sizeof(ath_usb_data_header_t),
-	    buffer, buffer_size);
+	ath_usb_t *ath_usb = (ath_usb_t *) ath->specific_data;
+
+	size_t frame_size = buffer_size + sizeof(ath_usb_data_header_t);
+	if (frame_size > ATH_USB_TX_BUF_SIZE)
+		return EINVAL;
+
+	fibril_mutex_lock(&ath_usb->tx_lock);
+
+	/* Frames in the stream start at 4 byte boundaries. */
+	size_t offset;
+	while (true) {
+		offset = ALIGN_UP(ath_usb->tx_length, 4);
+		if (ath_usb->tx_frames < ATH_USB_TX_MAX_FRAMES &&
+		    offset + frame_size <= ATH_USB_TX_BUF_SIZE)
+			break;
+		fibril_condvar_wait(&ath_usb->tx_cv, &ath_usb->tx_lock);
+	}
+
+	void *start = ath_usb->tx_buffer[ath_usb->tx_fill];
+	memset(start + ath_usb->tx_length, 0, offset - ath_usb->tx_length);
 
 	ath_usb_data_header_t *data_header =
-	    (ath_usb_data_header_t *) complete_buffer;
+	    (ath_usb_data_header_t *) (start + offset);
 	data_header->length = host2uint16_t_le(buffer_size);
 	data_header->tag = host2uint16_t_le(TX_TAG);
+	memcpy(start + offset + sizeof(ath_usb_data_header_t), buffer,
+	    buffer_size);
 
-	ath_usb_t *ath_usb = (ath_usb_t *) ath->specific_data;
-	const errno_t ret_val = usb_pipe_write(ath_usb->output_data_pipe,
-	    complete_buffer, complete_buffer_size);
+	ath_usb->tx_length = offset + frame_size;
+	ath_usb->tx_frames++;
+	fibril_condvar_broadcast(&ath_usb->tx_cv);
 
-	free(complete_buffer);
+	fibril_mutex_unlock(&ath_usb->tx_lock);
 
-	return ret_val;
+	return EOK;
 }
 
 /** Read data message.
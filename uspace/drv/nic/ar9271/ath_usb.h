@@ -35,12 +35,19 @@
 #ifndef ATHEROS_ATH_USB_H
 #define ATHEROS_ATH_USB_H
 
+#include <fibril_synch.h>
 #include <usb/dev/driver.h>
 #include "ath.h"
 
 #define RX_TAG  0x4e00
 #define TX_TAG  0x697e
 
+/** Size of one TX stream transfer. */
+#define ATH_USB_TX_BUF_SIZE  32768
+
+/** Maximum number of frames batched in one TX stream transfer. */
+#define ATH_USB_TX_MAX_FRAMES  20
+
 /** Atheros USB wifi device structure */
 typedef struct {
 	/** USB pipes indexes */
@@ -51,6 +58,22 @@ typedef struct {
 
 	/** Pointer to connected USB device. */
 	usb_device_t *usb_device;
+
+	/**
+	 * TX stream buffers. Frames are batched in one of them while
+	 * the other one is being sent by the TX fibril.
+	 */
+	void *tx_buffer[2];
+	/** Index of the TX stream buffer being filled. */
+	unsigned tx_fill;
+	/** Used length of the TX stream buffer being filled. */
+	size_t tx_length;
+	/** Number of frames in the TX stream buffer being filled. */
+	unsigned tx_frames;
+	/** Guard of the TX stream buffers. */
+	fibril_mutex_t tx_lock;
+	/** Signals frames to send or free space in the TX stream buffer. */
+	fibril_condvar_t tx_cv;
 } ath_usb_t;
 
 typedef struct {
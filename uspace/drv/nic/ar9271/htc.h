@@ -227,6 +227,26 @@ typedef struct {
 	uint8_t pad;
 } __attribute__((packed)) htc_vif_msg_t;
 
+/** HTC station flags.
+ *
+ */
+typedef enum {
+	HTC_STA_AUTH = 0x0001,
+	HTC_STA_QOS = 0x0002,
+	HTC_STA_ERP = 0x0004,
+	HTC_STA_HT = 0x0008
+} htc_sta_flags_t;
+
+/** HTC rate control capability flags.
+ *
+ */
+typedef enum {
+	HTC_RATE_CAP_DS = 0x01,
+	HTC_RATE_CAP_40 = 0x02,
+	HTC_RATE_CAP_SGI = 0x04,
+	HTC_RATE_CAP_HT = 0x08
+} htc_rate_cap_flags_t;
+
 /** HTC new station message.
  *
  */
@@ -261,7 +281,8 @@ typedef struct {
 	uint32_t cap_flags;  /**< Big Endian value! */
 	uint8_t legacy_rates_count;
 	uint8_t legacy_rates[HTC_RATES_MAX_LENGTH];
-	uint16_t pad;
+	uint8_t ht_rates_count;
+	uint8_t ht_rates[HTC_RATES_MAX_LENGTH];
 } htc_rate_msg_t;
 
 /** HTC RX status structure used in incoming HTC data messages.
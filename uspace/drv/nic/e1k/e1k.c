@@ -38,6 +38,7 @@
 #include <errno.h>
 #include <adt/list.h>
 #include <align.h>
+#include <time.h>
 #include <byteorder.h>
 #include <as.h>
 #include <ddi.h>
@@ -54,6 +55,18 @@
 
 #define E1000_DEFAULT_INTERRUPT_INTERVAL_USEC  250
 
+/** Length of the window the receive rate is sampled over */
+#define E1000_ITR_SAMPLE_USEC  10000
+
+/** Interrupt intervals chosen by the adaptive interrupt moderation */
+#define E1000_ITR_LOWEST_LATENCY_USEC  14
+#define E1000_ITR_LOW_LATENCY_USEC     50
+#define E1000_ITR_BULK_USEC            E1000_DEFAULT_INTERRUPT_INTERVAL_USEC
+
+/** Receive rates (frames per second) separating the intervals above */
+#define E1000_ITR_LOW_LATENCY_RATE  2000
+#define E1000_ITR_BULK_RATE         20000
+
 /* Must be power of 8 */
 #define E1000_RX_FRAME_COUNT  128
 #define E1000_TX_FRAME_COUNT  128
@@ -113,6 +126,19 @@
 #define E1000_REG_WRITE(e1000, reg, value) \
 	(pio_write_32(E1000_REG_ADDR(e1000, reg), value))
 
+/** E1000 receive queue */
+typedef struct {
+	/** Physical rx ring address */
+	uintptr_t ring_phys;
+	/** Virtual rx ring address */
+	void *ring_virt;
+
+	/** Ring of RX frames, physical address */
+	uintptr_t *frame_phys;
+	/** Ring of RX frames, virtual address */
+	void **frame_virt;
+} e1000_rx_queue_t;
+
 /** E1000 device data */
 typedef struct {
 	/** DDF device */
@@ -137,15 +163,12 @@ typedef struct {
 	/** Ring of TX frames, virtual address */
 	void **tx_frame_virt;
 
-	/** Physical rx ring address */
-	uintptr_t rx_ring_phys;
-	/** Virtual rx ring address */
-	void *rx_ring_virt;
-
-	/** Ring of RX frames, physical address */
-	uintptr_t *rx_frame_phys;
-	/** Ring of RX frames, virtual address */
-	void **rx_frame_virt;
+	/** Receive queues */
+	e1000_rx_queue_t rxq[E1000_RX_QUEUES_MAX];
+	/** Number of receive queues, more than one use extended descriptors */
+	unsigned int rx_queues;
+	/** Receive-side scaling configuration, locked by rx_lock */
+	nic_rss_t rss;
 
 	/** VLAN tag */
 	uint16_t vlan_tag;
@@ -162,6 +185,18 @@ typedef struct {
 	/** The irq assigned */
 	int irq;
 
+	/** Interrupt interval follows the receive rate (no poll mode was set) */
+	bool itr_adaptive;
+
+	/** Current interrupt interval in microseconds */
+	usec_t itr_usec;
+
+	/** Frames received since the start of the sampling window */
+	unsigned int itr_frames;
+
+	/** Start of the sampling window */
+	struct timespec itr_stamp;
+
 	/** Lock for CTRL register */
 	fibril_mutex_t ctrl_lock;
 
@@ -235,6 +270,7 @@ static driver_t e1000_driver = {
 static errno_t e1000_on_activating(nic_t *);
 static errno_t e1000_on_stopping(nic_t *);
 static void e1000_send_frame(nic_t *, void *, size_t);
+static void e1000_send_frame_csum(nic_t *, void *, size_t, const nic_csum_t *);
 
 /** PIO ranges used in the IRQ code. */
 irq_pio_range_t e1000_irq_pio_ranges[] = {
@@ -1088,20 +1124,21 @@ static errno_t e1000_vlan_set_tag(ddf_fun_t *fun, uint16_t tag, bool add,
 
 /** Fill receive descriptor with new empty buffer
  *
- * Store frame in e1000->rx_frame_phys
+ * Store frame in the rx frame ring of the queue. The same write prepares
+ * both a legacy and an extended descriptor.
  *
- * @param nic    NIC data stricture
+ * @param e1000  E1000 data
+ * @param rxq    Receive queue
  * @param offset Receive descriptor offset
  *
  */
-static void e1000_fill_new_rx_descriptor(nic_t *nic, size_t offset)
+static void e1000_fill_new_rx_descriptor(e1000_t *e1000,
+    e1000_rx_queue_t *rxq, size_t offset)
 {
-	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
-
 	e1000_rx_descriptor_t *rx_descriptor = (e1000_rx_descriptor_t *)
-	    (e1000->rx_ring_virt + offset * sizeof(e1000_rx_descriptor_t));
+	    (rxq->ring_virt + offset * sizeof(e1000_rx_descriptor_t));
 
-	rx_descriptor->phys_addr = PTR_TO_U64(e1000->rx_frame_phys[offset]);
+	rx_descriptor->phys_addr = PTR_TO_U64(rxq->frame_phys[offset]);
 	rx_descriptor->length = 0;
 	rx_descriptor->checksum = 0;
 	rx_descriptor->status = 0;
@@ -1109,22 +1146,27 @@ static void e1000_fill_new_rx_descriptor(nic_t *nic, size_t offset)
 	rx_descriptor->special = 0;
 }
 
-/** Clear receive descriptor
+/** Check whether the device has written back a receive descriptor
  *
- * @param e1000  E1000 data
- * @param offset Receive descriptor offset
+ * @param e1000      E1000 data
+ * @param descriptor Receive descriptor
+ * @param[out] length Length of the received data
+ *
+ * @return True if the descriptor holds a received frame
  *
  */
-static void e1000_clear_rx_descriptor(e1000_t *e1000, unsigned int offset)
+static bool e1000_rx_descriptor_done(e1000_t *e1000, void *descriptor,
+    uint32_t *length)
 {
-	e1000_rx_descriptor_t *rx_descriptor = (e1000_rx_descriptor_t *)
-	    (e1000->rx_ring_virt + offset * sizeof(e1000_rx_descriptor_t));
+	if (e1000->rx_queues > 1) {
+		e1000_rx_ext_descriptor_t *ext = descriptor;
+		*length = ext->length;
+		return (ext->status_error & 0x01) != 0;
+	}
 
-	rx_descriptor->length = 0;
-	rx_descriptor->checksum = 0;
-	rx_descriptor->status = 0;
-	rx_descriptor->errors = 0;
-	rx_descriptor->special = 0;
+	e1000_rx_descriptor_t *legacy = descriptor;
+	*length = legacy->length;
+	return (legacy->status & 0x01) != 0;
 }
 
 /** Clear receive descriptor
@@ -1165,42 +1207,110 @@ static uint32_t e1000_inc_tail(uint32_t tail, uint32_t descriptors_count)
 		return tail + 1;
 }
 
-/** Receive frames
+/** Receive frames from one receive queue
  *
  * @param nic NIC data
+ * @param n   Receive queue number
  *
  */
-static void e1000_receive_frames(nic_t *nic)
+static void e1000_receive_queue(nic_t *nic, unsigned int n)
 {
 	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
+	e1000_rx_queue_t *rxq = &e1000->rxq[n];
+	uint32_t length;
 
-	fibril_mutex_lock(&e1000->rx_lock);
-
-	uint32_t *tail_addr = E1000_REG_ADDR(e1000, E1000_RDT);
+	uint32_t *tail_addr =
+	    E1000_REG_ADDR(e1000, E1000_RXQ_REG(E1000_RDT, n));
 	uint32_t next_tail = e1000_inc_tail(*tail_addr, E1000_RX_FRAME_COUNT);
 
-	e1000_rx_descriptor_t *rx_descriptor = (e1000_rx_descriptor_t *)
-	    (e1000->rx_ring_virt + next_tail * sizeof(e1000_rx_descriptor_t));
+	void *rx_descriptor =
+	    rxq->ring_virt + next_tail * sizeof(e1000_rx_descriptor_t);
 
-	while (rx_descriptor->status & 0x01) {
-		uint32_t frame_size = rx_descriptor->length - E1000_CRC_SIZE;
+	while (e1000_rx_descriptor_done(e1000, rx_descriptor, &length)) {
+		uint32_t frame_size = length - E1000_CRC_SIZE;
 
 		nic_frame_t *frame = nic_alloc_frame(nic, frame_size);
 		if (frame != NULL) {
-			memcpy(frame->data, e1000->rx_frame_virt[next_tail], frame_size);
+			memcpy(frame->data, rxq->frame_virt[next_tail], frame_size);
 			nic_received_frame(nic, frame);
 		} else {
 			ddf_msg(LVL_ERROR, "Memory allocation failed. Frame dropped.");
 		}
 
-		e1000_fill_new_rx_descriptor(nic, next_tail);
+		e1000_fill_new_rx_descriptor(e1000, rxq, next_tail);
+		e1000->itr_frames++;
 
 		*tail_addr = e1000_inc_tail(*tail_addr, E1000_RX_FRAME_COUNT);
 		next_tail = e1000_inc_tail(*tail_addr, E1000_RX_FRAME_COUNT);
 
-		rx_descriptor = (e1000_rx_descriptor_t *)
-		    (e1000->rx_ring_virt + next_tail * sizeof(e1000_rx_descriptor_t));
+		rx_descriptor =
+		    rxq->ring_virt + next_tail * sizeof(e1000_rx_descriptor_t);
 	}
+}
+
+/** Receive frames
+ *
+ * The receiver timer interrupt is raised for all receive queues.
+ *
+ * @param nic NIC data
+ *
+ */
+static void e1000_receive_frames(nic_t *nic)
+{
+	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
+
+	fibril_mutex_lock(&e1000->rx_lock);
+
+	for (unsigned int n = 0; n < e1000->rx_queues; n++)
+		e1000_receive_queue(nic, n);
+
+	fibril_mutex_unlock(&e1000->rx_lock);
+}
+
+/** Adapt the interrupt interval to the receive rate
+ *
+ * Once per sampling window the rate of received frames is computed. Low
+ * rates get a short interval for low latency, high rates the default
+ * interval which keeps the number of interrupts down.
+ *
+ * @param e1000 E1000 data structure
+ *
+ */
+static void e1000_itr_update(e1000_t *e1000)
+{
+	struct timespec now;
+	usec_t itr_usec;
+
+	fibril_mutex_lock(&e1000->rx_lock);
+
+	if (!e1000->itr_adaptive) {
+		fibril_mutex_unlock(&e1000->rx_lock);
+		return;
+	}
+
+	getuptime(&now);
+	usec_t elapsed = NSEC2USEC(ts_sub_diff(&now, &e1000->itr_stamp));
+	if (elapsed < E1000_ITR_SAMPLE_USEC) {
+		fibril_mutex_unlock(&e1000->rx_lock);
+		return;
+	}
+
+	uint64_t rate = (uint64_t) e1000->itr_frames * 1000000 / elapsed;
+	if (rate < E1000_ITR_LOW_LATENCY_RATE)
+		itr_usec = E1000_ITR_LOWEST_LATENCY_USEC;
+	else if (rate < E1000_ITR_BULK_RATE)
+		itr_usec = E1000_ITR_LOW_LATENCY_USEC;
+	else
+		itr_usec = E1000_ITR_BULK_USEC;
+
+	if (itr_usec != e1000->itr_usec) {
+		E1000_REG_WRITE(e1000, E1000_ITR,
+		    e1000_calculate_itr_interval_from_usecs(itr_usec));
+		e1000->itr_usec = itr_usec;
+	}
+
+	e1000->itr_frames = 0;
+	e1000->itr_stamp = now;
 
 	fibril_mutex_unlock(&e1000->rx_lock);
 }
@@ -1253,7 +1363,9 @@ static void e1000_interrupt_handler(ipc_call_t *icall,
 	nic_t *nic = NIC_DATA_DEV(dev);
 	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
 
+	nic_report_interrupt(nic);
 	e1000_interrupt_handler_impl(nic, icr);
+	e1000_itr_update(e1000);
 	e1000_enable_interrupts(e1000);
 }
 
@@ -1333,6 +1445,11 @@ static errno_t e1000_poll_mode_change(nic_t *nic, nic_poll_mode_t mode,
 	e1000_t *e1000 = nic_get_specific(nic);
 	assert(e1000);
 
+	/* An explicitly set mode turns the adaptive moderation off */
+	fibril_mutex_lock(&e1000->rx_lock);
+	e1000->itr_adaptive = false;
+	fibril_mutex_unlock(&e1000->rx_lock);
+
 	switch (mode) {
 	case NIC_POLL_IMMEDIATE:
 		E1000_REG_WRITE(e1000, E1000_ITR, 0);
@@ -1354,6 +1471,68 @@ static errno_t e1000_poll_mode_change(nic_t *nic, nic_poll_mode_t mode,
 	return EOK;
 }
 
+/** Program receive-side scaling
+ *
+ * @param e1000 E1000 data structure
+ * @param rss   Receive-side scaling configuration
+ *
+ */
+static void e1000_program_rss(e1000_t *e1000, const nic_rss_t *rss)
+{
+	uint32_t mrqc = 0;
+
+	for (unsigned int i = 0; i < NIC_RSS_RETA_SIZE / 4; i++) {
+		uint32_t reta = 0;
+		for (unsigned int j = 0; j < 4; j++) {
+			if (rss->reta[4 * i + j] != 0)
+				reta |= (uint32_t) RETA_QUEUE1 << (8 * j);
+		}
+
+		E1000_REG_WRITE(e1000, E1000_RETA_ARRAY(i), reta);
+	}
+
+	for (unsigned int i = 0; i < NIC_RSS_KEY_SIZE / 4; i++) {
+		E1000_REG_WRITE(e1000, E1000_RSSRK_ARRAY(i),
+		    (uint32_t) rss->key[4 * i] |
+		    ((uint32_t) rss->key[4 * i + 1] << 8) |
+		    ((uint32_t) rss->key[4 * i + 2] << 16) |
+		    ((uint32_t) rss->key[4 * i + 3] << 24));
+	}
+
+	if (rss->hash_types & NIC_RSS_HASH_IPV4)
+		mrqc |= MRQC_IPV4;
+	if (rss->hash_types & NIC_RSS_HASH_TCP_IPV4)
+		mrqc |= MRQC_TCP_IPV4;
+	if (rss->hash_types & NIC_RSS_HASH_IPV6)
+		mrqc |= MRQC_IPV6;
+	if (rss->hash_types & NIC_RSS_HASH_TCP_IPV6)
+		mrqc |= MRQC_TCP_IPV6;
+	if (mrqc != 0)
+		mrqc |= MRQC_RSS_ENABLE;
+
+	E1000_REG_WRITE(e1000, E1000_MRQC, mrqc);
+}
+
+/** Callback for receive-side scaling configuration change
+ *
+ * @param nic NIC data
+ * @param rss New configuration
+ *
+ * @return EOK always
+ *
+ */
+static errno_t e1000_on_rss_change(nic_t *nic, const nic_rss_t *rss)
+{
+	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
+
+	fibril_mutex_lock(&e1000->rx_lock);
+	e1000->rss = *rss;
+	e1000_program_rss(e1000, rss);
+	fibril_mutex_unlock(&e1000->rx_lock);
+
+	return EOK;
+}
+
 /** Initialize receive registers
  *
  * @param e1000 E1000 data structure
@@ -1361,47 +1540,85 @@ static errno_t e1000_poll_mode_change(nic_t *nic, nic_poll_mode_t mode,
  */
 static void e1000_initialize_rx_registers(e1000_t *e1000)
 {
-	E1000_REG_WRITE(e1000, E1000_RDLEN, E1000_RX_FRAME_COUNT * 16);
-	E1000_REG_WRITE(e1000, E1000_RDH, 0);
+	for (unsigned int n = 0; n < e1000->rx_queues; n++) {
+		E1000_REG_WRITE(e1000, E1000_RXQ_REG(E1000_RDBAH, n),
+		    (uint32_t) (PTR_TO_U64(e1000->rxq[n].ring_phys) >> 32));
+		E1000_REG_WRITE(e1000, E1000_RXQ_REG(E1000_RDBAL, n),
+		    (uint32_t) PTR_TO_U64(e1000->rxq[n].ring_phys));
+		E1000_REG_WRITE(e1000, E1000_RXQ_REG(E1000_RDLEN, n),
+		    E1000_RX_FRAME_COUNT * 16);
+		E1000_REG_WRITE(e1000, E1000_RXQ_REG(E1000_RDH, n), 0);
+
+		/* It is not posible to let HW use all descriptors */
+		E1000_REG_WRITE(e1000, E1000_RXQ_REG(E1000_RDT, n),
+		    E1000_RX_FRAME_COUNT - 1);
+	}
 
-	/* It is not posible to let HW use all descriptors */
-	E1000_REG_WRITE(e1000, E1000_RDT, E1000_RX_FRAME_COUNT - 1);
+	if (e1000->rx_queues > 1) {
+		/* The hash is only computed with extended descriptors */
+		E1000_REG_WRITE(e1000, E1000_RFCTL,
+		    E1000_REG_READ(e1000, E1000_RFCTL) | RFCTL_EXTEN);
+		E1000_REG_WRITE(e1000, E1000_RXCSUM,
+		    E1000_REG_READ(e1000, E1000_RXCSUM) | RXCSUM_PCSD);
+
+		e1000_program_rss(e1000, &e1000->rss);
+	}
 
 	/* Set Broadcast Enable Bit */
 	E1000_REG_WRITE(e1000, E1000_RCTL, RCTL_BAM);
 }
 
-/** Initialize receive structure
+/** Release the rings of a receive queue
  *
- * @param nic NIC data
+ * @param rxq Receive queue
+ *
+ */
+static void e1000_rx_queue_fini(e1000_rx_queue_t *rxq)
+{
+	if (rxq->frame_virt != NULL) {
+		for (size_t i = 0; i < E1000_RX_FRAME_COUNT; i++) {
+			if (rxq->frame_virt[i] != NULL)
+				dmamem_unmap_anonymous(rxq->frame_virt[i]);
+		}
+	}
+
+	free(rxq->frame_phys);
+	free(rxq->frame_virt);
+	rxq->frame_phys = NULL;
+	rxq->frame_virt = NULL;
+
+	if (rxq->ring_virt != NULL) {
+		dmamem_unmap_anonymous(rxq->ring_virt);
+		rxq->ring_virt = NULL;
+	}
+}
+
+/** Allocate the rings of a receive queue
+ *
+ * @param e1000 E1000 data structure
+ * @param rxq   Receive queue
  *
  * @return EOK if succeed
  * @return An error code otherwise
  *
  */
-static errno_t e1000_initialize_rx_structure(nic_t *nic)
+static errno_t e1000_rx_queue_init(e1000_t *e1000, e1000_rx_queue_t *rxq)
 {
-	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
-	fibril_mutex_lock(&e1000->rx_lock);
-
-	e1000->rx_ring_virt = AS_AREA_ANY;
+	void *ring_virt = AS_AREA_ANY;
 	errno_t rc = dmamem_map_anonymous(
 	    E1000_RX_FRAME_COUNT * sizeof(e1000_rx_descriptor_t),
 	    DMAMEM_4GiB, AS_AREA_READ | AS_AREA_WRITE, 0,
-	    &e1000->rx_ring_phys, &e1000->rx_ring_virt);
+	    &rxq->ring_phys, &ring_virt);
 	if (rc != EOK)
 		return rc;
 
-	E1000_REG_WRITE(e1000, E1000_RDBAH,
-	    (uint32_t) (PTR_TO_U64(e1000->rx_ring_phys) >> 32));
-	E1000_REG_WRITE(e1000, E1000_RDBAL,
-	    (uint32_t) PTR_TO_U64(e1000->rx_ring_phys));
+	rxq->ring_virt = ring_virt;
 
-	e1000->rx_frame_phys = (uintptr_t *)
+	rxq->frame_phys = (uintptr_t *)
 	    calloc(E1000_RX_FRAME_COUNT, sizeof(uintptr_t));
-	e1000->rx_frame_virt =
+	rxq->frame_virt =
 	    calloc(E1000_RX_FRAME_COUNT, sizeof(void *));
-	if ((e1000->rx_frame_phys == NULL) || (e1000->rx_frame_virt == NULL)) {
+	if ((rxq->frame_phys == NULL) || (rxq->frame_virt == NULL)) {
 		rc = ENOMEM;
 		goto error;
 	}
@@ -1416,39 +1633,54 @@ static errno_t e1000_initialize_rx_structure(nic_t *nic)
 		if (rc != EOK)
 			goto error;
 
-		e1000->rx_frame_phys[i] = frame_phys;
-		e1000->rx_frame_virt[i] = frame_virt;
+		rxq->frame_phys[i] = frame_phys;
+		rxq->frame_virt[i] = frame_virt;
 	}
 
 	/* Write descriptor */
 	for (size_t i = 0; i < E1000_RX_FRAME_COUNT; i++)
-		e1000_fill_new_rx_descriptor(nic, i);
-
-	e1000_initialize_rx_registers(e1000);
+		e1000_fill_new_rx_descriptor(e1000, rxq, i);
 
-	fibril_mutex_unlock(&e1000->rx_lock);
 	return EOK;
 
 error:
-	for (size_t i = 0; i < E1000_RX_FRAME_COUNT; i++) {
-		if (e1000->rx_frame_virt[i] != NULL) {
-			dmamem_unmap_anonymous(e1000->rx_frame_virt[i]);
-			e1000->rx_frame_phys[i] = 0;
-			e1000->rx_frame_virt[i] = NULL;
-		}
-	}
+	e1000_rx_queue_fini(rxq);
+	return rc;
+}
+
+/** Initialize receive structure
+ *
+ * @param nic NIC data
+ *
+ * @return EOK if succeed
+ * @return An error code otherwise
+ *
+ */
+static errno_t e1000_initialize_rx_structure(nic_t *nic)
+{
+	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
+	errno_t rc = EOK;
+	unsigned int n;
+
+	fibril_mutex_lock(&e1000->rx_lock);
 
-	if (e1000->rx_frame_phys != NULL) {
-		free(e1000->rx_frame_phys);
-		e1000->rx_frame_phys = NULL;
+	for (n = 0; n < e1000->rx_queues; n++) {
+		rc = e1000_rx_queue_init(e1000, &e1000->rxq[n]);
+		if (rc != EOK)
+			break;
 	}
 
-	if (e1000->rx_frame_virt != NULL) {
-		free(e1000->rx_frame_virt);
-		e1000->rx_frame_virt = NULL;
+	if (rc != EOK) {
+		while (n > 0)
+			e1000_rx_queue_fini(&e1000->rxq[--n]);
+		fibril_mutex_unlock(&e1000->rx_lock);
+		return rc;
 	}
 
-	return rc;
+	e1000_initialize_rx_registers(e1000);
+
+	fibril_mutex_unlock(&e1000->rx_lock);
+	return EOK;
 }
 
 /** Uninitialize receive structure
@@ -1460,33 +1692,28 @@ static void e1000_uninitialize_rx_structure(nic_t *nic)
 {
 	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
 
-	/* Write descriptor */
-	for (unsigned int offset = 0; offset < E1000_RX_FRAME_COUNT; offset++) {
-		dmamem_unmap_anonymous(e1000->rx_frame_virt[offset]);
-		e1000->rx_frame_phys[offset] = 0;
-		e1000->rx_frame_virt[offset] = NULL;
-	}
-
-	free(e1000->rx_frame_virt);
-
-	e1000->rx_frame_phys = NULL;
-	e1000->rx_frame_virt = NULL;
-
-	dmamem_unmap_anonymous(e1000->rx_ring_virt);
+	for (unsigned int n = 0; n < e1000->rx_queues; n++)
+		e1000_rx_queue_fini(&e1000->rxq[n]);
 }
 
-/** Clear receive descriptor ring
+/** Clear receive descriptor rings
  *
  * @param e1000 E1000 data
  *
  */
 static void e1000_clear_rx_ring(e1000_t *e1000)
 {
-	/* Write descriptor */
-	for (unsigned int offset = 0;
-	    offset < E1000_RX_FRAME_COUNT;
-	    offset++)
-		e1000_clear_rx_descriptor(e1000, offset);
+	/*
+	 * Write descriptors anew, write-back of an extended descriptor
+	 * replaces the buffer address.
+	 */
+	for (unsigned int n = 0; n < e1000->rx_queues; n++) {
+		for (unsigned int offset = 0;
+		    offset < E1000_RX_FRAME_COUNT;
+		    offset++)
+			e1000_fill_new_rx_descriptor(e1000, &e1000->rxq[n],
+			    offset);
+	}
 }
 
 /** Initialize filters
@@ -1538,6 +1765,10 @@ static void e1000_initialize_registers(e1000_t *e1000)
 	E1000_REG_WRITE(e1000, E1000_ITR,
 	    e1000_calculate_itr_interval_from_usecs(
 	    E1000_DEFAULT_INTERRUPT_INTERVAL_USEC));
+	e1000->itr_adaptive = true;
+	e1000->itr_usec = E1000_DEFAULT_INTERRUPT_INTERVAL_USEC;
+	e1000->itr_frames = 0;
+	getuptime(&e1000->itr_stamp);
 	E1000_REG_WRITE(e1000, E1000_FCAH, 0);
 	E1000_REG_WRITE(e1000, E1000_FCAL, 0);
 	E1000_REG_WRITE(e1000, E1000_FCT, 0);
@@ -1895,9 +2126,11 @@ static e1000_t *e1000_create_dev_data(ddf_dev_t *dev)
 
 	memset(e1000, 0, sizeof(e1000_t));
 	e1000->dev = dev;
+	e1000->rx_queues = 1;
 
 	nic_set_specific(nic, e1000);
 	nic_set_send_frame_handler(nic, e1000_send_frame);
+	nic_set_send_frame_csum_handler(nic, e1000_send_frame_csum);
 	nic_set_state_change_handlers(nic, e1000_on_activating,
 	    e1000_on_down, e1000_on_stopping);
 	nic_set_filtering_change_handlers(nic,
@@ -2074,6 +2307,9 @@ static errno_t e1000_device_initialize(ddf_dev_t *dev)
 	case 0x10b9:
 		board = E1000_82572;
 		break;
+	case 0x10d3:
+		board = E1000_82574;
+		break;
 	case 0x1096:
 		board = E1000_80003ES2;
 		break;
@@ -2097,6 +2333,7 @@ static errno_t e1000_device_initialize(ddf_dev_t *dev)
 		break;
 	case E1000_82547:
 	case E1000_82572:
+	case E1000_82574:
 	case E1000_80003ES2:
 		e1000->info.eerd_start = 0x01;
 		e1000->info.eerd_done = 0x02;
@@ -2105,6 +2342,9 @@ static errno_t e1000_device_initialize(ddf_dev_t *dev)
 		break;
 	}
 
+	/* The 82574 has two receive queues and steers frames by RSS hash */
+	e1000->rx_queues = (board == E1000_82574) ? 2 : 1;
+
 	return EOK;
 }
 
@@ -2146,6 +2386,14 @@ errno_t e1000_dev_add(ddf_dev_t *dev)
 	nic_t *nic = ddf_dev_data_get(dev);
 	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
 
+	if (e1000->rx_queues > 1) {
+		nic_set_queues(nic, e1000->rx_queues, 1, NIC_RSS_HASH_IPV4 |
+		    NIC_RSS_HASH_TCP_IPV4 | NIC_RSS_HASH_IPV6 |
+		    NIC_RSS_HASH_TCP_IPV6, 0);
+		nic_set_rss_change_handler(nic, e1000_on_rss_change);
+		nic_query_rss(nic, &e1000->rss);
+	}
+
 	/* Map registers */
 	rc = e1000_pio_enable(dev);
 	if (rc != EOK)
@@ -2328,20 +2576,27 @@ static void e1000_eeprom_get_address(e1000_t *e1000,
 }
 
 /** Send frame
+ *
+ * The legacy descriptor can make the NIC insert the checksum computed
+ * from the checksum start to the end of the frame.
  *
  * @param nic    NIC driver data structure
  * @param data   Frame data
  * @param size   Frame size in bytes
- *
- * @return EOK if succeed
- * @return Error code in the case of error
+ * @param csum   Checksum to insert or NULL
  *
  */
-static void e1000_send_frame(nic_t *nic, void *data, size_t size)
+static void e1000_send_frame_common(nic_t *nic, void *data, size_t size,
+    const nic_csum_t *csum)
 {
 	assert(nic);
 
 	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
+
+	/* Checksum start and offset fields have only 8 bits */
+	if (csum != NULL && csum->start + csum->offset > UINT8_MAX)
+		return;
+
 	fibril_mutex_lock(&e1000->tx_lock);
 
 	uint32_t tdt = E1000_REG_READ(e1000, E1000_TDT);
@@ -2387,6 +2642,12 @@ static void e1000_send_frame(nic_t *nic, void *data, size_t size)
 
 	tx_descriptor_addr->checksum_start_field = 0;
 
+	if (csum != NULL) {
+		tx_descriptor_addr->checksum_offset = csum->start + csum->offset;
+		tx_descriptor_addr->checksum_start_field = csum->start;
+		tx_descriptor_addr->command |= TXDESCRIPTOR_COMMAND_IC;
+	}
+
 	tdt++;
 	if (tdt == E1000_TX_FRAME_COUNT)
 		tdt = 0;
@@ -2396,6 +2657,32 @@ static void e1000_send_frame(nic_t *nic, void *data, size_t size)
 	fibril_mutex_unlock(&e1000->tx_lock);
 }
 
+/** Send frame
+ *
+ * @param nic    NIC driver data structure
+ * @param data   Frame data
+ * @param size   Frame size in bytes
+ *
+ */
+static void e1000_send_frame(nic_t *nic, void *data, size_t size)
+{
+	e1000_send_frame_common(nic, data, size, NULL);
+}
+
+/** Send frame and let the NIC complete its checksum
+ *
+ * @param nic    NIC driver data structure
+ * @param data   Frame data
+ * @param size   Frame size in bytes
+ * @param csum   Checksum to complete
+ *
+ */
+static void e1000_send_frame_csum(nic_t *nic, void *data, size_t size,
+    const nic_csum_t *csum)
+{
+	e1000_send_frame_common(nic, data, size, csum);
+}
+
 int main(void)
 {
 	printf("%s: HelenOS E1000 network adapter driver\n", NAME);
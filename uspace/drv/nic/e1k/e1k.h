@@ -46,6 +46,14 @@
 #define E1000_RAL_ARRAY(n)   (E1000_RAL + ((n) * 8))
 #define E1000_RAH_ARRAY(n)   (E1000_RAH + ((n) * 8))
 #define E1000_VFTA_ARRAY(n)  (E1000_VFTA + (0x04 * (n)))
+#define E1000_RETA_ARRAY(n)  (E1000_RETA + (0x04 * (n)))
+#define E1000_RSSRK_ARRAY(n)  (E1000_RSSRK + (0x04 * (n)))
+
+/** Register of the n-th receive queue */
+#define E1000_RXQ_REG(reg, n)  ((reg) + ((n) * 0x100))
+
+/** Maximum number of receive queues */
+#define E1000_RX_QUEUES_MAX  2
 
 /** Receive descriptior */
 typedef struct {
@@ -63,6 +71,25 @@ typedef struct {
 	uint16_t special;
 } e1000_rx_descriptor_t;
 
+/** Extended receive descriptor, as written back
+ *
+ * The buffer address is written to the first 8 bytes, the other 8 are
+ * written as zero.
+ *
+ */
+typedef struct {
+	/** Multiple receive queues information (RSS type and queue) */
+	uint32_t mrq;
+	/** RSS hash */
+	uint32_t rss_hash;
+	/** Extended status (bits 19:0) and errors (bits 31:20) */
+	uint32_t status_error;
+	/** Length is per segment */
+	uint16_t length;
+	/** VLAN tag */
+	uint16_t vlan;
+} e1000_rx_ext_descriptor_t;
+
 /** Legacy transmit descriptior */
 typedef struct {
 	/** Buffer Address - physical */
@@ -90,6 +117,7 @@ typedef enum {
 	E1000_82546,
 	E1000_82547,
 	E1000_82572,
+	E1000_82574,
 	E1000_80003ES2
 } e1000_board_t;
 
@@ -110,6 +138,7 @@ typedef enum {
 typedef enum {
 	TXDESCRIPTOR_COMMAND_VLE = (1 << 6),   /**< VLAN frame Enable */
 	TXDESCRIPTOR_COMMAND_RS = (1 << 3),    /**< Report Status */
+	TXDESCRIPTOR_COMMAND_IC = (1 << 2),    /**< Insert Checksum */
 	TXDESCRIPTOR_COMMAND_IFCS = (1 << 1),  /**< Insert FCS */
 	TXDESCRIPTOR_COMMAND_EOP = (1 << 0)    /**< End Of Packet */
 } e1000_txdescriptor_command_t;
@@ -140,6 +169,11 @@ typedef enum {
 	E1000_RAL = 0x5400,    /**< Receive Address Low */
 	E1000_RAH = 0x5404,    /**< Receive Address High */
 	E1000_VFTA = 0x5600,   /**< VLAN Filter Table Array */
+	E1000_RXCSUM = 0x5000,  /**< Receive Checksum Control */
+	E1000_RFCTL = 0x5008,  /**< Receive Filter Control Register */
+	E1000_MRQC = 0x5818,   /**< Multiple Receive Queues Command */
+	E1000_RETA = 0x5C00,   /**< Redirection Table */
+	E1000_RSSRK = 0x5C80,  /**< RSS Random Key Register */
 	E1000_VET = 0x38,      /**< VLAN Ether Type */
 	E1000_FCAL = 0x28,     /**< Flow Control Address Low */
 	E1000_FCAH = 0x2C,     /**< Flow Control Address High */
@@ -227,6 +261,30 @@ typedef enum {
 	ICR_RXT0 = (1 << 7)   /**< Receiver Timer Interrupt */
 } e1000_icr_t;
 
+/** RXCSUM register fields */
+typedef enum {
+	RXCSUM_PCSD = (1 << 13)  /**< Packet Checksum Disable, report RSS hash */
+} e1000_rxcsum_t;
+
+/** RFCTL register fields */
+typedef enum {
+	RFCTL_EXTEN = (1 << 15)  /**< Extended Status Enable */
+} e1000_rfctl_t;
+
+/** MRQC register fields */
+typedef enum {
+	MRQC_RSS_ENABLE = (1 << 0),     /**< Receive-side scaling */
+	MRQC_TCP_IPV4 = (1 << 16),      /**< Hash TCP over IPv4 */
+	MRQC_IPV4 = (1 << 17),          /**< Hash IPv4 */
+	MRQC_IPV6 = (1 << 20),          /**< Hash IPv6 */
+	MRQC_TCP_IPV6 = (1 << 21)       /**< Hash TCP over IPv6 */
+} e1000_mrqc_t;
+
+/** Redirection table entry bits */
+typedef enum {
+	RETA_QUEUE1 = (1 << 7)  /**< The entry selects receive queue 1 */
+} e1000_reta_t;
+
 /** RAH register fields */
 typedef enum {
 	RAH_AV = (1 << 31)   /**< Address Valid */
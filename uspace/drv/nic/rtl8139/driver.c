@@ -60,6 +60,16 @@ FIBRIL_MUTEX_INITIALIZE(irq_reg_lock);
 /** PCI clock frequency in kHz */
 #define RTL8139_PCI_FREQ_KHZ  33000
 
+/** Length of the window the receive rate is sampled over */
+#define RTL8139_MODERATION_SAMPLE_USEC  10000
+
+/** Period of the timer replacing the receive interrupts */
+#define RTL8139_MODERATION_PERIOD_USEC  250
+
+/** Receive rates (frames per second) turning the moderation on and off */
+#define RTL8139_MODERATION_ON_RATE   8000
+#define RTL8139_MODERATION_OFF_RATE  2000
+
 #define RTL8139_AUTONEG_CAPS (ETH_AUTONEG_10BASE_T_HALF | \
 	ETH_AUTONEG_10BASE_T_FULL | ETH_AUTONEG_100BASE_TX_HALF | \
 	ETH_AUTONEG_100BASE_TX_FULL | ETH_AUTONEG_PAUSE_SYMETRIC)
@@ -114,6 +124,9 @@ inline static void rtl8139_unlock_all(rtl8139_t *rtl8139)
 /** Default interrupt mask */
 #define RTL_DEFAULT_INTERRUPTS UINT16_C(0xFFFF)
 
+/** Interrupt mask with the receive interrupt replaced by the timer */
+#define RTL_MODERATED_INTERRUPTS (RTL_DEFAULT_INTERRUPTS & ~INT_ROK)
+
 /** Obtain the value of the register part
  *  The bit operations will be done
  *  The _SHIFT and _MASK for the register part must exists as macros
@@ -597,6 +610,7 @@ static nic_frame_list_t *rtl8139_frame_receive(nic_t *nic_data)
 			if (frame)
 				nic_frame_list_append(frames, frame);
 		}
+		rtl8139->rx_frames++;
 
 		/* Update offset */
 		rx_offset = ALIGN_UP(rx_offset + size + RTL_FRAME_HEADER_SIZE, 4);
@@ -762,6 +776,71 @@ static int rtl8139_poll_interrupt(nic_t *nic_data)
 	return receive;
 }
 
+/** Turn the adaptive receive interrupt moderation on or off
+ *
+ *  With the moderation on the receive interrupt is masked and the received
+ *  frames are picked up by the timer interrupt every
+ *  RTL8139_MODERATION_PERIOD_USEC. The receiver lock must be held.
+ *
+ *  @param rtl8139  The card private structure
+ *  @param on       Turn the moderation on
+ */
+static void rtl8139_moderation_set(rtl8139_t *rtl8139, bool on)
+{
+	rtl8139->rx_moderated = on;
+	if (on) {
+		pio_write_32(rtl8139->io_port + TIMERINT, RTL8139_PCI_FREQ_KHZ *
+		    RTL8139_MODERATION_PERIOD_USEC / 1000);
+		pio_write_32(rtl8139->io_port + TCTR, 0);
+		rtl8139->int_mask = RTL_MODERATED_INTERRUPTS;
+	} else {
+		pio_write_32(rtl8139->io_port + TIMERINT, 0);
+		rtl8139->int_mask = RTL_DEFAULT_INTERRUPTS;
+	}
+
+	rtl8139->rx_frames = 0;
+	getuptime(&rtl8139->rx_stamp);
+}
+
+/** Adapt the receive interrupt moderation to the receive rate
+ *
+ *  The moderation is only used in the NIC_POLL_IMMEDIATE mode. It is turned
+ *  on when the receive rate sampled over RTL8139_MODERATION_SAMPLE_USEC gets
+ *  high and off when it falls low again.
+ *
+ *  @param nic_data  The driver data
+ */
+static void rtl8139_moderation_update(nic_t *nic_data)
+{
+	rtl8139_t *rtl8139 = nic_get_specific(nic_data);
+	struct timespec now;
+
+	if (nic_query_poll_mode(nic_data, 0) != NIC_POLL_IMMEDIATE)
+		return;
+
+	fibril_mutex_lock(&rtl8139->rx_lock);
+
+	getuptime(&now);
+	usec_t elapsed = NSEC2USEC(ts_sub_diff(&now, &rtl8139->rx_stamp));
+	if (elapsed < RTL8139_MODERATION_SAMPLE_USEC) {
+		fibril_mutex_unlock(&rtl8139->rx_lock);
+		return;
+	}
+
+	uint64_t rate = (uint64_t) rtl8139->rx_frames * 1000000 / elapsed;
+	if (!rtl8139->rx_moderated && rate >= RTL8139_MODERATION_ON_RATE) {
+		rtl8139_moderation_set(rtl8139, true);
+	} else if (rtl8139->rx_moderated &&
+	    rate < RTL8139_MODERATION_OFF_RATE) {
+		rtl8139_moderation_set(rtl8139, false);
+	} else {
+		rtl8139->rx_frames = 0;
+		rtl8139->rx_stamp = now;
+	}
+
+	fibril_mutex_unlock(&rtl8139->rx_lock);
+}
+
 /** Poll device according to isr status
  *
  *  The isr value must be obtained and cleared by the caller. The reason
@@ -788,6 +867,15 @@ static void rtl8139_interrupt_impl(nic_t *nic_data, uint16_t isr)
 			return;
 	}
 
+	/* The timer stands in for the receive interrupt when moderating */
+	if (poll_mode == NIC_POLL_IMMEDIATE && (isr & INT_TIME_OUT)) {
+		rtl8139_t *rtl8139 = nic_get_specific(nic_data);
+		if (rtl8139->rx_moderated) {
+			pio_write_32(rtl8139->io_port + TCTR, 0);
+			isr |= INT_ROK;
+		}
+	}
+
 	/*
 	 * Check transmittion interrupts first to allow transmit next frames
 	 * sooner
@@ -830,7 +918,9 @@ static void rtl8139_interrupt_handler(ipc_call_t *icall, ddf_dev_t *dev)
 	nic_t *nic_data = nic_get_from_ddf_dev(dev);
 	rtl8139_t *rtl8139 = nic_get_specific(nic_data);
 
+	nic_report_interrupt(nic_data);
 	rtl8139_interrupt_impl(nic_data, isr);
+	rtl8139_moderation_update(nic_data);
 
 	/* Turn the interrupts on again */
 	rtl8139_hw_int_set(rtl8139);
@@ -918,7 +1008,9 @@ static errno_t rtl8139_on_activated(nic_t *nic_data)
 	rtl8139_card_up(rtl8139);
 	rtl8139_unlock_all(rtl8139);
 
-	rtl8139->int_mask = RTL_DEFAULT_INTERRUPTS;
+	fibril_mutex_lock(&rtl8139->rx_lock);
+	rtl8139_moderation_set(rtl8139, false);
+	fibril_mutex_unlock(&rtl8139->rx_lock);
 	rtl8139_hw_int_set(rtl8139);
 
 	errno_t rc = hw_res_enable_interrupt(rtl8139->parent_sess, rtl8139->irq);
@@ -2065,6 +2157,10 @@ static errno_t rtl8139_poll_mode_change(nic_t *nic_data, nic_poll_mode_t mode,
 
 	fibril_mutex_lock(&rtl8139->rx_lock);
 
+	/* Start again without moderation */
+	if (rtl8139->rx_moderated)
+		rtl8139_moderation_set(rtl8139, false);
+
 	switch (mode) {
 	case NIC_POLL_IMMEDIATE:
 		rtl8139->int_mask = RTL_DEFAULT_INTERRUPTS;
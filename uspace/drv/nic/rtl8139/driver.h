@@ -29,8 +29,10 @@
 #ifndef RTL8139_DRIVER_H_
 #define RTL8139_DRIVER_H_
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 #include "defs.h"
 #include "general.h"
 
@@ -137,6 +139,13 @@ typedef struct rtl8139_data {
 	/** Polling mode information */
 	rtl8139_timer_act_t poll_timer;
 
+	/** Receive interrupts are replaced by the timer (adaptive moderation) */
+	bool rx_moderated;
+	/** Frames received since the start of the sampling window */
+	unsigned int rx_frames;
+	/** Start of the sampling window */
+	struct timespec rx_stamp;
+
 	/** Backward pointer to nic_data */
 	nic_t *nic_data;
 
@@ -102,7 +102,7 @@ enum rtl8169_registers {
 	RMS = 0xda, /**< Rx packet Maximum Size, 2b */
 	/* 0xdc - 0xdf reserved */
 	CCR = 0xe0, /**< C+ Command Register */
-	/* 0xe2 - 0xe3 reserved */
+	IMT = 0xe2, /**< Interrupt mitigation register, 2b */
 	RDSAR = 0xe4, /**< Receive Descriptor Start Address Register, 8b */
 	ETTHR = 0xec, /**< Early Transmit Threshold Register, 1b */
 	/* 0xed - 0xef reserved */
@@ -193,6 +193,20 @@ enum rtl8169_interrupts {
 	    INT_TOK | INT_RER | INT_ROK),
 };
 
+/** Interrupt mitigation register fields
+ *
+ *  Each field is 4 bits wide. The interrupt is delayed until the number of
+ *  frames or the timer given by the fields expires, the timer unit depends
+ *  on the link speed.
+ */
+enum rtl8169_imt {
+	IMT_RX_FRAMES_SHIFT = 0, /**< Received frames */
+	IMT_RX_TIMER_SHIFT = 4, /**< Receive timer */
+	IMT_TX_FRAMES_SHIFT = 8, /**< Transmitted frames */
+	IMT_TX_TIMER_SHIFT = 12, /**< Transmit timer */
+	IMT_FIELD_MASK = 0xf,
+};
+
 /** Transmit status descriptor registers bits */
 enum rtl8169_tsd {
 	TSD_CRS = (1 << 31), /**< Carrier Sense Lost */
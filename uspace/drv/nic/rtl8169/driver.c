@@ -52,6 +52,20 @@
 /** Global mutex for work with shared irq structure */
 FIBRIL_MUTEX_INITIALIZE(irq_reg_lock);
 
+/** Default interrupt mask */
+#define RTL8169_DEFAULT_INTERRUPTS  UINT16_C(0xFFFF)
+
+/** Length of the window the receive rate is sampled over */
+#define RTL8169_MODERATION_SAMPLE_USEC  10000
+
+/** Receive rates (frames per second) turning the moderation on and off */
+#define RTL8169_MODERATION_ON_RATE   8000
+#define RTL8169_MODERATION_OFF_RATE  2000
+
+/** Interrupt mitigation used under high receive rates */
+#define RTL8169_MODERATION_IMT \
+	((8 << IMT_RX_TIMER_SHIFT) | (8 << IMT_RX_FRAMES_SHIFT))
+
 static errno_t rtl8169_set_addr(ddf_fun_t *fun, const nic_address_t *addr);
 static errno_t rtl8169_get_device_info(ddf_fun_t *fun, nic_device_info_t *info);
 static errno_t rtl8169_get_cable_state(ddf_fun_t *fun, nic_cable_state_t *state);
@@ -74,6 +88,9 @@ static errno_t rtl8169_on_activated(nic_t *nic_data);
 static errno_t rtl8169_on_stopped(nic_t *nic_data);
 static void rtl8169_send_frame(nic_t *nic_data, void *data, size_t size);
 static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev);
+static errno_t rtl8169_poll_mode_change(nic_t *nic_data, nic_poll_mode_t mode,
+    const struct timespec *period);
+static void rtl8169_poll(nic_t *nic_data);
 static inline errno_t rtl8169_register_int_handler(nic_t *nic_data,
     cap_irq_handle_t *handle);
 static inline void rtl8169_get_hwaddr(rtl8169_t *rtl8169, nic_address_t *addr);
@@ -316,6 +333,7 @@ static rtl8169_t *rtl8169_create_dev_data(ddf_dev_t *dev)
 	nic_set_filtering_change_handlers(nic_data,
 	    rtl8169_unicast_set, rtl8169_multicast_set, rtl8169_broadcast_set,
 	    NULL, NULL);
+	nic_set_poll_handlers(nic_data, rtl8169_poll_mode_change, rtl8169_poll);
 
 	fibril_mutex_initialize(&rtl8169->rx_lock);
 	fibril_mutex_initialize(&rtl8169->tx_lock);
@@ -692,6 +710,62 @@ static void rtl8169_rx_ring_refill(rtl8169_t *rtl8169, unsigned int first,
 	}
 }
 
+/** Turn the adaptive interrupt moderation on or off
+ *
+ *  The moderation delays the receive interrupts using the interrupt
+ *  mitigation register. The receiver lock must be held.
+ *
+ *  @param rtl8169  The card private structure
+ *  @param on       Turn the moderation on
+ */
+static void rtl8169_moderation_set(rtl8169_t *rtl8169, bool on)
+{
+	rtl8169->rx_moderated = on;
+	pio_write_16(rtl8169->regs + IMT, on ? RTL8169_MODERATION_IMT : 0);
+
+	rtl8169->rx_frames = 0;
+	getuptime(&rtl8169->rx_stamp);
+}
+
+/** Adapt the interrupt moderation to the receive rate
+ *
+ *  The moderation is only used in the NIC_POLL_IMMEDIATE mode. It is turned
+ *  on when the receive rate sampled over RTL8169_MODERATION_SAMPLE_USEC gets
+ *  high and off when it falls low again.
+ *
+ *  @param nic_data  The driver data
+ */
+static void rtl8169_moderation_update(nic_t *nic_data)
+{
+	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
+	struct timespec now;
+
+	if (nic_query_poll_mode(nic_data, NULL) != NIC_POLL_IMMEDIATE)
+		return;
+
+	fibril_mutex_lock(&rtl8169->rx_lock);
+
+	getuptime(&now);
+	usec_t elapsed = NSEC2USEC(ts_sub_diff(&now, &rtl8169->rx_stamp));
+	if (elapsed < RTL8169_MODERATION_SAMPLE_USEC) {
+		fibril_mutex_unlock(&rtl8169->rx_lock);
+		return;
+	}
+
+	uint64_t rate = (uint64_t) rtl8169->rx_frames * 1000000 / elapsed;
+	if (!rtl8169->rx_moderated && rate >= RTL8169_MODERATION_ON_RATE) {
+		rtl8169_moderation_set(rtl8169, true);
+	} else if (rtl8169->rx_moderated &&
+	    rate < RTL8169_MODERATION_OFF_RATE) {
+		rtl8169_moderation_set(rtl8169, false);
+	} else {
+		rtl8169->rx_frames = 0;
+		rtl8169->rx_stamp = now;
+	}
+
+	fibril_mutex_unlock(&rtl8169->rx_lock);
+}
+
 static errno_t rtl8169_on_activated(nic_t *nic_data)
 {
 	errno_t rc;
@@ -747,7 +821,12 @@ static errno_t rtl8169_on_activated(nic_t *nic_data)
 	pio_write_32(rtl8169->regs + RCR, rcr);
 	pio_write_16(rtl8169->regs + RMS, BUFFER_SIZE);
 
-	pio_write_16(rtl8169->regs + IMR, 0xffff);
+	fibril_mutex_lock(&rtl8169->rx_lock);
+	rtl8169_moderation_set(rtl8169, false);
+	fibril_mutex_unlock(&rtl8169->rx_lock);
+
+	rtl8169->int_mask = RTL8169_DEFAULT_INTERRUPTS;
+	pio_write_16(rtl8169->regs + IMR, rtl8169->int_mask);
 	/* XXX Check return value */
 	hw_res_enable_interrupt(rtl8169->parent_sess, rtl8169->irq);
 
@@ -1017,6 +1096,7 @@ static void rtl8169_receive_done(ddf_dev_t *dev)
 			frame = nic_alloc_frame(nic_data, frame_size);
 			memcpy(frame->data, buffer, frame_size);
 			nic_frame_list_append(frames, frame);
+			rtl8169->rx_frames++;
 		}
 
 		tail = (tail + 1) % RX_BUFFERS_COUNT;
@@ -1032,18 +1112,19 @@ static void rtl8169_receive_done(ddf_dev_t *dev)
 
 }
 
-static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+/** Handle the interrupt status
+ *
+ *  Called from both the interrupt handler and the poll callback. The
+ *  handled events are acknowledged in the ISR.
+ *
+ *  @param nic_data  The driver data
+ *  @param isr       Interrupt status register value
+ */
+static void rtl8169_interrupt_impl(nic_t *nic_data, uint16_t isr)
 {
-	assert(dev);
-	assert(icall);
-
-	uint16_t isr = (uint16_t) ipc_get_arg2(icall) & INT_KNOWN;
-	nic_t *nic_data = nic_get_from_ddf_dev(dev);
+	ddf_dev_t *dev = nic_get_ddf_dev(nic_data);
 	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
 
-	ddf_msg(LVL_DEBUG, "rtl8169_irq_handler(): isr=0x%04x", isr);
-	pio_write_16(rtl8169->regs + IMR, 0xffff);
-
 	while (isr != 0) {
 		ddf_msg(LVL_DEBUG, "irq handler: remaining isr=0x%04x", isr);
 
@@ -1077,10 +1158,76 @@ static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 
 		isr = pio_read_16(rtl8169->regs + ISR) & INT_KNOWN;
 	}
+}
+
+static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+{
+	assert(dev);
+	assert(icall);
+
+	uint16_t isr = (uint16_t) ipc_get_arg2(icall) & INT_KNOWN;
+	nic_t *nic_data = nic_get_from_ddf_dev(dev);
+	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
+
+	ddf_msg(LVL_DEBUG, "rtl8169_irq_handler(): isr=0x%04x", isr);
+	pio_write_16(rtl8169->regs + IMR, rtl8169->int_mask);
+
+	nic_report_interrupt(nic_data);
+	rtl8169_interrupt_impl(nic_data, isr);
+	rtl8169_moderation_update(nic_data);
 
 	pio_write_16(rtl8169->regs + ISR, 0xffff);
 }
 
+/** Poll the device on demand or periodically
+ *
+ *  @param nic_data  The driver data
+ */
+static void rtl8169_poll(nic_t *nic_data)
+{
+	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
+
+	uint16_t isr = pio_read_16(rtl8169->regs + ISR) & INT_KNOWN;
+	rtl8169_interrupt_impl(nic_data, isr);
+}
+
+/** Set polling mode
+ *
+ *  The timed modes are not supported by the driver, libnic falls back to
+ *  software periodic polling for them.
+ *
+ *  @param nic_data  The driver data
+ *  @param mode      The mode to set
+ *  @param period    The period for NIC_POLL_PERIODIC
+ *
+ *  @return EOK if succeed
+ *  @return ENOTSUP if the mode is not supported
+ */
+static errno_t rtl8169_poll_mode_change(nic_t *nic_data, nic_poll_mode_t mode,
+    const struct timespec *period)
+{
+	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
+
+	switch (mode) {
+	case NIC_POLL_IMMEDIATE:
+		rtl8169->int_mask = RTL8169_DEFAULT_INTERRUPTS;
+		break;
+	case NIC_POLL_ON_DEMAND:
+		rtl8169->int_mask = 0;
+		break;
+	default:
+		return ENOTSUP;
+	}
+
+	/* Start again without moderation */
+	fibril_mutex_lock(&rtl8169->rx_lock);
+	rtl8169_moderation_set(rtl8169, false);
+	fibril_mutex_unlock(&rtl8169->rx_lock);
+
+	pio_write_16(rtl8169->regs + IMR, rtl8169->int_mask);
+	return EOK;
+}
+
 static void rtl8169_send_frame(nic_t *nic_data, void *data, size_t size)
 {
 	rtl8169_descr_t *descr, *prev;
@@ -30,8 +30,10 @@
 #ifndef RTL8169_DRIVER_H_
 #define RTL8169_DRIVER_H_
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 #include "defs.h"
 
 /** The driver name */
@@ -93,6 +95,13 @@ typedef struct rtl8169_data {
 	uint32_t rcr_ucast;
 	uint32_t rcr_mcast;
 
+	/** Receive interrupts are delayed by the interrupt mitigation */
+	bool rx_moderated;
+	/** Frames received since the start of the sampling window */
+	unsigned int rx_frames;
+	/** Start of the sampling window */
+	struct timespec rx_stamp;
+
 	/** Lock for receiver */
 	fibril_mutex_t rx_lock;
 	/** Lock for transmitter */
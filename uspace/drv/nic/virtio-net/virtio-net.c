@@ -32,12 +32,15 @@
 #include <stdint.h>
 
 #include <as.h>
+#include <macros.h>
 #include <ddf/driver.h>
 #include <ddf/interrupt.h>
 #include <ddf/log.h>
 #include <ops/nic.h>
 #include <pci_dev_iface.h>
 #include <nic/nic.h>
+#include <stats.h>
+#include <str_error.h>
 
 #include <nic.h>
 
@@ -45,17 +48,14 @@
 
 #define NAME	"virtio-net"
 
-#define VIRTIO_NET_NUM_QUEUES	3
-
-#define RX_QUEUE_1	0
-#define TX_QUEUE_1	1
-#define CT_QUEUE_1	2
-
 #define BUFFER_SIZE	2048
 #define RX_BUF_SIZE	BUFFER_SIZE
 #define TX_BUF_SIZE	BUFFER_SIZE
 #define CT_BUF_SIZE	BUFFER_SIZE
 
+/** Time to wait for the completion of a control command. */
+#define CT_TIMEOUT	1000000
+
 static ddf_dev_ops_t virtio_net_dev_ops;
 
 static errno_t virtio_net_dev_add(ddf_dev_t *dev);
@@ -69,6 +69,76 @@ static driver_t virtio_net_driver = {
 	.driver_ops = &virtio_net_driver_ops
 };
 
+/** Pass the frames received in a receive queue to the NIC framework.
+ *
+ * With VIRTIO_NET_F_MRG_RXBUF a frame can span several buffers, the header
+ * in the first one tells how many. The buffers are returned to the device
+ * and it is notified once for the whole batch.
+ */
+static void virtio_net_rx(nic_t *nic, virtio_net_queue_t *q)
+{
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+	bool mrg = (vdev->features & VIRTIO_NET_F_MRG_RXBUF) != 0;
+	uint16_t descs[RX_BUFFERS_MAX];
+	uint32_t lens[RX_BUFFERS_MAX];
+	bool refill = false;
+
+	while (virtio_virtq_consume_used(vdev, q->num, &descs[0], &lens[0])) {
+		virtio_net_hdr_t *hdr = (virtio_net_hdr_t *) q->buf[descs[0]];
+		unsigned nbufs = 1;
+		unsigned n = 1;
+
+		if (mrg)
+			nbufs = max(pio_read_le16(&hdr->num_buffers), 1);
+
+		/* Collect the rest of the buffers of the frame */
+		while (n < min(nbufs, q->size) &&
+		    virtio_virtq_consume_used(vdev, q->num, &descs[n], &lens[n]))
+			n++;
+
+		size_t size = 0;
+		for (unsigned i = 0; i < n; i++) {
+			lens[i] = min(lens[i], RX_BUF_SIZE);
+			size += lens[i];
+		}
+
+		if (n < nbufs) {
+			ddf_msg(LVL_WARN,
+			    "RX buffers of a frame missing, packet dropped");
+		} else if (lens[0] <= sizeof(*hdr)) {
+			ddf_msg(LVL_WARN,
+			    "RX data length too short, packet dropped");
+		} else {
+			size -= sizeof(*hdr);
+
+			nic_frame_t *frame = nic_alloc_frame(nic, size);
+			if (frame) {
+				uint8_t *dst = frame->data;
+
+				memcpy(dst, &hdr[1], lens[0] - sizeof(*hdr));
+				dst += lens[0] - sizeof(*hdr);
+				for (unsigned i = 1; i < n; i++) {
+					memcpy(dst, q->buf[descs[i]], lens[i]);
+					dst += lens[i];
+				}
+
+				nic_received_frame(nic, frame);
+			} else {
+				ddf_msg(LVL_WARN,
+				    "Cannot allocate RX frame, packet dropped");
+			}
+		}
+
+		for (unsigned i = 0; i < n; i++)
+			virtio_virtq_add_available(vdev, q->num, descs[i]);
+		refill = true;
+	}
+
+	if (refill)
+		virtio_virtq_notify(vdev, q->num);
+}
+
 static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 {
 	nic_t *nic = ddf_dev_data_get(dev);
@@ -77,36 +147,36 @@ static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 
 	uint16_t descno;
 	uint32_t len;
-	while (virtio_virtq_consume_used(vdev, RX_QUEUE_1, &descno, &len)) {
-		virtio_net_hdr_t *hdr =
-		    (virtio_net_hdr_t *) virtio_net->rx_buf[descno];
-		if (len <= sizeof(*hdr)) {
-			ddf_msg(LVL_WARN,
-			    "RX data length too short, packet dropped");
-			virtio_virtq_produce_available(vdev, RX_QUEUE_1,
+
+	/* All queues share the interrupt. */
+	for (unsigned i = 0; i < virtio_net->num_pairs; i++) {
+		virtio_net_queue_t *txq = &virtio_net->txq[i];
+
+		virtio_net_rx(nic, &virtio_net->rxq[i]);
+
+		while (virtio_virtq_consume_used(vdev, txq->num, &descno,
+		    &len)) {
+			virtio_free_desc(vdev, txq->num, &txq->free_head,
 			    descno);
-			continue;
 		}
+	}
 
-		nic_frame_t *frame = nic_alloc_frame(nic, len - sizeof(*hdr));
-		if (frame) {
-			memcpy(frame->data, &hdr[1], len - sizeof(*hdr));
-			nic_received_frame(nic, frame);
-		} else {
-			ddf_msg(LVL_WARN,
-			    "Cannot allocate RX frame, packet dropped");
-		}
+	while (virtio_virtq_consume_used(vdev, virtio_net->ct_num, &descno,
+	    &len)) {
+		uint16_t next = virtio_virtq_desc_get_next(vdev,
+		    virtio_net->ct_num, descno);
 
-		virtio_virtq_produce_available(vdev, RX_QUEUE_1, descno);
-	}
+		virtio_free_desc(vdev, virtio_net->ct_num,
+		    &virtio_net->ct_free_head, descno);
+		if (next != (uint16_t) -1U) {
+			virtio_free_desc(vdev, virtio_net->ct_num,
+			    &virtio_net->ct_free_head, next);
+		}
 
-	while (virtio_virtq_consume_used(vdev, TX_QUEUE_1, &descno, &len)) {
-		virtio_free_desc(vdev, TX_QUEUE_1, &virtio_net->tx_free_head,
-		    descno);
-	}
-	while (virtio_virtq_consume_used(vdev, CT_QUEUE_1, &descno, &len)) {
-		virtio_free_desc(vdev, CT_QUEUE_1, &virtio_net->ct_free_head,
-		    descno);
+		fibril_mutex_lock(&virtio_net->ct_lock);
+		virtio_net->ct_done = true;
+		fibril_condvar_broadcast(&virtio_net->ct_cv);
+		fibril_mutex_unlock(&virtio_net->ct_lock);
 	}
 }
 
@@ -166,6 +236,163 @@ static errno_t virtio_net_register_interrupt(ddf_dev_t *dev)
 	    virtio_net_irq_handler, &irq_code, &virtio_net->irq_handle);
 }
 
+/** Send a command over the control virtqueue and wait for its completion.
+ *
+ * @param virtio_net	Device
+ * @param class		Command class
+ * @param command	Command
+ * @param data		Command-specific data
+ * @param size		Size of the data
+ *
+ * @return EOK if the device acknowledged the command, EIO if it refused it,
+ *         ETIMEOUT if it did not complete it in time
+ */
+static errno_t virtio_net_ctrl_cmd(virtio_net_t *virtio_net, uint8_t class,
+    uint8_t command, const void *data, size_t size)
+{
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+	uint16_t num = virtio_net->ct_num;
+	errno_t rc = EOK;
+
+	assert(sizeof(virtio_net_ctrl_hdr_t) + size <= CT_BUF_SIZE);
+
+	fibril_mutex_lock(&virtio_net->ct_lock);
+
+	uint16_t hdrno = virtio_alloc_desc(vdev, num,
+	    &virtio_net->ct_free_head);
+	if (hdrno == (uint16_t) -1U) {
+		fibril_mutex_unlock(&virtio_net->ct_lock);
+		return EBUSY;
+	}
+
+	uint16_t ackno = virtio_alloc_desc(vdev, num,
+	    &virtio_net->ct_free_head);
+	if (ackno == (uint16_t) -1U) {
+		virtio_free_desc(vdev, num, &virtio_net->ct_free_head, hdrno);
+		fibril_mutex_unlock(&virtio_net->ct_lock);
+		return EBUSY;
+	}
+
+	virtio_net_ctrl_hdr_t *hdr =
+	    (virtio_net_ctrl_hdr_t *) virtio_net->ct_buf[hdrno];
+	hdr->class = class;
+	hdr->command = command;
+	memcpy(&hdr[1], data, size);
+
+	uint8_t *ack = (uint8_t *) virtio_net->ct_buf[ackno];
+	*ack = VIRTIO_NET_ERR;
+
+	/* The device reads the command and writes the acknowledgement */
+	virtio_virtq_desc_set(vdev, num, hdrno, virtio_net->ct_buf_p[hdrno],
+	    sizeof(virtio_net_ctrl_hdr_t) + size, VIRTQ_DESC_F_NEXT, ackno);
+	virtio_virtq_desc_set(vdev, num, ackno, virtio_net->ct_buf_p[ackno],
+	    sizeof(uint8_t), VIRTQ_DESC_F_WRITE, 0);
+
+	virtio_net->ct_done = false;
+	virtio_virtq_produce_available(vdev, num, hdrno);
+
+	while (!virtio_net->ct_done && rc == EOK) {
+		rc = fibril_condvar_wait_timeout(&virtio_net->ct_cv,
+		    &virtio_net->ct_lock, CT_TIMEOUT);
+	}
+
+	if (rc == EOK && *ack != VIRTIO_NET_OK)
+		rc = EIO;
+
+	fibril_mutex_unlock(&virtio_net->ct_lock);
+	return rc;
+}
+
+/** Determine the number of queue pairs to use.
+ *
+ * One pair per CPU is used, limited by what the device offers and by
+ * VIRTIO_NET_MAX_PAIRS.
+ */
+static unsigned virtio_net_num_pairs(unsigned max_pairs)
+{
+	unsigned np = max_pairs;
+
+	size_t cpus;
+	stats_cpu_t *stats = stats_get_cpus(&cpus);
+	if (stats != NULL) {
+		free(stats);
+		np = min(np, (unsigned) cpus);
+	}
+
+	np = min(np, VIRTIO_NET_MAX_PAIRS);
+	return max(np, 1);
+}
+
+/** Set up a receive or transmit queue and its DMA buffers.
+ *
+ * The queue is as large as the device allows, up to @a max_size.
+ * The buffers of a receive queue are given to the device, the descriptors
+ * of a transmit queue are put on a free list.
+ */
+static errno_t virtio_net_queue_init(virtio_net_t *virtio_net,
+    virtio_net_queue_t *q, uint16_t num, uint16_t max_size, bool rx)
+{
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+	errno_t rc;
+
+	uint16_t size = min(virtio_virtq_max_size(vdev, num), max_size);
+	if (size == 0)
+		return ENOENT;
+
+	q->num = num;
+
+	rc = virtio_virtq_setup(vdev, num, size);
+	if (rc != EOK)
+		return rc;
+
+	q->buf = calloc(size, sizeof(void *));
+	q->buf_p = calloc(size, sizeof(uintptr_t));
+	if (q->buf == NULL || q->buf_p == NULL)
+		return ENOMEM;
+
+	rc = virtio_setup_dma_bufs(size, BUFFER_SIZE, !rx, q->buf, q->buf_p);
+	if (rc != EOK)
+		return rc;
+
+	q->size = size;
+
+	if (!rx) {
+		virtio_create_desc_free_list(vdev, num, size, &q->free_head);
+		return EOK;
+	}
+
+	for (unsigned i = 0; i < size; i++) {
+		/*
+		 * Associtate the buffer with the descriptor, set length and
+		 * flags.
+		 */
+		virtio_virtq_desc_set(vdev, num, i, q->buf_p[i], RX_BUF_SIZE,
+		    VIRTQ_DESC_F_WRITE, 0);
+		/*
+		 * Put the set descriptor into the available ring of the RX
+		 * queue.
+		 */
+		virtio_virtq_add_available(vdev, num, i);
+	}
+
+	virtio_virtq_notify(vdev, num);
+	return EOK;
+}
+
+/** Free the DMA buffers of a receive or transmit queue. */
+static void virtio_net_queue_fini(virtio_net_queue_t *q)
+{
+	if (q->buf != NULL) {
+		virtio_teardown_dma_bufs(q->buf);
+		free(q->buf);
+		q->buf = NULL;
+	}
+
+	free(q->buf_p);
+	q->buf_p = NULL;
+	q->size = 0;
+}
+
 static errno_t virtio_net_initialize(ddf_dev_t *dev)
 {
 	nic_t *nic = nic_create_and_bind(dev);
@@ -178,6 +405,9 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 		return ENOMEM;
 	}
 
+	fibril_mutex_initialize(&virtio_net->ct_lock);
+	fibril_condvar_initialize(&virtio_net->ct_cv);
+
 	nic_set_specific(nic, virtio_net);
 
 	errno_t rc = virtio_pci_dev_initialize(dev, &virtio_net->virtio_dev);
@@ -196,18 +426,25 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 		goto fail;
 
 	/* Reset the device and negotiate the feature bits */
-	rc = virtio_device_setup_start(vdev,
-	    VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ);
+	rc = virtio_device_setup_start_opt(vdev,
+	    VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ, VIRTIO_NET_F_CSUM |
+	    VIRTIO_NET_F_MRG_RXBUF | VIRTIO_NET_F_MQ | VIRTIO_F_EVENT_IDX);
 	if (rc != EOK)
 		goto fail;
 
 	/* Perform device-specific setup */
 
 	/*
-	 * Discover and configure the virtqueues
+	 * Discover and configure the virtqueues. The receive and transmit
+	 * queues of each pair come first, followed by the control queue.
 	 */
+	unsigned max_pairs = 1;
+	if (vdev->features & VIRTIO_NET_F_MQ)
+		max_pairs = max(pio_read_le16(&netcfg->max_virtqueue_pairs), 1);
+	virtio_net->ct_num = 2 * max_pairs;
+
 	uint16_t num_queues = pio_read_le16(&cfg->num_queues);
-	if (num_queues != VIRTIO_NET_NUM_QUEUES) {
+	if (num_queues < virtio_net->ct_num + 1) {
 		ddf_msg(LVL_NOTE, "Unsupported number of virtqueues: %u",
 		    num_queues);
 		rc = ELIMIT;
@@ -220,25 +457,19 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 		goto fail;
 	}
 
-	rc = virtio_virtq_setup(vdev, RX_QUEUE_1, RX_BUFFERS);
-	if (rc != EOK)
-		goto fail;
-	rc = virtio_virtq_setup(vdev, TX_QUEUE_1, TX_BUFFERS);
-	if (rc != EOK)
-		goto fail;
-	rc = virtio_virtq_setup(vdev, CT_QUEUE_1, CT_BUFFERS);
-	if (rc != EOK)
-		goto fail;
+	unsigned np = virtio_net_num_pairs(max_pairs);
+	for (unsigned i = 0; i < np; i++) {
+		rc = virtio_net_queue_init(virtio_net, &virtio_net->rxq[i],
+		    2 * i, RX_BUFFERS_MAX, true);
+		if (rc != EOK)
+			goto fail;
+		rc = virtio_net_queue_init(virtio_net, &virtio_net->txq[i],
+		    2 * i + 1, TX_BUFFERS_MAX, false);
+		if (rc != EOK)
+			goto fail;
+	}
 
-	/*
-	 * Setup DMA buffers
-	 */
-	rc = virtio_setup_dma_bufs(RX_BUFFERS, RX_BUF_SIZE, false,
-	    virtio_net->rx_buf, virtio_net->rx_buf_p);
-	if (rc != EOK)
-		goto fail;
-	rc = virtio_setup_dma_bufs(TX_BUFFERS, TX_BUF_SIZE, true,
-	    virtio_net->tx_buf, virtio_net->tx_buf_p);
+	rc = virtio_virtq_setup(vdev, virtio_net->ct_num, CT_BUFFERS);
 	if (rc != EOK)
 		goto fail;
 	rc = virtio_setup_dma_bufs(CT_BUFFERS, CT_BUF_SIZE, true,
@@ -247,29 +478,9 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 		goto fail;
 
 	/*
-	 * Give all RX buffers to the NIC
-	 */
-	for (unsigned i = 0; i < RX_BUFFERS; i++) {
-		/*
-		 * Associtate the buffer with the descriptor, set length and
-		 * flags.
-		 */
-		virtio_virtq_desc_set(vdev, RX_QUEUE_1, i,
-		    virtio_net->rx_buf_p[i], RX_BUF_SIZE, VIRTQ_DESC_F_WRITE,
-		    0);
-		/*
-		 * Put the set descriptor into the available ring of the RX
-		 * queue.
-		 */
-		virtio_virtq_produce_available(vdev, RX_QUEUE_1, i);
-	}
-
-	/*
-	 * Put all TX and CT buffers on a free list
+	 * Put all CT buffers on a free list
 	 */
-	virtio_create_desc_free_list(vdev, TX_QUEUE_1, TX_BUFFERS,
-	    &virtio_net->tx_free_head);
-	virtio_create_desc_free_list(vdev, CT_QUEUE_1, CT_BUFFERS,
+	virtio_create_desc_free_list(vdev, virtio_net->ct_num, CT_BUFFERS,
 	    &virtio_net->ct_free_head);
 
 	/*
@@ -287,6 +498,9 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 	/*
 	 * Enable IRQ
 	 */
+	virtio_net->num_pairs = np;
+	virtio_net->active_pairs = 1;
+
 	rc = hw_res_enable_interrupt(ddf_dev_parent_sess_get(dev),
 	    virtio_net->irq);
 	if (rc != EOK) {
@@ -299,11 +513,38 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 	/* Go live */
 	virtio_device_setup_finalize(vdev);
 
+	/*
+	 * The device uses only the first queue pair until it is told
+	 * otherwise.
+	 */
+	if (np > 1) {
+		uint16_t pairs;
+
+		pio_write_le16(&pairs, np);
+		rc = virtio_net_ctrl_cmd(virtio_net, VIRTIO_NET_CTRL_MQ,
+		    VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET, &pairs, sizeof(pairs));
+		if (rc == EOK) {
+			virtio_net->active_pairs = np;
+		} else {
+			ddf_msg(LVL_WARN, "Failed enabling %u queue pairs: %s",
+			    np, str_error(rc));
+		}
+	}
+
+	ddf_msg(LVL_NOTE, "Using %u queue pair(s) with %u/%u descriptors%s%s",
+	    virtio_net->active_pairs, virtio_net->rxq[0].size,
+	    virtio_net->txq[0].size,
+	    (vdev->features & VIRTIO_NET_F_MRG_RXBUF) ?
+	    ", mergeable RX buffers" : "",
+	    (vdev->features & VIRTIO_F_EVENT_IDX) ? ", event index" : "");
+
 	return EOK;
 
 fail:
-	virtio_teardown_dma_bufs(virtio_net->rx_buf);
-	virtio_teardown_dma_bufs(virtio_net->tx_buf);
+	for (unsigned i = 0; i < VIRTIO_NET_MAX_PAIRS; i++) {
+		virtio_net_queue_fini(&virtio_net->rxq[i]);
+		virtio_net_queue_fini(&virtio_net->txq[i]);
+	}
 	virtio_teardown_dma_bufs(virtio_net->ct_buf);
 
 	virtio_device_setup_fail(vdev);
@@ -316,37 +557,71 @@ static void virtio_net_uninitialize(ddf_dev_t *dev)
 	nic_t *nic = ddf_dev_data_get(dev);
 	virtio_net_t *virtio_net = (virtio_net_t *) nic_get_specific(nic);
 
-	virtio_teardown_dma_bufs(virtio_net->rx_buf);
-	virtio_teardown_dma_bufs(virtio_net->tx_buf);
+	for (unsigned i = 0; i < VIRTIO_NET_MAX_PAIRS; i++) {
+		virtio_net_queue_fini(&virtio_net->rxq[i]);
+		virtio_net_queue_fini(&virtio_net->txq[i]);
+	}
 	virtio_teardown_dma_bufs(virtio_net->ct_buf);
 
 	virtio_device_setup_fail(&virtio_net->virtio_dev);
 	virtio_pci_dev_cleanup(&virtio_net->virtio_dev);
 }
 
-static void virtio_net_send(nic_t *nic, void *data, size_t size)
+/** Choose the transmit queue for a frame.
+ *
+ * The device steers the received frames of a flow to the receive queue of
+ * the pair the flow was last sent on. Sending on the queue given by the RSS
+ * configuration and the flow steering rules thus makes the replies arrive
+ * where they are directed to. Frames of one flow always use the same queue,
+ * so they are not reordered.
+ */
+static virtio_net_queue_t *virtio_net_txq_get(nic_t *nic,
+    virtio_net_t *virtio_net, const uint8_t *data, size_t size)
+{
+	if (virtio_net->active_pairs <= 1)
+		return &virtio_net->txq[0];
+
+	return &virtio_net->txq[nic_query_tx_queue(nic, data, size)];
+}
+
+/** Send a frame.
+ *
+ * @param nic	NIC
+ * @param data	Frame data
+ * @param size	Frame size
+ * @param csum	Checksum for the device to complete or @c NULL
+ */
+static void virtio_net_send_common(nic_t *nic, void *data, size_t size,
+    const nic_csum_t *csum)
 {
 	virtio_net_t *virtio_net = nic_get_specific(nic);
 	virtio_dev_t *vdev = &virtio_net->virtio_dev;
 
-	if (size > sizeof(virtio_net) + TX_BUF_SIZE) {
+	if (sizeof(virtio_net_hdr_t) + size > TX_BUF_SIZE) {
 		ddf_msg(LVL_WARN, "TX data too big, frame dropped");
 		return;
 	}
 
-	uint16_t descno = virtio_alloc_desc(vdev, TX_QUEUE_1,
-	    &virtio_net->tx_free_head);
+	virtio_net_queue_t *q = virtio_net_txq_get(nic, virtio_net, data,
+	    size);
+
+	uint16_t descno = virtio_alloc_desc(vdev, q->num, &q->free_head);
 	if (descno == (uint16_t) -1U) {
 		ddf_msg(LVL_WARN, "No TX buffers available, frame dropped");
 		return;
 	}
-	assert(descno < TX_BUFFERS);
+	assert(descno < q->size);
 
 	/* Setup the packet header */
-	virtio_net_hdr_t *hdr = (virtio_net_hdr_t *) virtio_net->tx_buf[descno];
+	virtio_net_hdr_t *hdr = (virtio_net_hdr_t *) q->buf[descno];
 	memset(hdr, 0, sizeof(virtio_net_hdr_t));
 	hdr->gso_type = VIRTIO_NET_HDR_GSO_NONE;
 	hdr->num_buffers = 0;
+	if (csum != NULL) {
+		hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+		pio_write_le16(&hdr->csum_start, csum->start);
+		pio_write_le16(&hdr->csum_offset, csum->offset);
+	}
 
 	/* Copy packet data into the buffer just past the header */
 	memcpy(&hdr[1], data, size);
@@ -354,9 +629,20 @@ static void virtio_net_send(nic_t *nic, void *data, size_t size)
 	/*
 	 * Set the descriptor, put it into the virtqueue and notify the device
 	 */
-	virtio_virtq_desc_set(vdev, TX_QUEUE_1, descno,
-	    virtio_net->tx_buf_p[descno], sizeof(virtio_net_hdr_t) + size, 0, 0);
-	virtio_virtq_produce_available(vdev, TX_QUEUE_1, descno);
+	virtio_virtq_desc_set(vdev, q->num, descno, q->buf_p[descno],
+	    sizeof(virtio_net_hdr_t) + size, 0, 0);
+	virtio_virtq_produce_available(vdev, q->num, descno);
+}
+
+static void virtio_net_send(nic_t *nic, void *data, size_t size)
+{
+	virtio_net_send_common(nic, data, size, NULL);
+}
+
+static void virtio_net_send_csum(nic_t *nic, void *data, size_t size,
+    const nic_csum_t *csum)
+{
+	virtio_net_send_common(nic, data, size, csum);
 }
 
 static errno_t virtio_net_on_multicast_mode_change(nic_t *nic,
@@ -407,13 +693,20 @@ static errno_t virtio_net_dev_add(ddf_dev_t *dev)
 		goto uninitialize;
 	}
 	nic_t *nic = ddf_dev_data_get(dev);
+	virtio_net_t *virtio_net = nic_get_specific(nic);
 	nic_set_ddf_fun(nic, fun);
 	ddf_fun_set_ops(fun, &virtio_net_dev_ops);
 
 	nic_set_send_frame_handler(nic, virtio_net_send);
+	if ((virtio_net->virtio_dev.features & VIRTIO_NET_F_CSUM) != 0)
+		nic_set_send_frame_csum_handler(nic, virtio_net_send_csum);
 	nic_set_filtering_change_handlers(nic, NULL,
 	    virtio_net_on_multicast_mode_change,
 	    virtio_net_on_broadcast_mode_change, NULL, NULL);
+	nic_set_queues(nic, virtio_net->active_pairs, virtio_net->active_pairs,
+	    NIC_RSS_HASH_IPV4 | NIC_RSS_HASH_TCP_IPV4 | NIC_RSS_HASH_UDP_IPV4 |
+	    NIC_RSS_HASH_IPV6 | NIC_RSS_HASH_TCP_IPV6 | NIC_RSS_HASH_UDP_IPV6,
+	    NIC_FLOWS_MAX);
 
 	rc = ddf_fun_bind(fun);
 	if (rc != EOK) {
@@ -32,19 +32,32 @@
 #include <virtio-pci.h>
 #include <abi/cap.h>
 #include <nic/nic.h>
+#include <fibril_synch.h>
+#include <stdbool.h>
 
-#define RX_BUFFERS	8
-#define TX_BUFFERS	8
+/** Maximum sizes of the receive and transmit virtqueues. */
+#define RX_BUFFERS_MAX	256
+#define TX_BUFFERS_MAX	256
 #define CT_BUFFERS	4
 
+/** Maximum number of receive/transmit queue pairs used. */
+#define VIRTIO_NET_MAX_PAIRS	8
+
 /** Device handles packets with partial checksum. */
 #define VIRTIO_NET_F_CSUM		(1U << 0)
 /** Driver handles packets with partial checksum. */
 #define VIRTIO_NET_F_GUEST_CSUM		(1U << 2)
 /** Device has given MAC address. */
 #define VIRTIO_NET_F_MAC		(1U << 5)
+/** Driver can merge receive buffers. */
+#define VIRTIO_NET_F_MRG_RXBUF		(1U << 15)
 /** Control channel is available */
 #define VIRTIO_NET_F_CTRL_VQ		(1U << 17)
+/** Device supports multiple receive/transmit queue pairs. */
+#define VIRTIO_NET_F_MQ			(1U << 22)
+
+/** Packet needs the checksum at csum_start + csum_offset. */
+#define VIRTIO_NET_HDR_F_NEEDS_CSUM	1
 
 #define VIRTIO_NET_HDR_GSO_NONE 0
 typedef struct {
@@ -54,25 +67,65 @@ typedef struct {
 	uint16_t gso_size;
 	uint16_t csum_start;
 	uint16_t csum_offset;
+	/** Number of merged receive buffers, with VIRTIO_NET_F_MRG_RXBUF. */
 	uint16_t num_buffers;
 } virtio_net_hdr_t;
 
+/* Control commands. */
+#define VIRTIO_NET_CTRL_MQ		4
+#define VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET	0
+
+/* Control command acknowledgements. */
+#define VIRTIO_NET_OK	0
+#define VIRTIO_NET_ERR	1
+
+typedef struct {
+	uint8_t class;
+	uint8_t command;
+} virtio_net_ctrl_hdr_t;
+
 typedef struct {
 	uint8_t mac[ETH_ADDR];
+	uint16_t status;
+	/** Maximum number of queue pairs, valid with VIRTIO_NET_F_MQ. */
+	uint16_t max_virtqueue_pairs;
 } virtio_net_cfg_t;
 
+/** Receive or transmit queue. */
+typedef struct {
+	/** Index of the virtqueue. */
+	uint16_t num;
+	/** Number of descriptors and buffers. */
+	uint16_t size;
+
+	void **buf;
+	uintptr_t *buf_p;
+
+	/** Head of the free descriptor list of a transmit queue. */
+	uint16_t free_head;
+} virtio_net_queue_t;
+
 typedef struct {
 	virtio_dev_t virtio_dev;
-	void *rx_buf[RX_BUFFERS];
-	uintptr_t rx_buf_p[RX_BUFFERS];
-	void *tx_buf[TX_BUFFERS];
-	uintptr_t tx_buf_p[TX_BUFFERS];
+
+	/** Number of receive/transmit queue pairs set up. */
+	unsigned num_pairs;
+	/** Number of queue pairs enabled in the device, used to transmit. */
+	unsigned active_pairs;
+	virtio_net_queue_t rxq[VIRTIO_NET_MAX_PAIRS];
+	virtio_net_queue_t txq[VIRTIO_NET_MAX_PAIRS];
+
+	/** Index of the control virtqueue. */
+	uint16_t ct_num;
 	void *ct_buf[CT_BUFFERS];
 	uintptr_t ct_buf_p[CT_BUFFERS];
-
-	uint16_t tx_free_head;
 	uint16_t ct_free_head;
 
+	/** Serializes control commands and signals their completion. */
+	fibril_mutex_t ct_lock;
+	fibril_condvar_t ct_cv;
+	bool ct_done;
+
 	int irq;
 	cap_irq_handle_t irq_handle;
 } virtio_net_t;
@@ -259,6 +259,8 @@ errno_t bithenge_new_offset_blob(bithenge_node_t **, bithenge_blob_t *, aoff64_t
 errno_t bithenge_new_subblob(bithenge_node_t **, bithenge_blob_t *, aoff64_t,
     aoff64_t);
 /** @memberof bithenge_blob_t */
+errno_t bithenge_new_cached_blob(bithenge_node_t **, bithenge_blob_t *);
+/** @memberof bithenge_blob_t */
 errno_t bithenge_blob_equal(bool *, bithenge_blob_t *, bithenge_blob_t *);
 
 #endif
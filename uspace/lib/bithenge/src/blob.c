@@ -132,7 +132,7 @@ static errno_t sequential_read(bithenge_blob_t *base, aoff64_t offset,
 	}
 	if (offset > blob->data_size)
 		return EINVAL;
-	*size = min(*size, blob->data_size - end);
+	*size = min(*size, blob->data_size - offset);
 	memcpy(buffer, blob->buffer + offset, *size);
 	return EOK;
 }
@@ -456,6 +456,176 @@ errno_t bithenge_new_subblob(bithenge_node_t **out, bithenge_blob_t *source,
 	return new_subblob(out, source, offset, size, true);
 }
 
+/** Size of a block in the cache of a cached blob. */
+#define CACHED_BLOCK_SIZE 4096
+/** Number of blocks in the cache of a cached blob. */
+#define CACHED_BLOCK_COUNT 16
+
+typedef struct {
+	/** Offset of the block within the source, or -1 if unused. */
+	aoff64_t offset;
+	/** Amount of valid data, less than the block size at the end. */
+	aoff64_t size;
+	/** Value of the use counter when the block was last used. */
+	unsigned last_use;
+	char data[CACHED_BLOCK_SIZE];
+} cached_block_t;
+
+typedef struct {
+	bithenge_blob_t base;
+	bithenge_blob_t *source;
+	unsigned use_counter;
+	cached_block_t blocks[CACHED_BLOCK_COUNT];
+} cached_blob_t;
+
+static inline cached_blob_t *blob_as_cached(bithenge_blob_t *base)
+{
+	return (cached_blob_t *)base;
+}
+
+static inline bithenge_blob_t *cached_as_blob(cached_blob_t *blob)
+{
+	return &blob->base;
+}
+
+/** Get the cache block starting at @a offset, reading it if necessary. The
+ * least recently used block is replaced. */
+static errno_t cached_get_block(cached_blob_t *blob, aoff64_t offset,
+    cached_block_t **out)
+{
+	cached_block_t *victim = &blob->blocks[0];
+	for (size_t i = 0; i < CACHED_BLOCK_COUNT; i++) {
+		cached_block_t *block = &blob->blocks[i];
+		if (block->offset == offset) {
+			block->last_use = ++blob->use_counter;
+			*out = block;
+			return EOK;
+		}
+		if (block->last_use < victim->last_use)
+			victim = block;
+	}
+
+	victim->offset = (aoff64_t) -1;
+	victim->last_use = 0;
+	victim->size = CACHED_BLOCK_SIZE;
+	errno_t rc = bithenge_blob_read(blob->source, offset, victim->data,
+	    &victim->size);
+	if (rc != EOK)
+		return rc;
+	victim->offset = offset;
+	victim->last_use = ++blob->use_counter;
+	*out = victim;
+	return EOK;
+}
+
+static errno_t cached_size(bithenge_blob_t *base, aoff64_t *size)
+{
+	cached_blob_t *blob = blob_as_cached(base);
+	return bithenge_blob_size(blob->source, size);
+}
+
+static errno_t cached_read(bithenge_blob_t *base, aoff64_t offset,
+    char *buffer, aoff64_t *size)
+{
+	cached_blob_t *blob = blob_as_cached(base);
+	aoff64_t done = 0;
+	errno_t rc;
+
+	/* Let the source check the offset. */
+	if (*size == 0)
+		return bithenge_blob_read(blob->source, offset, buffer, size);
+
+	while (done < *size) {
+		aoff64_t pos = offset + done;
+		aoff64_t in_block = pos % CACHED_BLOCK_SIZE;
+		aoff64_t left = *size - done;
+
+		if (in_block == 0 && left >= CACHED_BLOCK_SIZE) {
+			/* Whole blocks bypass the cache. */
+			aoff64_t amount = left - left % CACHED_BLOCK_SIZE;
+			rc = bithenge_blob_read(blob->source, pos,
+			    buffer + done, &amount);
+			if (rc != EOK)
+				return rc;
+			done += amount;
+			if (amount % CACHED_BLOCK_SIZE != 0 || amount == 0)
+				break;
+			continue;
+		}
+
+		cached_block_t *block;
+		rc = cached_get_block(blob, pos - in_block, &block);
+		if (rc != EOK)
+			return rc;
+		if (in_block > block->size)
+			return done ? EOK : ELIMIT;
+		if (in_block == block->size)
+			break;
+
+		aoff64_t amount = min(left, block->size - in_block);
+		memcpy(buffer + done, block->data + in_block, amount);
+		done += amount;
+	}
+
+	*size = done;
+	return EOK;
+}
+
+static void cached_destroy(bithenge_blob_t *base)
+{
+	cached_blob_t *blob = blob_as_cached(base);
+	bithenge_blob_dec_ref(blob->source);
+	free(blob);
+}
+
+static const bithenge_random_access_blob_ops_t cached_ops = {
+	.size = cached_size,
+	.read = cached_read,
+	.destroy = cached_destroy,
+};
+
+/** Create a blob that caches blocks read from another blob. Reading small
+ * fields from file or block device blobs is then served from memory instead
+ * of going to the underlying storage every time, while the memory used stays
+ * fixed regardless of the size of the source. The source must not change
+ * while the cached blob exists. This function takes ownership of a reference
+ * to @a source.
+ * @param[out] out Stores the created blob node. On error, this is unchanged.
+ * @param[in] source The input blob.
+ * @return EOK on success or an error code from errno.h.
+ */
+errno_t bithenge_new_cached_blob(bithenge_node_t **out,
+    bithenge_blob_t *source)
+{
+	assert(out);
+	assert(source);
+	errno_t rc;
+
+	cached_blob_t *blob = malloc(sizeof(*blob));
+	if (!blob) {
+		rc = ENOMEM;
+		goto error;
+	}
+	rc = bithenge_init_random_access_blob(cached_as_blob(blob),
+	    &cached_ops);
+	if (rc != EOK)
+		goto error;
+	blob->source = source;
+	blob->use_counter = 0;
+	for (size_t i = 0; i < CACHED_BLOCK_COUNT; i++) {
+		blob->blocks[i].offset = (aoff64_t) -1;
+		blob->blocks[i].size = 0;
+		blob->blocks[i].last_use = 0;
+	}
+	*out = bithenge_blob_as_node(cached_as_blob(blob));
+	return EOK;
+
+error:
+	bithenge_blob_dec_ref(source);
+	free(blob);
+	return rc;
+}
+
 /** Check whether the contents of two blobs are equal.
  * @memberof bithenge_blob_t
  * @param[out] out Holds whether the blobs are equal.
@@ -79,15 +79,16 @@ static errno_t file_read(bithenge_blob_t *base, aoff64_t offset, char *buffer,
 	size_t amount_read;
 	errno_t rc = vfs_read(blob->fd, &offset, buffer, *size, &amount_read);
 	if (rc != EOK)
-		return errno;
-	*size += amount_read;
+		return rc;
+	*size = amount_read;
 	return EOK;
 }
 
 static void file_destroy(bithenge_blob_t *base)
 {
 	file_blob_t *blob = blob_as_file(base);
-	vfs_put(blob->fd);
+	if (blob->needs_close)
+		vfs_put(blob->fd);
 	free(blob);
 }
 
@@ -130,9 +131,9 @@ static errno_t new_file_blob(bithenge_node_t **out, int fd, bool needs_close)
 	blob->size = stat.st_size;
 #endif
 	blob->needs_close = needs_close;
-	*out = bithenge_blob_as_node(file_as_blob(blob));
 
-	return EOK;
+	// Small fields would otherwise each cost a read from the file system
+	return bithenge_new_cached_blob(out, file_as_blob(blob));
 }
 
 /** Create a blob for a file. The blob must be freed with @a
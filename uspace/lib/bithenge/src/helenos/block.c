@@ -74,6 +74,8 @@ static errno_t block_read(bithenge_blob_t *base, aoff64_t offset, char *buffer,
 	if (offset > self->size)
 		return ELIMIT;
 	*size = min(*size, self->size - offset);
+	if (*size == 0)
+		return EOK;
 	return block_read_bytes_direct(self->service_id, offset, *size, buffer);
 }
 
@@ -137,9 +139,9 @@ errno_t bithenge_new_block_blob(bithenge_node_t **out, service_id_t service_id)
 	}
 	blob->service_id = service_id;
 	blob->size = size;
-	*out = bithenge_blob_as_node(block_as_blob(blob));
 
-	return EOK;
+	// Small fields would otherwise each cost a device read
+	return bithenge_new_cached_blob(out, block_as_blob(blob));
 }
 
 /** @}
@@ -34,6 +34,7 @@
  * Sequence transforms.
  */
 
+#include <assert.h>
 #include <stdlib.h>
 #include <bithenge/blob.h>
 #include <bithenge/expression.h>
@@ -52,6 +53,9 @@ typedef struct {
 	bithenge_scope_t *scope;
 	aoff64_t *ends;
 	size_t num_ends;
+	size_t ends_size;
+	/** Results of subtransforms that are kept, or NULL if none are. */
+	bithenge_node_t **values;
 	bool end_on_empty;
 	bithenge_int_t num_xforms;
 } seq_node_t;
@@ -71,6 +75,26 @@ static seq_node_t *node_as_seq(bithenge_node_t *node)
 	return (seq_node_t *)node;
 }
 
+/** Make room for one more field end, growing the array geometrically so that
+ * long sequences do not cost a reallocation per field. */
+static errno_t seq_node_reserve_end(seq_node_t *self)
+{
+	if (self->num_ends < self->ends_size)
+		return EOK;
+
+	size_t new_size = max(16, 2 * self->ends_size);
+	if (self->num_xforms != -1)
+		new_size = min(new_size, (size_t) self->num_xforms);
+	new_size = max(new_size, self->num_ends + 1);
+
+	aoff64_t *new_ends = realloc(self->ends, new_size * sizeof(*new_ends));
+	if (!new_ends)
+		return ENOMEM;
+	self->ends = new_ends;
+	self->ends_size = new_size;
+	return EOK;
+}
+
 static errno_t seq_node_field_offset(seq_node_t *self, aoff64_t *out, size_t index)
 {
 	if (index == 0) {
@@ -120,13 +144,9 @@ static errno_t seq_node_field_offset(seq_node_t *self, aoff64_t *out, size_t ind
 		if (rc != EOK)
 			return rc;
 
-		if (self->num_xforms == -1) {
-			aoff64_t *new_ends = realloc(self->ends,
-			    (self->num_ends + 1) * sizeof(*new_ends));
-			if (!new_ends)
-				return ENOMEM;
-			self->ends = new_ends;
-		}
+		rc = seq_node_reserve_end(self);
+		if (rc != EOK)
+			return rc;
 
 		prev_offset = self->ends[self->num_ends] =
 		    prev_offset + field_size;
@@ -138,6 +158,12 @@ static errno_t seq_node_field_offset(seq_node_t *self, aoff64_t *out, size_t ind
 static errno_t seq_node_subtransform(seq_node_t *self, bithenge_node_t **out,
     size_t index)
 {
+	if (self->values && self->values[index]) {
+		bithenge_node_inc_ref(self->values[index]);
+		*out = self->values[index];
+		return EOK;
+	}
+
 	aoff64_t start_pos;
 	errno_t rc = seq_node_field_offset(self, &start_pos, index);
 	if (rc != EOK)
@@ -185,12 +211,10 @@ static errno_t seq_node_subtransform(seq_node_t *self, bithenge_node_t **out,
 		if (rc != EOK)
 			return rc;
 
-		if (self->num_xforms == -1) {
-			aoff64_t *new_ends = realloc(self->ends,
-			    (self->num_ends + 1) * sizeof(*new_ends));
-			if (!new_ends)
-				return ENOMEM;
-			self->ends = new_ends;
+		rc = seq_node_reserve_end(self);
+		if (rc != EOK) {
+			bithenge_node_dec_ref(*out);
+			return rc;
 		}
 		self->ends[self->num_ends++] = start_pos + size;
 	} else {
@@ -218,6 +242,16 @@ static errno_t seq_node_subtransform(seq_node_t *self, bithenge_node_t **out,
 			return rc;
 	}
 
+	/*
+	 * Internal nodes may refer back to our scope, so keeping them would
+	 * create a reference cycle.
+	 */
+	if (self->values &&
+	    bithenge_node_type(*out) != BITHENGE_NODE_INTERNAL) {
+		bithenge_node_inc_ref(*out);
+		self->values[index] = *out;
+	}
+
 	return EOK;
 }
 
@@ -239,6 +273,25 @@ static void seq_node_destroy(seq_node_t *self)
 	bithenge_scope_dec_ref(self->scope);
 	bithenge_blob_dec_ref(self->blob);
 	free(self->ends);
+	if (self->values) {
+		for (bithenge_int_t i = 0; i < self->num_xforms; i++)
+			bithenge_node_dec_ref(self->values[i]);
+		free(self->values);
+	}
+}
+
+/** Keep the results of subtransforms, so that fields referred to repeatedly,
+ * e.g. by expressions in later fields, are only decoded once. Only usable
+ * when the number of subtransforms is known. */
+static errno_t seq_node_memoize(seq_node_t *self)
+{
+	assert(self->num_xforms != -1);
+	if (self->num_xforms == 0)
+		return EOK;
+	self->values = calloc(self->num_xforms, sizeof(*self->values));
+	if (!self->values)
+		return ENOMEM;
+	return EOK;
 }
 
 static void seq_node_set_num_xforms(seq_node_t *self,
@@ -257,12 +310,9 @@ static errno_t seq_node_init(seq_node_t *self, const seq_node_ops_t *ops,
     bool end_on_empty)
 {
 	self->ops = ops;
-	if (num_xforms != -1) {
-		self->ends = malloc(sizeof(*self->ends) * num_xforms);
-		if (!self->ends)
-			return ENOMEM;
-	} else
-		self->ends = NULL;
+	self->ends = NULL;
+	self->ends_size = 0;
+	self->values = NULL;
 	bithenge_blob_inc_ref(blob);
 	self->blob = blob;
 	self->num_xforms = num_xforms;
@@ -506,6 +556,14 @@ static errno_t struct_transform_make_node(struct_transform_t *self,
 		return rc;
 	}
 
+	rc = seq_node_memoize(struct_as_seq(node));
+	if (rc != EOK) {
+		seq_node_destroy(struct_as_seq(node));
+		bithenge_scope_dec_ref(inner);
+		free(node);
+		return rc;
+	}
+
 	bithenge_transform_inc_ref(struct_as_transform(self));
 	node->transform = self;
 	node->prefix = prefix;
@@ -43,16 +43,22 @@
 #include <as.h>
 #include <assert.h>
 #include <bd.h>
+#include <fibril.h>
 #include <fibril_synch.h>
 #include <adt/list.h>
+#include <adt/hash.h>
 #include <adt/hash_table.h>
+#include <adt/ohash_table.h>
+#include <align.h>
 #include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stacktrace.h>
+#include <str.h>
 #include <str_error.h>
 #include <offset.h>
+#include <qsort.h>
 #include <inttypes.h>
 #include "block.h"
 
@@ -63,15 +69,58 @@ static FIBRIL_MUTEX_INITIALIZE(dcl_lock);
 /** Device connection list head. */
 static LIST_INITIALIZE(dcl);
 
+/*
+ * The cache is divided into shards, each with its own lock, hash table and
+ * lists of unused blocks. Runs of BLOCK_SHARD_RUN consecutive blocks belong
+ * to the same shard, so that reading ahead only involves one shard.
+ */
+#define BLOCK_CACHE_SHARDS	8
+#define BLOCK_SHARD_RUN		32
+
+/** Number of recently evicted cold blocks remembered by each shard. */
+#define BLOCK_GHOSTS	32
+
 typedef struct {
 	fibril_mutex_t lock;
+	ohash_table_t block_hash;
+	/** Unused blocks used only once since loaded, oldest first. */
+	list_t cold_list;
+	/** Unused blocks used repeatedly, least recently used first. */
+	list_t hot_list;
+	unsigned blocks_cached;   /**< Number of cached blocks. */
+	unsigned hot_cached;      /**< Number of cached hot blocks. */
+	unsigned capacity;        /**< Number of blocks the shard should hold. */
+	/** Ring of addresses of recently evicted cold blocks. */
+	aoff64_t ghosts[BLOCK_GHOSTS];
+	unsigned ghosts_next;
+	unsigned ghosts_count;
+	/** Number of passes of the flusher over the shard. */
+	unsigned flush_gen;
+	/** Number of blocks left dirty since the last flusher pass. */
+	unsigned dirty_puts;
+	block_cache_stats_t stats;
+} cache_shard_t;
+
+typedef struct {
 	size_t lblock_size;       /**< Logical block size. */
 	unsigned blocks_cluster;  /**< Physical blocks per block_t */
-	unsigned block_count;     /**< Total number of blocks. */
-	unsigned blocks_cached;   /**< Number of cached blocks. */
-	hash_table_t block_hash;
-	list_t free_list;
 	enum cache_mode mode;
+	cache_shard_t shards[BLOCK_CACHE_SHARDS];
+	/** Protects the read-ahead state. */
+	fibril_mutex_t ra_lock;
+	/** Block expected to be missed next by a sequential reader. */
+	aoff64_t ra_next;
+	/** Number of blocks to read ahead of the next sequential miss. */
+	size_t ra_window;
+	/** Protects the flusher state. */
+	fibril_mutex_t flush_lock;
+	fibril_condvar_t flush_cv;
+	/** Flusher fibril of a write-back cache or zero. */
+	fid_t flusher;
+	bool flusher_stop;
+	bool flusher_done;
+	/** All dirty blocks should be written back as soon as possible. */
+	bool flush_urgent;
 } cache_t;
 
 typedef struct {
@@ -84,10 +133,19 @@ typedef struct {
 	aoff64_t pblocks;    /**< Number of physical blocks */
 	size_t pblock_size;  /**< Physical block size. */
 	cache_t *cache;
+	/** Buffer shared with the device for vectored writes or NULL. */
+	void *flush_buf;
+	/** Serializes use of flush_buf. */
+	fibril_mutex_t flush_buf_lock;
+	/** Image of a device mapped into memory or NULL. */
+	void *image;
 } devcon_t;
 
 static errno_t read_blocks(devcon_t *, aoff64_t, size_t, void *, size_t);
 static errno_t write_blocks(devcon_t *, aoff64_t, size_t, void *, size_t);
+static void flusher_start(devcon_t *);
+static void flusher_stop(cache_t *);
+static void flusher_wakeup(cache_t *);
 static aoff64_t ba_ltop(devcon_t *, aoff64_t);
 
 static devcon_t *devcon_search(service_id_t service_id)
@@ -123,6 +181,9 @@ static errno_t devcon_add(service_id_t service_id, async_sess_t *sess,
 	devcon->pblock_size = bsize;
 	devcon->pblocks = dev_size;
 	devcon->cache = NULL;
+	devcon->flush_buf = NULL;
+	fibril_mutex_initialize(&devcon->flush_buf_lock);
+	devcon->image = NULL;
 
 	fibril_mutex_lock(&dcl_lock);
 	list_foreach(dcl, link, devcon_t, d) {
@@ -144,6 +205,37 @@ static void devcon_remove(devcon_t *devcon)
 	fibril_mutex_unlock(&dcl_lock);
 }
 
+/** Get pointer to blocks in the image of a mapped device.
+ *
+ * @param devcon	Device connection with a mapped image.
+ * @param ba		Physical address of first block.
+ * @param size		Number of bytes.
+ *
+ * @return		Pointer into the image or NULL if the range lies
+ *			past the end of the device.
+ */
+static void *block_image_data(devcon_t *devcon, aoff64_t ba, size_t size)
+{
+	assert(devcon->image != NULL);
+
+	if (ba > devcon->pblocks)
+		return NULL;
+
+	size_t offs = ba * devcon->pblock_size;
+	if (size > devcon->pblocks * devcon->pblock_size - offs)
+		return NULL;
+
+	return (uint8_t *) devcon->image + offs;
+}
+
+/** Free a block along with its data, unless it points into an image. */
+static void block_free(devcon_t *devcon, block_t *b)
+{
+	if (devcon->image == NULL)
+		free(b->data);
+	free(b);
+}
+
 errno_t block_init(service_id_t service_id, size_t comm_size)
 {
 	bd_t *bd;
@@ -183,6 +275,19 @@ errno_t block_init(service_id_t service_id, size_t comm_size)
 		return rc;
 	}
 
+	/*
+	 * A device residing in memory can be mapped. Cached blocks then
+	 * point straight into its image and I/O amounts to plain copying.
+	 */
+	if (bsize != 0 && dev_size <= (SIZE_MAX - PAGE_SIZE) / bsize) {
+		devcon_t *devcon = devcon_search(service_id);
+		size_t image_size = ALIGN_UP(dev_size * bsize, PAGE_SIZE);
+		void *image;
+
+		if (image_size != 0 && bd_map(bd, image_size, &image) == EOK)
+			devcon->image = image;
+	}
+
 	return EOK;
 }
 
@@ -204,6 +309,11 @@ void block_fini(service_id_t service_id)
 	bd_close(devcon->bd);
 	async_hangup(devcon->sess);
 
+	if (devcon->flush_buf != NULL)
+		as_area_destroy(devcon->flush_buf);
+	if (devcon->image != NULL)
+		as_area_destroy(devcon->image);
+
 	free(devcon);
 }
 
@@ -267,6 +377,23 @@ static const hash_table_ops_t cache_ops = {
 	.remove_callback = NULL
 };
 
+/** Cache size used when the file system does not ask for a particular one. */
+#define BLOCK_CACHE_DEFAULT_SIZE	(2 * 1024 * 1024)
+/** The cache holds at least this many blocks, whatever its size in bytes. */
+#define BLOCK_CACHE_MIN_BLOCKS		(8 * BLOCK_CACHE_SHARDS)
+
+static cache_shard_t *shard_of(cache_t *cache, aoff64_t lba)
+{
+	size_t run = hash_mix((size_t) (lba / BLOCK_SHARD_RUN));
+	return &cache->shards[run % BLOCK_CACHE_SHARDS];
+}
+
+static unsigned shard_capacity(size_t blocks)
+{
+	blocks = max(blocks, (size_t) BLOCK_CACHE_MIN_BLOCKS);
+	return (blocks + BLOCK_CACHE_SHARDS - 1) / BLOCK_CACHE_SHARDS;
+}
+
 errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
     enum cache_mode mode)
 {
@@ -280,12 +407,11 @@ errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
 	if (!cache)
 		return ENOMEM;
 
-	fibril_mutex_initialize(&cache->lock);
-	list_initialize(&cache->free_list);
 	cache->lblock_size = size;
-	cache->block_count = blocks;
-	cache->blocks_cached = 0;
 	cache->mode = mode;
+	fibril_mutex_initialize(&cache->ra_lock);
+	cache->ra_next = 0;
+	cache->ra_window = 0;
 
 	/* Allow 1:1 or small-to-large block size translation */
 	if (cache->lblock_size % devcon->pblock_size != 0) {
@@ -295,12 +421,60 @@ errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
 
 	cache->blocks_cluster = cache->lblock_size / devcon->pblock_size;
 
-	if (!hash_table_create(&cache->block_hash, 0, 0, &cache_ops)) {
-		free(cache);
-		return ENOMEM;
+	if (blocks == 0)
+		blocks = BLOCK_CACHE_DEFAULT_SIZE / size;
+
+	for (unsigned i = 0; i < BLOCK_CACHE_SHARDS; i++) {
+		cache_shard_t *shard = &cache->shards[i];
+
+		fibril_mutex_initialize(&shard->lock);
+		list_initialize(&shard->cold_list);
+		list_initialize(&shard->hot_list);
+		shard->blocks_cached = 0;
+		shard->hot_cached = 0;
+		shard->capacity = shard_capacity(blocks);
+		shard->ghosts_next = 0;
+		shard->ghosts_count = 0;
+		shard->flush_gen = 0;
+		shard->dirty_puts = 0;
+		memset(&shard->stats, 0, sizeof(shard->stats));
+
+		if (!ohash_table_create(&shard->block_hash, 0, &cache_ops)) {
+			while (i-- > 0)
+				ohash_table_destroy(&cache->shards[i].block_hash);
+			free(cache);
+			return ENOMEM;
+		}
 	}
 
 	devcon->cache = cache;
+	flusher_start(devcon);
+	return EOK;
+}
+
+static errno_t shard_drain(devcon_t *devcon, cache_shard_t *shard,
+    list_t *list)
+{
+	cache_t *cache = devcon->cache;
+	errno_t rc;
+
+	while (!list_empty(list)) {
+		block_t *b = list_get_instance(list_first(list), block_t,
+		    free_link);
+
+		list_remove(&b->free_link);
+		if (b->dirty) {
+			rc = write_blocks(devcon, b->pba, cache->blocks_cluster,
+			    b->data, b->size);
+			if (rc != EOK)
+				return rc;
+		}
+
+		ohash_table_remove_item(&shard->block_hash, &b->hash_link);
+
+		block_free(devcon, b);
+	}
+
 	return EOK;
 }
 
@@ -316,45 +490,212 @@ errno_t block_cache_fini(service_id_t service_id)
 		return EOK;
 	cache = devcon->cache;
 
+	flusher_stop(cache);
+
 	/*
 	 * We are expecting to find all blocks for this device handle on the
-	 * free list, i.e. the block reference count should be zero. Do not
-	 * bother with the cache and block locks because we are single-threaded.
+	 * lists of unused blocks, i.e. the block reference count should be
+	 * zero. Do not bother with the cache and block locks because we are
+	 * single-threaded.
 	 */
-	while (!list_empty(&cache->free_list)) {
-		block_t *b = list_get_instance(list_first(&cache->free_list),
-		    block_t, free_link);
+	for (unsigned i = 0; i < BLOCK_CACHE_SHARDS; i++) {
+		cache_shard_t *shard = &cache->shards[i];
 
-		list_remove(&b->free_link);
-		if (b->dirty) {
-			rc = write_blocks(devcon, b->pba, cache->blocks_cluster,
-			    b->data, b->size);
-			if (rc != EOK)
-				return rc;
-		}
-
-		hash_table_remove_item(&cache->block_hash, &b->hash_link);
-
-		free(b->data);
-		free(b);
+		rc = shard_drain(devcon, shard, &shard->cold_list);
+		if (rc != EOK)
+			return rc;
+		rc = shard_drain(devcon, shard, &shard->hot_list);
+		if (rc != EOK)
+			return rc;
 	}
 
-	hash_table_destroy(&cache->block_hash);
+	for (unsigned i = 0; i < BLOCK_CACHE_SHARDS; i++)
+		ohash_table_destroy(&cache->shards[i].block_hash);
+
 	devcon->cache = NULL;
 	free(cache);
 
 	return EOK;
 }
 
-#define CACHE_LO_WATERMARK	10
-#define CACHE_HI_WATERMARK	20
-static bool cache_can_grow(cache_t *cache)
+/** Change the size of a block cache.
+ *
+ * Blocks beyond the new size are dropped as they fall out of use.
+ *
+ * @param service_id	Service ID of the block device
+ * @param size		New size of the cache in bytes
+ *
+ * @return		EOK on success, ENOENT if the device has no cache.
+ */
+errno_t block_cache_resize(service_id_t service_id, size_t size)
 {
-	if (cache->blocks_cached < CACHE_LO_WATERMARK)
-		return true;
-	if (!list_empty(&cache->free_list))
-		return false;
-	return true;
+	devcon_t *devcon = devcon_search(service_id);
+	if (devcon == NULL || devcon->cache == NULL)
+		return ENOENT;
+
+	cache_t *cache = devcon->cache;
+	unsigned capacity = shard_capacity(size / cache->lblock_size);
+
+	for (unsigned i = 0; i < BLOCK_CACHE_SHARDS; i++) {
+		fibril_mutex_lock(&cache->shards[i].lock);
+		cache->shards[i].capacity = capacity;
+		fibril_mutex_unlock(&cache->shards[i].lock);
+	}
+
+	return EOK;
+}
+
+/** Get statistics of a block cache.
+ *
+ * @param service_id	Service ID of the block device
+ * @param stats		Place to store the statistics
+ *
+ * @return		EOK on success, ENOENT if the device has no cache.
+ */
+errno_t block_cache_stats(service_id_t service_id, block_cache_stats_t *stats)
+{
+	devcon_t *devcon = devcon_search(service_id);
+	if (devcon == NULL || devcon->cache == NULL)
+		return ENOENT;
+
+	cache_t *cache = devcon->cache;
+	memset(stats, 0, sizeof(*stats));
+
+	for (unsigned i = 0; i < BLOCK_CACHE_SHARDS; i++) {
+		cache_shard_t *shard = &cache->shards[i];
+
+		fibril_mutex_lock(&shard->lock);
+		stats->hits += shard->stats.hits;
+		stats->misses += shard->stats.misses;
+		stats->evictions += shard->stats.evictions;
+		stats->writebacks += shard->stats.writebacks;
+		stats->ra_blocks += shard->stats.ra_blocks;
+		stats->ra_hits += shard->stats.ra_hits;
+		stats->ra_wasted += shard->stats.ra_wasted;
+		stats->blocks += shard->blocks_cached;
+		stats->capacity += shard->capacity;
+		fibril_mutex_unlock(&shard->lock);
+	}
+
+	fibril_mutex_lock(&cache->ra_lock);
+	stats->ra_window = cache->ra_window;
+	fibril_mutex_unlock(&cache->ra_lock);
+
+	return EOK;
+}
+
+/** Parse the size of a block cache.
+ *
+ * @param str		Size in bytes, optionally followed by k, M or G
+ * @param size		Place to store the size in bytes
+ *
+ * @return		EOK on success, EINVAL if @a str is not a valid size.
+ */
+errno_t block_cache_size_parse(const char *str, size_t *size)
+{
+	const char *end;
+	uint64_t value;
+
+	errno_t rc = str_uint64_t(str, &end, 10, false, &value);
+	if (rc != EOK)
+		return EINVAL;
+
+	switch (*end) {
+	case 'G':
+	case 'g':
+		value *= 1024;
+		/* Fallthrough */
+	case 'M':
+	case 'm':
+		value *= 1024;
+		/* Fallthrough */
+	case 'K':
+	case 'k':
+		value *= 1024;
+		end++;
+		break;
+	default:
+		break;
+	}
+
+	if (*end != '\0' || value == 0 || value > SIZE_MAX)
+		return EINVAL;
+
+	*size = value;
+	return EOK;
+}
+
+/*
+ * Eviction is scan resistant. A block loaded into the cache is cold until
+ * it is used again, which makes it hot. Unused cold blocks are evicted in
+ * the order in which they were loaded, so that a scan of the device only
+ * replaces other cold blocks. Unused hot blocks are evicted in LRU order
+ * when hot blocks take more than BLOCK_HOT_SHARE of the cache, or when there
+ * is no cold block to evict. The addresses of recently evicted cold blocks
+ * are remembered, and such a block becomes hot right away when it is loaded
+ * again.
+ */
+#define BLOCK_HOT_SHARE(capacity)	((capacity) * 3 / 4)
+
+static bool ghost_remove(cache_shard_t *shard, aoff64_t lba)
+{
+	for (unsigned i = 0; i < shard->ghosts_count; i++) {
+		if (shard->ghosts[i] == lba) {
+			/* Replace it by the most recent one. */
+			unsigned last = (shard->ghosts_next + BLOCK_GHOSTS - 1) %
+			    BLOCK_GHOSTS;
+			shard->ghosts[i] = shard->ghosts[last];
+			shard->ghosts[last] = (aoff64_t) -1;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void ghost_add(cache_shard_t *shard, aoff64_t lba)
+{
+	shard->ghosts[shard->ghosts_next] = lba;
+	shard->ghosts_next = (shard->ghosts_next + 1) % BLOCK_GHOSTS;
+	if (shard->ghosts_count < BLOCK_GHOSTS)
+		shard->ghosts_count++;
+}
+
+/** Choose an unused block to evict, or NULL if there is none. */
+static block_t *shard_victim(cache_shard_t *shard)
+{
+	list_t *list;
+
+	if (shard->hot_cached > BLOCK_HOT_SHARE(shard->capacity) &&
+	    !list_empty(&shard->hot_list))
+		list = &shard->hot_list;
+	else if (!list_empty(&shard->cold_list))
+		list = &shard->cold_list;
+	else if (!list_empty(&shard->hot_list))
+		list = &shard->hot_list;
+	else
+		return NULL;
+
+	return list_get_instance(list_first(list), block_t, free_link);
+}
+
+/** Update the shard's bookkeeping for a block leaving the cache. */
+static void shard_evicted(cache_t *cache, cache_shard_t *shard, block_t *b)
+{
+	if (b->hot)
+		shard->hot_cached--;
+	else
+		ghost_add(shard, b->lba);
+
+	if (b->readahead) {
+		/* Read too far ahead, shrink the window. */
+		shard->stats.ra_wasted++;
+		fibril_mutex_lock(&cache->ra_lock);
+		cache->ra_window /= 2;
+		fibril_mutex_unlock(&cache->ra_lock);
+	}
+
+	shard->stats.evictions++;
 }
 
 static void block_initialize(block_t *b)
@@ -364,10 +705,177 @@ static void block_initialize(block_t *b)
 	b->write_failures = 0;
 	b->dirty = false;
 	b->toxic = false;
+	b->readahead = false;
+	b->hot = false;
+	b->dirty_gen = 0;
 	fibril_rwlock_initialize(&b->contents_lock);
 	link_initialize(&b->free_link);
 }
 
+/*
+ * Sequential misses are detected per device. Each sequential miss reads the
+ * missed block together with a window of the blocks following it in one
+ * request to the device. The window starts at BLOCK_RA_MIN blocks and doubles
+ * with each sequential miss up to BLOCK_RA_MAX blocks or BLOCK_RA_MAX_BYTES.
+ * Read-ahead blocks are put on the cold list without being used, and halve
+ * the window if they are evicted before being used. Reading ahead stops at
+ * the end of the run of blocks belonging to the missed block's shard.
+ */
+#define BLOCK_RA_MIN		2
+#define BLOCK_RA_MAX		BLOCK_SHARD_RUN
+#define BLOCK_RA_MAX_BYTES	(128 * 1024)
+
+static size_t readahead_max(cache_t *cache)
+{
+	size_t blocks = BLOCK_RA_MAX_BYTES / cache->lblock_size;
+	return max(min(blocks, (size_t) BLOCK_RA_MAX), (size_t) 1);
+}
+
+/** Instantiate blocks to be read ahead of a missed block.
+ *
+ * Must be called with the shard's lock held. The returned blocks are in the
+ * cache and on the shard's cold list, with their locks held.
+ *
+ * @param devcon	Device connection
+ * @param shard		Shard of the missed block
+ * @param ba		Logical address of the missed block
+ * @param blocks	Array of BLOCK_RA_MAX entries for the blocks
+ *
+ * @return		Number of blocks to be read ahead.
+ */
+static size_t readahead_prepare(devcon_t *devcon, cache_shard_t *shard,
+    aoff64_t ba, block_t **blocks)
+{
+	cache_t *cache = devcon->cache;
+	size_t max_window = readahead_max(cache);
+
+	fibril_mutex_lock(&cache->ra_lock);
+	if (ba == cache->ra_next) {
+		cache->ra_window = (cache->ra_window == 0) ? BLOCK_RA_MIN :
+		    min(2 * cache->ra_window, max_window);
+	} else {
+		cache->ra_window = 0;
+	}
+	size_t window = cache->ra_window;
+	fibril_mutex_unlock(&cache->ra_lock);
+
+	size_t n;
+	for (n = 0; n < window; n++) {
+		aoff64_t lba = ba + 1 + n;
+
+		if (lba / BLOCK_SHARD_RUN != ba / BLOCK_SHARD_RUN)
+			break;
+		if (ba_ltop(devcon, lba) + cache->blocks_cluster > devcon->pblocks)
+			break;
+		if (ohash_table_find(&shard->block_hash, &lba) != NULL)
+			break;
+
+		block_t *b;
+		if (shard->blocks_cached < shard->capacity) {
+			b = malloc(sizeof(block_t));
+			if (b == NULL)
+				break;
+			b->data = malloc(cache->lblock_size);
+			if (b->data == NULL) {
+				free(b);
+				break;
+			}
+			shard->blocks_cached++;
+		} else {
+			/*
+			 * Only replace a clean cold block nobody is working
+			 * with, never a hot one.
+			 */
+			if (list_empty(&shard->cold_list))
+				break;
+			b = list_get_instance(list_first(&shard->cold_list),
+			    block_t, free_link);
+			if (!fibril_mutex_trylock(&b->lock))
+				break;
+			if (b->dirty) {
+				fibril_mutex_unlock(&b->lock);
+				break;
+			}
+			fibril_mutex_unlock(&b->lock);
+
+			list_remove(&b->free_link);
+			ohash_table_remove_item(&shard->block_hash, &b->hash_link);
+			shard_evicted(cache, shard, b);
+		}
+
+		block_initialize(b);
+		b->refcnt = 0;
+		b->readahead = true;
+		b->service_id = devcon->service_id;
+		b->size = cache->lblock_size;
+		b->lba = lba;
+		b->pba = ba_ltop(devcon, lba);
+		if (ohash_table_insert(&shard->block_hash, &b->hash_link) != EOK) {
+			free(b->data);
+			free(b);
+			shard->blocks_cached--;
+			break;
+		}
+
+		list_append(&b->free_link, &shard->cold_list);
+		fibril_mutex_lock(&b->lock);
+		blocks[n] = b;
+	}
+
+	fibril_mutex_lock(&cache->ra_lock);
+	cache->ra_next = ba + 1 + n;
+	fibril_mutex_unlock(&cache->ra_lock);
+
+	shard->stats.ra_blocks += n;
+	return n;
+}
+
+/** Read a missed block together with the blocks read ahead of it.
+ *
+ * @param devcon	Device connection
+ * @param b		Missed block, locked
+ * @param blocks	Blocks following @a b, locked
+ * @param cnt		Number of blocks in @a blocks
+ *
+ * @return		EOK on success or an error code reading @a b.
+ */
+static errno_t readahead_read(devcon_t *devcon, block_t *b, block_t **blocks,
+    size_t cnt)
+{
+	cache_t *cache = devcon->cache;
+	size_t bsize = cache->lblock_size;
+	errno_t rc = ENOMEM;
+
+	uint8_t *buf = malloc((cnt + 1) * bsize);
+	if (buf != NULL) {
+		rc = read_blocks(devcon, b->pba, (cnt + 1) * cache->blocks_cluster,
+		    buf, (cnt + 1) * bsize);
+	}
+
+	if (rc == EOK) {
+		memcpy(b->data, buf, bsize);
+		for (size_t i = 0; i < cnt; i++)
+			memcpy(blocks[i]->data, buf + (i + 1) * bsize, bsize);
+	} else {
+		/* Fall back to reading the blocks one by one. */
+		rc = read_blocks(devcon, b->pba, cache->blocks_cluster,
+		    b->data, bsize);
+		for (size_t i = 0; i < cnt; i++) {
+			if (read_blocks(devcon, blocks[i]->pba,
+			    cache->blocks_cluster, blocks[i]->data,
+			    bsize) != EOK)
+				blocks[i]->toxic = true;
+		}
+	}
+
+	free(buf);
+
+	for (size_t i = 0; i < cnt; i++)
+		fibril_mutex_unlock(&blocks[i]->lock);
+
+	return rc;
+}
+
 /** Instantiate a block in memory and get a reference to it.
  *
  * @param block			Pointer to where the function will store the
@@ -384,8 +892,10 @@ errno_t block_get(block_t **block, service_id_t service_id, aoff64_t ba, int fla
 {
 	devcon_t *devcon;
 	cache_t *cache;
+	cache_shard_t *shard;
 	block_t *b;
-	link_t *link;
+	block_t *ra_blocks[BLOCK_RA_MAX];
+	size_t ra_cnt = 0;
 	aoff64_t p_ba;
 	errno_t rc;
 
@@ -395,6 +905,7 @@ errno_t block_get(block_t **block, service_id_t service_id, aoff64_t ba, int fla
 	assert(devcon->cache);
 
 	cache = devcon->cache;
+	shard = shard_of(cache, ba);
 
 	/*
 	 * Check whether the logical block (or part of it) is beyond
@@ -411,8 +922,8 @@ retry:
 	rc = EOK;
 	b = NULL;
 
-	fibril_mutex_lock(&cache->lock);
-	ht_link_t *hlink = hash_table_find(&cache->block_hash, &ba);
+	fibril_mutex_lock(&shard->lock);
+	ht_link_t *hlink = ohash_table_find(&shard->block_hash, &ba);
 	if (hlink) {
 	found:
 		/*
@@ -422,57 +933,81 @@ retry:
 		fibril_mutex_lock(&b->lock);
 		if (b->refcnt++ == 0)
 			list_remove(&b->free_link);
+		if (b->readahead) {
+			/* The first use of a block read ahead keeps it cold. */
+			b->readahead = false;
+			shard->stats.ra_hits++;
+		} else if (!b->hot) {
+			b->hot = true;
+			shard->hot_cached++;
+		}
 		if (b->toxic)
 			rc = EIO;
+		shard->stats.hits++;
 		fibril_mutex_unlock(&b->lock);
-		fibril_mutex_unlock(&cache->lock);
+		fibril_mutex_unlock(&shard->lock);
 	} else {
 		/*
 		 * The block was not found in the cache.
 		 */
-		if (cache_can_grow(cache)) {
+		bool hot = ghost_remove(shard, ba);
+		block_t *victim = NULL;
+
+		if (shard->blocks_cached >= shard->capacity)
+			victim = shard_victim(shard);
+
+		if (victim == NULL) {
 			/*
-			 * We can grow the cache by allocating new blocks.
-			 * Should the allocation fail, we fail over and try to
-			 * recycle a block from the cache.
+			 * We can grow the cache by allocating new blocks,
+			 * either because it is not full or because all of
+			 * its blocks are in use. Should the allocation fail,
+			 * we fail over and try to recycle a block from the
+			 * cache.
 			 */
 			b = malloc(sizeof(block_t));
 			if (!b)
 				goto recycle;
-			b->data = malloc(cache->lblock_size);
-			if (!b->data) {
+			/* Blocks of a mapped device point into its image. */
+			if (devcon->image != NULL)
+				b->data = NULL;
+			else
+				b->data = malloc(cache->lblock_size);
+			if (devcon->image == NULL && !b->data) {
 				free(b);
 				b = NULL;
 				goto recycle;
 			}
-			cache->blocks_cached++;
+			shard->blocks_cached++;
 		} else {
 			/*
-			 * Try to recycle a block from the free list.
+			 * Try to recycle an unused block.
 			 */
 		recycle:
-			if (list_empty(&cache->free_list)) {
-				fibril_mutex_unlock(&cache->lock);
+			if (victim == NULL)
+				victim = shard_victim(shard);
+			if (victim == NULL) {
+				fibril_mutex_unlock(&shard->lock);
 				rc = ENOMEM;
 				goto out;
 			}
-			link = list_first(&cache->free_list);
-			b = list_get_instance(link, block_t, free_link);
+			b = victim;
 
 			fibril_mutex_lock(&b->lock);
 			if (b->dirty) {
 				/*
 				 * The block needs to be written back to the
 				 * device before it changes identity. Do this
-				 * while not holding the cache lock so that
+				 * while not holding the shard lock so that
 				 * concurrency is not impeded. Also move the
-				 * block to the end of the free list so that we
+				 * block to the end of its list so that we
 				 * do not slow down other instances of
-				 * block_get() draining the free list.
+				 * block_get() looking for a victim.
 				 */
+				list_t *list = b->hot ? &shard->hot_list :
+				    &shard->cold_list;
 				list_remove(&b->free_link);
-				list_append(&b->free_link, &cache->free_list);
-				fibril_mutex_unlock(&cache->lock);
+				list_append(&b->free_link, list);
+				fibril_mutex_unlock(&shard->lock);
 				rc = write_blocks(devcon, b->pba,
 				    cache->blocks_cluster, b->data, b->size);
 				if (rc != EOK) {
@@ -496,7 +1031,7 @@ retry:
 					b->write_failures = 0;
 
 				b->dirty = false;
-				if (!fibril_mutex_trylock(&cache->lock)) {
+				if (!fibril_mutex_trylock(&shard->lock)) {
 					/*
 					 * Somebody is probably racing with us.
 					 * Unlock the block and retry.
@@ -504,14 +1039,15 @@ retry:
 					fibril_mutex_unlock(&b->lock);
 					goto retry;
 				}
-				hlink = hash_table_find(&cache->block_hash, &ba);
+				shard->stats.writebacks++;
+				hlink = ohash_table_find(&shard->block_hash, &ba);
 				if (hlink) {
 					/*
 					 * Someone else must have already
 					 * instantiated the block while we were
-					 * not holding the cache lock.
-					 * Leave the recycled block on the
-					 * freelist and continue as if we
+					 * not holding the shard lock.
+					 * Leave the recycled block on its
+					 * list and continue as if we
 					 * found the block of interest during
 					 * the first try.
 					 */
@@ -523,11 +1059,11 @@ retry:
 			fibril_mutex_unlock(&b->lock);
 
 			/*
-			 * Unlink the block from the free list and the hash
-			 * table.
+			 * Unlink the block from its list and the hash table.
 			 */
 			list_remove(&b->free_link);
-			hash_table_remove_item(&cache->block_hash, &b->hash_link);
+			ohash_table_remove_item(&shard->block_hash, &b->hash_link);
+			shard_evicted(cache, shard, b);
 		}
 
 		block_initialize(b);
@@ -535,23 +1071,59 @@ retry:
 		b->size = cache->lblock_size;
 		b->lba = ba;
 		b->pba = ba_ltop(devcon, b->lba);
-		hash_table_insert(&cache->block_hash, &b->hash_link);
+		rc = ohash_table_insert(&shard->block_hash, &b->hash_link);
+		if (rc != EOK) {
+			/*
+			 * Only a newly allocated block can fail to be inserted,
+			 * a recycled one has just freed its slot.
+			 */
+			block_free(devcon, b);
+			b = NULL;
+			shard->blocks_cached--;
+			fibril_mutex_unlock(&shard->lock);
+			goto out;
+		}
+
+		b->hot = hot;
+		if (hot)
+			shard->hot_cached++;
+		shard->stats.misses++;
 
 		/*
-		 * Lock the block before releasing the cache lock. Thus we don't
+		 * Lock the block before releasing the shard lock. Thus we don't
 		 * kill concurrent operations on the cache while doing I/O on
 		 * the block.
 		 */
 		fibril_mutex_lock(&b->lock);
-		fibril_mutex_unlock(&cache->lock);
+		if (!(flags & BLOCK_FLAGS_NOREAD) && devcon->image == NULL)
+			ra_cnt = readahead_prepare(devcon, shard, ba, ra_blocks);
+		fibril_mutex_unlock(&shard->lock);
 
-		if (!(flags & BLOCK_FLAGS_NOREAD)) {
+		if (devcon->image != NULL) {
+			/*
+			 * The block already holds the contents of the mapped
+			 * device unless it lies past its end.
+			 */
+			b->data = block_image_data(devcon, b->pba, b->size);
+			if (b->data != NULL) {
+				rc = EOK;
+			} else {
+				rc = ELIMIT;
+				b->toxic = true;
+			}
+		} else if (!(flags & BLOCK_FLAGS_NOREAD)) {
 			/*
 			 * The block contains old or no data. We need to read
 			 * the new contents from the device.
 			 */
-			rc = read_blocks(devcon, b->pba, cache->blocks_cluster,
-			    b->data, cache->lblock_size);
+			if (ra_cnt > 0) {
+				rc = readahead_read(devcon, b, ra_blocks,
+				    ra_cnt);
+			} else {
+				rc = read_blocks(devcon, b->pba,
+				    cache->blocks_cluster, b->data,
+				    cache->lblock_size);
+			}
 			if (rc != EOK)
 				b->toxic = true;
 		} else
@@ -571,7 +1143,8 @@ out:
 
 /** Release a reference to a block.
  *
- * If the last reference is dropped, the block is put on the free list.
+ * If the last reference is dropped, the block is put on the list of unused
+ * blocks.
  *
  * @param block		Block of which a reference is to be released.
  *
@@ -581,8 +1154,9 @@ errno_t block_put(block_t *block)
 {
 	devcon_t *devcon = devcon_search(block->service_id);
 	cache_t *cache;
-	unsigned blocks_cached;
-	enum cache_mode mode;
+	cache_shard_t *shard;
+	bool over;
+	bool written = false;
 	errno_t rc = EOK;
 
 	assert(devcon);
@@ -590,43 +1164,49 @@ errno_t block_put(block_t *block)
 	assert(block->refcnt >= 1);
 
 	cache = devcon->cache;
+	shard = shard_of(cache, block->lba);
 
 retry:
-	fibril_mutex_lock(&cache->lock);
-	blocks_cached = cache->blocks_cached;
-	mode = cache->mode;
-	fibril_mutex_unlock(&cache->lock);
+	fibril_mutex_lock(&shard->lock);
+	over = shard->blocks_cached > shard->capacity;
+	fibril_mutex_unlock(&shard->lock);
 
 	/*
 	 * Determine whether to sync the block. Syncing the block is best done
-	 * when not holding the cache lock as it does not impede concurrency.
-	 * Since the situation may have changed when we unlocked the cache, the
-	 * blocks_cached and mode variables are mere hints. We will recheck the
-	 * conditions later when the cache lock is held again.
+	 * when not holding the shard lock as it does not impede concurrency.
+	 * Since the situation may have changed when we unlocked the shard, the
+	 * over variable is a mere hint. We will recheck the conditions later
+	 * when the shard lock is held again.
 	 */
 	fibril_mutex_lock(&block->lock);
 	if (block->toxic)
 		block->dirty = false;	/* will not write back toxic block */
+	if (devcon->image != NULL)
+		block->dirty = false;	/* already in the mapped image */
 	if (block->dirty && (block->refcnt == 1) &&
-	    (blocks_cached > CACHE_HI_WATERMARK || mode != CACHE_MODE_WB)) {
+	    (over || cache->mode != CACHE_MODE_WB)) {
 		rc = write_blocks(devcon, block->pba, cache->blocks_cluster,
 		    block->data, block->size);
 		if (rc == EOK)
 			block->write_failures = 0;
 		block->dirty = false;
+		written = true;
 	}
 	fibril_mutex_unlock(&block->lock);
 
-	fibril_mutex_lock(&cache->lock);
+	fibril_mutex_lock(&shard->lock);
+	if (written) {
+		shard->stats.writebacks++;
+		written = false;
+	}
 	fibril_mutex_lock(&block->lock);
 	if (!--block->refcnt) {
 		/*
 		 * Last reference to the block was dropped. Either free the
-		 * block or put it on the free list. In case of an I/O error,
-		 * free the block.
+		 * block or put it on the list of unused blocks. In case of an
+		 * I/O error, free the block.
 		 */
-		if ((cache->blocks_cached > CACHE_HI_WATERMARK) ||
-		    (rc != EOK)) {
+		if ((shard->blocks_cached > shard->capacity) || (rc != EOK)) {
 			/*
 			 * Currently there are too many cached blocks or there
 			 * was an I/O error when writing the block back to the
@@ -635,14 +1215,14 @@ retry:
 			if (block->dirty) {
 				/*
 				 * We cannot sync the block while holding the
-				 * cache lock. Release everything and retry.
+				 * shard lock. Release everything and retry.
 				 */
 				block->refcnt++;
 
 				if (block->write_failures < MAX_WRITE_RETRIES) {
 					block->write_failures++;
 					fibril_mutex_unlock(&block->lock);
-					fibril_mutex_unlock(&cache->lock);
+					fibril_mutex_unlock(&shard->lock);
 					goto retry;
 				} else {
 					printf("Too many errors writing block %"
@@ -654,35 +1234,415 @@ retry:
 			/*
 			 * Take the block out of the cache and free it.
 			 */
-			hash_table_remove_item(&cache->block_hash, &block->hash_link);
+			ohash_table_remove_item(&shard->block_hash, &block->hash_link);
+			shard_evicted(cache, shard, block);
 			fibril_mutex_unlock(&block->lock);
-			free(block->data);
-			free(block);
-			cache->blocks_cached--;
-			fibril_mutex_unlock(&cache->lock);
+			block_free(devcon, block);
+			shard->blocks_cached--;
+			fibril_mutex_unlock(&shard->lock);
 			return rc;
 		}
 		/*
-		 * Put the block on the free list.
+		 * Put the block on the list of unused blocks.
 		 */
 		if (cache->mode != CACHE_MODE_WB && block->dirty) {
 			/*
-			 * We cannot sync the block while holding the cache
+			 * We cannot sync the block while holding the shard
 			 * lock. Release everything and retry.
 			 */
 			block->refcnt++;
 			fibril_mutex_unlock(&block->lock);
-			fibril_mutex_unlock(&cache->lock);
+			fibril_mutex_unlock(&shard->lock);
 			goto retry;
 		}
-		list_append(&block->free_link, &cache->free_list);
+		list_append(&block->free_link, block->hot ? &shard->hot_list :
+		    &shard->cold_list);
+
+		if (block->dirty && block->dirty_gen == 0) {
+			block->dirty_gen = shard->flush_gen + 1;
+			if (++shard->dirty_puts == shard->capacity / 4)
+				flusher_wakeup(cache);
+		}
 	}
 	fibril_mutex_unlock(&block->lock);
-	fibril_mutex_unlock(&cache->lock);
+	fibril_mutex_unlock(&shard->lock);
+
+	return rc;
+}
+
+/*
+ * In the write-back mode, a flusher fibril writes back dirty blocks which are
+ * not in use. Every BLOCK_FLUSH_INTERVAL it writes back the blocks which have
+ * been dirty for at least one interval. When many blocks have been left dirty
+ * in a shard since the last pass, it is woken up early and writes back all
+ * dirty blocks. Blocks adjacent on the device are written back as one extent
+ * of up to BLOCK_FLUSH_MAX_BYTES. If the device accepts vectored requests,
+ * the extents are copied to a buffer of BLOCK_FLUSH_BUF_SIZE bytes shared with
+ * it and written back using one request.
+ */
+#define BLOCK_FLUSH_INTERVAL	1000000
+#define BLOCK_FLUSH_BATCH	64
+#define BLOCK_FLUSH_MAX_BYTES	(128 * 1024)
+#define BLOCK_FLUSH_BUF_SIZE	(256 * 1024)
+
+static int block_pba_cmp(const void *a, const void *b)
+{
+	const block_t *ba = *(const block_t **) a;
+	const block_t *bb = *(const block_t **) b;
+
+	if (ba->pba == bb->pba)
+		return 0;
+
+	return ba->pba < bb->pba ? -1 : 1;
+}
+
+/** Take a reference to the dirty unused blocks of a shard, marking them
+ * clean.
+ *
+ * @param shard		Shard
+ * @param list		List of unused blocks of the shard
+ * @param all		Take all dirty blocks, not only those dirty since
+ *			an earlier pass
+ * @param batch		Array to add the blocks to
+ * @param n		Number of blocks already in @a batch
+ *
+ * @return		New number of blocks in @a batch.
+ */
+static size_t flush_collect(cache_shard_t *shard, list_t *list, bool all,
+    block_t **batch, size_t n)
+{
+	list_foreach_safe(*list, cur, next) {
+		if (n == BLOCK_FLUSH_BATCH)
+			break;
+
+		block_t *b = list_get_instance(cur, block_t, free_link);
+		if (!b->dirty || b->toxic)
+			continue;
+		if (!all && b->dirty_gen >= shard->flush_gen)
+			continue;
+		if (!fibril_mutex_trylock(&b->lock))
+			continue;
+
+		/*
+		 * Mark the block clean before its data are copied. Should
+		 * someone dirty it again while it is being written, it will
+		 * be written again later.
+		 */
+		b->refcnt++;
+		list_remove(&b->free_link);
+		b->dirty = false;
+		b->dirty_gen = 0;
+		fibril_mutex_unlock(&b->lock);
+
+		batch[n++] = b;
+	}
+
+	return n;
+}
+
+/** Write back a run of adjacent blocks.
+ *
+ * @param devcon	Device connection
+ * @param blocks	Blocks with adjacent physical addresses
+ * @param cnt		Number of blocks
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t flush_run(devcon_t *devcon, block_t **blocks, size_t cnt)
+{
+	cache_t *cache = devcon->cache;
+	size_t bsize = cache->lblock_size;
+
+	if (cnt > 1) {
+		uint8_t *buf = malloc(cnt * bsize);
+		if (buf != NULL) {
+			for (size_t i = 0; i < cnt; i++)
+				memcpy(buf + i * bsize, blocks[i]->data, bsize);
+
+			errno_t rc = write_blocks(devcon, blocks[0]->pba,
+			    cnt * cache->blocks_cluster, buf, cnt * bsize);
+			free(buf);
+			return rc;
+		}
+	}
+
+	errno_t rc = EOK;
+	for (size_t i = 0; i < cnt; i++) {
+		errno_t rc2 = write_blocks(devcon, blocks[i]->pba,
+		    cache->blocks_cluster, blocks[i]->data, bsize);
+		if (rc2 != EOK)
+			rc = rc2;
+	}
+
+	return rc;
+}
+
+/** Write back runs of adjacent blocks using one vectored request.
+ *
+ * @param devcon	Device connection with a shared buffer
+ * @param blocks	Blocks sorted by their physical addresses
+ * @param runs		Numbers of blocks in the runs
+ * @param nruns		Number of runs, at most BD_VEC_MAX
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t flush_vec(devcon_t *devcon, block_t **blocks, size_t *runs,
+    size_t nruns)
+{
+	cache_t *cache = devcon->cache;
+	size_t bsize = cache->lblock_size;
+	bd_vec_t vec[BD_VEC_MAX];
+	size_t offs = 0;
+	size_t k = 0;
+
+	assert(nruns <= BD_VEC_MAX);
+
+	fibril_mutex_lock(&devcon->flush_buf_lock);
+
+	for (size_t r = 0; r < nruns; r++) {
+		vec[r].ba = blocks[k]->pba;
+		vec[r].cnt = runs[r] * cache->blocks_cluster;
+		vec[r].offs = offs;
+
+		for (size_t i = 0; i < runs[r]; i++) {
+			assert(offs + bsize <= BLOCK_FLUSH_BUF_SIZE);
+			memcpy((uint8_t *) devcon->flush_buf + offs,
+			    blocks[k++]->data, bsize);
+			offs += bsize;
+		}
+	}
+
+	errno_t rc = bd_rw_vec(devcon->bd, true, vec, nruns);
+	fibril_mutex_unlock(&devcon->flush_buf_lock);
+
+	return rc;
+}
+
+/** Write back dirty blocks which are not in use.
+ *
+ * @param devcon	Device connection
+ * @param all		Write back all dirty blocks, not only those dirty
+ *			since an earlier pass
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t cache_flush(devcon_t *devcon, bool all)
+{
+	cache_t *cache = devcon->cache;
+	block_t *batch[BLOCK_FLUSH_BATCH];
+	size_t max_run = max(BLOCK_FLUSH_MAX_BYTES / cache->lblock_size,
+	    (size_t) 1);
+	errno_t rc = EOK;
+
+	for (unsigned i = 0; i < BLOCK_CACHE_SHARDS; i++) {
+		cache_shard_t *shard = &cache->shards[i];
+
+		fibril_mutex_lock(&shard->lock);
+		shard->flush_gen++;
+		shard->dirty_puts = 0;
+		fibril_mutex_unlock(&shard->lock);
+	}
+
+	while (true) {
+		size_t n = 0;
+
+		for (unsigned i = 0; i < BLOCK_CACHE_SHARDS; i++) {
+			cache_shard_t *shard = &cache->shards[i];
+
+			fibril_mutex_lock(&shard->lock);
+			n = flush_collect(shard, &shard->cold_list, all, batch, n);
+			n = flush_collect(shard, &shard->hot_list, all, batch, n);
+			fibril_mutex_unlock(&shard->lock);
+		}
+
+		if (n == 0)
+			break;
+
+		qsort(batch, n, sizeof(block_t *), block_pba_cmp);
+
+		for (size_t first = 0; first < n; ) {
+			size_t runs[BD_VEC_MAX];
+			size_t nruns = 0;
+			size_t nblk = 0;
+
+			/*
+			 * Gather runs of adjacent blocks. Without the shared
+			 * buffer, each run is written by a request of its own.
+			 */
+			do {
+				size_t cnt = 1;
+				while (first + nblk + cnt < n && cnt < max_run &&
+				    batch[first + nblk + cnt]->pba ==
+				    batch[first + nblk + cnt - 1]->pba +
+				    cache->blocks_cluster)
+					cnt++;
+
+				if (nruns > 0 && (nblk + cnt) *
+				    cache->lblock_size > BLOCK_FLUSH_BUF_SIZE)
+					break;
+
+				runs[nruns++] = cnt;
+				nblk += cnt;
+			} while (devcon->flush_buf != NULL &&
+			    nruns < BD_VEC_MAX && first + nblk < n);
+
+			errno_t rc2;
+			if (devcon->flush_buf != NULL)
+				rc2 = flush_vec(devcon, &batch[first], runs, nruns);
+			else
+				rc2 = flush_run(devcon, &batch[first], nblk);
+
+			for (size_t i = first; i < first + nblk; i++) {
+				block_t *b = batch[i];
+				cache_shard_t *shard = shard_of(cache, b->lba);
+
+				fibril_mutex_lock(&shard->lock);
+				fibril_mutex_lock(&b->lock);
+				if (rc2 != EOK)
+					b->dirty = true;
+				else
+					shard->stats.writebacks++;
+				fibril_mutex_unlock(&b->lock);
+				fibril_mutex_unlock(&shard->lock);
+
+				(void) block_put(b);
+			}
+
+			if (rc2 != EOK) {
+				/* Try again on the next pass. */
+				rc = rc2;
+			}
+
+			first += nblk;
+		}
+
+		if (rc != EOK || n < BLOCK_FLUSH_BATCH)
+			break;
+	}
 
 	return rc;
 }
 
+static errno_t flusher_fibril(void *arg)
+{
+	devcon_t *devcon = arg;
+	cache_t *cache = devcon->cache;
+
+	fibril_mutex_lock(&cache->flush_lock);
+
+	while (!cache->flusher_stop) {
+		if (!cache->flush_urgent) {
+			(void) fibril_condvar_wait_timeout(&cache->flush_cv,
+			    &cache->flush_lock, BLOCK_FLUSH_INTERVAL);
+		}
+
+		if (cache->flusher_stop)
+			break;
+
+		bool all = cache->flush_urgent;
+		cache->flush_urgent = false;
+		fibril_mutex_unlock(&cache->flush_lock);
+
+		(void) cache_flush(devcon, all);
+
+		fibril_mutex_lock(&cache->flush_lock);
+	}
+
+	cache->flusher_done = true;
+	fibril_condvar_broadcast(&cache->flush_cv);
+	fibril_mutex_unlock(&cache->flush_lock);
+
+	return EOK;
+}
+
+static void flusher_start(devcon_t *devcon)
+{
+	cache_t *cache = devcon->cache;
+
+	fibril_mutex_initialize(&cache->flush_lock);
+	fibril_condvar_initialize(&cache->flush_cv);
+	cache->flusher_stop = false;
+	cache->flusher_done = false;
+	cache->flush_urgent = false;
+	cache->flusher = 0;
+
+	/* Blocks of a mapped device are never dirty. */
+	if (cache->mode != CACHE_MODE_WB || devcon->image != NULL)
+		return;
+
+	if (devcon->flush_buf == NULL &&
+	    cache->lblock_size <= BLOCK_FLUSH_MAX_BYTES) {
+		void *buf = as_area_create(AS_AREA_ANY, BLOCK_FLUSH_BUF_SIZE,
+		    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
+		    AS_AREA_UNPAGED);
+		if (buf != AS_MAP_FAILED) {
+			/* The device may not support vectored requests. */
+			if (bd_buf_share(devcon->bd, buf,
+			    BLOCK_FLUSH_BUF_SIZE) == EOK)
+				devcon->flush_buf = buf;
+			else
+				as_area_destroy(buf);
+		}
+	}
+
+	/* Without the flusher, blocks are still written back on eviction. */
+	cache->flusher = fibril_create(flusher_fibril, devcon);
+	if (cache->flusher != 0)
+		fibril_add_ready(cache->flusher);
+}
+
+static void flusher_stop(cache_t *cache)
+{
+	if (cache->flusher == 0)
+		return;
+
+	fibril_mutex_lock(&cache->flush_lock);
+	cache->flusher_stop = true;
+	fibril_condvar_broadcast(&cache->flush_cv);
+	while (!cache->flusher_done)
+		fibril_condvar_wait(&cache->flush_cv, &cache->flush_lock);
+	fibril_mutex_unlock(&cache->flush_lock);
+
+	cache->flusher = 0;
+}
+
+/** Wake up the flusher to write back all dirty blocks.
+ *
+ * Called with the lock of a shard held.
+ */
+static void flusher_wakeup(cache_t *cache)
+{
+	fibril_mutex_lock(&cache->flush_lock);
+	cache->flush_urgent = true;
+	fibril_condvar_broadcast(&cache->flush_cv);
+	fibril_mutex_unlock(&cache->flush_lock);
+}
+
+/** Write back all dirty blocks and wait until they are on stable storage.
+ *
+ * All blocks that have been put dirty before the call are written back and
+ * the device is asked to flush its cache. This orders the writes of the
+ * blocks put before the call before the writes of blocks put after it,
+ * which can be used to implement write barriers, e.g. for journaling.
+ * Blocks still in use are not written back.
+ *
+ * @param service_id	Service ID of the block device
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t block_cache_flush(service_id_t service_id)
+{
+	devcon_t *devcon = devcon_search(service_id);
+	if (devcon == NULL || devcon->cache == NULL)
+		return ENOENT;
+
+	errno_t rc = cache_flush(devcon, true);
+	if (rc != EOK)
+		return rc;
+
+	return bd_sync_cache(devcon->bd, 0, 0);
+}
+
 /** Read sequential data from a block device.
  *
  * @param service_id	Service ID of the block device.
@@ -907,6 +1867,38 @@ errno_t block_read_toc(service_id_t service_id, uint8_t session, void *buf,
 	return bd_read_toc(devcon->bd, session, buf, bufsize);
 }
 
+/** Copy blocks between a buffer and the image of a mapped device.
+ *
+ * @param devcon	Device connection with a mapped image.
+ * @param ba		Address of first block.
+ * @param cnt		Number of blocks.
+ * @param buf		Buffer.
+ * @param size		Size of the buffer.
+ * @param write		@c true to copy to the image, @c false to copy
+ *			from it.
+ *
+ * @return		EOK on success, ELIMIT if the blocks lie past the
+ *			end of the device.
+ */
+static errno_t image_copy(devcon_t *devcon, aoff64_t ba, size_t cnt,
+    void *buf, size_t size, bool write)
+{
+	size_t bytes = min(cnt * devcon->pblock_size, size);
+	void *data = block_image_data(devcon, ba, bytes);
+	if (data == NULL)
+		return ELIMIT;
+
+	/* A cached block may already reside in the image. */
+	if (data != buf) {
+		if (write)
+			memcpy(data, buf, bytes);
+		else
+			memcpy(buf, data, bytes);
+	}
+
+	return EOK;
+}
+
 /** Read blocks from block device.
  *
  * @param devcon	Device connection.
@@ -921,7 +1913,11 @@ static errno_t read_blocks(devcon_t *devcon, aoff64_t ba, size_t cnt, void *buf,
 {
 	assert(devcon);
 
-	errno_t rc = bd_read_blocks(devcon->bd, ba, cnt, buf, size);
+	errno_t rc;
+	if (devcon->image != NULL)
+		rc = image_copy(devcon, ba, cnt, buf, size, false);
+	else
+		rc = bd_read_blocks(devcon->bd, ba, cnt, buf, size);
 	if (rc != EOK) {
 		printf("Error %s reading %zu blocks starting at block %" PRIuOFF64
 		    " from device handle %" PRIun "\n", str_error_name(rc), cnt, ba,
@@ -948,7 +1944,11 @@ static errno_t write_blocks(devcon_t *devcon, aoff64_t ba, size_t cnt, void *dat
 {
 	assert(devcon);
 
-	errno_t rc = bd_write_blocks(devcon->bd, ba, cnt, data, size);
+	errno_t rc;
+	if (devcon->image != NULL)
+		rc = image_copy(devcon, ba, cnt, data, size, true);
+	else
+		rc = bd_write_blocks(devcon->bd, ba, cnt, data, size);
 	if (rc != EOK) {
 		printf("Error %s writing %zu blocks starting at block %" PRIuOFF64
 		    " to device handle %" PRIun "\n", str_error_name(rc), cnt, ba, devcon->service_id);
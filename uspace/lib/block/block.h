@@ -70,6 +70,12 @@ typedef struct block {
 	bool dirty;
 	/** If true, the blcok does not contain valid data. */
 	bool toxic;
+	/** If true, the block was read ahead and has not been used yet. */
+	bool readahead;
+	/** If true, the block was used repeatedly since it was loaded. */
+	bool hot;
+	/** Flusher pass during which the block was left dirty. */
+	unsigned dirty_gen;
 	/** Readers / Writer lock protecting the contents of the block. */
 	fibril_rwlock_t contents_lock;
 	/** Service ID of service providing the block device. */
@@ -82,7 +88,7 @@ typedef struct block {
 	size_t size;
 	/** Number of write failures. */
 	int write_failures;
-	/** Link for placing the block into the free block list. */
+	/** Link for placing the block into a list of unused blocks. */
 	link_t free_link;
 	/** Link for placing the block into the block hash table. */
 	ht_link_t hash_link;
@@ -90,6 +96,30 @@ typedef struct block {
 	void *data;
 } block_t;
 
+/** Statistics of a block cache. */
+typedef struct {
+	/** Blocks found in the cache */
+	size_t hits;
+	/** Blocks not found in the cache */
+	size_t misses;
+	/** Blocks dropped from the cache */
+	size_t evictions;
+	/** Dirty blocks written back to the device */
+	size_t writebacks;
+	/** Blocks read ahead */
+	size_t ra_blocks;
+	/** Blocks read ahead which were later used */
+	size_t ra_hits;
+	/** Blocks read ahead which were dropped before being used */
+	size_t ra_wasted;
+	/** Blocks currently cached */
+	size_t blocks;
+	/** Number of blocks the cache should hold */
+	size_t capacity;
+	/** Current read-ahead window in blocks */
+	size_t ra_window;
+} block_cache_stats_t;
+
 /** Caching mode */
 enum cache_mode {
 	/** Write-Through */
@@ -106,6 +136,10 @@ extern void *block_bb_get(service_id_t);
 
 extern errno_t block_cache_init(service_id_t, size_t, unsigned, enum cache_mode);
 extern errno_t block_cache_fini(service_id_t);
+extern errno_t block_cache_resize(service_id_t, size_t);
+extern errno_t block_cache_flush(service_id_t);
+extern errno_t block_cache_stats(service_id_t, block_cache_stats_t *);
+extern errno_t block_cache_size_parse(const char *, size_t *);
 
 extern errno_t block_get(block_t **, service_id_t, aoff64_t, int);
 extern errno_t block_put(block_t *);
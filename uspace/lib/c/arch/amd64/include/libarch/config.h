@@ -38,6 +38,10 @@
 #define PAGE_WIDTH	12
 #define PAGE_SIZE	(1 << PAGE_WIDTH)
 
+/* memcpy() and memset() are implemented in src/mem.S. */
+#define LIBARCH_MEMCPY
+#define LIBARCH_MEMSET
+
 #endif
 
 /** @}
@@ -39,6 +39,7 @@
 #include <stdlib.h>
 
 #include <libarch/rtld/elf_dyn.h>
+#include <libarch/rtld/module.h>
 #include <rtld/symbol.h>
 #include <rtld/rtld.h>
 #include <rtld/rtld_debug.h>
@@ -49,6 +50,73 @@ void module_process_pre_arch(module_t *m)
 	/* Unused */
 }
 
+/** Set up lazy binding of PLT entries.
+ *
+ * Each GOT entry referenced from a JUMP_SLOT relocation initially points
+ * back into its PLT entry, which pushes the relocation index and jumps
+ * to PLT0. PLT0 pushes GOT[1] and jumps to GOT[2]. We only need to bias
+ * the GOT entries and make GOT[1] and GOT[2] point to the module and
+ * the binding trampoline, respectively.
+ *
+ * @param m Module
+ * @return @c true if the PLT of @a m will be bound lazily
+ */
+bool module_plt_lazy_arch(module_t *m)
+{
+	elf_rela_t *rt = m->dyn.jmp_rel;
+	uintptr_t *got = m->dyn.plt_got;
+	size_t rt_entries;
+	size_t i;
+
+	if (m->dyn.plt_rel != DT_RELA || got == NULL)
+		return false;
+
+	rt_entries = m->dyn.plt_rel_sz / sizeof(elf_rela_t);
+	for (i = 0; i < rt_entries; ++i) {
+		if (ELF64_R_TYPE(rt[i].r_info) != R_X86_64_JUMP_SLOT)
+			return false;
+	}
+
+	for (i = 0; i < rt_entries; ++i)
+		*(uintptr_t *) (rt[i].r_offset + m->bias) += m->bias;
+
+	got[1] = (uintptr_t) m;
+	got[2] = (uintptr_t) plt_bind_start;
+	return true;
+}
+
+/** Bind a PLT entry on its first use.
+ *
+ * Called from plt_bind_start. Uses an uncached symbol search as it may run
+ * concurrently in several threads.
+ *
+ * @param m Module whose PLT entry is being bound
+ * @param idx Index of the JUMP_SLOT relocation
+ * @return Address of the function
+ */
+void *plt_bind(module_t *m, size_t idx)
+{
+	elf_rela_t *rela = (elf_rela_t *) m->dyn.jmp_rel + idx;
+	elf_symbol_t *sym_table = m->dyn.sym_tab;
+	elf_symbol_t *sym = &sym_table[ELF64_R_SYM(rela->r_info)];
+	uintptr_t *r_ptr = (uintptr_t *) (rela->r_offset + m->bias);
+	elf_symbol_t *sym_def;
+	module_t *dest;
+	void *addr;
+
+	sym_def = symbol_def_find(m->dyn.str_tab + sym->st_name, m,
+	    ssf_nocache, &dest);
+	if (sym_def == NULL) {
+		printf("Definition of '%s' not found.\n",
+		    m->dyn.str_tab + sym->st_name);
+		abort();
+	}
+
+	addr = symbol_get_addr(sym_def, dest, NULL);
+	*r_ptr = (uintptr_t) addr;
+	return addr;
+}
+
 /**
  * Process (fixup) all relocations in a relocation table with implicit addends.
  */
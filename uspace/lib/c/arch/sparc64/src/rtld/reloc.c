@@ -53,6 +53,18 @@ void module_process_pre_arch(module_t *m)
 	/* Unused */
 }
 
+/** Set up lazy binding of PLT entries.
+ *
+ * Not supported, all PLT entries are bound eagerly.
+ *
+ * @return @c false
+ */
+bool module_plt_lazy_arch(module_t *m)
+{
+	(void) m;
+	return false;
+}
+
 /**
  * Process (fixup) all relocations in a relocation table with implicit addends.
  */
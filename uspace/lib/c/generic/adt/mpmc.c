@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/**
+ * @file
+ * @brief Bounded lock-free multi-producer multi-consumer queue.
+ *
+ * The queue is an array of cells, each carrying a sequence number
+ * (D. Vyukov's bounded MPMC queue). A producer claims the cell at
+ * the push position once its sequence number says the cell is free,
+ * a consumer claims the cell at the pop position once the sequence number
+ * says the cell is full. Neither side takes a lock. A fibril that has to
+ * wait for a full or empty queue parks on the position it is waiting to
+ * advance and the other side unparks it.
+ */
+
+#include <adt/mpmc.h>
+#include <assert.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Initialize queue.
+ *
+ * @param q Queue
+ * @param cells Storage for the cells
+ * @param ncells Number of cells in @a cells, must be a power of two
+ */
+void mpmc_init(mpmc_t *q, mpmc_cell_t *cells, size_t ncells)
+{
+	size_t i;
+
+	assert(ncells >= 2);
+	assert((ncells & (ncells - 1)) == 0);
+
+	for (i = 0; i < ncells; i++) {
+		atomic_init(&cells[i].seq, i);
+		cells[i].item = NULL;
+	}
+
+	q->cells = cells;
+	q->mask = ncells - 1;
+	atomic_init(&q->push_pos, 0);
+	atomic_init(&q->pop_pos, 0);
+}
+
+/** Wait argument for mpmc_sleep_validate() */
+typedef struct {
+	/** Queue */
+	mpmc_t *q;
+	/** Position of the next operation */
+	atomic_size_t *pos;
+	/** @c true to wait for a full cell, @c false for a free one */
+	bool full;
+} mpmc_wait_t;
+
+/** Determine whether a fibril needs to wait for the cell at a position.
+ *
+ * @param arg Wait argument (mpmc_wait_t *)
+ * @return @c true if the cell is not ready yet
+ */
+static bool mpmc_sleep_validate(void *arg)
+{
+	mpmc_wait_t *wait = (mpmc_wait_t *) arg;
+	size_t p = atomic_load_explicit(wait->pos, memory_order_relaxed);
+	mpmc_cell_t *cell = &wait->q->cells[p & wait->q->mask];
+	size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+
+	return (intptr_t) (seq - (p + (wait->full ? 1 : 0))) < 0;
+}
+
+/** Sleep until the cell at a position becomes ready.
+ *
+ * May return spuriously, the caller is expected to retry.
+ *
+ * @param q Queue
+ * @param pos Position of the next operation
+ * @param full @c true to wait for a full cell, @c false for a free one
+ */
+static void mpmc_sleep(mpmc_t *q, atomic_size_t *pos, bool full)
+{
+	mpmc_wait_t wait = {
+		.q = q,
+		.pos = pos,
+		.full = full
+	};
+
+	(void) fibril_park(pos, mpmc_sleep_validate, &wait, NULL);
+}
+
+/** Push item into queue without blocking.
+ *
+ * @param q Queue
+ * @param item Item
+ * @return EOK on success, EAGAIN if the queue is full
+ */
+errno_t mpmc_try_push(mpmc_t *q, void *item)
+{
+	mpmc_cell_t *cell;
+	size_t pos;
+	size_t seq;
+	intptr_t diff;
+
+	pos = atomic_load_explicit(&q->push_pos, memory_order_relaxed);
+	while (true) {
+		cell = &q->cells[pos & q->mask];
+		seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+		diff = (intptr_t) (seq - pos);
+
+		if (diff == 0) {
+			if (atomic_compare_exchange_weak_explicit(&q->push_pos,
+			    &pos, pos + 1, memory_order_relaxed,
+			    memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			return EAGAIN;
+		} else {
+			pos = atomic_load_explicit(&q->push_pos,
+			    memory_order_relaxed);
+		}
+	}
+
+	cell->item = item;
+	atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+
+	(void) fibril_unpark(&q->pop_pos, 1);
+	return EOK;
+}
+
+/** Pop item from queue without blocking.
+ *
+ * @param q Queue
+ * @param ritem Place to store item
+ * @return EOK on success, EAGAIN if the queue is empty
+ */
+errno_t mpmc_try_pop(mpmc_t *q, void **ritem)
+{
+	mpmc_cell_t *cell;
+	size_t pos;
+	size_t seq;
+	intptr_t diff;
+
+	pos = atomic_load_explicit(&q->pop_pos, memory_order_relaxed);
+	while (true) {
+		cell = &q->cells[pos & q->mask];
+		seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+		diff = (intptr_t) (seq - (pos + 1));
+
+		if (diff == 0) {
+			if (atomic_compare_exchange_weak_explicit(&q->pop_pos,
+			    &pos, pos + 1, memory_order_relaxed,
+			    memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			return EAGAIN;
+		} else {
+			pos = atomic_load_explicit(&q->pop_pos,
+			    memory_order_relaxed);
+		}
+	}
+
+	*ritem = cell->item;
+	atomic_store_explicit(&cell->seq, pos + q->mask + 1,
+	    memory_order_release);
+
+	(void) fibril_unpark(&q->push_pos, 1);
+	return EOK;
+}
+
+/** Push item into queue, blocking while the queue is full.
+ *
+ * @param q Queue
+ * @param item Item
+ */
+void mpmc_push(mpmc_t *q, void *item)
+{
+	while (mpmc_try_push(q, item) != EOK)
+		mpmc_sleep(q, &q->push_pos, false);
+}
+
+/** Pop item from queue, blocking while the queue is empty.
+ *
+ * @param q Queue
+ * @return Item
+ */
+void *mpmc_pop(mpmc_t *q)
+{
+	void *item;
+
+	while (mpmc_try_pop(q, &item) != EOK)
+		mpmc_sleep(q, &q->pop_pos, true);
+
+	return item;
+}
+
+/** @}
+ */
@@ -0,0 +1,545 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+/*
+ * This is an implementation of a resizable open-addressing hash table
+ * using Robin Hood hashing.
+ *
+ * Each slot holds a pointer to the item and the item's hash, mixed so
+ * that poorly distributed hash functions do not cluster in a table whose
+ * size is a power of two. Collisions are resolved by linear probing. An
+ * item being inserted takes over the slot of any item which is closer to
+ * its home slot, so that the distances of the items from their home slots
+ * stay even. Items with the same home slot thus always form a contiguous
+ * run, and a lookup can stop as soon as it meets an item which is closer
+ * to its home slot than the key being searched for would be. Removed
+ * items are not replaced by tombstones; the rest of the run is shifted
+ * back instead.
+ *
+ * A lookup therefore mostly reads consecutive slots and only touches items
+ * whose hash matches the key.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/ohash_table.h>
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+
+/** Minimum number of slots. Must be a power of two. */
+#define OHT_MIN_SLOTS  16
+
+/** The table grows once more than 7/8 of the slots are occupied. */
+static inline size_t max_items(size_t slot_cnt)
+{
+	return slot_cnt - slot_cnt / 8;
+}
+
+/** The table shrinks once less than 1/8 of the slots is occupied. */
+static inline size_t min_items(size_t slot_cnt)
+{
+	return slot_cnt / 8;
+}
+
+/** Distance of the item in slot @a pos from its home slot. */
+static inline size_t slot_dist(const ohash_table_t *h, size_t pos)
+{
+	size_t mask = h->slot_cnt - 1;
+
+	return (pos - (h->slot[pos].hash & mask)) & mask;
+}
+
+/** Rounds up size to the nearest suitable table size. */
+static size_t round_up_size(size_t size)
+{
+	size_t rounded_size = OHT_MIN_SLOTS;
+
+	while (rounded_size < size)
+		rounded_size *= 2;
+
+	return rounded_size;
+}
+
+/** Places an item into the table without checking the load. */
+static void place(ohash_table_t *h, size_t hash, ht_link_t *item)
+{
+	size_t mask = h->slot_cnt - 1;
+	size_t pos = hash & mask;
+	size_t dist = 0;
+
+	while (h->slot[pos].item != NULL) {
+		size_t cur_dist = slot_dist(h, pos);
+
+		if (cur_dist < dist) {
+			/* Take the slot and go on placing the displaced item. */
+			ohash_slot_t tmp = h->slot[pos];
+			h->slot[pos].hash = hash;
+			h->slot[pos].item = item;
+			hash = tmp.hash;
+			item = tmp.item;
+			dist = cur_dist;
+		}
+
+		pos = (pos + 1) & mask;
+		dist++;
+	}
+
+	h->slot[pos].hash = hash;
+	h->slot[pos].item = item;
+}
+
+/** Empties slot @a pos, shifting the rest of its run back. */
+static void delete_slot(ohash_table_t *h, size_t pos)
+{
+	size_t mask = h->slot_cnt - 1;
+
+	while (true) {
+		size_t next = (pos + 1) & mask;
+
+		if (h->slot[next].item == NULL || slot_dist(h, next) == 0)
+			break;
+
+		h->slot[pos] = h->slot[next];
+		pos = next;
+	}
+
+	h->slot[pos].item = NULL;
+}
+
+/** Finds the slot holding @a item, which must be in the table. */
+static size_t locate(const ohash_table_t *h, ht_link_t *item)
+{
+	size_t mask = h->slot_cnt - 1;
+	size_t pos = hash_mix(h->op->hash(item)) & mask;
+
+	while (h->slot[pos].item != item) {
+		assert(h->slot[pos].item != NULL);
+		pos = (pos + 1) & mask;
+	}
+
+	return pos;
+}
+
+/** Allocates and rehashes items to a new table. Frees the old table.
+ *
+ * @return True on success, false if the table was left as is.
+ */
+static bool resize(ohash_table_t *h, size_t new_slot_cnt)
+{
+	assert(OHT_MIN_SLOTS <= new_slot_cnt);
+	assert(h->item_cnt < new_slot_cnt);
+
+	/* We are traversing the table and resizing would mess up the slots. */
+	if (h->apply_ongoing)
+		return false;
+
+	ohash_slot_t *new_slot = calloc(new_slot_cnt, sizeof(ohash_slot_t));
+	if (new_slot == NULL)
+		return false;
+
+	ohash_slot_t *old_slot = h->slot;
+	size_t old_slot_cnt = h->slot_cnt;
+
+	h->slot = new_slot;
+	h->slot_cnt = new_slot_cnt;
+
+	for (size_t pos = 0; pos < old_slot_cnt; pos++) {
+		if (old_slot[pos].item != NULL)
+			place(h, old_slot[pos].hash, old_slot[pos].item);
+	}
+
+	free(old_slot);
+	return true;
+}
+
+/** Shrinks the table if the table is only sparsely populated. */
+static void shrink_if_needed(ohash_table_t *h)
+{
+	if (h->item_cnt < min_items(h->slot_cnt) &&
+	    OHT_MIN_SLOTS < h->slot_cnt)
+		(void) resize(h, h->slot_cnt / 2);
+}
+
+/** Makes room for one more item.
+ *
+ * @return True if the item can be placed.
+ */
+static bool reserve_one(ohash_table_t *h)
+{
+	if (h->item_cnt + 1 <= max_items(h->slot_cnt))
+		return true;
+
+	if (resize(h, 2 * h->slot_cnt))
+		return true;
+
+	/* Overfill the table rather than fail, but keep a slot empty. */
+	return h->item_cnt + 1 < h->slot_cnt;
+}
+
+/** Unlinks and removes all items but does not resize. */
+static void clear_items(ohash_table_t *h)
+{
+	if (h->item_cnt == 0)
+		return;
+
+	for (size_t pos = 0; pos < h->slot_cnt; pos++) {
+		ht_link_t *item = h->slot[pos].item;
+
+		if (item != NULL) {
+			h->slot[pos].item = NULL;
+			if (h->op->remove_callback)
+				h->op->remove_callback(item);
+		}
+	}
+
+	h->item_cnt = 0;
+}
+
+/** Create open-addressing hash table.
+ *
+ * @param h         Hash table structure. Will be initialized by this call.
+ * @param init_size Initial desired number of slots. Pass zero if you want
+ *                  the default initial size.
+ * @param op        Hash table operations structure, with the same meaning
+ *                  as for hash_table_create().
+ *
+ * @return True on success
+ *
+ */
+bool ohash_table_create(ohash_table_t *h, size_t init_size,
+    const hash_table_ops_t *op)
+{
+	assert(h);
+	assert(op && op->hash && op->key_hash && op->key_equal);
+
+	/* Check for compulsory ops. */
+	if (!op || !op->hash || !op->key_hash || !op->key_equal)
+		return false;
+
+	h->slot_cnt = round_up_size(init_size);
+	h->slot = calloc(h->slot_cnt, sizeof(ohash_slot_t));
+	if (h->slot == NULL)
+		return false;
+
+	h->item_cnt = 0;
+	h->op = op;
+	h->apply_ongoing = false;
+
+	return true;
+}
+
+/** Destroy a hash table instance.
+ *
+ * @param h Hash table to be destroyed.
+ *
+ */
+void ohash_table_destroy(ohash_table_t *h)
+{
+	assert(h && h->slot);
+	assert(!h->apply_ongoing);
+
+	clear_items(h);
+
+	free(h->slot);
+
+	h->slot = NULL;
+	h->slot_cnt = 0;
+}
+
+/** Returns true if there are no items in the table. */
+bool ohash_table_empty(ohash_table_t *h)
+{
+	assert(h && h->slot);
+	return h->item_cnt == 0;
+}
+
+/** Returns the number of items in the table. */
+size_t ohash_table_size(ohash_table_t *h)
+{
+	assert(h && h->slot);
+	return h->item_cnt;
+}
+
+/** Remove all elements from the hash table
+ *
+ * @param h Hash table to be cleared
+ */
+void ohash_table_clear(ohash_table_t *h)
+{
+	assert(h && h->slot);
+	assert(!h->apply_ongoing);
+
+	clear_items(h);
+
+	/* Shrink the table to its minimum size if possible. */
+	if (OHT_MIN_SLOTS < h->slot_cnt)
+		(void) resize(h, OHT_MIN_SLOTS);
+}
+
+/** Insert item into a hash table.
+ *
+ * @param h    Hash table.
+ * @param item Item to be inserted into the hash table.
+ *
+ * @return EOK on success, ENOMEM if the table is full and cannot grow.
+ */
+errno_t ohash_table_insert(ohash_table_t *h, ht_link_t *item)
+{
+	assert(item);
+	assert(h && h->slot);
+	assert(!h->apply_ongoing);
+
+	if (!reserve_one(h))
+		return ENOMEM;
+
+	place(h, hash_mix(h->op->hash(item)), item);
+	++h->item_cnt;
+
+	return EOK;
+}
+
+/** Insert item into a hash table if not already present.
+ *
+ * @param h    Hash table.
+ * @param item Item to be inserted into the hash table.
+ *
+ * @return EOK if the inserted item was the only item with such a lookup key.
+ * @return EEXIST if such an item had already been inserted.
+ * @return ENOMEM if the table is full and cannot grow.
+ */
+errno_t ohash_table_insert_unique(ohash_table_t *h, ht_link_t *item)
+{
+	assert(item);
+	assert(h && h->slot);
+	assert(h->op && h->op->hash && h->op->equal);
+	assert(!h->apply_ongoing);
+
+	size_t hash = hash_mix(h->op->hash(item));
+	size_t mask = h->slot_cnt - 1;
+	size_t pos = hash & mask;
+	size_t dist = 0;
+
+	/* Check for duplicates. */
+	while (h->slot[pos].item != NULL && slot_dist(h, pos) >= dist) {
+		if (h->slot[pos].hash == hash &&
+		    h->op->equal(h->slot[pos].item, item))
+			return EEXIST;
+
+		pos = (pos + 1) & mask;
+		dist++;
+	}
+
+	if (!reserve_one(h))
+		return ENOMEM;
+
+	place(h, hash, item);
+	++h->item_cnt;
+
+	return EOK;
+}
+
+/** Search hash table for an item matching keys.
+ *
+ * @param h   Hash table.
+ * @param key Array of all keys needed to compute hash index.
+ *
+ * @return Matching item on success, NULL if there is no such item.
+ *
+ */
+ht_link_t *ohash_table_find(const ohash_table_t *h, const void *key)
+{
+	assert(h && h->slot);
+
+	size_t hash = hash_mix(h->op->key_hash(key));
+	size_t mask = h->slot_cnt - 1;
+	size_t pos = hash & mask;
+	size_t dist = 0;
+
+	while (h->slot[pos].item != NULL && slot_dist(h, pos) >= dist) {
+		if (h->slot[pos].hash == hash &&
+		    h->op->key_equal(key, h->slot[pos].item))
+			return h->slot[pos].item;
+
+		pos = (pos + 1) & mask;
+		dist++;
+	}
+
+	return NULL;
+}
+
+/** Find the next item equal to item.
+ *
+ * Unlike in a chained table, the items equal to @a first cannot wrap around
+ * back to it, so @a first is only used to check the usage.
+ */
+ht_link_t *ohash_table_find_next(const ohash_table_t *h, ht_link_t *first,
+    ht_link_t *item)
+{
+	assert(item);
+	assert(h && h->slot);
+	assert(h->op->equal(first, item));
+
+	size_t mask = h->slot_cnt - 1;
+	size_t pos = locate(h, item);
+	size_t hash = h->slot[pos].hash;
+	size_t dist = slot_dist(h, pos);
+
+	pos = (pos + 1) & mask;
+	dist++;
+
+	while (h->slot[pos].item != NULL && slot_dist(h, pos) >= dist) {
+		if (h->slot[pos].hash == hash &&
+		    h->op->equal(h->slot[pos].item, item))
+			return h->slot[pos].item;
+
+		pos = (pos + 1) & mask;
+		dist++;
+	}
+
+	return NULL;
+}
+
+/** Remove all matching items from hash table.
+ *
+ * For each removed item, h->remove_callback() is called.
+ *
+ * @param h    Hash table.
+ * @param key  Array of keys that will be compared against items of
+ *             the hash table.
+ *
+ * @return Returns the number of removed items.
+ */
+size_t ohash_table_remove(ohash_table_t *h, const void *key)
+{
+	assert(h && h->slot);
+	assert(!h->apply_ongoing);
+
+	size_t hash = hash_mix(h->op->key_hash(key));
+	size_t mask = h->slot_cnt - 1;
+	size_t pos = hash & mask;
+	size_t dist = 0;
+	size_t removed = 0;
+
+	while (h->slot[pos].item != NULL && slot_dist(h, pos) >= dist) {
+		ht_link_t *item = h->slot[pos].item;
+
+		if (h->slot[pos].hash == hash && h->op->key_equal(key, item)) {
+			/* The next item of the run moves to pos. */
+			delete_slot(h, pos);
+			--h->item_cnt;
+			++removed;
+
+			if (h->op->remove_callback)
+				h->op->remove_callback(item);
+			continue;
+		}
+
+		pos = (pos + 1) & mask;
+		dist++;
+	}
+
+	shrink_if_needed(h);
+
+	return removed;
+}
+
+/** Removes an item already present in the table. The item must be in the table. */
+void ohash_table_remove_item(ohash_table_t *h, ht_link_t *item)
+{
+	assert(item);
+	assert(h && h->slot);
+
+	delete_slot(h, locate(h, item));
+	--h->item_cnt;
+
+	if (h->op->remove_callback)
+		h->op->remove_callback(item);
+	shrink_if_needed(h);
+}
+
+/** Apply function to all items in hash table.
+ *
+ * @param h   Hash table.
+ * @param f   Function to be applied. Return false if no more items
+ *            should be visited. The functor may only delete the supplied
+ *            item.
+ * @param arg Argument to be passed to the function.
+ */
+void ohash_table_apply(ohash_table_t *h, bool (*f)(ht_link_t *, void *),
+    void *arg)
+{
+	assert(f);
+	assert(h && h->slot);
+
+	if (h->item_cnt == 0)
+		return;
+
+	h->apply_ongoing = true;
+
+	/*
+	 * Start at an empty slot. No run crosses it, so when f() deletes an
+	 * item and the rest of its run is shifted back, no item moves from
+	 * the visited slots to the unvisited ones.
+	 */
+	size_t mask = h->slot_cnt - 1;
+	size_t start = 0;
+	while (h->slot[start].item != NULL)
+		start++;
+
+	size_t i = 0;
+	while (i < h->slot_cnt) {
+		size_t pos = (start + i) & mask;
+		ht_link_t *item = h->slot[pos].item;
+
+		if (item == NULL) {
+			i++;
+			continue;
+		}
+
+		if (!f(item, arg))
+			break;
+
+		/* Visit the item moved to pos if f() deleted this one. */
+		if (h->slot[pos].item == item)
+			i++;
+	}
+
+	h->apply_ongoing = false;
+
+	shrink_if_needed(h);
+}
+
+/** @}
+ */
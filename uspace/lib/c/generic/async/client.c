@@ -68,6 +68,20 @@
  *     ...
  *   }
  *
+ *   Several requests can also be pipelined on a single exchange. The
+ *   server handles them in the order in which they were sent.
+ *
+ *   int fibril2(void *arg)
+ *   {
+ *     exch = async_exchange_begin(conn);
+ *     aids[0] = async_send(exch);
+ *     aids[1] = async_send(exch);
+ *     async_exchange_end(exch);
+ *
+ *     async_wait_all(aids, 2);
+ *     ...
+ *   }
+ *
  *
  * 2) Multithreaded server application
  *
@@ -232,6 +246,26 @@ void async_reply_received(ipc_call_t *data)
 	fibril_rmutex_unlock(&message_mutex);
 }
 
+/** Allocate a message record for a call made by the async framework.
+ *
+ * The record is completed by async_reply_received() once the answer
+ * arrives, either through the IPC answerbox or through a ring channel.
+ *
+ * @param dataptr If non-NULL, storage where the reply data will be stored.
+ *
+ * @return Hash of the message or 0 on error.
+ *
+ */
+aid_t async_msg_alloc(ipc_call_t *dataptr)
+{
+	amsg_t *msg = amsg_create();
+	if (msg == NULL)
+		return 0;
+
+	msg->dataptr = dataptr;
+	return (aid_t) msg;
+}
+
 /** Send message and return id of the sent message.
  *
  * The return value can be used as input for async_wait() to wait for
@@ -419,6 +453,41 @@ errno_t async_wait_timeout(aid_t amsgid, errno_t *retval, usec_t timeout)
 	return EOK;
 }
 
+/** Wait for several messages sent by the async framework.
+ *
+ * This is the counterpart of pipelining requests: several messages can be
+ * sent on one exchange without waiting for the answers in between, the
+ * server handles them in the order of arrival, and the answers are then
+ * collected here. Waiting for all of them costs at most as long as waiting
+ * for the slowest one.
+ *
+ * @param amsgids Hashes of the messages to wait for.
+ * @param count   Number of messages.
+ * @param retvals If non-NULL, array of count entries where the retvals of
+ *                the answers will be stored.
+ *
+ * @return EOK if all answers returned EOK, otherwise the first retval
+ *         that was not EOK.
+ *
+ */
+errno_t async_wait_all(aid_t *amsgids, size_t count, errno_t *retvals)
+{
+	errno_t rc = EOK;
+
+	for (size_t i = 0; i < count; i++) {
+		errno_t retval;
+		async_wait_for(amsgids[i], &retval);
+
+		if (retvals)
+			retvals[i] = retval;
+
+		if (rc == EOK)
+			rc = retval;
+	}
+
+	return rc;
+}
+
 /** Discard the message / reply on arrival.
  *
  * The message will be marked to be discarded once the reply arrives in
@@ -847,7 +916,7 @@ void async_msg_5(async_exch_t *exch, sysarg_t imethod, sysarg_t arg1,
 		    arg5, NULL);
 }
 
-static errno_t async_connect_me_to_internal(cap_phone_handle_t phone,
+errno_t async_connect_me_to_internal(cap_phone_handle_t phone,
     iface_t iface, sysarg_t arg2, sysarg_t arg3, sysarg_t flags,
     cap_phone_handle_t *out_phone)
 {
@@ -1058,6 +1127,129 @@ static void async_hangup_internal(cap_phone_handle_t phone)
 	(void) rc;
 }
 
+/** Create a session for a phone obtained by IPC_M_CONNECT_ME_TO.
+ *
+ * The phone is hung up if the session cannot be allocated.
+ *
+ * @param phone Phone of the new connection.
+ * @param iface Connection interface.
+ * @param arg2  User defined argument.
+ * @param arg3  User defined argument.
+ * @param rc    Placeholder for return code. Unused if NULL.
+ *
+ * @return New session on success or NULL on error.
+ *
+ */
+static async_sess_t *async_sess_phone_create(cap_phone_handle_t phone,
+    iface_t iface, sysarg_t arg2, sysarg_t arg3, errno_t *rc)
+{
+	async_sess_t *sess = calloc(1, sizeof(async_sess_t));
+	if (sess == NULL) {
+		async_hangup_internal(phone);
+		if (rc != NULL)
+			*rc = ENOMEM;
+
+		return NULL;
+	}
+
+	sess->iface = iface;
+	sess->phone = phone;
+	sess->arg1 = iface;
+	sess->arg2 = arg2;
+	sess->arg3 = arg3;
+
+	fibril_mutex_initialize(&sess->remote_state_mtx);
+	list_initialize(&sess->exch_list);
+	fibril_mutex_initialize(&sess->mutex);
+
+	return sess;
+}
+
+/** Send IPC_M_CONNECT_ME_TO without waiting for the answer.
+ *
+ * Several connection requests can be in flight on the same exchange. Each
+ * of them must be completed by async_connect_me_to_wait().
+ *
+ * @param exch     Exchange for sending the message.
+ * @param iface    Connection interface.
+ * @param arg2     User defined argument.
+ * @param arg3     User defined argument.
+ * @param blocking Wait until the service becomes available.
+ * @param answer   Storage for the answer, must stay valid until the request
+ *                 is completed.
+ *
+ * @return Hash of the sent request or 0 on error.
+ *
+ */
+aid_t async_connect_me_to_send(async_exch_t *exch, iface_t iface,
+    sysarg_t arg2, sysarg_t arg3, bool blocking, ipc_call_t *answer)
+{
+	return async_send_4(exch, IPC_M_CONNECT_ME_TO, (sysarg_t) iface, arg2,
+	    arg3, blocking ? IPC_FLAG_BLOCKING : 0, answer);
+}
+
+/** Complete a request sent by async_connect_me_to_send().
+ *
+ * @param req    Hash of the request.
+ * @param answer Answer storage passed to async_connect_me_to_send().
+ * @param iface  Connection interface.
+ * @param arg2   User defined argument.
+ * @param arg3   User defined argument.
+ * @param rc     Placeholder for return code. Unused if NULL.
+ *
+ * @return New session on success or NULL on error.
+ *
+ */
+async_sess_t *async_connect_me_to_wait(aid_t req, ipc_call_t *answer,
+    iface_t iface, sysarg_t arg2, sysarg_t arg3, errno_t *rc)
+{
+	errno_t ret;
+
+	async_wait_for(req, &ret);
+	if (ret != EOK) {
+		if (rc != NULL)
+			*rc = ret;
+
+		return NULL;
+	}
+
+	cap_phone_handle_t phone = (cap_phone_handle_t) ipc_get_arg5(answer);
+	return async_sess_phone_create(phone, iface, arg2, arg3, rc);
+}
+
+/** Open a new connection to the server at the other end of a session.
+ *
+ * The connection request goes directly to the server using the arguments
+ * recorded in the session, the same way new connections of parallel
+ * exchanges are created. No exchange of @a sess is used.
+ *
+ * @param sess Session to the server.
+ * @param rc   Placeholder for return code. Unused if NULL.
+ *
+ * @return New session on success or NULL on error.
+ *
+ */
+async_sess_t *async_reconnect(async_sess_t *sess, errno_t *rc)
+{
+	cap_phone_handle_t phone;
+	errno_t ret = async_connect_me_to_internal(sess->phone, sess->arg1,
+	    sess->arg2, sess->arg3, 0, &phone);
+	if (ret != EOK) {
+		if (rc != NULL)
+			*rc = ret;
+
+		return NULL;
+	}
+
+	async_sess_t *nsess = async_sess_phone_create(phone, sess->arg1,
+	    sess->arg2, sess->arg3, rc);
+	if (nsess == NULL)
+		return NULL;
+
+	nsess->iface = sess->iface;
+	return nsess;
+}
+
 /** Wrapper for ipc_hangup.
  *
  * @param sess Session to hung up.
@@ -1068,6 +1260,9 @@ void async_hangup(async_sess_t *sess)
 
 	assert(sess);
 
+	if (sess->ring != NULL)
+		async_ring_detach(sess);
+
 	fibril_mutex_lock(&async_sess_mutex);
 	assert(sess->exchanges == 0);
 
@@ -1328,6 +1523,23 @@ errno_t async_data_read_start(async_exch_t *exch, void *dst, size_t size)
 	    (sysarg_t) size);
 }
 
+/** Start IPC_M_DATA_WRITE using the async framework.
+ *
+ * @param exch    Exchange for sending the message.
+ * @param src     Address of the beginning of the source buffer.
+ * @param size    Size of the source buffer (in bytes).
+ * @param dataptr Storage of call data (arg 2 holds actual data size).
+ *
+ * @return Hash of the sent message or 0 on error.
+ *
+ */
+aid_t async_data_write(async_exch_t *exch, const void *src, size_t size,
+    ipc_call_t *dataptr)
+{
+	return async_send_2(exch, IPC_M_DATA_WRITE, (sysarg_t) src,
+	    (sysarg_t) size, dataptr);
+}
+
 /** Wrapper for IPC_M_DATA_WRITE calls using the async framework.
  *
  * @param exch Exchange for sending the message.
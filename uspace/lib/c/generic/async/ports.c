@@ -64,6 +64,9 @@ typedef struct {
 
 	/** Next available port ID */
 	port_id_t port_id_avail;
+
+	/** Connections may set up shared-memory ring channels */
+	bool ring;
 } interface_t;
 
 /* Port data */
@@ -174,6 +177,7 @@ static interface_t *async_new_interface(iface_t iface)
 
 	interface->iface = iface;
 	interface->port_id_avail = 0;
+	interface->ring = false;
 
 	hash_table_insert(&interface_hash_table, &interface->link);
 
@@ -248,6 +252,61 @@ void async_set_fallback_port_handler(async_port_handler_t handler, void *data)
 	fallback_port_data = data;
 }
 
+/** Allow clients to set up ring channels on connections to an interface.
+ *
+ * Calls received through a ring channel are delivered to the connection
+ * fibril by async_get_call() like any other call, but they can be only
+ * answered, not forwarded. The ring is served by a connection of its own
+ * which carries no other calls, thus the server should opt in only for
+ * interfaces where this does not break per-connection state.
+ *
+ * @param iface Interface.
+ *
+ * @return EOK on success or ENOMEM.
+ *
+ */
+errno_t async_ring_enable(iface_t iface)
+{
+	interface_t *interface;
+
+	fibril_rmutex_lock(&interface_mutex);
+
+	ht_link_t *link = hash_table_find(&interface_hash_table, &iface);
+	if (link)
+		interface = hash_table_get_inst(link, interface_t, link);
+	else
+		interface = async_new_interface(iface);
+
+	if (!interface) {
+		fibril_rmutex_unlock(&interface_mutex);
+		return ENOMEM;
+	}
+
+	interface->ring = true;
+
+	fibril_rmutex_unlock(&interface_mutex);
+
+	return EOK;
+}
+
+bool async_ring_enabled(iface_t iface)
+{
+	bool enabled = false;
+
+	fibril_rmutex_lock(&interface_mutex);
+
+	ht_link_t *link = hash_table_find(&interface_hash_table, &iface);
+	if (link) {
+		interface_t *interface =
+		    hash_table_get_inst(link, interface_t, link);
+		enabled = interface->ring;
+	}
+
+	fibril_rmutex_unlock(&interface_mutex);
+
+	return enabled;
+}
+
 static port_t *async_find_port(iface_t iface, port_id_t port_id)
 {
 	port_t *port = NULL;
@@ -0,0 +1,726 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Shared-memory ring channels.
+ *
+ * A ring channel is an address space area shared by a client and a server
+ * which carries two single-producer single-consumer queues, one for
+ * requests and one for answers. A client attaches a ring to a session with
+ * async_ring_attach() and then posts requests with async_ring_send(). The
+ * answers complete the same message records as ordinary IPC answers, so
+ * async_wait_for() and friends work unchanged.
+ *
+ * The ring is served by a dedicated connection to the server. The kernel
+ * is entered only when a peer has to be woken up: the client sends
+ * IPC_M_RING(ASYNC_RING_KICK) when it posts a request while the server
+ * sleeps in async_get_call() and the server answers the client's
+ * IPC_M_RING(ASYNC_RING_ARM) call when it posts an answer while the
+ * client's ring fibril sleeps.
+ *
+ * Neither peer trusts the contents of the shared area: the number of
+ * entries is negotiated in the setup call, queue indices are always masked
+ * and the client identifies calls by slots which it validates.
+ */
+
+#define _LIBC_ASYNC_C_
+#include <ipc/ipc.h>
+#include <async.h>
+#include "../private/async.h"
+#undef _LIBC_ASYNC_C_
+
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <mem.h>
+#include <as.h>
+#include <refcount.h>
+#include <abi/mm/as.h>
+#include "../private/fibril.h"
+
+/** Client side of a ring channel */
+struct async_ring {
+	/** Phone of the connection serving the ring */
+	cap_phone_handle_t phone;
+
+	/** Task answering the calls */
+	task_id_t task_id;
+
+	/** Shared area */
+	async_ring_shared_t *shared;
+
+	/** Number of entries in each queue */
+	size_t count;
+
+	/** Messages waiting for an answer indexed by slot */
+	aid_t *msgs;
+
+	/** Stack of free slots */
+	size_t *free_slots;
+
+	/** Number of free slots */
+	size_t free_count;
+
+	/** Mutex protecting the request queue and the slots */
+	fibril_mutex_t mutex;
+
+	/** Signalled when a slot becomes free */
+	fibril_condvar_t slot_cv;
+
+	/** Signalled when the first outstanding request is posted */
+	fibril_condvar_t busy_cv;
+
+	/** Signalled when the ring fibril exits */
+	fibril_condvar_t done_cv;
+
+	/** The ring is being detached */
+	bool closing;
+
+	/** The ring fibril exited, no more answers will arrive */
+	bool done;
+};
+
+/** Server side of a ring channel */
+struct async_ring_srv {
+	/** References held by the connection and by unanswered calls */
+	atomic_refcount_t refcnt;
+
+	/** Shared area */
+	async_ring_shared_t *shared;
+
+	/** Number of entries in each queue */
+	size_t count;
+
+	/** Mutex protecting the answer queue and the wakeup state */
+	fibril_rmutex_t mutex;
+
+	/** Held IPC_M_RING(ASYNC_RING_ARM) call or CAP_NIL */
+	cap_call_handle_t armed;
+
+	/** The client is to be woken up as soon as it arms the wakeup */
+	bool wakeup;
+};
+
+static size_t async_ring_size(size_t count)
+{
+	return sizeof(async_ring_shared_t) +
+	    2 * count * sizeof(async_ring_entry_t);
+}
+
+/** Post an entry into a queue.
+ *
+ * The caller must make sure that there is room in the queue.
+ *
+ */
+static void async_ring_push(async_ring_queue_t *queue,
+    async_ring_entry_t *entries, size_t count, const async_ring_entry_t *entry)
+{
+	unsigned int head = atomic_load_explicit(&queue->head,
+	    memory_order_relaxed);
+
+	entries[head & (count - 1)] = *entry;
+	atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+}
+
+/** Take an entry from a queue.
+ *
+ * @return True if an entry was copied out, false if the queue is empty.
+ *
+ */
+static bool async_ring_pop(async_ring_queue_t *queue,
+    async_ring_entry_t *entries, size_t count, async_ring_entry_t *entry)
+{
+	unsigned int tail = atomic_load_explicit(&queue->tail,
+	    memory_order_relaxed);
+	unsigned int head = atomic_load_explicit(&queue->head,
+	    memory_order_acquire);
+
+	if (head == tail)
+		return false;
+
+	*entry = entries[tail & (count - 1)];
+	atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+	return true;
+}
+
+/** Announce that the consumer of a queue is going to sleep.
+ *
+ * @return True if the queue is still empty and the producer is going to
+ *         wake the consumer up, false if the consumer should look again.
+ *
+ */
+static bool async_ring_sleep(async_ring_queue_t *queue)
+{
+	atomic_store(&queue->sleeping, true);
+	atomic_thread_fence(memory_order_seq_cst);
+
+	if (atomic_load(&queue->head) != atomic_load(&queue->tail)) {
+		atomic_store(&queue->sleeping, false);
+		return false;
+	}
+
+	return true;
+}
+
+/** Check whether the consumer of a queue needs a wakeup after a post. */
+static bool async_ring_wakeup_needed(async_ring_queue_t *queue)
+{
+	atomic_thread_fence(memory_order_seq_cst);
+
+	if (!atomic_load_explicit(&queue->sleeping, memory_order_relaxed))
+		return false;
+
+	return atomic_exchange(&queue->sleeping, false);
+}
+
+/** Complete a message as if its answer arrived through IPC. */
+static void async_ring_complete(async_ring_t *ring, aid_t msg,
+    const sysarg_t *args)
+{
+	ipc_call_t data;
+
+	memset(&data, 0, sizeof(data));
+	memcpy(data.args, args, sizeof(data.args));
+	data.flags = IPC_CALL_ANSWERED;
+	data.task_id = ring->task_id;
+	data.answer_label = (sysarg_t) msg;
+
+	async_reply_received(&data);
+}
+
+static void async_ring_fail(async_ring_t *ring, aid_t msg, errno_t rc)
+{
+	sysarg_t args[IPC_CALL_LEN] = { (sysarg_t) rc };
+
+	async_ring_complete(ring, msg, args);
+}
+
+/** Arm the server-side wakeup and wait for it.
+ *
+ * @return EOK when woken up, an error code if the connection is gone.
+ *
+ */
+static errno_t async_ring_arm(async_ring_t *ring)
+{
+	aid_t msg = async_msg_alloc(NULL);
+	if (msg == 0)
+		return ENOMEM;
+
+	errno_t rc = ipc_call_async_1(ring->phone, IPC_M_RING, ASYNC_RING_ARM,
+	    (void *) msg);
+	if (rc != EOK)
+		async_ring_fail(ring, msg, rc);
+
+	async_wait_for(msg, &rc);
+	return rc;
+}
+
+/** Fibril consuming the answer queue of a ring. */
+static errno_t async_ring_fibril(void *arg)
+{
+	async_ring_t *ring = (async_ring_t *) arg;
+	async_ring_queue_t *queue = &ring->shared->ans;
+	async_ring_entry_t *entries = ring->shared->entries + ring->count;
+	async_ring_entry_t entry;
+
+	fibril_mutex_lock(&ring->mutex);
+
+	while (true) {
+		if (async_ring_pop(queue, entries, ring->count, &entry)) {
+			sysarg_t slot = entry.slot;
+
+			/* Ignore answers to calls we have not made. */
+			if ((slot >= ring->count) || (ring->msgs[slot] == 0))
+				continue;
+
+			async_ring_complete(ring, ring->msgs[slot], entry.args);
+			ring->msgs[slot] = 0;
+			ring->free_slots[ring->free_count++] = slot;
+			fibril_condvar_signal(&ring->slot_cv);
+			continue;
+		}
+
+		if (ring->free_count == ring->count) {
+			/* No outstanding calls */
+			if (ring->closing)
+				break;
+
+			fibril_condvar_wait(&ring->busy_cv, &ring->mutex);
+			continue;
+		}
+
+		if (!async_ring_sleep(queue))
+			continue;
+
+		fibril_mutex_unlock(&ring->mutex);
+		errno_t rc = async_ring_arm(ring);
+		fibril_mutex_lock(&ring->mutex);
+
+		if (rc != EOK) {
+			/* The server is gone, fail all outstanding calls. */
+			for (size_t slot = 0; slot < ring->count; slot++) {
+				if (ring->msgs[slot] != 0) {
+					async_ring_fail(ring, ring->msgs[slot],
+					    EHANGUP);
+					ring->msgs[slot] = 0;
+				}
+			}
+
+			break;
+		}
+	}
+
+	ring->done = true;
+	fibril_condvar_broadcast(&ring->slot_cv);
+	fibril_condvar_broadcast(&ring->done_cv);
+	fibril_mutex_unlock(&ring->mutex);
+
+	return EOK;
+}
+
+static void async_ring_destroy(async_ring_t *ring)
+{
+	if (ring->shared != AS_MAP_FAILED)
+		as_area_destroy(ring->shared);
+
+	free(ring->free_slots);
+	free(ring->msgs);
+	free(ring);
+}
+
+/** Attach a shared-memory ring channel to a session.
+ *
+ * The ring is served by a new connection to the server, created the same
+ * way as the connections of parallel exchanges. The server has to opt in
+ * for the interface of the session using async_ring_enable(). Only calls
+ * made with async_ring_send() go through the ring.
+ *
+ * @param sess    Session.
+ * @param entries Minimum number of calls which can be outstanding on the
+ *                ring at the same time.
+ *
+ * @return EOK on success, ENOTSUP if the server does not support rings
+ *         for the interface, or another error code.
+ *
+ */
+errno_t async_ring_attach(async_sess_t *sess, size_t entries)
+{
+	if (sess == NULL)
+		return ENOENT;
+
+	if (sess->ring != NULL)
+		return EEXIST;
+
+	if ((entries == 0) || (entries > ASYNC_RING_MAX_ENTRIES))
+		return EINVAL;
+
+	size_t count = 1;
+	while (count < entries)
+		count <<= 1;
+
+	async_ring_t *ring = calloc(1, sizeof(async_ring_t));
+	if (ring == NULL)
+		return ENOMEM;
+
+	ring->phone = CAP_NIL;
+	ring->count = count;
+	ring->shared = AS_MAP_FAILED;
+	fibril_mutex_initialize(&ring->mutex);
+	fibril_condvar_initialize(&ring->slot_cv);
+	fibril_condvar_initialize(&ring->busy_cv);
+	fibril_condvar_initialize(&ring->done_cv);
+
+	errno_t rc = ENOMEM;
+
+	ring->msgs = calloc(count, sizeof(aid_t));
+	ring->free_slots = calloc(count, sizeof(size_t));
+	if ((ring->msgs == NULL) || (ring->free_slots == NULL))
+		goto error;
+
+	for (size_t slot = 0; slot < count; slot++)
+		ring->free_slots[slot] = count - 1 - slot;
+	ring->free_count = count;
+
+	ring->shared = as_area_create(AS_AREA_ANY, async_ring_size(count),
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (ring->shared == AS_MAP_FAILED)
+		goto error;
+
+	rc = async_connect_me_to_internal(sess->phone, sess->arg1, sess->arg2,
+	    sess->arg3, 0, &ring->phone);
+	if (rc != EOK)
+		goto error;
+
+	ipc_call_t answer;
+	aid_t msg = async_msg_alloc(&answer);
+	if (msg == 0) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	rc = ipc_call_async_5(ring->phone, IPC_M_SHARE_OUT,
+	    (sysarg_t) ring->shared, 0,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
+	    ASYNC_RING_MAGIC, count, (void *) msg);
+	if (rc != EOK)
+		async_ring_fail(ring, msg, rc);
+
+	async_wait_for(msg, &rc);
+	if (rc != EOK)
+		goto error;
+
+	ring->task_id = answer.task_id;
+
+	fid_t fid = fibril_create(async_ring_fibril, ring);
+	if (fid == 0) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	sess->ring = ring;
+	fibril_start(fid);
+
+	return EOK;
+
+error:
+	if (ring->phone != CAP_NIL)
+		ipc_hangup(ring->phone);
+
+	async_ring_destroy(ring);
+	return rc;
+}
+
+/** Detach the ring channel from a session.
+ *
+ * Waits for the answers to all calls outstanding on the ring.
+ *
+ * @param sess Session.
+ *
+ */
+void async_ring_detach(async_sess_t *sess)
+{
+	async_ring_t *ring = sess->ring;
+	assert(ring != NULL);
+
+	sess->ring = NULL;
+
+	fibril_mutex_lock(&ring->mutex);
+
+	ring->closing = true;
+	fibril_condvar_signal(&ring->busy_cv);
+
+	while (!ring->done)
+		fibril_condvar_wait(&ring->done_cv, &ring->mutex);
+
+	fibril_mutex_unlock(&ring->mutex);
+
+	ipc_hangup(ring->phone);
+	async_ring_destroy(ring);
+}
+
+/** Send a message through the ring channel of a session.
+ *
+ * If the session has no ring channel attached, the message is sent as an
+ * ordinary IPC call. The answer is waited for using async_wait_for().
+ *
+ * Calls sent through the ring are not ordered with respect to calls sent
+ * through the phone of the exchange and must not be followed by data
+ * transfers, which need the phone.
+ *
+ * @param exch    Exchange for sending the message.
+ * @param imethod Service-defined interface and method.
+ * @param arg1    Service-defined payload argument.
+ * @param arg2    Service-defined payload argument.
+ * @param arg3    Service-defined payload argument.
+ * @param arg4    Service-defined payload argument.
+ * @param arg5    Service-defined payload argument.
+ * @param dataptr If non-NULL, storage where the reply data will be stored.
+ *
+ * @return Hash of the sent message or 0 on error.
+ *
+ */
+aid_t async_ring_send(async_exch_t *exch, sysarg_t imethod, sysarg_t arg1,
+    sysarg_t arg2, sysarg_t arg3, sysarg_t arg4, sysarg_t arg5,
+    ipc_call_t *dataptr)
+{
+	if (exch == NULL)
+		return 0;
+
+	async_ring_t *ring = exch->sess->ring;
+	if (ring == NULL) {
+		return async_send_5(exch, imethod, arg1, arg2, arg3, arg4,
+		    arg5, dataptr);
+	}
+
+	aid_t msg = async_msg_alloc(dataptr);
+	if (msg == 0)
+		return 0;
+
+	async_ring_entry_t entry = {
+		.args = { imethod, arg1, arg2, arg3, arg4, arg5 }
+	};
+
+	fibril_mutex_lock(&ring->mutex);
+
+	while ((ring->free_count == 0) && (!ring->done))
+		fibril_condvar_wait(&ring->slot_cv, &ring->mutex);
+
+	if (ring->done) {
+		fibril_mutex_unlock(&ring->mutex);
+		async_ring_fail(ring, msg, EHANGUP);
+		return msg;
+	}
+
+	entry.slot = ring->free_slots[--ring->free_count];
+	ring->msgs[entry.slot] = msg;
+
+	async_ring_push(&ring->shared->req, ring->shared->entries, ring->count,
+	    &entry);
+
+	if (ring->free_count == ring->count - 1)
+		fibril_condvar_signal(&ring->busy_cv);
+
+	bool kick = async_ring_wakeup_needed(&ring->shared->req);
+
+	fibril_mutex_unlock(&ring->mutex);
+
+	if (kick)
+		ipc_call_async_1(ring->phone, IPC_M_RING, ASYNC_RING_KICK, NULL);
+
+	return msg;
+}
+
+static void async_ring_srv_destroy(async_ring_srv_t *srv)
+{
+	as_area_destroy(srv->shared);
+	fibril_rmutex_destroy(&srv->mutex);
+	free(srv);
+}
+
+static void async_ring_srv_put(async_ring_srv_t *srv)
+{
+	if (refcount_down(&srv->refcnt))
+		async_ring_srv_destroy(srv);
+}
+
+/** Accept the IPC_M_SHARE_OUT call setting up a ring channel.
+ *
+ * The call is answered in any case.
+ *
+ * @param call Setup call.
+ *
+ * @return Server side of the ring or NULL on failure.
+ *
+ */
+async_ring_srv_t *async_ring_srv_accept(ipc_call_t *call)
+{
+	size_t size = ipc_get_arg2(call);
+	size_t count = ipc_get_arg5(call);
+
+	if ((count == 0) || (count > ASYNC_RING_MAX_ENTRIES) ||
+	    ((count & (count - 1)) != 0) || (size < async_ring_size(count))) {
+		async_answer_0(call, EINVAL);
+		return NULL;
+	}
+
+	async_ring_srv_t *srv = calloc(1, sizeof(async_ring_srv_t));
+	if (srv == NULL) {
+		async_answer_0(call, ENOMEM);
+		return NULL;
+	}
+
+	if (fibril_rmutex_initialize(&srv->mutex) != EOK) {
+		free(srv);
+		async_answer_0(call, ENOMEM);
+		return NULL;
+	}
+
+	void *dst;
+	errno_t rc = async_share_out_finalize(call, &dst);
+	if ((rc != EOK) || (dst == AS_MAP_FAILED)) {
+		fibril_rmutex_destroy(&srv->mutex);
+		free(srv);
+		return NULL;
+	}
+
+	refcount_init(&srv->refcnt);
+	srv->shared = (async_ring_shared_t *) dst;
+	srv->count = count;
+	srv->armed = CAP_NIL;
+	srv->wakeup = false;
+
+	return srv;
+}
+
+/** Take a request from the ring.
+ *
+ * If there is no request, the client is asked to kick the server when it
+ * posts one.
+ *
+ * @param srv  Server side of the ring.
+ * @param call Storage for the request.
+ *
+ * @return True if a request was received.
+ *
+ */
+bool async_ring_srv_receive(async_ring_srv_t *srv, ipc_call_t *call)
+{
+	async_ring_queue_t *queue = &srv->shared->req;
+	async_ring_entry_t entry;
+
+	if (!async_ring_pop(queue, srv->shared->entries, srv->count, &entry)) {
+		if (async_ring_sleep(queue))
+			return false;
+
+		if (!async_ring_pop(queue, srv->shared->entries, srv->count,
+		    &entry))
+			return false;
+	}
+
+	memset(call, 0, sizeof(ipc_call_t));
+	memcpy(call->args, entry.args, sizeof(call->args));
+	call->flags = ASYNC_CALL_RING;
+	call->answer_label = entry.slot;
+
+	/* The call refers to the ring until it is answered. */
+	call->cap_handle = (cap_call_handle_t) srv;
+	refcount_up(&srv->refcnt);
+
+	return true;
+}
+
+/** Handle an IPC_M_RING call received by the connection serving a ring.
+ *
+ * @param srv  Server side of the ring.
+ * @param call IPC_M_RING call.
+ *
+ */
+void async_ring_srv_control(async_ring_srv_t *srv, ipc_call_t *call)
+{
+	bool wakeup = true;
+
+	if (ipc_get_arg1(call) == ASYNC_RING_ARM) {
+		fibril_rmutex_lock(&srv->mutex);
+
+		if ((srv->wakeup) || (srv->armed != CAP_NIL)) {
+			srv->wakeup = false;
+		} else {
+			srv->armed = call->cap_handle;
+			call->cap_handle = CAP_NIL;
+			wakeup = false;
+		}
+
+		fibril_rmutex_unlock(&srv->mutex);
+	}
+
+	/* Kicks need no action, the server is awake by now. */
+	if (wakeup)
+		async_answer_0(call, EOK);
+}
+
+/** Answer a call received through a ring.
+ *
+ * @param call   Call to answer.
+ * @param retval Return value.
+ * @param arg1   Service-defined return value.
+ * @param arg2   Service-defined return value.
+ * @param arg3   Service-defined return value.
+ * @param arg4   Service-defined return value.
+ * @param arg5   Service-defined return value.
+ *
+ * @return EOK.
+ *
+ */
+errno_t async_ring_srv_answer(ipc_call_t *call, errno_t retval, sysarg_t arg1,
+    sysarg_t arg2, sysarg_t arg3, sysarg_t arg4, sysarg_t arg5)
+{
+	async_ring_srv_t *srv = (async_ring_srv_t *) call->cap_handle;
+	assert(srv != NULL);
+	call->cap_handle = CAP_NIL;
+
+	async_ring_entry_t entry = {
+		.slot = call->answer_label,
+		.args = { (sysarg_t) retval, arg1, arg2, arg3, arg4, arg5 }
+	};
+
+	cap_call_handle_t armed = CAP_NIL;
+
+	fibril_rmutex_lock(&srv->mutex);
+
+	async_ring_push(&srv->shared->ans, srv->shared->entries + srv->count,
+	    srv->count, &entry);
+
+	if (async_ring_wakeup_needed(&srv->shared->ans)) {
+		if (srv->armed != CAP_NIL) {
+			armed = srv->armed;
+			srv->armed = CAP_NIL;
+		} else {
+			srv->wakeup = true;
+		}
+	}
+
+	fibril_rmutex_unlock(&srv->mutex);
+
+	if (armed != CAP_NIL)
+		ipc_answer_0(armed, EOK);
+
+	async_ring_srv_put(srv);
+	return EOK;
+}
+
+/** Close the server side of a ring when its connection ends.
+ *
+ * The client's wakeup call is released so that the client notices that the
+ * server is gone. Calls received through the ring which are still being
+ * handled keep the ring alive until they are answered.
+ *
+ * @param srv Server side of the ring.
+ *
+ */
+void async_ring_srv_close(async_ring_srv_t *srv)
+{
+	fibril_rmutex_lock(&srv->mutex);
+
+	cap_call_handle_t armed = srv->armed;
+	srv->armed = CAP_NIL;
+
+	fibril_rmutex_unlock(&srv->mutex);
+
+	if (armed != CAP_NIL)
+		ipc_answer_0(armed, EHANGUP);
+
+	async_ring_srv_put(srv);
+}
+
+/** @}
+ */
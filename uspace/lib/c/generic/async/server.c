@@ -105,6 +105,7 @@
 #include <ipc/event.h>
 #include <fibril.h>
 #include <adt/hash_table.h>
+#include <adt/ohash_table.h>
 #include <adt/hash.h>
 #include <adt/list.h>
 #include <assert.h>
@@ -156,6 +157,12 @@ typedef struct {
 
 	/** Client data */
 	void *data;
+
+	/** Interface of the connection. */
+	iface_t iface;
+
+	/** Ring channel served by the connection or NULL. */
+	async_ring_srv_t *ring;
 } connection_t;
 
 /* Member of notification_t::msg_list. */
@@ -215,7 +222,7 @@ void async_set_client_data_destructor(async_client_data_dtor_t dtor)
 }
 
 static fibril_rmutex_t client_mutex;
-static hash_table_t client_hash_table;
+static ohash_table_t client_hash_table;
 
 // TODO: lockfree notification_queue?
 static fibril_rmutex_t notification_mutex;
@@ -229,6 +236,14 @@ static long notification_freelist_used = 0;
 
 static sysarg_t notification_avail = 0;
 
+/*
+ * Answers deferred while more received calls are pending. They are sent by
+ * a single syscall once the pending calls are handed out.
+ */
+static fibril_rmutex_t answer_batch_mutex;
+static ipc_call_t answer_batch[IPC_MAX_BATCH];
+static atomic_size_t answer_batch_count;
+
 static size_t client_key_hash(const void *key)
 {
 	const task_id_t *in_task_id = key;
@@ -262,7 +277,7 @@ static client_t *async_client_get(task_id_t client_id, bool create)
 	client_t *client = NULL;
 
 	fibril_rmutex_lock(&client_mutex);
-	ht_link_t *link = hash_table_find(&client_hash_table, &client_id);
+	ht_link_t *link = ohash_table_find(&client_hash_table, &client_id);
 	if (link) {
 		client = hash_table_get_inst(link, client_t, link);
 		client->refcnt++;
@@ -272,10 +287,15 @@ static client_t *async_client_get(task_id_t client_id, bool create)
 		client = malloc(sizeof(client_t));
 		if (client) {
 			client->in_task_id = client_id;
-			client->data = async_client_data_create();
-
 			client->refcnt = 1;
-			hash_table_insert(&client_hash_table, &client->link);
+
+			if (ohash_table_insert(&client_hash_table,
+			    &client->link) == EOK) {
+				client->data = async_client_data_create();
+			} else {
+				free(client);
+				client = NULL;
+			}
 		}
 	}
 
@@ -290,7 +310,7 @@ static void async_client_put(client_t *client)
 	fibril_rmutex_lock(&client_mutex);
 
 	if (--client->refcnt == 0) {
-		hash_table_remove(&client_hash_table, &client->in_task_id);
+		ohash_table_remove(&client_hash_table, &client->in_task_id);
 		destroy = true;
 	} else
 		destroy = false;
@@ -363,6 +383,13 @@ static errno_t connection_fibril(void *arg)
 	while (mpsc_receive(c, &call, NULL) == EOK)
 		ipc_answer_0(call.cap_handle, EHANGUP);
 
+	/*
+	 * Calls received through the ring may still be answered by other
+	 * fibrils, they hold their own references.
+	 */
+	if (fibril_connection->ring)
+		async_ring_srv_close(fibril_connection->ring);
+
 	/*
 	 * Clean up memory.
 	 */
@@ -771,6 +798,19 @@ errno_t async_irq_unsubscribe(cap_irq_handle_t ihandle)
 	return ipc_irq_unsubscribe(ihandle);
 }
 
+/** Route an IRQ to a CPU.
+ *
+ * @param ihandle  IRQ capability handle.
+ * @param cpu      CPU ID or IRQ_CPU_ANY.
+ *
+ * @return Zero on success or an error code.
+ *
+ */
+errno_t async_irq_set_affinity(cap_irq_handle_t ihandle, unsigned int cpu)
+{
+	return ipc_irq_set_affinity(ihandle, cpu);
+}
+
 /** Subscribe to event notifications.
  *
  * @param evno    Event type to subscribe.
@@ -856,8 +896,52 @@ bool async_get_call_timeout(ipc_call_t *call, usec_t usecs)
 		expires = &ts;
 	}
 
-	errno_t rc = mpsc_receive(fibril_connection->msg_channel,
-	    call, expires);
+	connection_t *conn = fibril_connection;
+	errno_t rc;
+
+	while (true) {
+		if (conn->ring) {
+			/*
+			 * Calls sent through the phone take precedence so that
+			 * ring control messages are handled promptly.
+			 */
+			rc = mpsc_try_receive(conn->msg_channel, call);
+			if (rc == EAGAIN) {
+				if (async_ring_srv_receive(conn->ring, call)) {
+					call->task_id = conn->in_task_id;
+					call->request_label = (sysarg_t) conn;
+					return true;
+				}
+
+				rc = mpsc_receive(conn->msg_channel, call,
+				    expires);
+			}
+		} else {
+			rc = mpsc_receive(conn->msg_channel, call, expires);
+		}
+
+		if (rc != EOK)
+			break;
+
+		if (ipc_get_imethod(call) == IPC_M_RING) {
+			if (conn->ring)
+				async_ring_srv_control(conn->ring, call);
+			else
+				async_answer_0(call, ENOTSUP);
+			continue;
+		}
+
+		if ((ipc_get_imethod(call) == IPC_M_SHARE_OUT) &&
+		    (ipc_get_arg4(call) == ASYNC_RING_MAGIC)) {
+			if ((conn->ring) || (!async_ring_enabled(conn->iface)))
+				async_answer_0(call, ENOTSUP);
+			else
+				conn->ring = async_ring_srv_accept(call);
+			continue;
+		}
+
+		break;
+	}
 
 	if (rc == ETIMEOUT)
 		return false;
@@ -956,6 +1040,7 @@ static void handle_call(ipc_call_t *call)
 		async_port_handler_t handler =
 		    async_get_port_handler(iface, 0, &data);
 
+		conn->iface = iface;
 		async_new_connection(conn, call->task_id, call, handler, data);
 		return;
 	}
@@ -1022,8 +1107,10 @@ void __async_server_init(void)
 		abort();
 	if (fibril_rmutex_initialize(&notification_mutex) != EOK)
 		abort();
+	if (fibril_rmutex_initialize(&answer_batch_mutex) != EOK)
+		abort();
 
-	if (!hash_table_create(&client_hash_table, 0, 0, &client_hash_table_ops))
+	if (!ohash_table_create(&client_hash_table, 0, &client_hash_table_ops))
 		abort();
 
 	if (!hash_table_create(&notification_hash_table, 0, 0,
@@ -1037,6 +1124,77 @@ void __async_server_fini(void)
 {
 	fibril_rmutex_destroy(&client_mutex);
 	fibril_rmutex_destroy(&notification_mutex);
+	fibril_rmutex_destroy(&answer_batch_mutex);
+}
+
+static void async_answer_flush_locked(void)
+{
+	size_t count = atomic_load_explicit(&answer_batch_count,
+	    memory_order_relaxed);
+
+	if (count > 0) {
+		(void) ipc_answer_batch(answer_batch, count);
+		atomic_store_explicit(&answer_batch_count, 0,
+		    memory_order_relaxed);
+	}
+}
+
+/** Send all deferred answers. */
+void async_answer_flush(void)
+{
+	if (atomic_load_explicit(&answer_batch_count, memory_order_relaxed) == 0)
+		return;
+
+	fibril_rmutex_lock(&answer_batch_mutex);
+	async_answer_flush_locked();
+	fibril_rmutex_unlock(&answer_batch_mutex);
+}
+
+/** Defer an answer into the current batch if possible.
+ *
+ * Answers are deferred only while more received calls are pending, i.e.
+ * when the thread is going to handle another call instead of blocking in
+ * the kernel. Answers to system methods are never deferred, because the
+ * kernel acts on them and the server may depend on the result. The error
+ * code of a deferred answer is not reported.
+ *
+ * @return True if the answer was deferred.
+ *
+ */
+static bool async_answer_defer(ipc_call_t *call, errno_t retval,
+    sysarg_t arg1, sysarg_t arg2, sysarg_t arg3, sysarg_t arg4,
+    sysarg_t arg5)
+{
+	if (ipc_get_imethod(call) < IPC_FIRST_USER_METHOD)
+		return false;
+
+	if (!fibril_ipc_pending())
+		return false;
+
+	fibril_rmutex_lock(&answer_batch_mutex);
+
+	size_t count = atomic_load_explicit(&answer_batch_count,
+	    memory_order_relaxed);
+	ipc_call_t *answer = &answer_batch[count];
+
+	answer->cap_handle = call->cap_handle;
+	ipc_set_retval(answer, retval);
+	ipc_set_arg1(answer, arg1);
+	ipc_set_arg2(answer, arg2);
+	ipc_set_arg3(answer, arg3);
+	ipc_set_arg4(answer, arg4);
+	ipc_set_arg5(answer, arg5);
+
+	atomic_store_explicit(&answer_batch_count, count + 1,
+	    memory_order_relaxed);
+
+	if (count + 1 == IPC_MAX_BATCH)
+		async_answer_flush_locked();
+
+	fibril_rmutex_unlock(&answer_batch_mutex);
+
+	call->cap_handle = CAP_NIL;
+	return true;
 }
 
 errno_t async_accept_0(ipc_call_t *call)
@@ -1049,16 +1207,30 @@ errno_t async_accept_0(ipc_call_t *call)
 
 errno_t async_answer_0(ipc_call_t *call, errno_t retval)
 {
+	if (call->flags & ASYNC_CALL_RING)
+		return async_ring_srv_answer(call, retval, 0, 0, 0, 0, 0);
+
 	cap_call_handle_t chandle = call->cap_handle;
 	assert(chandle != CAP_NIL);
+
+	if (async_answer_defer(call, retval, 0, 0, 0, 0, 0))
+		return EOK;
+
 	call->cap_handle = CAP_NIL;
 	return ipc_answer_0(chandle, retval);
 }
 
 errno_t async_answer_1(ipc_call_t *call, errno_t retval, sysarg_t arg1)
 {
+	if (call->flags & ASYNC_CALL_RING)
+		return async_ring_srv_answer(call, retval, arg1, 0, 0, 0, 0);
+
 	cap_call_handle_t chandle = call->cap_handle;
 	assert(chandle != CAP_NIL);
+
+	if (async_answer_defer(call, retval, arg1, 0, 0, 0, 0))
+		return EOK;
+
 	call->cap_handle = CAP_NIL;
 	return ipc_answer_1(chandle, retval, arg1);
 }
@@ -1066,8 +1238,15 @@ errno_t async_answer_1(ipc_call_t *call, errno_t retval, sysarg_t arg1)
 errno_t async_answer_2(ipc_call_t *call, errno_t retval, sysarg_t arg1,
     sysarg_t arg2)
 {
+	if (call->flags & ASYNC_CALL_RING)
+		return async_ring_srv_answer(call, retval, arg1, arg2, 0, 0, 0);
+
 	cap_call_handle_t chandle = call->cap_handle;
 	assert(chandle != CAP_NIL);
+
+	if (async_answer_defer(call, retval, arg1, arg2, 0, 0, 0))
+		return EOK;
+
 	call->cap_handle = CAP_NIL;
 	return ipc_answer_2(chandle, retval, arg1, arg2);
 }
@@ -1075,8 +1254,15 @@ errno_t async_answer_2(ipc_call_t *call, errno_t retval, sysarg_t arg1,
 errno_t async_answer_3(ipc_call_t *call, errno_t retval, sysarg_t arg1,
     sysarg_t arg2, sysarg_t arg3)
 {
+	if (call->flags & ASYNC_CALL_RING)
+		return async_ring_srv_answer(call, retval, arg1, arg2, arg3, 0, 0);
+
 	cap_call_handle_t chandle = call->cap_handle;
 	assert(chandle != CAP_NIL);
+
+	if (async_answer_defer(call, retval, arg1, arg2, arg3, 0, 0))
+		return EOK;
+
 	call->cap_handle = CAP_NIL;
 	return ipc_answer_3(chandle, retval, arg1, arg2, arg3);
 }
@@ -1084,8 +1270,15 @@ errno_t async_answer_3(ipc_call_t *call, errno_t retval, sysarg_t arg1,
 errno_t async_answer_4(ipc_call_t *call, errno_t retval, sysarg_t arg1,
     sysarg_t arg2, sysarg_t arg3, sysarg_t arg4)
 {
+	if (call->flags & ASYNC_CALL_RING)
+		return async_ring_srv_answer(call, retval, arg1, arg2, arg3, arg4, 0);
+
 	cap_call_handle_t chandle = call->cap_handle;
 	assert(chandle != CAP_NIL);
+
+	if (async_answer_defer(call, retval, arg1, arg2, arg3, arg4, 0))
+		return EOK;
+
 	call->cap_handle = CAP_NIL;
 	return ipc_answer_4(chandle, retval, arg1, arg2, arg3, arg4);
 }
@@ -1093,8 +1286,15 @@ errno_t async_answer_4(ipc_call_t *call, errno_t retval, sysarg_t arg1,
 errno_t async_answer_5(ipc_call_t *call, errno_t retval, sysarg_t arg1,
     sysarg_t arg2, sysarg_t arg3, sysarg_t arg4, sysarg_t arg5)
 {
+	if (call->flags & ASYNC_CALL_RING)
+		return async_ring_srv_answer(call, retval, arg1, arg2, arg3, arg4, arg5);
+
 	cap_call_handle_t chandle = call->cap_handle;
 	assert(chandle != CAP_NIL);
+
+	if (async_answer_defer(call, retval, arg1, arg2, arg3, arg4, arg5))
+		return EOK;
+
 	call->cap_handle = CAP_NIL;
 	return ipc_answer_5(chandle, retval, arg1, arg2, arg3, arg4, arg5);
 }
@@ -1104,6 +1304,12 @@ static errno_t async_forward_fast(ipc_call_t *call, async_exch_t *exch,
 {
 	assert(call);
 
+	if (call->flags & ASYNC_CALL_RING) {
+		/* Calls received through a ring cannot be forwarded. */
+		async_ring_srv_answer(call, ENOTSUP, 0, 0, 0, 0, 0);
+		return ENOTSUP;
+	}
+
 	cap_call_handle_t chandle = call->cap_handle;
 	assert(chandle != CAP_NIL);
 	call->cap_handle = CAP_NIL;
@@ -1121,6 +1327,12 @@ static errno_t async_forward_slow(ipc_call_t *call, async_exch_t *exch,
 {
 	assert(call);
 
+	if (call->flags & ASYNC_CALL_RING) {
+		/* Calls received through a ring cannot be forwarded. */
+		async_ring_srv_answer(call, ENOTSUP, 0, 0, 0, 0, 0);
+		return ENOTSUP;
+	}
+
 	cap_call_handle_t chandle = call->cap_handle;
 	assert(chandle != CAP_NIL);
 	call->cap_handle = CAP_NIL;
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/**
+ * @file  cpuset.c
+ * @brief Restricting the processors threads of a task run on.
+ */
+
+#include <cpuset.h>
+#include <libc.h>
+#include <mem.h>
+
+/** Remove all processors from a CPU set.
+ *
+ * @param set CPU set.
+ *
+ */
+void cpuset_clear(cpuset_t *set)
+{
+	memset(set->bits, 0, sizeof(set->bits));
+}
+
+/** Add a processor to a CPU set.
+ *
+ * @param set CPU set.
+ * @param cpu Processor ID. IDs out of range are ignored.
+ *
+ */
+void cpuset_add(cpuset_t *set, unsigned int cpu)
+{
+	if (cpu < CPUSET_CPUS_MAX)
+		set->bits[cpu / 8] |= 1 << (cpu % 8);
+}
+
+/** Remove a processor from a CPU set.
+ *
+ * @param set CPU set.
+ * @param cpu Processor ID. IDs out of range are ignored.
+ *
+ */
+void cpuset_remove(cpuset_t *set, unsigned int cpu)
+{
+	if (cpu < CPUSET_CPUS_MAX)
+		set->bits[cpu / 8] &= ~(1 << (cpu % 8));
+}
+
+/** Check whether a CPU set contains a processor.
+ *
+ * @param set CPU set.
+ * @param cpu Processor ID.
+ *
+ * @return True if the processor is in the set.
+ *
+ */
+bool cpuset_contains(const cpuset_t *set, unsigned int cpu)
+{
+	if (cpu >= CPUSET_CPUS_MAX)
+		return false;
+
+	return (set->bits[cpu / 8] & (1 << (cpu % 8))) != 0;
+}
+
+/** Get the number of processors in a CPU set.
+ *
+ * @param set CPU set.
+ *
+ * @return Number of processors.
+ *
+ */
+unsigned int cpuset_count(const cpuset_t *set)
+{
+	unsigned int count = 0;
+
+	for (unsigned int cpu = 0; cpu < CPUSET_CPUS_MAX; cpu++) {
+		if (cpuset_contains(set, cpu))
+			count++;
+	}
+
+	return count;
+}
+
+static errno_t cpuset_set(cpuset_scope_t scope, const cpuset_t *set)
+{
+	if (set == NULL)
+		return (errno_t) __SYSCALL3(SYS_CPUSET_SET, scope, 0, 0);
+
+	return (errno_t) __SYSCALL3(SYS_CPUSET_SET, scope,
+	    (sysarg_t) set->bits, sizeof(set->bits));
+}
+
+static errno_t cpuset_get(cpuset_scope_t scope, cpuset_t *set)
+{
+	cpuset_clear(set);
+
+	return (errno_t) __SYSCALL3(SYS_CPUSET_GET, scope,
+	    (sysarg_t) set->bits, sizeof(set->bits));
+}
+
+/** Restrict the processors the current thread runs on.
+ *
+ * The CPU set of the thread takes precedence over the CPU set of the
+ * task. Note that the fibrils of a task may be scheduled on any of its
+ * threads, so restricting a single thread is mostly useful for threads
+ * dedicated to a particular job.
+ *
+ * @param set CPU set or NULL to use the CPU set of the task again.
+ *
+ * @return EOK on success.
+ * @return EINVAL if the set contains no active processor.
+ *
+ */
+errno_t cpuset_set_thread(const cpuset_t *set)
+{
+	return cpuset_set(CPUSET_SCOPE_THREAD, set);
+}
+
+/** Restrict the processors the threads of the current task run on.
+ *
+ * The CPU set applies to all threads of the task, including those
+ * created later, which do not have a CPU set of their own. Threads
+ * without any CPU set run on all processors which are not isolated.
+ *
+ * @param set CPU set or NULL to lift the restriction.
+ *
+ * @return EOK on success.
+ * @return EINVAL if the set contains no active processor.
+ *
+ */
+errno_t cpuset_set_task(const cpuset_t *set)
+{
+	return cpuset_set(CPUSET_SCOPE_TASK, set);
+}
+
+/** Get the processors the current thread may run on.
+ *
+ * @param set Place to store the CPU set.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t cpuset_get_thread(cpuset_t *set)
+{
+	return cpuset_get(CPUSET_SCOPE_THREAD, set);
+}
+
+/** Get the processors the threads of the current task may run on.
+ *
+ * @param set Place to store the CPU set.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t cpuset_get_task(cpuset_t *set)
+{
+	return cpuset_get(CPUSET_SCOPE_TASK, set);
+}
+
+/** @}
+ */
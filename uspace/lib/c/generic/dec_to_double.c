@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Correctly rounded conversion of decimal numbers to doubles.
+ *
+ * Uses the algorithm described in:
+ *   Number Parsing at a Gigabyte per Second
+ *   Lemire, 2021
+ * which is based on an idea of Michael Eisel.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <mem.h>
+
+#include "private/dec_to_double.h"
+#include "private/power_of_ten.h"
+
+/** Binary exponent of a normalized 10^q, offset by the bias and 63.
+ *
+ * Equal to floor(log2(10^q)) + 1024 + 63 for -325 <= q <= 308.
+ */
+static int pow10_bin_exp(int q)
+{
+	return (((152170 + 65536) * q) >> 16) + 1024 + 63;
+}
+
+/** Convert w * 10^q with w != 0 to a double.
+ *
+ * @return true on success, false if the result cannot be determined
+ *         without more precision or is not a normal number.
+ */
+static bool eisel_lemire(uint64_t w, int q, double *res)
+{
+	assert(w != 0);
+
+	if (q < FP_POW10_128_MIN || FP_POW10_128_MAX < q)
+		return false;
+
+	const uint64_t *pow10 = fp_pow10_128[q - FP_POW10_128_MIN];
+
+	int lz = __builtin_clzll(w);
+	w <<= lz;
+
+	uint64_t upper;
+	uint64_t lower = fp_umul128(w, pow10[0], &upper);
+
+	/*
+	 * If the bits below the 54-bit result are all ones the truncated
+	 * lower half of 10^q might still carry into them. Take it into
+	 * account.
+	 */
+	if ((upper & 0x1ff) == 0x1ff && lower + w < lower) {
+		uint64_t mid;
+		uint64_t low = fp_umul128(w, pow10[1], &mid);
+
+		uint64_t middle = lower + mid;
+		if (middle < lower)
+			++upper;
+
+		if (middle + 1 == 0 && (upper & 0x1ff) == 0x1ff &&
+		    low + w < low)
+			return false;
+
+		lower = middle;
+	}
+
+	uint64_t upper_bit = upper >> 63;
+	uint64_t mantissa = upper >> (upper_bit + 9);
+	lz += 1 ^ upper_bit;
+
+	/* Possibly exactly halfway between two doubles. */
+	if (lower == 0 && (upper & 0x1ff) == 0 && (mantissa & 3) == 1)
+		return false;
+
+	/* Round to nearest, drop the extra bit. */
+	mantissa += mantissa & 1;
+	mantissa >>= 1;
+
+	if (mantissa >= (1ULL << 53)) {
+		mantissa = 1ULL << 52;
+		--lz;
+	}
+
+	mantissa &= ~(1ULL << 52);
+
+	int exponent = pow10_bin_exp(q) - lz;
+
+	/* Subnormal numbers and overflows are left to the slow path. */
+	if (exponent < 1 || 2046 < exponent)
+		return false;
+
+	uint64_t bits = mantissa | ((uint64_t) exponent << 52);
+
+	static_assert(sizeof(*res) == sizeof(bits), "");
+	memcpy(res, &bits, sizeof(bits));
+	return true;
+}
+
+/** Convert a decimal number to the nearest double.
+ *
+ * @param w         Decimal significand, ie the first up to 19 significant
+ *                  digits of the number.
+ * @param q         Decimal exponent; the number is w * 10^q.
+ * @param truncated True if further non-zero digits following w were
+ *                  dropped.
+ * @param res       Place to store the non-negative result.
+ *
+ * @return true on success, false if the caller has to fall back to
+ *         a slower conversion.
+ */
+bool dec_to_double(uint64_t w, int q, bool truncated, double *res)
+{
+	if (w == 0) {
+		*res = 0.0;
+		return true;
+	}
+
+	if (!eisel_lemire(w, q, res))
+		return false;
+
+	if (truncated) {
+		/*
+		 * The exact number lies between w * 10^q and (w + 1) * 10^q.
+		 * If both round to the same double, so does the number.
+		 */
+		double upper;
+
+		if (w + 1 == 0 || !eisel_lemire(w + 1, q, &upper) ||
+		    upper != *res)
+			return false;
+	}
+
+	return true;
+}
+
+/** @}
+ */
@@ -160,5 +160,63 @@ errno_t hw_res_dma_channel_remain(async_sess_t *sess, unsigned channel, size_t *
 	return ret;
 }
 
+/** Switch the device to message signalled interrupts.
+ *
+ * The provider allocates up to @a count vectors, programs the MSI-X or MSI
+ * capability of the device and disables its legacy INTx interrupt. The
+ * vectors are numbered consecutively starting at @a irq and stay masked
+ * until enabled with hw_res_enable_interrupt().
+ *
+ * @param sess       Session to the HW resource provider
+ * @param[in,out] count Number of requested vectors on input, number of
+ *                   allocated vectors (at least one) on output
+ * @param[out] irq   Place to store the IRQ number of the first vector
+ *
+ * @return EOK on success, ENOTSUP if the device or the platform does not
+ *         support message signalled interrupts, ENOMEM if no vectors are
+ *         available
+ *
+ */
+errno_t hw_res_msi_setup(async_sess_t *sess, size_t *count, int *irq)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+
+	sysarg_t first;
+	sysarg_t granted;
+	const errno_t ret = async_req_2_2(exch, DEV_IFACE_ID(HW_RES_DEV_IFACE),
+	    HW_RES_MSI_SETUP, *count, &first, &granted);
+
+	async_exchange_end(exch);
+
+	if (ret == EOK) {
+		*irq = first;
+		*count = granted;
+	}
+
+	return ret;
+}
+
+/** Release message signalled interrupts of the device.
+ *
+ * The vectors allocated by hw_res_msi_setup() are freed and the device
+ * falls back to its legacy INTx interrupt.
+ *
+ * @param sess Session to the HW resource provider
+ *
+ * @return Error code.
+ *
+ */
+errno_t hw_res_msi_release(async_sess_t *sess)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+
+	const errno_t ret = async_req_1_0(exch, DEV_IFACE_ID(HW_RES_DEV_IFACE),
+	    HW_RES_MSI_RELEASE);
+
+	async_exchange_end(exch);
+
+	return ret;
+}
+
 /** @}
  */
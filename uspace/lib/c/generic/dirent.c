@@ -40,10 +40,20 @@
 #include <assert.h>
 #include <string.h>
 
+/** Size of the buffer for directory entries read ahead */
+#define DIR_BUF_SIZE 4096
+
 struct __dirstream {
 	int fd;
 	struct dirent res;
+	/** Position following the entries in the buffer */
 	aoff64_t pos;
+	/** Entry names read ahead, each terminated by NUL */
+	char buf[DIR_BUF_SIZE];
+	/** Number of valid bytes in @c buf */
+	size_t buf_len;
+	/** Offset of the next entry in @c buf */
+	size_t buf_off;
 };
 
 /** Open directory.
@@ -78,6 +88,8 @@ DIR *opendir(const char *dirname)
 
 	dirp->fd = fd;
 	dirp->pos = 0;
+	dirp->buf_len = 0;
+	dirp->buf_off = 0;
 	return dirp;
 }
 
@@ -90,18 +102,30 @@ DIR *opendir(const char *dirname)
 struct dirent *readdir(DIR *dirp)
 {
 	errno_t rc;
-	ssize_t len = 0;
-
-	rc = vfs_read_short(dirp->fd, dirp->pos, dirp->res.d_name,
-	    sizeof(dirp->res.d_name), &len);
-	if (rc != EOK) {
-		errno = rc;
-		return NULL;
+	size_t len;
+
+	if (dirp->buf_off >= dirp->buf_len) {
+		/* Read the following entries in one request. */
+		rc = vfs_readdir(dirp->fd, &dirp->pos, dirp->buf,
+		    sizeof(dirp->buf), &len);
+		if (rc != EOK) {
+			errno = rc;
+			return NULL;
+		}
+
+		dirp->buf_len = len;
+		dirp->buf_off = 0;
 	}
 
-	assert(strnlen(dirp->res.d_name, sizeof(dirp->res.d_name)) < sizeof(dirp->res.d_name));
+	const char *name = dirp->buf + dirp->buf_off;
+	len = strnlen(name, dirp->buf_len - dirp->buf_off);
+
+	assert(len < sizeof(dirp->res.d_name));
+	assert(dirp->buf_off + len < dirp->buf_len);
 
-	dirp->pos += len;
+	memcpy(dirp->res.d_name, name, len);
+	dirp->res.d_name[len] = '\0';
+	dirp->buf_off += len + 1;
 
 	return &dirp->res;
 }
@@ -113,6 +137,8 @@ struct dirent *readdir(DIR *dirp)
 void rewinddir(DIR *dirp)
 {
 	dirp->pos = 0;
+	dirp->buf_len = 0;
+	dirp->buf_off = 0;
 }
 
 /** Close directory.
@@ -38,8 +38,8 @@
 #include <assert.h>
 
 /*
- * Floating point numbers are converted from their binary representation
- * into a decimal string using the algorithm described in:
+ * Fixed precision conversions of floating point numbers from their binary
+ * representation into a decimal string use the algorithm described in:
  *   Printing floating-point numbers quickly and accurately with integers
  *   Loitsch, 2010
  */
@@ -127,333 +127,220 @@ static fp_num_t multiply(fp_num_t x, fp_num_t y)
 	return ret;
 }
 
-/** Returns a - b. Both must have the same exponent. */
-static fp_num_t subtract(fp_num_t a, fp_num_t b)
-{
-	assert(a.exponent == b.exponent);
-	assert(a.significand >= b.significand);
-
-	fp_num_t result;
-
-	result.significand = a.significand - b.significand;
-	result.exponent = a.exponent;
+/*
+ * The shortest representation is computed using the algorithm described in:
+ *   Ryu: fast float-to-string conversion
+ *   Adams, 2018
+ */
 
-	return result;
+/** floor(log2(5^e)) + 1, ie the bit length of 5^e, for 0 <= e <= 3528. */
+static int pow5_bits(int e)
+{
+	return ((e * 1217359) >> 19) + 1;
 }
 
-/** Returns the interval [low, high] of numbers that convert to binary val. */
-static void get_normalized_bounds(ieee_double_t val, fp_num_t *high,
-    fp_num_t *low, fp_num_t *val_dist)
+/** floor(log10(2^e)) for 0 <= e <= 1650. */
+static int log10_pow2(int e)
 {
-	/*
-	 * Only works if val comes directly from extract_ieee_double without
-	 * being manipulated in any way (eg it must not be normalized).
-	 */
-	assert(!is_normalized(val.pos_val));
+	return (e * 78913) >> 18;
+}
 
-	high->significand = (val.pos_val.significand << 1) + 1;
-	high->exponent = val.pos_val.exponent - 1;
+/** floor(log10(5^e)) for 0 <= e <= 2620. */
+static int log10_pow5(int e)
+{
+	return (e * 732923) >> 20;
+}
 
-	/* val_dist = high - val */
-	val_dist->significand = 1;
-	val_dist->exponent = val.pos_val.exponent - 1;
+/** Returns true if 5^p divides value. */
+static bool is_multiple_of_pow5(uint64_t value, int p)
+{
+	int count = 0;
 
-	/* Distance from both lower and upper bound is the same. */
-	if (!val.is_accuracy_step) {
-		low->significand = (val.pos_val.significand << 1) - 1;
-		low->exponent = val.pos_val.exponent - 1;
-	} else {
-		low->significand = (val.pos_val.significand << 2) - 1;
-		low->exponent = val.pos_val.exponent - 2;
+	while (value % 5 == 0) {
+		value /= 5;
+		++count;
 	}
 
-	*high = normalize(*high);
-
-	/*
-	 * Lower bound may not be normalized if subtracting 1 unit
-	 * reset the most-significant bit to 0.
-	 */
-	low->significand = low->significand << (low->exponent - high->exponent);
-	low->exponent = high->exponent;
-
-	val_dist->significand =
-	    val_dist->significand << (val_dist->exponent - high->exponent);
-	val_dist->exponent = high->exponent;
+	return count >= p;
 }
 
-/** Determines the interval of numbers that have the binary representation
- *  of val.
- *
- * Numbers in the range [scaled_upper_bound - bounds_delta, scaled_upper_bound]
- * have the same double binary representation as val.
- *
- * Bounds are scaled by 10^scale so that alpha <= exponent <= gamma.
- * Moreover, scaled_upper_bound is normalized.
- *
- * val_dist is the scaled distance from val to the upper bound, ie
- * val_dist == (upper_bound - val) * 10^scale
- */
-static void calc_scaled_bounds(ieee_double_t val, fp_num_t *scaled_upper_bound,
-    fp_num_t *bounds_delta, fp_num_t *val_dist, int *scale)
+/** Returns true if 2^p divides value. */
+static bool is_multiple_of_pow2(uint64_t value, int p)
 {
-	fp_num_t upper_bound, lower_bound;
-
-	get_normalized_bounds(val, &upper_bound, &lower_bound, val_dist);
-
-	assert(upper_bound.exponent == lower_bound.exponent);
-	assert(is_normalized(upper_bound));
-	assert(normalize(val.pos_val).exponent == upper_bound.exponent);
-
-	/*
-	 * Find such a cached normalized power of 10 that if multiplied
-	 * by upper_bound the binary exponent of upper_bound almost vanishes,
-	 * ie:
-	 *   upper_scaled := upper_bound * 10^scale
-	 *   alpha <= upper_scaled.exponent <= gamma
-	 *   alpha <= upper_bound.exponent + pow_10.exponent + 64 <= gamma
-	 */
-	fp_num_t scaling_power_of_10;
-	int lower_bin_exp = alpha - upper_bound.exponent - significand_width;
-
-	get_power_of_ten(lower_bin_exp, &scaling_power_of_10, scale);
-
-	int scale_exp = scaling_power_of_10.exponent;
-	assert(alpha <= upper_bound.exponent + scale_exp + significand_width);
-	assert(upper_bound.exponent + scale_exp + significand_width <= gamma);
-
-	fp_num_t upper_scaled = multiply(upper_bound, scaling_power_of_10);
-	fp_num_t lower_scaled = multiply(lower_bound, scaling_power_of_10);
-	*val_dist = multiply(*val_dist, scaling_power_of_10);
-
-	assert(alpha <= upper_scaled.exponent && upper_scaled.exponent <= gamma);
-
-	/*
-	 * Any value between lower and upper bound would be represented
-	 * in binary as the double val originated from. The bounds were
-	 * however scaled by an imprecise power of 10 (error less than
-	 * 1 ulp) so the scaled bounds have an error of less than 1 ulp.
-	 * Conservatively round the lower bound up and the upper bound
-	 * down by 1 ulp just to be on the safe side. It avoids pronouncing
-	 * produced decimal digits as correct if such a decimal number
-	 * is close to the bounds to within 1 ulp.
-	 */
-	upper_scaled.significand -= 1;
-	lower_scaled.significand += 1;
-
-	*bounds_delta = subtract(upper_scaled, lower_scaled);
-	*scaled_upper_bound = upper_scaled;
+	return (value & ((1ULL << p) - 1)) == 0;
 }
 
-/** Rounds the last digit of buf so that it is closest to the converted number. */
-static void round_last_digit(uint64_t rest, uint64_t w_dist, uint64_t delta,
-    uint64_t digit_val_diff, char *buf, int len)
+/** Returns (m * mul) >> j where mul is a 128-bit number and 64 < j < 128. */
+static uint64_t mul_shift(uint64_t m, const uint64_t *mul, int j)
 {
-	/*
-	 *  | <------- delta -------> |
-	 *  |    | <---- w_dist ----> |
-	 *  |    |       | <- rest -> |
-	 *  |    |       |            |
-	 *  |    |       ` buffer     |
-	 *  |    ` w                  ` upper
-	 *  ` lower
-	 *
-	 * delta = upper - lower .. conservative/safe interval
-	 * w_dist = upper - w
-	 * upper = "number represented by digits in buf" + rest
-	 *
-	 * Changing buf[len - 1] changes the value represented by buf
-	 * by digit_val_diff * scaling, where scaling is shared by
-	 * all parameters.
-	 *
-	 */
-
-	/* Current number in buf is greater than the double being converted */
-	bool cur_greater_w = rest < w_dist;
-	/* Rounding down by one would keep buf in between bounds (in safe rng). */
-	bool next_in_val_rng = cur_greater_w && (rest + digit_val_diff < delta);
-	/* Rounding down by one would bring buf closer to the processed number. */
-	bool next_closer = next_in_val_rng &&
-	    (rest + digit_val_diff < w_dist || rest - w_dist < w_dist - rest);
+	uint64_t high0;
+	uint64_t high1;
 
-	/*
-	 * Of the shortest strings pick the one that is closest to the actual
-	 * floating point number.
-	 */
-	while (next_closer) {
-		assert('0' < buf[len - 1]);
-		assert(0 < digit_val_diff);
+	(void) fp_umul128(m, mul[0], &high0);
+	uint64_t low1 = fp_umul128(m, mul[1], &high1);
 
-		--buf[len - 1];
-		rest += digit_val_diff;
+	uint64_t sum = high0 + low1;
+	if (sum < high0)
+		++high1;
 
-		cur_greater_w = rest < w_dist;
-		next_in_val_rng = cur_greater_w && (rest + digit_val_diff < delta);
-		next_closer = next_in_val_rng &&
-		    (rest + digit_val_diff < w_dist || rest - w_dist < w_dist - rest);
-	}
+	int dist = j - 64;
+	assert(0 < dist && dist < 64);
+	return (high1 << (64 - dist)) | (sum >> dist);
 }
 
-/** Generates the shortest accurate decimal string representation.
- *
- * Outputs (mostly) the shortest accurate string representation
- * for the number scaled_upper - val_dist. Numbers in the interval
- * [scaled_upper - delta, scaled_upper] have the same binary
- * floating point representation and will therefore share the
- * shortest string representation (up to the rounding of the last
- * digit to bring the shortest string also the closest to the
- * actual number).
+/** Computes the shortest decimal digits of a finite non-zero double.
  *
- * @param scaled_upper Scaled upper bound of numbers that have the
- *              same binary representation as the converted number.
- *              Scaled by 10^-scale so that alpha <= exponent <= gamma.
- * @param delta scaled_upper - delta is the lower bound of numbers
- *              that share the same binary representation in double.
- * @param val_dist scaled_upper - val_dist is the number whose
- *              decimal string we're generating.
- * @param scale Decimal scaling of the value to convert (ie scaled_upper).
- * @param buf   Buffer to store the string representation. Must be large
- *              enough to store all digits and a null terminator. At most
- *              MAX_DOUBLE_STR_LEN digits will be written (not counting
- *              the null terminator).
- * @param buf_size Size of buf in bytes.
- * @param dec_exponent Will be set to the decimal exponent of the number
- *              string in buf.
- *
- * @return Number of digits; negative on failure (eg buffer too small).
+ * @param ieee_val  Value to convert.
+ * @param dec_exponent Will be set to the decimal exponent of the result.
+ * @return The digits as an integer; value == digits * 10^dec_exponent.
  */
-static int gen_dec_digits(fp_num_t scaled_upper, fp_num_t delta,
-    fp_num_t val_dist, int scale, char *buf, size_t buf_size, int *dec_exponent)
+static uint64_t ryu_shortest(ieee_double_t ieee_val, int *dec_exponent)
 {
-	/*
-	 * The integral part of scaled_upper is 5 to 32 bits long while
-	 * the remaining fractional part is 59 to 32 bits long because:
-	 * -59 == alpha <= scaled_upper.e <= gamma == -32
-	 *
-	 *  | <------- delta -------> |
-	 *  |    | <--- val_dist ---> |
-	 *  |    |    |<- remainder ->|
-	 *  |    |    |               |
-	 *  |    |    ` buffer        |
-	 *  |    ` val                ` upper
-	 *  ` lower
-	 *
-	 */
-	assert(scaled_upper.significand != 0);
-	assert(alpha <= scaled_upper.exponent && scaled_upper.exponent <= gamma);
-	assert(scaled_upper.exponent == delta.exponent);
-	assert(scaled_upper.exponent == val_dist.exponent);
-	assert(val_dist.significand <= delta.significand);
+	/* Work with 4 * significand so that the bounds are integers. */
+	const uint64_t m2 = ieee_val.pos_val.significand;
+	const int e2 = ieee_val.pos_val.exponent - 2;
+	const bool accept_bounds = (m2 & 1) == 0;
+	const uint64_t mm_shift = ieee_val.is_accuracy_step ? 0 : 1;
 
-	/* We'll produce at least one digit and a null terminator. */
-	if (buf_size < 2) {
-		return -1;
-	}
+	const uint64_t mv = 4 * m2;
+	const uint64_t mp = 4 * m2 + 2;
+	const uint64_t mm = 4 * m2 - 1 - mm_shift;
 
-	/* one is number 1 encoded with the same exponent as scaled_upper */
-	fp_num_t one;
-	one.significand = ((uint64_t) 1) << (-scaled_upper.exponent);
-	one.exponent = scaled_upper.exponent;
+	uint64_t vr, vp, vm;
+	int e10;
+	bool vm_zeros = false;
+	bool vr_zeros = false;
 
 	/*
-	 * Extract the integral part of scaled_upper.
-	 *  upper / one == upper >> -one.e
+	 * Compute vr, vp and vm, ie the value and its bounds multiplied by
+	 * a suitable power of ten, so that they fit in 64 bits.
 	 */
-	uint32_t int_part = (uint32_t)(scaled_upper.significand >> (-one.exponent));
-
-	/*
-	 * Fractional part of scaled_upper.
-	 *  upper % one == upper & (one.f - 1)
-	 */
-	uint64_t frac_part = scaled_upper.significand & (one.significand - 1);
+	if (e2 >= 0) {
+		int q = log10_pow2(e2) - (e2 > 3 ? 1 : 0);
+		int k = FP_POW5_BITS + pow5_bits(q) - 1;
+		int i = -e2 + q + k;
+
+		assert(q < FP_POW5_INV_COUNT);
+		e10 = q;
+		vr = mul_shift(mv, fp_pow5_inv_split[q], i);
+		vp = mul_shift(mp, fp_pow5_inv_split[q], i);
+		vm = mul_shift(mm, fp_pow5_inv_split[q], i);
+
+		if (q <= 21) {
+			/* Only one of mp, mv and mm can be a multiple of 5. */
+			if (mv % 5 == 0)
+				vr_zeros = is_multiple_of_pow5(mv, q);
+			else if (accept_bounds)
+				vm_zeros = is_multiple_of_pow5(mm, q);
+			else if (is_multiple_of_pow5(mp, q))
+				--vp;
+		}
+	} else {
+		int q = log10_pow5(-e2) - (-e2 > 1 ? 1 : 0);
+		int i = -e2 - q;
+		int k = pow5_bits(i) - FP_POW5_BITS;
+		int j = q - k;
+
+		assert(i < FP_POW5_COUNT);
+		e10 = q + e2;
+		vr = mul_shift(mv, fp_pow5_split[i], j);
+		vp = mul_shift(mp, fp_pow5_split[i], j);
+		vm = mul_shift(mm, fp_pow5_split[i], j);
+
+		if (q <= 1) {
+			/* mv has at least q trailing zero bits. */
+			vr_zeros = true;
+			if (accept_bounds)
+				vm_zeros = (mm_shift == 1);
+			else
+				--vp;
+		} else if (q < 63) {
+			vr_zeros = is_multiple_of_pow2(mv, q);
+		}
+	}
 
-	/*
-	 * The integral part of upper has at least 5 bits (64 + alpha) and
-	 * at most 32 bits (64 + gamma). The integral part has at most 10
-	 * decimal digits, so kappa <= 10.
-	 */
-	int kappa = 10;
-	uint32_t div = 1000000000;
-	size_t len = 0;
+	/* Remove digits as long as the bounds stay distinguishable. */
+	int removed = 0;
+	int last_digit = 0;
+	uint64_t output;
+
+	if (vm_zeros || vr_zeros) {
+		/* Rare general case. */
+		while (vp / 10 > vm / 10) {
+			vm_zeros &= (vm % 10 == 0);
+			vr_zeros &= (last_digit == 0);
+			last_digit = vr % 10;
+			vr /= 10;
+			vp /= 10;
+			vm /= 10;
+			++removed;
+		}
 
-	/* Produce decimal digits for the integral part of upper. */
-	while (kappa > 0) {
-		int digit = int_part / div;
-		int_part %= div;
+		if (vm_zeros) {
+			while (vm % 10 == 0) {
+				vr_zeros &= (last_digit == 0);
+				last_digit = vr % 10;
+				vr /= 10;
+				vp /= 10;
+				vm /= 10;
+				++removed;
+			}
+		}
 
-		--kappa;
+		/* Exactly halfway between two candidates; round to even. */
+		if (vr_zeros && last_digit == 5 && vr % 2 == 0)
+			last_digit = 4;
 
-		/* Skip leading zeros. */
-		if (digit != 0 || len != 0) {
-			/* Current length + new digit + null terminator <= buf_size */
-			if (len + 2 <= buf_size) {
-				buf[len] = '0' + digit;
-				++len;
-			} else {
-				return -1;
-			}
+		output = vr + (((vr == vm && (!accept_bounds ||
+		    !vm_zeros)) || last_digit >= 5) ? 1 : 0);
+	} else {
+		/* Common case; remove two digits at a time when possible. */
+		bool round_up = false;
+
+		if (vp / 100 > vm / 100) {
+			round_up = (vr % 100) >= 50;
+			vr /= 100;
+			vp /= 100;
+			vm /= 100;
+			removed += 2;
 		}
 
-		/*
-		 * Difference between the so far produced decimal number and upper
-		 * is calculated as: remaining_int_part * one + frac_part
-		 */
-		uint64_t remainder = (((uint64_t)int_part) << -one.exponent) + frac_part;
-
-		/* The produced decimal number would convert back to upper. */
-		if (remainder <= delta.significand) {
-			assert(0 < len && len < buf_size);
-			*dec_exponent = kappa - scale;
-			buf[len] = '\0';
-
-			/* Of the shortest representations choose the numerically closest. */
-			round_last_digit(remainder, val_dist.significand, delta.significand,
-			    (uint64_t)div << (-one.exponent), buf, len);
-			return len;
+		while (vp / 10 > vm / 10) {
+			round_up = (vr % 10) >= 5;
+			vr /= 10;
+			vp /= 10;
+			vm /= 10;
+			++removed;
 		}
 
-		div /= 10;
+		output = vr + ((vr == vm || round_up) ? 1 : 0);
 	}
 
-	/* Generate decimal digits for the fractional part of upper. */
-	do {
-		/*
-		 * Does not overflow because at least 5 upper bits were
-		 * taken by the integral part and are now unused in frac_part.
-		 */
-		frac_part *= 10;
-		delta.significand *= 10;
-		val_dist.significand *= 10;
-
-		/* frac_part / one */
-		int digit = (int)(frac_part >> (-one.exponent));
-
-		/* frac_part %= one */
-		frac_part &= one.significand - 1;
-
-		--kappa;
+	*dec_exponent = e10 + removed;
+	return output;
+}
 
-		/* Skip leading zeros. */
-		if (digit == 0 && len == 0) {
-			continue;
-		}
+/** Writes the decimal digits of a non-zero number to buf.
+ *
+ * @return The number of written digits; negative if buf is too small.
+ */
+static int digits_to_str(uint64_t digits, char *buf, size_t buf_size)
+{
+	int len = 0;
 
-		/* Current length + new digit + null terminator <= buf_size */
-		if (len + 2 <= buf_size) {
-			buf[len] = '0' + digit;
-			++len;
-		} else {
-			return -1;
-		}
-	} while (frac_part > delta.significand);
+	for (uint64_t d = digits; d != 0; d /= 10)
+		++len;
 
-	assert(0 < len && len < buf_size);
+	/* Digits + null terminator. */
+	if ((size_t) len + 1 > buf_size)
+		return -1;
 
-	*dec_exponent = kappa - scale;
 	buf[len] = '\0';
 
-	/* Of the shortest representations choose the numerically closest one. */
-	round_last_digit(frac_part, val_dist.significand, delta.significand,
-	    one.significand, buf, len);
+	for (int i = len - 1; i >= 0; --i) {
+		buf[i] = '0' + (digits % 10);
+		digits /= 10;
+	}
 
 	return len;
 }
@@ -475,11 +362,10 @@ static int zero_to_str(char *buf, size_t buf_size, int *dec_exponent)
  *  representation.
  *
  * Produces an accurate string representation, ie the string will
- * convert back to the same binary double (eg via strtod). In the
- * vast majority of cases (99%) the string will be the shortest such
- * string that is also the closest to the value of any shortest
- * string representations. Therefore, no trailing zeros are ever
- * produced.
+ * convert back to the same binary double (eg via strtod). The string
+ * is always the shortest such string and, of all the shortest string
+ * representations, the one closest to the value. Therefore, no trailing
+ * zeros are ever produced.
  *
  * Conceptually, the value is: buf * 10^dec_exponent
  *
@@ -513,16 +399,9 @@ int double_to_short_str(ieee_double_t ieee_val, char *buf, size_t buf_size,
 		return zero_to_str(buf, buf_size, dec_exponent);
 	}
 
-	fp_num_t scaled_upper_bound;
-	fp_num_t delta;
-	fp_num_t val_dist;
-	int scale;
+	uint64_t digits = ryu_shortest(ieee_val, dec_exponent);
 
-	calc_scaled_bounds(ieee_val, &scaled_upper_bound,
-	    &delta, &val_dist, &scale);
-
-	int len = gen_dec_digits(scaled_upper_bound, delta, val_dist, scale,
-	    buf, buf_size, dec_exponent);
+	int len = digits_to_str(digits, buf, buf_size);
 
 	assert(len <= MAX_DOUBLE_STR_LEN);
 	return len;
@@ -783,3 +662,75 @@ int double_to_fixed_str(ieee_double_t ieee_val, int signif_d_cnt,
 	assert(len <= MAX_DOUBLE_STR_LEN);
 	return len;
 }
+
+/** Converts a non-special double into a rounded string of a given precision.
+ *
+ * Conceptually, the rounded double value is: buf * 10^dec_exponent
+ *
+ * Unlike double_to_fixed_str, the produced digits are correctly rounded
+ * to the requested precision and exactly the requested number of digits
+ * is output. The digits are derived from the shortest representation
+ * (see double_to_short_str), which is only possible if:
+ *   - the value is a normal number,
+ *   - the requested number of digits is at least the number of digits
+ *     of the shortest representation, and
+ *   - at most 15 significant digits are requested, since the shortest
+ *     representation then rounds to the same digits as the exact value.
+ *
+ * Significant and fractional digits are counted the same way as
+ * in double_to_fixed_str.
+ *
+ * @param ieee_val Binary double description to convert. Must be the product
+ *                 of extract_ieee_double.
+ * @param signif_d_cnt Number of significant digits to produce. Negative
+ *                 if not limited.
+ * @param frac_d_cnt Number of fractional digits to produce. Negative
+ *                 if not limited.
+ * @param buf      Buffer to store the string representation.
+ * @param buf_size Size of buf in bytes.
+ * @param dec_exponent Set to the decimal exponent of the number string
+ *                 in buf.
+ *
+ * @return The number of output digits. A negative value indicates that
+ *         the digits cannot be produced this way and double_to_fixed_str
+ *         has to be used instead.
+ */
+int double_to_rounded_str(ieee_double_t ieee_val, int signif_d_cnt,
+    int frac_d_cnt, char *buf, size_t buf_size, int *dec_exponent)
+{
+	/* The shortest digits and the exact value agree up to 15 digits. */
+	const int max_d_cnt = 15;
+
+	if (ieee_val.is_special || ieee_val.is_denormal) {
+		return -1;
+	}
+
+	int dec_exp;
+	uint64_t digits = ryu_shortest(ieee_val, &dec_exp);
+
+	int len = digits_to_str(digits, buf, buf_size);
+	if (len < 0) {
+		return -1;
+	}
+
+	int d_cnt = (signif_d_cnt >= 0) ? signif_d_cnt : INT_MAX;
+
+	/* The most significant digit is at position len + dec_exp - 1. */
+	if (frac_d_cnt >= 0 && len + dec_exp + frac_d_cnt < d_cnt) {
+		d_cnt = len + dec_exp + frac_d_cnt;
+	}
+
+	if (d_cnt < len || max_d_cnt < d_cnt || buf_size <= (size_t) d_cnt) {
+		return -1;
+	}
+
+	while (len < d_cnt) {
+		buf[len] = '0';
+		++len;
+		--dec_exp;
+	}
+
+	buf[len] = '\0';
+	*dec_exponent = dec_exp;
+	return len;
+}
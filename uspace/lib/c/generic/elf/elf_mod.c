@@ -58,11 +58,17 @@
 #include <str_error.h>
 #include <stdlib.h>
 #include <macros.h>
+#include <mem.h>
 
 #include <elf/elf_load.h>
 
 #define DPRINTF(...)
 
+/** Maximum number of program headers */
+#define PHDR_CAP  16
+
+static errno_t elf_load_open_file(int file, eld_flags_t flags,
+    elf_finfo_t *info);
 static errno_t elf_load_module(elf_ld_t *elf);
 static errno_t segment_header(elf_ld_t *elf, elf_segment_header_t *entry);
 static errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry);
@@ -84,8 +90,6 @@ static errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry);
  */
 errno_t elf_load_file(int file, eld_flags_t flags, elf_finfo_t *info)
 {
-	elf_ld_t elf;
-
 	int ofile;
 	errno_t rc = vfs_clone(file, -1, true, &ofile);
 	if (rc == EOK) {
@@ -95,27 +99,58 @@ errno_t elf_load_file(int file, eld_flags_t flags, elf_finfo_t *info)
 		return rc;
 	}
 
-	elf.fd = ofile;
-	elf.info = info;
-	elf.flags = flags;
-
-	rc = elf_load_module(&elf);
+	rc = elf_load_open_file(ofile, flags, info);
 
 	vfs_put(ofile);
 	return rc;
 }
 
+/** Load ELF binary from a file given by its path.
+ *
+ * The file is looked up and opened in one go, avoiding the extra
+ * round trips to VFS that cloning a looked up handle would cost.
+ *
+ * @param path  Path to the ELF file.
+ * @param flags Loader flags.
+ * @param info  Pointer to a structure for storing information
+ *              extracted from the binary.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
 errno_t elf_load_file_name(const char *path, eld_flags_t flags, elf_finfo_t *info)
 {
 	int file;
-	errno_t rc = vfs_lookup(path, 0, &file);
-	if (rc == EOK) {
-		rc = elf_load_file(file, flags, info);
-		vfs_put(file);
-		return rc;
-	} else {
+	errno_t rc = vfs_lookup_open(path, 0, MODE_READ, &file);
+	if (rc != EOK)
 		return EIO;
-	}
+
+	rc = elf_load_open_file(file, flags, info);
+
+	vfs_put(file);
+	return rc;
+}
+
+/** Load ELF binary from a file already opened for reading.
+ *
+ * @param file  ELF file opened in MODE_READ.
+ * @param flags Loader flags.
+ * @param info  Pointer to a structure for storing information
+ *              extracted from the binary.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+static errno_t elf_load_open_file(int file, eld_flags_t flags,
+    elf_finfo_t *info)
+{
+	elf_ld_t elf;
+
+	elf.fd = file;
+	elf.info = info;
+	elf.flags = flags;
+
+	return elf_load_module(&elf);
 }
 
 /** Load an ELF binary.
@@ -129,15 +164,25 @@ errno_t elf_load_file_name(const char *path, eld_flags_t flags, elf_finfo_t *inf
  */
 static errno_t elf_load_module(elf_ld_t *elf)
 {
-	elf_header_t header_buf;
-	elf_header_t *header = &header_buf;
+	/*
+	 * Normally, there are very few program headers and they directly
+	 * follow the ELF header, so don't bother with allocating memory
+	 * dynamically and try to get both with a single read.
+	 */
+	struct {
+		elf_header_t header;
+		elf_segment_header_t phdr[PHDR_CAP];
+	} head;
+	elf_header_t *header = &head.header;
+	elf_segment_header_t phdr[PHDR_CAP];
 	aoff64_t pos = 0;
+	size_t nhead;
 	size_t nr;
 	int i;
 	errno_t rc;
 
-	rc = vfs_read(elf->fd, &pos, header, sizeof(elf_header_t), &nr);
-	if (rc != EOK || nr != sizeof(elf_header_t)) {
+	rc = vfs_read(elf->fd, &pos, &head, sizeof(head), &nhead);
+	if (rc != EOK || nhead < sizeof(elf_header_t)) {
 		DPRINTF("Read error.\n");
 		return EIO;
 	}
@@ -178,28 +223,27 @@ static errno_t elf_load_module(elf_ld_t *elf)
 		return ENOTSUP;
 	}
 
-	/*
-	 * Read program header table.
-	 * Normally, there are very few program headers, so don't bother
-	 * with allocating memory dynamically.
-	 */
-	const int phdr_cap = 16;
-	elf_segment_header_t phdr[phdr_cap];
+	/* Read program header table. */
 	size_t phdr_len = header->e_phnum * header->e_phentsize;
 
 	elf->info->interp = NULL;
 	elf->info->dynamic = NULL;
 
 	if (phdr_len > sizeof(phdr)) {
-		DPRINTF("more than %d program headers\n", phdr_cap);
+		DPRINTF("more than %d program headers\n", PHDR_CAP);
 		return ENOTSUP;
 	}
 
-	pos = header->e_phoff;
-	rc = vfs_read(elf->fd, &pos, phdr, phdr_len, &nr);
-	if (rc != EOK || nr != phdr_len) {
-		DPRINTF("Read error.\n");
-		return EIO;
+	if (header->e_phoff <= nhead && phdr_len <= nhead - header->e_phoff) {
+		/* Already got it with the ELF header. */
+		memcpy(phdr, (uint8_t *) &head + header->e_phoff, phdr_len);
+	} else {
+		pos = header->e_phoff;
+		rc = vfs_read(elf->fd, &pos, phdr, phdr_len, &nr);
+		if (rc != EOK || nr != phdr_len) {
+			DPRINTF("Read error.\n");
+			return EIO;
+		}
 	}
 
 	uintptr_t module_base = UINTPTR_MAX;
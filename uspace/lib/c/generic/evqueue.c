@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Readiness event queue
+ *
+ * An event queue collects readiness events from many sources so that one
+ * fibril can wait for any of them. Notification is edge-triggered: a source
+ * reports an event when it changes state, e.g. when data arrives at an
+ * empty receive buffer. After getting an event, the user should consume
+ * everything the source has (until it returns EAGAIN), because no new event
+ * is reported for data that was already there.
+ */
+
+#include <adt/list.h>
+#include <assert.h>
+#include <errno.h>
+#include <evqueue.h>
+#include <fibril_synch.h>
+#include <stdlib.h>
+#include <time.h>
+
+/** Protects all event queues and sources */
+static FIBRIL_MUTEX_INITIALIZE(evqueue_lock);
+
+/** Queue a source with interesting pending events.
+ *
+ * @param src Event source, registered with an event queue
+ */
+static void evqueue_src_queue(evqueue_src_t *src)
+{
+	assert(fibril_mutex_is_locked(&evqueue_lock));
+	assert(src->evq != NULL);
+
+	if ((src->pending & src->mask) == 0 || link_used(&src->lready))
+		return;
+
+	list_append(&src->lready, &src->evq->ready);
+	fibril_condvar_broadcast(&src->evq->cv);
+}
+
+/** Create event queue.
+ *
+ * @param revq Place to store pointer to new event queue
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t evqueue_create(evqueue_t **revq)
+{
+	evqueue_t *evq;
+
+	evq = calloc(1, sizeof(evqueue_t));
+	if (evq == NULL)
+		return ENOMEM;
+
+	list_initialize(&evq->ready);
+	fibril_condvar_initialize(&evq->cv);
+	*revq = evq;
+	return EOK;
+}
+
+/** Destroy event queue.
+ *
+ * All sources must have been removed from the event queue.
+ *
+ * @param evq Event queue or @c NULL
+ */
+void evqueue_destroy(evqueue_t *evq)
+{
+	if (evq == NULL)
+		return;
+
+	assert(evq->nsrcs == 0);
+	free(evq);
+}
+
+/** Register event source with an event queue.
+ *
+ * Events that occurred on the source before it was registered are
+ * reported right away.
+ *
+ * @param evq  Event queue
+ * @param src  Event source
+ * @param mask Events to report (EVQUEUE_xxx). EVQUEUE_HUP is always
+ *             reported.
+ * @param arg  User argument to return with the events
+ *
+ * @return EOK on success, EBUSY if the source is registered already
+ */
+errno_t evqueue_add(evqueue_t *evq, evqueue_src_t *src, unsigned int mask,
+    void *arg)
+{
+	fibril_mutex_lock(&evqueue_lock);
+
+	if (src->evq != NULL) {
+		fibril_mutex_unlock(&evqueue_lock);
+		return EBUSY;
+	}
+
+	src->evq = evq;
+	src->mask = mask | EVQUEUE_HUP;
+	src->arg = arg;
+	++evq->nsrcs;
+
+	evqueue_src_queue(src);
+	fibril_mutex_unlock(&evqueue_lock);
+	return EOK;
+}
+
+/** Change the events reported for a source.
+ *
+ * @param src  Registered event source
+ * @param mask Events to report (EVQUEUE_xxx)
+ */
+void evqueue_modify(evqueue_src_t *src, unsigned int mask)
+{
+	fibril_mutex_lock(&evqueue_lock);
+	assert(src->evq != NULL);
+
+	src->mask = mask | EVQUEUE_HUP;
+	if ((src->pending & src->mask) == 0 && link_used(&src->lready))
+		list_remove(&src->lready);
+	else
+		evqueue_src_queue(src);
+
+	fibril_mutex_unlock(&evqueue_lock);
+}
+
+/** Unregister event source from its event queue.
+ *
+ * @param src Event source, does nothing if it is not registered
+ */
+void evqueue_remove(evqueue_src_t *src)
+{
+	fibril_mutex_lock(&evqueue_lock);
+
+	if (src->evq != NULL) {
+		if (link_used(&src->lready))
+			list_remove(&src->lready);
+		--src->evq->nsrcs;
+		src->evq = NULL;
+	}
+
+	fibril_mutex_unlock(&evqueue_lock);
+}
+
+/** Wait for events.
+ *
+ * @param evq     Event queue
+ * @param events  Array to store the events to
+ * @param max     Size of @a events, at least 1
+ * @param timeout Timeout in microseconds, zero not to wait at all or
+ *                negative to wait without a timeout
+ * @param nevents Place to store the number of events stored
+ *
+ * @return EOK on success, ETIMEOUT if no event occurred before timeout
+ */
+errno_t evqueue_wait(evqueue_t *evq, evqueue_event_t *events, size_t max,
+    usec_t timeout, size_t *nevents)
+{
+	struct timespec expires;
+	struct timespec now;
+	evqueue_src_t *src;
+	usec_t remain;
+	size_t n;
+
+	assert(max > 0);
+
+	if (timeout > 0) {
+		getuptime(&expires);
+		ts_add_diff(&expires, USEC2NSEC(timeout));
+	}
+
+	fibril_mutex_lock(&evqueue_lock);
+
+	while (list_empty(&evq->ready)) {
+		if (timeout == 0) {
+			fibril_mutex_unlock(&evqueue_lock);
+			return ETIMEOUT;
+		}
+
+		if (timeout < 0) {
+			fibril_condvar_wait(&evq->cv, &evqueue_lock);
+			continue;
+		}
+
+		getuptime(&now);
+		remain = NSEC2USEC(ts_sub_diff(&expires, &now));
+		if (remain <= 0 || fibril_condvar_wait_timeout(&evq->cv,
+		    &evqueue_lock, remain) == ETIMEOUT) {
+			if (!list_empty(&evq->ready))
+				break;
+			fibril_mutex_unlock(&evqueue_lock);
+			return ETIMEOUT;
+		}
+	}
+
+	n = 0;
+	while (n < max && !list_empty(&evq->ready)) {
+		src = list_get_instance(list_first(&evq->ready), evqueue_src_t,
+		    lready);
+		list_remove(&src->lready);
+
+		events[n].events = src->pending & src->mask;
+		events[n].arg = src->arg;
+		src->pending &= ~src->mask;
+		++n;
+	}
+
+	fibril_mutex_unlock(&evqueue_lock);
+	*nevents = n;
+	return EOK;
+}
+
+/** Initialize event source.
+ *
+ * @param src Event source
+ */
+void evqueue_src_init(evqueue_src_t *src)
+{
+	src->evq = NULL;
+	link_initialize(&src->lready);
+	src->mask = 0;
+	src->pending = 0;
+	src->arg = NULL;
+}
+
+/** Report events on an event source.
+ *
+ * Called by the object the source is embedded in when it becomes ready.
+ * Events reported while the source is not registered or while the events
+ * are not reported for it are kept until they are.
+ *
+ * @param src    Event source
+ * @param events Events that occurred (EVQUEUE_xxx)
+ */
+void evqueue_src_notify(evqueue_src_t *src, unsigned int events)
+{
+	fibril_mutex_lock(&evqueue_lock);
+
+	src->pending |= events;
+	if (src->evq != NULL)
+		evqueue_src_queue(src);
+
+	fibril_mutex_unlock(&evqueue_lock);
+}
+
+/** @}
+ */
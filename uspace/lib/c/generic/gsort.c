@@ -34,7 +34,9 @@
  * @file
  * @brief Gnome Sort.
  *
- * This file contains an implementation of gnome sort
+ * This file contains an implementation of a stable sort. Short runs are
+ * sorted by gnome sort, which are then merged. Gnome sort alone is used
+ * if there is no memory for merging.
  *
  */
 
@@ -56,6 +58,11 @@
  */
 #define INDEX(buf, i, elem_size)  ((buf) + (i) * (elem_size))
 
+/** Runs up to this length are sorted by gnome sort.
+ *
+ */
+#define RUN_MAX  8
+
 /** Gnome sort
  *
  * Apply generic gnome sort algorithm on supplied data,
@@ -89,11 +96,71 @@ static void _gsort(void *data, size_t cnt, size_t elem_size, sort_cmp_t cmp,
 	}
 }
 
-/** Gnome sort wrapper
+/** Merge sort
+ *
+ * Sort both halves of the data and merge them, taking the element from
+ * the first half when equal to keep the sort stable.
+ *
+ * @param data      Pointer to data to be sorted.
+ * @param cnt       Number of elements to be sorted.
+ * @param elem_size Size of one element.
+ * @param cmp       Comparator function.
+ * @param arg       3rd argument passed to cmp.
+ * @param slot      Pointer to scratch memory buffer
+ *                  elem_size bytes long.
+ * @param buf       Pointer to scratch memory buffer
+ *                  cnt / 2 elements long.
+ *
+ */
+static void _msort(void *data, size_t cnt, size_t elem_size, sort_cmp_t cmp,
+    void *arg, void *slot, void *buf)
+{
+	if (cnt <= RUN_MAX) {
+		_gsort(data, cnt, elem_size, cmp, arg, slot);
+		return;
+	}
+
+	size_t mid = cnt / 2;
+	_msort(data, mid, elem_size, cmp, arg, slot, buf);
+	_msort(INDEX(data, mid, elem_size), cnt - mid, elem_size, cmp, arg,
+	    slot, buf);
+
+	/* Already in order? */
+	if (cmp(INDEX(data, mid - 1, elem_size), INDEX(data, mid, elem_size),
+	    arg) <= 0)
+		return;
+
+	/* Move the first half aside and merge it back with the second one. */
+	memcpy(buf, data, mid * elem_size);
+
+	size_t i = 0;
+	size_t j = mid;
+	size_t k = 0;
+
+	while (i < mid && j < cnt) {
+		if (cmp(INDEX(data, j, elem_size), INDEX(buf, i, elem_size),
+		    arg) < 0) {
+			memcpy(INDEX(data, k, elem_size), INDEX(data, j, elem_size),
+			    elem_size);
+			j++;
+		} else {
+			memcpy(INDEX(data, k, elem_size), INDEX(buf, i, elem_size),
+			    elem_size);
+			i++;
+		}
+
+		k++;
+	}
+
+	memcpy(INDEX(data, k, elem_size), INDEX(buf, i, elem_size),
+	    (mid - i) * elem_size);
+}
+
+/** Stable sort wrapper
  *
  * This is only a wrapper that takes care of memory
- * allocations for storing the slot element for generic
- * gnome sort algorithm.
+ * allocations for storing the slot element and the
+ * merge buffer.
  *
  * @param data      Pointer to data to be sorted.
  * @param cnt       Number of elements to be sorted.
@@ -116,7 +183,16 @@ bool gsort(void *data, size_t cnt, size_t elem_size, sort_cmp_t cmp, void *arg)
 	} else
 		slot = (void *) ibuf_slot;
 
-	_gsort(data, cnt, elem_size, cmp, arg, slot);
+	void *buf = NULL;
+	if (cnt > RUN_MAX)
+		buf = malloc((cnt / 2) * elem_size);
+
+	if (buf != NULL) {
+		_msort(data, cnt, elem_size, cmp, arg, slot, buf);
+		free(buf);
+	} else {
+		_gsort(data, cnt, elem_size, cmp, arg, slot);
+	}
 
 	if (elem_size > IBUF_SIZE)
 		free(slot);
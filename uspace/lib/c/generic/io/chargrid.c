@@ -79,14 +79,19 @@ chargrid_t *chargrid_create(sysarg_t cols, sysarg_t rows,
 	scrbuf->attrs.val.style = STYLE_NORMAL;
 
 	scrbuf->top_row = 0;
+	scrbuf->dirty_r0 = 0;
+	scrbuf->dirty_r1 = 0;
 	chargrid_clear(scrbuf);
 
 	return scrbuf;
 }
 
-void chargrid_destroy(chargrid_t *srcbuf)
+void chargrid_destroy(chargrid_t *scrbuf)
 {
-	// TODO
+	if ((scrbuf->flags & CHARGRID_FLAG_SHARED) == CHARGRID_FLAG_SHARED)
+		as_area_destroy(scrbuf);
+	else
+		free(scrbuf);
 }
 
 bool chargrid_cursor_at(chargrid_t *scrbuf, sysarg_t col, sysarg_t row)
@@ -100,12 +105,71 @@ sysarg_t chargrid_get_top_row(chargrid_t *scrbuf)
 	return scrbuf->top_row;
 }
 
+/** Get range of rows containing dirty fields.
+ *
+ * Rows outside of the range contain no fields with CHAR_FLAG_DIRTY
+ * set. This allows the user of the chargrid to skip them when looking
+ * for fields to update. The range is empty if @a r0 >= @a r1.
+ *
+ * @param scrbuf Chargrid.
+ * @param r0     Place to store the first dirty row.
+ * @param r1     Place to store the row after the last dirty row.
+ *
+ */
+void chargrid_get_dirty_rows(chargrid_t *scrbuf, sysarg_t *r0, sysarg_t *r1)
+{
+	*r0 = scrbuf->dirty_r0;
+	*r1 = scrbuf->dirty_r1;
+}
+
+/** Add rows to range of dirty rows.
+ *
+ * This needs to be called when fields are modified directly instead
+ * of using the chargrid functions.
+ *
+ * @param scrbuf Chargrid.
+ * @param r0     First row (inclusive).
+ * @param r1     Last row (exclusive).
+ *
+ */
+void chargrid_set_dirty_rows(chargrid_t *scrbuf, sysarg_t r0, sysarg_t r1)
+{
+	if (r1 > scrbuf->rows)
+		r1 = scrbuf->rows;
+	if (r0 >= r1)
+		return;
+
+	if (scrbuf->dirty_r0 >= scrbuf->dirty_r1) {
+		scrbuf->dirty_r0 = r0;
+		scrbuf->dirty_r1 = r1;
+		return;
+	}
+
+	if (r0 < scrbuf->dirty_r0)
+		scrbuf->dirty_r0 = r0;
+	if (r1 > scrbuf->dirty_r1)
+		scrbuf->dirty_r1 = r1;
+}
+
+/** Reset range of dirty rows.
+ *
+ * To be called after the dirty fields have been processed and their
+ * CHAR_FLAG_DIRTY cleared.
+ *
+ * @param scrbuf Chargrid.
+ *
+ */
+void chargrid_reset_dirty_rows(chargrid_t *scrbuf)
+{
+	scrbuf->dirty_r0 = 0;
+	scrbuf->dirty_r1 = 0;
+}
+
 static sysarg_t chargrid_update_rows(chargrid_t *scrbuf)
 {
 	if (scrbuf->row == scrbuf->rows) {
 		scrbuf->row = scrbuf->rows - 1;
-		scrbuf->top_row = (scrbuf->top_row + 1) % scrbuf->rows;
-		chargrid_clear_row(scrbuf, scrbuf->row);
+		chargrid_scroll_up(scrbuf, 1);
 
 		return scrbuf->rows;
 	}
@@ -150,6 +214,7 @@ sysarg_t chargrid_putuchar(chargrid_t *scrbuf, char32_t ch, bool update)
 	field->ch = ch;
 	field->attrs = scrbuf->attrs;
 	field->flags |= CHAR_FLAG_DIRTY;
+	chargrid_set_dirty_rows(scrbuf, scrbuf->row, scrbuf->row + 1);
 
 	if (update) {
 		scrbuf->col++;
@@ -249,6 +314,9 @@ void chargrid_clear(chargrid_t *scrbuf)
 		scrbuf->data[pos].flags = CHAR_FLAG_DIRTY;
 	}
 
+	scrbuf->dirty_r0 = 0;
+	scrbuf->dirty_r1 = scrbuf->rows;
+
 	scrbuf->col = 0;
 	scrbuf->row = 0;
 }
@@ -312,6 +380,35 @@ void chargrid_clear_row(chargrid_t *scrbuf, sysarg_t row)
 		field->attrs = scrbuf->attrs;
 		field->flags |= CHAR_FLAG_DIRTY;
 	}
+
+	chargrid_set_dirty_rows(scrbuf, row, row + 1);
+}
+
+/** Scroll chargrid contents up.
+ *
+ * The top @a lines rows are discarded, the remaining rows move up
+ * and the rows which appear at the bottom are cleared. Only the cyclic
+ * buffer origin is moved, no fields are copied.
+ *
+ * @param scrbuf Chargrid.
+ * @param lines  Number of rows to scroll by.
+ *
+ */
+void chargrid_scroll_up(chargrid_t *scrbuf, sysarg_t lines)
+{
+	if (lines > scrbuf->rows)
+		lines = scrbuf->rows;
+
+	scrbuf->top_row = (scrbuf->top_row + lines) % scrbuf->rows;
+
+	/* Dirty rows move up along with the contents */
+	scrbuf->dirty_r0 = scrbuf->dirty_r0 > lines ?
+	    scrbuf->dirty_r0 - lines : 0;
+	scrbuf->dirty_r1 = scrbuf->dirty_r1 > lines ?
+	    scrbuf->dirty_r1 - lines : 0;
+
+	for (sysarg_t row = scrbuf->rows - lines; row < scrbuf->rows; row++)
+		chargrid_clear_row(scrbuf, row);
 }
 
 /** Set chargrid style.
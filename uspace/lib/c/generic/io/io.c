@@ -33,6 +33,7 @@
  */
 
 #include <stdio.h>
+#include <as.h>
 #include <assert.h>
 #include <str.h>
 #include <errno.h>
@@ -46,6 +47,8 @@
 #include <vfs/inbox.h>
 #include <ipc/loc.h>
 #include <adt/list.h>
+#include <align.h>
+#include <ns.h>
 #include <wchar.h>
 #include <uchar.h>
 #include "../private/io.h"
@@ -63,6 +66,16 @@ static size_t stdio_vfs_write(const void *, size_t, size_t, FILE *);
 
 static int stdio_vfs_flush(FILE *);
 
+static size_t stdio_map_read(void *, size_t, size_t, FILE *);
+static size_t stdio_map_write(const void *, size_t, size_t, FILE *);
+static int stdio_map_flush(FILE *);
+
+/** Buffer size of streams backed by files.
+ *
+ * Larger than BUFSIZ to cut down on the number of VFS requests.
+ */
+#define FILE_BUF_SIZE  65536
+
 /** KIO stream ops */
 static __stream_ops_t stdio_kio_ops = {
 	.read = stdio_kio_read,
@@ -77,6 +90,13 @@ static __stream_ops_t stdio_vfs_ops = {
 	.flush = stdio_vfs_flush
 };
 
+/** Memory-mapped VFS stream ops */
+static __stream_ops_t stdio_map_ops = {
+	.read = stdio_map_read,
+	.write = stdio_map_write,
+	.flush = stdio_map_flush
+};
+
 static FILE stdin_null = {
 	.fd = -1,
 	.pos = 0,
@@ -187,7 +207,7 @@ void __stdio_done(void)
 }
 
 static bool parse_mode(const char *fmode, int *mode, bool *create, bool *excl,
-    bool *truncate)
+    bool *truncate, bool *map)
 {
 	/* Parse mode except first character. */
 	const char *mp = fmode;
@@ -216,6 +236,13 @@ static bool parse_mode(const char *fmode, int *mode, bool *create, bool *excl,
 		ex = false;
 	}
 
+	if (*mp == 'm') {
+		mp++;
+		*map = true;
+	} else {
+		*map = false;
+	}
+
 	if (*mp != '\0') {
 		errno = EINVAL;
 		return false;
@@ -229,12 +256,17 @@ static bool parse_mode(const char *fmode, int *mode, bool *create, bool *excl,
 	switch (fmode[0]) {
 	case 'r':
 		*mode = plus ? MODE_READ | MODE_WRITE : MODE_READ;
-		if (ex) {
+		if (ex || (plus && *map)) {
 			errno = EINVAL;
 			return false;
 		}
 		break;
 	case 'w':
+		if (*map) {
+			errno = EINVAL;
+			return false;
+		}
+
 		*mode = plus ? MODE_READ | MODE_WRITE : MODE_WRITE;
 		*create = true;
 		*excl = ex;
@@ -248,7 +280,7 @@ static bool parse_mode(const char *fmode, int *mode, bool *create, bool *excl,
 			return false;
 		}
 
-		if (ex) {
+		if (ex || *map) {
 			errno = EINVAL;
 			return false;
 		}
@@ -307,10 +339,54 @@ static void _setvbuf(FILE *stream)
 		setvbuf(stream, NULL, _IONBF, 0);
 		break;
 	default:
-		setvbuf(stream, NULL, _IOFBF, BUFSIZ);
+		setvbuf(stream, NULL, _IOFBF, FILE_BUF_SIZE);
 	}
 }
 
+/** Map the file of a stream opened for reading into memory.
+ *
+ * The mapping is backed by the VFS pager, so the file is read in as it is
+ * being accessed and the reads go directly to the mapped pages.
+ *
+ * @return EOK on success, error code if the stream should stay regular.
+ */
+static errno_t _fmap(FILE *stream)
+{
+	vfs_stat_t st;
+	errno_t rc;
+
+	rc = vfs_stat(stream->fd, &st);
+	if (rc != EOK)
+		return rc;
+
+	/* Empty areas cannot be created. */
+	if (st.size == 0 || st.size > SIZE_MAX - PAGE_SIZE)
+		return ENOTSUP;
+
+	async_sess_t *pager = service_connect_blocking(SERVICE_VFS,
+	    INTERFACE_PAGER, 0, NULL);
+	if (pager == NULL)
+		return ENOENT;
+
+	void *map = async_as_area_create(AS_AREA_ANY,
+	    ALIGN_UP((size_t) st.size, PAGE_SIZE),
+	    AS_AREA_READ | AS_AREA_CACHEABLE, pager, stream->fd, 0, 0);
+	if (map == AS_MAP_FAILED) {
+		async_hangup(pager);
+		return ENOMEM;
+	}
+
+	/* The pager session must stay open for as long as the mapping. */
+	stream->sess = pager;
+	stream->ops = &stdio_map_ops;
+	stream->map = map;
+	stream->map_size = st.size;
+
+	/* Reads are served from the mapping, there is nothing to buffer. */
+	setvbuf(stream, NULL, _IONBF, 0);
+	return EOK;
+}
+
 /** Allocate stream buffer. */
 static int _fallocbuf(FILE *stream)
 {
@@ -330,7 +406,9 @@ static int _fallocbuf(FILE *stream)
 /** Open a stream.
  *
  * @param path Path of the file to open.
- * @param mode Mode string, (r|w|a)[b|t][+][x].
+ * @param mode Mode string, (r|w|a)[b|t][+][x][m]. 'm' requests the file
+ *             to be read through a memory mapping and is only allowed for
+ *             'r'. If the file cannot be mapped, it is read as usual.
  *
  */
 FILE *fopen(const char *path, const char *fmode)
@@ -339,8 +417,9 @@ FILE *fopen(const char *path, const char *fmode)
 	bool create;
 	bool excl;
 	bool truncate;
+	bool map;
 
-	if (!parse_mode(fmode, &mode, &create, &excl, &truncate))
+	if (!parse_mode(fmode, &mode, &create, &excl, &truncate, &map))
 		return NULL;
 
 	/* Open file. */
@@ -389,9 +468,14 @@ FILE *fopen(const char *path, const char *fmode)
 	stream->arg = NULL;
 	stream->sess = NULL;
 	stream->need_sync = false;
+	stream->map = NULL;
+	stream->map_size = 0;
 	_setvbuf(stream);
 	stream->ungetc_chars = 0;
 
+	if (map)
+		(void) _fmap(stream);
+
 	list_append(&stream->link, &files);
 
 	return stream;
@@ -414,6 +498,8 @@ FILE *fdopen(int fd, const char *mode)
 	stream->arg = NULL;
 	stream->sess = NULL;
 	stream->need_sync = false;
+	stream->map = NULL;
+	stream->map_size = 0;
 	_setvbuf(stream);
 	stream->ungetc_chars = 0;
 
@@ -428,6 +514,9 @@ static int _fclose_nofree(FILE *stream)
 
 	fflush(stream);
 
+	if (stream->map != NULL)
+		as_area_destroy(stream->map);
+
 	if (stream->sess != NULL)
 		async_hangup(stream->sess);
 
@@ -609,7 +698,7 @@ size_t fread(void *dest, size_t size, size_t nmemb, FILE *stream)
 
 	/* If not buffered stream, read in directly. */
 	if (stream->btype == _IONBF) {
-		total_read += _fread(dest, 1, bytes_left, stream);
+		total_read += _fread(dp, 1, bytes_left, stream);
 		return total_read / size;
 	}
 
@@ -624,6 +713,16 @@ size_t fread(void *dest, size_t size, size_t nmemb, FILE *stream)
 	}
 
 	while ((!stream->error) && (!stream->eof) && (bytes_left > 0)) {
+		if (stream->buf_head == stream->buf_tail &&
+		    bytes_left >= stream->buf_size) {
+			/*
+			 * The buffer is empty and would not hold the rest.
+			 * Read directly to the destination.
+			 */
+			total_read += _fread(dp, 1, bytes_left, stream);
+			break;
+		}
+
 		if (stream->buf_head == stream->buf_tail)
 			_ffillbuf(stream);
 
@@ -697,6 +796,16 @@ size_t fwrite(const void *buf, size_t size, size_t nmemb, FILE *stream)
 	need_flush = false;
 
 	while ((!stream->error) && (bytes_left > 0)) {
+		if (stream->buf_head == stream->buf &&
+		    bytes_left >= stream->buf_size && stream->btype == _IOFBF) {
+			/*
+			 * The buffer is empty and would only be filled to be
+			 * written out again. Write directly from the source.
+			 */
+			total_written += _fwrite(data, 1, bytes_left, stream);
+			break;
+		}
+
 		buf_free = stream->buf_size - (stream->buf_head - stream->buf);
 		if (bytes_left > buf_free)
 			now = buf_free;
@@ -990,7 +1099,7 @@ void clearerr(FILE *stream)
 
 int fileno(FILE *stream)
 {
-	if (stream->ops != &stdio_vfs_ops) {
+	if (stream->ops != &stdio_vfs_ops && stream->ops != &stdio_map_ops) {
 		errno = EBADF;
 		return EOF;
 	}
@@ -1086,6 +1195,43 @@ static size_t stdio_vfs_write(const void *buf, size_t size, size_t nmemb,
 	return nwritten / size;
 }
 
+/** Read from memory-mapped VFS stream. */
+static size_t stdio_map_read(void *buf, size_t size, size_t nmemb, FILE *stream)
+{
+	size_t nbytes = size * nmemb;
+
+	if (stream->pos >= stream->map_size) {
+		stream->eof = true;
+		return 0;
+	}
+
+	if (nbytes > stream->map_size - stream->pos) {
+		nbytes = stream->map_size - stream->pos;
+		stream->eof = true;
+	}
+
+	memcpy(buf, stream->map + stream->pos, nbytes);
+	stream->pos += nbytes;
+
+	return (nbytes / size);
+}
+
+/** Write to memory-mapped VFS stream. */
+static size_t stdio_map_write(const void *buf, size_t size, size_t nmemb,
+    FILE *stream)
+{
+	/* The stream is only ever open for reading. */
+	errno = EBADF;
+	stream->error = true;
+	return 0;
+}
+
+/** Flush memory-mapped VFS stream. */
+static int stdio_map_flush(FILE *stream)
+{
+	return 0;
+}
+
 /** Flush VFS stream. */
 static int stdio_vfs_flush(FILE *stream)
 {
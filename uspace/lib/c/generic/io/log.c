@@ -66,7 +66,27 @@ static async_sess_t *logger_session;
 /** Maximum length of a single log message (in bytes). */
 #define MESSAGE_BUFFER_SIZE 4096
 
+/** Maximum number of messages sent without waiting for the reply. */
+#define MESSAGE_PENDING_MAX 16
+
+/** Guards the pending message window. */
+static FIBRIL_MUTEX_INITIALIZE(pending_lock);
+
+/** Messages sent to the logger whose reply we have not collected yet. */
+static aid_t pending_msgs[MESSAGE_PENDING_MAX];
+
+/** Index of the oldest pending message. */
+static size_t pending_first;
+
+/** Number of pending messages. */
+static size_t pending_cnt;
+
 /** Send formatted message to the logger service.
+ *
+ * The logger reply is not waited for, up to MESSAGE_PENDING_MAX messages
+ * can be in flight. Only once the window is full we wait for the oldest
+ * reply, which keeps chatty clients from being blocked by the logger
+ * on every single message.
  *
  * @param session Initialized IPC session with the logger.
  * @param log Log to use.
@@ -76,21 +96,31 @@ static async_sess_t *logger_session;
  */
 static errno_t logger_message(async_sess_t *session, log_t log, log_level_t level, char *message)
 {
-	async_exch_t *exchange = async_exchange_begin(session);
-	if (exchange == NULL) {
-		return ENOMEM;
-	}
+	errno_t reg_msg_rc = EOK;
+
 	if (log == LOG_DEFAULT)
 		log = default_log_id;
 
 	// FIXME: remove when all USB drivers use libc logging explicitly
 	str_rtrim(message, '\n');
 
+	fibril_mutex_lock(&pending_lock);
+
+	if (pending_cnt == MESSAGE_PENDING_MAX) {
+		async_wait_for(pending_msgs[pending_first], &reg_msg_rc);
+		pending_first = (pending_first + 1) % MESSAGE_PENDING_MAX;
+		--pending_cnt;
+	}
+
+	async_exch_t *exchange = async_exchange_begin(session);
+	if (exchange == NULL) {
+		fibril_mutex_unlock(&pending_lock);
+		return ENOMEM;
+	}
+
 	aid_t reg_msg = async_send_2(exchange, LOGGER_WRITER_MESSAGE,
 	    log, level, NULL);
 	errno_t rc = async_data_write_start(exchange, message, str_size(message));
-	errno_t reg_msg_rc;
-	async_wait_for(reg_msg, &reg_msg_rc);
 
 	async_exchange_end(exchange);
 
@@ -102,9 +132,16 @@ static errno_t logger_message(async_sess_t *session, log_t log, log_level_t leve
 		rc = EOK;
 
 	if (rc != EOK) {
+		async_forget(reg_msg);
+		fibril_mutex_unlock(&pending_lock);
 		return rc;
 	}
 
+	pending_msgs[(pending_first + pending_cnt) % MESSAGE_PENDING_MAX] =
+	    reg_msg;
+	++pending_cnt;
+
+	fibril_mutex_unlock(&pending_lock);
 	return reg_msg_rc;
 }
 
@@ -854,19 +854,27 @@ static int print_double_fixed(double g, int precision, int width, uint32_t flags
 	val_str.neg = val.is_negative;
 
 	if (0 <= precision) {
-		/*
-		 * Request one more digit so we can round the result. The last
-		 * digit it returns may have an error of at most +/- 1.
-		 */
-		val_str.len = double_to_fixed_str(val, -1, precision + 1, buf, buf_size,
-		    &val_str.dec_exp);
+		/* Most values round directly from their shortest digits. */
+		val_str.len = double_to_rounded_str(val, -1, precision, buf,
+		    buf_size, &val_str.dec_exp);
 
-		/*
-		 * Round using the last digit to produce precision fractional digits.
-		 * If less than precision+1 fractional digits were output the last
-		 * digit is definitely inaccurate so also round to get rid of it.
-		 */
-		fp_round_up(buf, &val_str.len, &val_str.dec_exp);
+		if (val_str.len < 0) {
+			/*
+			 * Request one more digit so we can round the result.
+			 * The last digit it returns may have an error of at
+			 * most +/- 1.
+			 */
+			val_str.len = double_to_fixed_str(val, -1,
+			    precision + 1, buf, buf_size, &val_str.dec_exp);
+
+			/*
+			 * Round using the last digit to produce precision
+			 * fractional digits. If less than precision+1
+			 * fractional digits were output the last digit is
+			 * definitely inaccurate so also round to get rid of it.
+			 */
+			fp_round_up(buf, &val_str.len, &val_str.dec_exp);
+		}
 
 		/* Rounding could have introduced trailing zeros. */
 		if (flags & __PRINTF_FLAG_NOFRACZEROS) {
@@ -1070,20 +1078,27 @@ static int print_double_scientific(double g, int precision, int width,
 	val_str.neg = val.is_negative;
 
 	if (0 <= precision) {
-		/*
-		 * Request one more digit (in addition to the leading integer)
-		 * so we can round the result. The last digit it returns may
-		 * have an error of at most +/- 1.
-		 */
-		val_str.len = double_to_fixed_str(val, precision + 2, -1, buf, buf_size,
-		    &val_str.dec_exp);
+		/* Most values round directly from their shortest digits. */
+		val_str.len = double_to_rounded_str(val, precision + 1, -1, buf,
+		    buf_size, &val_str.dec_exp);
 
-		/*
-		 * Round the extra digit to produce precision+1 significant digits.
-		 * If less than precision+2 significant digits were returned the last
-		 * digit is definitely inaccurate so also round to get rid of it.
-		 */
-		fp_round_up(buf, &val_str.len, &val_str.dec_exp);
+		if (val_str.len < 0) {
+			/*
+			 * Request one more digit (in addition to the leading
+			 * integer) so we can round the result. The last digit
+			 * it returns may have an error of at most +/- 1.
+			 */
+			val_str.len = double_to_fixed_str(val, precision + 2,
+			    -1, buf, buf_size, &val_str.dec_exp);
+
+			/*
+			 * Round the extra digit to produce precision+1
+			 * significant digits. If less than precision+2
+			 * significant digits were returned the last digit is
+			 * definitely inaccurate so also round to get rid of it.
+			 */
+			fp_round_up(buf, &val_str.len, &val_str.dec_exp);
+		}
 
 		/* Rounding could have introduced trailing zeros. */
 		if (flags & __PRINTF_FLAG_NOFRACZEROS) {
@@ -1328,6 +1343,14 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 	int retval;           /* Return values from nested functions */
 
 	while (true) {
+		/*
+		 * Skip plain characters up to the next conversion. Neither
+		 * '%' nor the terminator can occur inside a UTF-8 sequence,
+		 * so there is no need to decode them.
+		 */
+		while (fmt[nxt] != '%' && fmt[nxt] != 0)
+			nxt++;
+
 		i = nxt;
 		char32_t uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
 
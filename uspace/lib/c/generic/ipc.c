@@ -162,6 +162,22 @@ errno_t ipc_answer_slow(cap_call_handle_t chandle, errno_t retval,
 	    cap_handle_raw(chandle), (sysarg_t) &data);
 }
 
+/** Answer a batch of received calls.
+ *
+ * @param answers Array of answers. The cap_handle member identifies the call
+ *                being answered, the args member carries the answer payload.
+ * @param count   Number of answers, at most IPC_MAX_BATCH.
+ *
+ * @return Zero on success.
+ * @return Value from @ref errno.h of the first failed answer.
+ *
+ */
+errno_t ipc_answer_batch(ipc_call_t *answers, size_t count)
+{
+	return (errno_t) __SYSCALL2(SYS_IPC_ANSWER_BATCH, (sysarg_t) answers,
+	    (sysarg_t) count);
+}
+
 /** Interrupt one thread of this task from waiting for IPC.
  *
  */
@@ -176,6 +192,28 @@ errno_t ipc_wait(ipc_call_t *call, sysarg_t usec, unsigned int flags)
 	return __SYSCALL3(SYS_IPC_WAIT, (sysarg_t) call, usec, flags);
 }
 
+/** Wait for a batch of calls.
+ *
+ * Blocks for the first call and then collects up to count - 1 more calls
+ * which are already pending.
+ *
+ * @param calls    Array of call buffers.
+ * @param count    Number of buffers in the array.
+ * @param received Storage for the number of received calls.
+ * @param usec     Timeout for the first call.
+ * @param flags    Flags for the first call.
+ *
+ * @return Zero on success.
+ * @return Value from @ref errno.h on failure.
+ *
+ */
+errno_t ipc_wait_batch(ipc_call_t *calls, size_t count, size_t *received,
+    sysarg_t usec, unsigned int flags)
+{
+	return (errno_t) __SYSCALL5(SYS_IPC_WAIT_BATCH, (sysarg_t) calls,
+	    (sysarg_t) count, usec, flags, (sysarg_t) received);
+}
+
 /** Hang up a phone.
  *
  * @param phandle  Handle of the phone to be hung up.
@@ -85,5 +85,19 @@ errno_t ipc_irq_unsubscribe(cap_irq_handle_t cap)
 	    cap_handle_raw(cap));
 }
 
+/** Route an IRQ to a CPU.
+ *
+ * @param cap   IRQ capability handle.
+ * @param cpu   CPU ID or IRQ_CPU_ANY.
+ *
+ * @return Value returned by the kernel.
+ *
+ */
+errno_t ipc_irq_set_affinity(cap_irq_handle_t cap, unsigned int cpu)
+{
+	return (errno_t) __SYSCALL2(SYS_IPC_IRQ_SET_AFFINITY,
+	    cap_handle_raw(cap), (sysarg_t) cpu);
+}
+
 /** @}
  */
@@ -55,6 +55,114 @@ static async_sess_t *loc_cons_block_sess = NULL;
 static async_sess_t *loc_supplier_sess = NULL;
 static async_sess_t *loc_consumer_sess = NULL;
 
+/** Number of services whose names are cached */
+#define LOC_CACHE_SIZE  32
+
+/** Cached names of a service */
+typedef struct {
+	/** Service ID, 0 if the entry is free */
+	service_id_t id;
+	/** Fully qualified service name or @c NULL if not known */
+	char *name;
+	/** Server name or @c NULL if not known */
+	char *server;
+} loc_cache_entry_t;
+
+/*
+ * Names of services are cached once the category change callback is
+ * registered. locsrv sends the event whenever a service is unregistered,
+ * which is the only way a cached name can become stale as service IDs
+ * are never reused. The whole cache is dropped on each event.
+ */
+static FIBRIL_MUTEX_INITIALIZE(loc_cache_mutex);
+static bool loc_cache_enabled = false;
+static loc_cache_entry_t loc_cache[LOC_CACHE_SIZE];
+static size_t loc_cache_next = 0;
+
+/** Find cache entry by service ID.
+ *
+ * Must be called with loc_cache_mutex locked.
+ */
+static loc_cache_entry_t *loc_cache_find_id(service_id_t id)
+{
+	for (size_t i = 0; i < LOC_CACHE_SIZE; i++) {
+		if (loc_cache[i].id != 0 && loc_cache[i].id == id)
+			return &loc_cache[i];
+	}
+
+	return NULL;
+}
+
+/** Find cache entry by fully qualified service name.
+ *
+ * Must be called with loc_cache_mutex locked.
+ */
+static loc_cache_entry_t *loc_cache_find_name(const char *name)
+{
+	for (size_t i = 0; i < LOC_CACHE_SIZE; i++) {
+		if (loc_cache[i].id != 0 && loc_cache[i].name != NULL &&
+		    str_cmp(loc_cache[i].name, name) == 0)
+			return &loc_cache[i];
+	}
+
+	return NULL;
+}
+
+/** Remember names of a service.
+ *
+ * @param id		Service ID
+ * @param name		Fully qualified service name or @c NULL
+ * @param server	Server name or @c NULL
+ */
+static void loc_cache_put(service_id_t id, const char *name,
+    const char *server)
+{
+	loc_cache_entry_t *entry;
+
+	fibril_mutex_lock(&loc_cache_mutex);
+
+	if (!loc_cache_enabled) {
+		fibril_mutex_unlock(&loc_cache_mutex);
+		return;
+	}
+
+	entry = loc_cache_find_id(id);
+	if (entry == NULL) {
+		/* Replace entries round-robin */
+		entry = &loc_cache[loc_cache_next];
+		loc_cache_next = (loc_cache_next + 1) % LOC_CACHE_SIZE;
+
+		free(entry->name);
+		free(entry->server);
+		entry->id = id;
+		entry->name = NULL;
+		entry->server = NULL;
+	}
+
+	if (name != NULL && entry->name == NULL)
+		entry->name = str_dup(name);
+	if (server != NULL && entry->server == NULL)
+		entry->server = str_dup(server);
+
+	fibril_mutex_unlock(&loc_cache_mutex);
+}
+
+/** Drop all cached names. */
+static void loc_cache_invalidate(void)
+{
+	fibril_mutex_lock(&loc_cache_mutex);
+
+	for (size_t i = 0; i < LOC_CACHE_SIZE; i++) {
+		free(loc_cache[i].name);
+		free(loc_cache[i].server);
+		loc_cache[i].id = 0;
+		loc_cache[i].name = NULL;
+		loc_cache[i].server = NULL;
+	}
+
+	fibril_mutex_unlock(&loc_cache_mutex);
+}
+
 static void loc_cb_conn(ipc_call_t *icall, void *arg)
 {
 	while (true) {
@@ -75,6 +183,9 @@ static void loc_cb_conn(ipc_call_t *icall, void *arg)
 
 			async_answer_0(&call, EOK);
 
+			/* Let the callback see the current state. */
+			loc_cache_invalidate();
+
 			if (cb_fun != NULL)
 				(*cb_fun)(cb_arg);
 
@@ -328,6 +439,16 @@ errno_t loc_service_get_id(const char *fqdn, service_id_t *handle,
 {
 	async_exch_t *exch;
 
+	fibril_mutex_lock(&loc_cache_mutex);
+	loc_cache_entry_t *entry = loc_cache_find_name(fqdn);
+	if (entry != NULL) {
+		if (handle != NULL)
+			*handle = entry->id;
+		fibril_mutex_unlock(&loc_cache_mutex);
+		return EOK;
+	}
+	fibril_mutex_unlock(&loc_cache_mutex);
+
 	if (flags & IPC_FLAG_BLOCKING)
 		exch = loc_exchange_begin_blocking(INTERFACE_LOC_CONSUMER);
 	else {
@@ -360,6 +481,13 @@ errno_t loc_service_get_id(const char *fqdn, service_id_t *handle,
 	if (handle != NULL)
 		*handle = (service_id_t) ipc_get_arg1(&answer);
 
+	/*
+	 * Only a name with a namespace is in the form returned by
+	 * loc_service_get_name().
+	 */
+	if (str_chr(fqdn, '/') != NULL)
+		loc_cache_put(ipc_get_arg1(&answer), fqdn, NULL);
+
 	return retval;
 }
 
@@ -439,7 +567,22 @@ errno_t loc_category_get_name(category_id_t cat_id, char **name)
  */
 errno_t loc_service_get_name(service_id_t svc_id, char **name)
 {
-	return loc_get_name_internal(LOC_SERVICE_GET_NAME, svc_id, name);
+	errno_t rc;
+
+	fibril_mutex_lock(&loc_cache_mutex);
+	loc_cache_entry_t *entry = loc_cache_find_id(svc_id);
+	if (entry != NULL && entry->name != NULL) {
+		*name = str_dup(entry->name);
+		fibril_mutex_unlock(&loc_cache_mutex);
+		return *name != NULL ? EOK : ENOMEM;
+	}
+	fibril_mutex_unlock(&loc_cache_mutex);
+
+	rc = loc_get_name_internal(LOC_SERVICE_GET_NAME, svc_id, name);
+	if (rc == EOK)
+		loc_cache_put(svc_id, *name, NULL);
+
+	return rc;
 }
 
 /** Get service server name.
@@ -453,7 +596,22 @@ errno_t loc_service_get_name(service_id_t svc_id, char **name)
  */
 errno_t loc_service_get_server_name(service_id_t svc_id, char **name)
 {
-	return loc_get_name_internal(LOC_SERVICE_GET_SERVER_NAME, svc_id, name);
+	errno_t rc;
+
+	fibril_mutex_lock(&loc_cache_mutex);
+	loc_cache_entry_t *entry = loc_cache_find_id(svc_id);
+	if (entry != NULL && entry->server != NULL) {
+		*name = str_dup(entry->server);
+		fibril_mutex_unlock(&loc_cache_mutex);
+		return *name != NULL ? EOK : ENOMEM;
+	}
+	fibril_mutex_unlock(&loc_cache_mutex);
+
+	rc = loc_get_name_internal(LOC_SERVICE_GET_SERVER_NAME, svc_id, name);
+	if (rc == EOK)
+		loc_cache_put(svc_id, NULL, *name);
+
+	return rc;
 }
 
 errno_t loc_namespace_get_id(const char *name, service_id_t *handle,
@@ -847,6 +1005,60 @@ errno_t loc_category_get_svcs(category_id_t cat_id, service_id_t **data,
 	    data, count);
 }
 
+/** Get IDs and names of all services in category.
+ *
+ * Returns an allocated array of service descriptors, carrying the ID, the
+ * fully qualified name and the server name of each service. This saves
+ * a loc_service_get_name() and loc_service_get_server_name() round trip
+ * per service.
+ *
+ * @param cat_id	Category ID
+ * @param data		Place to store pointer to array of descriptors
+ * @param count		Place to store number of descriptors
+ * @return 		EOK on success or an error code
+ */
+errno_t loc_category_get_svc_descs(category_id_t cat_id,
+    loc_svc_desc_t **data, size_t *count)
+{
+	loc_svc_desc_t *desc = NULL;
+	size_t alloc_size = 0;
+	size_t act_size;
+	errno_t rc;
+
+	*data = NULL;
+	*count = 0;
+
+	while (true) {
+		rc = loc_category_get_ids_once(LOC_CATEGORY_GET_SVC_DESCS,
+		    cat_id, (sysarg_t *) desc, alloc_size, &act_size);
+		if (rc != EOK) {
+			free(desc);
+			return rc;
+		}
+
+		if (act_size <= alloc_size)
+			break;
+
+		alloc_size = act_size;
+		loc_svc_desc_t *tmp = realloc(desc, alloc_size);
+		if (tmp == NULL) {
+			free(desc);
+			return ENOMEM;
+		}
+		desc = tmp;
+	}
+
+	*count = act_size / sizeof(loc_svc_desc_t);
+	*data = desc;
+
+	for (size_t i = 0; i < *count; i++) {
+		loc_cache_put(desc[i].id, desc[i].name,
+		    desc[i].server[0] != '\0' ? desc[i].server : NULL);
+	}
+
+	return EOK;
+}
+
 /** Get list of categories.
  *
  * Returns an allocated array of category IDs.
@@ -878,5 +1090,9 @@ errno_t loc_register_cat_change_cb(loc_cat_change_cb_t cb_fun, void *cb_arg)
 	cat_change_arg = cb_arg;
 	fibril_mutex_unlock(&loc_callback_mutex);
 
+	fibril_mutex_lock(&loc_cache_mutex);
+	loc_cache_enabled = true;
+	fibril_mutex_unlock(&loc_cache_mutex);
+
 	return EOK;
 }
@@ -46,6 +46,8 @@
 #include <mem.h>
 #include <stdlib.h>
 #include <adt/gcdlcm.h>
+#include <adt/list.h>
+#include <fibril.h>
 
 #include "private/malloc.h"
 #include "private/fibril.h"
@@ -59,6 +61,15 @@
 /** Magic used in heap descriptor. */
 #define HEAP_AREA_MAGIC  UINT32_C(0xBEEFCAFE)
 
+/** Magic used in headers of small blocks. */
+#define SMALL_BLOCK_MAGIC  UINT32_C(0xBEEF0303)
+
+/** Magic used in headers of large blocks. */
+#define LARGE_BLOCK_MAGIC  UINT32_C(0xBEEF0404)
+
+/** Magic used in span descriptor. */
+#define SPAN_MAGIC  UINT32_C(0xBEEFF00D)
+
 /** Allocation alignment.
  *
  * This also covers the alignment of fields
@@ -77,6 +88,34 @@
  */
 #define SHRINK_GRANULARITY  (64 * PAGE_SIZE)
 
+/** Largest small block
+ *
+ * Small blocks are allocated from size classes
+ * through the caches without taking the heap lock.
+ *
+ */
+#define SMALL_MAX  1024
+
+/** Size of the page runs small blocks are carved from. */
+#define SPAN_SIZE  (16 * PAGE_SIZE)
+
+/** Smallest large block
+ *
+ * Large blocks get a separate address space area each
+ * so that they never fragment the heap.
+ *
+ */
+#define LARGE_MIN  (32 * PAGE_SIZE)
+
+/** Number of caches of free small blocks. */
+#define MALLOC_CACHES  8
+
+/** Maximum number of free blocks of a size class in a cache. */
+#define CACHE_MAX  64
+
+/** Number of blocks moved between a cache and a size class at once. */
+#define CACHE_BATCH  (CACHE_MAX / 2)
+
 /** Overhead of each heap block. */
 #define STRUCT_OVERHEAD \
 	(sizeof(heap_block_head_t) + sizeof(heap_block_foot_t))
@@ -297,7 +336,8 @@ static bool area_create(size_t size)
 	/* Align the heap area size on page boundary */
 	size_t asize = ALIGN_UP(size, PAGE_SIZE);
 	void *astart = as_area_create(AS_AREA_ANY, asize,
-	    AS_AREA_WRITE | AS_AREA_READ | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	    AS_AREA_WRITE | AS_AREA_READ | AS_AREA_CACHEABLE |
+	    AS_AREA_LARGE_PAGES, AS_AREA_UNPAGED);
 	if (astart == AS_MAP_FAILED)
 		return false;
 
@@ -483,6 +523,501 @@ static void heap_shrink(heap_area_t *area)
 	next_fit = NULL;
 }
 
+/** Size classes of small blocks (net sizes). */
+static const size_t class_sizes[] = {
+	16, 32, 48, 64, 80, 96, 112, 128,
+	160, 192, 224, 256, 320, 384, 448, 512,
+	640, 768, 896, SMALL_MAX
+};
+
+#define SIZE_CLASSES  (sizeof(class_sizes) / sizeof(class_sizes[0]))
+
+/** Header of a small or a large block
+ *
+ * Mirrors the layout of heap_block_head_t so that the kind
+ * of any block can be told from the magic in its header.
+ *
+ */
+typedef struct {
+	/* Net size of a small block, size of the area of a large block */
+	size_t size;
+
+	/* Indication of a free block */
+	bool free;
+
+	/** Span of a small block, start of the area of a large block */
+	void *base;
+
+	/* A magic value to tell the kind of the block */
+	uint32_t magic;
+} chunk_head_t;
+
+static_assert(sizeof(chunk_head_t) == sizeof(heap_block_head_t), "");
+static_assert(offsetof(chunk_head_t, magic) ==
+    offsetof(heap_block_head_t, magic), "");
+
+/** Small block size class
+ *
+ * Keeps the spans the blocks of the class are carved from.
+ *
+ */
+typedef struct {
+	/** Protects the span list and the spans */
+	fibril_rmutex_t lock;
+
+	/** Gross size of the blocks (including the header) */
+	size_t size;
+
+	/** Spans with free blocks */
+	list_t partial;
+
+	/** Number of spans in the partial list */
+	size_t npartial;
+} size_class_t;
+
+/** Span
+ *
+ * A run of pages in a separate address space area which is
+ * carved into small blocks of a single size class. This
+ * structure is at its very beginning.
+ *
+ */
+typedef struct {
+	/** Link in the list of partial spans of the size class */
+	link_t link;
+
+	/** Size class of the span */
+	size_class_t *cls;
+
+	/** Free blocks returned to the span */
+	chunk_head_t *free;
+
+	/** Next block which has not been handed out yet */
+	uintptr_t bump;
+
+	/** End of the last block */
+	uintptr_t end;
+
+	/** Number of blocks handed out (including blocks in caches) */
+	size_t used;
+
+	/** A magic value */
+	uint32_t magic;
+} span_t;
+
+/** Cached free blocks of one size class */
+typedef struct {
+	chunk_head_t *head;
+	size_t count;
+} cache_bin_t;
+
+/** Cache of free small blocks
+ *
+ * There are several caches so that fibrils running in different threads
+ * rarely compete over one. A fibril sticks to the cache it used last and
+ * only moves on to another one when it finds its cache locked.
+ *
+ */
+typedef struct {
+	fibril_rmutex_t lock;
+	cache_bin_t bins[SIZE_CLASSES];
+} malloc_cache_t;
+
+/** Size classes of small blocks */
+static size_class_t classes[SIZE_CLASSES];
+
+/** Size class index by net size in BASE_ALIGN units */
+static uint8_t class_index[SMALL_MAX / BASE_ALIGN + 1];
+
+/** Caches of free small blocks */
+static malloc_cache_t caches[MALLOC_CACHES];
+
+/** Cache used last by the current fibril */
+static fibril_local unsigned cache_hint;
+
+/** Get the next block in a list of free small blocks. */
+static inline chunk_head_t *chunk_next(chunk_head_t *head)
+{
+	return *(chunk_head_t **) (head + 1);
+}
+
+/** Set the next block in a list of free small blocks. */
+static inline void chunk_set_next(chunk_head_t *head, chunk_head_t *next)
+{
+	*(chunk_head_t **) (head + 1) = next;
+}
+
+/** Initialize size classes and caches of small blocks. */
+static void small_init(void)
+{
+	size_t c = 0;
+
+	for (size_t i = 0; i < SIZE_CLASSES; i++) {
+		if (fibril_rmutex_initialize(&classes[i].lock) != EOK)
+			abort();
+
+		classes[i].size = sizeof(chunk_head_t) + class_sizes[i];
+		list_initialize(&classes[i].partial);
+		classes[i].npartial = 0;
+	}
+
+	for (size_t i = 0; i < sizeof(class_index); i++) {
+		while (class_sizes[c] < i * BASE_ALIGN)
+			c++;
+		class_index[i] = c;
+	}
+
+	for (size_t i = 0; i < MALLOC_CACHES; i++) {
+		if (fibril_rmutex_initialize(&caches[i].lock) != EOK)
+			abort();
+	}
+}
+
+static void small_fini(void)
+{
+	for (size_t i = 0; i < MALLOC_CACHES; i++)
+		fibril_rmutex_destroy(&caches[i].lock);
+
+	for (size_t i = 0; i < SIZE_CLASSES; i++)
+		fibril_rmutex_destroy(&classes[i].lock);
+}
+
+/** Create a new span for a size class
+ *
+ * Should be called only with the size class locked.
+ *
+ * @param cls Size class.
+ *
+ * @return New span or NULL on not enough memory.
+ *
+ */
+static span_t *span_create(size_class_t *cls)
+{
+	void *astart = as_area_create(AS_AREA_ANY, SPAN_SIZE,
+	    AS_AREA_WRITE | AS_AREA_READ | AS_AREA_CACHEABLE,
+	    AS_AREA_UNPAGED);
+	if (astart == AS_MAP_FAILED)
+		return NULL;
+
+	span_t *span = (span_t *) astart;
+	uintptr_t first = ALIGN_UP((uintptr_t) astart + sizeof(span_t),
+	    BASE_ALIGN);
+	size_t count = ((uintptr_t) astart + SPAN_SIZE - first) / cls->size;
+
+	link_initialize(&span->link);
+	span->cls = cls;
+	span->free = NULL;
+	span->bump = first;
+	span->end = first + count * cls->size;
+	span->used = 0;
+	span->magic = SPAN_MAGIC;
+
+	list_append(&span->link, &cls->partial);
+	cls->npartial++;
+
+	return span;
+}
+
+/** Take a block from a span
+ *
+ * Should be called only with the size class locked.
+ *
+ * @param span Span with at least one free block.
+ *
+ * @return Free block.
+ *
+ */
+static chunk_head_t *span_take(span_t *span)
+{
+	chunk_head_t *head;
+
+	if (span->free != NULL) {
+		head = span->free;
+		span->free = chunk_next(head);
+		malloc_assert(head->magic == SMALL_BLOCK_MAGIC);
+	} else {
+		malloc_assert(span->bump < span->end);
+
+		head = (chunk_head_t *) span->bump;
+		span->bump += span->cls->size;
+
+		head->size = span->cls->size - sizeof(chunk_head_t);
+		head->free = true;
+		head->base = span;
+		head->magic = SMALL_BLOCK_MAGIC;
+	}
+
+	span->used++;
+
+	if ((span->free == NULL) && (span->bump == span->end)) {
+		/* The span is full now. */
+		list_remove(&span->link);
+		span->cls->npartial--;
+	}
+
+	return head;
+}
+
+/** Return a block to its span
+ *
+ * A span of which no block is used anymore is destroyed,
+ * unless it is the last span with free blocks in its class.
+ * Should be called only with the size class locked.
+ *
+ * @param head Free block.
+ *
+ */
+static void span_put(chunk_head_t *head)
+{
+	span_t *span = (span_t *) head->base;
+	size_class_t *cls = span->cls;
+
+	malloc_assert(span->magic == SPAN_MAGIC);
+	malloc_assert(span->used > 0);
+
+	if ((span->free == NULL) && (span->bump == span->end)) {
+		/* The span was full. */
+		list_append(&span->link, &cls->partial);
+		cls->npartial++;
+	}
+
+	chunk_set_next(head, span->free);
+	span->free = head;
+	span->used--;
+
+	if ((span->used == 0) && (cls->npartial > 1)) {
+		list_remove(&span->link);
+		cls->npartial--;
+		span->magic = 0;
+		as_area_destroy(span);
+	}
+}
+
+/** Lock a cache of free small blocks
+ *
+ * Prefer the cache used last by the current fibril,
+ * but do not wait for it if another one is available.
+ *
+ * @return Locked cache.
+ *
+ */
+static malloc_cache_t *cache_lock(void)
+{
+	unsigned hint = cache_hint;
+
+	for (unsigned i = 0; i < MALLOC_CACHES; i++) {
+		unsigned idx = (hint + i) % MALLOC_CACHES;
+
+		if (fibril_rmutex_trylock(&caches[idx].lock)) {
+			cache_hint = idx;
+			return &caches[idx];
+		}
+	}
+
+	/* All caches are busy, wait for ours. */
+	fibril_rmutex_lock(&caches[hint].lock);
+	return &caches[hint];
+}
+
+/** Allocate a small block
+ *
+ * @param size Number of bytes to allocate (at most SMALL_MAX).
+ *
+ * @return Address of the allocated block or NULL on not enough memory.
+ *
+ */
+static void *small_alloc(size_t size)
+{
+	size_t c = class_index[(size + BASE_ALIGN - 1) / BASE_ALIGN];
+	malloc_cache_t *cache = cache_lock();
+	cache_bin_t *bin = &cache->bins[c];
+
+	if (bin->head == NULL) {
+		/* Refill the cache from the spans of the size class. */
+		size_class_t *cls = &classes[c];
+
+		fibril_rmutex_lock(&cls->lock);
+
+		while (bin->count < CACHE_BATCH) {
+			span_t *span;
+
+			if (!list_empty(&cls->partial)) {
+				span = list_get_instance(list_first(&cls->partial),
+				    span_t, link);
+			} else {
+				span = span_create(cls);
+				if (span == NULL)
+					break;
+			}
+
+			chunk_head_t *head = span_take(span);
+			chunk_set_next(head, bin->head);
+			bin->head = head;
+			bin->count++;
+		}
+
+		fibril_rmutex_unlock(&cls->lock);
+
+		if (bin->head == NULL) {
+			fibril_rmutex_unlock(&cache->lock);
+			return NULL;
+		}
+	}
+
+	chunk_head_t *head = bin->head;
+	bin->head = chunk_next(head);
+	bin->count--;
+
+	fibril_rmutex_unlock(&cache->lock);
+
+	malloc_assert(head->free);
+	head->free = false;
+
+	return (void *) (head + 1);
+}
+
+/** Free a small block
+ *
+ * @param head Header of the block.
+ *
+ */
+static void small_free(chunk_head_t *head)
+{
+	span_t *span = (span_t *) head->base;
+
+	malloc_assert(!head->free);
+	malloc_assert(span->magic == SPAN_MAGIC);
+
+	head->free = true;
+
+	size_t c = span->cls - classes;
+	malloc_cache_t *cache = cache_lock();
+	cache_bin_t *bin = &cache->bins[c];
+
+	chunk_set_next(head, bin->head);
+	bin->head = head;
+	bin->count++;
+
+	if (bin->count > CACHE_MAX) {
+		/* Give some blocks back to their spans. */
+		size_class_t *cls = &classes[c];
+
+		fibril_rmutex_lock(&cls->lock);
+
+		while (bin->count > CACHE_MAX - CACHE_BATCH) {
+			chunk_head_t *cur = bin->head;
+			bin->head = chunk_next(cur);
+			bin->count--;
+			span_put(cur);
+		}
+
+		fibril_rmutex_unlock(&cls->lock);
+	}
+
+	fibril_rmutex_unlock(&cache->lock);
+}
+
+/** Allocate a large block in a separate address space area
+ *
+ * @param size  Number of bytes to allocate.
+ * @param align Memory address alignment (at most PAGE_SIZE).
+ *
+ * @return Address of the allocated block or NULL on not enough memory.
+ *
+ */
+static void *large_alloc(size_t size, size_t align)
+{
+	size_t offset = ALIGN_UP(sizeof(chunk_head_t), align);
+
+	/* Check for integer overflow. */
+	if (offset + size < size)
+		return NULL;
+
+	size_t asize = ALIGN_UP(offset + size, PAGE_SIZE);
+	if (asize < offset + size)
+		return NULL;
+
+	void *astart = as_area_create(AS_AREA_ANY, asize,
+	    AS_AREA_WRITE | AS_AREA_READ | AS_AREA_CACHEABLE |
+	    AS_AREA_LARGE_PAGES, AS_AREA_UNPAGED);
+	if (astart == AS_MAP_FAILED)
+		return NULL;
+
+	void *addr = astart + offset;
+	chunk_head_t *head = (chunk_head_t *) (addr - sizeof(chunk_head_t));
+
+	head->size = asize;
+	head->free = false;
+	head->base = astart;
+	head->magic = LARGE_BLOCK_MAGIC;
+
+	return addr;
+}
+
+/** Free a large block
+ *
+ * @param head Header of the block.
+ *
+ */
+static void large_free(chunk_head_t *head)
+{
+	malloc_assert(!head->free);
+
+	head->free = true;
+	head->magic = 0;
+	as_area_destroy(head->base);
+}
+
+/** Resize a small or a large block
+ *
+ * @param addr Address of the block.
+ * @param head Header of the block.
+ * @param size New size of the block.
+ *
+ * @return Reallocated memory or NULL.
+ *
+ */
+static void *chunk_realloc(void *addr, chunk_head_t *head, size_t size)
+{
+	size_t usable;
+
+	malloc_assert(!head->free);
+
+	if (head->magic == SMALL_BLOCK_MAGIC) {
+		usable = head->size;
+
+		/* Keep the block if the new size falls into the same class. */
+		if ((size <= SMALL_MAX) &&
+		    (class_sizes[class_index[(size + BASE_ALIGN - 1) /
+		    BASE_ALIGN]] == usable))
+			return addr;
+	} else {
+		size_t offset = (size_t) (addr - head->base);
+		usable = head->size - offset;
+
+		/* Keep the block if it is not too large for the new size. */
+		if ((size <= usable) && (size >= usable / 2))
+			return addr;
+
+		/* Try to resize the area in place. */
+		size_t asize = ALIGN_UP(offset + size, PAGE_SIZE);
+
+		if ((size >= LARGE_MIN) && (asize >= offset + size) &&
+		    (as_area_resize(head->base, asize, 0) == EOK)) {
+			head->size = asize;
+			return addr;
+		}
+	}
+
+	void *ptr = malloc(size);
+	if (ptr != NULL) {
+		memcpy(ptr, addr, min(size, usable));
+		free(addr);
+	}
+
+	return ptr;
+}
+
 /** Initialize the heap allocator
  *
  * Create initial heap memory area. This routine is
@@ -497,10 +1032,13 @@ void __malloc_init(void)
 
 	if (!area_create(PAGE_SIZE))
 		abort();
+
+	small_init();
 }
 
 void __malloc_fini(void)
 {
+	small_fini();
 	fibril_rmutex_destroy(&malloc_mutex);
 }
 
@@ -801,6 +1339,12 @@ void *calloc(const size_t nmemb, const size_t size)
  */
 void *malloc(const size_t size)
 {
+	if (size <= SMALL_MAX)
+		return small_alloc(size);
+
+	if (size >= LARGE_MIN)
+		return large_alloc(size, BASE_ALIGN);
+
 	heap_lock();
 	void *block = malloc_internal(size, BASE_ALIGN);
 	heap_unlock();
@@ -824,6 +1368,12 @@ void *memalign(const size_t align, const size_t size)
 	size_t palign =
 	    1 << (fnzb(max(sizeof(void *), align) - 1) + 1);
 
+	if ((size <= SMALL_MAX) && (palign <= BASE_ALIGN))
+		return small_alloc(size);
+
+	if ((size >= LARGE_MIN) && (palign <= PAGE_SIZE))
+		return large_alloc(size, palign);
+
 	heap_lock();
 	void *block = malloc_internal(size, palign);
 	heap_unlock();
@@ -849,6 +1399,13 @@ void *realloc(void *const addr, const size_t size)
 	if (addr == NULL)
 		return malloc(size);
 
+	chunk_head_t *chunk =
+	    (chunk_head_t *) (addr - sizeof(chunk_head_t));
+
+	if ((chunk->magic == SMALL_BLOCK_MAGIC) ||
+	    (chunk->magic == LARGE_BLOCK_MAGIC))
+		return chunk_realloc(addr, chunk, size);
+
 	heap_lock();
 
 	/* Calculate the position of the header. */
@@ -958,6 +1515,19 @@ void free(void *const addr)
 	if (addr == NULL)
 		return;
 
+	chunk_head_t *chunk =
+	    (chunk_head_t *) (addr - sizeof(chunk_head_t));
+
+	if (chunk->magic == SMALL_BLOCK_MAGIC) {
+		small_free(chunk);
+		return;
+	}
+
+	if (chunk->magic == LARGE_BLOCK_MAGIC) {
+		large_free(chunk);
+		return;
+	}
+
 	heap_lock();
 
 	/* Calculate the position of the header. */
@@ -37,8 +37,12 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <str_search.h>
+#include <libarch/config.h>
 #include "private/cc.h"
 
+#ifndef LIBARCH_MEMSET
+
 /** Fill memory block with a constant value. */
 ATTRIBUTE_OPTIMIZE_NO_TLDP
     void *memset(void *dest, int b, size_t n)
@@ -94,10 +98,14 @@ ATTRIBUTE_OPTIMIZE_NO_TLDP
 	return dest;
 }
 
+#endif
+
 struct along {
 	unsigned long n;
 } __attribute__((packed));
 
+#ifndef LIBARCH_MEMCPY
+
 static void *unaligned_memcpy(void *dst, const void *src, size_t n)
 {
 	size_t i, j;
@@ -192,6 +200,8 @@ ATTRIBUTE_OPTIMIZE_NO_TLDP
 	return dst;
 }
 
+#endif
+
 /** Move memory block with possible overlapping. */
 void *memmove(void *dst, const void *src, size_t n)
 {
@@ -240,11 +250,22 @@ void *memmove(void *dst, const void *src, size_t n)
  */
 int memcmp(const void *s1, const void *s2, size_t len)
 {
-	uint8_t *u1 = (uint8_t *) s1;
-	uint8_t *u2 = (uint8_t *) s2;
+	const struct along *w1 = s1;
+	const struct along *w2 = s2;
 	size_t i;
 
-	for (i = 0; i < len; i++) {
+	/* Skip the equal words, the difference is then found bytewise. */
+	for (i = 0; len - i >= sizeof(unsigned long); i += sizeof(unsigned long)) {
+		if (w1->n != w2->n)
+			break;
+		w1++;
+		w2++;
+	}
+
+	uint8_t *u1 = (uint8_t *) w1;
+	uint8_t *u2 = (uint8_t *) w2;
+
+	for (; i < len; i++) {
 		if (*u1 != *u2)
 			return (int)(*u1) - (int)(*u2);
 		++u1;
@@ -265,17 +286,58 @@ int memcmp(const void *s1, const void *s2, size_t len)
  */
 void *memchr(const void *s, int c, size_t n)
 {
-	uint8_t *u = (uint8_t *) s;
+	const uint8_t *u = (const uint8_t *) s;
 	unsigned char uc = (unsigned char) c;
-	size_t i;
+	unsigned long ones = ((unsigned long) -1) / 0xff;
+	unsigned long highs = ones << 7;
+	unsigned long pattern = ones * uc;
+	unsigned long w;
+
+	/* Scan up to a word boundary. */
+	while (n > 0 && ((uintptr_t) u & (sizeof(unsigned long) - 1)) != 0) {
+		if (*u == uc)
+			return (void *) u;
+		u++;
+		n--;
+	}
 
-	for (i = 0; i < n; i++) {
-		if (u[i] == uc)
-			return (void *) &u[i];
+	/*
+	 * Skip the words that do not contain the byte. A word has a zero
+	 * byte iff (w - 0x01..01) & ~w & 0x80..80 is non-zero. Aligned
+	 * reads never cross into the next page.
+	 */
+	while (n >= sizeof(unsigned long)) {
+		w = *(const unsigned long *) u ^ pattern;
+		if (((w - ones) & ~w & highs) != 0)
+			break;
+		u += sizeof(unsigned long);
+		n -= sizeof(unsigned long);
+	}
+
+	while (n > 0) {
+		if (*u == uc)
+			return (void *) u;
+		u++;
+		n--;
 	}
 
 	return NULL;
 }
 
+/** Search memory area for a byte sequence.
+ *
+ * @param hs    Memory area
+ * @param hsize Size of memory area in bytes
+ * @param n     Byte sequence to search for
+ * @param nsize Size of the byte sequence
+ *
+ * @return Pointer to the first occurrence of @a n in @a hs or @c NULL
+ *         if not found. If @a nsize is zero, returns @a hs.
+ */
+void *memmem(const void *hs, size_t hsize, const void *n, size_t nsize)
+{
+	return (void *) str_search_mem(hs, hsize, n, nsize, false);
+}
+
 /** @}
  */
@@ -37,14 +37,46 @@
 #include <async.h>
 #include <macros.h>
 #include <errno.h>
+#include <adt/list.h>
+#include <fibril_synch.h>
+#include <stdlib.h>
 #include "private/ns.h"
 
+/** Maximum number of cached service connections */
+#define NS_CACHE_SIZE  8
+
 /*
  * XXX ns does not know about session_ns, so we create an extra session for
  * actual communicaton
  */
 static async_sess_t *sess_ns = NULL;
 
+/** Cached connection to a singleton service.
+ *
+ * The session is never used for exchanges. It only serves for opening new
+ * connections directly to the server, bypassing the naming service.
+ */
+typedef struct {
+	link_t link;
+	service_t service;
+	iface_t iface;
+	async_sess_t *sess;
+} ns_cache_entry_t;
+
+/** Pending connection requests of one service_conn_t. */
+typedef struct {
+	aid_t req;
+	ipc_call_t answer;
+	aid_t cache_req;
+	ipc_call_t cache_answer;
+} ns_conn_req_t;
+
+static FIBRIL_MUTEX_INITIALIZE(ns_cache_mutex);
+
+/** Cached connections, the most recently used first */
+static LIST_INITIALIZE(ns_cache);
+static size_t ns_cache_count = 0;
+
 errno_t service_register(service_t service, iface_t iface,
     async_port_handler_t handler, void *data)
 {
@@ -104,6 +136,228 @@ errno_t service_register_broker(service_t service, async_port_handler_t handler,
 	return rc;
 }
 
+/** Find a cached connection and reconnect through it.
+ *
+ * An entry whose server has gone away is dropped.
+ *
+ * @param service Singleton service ID.
+ * @param iface   Interface to connect to.
+ *
+ * @return New session or NULL if there is no usable cached connection.
+ *
+ */
+static async_sess_t *ns_cache_connect(service_t service, iface_t iface)
+{
+	async_sess_t *csess = NULL;
+
+	fibril_mutex_lock(&ns_cache_mutex);
+
+	list_foreach(ns_cache, link, ns_cache_entry_t, entry) {
+		if ((entry->service != service) || (entry->iface != iface))
+			continue;
+
+		csess = async_reconnect(entry->sess, NULL);
+		if (csess == NULL) {
+			/* The server is no longer there */
+			list_remove(&entry->link);
+			ns_cache_count--;
+			async_hangup(entry->sess);
+			free(entry);
+			break;
+		}
+
+		/* Keep the most recently used entries at the front */
+		list_remove(&entry->link);
+		list_prepend(&entry->link, &ns_cache);
+		break;
+	}
+
+	fibril_mutex_unlock(&ns_cache_mutex);
+	return csess;
+}
+
+/** Remember a connection for later reconnecting.
+ *
+ * The least recently used entry is evicted if the cache is full.
+ *
+ * @param service Singleton service ID.
+ * @param iface   Interface of the connection.
+ * @param sess    Session to keep, it is hung up if not kept.
+ *
+ */
+static void ns_cache_insert(service_t service, iface_t iface,
+    async_sess_t *sess)
+{
+	fibril_mutex_lock(&ns_cache_mutex);
+
+	list_foreach(ns_cache, link, ns_cache_entry_t, entry) {
+		if ((entry->service == service) && (entry->iface == iface)) {
+			/* Another fibril was faster */
+			fibril_mutex_unlock(&ns_cache_mutex);
+			async_hangup(sess);
+			return;
+		}
+	}
+
+	ns_cache_entry_t *entry = malloc(sizeof(ns_cache_entry_t));
+	if (entry == NULL) {
+		fibril_mutex_unlock(&ns_cache_mutex);
+		async_hangup(sess);
+		return;
+	}
+
+	if (ns_cache_count == NS_CACHE_SIZE) {
+		ns_cache_entry_t *last = list_get_instance(list_last(&ns_cache),
+		    ns_cache_entry_t, link);
+
+		list_remove(&last->link);
+		async_hangup(last->sess);
+		free(last);
+	} else {
+		ns_cache_count++;
+	}
+
+	link_initialize(&entry->link);
+	entry->service = service;
+	entry->iface = iface;
+	entry->sess = sess;
+	list_prepend(&entry->link, &ns_cache);
+
+	fibril_mutex_unlock(&ns_cache_mutex);
+}
+
+/** Return true if connections to @a service may be cached.
+ *
+ * Only connections to the well-known singleton servers themselves are
+ * cached. Connections carrying a custom argument are usually forwarded to
+ * another server by a broker and clonable services start a new server for
+ * every connection.
+ */
+static bool ns_cacheable(service_t service, iface_t iface, sysarg_t arg3)
+{
+	return (arg3 == 0) && !service_is_clonable(service, iface);
+}
+
+/** Connect to several singleton services.
+ *
+ * Connections that can be served from the cache go directly to the server.
+ * All remaining connection requests are sent to the naming service at once
+ * and the answers are collected afterwards, so that they take a single
+ * round trip. For a cacheable service an extra connection is requested
+ * along with the first one and kept in the cache.
+ *
+ * @param conns    Connection requests.
+ * @param reqs     Storage for the pending IPC requests, one per connection.
+ * @param count    Number of connection requests.
+ * @param blocking Wait for services which are not registered yet.
+ *
+ * @return EOK if all connections succeeded, otherwise the return code of
+ *         the first failed connection.
+ *
+ */
+static errno_t ns_connect(service_conn_t *conns, ns_conn_req_t *reqs,
+    size_t count, bool blocking)
+{
+	size_t pending = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		reqs[i].req = 0;
+		reqs[i].cache_req = 0;
+
+		conns[i].sess = NULL;
+		if (ns_cacheable(conns[i].service, conns[i].iface,
+		    conns[i].arg3)) {
+			conns[i].sess = ns_cache_connect(conns[i].service,
+			    conns[i].iface);
+		}
+
+		if (conns[i].sess != NULL)
+			conns[i].rc = EOK;
+		else
+			pending++;
+	}
+
+	if (pending > 0) {
+		errno_t rc;
+		async_sess_t *sess = ns_session_get(&rc);
+		async_exch_t *exch = async_exchange_begin(sess);
+		if (exch == NULL) {
+			if (sess != NULL)
+				rc = ENOENT;
+
+			for (size_t i = 0; i < count; i++) {
+				if (conns[i].sess == NULL)
+					conns[i].rc = rc;
+			}
+
+			return rc;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			service_conn_t *conn = &conns[i];
+			ns_conn_req_t *req = &reqs[i];
+
+			if (conn->sess != NULL)
+				continue;
+
+			req->req = async_connect_me_to_send(exch, conn->iface,
+			    conn->service, conn->arg3, blocking, &req->answer);
+
+			if (ns_cacheable(conn->service, conn->iface,
+			    conn->arg3)) {
+				req->cache_req = async_connect_me_to_send(exch,
+				    conn->iface, conn->service, 0, blocking,
+				    &req->cache_answer);
+			}
+		}
+
+		async_exchange_end(exch);
+	}
+
+	errno_t retval = EOK;
+
+	for (size_t i = 0; i < count; i++) {
+		service_conn_t *conn = &conns[i];
+		ns_conn_req_t *req = &reqs[i];
+
+		if (req->req != 0) {
+			conn->rc = EOK;
+			conn->sess = async_connect_me_to_wait(req->req,
+			    &req->answer, conn->iface, conn->service,
+			    conn->arg3, &conn->rc);
+
+			/*
+			 * FIXME Ugly hack to work around limitation of
+			 * implementing parallel exchanges using multiple
+			 * connections. Shift out first argument for non-initial
+			 * connections.
+			 */
+			if (conn->sess != NULL) {
+				async_sess_args_set(conn->sess, conn->iface,
+				    conn->arg3, 0);
+			}
+		} else if (conn->sess == NULL) {
+			conn->rc = ENOMEM;
+		}
+
+		if (req->cache_req != 0) {
+			async_sess_t *csess = async_connect_me_to_wait(
+			    req->cache_req, &req->cache_answer, conn->iface,
+			    conn->service, 0, NULL);
+			if (csess != NULL) {
+				async_sess_args_set(csess, conn->iface, 0, 0);
+				ns_cache_insert(conn->service, conn->iface,
+				    csess);
+			}
+		}
+
+		if ((conn->rc != EOK) && (retval == EOK))
+			retval = conn->rc;
+	}
+
+	return retval;
+}
+
 /** Connect to a singleton service.
  *
  * @param service Singleton service ID.
@@ -117,29 +371,21 @@ errno_t service_register_broker(service_t service, async_port_handler_t handler,
 async_sess_t *service_connect(service_t service, iface_t iface, sysarg_t arg3,
     errno_t *rc)
 {
-	async_sess_t *sess = ns_session_get(rc);
-	if (sess == NULL)
-		return NULL;
-
-	async_exch_t *exch = async_exchange_begin(sess);
-	if (exch == NULL)
-		return NULL;
+	service_conn_t conn = {
+		.service = service,
+		.iface = iface,
+		.arg3 = arg3
+	};
+	ns_conn_req_t req;
 
-	async_sess_t *csess =
-	    async_connect_me_to(exch, iface, service, arg3, rc);
-	async_exchange_end(exch);
+	if (ns_connect(&conn, &req, 1, false) != EOK) {
+		if (rc != NULL)
+			*rc = conn.rc;
 
-	if (csess == NULL)
 		return NULL;
+	}
 
-	/*
-	 * FIXME Ugly hack to work around limitation of implementing
-	 * parallel exchanges using multiple connections. Shift out
-	 * first argument for non-initial connections.
-	 */
-	async_sess_args_set(csess, iface, arg3, 0);
-
-	return csess;
+	return conn.sess;
 }
 
 /** Wait and connect to a singleton service.
@@ -155,26 +401,53 @@ async_sess_t *service_connect(service_t service, iface_t iface, sysarg_t arg3,
 async_sess_t *service_connect_blocking(service_t service, iface_t iface,
     sysarg_t arg3, errno_t *rc)
 {
-	async_sess_t *sess = ns_session_get(rc);
-	if (sess == NULL)
-		return NULL;
+	service_conn_t conn = {
+		.service = service,
+		.iface = iface,
+		.arg3 = arg3
+	};
+	ns_conn_req_t req;
 
-	async_exch_t *exch = async_exchange_begin(sess);
-	async_sess_t *csess =
-	    async_connect_me_to_blocking(exch, iface, service, arg3, rc);
-	async_exchange_end(exch);
+	if (ns_connect(&conn, &req, 1, true) != EOK) {
+		if (rc != NULL)
+			*rc = conn.rc;
 
-	if (csess == NULL)
 		return NULL;
+	}
 
-	/*
-	 * FIXME Ugly hack to work around limitation of implementing
-	 * parallel exchanges using multiple connections. Shift out
-	 * first argument for non-initial connections.
-	 */
-	async_sess_args_set(csess, iface, arg3, 0);
+	return conn.sess;
+}
 
-	return csess;
+/** Connect to several singleton services in one round trip.
+ *
+ * Meant for connecting to the well-known services a task needs at startup.
+ * The outcome of each connection is stored in its request, sessions of the
+ * successful connections are valid even if the function fails.
+ *
+ * @param conns    Connection requests.
+ * @param count    Number of connection requests.
+ * @param blocking Wait for services which are not registered yet.
+ *
+ * @return EOK if all connections succeeded, otherwise the return code of
+ *         the first failed connection.
+ *
+ */
+errno_t service_connect_batch(service_conn_t *conns, size_t count,
+    bool blocking)
+{
+	ns_conn_req_t *reqs = calloc(count, sizeof(ns_conn_req_t));
+	if (reqs == NULL) {
+		for (size_t i = 0; i < count; i++) {
+			conns[i].sess = NULL;
+			conns[i].rc = ENOMEM;
+		}
+
+		return ENOMEM;
+	}
+
+	errno_t rc = ns_connect(conns, reqs, count, blocking);
+	free(reqs);
+	return rc;
 }
 
 errno_t ns_ping(void)
@@ -220,5 +493,23 @@ async_sess_t *ns_session_get(errno_t *rc)
 	return sess_ns;
 }
 
+/** Forget the session to the naming service after the task was cloned. */
+void __ns_clone_reset(void)
+{
+	sess_ns = NULL;
+
+	/* The cached phones belong to the original task */
+	while (!list_empty(&ns_cache)) {
+		ns_cache_entry_t *entry = list_get_instance(
+		    list_first(&ns_cache), ns_cache_entry_t, link);
+
+		list_remove(&entry->link);
+		free(entry->sess);
+		free(entry);
+	}
+
+	ns_cache_count = 0;
+}
+
 /** @}
  */
@@ -41,6 +41,9 @@
 #include <fibril_synch.h>
 #include <time.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <abi/fourcc.h>
 
 /** Session data */
 struct async_sess {
@@ -76,8 +79,71 @@ struct async_sess {
 
 	/** Data for stateful connections */
 	void *remote_state_data;
+
+	/** Shared-memory ring channel or NULL if not attached */
+	async_ring_t *ring;
 };
 
+/** Magic value in ARG4 of IPC_M_SHARE_OUT calls setting up a ring channel */
+#define ASYNC_RING_MAGIC  FOURCC('r', 'i', 'n', 'g')
+
+/** Maximum number of entries in each queue of a ring channel */
+#define ASYNC_RING_MAX_ENTRIES  1024
+
+/** Call flag marking requests received through a ring channel
+ *
+ * The flag is private to the async framework and never passed to or from
+ * the kernel.
+ *
+ */
+#define ASYNC_CALL_RING  (1U << 31)
+
+/** IPC_M_RING operations */
+enum {
+	/** Wake up a server waiting for requests */
+	ASYNC_RING_KICK,
+	/** Ask to be woken up once answers are posted */
+	ASYNC_RING_ARM
+};
+
+/** Ring channel entry
+ *
+ * Requests carry the interface and method with up to five arguments,
+ * answers carry the return value with up to five return arguments.
+ */
+typedef struct {
+	/** Client slot of the call */
+	sysarg_t slot;
+	sysarg_t args[IPC_CALL_LEN];
+} async_ring_entry_t;
+
+/** Single-producer single-consumer queue of a ring channel */
+typedef struct {
+	/** Free-running producer index */
+	atomic_uint head;
+
+	/** Free-running consumer index */
+	atomic_uint tail;
+
+	/** Consumer went to sleep and has to be woken up by the producer */
+	atomic_bool sleeping;
+} __attribute__((aligned(64))) async_ring_queue_t;
+
+/** Layout of the area shared by both peers of a ring channel
+ *
+ * The request entries are followed by the same number of answer entries.
+ * The number of entries is negotiated when the ring is set up and is never
+ * read from the shared area.
+ */
+typedef struct {
+	async_ring_queue_t req;
+	async_ring_queue_t ans;
+	async_ring_entry_t entries[];
+} async_ring_shared_t;
+
+/** Server side of a ring channel */
+typedef struct async_ring_srv async_ring_srv_t;
+
 /** Exchange data */
 struct async_exch {
 	/** Link into list of inactive exchanges */
@@ -105,6 +171,19 @@ extern errno_t async_create_port_internal(iface_t, async_port_handler_t,
 extern async_port_handler_t async_get_port_handler(iface_t, port_id_t, void **);
 
 extern void async_reply_received(ipc_call_t *);
+extern void async_answer_flush(void);
+extern aid_t async_msg_alloc(ipc_call_t *);
+extern errno_t async_connect_me_to_internal(cap_phone_handle_t, iface_t,
+    sysarg_t, sysarg_t, sysarg_t, cap_phone_handle_t *);
+
+extern bool async_ring_enabled(iface_t);
+extern void async_ring_detach(async_sess_t *);
+extern async_ring_srv_t *async_ring_srv_accept(ipc_call_t *);
+extern bool async_ring_srv_receive(async_ring_srv_t *, ipc_call_t *);
+extern void async_ring_srv_control(async_ring_srv_t *, ipc_call_t *);
+extern errno_t async_ring_srv_answer(ipc_call_t *, errno_t, sysarg_t,
+    sysarg_t, sysarg_t, sysarg_t, sysarg_t);
+extern void async_ring_srv_close(async_ring_srv_t *);
 
 #endif
 
@@ -58,9 +58,15 @@ struct fibril {
 	tcb_t *tcb;
 
 	fibril_t *clean_after_me;
+	/* Fibril that yielded to this one, put into a ready queue by us. */
+	fibril_t *ready_after_me;
 	errno_t retval;
 
 	fibril_t *thread_ctx;
+	/* Ready queue of the thread, only set in the thread's helper fibril. */
+	struct _ready_queue *ready_queue;
+	/* Whether fibril_futex was held across the switch to this fibril. */
+	bool switch_locked;
 
 	bool is_running : 1;
 	bool is_writer : 1;
@@ -80,6 +86,7 @@ extern fibril_t *fibril_self(void);
 
 extern void __fibrils_init(void);
 extern void __fibrils_fini(void);
+extern void __fibrils_clone_reset(void);
 
 extern void fibril_wait_for(fibril_event_t *);
 extern errno_t fibril_wait_timeout(fibril_event_t *, const struct timespec *);
@@ -87,6 +94,7 @@ extern void fibril_notify(fibril_event_t *);
 
 extern errno_t fibril_ipc_wait(ipc_call_t *, const struct timespec *);
 extern void fibril_ipc_poke(void);
+extern bool fibril_ipc_pending(void);
 
 /**
  * "Restricted" fibril mutex.
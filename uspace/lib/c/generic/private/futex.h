@@ -85,7 +85,7 @@ void __futex_give_to(futex_t *, void *, const char *);
 
 #else
 
-#define futex_lock(fut)     (void) futex_down((fut))
+#define futex_lock(fut)     (void) futex_down_spin((fut))
 #define futex_trylock(fut)  futex_trydown((fut))
 #define futex_unlock(fut)   (void) futex_up((fut))
 
@@ -223,6 +223,38 @@ static inline errno_t futex_down(futex_t *futex)
 	return futex_down_timeout(futex, NULL);
 }
 
+/** Number of times a contended futex is polled before going to sleep. */
+#define FUTEX_SPIN_COUNT  100
+
+/** Down the futex, polling it for a while before sleeping.
+ *
+ * Futexes used as locks are usually held only briefly, by a thread running
+ * on another CPU. Polling the futex for a bounded number of iterations
+ * then avoids the round trip to the kernel. When there already are
+ * sleeping waiters, we sleep as well right away instead of overtaking them.
+ *
+ * @param futex Futex.
+ *
+ * @return ENOENT if there is no such virtual address.
+ * @return EOK on success.
+ * @return Error code from <errno.h> otherwise.
+ *
+ */
+static inline errno_t futex_down_spin(futex_t *futex)
+{
+	for (int i = 0; i < FUTEX_SPIN_COUNT; i++) {
+		int val = atomic_load_explicit(&futex->val, memory_order_relaxed);
+		if (val < 0)
+			break;
+
+		if (val > 0 && atomic_compare_exchange_weak_explicit(&futex->val,
+		    &val, val - 1, memory_order_acquire, memory_order_relaxed))
+			return EOK;
+	}
+
+	return futex_down(futex);
+}
+
 #endif
 
 /** @}
@@ -39,6 +39,8 @@
 
 extern async_sess_t session_ns;
 
+extern void __ns_clone_reset(void);
+
 #endif
 
 /** @}
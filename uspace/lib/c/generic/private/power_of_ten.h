@@ -29,9 +29,59 @@
 #ifndef POWER_OF_TEN_H_
 #define POWER_OF_TEN_H_
 
+#include <stdint.h>
+
 /* Fwd decl. */
 struct fp_num_t_tag;
 
 extern void get_power_of_ten(int, struct fp_num_t_tag *, int *);
 
+/** Number of entries of fp_pow5_inv_split. */
+#define FP_POW5_INV_COUNT  342
+/** Number of entries of fp_pow5_split. */
+#define FP_POW5_COUNT  326
+/** Bit width of the entries of fp_pow5_split and fp_pow5_inv_split. */
+#define FP_POW5_BITS  125
+
+/** Smallest decimal exponent in fp_pow10_128. */
+#define FP_POW10_128_MIN  (-325)
+/** Largest decimal exponent in fp_pow10_128. */
+#define FP_POW10_128_MAX  308
+
+extern const uint64_t fp_pow5_inv_split[FP_POW5_INV_COUNT][2];
+extern const uint64_t fp_pow5_split[FP_POW5_COUNT][2];
+extern const uint64_t fp_pow10_128[FP_POW10_128_MAX - FP_POW10_128_MIN + 1][2];
+
+/** Multiply two 64-bit numbers into a 128-bit product.
+ *
+ * @param a  First factor.
+ * @param b  Second factor.
+ * @param hi Place to store the upper 64 bits of the product.
+ * @return   The lower 64 bits of the product.
+ */
+static inline uint64_t fp_umul128(uint64_t a, uint64_t b, uint64_t *hi)
+{
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 p = (unsigned __int128) a * b;
+	*hi = (uint64_t) (p >> 64);
+	return (uint64_t) p;
+#else
+	uint64_t a_lo = (uint32_t) a;
+	uint64_t a_hi = a >> 32;
+	uint64_t b_lo = (uint32_t) b;
+	uint64_t b_hi = b >> 32;
+
+	uint64_t lo_lo = a_lo * b_lo;
+	uint64_t hi_lo = a_hi * b_lo;
+	uint64_t lo_hi = a_lo * b_hi;
+	uint64_t hi_hi = a_hi * b_hi;
+
+	/* Cannot overflow: at most 3 * (2^32 - 1). */
+	uint64_t mid = (lo_lo >> 32) + (uint32_t) hi_lo + (uint32_t) lo_hi;
+
+	*hi = hi_hi + (hi_lo >> 32) + (lo_hi >> 32) + (mid >> 32);
+	return (mid << 32) | (uint32_t) lo_lo;
+#endif
+}
+
 #endif
@@ -35,10 +35,11 @@
 #ifndef _LIBC_PRIVATE_SCANF_H_
 #define _LIBC_PRIVATE_SCANF_H_
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 
-extern errno_t __fstrtold(FILE *, int *, size_t, long double *);
+extern errno_t __fstrtold(FILE *, int *, size_t, bool, long double *);
 
 #endif
 
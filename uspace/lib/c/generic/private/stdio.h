@@ -115,6 +115,12 @@ struct _IO_FILE {
 	/** Points to end of occupied space when in read mode. */
 	uint8_t *buf_tail;
 
+	/** Mapping of the file contents in mmap mode or NULL */
+	uint8_t *map;
+
+	/** Size of the file contents in mmap mode */
+	size_t map_size;
+
 	/** Pushed back characters */
 	uint8_t ungetc_buf[UNGETC_MAX];
 
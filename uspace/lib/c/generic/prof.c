@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+#include <libc.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+#include <abi/prof.h>
+#include <prof.h>
+
+/** Start the kernel sampling profiler
+ *
+ * @param interval Sampling interval (clock ticks).
+ *
+ * @return EOK on success, EBUSY if the profiler is already running,
+ *         ENOTSUP if the kernel was built without the profiler.
+ *
+ */
+errno_t prof_start(unsigned int interval)
+{
+	return (errno_t) __SYSCALL2(SYS_PROF, PROF_START, interval);
+}
+
+/** Stop the kernel sampling profiler
+ *
+ * Samples which were not read yet are discarded.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t prof_stop(void)
+{
+	return (errno_t) __SYSCALL1(SYS_PROF, PROF_STOP);
+}
+
+/** Read samples taken by the kernel sampling profiler
+ *
+ * @param samples Buffer for the samples.
+ * @param count   Capacity of the buffer (samples).
+ * @param read    Place to store the number of samples read.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t prof_read(prof_sample_t *samples, size_t count, size_t *read)
+{
+	size_t nread;
+	errno_t rc = (errno_t) __SYSCALL5(SYS_PROF, PROF_READ, 0,
+	    (sysarg_t) samples, count * sizeof(prof_sample_t),
+	    (sysarg_t) &nread);
+	if (rc != EOK)
+		return rc;
+
+	*read = nread / sizeof(prof_sample_t);
+	return EOK;
+}
+
+/** Look up the kernel symbol containing an address
+ *
+ * @param addr Kernel address.
+ * @param name Buffer for the symbol name.
+ * @param size Size of the buffer.
+ * @param offs Place to store the offset of the address within the symbol.
+ *
+ * @return EOK on success, ENOENT if there is no such symbol.
+ *
+ */
+errno_t prof_symbol(uintptr_t addr, char *name, size_t size, size_t *offs)
+{
+	return (errno_t) __SYSCALL5(SYS_PROF, PROF_SYMBOL, addr,
+	    (sysarg_t) name, size, (sysarg_t) offs);
+}
+
+/** @}
+ */
@@ -33,11 +33,27 @@
 /**
  * @file
  * @brief Quicksort.
+ *
+ * Introspective quicksort: ranges are partitioned around a median-of-three
+ * (ninther for large ranges) pivot, small ranges are finished with insertion
+ * sort and heapsort takes over when the partitioning degenerates. Ranges
+ * that turn out to be already partitioned are first tried with a bounded
+ * insertion sort, which makes sorted and nearly sorted inputs cheap.
  */
 
 #include <qsort.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+/** Ranges up to this size are sorted by insertion sort */
+#define INSERTION_SORT_MAX  16
+
+/** Ranges above this size use the ninther for choosing a pivot */
+#define NINTHER_MIN  128
+
+/** Number of moves after which partial insertion sort gives up */
+#define PARTIAL_INSERTION_MAX  8
 
 /** Quicksort spec */
 typedef struct {
@@ -46,6 +62,8 @@ typedef struct {
 	size_t size;
 	int (*compar)(const void *, const void *, void *);
 	void *arg;
+	/** Elements can be swapped word by word */
+	bool word_swap;
 } qs_spec_t;
 
 /** Comparison function wrapper.
@@ -92,13 +110,25 @@ static bool elem_lt(qs_spec_t *qs, size_t i, size_t j)
  */
 static void elem_swap(qs_spec_t *qs, size_t i, size_t j)
 {
-	char *a;
-	char *b;
-	char t;
 	size_t k;
 
-	a = qs->base + i * qs->size;
-	b = qs->base + j * qs->size;
+	if (qs->word_swap) {
+		unsigned long *a = qs->base + i * qs->size;
+		unsigned long *b = qs->base + j * qs->size;
+		unsigned long t;
+
+		for (k = 0; k < qs->size / sizeof(unsigned long); k++) {
+			t = a[k];
+			a[k] = b[k];
+			b[k] = t;
+		}
+
+		return;
+	}
+
+	char *a = qs->base + i * qs->size;
+	char *b = qs->base + j * qs->size;
+	char t;
 
 	for (k = 0; k < qs->size; k++) {
 		t = a[k];
@@ -107,58 +137,226 @@ static void elem_swap(qs_spec_t *qs, size_t i, size_t j)
 	}
 }
 
-/** Partition a range of indices.
+/** Sort a range of indices by insertion sort.
  *
  * @param qs Quicksort spec
  * @param lo Lower bound (inclusive)
- * @param hi Upper bound (inclusive)
- * @return Pivot index
+ * @param hi Upper bound (exclusive)
+ * @param limit Maximum number of moves, 0 for no limit
+ * @return False if the limit was exceeded and the range is not sorted
  */
-static size_t partition(qs_spec_t *qs, size_t lo, size_t hi)
+static bool insertion_sort(qs_spec_t *qs, size_t lo, size_t hi, size_t limit)
 {
-	size_t pivot;
+	size_t moves = 0;
 	size_t i, j;
 
-	pivot = lo + (hi - lo) / 2;
-	i = lo;
-	j = hi;
+	for (i = lo + 1; i < hi; i++) {
+		for (j = i; j > lo && elem_lt(qs, j, j - 1); j--) {
+			elem_swap(qs, j, j - 1);
+			moves++;
+		}
+
+		if (limit != 0 && moves > limit)
+			return false;
+	}
+
+	return true;
+}
+
+/** Restore the heap property below one node of a heap.
+ *
+ * @param qs Quicksort spec
+ * @param lo Index of the heap root
+ * @param node Node, relative to the root
+ * @param n Number of heap elements
+ */
+static void sift_down(qs_spec_t *qs, size_t lo, size_t node, size_t n)
+{
+	size_t child;
+
+	while ((child = 2 * node + 1) < n) {
+		if (child + 1 < n && elem_lt(qs, lo + child, lo + child + 1))
+			child++;
+
+		if (!elem_lt(qs, lo + node, lo + child))
+			return;
+
+		elem_swap(qs, lo + node, lo + child);
+		node = child;
+	}
+}
+
+/** Sort a range of indices by heapsort.
+ *
+ * @param qs Quicksort spec
+ * @param lo Lower bound (inclusive)
+ * @param hi Upper bound (exclusive)
+ */
+static void heapsort(qs_spec_t *qs, size_t lo, size_t hi)
+{
+	size_t n = hi - lo;
+	size_t i;
+
+	for (i = n / 2; i-- > 0;)
+		sift_down(qs, lo, i, n);
+
+	for (i = n - 1; i > 0; i--) {
+		elem_swap(qs, lo, lo + i);
+		sift_down(qs, lo, 0, i);
+	}
+}
+
+/** Order three elements.
+ *
+ * @param qs Quicksort spec
+ * @param a First element index
+ * @param b Second element index, will hold the median
+ * @param c Third element index
+ */
+static void sort3(qs_spec_t *qs, size_t a, size_t b, size_t c)
+{
+	if (elem_lt(qs, b, a))
+		elem_swap(qs, a, b);
+	if (elem_lt(qs, c, b)) {
+		elem_swap(qs, b, c);
+		if (elem_lt(qs, b, a))
+			elem_swap(qs, a, b);
+	}
+}
+
+/** Move a pivot for a range of indices to its first element.
+ *
+ * @param qs Quicksort spec
+ * @param lo Lower bound (inclusive)
+ * @param hi Upper bound (exclusive)
+ */
+static void choose_pivot(qs_spec_t *qs, size_t lo, size_t hi)
+{
+	size_t mid = lo + (hi - lo) / 2;
+
+	if (hi - lo > NINTHER_MIN) {
+		sort3(qs, lo, mid, hi - 1);
+		sort3(qs, lo + 1, mid - 1, hi - 2);
+		sort3(qs, lo + 2, mid + 1, hi - 3);
+		sort3(qs, mid - 1, mid, mid + 1);
+	} else {
+		sort3(qs, lo, mid, hi - 1);
+	}
+
+	elem_swap(qs, lo, mid);
+}
+
+/** Partition a range of indices around its first element.
+ *
+ * Elements equal to the pivot stop the scans from both sides, so that
+ * ranges of equal elements are split in halves.
+ *
+ * @param qs Quicksort spec
+ * @param lo Lower bound (inclusive)
+ * @param hi Upper bound (exclusive)
+ * @param swapped Place to store whether any elements were swapped
+ * @return Final index of the pivot
+ */
+static size_t partition(qs_spec_t *qs, size_t lo, size_t hi, bool *swapped)
+{
+	size_t i = lo;
+	size_t j = hi;
+
+	*swapped = false;
+
 	while (true) {
-		while (elem_lt(qs, i, pivot))
-			++i;
-		while (elem_lt(qs, pivot, j))
-			--j;
+		do {
+			i++;
+		} while (i < hi && elem_lt(qs, i, lo));
+
+		do {
+			j--;
+		} while (elem_lt(qs, lo, j));
 
 		if (i >= j)
-			return j;
+			break;
 
 		elem_swap(qs, i, j);
-
-		/* Need to follow pivot movement */
-		if (i == pivot)
-			pivot = j;
-		else if (j == pivot)
-			pivot = i;
-
-		i++;
-		j--;
+		*swapped = true;
 	}
+
+	elem_swap(qs, lo, j);
+	return j;
 }
 
 /** Sort a range of indices.
  *
  * @param qs Quicksort spec
  * @param lo Lower bound (inclusive)
- * @param hi Upper bound (inclusive)
+ * @param hi Upper bound (exclusive)
+ * @param depth Number of partitionings left before falling back to heapsort
  */
-static void quicksort(qs_spec_t *qs, size_t lo, size_t hi)
+static void quicksort(qs_spec_t *qs, size_t lo, size_t hi, unsigned depth)
 {
-	size_t p;
+	while (hi - lo > INSERTION_SORT_MAX) {
+		if (depth == 0) {
+			heapsort(qs, lo, hi);
+			return;
+		}
+
+		depth--;
+
+		size_t n = hi - lo;
+		bool swapped;
+
+		choose_pivot(qs, lo, hi);
+		size_t p = partition(qs, lo, hi, &swapped);
+
+		size_t left = p - lo;
+		size_t right = hi - p - 1;
+
+		if (left < n / 8 || right < n / 8) {
+			/* Shuffle some elements to break the pattern. */
+			if (left >= INSERTION_SORT_MAX) {
+				elem_swap(qs, lo, lo + left / 4);
+				elem_swap(qs, p - 1, p - left / 4);
+			}
 
-	if (lo < hi) {
-		p = partition(qs, lo, hi);
-		quicksort(qs, lo, p);
-		quicksort(qs, p + 1, hi);
+			if (right >= INSERTION_SORT_MAX) {
+				elem_swap(qs, p + 1, p + 1 + right / 4);
+				elem_swap(qs, hi - 1, hi - right / 4);
+			}
+		} else if (!swapped) {
+			/* The range may well be sorted already. */
+			if (insertion_sort(qs, lo, p, PARTIAL_INSERTION_MAX) &&
+			    insertion_sort(qs, p + 1, hi, PARTIAL_INSERTION_MAX))
+				return;
+		}
+
+		/* Recurse into the smaller part, iterate on the larger one. */
+		if (left < right) {
+			quicksort(qs, lo, p, depth);
+			lo = p + 1;
+		} else {
+			quicksort(qs, p + 1, hi, depth);
+			hi = p;
+		}
 	}
+
+	(void) insertion_sort(qs, lo, hi, 0);
+}
+
+/** Set up a quicksort spec and sort.
+ *
+ * @param qs Quicksort spec with the array and comparison filled in
+ */
+static void qs_sort(qs_spec_t *qs)
+{
+	unsigned depth = 0;
+	size_t n;
+
+	qs->word_swap = (qs->size % sizeof(unsigned long) == 0) &&
+	    ((uintptr_t) qs->base % sizeof(unsigned long) == 0);
+
+	for (n = qs->nmemb; n > 1; n /= 2)
+		depth += 2;
+
+	quicksort(qs, 0, qs->nmemb, depth);
 }
 
 /** Quicksort.
@@ -182,7 +380,7 @@ void qsort(void *base, size_t nmemb, size_t size, int (*compar)(const void *,
 	qs.compar = compar_wrap;
 	qs.arg = compar;
 
-	quicksort(&qs, 0, nmemb - 1);
+	qs_sort(&qs);
 }
 
 /** Quicksort with extra argument to comparison function.
@@ -207,7 +405,7 @@ void qsort_r(void *base, size_t nmemb, size_t size, int (*compar)(const void *,
 	qs.compar = compar;
 	qs.arg = arg;
 
-	quicksort(&qs, 0, nmemb - 1);
+	qs_sort(&qs);
 }
 
 /** @}
@@ -33,15 +33,117 @@
  * @file
  * @brief Random number generator.
  *
- * Generate random (as opposed to pseudorandom) numbers. This should be
- * used sparingly (e.g. to seed a pseudorandom number generator).
+ * ChaCha20 keyed from the kernel entropy pool. Output is produced one
+ * 64-byte block at a time, so that filling a buffer costs a fraction of
+ * a cycle per byte and requesting a single byte does not enter the kernel.
  */
 
 #include <errno.h>
+#include <fibril.h>
+#include <libc.h>
+#include <macros.h>
+#include <mem.h>
 #include <rndgen.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
-#include <time.h>
+
+#define ROTL32(v, n)  (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define QUARTER_ROUND(x, a, b, c, d) \
+	do { \
+		x[a] += x[b]; x[d] = ROTL32(x[d] ^ x[a], 16); \
+		x[c] += x[d]; x[b] = ROTL32(x[b] ^ x[c], 12); \
+		x[a] += x[b]; x[d] = ROTL32(x[d] ^ x[a], 8); \
+		x[c] += x[d]; x[b] = ROTL32(x[b] ^ x[c], 7); \
+	} while (0)
+
+/** Generator used by rndgen_fill_local() */
+static fibril_local rndgen_t local_rndgen;
+static fibril_local bool local_rndgen_seeded;
+
+/** Produce the next ChaCha20 block.
+ *
+ * @param rndgen Random number generator
+ * @param out Destination of RNDGEN_BLOCK_SIZE bytes
+ */
+static void rndgen_block(rndgen_t *rndgen, uint8_t *out)
+{
+	uint32_t state[16] = {
+		0x61707865, 0x3320646e, 0x79622d32, 0x6b206574
+	};
+	uint32_t x[16];
+	int i;
+
+	for (i = 0; i < 8; i++)
+		state[4 + i] = rndgen->key[i];
+
+	state[12] = (uint32_t) rndgen->counter;
+	state[13] = (uint32_t) (rndgen->counter >> 32);
+	rndgen->counter++;
+
+	memcpy(x, state, sizeof(x));
+
+	for (i = 0; i < 10; i++) {
+		QUARTER_ROUND(x, 0, 4, 8, 12);
+		QUARTER_ROUND(x, 1, 5, 9, 13);
+		QUARTER_ROUND(x, 2, 6, 10, 14);
+		QUARTER_ROUND(x, 3, 7, 11, 15);
+		QUARTER_ROUND(x, 0, 5, 10, 15);
+		QUARTER_ROUND(x, 1, 6, 11, 12);
+		QUARTER_ROUND(x, 2, 7, 8, 13);
+		QUARTER_ROUND(x, 3, 4, 9, 14);
+	}
+
+	for (i = 0; i < 16; i++) {
+		uint32_t w = x[i] + state[i];
+
+		out[4 * i] = w & 0xff;
+		out[4 * i + 1] = (w >> 8) & 0xff;
+		out[4 * i + 2] = (w >> 16) & 0xff;
+		out[4 * i + 3] = (w >> 24) & 0xff;
+	}
+}
+
+/** Key random number generator.
+ *
+ * @param rndgen Random number generator
+ * @param seed RNDGEN_SEED_SIZE bytes of key material
+ */
+static void rndgen_key(rndgen_t *rndgen, const uint8_t *seed)
+{
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		rndgen->key[i] = (uint32_t) seed[4 * i] |
+		    ((uint32_t) seed[4 * i + 1] << 8) |
+		    ((uint32_t) seed[4 * i + 2] << 16) |
+		    ((uint32_t) seed[4 * i + 3] << 24);
+	}
+
+	rndgen->counter = 0;
+	rndgen->avail = 0;
+}
+
+/** Key random number generator from the kernel entropy pool.
+ *
+ * @param rndgen Random number generator
+ * @return EOK on success or error code
+ */
+static errno_t rndgen_seed(rndgen_t *rndgen)
+{
+	uint8_t seed[RNDGEN_SEED_SIZE];
+	errno_t rc;
+
+	rc = (errno_t) __SYSCALL2(SYS_ENTROPY_GET, (sysarg_t) seed,
+	    sizeof(seed));
+	if (rc != EOK)
+		return rc;
+
+	rndgen_key(rndgen, seed);
+	memset(seed, 0, sizeof(seed));
+	return EOK;
+}
 
 /** Create random number generator.
  *
@@ -51,15 +153,40 @@
 errno_t rndgen_create(rndgen_t **rrndgen)
 {
 	rndgen_t *rndgen;
-	struct timespec ts;
+	errno_t rc;
+
+	rndgen = calloc(1, sizeof(rndgen_t));
+	if (rndgen == NULL)
+		return ENOMEM;
+
+	rc = rndgen_seed(rndgen);
+	if (rc != EOK) {
+		free(rndgen);
+		return rc;
+	}
+
+	*rrndgen = rndgen;
+	return EOK;
+}
+
+/** Create random number generator with a fixed seed.
+ *
+ * The generator produces the same sequence for the same seed. This is
+ * meant for tests and simulations that need to be reproducible.
+ *
+ * @param rrndgen Place to store new random number generator
+ * @param seed RNDGEN_SEED_SIZE bytes of seed
+ * @return EOK on success or error code
+ */
+errno_t rndgen_create_seeded(rndgen_t **rrndgen, const uint8_t *seed)
+{
+	rndgen_t *rndgen;
 
 	rndgen = calloc(1, sizeof(rndgen_t));
 	if (rndgen == NULL)
 		return ENOMEM;
 
-	/* XXX This is a rather poor way of generating random numbers */
-	getuptime(&ts);
-	rndgen->seed = ts.tv_sec ^ ts.tv_nsec;
+	rndgen_key(rndgen, seed);
 
 	*rrndgen = rndgen;
 	return EOK;
@@ -74,9 +201,70 @@ void rndgen_destroy(rndgen_t *rndgen)
 	if (rndgen == NULL)
 		return;
 
+	memset(rndgen, 0, sizeof(rndgen_t));
 	free(rndgen);
 }
 
+/** Fill buffer with random bytes.
+ *
+ * Whole blocks are generated directly into the destination buffer.
+ *
+ * @param rndgen Random number generator
+ * @param buf Destination buffer
+ * @param size Number of bytes to generate
+ * @return EOK on success or error code
+ */
+errno_t rndgen_fill(rndgen_t *rndgen, void *buf, size_t size)
+{
+	uint8_t *dst = (uint8_t *) buf;
+	size_t len;
+
+	/* Use up buffered output first */
+	len = min(size, rndgen->avail);
+	memcpy(dst, rndgen->buf + RNDGEN_BLOCK_SIZE - rndgen->avail, len);
+	rndgen->avail -= len;
+	dst += len;
+	size -= len;
+
+	while (size >= RNDGEN_BLOCK_SIZE) {
+		rndgen_block(rndgen, dst);
+		dst += RNDGEN_BLOCK_SIZE;
+		size -= RNDGEN_BLOCK_SIZE;
+	}
+
+	if (size > 0) {
+		rndgen_block(rndgen, rndgen->buf);
+		memcpy(dst, rndgen->buf, size);
+		rndgen->avail = RNDGEN_BLOCK_SIZE - size;
+	}
+
+	return EOK;
+}
+
+/** Fill buffer with random bytes from the fibril's own generator.
+ *
+ * The generator is created and keyed from the kernel entropy pool on
+ * first use, so callers do not need to keep a generator around.
+ *
+ * @param buf Destination buffer
+ * @param size Number of bytes to generate
+ * @return EOK on success or error code
+ */
+errno_t rndgen_fill_local(void *buf, size_t size)
+{
+	errno_t rc;
+
+	if (!local_rndgen_seeded) {
+		rc = rndgen_seed(&local_rndgen);
+		if (rc != EOK)
+			return rc;
+
+		local_rndgen_seeded = true;
+	}
+
+	return rndgen_fill(&local_rndgen, buf, size);
+}
+
 /** Generate random 8-bit integer.
  *
  * @param rndgen Random number generator
@@ -85,10 +273,7 @@ void rndgen_destroy(rndgen_t *rndgen)
  */
 errno_t rndgen_uint8(rndgen_t *rndgen, uint8_t *rb)
 {
-	rndgen->seed = (1366 * rndgen->seed + 150889) % 714025;
-
-	*rb = rndgen->seed & 0xff;
-	return EOK;
+	return rndgen_fill(rndgen, rb, sizeof(uint8_t));
 }
 
 /** Generate random 32-bit integer.
@@ -99,21 +284,15 @@ errno_t rndgen_uint8(rndgen_t *rndgen, uint8_t *rb)
  */
 errno_t rndgen_uint32(rndgen_t *rndgen, uint32_t *rw)
 {
-	int i;
-	uint8_t b;
-	uint32_t w;
+	uint8_t b[4];
 	errno_t rc;
 
-	w = 0;
-	for (i = 0; i < 4; i++) {
-		rc = rndgen_uint8(rndgen, &b);
-		if (rc != EOK)
-			return rc;
-
-		w = (w << 8) | b;
-	}
+	rc = rndgen_fill(rndgen, b, sizeof(b));
+	if (rc != EOK)
+		return rc;
 
-	*rw = w;
+	*rw = (uint32_t) b[0] | ((uint32_t) b[1] << 8) |
+	    ((uint32_t) b[2] << 16) | ((uint32_t) b[3] << 24);
 	return EOK;
 }
 
@@ -100,9 +100,11 @@ errno_t module_create_static_exec(rtld_t *rtld, module_t **rmodule)
 	return EOK;
 }
 
-/** (Eagerly) process all relocation tables in a module.
+/** Process all relocation tables in a module.
  *
- * Currently works as if LD_BIND_NOW was specified.
+ * Unless the module asks for immediate binding, PLT entries are set up
+ * to be resolved on first use if the architecture supports it. Otherwise
+ * all relocations are processed eagerly.
  */
 void module_process_relocs(module_t *m)
 {
@@ -115,7 +117,10 @@ void module_process_relocs(module_t *m)
 	module_process_pre_arch(m);
 
 	/* jmp_rel table */
-	if (m->dyn.jmp_rel != NULL) {
+	if (m->dyn.jmp_rel != NULL && !m->dyn.bind_now &&
+	    module_plt_lazy_arch(m)) {
+		DPRINTF("jmp_rel table bound lazily\n");
+	} else if (m->dyn.jmp_rel != NULL) {
 		DPRINTF("jmp_rel table\n");
 		if (m->dyn.plt_rel == DT_REL) {
 			DPRINTF("jmp_rel table type DT_REL\n");
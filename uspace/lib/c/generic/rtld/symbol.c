@@ -34,6 +34,7 @@
  * @file
  */
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
@@ -44,6 +45,16 @@
 #include <rtld/rtld_debug.h>
 #include <rtld/symbol.h>
 
+/** Symbol name along with its hashes, computed once per search. */
+typedef struct {
+	const char *name;
+	/** GNU hash of the name */
+	elf_word gnu_hash;
+	/** SysV hash of the name, valid if @c has_sysv_hash is true */
+	elf_word sysv_hash;
+	bool has_sysv_hash;
+} symbol_key_t;
+
 /*
  * Hash tables are 32-bit (elf_word) even for 64-bit ELF files.
  */
@@ -62,38 +73,124 @@ static elf_word elf_hash(const unsigned char *name)
 	return h;
 }
 
-static elf_symbol_t *def_find_in_module(const char *name, module_t *m)
+/** Compute the hash function used by DT_GNU_HASH tables. */
+static elf_word elf_gnu_hash(const unsigned char *name)
+{
+	elf_word h = 5381;
+
+	while (*name)
+		h = (h << 5) + h + *name++;
+
+	return h;
+}
+
+static void symbol_key_init(symbol_key_t *key, const char *name)
+{
+	key->name = name;
+	key->gnu_hash = elf_gnu_hash((const unsigned char *) name);
+	key->has_sysv_hash = false;
+}
+
+/** Look up a symbol using the module's SysV hash table. */
+static elf_symbol_t *def_find_sysv(symbol_key_t *key, module_t *m)
 {
 	elf_symbol_t *sym_table;
-	elf_symbol_t *s, *sym;
+	elf_symbol_t *s;
 	elf_word nbucket;
 	/* elf_word nchain; */
 	elf_word i;
 	char *s_name;
 	elf_word bucket;
 
-	DPRINTF("def_find_in_module('%s', %s)\n", name, m->dyn.soname);
+	if (!key->has_sysv_hash) {
+		key->sysv_hash = elf_hash((const unsigned char *) key->name);
+		key->has_sysv_hash = true;
+	}
 
 	sym_table = m->dyn.sym_tab;
 	nbucket = m->dyn.hash[0];
 	/* nchain = m->dyn.hash[1]; XXX Use to check HT range */
 
-	bucket = elf_hash((unsigned char *)name) % nbucket;
+	bucket = key->sysv_hash % nbucket;
 	i = m->dyn.hash[2 + bucket];
 
-	sym = NULL;
 	while (i != STN_UNDEF) {
 		s = &sym_table[i];
 		s_name = m->dyn.str_tab + s->st_name;
 
-		if (str_cmp(name, s_name) == 0) {
-			sym = s;
-			break;
-		}
+		if (str_cmp(key->name, s_name) == 0)
+			return s;
 
 		i = m->dyn.hash[2 + nbucket + i];
 	}
 
+	return NULL;
+}
+
+/** Look up a symbol using the module's GNU hash table.
+ *
+ * The table starts with a Bloom filter which allows rejecting most
+ * symbols not defined in the module without touching the buckets,
+ * the chains or the string table. Chains hold the symbol hashes with
+ * the lowest bit marking the end of a chain, so only symbols with
+ * a matching hash need to have their names compared.
+ */
+static elf_symbol_t *def_find_gnu(symbol_key_t *key, module_t *m)
+{
+	const elf_word *table = m->dyn.gnu_hash;
+	elf_word nbuckets = table[0];
+	elf_word symoffset = table[1];
+	elf_word bloom_size = table[2];
+	elf_word bloom_shift = table[3];
+	const uintptr_t *bloom = (const uintptr_t *) &table[4];
+	const elf_word *buckets = (const elf_word *) &bloom[bloom_size];
+	const elf_word *chain = &buckets[nbuckets];
+	const unsigned bits = sizeof(uintptr_t) * 8;
+	elf_symbol_t *sym_table = m->dyn.sym_tab;
+	elf_word h = key->gnu_hash;
+	uintptr_t word;
+	uintptr_t mask;
+	elf_word i;
+
+	word = bloom[(h / bits) % bloom_size];
+	mask = ((uintptr_t) 1 << (h % bits)) |
+	    ((uintptr_t) 1 << ((h >> bloom_shift) % bits));
+	if ((word & mask) != mask)
+		return NULL;
+
+	i = buckets[h % nbuckets];
+	if (i < symoffset)
+		return NULL;
+
+	while (true) {
+		elf_word ch = chain[i - symoffset];
+
+		if ((h | 1) == (ch | 1) && str_cmp(key->name,
+		    m->dyn.str_tab + sym_table[i].st_name) == 0)
+			return &sym_table[i];
+
+		/* Lowest bit set marks the end of the chain */
+		if ((ch & 1) != 0)
+			break;
+		++i;
+	}
+
+	return NULL;
+}
+
+static elf_symbol_t *def_find_in_module(symbol_key_t *key, module_t *m)
+{
+	elf_symbol_t *sym;
+
+	DPRINTF("def_find_in_module('%s', %s)\n", key->name, m->dyn.soname);
+
+	if (m->dyn.gnu_hash != NULL)
+		sym = def_find_gnu(key, m);
+	else if (m->dyn.hash != NULL)
+		sym = def_find_sysv(key, m);
+	else
+		sym = NULL;
+
 	if (!sym)
 		return NULL;	/* Not found */
 
@@ -121,6 +218,7 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 {
 	module_t *m, *dm;
 	elf_symbol_t *sym, *s;
+	symbol_key_t key;
 	list_t queue;
 	size_t i;
 
@@ -141,6 +239,7 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 
 	/* If the symbol is found, it will be stored in 'sym' */
 	sym = NULL;
+	symbol_key_init(&key, name);
 
 	/* While queue is not empty */
 	while (!list_empty(&queue)) {
@@ -149,7 +248,7 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 		list_remove(&m->queue_link);
 
 		/* If ssf_noroot is specified, do not look in start module */
-		s = def_find_in_module(name, m);
+		s = def_find_in_module(&key, m);
 		if (s != NULL) {
 			/* Symbol found */
 			sym = s;
@@ -182,33 +281,29 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 	return sym; /* Symbol found */
 }
 
-/** Find the definition of a symbol.
- *
- * By definition in System V ABI, if module origin has the flag DT_SYMBOLIC,
- * origin is searched first. Otherwise, search global modules in the default
- * order.
+/** Search for the definition of a symbol.
  *
- * @param name		Name of the symbol to search for.
+ * @param key		Name of the symbol to search for with its hashes.
  * @param origin	Module in which the dependency originates.
- * @param flags		@c ssf_none or @c ssf_noexec to not look for the symbol
- *			in the executable program.
+ * @param flags		Search flags.
  * @param mod		(output) Will be filled with a pointer to the module
  *			that contains the symbol.
  */
-elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
+static elf_symbol_t *symbol_def_search(symbol_key_t *key, module_t *origin,
     symbol_search_flags_t flags, module_t **mod)
 {
 	elf_symbol_t *s;
 
 	DPRINTF("symbol_def_find('%s', origin='%s'\n",
-	    name, origin->dyn.soname);
+	    key->name, origin->dyn.soname);
 	if (origin->dyn.symbolic && (!origin->exec || (flags & ssf_noexec) == 0)) {
-		DPRINTF("symbolic->find '%s' in module '%s'\n", name, origin->dyn.soname);
+		DPRINTF("symbolic->find '%s' in module '%s'\n", key->name,
+		    origin->dyn.soname);
 		/*
 		 * Origin module has a DT_SYMBOLIC flag.
 		 * Try this module first
 		 */
-		s = def_find_in_module(name, origin);
+		s = def_find_in_module(key, origin);
 		if (s != NULL) {
 			/* Found */
 			*mod = origin;
@@ -221,8 +316,9 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
 	list_foreach(origin->rtld->modules, modules_link, module_t, m) {
 		DPRINTF("module '%s' local?\n", m->dyn.soname);
 		if (!m->local && (!m->exec || (flags & ssf_noexec) == 0)) {
-			DPRINTF("!local->find '%s' in module '%s'\n", name, m->dyn.soname);
-			s = def_find_in_module(name, m);
+			DPRINTF("!local->find '%s' in module '%s'\n", key->name,
+			    m->dyn.soname);
+			s = def_find_in_module(key, m);
 			if (s != NULL) {
 				/* Found */
 				*mod = m;
@@ -233,11 +329,11 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
 
 	/* Finally, try origin. */
 
-	DPRINTF("try finding '%s' in origin '%s'\n", name,
+	DPRINTF("try finding '%s' in origin '%s'\n", key->name,
 	    origin->dyn.soname);
 
 	if (!origin->exec || (flags & ssf_noexec) == 0) {
-		s = def_find_in_module(name, origin);
+		s = def_find_in_module(key, origin);
 		if (s != NULL) {
 			/* Found */
 			*mod = origin;
@@ -245,10 +341,64 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
 		}
 	}
 
-	DPRINTF("'%s' not found\n", name);
+	DPRINTF("'%s' not found\n", key->name);
 	return NULL;
 }
 
+/** Find the definition of a symbol.
+ *
+ * By definition in System V ABI, if module origin has the flag DT_SYMBOLIC,
+ * origin is searched first. Otherwise, search global modules in the default
+ * order.
+ *
+ * Unless @c ssf_nocache is specified, results are remembered in a cache
+ * of the runtime environment. Only lookups originating in global modules
+ * without DT_SYMBOLIC are cached since the result of those does not depend
+ * on the origin. Modules are only ever appended to the global search order,
+ * therefore a definition once found stays valid.
+ *
+ * @param name		Name of the symbol to search for.
+ * @param origin	Module in which the dependency originates.
+ * @param flags		@c ssf_none or @c ssf_noexec to not look for the symbol
+ *			in the executable program, @c ssf_nocache to bypass
+ *			the symbol cache.
+ * @param mod		(output) Will be filled with a pointer to the module
+ *			that contains the symbol.
+ */
+elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
+    symbol_search_flags_t flags, module_t **mod)
+{
+	rtld_symcache_entry_t *ce;
+	symbol_key_t key;
+	elf_symbol_t *s;
+	unsigned cflags;
+
+	symbol_key_init(&key, name);
+
+	if ((flags & ssf_nocache) != 0 || origin->local ||
+	    origin->dyn.symbolic)
+		return symbol_def_search(&key, origin, flags, mod);
+
+	cflags = flags & ssf_noexec;
+	ce = &origin->rtld->symcache[key.gnu_hash % RTLD_SYMCACHE_SIZE];
+	if (ce->sym != NULL && ce->hash == key.gnu_hash &&
+	    ce->flags == cflags && str_cmp(ce->name, name) == 0) {
+		*mod = ce->mod;
+		return ce->sym;
+	}
+
+	s = symbol_def_search(&key, origin, flags, mod);
+	if (s != NULL) {
+		ce->name = (*mod)->dyn.str_tab + s->st_name;
+		ce->hash = key.gnu_hash;
+		ce->flags = cflags;
+		ce->sym = s;
+		ce->mod = *mod;
+	}
+
+	return s;
+}
+
 /** Get symbol address.
  *
  * @param sym Symbol
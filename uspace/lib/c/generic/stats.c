@@ -35,6 +35,8 @@
 
 #include <stats.h>
 #include <sysinfo.h>
+#include <as.h>
+#include <ddi.h>
 #include <errno.h>
 #include <stdio.h>
 #include <inttypes.h>
@@ -42,6 +44,12 @@
 
 #define SYSINFO_STATS_MAX_PATH  64
 
+/** Number of attempts to get a complete thread statistics delta */
+#define STATS_DELTA_ATTEMPTS  4
+
+/** Mapped statistics page */
+static const stats_page_t *stats_page = NULL;
+
 /** Thread states
  *
  */
@@ -157,6 +165,37 @@ stats_task_t *stats_get_task(task_id_t task_id)
 	return stats_task;
 }
 
+/** Get IPC and syscall profile of a single task
+ *
+ * The profile is only available if the kernel was
+ * configured with CONFIG_IPC_PROFILE.
+ *
+ * @param task_id Task ID we are interested in.
+ *
+ * @return Pointer to the stats_task_ipc_t structure.
+ *         If non-NULL then it should be eventually freed
+ *         by free().
+ *
+ */
+stats_task_ipc_t *stats_get_task_ipc(task_id_t task_id)
+{
+	char name[SYSINFO_STATS_MAX_PATH];
+	snprintf(name, SYSINFO_STATS_MAX_PATH, "system.tasks.%" PRIu64 ".ipc",
+	    task_id);
+
+	size_t size = 0;
+	stats_task_ipc_t *stats_ipc =
+	    (stats_task_ipc_t *) sysinfo_get_data(name, &size);
+
+	if (size != sizeof(stats_task_ipc_t)) {
+		if (stats_ipc != NULL)
+			free(stats_ipc);
+		return NULL;
+	}
+
+	return stats_ipc;
+}
+
 /** Get thread statistics.
  *
  * @param count Number of records returned.
@@ -183,6 +222,77 @@ stats_thread_t *stats_get_threads(size_t *count)
 	return stats_threads;
 }
 
+/** Get statistics of threads which changed since a generation.
+ *
+ * Pass zero as @a since to get all threads. The returned header
+ * contains the generation to pass next time. If the header's @c full
+ * flag is set, all threads are included (some threads exited since
+ * @a since) and the caller should replace its set of threads.
+ *
+ * @param since Generation returned by the previous query or zero.
+ *
+ * @return Delta header followed by stats_thread_t structures
+ *         (see stats_delta_threads()). If non-NULL then it should
+ *         be eventually freed by free().
+ *
+ */
+stats_delta_t *stats_get_threads_delta(uint64_t since)
+{
+	char name[SYSINFO_STATS_MAX_PATH];
+	snprintf(name, SYSINFO_STATS_MAX_PATH, "system.threads_delta.%" PRIu64,
+	    since);
+
+	/*
+	 * Threads created between getting the size and the data might
+	 * not fit. Repeating the query with the same generation is fine,
+	 * it returns a superset of the previous result.
+	 */
+	for (unsigned int i = 0; i < STATS_DELTA_ATTEMPTS; i++) {
+		size_t size = 0;
+		stats_delta_t *delta =
+		    (stats_delta_t *) sysinfo_get_data(name, &size);
+		if (delta == NULL)
+			return NULL;
+
+		if ((size >= sizeof(stats_delta_t)) &&
+		    (size == sizeof(stats_delta_t) +
+		    delta->count * sizeof(stats_thread_t)))
+			return delta;
+
+		free(delta);
+	}
+
+	return NULL;
+}
+
+/** Get the read-only statistics page.
+ *
+ * The page is mapped on the first call. Its values change
+ * asynchronously.
+ *
+ * @return Statistics page or NULL if it is not available.
+ *
+ */
+const stats_page_t *stats_get_page(void)
+{
+	if (stats_page == NULL) {
+		uintptr_t faddr;
+		errno_t rc = sysinfo_get_value("system.stats.faddr", &faddr);
+		if (rc != EOK)
+			return NULL;
+
+		void *addr = AS_AREA_ANY;
+		rc = physmem_map(faddr, 1, AS_AREA_READ | AS_AREA_CACHEABLE,
+		    &addr);
+		if (rc != EOK)
+			return NULL;
+
+		stats_page = addr;
+	}
+
+	return stats_page;
+}
+
 /** Get IPC connections statistics.
  *
  * @param count Number of records returned.
@@ -209,6 +319,32 @@ stats_ipcc_t *stats_get_ipccs(size_t *count)
 	return stats_ipccs;
 }
 
+/** Get IRQ statistics.
+ *
+ * @param count Number of records returned.
+ *
+ * @return Array of stats_irq_t structures.
+ *         If non-NULL then it should be eventually freed
+ *         by free().
+ *
+ */
+stats_irq_t *stats_get_irqs(size_t *count)
+{
+	size_t size = 0;
+	stats_irq_t *stats_irqs =
+	    (stats_irq_t *) sysinfo_get_data("system.irqs", &size);
+
+	if ((size % sizeof(stats_irq_t)) != 0) {
+		if (stats_irqs != NULL)
+			free(stats_irqs);
+		*count = 0;
+		return NULL;
+	}
+
+	*count = size / sizeof(stats_irq_t);
+	return stats_irqs;
+}
+
 /** Get exception statistics.
  *
  * @param count Number of records returned.
@@ -262,6 +398,60 @@ stats_exc_t *stats_get_exception(unsigned int excn)
 	return stats_exception;
 }
 
+/** Get slab cache statistics
+ *
+ * @param count Number of records returned.
+ *
+ * @return Array of stats_slab_t structures.
+ *         If non-NULL then it should be eventually freed
+ *         by free().
+ *
+ */
+stats_slab_t *stats_get_slabs(size_t *count)
+{
+	size_t size = 0;
+	stats_slab_t *stats_slabs =
+	    (stats_slab_t *) sysinfo_get_data("system.slabs", &size);
+
+	if ((size % sizeof(stats_slab_t)) != 0) {
+		if (stats_slabs != NULL)
+			free(stats_slabs);
+		*count = 0;
+		return NULL;
+	}
+
+	*count = size / sizeof(stats_slab_t);
+	return stats_slabs;
+}
+
+/** Get lock contention statistics
+ *
+ * Only available if the kernel was built with lock statistics.
+ *
+ * @param count Number of records returned.
+ *
+ * @return Array of stats_lock_t structures.
+ *         If non-NULL then it should be eventually freed
+ *         by free().
+ *
+ */
+stats_lock_t *stats_get_locks(size_t *count)
+{
+	size_t size = 0;
+	stats_lock_t *stats_locks =
+	    (stats_lock_t *) sysinfo_get_data("system.locks", &size);
+
+	if ((size % sizeof(stats_lock_t)) != 0) {
+		if (stats_locks != NULL)
+			free(stats_locks);
+		*count = 0;
+		return NULL;
+	}
+
+	*count = size / sizeof(stats_lock_t);
+	return stats_locks;
+}
+
 /** Get system load
  *
  * @param count Number of load records returned.
@@ -38,6 +38,7 @@
 #include <_bits/ssize_t.h>
 #include <ctype.h>
 #include <errno.h>
+#include <float.h>
 #include <limits.h>
 #include <stdarg.h>
 #include <stdbool.h>
@@ -46,6 +47,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "../private/dec_to_double.h"
 #include "../private/scanf.h"
 
 typedef enum {
@@ -133,6 +135,21 @@ typedef struct {
 	va_list ap;
 } va_encaps_t;
 
+/** Maximum number of decimal digits kept in dec_sig_t */
+#define DEC_SIG_DIGITS  19
+
+/** Leading significant digits of a decimal number being parsed */
+typedef struct {
+	/** Up to DEC_SIG_DIGITS significant digits */
+	uint64_t w;
+	/** Number of digits in w */
+	int cnt;
+	/** Decimal exponent of w */
+	int exp;
+	/** Non-zero digits were dropped after w */
+	bool truncated;
+} dec_sig_t;
+
 static int digit_value(char digit)
 {
 	switch (digit) {
@@ -656,15 +673,43 @@ static errno_t __fstrtoumax(FILE *f, int *numchar, int base, size_t width,
 	return EOK;
 }
 
+/** Add decimal digit to significand.
+ *
+ * @param sig Significand
+ * @param digit Digit value
+ * @param frac @c true if the digit follows the decimal point
+ */
+static void dec_sig_add(dec_sig_t *sig, int digit, bool frac)
+{
+	if (sig->cnt < DEC_SIG_DIGITS) {
+		/* Leading zeros are not significant */
+		if (sig->cnt > 0 || digit != 0) {
+			sig->w = sig->w * 10 + digit;
+			++sig->cnt;
+		}
+
+		if (frac)
+			--sig->exp;
+	} else {
+		if (digit != 0)
+			sig->truncated = true;
+
+		if (!frac)
+			++sig->exp;
+	}
+}
+
 /** Read long double from file.
  *
  * @param f Input file
  * @param numchar Pointer to counter of characters read
  * @param width Maximum field with in characters
+ * @param narrow The caller converts the result to double or float, so a
+ *               correctly rounded double is precise enough
  * @param dest Place to store result
  * @return EOK on success, EIO on I/O error, EINVAL if input is not valid
  */
-errno_t __fstrtold(FILE *f, int *numchar, size_t width,
+errno_t __fstrtold(FILE *f, int *numchar, size_t width, bool narrow,
     long double *dest)
 {
 	errno_t rc;
@@ -678,6 +723,8 @@ errno_t __fstrtold(FILE *f, int *numchar, size_t width,
 	int eadj;
 	int exp;
 	int expsign;
+	dec_sig_t sig;
+	double d;
 
 	rc = vfscanf_skip_ws(f, numchar);
 	if (rc == EIO)
@@ -744,12 +791,20 @@ errno_t __fstrtold(FILE *f, int *numchar, size_t width,
 
 	/* Value */
 	v = 0;
+	sig.w = 0;
+	sig.cnt = 0;
+	sig.exp = 0;
+	sig.truncated = false;
+
 	do {
 		digit = digit_value(c);
 		if (digit >= base)
 			break;
 
 		v = v * base + digit;
+		if (base == 10)
+			dec_sig_add(&sig, digit, false);
+
 		c = __fgetc(f, numchar);
 		--width;
 	} while (width > 0 && isxdigit(c));
@@ -771,6 +826,9 @@ errno_t __fstrtold(FILE *f, int *numchar, size_t width,
 				break;
 
 			v = v * base + digit;
+			if (base == 10)
+				dec_sig_add(&sig, digit, true);
+
 			c = __fgetc(f, numchar);
 			--width;
 			eadj -= eadd;
@@ -818,6 +876,21 @@ errno_t __fstrtold(FILE *f, int *numchar, size_t width,
 		exp = exp * expsign;
 	}
 
+	/*
+	 * Decimal numbers are usually converted exactly from their leading
+	 * digits. Otherwise fall back to scaling v one digit at a time. The
+	 * exact conversion yields a double, so it is only used when that does
+	 * not lose the extra precision of long double.
+	 */
+	if ((narrow || LDBL_MANT_DIG == DBL_MANT_DIG) && base == 10 &&
+	    dec_to_double(sig.w, sig.exp + exp, sig.truncated, &d)) {
+		if (c != EOF)
+			__ungetc(c, f, numchar);
+
+		*dest = sign * (long double) d;
+		return EOK;
+	}
+
 	exp += eadj;
 
 	/* Adjust v for value of exponent */
@@ -1094,7 +1167,8 @@ static errno_t vfscanf_cvt(FILE *f, const char **fmt, va_encaps_t *va,
 		break;
 	case cs_float:
 		/* Floating-point value */
-		rc = __fstrtold(f, numchar, width, &fval);
+		rc = __fstrtold(f, numchar, width, cvtspec.lenmod != lm_L,
+		    &fval);
 		if (rc != EOK)
 			return rc;
 		break;
@@ -51,10 +51,14 @@ static FIBRIL_MUTEX_INITIALIZE(exit_handlers_lock);
 static LIST_INITIALIZE(quick_exit_handlers);
 static FIBRIL_MUTEX_INITIALIZE(quick_exit_handlers_lock);
 
-/** Convert string to long double.
+/** Convert string to a floating-point number.
  *
+ * @param nptr String to convert
+ * @param endptr Place to store pointer past the converted part or @c NULL
+ * @param narrow The result will be converted to double or float
+ * @return Converted value
  */
-long double strtold(const char *nptr, char **endptr)
+static long double strtofp(const char *nptr, char **endptr, bool narrow)
 {
 	int numchar;
 	long double ld;
@@ -64,7 +68,7 @@ long double strtold(const char *nptr, char **endptr)
 	numchar = 0;
 	__sstream_init(nptr, &f);
 
-	rc = __fstrtold(&f, &numchar, SIZE_MAX, &ld);
+	rc = __fstrtold(&f, &numchar, SIZE_MAX, narrow, &ld);
 	if (rc != EOK) {
 		ld = 0;
 		if (endptr != NULL)
@@ -78,6 +82,24 @@ long double strtold(const char *nptr, char **endptr)
 	return ld;
 }
 
+/** Convert string to float. */
+float strtof(const char *restrict nptr, char **restrict endptr)
+{
+	return (float) strtofp(nptr, endptr, true);
+}
+
+/** Convert string to double. */
+double strtod(const char *restrict nptr, char **restrict endptr)
+{
+	return (double) strtofp(nptr, endptr, true);
+}
+
+/** Convert string to long double. */
+long double strtold(const char *nptr, char **endptr)
+{
+	return strtofp(nptr, endptr, false);
+}
+
 int rand(void)
 {
 	return glbl_seed = ((1366 * glbl_seed + 150889) % RAND_MAX);
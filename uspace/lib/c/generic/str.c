@@ -117,6 +117,7 @@
 
 #include <align.h>
 #include <mem.h>
+#include <str_search.h>
 
 /** Byte mask consisting of lowest @n bits (out of 8) */
 #define LO_MASK_8(n)  ((uint8_t) ((1 << (n)) - 1))
@@ -130,6 +131,64 @@
 /** Number of data bits in a UTF-8 continuation byte */
 #define CONT_BITS  6
 
+/** Word with all bytes set to one */
+#define WORD_ONES  (((unsigned long) -1) / 0xff)
+
+/** Word with the highest bit of each byte set */
+#define WORD_HIGHS  (WORD_ONES << 7)
+
+/** Non-zero iff some byte of the word is zero */
+#define WORD_HAS_ZERO(w)  (((w) - WORD_ONES) & ~(w) & WORD_HIGHS)
+
+/** Check whether a string offset is word-aligned. */
+static inline bool word_aligned(const char *str, size_t offset)
+{
+	uintptr_t addr = (uintptr_t) (str + offset);
+
+	return (addr & (sizeof(unsigned long) - 1)) == 0;
+}
+
+/** Get the number of plain ASCII characters at the start of a string.
+ *
+ * Plain ASCII is one byte per character anywhere in UTF-8, so it can be
+ * skipped a word at a time. Aligned words never cross into the next page,
+ * so reading past the terminator within a word is safe.
+ *
+ * @param str    String.
+ * @param offset Byte offset where to start.
+ * @param size   Size of the string (in bytes).
+ *
+ * @return Number of non-zero ASCII bytes from @a offset.
+ */
+static size_t ascii_span(const char *str, size_t offset, size_t size)
+{
+	size_t start = offset;
+	unsigned long w;
+
+	while (offset < size && !word_aligned(str, offset)) {
+		uint8_t b = (uint8_t) str[offset];
+		if (b == 0 || (b & 0x80) != 0)
+			return offset - start;
+		offset++;
+	}
+
+	while (size - offset >= sizeof(unsigned long)) {
+		w = *(const unsigned long *) (str + offset);
+		if ((w & WORD_HIGHS) != 0 || WORD_HAS_ZERO(w) != 0)
+			break;
+		offset += sizeof(unsigned long);
+	}
+
+	while (offset < size) {
+		uint8_t b = (uint8_t) str[offset];
+		if (b == 0 || (b & 0x80) != 0)
+			break;
+		offset++;
+	}
+
+	return offset - start;
+}
+
 /** Decode a single character from a string.
  *
  * Decode a single character from a string of size @a size. Decoding starts
@@ -153,16 +212,16 @@ char32_t str_decode(const char *str, size_t *offset, size_t size)
 	/* First byte read from string */
 	uint8_t b0 = (uint8_t) str[(*offset)++];
 
+	/* Plain ASCII is by far the most common */
+	if ((b0 & 0x80) == 0)
+		return b0;
+
 	/* Determine code length */
 
 	unsigned int b0_bits;  /* Data bits in first byte */
 	unsigned int cbytes;   /* Number of continuation bytes */
 
-	if ((b0 & 0x80) == 0) {
-		/* 0xxxxxxx (Plain ASCII) */
-		b0_bits = 7;
-		cbytes = 0;
-	} else if ((b0 & 0xe0) == 0xc0) {
+	if ((b0 & 0xe0) == 0xc0) {
 		/* 110xxxxx 10xxxxxx */
 		b0_bits = 5;
 		cbytes = 1;
@@ -200,6 +259,49 @@ char32_t str_decode(const char *str, size_t *offset, size_t size)
 	return ch;
 }
 
+/** Decode characters from a string into an array.
+ *
+ * Decode up to @a count characters into @a buf, exactly as repeated calls
+ * to str_decode() would, including null characters, which are decoded as
+ * zero. Runs of plain ASCII are converted a word at a time.
+ *
+ * @param str    String (not necessarily NULL-terminated).
+ * @param offset Byte offset in string where to start decoding. It is moved
+ *               past the decoded characters.
+ * @param size   Size of the string (in bytes).
+ * @param buf    Output array.
+ * @param count  Maximum number of characters to decode.
+ *
+ * @return Number of decoded characters, less than @a count only if the
+ *         end of the string was reached.
+ */
+size_t str_decode_buf(const char *str, size_t *offset, size_t size,
+    char32_t *buf, size_t count)
+{
+	size_t off = *offset;
+	size_t n = 0;
+	unsigned long w;
+	size_t i;
+
+	while (n < count && off < size) {
+		if (word_aligned(str, off) &&
+		    count - n >= sizeof(unsigned long) &&
+		    size - off >= sizeof(unsigned long)) {
+			w = *(const unsigned long *) (str + off);
+			if ((w & WORD_HIGHS) == 0) {
+				for (i = 0; i < sizeof(unsigned long); i++)
+					buf[n++] = (uint8_t) str[off++];
+				continue;
+			}
+		}
+
+		buf[n++] = str_decode(str, &off, size);
+	}
+
+	*offset = off;
+	return n;
+}
+
 /** Decode a single character from a string to the left.
  *
  * Decode a single character from a string of size @a size. Decoding starts
@@ -326,12 +428,27 @@ errno_t chr_encode(const char32_t ch, char *str, size_t *offset, size_t size)
  */
 size_t str_size(const char *str)
 {
-	size_t size = 0;
+	const char *p = str;
+	unsigned long w;
 
-	while (*str++ != 0)
-		size++;
+	while (!word_aligned(p, 0)) {
+		if (*p == 0)
+			return p - str;
+		p++;
+	}
 
-	return size;
+	/* Aligned words never cross into the next page. */
+	while (true) {
+		w = *(const unsigned long *) p;
+		if (WORD_HAS_ZERO(w) != 0)
+			break;
+		p += sizeof(unsigned long);
+	}
+
+	while (*p != 0)
+		p++;
+
+	return p - str;
 }
 
 /** Get size of wide string.
@@ -443,9 +560,17 @@ size_t str_length(const char *str)
 {
 	size_t len = 0;
 	size_t offset = 0;
+	size_t n;
 
-	while (str_decode(str, &offset, STR_NO_LIMIT) != 0)
+	while (true) {
+		n = ascii_span(str, offset, STR_NO_LIMIT);
+		offset += n;
+		len += n;
+
+		if (str_decode(str, &offset, STR_NO_LIMIT) == 0)
+			break;
 		len++;
+	}
 
 	return len;
 }
@@ -479,9 +604,17 @@ size_t str_nlength(const char *str, size_t size)
 {
 	size_t len = 0;
 	size_t offset = 0;
+	size_t n;
+
+	while (true) {
+		n = ascii_span(str, offset, size);
+		offset += n;
+		len += n;
 
-	while (str_decode(str, &offset, size) != 0)
+		if (str_decode(str, &offset, size) == 0)
+			break;
 		len++;
+	}
 
 	return len;
 }
@@ -528,9 +661,19 @@ size_t str_width(const char *str)
 	size_t width = 0;
 	size_t offset = 0;
 	char32_t ch;
+	size_t n;
+
+	while (true) {
+		/* Plain ASCII characters are one cell wide. */
+		n = ascii_span(str, offset, STR_NO_LIMIT);
+		offset += n;
+		width += n;
 
-	while ((ch = str_decode(str, &offset, STR_NO_LIMIT)) != 0)
+		ch = str_decode(str, &offset, STR_NO_LIMIT);
+		if (ch == 0)
+			break;
 		width += chr_width(ch);
+	}
 
 	return width;
 }
@@ -561,6 +704,64 @@ bool chr_check(char32_t ch)
 	return false;
 }
 
+/** Check whether a string is valid UTF-8.
+ *
+ * Unlike str_decode(), which accepts any well-formed byte sequence, this
+ * also rejects overlong encodings, surrogates and code points above
+ * U+10FFFF. Runs of plain ASCII are checked a word at a time.
+ *
+ * @param str  String.
+ * @param size Size of the string (in bytes). Checking stops at a null
+ *             character if there is one before.
+ *
+ * @return True if the string is valid UTF-8.
+ *
+ */
+bool str_check(const char *str, size_t size)
+{
+	size_t offset = 0;
+	unsigned int cbytes;
+	uint32_t ch, min;
+	uint8_t b;
+
+	while (true) {
+		offset += ascii_span(str, offset, size);
+		if (offset >= size || str[offset] == 0)
+			return true;
+
+		b = (uint8_t) str[offset++];
+		if ((b & 0xe0) == 0xc0) {
+			ch = b & 0x1f;
+			cbytes = 1;
+			min = 0x80;
+		} else if ((b & 0xf0) == 0xe0) {
+			ch = b & 0x0f;
+			cbytes = 2;
+			min = 0x800;
+		} else if ((b & 0xf8) == 0xf0) {
+			ch = b & 0x07;
+			cbytes = 3;
+			min = 0x10000;
+		} else {
+			return false;
+		}
+
+		if (size - offset < cbytes)
+			return false;
+
+		while (cbytes > 0) {
+			b = (uint8_t) str[offset++];
+			if ((b & 0xc0) != 0x80)
+				return false;
+			ch = (ch << CONT_BITS) | (b & LO_MASK_8(CONT_BITS));
+			cbytes--;
+		}
+
+		if (ch < min || ch > 0x10ffff || (ch >= 0xd800 && ch <= 0xdfff))
+			return false;
+	}
+}
+
 /** Compare two NULL terminated strings.
  *
  * Do a char-by-char comparison of two NULL-terminated strings.
@@ -1237,17 +1438,23 @@ char *str_chr(const char *str, char32_t ch)
  */
 char *str_str(const char *hs, const char *n)
 {
-	size_t off = 0;
-
-	if (str_lcmp(hs, n, str_length(n)) == 0)
-		return (char *)hs;
-
-	while (str_decode(hs, &off, STR_NO_LIMIT) != 0) {
-		if (str_lcmp(hs + off, n, str_length(n)) == 0)
-			return (char *)(hs + off);
-	}
+	return (char *) str_search_mem(hs, str_size(hs), n, str_size(n),
+	    false);
+}
 
-	return NULL;
+/** Find first occurence of substring in string, ignoring case.
+ *
+ * Only ASCII letters are compared regardless of case, as in str_casecmp().
+ *
+ * @param hs  Haystack (string)
+ * @param n   Needle (substring to look for)
+ *
+ * @return Pointer to character in @a hs or @c NULL if not found.
+ */
+char *str_casestr(const char *hs, const char *n)
+{
+	return (char *) str_search_mem(hs, str_size(hs), n, str_size(n),
+	    true);
 }
 
 /** Removes specified trailing characters from a string.
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Substring search.
+ *
+ * One-shot searches (memmem(), str_str() and friends) use the two-way
+ * algorithm by Crochemore and Perrin, which needs constant space and
+ * linear time even for the worst-case patterns, and which also skips
+ * ahead by the last byte of the window like Horspool's algorithm does.
+ *
+ * For repeated searches of the same pattern, str_search_init() prepares
+ * Boyer-Moore-Horspool tables in both directions. That is sublinear on
+ * typical text, but can degrade to O(nm) on repetitive patterns.
+ *
+ * Both work on UTF-8 bytes. Since UTF-8 is self-synchronizing, a match of
+ * a valid pattern always starts at a character boundary. Case-insensitive
+ * searches fold ASCII letters only, just like str_casecmp().
+ */
+
+#include <macros.h>
+#include <mem.h>
+#include <stdint.h>
+#include <str.h>
+#include <str_search.h>
+
+/** Fold a byte to lower case for a case-insensitive search. */
+static inline uint8_t fold(uint8_t c, bool icase)
+{
+	if (icase && c >= 'A' && c <= 'Z')
+		return c - 'A' + 'a';
+
+	return c;
+}
+
+/** Compare two byte sequences, optionally regardless of case. */
+static bool bytes_equal(const uint8_t *a, const uint8_t *b, size_t n,
+    bool icase)
+{
+	if (!icase)
+		return memcmp(a, b, n) == 0;
+
+	for (size_t i = 0; i < n; i++) {
+		if (fold(a[i], true) != fold(b[i], true))
+			return false;
+	}
+
+	return true;
+}
+
+/** Prepare a substring search.
+ *
+ * @param s       Search to initialize.
+ * @param pattern Pattern to look for. It must stay valid while @a s is
+ *                in use.
+ * @param icase   @c true to compare ASCII letters regardless of case.
+ */
+void str_search_init(str_search_t *s, const char *pattern, bool icase)
+{
+	const uint8_t *p = (const uint8_t *) pattern;
+	size_t m = str_size(pattern);
+	size_t i;
+
+	s->pattern = pattern;
+	s->size = m;
+	s->icase = icase;
+
+	for (i = 0; i < 256; i++) {
+		s->shift[i] = m;
+		s->rshift[i] = m;
+	}
+
+	if (m == 0)
+		return;
+
+	/* Distance of the last occurrence of each byte from the end. */
+	for (i = 0; i < m - 1; i++)
+		s->shift[fold(p[i], icase)] = m - 1 - i;
+
+	/* Distance of the first occurrence of each byte from the start. */
+	for (i = m - 1; i > 0; i--)
+		s->rshift[fold(p[i], icase)] = i;
+}
+
+/** Find the first occurrence of a prepared pattern in a buffer.
+ *
+ * @param s    Prepared search.
+ * @param buf  Buffer to search.
+ * @param size Size of the buffer in bytes.
+ *
+ * @return Start of the first match in @a buf or @c NULL if not found.
+ */
+const char *str_search_first(const str_search_t *s, const char *buf,
+    size_t size)
+{
+	const uint8_t *h = (const uint8_t *) buf;
+	const uint8_t *n = (const uint8_t *) s->pattern;
+	size_t m = s->size;
+	uint8_t last, c;
+	size_t j;
+
+	if (m == 0)
+		return buf;
+	if (m > size)
+		return NULL;
+	if (m == 1 && !s->icase)
+		return memchr(buf, n[0], size);
+
+	last = fold(n[m - 1], s->icase);
+	j = 0;
+	while (j <= size - m) {
+		c = fold(h[j + m - 1], s->icase);
+		if (c == last && bytes_equal(h + j, n, m - 1, s->icase))
+			return buf + j;
+		j += s->shift[c];
+	}
+
+	return NULL;
+}
+
+/** Find the last occurrence of a prepared pattern in a buffer.
+ *
+ * @param s    Prepared search.
+ * @param buf  Buffer to search.
+ * @param size Size of the buffer in bytes.
+ *
+ * @return Start of the last match in @a buf or @c NULL if not found.
+ */
+const char *str_search_last(const str_search_t *s, const char *buf,
+    size_t size)
+{
+	const uint8_t *h = (const uint8_t *) buf;
+	const uint8_t *n = (const uint8_t *) s->pattern;
+	size_t m = s->size;
+	uint8_t first, c;
+	size_t j;
+
+	if (m == 0)
+		return buf + size;
+	if (m > size)
+		return NULL;
+
+	first = fold(n[0], s->icase);
+	j = size - m;
+	while (true) {
+		c = fold(h[j], s->icase);
+		if (c == first && bytes_equal(h + j + 1, n + 1, m - 1, s->icase))
+			return buf + j;
+		if (j < s->rshift[c])
+			break;
+		j -= s->rshift[c];
+	}
+
+	return NULL;
+}
+
+/** Compute the maximal suffix of a pattern.
+ *
+ * @param n       Pattern.
+ * @param m       Size of the pattern.
+ * @param reverse Use the reverse byte ordering.
+ * @param icase   Fold ASCII letters.
+ * @param period  Place to store the period of the suffix.
+ *
+ * @return Position before the start of the suffix.
+ */
+static size_t max_suffix(const uint8_t *n, size_t m, bool reverse,
+    bool icase, size_t *period)
+{
+	size_t ip = (size_t) -1;
+	size_t jp = 0;
+	size_t k = 1;
+	size_t p = 1;
+	uint8_t a, b;
+
+	while (jp + k < m) {
+		a = fold(n[ip + k], icase);
+		b = fold(n[jp + k], icase);
+		if (a == b) {
+			if (k == p) {
+				jp += p;
+				k = 1;
+			} else {
+				k++;
+			}
+		} else if (reverse ? a < b : a > b) {
+			jp += k;
+			k = 1;
+			p = jp - ip;
+		} else {
+			ip = jp++;
+			k = 1;
+			p = 1;
+		}
+	}
+
+	*period = p;
+	return ip;
+}
+
+/** Find the first occurrence of a byte sequence using the two-way algorithm.
+ *
+ * @param hs    Haystack.
+ * @param hsize Size of the haystack in bytes.
+ * @param n     Needle.
+ * @param nsize Size of the needle in bytes.
+ * @param icase @c true to compare ASCII letters regardless of case.
+ *
+ * @return Start of the first match in @a hs or @c NULL if not found.
+ */
+const char *str_search_mem(const char *hs, size_t hsize, const char *n,
+    size_t nsize, bool icase)
+{
+	const uint8_t *h = (const uint8_t *) hs;
+	const uint8_t *z = h + hsize;
+	const uint8_t *nd = (const uint8_t *) n;
+	size_t shift[256];
+	size_t ms, ms2, p, p2;
+	size_t mem, mem0;
+	size_t i, k;
+
+	if (nsize == 0)
+		return hs;
+	if (nsize > hsize)
+		return NULL;
+	if (nsize == 1 && !icase)
+		return memchr(hs, nd[0], hsize);
+
+	/* Position of the last occurrence of each byte plus one. */
+	memset(shift, 0, sizeof(shift));
+	for (i = 0; i < nsize; i++)
+		shift[fold(nd[i], icase)] = i + 1;
+
+	/* Critical factorization is the longer of the two maximal suffixes. */
+	ms = max_suffix(nd, nsize, false, icase, &p);
+	ms2 = max_suffix(nd, nsize, true, icase, &p2);
+	if (ms2 + 1 > ms + 1) {
+		ms = ms2;
+		p = p2;
+	}
+
+	if (bytes_equal(nd, nd + p, ms + 1, icase)) {
+		/* Periodic needle, remember the matched prefix on a shift. */
+		mem0 = nsize - p;
+	} else {
+		mem0 = 0;
+		p = max(ms, nsize - ms - 1) + 1;
+	}
+
+	mem = 0;
+	while ((size_t) (z - h) >= nsize) {
+		/* Skip by the last byte of the window. */
+		k = shift[fold(h[nsize - 1], icase)];
+		if (k == 0) {
+			h += nsize;
+			mem = 0;
+			continue;
+		}
+
+		k = nsize - k;
+		if (k != 0) {
+			if (k < mem)
+				k = mem;
+			h += k;
+			mem = 0;
+			continue;
+		}
+
+		/* Compare the right half. */
+		for (k = max(ms + 1, mem); k < nsize &&
+		    fold(nd[k], icase) == fold(h[k], icase); k++)
+			;
+		if (k < nsize) {
+			h += k - ms;
+			mem = 0;
+			continue;
+		}
+
+		/* Compare the left half. */
+		for (k = ms + 1; k > mem &&
+		    fold(nd[k - 1], icase) == fold(h[k - 1], icase); k--)
+			;
+		if (k <= mem)
+			return (const char *) h;
+
+		h += p;
+		mem = mem0;
+	}
+
+	return NULL;
+}
+
+/** @}
+ */
@@ -36,6 +36,7 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <str_error.h>
+#include <str_search.h>
 #include <string.h>
 
 /** Copy string.
@@ -375,23 +376,7 @@ size_t strspn(const char *s1, const char *s2)
  */
 char *strstr(const char *s1, const char *s2)
 {
-	size_t len;
-
-	/*
-	 * Naive search algorithm.
-	 *
-	 * Two-Way String-Matching might be a plausible alternative
-	 * for larger haystack+needle combinations.
-	 */
-
-	len = strlen(s2);
-	while (*s1 != '\0') {
-		if (strncmp(s1, s2, len) == 0)
-			return (char *) s1;
-		++s1;
-	}
-
-	return NULL;
+	return (char *) str_search_mem(s1, strlen(s1), s2, strlen(s2), false);
 }
 
 /** Tokenize a string (reentrant).
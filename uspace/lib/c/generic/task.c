@@ -48,7 +48,14 @@
 #include <stdlib.h>
 #include <udebug.h>
 #include <libc.h>
+#include <as.h>
+#include <fibril.h>
+#include <stack.h>
+#include <libarch/faddr.h>
+#include <abi/proc/uarg.h>
 #include "private/ns.h"
+#include "private/fibril.h"
+#include "private/thread.h"
 #include <vfs/vfs.h>
 
 task_id_t task_get_id(void)
@@ -91,6 +98,24 @@ errno_t task_kill(task_id_t task_id)
 	return (errno_t) __SYSCALL1(SYS_TASK_KILL, (sysarg_t) &task_id);
 }
 
+/** Set the scheduling class of the current task.
+ *
+ * The class applies to all threads of the task, including those created
+ * later. The real-time class SCHED_CLASS_FIFO should only be used by
+ * latency-sensitive tasks which do little work per event, as its threads
+ * run before all other threads in the system until they block.
+ *
+ * @param sched_class Scheduling class.
+ *
+ * @return EOK on success.
+ * @return EPERM if the task is not entitled to use the real-time class.
+ */
+errno_t task_set_sched_class(sched_class_t sched_class)
+{
+	return (errno_t) __SYSCALL1(SYS_TASK_SET_SCHED_CLASS,
+	    (sysarg_t) sched_class);
+}
+
 /** Create a new task by running an executable from the filesystem.
  *
  * This is really just a convenience wrapper over the more complicated
@@ -482,6 +507,108 @@ errno_t task_wait_task_id(task_id_t id, task_exit_t *texit, int *retval)
 	return task_wait(&wait, texit, retval);
 }
 
+typedef struct {
+	int (*fn)(void *);
+	void *arg;
+} task_clone_t;
+
+/** Main function of the only thread of a task clone. */
+static void task_clone_main(void *arg)
+{
+	task_clone_t *clone = (task_clone_t *) arg;
+
+	__fibrils_clone_reset();
+	__ns_clone_reset();
+	(void) ns_intro(task_get_id());
+
+	exit(clone->fn(clone->arg));
+}
+
+/** Clone the calling task.
+ *
+ * The clone gets a copy-on-write copy of the address space of the caller.
+ * A task which has initialized itself once can thus start helpers without
+ * loading and linking a program for each of them. The clone runs
+ * @a fn(@a arg) in its only thread and exits with the returned value.
+ *
+ * The caller must be single-threaded. Apart from its futexes, the clone
+ * does not inherit any kernel objects of the caller, it is only connected
+ * to the naming service. Other sessions of the caller, including those
+ * behind the standard streams, cannot be used in the clone.
+ *
+ * @param id   If not NULL, the ID of the clone is stored here.
+ * @param name Name of the clone.
+ * @param fn   Function to run in the clone.
+ * @param arg  Argument of @a fn.
+ *
+ * @return EOK on success, ENOTSUP if the caller runs more than one thread
+ *         or if some of its memory cannot be cloned, or another error code.
+ */
+errno_t task_clone(task_id_t *id, const char *name, int (*fn)(void *),
+    void *arg)
+{
+	if (fibril_get_runner_count() > 1)
+		return ENOTSUP;
+
+	/*
+	 * Everything needed to start the clone's thread is prepared in
+	 * advance, so that the clone gets its own copy of it.
+	 */
+	task_clone_t *clone = malloc(sizeof(task_clone_t));
+	if (!clone)
+		return ENOMEM;
+
+	uspace_arg_t *uarg = calloc(1, sizeof(uspace_arg_t));
+	if (!uarg) {
+		free(clone);
+		return ENOMEM;
+	}
+
+	fibril_t *fibril = fibril_alloc();
+	if (!fibril) {
+		free(uarg);
+		free(clone);
+		return ENOMEM;
+	}
+
+	size_t stack_size = stack_size_get();
+	void *stack = as_area_create(AS_AREA_ANY, stack_size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE | AS_AREA_GUARD |
+	    AS_AREA_LATE_RESERVE, AS_AREA_UNPAGED);
+	if (stack == AS_MAP_FAILED) {
+		fibril_teardown(fibril);
+		free(uarg);
+		free(clone);
+		return ENOMEM;
+	}
+
+	clone->fn = fn;
+	clone->arg = arg;
+	fibril->arg = clone;
+
+	uarg->uspace_entry = (void *) FADDR(__thread_entry);
+	uarg->uspace_stack = stack;
+	uarg->uspace_stack_size = stack_size;
+	uarg->uspace_thread_function = task_clone_main;
+	uarg->uspace_thread_arg = fibril;
+	uarg->uspace_uarg = uarg;
+
+	task_id_t clone_id;
+	errno_t rc = (errno_t) __SYSCALL4(SYS_PROGRAM_CLONE, (sysarg_t) uarg,
+	    (sysarg_t) name, (sysarg_t) str_size(name), (sysarg_t) &clone_id);
+
+	/* The clone has its own copies now. */
+	as_area_destroy(stack);
+	fibril_teardown(fibril);
+	free(uarg);
+	free(clone);
+
+	if ((rc == EOK) && (id != NULL))
+		*id = clone_id;
+
+	return rc;
+}
+
 errno_t task_retval(int val)
 {
 	errno_t rc;
@@ -35,6 +35,7 @@
  */
 
 #include <adt/list.h>
+#include <adt/twheel.h>
 #include <fibril.h>
 #include <stack.h>
 #include <tls.h>
@@ -45,7 +46,11 @@
 
 #include <mem.h>
 #include <str.h>
+#include <stats.h>
+#define _LIBC_ASYNC_C_
 #include <ipc/ipc.h>
+#include "../private/async.h"
+#undef _LIBC_ASYNC_C_
 #include <libarch/faddr.h>
 
 #include "../private/thread.h"
@@ -56,10 +61,9 @@
 #define DPRINTF(...) ((void)0)
 #undef READY_DEBUG
 
-/** Member of timeout_list. */
+/** Member of timeout_wheel. */
 typedef struct {
-	link_t link;
-	struct timespec expires;
+	twheel_timer_t timer;
 	fibril_event_t *event;
 } _timeout_t;
 
@@ -83,22 +87,72 @@ typedef enum {
 	SWITCH_FROM_BLOCKED,
 } _switch_type_t;
 
+/** Maximum number of threads with a ready queue of their own. */
+#define READY_QUEUES_MAX 64
+
+/**
+ * Ready queue of one thread.
+ *
+ * Fibrils made ready by a thread are appended to that thread's queue.
+ * Threads prefer fibrils from their own queue and only steal from the
+ * queues of others when theirs is empty. Threads without a queue of their
+ * own use the shared one.
+ */
+typedef struct _ready_queue {
+	futex_t futex;
+	list_t list;
+} _ready_queue_t;
+
 static bool multithreaded = false;
 
-/* This futex serializes access to global data. */
+/* Number of threads running fibrils, including the main thread. */
+static atomic_int runner_count = 1;
+
+/*
+ * This futex serializes access to global data other than the ready queues,
+ * i.e. events, timeouts and the list of all fibrils.
+ */
 static futex_t fibril_futex;
 static futex_t ready_semaphore;
 static long ready_st_count;
 
-static LIST_INITIALIZE(ready_list);
+/*
+ * The ready queues. Entries are only ever added, registration is serialized
+ * by fibril_futex. The first entry is the shared queue.
+ */
+static _ready_queue_t ready_shared;
+static _ready_queue_t *ready_queues[READY_QUEUES_MAX];
+static atomic_int ready_queue_count;
+
+/* Number of fibrils in the ready queues not yet claimed by a thread. */
+static atomic_long ready_count;
+
+/** Maximum number of stacks of dead fibrils kept for reuse. */
+#define STACK_POOL_MAX 16
+
+/*
+ * Stacks of the default size are kept for reuse instead of being destroyed
+ * with their fibril, protected by stack_pool_futex.
+ */
+static futex_t stack_pool_futex;
+static void *stack_pool[STACK_POOL_MAX];
+static size_t stack_pool_count;
+static fibril_stack_stats_t stack_pool_stats;
+
 static LIST_INITIALIZE(fibril_list);
-static LIST_INITIALIZE(timeout_list);
+static twheel_t timeout_wheel;
 
 static futex_t ipc_lists_futex;
 static LIST_INITIALIZE(ipc_waiter_list);
 static LIST_INITIALIZE(ipc_buffer_list);
 static LIST_INITIALIZE(ipc_buffer_free_list);
 
+/* Calls received by the last IPC batch wait, protected by ipc_lists_futex. */
+static ipc_call_t ipc_batch[IPC_MAX_BATCH];
+static size_t ipc_batch_next;
+static size_t ipc_batch_count;
+static bool ipc_batch_busy;
+
 /* Only used as unique markers for triggered events. */
 static fibril_t _fibril_event_triggered;
 static fibril_t _fibril_event_timed_out;
@@ -110,7 +164,7 @@ static inline void _ready_debug_check(void)
 {
 #ifdef READY_DEBUG
 	assert(!multithreaded);
-	long count = (long) list_count(&ready_list) +
+	long count = atomic_load(&ready_count) +
 	    (long) list_count(&ipc_buffer_free_list);
 	assert(ready_st_count == count);
 #endif
@@ -138,6 +192,8 @@ static inline errno_t _ready_down(const struct timespec *expires)
 
 static atomic_int threads_in_ipc_wait;
 
+static void _fibril_switch_finish(bool);
+
 /** Function that spans the whole life-cycle of a fibril.
  *
  * Each fibril begins execution in this function. Then the function implementing
@@ -147,8 +203,7 @@ static atomic_int threads_in_ipc_wait;
  */
 static void _fibril_main(void)
 {
-	/* fibril_futex is locked when a fibril is started. */
-	futex_unlock(&fibril_futex);
+	_fibril_switch_finish(false);
 
 	fibril_t *fibril = fibril_self();
 
@@ -237,24 +292,189 @@ static fibril_t *_fibril_trigger_internal(fibril_event_t *event, fibril_t *reaso
 	return f;
 }
 
+/** Receive one call, from the current batch if possible.
+ *
+ * Calls are received from the kernel in batches. The calls of a batch are
+ * handed out one by one, so the rest of the fibril machinery still treats
+ * them as received by individual waits. Only one thread at a time receives
+ * a batch, the others wait for single calls meanwhile.
+ *
+ * Answers deferred by the async framework while the batch is processed are
+ * sent before the last call of the batch is handed out or before the
+ * kernel is entered.
+ */
+static errno_t _ipc_wait_batch(ipc_call_t *call, sysarg_t usec,
+    unsigned int flags)
+{
+	futex_lock(&ipc_lists_futex);
+
+	if (ipc_batch_next < ipc_batch_count) {
+		*call = ipc_batch[ipc_batch_next++];
+		bool last = (ipc_batch_next == ipc_batch_count);
+		futex_unlock(&ipc_lists_futex);
+
+		if (last)
+			async_answer_flush();
+
+		return EOK;
+	}
+
+	bool batch = !ipc_batch_busy;
+	ipc_batch_busy = true;
+
+	futex_unlock(&ipc_lists_futex);
+
+	async_answer_flush();
+
+	if (!batch)
+		return ipc_wait(call, usec, flags);
+
+	size_t received = 0;
+	errno_t rc = ipc_wait_batch(ipc_batch, IPC_MAX_BATCH, &received, usec,
+	    flags);
+
+	futex_lock(&ipc_lists_futex);
+
+	if (rc == EOK) {
+		assert(received > 0);
+		*call = ipc_batch[0];
+		ipc_batch_next = 1;
+		ipc_batch_count = received;
+	}
+
+	ipc_batch_busy = false;
+
+	futex_unlock(&ipc_lists_futex);
+	return rc;
+}
+
+/** Check whether received calls are waiting to be handed out. */
+bool fibril_ipc_pending(void)
+{
+	return ipc_batch_next < ipc_batch_count;
+}
+
 static errno_t _ipc_wait(ipc_call_t *call, const struct timespec *expires)
 {
 	if (!expires)
-		return ipc_wait(call, SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NONE);
+		return _ipc_wait_batch(call, SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NONE);
 
-	if (expires->tv_sec == 0)
-		return ipc_wait(call, SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NON_BLOCKING);
+	if (expires->tv_sec == 0) {
+		return _ipc_wait_batch(call, SYNCH_NO_TIMEOUT,
+		    SYNCH_FLAGS_NON_BLOCKING);
+	}
 
 	struct timespec now;
 	getuptime(&now);
 
-	if (ts_gteq(&now, expires))
-		return ipc_wait(call, SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NON_BLOCKING);
+	if (ts_gteq(&now, expires)) {
+		return _ipc_wait_batch(call, SYNCH_NO_TIMEOUT,
+		    SYNCH_FLAGS_NON_BLOCKING);
+	}
 
-	return ipc_wait(call, NSEC2USEC(ts_sub_diff(expires, &now)),
+	return _ipc_wait_batch(call, NSEC2USEC(ts_sub_diff(expires, &now)),
 	    SYNCH_FLAGS_NONE);
 }
 
+/** Allocate and register a ready queue for the calling thread.
+ *
+ * @return The new queue, or NULL if the thread should use the shared queue.
+ */
+static _ready_queue_t *_ready_queue_create(void)
+{
+	_ready_queue_t *rq = malloc(sizeof(_ready_queue_t));
+	if (!rq)
+		return NULL;
+
+	if (futex_initialize(&rq->futex, 1) != EOK) {
+		free(rq);
+		return NULL;
+	}
+
+	list_initialize(&rq->list);
+
+	futex_lock(&fibril_futex);
+
+	int count = atomic_load_explicit(&ready_queue_count,
+	    memory_order_relaxed);
+	if (count < READY_QUEUES_MAX) {
+		ready_queues[count] = rq;
+		atomic_store_explicit(&ready_queue_count, count + 1,
+		    memory_order_release);
+	}
+
+	futex_unlock(&fibril_futex);
+
+	if (count >= READY_QUEUES_MAX) {
+		futex_destroy(&rq->futex);
+		free(rq);
+		return NULL;
+	}
+
+	return rq;
+}
+
+/** @return the ready queue of the current thread. */
+static _ready_queue_t *_ready_queue_self(void)
+{
+	fibril_t *ctx = fibril_self()->thread_ctx;
+	if (!ctx || !ctx->ready_queue)
+		return &ready_shared;
+
+	return ctx->ready_queue;
+}
+
+static fibril_t *_ready_queue_pop(_ready_queue_t *rq)
+{
+	futex_lock(&rq->futex);
+	fibril_t *f = list_pop(&rq->list, fibril_t, link);
+	futex_unlock(&rq->futex);
+	return f;
+}
+
+/** Claim one of the fibrils in the ready queues, if there is any. */
+static bool _ready_claim(void)
+{
+	long count = atomic_load_explicit(&ready_count, memory_order_relaxed);
+
+	while (count > 0) {
+		if (atomic_compare_exchange_weak_explicit(&ready_count, &count,
+		    count - 1, memory_order_acquire, memory_order_relaxed))
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * Take a claimed fibril, preferably from the current thread's own queue.
+ * The queues of other threads are only searched when the own one is empty.
+ * Every claim is backed by a queued fibril, but a thread that scans the
+ * queues concurrently may take the one we would find, so keep looking.
+ */
+static fibril_t *_ready_take(void)
+{
+	_ready_queue_t *own = _ready_queue_self();
+
+	while (true) {
+		fibril_t *f = _ready_queue_pop(own);
+		if (f)
+			return f;
+
+		int count = atomic_load_explicit(&ready_queue_count,
+		    memory_order_acquire);
+
+		for (int i = 0; i < count; i++) {
+			if (ready_queues[i] == own)
+				continue;
+
+			f = _ready_queue_pop(ready_queues[i]);
+			if (f)
+				return f;
+		}
+	}
+}
+
 /*
  * Waits until a ready fibril is added to the list, or an IPC message arrives.
  * Returns NULL on timeout and may also return NULL if returning from IPC
@@ -277,22 +497,25 @@ static fibril_t *_ready_list_pop(const struct timespec *expires, bool locked)
 
 	/*
 	 * Once we acquire a token from ready_semaphore, there are two options.
-	 * Either there is a ready fibril in the list, or it's our turn to
-	 * call `ipc_wait_cycle()`. There is one extra token on the semaphore
+	 * Either there is a ready fibril in one of the queues, or it's our turn
+	 * to call `ipc_wait_cycle()`. There is one extra token on the semaphore
 	 * for each entry of the call buffer.
+	 *
+	 * We announce ourselves as an IPC waiter before looking at the ready
+	 * count. A concurrent _ready_list_push() increments the count before
+	 * looking at the waiters, so one of us is guaranteed to notice the
+	 * other and the new fibril cannot be missed.
 	 */
 
-	if (!locked)
-		futex_lock(&fibril_futex);
-	fibril_t *f = list_pop(&ready_list, fibril_t, link);
-	if (!f)
-		atomic_fetch_add_explicit(&threads_in_ipc_wait, 1,
+	atomic_fetch_add(&threads_in_ipc_wait, 1);
+
+	if (_ready_claim()) {
+		atomic_fetch_sub_explicit(&threads_in_ipc_wait, 1,
 		    memory_order_relaxed);
-	if (!locked)
-		futex_unlock(&fibril_futex);
+		return _ready_take();
+	}
 
-	if (f)
-		return f;
+	fibril_t *f = NULL;
 
 	if (!multithreaded)
 		assert(list_empty(&ipc_buffer_list));
@@ -364,13 +587,16 @@ static void _ready_list_push(fibril_t *f)
 	if (!f)
 		return;
 
-	futex_assert_is_locked(&fibril_futex);
+	/* Enqueue in the current thread's ready queue. */
+	_ready_queue_t *rq = _ready_queue_self();
+	futex_lock(&rq->futex);
+	list_append(&f->link, &rq->list);
+	futex_unlock(&rq->futex);
 
-	/* Enqueue in ready_list. */
-	list_append(&f->link, &ready_list);
+	atomic_fetch_add(&ready_count, 1);
 	_ready_up();
 
-	if (atomic_load_explicit(&threads_in_ipc_wait, memory_order_relaxed)) {
+	if (atomic_load(&threads_in_ipc_wait)) {
 		DPRINTF("Poking.\n");
 		/* Wakeup one thread sleeping in SYS_IPC_WAIT. */
 		ipc_poke();
@@ -414,32 +640,100 @@ static errno_t _wait_ipc(ipc_call_t *call, const struct timespec *expires)
 	return rc;
 }
 
+/** Convert uptime to microseconds for timeout_wheel, rounding up. */
+static uint64_t _ts_to_usec(const struct timespec *ts)
+{
+	return (uint64_t) SEC2USEC(ts->tv_sec) +
+	    (uint64_t) NSEC2USEC(ts->tv_nsec + USEC2NSEC(1) - 1);
+}
+
 /** Fire all timeouts that expired. */
 static struct timespec *_handle_expired_timeouts(struct timespec *next_timeout)
 {
 	struct timespec ts;
 	getuptime(&ts);
 
+	list_t expired;
+	list_initialize(&expired);
+
 	futex_lock(&fibril_futex);
 
-	while (!list_empty(&timeout_list)) {
-		link_t *cur = list_first(&timeout_list);
-		_timeout_t *to = list_get_instance(cur, _timeout_t, link);
+	twheel_advance(&timeout_wheel, (uint64_t) SEC2USEC(ts.tv_sec) +
+	    (uint64_t) NSEC2USEC(ts.tv_nsec), &expired);
 
-		if (ts_gt(&to->expires, &ts)) {
-			*next_timeout = to->expires;
-			futex_unlock(&fibril_futex);
-			return next_timeout;
-		}
-
-		list_remove(&to->link);
+	while (!list_empty(&expired)) {
+		_timeout_t *to = list_get_instance(list_first(&expired),
+		    _timeout_t, timer.link);
+		list_remove(&to->timer.link);
 
 		_ready_list_push(_fibril_trigger_internal(
 		    to->event, _EVENT_TIMED_OUT));
 	}
 
+	uint64_t next;
+	bool pending = twheel_next(&timeout_wheel, &next);
+
 	futex_unlock(&fibril_futex);
-	return NULL;
+
+	if (!pending)
+		return NULL;
+
+	next_timeout->tv_sec = USEC2SEC(next);
+	next_timeout->tv_nsec = USEC2NSEC(next % SEC2USEC(1));
+	return next_timeout;
+}
+
+/** Allocate a fibril stack, reusing a pooled one if possible. */
+static void *_stack_alloc(size_t size)
+{
+	if (size == stack_size_get()) {
+		futex_lock(&stack_pool_futex);
+
+		if (stack_pool_count > 0) {
+			void *stack = stack_pool[--stack_pool_count];
+			stack_pool_stats.hits++;
+			futex_unlock(&stack_pool_futex);
+			return stack;
+		}
+
+		stack_pool_stats.misses++;
+		futex_unlock(&stack_pool_futex);
+	}
+
+	return as_area_create(AS_AREA_ANY, size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE | AS_AREA_GUARD |
+	    AS_AREA_LATE_RESERVE, AS_AREA_UNPAGED);
+}
+
+/** Return a fibril stack to the pool, or destroy it if the pool is full. */
+static void _stack_free(void *stack, size_t size)
+{
+	if (size == stack_size_get()) {
+		futex_lock(&stack_pool_futex);
+
+		if (stack_pool_count < STACK_POOL_MAX) {
+			stack_pool[stack_pool_count++] = stack;
+			futex_unlock(&stack_pool_futex);
+			return;
+		}
+
+		stack_pool_stats.destroyed++;
+		futex_unlock(&stack_pool_futex);
+	}
+
+	as_area_destroy(stack);
+}
+
+/** Get statistics of the fibril stack pool.
+ *
+ * @param stats  Place to store the statistics.
+ */
+void fibril_stack_stats(fibril_stack_stats_t *stats)
+{
+	futex_lock(&stack_pool_futex);
+	*stats = stack_pool_stats;
+	stats->pooled = stack_pool_count;
+	futex_unlock(&stack_pool_futex);
 }
 
 /**
@@ -454,20 +748,49 @@ static void _fibril_cleanup_dead(void)
 
 	void *stack = srcf->clean_after_me->stack;
 	assert(stack);
-	as_area_destroy(stack);
+	_stack_free(stack, srcf->clean_after_me->stack_size);
 	fibril_teardown(srcf->clean_after_me);
 	srcf->clean_after_me = NULL;
 }
 
-/** Switch to a fibril. */
+/**
+ * Finish a switch to the current fibril. Must be called right after
+ * context_swap() returns, or when a new fibril starts.
+ *
+ * A fibril that yielded to us is only put into a ready queue here, once
+ * its context is saved. fibril_futex is held across the switch only when
+ * the previous fibril blocked. It is acquired or released so that its state
+ * afterwards matches what the caller needs.
+ *
+ * @param locked  Whether fibril_futex must be held on return.
+ */
+static void _fibril_switch_finish(bool locked)
+{
+	fibril_t *self = fibril_self();
+	fibril_t *yielded = self->ready_after_me;
+	self->ready_after_me = NULL;
+
+	_ready_list_push(yielded);
+
+	if (self->switch_locked && !locked)
+		futex_unlock(&fibril_futex);
+	else if (!self->switch_locked && locked)
+		futex_lock(&fibril_futex);
+}
+
+/** Switch to a fibril.
+ *
+ * @param locked  True if fibril_futex is held by the caller. The lock is then
+ *                held across the switch and again on return.
+ */
 static void _fibril_switch_to(_switch_type_t type, fibril_t *dstf, bool locked)
 {
 	assert(fibril_self()->rmutex_locks == 0);
 
-	if (!locked)
-		futex_lock(&fibril_futex);
-	else
+	if (locked)
 		futex_assert_is_locked(&fibril_futex);
+	else
+		futex_assert_is_not_locked(&fibril_futex);
 
 	fibril_t *srcf = fibril_self();
 	assert(srcf);
@@ -475,7 +798,7 @@ static void _fibril_switch_to(_switch_type_t type, fibril_t *dstf, bool locked)
 
 	switch (type) {
 	case SWITCH_FROM_YIELD:
-		_ready_list_push(srcf);
+		dstf->ready_after_me = srcf;
 		break;
 	case SWITCH_FROM_DEAD:
 		dstf->clean_after_me = srcf;
@@ -488,8 +811,11 @@ static void _fibril_switch_to(_switch_type_t type, fibril_t *dstf, bool locked)
 	dstf->thread_ctx = srcf->thread_ctx;
 	srcf->thread_ctx = NULL;
 
+	dstf->switch_locked = locked;
+
 	/* Just some bookkeeping to allow better debugging of futex locks. */
-	futex_give_to(&fibril_futex, dstf);
+	if (locked)
+		futex_give_to(&fibril_futex, dstf);
 
 	/* Swap to the next fibril. */
 	context_swap(&srcf->ctx, &dstf->ctx);
@@ -497,11 +823,11 @@ static void _fibril_switch_to(_switch_type_t type, fibril_t *dstf, bool locked)
 	assert(srcf == fibril_self());
 	assert(srcf->thread_ctx);
 
-	if (!locked) {
-		/* Must be after context_swap()! */
-		futex_unlock(&fibril_futex);
+	/* Must be after context_swap()! */
+	_fibril_switch_finish(locked);
+
+	if (!locked)
 		_fibril_cleanup_dead();
-	}
 }
 
 /**
@@ -550,9 +876,7 @@ fid_t fibril_create_generic(errno_t (*func)(void *), void *arg, size_t stksz)
 		return 0;
 
 	fibril->stack_size = stksz;
-	fibril->stack = as_area_create(AS_AREA_ANY, fibril->stack_size,
-	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE | AS_AREA_GUARD |
-	    AS_AREA_LATE_RESERVE, AS_AREA_UNPAGED);
+	fibril->stack = _stack_alloc(fibril->stack_size);
 	if (fibril->stack == AS_MAP_FAILED) {
 		fibril_teardown(fibril);
 		return 0;
@@ -591,26 +915,23 @@ void fibril_destroy(fid_t fid)
 
 	assert(!fibril->is_running);
 	assert(fibril->stack);
-	as_area_destroy(fibril->stack);
+	_stack_free(fibril->stack, fibril->stack_size);
 	fibril_teardown(fibril);
 }
 
-static void _insert_timeout(_timeout_t *timeout)
+static void _insert_timeout(_timeout_t *timeout,
+    const struct timespec *expires)
 {
 	futex_assert_is_locked(&fibril_futex);
 	assert(timeout);
 
-	link_t *tmp = timeout_list.head.next;
-	while (tmp != &timeout_list.head) {
-		_timeout_t *cur = list_get_instance(tmp, _timeout_t, link);
-
-		if (ts_gteq(&cur->expires, &timeout->expires))
-			break;
-
-		tmp = tmp->next;
+	if (twheel_empty(&timeout_wheel)) {
+		struct timespec now;
+		getuptime(&now);
+		twheel_restart(&timeout_wheel, _ts_to_usec(&now));
 	}
 
-	list_insert_before(&timeout->link, tmp);
+	twheel_insert(&timeout_wheel, &timeout->timer, _ts_to_usec(expires));
 }
 
 /**
@@ -631,10 +952,13 @@ errno_t fibril_wait_timeout(fibril_event_t *event,
 	DPRINTF("### Fibril %p sleeping on event %p.\n", fibril_self(), event);
 
 	if (!fibril_self()->thread_ctx) {
-		fibril_self()->thread_ctx =
+		fibril_t *helper = (fibril_t *)
 		    fibril_create_generic(_helper_fibril_fn, NULL, PAGE_SIZE);
-		if (!fibril_self()->thread_ctx)
+		if (!helper)
 			return ENOMEM;
+
+		helper->ready_queue = _ready_queue_create();
+		fibril_self()->thread_ctx = helper;
 	}
 
 	futex_lock(&fibril_futex);
@@ -679,9 +1003,8 @@ errno_t fibril_wait_timeout(fibril_event_t *event,
 
 	_timeout_t timeout = { 0 };
 	if (expires) {
-		timeout.expires = *expires;
 		timeout.event = event;
-		_insert_timeout(&timeout);
+		_insert_timeout(&timeout, expires);
 	}
 
 	assert(srcf);
@@ -697,7 +1020,7 @@ errno_t fibril_wait_timeout(fibril_event_t *event,
 	assert(event->fibril != _EVENT_INITIAL);
 	assert(event->fibril == _EVENT_TIMED_OUT || event->fibril == _EVENT_TRIGGERED);
 
-	list_remove(&timeout.link);
+	twheel_remove(&timeout_wheel, &timeout.timer);
 	errno_t rc = (event->fibril == _EVENT_TIMED_OUT) ? ETIMEOUT : EOK;
 	event->fibril = _EVENT_INITIAL;
 
@@ -782,6 +1105,7 @@ void fibril_yield(void)
 
 static void _runner_fn(void *arg)
 {
+	fibril_self()->ready_queue = _ready_queue_create();
 	_helper_fibril_fn(arg);
 }
 
@@ -812,11 +1136,40 @@ int fibril_test_spawn_runners(int n)
 		if (rc != EOK)
 			return i;
 		thread_detach(tid);
+		atomic_fetch_add_explicit(&runner_count, 1, memory_order_relaxed);
 	}
 
 	return n;
 }
 
+/**
+ * Get the number of threads that run fibrils of this task.
+ *
+ * @return Number of runners including the main thread.
+ */
+int fibril_get_runner_count(void)
+{
+	return atomic_load_explicit(&runner_count, memory_order_relaxed);
+}
+
+/** Count the active processors of the system. */
+static int _active_cpu_count(void)
+{
+	size_t count;
+	stats_cpu_t *cpus = stats_get_cpus(&count);
+	if (cpus == NULL)
+		return 1;
+
+	int active = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (cpus[i].active)
+			active++;
+	}
+
+	free(cpus);
+	return active > 0 ? active : 1;
+}
+
 /**
  * Opt-in to have more than one runner thread.
  *
@@ -828,11 +1181,16 @@ int fibril_test_spawn_runners(int n)
  */
 void fibril_enable_multithreaded(void)
 {
-	// TODO: Implement better.
-	//       For now, 4 total runners is a sensible default.
-	if (!multithreaded) {
-		fibril_test_spawn_runners(3);
-	}
+	if (multithreaded)
+		return;
+
+	/*
+	 * One runner per active processor. A uniprocessor still gets
+	 * a second runner so that a fibril blocked in a system call
+	 * does not stall all the others.
+	 */
+	int cpus = _active_cpu_count();
+	fibril_test_spawn_runners(cpus > 1 ? cpus - 1 : 1);
 }
 
 /**
@@ -869,6 +1227,16 @@ void __fibrils_init(void)
 		abort();
 	if (futex_initialize(&ipc_lists_futex, 1) != EOK)
 		abort();
+	if (futex_initialize(&ready_shared.futex, 1) != EOK)
+		abort();
+	if (futex_initialize(&stack_pool_futex, 1) != EOK)
+		abort();
+
+	twheel_initialize(&timeout_wheel, 0);
+
+	list_initialize(&ready_shared.list);
+	ready_queues[0] = &ready_shared;
+	atomic_store(&ready_queue_count, 1);
 
 	/*
 	 * We allow a fixed, small amount of parallelism for IPC reads, but
@@ -885,10 +1253,46 @@ void __fibrils_init(void)
 	}
 }
 
+/**
+ * Forget the other fibrils of the parent task in its clone.
+ *
+ * The clone starts with a copy of the state of the single-threaded parent,
+ * but the other fibrils of the parent can never run in it. The only fibril
+ * of the clone must call this before it blocks for the first time.
+ */
+void __fibrils_clone_reset(void)
+{
+	assert(!multithreaded);
+
+	list_initialize(&fibril_list);
+	list_append(&fibril_self()->all_link, &fibril_list);
+
+	list_initialize(&ready_shared.list);
+	ready_st_count -= atomic_load(&ready_count);
+	atomic_store(&ready_count, 0);
+
+	twheel_initialize(&timeout_wheel, 0);
+
+	/* Calls received by the parent are of no use to the clone. */
+	list_initialize(&ipc_waiter_list);
+	while (!list_empty(&ipc_buffer_list)) {
+		link_t *link = list_first(&ipc_buffer_list);
+		list_remove(link);
+		list_append(link, &ipc_buffer_free_list);
+		_ready_up();
+	}
+
+	ipc_batch_next = 0;
+	ipc_batch_count = 0;
+	ipc_batch_busy = false;
+}
+
 void __fibrils_fini(void)
 {
 	futex_destroy(&fibril_futex);
 	futex_destroy(&ipc_lists_futex);
+	futex_destroy(&ready_shared.futex);
+	futex_destroy(&stack_pool_futex);
 }
 
 void fibril_usleep(usec_t timeout)
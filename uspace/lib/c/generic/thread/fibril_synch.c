@@ -91,14 +91,41 @@ static fibril_local bool deadlocked = false;
 
 static futex_t fibril_synch_futex;
 
+/** Number of buckets of the parking lot used by fibril_park(). */
+#define PARK_BUCKETS  64
+
+typedef struct {
+	futex_t futex;
+	list_t waiters;
+	/** Number of fibrils in fibril_park(), read without the lock */
+	atomic_size_t parked;
+} park_bucket_t;
+
+typedef struct {
+	link_t link;
+	fibril_event_t event;
+	const void *addr;
+} park_waiter_t;
+
+static park_bucket_t park_buckets[PARK_BUCKETS];
+
 void __fibril_synch_init(void)
 {
 	if (futex_initialize(&fibril_synch_futex, 1) != EOK)
 		abort();
+
+	for (size_t i = 0; i < PARK_BUCKETS; i++) {
+		if (futex_initialize(&park_buckets[i].futex, 1) != EOK)
+			abort();
+		list_initialize(&park_buckets[i].waiters);
+	}
 }
 
 void __fibril_synch_fini(void)
 {
+	for (size_t i = 0; i < PARK_BUCKETS; i++)
+		futex_destroy(&park_buckets[i].futex);
+
 	futex_destroy(&fibril_synch_futex);
 }
 
@@ -466,48 +493,108 @@ void fibril_condvar_broadcast(fibril_condvar_t *fcv)
 	futex_unlock(&fibril_synch_futex);
 }
 
+/*
+ * All timers are kept on timer_wheel and fired by timer_fibril, which is
+ * started when the first timer is created. Lock order is timer->lockp,
+ * then timer_lock.
+ */
+static FIBRIL_MUTEX_INITIALIZE(timer_lock);
+/** Wakes up timer_fibril. */
+static FIBRIL_CONDVAR_INITIALIZE(timer_cv);
+/** Signalled when timer_fibril drops a reference to a timer. */
+static FIBRIL_CONDVAR_INITIALIZE(timer_release_cv);
+static twheel_t timer_wheel;
+static fid_t timer_fibril;
+/** Time until which timer_fibril sleeps, UINT64_MAX if indefinitely. */
+static uint64_t timer_wakeup = UINT64_MAX;
+
+/** Get current uptime in microseconds. */
+static uint64_t timer_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return (uint64_t) SEC2USEC(ts.tv_sec) + (uint64_t) NSEC2USEC(ts.tv_nsec);
+}
+
+/** Execute the callback of an expired timer.
+ *
+ * @param timer	Timer
+ * @param gen	Generation of the timer when it was put to the wheel
+ */
+static void fibril_timer_fire(fibril_timer_t *timer, unsigned int gen)
+{
+	fibril_mutex_lock(timer->lockp);
+
+	/* Skip the timer if it was cleared or set again meanwhile. */
+	if (timer->state == fts_active && timer->gen == gen) {
+		timer->state = fts_fired;
+		timer->handler_fid = fibril_get_id();
+		fibril_mutex_unlock(timer->lockp);
+		timer->fun(timer->arg);
+		fibril_mutex_lock(timer->lockp);
+		timer->handler_fid = 0;
+		fibril_condvar_broadcast(&timer->cv);
+	}
+
+	fibril_mutex_unlock(timer->lockp);
+}
+
 /** Timer fibril.
  *
- * @param arg	Timer
+ * Fires the expired timers and sleeps until the next one expires.
+ *
+ * @param arg	Not used
  */
 static errno_t fibril_timer_func(void *arg)
 {
-	fibril_timer_t *timer = (fibril_timer_t *) arg;
-	errno_t rc;
+	list_t expired;
+
+	list_initialize(&expired);
+	fibril_mutex_lock(&timer_lock);
+
+	while (true) {
+		uint64_t now = timer_now();
+		twheel_advance(&timer_wheel, now, &expired);
+
+		if (!list_empty(&expired)) {
+			/*
+			 * Timers cleared meanwhile are removed from the list
+			 * by fibril_timer_clear_locked().
+			 */
+			while (!list_empty(&expired)) {
+				fibril_timer_t *timer = list_get_instance(
+				    list_first(&expired), fibril_timer_t,
+				    wheel.link);
+				list_remove(&timer->wheel.link);
+
+				unsigned int gen = timer->wheel_gen;
+				timer->refs++;
+				fibril_mutex_unlock(&timer_lock);
+
+				fibril_timer_fire(timer, gen);
+
+				fibril_mutex_lock(&timer_lock);
+				timer->refs--;
+				if (timer->refs == 0)
+					fibril_condvar_broadcast(&timer_release_cv);
+			}
 
-	fibril_mutex_lock(timer->lockp);
+			continue;
+		}
 
-	while (timer->state != fts_cleanup) {
-		switch (timer->state) {
-		case fts_not_set:
-		case fts_fired:
-			fibril_condvar_wait(&timer->cv, timer->lockp);
-			break;
-		case fts_active:
-			rc = fibril_condvar_wait_timeout(&timer->cv,
-			    timer->lockp, timer->delay);
-			if (rc == ETIMEOUT && timer->state == fts_active) {
-				timer->state = fts_fired;
-				timer->handler_fid = fibril_get_id();
-				fibril_mutex_unlock(timer->lockp);
-				timer->fun(timer->arg);
-				fibril_mutex_lock(timer->lockp);
-				timer->handler_fid = 0;
-			}
-			break;
-		case fts_cleanup:
-		case fts_clean:
-			assert(false);
-			break;
+		uint64_t next;
+		if (!twheel_next(&timer_wheel, &next)) {
+			timer_wakeup = UINT64_MAX;
+			fibril_condvar_wait(&timer_cv, &timer_lock);
+		} else if (next > now) {
+			timer_wakeup = next;
+			(void) fibril_condvar_wait_timeout(&timer_cv, &timer_lock,
+			    next - now);
 		}
 	}
 
-	/* Acknowledge timer fibril has finished cleanup. */
-	timer->state = fts_clean;
-	fibril_condvar_broadcast(&timer->cv);
-	fibril_mutex_unlock(timer->lockp);
-
-	return 0;
+	return EOK;
 }
 
 /** Create new timer.
@@ -516,27 +603,34 @@ static errno_t fibril_timer_func(void *arg)
  */
 fibril_timer_t *fibril_timer_create(fibril_mutex_t *lock)
 {
-	fid_t fid;
 	fibril_timer_t *timer;
 
 	timer = calloc(1, sizeof(fibril_timer_t));
 	if (timer == NULL)
 		return NULL;
 
-	fid = fibril_create(fibril_timer_func, (void *) timer);
-	if (fid == 0) {
-		free(timer);
-		return NULL;
+	fibril_mutex_lock(&timer_lock);
+
+	if (timer_fibril == 0) {
+		timer_fibril = fibril_create(fibril_timer_func, NULL);
+		if (timer_fibril == 0) {
+			fibril_mutex_unlock(&timer_lock);
+			free(timer);
+			return NULL;
+		}
+
+		twheel_initialize(&timer_wheel, timer_now());
+		fibril_add_ready(timer_fibril);
 	}
 
+	fibril_mutex_unlock(&timer_lock);
+
 	fibril_mutex_initialize(&timer->lock);
 	fibril_condvar_initialize(&timer->cv);
 
-	timer->fibril = fid;
 	timer->state = fts_not_set;
 	timer->lockp = (lock != NULL) ? lock : &timer->lock;
 
-	fibril_add_ready(fid);
 	return timer;
 }
 
@@ -548,16 +642,14 @@ void fibril_timer_destroy(fibril_timer_t *timer)
 {
 	fibril_mutex_lock(timer->lockp);
 	assert(timer->state == fts_not_set || timer->state == fts_fired);
-
-	/* Request timer fibril to terminate. */
-	timer->state = fts_cleanup;
-	fibril_condvar_broadcast(&timer->cv);
-
-	/* Wait for timer fibril to terminate */
-	while (timer->state != fts_clean)
-		fibril_condvar_wait(&timer->cv, timer->lockp);
 	fibril_mutex_unlock(timer->lockp);
 
+	/* Wait for the timer fibril to let go of the timer. */
+	fibril_mutex_lock(&timer_lock);
+	while (timer->refs > 0)
+		fibril_condvar_wait(&timer_release_cv, &timer_lock);
+	fibril_mutex_unlock(&timer_lock);
+
 	free(timer);
 }
 
@@ -595,10 +687,29 @@ void fibril_timer_set_locked(fibril_timer_t *timer, usec_t delay,
 	assert(fibril_mutex_is_locked(timer->lockp));
 	assert(timer->state == fts_not_set || timer->state == fts_fired);
 	timer->state = fts_active;
+	timer->gen++;
 	timer->delay = delay;
 	timer->fun = fun;
 	timer->arg = arg;
-	fibril_condvar_broadcast(&timer->cv);
+
+	uint64_t now = timer_now();
+	uint64_t expires = now + ((delay > 0) ? (uint64_t) delay : 0);
+
+	fibril_mutex_lock(&timer_lock);
+
+	if (twheel_empty(&timer_wheel))
+		twheel_restart(&timer_wheel, now);
+
+	timer->wheel_gen = timer->gen;
+	twheel_insert(&timer_wheel, &timer->wheel, expires);
+
+	/* Wake up the timer fibril if it would sleep past the new timer. */
+	if (expires < timer_wakeup) {
+		timer_wakeup = expires;
+		fibril_condvar_signal(&timer_cv);
+	}
+
+	fibril_mutex_unlock(&timer_lock);
 }
 
 /** Clear timer.
@@ -656,6 +767,11 @@ fibril_timer_state_t fibril_timer_clear_locked(fibril_timer_t *timer)
 
 	old_state = timer->state;
 	timer->state = fts_not_set;
+	timer->gen++;
+
+	fibril_mutex_lock(&timer_lock);
+	twheel_remove(&timer_wheel, &timer->wheel);
+	fibril_mutex_unlock(&timer_lock);
 
 	timer->delay = 0;
 	timer->fun = NULL;
@@ -806,5 +922,118 @@ void fibril_semaphore_close(fibril_semaphore_t *sem)
 	futex_unlock(&fibril_synch_futex);
 }
 
+static park_bucket_t *park_bucket(const void *addr)
+{
+	size_t key = (uintptr_t) addr;
+
+	key ^= key >> 6;
+	key ^= key >> 12;
+	return &park_buckets[key % PARK_BUCKETS];
+}
+
+/**
+ * Put the fibril to sleep on an arbitrary address.
+ *
+ * This is the fibril counterpart of a futex wait. Sleeping fibrils are kept
+ * in a small hash table indexed by the address, so unrelated addresses
+ * rarely contend with each other, and the runner thread is never blocked
+ * in the kernel.
+ *
+ * The @a validate callback runs with the bucket of @a addr locked. If it
+ * returns false, the fibril does not sleep at all. A wakeup issued after
+ * the waited-for condition changed therefore cannot be lost. The callback
+ * must not block.
+ *
+ * @param addr      Address to sleep on.
+ * @param validate  Callback deciding whether to sleep or NULL.
+ * @param arg       Argument passed to @a validate.
+ * @param expires   Absolute uptime deadline or NULL to sleep forever.
+ *
+ * @return EOK if woken up by fibril_unpark().
+ * @return EAGAIN if @a validate returned false.
+ * @return ETIMEOUT if the deadline passed.
+ */
+errno_t fibril_park(const void *addr, fibril_park_validate_t validate,
+    void *arg, const struct timespec *expires)
+{
+	park_bucket_t *bucket = park_bucket(addr);
+
+	/*
+	 * Announce ourselves before looking at the condition, so that
+	 * fibril_unpark() either sees us or we see the changed condition.
+	 */
+	atomic_fetch_add(&bucket->parked, 1);
+	futex_lock(&bucket->futex);
+
+	if (validate && !validate(arg)) {
+		futex_unlock(&bucket->futex);
+		atomic_fetch_sub(&bucket->parked, 1);
+		return EAGAIN;
+	}
+
+	park_waiter_t waiter = { .addr = addr };
+	list_append(&waiter.link, &bucket->waiters);
+
+	futex_unlock(&bucket->futex);
+
+	errno_t rc = fibril_wait_timeout(&waiter.event, expires);
+	if (rc != EOK) {
+		futex_lock(&bucket->futex);
+		if (link_in_use(&waiter.link))
+			list_remove(&waiter.link);
+		else
+			rc = EOK;  /* Woken up concurrently with the timeout. */
+		futex_unlock(&bucket->futex);
+	}
+
+	atomic_fetch_sub(&bucket->parked, 1);
+	return rc;
+}
+
+/**
+ * Wake up fibrils sleeping on an address.
+ *
+ * Fibrils are woken in the order they went to sleep.
+ *
+ * @param addr   Address passed to fibril_park().
+ * @param count  Maximum number of fibrils to wake, SIZE_MAX for all.
+ *
+ * @return Number of fibrils woken up.
+ */
+size_t fibril_unpark(const void *addr, size_t count)
+{
+	park_bucket_t *bucket = park_bucket(addr);
+	size_t woken = 0;
+
+	/*
+	 * Waking up nobody is the common case, so avoid the lock then.
+	 * The fence orders the caller's update of the condition before
+	 * the check, pairing with the increment in fibril_park().
+	 */
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(&bucket->parked, memory_order_relaxed) == 0)
+		return 0;
+
+	futex_lock(&bucket->futex);
+
+	link_t *link = list_first(&bucket->waiters);
+	while (link && woken < count) {
+		park_waiter_t *waiter = list_get_instance(link, park_waiter_t,
+		    link);
+		link = list_next(link, &bucket->waiters);
+
+		if (waiter->addr != addr)
+			continue;
+
+		list_remove(&waiter->link);
+		fibril_notify(&waiter->event);
+		woken++;
+	}
+
+	futex_unlock(&bucket->futex);
+
+	return woken;
+}
+
 /** @}
  */
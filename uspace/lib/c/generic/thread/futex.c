@@ -91,7 +91,7 @@ void __futex_lock(futex_t *futex, const char *name)
 	fibril_t *self = (fibril_t *) fibril_get_id();
 	DPRINTF("Locking futex %s (%p) by fibril %p.\n", name, futex, self);
 	__futex_assert_is_not_locked(futex, name);
-	futex_down(futex);
+	futex_down_spin(futex);
 
 	void *prev_owner = atomic_load_explicit(&futex->owner,
 	    memory_order_relaxed);
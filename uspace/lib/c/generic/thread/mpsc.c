@@ -177,6 +177,29 @@ errno_t mpsc_receive(mpsc_t *q, void *b, const struct timespec *expires)
 	return EOK;
 }
 
+/**
+ * Receive data from the channel without blocking.
+ *
+ * @return EAGAIN if there is no message in the queue, ENOENT if the queue is
+ * closed and there is no message left in the queue.
+ */
+errno_t mpsc_try_receive(mpsc_t *q, void *b)
+{
+	mpsc_node_t *n = q->head;
+	mpsc_node_t *new_head = __atomic_load_n(&n->next, __ATOMIC_ACQUIRE);
+	if (!new_head)
+		return EAGAIN;
+
+	if (new_head == q->close_node)
+		return ENOENT;
+
+	memcpy(b, new_head->data, q->elem_size);
+	q->head = new_head;
+
+	free(n);
+	return EOK;
+}
+
 /**
  * Close the channel.
  *
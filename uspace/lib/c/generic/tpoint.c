@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Tracepoints
+ *
+ * Lightweight binary event tracing. Events are recorded into a ring buffer
+ * shared by all threads and fibrils of the task. Recording an event takes
+ * an atomic increment to reserve a slot and no locks, so tracepoints can be
+ * left in hot paths. When the buffer is full, the oldest events are
+ * overwritten.
+ *
+ * The recorded events can be read with tpoint_read() or exported in the
+ * Chrome trace event format (which is understood by Perfetto as well)
+ * with tpoint_export().
+ */
+
+#include <errno.h>
+#include <fibril.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <task.h>
+#include <time.h>
+#include <tpoint.h>
+
+/** Tracepoint buffer slot */
+typedef struct {
+	/** Sequence number of the event stored in the slot plus one */
+	atomic_size_t seq;
+	/** Event */
+	tpoint_event_t ev;
+} tpoint_slot_t;
+
+/** Ring buffer or @c NULL if tracing is not enabled */
+static tpoint_slot_t *tpoint_buf;
+/** Number of slots in the ring buffer */
+static size_t tpoint_size;
+/** Sequence number of the next event */
+static atomic_size_t tpoint_next;
+
+/** Enable tracing.
+ *
+ * Must be called before tracepoints are hit from more than one thread.
+ *
+ * @param size Maximum number of recorded events
+ * @return EOK on success, EINVAL if @a size is zero, EBUSY if tracing
+ *         is already enabled, ENOMEM if out of memory
+ */
+errno_t tpoint_init(size_t size)
+{
+	tpoint_slot_t *buf;
+
+	if (size == 0)
+		return EINVAL;
+
+	if (tpoint_buf != NULL)
+		return EBUSY;
+
+	buf = calloc(size, sizeof(tpoint_slot_t));
+	if (buf == NULL)
+		return ENOMEM;
+
+	tpoint_size = size;
+	atomic_store(&tpoint_next, 0);
+	tpoint_buf = buf;
+	return EOK;
+}
+
+/** Disable tracing and free the recorded events.
+ *
+ * No tracepoint may be hit concurrently with this call.
+ */
+void tpoint_fini(void)
+{
+	free(tpoint_buf);
+	tpoint_buf = NULL;
+	tpoint_size = 0;
+}
+
+/** Record a tracepoint event.
+ *
+ * Does nothing if tracing is not enabled.
+ *
+ * @param tp Tracepoint
+ * @param phase Event phase
+ * @param a0 First argument
+ * @param a1 Second argument
+ * @param a2 Third argument
+ */
+void tpoint_record(const tpoint_t *tp, tpoint_phase_t phase, sysarg_t a0,
+    sysarg_t a1, sysarg_t a2)
+{
+	tpoint_slot_t *buf = tpoint_buf;
+	tpoint_slot_t *slot;
+	struct timespec ts;
+	size_t seq;
+
+	if (buf == NULL)
+		return;
+
+	getuptime(&ts);
+
+	seq = atomic_fetch_add_explicit(&tpoint_next, 1, memory_order_relaxed);
+	slot = &buf[seq % tpoint_size];
+
+	/* Invalidate the slot while we are filling it in */
+	atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	slot->ev.ts = SEC2NSEC(ts.tv_sec) + ts.tv_nsec;
+	slot->ev.tp = tp;
+	slot->ev.fid = fibril_get_id();
+	slot->ev.phase = phase;
+	slot->ev.args[0] = a0;
+	slot->ev.args[1] = a1;
+	slot->ev.args[2] = a2;
+
+	atomic_store_explicit(&slot->seq, seq + 1, memory_order_release);
+}
+
+/** Read recorded events.
+ *
+ * The most recent events are read, oldest first. Events which are being
+ * overwritten while we read them are skipped.
+ *
+ * @param events Buffer for the events
+ * @param count Capacity of the buffer (events)
+ * @return Number of events read
+ */
+size_t tpoint_read(tpoint_event_t *events, size_t count)
+{
+	tpoint_slot_t *slot;
+	size_t start, end;
+	size_t seq;
+	size_t n;
+
+	if (tpoint_buf == NULL)
+		return 0;
+
+	end = atomic_load_explicit(&tpoint_next, memory_order_acquire);
+	start = end > tpoint_size ? end - tpoint_size : 0;
+	if (end - start > count)
+		start = end - count;
+
+	n = 0;
+	for (seq = start; seq < end; seq++) {
+		slot = &tpoint_buf[seq % tpoint_size];
+
+		if (atomic_load_explicit(&slot->seq, memory_order_acquire) !=
+		    seq + 1)
+			continue;
+
+		events[n] = slot->ev;
+		atomic_thread_fence(memory_order_acquire);
+
+		/* Overwritten while we were copying it? */
+		if (atomic_load_explicit(&slot->seq, memory_order_relaxed) !=
+		    seq + 1)
+			continue;
+
+		++n;
+	}
+
+	return n;
+}
+
+/** Export recorded events in the Chrome trace event format.
+ *
+ * Fibrils are reported as threads. Tracepoint names are written out
+ * verbatim, they must not contain characters that need escaping in JSON.
+ *
+ * @param f Output file
+ * @return EOK on success, ENOMEM if out of memory, EIO on write error
+ */
+errno_t tpoint_export(FILE *f)
+{
+	static const char phase_char[] = {
+		[tpp_instant] = 'i',
+		[tpp_begin] = 'B',
+		[tpp_end] = 'E'
+	};
+	tpoint_event_t *events;
+	task_id_t pid;
+	size_t n, i;
+
+	events = calloc(tpoint_size > 0 ? tpoint_size : 1,
+	    sizeof(tpoint_event_t));
+	if (events == NULL)
+		return ENOMEM;
+
+	n = tpoint_read(events, tpoint_size);
+	pid = task_get_id();
+
+	fprintf(f, "{\"traceEvents\":[\n");
+
+	for (i = 0; i < n; i++) {
+		fprintf(f, "{\"name\":\"%s\",\"ph\":\"%c\",%s"
+		    "\"ts\":%lld.%03lld,\"pid\":%" PRIu64 ",\"tid\":%" PRIuPTR
+		    ",\"args\":{\"a0\":%" PRIun ",\"a1\":%" PRIun
+		    ",\"a2\":%" PRIun "}}%s\n",
+		    events[i].tp->name, phase_char[events[i].phase],
+		    events[i].phase == tpp_instant ? "\"s\":\"t\"," : "",
+		    events[i].ts / 1000, events[i].ts % 1000, pid,
+		    (uintptr_t) events[i].fid, events[i].args[0],
+		    events[i].args[1], events[i].args[2],
+		    i + 1 < n ? "," : "");
+	}
+
+	fprintf(f, "],\"displayTimeUnit\":\"ns\"}\n");
+	free(events);
+
+	if (ferror(f))
+		return EIO;
+
+	return EOK;
+}
+
+/** @}
+ */
@@ -33,10 +33,12 @@
  */
 
 #include <udebug.h>
+#include <errno.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <abi/ipc/methods.h>
 #include <async.h>
+#include "private/libc.h"
 
 errno_t udebug_begin(async_sess_t *sess)
 {
@@ -123,6 +125,37 @@ errno_t udebug_mem_read(async_sess_t *sess, void *buffer, uintptr_t addr, size_t
 	return rc;
 }
 
+/** Take a snapshot of memory of the debugged task.
+ *
+ * The memory is copied by the kernel and the copy is mapped read-only
+ * into our address space. It remains valid after the debugged task is
+ * resumed and must be unmapped with as_area_destroy().
+ *
+ * @param sess Debugging session.
+ * @param addr Page-aligned address in the debugged task.
+ * @param n    Number of bytes.
+ * @param dst  Place to store the address of the snapshot.
+ *
+ * @return EOK on success, an error code otherwise.
+ *
+ */
+errno_t udebug_mem_snapshot(async_sess_t *sess, uintptr_t addr, size_t n,
+    void **dst)
+{
+	sysarg_t base;
+
+	async_exch_t *exch = async_exchange_begin(sess);
+	errno_t rc = async_req_4_1(exch, IPC_M_DEBUG, UDEBUG_M_MEM_SNAPSHOT,
+	    addr, n, (sysarg_t) __progsymbols.end, &base);
+	async_exchange_end(exch);
+
+	if (rc != EOK)
+		return rc;
+
+	*dst = (void *) base;
+	return EOK;
+}
+
 errno_t udebug_args_read(async_sess_t *sess, thash_t tid, sysarg_t *buffer)
 {
 	async_exch_t *exch = async_exchange_begin(sess);
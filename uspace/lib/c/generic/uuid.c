@@ -47,29 +47,17 @@
  */
 errno_t uuid_generate(uuid_t *uuid)
 {
-	int i;
-	rndgen_t *rndgen;
 	errno_t rc;
 
-	rc = rndgen_create(&rndgen);
+	rc = rndgen_fill_local(uuid->b, uuid_bytes);
 	if (rc != EOK)
 		return EIO;
 
-	for (i = 0; i < uuid_bytes; i++) {
-		rc = rndgen_uint8(rndgen, &uuid->b[i]);
-		if (rc != EOK) {
-			rc = EIO;
-			goto error;
-		}
-	}
-
 	/* Version 4 UUID from random or pseudo-random numbers */
 	uuid->b[6] = (uuid->b[6] & 0x0f) | 0x40;
 	uuid->b[8] = (uuid->b[8] & 0x3f) | 0x80;
 
-error:
-	rndgen_destroy(rndgen);
-	return rc;
+	return EOK;
 }
 
 /** Encode UUID into binary form per RFC 4122.
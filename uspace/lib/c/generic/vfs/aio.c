@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Asynchronous file I/O.
+ *
+ * Requests are submitted to a queue without waiting for their completion
+ * and collected later, so that a single fibril can keep several reads and
+ * writes in flight. Every outstanding request owns an exchange of its own
+ * and since the VFS interface uses parallel exchanges, the requests are
+ * handled on separate VFS connections concurrently. VFS still serializes
+ * the requests on one file handle, so parallelism within a single file
+ * needs several handles, e.g. obtained by vfs_clone().
+ */
+
+#include <vfs/aio.h>
+#include <vfs/vfs.h>
+#include <adt/list.h>
+#include <assert.h>
+#include <async.h>
+#include <errno.h>
+#include <ipc/vfs.h>
+#include <macros.h>
+#include <stdlib.h>
+
+/** Create an asynchronous file I/O queue.
+ *
+ * @param depth		Maximum number of outstanding requests
+ * @param rq		Place to store pointer to the new queue
+ *
+ * @return		EOK on success, EINVAL if @a depth is zero or ENOMEM
+ */
+errno_t vfs_aio_create(size_t depth, vfs_aio_t **rq)
+{
+	vfs_aio_t *q;
+
+	if (depth == 0)
+		return EINVAL;
+
+	q = calloc(1, sizeof(vfs_aio_t));
+	if (q == NULL)
+		return ENOMEM;
+
+	q->depth = depth;
+	list_initialize(&q->outstanding);
+
+	*rq = q;
+	return EOK;
+}
+
+/** Destroy an asynchronous file I/O queue.
+ *
+ * Waits for all outstanding requests to complete. Their results are
+ * discarded.
+ *
+ * @param q		Queue or @c NULL
+ */
+void vfs_aio_destroy(vfs_aio_t *q)
+{
+	vfs_aio_req_t *req;
+
+	if (q == NULL)
+		return;
+
+	while (vfs_aio_wait(q, &req) == EOK)
+		;
+
+	free(q);
+}
+
+/** Submit an asynchronous file I/O request.
+ *
+ * The caller fills in the file, write, pos, buf, size and optionally arg
+ * fields of @a req. Requests larger than DATA_XFER_LIMIT are truncated to
+ * it, the caller learns the number of bytes transferred upon completion.
+ *
+ * @param q		Queue
+ * @param req		Request
+ *
+ * @return		EOK on success, EBUSY if the queue is full, ENOMEM
+ *			if the request could not be sent
+ */
+errno_t vfs_aio_submit(vfs_aio_t *q, vfs_aio_req_t *req)
+{
+	if (q->count >= q->depth)
+		return EBUSY;
+
+	req->rc = EOK;
+	req->nbytes = 0;
+	if (req->size > DATA_XFER_LIMIT)
+		req->size = DATA_XFER_LIMIT;
+
+	req->exch = vfs_exchange_begin();
+	if (req->exch == NULL)
+		return ENOMEM;
+
+	req->req = async_send_3(req->exch, req->write ? VFS_IN_WRITE :
+	    VFS_IN_READ, req->file, LOWER32(req->pos), UPPER32(req->pos),
+	    &req->answer);
+	if (req->req == 0) {
+		vfs_exchange_end(req->exch);
+		return ENOMEM;
+	}
+
+	if (req->write) {
+		req->data = async_data_write(req->exch, req->buf, req->size,
+		    &req->data_answer);
+	} else {
+		req->data = async_data_read(req->exch, req->buf, req->size,
+		    &req->data_answer);
+	}
+
+	if (req->data == 0) {
+		async_forget(req->req);
+		vfs_exchange_end(req->exch);
+		return ENOMEM;
+	}
+
+	list_append(&req->link, &q->outstanding);
+	q->count++;
+	return EOK;
+}
+
+/** Try to finish an outstanding request.
+ *
+ * @param req		Request
+ * @param timeout	Timeout in microseconds, negative to wait indefinitely
+ *
+ * @return		EOK if the request has completed, ETIMEOUT if not
+ */
+static errno_t vfs_aio_finish(vfs_aio_req_t *req, usec_t timeout)
+{
+	errno_t data_rc;
+	errno_t rc;
+
+	if (req->data != 0) {
+		if (timeout < 0)
+			async_wait_for(req->data, &data_rc);
+		else if (async_wait_timeout(req->data, &data_rc, timeout) != EOK)
+			return ETIMEOUT;
+
+		req->data = 0;
+		req->rc = data_rc;
+	}
+
+	if (timeout < 0)
+		async_wait_for(req->req, &rc);
+	else if (async_wait_timeout(req->req, &rc, timeout) != EOK)
+		return ETIMEOUT;
+
+	vfs_exchange_end(req->exch);
+	req->exch = NULL;
+
+	/* The VFS answer carries the more specific error. */
+	if (rc != EOK)
+		req->rc = rc;
+	if (req->rc == EOK)
+		req->nbytes = ipc_get_arg1(&req->answer);
+	return EOK;
+}
+
+/** Collect a completed request without blocking.
+ *
+ * @param q		Queue
+ * @param rreq		Place to store pointer to the completed request
+ *
+ * @return		EOK if a request was collected (its result is in its
+ *			rc and nbytes fields), EAGAIN if no request has
+ *			completed yet, ENOENT if there are no outstanding
+ *			requests
+ */
+errno_t vfs_aio_poll(vfs_aio_t *q, vfs_aio_req_t **rreq)
+{
+	if (list_empty(&q->outstanding))
+		return ENOENT;
+
+	list_foreach(q->outstanding, link, vfs_aio_req_t, req) {
+		if (vfs_aio_finish(req, 0) == EOK) {
+			list_remove(&req->link);
+			q->count--;
+			*rreq = req;
+			return EOK;
+		}
+	}
+
+	return EAGAIN;
+}
+
+/** Wait for the oldest outstanding request to complete.
+ *
+ * @param q		Queue
+ * @param rreq		Place to store pointer to the completed request
+ *
+ * @return		EOK if a request was collected (its result is in its
+ *			rc and nbytes fields), ENOENT if there are no
+ *			outstanding requests
+ */
+errno_t vfs_aio_wait(vfs_aio_t *q, vfs_aio_req_t **rreq)
+{
+	link_t *link = list_first(&q->outstanding);
+	if (link == NULL)
+		return ENOENT;
+
+	vfs_aio_req_t *req = list_get_instance(link, vfs_aio_req_t, link);
+	errno_t rc = vfs_aio_finish(req, -1);
+	assert(rc == EOK);
+	(void) rc;
+
+	list_remove(&req->link);
+	q->count--;
+	*rreq = req;
+	return EOK;
+}
+
+/** @}
+ */
@@ -40,6 +40,10 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <task.h>
 #include <ipc/services.h>
 #include <ns.h>
 #include <async.h>
@@ -127,6 +131,12 @@ static size_t cwd_size = 0;
 static FIBRIL_MUTEX_INITIALIZE(root_mutex);
 static int root_fd = -1;
 
+/** Mount point of the file system providing pipes */
+#define PIPE_MOUNT_POINT  "/pipe"
+
+/** Counter making the names of the pipes of this task unique */
+static atomic_uint pipe_counter;
+
 static errno_t get_parent_and_child(const char *path, int *parent, char **child)
 {
 	size_t size;
@@ -774,6 +784,62 @@ errno_t vfs_pass_handle(async_exch_t *vfs_exch, int file, async_exch_t *exch)
 	    0, vfs_exch);
 }
 
+/** Create a pipe
+ *
+ * The pipe is created in the pipe file system and its names are removed
+ * right away, so the pipe exists as long as the handles to its ends do. Once
+ * all handles to the write end are put, reading the read end returns the end
+ * of file. Once all handles to the read end are put, writing the write end
+ * fails with EPIPE. Both ends can be passed to other tasks.
+ *
+ * @param[out] rfd      Place to store the handle to the read end, opened
+ *                      for reading
+ * @param[out] wfd      Place to store the handle to the write end, opened
+ *                      for writing
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_pipe(int *rfd, int *wfd)
+{
+	char dir[sizeof(PIPE_MOUNT_POINT) + 32];
+	char rend[sizeof(dir) + 2];
+	char wend[sizeof(dir) + 2];
+	int r = -1;
+	int w = -1;
+	errno_t rc;
+
+	do {
+		snprintf(dir, sizeof(dir), PIPE_MOUNT_POINT "/%" PRIu64 "-%u",
+		    task_get_id(), atomic_fetch_add(&pipe_counter, 1));
+		rc = vfs_link_path(dir, KIND_DIRECTORY, NULL);
+	} while (rc == EEXIST);
+
+	if (rc != EOK)
+		return rc;
+
+	snprintf(rend, sizeof(rend), "%s/r", dir);
+	snprintf(wend, sizeof(wend), "%s/w", dir);
+
+	rc = vfs_lookup_open(wend, WALK_REGULAR, MODE_WRITE, &w);
+	if (rc == EOK)
+		rc = vfs_lookup_open(rend, WALK_REGULAR, MODE_READ, &r);
+
+	/* The ends opened so far keep the pipe alive. */
+	(void) vfs_unlink_path(rend);
+	(void) vfs_unlink_path(wend);
+	(void) vfs_unlink_path(dir);
+
+	if (rc != EOK) {
+		if (w >= 0)
+			vfs_put(w);
+		return rc;
+	}
+
+	*rfd = r;
+	*wfd = w;
+	return EOK;
+}
+
 /** Stop working with a file handle
  *
  * @param file  File handle to put
@@ -906,6 +972,53 @@ errno_t vfs_read_short(int file, aoff64_t pos, void *buf, size_t nbyte,
 	return EOK;
 }
 
+/** Read several directory entries
+ *
+ * Fill the buffer with the names of as many directory entries as fit, each
+ * terminated by a NUL character. The position is advanced past the last
+ * entry read, so it can be passed to the next call.
+ *
+ * @param file          Handle of a directory opened for reading
+ * @param[inout] pos    Position of the first entry to read
+ * @param buf           Buffer for the entry names
+ * @param size          Size of the buffer, at least VFS_DIRENT_NAME_SIZE
+ *                      to be able to read any entry
+ * @param[out] nread    Number of bytes filled in
+ *
+ * @return              EOK if at least one entry was read, ENOENT at the end
+ *                      of the directory or another error code
+ */
+errno_t vfs_readdir(int file, aoff64_t *pos, void *buf, size_t size,
+    size_t *nread)
+{
+	errno_t rc;
+	ipc_call_t answer;
+	aid_t req;
+
+	if (size > VFS_READDIR_MAX)
+		size = VFS_READDIR_MAX;
+
+	async_exch_t *exch = vfs_exchange_begin();
+
+	req = async_send_3(exch, VFS_IN_READDIR, file, LOWER32(*pos),
+	    UPPER32(*pos), &answer);
+	rc = async_data_read_start(exch, buf, size);
+
+	vfs_exchange_end(exch);
+
+	errno_t rc_orig;
+	async_wait_for(req, &rc_orig);
+
+	if (rc_orig != EOK)
+		return rc_orig;
+	if (rc != EOK)
+		return rc;
+
+	*nread = ipc_get_arg1(&answer);
+	*pos = MERGE_LOUP32(ipc_get_arg2(&answer), ipc_get_arg3(&answer));
+	return EOK;
+}
+
 /** Rename a file or directory
  *
  * There is no file-handle-based variant to disallow attempts to introduce loops
@@ -1143,6 +1256,28 @@ errno_t vfs_statfs_path(const char *path, vfs_statfs_t *st)
 	return rc;
 }
 
+/** Get statistics of the VFS server
+ *
+ * @param[out] stats    Buffer for storing the statistics
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_server_stats(vfs_server_stats_t *stats)
+{
+	errno_t rc, ret;
+	aid_t req;
+
+	async_exch_t *exch = vfs_exchange_begin();
+
+	req = async_send_0(exch, VFS_IN_STATS, NULL);
+	rc = async_data_read_start(exch, (void *) stats, sizeof(*stats));
+
+	vfs_exchange_end(exch);
+	async_wait_for(req, &ret);
+
+	return (ret != EOK ? ret : rc);
+}
+
 /** Synchronize file
  *
  * @param file  File handle to synchronize
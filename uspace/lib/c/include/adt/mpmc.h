@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Bounded lock-free multi-producer multi-consumer queue
+ */
+
+#ifndef _LIBC_MPMC_H_
+#define _LIBC_MPMC_H_
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+/** Size used to keep producer and consumer positions in separate lines */
+#define MPMC_CACHE_LINE  64
+
+/** Queue cell */
+typedef struct {
+	/** Sequence number telling whether the cell is free or full */
+	atomic_size_t seq;
+	/** Stored item */
+	void *item;
+} mpmc_cell_t;
+
+/** Bounded multi-producer multi-consumer queue of pointers */
+typedef struct {
+	/** Cells */
+	mpmc_cell_t *cells;
+	/** Number of cells minus one */
+	size_t mask;
+	char pad0[MPMC_CACHE_LINE];
+	/** Position of the next push */
+	atomic_size_t push_pos;
+	char pad1[MPMC_CACHE_LINE];
+	/** Position of the next pop */
+	atomic_size_t pop_pos;
+	char pad2[MPMC_CACHE_LINE];
+} mpmc_t;
+
+extern void mpmc_init(mpmc_t *, mpmc_cell_t *, size_t);
+extern errno_t mpmc_try_push(mpmc_t *, void *);
+extern errno_t mpmc_try_pop(mpmc_t *, void **);
+extern void mpmc_push(mpmc_t *, void *);
+extern void *mpmc_pop(mpmc_t *);
+
+#endif
+
+/** @}
+ */
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Open-addressing hash table
+ */
+
+#ifndef _LIBC_OHASH_TABLE_H_
+#define _LIBC_OHASH_TABLE_H_
+
+#include <adt/hash_table.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Slot of an open-addressing hash table. */
+typedef struct {
+	/** Mixed hash of the item, valid if item is not NULL */
+	size_t hash;
+	/** Item stored in the slot or NULL if the slot is empty */
+	ht_link_t *item;
+} ohash_slot_t;
+
+/** Open-addressing hash table structure.
+ *
+ * The table uses the same item links and operations as the chained
+ * hash_table_t, but keeps the items' hashes in a flat array of slots
+ * so that lookups do not touch items with a different hash.
+ */
+typedef struct {
+	const hash_table_ops_t *op;
+	ohash_slot_t *slot;
+	/** Number of slots, a power of two */
+	size_t slot_cnt;
+	size_t item_cnt;
+	bool apply_ongoing;
+} ohash_table_t;
+
+extern bool ohash_table_create(ohash_table_t *, size_t,
+    const hash_table_ops_t *);
+extern void ohash_table_destroy(ohash_table_t *);
+
+extern bool ohash_table_empty(ohash_table_t *);
+extern size_t ohash_table_size(ohash_table_t *);
+
+extern void ohash_table_clear(ohash_table_t *);
+extern errno_t ohash_table_insert(ohash_table_t *, ht_link_t *);
+extern errno_t ohash_table_insert_unique(ohash_table_t *, ht_link_t *);
+extern ht_link_t *ohash_table_find(const ohash_table_t *, const void *);
+extern ht_link_t *ohash_table_find_next(const ohash_table_t *, ht_link_t *,
+    ht_link_t *);
+extern size_t ohash_table_remove(ohash_table_t *, const void *);
+extern void ohash_table_remove_item(ohash_table_t *, ht_link_t *);
+extern void ohash_table_apply(ohash_table_t *, bool (*)(ht_link_t *, void *),
+    void *);
+
+#endif
+
+/** @}
+ */
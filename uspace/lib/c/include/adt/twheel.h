@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Hierarchical timer wheel
+ */
+
+#ifndef _LIBC_TWHEEL_H_
+#define _LIBC_TWHEEL_H_
+
+#include <adt/list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <_bits/decls.h>
+
+/** Resolution of the wheel, as a power of two of the time unit */
+#define TWHEEL_RES_BITS  10
+
+/** Number of levels of the wheel */
+#define TWHEEL_LEVELS  4
+
+/** Number of tick bits covered by the first level */
+#define TWHEEL_ROOT_BITS  8
+/** Number of tick bits covered by each further level */
+#define TWHEEL_LEVEL_BITS  6
+
+#define TWHEEL_ROOT_SLOTS  (1 << TWHEEL_ROOT_BITS)
+#define TWHEEL_LEVEL_SLOTS  (1 << TWHEEL_LEVEL_BITS)
+
+__HELENOS_DECLS_BEGIN;
+
+/** Timer on a timer wheel */
+typedef struct {
+	/** Link in a slot of the wheel or in a list of expired timers */
+	link_t link;
+	/** Expiration time */
+	uint64_t expires;
+	/** Level the timer is on, TWHEEL_LEVELS once expired */
+	unsigned int level;
+} twheel_timer_t;
+
+/** Hierarchical timer wheel
+ *
+ * Times are in arbitrary units, timers are sorted into ticks of
+ * 2^TWHEEL_RES_BITS units. The first level has one slot per tick, each
+ * further level has slots covering a whole rotation of the level below.
+ * Inserting and removing a timer takes constant time, timers are moved
+ * to lower levels as their expiration approaches. A timer never expires
+ * early, but may expire up to a tick late. Timers expiring in the same
+ * tick are kept in the order of their expiration time.
+ */
+typedef struct {
+	/** Last tick processed */
+	uint64_t now;
+	/** Number of timers on each level */
+	size_t count[TWHEEL_LEVELS];
+	/** Slots of the first level */
+	list_t root[TWHEEL_ROOT_SLOTS];
+	/** Slots of the further levels */
+	list_t slots[TWHEEL_LEVELS - 1][TWHEEL_LEVEL_SLOTS];
+} twheel_t;
+
+extern void twheel_initialize(twheel_t *, uint64_t);
+extern void twheel_restart(twheel_t *, uint64_t);
+extern bool twheel_empty(twheel_t *);
+extern void twheel_insert(twheel_t *, twheel_timer_t *, uint64_t);
+extern void twheel_remove(twheel_t *, twheel_timer_t *);
+extern void twheel_advance(twheel_t *, uint64_t, list_t *);
+extern bool twheel_next(twheel_t *, uint64_t *);
+
+__HELENOS_DECLS_END;
+
+#endif
+
+/** @}
+ */
@@ -104,6 +104,7 @@ struct async_sess;
 
 typedef struct async_sess async_sess_t;
 typedef struct async_exch async_exch_t;
+typedef struct async_ring async_ring_t;
 
 extern __noreturn void async_manager(void);
 
@@ -121,8 +122,12 @@ extern aid_t async_send_4(async_exch_t *, sysarg_t, sysarg_t, sysarg_t,
 extern aid_t async_send_5(async_exch_t *, sysarg_t, sysarg_t, sysarg_t,
     sysarg_t, sysarg_t, sysarg_t, ipc_call_t *);
 
+extern aid_t async_ring_send(async_exch_t *, sysarg_t, sysarg_t, sysarg_t,
+    sysarg_t, sysarg_t, sysarg_t, ipc_call_t *);
+
 extern void async_wait_for(aid_t, errno_t *);
 extern errno_t async_wait_timeout(aid_t, errno_t *, usec_t);
+extern errno_t async_wait_all(aid_t *, size_t, errno_t *);
 extern void async_forget(aid_t);
 
 extern void async_set_client_data_constructor(async_client_data_ctor_t);
@@ -134,12 +139,14 @@ extern void async_put_client_data_by_id(task_id_t);
 extern errno_t async_create_port(iface_t, async_port_handler_t, void *,
     port_id_t *);
 extern void async_set_fallback_port_handler(async_port_handler_t, void *);
+extern errno_t async_ring_enable(iface_t);
 extern errno_t async_create_callback_port(async_exch_t *, iface_t, sysarg_t,
     sysarg_t, async_port_handler_t, void *, port_id_t *);
 
 extern errno_t async_irq_subscribe(int, async_notification_handler_t, void *,
     const irq_code_t *, cap_irq_handle_t *);
 extern errno_t async_irq_unsubscribe(cap_irq_handle_t);
+extern errno_t async_irq_set_affinity(cap_irq_handle_t, unsigned int);
 
 extern errno_t async_event_subscribe(event_type_t, async_notification_handler_t,
     void *);
@@ -277,11 +284,17 @@ extern async_sess_t *async_connect_me_to(async_exch_t *, iface_t, sysarg_t,
     sysarg_t, errno_t *);
 extern async_sess_t *async_connect_me_to_blocking(async_exch_t *, iface_t,
     sysarg_t, sysarg_t, errno_t *);
+extern aid_t async_connect_me_to_send(async_exch_t *, iface_t, sysarg_t,
+    sysarg_t, bool, ipc_call_t *);
+extern async_sess_t *async_connect_me_to_wait(aid_t, ipc_call_t *, iface_t,
+    sysarg_t, sysarg_t, errno_t *);
+extern async_sess_t *async_reconnect(async_sess_t *, errno_t *);
 extern async_sess_t *async_connect_kbox(task_id_t, errno_t *);
 
 extern errno_t async_connect_to_me(async_exch_t *, iface_t, sysarg_t, sysarg_t);
 
 extern void async_hangup(async_sess_t *);
+extern errno_t async_ring_attach(async_sess_t *, size_t);
 
 extern async_exch_t *async_exchange_begin(async_sess_t *);
 extern void async_exchange_end(async_exch_t *);
@@ -356,6 +369,8 @@ extern errno_t async_data_write_forward_3_1(async_exch_t *, sysarg_t, sysarg_t,
 extern errno_t async_data_write_forward_4_1(async_exch_t *, sysarg_t, sysarg_t,
     sysarg_t, sysarg_t, sysarg_t, ipc_call_t *);
 
+extern aid_t async_data_write(async_exch_t *, const void *, size_t,
+    ipc_call_t *);
 extern errno_t async_data_write_start(async_exch_t *, const void *, size_t);
 extern bool async_data_write_receive(ipc_call_t *, size_t *);
 extern errno_t async_data_write_finalize(ipc_call_t *, void *, size_t);
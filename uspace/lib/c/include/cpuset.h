@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _LIBC_CPUSET_H_
+#define _LIBC_CPUSET_H_
+
+#include <abi/proc/cpuset.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Maximum number of processors a CPU set can describe. */
+#define CPUSET_CPUS_MAX  256
+
+/** Set of processors. */
+typedef struct {
+	/** Bit i of byte j stands for processor 8 * j + i. */
+	uint8_t bits[CPUSET_CPUS_MAX / 8];
+} cpuset_t;
+
+extern void cpuset_clear(cpuset_t *);
+extern void cpuset_add(cpuset_t *, unsigned int);
+extern void cpuset_remove(cpuset_t *, unsigned int);
+extern bool cpuset_contains(const cpuset_t *, unsigned int);
+extern unsigned int cpuset_count(const cpuset_t *);
+
+extern errno_t cpuset_set_thread(const cpuset_t *);
+extern errno_t cpuset_set_task(const cpuset_t *);
+extern errno_t cpuset_get_thread(cpuset_t *);
+extern errno_t cpuset_get_task(cpuset_t *);
+
+#endif
+
+/** @}
+ */
@@ -51,5 +51,7 @@ struct ieee_double_t_tag;
 extern int double_to_short_str(struct ieee_double_t_tag, char *, size_t, int *);
 extern int double_to_fixed_str(struct ieee_double_t_tag, int, int, char *,
     size_t, int *);
+extern int double_to_rounded_str(struct ieee_double_t_tag, int, int, char *,
+    size_t, int *);
 
 #endif
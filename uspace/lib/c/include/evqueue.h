@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Readiness event queue
+ */
+
+#ifndef _LIBC_EVQUEUE_H_
+#define _LIBC_EVQUEUE_H_
+
+#include <adt/list.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+/** Readiness events */
+typedef enum {
+	/** Data can be read */
+	EVQUEUE_READ = 0x1,
+	/** Data can be written */
+	EVQUEUE_WRITE = 0x2,
+	/** Source was closed, reset or failed */
+	EVQUEUE_HUP = 0x4
+} evqueue_events_t;
+
+struct evqueue;
+
+/** Source of readiness events.
+ *
+ * The source is embedded in the object that reports readiness (a TCP
+ * connection, UDP association, etc.) and is registered with at most one
+ * event queue at a time.
+ */
+typedef struct {
+	/** Event queue the source is registered with or @c NULL */
+	struct evqueue *evq;
+	/** Link to evqueue_t.ready */
+	link_t lready;
+	/** Events the event queue user is interested in */
+	unsigned int mask;
+	/** Events that occurred but have not been delivered yet */
+	unsigned int pending;
+	/** User argument returned with the events */
+	void *arg;
+} evqueue_src_t;
+
+/** Event delivered by evqueue_wait() */
+typedef struct {
+	/** Events that occurred */
+	unsigned int events;
+	/** User argument of the source */
+	void *arg;
+} evqueue_event_t;
+
+/** Readiness event queue */
+typedef struct evqueue {
+	/** Sources with pending events */
+	list_t ready; /* of evqueue_src_t */
+	/** Signalled when a source becomes ready */
+	fibril_condvar_t cv;
+	/** Number of registered sources */
+	size_t nsrcs;
+} evqueue_t;
+
+extern errno_t evqueue_create(evqueue_t **);
+extern void evqueue_destroy(evqueue_t *);
+extern errno_t evqueue_add(evqueue_t *, evqueue_src_t *, unsigned int, void *);
+extern void evqueue_modify(evqueue_src_t *, unsigned int);
+extern void evqueue_remove(evqueue_src_t *);
+extern errno_t evqueue_wait(evqueue_t *, evqueue_event_t *, size_t, usec_t,
+    size_t *);
+
+extern void evqueue_src_init(evqueue_src_t *);
+extern void evqueue_src_notify(evqueue_src_t *, unsigned int);
+
+#endif
+
+/** @}
+ */
@@ -37,6 +37,7 @@
 
 #include <time.h>
 #include <_bits/errno.h>
+#include <_bits/size_t.h>
 #include <_bits/__noreturn.h>
 #include <_bits/decls.h>
 
@@ -50,6 +51,18 @@ typedef struct {
 
 typedef fibril_t *fid_t;
 
+/** Statistics of the fibril stack pool. */
+typedef struct {
+	/** Stacks taken from the pool. */
+	size_t hits;
+	/** Stacks of the default size created because the pool was empty. */
+	size_t misses;
+	/** Stacks of the default size destroyed because the pool was full. */
+	size_t destroyed;
+	/** Stacks currently in the pool. */
+	size_t pooled;
+} fibril_stack_stats_t;
+
 #ifndef __cplusplus
 /** Fibril-local variable specifier */
 #define fibril_local __thread
@@ -58,6 +71,7 @@ typedef fibril_t *fid_t;
 extern fid_t fibril_create_generic(errno_t (*)(void *), void *, size_t);
 extern fid_t fibril_create(errno_t (*)(void *), void *);
 extern void fibril_destroy(fid_t);
+extern void fibril_stack_stats(fibril_stack_stats_t *);
 extern void fibril_add_ready(fid_t);
 extern fid_t fibril_get_id(void);
 extern void fibril_yield(void);
@@ -67,6 +81,7 @@ extern void fibril_sleep(sec_t);
 
 extern void fibril_enable_multithreaded(void);
 extern int fibril_test_spawn_runners(int);
+extern int fibril_get_runner_count(void);
 
 extern void fibril_detach(fid_t fid);
 
@@ -37,6 +37,7 @@
 
 #include <fibril.h>
 #include <adt/list.h>
+#include <adt/twheel.h>
 #include <time.h>
 #include <stdbool.h>
 #include <_bits/decls.h>
@@ -127,13 +128,25 @@ typedef enum {
  * fibril) after a specified time interval. The timer can be cleared
  * (canceled) before that. From the return value of fibril_timer_clear()
  * one can tell whether the timer fired or not.
+ *
+ * All timers are kept on one timer wheel and their callbacks are executed
+ * one after another by a single timer fibril.
  */
 typedef struct {
 	fibril_mutex_t lock;
 	fibril_mutex_t *lockp;
 	fibril_condvar_t cv;
-	fid_t fibril;
 	fibril_timer_state_t state;
+	/** Incremented each time the timer is set or cleared */
+	unsigned int gen;
+
+	/** Entry in the timer wheel, protected by the timer wheel lock */
+	twheel_timer_t wheel;
+	/** Value of @c gen when the timer was put to the timer wheel */
+	unsigned int wheel_gen;
+	/** Number of references held by the timer fibril */
+	unsigned int refs;
+
 	/** FID of fibril executing handler or 0 if handler is not running */
 	fid_t handler_fid;
 
@@ -189,11 +202,19 @@ extern void fibril_semaphore_down(fibril_semaphore_t *);
 extern errno_t fibril_semaphore_down_timeout(fibril_semaphore_t *, usec_t);
 extern void fibril_semaphore_close(fibril_semaphore_t *);
 
+/** Callback deciding whether fibril_park() should really go to sleep. */
+typedef bool (*fibril_park_validate_t)(void *);
+
+extern errno_t fibril_park(const void *, fibril_park_validate_t, void *,
+    const struct timespec *);
+extern size_t fibril_unpark(const void *, size_t);
+
 typedef struct mpsc mpsc_t;
 extern mpsc_t *mpsc_create(size_t);
 extern void mpsc_destroy(mpsc_t *);
 extern errno_t mpsc_send(mpsc_t *, const void *);
 extern errno_t mpsc_receive(mpsc_t *, void *, const struct timespec *);
+extern errno_t mpsc_try_receive(mpsc_t *, void *);
 extern void mpsc_close(mpsc_t *);
 
 __HELENOS_DECLS_END;
@@ -59,6 +59,8 @@ typedef struct {
 	char_attrs_t attrs;     /**< Current attributes */
 
 	sysarg_t top_row;       /**< The first row in the cyclic buffer */
+	sysarg_t dirty_r0;      /**< First row with dirty fields */
+	sysarg_t dirty_r1;      /**< Row after the last row with dirty fields */
 	charfield_t data[];     /**< Screen contents (cyclic buffer) */
 } chargrid_t;
 
@@ -78,6 +80,10 @@ extern bool chargrid_cursor_at(chargrid_t *, sysarg_t, sysarg_t);
 
 extern sysarg_t chargrid_get_top_row(chargrid_t *);
 
+extern void chargrid_get_dirty_rows(chargrid_t *, sysarg_t *, sysarg_t *);
+extern void chargrid_set_dirty_rows(chargrid_t *, sysarg_t, sysarg_t);
+extern void chargrid_reset_dirty_rows(chargrid_t *);
+
 extern sysarg_t chargrid_putuchar(chargrid_t *, char32_t, bool);
 extern sysarg_t chargrid_newline(chargrid_t *);
 extern sysarg_t chargrid_tabstop(chargrid_t *, sysarg_t);
@@ -85,6 +91,7 @@ extern sysarg_t chargrid_backspace(chargrid_t *);
 
 extern void chargrid_clear(chargrid_t *);
 extern void chargrid_clear_row(chargrid_t *, sysarg_t);
+extern void chargrid_scroll_up(chargrid_t *, sysarg_t);
 
 extern void chargrid_set_cursor(chargrid_t *, sysarg_t, sysarg_t);
 extern void chargrid_set_cursor_visibility(chargrid_t *, bool);
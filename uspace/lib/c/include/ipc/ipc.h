@@ -46,6 +46,8 @@
 #include <abi/cap.h>
 
 extern errno_t ipc_wait(ipc_call_t *, sysarg_t, unsigned int);
+extern errno_t ipc_wait_batch(ipc_call_t *, size_t, size_t *, sysarg_t,
+    unsigned int);
 extern void ipc_poke(void);
 
 /*
@@ -73,6 +75,7 @@ extern errno_t ipc_answer_fast(cap_call_handle_t, errno_t, sysarg_t, sysarg_t,
     sysarg_t, sysarg_t);
 extern errno_t ipc_answer_slow(cap_call_handle_t, errno_t, sysarg_t, sysarg_t,
     sysarg_t, sysarg_t, sysarg_t);
+extern errno_t ipc_answer_batch(ipc_call_t *, size_t);
 
 /*
  * User-friendly wrappers for ipc_call_async_fast() and ipc_call_async_slow().
@@ -68,7 +68,8 @@ typedef enum {
 	LOC_GET_SERVICE_COUNT,
 	LOC_GET_CATEGORIES,
 	LOC_GET_NAMESPACES,
-	LOC_GET_SERVICES
+	LOC_GET_SERVICES,
+	LOC_CATEGORY_GET_SVC_DESCS
 } loc_request_t;
 
 typedef enum {
@@ -80,6 +81,15 @@ typedef struct {
 	char name[LOC_NAME_MAXLEN + 1];
 } loc_sdesc_t;
 
+/** Service in a category, as returned by LOC_CATEGORY_GET_SVC_DESCS */
+typedef struct {
+	service_id_t id;
+	/** Fully qualified service name */
+	char name[LOC_NAME_MAXLEN + 1];
+	/** Name of the server supplying the service (empty if none) */
+	char server[LOC_NAME_MAXLEN + 1];
+} loc_svc_desc_t;
+
 #endif
 
 /** @}
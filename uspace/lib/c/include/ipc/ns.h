@@ -36,6 +36,9 @@
 #define _LIBC_IPC_NS_H_
 
 #include <ipc/common.h>
+#include <ipc/services.h>
+#include <abi/ipc/interfaces.h>
+#include <stdbool.h>
 
 typedef enum {
 	NS_PING = IPC_FIRST_USER_METHOD,
@@ -46,6 +49,15 @@ typedef enum {
 	NS_RETVAL
 } ns_request_t;
 
+/** Return true if connections to @a service spawn a new server instance.
+ *
+ * Connections to clonable services cannot be reused for reconnecting.
+ */
+static inline bool service_is_clonable(service_t service, iface_t iface)
+{
+	return (service == SERVICE_LOADER) && (iface == INTERFACE_LOADER);
+}
+
 #endif
 
 /** @}
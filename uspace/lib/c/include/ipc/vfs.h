@@ -46,6 +46,11 @@
 #define MAX_MNTOPTS_LEN 256
 #define PLB_SIZE        (2 * MAX_PATH_LEN)
 
+/** Size of a directory entry name including the terminating NUL */
+#define VFS_DIRENT_NAME_SIZE 256
+/** Maximum number of bytes returned by one VFS_IN_READDIR request */
+#define VFS_READDIR_MAX (16 * 1024)
+
 /* Basic types. */
 typedef int16_t fs_handle_t;
 typedef uint32_t fs_index_t;
@@ -61,6 +66,10 @@ typedef struct {
 	unsigned int instance;
 	bool concurrent_read_write;
 	bool write_retains_size;
+	/** VFS may cache the contents of regular files. */
+	bool page_cache;
+	/** Names only change through VFS, so VFS may cache lookups. */
+	bool name_cache;
 } vfs_info_t;
 
 /** Data returned by filesystem probe regarding a specific volume. */
@@ -77,11 +86,13 @@ typedef enum {
 	VFS_IN_OPEN,
 	VFS_IN_PUT,
 	VFS_IN_READ,
+	VFS_IN_READDIR,
 	VFS_IN_REGISTER,
 	VFS_IN_RENAME,
 	VFS_IN_RESIZE,
 	VFS_IN_STAT,
 	VFS_IN_STATFS,
+	VFS_IN_STATS,
 	VFS_IN_SYNC,
 	VFS_IN_UNLINK,
 	VFS_IN_UNMOUNT,
@@ -187,6 +198,8 @@ enum {
 	MODE_READ = 1,
 	MODE_WRITE = 2,
 	MODE_APPEND = 4,
+	/** Bypass the page cache when reading. */
+	MODE_DIRECT = 8,
 };
 
 #endif
@@ -56,6 +56,18 @@ void sincosl(long double, long double *, long double *);
 
 #endif
 
+#ifdef _HELENOS_SOURCE
+
+/* Batch variants evaluating the function over whole arrays. */
+void sin_v(const double *, double *, size_t);
+void sinf_v(const float *, float *, size_t);
+void cos_v(const double *, double *, size_t);
+void cosf_v(const float *, float *, size_t);
+void sincos_v(const double *, double *, double *, size_t);
+void sincosf_v(const float *, float *, float *, size_t);
+
+#endif
+
 #if FLT_EVAL_METHOD == 0
 typedef float float_t;
 typedef double double_t;
@@ -38,6 +38,21 @@
 #include <ipc/services.h>
 #include <task.h>
 #include <async.h>
+#include <stdbool.h>
+
+/** Connection request for service_connect_batch(). */
+typedef struct {
+	/** Singleton service ID */
+	service_t service;
+	/** Interface to connect to */
+	iface_t iface;
+	/** Custom connection argument */
+	sysarg_t arg3;
+	/** New session or NULL on error */
+	async_sess_t *sess;
+	/** Return code of this connection */
+	errno_t rc;
+} service_conn_t;
 
 extern errno_t service_register(service_t, iface_t, async_port_handler_t,
     void *);
@@ -45,6 +60,7 @@ extern errno_t service_register_broker(service_t, async_port_handler_t, void *);
 extern async_sess_t *service_connect(service_t, iface_t, sysarg_t, errno_t *);
 extern async_sess_t *service_connect_blocking(service_t, iface_t, sysarg_t,
     errno_t *);
+extern errno_t service_connect_batch(service_conn_t *, size_t, bool);
 
 extern errno_t ns_ping(void);
 extern errno_t ns_intro(task_id_t);
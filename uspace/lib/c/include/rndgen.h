@@ -36,17 +36,35 @@
 #define _LIBC_RNDGEN_H_
 
 #include <errno.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 
+/** Size of the generator seed in bytes */
+#define RNDGEN_SEED_SIZE  32
+
+/** Size of one generator output block in bytes */
+#define RNDGEN_BLOCK_SIZE  64
+
+/** ChaCha20 based random number generator */
 typedef struct {
-	unsigned int seed;
+	/** ChaCha20 key */
+	uint32_t key[8];
+	/** Block counter */
+	uint64_t counter;
+	/** Buffered output */
+	uint8_t buf[RNDGEN_BLOCK_SIZE];
+	/** Number of unused bytes at the end of @c buf */
+	size_t avail;
 } rndgen_t;
 
 extern errno_t rndgen_create(rndgen_t **);
+extern errno_t rndgen_create_seeded(rndgen_t **, const uint8_t *);
 extern void rndgen_destroy(rndgen_t *);
 extern errno_t rndgen_uint8(rndgen_t *, uint8_t *);
 extern errno_t rndgen_uint32(rndgen_t *, uint32_t *);
+extern errno_t rndgen_fill(rndgen_t *, void *, size_t);
+extern errno_t rndgen_fill_local(void *, size_t);
 
 #endif
 
@@ -39,6 +39,7 @@
 #include <loader/pcb.h>
 
 void module_process_pre_arch(module_t *m);
+bool module_plt_lazy_arch(module_t *m);
 
 void rel_table_process(module_t *m, elf_rel_t *rt, size_t rt_size);
 void rela_table_process(module_t *m, elf_rela_t *rt, size_t rt_size);
@@ -49,16 +49,35 @@ extern load_t *stats_get_load(size_t *);
 
 extern stats_task_t *stats_get_tasks(size_t *);
 extern stats_task_t *stats_get_task(task_id_t);
+extern stats_task_ipc_t *stats_get_task_ipc(task_id_t);
 
 extern stats_thread_t *stats_get_threads(size_t *);
+extern stats_delta_t *stats_get_threads_delta(uint64_t);
+extern const stats_page_t *stats_get_page(void);
 extern stats_ipcc_t *stats_get_ipccs(size_t *);
+extern stats_irq_t *stats_get_irqs(size_t *);
 
 extern stats_exc_t *stats_get_exceptions(size_t *);
 extern stats_exc_t *stats_get_exception(unsigned int);
 
+extern stats_slab_t *stats_get_slabs(size_t *);
+extern stats_lock_t *stats_get_locks(size_t *);
+
 extern void stats_print_load_fragment(load_t, unsigned int);
 extern const char *thread_get_state(state_t);
 
+/** Get thread statistics following a delta header.
+ *
+ * @param delta Thread statistics delta.
+ *
+ * @return Array of @c delta->count stats_thread_t structures.
+ *
+ */
+static inline stats_thread_t *stats_delta_threads(stats_delta_t *delta)
+{
+	return (stats_thread_t *) (delta + 1);
+}
+
 #endif
 
 /** @}
@@ -76,6 +76,8 @@ typedef struct {
 	long long rem;
 } lldiv_t;
 
+extern float strtof(const char *__restrict__, char **__restrict__);
+extern double strtod(const char *__restrict__, char **__restrict__);
 extern long double strtold(const char *, char **);
 
 extern int rand(void);
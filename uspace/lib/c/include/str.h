@@ -68,6 +68,8 @@ __HELENOS_DECLS_BEGIN;
 
 extern char32_t str_decode(const char *str, size_t *offset, size_t sz);
 extern char32_t str_decode_reverse(const char *str, size_t *offset, size_t sz);
+extern size_t str_decode_buf(const char *str, size_t *offset, size_t sz,
+    char32_t *buf, size_t count);
 extern errno_t chr_encode(char32_t ch, char *str, size_t *offset, size_t sz);
 
 extern size_t str_size(const char *str);
@@ -90,6 +92,7 @@ extern size_t str_width(const char *str);
 
 extern bool ascii_check(char32_t ch);
 extern bool chr_check(char32_t ch);
+extern bool str_check(const char *str, size_t size);
 
 extern int str_cmp(const char *s1, const char *s2);
 extern int str_lcmp(const char *s1, const char *s2, size_t max_len);
@@ -115,6 +118,7 @@ extern size_t utf16_wsize(const uint16_t *ustr);
 extern char *str_chr(const char *str, char32_t ch);
 extern char *str_rchr(const char *str, char32_t ch);
 extern char *str_str(const char *hs, const char *n);
+extern char *str_casestr(const char *hs, const char *n);
 
 extern void str_rtrim(char *str, char32_t ch);
 extern void str_ltrim(char *str, char32_t ch);
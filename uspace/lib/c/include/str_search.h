@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _LIBC_STR_SEARCH_H_
+#define _LIBC_STR_SEARCH_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <_bits/decls.h>
+
+__HELENOS_DECLS_BEGIN;
+
+/** Prepared substring search
+ *
+ * Boyer-Moore-Horspool shift tables for one pattern, which can then be
+ * looked for in any number of buffers in either direction.
+ */
+typedef struct {
+	/** Pattern, it is not copied */
+	const char *pattern;
+	/** Size of the pattern in bytes */
+	size_t size;
+	/** Compare ASCII letters regardless of case */
+	bool icase;
+	/** Forward shift for each value of the last byte of the window */
+	size_t shift[256];
+	/** Backward shift for each value of the first byte of the window */
+	size_t rshift[256];
+} str_search_t;
+
+extern void str_search_init(str_search_t *, const char *, bool);
+extern const char *str_search_first(const str_search_t *, const char *,
+    size_t);
+extern const char *str_search_last(const str_search_t *, const char *,
+    size_t);
+extern const char *str_search_mem(const char *, size_t, const char *, size_t,
+    bool);
+
+__HELENOS_DECLS_END;
+
+#endif
+
+/** @}
+ */
@@ -39,6 +39,7 @@
 #include <stdint.h>
 #include <stdarg.h>
 #include <abi/proc/task.h>
+#include <abi/proc/thread.h>
 #include <async.h>
 #include <types/task.h>
 
@@ -53,6 +54,7 @@ typedef struct _TASK task_t;
 extern task_id_t task_get_id(void);
 extern errno_t task_set_name(const char *);
 extern errno_t task_kill(task_id_t);
+extern errno_t task_set_sched_class(sched_class_t);
 
 extern errno_t task_spawnv(task_id_t *, task_wait_t *, const char *path,
     const char *const []);
@@ -71,6 +73,8 @@ extern errno_t task_setup_wait(task_id_t, task_wait_t *);
 extern void task_cancel_wait(task_wait_t *);
 extern errno_t task_wait(task_wait_t *, task_exit_t *, int *);
 extern errno_t task_wait_task_id(task_id_t, task_exit_t *, int *);
+extern errno_t task_clone(task_id_t *, const char *, int (*)(void *),
+    void *);
 extern errno_t task_retval(int);
 
 #endif
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Tracepoints
+ */
+
+#ifndef _LIBC_TPOINT_H_
+#define _LIBC_TPOINT_H_
+
+#include <errno.h>
+#include <fibril.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <types/common.h>
+
+/** Tracepoint event phase (as in the Chrome trace event format) */
+typedef enum {
+	/** Instant event */
+	tpp_instant,
+	/** Beginning of a duration */
+	tpp_begin,
+	/** End of a duration */
+	tpp_end
+} tpoint_phase_t;
+
+/** Tracepoint.
+ *
+ * Tracepoints are defined statically with TPOINT_DEFINE() and identified
+ * by their address.
+ */
+typedef struct {
+	/** Tracepoint name */
+	const char *name;
+} tpoint_t;
+
+/** Number of arguments recorded with each event */
+#define TPOINT_ARGS 3
+
+/** Recorded tracepoint event */
+typedef struct {
+	/** Time of the event (uptime) */
+	nsec_t ts;
+	/** Tracepoint */
+	const tpoint_t *tp;
+	/** Fibril that hit the tracepoint */
+	fid_t fid;
+	/** Event phase */
+	tpoint_phase_t phase;
+	/** Arguments */
+	sysarg_t args[TPOINT_ARGS];
+} tpoint_event_t;
+
+#define TPOINT_DEFINE(var, tpname) \
+	tpoint_t var = { .name = tpname }
+
+extern errno_t tpoint_init(size_t);
+extern void tpoint_fini(void);
+extern void tpoint_record(const tpoint_t *, tpoint_phase_t, sysarg_t,
+    sysarg_t, sysarg_t);
+extern size_t tpoint_read(tpoint_event_t *, size_t);
+extern errno_t tpoint_export(FILE *);
+
+/** Record an instant event.
+ *
+ * @param tp Tracepoint
+ * @param a0 First argument
+ * @param a1 Second argument
+ * @param a2 Third argument
+ */
+static inline void tpoint_hit(const tpoint_t *tp, sysarg_t a0, sysarg_t a1,
+    sysarg_t a2)
+{
+	tpoint_record(tp, tpp_instant, a0, a1, a2);
+}
+
+/** Record the beginning of a duration.
+ *
+ * @param tp Tracepoint
+ * @param a0 First argument
+ * @param a1 Second argument
+ * @param a2 Third argument
+ */
+static inline void tpoint_begin(const tpoint_t *tp, sysarg_t a0, sysarg_t a1,
+    sysarg_t a2)
+{
+	tpoint_record(tp, tpp_begin, a0, a1, a2);
+}
+
+/** Record the end of a duration.
+ *
+ * @param tp Tracepoint
+ */
+static inline void tpoint_end(const tpoint_t *tp)
+{
+	tpoint_record(tp, tpp_end, 0, 0, 0);
+}
+
+#endif
+
+/** @}
+ */
@@ -42,6 +42,23 @@
 
 #include <types/rtld/module.h>
 
+/** Number of entries in the symbol cache */
+#define RTLD_SYMCACHE_SIZE  256
+
+/** Symbol cache entry */
+typedef struct {
+	/** Symbol name */
+	const char *name;
+	/** GNU hash of the name */
+	uint32_t hash;
+	/** Search flags the entry is valid for */
+	unsigned flags;
+	/** Symbol definition or @c NULL if the entry is empty */
+	elf_symbol_t *sym;
+	/** Module containing the definition */
+	module_t *mod;
+} rtld_symcache_entry_t;
+
 typedef struct rtld {
 	elf_dyn_t *rtld_dynamic;
 	module_t rtld;
@@ -60,6 +77,9 @@ typedef struct rtld {
 
 	/** List of initial modules */
 	list_t imodules;
+
+	/** Cache of resolved symbols, indexed by name hash */
+	rtld_symcache_entry_t symcache[RTLD_SYMCACHE_SIZE];
 } rtld_t;
 
 #endif
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _LIBC_VFS_AIO_H_
+#define _LIBC_VFS_AIO_H_
+
+#include <adt/list.h>
+#include <async.h>
+#include <errno.h>
+#include <offset.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Asynchronous file I/O request.
+ *
+ * The request is owned by the caller and must stay allocated, together with
+ * its buffer, from vfs_aio_submit() until it is returned by vfs_aio_poll()
+ * or vfs_aio_wait().
+ */
+typedef struct {
+	/** Link to vfs_aio_t.outstanding */
+	link_t link;
+
+	/** File handle */
+	int file;
+	/** @c true to write, @c false to read */
+	bool write;
+	/** Position in the file */
+	aoff64_t pos;
+	/** Data buffer */
+	void *buf;
+	/** Number of bytes to transfer, at most DATA_XFER_LIMIT */
+	size_t size;
+	/** Argument for the caller's use */
+	void *arg;
+
+	/** Result of the request */
+	errno_t rc;
+	/** Number of bytes actually transferred */
+	size_t nbytes;
+
+	/** Exchange owned by the request while it is outstanding */
+	async_exch_t *exch;
+	/** VFS_IN_READ or VFS_IN_WRITE message */
+	aid_t req;
+	/** Data transfer message or 0 once it has been waited for */
+	aid_t data;
+	/** Answer to the VFS request */
+	ipc_call_t answer;
+	/** Answer to the data transfer */
+	ipc_call_t data_answer;
+} vfs_aio_req_t;
+
+/** Asynchronous file I/O queue.
+ *
+ * A queue is meant to be used by a single fibril.
+ */
+typedef struct {
+	/** Maximum number of outstanding requests */
+	size_t depth;
+	/** Number of outstanding requests */
+	size_t count;
+	/** Outstanding requests in the order of submission */
+	list_t outstanding;
+} vfs_aio_t;
+
+extern errno_t vfs_aio_create(size_t, vfs_aio_t **);
+extern void vfs_aio_destroy(vfs_aio_t *);
+extern errno_t vfs_aio_submit(vfs_aio_t *, vfs_aio_req_t *);
+extern errno_t vfs_aio_poll(vfs_aio_t *, vfs_aio_req_t **);
+extern errno_t vfs_aio_wait(vfs_aio_t *, vfs_aio_req_t **);
+
+#endif
+
+/** @}
+ */
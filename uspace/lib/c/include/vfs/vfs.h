@@ -71,6 +71,26 @@ typedef struct {
 	uint64_t f_bfree;    /* free blocks in fs */
 } vfs_statfs_t;
 
+/** Statistics of the VFS server. */
+typedef struct {
+	/** Lookups which inserted their path into the Path Lookup Buffer */
+	size_t plb_lookups;
+	/** Lookups which found the PLB lock held */
+	size_t plb_contended;
+	/** Lookups which had to wait for space in PLB */
+	size_t plb_waits;
+	/** Largest number of PLB bytes in use at once */
+	size_t plb_peak;
+	/** Pages in the page cache */
+	size_t cache_pages;
+	/** Pages read ahead */
+	size_t ra_pages;
+	/** Pages read ahead which were later read */
+	size_t ra_hits;
+	/** Pages read ahead which were evicted before being read */
+	size_t ra_wasted;
+} vfs_server_stats_t;
+
 /** List of file system types */
 typedef struct {
 	char **fstypes;
@@ -99,9 +119,11 @@ extern errno_t vfs_mount(int, const char *, service_id_t, const char *, unsigned
     unsigned, int *);
 extern errno_t vfs_open(int, int);
 extern errno_t vfs_pass_handle(async_exch_t *, int, async_exch_t *);
+extern errno_t vfs_pipe(int *, int *);
 extern errno_t vfs_put(int);
 extern errno_t vfs_read(int, aoff64_t *, void *, size_t, size_t *);
 extern errno_t vfs_read_short(int, aoff64_t, void *, size_t, ssize_t *);
+extern errno_t vfs_readdir(int, aoff64_t *, void *, size_t, size_t *);
 extern errno_t vfs_receive_handle(bool, int *);
 extern errno_t vfs_rename_path(const char *, const char *);
 extern errno_t vfs_resize(int, aoff64_t);
@@ -111,6 +133,7 @@ extern errno_t vfs_stat(int, vfs_stat_t *);
 extern errno_t vfs_stat_path(const char *, vfs_stat_t *);
 extern errno_t vfs_statfs(int, vfs_statfs_t *);
 extern errno_t vfs_statfs_path(const char *, vfs_statfs_t *);
+extern errno_t vfs_server_stats(vfs_server_stats_t *);
 extern errno_t vfs_sync(int);
 extern errno_t vfs_unlink(int, const char *, int);
 extern errno_t vfs_unlink_path(const char *);
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <adt/checksum.h>
+#include <pcut/pcut.h>
+#include <stdint.h>
+#include <str.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(checksum);
+
+enum {
+	test_size = 1024
+};
+
+static uint8_t test_data[test_size + 16];
+
+/** Bit-by-bit reference CRC32 implementation */
+static uint32_t crc32_ref(const uint8_t *data, size_t length, uint32_t seed)
+{
+	uint32_t crc = ~seed;
+	size_t i;
+	int j;
+
+	for (i = 0; i < length; i++) {
+		crc ^= data[i];
+		for (j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+	}
+
+	return ~crc;
+}
+
+/** Fill test data with pseudo-random bytes */
+static void fill_test_data(void)
+{
+	uint32_t x = 1;
+	size_t i;
+
+	for (i = 0; i < sizeof(test_data); i++) {
+		x = x * 1103515245 + 12345;
+		test_data[i] = x >> 16;
+	}
+}
+
+/** CRC32 of the standard check string */
+PCUT_TEST(crc32_check)
+{
+	char data[] = "123456789";
+
+	PCUT_ASSERT_INT_EQUALS(0xcbf43926,
+	    compute_crc32((uint8_t *) data, str_size(data)));
+}
+
+/** CRC32 of empty data */
+PCUT_TEST(crc32_empty)
+{
+	PCUT_ASSERT_INT_EQUALS(0, compute_crc32(test_data, 0));
+	PCUT_ASSERT_INT_EQUALS(0x12345678,
+	    compute_crc32_seed(test_data, 0, 0x12345678));
+}
+
+/** CRC32 of data at different lengths and alignments */
+PCUT_TEST(crc32_lengths)
+{
+	size_t off;
+	size_t len;
+
+	fill_test_data();
+
+	for (off = 0; off < 16; off++) {
+		for (len = 0; len <= test_size; len += 1 + len / 8) {
+			PCUT_ASSERT_INT_EQUALS(crc32_ref(test_data + off, len, 0),
+			    compute_crc32(test_data + off, len));
+		}
+	}
+}
+
+/** CRC32 computed in pieces using the seed */
+PCUT_TEST(crc32_seed)
+{
+	uint32_t crc;
+	size_t split;
+
+	fill_test_data();
+
+	for (split = 0; split <= test_size; split += 37) {
+		crc = compute_crc32(test_data, split);
+		crc = compute_crc32_seed(test_data + split, test_size - split,
+		    crc);
+		PCUT_ASSERT_INT_EQUALS(crc32_ref(test_data, test_size, 0), crc);
+	}
+}
+
+PCUT_EXPORT(checksum);
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <adt/mpmc.h>
+#include <fibril.h>
+#include <pcut/pcut.h>
+#include <stdint.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(mpmc);
+
+enum {
+	queue_size = 4,
+	item_count = 100
+};
+
+static mpmc_cell_t cells[queue_size];
+
+/** Fill the queue, drain it, and wrap around a few times. */
+PCUT_TEST(try_push_pop)
+{
+	mpmc_t q;
+	void *item;
+	uintptr_t i;
+	uintptr_t round;
+	errno_t rc;
+
+	mpmc_init(&q, cells, queue_size);
+
+	rc = mpmc_try_pop(&q, &item);
+	PCUT_ASSERT_ERRNO_VAL(EAGAIN, rc);
+
+	for (round = 0; round < 3; round++) {
+		for (i = 0; i < queue_size; i++) {
+			rc = mpmc_try_push(&q, (void *) (round * 10 + i));
+			PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+		}
+
+		rc = mpmc_try_push(&q, NULL);
+		PCUT_ASSERT_ERRNO_VAL(EAGAIN, rc);
+
+		for (i = 0; i < queue_size; i++) {
+			rc = mpmc_try_pop(&q, &item);
+			PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+			PCUT_ASSERT_EQUALS((void *) (round * 10 + i), item);
+		}
+
+		rc = mpmc_try_pop(&q, &item);
+		PCUT_ASSERT_ERRNO_VAL(EAGAIN, rc);
+	}
+}
+
+static errno_t producer_fn(void *arg)
+{
+	mpmc_t *q = (mpmc_t *) arg;
+	uintptr_t i;
+
+	for (i = 1; i <= item_count; i++)
+		mpmc_push(q, (void *) i);
+
+	return EOK;
+}
+
+/** Blocking push and pop hand over more items than the queue holds. */
+PCUT_TEST(blocking)
+{
+	mpmc_t q;
+	uintptr_t i;
+	fid_t fid;
+
+	mpmc_init(&q, cells, queue_size);
+
+	fid = fibril_create(producer_fn, &q);
+	PCUT_ASSERT_NOT_NULL((void *) fid);
+	fibril_add_ready(fid);
+
+	for (i = 1; i <= item_count; i++)
+		PCUT_ASSERT_EQUALS((void *) i, mpmc_pop(&q));
+}
+
+PCUT_EXPORT(mpmc);
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <adt/ohash_table.h>
+#include <errno.h>
+#include <pcut/pcut.h>
+#include <stdbool.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(ohash_table);
+
+enum {
+	item_count = 1000,
+	/** Number of distinct keys, so that some keys repeat */
+	key_count = 300
+};
+
+typedef struct {
+	ht_link_t link;
+	int key;
+	bool removed;
+} test_item_t;
+
+static test_item_t items[item_count];
+
+static size_t test_key_hash(const void *key)
+{
+	return *(const int *) key;
+}
+
+static size_t test_hash(const ht_link_t *item)
+{
+	test_item_t *ti = hash_table_get_inst(item, test_item_t, link);
+	return test_key_hash(&ti->key);
+}
+
+static bool test_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	test_item_t *ti1 = hash_table_get_inst(item1, test_item_t, link);
+	test_item_t *ti2 = hash_table_get_inst(item2, test_item_t, link);
+	return ti1->key == ti2->key;
+}
+
+static bool test_key_equal(const void *key, const ht_link_t *item)
+{
+	test_item_t *ti = hash_table_get_inst(item, test_item_t, link);
+	return ti->key == *(const int *) key;
+}
+
+static void test_remove_callback(ht_link_t *item)
+{
+	test_item_t *ti = hash_table_get_inst(item, test_item_t, link);
+	ti->removed = true;
+}
+
+static const hash_table_ops_t test_ops = {
+	.hash = test_hash,
+	.key_hash = test_key_hash,
+	.key_equal = test_key_equal,
+	.equal = test_equal,
+	.remove_callback = test_remove_callback
+};
+
+static void fill(ohash_table_t *h)
+{
+	int i;
+
+	for (i = 0; i < item_count; i++) {
+		/* Spread the keys in a way a poor hash would cluster them. */
+		items[i].key = (i % key_count) * 1024;
+		items[i].removed = false;
+		PCUT_ASSERT_ERRNO_VAL(EOK, ohash_table_insert(h, &items[i].link));
+	}
+}
+
+/** Count items with @a key by ohash_table_find() and _find_next(). */
+static int count_key(ohash_table_t *h, int key)
+{
+	ht_link_t *first = ohash_table_find(h, &key);
+	ht_link_t *cur;
+	int n = 0;
+
+	for (cur = first; cur != NULL; cur = ohash_table_find_next(h, first, cur)) {
+		PCUT_ASSERT_TRUE(test_key_equal(&key, cur));
+		n++;
+	}
+
+	return n;
+}
+
+/** Every inserted item can be found, including repeated keys. */
+PCUT_TEST(insert_find)
+{
+	ohash_table_t h;
+	int key;
+
+	PCUT_ASSERT_TRUE(ohash_table_create(&h, 0, &test_ops));
+	fill(&h);
+
+	PCUT_ASSERT_INT_EQUALS(item_count, ohash_table_size(&h));
+
+	for (key = 0; key < key_count; key++) {
+		PCUT_ASSERT_INT_EQUALS(item_count / key_count +
+		    (key < item_count % key_count ? 1 : 0),
+		    count_key(&h, key * 1024));
+	}
+
+	key = 1;
+	PCUT_ASSERT_NULL(ohash_table_find(&h, &key));
+
+	ohash_table_destroy(&h);
+}
+
+/** Removing by key removes all matching items and only them. */
+PCUT_TEST(remove_key)
+{
+	ohash_table_t h;
+	int key;
+	int i;
+
+	PCUT_ASSERT_TRUE(ohash_table_create(&h, 0, &test_ops));
+	fill(&h);
+
+	key = 5 * 1024;
+	PCUT_ASSERT_INT_EQUALS(4, ohash_table_remove(&h, &key));
+	PCUT_ASSERT_INT_EQUALS(0, count_key(&h, key));
+	PCUT_ASSERT_INT_EQUALS(item_count - 4, ohash_table_size(&h));
+
+	for (i = 0; i < item_count; i++) {
+		PCUT_ASSERT_EQUALS(items[i].key == key, items[i].removed);
+		if (!items[i].removed)
+			ohash_table_remove_item(&h, &items[i].link);
+	}
+
+	PCUT_ASSERT_TRUE(ohash_table_empty(&h));
+	ohash_table_destroy(&h);
+}
+
+/** Unique insertion rejects repeated keys. */
+PCUT_TEST(insert_unique)
+{
+	ohash_table_t h;
+	test_item_t a = { .key = 7 };
+	test_item_t b = { .key = 7 };
+
+	PCUT_ASSERT_TRUE(ohash_table_create(&h, 0, &test_ops));
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, ohash_table_insert_unique(&h, &a.link));
+	PCUT_ASSERT_ERRNO_VAL(EEXIST, ohash_table_insert_unique(&h, &b.link));
+	PCUT_ASSERT_INT_EQUALS(1, ohash_table_size(&h));
+
+	ohash_table_destroy(&h);
+	PCUT_ASSERT_TRUE(a.removed);
+	PCUT_ASSERT_FALSE(b.removed);
+}
+
+static bool visit_remove_odd(ht_link_t *item, void *arg)
+{
+	ohash_table_t *h = arg;
+	test_item_t *ti = hash_table_get_inst(item, test_item_t, link);
+
+	PCUT_ASSERT_FALSE(ti->removed);
+	ti->removed = true;
+
+	if ((ti - items) % 2 != 0)
+		ohash_table_remove_item(h, item);
+
+	return true;
+}
+
+/** Apply visits every item exactly once, even if it removes items. */
+PCUT_TEST(apply_remove)
+{
+	ohash_table_t h;
+	int i;
+
+	PCUT_ASSERT_TRUE(ohash_table_create(&h, 0, &test_ops));
+	fill(&h);
+
+	ohash_table_apply(&h, visit_remove_odd, &h);
+
+	for (i = 0; i < item_count; i++)
+		PCUT_ASSERT_TRUE(items[i].removed);
+
+	PCUT_ASSERT_INT_EQUALS(item_count / 2, ohash_table_size(&h));
+
+	ohash_table_destroy(&h);
+}
+
+PCUT_EXPORT(ohash_table);
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <adt/list.h>
+#include <adt/twheel.h>
+#include <pcut/pcut.h>
+#include <stdint.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(twheel);
+
+enum {
+	timer_count = 64
+};
+
+static twheel_timer_t timers[timer_count];
+
+/** Timers expire in order, not early and not more than a tick late. */
+PCUT_TEST(expire_order)
+{
+	twheel_t wheel;
+	list_t expired;
+	uint64_t now = 1000;
+	uint64_t last = 0;
+	int nexpired = 0;
+	int i;
+
+	twheel_initialize(&wheel, now);
+	list_initialize(&expired);
+
+	for (i = 0; i < timer_count; i++) {
+		/* Spread the timers over all levels of the wheel. */
+		twheel_insert(&wheel, &timers[i], now + ((uint64_t) i << (i / 3)));
+	}
+
+	while (!twheel_empty(&wheel)) {
+		uint64_t next;
+
+		PCUT_ASSERT_TRUE(twheel_next(&wheel, &next));
+		PCUT_ASSERT_TRUE(next >= now);
+
+		now = next;
+		twheel_advance(&wheel, now, &expired);
+
+		while (!list_empty(&expired)) {
+			twheel_timer_t *t = list_get_instance(list_first(&expired),
+			    twheel_timer_t, link);
+			list_remove(&t->link);
+
+			PCUT_ASSERT_TRUE(t->expires <= now);
+			PCUT_ASSERT_TRUE(now - t->expires < (1 << TWHEEL_RES_BITS));
+			PCUT_ASSERT_TRUE(t->expires >= last);
+			last = t->expires;
+			nexpired++;
+		}
+	}
+
+	PCUT_ASSERT_INT_EQUALS(timer_count, nexpired);
+}
+
+/** Removed timers do not expire. */
+PCUT_TEST(remove)
+{
+	twheel_t wheel;
+	list_t expired;
+	int i;
+
+	twheel_initialize(&wheel, 0);
+	list_initialize(&expired);
+
+	for (i = 0; i < timer_count; i++)
+		twheel_insert(&wheel, &timers[i], (uint64_t) i * 100000);
+
+	for (i = 0; i < timer_count; i += 2)
+		twheel_remove(&wheel, &timers[i]);
+
+	twheel_advance(&wheel, (uint64_t) timer_count * 100000, &expired);
+	PCUT_ASSERT_TRUE(twheel_empty(&wheel));
+	PCUT_ASSERT_INT_EQUALS(timer_count / 2, list_count(&expired));
+}
+
+PCUT_EXPORT(twheel);
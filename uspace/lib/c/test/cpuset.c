@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cpuset.h>
+#include <pcut/pcut.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(cpuset);
+
+PCUT_TEST(add_remove)
+{
+	cpuset_t set;
+
+	cpuset_clear(&set);
+	PCUT_ASSERT_INT_EQUALS(0, cpuset_count(&set));
+
+	cpuset_add(&set, 0);
+	cpuset_add(&set, 9);
+	cpuset_add(&set, CPUSET_CPUS_MAX);
+	PCUT_ASSERT_TRUE(cpuset_contains(&set, 0));
+	PCUT_ASSERT_TRUE(cpuset_contains(&set, 9));
+	PCUT_ASSERT_FALSE(cpuset_contains(&set, 8));
+	PCUT_ASSERT_FALSE(cpuset_contains(&set, CPUSET_CPUS_MAX));
+	PCUT_ASSERT_INT_EQUALS(2, cpuset_count(&set));
+
+	cpuset_remove(&set, 0);
+	PCUT_ASSERT_FALSE(cpuset_contains(&set, 0));
+	PCUT_ASSERT_INT_EQUALS(1, cpuset_count(&set));
+}
+
+/** The thread may run on some processor */
+PCUT_TEST(get_thread)
+{
+	cpuset_t set;
+
+	errno_t rc = cpuset_get_thread(&set);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_TRUE(cpuset_count(&set) > 0);
+}
+
+/** Restricting the thread to the processors it may run on anyway works */
+PCUT_TEST(set_thread)
+{
+	cpuset_t set;
+
+	errno_t rc = cpuset_get_thread(&set);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = cpuset_set_thread(&set);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = cpuset_set_thread(NULL);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+}
+
+/** An empty CPU set is rejected */
+PCUT_TEST(set_empty)
+{
+	cpuset_t set;
+
+	cpuset_clear(&set);
+	errno_t rc = cpuset_set_thread(&set);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, rc);
+}
+
+PCUT_EXPORT(cpuset);
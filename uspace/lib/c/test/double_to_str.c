@@ -203,4 +203,119 @@ PCUT_TEST(double_to_fixed_str_nodecimals)
 	PCUT_ASSERT_STR_EQUALS("1", buf);
 }
 
+PCUT_TEST(double_to_short_str_not_exact)
+{
+	size_t size = 255;
+	char buf[size];
+	int dec;
+	ieee_double_t d = extract_ieee_double(1e23);
+	int ret = double_to_short_str(d, buf, size, &dec);
+
+	PCUT_ASSERT_INT_EQUALS(1, ret);
+	PCUT_ASSERT_INT_EQUALS(23, dec);
+	PCUT_ASSERT_STR_EQUALS("1", buf);
+}
+
+PCUT_TEST(double_to_short_str_denormal)
+{
+	size_t size = 255;
+	char buf[size];
+	int dec;
+	ieee_double_t d = extract_ieee_double(5e-324);
+	int ret = double_to_short_str(d, buf, size, &dec);
+
+	PCUT_ASSERT_INT_EQUALS(1, ret);
+	PCUT_ASSERT_INT_EQUALS(-324, dec);
+	PCUT_ASSERT_STR_EQUALS("5", buf);
+}
+
+PCUT_TEST(double_to_short_str_max)
+{
+	size_t size = 255;
+	char buf[size];
+	int dec;
+	ieee_double_t d = extract_ieee_double(1.7976931348623157e308);
+	int ret = double_to_short_str(d, buf, size, &dec);
+
+	PCUT_ASSERT_INT_EQUALS(17, ret);
+	PCUT_ASSERT_INT_EQUALS(292, dec);
+	PCUT_ASSERT_STR_EQUALS("17976931348623157", buf);
+}
+
+PCUT_TEST(double_to_rounded_str_pad)
+{
+	size_t size = 255;
+	char buf[size];
+	int dec;
+	ieee_double_t d = extract_ieee_double(0.3);
+	int ret = double_to_rounded_str(d, -1, 5, buf, size, &dec);
+
+	PCUT_ASSERT_INT_EQUALS(5, ret);
+	PCUT_ASSERT_INT_EQUALS(-5, dec);
+	PCUT_ASSERT_STR_EQUALS("30000", buf);
+}
+
+PCUT_TEST(double_to_rounded_str_signif)
+{
+	size_t size = 255;
+	char buf[size];
+	int dec;
+	ieee_double_t d = extract_ieee_double(1e23);
+	int ret = double_to_rounded_str(d, 3, -1, buf, size, &dec);
+
+	PCUT_ASSERT_INT_EQUALS(3, ret);
+	PCUT_ASSERT_INT_EQUALS(21, dec);
+	PCUT_ASSERT_STR_EQUALS("100", buf);
+}
+
+PCUT_TEST(double_to_rounded_str_fallback)
+{
+	size_t size = 255;
+	char buf[size];
+	int dec;
+
+	/* The shortest representation has more digits than requested. */
+	ieee_double_t d = extract_ieee_double(1.0 / 3.0);
+	PCUT_ASSERT_TRUE(double_to_rounded_str(d, 3, -1, buf, size, &dec) < 0);
+
+	/* Too many digits requested. */
+	d = extract_ieee_double(0.5);
+	PCUT_ASSERT_TRUE(double_to_rounded_str(d, 17, -1, buf, size, &dec) < 0);
+
+	/* Denormal numbers are not supported. */
+	d = extract_ieee_double(5e-324);
+	PCUT_ASSERT_TRUE(double_to_rounded_str(d, 3, -1, buf, size, &dec) < 0);
+}
+
+PCUT_TEST(double_to_rounded_str_vs_fixed)
+{
+	size_t size = 255;
+	char buf[size];
+	char fixed_buf[size];
+	int dec;
+	int fixed_dec;
+
+	/*
+	 * Exactly representable values have no digits to round. Both
+	 * conversions must agree up to the padding zeros.
+	 */
+	for (int i = 1; i < 4096; i += 7) {
+		ieee_double_t d = extract_ieee_double(i / 8.0);
+		int ret = double_to_rounded_str(d, -1, 3, buf, size, &dec);
+		int fixed_ret = double_to_fixed_str(d, -1, 3, fixed_buf, size,
+		    &fixed_dec);
+
+		PCUT_ASSERT_TRUE(ret > 0);
+
+		while (ret > fixed_ret && buf[ret - 1] == '0') {
+			buf[--ret] = '\0';
+			++dec;
+		}
+
+		PCUT_ASSERT_INT_EQUALS(fixed_ret, ret);
+		PCUT_ASSERT_INT_EQUALS(fixed_dec, dec);
+		PCUT_ASSERT_STR_EQUALS(fixed_buf, buf);
+	}
+}
+
 PCUT_EXPORT(double_to_str);
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <evqueue.h>
+#include <pcut/pcut.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(evqueue);
+
+/** Events of a source are delivered once until the next notification */
+PCUT_TEST(notify_wait)
+{
+	evqueue_t *evq;
+	evqueue_src_t src;
+	evqueue_event_t ev[2];
+	size_t n;
+	int arg;
+	errno_t rc;
+
+	rc = evqueue_create(&evq);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	evqueue_src_init(&src);
+	rc = evqueue_add(evq, &src, EVQUEUE_READ, &arg);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = evqueue_wait(evq, ev, 2, 0, &n);
+	PCUT_ASSERT_ERRNO_VAL(ETIMEOUT, rc);
+
+	/* Repeated notifications are coalesced */
+	evqueue_src_notify(&src, EVQUEUE_READ);
+	evqueue_src_notify(&src, EVQUEUE_READ);
+
+	rc = evqueue_wait(evq, ev, 2, 0, &n);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(1, n);
+	PCUT_ASSERT_INT_EQUALS(EVQUEUE_READ, ev[0].events);
+	PCUT_ASSERT_EQUALS(&arg, ev[0].arg);
+
+	rc = evqueue_wait(evq, ev, 2, 1000, &n);
+	PCUT_ASSERT_ERRNO_VAL(ETIMEOUT, rc);
+
+	evqueue_remove(&src);
+	evqueue_destroy(evq);
+}
+
+/** Events not asked for are kept until they are */
+PCUT_TEST(mask)
+{
+	evqueue_t *evq;
+	evqueue_src_t src;
+	evqueue_event_t ev;
+	size_t n;
+	errno_t rc;
+
+	rc = evqueue_create(&evq);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Events before registration are reported when it happens */
+	evqueue_src_init(&src);
+	evqueue_src_notify(&src, EVQUEUE_WRITE);
+
+	rc = evqueue_add(evq, &src, EVQUEUE_READ, NULL);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = evqueue_wait(evq, &ev, 1, 0, &n);
+	PCUT_ASSERT_ERRNO_VAL(ETIMEOUT, rc);
+
+	evqueue_modify(&src, EVQUEUE_READ | EVQUEUE_WRITE);
+
+	rc = evqueue_wait(evq, &ev, 1, 0, &n);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(EVQUEUE_WRITE, ev.events);
+
+	/* Hangup is always reported */
+	evqueue_src_notify(&src, EVQUEUE_HUP);
+	rc = evqueue_wait(evq, &ev, 1, 0, &n);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(EVQUEUE_HUP, ev.events);
+
+	evqueue_remove(&src);
+	evqueue_destroy(evq);
+}
+
+PCUT_EXPORT(evqueue);
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <stdint.h>
+#include <time.h>
+#include <pcut/pcut.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(fibril_park);
+
+static bool still_zero(void *arg)
+{
+	return *(volatile int *) arg == 0;
+}
+
+static errno_t waker_fn(void *arg)
+{
+	fibril_usleep(1000);
+	*(volatile int *) arg = 1;
+	fibril_unpark(arg, SIZE_MAX);
+	return EOK;
+}
+
+PCUT_TEST(validate_fails)
+{
+	int word = 1;
+
+	errno_t rc = fibril_park(&word, still_zero, &word, NULL);
+	PCUT_ASSERT_ERRNO_VAL(EAGAIN, rc);
+}
+
+PCUT_TEST(timeout)
+{
+	int word = 0;
+	struct timespec expires;
+
+	getuptime(&expires);
+	ts_add_diff(&expires, USEC2NSEC(1000));
+
+	errno_t rc = fibril_park(&word, still_zero, &word, &expires);
+	PCUT_ASSERT_ERRNO_VAL(ETIMEOUT, rc);
+	PCUT_ASSERT_INT_EQUALS(0, fibril_unpark(&word, SIZE_MAX));
+}
+
+PCUT_TEST(wakeup)
+{
+	int word = 0;
+
+	fid_t fid = fibril_create(waker_fn, &word);
+	PCUT_ASSERT_NOT_NULL((void *) fid);
+	fibril_add_ready(fid);
+
+	while (fibril_park(&word, still_zero, &word, NULL) == EOK)
+		;
+
+	PCUT_ASSERT_INT_EQUALS(1, word);
+}
+
+PCUT_TEST(unpark_other_address)
+{
+	int words[2] = { 0, 0 };
+
+	PCUT_ASSERT_INT_EQUALS(0, fibril_unpark(&words[0], 1));
+	PCUT_ASSERT_INT_EQUALS(0, fibril_unpark(&words[1], SIZE_MAX));
+}
+
+PCUT_EXPORT(fibril_park);
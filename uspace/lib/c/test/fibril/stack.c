@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <async.h>
+
+#include <fibril.h>
+#include <pcut/pcut.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(fibril_stack);
+
+static errno_t test_fibril_fn(void *arg)
+{
+	return EOK;
+}
+
+/** Stack of a destroyed fibril is reused by the next one. */
+PCUT_TEST(reuse)
+{
+	fibril_stack_stats_t before, after;
+	fid_t fid;
+
+	fid = fibril_create(test_fibril_fn, NULL);
+	PCUT_ASSERT_NOT_NULL(fid);
+	fibril_destroy(fid);
+
+	fibril_stack_stats(&before);
+	PCUT_ASSERT_TRUE(before.pooled > 0);
+
+	fid = fibril_create(test_fibril_fn, NULL);
+	PCUT_ASSERT_NOT_NULL(fid);
+
+	fibril_stack_stats(&after);
+	PCUT_ASSERT_INT_EQUALS(before.hits + 1, after.hits);
+	PCUT_ASSERT_INT_EQUALS(before.pooled - 1, after.pooled);
+
+	fibril_destroy(fid);
+}
+
+PCUT_EXPORT(fibril_stack);
@@ -40,6 +40,17 @@ static int cmp_func(void *a, void *b, void *param)
 	return ia < ib ? -1 : 1;
 }
 
+typedef struct {
+	int key;
+	int pos;
+} test_elem_t;
+
+static int cmp_elem(void *a, void *b, void *param)
+{
+	return cmp_func(&((test_elem_t *)a)->key, &((test_elem_t *)b)->key,
+	    param);
+}
+
 PCUT_INIT;
 
 PCUT_TEST_SUITE(gsort);
@@ -105,4 +116,25 @@ PCUT_TEST(gsort_desc)
 	}
 }
 
+/* sort a long sequence, checking that equal entries keep their order */
+PCUT_TEST(gsort_stable)
+{
+	int size = 1000;
+	test_elem_t data[size];
+
+	for (int i = 0; i < size; i++) {
+		data[i].key = (i * 7919) % 13;
+		data[i].pos = i;
+	}
+
+	bool ret = gsort(data, size, sizeof(test_elem_t), cmp_elem, NULL);
+	PCUT_ASSERT_TRUE(ret);
+
+	for (int i = 1; i < size; i++) {
+		PCUT_ASSERT_TRUE(data[i - 1].key <= data[i].key);
+		if (data[i - 1].key == data[i].key)
+			PCUT_ASSERT_TRUE(data[i - 1].pos < data[i].pos);
+	}
+}
+
 PCUT_EXPORT(gsort);
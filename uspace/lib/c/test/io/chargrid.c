@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <io/chargrid.h>
+#include <pcut/pcut.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(chargrid);
+
+/** Putting characters marks their rows dirty */
+PCUT_TEST(putuchar_dirty_rows)
+{
+	chargrid_t *grid;
+	sysarg_t r0, r1;
+
+	grid = chargrid_create(10, 5, CHARGRID_FLAG_NONE);
+	PCUT_ASSERT_NOT_NULL(grid);
+
+	/* Cleared chargrid is dirty entirely */
+	chargrid_get_dirty_rows(grid, &r0, &r1);
+	PCUT_ASSERT_INT_EQUALS(0, r0);
+	PCUT_ASSERT_INT_EQUALS(5, r1);
+
+	chargrid_reset_dirty_rows(grid);
+	chargrid_get_dirty_rows(grid, &r0, &r1);
+	PCUT_ASSERT_TRUE(r0 >= r1);
+
+	chargrid_set_cursor(grid, 3, 2);
+	chargrid_putuchar(grid, 'a', true);
+	chargrid_get_dirty_rows(grid, &r0, &r1);
+	PCUT_ASSERT_INT_EQUALS(2, r0);
+	PCUT_ASSERT_INT_EQUALS(3, r1);
+	PCUT_ASSERT_INT_EQUALS('a', chargrid_charfield_at(grid, 3, 2)->ch);
+	PCUT_ASSERT_TRUE((chargrid_charfield_at(grid, 3, 2)->flags &
+	    CHAR_FLAG_DIRTY) != 0);
+
+	chargrid_set_cursor(grid, 0, 4);
+	chargrid_putuchar(grid, 'b', true);
+	chargrid_get_dirty_rows(grid, &r0, &r1);
+	PCUT_ASSERT_INT_EQUALS(2, r0);
+	PCUT_ASSERT_INT_EQUALS(5, r1);
+
+	chargrid_destroy(grid);
+}
+
+/** Scrolling moves the contents and dirty rows up */
+PCUT_TEST(scroll_up)
+{
+	chargrid_t *grid;
+	sysarg_t r0, r1;
+	sysarg_t rows;
+
+	grid = chargrid_create(10, 5, CHARGRID_FLAG_NONE);
+	PCUT_ASSERT_NOT_NULL(grid);
+
+	chargrid_set_cursor(grid, 0, 3);
+	chargrid_putuchar(grid, 'a', true);
+	chargrid_reset_dirty_rows(grid);
+
+	chargrid_set_cursor(grid, 0, 2);
+	chargrid_putuchar(grid, 'b', true);
+
+	chargrid_scroll_up(grid, 2);
+	PCUT_ASSERT_INT_EQUALS(2, chargrid_get_top_row(grid));
+	PCUT_ASSERT_INT_EQUALS('a', chargrid_charfield_at(grid, 0, 1)->ch);
+	PCUT_ASSERT_INT_EQUALS('b', chargrid_charfield_at(grid, 0, 0)->ch);
+	PCUT_ASSERT_INT_EQUALS(0, chargrid_charfield_at(grid, 0, 3)->ch);
+	PCUT_ASSERT_INT_EQUALS(0, chargrid_charfield_at(grid, 0, 4)->ch);
+
+	/* Row with 'b' and the two new rows are dirty */
+	chargrid_get_dirty_rows(grid, &r0, &r1);
+	PCUT_ASSERT_INT_EQUALS(0, r0);
+	PCUT_ASSERT_INT_EQUALS(5, r1);
+
+	/* Newline at the bottom row scrolls by one row */
+	chargrid_reset_dirty_rows(grid);
+	chargrid_set_cursor(grid, 0, 4);
+	rows = chargrid_newline(grid);
+	PCUT_ASSERT_INT_EQUALS(5, rows);
+	PCUT_ASSERT_INT_EQUALS(3, chargrid_get_top_row(grid));
+	PCUT_ASSERT_INT_EQUALS('a', chargrid_charfield_at(grid, 0, 0)->ch);
+
+	chargrid_get_dirty_rows(grid, &r0, &r1);
+	PCUT_ASSERT_INT_EQUALS(4, r0);
+	PCUT_ASSERT_INT_EQUALS(5, r1);
+
+	chargrid_destroy(grid);
+}
+
+/** Directly modified rows can be marked dirty */
+PCUT_TEST(set_dirty_rows)
+{
+	chargrid_t *grid;
+	sysarg_t r0, r1;
+
+	grid = chargrid_create(10, 5, CHARGRID_FLAG_NONE);
+	PCUT_ASSERT_NOT_NULL(grid);
+
+	chargrid_reset_dirty_rows(grid);
+	chargrid_set_dirty_rows(grid, 1, 2);
+	chargrid_set_dirty_rows(grid, 3, 10);
+	chargrid_get_dirty_rows(grid, &r0, &r1);
+	PCUT_ASSERT_INT_EQUALS(1, r0);
+	PCUT_ASSERT_INT_EQUALS(5, r1);
+
+	chargrid_destroy(grid);
+}
+
+PCUT_EXPORT(chargrid);
@@ -33,27 +33,40 @@ PCUT_INIT;
 
 PCUT_IMPORT(capa);
 PCUT_IMPORT(casting);
+PCUT_IMPORT(chargrid);
+PCUT_IMPORT(checksum);
 PCUT_IMPORT(circ_buf);
+PCUT_IMPORT(cpuset);
 PCUT_IMPORT(double_to_str);
+PCUT_IMPORT(evqueue);
+PCUT_IMPORT(fibril_park);
+PCUT_IMPORT(fibril_stack);
 PCUT_IMPORT(fibril_timer);
 PCUT_IMPORT(getopt);
 PCUT_IMPORT(gsort);
 PCUT_IMPORT(ieee_double);
 PCUT_IMPORT(imath);
 PCUT_IMPORT(inttypes);
+PCUT_IMPORT(malloc);
 PCUT_IMPORT(mem);
+PCUT_IMPORT(mpmc);
 PCUT_IMPORT(odict);
+PCUT_IMPORT(ohash_table);
 PCUT_IMPORT(perf);
 PCUT_IMPORT(perm);
 PCUT_IMPORT(qsort);
+PCUT_IMPORT(rndgen);
 PCUT_IMPORT(scanf);
 PCUT_IMPORT(sprintf);
 PCUT_IMPORT(stdio);
 PCUT_IMPORT(stdlib);
 PCUT_IMPORT(str);
+PCUT_IMPORT(str_search);
 PCUT_IMPORT(string);
 PCUT_IMPORT(strtol);
 PCUT_IMPORT(table);
+PCUT_IMPORT(tpoint);
+PCUT_IMPORT(twheel);
 PCUT_IMPORT(uuid);
 
 PCUT_MAIN();
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <malloc.h>
+#include <mem.h>
+#include <pcut/pcut.h>
+#include <stdint.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(malloc);
+
+/** Check that a block is usable and has the requested alignment. */
+static void check_block(void *p, size_t size, size_t align)
+{
+	PCUT_ASSERT_NOT_NULL(p);
+	PCUT_ASSERT_INT_EQUALS(0, (uintptr_t) p % align);
+	memset(p, 0x5a, size);
+}
+
+/** Small blocks of various sizes */
+PCUT_TEST(small)
+{
+	void *p[64];
+
+	for (size_t i = 0; i < 64; i++) {
+		p[i] = malloc(i * 16 + 1);
+		check_block(p[i], i * 16 + 1, 16);
+	}
+
+	for (size_t i = 0; i < 64; i++)
+		free(p[i]);
+}
+
+/** Blocks of a size served by the heap */
+PCUT_TEST(medium)
+{
+	void *p = malloc(4096);
+	check_block(p, 4096, 16);
+	free(p);
+}
+
+/** Large blocks */
+PCUT_TEST(large)
+{
+	void *p = malloc(1024 * 1024);
+	check_block(p, 1024 * 1024, 16);
+	free(p);
+}
+
+/** Many small blocks filling several spans */
+PCUT_TEST(many_small)
+{
+	const size_t count = 10000;
+	void **p = malloc(count * sizeof(void *));
+	PCUT_ASSERT_NOT_NULL(p);
+
+	for (size_t i = 0; i < count; i++) {
+		p[i] = malloc(24);
+		PCUT_ASSERT_NOT_NULL(p[i]);
+		*(size_t *) p[i] = i;
+	}
+
+	for (size_t i = 0; i < count; i++)
+		PCUT_ASSERT_INT_EQUALS(i, *(size_t *) p[i]);
+
+	for (size_t i = 0; i < count; i += 2)
+		free(p[i]);
+	for (size_t i = 1; i < count; i += 2)
+		free(p[i]);
+
+	free(p);
+}
+
+/** Growing a block across all kinds of blocks preserves its contents */
+PCUT_TEST(realloc_grow)
+{
+	uint8_t *p = NULL;
+	size_t size = 0;
+
+	while (size < 512 * 1024) {
+		size_t nsize = size * 2 + 7;
+
+		p = realloc(p, nsize);
+		PCUT_ASSERT_NOT_NULL(p);
+
+		for (size_t i = 0; i < size; i++)
+			PCUT_ASSERT_INT_EQUALS((uint8_t) i, p[i]);
+		for (size_t i = size; i < nsize; i++)
+			p[i] = (uint8_t) i;
+
+		size = nsize;
+	}
+
+	free(p);
+}
+
+/** Shrinking a block preserves its contents */
+PCUT_TEST(realloc_shrink)
+{
+	size_t size = 512 * 1024;
+	uint8_t *p = malloc(size);
+	PCUT_ASSERT_NOT_NULL(p);
+
+	for (size_t i = 0; i < size; i++)
+		p[i] = (uint8_t) i;
+
+	while (size > 1) {
+		size /= 3;
+
+		p = realloc(p, size);
+		PCUT_ASSERT_NOT_NULL(p);
+
+		for (size_t i = 0; i < size; i++)
+			PCUT_ASSERT_INT_EQUALS((uint8_t) i, p[i]);
+	}
+
+	free(p);
+}
+
+/** Aligned blocks */
+PCUT_TEST(memalign)
+{
+	static const size_t sizes[] = { 8, 200, 5000, 300000 };
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		for (size_t align = 8; align <= 8192; align *= 4) {
+			void *p = memalign(align, sizes[s]);
+			check_block(p, sizes[s], align);
+			free(p);
+		}
+	}
+}
+
+PCUT_EXPORT(malloc);
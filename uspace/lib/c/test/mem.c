@@ -98,6 +98,43 @@ PCUT_TEST(memchr)
 	PCUT_ASSERT_TRUE(p == NULL);
 }
 
+/** memchr function on whole words */
+PCUT_TEST(memchr_words)
+{
+	char buf[64];
+	size_t i;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = 'a' + i % 16;
+	buf[37] = 'x';
+	buf[50] = '\x80';
+
+	PCUT_ASSERT_TRUE(memchr(buf, 'x', sizeof(buf)) == buf + 37);
+	PCUT_ASSERT_TRUE(memchr(buf + 3, 'x', 35) == buf + 37);
+	PCUT_ASSERT_NULL(memchr(buf + 3, 'x', 34));
+	PCUT_ASSERT_TRUE(memchr(buf, 0x80, sizeof(buf)) == buf + 50);
+	PCUT_ASSERT_NULL(memchr(buf, 'z', sizeof(buf)));
+}
+
+/** memmem function */
+PCUT_TEST(memmem)
+{
+	const char *s = "ab\0cdab\0ce";
+	void *p;
+
+	p = memmem(s, 11, "b\0c", 3);
+	PCUT_ASSERT_TRUE(p == s + 1);
+
+	p = memmem(s + 2, 9, "b\0c", 3);
+	PCUT_ASSERT_TRUE(p == s + 6);
+
+	p = memmem(s, 11, "b\0cf", 4);
+	PCUT_ASSERT_NULL(p);
+
+	p = memmem(s, 11, "", 0);
+	PCUT_ASSERT_TRUE(p == s);
+}
+
 /** memset function */
 PCUT_TEST(memset)
 {
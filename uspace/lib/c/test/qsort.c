@@ -33,7 +33,9 @@
 
 enum {
 	/** Length of test number sequences */
-	test_seq_len = 5
+	test_seq_len = 5,
+	/** Length of sequences long enough not to be sorted by insertion sort */
+	test_long_seq_len = 1000
 };
 
 /** Test compare function.
@@ -50,6 +52,17 @@ static int test_cmp(const void *a, const void *b)
 	return *ia - *ib;
 }
 
+/** Test compare function comparing first bytes.
+ *
+ * @param a First key
+ * @param b Second key
+ * @return <0, 0, >0 if @a a is less than, equal or greater than @a b
+ */
+static int test_cmp_char(const void *a, const void *b)
+{
+	return *(const char *)a - *(const char *)b;
+}
+
 static void bubble_sort(int *seq, size_t nmemb)
 {
 	size_t i;
@@ -171,4 +184,53 @@ PCUT_TEST(pseudorandom_seq)
 	free(seq2);
 }
 
+/** Test sorting a long sequence with many repeating members. */
+PCUT_TEST(long_seq)
+{
+	int *seq;
+	int i;
+	int v;
+
+	seq = calloc(test_long_seq_len, sizeof(int));
+	PCUT_ASSERT_NOT_NULL(seq);
+
+	v = 1;
+	for (i = 0; i < test_long_seq_len; i++) {
+		seq[i] = v % 10;
+		v = seq_next(v);
+	}
+
+	qsort(seq, test_long_seq_len, sizeof(int), test_cmp);
+
+	for (i = 1; i < test_long_seq_len; i++) {
+		PCUT_ASSERT_TRUE(seq[i - 1] <= seq[i]);
+	}
+
+	free(seq);
+}
+
+/** Test sorting a long sequence of an odd element size. */
+PCUT_TEST(long_seq_odd_size)
+{
+	char (*seq)[3];
+	int i;
+
+	seq = calloc(test_long_seq_len, sizeof(*seq));
+	PCUT_ASSERT_NOT_NULL(seq);
+
+	for (i = 0; i < test_long_seq_len; i++) {
+		seq[i][0] = (test_long_seq_len - i) % 100;
+		seq[i][1] = i % 7;
+		seq[i][2] = 0;
+	}
+
+	qsort(seq, test_long_seq_len, sizeof(*seq), test_cmp_char);
+
+	for (i = 1; i < test_long_seq_len; i++) {
+		PCUT_ASSERT_TRUE(seq[i - 1][0] <= seq[i][0]);
+	}
+
+	free(seq);
+}
+
 PCUT_EXPORT(qsort);
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <mem.h>
+#include <pcut/pcut.h>
+#include <rndgen.h>
+#include <stdint.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(rndgen);
+
+/** ChaCha20 block for an all-zero key and counter (RFC 8439, A.1 #1) */
+static const uint8_t zero_key_block[RNDGEN_BLOCK_SIZE] = {
+	0x76, 0xb8, 0xe0, 0xad, 0xa0, 0xf1, 0x3d, 0x90,
+	0x40, 0x5d, 0x6a, 0xe5, 0x53, 0x86, 0xbd, 0x28,
+	0xbd, 0xd2, 0x19, 0xb8, 0xa0, 0x8d, 0xed, 0x1a,
+	0xa8, 0x36, 0xef, 0xcc, 0x8b, 0x77, 0x0d, 0xc7,
+	0xda, 0x41, 0x59, 0x7c, 0x51, 0x57, 0x48, 0x8d,
+	0x77, 0x24, 0xe0, 0x3f, 0xb8, 0xd8, 0x4a, 0x37,
+	0x6a, 0x43, 0xb8, 0xf4, 0x15, 0x18, 0xa1, 0x1c,
+	0xc3, 0x87, 0xb6, 0x69, 0xb2, 0xee, 0x65, 0x86
+};
+
+static const uint8_t zero_seed[RNDGEN_SEED_SIZE] = { 0 };
+
+/** Seeded generator produces the ChaCha20 key stream */
+PCUT_TEST(seeded_vector)
+{
+	rndgen_t *rndgen;
+	uint8_t buf[RNDGEN_BLOCK_SIZE];
+	errno_t rc;
+
+	rc = rndgen_create_seeded(&rndgen, zero_seed);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = rndgen_fill(rndgen, buf, sizeof(buf));
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(buf, zero_key_block, sizeof(buf)));
+
+	rndgen_destroy(rndgen);
+}
+
+/** Small requests continue the same stream as one large request */
+PCUT_TEST(fill_split)
+{
+	rndgen_t *whole;
+	rndgen_t *split;
+	uint8_t a[200];
+	uint8_t b[200];
+	uint32_t w;
+	uint8_t c;
+	errno_t rc;
+
+	rc = rndgen_create_seeded(&whole, zero_seed);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = rndgen_create_seeded(&split, zero_seed);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = rndgen_fill(whole, a, sizeof(a));
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = rndgen_uint8(split, &c);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	b[0] = c;
+
+	rc = rndgen_uint32(split, &w);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	b[1] = w & 0xff;
+	b[2] = (w >> 8) & 0xff;
+	b[3] = (w >> 16) & 0xff;
+	b[4] = (w >> 24) & 0xff;
+
+	rc = rndgen_fill(split, b + 5, 70);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = rndgen_fill(split, b + 75, 125);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(a, b, sizeof(a)));
+
+	rndgen_destroy(whole);
+	rndgen_destroy(split);
+}
+
+/** Generators keyed from the kernel produce different streams */
+PCUT_TEST(create_distinct)
+{
+	rndgen_t *r1;
+	rndgen_t *r2;
+	uint8_t a[32];
+	uint8_t b[32];
+	errno_t rc;
+
+	rc = rndgen_create(&r1);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = rndgen_create(&r2);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = rndgen_fill(r1, a, sizeof(a));
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = rndgen_fill(r2, b, sizeof(b));
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	PCUT_ASSERT_TRUE(memcmp(a, b, sizeof(a)) != 0);
+
+	rndgen_destroy(r1);
+	rndgen_destroy(r2);
+}
+
+PCUT_EXPORT(rndgen);
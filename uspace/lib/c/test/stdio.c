@@ -37,6 +37,7 @@
 #include <errno.h>
 #include <pcut/pcut.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <str.h>
 #include <tmpfile.h>
 #include <vfs/vfs.h>
@@ -203,6 +204,106 @@ PCUT_TEST(fgetpos_setpos)
 	(void) fclose(f);
 }
 
+enum {
+	/** Size of a file larger than the stream buffer */
+	large_file_size = 200000
+};
+
+/** Read back a large file written by fwrite() in mode @a mode. */
+static void large_file_check(const char *path, const char *mode,
+    const uint8_t *data)
+{
+	uint8_t *rbuf;
+	FILE *f;
+	size_t n;
+
+	rbuf = malloc(large_file_size);
+	PCUT_ASSERT_NOT_NULL(rbuf);
+
+	f = fopen(path, mode);
+	PCUT_ASSERT_NOT_NULL(f);
+
+	/* Mix small buffered reads with large ones. */
+	n = fread(rbuf, 1, 10, f);
+	PCUT_ASSERT_INT_EQUALS(10, n);
+	n = fread(rbuf + 10, 1, large_file_size - 20, f);
+	PCUT_ASSERT_INT_EQUALS(large_file_size - 20, n);
+	n = fread(rbuf + large_file_size - 10, 1, 20, f);
+	PCUT_ASSERT_INT_EQUALS(10, n);
+	PCUT_ASSERT_TRUE(feof(f));
+
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(data, rbuf, large_file_size));
+
+	fclose(f);
+	free(rbuf);
+}
+
+/** Large reads and writes bypassing the stream buffer */
+PCUT_TEST(large_file)
+{
+	char buf[L_tmpnam];
+	uint8_t *data;
+	char *p;
+	FILE *f;
+	size_t n;
+	size_t i;
+
+	data = malloc(large_file_size);
+	PCUT_ASSERT_NOT_NULL(data);
+
+	for (i = 0; i < large_file_size; i++)
+		data[i] = i % 251;
+
+	p = tmpnam(buf);
+	PCUT_ASSERT_NOT_NULL(p);
+
+	f = fopen(p, "wx");
+	PCUT_ASSERT_NOT_NULL(f);
+
+	n = fwrite(data, 1, 5, f);
+	PCUT_ASSERT_INT_EQUALS(5, n);
+	n = fwrite(data + 5, 1, large_file_size - 5, f);
+	PCUT_ASSERT_INT_EQUALS(large_file_size - 5, n);
+	PCUT_ASSERT_INT_EQUALS(0, fclose(f));
+
+	large_file_check(p, "r", data);
+	large_file_check(p, "rm", data);
+
+	(void) remove(p);
+	free(data);
+}
+
+/** Memory-mapped mode is only allowed for reading */
+PCUT_TEST(fopen_map_mode)
+{
+	char buf[L_tmpnam];
+	char *p;
+	FILE *f;
+
+	p = tmpnam(buf);
+	PCUT_ASSERT_NOT_NULL(p);
+
+	f = fopen(p, "wm");
+	PCUT_ASSERT_NULL(f);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, errno);
+
+	f = fopen(p, "wx");
+	PCUT_ASSERT_NOT_NULL(f);
+	fclose(f);
+
+	f = fopen(p, "r+m");
+	PCUT_ASSERT_NULL(f);
+
+	/* Empty files cannot be mapped, but can still be opened. */
+	f = fopen(p, "rm");
+	PCUT_ASSERT_NOT_NULL(f);
+	PCUT_ASSERT_INT_EQUALS(EOF, fgetc(f));
+	PCUT_ASSERT_TRUE(feof(f));
+	fclose(f);
+
+	(void) remove(p);
+}
+
 /** perror function with NULL as argument */
 PCUT_TEST(perror_null_msg)
 {
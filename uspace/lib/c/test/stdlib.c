@@ -75,6 +75,44 @@ PCUT_TEST(strtold)
 	PCUT_ASSERT_TRUE(ld == 42.0);
 }
 
+/** strtod function is correctly rounded */
+PCUT_TEST(strtod_rounding)
+{
+	char *endptr;
+	const char *str = "0.1";
+
+	PCUT_ASSERT_TRUE(strtod(str, &endptr) == 0.1);
+	PCUT_ASSERT_TRUE(endptr == str + 3);
+
+	PCUT_ASSERT_TRUE(strtod("1e23", NULL) == 1e23);
+	PCUT_ASSERT_TRUE(strtod("-2.2250738585072014e-308", NULL) ==
+	    -2.2250738585072014e-308);
+	PCUT_ASSERT_TRUE(strtod("1.7976931348623157e308", NULL) ==
+	    1.7976931348623157e308);
+
+	/* More digits than fit into 64 bits */
+	str = "3.14159265358979323846264338327950288";
+	PCUT_ASSERT_TRUE(strtod(str, &endptr) == 3.141592653589793);
+	PCUT_ASSERT_TRUE(*endptr == '\0');
+
+	str = "123456789012345678901234567890e-10";
+	PCUT_ASSERT_TRUE(strtod(str, NULL) == 12345678901234567890.1234567890);
+
+	PCUT_ASSERT_TRUE(strtof("0.1", NULL) == 0.1f);
+}
+
+/** strtold function keeps long double precision */
+PCUT_TEST(strtold_precision)
+{
+	char *endptr;
+	const char *str = "0.1";
+
+	/* Neither value is exactly representable in double */
+	PCUT_ASSERT_TRUE(strtold(str, &endptr) == 0.1L);
+	PCUT_ASSERT_TRUE(endptr == str + 3);
+	PCUT_ASSERT_TRUE(strtold("0.3", NULL) == 0.3L);
+}
+
 /** rand function */
 PCUT_TEST(rand)
 {
@@ -114,4 +114,74 @@ PCUT_TEST(str_str_empty_n)
 	PCUT_ASSERT_TRUE((const char *)p == hs);
 }
 
+PCUT_TEST(str_length_mixed)
+{
+	size_t i;
+
+	/* Unaligned starts and ASCII runs longer than a word. */
+	SET_BUFFER("xabcdefghijklmnopqrstuvwšabcdefghijklmnopqrstuvw");
+	for (i = 0; i < 8; i++) {
+		PCUT_ASSERT_INT_EQUALS(48 - i, str_length(buffer + i));
+		PCUT_ASSERT_INT_EQUALS(49 - i, str_size(buffer + i));
+		PCUT_ASSERT_INT_EQUALS(48 - i, str_width(buffer + i));
+	}
+
+	PCUT_ASSERT_INT_EQUALS(29, str_nlength(buffer, 30));
+	PCUT_ASSERT_INT_EQUALS(25, str_nlength(buffer, 26));
+	PCUT_ASSERT_INT_EQUALS(26, str_nlength(buffer, 27));
+}
+
+PCUT_TEST(str_decode_buf)
+{
+	char32_t buf[64];
+	size_t off;
+	size_t n;
+
+	SET_BUFFER("abcdefghijklmnopqrstuvwxyz-šč-0123456789");
+
+	off = 0;
+	n = str_decode_buf(buffer, &off, str_size(buffer), buf, 64);
+	PCUT_ASSERT_INT_EQUALS(40, n);
+	PCUT_ASSERT_INT_EQUALS(42, off);
+	PCUT_ASSERT_INT_EQUALS('a', buf[0]);
+	PCUT_ASSERT_INT_EQUALS('z', buf[25]);
+	PCUT_ASSERT_INT_EQUALS(L'š', buf[27]);
+	PCUT_ASSERT_INT_EQUALS(L'č', buf[28]);
+	PCUT_ASSERT_INT_EQUALS('9', buf[39]);
+
+	/* Stops after count characters. */
+	off = 1;
+	n = str_decode_buf(buffer, &off, str_size(buffer), buf, 27);
+	PCUT_ASSERT_INT_EQUALS(27, n);
+	PCUT_ASSERT_INT_EQUALS(29, off);
+	PCUT_ASSERT_INT_EQUALS(L'š', buf[26]);
+
+	/* Null characters are decoded as zero. */
+	off = 0;
+	n = str_decode_buf("ab\0cd", &off, 5, buf, 64);
+	PCUT_ASSERT_INT_EQUALS(5, n);
+	PCUT_ASSERT_INT_EQUALS(0, buf[2]);
+	PCUT_ASSERT_INT_EQUALS('d', buf[4]);
+}
+
+PCUT_TEST(str_check)
+{
+	PCUT_ASSERT_TRUE(str_check("plain ascii text, longer than a word",
+	    STR_NO_LIMIT));
+	PCUT_ASSERT_TRUE(str_check("šč \xf0\x9f\x98\x80", STR_NO_LIMIT));
+
+	/* Stray continuation byte */
+	PCUT_ASSERT_FALSE(str_check("abc\x80", STR_NO_LIMIT));
+	/* Overlong encoding of '/' */
+	PCUT_ASSERT_FALSE(str_check("\xc0\xaf", STR_NO_LIMIT));
+	/* Surrogate */
+	PCUT_ASSERT_FALSE(str_check("\xed\xa0\x80", STR_NO_LIMIT));
+	/* Above U+10FFFF */
+	PCUT_ASSERT_FALSE(str_check("\xf4\x90\x80\x80", STR_NO_LIMIT));
+	/* Truncated by the size or by the terminator */
+	PCUT_ASSERT_FALSE(str_check("ab\xc5\xa1", 3));
+	PCUT_ASSERT_FALSE(str_check("ab\xc5", STR_NO_LIMIT));
+	PCUT_ASSERT_TRUE(str_check("ab\xc5\xa1", 4));
+}
+
 PCUT_EXPORT(str);
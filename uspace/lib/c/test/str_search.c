@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pcut/pcut.h>
+#include <str.h>
+#include <str_search.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(str_search);
+
+/** Forward search finds the first match */
+PCUT_TEST(first)
+{
+	const char *hs = "abcabcabd";
+	str_search_t s;
+
+	str_search_init(&s, "abc", false);
+	PCUT_ASSERT_TRUE(str_search_first(&s, hs, str_size(hs)) == hs);
+	PCUT_ASSERT_TRUE(str_search_first(&s, hs + 1, 8) == hs + 3);
+
+	str_search_init(&s, "abd", false);
+	PCUT_ASSERT_TRUE(str_search_first(&s, hs, str_size(hs)) == hs + 6);
+	PCUT_ASSERT_NULL(str_search_first(&s, hs, 8));
+
+	str_search_init(&s, "c", false);
+	PCUT_ASSERT_TRUE(str_search_first(&s, hs, str_size(hs)) == hs + 2);
+}
+
+/** Backward search finds the last match */
+PCUT_TEST(last)
+{
+	const char *hs = "abcabcabd";
+	str_search_t s;
+
+	str_search_init(&s, "abc", false);
+	PCUT_ASSERT_TRUE(str_search_last(&s, hs, str_size(hs)) == hs + 3);
+	PCUT_ASSERT_TRUE(str_search_last(&s, hs, 5) == hs);
+	PCUT_ASSERT_NULL(str_search_last(&s, hs, 2));
+
+	str_search_init(&s, "d", false);
+	PCUT_ASSERT_TRUE(str_search_last(&s, hs, str_size(hs)) == hs + 8);
+}
+
+/** Case-insensitive search folds ASCII letters only */
+PCUT_TEST(icase)
+{
+	const char *hs = "Hello \xc3\x89t\xc3\xa9 WORLD";
+	str_search_t s;
+
+	str_search_init(&s, "world", true);
+	PCUT_ASSERT_TRUE(str_search_first(&s, hs, str_size(hs)) == hs + 13);
+	PCUT_ASSERT_TRUE(str_search_last(&s, hs, str_size(hs)) == hs + 13);
+
+	str_search_init(&s, "world", false);
+	PCUT_ASSERT_NULL(str_search_first(&s, hs, str_size(hs)));
+
+	/* Non-ASCII letters are not folded. */
+	str_search_init(&s, "\xc3\xa9t\xc3\xa9", true);
+	PCUT_ASSERT_NULL(str_search_first(&s, hs, str_size(hs)));
+	str_search_init(&s, "\xc3\x89T\xc3\xa9", true);
+	PCUT_ASSERT_TRUE(str_search_first(&s, hs, str_size(hs)) == hs + 6);
+}
+
+/** Empty pattern matches at the start or at the end */
+PCUT_TEST(empty)
+{
+	const char *hs = "abc";
+	str_search_t s;
+
+	str_search_init(&s, "", false);
+	PCUT_ASSERT_TRUE(str_search_first(&s, hs, 3) == hs);
+	PCUT_ASSERT_TRUE(str_search_last(&s, hs, 3) == hs + 3);
+	PCUT_ASSERT_TRUE(str_search_mem(hs, 3, "", 0, false) == hs);
+}
+
+/** Two-way search copes with periodic patterns */
+PCUT_TEST(mem_periodic)
+{
+	const char *hs = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab";
+	size_t hsize = str_size(hs);
+
+	PCUT_ASSERT_TRUE(str_search_mem(hs, hsize, "aaaab", 5, false) ==
+	    hs + hsize - 5);
+	PCUT_ASSERT_TRUE(str_search_mem(hs, hsize, "AAb", 3, true) ==
+	    hs + hsize - 3);
+	PCUT_ASSERT_NULL(str_search_mem(hs, hsize, "aaba", 4, false));
+	PCUT_ASSERT_TRUE(str_search_mem(hs, hsize - 1, "aaaaa", 5, false) ==
+	    hs);
+}
+
+/** Two-way search finds the first of overlapping matches */
+PCUT_TEST(mem_overlap)
+{
+	const char *hs = "xabababay";
+
+	PCUT_ASSERT_TRUE(str_search_mem(hs, 9, "abab", 4, false) == hs + 1);
+	PCUT_ASSERT_TRUE(str_search_mem(hs, 9, "baba", 4, false) == hs + 2);
+	PCUT_ASSERT_TRUE(str_search_mem(hs, 9, "abay", 4, false) == hs + 5);
+	PCUT_ASSERT_NULL(str_search_mem(hs, 8, "abay", 4, false));
+}
+
+/** str_casestr function */
+PCUT_TEST(str_casestr)
+{
+	const char *hs = "The Quick Brown Fox";
+
+	PCUT_ASSERT_TRUE(str_casestr(hs, "quick") == hs + 4);
+	PCUT_ASSERT_TRUE(str_casestr(hs, "FOX") == hs + 16);
+	PCUT_ASSERT_NULL(str_casestr(hs, "foxes"));
+	PCUT_ASSERT_NULL(str_str(hs, "quick"));
+}
+
+PCUT_EXPORT(str_search);
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <pcut/pcut.h>
+#include <stdio.h>
+#include <str.h>
+#include <tpoint.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(tpoint);
+
+static TPOINT_DEFINE(test_tp, "test");
+
+/** Nothing is recorded before tracing is enabled */
+PCUT_TEST(disabled)
+{
+	tpoint_event_t ev;
+	size_t n;
+
+	tpoint_hit(&test_tp, 1, 2, 3);
+	n = tpoint_read(&ev, 1);
+	PCUT_ASSERT_INT_EQUALS(0, n);
+}
+
+/** Events are read back in the order they were recorded */
+PCUT_TEST(record_read)
+{
+	tpoint_event_t ev[4];
+	size_t n;
+	errno_t rc;
+
+	rc = tpoint_init(4);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = tpoint_init(4);
+	PCUT_ASSERT_ERRNO_VAL(EBUSY, rc);
+
+	tpoint_begin(&test_tp, 1, 2, 3);
+	tpoint_end(&test_tp);
+
+	n = tpoint_read(ev, 4);
+	PCUT_ASSERT_INT_EQUALS(2, n);
+
+	PCUT_ASSERT_EQUALS(&test_tp, ev[0].tp);
+	PCUT_ASSERT_INT_EQUALS(tpp_begin, ev[0].phase);
+	PCUT_ASSERT_INT_EQUALS(1, ev[0].args[0]);
+	PCUT_ASSERT_INT_EQUALS(2, ev[0].args[1]);
+	PCUT_ASSERT_INT_EQUALS(3, ev[0].args[2]);
+	PCUT_ASSERT_EQUALS(fibril_get_id(), ev[0].fid);
+
+	PCUT_ASSERT_INT_EQUALS(tpp_end, ev[1].phase);
+	PCUT_ASSERT_TRUE(ev[1].ts >= ev[0].ts);
+
+	tpoint_fini();
+}
+
+/** Oldest events are overwritten when the buffer is full */
+PCUT_TEST(wrap)
+{
+	tpoint_event_t ev[4];
+	size_t n;
+	errno_t rc;
+
+	rc = tpoint_init(3);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	tpoint_hit(&test_tp, 1, 0, 0);
+	tpoint_hit(&test_tp, 2, 0, 0);
+	tpoint_hit(&test_tp, 3, 0, 0);
+	tpoint_hit(&test_tp, 4, 0, 0);
+	tpoint_hit(&test_tp, 5, 0, 0);
+
+	n = tpoint_read(ev, 4);
+	PCUT_ASSERT_INT_EQUALS(3, n);
+	PCUT_ASSERT_INT_EQUALS(3, ev[0].args[0]);
+	PCUT_ASSERT_INT_EQUALS(4, ev[1].args[0]);
+	PCUT_ASSERT_INT_EQUALS(5, ev[2].args[0]);
+
+	/* Only the most recent events fit into a smaller buffer */
+	n = tpoint_read(ev, 2);
+	PCUT_ASSERT_INT_EQUALS(2, n);
+	PCUT_ASSERT_INT_EQUALS(4, ev[0].args[0]);
+	PCUT_ASSERT_INT_EQUALS(5, ev[1].args[0]);
+
+	tpoint_fini();
+}
+
+/** Events are exported in the Chrome trace event format */
+PCUT_TEST(export)
+{
+	char buf[512];
+	FILE *f;
+	size_t n;
+	errno_t rc;
+
+	rc = tpoint_init(2);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	tpoint_hit(&test_tp, 42, 0, 0);
+
+	f = tmpfile();
+	PCUT_ASSERT_NOT_NULL(f);
+
+	rc = tpoint_export(f);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rewind(f);
+	n = fread(buf, 1, sizeof(buf) - 1, f);
+	buf[n] = '\0';
+	fclose(f);
+
+	PCUT_ASSERT_TRUE(str_str(buf, "\"traceEvents\"") != NULL);
+	PCUT_ASSERT_TRUE(str_str(buf, "\"name\":\"test\"") != NULL);
+	PCUT_ASSERT_TRUE(str_str(buf, "\"ph\":\"i\"") != NULL);
+	PCUT_ASSERT_TRUE(str_str(buf, "\"a0\":42") != NULL);
+
+	tpoint_fini();
+}
+
+PCUT_EXPORT(tpoint);
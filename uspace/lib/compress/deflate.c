@@ -0,0 +1,1439 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file
+ * @brief Implementation of deflate compression
+ *
+ * A deflate compressor (producing a stream as described by RFC 1951).
+ *
+ * Matches are found using hash chains over a 32 KiB sliding window:
+ * every position is hashed by its first three bytes and the chain of
+ * previous positions with the same hash is searched for the longest
+ * match. Fast levels take the first good match (greedy matching) and
+ * search only a short chain over a reduced distance, higher levels
+ * check whether the match at the next position is longer before
+ * committing to the current one (lazy matching) and search longer
+ * chains.
+ *
+ * Literals and matches are collected in a symbol buffer. When the
+ * buffer is full, or the data of the block is about to leave the
+ * window, a block is emitted using dynamic Huffman codes, fixed
+ * Huffman codes or no compression, whichever is the shortest.
+ *
+ * Input is copied into the window and output is produced through
+ * a pending buffer holding at most one block, so data can be
+ * compressed in chunks of any size.
+ *
+ */
+
+#include <assert.h>
+#include <macros.h>
+#include <mem.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "deflate.h"
+
+/** Window size */
+#define WINDOW_SIZE  32768
+/** Window position mask */
+#define WINDOW_MASK  (WINDOW_SIZE - 1)
+
+/** Number of bits of the hash */
+#define HASH_BITS  15
+/** Number of hash chain heads */
+#define HASH_SIZE  (1 << HASH_BITS)
+/** Hash mask */
+#define HASH_MASK  (HASH_SIZE - 1)
+
+/** Shortest match */
+#define MIN_MATCH  3
+/** Longest match */
+#define MAX_MATCH  258
+
+/** Lookahead needed to find the longest match at any position */
+#define MIN_LOOKAHEAD  (MAX_MATCH + MIN_MATCH + 1)
+/** Longest match distance (keeping lookahead within the window) */
+#define MAX_MATCH_DIST  (WINDOW_SIZE - MIN_LOOKAHEAD)
+
+/** Matches of minimum length further than this are not worth it */
+#define TOO_FAR  4096
+
+/** Empty hash chain */
+#define NIL  0
+
+/** Number of symbols collected in one block */
+#define SYM_BUF_SIZE  16384
+
+/** Longest stored block */
+#define STORED_MAX  65535
+
+/** Maximum bits in the Huffman code */
+#define MAX_HUFFMAN_BIT  15
+/** Maximum bits in the code length code */
+#define MAX_CLEN_BIT  7
+
+/** Number of length codes */
+#define MAX_LEN           29
+/** Number of distance codes */
+#define MAX_DIST          30
+/** Number of order codes */
+#define MAX_ORDER         19
+/** Number of literal/length codes */
+#define MAX_LITLEN        286
+/** Number of fixed literal/length codes */
+#define MAX_FIXED_LITLEN  288
+
+/** End of block symbol */
+#define END_BLOCK  256
+
+/** Match finder strategy */
+typedef enum {
+	/** No compression */
+	ds_stored,
+	/** Greedy matching */
+	ds_fast,
+	/** Lazy matching */
+	ds_lazy
+} deflate_strategy_t;
+
+/** Compression level configuration */
+typedef struct {
+	/** Reduce chain search above this match length */
+	uint16_t good_length;
+	/** Do not look for a better match above this length (lazy) or
+	 * do not insert matched strings above this length (greedy) */
+	uint16_t max_lazy;
+	/** Stop searching above this match length */
+	uint16_t nice_length;
+	/** Maximum number of hash chain entries to check */
+	uint16_t max_chain;
+	/** Maximum match distance */
+	uint16_t max_dist;
+	/** Strategy */
+	deflate_strategy_t strategy;
+} deflate_config_t;
+
+/** Configuration of the compression levels */
+static const deflate_config_t configs[DEFLATE_LEVEL_BEST + 1] = {
+	{ 0, 0, 0, 0, 0, ds_stored },
+	{ 4, 4, 8, 4, 8192, ds_fast },
+	{ 4, 5, 16, 8, 16384, ds_fast },
+	{ 4, 6, 32, 32, MAX_MATCH_DIST, ds_fast },
+	{ 4, 4, 16, 16, MAX_MATCH_DIST, ds_lazy },
+	{ 8, 16, 32, 32, MAX_MATCH_DIST, ds_lazy },
+	{ 8, 16, 128, 128, MAX_MATCH_DIST, ds_lazy },
+	{ 8, 32, 128, 256, MAX_MATCH_DIST, ds_lazy },
+	{ 32, 128, 258, 1024, MAX_MATCH_DIST, ds_lazy },
+	{ 32, 258, 258, 4096, MAX_MATCH_DIST, ds_lazy }
+};
+
+/** Block symbol (literal or match) */
+typedef struct {
+	/** Match distance or zero for a literal */
+	uint16_t dist;
+	/** Match length or literal */
+	uint16_t lc;
+} deflate_sym_t;
+
+/** Huffman code */
+typedef struct {
+	/** Bit-reversed code */
+	uint16_t code;
+	/** Code length */
+	uint8_t len;
+} deflate_code_t;
+
+/** Code length code token */
+typedef struct {
+	/** Code length code symbol */
+	uint8_t sym;
+	/** Value of extra bits */
+	uint8_t extra;
+} deflate_token_t;
+
+/** Deflate algorithm state
+ *
+ */
+struct deflate {
+	/** Level configuration */
+	const deflate_config_t *config;
+
+	/** Window (two window sizes to allow sliding) */
+	uint8_t *window;
+	/** Hash chain heads */
+	uint16_t *head;
+	/** Previous positions with the same hash */
+	uint16_t *prev;
+
+	/** Current position in the window */
+	size_t strstart;
+	/** Number of valid bytes after the current position */
+	size_t lookahead;
+	/** Start of the current block in the window */
+	size_t block_start;
+
+	/** Length of the best match at the current position */
+	size_t match_length;
+	/** Start of the best match at the current position */
+	size_t match_start;
+	/** Length of the best match at the previous position (lazy) */
+	size_t prev_length;
+	/** Start of the best match at the previous position (lazy) */
+	size_t prev_match;
+	/** Literal at the previous position not emitted yet (lazy) */
+	bool match_available;
+
+	/** Symbols of the current block */
+	deflate_sym_t *syms;
+	/** Number of symbols in the current block */
+	size_t nsyms;
+	/** Literal/length code frequencies */
+	uint32_t lit_freq[MAX_FIXED_LITLEN];
+	/** Distance code frequencies */
+	uint32_t dist_freq[MAX_DIST];
+
+	/** Fixed literal/length codes */
+	deflate_code_t fixed_lit[MAX_FIXED_LITLEN];
+	/** Fixed distance codes */
+	deflate_code_t fixed_dist[MAX_DIST];
+
+	/** Output waiting to be returned */
+	uint8_t *pending;
+	/** Number of bytes in the pending buffer */
+	size_t pend_len;
+	/** Number of bytes already returned from the pending buffer */
+	size_t pend_out;
+
+	/** Bit buffer */
+	uint64_t bitbuf;
+	/** Number of bits in the bit buffer */
+	unsigned bitcnt;
+
+	/** Last block has been emitted */
+	bool done;
+};
+
+/** Length codes
+ *
+ */
+static const uint16_t lens[MAX_LEN] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+/** Extended length codes
+ *
+ */
+static const uint8_t lens_ext[MAX_LEN] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+/** Distance codes
+ *
+ */
+static const uint16_t dists[MAX_DIST] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+	8193, 12289, 16385, 24577
+};
+
+/** Extended distance codes
+ *
+ */
+static const uint8_t dists_ext[MAX_DIST] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11,
+	12, 12, 13, 13
+};
+
+/** Order codes
+ *
+ */
+static const uint8_t order[MAX_ORDER] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+/** Determine index of the most significant bit
+ *
+ * @param val Value (non-zero).
+ *
+ * @return Bit index.
+ *
+ */
+static inline unsigned msb_index(unsigned val)
+{
+	return (unsigned) (sizeof(unsigned) * 8 - 1) - __builtin_clz(val);
+}
+
+/** Get length code for a match length
+ *
+ * @param length Match length (3 to 258).
+ *
+ * @return Length code index (0 to 28).
+ *
+ */
+static inline unsigned length_code(unsigned length)
+{
+	unsigned val = length - MIN_MATCH;
+	unsigned nb;
+
+	if (val < 8)
+		return val;
+
+	if (length == MAX_MATCH)
+		return MAX_LEN - 1;
+
+	/* Four codes for each power of two */
+	nb = msb_index(val);
+	return 4 * (nb - 1) + ((val >> (nb - 2)) & 3);
+}
+
+/** Get distance code for a match distance
+ *
+ * @param dist Match distance (1 to 32768).
+ *
+ * @return Distance code index (0 to 29).
+ *
+ */
+static inline unsigned dist_code(unsigned dist)
+{
+	unsigned val = dist - 1;
+	unsigned nb;
+
+	if (val < 4)
+		return val;
+
+	/* Two codes for each power of two */
+	nb = msb_index(val);
+	return 2 * nb + ((val >> (nb - 1)) & 1);
+}
+
+/** Write bits to the pending buffer
+ *
+ * @param state Deflate state.
+ * @param val   Bits (least significant first).
+ * @param cnt   Number of bits (at most 16).
+ *
+ */
+static inline void put_bits(deflate_t *state, unsigned val, unsigned cnt)
+{
+	state->bitbuf |= ((uint64_t) val) << state->bitcnt;
+	state->bitcnt += cnt;
+
+	while (state->bitcnt >= 8) {
+		state->pending[state->pend_len++] = (uint8_t) state->bitbuf;
+		state->bitbuf >>= 8;
+		state->bitcnt -= 8;
+	}
+}
+
+/** Pad the pending bits with zeroes to a byte boundary
+ *
+ * @param state Deflate state.
+ *
+ */
+static void put_align(deflate_t *state)
+{
+	if (state->bitcnt > 0)
+		put_bits(state, 0, 8 - state->bitcnt);
+}
+
+/** Write Huffman code to the pending buffer
+ *
+ * @param state Deflate state.
+ * @param code  Huffman code.
+ *
+ */
+static inline void put_code(deflate_t *state, const deflate_code_t *code)
+{
+	put_bits(state, code->code, code->len);
+}
+
+/** Code frequency and symbol for sorting */
+typedef struct {
+	uint32_t freq;
+	uint16_t sym;
+} deflate_leaf_t;
+
+/** Compare leaves by frequency (and symbol for stable ordering)
+ *
+ * @param a First leaf.
+ * @param b Second leaf.
+ *
+ * @return Less than, equal to or greater than zero.
+ *
+ */
+static int leaf_cmp(const void *a, const void *b)
+{
+	const deflate_leaf_t *la = (const deflate_leaf_t *) a;
+	const deflate_leaf_t *lb = (const deflate_leaf_t *) b;
+
+	if (la->freq != lb->freq)
+		return (la->freq < lb->freq) ? -1 : 1;
+
+	return (int) la->sym - (int) lb->sym;
+}
+
+/** Compute Huffman code lengths from sorted frequencies
+ *
+ * In-place computation of minimum redundancy codes by Moffat and
+ * Katajainen. On input, @a a contains frequencies in ascending order,
+ * on output it contains the corresponding code lengths.
+ *
+ * @param a Frequencies/code lengths.
+ * @param n Number of symbols (at least two).
+ *
+ */
+static void huffman_lengths(uint32_t *a, size_t n)
+{
+	size_t root, leaf, next;
+	size_t avail, used, depth;
+
+	/* Phase 1: compute parent pointers and internal node weights */
+	a[0] += a[1];
+	root = 0;
+	leaf = 2;
+	for (next = 1; next < n - 1; next++) {
+		if (leaf >= n || a[root] < a[leaf]) {
+			a[next] = a[root];
+			a[root++] = next;
+		} else {
+			a[next] = a[leaf++];
+		}
+
+		if (leaf >= n || (root < next && a[root] < a[leaf])) {
+			a[next] += a[root];
+			a[root++] = next;
+		} else {
+			a[next] += a[leaf++];
+		}
+	}
+
+	/* Phase 2: compute depths of the internal nodes */
+	a[n - 2] = 0;
+	for (next = n - 2; next-- > 0;)
+		a[next] = a[a[next]] + 1;
+
+	/* Phase 3: compute depths of the leaves */
+	avail = 1;
+	used = 0;
+	depth = 0;
+	root = n - 2;
+	next = n;
+	while (avail > 0) {
+		while (root != (size_t) -1 && a[root] == depth) {
+			used++;
+			root--;
+		}
+
+		while (avail > used) {
+			a[--next] = depth;
+			avail--;
+		}
+
+		avail = 2 * used;
+		depth++;
+		used = 0;
+	}
+}
+
+/** Assign canonical Huffman codes
+ *
+ * @param code Codes with lengths filled in.
+ * @param n    Number of symbols.
+ *
+ */
+static void huffman_codes(deflate_code_t *code, size_t n)
+{
+	uint16_t count[MAX_HUFFMAN_BIT + 1];
+	uint16_t next_code[MAX_HUFFMAN_BIT + 1];
+	size_t sym;
+	unsigned len;
+	unsigned c;
+	unsigned i;
+
+	for (len = 0; len <= MAX_HUFFMAN_BIT; len++)
+		count[len] = 0;
+
+	for (sym = 0; sym < n; sym++)
+		count[code[sym].len]++;
+
+	/* First canonical code of each length */
+	c = 0;
+	count[0] = 0;
+	for (len = 1; len <= MAX_HUFFMAN_BIT; len++) {
+		c = (c + count[len - 1]) << 1;
+		next_code[len] = c;
+	}
+
+	for (sym = 0; sym < n; sym++) {
+		len = code[sym].len;
+		if (len == 0)
+			continue;
+
+		/* Codes are sent starting with the most significant bit */
+		c = next_code[len]++;
+		code[sym].code = 0;
+		for (i = 0; i < len; i++) {
+			code[sym].code = (code[sym].code << 1) | (c & 1);
+			c >>= 1;
+		}
+	}
+}
+
+/** Construct length-limited Huffman code
+ *
+ * The code always has at least two symbols, so that it is complete.
+ * If the code would be longer than allowed, the frequencies are
+ * flattened and the code is computed again.
+ *
+ * @param freq  Symbol frequencies.
+ * @param n     Number of symbols.
+ * @param limit Maximum code length.
+ * @param code  Place to store the codes.
+ *
+ */
+static void huffman_build(const uint32_t *freq, size_t n, unsigned limit,
+    deflate_code_t *code)
+{
+	deflate_leaf_t leaf[MAX_FIXED_LITLEN];
+	uint32_t a[MAX_FIXED_LITLEN];
+	size_t nleaves = 0;
+	size_t sym;
+	size_t i;
+	unsigned shift = 0;
+
+	assert(n <= MAX_FIXED_LITLEN);
+
+	for (sym = 0; sym < n; sym++) {
+		code[sym].len = 0;
+		if (freq[sym] != 0) {
+			leaf[nleaves].freq = freq[sym];
+			leaf[nleaves].sym = sym;
+			nleaves++;
+		}
+	}
+
+	/* Make sure there are at least two codes */
+	for (sym = 0; nleaves < 2; sym++) {
+		if (freq[sym] == 0) {
+			leaf[nleaves].freq = 1;
+			leaf[nleaves].sym = sym;
+			nleaves++;
+		}
+	}
+
+	qsort(leaf, nleaves, sizeof(deflate_leaf_t), leaf_cmp);
+
+	while (true) {
+		for (i = 0; i < nleaves; i++)
+			a[i] = ((leaf[i].freq - 1) >> shift) + 1;
+
+		huffman_lengths(a, nleaves);
+
+		/* The least frequent symbol has the longest code */
+		if (a[0] <= limit)
+			break;
+
+		shift++;
+	}
+
+	for (i = 0; i < nleaves; i++)
+		code[leaf[i].sym].len = a[i];
+
+	huffman_codes(code, n);
+}
+
+/** Construct fixed Huffman codes
+ *
+ * @param state Deflate state.
+ *
+ */
+static void deflate_fixed_codes(deflate_t *state)
+{
+	size_t sym;
+
+	for (sym = 0; sym < MAX_FIXED_LITLEN; sym++) {
+		if (sym < 144)
+			state->fixed_lit[sym].len = 8;
+		else if (sym < 256)
+			state->fixed_lit[sym].len = 9;
+		else if (sym < 280)
+			state->fixed_lit[sym].len = 7;
+		else
+			state->fixed_lit[sym].len = 8;
+	}
+
+	for (sym = 0; sym < MAX_DIST; sym++)
+		state->fixed_dist[sym].len = 5;
+
+	huffman_codes(state->fixed_lit, MAX_FIXED_LITLEN);
+	huffman_codes(state->fixed_dist, MAX_DIST);
+}
+
+/** Record literal in the current block
+ *
+ * @param state Deflate state.
+ * @param c     Literal.
+ *
+ * @return True if the block should be emitted.
+ *
+ */
+static inline bool deflate_tally_lit(deflate_t *state, uint8_t c)
+{
+	state->syms[state->nsyms].dist = 0;
+	state->syms[state->nsyms].lc = c;
+	state->nsyms++;
+	state->lit_freq[c]++;
+
+	return state->nsyms >= SYM_BUF_SIZE;
+}
+
+/** Record match in the current block
+ *
+ * @param state  Deflate state.
+ * @param dist   Match distance.
+ * @param length Match length.
+ *
+ * @return True if the block should be emitted.
+ *
+ */
+static inline bool deflate_tally_match(deflate_t *state, size_t dist,
+    size_t length)
+{
+	assert(dist >= 1 && dist <= WINDOW_SIZE);
+	assert(length >= MIN_MATCH && length <= MAX_MATCH);
+
+	state->syms[state->nsyms].dist = dist;
+	state->syms[state->nsyms].lc = length;
+	state->nsyms++;
+	state->lit_freq[END_BLOCK + 1 + length_code(length)]++;
+	state->dist_freq[dist_code(dist)]++;
+
+	return state->nsyms >= SYM_BUF_SIZE;
+}
+
+/** Convert code lengths to code length code tokens
+ *
+ * @param length Code lengths.
+ * @param n      Number of code lengths.
+ * @param token  Place to store the tokens.
+ *
+ * @return Number of tokens.
+ *
+ */
+static size_t deflate_rle_lengths(const uint8_t *length, size_t n,
+    deflate_token_t *token)
+{
+	size_t ntokens = 0;
+	size_t i = 0;
+	size_t run;
+	size_t r;
+
+	while (i < n) {
+		uint8_t len = length[i];
+
+		run = 1;
+		while (i + run < n && length[i + run] == len)
+			run++;
+
+		i += run;
+
+		if (len == 0) {
+			/* Runs of zeroes */
+			while (run >= 11) {
+				r = min(run, (size_t) 138);
+				token[ntokens].sym = 18;
+				token[ntokens++].extra = r - 11;
+				run -= r;
+			}
+
+			if (run >= 3) {
+				token[ntokens].sym = 17;
+				token[ntokens++].extra = run - 3;
+				run = 0;
+			}
+		} else {
+			/* Send the length once, then repeat it */
+			token[ntokens].sym = len;
+			token[ntokens++].extra = 0;
+			run--;
+
+			while (run >= 3) {
+				r = min(run, (size_t) 6);
+				token[ntokens].sym = 16;
+				token[ntokens++].extra = r - 3;
+				run -= r;
+			}
+		}
+
+		while (run > 0) {
+			token[ntokens].sym = len;
+			token[ntokens++].extra = 0;
+			run--;
+		}
+	}
+
+	return ntokens;
+}
+
+/** Compute size of the block symbols coded with the given codes
+ *
+ * @param state Deflate state.
+ * @param lit   Literal/length codes.
+ * @param dist  Distance codes.
+ *
+ * @return Size in bits (without extra bits).
+ *
+ */
+static size_t deflate_data_bits(deflate_t *state, const deflate_code_t *lit,
+    const deflate_code_t *dist)
+{
+	size_t bits = 0;
+	size_t sym;
+
+	for (sym = 0; sym < MAX_LITLEN; sym++)
+		bits += (size_t) state->lit_freq[sym] * lit[sym].len;
+
+	for (sym = 0; sym < MAX_DIST; sym++)
+		bits += (size_t) state->dist_freq[sym] * dist[sym].len;
+
+	return bits;
+}
+
+/** Write block symbols
+ *
+ * @param state Deflate state.
+ * @param lit   Literal/length codes.
+ * @param dist  Distance codes.
+ *
+ */
+static void deflate_put_syms(deflate_t *state, const deflate_code_t *lit,
+    const deflate_code_t *dist)
+{
+	size_t i;
+	unsigned code;
+
+	for (i = 0; i < state->nsyms; i++) {
+		deflate_sym_t *sym = &state->syms[i];
+
+		if (sym->dist == 0) {
+			put_code(state, &lit[sym->lc]);
+			continue;
+		}
+
+		code = length_code(sym->lc);
+		put_code(state, &lit[END_BLOCK + 1 + code]);
+		if (lens_ext[code] != 0)
+			put_bits(state, sym->lc - lens[code], lens_ext[code]);
+
+		code = dist_code(sym->dist);
+		put_code(state, &dist[code]);
+		if (dists_ext[code] != 0) {
+			put_bits(state, sym->dist - dists[code],
+			    dists_ext[code]);
+		}
+	}
+
+	put_code(state, &lit[END_BLOCK]);
+}
+
+/** Write stored block(s)
+ *
+ * @param state Deflate state.
+ * @param data  Block data.
+ * @param len   Length of block data.
+ * @param last  This is the last block.
+ *
+ */
+static void deflate_put_stored(deflate_t *state, const uint8_t *data,
+    size_t len, bool last)
+{
+	do {
+		size_t n = min(len, (size_t) STORED_MAX);
+
+		put_bits(state, (last && n == len) ? 1 : 0, 1);
+		put_bits(state, 0, 2);
+		put_align(state);
+
+		put_bits(state, n & 0xffff, 16);
+		put_bits(state, ~n & 0xffff, 16);
+
+		memcpy(state->pending + state->pend_len, data, n);
+		state->pend_len += n;
+		data += n;
+		len -= n;
+	} while (len > 0);
+}
+
+/** Emit the current block to the pending buffer
+ *
+ * @param state Deflate state.
+ * @param last  This is the last block.
+ *
+ */
+static void deflate_flush_block(deflate_t *state, bool last)
+{
+	deflate_code_t lit[MAX_FIXED_LITLEN];
+	deflate_code_t dist[MAX_DIST];
+	deflate_code_t clen[MAX_ORDER];
+	deflate_token_t token[MAX_LITLEN + MAX_DIST];
+	uint8_t length[MAX_LITLEN + MAX_DIST];
+	uint32_t clen_freq[MAX_ORDER];
+	size_t block_end;
+	size_t block_len;
+	size_t ntokens;
+	size_t extra_bits;
+	size_t dyn_bits;
+	size_t fixed_bits;
+	size_t stored_bits;
+	size_t hlit, hdist, hclen;
+	size_t i;
+
+	/* A literal waiting for the lazy match decision is not included */
+	block_end = state->strstart - (state->match_available ? 1 : 0);
+	block_len = block_end - state->block_start;
+
+	/* Size of the block without compression */
+	stored_bits = (block_len / STORED_MAX + 1) * (3 + 7 + 32) +
+	    8 * block_len;
+
+	if (state->config->strategy == ds_stored) {
+		deflate_put_stored(state, state->window + state->block_start,
+		    block_len, last);
+		goto out;
+	}
+
+	state->lit_freq[END_BLOCK]++;
+
+	/* Extra bits are the same with fixed and dynamic codes */
+	extra_bits = 0;
+	for (i = 0; i < MAX_LEN; i++)
+		extra_bits += (size_t) state->lit_freq[END_BLOCK + 1 + i] *
+		    lens_ext[i];
+	for (i = 0; i < MAX_DIST; i++)
+		extra_bits += (size_t) state->dist_freq[i] * dists_ext[i];
+
+	fixed_bits = 3 + extra_bits + deflate_data_bits(state,
+	    state->fixed_lit, state->fixed_dist);
+
+	/* Construct dynamic codes */
+	huffman_build(state->lit_freq, MAX_LITLEN, MAX_HUFFMAN_BIT, lit);
+	huffman_build(state->dist_freq, MAX_DIST, MAX_HUFFMAN_BIT, dist);
+
+	hlit = MAX_LITLEN;
+	while (hlit > END_BLOCK + 1 && lit[hlit - 1].len == 0)
+		hlit--;
+
+	hdist = MAX_DIST;
+	while (hdist > 1 && dist[hdist - 1].len == 0)
+		hdist--;
+
+	for (i = 0; i < hlit; i++)
+		length[i] = lit[i].len;
+	for (i = 0; i < hdist; i++)
+		length[hlit + i] = dist[i].len;
+
+	ntokens = deflate_rle_lengths(length, hlit + hdist, token);
+
+	for (i = 0; i < MAX_ORDER; i++)
+		clen_freq[i] = 0;
+	for (i = 0; i < ntokens; i++)
+		clen_freq[token[i].sym]++;
+
+	huffman_build(clen_freq, MAX_ORDER, MAX_CLEN_BIT, clen);
+
+	hclen = MAX_ORDER;
+	while (hclen > 4 && clen[order[hclen - 1]].len == 0)
+		hclen--;
+
+	dyn_bits = 3 + 5 + 5 + 4 + 3 * hclen + extra_bits +
+	    deflate_data_bits(state, lit, dist);
+	for (i = 0; i < ntokens; i++) {
+		dyn_bits += clen[token[i].sym].len;
+		if (token[i].sym == 16)
+			dyn_bits += 2;
+		else if (token[i].sym == 17)
+			dyn_bits += 3;
+		else if (token[i].sym == 18)
+			dyn_bits += 7;
+	}
+
+	if (stored_bits <= fixed_bits && stored_bits <= dyn_bits) {
+		deflate_put_stored(state, state->window + state->block_start,
+		    block_len, last);
+	} else if (fixed_bits <= dyn_bits) {
+		put_bits(state, last ? 1 : 0, 1);
+		put_bits(state, 1, 2);
+		deflate_put_syms(state, state->fixed_lit, state->fixed_dist);
+	} else {
+		put_bits(state, last ? 1 : 0, 1);
+		put_bits(state, 2, 2);
+		put_bits(state, hlit - 257, 5);
+		put_bits(state, hdist - 1, 5);
+		put_bits(state, hclen - 4, 4);
+
+		for (i = 0; i < hclen; i++)
+			put_bits(state, clen[order[i]].len, 3);
+
+		for (i = 0; i < ntokens; i++) {
+			put_code(state, &clen[token[i].sym]);
+			if (token[i].sym == 16)
+				put_bits(state, token[i].extra, 2);
+			else if (token[i].sym == 17)
+				put_bits(state, token[i].extra, 3);
+			else if (token[i].sym == 18)
+				put_bits(state, token[i].extra, 7);
+		}
+
+		deflate_put_syms(state, lit, dist);
+	}
+
+out:
+	if (last)
+		put_align(state);
+
+	memset(state->lit_freq, 0, sizeof(state->lit_freq));
+	memset(state->dist_freq, 0, sizeof(state->dist_freq));
+	state->nsyms = 0;
+	state->block_start = block_end;
+}
+
+/** Insert string at position into the hash chains
+ *
+ * @param state Deflate state.
+ * @param pos   Position (at least MIN_MATCH bytes must be available).
+ *
+ * @return Previous head of the hash chain.
+ *
+ */
+static inline size_t deflate_insert(deflate_t *state, size_t pos)
+{
+	const uint8_t *p = state->window + pos;
+	unsigned hash;
+	size_t head;
+
+	hash = (((unsigned) p[0] << 10) ^ ((unsigned) p[1] << 5) ^ p[2]) &
+	    HASH_MASK;
+	head = state->head[hash];
+	state->prev[pos & WINDOW_MASK] = head;
+	state->head[hash] = pos;
+	return head;
+}
+
+/** Find the longest match at the current position
+ *
+ * @param state    Deflate state.
+ * @param cur      Head of the hash chain.
+ * @param best_len Length of the best match found so far.
+ *
+ * @return Length of the longest match (match_start is set if it is
+ *         longer than @a best_len).
+ *
+ */
+static size_t deflate_longest_match(deflate_t *state, size_t cur,
+    size_t best_len)
+{
+	const deflate_config_t *config = state->config;
+	const uint8_t *scan = state->window + state->strstart;
+	size_t chain = config->max_chain;
+	size_t max_len = min(state->lookahead, (size_t) MAX_MATCH);
+	size_t nice = min((size_t) config->nice_length, max_len);
+	size_t limit;
+	size_t len;
+
+	if (best_len >= max_len)
+		return best_len;
+
+	limit = (state->strstart > config->max_dist) ?
+	    state->strstart - config->max_dist : NIL;
+
+	/* Do not waste too much time if we already have a good match */
+	if (best_len >= config->good_length)
+		chain >>= 2;
+
+	do {
+		const uint8_t *match = state->window + cur;
+
+		/* Quickly skip matches which cannot be longer */
+		if (match[best_len] != scan[best_len] ||
+		    match[0] != scan[0] || match[1] != scan[1])
+			continue;
+
+		len = 2;
+		while (len < max_len && match[len] == scan[len])
+			len++;
+
+		if (len > best_len) {
+			state->match_start = cur;
+			best_len = len;
+			if (len >= nice)
+				break;
+		}
+	} while ((cur = state->prev[cur & WINDOW_MASK]) > limit &&
+	    --chain != 0);
+
+	return best_len;
+}
+
+/** Check whether hash chain head is usable for matching
+ *
+ * @param state Deflate state.
+ * @param head  Hash chain head.
+ *
+ * @return True if the position is within the match distance.
+ *
+ */
+static inline bool deflate_head_valid(deflate_t *state, size_t head)
+{
+	return head != NIL && state->strstart - head <= state->config->max_dist;
+}
+
+/** Process input without compression
+ *
+ * @param state Deflate state.
+ * @param flush There is no more input.
+ *
+ * @return True if the current block should be emitted.
+ *
+ */
+static bool deflate_stored(deflate_t *state, bool flush)
+{
+	(void) flush;
+
+	state->strstart += state->lookahead;
+	state->lookahead = 0;
+	return false;
+}
+
+/** Process input with greedy matching
+ *
+ * @param state Deflate state.
+ * @param flush There is no more input.
+ *
+ * @return True if the current block should be emitted.
+ *
+ */
+static bool deflate_fast(deflate_t *state, bool flush)
+{
+	size_t head;
+	bool bflush;
+
+	while (true) {
+		if (state->lookahead < MIN_LOOKAHEAD && !flush)
+			return false;
+		if (state->lookahead == 0)
+			return false;
+
+		head = NIL;
+		if (state->lookahead >= MIN_MATCH)
+			head = deflate_insert(state, state->strstart);
+
+		state->match_length = MIN_MATCH - 1;
+		if (deflate_head_valid(state, head)) {
+			state->match_length = deflate_longest_match(state,
+			    head, MIN_MATCH - 1);
+		}
+
+		if (state->match_length >= MIN_MATCH) {
+			bflush = deflate_tally_match(state,
+			    state->strstart - state->match_start,
+			    state->match_length);
+			state->lookahead -= state->match_length;
+
+			if (state->match_length <= state->config->max_lazy &&
+			    state->lookahead >= MIN_MATCH) {
+				/* Insert the matched strings, too */
+				state->match_length--;
+				do {
+					state->strstart++;
+					(void) deflate_insert(state,
+					    state->strstart);
+				} while (--state->match_length != 0);
+				state->strstart++;
+			} else {
+				state->strstart += state->match_length;
+				state->match_length = 0;
+			}
+		} else {
+			bflush = deflate_tally_lit(state,
+			    state->window[state->strstart]);
+			state->lookahead--;
+			state->strstart++;
+		}
+
+		if (bflush)
+			return true;
+	}
+}
+
+/** Process input with lazy matching
+ *
+ * A match is only emitted if there is no longer match at the next
+ * position.
+ *
+ * @param state Deflate state.
+ * @param flush There is no more input.
+ *
+ * @return True if the current block should be emitted.
+ *
+ */
+static bool deflate_lazy(deflate_t *state, bool flush)
+{
+	size_t head;
+	size_t max_insert;
+	bool bflush;
+
+	while (true) {
+		if (state->lookahead < MIN_LOOKAHEAD && !flush)
+			return false;
+		if (state->lookahead == 0)
+			break;
+
+		head = NIL;
+		if (state->lookahead >= MIN_MATCH)
+			head = deflate_insert(state, state->strstart);
+
+		state->prev_length = state->match_length;
+		state->prev_match = state->match_start;
+		state->match_length = MIN_MATCH - 1;
+
+		if (deflate_head_valid(state, head) &&
+		    state->prev_length < state->config->max_lazy) {
+			state->match_length = deflate_longest_match(state,
+			    head, state->prev_length);
+
+			/* Short far matches are likely more expensive */
+			if (state->match_length == MIN_MATCH &&
+			    state->strstart - state->match_start > TOO_FAR)
+				state->match_length = MIN_MATCH - 1;
+		}
+
+		if (state->prev_length >= MIN_MATCH &&
+		    state->match_length <= state->prev_length) {
+			/* Emit the match at the previous position */
+			max_insert = state->strstart + state->lookahead -
+			    MIN_MATCH;
+
+			bflush = deflate_tally_match(state,
+			    state->strstart - 1 - state->prev_match,
+			    state->prev_length);
+
+			state->lookahead -= state->prev_length - 1;
+			state->prev_length -= 2;
+			do {
+				if (++state->strstart <= max_insert)
+					(void) deflate_insert(state,
+					    state->strstart);
+			} while (--state->prev_length != 0);
+
+			state->match_available = false;
+			state->match_length = MIN_MATCH - 1;
+			state->strstart++;
+
+			if (bflush)
+				return true;
+		} else if (state->match_available) {
+			/* No better match, emit the previous literal */
+			bflush = deflate_tally_lit(state,
+			    state->window[state->strstart - 1]);
+			state->strstart++;
+			state->lookahead--;
+
+			if (bflush)
+				return true;
+		} else {
+			/* Wait for the next position to decide */
+			state->match_available = true;
+			state->strstart++;
+			state->lookahead--;
+		}
+	}
+
+	if (state->match_available) {
+		(void) deflate_tally_lit(state,
+		    state->window[state->strstart - 1]);
+		state->match_available = false;
+	}
+
+	return false;
+}
+
+/** Slide the window by one window size
+ *
+ * @param state Deflate state.
+ *
+ */
+static void deflate_slide(deflate_t *state)
+{
+	size_t i;
+
+	memcpy(state->window, state->window + WINDOW_SIZE, WINDOW_SIZE);
+	state->strstart -= WINDOW_SIZE;
+	state->block_start -= WINDOW_SIZE;
+
+	/* May wrap around, but only differences are used */
+	state->match_start -= WINDOW_SIZE;
+
+	for (i = 0; i < HASH_SIZE; i++) {
+		state->head[i] = (state->head[i] >= WINDOW_SIZE) ?
+		    state->head[i] - WINDOW_SIZE : NIL;
+	}
+
+	for (i = 0; i < WINDOW_SIZE; i++) {
+		state->prev[i] = (state->prev[i] >= WINDOW_SIZE) ?
+		    state->prev[i] - WINDOW_SIZE : NIL;
+	}
+}
+
+/** Create deflate state for streaming compression
+ *
+ * @param rstate Place to store pointer to new deflate state.
+ * @param level  Compression level (DEFLATE_LEVEL_NONE to
+ *               DEFLATE_LEVEL_BEST).
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM if out of memory.
+ *
+ */
+errno_t deflate_init(deflate_t **rstate, int level)
+{
+	deflate_t *state;
+
+	if (level < DEFLATE_LEVEL_NONE || level > DEFLATE_LEVEL_BEST)
+		return EINVAL;
+
+	state = calloc(1, sizeof(deflate_t));
+	if (state == NULL)
+		return ENOMEM;
+
+	state->config = &configs[level];
+	state->window = malloc(2 * WINDOW_SIZE);
+	state->head = calloc(HASH_SIZE, sizeof(uint16_t));
+	state->prev = calloc(WINDOW_SIZE, sizeof(uint16_t));
+	state->syms = malloc(SYM_BUF_SIZE * sizeof(deflate_sym_t));
+	/* Output of a block is never longer than the block stored */
+	state->pending = malloc(2 * WINDOW_SIZE + 64);
+
+	if (state->window == NULL || state->head == NULL ||
+	    state->prev == NULL || state->syms == NULL ||
+	    state->pending == NULL) {
+		deflate_destroy(state);
+		return ENOMEM;
+	}
+
+	state->match_length = MIN_MATCH - 1;
+	deflate_fixed_codes(state);
+
+	*rstate = state;
+	return EOK;
+}
+
+/** Destroy deflate state
+ *
+ * @param state Deflate state.
+ *
+ */
+void deflate_destroy(deflate_t *state)
+{
+	if (state == NULL)
+		return;
+
+	free(state->window);
+	free(state->head);
+	free(state->prev);
+	free(state->syms);
+	free(state->pending);
+	free(state);
+}
+
+/** Compress chunk of data
+ *
+ * Consume as much of the input and fill as much of the output buffer
+ * as possible. Call again with more input and/or a new output buffer
+ * until EOK is returned. Once @a finish is set, it must be set in all
+ * following calls.
+ *
+ * @param state     Deflate state.
+ * @param src       Source data buffer.
+ * @param srclen    Source buffer size (bytes).
+ * @param rconsumed Place to store number of bytes consumed.
+ * @param dest      Destination data buffer.
+ * @param destlen   Destination buffer size (bytes).
+ * @param rproduced Place to store number of bytes produced.
+ * @param finish    The source buffer contains the end of the input.
+ *
+ * @return EOK when the end of the stream has been written.
+ * @return EAGAIN if more input or output space is needed.
+ *
+ */
+errno_t deflate_step(deflate_t *state, const void *src, size_t srclen,
+    size_t *rconsumed, void *dest, size_t destlen, size_t *rproduced,
+    bool finish)
+{
+	const uint8_t *in = (const uint8_t *) src;
+	uint8_t *out = (uint8_t *) dest;
+	size_t consumed = 0;
+	size_t produced = 0;
+	size_t space;
+	size_t n;
+	bool flush;
+	bool bflush;
+	errno_t rc;
+
+	while (true) {
+		/* Return pending output */
+		n = min(state->pend_len - state->pend_out, destlen - produced);
+		memcpy(out + produced, state->pending + state->pend_out, n);
+		state->pend_out += n;
+		produced += n;
+
+		if (state->pend_out < state->pend_len) {
+			rc = EAGAIN;
+			break;
+		}
+
+		state->pend_len = 0;
+		state->pend_out = 0;
+
+		if (state->done) {
+			rc = EOK;
+			break;
+		}
+
+		/* Make room for more input */
+		if (state->strstart >= 2 * WINDOW_SIZE - MIN_LOOKAHEAD) {
+			if (state->block_start < WINDOW_SIZE) {
+				/* Block data would leave the window */
+				deflate_flush_block(state, false);
+				continue;
+			}
+
+			deflate_slide(state);
+		}
+
+		space = 2 * WINDOW_SIZE - state->strstart - state->lookahead;
+		n = min(srclen - consumed, space);
+		memcpy(state->window + state->strstart + state->lookahead,
+		    in + consumed, n);
+		state->lookahead += n;
+		consumed += n;
+
+		flush = finish && consumed == srclen;
+
+		switch (state->config->strategy) {
+		case ds_stored:
+			bflush = deflate_stored(state, flush);
+			break;
+		case ds_fast:
+			bflush = deflate_fast(state, flush);
+			break;
+		default:
+			bflush = deflate_lazy(state, flush);
+			break;
+		}
+
+		if (bflush) {
+			deflate_flush_block(state, false);
+			continue;
+		}
+
+		if (flush) {
+			/* All input has been processed */
+			assert(state->lookahead == 0);
+			deflate_flush_block(state, true);
+			state->done = true;
+			continue;
+		}
+
+		if (consumed == srclen) {
+			/* Need more input */
+			rc = EAGAIN;
+			break;
+		}
+	}
+
+	*rconsumed = consumed;
+	*rproduced = produced;
+	return rc;
+}
+
+/** Determine upper bound of compressed data size
+ *
+ * @param srclen Size of uncompressed data (bytes).
+ *
+ * @return Maximum size of compressed data (bytes).
+ *
+ */
+size_t deflate_bound(size_t srclen)
+{
+	/* Blocks hold at least 8 KiB on average, stored blocks grow by 6 */
+	return srclen + 6 * (srclen / 8192 + 2) + 8;
+}
+
+/** Deflate data
+ *
+ * @param src      Source data buffer.
+ * @param srclen   Source buffer size (bytes).
+ * @param dest     Destination data buffer.
+ * @param destlen  Destination buffer size (bytes).
+ * @param rdestlen Place to store size of compressed data (bytes).
+ * @param level    Compression level (DEFLATE_LEVEL_NONE to
+ *                 DEFLATE_LEVEL_BEST).
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM if out of memory or on output buffer overrun.
+ *
+ */
+errno_t deflate(void *src, size_t srclen, void *dest, size_t destlen,
+    size_t *rdestlen, int level)
+{
+	deflate_t *state;
+	size_t consumed;
+	size_t produced;
+	errno_t rc;
+
+	rc = deflate_init(&state, level);
+	if (rc != EOK)
+		return rc;
+
+	rc = deflate_step(state, src, srclen, &consumed, dest, destlen,
+	    &produced, true);
+	if (rc == EAGAIN)
+		rc = ENOMEM;
+
+	deflate_destroy(state);
+
+	if (rc == EOK)
+		*rdestlen = produced;
+	return rc;
+}
@@ -32,6 +32,8 @@
 #include <mem.h>
 #include <byteorder.h>
 #include <stdlib.h>
+#include <adt/checksum.h>
+#include "deflate.h"
 #include "gzip.h"
 #include "inflate.h"
 
@@ -40,6 +42,9 @@
 
 #define GZIP_METHOD_DEFLATE  UINT8_C(0x08)
 
+/** Operating system: unknown */
+#define GZIP_OS_UNKNOWN  UINT8_C(0xff)
+
 #define GZIP_FLAGS_MASK     UINT8_C(0x1f)
 #define GZIP_FLAG_FHCRC     UINT8_C(1 << 1)
 #define GZIP_FLAG_FEXTRA    UINT8_C(1 << 2)
@@ -61,41 +66,52 @@ typedef struct {
 	uint32_t size;
 } __attribute__((packed)) gzip_footer_t;
 
-/** Expand GZIP compressed data
+/** Skip zero-terminated string in GZIP header
  *
- * The routine allocates the output buffer based
- * on the size encoded in the input stream. This
- * effectively limits the size of the uncompressed
- * data to 4 GiB (expanding input streams that actually
- * encode more data will always fail).
+ * @param data   Header data.
+ * @param len    Length of header data (bytes).
+ * @param offset Offset of the string, updated to point after it.
  *
- * So far, no CRC is perfomed.
+ * @return EOK on success, ELIMIT if the string is not complete.
  *
- * @param[in]  src     Source data buffer.
- * @param[in]  srclen  Source buffer size (bytes).
- * @param[out] dest    Destination data buffer.
- * @param[out] destlen Destination buffer size (bytes).
+ */
+static errno_t gzip_skip_string(const uint8_t *data, size_t len,
+    size_t *offset)
+{
+	while (*offset < len) {
+		if (data[(*offset)++] == 0)
+			return EOK;
+	}
+
+	return ELIMIT;
+}
+
+/** Determine size of GZIP header
+ *
+ * This allows decompressing GZIP data in a streaming fashion:
+ * after skipping the header, the deflate stream can be decoded
+ * chunk by chunk using inflate_step().
+ *
+ * @param[in]  src    Source data buffer (start of GZIP stream).
+ * @param[in]  srclen Source buffer size (bytes).
+ * @param[out] rsize  Place to store header size (bytes).
  *
  * @return EOK on success.
- * @return ENOENT on distance too large.
- * @return EINVAL on invalid Huffman code, invalid deflate data,
- *                   invalid compression method or invalid stream.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
+ * @return EINVAL on invalid compression method or invalid header.
+ * @return ELIMIT if the buffer does not contain the complete header.
  *
  */
-errno_t gzip_expand(void *src, size_t srclen, void **dest, size_t *destlen)
+errno_t gzip_header_size(const void *src, size_t srclen, size_t *rsize)
 {
+	const uint8_t *data = (const uint8_t *) src;
 	gzip_header_t header;
-	gzip_footer_t footer;
-
-	if ((srclen < sizeof(header)) || (srclen < sizeof(footer)))
-		return EINVAL;
+	size_t offset;
+	errno_t rc;
 
-	/* Decode header and footer */
+	if (srclen < sizeof(header))
+		return ELIMIT;
 
 	memcpy(&header, src, sizeof(header));
-	memcpy(&footer, src + srclen - sizeof(footer), sizeof(footer));
 
 	if ((header.id1 != GZIP_ID1) ||
 	    (header.id2 != GZIP_ID2) ||
@@ -103,69 +119,92 @@ errno_t gzip_expand(void *src, size_t srclen, void **dest, size_t *destlen)
 	    ((header.flags & (~GZIP_FLAGS_MASK)) != 0))
 		return EINVAL;
 
-	*destlen = uint32_t_le2host(footer.size);
+	offset = sizeof(header);
 
 	/* Ignore extra metadata */
 
-	void *stream = src + sizeof(header);
-	size_t stream_length = srclen - sizeof(header) - sizeof(footer);
-
 	if ((header.flags & GZIP_FLAG_FEXTRA) != 0) {
 		uint16_t extra_length;
 
-		if (stream_length < sizeof(extra_length))
-			return EINVAL;
+		if (srclen - offset < sizeof(extra_length))
+			return ELIMIT;
 
-		memcpy(&extra_length, stream, sizeof(extra_length));
-		stream += sizeof(extra_length);
-		stream_length -= sizeof(extra_length);
+		memcpy(&extra_length, data + offset, sizeof(extra_length));
+		extra_length = uint16_t_le2host(extra_length);
+		offset += sizeof(extra_length);
 
-		if (stream_length < extra_length)
-			return EINVAL;
+		if (srclen - offset < extra_length)
+			return ELIMIT;
 
-		stream += extra_length;
-		stream_length -= extra_length;
+		offset += extra_length;
 	}
 
 	if ((header.flags & GZIP_FLAG_FNAME) != 0) {
-		while (*((uint8_t *) stream) != 0) {
-			if (stream_length == 0)
-				return EINVAL;
+		rc = gzip_skip_string(data, srclen, &offset);
+		if (rc != EOK)
+			return rc;
+	}
 
-			stream++;
-			stream_length--;
-		}
+	if ((header.flags & GZIP_FLAG_FCOMMENT) != 0) {
+		rc = gzip_skip_string(data, srclen, &offset);
+		if (rc != EOK)
+			return rc;
+	}
 
-		if (stream_length == 0)
-			return EINVAL;
+	if ((header.flags & GZIP_FLAG_FHCRC) != 0) {
+		if (srclen - offset < 2)
+			return ELIMIT;
 
-		stream++;
-		stream_length--;
+		offset += 2;
 	}
 
-	if ((header.flags & GZIP_FLAG_FCOMMENT) != 0) {
-		while (*((uint8_t *) stream) != 0) {
-			if (stream_length == 0)
-				return EINVAL;
+	*rsize = offset;
+	return EOK;
+}
+
+/** Expand GZIP compressed data
+ *
+ * The routine allocates the output buffer based
+ * on the size encoded in the input stream. This
+ * effectively limits the size of the uncompressed
+ * data to 4 GiB (expanding input streams that actually
+ * encode more data will always fail).
+ *
+ * So far, no CRC is perfomed.
+ *
+ * @param[in]  src     Source data buffer.
+ * @param[in]  srclen  Source buffer size (bytes).
+ * @param[out] dest    Destination data buffer.
+ * @param[out] destlen Destination buffer size (bytes).
+ *
+ * @return EOK on success.
+ * @return ENOENT on distance too large.
+ * @return EINVAL on invalid Huffman code, invalid deflate data,
+ *                   invalid compression method or invalid stream.
+ * @return ELIMIT on input buffer overrun.
+ * @return ENOMEM on output buffer overrun.
+ *
+ */
+errno_t gzip_expand(void *src, size_t srclen, void **dest, size_t *destlen)
+{
+	gzip_footer_t footer;
+	size_t hdr_size;
+	errno_t rc;
 
-			stream++;
-			stream_length--;
-		}
+	rc = gzip_header_size(src, srclen, &hdr_size);
+	if (rc != EOK)
+		return EINVAL;
 
-		if (stream_length == 0)
-			return EINVAL;
+	if (srclen - hdr_size < sizeof(footer))
+		return EINVAL;
 
-		stream++;
-		stream_length--;
-	}
+	/* Decode footer */
 
-	if ((header.flags & GZIP_FLAG_FHCRC) != 0) {
-		if (stream_length < 2)
-			return EINVAL;
+	memcpy(&footer, src + srclen - sizeof(footer), sizeof(footer));
+	*destlen = uint32_t_le2host(footer.size);
 
-		stream += 2;
-		stream_length -= 2;
-	}
+	void *stream = src + hdr_size;
+	size_t stream_length = srclen - hdr_size - sizeof(footer);
 
 	/* Allocate output buffer and inflate the data */
 
@@ -173,11 +212,99 @@ errno_t gzip_expand(void *src, size_t srclen, void **dest, size_t *destlen)
 	if (*dest == NULL)
 		return ENOMEM;
 
-	errno_t ret = inflate(stream, stream_length, *dest, *destlen);
-	if (ret != EOK) {
-		free(dest);
-		return ret;
+	rc = inflate(stream, stream_length, *dest, *destlen);
+	if (rc != EOK) {
+		free(*dest);
+		return rc;
+	}
+
+	return EOK;
+}
+
+/** Write GZIP header
+ *
+ * Write a minimal header (no file name, no modification time).
+ * The header is followed by the deflate stream (see deflate_step())
+ * and a footer written by gzip_footer_write().
+ *
+ * @param[out] dest Destination buffer (at least GZIP_HEADER_SIZE bytes).
+ *
+ */
+void gzip_header_write(void *dest)
+{
+	gzip_header_t header;
+
+	header.id1 = GZIP_ID1;
+	header.id2 = GZIP_ID2;
+	header.method = GZIP_METHOD_DEFLATE;
+	header.flags = 0;
+	header.mtime = 0;
+	header.extra_flags = 0;
+	header.os = GZIP_OS_UNKNOWN;
+
+	memcpy(dest, &header, sizeof(header));
+}
+
+/** Write GZIP footer
+ *
+ * @param[out] dest  Destination buffer (at least GZIP_FOOTER_SIZE bytes).
+ * @param[in]  crc32 CRC32 of the uncompressed data.
+ * @param[in]  size  Size of the uncompressed data (modulo 2^32).
+ *
+ */
+void gzip_footer_write(void *dest, uint32_t crc32, uint32_t size)
+{
+	gzip_footer_t footer;
+
+	footer.crc32 = host2uint32_t_le(crc32);
+	footer.size = host2uint32_t_le(size);
+
+	memcpy(dest, &footer, sizeof(footer));
+}
+
+/** Compress data in GZIP format
+ *
+ * The routine allocates the output buffer.
+ *
+ * @param[in]  src     Source data buffer.
+ * @param[in]  srclen  Source buffer size (bytes).
+ * @param[in]  level   Compression level (DEFLATE_LEVEL_NONE to
+ *                     DEFLATE_LEVEL_BEST).
+ * @param[out] dest    Destination data buffer.
+ * @param[out] destlen Destination buffer size (bytes).
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM if out of memory.
+ *
+ */
+errno_t gzip_compress(void *src, size_t srclen, int level, void **dest,
+    size_t *destlen)
+{
+	uint8_t *buf;
+	size_t bufsize;
+	size_t stream_length;
+	errno_t rc;
+
+	bufsize = GZIP_HEADER_SIZE + deflate_bound(srclen) + GZIP_FOOTER_SIZE;
+	buf = malloc(bufsize);
+	if (buf == NULL)
+		return ENOMEM;
+
+	gzip_header_write(buf);
+
+	rc = deflate(src, srclen, buf + GZIP_HEADER_SIZE,
+	    bufsize - GZIP_HEADER_SIZE - GZIP_FOOTER_SIZE, &stream_length,
+	    level);
+	if (rc != EOK) {
+		free(buf);
+		return rc;
 	}
 
+	gzip_footer_write(buf + GZIP_HEADER_SIZE + stream_length,
+	    compute_crc32((uint8_t *) src, srclen), (uint32_t) srclen);
+
+	*dest = buf;
+	*destlen = GZIP_HEADER_SIZE + stream_length + GZIP_FOOTER_SIZE;
 	return EOK;
 }
@@ -29,8 +29,19 @@
 #ifndef LIBCOMPRESS_GZIP_H_
 #define LIBCOMPRESS_GZIP_H_
 
+#include <errno.h>
 #include <stddef.h>
+#include <stdint.h>
 
+/** Size of the header written by gzip_header_write() */
+#define GZIP_HEADER_SIZE  10
+/** Size of the GZIP footer */
+#define GZIP_FOOTER_SIZE  8
+
+extern errno_t gzip_header_size(const void *, size_t, size_t *);
 extern errno_t gzip_expand(void *, size_t, void **, size_t *);
+extern void gzip_header_write(void *);
+extern void gzip_footer_write(void *, uint32_t, uint32_t);
+extern errno_t gzip_compress(void *, size_t, int, void **, size_t *);
 
 #endif
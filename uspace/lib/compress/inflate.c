@@ -30,12 +30,26 @@
 /** @file
  * @brief Implementation of inflate decompression
  *
- * A simple inflate implementation (decompression of `deflate' stream as
- * described by RFC 1951) based on puff.c by Mark Adler. This code is
- * currently not optimized for speed but for readability.
+ * An inflate implementation (decompression of `deflate' stream as
+ * described by RFC 1951), originally based on puff.c by Mark Adler.
  *
- * All dynamically allocated memory memory is taken from the stack. The
- * stack usage should be typically bounded by 2 KB.
+ * Huffman codes are decoded using lookup tables indexed by the next
+ * input bits: a root table resolves all codes up to a given length
+ * in one step, longer codes are resolved through a second-level table
+ * linked from the root table entry. Input bits are accumulated in
+ * a 64-bit bit buffer. When there is enough input and room in the output
+ * buffer, a fast loop decodes a whole literal/length and distance
+ * pair after a single refill of the bit buffer.
+ *
+ * The decoder is a state machine which can stop at any point when it
+ * runs out of input or output space and continue with the next call,
+ * so input and output can be processed in chunks of any size. The last
+ * 32 KiB of output are kept in a window for resolving back-references
+ * into data returned by previous calls.
+ *
+ * The boot loader builds this file with BOOT defined. It has neither
+ * a heap nor libc and only uses the one-shot inflate(), which decodes
+ * straight into the output buffer without any window.
  *
  * Original copyright notice:
  *
@@ -67,7 +81,15 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <errno.h>
+#include <macros.h>
+#ifdef BOOT
+#include <memstr.h>
+#define assert(expr)  ((void) 0)
+#else
+#include <assert.h>
+#include <stdlib.h>
 #include <mem.h>
+#endif
 #include "inflate.h"
 
 /** Maximum bits in the Huffman code */
@@ -87,38 +109,147 @@
 /** Number of all codes */
 #define MAX_CODE  (MAX_LITLEN + MAX_DIST)
 
-/** Check for input buffer overrun condition */
-#define CHECK_OVERRUN(state) \
-	do { \
-		if ((state).overrun) \
-			return ELIMIT; \
-	} while (false)
+/** Root table bits for literal/length codes */
+#define LEN_ROOT   9
+/** Root table bits for distance codes */
+#define DIST_ROOT  6
+/** Root table bits for code length codes (they are at most 7 bits long) */
+#define CLEN_ROOT  7
 
-/** Inflate algorithm state
- *
+/*
+ * Maximum table sizes for complete codes with the above root bits
+ * (including second-level tables), as computed by the enough
+ * program from zlib.
  */
-typedef struct {
-	uint8_t *dest;    /**< Output buffer */
-	size_t destlen;   /**< Output buffer size */
-	size_t destcnt;   /**< Position in the output buffer */
+#define LEN_TABLE_SIZE   852
+#define DIST_TABLE_SIZE  592
+
+/** Size of the window for back-references */
+#define WINDOW_SIZE  32768
 
-	uint8_t *src;     /**< Input buffer */
-	size_t srclen;    /**< Input buffer size */
-	size_t srccnt;    /**< Position in the input buffer */
+/** Longest match */
+#define MAX_MATCH  258
 
-	uint16_t bitbuf;  /**< Bit buffer */
-	size_t bitlen;    /**< Number of bits in the bit buffer */
+/** Number of input bytes needed by one iteration of the fast loop */
+#define FAST_IN  8
 
-	bool overrun;     /**< Overrun condition */
-} inflate_state_t;
+/** Huffman table entry type */
+typedef enum {
+	/** Entry decodes a symbol */
+	he_symbol,
+	/** Entry links to a second-level table */
+	he_link,
+	/** Invalid code */
+	he_invalid
+} huffman_entry_type_t;
 
-/** Huffman code description
+/** Huffman table entry
  *
  */
 typedef struct {
-	uint16_t *count;   /**< Array of symbol counts */
-	uint16_t *symbol;  /**< Array of symbols */
-} huffman_t;
+	/** Symbol or offset of the second-level table */
+	uint16_t val;
+	/** Code bits (beyond root bits for second-level entries) or bits
+	 * indexing the second-level table */
+	uint8_t bits;
+	/** Entry type (huffman_entry_type_t) */
+	uint8_t type;
+} huffman_entry_t;
+
+/** Decoder mode */
+typedef enum {
+	/** Block header */
+	im_header,
+	/** Stored block length */
+	im_stored,
+	/** Stored block data */
+	im_copy,
+	/** Dynamic block table sizes */
+	im_table,
+	/** Code length code lengths */
+	im_lenlens,
+	/** Literal/length and distance code lengths */
+	im_codelens,
+	/** Literal/length code */
+	im_len,
+	/** Literal waiting for output space */
+	im_lit,
+	/** Length extra bits */
+	im_lenext,
+	/** Distance code */
+	im_dist,
+	/** Distance extra bits */
+	im_distext,
+	/** Copying match */
+	im_match,
+	/** Done with the last block */
+	im_done,
+	/** Error detected */
+	im_bad
+} inflate_mode_t;
+
+/** Inflate algorithm state
+ *
+ */
+struct inflate {
+	/** Decoder mode */
+	inflate_mode_t mode;
+	/** Current block is the last one */
+	bool last;
+	/** Error code in im_bad mode */
+	errno_t error;
+
+	/** Bit buffer */
+	uint64_t bitbuf;
+	/** Number of bits in the bit buffer */
+	unsigned bitlen;
+
+	/** Remaining length of stored block or match, or literal */
+	size_t length;
+	/** Match distance */
+	size_t dist;
+	/** Number of extra bits to get */
+	unsigned extra;
+
+	/** Number of literal/length codes of dynamic block */
+	unsigned nlen;
+	/** Number of distance codes of dynamic block */
+	unsigned ndist;
+	/** Number of code length codes of dynamic block */
+	unsigned ncode;
+	/** Number of code lengths read */
+	unsigned have;
+	/** Code lengths of dynamic block */
+	uint16_t lengths[MAX_CODE];
+
+	/** Literal/length table */
+	huffman_entry_t len_table[LEN_TABLE_SIZE];
+	/** Distance table */
+	huffman_entry_t dist_table[DIST_TABLE_SIZE];
+	/** Code length table */
+	huffman_entry_t clen_table[1 << CLEN_ROOT];
+
+	/** Window (circular buffer with the last output bytes) */
+	uint8_t *window;
+	/** Number of valid bytes in the window */
+	size_t whave;
+	/** Next write position in the window */
+	size_t wnext;
+
+	/** Input buffer of the current step */
+	const uint8_t *src;
+	/** Input buffer size */
+	size_t srclen;
+	/** Position in the input buffer */
+	size_t srccnt;
+
+	/** Output buffer of the current step */
+	uint8_t *dest;
+	/** Output buffer size */
+	size_t destlen;
+	/** Position in the output buffer */
+	size_t destcnt;
+};
 
 /** Length codes
  *
@@ -161,457 +292,977 @@ static const short order[MAX_ORDER] = {
 	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
 };
 
-/** Static length symbol counts
+/** Get bits from the bit buffer without removing them
  *
- */
-static uint16_t len_count[MAX_HUFFMAN_BIT + 1] = {
-	0, 0, 0, 0, 0, 0, 0, 24, 152, 112, 0, 0, 0, 0, 0, 0
-};
-
-/** Static length symbols
+ * @param state Inflate state.
+ * @param cnt   Number of bits (less than 64).
  *
- */
-static uint16_t len_symbol[MAX_FIXED_LITLEN] = {
-	256, 257, 258, 259, 260, 261, 262, 263, 264, 265, 266, 267, 268,
-	269, 270, 271, 272, 273, 274, 275, 276, 277, 278, 279, 0, 1, 2,
-	3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
-	21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36,
-	37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52,
-	53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67, 68,
-	69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79, 80, 81, 82, 83, 84,
-	85, 86, 87, 88, 89, 90, 91, 92, 93, 94, 95, 96, 97, 98, 99, 100,
-	101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111, 112, 113,
-	114, 115, 116, 117, 118, 119, 120, 121, 122, 123, 124, 125, 126,
-	127, 128, 129, 130, 131, 132, 133, 134, 135, 136, 137, 138, 139,
-	140, 141, 142, 143, 280, 281, 282, 283, 284, 285, 286, 287, 144,
-	145, 146, 147, 148, 149, 150, 151, 152, 153, 154, 155, 156, 157,
-	158, 159, 160, 161, 162, 163, 164, 165, 166, 167, 168, 169, 170,
-	171, 172, 173, 174, 175, 176, 177, 178, 179, 180, 181, 182, 183,
-	184, 185, 186, 187, 188, 189, 190, 191, 192, 193, 194, 195, 196,
-	197, 198, 199, 200, 201, 202, 203, 204, 205, 206, 207, 208, 209,
-	210, 211, 212, 213, 214, 215, 216, 217, 218, 219, 220, 221, 222,
-	223, 224, 225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235,
-	236, 237, 238, 239, 240, 241, 242, 243, 244, 245, 246, 247, 248,
-	249, 250, 251, 252, 253, 254, 255
-};
-
-/** Static distance symbol counts
+ * @return Bits.
  *
  */
-static uint16_t dist_count[MAX_HUFFMAN_BIT + 1] = {
-	0, 0, 0, 0, 0, 30, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-};
+static inline unsigned peek_bits(inflate_t *state, unsigned cnt)
+{
+	return (unsigned) (state->bitbuf & ((UINT64_C(1) << cnt) - 1));
+}
 
-/** Static distance symbols
+/** Remove bits from the bit buffer
  *
- */
-static uint16_t dist_symbol[MAX_DIST] = {
-	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
-	16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29
-};
-
-/** Huffman code for lengths
+ * @param state Inflate state.
+ * @param cnt   Number of bits.
  *
  */
-static huffman_t len_code = {
-	.count = len_count,
-	.symbol = len_symbol
-};
+static inline void drop_bits(inflate_t *state, unsigned cnt)
+{
+	state->bitbuf >>= cnt;
+	state->bitlen -= cnt;
+}
 
-/** Huffman code for distances
+/** Load one more byte into the bit buffer
+ *
+ * @param state Inflate state.
+ *
+ * @return True on success, false if there is no more input.
  *
  */
-static huffman_t dist_code = {
-	.count = dist_count,
-	.symbol = dist_symbol
-};
+static inline bool pull_byte(inflate_t *state)
+{
+	if (state->srccnt == state->srclen)
+		return false;
+
+	state->bitbuf |= ((uint64_t) state->src[state->srccnt]) <<
+	    state->bitlen;
+	state->srccnt++;
+	state->bitlen += 8;
+	return true;
+}
 
-/** Get bits from the bit buffer
+/** Make sure there are enough bits in the bit buffer
  *
  * @param state Inflate state.
- * @param cnt   Number of bits to return (at most 16).
+ * @param cnt   Number of bits needed (at most 57).
  *
- * @return Returned bits.
+ * @return True on success, false if there is not enough input.
  *
  */
-static inline uint16_t get_bits(inflate_state_t *state, size_t cnt)
+static inline bool need_bits(inflate_t *state, unsigned cnt)
 {
-	/* Bit accumulator for at least 20 bits */
-	uint32_t val = state->bitbuf;
-
 	while (state->bitlen < cnt) {
-		if (state->srccnt == state->srclen) {
-			state->overrun = true;
-			return 0;
-		}
-
-		/* Load 8 more bits */
-		val |= ((uint32_t) state->src[state->srccnt]) << state->bitlen;
-		state->srccnt++;
-		state->bitlen += 8;
+		if (!pull_byte(state))
+			return false;
 	}
 
-	/* Update bits in the buffer */
-	state->bitbuf = (uint16_t) (val >> cnt);
-	state->bitlen -= cnt;
-
-	return ((uint16_t) (val & ((1 << cnt) - 1)));
+	return true;
 }
 
-/** Decode `stored' block
+/** Look up Huffman code in a table
  *
  * @param state Inflate state.
+ * @param table Huffman table.
+ * @param root  Root table bits.
+ * @param entry Place to store the entry.
+ * @param used  Place to store the number of code bits.
  *
- * @return EOK on success.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
- * @return EINVAL on invalid data.
+ * @return True if the entry was found, false if more bits are needed.
  *
  */
-static errno_t inflate_stored(inflate_state_t *state)
+static inline bool huffman_lookup(inflate_t *state, huffman_entry_t *table,
+    unsigned root, huffman_entry_t *entry, unsigned *used)
 {
-	/* Discard bits in the bit buffer */
-	state->bitbuf = 0;
-	state->bitlen = 0;
+	huffman_entry_t e = table[peek_bits(state, root)];
 
-	if (state->srccnt + 4 > state->srclen)
-		return ELIMIT;
+	if (e.type == he_link) {
+		if (state->bitlen < root)
+			return false;
 
-	uint16_t len =
-	    state->src[state->srccnt] | (state->src[state->srccnt + 1] << 8);
-	uint16_t len_compl =
-	    state->src[state->srccnt + 2] | (state->src[state->srccnt + 3] << 8);
+		e = table[e.val + ((state->bitbuf >> root) &
+		    ((UINT64_C(1) << e.bits) - 1))];
+		if (root + e.bits > state->bitlen)
+			return false;
 
-	/* Check block length and its complement */
-	if (((int16_t) len) != ~((int16_t) len_compl))
-		return EINVAL;
+		*entry = e;
+		*used = root + e.bits;
+		return true;
+	}
 
-	state->srccnt += 4;
+	if (e.bits > state->bitlen)
+		return false;
 
-	/* Check input buffer size */
-	if (state->srccnt + len > state->srclen)
-		return ELIMIT;
+	*entry = e;
+	*used = e.bits;
+	return true;
+}
 
-	/* Check output buffer size */
-	if (state->destcnt + len > state->destlen)
-		return ENOMEM;
+/** Fetch Huffman table entry without checking the number of bits
+ *
+ * Only used when the bit buffer is known to contain the longest code.
+ *
+ * @param state Inflate state.
+ * @param table Huffman table.
+ * @param root  Root table bits.
+ * @param used  Place to store the number of code bits.
+ *
+ * @return Table entry.
+ *
+ */
+static inline huffman_entry_t huffman_fetch(inflate_t *state,
+    huffman_entry_t *table, unsigned root, unsigned *used)
+{
+	huffman_entry_t e = table[peek_bits(state, root)];
 
-	/* Copy data */
-	memcpy(state->dest + state->destcnt, state->src + state->srccnt, len);
-	state->srccnt += len;
-	state->destcnt += len;
+	if (e.type == he_link) {
+		e = table[e.val + ((state->bitbuf >> root) &
+		    ((UINT64_C(1) << e.bits) - 1))];
+		*used = root + e.bits;
+		return e;
+	}
 
-	return EOK;
+	*used = e.bits;
+	return e;
 }
 
-/** Decode a symbol using the Huffman code
+/** Decode a symbol using a Huffman table
  *
- * @param state   Inflate state.
- * @param huffman Huffman code.
- * @param symbol  Decoded symbol.
+ * @param state  Inflate state.
+ * @param table  Huffman table.
+ * @param root   Root table bits.
+ * @param symbol Place to store the decoded symbol.
  *
- * @param EOK on success.
- * @param EINVAL on invalid Huffman code.
+ * @return EOK on success.
+ * @return ELIMIT if more input is needed.
+ * @return EINVAL on invalid Huffman code.
  *
  */
-static errno_t huffman_decode(inflate_state_t *state, huffman_t *huffman,
-    uint16_t *symbol)
+static errno_t huffman_decode(inflate_t *state, huffman_entry_t *table,
+    unsigned root, uint16_t *symbol)
 {
-	/* Decode bits */
-	uint16_t code = 0;
+	huffman_entry_t e;
+	unsigned used;
 
-	/* First code of the given length */
-	size_t first = 0;
+	while (!huffman_lookup(state, table, root, &e, &used)) {
+		if (!pull_byte(state))
+			return ELIMIT;
+	}
 
-	/*
-	 * Index of the first code of the given length
-	 * in the symbol table
-	 */
-	size_t index = 0;
+	if (e.type != he_symbol)
+		return EINVAL;
 
-	/* Current number of bits in the code */
-	size_t len;
+	drop_bits(state, used);
+	*symbol = e.val;
+	return EOK;
+}
 
-	for (len = 1; len <= MAX_HUFFMAN_BIT; len++) {
-		/* Get next bit */
-		code |= get_bits(state, 1);
-		CHECK_OVERRUN(*state);
-
-		uint16_t count = huffman->count[len];
-		if (code < first + count) {
-			/* Return decoded symbol */
-			*symbol = huffman->symbol[index + code - first];
-			return EOK;
-		}
+/** Reverse bits of a code
+ *
+ * Huffman codes are packed starting with the most significant bit, but
+ * the table is indexed with the first bit as the least significant one.
+ *
+ * @param code Code.
+ * @param len  Code length.
+ *
+ * @return Reversed code.
+ *
+ */
+static unsigned reverse_bits(unsigned code, unsigned len)
+{
+	unsigned rev = 0;
 
-		/* Update for next length */
-		index += count;
-		first += count;
-		first <<= 1;
-		code <<= 1;
+	while (len > 0) {
+		rev = (rev << 1) | (code & 1);
+		code >>= 1;
+		len--;
 	}
 
-	return EINVAL;
+	return rev;
 }
 
-/** Construct Huffman tables from canonical Huffman code
+/** Construct Huffman table from canonical Huffman code
  *
- * @param huffman Constructed Huffman tables.
- * @param length  Lengths of the canonical Huffman code.
- * @param n       Number of lengths.
+ * @param table  Huffman table.
+ * @param size   Number of entries in the table.
+ * @param root   Root table bits.
+ * @param length Lengths of the canonical Huffman code.
+ * @param n      Number of lengths.
+ * @param rleft  Place to store 0 if the code set is complete, a negative
+ *               value for an over-subscribed code set or a positive
+ *               value for an incomplete one.
+ * @param rcount Place to store the number of unused symbols or @c NULL.
  *
- * @return 0 if the Huffman code set is complete.
- * @return Negative value for an over-subscribed code set.
- * @return Positive value for an incomplete code set.
+ * @return EOK on success.
+ * @return EINVAL if the table would not fit.
  *
  */
-static int16_t huffman_construct(huffman_t *huffman, uint16_t *length, size_t n)
+static errno_t huffman_construct(huffman_entry_t *table, size_t size,
+    unsigned root, uint16_t *length, size_t n, int *rleft, size_t *rcount)
 {
+	uint16_t count[MAX_HUFFMAN_BIT + 1];
+	uint16_t next_code[MAX_HUFFMAN_BIT + 1];
+	uint8_t sub_len[1 << LEN_ROOT];
+	size_t root_size = (size_t) 1 << root;
+	size_t next_sub;
+	size_t symbol;
+	size_t i;
+	unsigned len;
+	unsigned code;
+	unsigned rev;
+	unsigned prefix;
+
+	assert(root <= LEN_ROOT);
+
 	/* Count number of codes for each length */
-	size_t len;
 	for (len = 0; len <= MAX_HUFFMAN_BIT; len++)
-		huffman->count[len] = 0;
+		count[len] = 0;
 
 	/* We assume that the lengths are within bounds */
-	size_t symbol;
 	for (symbol = 0; symbol < n; symbol++)
-		huffman->count[length[symbol]]++;
+		count[length[symbol]]++;
+
+	if (rcount != NULL)
+		*rcount = count[0];
+
+	/* Start with all entries invalid */
+	for (i = 0; i < root_size; i++) {
+		table[i].type = he_invalid;
+		table[i].bits = root;
+		table[i].val = 0;
+	}
 
-	if (huffman->count[0] == n) {
+	if (count[0] == n) {
 		/* The code is complete, but decoding will fail */
-		return 0;
+		*rleft = 0;
+		return EOK;
 	}
 
 	/* Check for an over-subscribed or incomplete set of lengths */
-	int16_t left = 1;
+	int left = 1;
 	for (len = 1; len <= MAX_HUFFMAN_BIT; len++) {
 		left <<= 1;
-		left -= huffman->count[len];
+		left -= count[len];
 		if (left < 0) {
 			/* Over-subscribed */
-			return left;
+			*rleft = left;
+			return EOK;
 		}
 	}
 
-	/* Generate offsets into symbol table */
-	uint16_t offs[MAX_HUFFMAN_BIT + 1];
+	/* First canonical code of each length */
+	code = 0;
+	count[0] = 0;
+	for (len = 1; len <= MAX_HUFFMAN_BIT; len++) {
+		code = (code + count[len - 1]) << 1;
+		next_code[len] = code;
+	}
+
+	/* Determine the size of second-level tables */
+	for (i = 0; i < root_size; i++)
+		sub_len[i] = 0;
 
-	offs[1] = 0;
-	for (len = 1; len < MAX_HUFFMAN_BIT; len++)
-		offs[len + 1] = offs[len] + huffman->count[len];
+	/*
+	 * Assign codes in canonical order. The codes of the same length
+	 * are consecutive, so we walk the symbols twice: first to size
+	 * the second-level tables, then to fill in the entries.
+	 */
+	uint16_t next[MAX_HUFFMAN_BIT + 1];
 
+	memcpy(next, next_code, sizeof(next));
 	for (symbol = 0; symbol < n; symbol++) {
-		if (length[symbol] != 0) {
-			huffman->symbol[offs[length[symbol]]] = symbol;
-			offs[length[symbol]]++;
+		len = length[symbol];
+		if (len <= root)
+			continue;
+
+		rev = reverse_bits(next[len]++, len);
+		prefix = rev & (root_size - 1);
+		if (sub_len[prefix] < len)
+			sub_len[prefix] = len;
+	}
+
+	/* Allocate second-level tables */
+	next_sub = root_size;
+	for (i = 0; i < root_size; i++) {
+		if (sub_len[i] == 0)
+			continue;
+
+		unsigned sbits = sub_len[i] - root;
+		size_t ssize = (size_t) 1 << sbits;
+
+		if (next_sub + ssize > size)
+			return EINVAL;
+
+		table[i].type = he_link;
+		table[i].bits = sbits;
+		table[i].val = next_sub;
+
+		for (size_t j = 0; j < ssize; j++) {
+			table[next_sub + j].type = he_invalid;
+			table[next_sub + j].bits = sbits;
+			table[next_sub + j].val = 0;
 		}
+
+		next_sub += ssize;
 	}
 
-	return left;
+	/* Fill in the entries */
+	memcpy(next, next_code, sizeof(next));
+	for (symbol = 0; symbol < n; symbol++) {
+		len = length[symbol];
+		if (len == 0)
+			continue;
+
+		rev = reverse_bits(next[len]++, len);
+
+		if (len <= root) {
+			for (i = rev; i < root_size; i += (size_t) 1 << len) {
+				table[i].type = he_symbol;
+				table[i].bits = len;
+				table[i].val = symbol;
+			}
+		} else {
+			huffman_entry_t *link = &table[rev & (root_size - 1)];
+			size_t ssize = (size_t) 1 << link->bits;
+			unsigned clen = len - root;
+
+			for (i = rev >> root; i < ssize;
+			    i += (size_t) 1 << clen) {
+				table[link->val + i].type = he_symbol;
+				table[link->val + i].bits = clen;
+				table[link->val + i].val = symbol;
+			}
+		}
+	}
+
+	*rleft = left;
+	return EOK;
 }
 
-/** Decode literal/length and distance codes
+/** Construct Huffman tables for a `fixed codes' block
  *
- * Decode until end-of-block code.
+ * @param state Inflate state.
  *
- * @param state     Inflate state.
- * @param len_code  Huffman code for literal/length.
- * @param dist_code Huffman code for distance.
+ */
+static void inflate_fixed_tables(inflate_t *state)
+{
+	uint16_t *length = state->lengths;
+	size_t symbol;
+	int left;
+
+	for (symbol = 0; symbol < 144; symbol++)
+		length[symbol] = 8;
+	for (; symbol < 256; symbol++)
+		length[symbol] = 9;
+	for (; symbol < 280; symbol++)
+		length[symbol] = 7;
+	for (; symbol < MAX_FIXED_LITLEN; symbol++)
+		length[symbol] = 8;
+
+	(void) huffman_construct(state->len_table, LEN_TABLE_SIZE, LEN_ROOT,
+	    length, MAX_FIXED_LITLEN, &left, NULL);
+
+	for (symbol = 0; symbol < MAX_DIST; symbol++)
+		length[symbol] = 5;
+
+	(void) huffman_construct(state->dist_table, DIST_TABLE_SIZE, DIST_ROOT,
+	    length, MAX_DIST, &left, NULL);
+}
+
+#ifndef BOOT
+
+/** Update window with the output of the current step
  *
- * @return EOK on success.
- * @return ENOENT on distance too large.
- * @return EINVAL on invalid Huffman code.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
+ * @param state Inflate state.
  *
  */
-static errno_t inflate_codes(inflate_state_t *state, huffman_t *len_code,
-    huffman_t *dist_code)
+static void inflate_update_window(inflate_t *state)
 {
-	uint16_t symbol;
+	const uint8_t *data = state->dest;
+	size_t len = state->destcnt;
+	size_t n;
+
+	if (len >= WINDOW_SIZE) {
+		memcpy(state->window, data + len - WINDOW_SIZE, WINDOW_SIZE);
+		state->wnext = 0;
+		state->whave = WINDOW_SIZE;
+		return;
+	}
 
-	do {
-		errno_t err = huffman_decode(state, len_code, &symbol);
-		if (err != EOK) {
-			/* Error decoding */
-			return err;
-		}
+	n = min(len, WINDOW_SIZE - state->wnext);
+	memcpy(state->window + state->wnext, data, n);
+	memcpy(state->window, data + n, len - n);
 
-		if (symbol < 256) {
-			/* Write out literal */
-			if (state->destcnt == state->destlen)
-				return ENOMEM;
+	state->wnext = (state->wnext + len) % WINDOW_SIZE;
+	state->whave = min(state->whave + len, (size_t) WINDOW_SIZE);
+}
 
-			state->dest[state->destcnt] = (uint8_t) symbol;
-			state->destcnt++;
-		} else if (symbol > 256) {
-			/* Compute length */
-			symbol -= 257;
-			if (symbol >= 29)
-				return EINVAL;
+#endif
 
-			size_t len = lens[symbol] + get_bits(state, lens_ext[symbol]);
-			CHECK_OVERRUN(*state);
+/** Copy part of a match to the output buffer
+ *
+ * The source may lie in the output buffer of the current step and/or
+ * in the window.
+ *
+ * @param state Inflate state.
+ * @param len   Number of bytes to copy (must fit in the output buffer).
+ *
+ */
+static void inflate_copy_match(inflate_t *state, size_t len)
+{
+	uint8_t *put = state->dest + state->destcnt;
+	size_t dist = state->dist;
 
-			/* Get distance */
-			err = huffman_decode(state, dist_code, &symbol);
-			if (err != EOK)
-				return err;
+	assert(state->destcnt + len <= state->destlen);
+	state->destcnt += len;
 
-			size_t dist = dists[symbol] + get_bits(state, dists_ext[symbol]);
-			if (dist > state->destcnt)
-				return ENOENT;
+	if (dist > (size_t) (put - state->dest)) {
+		/* Start in the window */
+		size_t back = dist - (put - state->dest);
+		size_t from = (state->wnext + WINDOW_SIZE - back) % WINDOW_SIZE;
+		size_t n = min(len, back);
 
-			if (state->destcnt + len > state->destlen)
-				return ENOMEM;
+		len -= n;
+		while (n > 0) {
+			size_t chunk = min(n, WINDOW_SIZE - from);
 
-			while (len > 0) {
-				/* Copy len bytes from distance bytes back */
-				state->dest[state->destcnt] =
-				    state->dest[state->destcnt - dist];
-				state->destcnt++;
-				len--;
-			}
+			memcpy(put, state->window + from, chunk);
+			put += chunk;
+			from = (from + chunk) % WINDOW_SIZE;
+			n -= chunk;
 		}
-	} while (symbol != 256);
 
-	return EOK;
+		if (len == 0)
+			return;
+	}
+
+	/* Copy from the output buffer */
+	const uint8_t *from = put - dist;
+
+	if (dist >= len) {
+		memcpy(put, from, len);
+		return;
+	}
+
+	/* Overlapping copy repeats the pattern */
+	while (len > 0) {
+		*put++ = *from++;
+		len--;
+	}
 }
 
-/** Decode `fixed codes' block
+/** Check match distance
  *
- * @param state     Inflate state.
- * @param len_code  Huffman code for literal/length.
- * @param dist_code Huffman code for distance.
+ * @param state Inflate state.
  *
- * @return EOK on success.
- * @return ENOENT on distance too large.
- * @return EINVAL on invalid Huffman code.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
+ * @return True if the distance is within the produced output.
  *
  */
-static errno_t inflate_fixed(inflate_state_t *state, huffman_t *len_code,
-    huffman_t *dist_code)
+static inline bool inflate_dist_valid(inflate_t *state)
 {
-	return inflate_codes(state, len_code, dist_code);
+	return state->dist <= state->whave + state->destcnt;
 }
 
-/** Decode `dynamic codes' block
+/** Fast decoding loop
  *
- * @param state     Inflate state.
+ * Decode literal/length and distance codes as long as there is enough
+ * input for one iteration and room for the longest match. Each iteration
+ * refills the bit buffer once, making room for the longest code sequence
+ * (48 bits). At the end, whole bytes read ahead in this loop are returned
+ * to the input.
  *
- * @return EOK on success.
- * @return ENOENT on distance too large.
- * @return EINVAL on invalid Huffman code.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
+ * @param state Inflate state (in im_len mode).
  *
  */
-static errno_t inflate_dynamic(inflate_state_t *state)
+static void inflate_fast(inflate_t *state)
 {
-	uint16_t length[MAX_CODE];
-	uint16_t dyn_len_count[MAX_HUFFMAN_BIT + 1];
-	uint16_t dyn_len_symbol[MAX_LITLEN];
-	uint16_t dyn_dist_count[MAX_HUFFMAN_BIT + 1];
-	uint16_t dyn_dist_symbol[MAX_DIST];
-	huffman_t dyn_len_code;
-	huffman_t dyn_dist_code;
+	size_t start = state->srccnt;
+	huffman_entry_t e;
+	unsigned used;
+	unsigned sym;
+
+	while (state->srclen - state->srccnt >= FAST_IN &&
+	    state->destlen - state->destcnt >= MAX_MATCH) {
+		/* Refill bit buffer */
+		while (state->bitlen <= 56) {
+			state->bitbuf |= ((uint64_t)
+			    state->src[state->srccnt]) << state->bitlen;
+			state->srccnt++;
+			state->bitlen += 8;
+		}
 
-	dyn_len_code.count = dyn_len_count;
-	dyn_len_code.symbol = dyn_len_symbol;
+		/* Literal/length code */
+		e = huffman_fetch(state, state->len_table, LEN_ROOT, &used);
+		if (e.type != he_symbol) {
+			state->error = EINVAL;
+			state->mode = im_bad;
+			break;
+		}
 
-	dyn_dist_code.count = dyn_dist_count;
-	dyn_dist_code.symbol = dyn_dist_symbol;
+		drop_bits(state, used);
+		sym = e.val;
 
-	/* Get number of bits in each table */
-	uint16_t nlen = get_bits(state, 5) + 257;
-	CHECK_OVERRUN(*state);
+		if (sym < 256) {
+			/* Write out literal */
+			state->dest[state->destcnt++] = (uint8_t) sym;
+			continue;
+		}
 
-	uint16_t ndist = get_bits(state, 5) + 1;
-	CHECK_OVERRUN(*state);
+		if (sym == 256) {
+			/* End of block */
+			state->mode = state->last ? im_done : im_header;
+			break;
+		}
 
-	uint16_t ncode = get_bits(state, 4) + 4;
-	CHECK_OVERRUN(*state);
+		sym -= 257;
+		if (sym >= MAX_LEN) {
+			state->error = EINVAL;
+			state->mode = im_bad;
+			break;
+		}
 
-	if ((nlen > MAX_LITLEN) || (ndist > MAX_DIST) ||
-	    (ncode > MAX_ORDER))
-		return EINVAL;
+		state->length = lens[sym] + peek_bits(state, lens_ext[sym]);
+		drop_bits(state, lens_ext[sym]);
+
+		/* Distance code */
+		e = huffman_fetch(state, state->dist_table, DIST_ROOT, &used);
+		if (e.type != he_symbol || e.val >= MAX_DIST) {
+			state->error = EINVAL;
+			state->mode = im_bad;
+			break;
+		}
+
+		drop_bits(state, used);
+		sym = e.val;
 
-	/* Read code length code lengths */
-	uint16_t index;
-	for (index = 0; index < ncode; index++) {
-		length[order[index]] = get_bits(state, 3);
-		CHECK_OVERRUN(*state);
+		state->dist = dists[sym] + peek_bits(state, dists_ext[sym]);
+		drop_bits(state, dists_ext[sym]);
+
+		if (!inflate_dist_valid(state)) {
+			state->error = ENOENT;
+			state->mode = im_bad;
+			break;
+		}
+
+		inflate_copy_match(state, state->length);
 	}
 
-	/* Set missing lengths to zero */
-	for (index = ncode; index < MAX_ORDER; index++)
-		length[order[index]] = 0;
+	/* Return unused bytes read ahead */
+	size_t n = min(state->bitlen >> 3, state->srccnt - start);
 
-	/* Build Huffman code */
-	int16_t rc = huffman_construct(&dyn_len_code, length, MAX_ORDER);
-	if (rc != 0)
-		return EINVAL;
+	state->srccnt -= n;
+	state->bitlen -= n << 3;
+	if (state->bitlen < 64)
+		state->bitbuf &= (UINT64_C(1) << state->bitlen) - 1;
+}
 
-	/* Read length/literal and distance code length tables */
-	index = 0;
-	while (index < nlen + ndist) {
-		uint16_t symbol;
-		errno_t err = huffman_decode(state, &dyn_len_code, &symbol);
-		if (err != EOK)
-			return EOK;
+/** Decode next part of the stream
+ *
+ * @param state Inflate state.
+ *
+ * @return EOK when the last block is finished.
+ * @return ELIMIT if more input is needed.
+ * @return ENOMEM if more output space is needed.
+ * @return Other error code on invalid data.
+ *
+ */
+static errno_t inflate_run(inflate_t *state)
+{
+	uint16_t symbol;
+	unsigned type;
+	size_t n;
+	int left;
+	size_t unused;
+	errno_t rc;
+
+	while (true) {
+		switch (state->mode) {
+		case im_header:
+			if (!need_bits(state, 3))
+				return ELIMIT;
+
+			/* Last block is indicated by a non-zero bit */
+			state->last = peek_bits(state, 1) != 0;
+			type = (state->bitbuf >> 1) & 0x3;
+			drop_bits(state, 3);
+
+			switch (type) {
+			case 0:
+				state->mode = im_stored;
+				break;
+			case 1:
+				inflate_fixed_tables(state);
+				state->mode = im_len;
+				break;
+			case 2:
+				state->mode = im_table;
+				break;
+			default:
+				return EINVAL;
+			}
+			break;
+		case im_stored:
+			/* Discard bits up to byte boundary */
+			drop_bits(state, state->bitlen & 7);
+			if (!need_bits(state, 32))
+				return ELIMIT;
+
+			/* Check block length and its complement */
+			if ((state->bitbuf & 0xffff) !=
+			    (~(state->bitbuf >> 16) & 0xffff))
+				return EINVAL;
 
-		if (symbol < 16) {
-			length[index] = symbol;
-			index++;
-		} else {
-			uint16_t len = 0;
+			state->length = state->bitbuf & 0xffff;
+			drop_bits(state, 32);
+			state->mode = im_copy;
+			break;
+		case im_copy:
+			/* Bytes still in the bit buffer come first */
+			while (state->length > 0 && state->bitlen >= 8) {
+				if (state->destcnt == state->destlen)
+					return ENOMEM;
+
+				state->dest[state->destcnt++] =
+				    (uint8_t) state->bitbuf;
+				drop_bits(state, 8);
+				state->length--;
+			}
+
+			n = min(state->length, state->srclen - state->srccnt);
+			n = min(n, state->destlen - state->destcnt);
+			memcpy(state->dest + state->destcnt,
+			    state->src + state->srccnt, n);
+			state->srccnt += n;
+			state->destcnt += n;
+			state->length -= n;
+
+			if (state->length > 0) {
+				if (state->destcnt == state->destlen)
+					return ENOMEM;
+				return ELIMIT;
+			}
+
+			state->mode = state->last ? im_done : im_header;
+			break;
+		case im_table:
+			if (!need_bits(state, 14))
+				return ELIMIT;
+
+			/* Get number of bits in each table */
+			state->nlen = peek_bits(state, 5) + 257;
+			drop_bits(state, 5);
+			state->ndist = peek_bits(state, 5) + 1;
+			drop_bits(state, 5);
+			state->ncode = peek_bits(state, 4) + 4;
+			drop_bits(state, 4);
+
+			if ((state->nlen > MAX_LITLEN) ||
+			    (state->ndist > MAX_DIST))
+				return EINVAL;
+
+			state->have = 0;
+			state->mode = im_lenlens;
+			break;
+		case im_lenlens:
+			/* Read code length code lengths */
+			while (state->have < state->ncode) {
+				if (!need_bits(state, 3))
+					return ELIMIT;
+
+				state->lengths[order[state->have]] =
+				    peek_bits(state, 3);
+				drop_bits(state, 3);
+				state->have++;
+			}
+
+			/* Set missing lengths to zero */
+			for (n = state->ncode; n < MAX_ORDER; n++)
+				state->lengths[order[n]] = 0;
+
+			/* Build Huffman code */
+			rc = huffman_construct(state->clen_table,
+			    1 << CLEN_ROOT, CLEN_ROOT, state->lengths,
+			    MAX_ORDER, &left, NULL);
+			if (rc != EOK || left != 0)
+				return EINVAL;
+
+			state->have = 0;
+			state->mode = im_codelens;
+			break;
+		case im_codelens:
+			/* Read literal/length and distance code lengths */
+			n = state->nlen + state->ndist;
+			while (state->have < n) {
+				huffman_entry_t e;
+				unsigned used;
+				unsigned rep;
+				uint16_t len;
+
+				while (!huffman_lookup(state, state->clen_table,
+				    CLEN_ROOT, &e, &used)) {
+					if (!pull_byte(state))
+						return ELIMIT;
+				}
+
+				if (e.type != he_symbol)
+					return EINVAL;
+
+				if (e.val < 16) {
+					drop_bits(state, used);
+					state->lengths[state->have++] = e.val;
+					continue;
+				}
+
+				/* Get the code and its extra bits at once */
+				type = e.val == 16 ? 2 : (e.val == 17 ? 3 : 7);
+				if (!need_bits(state, used + type))
+					return ELIMIT;
+
+				drop_bits(state, used);
 
-			if (symbol == 16) {
-				if (index == 0)
+				len = 0;
+				if (e.val == 16) {
+					if (state->have == 0)
+						return EINVAL;
+
+					len = state->lengths[state->have - 1];
+					rep = peek_bits(state, 2) + 3;
+				} else if (e.val == 17) {
+					rep = peek_bits(state, 3) + 3;
+				} else {
+					rep = peek_bits(state, 7) + 11;
+				}
+
+				drop_bits(state, type);
+
+				if (state->have + rep > n)
 					return EINVAL;
 
-				len = length[index - 1];
-				symbol = get_bits(state, 2) + 3;
-				CHECK_OVERRUN(*state);
-			} else if (symbol == 17) {
-				symbol = get_bits(state, 3) + 3;
-				CHECK_OVERRUN(*state);
-			} else {
-				symbol = get_bits(state, 7) + 11;
-				CHECK_OVERRUN(*state);
+				while (rep > 0) {
+					state->lengths[state->have++] = len;
+					rep--;
+				}
 			}
 
-			if (index + symbol > nlen + ndist)
+			/* Check for end-of-block code */
+			if (state->lengths[256] == 0)
+				return EINVAL;
+
+			/* Build Huffman tables for literal/length codes */
+			rc = huffman_construct(state->len_table, LEN_TABLE_SIZE,
+			    LEN_ROOT, state->lengths, state->nlen, &left,
+			    &unused);
+			if ((rc != EOK) || (left < 0) ||
+			    ((left > 0) && (unused + 1 != state->nlen)))
 				return EINVAL;
 
-			while (symbol > 0) {
-				length[index] = len;
-				index++;
-				symbol--;
+			/* Build Huffman tables for distance codes */
+			rc = huffman_construct(state->dist_table,
+			    DIST_TABLE_SIZE, DIST_ROOT,
+			    state->lengths + state->nlen, state->ndist, &left,
+			    &unused);
+			if ((rc != EOK) || (left < 0) ||
+			    ((left > 0) && (unused + 1 != state->ndist)))
+				return EINVAL;
+
+			state->mode = im_len;
+			break;
+		case im_len:
+			if (state->srclen - state->srccnt >= FAST_IN &&
+			    state->destlen - state->destcnt >= MAX_MATCH) {
+				inflate_fast(state);
+				if (state->mode == im_bad)
+					return state->error;
+				if (state->mode != im_len)
+					break;
 			}
+
+			rc = huffman_decode(state, state->len_table, LEN_ROOT,
+			    &symbol);
+			if (rc != EOK)
+				return rc;
+
+			if (symbol < 256) {
+				state->length = symbol;
+				state->mode = im_lit;
+				break;
+			}
+
+			if (symbol == 256) {
+				/* End of block */
+				state->mode = state->last ? im_done : im_header;
+				break;
+			}
+
+			/* Compute length */
+			symbol -= 257;
+			if (symbol >= MAX_LEN)
+				return EINVAL;
+
+			state->length = lens[symbol];
+			state->extra = lens_ext[symbol];
+			state->mode = im_lenext;
+			break;
+		case im_lit:
+			/* Write out literal */
+			if (state->destcnt == state->destlen)
+				return ENOMEM;
+
+			state->dest[state->destcnt++] = (uint8_t) state->length;
+			state->mode = im_len;
+			break;
+		case im_lenext:
+			if (!need_bits(state, state->extra))
+				return ELIMIT;
+
+			state->length += peek_bits(state, state->extra);
+			drop_bits(state, state->extra);
+			state->mode = im_dist;
+			break;
+		case im_dist:
+			/* Get distance */
+			rc = huffman_decode(state, state->dist_table, DIST_ROOT,
+			    &symbol);
+			if (rc != EOK)
+				return rc;
+
+			if (symbol >= MAX_DIST)
+				return EINVAL;
+
+			state->dist = dists[symbol];
+			state->extra = dists_ext[symbol];
+			state->mode = im_distext;
+			break;
+		case im_distext:
+			if (!need_bits(state, state->extra))
+				return ELIMIT;
+
+			state->dist += peek_bits(state, state->extra);
+			drop_bits(state, state->extra);
+
+			if (!inflate_dist_valid(state))
+				return ENOENT;
+
+			state->mode = im_match;
+			break;
+		case im_match:
+			if (state->destcnt == state->destlen)
+				return ENOMEM;
+
+			n = min(state->length, state->destlen - state->destcnt);
+			inflate_copy_match(state, n);
+			state->length -= n;
+
+			if (state->length == 0)
+				state->mode = im_len;
+			break;
+		case im_done:
+			return EOK;
+		case im_bad:
+			return state->error;
 		}
 	}
+}
 
-	/* Check for end-of-block code */
-	if (length[256] == 0)
-		return EINVAL;
+#ifndef BOOT
 
-	/* Build Huffman tables for literal/length codes */
-	rc = huffman_construct(&dyn_len_code, length, nlen);
-	if ((rc < 0) || ((rc > 0) && (dyn_len_code.count[0] + 1 != nlen)))
-		return EINVAL;
+/** Create inflate state for streaming decompression
+ *
+ * @param rstate Place to store pointer to new inflate state.
+ *
+ * @return EOK on success.
+ * @return ENOMEM if out of memory.
+ *
+ */
+errno_t inflate_init(inflate_t **rstate)
+{
+	inflate_t *state;
 
-	/* Build Huffman tables for distance codes */
-	rc = huffman_construct(&dyn_dist_code, length + nlen, ndist);
-	if ((rc < 0) || ((rc > 0) && (dyn_dist_code.count[0] + 1 != ndist)))
-		return EINVAL;
+	state = calloc(1, sizeof(inflate_t));
+	if (state == NULL)
+		return ENOMEM;
+
+	state->window = malloc(WINDOW_SIZE);
+	if (state->window == NULL) {
+		free(state);
+		return ENOMEM;
+	}
+
+	state->mode = im_header;
+	*rstate = state;
+	return EOK;
+}
+
+/** Destroy inflate state
+ *
+ * @param state Inflate state.
+ *
+ */
+void inflate_destroy(inflate_t *state)
+{
+	if (state == NULL)
+		return;
+
+	free(state->window);
+	free(state);
+}
+
+/** Decompress chunk of data
+ *
+ * Consume as much of the input and fill as much of the output buffer
+ * as possible. Call again with more input and/or a new output buffer
+ * until EOK is returned.
+ *
+ * @param state     Inflate state.
+ * @param src       Source data buffer.
+ * @param srclen    Source buffer size (bytes).
+ * @param rconsumed Place to store number of bytes consumed.
+ * @param dest      Destination data buffer.
+ * @param destlen   Destination buffer size (bytes).
+ * @param rproduced Place to store number of bytes produced.
+ *
+ * @return EOK when the end of the stream has been reached.
+ * @return EAGAIN if more input or output space is needed.
+ * @return ENOENT on distance too large.
+ * @return EINVAL on invalid Huffman code or invalid deflate data.
+ *
+ */
+errno_t inflate_step(inflate_t *state, const void *src, size_t srclen,
+    size_t *rconsumed, void *dest, size_t destlen, size_t *rproduced)
+{
+	errno_t rc;
+	size_t n;
+
+	state->src = (const uint8_t *) src;
+	state->srclen = srclen;
+	state->srccnt = 0;
+
+	state->dest = (uint8_t *) dest;
+	state->destlen = destlen;
+	state->destcnt = 0;
+
+	rc = inflate_run(state);
+
+	if (rc == EOK) {
+		/* Return whole bytes after the end of the stream */
+		n = min(state->bitlen >> 3, state->srccnt);
+		state->srccnt -= n;
+		state->bitlen = 0;
+		state->bitbuf = 0;
+	} else if (rc == ELIMIT || rc == ENOMEM) {
+		rc = EAGAIN;
+	} else if (state->mode != im_bad) {
+		state->error = rc;
+		state->mode = im_bad;
+	}
+
+	inflate_update_window(state);
 
-	return inflate_codes(state, &dyn_len_code, &dyn_dist_code);
+	*rconsumed = state->srccnt;
+	*rproduced = state->destcnt;
+	return rc;
 }
 
+#endif
+
 /** Inflate data
+ *
+ * The whole output has to fit in the destination buffer, so no window
+ * is needed: back-references always point into the buffer itself.
  *
  * @param src     Source data buffer.
  * @param srclen  Source buffer size (bytes).
@@ -625,50 +1276,37 @@ static errno_t inflate_dynamic(inflate_state_t *state)
  * @return ENOMEM on output buffer overrun.
  *
  */
-errno_t inflate(void *src, size_t srclen, void *dest, size_t destlen)
+errno_t inflate(const void *src, size_t srclen, void *dest, size_t destlen)
 {
-	/* Initialize the state */
-	inflate_state_t state;
-
-	state.dest = (uint8_t *) dest;
-	state.destlen = destlen;
-	state.destcnt = 0;
-
-	state.src = (uint8_t *) src;
-	state.srclen = srclen;
-	state.srccnt = 0;
-
-	state.bitbuf = 0;
-	state.bitlen = 0;
-
-	state.overrun = false;
+	inflate_t *state;
+	errno_t rc;
+
+#ifdef BOOT
+	/* The decoding tables do not fit on the boot loader stack */
+	static inflate_t boot_state;
+
+	state = &boot_state;
+	memset(state, 0, sizeof(inflate_t));
+#else
+	state = calloc(1, sizeof(inflate_t));
+	if (state == NULL)
+		return ENOMEM;
+#endif
 
-	uint16_t last;
-	errno_t ret = EOK;
+	state->mode = im_header;
 
-	do {
-		/* Last block is indicated by a non-zero bit */
-		last = get_bits(&state, 1);
-		CHECK_OVERRUN(state);
+	state->src = (const uint8_t *) src;
+	state->srclen = srclen;
+	state->srccnt = 0;
 
-		/* Block type */
-		uint16_t type = get_bits(&state, 2);
-		CHECK_OVERRUN(state);
+	state->dest = (uint8_t *) dest;
+	state->destlen = destlen;
+	state->destcnt = 0;
 
-		switch (type) {
-		case 0:
-			ret = inflate_stored(&state);
-			break;
-		case 1:
-			ret = inflate_fixed(&state, &len_code, &dist_code);
-			break;
-		case 2:
-			ret = inflate_dynamic(&state);
-			break;
-		default:
-			ret = EINVAL;
-		}
-	} while ((!last) && (ret == 0));
+	rc = inflate_run(state);
 
-	return ret;
+#ifndef BOOT
+	free(state);
+#endif
+	return rc;
 }
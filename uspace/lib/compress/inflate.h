@@ -29,8 +29,16 @@
 #ifndef LIBCOMPRESS_INFLATE_H_
 #define LIBCOMPRESS_INFLATE_H_
 
+#include <errno.h>
 #include <stddef.h>
 
-extern errno_t inflate(void *, size_t, void *, size_t);
+/** Inflate state for streaming decompression */
+typedef struct inflate inflate_t;
+
+extern errno_t inflate(const void *, size_t, void *, size_t);
+extern errno_t inflate_init(inflate_t **);
+extern errno_t inflate_step(inflate_t *, const void *, size_t, size_t *,
+    void *, size_t, size_t *);
+extern void inflate_destroy(inflate_t *);
 
 #endif
@@ -0,0 +1,685 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_ADT_FLAT_HASH_MAP
+#define LIBCPP_BITS_ADT_FLAT_HASH_MAP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <utility>
+
+namespace helenos
+{
+    /**
+     * HelenOS extension: Hash map that stores its elements
+     * directly in a single array and resolves collisions by
+     * linear probing. Each slot has a control byte that is
+     * either empty, deleted (a tombstone left by erase) or
+     * holds seven bits of the hash of the key in the slot,
+     * so most mismatching slots are rejected without calling
+     * the key comparator.
+     *
+     * Compared to std::unordered_map, there is no allocation
+     * per element and lookups do not chase pointers. The price
+     * is that any insertion can move elements, so it invalidates
+     * all iterators, pointers and references to elements.
+     */
+    template<
+        class Key, class T,
+        class Hash = std::hash<Key>,
+        class KeyEqual = std::equal_to<Key>
+    >
+    class flat_hash_map
+    {
+        private:
+            template<class Value, class Map>
+            class iterator_type
+            {
+                public:
+                    using value_type        = Value;
+                    using reference         = Value&;
+                    using pointer           = Value*;
+                    using difference_type   = std::ptrdiff_t;
+                    using iterator_category = std::forward_iterator_tag;
+
+                    iterator_type(Map* map = nullptr, std::size_t idx = 0)
+                        : map_{map}, idx_{idx}
+                    { /* DUMMY BODY */ }
+
+                    /**
+                     * Conversion from iterator to const_iterator.
+                     */
+                    template<class V, class M>
+                    iterator_type(const iterator_type<V, M>& other)
+                        : map_{other.map_}, idx_{other.idx_}
+                    { /* DUMMY BODY */ }
+
+                    reference operator*() const
+                    {
+                        return map_->slots_[idx_];
+                    }
+
+                    pointer operator->() const
+                    {
+                        return &map_->slots_[idx_];
+                    }
+
+                    iterator_type& operator++()
+                    {
+                        idx_ = map_->next_full_(idx_ + 1);
+
+                        return *this;
+                    }
+
+                    iterator_type operator++(int)
+                    {
+                        auto tmp = *this;
+                        ++(*this);
+
+                        return tmp;
+                    }
+
+                    template<class V, class M>
+                    bool operator==(const iterator_type<V, M>& other) const
+                    {
+                        return idx_ == other.idx_;
+                    }
+
+                    template<class V, class M>
+                    bool operator!=(const iterator_type<V, M>& other) const
+                    {
+                        return idx_ != other.idx_;
+                    }
+
+                private:
+                    Map* map_;
+                    std::size_t idx_;
+
+                    template<class, class>
+                    friend class iterator_type;
+
+                    friend class flat_hash_map;
+            };
+
+        public:
+            using key_type        = Key;
+            using mapped_type     = T;
+            using value_type      = std::pair<const key_type, mapped_type>;
+            using size_type       = std::size_t;
+            using difference_type = std::ptrdiff_t;
+            using hasher          = Hash;
+            using key_equal       = KeyEqual;
+            using reference       = value_type&;
+            using const_reference = const value_type&;
+            using pointer         = value_type*;
+            using const_pointer   = const value_type*;
+
+            using iterator       = iterator_type<value_type, flat_hash_map>;
+            using const_iterator = iterator_type<
+                const value_type, const flat_hash_map
+            >;
+
+            flat_hash_map()
+                : flat_hash_map(size_type{}, hasher{}, key_equal{})
+            { /* DUMMY BODY */ }
+
+            explicit flat_hash_map(size_type count,
+                                   const hasher& hf = hasher{},
+                                   const key_equal& eql = key_equal{})
+                : slots_{}, ctrl_{}, capacity_{}, size_{}, used_{},
+                  hasher_{hf}, key_eq_{eql}
+            {
+                if (count > 0)
+                    reserve(count);
+            }
+
+            flat_hash_map(std::initializer_list<value_type> init,
+                          size_type count = size_type{},
+                          const hasher& hf = hasher{},
+                          const key_equal& eql = key_equal{})
+                : flat_hash_map(count, hf, eql)
+            {
+                reserve(init.size());
+                for (const auto& val: init)
+                    insert(val);
+            }
+
+            flat_hash_map(const flat_hash_map& other)
+                : flat_hash_map(other.size_, other.hasher_, other.key_eq_)
+            {
+                for (const auto& val: other)
+                    insert(val);
+            }
+
+            flat_hash_map(flat_hash_map&& other) noexcept
+                : slots_{other.slots_}, ctrl_{other.ctrl_},
+                  capacity_{other.capacity_}, size_{other.size_},
+                  used_{other.used_}, hasher_{std::move(other.hasher_)},
+                  key_eq_{std::move(other.key_eq_)}
+            {
+                other.slots_ = nullptr;
+                other.ctrl_ = nullptr;
+                other.capacity_ = size_type{};
+                other.size_ = size_type{};
+                other.used_ = size_type{};
+            }
+
+            flat_hash_map& operator=(const flat_hash_map& other)
+            {
+                flat_hash_map tmp{other};
+                swap(tmp);
+
+                return *this;
+            }
+
+            flat_hash_map& operator=(flat_hash_map&& other) noexcept
+            {
+                flat_hash_map tmp{std::move(other)};
+                swap(tmp);
+
+                return *this;
+            }
+
+            ~flat_hash_map()
+            {
+                clear();
+                release_();
+            }
+
+            iterator begin() noexcept
+            {
+                return iterator{this, next_full_(0)};
+            }
+
+            const_iterator begin() const noexcept
+            {
+                return cbegin();
+            }
+
+            const_iterator cbegin() const noexcept
+            {
+                return const_iterator{this, next_full_(0)};
+            }
+
+            iterator end() noexcept
+            {
+                return iterator{this, capacity_};
+            }
+
+            const_iterator end() const noexcept
+            {
+                return cend();
+            }
+
+            const_iterator cend() const noexcept
+            {
+                return const_iterator{this, capacity_};
+            }
+
+            bool empty() const noexcept
+            {
+                return size_ == 0;
+            }
+
+            size_type size() const noexcept
+            {
+                return size_;
+            }
+
+            size_type capacity() const noexcept
+            {
+                return capacity_;
+            }
+
+            float load_factor() const noexcept
+            {
+                if (capacity_ == 0)
+                    return 0.f;
+
+                return size_ / static_cast<float>(capacity_);
+            }
+
+            template<class... Args>
+            std::pair<iterator, bool> emplace(Args&&... args)
+            {
+                value_type val{std::forward<Args>(args)...};
+
+                return try_emplace(
+                    std::move(const_cast<key_type&>(val.first)),
+                    std::move(val.second)
+                );
+            }
+
+            template<class... Args>
+            std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+            {
+                auto [idx, found] = prepare_insert_(key);
+                if (!found)
+                {
+                    ::new(static_cast<void*>(slots_ + idx)) value_type{
+                        key, mapped_type(std::forward<Args>(args)...)
+                    };
+                }
+
+                return std::make_pair(iterator{this, idx}, !found);
+            }
+
+            template<class... Args>
+            std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
+            {
+                auto [idx, found] = prepare_insert_(key);
+                if (!found)
+                {
+                    ::new(static_cast<void*>(slots_ + idx)) value_type{
+                        std::move(key), mapped_type(std::forward<Args>(args)...)
+                    };
+                }
+
+                return std::make_pair(iterator{this, idx}, !found);
+            }
+
+            std::pair<iterator, bool> insert(const value_type& val)
+            {
+                return try_emplace(val.first, val.second);
+            }
+
+            std::pair<iterator, bool> insert(value_type&& val)
+            {
+                return try_emplace(
+                    std::move(const_cast<key_type&>(val.first)),
+                    std::move(val.second)
+                );
+            }
+
+            mapped_type& operator[](const key_type& key)
+            {
+                return try_emplace(key).first->second;
+            }
+
+            mapped_type& operator[](key_type&& key)
+            {
+                return try_emplace(std::move(key)).first->second;
+            }
+
+            mapped_type& at(const key_type& key)
+            {
+                auto it = find(key);
+
+                // TODO: throw out_of_range if it == end()
+                return it->second;
+            }
+
+            const mapped_type& at(const key_type& key) const
+            {
+                auto it = find(key);
+
+                // TODO: throw out_of_range if it == end()
+                return it->second;
+            }
+
+            iterator find(const key_type& key)
+            {
+                return iterator{this, find_(key)};
+            }
+
+            const_iterator find(const key_type& key) const
+            {
+                return const_iterator{this, find_(key)};
+            }
+
+            size_type count(const key_type& key) const
+            {
+                return find_(key) == capacity_ ? 0 : 1;
+            }
+
+            bool contains(const key_type& key) const
+            {
+                return find_(key) != capacity_;
+            }
+
+            iterator erase(const_iterator pos)
+            {
+                auto idx = pos.idx_;
+                erase_at_(idx);
+
+                return iterator{this, next_full_(idx + 1)};
+            }
+
+            size_type erase(const key_type& key)
+            {
+                auto idx = find_(key);
+                if (idx == capacity_)
+                    return 0;
+
+                erase_at_(idx);
+
+                return 1;
+            }
+
+            void clear() noexcept
+            {
+                for (size_type i = 0; i < capacity_; ++i)
+                {
+                    if (is_full_(ctrl_[i]))
+                        slots_[i].~value_type();
+                    ctrl_[i] = ctrl_empty_;
+                }
+
+                size_ = size_type{};
+                used_ = size_type{};
+            }
+
+            void swap(flat_hash_map& other) noexcept
+            {
+                std::swap(slots_, other.slots_);
+                std::swap(ctrl_, other.ctrl_);
+                std::swap(capacity_, other.capacity_);
+                std::swap(size_, other.size_);
+                std::swap(used_, other.used_);
+                std::swap(hasher_, other.hasher_);
+                std::swap(key_eq_, other.key_eq_);
+            }
+
+            /**
+             * Makes room for at least count elements
+             * without further rehashing.
+             */
+            void reserve(size_type count)
+            {
+                auto needed = capacity_for_(count);
+                if (needed > capacity_)
+                    rehash_(needed);
+            }
+
+            /**
+             * Rebuilds the table with at least count slots,
+             * this also gets rid of all tombstones.
+             */
+            void rehash(size_type count)
+            {
+                auto needed = capacity_for_(size_);
+                while (needed < count)
+                    needed *= 2;
+
+                rehash_(needed);
+            }
+
+            hasher hash_function() const
+            {
+                return hasher_;
+            }
+
+            key_equal key_eq() const
+            {
+                return key_eq_;
+            }
+
+        private:
+            value_type* slots_;
+            std::uint8_t* ctrl_;
+            size_type capacity_;
+            size_type size_;
+
+            /**
+             * Number of full slots plus tombstones, these are
+             * the slots that prolong the probe sequences.
+             */
+            size_type used_;
+
+            hasher hasher_;
+            key_equal key_eq_;
+
+            static constexpr std::uint8_t ctrl_empty_{0x00};
+            static constexpr std::uint8_t ctrl_deleted_{0x01};
+            static constexpr std::uint8_t ctrl_full_{0x80};
+            static constexpr size_type min_capacity_{8};
+
+            static bool is_full_(std::uint8_t ctrl) noexcept
+            {
+                return (ctrl & ctrl_full_) != 0;
+            }
+
+            /**
+             * Note: The load (including tombstones) is kept
+             *       at most 7/8, so there is always an empty
+             *       slot that terminates each probe sequence.
+             */
+            static bool overloaded_(size_type used, size_type capacity) noexcept
+            {
+                return used > capacity - capacity / 8;
+            }
+
+            static size_type capacity_for_(size_type count) noexcept
+            {
+                size_type res{min_capacity_};
+                while (overloaded_(count, res))
+                    res *= 2;
+
+                return res;
+            }
+
+            /**
+             * Note: std::hash of integers is the identity,
+             *       which would make all keys with equal low
+             *       bits share a probe sequence in a power
+             *       of two table, so the hash is mixed first.
+             */
+            std::uint64_t hash_(const key_type& key) const
+            {
+                std::uint64_t x = hasher_(key);
+                x ^= x >> 33;
+                x *= 0xff51afd7ed558ccdULL;
+                x ^= x >> 33;
+
+                return x;
+            }
+
+            static std::uint8_t tag_(std::uint64_t hash) noexcept
+            {
+                return ctrl_full_ | static_cast<std::uint8_t>(hash >> 57);
+            }
+
+            size_type next_full_(size_type idx) const noexcept
+            {
+                while (idx < capacity_ && !is_full_(ctrl_[idx]))
+                    ++idx;
+
+                return idx;
+            }
+
+            size_type find_(const key_type& key) const
+            {
+                if (size_ == 0)
+                    return capacity_;
+
+                auto hash = hash_(key);
+                auto tag = tag_(hash);
+                auto mask = capacity_ - 1;
+
+                for (size_type idx = hash & mask; ; idx = (idx + 1) & mask)
+                {
+                    auto ctrl = ctrl_[idx];
+                    if (ctrl == ctrl_empty_)
+                        return capacity_;
+                    if (ctrl == tag && key_eq_(slots_[idx].first, key))
+                        return idx;
+                }
+            }
+
+            /**
+             * Returns the index of the key and true if it is
+             * already present. Otherwise, the returned slot is
+             * reserved for the key and has to be constructed
+             * by the caller.
+             */
+            std::pair<size_type, bool> prepare_insert_(const key_type& key)
+            {
+                if (capacity_ == 0 || overloaded_(used_ + 1, capacity_))
+                {
+                    /**
+                     * Note: If many of the used slots are tombstones
+                     *       we only clean up, otherwise we grow.
+                     */
+                    auto new_capacity = capacity_for_(size_ + 1);
+                    if (new_capacity <= capacity_ && size_ >= capacity_ / 2)
+                        new_capacity = capacity_ * 2;
+                    rehash_(new_capacity);
+                }
+
+                auto hash = hash_(key);
+                auto tag = tag_(hash);
+                auto mask = capacity_ - 1;
+                auto target = capacity_;
+
+                for (size_type idx = hash & mask; ; idx = (idx + 1) & mask)
+                {
+                    auto ctrl = ctrl_[idx];
+                    if (ctrl == ctrl_empty_)
+                    {
+                        if (target == capacity_)
+                        {
+                            target = idx;
+                            ++used_;
+                        }
+                        break;
+                    }
+                    else if (ctrl == ctrl_deleted_)
+                    {
+                        if (target == capacity_)
+                            target = idx;
+                    }
+                    else if (ctrl == tag && key_eq_(slots_[idx].first, key))
+                        return std::make_pair(idx, true);
+                }
+
+                ctrl_[target] = tag;
+                ++size_;
+
+                return std::make_pair(target, false);
+            }
+
+            void erase_at_(size_type idx)
+            {
+                slots_[idx].~value_type();
+                --size_;
+
+                /**
+                 * Note: A tombstone is only needed if a probe
+                 *       sequence can continue past this slot.
+                 */
+                if (ctrl_[(idx + 1) & (capacity_ - 1)] == ctrl_empty_)
+                {
+                    ctrl_[idx] = ctrl_empty_;
+                    --used_;
+                }
+                else
+                    ctrl_[idx] = ctrl_deleted_;
+            }
+
+            void rehash_(size_type new_capacity)
+            {
+                auto old_slots = slots_;
+                auto old_ctrl = ctrl_;
+                auto old_capacity = capacity_;
+
+                slots_ = static_cast<value_type*>(
+                    ::operator new(new_capacity * sizeof(value_type))
+                );
+                ctrl_ = new std::uint8_t[new_capacity]();
+                capacity_ = new_capacity;
+                size_ = size_type{};
+                used_ = size_type{};
+
+                for (size_type i = 0; i < old_capacity; ++i)
+                {
+                    if (!is_full_(old_ctrl[i]))
+                        continue;
+
+                    auto& val = old_slots[i];
+                    auto idx = prepare_insert_(val.first).first;
+                    ::new(static_cast<void*>(slots_ + idx)) value_type{
+                        std::move(const_cast<key_type&>(val.first)),
+                        std::move(val.second)
+                    };
+                    val.~value_type();
+                }
+
+                ::operator delete(old_slots);
+                delete[] old_ctrl;
+            }
+
+            void release_() noexcept
+            {
+                ::operator delete(slots_);
+                delete[] ctrl_;
+
+                slots_ = nullptr;
+                ctrl_ = nullptr;
+                capacity_ = size_type{};
+            }
+    };
+
+    template<class Key, class T, class Hash, class KeyEqual>
+    bool operator==(const flat_hash_map<Key, T, Hash, KeyEqual>& lhs,
+                    const flat_hash_map<Key, T, Hash, KeyEqual>& rhs)
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+
+        for (const auto& val: lhs)
+        {
+            auto it = rhs.find(val.first);
+            if (it == rhs.end() || !(it->second == val.second))
+                return false;
+        }
+
+        return true;
+    }
+
+    template<class Key, class T, class Hash, class KeyEqual>
+    bool operator!=(const flat_hash_map<Key, T, Hash, KeyEqual>& lhs,
+                    const flat_hash_map<Key, T, Hash, KeyEqual>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    template<class Key, class T, class Hash, class KeyEqual>
+    void swap(flat_hash_map<Key, T, Hash, KeyEqual>& lhs,
+              flat_hash_map<Key, T, Hash, KeyEqual>& rhs)
+        noexcept(noexcept(lhs.swap(rhs)))
+    {
+        lhs.swap(rhs);
+    }
+}
+
+#endif
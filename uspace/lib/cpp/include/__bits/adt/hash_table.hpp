@@ -33,6 +33,7 @@
 #include <__bits/adt/key_extractors.hpp>
 #include <__bits/adt/hash_table_iterators.hpp>
 #include <__bits/adt/hash_table_policies.hpp>
+#include <__bits/adt/node_pool.hpp>
 #include <cstdlib>
 #include <iterator>
 #include <limits>
@@ -111,7 +112,7 @@ namespace std::aux
                 : table_{other.table_}, bucket_count_{other.bucket_count_},
                   size_{other.size_}, hasher_{move(other.hasher_)},
                   key_eq_{move(other.key_eq_)}, key_extractor_{move(other.key_extractor_)},
-                  max_load_factor_{other.max_load_factor_}
+                  max_load_factor_{other.max_load_factor_}, pool_{move(other.pool_)}
             {
                 other.table_ = nullptr;
                 other.bucket_count_ = size_type{};
@@ -234,7 +235,7 @@ namespace std::aux
                 --size_;
 
                 node->unlink();
-                delete node;
+                pool_.destroy(node);
 
                 if (empty())
                     return end();
@@ -245,14 +246,14 @@ namespace std::aux
             void clear() noexcept
             {
                 for (size_type i = 0; i < bucket_count_; ++i)
-                    table_[i].clear();
+                    table_[i].clear(pool_);
                 size_ = size_type{};
             }
 
             void swap(hash_table& other)
                 noexcept(allocator_traits<allocator_type>::is_always_equal::value &&
-                         noexcept(swap(declval<Hasher&>(), declval<Hasher&>())) &&
-                         noexcept(swap(declval<KeyEq&>(), declval<KeyEq&>())))
+                         noexcept(std::swap(declval<Hasher&>(), declval<Hasher&>())) &&
+                         noexcept(std::swap(declval<KeyEq&>(), declval<KeyEq&>())))
             {
                 std::swap(table_, other.table_);
                 std::swap(bucket_count_, other.bucket_count_);
@@ -260,6 +261,7 @@ namespace std::aux
                 std::swap(hasher_, other.hasher_);
                 std::swap(key_eq_, other.key_eq_);
                 std::swap(max_load_factor_, other.max_load_factor_);
+                pool_.swap(other.pool_);
             }
 
             hasher hash_function() const
@@ -447,11 +449,13 @@ namespace std::aux
                     table_[i].head = nullptr;
                 }
 
-                new_table.size_ = size_;
-                swap(new_table);
-
-                delete[] new_table.table_;
-                new_table.table_ = nullptr;
+                /**
+                 * Note: Only the buckets are exchanged, the nodes
+                 *       stay in our pool. The old, now empty, buckets
+                 *       are destroyed with new_table.
+                 */
+                std::swap(table_, new_table.table_);
+                std::swap(bucket_count_, new_table.bucket_count_);
             }
 
             void reserve(size_type count)
@@ -496,9 +500,11 @@ namespace std::aux
 
             ~hash_table()
             {
-                // Lists are deleted in ~hash_table_bucket.
                 if (table_)
+                {
+                    clear();
                     delete[] table_;
+                }
             }
 
             place_type find_insertion_spot(const key_type& key) const
@@ -557,6 +563,17 @@ namespace std::aux
                 --size_;
             }
 
+            template<class... Args>
+            node_type* create_node(Args&&... args)
+            {
+                return pool_.create(forward<Args>(args)...);
+            }
+
+            void destroy_node(node_type* node)
+            {
+                pool_.destroy(node);
+            }
+
         private:
             hash_table_bucket<value_type, size_type>* table_;
             size_type bucket_count_;
@@ -565,6 +582,7 @@ namespace std::aux
             key_equal key_eq_;
             key_extract key_extractor_;
             float max_load_factor_;
+            node_pool<node_type> pool_;
 
             static constexpr float bucket_count_growth_factor_{1.25};
 
@@ -79,7 +79,13 @@ namespace std::aux
                 head->prepend(node);
         }
 
-        void clear()
+        /**
+         * Note: Nodes are owned by the node pool of the
+         *       table, so the bucket cannot destroy them
+         *       on its own.
+         */
+        template<class Pool>
+        void clear(Pool& pool)
         {
             if (!head)
                 return;
@@ -89,17 +95,12 @@ namespace std::aux
             {
                 auto tmp = current;
                 current = current->next;
-                delete tmp;
+                pool.destroy(tmp);
             }
             while (current && current != head);
 
             head = nullptr;
         }
-
-        ~hash_table_bucket()
-        {
-            clear();
-        }
     };
 }
 
@@ -74,7 +74,7 @@ namespace std::aux
                 {
                     if (idx_ < max_idx_)
                     {
-                        while (!table_[++idx_].head && idx_ < max_idx_)
+                        while (++idx_ < max_idx_ && !table_[idx_].head)
                         { /* DUMMY BODY */ }
 
                         if (idx_ < max_idx_)
@@ -194,7 +194,7 @@ namespace std::aux
                 {
                     if (idx_ < max_idx_)
                     {
-                        while (!table_[++idx_].head && idx_ < max_idx_)
+                        while (++idx_ < max_idx_ && !table_[idx_].head)
                         { /* DUMMY BODY */ }
 
                         if (idx_ < max_idx_)
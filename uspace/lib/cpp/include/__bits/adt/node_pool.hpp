@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_ADT_NODE_POOL
+#define LIBCPP_BITS_ADT_NODE_POOL
+
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+namespace std::aux
+{
+    /**
+     * Storage for nodes of a single container. Nodes are carved
+     * out of chunks that grow geometrically, freed nodes are kept
+     * on a free list and reused, so a container that keeps
+     * inserting and erasing elements stops calling into the
+     * allocator once its working set is reached. The chunks
+     * are returned only when the pool is destroyed.
+     * Note: All nodes have to be destroyed before the pool is.
+     */
+    template<class Node>
+    class node_pool
+    {
+        public:
+            node_pool() noexcept
+                : chunks_{}, free_{}, next_chunk_size_{initial_chunk_size_}
+            { /* DUMMY BODY */ }
+
+            node_pool(const node_pool&) = delete;
+            node_pool& operator=(const node_pool&) = delete;
+
+            node_pool(node_pool&& other) noexcept
+                : chunks_{other.chunks_}, free_{other.free_},
+                  next_chunk_size_{other.next_chunk_size_}
+            {
+                other.chunks_ = nullptr;
+                other.free_ = nullptr;
+                other.next_chunk_size_ = initial_chunk_size_;
+            }
+
+            node_pool& operator=(node_pool&& other) noexcept
+            {
+                node_pool tmp{move(other)};
+                swap(tmp);
+
+                return *this;
+            }
+
+            ~node_pool()
+            {
+                while (chunks_)
+                {
+                    auto next = chunks_->next;
+                    ::operator delete(chunks_);
+                    chunks_ = next;
+                }
+            }
+
+            template<class... Args>
+            Node* create(Args&&... args)
+            {
+                if (!free_)
+                    grow_();
+
+                auto slot = free_;
+                free_ = slot->next;
+
+                return ::new(static_cast<void*>(slot)) Node{forward<Args>(args)...};
+            }
+
+            void destroy(Node* node) noexcept
+            {
+                node->~Node();
+
+                auto slot = reinterpret_cast<slot_*>(node);
+                slot->next = free_;
+                free_ = slot;
+            }
+
+            void swap(node_pool& other) noexcept
+            {
+                std::swap(chunks_, other.chunks_);
+                std::swap(free_, other.free_);
+                std::swap(next_chunk_size_, other.next_chunk_size_);
+            }
+
+        private:
+            union slot_
+            {
+                slot_* next;
+                alignas(Node) unsigned char storage[sizeof(Node)];
+            };
+
+            /**
+             * Chunk header, the slots follow it. The alignment
+             * makes sure the first slot is properly aligned.
+             */
+            struct alignas(slot_) chunk_
+            {
+                chunk_* next;
+            };
+
+            chunk_* chunks_;
+            slot_* free_;
+            size_t next_chunk_size_;
+
+            static constexpr size_t initial_chunk_size_{8};
+            static constexpr size_t max_chunk_size_{256};
+
+            void grow_()
+            {
+                auto count = next_chunk_size_;
+                auto chunk = static_cast<chunk_*>(
+                    ::operator new(sizeof(chunk_) + count * sizeof(slot_))
+                );
+                chunk->next = chunks_;
+                chunks_ = chunk;
+
+                auto slots = reinterpret_cast<slot_*>(chunk + 1);
+                for (size_t i = count; i > 0; --i)
+                {
+                    slots[i - 1].next = free_;
+                    free_ = &slots[i - 1];
+                }
+
+                if (next_chunk_size_ < max_chunk_size_)
+                    next_chunk_size_ *= 2;
+            }
+    };
+}
+
+#endif
@@ -335,7 +335,7 @@ namespace std
                 }
                 else
                 {
-                    auto node = new node_type{key, forward<Args>(args)...};
+                    auto node = table_.create_node(key, forward<Args>(args)...);
                     bucket->append(node);
 
                     return make_pair(iterator{
@@ -370,7 +370,7 @@ namespace std
                 }
                 else
                 {
-                    auto node = new node_type{move(key), forward<Args>(args)...};
+                    auto node = table_.create_node(move(key), forward<Args>(args)...);
                     bucket->append(node);
 
                     return make_pair(iterator{
@@ -418,7 +418,7 @@ namespace std
                 }
                 else
                 {
-                    auto node = new node_type{key, forward<T>(val)};
+                    auto node = table_.create_node(key, forward<T>(val));
                     bucket->append(node);
 
                     return make_pair(iterator{
@@ -454,7 +454,7 @@ namespace std
                 }
                 else
                 {
-                    auto node = new node_type{move(key), forward<T>(val)};
+                    auto node = table_.create_node(move(key), forward<T>(val));
                     bucket->append(node);
 
                     return make_pair(iterator{
@@ -567,7 +567,7 @@ namespace std
                     while (current != head);
                 }
 
-                auto node = new node_type{key, mapped_type{}};
+                auto node = table_.create_node(key, mapped_type{});
                 bucket->append(node);
 
                 table_.increment_size();
@@ -595,7 +595,7 @@ namespace std
                     while (current != head);
                 }
 
-                auto node = new node_type{move(key), mapped_type{}};
+                auto node = table_.create_node(move(key), mapped_type{});
                 bucket->append(node);
 
                 table_.increment_size();
@@ -82,15 +82,24 @@ namespace std
                 data_ = allocator_.allocate(capacity_);
 
                 for (size_type i = 0; i < size_; ++i)
-                    data_[i] = val;
+                    allocator_traits<Allocator>::construct(allocator_, data_ + i, val);
             }
 
             template<class InputIterator>
             vector(InputIterator first, InputIterator last,
                    const Allocator& alloc = Allocator{})
+                : data_{nullptr}, size_{}, capacity_{}, allocator_{alloc}
             {
-                // TODO: research constraints and provide multiple
-                //       implementations via enable_if
+                if constexpr (is_integral<InputIterator>::value)
+                { // Required by the standard.
+                    resize(static_cast<size_type>(first),
+                           static_cast<value_type>(last));
+                }
+                else
+                {
+                    while (first != last)
+                        push_back(*first++);
+                }
             }
 
             vector(const vector& other)
@@ -100,7 +109,7 @@ namespace std
                 data_ = allocator_.allocate(capacity_);
 
                 for (size_type i = 0; i < size_; ++i)
-                    data_[i] = other.data_[i];
+                    allocator_traits<Allocator>::construct(allocator_, data_ + i, other.data_[i]);
             }
 
             vector(vector&& other) noexcept
@@ -119,7 +128,7 @@ namespace std
                 data_ = allocator_.allocate(capacity_);
 
                 for (size_type i = 0; i < size_; ++i)
-                    data_[i] = other.data_[i];
+                    allocator_traits<Allocator>::construct(allocator_, data_ + i, other.data_[i]);
             }
 
             vector(initializer_list<T> init, const Allocator& alloc = Allocator{})
@@ -131,12 +140,13 @@ namespace std
                 auto it = init.begin();
                 for (size_type i = 0; it != init.end(); ++i, ++it)
                 {
-                    data_[i] = *it;
+                    allocator_traits<Allocator>::construct(allocator_, data_ + i, *it);
                 }
             }
 
             ~vector()
             {
+                destroy_from_end_until_(begin());
                 allocator_.deallocate(data_, capacity_);
             }
 
@@ -274,16 +284,34 @@ namespace std
 
             void resize(size_type sz)
             {
-                resize_with_copy_(size_, capacity_);
+                if (sz <= size_)
+                {
+                    resize_with_copy_(sz, capacity_);
+
+                    return;
+                }
+
+                if (sz > capacity_)
+                    resize_with_copy_(size_, sz);
+
+                while (size_ < sz)
+                    allocator_traits<Allocator>::construct(allocator_, data_ + size_++);
             }
 
             void resize(size_type sz, const value_type& val)
             {
-                auto old_size = size_;
-                resize_with_copy_(sz, capacity_);
+                if (sz <= size_)
+                {
+                    resize_with_copy_(sz, capacity_);
 
-                for (size_type i = old_size - 1; i < size_; ++i)
-                    data_[i] = val;
+                    return;
+                }
+
+                if (sz > capacity_)
+                    resize_with_copy_(size_, sz);
+
+                while (size_ < sz)
+                    allocator_traits<Allocator>::construct(allocator_, data_ + size_++, val);
             }
 
             size_type capacity() const noexcept
@@ -307,7 +335,15 @@ namespace std
 
             void shrink_to_fit()
             {
-                resize_with_copy_(size_, size_);
+                if (capacity_ == size_)
+                    return;
+
+                auto new_data = allocator_.allocate(size_);
+                relocate_(new_data, 0, size_, 0);
+
+                allocator_.deallocate(data_, capacity_);
+                data_ = new_data;
+                capacity_ = size_;
             }
 
             reference operator[](size_type idx)
@@ -377,6 +413,7 @@ namespace std
 
                 allocator_traits<Allocator>::construct(allocator_,
                                                        begin() + size_, forward<Args>(args)...);
+                ++size_;
 
                 return back();
             }
@@ -385,14 +422,18 @@ namespace std
             {
                 if (size_ >= capacity_)
                     resize_with_copy_(size_, next_capacity_());
-                data_[size_++] = x;
+
+                allocator_traits<Allocator>::construct(allocator_, data_ + size_, x);
+                ++size_;
             }
 
             void push_back(T&& x)
             {
                 if (size_ >= capacity_)
                     resize_with_copy_(size_, next_capacity_());
-                data_[size_++] = forward<T>(x);
+
+                allocator_traits<Allocator>::construct(allocator_, data_ + size_, move(x));
+                ++size_;
             }
 
             void pop_back()
@@ -407,7 +448,7 @@ namespace std
                 auto pos = const_cast<iterator>(position);
 
                 pos = shift_(pos, 1);
-                allocator_.construct(pos, forward<Args>(args)...);
+                *pos = value_type(forward<Args>(args)...);
 
                 return pos;
             }
@@ -471,6 +512,7 @@ namespace std
             {
                 iterator pos = const_cast<iterator>(position);
                 copy(position + 1, cend(), pos);
+                destroy_from_end_until_(end() - 1);
                 --size_;
 
                 return pos;
@@ -479,7 +521,8 @@ namespace std
             iterator erase(const_iterator first, const_iterator last)
             {
                 iterator pos = const_cast<iterator>(first);
-                copy(last, cend(), pos);
+                auto new_end = copy(last, cend(), pos);
+                destroy_from_end_until_(new_end);
                 size_ -= static_cast<size_type>(last - first);
 
                 return pos;
@@ -507,36 +550,46 @@ namespace std
             size_type capacity_;
             allocator_type allocator_;
 
-            void resize_without_copy_(size_type capacity)
-            {
-                if (data_)
-                    allocator_.deallocate(data_, capacity_);
-
-                data_ = allocator_.allocate(capacity);
-                size_ = 0;
-                capacity_ = capacity;
-            }
-
             void resize_with_copy_(size_type size, size_type capacity)
             {
                 if (size < size_)
+                {
                     destroy_from_end_until_(begin() + size);
+                    size_ = size;
+                }
 
-                if(capacity_ == 0 || capacity_ < capacity)
+                if (capacity_ == 0 || capacity_ < capacity)
                 {
                     auto new_data = allocator_.allocate(capacity);
+                    relocate_(new_data, 0, size_, 0);
 
-                    auto to_copy = min(size, size_);
-                    for (size_type i = 0; i < to_copy; ++i)
-                        new_data[i] = move(data_[i]);
+                    allocator_.deallocate(data_, capacity_);
+                    data_ = new_data;
+                    capacity_ = capacity;
+                }
 
-                    std::swap(data_, new_data);
+                size_ = size;
+            }
 
-                    allocator_.deallocate(new_data, capacity_);
+            /**
+             * Moves [first, last) of our elements to uninitialized
+             * storage starting at dest + offset and destroys the
+             * originals. Elements are only moved if that cannot
+             * throw (or if they cannot be copied), so that a failed
+             * reallocation leaves the vector intact.
+             */
+            void relocate_(value_type* dest, size_type first,
+                           size_type last, size_type offset)
+            {
+                for (auto i = first; i < last; ++i)
+                {
+                    allocator_traits<Allocator>::construct(
+                        allocator_, dest + i + offset, move_if_noexcept(data_[i])
+                    );
                 }
 
-                capacity_ = capacity;
-                size_ = size;
+                for (auto i = first; i < last; ++i)
+                    allocator_traits<Allocator>::destroy(allocator_, data_ + i);
             }
 
             void destroy_from_end_until_(iterator target)
@@ -557,37 +610,61 @@ namespace std
                     return max(capacity_ * 2, size_type{2u});
             }
 
+            /**
+             * Opens a gap of count elements at position, the
+             * elements in the gap are left constructed so that
+             * the callers can assign to them.
+             */
             iterator shift_(iterator position, size_type count)
             {
-                if (size_ + count < capacity_)
-                {
-                    copy_backward(position, end(), end() + count);
-                    size_ += count;
+                auto start_idx = static_cast<size_type>(position - begin());
+                auto end_idx = start_idx + count;
+                auto new_size = size_ + count;
 
-                    return position;
+                if (new_size <= capacity_)
+                {
+                    // Elements moved past the old end need construction.
+                    for (auto i = size_; i > start_idx; --i)
+                    {
+                        auto target = i - 1 + count;
+                        if (target >= size_)
+                        {
+                            allocator_traits<Allocator>::construct(
+                                allocator_, data_ + target, move(data_[i - 1])
+                            );
+                        }
+                        else
+                            data_[target] = move(data_[i - 1]);
+                    }
+
+                    for (auto i = max(size_, start_idx); i < end_idx; ++i)
+                        construct_gap_(data_ + i);
                 }
                 else
                 {
-                    auto start_idx = static_cast<size_type>(position - begin());
-                    auto end_idx = start_idx + count;
-                    auto new_size = size_ + count;
+                    auto new_capacity = max(new_size, next_capacity_());
+                    auto new_data = allocator_.allocate(new_capacity);
 
-                    // Auxiliary vector for easier swap.
-                    vector tmp{};
-                    tmp.resize_without_copy_(max(new_size, capacity_));
-                    tmp.size_ = new_size;
+                    relocate_(new_data, 0, start_idx, 0);
+                    relocate_(new_data, start_idx, size_, count);
+                    for (auto i = start_idx; i < end_idx; ++i)
+                        construct_gap_(new_data + i);
 
-                    // Copy before insertion index.
-                    copy(begin(), begin() + start_idx, tmp.begin());
+                    allocator_.deallocate(data_, capacity_);
+                    data_ = new_data;
+                    capacity_ = new_capacity;
+                }
 
-                    // Copy after insertion index.
-                    copy(begin() + start_idx, end(), tmp.begin() + end_idx);
+                size_ = new_size;
 
-                    swap(tmp);
+                // Position might have been invalidated!
+                return begin() + start_idx;
+            }
 
-                    // Position was invalidated!
-                    return begin() + start_idx;
-                }
+            void construct_gap_(value_type* ptr)
+            {
+                if constexpr (is_default_constructible<value_type>::value)
+                    allocator_traits<Allocator>::construct(allocator_, ptr);
             }
     };
 
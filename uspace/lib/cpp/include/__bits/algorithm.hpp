@@ -29,7 +29,9 @@
 #ifndef LIBCPP_BITS_ALGORITHM
 #define LIBCPP_BITS_ALGORITHM
 
+#include <__bits/memory/misc.hpp>
 #include <iterator>
+#include <new>
 #include <utility>
 
 namespace std
@@ -158,9 +160,13 @@ namespace std
     template<class ForwardIterator>
     ForwardIterator adjacent_find(ForwardIterator first, ForwardIterator last)
     {
-        while (first != last)
+        if (first == last)
+            return last;
+
+        auto next = first;
+        while (++next != last)
         {
-            if (*first == *(first + 1))
+            if (*first == *next)
                 return first;
             ++first;
         }
@@ -171,9 +177,13 @@ namespace std
     template<class ForwardIterator, class Predicate>
     ForwardIterator adjacent_find(ForwardIterator first, ForwardIterator last, Predicate pred)
     {
-        while (first != last)
+        if (first == last)
+            return last;
+
+        auto next = first;
+        while (++next != last)
         {
-            if (pred(*first, *(first + 1)))
+            if (pred(*first, *next))
                 return first;
             ++first;
         }
@@ -679,13 +689,195 @@ namespace std
      * 25.4.1.1, sort:
      */
 
-    template<class RandomAccessIterator, class Compare>
-    void make_heap(RandomAccessIterator, RandomAccessIterator,
-                   Compare);
+    namespace aux
+    {
+        /**
+         * Ranges up to this size are left to the final
+         * insertion sort pass instead of being partitioned.
+         */
+        inline constexpr ptrdiff_t sort_threshold{16};
 
-    template<class RandomAccessIterator, class Compare>
-    void sort_heap(RandomAccessIterator, RandomAccessIterator,
-                   Compare);
+        template<class RandomAccessIterator, class Compare>
+        void heap_sift_down(RandomAccessIterator first, ptrdiff_t idx,
+                            ptrdiff_t count, Compare comp)
+        {
+            auto val = move(first[idx]);
+
+            auto child = 2 * idx + 1;
+            while (child < count)
+            {
+                if (child + 1 < count && comp(first[child], first[child + 1]))
+                    ++child;
+                if (!comp(val, first[child]))
+                    break;
+
+                first[idx] = move(first[child]);
+                idx = child;
+                child = 2 * idx + 1;
+            }
+
+            first[idx] = move(val);
+        }
+
+        /**
+         * Moves the smallest middle - first elements of
+         * [first, last) into [first, middle) in sorted order.
+         */
+        template<class RandomAccessIterator, class Compare>
+        void heap_select_sort(RandomAccessIterator first,
+                              RandomAccessIterator middle,
+                              RandomAccessIterator last, Compare comp)
+        {
+            ptrdiff_t count = middle - first;
+            if (count <= 0)
+                return;
+
+            for (auto idx = count / 2; idx > 0; --idx)
+                heap_sift_down(first, idx - 1, count, comp);
+
+            for (auto it = middle; it < last; ++it)
+            {
+                if (comp(*it, *first))
+                {
+                    iter_swap(it, first);
+                    heap_sift_down(first, ptrdiff_t{}, count, comp);
+                }
+            }
+
+            while (count > 1)
+            {
+                --count;
+                iter_swap(first, first + count);
+                heap_sift_down(first, ptrdiff_t{}, count, comp);
+            }
+        }
+
+        template<class RandomAccessIterator, class Compare>
+        void insertion_sort(RandomAccessIterator first,
+                            RandomAccessIterator last, Compare comp)
+        {
+            if (first == last)
+                return;
+
+            for (auto it = first + 1; it < last; ++it)
+            {
+                auto val = move(*it);
+                auto hole = it;
+
+                if (comp(val, *first))
+                {
+                    while (hole != first)
+                    {
+                        *hole = move(*(hole - 1));
+                        --hole;
+                    }
+                }
+                else
+                {
+                    // *first stops the scan, no bound check needed.
+                    while (comp(val, *(hole - 1)))
+                    {
+                        *hole = move(*(hole - 1));
+                        --hole;
+                    }
+                }
+
+                *hole = move(val);
+            }
+        }
+
+        template<class RandomAccessIterator, class Compare>
+        void move_median_to_first(RandomAccessIterator result,
+                                  RandomAccessIterator a,
+                                  RandomAccessIterator b,
+                                  RandomAccessIterator c, Compare comp)
+        {
+            if (comp(*a, *b))
+            {
+                if (comp(*b, *c))
+                    iter_swap(result, b);
+                else if (comp(*a, *c))
+                    iter_swap(result, c);
+                else
+                    iter_swap(result, a);
+            }
+            else if (comp(*a, *c))
+                iter_swap(result, a);
+            else if (comp(*b, *c))
+                iter_swap(result, c);
+            else
+                iter_swap(result, b);
+        }
+
+        /**
+         * Partitions [first + 1, last) around the median of three
+         * elements, which is moved to *first. The two remaining
+         * candidates bound both scans, so the loops need no range
+         * checks.
+         */
+        template<class RandomAccessIterator, class Compare>
+        RandomAccessIterator partition_pivot(RandomAccessIterator first,
+                                             RandomAccessIterator last,
+                                             Compare comp)
+        {
+            auto mid = first + (last - first) / 2;
+            move_median_to_first(first, first + 1, mid, last - 1, comp);
+
+            auto pivot = first;
+            auto lo = first + 1;
+            auto hi = last;
+            while (true)
+            {
+                while (comp(*lo, *pivot))
+                    ++lo;
+                --hi;
+                while (comp(*pivot, *hi))
+                    --hi;
+
+                if (!(lo < hi))
+                    return lo;
+
+                iter_swap(lo, hi);
+                ++lo;
+            }
+        }
+
+        inline ptrdiff_t sort_depth_limit(ptrdiff_t count)
+        {
+            ptrdiff_t depth{};
+            while (count > 1)
+            {
+                count >>= 1;
+                ++depth;
+            }
+
+            return 2 * depth;
+        }
+
+        template<class RandomAccessIterator, class Compare>
+        void introsort_loop(RandomAccessIterator first,
+                            RandomAccessIterator last,
+                            ptrdiff_t depth, Compare comp)
+        {
+            while (last - first > sort_threshold)
+            {
+                if (depth == 0)
+                {
+                    // Quicksort is degenerating, finish with heapsort.
+                    heap_select_sort(first, last, last, comp);
+
+                    return;
+                }
+                --depth;
+
+                auto cut = partition_pivot(first, last, comp);
+
+                // Recurse into the right part, loop on the left one.
+                introsort_loop(cut, last, depth, comp);
+                last = cut;
+            }
+        }
+    }
 
     template<class RandomAccessIterator>
     void sort(RandomAccessIterator first, RandomAccessIterator last)
@@ -700,35 +892,204 @@ namespace std
               Compare comp)
     {
         /**
-         * Note: This isn't the most effective approach,
-         *       but since we already have these two functions
-         *       and they satisfy asymptotic limitations
-         *       imposed by the standard, we're using them at
-         *       the moment. Might be good to change it to qsort
-         *       or merge sort later.
+         * Introsort: median-of-three quicksort that switches
+         * to heapsort once the recursion gets too deep, leaving
+         * short ranges unsorted for a single insertion sort
+         * pass at the end.
          */
 
-        make_heap(first, last, comp);
-        sort_heap(first, last, comp);
+        if (last - first < 2)
+            return;
+
+        aux::introsort_loop(
+            first, last, aux::sort_depth_limit(last - first), comp
+        );
+        aux::insertion_sort(first, last, comp);
     }
 
     /**
      * 25.4.1.2, stable_sort:
      */
 
-    // TODO: implement
+    namespace aux
+    {
+        /**
+         * Merges the sorted ranges [first, middle) and [middle, last),
+         * the left one is moved to buf first, which has to have
+         * space for at least middle - first elements.
+         */
+        template<class RandomAccessIterator, class T, class Compare>
+        void merge_with_buffer(RandomAccessIterator first,
+                               RandomAccessIterator middle,
+                               RandomAccessIterator last,
+                               T* buf, Compare comp)
+        {
+            T* buf_end = buf;
+            for (auto it = first; it != middle; ++it, ++buf_end)
+                ::new(static_cast<void*>(buf_end)) T(move(*it));
+
+            auto out = first;
+            auto left = buf;
+            auto right = middle;
+            while (left != buf_end && right != last)
+            {
+                // Take from the right only if strictly smaller to keep stability.
+                if (comp(*right, *left))
+                    *out++ = move(*right++);
+                else
+                    *out++ = move(*left++);
+            }
+
+            while (left != buf_end)
+                *out++ = move(*left++);
+
+            for (auto it = buf; it != buf_end; ++it)
+                it->~T();
+        }
+
+        template<class RandomAccessIterator, class T, class Compare>
+        void merge_sort_with_buffer(RandomAccessIterator first,
+                                    RandomAccessIterator last,
+                                    T* buf, Compare comp)
+        {
+            if (last - first <= sort_threshold)
+            {
+                insertion_sort(first, last, comp);
+
+                return;
+            }
+
+            auto middle = first + (last - first) / 2;
+            merge_sort_with_buffer(first, middle, buf, comp);
+            merge_sort_with_buffer(middle, last, buf, comp);
+
+            // Already in order, common for partially sorted input.
+            if (!comp(*middle, *(middle - 1)))
+                return;
+
+            merge_with_buffer(first, middle, last, buf, comp);
+        }
+    }
+
+    template<class RandomAccessIterator>
+    void stable_sort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        stable_sort(first, last, less<value_type>{});
+    }
+
+    template<class RandomAccessIterator, class Compare>
+    void stable_sort(RandomAccessIterator first, RandomAccessIterator last,
+                     Compare comp)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        ptrdiff_t count = last - first;
+        if (count <= aux::sort_threshold)
+        {
+            aux::insertion_sort(first, last, comp);
+
+            return;
+        }
+
+        /**
+         * Every merge moves at most the left half of its
+         * range to the buffer, the top level one being the
+         * largest.
+         */
+        ptrdiff_t needed = count / 2;
+        auto buf = get_temporary_buffer<value_type>(needed);
+
+        /**
+         * Note: Insertion sort is our fallback when memory
+         *       is scarce, it is stable but quadratic.
+         */
+        if (buf.second < needed)
+            aux::insertion_sort(first, last, comp);
+        else
+            aux::merge_sort_with_buffer(first, last, buf.first, comp);
+
+        return_temporary_buffer(buf.first);
+    }
 
     /**
      * 25.4.1.3, partial_sort:
      */
 
-    // TODO: implement
+    template<class RandomAccessIterator>
+    void partial_sort(RandomAccessIterator first,
+                      RandomAccessIterator middle,
+                      RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        partial_sort(first, middle, last, less<value_type>{});
+    }
+
+    template<class RandomAccessIterator, class Compare>
+    void partial_sort(RandomAccessIterator first,
+                      RandomAccessIterator middle,
+                      RandomAccessIterator last, Compare comp)
+    {
+        aux::heap_select_sort(first, middle, last, comp);
+    }
 
     /**
      * 25.4.1.4, partial_sort_copy:
      */
 
-    // TODO: implement
+    template<class InputIterator, class RandomAccessIterator>
+    RandomAccessIterator partial_sort_copy(InputIterator first,
+                                           InputIterator last,
+                                           RandomAccessIterator result_first,
+                                           RandomAccessIterator result_last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        return partial_sort_copy(
+            first, last, result_first, result_last, less<value_type>{}
+        );
+    }
+
+    template<class InputIterator, class RandomAccessIterator, class Compare>
+    RandomAccessIterator partial_sort_copy(InputIterator first,
+                                           InputIterator last,
+                                           RandomAccessIterator result_first,
+                                           RandomAccessIterator result_last,
+                                           Compare comp)
+    {
+        auto result_it = result_first;
+        while (first != last && result_it != result_last)
+            *result_it++ = *first++;
+
+        ptrdiff_t count = result_it - result_first;
+        if (count == 0)
+            return result_it;
+
+        for (auto idx = count / 2; idx > 0; --idx)
+            aux::heap_sift_down(result_first, idx - 1, count, comp);
+
+        while (first != last)
+        {
+            if (comp(*first, *result_first))
+            {
+                *result_first = *first;
+                aux::heap_sift_down(result_first, ptrdiff_t{}, count, comp);
+            }
+            ++first;
+        }
+
+        for (auto remaining = count; remaining > 1; --remaining)
+        {
+            iter_swap(result_first, result_first + (remaining - 1));
+            aux::heap_sift_down(
+                result_first, ptrdiff_t{}, remaining - 1, comp
+            );
+        }
+
+        return result_it;
+    }
 
     /**
      * 25.4.1.5, is_sorted:
@@ -782,7 +1143,47 @@ namespace std
      * 25.4.2, nth_element:
      */
 
-    // TODO: implement
+    template<class RandomAccessIterator>
+    void nth_element(RandomAccessIterator first, RandomAccessIterator nth,
+                     RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        nth_element(first, nth, last, less<value_type>{});
+    }
+
+    template<class RandomAccessIterator, class Compare>
+    void nth_element(RandomAccessIterator first, RandomAccessIterator nth,
+                     RandomAccessIterator last, Compare comp)
+    {
+        if (first == last || nth == last)
+            return;
+
+        /**
+         * Introselect: partition like sort does but only keep
+         * the part containing nth, with the same heap fallback
+         * when the pivots keep being bad.
+         */
+        auto depth = aux::sort_depth_limit(last - first);
+        while (last - first > 3)
+        {
+            if (depth == 0)
+            {
+                aux::heap_select_sort(first, nth + 1, last, comp);
+
+                return;
+            }
+            --depth;
+
+            auto cut = aux::partition_pivot(first, last, comp);
+            if (cut <= nth)
+                first = cut;
+            else
+                last = cut;
+        }
+
+        aux::insertion_sort(first, last, comp);
+    }
 
     /**
      * 25.4.3, binary search:
@@ -875,42 +1276,6 @@ namespace std
         {
             return 2 * idx + 2;
         }
-
-        template<class RandomAccessIterator, class Size, class Compare>
-        void correct_children(RandomAccessIterator first,
-                              Size idx, Size count, Compare comp)
-        {
-            using aux::heap_left_child;
-            using aux::heap_right_child;
-
-            auto left = heap_left_child(idx);
-            auto right = heap_right_child(idx);
-
-            bool left_incorrect{comp(first[idx], first[left])};
-            bool right_incorrect{comp(first[idx], first[right])};
-            while ((left < count && left_incorrect) ||
-                   (right < count && right_incorrect))
-            {
-                if (right >= count || (left_incorrect && comp(first[right], first[left])))
-                {
-                    swap(first[idx], first[left]);
-
-                    idx = left;
-                }
-                else if (right < count && right_incorrect)
-                {
-                    swap(first[idx], first[right]);
-
-                    idx = right;
-                } // Else should not happen because of the while condition.
-
-                left = heap_left_child(idx);
-                right = heap_right_child(idx);
-
-                left_incorrect = comp(first[idx], first[left]);
-                right_incorrect = comp(first[idx], first[right]);
-            }
-        }
     }
 
     /**
@@ -971,7 +1336,7 @@ namespace std
             return;
 
         swap(first[0], first[count - 1]);
-        aux::correct_children(first, decltype(count){}, count - 2, comp);
+        aux::heap_sift_down(first, ptrdiff_t{}, count - 1, comp);
     }
 
     /**
@@ -996,12 +1361,8 @@ namespace std
         if (count <= 1)
             return;
 
-        for (auto i = count; i > 0; --i)
-        {
-            auto idx = i - 1;
-
-            aux::correct_children(first, idx, count, comp);
-        }
+        for (auto idx = count / 2; idx > 0; --idx)
+            aux::heap_sift_down(first, idx - 1, count, comp);
     }
 
     /**
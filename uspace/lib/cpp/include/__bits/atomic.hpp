@@ -29,6 +29,689 @@
 #ifndef LIBCPP_BITS_ATOMIC
 #define LIBCPP_BITS_ATOMIC
 
-#error "<atomic> is not implemented"
+#include <__bits/thread/futex.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace std
+{
+    /**
+     * 29.3, order and consistency:
+     */
+
+    enum memory_order
+    {
+        memory_order_relaxed = __ATOMIC_RELAXED,
+        memory_order_consume = __ATOMIC_CONSUME,
+        memory_order_acquire = __ATOMIC_ACQUIRE,
+        memory_order_release = __ATOMIC_RELEASE,
+        memory_order_acq_rel = __ATOMIC_ACQ_REL,
+        memory_order_seq_cst = __ATOMIC_SEQ_CST
+    };
+
+    template<class T>
+    T kill_dependency(T y) noexcept
+    {
+        return y;
+    }
+
+    /**
+     * 29.4, lock-free property:
+     */
+
+#define ATOMIC_BOOL_LOCK_FREE     __GCC_ATOMIC_BOOL_LOCK_FREE
+#define ATOMIC_CHAR_LOCK_FREE     __GCC_ATOMIC_CHAR_LOCK_FREE
+#define ATOMIC_CHAR16_T_LOCK_FREE __GCC_ATOMIC_CHAR16_T_LOCK_FREE
+#define ATOMIC_CHAR32_T_LOCK_FREE __GCC_ATOMIC_CHAR32_T_LOCK_FREE
+#define ATOMIC_WCHAR_T_LOCK_FREE  __GCC_ATOMIC_WCHAR_T_LOCK_FREE
+#define ATOMIC_SHORT_LOCK_FREE    __GCC_ATOMIC_SHORT_LOCK_FREE
+#define ATOMIC_INT_LOCK_FREE      __GCC_ATOMIC_INT_LOCK_FREE
+#define ATOMIC_LONG_LOCK_FREE     __GCC_ATOMIC_LONG_LOCK_FREE
+#define ATOMIC_LLONG_LOCK_FREE    __GCC_ATOMIC_LLONG_LOCK_FREE
+#define ATOMIC_POINTER_LOCK_FREE  __GCC_ATOMIC_POINTER_LOCK_FREE
+
+#define ATOMIC_VAR_INIT(value) { value }
+#define ATOMIC_FLAG_INIT { false }
+
+    namespace aux
+    {
+        constexpr memory_order failure_order(memory_order mo)
+        {
+            if (mo == memory_order_acq_rel)
+                return memory_order_acquire;
+            else if (mo == memory_order_release)
+                return memory_order_relaxed;
+            else
+                return mo;
+        }
+
+        /**
+         * Note: Objects whose size is a power of two are aligned
+         *       to their size, so that the builtins can use
+         *       the native instructions for them.
+         */
+        template<class T>
+        inline constexpr size_t atomic_alignment_v =
+            (sizeof(T) & (sizeof(T) - 1)) == 0 && sizeof(T) > alignof(T) &&
+            sizeof(T) <= 16 ? sizeof(T) : alignof(T);
+
+        template<class T>
+        bool atomic_same_value(const T& lhs, const T& rhs)
+        {
+            return __builtin_memcmp(&lhs, &rhs, sizeof(T)) == 0;
+        }
+
+        /**
+         * Note: Waiting fibrils park on the address of the atomic
+         *       (see futex.hpp), so a notify without any waiters
+         *       is just a load in libc.
+         */
+        template<class T>
+        void atomic_wait(const T* addr, T old, memory_order mo)
+        {
+            while (true)
+            {
+                T current;
+                __atomic_load(addr, &current, mo);
+                if (!atomic_same_value(current, old))
+                    return;
+
+                park(addr, [addr, &old]{
+                    T current;
+                    __atomic_load(addr, &current, __ATOMIC_RELAXED);
+
+                    return atomic_same_value(current, old);
+                });
+            }
+        }
+
+        /**
+         * Note: The volatile overloads required by the standard
+         *       are not provided.
+         */
+        template<class T>
+        class atomic_base
+        {
+            public:
+                using value_type = T;
+
+                atomic_base() noexcept = default;
+
+                constexpr atomic_base(T desired) noexcept
+                    : value_{desired}
+                { /* DUMMY BODY */ }
+
+                atomic_base(const atomic_base&) = delete;
+                atomic_base& operator=(const atomic_base&) = delete;
+
+                static constexpr bool is_always_lock_free =
+                    __atomic_always_lock_free(sizeof(T), 0);
+
+                bool is_lock_free() const noexcept
+                {
+                    return is_always_lock_free;
+                }
+
+                void store(T desired, memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    __atomic_store(&value_, &desired, mo);
+                }
+
+                T load(memory_order mo = memory_order_seq_cst) const noexcept
+                {
+                    T res;
+                    __atomic_load(&value_, &res, mo);
+
+                    return res;
+                }
+
+                operator T() const noexcept
+                {
+                    return load();
+                }
+
+                T exchange(T desired, memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    T res;
+                    __atomic_exchange(&value_, &desired, &res, mo);
+
+                    return res;
+                }
+
+                bool compare_exchange_weak(T& expected, T desired,
+                                           memory_order success,
+                                           memory_order failure) noexcept
+                {
+                    return __atomic_compare_exchange(
+                        &value_, &expected, &desired, true, success, failure
+                    );
+                }
+
+                bool compare_exchange_weak(T& expected, T desired,
+                                           memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    return compare_exchange_weak(
+                        expected, desired, mo, failure_order(mo)
+                    );
+                }
+
+                bool compare_exchange_strong(T& expected, T desired,
+                                             memory_order success,
+                                             memory_order failure) noexcept
+                {
+                    return __atomic_compare_exchange(
+                        &value_, &expected, &desired, false, success, failure
+                    );
+                }
+
+                bool compare_exchange_strong(T& expected, T desired,
+                                             memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    return compare_exchange_strong(
+                        expected, desired, mo, failure_order(mo)
+                    );
+                }
+
+                /**
+                 * Note: Waiting and notification are C++20 additions,
+                 *       they are provided as an extension.
+                 */
+
+                void wait(T old, memory_order mo = memory_order_seq_cst) const noexcept
+                {
+                    atomic_wait(&value_, old, mo);
+                }
+
+                void notify_one() noexcept
+                {
+                    unpark(&value_, 1);
+                }
+
+                void notify_all() noexcept
+                {
+                    unpark_all(&value_);
+                }
+
+            protected:
+                alignas(atomic_alignment_v<T>) T value_;
+        };
+
+        template<class T>
+        class atomic_integral: public atomic_base<T>
+        {
+            public:
+                using difference_type = T;
+
+                using atomic_base<T>::atomic_base;
+
+                T fetch_add(T arg, memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    return __atomic_fetch_add(&this->value_, arg, mo);
+                }
+
+                T fetch_sub(T arg, memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    return __atomic_fetch_sub(&this->value_, arg, mo);
+                }
+
+                T fetch_and(T arg, memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    return __atomic_fetch_and(&this->value_, arg, mo);
+                }
+
+                T fetch_or(T arg, memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    return __atomic_fetch_or(&this->value_, arg, mo);
+                }
+
+                T fetch_xor(T arg, memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    return __atomic_fetch_xor(&this->value_, arg, mo);
+                }
+
+                T operator++(int) noexcept
+                {
+                    return fetch_add(1);
+                }
+
+                T operator--(int) noexcept
+                {
+                    return fetch_sub(1);
+                }
+
+                T operator++() noexcept
+                {
+                    return __atomic_add_fetch(&this->value_, 1, __ATOMIC_SEQ_CST);
+                }
+
+                T operator--() noexcept
+                {
+                    return __atomic_sub_fetch(&this->value_, 1, __ATOMIC_SEQ_CST);
+                }
+
+                T operator+=(T arg) noexcept
+                {
+                    return __atomic_add_fetch(&this->value_, arg, __ATOMIC_SEQ_CST);
+                }
+
+                T operator-=(T arg) noexcept
+                {
+                    return __atomic_sub_fetch(&this->value_, arg, __ATOMIC_SEQ_CST);
+                }
+
+                T operator&=(T arg) noexcept
+                {
+                    return __atomic_and_fetch(&this->value_, arg, __ATOMIC_SEQ_CST);
+                }
+
+                T operator|=(T arg) noexcept
+                {
+                    return __atomic_or_fetch(&this->value_, arg, __ATOMIC_SEQ_CST);
+                }
+
+                T operator^=(T arg) noexcept
+                {
+                    return __atomic_xor_fetch(&this->value_, arg, __ATOMIC_SEQ_CST);
+                }
+        };
+
+        /**
+         * Note: The builtins do not scale the operand
+         *       of pointer arithmetic by the size of the pointee.
+         */
+        template<class T>
+        class atomic_pointer: public atomic_base<T*>
+        {
+            public:
+                using difference_type = ptrdiff_t;
+
+                using atomic_base<T*>::atomic_base;
+
+                T* fetch_add(ptrdiff_t arg, memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    return __atomic_fetch_add(&this->value_, arg * sizeof(T), mo);
+                }
+
+                T* fetch_sub(ptrdiff_t arg, memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    return __atomic_fetch_sub(&this->value_, arg * sizeof(T), mo);
+                }
+
+                T* operator++(int) noexcept
+                {
+                    return fetch_add(1);
+                }
+
+                T* operator--(int) noexcept
+                {
+                    return fetch_sub(1);
+                }
+
+                T* operator++() noexcept
+                {
+                    return fetch_add(1) + 1;
+                }
+
+                T* operator--() noexcept
+                {
+                    return fetch_sub(1) - 1;
+                }
+
+                T* operator+=(ptrdiff_t arg) noexcept
+                {
+                    return fetch_add(arg) + arg;
+                }
+
+                T* operator-=(ptrdiff_t arg) noexcept
+                {
+                    return fetch_sub(arg) - arg;
+                }
+        };
+
+        template<class T>
+        using atomic_base_for_t = conditional_t<
+            is_integral<T>::value && !is_same<remove_cv_t<T>, bool>::value,
+            atomic_integral<T>, atomic_base<T>
+        >;
+    }
+
+    /**
+     * 29.5, atomic types:
+     */
+
+    template<class T>
+    struct atomic: aux::atomic_base_for_t<T>
+    {
+        atomic() noexcept = default;
+
+        constexpr atomic(T desired) noexcept
+            : aux::atomic_base_for_t<T>{desired}
+        { /* DUMMY BODY */ }
+
+        atomic(const atomic&) = delete;
+        atomic& operator=(const atomic&) = delete;
+
+        T operator=(T desired) noexcept
+        {
+            this->store(desired);
+
+            return desired;
+        }
+    };
+
+    template<class T>
+    struct atomic<T*>: aux::atomic_pointer<T>
+    {
+        atomic() noexcept = default;
+
+        constexpr atomic(T* desired) noexcept
+            : aux::atomic_pointer<T>{desired}
+        { /* DUMMY BODY */ }
+
+        atomic(const atomic&) = delete;
+        atomic& operator=(const atomic&) = delete;
+
+        T* operator=(T* desired) noexcept
+        {
+            this->store(desired);
+
+            return desired;
+        }
+    };
+
+    using atomic_bool           = atomic<bool>;
+    using atomic_char           = atomic<char>;
+    using atomic_schar          = atomic<signed char>;
+    using atomic_uchar          = atomic<unsigned char>;
+    using atomic_short          = atomic<short>;
+    using atomic_ushort         = atomic<unsigned short>;
+    using atomic_int            = atomic<int>;
+    using atomic_uint           = atomic<unsigned int>;
+    using atomic_long           = atomic<long>;
+    using atomic_ulong          = atomic<unsigned long>;
+    using atomic_llong          = atomic<long long>;
+    using atomic_ullong         = atomic<unsigned long long>;
+    using atomic_char16_t       = atomic<char16_t>;
+    using atomic_char32_t       = atomic<char32_t>;
+    using atomic_wchar_t        = atomic<wchar_t>;
+
+    using atomic_int8_t         = atomic<int8_t>;
+    using atomic_uint8_t        = atomic<uint8_t>;
+    using atomic_int16_t        = atomic<int16_t>;
+    using atomic_uint16_t       = atomic<uint16_t>;
+    using atomic_int32_t        = atomic<int32_t>;
+    using atomic_uint32_t       = atomic<uint32_t>;
+    using atomic_int64_t        = atomic<int64_t>;
+    using atomic_uint64_t       = atomic<uint64_t>;
+
+    using atomic_int_least8_t   = atomic<int_least8_t>;
+    using atomic_uint_least8_t  = atomic<uint_least8_t>;
+    using atomic_int_least16_t  = atomic<int_least16_t>;
+    using atomic_uint_least16_t = atomic<uint_least16_t>;
+    using atomic_int_least32_t  = atomic<int_least32_t>;
+    using atomic_uint_least32_t = atomic<uint_least32_t>;
+    using atomic_int_least64_t  = atomic<int_least64_t>;
+    using atomic_uint_least64_t = atomic<uint_least64_t>;
+
+    using atomic_int_fast8_t    = atomic<int_fast8_t>;
+    using atomic_uint_fast8_t   = atomic<uint_fast8_t>;
+    using atomic_int_fast16_t   = atomic<int_fast16_t>;
+    using atomic_uint_fast16_t  = atomic<uint_fast16_t>;
+    using atomic_int_fast32_t   = atomic<int_fast32_t>;
+    using atomic_uint_fast32_t  = atomic<uint_fast32_t>;
+    using atomic_int_fast64_t   = atomic<int_fast64_t>;
+    using atomic_uint_fast64_t  = atomic<uint_fast64_t>;
+
+    using atomic_intptr_t       = atomic<intptr_t>;
+    using atomic_uintptr_t      = atomic<uintptr_t>;
+    using atomic_size_t         = atomic<size_t>;
+    using atomic_ptrdiff_t      = atomic<ptrdiff_t>;
+    using atomic_intmax_t       = atomic<intmax_t>;
+    using atomic_uintmax_t      = atomic<uintmax_t>;
+
+    /**
+     * 29.6, operations on atomic types:
+     */
+
+    template<class T>
+    bool atomic_is_lock_free(const atomic<T>* obj) noexcept
+    {
+        return obj->is_lock_free();
+    }
+
+    template<class T>
+    void atomic_init(atomic<T>* obj, T desired) noexcept
+    {
+        obj->store(desired, memory_order_relaxed);
+    }
+
+    template<class T>
+    void atomic_store(atomic<T>* obj, T desired) noexcept
+    {
+        obj->store(desired);
+    }
+
+    template<class T>
+    void atomic_store_explicit(atomic<T>* obj, T desired, memory_order mo) noexcept
+    {
+        obj->store(desired, mo);
+    }
+
+    template<class T>
+    T atomic_load(const atomic<T>* obj) noexcept
+    {
+        return obj->load();
+    }
+
+    template<class T>
+    T atomic_load_explicit(const atomic<T>* obj, memory_order mo) noexcept
+    {
+        return obj->load(mo);
+    }
+
+    template<class T>
+    T atomic_exchange(atomic<T>* obj, T desired) noexcept
+    {
+        return obj->exchange(desired);
+    }
+
+    template<class T>
+    T atomic_exchange_explicit(atomic<T>* obj, T desired, memory_order mo) noexcept
+    {
+        return obj->exchange(desired, mo);
+    }
+
+    template<class T>
+    bool atomic_compare_exchange_weak(atomic<T>* obj, T* expected, T desired) noexcept
+    {
+        return obj->compare_exchange_weak(*expected, desired);
+    }
+
+    template<class T>
+    bool atomic_compare_exchange_weak_explicit(atomic<T>* obj, T* expected, T desired,
+                                               memory_order success,
+                                               memory_order failure) noexcept
+    {
+        return obj->compare_exchange_weak(*expected, desired, success, failure);
+    }
+
+    template<class T>
+    bool atomic_compare_exchange_strong(atomic<T>* obj, T* expected, T desired) noexcept
+    {
+        return obj->compare_exchange_strong(*expected, desired);
+    }
+
+    template<class T>
+    bool atomic_compare_exchange_strong_explicit(atomic<T>* obj, T* expected, T desired,
+                                                 memory_order success,
+                                                 memory_order failure) noexcept
+    {
+        return obj->compare_exchange_strong(*expected, desired, success, failure);
+    }
+
+    template<class T>
+    T atomic_fetch_add(atomic<T>* obj, typename atomic<T>::difference_type arg) noexcept
+    {
+        return obj->fetch_add(arg);
+    }
+
+    template<class T>
+    T atomic_fetch_add_explicit(atomic<T>* obj, typename atomic<T>::difference_type arg,
+                                memory_order mo) noexcept
+    {
+        return obj->fetch_add(arg, mo);
+    }
+
+    template<class T>
+    T atomic_fetch_sub(atomic<T>* obj, typename atomic<T>::difference_type arg) noexcept
+    {
+        return obj->fetch_sub(arg);
+    }
+
+    template<class T>
+    T atomic_fetch_sub_explicit(atomic<T>* obj, typename atomic<T>::difference_type arg,
+                                memory_order mo) noexcept
+    {
+        return obj->fetch_sub(arg, mo);
+    }
+
+    template<class T>
+    T atomic_fetch_and(atomic<T>* obj, T arg) noexcept
+    {
+        return obj->fetch_and(arg);
+    }
+
+    template<class T>
+    T atomic_fetch_and_explicit(atomic<T>* obj, T arg, memory_order mo) noexcept
+    {
+        return obj->fetch_and(arg, mo);
+    }
+
+    template<class T>
+    T atomic_fetch_or(atomic<T>* obj, T arg) noexcept
+    {
+        return obj->fetch_or(arg);
+    }
+
+    template<class T>
+    T atomic_fetch_or_explicit(atomic<T>* obj, T arg, memory_order mo) noexcept
+    {
+        return obj->fetch_or(arg, mo);
+    }
+
+    template<class T>
+    T atomic_fetch_xor(atomic<T>* obj, T arg) noexcept
+    {
+        return obj->fetch_xor(arg);
+    }
+
+    template<class T>
+    T atomic_fetch_xor_explicit(atomic<T>* obj, T arg, memory_order mo) noexcept
+    {
+        return obj->fetch_xor(arg, mo);
+    }
+
+    template<class T>
+    void atomic_wait(const atomic<T>* obj, T old) noexcept
+    {
+        obj->wait(old);
+    }
+
+    template<class T>
+    void atomic_wait_explicit(const atomic<T>* obj, T old, memory_order mo) noexcept
+    {
+        obj->wait(old, mo);
+    }
+
+    template<class T>
+    void atomic_notify_one(atomic<T>* obj) noexcept
+    {
+        obj->notify_one();
+    }
+
+    template<class T>
+    void atomic_notify_all(atomic<T>* obj) noexcept
+    {
+        obj->notify_all();
+    }
+
+    /**
+     * 29.7, flag type and operations:
+     */
+
+    struct atomic_flag
+    {
+        atomic_flag() noexcept = default;
+        atomic_flag(const atomic_flag&) = delete;
+        atomic_flag& operator=(const atomic_flag&) = delete;
+
+        bool test_and_set(memory_order mo = memory_order_seq_cst) noexcept
+        {
+            return __atomic_test_and_set(&value_, mo);
+        }
+
+        void clear(memory_order mo = memory_order_seq_cst) noexcept
+        {
+            __atomic_clear(&value_, mo);
+        }
+
+        bool test(memory_order mo = memory_order_seq_cst) const noexcept
+        {
+            return __atomic_load_n(&value_, mo);
+        }
+
+        void wait(bool old, memory_order mo = memory_order_seq_cst) const noexcept
+        {
+            aux::atomic_wait(&value_, old, mo);
+        }
+
+        void notify_one() noexcept
+        {
+            aux::unpark(&value_, 1);
+        }
+
+        void notify_all() noexcept
+        {
+            aux::unpark_all(&value_);
+        }
+
+        bool value_;
+    };
+
+    inline bool atomic_flag_test_and_set(atomic_flag* obj) noexcept
+    {
+        return obj->test_and_set();
+    }
+
+    inline bool atomic_flag_test_and_set_explicit(atomic_flag* obj, memory_order mo) noexcept
+    {
+        return obj->test_and_set(mo);
+    }
+
+    inline void atomic_flag_clear(atomic_flag* obj) noexcept
+    {
+        obj->clear();
+    }
+
+    inline void atomic_flag_clear_explicit(atomic_flag* obj, memory_order mo) noexcept
+    {
+        obj->clear(mo);
+    }
+
+    /**
+     * 29.8, fences:
+     */
+
+    inline void atomic_thread_fence(memory_order mo) noexcept
+    {
+        __atomic_thread_fence(mo);
+    }
+
+    inline void atomic_signal_fence(memory_order mo) noexcept
+    {
+        __atomic_signal_fence(mo);
+    }
+}
 
 #endif
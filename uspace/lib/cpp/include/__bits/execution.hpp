@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_EXECUTION
+#define LIBCPP_BITS_EXECUTION
+
+#include <__bits/algorithm.hpp>
+#include <__bits/thread/executor.hpp>
+#include <__bits/thread/threading.hpp>
+#include <iterator>
+#include <type_traits>
+
+namespace std
+{
+    /**
+     * 20.19, execution policies:
+     */
+
+    namespace execution
+    {
+        class sequenced_policy
+        { /* DUMMY BODY */ };
+
+        class parallel_policy
+        { /* DUMMY BODY */ };
+
+        class parallel_unsequenced_policy
+        { /* DUMMY BODY */ };
+
+        inline constexpr sequenced_policy seq{};
+        inline constexpr parallel_policy par{};
+        inline constexpr parallel_unsequenced_policy par_unseq{};
+    }
+
+    template<class T>
+    struct is_execution_policy: false_type
+    { /* DUMMY BODY */ };
+
+    template<>
+    struct is_execution_policy<execution::sequenced_policy>: true_type
+    { /* DUMMY BODY */ };
+
+    template<>
+    struct is_execution_policy<execution::parallel_policy>: true_type
+    { /* DUMMY BODY */ };
+
+    template<>
+    struct is_execution_policy<execution::parallel_unsequenced_policy>: true_type
+    { /* DUMMY BODY */ };
+
+    template<class T>
+    inline constexpr bool is_execution_policy_v = is_execution_policy<T>::value;
+
+    namespace aux
+    {
+        template<class ExecutionPolicy, class... Iterators>
+        inline constexpr bool runs_in_parallel_v =
+            !is_same_v<decay_t<ExecutionPolicy>, execution::sequenced_policy> &&
+            (is_base_of_v<
+                random_access_iterator_tag,
+                typename iterator_traits<Iterators>::iterator_category
+             > && ...);
+
+        /**
+         * Counts down finished parts of a parallel algorithm.
+         */
+        class task_latch
+        {
+            public:
+                task_latch(size_t count)
+                    : mtx_{}, cv_{}, count_{count}
+                {
+                    threading::mutex::init(mtx_);
+                    threading::condvar::init(cv_);
+                }
+
+                void count_down()
+                {
+                    /**
+                     * Note: The waiter may destroy the latch
+                     *       as soon as we unlock it.
+                     */
+                    threading::mutex::lock(mtx_);
+                    if (--count_ == 0)
+                        threading::condvar::broadcast(cv_);
+                    threading::mutex::unlock(mtx_);
+                }
+
+                void wait(executor& exec)
+                {
+                    threading::mutex::lock(mtx_);
+                    while (count_ > 0)
+                    {
+                        threading::mutex::unlock(mtx_);
+                        auto helped = exec.run_one();
+                        threading::mutex::lock(mtx_);
+
+                        if (!helped && count_ > 0)
+                            threading::condvar::wait(cv_, mtx_);
+                    }
+                    threading::mutex::unlock(mtx_);
+                }
+
+            private:
+                mutex_t mtx_;
+                condvar_t cv_;
+                size_t count_;
+        };
+
+        /**
+         * Minimal number of elements per task, smaller
+         * ranges are not worth the overhead of a task.
+         */
+        inline constexpr ptrdiff_t parallel_grain{1024};
+
+        /**
+         * Splits [0, count) into parts for the executor and calls
+         * func(from, to) for each of them. The calling fibril
+         * processes the first part itself and then helps with
+         * the rest until all parts are done.
+         */
+        template<class Function>
+        void parallel_for(ptrdiff_t count, Function func)
+        {
+            auto& exec = executor::instance();
+
+            auto parts = static_cast<ptrdiff_t>(exec.worker_count() * 4);
+            if (parts > count / parallel_grain)
+                parts = count / parallel_grain;
+
+            if (parts <= 1)
+            {
+                if (count > 0)
+                    func(ptrdiff_t{}, count);
+                return;
+            }
+
+            auto part_size = count / parts;
+            task_latch latch{static_cast<size_t>(parts - 1)};
+
+            for (ptrdiff_t i = 1; i < parts; ++i)
+            {
+                auto from = i * part_size;
+                auto to = (i == parts - 1) ? count : from + part_size;
+
+                exec.submit_callable([&func, &latch, from, to](){
+                    func(from, to);
+                    latch.count_down();
+                });
+            }
+
+            func(ptrdiff_t{}, part_size);
+            latch.wait(exec);
+        }
+    }
+
+    /**
+     * 25.2.4, for_each:
+     * Note: The parallel overloads only split random access
+     *       ranges, other ranges are processed sequentially.
+     */
+
+    template<class ExecutionPolicy, class ForwardIterator, class Function>
+    enable_if_t<is_execution_policy_v<decay_t<ExecutionPolicy>>>
+    for_each(ExecutionPolicy&&, ForwardIterator first,
+             ForwardIterator last, Function f)
+    {
+        if constexpr (aux::runs_in_parallel_v<ExecutionPolicy, ForwardIterator>)
+        {
+            aux::parallel_for(last - first, [&](auto from, auto to){
+                for_each(first + from, first + to, f);
+            });
+        }
+        else
+            for_each(first, last, f);
+    }
+
+    /**
+     * 25.3.4, transform:
+     */
+
+    template<class ExecutionPolicy, class ForwardIterator1,
+             class ForwardIterator2, class UnaryOperation>
+    enable_if_t<
+        is_execution_policy_v<decay_t<ExecutionPolicy>>, ForwardIterator2
+    >
+    transform(ExecutionPolicy&&, ForwardIterator1 first,
+              ForwardIterator1 last, ForwardIterator2 result,
+              UnaryOperation op)
+    {
+        if constexpr (aux::runs_in_parallel_v<
+            ExecutionPolicy, ForwardIterator1, ForwardIterator2
+        >)
+        {
+            auto count = last - first;
+            aux::parallel_for(count, [&](auto from, auto to){
+                transform(first + from, first + to, result + from, op);
+            });
+
+            return result + count;
+        }
+        else
+            return transform(first, last, result, op);
+    }
+
+    template<class ExecutionPolicy, class ForwardIterator1,
+             class ForwardIterator2, class ForwardIterator3,
+             class BinaryOperation>
+    enable_if_t<
+        is_execution_policy_v<decay_t<ExecutionPolicy>>, ForwardIterator3
+    >
+    transform(ExecutionPolicy&&, ForwardIterator1 first1,
+              ForwardIterator1 last1, ForwardIterator2 first2,
+              ForwardIterator3 result, BinaryOperation op)
+    {
+        if constexpr (aux::runs_in_parallel_v<
+            ExecutionPolicy, ForwardIterator1,
+            ForwardIterator2, ForwardIterator3
+        >)
+        {
+            auto count = last1 - first1;
+            aux::parallel_for(count, [&](auto from, auto to){
+                transform(
+                    first1 + from, first1 + to,
+                    first2 + from, result + from, op
+                );
+            });
+
+            return result + count;
+        }
+        else
+            return transform(first1, last1, first2, result, op);
+    }
+}
+
+#endif
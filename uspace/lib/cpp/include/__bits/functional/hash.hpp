@@ -75,7 +75,13 @@ namespace std
             static_assert(is_arithmetic<T>::value || is_pointer<T>::value,
                           "invalid type passed to aux::hash");
 
+            /**
+             * Note: The value may be narrower than the
+             *       converted integer, so the rest of it
+             *       has to be zeroed first.
+             */
             converter<T> conv;
+            conv.converted = 0;
             conv.value = x;
 
             return hash_<size_t>(conv.converted);
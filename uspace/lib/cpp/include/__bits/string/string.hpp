@@ -469,8 +469,8 @@ namespace std
                 : basic_string(allocator_type{})
             { /* DUMMY BODY */ }
 
-            explicit basic_string(const allocator_type& alloc)
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+            explicit basic_string(const allocator_type& alloc) noexcept
+                : data_{sso_}, size_{}, capacity_{sso_capacity_}, allocator_{alloc}
             {
                 /**
                  * Postconditions:
@@ -478,29 +478,26 @@ namespace std
                  *  size() = 0
                  *  capacity() = unspecified
                  */
-                data_ = allocator_.allocate(default_capacity_);
-                capacity_ = default_capacity_;
+                ensure_null_terminator_();
             }
 
             basic_string(const basic_string& other)
-                : data_{}, size_{other.size_}, capacity_{other.capacity_},
+                : data_{sso_}, size_{}, capacity_{sso_capacity_},
                   allocator_{other.allocator_}
             {
-                init_(other.data(), size_);
+                init_(other.data(), other.size_);
             }
 
-            basic_string(basic_string&& other)
-                : data_{other.data_}, size_{other.size_},
-                  capacity_{other.capacity_}, allocator_{move(other.allocator_)}
+            basic_string(basic_string&& other) noexcept
+                : data_{sso_}, size_{}, capacity_{sso_capacity_},
+                  allocator_{move(other.allocator_)}
             {
-                other.data_ = nullptr;
-                other.size_ = 0;
-                other.capacity_ = 0;
+                take_(other);
             }
 
             basic_string(const basic_string& other, size_type pos, size_type n = npos,
                          const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{sso_}, size_{}, capacity_{sso_capacity_}, allocator_{alloc}
             {
                 // TODO: if pos < other.size() throw out_of_range.
                 auto len = min(n, other.size() - pos);
@@ -508,21 +505,22 @@ namespace std
             }
 
             basic_string(const value_type* str, size_type n, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{n}, capacity_{n}, allocator_{alloc}
+                : data_{sso_}, size_{}, capacity_{sso_capacity_}, allocator_{alloc}
             {
-                init_(str, size_);
+                init_(str, n);
             }
 
             basic_string(const value_type* str, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{sso_}, size_{}, capacity_{sso_capacity_}, allocator_{alloc}
             {
                 init_(str, traits_type::length(str));
             }
 
             basic_string(size_type n, value_type c, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{n}, capacity_{n}, allocator_{alloc}
+                : data_{sso_}, size_{}, capacity_{sso_capacity_}, allocator_{alloc}
             {
-                data_ = allocator_.allocate(capacity_);
+                resize_without_copy_(n + 1);
+                size_ = n;
                 for (size_type i = 0; i < size_; ++i)
                     traits_type::assign(data_[i], c);
                 ensure_null_terminator_();
@@ -531,13 +529,12 @@ namespace std
             template<class InputIterator>
             basic_string(InputIterator first, InputIterator last,
                          const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{sso_}, size_{}, capacity_{sso_capacity_}, allocator_{alloc}
             {
                 if constexpr (is_integral<InputIterator>::value)
                 { // Required by the standard.
+                    resize_without_copy_(static_cast<size_type>(first) + 1);
                     size_ = static_cast<size_type>(first);
-                    capacity_ = size_;
-                    data_ = allocator_.allocate(capacity_);
 
                     for (size_type i = 0; i < size_; ++i)
                         traits_type::assign(data_[i], static_cast<value_type>(last));
@@ -555,22 +552,20 @@ namespace std
             { /* DUMMY BODY */ }
 
             basic_string(const basic_string& other, const allocator_type& alloc)
-                : data_{}, size_{other.size_}, capacity_{other.capacity_}, allocator_{alloc}
+                : data_{sso_}, size_{}, capacity_{sso_capacity_}, allocator_{alloc}
             {
-                init_(other.data(), size_);
+                init_(other.data(), other.size_);
             }
 
             basic_string(basic_string&& other, const allocator_type& alloc)
-                : data_{other.data_}, size_{other.size_}, capacity_{other.capacity_}, allocator_{alloc}
+                : data_{sso_}, size_{}, capacity_{sso_capacity_}, allocator_{alloc}
             {
-                other.data_ = nullptr;
-                other.size_ = 0;
-                other.capacity_ = 0;
+                take_(other);
             }
 
             ~basic_string()
             {
-                allocator_.deallocate(data_, capacity_);
+                release_();
             }
 
             basic_string& operator=(const basic_string& other)
@@ -589,7 +584,10 @@ namespace std
                          allocator_traits<allocator_type>::is_always_equal::value)
             {
                 if (this != &other)
-                    swap(other);
+                {
+                    release_();
+                    take_(other);
+                }
 
                 return *this;
             }
@@ -704,9 +702,9 @@ namespace std
                 // TODO: if new_size > max_size() throw length_error.
                 if (new_size > size_)
                 {
-                    ensure_free_space_(new_size - size_ + 1);
+                    ensure_free_space_(new_size - size_);
                     for (size_type i = size_; i < new_size; ++i)
-                        traits_type::assign(data_[i], i);
+                        traits_type::assign(data_[i], c);
                 }
 
                 size_ = new_size;
@@ -728,16 +726,34 @@ namespace std
                 // TODO: if new_capacity > max_size() throw
                 //       length_error (this function shall have no
                 //       effect in such case)
-                if (new_capacity > capacity_)
-                    resize_with_copy_(size_, new_capacity);
-                else if (new_capacity < capacity_)
-                    shrink_to_fit(); // Non-binding request, but why not.
+
+                /**
+                 * Note: Shrinking is a non-binding request, we
+                 *       ignore it so that reserving before a series
+                 *       of appends never costs a reallocation.
+                 */
+                if (new_capacity + 1 > capacity_)
+                    resize_with_copy_(size_, new_capacity + 1);
             }
 
             void shrink_to_fit()
             {
-                if (size_ != capacity_)
-                    resize_with_copy_(size_, capacity_);
+                if (is_sso_() || size_ + 1 == capacity_)
+                    return;
+
+                value_type* new_data{sso_};
+                size_type new_capacity{sso_capacity_};
+                if (size_ + 1 > sso_capacity_)
+                {
+                    new_capacity = size_ + 1;
+                    new_data = allocator_.allocate(new_capacity);
+                }
+
+                traits_type::copy(new_data, data_, size_ + 1);
+                allocator_.deallocate(data_, capacity_);
+
+                data_ = new_data;
+                capacity_ = new_capacity;
             }
 
             void clear() noexcept
@@ -907,8 +923,8 @@ namespace std
             basic_string& assign(const value_type* str, size_type n)
             {
                 // TODO: if (n > max_size()) throw length_error.
-                resize_without_copy_(n);
-                traits_type::copy(begin(), str, n);
+                resize_without_copy_(n + 1);
+                traits_type::move(begin(), str, n);
                 size_ = n;
                 ensure_null_terminator_();
 
@@ -1083,7 +1099,7 @@ namespace std
                 auto len = min(n1, size_ - pos);
 
                 basic_string tmp{};
-                tmp.resize_without_copy_(size_ - len + n2);
+                tmp.resize_without_copy_(size_ - len + n2 + 1);
 
                 // Prefix.
                 copy_(begin(), begin() + pos, tmp.begin());
@@ -1095,6 +1111,7 @@ namespace std
                 copy_(begin() + pos + len, end(), tmp.begin() + pos + n2);
 
                 tmp.size_ = size_ - len + n2;
+                tmp.ensure_null_terminator_();
                 swap(tmp);
                 return *this;
             }
@@ -1160,9 +1177,19 @@ namespace std
                 noexcept(allocator_traits<allocator_type>::propagate_on_container_swap::value ||
                          allocator_traits<allocator_type>::is_always_equal::value)
             {
-                std::swap(data_, other.data_);
-                std::swap(size_, other.size_);
-                std::swap(capacity_, other.capacity_);
+                if (!is_sso_() && !other.is_sso_())
+                {
+                    std::swap(data_, other.data_);
+                    std::swap(size_, other.size_);
+                    std::swap(capacity_, other.capacity_);
+
+                    return;
+                }
+
+                // Inline buffers cannot be swapped by pointers.
+                basic_string tmp{move(other)};
+                other.take_(*this);
+                take_(tmp);
             }
 
             /**
@@ -1476,31 +1503,66 @@ namespace std
             }
 
         private:
+            /**
+             * Short strings are stored in an inline buffer
+             * (data_ then points to sso_) so that they never
+             * touch the heap. The capacity is in characters
+             * including the null terminator and never drops
+             * below the size of the inline buffer.
+             */
+            static constexpr size_type sso_capacity_{
+                max(size_type{16u} / sizeof(value_type), size_type{4u})
+            };
+
             value_type* data_;
             size_type size_;
             size_type capacity_;
             allocator_type allocator_;
+            value_type sso_[sso_capacity_];
 
             template<class C, class T, class A>
             friend class basic_stringbuf;
 
+            bool is_sso_() const noexcept
+            {
+                return data_ == sso_;
+            }
+
+            void release_() noexcept
+            {
+                if (!is_sso_())
+                    allocator_.deallocate(data_, capacity_);
+
+                data_ = sso_;
+                capacity_ = sso_capacity_;
+            }
+
             /**
-             * Arbitrary value, standard just requires
-             * data() to have some capacity.
-             * (Well, we could've done data_ = &data_ and
-             * set capacity to 0, but that would be too cryptic.)
+             * Steals the contents of other, which has to be
+             * left empty. Our storage must have been released.
              */
-            static constexpr size_type default_capacity_{4};
+            void take_(basic_string& other) noexcept
+            {
+                if (other.is_sso_())
+                    traits_type::copy(sso_, other.sso_, other.size_ + 1);
+                else
+                {
+                    data_ = other.data_;
+                    capacity_ = other.capacity_;
+                }
+                size_ = other.size_;
+
+                other.data_ = other.sso_;
+                other.capacity_ = sso_capacity_;
+                other.size_ = 0;
+                other.ensure_null_terminator_();
+            }
 
             void init_(const value_type* str, size_type size)
             {
-                if (data_)
-                    allocator_.deallocate(data_, capacity_);
+                resize_without_copy_(size + 1);
 
                 size_ = size;
-                capacity_ = size + 1;
-
-                data_ = allocator_.allocate(capacity_);
                 traits_type::copy(data_, str, size);
                 ensure_null_terminator_();
             }
@@ -1515,41 +1577,44 @@ namespace std
 
             void ensure_free_space_(size_type n)
             {
-                /**
-                 * Note: We cannot use reserve like we
-                 *       did in vector, because in string
-                 *       reserve can cause shrinking.
-                 */
+                // Geometric growth keeps repeated appends amortized O(1).
                 if (size_ + 1 + n > capacity_)
                     resize_with_copy_(size_, max(size_ + 1 + n, next_capacity_()));
             }
 
+            /**
+             * Makes room for at least capacity characters
+             * (including the terminator), the contents are lost.
+             */
             void resize_without_copy_(size_type capacity)
             {
-                if (data_)
-                    allocator_.deallocate(data_, capacity_);
+                if (capacity > capacity_)
+                {
+                    release_();
+
+                    data_ = allocator_.allocate(capacity);
+                    capacity_ = capacity;
+                }
 
-                data_ = allocator_.allocate(capacity);
                 size_ = 0;
-                capacity_ = capacity;
                 ensure_null_terminator_();
             }
 
             void resize_with_copy_(size_type size, size_type capacity)
             {
-                if(capacity_ == 0 || capacity_ < capacity)
+                if (capacity_ < capacity)
                 {
                     auto new_data = allocator_.allocate(capacity);
 
                     auto to_copy = min(size, size_);
-                    traits_type::move(new_data, data_, to_copy);
+                    traits_type::copy(new_data, data_, to_copy);
 
-                    std::swap(data_, new_data);
+                    release_();
 
-                    allocator_.deallocate(new_data, capacity_);
+                    data_ = new_data;
+                    capacity_ = capacity;
                 }
 
-                capacity_ = capacity;
                 size_ = size;
                 ensure_null_terminator_();
             }
@@ -105,6 +105,7 @@ namespace std::test
             void test_construction_and_assignment();
             void test_insert();
             void test_erase();
+            void test_reallocation();
     };
 
     class string_test: public test_suite
@@ -123,6 +124,7 @@ namespace std::test
             void test_find();
             void test_substr();
             void test_compare();
+            void test_storage();
     };
 
     class bitset_test: public test_suite
@@ -205,6 +207,9 @@ namespace std::test
             void test_histogram();
             void test_emplace_insert();
             void test_multi();
+            void test_churn();
+            void test_flat();
+            void bench_maps();
     };
 
     class unordered_set_test: public test_suite
@@ -293,6 +298,22 @@ namespace std::test
         private:
             void test_non_modifying();
             void test_mutating();
+            void test_sorting();
+            void test_parallel();
+            void bench_sorting();
+    };
+
+    class atomic_test: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+        private:
+            void test_atomic();
+            void test_wait_notify();
+            void test_mutex();
+            void test_shared_mutex();
+            void test_condition_variable();
     };
 
     class future_test: public test_suite
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_THREAD_EXECUTOR
+#define LIBCPP_BITS_THREAD_EXECUTOR
+
+#include <__bits/thread/threading.hpp>
+#include <__bits/utility/forward_move.hpp>
+#include <cstdlib>
+#include <type_traits>
+
+namespace std::aux
+{
+    class executor_task
+    {
+        public:
+            virtual void run() = 0;
+
+            virtual ~executor_task() = default;
+
+        private:
+            /**
+             * Note: Tasks are linked directly into the queues
+             *       so that submitting one does not allocate.
+             */
+            executor_task* prev_{nullptr};
+            executor_task* next_{nullptr};
+
+            friend class executor;
+    };
+
+    template<class F>
+    class callable_task: public executor_task
+    {
+        public:
+            template<class G>
+            callable_task(G&& g)
+                : func_{forward<G>(g)}
+            { /* DUMMY BODY */ }
+
+            void run() override
+            {
+                func_();
+            }
+
+        private:
+            F func_;
+    };
+
+    /**
+     * Runs tasks on a fixed set of worker fibrils, one for each
+     * fibril runner (i.e. kernel thread) of the task, so that
+     * std::async does not need a new fibril and a stack per call
+     * and the work spreads over all processors.
+     * Each worker has its own queue, tasks submitted by a worker
+     * go to its queue and idle workers steal from the queues
+     * of the others.
+     */
+    class executor
+    {
+        public:
+            /**
+             * Note: The executor is created (and multithreading
+             *       enabled) on the first call and never destroyed,
+             *       its workers keep waiting for tasks until the
+             *       task exits.
+             */
+            static executor& instance();
+
+            /**
+             * Takes ownership of the task, which is deleted
+             * once it finishes.
+             */
+            void submit(executor_task* task);
+
+            template<class F>
+            void submit_callable(F&& f)
+            {
+                submit(new callable_task<decay_t<F>>{forward<F>(f)});
+            }
+
+            /**
+             * Runs one queued task in the calling fibril, returns
+             * false if there was none. Fibrils waiting for the
+             * result of a task call this to help instead of just
+             * blocking, which would deadlock once all workers waited
+             * for tasks that are still queued.
+             */
+            bool run_one();
+
+            size_t worker_count() const noexcept
+            {
+                return worker_count_;
+            }
+
+            executor(const executor&) = delete;
+            executor& operator=(const executor&) = delete;
+
+        private:
+            struct task_queue
+            {
+                mutex_t mtx;
+                executor_task* head;
+                executor_task* tail;
+            };
+
+            task_queue* queues_;
+            size_t worker_count_;
+
+            mutex_t idle_mtx_;
+            condvar_t idle_cv_;
+
+            /**
+             * Number of tasks in all queues, modified atomically
+             * and incremented under idle_mtx_.
+             */
+            size_t pending_;
+
+            /**
+             * Queue for the next task submitted from outside
+             * the workers.
+             */
+            size_t next_queue_;
+
+            executor(size_t workers);
+
+            executor_task* take_(size_t idx);
+            void run_(executor_task* task);
+
+            static int worker_main_(void* arg);
+    };
+}
+
+#endif
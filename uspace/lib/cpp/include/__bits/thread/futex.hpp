@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_THREAD_FUTEX
+#define LIBCPP_BITS_THREAD_FUTEX
+
+#include <cerrno>
+#include <cstdlib>
+#include <ctime>
+
+#include <fibril_synch.h>
+
+namespace std::aux
+{
+    /**
+     * Note: The primitives below keep their whole state in a single
+     *       word that is manipulated with atomic operations, so the
+     *       uncontended paths never take a lock. Only when a fibril
+     *       actually has to wait does it park on the address of the
+     *       word (see fibril_park() in libc), which is the fibril
+     *       counterpart of a futex and does not block the runner.
+     */
+
+    template<class Predicate>
+    int park(const void* addr, Predicate pred,
+             const ::std::timespec* expires = nullptr)
+    {
+        return ::helenos::fibril_park(
+            addr,
+            [](void* arg) -> bool {
+                return (*static_cast<Predicate*>(arg))();
+            },
+            static_cast<void*>(&pred), expires
+        );
+    }
+
+    inline void unpark(const void* addr, size_t count)
+    {
+        ::helenos::fibril_unpark(addr, count);
+    }
+
+    inline void unpark_all(const void* addr)
+    {
+        ::helenos::fibril_unpark(addr, static_cast<size_t>(-1));
+    }
+
+    inline ::std::timespec park_deadline(::helenos::usec_t timeout)
+    {
+        ::std::timespec ts{};
+        ::helenos::getuptime(&ts);
+        ::helenos::ts_add_diff(&ts, USEC2NSEC(timeout));
+
+        return ts;
+    }
+
+    /**
+     * Mutex with three states: unlocked, locked and locked
+     * with (possibly) sleeping waiters. Unlock only goes to
+     * libc when the last state was observed.
+     */
+    class futex_mutex
+    {
+        public:
+            constexpr futex_mutex() noexcept
+                : state_{unlocked}
+            { /* DUMMY BODY */ }
+
+            void lock()
+            {
+                if (!try_lock())
+                    lock_slow_(nullptr);
+            }
+
+            bool try_lock()
+            {
+                int expected{unlocked};
+
+                return __atomic_compare_exchange_n(
+                    &state_, &expected, locked, false,
+                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED
+                );
+            }
+
+            /**
+             * Returns false if the mutex could not be locked
+             * before the absolute (uptime) deadline.
+             */
+            bool lock_until(const ::std::timespec& expires)
+            {
+                return try_lock() || lock_slow_(&expires);
+            }
+
+            void unlock()
+            {
+                if (__atomic_exchange_n(&state_, unlocked, __ATOMIC_RELEASE) == contended)
+                    unpark(&state_, 1);
+            }
+
+        private:
+            static constexpr int unlocked{0};
+            static constexpr int locked{1};
+            static constexpr int contended{2};
+
+            int state_;
+
+            bool lock_slow_(const ::std::timespec*);
+            void lock_contended_();
+
+            friend class futex_condvar;
+    };
+
+    /**
+     * Condition variable implemented as a sequence number
+     * that every notification bumps, waiters sleep only while
+     * it has not changed since they released the mutex.
+     */
+    class futex_condvar
+    {
+        public:
+            constexpr futex_condvar() noexcept
+                : seq_{}
+            { /* DUMMY BODY */ }
+
+            /**
+             * Returns ETIMEOUT if the absolute (uptime) deadline
+             * passed before a notification came, EOK otherwise.
+             * Spurious wakeups are possible.
+             */
+            int wait(futex_mutex&, const ::std::timespec* = nullptr);
+
+            void signal()
+            {
+                __atomic_fetch_add(&seq_, 1U, __ATOMIC_SEQ_CST);
+                unpark(&seq_, 1);
+            }
+
+            void broadcast()
+            {
+                __atomic_fetch_add(&seq_, 1U, __ATOMIC_SEQ_CST);
+                unpark_all(&seq_);
+            }
+
+        private:
+            unsigned int seq_;
+    };
+
+    /**
+     * Reader-biased readers-writer lock. The low bits count readers,
+     * readers only wait for an active writer (not for writers that
+     * wait themselves), so read-mostly data never serializes readers.
+     */
+    class futex_rwlock
+    {
+        public:
+            constexpr futex_rwlock() noexcept
+                : state_{}
+            { /* DUMMY BODY */ }
+
+            void lock()
+            {
+                if (!try_lock())
+                    lock_slow_(nullptr);
+            }
+
+            bool try_lock()
+            {
+                auto state = __atomic_load_n(&state_, __ATOMIC_RELAXED);
+
+                return (state & ~waiters) == 0 && __atomic_compare_exchange_n(
+                    &state_, &state, state | writer, false,
+                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED
+                );
+            }
+
+            bool lock_until(const ::std::timespec& expires)
+            {
+                return try_lock() || lock_slow_(&expires);
+            }
+
+            void unlock()
+            {
+                auto state = __atomic_exchange_n(&state_, 0U, __ATOMIC_RELEASE);
+                if (state & waiters)
+                    unpark_all(&state_);
+            }
+
+            void lock_shared()
+            {
+                if (!try_lock_shared())
+                    lock_shared_slow_(nullptr);
+            }
+
+            bool try_lock_shared()
+            {
+                auto state = __atomic_load_n(&state_, __ATOMIC_RELAXED);
+                while ((state & writer) == 0)
+                {
+                    if (__atomic_compare_exchange_n(
+                        &state_, &state, state + 1, true,
+                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+                        return true;
+                }
+
+                return false;
+            }
+
+            bool lock_shared_until(const ::std::timespec& expires)
+            {
+                return try_lock_shared() || lock_shared_slow_(&expires);
+            }
+
+            void unlock_shared()
+            {
+                auto state = __atomic_sub_fetch(&state_, 1U, __ATOMIC_RELEASE);
+                if (state == waiters)
+                    wake_writers_();
+            }
+
+        private:
+            static constexpr unsigned int writer{1U << 31};
+            static constexpr unsigned int waiters{1U << 30};
+
+            unsigned int state_;
+
+            bool lock_slow_(const ::std::timespec*);
+            bool lock_shared_slow_(const ::std::timespec*);
+            void wake_writers_();
+    };
+}
+
+#endif
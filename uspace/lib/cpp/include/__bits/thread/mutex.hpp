@@ -117,7 +117,7 @@ namespace std
             {
                 auto time = aux::threading::time::convert(rel_time);
 
-                return aux::threading::mutex::try_lock_for(time);
+                return aux::threading::mutex::try_lock_for(mtx_, time);
             }
 
             template<class Clock, class Duration>
@@ -126,7 +126,7 @@ namespace std
                 auto dur = (abs_time - Clock::now());
                 auto time = aux::threading::time::convert(dur);
 
-                return aux::threading::mutex::try_lock_for(time);
+                return aux::threading::mutex::try_lock_for(mtx_, time);
             }
 
             using native_handle_type = aux::mutex_t*;
@@ -162,13 +162,19 @@ namespace std
             bool try_lock_for(const chrono::duration<Rep, Period>& rel_time)
             {
                 if (owner_ == this_thread::get_id())
+                {
+                    ++lock_level_;
                     return true;
+                }
 
                 auto time = aux::threading::time::convert(rel_time);
-                auto ret = aux::threading::mutex::try_lock_for(time);
+                auto ret = aux::threading::mutex::try_lock_for(mtx_, time);
 
                 if (ret)
-                    ++lock_level_;
+                {
+                    owner_ = this_thread::get_id();
+                    lock_level_ = 1;
+                }
                 return ret;
             }
 
@@ -176,14 +182,20 @@ namespace std
             bool try_lock_until(const chrono::time_point<Clock, Duration>& abs_time)
             {
                 if (owner_ == this_thread::get_id())
+                {
+                    ++lock_level_;
                     return true;
+                }
 
                 auto dur = (abs_time - Clock::now());
                 auto time = aux::threading::time::convert(dur);
-                auto ret = aux::threading::mutex::try_lock_for(time);
+                auto ret = aux::threading::mutex::try_lock_for(mtx_, time);
 
                 if (ret)
-                    ++lock_level_;
+                {
+                    owner_ = this_thread::get_id();
+                    lock_level_ = 1;
+                }
                 return ret;
             }
 
@@ -37,6 +37,7 @@
 #include <__bits/functional/function.hpp>
 #include <__bits/functional/invoke.hpp>
 #include <__bits/refcount_obj.hpp>
+#include <__bits/thread/executor.hpp>
 #include <__bits/thread/future_common.hpp>
 #include <__bits/thread/threading.hpp>
 #include <cerrno>
@@ -274,9 +275,13 @@ namespace std::aux
     {
         public:
             async_shared_state(F&& f, Args&&... args)
-                : shared_state<R>{}, thread_{}
+                : shared_state<R>{}, finished_{false}
             {
-                thread_ = thread{
+                /**
+                 * Note: The function runs on the executor instead
+                 *       of a fibril of its own.
+                 */
+                executor::instance().submit_callable(
                     [=](){
                         try
                         {
@@ -285,27 +290,54 @@ namespace std::aux
                             else
                             {
                                 invoke(f, args...);
+
+                                aux::threading::mutex::lock(this->mutex_);
                                 this->mark_set(true);
+                                aux::threading::mutex::unlock(this->mutex_);
+
+                                aux::threading::condvar::broadcast(this->condvar_);
                             }
                         }
                         catch(const exception& __exception)
                         {
+                            aux::threading::mutex::lock(this->mutex_);
                             this->set_exception(make_exception_ptr(__exception));
+                            this->mark_set(true);
+                            aux::threading::mutex::unlock(this->mutex_);
+
+                            aux::threading::condvar::broadcast(this->condvar_);
                         }
+
+                        /**
+                         * Note: This has to be the last access to the
+                         *       state, which may be deleted right after.
+                         */
+                        __atomic_store_n(&finished_, true, __ATOMIC_RELEASE);
                     }
-                };
+                );
             }
 
             void destroy() override
             {
-                if (!this->is_set())
-                    thread_.join();
+                wait();
             }
 
             void wait() const override
             {
-                if (!this->is_set())
-                    const_cast<thread&>(thread_).join();
+                /**
+                 * Note: We run queued tasks while waiting, the one
+                 *       we wait for may be one of them.
+                 */
+                while (!__atomic_load_n(&finished_, __ATOMIC_ACQUIRE))
+                {
+                    if (executor::instance().run_one())
+                        continue;
+
+                    if (!this->is_set())
+                        shared_state<R>::wait();
+                    else
+                        aux::threading::thread::yield();
+                }
             }
 
             ~async_shared_state() override
@@ -313,22 +345,8 @@ namespace std::aux
                 destroy();
             }
 
-        protected:
-            future_status timed_wait_(aux::time_unit_t time) const override
-            {
-                /**
-                 * Note: Currently we have no timed join, but this
-                 *       behaviour should be compliant.
-                 */
-                aux::threading::time::sleep(time);
-                if (this->value_set_)
-                    return future_status::ready;
-                else
-                    return future_status::timeout;
-            }
-
         private:
-            thread thread_;
+            bool finished_;
     };
 
     template<class R, class F, class... Args>
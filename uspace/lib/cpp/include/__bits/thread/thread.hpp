@@ -70,9 +70,18 @@ namespace std
                     return finished_;
                 }
 
-                void detach()
+                /**
+                 * Returns true if the thread has already finished,
+                 * in which case the caller has to delete the wrapper.
+                 */
+                bool detach()
                 {
+                    aux::threading::mutex::lock(join_mtx_);
                     detached_ = true;
+                    auto finished = finished_;
+                    aux::threading::mutex::unlock(join_mtx_);
+
+                    return finished;
                 }
 
                 bool detached() const
@@ -81,6 +90,23 @@ namespace std
                 }
 
             protected:
+                /**
+                 * Returns true if the thread was detached,
+                 * in which case it has to delete the wrapper.
+                 * Otherwise the wrapper must not be touched
+                 * afterwards, as the joining thread may delete it.
+                 */
+                bool finish()
+                {
+                    aux::threading::mutex::lock(join_mtx_);
+                    finished_ = true;
+                    auto detached = detached_;
+                    aux::threading::condvar::broadcast(join_cv_);
+                    aux::threading::mutex::unlock(join_mtx_);
+
+                    return detached;
+                }
+
                 aux::mutex_t join_mtx_;
                 aux::condvar_t join_cv_;
                 bool finished_;
@@ -95,15 +121,11 @@ namespace std
                     : joinable_wrapper{}, callable_{forward<Callable>(clbl)}
                 { /* DUMMY BODY */ }
 
-                void operator()()
+                bool operator()()
                 {
                     callable_();
 
-                    aux::threading::mutex::lock(join_mtx_);
-                    finished_ = true;
-                    aux::threading::mutex::unlock(join_mtx_);
-
-                    aux::threading::condvar::broadcast(join_cv_);
+                    return finish();
                 }
 
             private:
@@ -194,9 +216,7 @@ namespace std
                 return 1;
 
             auto callable = static_cast<CallablePtr>(clbl);
-            (*callable)();
-
-            if (callable->detached())
+            if ((*callable)())
                 delete callable;
 
             return 0;
@@ -29,6 +29,7 @@
 #ifndef LIBCPP_BITS_THREAD_THREADING
 #define LIBCPP_BITS_THREAD_THREADING
 
+#include <__bits/thread/futex.hpp>
 #include <chrono>
 
 #include <fibril.h>
@@ -48,17 +49,30 @@ namespace std::aux
     template<>
     struct threading_policy<fibril_tag>
     {
-        using mutex_type        = ::helenos::fibril_mutex_t;
+        /**
+         * Note: Instead of fibril_mutex_t and friends, which
+         *       serialize on a single global futex in libc, we use
+         *       word-sized primitives that only go to libc when they
+         *       have to wait (see futex.hpp).
+         */
+        using mutex_type        = futex_mutex;
         using thread_type       = ::helenos::fid_t;
-        using condvar_type      = ::helenos::fibril_condvar_t;
+        using condvar_type      = futex_condvar;
         using time_unit         = ::helenos::usec_t;
-        using shared_mutex_type = ::helenos::fibril_rwlock_t;
+        using shared_mutex_type = futex_rwlock;
 
         struct thread
         {
             template<class Callable, class Payload>
             static thread_type create(Callable clbl, Payload& pld)
             {
+                /**
+                 * Note: Threads are expected to run in parallel,
+                 *       so the first one gets us a fibril runner
+                 *       for each processor.
+                 */
+                ::helenos::fibril_enable_multithreaded();
+
                 return ::helenos::fibril_create(clbl, (void*)&pld);
             }
 
@@ -86,58 +100,70 @@ namespace std::aux
 
         struct mutex
         {
-            static void init(mutex_type& mtx)
+            static constexpr void init(mutex_type& mtx)
             {
-                ::helenos::fibril_mutex_initialize(&mtx);
+                mtx = mutex_type{};
             }
 
             static void lock(mutex_type& mtx)
             {
-                ::helenos::fibril_mutex_lock(&mtx);
+                mtx.lock();
             }
 
             static void unlock(mutex_type& mtx)
             {
-                ::helenos::fibril_mutex_unlock(&mtx);
+                mtx.unlock();
             }
 
             static bool try_lock(mutex_type& mtx)
             {
-                return ::helenos::fibril_mutex_trylock(&mtx);
+                return mtx.try_lock();
             }
 
             static bool try_lock_for(mutex_type& mtx, time_unit timeout)
             {
-                // TODO: we need fibril_mutex_trylock_for() :/
-                return try_lock(mtx);
+                if (timeout <= 0)
+                    return mtx.try_lock();
+
+                return mtx.lock_until(park_deadline(timeout));
             }
         };
 
         struct condvar
         {
-            static void init(condvar_type& cv)
+            static constexpr void init(condvar_type& cv)
             {
-                ::helenos::fibril_condvar_initialize(&cv);
+                cv = condvar_type{};
             }
 
             static void wait(condvar_type& cv, mutex_type& mtx)
             {
-                ::helenos::fibril_condvar_wait(&cv, &mtx);
+                cv.wait(mtx);
             }
 
+            /**
+             * Note: Unlike fibril_condvar_wait_timeout, a zero
+             *       (or negative) timeout means that the deadline
+             *       has already passed, not that there is none.
+             */
             static int wait_for(condvar_type& cv, mutex_type& mtx, time_unit timeout)
             {
-                return ::helenos::fibril_condvar_wait_timeout(&cv, &mtx, timeout);
+                if (timeout <= 0)
+                    return ETIMEOUT;
+
+                auto deadline = park_deadline(timeout);
+
+                return cv.wait(mtx, &deadline);
             }
 
             static void signal(condvar_type& cv)
             {
-                ::helenos::fibril_condvar_signal(&cv);
+                cv.signal();
             }
 
             static void broadcast(condvar_type& cv)
             {
-                ::helenos::fibril_condvar_broadcast(&cv);
+                cv.broadcast();
             }
         };
 
@@ -157,54 +183,55 @@ namespace std::aux
 
         struct shared_mutex
         {
-            static void init(shared_mutex_type& mtx)
+            static constexpr void init(shared_mutex_type& mtx)
             {
-                ::helenos::fibril_rwlock_initialize(&mtx);
+                mtx = shared_mutex_type{};
             }
 
             static void lock(shared_mutex_type& mtx)
             {
-                ::helenos::fibril_rwlock_write_lock(&mtx);
+                mtx.lock();
             }
 
             static void unlock(shared_mutex_type& mtx)
             {
-                ::helenos::fibril_rwlock_write_unlock(&mtx);
+                mtx.unlock();
             }
 
             static void lock_shared(shared_mutex_type& mtx)
             {
-                ::helenos::fibril_rwlock_read_lock(&mtx);
+                mtx.lock_shared();
             }
 
             static void unlock_shared(shared_mutex_type& mtx)
             {
-                ::helenos::fibril_rwlock_read_unlock(&mtx);
+                mtx.unlock_shared();
             }
 
             static bool try_lock(shared_mutex_type& mtx)
             {
-                // TODO: rwlocks don't have try locking capabilities
-                lock(mtx);
-
-                return true;
+                return mtx.try_lock();
             }
 
             static bool try_lock_shared(shared_mutex_type& mtx)
             {
-                lock(mtx);
-
-                return true;
+                return mtx.try_lock_shared();
             }
 
             static bool try_lock_for(shared_mutex_type& mtx, time_unit timeout)
             {
-                return try_lock(mtx);
+                if (timeout <= 0)
+                    return mtx.try_lock();
+
+                return mtx.lock_until(park_deadline(timeout));
             }
 
             static bool try_lock_shared_for(shared_mutex_type& mtx, time_unit timeout)
             {
-                return try_lock(mtx);
+                if (timeout <= 0)
+                    return mtx.try_lock_shared();
+
+                return mtx.lock_shared_until(park_deadline(timeout));
             }
         };
     };
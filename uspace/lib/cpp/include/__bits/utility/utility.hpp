@@ -30,6 +30,7 @@
 #define LIBCPP_BITS_UTILITY
 
 #include <__bits/type_transformation.hpp>
+#include <__bits/utility/declval.hpp>
 #include <__bits/utility/forward_move.hpp>
 #include <cstdint>
 #include <type_traits>
@@ -103,6 +104,26 @@ namespace std
         return old_val;
     }
 
+    /**
+     * 20.2.4, forward/move helpers (move_if_noexcept):
+     */
+
+    namespace aux
+    {
+        template<class T>
+        struct copy_instead_of_move: aux::value_is<
+            bool, !noexcept(T(declval<T&&>())) && is_constructible<T, const T&>::value
+        >
+        { /* DUMMY BODY */ };
+    }
+
+    template<class T>
+    constexpr conditional_t<aux::copy_instead_of_move<T>::value, const T&, T&&>
+    move_if_noexcept(T& x) noexcept
+    {
+        return move(x);
+    }
+
     /**
      * 20.5.2, class template integer_sequence:
      */
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/thread/executor.hpp>
+#include <fibril.h>
+
+namespace std::aux
+{
+    namespace
+    {
+        /**
+         * Index of the worker run by the current fibril
+         * plus one, zero in fibrils that are not workers.
+         */
+        __thread size_t current_worker{};
+    }
+
+    executor& executor::instance()
+    {
+        /**
+         * Note: Workers that start before the initialization
+         *       finishes wait for it in the static guard.
+         *       The executor is intentionally leaked, workers may
+         *       still be waiting for tasks during static destruction.
+         */
+        static executor* instance_ = [](){
+            ::helenos::fibril_enable_multithreaded();
+
+            auto runners = ::helenos::fibril_get_runner_count();
+
+            return new executor{runners > 1 ? size_t(runners) : size_t{2}};
+        }();
+
+        return *instance_;
+    }
+
+    executor::executor(size_t workers)
+        : queues_{new task_queue[workers]}, worker_count_{workers},
+          idle_mtx_{}, idle_cv_{}, pending_{}, next_queue_{}
+    {
+        threading::mutex::init(idle_mtx_);
+        threading::condvar::init(idle_cv_);
+
+        for (size_t i = 0; i < worker_count_; ++i)
+        {
+            threading::mutex::init(queues_[i].mtx);
+            queues_[i].head = nullptr;
+            queues_[i].tail = nullptr;
+        }
+
+        for (size_t i = 0; i < worker_count_; ++i)
+        {
+            auto fid = ::helenos::fibril_create(
+                &executor::worker_main_, reinterpret_cast<void*>(i + 1)
+            );
+            if (!fid)
+                abort();
+            ::helenos::fibril_add_ready(fid);
+        }
+    }
+
+    void executor::submit(executor_task* task)
+    {
+        size_t idx{};
+        if (current_worker)
+            idx = current_worker - 1;
+        else
+            idx = __atomic_fetch_add(&next_queue_, 1, __ATOMIC_RELAXED) % worker_count_;
+
+        auto& queue = queues_[idx];
+        threading::mutex::lock(queue.mtx);
+        task->prev_ = queue.tail;
+        task->next_ = nullptr;
+        if (queue.tail)
+            queue.tail->next_ = task;
+        else
+            queue.head = task;
+        queue.tail = task;
+        threading::mutex::unlock(queue.mtx);
+
+        threading::mutex::lock(idle_mtx_);
+        __atomic_add_fetch(&pending_, 1, __ATOMIC_RELEASE);
+        threading::mutex::unlock(idle_mtx_);
+
+        threading::condvar::signal(idle_cv_);
+    }
+
+    bool executor::run_one()
+    {
+        auto idx = current_worker ? current_worker - 1 : size_t{};
+        auto task = take_(idx);
+        if (!task)
+            return false;
+
+        run_(task);
+
+        return true;
+    }
+
+    /**
+     * Note: The owner takes the most recently submitted task of its
+     *       queue, which is likely still in the cache, while thieves
+     *       take the oldest tasks of the other queues.
+     */
+    executor_task* executor::take_(size_t idx)
+    {
+        if (__atomic_load_n(&pending_, __ATOMIC_ACQUIRE) == 0)
+            return nullptr;
+
+        executor_task* task{nullptr};
+        for (size_t i = 0; i < worker_count_ && !task; ++i)
+        {
+            auto& queue = queues_[(idx + i) % worker_count_];
+
+            threading::mutex::lock(queue.mtx);
+            if (i == 0 && queue.tail)
+            {
+                task = queue.tail;
+                queue.tail = task->prev_;
+                if (queue.tail)
+                    queue.tail->next_ = nullptr;
+                else
+                    queue.head = nullptr;
+            }
+            else if (i > 0 && queue.head)
+            {
+                task = queue.head;
+                queue.head = task->next_;
+                if (queue.head)
+                    queue.head->prev_ = nullptr;
+                else
+                    queue.tail = nullptr;
+            }
+            threading::mutex::unlock(queue.mtx);
+        }
+
+        if (task)
+            __atomic_sub_fetch(&pending_, 1, __ATOMIC_RELEASE);
+
+        return task;
+    }
+
+    void executor::run_(executor_task* task)
+    {
+        task->run();
+        delete task;
+    }
+
+    int executor::worker_main_(void* arg)
+    {
+        current_worker = reinterpret_cast<size_t>(arg);
+
+        auto& exec = instance();
+        auto idx = current_worker - 1;
+
+        while (true)
+        {
+            auto task = exec.take_(idx);
+            if (task)
+            {
+                exec.run_(task);
+                continue;
+            }
+
+            threading::mutex::lock(exec.idle_mtx_);
+            while (__atomic_load_n(&exec.pending_, __ATOMIC_ACQUIRE) == 0)
+                threading::condvar::wait(exec.idle_cv_, exec.idle_mtx_);
+            threading::mutex::unlock(exec.idle_mtx_);
+
+            /**
+             * Note: Another worker may have taken the task in the
+             *       meantime or still be updating pending_ after
+             *       taking it, so let it finish.
+             */
+            threading::thread::yield();
+        }
+
+        return 0;
+    }
+}
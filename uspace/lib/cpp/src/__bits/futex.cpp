@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/thread/futex.hpp>
+#include <fibril.h>
+
+namespace std::aux
+{
+    namespace
+    {
+        /**
+         * Number of times a contended lock is polled before
+         * the fibril parks. Locks are mostly held only briefly,
+         * so if the holder runs on another runner, it is likely
+         * to release the lock before a park/unpark round trip.
+         */
+        constexpr int spin_count{100};
+
+        bool spinning_pays_off()
+        {
+            /**
+             * Note: With a single runner, the holder cannot make
+             *       progress while we spin.
+             */
+            return ::helenos::fibril_get_runner_count() > 1;
+        }
+    }
+
+    bool futex_mutex::lock_slow_(const ::std::timespec* expires)
+    {
+        if (spinning_pays_off())
+        {
+            for (int i = 0; i < spin_count; ++i)
+            {
+                auto state = __atomic_load_n(&state_, __ATOMIC_RELAXED);
+                if (state == contended)
+                    break;
+                else if (state == unlocked && try_lock())
+                    return true;
+            }
+        }
+
+        /**
+         * Note: We cannot know if others are waiting too,
+         *       so once we have slept, we have to assume so.
+         */
+        while (__atomic_exchange_n(&state_, contended, __ATOMIC_ACQUIRE) != unlocked)
+        {
+            auto rc = park(&state_, [this]{
+                return __atomic_load_n(&state_, __ATOMIC_RELAXED) == contended;
+            }, expires);
+
+            if (rc == ETIMEOUT)
+                return false;
+        }
+
+        return true;
+    }
+
+    void futex_mutex::lock_contended_()
+    {
+        while (__atomic_exchange_n(&state_, contended, __ATOMIC_ACQUIRE) != unlocked)
+        {
+            park(&state_, [this]{
+                return __atomic_load_n(&state_, __ATOMIC_RELAXED) == contended;
+            });
+        }
+    }
+
+    int futex_condvar::wait(futex_mutex& mtx, const ::std::timespec* expires)
+    {
+        /**
+         * Note: The sequence number is read while we still hold
+         *       the mutex, so any notification that comes after
+         *       we unlock it makes the park return immediately.
+         */
+        auto seq = __atomic_load_n(&seq_, __ATOMIC_RELAXED);
+        mtx.unlock();
+
+        auto rc = park(&seq_, [this, seq]{
+            return __atomic_load_n(&seq_, __ATOMIC_RELAXED) == seq;
+        }, expires);
+
+        /**
+         * Note: Other fibrils woken by a broadcast may be
+         *       waiting for the mutex as well.
+         */
+        mtx.lock_contended_();
+
+        return rc == ETIMEOUT ? ETIMEOUT : EOK;
+    }
+
+    bool futex_rwlock::lock_slow_(const ::std::timespec* expires)
+    {
+        while (true)
+        {
+            auto state = __atomic_load_n(&state_, __ATOMIC_RELAXED);
+            if ((state & ~waiters) == 0)
+            {
+                if (__atomic_compare_exchange_n(
+                    &state_, &state, state | writer, true,
+                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+                    return true;
+                continue;
+            }
+
+            if ((state & waiters) == 0 && !__atomic_compare_exchange_n(
+                &state_, &state, state | waiters, true,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                continue;
+
+            state |= waiters;
+            auto rc = park(&state_, [this, state]{
+                return __atomic_load_n(&state_, __ATOMIC_RELAXED) == state;
+            }, expires);
+
+            if (rc == ETIMEOUT)
+                return false;
+        }
+    }
+
+    bool futex_rwlock::lock_shared_slow_(const ::std::timespec* expires)
+    {
+        while (true)
+        {
+            auto state = __atomic_load_n(&state_, __ATOMIC_RELAXED);
+            if ((state & writer) == 0)
+            {
+                if (__atomic_compare_exchange_n(
+                    &state_, &state, state + 1, true,
+                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+                    return true;
+                continue;
+            }
+
+            if ((state & waiters) == 0 && !__atomic_compare_exchange_n(
+                &state_, &state, state | waiters, true,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                continue;
+
+            state |= waiters;
+            auto rc = park(&state_, [this, state]{
+                return __atomic_load_n(&state_, __ATOMIC_RELAXED) == state;
+            }, expires);
+
+            if (rc == ETIMEOUT)
+                return false;
+        }
+    }
+
+    void futex_rwlock::wake_writers_()
+    {
+        /**
+         * Note: If this fails, a new reader or a writer got in
+         *       and its unlock will do the wakeup instead.
+         */
+        unsigned int expected{waiters};
+        if (__atomic_compare_exchange_n(
+            &state_, &expected, 0U, false,
+            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            unpark_all(&state_);
+    }
+}
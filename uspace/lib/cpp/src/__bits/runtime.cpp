@@ -136,7 +136,19 @@ namespace __cxxabiv1
     {
         static_guard_mtx.lock();
 
-        return !*((std::uint8_t*)guard);
+        /**
+         * Note: Another fibril might have finished the
+         *       initialization while we waited for the mutex,
+         *       in which case no release follows.
+         */
+        if (*((std::uint8_t*)guard))
+        {
+            static_guard_mtx.unlock();
+
+            return 0;
+        }
+
+        return 1;
     }
 
     extern "C" void __cxa_guard_release(guard_t* guard)
@@ -29,8 +29,13 @@
 #include <__bits/test/tests.hpp>
 #include <algorithm>
 #include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <execution>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace std::test
 {
@@ -41,6 +46,9 @@ namespace std::test
 
         test_non_modifying();
         test_mutating();
+        test_sorting();
+        test_parallel();
+        bench_sorting();
 
         return end();
     }
@@ -293,4 +301,219 @@ namespace std::test
         );
         test_eq("transform pt2", res6, data10.end());
     }
+
+    void algorithm_test::test_sorting()
+    {
+        auto check1 = {0, 1, 1, 2, 3, 4, 5, 5, 6, 7, 8, 9, 9, 10, 11, 12,
+                       13, 14, 15, 16, 17, 18, 19, 20};
+        std::vector<int> data1{20, 5, 13, 1, 9, 0, 18, 7, 3, 15, 11, 9,
+                               19, 2, 16, 5, 12, 4, 17, 10, 1, 14, 6, 8};
+
+        std::sort(data1.begin(), data1.end());
+        test_eq(
+            "sort pt1", check1.begin(), check1.end(),
+            data1.begin(), data1.end()
+        );
+
+        std::sort(
+            data1.begin(), data1.end(),
+            [](auto lhs, auto rhs){ return lhs > rhs; }
+        );
+        auto res1 = std::adjacent_find(
+            data1.begin(), data1.end(),
+            [](auto lhs, auto rhs){ return lhs < rhs; }
+        );
+        test_eq("sort pt2", res1, data1.end());
+
+        /**
+         * Large enough to go through the partitioning,
+         * all equal keys are the classic bad case for it.
+         */
+        std::vector<int> data2(1000, 7);
+        std::sort(data2.begin(), data2.end());
+        test("sort pt3", std::all_of(
+            data2.begin(), data2.end(), [](auto x){ return x == 7; }
+        ));
+
+        std::vector<int> data3{};
+        for (int i = 0; i < 1000; ++i)
+            data3.push_back((i * 7919) % 1000);
+        std::sort(data3.begin(), data3.end());
+        auto res2 = std::adjacent_find(
+            data3.begin(), data3.end(),
+            [](auto lhs, auto rhs){ return rhs < lhs; }
+        );
+        test_eq("sort pt4", res2, data3.end());
+        test_eq("sort pt5", data3[0], 0);
+        test_eq("sort pt6", data3[999], 999);
+
+        using pair_t = std::pair<int, int>;
+        std::vector<pair_t> data4{};
+        for (int i = 0; i < 100; ++i)
+            data4.emplace_back(i % 5, i);
+
+        std::stable_sort(
+            data4.begin(), data4.end(),
+            [](const auto& lhs, const auto& rhs){
+                return lhs.first < rhs.first;
+            }
+        );
+        auto res3 = std::adjacent_find(
+            data4.begin(), data4.end(),
+            [](const auto& lhs, const auto& rhs){
+                return rhs.first < lhs.first ||
+                       (rhs.first == lhs.first && rhs.second < lhs.second);
+            }
+        );
+        test_eq("stable_sort pt1", res3, data4.end());
+        test_eq("stable_sort pt2", data4[0], pair_t{0, 0});
+        test_eq("stable_sort pt3", data4[20], pair_t{1, 1});
+        test_eq("stable_sort pt4", data4[99], pair_t{4, 99});
+
+        auto check2 = {0, 1, 2, 3, 4};
+        std::vector<int> data5{};
+        for (int i = 0; i < 100; ++i)
+            data5.push_back((i * 37) % 100);
+
+        std::partial_sort(data5.begin(), data5.begin() + 5, data5.end());
+        test_eq(
+            "partial_sort", check2.begin(), check2.end(),
+            data5.begin(), data5.begin() + 5
+        );
+
+        std::array<int, 5> data6{};
+        auto res4 = std::partial_sort_copy(
+            data3.rbegin(), data3.rend(), data6.begin(), data6.end()
+        );
+        test_eq(
+            "partial_sort_copy pt1", check2.begin(), check2.end(),
+            data6.begin(), data6.end()
+        );
+        test_eq("partial_sort_copy pt2", res4, data6.end());
+
+        std::vector<int> data7{};
+        for (int i = 0; i < 100; ++i)
+            data7.push_back((i * 37) % 100);
+
+        auto nth = data7.begin() + 42;
+        std::nth_element(data7.begin(), nth, data7.end());
+        test_eq("nth_element pt1", *nth, 42);
+        test("nth_element pt2", std::all_of(
+            data7.begin(), nth, [](auto x){ return x < 42; }
+        ));
+        test("nth_element pt3", std::all_of(
+            nth, data7.end(), [](auto x){ return x >= 42; }
+        ));
+    }
+
+    void algorithm_test::test_parallel()
+    {
+        std::vector<unsigned int> data(50000);
+        for (std::size_t i = 0; i < data.size(); ++i)
+            data[i] = i;
+
+        std::vector<unsigned int> check(data.size());
+        std::transform(
+            data.begin(), data.end(), check.begin(),
+            [](auto x){ return x * 3 + 1; }
+        );
+
+        std::vector<unsigned int> res1(data.size());
+        auto end1 = std::transform(
+            std::execution::par, data.begin(), data.end(), res1.begin(),
+            [](auto x){ return x * 3 + 1; }
+        );
+        test("parallel transform pt1", end1 == res1.end());
+        test_eq(
+            "parallel transform pt2", res1.begin(), res1.end(),
+            check.begin(), check.end()
+        );
+
+        std::vector<unsigned int> res2(data.size());
+        std::transform(
+            std::execution::par, data.begin(), data.end(), res1.begin(),
+            res2.begin(), [](auto x, auto y){ return y - 2 * x; }
+        );
+        test("parallel binary transform", std::all_of(
+            res2.begin(), res2.end(),
+            [&](const auto& x){ return x == (&x - &res2[0]) + 1u; }
+        ));
+
+        std::for_each(
+            std::execution::par, res1.begin(), res1.end(),
+            [](auto& x){ x -= 1; }
+        );
+        test("parallel for_each", std::all_of(
+            res1.begin(), res1.end(),
+            [&](const auto& x){ return x == (&x - &res1[0]) * 3u; }
+        ));
+
+        auto data2 = {1, 2, 3};
+        std::vector<int> res3(3);
+        std::transform(
+            std::execution::seq, data2.begin(), data2.end(), res3.begin(),
+            [](auto x){ return -x; }
+        );
+        auto check3 = {-1, -2, -3};
+        test_eq(
+            "sequenced transform", res3.begin(), res3.end(),
+            check3.begin(), check3.end()
+        );
+    }
+
+    void algorithm_test::bench_sorting()
+    {
+        constexpr std::size_t count{20000};
+
+        std::vector<unsigned int> input(count);
+        std::uint32_t seed{42};
+        for (auto& x: input)
+        {
+            seed = seed * 1103515245u + 12345u;
+            x = seed >> 8;
+        }
+
+        auto heap = input;
+        auto intro = input;
+        auto stable = input;
+
+        auto measure = [](auto& data, auto sorter){
+            auto start = std::chrono::steady_clock::now();
+            sorter(data.begin(), data.end());
+            auto end = std::chrono::steady_clock::now();
+
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                end - start
+            ).count();
+        };
+
+        auto heap_us = measure(heap, [](auto first, auto last){
+            std::make_heap(first, last);
+            std::sort_heap(first, last);
+        });
+        auto intro_us = measure(intro, [](auto first, auto last){
+            std::sort(first, last);
+        });
+        auto stable_us = measure(stable, [](auto first, auto last){
+            std::stable_sort(first, last);
+        });
+
+        if (report_)
+        {
+            std::printf(
+                "[%s][sort benchmark] %zu elements: heap %lld us, "
+                "sort %lld us, stable_sort %lld us\n", name(), count,
+                (long long)heap_us, (long long)intro_us, (long long)stable_us
+            );
+        }
+
+        test_eq(
+            "sort benchmark pt1", heap.begin(), heap.end(),
+            intro.begin(), intro.end()
+        );
+        test_eq(
+            "sort benchmark pt2", intro.begin(), intro.end(),
+            stable.begin(), stable.end()
+        );
+    }
 }
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace std::test
+{
+    bool atomic_test::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        test_atomic();
+        test_wait_notify();
+        test_mutex();
+        test_shared_mutex();
+        test_condition_variable();
+
+        return end();
+    }
+
+    const char* atomic_test::name()
+    {
+        return "atomic";
+    }
+
+    void atomic_test::test_atomic()
+    {
+        std::atomic<int> a{1};
+        test_eq("construction", a.load(), 1);
+
+        ++a;
+        a += 3;
+        test_eq("arithmetic", a.load(), 5);
+        test_eq("fetch_or", a.fetch_or(8), 5);
+        test_eq("fetch_and", a.fetch_and(12), 13);
+        test_eq("exchange", a.exchange(4), 12);
+
+        int expected{3};
+        test("failed cas", !a.compare_exchange_strong(expected, 7));
+        test_eq("failed cas updates expected", expected, 4);
+        test("successful cas", a.compare_exchange_strong(expected, 7));
+        test_eq("successful cas stores", a.load(), 7);
+
+        int arr[4]{};
+        std::atomic<int*> p{arr};
+        p += 2;
+        test_eq("pointer arithmetic pt1", p.load(), &arr[2]);
+        --p;
+        test_eq("pointer arithmetic pt2", p.load(), &arr[1]);
+
+        std::atomic<bool> b{false};
+        b = true;
+        test("bool store", b.load());
+
+        std::atomic_flag flag = ATOMIC_FLAG_INIT;
+        test("flag initially clear", !flag.test_and_set());
+        test("flag set", flag.test_and_set());
+        flag.clear();
+        test("flag cleared", !flag.test());
+    }
+
+    void atomic_test::test_wait_notify()
+    {
+        std::atomic<int> a{0};
+        a.wait(1);
+        test("wait with different value returns", true);
+
+        std::thread t{[&a](){
+            std::this_thread::sleep_for(1ms);
+            a.store(1);
+            a.notify_one();
+
+            a.wait(1);
+            a.store(3);
+            a.notify_all();
+        }};
+
+        a.wait(0);
+        test_eq("wait woken by notify_one", a.load(), 1);
+
+        a.store(2);
+        a.notify_one();
+        a.wait(2);
+        test_eq("ping pong", a.load(), 3);
+
+        t.join();
+    }
+
+    void atomic_test::test_mutex()
+    {
+        constexpr int threads{4};
+        constexpr int iterations{10000};
+
+        std::mutex mtx{};
+        int counter{};
+        std::vector<std::thread> workers{};
+        for (int i = 0; i < threads; ++i)
+        {
+            workers.emplace_back([&](){
+                for (int j = 0; j < iterations; ++j)
+                {
+                    std::lock_guard<std::mutex> lock{mtx};
+                    ++counter;
+                }
+            });
+        }
+
+        for (auto& worker: workers)
+            worker.join();
+        test_eq("contended mutex", counter, threads * iterations);
+
+        std::timed_mutex tmtx{};
+        tmtx.lock();
+        std::thread t{[&](){
+            test("timed lock times out", !tmtx.try_lock_for(1ms));
+        }};
+        t.join();
+        tmtx.unlock();
+        test("timed lock succeeds", tmtx.try_lock_for(1ms));
+        tmtx.unlock();
+    }
+
+    void atomic_test::test_shared_mutex()
+    {
+        std::shared_timed_mutex mtx{};
+
+        mtx.lock_shared();
+        test("second reader gets in", mtx.try_lock_shared());
+        test("writer is kept out", !mtx.try_lock());
+        mtx.unlock_shared();
+        mtx.unlock_shared();
+        test("writer gets in", mtx.try_lock());
+        test("reader is kept out", !mtx.try_lock_shared());
+        mtx.unlock();
+
+        constexpr int threads{4};
+        constexpr int iterations{2000};
+
+        int value{};
+        bool consistent{true};
+        std::vector<std::thread> workers{};
+        for (int i = 0; i < threads; ++i)
+        {
+            workers.emplace_back([&, i](){
+                for (int j = 0; j < iterations; ++j)
+                {
+                    if (i == 0)
+                    {
+                        std::unique_lock<std::shared_timed_mutex> lock{mtx};
+                        value += 2;
+                    }
+                    else
+                    {
+                        std::shared_lock<std::shared_timed_mutex> lock{mtx};
+                        if (value % 2 != 0)
+                            consistent = false;
+                    }
+                }
+            });
+        }
+
+        for (auto& worker: workers)
+            worker.join();
+        test("readers see consistent state", consistent);
+        test_eq("writer updates", value, 2 * iterations);
+    }
+
+    void atomic_test::test_condition_variable()
+    {
+        constexpr int items{1000};
+
+        std::mutex mtx{};
+        std::condition_variable cv{};
+        std::vector<int> queue{};
+        bool done{false};
+
+        std::thread producer{[&](){
+            for (int i = 0; i < items; ++i)
+            {
+                std::lock_guard<std::mutex> lock{mtx};
+                queue.push_back(i);
+                cv.notify_one();
+            }
+
+            std::lock_guard<std::mutex> lock{mtx};
+            done = true;
+            cv.notify_all();
+        }};
+
+        long sum{};
+        std::unique_lock<std::mutex> lock{mtx};
+        while (true)
+        {
+            cv.wait(lock, [&](){ return done || !queue.empty(); });
+            for (auto x: queue)
+                sum += x;
+            queue.clear();
+
+            if (done)
+                break;
+        }
+        lock.unlock();
+        producer.join();
+
+        test_eq("producer consumer", sum, long{items * (items - 1) / 2});
+
+        lock.lock();
+        auto status = cv.wait_for(lock, 1ms);
+        test("wait_for times out", status == std::cv_status::timeout);
+    }
+}
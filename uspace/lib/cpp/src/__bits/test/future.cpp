@@ -33,6 +33,7 @@
 #include <future>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -275,6 +276,42 @@ namespace std::test
 
         res4.get();
         test_eq("void async", x, 42);
+
+        int y{};
+        auto res5 = std::async(
+            std::launch::async, [&y](){
+                y = 42;
+            }
+        );
+
+        res5.wait();
+        test_eq("void async async policy", y, 42);
+
+        /**
+         * The outer tasks wait for the inner ones, which
+         * must not deadlock when there are more outer tasks
+         * than workers.
+         */
+        std::vector<std::future<int>> outer{};
+        for (int i = 0; i < 16; ++i)
+        {
+            outer.push_back(std::async(
+                std::launch::async, [i](){
+                    auto inner = std::async(
+                        std::launch::async, [i](){
+                            return i * 2;
+                        }
+                    );
+
+                    return inner.get() + 1;
+                }
+            ));
+        }
+
+        int sum{};
+        for (auto& f: outer)
+            sum += f.get();
+        test_eq("nested async", sum, 256);
     }
 
     void future_test::test_packaged_task()
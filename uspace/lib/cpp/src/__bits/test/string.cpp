@@ -47,6 +47,7 @@ namespace std::test
         test_find();
         test_substr();
         test_compare();
+        test_storage();
 
         return end();
     }
@@ -703,4 +704,40 @@ namespace std::test
             res, 0
         );
     }
+
+    void string_test::test_storage()
+    {
+        std::string str1{"short"};
+        auto data1 = str1.data();
+        std::string str2{std::move(str1)};
+        test_eq("move short", str2, std::string{"short"});
+        test("move short leaves source empty", str1.empty());
+        test_eq("moved-from terminated", str1.c_str()[0], '\0');
+        test("short string stays inline", str2.data() != data1);
+
+        std::string str3(40, 'x');
+        auto data3 = str3.data();
+        std::string str4{std::move(str3)};
+        test_eq("move long steals buffer", str4.data(), data3);
+        test("move long leaves source empty", str3.empty());
+
+        str2.swap(str4);
+        test_eq("swap short/long pt1", str2.size(), 40ul);
+        test_eq("swap short/long pt2", str4, std::string{"short"});
+
+        std::string str5{};
+        str5.reserve(100);
+        auto data5 = str5.data();
+        for (int i = 0; i < 100; ++i)
+            str5.push_back('a');
+        test_eq("reserve avoids reallocation", str5.data(), data5);
+        test_eq("append after reserve", str5.size(), 100ul);
+
+        str5.resize(3);
+        str5.shrink_to_fit();
+        test_eq("shrink back to inline", str5, std::string{"aaa"});
+
+        str5.resize(6, 'b');
+        test_eq("resize with char", str5, std::string{"aaabbb"});
+    }
 }
@@ -27,11 +27,16 @@
  */
 
 #include <__bits/test/tests.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <flat_hash_map>
 #include <initializer_list>
 #include <unordered_map>
 #include <string>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 namespace std::test
 {
@@ -44,6 +49,9 @@ namespace std::test
         test_histogram();
         test_emplace_insert();
         test_multi();
+        test_churn();
+        test_flat();
+        bench_maps();
 
         return end();
     }
@@ -263,4 +271,174 @@ namespace std::test
         test_eq("multi erase by iterator pt1", res7->first, 7);
         test_eq("multi erase by iterator pt2", mmap.count(7), 1U);
     }
+
+    void unordered_map_test::test_churn()
+    {
+        std::unordered_map<int, std::string> map{};
+        for (int i = 0; i < 1000; ++i)
+            map.emplace(i, std::string(i % 40, 'a'));
+        test_eq("churn fill", map.size(), 1000U);
+
+        for (int round = 0; round < 4; ++round)
+        {
+            for (int i = 0; i < 1000; i += 2)
+                map.erase(i);
+            for (int i = 0; i < 1000; i += 2)
+                map.emplace(i, std::string(i % 40, 'b'));
+        }
+        test_eq("churn size", map.size(), 1000U);
+        test_eq("churn reused pt1", map[10], std::string(10, 'b'));
+        test_eq("churn reused pt2", map[11], std::string(11, 'a'));
+
+        auto copy = map;
+        map.clear();
+        test_eq("churn clear", map.empty(), true);
+        test_eq("churn copy", copy.size(), 1000U);
+        test_eq("churn copy value", copy.at(999), std::string(39, 'a'));
+    }
+
+    void unordered_map_test::test_flat()
+    {
+        helenos::flat_hash_map<int, int> map1{};
+        test_eq("flat empty", map1.empty(), true);
+        test_eq("flat empty find", map1.find(1), map1.end());
+
+        auto res1 = map1.emplace(1, 2);
+        test_eq("flat emplace pt1", res1.second, true);
+        test_eq("flat emplace pt2", res1.first->second, 2);
+
+        auto res2 = map1.emplace(1, 3);
+        test_eq("flat emplace pt3", res2.second, false);
+        test_eq("flat emplace pt4", res2.first->second, 2);
+
+        auto res3 = map1.try_emplace(2, 4);
+        test_eq("flat try_emplace", res3.second, true);
+
+        auto res4 = map1.insert(std::pair<const int, int>{3, 6});
+        test_eq("flat insert", res4.second, true);
+        test_eq("flat size", map1.size(), 3U);
+        test_eq("flat at", map1.at(3), 6);
+        test_eq("flat contains", map1.contains(2), true);
+
+        map1[4] = 8;
+        test_eq("flat operator[]", map1[4], 8);
+        test_eq("flat erase by key pt1", map1.erase(4), 1U);
+        test_eq("flat erase by key pt2", map1.erase(4), 0U);
+        test_eq("flat count", map1.count(4), 0U);
+
+        /**
+         * Erasing every other key leaves tombstones
+         * all over the table, which must not break
+         * the probe sequences of the remaining keys.
+         */
+        helenos::flat_hash_map<int, std::string> map2{};
+        for (int i = 0; i < 5000; ++i)
+            map2.emplace(i, std::to_string(i));
+        for (int i = 0; i < 5000; i += 2)
+            map2.erase(i);
+
+        bool found_all{true};
+        for (int i = 1; i < 5000; i += 2)
+        {
+            auto it = map2.find(i);
+            if (it == map2.end() || it->second != std::to_string(i))
+                found_all = false;
+        }
+        test("flat tombstones pt1", found_all);
+        test_eq("flat tombstones pt2", map2.size(), 2500U);
+        test_eq("flat tombstones pt3", map2.find(2), map2.end());
+
+        std::size_t visited{};
+        for (const auto& x: map2)
+        {
+            if (x.first % 2 == 1)
+                ++visited;
+        }
+        test_eq("flat iteration", visited, 2500U);
+
+        for (auto it = map2.begin(); it != map2.end();)
+        {
+            if (it->first % 4 == 1)
+                it = map2.erase(it);
+            else
+                ++it;
+        }
+        test_eq("flat erase by iterator", map2.size(), 1250U);
+
+        auto map3 = map2;
+        test_eq("flat copy", map3 == map2, true);
+
+        auto map4 = std::move(map3);
+        test_eq("flat move pt1", map4 == map2, true);
+        test_eq("flat move pt2", map3.size(), 0U);
+
+        map4.rehash(16384);
+        test_eq("flat rehash pt1", map4.capacity(), 16384U);
+        test_eq("flat rehash pt2", map4 == map2, true);
+
+        map4.clear();
+        test_eq("flat clear", map4.empty(), true);
+        test_eq("flat clear find", map4.find(3), map4.end());
+    }
+
+    void unordered_map_test::bench_maps()
+    {
+        constexpr std::size_t count{20000};
+
+        std::vector<int> keys(count);
+        std::uint32_t seed{42};
+        for (auto& x: keys)
+        {
+            seed = seed * 1103515245u + 12345u;
+            x = static_cast<int>(seed >> 8);
+        }
+
+        /**
+         * Each map gets the same sequence of inserts,
+         * successful lookups and erasures.
+         */
+        auto measure = [&keys](auto& map){
+            auto start = std::chrono::steady_clock::now();
+
+            for (auto key: keys)
+                map[key] = key;
+
+            std::size_t hits{};
+            for (int round = 0; round < 4; ++round)
+            {
+                for (auto key: keys)
+                    hits += map.count(key);
+            }
+
+            for (std::size_t i = 0; i < keys.size(); i += 2)
+                map.erase(keys[i]);
+
+            auto end = std::chrono::steady_clock::now();
+
+            return std::make_pair(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    end - start
+                ).count(),
+                hits
+            );
+        };
+
+        std::unordered_map<int, int> unordered{};
+        helenos::flat_hash_map<int, int> flat{};
+
+        auto unordered_res = measure(unordered);
+        auto flat_res = measure(flat);
+
+        if (report_)
+        {
+            std::printf(
+                "[%s][map benchmark] %zu keys: unordered_map %lld us, "
+                "flat_hash_map %lld us\n", name(), count,
+                (long long)unordered_res.first, (long long)flat_res.first
+            );
+        }
+
+        test_eq("map benchmark pt1", unordered_res.second, flat_res.second);
+        test_eq("map benchmark pt2", unordered.size(), flat.size());
+    }
 }
@@ -29,6 +29,7 @@
 #include <__bits/test/tests.hpp>
 #include <algorithm>
 #include <initializer_list>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -42,6 +43,7 @@ namespace std::test
         test_construction_and_assignment();
         test_insert();
         test_erase();
+        test_reallocation();
 
         return end();
     }
@@ -227,4 +229,35 @@ namespace std::test
             check3.begin(), check3.end()
         );
     }
+
+    void vector_test::test_reallocation()
+    {
+        std::vector<std::string> vec1{};
+        for (int i = 0; i < 40; ++i)
+            vec1.push_back(std::string(i, 'a'));
+
+        bool ok{true};
+        for (int i = 0; i < 40; ++i)
+            ok = ok && vec1[i] == std::string(i, 'a');
+        test("growth keeps elements", ok);
+
+        // Elements are moved on growth, so long strings keep their buffers.
+        auto data1 = vec1[39].data();
+        vec1.reserve(vec1.capacity() + 1);
+        test_eq("growth moves elements", vec1[39].data(), data1);
+
+        vec1.insert(vec1.begin(), std::string{"first"});
+        test_eq("insert front pt1", vec1.size(), 41ul);
+        test_eq("insert front pt2", vec1[0], std::string{"first"});
+        test_eq("insert front pt3", vec1[40], std::string(39, 'a'));
+
+        auto& res1 = vec1.emplace_back(3, 'z');
+        test_eq("emplace_back pt1", vec1.size(), 42ul);
+        test_eq("emplace_back pt2", res1, std::string{"zzz"});
+
+        vec1.resize(2);
+        vec1.shrink_to_fit();
+        test_eq("shrink_to_fit pt1", vec1.capacity(), 2ul);
+        test_eq("shrink_to_fit pt2", vec1[1], std::string{});
+    }
 }
@@ -97,7 +97,8 @@ namespace std
 
         if (joinable_wrapper_)
         {
-            joinable_wrapper_->detach();
+            if (joinable_wrapper_->detach())
+                delete joinable_wrapper_;
             joinable_wrapper_ = nullptr;
         }
     }
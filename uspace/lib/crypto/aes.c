@@ -30,11 +30,15 @@
  *
  * Implementation of AES-128 symmetric cipher cryptographic algorithm.
  *
- * Based on FIPS 197.
+ * Based on FIPS 197. Uses precomputed key schedules and table lookups
+ * combining the sub bytes and mix columns transformations; on amd64
+ * the AES instructions are used if the processor supports them.
+ * Counter (CTR) and CCM modes process whole buffers.
  */
 
 #include <stdbool.h>
 #include <errno.h>
+#include <macros.h>
 #include <mem.h>
 #include "crypto.h"
 
@@ -48,14 +52,7 @@
 #define BLOCK_LEN  16
 
 /* Number of iterations in AES algorithm. */
-#define ROUNDS  10
-
-/** Irreducible polynomial used in AES algorithm.
- *
- * NOTE: x^8 + x^4 + x^3 + x + 1.
- *
- */
-#define AES_IP  0x1b
+#define ROUNDS  AES_ROUNDS
 
 /** Precomputed values for AES sub_byte transformation. */
 static const uint8_t sbox[BLOCK_LEN][BLOCK_LEN] = {
@@ -126,7 +123,7 @@ static const uint8_t sbox[BLOCK_LEN][BLOCK_LEN] = {
 };
 
 /** Precomputed values for AES inv_sub_byte transformation. */
-static uint8_t inv_sbox[BLOCK_LEN][BLOCK_LEN] = {
+static const uint8_t inv_sbox[BLOCK_LEN][BLOCK_LEN] = {
 	{
 		0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38,
 		0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb
@@ -193,258 +190,898 @@ static uint8_t inv_sbox[BLOCK_LEN][BLOCK_LEN] = {
 	}
 };
 
-/** Precomputed values of powers of 2 in GF(2^8) left shifted by 24b. */
-static const uint32_t r_con_array[] = {
-	0x01000000, 0x02000000, 0x04000000, 0x08000000,
-	0x10000000, 0x20000000, 0x40000000, 0x80000000,
-	0x1b000000, 0x36000000
+/** Round constants (powers of 2 in GF(2^8)). */
+static const uint8_t r_con_array[ROUNDS] = {
+	0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36
 };
 
-/** Perform substitution transformation on given byte.
+/** Precomputed sub bytes and mix columns transformation of a column.
+ *
+ * Columns are stored with row 0 in the least significant byte, the
+ * table is for a byte in row 0, rows 1-3 use the value rotated left
+ * by 1-3 bytes.
+ *
+ */
+static const uint32_t te[256] = {
+	0xa56363c6, 0x847c7cf8, 0x997777ee, 0x8d7b7bf6,
+	0x0df2f2ff, 0xbd6b6bd6, 0xb16f6fde, 0x54c5c591,
+	0x50303060, 0x03010102, 0xa96767ce, 0x7d2b2b56,
+	0x19fefee7, 0x62d7d7b5, 0xe6abab4d, 0x9a7676ec,
+	0x45caca8f, 0x9d82821f, 0x40c9c989, 0x877d7dfa,
+	0x15fafaef, 0xeb5959b2, 0xc947478e, 0x0bf0f0fb,
+	0xecadad41, 0x67d4d4b3, 0xfda2a25f, 0xeaafaf45,
+	0xbf9c9c23, 0xf7a4a453, 0x967272e4, 0x5bc0c09b,
+	0xc2b7b775, 0x1cfdfde1, 0xae93933d, 0x6a26264c,
+	0x5a36366c, 0x413f3f7e, 0x02f7f7f5, 0x4fcccc83,
+	0x5c343468, 0xf4a5a551, 0x34e5e5d1, 0x08f1f1f9,
+	0x937171e2, 0x73d8d8ab, 0x53313162, 0x3f15152a,
+	0x0c040408, 0x52c7c795, 0x65232346, 0x5ec3c39d,
+	0x28181830, 0xa1969637, 0x0f05050a, 0xb59a9a2f,
+	0x0907070e, 0x36121224, 0x9b80801b, 0x3de2e2df,
+	0x26ebebcd, 0x6927274e, 0xcdb2b27f, 0x9f7575ea,
+	0x1b090912, 0x9e83831d, 0x742c2c58, 0x2e1a1a34,
+	0x2d1b1b36, 0xb26e6edc, 0xee5a5ab4, 0xfba0a05b,
+	0xf65252a4, 0x4d3b3b76, 0x61d6d6b7, 0xceb3b37d,
+	0x7b292952, 0x3ee3e3dd, 0x712f2f5e, 0x97848413,
+	0xf55353a6, 0x68d1d1b9, 0x00000000, 0x2cededc1,
+	0x60202040, 0x1ffcfce3, 0xc8b1b179, 0xed5b5bb6,
+	0xbe6a6ad4, 0x46cbcb8d, 0xd9bebe67, 0x4b393972,
+	0xde4a4a94, 0xd44c4c98, 0xe85858b0, 0x4acfcf85,
+	0x6bd0d0bb, 0x2aefefc5, 0xe5aaaa4f, 0x16fbfbed,
+	0xc5434386, 0xd74d4d9a, 0x55333366, 0x94858511,
+	0xcf45458a, 0x10f9f9e9, 0x06020204, 0x817f7ffe,
+	0xf05050a0, 0x443c3c78, 0xba9f9f25, 0xe3a8a84b,
+	0xf35151a2, 0xfea3a35d, 0xc0404080, 0x8a8f8f05,
+	0xad92923f, 0xbc9d9d21, 0x48383870, 0x04f5f5f1,
+	0xdfbcbc63, 0xc1b6b677, 0x75dadaaf, 0x63212142,
+	0x30101020, 0x1affffe5, 0x0ef3f3fd, 0x6dd2d2bf,
+	0x4ccdcd81, 0x140c0c18, 0x35131326, 0x2fececc3,
+	0xe15f5fbe, 0xa2979735, 0xcc444488, 0x3917172e,
+	0x57c4c493, 0xf2a7a755, 0x827e7efc, 0x473d3d7a,
+	0xac6464c8, 0xe75d5dba, 0x2b191932, 0x957373e6,
+	0xa06060c0, 0x98818119, 0xd14f4f9e, 0x7fdcdca3,
+	0x66222244, 0x7e2a2a54, 0xab90903b, 0x8388880b,
+	0xca46468c, 0x29eeeec7, 0xd3b8b86b, 0x3c141428,
+	0x79dedea7, 0xe25e5ebc, 0x1d0b0b16, 0x76dbdbad,
+	0x3be0e0db, 0x56323264, 0x4e3a3a74, 0x1e0a0a14,
+	0xdb494992, 0x0a06060c, 0x6c242448, 0xe45c5cb8,
+	0x5dc2c29f, 0x6ed3d3bd, 0xefacac43, 0xa66262c4,
+	0xa8919139, 0xa4959531, 0x37e4e4d3, 0x8b7979f2,
+	0x32e7e7d5, 0x43c8c88b, 0x5937376e, 0xb76d6dda,
+	0x8c8d8d01, 0x64d5d5b1, 0xd24e4e9c, 0xe0a9a949,
+	0xb46c6cd8, 0xfa5656ac, 0x07f4f4f3, 0x25eaeacf,
+	0xaf6565ca, 0x8e7a7af4, 0xe9aeae47, 0x18080810,
+	0xd5baba6f, 0x887878f0, 0x6f25254a, 0x722e2e5c,
+	0x241c1c38, 0xf1a6a657, 0xc7b4b473, 0x51c6c697,
+	0x23e8e8cb, 0x7cdddda1, 0x9c7474e8, 0x211f1f3e,
+	0xdd4b4b96, 0xdcbdbd61, 0x868b8b0d, 0x858a8a0f,
+	0x907070e0, 0x423e3e7c, 0xc4b5b571, 0xaa6666cc,
+	0xd8484890, 0x05030306, 0x01f6f6f7, 0x120e0e1c,
+	0xa36161c2, 0x5f35356a, 0xf95757ae, 0xd0b9b969,
+	0x91868617, 0x58c1c199, 0x271d1d3a, 0xb99e9e27,
+	0x38e1e1d9, 0x13f8f8eb, 0xb398982b, 0x33111122,
+	0xbb6969d2, 0x70d9d9a9, 0x898e8e07, 0xa7949433,
+	0xb69b9b2d, 0x221e1e3c, 0x92878715, 0x20e9e9c9,
+	0x49cece87, 0xff5555aa, 0x78282850, 0x7adfdfa5,
+	0x8f8c8c03, 0xf8a1a159, 0x80898909, 0x170d0d1a,
+	0xdabfbf65, 0x31e6e6d7, 0xc6424284, 0xb86868d0,
+	0xc3414182, 0xb0999929, 0x772d2d5a, 0x110f0f1e,
+	0xcbb0b07b, 0xfc5454a8, 0xd6bbbb6d, 0x3a16162c
+};
+
+/** Precomputed inverse sub bytes and inverse mix columns transformation.
+ *
+ * Same layout as @c te.
+ *
+ */
+static const uint32_t td[256] = {
+	0x50a7f451, 0x5365417e, 0xc3a4171a, 0x965e273a,
+	0xcb6bab3b, 0xf1459d1f, 0xab58faac, 0x9303e34b,
+	0x55fa3020, 0xf66d76ad, 0x9176cc88, 0x254c02f5,
+	0xfcd7e54f, 0xd7cb2ac5, 0x80443526, 0x8fa362b5,
+	0x495ab1de, 0x671bba25, 0x980eea45, 0xe1c0fe5d,
+	0x02752fc3, 0x12f04c81, 0xa397468d, 0xc6f9d36b,
+	0xe75f8f03, 0x959c9215, 0xeb7a6dbf, 0xda595295,
+	0x2d83bed4, 0xd3217458, 0x2969e049, 0x44c8c98e,
+	0x6a89c275, 0x78798ef4, 0x6b3e5899, 0xdd71b927,
+	0xb64fe1be, 0x17ad88f0, 0x66ac20c9, 0xb43ace7d,
+	0x184adf63, 0x82311ae5, 0x60335197, 0x457f5362,
+	0xe07764b1, 0x84ae6bbb, 0x1ca081fe, 0x942b08f9,
+	0x58684870, 0x19fd458f, 0x876cde94, 0xb7f87b52,
+	0x23d373ab, 0xe2024b72, 0x578f1fe3, 0x2aab5566,
+	0x0728ebb2, 0x03c2b52f, 0x9a7bc586, 0xa50837d3,
+	0xf2872830, 0xb2a5bf23, 0xba6a0302, 0x5c8216ed,
+	0x2b1ccf8a, 0x92b479a7, 0xf0f207f3, 0xa1e2694e,
+	0xcdf4da65, 0xd5be0506, 0x1f6234d1, 0x8afea6c4,
+	0x9d532e34, 0xa055f3a2, 0x32e18a05, 0x75ebf6a4,
+	0x39ec830b, 0xaaef6040, 0x069f715e, 0x51106ebd,
+	0xf98a213e, 0x3d06dd96, 0xae053edd, 0x46bde64d,
+	0xb58d5491, 0x055dc471, 0x6fd40604, 0xff155060,
+	0x24fb9819, 0x97e9bdd6, 0xcc434089, 0x779ed967,
+	0xbd42e8b0, 0x888b8907, 0x385b19e7, 0xdbeec879,
+	0x470a7ca1, 0xe90f427c, 0xc91e84f8, 0x00000000,
+	0x83868009, 0x48ed2b32, 0xac70111e, 0x4e725a6c,
+	0xfbff0efd, 0x5638850f, 0x1ed5ae3d, 0x27392d36,
+	0x64d90f0a, 0x21a65c68, 0xd1545b9b, 0x3a2e3624,
+	0xb1670a0c, 0x0fe75793, 0xd296eeb4, 0x9e919b1b,
+	0x4fc5c080, 0xa220dc61, 0x694b775a, 0x161a121c,
+	0x0aba93e2, 0xe52aa0c0, 0x43e0223c, 0x1d171b12,
+	0x0b0d090e, 0xadc78bf2, 0xb9a8b62d, 0xc8a91e14,
+	0x8519f157, 0x4c0775af, 0xbbdd99ee, 0xfd607fa3,
+	0x9f2601f7, 0xbcf5725c, 0xc53b6644, 0x347efb5b,
+	0x7629438b, 0xdcc623cb, 0x68fcedb6, 0x63f1e4b8,
+	0xcadc31d7, 0x10856342, 0x40229713, 0x2011c684,
+	0x7d244a85, 0xf83dbbd2, 0x1132f9ae, 0x6da129c7,
+	0x4b2f9e1d, 0xf330b2dc, 0xec52860d, 0xd0e3c177,
+	0x6c16b32b, 0x99b970a9, 0xfa489411, 0x2264e947,
+	0xc48cfca8, 0x1a3ff0a0, 0xd82c7d56, 0xef903322,
+	0xc74e4987, 0xc1d138d9, 0xfea2ca8c, 0x360bd498,
+	0xcf81f5a6, 0x28de7aa5, 0x268eb7da, 0xa4bfad3f,
+	0xe49d3a2c, 0x0d927850, 0x9bcc5f6a, 0x62467e54,
+	0xc2138df6, 0xe8b8d890, 0x5ef7392e, 0xf5afc382,
+	0xbe805d9f, 0x7c93d069, 0xa92dd56f, 0xb31225cf,
+	0x3b99acc8, 0xa77d1810, 0x6e639ce8, 0x7bbb3bdb,
+	0x097826cd, 0xf418596e, 0x01b79aec, 0xa89a4f83,
+	0x656e95e6, 0x7ee6ffaa, 0x08cfbc21, 0xe6e815ef,
+	0xd99be7ba, 0xce366f4a, 0xd4099fea, 0xd67cb029,
+	0xafb2a431, 0x31233f2a, 0x3094a5c6, 0xc066a235,
+	0x37bc4e74, 0xa6ca82fc, 0xb0d090e0, 0x15d8a733,
+	0x4a9804f1, 0xf7daec41, 0x0e50cd7f, 0x2ff69117,
+	0x8dd64d76, 0x4db0ef43, 0x544daacc, 0xdf0496e4,
+	0xe3b5d19e, 0x1b886a4c, 0xb81f2cc1, 0x7f516546,
+	0x04ea5e9d, 0x5d358c01, 0x737487fa, 0x2e410bfb,
+	0x5a1d67b3, 0x52d2db92, 0x335610e9, 0x1347d66d,
+	0x8c61d79a, 0x7a0ca137, 0x8e14f859, 0x893c13eb,
+	0xee27a9ce, 0x35c961b7, 0xede51ce1, 0x3cb1477a,
+	0x59dfd29c, 0x3f73f255, 0x79ce1418, 0xbf37c773,
+	0xeacdf753, 0x5baafd5f, 0x146f3ddf, 0x86db4478,
+	0x81f3afca, 0x3ec468b9, 0x2c342438, 0x5f40a3c2,
+	0x72c31d16, 0x0c25e2bc, 0x8b493c28, 0x41950dff,
+	0x7101a839, 0xdeb30c08, 0x9ce4b4d8, 0x90c15664,
+	0x6184cb7b, 0x70b632d5, 0x745c6c48, 0x4257b8d0
+};
+
+/** Substitute byte.
  *
  * @param byte Input byte.
- * @param inv  Flag indicating whether to use inverse table.
  *
  * @return Substituted value.
  *
  */
-static uint8_t sub_byte(uint8_t byte, bool inv)
+static inline uint8_t sub_byte(uint8_t byte)
 {
-	uint8_t i = byte >> 4;
-	uint8_t j = byte & 0xF;
+	return sbox[byte >> 4][byte & 0xf];
+}
 
-	if (!inv)
-		return sbox[i][j];
+/** Substitute byte using the inverse table.
+ *
+ * @param byte Input byte.
+ *
+ * @return Substituted value.
+ *
+ */
+static inline uint8_t inv_sub_byte(uint8_t byte)
+{
+	return inv_sbox[byte >> 4][byte & 0xf];
+}
 
-	return inv_sbox[i][j];
+/** Get byte of a column.
+ *
+ * @param col Column.
+ * @param row Row (0 to 3).
+ *
+ * @return Byte in the given row.
+ *
+ */
+static inline uint8_t col_byte(uint32_t col, unsigned row)
+{
+	return (uint8_t) (col >> (8 * row));
 }
 
-/** Perform substitution transformation on state table.
+/** Load column from memory (row 0 first).
+ *
+ * @param data Data.
  *
- * @param state State table to be modified.
- * @param inv   Flag indicating whether to use inverse table.
+ * @return Column.
  *
  */
-static void sub_bytes(uint8_t state[ELEMS][ELEMS], bool inv)
+static inline uint32_t load_col(const uint8_t *data)
 {
-	uint8_t val;
+	return ((uint32_t) data[0]) | ((uint32_t) data[1] << 8) |
+	    ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+/** Store column to memory (row 0 first).
+ *
+ * @param col  Column.
+ * @param data Data.
+ *
+ */
+static inline void store_col(uint32_t col, uint8_t *data)
+{
+	data[0] = (uint8_t) col;
+	data[1] = (uint8_t) (col >> 8);
+	data[2] = (uint8_t) (col >> 16);
+	data[3] = (uint8_t) (col >> 24);
+}
+
+/** Perform substitution transformation on given word.
+ *
+ * @param word Input word.
+ *
+ * @return Substituted word.
+ *
+ */
+static uint32_t sub_word(uint32_t word)
+{
+	return ((uint32_t) sub_byte(col_byte(word, 0))) |
+	    ((uint32_t) sub_byte(col_byte(word, 1)) << 8) |
+	    ((uint32_t) sub_byte(col_byte(word, 2)) << 16) |
+	    ((uint32_t) sub_byte(col_byte(word, 3)) << 24);
+}
+
+/** Perform inverse mix columns transformation on given column.
+ *
+ * @param col Input column.
+ *
+ * @return Transformed column.
+ *
+ */
+static uint32_t inv_mix_column(uint32_t col)
+{
+	/* The inverse table includes inverse substitution, undo it */
+	return td[sub_byte(col_byte(col, 0))] ^
+	    rotl_uint32(td[sub_byte(col_byte(col, 1))], 8) ^
+	    rotl_uint32(td[sub_byte(col_byte(col, 2))], 16) ^
+	    rotl_uint32(td[sub_byte(col_byte(col, 3))], 24);
+}
+
+#ifdef __x86_64__
 
-	for (size_t i = 0; i < ELEMS; i++) {
+/** Determine whether the processor supports AES-NI.
+ *
+ * @return True if AES instructions are available.
+ *
+ */
+static bool aesni_available(void)
+{
+	uint32_t eax = 1;
+	uint32_t ebx, ecx, edx;
+
+	asm volatile (
+	    "cpuid\n"
+	    : "+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx)
+	);
+
+	/* CPUID.01H:ECX.AES[bit 25] */
+	return (ecx & (1 << 25)) != 0;
+}
+
+/** Encrypt up to four blocks using AES-NI.
+ *
+ * The blocks are processed in parallel to hide instruction latency.
+ *
+ * @param ctx    AES context.
+ * @param input  Data to be encrypted.
+ * @param output Encrypted data.
+ * @param blocks Number of blocks (1 to 4).
+ *
+ */
+static void aesni_encrypt(const aes_ctx_t *ctx, const uint8_t *input,
+    uint8_t *output, size_t blocks)
+{
+	const uint32_t *rk = ctx->enc_key;
+
+	if (blocks == 4) {
+		asm volatile (
+		    "movdqu (%[rk]), %%xmm4\n"
+		    "movdqu (%[in]), %%xmm0\n"
+		    "movdqu 16(%[in]), %%xmm1\n"
+		    "movdqu 32(%[in]), %%xmm2\n"
+		    "movdqu 48(%[in]), %%xmm3\n"
+		    "pxor %%xmm4, %%xmm0\n"
+		    "pxor %%xmm4, %%xmm1\n"
+		    "pxor %%xmm4, %%xmm2\n"
+		    "pxor %%xmm4, %%xmm3\n"
+		    "mov $1, %%ecx\n"
+		    "1:\n"
+		    "add $16, %[rk]\n"
+		    "movdqu (%[rk]), %%xmm4\n"
+		    "aesenc %%xmm4, %%xmm0\n"
+		    "aesenc %%xmm4, %%xmm1\n"
+		    "aesenc %%xmm4, %%xmm2\n"
+		    "aesenc %%xmm4, %%xmm3\n"
+		    "inc %%ecx\n"
+		    "cmp $10, %%ecx\n"
+		    "jb 1b\n"
+		    "movdqu 16(%[rk]), %%xmm4\n"
+		    "aesenclast %%xmm4, %%xmm0\n"
+		    "aesenclast %%xmm4, %%xmm1\n"
+		    "aesenclast %%xmm4, %%xmm2\n"
+		    "aesenclast %%xmm4, %%xmm3\n"
+		    "movdqu %%xmm0, (%[out])\n"
+		    "movdqu %%xmm1, 16(%[out])\n"
+		    "movdqu %%xmm2, 32(%[out])\n"
+		    "movdqu %%xmm3, 48(%[out])\n"
+		    : [rk] "+r" (rk)
+		    : [in] "r" (input), [out] "r" (output)
+		    : "ecx", "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "cc",
+		      "memory"
+		);
+		return;
+	}
+
+	for (size_t i = 0; i < blocks; i++) {
+		rk = ctx->enc_key;
+
+		asm volatile (
+		    "movdqu (%[rk]), %%xmm4\n"
+		    "movdqu (%[in]), %%xmm0\n"
+		    "pxor %%xmm4, %%xmm0\n"
+		    "mov $1, %%ecx\n"
+		    "1:\n"
+		    "add $16, %[rk]\n"
+		    "movdqu (%[rk]), %%xmm4\n"
+		    "aesenc %%xmm4, %%xmm0\n"
+		    "inc %%ecx\n"
+		    "cmp $10, %%ecx\n"
+		    "jb 1b\n"
+		    "movdqu 16(%[rk]), %%xmm4\n"
+		    "aesenclast %%xmm4, %%xmm0\n"
+		    "movdqu %%xmm0, (%[out])\n"
+		    : [rk] "+r" (rk)
+		    : [in] "r" (input + i * BLOCK_LEN),
+		      [out] "r" (output + i * BLOCK_LEN)
+		    : "ecx", "xmm0", "xmm4", "cc", "memory"
+		);
+	}
+}
+
+/** Decrypt one block using AES-NI.
+ *
+ * @param ctx    AES context.
+ * @param input  Data to be decrypted.
+ * @param output Decrypted data.
+ *
+ */
+static void aesni_decrypt(const aes_ctx_t *ctx, const uint8_t *input,
+    uint8_t *output)
+{
+	const uint32_t *rk = ctx->dec_key;
+
+	asm volatile (
+	    "movdqu (%[rk]), %%xmm4\n"
+	    "movdqu (%[in]), %%xmm0\n"
+	    "pxor %%xmm4, %%xmm0\n"
+	    "mov $1, %%ecx\n"
+	    "1:\n"
+	    "add $16, %[rk]\n"
+	    "movdqu (%[rk]), %%xmm4\n"
+	    "aesdec %%xmm4, %%xmm0\n"
+	    "inc %%ecx\n"
+	    "cmp $10, %%ecx\n"
+	    "jb 1b\n"
+	    "movdqu 16(%[rk]), %%xmm4\n"
+	    "aesdeclast %%xmm4, %%xmm0\n"
+	    "movdqu %%xmm0, (%[out])\n"
+	    : [rk] "+r" (rk)
+	    : [in] "r" (input), [out] "r" (output)
+	    : "ecx", "xmm0", "xmm4", "cc", "memory"
+	);
+}
+
+#endif
+
+/** Initialize AES-128 context.
+ *
+ * Expand the key into the encryption and decryption key schedules,
+ * so that they need not be computed for every block.
+ *
+ * @param ctx AES context.
+ * @param key Key (AES_CIPHER_LENGTH bytes).
+ *
+ * @return EINVAL when key is not specified, otherwise EOK.
+ *
+ */
+errno_t aes_init(aes_ctx_t *ctx, const uint8_t *key)
+{
+	uint32_t *ek = ctx->enc_key;
+	uint32_t *dk = ctx->dec_key;
+	uint32_t temp;
+
+	if (!key)
+		return EINVAL;
+
+	for (size_t i = 0; i < CIPHER_ELEMS; i++)
+		ek[i] = load_col(key + 4 * i);
+
+	for (size_t i = CIPHER_ELEMS; i < AES_KEY_WORDS; i++) {
+		temp = ek[i - 1];
+
+		if ((i % CIPHER_ELEMS) == 0) {
+			temp = sub_word(rotr_uint32(temp, 8)) ^
+			    r_con_array[i / CIPHER_ELEMS - 1];
+		}
+
+		ek[i] = ek[i - CIPHER_ELEMS] ^ temp;
+	}
+
+	/*
+	 * Decryption key schedule for the equivalent inverse cipher:
+	 * round keys in reverse order, with inverse mix columns applied
+	 * to all but the first and the last one.
+	 */
+	for (size_t k = 0; k <= ROUNDS; k++) {
 		for (size_t j = 0; j < ELEMS; j++) {
-			val = state[i][j];
-			state[i][j] = sub_byte(val, inv);
+			temp = ek[(ROUNDS - k) * ELEMS + j];
+			if (k > 0 && k < ROUNDS)
+				temp = inv_mix_column(temp);
+			dk[k * ELEMS + j] = temp;
 		}
 	}
+
+#ifdef __x86_64__
+	ctx->aesni = aesni_available();
+#else
+	ctx->aesni = false;
+#endif
+	return EOK;
 }
 
-/** Perform shift rows transformation on state table.
+/** Compute column of the state after an encryption round.
+ *
+ * Shift rows: row n of column j comes from column j + n.
  *
- * @param state State table to be modified.
+ * @param s State (columns).
+ * @param j Column index.
+ *
+ * @return Column after sub bytes, shift rows and mix columns.
  *
  */
-static void shift_rows(uint8_t state[ELEMS][ELEMS])
+static inline uint32_t enc_round_col(const uint32_t *s, size_t j)
 {
-	uint8_t temp[ELEMS];
+	return te[col_byte(s[j], 0)] ^
+	    rotl_uint32(te[col_byte(s[(j + 1) % ELEMS], 1)], 8) ^
+	    rotl_uint32(te[col_byte(s[(j + 2) % ELEMS], 2)], 16) ^
+	    rotl_uint32(te[col_byte(s[(j + 3) % ELEMS], 3)], 24);
+}
 
-	for (size_t i = 1; i < ELEMS; i++) {
-		memcpy(temp, state[i], i);
-		memmove(state[i], state[i] + i, ELEMS - i);
-		memcpy(state[i] + ELEMS - i, temp, i);
-	}
+/** Compute column of the state after the last encryption round.
+ *
+ * @param s State (columns).
+ * @param j Column index.
+ *
+ * @return Column after sub bytes and shift rows.
+ *
+ */
+static inline uint32_t enc_last_col(const uint32_t *s, size_t j)
+{
+	return ((uint32_t) sub_byte(col_byte(s[j], 0))) |
+	    ((uint32_t) sub_byte(col_byte(s[(j + 1) % ELEMS], 1)) << 8) |
+	    ((uint32_t) sub_byte(col_byte(s[(j + 2) % ELEMS], 2)) << 16) |
+	    ((uint32_t) sub_byte(col_byte(s[(j + 3) % ELEMS], 3)) << 24);
+}
+
+/** Compute column of the state after a decryption round.
+ *
+ * Inverse shift rows: row n of column j comes from column j - n.
+ *
+ * @param s State (columns).
+ * @param j Column index.
+ *
+ * @return Column after inverse shift rows, sub bytes and mix columns
+ *         (the round key is mixed in the equivalent inverse cipher).
+ *
+ */
+static inline uint32_t dec_round_col(const uint32_t *s, size_t j)
+{
+	return td[col_byte(s[j], 0)] ^
+	    rotl_uint32(td[col_byte(s[(j + 3) % ELEMS], 1)], 8) ^
+	    rotl_uint32(td[col_byte(s[(j + 2) % ELEMS], 2)], 16) ^
+	    rotl_uint32(td[col_byte(s[(j + 1) % ELEMS], 3)], 24);
 }
 
-/** Perform inverted shift rows transformation on state table.
+/** Compute column of the state after the last decryption round.
  *
- * @param state State table to be modified.
+ * @param s State (columns).
+ * @param j Column index.
+ *
+ * @return Column after inverse shift rows and sub bytes.
  *
  */
-static void inv_shift_rows(uint8_t state[ELEMS][ELEMS])
+static inline uint32_t dec_last_col(const uint32_t *s, size_t j)
 {
-	uint8_t temp[ELEMS];
+	return ((uint32_t) inv_sub_byte(col_byte(s[j], 0))) |
+	    ((uint32_t) inv_sub_byte(col_byte(s[(j + 3) % ELEMS], 1)) << 8) |
+	    ((uint32_t) inv_sub_byte(col_byte(s[(j + 2) % ELEMS], 2)) << 16) |
+	    ((uint32_t) inv_sub_byte(col_byte(s[(j + 1) % ELEMS], 3)) << 24);
+}
+
+/** Encrypt block using software implementation.
+ *
+ * @param ctx    AES context.
+ * @param input  Data to be encrypted.
+ * @param output Encrypted data.
+ *
+ */
+static void aes_sw_encrypt(const aes_ctx_t *ctx, const uint8_t *input,
+    uint8_t *output)
+{
+	const uint32_t *rk = ctx->enc_key;
+	uint32_t s[ELEMS];
+	uint32_t t[ELEMS];
+
+	for (size_t j = 0; j < ELEMS; j++)
+		s[j] = load_col(input + 4 * j) ^ rk[j];
+
+	for (size_t k = 1; k < ROUNDS; k++) {
+		rk += ELEMS;
 
-	for (size_t i = 1; i < ELEMS; i++) {
-		memcpy(temp, state[i], ELEMS - i);
-		memmove(state[i], state[i] + ELEMS - i, i);
-		memcpy(state[i] + i, temp, ELEMS - i);
+		for (size_t j = 0; j < ELEMS; j++)
+			t[j] = enc_round_col(s, j) ^ rk[j];
+
+		memcpy(s, t, sizeof(s));
 	}
+
+	/* Last round without mix columns */
+	rk += ELEMS;
+	for (size_t j = 0; j < ELEMS; j++)
+		store_col(enc_last_col(s, j) ^ rk[j], output + 4 * j);
 }
 
-/** Multiplication in GF(2^8).
- *
- * @param x First factor.
- * @param y Second factor.
+/** Decrypt block using software implementation.
  *
- * @return Multiplication of given factors in GF(2^8).
+ * @param ctx    AES context.
+ * @param input  Data to be decrypted.
+ * @param output Decrypted data.
  *
  */
-static uint8_t galois_mult(uint8_t x, uint8_t y)
+static void aes_sw_decrypt(const aes_ctx_t *ctx, const uint8_t *input,
+    uint8_t *output)
 {
-	uint8_t result = 0;
-	uint8_t f_bith;
+	const uint32_t *rk = ctx->dec_key;
+	uint32_t s[ELEMS];
+	uint32_t t[ELEMS];
 
-	for (size_t i = 0; i < 8; i++) {
-		if (y & 1)
-			result ^= x;
+	for (size_t j = 0; j < ELEMS; j++)
+		s[j] = load_col(input + 4 * j) ^ rk[j];
 
-		f_bith = (x & 0x80);
-		x <<= 1;
+	for (size_t k = 1; k < ROUNDS; k++) {
+		rk += ELEMS;
 
-		if (f_bith)
-			x ^= AES_IP;
+		for (size_t j = 0; j < ELEMS; j++)
+			t[j] = dec_round_col(s, j) ^ rk[j];
 
-		y >>= 1;
+		memcpy(s, t, sizeof(s));
 	}
 
-	return result;
+	/* Last round without inverse mix columns */
+	rk += ELEMS;
+	for (size_t j = 0; j < ELEMS; j++)
+		store_col(dec_last_col(s, j) ^ rk[j], output + 4 * j);
 }
 
-/** Perform mix columns transformation on state table.
+/** Encrypt one block with AES-128.
  *
- * @param state State table to be modified.
+ * @param ctx    AES context.
+ * @param input  Data to be encrypted (AES_CIPHER_LENGTH bytes).
+ * @param output Encrypted data (may be the same as @a input).
  *
  */
-static void mix_columns(uint8_t state[ELEMS][ELEMS])
+void aes_encrypt_block(const aes_ctx_t *ctx, const uint8_t *input,
+    uint8_t *output)
 {
-	uint8_t orig_state[ELEMS][ELEMS];
-	memcpy(orig_state, state, BLOCK_LEN);
-
-	for (size_t j = 0; j < ELEMS; j++) {
-		state[0][j] =
-		    galois_mult(0x2, orig_state[0][j]) ^
-		    galois_mult(0x3, orig_state[1][j]) ^
-		    orig_state[2][j] ^
-		    orig_state[3][j];
-		state[1][j] =
-		    orig_state[0][j] ^
-		    galois_mult(0x2, orig_state[1][j]) ^
-		    galois_mult(0x3, orig_state[2][j]) ^
-		    orig_state[3][j];
-		state[2][j] =
-		    orig_state[0][j] ^
-		    orig_state[1][j] ^
-		    galois_mult(0x2, orig_state[2][j]) ^
-		    galois_mult(0x3, orig_state[3][j]);
-		state[3][j] =
-		    galois_mult(0x3, orig_state[0][j]) ^
-		    orig_state[1][j] ^
-		    orig_state[2][j] ^
-		    galois_mult(0x2, orig_state[3][j]);
+#ifdef __x86_64__
+	if (ctx->aesni) {
+		aesni_encrypt(ctx, input, output, 1);
+		return;
 	}
+#endif
+
+	aes_sw_encrypt(ctx, input, output);
 }
 
-/** Perform inverted mix columns transformation on state table.
+/** Decrypt one block with AES-128.
  *
- * @param state State table to be modified.
+ * @param ctx    AES context.
+ * @param input  Data to be decrypted (AES_CIPHER_LENGTH bytes).
+ * @param output Decrypted data (may be the same as @a input).
  *
  */
-static void inv_mix_columns(uint8_t state[ELEMS][ELEMS])
+void aes_decrypt_block(const aes_ctx_t *ctx, const uint8_t *input,
+    uint8_t *output)
 {
-	uint8_t orig_state[ELEMS][ELEMS];
-	memcpy(orig_state, state, BLOCK_LEN);
-
-	for (size_t j = 0; j < ELEMS; j++) {
-		state[0][j] =
-		    galois_mult(0x0e, orig_state[0][j]) ^
-		    galois_mult(0x0b, orig_state[1][j]) ^
-		    galois_mult(0x0d, orig_state[2][j]) ^
-		    galois_mult(0x09, orig_state[3][j]);
-		state[1][j] =
-		    galois_mult(0x09, orig_state[0][j]) ^
-		    galois_mult(0x0e, orig_state[1][j]) ^
-		    galois_mult(0x0b, orig_state[2][j]) ^
-		    galois_mult(0x0d, orig_state[3][j]);
-		state[2][j] =
-		    galois_mult(0x0d, orig_state[0][j]) ^
-		    galois_mult(0x09, orig_state[1][j]) ^
-		    galois_mult(0x0e, orig_state[2][j]) ^
-		    galois_mult(0x0b, orig_state[3][j]);
-		state[3][j] =
-		    galois_mult(0x0b, orig_state[0][j]) ^
-		    galois_mult(0x0d, orig_state[1][j]) ^
-		    galois_mult(0x09, orig_state[2][j]) ^
-		    galois_mult(0x0e, orig_state[3][j]);
+#ifdef __x86_64__
+	if (ctx->aesni) {
+		aesni_decrypt(ctx, input, output);
+		return;
 	}
+#endif
+
+	aes_sw_decrypt(ctx, input, output);
 }
 
-/** Perform round key transformation on state table.
+/** Increment counter block (as a 128-bit big-endian number).
  *
- * @param state     State table to be modified.
- * @param round_key Round key to be applied on state table.
+ * @param ctr Counter block.
  *
  */
-static void add_round_key(uint8_t state[ELEMS][ELEMS], uint32_t *round_key)
+static void ctr_increment(uint8_t *ctr)
 {
-	uint8_t byte_round;
-	uint8_t shift;
-	uint32_t mask = 0xff;
-
-	for (size_t j = 0; j < ELEMS; j++) {
-		for (size_t i = 0; i < ELEMS; i++) {
-			shift = 24 - 8 * i;
-			byte_round = (round_key[j] & (mask << shift)) >> shift;
-			state[i][j] = state[i][j] ^ byte_round;
-		}
+	for (int i = BLOCK_LEN - 1; i >= 0; i--) {
+		if (++ctr[i] != 0)
+			break;
 	}
 }
 
-/** Perform substitution transformation on given word.
+/** Encrypt or decrypt data with AES-128 in counter mode.
  *
- * @param byte Input word.
+ * The key stream is generated by encrypting successive values of the
+ * counter block. Up to four blocks are encrypted at once.
  *
- * @return Substituted word.
+ * @param ctx    AES context.
+ * @param ctr    Counter block (AES_CIPHER_LENGTH bytes), on return it
+ *               is advanced past the last block used.
+ * @param input  Input data.
+ * @param output Output data (may be the same as @a input).
+ * @param length Length of data in bytes.
  *
  */
-static uint32_t sub_word(uint32_t word)
+void aes_ctr(const aes_ctx_t *ctx, uint8_t *ctr, const uint8_t *input,
+    uint8_t *output, size_t length)
 {
-	uint32_t temp = word;
-	uint8_t *start = (uint8_t *) &temp;
+	uint8_t blocks[AES_CTR_BLOCKS * BLOCK_LEN];
+	uint8_t stream[AES_CTR_BLOCKS * BLOCK_LEN];
+	size_t nblocks;
+	size_t n;
 
-	for (size_t i = 0; i < 4; i++)
-		*(start + i) = sub_byte(*(start + i), false);
+	while (length > 0) {
+		nblocks = min((length + BLOCK_LEN - 1) / BLOCK_LEN,
+		    (size_t) AES_CTR_BLOCKS);
 
-	return temp;
+		for (size_t i = 0; i < nblocks; i++) {
+			memcpy(blocks + i * BLOCK_LEN, ctr, BLOCK_LEN);
+			ctr_increment(ctr);
+		}
+
+#ifdef __x86_64__
+		if (ctx->aesni) {
+			aesni_encrypt(ctx, blocks, stream, nblocks);
+		} else
+#endif
+		{
+			for (size_t i = 0; i < nblocks; i++) {
+				aes_sw_encrypt(ctx, blocks + i * BLOCK_LEN,
+				    stream + i * BLOCK_LEN);
+			}
+		}
+
+		n = min(length, nblocks * BLOCK_LEN);
+		for (size_t i = 0; i < n; i++)
+			output[i] = input[i] ^ stream[i];
+
+		input += n;
+		output += n;
+		length -= n;
+	}
 }
 
-/** Perform left rotation by one byte on given word.
+/** Add data to CBC-MAC.
  *
- * @param byte Input word.
+ * The data is padded with zeroes to whole blocks.
  *
- * @return Rotated word.
+ * @param ctx    AES context.
+ * @param mac    Current MAC value.
+ * @param data   Data.
+ * @param length Length of data in bytes.
  *
  */
-static uint32_t rot_word(uint32_t word)
+static void cbc_mac(const aes_ctx_t *ctx, uint8_t *mac, const uint8_t *data,
+    size_t length)
 {
-	return (word << 8 | word >> 24);
+	size_t n;
+
+	while (length > 0) {
+		n = min(length, (size_t) BLOCK_LEN);
+		for (size_t i = 0; i < n; i++)
+			mac[i] ^= data[i];
+
+		aes_encrypt_block(ctx, mac, mac);
+		data += n;
+		length -= n;
+	}
 }
 
-/** Key expansion procedure for AES algorithm.
+/** Compute CCM authentication tag.
  *
- * @param key     Input key.
- * @param key_exp Result key expansion.
+ * @param ctx       AES context.
+ * @param nonce     Nonce.
+ * @param nonce_len Nonce length (7 to 13 bytes).
+ * @param aad       Additional authenticated data.
+ * @param aad_len   Length of additional authenticated data.
+ * @param data      Plain text.
+ * @param length    Length of plain text.
+ * @param tag_len   Tag length (4 to 16 bytes, even).
+ * @param mac       Place to store the (unencrypted) MAC.
  *
  */
-static void key_expansion(uint8_t *key, uint32_t *key_exp)
+static void ccm_mac(const aes_ctx_t *ctx, const uint8_t *nonce,
+    size_t nonce_len, const uint8_t *aad, size_t aad_len,
+    const uint8_t *data, size_t length, size_t tag_len, uint8_t *mac)
 {
-	uint32_t temp;
+	size_t len_size = 15 - nonce_len;
+	uint8_t hdr[6];
+	size_t hdr_len;
+	size_t n;
 
-	for (size_t i = 0; i < CIPHER_ELEMS; i++) {
-		key_exp[i] =
-		    (key[4 * i] << 24) +
-		    (key[4 * i + 1] << 16) +
-		    (key[4 * i + 2] << 8) +
-		    (key[4 * i + 3]);
-	}
+	/* First block: flags, nonce and message length */
+	mac[0] = ((aad_len > 0) ? 0x40 : 0) | (((tag_len - 2) / 2) << 3) |
+	    (len_size - 1);
+	memcpy(mac + 1, nonce, nonce_len);
+	for (size_t i = 0; i < len_size; i++)
+		mac[BLOCK_LEN - 1 - i] = (uint8_t) (length >> (8 * i));
 
-	for (size_t i = CIPHER_ELEMS; i < ELEMS * (ROUNDS + 1); i++) {
-		temp = key_exp[i - 1];
+	aes_encrypt_block(ctx, mac, mac);
 
-		if ((i % CIPHER_ELEMS) == 0) {
-			temp = sub_word(rot_word(temp)) ^
-			    r_con_array[i / CIPHER_ELEMS - 1];
+	if (aad_len > 0) {
+		/* Length of additional data is encoded in front of it */
+		if (aad_len < 0xff00) {
+			hdr[0] = (uint8_t) (aad_len >> 8);
+			hdr[1] = (uint8_t) aad_len;
+			hdr_len = 2;
+		} else {
+			hdr[0] = 0xff;
+			hdr[1] = 0xfe;
+			hdr[2] = (uint8_t) (aad_len >> 24);
+			hdr[3] = (uint8_t) (aad_len >> 16);
+			hdr[4] = (uint8_t) (aad_len >> 8);
+			hdr[5] = (uint8_t) aad_len;
+			hdr_len = 6;
 		}
 
-		key_exp[i] = key_exp[i - CIPHER_ELEMS] ^ temp;
+		for (size_t i = 0; i < hdr_len; i++)
+			mac[i] ^= hdr[i];
+
+		/* Rest of the first block of additional data */
+		n = min(aad_len, BLOCK_LEN - hdr_len);
+		for (size_t i = 0; i < n; i++)
+			mac[hdr_len + i] ^= aad[i];
+
+		aes_encrypt_block(ctx, mac, mac);
+		cbc_mac(ctx, mac, aad + n, aad_len - n);
 	}
+
+	cbc_mac(ctx, mac, data, length);
+}
+
+/** Set up CCM counter block.
+ *
+ * @param nonce     Nonce.
+ * @param nonce_len Nonce length.
+ * @param ctr       Counter block to be initialized (with counter 0).
+ *
+ */
+static void ccm_ctr_init(const uint8_t *nonce, size_t nonce_len,
+    uint8_t *ctr)
+{
+	memset(ctr, 0, BLOCK_LEN);
+	ctr[0] = 15 - nonce_len - 1;
+	memcpy(ctr + 1, nonce, nonce_len);
+}
+
+/** Check CCM parameters.
+ *
+ * @param nonce_len Nonce length.
+ * @param tag_len   Tag length.
+ * @param length    Message length.
+ *
+ * @return True if valid.
+ *
+ */
+static bool ccm_params_valid(size_t nonce_len, size_t tag_len, size_t length)
+{
+	size_t len_size = 15 - nonce_len;
+
+	if (nonce_len < 7 || nonce_len > 13)
+		return false;
+
+	if (tag_len < 4 || tag_len > 16 || (tag_len % 2) != 0)
+		return false;
+
+	/* Message length must fit in the length field */
+	if (len_size < sizeof(size_t) && (length >> (8 * len_size)) != 0)
+		return false;
+
+	return true;
+}
+
+/** Encrypt and authenticate data with AES-128 in CCM mode.
+ *
+ * CCM mode as specified in RFC 3610 (used by CCMP in IEEE 802.11).
+ *
+ * @param ctx       AES context.
+ * @param nonce     Nonce.
+ * @param nonce_len Nonce length (7 to 13 bytes).
+ * @param aad       Additional authenticated data (not encrypted).
+ * @param aad_len   Length of additional authenticated data.
+ * @param input     Plain text.
+ * @param length    Length of plain text.
+ * @param output    Cipher text (same length, may be the same as @a input).
+ * @param tag       Place to store authentication tag.
+ * @param tag_len   Tag length (4 to 16 bytes, even).
+ *
+ * @return EINVAL on invalid parameters, otherwise EOK.
+ *
+ */
+errno_t aes_ccm_encrypt(const aes_ctx_t *ctx, const uint8_t *nonce,
+    size_t nonce_len, const uint8_t *aad, size_t aad_len,
+    const uint8_t *input, size_t length, uint8_t *output, uint8_t *tag,
+    size_t tag_len)
+{
+	uint8_t mac[BLOCK_LEN];
+	uint8_t ctr[BLOCK_LEN];
+
+	if (!ccm_params_valid(nonce_len, tag_len, length))
+		return EINVAL;
+
+	ccm_mac(ctx, nonce, nonce_len, aad, aad_len, input, length, tag_len,
+	    mac);
+
+	/* Counter 0 encrypts the tag, the data starts with counter 1 */
+	ccm_ctr_init(nonce, nonce_len, ctr);
+	aes_ctr(ctx, ctr, mac, tag, tag_len);
+	aes_ctr(ctx, ctr, input, output, length);
+
+	return EOK;
+}
+
+/** Decrypt and verify data with AES-128 in CCM mode.
+ *
+ * @param ctx       AES context.
+ * @param nonce     Nonce.
+ * @param nonce_len Nonce length (7 to 13 bytes).
+ * @param aad       Additional authenticated data.
+ * @param aad_len   Length of additional authenticated data.
+ * @param input     Cipher text.
+ * @param length    Length of cipher text.
+ * @param output    Plain text (same length, may be the same as @a input).
+ * @param tag       Authentication tag.
+ * @param tag_len   Tag length (4 to 16 bytes, even).
+ *
+ * @return EINVAL on invalid parameters or if the authentication
+ *         fails (the output is cleared then), otherwise EOK.
+ *
+ */
+errno_t aes_ccm_decrypt(const aes_ctx_t *ctx, const uint8_t *nonce,
+    size_t nonce_len, const uint8_t *aad, size_t aad_len,
+    const uint8_t *input, size_t length, uint8_t *output, const uint8_t *tag,
+    size_t tag_len)
+{
+	uint8_t mac[BLOCK_LEN];
+	uint8_t ctr[BLOCK_LEN];
+	uint8_t stag[BLOCK_LEN];
+	uint8_t diff = 0;
+
+	if (!ccm_params_valid(nonce_len, tag_len, length))
+		return EINVAL;
+
+	ccm_ctr_init(nonce, nonce_len, ctr);
+	aes_ctr(ctx, ctr, tag, stag, tag_len);
+	aes_ctr(ctx, ctr, input, output, length);
+
+	ccm_mac(ctx, nonce, nonce_len, aad, aad_len, output, length, tag_len,
+	    mac);
+
+	/* Compare in constant time */
+	for (size_t i = 0; i < tag_len; i++)
+		diff |= mac[i] ^ stag[i];
+
+	if (diff != 0) {
+		memset(output, 0, length);
+		return EINVAL;
+	}
+
+	return EOK;
 }
 
 /** AES-128 encryption algorithm.
@@ -460,41 +1097,16 @@ static void key_expansion(uint8_t *key, uint32_t *key_exp)
  */
 errno_t aes_encrypt(uint8_t *key, uint8_t *input, uint8_t *output)
 {
+	aes_ctx_t ctx;
+
 	if ((!key) || (!input))
 		return EINVAL;
 
 	if (!output)
 		return ENOMEM;
 
-	/* Create key expansion. */
-	uint32_t key_exp[ELEMS * (ROUNDS + 1)];
-	key_expansion(key, key_exp);
-
-	/* Copy input into state array. */
-	uint8_t state[ELEMS][ELEMS];
-	for (size_t i = 0; i < ELEMS; i++) {
-		for (size_t j = 0; j < ELEMS; j++)
-			state[i][j] = input[i + ELEMS * j];
-	}
-
-	/* Processing loop. */
-	add_round_key(state, key_exp);
-
-	for (size_t k = 1; k <= ROUNDS; k++) {
-		sub_bytes(state, false);
-		shift_rows(state);
-
-		if (k < ROUNDS)
-			mix_columns(state);
-
-		add_round_key(state, key_exp + k * ELEMS);
-	}
-
-	/* Copy state array into output. */
-	for (size_t i = 0; i < ELEMS; i++) {
-		for (size_t j = 0; j < ELEMS; j++)
-			output[i + j * ELEMS] = state[i][j];
-	}
+	(void) aes_init(&ctx, key);
+	aes_encrypt_block(&ctx, input, output);
 
 	return EOK;
 }
@@ -512,40 +1124,16 @@ errno_t aes_encrypt(uint8_t *key, uint8_t *input, uint8_t *output)
  */
 errno_t aes_decrypt(uint8_t *key, uint8_t *input, uint8_t *output)
 {
+	aes_ctx_t ctx;
+
 	if ((!key) || (!input))
 		return EINVAL;
 
 	if (!output)
 		return ENOMEM;
 
-	/* Create key expansion. */
-	uint32_t key_exp[ELEMS * (ROUNDS + 1)];
-	key_expansion(key, key_exp);
-
-	/* Copy input into state array. */
-	uint8_t state[ELEMS][ELEMS];
-	for (size_t i = 0; i < ELEMS; i++) {
-		for (size_t j = 0; j < ELEMS; j++)
-			state[i][j] = input[i + ELEMS * j];
-	}
-
-	/* Processing loop. */
-	add_round_key(state, key_exp + ROUNDS * ELEMS);
-
-	for (int k = ROUNDS - 1; k >= 0; k--) {
-		inv_shift_rows(state);
-		sub_bytes(state, true);
-		add_round_key(state, key_exp + k * ELEMS);
-
-		if (k > 0)
-			inv_mix_columns(state);
-	}
-
-	/* Copy state array into output. */
-	for (size_t i = 0; i < ELEMS; i++) {
-		for (size_t j = 0; j < ELEMS; j++)
-			output[i + j * ELEMS] = state[i][j];
-	}
+	(void) aes_init(&ctx, key);
+	aes_decrypt_block(&ctx, input, output);
 
 	return EOK;
 }
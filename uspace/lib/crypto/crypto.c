@@ -31,39 +31,38 @@
  * Cryptographic functions library.
  */
 
-#include <assert.h>
 #include <str.h>
 #include <macros.h>
 #include <errno.h>
 #include <byteorder.h>
-#include <limits.h>
 #include "crypto.h"
 
-/** Hash function procedure definition. */
-typedef void (*hash_fnc_t)(uint32_t *, uint32_t *);
+#ifdef __x86_64__
+#include <stdatomic.h>
+#endif
 
 /** Length of HMAC block. */
-#define HMAC_BLOCK_LENGTH  64
+#define HMAC_BLOCK_LENGTH  HASH_BLOCK_LENGTH
 
-/** Ceiling for uint32_t. */
-#define ceil_uint32(val) \
-	(((val) - (uint32_t) (val)) > 0 ? \
-	(uint32_t) ((val) + 1) : (uint32_t) (val))
+/** Offset of the message length in the last block. */
+#define HASH_LENGTH_OFFSET  (HASH_BLOCK_LENGTH - 8)
 
-/** Floor for uint32_t. */
-#define floor_uint32(val) \
-	(((val) - (uint32_t) (val)) < 0 ? \
-	(uint32_t) ((val) - 1) : (uint32_t) (val))
-
-/** Pick value at specified index from array or zero if out of bounds. */
-#define get_at(input, size, i) \
-	((i) < (size) ? (input[i]) : 0)
+/** Init values used in MD5 function. */
+static const uint32_t md5_init[] = {
+	0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476
+};
 
-/** Init values used in SHA1 and MD5 functions. */
-static const uint32_t hash_init[] = {
+/** Init values used in SHA-1 function. */
+static const uint32_t sha1_init[] = {
 	0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
 };
 
+/** Init values used in SHA-256 function. */
+static const uint32_t sha256_init[] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
 /** Shift amount array for MD5 algorithm. */
 static const uint32_t md5_shift[] = {
 	7, 12, 17, 22,  7, 12, 17, 22,  7, 12, 17, 22,  7, 12, 17, 22,
@@ -92,95 +91,719 @@ static const uint32_t md5_sbox[] = {
 	0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
 };
 
+/** Round constants for SHA-256 algorithm. */
+static const uint32_t sha256_k[] __attribute__((aligned(16))) = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/** Load little-endian 32-bit word.
+ *
+ * @param data Data.
+ *
+ * @return Value.
+ *
+ */
+static inline uint32_t load_le32(const uint8_t *data)
+{
+	return ((uint32_t) data[0]) | ((uint32_t) data[1] << 8) |
+	    ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+/** Load big-endian 32-bit word.
+ *
+ * @param data Data.
+ *
+ * @return Value.
+ *
+ */
+static inline uint32_t load_be32(const uint8_t *data)
+{
+	return ((uint32_t) data[0] << 24) | ((uint32_t) data[1] << 16) |
+	    ((uint32_t) data[2] << 8) | ((uint32_t) data[3]);
+}
+
+/** One step of MD5 algorithm.
+ *
+ * @param w Working array with interim hash parts values.
+ * @param f Value of the round function.
+ * @param k Step number.
+ * @param m Message word.
+ *
+ */
+static inline void md5_step(uint32_t *w, uint32_t f, size_t k, uint32_t m)
+{
+	uint32_t temp = w[3];
+
+	w[3] = w[2];
+	w[2] = w[1];
+	w[1] += rotl_uint32(w[0] + f + md5_sbox[k] + m, md5_shift[k]);
+	w[0] = temp;
+}
+
 /** Working procedure of MD5 cryptographic hash function.
  *
- * @param h         Working array with interim hash parts values.
- * @param sched_arr Input array with scheduled values from input string.
+ * @param h      Working array with interim hash parts values.
+ * @param data   Input blocks.
+ * @param blocks Number of input blocks.
  *
  */
-static void md5_proc(uint32_t *h, uint32_t *sched_arr)
-{
-	uint32_t f, g, temp;
-	uint32_t w[HASH_MD5 / 4];
-
-	memcpy(w, h, (HASH_MD5 / 4) * sizeof(uint32_t));
-
-	for (size_t k = 0; k < 64; k++) {
-		if (k < 16) {
-			f = (w[1] & w[2]) | (~w[1] & w[3]);
-			g = k;
-		} else if ((k >= 16) && (k < 32)) {
-			f = (w[1] & w[3]) | (w[2] & ~w[3]);
-			g = (5 * k + 1) % 16;
-		} else if ((k >= 32) && (k < 48)) {
-			f = w[1] ^ w[2] ^ w[3];
-			g = (3 * k + 5) % 16;
-		} else {
-			f = w[2] ^ (w[1] | ~w[3]);
-			g = 7 * k % 16;
+static void md5_proc(uint32_t *h, const uint8_t *data, size_t blocks)
+{
+	uint32_t m[16];
+	uint32_t w[4];
+	size_t k;
+
+	for (; blocks > 0; blocks--, data += HASH_BLOCK_LENGTH) {
+		for (k = 0; k < 16; k++)
+			m[k] = load_le32(data + 4 * k);
+
+		memcpy(w, h, sizeof(w));
+
+		for (k = 0; k < 16; k++)
+			md5_step(w, w[3] ^ (w[1] & (w[2] ^ w[3])), k, m[k]);
+
+		for (k = 16; k < 32; k++) {
+			md5_step(w, w[2] ^ (w[3] & (w[1] ^ w[2])), k,
+			    m[(5 * k + 1) % 16]);
 		}
 
-		temp = w[3];
-		w[3] = w[2];
-		w[2] = w[1];
-		w[1] += rotl_uint32(w[0] + f + md5_sbox[k] +
-		    uint32_t_byteorder_swap(sched_arr[g]),
-		    md5_shift[k]);
-		w[0] = temp;
+		for (k = 32; k < 48; k++)
+			md5_step(w, w[1] ^ w[2] ^ w[3], k, m[(3 * k + 5) % 16]);
+
+		for (k = 48; k < 64; k++)
+			md5_step(w, w[2] ^ (w[1] | ~w[3]), k, m[7 * k % 16]);
+
+		for (k = 0; k < 4; k++)
+			h[k] += w[k];
 	}
+}
 
-	for (uint8_t k = 0; k < HASH_MD5 / 4; k++)
-		h[k] += w[k];
+/** One step of SHA-1 algorithm.
+ *
+ * @param w  Working array with interim hash parts values.
+ * @param f  Value of the round function.
+ * @param cf Round constant.
+ * @param m  Scheduled message word.
+ *
+ */
+static inline void sha1_step(uint32_t *w, uint32_t f, uint32_t cf,
+    uint32_t m)
+{
+	uint32_t temp = rotl_uint32(w[0], 5) + f + w[4] + cf + m;
+
+	w[4] = w[3];
+	w[3] = w[2];
+	w[2] = rotl_uint32(w[1], 30);
+	w[1] = w[0];
+	w[0] = temp;
+}
+
+/** Compute next scheduled SHA-1 message word.
+ *
+ * The schedule is kept in a circular buffer of 16 words.
+ *
+ * @param m Message schedule.
+ * @param k Step number.
+ *
+ * @return Scheduled message word for step k.
+ *
+ */
+static inline uint32_t sha1_sched(uint32_t *m, size_t k)
+{
+	if (k >= 16) {
+		m[k % 16] = rotl_uint32(m[(k - 3) % 16] ^ m[(k - 8) % 16] ^
+		    m[(k - 14) % 16] ^ m[k % 16], 1);
+	}
+
+	return m[k % 16];
 }
 
 /** Working procedure of SHA-1 cryptographic hash function.
  *
- * @param h         Working array with interim hash parts values.
- * @param sched_arr Input array with scheduled values from input string.
+ * @param h      Working array with interim hash parts values.
+ * @param data   Input blocks.
+ * @param blocks Number of input blocks.
+ *
+ */
+static void sha1_proc(uint32_t *h, const uint8_t *data, size_t blocks)
+{
+	uint32_t m[16];
+	uint32_t w[5];
+	size_t k;
+
+	for (; blocks > 0; blocks--, data += HASH_BLOCK_LENGTH) {
+		for (k = 0; k < 16; k++)
+			m[k] = load_be32(data + 4 * k);
+
+		memcpy(w, h, sizeof(w));
+
+		for (k = 0; k < 20; k++) {
+			sha1_step(w, w[3] ^ (w[1] & (w[2] ^ w[3])), 0x5a827999,
+			    sha1_sched(m, k));
+		}
+
+		for (k = 20; k < 40; k++) {
+			sha1_step(w, w[1] ^ w[2] ^ w[3], 0x6ed9eba1,
+			    sha1_sched(m, k));
+		}
+
+		for (k = 40; k < 60; k++) {
+			sha1_step(w, (w[1] & w[2]) | (w[3] & (w[1] | w[2])),
+			    0x8f1bbcdc, sha1_sched(m, k));
+		}
+
+		for (k = 60; k < 80; k++) {
+			sha1_step(w, w[1] ^ w[2] ^ w[3], 0xca62c1d6,
+			    sha1_sched(m, k));
+		}
+
+		for (k = 0; k < 5; k++)
+			h[k] += w[k];
+	}
+}
+
+/** Working procedure of SHA-256 cryptographic hash function.
+ *
+ * @param h      Working array with interim hash parts values.
+ * @param data   Input blocks.
+ * @param blocks Number of input blocks.
+ *
+ */
+static void sha256_proc(uint32_t *h, const uint8_t *data, size_t blocks)
+{
+	uint32_t m[16];
+	uint32_t w[8];
+	uint32_t s0, s1, t1, t2;
+	size_t k;
+
+	for (; blocks > 0; blocks--, data += HASH_BLOCK_LENGTH) {
+		for (k = 0; k < 16; k++)
+			m[k] = load_be32(data + 4 * k);
+
+		memcpy(w, h, sizeof(w));
+
+		for (k = 0; k < 64; k++) {
+			if (k >= 16) {
+				s0 = m[(k - 15) % 16];
+				s0 = rotr_uint32(s0, 7) ^ rotr_uint32(s0, 18) ^
+				    (s0 >> 3);
+				s1 = m[(k - 2) % 16];
+				s1 = rotr_uint32(s1, 17) ^ rotr_uint32(s1, 19) ^
+				    (s1 >> 10);
+				m[k % 16] += s0 + m[(k - 7) % 16] + s1;
+			}
+
+			t1 = w[7] + (rotr_uint32(w[4], 6) ^
+			    rotr_uint32(w[4], 11) ^ rotr_uint32(w[4], 25)) +
+			    (w[6] ^ (w[4] & (w[5] ^ w[6]))) + sha256_k[k] +
+			    m[k % 16];
+			t2 = (rotr_uint32(w[0], 2) ^ rotr_uint32(w[0], 13) ^
+			    rotr_uint32(w[0], 22)) +
+			    ((w[0] & w[1]) | (w[2] & (w[0] | w[1])));
+
+			w[7] = w[6];
+			w[6] = w[5];
+			w[5] = w[4];
+			w[4] = w[3] + t1;
+			w[3] = w[2];
+			w[2] = w[1];
+			w[1] = w[0];
+			w[0] = t1 + t2;
+		}
+
+		for (k = 0; k < 8; k++)
+			h[k] += w[k];
+	}
+}
+
+#ifdef __x86_64__
+
+/** SHA extensions support (0 unknown, 1 no, 2 yes) */
+static atomic_int sha_ni_state;
+
+typedef uint32_t sha_v4su_t __attribute__((vector_size(16)));
+
+/** Determine whether the processor supports SHA extensions.
+ *
+ * @return True if SHA instructions are available.
+ *
+ */
+static bool sha_ni_available(void)
+{
+	int state = atomic_load_explicit(&sha_ni_state, memory_order_relaxed);
+	uint32_t eax = 0;
+	uint32_t ebx, ecx = 0, edx;
+
+	if (state != 0)
+		return state == 2;
+
+	asm volatile (
+	    "cpuid\n"
+	    : "+a" (eax), "=b" (ebx), "+c" (ecx), "=d" (edx)
+	);
+
+	state = 1;
+	if (eax >= 7) {
+		eax = 7;
+		ecx = 0;
+
+		asm volatile (
+		    "cpuid\n"
+		    : "+a" (eax), "=b" (ebx), "+c" (ecx), "=d" (edx)
+		);
+
+		/* CPUID.(EAX=07H,ECX=0):EBX.SHA[bit 29] */
+		if ((ebx & (1 << 29)) != 0)
+			state = 2;
+	}
+
+	atomic_store_explicit(&sha_ni_state, state, memory_order_relaxed);
+	return state == 2;
+}
+
+/** Load 128 bits of message and reorder its bytes.
+ *
+ * @param data Data.
+ * @param mask Byte shuffle mask.
+ *
+ * @return Loaded value.
+ *
+ */
+static inline sha_v4su_t sha_load(const uint8_t *data, sha_v4su_t mask)
+{
+	sha_v4su_t v;
+
+	memcpy(&v, data, sizeof(v));
+	asm ("pshufb %[mask], %[v]\n" : [v] "+x" (v) : [mask] "x" (mask));
+	return v;
+}
+
+/** Move the high 64 bits of a value to the low 64 bits. */
+static inline sha_v4su_t sha_high64(sha_v4su_t v)
+{
+	sha_v4su_t r;
+
+	asm ("pshufd $0x0e, %[v], %[r]\n" : [r] "=x" (r) : [v] "x" (v));
+	return r;
+}
+
+/** Extract 128 bits from the middle of a 256-bit concatenation.
+ *
+ * @param hi High part.
+ * @param lo Low part.
+ *
+ * @return Words 1 to 4 of the concatenation.
+ *
+ */
+static inline sha_v4su_t sha_alignr4(sha_v4su_t hi, sha_v4su_t lo)
+{
+	asm ("palignr $4, %[lo], %[hi]\n" : [hi] "+x" (hi) : [lo] "x" (lo));
+	return hi;
+}
+
+/** Perform two rounds of SHA-256 (SHA256RNDS2). */
+static inline sha_v4su_t sha256_rnds2(sha_v4su_t cdgh, sha_v4su_t abef,
+    sha_v4su_t msg)
+{
+	asm (
+	    "sha256rnds2 %[msg], %[abef], %[cdgh]\n"
+	    : [cdgh] "+x" (cdgh)
+	    : [abef] "x" (abef), [msg] "Yz" (msg)
+	);
+	return cdgh;
+}
+
+/** First part of SHA-256 message schedule (SHA256MSG1). */
+static inline sha_v4su_t sha256_msg1(sha_v4su_t a, sha_v4su_t b)
+{
+	asm ("sha256msg1 %[b], %[a]\n" : [a] "+x" (a) : [b] "x" (b));
+	return a;
+}
+
+/** Second part of SHA-256 message schedule (SHA256MSG2). */
+static inline sha_v4su_t sha256_msg2(sha_v4su_t a, sha_v4su_t b)
+{
+	asm ("sha256msg2 %[b], %[a]\n" : [a] "+x" (a) : [b] "x" (b));
+	return a;
+}
+
+/** Perform four rounds of SHA-256 using SHA extensions.
+ *
+ * @param abef State words A, B, E, F.
+ * @param cdgh State words C, D, G, H.
+ * @param m    Message schedule (current, next, next but one, previous).
+ * @param k    Number of the four-round group.
+ *
+ */
+static inline void sha256_ni_rounds(sha_v4su_t *abef, sha_v4su_t *cdgh,
+    sha_v4su_t *m0, sha_v4su_t *m1, sha_v4su_t *m3, size_t k)
+{
+	sha_v4su_t msg;
+
+	memcpy(&msg, sha256_k + 4 * k, sizeof(msg));
+	msg += *m0;
+	*cdgh = sha256_rnds2(*cdgh, *abef, msg);
+
+	if (k >= 3 && k < 15)
+		*m1 = sha256_msg2(*m1 + sha_alignr4(*m0, *m3), *m0);
+
+	*abef = sha256_rnds2(*abef, *cdgh, sha_high64(msg));
+
+	if (k >= 1 && k < 13)
+		*m3 = sha256_msg1(*m3, *m0);
+}
+
+/** Working procedure of SHA-256 using SHA extensions.
+ *
+ * @param h      Working array with interim hash parts values.
+ * @param data   Input blocks.
+ * @param blocks Number of input blocks.
+ *
+ */
+static void sha256_ni_proc(uint32_t *h, const uint8_t *data, size_t blocks)
+{
+	/* Swap bytes in each word */
+	const sha_v4su_t mask = {
+		0x00010203, 0x04050607, 0x08090a0b, 0x0c0d0e0f
+	};
+	sha_v4su_t abef = { h[5], h[4], h[1], h[0] };
+	sha_v4su_t cdgh = { h[7], h[6], h[3], h[2] };
+	sha_v4su_t abef_save, cdgh_save;
+	sha_v4su_t m0, m1, m2, m3;
+
+	for (; blocks > 0; blocks--, data += HASH_BLOCK_LENGTH) {
+		abef_save = abef;
+		cdgh_save = cdgh;
+
+		m0 = sha_load(data, mask);
+		m1 = sha_load(data + 16, mask);
+		m2 = sha_load(data + 32, mask);
+		m3 = sha_load(data + 48, mask);
+
+		for (size_t k = 0; k < 16; k += 4) {
+			sha256_ni_rounds(&abef, &cdgh, &m0, &m1, &m3, k);
+			sha256_ni_rounds(&abef, &cdgh, &m1, &m2, &m0, k + 1);
+			sha256_ni_rounds(&abef, &cdgh, &m2, &m3, &m1, k + 2);
+			sha256_ni_rounds(&abef, &cdgh, &m3, &m0, &m2, k + 3);
+		}
+
+		abef += abef_save;
+		cdgh += cdgh_save;
+	}
+
+	h[0] = abef[3];
+	h[1] = abef[2];
+	h[2] = cdgh[3];
+	h[3] = cdgh[2];
+	h[4] = abef[1];
+	h[5] = abef[0];
+	h[6] = cdgh[1];
+	h[7] = cdgh[0];
+}
+
+/** Perform four rounds of SHA-1 (SHA1RNDS4).
+ *
+ * @param abcd State words A, B, C, D.
+ * @param e    State word E added to the message.
+ * @param func Round function selector (0 to 3).
+ *
+ * @return Updated state words.
+ *
+ */
+static inline sha_v4su_t sha1_rnds4(sha_v4su_t abcd, sha_v4su_t e,
+    unsigned func)
+{
+	switch (func) {
+	case 0:
+		asm ("sha1rnds4 $0, %[e], %[s]\n"
+		    : [s] "+x" (abcd) : [e] "x" (e));
+		break;
+	case 1:
+		asm ("sha1rnds4 $1, %[e], %[s]\n"
+		    : [s] "+x" (abcd) : [e] "x" (e));
+		break;
+	case 2:
+		asm ("sha1rnds4 $2, %[e], %[s]\n"
+		    : [s] "+x" (abcd) : [e] "x" (e));
+		break;
+	default:
+		asm ("sha1rnds4 $3, %[e], %[s]\n"
+		    : [s] "+x" (abcd) : [e] "x" (e));
+		break;
+	}
+
+	return abcd;
+}
+
+/** Compute state word E for the next four rounds of SHA-1 (SHA1NEXTE). */
+static inline sha_v4su_t sha1_nexte(sha_v4su_t e, sha_v4su_t msg)
+{
+	asm ("sha1nexte %[msg], %[e]\n" : [e] "+x" (e) : [msg] "x" (msg));
+	return e;
+}
+
+/** First part of SHA-1 message schedule (SHA1MSG1). */
+static inline sha_v4su_t sha1_msg1(sha_v4su_t a, sha_v4su_t b)
+{
+	asm ("sha1msg1 %[b], %[a]\n" : [a] "+x" (a) : [b] "x" (b));
+	return a;
+}
+
+/** Second part of SHA-1 message schedule (SHA1MSG2). */
+static inline sha_v4su_t sha1_msg2(sha_v4su_t a, sha_v4su_t b)
+{
+	asm ("sha1msg2 %[b], %[a]\n" : [a] "+x" (a) : [b] "x" (b));
+	return a;
+}
+
+/** Perform four rounds of SHA-1 using SHA extensions.
+ *
+ * The state word E alternates between two variables, the one not
+ * used in this group receives the state for the next group.
+ *
+ * @param abcd State words A, B, C, D.
+ * @param e    State word E for this group.
+ * @param enext State word E for the next group.
+ * @param m    Message schedule (current, next, next but one, previous).
+ * @param k    Number of the four-round group.
  *
  */
-static void sha1_proc(uint32_t *h, uint32_t *sched_arr)
-{
-	uint32_t f, cf, temp;
-	uint32_t w[HASH_SHA1 / 4];
-
-	for (size_t k = 16; k < 80; k++) {
-		sched_arr[k] = rotl_uint32(
-		    sched_arr[k - 3] ^
-		    sched_arr[k - 8] ^
-		    sched_arr[k - 14] ^
-		    sched_arr[k - 16],
-		    1);
+static inline void sha1_ni_rounds(sha_v4su_t *abcd, sha_v4su_t *e,
+    sha_v4su_t *enext, sha_v4su_t *m0, sha_v4su_t *m1, sha_v4su_t *m2,
+    sha_v4su_t *m3, size_t k)
+{
+	if (k == 0)
+		*e += *m0;
+	else
+		*e = sha1_nexte(*e, *m0);
+
+	*enext = *abcd;
+
+	if (k >= 3 && k < 19)
+		*m1 = sha1_msg2(*m1, *m0);
+
+	*abcd = sha1_rnds4(*abcd, *e, k / 5);
+
+	if (k >= 1 && k < 17)
+		*m3 = sha1_msg1(*m3, *m0);
+
+	if (k >= 2 && k < 18)
+		*m2 ^= *m0;
+}
+
+/** Working procedure of SHA-1 using SHA extensions.
+ *
+ * @param h      Working array with interim hash parts values.
+ * @param data   Input blocks.
+ * @param blocks Number of input blocks.
+ *
+ */
+static void sha1_ni_proc(uint32_t *h, const uint8_t *data, size_t blocks)
+{
+	/* Reverse bytes in the whole value */
+	const sha_v4su_t mask = {
+		0x0c0d0e0f, 0x08090a0b, 0x04050607, 0x00010203
+	};
+	sha_v4su_t abcd = { h[3], h[2], h[1], h[0] };
+	sha_v4su_t e0 = { 0, 0, 0, h[4] };
+	sha_v4su_t e1;
+	sha_v4su_t abcd_save, e0_save;
+	sha_v4su_t m0, m1, m2, m3;
+
+	for (; blocks > 0; blocks--, data += HASH_BLOCK_LENGTH) {
+		abcd_save = abcd;
+		e0_save = e0;
+
+		m0 = sha_load(data, mask);
+		m1 = sha_load(data + 16, mask);
+		m2 = sha_load(data + 32, mask);
+		m3 = sha_load(data + 48, mask);
+
+		for (size_t k = 0; k < 20; k += 4) {
+			sha1_ni_rounds(&abcd, &e0, &e1, &m0, &m1, &m2, &m3, k);
+			sha1_ni_rounds(&abcd, &e1, &e0, &m1, &m2, &m3, &m0,
+			    k + 1);
+			sha1_ni_rounds(&abcd, &e0, &e1, &m2, &m3, &m0, &m1,
+			    k + 2);
+			sha1_ni_rounds(&abcd, &e1, &e0, &m3, &m0, &m1, &m2,
+			    k + 3);
+		}
+
+		e0 = sha1_nexte(e0, e0_save);
+		abcd += abcd_save;
 	}
 
-	memcpy(w, h, (HASH_SHA1 / 4) * sizeof(uint32_t));
-
-	for (size_t k = 0; k < 80; k++) {
-		if (k < 20) {
-			f = (w[1] & w[2]) | (~w[1] & w[3]);
-			cf = 0x5A827999;
-		} else if ((k >= 20) && (k < 40)) {
-			f = w[1] ^ w[2] ^ w[3];
-			cf = 0x6ed9eba1;
-		} else if ((k >= 40) && (k < 60)) {
-			f = (w[1] & w[2]) | (w[1] & w[3]) | (w[2] & w[3]);
-			cf = 0x8f1bbcdc;
-		} else {
-			f = w[1] ^ w[2] ^ w[3];
-			cf = 0xca62c1d6;
+	h[0] = abcd[3];
+	h[1] = abcd[2];
+	h[2] = abcd[1];
+	h[3] = abcd[0];
+	h[4] = e0[3];
+}
+
+#endif
+
+/** Process whole blocks of input using the selected hash function.
+ *
+ * @param ctx    Hash context.
+ * @param data   Input blocks.
+ * @param blocks Number of input blocks.
+ *
+ */
+static void hash_proc(hash_ctx_t *ctx, const uint8_t *data, size_t blocks)
+{
+	switch (ctx->func) {
+	case HASH_MD5:
+		md5_proc(ctx->h, data, blocks);
+		break;
+	case HASH_SHA1:
+#ifdef __x86_64__
+		if (sha_ni_available()) {
+			sha1_ni_proc(ctx->h, data, blocks);
+			break;
 		}
+#endif
+		sha1_proc(ctx->h, data, blocks);
+		break;
+	case HASH_SHA256:
+#ifdef __x86_64__
+		if (sha_ni_available()) {
+			sha256_ni_proc(ctx->h, data, blocks);
+			break;
+		}
+#endif
+		sha256_proc(ctx->h, data, blocks);
+		break;
+	}
+}
+
+/** Initialize hash context.
+ *
+ * @param ctx      Hash context.
+ * @param hash_sel Hash function selector.
+ *
+ * @return EINVAL when the hash function is not supported, otherwise EOK.
+ *
+ */
+errno_t hash_init(hash_ctx_t *ctx, hash_func_t hash_sel)
+{
+	switch (hash_sel) {
+	case HASH_MD5:
+		memcpy(ctx->h, md5_init, sizeof(md5_init));
+		break;
+	case HASH_SHA1:
+		memcpy(ctx->h, sha1_init, sizeof(sha1_init));
+		break;
+	case HASH_SHA256:
+		memcpy(ctx->h, sha256_init, sizeof(sha256_init));
+		break;
+	default:
+		return EINVAL;
+	}
+
+	ctx->func = hash_sel;
+	ctx->block_len = 0;
+	ctx->length = 0;
+	return EOK;
+}
+
+/** Add data to the hashed message.
+ *
+ * Whole blocks are processed directly from the input, only an incomplete
+ * block is buffered in the context.
+ *
+ * @param ctx  Hash context.
+ * @param data Data.
+ * @param size Size of data.
+ *
+ */
+void hash_update(hash_ctx_t *ctx, const void *data, size_t size)
+{
+	const uint8_t *input = data;
+	size_t n;
+
+	ctx->length += size;
+
+	if (ctx->block_len > 0) {
+		n = min(size, HASH_BLOCK_LENGTH - ctx->block_len);
+		memcpy(ctx->block + ctx->block_len, input, n);
+		ctx->block_len += n;
+		input += n;
+		size -= n;
+
+		if (ctx->block_len < HASH_BLOCK_LENGTH)
+			return;
+
+		hash_proc(ctx, ctx->block, 1);
+		ctx->block_len = 0;
+	}
+
+	if (size >= HASH_BLOCK_LENGTH) {
+		n = size / HASH_BLOCK_LENGTH;
+		hash_proc(ctx, input, n);
+		input += n * HASH_BLOCK_LENGTH;
+		size -= n * HASH_BLOCK_LENGTH;
+	}
 
-		temp = rotl_uint32(w[0], 5) + f + w[4] + cf + sched_arr[k];
+	memcpy(ctx->block, input, size);
+	ctx->block_len = size;
+}
 
-		w[4] = w[3];
-		w[3] = w[2];
-		w[2] = rotl_uint32(w[1], 30);
-		w[1] = w[0];
-		w[0] = temp;
+/** Finish the hashed message and produce the hash.
+ *
+ * @param ctx    Hash context.
+ * @param output Result hash byte sequence (length given by the hash
+ *               function selector).
+ *
+ */
+void hash_final(hash_ctx_t *ctx, uint8_t *output)
+{
+	uint64_t bits_size = ctx->length * 8;
+	uint32_t word;
+
+	ctx->block[ctx->block_len++] = 0x80;
+
+	if (ctx->block_len > HASH_LENGTH_OFFSET) {
+		memset(ctx->block + ctx->block_len, 0,
+		    HASH_BLOCK_LENGTH - ctx->block_len);
+		hash_proc(ctx, ctx->block, 1);
+		ctx->block_len = 0;
 	}
 
-	for (uint8_t k = 0; k < HASH_SHA1 / 4; k++)
-		h[k] += w[k];
+	memset(ctx->block + ctx->block_len, 0,
+	    HASH_LENGTH_OFFSET - ctx->block_len);
+
+	if (ctx->func == HASH_MD5)
+		bits_size = host2uint64_t_le(bits_size);
+	else
+		bits_size = host2uint64_t_be(bits_size);
+
+	memcpy(ctx->block + HASH_LENGTH_OFFSET, &bits_size, sizeof(bits_size));
+	hash_proc(ctx, ctx->block, 1);
+
+	/* Copy hash parts into final result. */
+	for (size_t i = 0; i < ctx->func / 4; i++) {
+		if (ctx->func == HASH_MD5)
+			word = host2uint32_t_le(ctx->h[i]);
+		else
+			word = host2uint32_t_be(ctx->h[i]);
+
+		memcpy(output + i * sizeof(uint32_t), &word, sizeof(uint32_t));
+	}
 }
 
 /** Create hash based on selected algorithm.
@@ -190,15 +813,16 @@ static void sha1_proc(uint32_t *h, uint32_t *sched_arr)
  * @param output     Result hash byte sequence.
  * @param hash_sel   Hash function selector.
  *
- * @return EINVAL when input not specified,
- *         ENOMEM when pointer for output hash result
+ * @return EINVAL when input not specified or the hash function
+ *         is not supported, ENOMEM when pointer for output hash result
  *         is not allocated, otherwise EOK.
  *
  */
 errno_t create_hash(uint8_t *input, size_t input_size, uint8_t *output,
     hash_func_t hash_sel)
 {
-	assert(input_size < SSIZE_MAX);
+	hash_ctx_t ctx;
+	errno_t rc;
 
 	if (!input)
 		return EINVAL;
@@ -206,55 +830,94 @@ errno_t create_hash(uint8_t *input, size_t input_size, uint8_t *output,
 	if (!output)
 		return ENOMEM;
 
-	hash_fnc_t hash_func = (hash_sel == HASH_MD5) ? md5_proc : sha1_proc;
-
-	/* Prepare scheduled input. */
-	uint8_t work_input[input_size + 1];
-	memcpy(work_input, input, input_size);
-	work_input[input_size] = 0x80;
-
-	// FIXME: double?
-	size_t blocks = ceil_uint32((((double) input_size + 1) / 4 + 2) / 16);
-	uint32_t work_arr[blocks * 16];
-	for (size_t i = 0; i < blocks; i++) {
-		for (size_t j = 0; j < 16; j++) {
-			work_arr[i * 16 + j] =
-			    (get_at(work_input, input_size + 1, i * 64 + j * 4) << 24) |
-			    (get_at(work_input, input_size + 1, i * 64 + j * 4 + 1) << 16) |
-			    (get_at(work_input, input_size + 1, i * 64 + j * 4 + 2) << 8) |
-			    get_at(work_input, input_size + 1, i * 64 + j * 4 + 3);
-		}
-	}
+	rc = hash_init(&ctx, hash_sel);
+	if (rc != EOK)
+		return rc;
 
-	uint64_t bits_size = (uint64_t) (input_size * 8);
-	if (hash_sel == HASH_MD5)
-		bits_size = uint64_t_byteorder_swap(bits_size);
+	hash_update(&ctx, input, input_size);
+	hash_final(&ctx, output);
+	return EOK;
+}
 
-	work_arr[(blocks - 1) * 16 + 14] = bits_size >> 32;
-	work_arr[(blocks - 1) * 16 + 15] = bits_size & 0xffffffff;
+/** Initialize HMAC context with a key.
+ *
+ * Both the inner and the outer hash absorb the padded key, so that
+ * a copy of the context can be used for any number of messages
+ * authenticated with the same key.
+ *
+ * @param ctx      HMAC context.
+ * @param key      Cryptographic key sequence.
+ * @param key_size Size of key sequence.
+ * @param hash_sel Hash function selector.
+ *
+ * @return EINVAL when key not specified or the hash function
+ *         is not supported, otherwise EOK.
+ *
+ */
+errno_t hmac_init(hmac_ctx_t *ctx, const uint8_t *key, size_t key_size,
+    hash_func_t hash_sel)
+{
+	uint8_t work_key[HMAC_BLOCK_LENGTH];
+	uint8_t key_pad[HMAC_BLOCK_LENGTH];
+	errno_t rc;
 
-	/* Hash computation. */
-	uint32_t h[hash_sel / 4];
-	memcpy(h, hash_init, (hash_sel / 4) * sizeof(uint32_t));
-	uint32_t sched_arr[80];
-	for (size_t i = 0; i < blocks; i++) {
-		for (size_t k = 0; k < 16; k++)
-			sched_arr[k] = work_arr[i * 16 + k];
+	if (!key)
+		return EINVAL;
 
-		hash_func(h, sched_arr);
-	}
+	rc = hash_init(&ctx->inner, hash_sel);
+	if (rc != EOK)
+		return rc;
 
-	/* Copy hash parts into final result. */
-	for (size_t i = 0; i < hash_sel / 4; i++) {
-		if (hash_sel == HASH_SHA1)
-			h[i] = uint32_t_byteorder_swap(h[i]);
+	memset(work_key, 0, HMAC_BLOCK_LENGTH);
 
-		memcpy(output + i * sizeof(uint32_t), &h[i], sizeof(uint32_t));
+	if (key_size > HMAC_BLOCK_LENGTH) {
+		hash_update(&ctx->inner, key, key_size);
+		hash_final(&ctx->inner, work_key);
+		(void) hash_init(&ctx->inner, hash_sel);
+	} else {
+		memcpy(work_key, key, key_size);
 	}
 
+	for (size_t i = 0; i < HMAC_BLOCK_LENGTH; i++)
+		key_pad[i] = work_key[i] ^ 0x36;
+
+	hash_update(&ctx->inner, key_pad, HMAC_BLOCK_LENGTH);
+
+	for (size_t i = 0; i < HMAC_BLOCK_LENGTH; i++)
+		key_pad[i] = work_key[i] ^ 0x5c;
+
+	(void) hash_init(&ctx->outer, hash_sel);
+	hash_update(&ctx->outer, key_pad, HMAC_BLOCK_LENGTH);
 	return EOK;
 }
 
+/** Add data to the authenticated message.
+ *
+ * @param ctx  HMAC context.
+ * @param data Data.
+ * @param size Size of data.
+ *
+ */
+void hmac_update(hmac_ctx_t *ctx, const void *data, size_t size)
+{
+	hash_update(&ctx->inner, data, size);
+}
+
+/** Finish the authenticated message and produce the HMAC.
+ *
+ * @param ctx  HMAC context.
+ * @param hash Output parameter for result hash.
+ *
+ */
+void hmac_final(hmac_ctx_t *ctx, uint8_t *hash)
+{
+	uint8_t temp_hash[HASH_MAX_LENGTH];
+
+	hash_final(&ctx->inner, temp_hash);
+	hash_update(&ctx->outer, temp_hash, ctx->inner.func);
+	hash_final(&ctx->outer, hash);
+}
+
 /** Hash-based message authentication code.
  *
  * @param key      Cryptographic key sequence.
@@ -264,55 +927,38 @@ errno_t create_hash(uint8_t *input, size_t input_size, uint8_t *output,
  * @param hash     Output parameter for result hash.
  * @param hash_sel Hash function selector.
  *
- * @return EINVAL when key or message not specified,
- *         ENOMEM when pointer for output hash result
- *         is not allocated, otherwise EOK.
+ * @return EINVAL when key or message not specified or the hash
+ *         function is not supported, ENOMEM when pointer for output
+ *         hash result is not allocated, otherwise EOK.
  *
  */
 errno_t hmac(uint8_t *key, size_t key_size, uint8_t *msg, size_t msg_size,
     uint8_t *hash, hash_func_t hash_sel)
 {
+	hmac_ctx_t ctx;
+	errno_t rc;
+
 	if ((!key) || (!msg))
 		return EINVAL;
 
 	if (!hash)
 		return ENOMEM;
 
-	uint8_t work_key[HMAC_BLOCK_LENGTH];
-	uint8_t o_key_pad[HMAC_BLOCK_LENGTH];
-	uint8_t i_key_pad[HMAC_BLOCK_LENGTH];
-	uint8_t temp_hash[hash_sel];
-	memset(work_key, 0, HMAC_BLOCK_LENGTH);
-
-	if (key_size > HMAC_BLOCK_LENGTH)
-		create_hash(key, key_size, work_key, hash_sel);
-	else
-		memcpy(work_key, key, key_size);
-
-	for (size_t i = 0; i < HMAC_BLOCK_LENGTH; i++) {
-		o_key_pad[i] = work_key[i] ^ 0x5c;
-		i_key_pad[i] = work_key[i] ^ 0x36;
-	}
-
-	uint8_t temp_work[HMAC_BLOCK_LENGTH + max(msg_size, hash_sel)];
-	memcpy(temp_work, i_key_pad, HMAC_BLOCK_LENGTH);
-	memcpy(temp_work + HMAC_BLOCK_LENGTH, msg, msg_size);
-
-	create_hash(temp_work, HMAC_BLOCK_LENGTH + msg_size, temp_hash,
-	    hash_sel);
-
-	memcpy(temp_work, o_key_pad, HMAC_BLOCK_LENGTH);
-	memcpy(temp_work + HMAC_BLOCK_LENGTH, temp_hash, hash_sel);
-
-	create_hash(temp_work, HMAC_BLOCK_LENGTH + hash_sel, hash, hash_sel);
+	rc = hmac_init(&ctx, key, key_size, hash_sel);
+	if (rc != EOK)
+		return rc;
 
+	hmac_update(&ctx, msg, msg_size);
+	hmac_final(&ctx, hash);
 	return EOK;
 }
 
 /** Password-Based Key Derivation Function 2.
  *
  * As defined in RFC 2898, using HMAC-SHA1 with 4096 iterations
- * and 32 bytes key result used for WPA/WPA2.
+ * and 32 bytes key result used for WPA/WPA2. The password is absorbed
+ * into the HMAC context only once, each iteration then starts from
+ * a copy of it.
  *
  * @param pass      Password sequence.
  * @param pass_size Password sequence length.
@@ -328,31 +974,37 @@ errno_t hmac(uint8_t *key, size_t key_size, uint8_t *msg, size_t msg_size,
 errno_t pbkdf2(uint8_t *pass, size_t pass_size, uint8_t *salt, size_t salt_size,
     uint8_t *hash)
 {
+	hmac_ctx_t keyed;
+	hmac_ctx_t ctx;
+	errno_t rc;
+
 	if ((!pass) || (!salt))
 		return EINVAL;
 
 	if (!hash)
 		return ENOMEM;
 
-	uint8_t work_salt[salt_size + 4];
-	memcpy(work_salt, salt, salt_size);
+	rc = hmac_init(&keyed, pass, pass_size, HASH_SHA1);
+	if (rc != EOK)
+		return rc;
+
 	uint8_t work_hmac[HASH_SHA1];
-	uint8_t temp_hmac[HASH_SHA1];
 	uint8_t xor_hmac[HASH_SHA1];
 	uint8_t temp_hash[HASH_SHA1 * 2];
 
 	for (size_t i = 0; i < 2; i++) {
 		uint32_t be_i = host2uint32_t_be(i + 1);
 
-		memcpy(work_salt + salt_size, &be_i, 4);
-		hmac(pass, pass_size, work_salt, salt_size + 4,
-		    work_hmac, HASH_SHA1);
+		ctx = keyed;
+		hmac_update(&ctx, salt, salt_size);
+		hmac_update(&ctx, &be_i, 4);
+		hmac_final(&ctx, work_hmac);
 		memcpy(xor_hmac, work_hmac, HASH_SHA1);
 
 		for (size_t k = 1; k < 4096; k++) {
-			memcpy(temp_hmac, work_hmac, HASH_SHA1);
-			hmac(pass, pass_size, temp_hmac, HASH_SHA1,
-			    work_hmac, HASH_SHA1);
+			ctx = keyed;
+			hmac_update(&ctx, work_hmac, HASH_SHA1);
+			hmac_final(&ctx, work_hmac);
 
 			for (size_t t = 0; t < HASH_SHA1; t++)
 				xor_hmac[t] ^= work_hmac[t];
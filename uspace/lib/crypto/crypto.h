@@ -30,11 +30,17 @@
 #define LIBCRYPTO_H
 
 #include <errno.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 #define AES_CIPHER_LENGTH  16
+#define AES_ROUNDS         10
+#define AES_KEY_WORDS      (4 * (AES_ROUNDS + 1))
+#define AES_CTR_BLOCKS     4
 #define PBKDF2_KEY_LENGTH  32
+#define HASH_BLOCK_LENGTH  64
+#define HASH_MAX_LENGTH    32
 
 /* Left rotation for uint32_t. */
 #define rotl_uint32(val, shift) \
@@ -44,17 +50,67 @@
 #define rotr_uint32(val, shift) \
 	(((val) >> shift) | ((val) << (32 - shift)))
 
+/** AES-128 context with expanded key. */
+typedef struct {
+	/** Encryption round keys (columns, row 0 in least significant byte) */
+	uint32_t enc_key[AES_KEY_WORDS] __attribute__((aligned(16)));
+	/** Decryption round keys for the equivalent inverse cipher */
+	uint32_t dec_key[AES_KEY_WORDS] __attribute__((aligned(16)));
+	/** Use AES instructions */
+	bool aesni;
+} aes_ctx_t;
+
 /** Hash function selector and also result hash length indicator. */
 typedef enum {
-	HASH_MD5 =  16,
-	HASH_SHA1 = 20
+	HASH_MD5 =    16,
+	HASH_SHA1 =   20,
+	HASH_SHA256 = 32
 } hash_func_t;
 
+/** Incremental hash computation context. */
+typedef struct {
+	/** Hash function */
+	hash_func_t func;
+	/** Interim hash parts values */
+	uint32_t h[HASH_MAX_LENGTH / 4];
+	/** Incomplete input block */
+	uint8_t block[HASH_BLOCK_LENGTH];
+	/** Number of bytes in the incomplete block */
+	size_t block_len;
+	/** Total length of the message in bytes */
+	uint64_t length;
+} hash_ctx_t;
+
+/** HMAC computation context. */
+typedef struct {
+	/** Inner hash, keyed with the inner pad */
+	hash_ctx_t inner;
+	/** Outer hash, keyed with the outer pad */
+	hash_ctx_t outer;
+} hmac_ctx_t;
+
 extern errno_t rc4(uint8_t *, size_t, uint8_t *, size_t, size_t, uint8_t *);
 extern errno_t aes_encrypt(uint8_t *, uint8_t *, uint8_t *);
 extern errno_t aes_decrypt(uint8_t *, uint8_t *, uint8_t *);
+extern errno_t aes_init(aes_ctx_t *, const uint8_t *);
+extern void aes_encrypt_block(const aes_ctx_t *, const uint8_t *, uint8_t *);
+extern void aes_decrypt_block(const aes_ctx_t *, const uint8_t *, uint8_t *);
+extern void aes_ctr(const aes_ctx_t *, uint8_t *, const uint8_t *, uint8_t *,
+    size_t);
+extern errno_t aes_ccm_encrypt(const aes_ctx_t *, const uint8_t *, size_t,
+    const uint8_t *, size_t, const uint8_t *, size_t, uint8_t *, uint8_t *,
+    size_t);
+extern errno_t aes_ccm_decrypt(const aes_ctx_t *, const uint8_t *, size_t,
+    const uint8_t *, size_t, const uint8_t *, size_t, uint8_t *,
+    const uint8_t *, size_t);
+extern errno_t hash_init(hash_ctx_t *, hash_func_t);
+extern void hash_update(hash_ctx_t *, const void *, size_t);
+extern void hash_final(hash_ctx_t *, uint8_t *);
 extern errno_t create_hash(uint8_t *, size_t, uint8_t *, hash_func_t);
 extern errno_t hmac(uint8_t *, size_t, uint8_t *, size_t, uint8_t *, hash_func_t);
+extern errno_t hmac_init(hmac_ctx_t *, const uint8_t *, size_t, hash_func_t);
+extern void hmac_update(hmac_ctx_t *, const void *, size_t);
+extern void hmac_final(hmac_ctx_t *, uint8_t *);
 extern errno_t pbkdf2(uint8_t *, size_t, uint8_t *, size_t, uint8_t *);
 
 extern uint16_t crc16_ibm(uint16_t crc, uint8_t *buf, size_t len);
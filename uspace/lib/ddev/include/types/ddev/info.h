@@ -37,10 +37,22 @@
 
 #include <gfx/coord.h>
 
+/** Display device capabilities */
+typedef enum {
+	/** Device fills rectangles without touching the CPU-visible image */
+	ddev_cap_fill = 0x1,
+	/** Device copies bitmaps to the screen by itself */
+	ddev_cap_copy = 0x2,
+	/** Rendering is not visible until the GC is updated */
+	ddev_cap_buffered = 0x4
+} ddev_caps_t;
+
 /** Display device information */
 typedef struct {
 	/** Bounding rectangle */
 	gfx_rect_t rect;
+	/** Capabilities (combination of ddev_caps_t flags) */
+	ddev_caps_t caps;
 } ddev_info_t;
 
 #endif
@@ -233,6 +233,7 @@ PCUT_TEST(dev_get_info_success)
 	resp.info.rect.p0.y = 2;
 	resp.info.rect.p1.x = 3;
 	resp.info.rect.p1.y = 4;
+	resp.info.caps = ddev_cap_fill | ddev_cap_buffered;
 
 	rc = ddev_get_info(ddev, &info);
 	PCUT_ASSERT_ERRNO_VAL(resp.rc, rc);
@@ -241,6 +242,7 @@ PCUT_TEST(dev_get_info_success)
 	PCUT_ASSERT_INT_EQUALS(resp.info.rect.p0.y, info.rect.p0.y);
 	PCUT_ASSERT_INT_EQUALS(resp.info.rect.p1.x, info.rect.p1.x);
 	PCUT_ASSERT_INT_EQUALS(resp.info.rect.p1.y, info.rect.p1.y);
+	PCUT_ASSERT_INT_EQUALS(resp.info.caps, info.caps);
 
 	ddev_close(ddev);
 	rc = loc_service_unregister(sid);
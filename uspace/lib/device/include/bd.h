@@ -35,13 +35,51 @@
 #ifndef LIBDEVICE_BD_H
 #define LIBDEVICE_BD_H
 
+#include <adt/list.h>
 #include <async.h>
+#include <fibril_synch.h>
+#include <ipc/bd.h>
 #include <offset.h>
+#include <stdbool.h>
 
 typedef struct {
 	async_sess_t *sess;
+	/** Synchronizes access to the list of pending requests */
+	fibril_mutex_t lock;
+	/** Signalled when a request completes */
+	fibril_condvar_t cv;
+	/** Pending vectored requests */
+	list_t reqs; /* of bd_req_t */
+	/** Tag of the next vectored request */
+	sysarg_t next_tag;
+	/** Buffer shared with the server or @c NULL */
+	void *buf;
+	/** Size of the shared buffer */
+	size_t buf_size;
 } bd_t;
 
+/** Vectored block device request */
+typedef struct bd_req {
+	/** Link to bd_t.reqs */
+	link_t lreqs;
+	/** Tag identifying the request in the completion */
+	sysarg_t tag;
+	/** @c true to write, @c false to read */
+	bool write;
+	/** Extents, with data in the shared buffer */
+	const bd_vec_t *vec;
+	/** Number of extents */
+	size_t nvec;
+	/** Completion callback or @c NULL */
+	void (*done)(struct bd_req *, errno_t);
+	/** Argument for use by the completion callback */
+	void *arg;
+	/** @c true once the request has completed */
+	bool finished;
+	/** Result of the request */
+	errno_t rc;
+} bd_req_t;
+
 extern errno_t bd_open(async_sess_t *, bd_t **);
 extern void bd_close(bd_t *);
 extern errno_t bd_read_blocks(bd_t *, aoff64_t, size_t, void *, size_t);
@@ -50,6 +88,11 @@ extern errno_t bd_write_blocks(bd_t *, aoff64_t, size_t, const void *, size_t);
 extern errno_t bd_sync_cache(bd_t *, aoff64_t, size_t);
 extern errno_t bd_get_block_size(bd_t *, size_t *);
 extern errno_t bd_get_num_blocks(bd_t *, aoff64_t *);
+extern errno_t bd_buf_share(bd_t *, void *, size_t);
+extern errno_t bd_map(bd_t *, size_t, void **);
+extern errno_t bd_submit(bd_t *, bd_req_t *);
+extern errno_t bd_req_wait(bd_t *, bd_req_t *);
+extern errno_t bd_rw_vec(bd_t *, bool, const bd_vec_t *, size_t);
 
 #endif
 
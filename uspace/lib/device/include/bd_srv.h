@@ -38,6 +38,7 @@
 #include <adt/list.h>
 #include <async.h>
 #include <fibril_synch.h>
+#include <ipc/bd.h>
 #include <stdbool.h>
 #include <offset.h>
 
@@ -54,8 +55,38 @@ typedef struct {
 	bd_srvs_t *srvs;
 	async_sess_t *client_sess;
 	void *carg;
+	/** Buffer shared by the client or @c NULL */
+	void *buf;
+	/** Size of the shared buffer */
+	size_t buf_size;
+	/** Block size of the device */
+	size_t block_size;
+	/** Synchronizes access to @c io_pending */
+	fibril_mutex_t io_lock;
+	/** Signalled when a vectored request completes */
+	fibril_condvar_t io_cv;
+	/** Number of vectored requests in progress */
+	unsigned io_pending;
 } bd_srv_t;
 
+/** Vectored request in progress */
+typedef struct {
+	/** Server structure of the client session */
+	bd_srv_t *srv;
+	/** Tag identifying the request to the client */
+	sysarg_t tag;
+	/** @c true to write, @c false to read */
+	bool write;
+	/** Extents, validated against the shared buffer */
+	bd_vec_t *vec;
+	/** Number of extents */
+	size_t nvec;
+	/** Link for use by the server implementation */
+	link_t link;
+	/** Argument for use by the server implementation */
+	void *arg;
+} bd_io_t;
+
 struct bd_ops {
 	errno_t (*open)(bd_srvs_t *, bd_srv_t *);
 	errno_t (*close)(bd_srv_t *);
@@ -65,9 +96,18 @@ struct bd_ops {
 	errno_t (*write_blocks)(bd_srv_t *, aoff64_t, size_t, const void *, size_t);
 	errno_t (*get_block_size)(bd_srv_t *, size_t *);
 	errno_t (*get_num_blocks)(bd_srv_t *, aoff64_t *);
+	/** Start a vectored request, complete it using bd_io_done() */
+	errno_t (*submit)(bd_srv_t *, bd_io_t *);
+	/** Get the memory area holding the image of the whole device */
+	errno_t (*map)(bd_srv_t *, void **, size_t *);
+	/** Get the device and address to forward reads and writes to */
+	errno_t (*forward)(bd_srv_t *, aoff64_t, size_t, async_sess_t **,
+	    aoff64_t *);
 };
 
 extern void bd_srvs_init(bd_srvs_t *);
+extern void *bd_io_buf(bd_io_t *, size_t);
+extern void bd_io_done(bd_io_t *, errno_t);
 
 extern errno_t bd_conn(ipc_call_t *, bd_srvs_t *);
 
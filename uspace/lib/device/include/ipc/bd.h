@@ -36,6 +36,7 @@
 #define LIBDEVICE_IPC_BD_H
 
 #include <ipc/common.h>
+#include <stdint.h>
 
 typedef enum {
 	BD_GET_BLOCK_SIZE = IPC_FIRST_USER_METHOD,
@@ -43,9 +44,34 @@ typedef enum {
 	BD_READ_BLOCKS,
 	BD_SYNC_CACHE,
 	BD_WRITE_BLOCKS,
-	BD_READ_TOC
+	BD_READ_TOC,
+	BD_SHARE_BUF,
+	BD_READ_BLOCKS_V,
+	BD_WRITE_BLOCKS_V,
+	BD_MAP
 } bd_request_t;
 
+typedef enum {
+	BD_EV_IO_DONE = IPC_FIRST_USER_METHOD
+} bd_event_t;
+
+/** Maximum number of extents in one vectored request */
+#define BD_VEC_MAX  64
+
+/** Extent of a vectored request
+ *
+ * The data of the extent are located in the buffer shared with the server
+ * using BD_SHARE_BUF.
+ */
+typedef struct {
+	/** Address of first block */
+	uint64_t ba;
+	/** Number of blocks */
+	uint64_t cnt;
+	/** Offset of the data in the shared buffer */
+	uint64_t offs;
+} bd_vec_t;
+
 #endif
 
 /** @}
@@ -38,8 +38,12 @@
 #ifndef LIBDEVICE_NIC_H
 #define LIBDEVICE_NIC_H
 
+#include <mem.h>
 #include <nic/eth_phys.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /** Ethernet address length. */
 #define ETH_ADDR  6
@@ -75,6 +79,9 @@
 #define NIC_DEFECTIVE_BAD_TCP_CHECKSUM   0x0080
 #define NIC_DEFECTIVE_BAD_UDP_CHECKSUM   0x0100
 
+/** The NIC computes the transport checksum of frames to send */
+#define NIC_OFFLOAD_TX_CSUM  0x0001
+
 /**
  * The bitmap uses single bit for each of the 2^12 = 4096 possible VLAN tags.
  * This means its size is 4096/8 = 512 bytes.
@@ -222,6 +229,13 @@ typedef struct nic_device_stats {
 	unsigned long receive_compressed;
 	/** Total compressed packet transmitted. */
 	unsigned long send_compressed;
+
+	/* interrupt moderation */
+
+	/** Device interrupts handled by the driver. */
+	unsigned long interrupts;
+	/** Polls of the device done without an interrupt. */
+	unsigned long polls;
 } nic_device_stats_t;
 
 /** Errors corresponding to those in the nic_device_stats_t */
@@ -435,6 +449,125 @@ typedef enum nic_poll_mode {
 	NIC_POLL_SOFTWARE_PERIODIC
 } nic_poll_mode_t;
 
+/**
+ * Checksum the NIC should complete in a frame to send.
+ *
+ * The frame carries the checksum of the pseudo header in the checksum field
+ * and the NIC adds the sum of the frame from @c start up to its end.
+ */
+typedef struct {
+	/** Offset of the checksummed data in the frame */
+	uint16_t start;
+	/** Offset of the checksum field from @c start, 0 if there is none */
+	uint16_t offset;
+} nic_csum_t;
+
+/** Maximum number of receive or transmit queues of a NIC */
+#define NIC_QUEUES_MAX  8
+
+/** Size of the receive-side scaling hash key */
+#define NIC_RSS_KEY_SIZE  40
+
+/** Number of entries of the receive-side scaling redirection table */
+#define NIC_RSS_RETA_SIZE  128
+
+/** Receive-side scaling hash types */
+#define NIC_RSS_HASH_IPV4      0x0001
+#define NIC_RSS_HASH_TCP_IPV4  0x0002
+#define NIC_RSS_HASH_UDP_IPV4  0x0004
+#define NIC_RSS_HASH_IPV6      0x0008
+#define NIC_RSS_HASH_TCP_IPV6  0x0010
+#define NIC_RSS_HASH_UDP_IPV6  0x0020
+
+/** Receive and transmit queues of a NIC. */
+typedef struct {
+	/** Number of receive queues */
+	unsigned int rx_queues;
+	/** Number of transmit queues */
+	unsigned int tx_queues;
+	/** Supported hash types (NIC_RSS_HASH_*) */
+	uint32_t rss_hash_caps;
+	/** Maximum number of flow steering rules, zero if not supported */
+	unsigned int flows_max;
+} nic_queues_t;
+
+/**
+ * Receive-side scaling configuration.
+ *
+ * The Toeplitz hash of the addresses (and ports) of a received frame selects
+ * an entry of the redirection table, which holds the receive queue number.
+ */
+typedef struct {
+	/** Enabled hash types (NIC_RSS_HASH_*), zero to use queue 0 only */
+	uint32_t hash_types;
+	/** Hash key */
+	uint8_t key[NIC_RSS_KEY_SIZE];
+	/** Redirection table, indexed by the hash modulo its size */
+	uint8_t reta[NIC_RSS_RETA_SIZE];
+} nic_rss_t;
+
+/**
+ * Flow steering rule.
+ *
+ * Directs received IPv4 TCP or UDP frames to a receive queue, regardless of
+ * the hash. Fields which are zero match any value, addresses and ports are
+ * in host byte order.
+ */
+typedef struct {
+	/** IP protocol number */
+	uint8_t protocol;
+	/** Source address */
+	uint32_t src_addr;
+	/** Destination address */
+	uint32_t dest_addr;
+	/** Source port */
+	uint16_t src_port;
+	/** Destination port */
+	uint16_t dest_port;
+	/** Receive queue */
+	unsigned int queue;
+} nic_flow_t;
+
+/** Flow steering rule identifier */
+typedef unsigned int nic_flow_id_t;
+
+/** Number of frame slots in a shared frame ring */
+#define NIC_RING_SLOTS  64
+
+/** Size of a frame slot, enough for an Ethernet frame with a VLAN tag */
+#define NIC_RING_SLOT_SIZE  2048
+
+/**
+ * Ring of frames in memory shared between the NIC driver and its client.
+ *
+ * The ring has a single producer and a single consumer. The indices run
+ * freely and are taken modulo NIC_RING_SLOTS. Before the consumer stops
+ * looking at the ring it sets @c kick and the producer only notifies the
+ * consumer if it finds it set, so a burst of frames costs one notification.
+ */
+typedef struct {
+	/** Index of the next slot to be filled, written by the producer */
+	atomic_uint head;
+	/** Index of the next slot to be consumed, written by the consumer */
+	atomic_uint tail;
+	/** Consumer waits for a notification */
+	atomic_bool kick;
+	/** Sizes of the frames in the slots */
+	uint32_t size[NIC_RING_SLOTS];
+	/** Checksums to complete in the frames in the slots */
+	nic_csum_t csum[NIC_RING_SLOTS];
+	/** Frame data */
+	uint8_t data[NIC_RING_SLOTS][NIC_RING_SLOT_SIZE];
+} nic_ring_t;
+
+/** Frame rings shared between the NIC driver and its client. */
+typedef struct {
+	/** Received frames, produced by the driver */
+	nic_ring_t rx;
+	/** Frames to send, produced by the client */
+	nic_ring_t tx;
+} nic_rings_t;
+
 /**
  * Says if this virtue type is a multi-virtue (there can be multiple virtues of
  * this type at once).
@@ -456,6 +589,100 @@ static inline int nic_wv_is_multi(nic_wv_type_t type)
 	}
 }
 
+/** Initialize a frame ring.
+ *
+ * @param ring	Ring
+ */
+static inline void nic_ring_init(nic_ring_t *ring)
+{
+	atomic_init(&ring->head, 0);
+	atomic_init(&ring->tail, 0);
+	atomic_init(&ring->kick, true);
+}
+
+/** Put a frame to a ring (producer).
+ *
+ * @param ring		Ring
+ * @param data		Frame data
+ * @param size		Frame size, at most NIC_RING_SLOT_SIZE
+ * @param csum		Checksum to complete or @c NULL if there is none
+ * @param[out] kick	Set to @c true if the consumer needs to be notified
+ *
+ * @return @c true on success, @c false if the ring is full
+ */
+static inline bool nic_ring_put(nic_ring_t *ring, const void *data,
+    size_t size, const nic_csum_t *csum, bool *kick)
+{
+	unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+	if (head - atomic_load(&ring->tail) >= NIC_RING_SLOTS)
+		return false;
+
+	memcpy(ring->data[head % NIC_RING_SLOTS], data, size);
+	ring->size[head % NIC_RING_SLOTS] = size;
+	if (csum != NULL) {
+		ring->csum[head % NIC_RING_SLOTS] = *csum;
+	} else {
+		ring->csum[head % NIC_RING_SLOTS].start = 0;
+		ring->csum[head % NIC_RING_SLOTS].offset = 0;
+	}
+	atomic_store(&ring->head, head + 1);
+
+	*kick = atomic_exchange(&ring->kick, false);
+	return true;
+}
+
+/** Get the oldest frame in a ring without removing it (consumer).
+ *
+ * @param ring		Ring
+ * @param[out] size	Frame size
+ * @param[out] csum	Checksum to complete in the frame
+ *
+ * @return Frame data or @c NULL if the ring is empty
+ */
+static inline void *nic_ring_peek(nic_ring_t *ring, size_t *size,
+    nic_csum_t *csum)
+{
+	unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+	if (atomic_load(&ring->head) == tail)
+		return NULL;
+
+	*size = ring->size[tail % NIC_RING_SLOTS];
+	*csum = ring->csum[tail % NIC_RING_SLOTS];
+	return ring->data[tail % NIC_RING_SLOTS];
+}
+
+/** Remove the oldest frame from a ring (consumer).
+ *
+ * @param ring	Ring
+ */
+static inline void nic_ring_pop(nic_ring_t *ring)
+{
+	atomic_fetch_add(&ring->tail, 1);
+}
+
+/** Ask for a notification once the ring is empty (consumer).
+ *
+ * @param ring	Ring
+ *
+ * @return @c true if the consumer can wait for the notification, @c false
+ *         if a frame was put to the ring meanwhile and should be consumed
+ */
+static inline bool nic_ring_idle(nic_ring_t *ring)
+{
+	atomic_store(&ring->kick, true);
+
+	if (atomic_load(&ring->head) == atomic_load(&ring->tail))
+		return true;
+
+	/*
+	 * If the producer has already taken the flag, a notification is on its
+	 * way and the frame will be consumed when it arrives.
+	 */
+	return !atomic_exchange(&ring->kick, false);
+}
+
 static inline const char *nic_device_state_to_string(nic_device_state_t state)
 {
 	switch (state) {
@@ -34,6 +34,7 @@
  * @brief Block device client interface
  */
 
+#include <as.h>
 #include <async.h>
 #include <assert.h>
 #include <bd.h>
@@ -54,6 +55,10 @@ errno_t bd_open(async_sess_t *sess, bd_t **rbd)
 		return ENOMEM;
 
 	bd->sess = sess;
+	fibril_mutex_initialize(&bd->lock);
+	fibril_condvar_initialize(&bd->cv);
+	list_initialize(&bd->reqs);
+	bd->next_tag = 1;
 
 	async_exch_t *exch = async_exchange_begin(sess);
 
@@ -195,12 +200,226 @@ errno_t bd_get_num_blocks(bd_t *bd, aoff64_t *rnb)
 	return EOK;
 }
 
+/** Share a buffer with the block device server.
+ *
+ * The buffer holds the data of vectored requests. It must be an address
+ * space area of its own, such as one created by as_area_create(). Only one
+ * buffer can be shared over a session.
+ *
+ * @param bd	Block device
+ * @param buf	Start of the buffer
+ * @param size	Size of the buffer in bytes
+ *
+ * @return	EOK on success or an error code.
+ */
+errno_t bd_buf_share(bd_t *bd, void *buf, size_t size)
+{
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exch, BD_SHARE_BUF, &answer);
+	errno_t rc = async_share_out_start(exch, buf,
+	    AS_AREA_READ | AS_AREA_WRITE);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	if (retval != EOK)
+		return retval;
+
+	bd->buf = buf;
+	bd->buf_size = size;
+	return EOK;
+}
+
+/** Map the image of the whole device into the address space.
+ *
+ * Only devices residing in memory, such as a RAM disk, support this.
+ * The mapping is shared with the server, so writing to it changes the
+ * contents of the device directly.
+ *
+ * @param bd	Block device
+ * @param size	Size of the device in bytes, rounded up to whole pages
+ * @param rimage Place to store the start of the mapping
+ *
+ * @return	EOK on success, ENOTSUP if the device cannot be mapped or
+ *		another error code.
+ */
+errno_t bd_map(bd_t *bd, size_t size, void **rimage)
+{
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exch, BD_MAP, &answer);
+	void *image;
+	errno_t rc = async_share_in_start_0_0(exch, size, &image);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	if (retval != EOK) {
+		as_area_destroy(image);
+		return retval;
+	}
+
+	*rimage = image;
+	return EOK;
+}
+
+/** Submit a vectored request.
+ *
+ * The request is queued by the server and the function returns without
+ * waiting for it to complete, so a client can have many requests in
+ * flight. When a request completes, its @c done callback is called from
+ * the callback connection fibril. Use bd_req_wait() to wait for a request
+ * without a callback.
+ *
+ * @param bd	Block device, with a buffer shared by bd_buf_share()
+ * @param breq	Request. It must stay valid until it completes.
+ *
+ * @return	EOK if the request was queued or an error code.
+ */
+errno_t bd_submit(bd_t *bd, bd_req_t *breq)
+{
+	if (breq->nvec == 0 || breq->nvec > BD_VEC_MAX)
+		return EINVAL;
+
+	breq->finished = false;
+	breq->rc = EOK;
+
+	fibril_mutex_lock(&bd->lock);
+	breq->tag = bd->next_tag++;
+	list_append(&breq->lreqs, &bd->reqs);
+	fibril_mutex_unlock(&bd->lock);
+
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_2(exch, breq->write ? BD_WRITE_BLOCKS_V :
+	    BD_READ_BLOCKS_V, breq->tag, breq->nvec, &answer);
+	errno_t rc = async_data_write_start(exch, breq->vec,
+	    breq->nvec * sizeof(bd_vec_t));
+	async_exchange_end(exch);
+
+	errno_t retval;
+	if (rc != EOK) {
+		async_forget(req);
+		retval = rc;
+	} else {
+		async_wait_for(req, &retval);
+	}
+
+	if (retval != EOK) {
+		/* The request was not queued and will not complete. */
+		fibril_mutex_lock(&bd->lock);
+		list_remove(&breq->lreqs);
+		fibril_mutex_unlock(&bd->lock);
+		return retval;
+	}
+
+	return EOK;
+}
+
+/** Wait for a vectored request to complete.
+ *
+ * @param bd	Block device
+ * @param breq	Request submitted by bd_submit() without a callback
+ *
+ * @return	Result of the request.
+ */
+errno_t bd_req_wait(bd_t *bd, bd_req_t *breq)
+{
+	fibril_mutex_lock(&bd->lock);
+	while (!breq->finished)
+		fibril_condvar_wait(&bd->cv, &bd->lock);
+	fibril_mutex_unlock(&bd->lock);
+
+	return breq->rc;
+}
+
+/** Read or write blocks described by a vector and wait for completion.
+ *
+ * @param bd	Block device, with a buffer shared by bd_buf_share()
+ * @param write	@c true to write, @c false to read
+ * @param vec	Extents, with data in the shared buffer
+ * @param nvec	Number of extents
+ *
+ * @return	EOK on success or an error code.
+ */
+errno_t bd_rw_vec(bd_t *bd, bool write, const bd_vec_t *vec, size_t nvec)
+{
+	bd_req_t breq;
+
+	breq.write = write;
+	breq.vec = vec;
+	breq.nvec = nvec;
+	breq.done = NULL;
+	breq.arg = NULL;
+
+	errno_t rc = bd_submit(bd, &breq);
+	if (rc != EOK)
+		return rc;
+
+	return bd_req_wait(bd, &breq);
+}
+
+/** Complete a vectored request.
+ *
+ * @param bd	Block device
+ * @param call	BD_EV_IO_DONE event
+ */
+static void bd_io_done(bd_t *bd, ipc_call_t *call)
+{
+	sysarg_t tag = ipc_get_arg1(call);
+	errno_t rc = ipc_get_arg2(call);
+	bd_req_t *breq = NULL;
+
+	fibril_mutex_lock(&bd->lock);
+
+	list_foreach(bd->reqs, lreqs, bd_req_t, r) {
+		if (r->tag == tag) {
+			breq = r;
+			break;
+		}
+	}
+
+	if (breq == NULL) {
+		fibril_mutex_unlock(&bd->lock);
+		async_answer_0(call, ENOENT);
+		return;
+	}
+
+	list_remove(&breq->lreqs);
+
+	/* The callback may free the request, so grab it first. */
+	void (*done)(bd_req_t *, errno_t) = breq->done;
+	if (done == NULL) {
+		breq->rc = rc;
+		breq->finished = true;
+		fibril_condvar_broadcast(&bd->cv);
+	}
+
+	fibril_mutex_unlock(&bd->lock);
+	async_answer_0(call, EOK);
+
+	if (done != NULL)
+		done(breq, rc);
+}
+
 static void bd_cb_conn(ipc_call_t *icall, void *arg)
 {
 	bd_t *bd = (bd_t *)arg;
 
-	(void)bd;
-
 	while (true) {
 		ipc_call_t call;
 		async_get_call(&call);
@@ -211,6 +430,9 @@ static void bd_cb_conn(ipc_call_t *icall, void *arg)
 		}
 
 		switch (ipc_get_imethod(&call)) {
+		case BD_EV_IO_DONE:
+			bd_io_done(bd, &call);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 		}
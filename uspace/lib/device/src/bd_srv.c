@@ -33,6 +33,8 @@
  * @file
  * @brief Block device server stub
  */
+#include <as.h>
+#include <assert.h>
 #include <errno.h>
 #include <ipc/bd.h>
 #include <macros.h>
@@ -42,6 +44,67 @@
 
 #include <bd_srv.h>
 
+/** Forward a read or write request to the device holding the blocks.
+ *
+ * The data are transferred directly between the client and the device,
+ * with only the block address translated.
+ *
+ * @param srv	Server structure
+ * @param call	BD_READ_BLOCKS or BD_WRITE_BLOCKS request
+ * @param write	@c true if the request is BD_WRITE_BLOCKS
+ *
+ * @return	@c true if the request was forwarded or answered, @c false
+ *		if it should be served locally.
+ */
+static bool bd_forward_srv(bd_srv_t *srv, ipc_call_t *call, bool write)
+{
+	async_sess_t *sess;
+	async_exch_t *exch;
+	aoff64_t fba;
+	errno_t rc;
+
+	if (srv->srvs->ops->forward == NULL)
+		return false;
+
+	aoff64_t ba = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
+	size_t cnt = ipc_get_arg3(call);
+
+	rc = srv->srvs->ops->forward(srv, ba, cnt, &sess, &fba);
+	if (rc == ENOTSUP)
+		return false;
+
+	exch = NULL;
+	if (rc == EOK) {
+		exch = async_exchange_begin(sess);
+		if (exch == NULL)
+			rc = ENOMEM;
+	}
+
+	if (rc != EOK) {
+		/* Refuse the data transfer of the request. */
+		ipc_call_t dcall;
+		if (write)
+			async_data_write_receive(&dcall, NULL);
+		else
+			async_data_read_receive(&dcall, NULL);
+		async_answer_0(&dcall, rc);
+		async_answer_0(call, rc);
+		return true;
+	}
+
+	if (write) {
+		rc = async_data_write_forward_3_0(exch, BD_WRITE_BLOCKS,
+		    LOWER32(fba), UPPER32(fba), cnt);
+	} else {
+		rc = async_data_read_forward_3_0(exch, BD_READ_BLOCKS,
+		    LOWER32(fba), UPPER32(fba), cnt);
+	}
+
+	async_exchange_end(exch);
+	async_answer_0(call, rc);
+	return true;
+}
+
 static void bd_read_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 {
 	aoff64_t ba;
@@ -50,6 +113,9 @@ static void bd_read_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 	size_t size;
 	errno_t rc;
 
+	if (bd_forward_srv(srv, call, false))
+		return;
+
 	ba = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
 	cnt = ipc_get_arg3(call);
 
@@ -158,6 +224,9 @@ static void bd_write_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 	size_t size;
 	errno_t rc;
 
+	if (bd_forward_srv(srv, call, true))
+		return;
+
 	ba = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
 	cnt = ipc_get_arg3(call);
 
@@ -177,6 +246,228 @@ static void bd_write_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 	async_answer_0(call, rc);
 }
 
+static void bd_share_buf_srv(bd_srv_t *srv, ipc_call_t *call)
+{
+	ipc_call_t scall;
+	size_t size;
+	unsigned int flags;
+	void *buf;
+	errno_t rc;
+
+	if (!async_share_out_receive(&scall, &size, &flags)) {
+		async_answer_0(&scall, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (srv->buf != NULL) {
+		async_answer_0(&scall, EEXIST);
+		async_answer_0(call, EEXIST);
+		return;
+	}
+
+	/* The block size is needed to validate vectored requests. */
+	if (srv->srvs->ops->get_block_size == NULL ||
+	    srv->srvs->ops->get_block_size(srv, &srv->block_size) != EOK ||
+	    srv->block_size == 0) {
+		async_answer_0(&scall, ENOTSUP);
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	rc = async_share_out_finalize(&scall, &buf);
+	if (rc != EOK || buf == AS_MAP_FAILED) {
+		async_answer_0(call, ENOMEM);
+		return;
+	}
+
+	srv->buf = buf;
+	srv->buf_size = size;
+	async_answer_0(call, EOK);
+}
+
+static void bd_map_srv(bd_srv_t *srv, ipc_call_t *call)
+{
+	ipc_call_t scall;
+	size_t size;
+	void *image;
+	size_t image_size;
+	errno_t rc;
+
+	if (!async_share_in_receive(&scall, &size)) {
+		async_answer_0(&scall, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (srv->srvs->ops->map == NULL) {
+		async_answer_0(&scall, ENOTSUP);
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	rc = srv->srvs->ops->map(srv, &image, &image_size);
+	if (rc != EOK) {
+		async_answer_0(&scall, rc);
+		async_answer_0(call, rc);
+		return;
+	}
+
+	if (size != image_size) {
+		async_answer_0(&scall, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	rc = async_share_in_finalize(&scall, image,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE);
+	async_answer_0(call, rc);
+}
+
+/** Get pointer to the data of an extent of a vectored request.
+ *
+ * @param io	Vectored request
+ * @param i	Index of the extent
+ *
+ * @return	Pointer into the buffer shared by the client.
+ */
+void *bd_io_buf(bd_io_t *io, size_t i)
+{
+	assert(i < io->nvec);
+	return (uint8_t *) io->srv->buf + io->vec[i].offs;
+}
+
+/** Complete a vectored request.
+ *
+ * Sends the completion with the tag of the request to the client and
+ * frees the request. Can be called from any fibril.
+ *
+ * @param io	Vectored request
+ * @param rc	Result of the request
+ */
+void bd_io_done(bd_io_t *io, errno_t rc)
+{
+	bd_srv_t *srv = io->srv;
+
+	async_exch_t *exch = async_exchange_begin(srv->client_sess);
+	async_msg_2(exch, BD_EV_IO_DONE, io->tag, rc);
+	async_exchange_end(exch);
+
+	free(io->vec);
+	free(io);
+
+	fibril_mutex_lock(&srv->io_lock);
+	assert(srv->io_pending > 0);
+	srv->io_pending--;
+	fibril_condvar_broadcast(&srv->io_cv);
+	fibril_mutex_unlock(&srv->io_lock);
+}
+
+/** Carry out a vectored request using read_blocks/write_blocks.
+ *
+ * Used when the server does not implement the submit operation.
+ */
+static void bd_io_emulate(bd_srv_t *srv, bd_io_t *io)
+{
+	bd_ops_t *ops = srv->srvs->ops;
+	errno_t rc = EOK;
+
+	if ((io->write && ops->write_blocks == NULL) ||
+	    (!io->write && ops->read_blocks == NULL)) {
+		bd_io_done(io, ENOTSUP);
+		return;
+	}
+
+	for (size_t i = 0; i < io->nvec && rc == EOK; i++) {
+		void *data = bd_io_buf(io, i);
+		size_t size = io->vec[i].cnt * srv->block_size;
+
+		if (io->write) {
+			rc = ops->write_blocks(srv, io->vec[i].ba,
+			    io->vec[i].cnt, data, size);
+		} else {
+			rc = ops->read_blocks(srv, io->vec[i].ba,
+			    io->vec[i].cnt, data, size);
+		}
+	}
+
+	bd_io_done(io, rc);
+}
+
+static void bd_rw_blocks_v_srv(bd_srv_t *srv, ipc_call_t *call, bool write)
+{
+	sysarg_t tag;
+	size_t nvec;
+	bd_vec_t *vec;
+	bd_io_t *io;
+	size_t size;
+	errno_t rc;
+
+	tag = ipc_get_arg1(call);
+	nvec = ipc_get_arg2(call);
+
+	if (nvec == 0 || nvec > BD_VEC_MAX) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	rc = async_data_write_accept((void **) &vec, false,
+	    nvec * sizeof(bd_vec_t), nvec * sizeof(bd_vec_t), 0, &size);
+	if (rc != EOK) {
+		async_answer_0(call, rc);
+		return;
+	}
+
+	if (srv->buf == NULL) {
+		free(vec);
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	/* Make sure the extents lie within the shared buffer. */
+	for (size_t i = 0; i < nvec; i++) {
+		if (vec[i].cnt == 0 || vec[i].offs > srv->buf_size ||
+		    vec[i].cnt > (srv->buf_size - vec[i].offs) /
+		    srv->block_size) {
+			free(vec);
+			async_answer_0(call, EINVAL);
+			return;
+		}
+	}
+
+	io = calloc(1, sizeof(bd_io_t));
+	if (io == NULL) {
+		free(vec);
+		async_answer_0(call, ENOMEM);
+		return;
+	}
+
+	io->srv = srv;
+	io->tag = tag;
+	io->write = write;
+	io->vec = vec;
+	io->nvec = nvec;
+	link_initialize(&io->link);
+
+	fibril_mutex_lock(&srv->io_lock);
+	srv->io_pending++;
+	fibril_mutex_unlock(&srv->io_lock);
+
+	/*
+	 * Answer before starting the request, the completion is sent
+	 * separately over the callback session.
+	 */
+	async_answer_0(call, EOK);
+
+	if (srv->srvs->ops->submit != NULL) {
+		rc = srv->srvs->ops->submit(srv, io);
+		if (rc != EOK)
+			bd_io_done(io, rc);
+	} else {
+		bd_io_emulate(srv, io);
+	}
+}
+
 static void bd_get_block_size_srv(bd_srv_t *srv, ipc_call_t *call)
 {
 	errno_t rc;
@@ -214,6 +505,8 @@ static bd_srv_t *bd_srv_create(bd_srvs_t *srvs)
 		return NULL;
 
 	srv->srvs = srvs;
+	fibril_mutex_initialize(&srv->io_lock);
+	fibril_condvar_initialize(&srv->io_cv);
 	return srv;
 }
 
@@ -275,12 +568,33 @@ errno_t bd_conn(ipc_call_t *icall, bd_srvs_t *srvs)
 		case BD_GET_NUM_BLOCKS:
 			bd_get_num_blocks_srv(srv, &call);
 			break;
+		case BD_SHARE_BUF:
+			bd_share_buf_srv(srv, &call);
+			break;
+		case BD_READ_BLOCKS_V:
+			bd_rw_blocks_v_srv(srv, &call, false);
+			break;
+		case BD_WRITE_BLOCKS_V:
+			bd_rw_blocks_v_srv(srv, &call, true);
+			break;
+		case BD_MAP:
+			bd_map_srv(srv, &call);
+			break;
 		default:
 			async_answer_0(&call, EINVAL);
 		}
 	}
 
+	/* Wait for vectored requests still in progress. */
+	fibril_mutex_lock(&srv->io_lock);
+	while (srv->io_pending > 0)
+		fibril_condvar_wait(&srv->io_cv, &srv->io_lock);
+	fibril_mutex_unlock(&srv->io_lock);
+
 	rc = srvs->ops->close(srv);
+
+	if (srv->buf != NULL)
+		as_area_destroy(srv->buf);
 	free(srv);
 
 	return rc;
@@ -272,6 +272,9 @@ errno_t display_window_get_gc(display_window_t *window, gfx_context_t **rgc)
 		return ENOMEM;
 	}
 
+	/* Batching is only an optimization, without it we just go slower */
+	(void) ipc_gc_cmdbuf_enable(gc);
+
 	*rgc = ipc_gc_get_ctx(gc);
 	return EOK;
 }
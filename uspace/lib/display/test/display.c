@@ -74,6 +74,7 @@ static errno_t test_get_event(void *, sysarg_t *, display_wnd_ev_t *);
 static errno_t test_get_info(void *, display_info_t *);
 
 static errno_t test_gc_set_color(void *, gfx_color_t *);
+static errno_t test_gc_update(void *);
 
 static display_ops_t test_display_srv_ops = {
 	.window_create = test_window_create,
@@ -102,7 +103,8 @@ static display_wnd_cb_t test_display_wnd_cb = {
 };
 
 static gfx_context_ops_t test_gc_ops = {
-	.set_color = test_gc_set_color
+	.set_color = test_gc_set_color,
+	.update = test_gc_update
 };
 
 /** Describes to the server how to respond to our request and pass tracking
@@ -1580,6 +1582,10 @@ PCUT_TEST(window_get_gc_success)
 	resp.set_color_called = false;
 	rc = gfx_set_color(gc, color);
 	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Setting color may be batched until update */
+	rc = gfx_update(gc);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
 	PCUT_ASSERT_TRUE(resp.set_color_called);
 
 	gfx_color_delete(color);
@@ -2317,4 +2323,11 @@ static errno_t test_gc_set_color(void *arg, gfx_color_t *color)
 	return resp->rc;
 }
 
+static errno_t test_gc_update(void *arg)
+{
+	test_response_t *resp = (test_response_t *) arg;
+
+	return resp->rc;
+}
+
 PCUT_EXPORT(display);
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libdrv
+ * @{
+ */
+/** @file
+ * @brief Batched device interface calls.
+ *
+ * A batch sends a sequence of device interface calls to a function without
+ * waiting for their answers in between. The calls are sent through the ring
+ * channel of the session if one is attached, otherwise as ordinary IPC
+ * calls. Each call carries only register arguments and returns at most one
+ * value; methods which transfer data are not suitable for batching.
+ *
+ * The calls of a batch are executed in the order they were added, but their
+ * results become available only once the batch is flushed. A call whose
+ * arguments depend on the result of a previous one needs to be separated
+ * from it by ddf_batch_flush().
+ */
+
+#include <assert.h>
+#include <async.h>
+#include <errno.h>
+#include <stdint.h>
+
+#include "ddf/batch.h"
+
+/** Begin a batch of calls.
+ *
+ * @param batch Batch to initialize
+ * @param sess  Session with the function the calls are made to
+ */
+void ddf_batch_begin(ddf_batch_t *batch, async_sess_t *sess)
+{
+	batch->count = 0;
+	batch->rc = EOK;
+	batch->exch = async_exchange_begin(sess);
+	if (batch->exch == NULL)
+		batch->rc = ENOMEM;
+}
+
+/** Store the result of an answered call.
+ *
+ * @param batch Batch
+ * @param i     Index of the call
+ */
+static void ddf_batch_store(ddf_batch_t *batch, size_t i)
+{
+	sysarg_t val = ipc_get_arg1(&batch->answer[i]);
+
+	switch (batch->res_size[i]) {
+	case 0:
+		break;
+	case sizeof(uint8_t):
+		*(uint8_t *) batch->res[i] = (uint8_t) val;
+		break;
+	case sizeof(uint16_t):
+		*(uint16_t *) batch->res[i] = (uint16_t) val;
+		break;
+	case sizeof(uint32_t):
+		*(uint32_t *) batch->res[i] = (uint32_t) val;
+		break;
+	default:
+		assert(batch->res_size[i] == sizeof(sysarg_t));
+		*(sysarg_t *) batch->res[i] = val;
+		break;
+	}
+}
+
+/** Add a call to a batch.
+ *
+ * The batch is flushed first if it is full. If the batch has already
+ * failed, the call is not sent.
+ *
+ * @param batch    Batch
+ * @param iface    Device interface
+ * @param method   Method of the interface
+ * @param arg1     First argument of the method
+ * @param arg2     Second argument of the method
+ * @param arg3     Third argument of the method
+ * @param res      Where to store the first return argument of the call
+ *                 once it is answered, NULL if not needed
+ * @param res_size Size of @a res in bytes, one of 1, 2, 4 or
+ *                 sizeof(sysarg_t)
+ */
+void ddf_batch_call(ddf_batch_t *batch, dev_inferface_idx_t iface,
+    sysarg_t method, sysarg_t arg1, sysarg_t arg2, sysarg_t arg3, void *res,
+    size_t res_size)
+{
+	if (batch->count == DDF_BATCH_MAX)
+		(void) ddf_batch_flush(batch);
+
+	if (batch->rc != EOK)
+		return;
+
+	size_t i = batch->count;
+	batch->req[i] = async_ring_send(batch->exch, DEV_IFACE_ID(iface),
+	    method, arg1, arg2, arg3, 0, &batch->answer[i]);
+	if (batch->req[i] == 0) {
+		batch->rc = ENOMEM;
+		return;
+	}
+
+	batch->res[i] = res;
+	batch->res_size[i] = (res != NULL) ? res_size : 0;
+	batch->count++;
+}
+
+/** Wait for all outstanding calls of a batch.
+ *
+ * @param batch Batch
+ * @return EOK if all calls of the batch so far succeeded, otherwise
+ *         the error code of the first one which failed
+ */
+errno_t ddf_batch_flush(ddf_batch_t *batch)
+{
+	for (size_t i = 0; i < batch->count; i++) {
+		errno_t rc;
+		async_wait_for(batch->req[i], &rc);
+		if (rc == EOK)
+			ddf_batch_store(batch, i);
+		else if (batch->rc == EOK)
+			batch->rc = rc;
+	}
+
+	batch->count = 0;
+	return batch->rc;
+}
+
+/** End a batch of calls.
+ *
+ * Waits for all outstanding calls and ends the exchange.
+ *
+ * @param batch Batch
+ * @return EOK if all calls of the batch succeeded, otherwise the error
+ *         code of the first one which failed
+ */
+errno_t ddf_batch_end(ddf_batch_t *batch)
+{
+	errno_t rc = ddf_batch_flush(batch);
+
+	if (batch->exch != NULL) {
+		async_exchange_end(batch->exch);
+		batch->exch = NULL;
+	}
+
+	return rc;
+}
+
+/** @}
+ */
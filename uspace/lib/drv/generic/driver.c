@@ -656,6 +656,12 @@ const char *ddf_dev_get_name(ddf_dev_t *dev)
 }
 
 /** Return existing session with the parent function.
+ *
+ * The initial connection is forwarded by the device manager to the driver
+ * of the parent function, so calls on the session reach it directly. The
+ * session is then pointed at the parent function itself, which lets
+ * further connections made from it, such as parallel exchanges or a ring
+ * channel attached with async_ring_attach(), bypass the device manager too.
  *
  * @param dev	Device
  * @return	Session with parent function or NULL upon failure
@@ -665,6 +671,14 @@ async_sess_t *ddf_dev_parent_sess_get(ddf_dev_t *dev)
 	if (dev->parent_sess == NULL) {
 		dev->parent_sess = devman_parent_device_connect(dev->handle,
 		    IPC_FLAG_BLOCKING);
+		if (dev->parent_sess == NULL)
+			return NULL;
+
+		devman_handle_t pfun_handle;
+		if (devman_dev_get_parent(dev->handle, &pfun_handle) == EOK) {
+			async_sess_args_set(dev->parent_sess,
+			    INTERFACE_DDF_DRIVER, pfun_handle, 0);
+		}
 	}
 
 	return dev->parent_sess;
@@ -997,6 +1011,17 @@ errno_t ddf_driver_main(const driver_t *drv)
 		return rc;
 	}
 
+	/*
+	 * Child drivers may attach ring channels to their parent sessions
+	 * for register-only interface calls. Client connections can be
+	 * exclusive and are therefore left out.
+	 */
+	rc = async_ring_enable(INTERFACE_DDF_DRIVER);
+	if (rc != EOK) {
+		printf("Error: Failed to enable driver port rings.\n");
+		return rc;
+	}
+
 	async_set_fallback_port_handler(driver_connection_client, NULL);
 
 	rc = devman_driver_register(driver->name);
@@ -34,9 +34,11 @@
 
 #include <as.h>
 #include <async.h>
+#include <fibril.h>
 #include <devman.h>
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <macros.h>
 #include <str.h>
 #include "ahci_iface.h"
@@ -274,38 +276,49 @@ static void remote_ahci_get_block_size(ddf_fun_t *fun, void *iface,
 		async_answer_1(call, EOK, blocks);
 }
 
-void remote_ahci_read_blocks(ddf_fun_t *fun, void *iface, ipc_call_t *call)
-{
-	const ahci_iface_t *ahci_iface = (ahci_iface_t *) iface;
-
-	if (ahci_iface->read_blocks == NULL) {
-		async_answer_0(call, ENOTSUP);
-		return;
-	}
-
-	ipc_call_t data;
-	size_t maxblock_size;
-	unsigned int flags;
-	async_share_out_receive(&data, &maxblock_size, &flags);
-
+/** Read or write request being carried out by a fibril of its own. */
+typedef struct {
+	ddf_fun_t *fun;
+	const ahci_iface_t *ahci_iface;
+	ipc_call_t call;
+	bool write;
 	void *buf;
-	async_share_out_finalize(&data, &buf);
+} remote_ahci_rw_t;
+
+static errno_t remote_ahci_rw_fibril(void *arg)
+{
+	remote_ahci_rw_t *rw = (remote_ahci_rw_t *) arg;
 
 	const uint64_t blocknum =
-	    (((uint64_t) (DEV_IPC_GET_ARG1(*call))) << 32) |
-	    (((uint64_t) (DEV_IPC_GET_ARG2(*call))) & 0xffffffff);
-	const size_t cnt = (size_t) DEV_IPC_GET_ARG3(*call);
+	    (((uint64_t) (DEV_IPC_GET_ARG1(rw->call))) << 32) |
+	    (((uint64_t) (DEV_IPC_GET_ARG2(rw->call))) & 0xffffffff);
+	const size_t cnt = (size_t) DEV_IPC_GET_ARG3(rw->call);
 
-	const errno_t ret = ahci_iface->read_blocks(fun, blocknum, cnt, buf);
+	errno_t ret;
+	if (rw->write)
+		ret = rw->ahci_iface->write_blocks(rw->fun, blocknum, cnt, rw->buf);
+	else
+		ret = rw->ahci_iface->read_blocks(rw->fun, blocknum, cnt, rw->buf);
 
-	async_answer_0(call, ret);
+	as_area_destroy(rw->buf);
+	async_answer_0(&rw->call, ret);
+	free(rw);
+
+	return EOK;
 }
 
-void remote_ahci_write_blocks(ddf_fun_t *fun, void *iface, ipc_call_t *call)
+/** Start a read or write request.
+ *
+ * The request is carried out by a fibril of its own, so that the client can
+ * have several requests queued in the device at the same time.
+ */
+static void remote_ahci_rw_blocks(ddf_fun_t *fun, void *iface,
+    ipc_call_t *call, bool write)
 {
 	const ahci_iface_t *ahci_iface = (ahci_iface_t *) iface;
 
-	if (ahci_iface->read_blocks == NULL) {
+	if ((write && ahci_iface->write_blocks == NULL) ||
+	    (!write && ahci_iface->read_blocks == NULL)) {
 		async_answer_0(call, ENOTSUP);
 		return;
 	}
@@ -313,19 +326,50 @@ void remote_ahci_write_blocks(ddf_fun_t *fun, void *iface, ipc_call_t *call)
 	ipc_call_t data;
 	size_t maxblock_size;
 	unsigned int flags;
-	async_share_out_receive(&data, &maxblock_size, &flags);
+	if (!async_share_out_receive(&data, &maxblock_size, &flags)) {
+		async_answer_0(&data, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
 
 	void *buf;
-	async_share_out_finalize(&data, &buf);
+	errno_t rc = async_share_out_finalize(&data, &buf);
+	if (rc != EOK || buf == AS_MAP_FAILED) {
+		async_answer_0(call, ENOMEM);
+		return;
+	}
 
-	const uint64_t blocknum =
-	    (((uint64_t)(DEV_IPC_GET_ARG1(*call))) << 32) |
-	    (((uint64_t)(DEV_IPC_GET_ARG2(*call))) & 0xffffffff);
-	const size_t cnt = (size_t) DEV_IPC_GET_ARG3(*call);
+	remote_ahci_rw_t *rw = calloc(1, sizeof(remote_ahci_rw_t));
+	if (rw == NULL) {
+		as_area_destroy(buf);
+		async_answer_0(call, ENOMEM);
+		return;
+	}
 
-	const errno_t ret = ahci_iface->write_blocks(fun, blocknum, cnt, buf);
+	rw->fun = fun;
+	rw->ahci_iface = ahci_iface;
+	rw->call = *call;
+	rw->write = write;
+	rw->buf = buf;
 
-	async_answer_0(call, ret);
+	fid_t fid = fibril_create(remote_ahci_rw_fibril, rw);
+	if (fid == 0) {
+		/* Carry out the request synchronously. */
+		(void) remote_ahci_rw_fibril(rw);
+		return;
+	}
+
+	fibril_add_ready(fid);
+}
+
+void remote_ahci_read_blocks(ddf_fun_t *fun, void *iface, ipc_call_t *call)
+{
+	remote_ahci_rw_blocks(fun, iface, call, false);
+}
+
+void remote_ahci_write_blocks(ddf_fun_t *fun, void *iface, ipc_call_t *call)
+{
+	remote_ahci_rw_blocks(fun, iface, call, true);
 }
 
 /**
@@ -46,6 +46,8 @@ static void remote_hw_res_disable_interrupt(ddf_fun_t *, void *, ipc_call_t *);
 static void remote_hw_res_clear_interrupt(ddf_fun_t *, void *, ipc_call_t *);
 static void remote_hw_res_dma_channel_setup(ddf_fun_t *, void *, ipc_call_t *);
 static void remote_hw_res_dma_channel_remain(ddf_fun_t *, void *, ipc_call_t *);
+static void remote_hw_res_msi_setup(ddf_fun_t *, void *, ipc_call_t *);
+static void remote_hw_res_msi_release(ddf_fun_t *, void *, ipc_call_t *);
 
 static const remote_iface_func_ptr_t remote_hw_res_iface_ops [] = {
 	[HW_RES_GET_RESOURCE_LIST] = &remote_hw_res_get_resource_list,
@@ -54,6 +56,8 @@ static const remote_iface_func_ptr_t remote_hw_res_iface_ops [] = {
 	[HW_RES_CLEAR_INTERRUPT] = &remote_hw_res_clear_interrupt,
 	[HW_RES_DMA_CHANNEL_SETUP] = &remote_hw_res_dma_channel_setup,
 	[HW_RES_DMA_CHANNEL_REMAIN] = &remote_hw_res_dma_channel_remain,
+	[HW_RES_MSI_SETUP] = &remote_hw_res_msi_setup,
+	[HW_RES_MSI_RELEASE] = &remote_hw_res_msi_release,
 };
 
 const remote_iface_t remote_hw_res_iface = {
@@ -170,6 +174,36 @@ static void remote_hw_res_dma_channel_remain(ddf_fun_t *fun, void *ops,
 	async_answer_1(call, ret, remain);
 }
 
+static void remote_hw_res_msi_setup(ddf_fun_t *fun, void *ops,
+    ipc_call_t *call)
+{
+	hw_res_ops_t *hw_res_ops = ops;
+
+	if (hw_res_ops->msi_setup == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	size_t count = DEV_IPC_GET_ARG1(*call);
+	int irq = 0;
+	const errno_t ret = hw_res_ops->msi_setup(fun, &count, &irq);
+	async_answer_2(call, ret, irq, count);
+}
+
+static void remote_hw_res_msi_release(ddf_fun_t *fun, void *ops,
+    ipc_call_t *call)
+{
+	hw_res_ops_t *hw_res_ops = ops;
+
+	if (hw_res_ops->msi_release == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	const errno_t ret = hw_res_ops->msi_release(fun);
+	async_answer_0(call, ret);
+}
+
 /**
  * @}
  */
@@ -34,6 +34,7 @@
  * @brief Driver-side RPC skeletons for DDF NIC interface
  */
 
+#include <as.h>
 #include <assert.h>
 #include <async.h>
 #include <errno.h>
@@ -85,7 +86,14 @@ typedef enum {
 	NIC_OFFLOAD_SET,
 	NIC_POLL_GET_MODE,
 	NIC_POLL_SET_MODE,
-	NIC_POLL_NOW
+	NIC_POLL_NOW,
+	NIC_RINGS_SETUP,
+	NIC_TX_KICK,
+	NIC_QUEUES_GET,
+	NIC_RSS_GET,
+	NIC_RSS_SET,
+	NIC_FLOW_ADD,
+	NIC_FLOW_REMOVE
 } nic_funcs_t;
 
 /** Send frame from NIC
@@ -93,17 +101,21 @@ typedef enum {
  * @param[in] dev_sess
  * @param[in] data     Frame data
  * @param[in] size     Frame size in bytes
+ * @param[in] csum     Checksum the NIC should complete or NULL if the frame
+ *                     is complete
  *
  * @return EOK If the operation was successfully completed
  *
  */
-errno_t nic_send_frame(async_sess_t *dev_sess, void *data, size_t size)
+errno_t nic_send_frame(async_sess_t *dev_sess, void *data, size_t size,
+    const nic_csum_t *csum)
 {
 	async_exch_t *exch = async_exchange_begin(dev_sess);
 
 	ipc_call_t answer;
-	aid_t req = async_send_1(exch, DEV_IFACE_ID(NIC_DEV_IFACE),
-	    NIC_SEND_MESSAGE, &answer);
+	aid_t req = async_send_3(exch, DEV_IFACE_ID(NIC_DEV_IFACE),
+	    NIC_SEND_MESSAGE, csum != NULL ? csum->start : 0,
+	    csum != NULL ? csum->offset : 0, &answer);
 	errno_t retval = async_data_write_start(exch, data, size);
 
 	async_exchange_end(exch);
@@ -1335,6 +1347,203 @@ errno_t nic_poll_now(async_sess_t *dev_sess)
 	return rc;
 }
 
+/** Share frame rings with the NIC
+ *
+ * The rings must be initialized and placed at the beginning of a memory
+ * area created by the caller. Once shared, received frames are passed in
+ * the rx ring (see NIC_EV_RX_KICK) and frames can be sent using the tx ring
+ * (see nic_tx_kick()).
+ *
+ * @param[in] dev_sess
+ * @param[in] rings    Frame rings
+ *
+ * @return EOK If the operation was successfully completed
+ * @return ENOTSUP If the NIC does not support frame rings
+ *
+ */
+errno_t nic_rings_setup(async_sess_t *dev_sess, nic_rings_t *rings)
+{
+	async_exch_t *exch = async_exchange_begin(dev_sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_1(exch, DEV_IFACE_ID(NIC_DEV_IFACE),
+	    NIC_RINGS_SETUP, &answer);
+	errno_t rc = async_share_out_start(exch, rings,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE);
+
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	async_wait_for(req, &rc);
+	return rc;
+}
+
+/** Notify the NIC about frames put to the tx ring
+ *
+ * @param[in] dev_sess
+ * @param[in] wait     If true, wait until the NIC has sent all frames in
+ *                     the ring, otherwise do not wait at all
+ *
+ * @return EOK If the operation was successfully completed
+ *
+ */
+errno_t nic_tx_kick(async_sess_t *dev_sess, bool wait)
+{
+	errno_t rc = EOK;
+
+	async_exch_t *exch = async_exchange_begin(dev_sess);
+	if (wait)
+		rc = async_req_1_0(exch, DEV_IFACE_ID(NIC_DEV_IFACE), NIC_TX_KICK);
+	else
+		async_msg_1(exch, DEV_IFACE_ID(NIC_DEV_IFACE), NIC_TX_KICK);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
+/** Get the receive and transmit queues of the NIC
+ *
+ * @param[in]  dev_sess
+ * @param[out] queues   Queue counts and capabilities
+ *
+ * @return EOK If the operation was successfully completed
+ *
+ */
+errno_t nic_queues_get(async_sess_t *dev_sess, nic_queues_t *queues)
+{
+	assert(queues);
+
+	async_exch_t *exch = async_exchange_begin(dev_sess);
+
+	errno_t rc = async_req_1_0(exch, DEV_IFACE_ID(NIC_DEV_IFACE),
+	    NIC_QUEUES_GET);
+	if (rc != EOK) {
+		async_exchange_end(exch);
+		return rc;
+	}
+
+	rc = async_data_read_start(exch, queues, sizeof(nic_queues_t));
+	async_exchange_end(exch);
+
+	return rc;
+}
+
+/** Get the receive-side scaling configuration
+ *
+ * @param[in]  dev_sess
+ * @param[out] rss      Current configuration
+ *
+ * @return EOK If the operation was successfully completed
+ *
+ */
+errno_t nic_rss_get(async_sess_t *dev_sess, nic_rss_t *rss)
+{
+	assert(rss);
+
+	async_exch_t *exch = async_exchange_begin(dev_sess);
+
+	errno_t rc = async_req_1_0(exch, DEV_IFACE_ID(NIC_DEV_IFACE),
+	    NIC_RSS_GET);
+	if (rc != EOK) {
+		async_exchange_end(exch);
+		return rc;
+	}
+
+	rc = async_data_read_start(exch, rss, sizeof(nic_rss_t));
+	async_exchange_end(exch);
+
+	return rc;
+}
+
+/** Set the receive-side scaling configuration
+ *
+ * @param[in] dev_sess
+ * @param[in] rss      New configuration
+ *
+ * @return EOK If the operation was successfully completed
+ * @return EINVAL If the configuration uses an unsupported hash type or
+ *                a queue the NIC does not have
+ *
+ */
+errno_t nic_rss_set(async_sess_t *dev_sess, const nic_rss_t *rss)
+{
+	assert(rss);
+
+	async_exch_t *exch = async_exchange_begin(dev_sess);
+
+	aid_t message_id = async_send_1(exch, DEV_IFACE_ID(NIC_DEV_IFACE),
+	    NIC_RSS_SET, NULL);
+	errno_t rc = async_data_write_start(exch, rss, sizeof(nic_rss_t));
+
+	async_exchange_end(exch);
+
+	errno_t res;
+	async_wait_for(message_id, &res);
+
+	if (rc != EOK)
+		return rc;
+
+	return res;
+}
+
+/** Add a flow steering rule
+ *
+ * @param[in]  dev_sess
+ * @param[in]  flow     Rule
+ * @param[out] id       Identifier of the new rule
+ *
+ * @return EOK If the operation was successfully completed
+ * @return ELIMIT If the NIC cannot hold more rules
+ * @return ENOTSUP If the NIC does not support flow steering
+ *
+ */
+errno_t nic_flow_add(async_sess_t *dev_sess, const nic_flow_t *flow,
+    nic_flow_id_t *id)
+{
+	assert(flow);
+	assert(id);
+
+	async_exch_t *exch = async_exchange_begin(dev_sess);
+
+	ipc_call_t result;
+	aid_t message_id = async_send_1(exch, DEV_IFACE_ID(NIC_DEV_IFACE),
+	    NIC_FLOW_ADD, &result);
+	errno_t rc = async_data_write_start(exch, flow, sizeof(nic_flow_t));
+
+	async_exchange_end(exch);
+
+	errno_t res;
+	async_wait_for(message_id, &res);
+
+	if (rc != EOK)
+		return rc;
+
+	*id = ipc_get_arg1(&result);
+	return res;
+}
+
+/** Remove a flow steering rule
+ *
+ * @param[in] dev_sess
+ * @param[in] id       Rule identifier
+ *
+ * @return EOK If the operation was successfully completed
+ *
+ */
+errno_t nic_flow_remove(async_sess_t *dev_sess, nic_flow_id_t id)
+{
+	async_exch_t *exch = async_exchange_begin(dev_sess);
+	errno_t rc = async_req_2_0(exch, DEV_IFACE_ID(NIC_DEV_IFACE),
+	    NIC_FLOW_REMOVE, (sysarg_t) id);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
 static void remote_nic_send_frame(ddf_fun_t *dev, void *iface,
     ipc_call_t *call)
 {
@@ -1343,15 +1552,20 @@ static void remote_nic_send_frame(ddf_fun_t *dev, void *iface,
 
 	void *data;
 	size_t size;
+	nic_csum_t csum;
 	errno_t rc;
 
+	csum.start = ipc_get_arg2(call);
+	csum.offset = ipc_get_arg3(call);
+
 	rc = async_data_write_accept(&data, false, 0, 0, 0, &size);
 	if (rc != EOK) {
 		async_answer_0(call, EINVAL);
 		return;
 	}
 
-	rc = nic_iface->send_frame(dev, data, size);
+	rc = nic_iface->send_frame(dev, data, size,
+	    csum.offset != 0 ? &csum : NULL);
 	async_answer_0(call, rc);
 	free(data);
 }
@@ -2485,6 +2699,214 @@ static void remote_nic_poll_now(ddf_fun_t *dev, void *iface,
 	async_answer_0(call, rc);
 }
 
+static void remote_nic_rings_setup(ddf_fun_t *dev, void *iface,
+    ipc_call_t *call)
+{
+	nic_iface_t *nic_iface = (nic_iface_t *) iface;
+	ipc_call_t data;
+	unsigned int flags;
+	size_t size;
+	void *rings;
+
+	if (!async_share_out_receive(&data, &size, &flags)) {
+		async_answer_0(&data, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (nic_iface->rings_setup == NULL) {
+		async_answer_0(&data, ENOTSUP);
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	if (size < sizeof(nic_rings_t)) {
+		async_answer_0(&data, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	errno_t rc = async_share_out_finalize(&data, &rings);
+	if (rc != EOK || rings == AS_MAP_FAILED) {
+		async_answer_0(call, ENOMEM);
+		return;
+	}
+
+	rc = nic_iface->rings_setup(dev, (nic_rings_t *) rings);
+	if (rc != EOK)
+		as_area_destroy(rings);
+
+	async_answer_0(call, rc);
+}
+
+static void remote_nic_tx_kick(ddf_fun_t *dev, void *iface,
+    ipc_call_t *call)
+{
+	nic_iface_t *nic_iface = (nic_iface_t *) iface;
+	if (nic_iface->tx_kick == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	errno_t rc = nic_iface->tx_kick(dev);
+	async_answer_0(call, rc);
+}
+
+static void remote_nic_queues_get(ddf_fun_t *dev, void *iface,
+    ipc_call_t *call)
+{
+	nic_iface_t *nic_iface = (nic_iface_t *) iface;
+	if (nic_iface->queues_get == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	nic_queues_t queues;
+	memset(&queues, 0, sizeof(nic_queues_t));
+
+	errno_t rc = nic_iface->queues_get(dev, &queues);
+	if (rc != EOK) {
+		async_answer_0(call, rc);
+		return;
+	}
+
+	ipc_call_t data;
+	size_t max_len;
+	if (!async_data_read_receive(&data, &max_len)) {
+		async_answer_0(&data, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (max_len != sizeof(nic_queues_t)) {
+		async_answer_0(&data, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	async_data_read_finalize(&data, &queues, max_len);
+	async_answer_0(call, EOK);
+}
+
+static void remote_nic_rss_get(ddf_fun_t *dev, void *iface,
+    ipc_call_t *call)
+{
+	nic_iface_t *nic_iface = (nic_iface_t *) iface;
+	if (nic_iface->rss_get == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	nic_rss_t rss;
+	memset(&rss, 0, sizeof(nic_rss_t));
+
+	errno_t rc = nic_iface->rss_get(dev, &rss);
+	if (rc != EOK) {
+		async_answer_0(call, rc);
+		return;
+	}
+
+	ipc_call_t data;
+	size_t max_len;
+	if (!async_data_read_receive(&data, &max_len)) {
+		async_answer_0(&data, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (max_len != sizeof(nic_rss_t)) {
+		async_answer_0(&data, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	async_data_read_finalize(&data, &rss, max_len);
+	async_answer_0(call, EOK);
+}
+
+static void remote_nic_rss_set(ddf_fun_t *dev, void *iface,
+    ipc_call_t *call)
+{
+	nic_iface_t *nic_iface = (nic_iface_t *) iface;
+	ipc_call_t data;
+	size_t length;
+	nic_rss_t rss;
+
+	if (!async_data_write_receive(&data, &length)) {
+		async_answer_0(&data, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (length != sizeof(nic_rss_t)) {
+		async_answer_0(&data, ELIMIT);
+		async_answer_0(call, ELIMIT);
+		return;
+	}
+
+	if (async_data_write_finalize(&data, &rss, length) != EOK) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (nic_iface->rss_set != NULL) {
+		errno_t rc = nic_iface->rss_set(dev, &rss);
+		async_answer_0(call, rc);
+	} else
+		async_answer_0(call, ENOTSUP);
+}
+
+static void remote_nic_flow_add(ddf_fun_t *dev, void *iface,
+    ipc_call_t *call)
+{
+	nic_iface_t *nic_iface = (nic_iface_t *) iface;
+	nic_flow_id_t id = 0;
+	ipc_call_t data;
+	size_t length;
+	nic_flow_t flow;
+
+	if (!async_data_write_receive(&data, &length)) {
+		async_answer_0(&data, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (length != sizeof(nic_flow_t)) {
+		async_answer_0(&data, ELIMIT);
+		async_answer_0(call, ELIMIT);
+		return;
+	}
+
+	if (async_data_write_finalize(&data, &flow, length) != EOK) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (nic_iface->flow_add == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	errno_t rc = nic_iface->flow_add(dev, &flow, &id);
+	async_answer_1(call, rc, (sysarg_t) id);
+}
+
+static void remote_nic_flow_remove(ddf_fun_t *dev, void *iface,
+    ipc_call_t *call)
+{
+	nic_iface_t *nic_iface = (nic_iface_t *) iface;
+
+	if (nic_iface->flow_remove == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	nic_flow_id_t id = (nic_flow_id_t) ipc_get_arg2(call);
+
+	errno_t rc = nic_iface->flow_remove(dev, id);
+	async_answer_0(call, rc);
+}
+
 /** Remote NIC interface operations.
  *
  */
@@ -2529,7 +2951,14 @@ static const remote_iface_func_ptr_t remote_nic_iface_ops[] = {
 	[NIC_OFFLOAD_SET] = remote_nic_offload_set,
 	[NIC_POLL_GET_MODE] = remote_nic_poll_get_mode,
 	[NIC_POLL_SET_MODE] = remote_nic_poll_set_mode,
-	[NIC_POLL_NOW] = remote_nic_poll_now
+	[NIC_POLL_NOW] = remote_nic_poll_now,
+	[NIC_RINGS_SETUP] = remote_nic_rings_setup,
+	[NIC_TX_KICK] = remote_nic_tx_kick,
+	[NIC_QUEUES_GET] = remote_nic_queues_get,
+	[NIC_RSS_GET] = remote_nic_rss_get,
+	[NIC_RSS_SET] = remote_nic_rss_set,
+	[NIC_FLOW_ADD] = remote_nic_flow_add,
+	[NIC_FLOW_REMOVE] = remote_nic_flow_remove
 };
 
 /** Remote NIC interface structure.
@@ -123,6 +123,84 @@ errno_t pci_config_space_write_32(async_sess_t *sess, uint32_t address,
 	return rc;
 }
 
+/** Add reading a byte of the configuration space to a batch.
+ *
+ * @param batch   Batch of calls to the PCI function
+ * @param address Address in the configuration space
+ * @param val     Where to store the value once the batch is flushed
+ */
+void pci_config_space_batch_read_8(ddf_batch_t *batch, uint32_t address,
+    uint8_t *val)
+{
+	ddf_batch_call(batch, PCI_DEV_IFACE, IPC_M_CONFIG_SPACE_READ_8,
+	    address, 0, 0, val, sizeof(*val));
+}
+
+/** Add reading a word of the configuration space to a batch.
+ *
+ * @param batch   Batch of calls to the PCI function
+ * @param address Address in the configuration space
+ * @param val     Where to store the value once the batch is flushed
+ */
+void pci_config_space_batch_read_16(ddf_batch_t *batch, uint32_t address,
+    uint16_t *val)
+{
+	ddf_batch_call(batch, PCI_DEV_IFACE, IPC_M_CONFIG_SPACE_READ_16,
+	    address, 0, 0, val, sizeof(*val));
+}
+
+/** Add reading a double word of the configuration space to a batch.
+ *
+ * @param batch   Batch of calls to the PCI function
+ * @param address Address in the configuration space
+ * @param val     Where to store the value once the batch is flushed
+ */
+void pci_config_space_batch_read_32(ddf_batch_t *batch, uint32_t address,
+    uint32_t *val)
+{
+	ddf_batch_call(batch, PCI_DEV_IFACE, IPC_M_CONFIG_SPACE_READ_32,
+	    address, 0, 0, val, sizeof(*val));
+}
+
+/** Add writing a byte of the configuration space to a batch.
+ *
+ * @param batch   Batch of calls to the PCI function
+ * @param address Address in the configuration space
+ * @param val     Value to write
+ */
+void pci_config_space_batch_write_8(ddf_batch_t *batch, uint32_t address,
+    uint8_t val)
+{
+	ddf_batch_call(batch, PCI_DEV_IFACE, IPC_M_CONFIG_SPACE_WRITE_8,
+	    address, val, 0, NULL, 0);
+}
+
+/** Add writing a word of the configuration space to a batch.
+ *
+ * @param batch   Batch of calls to the PCI function
+ * @param address Address in the configuration space
+ * @param val     Value to write
+ */
+void pci_config_space_batch_write_16(ddf_batch_t *batch, uint32_t address,
+    uint16_t val)
+{
+	ddf_batch_call(batch, PCI_DEV_IFACE, IPC_M_CONFIG_SPACE_WRITE_16,
+	    address, val, 0, NULL, 0);
+}
+
+/** Add writing a double word of the configuration space to a batch.
+ *
+ * @param batch   Batch of calls to the PCI function
+ * @param address Address in the configuration space
+ * @param val     Value to write
+ */
+void pci_config_space_batch_write_32(ddf_batch_t *batch, uint32_t address,
+    uint32_t val)
+{
+	ddf_batch_call(batch, PCI_DEV_IFACE, IPC_M_CONFIG_SPACE_WRITE_32,
+	    address, val, 0, NULL, 0);
+}
+
 static void remote_config_space_read_8(ddf_fun_t *, void *, ipc_call_t *);
 static void remote_config_space_read_16(ddf_fun_t *, void *, ipc_call_t *);
 static void remote_config_space_read_32(ddf_fun_t *, void *, ipc_call_t *);
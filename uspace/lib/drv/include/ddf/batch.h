@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libdrv
+ * @{
+ */
+/** @file
+ * @brief Batched device interface calls.
+ */
+
+#ifndef DDF_BATCH_H_
+#define DDF_BATCH_H_
+
+#include <async.h>
+#include <errno.h>
+#include <ipc/dev_iface.h>
+#include <stddef.h>
+
+/** Maximum number of calls outstanding in a batch */
+#define DDF_BATCH_MAX  16
+
+/** Batch of device interface calls.
+ *
+ * The calls of a batch are all sent before any of their answers is waited
+ * for, so a driver pays the round trip to the driver below once per batch
+ * rather than once per call.
+ */
+typedef struct {
+	/** Exchange the calls are sent over */
+	async_exch_t *exch;
+	/** Number of outstanding calls */
+	size_t count;
+	/** Outstanding calls */
+	aid_t req[DDF_BATCH_MAX];
+	/** Answers of the outstanding calls */
+	ipc_call_t answer[DDF_BATCH_MAX];
+	/** Where to store the first return argument of each call */
+	void *res[DDF_BATCH_MAX];
+	/** Size of the result of each call */
+	size_t res_size[DDF_BATCH_MAX];
+	/** First error encountered */
+	errno_t rc;
+} ddf_batch_t;
+
+extern void ddf_batch_begin(ddf_batch_t *, async_sess_t *);
+extern void ddf_batch_call(ddf_batch_t *, dev_inferface_idx_t, sysarg_t,
+    sysarg_t, sysarg_t, sysarg_t, void *, size_t);
+extern errno_t ddf_batch_flush(ddf_batch_t *);
+extern errno_t ddf_batch_end(ddf_batch_t *);
+
+#endif
+
+/** @}
+ */
@@ -42,11 +42,21 @@
 typedef enum {
 	NIC_EV_ADDR_CHANGED = IPC_FIRST_USER_METHOD,
 	NIC_EV_RECEIVED,
-	NIC_EV_DEVICE_STATE
+	NIC_EV_DEVICE_STATE,
+	NIC_EV_RX_KICK
 } nic_event_t;
 
-extern errno_t nic_send_frame(async_sess_t *, void *, size_t);
+extern errno_t nic_send_frame(async_sess_t *, void *, size_t,
+    const nic_csum_t *);
 extern errno_t nic_callback_create(async_sess_t *, async_port_handler_t, void *);
+extern errno_t nic_rings_setup(async_sess_t *, nic_rings_t *);
+extern errno_t nic_tx_kick(async_sess_t *, bool);
+extern errno_t nic_queues_get(async_sess_t *, nic_queues_t *);
+extern errno_t nic_rss_get(async_sess_t *, nic_rss_t *);
+extern errno_t nic_rss_set(async_sess_t *, const nic_rss_t *);
+extern errno_t nic_flow_add(async_sess_t *, const nic_flow_t *,
+    nic_flow_id_t *);
+extern errno_t nic_flow_remove(async_sess_t *, nic_flow_id_t);
 extern errno_t nic_get_state(async_sess_t *, nic_device_state_t *);
 extern errno_t nic_set_state(async_sess_t *, nic_device_state_t);
 extern errno_t nic_get_address(async_sess_t *, nic_address_t *);
@@ -43,7 +43,7 @@
 
 typedef struct nic_iface {
 	/** Mandatory methods */
-	errno_t (*send_frame)(ddf_fun_t *, void *, size_t);
+	errno_t (*send_frame)(ddf_fun_t *, void *, size_t, const nic_csum_t *);
 	errno_t (*callback_create)(ddf_fun_t *);
 	errno_t (*get_state)(ddf_fun_t *, nic_device_state_t *);
 	errno_t (*set_state)(ddf_fun_t *, nic_device_state_t);
@@ -107,6 +107,15 @@ typedef struct nic_iface {
 	errno_t (*poll_set_mode)(ddf_fun_t *, nic_poll_mode_t,
 	    const struct timespec *);
 	errno_t (*poll_now)(ddf_fun_t *);
+
+	errno_t (*rings_setup)(ddf_fun_t *, nic_rings_t *);
+	errno_t (*tx_kick)(ddf_fun_t *);
+
+	errno_t (*queues_get)(ddf_fun_t *, nic_queues_t *);
+	errno_t (*rss_get)(ddf_fun_t *, nic_rss_t *);
+	errno_t (*rss_set)(ddf_fun_t *, const nic_rss_t *);
+	errno_t (*flow_add)(ddf_fun_t *, const nic_flow_t *, nic_flow_id_t *);
+	errno_t (*flow_remove)(ddf_fun_t *, nic_flow_id_t);
 } nic_iface_t;
 
 #endif
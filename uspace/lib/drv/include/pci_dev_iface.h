@@ -39,6 +39,7 @@
 
 #include <errno.h>
 
+#include "ddf/batch.h"
 #include "ddf/driver.h"
 
 #define PCI_VENDOR_ID	0x00
@@ -57,7 +58,9 @@
 #define PCI_CAP_NEXT(c)	((c) + 0x1)
 
 #define PCI_CAP_PMID		0x1
+#define PCI_CAP_MSI		0x5
 #define PCI_CAP_VENDORSPECID	0x9
+#define PCI_CAP_MSIX		0x11
 
 extern errno_t pci_config_space_read_8(async_sess_t *, uint32_t, uint8_t *);
 extern errno_t pci_config_space_read_16(async_sess_t *, uint32_t, uint16_t *);
@@ -67,6 +70,18 @@ extern errno_t pci_config_space_write_8(async_sess_t *, uint32_t, uint8_t);
 extern errno_t pci_config_space_write_16(async_sess_t *, uint32_t, uint16_t);
 extern errno_t pci_config_space_write_32(async_sess_t *, uint32_t, uint32_t);
 
+extern void pci_config_space_batch_read_8(ddf_batch_t *, uint32_t, uint8_t *);
+extern void pci_config_space_batch_read_16(ddf_batch_t *, uint32_t,
+    uint16_t *);
+extern void pci_config_space_batch_read_32(ddf_batch_t *, uint32_t,
+    uint32_t *);
+
+extern void pci_config_space_batch_write_8(ddf_batch_t *, uint32_t, uint8_t);
+extern void pci_config_space_batch_write_16(ddf_batch_t *, uint32_t,
+    uint16_t);
+extern void pci_config_space_batch_write_32(ddf_batch_t *, uint32_t,
+    uint32_t);
+
 static inline errno_t
 pci_config_space_cap_first(async_sess_t *sess, uint8_t *c, uint8_t *id)
 {
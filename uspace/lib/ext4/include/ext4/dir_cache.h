@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libext4
+ * @{
+ */
+
+#ifndef LIBEXT4_DIR_CACHE_H_
+#define LIBEXT4_DIR_CACHE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ext4/types.h"
+
+extern errno_t ext4_dir_cache_init(ext4_dir_cache_t *);
+extern void ext4_dir_cache_fini(ext4_dir_cache_t *);
+extern bool ext4_dir_cache_lookup(ext4_dir_cache_t *, uint32_t, const char *,
+    uint32_t *);
+extern void ext4_dir_cache_insert(ext4_dir_cache_t *, uint32_t, const char *,
+    uint32_t);
+extern void ext4_dir_cache_remove(ext4_dir_cache_t *, uint32_t, const char *);
+extern void ext4_dir_cache_invalidate(ext4_dir_cache_t *, uint32_t);
+
+#endif
+
+/**
+ * @}
+ */
@@ -65,8 +65,11 @@ extern void ext4_directory_dx_entry_set_block(ext4_directory_dx_entry_t *,
     uint32_t);
 
 extern errno_t ext4_directory_dx_init(ext4_inode_ref_t *);
+extern errno_t ext4_directory_dx_convert(ext4_inode_ref_t *);
 extern errno_t ext4_directory_dx_find_entry(ext4_directory_search_result_t *,
     ext4_inode_ref_t *, size_t, const char *);
+extern errno_t ext4_directory_dx_read_entry(ext4_directory_search_result_t *,
+    ext4_inode_ref_t *, aoff64_t, aoff64_t *);
 extern errno_t ext4_directory_dx_add_entry(ext4_inode_ref_t *, ext4_inode_ref_t *,
     const char *);
 
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libext4
+ * @{
+ */
+
+#ifndef LIBEXT4_JOURNAL_H_
+#define LIBEXT4_JOURNAL_H_
+
+#include <block.h>
+#include <stdint.h>
+#include "ext4/types.h"
+
+extern errno_t ext4_journal_open(ext4_filesystem_t *);
+extern errno_t ext4_journal_close(ext4_filesystem_t *);
+extern void ext4_journal_fini(ext4_filesystem_t *);
+extern void ext4_journal_start(ext4_filesystem_t *);
+extern void ext4_journal_stop(ext4_filesystem_t *);
+extern void ext4_journal_dirty(ext4_filesystem_t *, block_t *);
+extern void ext4_journal_dirty_inode(ext4_inode_ref_t *);
+extern void ext4_journal_revoke(ext4_filesystem_t *, uint64_t, uint32_t);
+extern errno_t ext4_journal_commit(ext4_filesystem_t *);
+
+#endif
+
+/**
+ * @}
+ */
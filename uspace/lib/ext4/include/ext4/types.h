@@ -35,7 +35,10 @@
 #ifndef LIBEXT4_TYPES_H_
 #define LIBEXT4_TYPES_H_
 
+#include <adt/hash_table.h>
+#include <adt/list.h>
 #include <block.h>
+#include <fibril_synch.h>
 
 /*
  * Structure of the super block
@@ -227,11 +230,174 @@ typedef struct ext4_superblock {
 	EXT4_FEATURE_RO_COMPAT_GDT_CSUM | \
 	EXT4_FEATURE_RO_COMPAT_EXTRA_ISIZE)
 
+/*
+ * Structures of the JBD2 journal (all fields are big-endian)
+ */
+#define EXT4_JOURNAL_MAGIC  0xC03B3998
+
+#define EXT4_JOURNAL_DESCRIPTOR_BLOCK  1
+#define EXT4_JOURNAL_COMMIT_BLOCK      2
+#define EXT4_JOURNAL_SUPERBLOCK_V1     3
+#define EXT4_JOURNAL_SUPERBLOCK_V2     4
+#define EXT4_JOURNAL_REVOKE_BLOCK      5
+
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_REVOKE        0x0001
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_64BIT         0x0002
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_ASYNC_COMMIT  0x0004
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_CSUM_V2       0x0008
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_CSUM_V3       0x0010
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_FAST_COMMIT   0x0020
+
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_SUPP \
+	(EXT4_JOURNAL_FEATURE_INCOMPAT_REVOKE | \
+	EXT4_JOURNAL_FEATURE_INCOMPAT_64BIT | \
+	EXT4_JOURNAL_FEATURE_INCOMPAT_ASYNC_COMMIT)
+
+#define EXT4_JOURNAL_FLAG_ESCAPE     0x0001  /* Magic number replaced by zero */
+#define EXT4_JOURNAL_FLAG_SAME_UUID  0x0002  /* UUID of the previous tag */
+#define EXT4_JOURNAL_FLAG_DELETED    0x0004  /* Not used */
+#define EXT4_JOURNAL_FLAG_LAST_TAG   0x0008  /* Last tag of the descriptor */
+
+/*
+ * Header of all blocks of the journal log
+ */
+typedef struct ext4_journal_header {
+	uint32_t magic;
+	uint32_t blocktype;
+	uint32_t sequence;              /* Transaction ID */
+} __attribute__((packed)) ext4_journal_header_t;
+
+/*
+ * Superblock of the journal
+ */
+typedef struct ext4_journal_superblock {
+	ext4_journal_header_t header;
+	uint32_t block_size;            /* Block size of the journal device */
+	uint32_t maxlen;                /* Total blocks in the journal */
+	uint32_t first;                 /* First block of the log */
+	uint32_t sequence;              /* First transaction expected in log */
+	uint32_t start;                 /* First block of the log, 0 if empty */
+	uint32_t error;                 /* Error value set by abort */
+	uint32_t features_compatible;
+	uint32_t features_incompatible;
+	uint32_t features_read_only;
+	uint8_t uuid[16];               /* UUID of the journal */
+	uint32_t nr_users;              /* Number of file systems sharing it */
+	uint32_t dynsuper;              /* Not used */
+	uint32_t max_transaction;       /* Not used */
+	uint32_t max_trans_data;        /* Not used */
+	uint8_t checksum_type;
+	uint8_t padding2[3];
+	uint32_t padding[42];
+	uint32_t checksum;
+	uint8_t users[16 * 48];         /* UUIDs of the file systems */
+} __attribute__((packed)) ext4_journal_superblock_t;
+
+/*
+ * Tag of a block logged in a descriptor block
+ */
+typedef struct ext4_journal_block_tag {
+	uint32_t blocknr;               /* Block number on the file system */
+	uint16_t checksum;              /* Not used without checksums */
+	uint16_t flags;
+	uint32_t blocknr_high;          /* Present only with 64BIT feature */
+} __attribute__((packed)) ext4_journal_block_tag_t;
+
+/*
+ * Header of a revocation block, followed by the revoked block numbers
+ */
+typedef struct ext4_journal_revoke_header {
+	ext4_journal_header_t header;
+	uint32_t count;                 /* Bytes used in the block */
+} __attribute__((packed)) ext4_journal_revoke_header_t;
+
+/*
+ * In-memory cache of extents resolved from the extent trees
+ */
+typedef struct ext4_extent_cache {
+	fibril_mutex_t lock;
+	hash_table_t inodes;            /* Cached i-nodes by index */
+	list_t lru;                     /* Cached i-nodes, least recent first */
+	size_t inodes_count;
+} ext4_extent_cache_t;
+
+/*
+ * In-memory cache of recently used names of directories
+ */
+typedef struct ext4_dir_cache {
+	fibril_mutex_t lock;
+	hash_table_t dirs;              /* Cached directories by index */
+	list_t lru;                     /* Cached directories, least recent first */
+	size_t dirs_count;
+} ext4_dir_cache_t;
+
+/*
+ * Preallocation windows of i-nodes
+ */
+typedef struct ext4_prealloc {
+	fibril_mutex_t lock;
+	list_t windows;                 /* Windows, least recent first */
+	size_t windows_count;
+} ext4_prealloc_t;
+
+/*
+ * Contiguous run of the blocks of the journal
+ */
+typedef struct ext4_journal_run {
+	uint32_t iblock;                /* First block of the journal */
+	uint32_t count;                 /* Number of blocks */
+	uint64_t fblock;                /* First block on the file system */
+} ext4_journal_run_t;
+
+/*
+ * Journal of the file system
+ */
+typedef struct ext4_journal {
+	struct ext4_filesystem *fs;
+	fibril_mutex_t lock;
+	fibril_condvar_t cv;            /* Signalled at the end of operations */
+	fibril_condvar_t commit_cv;     /* Wakes up the committer */
+	ext4_journal_run_t *runs;       /* Physical location of the journal */
+	size_t runs_count;
+	size_t dev_blocks;              /* Device blocks per journal block */
+	uint32_t block_size;
+	uint32_t first;                 /* First block of the log */
+	uint32_t maxlen;                /* End of the log */
+	uint32_t features_incompatible;
+	uint8_t uuid[16];
+	uint32_t sequence;              /* ID of the running transaction */
+	uint32_t head;                  /* Next block of the log to write */
+	uint32_t tail;                  /* Oldest block still needed, 0 if none */
+	uint32_t tail_sequence;         /* Transaction starting at the tail */
+	size_t max_blocks;              /* Commit limit of a transaction */
+	hash_table_t buffers;           /* Blocks of the running transaction */
+	size_t buffers_count;
+	hash_table_t revoked;           /* Revoked by the running transaction */
+	size_t revoked_count;
+	hash_table_t logged;            /* Logged since the last checkpoint */
+	size_t logged_count;
+	unsigned handles;               /* Operations in progress */
+	bool committing;
+	bool aborted;
+	fid_t committer;
+	bool committer_stop;
+	bool committer_done;
+} ext4_journal_t;
+
 typedef struct ext4_filesystem {
 	service_id_t device;
 	ext4_superblock_t *superblock;
 	aoff64_t inode_block_limits[4];
 	aoff64_t inode_blocks_per_level[4];
+	ext4_extent_cache_t extent_cache;
+	ext4_dir_cache_t dir_cache;
+	ext4_prealloc_t prealloc;
+	/*
+	 * Serializes updates of the block and i-node bitmaps and of the free
+	 * counts in the block group descriptors and the superblock.
+	 */
+	fibril_mutex_t alloc_lock;
+	ext4_journal_t *journal;        /* NULL if not journaling */
 } ext4_filesystem_t;
 
 /** Size of buffer for volume name. To hold 16 latin-1 chars encoded as UTF-8
@@ -432,6 +598,7 @@ typedef struct ext4_directory_iterator {
 typedef struct ext4_directory_search_result {
 	block_t *block;
 	ext4_directory_entry_ll_t *dentry;
+	uint32_t iblock;                /* Logical block with the entry */
 } ext4_directory_search_result_t;
 
 /* Structures for indexed directory */
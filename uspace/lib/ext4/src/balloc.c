@@ -35,18 +35,24 @@
  * @brief Physical block allocator.
  */
 
+#include <adt/list.h>
+#include <assert.h>
 #include <errno.h>
+#include <fibril_synch.h>
+#include <macros.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include "ext4/balloc.h"
 #include "ext4/bitmap.h"
 #include "ext4/block_group.h"
 #include "ext4/filesystem.h"
 #include "ext4/inode.h"
+#include "ext4/journal.h"
 #include "ext4/superblock.h"
 #include "ext4/types.h"
 
-/** Free block.
+/** Free block with the allocation lock held.
  *
  * @param inode_ref  Inode, where the block is allocated
  * @param block_addr Absolute block address to free
@@ -54,7 +60,8 @@
  * @return Error code
  *
  */
-errno_t ext4_balloc_free_block(ext4_inode_ref_t *inode_ref, uint32_t block_addr)
+static errno_t ext4_balloc_free_block_locked(ext4_inode_ref_t *inode_ref,
+    uint32_t block_addr)
 {
 	ext4_filesystem_t *fs = inode_ref->fs;
 	ext4_superblock_t *sb = fs->superblock;
@@ -82,7 +89,10 @@ errno_t ext4_balloc_free_block(ext4_inode_ref_t *inode_ref, uint32_t block_addr)
 
 	/* Modify bitmap */
 	ext4_bitmap_free_bit(bitmap_block->data, index_in_group);
-	bitmap_block->dirty = true;
+	ext4_journal_dirty(fs, bitmap_block);
+
+	/* Do not replay the block if it was logged as metadata */
+	ext4_journal_revoke(fs, block_addr, 1);
 
 	/* Release block with bitmap */
 	rc = block_put(bitmap_block);
@@ -119,10 +129,39 @@ errno_t ext4_balloc_free_block(ext4_inode_ref_t *inode_ref, uint32_t block_addr)
 	return ext4_filesystem_put_block_group_ref(bg_ref);
 }
 
-static errno_t ext4_balloc_free_blocks_internal(ext4_inode_ref_t *inode_ref,
-    uint32_t first, uint32_t count)
+/** Free block.
+ *
+ * @param inode_ref  Inode, where the block is allocated
+ * @param block_addr Absolute block address to free
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_free_block(ext4_inode_ref_t *inode_ref, uint32_t block_addr)
 {
 	ext4_filesystem_t *fs = inode_ref->fs;
+
+	fibril_mutex_lock(&fs->alloc_lock);
+	errno_t rc = ext4_balloc_free_block_locked(inode_ref, block_addr);
+	fibril_mutex_unlock(&fs->alloc_lock);
+
+	return rc;
+}
+
+/** Free continuous set of blocks inside one block group.
+ *
+ * Must be called with the allocation lock held.
+ *
+ * @param fs        Filesystem
+ * @param inode_ref Inode, where the blocks are allocated, or NULL for
+ *                  blocks not accounted to any inode
+ * @param first     First block to release
+ * @param count     Number of blocks to release
+ *
+ */
+static errno_t ext4_balloc_free_blocks_locked(ext4_filesystem_t *fs,
+    ext4_inode_ref_t *inode_ref, uint32_t first, uint32_t count)
+{
 	ext4_superblock_t *sb = fs->superblock;
 
 	/* Compute indexes */
@@ -155,7 +194,10 @@ static errno_t ext4_balloc_free_blocks_internal(ext4_inode_ref_t *inode_ref,
 
 	/* Modify bitmap */
 	ext4_bitmap_free_bits(bitmap_block->data, index_in_group_first, count);
-	bitmap_block->dirty = true;
+	ext4_journal_dirty(fs, bitmap_block);
+
+	/* Do not replay the blocks if they were logged as metadata */
+	ext4_journal_revoke(fs, first, count);
 
 	/* Release block with bitmap */
 	rc = block_put(bitmap_block);
@@ -174,11 +216,13 @@ static errno_t ext4_balloc_free_blocks_internal(ext4_inode_ref_t *inode_ref,
 	ext4_superblock_set_free_blocks_count(sb, sb_free_blocks);
 
 	/* Update inode blocks count */
-	uint64_t ino_blocks =
-	    ext4_inode_get_blocks_count(sb, inode_ref->inode);
-	ino_blocks -= count * (block_size / EXT4_INODE_BLOCK_SIZE);
-	ext4_inode_set_blocks_count(sb, inode_ref->inode, ino_blocks);
-	inode_ref->dirty = true;
+	if (inode_ref != NULL) {
+		uint64_t ino_blocks =
+		    ext4_inode_get_blocks_count(sb, inode_ref->inode);
+		ino_blocks -= count * (block_size / EXT4_INODE_BLOCK_SIZE);
+		ext4_inode_set_blocks_count(sb, inode_ref->inode, ino_blocks);
+		inode_ref->dirty = true;
+	}
 
 	/* Update block group free blocks count */
 	uint32_t free_blocks =
@@ -192,6 +236,26 @@ static errno_t ext4_balloc_free_blocks_internal(ext4_inode_ref_t *inode_ref,
 	return ext4_filesystem_put_block_group_ref(bg_ref);
 }
 
+/** Free continuous set of blocks inside one block group.
+ *
+ * @param fs        Filesystem
+ * @param inode_ref Inode, where the blocks are allocated, or NULL for
+ *                  blocks not accounted to any inode
+ * @param first     First block to release
+ * @param count     Number of blocks to release
+ *
+ */
+static errno_t ext4_balloc_free_blocks_internal(ext4_filesystem_t *fs,
+    ext4_inode_ref_t *inode_ref, uint32_t first, uint32_t count)
+{
+	fibril_mutex_lock(&fs->alloc_lock);
+	errno_t rc = ext4_balloc_free_blocks_locked(fs, inode_ref, first,
+	    count);
+	fibril_mutex_unlock(&fs->alloc_lock);
+
+	return rc;
+}
+
 /** Free continuous set of blocks.
  *
  * @param inode_ref Inode, where the blocks are allocated
@@ -220,7 +284,7 @@ errno_t ext4_balloc_free_blocks(ext4_inode_ref_t *inode_ref,
 			 */
 			uint32_t s = limit - first;
 
-			r = ext4_balloc_free_blocks_internal(inode_ref,
+			r = ext4_balloc_free_blocks_internal(fs, inode_ref,
 			    first, s);
 			if (r != EOK)
 				return r;
@@ -228,7 +292,7 @@ errno_t ext4_balloc_free_blocks(ext4_inode_ref_t *inode_ref,
 			first = limit;
 			count -= s;
 		} else {
-			return ext4_balloc_free_blocks_internal(inode_ref,
+			return ext4_balloc_free_blocks_internal(fs, inode_ref,
 			    first, count);
 		}
 	}
@@ -312,7 +376,7 @@ static errno_t ext4_balloc_find_goal(ext4_inode_ref_t *inode_ref, uint32_t *goal
 		if (rc != EOK)
 			return rc;
 
-		if (goal != 0) {
+		if (*goal != 0) {
 			(*goal)++;
 			return EOK;
 		}
@@ -335,15 +399,370 @@ static errno_t ext4_balloc_find_goal(ext4_inode_ref_t *inode_ref, uint32_t *goal
 	return ext4_filesystem_put_block_group_ref(bg_ref);
 }
 
-/** Data block allocation algorithm.
+/** Smallest preallocation window in blocks */
+#define EXT4_PREALLOC_MIN_BLOCKS  8
+
+/** Largest preallocation window in blocks */
+#define EXT4_PREALLOC_MAX_BLOCKS  256
+
+/** Maximum number of i-nodes with a preallocation window */
+#define EXT4_PREALLOC_WINDOWS  32
+
+/*
+ * Preallocation window of an i-node.
+ *
+ * The blocks of the window are marked as used in the bitmap, but they are
+ * accounted to the i-node only when handed out. The window is grown while
+ * the i-node keeps allocating sequentially from it.
+ */
+typedef struct {
+	link_t link;            /* Link in ext4_prealloc_t.windows */
+	uint32_t index;         /* Index of the i-node */
+	uint32_t start;         /* Next reserved block */
+	uint32_t count;         /* Number of reserved blocks left */
+	uint32_t size;          /* Size of the next reservation */
+} ext4_prealloc_window_t;
+
+/** Initialize preallocation windows of filesystem.
+ *
+ * @param fs Filesystem
+ *
+ */
+void ext4_balloc_prealloc_init(ext4_filesystem_t *fs)
+{
+	fibril_mutex_initialize(&fs->prealloc.lock);
+	list_initialize(&fs->prealloc.windows);
+	fs->prealloc.windows_count = 0;
+}
+
+/** Return the blocks left in a preallocation window to the bitmap.
+ *
+ * @param fs     Filesystem
+ * @param window Preallocation window
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_balloc_prealloc_release(ext4_filesystem_t *fs,
+    ext4_prealloc_window_t *window)
+{
+	errno_t rc = EOK;
+
+	if (window->count > 0) {
+		rc = ext4_balloc_free_blocks_internal(fs, NULL, window->start,
+		    window->count);
+	}
+
+	window->count = 0;
+	return rc;
+}
+
+/** Reserve a run of free blocks in the block group of the goal.
+ *
+ * A single bitmap and block group descriptor update covers the whole run.
+ * Must be called with the allocation lock held.
+ *
+ * @param fs     Filesystem
+ * @param goal   Preferred first block
+ * @param exact  The run must start at the goal
+ * @param want   Number of blocks wanted
+ * @param start  Output value - first block of the run
+ * @param count  Output value - number of blocks of the run
+ *
+ * @return Error code, ENOSPC if no run was found
+ *
+ */
+static errno_t ext4_balloc_alloc_run_locked(ext4_filesystem_t *fs,
+    uint32_t goal, bool exact, uint32_t want, uint32_t *start, uint32_t *count)
+{
+	ext4_superblock_t *sb = fs->superblock;
+	uint32_t block_group = ext4_filesystem_blockaddr2group(sb, goal);
+	uint32_t index_in_group =
+	    ext4_filesystem_blockaddr2_index_in_group(sb, goal);
+
+	ext4_block_group_ref_t *bg_ref;
+	errno_t rc = ext4_filesystem_get_block_group_ref(fs, block_group,
+	    &bg_ref);
+	if (rc != EOK)
+		return rc;
+
+	uint32_t free_blocks =
+	    ext4_block_group_get_free_blocks_count(bg_ref->block_group, sb);
+	uint32_t first_in_group_index = ext4_filesystem_blockaddr2_index_in_group(
+	    sb, ext4_balloc_get_first_data_block_in_group(sb, bg_ref));
+	uint32_t blocks_in_group =
+	    ext4_superblock_get_blocks_in_group(sb, block_group);
+
+	if (index_in_group < first_in_group_index) {
+		if (exact)
+			free_blocks = 0;
+		index_in_group = first_in_group_index;
+	}
+
+	if (free_blocks == 0) {
+		rc = ext4_filesystem_put_block_group_ref(bg_ref);
+		return rc != EOK ? rc : ENOSPC;
+	}
+
+	uint32_t bitmap_block_addr =
+	    ext4_block_group_get_block_bitmap(bg_ref->block_group, sb);
+	block_t *bitmap_block;
+	rc = block_get(&bitmap_block, fs->device, bitmap_block_addr, 0);
+	if (rc != EOK) {
+		ext4_filesystem_put_block_group_ref(bg_ref);
+		return rc;
+	}
+
+	/* Find the first free block */
+	uint32_t first = index_in_group;
+	while (!exact && first < blocks_in_group &&
+	    !ext4_bitmap_is_free_bit(bitmap_block->data, first))
+		first++;
+
+	/* Extend the run as far as possible */
+	uint32_t len = 0;
+	want = min(want, free_blocks);
+	while (len < want && first + len < blocks_in_group &&
+	    ext4_bitmap_is_free_bit(bitmap_block->data, first + len)) {
+		ext4_bitmap_set_bit(bitmap_block->data, first + len);
+		len++;
+	}
+
+	if (len > 0)
+		ext4_journal_dirty(fs, bitmap_block);
+
+	rc = block_put(bitmap_block);
+	if (rc != EOK) {
+		ext4_filesystem_put_block_group_ref(bg_ref);
+		return rc;
+	}
+
+	if (len == 0) {
+		rc = ext4_filesystem_put_block_group_ref(bg_ref);
+		return rc != EOK ? rc : ENOSPC;
+	}
+
+	/* Update superblock free blocks count */
+	uint32_t sb_free_blocks = ext4_superblock_get_free_blocks_count(sb);
+	sb_free_blocks -= len;
+	ext4_superblock_set_free_blocks_count(sb, sb_free_blocks);
+
+	/* Update block group free blocks count */
+	ext4_block_group_set_free_blocks_count(bg_ref->block_group, sb,
+	    free_blocks - len);
+	bg_ref->dirty = true;
+
+	*start = ext4_filesystem_index_in_group2blockaddr(sb, first,
+	    block_group);
+	*count = len;
+
+	return ext4_filesystem_put_block_group_ref(bg_ref);
+}
+
+/** Reserve a run of free blocks in the block group of the goal.
+ *
+ * @param fs     Filesystem
+ * @param goal   Preferred first block
+ * @param exact  The run must start at the goal
+ * @param want   Number of blocks wanted
+ * @param start  Output value - first block of the run
+ * @param count  Output value - number of blocks of the run
+ *
+ * @return Error code, ENOSPC if no run was found
+ *
+ */
+static errno_t ext4_balloc_alloc_run(ext4_filesystem_t *fs, uint32_t goal,
+    bool exact, uint32_t want, uint32_t *start, uint32_t *count)
+{
+	fibril_mutex_lock(&fs->alloc_lock);
+	errno_t rc = ext4_balloc_alloc_run_locked(fs, goal, exact, want, start,
+	    count);
+	fibril_mutex_unlock(&fs->alloc_lock);
+
+	return rc;
+}
+
+/** Allocate data block from the preallocation window of the i-node.
+ *
+ * If the window does not continue at the goal, its blocks are returned and
+ * a new window is reserved at the goal. The window size doubles whenever
+ * a window is used up sequentially, up to EXT4_PREALLOC_MAX_BLOCKS.
+ *
+ * @param inode_ref I-node to allocate block for
+ * @param goal      Preferred block
+ * @param exact     Only the goal block itself is acceptable
+ * @param fblock    Output value - allocated block
+ *
+ * @return Error code, ENOENT if the window cannot be used
+ *
+ */
+static errno_t ext4_balloc_prealloc_alloc(ext4_inode_ref_t *inode_ref,
+    uint32_t goal, bool exact, uint32_t *fblock)
+{
+	ext4_filesystem_t *fs = inode_ref->fs;
+	ext4_superblock_t *sb = fs->superblock;
+	ext4_prealloc_window_t *window = NULL;
+	errno_t rc = EOK;
+
+	/* Only regular files are worth preallocating for */
+	if (!ext4_inode_is_type(sb, inode_ref->inode, EXT4_INODE_MODE_FILE))
+		return ENOENT;
+
+	fibril_mutex_lock(&fs->prealloc.lock);
+
+	list_foreach(fs->prealloc.windows, link, ext4_prealloc_window_t, w) {
+		if (w->index == inode_ref->index) {
+			window = w;
+			break;
+		}
+	}
+
+	if (window != NULL) {
+		list_remove(&window->link);
+		list_append(&window->link, &fs->prealloc.windows);
+
+		if (window->count > 0 && window->start == goal)
+			goto take;
+
+		if (window->count == 0 && window->start == goal) {
+			/* Sequential use, grow the window */
+			window->size = min(2 * window->size,
+			    (uint32_t) EXT4_PREALLOC_MAX_BLOCKS);
+		} else {
+			/* Random use, start over */
+			rc = ext4_balloc_prealloc_release(fs, window);
+			if (rc != EOK)
+				goto out;
+			window->size = EXT4_PREALLOC_MIN_BLOCKS;
+		}
+	} else {
+		if (fs->prealloc.windows_count >= EXT4_PREALLOC_WINDOWS) {
+			window = list_get_instance(
+			    list_first(&fs->prealloc.windows),
+			    ext4_prealloc_window_t, link);
+			rc = ext4_balloc_prealloc_release(fs, window);
+			if (rc != EOK)
+				goto out;
+			list_remove(&window->link);
+		} else {
+			window = malloc(sizeof(ext4_prealloc_window_t));
+			if (window == NULL) {
+				rc = ENOENT;
+				goto out;
+			}
+			fs->prealloc.windows_count++;
+		}
+
+		window->index = inode_ref->index;
+		window->count = 0;
+		window->size = EXT4_PREALLOC_MIN_BLOCKS;
+		list_append(&window->link, &fs->prealloc.windows);
+	}
+
+	rc = ext4_balloc_alloc_run(fs, goal, exact, window->size,
+	    &window->start, &window->count);
+	if (rc != EOK) {
+		window->count = 0;
+		if (rc == ENOSPC)
+			rc = ENOENT;
+		goto out;
+	}
+
+	if (exact && window->start != goal) {
+		rc = ENOENT;
+		goto out;
+	}
+
+take:
+	*fblock = window->start;
+	window->start++;
+	window->count--;
+
+	/* Update inode blocks (different block size!) count */
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
+	uint64_t ino_blocks =
+	    ext4_inode_get_blocks_count(sb, inode_ref->inode);
+	ino_blocks += block_size / EXT4_INODE_BLOCK_SIZE;
+	ext4_inode_set_blocks_count(sb, inode_ref->inode, ino_blocks);
+	inode_ref->dirty = true;
+
+out:
+	fibril_mutex_unlock(&fs->prealloc.lock);
+	return rc;
+}
+
+/** Return the preallocation window of an i-node.
+ *
+ * Called when the i-node is closed, truncated or freed.
+ *
+ * @param fs    Filesystem
+ * @param index Index of the i-node
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_prealloc_discard(ext4_filesystem_t *fs, uint32_t index)
+{
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&fs->prealloc.lock);
+
+	list_foreach(fs->prealloc.windows, link, ext4_prealloc_window_t, w) {
+		if (w->index == index) {
+			rc = ext4_balloc_prealloc_release(fs, w);
+			list_remove(&w->link);
+			fs->prealloc.windows_count--;
+			free(w);
+			break;
+		}
+	}
+
+	fibril_mutex_unlock(&fs->prealloc.lock);
+	return rc;
+}
+
+/** Return all preallocation windows of the filesystem.
+ *
+ * @param fs Filesystem
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_prealloc_discard_all(ext4_filesystem_t *fs)
+{
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&fs->prealloc.lock);
+
+	while (!list_empty(&fs->prealloc.windows)) {
+		ext4_prealloc_window_t *window = list_get_instance(
+		    list_first(&fs->prealloc.windows), ext4_prealloc_window_t,
+		    link);
+
+		errno_t rc2 = ext4_balloc_prealloc_release(fs, window);
+		if (rc == EOK)
+			rc = rc2;
+
+		list_remove(&window->link);
+		fs->prealloc.windows_count--;
+		free(window);
+	}
+
+	fibril_mutex_unlock(&fs->prealloc.lock);
+	return rc;
+}
+
+/** Allocate a data block near the goal with the allocation lock held.
  *
  * @param inode_ref Inode to allocate block for
+ * @param goal      Preferred block
  * @param fblock    Allocated block address
  *
  * @return Error code
  *
  */
-errno_t ext4_balloc_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t *fblock)
+static errno_t ext4_balloc_alloc_block_locked(ext4_inode_ref_t *inode_ref,
+    uint32_t goal, uint32_t *fblock)
 {
 	uint32_t allocated_block = 0;
 
@@ -351,13 +770,8 @@ errno_t ext4_balloc_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t *fblock)
 	block_t *bitmap_block;
 	uint32_t rel_block_idx = 0;
 	uint32_t free_blocks;
-	uint32_t goal;
 	uint32_t block_size;
-
-	/* Find GOAL */
-	errno_t rc = ext4_balloc_find_goal(inode_ref, &goal);
-	if (rc != EOK)
-		return rc;
+	errno_t rc;
 
 	ext4_superblock_t *sb = inode_ref->fs->superblock;
 
@@ -404,7 +818,7 @@ errno_t ext4_balloc_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t *fblock)
 	/* Check if goal is free */
 	if (ext4_bitmap_is_free_bit(bitmap_block->data, index_in_group)) {
 		ext4_bitmap_set_bit(bitmap_block->data, index_in_group);
-		bitmap_block->dirty = true;
+		ext4_journal_dirty(inode_ref->fs, bitmap_block);
 		rc = block_put(bitmap_block);
 		if (rc != EOK) {
 			ext4_filesystem_put_block_group_ref(bg_ref);
@@ -430,7 +844,7 @@ errno_t ext4_balloc_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t *fblock)
 	    ++tmp_idx) {
 		if (ext4_bitmap_is_free_bit(bitmap_block->data, tmp_idx)) {
 			ext4_bitmap_set_bit(bitmap_block->data, tmp_idx);
-			bitmap_block->dirty = true;
+			ext4_journal_dirty(inode_ref->fs, bitmap_block);
 			rc = block_put(bitmap_block);
 			if (rc != EOK)
 				return rc;
@@ -447,7 +861,7 @@ errno_t ext4_balloc_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t *fblock)
 	rc = ext4_bitmap_find_free_byte_and_set_bit(bitmap_block->data,
 	    index_in_group, &rel_block_idx, blocks_in_group);
 	if (rc == EOK) {
-		bitmap_block->dirty = true;
+		ext4_journal_dirty(inode_ref->fs, bitmap_block);
 		rc = block_put(bitmap_block);
 		if (rc != EOK)
 			return rc;
@@ -463,7 +877,7 @@ errno_t ext4_balloc_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t *fblock)
 	rc = ext4_bitmap_find_free_bit_and_set(bitmap_block->data,
 	    index_in_group, &rel_block_idx, blocks_in_group);
 	if (rc == EOK) {
-		bitmap_block->dirty = true;
+		ext4_journal_dirty(inode_ref->fs, bitmap_block);
 		rc = block_put(bitmap_block);
 		if (rc != EOK)
 			return rc;
@@ -535,7 +949,7 @@ goal_failed:
 		rc = ext4_bitmap_find_free_byte_and_set_bit(bitmap_block->data,
 		    index_in_group, &rel_block_idx, blocks_in_group);
 		if (rc == EOK) {
-			bitmap_block->dirty = true;
+			ext4_journal_dirty(inode_ref->fs, bitmap_block);
 			rc = block_put(bitmap_block);
 			if (rc != EOK) {
 				ext4_filesystem_put_block_group_ref(bg_ref);
@@ -553,7 +967,7 @@ goal_failed:
 		rc = ext4_bitmap_find_free_bit_and_set(bitmap_block->data,
 		    index_in_group, &rel_block_idx, blocks_in_group);
 		if (rc == EOK) {
-			bitmap_block->dirty = true;
+			ext4_journal_dirty(inode_ref->fs, bitmap_block);
 			rc = block_put(bitmap_block);
 			if (rc != EOK) {
 				ext4_filesystem_put_block_group_ref(bg_ref);
@@ -614,7 +1028,37 @@ success:
 	return rc;
 }
 
-/** Try to allocate concrete block.
+/** Data block allocation algorithm.
+ *
+ * @param inode_ref Inode to allocate block for
+ * @param fblock    Allocated block address
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t *fblock)
+{
+	ext4_filesystem_t *fs = inode_ref->fs;
+	uint32_t goal;
+
+	/* Find GOAL */
+	errno_t rc = ext4_balloc_find_goal(inode_ref, &goal);
+	if (rc != EOK)
+		return rc;
+
+	/* Prefer the preallocation window of the inode */
+	rc = ext4_balloc_prealloc_alloc(inode_ref, goal, false, fblock);
+	if (rc != ENOENT)
+		return rc;
+
+	fibril_mutex_lock(&fs->alloc_lock);
+	rc = ext4_balloc_alloc_block_locked(inode_ref, goal, fblock);
+	fibril_mutex_unlock(&fs->alloc_lock);
+
+	return rc;
+}
+
+/** Try to allocate concrete block with the allocation lock held.
  *
  * @param inode_ref Inode to allocate block for
  * @param fblock    Block address to allocate
@@ -623,8 +1067,8 @@ success:
  * @return Error code
  *
  */
-errno_t ext4_balloc_try_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t fblock,
-    bool *free)
+static errno_t ext4_balloc_try_alloc_block_locked(ext4_inode_ref_t *inode_ref,
+    uint32_t fblock, bool *free)
 {
 	errno_t rc;
 
@@ -658,7 +1102,7 @@ errno_t ext4_balloc_try_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t fblock
 	/* Allocate block if possible */
 	if (*free) {
 		ext4_bitmap_set_bit(bitmap_block->data, index_in_group);
-		bitmap_block->dirty = true;
+		ext4_journal_dirty(fs, bitmap_block);
 	}
 
 	/* Release block with bitmap */
@@ -699,6 +1143,39 @@ terminate:
 	return ext4_filesystem_put_block_group_ref(bg_ref);
 }
 
+/** Try to allocate concrete block.
+ *
+ * @param inode_ref Inode to allocate block for
+ * @param fblock    Block address to allocate
+ * @param free      Output value - if target block is free
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_try_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t fblock,
+    bool *free)
+{
+	ext4_filesystem_t *fs = inode_ref->fs;
+	errno_t rc;
+
+	/* The block may be the next one of the preallocation window */
+	uint32_t pblock;
+	rc = ext4_balloc_prealloc_alloc(inode_ref, fblock, true, &pblock);
+	if (rc == EOK) {
+		assert(pblock == fblock);
+		*free = true;
+		return EOK;
+	}
+	if (rc != ENOENT)
+		return rc;
+
+	fibril_mutex_lock(&fs->alloc_lock);
+	rc = ext4_balloc_try_alloc_block_locked(inode_ref, fblock, free);
+	fibril_mutex_unlock(&fs->alloc_lock);
+
+	return rc;
+}
+
 /**
  * @}
  */
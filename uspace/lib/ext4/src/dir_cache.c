@@ -0,0 +1,415 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libext4
+ * @{
+ */
+/**
+ * @file  dir_cache.c
+ * @brief In-memory cache of recently used directory entry names.
+ *
+ * Each cached directory keeps a hash table of the names recently looked up
+ * in it together with the logical block where the entry was found. The
+ * cached block is only a hint: the entry is searched for in the block and
+ * the regular lookup is done if it is not there anymore, so the cache does
+ * not need to follow entries moved by splits of the directory index.
+ */
+
+#include <adt/hash.h>
+#include <errno.h>
+#include <mem.h>
+#include <stdlib.h>
+#include <str.h>
+#include "ext4/dir_cache.h"
+
+/** Maximum number of directories with cached names */
+#define EXT4_DIR_CACHE_DIRS  64
+
+/** Maximum number of cached names of one directory */
+#define EXT4_DIR_CACHE_NAMES  512
+
+/** Cached names of one directory */
+typedef struct {
+	ht_link_t link;         /* Link in ext4_dir_cache_t.dirs */
+	link_t lru;             /* Link in ext4_dir_cache_t.lru */
+	uint32_t index;         /* Index of the directory i-node */
+	hash_table_t names;     /* Cached names */
+	list_t names_lru;       /* Cached names, least recent first */
+	size_t names_count;
+} ext4_dir_cache_dir_t;
+
+/** Cached name */
+typedef struct {
+	ht_link_t link;         /* Link in ext4_dir_cache_dir_t.names */
+	link_t lru;             /* Link in ext4_dir_cache_dir_t.names_lru */
+	uint32_t iblock;        /* Logical block with the entry */
+	size_t name_len;
+	char name[];
+} ext4_dir_cache_name_t;
+
+/** Key of a cached name */
+typedef struct {
+	const char *name;
+	size_t name_len;
+} ext4_dir_cache_key_t;
+
+static size_t ext4_dir_cache_dir_key_hash(const void *key)
+{
+	const uint32_t *index = key;
+	return hash_mix(*index);
+}
+
+static size_t ext4_dir_cache_dir_hash(const ht_link_t *item)
+{
+	ext4_dir_cache_dir_t *cd =
+	    hash_table_get_inst(item, ext4_dir_cache_dir_t, link);
+	return hash_mix(cd->index);
+}
+
+static bool ext4_dir_cache_dir_key_equal(const void *key,
+    const ht_link_t *item)
+{
+	const uint32_t *index = key;
+	ext4_dir_cache_dir_t *cd =
+	    hash_table_get_inst(item, ext4_dir_cache_dir_t, link);
+	return cd->index == *index;
+}
+
+static const hash_table_ops_t ext4_dir_cache_dir_ops = {
+	.hash = ext4_dir_cache_dir_hash,
+	.key_hash = ext4_dir_cache_dir_key_hash,
+	.key_equal = ext4_dir_cache_dir_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static size_t ext4_dir_cache_name_hash_str(const char *name, size_t name_len)
+{
+	size_t hash = 0;
+
+	for (size_t i = 0; i < name_len; i++)
+		hash = hash * 31 + (uint8_t) name[i];
+
+	return hash_mix(hash);
+}
+
+static size_t ext4_dir_cache_name_key_hash(const void *key)
+{
+	const ext4_dir_cache_key_t *k = key;
+	return ext4_dir_cache_name_hash_str(k->name, k->name_len);
+}
+
+static size_t ext4_dir_cache_name_hash(const ht_link_t *item)
+{
+	ext4_dir_cache_name_t *cn =
+	    hash_table_get_inst(item, ext4_dir_cache_name_t, link);
+	return ext4_dir_cache_name_hash_str(cn->name, cn->name_len);
+}
+
+static bool ext4_dir_cache_name_key_equal(const void *key,
+    const ht_link_t *item)
+{
+	const ext4_dir_cache_key_t *k = key;
+	ext4_dir_cache_name_t *cn =
+	    hash_table_get_inst(item, ext4_dir_cache_name_t, link);
+	return (cn->name_len == k->name_len) &&
+	    (memcmp(cn->name, k->name, k->name_len) == 0);
+}
+
+static const hash_table_ops_t ext4_dir_cache_name_ops = {
+	.hash = ext4_dir_cache_name_hash,
+	.key_hash = ext4_dir_cache_name_key_hash,
+	.key_equal = ext4_dir_cache_name_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Initialize directory name cache.
+ *
+ * @param cache Directory name cache
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_dir_cache_init(ext4_dir_cache_t *cache)
+{
+	if (!hash_table_create(&cache->dirs, 0, 0, &ext4_dir_cache_dir_ops))
+		return ENOMEM;
+
+	fibril_mutex_initialize(&cache->lock);
+	list_initialize(&cache->lru);
+	cache->dirs_count = 0;
+	return EOK;
+}
+
+/** Remove a cached name.
+ *
+ * @param cd Cached directory
+ * @param cn Name to remove
+ *
+ */
+static void ext4_dir_cache_name_remove(ext4_dir_cache_dir_t *cd,
+    ext4_dir_cache_name_t *cn)
+{
+	hash_table_remove_item(&cd->names, &cn->link);
+	list_remove(&cn->lru);
+	cd->names_count--;
+	free(cn);
+}
+
+/** Remove a directory with all its cached names.
+ *
+ * @param cache Directory name cache
+ * @param cd    Cached directory
+ *
+ */
+static void ext4_dir_cache_dir_remove(ext4_dir_cache_t *cache,
+    ext4_dir_cache_dir_t *cd)
+{
+	while (!list_empty(&cd->names_lru)) {
+		ext4_dir_cache_name_remove(cd, list_get_instance(
+		    list_first(&cd->names_lru), ext4_dir_cache_name_t, lru));
+	}
+
+	hash_table_destroy(&cd->names);
+	hash_table_remove_item(&cache->dirs, &cd->link);
+	list_remove(&cd->lru);
+	cache->dirs_count--;
+	free(cd);
+}
+
+/** Finalize directory name cache.
+ *
+ * @param cache Directory name cache
+ *
+ */
+void ext4_dir_cache_fini(ext4_dir_cache_t *cache)
+{
+	while (!list_empty(&cache->lru)) {
+		ext4_dir_cache_dir_remove(cache, list_get_instance(
+		    list_first(&cache->lru), ext4_dir_cache_dir_t, lru));
+	}
+
+	hash_table_destroy(&cache->dirs);
+}
+
+/** Find cached directory and mark it as recently used.
+ *
+ * @param cache Directory name cache
+ * @param index Index of the directory i-node
+ *
+ * @return Cached directory or NULL if not cached
+ *
+ */
+static ext4_dir_cache_dir_t *ext4_dir_cache_dir_find(ext4_dir_cache_t *cache,
+    uint32_t index)
+{
+	ht_link_t *link = hash_table_find(&cache->dirs, &index);
+	if (link == NULL)
+		return NULL;
+
+	ext4_dir_cache_dir_t *cd =
+	    hash_table_get_inst(link, ext4_dir_cache_dir_t, link);
+
+	list_remove(&cd->lru);
+	list_append(&cd->lru, &cache->lru);
+	return cd;
+}
+
+/** Find cached name of a directory.
+ *
+ * @param cd       Cached directory
+ * @param name     Name
+ * @param name_len Length of the name
+ *
+ * @return Cached name or NULL if not cached
+ *
+ */
+static ext4_dir_cache_name_t *ext4_dir_cache_name_find(
+    ext4_dir_cache_dir_t *cd, const char *name, size_t name_len)
+{
+	ext4_dir_cache_key_t key = {
+		.name = name,
+		.name_len = name_len
+	};
+
+	ht_link_t *link = hash_table_find(&cd->names, &key);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, ext4_dir_cache_name_t, link);
+}
+
+/** Look up the block of a directory entry in the cache.
+ *
+ * @param cache  Directory name cache
+ * @param index  Index of the directory i-node
+ * @param name   Name of the entry
+ * @param iblock Output value for the logical block with the entry
+ *
+ * @return True if the name was found in the cache
+ *
+ */
+bool ext4_dir_cache_lookup(ext4_dir_cache_t *cache, uint32_t index,
+    const char *name, uint32_t *iblock)
+{
+	bool found = false;
+
+	fibril_mutex_lock(&cache->lock);
+
+	ext4_dir_cache_dir_t *cd = ext4_dir_cache_dir_find(cache, index);
+	if (cd != NULL) {
+		ext4_dir_cache_name_t *cn = ext4_dir_cache_name_find(cd, name,
+		    str_size(name));
+		if (cn != NULL) {
+			list_remove(&cn->lru);
+			list_append(&cn->lru, &cd->names_lru);
+			*iblock = cn->iblock;
+			found = true;
+		}
+	}
+
+	fibril_mutex_unlock(&cache->lock);
+	return found;
+}
+
+/** Insert the block of a directory entry into the cache.
+ *
+ * @param cache  Directory name cache
+ * @param index  Index of the directory i-node
+ * @param name   Name of the entry
+ * @param iblock Logical block with the entry
+ *
+ */
+void ext4_dir_cache_insert(ext4_dir_cache_t *cache, uint32_t index,
+    const char *name, uint32_t iblock)
+{
+	size_t name_len = str_size(name);
+
+	fibril_mutex_lock(&cache->lock);
+
+	ext4_dir_cache_dir_t *cd = ext4_dir_cache_dir_find(cache, index);
+	if (cd == NULL) {
+		if (cache->dirs_count >= EXT4_DIR_CACHE_DIRS) {
+			ext4_dir_cache_dir_remove(cache, list_get_instance(
+			    list_first(&cache->lru), ext4_dir_cache_dir_t, lru));
+		}
+
+		cd = calloc(1, sizeof(ext4_dir_cache_dir_t));
+		if (cd == NULL)
+			goto out;
+
+		if (!hash_table_create(&cd->names, 0, 0,
+		    &ext4_dir_cache_name_ops)) {
+			free(cd);
+			goto out;
+		}
+
+		cd->index = index;
+		list_initialize(&cd->names_lru);
+		hash_table_insert(&cache->dirs, &cd->link);
+		list_append(&cd->lru, &cache->lru);
+		cache->dirs_count++;
+	}
+
+	ext4_dir_cache_name_t *cn = ext4_dir_cache_name_find(cd, name,
+	    name_len);
+	if (cn != NULL) {
+		cn->iblock = iblock;
+		list_remove(&cn->lru);
+		list_append(&cn->lru, &cd->names_lru);
+		goto out;
+	}
+
+	if (cd->names_count >= EXT4_DIR_CACHE_NAMES) {
+		ext4_dir_cache_name_remove(cd, list_get_instance(
+		    list_first(&cd->names_lru), ext4_dir_cache_name_t, lru));
+	}
+
+	cn = malloc(sizeof(ext4_dir_cache_name_t) + name_len);
+	if (cn == NULL)
+		goto out;
+
+	cn->iblock = iblock;
+	cn->name_len = name_len;
+	memcpy(cn->name, name, name_len);
+	hash_table_insert(&cd->names, &cn->link);
+	list_append(&cn->lru, &cd->names_lru);
+	cd->names_count++;
+
+out:
+	fibril_mutex_unlock(&cache->lock);
+}
+
+/** Remove a name of a directory from the cache.
+ *
+ * @param cache Directory name cache
+ * @param index Index of the directory i-node
+ * @param name  Name of the entry
+ *
+ */
+void ext4_dir_cache_remove(ext4_dir_cache_t *cache, uint32_t index,
+    const char *name)
+{
+	fibril_mutex_lock(&cache->lock);
+
+	ht_link_t *link = hash_table_find(&cache->dirs, &index);
+	if (link != NULL) {
+		ext4_dir_cache_dir_t *cd =
+		    hash_table_get_inst(link, ext4_dir_cache_dir_t, link);
+		ext4_dir_cache_name_t *cn = ext4_dir_cache_name_find(cd, name,
+		    str_size(name));
+		if (cn != NULL)
+			ext4_dir_cache_name_remove(cd, cn);
+	}
+
+	fibril_mutex_unlock(&cache->lock);
+}
+
+/** Remove all cached names of a directory.
+ *
+ * @param cache Directory name cache
+ * @param index Index of the directory i-node
+ *
+ */
+void ext4_dir_cache_invalidate(ext4_dir_cache_t *cache, uint32_t index)
+{
+	fibril_mutex_lock(&cache->lock);
+
+	ht_link_t *link = hash_table_find(&cache->dirs, &index);
+	if (link != NULL) {
+		ext4_dir_cache_dir_remove(cache,
+		    hash_table_get_inst(link, ext4_dir_cache_dir_t, link));
+	}
+
+	fibril_mutex_unlock(&cache->lock);
+}
+
+/**
+ * @}
+ */
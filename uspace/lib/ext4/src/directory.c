@@ -40,10 +40,12 @@
 #include <mem.h>
 #include <stdlib.h>
 #include <str.h>
+#include "ext4/dir_cache.h"
 #include "ext4/directory.h"
 #include "ext4/directory_index.h"
 #include "ext4/filesystem.h"
 #include "ext4/inode.h"
+#include "ext4/journal.h"
 #include "ext4/superblock.h"
 
 /** Get i-node number from directory entry.
@@ -445,6 +447,17 @@ errno_t ext4_directory_add_entry(ext4_inode_ref_t *parent, const char *name,
 			return EOK;
 	}
 
+	/* Index the directory instead of adding a second block to it */
+	if ((ext4_superblock_has_feature_compatible(fs->superblock,
+	    EXT4_FEATURE_COMPAT_DIR_INDEX)) && (total_blocks == 1)) {
+		errno_t rc = ext4_directory_dx_convert(parent);
+		if (rc == EOK)
+			return ext4_directory_dx_add_entry(parent, child, name);
+
+		if (rc != ENOTSUP)
+			return rc;
+	}
+
 	/* No free block found - needed to allocate next data block */
 
 	iblock = 0;
@@ -466,13 +479,63 @@ errno_t ext4_directory_add_entry(ext4_inode_ref_t *parent, const char *name,
 	    child, name, name_len);
 
 	/* Save new block */
-	new_block->dirty = true;
+	ext4_journal_dirty(fs, new_block);
 	rc = block_put(new_block);
 
 	return rc;
 }
 
-/** Find directory entry with passed name.
+/** Find directory entry in a data block of the directory.
+ *
+ * @param result   Result structure to be returned if entry found
+ * @param parent   Directory i-node
+ * @param iblock   Logical block to search
+ * @param name_len Length of the name
+ * @param name     Name of entry to be found
+ *
+ * @return Error code, ENOENT if the entry is not in the block
+ *
+ */
+static errno_t ext4_directory_find_in_iblock(
+    ext4_directory_search_result_t *result, ext4_inode_ref_t *parent,
+    uint32_t iblock, size_t name_len, const char *name)
+{
+	ext4_superblock_t *sb = parent->fs->superblock;
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
+
+	/* The directory may have been truncated in between */
+	if (iblock >= ext4_inode_get_size(sb, parent->inode) / block_size)
+		return ENOENT;
+
+	uint32_t fblock;
+	errno_t rc = ext4_filesystem_get_inode_data_block_index(parent, iblock,
+	    &fblock);
+	if (rc != EOK)
+		return rc;
+
+	if (fblock == 0)
+		return ENOENT;
+
+	block_t *block;
+	rc = block_get(&block, parent->fs->device, fblock, BLOCK_FLAGS_NONE);
+	if (rc != EOK)
+		return rc;
+
+	ext4_directory_entry_ll_t *res_entry;
+	rc = ext4_directory_find_in_block(block, sb, name_len, name,
+	    &res_entry);
+	if (rc != EOK) {
+		block_put(block);
+		return rc;
+	}
+
+	result->block = block;
+	result->dentry = res_entry;
+	result->iblock = iblock;
+	return EOK;
+}
+
+/** Find directory entry with passed name without remembering it.
  *
  * @param result Result structure to be returned if entry found
  * @param parent Directory i-node
@@ -481,13 +544,27 @@ errno_t ext4_directory_add_entry(ext4_inode_ref_t *parent, const char *name,
  * @return Error code
  *
  */
-errno_t ext4_directory_find_entry(ext4_directory_search_result_t *result,
-    ext4_inode_ref_t *parent, const char *name)
+static errno_t ext4_directory_find_entry_core(
+    ext4_directory_search_result_t *result, ext4_inode_ref_t *parent,
+    const char *name)
 {
 	uint32_t name_len = str_size(name);
 
 	ext4_superblock_t *sb = parent->fs->superblock;
 
+	/* Try the block where the name was found recently */
+	uint32_t hint;
+	if (ext4_dir_cache_lookup(&parent->fs->dir_cache, parent->index, name,
+	    &hint)) {
+		errno_t rc = ext4_directory_find_in_iblock(result, parent, hint,
+		    name_len, name);
+		if (rc != ENOENT)
+			return rc;
+
+		ext4_dir_cache_remove(&parent->fs->dir_cache, parent->index,
+		    name);
+	}
+
 	/* Index search */
 	if ((ext4_superblock_has_feature_compatible(sb,
 	    EXT4_FEATURE_COMPAT_DIR_INDEX)) &&
@@ -537,6 +614,7 @@ errno_t ext4_directory_find_entry(ext4_directory_search_result_t *result,
 		if (rc == EOK) {
 			result->block = block;
 			result->dentry = res_entry;
+			result->iblock = iblock;
 			return EOK;
 		}
 
@@ -555,6 +633,30 @@ errno_t ext4_directory_find_entry(ext4_directory_search_result_t *result,
 	return ENOENT;
 }
 
+/** Find directory entry with passed name.
+ *
+ * The block where the entry was found is remembered in the name cache of
+ * the directory, so that the next lookup of the name goes there directly.
+ *
+ * @param result Result structure to be returned if entry found
+ * @param parent Directory i-node
+ * @param name   Name of entry to be found
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_directory_find_entry(ext4_directory_search_result_t *result,
+    ext4_inode_ref_t *parent, const char *name)
+{
+	errno_t rc = ext4_directory_find_entry_core(result, parent, name);
+	if (rc == EOK) {
+		ext4_dir_cache_insert(&parent->fs->dir_cache, parent->index,
+		    name, result->iblock);
+	}
+
+	return rc;
+}
+
 /** Remove directory entry.
  *
  * @param parent Directory i-node
@@ -576,6 +678,8 @@ errno_t ext4_directory_remove_entry(ext4_inode_ref_t *parent, const char *name)
 	if (rc != EOK)
 		return rc;
 
+	ext4_dir_cache_remove(&parent->fs->dir_cache, parent->index, name);
+
 	/* Invalidate entry */
 	ext4_directory_entry_ll_set_inode(result.dentry, 0);
 
@@ -612,7 +716,7 @@ errno_t ext4_directory_remove_entry(ext4_inode_ref_t *parent, const char *name)
 		    tmp_dentry_length + del_entry_length);
 	}
 
-	result.block->dirty = true;
+	ext4_journal_dirty(parent->fs, result.block);
 
 	return ext4_directory_destroy_result(&result);
 }
@@ -655,7 +759,7 @@ errno_t ext4_directory_try_insert_entry(ext4_superblock_t *sb,
 		if ((inode == 0) && (rec_len >= required_len)) {
 			ext4_directory_write_entry(sb, dentry, rec_len, child,
 			    name, name_len);
-			target_block->dirty = true;
+			ext4_journal_dirty(child->fs, target_block);
 
 			return EOK;
 		}
@@ -682,7 +786,7 @@ errno_t ext4_directory_try_insert_entry(ext4_superblock_t *sb,
 				ext4_directory_write_entry(sb, new_entry,
 				    free_space, child, name, name_len);
 
-				target_block->dirty = true;
+				ext4_journal_dirty(child->fs, target_block);
 
 				return EOK;
 			}
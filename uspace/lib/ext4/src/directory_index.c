@@ -36,6 +36,7 @@
 
 #include <byteorder.h>
 #include <errno.h>
+#include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
 #include <str.h>
@@ -44,6 +45,7 @@
 #include "ext4/filesystem.h"
 #include "ext4/hash.h"
 #include "ext4/inode.h"
+#include "ext4/journal.h"
 #include "ext4/superblock.h"
 
 /** Type entry to pass to sorting algorithm.
@@ -55,6 +57,16 @@ typedef struct ext4_dx_sort_entry {
 	void *dentry;
 } ext4_dx_sort_entry_t;
 
+/*
+ * Layout of readdir cookies of indexed directories, see
+ * ext4_directory_dx_read_entry()
+ */
+#define EXT4_DX_COOKIE_RANK_BITS   3
+#define EXT4_DX_COOKIE_RANKS       (1 << EXT4_DX_COOKIE_RANK_BITS)
+#define EXT4_DX_COOKIE_HASH_SHIFT  4
+#define EXT4_DX_COOKIE_END \
+	((aoff64_t) 1 << (32 - EXT4_DX_COOKIE_HASH_SHIFT + EXT4_DX_COOKIE_RANK_BITS))
+
 /** Get hash version used in directory index.
  *
  * @param root_info Pointer to root info structure of index
@@ -228,31 +240,28 @@ void ext4_directory_dx_entry_set_block(ext4_directory_dx_entry_t *entry,
 	entry->block = host2uint32_t_le(block);
 }
 
-/** Initialize index structure of new directory.
+/** Set up the root of a directory index with a single leaf.
  *
- * @param dir Pointer to directory i-node
+ * The dot entries must already be at the beginning of the root block.
  *
- * @return Error code
+ * @param dir        Directory i-node
+ * @param root_block Block 0 of the directory
+ * @param iblock     Logical block of the leaf
  *
  */
-errno_t ext4_directory_dx_init(ext4_inode_ref_t *dir)
+static void ext4_directory_dx_root_setup(ext4_inode_ref_t *dir,
+    block_t *root_block, uint32_t iblock)
 {
-	/* Load block 0, where will be index root located */
-	uint32_t fblock;
-	errno_t rc = ext4_filesystem_get_inode_data_block_index(dir, 0,
-	    &fblock);
-	if (rc != EOK)
-		return rc;
-
-	block_t *block;
-	rc = block_get(&block, dir->fs->device, fblock, BLOCK_FLAGS_NONE);
-	if (rc != EOK)
-		return rc;
+	uint32_t block_size =
+	    ext4_superblock_get_block_size(dir->fs->superblock);
 
 	/* Initialize pointers to data structures */
-	ext4_directory_dx_root_t *root = block->data;
+	ext4_directory_dx_root_t *root = root_block->data;
 	ext4_directory_dx_root_info_t *info = &(root->info);
 
+	/* Clear everything behind the dot entries */
+	memset(info, 0, block_size - 2 * sizeof(ext4_directory_dx_dot_entry_t));
+
 	/* Initialize root info structure */
 	uint8_t hash_version =
 	    ext4_superblock_get_default_hash_version(dir->fs->superblock);
@@ -266,14 +275,43 @@ errno_t ext4_directory_dx_init(ext4_inode_ref_t *dir)
 	    (ext4_directory_dx_countlimit_t *) &root->entries;
 	ext4_directory_dx_countlimit_set_count(countlimit, 1);
 
-	uint32_t block_size =
-	    ext4_superblock_get_block_size(dir->fs->superblock);
 	uint32_t entry_space =
 	    block_size - 2 * sizeof(ext4_directory_dx_dot_entry_t) -
 	    sizeof(ext4_directory_dx_root_info_t);
 	uint16_t root_limit = entry_space / sizeof(ext4_directory_dx_entry_t);
 	ext4_directory_dx_countlimit_set_limit(countlimit, root_limit);
 
+	/* Connect the leaf to the only entry in index */
+	ext4_directory_dx_entry_t *entry = root->entries;
+	ext4_directory_dx_entry_set_block(entry, iblock);
+
+	ext4_journal_dirty(dir->fs, root_block);
+}
+
+/** Initialize index structure of new directory.
+ *
+ * @param dir Pointer to directory i-node
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_directory_dx_init(ext4_inode_ref_t *dir)
+{
+	/* Load block 0, where will be index root located */
+	uint32_t fblock;
+	errno_t rc = ext4_filesystem_get_inode_data_block_index(dir, 0,
+	    &fblock);
+	if (rc != EOK)
+		return rc;
+
+	block_t *block;
+	rc = block_get(&block, dir->fs->device, fblock, BLOCK_FLAGS_NONE);
+	if (rc != EOK)
+		return rc;
+
+	uint32_t block_size =
+	    ext4_superblock_get_block_size(dir->fs->superblock);
+
 	/* Append new block, where will be new entries inserted in the future */
 	uint32_t iblock;
 	rc = ext4_filesystem_append_inode_block(dir, &fblock, &iblock);
@@ -294,22 +332,154 @@ errno_t ext4_directory_dx_init(ext4_inode_ref_t *dir)
 	ext4_directory_entry_ll_set_entry_length(block_entry, block_size);
 	ext4_directory_entry_ll_set_inode(block_entry, 0);
 
-	new_block->dirty = true;
+	ext4_journal_dirty(dir->fs, new_block);
 	rc = block_put(new_block);
 	if (rc != EOK) {
 		block_put(block);
 		return rc;
 	}
 
-	/* Connect new block to the only entry in index */
-	ext4_directory_dx_entry_t *entry = root->entries;
-	ext4_directory_dx_entry_set_block(entry, iblock);
-
-	block->dirty = true;
+	ext4_directory_dx_root_setup(dir, block, iblock);
 
 	return block_put(block);
 }
 
+/** Convert a directory with a single block to an indexed one.
+ *
+ * Linear directories are indexed when they outgrow their first block, so
+ * that names of large directories are always found through the index.
+ * The entries following the dot entries are moved to a new leaf and the
+ * first block becomes the root of the index.
+ *
+ * @param dir Directory i-node
+ *
+ * @return Error code, ENOTSUP if the first block has an unexpected layout
+ *
+ */
+errno_t ext4_directory_dx_convert(ext4_inode_ref_t *dir)
+{
+	ext4_superblock_t *sb = dir->fs->superblock;
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
+
+	if (ext4_inode_get_size(sb, dir->inode) != block_size)
+		return ENOTSUP;
+
+	uint32_t fblock;
+	errno_t rc = ext4_filesystem_get_inode_data_block_index(dir, 0,
+	    &fblock);
+	if (rc != EOK)
+		return rc;
+
+	block_t *block;
+	rc = block_get(&block, dir->fs->device, fblock, BLOCK_FLAGS_NONE);
+	if (rc != EOK)
+		return rc;
+
+	/* The root needs the dot entries in their minimal size */
+	ext4_directory_entry_ll_t *dot = block->data;
+	ext4_directory_entry_ll_t *dotdot = block->data +
+	    sizeof(ext4_directory_dx_dot_entry_t);
+	if ((ext4_directory_entry_ll_get_entry_length(dot) !=
+	    sizeof(ext4_directory_dx_dot_entry_t)) ||
+	    (ext4_directory_entry_ll_get_name_length(sb, dot) != 1) ||
+	    (dot->name[0] != '.') ||
+	    (ext4_directory_entry_ll_get_name_length(sb, dotdot) != 2) ||
+	    (dotdot->name[0] != '.') || (dotdot->name[1] != '.')) {
+		block_put(block);
+		return ENOTSUP;
+	}
+
+	void *entry_buffer = malloc(block_size);
+	if (entry_buffer == NULL) {
+		block_put(block);
+		return ENOMEM;
+	}
+
+	/* Pack the other entries into the buffer */
+	uint32_t offset = sizeof(ext4_directory_dx_dot_entry_t) +
+	    ext4_directory_entry_ll_get_entry_length(dotdot);
+	uint32_t size = 0;
+	void *last = NULL;
+	while (offset + 8 <= block_size) {
+		ext4_directory_entry_ll_t *dentry = block->data + offset;
+		uint16_t dentry_len =
+		    ext4_directory_entry_ll_get_entry_length(dentry);
+		if ((dentry_len < 8) || (offset + dentry_len > block_size)) {
+			free(entry_buffer);
+			block_put(block);
+			return EIO;
+		}
+
+		if (ext4_directory_entry_ll_get_inode(dentry) != 0) {
+			uint32_t rec_len = 8 +
+			    ext4_directory_entry_ll_get_name_length(sb, dentry);
+			if ((rec_len % 4) != 0)
+				rec_len += 4 - (rec_len % 4);
+
+			last = entry_buffer + size;
+			memcpy(last, dentry, rec_len);
+			ext4_directory_entry_ll_set_entry_length(last, rec_len);
+			size += rec_len;
+		}
+
+		offset += dentry_len;
+	}
+
+	/* Extend the last entry up to the end of the leaf */
+	if (last != NULL) {
+		ext4_directory_entry_ll_set_entry_length(last,
+		    block_size - (last - entry_buffer));
+	} else {
+		ext4_directory_entry_ll_t *empty = entry_buffer;
+		ext4_directory_entry_ll_set_entry_length(empty, block_size);
+		ext4_directory_entry_ll_set_inode(empty, 0);
+		size = block_size;
+	}
+
+	uint32_t iblock;
+	rc = ext4_filesystem_append_inode_block(dir, &fblock, &iblock);
+	if (rc != EOK) {
+		free(entry_buffer);
+		block_put(block);
+		return rc;
+	}
+
+	block_t *leaf_block;
+	rc = block_get(&leaf_block, dir->fs->device, fblock,
+	    BLOCK_FLAGS_NOREAD);
+	if (rc != EOK) {
+		free(entry_buffer);
+		block_put(block);
+		return rc;
+	}
+
+	memset(leaf_block->data, 0, block_size);
+	memcpy(leaf_block->data, entry_buffer, size);
+	free(entry_buffer);
+
+	ext4_journal_dirty(dir->fs, leaf_block);
+	rc = block_put(leaf_block);
+	if (rc != EOK) {
+		block_put(block);
+		return rc;
+	}
+
+	/* The dotdot entry covers the index in the root */
+	ext4_directory_entry_ll_set_entry_length(dotdot,
+	    block_size - sizeof(ext4_directory_dx_dot_entry_t));
+
+	ext4_directory_dx_root_setup(dir, block, iblock);
+
+	rc = block_put(block);
+	if (rc != EOK)
+		return rc;
+
+	ext4_inode_set_flag(dir->inode, EXT4_INODE_FLAG_INDEX);
+	dir->dirty = true;
+
+	return EOK;
+}
+
 /** Initialize hash info structure necessary for index operations.
  *
  * @param hinfo      Pointer to hinfo to be initialized
@@ -458,7 +628,7 @@ static errno_t ext4_directory_dx_get_leaf(ext4_hash_info_t *hinfo,
 
 		uint16_t entry_space =
 		    ext4_superblock_get_block_size(inode_ref->fs->superblock) -
-		    sizeof(ext4_directory_dx_dot_entry_t);
+		    sizeof(ext4_fake_directory_entry_t);
 		entry_space = entry_space / sizeof(ext4_directory_dx_entry_t);
 
 		if (limit != entry_space) {
@@ -473,24 +643,24 @@ static errno_t ext4_directory_dx_get_leaf(ext4_hash_info_t *hinfo,
 	return EOK;
 }
 
-/** Check if the the next block would be checked during entry search.
+/** Move the path to the next index entry.
  *
- * @param inode_ref Directory i-node
- * @param hash      Hash value to check
- * @param dx_block  Current block
- * @param dx_blocks Array with path from root to leaf node
+ * @param dx_block    Leaf level of the path
+ * @param dx_blocks   Array with path from root to leaf node
+ * @param level       Output value for the level with the next entry
+ * @param num_handles Output value for number of levels below it
  *
- * @return Error code
+ * @return False if the whole index has been passed
  *
  */
-static errno_t ext4_directory_dx_next_block(ext4_inode_ref_t *inode_ref,
-    uint32_t hash, ext4_directory_dx_block_t *dx_block,
-    ext4_directory_dx_block_t *dx_blocks)
+static bool ext4_directory_dx_path_next(ext4_directory_dx_block_t *dx_block,
+    ext4_directory_dx_block_t *dx_blocks, ext4_directory_dx_block_t **level,
+    uint32_t *num_handles)
 {
-	uint32_t num_handles = 0;
 	ext4_directory_dx_block_t *p = dx_block;
 
-	/* Try to find data block with next bunch of entries */
+	*num_handles = 0;
+
 	while (true) {
 		p->position++;
 		uint16_t count = ext4_directory_dx_countlimit_get_count(
@@ -500,20 +670,28 @@ static errno_t ext4_directory_dx_next_block(ext4_inode_ref_t *inode_ref,
 			break;
 
 		if (p == dx_blocks)
-			return EOK;
+			return false;
 
-		num_handles++;
+		(*num_handles)++;
 		p--;
 	}
 
-	/* Check hash collision (if not occured - no next block cannot be used) */
-	uint32_t current_hash = ext4_directory_dx_entry_get_hash(p->position);
-	if ((hash & 1) == 0) {
-		if ((current_hash & ~1) != hash)
-			return 0;
-	}
+	*level = p;
+	return true;
+}
 
-	/* Fill new path */
+/** Load the nodes of the path below the moved index entry.
+ *
+ * @param inode_ref   Directory i-node
+ * @param p           Level with the moved index entry
+ * @param num_handles Number of levels below it
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_directory_dx_path_load(ext4_inode_ref_t *inode_ref,
+    ext4_directory_dx_block_t *p, uint32_t num_handles)
+{
 	while (num_handles--) {
 		uint32_t block_idx =
 		    ext4_directory_dx_entry_get_block(p->position);
@@ -541,9 +719,70 @@ static errno_t ext4_directory_dx_next_block(ext4_inode_ref_t *inode_ref,
 		p->position = p->entries;
 	}
 
+	return EOK;
+}
+
+/** Check if the the next block would be checked during entry search.
+ *
+ * @param inode_ref Directory i-node
+ * @param hash      Hash value to check
+ * @param dx_block  Current block
+ * @param dx_blocks Array with path from root to leaf node
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_directory_dx_next_block(ext4_inode_ref_t *inode_ref,
+    uint32_t hash, ext4_directory_dx_block_t *dx_block,
+    ext4_directory_dx_block_t *dx_blocks)
+{
+	ext4_directory_dx_block_t *p;
+	uint32_t num_handles;
+
+	/* Try to find data block with next bunch of entries */
+	if (!ext4_directory_dx_path_next(dx_block, dx_blocks, &p, &num_handles))
+		return EOK;
+
+	/* Check hash collision (if not occured - no next block cannot be used) */
+	uint32_t current_hash = ext4_directory_dx_entry_get_hash(p->position);
+	if ((hash & 1) == 0) {
+		if ((current_hash & ~1) != hash)
+			return 0;
+	}
+
+	/* Fill new path */
+	errno_t rc = ext4_directory_dx_path_load(inode_ref, p, num_handles);
+	if (rc != EOK)
+		return rc;
+
 	return ENOENT;
 }
 
+/** Go to the next leaf of the index.
+ *
+ * @param inode_ref Directory i-node
+ * @param dx_block  Current leaf
+ * @param dx_blocks Array with path from root to leaf node
+ * @param hash      Output value for the lowest hash value of the next leaf
+ *
+ * @return Error code, ENOENT if there is no next leaf
+ *
+ */
+static errno_t ext4_directory_dx_next_leaf(ext4_inode_ref_t *inode_ref,
+    ext4_directory_dx_block_t *dx_block, ext4_directory_dx_block_t *dx_blocks,
+    uint32_t *hash)
+{
+	ext4_directory_dx_block_t *p;
+	uint32_t num_handles;
+
+	if (!ext4_directory_dx_path_next(dx_block, dx_blocks, &p, &num_handles))
+		return ENOENT;
+
+	*hash = ext4_directory_dx_entry_get_hash(p->position) & ~1;
+
+	return ext4_directory_dx_path_load(inode_ref, p, num_handles);
+}
+
 /** Try to find directory entry using directory index.
  *
  * @param result    Output value - if entry will be found,
@@ -624,6 +863,7 @@ errno_t ext4_directory_dx_find_entry(ext4_directory_search_result_t *result,
 		if (rc == EOK) {
 			result->block = leaf_block;
 			result->dentry = res_dentry;
+			result->iblock = leaf_block_idx;
 			goto cleanup;
 		}
 
@@ -660,6 +900,279 @@ cleanup:
 	return rc;
 }
 
+/** Candidate entry of a hash ordered directory read.
+ *
+ */
+typedef struct ext4_dx_read_entry {
+	uint32_t hash;
+	uint32_t minor_hash;
+	uint32_t fblock;        /* Block with the entry */
+	uint32_t offset;        /* Offset of the entry in the block */
+	uint8_t name_len;
+	uint8_t name[EXT4_DIRECTORY_FILENAME_LEN];
+} ext4_dx_read_entry_t;
+
+/** Compare candidate entries of a hash ordered directory read.
+ *
+ * Entries are ordered by hash values, the names only order collisions.
+ *
+ * @param a First entry
+ * @param b Second entry
+ *
+ * @return Classic compare result
+ *
+ */
+static int ext4_directory_dx_read_entry_cmp(const ext4_dx_read_entry_t *a,
+    const ext4_dx_read_entry_t *b)
+{
+	if (a->hash != b->hash)
+		return a->hash < b->hash ? -1 : 1;
+
+	if (a->minor_hash != b->minor_hash)
+		return a->minor_hash < b->minor_hash ? -1 : 1;
+
+	if (a->name_len != b->name_len)
+		return a->name_len < b->name_len ? -1 : 1;
+
+	return memcmp(a->name, b->name, a->name_len);
+}
+
+/** Read the entry of an indexed directory following a cookie.
+ *
+ * Entries are read in hash order rather than in the order of offsets, so
+ * that reading continues where it stopped even if the index has been split
+ * in between and only the leaves around the cookie need to be scanned. The
+ * cookie selects a bucket of hash values by EXT4_DX_COOKIE_HASH_SHIFT upper
+ * hash bits and ranks the entries within the bucket by its low
+ * EXT4_DX_COOKIE_RANK_BITS bits. Cookies are below 2^31, so differences of
+ * two cookies can be returned as byte counts of a read even on 32-bit
+ * systems. Buckets are narrow enough never to get more than
+ * EXT4_DX_COOKIE_RANKS names in practice, further ones would be skipped.
+ *
+ * @param result    Output value for the entry found
+ * @param inode_ref Directory i-node
+ * @param pos       Cookie to continue reading from, 0 for the first entry
+ * @param next      Output value for the cookie of the following entry
+ *
+ * @return Error code, ENOENT if there are no more entries
+ *
+ */
+errno_t ext4_directory_dx_read_entry(ext4_directory_search_result_t *result,
+    ext4_inode_ref_t *inode_ref, aoff64_t pos, aoff64_t *next)
+{
+	ext4_filesystem_t *fs = inode_ref->fs;
+	ext4_dx_read_entry_t *bucket_entries = NULL;
+	ext4_dx_read_entry_t *beyond = NULL;
+	uint32_t bucket_count = 0;
+	bool beyond_found = false;
+	errno_t rc2;
+
+	result->block = NULL;
+	result->dentry = NULL;
+
+	if (pos >= EXT4_DX_COOKIE_END)
+		return ENOENT;
+
+	uint32_t bucket = pos >> EXT4_DX_COOKIE_RANK_BITS;
+	uint32_t rank = pos & (EXT4_DX_COOKIE_RANKS - 1);
+
+	/* Load direct block 0 (index root) */
+	uint32_t root_block_addr;
+	errno_t rc = ext4_filesystem_get_inode_data_block_index(inode_ref, 0,
+	    &root_block_addr);
+	if (rc != EOK)
+		return rc;
+
+	block_t *root_block;
+	rc = block_get(&root_block, fs->device, root_block_addr,
+	    BLOCK_FLAGS_NONE);
+	if (rc != EOK)
+		return rc;
+
+	ext4_hash_info_t hinfo;
+	rc = ext4_directory_hinfo_init(&hinfo, root_block, fs->superblock,
+	    0, NULL);
+	if (rc != EOK) {
+		block_put(root_block);
+		return EXT4_ERR_BAD_DX_DIR;
+	}
+
+	/* Find the leaf with the first hash value of the bucket */
+	hinfo.hash = bucket << EXT4_DX_COOKIE_HASH_SHIFT;
+
+	ext4_directory_dx_block_t dx_blocks[2];
+	ext4_directory_dx_block_t *dx_block;
+	ext4_directory_dx_block_t *tmp;
+
+	rc = ext4_directory_dx_get_leaf(&hinfo, inode_ref, root_block,
+	    &dx_block, dx_blocks);
+	if (rc != EOK) {
+		block_put(root_block);
+		return EXT4_ERR_BAD_DX_DIR;
+	}
+
+	/* The ranked entries of the bucket and the first entry behind it */
+	bucket_entries = malloc((EXT4_DX_COOKIE_RANKS + 1) *
+	    sizeof(ext4_dx_read_entry_t));
+	if (bucket_entries == NULL) {
+		rc = ENOMEM;
+		goto cleanup;
+	}
+
+	beyond = &bucket_entries[EXT4_DX_COOKIE_RANKS];
+
+	uint32_t block_size = ext4_superblock_get_block_size(fs->superblock);
+
+	while (true) {
+		uint32_t leaf_block_idx =
+		    ext4_directory_dx_entry_get_block(dx_block->position);
+		uint32_t leaf_block_addr;
+
+		rc = ext4_filesystem_get_inode_data_block_index(inode_ref,
+		    leaf_block_idx, &leaf_block_addr);
+		if (rc != EOK)
+			goto cleanup;
+
+		block_t *leaf_block;
+		rc = block_get(&leaf_block, fs->device, leaf_block_addr,
+		    BLOCK_FLAGS_NONE);
+		if (rc != EOK)
+			goto cleanup;
+
+		uint32_t offset = 0;
+		while (offset + 8 <= block_size) {
+			ext4_directory_entry_ll_t *dentry =
+			    leaf_block->data + offset;
+			uint16_t dentry_len =
+			    ext4_directory_entry_ll_get_entry_length(dentry);
+			uint16_t name_len = ext4_directory_entry_ll_get_name_length(
+			    fs->superblock, dentry);
+
+			/* Corrupted entry */
+			if ((dentry_len < 8) || (offset + dentry_len > block_size) ||
+			    (name_len > dentry_len - 8) ||
+			    (name_len > EXT4_DIRECTORY_FILENAME_LEN)) {
+				block_put(leaf_block);
+				rc = EIO;
+				goto cleanup;
+			}
+
+			/* Dot entries are in the root, not in the leaves */
+			if (ext4_directory_entry_ll_get_inode(dentry) == 0)
+				goto skip;
+
+			ext4_dx_read_entry_t entry;
+			ext4_hash_string(&hinfo, name_len, (char *) dentry->name);
+			entry.hash = hinfo.hash;
+			entry.minor_hash = hinfo.minor_hash;
+			entry.fblock = leaf_block_addr;
+			entry.offset = offset;
+			entry.name_len = name_len;
+			memcpy(entry.name, dentry->name, name_len);
+
+			uint32_t entry_bucket =
+			    entry.hash >> EXT4_DX_COOKIE_HASH_SHIFT;
+
+			if (entry_bucket == bucket) {
+				/* Keep the lowest entries of the bucket sorted */
+				uint32_t i = bucket_count;
+				while ((i > 0) && ext4_directory_dx_read_entry_cmp(
+				    &entry, &bucket_entries[i - 1]) < 0)
+					i--;
+
+				if (i < EXT4_DX_COOKIE_RANKS) {
+					uint32_t last = min(bucket_count,
+					    EXT4_DX_COOKIE_RANKS - 1);
+					memmove(&bucket_entries[i + 1],
+					    &bucket_entries[i],
+					    (last - i) * sizeof(ext4_dx_read_entry_t));
+					bucket_entries[i] = entry;
+					if (bucket_count < EXT4_DX_COOKIE_RANKS)
+						bucket_count++;
+				}
+			} else if (entry_bucket > bucket) {
+				if (!beyond_found ||
+				    ext4_directory_dx_read_entry_cmp(&entry,
+				    beyond) < 0) {
+					*beyond = entry;
+					beyond_found = true;
+				}
+			}
+
+		skip:
+			offset += dentry_len;
+		}
+
+		rc = block_put(leaf_block);
+		if (rc != EOK)
+			goto cleanup;
+
+		uint32_t next_hash;
+		rc = ext4_directory_dx_next_leaf(inode_ref, dx_block, dx_blocks,
+		    &next_hash);
+		if (rc == ENOENT)
+			break;
+		if (rc != EOK)
+			goto cleanup;
+
+		/*
+		 * Further leaves only hold higher hash values, they are not
+		 * needed once the bucket is complete and an entry has been
+		 * found that they cannot precede.
+		 */
+		if ((next_hash >> EXT4_DX_COOKIE_HASH_SHIFT) > bucket) {
+			if (bucket_count > rank)
+				break;
+			if (beyond_found && (next_hash > beyond->hash))
+				break;
+		}
+	}
+
+	ext4_dx_read_entry_t *found;
+	if (bucket_count > rank) {
+		found = &bucket_entries[rank];
+		*next = pos + 1;
+	} else if (beyond_found) {
+		found = beyond;
+		*next = (((aoff64_t) found->hash >> EXT4_DX_COOKIE_HASH_SHIFT) <<
+		    EXT4_DX_COOKIE_RANK_BITS) + 1;
+	} else {
+		rc = ENOENT;
+		goto cleanup;
+	}
+
+	/* The block is still cached, get it for the caller */
+	rc = block_get(&result->block, fs->device, found->fblock,
+	    BLOCK_FLAGS_NONE);
+	if (rc != EOK) {
+		result->block = NULL;
+		goto cleanup;
+	}
+
+	result->dentry = result->block->data + found->offset;
+
+cleanup:
+	free(bucket_entries);
+
+	/* The whole path must be released (preventing memory leak) */
+	tmp = dx_blocks;
+
+	while (tmp <= dx_block) {
+		rc2 = block_put(tmp->block);
+		if (rc == EOK && rc2 != EOK)
+			rc = rc2;
+		++tmp;
+	}
+
+	if ((rc != EOK) && (result->block != NULL)) {
+		block_put(result->block);
+		result->block = NULL;
+		result->dentry = NULL;
+	}
+
+	return rc;
+}
+
 /** Compare function used to pass in quicksort implementation.
  *
  * It can compare two entries by hash value.
@@ -690,12 +1203,13 @@ static int ext4_directory_dx_entry_comparator(const void *arg1,
  *
  * Note that space for new entry must be checked by caller.
  *
+ * @param inode_ref   Directory i-node
  * @param index_block Block where to insert new entry
  * @param hash        Hash value covered by child node
  * @param iblock      Logical number of child block
  *
  */
-static void ext4_directory_dx_insert_entry(
+static void ext4_directory_dx_insert_entry(ext4_inode_ref_t *inode_ref,
     ext4_directory_dx_block_t *index_block, uint32_t hash, uint32_t iblock)
 {
 	ext4_directory_dx_entry_t *old_index_entry = index_block->position;
@@ -715,7 +1229,7 @@ static void ext4_directory_dx_insert_entry(
 
 	ext4_directory_dx_countlimit_set_count(countlimit, count + 1);
 
-	index_block->block->dirty = true;
+	ext4_journal_dirty(inode_ref->fs, index_block->block);
 }
 
 /** Split directory entries to two parts preventing node overflow.
@@ -873,14 +1387,14 @@ static errno_t ext4_directory_dx_split_data(ext4_inode_ref_t *inode_ref,
 	}
 
 	/* Do some steps to finish operation */
-	old_data_block->dirty = true;
-	new_data_block_tmp->dirty = true;
+	ext4_journal_dirty(inode_ref->fs, old_data_block);
+	ext4_journal_dirty(inode_ref->fs, new_data_block_tmp);
 
 	free(sort_array);
 	free(entry_buffer);
 
-	ext4_directory_dx_insert_entry(index_block, new_hash + continued,
-	    new_iblock);
+	ext4_directory_dx_insert_entry(inode_ref, index_block,
+	    new_hash + continued, new_iblock);
 
 	*new_data_block = new_data_block_tmp;
 
@@ -891,14 +1405,16 @@ static errno_t ext4_directory_dx_split_data(ext4_inode_ref_t *inode_ref,
  *
  * @param inode_ref Directory i-node
  * @param dx_blocks Array with path from root to leaf node
- * @param dx_block  Leaf block to be split if needed
+ * @param dx_leaf   Leaf block to be split if needed, moved to the new
+ *                  level if the tree grows
  *
  * @return Error code
  *
  */
 static errno_t ext4_directory_dx_split_index(ext4_inode_ref_t *inode_ref,
-    ext4_directory_dx_block_t *dx_blocks, ext4_directory_dx_block_t *dx_block)
+    ext4_directory_dx_block_t *dx_blocks, ext4_directory_dx_block_t **dx_leaf)
 {
+	ext4_directory_dx_block_t *dx_block = *dx_leaf;
 	ext4_directory_dx_entry_t *entries;
 	if (dx_block == dx_blocks)
 		entries =
@@ -954,6 +1470,11 @@ static errno_t ext4_directory_dx_split_index(ext4_inode_ref_t *inode_ref,
 		uint32_t block_size =
 		    ext4_superblock_get_block_size(inode_ref->fs->superblock);
 
+		/* The node looks like an empty block to linear directory code */
+		memset(&new_node->fake, 0, sizeof(ext4_fake_directory_entry_t));
+		ext4_directory_entry_ll_set_entry_length(
+		    (ext4_directory_entry_ll_t *) &new_node->fake, block_size);
+
 		/* Split leaf node */
 		if (levels > 0) {
 			uint32_t count_left = leaf_count / 2;
@@ -980,11 +1501,12 @@ static errno_t ext4_directory_dx_split_index(ext4_inode_ref_t *inode_ref,
 			    entry_space / sizeof(ext4_directory_dx_entry_t);
 			ext4_directory_dx_countlimit_set_limit(right_countlimit, node_limit);
 
+			ext4_journal_dirty(inode_ref->fs, dx_block->block);
+			ext4_journal_dirty(inode_ref->fs, new_block);
+
 			/* Which index block is target for new entry */
 			uint32_t position_index = (dx_block->position - dx_block->entries);
 			if (position_index >= count_left) {
-				dx_block->block->dirty = true;
-
 				block_t *block_tmp = dx_block->block;
 				dx_block->block = new_block;
 				dx_block->position =
@@ -995,7 +1517,8 @@ static errno_t ext4_directory_dx_split_index(ext4_inode_ref_t *inode_ref,
 			}
 
 			/* Finally insert new entry */
-			ext4_directory_dx_insert_entry(dx_blocks, hash_right, new_iblock);
+			ext4_directory_dx_insert_entry(inode_ref, dx_blocks, hash_right,
+			    new_iblock);
 
 			return block_put(new_block);
 		} else {
@@ -1026,9 +1549,16 @@ static errno_t ext4_directory_dx_split_index(ext4_inode_ref_t *inode_ref,
 
 			/* Add new entry to the path */
 			dx_block = dx_blocks + 1;
-			dx_block->position = dx_block->position - entries + new_entries;
+			dx_block->position = dx_blocks[0].position - entries +
+			    new_entries;
 			dx_block->entries = new_entries;
 			dx_block->block = new_block;
+			dx_blocks[0].position = entries;
+
+			ext4_journal_dirty(inode_ref->fs, dx_blocks[0].block);
+			ext4_journal_dirty(inode_ref->fs, new_block);
+
+			*dx_leaf = dx_block;
 		}
 	}
 
@@ -1114,7 +1644,7 @@ errno_t ext4_directory_dx_add_entry(ext4_inode_ref_t *parent,
 	 * Check if there is needed to split index node
 	 * (and recursively also parent nodes)
 	 */
-	rc = ext4_directory_dx_split_index(parent, dx_blocks, dx_block);
+	rc = ext4_directory_dx_split_index(parent, dx_blocks, &dx_block);
 	if (rc != EOK)
 		goto release_target_index;
 
@@ -40,7 +40,9 @@
 #include <stdlib.h>
 #include "ext4/balloc.h"
 #include "ext4/extent.h"
+#include "ext4/extent_cache.h"
 #include "ext4/inode.h"
+#include "ext4/journal.h"
 #include "ext4/superblock.h"
 
 /** Get logical number of the block covered by extent.
@@ -390,6 +392,11 @@ errno_t ext4_extent_find_block(ext4_inode_ref_t *inode_ref, uint32_t iblock,
 		return EOK;
 	}
 
+	/* Recently resolved extents need no walk through the tree */
+	if (ext4_extent_cache_lookup(&inode_ref->fs->extent_cache,
+	    inode_ref->index, iblock, fblock))
+		return EOK;
+
 	block_t *block = NULL;
 
 	/* Walk through extent tree */
@@ -429,9 +436,17 @@ errno_t ext4_extent_find_block(ext4_inode_ref_t *inode_ref, uint32_t iblock,
 		/* Compute requested physical block address */
 		uint32_t phys_block;
 		uint32_t first = ext4_extent_get_first_block(extent);
+		uint16_t count = ext4_extent_get_block_count(extent);
 		phys_block = ext4_extent_get_start(extent) + iblock - first;
 
 		*fblock = phys_block;
+
+		/* Uninitialized extents (count over 2^15) are not cached */
+		if (iblock - first < count && count <= (1 << 15)) {
+			ext4_extent_cache_insert(&inode_ref->fs->extent_cache,
+			    inode_ref->index, first, count,
+			    ext4_extent_get_start(extent));
+		}
 	}
 
 	/* Cleanup */
@@ -619,6 +634,9 @@ static errno_t ext4_extent_release_branch(ext4_inode_ref_t *inode_ref,
 errno_t ext4_extent_release_blocks_from(ext4_inode_ref_t *inode_ref,
     uint32_t iblock_from)
 {
+	ext4_extent_cache_invalidate(&inode_ref->fs->extent_cache,
+	    inode_ref->index, iblock_from);
+
 	/* Find the first extent to modify */
 	ext4_extent_path_t *path;
 	errno_t rc2;
@@ -677,7 +695,7 @@ errno_t ext4_extent_release_blocks_from(ext4_inode_ref_t *inode_ref,
 	}
 
 	ext4_extent_header_set_entries_count(path_ptr->header, entries);
-	path_ptr->block->dirty = true;
+	ext4_journal_dirty(inode_ref->fs, path_ptr->block);
 
 	/* If leaf node is empty, parent entry must be modified */
 	bool remove_parent_record = false;
@@ -716,7 +734,7 @@ errno_t ext4_extent_release_blocks_from(ext4_inode_ref_t *inode_ref,
 		}
 
 		ext4_extent_header_set_entries_count(path_ptr->header, entries);
-		path_ptr->block->dirty = true;
+		ext4_journal_dirty(inode_ref->fs, path_ptr->block);
 
 		/* Free the node if it is empty */
 		if ((entries == 0) && (path_ptr != path)) {
@@ -828,7 +846,7 @@ static errno_t ext4_extent_append_extent(ext4_inode_ref_t *inode_ref,
 			ext4_extent_header_set_depth(path_ptr->header, path_ptr->depth);
 			ext4_extent_header_set_generation(path_ptr->header, 0);
 
-			path_ptr->block->dirty = true;
+			ext4_journal_dirty(inode_ref->fs, path_ptr->block);
 
 			/* Jump to the preceeding item */
 			path_ptr--;
@@ -844,7 +862,7 @@ static errno_t ext4_extent_append_extent(ext4_inode_ref_t *inode_ref,
 			}
 
 			ext4_extent_header_set_entries_count(path_ptr->header, entries + 1);
-			path_ptr->block->dirty = true;
+			ext4_journal_dirty(inode_ref->fs, path_ptr->block);
 
 			/* No more splitting needed */
 			return EOK;
@@ -914,7 +932,7 @@ static errno_t ext4_extent_append_extent(ext4_inode_ref_t *inode_ref,
 		ext4_extent_header_set_entries_count(old_root->header, entries + 1);
 		ext4_extent_header_set_max_entries_count(old_root->header, limit);
 
-		old_root->block->dirty = true;
+		ext4_journal_dirty(inode_ref->fs, old_root->block);
 
 		/* Re-initialize new root metadata */
 		new_root->depth = root_depth + 1;
@@ -930,7 +948,7 @@ static errno_t ext4_extent_append_extent(ext4_inode_ref_t *inode_ref,
 		ext4_extent_index_set_first_block(new_root->index, 0);
 		ext4_extent_index_set_leaf(new_root->index, new_fblock);
 
-		new_root->block->dirty = true;
+		ext4_journal_dirty(inode_ref->fs, new_root->block);
 	} else {
 		if (path->depth) {
 			path->index = EXT4_EXTENT_FIRST_INDEX(path->header) + entries;
@@ -942,7 +960,7 @@ static errno_t ext4_extent_append_extent(ext4_inode_ref_t *inode_ref,
 		}
 
 		ext4_extent_header_set_entries_count(path->header, entries + 1);
-		path->block->dirty = true;
+		ext4_journal_dirty(inode_ref->fs, path->block);
 	}
 
 	return EOK;
@@ -1016,7 +1034,7 @@ errno_t ext4_extent_append_block(ext4_inode_ref_t *inode_ref, uint32_t *iblock,
 				inode_ref->dirty = true;
 			}
 
-			path_ptr->block->dirty = true;
+			ext4_journal_dirty(inode_ref->fs, path_ptr->block);
 
 			goto finish;
 		} else {
@@ -1044,7 +1062,7 @@ errno_t ext4_extent_append_block(ext4_inode_ref_t *inode_ref, uint32_t *iblock,
 				inode_ref->dirty = true;
 			}
 
-			path_ptr->block->dirty = true;
+			ext4_journal_dirty(inode_ref->fs, path_ptr->block);
 
 			goto finish;
 		}
@@ -1080,7 +1098,7 @@ append_extent:
 		inode_ref->dirty = true;
 	}
 
-	path_ptr->block->dirty = true;
+	ext4_journal_dirty(inode_ref->fs, path_ptr->block);
 
 finish:
 	rc2 = EOK;
@@ -1089,6 +1107,12 @@ finish:
 	*iblock = new_block_idx;
 	*fblock = phys_block;
 
+	/* Keep the cache in step with the tree */
+	if (rc == EOK) {
+		ext4_extent_cache_insert(&inode_ref->fs->extent_cache,
+		    inode_ref->index, new_block_idx, 1, phys_block);
+	}
+
 	/*
 	 * Put loaded blocks
 	 * starting from 1: 0 is a block with inode data
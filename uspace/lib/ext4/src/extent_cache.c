@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libext4
+ * @{
+ */
+/**
+ * @file  extent_cache.c
+ * @brief In-memory cache of resolved extents.
+ *
+ * Each cached i-node keeps the extents recently resolved from its extent
+ * tree in an ordered dictionary keyed by the first logical block, so that
+ * a logical block is mapped to a physical one in O(log n) without reading
+ * any index blocks. The cache only ever holds a subset of the on-disk
+ * mapping: paths changing the mapping either insert what they created or
+ * invalidate what they removed.
+ */
+
+#include <adt/hash.h>
+#include <adt/odict.h>
+#include <errno.h>
+#include <stdlib.h>
+#include "ext4/extent_cache.h"
+
+/** Maximum number of i-nodes with cached extents */
+#define EXT4_EXTENT_CACHE_INODES  128
+
+/** Maximum number of cached extents of one i-node */
+#define EXT4_EXTENT_CACHE_EXTENTS  64
+
+/** Cached extents of one i-node */
+typedef struct {
+	ht_link_t link;         /* Link in ext4_extent_cache_t.inodes */
+	link_t lru;             /* Link in ext4_extent_cache_t.lru */
+	uint32_t index;         /* Index of the i-node */
+	odict_t extents;        /* Cached extents by first logical block */
+} ext4_extent_cache_inode_t;
+
+/** Cached extent */
+typedef struct {
+	odlink_t link;          /* Link in ext4_extent_cache_inode_t.extents */
+	uint32_t iblock;        /* First logical block */
+	uint32_t count;         /* Number of blocks */
+	uint32_t fblock;        /* First physical block */
+} ext4_extent_cache_entry_t;
+
+static size_t ext4_extent_cache_key_hash(const void *key)
+{
+	const uint32_t *index = key;
+	return hash_mix(*index);
+}
+
+static size_t ext4_extent_cache_hash(const ht_link_t *item)
+{
+	ext4_extent_cache_inode_t *ci =
+	    hash_table_get_inst(item, ext4_extent_cache_inode_t, link);
+	return hash_mix(ci->index);
+}
+
+static bool ext4_extent_cache_key_equal(const void *key,
+    const ht_link_t *item)
+{
+	const uint32_t *index = key;
+	ext4_extent_cache_inode_t *ci =
+	    hash_table_get_inst(item, ext4_extent_cache_inode_t, link);
+	return ci->index == *index;
+}
+
+static const hash_table_ops_t ext4_extent_cache_ops = {
+	.hash = ext4_extent_cache_hash,
+	.key_hash = ext4_extent_cache_key_hash,
+	.key_equal = ext4_extent_cache_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static void *ext4_extent_cache_getkey(odlink_t *odlink)
+{
+	return &odict_get_instance(odlink, ext4_extent_cache_entry_t,
+	    link)->iblock;
+}
+
+static int ext4_extent_cache_cmp(void *a, void *b)
+{
+	uint32_t ia = *(uint32_t *) a;
+	uint32_t ib = *(uint32_t *) b;
+
+	if (ia < ib)
+		return -1;
+	if (ia > ib)
+		return 1;
+	return 0;
+}
+
+/** Initialize extent cache.
+ *
+ * @param cache Extent cache
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_extent_cache_init(ext4_extent_cache_t *cache)
+{
+	if (!hash_table_create(&cache->inodes, 0, 0, &ext4_extent_cache_ops))
+		return ENOMEM;
+
+	fibril_mutex_initialize(&cache->lock);
+	list_initialize(&cache->lru);
+	cache->inodes_count = 0;
+	return EOK;
+}
+
+/** Remove a cached extent.
+ *
+ * @param entry Extent to remove
+ *
+ */
+static void ext4_extent_cache_entry_remove(ext4_extent_cache_entry_t *entry)
+{
+	odict_remove(&entry->link);
+	free(entry);
+}
+
+/** Remove an i-node with all its cached extents.
+ *
+ * @param cache Extent cache
+ * @param ci    Cached i-node
+ *
+ */
+static void ext4_extent_cache_inode_remove(ext4_extent_cache_t *cache,
+    ext4_extent_cache_inode_t *ci)
+{
+	odlink_t *odlink;
+
+	while ((odlink = odict_first(&ci->extents)) != NULL) {
+		ext4_extent_cache_entry_remove(odict_get_instance(odlink,
+		    ext4_extent_cache_entry_t, link));
+	}
+
+	hash_table_remove_item(&cache->inodes, &ci->link);
+	list_remove(&ci->lru);
+	cache->inodes_count--;
+	free(ci);
+}
+
+/** Finalize extent cache.
+ *
+ * @param cache Extent cache
+ *
+ */
+void ext4_extent_cache_fini(ext4_extent_cache_t *cache)
+{
+	while (!list_empty(&cache->lru)) {
+		ext4_extent_cache_inode_remove(cache, list_get_instance(
+		    list_first(&cache->lru), ext4_extent_cache_inode_t, lru));
+	}
+
+	hash_table_destroy(&cache->inodes);
+}
+
+/** Find cached i-node and mark it as recently used.
+ *
+ * @param cache Extent cache
+ * @param index Index of the i-node
+ *
+ * @return Cached i-node or NULL if not cached
+ *
+ */
+static ext4_extent_cache_inode_t *ext4_extent_cache_inode_find(
+    ext4_extent_cache_t *cache, uint32_t index)
+{
+	ht_link_t *link = hash_table_find(&cache->inodes, &index);
+	if (link == NULL)
+		return NULL;
+
+	ext4_extent_cache_inode_t *ci =
+	    hash_table_get_inst(link, ext4_extent_cache_inode_t, link);
+
+	list_remove(&ci->lru);
+	list_append(&ci->lru, &cache->lru);
+	return ci;
+}
+
+/** Find the cached extent containing a logical block.
+ *
+ * @param ci     Cached i-node
+ * @param iblock Logical block
+ *
+ * @return Cached extent or NULL if the block is not cached
+ *
+ */
+static ext4_extent_cache_entry_t *ext4_extent_cache_entry_find(
+    ext4_extent_cache_inode_t *ci, uint32_t iblock)
+{
+	odlink_t *odlink = odict_find_leq(&ci->extents, &iblock, NULL);
+	if (odlink == NULL)
+		return NULL;
+
+	ext4_extent_cache_entry_t *entry =
+	    odict_get_instance(odlink, ext4_extent_cache_entry_t, link);
+	if (iblock - entry->iblock >= entry->count)
+		return NULL;
+
+	return entry;
+}
+
+/** Map logical block of an i-node using the cache.
+ *
+ * @param cache  Extent cache
+ * @param index  Index of the i-node
+ * @param iblock Logical block
+ * @param fblock Output value for physical block number
+ *
+ * @return True if the block was found in the cache
+ *
+ */
+bool ext4_extent_cache_lookup(ext4_extent_cache_t *cache, uint32_t index,
+    uint32_t iblock, uint32_t *fblock)
+{
+	bool found = false;
+
+	fibril_mutex_lock(&cache->lock);
+
+	ext4_extent_cache_inode_t *ci = ext4_extent_cache_inode_find(cache,
+	    index);
+	if (ci != NULL) {
+		ext4_extent_cache_entry_t *entry =
+		    ext4_extent_cache_entry_find(ci, iblock);
+		if (entry != NULL) {
+			*fblock = entry->fblock + (iblock - entry->iblock);
+			found = true;
+		}
+	}
+
+	fibril_mutex_unlock(&cache->lock);
+	return found;
+}
+
+/** Remove cached extents of an i-node overlapping a range of blocks.
+ *
+ * Partially overlapping extents are trimmed.
+ *
+ * @param ci     Cached i-node
+ * @param iblock First logical block of the range
+ * @param count  Number of blocks in the range
+ *
+ */
+static void ext4_extent_cache_remove_range(ext4_extent_cache_inode_t *ci,
+    uint32_t iblock, uint64_t count)
+{
+	uint64_t end = (uint64_t) iblock + count;
+	odlink_t *odlink = odict_find_leq(&ci->extents, &iblock, NULL);
+	if (odlink == NULL)
+		odlink = odict_first(&ci->extents);
+
+	while (odlink != NULL) {
+		ext4_extent_cache_entry_t *entry =
+		    odict_get_instance(odlink, ext4_extent_cache_entry_t, link);
+		odlink = odict_next(odlink, &ci->extents);
+
+		if (entry->iblock >= end)
+			break;
+
+		if (entry->iblock < iblock) {
+			/* Keep the part in front of the range */
+			if (entry->iblock + (uint64_t) entry->count > iblock)
+				entry->count = iblock - entry->iblock;
+			continue;
+		}
+
+		if (entry->iblock + (uint64_t) entry->count > end) {
+			/* Keep the part behind the range */
+			uint32_t skip = end - entry->iblock;
+			entry->iblock += skip;
+			entry->fblock += skip;
+			entry->count -= skip;
+			continue;
+		}
+
+		ext4_extent_cache_entry_remove(entry);
+	}
+}
+
+/** Insert a resolved extent into the cache.
+ *
+ * The extent is merged with cached neighbours it continues both logically
+ * and physically, so that appending block by block keeps a single entry.
+ *
+ * @param cache  Extent cache
+ * @param index  Index of the i-node
+ * @param iblock First logical block of the extent
+ * @param count  Number of blocks of the extent
+ * @param fblock First physical block of the extent
+ *
+ */
+void ext4_extent_cache_insert(ext4_extent_cache_t *cache, uint32_t index,
+    uint32_t iblock, uint32_t count, uint32_t fblock)
+{
+	if (count == 0)
+		return;
+
+	fibril_mutex_lock(&cache->lock);
+
+	ext4_extent_cache_inode_t *ci = ext4_extent_cache_inode_find(cache,
+	    index);
+	if (ci == NULL) {
+		if (cache->inodes_count >= EXT4_EXTENT_CACHE_INODES) {
+			ext4_extent_cache_inode_remove(cache, list_get_instance(
+			    list_first(&cache->lru), ext4_extent_cache_inode_t,
+			    lru));
+		}
+
+		ci = calloc(1, sizeof(ext4_extent_cache_inode_t));
+		if (ci == NULL)
+			goto out;
+
+		ci->index = index;
+		odict_initialize(&ci->extents, ext4_extent_cache_getkey,
+		    ext4_extent_cache_cmp);
+		hash_table_insert(&cache->inodes, &ci->link);
+		list_append(&ci->lru, &cache->lru);
+		cache->inodes_count++;
+	}
+
+	/* Drop stale extents in the way */
+	ext4_extent_cache_remove_range(ci, iblock, count);
+
+	/* Try to extend the preceding extent */
+	odlink_t *odlink = odict_find_lt(&ci->extents, &iblock, NULL);
+	if (odlink != NULL) {
+		ext4_extent_cache_entry_t *prev =
+		    odict_get_instance(odlink, ext4_extent_cache_entry_t, link);
+		if (prev->iblock + prev->count == iblock &&
+		    prev->fblock + prev->count == fblock &&
+		    (uint64_t) prev->count + count <= UINT32_MAX) {
+			prev->count += count;
+			goto out;
+		}
+	}
+
+	if (odict_count(&ci->extents) >= EXT4_EXTENT_CACHE_EXTENTS) {
+		/*
+		 * Evict the extent at the far end from the new one, keeping
+		 * those around the current position in the file.
+		 */
+		ext4_extent_cache_entry_t *first = odict_get_instance(
+		    odict_first(&ci->extents), ext4_extent_cache_entry_t, link);
+		ext4_extent_cache_entry_t *last = odict_get_instance(
+		    odict_last(&ci->extents), ext4_extent_cache_entry_t, link);
+
+		if ((int64_t) iblock - first->iblock >
+		    (int64_t) last->iblock - iblock)
+			ext4_extent_cache_entry_remove(first);
+		else
+			ext4_extent_cache_entry_remove(last);
+	}
+
+	ext4_extent_cache_entry_t *entry =
+	    malloc(sizeof(ext4_extent_cache_entry_t));
+	if (entry == NULL)
+		goto out;
+
+	entry->iblock = iblock;
+	entry->count = count;
+	entry->fblock = fblock;
+	odlink_initialize(&entry->link);
+	odict_insert(&entry->link, &ci->extents, NULL);
+
+out:
+	fibril_mutex_unlock(&cache->lock);
+}
+
+/** Invalidate cached extents of an i-node from a logical block on.
+ *
+ * @param cache       Extent cache
+ * @param index       Index of the i-node
+ * @param iblock_from First logical block to invalidate, 0 for all
+ *
+ */
+void ext4_extent_cache_invalidate(ext4_extent_cache_t *cache, uint32_t index,
+    uint32_t iblock_from)
+{
+	fibril_mutex_lock(&cache->lock);
+
+	ht_link_t *link = hash_table_find(&cache->inodes, &index);
+	if (link != NULL) {
+		ext4_extent_cache_inode_t *ci =
+		    hash_table_get_inst(link, ext4_extent_cache_inode_t, link);
+
+		if (iblock_from == 0) {
+			ext4_extent_cache_inode_remove(cache, ci);
+		} else {
+			ext4_extent_cache_remove_range(ci, iblock_from,
+			    (uint64_t) UINT32_MAX + 1 - iblock_from);
+		}
+	}
+
+	fibril_mutex_unlock(&cache->lock);
+}
+
+/**
+ * @}
+ */
@@ -48,11 +48,14 @@
 #include "ext4/bitmap.h"
 #include "ext4/block_group.h"
 #include "ext4/cfg.h"
+#include "ext4/dir_cache.h"
 #include "ext4/directory.h"
 #include "ext4/extent.h"
+#include "ext4/extent_cache.h"
 #include "ext4/filesystem.h"
 #include "ext4/ialloc.h"
 #include "ext4/inode.h"
+#include "ext4/journal.h"
 #include "ext4/ops.h"
 #include "ext4/superblock.h"
 
@@ -103,6 +106,17 @@ static errno_t ext4_filesystem_init(ext4_filesystem_t *fs, service_id_t service_
 	if (rc != EOK)
 		goto err_1;
 
+	rc = ext4_extent_cache_init(&fs->extent_cache);
+	if (rc != EOK)
+		goto err_2;
+
+	rc = ext4_dir_cache_init(&fs->dir_cache);
+	if (rc != EOK)
+		goto err_3;
+
+	fibril_mutex_initialize(&fs->alloc_lock);
+	ext4_balloc_prealloc_init(fs);
+
 	/* Compute limits for indirect block levels */
 	uint32_t block_ids_per_block = block_size / sizeof(uint32_t);
 	fs->inode_block_limits[0] = EXT4_INODE_DIRECT_BLOCK_COUNT;
@@ -119,25 +133,38 @@ static errno_t ext4_filesystem_init(ext4_filesystem_t *fs, service_id_t service_
 
 	uint16_t state = ext4_superblock_get_state(fs->superblock);
 
-	if (((state & EXT4_SUPERBLOCK_STATE_VALID_FS) !=
+	/*
+	 * A journaled file system which was not unmounted cleanly is
+	 * consistent again once the journal is replayed.
+	 */
+	bool recover = ext4_superblock_has_feature_compatible(fs->superblock,
+	    EXT4_FEATURE_COMPAT_HAS_JOURNAL) &&
+	    ext4_superblock_has_feature_incompatible(fs->superblock,
+	    EXT4_FEATURE_INCOMPAT_RECOVER);
+
+	if (!recover && (((state & EXT4_SUPERBLOCK_STATE_VALID_FS) !=
 	    EXT4_SUPERBLOCK_STATE_VALID_FS) ||
 	    ((state & EXT4_SUPERBLOCK_STATE_ERROR_FS) ==
-	    EXT4_SUPERBLOCK_STATE_ERROR_FS)) {
+	    EXT4_SUPERBLOCK_STATE_ERROR_FS))) {
 		rc = ENOTSUP;
-		goto err_2;
+		goto err_4;
 	}
 
 	rc = ext4_superblock_check_sanity(fs->superblock);
 	if (rc != EOK)
-		goto err_2;
+		goto err_4;
 
 	/* Check flags */
 	bool read_only;
 	rc = ext4_filesystem_check_features(fs, &read_only);
 	if (rc != EOK)
-		goto err_2;
+		goto err_4;
 
 	return EOK;
+err_4:
+	ext4_dir_cache_fini(&fs->dir_cache);
+err_3:
+	ext4_extent_cache_fini(&fs->extent_cache);
 err_2:
 	block_cache_fini(fs->device);
 err_1:
@@ -155,9 +182,18 @@ err:
  */
 static void ext4_filesystem_fini(ext4_filesystem_t *fs)
 {
+	/* Return reserved blocks before the bitmaps are written back */
+	(void) ext4_balloc_prealloc_discard_all(fs);
+
+	/* Release blocks of an uncommitted transaction */
+	ext4_journal_fini(fs);
+
 	/* Release memory space for superblock */
 	free(fs->superblock);
 
+	ext4_extent_cache_fini(&fs->extent_cache);
+	ext4_dir_cache_fini(&fs->dir_cache);
+
 	/* Finish work with block library */
 	block_cache_fini(fs->device);
 	block_fini(fs->device);
@@ -440,6 +476,11 @@ errno_t ext4_filesystem_open(ext4_instance_t *inst, service_id_t service_id,
 
 	fs_inited = 1;
 
+	/* Replay the journal if needed and start journaling */
+	rc = ext4_journal_open(fs);
+	if (rc != EOK)
+		goto error;
+
 	/* Read root node */
 	rc = ext4_node_get_core(&root_node, inst, EXT4_INODE_ROOT_INDEX);
 	if (rc != EOK)
@@ -481,9 +522,19 @@ error:
  */
 errno_t ext4_filesystem_close(ext4_filesystem_t *fs)
 {
+	/* Return reserved blocks so that the free counts are exact */
+	errno_t rc = ext4_balloc_prealloc_discard_all(fs);
+	if (rc != EOK)
+		return rc;
+
+	/* Commit and empty the journal */
+	rc = ext4_journal_close(fs);
+	if (rc != EOK)
+		return rc;
+
 	/* Write the superblock to the device */
 	ext4_superblock_set_state(fs->superblock, EXT4_SUPERBLOCK_STATE_VALID_FS);
-	errno_t rc = ext4_superblock_write_direct(fs->device, fs->superblock);
+	rc = ext4_superblock_write_direct(fs->device, fs->superblock);
 	if (rc != EOK)
 		return rc;
 
@@ -521,6 +572,12 @@ static errno_t ext4_filesystem_check_features(ext4_filesystem_t *fs,
 	incompatible_features =
 	    ext4_superblock_get_features_incompatible(fs->superblock);
 	incompatible_features &= ~EXT4_FEATURE_INCOMPAT_SUPP;
+
+	/* Recovery is done by replaying the journal */
+	if (ext4_superblock_has_feature_compatible(fs->superblock,
+	    EXT4_FEATURE_COMPAT_HAS_JOURNAL))
+		incompatible_features &= ~EXT4_FEATURE_INCOMPAT_RECOVER;
+
 	if (incompatible_features > 0)
 		return ENOTSUP;
 
@@ -800,7 +857,7 @@ static errno_t ext4_filesystem_init_block_bitmap(ext4_block_group_ref_t *bg_ref)
 		ext4_bitmap_set_bit(bitmap, block);
 	}
 
-	bitmap_block->dirty = true;
+	ext4_journal_dirty(bg_ref->fs, bitmap_block);
 
 	/* Save bitmap */
 	return block_put(bitmap_block);
@@ -843,7 +900,7 @@ static errno_t ext4_filesystem_init_inode_bitmap(ext4_block_group_ref_t *bg_ref)
 	if (i < end_bit)
 		memset(bitmap + (i >> 3), 0xff, (end_bit - i) >> 3);
 
-	bitmap_block->dirty = true;
+	ext4_journal_dirty(bg_ref->fs, bitmap_block);
 
 	/* Save bitmap */
 	return block_put(bitmap_block);
@@ -1097,7 +1154,7 @@ errno_t ext4_filesystem_put_block_group_ref(ext4_block_group_ref_t *ref)
 		ext4_block_group_set_checksum(ref->block_group, checksum);
 
 		/* Mark block dirty for writing changes to physical device */
-		ref->block->dirty = true;
+		ext4_journal_dirty(ref->fs, ref->block);
 	}
 
 	/* Put back block, that contains block group descriptor */
@@ -1196,7 +1253,7 @@ errno_t ext4_filesystem_put_inode_ref(ext4_inode_ref_t *ref)
 	/* Check if reference modified */
 	if (ref->dirty) {
 		/* Mark block dirty for writing changes to physical device */
-		ref->block->dirty = true;
+		ext4_journal_dirty(ref->fs, ref->block);
 	}
 
 	/* Put back block, that contains i-node */
@@ -1370,6 +1427,14 @@ errno_t ext4_filesystem_free_inode(ext4_inode_ref_t *inode_ref)
 {
 	ext4_filesystem_t *fs = inode_ref->fs;
 
+	/* The index may be reused by another i-node */
+	ext4_extent_cache_invalidate(&fs->extent_cache, inode_ref->index, 0);
+	ext4_dir_cache_invalidate(&fs->dir_cache, inode_ref->index);
+
+	errno_t rc = ext4_balloc_prealloc_discard(fs, inode_ref->index);
+	if (rc != EOK)
+		return rc;
+
 	/* For extents must be data block destroyed by other way */
 	if ((ext4_superblock_has_feature_incompatible(fs->superblock,
 	    EXT4_FEATURE_INCOMPAT_EXTENTS)) &&
@@ -1383,7 +1448,7 @@ errno_t ext4_filesystem_free_inode(ext4_inode_ref_t *inode_ref)
 	/* 1) Single indirect */
 	uint32_t fblock = ext4_inode_get_indirect_block(inode_ref->inode, 0);
 	if (fblock != 0) {
-		errno_t rc = ext4_balloc_free_block(inode_ref, fblock);
+		rc = ext4_balloc_free_block(inode_ref, fblock);
 		if (rc != EOK)
 			return rc;
 
@@ -1397,7 +1462,7 @@ errno_t ext4_filesystem_free_inode(ext4_inode_ref_t *inode_ref)
 	/* 2) Double indirect */
 	fblock = ext4_inode_get_indirect_block(inode_ref->inode, 1);
 	if (fblock != 0) {
-		errno_t rc = block_get(&block, fs->device, fblock, BLOCK_FLAGS_NONE);
+		rc = block_get(&block, fs->device, fblock, BLOCK_FLAGS_NONE);
 		if (rc != EOK)
 			return rc;
 
@@ -1429,7 +1494,7 @@ errno_t ext4_filesystem_free_inode(ext4_inode_ref_t *inode_ref)
 	block_t *subblock;
 	fblock = ext4_inode_get_indirect_block(inode_ref->inode, 2);
 	if (fblock != 0) {
-		errno_t rc = block_get(&block, fs->device, fblock, BLOCK_FLAGS_NONE);
+		rc = block_get(&block, fs->device, fblock, BLOCK_FLAGS_NONE);
 		if (rc != EOK)
 			return rc;
 
@@ -1494,7 +1559,7 @@ finish:
 	uint32_t xattr_block = ext4_inode_get_file_acl(
 	    inode_ref->inode, fs->superblock);
 	if (xattr_block) {
-		errno_t rc = ext4_balloc_free_block(inode_ref, xattr_block);
+		rc = ext4_balloc_free_block(inode_ref, xattr_block);
 		if (rc != EOK)
 			return rc;
 
@@ -1502,7 +1567,6 @@ finish:
 	}
 
 	/* Free inode by allocator */
-	errno_t rc;
 	if (ext4_inode_is_type(fs->superblock, inode_ref->inode,
 	    EXT4_INODE_MODE_DIRECTORY))
 		rc = ext4_ialloc_free_inode(fs, inode_ref->index, true);
@@ -1538,6 +1602,12 @@ errno_t ext4_filesystem_truncate_inode(ext4_inode_ref_t *inode_ref,
 	if (old_size < new_size)
 		return EINVAL;
 
+	/* Blocks reserved beyond the old end are not needed any more */
+	errno_t rc = ext4_balloc_prealloc_discard(inode_ref->fs,
+	    inode_ref->index);
+	if (rc != EOK)
+		return rc;
+
 	/* Compute how many blocks will be released */
 	aoff64_t size_diff = old_size - new_size;
 	uint32_t block_size  = ext4_superblock_get_block_size(sb);
@@ -1553,7 +1623,7 @@ errno_t ext4_filesystem_truncate_inode(ext4_inode_ref_t *inode_ref,
 	    EXT4_FEATURE_INCOMPAT_EXTENTS)) &&
 	    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS))) {
 		/* Extents require special operation */
-		errno_t rc = ext4_extent_release_blocks_from(inode_ref,
+		rc = ext4_extent_release_blocks_from(inode_ref,
 		    old_blocks_count - diff_blocks_count);
 		if (rc != EOK)
 			return rc;
@@ -1562,7 +1632,7 @@ errno_t ext4_filesystem_truncate_inode(ext4_inode_ref_t *inode_ref,
 
 		/* Starting from 1 because of logical blocks are numbered from 0 */
 		for (uint32_t i = 1; i <= diff_blocks_count; ++i) {
-			errno_t rc = ext4_filesystem_release_inode_block(inode_ref,
+			rc = ext4_filesystem_release_inode_block(inode_ref,
 			    old_blocks_count - i);
 			if (rc != EOK)
 				return rc;
@@ -1767,7 +1837,7 @@ errno_t ext4_filesystem_set_inode_data_block_index(ext4_inode_ref_t *inode_ref,
 
 		/* Initialize new block */
 		memset(new_block->data, 0, block_size);
-		new_block->dirty = true;
+		ext4_journal_dirty(fs, new_block);
 
 		/* Put back the allocated block */
 		rc = block_put(new_block);
@@ -1807,7 +1877,7 @@ errno_t ext4_filesystem_set_inode_data_block_index(ext4_inode_ref_t *inode_ref,
 
 			/* Initialize allocated block */
 			memset(new_block->data, 0, block_size);
-			new_block->dirty = true;
+			ext4_journal_dirty(fs, new_block);
 
 			rc = block_put(new_block);
 			if (rc != EOK) {
@@ -1818,7 +1888,7 @@ errno_t ext4_filesystem_set_inode_data_block_index(ext4_inode_ref_t *inode_ref,
 			/* Write block address to the parent */
 			((uint32_t *) block->data)[offset_in_block] =
 			    host2uint32_t_le(new_block_addr);
-			block->dirty = true;
+			ext4_journal_dirty(fs, block);
 			current_block = new_block_addr;
 		}
 
@@ -1826,7 +1896,7 @@ errno_t ext4_filesystem_set_inode_data_block_index(ext4_inode_ref_t *inode_ref,
 		if (level == 1) {
 			((uint32_t *) block->data)[offset_in_block] =
 			    host2uint32_t_le(fblock);
-			block->dirty = true;
+			ext4_journal_dirty(fs, block);
 		}
 
 		rc = block_put(block);
@@ -1927,7 +1997,7 @@ errno_t ext4_filesystem_release_inode_block(ext4_inode_ref_t *inode_ref,
 		if (level == 1) {
 			((uint32_t *) block->data)[offset_in_block] =
 			    host2uint32_t_le(0);
-			block->dirty = true;
+			ext4_journal_dirty(fs, block);
 		}
 
 		rc = block_put(block);
@@ -32,16 +32,264 @@
 /**
  * @file  hash.c
  * @brief Hashing algorithms for ext4 HTree.
+ *
+ * The hash functions must produce exactly the values of the Linux driver,
+ * otherwise the names would be looked up in other leaves of the index than
+ * where they were inserted.
  */
 
+#include <byteorder.h>
 #include <errno.h>
+#include <stdbool.h>
 #include "ext4/hash.h"
 
+/** Largest hash value with the lowest bit cleared, reserved for end of index */
+#define EXT4_HASH_EOF  0xfffffffe
+
+/** Legacy hash function.
+ *
+ * @param name           Name to compute hash value from
+ * @param len            Length of the name
+ * @param unsigned_chars Treat the characters as unsigned
+ *
+ * @return Hash value
+ *
+ */
+static uint32_t ext4_hash_legacy(const char *name, int len,
+    bool unsigned_chars)
+{
+	uint32_t hash0 = 0x12a3fe2d;
+	uint32_t hash1 = 0x37abe8f9;
+
+	for (int i = 0; i < len; i++) {
+		uint32_t c;
+		if (unsigned_chars)
+			c = (uint8_t) name[i];
+		else
+			c = (int32_t) (int8_t) name[i];
+
+		uint32_t hash = hash1 + (hash0 ^ (c * 7152373));
+		if (hash & 0x80000000)
+			hash -= 0x7fffffff;
+
+		hash1 = hash0;
+		hash0 = hash;
+	}
+
+	return hash0 << 1;
+}
+
+/** Pack a part of the name into the input words of a transformation.
+ *
+ * Words not covered by the name are filled with padding derived from
+ * the length of the rest of the name.
+ *
+ * @param name           Rest of the name
+ * @param len            Length of the rest of the name
+ * @param buf            Output words
+ * @param num            Number of output words
+ * @param unsigned_chars Treat the characters as unsigned
+ *
+ */
+static void ext4_hash_str2buf(const char *name, int len, uint32_t *buf,
+    int num, bool unsigned_chars)
+{
+	uint32_t pad = (uint32_t) len | ((uint32_t) len << 8);
+	pad |= pad << 16;
+
+	uint32_t val = pad;
+	if (len > num * 4)
+		len = num * 4;
+
+	for (int i = 0; i < len; i++) {
+		uint32_t c;
+		if (unsigned_chars)
+			c = (uint8_t) name[i];
+		else
+			c = (int32_t) (int8_t) name[i];
+
+		val = c + (val << 8);
+		if ((i % 4) == 3) {
+			*buf++ = val;
+			val = pad;
+			num--;
+		}
+	}
+
+	if (--num >= 0)
+		*buf++ = val;
+
+	while (--num >= 0)
+		*buf++ = pad;
+}
+
+/** Rotate 32-bit value to the left. */
+static inline uint32_t ext4_hash_rol(uint32_t x, int s)
+{
+	return (x << s) | (x >> (32 - s));
+}
+
+#define EXT4_HASH_F(x, y, z)  ((z) ^ ((x) & ((y) ^ (z))))
+#define EXT4_HASH_G(x, y, z)  (((x) & (y)) + (((x) ^ (y)) & (z)))
+#define EXT4_HASH_H(x, y, z)  ((x) ^ (y) ^ (z))
+
+#define EXT4_HASH_ROUND(f, a, b, c, d, x, s) \
+	((a) = ext4_hash_rol((a) + f((b), (c), (d)) + (x), (s)))
+
+#define EXT4_HASH_K2  0x5a827999
+#define EXT4_HASH_K3  0x6ed9eba1
+
+/** Half MD4 transformation of eight input words.
+ *
+ * @param buf State of the hash
+ * @param in  Input words
+ *
+ */
+static void ext4_hash_half_md4_transform(uint32_t buf[4],
+    const uint32_t in[8])
+{
+	uint32_t a = buf[0];
+	uint32_t b = buf[1];
+	uint32_t c = buf[2];
+	uint32_t d = buf[3];
+
+	/* Round 1 */
+	EXT4_HASH_ROUND(EXT4_HASH_F, a, b, c, d, in[0], 3);
+	EXT4_HASH_ROUND(EXT4_HASH_F, d, a, b, c, in[1], 7);
+	EXT4_HASH_ROUND(EXT4_HASH_F, c, d, a, b, in[2], 11);
+	EXT4_HASH_ROUND(EXT4_HASH_F, b, c, d, a, in[3], 19);
+	EXT4_HASH_ROUND(EXT4_HASH_F, a, b, c, d, in[4], 3);
+	EXT4_HASH_ROUND(EXT4_HASH_F, d, a, b, c, in[5], 7);
+	EXT4_HASH_ROUND(EXT4_HASH_F, c, d, a, b, in[6], 11);
+	EXT4_HASH_ROUND(EXT4_HASH_F, b, c, d, a, in[7], 19);
+
+	/* Round 2 */
+	EXT4_HASH_ROUND(EXT4_HASH_G, a, b, c, d, in[1] + EXT4_HASH_K2, 3);
+	EXT4_HASH_ROUND(EXT4_HASH_G, d, a, b, c, in[3] + EXT4_HASH_K2, 5);
+	EXT4_HASH_ROUND(EXT4_HASH_G, c, d, a, b, in[5] + EXT4_HASH_K2, 9);
+	EXT4_HASH_ROUND(EXT4_HASH_G, b, c, d, a, in[7] + EXT4_HASH_K2, 13);
+	EXT4_HASH_ROUND(EXT4_HASH_G, a, b, c, d, in[0] + EXT4_HASH_K2, 3);
+	EXT4_HASH_ROUND(EXT4_HASH_G, d, a, b, c, in[2] + EXT4_HASH_K2, 5);
+	EXT4_HASH_ROUND(EXT4_HASH_G, c, d, a, b, in[4] + EXT4_HASH_K2, 9);
+	EXT4_HASH_ROUND(EXT4_HASH_G, b, c, d, a, in[6] + EXT4_HASH_K2, 13);
+
+	/* Round 3 */
+	EXT4_HASH_ROUND(EXT4_HASH_H, a, b, c, d, in[3] + EXT4_HASH_K3, 3);
+	EXT4_HASH_ROUND(EXT4_HASH_H, d, a, b, c, in[7] + EXT4_HASH_K3, 9);
+	EXT4_HASH_ROUND(EXT4_HASH_H, c, d, a, b, in[2] + EXT4_HASH_K3, 11);
+	EXT4_HASH_ROUND(EXT4_HASH_H, b, c, d, a, in[6] + EXT4_HASH_K3, 15);
+	EXT4_HASH_ROUND(EXT4_HASH_H, a, b, c, d, in[1] + EXT4_HASH_K3, 3);
+	EXT4_HASH_ROUND(EXT4_HASH_H, d, a, b, c, in[5] + EXT4_HASH_K3, 9);
+	EXT4_HASH_ROUND(EXT4_HASH_H, c, d, a, b, in[0] + EXT4_HASH_K3, 11);
+	EXT4_HASH_ROUND(EXT4_HASH_H, b, c, d, a, in[4] + EXT4_HASH_K3, 15);
+
+	buf[0] += a;
+	buf[1] += b;
+	buf[2] += c;
+	buf[3] += d;
+}
+
+/** TEA transformation of four input words.
+ *
+ * @param buf State of the hash
+ * @param in  Input words
+ *
+ */
+static void ext4_hash_tea_transform(uint32_t buf[4], const uint32_t in[4])
+{
+	uint32_t sum = 0;
+	uint32_t b0 = buf[0];
+	uint32_t b1 = buf[1];
+
+	for (int n = 0; n < 16; n++) {
+		sum += 0x9e3779b9;
+		b0 += ((b1 << 4) + in[0]) ^ (b1 + sum) ^ ((b1 >> 5) + in[1]);
+		b1 += ((b0 << 4) + in[2]) ^ (b0 + sum) ^ ((b0 >> 5) + in[3]);
+	}
+
+	buf[0] += b0;
+	buf[1] += b1;
+}
+
+/** Compute hash value of a name.
+ *
+ * @param hinfo Hash info with hash version and seed, the major and minor
+ *              hash value are stored there
+ * @param len   Length of the name
+ * @param name  Name to compute hash value from
+ *
+ * @return Error code
+ *
+ */
 errno_t ext4_hash_string(ext4_hash_info_t *hinfo, int len, const char *name)
 {
-	// TODO
-	hinfo->hash = 0;
-	return ENOTSUP;
+	uint32_t buf[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+	uint32_t in[8];
+	uint32_t hash = 0;
+	uint32_t minor_hash = 0;
+	bool unsigned_chars = false;
+
+	/* Seed of zeroes means the default one */
+	if (hinfo->seed != NULL) {
+		bool zero = true;
+		for (int i = 0; i < 4; i++) {
+			if (hinfo->seed[i] != 0)
+				zero = false;
+		}
+
+		if (!zero) {
+			for (int i = 0; i < 4; i++)
+				buf[i] = uint32_t_le2host(hinfo->seed[i]);
+		}
+	}
+
+	switch (hinfo->hash_version) {
+	case EXT4_HASH_VERSION_LEGACY_UNSIGNED:
+		unsigned_chars = true;
+		/* Fallthrough */
+	case EXT4_HASH_VERSION_LEGACY:
+		hash = ext4_hash_legacy(name, len, unsigned_chars);
+		break;
+	case EXT4_HASH_VERSION_HALF_MD4_UNSIGNED:
+		unsigned_chars = true;
+		/* Fallthrough */
+	case EXT4_HASH_VERSION_HALF_MD4:
+		for (int i = 0; i < len; i += 32) {
+			ext4_hash_str2buf(name + i, len - i, in, 8,
+			    unsigned_chars);
+			ext4_hash_half_md4_transform(buf, in);
+		}
+
+		hash = buf[1];
+		minor_hash = buf[2];
+		break;
+	case EXT4_HASH_VERSION_TEA_UNSIGNED:
+		unsigned_chars = true;
+		/* Fallthrough */
+	case EXT4_HASH_VERSION_TEA:
+		for (int i = 0; i < len; i += 16) {
+			ext4_hash_str2buf(name + i, len - i, in, 4,
+			    unsigned_chars);
+			ext4_hash_tea_transform(buf, in);
+		}
+
+		hash = buf[0];
+		minor_hash = buf[1];
+		break;
+	default:
+		hinfo->hash = 0;
+		return ENOTSUP;
+	}
+
+	/* The lowest bit marks continued collision chains in the index */
+	hash &= ~1;
+	if (hash == EXT4_HASH_EOF)
+		hash = EXT4_HASH_EOF - 2;
+
+	hinfo->hash = hash;
+	hinfo->minor_hash = minor_hash;
+
+	return EOK;
 }
 
 /**
@@ -36,11 +36,13 @@
  */
 
 #include <errno.h>
+#include <fibril_synch.h>
 #include <stdbool.h>
 #include "ext4/bitmap.h"
 #include "ext4/block_group.h"
 #include "ext4/filesystem.h"
 #include "ext4/ialloc.h"
+#include "ext4/journal.h"
 #include "ext4/superblock.h"
 
 /** Convert i-node number to relative index in block group.
@@ -88,14 +90,15 @@ static uint32_t ext4_ialloc_get_bgid_of_inode(ext4_superblock_t *sb,
 	return (inode - 1) / inodes_per_group;
 }
 
-/** Free i-node number and modify filesystem data structers.
+/** Free i-node number with the allocation lock held.
  *
  * @param fs     Filesystem, where the i-node is located
  * @param index  Index of i-node to be release
  * @param is_dir Flag us for information whether i-node is directory or not
  *
  */
-errno_t ext4_ialloc_free_inode(ext4_filesystem_t *fs, uint32_t index, bool is_dir)
+static errno_t ext4_ialloc_free_inode_locked(ext4_filesystem_t *fs,
+    uint32_t index, bool is_dir)
 {
 	ext4_superblock_t *sb = fs->superblock;
 
@@ -119,7 +122,7 @@ errno_t ext4_ialloc_free_inode(ext4_filesystem_t *fs, uint32_t index, bool is_di
 	/* Free i-node in the bitmap */
 	uint32_t index_in_group = ext4_ialloc_inode2index_in_group(sb, index);
 	ext4_bitmap_free_bit(bitmap_block->data, index_in_group);
-	bitmap_block->dirty = true;
+	ext4_journal_dirty(fs, bitmap_block);
 
 	/* Put back the block with bitmap */
 	rc = block_put(bitmap_block);
@@ -161,10 +164,23 @@ errno_t ext4_ialloc_free_inode(ext4_filesystem_t *fs, uint32_t index, bool is_di
 	return EOK;
 }
 
-/** I-node allocation algorithm.
+/** Free i-node number and modify filesystem data structers.
  *
- * This is more simple algorithm, than Orlov allocator used
- * in the Linux kernel.
+ * @param fs     Filesystem, where the i-node is located
+ * @param index  Index of i-node to be release
+ * @param is_dir Flag us for information whether i-node is directory or not
+ *
+ */
+errno_t ext4_ialloc_free_inode(ext4_filesystem_t *fs, uint32_t index, bool is_dir)
+{
+	fibril_mutex_lock(&fs->alloc_lock);
+	errno_t rc = ext4_ialloc_free_inode_locked(fs, index, is_dir);
+	fibril_mutex_unlock(&fs->alloc_lock);
+
+	return rc;
+}
+
+/** I-node allocation algorithm with the allocation lock held.
  *
  * @param fs     Filesystem to allocate i-node on
  * @param index  Output value - allocated i-node number
@@ -173,7 +189,8 @@ errno_t ext4_ialloc_free_inode(ext4_filesystem_t *fs, uint32_t index, bool is_di
  * @return Error code
  *
  */
-errno_t ext4_ialloc_alloc_inode(ext4_filesystem_t *fs, uint32_t *index, bool is_dir)
+static errno_t ext4_ialloc_alloc_inode_locked(ext4_filesystem_t *fs,
+    uint32_t *index, bool is_dir)
 {
 	int pick_first_free = 0;
 	ext4_superblock_t *sb = fs->superblock;
@@ -252,7 +269,7 @@ retry:
 			}
 
 			/* Free i-node found, save the bitmap */
-			bitmap_block->dirty = true;
+			ext4_journal_dirty(fs, bitmap_block);
 
 			rc = block_put(bitmap_block);
 			if (rc != EOK) {
@@ -321,7 +338,28 @@ retry:
 	return ENOSPC;
 }
 
-/** Allocate a specific I-node.
+/** I-node allocation algorithm.
+ *
+ * This is more simple algorithm, than Orlov allocator used
+ * in the Linux kernel.
+ *
+ * @param fs     Filesystem to allocate i-node on
+ * @param index  Output value - allocated i-node number
+ * @param is_dir Flag if allocated i-node will be file or directory
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_ialloc_alloc_inode(ext4_filesystem_t *fs, uint32_t *index, bool is_dir)
+{
+	fibril_mutex_lock(&fs->alloc_lock);
+	errno_t rc = ext4_ialloc_alloc_inode_locked(fs, index, is_dir);
+	fibril_mutex_unlock(&fs->alloc_lock);
+
+	return rc;
+}
+
+/** Allocate a specific I-node with the allocation lock held.
  *
  * @param fs     Filesystem to allocate i-node on
  * @param inode  I-node to allocate
@@ -330,8 +368,8 @@ retry:
  * @return Error code
  *
  */
-errno_t ext4_ialloc_alloc_this_inode(ext4_filesystem_t *fs, uint32_t inode,
-    bool is_dir)
+static errno_t ext4_ialloc_alloc_this_inode_locked(ext4_filesystem_t *fs,
+    uint32_t inode, bool is_dir)
 {
 	ext4_superblock_t *sb = fs->superblock;
 
@@ -367,7 +405,7 @@ errno_t ext4_ialloc_alloc_this_inode(ext4_filesystem_t *fs, uint32_t inode,
 	ext4_bitmap_set_bit(bitmap_block->data, index_in_group);
 
 	/* Save the bitmap */
-	bitmap_block->dirty = true;
+	ext4_journal_dirty(fs, bitmap_block);
 
 	rc = block_put(bitmap_block);
 	if (rc != EOK) {
@@ -416,6 +454,25 @@ errno_t ext4_ialloc_alloc_this_inode(ext4_filesystem_t *fs, uint32_t inode,
 	return EOK;
 }
 
+/** Allocate a specific I-node.
+ *
+ * @param fs     Filesystem to allocate i-node on
+ * @param inode  I-node to allocate
+ * @param is_dir Flag if allocated i-node will be file or directory
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_ialloc_alloc_this_inode(ext4_filesystem_t *fs, uint32_t inode,
+    bool is_dir)
+{
+	fibril_mutex_lock(&fs->alloc_lock);
+	errno_t rc = ext4_ialloc_alloc_this_inode_locked(fs, inode, is_dir);
+	fibril_mutex_unlock(&fs->alloc_lock);
+
+	return rc;
+}
+
 /**
  * @}
  */
@@ -0,0 +1,1588 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libext4
+ * @{
+ */
+/**
+ * @file  journal.c
+ * @brief JBD2 journal of metadata blocks.
+ *
+ * Metadata blocks modified by file system operations are added to the
+ * running transaction, which holds a reference to each of them so that the
+ * block cache does not write them in place. The updates of many operations
+ * are batched in one transaction, which is committed by writing copies of
+ * its blocks to the log sequentially, followed by a commit block. This
+ * happens when the transaction grows large, on sync and at the latest
+ * every EXT4_JOURNAL_COMMIT_INTERVAL. Only then are the blocks released to
+ * the block cache, which may write them back whenever it likes.
+ *
+ * When the log is half full, all blocks logged so far are written in place
+ * and the log is emptied (checkpoint). After a crash, the committed
+ * transactions are replayed from the log on mount.
+ *
+ * File data is not journaled, which corresponds to data=writeback mode
+ * of Linux. Journals with checksums are not supported, file systems with
+ * such journals are used without journaling.
+ */
+
+#include <adt/hash.h>
+#include <assert.h>
+#include <byteorder.h>
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdlib.h>
+#include "ext4/filesystem.h"
+#include "ext4/inode.h"
+#include "ext4/journal.h"
+#include "ext4/superblock.h"
+
+/** Interval of committing the running transaction (microseconds) */
+#define EXT4_JOURNAL_COMMIT_INTERVAL  5000000
+
+/** Number of blocks of a transaction which makes it commit */
+#define EXT4_JOURNAL_MAX_BLOCKS  1024
+
+/** Minimum number of blocks of the log */
+#define EXT4_JOURNAL_MIN_BLOCKS  64
+
+/** Size of the UUID following the first tag of a descriptor block */
+#define EXT4_JOURNAL_UUID_SIZE  16
+
+/** Block of the running transaction */
+typedef struct {
+	ht_link_t link;         /* Link in ext4_journal_t.buffers */
+	block_t *block;         /* Reference held until commit */
+} ext4_journal_buffer_t;
+
+/** Block number recorded by the journal */
+typedef struct {
+	ht_link_t link;
+	uint64_t block;         /* Block number on the file system */
+	uint32_t sequence;      /* Transaction revoking the block */
+} ext4_journal_record_t;
+
+/** Passes over the log during recovery */
+typedef enum {
+	EXT4_JOURNAL_PASS_SCAN,         /* Find the last committed transaction */
+	EXT4_JOURNAL_PASS_REVOKE,       /* Collect the revoked blocks */
+	EXT4_JOURNAL_PASS_REPLAY        /* Write the logged blocks in place */
+} ext4_journal_pass_t;
+
+/** State of the checkpoint of the logged blocks */
+typedef struct {
+	ext4_journal_t *journal;
+	errno_t rc;
+} ext4_journal_checkpoint_t;
+
+static errno_t ext4_journal_commit_locked(ext4_journal_t *, bool);
+
+static size_t ext4_journal_block_key_hash(const void *key)
+{
+	const uint64_t *block = key;
+	return hash_mix64(*block);
+}
+
+static size_t ext4_journal_buffer_hash(const ht_link_t *item)
+{
+	ext4_journal_buffer_t *buffer =
+	    hash_table_get_inst(item, ext4_journal_buffer_t, link);
+	return hash_mix64(buffer->block->lba);
+}
+
+static bool ext4_journal_buffer_key_equal(const void *key,
+    const ht_link_t *item)
+{
+	const uint64_t *block = key;
+	ext4_journal_buffer_t *buffer =
+	    hash_table_get_inst(item, ext4_journal_buffer_t, link);
+	return buffer->block->lba == *block;
+}
+
+static void ext4_journal_buffer_remove(ht_link_t *item)
+{
+	ext4_journal_buffer_t *buffer =
+	    hash_table_get_inst(item, ext4_journal_buffer_t, link);
+
+	/* Let the block cache write the block back */
+	(void) block_put(buffer->block);
+	free(buffer);
+}
+
+static const hash_table_ops_t ext4_journal_buffer_ops = {
+	.hash = ext4_journal_buffer_hash,
+	.key_hash = ext4_journal_block_key_hash,
+	.key_equal = ext4_journal_buffer_key_equal,
+	.equal = NULL,
+	.remove_callback = ext4_journal_buffer_remove
+};
+
+static size_t ext4_journal_record_hash(const ht_link_t *item)
+{
+	ext4_journal_record_t *record =
+	    hash_table_get_inst(item, ext4_journal_record_t, link);
+	return hash_mix64(record->block);
+}
+
+static bool ext4_journal_record_key_equal(const void *key,
+    const ht_link_t *item)
+{
+	const uint64_t *block = key;
+	ext4_journal_record_t *record =
+	    hash_table_get_inst(item, ext4_journal_record_t, link);
+	return record->block == *block;
+}
+
+static void ext4_journal_record_remove(ht_link_t *item)
+{
+	free(hash_table_get_inst(item, ext4_journal_record_t, link));
+}
+
+static const hash_table_ops_t ext4_journal_record_ops = {
+	.hash = ext4_journal_record_hash,
+	.key_hash = ext4_journal_block_key_hash,
+	.key_equal = ext4_journal_record_key_equal,
+	.equal = NULL,
+	.remove_callback = ext4_journal_record_remove
+};
+
+/** Check whether block numbers in the log have 64 bits.
+ *
+ * @param journal Journal
+ *
+ * @return True with 64-bit block numbers
+ *
+ */
+static bool ext4_journal_is_64bit(ext4_journal_t *journal)
+{
+	return (journal->features_incompatible &
+	    EXT4_JOURNAL_FEATURE_INCOMPAT_64BIT) != 0;
+}
+
+/** Get size of a tag in a descriptor block.
+ *
+ * @param journal Journal
+ *
+ * @return Size of the tag in bytes
+ *
+ */
+static size_t ext4_journal_tag_size(ext4_journal_t *journal)
+{
+	if (ext4_journal_is_64bit(journal))
+		return sizeof(ext4_journal_block_tag_t);
+
+	return sizeof(ext4_journal_block_tag_t) - sizeof(uint32_t);
+}
+
+/** Get size of a record in a revocation block.
+ *
+ * @param journal Journal
+ *
+ * @return Size of the record in bytes
+ *
+ */
+static size_t ext4_journal_record_size(ext4_journal_t *journal)
+{
+	return ext4_journal_is_64bit(journal) ? sizeof(uint64_t) :
+	    sizeof(uint32_t);
+}
+
+/** Compare transaction IDs, which may wrap around.
+ *
+ * @param a First transaction ID
+ * @param b Second transaction ID
+ *
+ * @return True if a is later than b
+ *
+ */
+static bool ext4_journal_sequence_after(uint32_t a, uint32_t b)
+{
+	return (int32_t) (a - b) > 0;
+}
+
+/** Get the block following a block of the log.
+ *
+ * @param journal Journal
+ * @param iblock  Block of the log
+ * @param count   Number of blocks to advance
+ *
+ * @return Block of the log count blocks after iblock
+ *
+ */
+static uint32_t ext4_journal_advance(ext4_journal_t *journal, uint32_t iblock,
+    uint32_t count)
+{
+	iblock += count;
+	if (iblock >= journal->maxlen)
+		iblock -= journal->maxlen - journal->first;
+
+	return iblock;
+}
+
+/** Get number of blocks of the log which can be written.
+ *
+ * One block is kept free so that a full log can be told from an empty
+ * one.
+ *
+ * @param journal Journal
+ *
+ * @return Number of free blocks
+ *
+ */
+static uint32_t ext4_journal_free(ext4_journal_t *journal)
+{
+	uint32_t len = journal->maxlen - journal->first;
+
+	if (journal->tail == 0)
+		return len - 1;
+
+	uint32_t used = (journal->head + len - journal->tail) % len;
+	return len - used - 1;
+}
+
+/** Read or write consecutive blocks of the journal.
+ *
+ * @param journal Journal
+ * @param iblock  First block of the journal
+ * @param count   Number of blocks
+ * @param buf     Buffer for the blocks
+ * @param write   True to write the blocks, false to read them
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_io(ext4_journal_t *journal, uint32_t iblock,
+    uint32_t count, void *buf, bool write)
+{
+	service_id_t device = journal->fs->device;
+	uint8_t *data = buf;
+
+	while (count > 0) {
+		/* Find the run containing the block */
+		size_t lo = 0;
+		size_t hi = journal->runs_count;
+		ext4_journal_run_t *run = NULL;
+
+		while (lo < hi) {
+			size_t mid = (lo + hi) / 2;
+
+			if (iblock < journal->runs[mid].iblock) {
+				hi = mid;
+			} else if (iblock >= journal->runs[mid].iblock +
+			    journal->runs[mid].count) {
+				lo = mid + 1;
+			} else {
+				run = &journal->runs[mid];
+				break;
+			}
+		}
+
+		if (run == NULL)
+			return EIO;
+
+		uint32_t offset = iblock - run->iblock;
+		uint32_t n = min(count, run->count - offset);
+		aoff64_t ba = (run->fblock + offset) * journal->dev_blocks;
+		size_t cnt = n * journal->dev_blocks;
+
+		errno_t rc;
+		if (write)
+			rc = block_write_direct(device, ba, cnt, data);
+		else
+			rc = block_read_direct(device, ba, cnt, data);
+		if (rc != EOK)
+			return rc;
+
+		iblock += n;
+		count -= n;
+		data += n * journal->block_size;
+	}
+
+	return EOK;
+}
+
+/** Write blocks to the log, wrapping around at its end.
+ *
+ * @param journal Journal
+ * @param iblock  First block of the log
+ * @param count   Number of blocks
+ * @param buf     Data of the blocks
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_log_write(ext4_journal_t *journal,
+    uint32_t iblock, uint32_t count, uint8_t *buf)
+{
+	while (count > 0) {
+		uint32_t n = min(count, journal->maxlen - iblock);
+
+		errno_t rc = ext4_journal_io(journal, iblock, n, buf, true);
+		if (rc != EOK)
+			return rc;
+
+		buf += n * journal->block_size;
+		count -= n;
+		iblock = journal->first;
+	}
+
+	return EOK;
+}
+
+/** Write the state of the log to the journal superblock.
+ *
+ * @param journal Journal
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_write_superblock(ext4_journal_t *journal)
+{
+	uint8_t *buf = malloc(journal->block_size);
+	if (buf == NULL)
+		return ENOMEM;
+
+	errno_t rc = ext4_journal_io(journal, 0, 1, buf, false);
+	if (rc != EOK) {
+		free(buf);
+		return rc;
+	}
+
+	ext4_journal_superblock_t *jsb = (ext4_journal_superblock_t *) buf;
+	uint32_t sequence = journal->tail == 0 ? journal->sequence :
+	    journal->tail_sequence;
+
+	jsb->sequence = host2uint32_t_be(sequence);
+	jsb->start = host2uint32_t_be(journal->tail);
+	jsb->features_incompatible =
+	    host2uint32_t_be(journal->features_incompatible);
+
+	rc = ext4_journal_io(journal, 0, 1, buf, true);
+	free(buf);
+	return rc;
+}
+
+/** Initialize header of a block of the log.
+ *
+ * @param buf       Block
+ * @param blocktype Type of the block
+ * @param sequence  Transaction ID
+ *
+ */
+static void ext4_journal_header_init(void *buf, uint32_t blocktype,
+    uint32_t sequence)
+{
+	ext4_journal_header_t *header = buf;
+
+	header->magic = host2uint32_t_be(EXT4_JOURNAL_MAGIC);
+	header->blocktype = host2uint32_t_be(blocktype);
+	header->sequence = host2uint32_t_be(sequence);
+}
+
+static bool ext4_journal_collect_buffer(ht_link_t *item, void *arg)
+{
+	ext4_journal_buffer_t ***next = arg;
+
+	**next = hash_table_get_inst(item, ext4_journal_buffer_t, link);
+	(*next)++;
+	return true;
+}
+
+static bool ext4_journal_collect_record(ht_link_t *item, void *arg)
+{
+	ext4_journal_record_t ***next = arg;
+
+	**next = hash_table_get_inst(item, ext4_journal_record_t, link);
+	(*next)++;
+	return true;
+}
+
+/** Remember that a block has been logged since the last checkpoint.
+ *
+ * @param journal Journal
+ * @param block   Block number
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_logged_add(ext4_journal_t *journal,
+    uint64_t block)
+{
+	if (hash_table_find(&journal->logged, &block) != NULL)
+		return EOK;
+
+	ext4_journal_record_t *record = malloc(sizeof(ext4_journal_record_t));
+	if (record == NULL)
+		return ENOMEM;
+
+	record->block = block;
+	record->sequence = journal->sequence;
+	hash_table_insert(&journal->logged, &record->link);
+	journal->logged_count++;
+	return EOK;
+}
+
+/** Write the running transaction to the log.
+ *
+ * The log consists of descriptor blocks, each followed by the blocks
+ * it describes, the revocation blocks and the commit block. All but the
+ * commit block are written in one sequential write. The commit block is
+ * written once they are on stable storage, and after it is, the blocks of
+ * the transaction are released to the block cache.
+ *
+ * @param journal Journal
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_write_transaction(ext4_journal_t *journal)
+{
+	service_id_t device = journal->fs->device;
+	size_t block_size = journal->block_size;
+	bool is_64bit = ext4_journal_is_64bit(journal);
+	size_t tag_size = ext4_journal_tag_size(journal);
+	size_t record_size = ext4_journal_record_size(journal);
+	size_t tags_per_block = (block_size - sizeof(ext4_journal_header_t) -
+	    EXT4_JOURNAL_UUID_SIZE) / tag_size;
+	size_t records_per_block = (block_size -
+	    sizeof(ext4_journal_revoke_header_t)) / record_size;
+
+	size_t nbuffers = journal->buffers_count;
+	size_t nrecords = journal->revoked_count;
+	size_t ndesc = (nbuffers + tags_per_block - 1) / tags_per_block;
+	size_t nrevoke = (nrecords + records_per_block - 1) / records_per_block;
+	size_t nlog = ndesc + nbuffers + nrevoke + 1;
+
+	if (nlog > ext4_journal_free(journal))
+		return ENOSPC;
+
+	ext4_journal_buffer_t **buffers =
+	    calloc(max(nbuffers, 1), sizeof(ext4_journal_buffer_t *));
+	ext4_journal_record_t **records =
+	    calloc(max(nrecords, 1), sizeof(ext4_journal_record_t *));
+	uint8_t *log = calloc(nlog, block_size);
+	if (buffers == NULL || records == NULL || log == NULL) {
+		free(buffers);
+		free(records);
+		free(log);
+		return ENOMEM;
+	}
+
+	ext4_journal_buffer_t **next_buffer = buffers;
+	hash_table_apply(&journal->buffers, ext4_journal_collect_buffer,
+	    &next_buffer);
+	ext4_journal_record_t **next_record = records;
+	hash_table_apply(&journal->revoked, ext4_journal_collect_record,
+	    &next_record);
+
+	/* Descriptor blocks, each followed by the blocks it describes */
+	uint8_t *pos = log;
+	for (size_t i = 0; i < nbuffers; i += tags_per_block) {
+		size_t count = min(nbuffers - i, tags_per_block);
+		uint8_t *tag = pos + sizeof(ext4_journal_header_t);
+		uint8_t *data = pos + block_size;
+
+		ext4_journal_header_init(pos, EXT4_JOURNAL_DESCRIPTOR_BLOCK,
+		    journal->sequence);
+
+		for (size_t j = 0; j < count; j++) {
+			block_t *block = buffers[i + j]->block;
+			ext4_journal_block_tag_t *t =
+			    (ext4_journal_block_tag_t *) tag;
+			uint16_t flags = 0;
+
+			memcpy(data, block->data, block_size);
+
+			/* Blocks starting with the magic number are escaped */
+			if (uint32_t_be2host(*(uint32_t *) data) ==
+			    EXT4_JOURNAL_MAGIC) {
+				memset(data, 0, sizeof(uint32_t));
+				flags |= EXT4_JOURNAL_FLAG_ESCAPE;
+			}
+
+			if (j > 0)
+				flags |= EXT4_JOURNAL_FLAG_SAME_UUID;
+			if (j == count - 1)
+				flags |= EXT4_JOURNAL_FLAG_LAST_TAG;
+
+			t->blocknr = host2uint32_t_be((uint32_t) block->lba);
+			t->checksum = 0;
+			t->flags = host2uint16_t_be(flags);
+			if (is_64bit)
+				t->blocknr_high = host2uint32_t_be(block->lba >> 32);
+
+			tag += tag_size;
+			if (j == 0) {
+				memcpy(tag, journal->uuid, EXT4_JOURNAL_UUID_SIZE);
+				tag += EXT4_JOURNAL_UUID_SIZE;
+			}
+
+			data += block_size;
+		}
+
+		pos = data;
+	}
+
+	/* Revocation blocks */
+	for (size_t i = 0; i < nrecords; i += records_per_block) {
+		size_t count = min(nrecords - i, records_per_block);
+		ext4_journal_revoke_header_t *header =
+		    (ext4_journal_revoke_header_t *) pos;
+		uint8_t *rec = pos + sizeof(ext4_journal_revoke_header_t);
+
+		ext4_journal_header_init(pos, EXT4_JOURNAL_REVOKE_BLOCK,
+		    journal->sequence);
+		header->count = host2uint32_t_be(
+		    sizeof(ext4_journal_revoke_header_t) + count * record_size);
+
+		for (size_t j = 0; j < count; j++) {
+			uint64_t block = records[i + j]->block;
+
+			if (is_64bit)
+				*(uint64_t *) rec = host2uint64_t_be(block);
+			else
+				*(uint32_t *) rec = host2uint32_t_be(block);
+
+			rec += record_size;
+		}
+
+		pos += block_size;
+	}
+
+	/* Commit block */
+	ext4_journal_header_init(pos, EXT4_JOURNAL_COMMIT_BLOCK,
+	    journal->sequence);
+
+	errno_t rc = EOK;
+
+	/* The log was empty, it starts with this transaction now */
+	if (journal->tail == 0) {
+		journal->tail = journal->head;
+		journal->tail_sequence = journal->sequence;
+		rc = ext4_journal_write_superblock(journal);
+		if (rc != EOK)
+			goto out;
+	}
+
+	rc = ext4_journal_log_write(journal, journal->head, nlog - 1, log);
+	if (rc != EOK)
+		goto out;
+
+	rc = block_sync_cache(device, 0, 0);
+	if (rc != EOK)
+		goto out;
+
+	rc = ext4_journal_log_write(journal,
+	    ext4_journal_advance(journal, journal->head, nlog - 1), 1, pos);
+	if (rc != EOK)
+		goto out;
+
+	rc = block_sync_cache(device, 0, 0);
+	if (rc != EOK)
+		goto out;
+
+	journal->head = ext4_journal_advance(journal, journal->head, nlog);
+	journal->sequence++;
+
+	for (size_t i = 0; i < nbuffers; i++) {
+		rc = ext4_journal_logged_add(journal, buffers[i]->block->lba);
+		if (rc != EOK)
+			goto out;
+	}
+
+	/* The transaction is committed, release the blocks */
+	hash_table_clear(&journal->buffers);
+	journal->buffers_count = 0;
+	hash_table_clear(&journal->revoked);
+	journal->revoked_count = 0;
+out:
+	free(buffers);
+	free(records);
+	free(log);
+	return rc;
+}
+
+static bool ext4_journal_checkpoint_block(ht_link_t *item, void *arg)
+{
+	ext4_journal_checkpoint_t *cp = arg;
+	ext4_journal_t *journal = cp->journal;
+	ext4_journal_record_t *record =
+	    hash_table_get_inst(item, ext4_journal_record_t, link);
+	block_t *block;
+
+	cp->rc = block_get(&block, journal->fs->device, record->block,
+	    BLOCK_FLAGS_NONE);
+	if (cp->rc != EOK)
+		return false;
+
+	/*
+	 * The cache flush does not write blocks in use, e.g. the i-node
+	 * blocks of open nodes. No operation is in progress, so their
+	 * contents are what has been committed.
+	 */
+	if (block->dirty && block->refcnt > 1) {
+		cp->rc = block_write_direct(journal->fs->device, block->pba,
+		    journal->dev_blocks, block->data);
+	}
+
+	errno_t rc = block_put(block);
+	if (cp->rc == EOK)
+		cp->rc = rc;
+
+	return cp->rc == EOK;
+}
+
+/** Write all logged blocks in place and empty the log.
+ *
+ * Called when no operation is in progress and the running transaction
+ * is empty.
+ *
+ * @param journal Journal
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_checkpoint(ext4_journal_t *journal)
+{
+	service_id_t device = journal->fs->device;
+	ext4_journal_checkpoint_t cp = {
+		.journal = journal,
+		.rc = EOK
+	};
+
+	hash_table_apply(&journal->logged, ext4_journal_checkpoint_block, &cp);
+	if (cp.rc != EOK)
+		return cp.rc;
+
+	errno_t rc = block_cache_flush(device);
+	if (rc != EOK)
+		return rc;
+
+	hash_table_clear(&journal->logged);
+	journal->logged_count = 0;
+
+	journal->tail = 0;
+	journal->head = journal->first;
+	rc = ext4_journal_write_superblock(journal);
+	if (rc != EOK)
+		return rc;
+
+	return block_sync_cache(device, 0, 0);
+}
+
+/** Stop journaling after an error.
+ *
+ * The blocks of the running transaction are released and everything is
+ * written in place, so that the log is not needed any more.
+ *
+ * @param journal Journal
+ *
+ */
+static void ext4_journal_abort(ext4_journal_t *journal)
+{
+	journal->aborted = true;
+
+	hash_table_clear(&journal->buffers);
+	journal->buffers_count = 0;
+	hash_table_clear(&journal->revoked);
+	journal->revoked_count = 0;
+
+	(void) ext4_journal_checkpoint(journal);
+}
+
+/** Commit the running transaction.
+ *
+ * Waits for the operations in progress to finish. New operations wait
+ * until the commit is finished.
+ *
+ * @param journal    Journal, locked
+ * @param checkpoint True to empty the log after the commit
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_commit_locked(ext4_journal_t *journal,
+    bool checkpoint)
+{
+	while (journal->committing)
+		fibril_condvar_wait(&journal->cv, &journal->lock);
+
+	if (journal->aborted)
+		return EOK;
+
+	journal->committing = true;
+	while (journal->handles > 0)
+		fibril_condvar_wait(&journal->cv, &journal->lock);
+
+	errno_t rc = EOK;
+	if (journal->buffers_count > 0 || journal->revoked_count > 0)
+		rc = ext4_journal_write_transaction(journal);
+
+	/* Keep room for the next transaction */
+	uint32_t len = journal->maxlen - journal->first;
+	if (rc == EOK && journal->tail != 0 &&
+	    (checkpoint || ext4_journal_free(journal) < len / 2))
+		rc = ext4_journal_checkpoint(journal);
+
+	if (rc != EOK)
+		ext4_journal_abort(journal);
+
+	journal->committing = false;
+	fibril_condvar_broadcast(&journal->cv);
+	return rc;
+}
+
+/** Committer fibril.
+ *
+ * Commits the running transaction periodically.
+ *
+ * @param arg Journal
+ *
+ * @return EOK
+ *
+ */
+static errno_t ext4_journal_committer(void *arg)
+{
+	ext4_journal_t *journal = arg;
+
+	fibril_mutex_lock(&journal->lock);
+
+	while (!journal->committer_stop) {
+		(void) fibril_condvar_wait_timeout(&journal->commit_cv,
+		    &journal->lock, EXT4_JOURNAL_COMMIT_INTERVAL);
+		if (journal->committer_stop)
+			break;
+
+		(void) ext4_journal_commit_locked(journal, false);
+	}
+
+	journal->committer_done = true;
+	fibril_condvar_broadcast(&journal->commit_cv);
+	fibril_mutex_unlock(&journal->lock);
+	return EOK;
+}
+
+/** Check whether a logged block has been revoked.
+ *
+ * @param revoke   Revoked blocks
+ * @param block    Block number
+ * @param sequence Transaction which logged the block
+ *
+ * @return True if the block must not be replayed
+ *
+ */
+static bool ext4_journal_is_revoked(hash_table_t *revoke, uint64_t block,
+    uint32_t sequence)
+{
+	ht_link_t *link = hash_table_find(revoke, &block);
+	if (link == NULL)
+		return false;
+
+	ext4_journal_record_t *record =
+	    hash_table_get_inst(link, ext4_journal_record_t, link);
+	return !ext4_journal_sequence_after(sequence, record->sequence);
+}
+
+/** Collect the records of a revocation block.
+ *
+ * @param journal  Journal
+ * @param buf      Revocation block
+ * @param sequence Transaction of the block
+ * @param revoke   Revoked blocks
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_revoke_records(ext4_journal_t *journal,
+    uint8_t *buf, uint32_t sequence, hash_table_t *revoke)
+{
+	ext4_journal_revoke_header_t *header =
+	    (ext4_journal_revoke_header_t *) buf;
+	size_t record_size = ext4_journal_record_size(journal);
+	size_t count = min(uint32_t_be2host(header->count),
+	    journal->block_size);
+
+	for (size_t offset = sizeof(ext4_journal_revoke_header_t);
+	    offset + record_size <= count; offset += record_size) {
+		uint64_t block;
+
+		if (ext4_journal_is_64bit(journal))
+			block = uint64_t_be2host(*(uint64_t *) (buf + offset));
+		else
+			block = uint32_t_be2host(*(uint32_t *) (buf + offset));
+
+		ht_link_t *link = hash_table_find(revoke, &block);
+		if (link != NULL) {
+			ext4_journal_record_t *record = hash_table_get_inst(link,
+			    ext4_journal_record_t, link);
+			if (ext4_journal_sequence_after(sequence,
+			    record->sequence))
+				record->sequence = sequence;
+			continue;
+		}
+
+		ext4_journal_record_t *record =
+		    malloc(sizeof(ext4_journal_record_t));
+		if (record == NULL)
+			return ENOMEM;
+
+		record->block = block;
+		record->sequence = sequence;
+		hash_table_insert(revoke, &record->link);
+	}
+
+	return EOK;
+}
+
+/** Write a block from the log in place.
+ *
+ * The block is written through the block cache, so that cached copies
+ * are updated as well.
+ *
+ * @param journal Journal
+ * @param iblock  Block of the log
+ * @param target  Block number on the file system
+ * @param escape  True if the magic number was replaced by zero
+ * @param data    Buffer for the block
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_replay_block(ext4_journal_t *journal,
+    uint32_t iblock, uint64_t target, bool escape, uint8_t *data)
+{
+	ext4_filesystem_t *fs = journal->fs;
+
+	if (target >= ext4_superblock_get_blocks_count(fs->superblock))
+		return EIO;
+
+	errno_t rc = ext4_journal_io(journal, iblock, 1, data, false);
+	if (rc != EOK)
+		return rc;
+
+	if (escape)
+		*(uint32_t *) data = host2uint32_t_be(EXT4_JOURNAL_MAGIC);
+
+	block_t *block;
+	rc = block_get(&block, fs->device, target, BLOCK_FLAGS_NOREAD);
+	if (rc != EOK)
+		return rc;
+
+	memcpy(block->data, data, journal->block_size);
+	block->dirty = true;
+
+	return block_put(block);
+}
+
+/** Make one pass over the log during recovery.
+ *
+ * @param journal  Journal
+ * @param pass     Pass to make
+ * @param start    First block of the log
+ * @param sequence First transaction of the log
+ * @param end      Transaction following the last committed one, output
+ *                 of the scan pass, input of the others
+ * @param revoke   Revoked blocks
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_pass(ext4_journal_t *journal,
+    ext4_journal_pass_t pass, uint32_t start, uint32_t sequence,
+    uint32_t *end, hash_table_t *revoke)
+{
+	size_t block_size = journal->block_size;
+	size_t tag_size = ext4_journal_tag_size(journal);
+	uint32_t iblock = start;
+	errno_t rc = EOK;
+
+	uint8_t *buf = malloc(block_size);
+	uint8_t *data = malloc(block_size);
+	if (buf == NULL || data == NULL) {
+		free(buf);
+		free(data);
+		return ENOMEM;
+	}
+
+	while (pass == EXT4_JOURNAL_PASS_SCAN || sequence != *end) {
+		rc = ext4_journal_io(journal, iblock, 1, buf, false);
+		if (rc != EOK)
+			goto out;
+
+		/* The log ends with the first block not belonging to it */
+		ext4_journal_header_t *header = (ext4_journal_header_t *) buf;
+		if (uint32_t_be2host(header->magic) != EXT4_JOURNAL_MAGIC ||
+		    uint32_t_be2host(header->sequence) != sequence)
+			break;
+
+		uint32_t blocktype = uint32_t_be2host(header->blocktype);
+		iblock = ext4_journal_advance(journal, iblock, 1);
+
+		if (blocktype == EXT4_JOURNAL_DESCRIPTOR_BLOCK) {
+			size_t offset = sizeof(ext4_journal_header_t);
+
+			while (offset + tag_size <= block_size) {
+				ext4_journal_block_tag_t *tag =
+				    (ext4_journal_block_tag_t *) (buf + offset);
+				uint16_t flags = uint16_t_be2host(tag->flags);
+				uint64_t target = uint32_t_be2host(tag->blocknr);
+
+				if (ext4_journal_is_64bit(journal)) {
+					target |= (uint64_t) uint32_t_be2host(
+					    tag->blocknr_high) << 32;
+				}
+
+				if (pass == EXT4_JOURNAL_PASS_REPLAY &&
+				    !ext4_journal_is_revoked(revoke, target,
+				    sequence)) {
+					rc = ext4_journal_replay_block(journal,
+					    iblock, target,
+					    (flags & EXT4_JOURNAL_FLAG_ESCAPE) != 0,
+					    data);
+					if (rc != EOK)
+						goto out;
+				}
+
+				iblock = ext4_journal_advance(journal, iblock, 1);
+				offset += tag_size;
+				if ((flags & EXT4_JOURNAL_FLAG_SAME_UUID) == 0)
+					offset += EXT4_JOURNAL_UUID_SIZE;
+				if ((flags & EXT4_JOURNAL_FLAG_LAST_TAG) != 0)
+					break;
+			}
+		} else if (blocktype == EXT4_JOURNAL_COMMIT_BLOCK) {
+			sequence++;
+		} else if (blocktype == EXT4_JOURNAL_REVOKE_BLOCK) {
+			if (pass == EXT4_JOURNAL_PASS_REVOKE) {
+				rc = ext4_journal_revoke_records(journal, buf,
+				    sequence, revoke);
+				if (rc != EOK)
+					goto out;
+			}
+		} else {
+			break;
+		}
+	}
+
+	if (pass == EXT4_JOURNAL_PASS_SCAN)
+		*end = sequence;
+out:
+	free(buf);
+	free(data);
+	return rc;
+}
+
+/** Replay the committed transactions of the log.
+ *
+ * @param journal Journal with the log state read from its superblock
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_recover(ext4_journal_t *journal)
+{
+	ext4_filesystem_t *fs = journal->fs;
+	uint32_t end = journal->sequence;
+	hash_table_t revoke;
+	errno_t rc;
+
+	/* Empty log */
+	if (journal->tail == 0)
+		return EOK;
+
+	if (!hash_table_create(&revoke, 0, 0, &ext4_journal_record_ops))
+		return ENOMEM;
+
+	rc = ext4_journal_pass(journal, EXT4_JOURNAL_PASS_SCAN, journal->tail,
+	    journal->tail_sequence, &end, &revoke);
+	if (rc != EOK)
+		goto out;
+
+	rc = ext4_journal_pass(journal, EXT4_JOURNAL_PASS_REVOKE,
+	    journal->tail, journal->tail_sequence, &end, &revoke);
+	if (rc != EOK)
+		goto out;
+
+	rc = ext4_journal_pass(journal, EXT4_JOURNAL_PASS_REPLAY,
+	    journal->tail, journal->tail_sequence, &end, &revoke);
+	if (rc != EOK)
+		goto out;
+
+	rc = block_cache_flush(fs->device);
+	if (rc != EOK)
+		goto out;
+
+	/* Skip the ID of a transaction which might have been partly logged */
+	journal->sequence = end + 1;
+out:
+	hash_table_clear(&revoke);
+	hash_table_destroy(&revoke);
+	return rc;
+}
+
+/** Find the blocks of the journal on the file system.
+ *
+ * @param journal  Journal
+ * @param index    Index of the journal i-node
+ * @param nblocks  Output number of blocks of the journal
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_map(ext4_journal_t *journal, uint32_t index,
+    uint32_t *nblocks)
+{
+	ext4_filesystem_t *fs = journal->fs;
+	ext4_inode_ref_t *inode_ref;
+	size_t capacity = 0;
+
+	errno_t rc = ext4_filesystem_get_inode_ref(fs, index, &inode_ref);
+	if (rc != EOK)
+		return rc;
+
+	uint64_t size = ext4_inode_get_size(fs->superblock, inode_ref->inode);
+	uint64_t blocks = size / journal->block_size;
+	if (blocks < EXT4_JOURNAL_MIN_BLOCKS || blocks > UINT32_MAX) {
+		rc = ENOTSUP;
+		goto out;
+	}
+
+	for (uint32_t i = 0; i < blocks; i++) {
+		uint32_t fblock;
+
+		rc = ext4_filesystem_get_inode_data_block_index(inode_ref, i,
+		    &fblock);
+		if (rc != EOK)
+			goto out;
+
+		if (fblock == 0) {
+			rc = ENOTSUP;
+			goto out;
+		}
+
+		ext4_journal_run_t *last = journal->runs_count > 0 ?
+		    &journal->runs[journal->runs_count - 1] : NULL;
+		if (last != NULL && last->fblock + last->count == fblock) {
+			last->count++;
+			continue;
+		}
+
+		if (journal->runs_count == capacity) {
+			size_t ncapacity = capacity > 0 ? 2 * capacity : 8;
+			ext4_journal_run_t *runs = realloc(journal->runs,
+			    ncapacity * sizeof(ext4_journal_run_t));
+			if (runs == NULL) {
+				rc = ENOMEM;
+				goto out;
+			}
+
+			journal->runs = runs;
+			capacity = ncapacity;
+		}
+
+		journal->runs[journal->runs_count].iblock = i;
+		journal->runs[journal->runs_count].count = 1;
+		journal->runs[journal->runs_count].fblock = fblock;
+		journal->runs_count++;
+	}
+
+	*nblocks = blocks;
+out:
+	(void) ext4_filesystem_put_inode_ref(inode_ref);
+	return rc;
+}
+
+/** Read the journal superblock.
+ *
+ * @param journal Journal
+ * @param nblocks Number of blocks of the journal
+ *
+ * @return Error code, ENOTSUP if the journal cannot be used
+ *
+ */
+static errno_t ext4_journal_read_superblock(ext4_journal_t *journal,
+    uint32_t nblocks)
+{
+	uint8_t *buf = malloc(journal->block_size);
+	if (buf == NULL)
+		return ENOMEM;
+
+	errno_t rc = ext4_journal_io(journal, 0, 1, buf, false);
+	if (rc != EOK)
+		goto out;
+
+	ext4_journal_superblock_t *jsb = (ext4_journal_superblock_t *) buf;
+	uint32_t blocktype = uint32_t_be2host(jsb->header.blocktype);
+	uint32_t first = uint32_t_be2host(jsb->first);
+	uint32_t maxlen = uint32_t_be2host(jsb->maxlen);
+
+	if (uint32_t_be2host(jsb->header.magic) != EXT4_JOURNAL_MAGIC ||
+	    (blocktype != EXT4_JOURNAL_SUPERBLOCK_V1 &&
+	    blocktype != EXT4_JOURNAL_SUPERBLOCK_V2) ||
+	    uint32_t_be2host(jsb->block_size) != journal->block_size ||
+	    maxlen > nblocks || first == 0 ||
+	    first + EXT4_JOURNAL_MIN_BLOCKS > maxlen) {
+		rc = ENOTSUP;
+		goto out;
+	}
+
+	journal->features_incompatible = 0;
+	if (blocktype == EXT4_JOURNAL_SUPERBLOCK_V2) {
+		journal->features_incompatible =
+		    uint32_t_be2host(jsb->features_incompatible);
+		if ((journal->features_incompatible &
+		    ~EXT4_JOURNAL_FEATURE_INCOMPAT_SUPP) != 0) {
+			rc = ENOTSUP;
+			goto out;
+		}
+	}
+
+	journal->first = first;
+	journal->maxlen = maxlen;
+	journal->sequence = uint32_t_be2host(jsb->sequence);
+	journal->tail = uint32_t_be2host(jsb->start);
+	journal->tail_sequence = journal->sequence;
+	memcpy(journal->uuid, jsb->uuid, sizeof(journal->uuid));
+
+	if (journal->tail != 0 &&
+	    (journal->tail < first || journal->tail >= maxlen))
+		rc = EIO;
+out:
+	free(buf);
+	return rc;
+}
+
+/** Load the journal, recovering it if necessary.
+ *
+ * @param journal Journal
+ *
+ * @return Error code, ENOTSUP if the journal cannot be used
+ *
+ */
+static errno_t ext4_journal_load(ext4_journal_t *journal)
+{
+	ext4_filesystem_t *fs = journal->fs;
+	uint32_t index = ext4_superblock_get_journal_inode_number(fs->superblock);
+	uint32_t nblocks;
+	size_t dev_bsize;
+
+	errno_t rc = block_get_bsize(fs->device, &dev_bsize);
+	if (rc != EOK)
+		return rc;
+
+	journal->block_size = ext4_superblock_get_block_size(fs->superblock);
+	journal->dev_blocks = journal->block_size / dev_bsize;
+
+	rc = ext4_journal_map(journal, index, &nblocks);
+	if (rc != EOK)
+		return rc;
+
+	rc = ext4_journal_read_superblock(journal, nblocks);
+	if (rc != EOK)
+		return rc;
+
+	if (ext4_superblock_has_feature_incompatible(fs->superblock,
+	    EXT4_FEATURE_INCOMPAT_RECOVER)) {
+		rc = ext4_journal_recover(journal);
+		if (rc != EOK)
+			return rc;
+
+		/* The superblock may have been replayed */
+		ext4_superblock_t *sb;
+		rc = ext4_superblock_read_direct(fs->device, &sb);
+		if (rc != EOK)
+			return rc;
+
+		ext4_superblock_release(fs->superblock);
+		fs->superblock = sb;
+	}
+
+	/* Start with an empty log */
+	journal->head = journal->first;
+	journal->tail = 0;
+
+	/* Revocation blocks are written, block numbers are 64-bit if needed */
+	journal->features_incompatible |= EXT4_JOURNAL_FEATURE_INCOMPAT_REVOKE;
+	if (ext4_superblock_has_feature_incompatible(fs->superblock,
+	    EXT4_FEATURE_INCOMPAT_64BIT)) {
+		journal->features_incompatible |=
+		    EXT4_JOURNAL_FEATURE_INCOMPAT_64BIT;
+	}
+
+	rc = ext4_journal_write_superblock(journal);
+	if (rc != EOK)
+		return rc;
+
+	return block_sync_cache(fs->device, 0, 0);
+}
+
+/** Open the journal of a file system.
+ *
+ * Replays the log if the file system was not unmounted cleanly. The file
+ * system is used without journaling if it has no journal or one which is
+ * not supported, unless it needs recovery.
+ *
+ * @param fs Filesystem
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_journal_open(ext4_filesystem_t *fs)
+{
+	ext4_superblock_t *sb = fs->superblock;
+	bool recover = ext4_superblock_has_feature_incompatible(sb,
+	    EXT4_FEATURE_INCOMPAT_RECOVER);
+
+	/* External journals are not supported */
+	if (!ext4_superblock_has_feature_compatible(sb,
+	    EXT4_FEATURE_COMPAT_HAS_JOURNAL) ||
+	    ext4_superblock_get_journal_inode_number(sb) == 0 ||
+	    ext4_superblock_has_feature_incompatible(sb,
+	    EXT4_FEATURE_INCOMPAT_JOURNAL_DEV))
+		return recover ? ENOTSUP : EOK;
+
+	ext4_journal_t *journal = calloc(1, sizeof(ext4_journal_t));
+	if (journal == NULL)
+		return ENOMEM;
+
+	journal->fs = fs;
+	fibril_mutex_initialize(&journal->lock);
+	fibril_condvar_initialize(&journal->cv);
+	fibril_condvar_initialize(&journal->commit_cv);
+
+	errno_t rc = ENOMEM;
+	if (!hash_table_create(&journal->buffers, 0, 0,
+	    &ext4_journal_buffer_ops))
+		goto err;
+	if (!hash_table_create(&journal->revoked, 0, 0,
+	    &ext4_journal_record_ops))
+		goto err_1;
+	if (!hash_table_create(&journal->logged, 0, 0,
+	    &ext4_journal_record_ops))
+		goto err_2;
+
+	rc = ext4_journal_load(journal);
+	if (rc != EOK)
+		goto err_3;
+
+	journal->max_blocks = min((journal->maxlen - journal->first) / 4,
+	    EXT4_JOURNAL_MAX_BLOCKS);
+
+	journal->committer = fibril_create(ext4_journal_committer, journal);
+	if (journal->committer == 0) {
+		rc = ENOMEM;
+		goto err_3;
+	}
+
+	fibril_add_ready(journal->committer);
+
+	/* Recovery is needed until the file system is unmounted */
+	ext4_superblock_set_features_incompatible(fs->superblock,
+	    ext4_superblock_get_features_incompatible(fs->superblock) |
+	    EXT4_FEATURE_INCOMPAT_RECOVER);
+
+	fs->journal = journal;
+	return EOK;
+err_3:
+	hash_table_destroy(&journal->logged);
+err_2:
+	hash_table_destroy(&journal->revoked);
+err_1:
+	hash_table_destroy(&journal->buffers);
+err:
+	free(journal->runs);
+	free(journal);
+
+	/* Use the file system without the journal it does not understand */
+	if (rc == ENOTSUP && !recover)
+		return EOK;
+
+	return rc;
+}
+
+/** Finalize the journal without committing.
+ *
+ * @param fs Filesystem
+ *
+ */
+void ext4_journal_fini(ext4_filesystem_t *fs)
+{
+	ext4_journal_t *journal = fs->journal;
+	if (journal == NULL)
+		return;
+
+	fibril_mutex_lock(&journal->lock);
+
+	journal->committer_stop = true;
+	fibril_condvar_broadcast(&journal->commit_cv);
+	while (!journal->committer_done)
+		fibril_condvar_wait(&journal->commit_cv, &journal->lock);
+
+	hash_table_clear(&journal->buffers);
+
+	fibril_mutex_unlock(&journal->lock);
+
+	hash_table_clear(&journal->revoked);
+	hash_table_clear(&journal->logged);
+	hash_table_destroy(&journal->buffers);
+	hash_table_destroy(&journal->revoked);
+	hash_table_destroy(&journal->logged);
+	free(journal->runs);
+	free(journal);
+	fs->journal = NULL;
+}
+
+/** Close the journal.
+ *
+ * Commits the running transaction and empties the log, so that the file
+ * system does not need recovery.
+ *
+ * @param fs Filesystem
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_journal_close(ext4_filesystem_t *fs)
+{
+	ext4_journal_t *journal = fs->journal;
+	if (journal == NULL)
+		return EOK;
+
+	fibril_mutex_lock(&journal->lock);
+	errno_t rc = ext4_journal_commit_locked(journal, true);
+	fibril_mutex_unlock(&journal->lock);
+
+	if (rc != EOK)
+		return rc;
+
+	ext4_superblock_set_features_incompatible(fs->superblock,
+	    ext4_superblock_get_features_incompatible(fs->superblock) &
+	    ~EXT4_FEATURE_INCOMPAT_RECOVER);
+
+	ext4_journal_fini(fs);
+	return EOK;
+}
+
+/** Start an operation modifying the file system.
+ *
+ * All blocks modified by the operation become part of the same
+ * transaction.
+ *
+ * @param fs Filesystem
+ *
+ */
+void ext4_journal_start(ext4_filesystem_t *fs)
+{
+	ext4_journal_t *journal = fs->journal;
+	if (journal == NULL)
+		return;
+
+	fibril_mutex_lock(&journal->lock);
+	while (journal->committing)
+		fibril_condvar_wait(&journal->cv, &journal->lock);
+	journal->handles++;
+	fibril_mutex_unlock(&journal->lock);
+}
+
+/** Finish an operation modifying the file system.
+ *
+ * Commits the running transaction if it has grown large. If the commit
+ * fails, journaling is stopped and the blocks are written in place, so
+ * there is no error to report to the operation.
+ *
+ * @param fs Filesystem
+ *
+ */
+void ext4_journal_stop(ext4_filesystem_t *fs)
+{
+	ext4_journal_t *journal = fs->journal;
+	if (journal == NULL)
+		return;
+
+	fibril_mutex_lock(&journal->lock);
+
+	assert(journal->handles > 0);
+	journal->handles--;
+	if (journal->handles == 0)
+		fibril_condvar_broadcast(&journal->cv);
+
+	if (!journal->aborted && journal->buffers_count >= journal->max_blocks)
+		(void) ext4_journal_commit_locked(journal, false);
+
+	fibril_mutex_unlock(&journal->lock);
+}
+
+/** Mark a metadata block dirty.
+ *
+ * Without a journal, the block is only marked dirty. Otherwise it is also
+ * added to the running transaction, which keeps a reference to it until
+ * the transaction is committed.
+ *
+ * @param fs    Filesystem
+ * @param block Modified metadata block
+ *
+ */
+void ext4_journal_dirty(ext4_filesystem_t *fs, block_t *block)
+{
+	ext4_journal_t *journal = fs->journal;
+
+	block->dirty = true;
+	if (journal == NULL)
+		return;
+
+	fibril_mutex_lock(&journal->lock);
+
+	if (journal->aborted) {
+		fibril_mutex_unlock(&journal->lock);
+		return;
+	}
+
+	/* The block is logged again, the revocation does not apply */
+	if (journal->revoked_count > 0 &&
+	    hash_table_remove(&journal->revoked, &block->lba) > 0)
+		journal->revoked_count--;
+
+	if (hash_table_find(&journal->buffers, &block->lba) != NULL) {
+		fibril_mutex_unlock(&journal->lock);
+		return;
+	}
+
+	ext4_journal_buffer_t *buffer = malloc(sizeof(ext4_journal_buffer_t));
+	if (buffer == NULL) {
+		ext4_journal_abort(journal);
+		fibril_mutex_unlock(&journal->lock);
+		return;
+	}
+
+	/* Take another reference to the cached block */
+	errno_t rc = block_get(&buffer->block, fs->device, block->lba,
+	    BLOCK_FLAGS_NONE);
+	if (rc != EOK) {
+		free(buffer);
+		ext4_journal_abort(journal);
+		fibril_mutex_unlock(&journal->lock);
+		return;
+	}
+
+	assert(buffer->block == block);
+	hash_table_insert(&journal->buffers, &buffer->link);
+	journal->buffers_count++;
+
+	fibril_mutex_unlock(&journal->lock);
+}
+
+/** Add the block of a modified i-node to the running transaction.
+ *
+ * I-nodes are written to their blocks only when their references are
+ * put, which may happen after the operation modifying them finished.
+ *
+ * @param inode_ref I-node reference
+ *
+ */
+void ext4_journal_dirty_inode(ext4_inode_ref_t *inode_ref)
+{
+	if (inode_ref->dirty)
+		ext4_journal_dirty(inode_ref->fs, inode_ref->block);
+}
+
+/** Revoke freed blocks.
+ *
+ * Blocks logged before they were freed must not be replayed over what
+ * they are used for afterwards.
+ *
+ * @param fs    Filesystem
+ * @param first First freed block
+ * @param count Number of freed blocks
+ *
+ */
+void ext4_journal_revoke(ext4_filesystem_t *fs, uint64_t first,
+    uint32_t count)
+{
+	ext4_journal_t *journal = fs->journal;
+	if (journal == NULL)
+		return;
+
+	fibril_mutex_lock(&journal->lock);
+
+	if (journal->aborted ||
+	    (journal->logged_count == 0 && journal->buffers_count == 0)) {
+		fibril_mutex_unlock(&journal->lock);
+		return;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		uint64_t block = first + i;
+
+		if (hash_table_find(&journal->logged, &block) == NULL &&
+		    hash_table_find(&journal->buffers, &block) == NULL)
+			continue;
+
+		if (hash_table_find(&journal->revoked, &block) != NULL)
+			continue;
+
+		ext4_journal_record_t *record =
+		    malloc(sizeof(ext4_journal_record_t));
+		if (record == NULL) {
+			ext4_journal_abort(journal);
+			break;
+		}
+
+		record->block = block;
+		record->sequence = journal->sequence;
+		hash_table_insert(&journal->revoked, &record->link);
+		journal->revoked_count++;
+	}
+
+	fibril_mutex_unlock(&journal->lock);
+}
+
+/** Commit the running transaction.
+ *
+ * @param fs Filesystem
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_journal_commit(ext4_filesystem_t *fs)
+{
+	ext4_journal_t *journal = fs->journal;
+	if (journal == NULL)
+		return EOK;
+
+	fibril_mutex_lock(&journal->lock);
+	errno_t rc = ext4_journal_commit_locked(journal, false);
+	fibril_mutex_unlock(&journal->lock);
+	return rc;
+}
+
+/**
+ * @}
+ */
@@ -50,6 +50,7 @@
 #include "ext4/directory_index.h"
 #include "ext4/extent.h"
 #include "ext4/inode.h"
+#include "ext4/journal.h"
 #include "ext4/ops.h"
 #include "ext4/filesystem.h"
 #include "ext4/fstypes.h"
@@ -59,6 +60,8 @@
 
 static errno_t ext4_read_directory(ipc_call_t *, aoff64_t, size_t,
     ext4_instance_t *, ext4_inode_ref_t *, size_t *);
+static errno_t ext4_read_directory_dx(ipc_call_t *, aoff64_t,
+    ext4_inode_ref_t *, size_t *);
 static errno_t ext4_read_file(ipc_call_t *, aoff64_t, size_t, ext4_instance_t *,
     ext4_inode_ref_t *, size_t *);
 static bool ext4_is_dots(const uint8_t *, size_t);
@@ -450,8 +453,10 @@ errno_t ext4_create_node(fs_node_t **rfn, service_id_t service_id, int flags)
 
 	/* Allocate new i-node in filesystem */
 	ext4_inode_ref_t *inode_ref;
+	ext4_journal_start(inst->filesystem);
 	rc = ext4_filesystem_alloc_inode(inst->filesystem, &inode_ref, flags);
 	if (rc != EOK) {
+		ext4_journal_stop(inst->filesystem);
 		free(enode);
 		free(fs_node);
 		return rc;
@@ -468,6 +473,8 @@ errno_t ext4_create_node(fs_node_t **rfn, service_id_t service_id, int flags)
 	inst->open_nodes_count++;
 
 	enode->inode_ref->dirty = true;
+	ext4_journal_dirty_inode(enode->inode_ref);
+	ext4_journal_stop(inst->filesystem);
 
 	fs_node_initialize(fs_node);
 	fs_node->data = enode;
@@ -477,14 +484,14 @@ errno_t ext4_create_node(fs_node_t **rfn, service_id_t service_id, int flags)
 	return EOK;
 }
 
-/** Destroy existing node.
+/** Destroy existing node, as part of a journaled operation.
  *
- * @param fs Node to destroy
+ * @param fn Node to destroy
  *
  * @return Error code
  *
  */
-errno_t ext4_destroy_node(fs_node_t *fn)
+static errno_t ext4_destroy_node_core(fs_node_t *fn)
 {
 	/* If directory, check for children */
 	bool has_children;
@@ -526,7 +533,25 @@ errno_t ext4_destroy_node(fs_node_t *fn)
 	return ext4_node_put(fn);
 }
 
-/** Link the specfied node to directory.
+/** Destroy existing node.
+ *
+ * @param fn Node to destroy
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_destroy_node(fs_node_t *fn)
+{
+	ext4_filesystem_t *fs = EXT4_NODE(fn)->instance->filesystem;
+
+	ext4_journal_start(fs);
+	errno_t rc = ext4_destroy_node_core(fn);
+	ext4_journal_stop(fs);
+
+	return rc;
+}
+
+/** Link the specfied node to directory, as part of a journaled operation.
  *
  * @param pfn  Parent node to link in
  * @param cfn  Node to be linked
@@ -535,7 +560,8 @@ errno_t ext4_destroy_node(fs_node_t *fn)
  * @return Error code
  *
  */
-errno_t ext4_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+static errno_t ext4_link_core(fs_node_t *pfn, fs_node_t *cfn,
+    const char *name)
 {
 	/* Check maximum name length */
 	if (str_size(name) > EXT4_DIRECTORY_FILENAME_LEN)
@@ -599,7 +625,31 @@ errno_t ext4_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
 	return EOK;
 }
 
-/** Unlink node from specified directory.
+/** Link the specfied node to directory.
+ *
+ * @param pfn  Parent node to link in
+ * @param cfn  Node to be linked
+ * @param name Name which will be assigned to directory entry
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+{
+	ext4_node_t *parent = EXT4_NODE(pfn);
+	ext4_node_t *child = EXT4_NODE(cfn);
+	ext4_filesystem_t *fs = parent->instance->filesystem;
+
+	ext4_journal_start(fs);
+	errno_t rc = ext4_link_core(pfn, cfn, name);
+	ext4_journal_dirty_inode(parent->inode_ref);
+	ext4_journal_dirty_inode(child->inode_ref);
+	ext4_journal_stop(fs);
+
+	return rc;
+}
+
+/** Unlink node from specified directory, as part of a journaled operation.
  *
  * @param pfn  Parent node to delete node from
  * @param cfn  Child node to be unlinked from directory
@@ -608,7 +658,8 @@ errno_t ext4_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
  * @return Error code
  *
  */
-errno_t ext4_unlink(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+static errno_t ext4_unlink_core(fs_node_t *pfn, fs_node_t *cfn,
+    const char *name)
 {
 	bool has_children;
 	errno_t rc = ext4_has_children(&has_children, cfn);
@@ -671,6 +722,30 @@ errno_t ext4_unlink(fs_node_t *pfn, fs_node_t *cfn, const char *name)
 	return EOK;
 }
 
+/** Unlink node from specified directory.
+ *
+ * @param pfn  Parent node to delete node from
+ * @param cfn  Child node to be unlinked from directory
+ * @param name Name of entry that will be removed
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_unlink(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+{
+	ext4_node_t *parent = EXT4_NODE(pfn);
+	ext4_node_t *child = EXT4_NODE(cfn);
+	ext4_filesystem_t *fs = parent->instance->filesystem;
+
+	ext4_journal_start(fs);
+	errno_t rc = ext4_unlink_core(pfn, cfn, name);
+	ext4_journal_dirty_inode(parent->inode_ref);
+	ext4_journal_dirty_inode(child->inode_ref);
+	ext4_journal_stop(fs);
+
+	return rc;
+}
+
 /** Check if specified node has children.
  *
  * For files is response allways false and check is executed only for directories.
@@ -940,11 +1015,25 @@ static errno_t ext4_mounted(service_id_t service_id, const char *opts,
 	if (inst == NULL)
 		return ENOMEM;
 
-	enum cache_mode cmode;
-	if (str_cmp(opts, "wtcache") == 0)
-		cmode = CACHE_MODE_WT;
-	else
-		cmode = CACHE_MODE_WB;
+	char *mntopts = str_dup(opts);
+	if (mntopts == NULL) {
+		free(inst);
+		return ENOMEM;
+	}
+
+	/* Parse mount options */
+	enum cache_mode cmode = CACHE_MODE_WB;
+	size_t cache_size = 0;
+	char *next = mntopts;
+	char *opt;
+	while ((opt = str_tok(next, " ,", &next)) != NULL) {
+		if (str_cmp(opt, "wtcache") == 0)
+			cmode = CACHE_MODE_WT;
+		else if (str_lcmp(opt, "cache=", 6) == 0)
+			(void) block_cache_size_parse(opt + 6, &cache_size);
+	}
+
+	free(mntopts);
 
 	/* Initialize instance */
 	link_initialize(&inst->link);
@@ -959,6 +1048,9 @@ static errno_t ext4_mounted(service_id_t service_id, const char *opts,
 		return rc;
 	}
 
+	if (cache_size != 0)
+		(void) block_cache_resize(service_id, cache_size);
+
 	/* Add instance to the list */
 	fibril_mutex_lock(&instance_list_mutex);
 	list_append(&inst->link, &instance_list);
@@ -1103,8 +1195,24 @@ bool ext4_is_dots(const uint8_t *name, size_t name_size)
 errno_t ext4_read_directory(ipc_call_t *call, aoff64_t pos, size_t size,
     ext4_instance_t *inst, ext4_inode_ref_t *inode_ref, size_t *rbytes)
 {
+	ext4_superblock_t *sb = inst->filesystem->superblock;
+	errno_t rc;
+
+	/* Indexed directories are read in hash order */
+	if ((ext4_superblock_has_feature_compatible(sb,
+	    EXT4_FEATURE_COMPAT_DIR_INDEX)) &&
+	    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_INDEX))) {
+		rc = ext4_read_directory_dx(call, pos, inode_ref, rbytes);
+		if (rc != EXT4_ERR_BAD_DX_DIR)
+			return rc;
+
+		/* Needed to clear dir index flag if corrupted */
+		ext4_inode_clear_flag(inode_ref->inode, EXT4_INODE_FLAG_INDEX);
+		inode_ref->dirty = true;
+	}
+
 	ext4_directory_iterator_t it;
-	errno_t rc = ext4_directory_iterator_init(&it, inode_ref, pos);
+	rc = ext4_directory_iterator_init(&it, inode_ref, pos);
 	if (rc != EOK) {
 		async_answer_0(call, rc);
 		return rc;
@@ -1179,6 +1287,60 @@ errno_t ext4_read_directory(ipc_call_t *call, aoff64_t pos, size_t size,
 	}
 }
 
+/** Read data from indexed directory.
+ *
+ * Positions are cookies of ext4_directory_dx_read_entry() instead of
+ * offsets in the directory.
+ *
+ * @param call      IPC call
+ * @param pos       Cookie to start reading from
+ * @param inode_ref Node to read data from
+ * @param rbytes    Output value to return the difference to the next cookie
+ *
+ * @return Error code, EXT4_ERR_BAD_DX_DIR if the index is corrupted and
+ *         the call still has to be answered
+ *
+ */
+errno_t ext4_read_directory_dx(ipc_call_t *call, aoff64_t pos,
+    ext4_inode_ref_t *inode_ref, size_t *rbytes)
+{
+	ext4_directory_search_result_t result;
+	aoff64_t next;
+	errno_t rc = ext4_directory_dx_read_entry(&result, inode_ref, pos,
+	    &next);
+	if (rc == EXT4_ERR_BAD_DX_DIR)
+		return rc;
+
+	if (rc != EOK) {
+		async_answer_0(call, rc);
+		return rc;
+	}
+
+	uint16_t name_size = ext4_directory_entry_ll_get_name_length(
+	    inode_ref->fs->superblock, result.dentry);
+
+	/* Add the \0 missing in the on-disk entry */
+	uint8_t *buf = malloc(name_size + 1);
+	if (buf == NULL) {
+		ext4_directory_destroy_result(&result);
+		async_answer_0(call, ENOMEM);
+		return ENOMEM;
+	}
+
+	memcpy(buf, &result.dentry->name, name_size);
+	*(buf + name_size) = 0;
+
+	(void) async_data_read_finalize(call, buf, name_size + 1);
+	free(buf);
+
+	rc = ext4_directory_destroy_result(&result);
+	if (rc != EOK)
+		return rc;
+
+	*rbytes = next - pos;
+	return EOK;
+}
+
 /** Read data from file.
  *
  * @param call      IPC call
@@ -1300,6 +1462,8 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 	ext4_node_t *enode = EXT4_NODE(fn);
 	ext4_filesystem_t *fs = enode->instance->filesystem;
 
+	ext4_journal_start(fs);
+
 	uint32_t block_size = ext4_superblock_get_block_size(fs->superblock);
 
 	/* Prevent writing to more than one block */
@@ -1318,7 +1482,7 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 	    &fblock);
 	if (rc != EOK) {
 		async_answer_0(&call, rc);
-		goto exit;
+		goto stop;
 	}
 
 	/* Check for sparse file */
@@ -1335,7 +1499,7 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 				    &fblock, true);
 				if (rc != EOK) {
 					async_answer_0(&call, rc);
-					goto exit;
+					goto stop;
 				}
 			}
 
@@ -1343,13 +1507,13 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 			    &fblock, false);
 			if (rc != EOK) {
 				async_answer_0(&call, rc);
-				goto exit;
+				goto stop;
 			}
 		} else {
 			rc = ext4_balloc_alloc_block(inode_ref, &fblock);
 			if (rc != EOK) {
 				async_answer_0(&call, rc);
-				goto exit;
+				goto stop;
 			}
 
 			rc = ext4_filesystem_set_inode_data_block_index(inode_ref,
@@ -1357,7 +1521,7 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 			if (rc != EOK) {
 				ext4_balloc_free_block(inode_ref, fblock);
 				async_answer_0(&call, rc);
-				goto exit;
+				goto stop;
 			}
 		}
 
@@ -1370,7 +1534,7 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 	rc = block_get(&write_block, service_id, fblock, flags);
 	if (rc != EOK) {
 		async_answer_0(&call, rc);
-		goto exit;
+		goto stop;
 	}
 
 	if (flags == BLOCK_FLAGS_NOREAD)
@@ -1380,14 +1544,14 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 	    (pos % block_size), bytes);
 	if (rc != EOK) {
 		block_put(write_block);
-		goto exit;
+		goto stop;
 	}
 
 	write_block->dirty = true;
 
 	rc = block_put(write_block);
 	if (rc != EOK)
-		goto exit;
+		goto stop;
 
 	/* Do some counting */
 	uint32_t old_inode_size = ext4_inode_get_size(fs->superblock,
@@ -1400,6 +1564,9 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 	*nsize = ext4_inode_get_size(fs->superblock, inode_ref->inode);
 	*wbytes = bytes;
 
+stop:
+	ext4_journal_dirty_inode(enode->inode_ref);
+	ext4_journal_stop(fs);
 exit:
 	rc2 = ext4_node_put(fn);
 	return rc == EOK ? rc2 : rc;
@@ -1426,8 +1593,13 @@ static errno_t ext4_truncate(service_id_t service_id, fs_index_t index,
 
 	ext4_node_t *enode = EXT4_NODE(fn);
 	ext4_inode_ref_t *inode_ref = enode->inode_ref;
+	ext4_filesystem_t *fs = enode->instance->filesystem;
 
+	ext4_journal_start(fs);
 	rc = ext4_filesystem_truncate_inode(inode_ref, new_size);
+	ext4_journal_dirty_inode(inode_ref);
+	ext4_journal_stop(fs);
+
 	errno_t const rc2 = ext4_node_put(fn);
 
 	return rc == EOK ? rc2 : rc;
@@ -1443,7 +1615,17 @@ static errno_t ext4_truncate(service_id_t service_id, fs_index_t index,
  */
 static errno_t ext4_close(service_id_t service_id, fs_index_t index)
 {
-	return EOK;
+	ext4_instance_t *inst;
+	errno_t rc = ext4_instance_get(service_id, &inst);
+	if (rc != EOK)
+		return rc;
+
+	/* Return the blocks preallocated for the file */
+	ext4_journal_start(inst->filesystem);
+	rc = ext4_balloc_prealloc_discard(inst->filesystem, index);
+	ext4_journal_stop(inst->filesystem);
+
+	return rc;
 }
 
 /** Destroy node specified by index.
@@ -1479,9 +1661,15 @@ static errno_t ext4_sync(service_id_t service_id, fs_index_t index)
 		return rc;
 
 	ext4_node_t *enode = EXT4_NODE(fn);
+	ext4_filesystem_t *fs = enode->instance->filesystem;
 	enode->inode_ref->dirty = true;
 
-	return ext4_node_put(fn);
+	rc = ext4_node_put(fn);
+	if (rc != EOK)
+		return rc;
+
+	/* Make the metadata updates so far persistent */
+	return ext4_journal_commit(fs);
 }
 
 /** VFS operations
@@ -70,6 +70,17 @@ static libfs_ops_t *libfs_ops = NULL;
 
 static char fs_name[FS_NAME_MAXLEN + 1];
 
+/** Number of locks serializing changes of directory entries */
+#define DIR_LOCKS	64
+
+/**
+ * Locks serializing lookups which create or remove a name. VFS holds its
+ * namespace lock only for reading while creating files, so two lookups could
+ * otherwise both find a name missing and both create it. Directories are
+ * hashed onto the locks by their index.
+ */
+static fibril_mutex_t dir_locks[DIR_LOCKS];
+
 static void libfs_link(libfs_ops_t *, fs_handle_t, ipc_call_t *);
 static void libfs_lookup(libfs_ops_t *, fs_handle_t, ipc_call_t *);
 static void libfs_stat(libfs_ops_t *, fs_handle_t, ipc_call_t *);
@@ -387,6 +398,9 @@ errno_t fs_register(async_sess_t *sess, vfs_info_t *info, vfs_out_ops_t *vops,
 		return rc;
 	}
 
+	for (size_t i = 0; i < DIR_LOCKS; i++)
+		fibril_mutex_initialize(&dir_locks[i]);
+
 	/*
 	 * Set VFS_OUT and libfs operations.
 	 */
@@ -428,11 +442,43 @@ errno_t fs_register(async_sess_t *sess, vfs_info_t *info, vfs_out_ops_t *vops,
 	return ipc_get_retval(&answer);
 }
 
+/** Serve VFS requests on a pool of threads.
+ *
+ * Each request is served by a fibril of its own, but by default all of them
+ * run on the main thread of the server, so requests never run in parallel
+ * and a fibril blocked in a system call stalls all the others. This starts
+ * a fibril runner thread for each processor. It is meant to be called before
+ * fs_register().
+ *
+ * The file system implementation must then be safe for concurrent requests.
+ * VFS serializes writes and truncation of a node with any other I/O on the
+ * node, unless the file system asks for concurrent reads and writes, and it
+ * serializes renaming and unmounting with all lookups. libfs serializes
+ * lookups creating or removing a name in the same directory. Everything
+ * else needs locks of the implementation: node reference counts and node
+ * caches, node state reachable from more than one node, such as a directory
+ * entry updated when its child is synced, and allocation of blocks and
+ * i-nodes, whose bitmaps and counters are shared by all nodes of the
+ * instance. Per-node locks taken in the order of parent before child and
+ * per-instance allocation locks taken last keep unrelated requests apart.
+ */
+void fs_enable_multithreaded(void)
+{
+	fibril_enable_multithreaded();
+}
+
 void fs_node_initialize(fs_node_t *fn)
 {
 	memset(fn, 0, sizeof(fs_node_t));
 }
 
+/** Get the lock serializing changes of a directory's entries. */
+static fibril_mutex_t *libfs_dir_lock(service_id_t service_id,
+    fs_index_t index)
+{
+	return &dir_locks[(service_id * 31 + index) % DIR_LOCKS];
+}
+
 static char plb_get_char(unsigned pos)
 {
 	return reg.plb_ro[pos % PLB_SIZE];
@@ -552,6 +598,7 @@ void libfs_lookup(libfs_ops_t *ops, fs_handle_t fs_handle, ipc_call_t *req)
 	fs_node_t *par = NULL;
 	fs_node_t *cur = NULL;
 	fs_node_t *tmp = NULL;
+	fibril_mutex_t *dir_lock = NULL;
 	unsigned clen = 0;
 
 	rc = ops->node_get(&cur, service_id, index);
@@ -593,6 +640,16 @@ void libfs_lookup(libfs_ops_t *ops, fs_handle_t fs_handle, ipc_call_t *req)
 
 		assert(component[clen] == 0);
 
+		/*
+		 * Keep the last component from being created or removed by
+		 * someone else between matching and changing it.
+		 */
+		if (next == last && (lflag & (L_CREATE | L_UNLINK)) != 0) {
+			dir_lock = libfs_dir_lock(service_id,
+			    ops->index_get(cur));
+			fibril_mutex_lock(dir_lock);
+		}
+
 		/* Match the component */
 		rc = ops->match(&tmp, cur, component);
 		if (rc != EOK) {
@@ -703,6 +760,9 @@ out1:
 	    UPPER32(ops->size_get(cur)));
 
 out:
+	if (dir_lock != NULL)
+		fibril_mutex_unlock(dir_lock);
+
 	if (par)
 		(void) ops->node_put(par);
 
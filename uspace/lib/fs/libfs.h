@@ -97,6 +97,7 @@ typedef struct {
 extern errno_t fs_register(async_sess_t *, vfs_info_t *, vfs_out_ops_t *,
     libfs_ops_t *);
 
+extern void fs_enable_multithreaded(void);
 extern void fs_node_initialize(fs_node_t *);
 
 extern errno_t fs_instance_create(service_id_t, void *);
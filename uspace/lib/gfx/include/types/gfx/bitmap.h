@@ -51,7 +51,12 @@ typedef enum {
 	/** Enable color key */
 	bmpf_color_key = 0x2,
 	/** Paint non-background pixels with current drawing color */
-	bmpf_colorize = 0x4
+	bmpf_colorize = 0x4,
+	/**
+	 * Bitmap is a surface covering the entire GC. Rendering it presents
+	 * its contents instead of copying them, if the GC supports it.
+	 */
+	bmpf_surface = 0x8
 } gfx_bitmap_flags_t;
 
 /** Bitmap parameters */
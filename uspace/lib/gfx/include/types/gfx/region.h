@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libgfx
+ * @{
+ */
+/**
+ * @file Region
+ */
+
+#ifndef _GFX_TYPES_REGION_H
+#define _GFX_TYPES_REGION_H
+
+#include <stddef.h>
+#include <types/gfx/coord.h>
+
+enum {
+	/** Maximum number of rectangles in a region */
+	gfx_region_max_rects = 16
+};
+
+/** Region.
+ *
+ * A set of pixels described as a list of non-overlapping rectangles.
+ * The region may cover more pixels than were added to it, nearby
+ * rectangles are merged into their envelope (the region is used to track
+ * damage where painting a few extra pixels is cheaper than an extra
+ * operation).
+ */
+typedef struct {
+	/** Number of rectangles */
+	size_t count;
+	/** Rectangles (sorted, non-empty, non-overlapping) */
+	gfx_rect_t rects[gfx_region_max_rects];
+} gfx_region_t;
+
+#endif
+
+/** @}
+ */
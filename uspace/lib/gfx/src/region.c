@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libgfx
+ * @{
+ */
+/**
+ * @file Region
+ *
+ * Regions are used to track damage. Adding a rectangle merges it with each
+ * rectangle it overlaps, or which is close enough that repainting the
+ * pixels in between costs less than keeping the two apart.
+ */
+
+#include <gfx/coord.h>
+#include <gfx/region.h>
+#include <stdint.h>
+
+enum {
+	/**
+	 * Number of pixels which can always be wasted by merging two
+	 * rectangles.
+	 */
+	gfx_region_slack = 1024
+};
+
+/** Compute area of a sorted rectangle. */
+static uint64_t gfx_region_rect_area(gfx_rect_t *rect)
+{
+	return (uint64_t)(rect->p1.x - rect->p0.x) *
+	    (uint64_t)(rect->p1.y - rect->p0.y);
+}
+
+/** Determine if two rectangles should be merged.
+ *
+ * Rectangles are merged if they overlap or if their envelope contains
+ * few pixels that belong to neither of them.
+ *
+ * @param a First rectangle (sorted)
+ * @param b Second rectangle (sorted)
+ * @param env Envelope of @a a and @a b
+ * @return @c true iff the rectangles should be merged
+ */
+static bool gfx_region_should_merge(gfx_rect_t *a, gfx_rect_t *b,
+    gfx_rect_t *env)
+{
+	uint64_t area;
+	uint64_t earea;
+	uint64_t waste;
+
+	if (gfx_rect_is_incident(a, b))
+		return true;
+
+	area = gfx_region_rect_area(a) + gfx_region_rect_area(b);
+	earea = gfx_region_rect_area(env);
+	waste = earea - area;
+
+	return waste <= gfx_region_slack || waste <= area / 2;
+}
+
+/** Remove rectangle from region.
+ *
+ * @param region Region
+ * @param idx Index of rectangle to remove
+ */
+static void gfx_region_remove(gfx_region_t *region, size_t idx)
+{
+	region->rects[idx] = region->rects[region->count - 1];
+	--region->count;
+}
+
+/** Initialize region to empty.
+ *
+ * @param region Region
+ */
+void gfx_region_init(gfx_region_t *region)
+{
+	region->count = 0;
+}
+
+/** Add rectangle to region.
+ *
+ * @param region Region
+ * @param rect Rectangle to add (need not be sorted)
+ */
+void gfx_region_add_rect(gfx_region_t *region, gfx_rect_t *rect)
+{
+	gfx_rect_t r;
+	gfx_rect_t env;
+	uint64_t growth;
+	uint64_t best_growth;
+	size_t best;
+	size_t i;
+
+	if (gfx_rect_is_empty(rect))
+		return;
+
+	gfx_rect_points_sort(rect, &r);
+
+	/*
+	 * Merge with any rectangle that is close. The result can, in turn,
+	 * be close to another rectangle, so start over after each merge.
+	 */
+	i = 0;
+	while (i < region->count) {
+		gfx_rect_envelope(&region->rects[i], &r, &env);
+		if (gfx_region_should_merge(&region->rects[i], &r, &env)) {
+			r = env;
+			gfx_region_remove(region, i);
+			i = 0;
+			continue;
+		}
+
+		++i;
+	}
+
+	if (region->count < gfx_region_max_rects) {
+		region->rects[region->count++] = r;
+		return;
+	}
+
+	/*
+	 * The region is full. Merge with the rectangle whose envelope
+	 * grows the least and add the result again (it may now be close
+	 * to other rectangles).
+	 */
+	best = 0;
+	best_growth = UINT64_MAX;
+	for (i = 0; i < region->count; i++) {
+		gfx_rect_envelope(&region->rects[i], &r, &env);
+		growth = gfx_region_rect_area(&env) -
+		    gfx_region_rect_area(&region->rects[i]);
+		if (growth < best_growth) {
+			best_growth = growth;
+			best = i;
+		}
+	}
+
+	gfx_rect_envelope(&region->rects[best], &r, &env);
+	gfx_region_remove(region, best);
+	gfx_region_add_rect(region, &env);
+}
+
+/** Determine if region is empty.
+ *
+ * @param region Region
+ * @return @c true iff region is empty
+ */
+bool gfx_region_is_empty(gfx_region_t *region)
+{
+	return region->count == 0;
+}
+
+/** Compute envelope of region.
+ *
+ * @param region Region
+ * @param env Place to store envelope (empty if region is empty)
+ */
+void gfx_region_envelope(gfx_region_t *region, gfx_rect_t *env)
+{
+	gfx_rect_t e;
+	size_t i;
+
+	env->p0.x = 0;
+	env->p0.y = 0;
+	env->p1.x = 0;
+	env->p1.y = 0;
+
+	for (i = 0; i < region->count; i++) {
+		gfx_rect_envelope(env, &region->rects[i], &e);
+		*env = e;
+	}
+}
+
+/** @}
+ */
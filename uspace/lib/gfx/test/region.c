@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gfx/coord.h>
+#include <gfx/region.h>
+#include <pcut/pcut.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(region);
+
+static void test_rect(gfx_rect_t *rect, gfx_coord_t x0, gfx_coord_t y0,
+    gfx_coord_t x1, gfx_coord_t y1)
+{
+	rect->p0.x = x0;
+	rect->p0.y = y0;
+	rect->p1.x = x1;
+	rect->p1.y = y1;
+}
+
+/** Newly initialized region is empty */
+PCUT_TEST(init_empty)
+{
+	gfx_region_t region;
+	gfx_rect_t env;
+
+	gfx_region_init(&region);
+	PCUT_ASSERT_TRUE(gfx_region_is_empty(&region));
+
+	gfx_region_envelope(&region, &env);
+	PCUT_ASSERT_TRUE(gfx_rect_is_empty(&env));
+}
+
+/** Adding empty rectangle has no effect */
+PCUT_TEST(add_empty)
+{
+	gfx_region_t region;
+	gfx_rect_t rect;
+
+	gfx_region_init(&region);
+	test_rect(&rect, 10, 10, 10, 20);
+	gfx_region_add_rect(&region, &rect);
+	PCUT_ASSERT_TRUE(gfx_region_is_empty(&region));
+}
+
+/** Added rectangle is stored sorted */
+PCUT_TEST(add_one)
+{
+	gfx_region_t region;
+	gfx_rect_t rect;
+
+	gfx_region_init(&region);
+	test_rect(&rect, 20, 40, 10, 30);
+	gfx_region_add_rect(&region, &rect);
+
+	PCUT_ASSERT_FALSE(gfx_region_is_empty(&region));
+	PCUT_ASSERT_INT_EQUALS(1, region.count);
+	PCUT_ASSERT_INT_EQUALS(10, region.rects[0].p0.x);
+	PCUT_ASSERT_INT_EQUALS(30, region.rects[0].p0.y);
+	PCUT_ASSERT_INT_EQUALS(20, region.rects[0].p1.x);
+	PCUT_ASSERT_INT_EQUALS(40, region.rects[0].p1.y);
+}
+
+/** Distant rectangles are kept apart */
+PCUT_TEST(add_distant)
+{
+	gfx_region_t region;
+	gfx_rect_t rect;
+	gfx_rect_t env;
+
+	gfx_region_init(&region);
+	test_rect(&rect, 0, 0, 10, 10);
+	gfx_region_add_rect(&region, &rect);
+	test_rect(&rect, 1900, 1000, 1920, 1080);
+	gfx_region_add_rect(&region, &rect);
+
+	PCUT_ASSERT_INT_EQUALS(2, region.count);
+
+	gfx_region_envelope(&region, &env);
+	PCUT_ASSERT_INT_EQUALS(0, env.p0.x);
+	PCUT_ASSERT_INT_EQUALS(0, env.p0.y);
+	PCUT_ASSERT_INT_EQUALS(1920, env.p1.x);
+	PCUT_ASSERT_INT_EQUALS(1080, env.p1.y);
+}
+
+/** Overlapping rectangles are merged */
+PCUT_TEST(add_overlap)
+{
+	gfx_region_t region;
+	gfx_rect_t rect;
+
+	gfx_region_init(&region);
+	test_rect(&rect, 0, 0, 100, 100);
+	gfx_region_add_rect(&region, &rect);
+	test_rect(&rect, 90, 90, 400, 400);
+	gfx_region_add_rect(&region, &rect);
+
+	PCUT_ASSERT_INT_EQUALS(1, region.count);
+	PCUT_ASSERT_INT_EQUALS(0, region.rects[0].p0.x);
+	PCUT_ASSERT_INT_EQUALS(0, region.rects[0].p0.y);
+	PCUT_ASSERT_INT_EQUALS(400, region.rects[0].p1.x);
+	PCUT_ASSERT_INT_EQUALS(400, region.rects[0].p1.y);
+}
+
+/** Adjacent rectangles are merged */
+PCUT_TEST(add_adjacent)
+{
+	gfx_region_t region;
+	gfx_rect_t rect;
+
+	gfx_region_init(&region);
+	test_rect(&rect, 0, 0, 500, 10);
+	gfx_region_add_rect(&region, &rect);
+	test_rect(&rect, 0, 10, 500, 20);
+	gfx_region_add_rect(&region, &rect);
+
+	PCUT_ASSERT_INT_EQUALS(1, region.count);
+	PCUT_ASSERT_INT_EQUALS(0, region.rects[0].p0.y);
+	PCUT_ASSERT_INT_EQUALS(20, region.rects[0].p1.y);
+}
+
+/** A merged rectangle is merged again with others it now overlaps */
+PCUT_TEST(add_merge_chain)
+{
+	gfx_region_t region;
+	gfx_rect_t rect;
+
+	gfx_region_init(&region);
+	test_rect(&rect, 0, 0, 10, 10);
+	gfx_region_add_rect(&region, &rect);
+	test_rect(&rect, 1000, 0, 1010, 10);
+	gfx_region_add_rect(&region, &rect);
+	PCUT_ASSERT_INT_EQUALS(2, region.count);
+
+	/* Covers both */
+	test_rect(&rect, 5, 0, 1005, 10);
+	gfx_region_add_rect(&region, &rect);
+
+	PCUT_ASSERT_INT_EQUALS(1, region.count);
+	PCUT_ASSERT_INT_EQUALS(0, region.rects[0].p0.x);
+	PCUT_ASSERT_INT_EQUALS(1010, region.rects[0].p1.x);
+}
+
+/** Region never holds more than the maximum number of rectangles */
+PCUT_TEST(add_full)
+{
+	gfx_region_t region;
+	gfx_rect_t rect;
+	gfx_rect_t env;
+	size_t i, j;
+
+	gfx_region_init(&region);
+
+	for (i = 0; i < gfx_region_max_rects * 2; i++) {
+		test_rect(&rect, i * 1000, 0, i * 1000 + 10, 10);
+		gfx_region_add_rect(&region, &rect);
+		PCUT_ASSERT_TRUE(region.count <= gfx_region_max_rects);
+	}
+
+	/* Rectangles must not overlap */
+	for (i = 0; i < region.count; i++) {
+		for (j = i + 1; j < region.count; j++) {
+			PCUT_ASSERT_FALSE(gfx_rect_is_incident(
+			    &region.rects[i], &region.rects[j]));
+		}
+	}
+
+	/* All rectangles must be covered */
+	gfx_region_envelope(&region, &env);
+	PCUT_ASSERT_INT_EQUALS(0, env.p0.x);
+	PCUT_ASSERT_INT_EQUALS((gfx_region_max_rects * 2 - 1) * 1000 + 10,
+	    env.p1.x);
+}
+
+PCUT_EXPORT(region);
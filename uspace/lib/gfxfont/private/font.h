@@ -69,6 +69,10 @@ struct gfx_font {
 	gfx_bitmap_t *bitmap;
 	/** Bitmap rectangle */
 	gfx_rect_t rect;
+	/** Cached text runs (of gfx_text_run_t) */
+	list_t text_runs;
+	/** Number of entries in @c text_runs */
+	unsigned text_runs_cnt;
 };
 
 /** Font info
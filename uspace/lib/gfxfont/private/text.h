@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libgfxfont
+ * @{
+ */
+/**
+ * @file Text run cache
+ *
+ */
+
+#ifndef _GFX_PRIVATE_TEXT_H
+#define _GFX_PRIVATE_TEXT_H
+
+#include <adt/list.h>
+#include <stdbool.h>
+#include <types/gfx/bitmap.h>
+#include <types/gfx/coord.h>
+#include <types/gfx/font.h>
+
+/** Maximum number of text runs cached per font */
+#define GFX_TEXT_RUNS_MAX 32
+
+/** Maximum area in pixels of a cached text run bitmap */
+#define GFX_TEXT_RUN_AREA_MAX (256 * 1024)
+
+/** Cached text run.
+ *
+ * A text run is everything gfx_puttext() draws for a string with given
+ * formatting, pre-rendered into a bitmap in the same format as the font
+ * bitmap, so that it is drawn with a single bitmap render. The color is
+ * not part of the key as it is applied when rendering (the bitmap is
+ * colorized).
+ *
+ * The bitmap is only created when the same run is drawn for the second
+ * time, so that text that changes all the time does not pay for it.
+ */
+typedef struct {
+	/** Link to @c gfx_font_t.text_runs (most recently used first) */
+	link_t lruns;
+	/** String */
+	char *str;
+	/** Available width if abbreviating or -1 */
+	gfx_coord_t abbr_width;
+	/** Underline */
+	bool underline;
+	/** Bitmap or @c NULL if not created yet */
+	gfx_bitmap_t *bitmap;
+	/** Bitmap rectangle relative to text start position */
+	gfx_rect_t rect;
+} gfx_text_run_t;
+
+extern void gfx_text_runs_clear(gfx_font_t *);
+
+#endif
+
+/** @}
+ */
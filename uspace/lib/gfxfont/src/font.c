@@ -44,6 +44,7 @@
 #include <stdlib.h>
 #include "../private/font.h"
 #include "../private/glyph.h"
+#include "../private/text.h"
 #include "../private/tpf_file.h"
 #include "../private/typeface.h"
 
@@ -106,6 +107,7 @@ static errno_t gfx_font_create_with_info(gfx_typeface_t *tface,
 	}
 	font->typeface = tface;
 	font->finfo = finfo;
+	list_initialize(&font->text_runs);
 
 	font->rect.p0.x = 0;
 	font->rect.p0.y = 0;
@@ -237,6 +239,8 @@ void gfx_font_close(gfx_font_t *font)
 {
 	gfx_glyph_t *glyph;
 
+	gfx_text_runs_clear(font);
+
 	glyph = gfx_font_first_glyph(font);
 	while (glyph != NULL) {
 		gfx_glyph_destroy(glyph);
@@ -266,6 +270,7 @@ void gfx_font_get_metrics(gfx_font_t *font, gfx_font_metrics_t *metrics)
 errno_t gfx_font_set_metrics(gfx_font_t *font, gfx_font_metrics_t *metrics)
 {
 	font->metrics = *metrics;
+	gfx_text_runs_clear(font);
 	return EOK;
 }
 
@@ -381,6 +386,8 @@ errno_t gfx_font_splice_at_glyph(gfx_font_t *font, gfx_glyph_t *glyph,
 	gfx_coord_t x0;
 	errno_t rc;
 
+	gfx_text_runs_clear(font);
+
 	/* Change of width of glyph */
 	dwidth = (nrect->p1.x - nrect->p0.x) -
 	    (glyph->rect.p1.x - glyph->rect.p0.x);
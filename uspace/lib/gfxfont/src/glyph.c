@@ -45,6 +45,7 @@
 #include <str.h>
 #include "../private/font.h"
 #include "../private/glyph.h"
+#include "../private/text.h"
 #include "../private/tpf_file.h"
 
 /** Initialize glyph metrics structure.
@@ -93,6 +94,7 @@ errno_t gfx_glyph_create(gfx_font_t *font, gfx_glyph_metrics_t *metrics,
 
 	glyph->metrics = *metrics;
 	list_append(&glyph->lglyphs, &glyph->font->glyphs);
+	gfx_text_runs_clear(font);
 	list_initialize(&glyph->patterns);
 
 	if (last != NULL)
@@ -117,6 +119,7 @@ errno_t gfx_glyph_create(gfx_font_t *font, gfx_glyph_metrics_t *metrics,
  */
 void gfx_glyph_destroy(gfx_glyph_t *glyph)
 {
+	gfx_text_runs_clear(glyph->font);
 	list_remove(&glyph->lglyphs);
 	free(glyph);
 }
@@ -140,6 +143,7 @@ void gfx_glyph_get_metrics(gfx_glyph_t *glyph, gfx_glyph_metrics_t *metrics)
 errno_t gfx_glyph_set_metrics(gfx_glyph_t *glyph, gfx_glyph_metrics_t *metrics)
 {
 	glyph->metrics = *metrics;
+	gfx_text_runs_clear(glyph->font);
 	return EOK;
 }
 
@@ -179,6 +183,7 @@ errno_t gfx_glyph_set_pattern(gfx_glyph_t *glyph, const char *pattern)
 	}
 
 	list_append(&pat->lpatterns, &glyph->patterns);
+	gfx_text_runs_clear(glyph->font);
 	return EOK;
 }
 
@@ -199,6 +204,7 @@ void gfx_glyph_clear_pattern(gfx_glyph_t *glyph, const char *pattern)
 			list_remove(&pat->lpatterns);
 			free(pat->text);
 			free(pat);
+			gfx_text_runs_clear(glyph->font);
 			return;
 		}
 
@@ -36,16 +36,24 @@
 #include <errno.h>
 #include <gfx/bitmap.h>
 #include <gfx/color.h>
+#include <gfx/coord.h>
 #include <gfx/font.h>
 #include <gfx/glyph.h>
 #include <gfx/render.h>
 #include <gfx/text.h>
 #include <io/pixelmap.h>
+#include <macros.h>
 #include <mem.h>
+#include <stdlib.h>
 #include <str.h>
 #include "../private/font.h"
+#include "../private/glyph.h"
+#include "../private/text.h"
 #include "../private/typeface.h"
 
+/** Number of characters decoded at a time in text mode */
+#define TEXT_DECODE_CHUNK 64
+
 /** Initialize text formatting structure.
  *
  * Text formatting structure must always be initialized using this function
@@ -114,8 +122,10 @@ static errno_t gfx_puttext_textmode(gfx_coord2_t *pos, gfx_text_fmt_t *fmt,
 	gfx_coord_t x;
 	gfx_coord_t rmargin;
 	pixel_t pixel;
+	char32_t cbuf[TEXT_DECODE_CHUNK];
 	char32_t c;
 	size_t off;
+	size_t n, i;
 	bool ellipsis;
 	errno_t rc;
 
@@ -165,13 +175,18 @@ static errno_t gfx_puttext_textmode(gfx_coord2_t *pos, gfx_text_fmt_t *fmt,
 	pmap.data = alloc.pixels;
 
 	off = 0;
-	for (x = 0; x < rmargin; x++) {
-		c = str_decode(str, &off, STR_NO_LIMIT);
-		pixel = PIXEL(attr,
-		    (c >> 16) & 0xff,
-		    (c >> 8) & 0xff,
-		    c & 0xff);
-		pixelmap_put_pixel(&pmap, x, 0, pixel);
+	x = 0;
+	while (x < rmargin) {
+		n = str_decode_buf(str, &off, STR_NO_LIMIT, cbuf,
+		    min((size_t) (rmargin - x), TEXT_DECODE_CHUNK));
+		for (i = 0; i < n; i++) {
+			c = cbuf[i];
+			pixel = PIXEL(attr,
+			    (c >> 16) & 0xff,
+			    (c >> 8) & 0xff,
+			    c & 0xff);
+			pixelmap_put_pixel(&pmap, x++, 0, pixel);
+		}
 	}
 
 	if (ellipsis) {
@@ -245,14 +260,28 @@ void gfx_text_start_pos(gfx_coord2_t *pos, gfx_text_fmt_t *fmt,
 	}
 }
 
-/** Render text.
+/** Text layout callbacks */
+typedef struct {
+	/** Place glyph with its origin at position */
+	errno_t (*glyph)(void *, gfx_glyph_t *, gfx_coord2_t *);
+	/** Fill rectangle */
+	errno_t (*fill_rect)(void *, gfx_rect_t *);
+} gfx_text_layout_cb_t;
+
+/** Lay out text.
  *
- * @param pos Anchor position
+ * Determine the glyphs and rectangles (underline) that make up the text,
+ * including ellipsis, and pass them to the callbacks in drawing order.
+ *
+ * @param spos Text starting position
  * @param fmt Text formatting
  * @param str String
+ * @param cb Layout callbacks
+ * @param arg Argument to callbacks
  * @return EOK on success or an error code
  */
-errno_t gfx_puttext(gfx_coord2_t *pos, gfx_text_fmt_t *fmt, const char *str)
+static errno_t gfx_text_layout(gfx_coord2_t *spos, gfx_text_fmt_t *fmt,
+    const char *str, gfx_text_layout_cb_t *cb, void *arg)
 {
 	gfx_glyph_metrics_t gmetrics;
 	gfx_font_metrics_t fmetrics;
@@ -260,35 +289,25 @@ errno_t gfx_puttext(gfx_coord2_t *pos, gfx_text_fmt_t *fmt, const char *str)
 	const char *cp;
 	gfx_glyph_t *glyph;
 	gfx_coord2_t cpos;
-	gfx_coord2_t spos;
 	gfx_rect_t rect;
 	gfx_coord_t width;
 	gfx_coord_t rmargin;
 	bool ellipsis;
 	errno_t rc;
 
-	gfx_text_start_pos(pos, fmt, str, &spos);
-
-	/* Text mode */
-	if ((fmt->font->finfo->props.flags & gff_text_mode) != 0)
-		return gfx_puttext_textmode(&spos, fmt, str);
-
-	rc = gfx_set_color(fmt->font->typeface->gc, fmt->color);
-	if (rc != EOK)
-		return rc;
-
 	width = gfx_text_width(fmt->font, str);
 
 	if (fmt->abbreviate && width > fmt->width) {
 		/* Need to append ellipsis */
 		ellipsis = true;
-		rmargin = spos.x + fmt->width - gfx_text_width(fmt->font, "...");
+		rmargin = spos->x + fmt->width -
+		    gfx_text_width(fmt->font, "...");
 	} else {
 		ellipsis = false;
-		rmargin = spos.x + width;
+		rmargin = spos->x + width;
 	}
 
-	cpos = spos;
+	cpos = *spos;
 	cp = str;
 	while (*cp != '\0') {
 		rc = gfx_font_search_glyph(fmt->font, cp, &glyph, &stradv);
@@ -303,7 +322,7 @@ errno_t gfx_puttext(gfx_coord2_t *pos, gfx_text_fmt_t *fmt, const char *str)
 		if (fmt->abbreviate && cpos.x + gmetrics.advance > rmargin)
 			break;
 
-		rc = gfx_glyph_render(glyph, &cpos);
+		rc = cb->glyph(arg, glyph, &cpos);
 		if (rc != EOK)
 			return rc;
 
@@ -315,12 +334,12 @@ errno_t gfx_puttext(gfx_coord2_t *pos, gfx_text_fmt_t *fmt, const char *str)
 	if (fmt->underline) {
 		gfx_font_get_metrics(fmt->font, &fmetrics);
 
-		rect.p0.x = spos.x;
-		rect.p0.y = spos.y + fmetrics.underline_y0;
+		rect.p0.x = spos->x;
+		rect.p0.y = spos->y + fmetrics.underline_y0;
 		rect.p1.x = cpos.x;
-		rect.p1.y = spos.y + fmetrics.underline_y1;
+		rect.p1.y = spos->y + fmetrics.underline_y1;
 
-		rc = gfx_fill_rect(fmt->font->typeface->gc, &rect);
+		rc = cb->fill_rect(arg, &rect);
 		if (rc != EOK)
 			return rc;
 	}
@@ -333,19 +352,19 @@ errno_t gfx_puttext(gfx_coord2_t *pos, gfx_text_fmt_t *fmt, const char *str)
 
 		gfx_glyph_get_metrics(glyph, &gmetrics);
 
-		rc = gfx_glyph_render(glyph, &cpos);
+		rc = cb->glyph(arg, glyph, &cpos);
 		if (rc != EOK)
 			return rc;
 
 		cpos.x += gmetrics.advance;
 
-		rc = gfx_glyph_render(glyph, &cpos);
+		rc = cb->glyph(arg, glyph, &cpos);
 		if (rc != EOK)
 			return rc;
 
 		cpos.x += gmetrics.advance;
 
-		rc = gfx_glyph_render(glyph, &cpos);
+		rc = cb->glyph(arg, glyph, &cpos);
 		if (rc != EOK)
 			return rc;
 	}
@@ -353,6 +372,323 @@ errno_t gfx_puttext(gfx_coord2_t *pos, gfx_text_fmt_t *fmt, const char *str)
 	return EOK;
 }
 
+static errno_t gfx_text_render_glyph(void *arg, gfx_glyph_t *glyph,
+    gfx_coord2_t *pos)
+{
+	(void) arg;
+	return gfx_glyph_render(glyph, pos);
+}
+
+static errno_t gfx_text_render_rect(void *arg, gfx_rect_t *rect)
+{
+	gfx_font_t *font = (gfx_font_t *) arg;
+
+	return gfx_fill_rect(font->typeface->gc, rect);
+}
+
+/** Layout callbacks rendering text directly to the GC */
+static gfx_text_layout_cb_t gfx_text_render_cb = {
+	.glyph = gfx_text_render_glyph,
+	.fill_rect = gfx_text_render_rect
+};
+
+static errno_t gfx_text_bounds_glyph(void *arg, gfx_glyph_t *glyph,
+    gfx_coord2_t *pos)
+{
+	gfx_rect_t *bounds = (gfx_rect_t *) arg;
+	gfx_coord2_t offs;
+	gfx_rect_t grect;
+
+	gfx_coord2_subtract(pos, &glyph->origin, &offs);
+	gfx_rect_translate(&offs, &glyph->rect, &grect);
+	gfx_rect_envelope(bounds, &grect, bounds);
+	return EOK;
+}
+
+static errno_t gfx_text_bounds_rect(void *arg, gfx_rect_t *rect)
+{
+	gfx_rect_t *bounds = (gfx_rect_t *) arg;
+
+	gfx_rect_envelope(bounds, rect, bounds);
+	return EOK;
+}
+
+/** Layout callbacks computing the bounding rectangle of text */
+static gfx_text_layout_cb_t gfx_text_bounds_cb = {
+	.glyph = gfx_text_bounds_glyph,
+	.fill_rect = gfx_text_bounds_rect
+};
+
+/** Text run being pre-rendered */
+typedef struct {
+	/** Font bitmap */
+	pixelmap_t smap;
+	/** Text run bitmap */
+	pixelmap_t dmap;
+	/** Top-left corner of text run bitmap */
+	gfx_coord2_t dorig;
+} gfx_text_prerender_t;
+
+static errno_t gfx_text_prerender_glyph(void *arg, gfx_glyph_t *glyph,
+    gfx_coord2_t *pos)
+{
+	gfx_text_prerender_t *pre = (gfx_text_prerender_t *) arg;
+	gfx_coord2_t offs;
+	gfx_coord_t x, y;
+	pixel_t pixel;
+
+	gfx_coord2_subtract(pos, &glyph->origin, &offs);
+	gfx_coord2_subtract(&offs, &pre->dorig, &offs);
+
+	for (y = glyph->rect.p0.y; y < glyph->rect.p1.y; y++) {
+		for (x = glyph->rect.p0.x; x < glyph->rect.p1.x; x++) {
+			/* Do not let background of a glyph erase others */
+			pixel = pixelmap_get_pixel(&pre->smap, x, y);
+			if (pixel != PIXEL(0, 0, 0, 0)) {
+				pixelmap_put_pixel(&pre->dmap, x + offs.x,
+				    y + offs.y, pixel);
+			}
+		}
+	}
+
+	return EOK;
+}
+
+static errno_t gfx_text_prerender_rect(void *arg, gfx_rect_t *rect)
+{
+	gfx_text_prerender_t *pre = (gfx_text_prerender_t *) arg;
+	gfx_coord_t x, y;
+
+	for (y = rect->p0.y; y < rect->p1.y; y++) {
+		for (x = rect->p0.x; x < rect->p1.x; x++) {
+			pixelmap_put_pixel(&pre->dmap, x - pre->dorig.x,
+			    y - pre->dorig.y, PIXEL(255, 255, 255, 255));
+		}
+	}
+
+	return EOK;
+}
+
+/** Layout callbacks pre-rendering text into a text run bitmap */
+static gfx_text_layout_cb_t gfx_text_prerender_cb = {
+	.glyph = gfx_text_prerender_glyph,
+	.fill_rect = gfx_text_prerender_rect
+};
+
+/** Destroy cached text run.
+ *
+ * @param run Text run
+ */
+static void gfx_text_run_destroy(gfx_text_run_t *run)
+{
+	if (run->bitmap != NULL)
+		gfx_bitmap_destroy(run->bitmap);
+	list_remove(&run->lruns);
+	free(run->str);
+	free(run);
+}
+
+/** Clear text run cache of a font.
+ *
+ * This needs to be called whenever anything affecting the appearance
+ * of text in the font changes.
+ *
+ * @param font Font
+ */
+void gfx_text_runs_clear(gfx_font_t *font)
+{
+	gfx_text_run_t *run;
+	link_t *link;
+
+	link = list_first(&font->text_runs);
+	while (link != NULL) {
+		run = list_get_instance(link, gfx_text_run_t, lruns);
+		gfx_text_run_destroy(run);
+		link = list_first(&font->text_runs);
+	}
+
+	font->text_runs_cnt = 0;
+}
+
+/** Look up text run in cache, adding it if not present.
+ *
+ * @param fmt Text formatting
+ * @param str String
+ * @param rrun Place to store pointer to text run
+ * @param rnew Place to store @c true iff the text run was just added
+ * @return EOK on success or ENOMEM if out of memory
+ */
+static errno_t gfx_text_run_get(gfx_text_fmt_t *fmt, const char *str,
+    gfx_text_run_t **rrun, bool *rnew)
+{
+	gfx_font_t *font = fmt->font;
+	gfx_coord_t abbr_width;
+	gfx_text_run_t *run;
+	link_t *link;
+
+	abbr_width = fmt->abbreviate ? fmt->width : -1;
+
+	list_foreach(font->text_runs, lruns, gfx_text_run_t, run) {
+		if (run->abbr_width == abbr_width &&
+		    run->underline == fmt->underline &&
+		    str_cmp(run->str, str) == 0) {
+			/* Move to the front */
+			list_remove(&run->lruns);
+			list_prepend(&run->lruns, &font->text_runs);
+			*rrun = run;
+			*rnew = false;
+			return EOK;
+		}
+	}
+
+	run = calloc(1, sizeof(gfx_text_run_t));
+	if (run == NULL)
+		return ENOMEM;
+
+	run->str = str_dup(str);
+	if (run->str == NULL) {
+		free(run);
+		return ENOMEM;
+	}
+
+	run->abbr_width = abbr_width;
+	run->underline = fmt->underline;
+
+	/* Evict least recently used text run if the cache is full */
+	if (font->text_runs_cnt >= GFX_TEXT_RUNS_MAX) {
+		link = list_last(&font->text_runs);
+		gfx_text_run_destroy(list_get_instance(link, gfx_text_run_t,
+		    lruns));
+		--font->text_runs_cnt;
+	}
+
+	list_prepend(&run->lruns, &font->text_runs);
+	++font->text_runs_cnt;
+
+	*rrun = run;
+	*rnew = true;
+	return EOK;
+}
+
+/** Pre-render text run into a bitmap.
+ *
+ * @param fmt Text formatting
+ * @param run Text run
+ * @return EOK on success, ENOTSUP if the text run is empty or too large
+ *         to cache, or another error code
+ */
+static errno_t gfx_text_run_prerender(gfx_text_fmt_t *fmt,
+    gfx_text_run_t *run)
+{
+	gfx_font_t *font = fmt->font;
+	gfx_text_prerender_t pre;
+	gfx_bitmap_params_t params;
+	gfx_bitmap_alloc_t salloc;
+	gfx_bitmap_alloc_t dalloc;
+	gfx_bitmap_t *bitmap;
+	gfx_coord2_t orig;
+	gfx_coord2_t dim;
+	gfx_rect_t bounds;
+	errno_t rc;
+
+	orig.x = 0;
+	orig.y = 0;
+	bounds.p0 = orig;
+	bounds.p1 = orig;
+
+	rc = gfx_text_layout(&orig, fmt, run->str, &gfx_text_bounds_cb,
+	    &bounds);
+	if (rc != EOK)
+		return rc;
+
+	gfx_coord2_subtract(&bounds.p1, &bounds.p0, &dim);
+	if (gfx_rect_is_empty(&bounds) ||
+	    dim.x * dim.y > GFX_TEXT_RUN_AREA_MAX)
+		return ENOTSUP;
+
+	rc = gfx_bitmap_get_alloc(font->bitmap, &salloc);
+	if (rc != EOK)
+		return rc;
+
+	/* Same format as the font bitmap */
+	gfx_bitmap_params_init(&params);
+	params.rect = bounds;
+	params.flags = bmpf_color_key | bmpf_colorize;
+	params.key_color = PIXEL(0, 0, 0, 0);
+
+	rc = gfx_bitmap_create(font->typeface->gc, &params, NULL, &bitmap);
+	if (rc != EOK)
+		return rc;
+
+	rc = gfx_bitmap_get_alloc(bitmap, &dalloc);
+	if (rc != EOK) {
+		gfx_bitmap_destroy(bitmap);
+		return rc;
+	}
+
+	pre.smap.width = font->rect.p1.x;
+	pre.smap.height = font->rect.p1.y;
+	pre.smap.data = salloc.pixels;
+
+	pre.dmap.width = dim.x;
+	pre.dmap.height = dim.y;
+	pre.dmap.data = dalloc.pixels;
+	pre.dorig = bounds.p0;
+
+	memset(dalloc.pixels, 0, dim.x * dim.y * sizeof(pixel_t));
+
+	rc = gfx_text_layout(&orig, fmt, run->str, &gfx_text_prerender_cb,
+	    &pre);
+	if (rc != EOK) {
+		gfx_bitmap_destroy(bitmap);
+		return rc;
+	}
+
+	run->bitmap = bitmap;
+	run->rect = bounds;
+	return EOK;
+}
+
+/** Render text.
+ *
+ * Text drawn repeatedly is pre-rendered into a bitmap the second time
+ * and then drawn with a single bitmap render.
+ *
+ * @param pos Anchor position
+ * @param fmt Text formatting
+ * @param str String
+ * @return EOK on success or an error code
+ */
+errno_t gfx_puttext(gfx_coord2_t *pos, gfx_text_fmt_t *fmt, const char *str)
+{
+	gfx_text_run_t *run;
+	gfx_coord2_t spos;
+	bool new_run;
+	errno_t rc;
+
+	gfx_text_start_pos(pos, fmt, str, &spos);
+
+	/* Text mode */
+	if ((fmt->font->finfo->props.flags & gff_text_mode) != 0)
+		return gfx_puttext_textmode(&spos, fmt, str);
+
+	rc = gfx_set_color(fmt->font->typeface->gc, fmt->color);
+	if (rc != EOK)
+		return rc;
+
+	rc = gfx_text_run_get(fmt, str, &run, &new_run);
+	if (rc == EOK && !new_run && run->bitmap == NULL) {
+		/* Seen before, try caching it. If that fails, just go on. */
+		(void) gfx_text_run_prerender(fmt, run);
+	}
+
+	if (rc == EOK && run->bitmap != NULL)
+		return gfx_bitmap_render(run->bitmap, &run->rect, &spos);
+
+	return gfx_text_layout(&spos, fmt, str, &gfx_text_render_cb,
+	    fmt->font);
+}
+
 /** Find character position in string by X coordinate.
  *
  * @param pos Anchor position
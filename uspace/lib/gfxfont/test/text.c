@@ -30,6 +30,7 @@
 #include <gfx/context.h>
 #include <gfx/font.h>
 #include <gfx/glyph.h>
+#include <gfx/glyph_bmp.h>
 #include <gfx/text.h>
 #include <gfx/typeface.h>
 #include <pcut/pcut.h>
@@ -150,6 +151,114 @@ PCUT_TEST(dummy_puttext)
 	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
 }
 
+/** Text drawn repeatedly is pre-rendered and drawn with one bitmap render */
+PCUT_TEST(puttext_run_cache)
+{
+	gfx_font_props_t props;
+	gfx_font_metrics_t metrics;
+	gfx_glyph_metrics_t gmetrics;
+	gfx_typeface_t *tface;
+	gfx_font_t *font;
+	gfx_glyph_t *glyph;
+	gfx_glyph_bmp_t *bmp;
+	gfx_context_t *gc;
+	gfx_color_t *color;
+	gfx_text_fmt_t fmt;
+	gfx_coord2_t pos;
+	test_gc_t tgc;
+	pixel_t *pixels;
+	errno_t rc;
+
+	rc = gfx_context_new(&test_ops, (void *)&tgc, &gc);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gfx_color_new_rgb_i16(0, 0, 0, &color);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gfx_typeface_create(gc, &tface);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	gfx_font_props_init(&props);
+	gfx_font_metrics_init(&metrics);
+	rc = gfx_font_create(tface, &props, &metrics, &font);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	gfx_glyph_metrics_init(&gmetrics);
+	gmetrics.advance = 2;
+
+	rc = gfx_glyph_create(font, &gmetrics, &glyph);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gfx_glyph_set_pattern(glyph, "A");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gfx_glyph_bmp_open(glyph, &bmp);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gfx_glyph_bmp_setpix(bmp, 0, 0, 1);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = gfx_glyph_bmp_setpix(bmp, 1, 1, 1);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gfx_glyph_bmp_save(bmp);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	gfx_glyph_bmp_close(bmp);
+
+	gfx_text_fmt_init(&fmt);
+	fmt.font = font;
+	fmt.color = color;
+	pos.x = 10;
+	pos.y = 20;
+
+	/* First time the text is drawn glyph by glyph */
+	tgc.bm_pixels = NULL;
+	rc = gfx_puttext(&pos, &fmt, "AA");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_NULL(tgc.bm_pixels);
+
+	/* Second time it is pre-rendered into a bitmap */
+	rc = gfx_puttext(&pos, &fmt, "AA");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_NOT_NULL(tgc.bm_pixels);
+
+	PCUT_ASSERT_INT_EQUALS(0, tgc.bm_params.rect.p0.x);
+	PCUT_ASSERT_INT_EQUALS(0, tgc.bm_params.rect.p0.y);
+	PCUT_ASSERT_INT_EQUALS(4, tgc.bm_params.rect.p1.x);
+	PCUT_ASSERT_INT_EQUALS(2, tgc.bm_params.rect.p1.y);
+	PCUT_ASSERT_INT_EQUALS(0, tgc.bm_srect.p0.x);
+	PCUT_ASSERT_INT_EQUALS(0, tgc.bm_srect.p0.y);
+	PCUT_ASSERT_INT_EQUALS(4, tgc.bm_srect.p1.x);
+	PCUT_ASSERT_INT_EQUALS(2, tgc.bm_srect.p1.y);
+	PCUT_ASSERT_INT_EQUALS(10, tgc.bm_offs.x);
+	PCUT_ASSERT_INT_EQUALS(20, tgc.bm_offs.y);
+
+	pixels = (pixel_t *) tgc.bm_pixels;
+	PCUT_ASSERT_TRUE(pixels[0] != 0);
+	PCUT_ASSERT_TRUE(pixels[1] == 0);
+	PCUT_ASSERT_TRUE(pixels[2] != 0);
+	PCUT_ASSERT_TRUE(pixels[3] == 0);
+	PCUT_ASSERT_TRUE(pixels[4] == 0);
+	PCUT_ASSERT_TRUE(pixels[5] != 0);
+	PCUT_ASSERT_TRUE(pixels[6] == 0);
+	PCUT_ASSERT_TRUE(pixels[7] != 0);
+
+	/* Afterwards the cached bitmap is reused */
+	tgc.bm_pixels = NULL;
+	pos.x = 30;
+	rc = gfx_puttext(&pos, &fmt, "AA");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_NULL(tgc.bm_pixels);
+	PCUT_ASSERT_INT_EQUALS(30, tgc.bm_offs.x);
+	PCUT_ASSERT_INT_EQUALS(20, tgc.bm_offs.y);
+
+	gfx_font_close(font);
+	gfx_typeface_destroy(tface);
+	gfx_color_delete(color);
+
+	rc = gfx_context_delete(gc);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+}
+
 /** gfx_text_start_pos() correctly computes text start position */
 PCUT_TEST(text_start_pos)
 {
@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libgfximage
+ * @{
+ */
+/**
+ * @file Decoded image cache
+ *
+ * Images loaded from files are kept decoded in a process-wide cache,
+ * so that opening the same image again only needs a copy into the new
+ * bitmap. Entries are keyed by path and requested maximum size and are
+ * validated against the identity and size of the file, since the file
+ * system does not provide modification times.
+ */
+
+#include <adt/list.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <gfx/bitmap.h>
+#include <gfximage/imgcache.h>
+#include <gfximage/tga.h>
+#include <gzip.h>
+#include <io/pixel.h>
+#include <mem.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <str.h>
+#include <vfs/vfs.h>
+
+/** Maximum total size of decoded pixels kept in the cache */
+#define GFXIMAGE_CACHE_MAX (16 * 1024 * 1024)
+
+/** Decoded image cache entry */
+typedef struct {
+	/** Link to @c cache_entries */
+	link_t lentries;
+	/** File path */
+	char *path;
+	/** Service ID of the file system holding the file */
+	service_id_t service_id;
+	/** File index */
+	fs_index_t index;
+	/** File size */
+	aoff64_t size;
+	/** Requested maximum dimensions (0, 0 for full size) */
+	gfx_coord2_t maxdim;
+	/** Bitmap rectangle */
+	gfx_rect_t rect;
+	/** Decoded pixels */
+	pixel_t *pixels;
+	/** Size of @c pixels in bytes */
+	size_t bytes;
+} gfximage_entry_t;
+
+/** Cache entries, most recently used first */
+static LIST_INITIALIZE(cache_entries);
+/** Total size of decoded pixels in the cache */
+static size_t cache_bytes;
+/** Protects the cache */
+static FIBRIL_MUTEX_INITIALIZE(cache_lock);
+
+/** Destroy cache entry.
+ *
+ * @param entry Cache entry
+ */
+static void gfximage_entry_destroy(gfximage_entry_t *entry)
+{
+	list_remove(&entry->lentries);
+	cache_bytes -= entry->bytes;
+	free(entry->pixels);
+	free(entry->path);
+	free(entry);
+}
+
+/** Find cache entry.
+ *
+ * Stale entries for the same path and size are removed.
+ *
+ * @param path File path
+ * @param stat File status
+ * @param maxdim Maximum dimensions (0, 0 for full size)
+ * @return Cache entry or @c NULL if not found
+ */
+static gfximage_entry_t *gfximage_entry_find(const char *path,
+    vfs_stat_t *stat, gfx_coord2_t *maxdim)
+{
+	assert(fibril_mutex_is_locked(&cache_lock));
+
+	list_foreach(cache_entries, lentries, gfximage_entry_t, e) {
+		if (str_cmp(e->path, path) != 0 || e->maxdim.x != maxdim->x ||
+		    e->maxdim.y != maxdim->y)
+			continue;
+
+		if (e->service_id == stat->service_id &&
+		    e->index == stat->index && e->size == stat->size) {
+			/* Move to front */
+			list_remove(&e->lentries);
+			list_prepend(&e->lentries, &cache_entries);
+			return e;
+		}
+
+		/* File has changed */
+		gfximage_entry_destroy(e);
+		return NULL;
+	}
+
+	return NULL;
+}
+
+/** Copy pixels between bitmap memory and a packed pixel array.
+ *
+ * @param rect Bitmap rectangle
+ * @param alloc Bitmap allocation
+ * @param pixels Packed pixel array
+ * @param to_bitmap @c true to copy to bitmap, @c false to copy from bitmap
+ */
+static void gfximage_copy(gfx_rect_t *rect, gfx_bitmap_alloc_t *alloc,
+    pixel_t *pixels, bool to_bitmap)
+{
+	gfx_coord2_t dims;
+	gfx_coord_t y;
+	size_t len;
+	void *row;
+
+	gfx_rect_dims(rect, &dims);
+	len = dims.x * sizeof(pixel_t);
+
+	for (y = 0; y < dims.y; y++) {
+		row = alloc->pixels + y * alloc->pitch;
+		if (to_bitmap)
+			memcpy(row, pixels + y * dims.x, len);
+		else
+			memcpy(pixels + y * dims.x, row, len);
+	}
+}
+
+/** Read file into memory.
+ *
+ * @param fd File descriptor
+ * @param size File size
+ * @param rdata Place to store pointer to file contents
+ * @return EOK on success or an error code
+ */
+static errno_t gfximage_read(int fd, size_t size, void **rdata)
+{
+	void *data;
+	size_t nread;
+	errno_t rc;
+
+	data = malloc(size);
+	if (data == NULL)
+		return ENOMEM;
+
+	rc = vfs_read(fd, (aoff64_t []) { 0 }, data, size, &nread);
+	if (rc != EOK || nread != size) {
+		free(data);
+		return rc != EOK ? rc : EIO;
+	}
+
+	*rdata = data;
+	return EOK;
+}
+
+/** Add decoded image to cache.
+ *
+ * Least recently used entries are evicted to make room. Failure
+ * to cache the image is not an error.
+ *
+ * @param path File path
+ * @param stat File status
+ * @param maxdim Maximum dimensions (0, 0 for full size)
+ * @param bitmap Bitmap containing the decoded image
+ * @param rect Bitmap rectangle
+ */
+static void gfximage_entry_add(const char *path, vfs_stat_t *stat,
+    gfx_coord2_t *maxdim, gfx_bitmap_t *bitmap, gfx_rect_t *rect)
+{
+	gfximage_entry_t *entry;
+	gfx_bitmap_alloc_t alloc;
+	gfx_coord2_t dims;
+	link_t *link;
+
+	gfx_rect_dims(rect, &dims);
+	if ((size_t) dims.x * dims.y * sizeof(pixel_t) > GFXIMAGE_CACHE_MAX)
+		return;
+
+	if (gfx_bitmap_get_alloc(bitmap, &alloc) != EOK)
+		return;
+
+	entry = calloc(1, sizeof(gfximage_entry_t));
+	if (entry == NULL)
+		return;
+
+	entry->path = str_dup(path);
+	entry->bytes = dims.x * dims.y * sizeof(pixel_t);
+	entry->pixels = malloc(entry->bytes);
+	if (entry->path == NULL || entry->pixels == NULL) {
+		free(entry->path);
+		free(entry->pixels);
+		free(entry);
+		return;
+	}
+
+	entry->service_id = stat->service_id;
+	entry->index = stat->index;
+	entry->size = stat->size;
+	entry->maxdim = *maxdim;
+	entry->rect = *rect;
+	gfximage_copy(rect, &alloc, entry->pixels, false);
+
+	fibril_mutex_lock(&cache_lock);
+
+	while (cache_bytes + entry->bytes > GFXIMAGE_CACHE_MAX) {
+		link = list_last(&cache_entries);
+		assert(link != NULL);
+		gfximage_entry_destroy(list_get_instance(link,
+		    gfximage_entry_t, lentries));
+	}
+
+	list_prepend(&entry->lentries, &cache_entries);
+	cache_bytes += entry->bytes;
+
+	fibril_mutex_unlock(&cache_lock);
+}
+
+/** Load image from file.
+ *
+ * Load a TGA or gzipped TGA image from a file and create a bitmap
+ * from it. The decoded image is cached, so opening the same unchanged
+ * file again does not decode it again.
+ *
+ * @param gc      Graphic context
+ * @param path    File path
+ * @param maxdim  Maximum bitmap dimensions (the image is decoded at
+ *                reduced size to fit) or @c NULL for full size
+ * @param rbitmap Place to store pointer to new bitmap
+ * @param rrect   Place to store bitmap rectangle
+ *
+ * @return EOK on success or an error code
+ */
+errno_t gfximage_load(gfx_context_t *gc, const char *path,
+    gfx_coord2_t *maxdim, gfx_bitmap_t **rbitmap, gfx_rect_t *rrect)
+{
+	gfximage_entry_t *entry;
+	gfx_bitmap_params_t params;
+	gfx_bitmap_alloc_t alloc;
+	gfx_bitmap_t *bitmap;
+	gfx_coord2_t mdim;
+	vfs_stat_t stat;
+	void *data;
+	size_t size;
+	void *edata;
+	size_t esize;
+	int fd;
+	errno_t rc;
+
+	if (maxdim != NULL) {
+		mdim = *maxdim;
+	} else {
+		mdim.x = 0;
+		mdim.y = 0;
+	}
+
+	rc = vfs_lookup_open(path, WALK_REGULAR, MODE_READ, &fd);
+	if (rc != EOK)
+		return rc;
+
+	rc = vfs_stat(fd, &stat);
+	if (rc != EOK) {
+		vfs_put(fd);
+		return rc;
+	}
+
+	fibril_mutex_lock(&cache_lock);
+
+	entry = gfximage_entry_find(path, &stat, &mdim);
+	if (entry != NULL) {
+		vfs_put(fd);
+
+		gfx_bitmap_params_init(&params);
+		params.rect = entry->rect;
+
+		rc = gfx_bitmap_create(gc, &params, NULL, &bitmap);
+		if (rc != EOK) {
+			fibril_mutex_unlock(&cache_lock);
+			return rc;
+		}
+
+		rc = gfx_bitmap_get_alloc(bitmap, &alloc);
+		if (rc != EOK) {
+			fibril_mutex_unlock(&cache_lock);
+			gfx_bitmap_destroy(bitmap);
+			return rc;
+		}
+
+		gfximage_copy(&entry->rect, &alloc, entry->pixels, true);
+		*rrect = entry->rect;
+		fibril_mutex_unlock(&cache_lock);
+
+		*rbitmap = bitmap;
+		return EOK;
+	}
+
+	fibril_mutex_unlock(&cache_lock);
+
+	rc = gfximage_read(fd, stat.size, &data);
+	vfs_put(fd);
+	if (rc != EOK)
+		return rc;
+
+	size = stat.size;
+
+	/* Gzipped image? */
+	if (size >= 2 && ((uint8_t *) data)[0] == 0x1f &&
+	    ((uint8_t *) data)[1] == 0x8b) {
+		rc = gzip_expand(data, size, &edata, &esize);
+		free(data);
+		if (rc != EOK)
+			return rc;
+
+		data = edata;
+		size = esize;
+	}
+
+	rc = decode_tga_scaled(gc, data, size, maxdim, &bitmap, rrect);
+	free(data);
+	if (rc != EOK)
+		return rc;
+
+	gfximage_entry_add(path, &stat, &mdim, bitmap, rrect);
+
+	*rbitmap = bitmap;
+	return EOK;
+}
+
+/** Purge decoded image cache.
+ *
+ * Free all cached decoded images.
+ */
+void gfximage_cache_purge(void)
+{
+	link_t *link;
+
+	fibril_mutex_lock(&cache_lock);
+
+	while ((link = list_first(&cache_entries)) != NULL) {
+		gfximage_entry_destroy(list_get_instance(link,
+		    gfximage_entry_t, lentries));
+	}
+
+	fibril_mutex_unlock(&cache_lock);
+}
+
+/** @}
+ */
@@ -41,7 +41,6 @@
 #include <pixconv.h>
 #include <gfx/bitmap.h>
 #include <gfximage/tga.h>
-#include <io/pixelmap.h>
 
 typedef struct {
 	uint8_t id_length;
@@ -163,28 +162,56 @@ static bool decode_tga_header(void *data, size_t size, tga_t *tga)
 	return true;
 }
 
-/** Decode Truevision TGA format
+/** Determine subsampling factor for decoding at reduced size.
+ *
+ * @param width Image width
+ * @param height Image height
+ * @param maxdim Maximum dimensions or @c NULL for full size
+ * @return Smallest factor such that the subsampled image fits @a maxdim
+ */
+static sysarg_t tga_scale_factor(sysarg_t width, sysarg_t height,
+    gfx_coord2_t *maxdim)
+{
+	sysarg_t f = 1;
+
+	if (maxdim == NULL || maxdim->x <= 0 || maxdim->y <= 0)
+		return 1;
+
+	while ((width + f - 1) / f > (sysarg_t) maxdim->x ||
+	    (height + f - 1) / f > (sysarg_t) maxdim->y)
+		++f;
+
+	return f;
+}
+
+/** Decode Truevision TGA format at reduced size
+ *
+ * Decode Truevision TGA format and create a bitmap from it. If
+ * @a maxdim is not @c NULL, the image is subsampled by the smallest
+ * integer factor which makes it fit within @a maxdim. Only the pixels
+ * which end up in the bitmap are decoded. Pixels are converted directly
+ * into the bitmap memory, one row at a time.
  *
- * Decode Truevision TGA format and create a surface
- * from it. The supported variants of TGA are currently
- * limited to uncompressed 24 bit true-color images without
- * alpha channel.
+ * The supported variants of TGA are currently limited to uncompressed
+ * 24 bit true-color images without alpha channel and 8 bit grayscale
+ * images.
  *
  * @param gc      Graphic context
- * @param data    Memory representation of gzipped TGA.
+ * @param data    Memory representation of TGA.
  * @param size    Size of the representation (in bytes).
+ * @param maxdim  Maximum bitmap dimensions or @c NULL for full size
  * @param rbitmap Place to store pointer to new bitmap
  * @param rrect   Place to store bitmap rectangle
  *
  * @return EOK un success or an error code
  */
-errno_t decode_tga(gfx_context_t *gc, void *data, size_t size,
-    gfx_bitmap_t **rbitmap, gfx_rect_t *rrect)
+errno_t decode_tga_scaled(gfx_context_t *gc, void *data, size_t size,
+    gfx_coord2_t *maxdim, gfx_bitmap_t **rbitmap, gfx_rect_t *rrect)
 {
 	gfx_bitmap_params_t params;
 	gfx_bitmap_alloc_t alloc;
 	gfx_bitmap_t *bitmap = NULL;
-	pixelmap_t pixelmap;
+	size_t bpp;
 	errno_t rc;
 
 	tga_t tga;
@@ -220,12 +247,17 @@ errno_t decode_tga(gfx_context_t *gc, void *data, size_t size,
 	if (tga.img_alpha_bpp != 0)
 		return ENOTSUP;
 
+	bpp = tga.img_bpp / 8;
+
 	sysarg_t twidth = tga.startx + tga.width;
 	sysarg_t theight = tga.starty + tga.height;
+	sysarg_t f = tga_scale_factor(twidth, theight, maxdim);
+	sysarg_t bwidth = (twidth + f - 1) / f;
+	sysarg_t bheight = (theight + f - 1) / f;
 
 	gfx_bitmap_params_init(&params);
-	params.rect.p1.x = twidth;
-	params.rect.p1.y = theight;
+	params.rect.p1.x = bwidth;
+	params.rect.p1.y = bheight;
 
 	rc = gfx_bitmap_create(gc, &params, NULL, &bitmap);
 	if (rc != EOK)
@@ -237,42 +269,40 @@ errno_t decode_tga(gfx_context_t *gc, void *data, size_t size,
 		return rc;
 	}
 
-	pixelmap.width = twidth;
-	pixelmap.height = theight;
-	pixelmap.data = alloc.pixels;
-
 	/*
 	 * TGA is encoded in a bottom-up manner, the true-color
-	 * variant is in BGR 8:8:8 encoding.
+	 * variant is in BGR 8:8:8 encoding. Bitmap row @c by shows
+	 * image row @c y, bitmap column @c bx shows column @c bx * f.
 	 */
 
-	switch (tga.img_type) {
-	case IMG_BGRA:
-		for (sysarg_t y = tga.starty; y < theight; y++) {
-			for (sysarg_t x = tga.startx; x < twidth; x++) {
-				size_t offset =
-				    ((y - tga.starty) * tga.width + (x - tga.startx)) * 3;
-
-				pixel_t pixel =
-				    bgr_888_2pixel(((uint8_t *) tga.img_data) + offset);
-				pixelmap_put_pixel(&pixelmap, x, theight - y - 1, pixel);
+	for (sysarg_t by = 0; by < bheight; by++) {
+		pixel_t *dst = (pixel_t *) (alloc.pixels + by * alloc.pitch);
+		sysarg_t y = theight - by * f - 1;
+
+		if (y < tga.starty)
+			continue;
+
+		uint8_t *src = (uint8_t *) tga.img_data +
+		    (y - tga.starty) * tga.width * bpp;
+		sysarg_t bx = (tga.startx + f - 1) / f;
+		uint8_t *sp = src + (bx * f - tga.startx) * bpp;
+
+		switch (tga.img_type) {
+		case IMG_BGRA:
+			for (; bx < bwidth; bx++) {
+				dst[bx] = bgr_888_2pixel(sp);
+				sp += f * bpp;
 			}
-		}
-		break;
-	case IMG_GRAY:
-		for (sysarg_t y = tga.starty; y < theight; y++) {
-			for (sysarg_t x = tga.startx; x < twidth; x++) {
-				size_t offset =
-				    (y - tga.starty) * tga.width + (x - tga.startx);
-
-				pixel_t pixel =
-				    gray_8_2pixel(((uint8_t *) tga.img_data) + offset);
-				pixelmap_put_pixel(&pixelmap, x, theight - y - 1, pixel);
+			break;
+		case IMG_GRAY:
+			for (; bx < bwidth; bx++) {
+				dst[bx] = gray_8_2pixel(sp);
+				sp += f * bpp;
 			}
+			break;
+		default:
+			break;
 		}
-		break;
-	default:
-		break;
 	}
 
 	*rbitmap = bitmap;
@@ -280,5 +310,24 @@ errno_t decode_tga(gfx_context_t *gc, void *data, size_t size,
 	return EOK;
 }
 
+/** Decode Truevision TGA format
+ *
+ * Decode Truevision TGA format and create a bitmap from it
+ * at full size.
+ *
+ * @param gc      Graphic context
+ * @param data    Memory representation of TGA.
+ * @param size    Size of the representation (in bytes).
+ * @param rbitmap Place to store pointer to new bitmap
+ * @param rrect   Place to store bitmap rectangle
+ *
+ * @return EOK un success or an error code
+ */
+errno_t decode_tga(gfx_context_t *gc, void *data, size_t size,
+    gfx_bitmap_t **rbitmap, gfx_rect_t *rrect)
+{
+	return decode_tga_scaled(gc, data, size, NULL, rbitmap, rrect);
+}
+
 /** @}
  */
@@ -65,6 +65,8 @@ errno_t hound_context_disconnect_target(hound_context_t *hound, const char *targ
 
 hound_stream_t *hound_stream_create(hound_context_t *hound, unsigned flags,
     pcm_format_t format, size_t bsize);
+hound_stream_t *hound_stream_create_ring(hound_context_t *hound,
+    unsigned flags, pcm_format_t format, size_t period_size, size_t periods);
 void hound_stream_destroy(hound_stream_t *stream);
 
 errno_t hound_stream_write(hound_stream_t *stream, const void *data, size_t size);
@@ -39,6 +39,8 @@
 #include <async.h>
 #include <errno.h>
 #include <pcm/format.h>
+#include <stdatomic.h>
+#include <stdint.h>
 
 extern const char *HOUND_SERVICE;
 
@@ -56,6 +58,64 @@ typedef enum {
 
 typedef async_sess_t hound_sess_t;
 
+/** Size reserved for the shared ring header, data follow it */
+#define HOUND_RING_HEADER_SIZE 64
+
+/** Header of a playback ring shared between a client and the daemon.
+ *
+ * The client writes whole periods and advances @c write_pos, the daemon
+ * mixes data from the ring and advances @c read_pos. Both positions count
+ * bytes since the ring was created, so the ring is empty when they are equal.
+ */
+typedef struct {
+	/** Bytes produced by the client */
+	atomic_size_t write_pos;
+	/** Bytes consumed by the daemon */
+	atomic_size_t read_pos;
+	/** Number of times the daemon found the ring short of data */
+	atomic_size_t xruns;
+	/** Size of one period in bytes */
+	size_t period_size;
+	/** Number of periods in the ring */
+	size_t periods;
+} hound_ring_t;
+
+/**
+ * Ring data area getter.
+ * @param ring Shared ring header.
+ * @return Pointer to the first byte of the ring data.
+ */
+static inline uint8_t *hound_ring_data(hound_ring_t *ring)
+{
+	return (uint8_t *) ring + HOUND_RING_HEADER_SIZE;
+}
+
+/**
+ * Ring data capacity getter.
+ * @param ring Shared ring header.
+ * @return Size of the ring data area in bytes.
+ */
+static inline size_t hound_ring_size(const hound_ring_t *ring)
+{
+	return ring->period_size * ring->periods;
+}
+
+/** Playback statistics of an audio device */
+typedef struct {
+	/** Number of periods played */
+	size_t periods;
+	/** Number of periods the mixer was too late for */
+	size_t xruns;
+	/** Length of one period */
+	usec_t period_usec;
+	/** Delay between mixing data and playing them */
+	usec_t latency_usec;
+	/** Time spent mixing the last period */
+	usec_t mix_usec_last;
+	/** Longest time spent mixing a period */
+	usec_t mix_usec_max;
+} hound_stats_t;
+
 typedef struct {
 } *hound_context_id_t;
 
@@ -87,11 +147,14 @@ errno_t hound_service_connect_source_sink(hound_sess_t *sess, const char *source
     const char *sink);
 errno_t hound_service_disconnect_source_sink(hound_sess_t *sess, const char *source,
     const char *sink);
+errno_t hound_service_get_stats(hound_sess_t *sess, const char *name,
+    hound_stats_t *stats);
 
 errno_t hound_service_stream_enter(async_exch_t *exch, hound_context_id_t id,
     int flags, pcm_format_t format, size_t bsize);
 errno_t hound_service_stream_drain(async_exch_t *exch);
 errno_t hound_service_stream_exit(async_exch_t *exch);
+errno_t hound_service_stream_share(async_exch_t *exch, hound_ring_t *ring);
 
 errno_t hound_service_stream_write(async_exch_t *exch, const void *data, size_t size);
 errno_t hound_service_stream_read(async_exch_t *exch, void *data, size_t size);
@@ -123,6 +186,10 @@ typedef struct hound_server_iface {
 	errno_t (*stream_data_write)(void *, void *, size_t);
 	/** Read data from the stream */
 	errno_t (*stream_data_read)(void *, void *, size_t);
+	/** Switch the stream to a shared ring of the given size */
+	errno_t (*stream_share)(void *, hound_ring_t *, size_t);
+	/** Get playback statistics of a device */
+	errno_t (*get_stats)(void *, const char *, hound_stats_t *);
 	void *server;
 } hound_server_iface_t;
 
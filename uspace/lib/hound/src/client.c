@@ -34,9 +34,13 @@
  * Common USB functions.
  */
 #include <adt/list.h>
+#include <as.h>
 #include <errno.h>
+#include <fibril.h>
 #include <inttypes.h>
 #include <loc.h>
+#include <macros.h>
+#include <mem.h>
 #include <str.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -58,6 +62,8 @@ struct hound_stream {
 	hound_context_t *context;
 	/** Stream flags */
 	int flags;
+	/** Ring shared with the daemon, NULL if data are sent over IPC */
+	hound_ring_t *ring;
 };
 
 /**
@@ -304,6 +310,7 @@ hound_stream_t *hound_stream_create(hound_context_t *hound, unsigned flags,
 		new_stream->format = format;
 		new_stream->context = hound;
 		new_stream->flags = flags;
+		new_stream->ring = NULL;
 		const errno_t ret = hound_service_stream_enter(new_stream->exch,
 		    hound->id, flags, format, bsize);
 		if (ret != EOK) {
@@ -331,10 +338,105 @@ void hound_stream_destroy(hound_stream_t *stream)
 		hound_service_stream_exit(stream->exch);
 		async_exchange_end(stream->exch);
 		list_remove(&stream->link);
+		if (stream->ring)
+			as_area_destroy(stream->ring);
 		free(stream);
 	}
 }
 
+/**
+ * Create a new playback stream that passes data through a shared ring.
+ * @param hound Hound context.
+ * @param flags new stream flags.
+ * @param format new stream PCM format.
+ * @param period_size Size of one ring period (in bytes).
+ * @param periods Number of periods in the ring.
+ * @return Valid pointer to a stream instance, NULL on failure.
+ *
+ * Writes to the stream are copied to memory shared with the daemon,
+ * which mixes them directly from the ring. No IPC is needed per write.
+ */
+hound_stream_t *hound_stream_create_ring(hound_context_t *hound,
+    unsigned flags, pcm_format_t format, size_t period_size, size_t periods)
+{
+	assert(hound);
+	const size_t frame_size = pcm_format_frame_size(&format);
+	if (hound->record || period_size == 0 || periods == 0 ||
+	    period_size % frame_size != 0 ||
+	    period_size > (SIZE_MAX - HOUND_RING_HEADER_SIZE) / periods)
+		return NULL;
+
+	const size_t size = period_size * periods;
+	hound_ring_t *ring = as_area_create(AS_AREA_ANY,
+	    HOUND_RING_HEADER_SIZE + size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (ring == AS_MAP_FAILED)
+		return NULL;
+	atomic_init(&ring->write_pos, 0);
+	atomic_init(&ring->read_pos, 0);
+	atomic_init(&ring->xruns, 0);
+	ring->period_size = period_size;
+	ring->periods = periods;
+
+	hound_stream_t *stream = hound_stream_create(hound, flags, format,
+	    size);
+	if (!stream) {
+		as_area_destroy(ring);
+		return NULL;
+	}
+	if (hound_service_stream_share(stream->exch, ring) != EOK) {
+		/* Nothing was written, there is nothing to drain */
+		stream->flags &= ~HOUND_STREAM_DRAIN_ON_EXIT;
+		hound_stream_destroy(stream);
+		as_area_destroy(ring);
+		return NULL;
+	}
+	stream->ring = ring;
+	return stream;
+}
+
+/**
+ * Copy data to the shared ring of a stream.
+ * @param stream The target stream.
+ * @param data data buffer.
+ * @param size size of the @p data buffer.
+ * @return error code.
+ *
+ * Blocks while there is less than a period (or the remaining data) of free
+ * space in the ring.
+ */
+static errno_t hound_stream_ring_write(hound_stream_t *stream,
+    const void *data, size_t size)
+{
+	hound_ring_t *ring = stream->ring;
+	const size_t ring_size = hound_ring_size(ring);
+	const usec_t period_usec =
+	    pcm_format_size_to_usec(ring->period_size, &stream->format);
+	const uint8_t *src = data;
+
+	while (size > 0) {
+		const size_t wpos = atomic_load_explicit(&ring->write_pos,
+		    memory_order_relaxed);
+		const size_t rpos = atomic_load_explicit(&ring->read_pos,
+		    memory_order_acquire);
+		const size_t space = ring_size - (wpos - rpos);
+		if (space < min(size, ring->period_size)) {
+			fibril_usleep(period_usec);
+			continue;
+		}
+
+		/* Copy up to the end of the ring and wrap around */
+		const size_t offset = wpos % ring_size;
+		const size_t count = min(min(size, space), ring_size - offset);
+		memcpy(hound_ring_data(ring) + offset, src, count);
+		atomic_store_explicit(&ring->write_pos, wpos + count,
+		    memory_order_release);
+		src += count;
+		size -= count;
+	}
+	return EOK;
+}
+
 /**
  * Send new data to a stream.
  * @param stream The target stream
@@ -347,6 +449,8 @@ errno_t hound_stream_write(hound_stream_t *stream, const void *data, size_t size
 	assert(stream);
 	if (!data || size == 0)
 		return EBADMEM;
+	if (stream->ring)
+		return hound_stream_ring_write(stream, data, size);
 	return hound_service_stream_write(stream->exch, data, size);
 }
 
@@ -34,6 +34,7 @@
  * Common USB functions.
  */
 #include <adt/list.h>
+#include <as.h>
 #include <errno.h>
 #include <loc.h>
 #include <macros.h>
@@ -64,6 +65,10 @@ enum ipc_methods {
 	IPC_M_HOUND_STREAM_EXIT,
 	/** Wait until there is no data in the stream */
 	IPC_M_HOUND_STREAM_DRAIN,
+	/** Switch stream to a shared ring buffer */
+	IPC_M_HOUND_STREAM_SHARE,
+	/** Get playback statistics of a device */
+	IPC_M_HOUND_GET_STATS,
 };
 
 /** PCM format conversion helper structure */
@@ -294,6 +299,39 @@ errno_t hound_service_disconnect_source_sink(hound_sess_t *sess, const char *sou
 	return ENOTSUP;
 }
 
+/**
+ * Get playback statistics of an audio device.
+ * @param sess Valid audio session.
+ * @param name Device sink name, valid string.
+ * @param stats Place to store the statistics.
+ * @return Error code.
+ */
+errno_t hound_service_get_stats(hound_sess_t *sess, const char *name,
+    hound_stats_t *stats)
+{
+	assert(sess);
+	assert(name);
+	assert(stats);
+
+	async_exch_t *exch = async_exchange_begin(sess);
+	if (!exch)
+		return ENOMEM;
+	ipc_call_t call;
+	aid_t id = async_send_0(exch, IPC_M_HOUND_GET_STATS, &call);
+	errno_t ret = id ? EOK : EPARTY;
+	if (ret == EOK)
+		ret = async_data_write_start(exch, name, str_size(name));
+	if (ret == EOK)
+		ret = async_data_read_start(exch, stats, sizeof(*stats));
+	async_exchange_end(exch);
+	if (ret != EOK) {
+		async_forget(id);
+		return ret;
+	}
+	async_wait_for(id, &ret);
+	return ret;
+}
+
 /**
  * Switch IPC exchange to a STREAM mode.
  * @param exch IPC exchange.
@@ -328,6 +366,29 @@ errno_t hound_service_stream_exit(async_exch_t *exch)
 	return async_req_0_0(exch, IPC_M_HOUND_STREAM_EXIT);
 }
 
+/**
+ * Replace stream data transfers by a shared ring buffer.
+ * @param exch IPC exchange in STREAM MODE.
+ * @param ring Initialized ring header at the start of an address space area.
+ * @return Error code.
+ *
+ * The daemon mixes data directly from the ring after this call succeeds,
+ * written data no longer need to be sent by hound_service_stream_write().
+ */
+errno_t hound_service_stream_share(async_exch_t *exch, hound_ring_t *ring)
+{
+	ipc_call_t call;
+	aid_t id = async_send_0(exch, IPC_M_HOUND_STREAM_SHARE, &call);
+	errno_t ret = async_share_out_start(exch, ring,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE);
+	if (ret != EOK) {
+		async_forget(id);
+		return ret;
+	}
+	async_wait_for(id, &ret);
+	return ret;
+}
+
 /**
  * Wait until the server side buffer is empty.
  * @param exch IPC exchange.
@@ -368,6 +429,8 @@ errno_t hound_service_stream_read(async_exch_t *exch, void *data, size_t size)
 
 static void hound_server_read_data(void *stream);
 static void hound_server_write_data(void *stream);
+static void hound_server_share_ring(void *stream, ipc_call_t *icall);
+static void hound_server_get_stats(ipc_call_t *icall);
 static const hound_server_iface_t *server_iface;
 
 /**
@@ -608,8 +671,12 @@ void hound_connection_handler(ipc_call_t *icall, void *arg)
 				}
 			}
 			break;
+		case IPC_M_HOUND_GET_STATS:
+			hound_server_get_stats(&call);
+			break;
 		case IPC_M_HOUND_STREAM_EXIT:
 		case IPC_M_HOUND_STREAM_DRAIN:
+		case IPC_M_HOUND_STREAM_SHARE:
 			/* Stream exit/drain is only allowed in stream context */
 			async_answer_0(&call, EINVAL);
 			break;
@@ -637,9 +704,10 @@ static void hound_server_read_data(void *stream)
 	size_t size = 0;
 	errno_t ret_answer = EOK;
 
-	/* accept data write or drain */
+	/* accept data write, drain or ring share */
 	while (async_data_write_receive(&call, &size) ||
-	    (ipc_get_imethod(&call) == IPC_M_HOUND_STREAM_DRAIN)) {
+	    (ipc_get_imethod(&call) == IPC_M_HOUND_STREAM_DRAIN) ||
+	    (ipc_get_imethod(&call) == IPC_M_HOUND_STREAM_SHARE)) {
 		/* check drain first */
 		if (ipc_get_imethod(&call) == IPC_M_HOUND_STREAM_DRAIN) {
 			errno_t ret = ENOTSUP;
@@ -648,6 +716,10 @@ static void hound_server_read_data(void *stream)
 			async_answer_0(&call, ret);
 			continue;
 		}
+		if (ipc_get_imethod(&call) == IPC_M_HOUND_STREAM_SHARE) {
+			hound_server_share_ring(stream, &call);
+			continue;
+		}
 
 		/* there was an error last time */
 		if (ret_answer != EOK) {
@@ -717,6 +789,86 @@ static void hound_server_write_data(void *stream)
 	async_answer_0(&call, ret);
 }
 
+/**
+ * Accept a shared ring and attach it to the stream.
+ * @param stream target stream.
+ * @param icall IPC_M_HOUND_STREAM_SHARE call.
+ */
+static void hound_server_share_ring(void *stream, ipc_call_t *icall)
+{
+	ipc_call_t call;
+	size_t size;
+	unsigned int flags;
+	void *area;
+
+	if (!async_share_out_receive(&call, &size, &flags)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	if (!server_iface->stream_share ||
+	    (flags & (AS_AREA_READ | AS_AREA_WRITE)) !=
+	    (AS_AREA_READ | AS_AREA_WRITE) || size < HOUND_RING_HEADER_SIZE) {
+		async_answer_0(&call, ENOTSUP);
+		async_answer_0(icall, ENOTSUP);
+		return;
+	}
+
+	errno_t ret = async_share_out_finalize(&call, &area);
+	if (ret != EOK || area == AS_MAP_FAILED) {
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	ret = server_iface->stream_share(stream, area, size);
+	if (ret != EOK)
+		as_area_destroy(area);
+	async_answer_0(icall, ret);
+}
+
+/**
+ * Answer device statistics query.
+ * @param icall IPC_M_HOUND_GET_STATS call.
+ */
+static void hound_server_get_stats(ipc_call_t *icall)
+{
+	hound_stats_t stats = { 0 };
+	ipc_call_t call;
+	size_t size;
+	char *name = NULL;
+
+	errno_t ret = async_data_write_accept((void **)&name, true, 0, 0, 0,
+	    0);
+	if (ret != EOK) {
+		async_answer_0(icall, ret);
+		return;
+	}
+
+	if (!server_iface->get_stats)
+		ret = ENOTSUP;
+	else
+		ret = server_iface->get_stats(server_iface->server, name,
+		    &stats);
+	free(name);
+
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+	if (ret != EOK || size != sizeof(stats)) {
+		if (ret == EOK)
+			ret = EINVAL;
+		async_answer_0(&call, ret);
+		async_answer_0(icall, ret);
+		return;
+	}
+
+	ret = async_data_read_finalize(&call, &stats, size);
+	async_answer_0(icall, ret);
+}
+
 /*
  * SERVER SIDE
  */
@@ -52,6 +52,10 @@ typedef struct {
 
 	size_t buffer_size;
 	receive_buffer_t recv_buffer;
+
+	/** Request buffer kept for the following requests */
+	char *send_buffer;
+	size_t send_buffer_size;
 } http_t;
 
 typedef struct {
@@ -63,10 +67,14 @@ typedef struct {
 	link_t link;
 	char *name;
 	char *value;
+	/** Header and its strings are stored in the arena of the list */
+	bool in_arena;
 } http_header_t;
 
 typedef struct {
 	list_t list;
+	/** Single allocation holding received headers, or NULL */
+	void *arena;
 } http_headers_t;
 
 typedef struct {
@@ -82,6 +90,21 @@ typedef struct {
 	http_headers_t headers;
 } http_response_t;
 
+/** Reader of a response body */
+typedef struct {
+	http_t *http;
+	/** Body uses the chunked transfer coding */
+	bool chunked;
+	/** Body length is given by Content-Length */
+	bool sized;
+	/** Bytes left in the body if sized or in the current chunk */
+	uint64_t remaining;
+	/** Whole body has been read */
+	bool done;
+	/** Connection may be reused for another request */
+	bool keep_alive;
+} http_body_t;
+
 extern http_t *http_create(const char *, uint16_t);
 extern errno_t http_connect(http_t *);
 
@@ -124,6 +147,7 @@ static inline void http_headers_append_header(http_headers_t *headers,
 
 extern http_request_t *http_request_create(const char *, const char *);
 extern void http_request_destroy(http_request_t *);
+extern errno_t http_request_set_range(http_request_t *, uint64_t, uint64_t);
 extern errno_t http_request_format(http_request_t *, char **, size_t *);
 extern errno_t http_send_request(http_t *, http_request_t *);
 extern errno_t http_receive_status(receive_buffer_t *, http_version_t *, uint16_t *,
@@ -131,6 +155,13 @@ extern errno_t http_receive_status(receive_buffer_t *, http_version_t *, uint16_
 extern errno_t http_receive_response(receive_buffer_t *, http_response_t **,
     size_t, unsigned);
 extern void http_response_destroy(http_response_t *);
+extern errno_t http_response_content_length(http_response_t *, uint64_t *);
+extern errno_t http_response_content_range(http_response_t *, uint64_t *,
+    uint64_t *, uint64_t *);
+extern bool http_response_keep_alive(http_response_t *);
+extern void http_body_init(http_body_t *, http_t *, http_response_t *);
+extern errno_t http_body_read(http_body_t *, void *, size_t, size_t *);
+extern bool http_body_reusable(http_body_t *);
 extern errno_t http_close(http_t *);
 extern void http_destroy(http_t *);
 
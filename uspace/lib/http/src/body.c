@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup http
+ * @{
+ */
+/**
+ * @file
+ * Reading of response bodies.
+ *
+ * The body is delimited by Content-Length, by the chunked transfer coding
+ * or by the server closing the connection. Only the first two leave the
+ * connection usable for another request. Data are received straight into
+ * the buffer of the caller whenever the receive buffer is empty.
+ */
+
+#include <errno.h>
+#include <macros.h>
+#include <stdbool.h>
+#include <str.h>
+
+#include <http/http.h>
+#include <http/receive-buffer.h>
+
+/** Maximum length of a chunk size line including extensions */
+#define HTTP_CHUNK_LINE_MAX  128
+
+/** Start reading a response body.
+ *
+ * Must be called right after receiving the response headers.
+ *
+ * @param body Body reader to initialize
+ * @param http HTTP connection the response was received over
+ * @param resp Received response
+ */
+void http_body_init(http_body_t *body, http_t *http, http_response_t *resp)
+{
+	char *value;
+
+	body->http = http;
+	body->chunked = false;
+	body->sized = false;
+	body->remaining = 0;
+	body->done = false;
+	body->keep_alive = http_response_keep_alive(resp);
+
+	/* These responses never carry a body */
+	if ((resp->status >= 100 && resp->status < 200) ||
+	    resp->status == 204 || resp->status == 304) {
+		body->sized = true;
+		body->done = true;
+		return;
+	}
+
+	if (http_headers_get(&resp->headers, "Transfer-Encoding",
+	    &value) == EOK && str_casecmp(value, "identity") != 0) {
+		/* Chunked has to be the last coding applied */
+		size_t len = str_size(value);
+		if (len >= 7 && str_casecmp(value + len - 7, "chunked") == 0) {
+			body->chunked = true;
+			return;
+		}
+
+		body->keep_alive = false;
+		return;
+	}
+
+	if (http_response_content_length(resp, &body->remaining) == EOK) {
+		body->sized = true;
+		body->done = (body->remaining == 0);
+		return;
+	}
+
+	/* The body extends up to the end of the connection */
+	body->keep_alive = false;
+}
+
+/** Receive the size line of the next chunk.
+ *
+ * The trailer following the last chunk is discarded.
+ *
+ * @param body Body reader
+ * @return EOK on success or an error code
+ */
+static errno_t http_body_chunk_start(http_body_t *body)
+{
+	receive_buffer_t *rb = &body->http->recv_buffer;
+	char line[HTTP_CHUNK_LINE_MAX];
+	size_t nrecv;
+
+	errno_t rc = recv_line(rb, line, sizeof(line), &nrecv);
+	if (rc != EOK)
+		return rc;
+
+	/* Chunk extensions after the size are ignored */
+	const char *end;
+	rc = str_uint64_t(line, &end, 16, false, &body->remaining);
+	if (rc != EOK || end == line || (*end != '\0' && *end != ';' &&
+	    *end != ' ' && *end != '\t'))
+		return HTTP_EPARSE;
+
+	if (body->remaining > 0)
+		return EOK;
+
+	/* Last chunk, skip the trailer up to the empty line */
+	do {
+		rc = recv_line(rb, line, sizeof(line), &nrecv);
+		if (rc != EOK)
+			return rc;
+	} while (line[0] != '\0');
+
+	body->done = true;
+	return EOK;
+}
+
+/** Read data of a response body.
+ *
+ * @param body   Body reader
+ * @param buf    Buffer to read into
+ * @param size   Size of @a buf
+ * @param nread  Place to store the number of bytes read, zero at the end
+ *               of the body
+ * @return EOK on success or an error code
+ */
+errno_t http_body_read(http_body_t *body, void *buf, size_t size,
+    size_t *nread)
+{
+	receive_buffer_t *rb = &body->http->recv_buffer;
+	errno_t rc;
+
+	*nread = 0;
+
+	if (body->chunked && !body->done && body->remaining == 0) {
+		rc = http_body_chunk_start(body);
+		if (rc != EOK)
+			return rc;
+	}
+
+	if (body->done || size == 0)
+		return EOK;
+
+	if (body->chunked || body->sized)
+		size = min(size, body->remaining);
+
+	size_t nrecv;
+	rc = recv_buffer(rb, buf, size, &nrecv);
+	if (rc != EOK)
+		return rc;
+
+	if (nrecv == 0) {
+		/* Connection closed by the server */
+		body->keep_alive = false;
+		body->done = true;
+		return (body->chunked || body->sized) ? EIO : EOK;
+	}
+
+	*nread = nrecv;
+
+	if (!body->chunked && !body->sized)
+		return EOK;
+
+	body->remaining -= nrecv;
+	if (body->remaining > 0)
+		return EOK;
+
+	if (body->sized) {
+		body->done = true;
+		return EOK;
+	}
+
+	/* Each chunk is terminated by an end of line */
+	rc = recv_eol(rb, &nrecv);
+	if (rc == EOK && nrecv == 0)
+		rc = HTTP_EPARSE;
+	return rc;
+}
+
+/** Determine whether the connection can carry another request.
+ *
+ * @param body Body reader
+ * @return @c true if the whole body has been read and the server keeps
+ *         the connection open
+ */
+bool http_body_reusable(http_body_t *body)
+{
+	return body->done && body->keep_alive;
+}
+
+/** @}
+ */
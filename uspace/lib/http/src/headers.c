@@ -49,6 +49,7 @@ void http_header_init(http_header_t *header)
 	link_initialize(&header->link);
 	header->name = NULL;
 	header->value = NULL;
+	header->in_arena = false;
 }
 
 http_header_t *http_header_create(const char *name, const char *value)
@@ -76,6 +77,10 @@ http_header_t *http_header_create(const char *name, const char *value)
 
 void http_header_destroy(http_header_t *header)
 {
+	/* Freed together with the arena by http_headers_clear() */
+	if (header->in_arena)
+		return;
+
 	free(header->name);
 	free(header->value);
 	free(header);
@@ -254,6 +259,7 @@ bool http_header_name_match(const char *name_a, const char *name_b)
 void http_headers_init(http_headers_t *headers)
 {
 	list_initialize(&headers->list);
+	headers->arena = NULL;
 }
 
 errno_t http_headers_find_single(http_headers_t *headers, const char *name,
@@ -300,6 +306,18 @@ errno_t http_headers_set(http_headers_t *headers, const char *name,
 	if (rc == HTTP_EMISSING_HEADER)
 		return http_headers_append(headers, name, value);
 
+	if (header->in_arena) {
+		/* The strings of a received header cannot be reallocated */
+		http_header_t *new_header = http_header_create(header->name,
+		    value);
+		if (new_header == NULL)
+			return ENOMEM;
+
+		list_insert_after(&new_header->link, &header->link);
+		http_headers_remove(headers, header);
+		return EOK;
+	}
+
 	char *new_value = str_dup(value);
 	if (new_value == NULL)
 		return ENOMEM;
@@ -320,12 +338,181 @@ errno_t http_headers_get(http_headers_t *headers, const char *name, char **value
 	return EOK;
 }
 
+/** Find the end of a header block in the receive buffer.
+ *
+ * More data are received until the empty line terminating the block is
+ * buffered. Lines are found by scanning the buffer with memchr().
+ *
+ * @param rb   Receive buffer
+ * @param size Place to store the size of the block without the
+ *             terminating empty line
+ * @return EOK on success, ELIMIT if the block does not fit in the buffer
+ *         or another error code
+ */
+static errno_t http_headers_block_find(receive_buffer_t *rb, size_t *size)
+{
+	/* Start of the current line relative to the read position */
+	size_t line = 0;
+
+	while (true) {
+		const char *start = rb->buffer + rb->out;
+		size_t avail = rb->in - rb->out;
+
+		while (line < avail) {
+			const char *eol = memchr(start + line, '\n',
+			    avail - line);
+			if (eol == NULL)
+				break;
+
+			size_t len = eol - (start + line);
+			if (len == 0 || (len == 1 && start[line] == '\r')) {
+				*size = line;
+				return EOK;
+			}
+
+			line = eol - start + 1;
+		}
+
+		errno_t rc = recv_fill(rb);
+		if (rc != EOK)
+			return rc;
+	}
+}
+
+/** Parse a header block present in the receive buffer.
+ *
+ * The block is copied once into an arena owned by the header list and
+ * the headers point into the copy, so that no further allocations are
+ * needed regardless of the number of headers. The block is consumed
+ * only on success.
+ *
+ * @param rb          Receive buffer
+ * @param headers     Header list to append the headers to
+ * @param size        Size of the block as found by
+ *                    http_headers_block_find()
+ * @param limit_alloc Maximum total size of header names and values or
+ *                    zero for no limit
+ * @param limit_count Maximum number of headers or zero for no limit
+ * @return EOK on success or an error code
+ */
+static errno_t http_headers_block_parse(receive_buffer_t *rb,
+    http_headers_t *headers, size_t size, size_t limit_alloc,
+    unsigned limit_count)
+{
+	const char *block = rb->buffer + rb->out;
+	const char *block_end = block + size;
+
+	if (size == 0)
+		return EOK;
+
+	if (memchr(block, '\0', size) != NULL)
+		return EIO;
+
+	/* A continuation line cannot come first */
+	if (block[0] == ' ' || block[0] == '\t')
+		return EINVAL;
+
+	unsigned count = 0;
+	const char *p = block;
+	while (p < block_end) {
+		if (*p != ' ' && *p != '\t')
+			count++;
+		p = (const char *) memchr(p, '\n', block_end - p) + 1;
+	}
+
+	if (limit_count > 0 && count > limit_count)
+		return ELIMIT;
+
+	http_header_t *hdrs = malloc(count * sizeof(http_header_t) + size + 1);
+	if (hdrs == NULL)
+		return ENOMEM;
+
+	char *text = (char *) (hdrs + count);
+	char *end = text + size;
+	memcpy(text, block, size);
+	*end = '\0';
+
+	errno_t rc = EOK;
+	size_t used = 0;
+	char *line = text;
+	for (unsigned i = 0; i < count; i++) {
+		char *eol = memchr(line, '\n', end - line);
+
+		/* Join folded lines into a single value */
+		while (eol + 1 < end && (eol[1] == ' ' || eol[1] == '\t')) {
+			*eol = ' ';
+			if (eol[-1] == '\r')
+				eol[-1] = ' ';
+			eol = memchr(eol + 1, '\n', end - eol - 1);
+		}
+
+		char *line_end = eol;
+		if (line_end > line && line_end[-1] == '\r')
+			line_end--;
+		*line_end = '\0';
+
+		char *colon = memchr(line, ':', line_end - line);
+		if (colon == NULL) {
+			rc = EINVAL;
+			goto error;
+		}
+
+		for (char *c = line; c < colon; c++) {
+			if (!is_token(*c)) {
+				rc = EINVAL;
+				goto error;
+			}
+		}
+		*colon = '\0';
+
+		char *value = colon + 1;
+		while (*value == ' ' || *value == '\t')
+			value++;
+
+		used += (colon - line) + (line_end - value);
+		if (limit_alloc > 0 && used > limit_alloc) {
+			rc = ELIMIT;
+			goto error;
+		}
+
+		http_header_init(&hdrs[i]);
+		hdrs[i].name = line;
+		hdrs[i].value = value;
+		hdrs[i].in_arena = true;
+
+		line = eol + 1;
+	}
+
+	for (unsigned i = 0; i < count; i++)
+		http_headers_append_header(headers, &hdrs[i]);
+
+	headers->arena = hdrs;
+	rb->out += size;
+	return EOK;
+error:
+	free(hdrs);
+	return rc;
+}
+
 errno_t http_headers_receive(receive_buffer_t *rb, http_headers_t *headers,
     size_t limit_alloc, unsigned limit_count)
 {
 	errno_t rc = EOK;
 	unsigned added = 0;
 
+	if (headers->arena == NULL) {
+		size_t size;
+		rc = http_headers_block_find(rb, &size);
+		if (rc == EOK) {
+			return http_headers_block_parse(rb, headers, size,
+			    limit_alloc, limit_count);
+		}
+
+		/* Blocks larger than the buffer are received piecewise */
+		if (rc != ELIMIT)
+			return rc;
+	}
+
 	while (true) {
 		char c = 0;
 		rc = recv_char(rb, &c, false);
@@ -380,6 +567,9 @@ void http_headers_clear(http_headers_t *headers)
 		http_header_destroy(header);
 		link = next;
 	}
+
+	free(headers->arena);
+	headers->arena = NULL;
 }
 
 /** @}
@@ -66,6 +66,10 @@ http_t *http_create(const char *host, uint16_t port)
 		return NULL;
 	}
 	http->port = port;
+	http->tcp = NULL;
+	http->conn = NULL;
+	http->send_buffer = NULL;
+	http->send_buffer_size = 0;
 
 	http->buffer_size = 4096;
 	errno_t rc = recv_buffer_init(&http->recv_buffer, http->buffer_size,
@@ -119,6 +123,9 @@ errno_t http_close(http_t *http)
 	tcp_destroy(http->tcp);
 	http->tcp = NULL;
 
+	/* Whatever is left over belongs to the old connection */
+	recv_reset(&http->recv_buffer);
+
 	return EOK;
 }
 
@@ -126,6 +133,7 @@ void http_destroy(http_t *http)
 {
 	(void) http_close(http);
 	recv_buffer_fini(&http->recv_buffer);
+	free(http->send_buffer);
 	free(http);
 }
 
@@ -144,35 +144,55 @@ errno_t recv_cut_str(receive_buffer_t *rb, receive_buffer_mark_t *a, receive_buf
 	return EOK;
 }
 
+/** Receive more data into the buffer.
+ *
+ * Data not consumed yet and data following any mark are kept. The buffer
+ * is compacted if there is no free space at its end.
+ *
+ * @return EOK on success, ELIMIT if the buffer is full, EIO at the end
+ *         of data or another error code
+ */
+errno_t recv_fill(receive_buffer_t *rb)
+{
+	size_t free = rb->size - rb->in;
+	if (free == 0) {
+		size_t keep = rb->out;
+		list_foreach(rb->marks, link, receive_buffer_mark_t, mark) {
+			keep = min(keep, mark->offset);
+		}
+
+		if (keep == 0)
+			return ELIMIT;
+
+		memmove(rb->buffer, rb->buffer + keep, rb->in - keep);
+		rb->in -= keep;
+		rb->out -= keep;
+		free = rb->size - rb->in;
+		list_foreach(rb->marks, link, receive_buffer_mark_t, mark) {
+			mark->offset -= keep;
+		}
+	}
+
+	size_t nrecv;
+	errno_t rc = rb->receive(rb->client_data, rb->buffer + rb->in, free, &nrecv);
+	if (rc != EOK)
+		return rc;
+
+	/* End of data */
+	if (nrecv == 0)
+		return EIO;
+
+	rb->in += nrecv;
+	return EOK;
+}
+
 /** Receive one character (with buffering) */
 errno_t recv_char(receive_buffer_t *rb, char *c, bool consume)
 {
 	if (rb->out == rb->in) {
-		size_t free = rb->size - rb->in;
-		if (free == 0) {
-			size_t min_mark = rb->size;
-			list_foreach(rb->marks, link, receive_buffer_mark_t, mark) {
-				min_mark = min(min_mark, mark->offset);
-			}
-
-			if (min_mark == 0)
-				return ELIMIT;
-
-			size_t new_in = rb->in - min_mark;
-			memmove(rb->buffer, rb->buffer + min_mark, new_in);
-			rb->out = rb->in = new_in;
-			free = rb->size - rb->in;
-			list_foreach(rb->marks, link, receive_buffer_mark_t, mark) {
-				mark->offset -= min_mark;
-			}
-		}
-
-		size_t nrecv;
-		errno_t rc = rb->receive(rb->client_data, rb->buffer + rb->in, free, &nrecv);
+		errno_t rc = recv_fill(rb);
 		if (rc != EOK)
 			return rc;
-
-		rb->in = nrecv;
 	}
 
 	*c = rb->buffer[rb->out];
@@ -34,6 +34,7 @@
  */
 
 #include <errno.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
@@ -78,16 +79,37 @@ void http_request_destroy(http_request_t *req)
 	free(req);
 }
 
+/** Request only a range of the resource.
+ *
+ * @param req   Request
+ * @param first Offset of the first byte requested
+ * @param last  Offset of the last byte requested
+ * @return EOK on success, EINVAL if the range is empty or ENOMEM
+ */
+errno_t http_request_set_range(http_request_t *req, uint64_t first,
+    uint64_t last)
+{
+	if (last < first)
+		return EINVAL;
+
+	char *value;
+	if (asprintf(&value, "bytes=%" PRIu64 "-%" PRIu64, first, last) < 0)
+		return ENOMEM;
+
+	errno_t rc = http_headers_set(&req->headers, "Range", value);
+	free(value);
+	return rc;
+}
+
 static ssize_t http_encode_method(char *buf, size_t buf_size,
     const char *method, const char *path)
 {
 	return snprintf(buf, buf_size, HTTP_METHOD_LINE, method, path);
 }
 
-errno_t http_request_format(http_request_t *req, char **out_buf,
-    size_t *out_buf_size)
+/** Compute the size of a formatted request. */
+static errno_t http_request_size(http_request_t *req, size_t *out_size)
 {
-	/* Compute the size of the request */
 	ssize_t meth_size = http_encode_method(NULL, 0, req->method, req->path);
 	if (meth_size < 0)
 		return EINVAL;
@@ -101,26 +123,26 @@ errno_t http_request_format(http_request_t *req, char **out_buf,
 	}
 	size += str_length(HTTP_REQUEST_LINE);
 
-	char *buf = malloc(size);
-	if (buf == NULL)
-		return ENOMEM;
+	*out_size = size;
+	return EOK;
+}
 
+/** Format a request into a buffer of the size given by http_request_size(). */
+static errno_t http_request_encode(http_request_t *req, char *buf,
+    size_t size)
+{
 	char *pos = buf;
 	size_t pos_size = size;
 	ssize_t written = http_encode_method(pos, pos_size, req->method, req->path);
-	if (written < 0) {
-		free(buf);
+	if (written < 0)
 		return EINVAL;
-	}
 	pos += written;
 	pos_size -= written;
 
 	http_headers_foreach(req->headers, header) {
 		written = http_header_encode(header, pos, pos_size);
-		if (written < 0) {
-			free(buf);
+		if (written < 0)
 			return EINVAL;
-		}
 		pos += written;
 		pos_size -= written;
 	}
@@ -130,24 +152,62 @@ errno_t http_request_format(http_request_t *req, char **out_buf,
 	pos_size -= rlsize;
 	assert(pos_size == 0);
 
+	return EOK;
+}
+
+errno_t http_request_format(http_request_t *req, char **out_buf,
+    size_t *out_buf_size)
+{
+	size_t size;
+	errno_t rc = http_request_size(req, &size);
+	if (rc != EOK)
+		return rc;
+
+	char *buf = malloc(size);
+	if (buf == NULL)
+		return ENOMEM;
+
+	rc = http_request_encode(req, buf, size);
+	if (rc != EOK) {
+		free(buf);
+		return rc;
+	}
+
 	*out_buf = buf;
 	*out_buf_size = size;
 	return EOK;
 }
 
+/** Send a request.
+ *
+ * The request is formatted into a buffer which is kept for the following
+ * requests over the connection.
+ *
+ * @param http HTTP connection
+ * @param req  Request
+ * @return EOK on success or an error code
+ */
 errno_t http_send_request(http_t *http, http_request_t *req)
 {
-	char *buf = NULL;
-	size_t buf_size = 0;
-
-	errno_t rc = http_request_format(req, &buf, &buf_size);
+	size_t size;
+	errno_t rc = http_request_size(req, &size);
 	if (rc != EOK)
 		return rc;
 
-	rc = tcp_conn_send(http->conn, buf, buf_size);
-	free(buf);
+	if (size > http->send_buffer_size) {
+		char *buf = realloc(http->send_buffer, size);
+		if (buf == NULL)
+			return ENOMEM;
 
-	return rc;
+		http->send_buffer = buf;
+		http->send_buffer_size = size;
+	}
+
+	rc = http_request_encode(req, http->send_buffer, size);
+	if (rc != EOK)
+		return rc;
+
+	return tcp_conn_send(http->conn, http->send_buffer, size);
 }
 
 /** @}
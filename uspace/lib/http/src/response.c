@@ -34,6 +34,7 @@
  */
 
 #include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
@@ -227,5 +228,91 @@ void http_response_destroy(http_response_t *resp)
 	free(resp);
 }
 
+/** Get the length of the response body.
+ *
+ * @param resp   Response
+ * @param length Place to store the value of the Content-Length header
+ * @return EOK on success, HTTP_EMISSING_HEADER if the header is not
+ *         present or another error code
+ */
+errno_t http_response_content_length(http_response_t *resp, uint64_t *length)
+{
+	char *value;
+	errno_t rc = http_headers_get(&resp->headers, "Content-Length", &value);
+	if (rc != EOK)
+		return rc;
+
+	rc = str_uint64_t(value, NULL, 10, true, length);
+	if (rc != EOK)
+		return HTTP_EPARSE;
+
+	return EOK;
+}
+
+/** Get the range of the resource carried by a partial response.
+ *
+ * @param resp  Response
+ * @param first Place to store the offset of the first byte
+ * @param last  Place to store the offset of the last byte
+ * @param total Place to store the size of the whole resource or
+ *              UINT64_MAX if the server does not know it
+ * @return EOK on success, HTTP_EMISSING_HEADER if the response has no
+ *         Content-Range header or another error code
+ */
+errno_t http_response_content_range(http_response_t *resp, uint64_t *first,
+    uint64_t *last, uint64_t *total)
+{
+	char *value;
+	errno_t rc = http_headers_get(&resp->headers, "Content-Range", &value);
+	if (rc != EOK)
+		return rc;
+
+	if (str_lcasecmp(value, "bytes ", 6) != 0)
+		return HTTP_EPARSE;
+
+	const char *pos = value + 6;
+	rc = str_uint64_t(pos, &pos, 10, false, first);
+	if (rc != EOK || *pos != '-')
+		return HTTP_EPARSE;
+
+	rc = str_uint64_t(pos + 1, &pos, 10, false, last);
+	if (rc != EOK || *pos != '/' || *last < *first)
+		return HTTP_EPARSE;
+
+	if (str_cmp(pos + 1, "*") == 0) {
+		*total = UINT64_MAX;
+		return EOK;
+	}
+
+	rc = str_uint64_t(pos + 1, NULL, 10, true, total);
+	if (rc != EOK || *total <= *last)
+		return HTTP_EPARSE;
+
+	return EOK;
+}
+
+/** Determine whether the server keeps the connection open.
+ *
+ * @param resp Response
+ * @return @c true if another request can be sent over the connection
+ *         once the body of the response has been read
+ */
+bool http_response_keep_alive(http_response_t *resp)
+{
+	char *value;
+	bool persistent = resp->version.major > 1 ||
+	    (resp->version.major == 1 && resp->version.minor >= 1);
+
+	if (http_headers_get(&resp->headers, "Connection", &value) != EOK)
+		return persistent;
+
+	if (str_casecmp(value, "close") == 0)
+		return false;
+	if (str_casecmp(value, "keep-alive") == 0)
+		return true;
+
+	return persistent;
+}
+
 /** @}
  */
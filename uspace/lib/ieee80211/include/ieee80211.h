@@ -59,6 +59,18 @@ typedef struct ieee80211_dev ieee80211_dev_t;
 /** Max AMPDU factor. */
 #define IEEE80211_MAX_AMPDU_FACTOR  13
 
+/** HT capability info bits. */
+#define IEEE80211_HT_CAP_SM_PS_DISABLED  0x000C
+#define IEEE80211_HT_CAP_SGI_20          0x0020
+#define IEEE80211_HT_CAP_RX_STBC_1       0x0100
+
+/** HT A-MPDU parameters fields. */
+#define IEEE80211_HT_AMPDU_FACTOR_MASK    0x03
+#define IEEE80211_HT_AMPDU_DENSITY_SHIFT  2
+
+/** Number of HT MCS rates supported with single spatial stream. */
+#define IEEE80211_HT_MCS_COUNT  8
+
 /** Max authentication password length. */
 #define IEEE80211_MAX_PASSW_LEN  64
 
@@ -191,6 +203,8 @@ extern bool ieee80211_is_ready(ieee80211_dev_t *);
 extern void ieee80211_set_ready(ieee80211_dev_t *, bool);
 extern bool ieee80211_query_using_key(ieee80211_dev_t *);
 extern void ieee80211_setup_key_confirm(ieee80211_dev_t *, bool);
+extern void ieee80211_set_ht_cap(ieee80211_dev_t *, uint16_t, uint8_t);
+extern bool ieee80211_query_ht(ieee80211_dev_t *, uint16_t *, uint8_t *);
 
 extern bool ieee80211_is_data_frame(uint16_t);
 extern bool ieee80211_is_mgmt_frame(uint16_t);
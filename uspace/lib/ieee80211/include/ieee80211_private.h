@@ -110,6 +110,31 @@
 #define IEEE80211_GTK_CCMP_LENGTH 16
 #define IEEE80211_GTK_TKIP_LENGTH 32
 
+/** Number of traffic identifiers we keep block ack sessions for. */
+#define IEEE80211_TID_COUNT  8
+
+/** Reorder buffer size offered in block ack sessions. */
+#define IEEE80211_BA_BUFFER_SIZE  64
+
+/** ADDBA parameter set field masks. */
+#define IEEE80211_BA_PARAM_AMSDU        0x0001
+#define IEEE80211_BA_PARAM_IMMEDIATE    0x0002
+#define IEEE80211_BA_PARAM_TID_MASK     0x003C
+#define IEEE80211_BA_PARAM_TID_SHIFT    2
+#define IEEE80211_BA_PARAM_BUFFER_SHIFT 6
+
+/** DELBA parameter set TID field shift. */
+#define IEEE80211_DELBA_PARAM_TID_SHIFT 12
+
+/** Status code used for declined ADDBA requests. */
+#define IEEE80211_STATUS_REQUEST_DECLINED  37
+
+/** QoS control field length in QoS data frames. */
+#define IEEE80211_QOS_CTRL_LENGTH  2
+
+/** HT control field length in HT frames with order bit set. */
+#define IEEE80211_HT_CTRL_LENGTH  4
+
 /** IEEE 802.11 frame types. */
 typedef enum {
 	IEEE80211_MGMT_FRAME = 0x0,
@@ -130,6 +155,7 @@ typedef enum {
 	IEEE80211_MGMT_DISASSOC_FRAME = 0xA0,
 	IEEE80211_MGMT_AUTH_FRAME = 0xB0,
 	IEEE80211_MGMT_DEAUTH_FRAME = 0xC0,
+	IEEE80211_MGMT_ACTION_FRAME = 0xD0,
 } ieee80211_frame_mgmt_subtype_t;
 
 /** IEEE 802.11 data frame subtypes. */
@@ -142,7 +168,8 @@ typedef enum {
 typedef enum {
 	IEEE80211_FRAME_CTRL_FRAME_TYPE = 0x000C,
 	IEEE80211_FRAME_CTRL_FRAME_SUBTYPE = 0x00F0,
-	IEEE80211_FRAME_CTRL_PROTECTED = 0x4000
+	IEEE80211_FRAME_CTRL_PROTECTED = 0x4000,
+	IEEE80211_FRAME_CTRL_ORDER = 0x8000
 } ieee80211_frame_ctrl_mask_t;
 
 /** IEEE 802.11 frame control DS field values. */
@@ -184,11 +211,24 @@ typedef enum {
 	IEEE80211_RATES_IE = 1,       /**< Supported data rates. */
 	IEEE80211_CHANNEL_IE = 3,     /**< Current channel number. */
 	IEEE80211_CHALLENGE_IE = 16,  /**< Challenge text. */
+	IEEE80211_HT_CAP_IE = 45,     /**< HT capabilities. */
 	IEEE80211_RSN_IE = 48,        /**< RSN. */
 	IEEE80211_EXT_RATES_IE = 50,  /**< Extended data rates. */
 	IEEE80211_VENDOR_IE = 221     /**< Vendor specific IE. */
 } ieee80211_ie_type_t;
 
+/** IEEE 802.11 action frame categories. */
+typedef enum {
+	IEEE80211_ACTION_BLOCK_ACK = 3
+} ieee80211_action_category_t;
+
+/** IEEE 802.11n block ack action codes. */
+typedef enum {
+	IEEE80211_BA_ADDBA_REQ = 0,
+	IEEE80211_BA_ADDBA_RESP = 1,
+	IEEE80211_BA_DELBA = 2
+} ieee80211_ba_action_t;
+
 /** IEEE 802.11 authentication phases. */
 typedef enum {
 	IEEE80211_AUTH_DISCONNECTED,
@@ -197,6 +237,16 @@ typedef enum {
 	IEEE80211_AUTH_CONNECTED
 } ieee80211_auth_phase_t;
 
+/** IEEE 802.11n HT capabilities IE body. */
+typedef struct {
+	uint16_t cap_info;     /**< Little Endian value! */
+	uint8_t ampdu_params;
+	uint8_t mcs_set[16];
+	uint16_t ext_cap;      /**< Little Endian value! */
+	uint32_t txbf_cap;     /**< Little Endian value! */
+	uint8_t asel_cap;
+} __attribute__((packed)) ieee80211_ht_cap_t;
+
 /** Link with scan result info. */
 typedef struct {
 	link_t link;
@@ -204,6 +254,8 @@ typedef struct {
 	ieee80211_scan_result_t scan_result;
 	uint8_t auth_ie[256];
 	size_t auth_ie_len;
+	bool ht_capable;
+	ieee80211_ht_cap_t ht_cap;
 } ieee80211_scan_result_link_t;
 
 /** List of scan results info. */
@@ -213,6 +265,14 @@ typedef struct {
 	size_t size;
 } ieee80211_scan_result_list_t;
 
+/** Block ack session accepted for one traffic identifier. */
+typedef struct {
+	bool active;
+	uint16_t buffer_size;
+	uint16_t timeout;
+	uint16_t ssn;
+} ieee80211_ba_session_t;
+
 /** BSSID info. */
 typedef struct {
 	uint16_t aid;
@@ -220,6 +280,8 @@ typedef struct {
 	uint8_t ptk[MAX_PTK_LENGTH];
 	uint8_t gtk[MAX_GTK_LENGTH];
 	ieee80211_scan_result_link_t *res_link;
+	bool ht;
+	ieee80211_ba_session_t ba_rx[IEEE80211_TID_COUNT];
 } ieee80211_bssid_info_t;
 
 /** IEEE 802.11 WiFi device structure. */
@@ -251,6 +313,15 @@ struct ieee80211_dev {
 	 */
 	bool using_hw_key;
 
+	/** Flag indicating that device supports HT (802.11n) operation. */
+	bool ht_supported;
+
+	/** HT capability info announced to APs. */
+	uint16_t ht_cap_info;
+
+	/** HT A-MPDU parameters announced to APs. */
+	uint8_t ht_ampdu_params;
+
 	/** BSSIDs we listen to. */
 	nic_address_t bssid_mask;
 
@@ -348,6 +419,34 @@ typedef struct {
 } __attribute__((packed)) __attribute__((aligned(2)))
     ieee80211_assoc_resp_body_t;
 
+/** IEEE 802.11n ADDBA request action frame body. */
+typedef struct {
+	uint8_t category;
+	uint8_t action;
+	uint8_t dialog_token;
+	uint16_t params;   /**< Little Endian value! */
+	uint16_t timeout;  /**< Little Endian value! */
+	uint16_t ssn;      /**< Little Endian value! */
+} __attribute__((packed)) ieee80211_addba_req_body_t;
+
+/** IEEE 802.11n ADDBA response action frame body. */
+typedef struct {
+	uint8_t category;
+	uint8_t action;
+	uint8_t dialog_token;
+	uint16_t status;   /**< Little Endian value! */
+	uint16_t params;   /**< Little Endian value! */
+	uint16_t timeout;  /**< Little Endian value! */
+} __attribute__((packed)) ieee80211_addba_resp_body_t;
+
+/** IEEE 802.11n DELBA action frame body. */
+typedef struct {
+	uint8_t category;
+	uint8_t action;
+	uint16_t params;   /**< Little Endian value! */
+	uint16_t reason;   /**< Little Endian value! */
+} __attribute__((packed)) ieee80211_delba_body_t;
+
 /** IEEE 802.11 beacon frame body start. */
 typedef struct {
 	uint8_t timestamp[8];
@@ -56,6 +56,11 @@ static const uint8_t rfc1042_header[] = {
 	0xaa, 0xaa, 0x03, 0x00, 0x00, 0x00
 };
 
+/** WMM information element body (OUI, type, subtype, version, QoS info). */
+static const uint8_t wmm_ie_data[] = {
+	0x00, 0x50, 0xf2, 0x02, 0x00, 0x01, 0x00
+};
+
 /** Broadcast MAC address. */
 static const uint8_t ieee80211_broadcast_mac_addr[] = {
 	0xff, 0xff, 0xff, 0xff, 0xff, 0xff
@@ -208,6 +213,35 @@ static inline bool ieee80211_is_encrypted_frame(uint16_t frame_ctrl)
 	return (frame_ctrl & IEEE80211_FRAME_CTRL_PROTECTED);
 }
 
+/** Check if it is QoS data frame.
+ *
+ * @param frame_ctrl Frame control field in little endian (!).
+ *
+ * @return True if the frame carries QoS control field, otherwise false.
+ *
+ */
+static inline bool ieee80211_is_qos_frame(uint16_t frame_ctrl)
+{
+	frame_ctrl = uint16_t_le2host(frame_ctrl);
+
+	return (frame_ctrl & IEEE80211_DATA_QOS_FRAME);
+}
+
+/** Check management action frame.
+ *
+ * @param frame_ctrl Frame control field in little endian (!).
+ *
+ * @return True if it is action frame, otherwise false.
+ *
+ */
+static inline bool ieee80211_is_action_frame(uint16_t frame_ctrl)
+{
+	frame_ctrl = uint16_t_le2host(frame_ctrl);
+
+	return (frame_ctrl & IEEE80211_FRAME_CTRL_FRAME_SUBTYPE) ==
+	    IEEE80211_MGMT_ACTION_FRAME;
+}
+
 /** Check if PAE packet is EAPOL-Key frame.
  *
  * @param key_frame Pointer to start of EAPOL frame.
@@ -495,6 +529,60 @@ void ieee80211_setup_key_confirm(ieee80211_dev_t *ieee80211_dev,
 	fibril_mutex_unlock(&ieee80211_dev->gen_mutex);
 }
 
+/** Announce HT (802.11n) support of IEEE 802.11 device.
+ *
+ * Should be called by driver before the device connects to a network.
+ *
+ * @param ieee80211_dev IEEE 802.11 device.
+ * @param cap_info      HT capability info field to announce.
+ * @param ampdu_params  HT A-MPDU parameters field to announce.
+ *
+ */
+void ieee80211_set_ht_cap(ieee80211_dev_t *ieee80211_dev, uint16_t cap_info,
+    uint8_t ampdu_params)
+{
+	fibril_mutex_lock(&ieee80211_dev->gen_mutex);
+	ieee80211_dev->ht_supported = true;
+	ieee80211_dev->ht_cap_info = cap_info;
+	ieee80211_dev->ht_ampdu_params = ampdu_params;
+	fibril_mutex_unlock(&ieee80211_dev->gen_mutex);
+}
+
+/** Query HT parameters of current association.
+ *
+ * @param ieee80211_dev IEEE 802.11 device.
+ * @param cap_info      Place to store HT capability info supported by both
+ *                      device and AP. Can be NULL.
+ * @param ampdu_params  Place to store HT A-MPDU parameters of AP.
+ *                      Can be NULL.
+ *
+ * @return True if association uses HT operation, false otherwise.
+ *
+ */
+bool ieee80211_query_ht(ieee80211_dev_t *ieee80211_dev, uint16_t *cap_info,
+    uint8_t *ampdu_params)
+{
+	fibril_mutex_lock(&ieee80211_dev->gen_mutex);
+
+	ieee80211_scan_result_link_t *res_link =
+	    ieee80211_dev->bssid_info.res_link;
+	bool ht = ieee80211_dev->bssid_info.ht && res_link;
+
+	if (ht) {
+		if (cap_info) {
+			*cap_info = ieee80211_dev->ht_cap_info &
+			    uint16_t_le2host(res_link->ht_cap.cap_info);
+		}
+
+		if (ampdu_params)
+			*ampdu_params = res_link->ht_cap.ampdu_params;
+	}
+
+	fibril_mutex_unlock(&ieee80211_dev->gen_mutex);
+
+	return ht;
+}
+
 static errno_t ieee80211_scan(void *arg)
 {
 	assert(arg);
@@ -996,6 +1084,21 @@ errno_t ieee80211_associate(ieee80211_dev_t *ieee80211_dev, char *password)
 	    (auth_data->security.type == IEEE80211_SECURITY_WPA2))
 		buffer_size += auth_link->auth_ie_len;
 
+	/*
+	 * HT operation is used only if both device and AP support it.
+	 * HT capable APs expect WMM IE to be present in association
+	 * request of HT stations.
+	 */
+	bool ht = ieee80211_dev->ht_supported && auth_link->ht_capable;
+	if (ht) {
+		buffer_size += sizeof(ieee80211_ie_header_t) * 2 +
+		    sizeof(ieee80211_ht_cap_t) + ARRAY_SIZE(wmm_ie_data);
+	}
+
+	ieee80211_dev->bssid_info.ht = ht;
+	memset(ieee80211_dev->bssid_info.ba_rx, 0,
+	    sizeof(ieee80211_dev->bssid_info.ba_rx));
+
 	void *buffer = malloc(buffer_size);
 	if (!buffer)
 		return ENOMEM;
@@ -1032,8 +1135,27 @@ errno_t ieee80211_associate(ieee80211_dev_t *ieee80211_dev, char *password)
 		assoc_body->capability |= host2uint16_t_le(CAP_SECURITY);
 
 	if ((auth_data->security.type == IEEE80211_SECURITY_WPA) ||
-	    (auth_data->security.type == IEEE80211_SECURITY_WPA2))
+	    (auth_data->security.type == IEEE80211_SECURITY_WPA2)) {
 		memcpy(it, auth_link->auth_ie, auth_link->auth_ie_len);
+		it += auth_link->auth_ie_len;
+	}
+
+	if (ht) {
+		ieee80211_ht_cap_t ht_cap;
+		memset(&ht_cap, 0, sizeof(ht_cap));
+
+		ht_cap.cap_info = host2uint16_t_le(ieee80211_dev->ht_cap_info);
+		ht_cap.ampdu_params = ieee80211_dev->ht_ampdu_params;
+
+		/* RX MCS 0-7 (single spatial stream), TX MCS set defined. */
+		ht_cap.mcs_set[0] = 0xff;
+		ht_cap.mcs_set[12] = 0x01;
+
+		ieee80211_prepare_ie_header(&it, IEEE80211_HT_CAP_IE,
+		    sizeof(ht_cap), &ht_cap);
+		ieee80211_prepare_ie_header(&it, IEEE80211_VENDOR_IE,
+		    ARRAY_SIZE(wmm_ie_data), (void *) wmm_ie_data);
+	}
 
 	ieee80211_dev->ops->tx_handler(ieee80211_dev, buffer, buffer_size);
 
@@ -1091,6 +1213,9 @@ errno_t ieee80211_deauthenticate(ieee80211_dev_t *ieee80211_dev)
 	free(buffer);
 
 	ieee80211_dev->bssid_info.res_link = NULL;
+	ieee80211_dev->bssid_info.ht = false;
+	memset(ieee80211_dev->bssid_info.ba_rx, 0,
+	    sizeof(ieee80211_dev->bssid_info.ba_rx));
 	ieee80211_dev->ops->bssid_change(ieee80211_dev, false);
 
 	if (ieee80211_query_using_key(ieee80211_dev))
@@ -1191,6 +1316,16 @@ static uint8_t *ieee80211_process_ies(ieee80211_dev_t *ieee80211_dev,
 			    (it + sizeof(ieee80211_ie_header_t));
 			ap_data->scan_result.channel = *channel;
 			break;
+		case IEEE80211_HT_CAP_IE:
+			if ((!ap_data) ||
+			    (ie_header->length < sizeof(ieee80211_ht_cap_t)))
+				break;
+
+			memcpy(&ap_data->ht_cap,
+			    it + sizeof(ieee80211_ie_header_t),
+			    sizeof(ieee80211_ht_cap_t));
+			ap_data->ht_capable = true;
+			break;
 		case IEEE80211_RSN_IE:
 			if (!ap_data)
 				break;
@@ -1382,6 +1517,162 @@ static errno_t ieee80211_process_assoc_response(ieee80211_dev_t *ieee80211_dev,
 	return EOK;
 }
 
+/** Send action frame to AP we are associated with.
+ *
+ * @param ieee80211_dev Pointer to IEEE 802.11 device structure.
+ * @param body          Action frame body.
+ * @param body_size     Size of action frame body.
+ *
+ * @return EOK if succeed, error code otherwise.
+ *
+ */
+static errno_t ieee80211_send_action(ieee80211_dev_t *ieee80211_dev,
+    void *body, size_t body_size)
+{
+	ieee80211_scan_result_t *auth_data =
+	    &ieee80211_dev->bssid_info.res_link->scan_result;
+
+	nic_t *nic = nic_get_from_ddf_dev(ieee80211_dev->ddf_dev);
+	nic_address_t nic_address;
+	nic_query_address(nic, &nic_address);
+
+	size_t buffer_size = sizeof(ieee80211_mgmt_header_t) + body_size;
+
+	void *buffer = malloc(buffer_size);
+	if (!buffer)
+		return ENOMEM;
+
+	memset(buffer, 0, buffer_size);
+
+	ieee80211_mgmt_header_t *mgmt_header =
+	    (ieee80211_mgmt_header_t *) buffer;
+
+	mgmt_header->frame_ctrl =
+	    host2uint16_t_le(IEEE80211_MGMT_FRAME |
+	    IEEE80211_MGMT_ACTION_FRAME);
+	memcpy(mgmt_header->dest_addr, auth_data->bssid.address, ETH_ADDR);
+	memcpy(mgmt_header->src_addr, nic_address.address, ETH_ADDR);
+	memcpy(mgmt_header->bssid, auth_data->bssid.address, ETH_ADDR);
+
+	memcpy(buffer + sizeof(ieee80211_mgmt_header_t), body, body_size);
+
+	errno_t rc = ieee80211_dev->ops->tx_handler(ieee80211_dev, buffer,
+	    buffer_size);
+
+	free(buffer);
+
+	return rc;
+}
+
+/** Process ADDBA request and answer it with ADDBA response.
+ *
+ * Only immediate block ack sessions are accepted. Reassembly of
+ * A-MPDUs is done by device, so the session is only recorded.
+ *
+ * @param ieee80211_dev Pointer to IEEE 802.11 device structure.
+ * @param req           ADDBA request frame body.
+ *
+ * @return EOK if succeed, error code otherwise.
+ *
+ */
+static errno_t ieee80211_process_addba_req(ieee80211_dev_t *ieee80211_dev,
+    ieee80211_addba_req_body_t *req)
+{
+	ieee80211_bssid_info_t *bssid_info = &ieee80211_dev->bssid_info;
+
+	uint16_t params = uint16_t_le2host(req->params);
+	unsigned int tid = (params & IEEE80211_BA_PARAM_TID_MASK) >>
+	    IEEE80211_BA_PARAM_TID_SHIFT;
+	uint16_t ba_buffer_size = params >> IEEE80211_BA_PARAM_BUFFER_SHIFT;
+	uint16_t status = 0;
+
+	if ((!bssid_info->ht) || (tid >= IEEE80211_TID_COUNT) ||
+	    (!(params & IEEE80211_BA_PARAM_IMMEDIATE)))
+		status = IEEE80211_STATUS_REQUEST_DECLINED;
+
+	if ((ba_buffer_size == 0) ||
+	    (ba_buffer_size > IEEE80211_BA_BUFFER_SIZE))
+		ba_buffer_size = IEEE80211_BA_BUFFER_SIZE;
+
+	if (status == 0) {
+		ieee80211_ba_session_t *session = &bssid_info->ba_rx[tid];
+		session->active = true;
+		session->buffer_size = ba_buffer_size;
+		session->timeout = uint16_t_le2host(req->timeout);
+		session->ssn = uint16_t_le2host(req->ssn) >> 4;
+	}
+
+	ieee80211_addba_resp_body_t resp;
+	resp.category = IEEE80211_ACTION_BLOCK_ACK;
+	resp.action = IEEE80211_BA_ADDBA_RESP;
+	resp.dialog_token = req->dialog_token;
+	resp.status = host2uint16_t_le(status);
+	resp.params = host2uint16_t_le(
+	    (tid << IEEE80211_BA_PARAM_TID_SHIFT) |
+	    IEEE80211_BA_PARAM_IMMEDIATE |
+	    (ba_buffer_size << IEEE80211_BA_PARAM_BUFFER_SHIFT));
+	resp.timeout = req->timeout;
+
+	return ieee80211_send_action(ieee80211_dev, &resp, sizeof(resp));
+}
+
+/** Process action frame.
+ *
+ * @param ieee80211_dev Pointer to IEEE 802.11 device structure.
+ * @param mgmt_header   Pointer to start of management frame header.
+ * @param buffer_size   Size of frame.
+ *
+ * @return EOK if succeed, error code otherwise.
+ *
+ */
+static errno_t ieee80211_process_action(ieee80211_dev_t *ieee80211_dev,
+    ieee80211_mgmt_header_t *mgmt_header, size_t buffer_size)
+{
+	ieee80211_scan_result_link_t *res_link =
+	    ieee80211_dev->bssid_info.res_link;
+
+	if ((!res_link) || (memcmp(mgmt_header->bssid,
+	    res_link->scan_result.bssid.address, ETH_ADDR) != 0))
+		return EOK;
+
+	if (buffer_size < sizeof(ieee80211_mgmt_header_t) + 2)
+		return EOK;
+
+	size_t body_size = buffer_size - sizeof(ieee80211_mgmt_header_t);
+	uint8_t *body = (uint8_t *) mgmt_header +
+	    sizeof(ieee80211_mgmt_header_t);
+
+	if (body[0] != IEEE80211_ACTION_BLOCK_ACK)
+		return EOK;
+
+	ieee80211_delba_body_t *delba;
+	unsigned int tid;
+
+	switch (body[1]) {
+	case IEEE80211_BA_ADDBA_REQ:
+		if (body_size < sizeof(ieee80211_addba_req_body_t))
+			break;
+
+		return ieee80211_process_addba_req(ieee80211_dev,
+		    (ieee80211_addba_req_body_t *) body);
+	case IEEE80211_BA_DELBA:
+		if (body_size < sizeof(ieee80211_delba_body_t))
+			break;
+
+		delba = (ieee80211_delba_body_t *) body;
+		tid = uint16_t_le2host(delba->params) >>
+		    IEEE80211_DELBA_PARAM_TID_SHIFT;
+
+		if (tid < IEEE80211_TID_COUNT) {
+			memset(&ieee80211_dev->bssid_info.ba_rx[tid], 0,
+			    sizeof(ieee80211_ba_session_t));
+		}
+		break;
+	}
+
+	return EOK;
+}
+
 static errno_t ieee80211_process_4way_handshake(ieee80211_dev_t *ieee80211_dev,
     void *buffer, size_t buffer_size)
 {
@@ -1650,6 +1941,18 @@ static errno_t ieee80211_process_data(ieee80211_dev_t *ieee80211_dev,
 		if (ieee80211_is_encrypted_frame(data_header->frame_ctrl))
 			strip_length += 8;
 
+		/*
+		 * QoS data frames carry QoS control field and eventually
+		 * HT control field after the header.
+		 */
+		if (ieee80211_is_qos_frame(data_header->frame_ctrl)) {
+			strip_length += IEEE80211_QOS_CTRL_LENGTH;
+
+			if (uint16_t_le2host(data_header->frame_ctrl) &
+			    IEEE80211_FRAME_CTRL_ORDER)
+				strip_length += IEEE80211_HT_CTRL_LENGTH;
+		}
+
 		/* Process 4-way authentication handshake. */
 		uint16_t *proto = (uint16_t *) (buffer + strip_length);
 		if (uint16_t_be2host(*proto) == ETH_TYPE_PAE)
@@ -1718,6 +2021,10 @@ errno_t ieee80211_rx_handler(ieee80211_dev_t *ieee80211_dev, void *buffer,
 		if (ieee80211_is_assoc_response_frame(mgmt_header->frame_ctrl))
 			return ieee80211_process_assoc_response(ieee80211_dev,
 			    mgmt_header);
+
+		if (ieee80211_is_action_frame(mgmt_header->frame_ctrl))
+			return ieee80211_process_action(ieee80211_dev,
+			    mgmt_header, buffer_size);
 	} else if (ieee80211_is_data_frame(frame_ctrl))
 		return ieee80211_process_data(ieee80211_dev, buffer,
 		    buffer_size);
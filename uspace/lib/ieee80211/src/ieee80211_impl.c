@@ -232,6 +232,12 @@ errno_t ieee80211_aes_key_unwrap(uint8_t *kek, uint8_t *data, size_t data_size,
 	uint8_t work_output[AES_CIPHER_LENGTH];
 	uint8_t *work_block;
 	uint8_t a[8];
+	aes_ctx_t ctx;
+
+	/* Expand the key once for all blocks */
+	errno_t rc = aes_init(&ctx, kek);
+	if (rc != EOK)
+		return rc;
 
 	memcpy(a, data, 8);
 
@@ -250,7 +256,7 @@ errno_t ieee80211_aes_key_unwrap(uint8_t *kek, uint8_t *data, size_t data_size,
 			work_block = work_data + (i - 1) * 8;
 			memcpy(work_input, a, 8);
 			memcpy(work_input + 8, work_block, 8);
-			aes_decrypt(kek, work_input, work_output);
+			aes_decrypt_block(&ctx, work_input, work_output);
 			memcpy(a, work_output, 8);
 			memcpy(work_data + (i - 1) * 8, work_output + 8, 8);
 		}
@@ -38,8 +38,11 @@
 #include <async.h>
 #include <inet/addr.h>
 #include <inet/eth_addr.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 struct iplink_ev_ops;
+struct iplink_batch;
 
 typedef struct {
 	async_sess_t *sess;
@@ -57,6 +60,13 @@ typedef struct {
 	void *data;
 	/** Size of @c data in bytes */
 	size_t size;
+	/** Offset of the checksummed transport segment in @c data */
+	uint16_t csum_start;
+	/**
+	 * Offset of the partial transport checksum from @c csum_start or 0
+	 * if the packet is complete
+	 */
+	uint16_t csum_offset;
 } iplink_sdu_t;
 
 /** IPv6 link Service Data Unit */
@@ -86,9 +96,11 @@ extern errno_t iplink_open(async_sess_t *, iplink_ev_ops_t *, void *, iplink_t *
 extern void iplink_close(iplink_t *);
 extern errno_t iplink_send(iplink_t *, iplink_sdu_t *);
 extern errno_t iplink_send6(iplink_t *, iplink_sdu6_t *);
+extern errno_t iplink_send_batch(iplink_t *, struct iplink_batch *);
 extern errno_t iplink_addr_add(iplink_t *, inet_addr_t *);
 extern errno_t iplink_addr_remove(iplink_t *, inet_addr_t *);
 extern errno_t iplink_get_mtu(iplink_t *, size_t *);
+extern errno_t iplink_get_offload(iplink_t *, bool *);
 extern errno_t iplink_get_mac48(iplink_t *, eth_addr_t *);
 extern errno_t iplink_set_mac48(iplink_t *, eth_addr_t *);
 extern void *iplink_get_userptr(iplink_t *);
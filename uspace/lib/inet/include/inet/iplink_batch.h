@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libinet
+ * @{
+ */
+/** @file
+ */
+
+#ifndef LIBINET_INET_IPLINK_BATCH_H
+#define LIBINET_INET_IPLINK_BATCH_H
+
+#include <errno.h>
+#include <inet/addr.h>
+#include <inet/iplink.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Header of an SDU in a batch, followed by the SDU data */
+typedef struct {
+	/** Size of the data in bytes */
+	uint32_t size;
+	/** IP version of a received SDU */
+	uint32_t ver;
+	/** Local source address of a sent SDU */
+	addr32_t src;
+	/** Local destination address of a sent SDU */
+	addr32_t dest;
+} iplink_batch_hdr_t;
+
+/** Batch of SDUs carried in a single IPC message */
+typedef struct iplink_batch {
+	/** Serialized SDUs */
+	uint8_t *buf;
+	/** Size of @c buf in bytes */
+	size_t buf_size;
+	/** Number of bytes used in @c buf */
+	size_t size;
+	/** Number of SDUs in the batch */
+	size_t count;
+} iplink_batch_t;
+
+extern errno_t iplink_batch_create(size_t, iplink_batch_t **);
+extern void iplink_batch_destroy(iplink_batch_t *);
+extern void iplink_batch_clear(iplink_batch_t *);
+extern errno_t iplink_batch_add_recv(iplink_batch_t *, iplink_recv_sdu_t *,
+    ip_ver_t);
+extern errno_t iplink_batch_add_send(iplink_batch_t *, iplink_sdu_t *);
+extern errno_t iplink_batch_get(const void *, size_t, size_t *,
+    iplink_batch_hdr_t *, void **);
+
+#endif
+
+/** @}
+ */
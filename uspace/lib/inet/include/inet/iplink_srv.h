@@ -40,6 +40,7 @@
 #include <inet/addr.h>
 #include <inet/eth_addr.h>
 #include <inet/iplink.h>
+#include <inet/iplink_batch.h>
 #include <stdbool.h>
 
 struct iplink_ops;
@@ -58,6 +59,7 @@ typedef struct iplink_ops {
 	errno_t (*send)(iplink_srv_t *, iplink_sdu_t *);
 	errno_t (*send6)(iplink_srv_t *, iplink_sdu6_t *);
 	errno_t (*get_mtu)(iplink_srv_t *, size_t *);
+	errno_t (*get_offload)(iplink_srv_t *, bool *);
 	errno_t (*get_mac48)(iplink_srv_t *, eth_addr_t *);
 	errno_t (*set_mac48)(iplink_srv_t *, eth_addr_t *);
 	errno_t (*addr_add)(iplink_srv_t *, inet_addr_t *);
@@ -68,6 +70,7 @@ extern void iplink_srv_init(iplink_srv_t *);
 
 extern errno_t iplink_conn(ipc_call_t *, void *);
 extern errno_t iplink_ev_recv(iplink_srv_t *, iplink_recv_sdu_t *, ip_ver_t);
+extern errno_t iplink_ev_recv_batch(iplink_srv_t *, iplink_batch_t *);
 extern errno_t iplink_ev_change_addr(iplink_srv_t *, eth_addr_t *);
 
 #endif
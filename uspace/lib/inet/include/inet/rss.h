@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libinet
+ * @{
+ */
+/**
+ * @file
+ * @brief Receive-side scaling hash.
+ */
+
+#ifndef LIBINET_INET_RSS_H
+#define LIBINET_INET_RSS_H
+
+#include <inet/addr.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Size of the Toeplitz hash key */
+#define INET_RSS_KEY_SIZE  40
+
+/** Number of entries of a redirection table */
+#define INET_RSS_RETA_SIZE  128
+
+extern const uint8_t inet_rss_default_key[INET_RSS_KEY_SIZE];
+
+extern uint32_t inet_rss_hash(const uint8_t *, const void *, size_t);
+extern uint32_t inet_rss_hash_flow(const uint8_t *, const inet_addr_t *,
+    const inet_addr_t *, uint16_t, uint16_t);
+
+/** Redirection table index for a hash value.
+ *
+ * @param hash Hash value
+ * @return Index to a redirection table of INET_RSS_RETA_SIZE entries
+ */
+static inline size_t inet_rss_reta_index(uint32_t hash)
+{
+	return hash % INET_RSS_RETA_SIZE;
+}
+
+#endif
+
+/** @}
+ */
@@ -35,10 +35,13 @@
 #ifndef LIBINET_INET_TCP_H
 #define LIBINET_INET_TCP_H
 
+#include <evqueue.h>
 #include <fibril_synch.h>
 #include <inet/addr.h>
 #include <inet/endpoint.h>
 #include <inet/inet.h>
+#include <ipc/tcp.h>
+#include <offset.h>
 
 /** TCP connection */
 typedef struct {
@@ -54,6 +57,12 @@ typedef struct {
 	bool connected;
 	bool conn_failed;
 	bool conn_reset;
+	/** Rings shared with the TCP server or @c NULL if data is passed in IPC */
+	tcp_rings_t *rings;
+	/** Serializes writers to the tx ring */
+	fibril_mutex_t tx_lock;
+	/** Readiness event source */
+	evqueue_src_t evsrc;
 } tcp_conn_t;
 
 /** TCP connection listener */
@@ -103,6 +112,7 @@ extern errno_t tcp_conn_create(tcp_t *, inet_ep2_t *, tcp_cb_t *, void *,
     tcp_conn_t **);
 extern void tcp_conn_destroy(tcp_conn_t *);
 extern void *tcp_conn_userptr(tcp_conn_t *);
+extern evqueue_src_t *tcp_conn_evsrc(tcp_conn_t *);
 extern errno_t tcp_listener_create(tcp_t *, inet_ep_t *, tcp_listen_cb_t *, void *,
     tcp_cb_t *, void *, tcp_listener_t **);
 extern void tcp_listener_destroy(tcp_listener_t *);
@@ -110,12 +120,16 @@ extern void *tcp_listener_userptr(tcp_listener_t *);
 
 extern errno_t tcp_conn_wait_connected(tcp_conn_t *);
 extern errno_t tcp_conn_send(tcp_conn_t *, const void *, size_t);
+extern errno_t tcp_conn_send_file(tcp_conn_t *, int, aoff64_t *, size_t,
+    size_t *);
 extern errno_t tcp_conn_send_fin(tcp_conn_t *);
 extern errno_t tcp_conn_push(tcp_conn_t *);
 extern errno_t tcp_conn_reset(tcp_conn_t *);
 
 extern errno_t tcp_conn_recv(tcp_conn_t *, void *, size_t, size_t *);
 extern errno_t tcp_conn_recv_wait(tcp_conn_t *, void *, size_t, size_t *);
+extern errno_t tcp_conn_stats_get(tcp_conn_t *, tcp_conn_stats_t *);
+extern errno_t tcp_conn_set_bufsize(tcp_conn_t *, size_t, size_t);
 
 #endif
 
@@ -36,6 +36,7 @@
 #define LIBINET_INET_UDP_H
 
 #include <async.h>
+#include <evqueue.h>
 #include <fibril_synch.h>
 #include <inet/addr.h>
 #include <inet/endpoint.h>
@@ -54,8 +55,20 @@ typedef struct {
 	sysarg_t assoc_id;
 	size_t size;
 	inet_ep_t remote_ep;
+	/** Message data if read in a batch, @c NULL if it is read from server */
+	void *data;
 } udp_rmsg_t;
 
+/** UDP message to send with udp_assoc_send_msgs() */
+typedef struct {
+	/** Destination endpoint or @c NULL to use association's remote ep */
+	inet_ep_t *dest;
+	/** Message data */
+	void *data;
+	/** Message size in bytes */
+	size_t size;
+} udp_smsg_t;
+
 /** UDP received error */
 typedef struct {
 } udp_rerr_t;
@@ -67,6 +80,14 @@ typedef struct {
 	sysarg_t id;
 	struct udp_cb *cb;
 	void *cb_arg;
+	/** Readiness event source */
+	evqueue_src_t evsrc;
+	/** Protects @c rqueue */
+	fibril_mutex_t lock;
+	/** Received messages waiting for udp_assoc_recv() */
+	list_t rqueue; /* of udp_rqmsg_t */
+	/** Number of messages in @c rqueue */
+	size_t rqueue_len;
 } udp_assoc_t;
 
 /** UDP callbacks */
@@ -88,6 +109,8 @@ typedef struct udp {
 	fibril_condvar_t cv;
 	/** Set to @a true when callback connection handler has terminated */
 	bool cb_done;
+	/** Buffer for reading batches of received messages or @c NULL */
+	void *rbatch;
 } udp_t;
 
 extern errno_t udp_create(udp_t **);
@@ -97,6 +120,11 @@ extern errno_t udp_assoc_create(udp_t *, inet_ep2_t *, udp_cb_t *, void *,
 extern errno_t udp_assoc_set_nolocal(udp_assoc_t *);
 extern void udp_assoc_destroy(udp_assoc_t *);
 extern errno_t udp_assoc_send_msg(udp_assoc_t *, inet_ep_t *, void *, size_t);
+extern errno_t udp_assoc_send_msgs(udp_assoc_t *, udp_smsg_t *, size_t,
+    size_t *);
+extern errno_t udp_assoc_recv(udp_assoc_t *, void *, size_t, size_t *,
+    inet_ep_t *);
+extern evqueue_src_t *udp_assoc_evsrc(udp_assoc_t *);
 extern void *udp_assoc_userptr(udp_assoc_t *);
 extern size_t udp_rmsg_size(udp_rmsg_t *);
 extern errno_t udp_rmsg_read(udp_rmsg_t *, size_t, void *, size_t);
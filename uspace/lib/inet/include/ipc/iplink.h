@@ -44,12 +44,15 @@ typedef enum {
 	IPLINK_SEND,
 	IPLINK_SEND6,
 	IPLINK_ADDR_ADD,
-	IPLINK_ADDR_REMOVE
+	IPLINK_ADDR_REMOVE,
+	IPLINK_SEND_BATCH,
+	IPLINK_GET_OFFLOAD
 } iplink_request_t;
 
 typedef enum {
 	IPLINK_EV_RECV = IPC_FIRST_USER_METHOD,
 	IPLINK_EV_CHANGE_ADDR,
+	IPLINK_EV_RECV_BATCH
 } iplink_event_t;
 
 #endif
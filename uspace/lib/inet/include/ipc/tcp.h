@@ -36,6 +36,11 @@
 #define LIBINET_IPC_TCP_H
 
 #include <ipc/common.h>
+#include <mem.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 typedef enum {
 	TCP_CALLBACK_CREATE = IPC_FIRST_USER_METHOD,
@@ -48,7 +53,12 @@ typedef enum {
 	TCP_CONN_PUSH,
 	TCP_CONN_RESET,
 	TCP_CONN_RECV,
-	TCP_CONN_RECV_WAIT
+	TCP_CONN_RECV_WAIT,
+	TCP_CONN_STATS,
+	TCP_CONN_SET_BUFSIZE,
+	TCP_CONN_RINGS_SETUP,
+	TCP_CONN_RX_KICK,
+	TCP_CONN_TX_KICK
 } tcp_request_t;
 
 typedef enum {
@@ -60,6 +70,248 @@ typedef enum {
 	TCP_EV_NEW_CONN
 } tcp_event_t;
 
+/** TCP connection congestion control statistics */
+typedef struct {
+	/** Congestion window in bytes */
+	uint32_t cwnd;
+	/** Slow start threshold in bytes */
+	uint32_t ssthresh;
+	/** Smoothed round-trip time in microseconds */
+	uint64_t srtt;
+	/** Round-trip time variation in microseconds */
+	uint64_t rttvar;
+	/** Retransmission timeout in microseconds */
+	uint64_t rto;
+	/** Number of segments transmitted */
+	uint64_t segs_out;
+	/** Number of segments retransmitted */
+	uint64_t segs_retrans;
+	/** Number of fast retransmits */
+	uint64_t fast_retrans;
+	/** Number of retransmission timeouts */
+	uint64_t timeouts;
+	/** Number of duplicate ACKs received */
+	uint64_t dupacks_in;
+} tcp_conn_stats_t;
+
+/** Size of the data area of a shared connection ring in bytes */
+#define TCP_RING_SIZE  65536
+
+/**
+ * Byte stream ring in memory shared between the TCP service and its client.
+ *
+ * The ring has a single producer and a single consumer. The positions run
+ * freely and are taken modulo TCP_RING_SIZE. The consumer sets @c rd_kick
+ * before it waits for data and the producer sets @c wr_kick before it waits
+ * for space. The other side only notifies if it finds the flag set, so the
+ * notification is sent once when an empty ring becomes non-empty (or a full
+ * ring gets space) instead of once for every chunk.
+ */
+typedef struct {
+	/** Position where the next byte is put, written by the producer */
+	atomic_size_t head;
+	/** Position of the next byte to consume, written by the consumer */
+	atomic_size_t tail;
+	/** Consumer waits for data */
+	atomic_bool rd_kick;
+	/** Producer waits for space */
+	atomic_bool wr_kick;
+	/** Producer will not put any more data */
+	atomic_bool fin;
+	/** Stream data */
+	uint8_t data[TCP_RING_SIZE];
+} tcp_ring_t;
+
+/** Connection rings shared between the TCP service and its client. */
+typedef struct {
+	/** Received data, produced by the service */
+	tcp_ring_t rx;
+	/** Data to send, produced by the client */
+	tcp_ring_t tx;
+} tcp_rings_t;
+
+/** Initialize a connection ring.
+ *
+ * @param ring Ring
+ */
+static inline void tcp_ring_init(tcp_ring_t *ring)
+{
+	atomic_init(&ring->head, 0);
+	atomic_init(&ring->tail, 0);
+	atomic_init(&ring->rd_kick, true);
+	atomic_init(&ring->wr_kick, false);
+	atomic_init(&ring->fin, false);
+}
+
+/** Get contiguous free space in a ring (producer).
+ *
+ * @param ring Ring
+ * @param[out] size Size of the free space in bytes, zero if the ring is full
+ *
+ * @return Start of the free space
+ */
+static inline void *tcp_ring_wspace(tcp_ring_t *ring, size_t *size)
+{
+	size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	size_t used = head - atomic_load(&ring->tail);
+	size_t off = head % TCP_RING_SIZE;
+
+	*size = TCP_RING_SIZE - used;
+	if (*size > TCP_RING_SIZE - off)
+		*size = TCP_RING_SIZE - off;
+	return ring->data + off;
+}
+
+/** Make data written to the free space available (producer).
+ *
+ * @param ring Ring
+ * @param size Number of bytes written
+ *
+ * @return @c true if the consumer needs to be notified
+ */
+static inline bool tcp_ring_produce(tcp_ring_t *ring, size_t size)
+{
+	atomic_fetch_add(&ring->head, size);
+	return atomic_exchange(&ring->rd_kick, false);
+}
+
+/** Get contiguous data in a ring (consumer).
+ *
+ * @param ring Ring
+ * @param[out] size Size of the data in bytes, zero if the ring is empty
+ *
+ * @return Start of the data
+ */
+static inline void *tcp_ring_rdata(tcp_ring_t *ring, size_t *size)
+{
+	size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	size_t off = tail % TCP_RING_SIZE;
+
+	*size = atomic_load(&ring->head) - tail;
+	if (*size > TCP_RING_SIZE - off)
+		*size = TCP_RING_SIZE - off;
+	return ring->data + off;
+}
+
+/** Remove data from a ring (consumer).
+ *
+ * @param ring Ring
+ * @param size Number of bytes consumed
+ *
+ * @return @c true if the producer needs to be notified
+ */
+static inline bool tcp_ring_consume(tcp_ring_t *ring, size_t size)
+{
+	atomic_fetch_add(&ring->tail, size);
+	return atomic_exchange(&ring->wr_kick, false);
+}
+
+/** Copy data to a ring (producer).
+ *
+ * @param ring Ring
+ * @param data Data
+ * @param size Data size in bytes
+ * @param[out] kick Set to @c true if the consumer needs to be notified
+ *
+ * @return Number of bytes copied, less than @a size if the ring got full
+ */
+static inline size_t tcp_ring_write(tcp_ring_t *ring, const void *data,
+    size_t size, bool *kick)
+{
+	const uint8_t *dp = data;
+	size_t done = 0;
+	size_t space;
+	void *sp;
+
+	*kick = false;
+	while (done < size) {
+		sp = tcp_ring_wspace(ring, &space);
+		if (space == 0)
+			break;
+		if (space > size - done)
+			space = size - done;
+		memcpy(sp, dp + done, space);
+		done += space;
+		if (tcp_ring_produce(ring, space))
+			*kick = true;
+	}
+
+	return done;
+}
+
+/** Copy data from a ring (consumer).
+ *
+ * @param ring Ring
+ * @param buf Buffer
+ * @param size Buffer size in bytes
+ * @param[out] kick Set to @c true if the producer needs to be notified
+ *
+ * @return Number of bytes copied, zero if the ring is empty
+ */
+static inline size_t tcp_ring_read(tcp_ring_t *ring, void *buf, size_t size,
+    bool *kick)
+{
+	uint8_t *bp = buf;
+	size_t done = 0;
+	size_t avail;
+	void *dp;
+
+	*kick = false;
+	while (done < size) {
+		dp = tcp_ring_rdata(ring, &avail);
+		if (avail == 0)
+			break;
+		if (avail > size - done)
+			avail = size - done;
+		memcpy(bp + done, dp, avail);
+		done += avail;
+		if (tcp_ring_consume(ring, avail))
+			*kick = true;
+	}
+
+	return done;
+}
+
+/** Ask for a notification once data is put to an empty ring (consumer).
+ *
+ * @param ring Ring
+ *
+ * @return @c true if the consumer can wait for the notification, @c false
+ *         if data was put to the ring meanwhile and should be consumed
+ */
+static inline bool tcp_ring_rd_idle(tcp_ring_t *ring)
+{
+	atomic_store(&ring->rd_kick, true);
+
+	if (atomic_load(&ring->head) == atomic_load(&ring->tail) &&
+	    !atomic_load(&ring->fin))
+		return true;
+
+	/*
+	 * If the producer has already taken the flag, a notification is on its
+	 * way and the data will be consumed when it arrives.
+	 */
+	return !atomic_exchange(&ring->rd_kick, false);
+}
+
+/** Ask for a notification once space is freed in a full ring (producer).
+ *
+ * @param ring Ring
+ *
+ * @return @c true if the producer can wait for the notification, @c false
+ *         if space was freed meanwhile and can be filled
+ */
+static inline bool tcp_ring_wr_idle(tcp_ring_t *ring)
+{
+	atomic_store(&ring->wr_kick, true);
+
+	if (atomic_load(&ring->head) - atomic_load(&ring->tail) ==
+	    TCP_RING_SIZE)
+		return true;
+
+	return !atomic_exchange(&ring->wr_kick, false);
+}
+
 #endif
 
 /** @}
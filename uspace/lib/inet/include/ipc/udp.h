@@ -35,7 +35,9 @@
 #ifndef LIBINET_IPC_UDP_H
 #define LIBINET_IPC_UDP_H
 
+#include <inet/endpoint.h>
 #include <ipc/common.h>
+#include <stddef.h>
 
 typedef enum {
 	UDP_CALLBACK_CREATE = IPC_FIRST_USER_METHOD,
@@ -45,13 +47,42 @@ typedef enum {
 	UDP_ASSOC_SEND_MSG,
 	UDP_RMSG_INFO,
 	UDP_RMSG_READ,
-	UDP_RMSG_DISCARD
+	UDP_RMSG_DISCARD,
+	UDP_ASSOC_SEND_MSGS,
+	UDP_RMSG_READ_BATCH
 } udp_request_t;
 
 typedef enum {
 	UDP_EV_DATA = IPC_FIRST_USER_METHOD
 } udp_event_t;
 
+/** Alignment of messages in a message batch */
+#define UDP_BATCH_ALIGN  sizeof(sysarg_t)
+
+/** Header of a message in a batch sent with UDP_ASSOC_SEND_MSGS.
+ *
+ * The header is followed by the message data, padded to UDP_BATCH_ALIGN.
+ */
+typedef struct {
+	/** Destination endpoint or any address and port for the default */
+	inet_ep_t dest;
+	/** Message size */
+	size_t size;
+} udp_smsg_hdr_t;
+
+/** Header of a message in a batch read with UDP_RMSG_READ_BATCH.
+ *
+ * The header is followed by the message data, padded to UDP_BATCH_ALIGN.
+ */
+typedef struct {
+	/** Association ID */
+	sysarg_t assoc_id;
+	/** Remote endpoint */
+	inet_ep_t remote_ep;
+	/** Message size */
+	size_t size;
+} udp_rmsg_hdr_t;
+
 #endif
 
 /** @}
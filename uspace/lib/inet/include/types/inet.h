@@ -57,7 +57,13 @@ typedef struct {
 } inet_ev_ops_t;
 
 typedef enum {
-	INET_DF = 1
+	/** Do not fragment */
+	INET_DF = 1,
+	/**
+	 * The transport checksum contains only the sum of the pseudo header,
+	 * it is completed by inetsrv or by the NIC.
+	 */
+	INET_CSUM_PARTIAL = 2
 } inet_df_t;
 
 #endif
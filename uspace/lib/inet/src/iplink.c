@@ -40,6 +40,7 @@
 #include <inet/addr.h>
 #include <inet/eth_addr.h>
 #include <inet/iplink.h>
+#include <inet/iplink_batch.h>
 #include <ipc/iplink.h>
 #include <ipc/services.h>
 #include <loc.h>
@@ -90,8 +91,8 @@ errno_t iplink_send(iplink_t *iplink, iplink_sdu_t *sdu)
 	async_exch_t *exch = async_exchange_begin(iplink->sess);
 
 	ipc_call_t answer;
-	aid_t req = async_send_2(exch, IPLINK_SEND, (sysarg_t) sdu->src,
-	    (sysarg_t) sdu->dest, &answer);
+	aid_t req = async_send_4(exch, IPLINK_SEND, (sysarg_t) sdu->src,
+	    (sysarg_t) sdu->dest, sdu->csum_start, sdu->csum_offset, &answer);
 
 	errno_t rc = async_data_write_start(exch, sdu->data, sdu->size);
 
@@ -108,6 +109,40 @@ errno_t iplink_send(iplink_t *iplink, iplink_sdu_t *sdu)
 	return retval;
 }
 
+/** Send a batch of IPv4 SDUs in a single message.
+ *
+ * @param iplink IP link
+ * @param batch  Batch of SDUs added by iplink_batch_add_send()
+ *
+ * @return EOK if all SDUs were sent, otherwise the error of the first
+ *         SDU which failed
+ */
+errno_t iplink_send_batch(iplink_t *iplink, iplink_batch_t *batch)
+{
+	if (batch->count == 0)
+		return EOK;
+
+	async_exch_t *exch = async_exchange_begin(iplink->sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_1(exch, IPLINK_SEND_BATCH, batch->count,
+	    &answer);
+
+	errno_t rc = async_data_write_start(exch, batch->buf, batch->size);
+
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+
+	return retval;
+}
+
 errno_t iplink_send6(iplink_t *iplink, iplink_sdu6_t *sdu)
 {
 	async_exch_t *exch = async_exchange_begin(iplink->sess);
@@ -153,6 +188,30 @@ errno_t iplink_get_mtu(iplink_t *iplink, size_t *rmtu)
 	return EOK;
 }
 
+/** Determine if the link can complete partial transport checksums.
+ *
+ * @param iplink IP link
+ * @param roffload Place to store @c true if IPv4 packets can be sent
+ *                 with a partial checksum
+ *
+ * @return EOK on success or an error code
+ */
+errno_t iplink_get_offload(iplink_t *iplink, bool *roffload)
+{
+	async_exch_t *exch = async_exchange_begin(iplink->sess);
+
+	sysarg_t offload;
+	errno_t rc = async_req_0_1(exch, IPLINK_GET_OFFLOAD, &offload);
+
+	async_exchange_end(exch);
+
+	if (rc != EOK)
+		return rc;
+
+	*roffload = offload != 0;
+	return EOK;
+}
+
 errno_t iplink_get_mac48(iplink_t *iplink, eth_addr_t *mac)
 {
 	async_exch_t *exch = async_exchange_begin(iplink->sess);
@@ -262,6 +321,37 @@ static void iplink_ev_recv(iplink_t *iplink, ipc_call_t *icall)
 	async_answer_0(icall, rc);
 }
 
+static void iplink_ev_recv_batch(iplink_t *iplink, ipc_call_t *icall)
+{
+	iplink_batch_hdr_t hdr;
+	iplink_recv_sdu_t sdu;
+	errno_t retval = EOK;
+	size_t offs = 0;
+	void *buf;
+	size_t size;
+
+	errno_t rc = async_data_write_accept(&buf, false, 0, DATA_XFER_LIMIT,
+	    0, &size);
+	if (rc != EOK) {
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	while ((rc = iplink_batch_get(buf, size, &offs, &hdr,
+	    &sdu.data)) == EOK) {
+		sdu.size = hdr.size;
+		rc = iplink->ev_ops->recv(iplink, &sdu, hdr.ver);
+		if (rc != EOK && retval == EOK)
+			retval = rc;
+	}
+
+	if (rc != ENOENT && retval == EOK)
+		retval = rc;
+
+	free(buf);
+	async_answer_0(icall, retval);
+}
+
 static void iplink_ev_change_addr(iplink_t *iplink, ipc_call_t *icall)
 {
 	eth_addr_t *addr;
@@ -299,6 +389,9 @@ static void iplink_cb_conn(ipc_call_t *icall, void *arg)
 		case IPLINK_EV_CHANGE_ADDR:
 			iplink_ev_change_addr(iplink, &call);
 			break;
+		case IPLINK_EV_RECV_BATCH:
+			iplink_ev_recv_batch(iplink, &call);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 		}
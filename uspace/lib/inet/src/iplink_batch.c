@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libinet
+ * @{
+ */
+/**
+ * @file
+ * @brief Batches of SDUs passed in a single IPC message.
+ *
+ * Each SDU is stored as an iplink_batch_hdr_t header followed by the data,
+ * padded so that the next header is aligned.
+ */
+
+#include <align.h>
+#include <async.h>
+#include <errno.h>
+#include <inet/iplink_batch.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdlib.h>
+
+/** Alignment of the SDU headers in a batch */
+#define IPLINK_BATCH_ALIGN  sizeof(uint32_t)
+
+/** Create a batch.
+ *
+ * @param buf_size Size of the buffer for the serialized SDUs, at most
+ *                 DATA_XFER_LIMIT
+ * @param rbatch   Place to store pointer to the new batch
+ *
+ * @return EOK on success, EINVAL if @a buf_size is out of range or ENOMEM
+ */
+errno_t iplink_batch_create(size_t buf_size, iplink_batch_t **rbatch)
+{
+	iplink_batch_t *batch;
+
+	if (buf_size < sizeof(iplink_batch_hdr_t) || buf_size > DATA_XFER_LIMIT)
+		return EINVAL;
+
+	batch = calloc(1, sizeof(iplink_batch_t));
+	if (batch == NULL)
+		return ENOMEM;
+
+	batch->buf = malloc(buf_size);
+	if (batch->buf == NULL) {
+		free(batch);
+		return ENOMEM;
+	}
+
+	batch->buf_size = buf_size;
+	*rbatch = batch;
+	return EOK;
+}
+
+/** Destroy a batch.
+ *
+ * @param batch Batch or @c NULL
+ */
+void iplink_batch_destroy(iplink_batch_t *batch)
+{
+	if (batch == NULL)
+		return;
+
+	free(batch->buf);
+	free(batch);
+}
+
+/** Remove all SDUs from a batch.
+ *
+ * @param batch Batch
+ */
+void iplink_batch_clear(iplink_batch_t *batch)
+{
+	batch->size = 0;
+	batch->count = 0;
+}
+
+/** Append an SDU to a batch.
+ *
+ * @param batch Batch
+ * @param hdr   SDU header
+ * @param data  SDU data, hdr->size bytes
+ *
+ * @return EOK on success, ELIMIT if the SDU does not fit in the batch
+ */
+static errno_t iplink_batch_add(iplink_batch_t *batch, iplink_batch_hdr_t *hdr,
+    const void *data)
+{
+	size_t avail = batch->buf_size - batch->size;
+
+	if (avail < sizeof(iplink_batch_hdr_t) ||
+	    avail - sizeof(iplink_batch_hdr_t) < hdr->size)
+		return ELIMIT;
+
+	memcpy(batch->buf + batch->size, hdr, sizeof(iplink_batch_hdr_t));
+	memcpy(batch->buf + batch->size + sizeof(iplink_batch_hdr_t), data,
+	    hdr->size);
+
+	batch->size = min((size_t) ALIGN_UP(batch->size +
+	    sizeof(iplink_batch_hdr_t) + hdr->size, IPLINK_BATCH_ALIGN),
+	    batch->buf_size);
+	batch->count++;
+	return EOK;
+}
+
+/** Append a received SDU to a batch.
+ *
+ * @param batch Batch
+ * @param sdu   Received SDU
+ * @param ver   IP version
+ *
+ * @return EOK on success, ELIMIT if the SDU does not fit in the batch
+ */
+errno_t iplink_batch_add_recv(iplink_batch_t *batch, iplink_recv_sdu_t *sdu,
+    ip_ver_t ver)
+{
+	iplink_batch_hdr_t hdr;
+
+	if (sdu->size > UINT32_MAX)
+		return ELIMIT;
+
+	hdr.size = sdu->size;
+	hdr.ver = ver;
+	hdr.src = 0;
+	hdr.dest = 0;
+
+	return iplink_batch_add(batch, &hdr, sdu->data);
+}
+
+/** Append an IPv4 SDU to be sent to a batch.
+ *
+ * The batch does not carry the checksum offsets, the SDU must be complete.
+ *
+ * @param batch Batch
+ * @param sdu   SDU
+ *
+ * @return EOK on success, ELIMIT if the SDU does not fit in the batch
+ */
+errno_t iplink_batch_add_send(iplink_batch_t *batch, iplink_sdu_t *sdu)
+{
+	iplink_batch_hdr_t hdr;
+
+	if (sdu->size > UINT32_MAX)
+		return ELIMIT;
+
+	hdr.size = sdu->size;
+	hdr.ver = ip_v4;
+	hdr.src = sdu->src;
+	hdr.dest = sdu->dest;
+
+	return iplink_batch_add(batch, &hdr, sdu->data);
+}
+
+/** Get the next SDU from serialized batch.
+ *
+ * @param buf       Serialized batch
+ * @param size      Size of @a buf in bytes
+ * @param offs      Offset of the next SDU, updated to the following one
+ * @param hdr       Place to store the SDU header
+ * @param data      Place to store pointer to the SDU data in @a buf
+ *
+ * @return EOK on success, ENOENT if there are no more SDUs or EINVAL if
+ *         the batch is malformed
+ */
+errno_t iplink_batch_get(const void *buf, size_t size, size_t *offs,
+    iplink_batch_hdr_t *hdr, void **data)
+{
+	const uint8_t *bp = buf;
+
+	if (*offs >= size)
+		return ENOENT;
+
+	if (size - *offs < sizeof(iplink_batch_hdr_t))
+		return EINVAL;
+
+	memcpy(hdr, bp + *offs, sizeof(iplink_batch_hdr_t));
+	if (size - *offs - sizeof(iplink_batch_hdr_t) < hdr->size)
+		return EINVAL;
+
+	*data = (void *) (bp + *offs + sizeof(iplink_batch_hdr_t));
+	*offs = min((size_t) ALIGN_UP(*offs + sizeof(iplink_batch_hdr_t) +
+	    hdr->size, IPLINK_BATCH_ALIGN), size);
+	return EOK;
+}
+
+/** @}
+ */
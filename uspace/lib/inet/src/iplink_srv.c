@@ -49,6 +49,19 @@ static void iplink_get_mtu_srv(iplink_srv_t *srv, ipc_call_t *call)
 	async_answer_1(call, rc, mtu);
 }
 
+static void iplink_get_offload_srv(iplink_srv_t *srv, ipc_call_t *call)
+{
+	bool offload = false;
+	errno_t rc;
+
+	if (srv->ops->get_offload != NULL)
+		rc = srv->ops->get_offload(srv, &offload);
+	else
+		rc = ENOTSUP;
+
+	async_answer_1(call, rc, offload);
+}
+
 static void iplink_get_mac48_srv(iplink_srv_t *srv, ipc_call_t *icall)
 {
 	eth_addr_t mac;
@@ -175,6 +188,8 @@ static void iplink_send_srv(iplink_srv_t *srv, ipc_call_t *icall)
 
 	sdu.src = ipc_get_arg1(icall);
 	sdu.dest = ipc_get_arg2(icall);
+	sdu.csum_start = ipc_get_arg3(icall);
+	sdu.csum_offset = ipc_get_arg4(icall);
 
 	errno_t rc = async_data_write_accept(&sdu.data, false, 0, 0, 0,
 	    &sdu.size);
@@ -188,6 +203,41 @@ static void iplink_send_srv(iplink_srv_t *srv, ipc_call_t *icall)
 	async_answer_0(icall, rc);
 }
 
+static void iplink_send_batch_srv(iplink_srv_t *srv, ipc_call_t *icall)
+{
+	iplink_batch_hdr_t hdr;
+	iplink_sdu_t sdu;
+	errno_t retval = EOK;
+	size_t offs = 0;
+	void *buf;
+	size_t size;
+
+	errno_t rc = async_data_write_accept(&buf, false, 0, DATA_XFER_LIMIT,
+	    0, &size);
+	if (rc != EOK) {
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	while ((rc = iplink_batch_get(buf, size, &offs, &hdr,
+	    &sdu.data)) == EOK) {
+		sdu.src = hdr.src;
+		sdu.dest = hdr.dest;
+		sdu.size = hdr.size;
+		sdu.csum_start = 0;
+		sdu.csum_offset = 0;
+		rc = srv->ops->send(srv, &sdu);
+		if (rc != EOK && retval == EOK)
+			retval = rc;
+	}
+
+	if (rc != ENOENT && retval == EOK)
+		retval = rc;
+
+	free(buf);
+	async_answer_0(icall, retval);
+}
+
 static void iplink_send6_srv(iplink_srv_t *srv, ipc_call_t *icall)
 {
 	iplink_sdu6_t sdu;
@@ -279,6 +329,9 @@ errno_t iplink_conn(ipc_call_t *icall, void *arg)
 		case IPLINK_GET_MTU:
 			iplink_get_mtu_srv(srv, &call);
 			break;
+		case IPLINK_GET_OFFLOAD:
+			iplink_get_offload_srv(srv, &call);
+			break;
 		case IPLINK_GET_MAC48:
 			iplink_get_mac48_srv(srv, &call);
 			break;
@@ -291,6 +344,9 @@ errno_t iplink_conn(ipc_call_t *icall, void *arg)
 		case IPLINK_SEND6:
 			iplink_send6_srv(srv, &call);
 			break;
+		case IPLINK_SEND_BATCH:
+			iplink_send_batch_srv(srv, &call);
+			break;
 		case IPLINK_ADDR_ADD:
 			iplink_addr_add_srv(srv, &call);
 			break;
@@ -333,6 +389,40 @@ errno_t iplink_ev_recv(iplink_srv_t *srv, iplink_recv_sdu_t *sdu, ip_ver_t ver)
 	return EOK;
 }
 
+/** Deliver a batch of received SDUs to the client in a single message.
+ *
+ * @param srv   IP link server
+ * @param batch Batch of SDUs added by iplink_batch_add_recv()
+ *
+ * @return EOK on success or an error code
+ */
+errno_t iplink_ev_recv_batch(iplink_srv_t *srv, iplink_batch_t *batch)
+{
+	if (srv->client_sess == NULL)
+		return EIO;
+
+	if (batch->count == 0)
+		return EOK;
+
+	async_exch_t *exch = async_exchange_begin(srv->client_sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_1(exch, IPLINK_EV_RECV_BATCH, batch->count,
+	    &answer);
+
+	errno_t rc = async_data_write_start(exch, batch->buf, batch->size);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	return retval;
+}
+
 errno_t iplink_ev_change_addr(iplink_srv_t *srv, eth_addr_t *addr)
 {
 	if (srv->client_sess == NULL)
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libinet
+ * @{
+ */
+/**
+ * @file
+ * @brief Receive-side scaling hash.
+ *
+ * The Toeplitz hash used by NICs to spread received flows over their
+ * receive queues. Computing the same hash in software lets a driver
+ * without hardware support steer flows the same way and lets a transport
+ * protocol pick the queue (or its own shard) a flow will be received on.
+ */
+
+#include <assert.h>
+#include <byteorder.h>
+#include <inet/rss.h>
+#include <mem.h>
+
+/** Default hash key, the one commonly programmed into NICs. */
+const uint8_t inet_rss_default_key[INET_RSS_KEY_SIZE] = {
+	0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2,
+	0x41, 0x67, 0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0,
+	0xd0, 0xca, 0x2b, 0xcb, 0xae, 0x7b, 0x30, 0xb4,
+	0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30, 0xf2, 0x0c,
+	0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa
+};
+
+/** Compute Toeplitz hash.
+ *
+ * For every bit set in the input the 32 bits of the key starting at the
+ * same bit position are added to the result.
+ *
+ * @param key  Hash key of INET_RSS_KEY_SIZE bytes
+ * @param data Input in network byte order
+ * @param size Size of input, at most INET_RSS_KEY_SIZE - 4 bytes
+ * @return Hash value
+ */
+uint32_t inet_rss_hash(const uint8_t *key, const void *data, size_t size)
+{
+	const uint8_t *bp = data;
+	uint32_t hash = 0;
+	uint32_t window;
+	size_t i;
+	int bit;
+
+	assert(size <= INET_RSS_KEY_SIZE - 4);
+
+	window = ((uint32_t) key[0] << 24) | ((uint32_t) key[1] << 16) |
+	    ((uint32_t) key[2] << 8) | key[3];
+
+	for (i = 0; i < size; i++) {
+		for (bit = 7; bit >= 0; bit--) {
+			if ((bp[i] >> bit) & 1)
+				hash ^= window;
+			window = (window << 1) | ((key[i + 4] >> bit) & 1);
+		}
+	}
+
+	return hash;
+}
+
+/** Compute Toeplitz hash of a TCP or UDP flow.
+ *
+ * The input is laid out as by NICs hashing TCP over IPv4 or IPv6: source
+ * address, destination address, source port and destination port.
+ *
+ * @param key   Hash key of INET_RSS_KEY_SIZE bytes
+ * @param src   Source address
+ * @param dest  Destination address
+ * @param sport Source port
+ * @param dport Destination port
+ * @return Hash value, zero if the addresses are not of the same version
+ */
+uint32_t inet_rss_hash_flow(const uint8_t *key, const inet_addr_t *src,
+    const inet_addr_t *dest, uint16_t sport, uint16_t dport)
+{
+	uint8_t buf[2 * sizeof(addr128_t) + 2 * sizeof(uint16_t)];
+	uint16_t port;
+	size_t asize;
+	uint32_t a;
+
+	if (src->version != dest->version)
+		return 0;
+
+	switch (src->version) {
+	case ip_v4:
+		asize = sizeof(addr32_t);
+		a = host2uint32_t_be(src->addr);
+		memcpy(buf, &a, asize);
+		a = host2uint32_t_be(dest->addr);
+		memcpy(buf + asize, &a, asize);
+		break;
+	case ip_v6:
+		asize = sizeof(addr128_t);
+		memcpy(buf, src->addr6, asize);
+		memcpy(buf + asize, dest->addr6, asize);
+		break;
+	default:
+		return 0;
+	}
+
+	port = host2uint16_t_be(sport);
+	memcpy(buf + 2 * asize, &port, sizeof(uint16_t));
+	port = host2uint16_t_be(dport);
+	memcpy(buf + 2 * asize + sizeof(uint16_t), &port, sizeof(uint16_t));
+
+	return inet_rss_hash(key, buf, 2 * asize + 2 * sizeof(uint16_t));
+}
+
+/** @}
+ */
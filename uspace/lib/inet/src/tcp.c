@@ -32,13 +32,17 @@
 /** @file TCP API
  */
 
+#include <as.h>
 #include <errno.h>
+#include <evqueue.h>
 #include <fibril.h>
 #include <inet/endpoint.h>
 #include <inet/tcp.h>
 #include <ipc/services.h>
 #include <ipc/tcp.h>
+#include <macros.h>
 #include <stdlib.h>
+#include <vfs/vfs.h>
 
 static void tcp_cb_conn(ipc_call_t *, void *);
 static errno_t tcp_conn_fibril(void *);
@@ -150,6 +154,48 @@ void tcp_destroy(tcp_t *tcp)
 	free(tcp);
 }
 
+/** Share data rings with the TCP server.
+ *
+ * If the server does not support rings, data keeps being passed in IPC
+ * messages.
+ *
+ * @param conn Connection
+ */
+static void tcp_conn_rings_setup(tcp_conn_t *conn)
+{
+	async_exch_t *exch;
+	tcp_rings_t *rings;
+	errno_t rc;
+
+	rings = as_area_create(AS_AREA_ANY, sizeof(tcp_rings_t),
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (rings == AS_MAP_FAILED)
+		return;
+
+	tcp_ring_init(&rings->rx);
+	tcp_ring_init(&rings->tx);
+
+	exch = async_exchange_begin(conn->tcp->sess);
+	aid_t req = async_send_1(exch, TCP_CONN_RINGS_SETUP, conn->id, NULL);
+	rc = async_share_out_start(exch, rings,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		as_area_destroy(rings);
+		return;
+	}
+
+	async_wait_for(req, &rc);
+	if (rc != EOK) {
+		as_area_destroy(rings);
+		return;
+	}
+
+	conn->rings = rings;
+}
+
 /** Create new TCP connection
  *
  * @param tcp   TCP client instance
@@ -172,6 +218,8 @@ static errno_t tcp_conn_new(tcp_t *tcp, sysarg_t id, tcp_cb_t *cb, void *arg,
 	conn->data_avail = false;
 	fibril_mutex_initialize(&conn->lock);
 	fibril_condvar_initialize(&conn->cv);
+	fibril_mutex_initialize(&conn->tx_lock);
+	evqueue_src_init(&conn->evsrc);
 
 	conn->tcp = tcp;
 	conn->id = id;
@@ -179,6 +227,7 @@ static errno_t tcp_conn_new(tcp_t *tcp, sysarg_t id, tcp_cb_t *cb, void *arg,
 	conn->cb_arg = arg;
 
 	list_append(&conn->ltcp, &tcp->conn);
+	tcp_conn_rings_setup(conn);
 	*rconn = conn;
 
 	return EOK;
@@ -262,6 +311,9 @@ void tcp_conn_destroy(tcp_conn_t *conn)
 	errno_t rc = async_req_1_0(exch, TCP_CONN_DESTROY, conn->id);
 	async_exchange_end(exch);
 
+	evqueue_remove(&conn->evsrc);
+	if (conn->rings != NULL)
+		as_area_destroy(conn->rings);
 	free(conn);
 	(void) rc;
 }
@@ -296,6 +348,20 @@ void *tcp_conn_userptr(tcp_conn_t *conn)
 	return conn->cb_arg;
 }
 
+/** Get readiness event source of a connection.
+ *
+ * The source reports EVQUEUE_WRITE when the connection is established,
+ * EVQUEUE_READ when data arrives after tcp_conn_recv() returned EAGAIN
+ * and EVQUEUE_HUP when the connection fails or is reset.
+ *
+ * @param conn TCP connection
+ * @return Event source
+ */
+evqueue_src_t *tcp_conn_evsrc(tcp_conn_t *conn)
+{
+	return &conn->evsrc;
+}
+
 /** Create a TCP connection listener.
  *
  * A listener listens for connections on the set of endpoints specified
@@ -439,6 +505,59 @@ errno_t tcp_conn_wait_connected(tcp_conn_t *conn)
 	}
 }
 
+/** Send data over TCP connection using the tx ring.
+ *
+ * The server is only notified when the ring was empty. If the ring is full,
+ * wait for the server to drain it.
+ *
+ * @param conn  Connection
+ * @param data  Data
+ * @param bytes Data size in bytes
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t tcp_conn_send_ring(tcp_conn_t *conn, const void *data,
+    size_t bytes)
+{
+	tcp_ring_t *ring = &conn->rings->tx;
+	const uint8_t *dp = data;
+	async_exch_t *exch;
+	errno_t rc = EOK;
+	size_t n;
+	bool kick;
+
+	fibril_mutex_lock(&conn->tx_lock);
+
+	while (true) {
+		if (atomic_load(&ring->fin)) {
+			rc = EIO;
+			break;
+		}
+
+		n = tcp_ring_write(ring, dp, bytes, &kick);
+		dp += n;
+		bytes -= n;
+
+		if (bytes == 0) {
+			if (kick) {
+				exch = async_exchange_begin(conn->tcp->sess);
+				async_msg_1(exch, TCP_CONN_TX_KICK, conn->id);
+				async_exchange_end(exch);
+			}
+			break;
+		}
+
+		exch = async_exchange_begin(conn->tcp->sess);
+		rc = async_req_1_0(exch, TCP_CONN_TX_KICK, conn->id);
+		async_exchange_end(exch);
+		if (rc != EOK)
+			break;
+	}
+
+	fibril_mutex_unlock(&conn->tx_lock);
+	return rc;
+}
+
 /** Send data over TCP connection.
  *
  * @param conn  Connection
@@ -452,6 +571,9 @@ errno_t tcp_conn_send(tcp_conn_t *conn, const void *data, size_t bytes)
 	async_exch_t *exch;
 	errno_t rc;
 
+	if (conn->rings != NULL)
+		return tcp_conn_send_ring(conn, data, bytes);
+
 	exch = async_exchange_begin(conn->tcp->sess);
 	aid_t req = async_send_1(exch, TCP_CONN_SEND, conn->id, NULL);
 	rc = async_data_write_start(exch, data, bytes);
@@ -471,6 +593,124 @@ errno_t tcp_conn_send(tcp_conn_t *conn, const void *data, size_t bytes)
 	return rc;
 }
 
+/** Send file data over TCP connection using the tx ring.
+ *
+ * The file is read directly into the ring, without an intermediate buffer.
+ *
+ * @param conn  Connection
+ * @param fd    File descriptor
+ * @param pos   Position in the file, advanced by the amount sent
+ * @param bytes Number of bytes to send
+ * @param nsent Place to store number of bytes sent
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t tcp_conn_send_file_ring(tcp_conn_t *conn, int fd,
+    aoff64_t *pos, size_t bytes, size_t *nsent)
+{
+	tcp_ring_t *ring = &conn->rings->tx;
+	async_exch_t *exch;
+	errno_t rc = EOK;
+	size_t done = 0;
+	size_t space;
+	size_t nr;
+	bool kick = false;
+	void *sp;
+
+	fibril_mutex_lock(&conn->tx_lock);
+
+	while (done < bytes) {
+		if (atomic_load(&ring->fin)) {
+			rc = EIO;
+			break;
+		}
+
+		sp = tcp_ring_wspace(ring, &space);
+		if (space == 0) {
+			/* Wait for the server to drain the ring */
+			exch = async_exchange_begin(conn->tcp->sess);
+			rc = async_req_1_0(exch, TCP_CONN_TX_KICK, conn->id);
+			async_exchange_end(exch);
+			if (rc != EOK)
+				break;
+
+			kick = false;
+			continue;
+		}
+
+		rc = vfs_read(fd, pos, sp, min(space, bytes - done), &nr);
+		if (rc != EOK || nr == 0)
+			break;
+
+		if (tcp_ring_produce(ring, nr))
+			kick = true;
+		done += nr;
+	}
+
+	if (kick) {
+		exch = async_exchange_begin(conn->tcp->sess);
+		async_msg_1(exch, TCP_CONN_TX_KICK, conn->id);
+		async_exchange_end(exch);
+	}
+
+	fibril_mutex_unlock(&conn->tx_lock);
+	*nsent = done;
+	return rc;
+}
+
+/** Send file data over TCP connection.
+ *
+ * If the connection data is passed in shared rings, the file is read
+ * directly into the transmit ring, otherwise it goes through a buffer.
+ * Sending stops early at the end of the file.
+ *
+ * @param conn  Connection
+ * @param fd    File descriptor
+ * @param pos   Position in the file, advanced by the amount sent
+ * @param bytes Number of bytes to send
+ * @param nsent Place to store number of bytes sent or @c NULL
+ *
+ * @return EOK on success or an error code
+ */
+errno_t tcp_conn_send_file(tcp_conn_t *conn, int fd, aoff64_t *pos,
+    size_t bytes, size_t *nsent)
+{
+	size_t done = 0;
+	size_t nr;
+	errno_t rc;
+	void *buf;
+
+	if (conn->rings != NULL) {
+		rc = tcp_conn_send_file_ring(conn, fd, pos, bytes, &done);
+		if (nsent != NULL)
+			*nsent = done;
+		return rc;
+	}
+
+	buf = malloc(TCP_RING_SIZE);
+	if (buf == NULL)
+		return ENOMEM;
+
+	rc = EOK;
+	while (done < bytes) {
+		rc = vfs_read(fd, pos, buf, min((size_t) TCP_RING_SIZE,
+		    bytes - done), &nr);
+		if (rc != EOK || nr == 0)
+			break;
+
+		rc = tcp_conn_send(conn, buf, nr);
+		if (rc != EOK)
+			break;
+
+		done += nr;
+	}
+
+	free(buf);
+	if (nsent != NULL)
+		*nsent = done;
+	return rc;
+}
+
 /** Send FIN.
  *
  * Send FIN, indicating no more data will be send over the connection.
@@ -521,6 +761,43 @@ errno_t tcp_conn_reset(tcp_conn_t *conn)
 	return rc;
 }
 
+/** Read received data from the rx ring.
+ *
+ * If the server waits for space in the ring, it is notified.
+ *
+ * @param conn Connection, must be locked
+ * @param buf  Buffer
+ * @param bsize Buffer size
+ * @param nrecv Place to store actual number of received bytes
+ *
+ * @return EOK on success, EAGAIN if the ring is empty
+ */
+static errno_t tcp_conn_recv_ring(tcp_conn_t *conn, void *buf, size_t bsize,
+    size_t *nrecv)
+{
+	tcp_ring_t *ring = &conn->rings->rx;
+	async_exch_t *exch;
+	size_t n;
+	bool kick;
+	bool fin;
+
+	/* Check the flag first, data put before it was set must be read */
+	fin = atomic_load(&ring->fin);
+
+	n = tcp_ring_read(ring, buf, bsize, &kick);
+	if (kick) {
+		exch = async_exchange_begin(conn->tcp->sess);
+		async_msg_1(exch, TCP_CONN_RX_KICK, conn->id);
+		async_exchange_end(exch);
+	}
+
+	if (n == 0 && !fin && bsize > 0)
+		return EAGAIN;
+
+	*nrecv = n;
+	return EOK;
+}
+
 /** Read received data from connection without blocking.
  *
  * If any received data is pending on the connection, up to @a bsize bytes
@@ -544,6 +821,14 @@ errno_t tcp_conn_recv(tcp_conn_t *conn, void *buf, size_t bsize, size_t *nrecv)
 	ipc_call_t answer;
 
 	fibril_mutex_lock(&conn->lock);
+	if (conn->rings != NULL) {
+		errno_t rc = tcp_conn_recv_ring(conn, buf, bsize, nrecv);
+		if (rc == EAGAIN && !tcp_ring_rd_idle(&conn->rings->rx))
+			rc = tcp_conn_recv_ring(conn, buf, bsize, nrecv);
+		fibril_mutex_unlock(&conn->lock);
+		return rc;
+	}
+
 	if (!conn->data_avail) {
 		fibril_mutex_unlock(&conn->lock);
 		return EAGAIN;
@@ -572,6 +857,45 @@ errno_t tcp_conn_recv(tcp_conn_t *conn, void *buf, size_t bsize, size_t *nrecv)
 	return EOK;
 }
 
+/** Read received data from the rx ring with blocking.
+ *
+ * @param conn Connection
+ * @param buf  Buffer
+ * @param bsize Buffer size
+ * @param nrecv Place to store actual number of received bytes
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t tcp_conn_recv_wait_ring(tcp_conn_t *conn, void *buf,
+    size_t bsize, size_t *nrecv)
+{
+	errno_t rc;
+
+	fibril_mutex_lock(&conn->lock);
+
+	while (true) {
+		rc = tcp_conn_recv_ring(conn, buf, bsize, nrecv);
+		if (rc != EAGAIN)
+			break;
+
+		if (conn->conn_reset) {
+			rc = EIO;
+			break;
+		}
+
+		/* Wait for the empty ring to get data */
+		conn->data_avail = false;
+		if (!tcp_ring_rd_idle(&conn->rings->rx))
+			continue;
+
+		while (!conn->data_avail && !conn->conn_reset)
+			fibril_condvar_wait(&conn->cv, &conn->lock);
+	}
+
+	fibril_mutex_unlock(&conn->lock);
+	return rc;
+}
+
 /** Read received data from connection with blocking.
  *
  * Wait for @a bsize bytes of data to be received and copy them to
@@ -592,6 +916,9 @@ errno_t tcp_conn_recv_wait(tcp_conn_t *conn, void *buf, size_t bsize,
 	async_exch_t *exch;
 	ipc_call_t answer;
 
+	if (conn->rings != NULL)
+		return tcp_conn_recv_wait_ring(conn, buf, bsize, nrecv);
+
 again:
 	fibril_mutex_lock(&conn->lock);
 	while (!conn->data_avail) {
@@ -629,6 +956,59 @@ again:
 	return EOK;
 }
 
+/** Get connection congestion control statistics.
+ *
+ * @param conn Connection
+ * @param stats Place to store statistics
+ *
+ * @return EOK on success or an error code
+ */
+errno_t tcp_conn_stats_get(tcp_conn_t *conn, tcp_conn_stats_t *stats)
+{
+	async_exch_t *exch;
+	ipc_call_t answer;
+
+	exch = async_exchange_begin(conn->tcp->sess);
+	aid_t req = async_send_1(exch, TCP_CONN_STATS, conn->id, &answer);
+	errno_t rc = async_data_read_start(exch, stats,
+	    sizeof(tcp_conn_stats_t));
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+
+	return retval;
+}
+
+/** Set connection send and receive buffer size.
+ *
+ * By default the receive buffer size is adjusted automatically. Setting
+ * it explicitly disables the automatic adjustment.
+ *
+ * @param conn Connection
+ * @param snd_size Send buffer size in bytes or zero to keep current size
+ * @param rcv_size Receive buffer size in bytes or zero to keep current size
+ *
+ * @return EOK on success or an error code
+ */
+errno_t tcp_conn_set_bufsize(tcp_conn_t *conn, size_t snd_size,
+    size_t rcv_size)
+{
+	async_exch_t *exch;
+
+	exch = async_exchange_begin(conn->tcp->sess);
+	errno_t rc = async_req_3_0(exch, TCP_CONN_SET_BUFSIZE, conn->id,
+	    snd_size, rcv_size);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
 /** Connection established event.
  *
  * @param tcp   TCP client
@@ -654,6 +1034,8 @@ static void tcp_ev_connected(tcp_t *tcp, ipc_call_t *icall)
 	fibril_condvar_broadcast(&conn->cv);
 	fibril_mutex_unlock(&conn->lock);
 
+	evqueue_src_notify(&conn->evsrc, EVQUEUE_WRITE);
+
 	async_answer_0(icall, EOK);
 }
 
@@ -682,6 +1064,8 @@ static void tcp_ev_conn_failed(tcp_t *tcp, ipc_call_t *icall)
 	fibril_condvar_broadcast(&conn->cv);
 	fibril_mutex_unlock(&conn->lock);
 
+	evqueue_src_notify(&conn->evsrc, EVQUEUE_HUP);
+
 	async_answer_0(icall, EOK);
 }
 
@@ -710,6 +1094,8 @@ static void tcp_ev_conn_reset(tcp_t *tcp, ipc_call_t *icall)
 	fibril_condvar_broadcast(&conn->cv);
 	fibril_mutex_unlock(&conn->lock);
 
+	evqueue_src_notify(&conn->evsrc, EVQUEUE_HUP);
+
 	async_answer_0(icall, EOK);
 }
 
@@ -733,8 +1119,12 @@ static void tcp_ev_data(tcp_t *tcp, ipc_call_t *icall)
 		return;
 	}
 
+	fibril_mutex_lock(&conn->lock);
 	conn->data_avail = true;
 	fibril_condvar_broadcast(&conn->cv);
+	fibril_mutex_unlock(&conn->lock);
+
+	evqueue_src_notify(&conn->evsrc, EVQUEUE_READ);
 
 	if (conn->cb != NULL && conn->cb->data_avail != NULL)
 		conn->cb->data_avail(conn);
@@ -784,6 +1174,9 @@ static void tcp_ev_new_conn(tcp_t *tcp, ipc_call_t *icall)
 		return;
 	}
 
+	/* Incoming connections are established already */
+	evqueue_src_notify(&conn->evsrc, EVQUEUE_WRITE);
+
 	if (lst->lcb != NULL && lst->lcb->new_conn != NULL) {
 		cinfo = calloc(1, sizeof(tcp_in_conn_t));
 		if (cinfo == NULL) {
@@ -32,14 +32,36 @@
 /** @file UDP API
  */
 
+#include <align.h>
 #include <errno.h>
+#include <evqueue.h>
 #include <inet/endpoint.h>
 #include <inet/udp.h>
 #include <ipc/services.h>
 #include <ipc/udp.h>
 #include <loc.h>
+#include <macros.h>
+#include <mem.h>
 #include <stdlib.h>
 
+/** Size of the buffer for batches of sent or received messages */
+#define UDP_BATCH_SIZE DATA_XFER_LIMIT
+
+/** Maximum number of received messages queued for udp_assoc_recv() */
+#define UDP_RQUEUE_MAX 64
+
+/** Received message queued for udp_assoc_recv() */
+typedef struct {
+	/** Link to udp_assoc_t.rqueue */
+	link_t lrqueue;
+	/** Remote endpoint */
+	inet_ep_t remote_ep;
+	/** Message size */
+	size_t size;
+	/** Message data */
+	uint8_t data[];
+} udp_rqmsg_t;
+
 static void udp_cb_conn(ipc_call_t *, void *);
 
 /** Create callback connection from UDP service.
@@ -90,6 +112,9 @@ errno_t udp_create(udp_t **rudp)
 	fibril_mutex_initialize(&udp->lock);
 	fibril_condvar_initialize(&udp->cv);
 
+	/* Without the buffer, received messages are read one by one */
+	udp->rbatch = malloc(UDP_BATCH_SIZE);
+
 	rc = loc_service_get_id(SERVICE_NAME_UDP, &udp_svcid,
 	    IPC_FLAG_BLOCKING);
 	if (rc != EOK) {
@@ -113,6 +138,8 @@ errno_t udp_create(udp_t **rudp)
 	*rudp = udp;
 	return EOK;
 error:
+	if (udp != NULL)
+		free(udp->rbatch);
 	free(udp);
 	return rc;
 }
@@ -133,6 +160,7 @@ void udp_destroy(udp_t *udp)
 		fibril_condvar_wait(&udp->cv, &udp->lock);
 	fibril_mutex_unlock(&udp->lock);
 
+	free(udp->rbatch);
 	free(udp);
 }
 
@@ -192,6 +220,12 @@ errno_t udp_assoc_create(udp_t *udp, inet_ep2_t *epp, udp_cb_t *cb, void *arg,
 	assoc->id = ipc_get_arg1(&answer);
 	assoc->cb = cb;
 	assoc->cb_arg = arg;
+	evqueue_src_init(&assoc->evsrc);
+	fibril_mutex_initialize(&assoc->lock);
+	list_initialize(&assoc->rqueue);
+
+	/* Nothing prevents sending right away */
+	evqueue_src_notify(&assoc->evsrc, EVQUEUE_WRITE);
 
 	list_append(&assoc->ludp, &udp->assoc);
 	*rassoc = assoc;
@@ -222,6 +256,15 @@ void udp_assoc_destroy(udp_assoc_t *assoc)
 	errno_t rc = async_req_1_0(exch, UDP_ASSOC_DESTROY, assoc->id);
 	async_exchange_end(exch);
 
+	evqueue_remove(&assoc->evsrc);
+
+	while (!list_empty(&assoc->rqueue)) {
+		udp_rqmsg_t *qmsg = list_get_instance(list_first(&assoc->rqueue),
+		    udp_rqmsg_t, lrqueue);
+		list_remove(&qmsg->lrqueue);
+		free(qmsg);
+	}
+
 	free(assoc);
 	(void) rc;
 }
@@ -291,6 +334,145 @@ errno_t udp_assoc_send_msg(udp_assoc_t *assoc, inet_ep_t *dest, void *data,
 	return rc;
 }
 
+/** Receive message queued on UDP association without blocking.
+ *
+ * Messages are only queued if the association has no @c recv_msg callback.
+ * If the buffer is smaller than the message, the rest of the message is
+ * discarded.
+ *
+ * @param assoc UDP association
+ * @param buf   Buffer
+ * @param bsize Buffer size
+ * @param size  Place to store the message size
+ * @param ep    Place to store remote endpoint or @c NULL
+ *
+ * @return EOK on success, EAGAIN if no message is queued
+ */
+errno_t udp_assoc_recv(udp_assoc_t *assoc, void *buf, size_t bsize,
+    size_t *size, inet_ep_t *ep)
+{
+	udp_rqmsg_t *qmsg;
+
+	fibril_mutex_lock(&assoc->lock);
+	if (list_empty(&assoc->rqueue)) {
+		fibril_mutex_unlock(&assoc->lock);
+		return EAGAIN;
+	}
+
+	qmsg = list_get_instance(list_first(&assoc->rqueue), udp_rqmsg_t,
+	    lrqueue);
+	list_remove(&qmsg->lrqueue);
+	--assoc->rqueue_len;
+	fibril_mutex_unlock(&assoc->lock);
+
+	memcpy(buf, qmsg->data, min(bsize, qmsg->size));
+	*size = qmsg->size;
+	if (ep != NULL)
+		*ep = qmsg->remote_ep;
+
+	free(qmsg);
+	return EOK;
+}
+
+/** Get readiness event source of an association.
+ *
+ * The source reports EVQUEUE_READ when a message is queued for
+ * udp_assoc_recv() on an empty queue.
+ *
+ * @param assoc UDP association
+ * @return Event source
+ */
+evqueue_src_t *udp_assoc_evsrc(udp_assoc_t *assoc)
+{
+	return &assoc->evsrc;
+}
+
+/** Send batch of messages via UDP association.
+ *
+ * The messages are packed in as few IPC calls as possible. They are sent
+ * in order until the first one that fails.
+ *
+ * @param assoc Association
+ * @param msgs  Messages
+ * @param count Number of messages
+ * @param nsent Place to store number of messages sent or @c NULL
+ *
+ * @return EOK if all messages were sent or an error code
+ */
+errno_t udp_assoc_send_msgs(udp_assoc_t *assoc, udp_smsg_t *msgs,
+    size_t count, size_t *nsent)
+{
+	async_exch_t *exch;
+	ipc_call_t answer;
+	udp_smsg_hdr_t hdr;
+	uint8_t *buf;
+	size_t done;
+	size_t need;
+	size_t off;
+	size_t padded;
+	size_t n;
+	errno_t rc;
+
+	buf = malloc(UDP_BATCH_SIZE);
+	if (buf == NULL)
+		return ENOMEM;
+
+	done = 0;
+	rc = EOK;
+	while (done < count && rc == EOK) {
+		/* A message that does not fit in a batch is sent alone */
+		if (sizeof(hdr) + msgs[done].size > UDP_BATCH_SIZE) {
+			rc = udp_assoc_send_msg(assoc, msgs[done].dest,
+			    msgs[done].data, msgs[done].size);
+			if (rc == EOK)
+				++done;
+			continue;
+		}
+
+		off = 0;
+		n = 0;
+		while (done + n < count) {
+			udp_smsg_t *msg = &msgs[done + n];
+
+			need = sizeof(hdr) + msg->size;
+			if (need > UDP_BATCH_SIZE - off)
+				break;
+
+			memset(&hdr, 0, sizeof(hdr));
+			if (msg->dest != NULL)
+				hdr.dest = *msg->dest;
+			else
+				inet_ep_init(&hdr.dest);
+			hdr.size = msg->size;
+
+			memcpy(buf + off, &hdr, sizeof(hdr));
+			memcpy(buf + off + sizeof(hdr), msg->data, msg->size);
+			padded = (size_t) ALIGN_UP(need, UDP_BATCH_ALIGN);
+			off += min(padded, UDP_BATCH_SIZE - off);
+			++n;
+		}
+
+		exch = async_exchange_begin(assoc->udp->sess);
+		aid_t req = async_send_2(exch, UDP_ASSOC_SEND_MSGS, assoc->id, n,
+		    &answer);
+		rc = async_data_write_start(exch, buf, off);
+		async_exchange_end(exch);
+
+		if (rc != EOK) {
+			async_forget(req);
+			break;
+		}
+
+		async_wait_for(req, &rc);
+		done += ipc_get_arg1(&answer);
+	}
+
+	free(buf);
+	if (nsent != NULL)
+		*nsent = done;
+	return rc;
+}
+
 /** Get the user/callback argument for an association.
  *
  * @param assoc UDP association
@@ -329,6 +511,15 @@ errno_t udp_rmsg_read(udp_rmsg_t *rmsg, size_t off, void *buf, size_t bsize)
 	async_exch_t *exch;
 	ipc_call_t answer;
 
+	if (rmsg->data != NULL) {
+		if (off > rmsg->size)
+			return EINVAL;
+
+		memcpy(buf, (uint8_t *) rmsg->data + off,
+		    min(bsize, rmsg->size - off));
+		return EOK;
+	}
+
 	exch = async_exchange_begin(rmsg->udp->sess);
 	aid_t req = async_send_1(exch, UDP_RMSG_READ, off, &answer);
 	errno_t rc = async_data_read_start(exch, buf, bsize);
@@ -413,6 +604,7 @@ static errno_t udp_rmsg_info(udp_t *udp, udp_rmsg_t *rmsg)
 	rmsg->assoc_id = ipc_get_arg1(&answer);
 	rmsg->size = ipc_get_arg2(&answer);
 	rmsg->remote_ep = ep;
+	rmsg->data = NULL;
 	return EOK;
 }
 
@@ -432,6 +624,49 @@ static errno_t udp_rmsg_discard(udp_t *udp)
 	return rc;
 }
 
+/** Queue received message for udp_assoc_recv().
+ *
+ * If the queue is full, the message is dropped.
+ *
+ * @param assoc UDP association
+ * @param rmsg  Received message
+ */
+static void udp_assoc_rqueue_add(udp_assoc_t *assoc, udp_rmsg_t *rmsg)
+{
+	udp_rqmsg_t *qmsg;
+	bool was_empty;
+	errno_t rc;
+
+	qmsg = malloc(sizeof(udp_rqmsg_t) + rmsg->size);
+	if (qmsg == NULL)
+		return;
+
+	rc = udp_rmsg_read(rmsg, 0, qmsg->data, rmsg->size);
+	if (rc != EOK) {
+		free(qmsg);
+		return;
+	}
+
+	link_initialize(&qmsg->lrqueue);
+	qmsg->remote_ep = rmsg->remote_ep;
+	qmsg->size = rmsg->size;
+
+	fibril_mutex_lock(&assoc->lock);
+	if (assoc->rqueue_len >= UDP_RQUEUE_MAX) {
+		fibril_mutex_unlock(&assoc->lock);
+		free(qmsg);
+		return;
+	}
+
+	was_empty = list_empty(&assoc->rqueue);
+	list_append(&qmsg->lrqueue, &assoc->rqueue);
+	++assoc->rqueue_len;
+	fibril_mutex_unlock(&assoc->lock);
+
+	if (was_empty)
+		evqueue_src_notify(&assoc->evsrc, EVQUEUE_READ);
+}
+
 /** Get association based on its ID.
  *
  * @param udp    UDP client
@@ -452,6 +687,84 @@ static errno_t udp_assoc_get(udp_t *udp, sysarg_t id, udp_assoc_t **rassoc)
 	return EINVAL;
 }
 
+/** Deliver received message to its association.
+ *
+ * @param udp  UDP client
+ * @param rmsg Received message
+ */
+static void udp_rmsg_deliver(udp_t *udp, udp_rmsg_t *rmsg)
+{
+	udp_assoc_t *assoc;
+	errno_t rc;
+
+	rc = udp_assoc_get(udp, rmsg->assoc_id, &assoc);
+	if (rc != EOK)
+		return;
+
+	if (assoc->cb != NULL && assoc->cb->recv_msg != NULL)
+		assoc->cb->recv_msg(assoc, rmsg);
+	else
+		udp_assoc_rqueue_add(assoc, rmsg);
+}
+
+/** Read and deliver a batch of received messages.
+ *
+ * @param udp UDP client
+ * @return EOK on success, ENOENT if no message is waiting, EOVERFLOW if
+ *         the next message does not fit in a batch and needs to be read
+ *         by itself, or an error code
+ */
+static errno_t udp_rmsg_read_batch(udp_t *udp)
+{
+	async_exch_t *exch;
+	ipc_call_t answer;
+	udp_rmsg_hdr_t hdr;
+	udp_rmsg_t rmsg;
+	uint8_t *buf = udp->rbatch;
+	size_t count;
+	size_t off;
+	size_t i;
+
+	if (buf == NULL)
+		return ENOTSUP;
+
+	exch = async_exchange_begin(udp->sess);
+	aid_t req = async_send_0(exch, UDP_RMSG_READ_BATCH, &answer);
+	errno_t rc = async_data_read_start(exch, buf, UDP_BATCH_SIZE);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	if (retval != EOK)
+		return retval;
+
+	count = ipc_get_arg1(&answer);
+	off = 0;
+	for (i = 0; i < count; i++) {
+		memcpy(&hdr, buf + off, sizeof(hdr));
+		if (hdr.size > UDP_BATCH_SIZE - off - sizeof(hdr))
+			return EIO;
+
+		rmsg.udp = udp;
+		rmsg.assoc_id = hdr.assoc_id;
+		rmsg.size = hdr.size;
+		rmsg.remote_ep = hdr.remote_ep;
+		rmsg.data = buf + off + sizeof(hdr);
+		udp_rmsg_deliver(udp, &rmsg);
+
+		off += ALIGN_UP(sizeof(hdr) + hdr.size, UDP_BATCH_ALIGN);
+		if (off > UDP_BATCH_SIZE)
+			break;
+	}
+
+	return EOK;
+}
+
 /** Handle 'data' event, i.e. some message(s) arrived.
  *
  * For each received message, get information about it, call @c recv_msg
@@ -464,22 +777,22 @@ static errno_t udp_assoc_get(udp_t *udp, sysarg_t id, udp_assoc_t **rassoc)
 static void udp_ev_data(udp_t *udp, ipc_call_t *icall)
 {
 	udp_rmsg_t rmsg;
-	udp_assoc_t *assoc;
 	errno_t rc;
 
 	while (true) {
-		rc = udp_rmsg_info(udp, &rmsg);
-		if (rc != EOK) {
+		rc = udp_rmsg_read_batch(udp);
+		if (rc == EOK)
+			continue;
+		if (rc == ENOENT)
 			break;
-		}
 
-		rc = udp_assoc_get(udp, rmsg.assoc_id, &assoc);
+		/* Read the next message by itself */
+		rc = udp_rmsg_info(udp, &rmsg);
 		if (rc != EOK) {
-			continue;
+			break;
 		}
 
-		if (assoc->cb != NULL && assoc->cb->recv_msg != NULL)
-			assoc->cb->recv_msg(assoc, &rmsg);
+		udp_rmsg_deliver(udp, &rmsg);
 
 		rc = udp_rmsg_discard(udp);
 		if (rc != EOK) {
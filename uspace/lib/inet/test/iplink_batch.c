@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <inet/iplink_batch.h>
+#include <mem.h>
+#include <pcut/pcut.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(iplink_batch);
+
+/** SDUs added to a batch are returned by iplink_batch_get() in order */
+PCUT_TEST(add_get)
+{
+	iplink_batch_t *batch;
+	iplink_batch_hdr_t hdr;
+	iplink_recv_sdu_t rsdu;
+	iplink_sdu_t sdu;
+	char d1[] = "abc";
+	char d2[] = "defgh";
+	size_t offs = 0;
+	void *data;
+	errno_t rc;
+
+	rc = iplink_batch_create(256, &batch);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rsdu.data = d1;
+	rsdu.size = sizeof(d1);
+	rc = iplink_batch_add_recv(batch, &rsdu, ip_v6);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	sdu.src = 1;
+	sdu.dest = 2;
+	sdu.data = d2;
+	sdu.size = sizeof(d2);
+	rc = iplink_batch_add_send(batch, &sdu);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(2, batch->count);
+
+	rc = iplink_batch_get(batch->buf, batch->size, &offs, &hdr, &data);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(sizeof(d1), hdr.size);
+	PCUT_ASSERT_INT_EQUALS(ip_v6, hdr.ver);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(data, d1, sizeof(d1)));
+
+	rc = iplink_batch_get(batch->buf, batch->size, &offs, &hdr, &data);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(sizeof(d2), hdr.size);
+	PCUT_ASSERT_INT_EQUALS(1, hdr.src);
+	PCUT_ASSERT_INT_EQUALS(2, hdr.dest);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(data, d2, sizeof(d2)));
+
+	rc = iplink_batch_get(batch->buf, batch->size, &offs, &hdr, &data);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+
+	iplink_batch_clear(batch);
+	PCUT_ASSERT_INT_EQUALS(0, batch->count);
+	PCUT_ASSERT_INT_EQUALS(0, batch->size);
+
+	iplink_batch_destroy(batch);
+}
+
+/** An SDU which does not fit is refused */
+PCUT_TEST(add_full)
+{
+	iplink_batch_t *batch;
+	iplink_recv_sdu_t rsdu;
+	char d[64];
+	errno_t rc;
+
+	rc = iplink_batch_create(sizeof(iplink_batch_hdr_t) + sizeof(d), &batch);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	memset(d, 0, sizeof(d));
+	rsdu.data = d;
+	rsdu.size = sizeof(d);
+	rc = iplink_batch_add_recv(batch, &rsdu, ip_v4);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rsdu.size = 1;
+	rc = iplink_batch_add_recv(batch, &rsdu, ip_v4);
+	PCUT_ASSERT_ERRNO_VAL(ELIMIT, rc);
+	PCUT_ASSERT_INT_EQUALS(1, batch->count);
+
+	iplink_batch_destroy(batch);
+}
+
+/** A truncated batch is reported as malformed */
+PCUT_TEST(get_truncated)
+{
+	iplink_batch_t *batch;
+	iplink_batch_hdr_t hdr;
+	iplink_recv_sdu_t rsdu;
+	char d[] = "abcdef";
+	size_t offs = 0;
+	void *data;
+	errno_t rc;
+
+	rc = iplink_batch_create(256, &batch);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rsdu.data = d;
+	rsdu.size = sizeof(d);
+	rc = iplink_batch_add_recv(batch, &rsdu, ip_v4);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = iplink_batch_get(batch->buf, sizeof(iplink_batch_hdr_t) + 2,
+	    &offs, &hdr, &data);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, rc);
+
+	offs = 0;
+	rc = iplink_batch_get(batch->buf, 2, &offs, &hdr, &data);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, rc);
+
+	iplink_batch_destroy(batch);
+}
+
+PCUT_EXPORT(iplink_batch);
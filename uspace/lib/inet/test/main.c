@@ -31,5 +31,8 @@
 PCUT_INIT;
 
 PCUT_IMPORT(eth_addr);
+PCUT_IMPORT(iplink_batch);
+PCUT_IMPORT(rss);
+PCUT_IMPORT(tcp_ring);
 
 PCUT_MAIN();
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <inet/addr.h>
+#include <inet/rss.h>
+#include <pcut/pcut.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(rss);
+
+/** Toeplitz hash of an IPv4 address pair (no ports) */
+PCUT_TEST(hash_ipv4)
+{
+	uint8_t data[] = {
+		66, 9, 149, 187,
+		161, 142, 100, 80
+	};
+
+	PCUT_ASSERT_INT_EQUALS(0x323e8fc2,
+	    inet_rss_hash(inet_rss_default_key, data, sizeof(data)));
+}
+
+/** Toeplitz hash of IPv4 TCP flows */
+PCUT_TEST(hash_flow_ipv4)
+{
+	inet_addr_t src;
+	inet_addr_t dest;
+
+	inet_addr(&src, 66, 9, 149, 187);
+	inet_addr(&dest, 161, 142, 100, 80);
+	PCUT_ASSERT_INT_EQUALS(0x51ccc178, inet_rss_hash_flow(
+	    inet_rss_default_key, &src, &dest, 2794, 1766));
+
+	inet_addr(&src, 199, 92, 111, 2);
+	inet_addr(&dest, 65, 69, 140, 83);
+	PCUT_ASSERT_INT_EQUALS(0xc626b0ea, inet_rss_hash_flow(
+	    inet_rss_default_key, &src, &dest, 14230, 4739));
+
+	inet_addr(&src, 24, 19, 198, 95);
+	inet_addr(&dest, 12, 22, 207, 184);
+	PCUT_ASSERT_INT_EQUALS(0x5c2b394a, inet_rss_hash_flow(
+	    inet_rss_default_key, &src, &dest, 12898, 38024));
+}
+
+/** Toeplitz hash of an IPv6 TCP flow */
+PCUT_TEST(hash_flow_ipv6)
+{
+	inet_addr_t src;
+	inet_addr_t dest;
+
+	inet_addr6(&src, 0x3ffe, 0x2501, 0x200, 0x1fff, 0, 0, 0, 7);
+	inet_addr6(&dest, 0x3ffe, 0x2501, 0x200, 0x3, 0, 0, 0, 1);
+	PCUT_ASSERT_INT_EQUALS(0x40207d3d, inet_rss_hash_flow(
+	    inet_rss_default_key, &src, &dest, 2794, 1766));
+}
+
+/** Addresses of different versions do not hash */
+PCUT_TEST(hash_flow_mixed)
+{
+	inet_addr_t src;
+	inet_addr_t dest;
+
+	inet_addr(&src, 10, 0, 0, 1);
+	inet_addr6(&dest, 0x3ffe, 0x2501, 0x200, 0x3, 0, 0, 0, 1);
+	PCUT_ASSERT_INT_EQUALS(0, inet_rss_hash_flow(inet_rss_default_key,
+	    &src, &dest, 1, 2));
+}
+
+PCUT_EXPORT(rss);
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ipc/tcp.h>
+#include <mem.h>
+#include <pcut/pcut.h>
+#include <stdlib.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(tcp_ring);
+
+/** Data written to a ring is read back in order, also across the wrap */
+PCUT_TEST(write_read_wrap)
+{
+	tcp_ring_t *ring;
+	uint8_t out[1000];
+	uint8_t in[1000];
+	size_t n;
+	bool kick;
+	int i;
+
+	ring = calloc(1, sizeof(tcp_ring_t));
+	PCUT_ASSERT_NOT_NULL(ring);
+	tcp_ring_init(ring);
+
+	for (i = 0; i < (int) sizeof(out); i++)
+		out[i] = i % 251;
+
+	/* Move the positions close to the end of the data area */
+	atomic_store(&ring->head, TCP_RING_SIZE - 100);
+	atomic_store(&ring->tail, TCP_RING_SIZE - 100);
+
+	n = tcp_ring_write(ring, out, sizeof(out), &kick);
+	PCUT_ASSERT_INT_EQUALS(sizeof(out), n);
+	PCUT_ASSERT_TRUE(kick);
+
+	n = tcp_ring_read(ring, in, sizeof(in), &kick);
+	PCUT_ASSERT_INT_EQUALS(sizeof(in), n);
+	PCUT_ASSERT_FALSE(kick);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(in, out, sizeof(in)));
+
+	n = tcp_ring_read(ring, in, sizeof(in), &kick);
+	PCUT_ASSERT_INT_EQUALS(0, n);
+
+	free(ring);
+}
+
+/** The consumer is only notified once per empty to non-empty transition */
+PCUT_TEST(rd_kick)
+{
+	tcp_ring_t *ring;
+	uint8_t buf[16];
+	bool kick;
+
+	ring = calloc(1, sizeof(tcp_ring_t));
+	PCUT_ASSERT_NOT_NULL(ring);
+	tcp_ring_init(ring);
+
+	(void) tcp_ring_write(ring, "abc", 3, &kick);
+	PCUT_ASSERT_TRUE(kick);
+	(void) tcp_ring_write(ring, "def", 3, &kick);
+	PCUT_ASSERT_FALSE(kick);
+
+	/* Data is pending, the consumer cannot wait */
+	PCUT_ASSERT_FALSE(tcp_ring_rd_idle(ring));
+
+	PCUT_ASSERT_INT_EQUALS(6, tcp_ring_read(ring, buf, sizeof(buf), &kick));
+	PCUT_ASSERT_TRUE(tcp_ring_rd_idle(ring));
+
+	(void) tcp_ring_write(ring, "g", 1, &kick);
+	PCUT_ASSERT_TRUE(kick);
+
+	free(ring);
+}
+
+/** A producer waiting on a full ring is notified when space is freed */
+PCUT_TEST(wr_kick)
+{
+	tcp_ring_t *ring;
+	uint8_t *buf;
+	uint8_t c;
+	size_t n;
+	bool kick;
+
+	ring = calloc(1, sizeof(tcp_ring_t));
+	PCUT_ASSERT_NOT_NULL(ring);
+	buf = calloc(1, TCP_RING_SIZE + 1);
+	PCUT_ASSERT_NOT_NULL(buf);
+	tcp_ring_init(ring);
+
+	n = tcp_ring_write(ring, buf, TCP_RING_SIZE + 1, &kick);
+	PCUT_ASSERT_INT_EQUALS(TCP_RING_SIZE, n);
+	PCUT_ASSERT_TRUE(tcp_ring_wr_idle(ring));
+
+	n = tcp_ring_read(ring, &c, 1, &kick);
+	PCUT_ASSERT_INT_EQUALS(1, n);
+	PCUT_ASSERT_TRUE(kick);
+
+	/* Space is available, the producer cannot wait */
+	PCUT_ASSERT_FALSE(tcp_ring_wr_idle(ring));
+
+	free(buf);
+	free(ring);
+}
+
+PCUT_EXPORT(tcp_ring);
@@ -45,6 +45,7 @@ extern gfx_context_ops_t ipc_gc_ops;
 
 extern errno_t ipc_gc_create(async_sess_t *, ipc_gc_t **);
 extern errno_t ipc_gc_delete(ipc_gc_t *);
+extern errno_t ipc_gc_cmdbuf_enable(ipc_gc_t *);
 extern gfx_context_t *ipc_gc_get_ctx(ipc_gc_t *);
 
 #endif
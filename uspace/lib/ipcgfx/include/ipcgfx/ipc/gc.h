@@ -36,6 +36,7 @@
 #define _IPCGFX_IPC_GC_H_
 
 #include <ipc/common.h>
+#include <stdint.h>
 
 typedef enum {
 	GC_SET_CLIP_RECT = IPC_FIRST_USER_METHOD,
@@ -48,8 +49,33 @@ typedef enum {
 	GC_BITMAP_DESTROY,
 	GC_BITMAP_RENDER,
 	GC_BITMAP_GET_ALLOC,
+	GC_CMDBUF_SETUP,
+	GC_CMDBUF_SUBMIT,
 } gc_request_t;
 
+enum {
+	/** Size of command buffer in bytes */
+	GC_CMDBUF_SIZE = 16384
+};
+
+/** Command recorded in command buffer.
+ *
+ * A command buffer shared with GC_CMDBUF_SETUP holds an array of these.
+ * GC_CMDBUF_SUBMIT replays the first @c arg1 of them in order, followed
+ * by an update if @c arg2 is non-zero.
+ */
+typedef struct {
+	/** GC_SET_CLIP_RECT, GC_SET_CLIP_RECT_NULL, GC_SET_RGB_COLOR or
+	 * GC_FILL_RECT
+	 */
+	uint32_t method;
+	/** Arguments as they would be passed with the request */
+	int32_t arg[4];
+} gc_cmd_t;
+
+/** Number of commands that fit in command buffer */
+#define GC_CMDBUF_CMDS (GC_CMDBUF_SIZE / sizeof(gc_cmd_t))
+
 #endif
 
 /** @}
@@ -39,6 +39,8 @@
 
 #include <async.h>
 #include <gfx/context.h>
+#include <ipcgfx/ipc/gc.h>
+#include <stddef.h>
 
 /** Actual structure of graphics context.
  *
@@ -49,6 +51,10 @@ struct ipc_gc {
 	gfx_context_t *gc;
 	/** Session with GFX server */
 	async_sess_t *sess;
+	/** Command buffer shared with server or @c NULL if not batching */
+	gc_cmd_t *cmdbuf;
+	/** Number of commands recorded in command buffer */
+	size_t cmd_count;
 };
 
 /** Bitmap in IPC GC */
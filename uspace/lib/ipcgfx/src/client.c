@@ -54,6 +54,8 @@ static errno_t ipc_gc_bitmap_destroy(void *);
 static errno_t ipc_gc_bitmap_render(void *, gfx_rect_t *, gfx_coord2_t *);
 static errno_t ipc_gc_bitmap_get_alloc(void *, gfx_bitmap_alloc_t *);
 
+static errno_t ipc_gc_cmdbuf_submit(ipc_gc_t *, bool);
+
 gfx_context_ops_t ipc_gc_ops = {
 	.set_clip_rect = ipc_gc_set_clip_rect,
 	.set_color = ipc_gc_set_color,
@@ -65,6 +67,75 @@ gfx_context_ops_t ipc_gc_ops = {
 	.bitmap_get_alloc = ipc_gc_bitmap_get_alloc
 };
 
+/** Record command in IPC GC command buffer.
+ *
+ * If the buffer is full, it is submitted first.
+ *
+ * @param ipcgc IPC GC
+ * @param method Request
+ * @param a0 First argument
+ * @param a1 Second argument
+ * @param a2 Third argument
+ * @param a3 Fourth argument
+ *
+ * @return EOK on success or an error code from submitting the buffer
+ */
+static errno_t ipc_gc_cmd_add(ipc_gc_t *ipcgc, gc_request_t method,
+    int32_t a0, int32_t a1, int32_t a2, int32_t a3)
+{
+	gc_cmd_t *cmd;
+	errno_t rc = EOK;
+
+	if (ipcgc->cmd_count >= GC_CMDBUF_CMDS)
+		rc = ipc_gc_cmdbuf_submit(ipcgc, false);
+
+	cmd = &ipcgc->cmdbuf[ipcgc->cmd_count++];
+	cmd->method = method;
+	cmd->arg[0] = a0;
+	cmd->arg[1] = a1;
+	cmd->arg[2] = a2;
+	cmd->arg[3] = a3;
+
+	return rc;
+}
+
+/** Submit IPC GC command buffer.
+ *
+ * The server replays the recorded commands in order. The buffer is
+ * empty afterwards, even if some of the commands failed.
+ *
+ * @param ipcgc IPC GC
+ * @param update @c true to update display after replaying the commands
+ *
+ * @return EOK on success or the first error reported by the commands
+ */
+static errno_t ipc_gc_cmdbuf_submit(ipc_gc_t *ipcgc, bool update)
+{
+	async_exch_t *exch;
+	errno_t rc;
+
+	exch = async_exchange_begin(ipcgc->sess);
+	rc = async_req_2_0(exch, GC_CMDBUF_SUBMIT, ipcgc->cmd_count,
+	    update ? 1 : 0);
+	async_exchange_end(exch);
+
+	ipcgc->cmd_count = 0;
+	return rc;
+}
+
+/** Submit recorded commands before an operation that is not recorded.
+ *
+ * @param ipcgc IPC GC
+ * @return EOK on success or an error code
+ */
+static errno_t ipc_gc_cmdbuf_flush(ipc_gc_t *ipcgc)
+{
+	if (ipcgc->cmd_count == 0)
+		return EOK;
+
+	return ipc_gc_cmdbuf_submit(ipcgc, false);
+}
+
 /** Set clipping rectangle on IPC GC.
  *
  * @param arg IPC GC
@@ -78,6 +149,15 @@ static errno_t ipc_gc_set_clip_rect(void *arg, gfx_rect_t *rect)
 	async_exch_t *exch;
 	errno_t rc;
 
+	if (ipcgc->cmdbuf != NULL) {
+		if (rect != NULL) {
+			return ipc_gc_cmd_add(ipcgc, GC_SET_CLIP_RECT,
+			    rect->p0.x, rect->p0.y, rect->p1.x, rect->p1.y);
+		}
+
+		return ipc_gc_cmd_add(ipcgc, GC_SET_CLIP_RECT_NULL, 0, 0, 0, 0);
+	}
+
 	exch = async_exchange_begin(ipcgc->sess);
 	if (rect != NULL) {
 		rc = async_req_4_0(exch, GC_SET_CLIP_RECT, rect->p0.x, rect->p0.y,
@@ -109,6 +189,9 @@ static errno_t ipc_gc_set_color(void *arg, gfx_color_t *color)
 
 	gfx_color_get_rgb_i16(color, &r, &g, &b);
 
+	if (ipcgc->cmdbuf != NULL)
+		return ipc_gc_cmd_add(ipcgc, GC_SET_RGB_COLOR, r, g, b, 0);
+
 	exch = async_exchange_begin(ipcgc->sess);
 	rc = async_req_3_0(exch, GC_SET_RGB_COLOR, r, g, b);
 	async_exchange_end(exch);
@@ -129,6 +212,11 @@ static errno_t ipc_gc_fill_rect(void *arg, gfx_rect_t *rect)
 	async_exch_t *exch;
 	errno_t rc;
 
+	if (ipcgc->cmdbuf != NULL) {
+		return ipc_gc_cmd_add(ipcgc, GC_FILL_RECT, rect->p0.x,
+		    rect->p0.y, rect->p1.x, rect->p1.y);
+	}
+
 	exch = async_exchange_begin(ipcgc->sess);
 	rc = async_req_4_0(exch, GC_FILL_RECT, rect->p0.x, rect->p0.y,
 	    rect->p1.x, rect->p1.y);
@@ -138,6 +226,9 @@ static errno_t ipc_gc_fill_rect(void *arg, gfx_rect_t *rect)
 }
 
 /** Update display on IPC GC.
+ *
+ * If batching, the recorded commands are submitted together with
+ * the update.
  *
  * @param arg IPC GC
  *
@@ -149,6 +240,9 @@ static errno_t ipc_gc_update(void *arg)
 	async_exch_t *exch;
 	errno_t rc;
 
+	if (ipcgc->cmdbuf != NULL)
+		return ipc_gc_cmdbuf_submit(ipcgc, true);
+
 	exch = async_exchange_begin(ipcgc->sess);
 	rc = async_req_0_0(exch, GC_UPDATE);
 	async_exchange_end(exch);
@@ -178,6 +272,10 @@ static errno_t ipc_gc_bitmap_create_normal(void *arg,
 	aid_t req;
 	errno_t rc;
 
+	rc = ipc_gc_cmdbuf_flush(ipcgc);
+	if (rc != EOK)
+		return rc;
+
 	ipcbm = calloc(1, sizeof(ipc_gc_bitmap_t));
 	if (ipcbm == NULL)
 		return ENOMEM;
@@ -284,6 +382,10 @@ static errno_t ipc_gc_bitmap_create_direct_output(void *arg,
 	if (alloc != NULL)
 		return EINVAL;
 
+	rc = ipc_gc_cmdbuf_flush(ipcgc);
+	if (rc != EOK)
+		return rc;
+
 	ipcbm = calloc(1, sizeof(ipc_gc_bitmap_t));
 	if (ipcbm == NULL)
 		return ENOMEM;
@@ -363,6 +465,10 @@ static errno_t ipc_gc_bitmap_destroy(void *bm)
 	async_exch_t *exch;
 	errno_t rc;
 
+	rc = ipc_gc_cmdbuf_flush(ipcbm->ipcgc);
+	if (rc != EOK)
+		return rc;
+
 	exch = async_exchange_begin(ipcbm->ipcgc->sess);
 	rc = async_req_1_0(exch, GC_BITMAP_DESTROY, ipcbm->bmp_id);
 	async_exchange_end(exch);
@@ -410,6 +516,10 @@ static errno_t ipc_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 	/* Destination rectangle */
 	gfx_rect_translate(&offs, &srect, &drect);
 
+	rc = ipc_gc_cmdbuf_flush(ipcbm->ipcgc);
+	if (rc != EOK)
+		return rc;
+
 	exch = async_exchange_begin(ipcbm->ipcgc->sess);
 	req = async_send_3(exch, GC_BITMAP_RENDER, ipcbm->bmp_id, offs.x,
 	    offs.y, &answer);
@@ -495,10 +605,65 @@ errno_t ipc_gc_delete(ipc_gc_t *ipcgc)
 	if (rc != EOK)
 		return rc;
 
+	if (ipcgc->cmdbuf != NULL) {
+		(void) ipc_gc_cmdbuf_flush(ipcgc);
+		as_area_destroy(ipcgc->cmdbuf);
+	}
+
 	free(ipcgc);
 	return EOK;
 }
 
+/** Enable command buffer on IPC GC.
+ *
+ * Setting the clipping rectangle, setting the color and filling
+ * rectangles are then recorded in a buffer shared with the server
+ * instead of being sent one request each. The buffer is submitted
+ * in a single request on update, when it is full or before any
+ * other operation. Errors from recorded operations are reported by
+ * the operation that submits the buffer.
+ *
+ * @param ipcgc IPC GC
+ * @return EOK on success or an error code
+ */
+errno_t ipc_gc_cmdbuf_enable(ipc_gc_t *ipcgc)
+{
+	async_exch_t *exch;
+	ipc_call_t answer;
+	gc_cmd_t *cmdbuf;
+	aid_t req;
+	errno_t rc;
+
+	if (ipcgc->cmdbuf != NULL)
+		return EOK;
+
+	cmdbuf = as_area_create(AS_AREA_ANY, GC_CMDBUF_SIZE, AS_AREA_READ |
+	    AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (cmdbuf == AS_MAP_FAILED)
+		return ENOMEM;
+
+	exch = async_exchange_begin(ipcgc->sess);
+	req = async_send_0(exch, GC_CMDBUF_SETUP, &answer);
+	rc = async_share_out_start(exch, cmdbuf,
+	    AS_AREA_READ | AS_AREA_CACHEABLE);
+	async_exchange_end(exch);
+	if (rc != EOK) {
+		async_forget(req);
+		as_area_destroy(cmdbuf);
+		return rc;
+	}
+
+	async_wait_for(req, &rc);
+	if (rc != EOK) {
+		as_area_destroy(cmdbuf);
+		return rc;
+	}
+
+	ipcgc->cmdbuf = cmdbuf;
+	ipcgc->cmd_count = 0;
+	return EOK;
+}
+
 /** Get generic graphic context from IPC GC.
  *
  * @param ipcgc IPC GC
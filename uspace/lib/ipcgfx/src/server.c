@@ -359,6 +359,120 @@ static void gc_bitmap_render_srv(ipc_gc_srv_t *srvgc, ipc_call_t *icall)
 	async_answer_0(icall, rc);
 }
 
+/** Replay command from command buffer.
+ *
+ * @param srvgc IPC GC server
+ * @param cmd Command
+ * @return EOK on success or an error code
+ */
+static errno_t gc_cmd_replay(ipc_gc_srv_t *srvgc, gc_cmd_t *cmd)
+{
+	gfx_color_t *color;
+	gfx_rect_t rect;
+	errno_t rc;
+
+	rect.p0.x = cmd->arg[0];
+	rect.p0.y = cmd->arg[1];
+	rect.p1.x = cmd->arg[2];
+	rect.p1.y = cmd->arg[3];
+
+	switch (cmd->method) {
+	case GC_SET_CLIP_RECT:
+		return gfx_set_clip_rect(srvgc->gc, &rect);
+	case GC_SET_CLIP_RECT_NULL:
+		return gfx_set_clip_rect(srvgc->gc, NULL);
+	case GC_SET_RGB_COLOR:
+		rc = gfx_color_new_rgb_i16(cmd->arg[0], cmd->arg[1],
+		    cmd->arg[2], &color);
+		if (rc != EOK)
+			return ENOMEM;
+
+		rc = gfx_set_color(srvgc->gc, color);
+		gfx_color_delete(color);
+		return rc;
+	case GC_FILL_RECT:
+		return gfx_fill_rect(srvgc->gc, &rect);
+	default:
+		return EINVAL;
+	}
+}
+
+static void gc_cmdbuf_setup_srv(ipc_gc_srv_t *srvgc, ipc_call_t *icall)
+{
+	ipc_call_t call;
+	size_t size;
+	unsigned int flags;
+	void *cmdbuf;
+	errno_t rc;
+
+	if (!async_share_out_receive(&call, &size, &flags)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	if (srvgc->cmdbuf != NULL) {
+		async_answer_0(&call, EEXIST);
+		async_answer_0(icall, EEXIST);
+		return;
+	}
+
+	/* Check size */
+	if (size != PAGES2SIZE(SIZE2PAGES(GC_CMDBUF_SIZE))) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	rc = async_share_out_finalize(&call, &cmdbuf);
+	if (rc != EOK || cmdbuf == AS_MAP_FAILED) {
+		async_answer_0(&call, ENOMEM);
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	srvgc->cmdbuf = (gc_cmd_t *) cmdbuf;
+	async_answer_0(icall, EOK);
+}
+
+static void gc_cmdbuf_submit_srv(ipc_gc_srv_t *srvgc, ipc_call_t *call)
+{
+	gc_cmd_t cmd;
+	size_t count;
+	size_t i;
+	bool update;
+	errno_t rc;
+	errno_t first = EOK;
+
+	count = ipc_get_arg1(call);
+	update = ipc_get_arg2(call) != 0;
+
+	if (srvgc->cmdbuf == NULL || count > GC_CMDBUF_CMDS) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	/*
+	 * Replay all commands even if some fail, the client has moved on
+	 * and the first error is all it gets to see.
+	 */
+	for (i = 0; i < count; i++) {
+		/* Copy the command, the client can still write to the buffer */
+		cmd = srvgc->cmdbuf[i];
+		rc = gc_cmd_replay(srvgc, &cmd);
+		if (rc != EOK && first == EOK)
+			first = rc;
+	}
+
+	if (update) {
+		rc = gfx_update(srvgc->gc);
+		if (rc != EOK && first == EOK)
+			first = rc;
+	}
+
+	async_answer_0(call, first);
+}
+
 errno_t gc_conn(ipc_call_t *icall, gfx_context_t *gc)
 {
 	ipc_gc_srv_t srvgc;
@@ -371,6 +485,7 @@ errno_t gc_conn(ipc_call_t *icall, gfx_context_t *gc)
 	srvgc.gc = gc;
 	list_initialize(&srvgc.bitmaps);
 	srvgc.next_bmp_id = 1;
+	srvgc.cmdbuf = NULL;
 
 	while (true) {
 		ipc_call_t call;
@@ -411,6 +526,12 @@ errno_t gc_conn(ipc_call_t *icall, gfx_context_t *gc)
 		case GC_BITMAP_RENDER:
 			gc_bitmap_render_srv(&srvgc, &call);
 			break;
+		case GC_CMDBUF_SETUP:
+			gc_cmdbuf_setup_srv(&srvgc, &call);
+			break;
+		case GC_CMDBUF_SUBMIT:
+			gc_cmdbuf_submit_srv(&srvgc, &call);
+			break;
 		default:
 			async_answer_0(&call, EINVAL);
 			break;
@@ -437,6 +558,9 @@ errno_t gc_conn(ipc_call_t *icall, gfx_context_t *gc)
 		link = list_first(&srvgc.bitmaps);
 	}
 
+	if (srvgc.cmdbuf != NULL)
+		as_area_destroy(srvgc.cmdbuf);
+
 	return EOK;
 }
 
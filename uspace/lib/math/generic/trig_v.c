@@ -0,0 +1,508 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libmath
+ * @{
+ */
+/** @file Batch sine and cosine.
+ *
+ * The argument is reduced by the nearest multiple of pi/32, the sine
+ * and cosine of the multiple are taken from a table and combined with
+ * short polynomials for the remainder:
+ *
+ *   sin(j * pi/32 + r) = sin(j * pi/32) * cos(r) + cos(j * pi/32) * sin(r)
+ *
+ * The arguments are processed in chunks by a loop free of data dependent
+ * branches, so that the compiler can vectorize it. The 32-bit variants
+ * are computed in single precision. Arguments outside the reduction range
+ * (and NaN or infinity) are passed to the scalar functions.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <macros.h>
+
+/** Reduction range (64-bit floating point)
+ *
+ * The multiple of pi/32 must fit into 20 bits, so that its products with
+ * the high parts of pi/32 are exact. The bound is 0x1p16 given by its
+ * binary representation.
+ */
+#define REDUCE_MAX_64  UINT64_C(0x40f0000000000000)
+
+/** Reduction range (32-bit floating point)
+ *
+ * The multiple of pi/32 must fit into 12 bits. The bound is 0x1p8.
+ */
+#define REDUCE_MAX_32  UINT32_C(0x43800000)
+
+/** 32 / pi */
+#define INV_PIO32_64  0x1.45f306dc9c883p3
+#define INV_PIO32_32  0x1.45f306p3f
+
+/** pi / 32 split into parts with 33, 33 and 53 significant bits */
+#define PIO32_1_64  0x1.921fb544p-4
+#define PIO32_2_64  0x1.0b4611a6p-38
+#define PIO32_3_64  0x1.3198a2e037073p-73
+
+/** pi / 32 split into parts with 12, 12 and 24 significant bits */
+#define PIO32_1_32  0x1.92p-4f
+#define PIO32_2_32  0x1.fb4p-16f
+#define PIO32_3_32  0x1.4442d2p-28f
+
+/** Sine of j * pi/32 for j = 0 .. 63 (64-bit floating point) */
+static const double sin_table_64[64] = {
+	0x0p0, 0x1.917a6bc29b42cp-4,
+	0x1.8f8b83c69a60bp-3, 0x1.294062ed59f06p-2,
+	0x1.87de2a6aea963p-2, 0x1.e2b5d3806f63bp-2,
+	0x1.1c73b39ae68c8p-1, 0x1.44cf325091dd6p-1,
+	0x1.6a09e667f3bcdp-1, 0x1.8bc806b151741p-1,
+	0x1.a9b66290ea1a3p-1, 0x1.c38b2f180bdb1p-1,
+	0x1.d906bcf328d46p-1, 0x1.e9f4156c62ddap-1,
+	0x1.f6297cff75cbp-1, 0x1.fd88da3d12526p-1,
+	0x1p0, 0x1.fd88da3d12526p-1,
+	0x1.f6297cff75cbp-1, 0x1.e9f4156c62ddap-1,
+	0x1.d906bcf328d46p-1, 0x1.c38b2f180bdb1p-1,
+	0x1.a9b66290ea1a3p-1, 0x1.8bc806b151741p-1,
+	0x1.6a09e667f3bcdp-1, 0x1.44cf325091dd6p-1,
+	0x1.1c73b39ae68c8p-1, 0x1.e2b5d3806f63bp-2,
+	0x1.87de2a6aea963p-2, 0x1.294062ed59f06p-2,
+	0x1.8f8b83c69a60bp-3, 0x1.917a6bc29b42cp-4,
+	0x0p0, -0x1.917a6bc29b42cp-4,
+	-0x1.8f8b83c69a60bp-3, -0x1.294062ed59f06p-2,
+	-0x1.87de2a6aea963p-2, -0x1.e2b5d3806f63bp-2,
+	-0x1.1c73b39ae68c8p-1, -0x1.44cf325091dd6p-1,
+	-0x1.6a09e667f3bcdp-1, -0x1.8bc806b151741p-1,
+	-0x1.a9b66290ea1a3p-1, -0x1.c38b2f180bdb1p-1,
+	-0x1.d906bcf328d46p-1, -0x1.e9f4156c62ddap-1,
+	-0x1.f6297cff75cbp-1, -0x1.fd88da3d12526p-1,
+	-0x1p0, -0x1.fd88da3d12526p-1,
+	-0x1.f6297cff75cbp-1, -0x1.e9f4156c62ddap-1,
+	-0x1.d906bcf328d46p-1, -0x1.c38b2f180bdb1p-1,
+	-0x1.a9b66290ea1a3p-1, -0x1.8bc806b151741p-1,
+	-0x1.6a09e667f3bcdp-1, -0x1.44cf325091dd6p-1,
+	-0x1.1c73b39ae68c8p-1, -0x1.e2b5d3806f63bp-2,
+	-0x1.87de2a6aea963p-2, -0x1.294062ed59f06p-2,
+	-0x1.8f8b83c69a60bp-3, -0x1.917a6bc29b42cp-4,
+};
+
+/** Sine of j * pi/32 for j = 0 .. 63 (32-bit floating point) */
+static const float sin_table_32[64] = {
+	0x0p0f, 0x1.917a6cp-4f, 0x1.8f8b84p-3f, 0x1.294062p-2f,
+	0x1.87de2ap-2f, 0x1.e2b5d4p-2f, 0x1.1c73b4p-1f, 0x1.44cf32p-1f,
+	0x1.6a09e6p-1f, 0x1.8bc806p-1f, 0x1.a9b662p-1f, 0x1.c38b3p-1f,
+	0x1.d906bcp-1f, 0x1.e9f416p-1f, 0x1.f6297cp-1f, 0x1.fd88dap-1f,
+	0x1p0f, 0x1.fd88dap-1f, 0x1.f6297cp-1f, 0x1.e9f416p-1f,
+	0x1.d906bcp-1f, 0x1.c38b3p-1f, 0x1.a9b662p-1f, 0x1.8bc806p-1f,
+	0x1.6a09e6p-1f, 0x1.44cf32p-1f, 0x1.1c73b4p-1f, 0x1.e2b5d4p-2f,
+	0x1.87de2ap-2f, 0x1.294062p-2f, 0x1.8f8b84p-3f, 0x1.917a6cp-4f,
+	0x0p0f, -0x1.917a6cp-4f, -0x1.8f8b84p-3f, -0x1.294062p-2f,
+	-0x1.87de2ap-2f, -0x1.e2b5d4p-2f, -0x1.1c73b4p-1f, -0x1.44cf32p-1f,
+	-0x1.6a09e6p-1f, -0x1.8bc806p-1f, -0x1.a9b662p-1f, -0x1.c38b3p-1f,
+	-0x1.d906bcp-1f, -0x1.e9f416p-1f, -0x1.f6297cp-1f, -0x1.fd88dap-1f,
+	-0x1p0f, -0x1.fd88dap-1f, -0x1.f6297cp-1f, -0x1.e9f416p-1f,
+	-0x1.d906bcp-1f, -0x1.c38b3p-1f, -0x1.a9b662p-1f, -0x1.8bc806p-1f,
+	-0x1.6a09e6p-1f, -0x1.44cf32p-1f, -0x1.1c73b4p-1f, -0x1.e2b5d4p-2f,
+	-0x1.87de2ap-2f, -0x1.294062p-2f, -0x1.8f8b84p-3f, -0x1.917a6cp-4f,
+};
+
+/** One half with the sign of the argument (64-bit floating point)
+ *
+ * Used to round to the nearest integer by truncation. Unlike
+ * a comparison, the bit operations do not prevent vectorization.
+ *
+ * @param x Argument.
+ *
+ * @return 0.5 or -0.5.
+ */
+static inline double half_64(double x)
+{
+	union {
+		double f;
+		uint64_t i;
+	} u = { .f = x };
+
+	u.i = (u.i & (UINT64_C(1) << 63)) | UINT64_C(0x3fe0000000000000);
+	return u.f;
+}
+
+/** One half with the sign of the argument (32-bit floating point)
+ *
+ * @param x Argument.
+ *
+ * @return 0.5f or -0.5f.
+ */
+static inline float half_32(float x)
+{
+	union {
+		float f;
+		uint32_t i;
+	} u = { .f = x };
+
+	u.i = (u.i & (UINT32_C(1) << 31)) | UINT32_C(0x3f000000);
+	return u.f;
+}
+
+/** Sine and cosine within reduction range (64-bit floating point)
+ *
+ * @param x Argument, |x| <= 0x1p16.
+ * @param s Place to store sine value.
+ * @param c Place to store cosine value.
+ */
+static inline void sincos_kernel_64(double x, double *s, double *c)
+{
+	int32_t n = (int32_t) (x * INV_PIO32_64 + half_64(x));
+	double fn = n;
+
+	/* |r| <= pi/64 */
+	double r = ((x - fn * PIO32_1_64) - fn * PIO32_2_64) -
+	    fn * PIO32_3_64;
+	double r2 = r * r;
+
+	double sr = r + r * r2 * (-1.0 / 6 + r2 * (1.0 / 120 +
+	    r2 * (-1.0 / 5040 + r2 * (1.0 / 362880))));
+	double cr = 1.0 + r2 * (-1.0 / 2 + r2 * (1.0 / 24 +
+	    r2 * (-1.0 / 720 + r2 * (1.0 / 40320))));
+
+	int32_t j = n & 63;
+	double sj = sin_table_64[j];
+	double cj = sin_table_64[(j + 16) & 63];
+
+	*s = sj * cr + cj * sr;
+	*c = cj * cr - sj * sr;
+}
+
+/** Sine and cosine within reduction range (32-bit floating point)
+ *
+ * @param x Argument, |x| <= 0x1p8.
+ * @param s Place to store sine value.
+ * @param c Place to store cosine value.
+ */
+static inline void sincos_kernel_32(float x, float *s, float *c)
+{
+	int32_t n = (int32_t) (x * INV_PIO32_32 + half_32(x));
+	float fn = n;
+
+	/* |r| <= pi/64 */
+	float r = ((x - fn * PIO32_1_32) - fn * PIO32_2_32) -
+	    fn * PIO32_3_32;
+	float r2 = r * r;
+
+	float sr = r + r * r2 * (-1.0f / 6 + r2 * (1.0f / 120));
+	float cr = 1.0f + r2 * (-1.0f / 2 + r2 * (1.0f / 24));
+
+	int32_t j = n & 63;
+	float sj = sin_table_32[j];
+	float cj = sin_table_32[(j + 16) & 63];
+
+	*s = sj * cr + cj * sr;
+	*c = cj * cr - sj * sr;
+}
+
+/** Check whether argument is within reduction range (64-bit floating point)
+ *
+ * The check is done on the binary representation, which is also false
+ * for NaN and infinity and does not prevent vectorization.
+ *
+ * @param x Argument.
+ *
+ * @return True if @a x is within reduction range.
+ */
+static inline bool in_range_64(double x)
+{
+	union {
+		double f;
+		uint64_t i;
+	} u = { .f = x };
+
+	return (u.i & ~(UINT64_C(1) << 63)) <= REDUCE_MAX_64;
+}
+
+/** Check whether argument is within reduction range (32-bit floating point)
+ *
+ * @param x Argument.
+ *
+ * @return True if @a x is within reduction range.
+ */
+static inline bool in_range_32(float x)
+{
+	union {
+		float f;
+		uint32_t i;
+	} u = { .f = x };
+
+	return (u.i & ~(UINT32_C(1) << 31)) <= REDUCE_MAX_32;
+}
+
+/** Replace argument outside reduction range by zero (64-bit floating point)
+ *
+ * @param x Argument.
+ *
+ * @return @a x if it is within reduction range, zero otherwise.
+ */
+static inline double range_mask_64(double x)
+{
+	union {
+		double f;
+		uint64_t i;
+	} u = { .f = x };
+
+	u.i &= -(uint64_t) ((u.i & ~(UINT64_C(1) << 63)) <= REDUCE_MAX_64);
+	return u.f;
+}
+
+/** Replace argument outside reduction range by zero (32-bit floating point)
+ *
+ * @param x Argument.
+ *
+ * @return @a x if it is within reduction range, zero otherwise.
+ */
+static inline float range_mask_32(float x)
+{
+	union {
+		float f;
+		uint32_t i;
+	} u = { .f = x };
+
+	u.i &= -(uint32_t) ((u.i & ~(UINT32_C(1) << 31)) <= REDUCE_MAX_32);
+	return u.f;
+}
+
+/** Number of elements computed at once in a vectorizable loop */
+#define CHUNK_SIZE  64
+
+/** Sine and cosine of a chunk of arguments (64-bit floating point)
+ *
+ * Arguments outside reduction range give meaningless results, which
+ * are replaced by the callers.
+ *
+ * @param in Array of arguments.
+ * @param s  Array to store sine values to.
+ * @param c  Array to store cosine values to.
+ * @param n  Number of elements, at most CHUNK_SIZE.
+ */
+static void sincos_chunk_64(const double *in, double *restrict s,
+    double *restrict c, size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		double x = range_mask_64(in[i]);
+		sincos_kernel_64(x, &s[i], &c[i]);
+	}
+}
+
+/** Sine and cosine of a chunk of arguments (32-bit floating point)
+ *
+ * Arguments outside reduction range give meaningless results, which
+ * are replaced by the callers.
+ *
+ * @param in Array of arguments.
+ * @param s  Array to store sine values to.
+ * @param c  Array to store cosine values to.
+ * @param n  Number of elements, at most CHUNK_SIZE.
+ */
+static void sincos_chunk_32(const float *in, float *restrict s,
+    float *restrict c, size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		float x = range_mask_32(in[i]);
+		sincos_kernel_32(x, &s[i], &c[i]);
+	}
+}
+
+/** Batch sine (64-bit floating point)
+ *
+ * @param in  Array of arguments.
+ * @param out Array to store sine values to, can be the same as @a in.
+ * @param n   Number of elements.
+ */
+void sin_v(const double *in, double *out, size_t n)
+{
+	double s[CHUNK_SIZE];
+	double c[CHUNK_SIZE];
+
+	while (n > 0) {
+		size_t cnt = min(n, CHUNK_SIZE);
+
+		sincos_chunk_64(in, s, c, cnt);
+		for (size_t i = 0; i < cnt; i++) {
+			out[i] = in_range_64(in[i]) ? s[i] :
+			    sin(in[i]);
+		}
+
+		in += cnt;
+		out += cnt;
+		n -= cnt;
+	}
+}
+
+/** Batch sine (32-bit floating point)
+ *
+ * @param in  Array of arguments.
+ * @param out Array to store sine values to, can be the same as @a in.
+ * @param n   Number of elements.
+ */
+void sinf_v(const float *in, float *out, size_t n)
+{
+	float s[CHUNK_SIZE];
+	float c[CHUNK_SIZE];
+
+	while (n > 0) {
+		size_t cnt = min(n, CHUNK_SIZE);
+
+		sincos_chunk_32(in, s, c, cnt);
+		for (size_t i = 0; i < cnt; i++) {
+			out[i] = in_range_32(in[i]) ? s[i] :
+			    sinf(in[i]);
+		}
+
+		in += cnt;
+		out += cnt;
+		n -= cnt;
+	}
+}
+
+/** Batch cosine (64-bit floating point)
+ *
+ * @param in  Array of arguments.
+ * @param out Array to store cosine values to, can be the same as @a in.
+ * @param n   Number of elements.
+ */
+void cos_v(const double *in, double *out, size_t n)
+{
+	double s[CHUNK_SIZE];
+	double c[CHUNK_SIZE];
+
+	while (n > 0) {
+		size_t cnt = min(n, CHUNK_SIZE);
+
+		sincos_chunk_64(in, s, c, cnt);
+		for (size_t i = 0; i < cnt; i++) {
+			out[i] = in_range_64(in[i]) ? c[i] :
+			    cos(in[i]);
+		}
+
+		in += cnt;
+		out += cnt;
+		n -= cnt;
+	}
+}
+
+/** Batch cosine (32-bit floating point)
+ *
+ * @param in  Array of arguments.
+ * @param out Array to store cosine values to, can be the same as @a in.
+ * @param n   Number of elements.
+ */
+void cosf_v(const float *in, float *out, size_t n)
+{
+	float s[CHUNK_SIZE];
+	float c[CHUNK_SIZE];
+
+	while (n > 0) {
+		size_t cnt = min(n, CHUNK_SIZE);
+
+		sincos_chunk_32(in, s, c, cnt);
+		for (size_t i = 0; i < cnt; i++) {
+			out[i] = in_range_32(in[i]) ? c[i] :
+			    cosf(in[i]);
+		}
+
+		in += cnt;
+		out += cnt;
+		n -= cnt;
+	}
+}
+
+/** Batch sine and cosine (64-bit floating point)
+ *
+ * @param in   Array of arguments.
+ * @param sout Array to store sine values to, can be the same as @a in.
+ * @param cout Array to store cosine values to, can be the same as @a in.
+ * @param n    Number of elements.
+ */
+void sincos_v(const double *in, double *sout, double *cout, size_t n)
+{
+	double s[CHUNK_SIZE];
+	double c[CHUNK_SIZE];
+
+	while (n > 0) {
+		size_t cnt = min(n, CHUNK_SIZE);
+
+		sincos_chunk_64(in, s, c, cnt);
+		for (size_t i = 0; i < cnt; i++) {
+			if (in_range_64(in[i])) {
+				sout[i] = s[i];
+				cout[i] = c[i];
+			} else {
+				sincos(in[i], &sout[i], &cout[i]);
+			}
+		}
+
+		in += cnt;
+		sout += cnt;
+		cout += cnt;
+		n -= cnt;
+	}
+}
+
+/** Batch sine and cosine (32-bit floating point)
+ *
+ * @param in   Array of arguments.
+ * @param sout Array to store sine values to, can be the same as @a in.
+ * @param cout Array to store cosine values to, can be the same as @a in.
+ * @param n    Number of elements.
+ */
+void sincosf_v(const float *in, float *sout, float *cout, size_t n)
+{
+	float s[CHUNK_SIZE];
+	float c[CHUNK_SIZE];
+
+	while (n > 0) {
+		size_t cnt = min(n, CHUNK_SIZE);
+
+		sincos_chunk_32(in, s, c, cnt);
+		for (size_t i = 0; i < cnt; i++) {
+			if (in_range_32(in[i])) {
+				sout[i] = s[i];
+				cout[i] = c[i];
+			} else {
+				sincosf(in[i], &sout[i], &cout[i]);
+			}
+		}
+
+		in += cnt;
+		sout += cnt;
+		cout += cnt;
+		n -= cnt;
+	}
+}
+
+/** @}
+ */
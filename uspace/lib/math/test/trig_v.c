@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pcut/pcut.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(trig_v);
+
+/** Maximum error tolerated against the correctly rounded result */
+#define MAX_ULP 4
+
+typedef struct {
+	double x;
+	double sin;
+	double cos;
+} double_case_t;
+
+typedef struct {
+	float x;
+	float sin;
+	float cos;
+} float_case_t;
+
+static const double_case_t double_cases[] = {
+	{ 0x1.0000000000000p-1, 0x1.eaee8744b05f0p-2, 0x1.c1528065b7d50p-1 },
+	{ -0x1.0000000000000p0, -0x1.aed548f090ceep-1, 0x1.14a280fb5068cp-1 },
+	{ 0x1.8000000000000p1, 0x1.210386db6d55bp-3, -0x1.fae04be85e5d2p-1 },
+	{ -0x1.d000000000000p2, -0x1.a56adb62a27b9p-1, 0x1.22c6f50dc3fbep-1 },
+	{ 0x1.9000000000000p6, -0x1.03425b78c4db8p-1, 0x1.b981dbf665fdfp-1 },
+	{ 0x1.34a0000000000p10, 0x1.29c531dfd031bp-3, -0x1.fa8f2ceb78372p-1 },
+	{ -0x1.81fe34208b018p6, -0x1.8e39388854025p-1, -0x1.41cf80188387bp-1 },
+	{ 0x1.100f8472d4b88p7, -0x1.9e0506e1bf207p-1, -0x1.2d3793ce8f315p-1 },
+	{ 0x1.d64397163c358p8, -0x1.a7bf43d0f5e39p-1, 0x1.1f5f19b757da5p-1 },
+	{ -0x1.cd18730c739ccp8, -0x1.5112439acabb9p-1, -0x1.816452ea0eee5p-1 },
+	{ 0x1.6642af61783ccp7, -0x1.e6d59108fdf08p-5, -0x1.ff1857b27f2b2p-1 },
+	{ 0x1.ddfc1639b5e76p8, 0x1.c903e32b8d666p-2, 0x1.ca2de74347256p-1 },
+	{ -0x1.afc91bbbd3904p7, -0x1.89abf56001a4dp-1, -0x1.475cf271a79ddp-1 },
+	{ -0x1.89f90daab8161p8, 0x1.e994ff07b8418p-1, -0x1.2bb08319b20c7p-2 },
+	{ -0x1.f7ee09e7eb300p0, -0x1.d80b6b3024df6p-1, -0x1.8c93259c7b184p-2 },
+	{ -0x1.a685b9cda32dcp8, -0x1.ffe0b9c7553bdp-1, 0x1.65e37c209bf6ap-6 },
+};
+
+static const float_case_t float_cases[] = {
+	{ 0x1.000000p-1f, 0x1.eaee88p-2f, 0x1.c15280p-1f },
+	{ -0x1.000000p0f, -0x1.aed548p-1f, 0x1.14a280p-1f },
+	{ 0x1.800000p1f, 0x1.210386p-3f, -0x1.fae04cp-1f },
+	{ -0x1.d00000p2f, -0x1.a56adcp-1f, 0x1.22c6f6p-1f },
+	{ 0x1.900000p6f, -0x1.03425cp-1f, 0x1.b981dcp-1f },
+	{ 0x1.900000p7f, -0x1.bf20d2p-1f, 0x1.f2e154p-2f },
+	{ -0x1.8b8974p6f, 0x1.fe8646p-1f, -0x1.36bd3cp-4f },
+	{ 0x1.00e4c0p7f, 0x1.674fbap-2f, -0x1.df7200p-1f },
+	{ 0x1.fcb820p5f, 0x1.60010ap-1f, 0x1.73cd74p-1f },
+	{ 0x1.40c4c6p6f, -0x1.fe4c6ap-1f, 0x1.4da778p-4f },
+	{ -0x1.11016ap5f, -0x1.ac93c0p-2f, -0x1.d0ffd6p-1f },
+	{ -0x1.22339cp5f, 0x1.fa7c9ap-1f, 0x1.2bbd1ap-3f },
+	{ -0x1.865986p7f, -0x1.8b16b0p-2f, 0x1.d85b26p-1f },
+	{ -0x1.045e74p6f, -0x1.8b02f6p-1f, -0x1.45bec0p-1f },
+	{ 0x1.2f4628p6f, 0x1.a1d0f4p-2f, 0x1.d370fcp-1f },
+	{ -0x1.78b372p7f, 0x1.281532p-3f, 0x1.fa9f00p-1f },
+};
+
+#define DOUBLE_CASES (sizeof(double_cases) / sizeof(double_cases[0]))
+#define FLOAT_CASES (sizeof(float_cases) / sizeof(float_cases[0]))
+
+static inline int64_t dint(double x)
+{
+	union {
+		double f;
+		int64_t i;
+	} u = { .f = x };
+	return u.i;
+}
+
+static inline int32_t fint(float x)
+{
+	union {
+		float f;
+		int32_t i;
+	} u = { .f = x };
+	return u.i;
+}
+
+/* All reference values are nonzero, so the representations can be compared */
+#define assert_double_close(x, y) \
+	PCUT_ASSERT_TRUE(llabs(dint(x) - dint(y)) <= MAX_ULP)
+#define assert_float_close(x, y) \
+	PCUT_ASSERT_TRUE(abs(fint(x) - fint(y)) <= MAX_ULP)
+
+PCUT_TEST(sin_v)
+{
+	double in[DOUBLE_CASES];
+	double out[DOUBLE_CASES];
+
+	for (size_t i = 0; i < DOUBLE_CASES; i++)
+		in[i] = double_cases[i].x;
+
+	sin_v(in, out, DOUBLE_CASES);
+
+	for (size_t i = 0; i < DOUBLE_CASES; i++)
+		assert_double_close(out[i], double_cases[i].sin);
+}
+
+PCUT_TEST(cos_v)
+{
+	double in[DOUBLE_CASES];
+	double out[DOUBLE_CASES];
+
+	for (size_t i = 0; i < DOUBLE_CASES; i++)
+		in[i] = double_cases[i].x;
+
+	cos_v(in, out, DOUBLE_CASES);
+
+	for (size_t i = 0; i < DOUBLE_CASES; i++)
+		assert_double_close(out[i], double_cases[i].cos);
+}
+
+PCUT_TEST(sinf_v)
+{
+	float in[FLOAT_CASES];
+	float out[FLOAT_CASES];
+
+	for (size_t i = 0; i < FLOAT_CASES; i++)
+		in[i] = float_cases[i].x;
+
+	sinf_v(in, out, FLOAT_CASES);
+
+	for (size_t i = 0; i < FLOAT_CASES; i++)
+		assert_float_close(out[i], float_cases[i].sin);
+}
+
+PCUT_TEST(cosf_v)
+{
+	float in[FLOAT_CASES];
+	float out[FLOAT_CASES];
+
+	for (size_t i = 0; i < FLOAT_CASES; i++)
+		in[i] = float_cases[i].x;
+
+	cosf_v(in, out, FLOAT_CASES);
+
+	for (size_t i = 0; i < FLOAT_CASES; i++)
+		assert_float_close(out[i], float_cases[i].cos);
+}
+
+PCUT_TEST(sincos_v_matches)
+{
+	double in[DOUBLE_CASES];
+	double s[DOUBLE_CASES];
+	double c[DOUBLE_CASES];
+	double s1[DOUBLE_CASES];
+	double c1[DOUBLE_CASES];
+
+	for (size_t i = 0; i < DOUBLE_CASES; i++)
+		in[i] = double_cases[i].x;
+
+	sincos_v(in, s, c, DOUBLE_CASES);
+	sin_v(in, s1, DOUBLE_CASES);
+	cos_v(in, c1, DOUBLE_CASES);
+
+	for (size_t i = 0; i < DOUBLE_CASES; i++) {
+		PCUT_ASSERT_EQUALS(dint(s1[i]), dint(s[i]));
+		PCUT_ASSERT_EQUALS(dint(c1[i]), dint(c[i]));
+	}
+}
+
+PCUT_TEST(sincosf_v_matches)
+{
+	float in[FLOAT_CASES];
+	float s[FLOAT_CASES];
+	float c[FLOAT_CASES];
+	float s1[FLOAT_CASES];
+	float c1[FLOAT_CASES];
+
+	for (size_t i = 0; i < FLOAT_CASES; i++)
+		in[i] = float_cases[i].x;
+
+	sincosf_v(in, s, c, FLOAT_CASES);
+	sinf_v(in, s1, FLOAT_CASES);
+	cosf_v(in, c1, FLOAT_CASES);
+
+	for (size_t i = 0; i < FLOAT_CASES; i++) {
+		PCUT_ASSERT_EQUALS(fint(s1[i]), fint(s[i]));
+		PCUT_ASSERT_EQUALS(fint(c1[i]), fint(c[i]));
+	}
+}
+
+/** Output may alias the input. */
+PCUT_TEST(in_place)
+{
+	double buf[DOUBLE_CASES];
+
+	for (size_t i = 0; i < DOUBLE_CASES; i++)
+		buf[i] = double_cases[i].x;
+
+	sin_v(buf, buf, DOUBLE_CASES);
+
+	for (size_t i = 0; i < DOUBLE_CASES; i++)
+		assert_double_close(buf[i], double_cases[i].sin);
+}
+
+/** Arguments outside the reduction range take the scalar path. */
+PCUT_TEST(large_and_special)
+{
+	double in[] = { 1e6, -1e9, HUGE_VAL, __builtin_nan(""), 0.0 };
+	double out[5];
+	float inf[] = { 1e4f, -1e6f, HUGE_VALF, __builtin_nanf(""), 0.0f };
+	float outf[5];
+
+	sin_v(in, out, 5);
+	sinf_v(inf, outf, 5);
+
+	for (size_t i = 0; i < 3; i++) {
+		PCUT_ASSERT_EQUALS(dint(sin(in[i])), dint(out[i]));
+		PCUT_ASSERT_EQUALS(fint(sinf(inf[i])), fint(outf[i]));
+	}
+
+	PCUT_ASSERT_TRUE(isnan(out[3]));
+	PCUT_ASSERT_TRUE(isnan(outf[3]));
+	PCUT_ASSERT_EQUALS(dint(0.0), dint(out[4]));
+	PCUT_ASSERT_EQUALS(fint(0.0f), fint(outf[4]));
+}
+
+PCUT_EXPORT(trig_v);
@@ -48,6 +48,7 @@ extern errno_t mem_gc_create(gfx_rect_t *, gfx_bitmap_alloc_t *,
     mem_gc_cb_t *, void *, mem_gc_t **);
 extern errno_t mem_gc_delete(mem_gc_t *);
 extern void mem_gc_retarget(mem_gc_t *, gfx_rect_t *, gfx_bitmap_alloc_t *);
+extern void mem_gc_set_alloc(mem_gc_t *, gfx_bitmap_alloc_t *);
 extern gfx_context_t *mem_gc_get_ctx(mem_gc_t *);
 
 #endif
@@ -38,6 +38,7 @@
 
 #include <errno.h>
 #include <stdbool.h>
+#include <types/gfx/bitmap.h>
 #include <types/gfx/coord.h>
 
 struct mem_gc;
@@ -54,6 +55,14 @@ typedef struct {
 	errno_t (*cursor_set_pos)(void *, gfx_coord2_t *);
 	/** Set cursor visibility */
 	errno_t (*cursor_set_visible)(void *, bool);
+	/**
+	 * Present surface (optional). Called with allocation info of
+	 * a surface bitmap when it is rendered, the GC owner should then
+	 * use the surface contents instead of the GC memory. Called with
+	 * @c NULL when the surface is withdrawn, the owner should then copy
+	 * the surface contents back into the GC memory.
+	 */
+	errno_t (*present)(void *, gfx_bitmap_alloc_t *);
 } mem_gc_cb_t;
 
 #endif
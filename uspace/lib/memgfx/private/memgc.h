@@ -58,10 +58,12 @@ struct mem_gc {
 	void *cb_arg;
 	/** Current drawing color */
 	pixel_t color;
+	/** Presented surface bitmap or @c NULL */
+	struct mem_gc_bitmap *surface;
 };
 
 /** Bitmap in memory GC */
-typedef struct {
+typedef struct mem_gc_bitmap {
 	/** Containing memory GC */
 	struct mem_gc *mgc;
 	/** Allocation info */
@@ -42,10 +42,10 @@
 #include <gfx/context.h>
 #include <gfx/render.h>
 #include <io/pixel.h>
-#include <io/pixelmap.h>
 #include <memgfx/memgc.h>
 #include <stdlib.h>
 #include "../private/memgc.h"
+#include "../private/span.h"
 
 static errno_t mem_gc_set_clip_rect(void *, gfx_rect_t *);
 static errno_t mem_gc_set_color(void *, gfx_color_t *);
@@ -60,6 +60,7 @@ static errno_t mem_gc_cursor_get_pos(void *, gfx_coord2_t *);
 static errno_t mem_gc_cursor_set_pos(void *, gfx_coord2_t *);
 static errno_t mem_gc_cursor_set_visible(void *, bool);
 static void mem_gc_invalidate_rect(mem_gc_t *, gfx_rect_t *);
+static void mem_gc_withdraw_surface(mem_gc_t *);
 
 gfx_context_ops_t mem_gc_ops = {
 	.set_clip_rect = mem_gc_set_clip_rect,
@@ -115,6 +116,20 @@ static errno_t mem_gc_set_color(void *arg, gfx_color_t *color)
 	return EOK;
 }
 
+/** Get pointer to pixel in a block of memory.
+ *
+ * @param pixels Pixel array
+ * @param pitch Bytes per row
+ * @param x X coordinate
+ * @param y Y coordinate
+ * @return Pointer to pixel (x, y)
+ */
+static inline pixel_t *mem_gc_row(void *pixels, size_t pitch,
+    gfx_coord_t x, gfx_coord_t y)
+{
+	return (pixel_t *)((uint8_t *)pixels + (size_t)y * pitch) + x;
+}
+
 /** Fill rectangle on memory GC.
  *
  * @param arg Memory GC
@@ -126,22 +141,24 @@ static errno_t mem_gc_fill_rect(void *arg, gfx_rect_t *rect)
 {
 	mem_gc_t *mgc = (mem_gc_t *) arg;
 	gfx_rect_t crect;
-	gfx_coord_t x, y;
-	pixelmap_t pixelmap;
+	gfx_coord_t y;
+	pixel_t *row;
 
 	/* Make sure we have a sorted, clipped rectangle */
 	gfx_rect_clip(rect, &mgc->clip_rect, &crect);
 
+	/* We are about to modify GC memory */
+	mem_gc_withdraw_surface(mgc);
+
 	assert(mgc->rect.p0.x == 0);
 	assert(mgc->rect.p0.y == 0);
 	assert(mgc->alloc.pitch == mgc->rect.p1.x * (int)sizeof(uint32_t));
-	pixelmap.width = mgc->rect.p1.x;
-	pixelmap.height = mgc->rect.p1.y;
-	pixelmap.data = mgc->alloc.pixels;
 
-	for (y = crect.p0.y; y < crect.p1.y; y++) {
-		for (x = crect.p0.x; x < crect.p1.x; x++) {
-			pixelmap_put_pixel(&pixelmap, x, y, mgc->color);
+	if (crect.p1.x > crect.p0.x) {
+		for (y = crect.p0.y; y < crect.p1.y; y++) {
+			row = mem_gc_row(mgc->alloc.pixels, mgc->alloc.pitch,
+			    crect.p0.x, y);
+			mem_span_fill(row, mgc->color, crect.p1.x - crect.p0.x);
 		}
 	}
 
@@ -237,6 +254,23 @@ void mem_gc_retarget(mem_gc_t *mgc, gfx_rect_t *rect,
 	mgc->rect = *rect;
 	mgc->clip_rect = *rect;
 	mgc->alloc = *alloc;
+
+	/* Surfaces no longer match the GC memory */
+	mgc->surface = NULL;
+}
+
+/** Point memory GC to a different block of memory of the same size.
+ *
+ * Unlike mem_gc_retarget() the clipping rectangle is kept. This can be
+ * used to flip between buffers.
+ *
+ * @param mgc Memory GC
+ * @param alloc Allocation info of the new block
+ */
+void mem_gc_set_alloc(mem_gc_t *mgc, gfx_bitmap_alloc_t *alloc)
+{
+	mem_gc_withdraw_surface(mgc);
+	mgc->alloc = *alloc;
 }
 
 /** Get generic graphic context from memory GC.
@@ -254,6 +288,57 @@ static void mem_gc_invalidate_rect(mem_gc_t *mgc, gfx_rect_t *rect)
 	mgc->cb->invalidate(mgc->cb_arg, rect);
 }
 
+/** Withdraw presented surface.
+ *
+ * If a surface is presented, let the GC owner copy its contents back
+ * into GC memory so that it can be modified.
+ *
+ * @param mgc Memory GC
+ */
+static void mem_gc_withdraw_surface(mem_gc_t *mgc)
+{
+	if (mgc->surface == NULL)
+		return;
+
+	mgc->surface = NULL;
+	(void) mgc->cb->present(mgc->cb_arg, NULL);
+}
+
+/** Try presenting surface bitmap.
+ *
+ * @param mbm Bitmap
+ * @param offs Offset
+ * @return @c true if the surface is presented, @c false if the bitmap
+ *         needs to be copied to GC memory instead.
+ */
+static bool mem_gc_present_surface(mem_gc_bitmap_t *mbm, gfx_coord2_t *offs)
+{
+	mem_gc_t *mgc = mbm->mgc;
+	errno_t rc;
+
+	if ((mbm->flags & bmpf_surface) == 0 || mgc->cb == NULL ||
+	    mgc->cb->present == NULL)
+		return false;
+
+	/* Surface must cover the GC exactly */
+	if (offs->x != 0 || offs->y != 0 ||
+	    mbm->rect.p0.x != mgc->rect.p0.x ||
+	    mbm->rect.p0.y != mgc->rect.p0.y ||
+	    mbm->rect.p1.x != mgc->rect.p1.x ||
+	    mbm->rect.p1.y != mgc->rect.p1.y)
+		return false;
+
+	if (mgc->surface == mbm)
+		return true;
+
+	rc = mgc->cb->present(mgc->cb_arg, &mbm->alloc);
+	if (rc != EOK)
+		return false;
+
+	mgc->surface = mbm;
+	return true;
+}
+
 /** Create bitmap in memory GC.
  *
  * @param arg Memory GC
@@ -272,9 +357,14 @@ errno_t mem_gc_bitmap_create(void *arg, gfx_bitmap_params_t *params,
 
 	/* Check that we support all requested flags */
 	if ((params->flags & ~(bmpf_color_key | bmpf_colorize |
-	    bmpf_direct_output)) != 0)
+	    bmpf_direct_output | bmpf_surface)) != 0)
 		return ENOTSUP;
 
+	/* Surface is presented as it is */
+	if ((params->flags & bmpf_surface) != 0 &&
+	    (params->flags & (bmpf_color_key | bmpf_direct_output)) != 0)
+		return EINVAL;
+
 	mbm = calloc(1, sizeof(mem_gc_bitmap_t));
 	if (mbm == NULL)
 		return ENOMEM;
@@ -352,6 +442,11 @@ error:
 static errno_t mem_gc_bitmap_destroy(void *bm)
 {
 	mem_gc_bitmap_t *mbm = (mem_gc_bitmap_t *)bm;
+
+	/* Owner must stop using the memory before it goes away */
+	if (mbm->mgc->surface == mbm)
+		mem_gc_withdraw_surface(mbm->mgc);
+
 	if (mbm->myalloc) {
 #if 0
 		/* TODO: if we alloc allocating the bitmap with malloc */
@@ -379,10 +474,10 @@ static errno_t mem_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 	gfx_rect_t drect;
 	gfx_rect_t crect;
 	gfx_coord2_t offs;
-	gfx_coord_t x, y;
-	pixelmap_t smap;
-	pixelmap_t dmap;
-	pixel_t pixel;
+	gfx_coord_t y;
+	gfx_coord_t w;
+	pixel_t *srow;
+	pixel_t *drow;
 
 	if (srect0 != NULL)
 		gfx_rect_clip(srect0, &mbm->rect, &srect);
@@ -404,51 +499,48 @@ static errno_t mem_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 
 	assert(mbm->alloc.pitch == (mbm->rect.p1.x - mbm->rect.p0.x) *
 	    (int)sizeof(uint32_t));
-	smap.width = mbm->rect.p1.x - mbm->rect.p0.x;
-	smap.height = mbm->rect.p1.y - mbm->rect.p0.y;
-	smap.data = mbm->alloc.pixels;
-
 	assert(mbm->mgc->rect.p0.x == 0);
 	assert(mbm->mgc->rect.p0.y == 0);
 	assert(mbm->mgc->alloc.pitch == mbm->mgc->rect.p1.x * (int)sizeof(uint32_t));
-	dmap.width = mbm->mgc->rect.p1.x;
-	dmap.height = mbm->mgc->rect.p1.y;
-	dmap.data = mbm->mgc->alloc.pixels;
 
-	if ((mbm->flags & bmpf_direct_output) != 0) {
+	if (mem_gc_present_surface(mbm, &offs)) {
+		/* No copying, owner uses the surface directly */
+		mem_gc_invalidate_rect(mbm->mgc, &crect);
+		return EOK;
+	}
+
+	/* We are about to modify GC memory */
+	mem_gc_withdraw_surface(mbm->mgc);
+
+	w = crect.p1.x - crect.p0.x;
+	if ((mbm->flags & bmpf_direct_output) != 0 || w <= 0) {
 		/* Nothing to do */
-	} else if ((mbm->flags & bmpf_color_key) == 0) {
-		/* Simple copy */
-		for (y = crect.p0.y; y < crect.p1.y; y++) {
-			for (x = crect.p0.x; x < crect.p1.x; x++) {
-				pixel = pixelmap_get_pixel(&smap,
-				    x - mbm->rect.p0.x - offs.x,
-				    y - mbm->rect.p0.y - offs.y);
-				pixelmap_put_pixel(&dmap, x, y, pixel);
-			}
-		}
-	} else if ((mbm->flags & bmpf_colorize) == 0) {
-		/* Color key */
-		for (y = crect.p0.y; y < crect.p1.y; y++) {
-			for (x = crect.p0.x; x < crect.p1.x; x++) {
-				pixel = pixelmap_get_pixel(&smap,
-				    x - mbm->rect.p0.x - offs.x,
-				    y - mbm->rect.p0.y - offs.y);
-				if (pixel != mbm->key_color)
-					pixelmap_put_pixel(&dmap, x, y, pixel);
-			}
-		}
-	} else {
-		/* Color key & colorization */
-		for (y = crect.p0.y; y < crect.p1.y; y++) {
-			for (x = crect.p0.x; x < crect.p1.x; x++) {
-				pixel = pixelmap_get_pixel(&smap,
-				    x - mbm->rect.p0.x - offs.x,
-				    y - mbm->rect.p0.y - offs.y);
-				if (pixel != mbm->key_color)
-					pixelmap_put_pixel(&dmap, x, y,
-					    mbm->mgc->color);
-			}
+		mem_gc_invalidate_rect(mbm->mgc, &crect);
+		return EOK;
+	}
+
+	/*
+	 * Process the rectangle row by row. Source pixel corresponding
+	 * to destination pixel (x, y) is at (x - offs.x, y - offs.y)
+	 * in bitmap coordinates.
+	 */
+	for (y = crect.p0.y; y < crect.p1.y; y++) {
+		srow = mem_gc_row(mbm->alloc.pixels, mbm->alloc.pitch,
+		    crect.p0.x - mbm->rect.p0.x - offs.x,
+		    y - mbm->rect.p0.y - offs.y);
+		drow = mem_gc_row(mbm->mgc->alloc.pixels, mbm->mgc->alloc.pitch,
+		    crect.p0.x, y);
+
+		if ((mbm->flags & bmpf_color_key) == 0) {
+			/* Simple copy */
+			mem_span_copy(drow, srow, w);
+		} else if ((mbm->flags & bmpf_colorize) == 0) {
+			/* Color key */
+			mem_span_key(drow, srow, w, mbm->key_color);
+		} else {
+			/* Color key & colorization */
+			mem_span_key_colorize(drow, srow, w, mbm->key_color,
+			    mbm->mgc->color);
 		}
 	}
 
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libmemgfx
+ * @{
+ */
+/**
+ * @file Pixel span operations
+ *
+ * Operations on a horizontal run of pixels, the building blocks of
+ * rectangle fills and bitmap blits. The inner loops work on several pixels
+ * at a time using the compiler's generic vector types, which are lowered to
+ * SSE2 on amd64, NEON on arm64 and to plain integer code where no vector
+ * unit is available.
+ */
+
+#include <mem.h>
+#include <stdint.h>
+#include "../private/span.h"
+
+/** Four pixels (unaligned access) */
+typedef uint32_t mem_vec4_t __attribute__((vector_size(16), aligned(4),
+    may_alias));
+
+/** Fill span with a color.
+ *
+ * @param dst Destination pixels
+ * @param color Color
+ * @param n Number of pixels
+ */
+void mem_span_fill(pixel_t *dst, pixel_t color, size_t n)
+{
+	mem_vec4_t c = { color, color, color, color };
+	size_t i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		*(mem_vec4_t *)(dst + i) = c;
+		*(mem_vec4_t *)(dst + i + 4) = c;
+	}
+
+	for (; i < n; i++)
+		dst[i] = color;
+}
+
+/** Copy span.
+ *
+ * @param dst Destination pixels
+ * @param src Source pixels
+ * @param n Number of pixels
+ */
+void mem_span_copy(pixel_t *dst, const pixel_t *src, size_t n)
+{
+	memcpy(dst, src, n * sizeof(pixel_t));
+}
+
+/** Copy span, skipping pixels with key color.
+ *
+ * @param dst Destination pixels
+ * @param src Source pixels
+ * @param n Number of pixels
+ * @param key Key color (transparent)
+ */
+void mem_span_key(pixel_t *dst, const pixel_t *src, size_t n, pixel_t key)
+{
+	mem_vec4_t k = { key, key, key, key };
+	mem_vec4_t s, d, m;
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		s = *(const mem_vec4_t *)(src + i);
+		/* All ones in lanes to keep (source pixel is key) */
+		m = (mem_vec4_t)(s == k);
+		d = *(mem_vec4_t *)(dst + i);
+		*(mem_vec4_t *)(dst + i) = (d & m) | (s & ~m);
+	}
+
+	for (; i < n; i++) {
+		if (src[i] != key)
+			dst[i] = src[i];
+	}
+}
+
+/** Paint color where source span does not have key color.
+ *
+ * @param dst Destination pixels
+ * @param src Source pixels
+ * @param n Number of pixels
+ * @param key Key color (transparent)
+ * @param color Color to paint with
+ */
+void mem_span_key_colorize(pixel_t *dst, const pixel_t *src, size_t n,
+    pixel_t key, pixel_t color)
+{
+	mem_vec4_t k = { key, key, key, key };
+	mem_vec4_t c = { color, color, color, color };
+	mem_vec4_t s, d, m;
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		s = *(const mem_vec4_t *)(src + i);
+		m = (mem_vec4_t)(s == k);
+		d = *(mem_vec4_t *)(dst + i);
+		*(mem_vec4_t *)(dst + i) = (d & m) | (c & ~m);
+	}
+
+	for (; i < n; i++) {
+		if (src[i] != key)
+			dst[i] = color;
+	}
+}
+
+/** @}
+ */
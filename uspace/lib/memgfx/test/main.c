@@ -31,6 +31,7 @@
 PCUT_INIT;
 
 PCUT_IMPORT(memgfx);
+PCUT_IMPORT(span);
 PCUT_IMPORT(xlategc);
 
 PCUT_MAIN();
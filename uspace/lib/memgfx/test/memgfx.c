@@ -47,13 +47,15 @@ static void test_update(void *arg);
 static errno_t test_cursor_get_pos(void *arg, gfx_coord2_t *);
 static errno_t test_cursor_set_pos(void *arg, gfx_coord2_t *);
 static errno_t test_cursor_set_visible(void *arg, bool);
+static errno_t test_present(void *arg, gfx_bitmap_alloc_t *);
 
 static mem_gc_cb_t test_mem_gc_cb = {
 	.invalidate = test_invalidate_rect,
 	.update = test_update,
 	.cursor_get_pos = test_cursor_get_pos,
 	.cursor_set_pos = test_cursor_set_pos,
-	.cursor_set_visible = test_cursor_set_visible
+	.cursor_set_visible = test_cursor_set_visible,
+	.present = test_present
 };
 
 typedef struct {
@@ -77,6 +79,10 @@ typedef struct {
 	bool cursor_set_visible_called;
 	/** Value passed to cursor_set_visible */
 	bool set_visible_vis;
+	/** True if present was called */
+	bool present_called;
+	/** Pixels of surface passed to present or @c NULL */
+	void *present_pixels;
 } test_resp_t;
 
 /** Test creating and deleting a memory GC */
@@ -279,6 +285,99 @@ PCUT_TEST(bitmap_render)
 	free(alloc.pixels);
 }
 
+/** Test rendering surface bitmap presents it without copying */
+PCUT_TEST(bitmap_render_surface)
+{
+	mem_gc_t *mgc;
+	gfx_rect_t rect;
+	gfx_bitmap_alloc_t alloc;
+	gfx_context_t *gc;
+	gfx_bitmap_params_t params;
+	gfx_bitmap_alloc_t balloc;
+	gfx_bitmap_t *bitmap;
+	gfx_color_t *color;
+	pixel_t *pixels;
+	test_resp_t resp;
+	errno_t rc;
+	int i;
+
+	/* Bounding rectangle for memory GC */
+	rect.p0.x = 0;
+	rect.p0.y = 0;
+	rect.p1.x = 10;
+	rect.p1.y = 10;
+
+	alloc.pitch = (rect.p1.x - rect.p0.x) * sizeof(uint32_t);
+	alloc.off0 = 0;
+	alloc.pixels = calloc(1, alloc.pitch * (rect.p1.y - rect.p0.y));
+	PCUT_ASSERT_NOT_NULL(alloc.pixels);
+
+	rc = mem_gc_create(&rect, &alloc, &test_mem_gc_cb, &resp, &mgc);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	gc = mem_gc_get_ctx(mgc);
+	PCUT_ASSERT_NOT_NULL(gc);
+
+	/* Create surface covering the entire GC */
+	gfx_bitmap_params_init(&params);
+	params.rect = rect;
+	params.flags = bmpf_surface;
+
+	rc = gfx_bitmap_create(gc, &params, NULL, &bitmap);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gfx_bitmap_get_alloc(bitmap, &balloc);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	pixels = balloc.pixels;
+	for (i = 0; i < 10 * 10; i++)
+		pixels[i] = PIXEL(0, 255, 255, 0);
+
+	memset(&resp, 0, sizeof(resp));
+
+	/* Rendering surface presents it */
+	rc = gfx_bitmap_render(bitmap, NULL, NULL);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	PCUT_ASSERT_TRUE(resp.present_called);
+	PCUT_ASSERT_EQUALS(balloc.pixels, resp.present_pixels);
+	PCUT_ASSERT_TRUE(resp.invalidate_called);
+
+	/* Nothing was copied to GC memory */
+	pixels = alloc.pixels;
+	for (i = 0; i < 10 * 10; i++)
+		PCUT_ASSERT_INT_EQUALS(PIXEL(0, 0, 0, 0), pixels[i]);
+
+	/* Rendering it again does not present it again */
+	memset(&resp, 0, sizeof(resp));
+	rc = gfx_bitmap_render(bitmap, NULL, NULL);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_FALSE(resp.present_called);
+	PCUT_ASSERT_TRUE(resp.invalidate_called);
+
+	/* Drawing into GC memory withdraws the surface */
+	rc = gfx_color_new_rgb_i16(0xffff, 0xffff, 0xffff, &color);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gfx_set_color(gc, color);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	memset(&resp, 0, sizeof(resp));
+	rc = gfx_fill_rect(gc, &rect);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_TRUE(resp.present_called);
+	PCUT_ASSERT_NULL(resp.present_pixels);
+
+	/* Destroying a surface that is not presented does nothing */
+	memset(&resp, 0, sizeof(resp));
+	gfx_bitmap_destroy(bitmap);
+	PCUT_ASSERT_FALSE(resp.present_called);
+
+	gfx_color_delete(color);
+	mem_gc_delete(mgc);
+	free(alloc.pixels);
+}
+
 /** Test gfx_update() on a memory GC */
 PCUT_TEST(gfx_update)
 {
@@ -494,4 +593,14 @@ static errno_t test_cursor_set_visible(void *arg, bool visible)
 	return resp->rc;
 }
 
+/** Called by memory GC when a surface is presented or withdrawn. */
+static errno_t test_present(void *arg, gfx_bitmap_alloc_t *alloc)
+{
+	test_resp_t *resp = (test_resp_t *)arg;
+
+	resp->present_called = true;
+	resp->present_pixels = alloc != NULL ? alloc->pixels : NULL;
+	return resp->rc;
+}
+
 PCUT_EXPORT(memgfx);
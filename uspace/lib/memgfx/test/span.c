@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <io/pixel.h>
+#include <pcut/pcut.h>
+#include <stddef.h>
+#include "../private/span.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(span);
+
+enum {
+	/** Size of test buffers in pixels */
+	test_buf_len = 64
+};
+
+/** Fill buffer with a distinct pattern. */
+static void test_pattern(pixel_t *buf, size_t n, pixel_t base)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		buf[i] = base + i;
+}
+
+/** mem_span_fill() fills exactly the span, for all lengths and offsets */
+PCUT_TEST(fill)
+{
+	pixel_t buf[test_buf_len];
+	size_t off, n, i;
+
+	for (off = 0; off < 4; off++) {
+		for (n = 0; n + off < test_buf_len; n++) {
+			test_pattern(buf, test_buf_len, 0x100);
+			mem_span_fill(buf + off, 0xaabbcc, n);
+
+			for (i = 0; i < test_buf_len; i++) {
+				if (i >= off && i < off + n) {
+					PCUT_ASSERT_INT_EQUALS(0xaabbcc,
+					    buf[i]);
+				} else {
+					PCUT_ASSERT_INT_EQUALS(0x100 + i,
+					    buf[i]);
+				}
+			}
+		}
+	}
+}
+
+/** mem_span_copy() copies exactly the span */
+PCUT_TEST(copy)
+{
+	pixel_t src[test_buf_len];
+	pixel_t dst[test_buf_len];
+	size_t off, n, i;
+
+	test_pattern(src, test_buf_len, 0x1000);
+
+	for (off = 0; off < 4; off++) {
+		for (n = 0; n + off < test_buf_len; n++) {
+			test_pattern(dst, test_buf_len, 0x100);
+			mem_span_copy(dst + off, src + 1, n);
+
+			for (i = 0; i < test_buf_len; i++) {
+				if (i >= off && i < off + n) {
+					PCUT_ASSERT_INT_EQUALS(src[i - off + 1],
+					    dst[i]);
+				} else {
+					PCUT_ASSERT_INT_EQUALS(0x100 + i,
+					    dst[i]);
+				}
+			}
+		}
+	}
+}
+
+/** mem_span_key() skips exactly the pixels with key color */
+PCUT_TEST(key)
+{
+	pixel_t src[test_buf_len];
+	pixel_t dst[test_buf_len];
+	size_t off, n, i;
+
+	test_pattern(src, test_buf_len, 0x1000);
+	for (i = 0; i < test_buf_len; i += 3)
+		src[i] = 0xff00ff;
+
+	for (off = 0; off < 4; off++) {
+		for (n = 0; n + off < test_buf_len; n++) {
+			test_pattern(dst, test_buf_len, 0x100);
+			mem_span_key(dst + off, src, n, 0xff00ff);
+
+			for (i = 0; i < test_buf_len; i++) {
+				if (i >= off && i < off + n &&
+				    src[i - off] != 0xff00ff) {
+					PCUT_ASSERT_INT_EQUALS(src[i - off],
+					    dst[i]);
+				} else {
+					PCUT_ASSERT_INT_EQUALS(0x100 + i,
+					    dst[i]);
+				}
+			}
+		}
+	}
+}
+
+/** mem_span_key_colorize() paints exactly the pixels without key color */
+PCUT_TEST(key_colorize)
+{
+	pixel_t src[test_buf_len];
+	pixel_t dst[test_buf_len];
+	size_t off, n, i;
+
+	test_pattern(src, test_buf_len, 0x1000);
+	for (i = 0; i < test_buf_len; i += 5)
+		src[i] = 0xff00ff;
+
+	for (off = 0; off < 4; off++) {
+		for (n = 0; n + off < test_buf_len; n++) {
+			test_pattern(dst, test_buf_len, 0x100);
+			mem_span_key_colorize(dst + off, src, n, 0xff00ff,
+			    0x123456);
+
+			for (i = 0; i < test_buf_len; i++) {
+				if (i >= off && i < off + n &&
+				    src[i - off] != 0xff00ff) {
+					PCUT_ASSERT_INT_EQUALS(0x123456,
+					    dst[i]);
+				} else {
+					PCUT_ASSERT_INT_EQUALS(0x100 + i,
+					    dst[i]);
+				}
+			}
+		}
+	}
+}
+
+PCUT_EXPORT(span);
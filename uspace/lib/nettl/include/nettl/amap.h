@@ -36,11 +36,24 @@
 #ifndef LIBNETTL_AMAP_H_
 #define LIBNETTL_AMAP_H_
 
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <inet/endpoint.h>
 #include <nettl/portrng.h>
 #include <loc.h>
 
+/** Fully specified endpoint pair (remote endpoint, local endpoint) */
+typedef struct {
+	/** Link to amap_t.exact */
+	ht_link_t lamap;
+	/** Remote endpoint */
+	inet_ep_t rep;
+	/** Local endpoint */
+	inet_ep_t lep;
+	/** User argument */
+	void *arg;
+} amap_exact_t;
+
 /** Port range for (remote endpoint, local address) */
 typedef struct {
 	/** Link to amap_t.repla */
@@ -75,6 +88,8 @@ typedef struct {
 
 /** Association map */
 typedef struct {
+	/** Remote endpoint, local endpoint, for exact lookups */
+	hash_table_t exact; /* of amap_exact_t */
 	/** Remote endpoint, local address */
 	list_t repla; /* of amap_repla_t */
 	/** Local addresses */
@@ -47,8 +47,14 @@
  *
  * In the unspecified case only the local port is known and the entry matches
  * all remote and local addresses.
+ *
+ * Fully specified endpoint pairs (repla entries) are also kept in a hash
+ * table, so that the most common lookup, for a connected association, does
+ * not need to walk any lists.
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <errno.h>
 #include <inet/addr.h>
@@ -74,6 +80,92 @@ static portrng_flags_t aflags_to_pflags(amap_flags_t flags)
 	return pflags;
 }
 
+/** Compute hash of an IP address.
+ *
+ * @param addr Address
+ * @return Hash
+ */
+static size_t amap_addr_hash(const inet_addr_t *addr)
+{
+	size_t hash = addr->version;
+
+	switch (addr->version) {
+	case ip_v4:
+		hash = hash_combine(hash, addr->addr);
+		break;
+	case ip_v6:
+		for (size_t i = 0; i < sizeof(addr128_t); i++)
+			hash = hash_combine(hash, addr->addr6[i]);
+		break;
+	default:
+		break;
+	}
+
+	return hash;
+}
+
+/** Compute hash of a fully specified endpoint pair.
+ *
+ * @param rep Remote endpoint
+ * @param lep Local endpoint
+ * @return Hash
+ */
+static size_t amap_exact_hash_eps(const inet_ep_t *rep, const inet_ep_t *lep)
+{
+	size_t hash;
+
+	hash = hash_combine(amap_addr_hash(&rep->addr), rep->port);
+	hash = hash_combine(hash, amap_addr_hash(&lep->addr));
+	return hash_combine(hash, lep->port);
+}
+
+static size_t amap_exact_hash(const ht_link_t *item)
+{
+	amap_exact_t *exact = hash_table_get_inst(item, amap_exact_t, lamap);
+	return amap_exact_hash_eps(&exact->rep, &exact->lep);
+}
+
+static size_t amap_exact_key_hash(const void *key)
+{
+	const inet_ep2_t *epp = key;
+	return amap_exact_hash_eps(&epp->remote, &epp->local);
+}
+
+static bool amap_exact_key_equal(const void *key, const ht_link_t *item)
+{
+	const inet_ep2_t *epp = key;
+	amap_exact_t *exact = hash_table_get_inst(item, amap_exact_t, lamap);
+
+	return exact->rep.port == epp->remote.port &&
+	    exact->lep.port == epp->local.port &&
+	    inet_addr_compare(&exact->rep.addr, &epp->remote.addr) &&
+	    inet_addr_compare(&exact->lep.addr, &epp->local.addr);
+}
+
+static bool amap_exact_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	amap_exact_t *exact = hash_table_get_inst(item1, amap_exact_t, lamap);
+	inet_ep2_t epp;
+
+	epp.remote = exact->rep;
+	epp.local = exact->lep;
+	return amap_exact_key_equal(&epp, item2);
+}
+
+static void amap_exact_remove_callback(ht_link_t *item)
+{
+	free(hash_table_get_inst(item, amap_exact_t, lamap));
+}
+
+/** Operations for the exact match hash table. */
+static const hash_table_ops_t amap_exact_ops = {
+	.hash = amap_exact_hash,
+	.key_hash = amap_exact_key_hash,
+	.key_equal = amap_exact_key_equal,
+	.equal = amap_exact_equal,
+	.remove_callback = amap_exact_remove_callback
+};
+
 /** Create association map.
  *
  * @param rmap Place to store pointer to new association map
@@ -97,6 +189,12 @@ errno_t amap_create(amap_t **rmap)
 		return ENOMEM;
 	}
 
+	if (!hash_table_create(&map->exact, 0, 0, &amap_exact_ops)) {
+		portrng_destroy(map->unspec);
+		free(map);
+		return ENOMEM;
+	}
+
 	list_initialize(&map->repla);
 	list_initialize(&map->laddr);
 	list_initialize(&map->llink);
@@ -116,6 +214,8 @@ void amap_destroy(amap_t *map)
 	assert(list_empty(&map->repla));
 	assert(list_empty(&map->laddr));
 	assert(list_empty(&map->llink));
+	assert(hash_table_empty(&map->exact));
+	hash_table_destroy(&map->exact);
 	free(map);
 }
 
@@ -144,13 +244,6 @@ static errno_t amap_repla_find(amap_t *map, inet_ep_t *rep, inet_addr_t *la,
 	free(sladdr);
 
 	list_foreach(map->repla, lamap, amap_repla_t, repla) {
-		(void) inet_addr_format(&repla->rep.addr, &sraddr);
-		(void) inet_addr_format(&repla->laddr, &sladdr);
-		log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_repla_find(): "
-		    "compare to rep=(%s, %" PRIu16 ") la=%s",
-		    sraddr, repla->rep.port, sladdr);
-		free(sraddr);
-		free(sladdr);
 		if (inet_addr_compare(&repla->rep.addr, &rep->addr) &&
 		    repla->rep.port == rep->port &&
 		    inet_addr_compare(&repla->laddr, la)) {
@@ -374,6 +467,7 @@ static void amap_llink_remove(amap_t *map, amap_llink_t *llink)
 static errno_t amap_insert_repla(amap_t *map, inet_ep2_t *epp, void *arg,
     amap_flags_t flags, inet_ep2_t *aepp)
 {
+	amap_exact_t *exact;
 	amap_repla_t *repla;
 	inet_ep2_t mepp;
 	errno_t rc;
@@ -399,6 +493,19 @@ static errno_t amap_insert_repla(amap_t *map, inet_ep2_t *epp, void *arg,
 		return rc;
 	}
 
+	exact = calloc(1, sizeof(amap_exact_t));
+	if (exact == NULL) {
+		portrng_free_port(repla->portrng, mepp.local.port);
+		if (portrng_empty(repla->portrng))
+			amap_repla_remove(map, repla);
+		return ENOMEM;
+	}
+
+	exact->rep = mepp.remote;
+	exact->lep = mepp.local;
+	exact->arg = arg;
+	hash_table_insert(&map->exact, &exact->lamap);
+
 	*aepp = mepp;
 	return EOK;
 }
@@ -606,6 +713,7 @@ static void amap_remove_repla(amap_t *map, inet_ep2_t *epp)
 		return;
 	}
 
+	(void) hash_table_remove(&map->exact, epp);
 	portrng_free_port(repla->portrng, epp->local.port);
 
 	if (portrng_empty(repla->portrng))
@@ -723,23 +831,20 @@ void amap_remove(amap_t *map, inet_ep2_t *epp)
 errno_t amap_find_match(amap_t *map, inet_ep2_t *epp, void **rarg)
 {
 	errno_t rc;
-	amap_repla_t *repla;
+	ht_link_t *link;
 	amap_laddr_t *laddr;
 	amap_llink_t *llink;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_find_match(llink=%zu)",
 	    epp->local_link);
 
-	/* Remode endpoint, local address */
-	rc = amap_repla_find(map, &epp->remote, &epp->local.addr, &repla);
-	if (rc == EOK) {
-		rc = portrng_find_port(repla->portrng, epp->local.port,
-		    rarg);
-		if (rc == EOK) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG2, "Matched repla / "
-			    "port %" PRIu16, epp->local.port);
-			return EOK;
-		}
+	/* Remote endpoint, local endpoint */
+	link = hash_table_find(&map->exact, epp);
+	if (link != NULL) {
+		*rarg = hash_table_get_inst(link, amap_exact_t, lamap)->arg;
+		log_msg(LOG_DEFAULT, LVL_DEBUG2, "Matched repla / "
+		    "port %" PRIu16, epp->local.port);
+		return EOK;
 	}
 
 	/* Local address */
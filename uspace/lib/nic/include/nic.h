@@ -49,6 +49,9 @@
 struct nic;
 typedef struct nic nic_t;
 
+/** Number of flow steering rules which can be applied in software */
+#define NIC_FLOWS_MAX  32
+
 /**
  * Single WOL virtue descriptor.
  */
@@ -84,6 +87,19 @@ typedef list_t nic_frame_list_t;
  */
 typedef void (*send_frame_handler)(nic_t *, void *, size_t);
 
+/**
+ * Handler for writing frame data to the NIC device and letting the device
+ * complete the transport checksum in the frame. Otherwise the same as
+ * send_frame_handler.
+ *
+ * @param nic_data
+ * @param data		Pointer to frame data
+ * @param size		Size of frame data in bytes
+ * @param csum		Checksum to complete
+ */
+typedef void (*send_frame_csum_handler)(nic_t *, void *, size_t,
+    const nic_csum_t *);
+
 /**
  * The handler for transitions between driver states.
  * If the handler returns error code, the transition between
@@ -205,6 +221,18 @@ typedef errno_t (*poll_mode_change_handler)(nic_t *,
  */
 typedef void (*poll_request_handler)(nic_t *);
 
+/**
+ * Handler for receive-side scaling configuration change.
+ *
+ * @param nic_data
+ * @param rss		New configuration, already checked against the
+ *			queues and hash types the NIC reported
+ *
+ * @return EOK		If the NIC was set up
+ * @return error code	Otherwise, the configuration is not changed
+ */
+typedef errno_t (*rss_change_handler)(nic_t *, const nic_rss_t *);
+
 /* nic_t allocation and deallocation */
 extern nic_t *nic_create_and_bind(ddf_dev_t *);
 extern void nic_unbind_and_destroy(ddf_dev_t *);
@@ -218,6 +246,7 @@ extern void nic_driver_implement(driver_ops_t *, ddf_dev_ops_t *,
 extern errno_t nic_get_resources(nic_t *, hw_res_list_parsed_t *);
 extern void nic_set_specific(nic_t *, void *);
 extern void nic_set_send_frame_handler(nic_t *, send_frame_handler);
+extern void nic_set_send_frame_csum_handler(nic_t *, send_frame_csum_handler);
 extern void nic_set_state_change_handlers(nic_t *,
     state_change_handler, state_change_handler, state_change_handler);
 extern void nic_set_filtering_change_handlers(nic_t *,
@@ -230,6 +259,9 @@ extern void nic_set_poll_handlers(nic_t *,
     poll_mode_change_handler, poll_request_handler);
 
 /* General driver functions */
+extern void nic_set_queues(nic_t *, unsigned int, unsigned int, uint32_t,
+    unsigned int);
+extern void nic_set_rss_change_handler(nic_t *, rss_change_handler);
 extern ddf_dev_t *nic_get_ddf_dev(nic_t *);
 extern ddf_fun_t *nic_get_ddf_fun(nic_t *);
 extern void nic_set_ddf_fun(nic_t *, ddf_fun_t *);
@@ -243,6 +275,9 @@ extern errno_t nic_report_poll_mode(nic_t *, nic_poll_mode_t, struct timespec *)
 extern void nic_query_address(nic_t *, nic_address_t *);
 extern void nic_received_frame(nic_t *, nic_frame_t *);
 extern void nic_received_frame_list(nic_t *, nic_frame_list_t *);
+extern void nic_query_rss(nic_t *, nic_rss_t *);
+extern unsigned int nic_query_rx_queue(nic_t *, const void *, size_t);
+extern unsigned int nic_query_tx_queue(nic_t *, const void *, size_t);
 extern nic_poll_mode_t nic_query_poll_mode(nic_t *, struct timespec *);
 
 /* Statistics updates */
@@ -251,6 +286,8 @@ extern void nic_report_send_error(nic_t *, nic_send_error_cause_t, unsigned);
 extern void nic_report_receive_error(nic_t *, nic_receive_error_cause_t,
     unsigned);
 extern void nic_report_collisions(nic_t *, unsigned);
+extern void nic_report_interrupt(nic_t *);
+extern void nic_report_poll(nic_t *);
 
 /* Frame / frame list allocation and deallocation */
 extern nic_frame_t *nic_alloc_frame(nic_t *, size_t);
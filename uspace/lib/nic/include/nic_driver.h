@@ -47,6 +47,7 @@
 #include <async.h>
 
 #include "nic.h"
+#include "nic_rss.h"
 #include "nic_rx_control.h"
 #include "nic_wol_virtues.h"
 
@@ -126,6 +127,15 @@ struct nic {
 	 * Called with the main_lock locked for reading.
 	 */
 	send_frame_handler send_frame;
+	/**
+	 * Function sending the data and letting the device complete the
+	 * checksum. The implementation is optional, if it is filled in
+	 * the NIC_OFFLOAD_TX_CSUM offload is supported.
+	 * Called with the main_lock locked for reading.
+	 */
+	send_frame_csum_handler send_frame_csum;
+	/** Active offload computations, locked by main_lock */
+	uint32_t offload_active;
 	/**
 	 * Event handler called when device goes to the ACTIVE state.
 	 * The implementation is optional.
@@ -194,6 +204,29 @@ struct nic {
 	 * The implementation is optional.
 	 */
 	poll_request_handler on_poll_request;
+	/**
+	 * Frame rings shared with the client or NULL if frames are passed
+	 * in IPC messages. Set under both ring locks.
+	 */
+	nic_rings_t *rings;
+	/** Lock for producing to the rx ring */
+	fibril_mutex_t rx_ring_lock;
+	/** Lock for consuming from the tx ring */
+	fibril_mutex_t tx_ring_lock;
+	/** Receive queues and their configuration */
+	nic_rssc_t rss_control;
+	/**
+	 * Lock for receive queues configuration. You must not hold any other
+	 * lock from nic_t except the main_lock at the same moment.
+	 */
+	fibril_rwlock_t rss_lock;
+	/**
+	 * Event handler called when the receive-side scaling configuration is
+	 * changed. The implementation is optional, without it the configuration
+	 * is only used for classification in software.
+	 * Called with rss_lock locked for writing.
+	 */
+	rss_change_handler on_rss_change;
 	/** Data specific for particular driver */
 	void *specific;
 };
@@ -45,6 +45,7 @@
 extern errno_t nic_ev_addr_changed(async_sess_t *, const nic_address_t *);
 extern errno_t nic_ev_device_state(async_sess_t *, sysarg_t);
 extern errno_t nic_ev_received(async_sess_t *, void *, size_t);
+extern void nic_ev_rx_kick(async_sess_t *);
 
 #endif
 
@@ -48,7 +48,8 @@
  */
 
 extern errno_t nic_get_address_impl(ddf_fun_t *dev_fun, nic_address_t *address);
-extern errno_t nic_send_frame_impl(ddf_fun_t *dev_fun, void *data, size_t size);
+extern errno_t nic_send_frame_impl(ddf_fun_t *dev_fun, void *data, size_t size,
+    const nic_csum_t *csum);
 extern errno_t nic_callback_create_impl(ddf_fun_t *dev_fun);
 extern errno_t nic_get_state_impl(ddf_fun_t *dev_fun, nic_device_state_t *state);
 extern errno_t nic_set_state_impl(ddf_fun_t *dev_fun, nic_device_state_t state);
@@ -81,6 +82,16 @@ extern errno_t nic_poll_get_mode_impl(ddf_fun_t *,
 extern errno_t nic_poll_set_mode_impl(ddf_fun_t *,
     nic_poll_mode_t, const struct timespec *);
 extern errno_t nic_poll_now_impl(ddf_fun_t *);
+extern errno_t nic_rings_setup_impl(ddf_fun_t *, nic_rings_t *);
+extern errno_t nic_tx_kick_impl(ddf_fun_t *);
+extern errno_t nic_queues_get_impl(ddf_fun_t *, nic_queues_t *);
+extern errno_t nic_rss_get_impl(ddf_fun_t *, nic_rss_t *);
+extern errno_t nic_rss_set_impl(ddf_fun_t *, const nic_rss_t *);
+extern errno_t nic_flow_add_impl(ddf_fun_t *, const nic_flow_t *,
+    nic_flow_id_t *);
+extern errno_t nic_flow_remove_impl(ddf_fun_t *, nic_flow_id_t);
+extern errno_t nic_offload_probe_impl(ddf_fun_t *, uint32_t *, uint32_t *);
+extern errno_t nic_offload_set_impl(ddf_fun_t *, uint32_t, uint32_t);
 
 extern void nic_default_handler_impl(ddf_fun_t *dev_fun, ipc_call_t *call);
 extern errno_t nic_open_impl(ddf_fun_t *fun);
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @addtogroup libnic
+ * @{
+ */
+/**
+ * @file
+ * @brief Receive-side scaling and flow steering control structures
+ */
+
+#ifndef __NIC_RSS_H__
+#define __NIC_RSS_H__
+
+#ifndef LIBNIC_INTERNAL
+#error "This is internal libnic's header, please do not include it"
+#endif
+
+#include <nic/nic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "nic.h"
+
+/** Flow steering rule slot */
+typedef struct {
+	/** The slot holds a rule */
+	bool used;
+	/** Rule identifier */
+	nic_flow_id_t id;
+	/** Rule */
+	nic_flow_t flow;
+} nic_flow_slot_t;
+
+/**
+ * Receive queues configuration.
+ * The structure is not synchronized inside, the nic_driver should provide
+ * a synchronized facade.
+ */
+typedef struct nic_rssc {
+	/** Number of receive queues */
+	unsigned int rx_queues;
+	/** Number of transmit queues */
+	unsigned int tx_queues;
+	/** Hash types the NIC supports */
+	uint32_t hash_caps;
+	/** Maximum number of flow steering rules */
+	unsigned int flows_max;
+	/** Current configuration */
+	nic_rss_t rss;
+	/** Flow steering rules */
+	nic_flow_slot_t flows[NIC_FLOWS_MAX];
+	/** Identifier of the next rule */
+	nic_flow_id_t next_id;
+} nic_rssc_t;
+
+extern void nic_rssc_init(nic_rssc_t *);
+extern void nic_rssc_set_queues(nic_rssc_t *, unsigned int, unsigned int,
+    uint32_t, unsigned int);
+extern errno_t nic_rssc_check(const nic_rssc_t *, const nic_rss_t *);
+extern errno_t nic_rssc_flow_add(nic_rssc_t *, const nic_flow_t *,
+    nic_flow_id_t *);
+extern errno_t nic_rssc_flow_remove(nic_rssc_t *, nic_flow_id_t);
+extern unsigned int nic_rssc_queue(const nic_rssc_t *, const void *, size_t,
+    bool);
+
+#endif
+
+/** @}
+ */
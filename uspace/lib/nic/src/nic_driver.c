@@ -143,6 +143,24 @@ void nic_driver_implement(driver_ops_t *driver_ops, ddf_dev_ops_t *dev_ops,
 			iface->poll_set_mode = nic_poll_set_mode_impl;
 		if (!iface->poll_now)
 			iface->poll_now = nic_poll_now_impl;
+		if (!iface->rings_setup)
+			iface->rings_setup = nic_rings_setup_impl;
+		if (!iface->tx_kick)
+			iface->tx_kick = nic_tx_kick_impl;
+		if (!iface->queues_get)
+			iface->queues_get = nic_queues_get_impl;
+		if (!iface->rss_get)
+			iface->rss_get = nic_rss_get_impl;
+		if (!iface->rss_set)
+			iface->rss_set = nic_rss_set_impl;
+		if (!iface->flow_add)
+			iface->flow_add = nic_flow_add_impl;
+		if (!iface->flow_remove)
+			iface->flow_remove = nic_flow_remove_impl;
+		if (!iface->offload_probe)
+			iface->offload_probe = nic_offload_probe_impl;
+		if (!iface->offload_set)
+			iface->offload_set = nic_offload_set_impl;
 	}
 }
 
@@ -160,6 +178,20 @@ void nic_set_send_frame_handler(nic_t *nic_data, send_frame_handler sffunc)
 	nic_data->send_frame = sffunc;
 }
 
+/**
+ * Setup the handler sending frames with checksum offload. This can be called
+ * only in the add_device handler, together with nic_set_send_frame_handler.
+ *
+ * @param nic_data
+ * @param sffunc	Function sending a frame and letting the device complete
+ *			its checksum
+ */
+void nic_set_send_frame_csum_handler(nic_t *nic_data,
+    send_frame_csum_handler sffunc)
+{
+	nic_data->send_frame_csum = sffunc;
+}
+
 /**
  * Setup event handlers for transitions between driver states.
  * This function can be called only in the add_device handler.
@@ -232,6 +264,42 @@ void nic_set_poll_handlers(nic_t *nic_data,
 	nic_data->on_poll_request = on_poll_req;
 }
 
+/**
+ * Report the receive and transmit queues of the NIC.
+ * This function can be called only in the add_device handler. All supported
+ * hash types are enabled and the hash values are spread over the receive
+ * queues in turn.
+ *
+ * @param nic_data
+ * @param rx_queues	Number of receive queues
+ * @param tx_queues	Number of transmit queues
+ * @param hash_caps	Supported hash types (NIC_RSS_HASH_*)
+ * @param flows_max	Maximum number of flow steering rules, zero if not
+ *			supported. Rules are only applied by nic_query_rx_queue
+ *			and nic_query_tx_queue.
+ */
+void nic_set_queues(nic_t *nic_data, unsigned int rx_queues,
+    unsigned int tx_queues, uint32_t hash_caps, unsigned int flows_max)
+{
+	fibril_rwlock_write_lock(&nic_data->rss_lock);
+	nic_rssc_set_queues(&nic_data->rss_control, rx_queues, tx_queues,
+	    hash_caps, flows_max);
+	fibril_rwlock_write_unlock(&nic_data->rss_lock);
+}
+
+/**
+ * Setup the handler programming the receive-side scaling configuration into
+ * the NIC. This function can be called only in the add_device handler.
+ *
+ * @param nic_data
+ * @param on_rss_change	Called when the configuration is about to be changed
+ */
+void nic_set_rss_change_handler(nic_t *nic_data,
+    rss_change_handler on_rss_change)
+{
+	nic_data->on_rss_change = on_rss_change;
+}
+
 /**
  * Connect to the parent's driver and get HW resources list in parsed format.
  * Note: this function should be called only from add_device handler, therefore
@@ -507,6 +575,43 @@ void nic_set_tx_busy(nic_t *nic_data, int busy)
 	nic_data->tx_busy = busy;
 }
 
+/**
+ * Pass a received frame to the client, in the rx ring if it was set up.
+ *
+ * The client is notified only if it is waiting for frames, so a burst of
+ * frames costs a single notification. If the ring is full, the frame is
+ * dropped.
+ *
+ * @param nic_data
+ * @param data		Frame data
+ * @param size		Frame size
+ */
+static void nic_deliver_frame(nic_t *nic_data, void *data, size_t size)
+{
+	bool queued;
+	bool kick;
+
+	fibril_mutex_lock(&nic_data->rx_ring_lock);
+	if (nic_data->rings == NULL || size > NIC_RING_SLOT_SIZE) {
+		fibril_mutex_unlock(&nic_data->rx_ring_lock);
+		nic_ev_received(nic_data->client_session, data, size);
+		return;
+	}
+
+	queued = nic_ring_put(&nic_data->rings->rx, data, size, NULL, &kick);
+	fibril_mutex_unlock(&nic_data->rx_ring_lock);
+
+	if (!queued) {
+		fibril_rwlock_write_lock(&nic_data->stats_lock);
+		nic_data->stats.receive_dropped++;
+		fibril_rwlock_write_unlock(&nic_data->stats_lock);
+		return;
+	}
+
+	if (kick)
+		nic_ev_rx_kick(nic_data->client_session);
+}
+
 /**
  * This is the function that the driver should call when it receives a frame.
  * The frame is checked by filters and then sent up to the NIL layer or
@@ -543,8 +648,7 @@ void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
 			break;
 		}
 		fibril_rwlock_write_unlock(&nic_data->stats_lock);
-		nic_ev_received(nic_data->client_session, frame->data,
-		    frame->size);
+		nic_deliver_frame(nic_data, frame->data, frame->size);
 	} else {
 		switch (frame_type) {
 		case NIC_FRAME_UNICAST:
@@ -585,6 +689,65 @@ void nic_received_frame_list(nic_t *nic_data, nic_frame_list_t *frames)
 	nic_driver_release_frame_list(frames);
 }
 
+/**
+ * Get the current receive-side scaling configuration, e.g. to program it into
+ * the NIC after a reset.
+ *
+ * @param nic_data
+ * @param[out] rss	Configuration
+ */
+void nic_query_rss(nic_t *nic_data, nic_rss_t *rss)
+{
+	fibril_rwlock_read_lock(&nic_data->rss_lock);
+	*rss = nic_data->rss_control.rss;
+	fibril_rwlock_read_unlock(&nic_data->rss_lock);
+}
+
+/**
+ * Determine the receive queue of a received frame in software, for NICs
+ * which have several queues but cannot steer the frames themselves.
+ *
+ * @param nic_data
+ * @param data		Frame data
+ * @param size		Frame size
+ *
+ * @return Receive queue number
+ */
+unsigned int nic_query_rx_queue(nic_t *nic_data, const void *data,
+    size_t size)
+{
+	fibril_rwlock_read_lock(&nic_data->rss_lock);
+	unsigned int queue = nic_rssc_queue(&nic_data->rss_control, data, size,
+	    false);
+	fibril_rwlock_read_unlock(&nic_data->rss_lock);
+
+	return queue;
+}
+
+/**
+ * Determine the transmit queue of a frame to send.
+ *
+ * The frame is sent on the queue its replies are received on. NICs which
+ * receive a flow on the queue it is sent on thus follow the receive-side
+ * scaling configuration and the flow steering rules.
+ *
+ * @param nic_data
+ * @param data		Frame data
+ * @param size		Frame size
+ *
+ * @return Transmit queue number
+ */
+unsigned int nic_query_tx_queue(nic_t *nic_data, const void *data,
+    size_t size)
+{
+	fibril_rwlock_read_lock(&nic_data->rss_lock);
+	unsigned int queue = nic_rssc_queue(&nic_data->rss_control, data, size,
+	    true) % nic_data->rss_control.tx_queues;
+	fibril_rwlock_read_unlock(&nic_data->rss_lock);
+
+	return queue;
+}
+
 /** Allocate and initialize the driver data.
  *
  * @return Allocated structure or NULL.
@@ -612,15 +775,24 @@ static nic_t *nic_create(ddf_dev_t *dev)
 	nic_data->poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->default_poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->send_frame = NULL;
+	nic_data->send_frame_csum = NULL;
+	nic_data->offload_active = 0;
 	nic_data->on_activating = NULL;
 	nic_data->on_going_down = NULL;
 	nic_data->on_stopping = NULL;
+	nic_data->rings = NULL;
+	nic_data->on_rss_change = NULL;
 	nic_data->specific = NULL;
 
+	nic_rssc_init(&nic_data->rss_control);
+
 	fibril_rwlock_initialize(&nic_data->main_lock);
 	fibril_rwlock_initialize(&nic_data->stats_lock);
 	fibril_rwlock_initialize(&nic_data->rxc_lock);
 	fibril_rwlock_initialize(&nic_data->wv_lock);
+	fibril_mutex_initialize(&nic_data->rx_ring_lock);
+	fibril_mutex_initialize(&nic_data->tx_ring_lock);
+	fibril_rwlock_initialize(&nic_data->rss_lock);
 
 	memset(&nic_data->mac, 0, sizeof(nic_address_t));
 	memset(&nic_data->default_mac, 0, sizeof(nic_address_t));
@@ -658,6 +830,8 @@ nic_t *nic_create_and_bind(ddf_dev_t *device)
  */
 static void nic_destroy(nic_t *nic_data)
 {
+	if (nic_data->rings != NULL)
+		as_area_destroy(nic_data->rings);
 	free(nic_data->specific);
 }
 
@@ -1023,6 +1197,32 @@ void nic_report_collisions(nic_t *nic_data, unsigned count)
 	fibril_rwlock_write_unlock(&nic_data->stats_lock);
 }
 
+/**
+ * Raises the interrupts counter in device statistics.
+ *
+ * Called by the driver for each device interrupt it handles.
+ */
+void nic_report_interrupt(nic_t *nic_data)
+{
+	fibril_rwlock_write_lock(&nic_data->stats_lock);
+	nic_data->stats.interrupts++;
+	fibril_rwlock_write_unlock(&nic_data->stats_lock);
+}
+
+/**
+ * Raises the polls counter in device statistics.
+ *
+ * Polls requested through the NIC interface and the software periodic
+ * polling are counted here, drivers polling the device on their own
+ * should call it as well.
+ */
+void nic_report_poll(nic_t *nic_data)
+{
+	fibril_rwlock_write_lock(&nic_data->stats_lock);
+	nic_data->stats.polls++;
+	fibril_rwlock_write_unlock(&nic_data->stats_lock);
+}
+
 /** Just wrapper for checking nonzero time interval
  *
  *  @oaram t The interval to check
@@ -1092,6 +1292,7 @@ static errno_t period_fibril_fun(void *data)
 		/* Provide polling if the period finished */
 		fibril_rwlock_read_lock(&nic->main_lock);
 		if (info->running && info->run == run) {
+			nic_report_poll(nic);
 			nic->on_poll_request(nic);
 		}
 		fibril_rwlock_read_unlock(&nic->main_lock);
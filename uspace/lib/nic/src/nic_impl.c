@@ -35,6 +35,7 @@
  * @brief Default DDF NIC interface methods implementations
  */
 
+#include <as.h>
 #include <errno.h>
 #include <str_error.h>
 #include <ipc/services.h>
@@ -158,18 +159,56 @@ errno_t nic_set_state_impl(ddf_fun_t *fun, nic_device_state_t state)
 	return EOK;
 }
 
+/**
+ * Complete the checksum of a frame in software.
+ *
+ * The checksum field contains the sum of the pseudo header, the one's
+ * complement sum of the data from csum->start to the end of the frame
+ * is computed and stored in it.
+ *
+ * @param	data	Frame data
+ * @param 	size	Frame size in bytes
+ * @param	csum	Checksum to complete
+ */
+static void nic_csum_complete(uint8_t *data, size_t size,
+    const nic_csum_t *csum)
+{
+	uint32_t sum = 0;
+	size_t i;
+
+	if ((size_t) csum->start + csum->offset + 2 > size)
+		return;
+
+	for (i = csum->start; i + 1 < size; i += 2)
+		sum += ((uint32_t) data[i] << 8) | data[i + 1];
+	if (i < size)
+		sum += (uint32_t) data[i] << 8;
+
+	while ((sum >> 16) != 0)
+		sum = (sum & 0xffff) + (sum >> 16);
+	sum = ~sum & 0xffff;
+
+	data[csum->start + csum->offset] = sum >> 8;
+	data[csum->start + csum->offset + 1] = sum & 0xff;
+}
+
 /**
  * Default implementation of the send_frame method.
  * Send messages to the network.
  *
+ * If the frame checksum is to be completed and the device does not do it,
+ * it is completed in software.
+ *
  * @param	fun
  * @param	data	Frame data
  * @param 	size	Frame size in bytes
+ * @param	csum	Checksum to complete or NULL if the frame is complete
  *
  * @return EOK		If the message was sent
  * @return EBUSY	If the device is not in state when the frame can be sent.
  */
-errno_t nic_send_frame_impl(ddf_fun_t *fun, void *data, size_t size)
+errno_t nic_send_frame_impl(ddf_fun_t *fun, void *data, size_t size,
+    const nic_csum_t *csum)
 {
 	nic_t *nic_data = nic_get_from_ddf_fun(fun);
 
@@ -179,6 +218,17 @@ errno_t nic_send_frame_impl(ddf_fun_t *fun, void *data, size_t size)
 		return EBUSY;
 	}
 
+	if (csum != NULL && csum->offset != 0) {
+		if ((nic_data->offload_active & NIC_OFFLOAD_TX_CSUM) != 0 &&
+		    nic_data->send_frame_csum != NULL) {
+			nic_data->send_frame_csum(nic_data, data, size, csum);
+			fibril_rwlock_read_unlock(&nic_data->main_lock);
+			return EOK;
+		}
+
+		nic_csum_complete(data, size, csum);
+	}
+
 	nic_data->send_frame(nic_data, data, size);
 	fibril_rwlock_read_unlock(&nic_data->main_lock);
 	return EOK;
@@ -799,6 +849,7 @@ errno_t nic_poll_now_impl(ddf_fun_t *fun)
 		return EINVAL;
 	}
 	if (nic_data->on_poll_request != NULL) {
+		nic_report_poll(nic_data);
 		nic_data->on_poll_request(nic_data);
 		fibril_rwlock_read_unlock(&nic_data->main_lock);
 		return EOK;
@@ -808,6 +859,224 @@ errno_t nic_poll_now_impl(ddf_fun_t *fun)
 	}
 }
 
+/**
+ * Default implementation of the rings_setup method.
+ * Starts passing frames to and from the client in the shared frame rings.
+ * Rings shared earlier are unmapped.
+ *
+ * @param	fun
+ * @param	rings	Frame rings mapped from the client
+ *
+ * @return EOK always.
+ */
+errno_t nic_rings_setup_impl(ddf_fun_t *fun, nic_rings_t *rings)
+{
+	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+
+	fibril_mutex_lock(&nic_data->tx_ring_lock);
+	fibril_mutex_lock(&nic_data->rx_ring_lock);
+	nic_rings_t *old = nic_data->rings;
+	nic_data->rings = rings;
+	fibril_mutex_unlock(&nic_data->rx_ring_lock);
+	fibril_mutex_unlock(&nic_data->tx_ring_lock);
+
+	if (old != NULL)
+		as_area_destroy(old);
+
+	return EOK;
+}
+
+/**
+ * Default implementation of the tx_kick method.
+ * Sends all frames from the tx ring, including those the client puts there
+ * meanwhile, using the default send_frame implementation.
+ *
+ * @param	fun
+ *
+ * @return EOK		If the ring was drained
+ * @return ENOENT	If no frame rings were set up
+ */
+errno_t nic_tx_kick_impl(ddf_fun_t *fun)
+{
+	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+	nic_csum_t csum;
+	void *data;
+	size_t size;
+
+	fibril_mutex_lock(&nic_data->tx_ring_lock);
+	if (nic_data->rings == NULL) {
+		fibril_mutex_unlock(&nic_data->tx_ring_lock);
+		return ENOENT;
+	}
+
+	nic_ring_t *ring = &nic_data->rings->tx;
+
+	do {
+		while ((data = nic_ring_peek(ring, &size, &csum)) != NULL) {
+			if (size <= NIC_RING_SLOT_SIZE)
+				(void) nic_send_frame_impl(fun, data, size, &csum);
+			nic_ring_pop(ring);
+		}
+	} while (!nic_ring_idle(ring));
+
+	fibril_mutex_unlock(&nic_data->tx_ring_lock);
+	return EOK;
+}
+
+/**
+ * Default implementation of the queues_get method.
+ *
+ * @param		fun
+ * @param[out]	queues	Queues reported by the driver
+ *
+ * @return EOK always.
+ */
+errno_t nic_queues_get_impl(ddf_fun_t *fun, nic_queues_t *queues)
+{
+	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+	fibril_rwlock_read_lock(&nic_data->rss_lock);
+	queues->rx_queues = nic_data->rss_control.rx_queues;
+	queues->tx_queues = nic_data->rss_control.tx_queues;
+	queues->rss_hash_caps = nic_data->rss_control.hash_caps;
+	queues->flows_max = nic_data->rss_control.flows_max;
+	fibril_rwlock_read_unlock(&nic_data->rss_lock);
+	return EOK;
+}
+
+/**
+ * Default implementation of the rss_get method.
+ *
+ * @param		fun
+ * @param[out]	rss	Current configuration
+ *
+ * @return EOK always.
+ */
+errno_t nic_rss_get_impl(ddf_fun_t *fun, nic_rss_t *rss)
+{
+	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+	nic_query_rss(nic_data, rss);
+	return EOK;
+}
+
+/**
+ * Default implementation of the rss_set method.
+ * The configuration is checked and passed to the driver's handler, if there
+ * is one.
+ *
+ * @param	fun
+ * @param	rss	New configuration
+ *
+ * @return EOK		If the configuration was set
+ * @return EINVAL	If it uses an unsupported hash type or a queue the
+ *			NIC does not have
+ * @return error code	If the driver failed to set it
+ */
+errno_t nic_rss_set_impl(ddf_fun_t *fun, const nic_rss_t *rss)
+{
+	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+	fibril_rwlock_write_lock(&nic_data->rss_lock);
+	errno_t rc = nic_rssc_check(&nic_data->rss_control, rss);
+	if (rc == EOK && nic_data->on_rss_change != NULL)
+		rc = nic_data->on_rss_change(nic_data, rss);
+	if (rc == EOK)
+		nic_data->rss_control.rss = *rss;
+	fibril_rwlock_write_unlock(&nic_data->rss_lock);
+	return rc;
+}
+
+/**
+ * Default implementation of the flow_add method.
+ *
+ * @param		fun
+ * @param		flow	Rule
+ * @param[out]	id		Identifier of the new rule
+ *
+ * @return EOK		If the rule was added
+ * @return ENOTSUP	If the driver does not apply the rules
+ * @return EINVAL	If the rule directs to a queue the NIC does not have
+ * @return ELIMIT	If there are too many rules
+ */
+errno_t nic_flow_add_impl(ddf_fun_t *fun, const nic_flow_t *flow,
+    nic_flow_id_t *id)
+{
+	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+	fibril_rwlock_write_lock(&nic_data->rss_lock);
+	errno_t rc = nic_rssc_flow_add(&nic_data->rss_control, flow, id);
+	fibril_rwlock_write_unlock(&nic_data->rss_lock);
+	return rc;
+}
+
+/**
+ * Default implementation of the flow_remove method.
+ *
+ * @param	fun
+ * @param	id	Rule identifier
+ *
+ * @return EOK		If the rule was removed
+ * @return ENOENT	If there is no such rule
+ */
+errno_t nic_flow_remove_impl(ddf_fun_t *fun, nic_flow_id_t id)
+{
+	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+	fibril_rwlock_write_lock(&nic_data->rss_lock);
+	errno_t rc = nic_rssc_flow_remove(&nic_data->rss_control, id);
+	fibril_rwlock_write_unlock(&nic_data->rss_lock);
+	return rc;
+}
+
+/**
+ * Default implementation of the offload_probe method.
+ * Checksum offload is supported if the driver has set the handler sending
+ * frames with it.
+ *
+ * @param		fun
+ * @param[out]	supported	Supported offload computations
+ * @param[out]	active		Active offload computations
+ *
+ * @return EOK always.
+ */
+errno_t nic_offload_probe_impl(ddf_fun_t *fun, uint32_t *supported,
+    uint32_t *active)
+{
+	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+
+	fibril_rwlock_read_lock(&nic_data->main_lock);
+	*supported = nic_data->send_frame_csum != NULL ?
+	    NIC_OFFLOAD_TX_CSUM : 0;
+	*active = nic_data->offload_active;
+	fibril_rwlock_read_unlock(&nic_data->main_lock);
+	return EOK;
+}
+
+/**
+ * Default implementation of the offload_set method.
+ *
+ * @param	fun
+ * @param	mask	Offload computations to change
+ * @param	active	New setting of the computations in the mask
+ *
+ * @return EOK		If the setting was changed
+ * @return ENOTSUP	If some of the computations is not supported
+ */
+errno_t nic_offload_set_impl(ddf_fun_t *fun, uint32_t mask, uint32_t active)
+{
+	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+	uint32_t supported;
+
+	fibril_rwlock_write_lock(&nic_data->main_lock);
+	supported = nic_data->send_frame_csum != NULL ?
+	    NIC_OFFLOAD_TX_CSUM : 0;
+	if ((active & mask & ~supported) != 0) {
+		fibril_rwlock_write_unlock(&nic_data->main_lock);
+		return ENOTSUP;
+	}
+
+	nic_data->offload_active = (nic_data->offload_active & ~mask) |
+	    (active & mask);
+	fibril_rwlock_write_unlock(&nic_data->main_lock);
+	return EOK;
+}
+
 /**
  * Default handler for unknown methods (outside of the NIC interface).
  * Logs a warning message and returns ENOTSUP to the caller.
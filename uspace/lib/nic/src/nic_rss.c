@@ -0,0 +1,390 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @addtogroup libnic
+ * @{
+ */
+/**
+ * @file
+ * @brief Receive-side scaling and flow steering
+ *
+ * Frames are classified the way a NIC with RSS does it: a flow steering
+ * rule matching the frame selects its queue, otherwise the Toeplitz hash of
+ * its addresses (and ports) selects an entry of the redirection table.
+ * Drivers of NICs which steer in hardware only keep the configuration here,
+ * the others use the classification to pick a queue in software.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <inet/rss.h>
+#include <mem.h>
+#include <nic/nic.h>
+#include "nic_rss.h"
+
+#define ETH_HDR_SIZE  14
+#define ETH_TYPE_OFFSET  12
+#define ETH_TYPE_IPV4  0x0800
+#define ETH_TYPE_IPV6  0x86dd
+#define ETH_TYPE_VLAN  0x8100
+#define VLAN_HDR_SIZE  4
+
+#define IPV4_HDR_SIZE  20
+#define IPV6_HDR_SIZE  40
+
+#define IP_PROTO_TCP  6
+#define IP_PROTO_UDP  17
+
+/* A NIC RSS configuration is passed to the inet hash as is */
+static_assert(NIC_RSS_KEY_SIZE == INET_RSS_KEY_SIZE, "");
+static_assert(NIC_RSS_RETA_SIZE == INET_RSS_RETA_SIZE, "");
+
+/** Addresses and ports of a frame, oriented for reception */
+typedef struct {
+	/** IP version, 4 or 6 */
+	int version;
+	/** IP protocol number */
+	uint8_t protocol;
+	/** The ports are valid */
+	bool has_ports;
+	/** Source and destination address, in network byte order */
+	uint8_t addr[2][16];
+	/** Source and destination port, in network byte order */
+	uint8_t port[2][2];
+} nic_rss_tuple_t;
+
+/** Get a 16-bit value in network byte order. */
+static uint16_t nic_rss_get16(const uint8_t *p)
+{
+	return ((uint16_t) p[0] << 8) | p[1];
+}
+
+/** Get a 32-bit value in network byte order. */
+static uint32_t nic_rss_get32(const uint8_t *p)
+{
+	return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+	    ((uint32_t) p[2] << 8) | p[3];
+}
+
+/** Fill in the default redirection table.
+ *
+ * The hash values are spread over the receive queues in turn, so the queue
+ * of a hash value is its redirection table index modulo the number of queues.
+ *
+ * @param rssc Receive queues configuration
+ */
+static void nic_rssc_reta_default(nic_rssc_t *rssc)
+{
+	for (size_t i = 0; i < NIC_RSS_RETA_SIZE; i++)
+		rssc->rss.reta[i] = i % rssc->rx_queues;
+}
+
+/** Initialize receive queues configuration for a single queue NIC.
+ *
+ * @param rssc Receive queues configuration
+ */
+void nic_rssc_init(nic_rssc_t *rssc)
+{
+	memset(rssc, 0, sizeof(nic_rssc_t));
+	rssc->rx_queues = 1;
+	rssc->tx_queues = 1;
+	rssc->next_id = 1;
+	memcpy(rssc->rss.key, inet_rss_default_key, NIC_RSS_KEY_SIZE);
+	nic_rssc_reta_default(rssc);
+}
+
+/** Set the queues of the NIC.
+ *
+ * All supported hash types are enabled with the default key and redirection
+ * table. Flow steering rules are dropped.
+ *
+ * @param rssc      Receive queues configuration
+ * @param rx_queues Number of receive queues
+ * @param tx_queues Number of transmit queues
+ * @param hash_caps Supported hash types
+ * @param flows_max Maximum number of flow steering rules
+ */
+void nic_rssc_set_queues(nic_rssc_t *rssc, unsigned int rx_queues,
+    unsigned int tx_queues, uint32_t hash_caps, unsigned int flows_max)
+{
+	assert(rx_queues > 0 && rx_queues <= NIC_QUEUES_MAX);
+	assert(tx_queues > 0 && tx_queues <= NIC_QUEUES_MAX);
+	assert(flows_max <= NIC_FLOWS_MAX);
+
+	rssc->rx_queues = rx_queues;
+	rssc->tx_queues = tx_queues;
+	rssc->hash_caps = hash_caps;
+	rssc->flows_max = flows_max;
+	rssc->rss.hash_types = hash_caps;
+	memset(rssc->flows, 0, sizeof(rssc->flows));
+	nic_rssc_reta_default(rssc);
+}
+
+/** Check whether a configuration can be set.
+ *
+ * @param rssc Receive queues configuration
+ * @param rss  New configuration
+ *
+ * @return EOK if it can be set
+ * @return EINVAL if it uses an unsupported hash type or a queue the NIC
+ *         does not have
+ */
+errno_t nic_rssc_check(const nic_rssc_t *rssc, const nic_rss_t *rss)
+{
+	if ((rss->hash_types & ~rssc->hash_caps) != 0)
+		return EINVAL;
+
+	for (size_t i = 0; i < NIC_RSS_RETA_SIZE; i++) {
+		if (rss->reta[i] >= rssc->rx_queues)
+			return EINVAL;
+	}
+
+	return EOK;
+}
+
+/** Add a flow steering rule.
+ *
+ * @param rssc Receive queues configuration
+ * @param flow Rule
+ * @param[out] id Identifier of the new rule
+ *
+ * @return EOK on success
+ * @return ENOTSUP if flow steering is not supported
+ * @return EINVAL if the rule directs to a queue the NIC does not have
+ * @return ELIMIT if there are too many rules
+ */
+errno_t nic_rssc_flow_add(nic_rssc_t *rssc, const nic_flow_t *flow,
+    nic_flow_id_t *id)
+{
+	if (rssc->flows_max == 0)
+		return ENOTSUP;
+
+	if (flow->queue >= rssc->rx_queues)
+		return EINVAL;
+
+	for (size_t i = 0; i < rssc->flows_max; i++) {
+		if (!rssc->flows[i].used) {
+			rssc->flows[i].used = true;
+			rssc->flows[i].id = rssc->next_id++;
+			rssc->flows[i].flow = *flow;
+			*id = rssc->flows[i].id;
+			return EOK;
+		}
+	}
+
+	return ELIMIT;
+}
+
+/** Remove a flow steering rule.
+ *
+ * @param rssc Receive queues configuration
+ * @param id   Rule identifier
+ *
+ * @return EOK on success
+ * @return ENOENT if there is no such rule
+ */
+errno_t nic_rssc_flow_remove(nic_rssc_t *rssc, nic_flow_id_t id)
+{
+	for (size_t i = 0; i < rssc->flows_max; i++) {
+		if (rssc->flows[i].used && rssc->flows[i].id == id) {
+			rssc->flows[i].used = false;
+			return EOK;
+		}
+	}
+
+	return ENOENT;
+}
+
+/** Get addresses and ports of a frame.
+ *
+ * @param data    Frame data
+ * @param size    Frame size
+ * @param reverse The frame is sent, orient the tuple for the replies
+ * @param[out] t  Tuple
+ *
+ * @return @c true if the frame is an IP datagram
+ */
+static bool nic_rss_tuple_get(const uint8_t *data, size_t size, bool reverse,
+    nic_rss_tuple_t *t)
+{
+	size_t off = ETH_HDR_SIZE;
+	size_t asize;
+	size_t hsize;
+	uint16_t type;
+	int s = reverse ? 1 : 0;
+
+	if (size < ETH_HDR_SIZE)
+		return false;
+
+	type = nic_rss_get16(data + ETH_TYPE_OFFSET);
+	if (type == ETH_TYPE_VLAN) {
+		if (size < ETH_HDR_SIZE + VLAN_HDR_SIZE)
+			return false;
+		type = nic_rss_get16(data + ETH_TYPE_OFFSET + VLAN_HDR_SIZE);
+		off += VLAN_HDR_SIZE;
+	}
+
+	const uint8_t *ip = data + off;
+	size -= off;
+
+	switch (type) {
+	case ETH_TYPE_IPV4:
+		if (size < IPV4_HDR_SIZE || (ip[0] >> 4) != 4)
+			return false;
+		t->version = 4;
+		t->protocol = ip[9];
+		asize = 4;
+		memcpy(t->addr[s], ip + 12, asize);
+		memcpy(t->addr[1 - s], ip + 16, asize);
+		hsize = (ip[0] & 0x0f) * 4;
+		if (hsize < IPV4_HDR_SIZE)
+			return false;
+		/* Fragments are hashed without the ports */
+		t->has_ports = (nic_rss_get16(ip + 6) & 0x3fff) == 0;
+		break;
+	case ETH_TYPE_IPV6:
+		if (size < IPV6_HDR_SIZE || (ip[0] >> 4) != 6)
+			return false;
+		t->version = 6;
+		t->protocol = ip[6];
+		asize = 16;
+		memcpy(t->addr[s], ip + 8, asize);
+		memcpy(t->addr[1 - s], ip + 24, asize);
+		hsize = IPV6_HDR_SIZE;
+		t->has_ports = true;
+		break;
+	default:
+		return false;
+	}
+
+	if (t->protocol != IP_PROTO_TCP && t->protocol != IP_PROTO_UDP)
+		t->has_ports = false;
+	if (hsize + 2 * sizeof(uint16_t) > size)
+		t->has_ports = false;
+
+	if (t->has_ports) {
+		memcpy(t->port[s], ip + hsize, 2);
+		memcpy(t->port[1 - s], ip + hsize + 2, 2);
+	}
+
+	return true;
+}
+
+/** Match a flow steering rule against a tuple.
+ *
+ * @param flow Rule
+ * @param t    Tuple
+ * @return @c true if the rule matches
+ */
+static bool nic_flow_match(const nic_flow_t *flow, const nic_rss_tuple_t *t)
+{
+	if (t->version != 4 || !t->has_ports)
+		return false;
+
+	if (flow->protocol != 0 && flow->protocol != t->protocol)
+		return false;
+	if (flow->src_addr != 0 && flow->src_addr != nic_rss_get32(t->addr[0]))
+		return false;
+	if (flow->dest_addr != 0 &&
+	    flow->dest_addr != nic_rss_get32(t->addr[1]))
+		return false;
+	if (flow->src_port != 0 && flow->src_port != nic_rss_get16(t->port[0]))
+		return false;
+	if (flow->dest_port != 0 &&
+	    flow->dest_port != nic_rss_get16(t->port[1]))
+		return false;
+
+	return true;
+}
+
+/** Determine the receive queue of a frame.
+ *
+ * A frame which is sent is classified as the replies to it will be, so that
+ * a NIC which receives a flow on the queue it is sent on steers it the
+ * same way.
+ *
+ * @param rssc    Receive queues configuration
+ * @param data    Frame data
+ * @param size    Frame size
+ * @param reverse The frame is sent rather than received
+ *
+ * @return Receive queue number
+ */
+unsigned int nic_rssc_queue(const nic_rssc_t *rssc, const void *data,
+    size_t size, bool reverse)
+{
+	nic_rss_tuple_t t;
+	uint8_t buf[2 * 16 + 2 * 2];
+	uint32_t ip_type;
+	uint32_t l4_type;
+	size_t asize;
+	size_t len;
+
+	if (rssc->rx_queues <= 1)
+		return 0;
+
+	if (!nic_rss_tuple_get(data, size, reverse, &t))
+		return 0;
+
+	for (size_t i = 0; i < rssc->flows_max; i++) {
+		if (rssc->flows[i].used &&
+		    nic_flow_match(&rssc->flows[i].flow, &t))
+			return rssc->flows[i].flow.queue;
+	}
+
+	if (t.version == 4) {
+		ip_type = NIC_RSS_HASH_IPV4;
+		l4_type = t.protocol == IP_PROTO_TCP ? NIC_RSS_HASH_TCP_IPV4 :
+		    NIC_RSS_HASH_UDP_IPV4;
+		asize = 4;
+	} else {
+		ip_type = NIC_RSS_HASH_IPV6;
+		l4_type = t.protocol == IP_PROTO_TCP ? NIC_RSS_HASH_TCP_IPV6 :
+		    NIC_RSS_HASH_UDP_IPV6;
+		asize = 16;
+	}
+
+	memcpy(buf, t.addr[0], asize);
+	memcpy(buf + asize, t.addr[1], asize);
+	len = 2 * asize;
+
+	if (t.has_ports && (rssc->rss.hash_types & l4_type) != 0) {
+		memcpy(buf + len, t.port[0], 2);
+		memcpy(buf + len + 2, t.port[1], 2);
+		len += 4;
+	} else if ((rssc->rss.hash_types & ip_type) == 0) {
+		return 0;
+	}
+
+	uint32_t hash = inet_rss_hash(rssc->rss.key, buf, len);
+	return rssc->rss.reta[inet_rss_reta_index(hash)];
+}
+
+/** @}
+ */
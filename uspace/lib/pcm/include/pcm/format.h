@@ -47,6 +47,16 @@ typedef struct {
 	pcm_sample_format_t sample_format;
 } pcm_format_t;
 
+/** Mixer of audio data in a fixed pair of formats */
+typedef struct pcm_mixer {
+	/** Source format */
+	pcm_format_t src;
+	/** Destination format */
+	pcm_format_t dst;
+	/** Mix frames of source data into destination data */
+	void (*mix)(const struct pcm_mixer *, void *, const void *, size_t);
+} pcm_mixer_t;
+
 extern const pcm_format_t AUDIO_FORMAT_DEFAULT;
 extern const pcm_format_t AUDIO_FORMAT_ANY;
 
@@ -102,6 +112,37 @@ errno_t pcm_format_convert_and_mix(void *dst, size_t dst_size, const void *src,
 errno_t pcm_format_mix(void *dst, const void *src, size_t size, const pcm_format_t *f);
 errno_t pcm_format_convert(pcm_format_t a, void *srca, size_t sizea,
     pcm_format_t b, void *srcb, size_t *sizeb);
+void pcm_mixer_init(pcm_mixer_t *mixer, const pcm_format_t *sf,
+    const pcm_format_t *df);
+
+/**
+ * Check whether mixer handles the given pair of formats.
+ * @param mixer Pointer to the mixer.
+ * @param sf Pointer to the source format descriptor.
+ * @param df Pointer to the destination format descriptor.
+ * @return True if the mixer was initialized for @p sf and @p df.
+ */
+static inline bool pcm_mixer_matches(const pcm_mixer_t *mixer,
+    const pcm_format_t *sf, const pcm_format_t *df)
+{
+	return pcm_format_same(&mixer->src, sf) &&
+	    pcm_format_same(&mixer->dst, df);
+}
+
+/**
+ * Mix audio data using a mixer.
+ * @param mixer Pointer to the mixer.
+ * @param dst Destination buffer.
+ * @param src Source buffer.
+ * @param frames Number of frames to mix.
+ *
+ * Both buffers must contain at least @p frames frames in their formats.
+ */
+static inline void pcm_mixer_mix(const pcm_mixer_t *mixer, void *dst,
+    const void *src, size_t frames)
+{
+	mixer->mix(mixer, dst, src, frames);
+}
 
 #endif
 
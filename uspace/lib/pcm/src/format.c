@@ -72,6 +72,20 @@ const pcm_format_t AUDIO_FORMAT_ANY = {
 static float get_normalized_sample(const void *buffer, size_t size,
     unsigned frame, unsigned channel, const pcm_format_t *f);
 
+/**
+ * Clamp floating point sample to <-1,1>.
+ * @param c Sample.
+ * @return Clamped sample.
+ */
+static inline float pcm_clamp(float c)
+{
+	if (c < -1.0f)
+		return -1.0f;
+	if (c > 1.0f)
+		return 1.0f;
+	return c;
+}
+
 /**
  * Compare PCM format attribtues.
  * @param a Format description.
@@ -136,6 +150,9 @@ do { \
 	case PCM_SAMPLE_SINT32_BE:
 		SET_NULL(int32_t, le, 0);
 		break;
+	case PCM_SAMPLE_FLOAT32:
+		SET_NULL(float, le, 0);
+		break;
 	case PCM_SAMPLE_UINT24_32_LE:
 	case PCM_SAMPLE_SINT24_32_LE:
 	case PCM_SAMPLE_UINT24_32_BE:
@@ -144,7 +161,6 @@ do { \
 	case PCM_SAMPLE_SINT24_LE:
 	case PCM_SAMPLE_UINT24_BE:
 	case PCM_SAMPLE_SINT24_BE:
-	case PCM_SAMPLE_FLOAT32:
 	default:
 		break;
 	}
@@ -217,6 +233,21 @@ do { \
 	} \
 } while (0)
 
+#define LOOP_ADD_FLOAT() \
+do { \
+	const unsigned frame_count = dst_size / dst_frame_size; \
+	float *dst_buf = dst; \
+	for (size_t i = 0; i < frame_count; ++i) { \
+		for (unsigned j = 0; j < df->channels; ++j) { \
+			const float a = \
+			    get_normalized_sample(dst, dst_size, i, j, df);\
+			const float b = \
+			    get_normalized_sample(src, src_size, i, j, sf);\
+			dst_buf[i * df->channels + j] = pcm_clamp(a + b); \
+		} \
+	} \
+} while (0)
+
 	switch (df->sample_format) {
 	case PCM_SAMPLE_UINT8:
 		LOOP_ADD(uint8_t, le, UINT8_MIN, UINT8_MAX);
@@ -252,16 +283,163 @@ do { \
 	case PCM_SAMPLE_SINT32_BE:
 		LOOP_ADD(int32_t, be, INT32_MIN, INT32_MAX);
 		break;
+	case PCM_SAMPLE_FLOAT32:
+		LOOP_ADD_FLOAT();
+		break;
 	case PCM_SAMPLE_UINT24_LE:
 	case PCM_SAMPLE_SINT24_LE:
 	case PCM_SAMPLE_UINT24_BE:
 	case PCM_SAMPLE_SINT24_BE:
-	case PCM_SAMPLE_FLOAT32:
 	default:
 		return ENOTSUP;
 	}
 	return EOK;
 #undef LOOP_ADD
+#undef LOOP_ADD_FLOAT
+}
+
+/**
+ * Saturate 32-bit value to a 16-bit sample.
+ * @param v Value.
+ * @return Value clamped to <INT16_MIN, INT16_MAX>.
+ */
+static inline int16_t pcm_sat16(int32_t v)
+{
+	if (v > INT16_MAX)
+		return INT16_MAX;
+	if (v < INT16_MIN)
+		return INT16_MIN;
+	return v;
+}
+
+/**
+ * Mix using the generic per-sample conversion.
+ * @param mixer Mixer.
+ * @param dst Destination buffer.
+ * @param src Source buffer.
+ * @param frames Number of frames.
+ */
+static void pcm_mix_generic(const pcm_mixer_t *mixer, void *dst,
+    const void *src, size_t frames)
+{
+	(void) pcm_format_convert_and_mix(dst,
+	    frames * pcm_format_frame_size(&mixer->dst), src,
+	    frames * pcm_format_frame_size(&mixer->src), &mixer->src,
+	    &mixer->dst);
+}
+
+/**
+ * Mix signed 16-bit little-endian samples into the same format.
+ * @param mixer Mixer.
+ * @param dst Destination buffer.
+ * @param src Source buffer.
+ * @param frames Number of frames.
+ *
+ * Samples are added with saturation, eight at a time using SSE2 on amd64.
+ */
+static void pcm_mix_s16le_s16le(const pcm_mixer_t *mixer, void *dst,
+    const void *src, size_t frames)
+{
+	int16_t *d = dst;
+	const int16_t *s = src;
+	const size_t count = frames * mixer->dst.channels;
+	size_t i = 0;
+
+#ifdef __x86_64__
+	for (; i + 16 <= count; i += 16) {
+		asm volatile (
+		    "movdqu (%[s]), %%xmm0\n"
+		    "movdqu 16(%[s]), %%xmm1\n"
+		    "movdqu (%[d]), %%xmm2\n"
+		    "movdqu 16(%[d]), %%xmm3\n"
+		    "paddsw %%xmm2, %%xmm0\n"
+		    "paddsw %%xmm3, %%xmm1\n"
+		    "movdqu %%xmm0, (%[d])\n"
+		    "movdqu %%xmm1, 16(%[d])\n"
+		    :
+		    : [s] "r" (s + i), [d] "r" (d + i)
+		    : "xmm0", "xmm1", "xmm2", "xmm3", "memory"
+		);
+	}
+#endif
+
+	for (; i < count; ++i) {
+		const int32_t a = (int16_t) int16_t_le2host(d[i]);
+		const int32_t b = (int16_t) int16_t_le2host(s[i]);
+		d[i] = host2int16_t_le(pcm_sat16(a + b));
+	}
+}
+
+/**
+ * Mix signed 16-bit little-endian samples into floating point samples.
+ * @param mixer Mixer.
+ * @param dst Destination buffer.
+ * @param src Source buffer.
+ * @param frames Number of frames.
+ */
+static void pcm_mix_s16le_float(const pcm_mixer_t *mixer, void *dst,
+    const void *src, size_t frames)
+{
+	float *d = dst;
+	const int16_t *s = src;
+	const size_t count = frames * mixer->dst.channels;
+
+	for (size_t i = 0; i < count; ++i) {
+		const float b = (int16_t) int16_t_le2host(s[i]);
+		d[i] = pcm_clamp(d[i] + b * (1.0f / 32768.0f));
+	}
+}
+
+/**
+ * Mix floating point samples into the same format.
+ * @param mixer Mixer.
+ * @param dst Destination buffer.
+ * @param src Source buffer.
+ * @param frames Number of frames.
+ */
+static void pcm_mix_float_float(const pcm_mixer_t *mixer, void *dst,
+    const void *src, size_t frames)
+{
+	float *d = dst;
+	const float *s = src;
+	const size_t count = frames * mixer->dst.channels;
+
+	for (size_t i = 0; i < count; ++i)
+		d[i] = pcm_clamp(d[i] + s[i]);
+}
+
+/**
+ * Initialize mixer for a pair of formats.
+ * @param mixer Mixer to initialize.
+ * @param sf Pointer to the source format descriptor.
+ * @param df Pointer to the destination format descriptor.
+ *
+ * Selects a specialized mixing function if one exists for the pair of
+ * formats, so that the selection need not be done for every buffer.
+ */
+void pcm_mixer_init(pcm_mixer_t *mixer, const pcm_format_t *sf,
+    const pcm_format_t *df)
+{
+	assert(mixer);
+	assert(sf);
+	assert(df);
+
+	mixer->src = *sf;
+	mixer->dst = *df;
+	mixer->mix = pcm_mix_generic;
+
+	if (sf->channels != df->channels || sf->channels == 0)
+		return;
+
+	if (sf->sample_format == PCM_SAMPLE_SINT16_LE) {
+		if (df->sample_format == PCM_SAMPLE_SINT16_LE)
+			mixer->mix = pcm_mix_s16le_s16le;
+		else if (df->sample_format == PCM_SAMPLE_FLOAT32)
+			mixer->mix = pcm_mix_s16le_float;
+	} else if (sf->sample_format == PCM_SAMPLE_FLOAT32 &&
+	    df->sample_format == PCM_SAMPLE_FLOAT32) {
+		mixer->mix = pcm_mix_float_float;
+	}
 }
 
 /**
@@ -321,11 +499,15 @@ do { \
 	case PCM_SAMPLE_SINT24_32_BE:
 	case PCM_SAMPLE_SINT32_BE:
 		GET(int32_t, le, INT32_MIN, INT32_MAX);
+	case PCM_SAMPLE_FLOAT32:
+		if (frame * f->channels + channel >= size / sizeof(float))
+			return 0.0f;
+		return pcm_clamp(((const float *) buffer)[frame * f->channels +
+		    channel]);
 	case PCM_SAMPLE_UINT24_LE:
 	case PCM_SAMPLE_SINT24_LE:
 	case PCM_SAMPLE_UINT24_BE:
 	case PCM_SAMPLE_SINT24_BE:
-	case PCM_SAMPLE_FLOAT32:
 	default:
 		break;
 	}
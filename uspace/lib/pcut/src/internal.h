@@ -85,6 +85,62 @@
 
 extern int pcut_run_mode;
 
+/** Default threshold for reporting a test as slow (in milliseconds).
+ *
+ * Used when running times are reported (-T) and no threshold was
+ * given (-w).
+ */
+#define PCUT_DEFAULT_SLOW_THRESHOLD 1000
+
+/** Number of tests to run concurrently in forking mode. */
+extern int pcut_parallel_jobs;
+
+/** Number of times each test is executed (benchmark mode when above one). */
+extern int pcut_bench_iterations;
+
+/** Threshold for reporting a test as slow (in milliseconds, zero disables). */
+extern int pcut_slow_threshold;
+
+/** Whether to report running time of every test (and not only slow ones). */
+extern int pcut_report_times;
+
+/** @def PCUT_HAVE_PARALLEL
+ * Defined when the OS back-end implements pcut_run_tests_parallel().
+ */
+#if defined(__helenos__)
+#define PCUT_HAVE_PARALLEL 1
+#endif
+
+/** Measured running time of a test. */
+typedef struct pcut_test_time pcut_test_time_t;
+
+/** @copydoc pcut_test_time_t */
+struct pcut_test_time {
+	/** Number of measured iterations (zero when nothing was measured). */
+	int iterations;
+	/** Mean wall-clock time of one iteration in microseconds. */
+	long long wall_mean;
+	/** Shortest iteration in microseconds. */
+	long long wall_min;
+	/** Longest iteration in microseconds. */
+	long long wall_max;
+	/** Standard deviation of iteration wall-clock time in microseconds. */
+	long long wall_stddev;
+	/** Mean CPU time of one iteration in microseconds (-1 if unknown). */
+	long long cpu_mean;
+};
+
+/** Callback reporting result of a test run by pcut_run_tests_parallel().
+ *
+ * @param index Index of the test in the array passed to
+ *	pcut_run_tests_parallel().
+ * @param outcome Outcome of the test.
+ * @param unparsed_output Buffer with all the output from the test.
+ * @param unparsed_output_size Size of @p unparsed_output in bytes.
+ */
+typedef void (*pcut_parallel_result_func_t)(int index, int outcome,
+		const char *unparsed_output, size_t unparsed_output_size);
+
 
 pcut_item_t *pcut_fix_list_get_real_head(pcut_item_t *last);
 int pcut_count_tests(pcut_item_t *it);
@@ -98,11 +154,14 @@ int pcut_is_arg_with_number(const char *arg, const char *opt, int *value);
 int pcut_run_test_forking(const char *self_path, pcut_item_t *test);
 int pcut_run_test_forked(pcut_item_t *test);
 int pcut_run_test_single(pcut_item_t *test);
+int pcut_run_tests_parallel(const char *self_path, pcut_item_t **tests,
+		int count, int jobs, pcut_parallel_result_func_t result_func);
 
 int pcut_get_test_timeout(pcut_item_t *test);
 
 void pcut_failed_assertion(const char *message);
 void pcut_print_fail_message(const char *msg);
+void pcut_print_time_message(const pcut_test_time_t *time);
 
 /** Reporting callbacks structure. */
 typedef struct pcut_report_ops pcut_report_ops_t;
@@ -122,6 +181,8 @@ struct pcut_report_ops {
 	/** Test completed. */
 	void (*test_done)(pcut_item_t *, int, const char *, const char *,
 		const char *);
+	/** Running time of a test (reported right before its completion). */
+	void (*test_time)(pcut_item_t *, const pcut_test_time_t *);
 };
 
 void pcut_report_register_handler(pcut_report_ops_t *ops);
@@ -135,6 +196,7 @@ void pcut_report_test_done(pcut_item_t *test, int outcome,
 		const char *extra_output);
 void pcut_report_test_done_unparsed(pcut_item_t *test, int outcome,
 		const char *unparsed_output, size_t unparsed_output_size);
+void pcut_report_test_time(pcut_item_t *test, const pcut_test_time_t *time);
 void pcut_report_done(void);
 
 /* OS-dependent functions. */
@@ -151,6 +213,15 @@ void pcut_report_done(void);
  */
 void pcut_hook_before_test(pcut_item_t *test);
 
+/** Get current wall-clock time.
+ *
+ * The time is only used to measure intervals, so it does not matter
+ * when the epoch is.
+ *
+ * @return Current time in microseconds.
+ */
+long long pcut_get_wall_time(void);
+
 /** Tell whether two strings start with the same prefix.
  *
  * @param a First string.
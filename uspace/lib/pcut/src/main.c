@@ -44,6 +44,18 @@
 /** Current running mode. */
 int pcut_run_mode = PCUT_RUN_MODE_FORKING;
 
+/** Number of tests to run concurrently. */
+int pcut_parallel_jobs = 1;
+
+/** Number of iterations of each test. */
+int pcut_bench_iterations = 1;
+
+/** Threshold for reporting a test as slow (-1 until decided). */
+int pcut_slow_threshold = -1;
+
+/** Whether to report running time of every test. */
+int pcut_report_times = 0;
+
 /** Empty list to bypass special handling for NULL. */
 static pcut_main_extra_t empty_main_extra[] = {
 	PCUT_MAIN_EXTRA_SET_LAST
@@ -151,6 +163,112 @@ leave_no_print:
 	return ret_code;
 }
 
+#ifdef PCUT_HAVE_PARALLEL
+
+/** Suites of tests run in parallel mode. */
+static pcut_item_t **parallel_suites;
+
+/** Tests run in parallel mode. */
+static pcut_item_t **parallel_tests;
+
+/** Suite of the last reported test in parallel mode. */
+static pcut_item_t *parallel_current_suite;
+
+/** Return code of tests run in parallel mode. */
+static int parallel_ret_code;
+
+/** Report result of a test run in parallel mode.
+ *
+ * Results arrive in the order of the tests, so suites can be reported
+ * in the same way as when running tests one by one.
+ *
+ * @param index Index of the test.
+ * @param outcome Outcome of the test.
+ * @param unparsed_output Buffer with all the output from the test.
+ * @param unparsed_output_size Size of @p unparsed_output in bytes.
+ */
+static void report_parallel_result(int index, int outcome,
+		const char *unparsed_output, size_t unparsed_output_size) {
+	pcut_item_t *suite = parallel_suites[index];
+	pcut_item_t *test = parallel_tests[index];
+
+	if (suite != parallel_current_suite) {
+		if (parallel_current_suite != NULL) {
+			pcut_report_suite_done(parallel_current_suite);
+		}
+		pcut_report_suite_start(suite);
+		parallel_current_suite = suite;
+	}
+
+	pcut_report_test_start(test);
+	pcut_report_test_done_unparsed(test, outcome, unparsed_output,
+		unparsed_output_size);
+
+	if (outcome != PCUT_OUTCOME_PASS) {
+		parallel_ret_code = PCUT_OUTCOME_FAIL;
+	}
+}
+
+/** Run tests of all suites (or of a single suite) in parallel.
+ *
+ * @param first First item of the list.
+ * @param only_suite Suite to run or NULL to run all suites.
+ * @param prog_path Path to the current binary.
+ * @param ret_code Where to store the return code.
+ * @return Whether the tests were run (non-zero) or the caller needs to
+ *	run them one by one.
+ */
+static int run_parallel(pcut_item_t *first, pcut_item_t *only_suite,
+		const char *prog_path, int *ret_code) {
+	pcut_item_t *suite = NULL;
+	pcut_item_t *it;
+	int total = pcut_count_tests(first);
+	int count = 0;
+	int rc;
+
+	if (total == 0) {
+		return 0;
+	}
+
+	parallel_suites = malloc(sizeof(pcut_item_t *) * total);
+	parallel_tests = malloc(sizeof(pcut_item_t *) * total);
+	if ((parallel_suites == NULL) || (parallel_tests == NULL)) {
+		free(parallel_suites);
+		free(parallel_tests);
+		return 0;
+	}
+
+	for (it = first; it != NULL; it = pcut_get_real_next(it)) {
+		if (it->kind == PCUT_KIND_TESTSUITE) {
+			suite = it;
+		} else if ((it->kind == PCUT_KIND_TEST) && (suite != NULL) &&
+		    ((only_suite == NULL) || (suite == only_suite))) {
+			parallel_suites[count] = suite;
+			parallel_tests[count] = it;
+			count++;
+		}
+	}
+
+	parallel_current_suite = NULL;
+	parallel_ret_code = PCUT_OUTCOME_PASS;
+
+	rc = pcut_run_tests_parallel(prog_path, parallel_tests, count,
+		pcut_parallel_jobs, report_parallel_result);
+	if (rc == PCUT_OUTCOME_PASS) {
+		if (parallel_current_suite != NULL) {
+			pcut_report_suite_done(parallel_current_suite);
+		}
+		*ret_code = parallel_ret_code;
+	}
+
+	free(parallel_suites);
+	free(parallel_tests);
+
+	return rc == PCUT_OUTCOME_PASS;
+}
+
+#endif
+
 /** Add direct pointers to set-up/tear-down functions to a suites.
  *
  * At start-up, set-up and tear-down functions are scattered in the
@@ -222,6 +340,9 @@ int pcut_main(pcut_item_t *last, int argc, char *argv[]) {
 		for (i = 1; i < argc; i++) {
 			pcut_is_arg_with_number(argv[i], "-s", &run_only_suite);
 			pcut_is_arg_with_number(argv[i], "-t", &run_only_test);
+			pcut_is_arg_with_number(argv[i], "-j", &pcut_parallel_jobs);
+			pcut_is_arg_with_number(argv[i], "-b", &pcut_bench_iterations);
+			pcut_is_arg_with_number(argv[i], "-w", &pcut_slow_threshold);
 			if (pcut_str_equals(argv[i], "-l")) {
 				pcut_print_tests(items);
 				return PCUT_OUTCOME_PASS;
@@ -229,6 +350,9 @@ int pcut_main(pcut_item_t *last, int argc, char *argv[]) {
 			if (pcut_str_equals(argv[i], "-x")) {
 				pcut_report_register_handler(&pcut_report_xml);
 			}
+			if (pcut_str_equals(argv[i], "-T")) {
+				pcut_report_times = 1;
+			}
 #ifndef PCUT_NO_LONG_JUMP
 			if (pcut_str_equals(argv[i], "-u")) {
 				pcut_run_mode = PCUT_RUN_MODE_SINGLE;
@@ -237,6 +361,15 @@ int pcut_main(pcut_item_t *last, int argc, char *argv[]) {
 		}
 	}
 
+	/*
+	 * Slow tests are flagged only on request to keep the output
+	 * reproducible.
+	 */
+	if (pcut_slow_threshold < 0) {
+		pcut_slow_threshold = pcut_report_times ?
+			PCUT_DEFAULT_SLOW_THRESHOLD : 0;
+	}
+
 	setvbuf(stdout, NULL, _IONBF, 0);
 	set_setup_teardown_callbacks(items);
 
@@ -264,6 +397,14 @@ int pcut_main(pcut_item_t *last, int argc, char *argv[]) {
 			return PCUT_OUTCOME_BAD_INVOCATION;
 		}
 
+#ifdef PCUT_HAVE_PARALLEL
+		if ((pcut_run_mode == PCUT_RUN_MODE_FORKING) &&
+		    (pcut_parallel_jobs > 1) &&
+		    run_parallel(items, suite, argv[0], &rc)) {
+			return PCUT_OUTCOME_PASS;
+		}
+#endif
+
 		run_suite(suite, NULL, argv[0]);
 		return PCUT_OUTCOME_PASS;
 	}
@@ -293,6 +434,15 @@ int pcut_main(pcut_item_t *last, int argc, char *argv[]) {
 
 	rc = PCUT_OUTCOME_PASS;
 
+#ifdef PCUT_HAVE_PARALLEL
+	if ((pcut_run_mode == PCUT_RUN_MODE_FORKING) &&
+	    (pcut_parallel_jobs > 1) &&
+	    run_parallel(items, NULL, argv[0], &rc)) {
+		pcut_report_done();
+		return rc;
+	}
+#endif
+
 	it = items;
 	while (it != NULL) {
 		if (it->kind == PCUT_KIND_TESTSUITE) {
@@ -56,7 +56,7 @@
 #include <process.h>
 
 #define FORMAT_COMMAND(buffer, buffer_size, self_path, test_id, temp_file) \
-	pcut_snprintf(buffer, buffer_size, "\"\"%s\" -t%d >%s\"", self_path, test_id, temp_file)
+	pcut_snprintf(buffer, buffer_size, "\"\"%s\" -t%d -b%d >%s\"", self_path, test_id, pcut_bench_iterations, temp_file)
 #define FORMAT_TEMP_FILENAME(buffer, buffer_size) \
 	pcut_snprintf(buffer, buffer_size, "pcut_%d.tmp", _getpid())
 
@@ -64,7 +64,7 @@
 #include <unistd.h>
 
 #define FORMAT_COMMAND(buffer, buffer_size, self_path, test_id, temp_file) \
-	pcut_snprintf(buffer, buffer_size, "%s -t%d &>%s", self_path, test_id, temp_file)
+	pcut_snprintf(buffer, buffer_size, "%s -t%d -b%d &>%s", self_path, test_id, pcut_bench_iterations, temp_file)
 #define FORMAT_TEMP_FILENAME(buffer, buffer_size) \
 	pcut_snprintf(buffer, buffer_size, "pcut_%d.tmp", getpid())
 
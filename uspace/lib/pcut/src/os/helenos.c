@@ -38,6 +38,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <task.h>
+#include <time.h>
 #include <fibril_synch.h>
 #include <vfs/vfs.h>
 #include "../internal.h"
@@ -107,88 +108,122 @@ static void before_test_start(pcut_item_t *test) {
 	memset(extra_output_buffer, 0, OUTPUT_BUFFER_SIZE);
 }
 
-/** Mutex guard for forced_termination_cv. */
-static FIBRIL_MUTEX_INITIALIZE(forced_termination_mutex);
-
-/** Condition-variable for checking whether test timed-out. */
-static FIBRIL_CONDVAR_INITIALIZE(forced_termination_cv);
-
-/** Spawned task id. */
-static task_id_t test_task_id;
-
-/** Flag whether test is still running.
- *
- * This flag is used when checking whether test timed-out.
- */
-static int test_running;
+/** Test task watched for a time-out. */
+typedef struct {
+	/** Mutex guard for the structure. */
+	fibril_mutex_t mutex;
+	/** Condition-variable for checking whether test timed-out. */
+	fibril_condvar_t cv;
+	/** The test being run. */
+	pcut_item_t *test;
+	/** Spawned task id. */
+	task_id_t task_id;
+	/** Flag whether test is still running. */
+	int running;
+	/** Flag whether the time-out fibril has not finished yet. */
+	int watching;
+} test_task_t;
 
 /** Main fibril for checking whether test timed-out.
  *
- * @param arg Test that is currently running (pcut_item_t *).
+ * @param arg Test task that is currently running (test_task_t *).
  * @return EOK Always.
  */
 static int test_timeout_handler_fibril(void *arg) {
-	pcut_item_t *test = arg;
-	int timeout_sec = pcut_get_test_timeout(test);
+	test_task_t *task = arg;
+	int timeout_sec = pcut_get_test_timeout(task->test);
 	usec_t timeout_us = SEC2USEC(timeout_sec);
 
-	fibril_mutex_lock(&forced_termination_mutex);
-	if (!test_running) {
+	fibril_mutex_lock(&task->mutex);
+	if (!task->running) {
 		goto leave_no_kill;
 	}
-	errno_t rc = fibril_condvar_wait_timeout(&forced_termination_cv,
-		&forced_termination_mutex, timeout_us);
+	errno_t rc = fibril_condvar_wait_timeout(&task->cv,
+		&task->mutex, timeout_us);
 	if (rc == ETIMEOUT) {
-		task_kill(test_task_id);
+		task_kill(task->task_id);
 	}
 leave_no_kill:
-	fibril_mutex_unlock(&forced_termination_mutex);
+	task->watching = 0;
+	fibril_condvar_broadcast(&task->cv);
+	fibril_mutex_unlock(&task->mutex);
 	return EOK;
 }
 
-/** Run the test as a new task and report the result.
+/** Store error message into output buffer of a test.
+ *
+ * The message is encoded the same way as pcut_print_fail_message()
+ * does it.
+ *
+ * @param output Output buffer (OUTPUT_BUFFER_SIZE bytes).
+ * @param msg The message.
+ */
+static void set_output_error(char *output, const char *msg) {
+	memset(output, 0, OUTPUT_BUFFER_SIZE);
+	snprintf(output + 3, OUTPUT_BUFFER_SIZE - 4, "%s\n", msg);
+}
+
+/** Run the test as a new task.
+ *
+ * This function can be executed by several fibrils at once.
  *
  * @param self_path Path to itself, that is to current binary.
  * @param test Test to be run.
+ * @param output Buffer for output of the test (OUTPUT_BUFFER_SIZE bytes).
+ * @return Test outcome code.
  */
-int pcut_run_test_forking(const char *self_path, pcut_item_t *test) {
-	before_test_start(test);
+static int run_test_task(const char *self_path, pcut_item_t *test,
+    char *output) {
+	memset(output, 0, OUTPUT_BUFFER_SIZE);
 
 	char tempfile_name[PCUT_TEMP_FILENAME_BUFFER_SIZE];
-	snprintf(tempfile_name, PCUT_TEMP_FILENAME_BUFFER_SIZE - 1, "pcut_%lld.tmp", (unsigned long long) task_get_id());
+	snprintf(tempfile_name, PCUT_TEMP_FILENAME_BUFFER_SIZE - 1,
+	    "pcut_%lld_%d.tmp", (unsigned long long) task_get_id(), test->id);
 	int tempfile;
 	errno_t rc = vfs_lookup_open(tempfile_name, WALK_REGULAR | WALK_MAY_CREATE, MODE_READ | MODE_WRITE, &tempfile);
 	if (rc != EOK) {
-		pcut_report_test_done(test, PCUT_OUTCOME_INTERNAL_ERROR, "Failed to create temporary file.", NULL, NULL);
+		set_output_error(output, "Failed to create temporary file.");
 		return PCUT_OUTCOME_INTERNAL_ERROR;
 	}
 
 	char test_number_argument[MAX_TEST_NUMBER_WIDTH];
 	snprintf(test_number_argument, MAX_TEST_NUMBER_WIDTH, "-t%d", test->id);
 
-	const char *const arguments[3] = {
+	char iterations_argument[MAX_TEST_NUMBER_WIDTH];
+	snprintf(iterations_argument, MAX_TEST_NUMBER_WIDTH, "-b%d",
+	    pcut_bench_iterations);
+
+	const char *const arguments[4] = {
 		self_path,
 		test_number_argument,
+		iterations_argument,
 		NULL
 	};
 
 	int status = PCUT_OUTCOME_PASS;
 
+	test_task_t task;
+	fibril_mutex_initialize(&task.mutex);
+	fibril_condvar_initialize(&task.cv);
+	task.test = test;
+
 	task_wait_t test_task_wait;
-	rc = task_spawnvf(&test_task_id, &test_task_wait, self_path, arguments,
+	rc = task_spawnvf(&task.task_id, &test_task_wait, self_path, arguments,
 	    fileno(stdin), tempfile, tempfile);
 	if (rc != EOK) {
 		status = PCUT_OUTCOME_INTERNAL_ERROR;
 		goto leave_close_tempfile;
 	}
 
-	test_running = 1;
+	task.running = 1;
+	task.watching = 0;
 
-	fid_t killer_fibril = fibril_create(test_timeout_handler_fibril, test);
+	fid_t killer_fibril = fibril_create(test_timeout_handler_fibril, &task);
 	if (killer_fibril == 0) {
 		/* FIXME: somehow announce this problem. */
-		task_kill(test_task_id);
+		task_kill(task.task_id);
 	} else {
+		task.watching = 1;
 		fibril_add_ready(killer_fibril);
 	}
 
@@ -197,32 +232,231 @@ int pcut_run_test_forking(const char *self_path, pcut_item_t *test) {
 	rc = task_wait(&test_task_wait, &task_exit, &task_retval);
 	if (rc != EOK) {
 		status = PCUT_OUTCOME_INTERNAL_ERROR;
-		goto leave_close_tempfile;
-	}
-	if (task_exit == TASK_EXIT_UNEXPECTED) {
+	} else if (task_exit == TASK_EXIT_UNEXPECTED) {
 		status = PCUT_OUTCOME_INTERNAL_ERROR;
 	} else {
 		status = task_retval == 0 ? PCUT_OUTCOME_PASS : PCUT_OUTCOME_FAIL;
 	}
 
-	fibril_mutex_lock(&forced_termination_mutex);
-	test_running = 0;
-	fibril_condvar_signal(&forced_termination_cv);
-	fibril_mutex_unlock(&forced_termination_mutex);
+	/* Stop the time-out fibril, it refers to our stack. */
+	fibril_mutex_lock(&task.mutex);
+	task.running = 0;
+	fibril_condvar_broadcast(&task.cv);
+	while (task.watching) {
+		fibril_condvar_wait(&task.cv, &task.mutex);
+	}
+	fibril_mutex_unlock(&task.mutex);
+
+	if (rc != EOK) {
+		goto leave_close_tempfile;
+	}
 
 	aoff64_t pos = 0;
 	size_t nread;
-	vfs_read(tempfile, &pos, extra_output_buffer, OUTPUT_BUFFER_SIZE, &nread);
+	/* Keep the last byte zero to terminate the output. */
+	vfs_read(tempfile, &pos, output, OUTPUT_BUFFER_SIZE - 1, &nread);
 
 leave_close_tempfile:
 	vfs_put(tempfile);
 	vfs_unlink_path(tempfile_name);
 
+	return status;
+}
+
+/** Run the test as a new task and report the result.
+ *
+ * @param self_path Path to itself, that is to current binary.
+ * @param test Test to be run.
+ */
+int pcut_run_test_forking(const char *self_path, pcut_item_t *test) {
+	before_test_start(test);
+
+	int status = run_test_task(self_path, test, extra_output_buffer);
+
 	pcut_report_test_done_unparsed(test, status, extra_output_buffer, OUTPUT_BUFFER_SIZE);
 
 	return status;
 }
 
+/* Parallel execution. */
+
+/** Result of a test run in parallel mode. */
+typedef struct {
+	/** Whether the test completed. */
+	int done;
+	/** Outcome of the test. */
+	int outcome;
+	/** Output of the test (OUTPUT_BUFFER_SIZE bytes or NULL). */
+	char *output;
+} parallel_result_t;
+
+/** Mutex guard for the parallel_* variables. */
+static FIBRIL_MUTEX_INITIALIZE(parallel_mutex);
+
+/** Condition-variable signalled when a test completes or is reported. */
+static FIBRIL_CONDVAR_INITIALIZE(parallel_cv);
+
+/** Path to the current binary. */
+static const char *parallel_self_path;
+
+/** Tests to run. */
+static pcut_item_t **parallel_tests;
+
+/** Results of the tests. */
+static parallel_result_t *parallel_results;
+
+/** Number of tests to run. */
+static int parallel_count;
+
+/** Index of the next test to start. */
+static int parallel_next;
+
+/** Number of tests already reported. */
+static int parallel_reported;
+
+/** How far ahead of the reporting position tests may be started. */
+static int parallel_window;
+
+/** Number of worker fibrils still running. */
+static int parallel_workers;
+
+/** Worker fibril running the tests one after another.
+ *
+ * @param arg Ignored.
+ * @return EOK Always.
+ */
+static int parallel_worker_fibril(void *arg) {
+	PCUT_UNUSED(arg);
+
+	fibril_mutex_lock(&parallel_mutex);
+	while (parallel_next < parallel_count) {
+		/* Do not let completed outputs pile up behind a slow test. */
+		if (parallel_next >= parallel_reported + parallel_window) {
+			fibril_condvar_wait(&parallel_cv, &parallel_mutex);
+			continue;
+		}
+
+		int index = parallel_next++;
+		fibril_mutex_unlock(&parallel_mutex);
+
+		int outcome = PCUT_OUTCOME_INTERNAL_ERROR;
+		char *output = malloc(OUTPUT_BUFFER_SIZE);
+		if (output != NULL) {
+			outcome = run_test_task(parallel_self_path,
+			    parallel_tests[index], output);
+		}
+
+		fibril_mutex_lock(&parallel_mutex);
+		parallel_results[index].outcome = outcome;
+		parallel_results[index].output = output;
+		parallel_results[index].done = 1;
+		fibril_condvar_broadcast(&parallel_cv);
+	}
+
+	parallel_workers--;
+	fibril_condvar_broadcast(&parallel_cv);
+	fibril_mutex_unlock(&parallel_mutex);
+
+	return EOK;
+}
+
+/** Run tests in several tasks at once.
+ *
+ * Results are passed to @p result_func in the order of @p tests.
+ *
+ * @param self_path Path to itself, that is to current binary.
+ * @param tests Tests to be run.
+ * @param count Number of tests.
+ * @param jobs Maximum number of tests running at the same time.
+ * @param result_func Function to report test results.
+ * @return PCUT_OUTCOME_PASS when all tests were run (regardless of
+ *	their outcome).
+ * @retval PCUT_OUTCOME_INTERNAL_ERROR Unable to start, no test was run.
+ */
+int pcut_run_tests_parallel(const char *self_path, pcut_item_t **tests,
+    int count, int jobs, pcut_parallel_result_func_t result_func) {
+	static char no_output[1];
+
+	parallel_results = calloc(count, sizeof(parallel_result_t));
+	if (parallel_results == NULL) {
+		return PCUT_OUTCOME_INTERNAL_ERROR;
+	}
+
+	parallel_self_path = self_path;
+	parallel_tests = tests;
+	parallel_count = count;
+	parallel_next = 0;
+	parallel_reported = 0;
+	parallel_window = 4 * jobs;
+	parallel_workers = 0;
+
+	if (jobs > count) {
+		jobs = count;
+	}
+
+	fibril_mutex_lock(&parallel_mutex);
+
+	for (int i = 0; i < jobs; i++) {
+		fid_t worker = fibril_create(parallel_worker_fibril, NULL);
+		if (worker == 0) {
+			break;
+		}
+		parallel_workers++;
+		fibril_add_ready(worker);
+	}
+
+	if (parallel_workers == 0) {
+		fibril_mutex_unlock(&parallel_mutex);
+		free(parallel_results);
+		return PCUT_OUTCOME_INTERNAL_ERROR;
+	}
+
+	while (parallel_reported < count) {
+		parallel_result_t *result = &parallel_results[parallel_reported];
+		if (!result->done) {
+			fibril_condvar_wait(&parallel_cv, &parallel_mutex);
+			continue;
+		}
+
+		fibril_mutex_unlock(&parallel_mutex);
+
+		if (result->output != NULL) {
+			result_func(parallel_reported, result->outcome,
+			    result->output, OUTPUT_BUFFER_SIZE);
+			free(result->output);
+		} else {
+			result_func(parallel_reported, result->outcome,
+			    no_output, sizeof(no_output));
+		}
+
+		fibril_mutex_lock(&parallel_mutex);
+		parallel_reported++;
+		fibril_condvar_broadcast(&parallel_cv);
+	}
+
+	while (parallel_workers > 0) {
+		fibril_condvar_wait(&parallel_cv, &parallel_mutex);
+	}
+
+	fibril_mutex_unlock(&parallel_mutex);
+
+	free(parallel_results);
+	parallel_results = NULL;
+
+	return PCUT_OUTCOME_PASS;
+}
+
+/** Get current wall-clock time.
+ *
+ * @return System uptime in microseconds.
+ */
+long long pcut_get_wall_time(void) {
+	struct timespec ts;
+
+	getuptime(&ts);
+	return SEC2USEC(ts.tv_sec) + NSEC2USEC(ts.tv_nsec);
+}
+
 void pcut_hook_before_test(pcut_item_t *test) {
 	PCUT_UNUSED(test);
 
@@ -33,6 +33,7 @@
 
 #pragma warning(push, 0)
 #include <string.h>
+#include <time.h>
 #pragma warning(pop)
 
 #include "../internal.h"
@@ -66,3 +67,14 @@ void pcut_str_error(int error, char *buffer, int size) {
 	/* Ensure correct termination. */
 	buffer[size - 1] = 0;
 }
+
+long long pcut_get_wall_time(void) {
+#if defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+		return (long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+	}
+#endif
+	/* Standard C offers only a second resolution. */
+	return (long long) time(NULL) * 1000000;
+}
@@ -193,7 +193,11 @@ int pcut_run_test_forking(const char *self_path, pcut_item_t *test) {
 	alarm(pcut_get_test_timeout(test));
 
 	stderr_size = read_all(link_stderr[0], extra_output_buffer, OUTPUT_BUFFER_SIZE - 1);
-	read_all(link_stdout[0], extra_output_buffer, OUTPUT_BUFFER_SIZE - 1 - stderr_size);
+	if (stderr_size > 0) {
+		/* Keep the zero byte terminating the stderr part. */
+		stderr_size++;
+	}
+	read_all(link_stdout[0], extra_output_buffer + stderr_size, OUTPUT_BUFFER_SIZE - 1 - stderr_size);
 
 	wait(&status);
 	alarm(0);
@@ -218,7 +218,7 @@ int pcut_run_test_forking(const char *self_path, pcut_item_t *test) {
 
 	/* Format the command line. */
 	pcut_snprintf(command, PCUT_COMMAND_LINE_BUFFER_SIZE - 1,
-		"\"%s\" -t%d", self_path, test->id);
+		"\"%s\" -t%d -b%d", self_path, test->id, pcut_bench_iterations);
 
 	/* Run the process. */
 	okay = CreateProcess(NULL, command, NULL, NULL, TRUE, 0, NULL, NULL,
@@ -84,6 +84,20 @@ void pcut_print_fail_message(const char *msg) {
 	printf("%c%c%c%s\n%c", 0, 0, 0, msg, 0);
 }
 
+/** Print running time of a test.
+ *
+ * The time is printed with a special 5-zero-byte prefix to be later
+ * parsed when reporting the results from a different process (the
+ * parser may swallow one zero byte as a terminator of preceding output).
+ *
+ * @param time Measured time.
+ */
+void pcut_print_time_message(const pcut_test_time_t *time) {
+	printf("%c%c%c%c%c%d %lld %lld %lld %lld %lld\n%c", 0, 0, 0, 0, 0,
+		time->iterations, time->wall_mean, time->wall_min,
+		time->wall_max, time->wall_stddev, time->cpu_mean, 0);
+}
+
 /** Size of buffer for storing error messages or extra test output. */
 #define BUFFER_SIZE 4096
 
@@ -93,6 +107,49 @@ static char buffer_for_extra_output[BUFFER_SIZE];
 /** Buffer for assertion and other error messages. */
 static char buffer_for_error_messages[BUFFER_SIZE];
 
+/** Running time of a test parsed from its output. */
+static pcut_test_time_t parsed_time;
+
+/** Parse a (possibly negative) decimal number.
+ *
+ * @param str Pointer to the string, advanced past the number.
+ * @return Parsed number.
+ */
+static long long parse_number(const char **str) {
+	const char *it = *str;
+	long long value = 0;
+	int negative = 0;
+
+	while (*it == ' ') {
+		it++;
+	}
+	if (*it == '-') {
+		negative = 1;
+		it++;
+	}
+	while ((*it >= '0') && (*it <= '9')) {
+		value = value * 10 + (*it - '0');
+		it++;
+	}
+
+	*str = it;
+	return negative ? -value : value;
+}
+
+/** Parse running time printed by pcut_print_time_message().
+ *
+ * @param message The message (without the zero-byte prefix).
+ * @param time Where to store the parsed time.
+ */
+static void parse_time_message(const char *message, pcut_test_time_t *time) {
+	time->iterations = (int) parse_number(&message);
+	time->wall_mean = parse_number(&message);
+	time->wall_min = parse_number(&message);
+	time->wall_max = parse_number(&message);
+	time->wall_stddev = parse_number(&message);
+	time->cpu_mean = parse_number(&message);
+}
+
 /** Parse output of a single test.
  *
  * @param full_output Full unparsed output.
@@ -107,6 +164,7 @@ static void parse_command_output(const char *full_output, size_t full_output_siz
 		char *error_buffer, size_t error_buffer_size) {
 	memset(stdio_buffer, 0, stdio_buffer_size);
 	memset(error_buffer, 0, error_buffer_size);
+	memset(&parsed_time, 0, sizeof(parsed_time));
 
 	/* Ensure that we do not read past the full_output. */
 	if (full_output[full_output_size - 1] != 0) {
@@ -131,7 +189,10 @@ static void parse_command_output(const char *full_output, size_t full_output_siz
 		/* Determine the length of the text after the zeros. */
 		message_length = pcut_str_size(full_output);
 
-		if (cont_zeros_count < 2) {
+		if (cont_zeros_count >= 4) {
+			/* Running time of the test. */
+			parse_time_message(full_output, &parsed_time);
+		} else if (cont_zeros_count < 2) {
 			/* Okay, standard I/O. */
 			if (message_length > stdio_buffer_size) {
 				/* TODO: handle gracefully */
@@ -225,9 +286,24 @@ void pcut_report_test_done_unparsed(pcut_item_t *test, int outcome,
 			buffer_for_extra_output, BUFFER_SIZE,
 			buffer_for_error_messages, BUFFER_SIZE);
 
+	if (parsed_time.iterations > 0) {
+		pcut_report_test_time(test, &parsed_time);
+	}
+
 	pcut_report_test_done(test, outcome, buffer_for_error_messages, NULL, buffer_for_extra_output);
 }
 
+/** Report running time of a test.
+ *
+ * This is reported right before the test completion is reported.
+ *
+ * @param test Test that is about to finish.
+ * @param time Measured time.
+ */
+void pcut_report_test_time(pcut_item_t *test, const pcut_test_time_t *time) {
+	REPORT_CALL(test_time, test, time);
+}
+
 /** Close the report.
  *
  */
@@ -59,6 +59,29 @@ static int failed_tests_in_suite;
 /** Comma-separated list of failed test names. */
 static char *failed_test_names;
 
+/** Comma-separated list of slow test names. */
+static char *slow_test_names;
+
+/** Running time of the test that is being reported. */
+static pcut_test_time_t test_time;
+
+/** Append test name to a comma-separated list.
+ *
+ * @param names Pointer to the list (NULL when empty).
+ * @param test_name Name to append.
+ */
+static void append_test_name(char **names, const char *test_name) {
+	if (*names == NULL) {
+		*names = strdup(test_name);
+	} else {
+		char *fs = NULL;
+		if (asprintf(&fs, "%s, %s", *names, test_name) >= 0) {
+			free(*names);
+			*names = fs;
+		}
+	}
+}
+
 /** Initialize the TAP output.
  *
  * @param all_items Start of the list with all items.
@@ -109,6 +132,66 @@ static void tap_test_start(pcut_item_t *test) {
 	test_counter++;
 }
 
+/** Remember running time of a test.
+ *
+ * It is printed once the test completes.
+ *
+ * @param test Test that is about to finish.
+ * @param time Measured time.
+ */
+static void tap_test_time(pcut_item_t *test, const pcut_test_time_t *time) {
+	PCUT_UNUSED(test);
+
+	test_time = *time;
+}
+
+/** Format time in microseconds as milliseconds.
+ *
+ * @param buffer Buffer to store the result to.
+ * @param size Size of @p buffer.
+ * @param usec Time in microseconds.
+ */
+static void format_msec(char *buffer, size_t size, long long usec) {
+	snprintf(buffer, size, "%lld.%03lld ms", usec / 1000, usec % 1000);
+}
+
+/** Print running time of a test as a TAP comment.
+ *
+ * Time of a single run is printed only when requested (to keep the output
+ * reproducible), benchmarks are reported always.
+ *
+ * @param test_name Name of the test.
+ */
+static void print_test_time(const char *test_name) {
+	char mean[32], cpu[32], min[32], max[32], stddev[32];
+
+	format_msec(mean, sizeof(mean), test_time.wall_mean);
+	if (test_time.cpu_mean >= 0) {
+		format_msec(cpu, sizeof(cpu), test_time.cpu_mean);
+	} else {
+		snprintf(cpu, sizeof(cpu), "unknown");
+	}
+
+	if (test_time.iterations == 1) {
+		if (pcut_report_times) {
+			printf("# time: %s (cpu %s)\n", mean, cpu);
+		}
+	} else {
+		format_msec(min, sizeof(min), test_time.wall_min);
+		format_msec(max, sizeof(max), test_time.wall_max);
+		format_msec(stddev, sizeof(stddev), test_time.wall_stddev);
+		printf("# benchmark: %d iterations, mean %s (cpu %s), "
+			"min %s, max %s, stddev %s\n", test_time.iterations,
+			mean, cpu, min, max, stddev);
+	}
+
+	if ((pcut_slow_threshold > 0) &&
+	    (test_time.wall_mean >= (long long) pcut_slow_threshold * 1000)) {
+		printf("# slow: exceeds %d ms\n", pcut_slow_threshold);
+		append_test_name(&slow_test_names, test_name);
+	}
+}
+
 /** Print the buffer, prefix new line with a given string.
  *
  * @param message Message to print.
@@ -172,17 +255,13 @@ static void tap_test_done(pcut_item_t *test, int outcome,
 
 	print_by_lines(extra_output, "# stdio: ");
 
+	if (test_time.iterations > 0) {
+		print_test_time(test_name);
+		test_time.iterations = 0;
+	}
+
 	if (outcome != PCUT_OUTCOME_PASS) {
-		if (failed_test_names == NULL) {
-			failed_test_names = strdup(test_name);
-		} else {
-			char *fs = NULL;
-			if (asprintf(&fs, "%s, %s",
-			    failed_test_names, test_name) >= 0) {
-				free(failed_test_names);
-				failed_test_names = fs;
-			}
-		}
+		append_test_name(&failed_test_names, test_name);
 	}
 }
 
@@ -194,11 +273,15 @@ static void tap_done(void) {
 		printf("#> Done: %d of %d tests failed.\n", failed_test_counter, test_counter);
 		printf("#> Failed tests: %s\n", failed_test_names);
 	}
+	if (slow_test_names != NULL) {
+		printf("#> Slow tests: %s\n", slow_test_names);
+	}
 }
 
 
 pcut_report_ops_t pcut_report_tap = {
 	tap_init, tap_done,
 	tap_suite_start, tap_suite_done,
-	tap_test_start, tap_test_done
+	tap_test_start, tap_test_done,
+	tap_test_time
 };
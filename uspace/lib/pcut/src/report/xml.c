@@ -54,6 +54,9 @@ static int tests_in_suite;
 /** Counter of failed tests in current suite. */
 static int failed_tests_in_suite;
 
+/** Running time of the test that is being reported. */
+static pcut_test_time_t test_time;
+
 /** Initialize the XML output.
  *
  * @param all_items Start of the list with all items.
@@ -99,6 +102,19 @@ static void xml_test_start(pcut_item_t *test) {
 	test_counter++;
 }
 
+/** Remember running time of a test.
+ *
+ * It is printed once the test completes.
+ *
+ * @param test Test that is about to finish.
+ * @param time Measured time.
+ */
+static void xml_test_time(pcut_item_t *test, const pcut_test_time_t *time) {
+	PCUT_UNUSED(test);
+
+	test_time = *time;
+}
+
 /** Print the buffer as a CDATA into given element.
  *
  * @param message Message to print.
@@ -157,8 +173,28 @@ static void xml_test_done(pcut_item_t *test, int outcome,
 		break;
 	}
 
-	printf("\t\t<testcase name=\"%s\" status=\"%s\">\n", test_name,
+	printf("\t\t<testcase name=\"%s\" status=\"%s\"", test_name,
 		status_str);
+	if ((test_time.iterations > 0) && pcut_report_times) {
+		printf(" time-us=\"%lld\"", test_time.wall_mean);
+		if (test_time.cpu_mean >= 0) {
+			printf(" cpu-time-us=\"%lld\"", test_time.cpu_mean);
+		}
+	}
+	if ((test_time.iterations > 0) && (pcut_slow_threshold > 0) &&
+	    (test_time.wall_mean >= (long long) pcut_slow_threshold * 1000)) {
+		printf(" slow=\"yes\"");
+	}
+	printf(">\n");
+
+	if (test_time.iterations > 1) {
+		printf("\t\t\t<benchmark iterations=\"%d\" mean-us=\"%lld\" "
+			"min-us=\"%lld\" max-us=\"%lld\" stddev-us=\"%lld\" />\n",
+			test_time.iterations, test_time.wall_mean,
+			test_time.wall_min, test_time.wall_max,
+			test_time.wall_stddev);
+	}
+	test_time.iterations = 0;
 
 	print_by_lines(error_message, "error-message");
 	print_by_lines(teardown_error_message, "error-message");
@@ -177,5 +213,6 @@ static void xml_done(void) {
 pcut_report_ops_t pcut_report_xml = {
 	xml_init, xml_done,
 	xml_suite_start, xml_suite_done,
-	xml_test_start, xml_test_done
+	xml_test_start, xml_test_done,
+	xml_test_time
 };
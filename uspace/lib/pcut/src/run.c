@@ -39,6 +39,10 @@
 #pragma warning(pop)
 #endif
 
+#pragma warning(push, 0)
+#include <time.h>
+#pragma warning(pop)
+
 #ifndef PCUT_NO_LONG_JUMP
 /** Long-jump buffer. */
 static jmp_buf start_test_jump;
@@ -71,6 +75,36 @@ static pcut_item_t *current_test = NULL;
 /** Pointer to current test suite. */
 static pcut_item_t *current_suite = NULL;
 
+/** Number of measured iterations of the current test. */
+static int time_iterations;
+
+/** Whether an iteration is being measured right now. */
+static int time_measuring;
+
+/** Whether CPU time could be measured for all iterations. */
+static int time_cpu_valid;
+
+/** Wall-clock time when the current iteration started. */
+static long long time_wall_start;
+
+/** CPU time when the current iteration started. */
+static clock_t time_cpu_start;
+
+/** Sum of wall-clock times of all iterations. */
+static long long time_wall_sum;
+
+/** Sum of squares of wall-clock times of all iterations. */
+static long long time_wall_sum_sq;
+
+/** Shortest iteration. */
+static long long time_wall_min;
+
+/** Longest iteration. */
+static long long time_wall_max;
+
+/** Sum of CPU times of all iterations. */
+static long long time_cpu_sum;
+
 /** A NULL-like suite. */
 static pcut_item_t default_suite;
 static int default_suite_initialized = 0;
@@ -104,6 +138,108 @@ static pcut_item_t *pcut_find_parent_suite(pcut_item_t *it) {
 	return &default_suite;
 }
 
+/** Forget measurements of a previous test. */
+static void time_reset(void) {
+	time_iterations = 0;
+	time_measuring = 0;
+	time_cpu_valid = 1;
+	time_wall_sum = 0;
+	time_wall_sum_sq = 0;
+	time_wall_min = 0;
+	time_wall_max = 0;
+	time_cpu_sum = 0;
+}
+
+/** Start measuring one iteration of the current test. */
+static void time_iteration_start(void) {
+	time_measuring = 1;
+	time_cpu_start = clock();
+	time_wall_start = pcut_get_wall_time();
+}
+
+/** Finish measuring one iteration of the current test. */
+static void time_iteration_end(void) {
+	long long wall = pcut_get_wall_time() - time_wall_start;
+	clock_t cpu = clock();
+
+	time_measuring = 0;
+
+	if ((cpu == (clock_t) -1) || (time_cpu_start == (clock_t) -1)) {
+		time_cpu_valid = 0;
+	} else {
+		time_cpu_sum += (long long) (cpu - time_cpu_start) * 1000000 /
+			CLOCKS_PER_SEC;
+	}
+
+	if ((time_iterations == 0) || (wall < time_wall_min)) {
+		time_wall_min = wall;
+	}
+	if ((time_iterations == 0) || (wall > time_wall_max)) {
+		time_wall_max = wall;
+	}
+	time_wall_sum += wall;
+	time_wall_sum_sq += wall * wall;
+	time_iterations++;
+}
+
+/** Compute integer square root.
+ *
+ * @param value Non-negative number.
+ * @return Largest integer whose square does not exceed @p value.
+ */
+static long long isqrt(long long value) {
+	long long x = value;
+	long long y;
+
+	if (value < 2) {
+		return value;
+	}
+
+	y = (x + 1) / 2;
+	while (y < x) {
+		x = y;
+		y = (x + value / x) / 2;
+	}
+
+	return x;
+}
+
+/** Report running time of the current test.
+ *
+ * In forked mode, the time is printed for the parent process to pick
+ * it up. Nothing is reported twice.
+ */
+static void report_test_time(void) {
+	pcut_test_time_t time;
+	long long variance;
+
+	if (time_measuring) {
+		time_iteration_end();
+	}
+	if (time_iterations == 0) {
+		return;
+	}
+
+	time.iterations = time_iterations;
+	time.wall_mean = time_wall_sum / time_iterations;
+	time.wall_min = time_wall_min;
+	time.wall_max = time_wall_max;
+	variance = (time_iterations * time_wall_sum_sq
+		- time_wall_sum * time_wall_sum)
+		/ ((long long) time_iterations * time_iterations);
+	time.wall_stddev = isqrt(variance > 0 ? variance : 0);
+	time.cpu_mean = time_cpu_valid ? time_cpu_sum / time_iterations : -1;
+
+	time_iterations = 0;
+
+	if (report_test_result) {
+		pcut_report_test_time(current_test, &time);
+	}
+	if (print_test_error) {
+		pcut_print_time_message(&time);
+	}
+}
+
 /** Run a set-up (tear-down) function.
  *
  * @param func Function to run (can be NULL).
@@ -151,6 +287,8 @@ void pcut_failed_assertion(const char *message) {
 		pcut_print_fail_message(message);
 	}
 
+	report_test_time();
+
 	if (execute_teardown_on_failure) {
 		execute_teardown_on_failure = 0;
 		prev_message = message;
@@ -179,6 +317,9 @@ void pcut_failed_assertion(const char *message) {
  * @return Error status (zero means success).
  */
 static int run_test(pcut_item_t *test) {
+	int iterations = pcut_bench_iterations > 1 ? pcut_bench_iterations : 1;
+	int i;
+
 	/*
 	 * Set here as the returning point in case of test failure.
 	 * If we get here, it means something failed during the
@@ -200,29 +341,43 @@ static int run_test(pcut_item_t *test) {
 
 	pcut_hook_before_test(test);
 
-	/*
-	 * If anything goes wrong, execute the tear-down function
-	 * as well.
-	 */
-	execute_teardown_on_failure = 1;
+	time_reset();
 
 	/*
-	 * Run the set-up function.
+	 * In benchmark mode, the whole test (including set-up and
+	 * tear-down) is repeated several times.
 	 */
-	run_setup_teardown(current_suite->setup_func);
+	for (i = 0; i < iterations; i++) {
+		time_iteration_start();
+
+		/*
+		 * If anything goes wrong, execute the tear-down function
+		 * as well.
+		 */
+		execute_teardown_on_failure = 1;
+
+		/*
+		 * Run the set-up function.
+		 */
+		run_setup_teardown(current_suite->setup_func);
+
+		/*
+		 * The setup function was performed, it is time to run
+		 * the actual test.
+		 */
+		test->test_func();
+
+		/*
+		 * Finally, run the tear-down function. We need to clear
+		 * the flag to prevent endless loop.
+		 */
+		execute_teardown_on_failure = 0;
+		run_setup_teardown(current_suite->teardown_func);
 
-	/*
-	 * The setup function was performed, it is time to run
-	 * the actual test.
-	 */
-	test->test_func();
+		time_iteration_end();
+	}
 
-	/*
-	 * Finally, run the tear-down function. We need to clear
-	 * the flag to prevent endless loop.
-	 */
-	execute_teardown_on_failure = 0;
-	run_setup_teardown(current_suite->teardown_func);
+	report_test_time();
 
 	/*
 	 * If we got here, it means everything went well with
@@ -283,6 +438,9 @@ int pcut_run_test_single(pcut_item_t *test) {
 }
 
 /** Tells time-out length for a given test.
+ *
+ * In benchmark mode, the time-out is multiplied by the number of
+ * iterations.
  *
  * @param test Test for which the time-out is questioned.
  * @return Timeout in seconds.
@@ -299,5 +457,9 @@ int pcut_get_test_timeout(pcut_item_t *test) {
 		extras++;
 	}
 
+	if (pcut_bench_iterations > 1) {
+		timeout *= pcut_bench_iterations;
+	}
+
 	return timeout;
 }
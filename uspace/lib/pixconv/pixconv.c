@@ -38,6 +38,11 @@
  * the names of the visuals and the format created by these functions.
  * The functions use the so called network bit order (i.e. big endian)
  * with respect to their names.
+ *
+ * The row variants convert a whole run of pixels. For the 32, 24 and
+ * 16-bit visuals they work on four or eight pixels at a time using the
+ * compiler's generic vector types, which are lowered to SSE2 or NEON
+ * where available and to plain integer code elsewhere.
  */
 
 #include <byteorder.h>
@@ -283,5 +288,222 @@ pixel_t gray_8_2pixel(void *src)
 	return (0xff000000 | (val << 16) | (val << 8) | (val));
 }
 
+/** Four pixels */
+typedef uint32_t pixconv_vec4_t __attribute__((vector_size(16), aligned(4),
+    may_alias));
+
+/** Eight 16-bit visual pixels */
+typedef uint16_t pixconv_vec8_t __attribute__((vector_size(16), aligned(2),
+    may_alias));
+
+/** Sixteen bytes */
+typedef uint8_t pixconv_vec16_t __attribute__((vector_size(16), aligned(1),
+    may_alias));
+
+#ifdef __LE__
+
+/** Byte offsets of color channels within a pixel in memory */
+#define PIXCONV_R  2
+#define PIXCONV_G  1
+#define PIXCONV_B  0
+
+static inline pixconv_vec4_t pixconv_vec4_host2be(pixconv_vec4_t v)
+{
+	return (v << 24) | ((v & 0xff00) << 8) | ((v >> 8) & 0xff00) |
+	    (v >> 24);
+}
+
+static inline pixconv_vec8_t pixconv_vec8_host2be(pixconv_vec8_t v)
+{
+	return (v << 8) | (v >> 8);
+}
+
+static inline pixconv_vec8_t pixconv_vec8_host2le(pixconv_vec8_t v)
+{
+	return v;
+}
+
+/** Pack low halves of eight 32-bit lanes into 16-bit lanes */
+static inline pixconv_vec8_t pixconv_vec4_pack(pixconv_vec4_t lo,
+    pixconv_vec4_t hi)
+{
+	return __builtin_shuffle((pixconv_vec8_t) lo, (pixconv_vec8_t) hi,
+	    (pixconv_vec8_t) { 0, 2, 4, 6, 8, 10, 12, 14 });
+}
+
+#else
+
+/** Byte offsets of color channels within a pixel in memory */
+#define PIXCONV_R  1
+#define PIXCONV_G  2
+#define PIXCONV_B  3
+
+static inline pixconv_vec4_t pixconv_vec4_host2be(pixconv_vec4_t v)
+{
+	return v;
+}
+
+static inline pixconv_vec8_t pixconv_vec8_host2be(pixconv_vec8_t v)
+{
+	return v;
+}
+
+static inline pixconv_vec8_t pixconv_vec8_host2le(pixconv_vec8_t v)
+{
+	return (v << 8) | (v >> 8);
+}
+
+/** Pack low halves of eight 32-bit lanes into 16-bit lanes */
+static inline pixconv_vec8_t pixconv_vec4_pack(pixconv_vec4_t lo,
+    pixconv_vec4_t hi)
+{
+	return __builtin_shuffle((pixconv_vec8_t) lo, (pixconv_vec8_t) hi,
+	    (pixconv_vec8_t) { 1, 3, 5, 7, 9, 11, 13, 15 });
+}
+
+#endif
+
+/** Define row conversion to a 32-bit visual.
+ *
+ * @param visual Name of the visual
+ * @param expr Value of the visual pixel computed from @c pix in network
+ *             bit order, evaluated on four pixels at a time
+ */
+#define PIXCONV_ROW_32(visual, expr) \
+	void pixel2##visual##_row(void *dst, const pixel_t *src, size_t cnt) \
+	{ \
+		uint32_t *d = (uint32_t *) dst; \
+		pixconv_vec4_t pix; \
+		size_t i; \
+		\
+		for (i = 0; i + 4 <= cnt; i += 4) { \
+			pix = *(const pixconv_vec4_t *) (src + i); \
+			*(pixconv_vec4_t *) (d + i) = \
+			    pixconv_vec4_host2be(expr); \
+		} \
+		\
+		for (; i < cnt; i++) \
+			pixel2##visual(d + i, src[i]); \
+	}
+
+/** Define row conversion to a 16-bit visual.
+ *
+ * @param visual Name of the visual
+ * @param order Byte order of the visual (@c le or @c be)
+ * @param expr Value of the visual pixel computed from @c pix, evaluated
+ *             on four pixels at a time
+ */
+#define PIXCONV_ROW_16(visual, order, expr) \
+	void pixel2##visual##_row(void *dst, const pixel_t *src, size_t cnt) \
+	{ \
+		uint16_t *d = (uint16_t *) dst; \
+		pixconv_vec4_t pix; \
+		pixconv_vec4_t lo; \
+		pixconv_vec8_t v; \
+		size_t i; \
+		\
+		for (i = 0; i + 8 <= cnt; i += 8) { \
+			pix = *(const pixconv_vec4_t *) (src + i); \
+			lo = (expr); \
+			pix = *(const pixconv_vec4_t *) (src + i + 4); \
+			v = pixconv_vec4_pack(lo, (expr)); \
+			*(pixconv_vec8_t *) (d + i) = \
+			    pixconv_vec8_host2##order(v); \
+		} \
+		\
+		for (; i < cnt; i++) \
+			pixel2##visual(d + i, src[i]); \
+	}
+
+/** Define row conversion to a visual without a vectorized path.
+ *
+ * @param visual Name of the visual
+ * @param bytes Bytes per visual pixel
+ */
+#define PIXCONV_ROW(visual, bytes) \
+	void pixel2##visual##_row(void *dst, const pixel_t *src, size_t cnt) \
+	{ \
+		uint8_t *d = (uint8_t *) dst; \
+		size_t i; \
+		\
+		for (i = 0; i < cnt; i++) \
+			pixel2##visual(d + i * (bytes), src[i]); \
+	}
+
+PIXCONV_ROW_32(argb_8888,
+    (ALPHA(pix) << 24) | (RED(pix) << 16) | (GREEN(pix) << 8) | (BLUE(pix)))
+PIXCONV_ROW_32(abgr_8888,
+    (ALPHA(pix) << 24) | (BLUE(pix) << 16) | (GREEN(pix) << 8) | (RED(pix)))
+PIXCONV_ROW_32(rgba_8888,
+    (RED(pix) << 24) | (GREEN(pix) << 16) | (BLUE(pix) << 8) | (ALPHA(pix)))
+PIXCONV_ROW_32(bgra_8888,
+    (BLUE(pix) << 24) | (GREEN(pix) << 16) | (RED(pix) << 8) | (ALPHA(pix)))
+PIXCONV_ROW_32(rgb_0888,
+    (RED(pix) << 16) | (GREEN(pix) << 8) | (BLUE(pix)))
+PIXCONV_ROW_32(bgr_0888,
+    (BLUE(pix) << 16) | (GREEN(pix) << 8) | (RED(pix)))
+PIXCONV_ROW_32(rgb_8880,
+    (RED(pix) << 24) | (GREEN(pix) << 16) | (BLUE(pix) << 8))
+PIXCONV_ROW_32(bgr_8880,
+    (BLUE(pix) << 24) | (GREEN(pix) << 16) | (RED(pix) << 8))
+
+PIXCONV_ROW_16(rgb_555_be, be, (NARROW(RED(pix), 5) << 10) |
+    (NARROW(GREEN(pix), 5) << 5) | (NARROW(BLUE(pix), 5)))
+PIXCONV_ROW_16(rgb_555_le, le, (NARROW(RED(pix), 5) << 10) |
+    (NARROW(GREEN(pix), 5) << 5) | (NARROW(BLUE(pix), 5)))
+PIXCONV_ROW_16(rgb_565_be, be, (NARROW(RED(pix), 5) << 11) |
+    (NARROW(GREEN(pix), 6) << 5) | (NARROW(BLUE(pix), 5)))
+PIXCONV_ROW_16(rgb_565_le, le, (NARROW(RED(pix), 5) << 11) |
+    (NARROW(GREEN(pix), 6) << 5) | (NARROW(BLUE(pix), 5)))
+
+PIXCONV_ROW(bgr_323, 1)
+PIXCONV_ROW(gray_8, 1)
+
+/** Convert row of pixels to a 24-bit visual.
+ *
+ * Four pixels are converted at a time by picking three bytes out of
+ * each. This produces 12 bytes, but all 16 bytes of the vector are
+ * stored, the excess being overwritten by the next iteration. Therefore
+ * the vectorized loop stops while there are still at least six pixels
+ * to go, so that the store never goes past the end of the row.
+ *
+ * @param d Destination
+ * @param src Source pixels
+ * @param cnt Number of pixels
+ * @param mask Byte selection
+ * @param p2v Function to convert a single pixel
+ */
+static inline void pixconv_row_24(uint8_t *d, const pixel_t *src,
+    size_t cnt, pixconv_vec16_t mask, pixel2visual_t p2v)
+{
+	pixconv_vec16_t pix;
+	size_t i;
+
+	for (i = 0; i + 6 <= cnt; i += 4) {
+		pix = *(const pixconv_vec16_t *) (src + i);
+		*(pixconv_vec16_t *) (d + 3 * i) = __builtin_shuffle(pix, mask);
+	}
+
+	for (; i < cnt; i++)
+		p2v(d + 3 * i, src[i]);
+}
+
+/** Byte selection for 24-bit visual with channels @a c0, @a c1, @a c2 */
+#define PIXCONV_MASK_24(c0, c1, c2) \
+	((pixconv_vec16_t) { c0, c1, c2, 4 + c0, 4 + c1, 4 + c2, \
+	    8 + c0, 8 + c1, 8 + c2, 12 + c0, 12 + c1, 12 + c2, 0, 0, 0, 0 })
+
+void pixel2rgb_888_row(void *dst, const pixel_t *src, size_t cnt)
+{
+	pixconv_row_24((uint8_t *) dst, src, cnt,
+	    PIXCONV_MASK_24(PIXCONV_R, PIXCONV_G, PIXCONV_B), pixel2rgb_888);
+}
+
+void pixel2bgr_888_row(void *dst, const pixel_t *src, size_t cnt)
+{
+	pixconv_row_24((uint8_t *) dst, src, cnt,
+	    PIXCONV_MASK_24(PIXCONV_B, PIXCONV_G, PIXCONV_R), pixel2bgr_888);
+}
+
 /** @}
  */
@@ -41,6 +41,10 @@
 #define PATH_MAX 256
 #endif
 
+#define PTHREAD_KEYS_MAX 128
+#define PTHREAD_DESTRUCTOR_ITERATIONS 4
+#define PTHREAD_STACK_MIN 4096
+
 #endif /* POSIX_LIMITS_H_ */
 
 /** @}
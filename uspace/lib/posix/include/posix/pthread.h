@@ -33,9 +33,17 @@
 #define POSIX_PTHREAD_H_
 
 #include <time.h>
+#include <stddef.h>
 #include <_bits/decls.h>
+#include <_bits/__noreturn.h>
 
+#define PTHREAD_MUTEX_NORMAL 0
 #define PTHREAD_MUTEX_RECURSIVE 1
+#define PTHREAD_MUTEX_ERRORCHECK 2
+#define PTHREAD_MUTEX_DEFAULT PTHREAD_MUTEX_NORMAL
+
+#define PTHREAD_CREATE_JOINABLE 0
+#define PTHREAD_CREATE_DETACHED 1
 
 #define PTHREAD_MUTEX_INITIALIZER { 0 }
 
@@ -46,17 +54,26 @@ __C_DECLS_BEGIN;
 typedef void *pthread_t;
 
 typedef struct {
-	int dummy;
+	int detach_state;
+	size_t stack_size;
 } pthread_attr_t;
 
 typedef int pthread_key_t;
 
+/*
+ * The mutex and the condition variable are single words manipulated
+ * atomically, fibrils only go to libc when they need to sleep.
+ * All-zero objects are valid, unlocked/unsignaled ones.
+ */
 typedef struct pthread_mutex {
-	int dummy;
+	int state;
+	int type;
+	unsigned int count;
+	void *owner;
 } pthread_mutex_t;
 
 typedef struct {
-	int dummy;
+	int type;
 } pthread_mutexattr_t;
 
 typedef struct {
@@ -64,7 +81,7 @@ typedef struct {
 } pthread_condattr_t;
 
 typedef struct {
-	int dummy;
+	unsigned int seq;
 } pthread_cond_t;
 
 extern pthread_t pthread_self(void);
@@ -73,9 +90,15 @@ extern int pthread_create(pthread_t *, const pthread_attr_t *,
     void *(*)(void *), void *);
 extern int pthread_join(pthread_t, void **);
 extern int pthread_detach(pthread_t);
+extern __noreturn void pthread_exit(void *);
 
 extern int pthread_attr_init(pthread_attr_t *);
 extern int pthread_attr_destroy(pthread_attr_t *);
+extern int pthread_attr_getdetachstate(const pthread_attr_t *, int *);
+extern int pthread_attr_setdetachstate(pthread_attr_t *, int);
+extern int pthread_attr_getstacksize(const pthread_attr_t *__restrict__,
+    size_t *__restrict__);
+extern int pthread_attr_setstacksize(pthread_attr_t *, size_t);
 
 extern int pthread_mutex_init(pthread_mutex_t *__restrict__,
     const pthread_mutexattr_t *__restrict__);
@@ -34,57 +34,108 @@
 
 #include <pthread.h>
 #include <errno.h>
+#include <fibril_synch.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
 #include "../internal/common.h"
+#include "../internal/pthread.h"
+
+/*
+ * The condition variable is a sequence number bumped by every signal.
+ * Waiters sleep only as long as it does not change after they have
+ * released the mutex, so no signal can get lost in between.
+ */
+
+typedef struct {
+	pthread_cond_t *condvar;
+	unsigned int seq;
+} cond_wait_t;
+
+static bool cond_is_unchanged(void *arg)
+{
+	cond_wait_t *wait = arg;
+
+	return __atomic_load_n(&wait->condvar->seq, __ATOMIC_RELAXED) ==
+	    wait->seq;
+}
 
 int pthread_cond_init(pthread_cond_t *restrict condvar,
     const pthread_condattr_t *restrict attr)
 {
-	not_implemented();
-	return ENOTSUP;
+	condvar->seq = 0;
+	return EOK;
 }
 
 int pthread_cond_destroy(pthread_cond_t *condvar)
 {
-	not_implemented();
-	return ENOTSUP;
+	return EOK;
 }
 
 int pthread_cond_broadcast(pthread_cond_t *condvar)
 {
-	not_implemented();
-	return ENOTSUP;
+	__atomic_fetch_add(&condvar->seq, 1, __ATOMIC_SEQ_CST);
+	(void) fibril_unpark(&condvar->seq, SIZE_MAX);
+	return EOK;
 }
 
 int pthread_cond_signal(pthread_cond_t *condvar)
 {
-	not_implemented();
-	return ENOTSUP;
+	__atomic_fetch_add(&condvar->seq, 1, __ATOMIC_SEQ_CST);
+	(void) fibril_unpark(&condvar->seq, 1);
+	return EOK;
+}
+
+static int cond_wait(pthread_cond_t *condvar, pthread_mutex_t *mutex,
+    const struct timespec *expires)
+{
+	cond_wait_t wait = {
+		.condvar = condvar,
+		.seq = __atomic_load_n(&condvar->seq, __ATOMIC_RELAXED)
+	};
+
+	unsigned int count = __pthread_mutex_release_all(mutex);
+	errno_t rc = fibril_park(&condvar->seq, cond_is_unchanged, &wait,
+	    expires);
+	__pthread_mutex_reacquire(mutex, count);
+
+	return rc == ETIMEOUT ? ETIMEDOUT : EOK;
 }
 
 int pthread_cond_timedwait(pthread_cond_t *restrict condvar,
     pthread_mutex_t *restrict mutex, const struct timespec *restrict timeout)
 {
-	not_implemented();
-	return ENOTSUP;
+	/*
+	 * The timeout is in CLOCK_REALTIME, fibrils sleep until
+	 * an uptime deadline.
+	 */
+	struct timespec now;
+	getrealtime(&now);
+	nsec_t diff = ts_sub_diff(timeout, &now);
+	if (diff <= 0)
+		return ETIMEDOUT;
+
+	struct timespec expires;
+	getuptime(&expires);
+	ts_add_diff(&expires, diff);
+
+	return cond_wait(condvar, mutex, &expires);
 }
 
 int pthread_cond_wait(pthread_cond_t *restrict condvar,
     pthread_mutex_t *restrict mutex)
 {
-	not_implemented();
-	return ENOTSUP;
+	return cond_wait(condvar, mutex, NULL);
 }
 
 int pthread_condattr_init(pthread_condattr_t *attr)
 {
-	not_implemented();
-	return ENOTSUP;
+	return EOK;
 }
 
 int pthread_condattr_destroy(pthread_condattr_t *attr)
 {
-	not_implemented();
-	return ENOTSUP;
+	return EOK;
 }
 
 /** @}
@@ -35,30 +35,141 @@
 #include <stdlib.h>
 #include <pthread.h>
 #include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <limits.h>
+#include <stdbool.h>
 #include "../internal/common.h"
+#include "../internal/pthread.h"
+
+/*
+ * Values of the keys are kept in a fibril-local array, so reading one
+ * costs a TLS access and two loads. The array is allocated on the first
+ * pthread_setspecific() in each thread.
+ *
+ * Every key creation bumps the generation of the slot, so a value left
+ * in some thread by a deleted key is not visible through a new key that
+ * reuses the slot.
+ */
+
+typedef struct {
+	unsigned int generation;
+	void *value;
+} key_value_t;
+
+static fibril_local key_value_t *key_values;
+
+static FIBRIL_MUTEX_INITIALIZE(keys_lock);
+static bool key_used[PTHREAD_KEYS_MAX];
+static unsigned int key_generation[PTHREAD_KEYS_MAX];
+static void (*key_destructor[PTHREAD_KEYS_MAX])(void *);
+
+static inline bool key_valid(pthread_key_t key)
+{
+	return key >= 0 && key < PTHREAD_KEYS_MAX;
+}
 
 void *pthread_getspecific(pthread_key_t key)
 {
-	not_implemented();
-	return NULL;
+	if (!key_values || !key_valid(key))
+		return NULL;
+
+	key_value_t *kv = &key_values[key];
+	if (kv->generation != __atomic_load_n(&key_generation[key],
+	    __ATOMIC_RELAXED))
+		return NULL;
+
+	return kv->value;
 }
 
 int pthread_setspecific(pthread_key_t key, const void *data)
 {
-	not_implemented();
-	return ENOTSUP;
+	if (!key_valid(key))
+		return EINVAL;
+
+	if (!key_values) {
+		key_values = calloc(PTHREAD_KEYS_MAX, sizeof(key_value_t));
+		if (!key_values)
+			return ENOMEM;
+	}
+
+	key_values[key].generation = __atomic_load_n(&key_generation[key],
+	    __ATOMIC_RELAXED);
+	key_values[key].value = (void *) data;
+	return EOK;
 }
 
 int pthread_key_delete(pthread_key_t key)
 {
-	not_implemented();
-	return ENOTSUP;
+	if (!key_valid(key))
+		return EINVAL;
+
+	fibril_mutex_lock(&keys_lock);
+	if (!key_used[key]) {
+		fibril_mutex_unlock(&keys_lock);
+		return EINVAL;
+	}
+
+	key_used[key] = false;
+	key_destructor[key] = NULL;
+	fibril_mutex_unlock(&keys_lock);
+	return EOK;
 }
 
 int pthread_key_create(pthread_key_t *key, void (*destructor)(void *))
 {
-	not_implemented();
-	return ENOTSUP;
+	fibril_mutex_lock(&keys_lock);
+
+	for (pthread_key_t k = 0; k < PTHREAD_KEYS_MAX; k++) {
+		if (key_used[k])
+			continue;
+
+		key_used[k] = true;
+		key_destructor[k] = destructor;
+		__atomic_store_n(&key_generation[k], key_generation[k] + 1,
+		    __ATOMIC_RELAXED);
+		fibril_mutex_unlock(&keys_lock);
+
+		*key = k;
+		return EOK;
+	}
+
+	fibril_mutex_unlock(&keys_lock);
+	return EAGAIN;
+}
+
+/** Run destructors of the values of the exiting thread and free them. */
+void __pthread_keys_destroy(void)
+{
+	if (!key_values)
+		return;
+
+	for (int i = 0; i < PTHREAD_DESTRUCTOR_ITERATIONS; i++) {
+		bool called = false;
+
+		for (pthread_key_t k = 0; k < PTHREAD_KEYS_MAX; k++) {
+			void *value = pthread_getspecific(k);
+			if (!value)
+				continue;
+
+			fibril_mutex_lock(&keys_lock);
+			void (*destructor)(void *) = key_used[k] ?
+			    key_destructor[k] : NULL;
+			fibril_mutex_unlock(&keys_lock);
+
+			key_values[k].value = NULL;
+			if (destructor) {
+				destructor(value);
+				called = true;
+			}
+		}
+
+		if (!called)
+			break;
+	}
+
+	free(key_values);
+	key_values = NULL;
 }
 
 /** @}
@@ -34,62 +34,214 @@
 
 #include <pthread.h>
 #include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <stdbool.h>
 #include "../internal/common.h"
+#include "../internal/pthread.h"
+
+/*
+ * The mutex state is a single word: unlocked, locked, or locked with
+ * (possibly) parked waiters. Only the last one makes unlock call libc.
+ */
+#define MUTEX_UNLOCKED   0
+#define MUTEX_LOCKED     1
+#define MUTEX_CONTENDED  2
+
+/** Number of times a contended mutex is polled before parking. */
+#define MUTEX_SPIN_COUNT  100
+
+static bool mutex_is_contended(void *arg)
+{
+	pthread_mutex_t *mutex = arg;
+
+	return __atomic_load_n(&mutex->state, __ATOMIC_RELAXED) ==
+	    MUTEX_CONTENDED;
+}
+
+static bool mutex_try_acquire(pthread_mutex_t *mutex)
+{
+	int expected = MUTEX_UNLOCKED;
+
+	return __atomic_compare_exchange_n(&mutex->state, &expected,
+	    MUTEX_LOCKED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+/** Lock the mutex after having slept on it.
+ *
+ * We cannot know whether other fibrils are parked as well,
+ * so the mutex has to stay marked as contended.
+ */
+static void mutex_acquire_contended(pthread_mutex_t *mutex)
+{
+	while (__atomic_exchange_n(&mutex->state, MUTEX_CONTENDED,
+	    __ATOMIC_ACQUIRE) != MUTEX_UNLOCKED)
+		(void) fibril_park(&mutex->state, mutex_is_contended, mutex,
+		    NULL);
+}
+
+static void mutex_acquire(pthread_mutex_t *mutex)
+{
+	if (mutex_try_acquire(mutex))
+		return;
+
+	/*
+	 * The holder usually runs on another runner and leaves the
+	 * critical section soon. With a single runner, it cannot run
+	 * while we spin.
+	 */
+	if (fibril_get_runner_count() > 1) {
+		for (int i = 0; i < MUTEX_SPIN_COUNT; i++) {
+			int state = __atomic_load_n(&mutex->state,
+			    __ATOMIC_RELAXED);
+			if (state == MUTEX_CONTENDED)
+				break;
+			if (state == MUTEX_UNLOCKED && mutex_try_acquire(mutex))
+				return;
+		}
+	}
+
+	mutex_acquire_contended(mutex);
+}
+
+static void mutex_release(pthread_mutex_t *mutex)
+{
+	if (__atomic_exchange_n(&mutex->state, MUTEX_UNLOCKED,
+	    __ATOMIC_RELEASE) == MUTEX_CONTENDED)
+		(void) fibril_unpark(&mutex->state, 1);
+}
 
 int pthread_mutex_init(pthread_mutex_t *restrict mutex,
     const pthread_mutexattr_t *restrict attr)
 {
-	not_implemented();
-	return ENOTSUP;
+	mutex->state = MUTEX_UNLOCKED;
+	mutex->type = attr ? attr->type : PTHREAD_MUTEX_DEFAULT;
+	mutex->count = 0;
+	mutex->owner = NULL;
+	return EOK;
 }
 
 int pthread_mutex_destroy(pthread_mutex_t *mutex)
 {
-	not_implemented();
-	return ENOTSUP;
+	if (__atomic_load_n(&mutex->state, __ATOMIC_RELAXED) !=
+	    MUTEX_UNLOCKED)
+		return EBUSY;
+
+	return EOK;
 }
 
 int pthread_mutex_lock(pthread_mutex_t *mutex)
 {
-	not_implemented();
-	return ENOTSUP;
+	if (mutex->type != PTHREAD_MUTEX_NORMAL) {
+		pthread_t self = pthread_self();
+
+		if (mutex->owner == self) {
+			if (mutex->type == PTHREAD_MUTEX_ERRORCHECK)
+				return EDEADLK;
+
+			mutex->count++;
+			return EOK;
+		}
+
+		mutex_acquire(mutex);
+		mutex->owner = self;
+		mutex->count = 1;
+		return EOK;
+	}
+
+	mutex_acquire(mutex);
+	return EOK;
 }
 
 int pthread_mutex_trylock(pthread_mutex_t *mutex)
 {
-	not_implemented();
-	return ENOTSUP;
+	if (mutex->type == PTHREAD_MUTEX_RECURSIVE &&
+	    mutex->owner == pthread_self()) {
+		mutex->count++;
+		return EOK;
+	}
+
+	if (!mutex_try_acquire(mutex))
+		return EBUSY;
+
+	if (mutex->type != PTHREAD_MUTEX_NORMAL) {
+		mutex->owner = pthread_self();
+		mutex->count = 1;
+	}
+
+	return EOK;
 }
 
 int pthread_mutex_unlock(pthread_mutex_t *mutex)
 {
-	not_implemented();
-	return ENOTSUP;
+	if (mutex->type != PTHREAD_MUTEX_NORMAL) {
+		if (mutex->owner != pthread_self())
+			return EPERM;
+
+		if (--mutex->count > 0)
+			return EOK;
+
+		mutex->owner = NULL;
+	}
+
+	mutex_release(mutex);
+	return EOK;
+}
+
+/** Unlock the mutex completely before waiting on a condition variable.
+ *
+ * @return Recursion count to pass to __pthread_mutex_reacquire().
+ */
+unsigned int __pthread_mutex_release_all(pthread_mutex_t *mutex)
+{
+	unsigned int count = mutex->count;
+
+	mutex->count = 0;
+	mutex->owner = NULL;
+	mutex_release(mutex);
+	return count;
+}
+
+/** Lock the mutex again after waiting on a condition variable.
+ *
+ * Other fibrils woken by a broadcast may be competing for the mutex.
+ */
+void __pthread_mutex_reacquire(pthread_mutex_t *mutex, unsigned int count)
+{
+	mutex_acquire_contended(mutex);
+
+	if (mutex->type != PTHREAD_MUTEX_NORMAL) {
+		mutex->owner = pthread_self();
+		mutex->count = count;
+	}
 }
 
 int pthread_mutexattr_init(pthread_mutexattr_t *attr)
 {
-	not_implemented();
-	return ENOTSUP;
+	attr->type = PTHREAD_MUTEX_DEFAULT;
+	return EOK;
 }
 
 int pthread_mutexattr_destroy(pthread_mutexattr_t *attr)
 {
-	not_implemented();
-	return ENOTSUP;
+	return EOK;
 }
 
 int pthread_mutexattr_gettype(const pthread_mutexattr_t *restrict attr,
     int *restrict type)
 {
-	not_implemented();
-	return ENOTSUP;
+	*type = attr->type;
+	return EOK;
 }
 
 int pthread_mutexattr_settype(pthread_mutexattr_t *attr, int type)
 {
-	not_implemented();
-	return ENOTSUP;
+	if (type != PTHREAD_MUTEX_NORMAL && type != PTHREAD_MUTEX_RECURSIVE &&
+	    type != PTHREAD_MUTEX_ERRORCHECK)
+		return EINVAL;
+
+	attr->type = type;
+	return EOK;
 }
 
 /** @}
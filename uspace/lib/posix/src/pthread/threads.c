@@ -34,12 +34,34 @@
 
 #include <pthread.h>
 #include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <fibril.h>
+#include <fibril_synch.h>
 #include "../internal/common.h"
+#include "../internal/pthread.h"
+
+/** Control block of a thread started by pthread_create(). */
+typedef struct {
+	void *(*start_routine)(void *);
+	void *arg;
+	void *retval;
+
+	fibril_mutex_t lock;
+	fibril_condvar_t finished_cv;
+	bool finished;
+	bool detached;
+} pthread_tcb_t;
+
+/** Control block of the current thread, NULL if not created by us. */
+static fibril_local pthread_tcb_t *current;
 
 pthread_t pthread_self(void)
 {
+	if (current)
+		return (pthread_t) current;
+
 	return (pthread_t) fibril_get_id();
 }
 
@@ -48,35 +70,162 @@ int pthread_equal(pthread_t thread1, pthread_t thread2)
 	return thread1 == thread2;
 }
 
+static errno_t pthread_main(void *arg)
+{
+	pthread_tcb_t *tcb = arg;
+
+	current = tcb;
+	pthread_exit(tcb->start_routine(tcb->arg));
+}
+
+/** Create a new thread.
+ *
+ * Threads are fibrils. The first call switches the program to
+ * multithreaded mode, which starts a fibril runner for each processor,
+ * so that threads actually run in parallel.
+ */
 int pthread_create(pthread_t *thread_id, const pthread_attr_t *attributes,
     void *(*start_routine)(void *), void *arg)
 {
-	not_implemented();
-	return ENOTSUP;
+	pthread_tcb_t *tcb = calloc(1, sizeof(pthread_tcb_t));
+	if (!tcb)
+		return EAGAIN;
+
+	tcb->start_routine = start_routine;
+	tcb->arg = arg;
+	tcb->detached = attributes &&
+	    attributes->detach_state == PTHREAD_CREATE_DETACHED;
+	fibril_mutex_initialize(&tcb->lock);
+	fibril_condvar_initialize(&tcb->finished_cv);
+
+	fid_t fid;
+	if (attributes && attributes->stack_size)
+		fid = fibril_create_generic(pthread_main, tcb,
+		    attributes->stack_size);
+	else
+		fid = fibril_create(pthread_main, tcb);
+	if (!fid) {
+		free(tcb);
+		return EAGAIN;
+	}
+
+	fibril_enable_multithreaded();
+
+	/* A detached thread may exit as soon as it is ready. */
+	*thread_id = (pthread_t) tcb;
+	fibril_add_ready(fid);
+	return EOK;
+}
+
+void pthread_exit(void *retval)
+{
+	pthread_tcb_t *tcb = current;
+
+	__pthread_keys_destroy();
+
+	if (tcb) {
+		fibril_mutex_lock(&tcb->lock);
+		tcb->retval = retval;
+		tcb->finished = true;
+		bool detached = tcb->detached;
+		fibril_condvar_broadcast(&tcb->finished_cv);
+		fibril_mutex_unlock(&tcb->lock);
+
+		/* Otherwise the joining thread frees the block. */
+		if (detached)
+			free(tcb);
+		current = NULL;
+	}
+
+	fibril_exit(0);
 }
 
 int pthread_join(pthread_t thread, void **ret_val)
 {
-	not_implemented();
-	return ENOTSUP;
+	pthread_tcb_t *tcb = (pthread_tcb_t *) thread;
+
+	if (tcb == current)
+		return EDEADLK;
+
+	fibril_mutex_lock(&tcb->lock);
+	if (tcb->detached) {
+		fibril_mutex_unlock(&tcb->lock);
+		return EINVAL;
+	}
+
+	while (!tcb->finished)
+		fibril_condvar_wait(&tcb->finished_cv, &tcb->lock);
+	fibril_mutex_unlock(&tcb->lock);
+
+	if (ret_val)
+		*ret_val = tcb->retval;
+
+	free(tcb);
+	return EOK;
 }
 
 int pthread_detach(pthread_t thread)
 {
-	not_implemented();
-	return ENOTSUP;
+	pthread_tcb_t *tcb = (pthread_tcb_t *) thread;
+
+	fibril_mutex_lock(&tcb->lock);
+	if (tcb->detached) {
+		fibril_mutex_unlock(&tcb->lock);
+		return EINVAL;
+	}
+
+	tcb->detached = true;
+	bool finished = tcb->finished;
+	fibril_mutex_unlock(&tcb->lock);
+
+	if (finished)
+		free(tcb);
+
+	return EOK;
 }
 
 int pthread_attr_init(pthread_attr_t *attr)
 {
-	not_implemented();
-	return ENOTSUP;
+	attr->detach_state = PTHREAD_CREATE_JOINABLE;
+	attr->stack_size = 0;
+	return EOK;
 }
 
 int pthread_attr_destroy(pthread_attr_t *attr)
 {
-	not_implemented();
-	return ENOTSUP;
+	return EOK;
+}
+
+int pthread_attr_getdetachstate(const pthread_attr_t *attr, int *state)
+{
+	*state = attr->detach_state;
+	return EOK;
+}
+
+int pthread_attr_setdetachstate(pthread_attr_t *attr, int state)
+{
+	if (state != PTHREAD_CREATE_JOINABLE &&
+	    state != PTHREAD_CREATE_DETACHED)
+		return EINVAL;
+
+	attr->detach_state = state;
+	return EOK;
+}
+
+int pthread_attr_getstacksize(const pthread_attr_t *restrict attr,
+    size_t *restrict size)
+{
+	*size = attr->stack_size;
+	return EOK;
+}
+
+int pthread_attr_setstacksize(pthread_attr_t *attr, size_t size)
+{
+	if (size < PTHREAD_STACK_MIN)
+		return EINVAL;
+
+	attr->stack_size = size;
+	return EOK;
 }
 
 /** @}
@@ -127,34 +127,6 @@ double atof(const char *nptr)
 	return strtod(nptr, NULL);
 }
 
-/**
- * Converts a string representation of a floating-point number to
- * its native representation. See strtold().
- *
- * @param nptr String representation of a floating-point number.
- * @param endptr Pointer to the final part of the string which
- *     was not used for conversion.
- * @return Single-precision number resulting from the string conversion.
- */
-float strtof(const char *restrict nptr, char **restrict endptr)
-{
-	return (float) strtold(nptr, endptr);
-}
-
-/**
- * Converts a string representation of a floating-point number to
- * its native representation. See strtold().
- *
- * @param nptr String representation of a floating-point number.
- * @param endptr Pointer to the final part of the string which
- *     was not used for conversion.
- * @return Double-precision number resulting from the string conversion.
- */
-double strtod(const char *restrict nptr, char **restrict endptr)
-{
-	return (double) strtold(nptr, endptr);
-}
-
 /**
  * Creates and opens an unique temporary file from template.
  *
@@ -30,6 +30,7 @@
 
 PCUT_INIT;
 
+PCUT_IMPORT(pthread);
 PCUT_IMPORT(stdio);
 PCUT_IMPORT(stdlib);
 PCUT_IMPORT(unistd);
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <pcut/pcut.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(pthread);
+
+#define THREADS 4
+#define ITERATIONS 10000
+
+static pthread_mutex_t counter_lock = PTHREAD_MUTEX_INITIALIZER;
+static int counter;
+
+static void *return_arg(void *arg)
+{
+	return arg;
+}
+
+static void *increment(void *arg)
+{
+	for (int i = 0; i < ITERATIONS; i++) {
+		pthread_mutex_lock(&counter_lock);
+		counter++;
+		pthread_mutex_unlock(&counter_lock);
+	}
+
+	return NULL;
+}
+
+/** Thread return value is passed to pthread_join */
+PCUT_TEST(create_join)
+{
+	pthread_t thread;
+	void *retval = NULL;
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_create(&thread, NULL, return_arg,
+	    (void *) 42));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_join(thread, &retval));
+	PCUT_ASSERT_INT_EQUALS(42, (intptr_t) retval);
+}
+
+/** Detached thread cannot be joined */
+PCUT_TEST(detach)
+{
+	pthread_attr_t attr;
+	pthread_t thread;
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_attr_init(&attr));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_attr_setdetachstate(&attr,
+	    PTHREAD_CREATE_DETACHED));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_create(&thread, &attr, return_arg,
+	    NULL));
+	pthread_attr_destroy(&attr);
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_create(&thread, NULL, return_arg,
+	    NULL));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_detach(thread));
+}
+
+/** Mutex keeps concurrent increments consistent */
+PCUT_TEST(mutex_contention)
+{
+	pthread_t threads[THREADS];
+
+	counter = 0;
+	for (int i = 0; i < THREADS; i++) {
+		PCUT_ASSERT_INT_EQUALS(0, pthread_create(&threads[i], NULL,
+		    increment, NULL));
+	}
+
+	for (int i = 0; i < THREADS; i++)
+		PCUT_ASSERT_INT_EQUALS(0, pthread_join(threads[i], NULL));
+
+	PCUT_ASSERT_INT_EQUALS(THREADS * ITERATIONS, counter);
+}
+
+/** Recursive and error checking mutexes */
+PCUT_TEST(mutex_types)
+{
+	pthread_mutexattr_t attr;
+	pthread_mutex_t mutex;
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutexattr_init(&attr));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutexattr_settype(&attr,
+	    PTHREAD_MUTEX_RECURSIVE));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_init(&mutex, &attr));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_lock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_lock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_unlock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(EBUSY, pthread_mutex_destroy(&mutex));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_unlock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(EPERM, pthread_mutex_unlock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_destroy(&mutex));
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutexattr_settype(&attr,
+	    PTHREAD_MUTEX_ERRORCHECK));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_init(&mutex, &attr));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_lock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(EDEADLK, pthread_mutex_lock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(EBUSY, pthread_mutex_trylock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_unlock(&mutex));
+	pthread_mutexattr_destroy(&attr);
+}
+
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cv = PTHREAD_COND_INITIALIZER;
+static int queue_items;
+static int queue_consumed;
+
+static void *consume(void *arg)
+{
+	int total = (intptr_t) arg;
+
+	pthread_mutex_lock(&queue_lock);
+	while (queue_consumed < total) {
+		while (queue_items == 0)
+			pthread_cond_wait(&queue_cv, &queue_lock);
+		queue_items--;
+		queue_consumed++;
+	}
+	pthread_mutex_unlock(&queue_lock);
+
+	return NULL;
+}
+
+/** Condition variable does not lose signals */
+PCUT_TEST(cond_producer_consumer)
+{
+	pthread_t thread;
+
+	queue_items = 0;
+	queue_consumed = 0;
+	PCUT_ASSERT_INT_EQUALS(0, pthread_create(&thread, NULL, consume,
+	    (void *) ITERATIONS));
+
+	for (int i = 0; i < ITERATIONS; i++) {
+		pthread_mutex_lock(&queue_lock);
+		queue_items++;
+		pthread_cond_signal(&queue_cv);
+		pthread_mutex_unlock(&queue_lock);
+	}
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_join(thread, NULL));
+	PCUT_ASSERT_INT_EQUALS(ITERATIONS, queue_consumed);
+}
+
+/** Timed wait without a signal times out */
+PCUT_TEST(cond_timedwait)
+{
+	pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	pthread_cond_t cv = PTHREAD_COND_INITIALIZER;
+	struct timespec expires;
+
+	getrealtime(&expires);
+	ts_add_diff(&expires, MSEC2NSEC(1));
+
+	pthread_mutex_lock(&mutex);
+	PCUT_ASSERT_INT_EQUALS(ETIMEDOUT, pthread_cond_timedwait(&cv, &mutex,
+	    &expires));
+	pthread_mutex_unlock(&mutex);
+}
+
+static pthread_key_t test_key;
+static int destructor_calls;
+
+static void count_destructor(void *value)
+{
+	destructor_calls++;
+}
+
+static void *set_key(void *arg)
+{
+	if (pthread_getspecific(test_key) != NULL)
+		return (void *) 1;
+
+	pthread_setspecific(test_key, arg);
+	return pthread_getspecific(test_key);
+}
+
+/** Keys are thread-specific and have their destructors called */
+PCUT_TEST(keys)
+{
+	pthread_t thread;
+	void *retval;
+	int value;
+
+	destructor_calls = 0;
+	PCUT_ASSERT_INT_EQUALS(0, pthread_key_create(&test_key,
+	    count_destructor));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_setspecific(test_key, &value));
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_create(&thread, NULL, set_key,
+	    &thread));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_join(thread, &retval));
+	PCUT_ASSERT_EQUALS(&thread, retval);
+	PCUT_ASSERT_INT_EQUALS(1, destructor_calls);
+	PCUT_ASSERT_EQUALS(&value, pthread_getspecific(test_key));
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_key_delete(test_key));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_key_create(&test_key, NULL));
+	PCUT_ASSERT_NULL(pthread_getspecific(test_key));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_key_delete(test_key));
+}
+
+PCUT_EXPORT(pthread);
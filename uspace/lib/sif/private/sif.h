@@ -39,21 +39,73 @@
 
 #include <adt/list.h>
 #include <adt/odict.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 
+/** Minimum number of journal records before the repository is compacted */
+#define SIF_JOURNAL_MIN 64
+
 /** SIF session */
 struct sif_sess {
-	/** Repository file */
+	/** Repository file (open for appending journal records) */
 	FILE *f;
 	/** Repository file name */
 	char *fname;
 	/** Root node */
 	struct sif_node *root;
+	/** Nodes indexed by node ID (of sif_node_t) */
+	odict_t nodes;
+	/** ID that will be assigned to the next new node */
+	size_t next_id;
+	/** Number of journal records following the snapshot */
+	size_t jrecs;
+	/** Journal cannot be trusted, compact on next commit */
+	bool compact;
 };
 
+/** SIF journal record operation */
+typedef enum {
+	/** Prepend child @c id2 of type @c s1 to node @c id1 */
+	sif_jop_prepend = 'p',
+	/** Append child @c id2 of type @c s1 to node @c id1 */
+	sif_jop_append = 'a',
+	/** Insert node @c id2 of type @c s1 before sibling @c id1 */
+	sif_jop_ins_before = 'b',
+	/** Insert node @c id2 of type @c s1 after sibling @c id1 */
+	sif_jop_ins_after = 'f',
+	/** Destroy node @c id1 */
+	sif_jop_destroy = 'd',
+	/** Set attribute @c s1 of node @c id1 to value @c s2 */
+	sif_jop_set_attr = 's',
+	/** Unset attribute @c s1 of node @c id1 */
+	sif_jop_unset_attr = 'u'
+} sif_jop_t;
+
+/** SIF journal record */
+typedef struct {
+	/** Link to list of records of a transaction */
+	link_t lrecs;
+	/** Operation */
+	sif_jop_t op;
+	/** ID of the node the operation applies to */
+	size_t id1;
+	/** ID of the new node */
+	size_t id2;
+	/** First string argument or @c NULL */
+	char *s1;
+	/** Second string argument or @c NULL */
+	char *s2;
+} sif_jrec_t;
+
 /** SIF transaction */
 struct sif_trans {
 	struct sif_sess *sess;
+	/** Journal records (of sif_jrec_t) */
+	list_t recs;
+	/** Error that occurred while recording the transaction */
+	errno_t rc;
 };
 
 /** SIF attribute */
@@ -72,6 +124,10 @@ typedef struct {
 struct sif_node {
 	/** Parent node or @c NULL in case of root node */
 	struct sif_node *parent;
+	/** Node ID */
+	size_t id;
+	/** Link to sess->nodes */
+	odlink_t lnodes;
 	/** Link to parent->children */
 	link_t lparent;
 	/** Node type */
@@ -57,6 +57,19 @@
  *  - does not deal with data sets large enough not to fit in primary memory
  *
  * any kind of structure data validation is left up to the application.
+ *
+ * On disk, the repository consists of a snapshot of the whole tree followed
+ * by a journal. Committing a transaction appends a record of each change
+ * to the journal, followed by a commit mark, so the cost of a commit is
+ * proportional to the size of the change, not the size of the repository.
+ * Once the journal holds more records than there are nodes in the tree,
+ * the repository is compacted by writing a new snapshot into a temporary
+ * file and renaming it over the repository. A transaction that was only
+ * partially appended (e.g. due to a crash) is discarded when the repository
+ * is opened.
+ *
+ * Journal records refer to nodes by their ID. Nodes in the snapshot are
+ * numbered in preorder, nodes created later are numbered sequentially.
  */
 
 #include <adt/list.h>
@@ -69,12 +82,25 @@
 #include "../private/sif.h"
 
 static errno_t sif_export_node(sif_node_t *, FILE *);
-static errno_t sif_import_node(sif_node_t *, FILE *, sif_node_t **);
+static errno_t sif_export_snapshot(sif_node_t *, FILE *);
+static errno_t sif_import_node(sif_sess_t *, sif_node_t *, FILE *,
+    sif_node_t **);
+static errno_t sif_export_journal(list_t *, FILE *);
+static errno_t sif_import_journal(sif_sess_t *, FILE *);
+static errno_t sif_sess_compact(sif_sess_t *);
+static errno_t sif_trans_log(sif_trans_t *, sif_jop_t, size_t, size_t,
+    const char *, const char *, sif_jrec_t **);
+static void sif_trans_delete(sif_trans_t *);
+static void sif_jrec_delete(sif_jrec_t *);
+static errno_t sif_attr_set(sif_node_t *, const char *, const char *);
+static void sif_attr_unset(sif_node_t *, const char *);
 static sif_attr_t *sif_node_first_attr(sif_node_t *);
 static sif_attr_t *sif_node_next_attr(sif_attr_t *);
 static void sif_attr_delete(sif_attr_t *);
 static void *sif_attr_getkey(odlink_t *);
 static int sif_attr_cmp(void *, void *);
+static void *sif_node_getkey(odlink_t *);
+static int sif_node_cmp(void *, void *);
 
 /** Create new SIF node.
  *
@@ -113,6 +139,9 @@ static void sif_node_delete(sif_node_t *node)
 
 	assert(!link_used(&node->lparent));
 
+	if (odlink_used(&node->lnodes))
+		odict_remove(&node->lnodes);
+
 	if (node->ntype != NULL)
 		free(node->ntype);
 
@@ -133,6 +162,78 @@ static void sif_node_delete(sif_node_t *node)
 	free(node);
 }
 
+/** Create new SIF node and enter it into the node index.
+ *
+ * The node is not linked to the list of children of @a parent.
+ *
+ * @param sess SIF session
+ * @param parent Parent node
+ * @param id Node ID
+ * @param ntype Node type
+ * @param rnode Place to store pointer to new node
+ * @return EOK on success or ENOMEM if out of memory
+ */
+static errno_t sif_node_create(sif_sess_t *sess, sif_node_t *parent,
+    size_t id, const char *ntype, sif_node_t **rnode)
+{
+	sif_node_t *node;
+
+	node = sif_node_new(parent);
+	if (node == NULL)
+		return ENOMEM;
+
+	node->ntype = str_dup(ntype);
+	if (node->ntype == NULL) {
+		sif_node_delete(node);
+		return ENOMEM;
+	}
+
+	node->id = id;
+	odict_insert(&node->lnodes, &sess->nodes, NULL);
+	if (id >= sess->next_id)
+		sess->next_id = id + 1;
+
+	*rnode = node;
+	return EOK;
+}
+
+/** Find node by ID.
+ *
+ * @param sess SIF session
+ * @param id Node ID
+ * @return Node or @c NULL if there is no node with ID @a id
+ */
+static sif_node_t *sif_sess_find_node(sif_sess_t *sess, size_t id)
+{
+	odlink_t *link;
+
+	link = odict_find_eq(&sess->nodes, (void *)&id, NULL);
+	if (link == NULL)
+		return NULL;
+
+	return odict_get_instance(link, sif_node_t, lnodes);
+}
+
+/** Renumber nodes of a subtree in preorder.
+ *
+ * @param sess SIF session
+ * @param node Root of the subtree
+ */
+static void sif_node_renumber(sif_sess_t *sess, sif_node_t *node)
+{
+	sif_node_t *child;
+
+	odict_remove(&node->lnodes);
+	node->id = sess->next_id++;
+	odict_insert(&node->lnodes, &sess->nodes, NULL);
+
+	child = sif_node_first_child(node);
+	while (child != NULL) {
+		sif_node_renumber(sess, child);
+		child = sif_node_next_child(child);
+	}
+}
+
 /** Create new SIF attribute.
  *
  * @param node Containing node
@@ -182,7 +283,6 @@ errno_t sif_create(const char *fname, sif_sess_t **rsess)
 {
 	sif_sess_t *sess;
 	sif_node_t *root = NULL;
-	sif_trans_t *trans = NULL;
 	errno_t rc;
 	FILE *f;
 
@@ -190,23 +290,17 @@ errno_t sif_create(const char *fname, sif_sess_t **rsess)
 	if (sess == NULL)
 		return ENOMEM;
 
+	odict_initialize(&sess->nodes, sif_node_getkey, sif_node_cmp);
+
 	sess->fname = str_dup(fname);
 	if (sess->fname == NULL) {
 		rc = ENOMEM;
 		goto error;
 	}
 
-	root = sif_node_new(NULL);
-	if (root == NULL) {
-		rc = ENOMEM;
-		goto error;
-	}
-
-	root->ntype = str_dup("sif");
-	if (root->ntype == NULL) {
-		rc = ENOMEM;
+	rc = sif_node_create(sess, NULL, 0, "sif", &root);
+	if (rc != EOK)
 		goto error;
-	}
 
 	f = fopen(fname, "wx");
 	if (f == NULL) {
@@ -214,24 +308,26 @@ errno_t sif_create(const char *fname, sif_sess_t **rsess)
 		goto error;
 	}
 
-	sess->f = f;
-	sess->root = root;
-
-	/* Run a dummy trasaction to marshall initial repo state to file */
-	rc = sif_trans_begin(sess, &trans);
+	/* Write initial snapshot */
+	rc = sif_export_snapshot(root, f);
+	if (fclose(f) < 0 && rc == EOK)
+		rc = EIO;
 	if (rc != EOK)
 		goto error;
 
-	rc = sif_trans_end(trans);
-	if (rc != EOK)
+	f = fopen(fname, "a");
+	if (f == NULL) {
+		rc = EIO;
 		goto error;
+	}
 
+	sess->f = f;
+	sess->root = root;
 	*rsess = sess;
 	return EOK;
 error:
-	if (trans != NULL)
-		sif_trans_abort(trans);
 	sif_node_delete(root);
+	odict_finalize(&sess->nodes);
 	if (sess->fname != NULL)
 		free(sess->fname);
 	free(sess);
@@ -239,6 +335,8 @@ error:
 }
 
 /** Open an existing SIF repository.
+ *
+ * Load the snapshot and replay the journal.
  *
  * @param fname File name
  * @param rsess Place to store pointer to new session.
@@ -250,12 +348,15 @@ errno_t sif_open(const char *fname, sif_sess_t **rsess)
 	sif_sess_t *sess;
 	sif_node_t *root = NULL;
 	errno_t rc;
-	FILE *f;
+	FILE *f = NULL;
+	int c;
 
 	sess = calloc(1, sizeof(sif_sess_t));
 	if (sess == NULL)
 		return ENOMEM;
 
+	odict_initialize(&sess->nodes, sif_node_getkey, sif_node_cmp);
+
 	sess->fname = str_dup(fname);
 	if (sess->fname == NULL) {
 		rc = ENOMEM;
@@ -268,7 +369,7 @@ errno_t sif_open(const char *fname, sif_sess_t **rsess)
 		goto error;
 	}
 
-	rc = sif_import_node(NULL, f, &root);
+	rc = sif_import_node(sess, NULL, f, &root);
 	if (rc != EOK)
 		goto error;
 
@@ -277,14 +378,41 @@ errno_t sif_open(const char *fname, sif_sess_t **rsess)
 		goto error;
 	}
 
-	sess->root = root;
+	c = fgetc(f);
+	if (c != '\n' && c != EOF) {
+		rc = EIO;
+		goto error;
+	}
 
-	sess->f = f;
 	sess->root = root;
+
+	rc = sif_import_journal(sess, f);
+	if (rc != EOK)
+		goto error;
+
+	(void) fclose(f);
+	f = NULL;
+
+	if (sess->compact) {
+		/* Get rid of incomplete transaction at the end of the journal */
+		rc = sif_sess_compact(sess);
+		if (rc != EOK)
+			goto error;
+	} else {
+		sess->f = fopen(fname, "a");
+		if (sess->f == NULL) {
+			rc = EIO;
+			goto error;
+		}
+	}
+
 	*rsess = sess;
 	return EOK;
 error:
+	if (f != NULL)
+		(void) fclose(f);
 	sif_node_delete(root);
+	odict_finalize(&sess->nodes);
 	if (sess->fname != NULL)
 		free(sess->fname);
 	free(sess);
@@ -298,17 +426,18 @@ error:
  */
 errno_t sif_close(sif_sess_t *sess)
 {
+	errno_t rc = EOK;
+
 	sif_node_delete(sess->root);
+	odict_finalize(&sess->nodes);
 
-	if (fclose(sess->f) < 0) {
-		free(sess);
-		return EIO;
-	}
+	if (sess->f != NULL && fclose(sess->f) < 0)
+		rc = EIO;
 
 	if (sess->fname != NULL)
 		free(sess->fname);
 	free(sess);
-	return EOK;
+	return rc;
 }
 
 /** Return root node.
@@ -396,6 +525,7 @@ errno_t sif_trans_begin(sif_sess_t *sess, sif_trans_t **rtrans)
 		return ENOMEM;
 
 	trans->sess = sess;
+	list_initialize(&trans->recs);
 	*rtrans = trans;
 	return EOK;
 }
@@ -405,30 +535,45 @@ errno_t sif_trans_begin(sif_sess_t *sess, sif_trans_t **rtrans)
  * Commit and free the transaction. If an error is returned, that means
  * the transaction has not been freed (and sif_trans_abort() must be used).
  *
+ * The changes are appended to the journal. If the journal has grown
+ * too long, the repository is compacted instead.
+ *
  * @param trans Transaction
  * @return EOK on success or error code
  */
 errno_t sif_trans_end(sif_trans_t *trans)
 {
+	sif_sess_t *sess = trans->sess;
+	size_t nrecs;
+	size_t limit;
 	errno_t rc;
 
-	(void) fclose(trans->sess->f);
+	if (trans->rc != EOK)
+		return trans->rc;
 
-	trans->sess->f = fopen(trans->sess->fname, "w");
-	if (trans->sess->f == NULL)
-		return EIO;
+	nrecs = list_count(&trans->recs);
+	limit = odict_count(&sess->nodes);
+	if (limit < SIF_JOURNAL_MIN)
+		limit = SIF_JOURNAL_MIN;
 
-	rc = sif_export_node(trans->sess->root, trans->sess->f);
-	if (rc != EOK)
-		return rc;
-
-	if (fputc('\n', trans->sess->f) == EOF)
-		return EIO;
+	if (sess->compact || sess->f == NULL || sess->jrecs + nrecs > limit) {
+		rc = sif_sess_compact(sess);
+		if (rc != EOK) {
+			sess->compact = true;
+			return rc;
+		}
+	} else if (nrecs > 0) {
+		rc = sif_export_journal(&trans->recs, sess->f);
+		if (rc != EOK) {
+			/* The journal may now end with a partial transaction */
+			sess->compact = true;
+			return rc;
+		}
 
-	if (fflush(trans->sess->f) == EOF)
-		return EIO;
+		sess->jrecs += nrecs;
+	}
 
-	free(trans);
+	sif_trans_delete(trans);
 	return EOK;
 }
 
@@ -438,9 +583,152 @@ errno_t sif_trans_end(sif_trans_t *trans)
  */
 void sif_trans_abort(sif_trans_t *trans)
 {
+	/*
+	 * Changes made as part of the transaction have already been applied
+	 * to the tree in memory, but they are not in the journal. Make sure
+	 * the next commit writes out a fresh snapshot.
+	 */
+	if (!list_empty(&trans->recs) || trans->rc != EOK)
+		trans->sess->compact = true;
+
+	sif_trans_delete(trans);
+}
+
+/** Free SIF transaction and its journal records.
+ *
+ * @param trans Transaction
+ */
+static void sif_trans_delete(sif_trans_t *trans)
+{
+	link_t *link;
+
+	while ((link = list_first(&trans->recs)) != NULL)
+		sif_jrec_delete(list_get_instance(link, sif_jrec_t, lrecs));
+
 	free(trans);
 }
 
+/** Add record to transaction journal.
+ *
+ * @param trans Transaction
+ * @param op Operation
+ * @param id1 ID of the node the operation applies to
+ * @param id2 ID of the new node or zero
+ * @param s1 First string argument or @c NULL
+ * @param s2 Second string argument or @c NULL
+ * @param rrec Place to store pointer to new record or @c NULL
+ *
+ * @return EOK on success or ENOMEM if out of memory
+ */
+static errno_t sif_trans_log(sif_trans_t *trans, sif_jop_t op, size_t id1,
+    size_t id2, const char *s1, const char *s2, sif_jrec_t **rrec)
+{
+	sif_jrec_t *rec;
+
+	rec = calloc(1, sizeof(sif_jrec_t));
+	if (rec == NULL)
+		return ENOMEM;
+
+	rec->op = op;
+	rec->id1 = id1;
+	rec->id2 = id2;
+
+	if (s1 != NULL) {
+		rec->s1 = str_dup(s1);
+		if (rec->s1 == NULL) {
+			sif_jrec_delete(rec);
+			return ENOMEM;
+		}
+	}
+
+	if (s2 != NULL) {
+		rec->s2 = str_dup(s2);
+		if (rec->s2 == NULL) {
+			sif_jrec_delete(rec);
+			return ENOMEM;
+		}
+	}
+
+	list_append(&rec->lrecs, &trans->recs);
+	if (rrec != NULL)
+		*rrec = rec;
+	return EOK;
+}
+
+/** Delete journal record.
+ *
+ * @param rec Journal record
+ */
+static void sif_jrec_delete(sif_jrec_t *rec)
+{
+	if (link_used(&rec->lrecs))
+		list_remove(&rec->lrecs);
+
+	if (rec->s1 != NULL)
+		free(rec->s1);
+	if (rec->s2 != NULL)
+		free(rec->s2);
+	free(rec);
+}
+
+/** Compact SIF repository.
+ *
+ * Write a snapshot of the tree into a temporary file and replace the
+ * repository file with it, thereby discarding the journal.
+ *
+ * @param sess SIF session
+ * @return EOK on success or error code
+ */
+static errno_t sif_sess_compact(sif_sess_t *sess)
+{
+	char *tname;
+	errno_t rc;
+	FILE *f;
+
+	if (asprintf(&tname, "%s.new", sess->fname) < 0)
+		return ENOMEM;
+
+	f = fopen(tname, "w");
+	if (f == NULL) {
+		free(tname);
+		return EIO;
+	}
+
+	/* Snapshot nodes are numbered in preorder */
+	sess->next_id = 0;
+	sif_node_renumber(sess, sess->root);
+
+	rc = sif_export_snapshot(sess->root, f);
+	if (fclose(f) < 0 && rc == EOK)
+		rc = EIO;
+	if (rc != EOK)
+		goto error;
+
+	if (sess->f != NULL) {
+		(void) fclose(sess->f);
+		sess->f = NULL;
+	}
+
+	if (rename(tname, sess->fname) != 0) {
+		rc = EIO;
+		goto error;
+	}
+
+	free(tname);
+
+	sess->f = fopen(sess->fname, "a");
+	if (sess->f == NULL)
+		return EIO;
+
+	sess->jrecs = 0;
+	sess->compact = false;
+	return EOK;
+error:
+	(void) remove(tname);
+	free(tname);
+	return rc;
+}
+
 /** Prepend new child.
  *
  * Create a new child and prepend it at the beginning of children list of
@@ -456,16 +744,20 @@ void sif_trans_abort(sif_trans_t *trans)
 errno_t sif_node_prepend_child(sif_trans_t *trans, sif_node_t *parent,
     const char *ctype, sif_node_t **rchild)
 {
+	sif_sess_t *sess = trans->sess;
 	sif_node_t *child;
+	sif_jrec_t *rec;
+	errno_t rc;
 
-	child = sif_node_new(parent);
-	if (child == NULL)
-		return ENOMEM;
+	rc = sif_trans_log(trans, sif_jop_prepend, parent->id, sess->next_id, ctype,
+	    NULL, &rec);
+	if (rc != EOK)
+		return rc;
 
-	child->ntype = str_dup(ctype);
-	if (child->ntype == NULL) {
-		sif_node_delete(child);
-		return ENOMEM;
+	rc = sif_node_create(sess, parent, sess->next_id, ctype, &child);
+	if (rc != EOK) {
+		sif_jrec_delete(rec);
+		return rc;
 	}
 
 	list_prepend(&child->lparent, &parent->children);
@@ -488,16 +780,20 @@ errno_t sif_node_prepend_child(sif_trans_t *trans, sif_node_t *parent,
 errno_t sif_node_append_child(sif_trans_t *trans, sif_node_t *parent,
     const char *ctype, sif_node_t **rchild)
 {
+	sif_sess_t *sess = trans->sess;
 	sif_node_t *child;
+	sif_jrec_t *rec;
+	errno_t rc;
 
-	child = sif_node_new(parent);
-	if (child == NULL)
-		return ENOMEM;
+	rc = sif_trans_log(trans, sif_jop_append, parent->id, sess->next_id, ctype,
+	    NULL, &rec);
+	if (rc != EOK)
+		return rc;
 
-	child->ntype = str_dup(ctype);
-	if (child->ntype == NULL) {
-		sif_node_delete(child);
-		return ENOMEM;
+	rc = sif_node_create(sess, parent, sess->next_id, ctype, &child);
+	if (rc != EOK) {
+		sif_jrec_delete(rec);
+		return rc;
 	}
 
 	list_append(&child->lparent, &parent->children);
@@ -520,16 +816,20 @@ errno_t sif_node_append_child(sif_trans_t *trans, sif_node_t *parent,
 errno_t sif_node_insert_before(sif_trans_t *trans, sif_node_t *sibling,
     const char *ctype, sif_node_t **rchild)
 {
+	sif_sess_t *sess = trans->sess;
 	sif_node_t *child;
+	sif_jrec_t *rec;
+	errno_t rc;
 
-	child = sif_node_new(sibling->parent);
-	if (child == NULL)
-		return ENOMEM;
+	rc = sif_trans_log(trans, sif_jop_ins_before, sibling->id, sess->next_id, ctype,
+	    NULL, &rec);
+	if (rc != EOK)
+		return rc;
 
-	child->ntype = str_dup(ctype);
-	if (child->ntype == NULL) {
-		sif_node_delete(child);
-		return ENOMEM;
+	rc = sif_node_create(sess, sibling->parent, sess->next_id, ctype, &child);
+	if (rc != EOK) {
+		sif_jrec_delete(rec);
+		return rc;
 	}
 
 	list_insert_before(&child->lparent, &sibling->lparent);
@@ -552,16 +852,20 @@ errno_t sif_node_insert_before(sif_trans_t *trans, sif_node_t *sibling,
 errno_t sif_node_insert_after(sif_trans_t *trans, sif_node_t *sibling,
     const char *ctype, sif_node_t **rchild)
 {
+	sif_sess_t *sess = trans->sess;
 	sif_node_t *child;
+	sif_jrec_t *rec;
+	errno_t rc;
 
-	child = sif_node_new(sibling->parent);
-	if (child == NULL)
-		return ENOMEM;
+	rc = sif_trans_log(trans, sif_jop_ins_after, sibling->id, sess->next_id, ctype,
+	    NULL, &rec);
+	if (rc != EOK)
+		return rc;
 
-	child->ntype = str_dup(ctype);
-	if (child->ntype == NULL) {
-		sif_node_delete(child);
-		return ENOMEM;
+	rc = sif_node_create(sess, sibling->parent, sess->next_id, ctype, &child);
+	if (rc != EOK) {
+		sif_jrec_delete(rec);
+		return rc;
 	}
 
 	list_insert_after(&child->lparent, &sibling->lparent);
@@ -580,6 +884,13 @@ errno_t sif_node_insert_after(sif_trans_t *trans, sif_node_t *sibling,
  */
 void sif_node_destroy(sif_trans_t *trans, sif_node_t *node)
 {
+	errno_t rc;
+
+	rc = sif_trans_log(trans, sif_jop_destroy, node->id, 0, NULL, NULL,
+	    NULL);
+	if (rc != EOK)
+		trans->rc = rc;
+
 	list_remove(&node->lparent);
 	sif_node_delete(node);
 }
@@ -595,6 +906,56 @@ void sif_node_destroy(sif_trans_t *trans, sif_node_t *node)
  */
 errno_t sif_node_set_attr(sif_trans_t *trans, sif_node_t *node,
     const char *aname, const char *avalue)
+{
+	sif_jrec_t *rec;
+	errno_t rc;
+
+	rc = sif_trans_log(trans, sif_jop_set_attr, node->id, 0, aname,
+	    avalue, &rec);
+	if (rc != EOK)
+		return rc;
+
+	rc = sif_attr_set(node, aname, avalue);
+	if (rc != EOK) {
+		sif_jrec_delete(rec);
+		return rc;
+	}
+
+	return EOK;
+}
+
+/** Unset node attribute.
+ *
+ * This function does not return an error, but the transaction may still
+ * fail to complete.
+ *
+ * @param trans Transaction
+ * @param node Node
+ * @param aname Attribute name
+ */
+void sif_node_unset_attr(sif_trans_t *trans, sif_node_t *node,
+    const char *aname)
+{
+	errno_t rc;
+
+	rc = sif_trans_log(trans, sif_jop_unset_attr, node->id, 0, aname,
+	    NULL, NULL);
+	if (rc != EOK)
+		trans->rc = rc;
+
+	sif_attr_unset(node, aname);
+}
+
+/** Set attribute in the tree.
+ *
+ * @param node SIF node
+ * @param aname Attribute name
+ * @param value Attribute value
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+static errno_t sif_attr_set(sif_node_t *node, const char *aname,
+    const char *avalue)
 {
 	odlink_t *link;
 	sif_attr_t *attr;
@@ -633,17 +994,12 @@ errno_t sif_node_set_attr(sif_trans_t *trans, sif_node_t *node,
 	return EOK;
 }
 
-/** Unset node attribute.
+/** Unset attribute in the tree.
  *
- * This function does not return an error, but the transaction may still
- * fail to complete.
- *
- * @param trans Transaction
  * @param node Node
  * @param aname Attribute name
  */
-void sif_node_unset_attr(sif_trans_t *trans, sif_node_t *node,
-    const char *aname)
+static void sif_attr_unset(sif_node_t *node, const char *aname)
 {
 	odlink_t *link;
 	sif_attr_t *attr;
@@ -883,12 +1239,14 @@ static errno_t sif_export_node(sif_node_t *node, FILE *f)
 
 /** Import SIF node from file.
  *
+ * @param sess SIF session
  * @param parent Parent node
  * @param f File
  * @param rnode Place to store pointer to imported node
  * @return EOK on success, EIO on I/O error
  */
-static errno_t sif_import_node(sif_node_t *parent, FILE *f, sif_node_t **rnode)
+static errno_t sif_import_node(sif_sess_t *sess, sif_node_t *parent, FILE *f,
+    sif_node_t **rnode)
 {
 	errno_t rc;
 	sif_node_t *node = NULL;
@@ -901,6 +1259,10 @@ static errno_t sif_import_node(sif_node_t *parent, FILE *f, sif_node_t **rnode)
 	if (node == NULL)
 		return ENOMEM;
 
+	/* Number nodes in preorder */
+	node->id = sess->next_id++;
+	odict_insert(&node->lnodes, &sess->nodes, NULL);
+
 	rc = sif_import_string(f, &ntype);
 	if (rc != EOK)
 		goto error;
@@ -954,7 +1316,7 @@ static errno_t sif_import_node(sif_node_t *parent, FILE *f, sif_node_t **rnode)
 	while (c != '}') {
 		ungetc(c, f);
 
-		rc = sif_import_node(node, f, &child);
+		rc = sif_import_node(sess, node, f, &child);
 		if (rc != EOK)
 			goto error;
 
@@ -974,6 +1336,348 @@ error:
 	return rc;
 }
 
+/** Export snapshot of SIF tree to file.
+ *
+ * @param root Root node
+ * @param f File
+ * @return EOK on success, EIO on I/O error
+ */
+static errno_t sif_export_snapshot(sif_node_t *root, FILE *f)
+{
+	errno_t rc;
+
+	rc = sif_export_node(root, f);
+	if (rc != EOK)
+		return rc;
+
+	if (fputc('\n', f) == EOF)
+		return EIO;
+
+	if (fflush(f) == EOF)
+		return EIO;
+
+	return EOK;
+}
+
+/** Export node ID to file.
+ *
+ * @param id Node ID
+ * @param f File
+ * @return EOK on success, EIO on I/O error
+ */
+static errno_t sif_export_id(size_t id, FILE *f)
+{
+	if (fprintf(f, "[%zu]", id) < 0)
+		return EIO;
+
+	return EOK;
+}
+
+/** Import node ID from file.
+ *
+ * @param f File
+ * @param rid Place to store node ID
+ * @return EOK on success, EIO on I/O error
+ */
+static errno_t sif_import_id(FILE *f, size_t *rid)
+{
+	char *str;
+	errno_t rc;
+
+	rc = sif_import_string(f, &str);
+	if (rc != EOK)
+		return rc;
+
+	rc = str_size_t(str, NULL, 10, true, rid);
+	free(str);
+	if (rc != EOK)
+		return EIO;
+
+	return EOK;
+}
+
+/** Export journal record to file.
+ *
+ * @param rec Journal record
+ * @param f File
+ * @return EOK on success, EIO on I/O error
+ */
+static errno_t sif_export_jrec(sif_jrec_t *rec, FILE *f)
+{
+	errno_t rc;
+
+	if (fputc(rec->op, f) == EOF)
+		return EIO;
+
+	rc = sif_export_id(rec->id1, f);
+	if (rc != EOK)
+		return rc;
+
+	switch (rec->op) {
+	case sif_jop_prepend:
+	case sif_jop_append:
+	case sif_jop_ins_before:
+	case sif_jop_ins_after:
+		rc = sif_export_id(rec->id2, f);
+		if (rc != EOK)
+			return rc;
+		rc = sif_export_string(rec->s1, f);
+		break;
+	case sif_jop_destroy:
+		break;
+	case sif_jop_set_attr:
+		rc = sif_export_string(rec->s1, f);
+		if (rc != EOK)
+			return rc;
+		rc = sif_export_string(rec->s2, f);
+		break;
+	case sif_jop_unset_attr:
+		rc = sif_export_string(rec->s1, f);
+		break;
+	}
+
+	if (rc != EOK)
+		return rc;
+
+	if (fputc('\n', f) == EOF)
+		return EIO;
+
+	return EOK;
+}
+
+/** Import journal record from file.
+ *
+ * @param f File
+ * @param rrec Place to store pointer to new journal record
+ * @return EOK on success, EIO on I/O error, ENOMEM if out of memory
+ */
+static errno_t sif_import_jrec(FILE *f, sif_jrec_t **rrec)
+{
+	sif_jrec_t *rec;
+	errno_t rc;
+	int c;
+
+	rec = calloc(1, sizeof(sif_jrec_t));
+	if (rec == NULL)
+		return ENOMEM;
+
+	c = fgetc(f);
+	rec->op = c;
+
+	rc = sif_import_id(f, &rec->id1);
+	if (rc != EOK)
+		goto error;
+
+	switch (c) {
+	case sif_jop_prepend:
+	case sif_jop_append:
+	case sif_jop_ins_before:
+	case sif_jop_ins_after:
+		rc = sif_import_id(f, &rec->id2);
+		if (rc != EOK)
+			goto error;
+		rc = sif_import_string(f, &rec->s1);
+		break;
+	case sif_jop_destroy:
+		break;
+	case sif_jop_set_attr:
+		rc = sif_import_string(f, &rec->s1);
+		if (rc != EOK)
+			goto error;
+		rc = sif_import_string(f, &rec->s2);
+		break;
+	case sif_jop_unset_attr:
+		rc = sif_import_string(f, &rec->s1);
+		break;
+	default:
+		rc = EIO;
+		break;
+	}
+
+	if (rc != EOK)
+		goto error;
+
+	if (fgetc(f) != '\n') {
+		rc = EIO;
+		goto error;
+	}
+
+	*rrec = rec;
+	return EOK;
+error:
+	sif_jrec_delete(rec);
+	return rc;
+}
+
+/** Export transaction journal to file.
+ *
+ * @param recs List of journal records
+ * @param f File
+ * @return EOK on success, EIO on I/O error
+ */
+static errno_t sif_export_journal(list_t *recs, FILE *f)
+{
+	errno_t rc;
+
+	list_foreach(*recs, lrecs, sif_jrec_t, rec) {
+		rc = sif_export_jrec(rec, f);
+		if (rc != EOK)
+			return rc;
+	}
+
+	/* Commit mark */
+	if (fputs("c\n", f) == EOF)
+		return EIO;
+
+	if (fflush(f) == EOF)
+		return EIO;
+
+	return EOK;
+}
+
+/** Apply journal record to SIF tree.
+ *
+ * @param sess SIF session
+ * @param rec Journal record
+ * @return EOK on success, EIO if the record is not valid,
+ *         ENOMEM if out of memory
+ */
+static errno_t sif_jrec_apply(sif_sess_t *sess, sif_jrec_t *rec)
+{
+	sif_node_t *node;
+	sif_node_t *child;
+	errno_t rc;
+
+	node = sif_sess_find_node(sess, rec->id1);
+	if (node == NULL)
+		return EIO;
+
+	switch (rec->op) {
+	case sif_jop_prepend:
+	case sif_jop_append:
+	case sif_jop_ins_before:
+	case sif_jop_ins_after:
+		if (sif_sess_find_node(sess, rec->id2) != NULL)
+			return EIO;
+
+		if (rec->op == sif_jop_prepend || rec->op == sif_jop_append) {
+			rc = sif_node_create(sess, node, rec->id2, rec->s1,
+			    &child);
+		} else {
+			if (node->parent == NULL)
+				return EIO;
+			rc = sif_node_create(sess, node->parent, rec->id2,
+			    rec->s1, &child);
+		}
+
+		if (rc != EOK)
+			return rc;
+
+		if (rec->op == sif_jop_prepend)
+			list_prepend(&child->lparent, &node->children);
+		else if (rec->op == sif_jop_append)
+			list_append(&child->lparent, &node->children);
+		else if (rec->op == sif_jop_ins_before)
+			list_insert_before(&child->lparent, &node->lparent);
+		else
+			list_insert_after(&child->lparent, &node->lparent);
+		break;
+	case sif_jop_destroy:
+		if (node->parent == NULL)
+			return EIO;
+
+		list_remove(&node->lparent);
+		sif_node_delete(node);
+		break;
+	case sif_jop_set_attr:
+		return sif_attr_set(node, rec->s1, rec->s2);
+	case sif_jop_unset_attr:
+		sif_attr_unset(node, rec->s1);
+		break;
+	}
+
+	return EOK;
+}
+
+/** Import journal from file and apply it to SIF tree.
+ *
+ * Records are applied one committed transaction at a time. If the file
+ * ends in the middle of a transaction, the transaction is discarded and
+ * @c sess->compact is set.
+ *
+ * @param sess SIF session
+ * @param f File
+ * @return EOK on success, EIO on I/O error or if the journal is corrupt,
+ *         ENOMEM if out of memory
+ */
+static errno_t sif_import_journal(sif_sess_t *sess, FILE *f)
+{
+	list_t recs;
+	link_t *link;
+	sif_jrec_t *rec;
+	size_t nrecs = 0;
+	bool torn = false;
+	errno_t rc;
+	int c;
+
+	list_initialize(&recs);
+
+	while (true) {
+		c = fgetc(f);
+		if (c == EOF)
+			break;
+
+		if (c == 'c') {
+			c = fgetc(f);
+			if (c == EOF) {
+				torn = true;
+				break;
+			}
+			if (c != '\n') {
+				rc = EIO;
+				goto error;
+			}
+
+			/* Transaction is complete, apply it */
+			while ((link = list_first(&recs)) != NULL) {
+				rec = list_get_instance(link, sif_jrec_t, lrecs);
+				rc = sif_jrec_apply(sess, rec);
+				sif_jrec_delete(rec);
+				if (rc != EOK)
+					goto error;
+			}
+
+			sess->jrecs += nrecs;
+			nrecs = 0;
+			continue;
+		}
+
+		ungetc(c, f);
+
+		rc = sif_import_jrec(f, &rec);
+		if (rc == EIO && feof(f)) {
+			torn = true;
+			break;
+		}
+		if (rc != EOK)
+			goto error;
+
+		list_append(&rec->lrecs, &recs);
+		++nrecs;
+	}
+
+	if (torn || !list_empty(&recs)) {
+		/* Incomplete transaction */
+		sess->compact = true;
+	}
+
+	rc = EOK;
+error:
+	while ((link = list_first(&recs)) != NULL)
+		sif_jrec_delete(list_get_instance(link, sif_jrec_t, lrecs));
+	return rc;
+}
+
 /** Get first attribute or a node.
  *
  * @param node SIF node
@@ -1033,5 +1737,37 @@ static int sif_attr_cmp(void *a, void *b)
 	return str_cmp(ca, cb);
 }
 
+/** Get key callback for ordered dictionary of nodes.
+ *
+ * @param link Ordered dictionary link of node
+ * @return Pointer to node ID
+ */
+static void *sif_node_getkey(odlink_t *link)
+{
+	return (void *)&odict_get_instance(link, sif_node_t, lnodes)->id;
+}
+
+/** Comparison callback for ordered dictionary of nodes.
+ *
+ * @param a Pointer to ID of first node
+ * @param b Pointer to ID of second node
+ * @return Less than zero, zero or greater than zero, if a < b, a == b, a > b,
+ *         respectively.
+ */
+static int sif_node_cmp(void *a, void *b)
+{
+	size_t ia, ib;
+
+	ia = *(size_t *)a;
+	ib = *(size_t *)b;
+
+	if (ia < ib)
+		return -1;
+	else if (ia == ib)
+		return 0;
+	else
+		return 1;
+}
+
 /** @}
  */
@@ -601,4 +601,140 @@ PCUT_TEST(sif_persist)
 	PCUT_ASSERT_INT_EQUALS(0, rv);
 }
 
+/** Test replaying a journal of many small transactions after reopen. */
+PCUT_TEST(sif_journal)
+{
+	sif_sess_t *sess;
+	sif_node_t *root;
+	sif_node_t *node;
+	sif_trans_t *trans;
+	errno_t rc;
+	int rv;
+	char *fname;
+	char *p;
+	char val[16];
+	int count;
+	int i;
+
+	fname = calloc(L_tmpnam, 1);
+	PCUT_ASSERT_NOT_NULL(fname);
+
+	p = tmpnam(fname);
+	PCUT_ASSERT_TRUE(p == fname);
+
+	rc = sif_create(fname, &sess);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	root = sif_get_root(sess);
+
+	/* Enough transactions to cause compaction in between */
+	for (i = 0; i < 200; i++) {
+		rc = sif_trans_begin(sess, &trans);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+		rc = sif_node_append_child(trans, root, "node", &node);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+		snprintf(val, sizeof(val), "%d", i);
+		rc = sif_node_set_attr(trans, node, "i", val);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+		/* Destroy every other node */
+		if (i % 2 != 0)
+			sif_node_destroy(trans, node);
+
+		rc = sif_trans_end(trans);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	}
+
+	rc = sif_close(sess);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Now reopen the repository */
+
+	rc = sif_open(fname, &sess);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	root = sif_get_root(sess);
+
+	count = 0;
+	node = sif_node_first_child(root);
+	while (node != NULL) {
+		snprintf(val, sizeof(val), "%d", 2 * count);
+		PCUT_ASSERT_INT_EQUALS(0, str_cmp(sif_node_get_attr(node, "i"),
+		    val));
+		++count;
+		node = sif_node_next_child(node);
+	}
+
+	PCUT_ASSERT_INT_EQUALS(100, count);
+
+	rc = sif_close(sess);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rv = remove(fname);
+	PCUT_ASSERT_INT_EQUALS(0, rv);
+}
+
+/** Test that an incomplete transaction at the end of file is discarded. */
+PCUT_TEST(sif_journal_incomplete)
+{
+	sif_sess_t *sess;
+	sif_node_t *root;
+	sif_node_t *node;
+	sif_trans_t *trans;
+	errno_t rc;
+	int rv;
+	char *fname;
+	char *p;
+	FILE *f;
+
+	fname = calloc(L_tmpnam, 1);
+	PCUT_ASSERT_NOT_NULL(fname);
+
+	p = tmpnam(fname);
+	PCUT_ASSERT_TRUE(p == fname);
+
+	rc = sif_create(fname, &sess);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	root = sif_get_root(sess);
+
+	rc = sif_trans_begin(sess, &trans);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = sif_node_append_child(trans, root, "node", &node);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = sif_trans_end(trans);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = sif_close(sess);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Simulate a commit interrupted half-way through */
+	f = fopen(fname, "a");
+	PCUT_ASSERT_NOT_NULL(f);
+	rv = fputs("s[1][a][X]\na[0][2][no", f);
+	PCUT_ASSERT_TRUE(rv >= 0);
+	rv = fclose(f);
+	PCUT_ASSERT_INT_EQUALS(0, rv);
+
+	rc = sif_open(fname, &sess);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	root = sif_get_root(sess);
+
+	node = sif_node_first_child(root);
+	PCUT_ASSERT_NOT_NULL(node);
+	PCUT_ASSERT_NULL(sif_node_get_attr(node, "a"));
+	PCUT_ASSERT_NULL(sif_node_next_child(node));
+
+	rc = sif_close(sess);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rv = remove(fname);
+	PCUT_ASSERT_INT_EQUALS(0, rv);
+}
+
 PCUT_EXPORT(sif);
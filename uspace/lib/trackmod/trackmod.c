@@ -35,6 +35,8 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <mem.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -45,7 +47,9 @@
 
 /** Tunables */
 enum {
-	amp_factor = 16
+	amp_factor = 16,
+	/** Number of samples rendered at once */
+	render_block = 256
 };
 
 /** Standard definitions set in stone */
@@ -279,6 +283,7 @@ static void trackmod_process_instr(trackmod_modplay_t *modplay, size_t i,
 	sidx = instr->key_smp[cell->note] % instr->samples;
 	chan->sample = &instr->sample[sidx];
 	chan->smp_pos = 0;
+	chan->smp_frac = 0;
 	chan->lsmp = 0;
 
 	chan->volume = modplay->chan[i].sample->def_vol;
@@ -297,6 +302,7 @@ static void trackmod_process_keyoff_note(trackmod_modplay_t *modplay, size_t i)
 	chan->sample = NULL;
 	chan->period = 0;
 	chan->smp_pos = 0;
+	chan->smp_frac = 0;
 	chan->lsmp = 0;
 }
 
@@ -901,45 +907,117 @@ static void chan_smp_next_frame(trackmod_chan_t *chan)
 	}
 }
 
-/** Render next sample on channel.
+/** Render a block of samples on channel.
  *
- * @param modplay Module playback
- * @param cidx    Channel number
- * @return        Sample value
+ * Adds @a nsamples samples of the channel to the accumulator. The channel
+ * state does not change within a tick, so the resampling step and volume
+ * are computed once per block. The sample position is kept in 32.32 fixed
+ * point and sample end and loop are only checked once for every run of
+ * samples that stays within them.
+ *
+ * @param modplay  Module playback
+ * @param cidx     Channel number
+ * @param acc      Accumulator
+ * @param nsamples Number of samples to render
  */
-static int trackmod_chan_next_sample(trackmod_modplay_t *modplay,
-    size_t cidx)
+static void trackmod_chan_render(trackmod_modplay_t *modplay, size_t cidx,
+    int32_t *acc, size_t nsamples)
 {
-	int sl, sn;
-	int period, clk;
-	int s;
-
 	trackmod_chan_t *chan = &modplay->chan[cidx];
+	trackmod_sample_t *sample;
+	uint64_t step;
+	uint64_t frac;
+	uint64_t run;
+	size_t end;
+	size_t pos;
+	int vmul;
+	int lsmp;
+	int sl, sn;
+	size_t i;
 
 	if (chan->sample == NULL || chan->period == 0)
-		return 0;
+		return;
+
+	/* Position increment per output sample */
+	step = ((uint64_t)(base_clock / modplay->smp_freq) << 32) /
+	    chan->period;
+	if (step == 0)
+		step = 1;
+
+	vmul = amp_factor * chan->volume;
+	sample = chan->sample;
+	pos = chan->smp_pos;
+	frac = chan->smp_frac;
+	lsmp = chan->lsmp;
+
+	if (sample->loop_type == tl_forward_loop)
+		end = sample->loop_start + sample->loop_len;
+	else
+		end = sample->length;
 
 	/*
 	 * Linear interpolation. Note this is slightly simplified:
 	 * We ignore the half-sample offset and the boundary condition
 	 * at the end of the sample (we should extend with zero).
 	 */
-	sl = (int)chan->lsmp * amp_factor * chan->volume / vol_max;
-	sn = (int)trackmod_sample_get_frame(chan->sample, chan->smp_pos) *
-	    amp_factor * chan->volume / vol_max;
+	sl = lsmp * vmul / vol_max;
+	sn = trackmod_sample_get_frame(sample, pos) * vmul / vol_max;
 
-	period = (int)chan->period;
-	clk = (int)chan->smp_clk;
+	while (nsamples > 0) {
+		/* Samples after which the position is still before the end */
+		run = 0;
+		if (pos < end)
+			run = (((uint64_t)(end - pos) << 32) - frac - 1) /
+			    step;
+		if (run > nsamples)
+			run = nsamples;
+
+		for (i = 0; i < run; i++) {
+			acc[i] += sl + (int)(((int64_t)(sn - sl) *
+			    (int64_t)(frac >> 16)) >> 16);
+			frac += step;
+			if (frac >> 32 != 0) {
+				pos += frac >> 32;
+				frac &= UINT32_MAX;
+				lsmp = trackmod_sample_get_frame(sample,
+				    pos - 1);
+				sl = lsmp * vmul / vol_max;
+				sn = trackmod_sample_get_frame(sample, pos) *
+				    vmul / vol_max;
+			}
+		}
 
-	s = (sl * (period - clk) + sn * clk) / period;
+		acc += run;
+		nsamples -= run;
+		if (nsamples == 0)
+			break;
+
+		/* This sample reaches the end of the sample or loop */
+		*acc++ += sl + (int)(((int64_t)(sn - sl) *
+		    (int64_t)(frac >> 16)) >> 16);
+		--nsamples;
+
+		frac += step;
+		chan->smp_pos = pos;
+		while (chan->sample != NULL && frac >> 32 != 0) {
+			frac -= (uint64_t)1 << 32;
+			chan_smp_next_frame(chan);
+		}
+
+		if (chan->sample == NULL) {
+			chan->smp_frac = frac;
+			return;
+		}
 
-	chan->smp_clk += base_clock / modplay->smp_freq;
-	while (chan->sample != NULL && chan->smp_clk >= chan->period) {
-		chan->smp_clk -= chan->period;
-		chan_smp_next_frame(chan);
+		pos = chan->smp_pos;
+		lsmp = chan->lsmp;
+		sl = lsmp * vmul / vol_max;
+		sn = trackmod_sample_get_frame(sample, pos) * vmul / vol_max;
 	}
 
-	return s;
+	chan->smp_pos = pos;
+	chan->smp_frac = frac;
+	chan->lsmp = lsmp;
 }
 
 /** Render a segment of samples contained entirely within a tick.
@@ -951,23 +1029,30 @@ static int trackmod_chan_next_sample(trackmod_modplay_t *modplay,
 static void get_samples_within_tick(trackmod_modplay_t *modplay,
     void *buffer, size_t bufsize)
 {
+	int32_t acc[render_block];
+	int16_t *out = buffer;
 	size_t nsamples;
+	size_t now;
 	size_t smpidx;
 	size_t chan;
-	int s;
 
 	nsamples = bufsize / modplay->frame_size;
+	modplay->smp += nsamples;
 
-	for (smpidx = 0; smpidx < nsamples; smpidx++) {
-		s = 0;
-		for (chan = 0; chan < modplay->module->channels; chan++) {
-			s += trackmod_chan_next_sample(modplay, chan);
-		}
+	while (nsamples > 0) {
+		now = min(nsamples, (size_t)render_block);
 
-		((int16_t *)buffer)[smpidx] = s;
-	}
+		memset(acc, 0, now * sizeof(int32_t));
+		for (chan = 0; chan < modplay->module->channels; chan++)
+			trackmod_chan_render(modplay, chan, acc, now);
 
-	modplay->smp += nsamples;
+		for (smpidx = 0; smpidx < now; smpidx++)
+			out[smpidx] = max(min(acc[smpidx], INT16_MAX),
+			    INT16_MIN);
+
+		out += now;
+		nsamples -= now;
+	}
 }
 
 /** Render a segment of samples.
@@ -141,8 +141,8 @@ typedef struct {
 	int8_t lsmp;
 	/** Sample position (in frames) */
 	size_t smp_pos;
-	/** Sample position (clock ticks within frame) */
-	size_t smp_clk;
+	/** Sample position (fraction of frame, 32-bit fixed point) */
+	uint32_t smp_frac;
 	/** Current period */
 	unsigned period;
 	/** Period after note was processed, zero if no note */
@@ -37,12 +37,17 @@
 #define _UI_PRIVATE_FILELIST_H
 
 #include <adt/list.h>
+#include <dirent.h>
 #include <gfx/color.h>
 #include <gfx/coord.h>
 #include <ipc/loc.h>
 #include <ui/window.h>
 #include <stdint.h>
 #include <types/ui/filelist.h>
+#include <types/ui/ui.h>
+
+/** Number of directory entries read and merged into file list at once */
+#define UI_FILE_LIST_BATCH_SIZE 128
 
 /** File list entry attributes */
 struct ui_file_list_entry_attr {
@@ -72,6 +77,22 @@ struct ui_file_list_entry {
 	service_id_t svc;
 };
 
+/** File list directory loader.
+ *
+ * Reads the rest of a directory in a background fibril and merges
+ * the entries into the file list batch by batch.
+ */
+typedef struct ui_file_list_loader {
+	/** File list or @c NULL if loading was cancelled */
+	struct ui_file_list *flist;
+	/** UI (for locking) */
+	ui_t *ui;
+	/** Directory being read */
+	DIR *dir;
+	/** Directory path */
+	char *path;
+} ui_file_list_loader_t;
+
 /** File list.
  *
  * Allows browsing files and directories.
@@ -124,6 +145,12 @@ typedef struct ui_file_list {
 
 	/** Directory */
 	char *dir;
+
+	/** Background directory loader or @c NULL if not loading */
+	ui_file_list_loader_t *loader;
+
+	/** Name of entry to seek cursor to as entries arrive or @c NULL */
+	char *seek_name;
 } ui_file_list_t;
 
 extern gfx_coord_t ui_file_list_entry_height(ui_file_list_t *);
@@ -140,6 +167,10 @@ extern bool ui_file_list_is_active(ui_file_list_t *);
 extern void ui_file_list_entry_delete(ui_file_list_entry_t *);
 extern void ui_file_list_clear_entries(ui_file_list_t *);
 extern errno_t ui_file_list_sort(ui_file_list_t *);
+extern void ui_file_list_merge(ui_file_list_t *, ui_file_list_entry_t **,
+    size_t);
+extern bool ui_file_list_seek(ui_file_list_t *);
+extern void ui_file_list_load_stop(ui_file_list_t *);
 extern int ui_file_list_entry_ptr_cmp(const void *, const void *);
 extern ui_file_list_entry_t *ui_file_list_first(ui_file_list_t *);
 extern ui_file_list_entry_t *ui_file_list_last(ui_file_list_t *);
@@ -148,6 +179,8 @@ extern ui_file_list_entry_t *ui_file_list_prev(ui_file_list_entry_t *);
 extern ui_file_list_entry_t *ui_file_list_page_nth_entry(ui_file_list_t *,
     size_t, size_t *);
 extern void ui_file_list_entry_attr_init(ui_file_list_entry_attr_t *);
+extern errno_t ui_file_list_entry_create(ui_file_list_entry_attr_t *,
+    ui_file_list_entry_t **);
 extern errno_t ui_file_list_entry_append(ui_file_list_t *,
     ui_file_list_entry_attr_t *);
 extern void ui_file_list_cursor_move(ui_file_list_t *, ui_file_list_entry_t *,
@@ -42,6 +42,7 @@
 #include <congfx/console.h>
 #include <display.h>
 #include <gfx/context.h>
+#include <gfx/region.h>
 #include <io/kbd_event.h>
 #include <io/pos_event.h>
 #include <memgfx/memgc.h>
@@ -68,6 +69,11 @@ struct ui_window {
 	gfx_context_t *gc;
 	/** Window bitmap (if client-side rendering) */
 	gfx_bitmap_t *bmp;
+	/**
+	 * Presented window surface (if double-buffered surfaces).
+	 * Rendering goes to @c bmp and the two are flipped on update.
+	 */
+	gfx_bitmap_t *fbmp;
 	/** Window memory GC (if client-side rendering) */
 	mem_gc_t *mgc;
 	/** Translating GC (if full screen & server-side rendering) */
@@ -86,8 +92,8 @@ struct ui_window {
 	mem_gc_t *app_mgc;
 	/** Application area GC */
 	gfx_context_t *app_gc;
-	/** Dirty rectangle */
-	gfx_rect_t dirty_rect;
+	/** Dirty region */
+	gfx_region_t dirty;
 	/** UI resource. Ideally this would be in ui_t. */
 	struct ui_resource *res;
 	/** Window decoration */
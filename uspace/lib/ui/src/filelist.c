@@ -36,15 +36,18 @@
 
 #include <dirent.h>
 #include <errno.h>
+#include <fibril.h>
 #include <gfx/render.h>
 #include <gfx/text.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include <str.h>
 #include <ui/control.h>
 #include <ui/filelist.h>
 #include <ui/paint.h>
 #include <ui/resource.h>
 #include <ui/scrollbar.h>
+#include <ui/ui.h>
 #include <vfs/vfs.h>
 #include <qsort.h>
 #include "../private/filelist.h"
@@ -388,6 +391,10 @@ ui_evclaim_t ui_file_list_kbd_event(ui_file_list_t *flist, kbd_event_t *event)
 		return ui_unclaimed;
 
 	if (event->type == KEY_PRESS) {
+		/* User takes over cursor */
+		free(flist->seek_name);
+		flist->seek_name = NULL;
+
 		if ((event->mods & (KM_CTRL | KM_ALT | KM_SHIFT)) == 0) {
 			switch (event->key) {
 			case KC_UP:
@@ -451,6 +458,10 @@ ui_evclaim_t ui_file_list_pos_event(ui_file_list_t *flist, pos_event_t *event)
 		ui_file_list_activate_req(flist);
 
 	if (event->type == POS_PRESS || event->type == POS_DCLICK) {
+		/* User takes over cursor */
+		free(flist->seek_name);
+		flist->seek_name = NULL;
+
 		ui_file_list_inside_rect(flist, &irect);
 
 		/* Did we click on one of the entries? */
@@ -711,13 +722,14 @@ ui_evclaim_t ui_file_list_ctl_pos_event(void *arg, pos_event_t *event)
 	return ui_file_list_pos_event(flist, event);
 }
 
-/** Append new file list entry.
+/** Create file list entry not belonging to any file list.
  *
- * @param flist File list
  * @param attr Entry attributes
+ * @param rentry Place to store pointer to new entry
  * @return EOK on success or an error code
  */
-errno_t ui_file_list_entry_append(ui_file_list_t *flist, ui_file_list_entry_attr_t *attr)
+errno_t ui_file_list_entry_create(ui_file_list_entry_attr_t *attr,
+    ui_file_list_entry_t **rentry)
 {
 	ui_file_list_entry_t *entry;
 
@@ -725,7 +737,6 @@ errno_t ui_file_list_entry_append(ui_file_list_t *flist, ui_file_list_entry_attr
 	if (entry == NULL)
 		return ENOMEM;
 
-	entry->flist = flist;
 	entry->name = str_dup(attr->name);
 	if (entry->name == NULL) {
 		free(entry);
@@ -736,6 +747,37 @@ errno_t ui_file_list_entry_append(ui_file_list_t *flist, ui_file_list_entry_attr
 	entry->isdir = attr->isdir;
 	entry->svc = attr->svc;
 	link_initialize(&entry->lentries);
+
+	*rentry = entry;
+	return EOK;
+}
+
+/** Free file list entry not belonging to any file list.
+ *
+ * @param entry File list entry
+ */
+static void ui_file_list_entry_free(ui_file_list_entry_t *entry)
+{
+	free((char *) entry->name);
+	free(entry);
+}
+
+/** Append new file list entry.
+ *
+ * @param flist File list
+ * @param attr Entry attributes
+ * @return EOK on success or an error code
+ */
+errno_t ui_file_list_entry_append(ui_file_list_t *flist, ui_file_list_entry_attr_t *attr)
+{
+	ui_file_list_entry_t *entry;
+	errno_t rc;
+
+	rc = ui_file_list_entry_create(attr, &entry);
+	if (rc != EOK)
+		return rc;
+
+	entry->flist = flist;
 	list_append(&entry->lentries, &flist->entries);
 	++flist->entries_cnt;
 	return EOK;
@@ -766,6 +808,8 @@ void ui_file_list_clear_entries(ui_file_list_t *flist)
 {
 	ui_file_list_entry_t *entry;
 
+	ui_file_list_load_stop(flist);
+
 	entry = ui_file_list_first(flist);
 	while (entry != NULL) {
 		ui_file_list_entry_delete(entry);
@@ -773,7 +817,155 @@ void ui_file_list_clear_entries(ui_file_list_t *flist)
 	}
 }
 
+/** Read a batch of directory entries.
+ *
+ * Entries are created detached from any file list. Stale entries
+ * which cannot be examined are skipped.
+ *
+ * @param dir Open directory
+ * @param path Directory path
+ * @param batch Array of at least UI_FILE_LIST_BATCH_SIZE entry pointers
+ * @param rcnt Place to store number of entries read
+ * @param reof Place to store @c true iff end of directory was reached
+ * @return EOK on success or an error code. The entries read before
+ *         the error are still returned.
+ */
+static errno_t ui_file_list_read_batch(DIR *dir, const char *path,
+    ui_file_list_entry_t **batch, size_t *rcnt, bool *reof)
+{
+	struct dirent *dirent;
+	vfs_stat_t finfo;
+	ui_file_list_entry_attr_t attr;
+	const char *sep;
+	char *fpath;
+	size_t cnt;
+	errno_t rc;
+	int rv;
+
+	sep = str_cmp(path, "/") == 0 ? "" : "/";
+	cnt = 0;
+	*reof = false;
+
+	while (cnt < UI_FILE_LIST_BATCH_SIZE) {
+		dirent = readdir(dir);
+		if (dirent == NULL) {
+			*reof = true;
+			break;
+		}
+
+		/*
+		 * Use absolute path, the working directory can be changed
+		 * by another file list while we are loading.
+		 */
+		rv = asprintf(&fpath, "%s%s%s", path, sep, dirent->d_name);
+		if (rv < 0) {
+			*rcnt = cnt;
+			return ENOMEM;
+		}
+
+		rc = vfs_stat_path(fpath, &finfo);
+		free(fpath);
+		if (rc != EOK) {
+			/* Possibly a stale entry */
+			continue;
+		}
+
+		ui_file_list_entry_attr_init(&attr);
+		attr.name = dirent->d_name;
+		attr.size = finfo.size;
+		attr.isdir = finfo.is_directory;
+		attr.svc = finfo.service;
+
+		rc = ui_file_list_entry_create(&attr, &batch[cnt]);
+		if (rc != EOK) {
+			*rcnt = cnt;
+			return rc;
+		}
+
+		++cnt;
+	}
+
+	*rcnt = cnt;
+	return EOK;
+}
+
+/** Directory loader fibril.
+ *
+ * Read the rest of the directory and merge it into the file list
+ * one batch at a time, repainting the file list after each batch.
+ *
+ * @param arg Loader (ui_file_list_loader_t *)
+ * @return EOK
+ */
+static errno_t ui_file_list_loader_fibril(void *arg)
+{
+	ui_file_list_loader_t *loader = (ui_file_list_loader_t *)arg;
+	ui_file_list_entry_t *batch[UI_FILE_LIST_BATCH_SIZE];
+	ui_file_list_t *flist;
+	size_t cnt;
+	size_t i;
+	bool eof;
+	errno_t rc;
+
+	do {
+		rc = ui_file_list_read_batch(loader->dir, loader->path, batch,
+		    &cnt, &eof);
+		if (rc != EOK)
+			eof = true;
+
+		/*
+		 * Because we are operating in a different fibril, we must
+		 * lock the UI to ensure mutual exclusion with normal UI events
+		 */
+		ui_lock(loader->ui);
+
+		flist = loader->flist;
+		if (flist == NULL) {
+			/* Loading was cancelled */
+			ui_unlock(loader->ui);
+			for (i = 0; i < cnt; i++)
+				ui_file_list_entry_free(batch[i]);
+			break;
+		}
+
+		ui_file_list_merge(flist, batch, cnt);
+		if (eof)
+			ui_file_list_load_stop(flist);
+
+		ui_file_list_scrollbar_update(flist);
+		(void) ui_file_list_paint(flist);
+		ui_unlock(loader->ui);
+	} while (!eof);
+
+	closedir(loader->dir);
+	free(loader->path);
+	free(loader);
+	return EOK;
+}
+
+/** Stop loading directory in the background.
+ *
+ * Any entries not merged into the file list yet are discarded.
+ *
+ * @param flist File list
+ */
+void ui_file_list_load_stop(ui_file_list_t *flist)
+{
+	if (flist->loader != NULL) {
+		/* The loader fibril will clean up after itself */
+		flist->loader->flist = NULL;
+		flist->loader = NULL;
+	}
+
+	free(flist->seek_name);
+	flist->seek_name = NULL;
+}
+
 /** Read directory into file list entry list.
+ *
+ * The first batch of entries is read immediately. If the directory has
+ * more entries, they are read in the background and merged into the
+ * file list as they arrive.
  *
  * @param flist File list
  * @param dirname Directory path
@@ -781,20 +973,21 @@ void ui_file_list_clear_entries(ui_file_list_t *flist)
  */
 errno_t ui_file_list_read_dir(ui_file_list_t *flist, const char *dirname)
 {
-	DIR *dir;
-	struct dirent *dirent;
-	vfs_stat_t finfo;
+	DIR *dir = NULL;
 	char newdir[256];
 	char *ndir = NULL;
 	ui_file_list_entry_attr_t attr;
-	ui_file_list_entry_t *next;
-	ui_file_list_entry_t *prev;
+	ui_file_list_entry_t *batch[UI_FILE_LIST_BATCH_SIZE];
+	ui_file_list_loader_t *loader;
+	ui_file_list_entry_t *entry;
+	fid_t fid;
 	char *olddn;
-	size_t pg_size;
-	size_t max_idx;
-	size_t i;
+	size_t cnt;
+	bool eof;
 	errno_t rc;
 
+	ui_file_list_load_stop(flist);
+
 	rc = vfs_cwd_set(dirname);
 	if (rc != EOK)
 		return rc;
@@ -807,7 +1000,7 @@ errno_t ui_file_list_read_dir(ui_file_list_t *flist, const char *dirname)
 	if (ndir == NULL)
 		return ENOMEM;
 
-	dir = opendir(".");
+	dir = opendir(ndir);
 	if (dir == NULL) {
 		rc = errno;
 		goto error;
@@ -819,36 +1012,15 @@ errno_t ui_file_list_read_dir(ui_file_list_t *flist, const char *dirname)
 		attr.name = "..";
 		attr.isdir = true;
 
-		rc = ui_file_list_entry_append(flist, &attr);
-		if (rc != EOK)
-			goto error;
-	}
-
-	dirent = readdir(dir);
-	while (dirent != NULL) {
-		rc = vfs_stat_path(dirent->d_name, &finfo);
-		if (rc != EOK) {
-			/* Possibly a stale entry */
-			dirent = readdir(dir);
-			continue;
-		}
-
-		ui_file_list_entry_attr_init(&attr);
-		attr.name = dirent->d_name;
-		attr.size = finfo.size;
-		attr.isdir = finfo.is_directory;
-		attr.svc = finfo.service;
-
-		rc = ui_file_list_entry_append(flist, &attr);
+		rc = ui_file_list_entry_create(&attr, &entry);
 		if (rc != EOK)
 			goto error;
 
-		dirent = readdir(dir);
+		ui_file_list_merge(flist, &entry, 1);
 	}
 
-	closedir(dir);
-
-	rc = ui_file_list_sort(flist);
+	rc = ui_file_list_read_batch(dir, ndir, batch, &cnt, &eof);
+	ui_file_list_merge(flist, batch, cnt);
 	if (rc != EOK)
 		goto error;
 
@@ -858,50 +1030,52 @@ errno_t ui_file_list_read_dir(ui_file_list_t *flist, const char *dirname)
 	flist->page_idx = 0;
 
 	/* Moving up? */
-	if (str_cmp(dirname, "..") == 0) {
+	if (str_cmp(dirname, "..") == 0 && flist->dir != NULL) {
 		/* Get the last component of old path */
 		olddn = str_rchr(flist->dir, '/');
 		if (olddn != NULL && *olddn != '\0') {
 			/* Find corresponding entry */
-			++olddn;
-			next = ui_file_list_next(flist->cursor);
-			while (next != NULL && str_cmp(next->name, olddn) <= 0 &&
-			    next->isdir) {
-				flist->cursor = next;
-				++flist->cursor_idx;
-				next = ui_file_list_next(flist->cursor);
+			flist->seek_name = str_dup(olddn + 1);
+			if (flist->seek_name != NULL &&
+			    (ui_file_list_seek(flist) || eof)) {
+				/* Found or there is nothing more to look at */
+				free(flist->seek_name);
+				flist->seek_name = NULL;
 			}
+		}
+	}
 
-			/* Move page so that cursor is in the center */
-			flist->page = flist->cursor;
-			flist->page_idx = flist->cursor_idx;
-
-			pg_size = ui_file_list_page_size(flist);
-
-			for (i = 0; i < pg_size / 2; i++) {
-				prev = ui_file_list_prev(flist->page);
-				if (prev == NULL)
-					break;
+	if (!eof) {
+		/* Read the rest of the directory in the background */
+		loader = calloc(1, sizeof(ui_file_list_loader_t));
+		if (loader == NULL) {
+			rc = ENOMEM;
+			goto error;
+		}
 
-				flist->page = prev;
-				--flist->page_idx;
-			}
+		loader->path = str_dup(ndir);
+		if (loader->path == NULL) {
+			free(loader);
+			rc = ENOMEM;
+			goto error;
+		}
 
-			/* Make sure page is not beyond the end if possible */
-			if (flist->entries_cnt > pg_size)
-				max_idx = flist->entries_cnt - pg_size;
-			else
-				max_idx = 0;
+		fid = fibril_create(ui_file_list_loader_fibril, loader);
+		if (fid == 0) {
+			free(loader->path);
+			free(loader);
+			rc = ENOMEM;
+			goto error;
+		}
 
-			while (flist->page_idx > 0 && flist->page_idx > max_idx) {
-				prev = ui_file_list_prev(flist->page);
-				if (prev == NULL)
-					break;
+		loader->flist = flist;
+		loader->ui = ui_window_get_ui(flist->window);
+		loader->dir = dir;
+		flist->loader = loader;
 
-				flist->page = prev;
-				--flist->page_idx;
-			}
-		}
+		fibril_add_ready(fid);
+	} else {
+		closedir(dir);
 	}
 
 	free(flist->dir);
@@ -909,6 +1083,8 @@ errno_t ui_file_list_read_dir(ui_file_list_t *flist, const char *dirname)
 
 	return EOK;
 error:
+	free(flist->seek_name);
+	flist->seek_name = NULL;
 	(void) vfs_cwd_set(flist->dir);
 	if (ndir != NULL)
 		free(ndir);
@@ -961,6 +1137,151 @@ errno_t ui_file_list_sort(ui_file_list_t *flist)
 	return EOK;
 }
 
+/** Merge a batch of entries into file list.
+ *
+ * The batch is sorted and merged into the (already sorted) entry list.
+ * Cursor and page stay on the same entries, unless they were at the top
+ * of the list, in which case they stay at the top.
+ *
+ * @param flist File list
+ * @param batch Array of entries not belonging to any file list
+ * @param cnt Number of entries in @a batch
+ */
+void ui_file_list_merge(ui_file_list_t *flist, ui_file_list_entry_t **batch,
+    size_t cnt)
+{
+	ui_file_list_entry_t *entry;
+	bool before_page;
+	bool before_cursor;
+	bool page_top;
+	bool cursor_top;
+	size_t rows;
+	size_t i;
+
+	/* Sort the batch */
+	qsort(batch, cnt, sizeof(ui_file_list_entry_t *),
+	    ui_file_list_entry_ptr_cmp);
+
+	page_top = flist->page == NULL || flist->page_idx == 0;
+	cursor_top = flist->cursor == NULL || flist->cursor_idx == 0;
+	before_page = flist->page != NULL;
+	before_cursor = flist->cursor != NULL;
+
+	/* Merge it with the entry list */
+	entry = ui_file_list_first(flist);
+	for (i = 0; i < cnt; i++) {
+		while (entry != NULL &&
+		    ui_file_list_entry_ptr_cmp(&entry, &batch[i]) <= 0) {
+			if (entry == flist->page)
+				before_page = false;
+			if (entry == flist->cursor)
+				before_cursor = false;
+			entry = ui_file_list_next(entry);
+		}
+
+		batch[i]->flist = flist;
+		if (entry != NULL)
+			list_insert_before(&batch[i]->lentries,
+			    &entry->lentries);
+		else
+			list_append(&batch[i]->lentries, &flist->entries);
+		++flist->entries_cnt;
+
+		/* Keep indices of page and cursor entries valid */
+		if (before_page)
+			++flist->page_idx;
+		if (before_cursor)
+			++flist->cursor_idx;
+	}
+
+	if (page_top) {
+		flist->page = ui_file_list_first(flist);
+		flist->page_idx = 0;
+	}
+
+	if (cursor_top) {
+		flist->cursor = ui_file_list_first(flist);
+		flist->cursor_idx = 0;
+	}
+
+	/* Make sure cursor stays on the page */
+	rows = ui_file_list_page_size(flist);
+	if (rows > 0 && (flist->cursor_idx < flist->page_idx ||
+	    flist->cursor_idx >= flist->page_idx + rows)) {
+		flist->page = flist->cursor;
+		flist->page_idx = flist->cursor_idx;
+	}
+
+	/* Still looking for an entry? */
+	if (flist->seek_name != NULL && ui_file_list_seek(flist)) {
+		free(flist->seek_name);
+		flist->seek_name = NULL;
+	}
+}
+
+/** Seek cursor to the entry named @c flist->seek_name.
+ *
+ * Move cursor to the last directory entry whose name does not sort
+ * after the name sought and move the page so that the cursor is
+ * in the center.
+ *
+ * @param flist File list
+ * @return @c true iff the entry under cursor has the name sought
+ */
+bool ui_file_list_seek(ui_file_list_t *flist)
+{
+	ui_file_list_entry_t *next;
+	ui_file_list_entry_t *prev;
+	size_t pg_size;
+	size_t max_idx;
+	size_t i;
+
+	flist->cursor = ui_file_list_first(flist);
+	flist->cursor_idx = 0;
+	if (flist->cursor == NULL)
+		return false;
+
+	next = ui_file_list_next(flist->cursor);
+	while (next != NULL && str_cmp(next->name, flist->seek_name) <= 0 &&
+	    next->isdir) {
+		flist->cursor = next;
+		++flist->cursor_idx;
+		next = ui_file_list_next(flist->cursor);
+	}
+
+	/* Move page so that cursor is in the center */
+	flist->page = flist->cursor;
+	flist->page_idx = flist->cursor_idx;
+
+	pg_size = ui_file_list_page_size(flist);
+
+	for (i = 0; i < pg_size / 2; i++) {
+		prev = ui_file_list_prev(flist->page);
+		if (prev == NULL)
+			break;
+
+		flist->page = prev;
+		--flist->page_idx;
+	}
+
+	/* Make sure page is not beyond the end if possible */
+	if (flist->entries_cnt > pg_size)
+		max_idx = flist->entries_cnt - pg_size;
+	else
+		max_idx = 0;
+
+	while (flist->page_idx > 0 && flist->page_idx > max_idx) {
+		prev = ui_file_list_prev(flist->page);
+		if (prev == NULL)
+			break;
+
+		flist->page = prev;
+		--flist->page_idx;
+	}
+
+	return str_cmp(flist->cursor->name, flist->seek_name) == 0;
+}
+
 /** Compare two file list entries indirectly referenced by pointers.
  *
  * @param pa Pointer to pointer to first entry
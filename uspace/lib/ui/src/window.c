@@ -210,6 +210,7 @@ errno_t ui_window_create(ui_t *ui, ui_wnd_params_t *params,
 	gfx_bitmap_params_t bparams;
 	gfx_bitmap_alloc_t alloc;
 	gfx_bitmap_t *bmp = NULL;
+	gfx_bitmap_t *fbmp = NULL;
 	gfx_coord2_t off;
 	mem_gc_t *memgc = NULL;
 	xlate_gc_t *xgc = NULL;
@@ -303,6 +304,13 @@ errno_t ui_window_create(ui_t *ui, ui_wnd_params_t *params,
 	/* Console does not support direct output */
 	if (ui->display != NULL)
 		bparams.flags |= bmpf_direct_output;
+#else
+	/*
+	 * With display server, use two surfaces which the server
+	 * presents without copying and flip them on every update.
+	 */
+	if (ui->display != NULL)
+		bparams.flags |= bmpf_surface;
 #endif
 
 	/* Move rectangle so that top-left corner is 0,0 */
@@ -312,6 +320,12 @@ errno_t ui_window_create(ui_t *ui, ui_wnd_params_t *params,
 	if (rc != EOK)
 		goto error;
 
+	if ((bparams.flags & bmpf_surface) != 0) {
+		rc = gfx_bitmap_create(gc, &bparams, NULL, &fbmp);
+		if (rc != EOK)
+			goto error;
+	}
+
 	/* Create memory GC */
 	rc = gfx_bitmap_get_alloc(bmp, &alloc);
 	if (rc != EOK) {
@@ -327,6 +341,7 @@ errno_t ui_window_create(ui_t *ui, ui_wnd_params_t *params,
 	}
 
 	window->bmp = bmp;
+	window->fbmp = fbmp;
 	window->mgc = memgc;
 	window->gc = mem_gc_get_ctx(memgc);
 	window->realgc = gc;
@@ -393,6 +408,8 @@ error:
 		mem_gc_delete(memgc);
 	if (xgc != NULL)
 		xlate_gc_delete(xgc);
+	if (fbmp != NULL)
+		gfx_bitmap_destroy(fbmp);
 	if (bmp != NULL)
 		gfx_bitmap_destroy(bmp);
 	if (dgc != NULL)
@@ -426,6 +443,8 @@ void ui_window_destroy(ui_window_t *window)
 		mem_gc_delete(window->mgc);
 		window->gc = NULL;
 	}
+	if (window->fbmp != NULL)
+		gfx_bitmap_destroy(window->fbmp);
 	if (window->bmp != NULL)
 		gfx_bitmap_destroy(window->bmp);
 	if (window->dwindow != NULL)
@@ -506,6 +525,7 @@ errno_t ui_window_size_change(ui_window_t *window, gfx_rect_t *rect,
 	gfx_rect_t arect;
 	gfx_bitmap_t *app_bmp = NULL;
 	gfx_bitmap_t *win_bmp = NULL;
+	gfx_bitmap_t *win_fbmp = NULL;
 	gfx_bitmap_params_t app_params;
 	gfx_bitmap_params_t win_params;
 	gfx_bitmap_alloc_t app_alloc;
@@ -529,12 +549,21 @@ errno_t ui_window_size_change(ui_window_t *window, gfx_rect_t *rect,
 		assert(window->bmp != NULL);
 		gfx_bitmap_params_init(&win_params);
 		win_params.rect = nrect;
+		if (window->fbmp != NULL)
+			win_params.flags |= bmpf_surface;
 
 		rc = gfx_bitmap_create(window->realgc, &win_params, NULL,
 		    &win_bmp);
 		if (rc != EOK)
 			goto error;
 
+		if (window->fbmp != NULL) {
+			rc = gfx_bitmap_create(window->realgc, &win_params,
+			    NULL, &win_fbmp);
+			if (rc != EOK)
+				goto error;
+		}
+
 		rc = gfx_bitmap_get_alloc(win_bmp, &win_alloc);
 		if (rc != EOK)
 			goto error;
@@ -608,6 +637,11 @@ errno_t ui_window_size_change(ui_window_t *window, gfx_rect_t *rect,
 
 		gfx_bitmap_destroy(window->bmp);
 		window->bmp = win_bmp;
+
+		if (window->fbmp != NULL) {
+			gfx_bitmap_destroy(window->fbmp);
+			window->fbmp = win_fbmp;
+		}
 	}
 
 	window->rect = nrect;
@@ -627,6 +661,8 @@ errno_t ui_window_size_change(ui_window_t *window, gfx_rect_t *rect,
 error:
 	if (app_bmp != NULL)
 		gfx_bitmap_destroy(app_bmp);
+	if (win_fbmp != NULL)
+		gfx_bitmap_destroy(win_fbmp);
 	if (win_bmp != NULL)
 		gfx_bitmap_destroy(win_bmp);
 	return rc;
@@ -1325,10 +1361,67 @@ void ui_window_def_unfocus(ui_window_t *window, unsigned nfocus)
 static void ui_window_invalidate(void *arg, gfx_rect_t *rect)
 {
 	ui_window_t *window = (ui_window_t *) arg;
-	gfx_rect_t env;
 
-	gfx_rect_envelope(&window->dirty_rect, rect, &env);
-	window->dirty_rect = env;
+	gfx_region_add_rect(&window->dirty, rect);
+}
+
+/** Flip window surfaces.
+ *
+ * Present the surface we have been rendering into and continue rendering
+ * into the other one. The display server has stopped reading the other
+ * surface once it has finished rendering the new one. The other surface
+ * lags exactly by the damage of the presented frame, which is copied
+ * over to bring it up to date.
+ *
+ * @param window Window
+ */
+static void ui_window_flip(ui_window_t *window)
+{
+	gfx_bitmap_alloc_t falloc;
+	gfx_bitmap_alloc_t balloc;
+	gfx_bitmap_t *bmp;
+	gfx_rect_t brect;
+	gfx_rect_t crect;
+	uint8_t *src;
+	uint8_t *dst;
+	gfx_coord_t y;
+	size_t i;
+
+	if (gfx_region_is_empty(&window->dirty))
+		return;
+
+	for (i = 0; i < window->dirty.count; i++) {
+		(void) gfx_bitmap_render(window->bmp, &window->dirty.rects[i],
+		    &window->dpos);
+	}
+
+	bmp = window->fbmp;
+	window->fbmp = window->bmp;
+	window->bmp = bmp;
+
+	if (gfx_bitmap_get_alloc(window->fbmp, &falloc) != EOK ||
+	    gfx_bitmap_get_alloc(window->bmp, &balloc) != EOK) {
+		gfx_region_init(&window->dirty);
+		return;
+	}
+
+	gfx_rect_rtranslate(&window->rect.p0, &window->rect, &brect);
+
+	for (i = 0; i < window->dirty.count; i++) {
+		gfx_rect_clip(&window->dirty.rects[i], &brect, &crect);
+
+		for (y = crect.p0.y; y < crect.p1.y; y++) {
+			src = (uint8_t *)falloc.pixels + y * falloc.pitch +
+			    crect.p0.x * sizeof(uint32_t);
+			dst = (uint8_t *)balloc.pixels + y * balloc.pitch +
+			    crect.p0.x * sizeof(uint32_t);
+			memcpy(dst, src, (crect.p1.x - crect.p0.x) *
+			    sizeof(uint32_t));
+		}
+	}
+
+	mem_gc_set_alloc(window->mgc, &balloc);
+	gfx_region_init(&window->dirty);
 }
 
 /** Window update callback
@@ -1338,16 +1431,23 @@ static void ui_window_invalidate(void *arg, gfx_rect_t *rect)
 static void ui_window_update(void *arg)
 {
 	ui_window_t *window = (ui_window_t *) arg;
+	size_t i;
 
-	if (!gfx_rect_is_empty(&window->dirty_rect)) {
-		(void) gfx_bitmap_render(window->bmp, &window->dirty_rect,
+	if (window->fbmp != NULL) {
+		ui_window_flip(window);
+		return;
+	}
+
+	/*
+	 * Render each dirty rectangle separately so that only damaged
+	 * areas are sent to the display server.
+	 */
+	for (i = 0; i < window->dirty.count; i++) {
+		(void) gfx_bitmap_render(window->bmp, &window->dirty.rects[i],
 		    &window->dpos);
 	}
 
-	window->dirty_rect.p0.x = 0;
-	window->dirty_rect.p0.y = 0;
-	window->dirty_rect.p1.x = 0;
-	window->dirty_rect.p1.y = 0;
+	gfx_region_init(&window->dirty);
 }
 
 /** Window cursor get position callback
@@ -1063,6 +1063,78 @@ PCUT_TEST(sort)
 	ui_destroy(ui);
 }
 
+/** ui_file_list_merge() merges a batch of entries into sorted position */
+PCUT_TEST(merge)
+{
+	ui_t *ui;
+	ui_window_t *window;
+	ui_wnd_params_t params;
+	ui_file_list_t *flist;
+	ui_file_list_entry_t *entry;
+	ui_file_list_entry_t *batch[2];
+	ui_file_list_entry_attr_t attr;
+	errno_t rc;
+
+	rc = ui_create_disp(NULL, &ui);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	ui_wnd_params_init(&params);
+	params.caption = "Test";
+
+	rc = ui_window_create(ui, &params, &window);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = ui_file_list_create(window, true, &flist);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	ui_file_list_entry_attr_init(&attr);
+
+	attr.name = "b";
+	rc = ui_file_list_entry_append(flist, &attr);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	attr.name = "d";
+	rc = ui_file_list_entry_append(flist, &attr);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Page at the top, cursor on "d" */
+	flist->page = ui_file_list_first(flist);
+	flist->page_idx = 0;
+	flist->cursor = ui_file_list_last(flist);
+	flist->cursor_idx = 1;
+
+	attr.name = "c";
+	rc = ui_file_list_entry_create(&attr, &batch[0]);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	attr.name = "a";
+	rc = ui_file_list_entry_create(&attr, &batch[1]);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	ui_file_list_merge(flist, batch, 2);
+
+	PCUT_ASSERT_INT_EQUALS(4, flist->entries_cnt);
+
+	entry = ui_file_list_first(flist);
+	PCUT_ASSERT_STR_EQUALS("a", entry->name);
+	entry = ui_file_list_next(entry);
+	PCUT_ASSERT_STR_EQUALS("b", entry->name);
+	entry = ui_file_list_next(entry);
+	PCUT_ASSERT_STR_EQUALS("c", entry->name);
+	entry = ui_file_list_next(entry);
+	PCUT_ASSERT_STR_EQUALS("d", entry->name);
+
+	/* Page stays at the top, cursor stays on "d" */
+	PCUT_ASSERT_EQUALS(ui_file_list_first(flist), flist->page);
+	PCUT_ASSERT_INT_EQUALS(0, flist->page_idx);
+	PCUT_ASSERT_STR_EQUALS("d", flist->cursor->name);
+	PCUT_ASSERT_INT_EQUALS(3, flist->cursor_idx);
+
+	ui_file_list_destroy(flist);
+	ui_window_destroy(window);
+	ui_destroy(ui);
+}
+
 /** ui_file_list_entry_ptr_cmp compares two indirectly referenced entries */
 PCUT_TEST(entry_ptr_cmp)
 {
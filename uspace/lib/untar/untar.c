@@ -32,14 +32,81 @@
 /** @file
  */
 
+#include <adt/list.h>
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <gzip.h>
+#include <inflate.h>
+#include <macros.h>
+#include <mem.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <str.h>
 #include <str_error.h>
 #include <vfs/vfs.h>
 #include "private/tar.h"
 #include "untar.h"
 
+/** Number of fibrils writing extracted files */
+#define UNTAR_WRITERS  4
+
+/** Largest file handed over to a writer fibril */
+#define UNTAR_JOB_MAX  (256 * 1024)
+
+/** Limit on the amount of file data waiting for the writers */
+#define UNTAR_QUEUE_MAX  (2 * 1024 * 1024)
+
+/** Size of the input buffer for compressed archives */
+#define UNTAR_IBUF_SIZE  65536
+
+/** Size of the chunks in which large files are written */
+#define UNTAR_CHUNK_SIZE  65536
+
+/** File waiting to be written by a writer fibril */
+typedef struct {
+	/** Link to untar_t.jobs */
+	link_t ljobs;
+	/** File name */
+	char filename[100];
+	/** File contents */
+	void *data;
+	/** File size */
+	size_t size;
+} untar_job_t;
+
+/** Extraction state */
+typedef struct {
+	/** Archive */
+	tar_file_t *tar;
+	/** Input buffer */
+	uint8_t *ibuf;
+	/** Position of the first unused byte in the input buffer */
+	size_t ipos;
+	/** Number of valid bytes in the input buffer */
+	size_t ilen;
+	/** The whole archive has been read */
+	bool eof;
+	/** Inflate state if the archive is compressed, otherwise @c NULL */
+	inflate_t *inflate;
+
+	/** Synchronizes access to the following members */
+	fibril_mutex_t lock;
+	/** Signalled when the following members change */
+	fibril_condvar_t cv;
+	/** Files waiting to be written (untar_job_t) */
+	list_t jobs;
+	/** Size of the files queued or being written */
+	size_t queued;
+	/** Number of running writer fibrils */
+	unsigned writers;
+	/** No more jobs will be queued */
+	bool done;
+	/** First error encountered by a writer fibril */
+	errno_t error;
+} untar_t;
+
 static size_t get_block_count(size_t bytes)
 {
 	return (bytes + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE;
@@ -70,15 +137,119 @@ static void tar_report(tar_file_t *tar, const char *fmt, ...)
 	va_end(args);
 }
 
-static errno_t tar_skip_blocks(tar_file_t *tar, size_t valid_data_size)
+/** Prepare reading the archive.
+ *
+ * The first block is read to determine whether the archive is
+ * GZIP-compressed.
+ *
+ * @param untar Extraction state
+ * @return EOK on success, ENOMEM if out of memory, EINVAL if
+ *         the GZIP header is invalid
+ */
+static errno_t untar_input_init(untar_t *untar)
+{
+	size_t hdr_size;
+	size_t nread;
+	errno_t rc;
+
+	untar->ibuf = malloc(UNTAR_IBUF_SIZE);
+	if (untar->ibuf == NULL)
+		return ENOMEM;
+
+	untar->ilen = tar_read(untar->tar, untar->ibuf, TAR_BLOCK_SIZE);
+	untar->ipos = 0;
+	untar->eof = untar->ilen < TAR_BLOCK_SIZE;
+
+	if (untar->ilen < 2 || untar->ibuf[0] != 0x1f ||
+	    untar->ibuf[1] != 0x8b)
+		return EOK;
+
+	/* Read until the whole header is available */
+	while (true) {
+		rc = gzip_header_size(untar->ibuf, untar->ilen, &hdr_size);
+		if (rc == EOK)
+			break;
+
+		if (rc != ELIMIT || untar->eof || untar->ilen == UNTAR_IBUF_SIZE)
+			return EINVAL;
+
+		nread = tar_read(untar->tar, untar->ibuf + untar->ilen,
+		    UNTAR_IBUF_SIZE - untar->ilen);
+		untar->eof = nread < UNTAR_IBUF_SIZE - untar->ilen;
+		untar->ilen += nread;
+	}
+
+	rc = inflate_init(&untar->inflate);
+	if (rc != EOK)
+		return rc;
+
+	untar->ipos = hdr_size;
+	return EOK;
+}
+
+/** Read data from the archive, decompressing them if needed.
+ *
+ * @param untar Extraction state
+ * @param data Buffer for the data
+ * @param size Number of bytes to read
+ * @return EOK on success, EIO if the archive ends prematurely,
+ *         other error code if decompression failed
+ */
+static errno_t untar_read(untar_t *untar, void *data, size_t size)
+{
+	uint8_t *dp = data;
+	size_t consumed, produced;
+	size_t n;
+	errno_t rc;
+
+	if (untar->inflate == NULL) {
+		n = min(size, untar->ilen - untar->ipos);
+		memcpy(dp, untar->ibuf + untar->ipos, n);
+		untar->ipos += n;
+
+		if (n < size && tar_read(untar->tar, dp + n, size - n) !=
+		    size - n)
+			return EIO;
+
+		return EOK;
+	}
+
+	while (size > 0) {
+		rc = inflate_step(untar->inflate, untar->ibuf + untar->ipos,
+		    untar->ilen - untar->ipos, &consumed, dp, size, &produced);
+		untar->ipos += consumed;
+		dp += produced;
+		size -= produced;
+
+		if (rc == EOK)
+			return size > 0 ? EIO : EOK;
+		if (rc != EAGAIN)
+			return rc;
+
+		if (size > 0 && produced == 0 && untar->ipos == untar->ilen) {
+			/* Decompressor needs more input */
+			if (untar->eof)
+				return EIO;
+
+			untar->ilen = tar_read(untar->tar, untar->ibuf,
+			    UNTAR_IBUF_SIZE);
+			untar->ipos = 0;
+			untar->eof = untar->ilen < UNTAR_IBUF_SIZE;
+		}
+	}
+
+	return EOK;
+}
+
+static errno_t tar_skip_blocks(untar_t *untar, size_t valid_data_size)
 {
 	size_t blocks_to_read = get_block_count(valid_data_size);
 
 	while (blocks_to_read > 0) {
 		uint8_t block[TAR_BLOCK_SIZE];
-		size_t actually_read = tar_read(tar, block, TAR_BLOCK_SIZE);
-		if (actually_read != TAR_BLOCK_SIZE)
-			return errno;
+		errno_t rc = untar_read(untar, block, TAR_BLOCK_SIZE);
+		if (rc != EOK)
+			return rc;
 
 		blocks_to_read--;
 	}
@@ -86,82 +257,354 @@ static errno_t tar_skip_blocks(tar_file_t *tar, size_t valid_data_size)
 	return EOK;
 }
 
-static errno_t tar_handle_normal_file(tar_file_t *tar,
-    const tar_header_t *header)
+/** Create file and allocate space for its contents.
+ *
+ * An existing file is truncated to the new size.
+ *
+ * @param untar Extraction state
+ * @param filename File name
+ * @param size File size
+ * @param rfd Place to store file descriptor of the open file
+ * @return EOK on success or an error code
+ */
+static errno_t untar_file_create(untar_t *untar, const char *filename,
+    size_t size, int *rfd)
 {
+	int fd;
+	errno_t rc;
+
 	// FIXME: create the directory first
 
-	FILE *file = fopen(header->filename, "wb");
-	if (file == NULL) {
-		tar_report(tar, "Failed to create %s: %s.\n", header->filename,
-		    str_error(errno));
-		return errno;
+	rc = vfs_lookup_open(filename, WALK_REGULAR | WALK_MAY_CREATE,
+	    MODE_WRITE, &fd);
+	if (rc != EOK) {
+		tar_report(untar->tar, "Failed to create %s: %s.\n", filename,
+		    str_error(rc));
+		return rc;
+	}
+
+	rc = vfs_resize(fd, size);
+	if (rc != EOK) {
+		tar_report(untar->tar, "Failed to allocate %s: %s.\n",
+		    filename, str_error(rc));
+		vfs_put(fd);
+		return rc;
+	}
+
+	*rfd = fd;
+	return EOK;
+}
+
+/** Write file contents.
+ *
+ * @param untar Extraction state
+ * @param filename File name
+ * @param data File contents
+ * @param size File size
+ * @return EOK on success or an error code
+ */
+static errno_t untar_file_write(untar_t *untar, const char *filename,
+    const void *data, size_t size)
+{
+	aoff64_t pos = 0;
+	size_t nwritten;
+	int fd;
+	errno_t rc;
+
+	rc = untar_file_create(untar, filename, size, &fd);
+	if (rc != EOK)
+		return rc;
+
+	rc = vfs_write(fd, &pos, data, size, &nwritten);
+	if (rc != EOK) {
+		tar_report(untar->tar, "Failed to write to %s: %s.\n",
+		    filename, str_error(rc));
+		vfs_put(fd);
+		return rc;
+	}
+
+	return vfs_put(fd);
+}
+
+/** Writer fibril.
+ *
+ * Writes queued files until there are no more.
+ *
+ * @param arg Extraction state
+ * @return EOK
+ */
+static errno_t untar_writer(void *arg)
+{
+	untar_t *untar = (untar_t *) arg;
+	untar_job_t *job;
+	errno_t rc;
+
+	fibril_mutex_lock(&untar->lock);
+
+	while (true) {
+		while (list_empty(&untar->jobs) && !untar->done)
+			fibril_condvar_wait(&untar->cv, &untar->lock);
+
+		if (list_empty(&untar->jobs))
+			break;
+
+		job = list_get_instance(list_first(&untar->jobs), untar_job_t,
+		    ljobs);
+		list_remove(&job->ljobs);
+
+		rc = untar->error;
+		fibril_mutex_unlock(&untar->lock);
+
+		/* After an error, only drain the queue */
+		if (rc == EOK) {
+			rc = untar_file_write(untar, job->filename, job->data,
+			    job->size);
+		}
+
+		fibril_mutex_lock(&untar->lock);
+
+		if (rc != EOK && untar->error == EOK)
+			untar->error = rc;
+
+		untar->queued -= job->size;
+		fibril_condvar_broadcast(&untar->cv);
+
+		free(job->data);
+		free(job);
+	}
+
+	untar->writers--;
+	fibril_condvar_broadcast(&untar->cv);
+	fibril_mutex_unlock(&untar->lock);
+	return EOK;
+}
+
+/** Start writer fibrils.
+ *
+ * If no writer fibril can be created, files are written by the caller.
+ *
+ * @param untar Extraction state
+ */
+static void untar_writers_start(untar_t *untar)
+{
+	fid_t fid;
+
+	for (unsigned i = 0; i < UNTAR_WRITERS; i++) {
+		fid = fibril_create(untar_writer, untar);
+		if (fid == 0)
+			break;
+
+		untar->writers++;
+		fibril_add_ready(fid);
 	}
+}
+
+/** Wait for writer fibrils to write all queued files and terminate.
+ *
+ * @param untar Extraction state
+ * @return First error encountered by a writer fibril or EOK
+ */
+static errno_t untar_writers_stop(untar_t *untar)
+{
+	errno_t rc;
+
+	fibril_mutex_lock(&untar->lock);
+
+	untar->done = true;
+	fibril_condvar_broadcast(&untar->cv);
+
+	while (untar->writers > 0)
+		fibril_condvar_wait(&untar->cv, &untar->lock);
+
+	rc = untar->error;
+	fibril_mutex_unlock(&untar->lock);
+	return rc;
+}
+
+/** Read file contents and queue the file for a writer fibril.
+ *
+ * Waits while too much data is already queued, so that memory usage
+ * stays bounded.
+ *
+ * @param untar Extraction state
+ * @param header File header
+ * @return EOK on success or an error code
+ */
+static errno_t tar_queue_normal_file(untar_t *untar,
+    const tar_header_t *header)
+{
+	untar_job_t *job;
+	size_t blocks = get_block_count(header->size);
+	errno_t rc;
+
+	fibril_mutex_lock(&untar->lock);
+
+	while (untar->queued > 0 &&
+	    untar->queued + header->size > UNTAR_QUEUE_MAX &&
+	    untar->error == EOK)
+		fibril_condvar_wait(&untar->cv, &untar->lock);
+
+	rc = untar->error;
+	if (rc == EOK)
+		untar->queued += header->size;
+
+	fibril_mutex_unlock(&untar->lock);
 
-	errno_t rc = EOK;
+	if (rc != EOK)
+		return rc;
+
+	job = calloc(1, sizeof(untar_job_t));
+	if (job == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	/* Whole blocks are read, the padding is discarded with the job */
+	job->data = malloc(max(blocks * TAR_BLOCK_SIZE, 1));
+	if (job->data == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	rc = untar_read(untar, job->data, blocks * TAR_BLOCK_SIZE);
+	if (rc != EOK) {
+		tar_report(untar->tar, "Failed to read %s: %s.\n",
+		    header->filename, str_error(rc));
+		goto error;
+	}
+
+	str_cpy(job->filename, sizeof(job->filename), header->filename);
+	job->size = header->size;
+
+	fibril_mutex_lock(&untar->lock);
+	list_append(&job->ljobs, &untar->jobs);
+	fibril_condvar_broadcast(&untar->cv);
+	fibril_mutex_unlock(&untar->lock);
+	return EOK;
+error:
+	if (job != NULL)
+		free(job->data);
+	free(job);
+
+	fibril_mutex_lock(&untar->lock);
+	untar->queued -= header->size;
+	fibril_condvar_broadcast(&untar->cv);
+	fibril_mutex_unlock(&untar->lock);
+	return rc;
+}
+
+static errno_t tar_handle_normal_file(untar_t *untar,
+    const tar_header_t *header)
+{
+	uint8_t *buf;
 	size_t bytes_remaining = header->size;
-	size_t blocks = get_block_count(bytes_remaining);
+	size_t to_read, to_write;
+	size_t nwritten;
+	aoff64_t pos = 0;
+	int fd;
+	errno_t rc;
 
-	while (blocks > 0) {
-		uint8_t block[TAR_BLOCK_SIZE];
-		size_t actually_read = tar_read(tar, block, TAR_BLOCK_SIZE);
-		if (actually_read != TAR_BLOCK_SIZE) {
-			rc = errno;
-			tar_report(tar, "Failed to read block for %s: %s.\n",
+	/* Small files are written by the writer fibrils */
+	if (untar->writers > 0 && header->size <= UNTAR_JOB_MAX)
+		return tar_queue_normal_file(untar, header);
+
+	buf = malloc(UNTAR_CHUNK_SIZE);
+	if (buf == NULL)
+		return ENOMEM;
+
+	rc = untar_file_create(untar, header->filename, header->size, &fd);
+	if (rc != EOK) {
+		free(buf);
+		return rc;
+	}
+
+	while (bytes_remaining > 0) {
+		to_write = min(bytes_remaining, UNTAR_CHUNK_SIZE);
+		to_read = get_block_count(to_write) * TAR_BLOCK_SIZE;
+
+		rc = untar_read(untar, buf, to_read);
+		if (rc != EOK) {
+			tar_report(untar->tar,
+			    "Failed to read block for %s: %s.\n",
 			    header->filename, str_error(rc));
 			break;
 		}
 
-		size_t to_write = TAR_BLOCK_SIZE;
-		if (bytes_remaining < TAR_BLOCK_SIZE)
-			to_write = bytes_remaining;
-
-		size_t actually_written = fwrite(block, 1, to_write, file);
-		if (actually_written != to_write) {
-			rc = errno;
-			tar_report(tar, "Failed to write to %s: %s.\n",
+		rc = vfs_write(fd, &pos, buf, to_write, &nwritten);
+		if (rc != EOK) {
+			tar_report(untar->tar, "Failed to write to %s: %s.\n",
 			    header->filename, str_error(rc));
 			break;
 		}
 
-		blocks--;
-		bytes_remaining -= TAR_BLOCK_SIZE;
+		bytes_remaining -= to_write;
 	}
 
-	fclose(file);
+	if (rc == EOK)
+		rc = vfs_put(fd);
+	else
+		vfs_put(fd);
+
+	free(buf);
 	return rc;
 }
 
-static errno_t tar_handle_directory(tar_file_t *tar, const tar_header_t *header)
+static errno_t tar_handle_directory(untar_t *untar, const tar_header_t *header)
 {
 	errno_t rc = vfs_link_path(header->filename, KIND_DIRECTORY, NULL);
 	if (rc != EOK) {
 		if (rc != EEXIST) {
-			tar_report(tar, "Failed to create directory %s: %s.\n",
+			tar_report(untar->tar,
+			    "Failed to create directory %s: %s.\n",
 			    header->filename, str_error(rc));
 			return rc;
 		}
 	}
 
-	return tar_skip_blocks(tar, header->size);
+	return tar_skip_blocks(untar, header->size);
 }
 
+/** Extract archive.
+ *
+ * The archive may be GZIP-compressed. Headers and file data are read by
+ * the calling fibril, while files small enough are created and written
+ * by several writer fibrils in parallel.
+ *
+ * @param tar Archive
+ * @return EOK on success or an error code if the archive cannot be opened
+ */
 int untar(tar_file_t *tar)
 {
+	untar_t state;
+
 	int rc = tar_open(tar);
 	if (rc != EOK) {
 		tar_report(tar, "Failed to open: %s.\n", str_error(rc));
 		return rc;
 	}
 
+	memset(&state, 0, sizeof(state));
+	state.tar = tar;
+	fibril_mutex_initialize(&state.lock);
+	fibril_condvar_initialize(&state.cv);
+	list_initialize(&state.jobs);
+
+	rc = untar_input_init(&state);
+	if (rc != EOK) {
+		tar_report(tar, "Failed to read archive: %s.\n", str_error(rc));
+		goto out;
+	}
+
+	untar_writers_start(&state);
+
 	while (true) {
 		tar_header_raw_t header_raw;
-		size_t header_ok = tar_read(tar, &header_raw, sizeof(header_raw));
-		if (header_ok != sizeof(header_raw))
+		errno_t rc = untar_read(&state, &header_raw, sizeof(header_raw));
+		if (rc != EOK)
 			break;
 
 		tar_header_t header;
-		errno_t rc = tar_header_parse(&header, &header_raw);
+		rc = tar_header_parse(&header, &header_raw);
 		if (rc == EEMPTY)
 			continue;
 
@@ -172,13 +615,13 @@ int untar(tar_file_t *tar)
 
 		switch (header.type) {
 		case TAR_TYPE_DIRECTORY:
-			rc = tar_handle_directory(tar, &header);
+			rc = tar_handle_directory(&state, &header);
 			break;
 		case TAR_TYPE_NORMAL:
-			rc = tar_handle_normal_file(tar, &header);
+			rc = tar_handle_normal_file(&state, &header);
 			break;
 		default:
-			rc = tar_skip_blocks(tar, header.size);
+			rc = tar_skip_blocks(&state, header.size);
 			break;
 		}
 
@@ -186,8 +629,13 @@ int untar(tar_file_t *tar)
 			break;
 	}
 
+	(void) untar_writers_stop(&state);
+	rc = EOK;
+out:
+	inflate_destroy(state.inflate);
+	free(state.ibuf);
 	tar_close(tar);
-	return EOK;
+	return rc;
 }
 
 /** @}
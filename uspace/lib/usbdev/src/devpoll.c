@@ -48,6 +48,7 @@
 #include <errno.h>
 #include <fibril.h>
 #include <fibril_synch.h>
+#include <mem.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <str_error.h>
@@ -123,11 +124,28 @@ static errno_t polling_fibril(void *arg)
 		    polling->request_size, pipe->desc.max_transfer_size);
 	}
 
+	/*
+	 * Poll into a buffer satisfying the constraints of the host
+	 * controller, so that the transfers need neither a temporary DMA
+	 * buffer nor a bounce buffer. The reports are then copied to the
+	 * buffer of the user.
+	 */
+	void *dma_buffer = usb_pipe_alloc_buffer(pipe, polling->request_size);
+
 	size_t failed_attempts = 0;
 	while (failed_attempts <= polling->max_failures) {
 		size_t actual_size;
-		const errno_t rc = usb_pipe_read(pipe, polling->buffer,
-		    polling->request_size, &actual_size);
+		errno_t rc;
+		if (dma_buffer) {
+			rc = usb_pipe_read_dma(pipe, dma_buffer, dma_buffer,
+			    polling->request_size, &actual_size);
+			if (rc == EOK)
+				memcpy(polling->buffer, dma_buffer,
+				    actual_size);
+		} else {
+			rc = usb_pipe_read(pipe, polling->buffer,
+			    polling->request_size, &actual_size);
+		}
 
 		if (rc == EOK) {
 			if (polling->debug > 1) {
@@ -189,6 +207,9 @@ static errno_t polling_fibril(void *arg)
 		fibril_usleep(polling->delay);
 	}
 
+	if (dma_buffer)
+		usb_pipe_free_buffer(pipe, dma_buffer);
+
 	const bool failed = failed_attempts > 0;
 
 	if (polling->on_polling_end)
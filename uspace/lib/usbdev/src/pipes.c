@@ -141,6 +141,8 @@ static errno_t transfer_wrap_dma(transfer_t *t, void *buf, size_t size)
 	}
 
 	void *dma_buf = usb_pipe_alloc_buffer(t->pipe, size);
+	if (!dma_buf)
+		return ENOMEM;
 	setup_dma_buffer(t, dma_buf, dma_buf, size);
 
 	if (t->dir == USB_DIRECTION_OUT)
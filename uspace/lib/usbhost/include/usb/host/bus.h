@@ -122,6 +122,7 @@ struct bus_ops {
 	/* Operations on batch */
 	int (*batch_schedule)(usb_transfer_batch_t *);
 	void (*batch_destroy)(usb_transfer_batch_t *);		/**< Optional */
+	void (*batch_recycle)(usb_transfer_batch_t *);		/**< Optional */
 };
 
 /** Endpoint management structure */
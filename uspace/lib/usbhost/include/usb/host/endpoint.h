@@ -112,6 +112,13 @@ typedef struct endpoint {
 	 */
 	unsigned packets_per_uframe;
 
+	/** Finished transfer batches kept for reuse */
+	list_t batch_pool;
+	/** Number of batches in the pool */
+	size_t batch_pool_count;
+	/** Protects the batch pool */
+	fibril_mutex_t batch_pool_lock;
+
 	/* This structure is meant to be extended by overriding. */
 } endpoint_t;
 
@@ -37,6 +37,7 @@
 #ifndef LIBUSBHOST_HOST_USB_TRANSFER_BATCH_H
 #define LIBUSBHOST_HOST_USB_TRANSFER_BATCH_H
 
+#include <adt/list.h>
 #include <errno.h>
 #include <refcount.h>
 #include <stddef.h>
@@ -53,6 +54,9 @@
 typedef struct endpoint endpoint_t;
 typedef struct bus bus_t;
 
+/** Maximum number of batches kept for reuse by one endpoint */
+#define USB_TRANSFER_BATCH_POOL_SIZE 4
+
 /** Structure stores additional data needed for communication with EP */
 typedef struct usb_transfer_batch {
 	/** Target for communication */
@@ -62,6 +66,8 @@ typedef struct usb_transfer_batch {
 
 	/** Endpoint used for communication */
 	endpoint_t *ep;
+	/** Link in the batch pool of the endpoint */
+	link_t pool_link;
 
 	/** Place to store SETUP data needed by control transfers */
 	union {
@@ -127,6 +133,9 @@ void usb_transfer_batch_finish(usb_transfer_batch_t *);
  */
 void usb_transfer_batch_destroy(usb_transfer_batch_t *);
 
+/** Free the batches kept for reuse by an endpoint. */
+void usb_transfer_batch_pool_fini(endpoint_t *);
+
 #endif
 
 /**
@@ -60,6 +60,8 @@ void endpoint_init(endpoint_t *ep, device_t *dev, const usb_endpoint_descriptors
 
 	refcount_init(&ep->refcnt);
 	fibril_condvar_initialize(&ep->avail);
+	list_initialize(&ep->batch_pool);
+	fibril_mutex_initialize(&ep->batch_pool_lock);
 
 	ep->endpoint = USB_ED_GET_EP(desc->endpoint);
 	ep->direction = USB_ED_GET_DIR(desc->endpoint);
@@ -98,6 +100,9 @@ void endpoint_add_ref(endpoint_t *ep)
 static inline void endpoint_destroy(endpoint_t *ep)
 {
 	const bus_ops_t *ops = get_bus_ops(ep);
+
+	usb_transfer_batch_pool_fini(ep);
+
 	if (ops->endpoint_destroy) {
 		ops->endpoint_destroy(ep);
 	} else {
@@ -35,6 +35,7 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <mem.h>
 #include <stdlib.h>
 #include <str_error.h>
 #include <usb/debug.h>
@@ -44,10 +45,84 @@
 
 #include "usb_transfer_batch.h"
 
+/**
+ * Whether finished batches of the bus can be kept for reuse. Batches created
+ * by the bus can be reused only if the bus knows how to reset them.
+ */
+static bool batch_poolable(bus_t *bus)
+{
+	return !bus->ops->batch_create || bus->ops->batch_recycle;
+}
+
+/**
+ * Dispose of a batch. If there's no bus callback, just free it.
+ */
+static void batch_dispose(bus_t *bus, usb_transfer_batch_t *batch)
+{
+	if (bus->ops->batch_destroy) {
+		usb_log_debug2("Batch %p " USB_TRANSFER_BATCH_FMT " destroying.",
+		    batch, USB_TRANSFER_BATCH_ARGS(*batch));
+		bus->ops->batch_destroy(batch);
+	} else {
+		usb_log_debug2("Batch %p " USB_TRANSFER_BATCH_FMT " disposing.",
+		    batch, USB_TRANSFER_BATCH_ARGS(*batch));
+		free(batch);
+	}
+}
+
+/**
+ * Take a batch from the pool of the endpoint.
+ *
+ * @return Reinitialized batch or NULL if the pool is empty.
+ */
+static usb_transfer_batch_t *batch_pool_get(endpoint_t *ep)
+{
+	fibril_mutex_lock(&ep->batch_pool_lock);
+	link_t *link = list_first(&ep->batch_pool);
+	if (link) {
+		list_remove(link);
+		--ep->batch_pool_count;
+	}
+	fibril_mutex_unlock(&ep->batch_pool_lock);
+
+	if (!link)
+		return NULL;
+
+	usb_transfer_batch_t *batch =
+	    list_get_instance(link, usb_transfer_batch_t, pool_link);
+	memset(batch, 0, sizeof(usb_transfer_batch_t));
+	usb_transfer_batch_init(batch, ep);
+	return batch;
+}
+
+/**
+ * Put a finished batch to the pool of its endpoint.
+ *
+ * The batch does not hold a reference to the endpoint while in the pool.
+ *
+ * @return Whether the batch was pooled.
+ */
+static bool batch_pool_put(usb_transfer_batch_t *batch)
+{
+	endpoint_t *ep = batch->ep;
+	bool pooled = false;
+
+	fibril_mutex_lock(&ep->batch_pool_lock);
+	if (ep->batch_pool_count < USB_TRANSFER_BATCH_POOL_SIZE) {
+		list_append(&batch->pool_link, &ep->batch_pool);
+		++ep->batch_pool_count;
+		pooled = true;
+	}
+	fibril_mutex_unlock(&ep->batch_pool_lock);
+
+	return pooled;
+}
+
 /**
  * Create a batch on a given endpoint.
  *
- * If the bus callback is not defined, it just creates a default batch.
+ * Batches finished on the endpoint are reused if possible. If the bus
+ * callback is not defined, it just creates a default batch.
  */
 usb_transfer_batch_t *usb_transfer_batch_create(endpoint_t *ep)
 {
@@ -55,6 +130,10 @@ usb_transfer_batch_t *usb_transfer_batch_create(endpoint_t *ep)
 
 	bus_t *bus = endpoint_get_bus(ep);
 
+	usb_transfer_batch_t *pooled = batch_pool_get(ep);
+	if (pooled)
+		return pooled;
+
 	if (!bus->ops->batch_create) {
 		usb_transfer_batch_t *batch = calloc(1, sizeof(usb_transfer_batch_t));
 		if (!batch)
@@ -75,10 +154,12 @@ void usb_transfer_batch_init(usb_transfer_batch_t *batch, endpoint_t *ep)
 	/* Batch reference */
 	endpoint_add_ref(ep);
 	batch->ep = ep;
+	link_initialize(&batch->pool_link);
 }
 
 /**
- * Destroy the batch. If there's no bus callback, just free it.
+ * Destroy the batch. The batch is kept for reuse by its endpoint if the
+ * endpoint pool is not full, otherwise it is disposed of.
  */
 void usb_transfer_batch_destroy(usb_transfer_batch_t *batch)
 {
@@ -88,20 +169,37 @@ void usb_transfer_batch_destroy(usb_transfer_batch_t *batch)
 	bus_t *bus = endpoint_get_bus(batch->ep);
 	endpoint_t *ep = batch->ep;
 
-	if (bus->ops) {
-		usb_log_debug2("Batch %p " USB_TRANSFER_BATCH_FMT " destroying.",
-		    batch, USB_TRANSFER_BATCH_ARGS(*batch));
-		bus->ops->batch_destroy(batch);
+	if (batch_poolable(bus)) {
+		if (bus->ops->batch_recycle)
+			bus->ops->batch_recycle(batch);
+		if (!batch_pool_put(batch))
+			batch_dispose(bus, batch);
 	} else {
-		usb_log_debug2("Batch %p " USB_TRANSFER_BATCH_FMT " disposing.",
-		    batch, USB_TRANSFER_BATCH_ARGS(*batch));
-		free(batch);
+		batch_dispose(bus, batch);
 	}
 
 	/* Batch reference */
 	endpoint_del_ref(ep);
 }
 
+/**
+ * Free the batches kept for reuse by an endpoint. To be called when the
+ * endpoint is being destroyed.
+ */
+void usb_transfer_batch_pool_fini(endpoint_t *ep)
+{
+	bus_t *bus = endpoint_get_bus(ep);
+
+	while (!list_empty(&ep->batch_pool)) {
+		usb_transfer_batch_t *batch = list_get_instance(
+		    list_first(&ep->batch_pool), usb_transfer_batch_t,
+		    pool_link);
+		list_remove(&batch->pool_link);
+		batch_dispose(bus, batch);
+	}
+	ep->batch_pool_count = 0;
+}
+
 bool usb_transfer_batch_bounce_required(usb_transfer_batch_t *batch)
 {
 	if (!batch->size)
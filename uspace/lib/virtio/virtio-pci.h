@@ -62,6 +62,13 @@
 #define VIRTIO_FEATURES_32_63	1
 
 #define VIRTIO_F_VERSION_1	1
+/** Virtqueues use the packed layout (bit 34, in the 32 - 63 word). */
+#define VIRTIO_F_RING_PACKED	(1U << 2)
+
+/** Driver can use descriptors with VIRTQ_DESC_F_INDIRECT. */
+#define VIRTIO_F_INDIRECT_DESC	(1U << 28)
+/** Notifications and interrupts are suppressed using event indices. */
+#define VIRTIO_F_EVENT_IDX	(1U << 29)
 
 /** Common configuration structure layout according to VIRTIO version 1.0 */
 typedef struct virtio_pci_common_cfg {
@@ -129,6 +136,29 @@ typedef struct virtq_used {
 	 */
 } virtq_used_t;
 
+/** Descriptor is available, in the packed layout */
+#define VIRTQ_DESC_F_AVAIL	(1 << 7)
+/** Descriptor is used, in the packed layout */
+#define VIRTQ_DESC_F_USED	(1 << 15)
+
+/** Packed Virtqueue Descriptor structure as per VIRTIO version 1.1 */
+typedef struct virtq_packed_desc {
+	ioport64_t addr;	/**< Buffer physical address */
+	ioport32_t len;		/**< Buffer length */
+	ioport16_t id;		/**< Buffer ID */
+	ioport16_t flags;	/**< Buffer flags */
+} virtq_packed_desc_t;
+
+#define VIRTQ_EVENT_F_ENABLE	0
+#define VIRTQ_EVENT_F_DISABLE	1
+#define VIRTQ_EVENT_F_DESC	2
+
+/** Event suppression structure of a packed virtqueue */
+typedef struct virtq_event {
+	ioport16_t off_wrap;	/**< Descriptor ring offset and wrap counter */
+	ioport16_t flags;	/**< Event flags */
+} virtq_event_t;
+
 typedef struct {
 	void *virt;
 	uintptr_t phys;
@@ -143,7 +173,16 @@ typedef struct {
 	 */
 	size_t queue_size;
 
-	/** Virtual address of queue size virtq descriptors */
+	/** The virtqueue uses the packed layout (VIRTIO_F_RING_PACKED) */
+	bool packed;
+
+	/**
+	 * Virtual address of queue size virtq descriptors
+	 *
+	 * In the packed layout this is a driver-private table the descriptor
+	 * chains are built in. virtio_virtq_add_available() copies a chain
+	 * to the descriptor ring.
+	 */
 	virtq_desc_t *desc;
 	/** Virtual address of the available ring */
 	virtq_avail_t *avail;
@@ -151,6 +190,30 @@ typedef struct {
 	virtq_used_t *used;
 	uint16_t used_last_idx;
 
+	/** Index of the available ring when the device was last notified */
+	uint16_t avail_notified_idx;
+	/** Used ring index the device should interrupt at (VIRTIO_F_EVENT_IDX) */
+	ioport16_t *used_event;
+	/** Available ring index the device wants a notification at */
+	ioport16_t *avail_event;
+
+	/** Descriptor ring of the packed layout */
+	virtq_packed_desc_t *ring;
+	/** Driver event suppression structure of the packed layout */
+	virtq_event_t *driver_event;
+	/** Device event suppression structure of the packed layout */
+	virtq_event_t *device_event;
+	/** Next descriptor ring slot to make available and its wrap counter */
+	uint16_t avail_idx;
+	bool avail_wrap;
+	/** Next descriptor ring slot to be used and its wrap counter */
+	uint16_t used_idx;
+	bool used_wrap;
+	/** Descriptor ring slots made available since the last notification */
+	uint16_t num_added;
+	/** Number of ring slots of the chain made available with each head */
+	uint16_t *chain_len;
+
 	/** Address of the queue's notification register */
 	ioport16_t *notify;
 } virtq_t;
@@ -181,6 +244,11 @@ typedef struct {
 
 	/** Virtqueues */
 	virtq_t *queues;
+
+	/** Accepted feature flags (bits 0 - 31) */
+	uint32_t features;
+	/** Accepted reserved feature flags (bits 32 - 63) */
+	uint32_t reserved_features;
 } virtio_dev_t;
 
 extern errno_t virtio_setup_dma_bufs(unsigned int, size_t, bool, void *[],
@@ -191,6 +259,8 @@ extern void virtio_virtq_desc_set(virtio_dev_t *vdev, uint16_t, uint16_t,
     uint64_t, uint32_t, uint16_t, uint16_t);
 extern uint16_t virtio_virtq_desc_get_next(virtio_dev_t *vdev, uint16_t,
     uint16_t);
+extern void virtio_virtq_indirect_set(virtio_dev_t *, void *, uint16_t,
+    uint64_t, uint32_t, uint16_t);
 
 extern void virtio_create_desc_free_list(virtio_dev_t *, uint16_t, uint16_t,
     uint16_t *);
@@ -198,13 +268,18 @@ extern uint16_t virtio_alloc_desc(virtio_dev_t *, uint16_t, uint16_t *);
 extern void virtio_free_desc(virtio_dev_t *, uint16_t, uint16_t *, uint16_t);
 
 extern void virtio_virtq_produce_available(virtio_dev_t *, uint16_t, uint16_t);
+extern void virtio_virtq_add_available(virtio_dev_t *, uint16_t, uint16_t);
+extern void virtio_virtq_notify(virtio_dev_t *, uint16_t);
 extern bool virtio_virtq_consume_used(virtio_dev_t *, uint16_t, uint16_t *,
     uint32_t *);
 
+extern uint16_t virtio_virtq_max_size(virtio_dev_t *, uint16_t);
 extern errno_t virtio_virtq_setup(virtio_dev_t *, uint16_t, uint16_t);
 extern void virtio_virtq_teardown(virtio_dev_t *, uint16_t);
 
 extern errno_t virtio_device_setup_start(virtio_dev_t *, uint32_t);
+extern errno_t virtio_device_setup_start_opt(virtio_dev_t *, uint32_t,
+    uint32_t);
 extern void virtio_device_setup_fail(virtio_dev_t *);
 extern void virtio_device_setup_finalize(virtio_dev_t *);
 
@@ -35,6 +35,7 @@
 #include <align.h>
 #include <macros.h>
 #include <stdalign.h>
+#include <stdlib.h>
 
 #include <ddf/log.h>
 #include <barrier.h>
@@ -113,6 +114,40 @@ uint16_t virtio_virtq_desc_get_next(virtio_dev_t *vdev, uint16_t num,
 	return pio_read_le16(&d->next);
 }
 
+/** Set an entry of an indirect descriptor table
+ *
+ * The entries of an indirect table are chained in the order of their indices,
+ * the entry @a i continues in the entry @a i + 1 if @a flags has
+ * VIRTQ_DESC_F_NEXT. The table layout depends on the layout of the
+ * virtqueues, so the drivers should not write the table directly.
+ *
+ * @param vdev[in]   VIRTIO device.
+ * @param table[in]  Indirect descriptor table.
+ * @param i[in]      Index of the entry in @a table.
+ * @param addr[in]   Physical address of the buffer.
+ * @param len[in]    Length of the buffer.
+ * @param flags[in]  VIRTQ_DESC_F_NEXT and VIRTQ_DESC_F_WRITE flags.
+ */
+void virtio_virtq_indirect_set(virtio_dev_t *vdev, void *table, uint16_t i,
+    uint64_t addr, uint32_t len, uint16_t flags)
+{
+	if (vdev->reserved_features & VIRTIO_F_RING_PACKED) {
+		/* Packed indirect tables are contiguous, without chaining. */
+		virtq_packed_desc_t *d = &((virtq_packed_desc_t *) table)[i];
+		pio_write_le64(&d->addr, addr);
+		pio_write_le32(&d->len, len);
+		pio_write_le16(&d->id, 0);
+		pio_write_le16(&d->flags, flags & ~VIRTQ_DESC_F_NEXT);
+	} else {
+		virtq_desc_t *d = &((virtq_desc_t *) table)[i];
+		pio_write_le64(&d->addr, addr);
+		pio_write_le32(&d->len, len);
+		pio_write_le16(&d->flags, flags);
+		pio_write_le16(&d->next,
+		    (flags & VIRTQ_DESC_F_NEXT) ? i + 1 : 0);
+	}
+}
+
 /** Create free descriptor list from the unused VIRTIO descriptors
  *
  * @param vdev[in]   VIRTIO device for which the free list will be created.
@@ -170,31 +205,242 @@ void virtio_free_desc(virtio_dev_t *vdev, uint16_t num, uint16_t *head,
 	fibril_mutex_unlock(&q->lock);
 }
 
-void virtio_virtq_produce_available(virtio_dev_t *vdev, uint16_t num,
+/** Flags marking a packed ring descriptor available in the current lap */
+static uint16_t virtq_packed_avail_flags(bool wrap)
+{
+	return wrap ? VIRTQ_DESC_F_AVAIL : VIRTQ_DESC_F_USED;
+}
+
+/** Copy a descriptor chain to the packed descriptor ring
+ *
+ * The chain is made available to the device by writing the flags of its first
+ * descriptor last. Must be called with the virtqueue locked.
+ */
+static void virtq_packed_add_available(virtq_t *q, uint16_t descno)
+{
+	uint16_t head_idx = q->avail_idx;
+	uint16_t head_flags = 0;
+	uint16_t n = 0;
+	uint16_t d = descno;
+
+	while (true) {
+		virtq_desc_t *src = &q->desc[d];
+		virtq_packed_desc_t *dst = &q->ring[q->avail_idx];
+		uint16_t flags = pio_read_le16(&src->flags);
+
+		pio_write_le64(&dst->addr, pio_read_le64(&src->addr));
+		pio_write_le32(&dst->len, pio_read_le32(&src->len));
+		pio_write_le16(&dst->id, descno);
+
+		uint16_t rflags = flags |
+		    virtq_packed_avail_flags(q->avail_wrap);
+		if (n == 0)
+			head_flags = rflags;
+		else
+			pio_write_le16(&dst->flags, rflags);
+
+		n++;
+		if (++q->avail_idx == q->queue_size) {
+			q->avail_idx = 0;
+			q->avail_wrap = !q->avail_wrap;
+		}
+
+		if (!(flags & VIRTQ_DESC_F_NEXT))
+			break;
+		d = pio_read_le16(&src->next);
+	}
+
+	q->chain_len[descno] = n;
+	q->num_added += n;
+
+	write_barrier();
+	pio_write_le16(&q->ring[head_idx].flags, head_flags);
+}
+
+/** Put a descriptor chain on the available ring without notifying the device
+ *
+ * Use virtio_virtq_notify() to notify the device after adding a batch of
+ * descriptor chains.
+ *
+ * @param vdev[in]    VIRTIO device.
+ * @param num[in]     Index of the virtqueue.
+ * @param descno[in]  Head of the descriptor chain.
+ */
+void virtio_virtq_add_available(virtio_dev_t *vdev, uint16_t num,
     uint16_t descno)
 {
 	virtq_t *q = &vdev->queues[num];
 
 	fibril_mutex_lock(&q->lock);
+
+	if (q->packed) {
+		virtq_packed_add_available(q, descno);
+		fibril_mutex_unlock(&q->lock);
+		return;
+	}
+
 	uint16_t idx = pio_read_le16(&q->avail->idx);
 	pio_write_le16(&q->avail->ring[idx % q->queue_size], descno);
 	write_barrier();
 	pio_write_le16(&q->avail->idx, idx + 1);
-	write_barrier();
-	pio_write_le16(q->notify, num);
 	fibril_mutex_unlock(&q->lock);
 }
 
+/** Notify the device about descriptor chains added to the available ring
+ *
+ * The notification is skipped if the device does not need it, either because
+ * it asked not to be notified or because, with VIRTIO_F_EVENT_IDX, it asked to
+ * be notified only after the available ring reaches an index not reached yet.
+ *
+ * @param vdev[in]  VIRTIO device.
+ * @param num[in]   Index of the virtqueue.
+ */
+void virtio_virtq_notify(virtio_dev_t *vdev, uint16_t num)
+{
+	virtq_t *q = &vdev->queues[num];
+	bool notify;
+
+	fibril_mutex_lock(&q->lock);
+
+	/* Make the ring index visible before reading the device's wishes. */
+	memory_barrier();
+
+	uint16_t old_idx;
+	uint16_t new_idx;
+
+	if (q->packed) {
+		new_idx = q->avail_idx;
+		old_idx = new_idx - q->num_added;
+		q->num_added = 0;
+	} else {
+		old_idx = q->avail_notified_idx;
+		new_idx = pio_read_le16(&q->avail->idx);
+		q->avail_notified_idx = new_idx;
+	}
+
+	if (new_idx == old_idx) {
+		notify = false;
+	} else if (q->packed) {
+		uint16_t flags = pio_read_le16(&q->device_event->flags);
+		if (flags == VIRTQ_EVENT_F_DESC) {
+			/*
+			 * The event offset refers to the lap of its wrap
+			 * counter, bring it to the lap of the indices.
+			 */
+			uint16_t off_wrap =
+			    pio_read_le16(&q->device_event->off_wrap);
+			uint16_t event = off_wrap & 0x7fff;
+			if ((bool) (off_wrap >> 15) != q->avail_wrap)
+				event -= q->queue_size;
+			notify = (uint16_t) (new_idx - event - 1) <
+			    (uint16_t) (new_idx - old_idx);
+		} else {
+			notify = flags != VIRTQ_EVENT_F_DISABLE;
+		}
+		notify = false;
+	} else if (vdev->features & VIRTIO_F_EVENT_IDX) {
+		uint16_t event = pio_read_le16(q->avail_event);
+		notify = (uint16_t) (new_idx - event - 1) <
+		    (uint16_t) (new_idx - old_idx);
+	} else {
+		notify = !(pio_read_le16(&q->used->flags) &
+		    VIRTQ_USED_F_NO_NOTIFY);
+	}
+
+	if (notify)
+		pio_write_le16(q->notify, num);
+
+	fibril_mutex_unlock(&q->lock);
+}
+
+/** Check whether the packed ring slot at used_idx has been used */
+static bool virtq_packed_is_used(virtq_t *q)
+{
+	uint16_t flags = pio_read_le16(&q->ring[q->used_idx].flags);
+	bool avail = (flags & VIRTQ_DESC_F_AVAIL) != 0;
+	bool used = (flags & VIRTQ_DESC_F_USED) != 0;
+
+	return avail == used && used == q->used_wrap;
+}
+
+/** Take a used descriptor chain from the packed descriptor ring
+ *
+ * Must be called with the virtqueue locked.
+ */
+static bool virtq_packed_consume_used(virtio_dev_t *vdev, virtq_t *q,
+    uint16_t *descno, uint32_t *len)
+{
+	if (!virtq_packed_is_used(q)) {
+		if (!(vdev->features & VIRTIO_F_EVENT_IDX))
+			return false;
+
+		/*
+		 * Ask for an interrupt when the next buffer is used. The
+		 * device might have used one meanwhile, so check again.
+		 */
+		pio_write_le16(&q->driver_event->off_wrap,
+		    q->used_idx | (q->used_wrap ? 0x8000 : 0));
+		memory_barrier();
+
+		if (!virtq_packed_is_used(q))
+			return false;
+	}
+
+	/* Read the descriptor only after seeing its flags. */
+	read_barrier();
+
+	virtq_packed_desc_t *d = &q->ring[q->used_idx];
+	uint16_t id = pio_read_le16(&d->id);
+	*descno = id;
+	*len = pio_read_le32(&d->len);
+
+	q->used_idx += q->chain_len[id];
+	if (q->used_idx >= q->queue_size) {
+		q->used_idx -= q->queue_size;
+		q->used_wrap = !q->used_wrap;
+	}
+
+	return true;
+}
+
+void virtio_virtq_produce_available(virtio_dev_t *vdev, uint16_t num,
+    uint16_t descno)
+{
+	virtio_virtq_add_available(vdev, num, descno);
+	virtio_virtq_notify(vdev, num);
+}
+
 bool virtio_virtq_consume_used(virtio_dev_t *vdev, uint16_t num,
     uint16_t *descno, uint32_t *len)
 {
 	virtq_t *q = &vdev->queues[num];
 
 	fibril_mutex_lock(&q->lock);
+
+	if (q->packed) {
+		bool rc = virtq_packed_consume_used(vdev, q, descno, len);
+		fibril_mutex_unlock(&q->lock);
+		return rc;
+	}
+
 	uint16_t last_idx = q->used_last_idx % q->queue_size;
 	if (last_idx == (pio_read_le16(&q->used->idx) % q->queue_size)) {
-		fibril_mutex_unlock(&q->lock);
-		return false;
+		if (!(vdev->features & VIRTIO_F_EVENT_IDX)) {
+			fibril_mutex_unlock(&q->lock);
+			return false;
+		}
+
+		/*
+		 * Ask for an interrupt when the next buffer is used. The
+		 * device might have used one meanwhile, so check again.
+		 */
+		pio_write_le16(q->used_event, q->used_last_idx);
+		memory_barrier();
+
+		if (last_idx == (pio_read_le16(&q->used->idx) % q->queue_size)) {
+			fibril_mutex_unlock(&q->lock);
+			return false;
+		}
 	}
 
 	*descno = (uint16_t) pio_read_le32(&q->used->ring[last_idx].id);
@@ -206,6 +452,21 @@ bool virtio_virtq_consume_used(virtio_dev_t *vdev, uint16_t num,
 	return true;
 }
 
+/** Get the maximum size of a virtqueue the device supports
+ *
+ * @param vdev[in]  VIRTIO device.
+ * @param num[in]   Index of the virtqueue.
+ *
+ * @return  Maximum number of descriptors, 0 if the virtqueue is not available.
+ */
+uint16_t virtio_virtq_max_size(virtio_dev_t *vdev, uint16_t num)
+{
+	virtio_pci_common_cfg_t *cfg = vdev->common_cfg;
+
+	pio_write_le16(&cfg->queue_select, num);
+	return pio_read_le16(&cfg->queue_size);
+}
+
 errno_t virtio_virtq_setup(virtio_dev_t *vdev, uint16_t num, uint16_t size)
 {
 	virtq_t *q = &vdev->queues[num];
@@ -222,22 +483,46 @@ errno_t virtio_virtq_setup(virtio_dev_t *vdev, uint16_t num, uint16_t size)
 	pio_write_le16(&cfg->queue_size, size);
 	ddf_msg(LVL_NOTE, "Virtq %u: %u descriptors", num, (unsigned) size);
 
+	q->packed = (vdev->reserved_features & VIRTIO_F_RING_PACKED) != 0;
+
 	size_t avail_offset = 0;
 	size_t used_offset = 0;
+	size_t mem_size;
 
 	/*
 	 * Compute the size of the needed DMA memory and also the offsets of
-	 * the individual components
+	 * the individual components. In the packed layout, the avail and used
+	 * offsets locate the driver and device event suppression structures.
 	 */
-	size_t mem_size = sizeof(virtq_desc_t[size]);
-	mem_size = ALIGN_UP(mem_size, alignof(virtq_avail_t));
-	avail_offset = mem_size;
-	mem_size += sizeof(virtq_avail_t) + sizeof(ioport16_t[size]) +
-	    sizeof(ioport16_t);
-	mem_size = ALIGN_UP(mem_size, alignof(virtq_used_t));
-	used_offset = mem_size;
-	mem_size += sizeof(virtq_used_t) + sizeof(virtq_used_elem_t[size]) +
-	    sizeof(ioport16_t);
+	if (q->packed) {
+		mem_size = sizeof(virtq_packed_desc_t[size]);
+		mem_size = ALIGN_UP(mem_size, alignof(virtq_event_t));
+		avail_offset = mem_size;
+		mem_size += sizeof(virtq_event_t);
+		used_offset = mem_size;
+		mem_size += sizeof(virtq_event_t);
+
+		/* Descriptor chains are built in a driver-private table. */
+		q->desc = calloc(size, sizeof(virtq_desc_t));
+		q->chain_len = calloc(size, sizeof(uint16_t));
+		if (q->desc == NULL || q->chain_len == NULL) {
+			free(q->desc);
+			free(q->chain_len);
+			q->desc = NULL;
+			q->chain_len = NULL;
+			return ENOMEM;
+		}
+	} else {
+		mem_size = sizeof(virtq_desc_t[size]);
+		mem_size = ALIGN_UP(mem_size, alignof(virtq_avail_t));
+		avail_offset = mem_size;
+		mem_size += sizeof(virtq_avail_t) + sizeof(ioport16_t[size]) +
+		    sizeof(ioport16_t);
+		mem_size = ALIGN_UP(mem_size, alignof(virtq_used_t));
+		used_offset = mem_size;
+		mem_size += sizeof(virtq_used_t) +
+		    sizeof(virtq_used_elem_t[size]) + sizeof(ioport16_t);
+	}
 
 	/*
 	 * Allocate DMA memory for the virtqueues
@@ -247,6 +532,12 @@ errno_t virtio_virtq_setup(virtio_dev_t *vdev, uint16_t num, uint16_t size)
 	    AS_AREA_READ | AS_AREA_WRITE, 0, &q->phys, &q->virt);
 	if (rc != EOK) {
 		q->virt = NULL;
+		if (q->packed) {
+			free(q->desc);
+			free(q->chain_len);
+			q->desc = NULL;
+			q->chain_len = NULL;
+		}
 		return rc;
 	}
 
@@ -254,13 +545,36 @@ errno_t virtio_virtq_setup(virtio_dev_t *vdev, uint16_t num, uint16_t size)
 
 	q->size = mem_size;
 	q->queue_size = size;
-	q->desc = q->virt;
-	q->avail = q->virt + avail_offset;
-	q->used = q->virt + used_offset;
-	q->used_last_idx = 0;
-
 	memset(q->virt, 0, q->size);
 
+	if (q->packed) {
+		q->ring = q->virt;
+		q->driver_event = q->virt + avail_offset;
+		q->device_event = q->virt + used_offset;
+		q->avail_idx = 0;
+		q->avail_wrap = true;
+		q->used_idx = 0;
+		q->used_wrap = true;
+		q->num_added = 0;
+
+		/*
+		 * With VIRTIO_F_EVENT_IDX, the device interrupts only when the
+		 * descriptor set in off_wrap is used.
+		 */
+		pio_write_le16(&q->driver_event->off_wrap, 0x8000);
+		pio_write_le16(&q->driver_event->flags,
+		    (vdev->features & VIRTIO_F_EVENT_IDX) ?
+		    VIRTQ_EVENT_F_DESC : VIRTQ_EVENT_F_ENABLE);
+	} else {
+		q->desc = q->virt;
+		q->avail = q->virt + avail_offset;
+		q->used = q->virt + used_offset;
+		q->used_last_idx = 0;
+		q->avail_notified_idx = 0;
+		q->used_event = &q->avail->ring[size];
+		q->avail_event = (ioport16_t *) &q->used->ring[size];
+	}
+
 	/*
 	 * Write the configured addresses to device's common config
 	 */
@@ -294,6 +608,13 @@ void virtio_virtq_teardown(virtio_dev_t *vdev, uint16_t num)
 	virtq_t *q = &vdev->queues[num];
 	if (q->size)
 		dmamem_unmap_anonymous(q->virt);
+
+	if (q->packed) {
+		free(q->desc);
+		free(q->chain_len);
+		q->desc = NULL;
+		q->chain_len = NULL;
+	}
 }
 
 /**
@@ -301,6 +622,22 @@ void virtio_virtq_teardown(virtio_dev_t *vdev, uint16_t num)
  * specification, steps 1 - 6.
  */
 errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
+{
+	return virtio_device_setup_start_opt(vdev, features, 0);
+}
+
+/**
+ * Perform device initialization as described in section 3.1.1 of the
+ * specification, steps 1 - 6, accepting optional features the device offers.
+ *
+ * The accepted features are stored in vdev->features.
+ *
+ * @param vdev[in]      VIRTIO device.
+ * @param features[in]  Features the device must offer.
+ * @param optional[in]  Features accepted only if the device offers them.
+ */
+errno_t virtio_device_setup_start_opt(virtio_dev_t *vdev, uint32_t features,
+    uint32_t optional)
 {
 	virtio_pci_common_cfg_t *cfg = vdev->common_cfg;
 
@@ -321,6 +658,7 @@ errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
 	uint32_t device_features = pio_read_le32(&cfg->device_feature);
 
 	uint32_t reserved_features = VIRTIO_F_VERSION_1;
+	uint32_t reserved_optional = VIRTIO_F_RING_PACKED;
 	pio_write_le32(&cfg->device_feature_select, VIRTIO_FEATURES_32_63);
 	uint32_t device_reserved_features = pio_read_le32(&cfg->device_feature);
 
@@ -329,10 +667,12 @@ errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
 
 	if (features != (features & device_features))
 		return ENOTSUP;
+	features |= optional;
 	features &= device_features;
 
 	if (reserved_features != (reserved_features & device_reserved_features))
 		return ENOTSUP;
+	reserved_features |= reserved_optional;
 	reserved_features &= device_reserved_features;
 
 	/* 4. Write the accepted feature flags */
@@ -353,6 +693,8 @@ errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
 	if (!(status & VIRTIO_DEV_STATUS_FEATURES_OK))
 		return ENOTSUP;
 
+	vdev->features = features;
+	vdev->reserved_features = reserved_features;
 	return EOK;
 }
 
@@ -186,6 +186,7 @@ void audio_pipe_init(audio_pipe_t *pipe)
 	fibril_mutex_initialize(&pipe->guard);
 	pipe->frames = 0;
 	pipe->bytes = 0;
+	pcm_mixer_init(&pipe->mixer, &AUDIO_FORMAT_ANY, &AUDIO_FORMAT_ANY);
 }
 
 /**
@@ -281,10 +282,13 @@ size_t audio_pipe_mix_data(audio_pipe_t *pipe, void *data,
 
 		assert(src_copy_size <= audio_data_link_remain_size(alink));
 
+		/* Buffers in a pipe usually share format, reuse the mixer */
+		if (!pcm_mixer_matches(&pipe->mixer, &alink->adata->format, f))
+			pcm_mixer_init(&pipe->mixer, &alink->adata->format, f);
+
 		/* Copy audio data */
-		pcm_format_convert_and_mix(data, dst_copy_size,
-		    audio_data_link_start(alink), src_copy_size,
-		    &alink->adata->format, f);
+		pcm_mixer_mix(&pipe->mixer, data, audio_data_link_start(alink),
+		    copy_frames);
 
 		/* Update values */
 		needed_frames -= copy_frames;
@@ -64,6 +64,8 @@ typedef struct {
 	size_t frames;
 	/** List access synchronization */
 	fibril_mutex_t guard;
+	/** Mixer for the format of the last mixed buffer */
+	pcm_mixer_t mixer;
 } audio_pipe_t;
 
 audio_data_t *audio_data_create(void *data, size_t size,
@@ -39,6 +39,7 @@
 #include <errno.h>
 #include <inttypes.h>
 #include <loc.h>
+#include <macros.h>
 #include <stdbool.h>
 #include <str.h>
 #include <str_error.h>
@@ -50,6 +51,9 @@
 /* hardwired to provide ~21ms per fragment */
 #define BUFFER_PARTS   16
 
+/* Number of fragments mixed ahead of the playback position */
+#define FRAGMENTS_AHEAD   2
+
 static errno_t device_sink_connection_callback(audio_sink_t *sink, bool new);
 static errno_t device_source_connection_callback(audio_source_t *source, bool new);
 static void device_event_callback(ipc_call_t *icall, void *arg);
@@ -57,6 +61,8 @@ static errno_t device_check_format(audio_sink_t *sink);
 static errno_t get_buffer(audio_device_t *dev);
 static errno_t release_buffer(audio_device_t *dev);
 static void advance_buffer(audio_device_t *dev, size_t size);
+static bool playback_underrun(audio_device_t *dev,
+    const struct timespec *now);
 static inline bool is_running(audio_device_t *dev)
 {
 	assert(dev);
@@ -93,6 +99,8 @@ errno_t audio_device_init(audio_device_t *dev, service_id_t id, const char *name
 	dev->buffer.position = NULL;
 	dev->buffer.size = 0;
 	dev->buffer.fragment_size = 0;
+	dev->buffer.position_reporting = false;
+	dev->stats = (hound_stats_t) { 0 };
 
 	log_verbose("Initialized device (%p) '%s' with id %" PRIun ".",
 	    dev, dev->name, dev->id);
@@ -143,6 +151,18 @@ audio_sink_t *audio_device_get_sink(audio_device_t *dev)
 	return NULL;
 }
 
+/**
+ * Get playback statistics of the device.
+ * @param dev The device.
+ * @param stats Place to store the statistics.
+ */
+void audio_device_get_stats(audio_device_t *dev, hound_stats_t *stats)
+{
+	assert(dev);
+	assert(stats);
+	*stats = dev->stats;
+}
+
 /**
  * Handle connection addition and removal.
  * @param sink audio sink that is connected or disconnected.
@@ -174,8 +194,7 @@ static errno_t device_sink_connection_callback(audio_sink_t *sink, bool new)
 		 */
 		pcm_format_silence(dev->buffer.base, dev->buffer.size,
 		    &dev->sink.format);
-		//TODO add underrun detection.
-		const size_t size = dev->buffer.fragment_size * 2;
+		const size_t size = dev->buffer.fragment_size * FRAGMENTS_AHEAD;
 		/* We never cross the end of the buffer here */
 		audio_sink_mix_inputs(&dev->sink, dev->buffer.position, size);
 		advance_buffer(dev, size);
@@ -183,6 +202,17 @@ static errno_t device_sink_connection_callback(audio_sink_t *sink, bool new)
 		const unsigned frames = dev->buffer.fragment_size /
 		    pcm_format_frame_size(&dev->sink.format);
 		log_verbose("Fragment frame count %u", frames);
+		const usec_t period_usec = pcm_format_size_to_usec(
+		    dev->buffer.fragment_size, &dev->sink.format);
+		dev->stats = (hound_stats_t) {
+			.period_usec = period_usec,
+			.latency_usec = period_usec * FRAGMENTS_AHEAD,
+		};
+		getuptime(&dev->last_played);
+
+		sysarg_t val;
+		ret = audio_pcm_query_cap(dev->sess, AUDIO_CAP_BUFFER_POS, &val);
+		dev->buffer.position_reporting = ret == EOK && val;
 		ret = audio_pcm_start_playback_fragment(dev->sess, frames,
 		    dev->sink.format.channels, dev->sink.format.sampling_rate,
 		    dev->sink.format.sample_format);
@@ -277,15 +307,22 @@ static void device_event_callback(ipc_call_t *icall, void *arg)
 		switch (ipc_get_imethod(&call)) {
 		case PCM_EVENT_FRAMES_PLAYED:
 			getuptime(&time1);
-			//TODO add underrun detection.
+			if (playback_underrun(dev, &time1))
+				++dev->stats.xruns;
+			dev->last_played = time1;
 			/* We never cross the end of the buffer here */
 			audio_sink_mix_inputs(&dev->sink, dev->buffer.position,
 			    dev->buffer.fragment_size);
 			advance_buffer(dev, dev->buffer.fragment_size);
 			struct timespec time2;
 			getuptime(&time2);
-			log_verbose("Time to mix sources: %lld\n",
-			    NSEC2USEC(ts_sub_diff(&time2, &time1)));
+			const usec_t mix_usec =
+			    NSEC2USEC(ts_sub_diff(&time2, &time1));
+			++dev->stats.periods;
+			dev->stats.mix_usec_last = mix_usec;
+			dev->stats.mix_usec_max =
+			    max(dev->stats.mix_usec_max, mix_usec);
+			log_verbose("Time to mix sources: %lld\n", mix_usec);
 			break;
 		case PCM_EVENT_CAPTURE_TERMINATED:
 			log_verbose("Capture terminated");
@@ -392,6 +429,43 @@ static errno_t release_buffer(audio_device_t *dev)
 	return ret;
 }
 
+/**
+ * Check whether the device played past the mixed data.
+ * @param dev Audio device.
+ * @param now Time of the current fragment event.
+ * @return True if the device played data that were not mixed in time.
+ *
+ * Devices that report their position are checked directly and the mixing
+ * position is moved just past the fragment being played if the mixer fell
+ * behind. Otherwise the device ran out of data if the event came later
+ * than the fragments mixed ahead last time.
+ */
+static bool playback_underrun(audio_device_t *dev,
+    const struct timespec *now)
+{
+	size_t pos;
+
+	if (dev->buffer.position_reporting &&
+	    audio_pcm_get_buffer_pos(dev->sess, &pos) == EOK &&
+	    pos < dev->buffer.size) {
+		const size_t fragment = dev->buffer.fragment_size;
+		const size_t parts = dev->buffer.size / fragment;
+		const size_t played = pos / fragment;
+		const size_t mixed =
+		    (dev->buffer.position - dev->buffer.base) / fragment;
+		/* The fragment being played is never mixed into */
+		const size_t ahead = (mixed + parts - played) % parts;
+		if (ahead > 0 && ahead <= FRAGMENTS_AHEAD)
+			return false;
+		dev->buffer.position =
+		    dev->buffer.base + ((played + 1) % parts) * fragment;
+		return true;
+	}
+
+	const usec_t gap = NSEC2USEC(ts_sub_diff(now, &dev->last_played));
+	return gap > dev->stats.latency_usec;
+}
+
 /**
  * Move buffer position pointer.
  * @param dev Audio device.
@@ -42,6 +42,8 @@
 #include <errno.h>
 #include <ipc/loc.h>
 #include <audio_pcm_iface.h>
+#include <hound/protocol.h>
+#include <time.h>
 
 #include "audio_source.h"
 #include "audio_sink.h"
@@ -62,7 +64,13 @@ typedef struct {
 		size_t size;
 		void *position;
 		size_t fragment_size;
+		/** Device reports its position in the buffer */
+		bool position_reporting;
 	} buffer;
+	/** Playback statistics */
+	hound_stats_t stats;
+	/** Time of the last played fragment event */
+	struct timespec last_played;
 	/** Capture device abstraction. */
 	audio_source_t source;
 	/** Playback device abstraction. */
@@ -79,6 +87,7 @@ errno_t audio_device_init(audio_device_t *dev, service_id_t id, const char *name
 void audio_device_fini(audio_device_t *dev);
 audio_source_t *audio_device_get_source(audio_device_t *dev);
 audio_sink_t *audio_device_get_sink(audio_device_t *dev);
+void audio_device_get_stats(audio_device_t *dev, hound_stats_t *stats);
 errno_t audio_device_recorded_data(audio_device_t *dev, void **base, size_t *size);
 errno_t audio_device_available_buffer(audio_device_t *dev, void **base, size_t *size);
 
@@ -493,6 +493,28 @@ errno_t hound_list_sinks(hound_t *hound, char ***list, size_t *size)
 	return ret;
 }
 
+/**
+ * Get playback statistics of a device.
+ * @param[in] hound The hound structure.
+ * @param[in] name Device name.
+ * @param[out] stats Place to store the statistics.
+ * @return Error code.
+ */
+errno_t hound_get_device_stats(hound_t *hound, const char *name,
+    hound_stats_t *stats)
+{
+	assert(hound);
+	if (!name || !stats)
+		return EINVAL;
+
+	fibril_mutex_lock(&hound->list_guard);
+	audio_device_t *dev = find_device_by_name(&hound->devices, name);
+	if (dev)
+		audio_device_get_stats(dev, stats);
+	fibril_mutex_unlock(&hound->list_guard);
+	return dev ? EOK : ENOENT;
+}
+
 /**
  * List all connections
  * @param[in] hound The hound structure.
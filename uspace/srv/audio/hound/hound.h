@@ -74,6 +74,8 @@ errno_t hound_add_source(hound_t *hound, audio_source_t *source);
 errno_t hound_add_sink(hound_t *hound, audio_sink_t *sink);
 errno_t hound_list_sources(hound_t *hound, char ***list, size_t *size);
 errno_t hound_list_sinks(hound_t *hound, char ***list, size_t *size);
+errno_t hound_get_device_stats(hound_t *hound, const char *name,
+    hound_stats_t *stats);
 errno_t hound_list_connections(hound_t *hound, const char ***sources,
     const char ***sinks, size_t *size);
 errno_t hound_remove_source(hound_t *hound, audio_source_t *source);
@@ -34,6 +34,7 @@
 /** @file
  */
 
+#include <as.h>
 #include <macros.h>
 #include <errno.h>
 #include <stdlib.h>
@@ -171,8 +172,81 @@ typedef struct hound_ctx_stream {
 	fibril_mutex_t guard;
 	/** buffer status change condition */
 	fibril_condvar_t change;
+	/** Ring shared with the client, NULL if not shared */
+	hound_ring_t *ring;
+	/** Size of the ring data, as validated when it was shared */
+	size_t ring_size;
+	/** Mixer for the ring data */
+	pcm_mixer_t ring_mixer;
 } hound_ctx_stream_t;
 
+/**
+ * Get amount of data waiting in the shared ring.
+ * @param stream The stream.
+ * @return Number of bytes in the ring, 0 if there is no ring.
+ *
+ * Positions are updated by the client, never trust them to stay
+ * within the ring.
+ */
+static size_t stream_ring_bytes(hound_ctx_stream_t *stream)
+{
+	if (!stream->ring)
+		return 0;
+	const size_t rpos = atomic_load_explicit(&stream->ring->read_pos,
+	    memory_order_relaxed);
+	const size_t wpos = atomic_load_explicit(&stream->ring->write_pos,
+	    memory_order_acquire);
+	return min(wpos - rpos, stream->ring_size);
+}
+
+/**
+ * Mix data from the shared ring into the destination buffer.
+ * @param stream The source stream.
+ * @param data Destination audio buffer.
+ * @param size Size of the @p data buffer.
+ * @param f Destination data format.
+ * @return Size of the destination buffer touched with ring data.
+ */
+static size_t stream_ring_mix(hound_ctx_stream_t *stream, void *data,
+    size_t size, const pcm_format_t *f)
+{
+	hound_ring_t *ring = stream->ring;
+	const size_t src_frame_size = pcm_format_frame_size(&stream->format);
+	const size_t dst_frame_size = pcm_format_frame_size(f);
+	const size_t rpos = atomic_load_explicit(&ring->read_pos,
+	    memory_order_relaxed);
+	size_t offset = rpos % stream->ring_size;
+	if (offset % src_frame_size != 0)
+		return 0;
+
+	const size_t frames = min(stream_ring_bytes(stream) / src_frame_size,
+	    size / dst_frame_size);
+	if (!pcm_mixer_matches(&stream->ring_mixer, &stream->format, f))
+		pcm_mixer_init(&stream->ring_mixer, &stream->format, f);
+
+	/* Mix up to the end of the ring and wrap around */
+	size_t remain = frames;
+	while (remain > 0) {
+		const size_t count = min(remain,
+		    (stream->ring_size - offset) / src_frame_size);
+		pcm_mixer_mix(&stream->ring_mixer, data,
+		    hound_ring_data(ring) + offset, count);
+		data += count * dst_frame_size;
+		offset = (offset + count * src_frame_size) % stream->ring_size;
+		remain -= count;
+	}
+	atomic_store_explicit(&ring->read_pos, rpos + frames * src_frame_size,
+	    memory_order_release);
+
+	/* Do not count underruns before the client started writing */
+	if (frames * dst_frame_size < size &&
+	    !(stream->flags & HOUND_STREAM_IGNORE_UNDERFLOW) &&
+	    atomic_load_explicit(&ring->write_pos, memory_order_relaxed) != 0)
+		atomic_fetch_add_explicit(&ring->xruns, 1,
+		    memory_order_relaxed);
+	return frames * dst_frame_size;
+}
+
 /**
  * New stream append helper.
  * @param ctx hound context.
@@ -253,6 +327,10 @@ hound_ctx_stream_t *hound_ctx_create_stream(hound_ctx_t *ctx, int flags,
 		link_initialize(&stream->link);
 		fibril_mutex_initialize(&stream->guard);
 		fibril_condvar_initialize(&stream->change);
+		stream->ring = NULL;
+		stream->ring_size = 0;
+		pcm_mixer_init(&stream->ring_mixer, &AUDIO_FORMAT_ANY,
+		    &AUDIO_FORMAT_ANY);
 		stream->ctx = ctx;
 		stream->flags = flags;
 		stream->format = format;
@@ -284,10 +362,48 @@ void hound_ctx_destroy_stream(hound_ctx_stream_t *stream)
 		    stream->format.channels, stream->format.sampling_rate,
 		    pcm_sample_format_str(stream->format.sample_format));
 		audio_pipe_fini(&stream->fifo);
+		if (stream->ring)
+			as_area_destroy(stream->ring);
 		free(stream);
 	}
 }
 
+/**
+ * Attach a ring shared with the client to a stream.
+ * @param stream The destination stream.
+ * @param ring Ring header at the start of the shared area.
+ * @param size Size of the shared area.
+ * @return Error code.
+ *
+ * Data in the ring are mixed after any data written to the stream
+ * by hound_ctx_stream_write().
+ */
+errno_t hound_ctx_stream_share(hound_ctx_stream_t *stream, hound_ring_t *ring,
+    size_t size)
+{
+	assert(stream);
+	assert(ring);
+
+	const size_t period_size = ring->period_size;
+	const size_t periods = ring->periods;
+	if (periods == 0 || period_size == 0 ||
+	    period_size % pcm_format_frame_size(&stream->format) != 0 ||
+	    period_size > (size - HOUND_RING_HEADER_SIZE) / periods)
+		return EINVAL;
+
+	fibril_mutex_lock(&stream->guard);
+	if (stream->ring) {
+		fibril_mutex_unlock(&stream->guard);
+		return EEXIST;
+	}
+	stream->ring_size = period_size * periods;
+	stream->ring = ring;
+	fibril_mutex_unlock(&stream->guard);
+	log_verbose("CTX: %p stream shared ring: %zu x %zu B", stream->ctx,
+	    periods, period_size);
+	return EOK;
+}
+
 /**
  * Write new data to a stream.
  * @param stream The destination stream.
@@ -361,7 +477,9 @@ size_t hound_ctx_stream_add_self(hound_ctx_stream_t *stream, void *data,
 {
 	assert(stream);
 	fibril_mutex_lock(&stream->guard);
-	const size_t ret = audio_pipe_mix_data(&stream->fifo, data, size, f);
+	size_t ret = audio_pipe_mix_data(&stream->fifo, data, size, f);
+	if (stream->ring && ret < size)
+		ret += stream_ring_mix(stream, data + ret, size - ret, f);
 	fibril_condvar_signal(&stream->change);
 	fibril_mutex_unlock(&stream->guard);
 	return ret;
@@ -376,7 +494,7 @@ void hound_ctx_stream_drain(hound_ctx_stream_t *stream)
 	assert(stream);
 	log_debug("Draining stream");
 	fibril_mutex_lock(&stream->guard);
-	while (audio_pipe_bytes(&stream->fifo))
+	while (audio_pipe_bytes(&stream->fifo) || stream_ring_bytes(stream))
 		fibril_condvar_wait(&stream->change, &stream->guard);
 	fibril_mutex_unlock(&stream->guard);
 }
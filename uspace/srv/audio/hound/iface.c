@@ -151,6 +151,18 @@ static errno_t iface_stream_data_write(void *stream, void *buffer, size_t size)
 	return hound_ctx_stream_write(stream, buffer, size);
 }
 
+static errno_t iface_stream_share(void *stream, hound_ring_t *ring,
+    size_t size)
+{
+	return hound_ctx_stream_share(stream, ring, size);
+}
+
+static errno_t iface_get_stats(void *server, const char *name,
+    hound_stats_t *stats)
+{
+	return hound_get_device_stats(server, name, stats);
+}
+
 hound_server_iface_t hound_iface = {
 	.add_context = iface_add_context,
 	.rem_context = iface_rem_context,
@@ -163,5 +175,7 @@ hound_server_iface_t hound_iface = {
 	.drain_stream = iface_drain_stream,
 	.stream_data_write = iface_stream_data_write,
 	.stream_data_read = iface_stream_data_read,
+	.stream_share = iface_stream_share,
+	.get_stats = iface_get_stats,
 	.server = NULL,
 };
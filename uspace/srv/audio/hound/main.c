@@ -75,7 +75,14 @@ int main(int argc, char **argv)
 		return 1;
 	}
 
-	errno_t ret = hound_init(&hound);
+	/* Audio buffers must be refilled in time regardless of other load */
+	errno_t ret = task_set_sched_class(SCHED_CLASS_FIFO);
+	if (ret != EOK) {
+		log_warning("Failed to enable real-time scheduling: %s",
+		    str_error(ret));
+	}
+
+	ret = hound_init(&hound);
 	if (ret != EOK) {
 		log_fatal("Failed to initialize hound structure: %s",
 		    str_error(ret));
@@ -42,28 +42,63 @@
 #include <async.h>
 #include <as.h>
 #include <bd_srv.h>
+#include <fibril.h>
 #include <fibril_synch.h>
 #include <loc.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <str_error.h>
 #include <stdbool.h>
 #include <task.h>
 #include <macros.h>
 #include <str.h>
+#include <vfs/vfs.h>
 
 #define NAME "file_bd"
 
 #define DEFAULT_BLOCK_SIZE 512
 
+/** Default number of transfers in flight with the file system */
+#define DEFAULT_QUEUE_DEPTH 8
+
 static size_t block_size;
 static aoff64_t num_blocks;
-static FILE *img;
+static int img;
+/** Additional open mode of the image */
+static int img_mode;
 
 static service_id_t service_id;
 static bd_srvs_t bd_srvs;
-static fibril_mutex_t dev_lock;
+
+/** Maximum number of transfers in flight */
+static size_t queue_depth;
+/** Limits the number of transfers in flight to queue_depth */
+static fibril_semaphore_t queue_sem;
+
+/** Vectored request in progress */
+typedef struct {
+	/** Vectored request of the client */
+	bd_io_t *io;
+	/** Protects @c pending and @c rc */
+	fibril_mutex_t lock;
+	/** Number of runs in flight, plus one while submitting */
+	unsigned pending;
+	/** Result of the request */
+	errno_t rc;
+} file_bd_io_t;
+
+/** Run of extents of a vectored request transferred at once */
+typedef struct {
+	file_bd_io_t *fio;
+	/** Index of the first extent */
+	size_t first;
+	/** Address of the first block */
+	aoff64_t ba;
+	/** Number of blocks */
+	size_t cnt;
+} file_bd_run_t;
 
 static void print_usage(void);
 static errno_t file_bd_init(const char *fname);
@@ -73,16 +108,20 @@ static errno_t file_bd_open(bd_srvs_t *, bd_srv_t *);
 static errno_t file_bd_close(bd_srv_t *);
 static errno_t file_bd_read_blocks(bd_srv_t *, aoff64_t, size_t, void *, size_t);
 static errno_t file_bd_write_blocks(bd_srv_t *, aoff64_t, size_t, const void *, size_t);
+static errno_t file_bd_sync_cache(bd_srv_t *, aoff64_t, size_t);
 static errno_t file_bd_get_block_size(bd_srv_t *, size_t *);
 static errno_t file_bd_get_num_blocks(bd_srv_t *, aoff64_t *);
+static errno_t file_bd_submit(bd_srv_t *, bd_io_t *);
 
 static bd_ops_t file_bd_ops = {
 	.open = file_bd_open,
 	.close = file_bd_close,
 	.read_blocks = file_bd_read_blocks,
 	.write_blocks = file_bd_write_blocks,
+	.sync_cache = file_bd_sync_cache,
 	.get_block_size = file_bd_get_block_size,
-	.get_num_blocks = file_bd_get_num_blocks
+	.get_num_blocks = file_bd_get_num_blocks,
+	.submit = file_bd_submit
 };
 
 int main(int argc, char **argv)
@@ -95,6 +134,8 @@ int main(int argc, char **argv)
 	printf(NAME ": File-backed block device driver\n");
 
 	block_size = DEFAULT_BLOCK_SIZE;
+	queue_depth = DEFAULT_QUEUE_DEPTH;
+	img_mode = 0;
 
 	++argv;
 	--argc;
@@ -115,6 +156,23 @@ int main(int argc, char **argv)
 			}
 			++argv;
 			--argc;
+		} else if (str_cmp(*argv, "-q") == 0) {
+			if (argc < 2) {
+				printf("Argument missing.\n");
+				print_usage();
+				return -1;
+			}
+
+			rc = str_size_t(argv[1], NULL, 10, true, &queue_depth);
+			if (rc != EOK || queue_depth == 0) {
+				printf("Invalid queue depth '%s'.\n", argv[1]);
+				print_usage();
+				return -1;
+			}
+			++argv;
+			--argc;
+		} else if (str_cmp(*argv, "-d") == 0) {
+			img_mode = MODE_DIRECT;
 		} else {
 			printf("Invalid option '%s'.\n", *argv);
 			print_usage();
@@ -166,39 +224,40 @@ int main(int argc, char **argv)
 
 static void print_usage(void)
 {
-	printf("Usage: " NAME " [-b <block_size>] <image_file> <device_name>\n");
+	printf("Usage: " NAME " [-b <block_size>] [-q <queue_depth>] [-d] "
+	    "<image_file> <device_name>\n");
+	printf("  -d  Bypass the page cache when reading the image\n");
 }
 
 static errno_t file_bd_init(const char *fname)
 {
+	vfs_stat_t st;
+	errno_t rc;
+
 	bd_srvs_init(&bd_srvs);
 	bd_srvs.ops = &file_bd_ops;
 
 	async_set_fallback_port_handler(file_bd_connection, NULL);
-	errno_t rc = loc_server_register(NAME);
+	rc = loc_server_register(NAME);
 	if (rc != EOK) {
 		printf("%s: Unable to register driver.\n", NAME);
 		return rc;
 	}
 
-	img = fopen(fname, "rb+");
-	if (img == NULL)
+	rc = vfs_lookup_open(fname, WALK_REGULAR,
+	    MODE_READ | MODE_WRITE | img_mode, &img);
+	if (rc != EOK)
 		return EINVAL;
 
-	if (fseek(img, 0, SEEK_END) != 0) {
-		fclose(img);
-		return EIO;
-	}
-
-	off64_t img_size = ftell(img);
-	if (img_size < 0) {
-		fclose(img);
+	rc = vfs_stat(img, &st);
+	if (rc != EOK) {
+		vfs_put(img);
 		return EIO;
 	}
 
-	num_blocks = img_size / block_size;
+	num_blocks = st.size / block_size;
 
-	fibril_mutex_initialize(&dev_lock);
+	fibril_semaphore_initialize(&queue_sem, queue_depth);
 
 	return EOK;
 }
@@ -220,85 +279,189 @@ static errno_t file_bd_close(bd_srv_t *bd)
 	return EOK;
 }
 
-/** Read blocks from the device. */
-static errno_t file_bd_read_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt, void *buf,
-    size_t size)
+/** Check whether access is within device address bounds. */
+static errno_t file_bd_check(aoff64_t ba, size_t cnt)
 {
-	size_t n_rd;
-
-	if (size < cnt * block_size)
-		return EINVAL;
-
-	/* Check whether access is within device address bounds. */
-	if (ba + cnt > num_blocks) {
+	if (ba > num_blocks || cnt > num_blocks - ba) {
 		printf(NAME ": Accessed blocks %" PRIuOFF64 "-%" PRIuOFF64 ", while "
 		    "max block number is %" PRIuOFF64 ".\n", ba, ba + cnt - 1,
 		    num_blocks - 1);
 		return ELIMIT;
 	}
 
-	fibril_mutex_lock(&dev_lock);
+	return EOK;
+}
 
-	clearerr(img);
-	if (fseek(img, ba * block_size, SEEK_SET) < 0) {
-		fibril_mutex_unlock(&dev_lock);
-		return EIO;
-	}
+/** Transfer blocks between the image and a buffer.
+ *
+ * The image is accessed at explicit positions, so transfers need no
+ * locking. Up to queue_depth of them are in flight at the same time, each
+ * using an exchange of its own with VFS.
+ *
+ * @param ba	Address of first block
+ * @param cnt	Number of blocks
+ * @param buf	Buffer
+ * @param write	@c true to write the buffer to the image, @c false to read
+ *
+ * @return	EOK on success or an error code
+ */
+static errno_t file_bd_transfer(aoff64_t ba, size_t cnt, void *buf,
+    bool write)
+{
+	aoff64_t pos = ba * block_size;
+	size_t bytes = cnt * block_size;
+	size_t nbytes;
+	errno_t rc;
+
+	fibril_semaphore_down(&queue_sem);
+	if (write)
+		rc = vfs_write(img, &pos, buf, bytes, &nbytes);
+	else
+		rc = vfs_read(img, &pos, buf, bytes, &nbytes);
+	fibril_semaphore_up(&queue_sem);
 
-	n_rd = fread(buf, block_size, cnt, img);
+	if (rc != EOK)
+		return EIO;
 
-	if (ferror(img)) {
-		fibril_mutex_unlock(&dev_lock);
-		return EIO;	/* Read error */
+	if (nbytes < bytes) {
+		/* A short read means reading beyond the end of the image. */
+		return write ? EIO : EINVAL;
 	}
 
-	fibril_mutex_unlock(&dev_lock);
+	return EOK;
+}
 
-	if (n_rd < cnt)
-		return EINVAL;	/* Read beyond end of device */
+/** Read blocks from the device. */
+static errno_t file_bd_read_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt, void *buf,
+    size_t size)
+{
+	if (size < cnt * block_size)
+		return EINVAL;
 
-	return EOK;
+	errno_t rc = file_bd_check(ba, cnt);
+	if (rc != EOK)
+		return rc;
+
+	return file_bd_transfer(ba, cnt, buf, false);
 }
 
 /** Write blocks to the device. */
 static errno_t file_bd_write_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt,
     const void *buf, size_t size)
 {
-	size_t n_wr;
-
 	if (size < cnt * block_size)
 		return EINVAL;
 
-	/* Check whether access is within device address bounds. */
-	if (ba + cnt > num_blocks) {
-		printf(NAME ": Accessed blocks %" PRIuOFF64 "-%" PRIuOFF64 ", while "
-		    "max block number is %" PRIuOFF64 ".\n", ba, ba + cnt - 1,
-		    num_blocks - 1);
-		return ELIMIT;
-	}
+	errno_t rc = file_bd_check(ba, cnt);
+	if (rc != EOK)
+		return rc;
 
-	fibril_mutex_lock(&dev_lock);
+	return file_bd_transfer(ba, cnt, (void *) buf, true);
+}
 
-	clearerr(img);
-	if (fseek(img, ba * block_size, SEEK_SET) < 0) {
-		fibril_mutex_unlock(&dev_lock);
+/** Flush the image to its backing store. */
+static errno_t file_bd_sync_cache(bd_srv_t *bd, aoff64_t ba, size_t cnt)
+{
+	if (vfs_sync(img) != EOK)
 		return EIO;
-	}
 
-	n_wr = fwrite(buf, block_size, cnt, img);
+	return EOK;
+}
 
-	if (ferror(img) || n_wr < cnt) {
-		fibril_mutex_unlock(&dev_lock);
-		return EIO;	/* Write error */
+/** Drop a reference to a vectored request, completing it with the last. */
+static void file_bd_io_put(file_bd_io_t *fio, errno_t rc)
+{
+	fibril_mutex_lock(&fio->lock);
+	if (rc != EOK && fio->rc == EOK)
+		fio->rc = rc;
+	bool last = --fio->pending == 0;
+	fibril_mutex_unlock(&fio->lock);
+
+	if (last) {
+		bd_io_done(fio->io, fio->rc);
+		free(fio);
 	}
+}
 
-	if (fflush(img) != 0) {
-		fibril_mutex_unlock(&dev_lock);
-		return EIO;
+/** Transfer one run of extents of a vectored request. */
+static errno_t file_bd_run_fibril(void *arg)
+{
+	file_bd_run_t *run = (file_bd_run_t *) arg;
+	bd_io_t *io = run->fio->io;
+
+	errno_t rc = file_bd_check(run->ba, run->cnt);
+	if (rc == EOK) {
+		rc = file_bd_transfer(run->ba, run->cnt,
+		    bd_io_buf(io, run->first), io->write);
 	}
 
-	fibril_mutex_unlock(&dev_lock);
+	file_bd_io_put(run->fio, rc);
+	free(run);
+	return EOK;
+}
+
+/** Start a vectored request.
+ *
+ * Extents which are adjacent both on the device and in the shared buffer
+ * are coalesced into runs, each of which is transferred with a single
+ * request to VFS. The runs are transferred by fibrils of their own, so that
+ * all of them can be in flight at the same time.
+ */
+static errno_t file_bd_submit(bd_srv_t *bd, bd_io_t *io)
+{
+	file_bd_io_t *fio;
+	size_t i;
+
+	fio = calloc(1, sizeof(file_bd_io_t));
+	if (fio == NULL)
+		return ENOMEM;
+
+	fio->io = io;
+	fibril_mutex_initialize(&fio->lock);
+	fio->pending = 1;
+	fio->rc = EOK;
+
+	i = 0;
+	while (i < io->nvec) {
+		size_t first = i;
+		uint64_t cnt = io->vec[i].cnt;
+
+		while (i + 1 < io->nvec &&
+		    io->vec[i + 1].ba == io->vec[i].ba + io->vec[i].cnt &&
+		    io->vec[i + 1].offs == io->vec[i].offs +
+		    io->vec[i].cnt * block_size) {
+			++i;
+			cnt += io->vec[i].cnt;
+		}
+		++i;
+
+		file_bd_run_t *run = calloc(1, sizeof(file_bd_run_t));
+		fid_t fid = 0;
+
+		if (run != NULL) {
+			run->fio = fio;
+			run->first = first;
+			run->ba = io->vec[first].ba;
+			run->cnt = cnt;
+			fid = fibril_create(file_bd_run_fibril, run);
+		}
+
+		if (fid == 0) {
+			free(run);
+			fibril_mutex_lock(&fio->lock);
+			fio->rc = ENOMEM;
+			fibril_mutex_unlock(&fio->lock);
+			continue;
+		}
+
+		fibril_mutex_lock(&fio->lock);
+		fio->pending++;
+		fibril_mutex_unlock(&fio->lock);
+		fibril_add_ready(fid);
+	}
 
+	/* Drop the reference held while submitting. */
+	file_bd_io_put(fio, EOK);
 	return EOK;
 }
 
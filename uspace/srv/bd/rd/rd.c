@@ -72,6 +72,7 @@ static errno_t rd_read_blocks(bd_srv_t *, aoff64_t, size_t, void *, size_t);
 static errno_t rd_write_blocks(bd_srv_t *, aoff64_t, size_t, const void *, size_t);
 static errno_t rd_get_block_size(bd_srv_t *, size_t *);
 static errno_t rd_get_num_blocks(bd_srv_t *, aoff64_t *);
+static errno_t rd_map(bd_srv_t *, void **, size_t *);
 
 /** This rwlock protects the ramdisk's data.
  *
@@ -88,7 +89,8 @@ static bd_ops_t rd_bd_ops = {
 	.read_blocks = rd_read_blocks,
 	.write_blocks = rd_write_blocks,
 	.get_block_size = rd_get_block_size,
-	.get_num_blocks = rd_get_num_blocks
+	.get_num_blocks = rd_get_num_blocks,
+	.map = rd_map
 };
 
 static bd_srvs_t bd_srvs;
@@ -209,6 +211,18 @@ static errno_t rd_get_num_blocks(bd_srv_t *bd, aoff64_t *rnb)
 	return EOK;
 }
 
+/** Get the image of the device to be mapped by a client.
+ *
+ * Clients write to the mapping without taking rd_lock. The lock only
+ * orders requests served by this server.
+ */
+static errno_t rd_map(bd_srv_t *bd, void **rimage, size_t *rsize)
+{
+	*rimage = rd_addr;
+	*rsize = ALIGN_UP(rd_size, PAGE_SIZE);
+	return EOK;
+}
+
 int main(int argc, char **argv)
 {
 	printf("%s: HelenOS RAM disk server\n", NAME);
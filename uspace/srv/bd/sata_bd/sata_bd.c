@@ -36,8 +36,12 @@
  *
  */
 
+#include <as.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <bd_srv.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <devman.h>
 #include <errno.h>
 #include <str_error.h>
@@ -65,6 +69,7 @@ static errno_t sata_bd_read_blocks(bd_srv_t *, aoff64_t, size_t, void *, size_t)
 static errno_t sata_bd_write_blocks(bd_srv_t *, aoff64_t, size_t, const void *, size_t);
 static errno_t sata_bd_get_block_size(bd_srv_t *, size_t *);
 static errno_t sata_bd_get_num_blocks(bd_srv_t *, aoff64_t *);
+static errno_t sata_bd_submit(bd_srv_t *, bd_io_t *);
 
 static bd_ops_t sata_bd_ops = {
 	.open = sata_bd_open,
@@ -72,9 +77,30 @@ static bd_ops_t sata_bd_ops = {
 	.read_blocks = sata_bd_read_blocks,
 	.write_blocks = sata_bd_write_blocks,
 	.get_block_size = sata_bd_get_block_size,
-	.get_num_blocks = sata_bd_get_num_blocks
+	.get_num_blocks = sata_bd_get_num_blocks,
+	.submit = sata_bd_submit
 };
 
+/** Vectored request in progress. */
+typedef struct {
+	/** Vectored request of the client. */
+	bd_io_t *io;
+	/** Protects @c pending and @c rc. */
+	fibril_mutex_t lock;
+	/** Number of extents in flight, plus one while submitting. */
+	unsigned pending;
+	/** Result of the request. */
+	errno_t rc;
+} sata_bd_io_t;
+
+/** Extent of a vectored request passed to the device. */
+typedef struct {
+	sata_bd_dev_t *sbd;
+	sata_bd_io_t *sio;
+	/** Index of the extent. */
+	size_t i;
+} sata_bd_ext_t;
+
 static sata_bd_dev_t *bd_srv_sata(bd_srv_t *bd)
 {
 	return (sata_bd_dev_t *) bd->srvs->sarg;
@@ -224,6 +250,106 @@ static errno_t sata_bd_write_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
 	return ahci_write_blocks(sbd->sess, ba, cnt, (void *)buf);
 }
 
+/** Drop a reference to a vectored request, completing it with the last. */
+static void sata_bd_io_put(sata_bd_io_t *sio, errno_t rc)
+{
+	fibril_mutex_lock(&sio->lock);
+	if (rc != EOK && sio->rc == EOK)
+		sio->rc = rc;
+	bool last = --sio->pending == 0;
+	fibril_mutex_unlock(&sio->lock);
+
+	if (last) {
+		bd_io_done(sio->io, sio->rc);
+		free(sio);
+	}
+}
+
+/** Transfer one extent of a vectored request.
+ *
+ * The device receives the data in an area shared with it, so the data
+ * are copied through an area of their own.
+ */
+static errno_t sata_bd_ext_fibril(void *arg)
+{
+	sata_bd_ext_t *ext = (sata_bd_ext_t *) arg;
+	bd_io_t *io = ext->sio->io;
+	bd_vec_t *vec = &io->vec[ext->i];
+	size_t size = vec->cnt * ext->sbd->block_size;
+	errno_t rc;
+
+	void *buf = as_area_create(AS_AREA_ANY, size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (buf == AS_MAP_FAILED) {
+		rc = ENOMEM;
+		goto out;
+	}
+
+	if (io->write) {
+		memcpy(buf, bd_io_buf(io, ext->i), size);
+		rc = ahci_write_blocks(ext->sbd->sess, vec->ba, vec->cnt, buf);
+	} else {
+		rc = ahci_read_blocks(ext->sbd->sess, vec->ba, vec->cnt, buf);
+		if (rc == EOK)
+			memcpy(bd_io_buf(io, ext->i), buf, size);
+	}
+
+	as_area_destroy(buf);
+out:
+	sata_bd_io_put(ext->sio, rc);
+	free(ext);
+	return EOK;
+}
+
+/** Start a vectored request.
+ *
+ * Each extent is passed to the device by a fibril of its own, so that the
+ * device can have all of them queued at the same time.
+ */
+static errno_t sata_bd_submit(bd_srv_t *bd, bd_io_t *io)
+{
+	sata_bd_dev_t *sbd = bd_srv_sata(bd);
+	sata_bd_io_t *sio;
+
+	sio = calloc(1, sizeof(sata_bd_io_t));
+	if (sio == NULL)
+		return ENOMEM;
+
+	sio->io = io;
+	fibril_mutex_initialize(&sio->lock);
+	sio->pending = 1;
+	sio->rc = EOK;
+
+	for (size_t i = 0; i < io->nvec; i++) {
+		sata_bd_ext_t *ext = calloc(1, sizeof(sata_bd_ext_t));
+		fid_t fid = 0;
+
+		if (ext != NULL) {
+			ext->sbd = sbd;
+			ext->sio = sio;
+			ext->i = i;
+			fid = fibril_create(sata_bd_ext_fibril, ext);
+		}
+
+		if (fid == 0) {
+			free(ext);
+			fibril_mutex_lock(&sio->lock);
+			sio->rc = ENOMEM;
+			fibril_mutex_unlock(&sio->lock);
+			continue;
+		}
+
+		fibril_mutex_lock(&sio->lock);
+		sio->pending++;
+		fibril_mutex_unlock(&sio->lock);
+		fibril_add_ready(fid);
+	}
+
+	/* Drop the reference held while submitting. */
+	sata_bd_io_put(sio, EOK);
+	return EOK;
+}
+
 /** Get device block size. */
 static errno_t sata_bd_get_block_size(bd_srv_t *bd, size_t *rsize)
 {
@@ -34,6 +34,7 @@
  */
 
 #include <adt/list.h>
+#include <bd.h>
 #include <bd_srv.h>
 #include <block.h>
 #include <errno.h>
@@ -41,6 +42,7 @@
 #include <io/log.h>
 #include <label/empty.h>
 #include <label/label.h>
+#include <ipc/services.h>
 #include <loc.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -68,6 +70,9 @@ static errno_t vbds_bd_write_blocks(bd_srv_t *, aoff64_t, size_t, const void *,
     size_t);
 static errno_t vbds_bd_get_block_size(bd_srv_t *, size_t *);
 static errno_t vbds_bd_get_num_blocks(bd_srv_t *, aoff64_t *);
+static errno_t vbds_bd_submit(bd_srv_t *, bd_io_t *);
+static errno_t vbds_bd_forward(bd_srv_t *, aoff64_t, size_t, async_sess_t **,
+    aoff64_t *);
 
 static errno_t vbds_bsa_translate(vbds_part_t *, aoff64_t, size_t, aoff64_t *);
 
@@ -90,7 +95,9 @@ static bd_ops_t vbds_bd_ops = {
 	.sync_cache = vbds_bd_sync_cache,
 	.write_blocks = vbds_bd_write_blocks,
 	.get_block_size = vbds_bd_get_block_size,
-	.get_num_blocks = vbds_bd_get_num_blocks
+	.get_num_blocks = vbds_bd_get_num_blocks,
+	.submit = vbds_bd_submit,
+	.forward = vbds_bd_forward
 };
 
 /** Provide disk access to liblabel */
@@ -959,6 +966,15 @@ static errno_t vbds_bd_close(bd_srv_t *bd)
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "vbds_bd_close()");
 
+	if (bd->carg != NULL) {
+		vbds_fwd_t *fwd = (vbds_fwd_t *) bd->carg;
+
+		bd_close(fwd->bd);
+		async_hangup(fwd->sess);
+		free(fwd);
+		bd->carg = NULL;
+	}
+
 	/* Grabbing writer lock also forces all I/O to complete */
 
 	fibril_rwlock_write_lock(&part->lock);
@@ -1068,6 +1084,177 @@ static errno_t vbds_bd_get_num_blocks(bd_srv_t *bd, aoff64_t *rnb)
 	return EOK;
 }
 
+/** Open a session to the disk for forwarding requests. */
+static errno_t vbds_fwd_open(vbds_part_t *part, vbds_fwd_t **rfwd)
+{
+	vbds_fwd_t *fwd;
+	errno_t rc;
+
+	fwd = calloc(1, sizeof(vbds_fwd_t));
+	if (fwd == NULL)
+		return ENOMEM;
+
+	fwd->sess = loc_service_connect(part->disk->svc_id, INTERFACE_BLOCK,
+	    0);
+	if (fwd->sess == NULL) {
+		rc = EIO;
+		goto error;
+	}
+
+	rc = bd_open(fwd->sess, &fwd->bd);
+	if (rc != EOK)
+		goto error;
+
+	*rfwd = fwd;
+	return EOK;
+error:
+	if (fwd->bd != NULL)
+		bd_close(fwd->bd);
+	if (fwd->sess != NULL)
+		async_hangup(fwd->sess);
+	free(fwd);
+	return rc;
+}
+
+/** Get the forwarding session of a client, opening it if needed.
+ *
+ * Caller must hold the partition lock.
+ *
+ * @return	Forwarding session or @c NULL if the disk cannot be reached.
+ */
+static vbds_fwd_t *vbds_fwd_get(vbds_part_t *part, bd_srv_t *bd)
+{
+	if (bd->carg == NULL) {
+		vbds_fwd_t *fwd;
+
+		if (vbds_fwd_open(part, &fwd) == EOK)
+			bd->carg = fwd;
+	}
+
+	return (vbds_fwd_t *) bd->carg;
+}
+
+/** Translate a read or write request to be forwarded to the disk.
+ *
+ * The request is forwarded with the block address translated, so that the
+ * data are transferred directly between the client and the disk.
+ */
+static errno_t vbds_bd_forward(bd_srv_t *bd, aoff64_t ba, size_t cnt,
+    async_sess_t **rsess, aoff64_t *rgba)
+{
+	vbds_part_t *part = bd_srv_part(bd);
+	aoff64_t gba;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG2, "vbds_bd_forward()");
+	fibril_rwlock_read_lock(&part->lock);
+
+	if (vbds_bsa_translate(part, ba, cnt, &gba) != EOK) {
+		fibril_rwlock_read_unlock(&part->lock);
+		return ELIMIT;
+	}
+
+	vbds_fwd_t *fwd = vbds_fwd_get(part, bd);
+	fibril_rwlock_read_unlock(&part->lock);
+
+	/* Fall back to copying the data through the block library. */
+	if (fwd == NULL)
+		return ENOTSUP;
+
+	*rsess = fwd->sess;
+	*rgba = gba;
+	return EOK;
+}
+
+static void vbds_io_done(bd_req_t *req, errno_t rc)
+{
+	vbds_io_t *vio = (vbds_io_t *) req->arg;
+
+	bd_io_done(vio->io, rc);
+	free(vio);
+}
+
+/** Carry out a vectored request using the block library. */
+static errno_t vbds_io_direct(vbds_part_t *part, vbds_io_t *vio)
+{
+	bd_io_t *io = vio->io;
+	errno_t rc = EOK;
+
+	for (size_t i = 0; i < io->nvec && rc == EOK; i++) {
+		if (io->write) {
+			rc = block_write_direct(part->disk->svc_id,
+			    vio->vec[i].ba, vio->vec[i].cnt, bd_io_buf(io, i));
+		} else {
+			rc = block_read_direct(part->disk->svc_id,
+			    vio->vec[i].ba, vio->vec[i].cnt, bd_io_buf(io, i));
+		}
+	}
+
+	return rc;
+}
+
+static errno_t vbds_bd_submit(bd_srv_t *bd, bd_io_t *io)
+{
+	vbds_part_t *part = bd_srv_part(bd);
+	vbds_io_t *vio;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG2, "vbds_bd_submit()");
+
+	vio = calloc(1, sizeof(vbds_io_t));
+	if (vio == NULL)
+		return ENOMEM;
+
+	vio->io = io;
+
+	fibril_rwlock_read_lock(&part->lock);
+
+	for (size_t i = 0; i < io->nvec; i++) {
+		if (vbds_bsa_translate(part, io->vec[i].ba, io->vec[i].cnt,
+		    &vio->vec[i].ba) != EOK) {
+			fibril_rwlock_read_unlock(&part->lock);
+			free(vio);
+			return ELIMIT;
+		}
+
+		vio->vec[i].cnt = io->vec[i].cnt;
+		vio->vec[i].offs = io->vec[i].offs;
+	}
+
+	/*
+	 * The buffer shared by the client is shared further with the disk
+	 * so that the disk transfers the data directly to or from the client.
+	 */
+	vbds_fwd_t *fwd = vbds_fwd_get(part, bd);
+	if (fwd != NULL && !fwd->shared &&
+	    bd_buf_share(fwd->bd, bd->buf, bd->buf_size) == EOK)
+		fwd->shared = true;
+
+	if (fwd == NULL || !fwd->shared) {
+		/* The disk does not accept the buffer, copy the data. */
+		rc = vbds_io_direct(part, vio);
+		fibril_rwlock_read_unlock(&part->lock);
+		free(vio);
+		bd_io_done(io, rc);
+		return EOK;
+	}
+
+	fibril_rwlock_read_unlock(&part->lock);
+
+	vio->req.write = io->write;
+	vio->req.vec = vio->vec;
+	vio->req.nvec = io->nvec;
+	vio->req.done = vbds_io_done;
+	vio->req.arg = vio;
+
+	rc = bd_submit(fwd->bd, &vio->req);
+	if (rc != EOK) {
+		free(vio);
+		return rc;
+	}
+
+	return EOK;
+}
+
 void vbds_bd_conn(ipc_call_t *icall, void *arg)
 {
 	vbds_part_t *part;
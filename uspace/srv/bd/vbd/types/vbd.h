@@ -38,6 +38,7 @@
 #define TYPES_VBDS_H_
 
 #include <adt/list.h>
+#include <bd.h>
 #include <bd_srv.h>
 #include <label/label.h>
 #include <loc.h>
@@ -85,6 +86,26 @@ typedef struct {
 	atomic_refcount_t refcnt;
 } vbds_part_t;
 
+/** Client session forwarding requests to the disk */
+typedef struct {
+	/** Session to the disk */
+	async_sess_t *sess;
+	/** Block device, sharing the buffer of the client once @c shared */
+	bd_t *bd;
+	/** The buffer of the client is shared with the disk */
+	bool shared;
+} vbds_fwd_t;
+
+/** Vectored request forwarded to the disk */
+typedef struct {
+	/** Request to the disk */
+	bd_req_t req;
+	/** Request of the client */
+	bd_io_t *io;
+	/** Extents translated to disk addresses */
+	bd_vec_t vec[BD_VEC_MAX];
+} vbds_io_t;
+
 /** Disk */
 typedef struct vbds_disk {
 	/** Link to vbds_disks */
@@ -97,6 +97,8 @@ typedef struct driver_list {
 	list_t drivers;
 	/** Fibril mutex for list of drivers. */
 	fibril_mutex_t drivers_mutex;
+	/** Drivers indexed by their match ID strings */
+	hash_table_t match_index;
 	/** Next free handle */
 	devman_handle_t next_handle;
 } driver_list_t;
@@ -31,14 +31,18 @@
  * @{
  */
 
+#include <adt/hash.h>
 #include <dirent.h>
 #include <errno.h>
 #include <io/log.h>
+#include <macros.h>
 #include <vfs/vfs.h>
 #include <loc.h>
 #include <str_error.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <task.h>
+#include <time.h>
 
 #include "dev.h"
 #include "devman.h"
@@ -49,19 +53,95 @@
 
 static errno_t driver_reassign_fibril(void *);
 
+/** Entry of the match ID index (driver_list_t.match_index). */
+typedef struct {
+	/** Link to driver_list_t.match_index */
+	ht_link_t link;
+	/** Match ID string (owned by the driver's match ID) */
+	const char *id;
+	/** Driver having this match ID */
+	driver_t *drv;
+} driver_match_t;
+
+/** State shared by fibrils passing devices to a newly started driver. */
+typedef struct {
+	/** Driver the devices are passed to */
+	driver_t *driver;
+	/** Device tree */
+	dev_tree_t *tree;
+	/** Protects @c pending */
+	fibril_mutex_t lock;
+	/** Signalled when @c pending drops to zero */
+	fibril_condvar_t done_cv;
+	/** Number of devices still being passed to the driver */
+	size_t pending;
+} driver_pass_t;
+
+/** Argument of a single device pass fibril. */
+typedef struct {
+	driver_pass_t *pass;
+	dev_node_t *dev;
+} driver_pass_dev_t;
+
+static size_t match_index_key_hash(const void *key)
+{
+	const char *id = key;
+	size_t hash = 0;
+
+	while (*id != '\0')
+		hash = hash * 31 + (uint8_t) *id++;
+
+	return hash_mix(hash);
+}
+
+static size_t match_index_hash(const ht_link_t *item)
+{
+	driver_match_t *match = hash_table_get_inst(item, driver_match_t,
+	    link);
+	return match_index_key_hash(match->id);
+}
+
+static bool match_index_key_equal(const void *key, const ht_link_t *item)
+{
+	driver_match_t *match = hash_table_get_inst(item, driver_match_t,
+	    link);
+	return str_cmp(match->id, key) == 0;
+}
+
+static bool match_index_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	driver_match_t *match1 = hash_table_get_inst(item1, driver_match_t,
+	    link);
+	driver_match_t *match2 = hash_table_get_inst(item2, driver_match_t,
+	    link);
+	return str_cmp(match1->id, match2->id) == 0;
+}
+
+static hash_table_ops_t match_index_ops = {
+	.hash = match_index_hash,
+	.key_hash = match_index_key_hash,
+	.key_equal = match_index_key_equal,
+	.equal = match_index_equal,
+	.remove_callback = NULL
+};
+
 /**
  * Initialize the list of device driver's.
  *
  * @param drv_list the list of device driver's.
+ * @return True on success, false if out of memory.
  *
  */
-void init_driver_list(driver_list_t *drv_list)
+bool init_driver_list(driver_list_t *drv_list)
 {
 	assert(drv_list != NULL);
 
 	list_initialize(&drv_list->drivers);
 	fibril_mutex_initialize(&drv_list->drivers_mutex);
 	drv_list->next_handle = 1;
+
+	return hash_table_create(&drv_list->match_index, 0, 0,
+	    &match_index_ops);
 }
 
 /** Allocate and initialize a new driver structure.
@@ -77,19 +157,43 @@ driver_t *create_driver(void)
 }
 
 /** Add a driver to the list of drivers.
+ *
+ * The driver's match IDs are entered into the match ID index so that
+ * candidate drivers for a device can be found without going through
+ * the whole list.
  *
  * @param drivers_list	List of drivers.
  * @param drv		Driver structure.
+ * @return		True on success, false if out of memory.
  */
-void add_driver(driver_list_t *drivers_list, driver_t *drv)
+bool add_driver(driver_list_t *drivers_list, driver_t *drv)
 {
+	driver_match_t *matches;
+	size_t nids;
+	size_t i;
+
+	nids = list_count(&drv->match_ids.ids);
+	matches = calloc(max(nids, 1), sizeof(driver_match_t));
+	if (matches == NULL)
+		return false;
+
 	fibril_mutex_lock(&drivers_list->drivers_mutex);
 	list_append(&drv->drivers, &drivers_list->drivers);
 	drv->handle = drivers_list->next_handle++;
+
+	i = 0;
+	list_foreach(drv->match_ids.ids, link, match_id_t, mid) {
+		matches[i].id = mid->id;
+		matches[i].drv = drv;
+		hash_table_insert(&drivers_list->match_index, &matches[i].link);
+		++i;
+	}
+
 	fibril_mutex_unlock(&drivers_list->drivers_mutex);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Driver `%s' was added to the list of available "
 	    "drivers.", drv->name);
+	return true;
 }
 
 /**
@@ -186,7 +290,13 @@ int lookup_available_drivers(driver_list_t *drivers_list, const char *dir_path)
 		driver_t *drv = create_driver();
 		while ((diren = readdir(dir))) {
 			if (get_driver_info(dir_path, diren->d_name, drv)) {
-				add_driver(drivers_list, drv);
+				if (!add_driver(drivers_list, drv)) {
+					log_msg(LOG_DEFAULT, LVL_ERROR,
+					    "Out of memory adding driver `%s'.",
+					    drv->name);
+					clean_driver(drv);
+					continue;
+				}
 				drv_cnt++;
 				drv = create_driver();
 			}
@@ -211,6 +321,11 @@ int lookup_available_drivers(driver_list_t *drivers_list, const char *dir_path)
  * same score in the list of drivers, or a driver with the next best score
  * (greater than zero).
  *
+ * Only drivers sharing at least one match ID with the device can score
+ * above zero, so the candidates are taken from the match ID index.
+ * Handles are assigned in list order, which lets us preserve the list
+ * order tie-breaking without walking the list.
+ *
  * @param drivers_list	The list of drivers, where we look for the driver
  *			suitable for handling the device.
  * @param node		The device node structure of the device.
@@ -220,51 +335,53 @@ int lookup_available_drivers(driver_list_t *drivers_list, const char *dir_path)
 driver_t *find_best_match_driver(driver_list_t *drivers_list, dev_node_t *node)
 {
 	driver_t *best_drv = NULL;
+	driver_t *next_drv = NULL;
 	int best_score = 0, score = 0;
 	int cur_score;
-	link_t *link;
+	ht_link_t *first;
+	ht_link_t *cur;
 
 	fibril_mutex_lock(&drivers_list->drivers_mutex);
 
-	if (node->drv != NULL) {
+	if (node->drv != NULL)
 		cur_score = get_match_score(node->drv, node);
+	else
+		cur_score = INT_MAX;
 
-		link = list_next(&node->drv->drivers, &drivers_list->drivers);
+	list_foreach(node->pfun->match_ids.ids, link, match_id_t, mid) {
+		first = hash_table_find(&drivers_list->match_index, mid->id);
+		cur = first;
+		while (cur != NULL) {
+			driver_match_t *match = hash_table_get_inst(cur,
+			    driver_match_t, link);
+			driver_t *drv = match->drv;
 
-		/*
-		 * Find next driver with score equal to the current.
-		 */
-		while (link != NULL) {
-			driver_t *drv = list_get_instance(link, driver_t,
-			    drivers);
-			score = get_match_score(drv, node);
-			if (score == cur_score) {
-				/* Found it */
-				fibril_mutex_unlock(&drivers_list->drivers_mutex);
-				return drv;
-			}
+			cur = hash_table_find_next(&drivers_list->match_index,
+			    first, cur);
 
-			link = list_next(link, &drivers_list->drivers);
-		}
-
-		/* There is no driver with the same score */
-	} else {
-		cur_score = INT_MAX;
-	}
+			score = get_match_score(drv, node);
 
-	/*
-	 * Find driver with the next best score
-	 */
-	list_foreach(drivers_list->drivers, drivers, driver_t, drv) {
-		score = get_match_score(drv, node);
-		if (score > best_score && score < cur_score) {
-			best_score = score;
-			best_drv = drv;
+			/*
+			 * Next driver (in list order) with score equal to
+			 * the current.
+			 */
+			if (node->drv != NULL && score == cur_score &&
+			    drv->handle > node->drv->handle &&
+			    (next_drv == NULL || drv->handle < next_drv->handle))
+				next_drv = drv;
+
+			/* Driver with the next best score */
+			if (score > 0 && score < cur_score &&
+			    (score > best_score || (score == best_score &&
+			    drv->handle < best_drv->handle))) {
+				best_score = score;
+				best_drv = drv;
+			}
 		}
 	}
 
 	fibril_mutex_unlock(&drivers_list->drivers_mutex);
-	return best_drv;
+	return next_drv != NULL ? next_drv : best_drv;
 }
 
 /** Assign a driver to a device.
@@ -416,75 +533,176 @@ driver_t *driver_find_by_name(driver_list_t *drv_list, const char *drv_name)
 	return res;
 }
 
+/** Pass a device to a driver, reassigning it if the probe fails.
+ *
+ * @param driver	The driver to which the device is passed.
+ * @param dev		The device.
+ * @param tree		Device tree.
+ */
+static void pass_device(driver_t *driver, dev_node_t *dev, dev_tree_t *tree)
+{
+	add_device(driver, dev, tree);
+
+	/* Device probe failed, need to try next best driver */
+	if (dev->state == DEVICE_NOT_PRESENT) {
+		fibril_mutex_lock(&driver->driver_mutex);
+		list_remove(&dev->driver_devices);
+		fibril_mutex_unlock(&driver->driver_mutex);
+		/* Give an extra reference to driver_reassign_fibril */
+		dev_add_ref(dev);
+		fid_t fid = fibril_create(driver_reassign_fibril, dev);
+		if (fid == 0) {
+			log_msg(LOG_DEFAULT, LVL_ERROR,
+			    "Error creating fibril to assign driver.");
+			dev_del_ref(dev);
+		} else {
+			fibril_add_ready(fid);
+		}
+	}
+}
+
+/** Fibril passing one device to a newly started driver.
+ *
+ * @param arg	Device pass argument (driver_pass_dev_t *).
+ * @return	EOK
+ */
+static errno_t pass_device_fibril(void *arg)
+{
+	driver_pass_dev_t *pdev = (driver_pass_dev_t *) arg;
+	driver_pass_t *pass = pdev->pass;
+
+	pass_device(pass->driver, pdev->dev, pass->tree);
+
+	/* Delete the reference we got from pass_devices_to_driver(). */
+	dev_del_ref(pdev->dev);
+	free(pdev);
+
+	fibril_mutex_lock(&pass->lock);
+	if (--pass->pending == 0)
+		fibril_condvar_broadcast(&pass->done_cv);
+	fibril_mutex_unlock(&pass->lock);
+
+	return EOK;
+}
+
+/** Pass a device to a newly started driver in a separate fibril.
+ *
+ * If the fibril cannot be created, the device is passed synchronously.
+ * Consumes one reference to @a dev.
+ *
+ * @param pass	Device pass state.
+ * @param dev	Device.
+ */
+static void pass_device_async(driver_pass_t *pass, dev_node_t *dev)
+{
+	driver_pass_dev_t *pdev;
+	fid_t fid;
+
+	pdev = calloc(1, sizeof(driver_pass_dev_t));
+	if (pdev != NULL) {
+		pdev->pass = pass;
+		pdev->dev = dev;
+
+		fibril_mutex_lock(&pass->lock);
+		++pass->pending;
+		fibril_mutex_unlock(&pass->lock);
+
+		fid = fibril_create(pass_device_fibril, pdev);
+		if (fid != 0) {
+			fibril_add_ready(fid);
+			return;
+		}
+
+		fibril_mutex_lock(&pass->lock);
+		--pass->pending;
+		fibril_mutex_unlock(&pass->lock);
+		free(pdev);
+	}
+
+	pass_device(pass->driver, dev, pass->tree);
+	dev_del_ref(dev);
+}
+
 /** Notify driver about the devices to which it was assigned.
  *
  * @param driver	The driver to which the devices are passed.
  */
 static void pass_devices_to_driver(driver_t *driver, dev_tree_t *tree)
 {
+	driver_pass_t pass;
 	dev_node_t *dev;
 	link_t *link;
+	size_t npassed;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "pass_devices_to_driver(driver=\"%s\")",
 	    driver->name);
 
+	pass.driver = driver;
+	pass.tree = tree;
+	fibril_mutex_initialize(&pass.lock);
+	fibril_condvar_initialize(&pass.done_cv);
+	pass.pending = 0;
+
 	fibril_mutex_lock(&driver->driver_mutex);
 
 	/*
 	 * Go through devices list as long as there is some device
-	 * that has not been passed to the driver.
+	 * that has not been passed to the driver. The devices are passed
+	 * in parallel, each in its own fibril, and we wait for all of them
+	 * before looking again.
 	 */
-	link = driver->devices.head.next;
-	while (link != &driver->devices.head) {
-		dev = list_get_instance(link, dev_node_t, driver_devices);
-		fibril_rwlock_write_lock(&tree->rwlock);
+	do {
+		npassed = 0;
 
-		if (dev->passed_to_driver) {
-			fibril_rwlock_write_unlock(&tree->rwlock);
-			link = link->next;
-			continue;
-		}
+		link = driver->devices.head.next;
+		while (link != &driver->devices.head) {
+			dev = list_get_instance(link, dev_node_t,
+			    driver_devices);
+			fibril_rwlock_write_lock(&tree->rwlock);
+
+			if (dev->passed_to_driver) {
+				fibril_rwlock_write_unlock(&tree->rwlock);
+				link = link->next;
+				continue;
+			}
 
-		dev_add_ref(dev);
+			/* Make sure we do not pick the device again */
+			dev->passed_to_driver = true;
+			dev_add_ref(dev);
+			++npassed;
 
-		/*
-		 * Unlock to avoid deadlock when adding device
-		 * handled by itself.
-		 */
-		fibril_mutex_unlock(&driver->driver_mutex);
-		fibril_rwlock_write_unlock(&tree->rwlock);
+			/*
+			 * Unlock to avoid deadlock when adding device
+			 * handled by itself.
+			 */
+			fibril_mutex_unlock(&driver->driver_mutex);
+			fibril_rwlock_write_unlock(&tree->rwlock);
 
-		add_device(driver, dev, tree);
+			pass_device_async(&pass, dev);
 
-		/* Device probe failed, need to try next best driver */
-		if (dev->state == DEVICE_NOT_PRESENT) {
+			/*
+			 * Lock again as we will work with driver's
+			 * structure.
+			 */
 			fibril_mutex_lock(&driver->driver_mutex);
-			list_remove(&dev->driver_devices);
-			fibril_mutex_unlock(&driver->driver_mutex);
-			/* Give an extra reference to driver_reassign_fibril */
-			dev_add_ref(dev);
-			fid_t fid = fibril_create(driver_reassign_fibril, dev);
-			if (fid == 0) {
-				log_msg(LOG_DEFAULT, LVL_ERROR,
-				    "Error creating fibril to assign driver.");
-				dev_del_ref(dev);
-			}
-			fibril_add_ready(fid);
+
+			/*
+			 * Restart the cycle to go through all devices again.
+			 */
+			link = driver->devices.head.next;
 		}
 
-		dev_del_ref(dev);
+		if (npassed > 0) {
+			fibril_mutex_unlock(&driver->driver_mutex);
 
-		/*
-		 * Lock again as we will work with driver's
-		 * structure.
-		 */
-		fibril_mutex_lock(&driver->driver_mutex);
+			fibril_mutex_lock(&pass.lock);
+			while (pass.pending > 0)
+				fibril_condvar_wait(&pass.done_cv, &pass.lock);
+			fibril_mutex_unlock(&pass.lock);
 
-		/*
-		 * Restart the cycle to go through all devices again.
-		 */
-		link = driver->devices.head.next;
-	}
+			fibril_mutex_lock(&driver->driver_mutex);
+		}
+	} while (npassed > 0);
 
 	/*
 	 * Once we passed all devices to the driver, we need to mark the
@@ -630,6 +848,9 @@ again:
  */
 void add_device(driver_t *drv, dev_node_t *dev, dev_tree_t *tree)
 {
+	struct timespec start;
+	struct timespec end;
+
 	/*
 	 * We do not expect to have driver's mutex locked as we do not
 	 * access any structures that would affect driver_t.
@@ -637,6 +858,8 @@ void add_device(driver_t *drv, dev_node_t *dev, dev_tree_t *tree)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "add_device(drv=\"%s\", dev=\"%s\")",
 	    drv->name, dev->pfun->name);
 
+	getuptime(&start);
+
 	/* Send the device to the driver. */
 	devman_handle_t parent_handle;
 	if (dev->pfun) {
@@ -677,6 +900,11 @@ void add_device(driver_t *drv, dev_node_t *dev, dev_tree_t *tree)
 	}
 
 	dev->passed_to_driver = true;
+
+	getuptime(&end);
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "Device `%s' added to driver `%s' "
+	    "in %lld ms (%s).", dev->pfun->pathname, drv->name,
+	    (long long) NSEC2MSEC(ts_sub_diff(&end, &start)), str_error(rc));
 }
 
 errno_t driver_dev_remove(dev_tree_t *tree, dev_node_t *dev)
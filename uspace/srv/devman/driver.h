@@ -37,7 +37,7 @@
 #include <stdbool.h>
 #include "devman.h"
 
-extern void init_driver_list(driver_list_t *);
+extern bool init_driver_list(driver_list_t *);
 extern driver_t *create_driver(void);
 extern bool get_driver_info(const char *, const char *, driver_t *);
 extern int lookup_available_drivers(driver_list_t *, const char *);
@@ -45,7 +45,7 @@ extern int lookup_available_drivers(driver_list_t *, const char *);
 extern driver_t *find_best_match_driver(driver_list_t *, dev_node_t *);
 extern bool assign_driver(dev_node_t *, driver_list_t *, dev_tree_t *);
 
-extern void add_driver(driver_list_t *, driver_t *);
+extern bool add_driver(driver_list_t *, driver_t *);
 extern void attach_driver(dev_tree_t *, dev_node_t *, driver_t *);
 extern void detach_driver(dev_tree_t *, dev_node_t *);
 extern bool start_driver(driver_t *);
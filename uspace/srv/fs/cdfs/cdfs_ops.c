@@ -41,6 +41,7 @@
 #include <adt/list.h>
 #include <adt/hash_table.h>
 #include <adt/hash.h>
+#include <fibril_synch.h>
 #include <mem.h>
 #include <loc.h>
 #include <libfs.h>
@@ -61,6 +62,13 @@
 
 #define NODE_CACHE_SIZE 200
 
+/**
+ * Maximum number of blocks read from the medium at once. Files and
+ * directories are single contiguous extents, so sequential reads are
+ * served from large reads ahead which avoid seeking on optical drives.
+ */
+#define CDFS_RA_BLOCKS  64
+
 /** All root nodes have index 0 */
 #define CDFS_SOME_ROOT  0
 
@@ -216,10 +224,14 @@ typedef enum {
 	CDFS_DIRECTORY
 } cdfs_dentry_type_t;
 
+typedef struct cdfs_node cdfs_node_t;
+
 typedef struct {
-	link_t link;       /**< Siblings list link */
-	fs_index_t index;  /**< Node index */
-	char *name;        /**< Dentry name */
+	link_t link;          /**< Siblings list link */
+	ht_link_t dh_link;    /**< Dentries hash table link */
+	cdfs_node_t *parent;  /**< Directory containing the dentry */
+	fs_index_t index;     /**< Node index */
+	char *name;           /**< Dentry name */
 } cdfs_dentry_t;
 
 typedef uint32_t cdfs_lba_t;
@@ -229,9 +241,14 @@ typedef struct {
 	service_id_t service_id;  /**< Service ID of block device */
 	cdfs_enc_t enc;		  /**< Filesystem string encoding */
 	char *vol_ident;	  /**< Volume identifier */
+
+	fibril_mutex_t ra_lock;	  /**< Protects the read-ahead buffer */
+	uint8_t *ra_buf;	  /**< Blocks read ahead, or NULL */
+	cdfs_lba_t ra_lba;	  /**< First block in the read-ahead buffer */
+	size_t ra_count;	  /**< Number of blocks in the buffer */
 } cdfs_t;
 
-typedef struct {
+struct cdfs_node {
 	fs_node_t *fs_node;       /**< FS node */
 	fs_index_t index;         /**< Node index */
 	cdfs_t *fs;		  /**< File system */
@@ -246,7 +263,7 @@ typedef struct {
 	cdfs_lba_t lba;           /**< LBA of data on disk */
 	bool processed;           /**< If all children have been read */
 	unsigned int opened;      /**< Opened count */
-} cdfs_node_t;
+};
 
 /** String encoding */
 enum {
@@ -275,6 +292,9 @@ static size_t nodes_cached = 0;
 /** Hash table of all cdfs nodes */
 static hash_table_t nodes;
 
+/** Hash table of the dentries of all directories read so far */
+static hash_table_t dentries;
+
 /*
  * Hash table support functions.
  */
@@ -313,6 +333,8 @@ static void nodes_remove_callback(ht_link_t *item)
 		while ((link = list_first(&node->cs_list)) != NULL) {
 			cdfs_dentry_t *dentry = list_get_instance(link, cdfs_dentry_t, link);
 			list_remove(&dentry->link);
+			hash_table_remove_item(&dentries, &dentry->dh_link);
+			free(dentry->name);
 			free(dentry);
 		}
 	}
@@ -322,14 +344,82 @@ static void nodes_remove_callback(ht_link_t *item)
 }
 
 /** Nodes hash table operations */
-static const hash_table_ops_t nodes_ops = {
-	.hash = nodes_hash,
+static const hash_table_ops_t nodes_ops = {	.hash = nodes_hash,
 	.key_hash = nodes_key_hash,
 	.key_equal = nodes_key_equal,
 	.equal = NULL,
 	.remove_callback = nodes_remove_callback
 };
 
+typedef struct {
+	cdfs_node_t *parent;
+	const char *name;
+} dentries_key_t;
+
+static size_t dentries_hash_name(cdfs_node_t *parent, const char *name)
+{
+	size_t hash = hash_combine(0, (uintptr_t) parent);
+	size_t off = 0;
+	char32_t c;
+
+	while ((c = str_decode(name, &off, STR_NO_LIMIT)) != 0)
+		hash = hash_combine(hash, c);
+
+	return hash;
+}
+
+static size_t dentries_key_hash(const void *k)
+{
+	const dentries_key_t *key = k;
+	return dentries_hash_name(key->parent, key->name);
+}
+
+static size_t dentries_hash(const ht_link_t *item)
+{
+	cdfs_dentry_t *dentry =
+	    hash_table_get_inst(item, cdfs_dentry_t, dh_link);
+	return dentries_hash_name(dentry->parent, dentry->name);
+}
+
+static bool dentries_key_equal(const void *k, const ht_link_t *item)
+{
+	cdfs_dentry_t *dentry =
+	    hash_table_get_inst(item, cdfs_dentry_t, dh_link);
+	const dentries_key_t *key = k;
+
+	return key->parent == dentry->parent &&
+	    str_cmp(key->name, dentry->name) == 0;
+}
+
+/** Dentries hash table operations */
+static const hash_table_ops_t dentries_ops = {
+	.hash = dentries_hash,
+	.key_hash = dentries_key_hash,
+	.key_equal = dentries_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Find a dentry of a directory which has been read.
+ *
+ * @param parent Directory node
+ * @param name   Name of the dentry
+ * @return       Dentry or NULL if there is no such dentry
+ */
+static cdfs_dentry_t *dentry_find(cdfs_node_t *parent, const char *name)
+{
+	dentries_key_t key = {
+		.parent = parent,
+		.name = name
+	};
+
+	ht_link_t *link = hash_table_find(&dentries, &key);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, cdfs_dentry_t, dh_link);
+}
+
 static errno_t cdfs_node_get(fs_node_t **rfn, service_id_t service_id,
     fs_index_t index)
 {
@@ -424,10 +514,8 @@ static errno_t link_node(fs_node_t *pfn, fs_node_t *fn, const char *name)
 	assert(parent->type == CDFS_DIRECTORY);
 
 	/* Check for duplicate entries */
-	list_foreach(parent->cs_list, link, cdfs_dentry_t, dentry) {
-		if (str_cmp(dentry->name, name) == 0)
-			return EEXIST;
-	}
+	if (dentry_find(parent, name) != NULL)
+		return EEXIST;
 
 	/* Allocate and initialize the dentry */
 	cdfs_dentry_t *dentry = malloc(sizeof(cdfs_dentry_t));
@@ -442,10 +530,12 @@ static errno_t link_node(fs_node_t *pfn, fs_node_t *fn, const char *name)
 	}
 
 	link_initialize(&dentry->link);
+	dentry->parent = parent;
 	dentry->index = node->index;
 
 	node->lnkcnt++;
 	list_append(&dentry->link, &parent->cs_list);
+	hash_table_insert(&dentries, &dentry->dh_link);
 
 	return EOK;
 }
@@ -565,6 +655,76 @@ static char *cdfs_decode_vol_ident(void *data, size_t dsize, cdfs_enc_t enc)
 	return ident;
 }
 
+/** Read consecutive blocks directly from the medium.
+ *
+ * @param fs  File system
+ * @param lba First block to read
+ * @param cnt Number of blocks to read
+ * @param buf Buffer for @a cnt blocks
+ * @return    EOK on success or an error code
+ */
+static errno_t cdfs_read_blocks(cdfs_t *fs, cdfs_lba_t lba, size_t cnt,
+    void *buf)
+{
+	size_t bsize;
+	errno_t rc = block_get_bsize(fs->service_id, &bsize);
+	if (rc != EOK)
+		return rc;
+
+	if (bsize <= BLOCK_SIZE && (BLOCK_SIZE % bsize) == 0) {
+		size_t n = BLOCK_SIZE / bsize;
+		return block_read_direct(fs->service_id, (aoff64_t) lba * n,
+		    cnt * n, buf);
+	}
+
+	return block_read_bytes_direct(fs->service_id,
+	    (aoff64_t) lba * BLOCK_SIZE, cnt * BLOCK_SIZE, buf);
+}
+
+/** Get a block of an extent through the read-ahead buffer.
+ *
+ * If the block is not in the buffer, it is read together with the blocks
+ * following it up to CDFS_RA_BLOCKS blocks or the end of the extent.
+ * Must be called with the read-ahead lock of the file system held.
+ *
+ * @param fs    File system
+ * @param lba   Block to get
+ * @param end   Block following the last block of the extent
+ * @param data  Place to store the pointer to the data of the block
+ * @param avail Place to store the number of consecutive blocks of the
+ *              extent available in the buffer starting at @a lba
+ * @return      EOK on success or an error code
+ */
+static errno_t cdfs_ra_get(cdfs_t *fs, cdfs_lba_t lba, cdfs_lba_t end,
+    uint8_t **data, size_t *avail)
+{
+	assert(fibril_mutex_is_locked(&fs->ra_lock));
+	assert(lba < end);
+
+	if (fs->ra_buf == NULL) {
+		fs->ra_buf = malloc(CDFS_RA_BLOCKS * BLOCK_SIZE);
+		if (fs->ra_buf == NULL)
+			return ENOMEM;
+	}
+
+	if (fs->ra_count == 0 || lba < fs->ra_lba ||
+	    lba >= fs->ra_lba + fs->ra_count) {
+		size_t cnt = min(end - lba, (cdfs_lba_t) CDFS_RA_BLOCKS);
+
+		fs->ra_count = 0;
+		errno_t rc = cdfs_read_blocks(fs, lba, cnt, fs->ra_buf);
+		if (rc != EOK)
+			return rc;
+
+		fs->ra_lba = lba;
+		fs->ra_count = cnt;
+	}
+
+	*data = fs->ra_buf + (lba - fs->ra_lba) * BLOCK_SIZE;
+	*avail = min(fs->ra_lba + fs->ra_count, end) - lba;
+	return EOK;
+}
+
 static errno_t cdfs_readdir(cdfs_t *fs, fs_node_t *fs_node)
 {
 	cdfs_node_t *node = CDFS_NODE(fs_node);
@@ -577,17 +737,38 @@ static errno_t cdfs_readdir(cdfs_t *fs, fs_node_t *fs_node)
 	if ((node->size % BLOCK_SIZE) != 0)
 		blocks++;
 
+	if (blocks == 0) {
+		node->processed = true;
+		return EOK;
+	}
+
+	/* The directory extent is read in as few requests as possible */
+	uint8_t *buf = malloc(min(blocks, (uint32_t) CDFS_RA_BLOCKS) *
+	    BLOCK_SIZE);
+	if (buf == NULL)
+		return ENOMEM;
+
+	uint32_t buf_first = 0;
+	uint32_t buf_cnt = 0;
+
 	for (uint32_t i = 0; i < blocks; i++) {
-		block_t *block;
-		errno_t rc = block_get(&block, fs->service_id, node->lba + i, BLOCK_FLAGS_NONE);
-		if (rc != EOK)
-			return rc;
+		if (i >= buf_first + buf_cnt) {
+			buf_first = i;
+			buf_cnt = min(blocks - i, (uint32_t) CDFS_RA_BLOCKS);
+			errno_t rc = cdfs_read_blocks(fs, node->lba + i,
+			    buf_cnt, buf);
+			if (rc != EOK) {
+				free(buf);
+				return rc;
+			}
+		}
 
+		uint8_t *data = buf + (i - buf_first) * BLOCK_SIZE;
 		cdfs_dir_t *dir;
 
 		for (size_t offset = 0; offset < BLOCK_SIZE;
 		    offset += dir->length) {
-			dir = (cdfs_dir_t *) (block->data + offset);
+			dir = (cdfs_dir_t *) (data + offset);
 			if (dir->length == 0)
 				break;
 			if (offset + dir->length > BLOCK_SIZE) {
@@ -615,8 +796,10 @@ static errno_t cdfs_readdir(cdfs_t *fs, fs_node_t *fs_node)
 			fs_node_t *fn;
 			errno_t rc = create_node(&fn, fs, dentry_type,
 			    (node->lba + i) * BLOCK_SIZE + offset);
-			if (rc != EOK)
+			if (rc != EOK) {
+				free(buf);
 				return rc;
+			}
 
 			assert(fn != NULL);
 
@@ -626,8 +809,10 @@ static errno_t cdfs_readdir(cdfs_t *fs, fs_node_t *fs_node)
 
 			char *name = cdfs_decode_name(dir->name,
 			    dir->name_length, node->fs->enc, dentry_type);
-			if (name == NULL)
+			if (name == NULL) {
+				free(buf);
 				return EIO;
+			}
 
 			// FIXME: check return value
 
@@ -637,10 +822,9 @@ static errno_t cdfs_readdir(cdfs_t *fs, fs_node_t *fs_node)
 			if (dentry_type == CDFS_FILE)
 				cur->processed = true;
 		}
-
-		block_put(block);
 	}
 
+	free(buf);
 	node->processed = true;
 	return EOK;
 }
@@ -707,11 +891,10 @@ static errno_t cdfs_match(fs_node_t **fn, fs_node_t *pfn, const char *component)
 			return rc;
 	}
 
-	list_foreach(parent->cs_list, link, cdfs_dentry_t, dentry) {
-		if (str_cmp(dentry->name, component) == 0) {
-			*fn = get_cached_node(parent->fs, dentry->index);
-			return EOK;
-		}
+	cdfs_dentry_t *dentry = dentry_find(parent, component);
+	if (dentry != NULL) {
+		*fn = get_cached_node(parent->fs, dentry->index);
+		return EOK;
 	}
 
 	*fn = NULL;
@@ -1063,6 +1246,7 @@ static cdfs_t *cdfs_fs_create(service_id_t sid, cdfs_lba_t altroot)
 		goto error;
 
 	fs->service_id = sid;
+	fibril_mutex_initialize(&fs->ra_lock);
 
 	/* Create root node */
 	errno_t rc = create_node(&rfn, fs, L_DIRECTORY, cdfs_index++);
@@ -1226,6 +1410,7 @@ static void cdfs_fs_destroy(cdfs_t *fs)
 	block_cache_fini(fs->service_id);
 	block_fini(fs->service_id);
 	free(fs->vol_ident);
+	free(fs->ra_buf);
 	free(fs);
 }
 
@@ -1284,25 +1469,30 @@ static errno_t cdfs_read(service_id_t service_id, fs_index_t index, aoff64_t pos
 			*rbytes = 0;
 			async_data_read_finalize(&call, NULL, 0);
 		} else {
+			cdfs_t *fs = node->fs;
 			cdfs_lba_t lba = pos / BLOCK_SIZE;
 			size_t offset = pos % BLOCK_SIZE;
+			cdfs_lba_t end = (node->size + BLOCK_SIZE - 1) /
+			    BLOCK_SIZE;
 
-			*rbytes = min(len, BLOCK_SIZE - offset);
-			*rbytes = min(*rbytes, node->size - pos);
+			fibril_mutex_lock(&fs->ra_lock);
 
-			block_t *block;
-			errno_t rc = block_get(&block, service_id, node->lba + lba,
-			    BLOCK_FLAGS_NONE);
+			uint8_t *data;
+			size_t avail;
+			errno_t rc = cdfs_ra_get(fs, node->lba + lba,
+			    node->lba + end, &data, &avail);
 			if (rc != EOK) {
+				fibril_mutex_unlock(&fs->ra_lock);
 				async_answer_0(&call, rc);
 				return rc;
 			}
 
-			async_data_read_finalize(&call, block->data + offset,
-			    *rbytes);
-			rc = block_put(block);
-			if (rc != EOK)
-				return rc;
+			/* Serve as much as is buffered in one go */
+			*rbytes = min(len, avail * BLOCK_SIZE - offset);
+			*rbytes = min(*rbytes, node->size - pos);
+
+			async_data_read_finalize(&call, data + offset, *rbytes);
+			fibril_mutex_unlock(&fs->ra_lock);
 		}
 	} else {
 		link_t *link = list_nth(&node->cs_list, pos);
@@ -1440,6 +1630,11 @@ bool cdfs_init(void)
 	if (!hash_table_create(&nodes, 0, 0, &nodes_ops))
 		return false;
 
+	if (!hash_table_create(&dentries, 0, 0, &dentries_ops)) {
+		hash_table_destroy(&nodes);
+		return false;
+	}
+
 	return true;
 }
 
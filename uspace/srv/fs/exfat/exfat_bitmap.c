@@ -43,93 +43,290 @@
 #include <byteorder.h>
 #include <align.h>
 #include <assert.h>
+#include <bitops.h>
 #include <fibril_synch.h>
+#include <adt/list.h>
+#include <macros.h>
 #include <mem.h>
+#include <stdlib.h>
+
+/** Number of clusters summarized by one free cluster counter. */
+#define EXFAT_BITMAP_GROUP	4096
+
+/** In-memory copy of the Allocation Bitmap of one mounted file system. */
+typedef struct {
+	link_t link;
+	service_id_t service_id;
+
+	/**
+	 * The lock protects the copy as well as the on-disk bitmap and
+	 * serializes allocation of clusters.
+	 */
+	fibril_mutex_t lock;
+	/**
+	 * One bit per cluster of the data region, set for allocated clusters.
+	 * The bits past the last cluster are set.
+	 */
+	uint32_t *bitmap;
+	/** Number of free clusters in each group of EXFAT_BITMAP_GROUP. */
+	uint16_t *group_free;
+	/** Number of clusters in the data region. */
+	uint32_t clusters;
+	/** Number of free clusters. */
+	uint32_t free;
+	/** Bit where the next search for free clusters starts. */
+	uint32_t next;
+} exfat_bitmap_cache_t;
+
+/** Mutex protecting the list of bitmap copies. */
+static FIBRIL_MUTEX_INITIALIZE(bitmap_cache_lock);
+
+/** List of bitmap copies of mounted file systems. */
+static LIST_INITIALIZE(bitmap_cache_list);
+
+static exfat_bitmap_cache_t *exfat_bitmap_cache_find(service_id_t service_id,
+    bool lock)
+{
+	if (lock)
+		fibril_mutex_lock(&bitmap_cache_lock);
+
+	list_foreach(bitmap_cache_list, link, exfat_bitmap_cache_t, bc) {
+		if (bc->service_id == service_id) {
+			if (lock)
+				fibril_mutex_unlock(&bitmap_cache_lock);
+			return bc;
+		}
+	}
 
-errno_t exfat_bitmap_is_free(exfat_bs_t *bs, service_id_t service_id,
-    exfat_cluster_t clst)
+	if (lock)
+		fibril_mutex_unlock(&bitmap_cache_lock);
+	return NULL;
+}
+
+static bool exfat_bitmap_cache_test(exfat_bitmap_cache_t *bc, uint32_t bit)
 {
-	fs_node_t *fn;
-	block_t *b = NULL;
-	exfat_node_t *bitmapp;
-	uint8_t *bitmap;
-	errno_t rc;
-	bool alloc;
+	return bc->bitmap[bit / 32] & (1U << (bit % 32));
+}
 
-	clst -= EXFAT_CLST_FIRST;
+/** Mark a range of clusters in the bitmap copy.
+ *
+ * @param bc		Locked bitmap copy.
+ * @param first		First bit of the range.
+ * @param count		Number of bits in the range.
+ * @param alloc		True to mark the clusters allocated, false to mark
+ *			them free.
+ */
+static void exfat_bitmap_cache_mark(exfat_bitmap_cache_t *bc, uint32_t first,
+    uint32_t count, bool alloc)
+{
+	uint32_t bit;
 
-	rc = exfat_bitmap_get(&fn, service_id);
-	if (rc != EOK)
-		return rc;
-	bitmapp = EXFAT_NODE(fn);
+	assert(first + count <= bc->clusters);
 
-	aoff64_t offset = clst / 8;
-	rc = exfat_block_get(&b, bs, bitmapp, offset / BPS(bs), BLOCK_FLAGS_NONE);
-	if (rc != EOK) {
-		(void) exfat_node_put(fn);
-		return rc;
+	for (bit = first; bit < first + count; bit++) {
+		assert(exfat_bitmap_cache_test(bc, bit) != alloc);
+
+		if (alloc) {
+			bc->bitmap[bit / 32] |= 1U << (bit % 32);
+			bc->group_free[bit / EXFAT_BITMAP_GROUP]--;
+			bc->free--;
+		} else {
+			bc->bitmap[bit / 32] &= ~(1U << (bit % 32));
+			bc->group_free[bit / EXFAT_BITMAP_GROUP]++;
+			bc->free++;
+		}
 	}
-	bitmap = (uint8_t *)b->data;
-	alloc = bitmap[offset % BPS(bs)] & (1 << (clst % 8));
+}
 
-	rc = block_put(b);
-	if (rc != EOK) {
-		(void) exfat_node_put(fn);
-		return rc;
+/** Find the first free cluster at or after a bit of the bitmap copy.
+ *
+ * @return		The bit of the free cluster or the number of clusters
+ *			if there is none.
+ */
+static uint32_t exfat_bitmap_cache_next_free(exfat_bitmap_cache_t *bc,
+    uint32_t bit)
+{
+	uint32_t word;
+
+	while (bit < bc->clusters) {
+		if (bc->group_free[bit / EXFAT_BITMAP_GROUP] == 0) {
+			bit = ALIGN_DOWN(bit, EXFAT_BITMAP_GROUP) +
+			    EXFAT_BITMAP_GROUP;
+			continue;
+		}
+
+		word = ~bc->bitmap[bit / 32] & (UINT32_MAX << (bit % 32));
+		if (word != 0) {
+			bit = ALIGN_DOWN(bit, 32) + fnzb32(word & (~word + 1));
+			return min(bit, bc->clusters);
+		}
+
+		bit = ALIGN_DOWN(bit, 32) + 32;
 	}
-	rc = exfat_node_put(fn);
-	if (rc != EOK)
-		return rc;
 
-	if (alloc)
-		return ENOENT;
+	return bc->clusters;
+}
 
-	return EOK;
+/** Find the first allocated cluster at or after a bit of the bitmap copy.
+ *
+ * @return		The bit of the allocated cluster or @a limit if there
+ *			is none before it.
+ */
+static uint32_t exfat_bitmap_cache_next_used(exfat_bitmap_cache_t *bc,
+    uint32_t bit, uint32_t limit)
+{
+	uint32_t word;
+
+	while (bit < limit) {
+		if (bit % EXFAT_BITMAP_GROUP == 0 &&
+		    bc->group_free[bit / EXFAT_BITMAP_GROUP] ==
+		    EXFAT_BITMAP_GROUP) {
+			bit += EXFAT_BITMAP_GROUP;
+			continue;
+		}
+
+		word = bc->bitmap[bit / 32] & (UINT32_MAX << (bit % 32));
+		if (word != 0) {
+			bit = ALIGN_DOWN(bit, 32) + fnzb32(word & (~word + 1));
+			return min(bit, limit);
+		}
+
+		bit = ALIGN_DOWN(bit, 32) + 32;
+	}
+
+	return limit;
 }
 
-errno_t exfat_bitmap_set_cluster(exfat_bs_t *bs, service_id_t service_id,
-    exfat_cluster_t clst)
+/** Find a run of free clusters in the bitmap copy.
+ *
+ * @param bc		Locked bitmap copy.
+ * @param start		Bit where the search starts.
+ * @param end		Bit where the search ends. The run may extend
+ *			past it.
+ * @param count		Number of clusters in the run.
+ * @param first		Place to store the first bit of the run.
+ *
+ * @return		True if a run was found.
+ */
+static bool exfat_bitmap_cache_find_run(exfat_bitmap_cache_t *bc,
+    uint32_t start, uint32_t end, uint32_t count, uint32_t *first)
+{
+	uint32_t bit = start;
+	uint32_t used;
+
+	while (bit < end) {
+		bit = exfat_bitmap_cache_next_free(bc, bit);
+		if (bit >= end || bc->clusters - bit < count)
+			return false;
+
+		used = exfat_bitmap_cache_next_used(bc, bit, bit + count);
+		if (used == bit + count) {
+			*first = bit;
+			return true;
+		}
+
+		bit = used + 1;
+	}
+
+	return false;
+}
+
+/** Write a range of the bitmap copy to the on-disk Allocation Bitmap.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param bc		Locked bitmap copy.
+ * @param first		First bit of the range.
+ * @param count		Number of bits in the range.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t exfat_bitmap_cache_write(exfat_bs_t *bs,
+    exfat_bitmap_cache_t *bc, uint32_t first, uint32_t count)
 {
 	fs_node_t *fn;
-	block_t *b = NULL;
 	exfat_node_t *bitmapp;
-	uint8_t *bitmap;
+	block_t *b;
+	aoff64_t byte, last, end;
+	uint8_t value;
 	errno_t rc;
 
-	clst -= EXFAT_CLST_FIRST;
-
-	rc = exfat_bitmap_get(&fn, service_id);
+	rc = exfat_bitmap_get(&fn, bc->service_id);
 	if (rc != EOK)
 		return rc;
 	bitmapp = EXFAT_NODE(fn);
 
-	aoff64_t offset = clst / 8;
-	rc = exfat_block_get(&b, bs, bitmapp, offset / BPS(bs), BLOCK_FLAGS_NONE);
-	if (rc != EOK) {
-		(void) exfat_node_put(fn);
-		return rc;
+	byte = first / 8;
+	last = (first + count - 1) / 8;
+
+	while (byte <= last) {
+		rc = exfat_block_get(&b, bs, bitmapp, byte / BPS(bs),
+		    BLOCK_FLAGS_NONE);
+		if (rc != EOK) {
+			(void) exfat_node_put(fn);
+			return rc;
+		}
+
+		end = min(last + 1, ALIGN_DOWN(byte, BPS(bs)) + BPS(bs));
+		for (; byte < end; byte++) {
+			value = bc->bitmap[byte / 4] >> (8 * (byte % 4));
+			/* Keep the bits past the last cluster clear. */
+			if ((byte + 1) * 8 > bc->clusters)
+				value &= (1 << (bc->clusters - byte * 8)) - 1;
+			((uint8_t *) b->data)[byte % BPS(bs)] = value;
+		}
+
+		b->dirty = true;
+		rc = block_put(b);
+		if (rc != EOK) {
+			(void) exfat_node_put(fn);
+			return rc;
+		}
 	}
-	bitmap = (uint8_t *)b->data;
-	bitmap[offset % BPS(bs)] |= (1 << (clst % 8));
 
-	b->dirty = true;
-	rc = block_put(b);
+	return exfat_node_put(fn);
+}
+
+/** Mark a range of clusters in the bitmap copy and on the disk.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param bc		Locked bitmap copy.
+ * @param first		First bit of the range.
+ * @param count		Number of bits in the range.
+ * @param alloc		True to allocate the clusters, false to free them.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t exfat_bitmap_cache_update(exfat_bs_t *bs,
+    exfat_bitmap_cache_t *bc, uint32_t first, uint32_t count, bool alloc)
+{
+	errno_t rc;
+
+	if (count == 0)
+		return EOK;
+
+	exfat_bitmap_cache_mark(bc, first, count, alloc);
+	rc = exfat_bitmap_cache_write(bs, bc, first, count);
 	if (rc != EOK) {
-		(void) exfat_node_put(fn);
-		return rc;
+		exfat_bitmap_cache_mark(bc, first, count, !alloc);
+		(void) exfat_bitmap_cache_write(bs, bc, first, count);
 	}
 
-	return exfat_node_put(fn);
+	return rc;
 }
 
-errno_t exfat_bitmap_clear_cluster(exfat_bs_t *bs, service_id_t service_id,
-    exfat_cluster_t clst)
+/** Check the on-disk Allocation Bitmap whether a cluster is free.
+ *
+ * This is used when the file system does not have a bitmap copy.
+ */
+static errno_t exfat_bitmap_is_free_disk(exfat_bs_t *bs,
+    service_id_t service_id, exfat_cluster_t clst)
 {
 	fs_node_t *fn;
 	block_t *b = NULL;
 	exfat_node_t *bitmapp;
 	uint8_t *bitmap;
 	errno_t rc;
+	bool alloc;
 
 	clst -= EXFAT_CLST_FIRST;
 
@@ -139,101 +336,254 @@ errno_t exfat_bitmap_clear_cluster(exfat_bs_t *bs, service_id_t service_id,
 	bitmapp = EXFAT_NODE(fn);
 
 	aoff64_t offset = clst / 8;
-	rc = exfat_block_get(&b, bs, bitmapp, offset / BPS(bs),
-	    BLOCK_FLAGS_NONE);
+	rc = exfat_block_get(&b, bs, bitmapp, offset / BPS(bs), BLOCK_FLAGS_NONE);
 	if (rc != EOK) {
 		(void) exfat_node_put(fn);
 		return rc;
 	}
 	bitmap = (uint8_t *)b->data;
-	bitmap[offset % BPS(bs)] &= ~(1 << (clst % 8));
+	alloc = bitmap[offset % BPS(bs)] & (1 << (clst % 8));
 
-	b->dirty = true;
 	rc = block_put(b);
 	if (rc != EOK) {
 		(void) exfat_node_put(fn);
 		return rc;
 	}
+	rc = exfat_node_put(fn);
+	if (rc != EOK)
+		return rc;
 
-	return exfat_node_put(fn);
+	if (alloc)
+		return ENOENT;
+
+	return EOK;
+}
+
+errno_t exfat_bitmap_is_free(exfat_bs_t *bs, service_id_t service_id,
+    exfat_cluster_t clst)
+{
+	exfat_bitmap_cache_t *bc;
+	bool alloc;
+
+	bc = exfat_bitmap_cache_find(service_id, true);
+	if (!bc)
+		return exfat_bitmap_is_free_disk(bs, service_id, clst);
+
+	clst -= EXFAT_CLST_FIRST;
+	if (clst >= bc->clusters)
+		return ENOENT;
+
+	fibril_mutex_lock(&bc->lock);
+	alloc = exfat_bitmap_cache_test(bc, clst);
+	fibril_mutex_unlock(&bc->lock);
+
+	if (alloc)
+		return ENOENT;
+
+	return EOK;
+}
+
+errno_t exfat_bitmap_set_cluster(exfat_bs_t *bs, service_id_t service_id,
+    exfat_cluster_t clst)
+{
+	return exfat_bitmap_set_clusters(bs, service_id, clst, 1);
+}
+
+errno_t exfat_bitmap_clear_cluster(exfat_bs_t *bs, service_id_t service_id,
+    exfat_cluster_t clst)
+{
+	return exfat_bitmap_clear_clusters(bs, service_id, clst, 1);
 }
 
 errno_t exfat_bitmap_set_clusters(exfat_bs_t *bs, service_id_t service_id,
     exfat_cluster_t firstc, exfat_cluster_t count)
 {
+	exfat_bitmap_cache_t *bc;
+	uint32_t first = firstc - EXFAT_CLST_FIRST;
 	errno_t rc;
-	exfat_cluster_t clst;
-	clst = firstc;
 
-	while (clst < firstc + count) {
-		rc = exfat_bitmap_set_cluster(bs, service_id, clst);
-		if (rc != EOK) {
-			if (clst - firstc > 0)
-				(void) exfat_bitmap_clear_clusters(bs, service_id,
-				    firstc, clst - firstc);
-			return rc;
-		}
-		clst++;
+	bc = exfat_bitmap_cache_find(service_id, true);
+	if (!bc)
+		return ENOENT;
+
+	fibril_mutex_lock(&bc->lock);
+	if (first >= bc->clusters || count > bc->clusters - first ||
+	    exfat_bitmap_cache_next_used(bc, first, first + count) !=
+	    first + count) {
+		fibril_mutex_unlock(&bc->lock);
+		return EINVAL;
 	}
-	return EOK;
+	rc = exfat_bitmap_cache_update(bs, bc, first, count, true);
+	fibril_mutex_unlock(&bc->lock);
+
+	return rc;
 }
 
 errno_t exfat_bitmap_clear_clusters(exfat_bs_t *bs, service_id_t service_id,
     exfat_cluster_t firstc, exfat_cluster_t count)
 {
+	exfat_bitmap_cache_t *bc;
+	uint32_t first = firstc - EXFAT_CLST_FIRST;
 	errno_t rc;
-	exfat_cluster_t clst;
-	clst = firstc;
 
-	while (clst < firstc + count) {
-		rc = exfat_bitmap_clear_cluster(bs, service_id, clst);
-		if (rc != EOK)
-			return rc;
-		clst++;
+	bc = exfat_bitmap_cache_find(service_id, true);
+	if (!bc)
+		return ENOENT;
+
+	fibril_mutex_lock(&bc->lock);
+	if (first >= bc->clusters || count > bc->clusters - first) {
+		fibril_mutex_unlock(&bc->lock);
+		return EINVAL;
 	}
-	return EOK;
+	rc = exfat_bitmap_cache_update(bs, bc, first, count, false);
+	fibril_mutex_unlock(&bc->lock);
+
+	return rc;
 }
 
+/** Allocate a run of contiguous clusters.
+ *
+ * The search starts where the previous allocation ended, so that a new file
+ * is placed into free space where it has room to grow contiguously.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param service_id	Service ID of the file system.
+ * @param firstc	Place to store the first cluster of the run.
+ * @param count		Number of clusters to allocate.
+ *
+ * @return		EOK on success, ENOSPC if there is no such run or
+ *			another error code.
+ */
 errno_t exfat_bitmap_alloc_clusters(exfat_bs_t *bs, service_id_t service_id,
     exfat_cluster_t *firstc, exfat_cluster_t count)
 {
-	exfat_cluster_t startc, endc;
-	startc = EXFAT_CLST_FIRST;
-
-	while (startc < DATA_CNT(bs) + 2) {
-		endc = startc;
-		while (exfat_bitmap_is_free(bs, service_id, endc) == EOK) {
-			if ((endc - startc) + 1 == count) {
-				*firstc = startc;
-				return exfat_bitmap_set_clusters(bs, service_id, startc, count);
-			} else
-				endc++;
+	exfat_bitmap_cache_t *bc;
+	uint32_t first;
+	errno_t rc;
+
+	bc = exfat_bitmap_cache_find(service_id, true);
+	if (!bc)
+		return ENOENT;
+
+	fibril_mutex_lock(&bc->lock);
+
+	if (bc->free < count ||
+	    (!exfat_bitmap_cache_find_run(bc, bc->next, bc->clusters, count,
+	    &first) &&
+	    !exfat_bitmap_cache_find_run(bc, 0, bc->next, count, &first))) {
+		fibril_mutex_unlock(&bc->lock);
+		return ENOSPC;
+	}
+
+	rc = exfat_bitmap_cache_update(bs, bc, first, count, true);
+	if (rc == EOK) {
+		bc->next = first + count;
+		*firstc = first + EXFAT_CLST_FIRST;
+	}
+
+	fibril_mutex_unlock(&bc->lock);
+	return rc;
+}
+
+/** Allocate clusters wherever they are free.
+ *
+ * The clusters are searched in ascending order starting where the previous
+ * allocation ended.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param service_id	Service ID of the file system.
+ * @param clsts		Array where to store the allocated clusters.
+ * @param count		Number of clusters to allocate.
+ *
+ * @return		EOK on success, ENOSPC if there are not enough free
+ *			clusters or another error code.
+ */
+errno_t exfat_bitmap_take_clusters(exfat_bs_t *bs, service_id_t service_id,
+    exfat_cluster_t *clsts, unsigned count)
+{
+	exfat_bitmap_cache_t *bc;
+	uint32_t bit, run;
+	unsigned found = 0;
+	errno_t rc = EOK;
+
+	bc = exfat_bitmap_cache_find(service_id, true);
+	if (!bc)
+		return ENOENT;
+
+	fibril_mutex_lock(&bc->lock);
+
+	if (bc->free < count) {
+		fibril_mutex_unlock(&bc->lock);
+		return ENOSPC;
+	}
+
+	bit = bc->next;
+	while (found < count) {
+		bit = exfat_bitmap_cache_next_free(bc, bit);
+		if (bit >= bc->clusters) {
+			bit = 0;
+			continue;
+		}
+
+		/* Allocate the whole run of free clusters at once. */
+		run = exfat_bitmap_cache_next_used(bc, bit,
+		    bit + min(count - found, bc->clusters - bit)) - bit;
+		rc = exfat_bitmap_cache_update(bs, bc, bit, run, true);
+		if (rc != EOK)
+			break;
+
+		while (run-- > 0)
+			clsts[found++] = EXFAT_CLST_FIRST + bit++;
+	}
+
+	if (rc == EOK) {
+		bc->next = bit;
+	} else {
+		while (found-- > 0) {
+			(void) exfat_bitmap_cache_update(bs, bc,
+			    clsts[found] - EXFAT_CLST_FIRST, 1, false);
 		}
-		startc = endc + 1;
 	}
-	return ENOSPC;
+
+	fibril_mutex_unlock(&bc->lock);
+	return rc;
 }
 
 errno_t exfat_bitmap_append_clusters(exfat_bs_t *bs, exfat_node_t *nodep,
     exfat_cluster_t count)
 {
+	exfat_bitmap_cache_t *bc;
+	exfat_cluster_t lastc;
+	uint32_t first;
+	errno_t rc;
+
 	if (nodep->firstc == 0) {
 		return exfat_bitmap_alloc_clusters(bs, nodep->idx->service_id,
 		    &nodep->firstc, count);
-	} else {
-		exfat_cluster_t lastc, clst;
-		lastc = nodep->firstc + ROUND_UP(nodep->size, BPC(bs)) / BPC(bs) - 1;
-
-		clst = lastc + 1;
-		while (exfat_bitmap_is_free(bs, nodep->idx->service_id, clst) == EOK) {
-			if (clst - lastc == count) {
-				return exfat_bitmap_set_clusters(bs, nodep->idx->service_id,
-				    lastc + 1, count);
-			} else
-				clst++;
-		}
+	}
+
+	bc = exfat_bitmap_cache_find(nodep->idx->service_id, true);
+	if (!bc)
+		return ENOENT;
+
+	lastc = nodep->firstc + ROUND_UP(nodep->size, BPC(bs)) / BPC(bs) - 1;
+	first = lastc + 1 - EXFAT_CLST_FIRST;
+
+	fibril_mutex_lock(&bc->lock);
+
+	if (first >= bc->clusters || count > bc->clusters - first ||
+	    exfat_bitmap_cache_next_used(bc, first, first + count) !=
+	    first + count) {
+		fibril_mutex_unlock(&bc->lock);
 		return ENOSPC;
 	}
+
+	rc = exfat_bitmap_cache_update(bs, bc, first, count, true);
+	if (rc == EOK && bc->next >= first && bc->next < first + count)
+		bc->next = first + count;
+
+	fibril_mutex_unlock(&bc->lock);
+	return rc;
 }
 
 errno_t exfat_bitmap_free_clusters(exfat_bs_t *bs, exfat_node_t *nodep,
@@ -262,6 +612,150 @@ errno_t exfat_bitmap_replicate_clusters(exfat_bs_t *bs, exfat_node_t *nodep)
 	return exfat_set_cluster(bs, service_id, lastc, EXFAT_CLST_EOF);
 }
 
+/** Load the Allocation Bitmap of a file system into memory.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param service_id	Service ID of the file system.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t exfat_bitmap_init_by_service_id(exfat_bs_t *bs,
+    service_id_t service_id)
+{
+	exfat_bitmap_cache_t *bc;
+	fs_node_t *fn;
+	exfat_node_t *bitmapp;
+	block_t *b;
+	uint32_t words, groups, bit;
+	aoff64_t bytes, byte;
+	errno_t rc;
+
+	bc = (exfat_bitmap_cache_t *) malloc(sizeof(exfat_bitmap_cache_t));
+	if (!bc)
+		return ENOMEM;
+
+	link_initialize(&bc->link);
+	bc->service_id = service_id;
+	fibril_mutex_initialize(&bc->lock);
+	bc->clusters = DATA_CNT(bs);
+	bc->free = 0;
+	bc->next = 0;
+
+	words = (bc->clusters + 31) / 32;
+	groups = (bc->clusters + EXFAT_BITMAP_GROUP - 1) / EXFAT_BITMAP_GROUP;
+	bc->bitmap = calloc(words, sizeof(uint32_t));
+	bc->group_free = calloc(groups, sizeof(uint16_t));
+	if (!bc->bitmap || !bc->group_free) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	rc = exfat_bitmap_get(&fn, service_id);
+	if (rc != EOK)
+		goto error;
+	bitmapp = EXFAT_NODE(fn);
+
+	/* Clusters missing from a short bitmap are treated as allocated. */
+	bytes = min(bitmapp->size, (aoff64_t) words * 4);
+	memset(bc->bitmap, 0xff, words * sizeof(uint32_t));
+
+	for (byte = 0; byte < bytes; byte++) {
+		if (byte % BPS(bs) == 0) {
+			rc = exfat_block_get(&b, bs, bitmapp, byte / BPS(bs),
+			    BLOCK_FLAGS_NONE);
+			if (rc != EOK) {
+				(void) exfat_node_put(fn);
+				goto error;
+			}
+		}
+
+		bc->bitmap[byte / 4] &= ~(0xffU << (8 * (byte % 4)));
+		bc->bitmap[byte / 4] |= (uint32_t) ((uint8_t *)
+		    b->data)[byte % BPS(bs)] << (8 * (byte % 4));
+
+		if (byte % BPS(bs) == BPS(bs) - 1 || byte == bytes - 1) {
+			rc = block_put(b);
+			if (rc != EOK) {
+				(void) exfat_node_put(fn);
+				goto error;
+			}
+		}
+	}
+
+	rc = exfat_node_put(fn);
+	if (rc != EOK)
+		goto error;
+
+	for (bit = bc->clusters; bit < words * 32; bit++)
+		bc->bitmap[bit / 32] |= 1U << (bit % 32);
+
+	for (bit = 0; bit < bc->clusters; bit++) {
+		if (!exfat_bitmap_cache_test(bc, bit)) {
+			bc->group_free[bit / EXFAT_BITMAP_GROUP]++;
+			bc->free++;
+		}
+	}
+
+	fibril_mutex_lock(&bitmap_cache_lock);
+	if (!exfat_bitmap_cache_find(service_id, false)) {
+		list_append(&bc->link, &bitmap_cache_list);
+	} else {
+		rc = EEXIST;
+	}
+	fibril_mutex_unlock(&bitmap_cache_lock);
+
+	if (rc == EOK)
+		return EOK;
+
+error:
+	free(bc->bitmap);
+	free(bc->group_free);
+	free(bc);
+	return rc;
+}
+
+/** Drop the in-memory copy of the Allocation Bitmap of a file system.
+ *
+ * @param service_id	Service ID of the file system.
+ */
+void exfat_bitmap_fini_by_service_id(service_id_t service_id)
+{
+	exfat_bitmap_cache_t *bc;
+
+	fibril_mutex_lock(&bitmap_cache_lock);
+	bc = exfat_bitmap_cache_find(service_id, false);
+	assert(bc);
+	list_remove(&bc->link);
+	fibril_mutex_unlock(&bitmap_cache_lock);
+
+	free(bc->bitmap);
+	free(bc->group_free);
+	free(bc);
+}
+
+/** Get the number of free clusters of a file system.
+ *
+ * @param service_id	Service ID of the file system.
+ * @param count		Place to store the number of free clusters.
+ *
+ * @return		EOK on success or ENOENT if the Allocation Bitmap is
+ *			not loaded.
+ */
+errno_t exfat_bitmap_free_count(service_id_t service_id, uint32_t *count)
+{
+	exfat_bitmap_cache_t *bc;
+
+	bc = exfat_bitmap_cache_find(service_id, true);
+	if (!bc)
+		return ENOENT;
+
+	fibril_mutex_lock(&bc->lock);
+	*count = bc->free;
+	fibril_mutex_unlock(&bc->lock);
+
+	return EOK;
+}
+
 /**
  * @}
  */
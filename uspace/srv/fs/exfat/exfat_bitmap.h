@@ -43,6 +43,8 @@ struct exfat_bs;
 
 extern errno_t exfat_bitmap_alloc_clusters(struct exfat_bs *, service_id_t,
     exfat_cluster_t *, exfat_cluster_t);
+extern errno_t exfat_bitmap_take_clusters(struct exfat_bs *, service_id_t,
+    exfat_cluster_t *, unsigned);
 extern errno_t exfat_bitmap_append_clusters(struct exfat_bs *, struct exfat_node *,
     exfat_cluster_t);
 extern errno_t exfat_bitmap_free_clusters(struct exfat_bs *, struct exfat_node *,
@@ -59,6 +61,10 @@ extern errno_t exfat_bitmap_set_clusters(struct exfat_bs *, service_id_t,
 extern errno_t exfat_bitmap_clear_clusters(struct exfat_bs *, service_id_t,
     exfat_cluster_t, exfat_cluster_t);
 
+extern errno_t exfat_bitmap_init_by_service_id(struct exfat_bs *, service_id_t);
+extern void exfat_bitmap_fini_by_service_id(service_id_t);
+extern errno_t exfat_bitmap_free_count(service_id_t, uint32_t *);
+
 #endif
 
 /**
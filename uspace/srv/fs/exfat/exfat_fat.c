@@ -51,13 +51,6 @@
 #include <stdlib.h>
 #include <str.h>
 
-/**
- * The fat_alloc_lock mutex protects all copies of the File Allocation Table
- * during allocation of clusters. The lock does not have to be held durring
- * deallocation of clusters.
- */
-static FIBRIL_MUTEX_INITIALIZE(exfat_alloc_lock);
-
 /** Walk the cluster chain.
  *
  * @param bs		Buffer holding the boot sector for the file.
@@ -156,7 +149,7 @@ exfat_block_get(block_t **block, exfat_bs_t *bs, exfat_node_t *nodep,
 
 	rc = exfat_block_get_by_clst(block, bs, nodep->idx->service_id,
 	    nodep->fragmented, firstc, &currc, relbn, flags);
-	if (rc != EOK)
+	if (rc != EOK || !nodep->fragmented)
 		return rc;
 
 	/*
@@ -298,57 +291,45 @@ errno_t
 exfat_alloc_clusters(exfat_bs_t *bs, service_id_t service_id, unsigned nclsts,
     exfat_cluster_t *mcl, exfat_cluster_t *lcl)
 {
-	exfat_cluster_t *lifo;    /* stack for storing free cluster numbers */
-	unsigned found = 0;     /* top of the free cluster number stack */
-	exfat_cluster_t clst;
-	errno_t rc = EOK;
+	exfat_cluster_t *clsts;	/* allocated clusters in the chain order */
+	unsigned c;
+	errno_t rc;
 
-	lifo = (exfat_cluster_t *) malloc(nclsts * sizeof(exfat_cluster_t));
-	if (!lifo)
+	clsts = (exfat_cluster_t *) malloc(nclsts * sizeof(exfat_cluster_t));
+	if (!clsts)
 		return ENOMEM;
 
-	fibril_mutex_lock(&exfat_alloc_lock);
-	for (clst = EXFAT_CLST_FIRST; clst < DATA_CNT(bs) + 2 && found < nclsts;
-	    clst++) {
-		/* Need to rewrite because of multiple exfat_bitmap_get calls */
-		if (exfat_bitmap_is_free(bs, service_id, clst) == EOK) {
-			/*
-			 * The cluster is free. Put it into our stack
-			 * of found clusters and mark it as non-free.
-			 */
-			lifo[found] = clst;
-			rc = exfat_set_cluster(bs, service_id, clst,
-			    (found == 0) ?  EXFAT_CLST_EOF : lifo[found - 1]);
-			if (rc != EOK)
-				goto exit_error;
-			found++;
-			rc = exfat_bitmap_set_cluster(bs, service_id, clst);
-			if (rc != EOK)
-				goto exit_error;
+	/*
+	 * Take the clusters from the Allocation Bitmap and link them in FAT
+	 * in ascending order.
+	 */
+	rc = exfat_bitmap_take_clusters(bs, service_id, clsts, nclsts);
+	if (rc != EOK) {
+		free(clsts);
+		return rc;
+	}
 
-		}
+	for (c = 0; c < nclsts; c++) {
+		rc = exfat_set_cluster(bs, service_id, clsts[c],
+		    c + 1 == nclsts ? EXFAT_CLST_EOF : clsts[c + 1]);
+		if (rc != EOK)
+			break;
 	}
 
-	if (rc == EOK && found == nclsts) {
-		*mcl = lifo[found - 1];
-		*lcl = lifo[0];
-		free(lifo);
-		fibril_mutex_unlock(&exfat_alloc_lock);
+	if (rc == EOK) {
+		*mcl = clsts[0];
+		*lcl = clsts[nclsts - 1];
+		free(clsts);
 		return EOK;
 	}
 
-	rc = ENOSPC;
-
-exit_error:
-
 	/* If something wrong - free the clusters */
-	while (found--) {
-		(void) exfat_bitmap_clear_cluster(bs, service_id, lifo[found]);
-		(void) exfat_set_cluster(bs, service_id, lifo[found], 0);
+	for (c = 0; c < nclsts; c++) {
+		(void) exfat_set_cluster(bs, service_id, clsts[c], 0);
+		(void) exfat_bitmap_clear_cluster(bs, service_id, clsts[c]);
 	}
 
-	free(lifo);
-	fibril_mutex_unlock(&exfat_alloc_lock);
+	free(clsts);
 	return rc;
 }
 
@@ -50,6 +50,8 @@
 
 vfs_info_t ext4fs_vfs_info = {
 	.name = NAME,
+	.page_cache = true,
+	.name_cache = true,
 	.instance = 0
 };
 
@@ -81,6 +83,9 @@ int main(int argc, char **argv)
 		return rc;
 	}
 
+	/* Requests on different files are safe to run in parallel */
+	fs_enable_multithreaded();
+
 	rc = fs_register(vfs_sess, &ext4fs_vfs_info, &ext4_ops,
 	    &ext4_libfs_ops);
 	if (rc != EOK) {
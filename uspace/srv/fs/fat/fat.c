@@ -55,6 +55,8 @@ vfs_info_t fat_vfs_info = {
 	.name = NAME,
 	.concurrent_read_write = false,
 	.write_retains_size = false,
+	.page_cache = true,
+	.name_cache = true,
 	.instance = 0,
 };
 
@@ -82,6 +84,9 @@ int main(int argc, char **argv)
 		return -1;
 	}
 
+	/* Requests on different files are safe to run in parallel */
+	fs_enable_multithreaded();
+
 	rc = fs_register(vfs_sess, &fat_vfs_info, &fat_ops, &fat_libfs_ops);
 	if (rc != EOK) {
 		fat_idx_fini();
@@ -46,18 +46,300 @@
 #include <byteorder.h>
 #include <align.h>
 #include <assert.h>
+#include <bitops.h>
 #include <fibril_synch.h>
+#include <adt/list.h>
 #include <mem.h>
 #include <stdlib.h>
 
 #define IS_ODD(number)	(number & 0x1)
 
+/** Maximum number of runs cached for the cluster chain of one node. */
+#define FAT_CHAIN_RUNS_MAX	512
+
+/** Number of FAT sectors read at once when building the bitmap. */
+#define FAT_BITMAP_SCAN_SECTORS	64
+
+/** Free cluster bitmap of one mounted file system. */
+typedef struct {
+	link_t link;
+	service_id_t service_id;
+
+	/**
+	 * The lock protects the bitmap and all copies of the File Allocation
+	 * Table during allocation of clusters. Deallocation of clusters only
+	 * needs to hold it while updating the bitmap.
+	 */
+	fibril_mutex_t lock;
+	/** One bit per cluster, set for free clusters. */
+	uint32_t *bitmap;
+	/** Number of clusters described by the bitmap, including reserved. */
+	uint32_t clusters;
+	/** Number of free clusters. */
+	uint32_t free;
+	/** Cluster where the next search for a free cluster starts. */
+	fat_cluster_t next;
+} fat_bitmap_t;
+
+/** Mutex protecting the list of bitmaps. */
+static FIBRIL_MUTEX_INITIALIZE(bitmap_lock);
+
+/** List of bitmaps of mounted file systems. */
+static LIST_INITIALIZE(bitmap_list);
+
 /**
- * The fat_alloc_lock mutex protects all copies of the File Allocation Table
- * during allocation of clusters. The lock does not have to be held durring
- * deallocation of clusters.
+ * Mutex serializing updates of FAT12 entries. Unlike the wider entries,
+ * they share bytes with their neighbours, so that concurrent updates of
+ * adjacent clusters would overwrite each other.
  */
-static FIBRIL_MUTEX_INITIALIZE(fat_alloc_lock);
+static FIBRIL_MUTEX_INITIALIZE(fat12_lock);
+
+static fat_bitmap_t *fat_bitmap_find(service_id_t service_id, bool lock)
+{
+	if (lock)
+		fibril_mutex_lock(&bitmap_lock);
+
+	list_foreach(bitmap_list, link, fat_bitmap_t, bm) {
+		if (bm->service_id == service_id) {
+			if (lock)
+				fibril_mutex_unlock(&bitmap_lock);
+			return bm;
+		}
+	}
+
+	if (lock)
+		fibril_mutex_unlock(&bitmap_lock);
+	return NULL;
+}
+
+/** Mark a cluster free in the bitmap. Must be called with the bitmap locked. */
+static void fat_bitmap_put(fat_bitmap_t *bm, fat_cluster_t clst)
+{
+	assert(clst >= FAT_CLST_FIRST && clst < bm->clusters);
+	assert(!(bm->bitmap[clst / 32] & (1U << (clst % 32))));
+
+	bm->bitmap[clst / 32] |= 1U << (clst % 32);
+	bm->free++;
+}
+
+/** Take a free cluster from the bitmap.
+ *
+ * The search starts where the previous one stopped, so that clusters which
+ * are allocated one after another follow each other on the disk.
+ * Must be called with the bitmap locked and at least one cluster free.
+ *
+ * @param bm		Free cluster bitmap.
+ *
+ * @return		Number of the allocated cluster.
+ */
+static fat_cluster_t fat_bitmap_take(fat_bitmap_t *bm)
+{
+	fat_cluster_t clst = bm->next;
+	uint32_t word;
+
+	assert(bm->free > 0);
+
+	while (true) {
+		if (clst >= bm->clusters)
+			clst = FAT_CLST_FIRST;
+
+		word = bm->bitmap[clst / 32] >> (clst % 32);
+		if (word != 0)
+			break;
+
+		/* Skip the rest of the word. */
+		clst = ALIGN_DOWN(clst, 32) + 32;
+	}
+
+	clst += fnzb32(word & (~word + 1));
+	assert(clst < bm->clusters);
+
+	bm->bitmap[clst / 32] &= ~(1U << (clst % 32));
+	bm->free--;
+	bm->next = clst + 1;
+
+	return clst;
+}
+
+/** Initialize the run-length map of a cluster chain.
+ *
+ * @param chain		Map to initialize.
+ */
+void fat_chain_cache_init(fat_chain_cache_t *chain)
+{
+	fibril_mutex_initialize(&chain->lock);
+	chain->runs = NULL;
+	chain->count = 0;
+	chain->size = 0;
+	chain->clusters = 0;
+	chain->complete = false;
+}
+
+/** Release the run-length map of a cluster chain.
+ *
+ * @param chain		Map to release.
+ */
+void fat_chain_cache_fini(fat_chain_cache_t *chain)
+{
+	free(chain->runs);
+	chain->runs = NULL;
+	chain->count = 0;
+	chain->size = 0;
+}
+
+/** Append a cluster to the run-length map of a cluster chain.
+ *
+ * @param chain		Locked map.
+ * @param clst		Cluster following the last cluster covered by the map.
+ *
+ * @return		True on success, false if the map cannot grow.
+ */
+static bool fat_chain_cache_append(fat_chain_cache_t *chain,
+    fat_cluster_t clst)
+{
+	fat_run_t *run;
+
+	if (chain->count > 0) {
+		run = &chain->runs[chain->count - 1];
+		if (run->clst + run->count == clst) {
+			run->count++;
+			chain->clusters++;
+			return true;
+		}
+	}
+
+	if (chain->count == chain->size) {
+		unsigned size;
+		fat_run_t *runs;
+
+		if (chain->size >= FAT_CHAIN_RUNS_MAX)
+			return false;
+
+		size = chain->size ? 2 * chain->size : 4;
+		runs = realloc(chain->runs, size * sizeof(fat_run_t));
+		if (!runs)
+			return false;
+
+		chain->runs = runs;
+		chain->size = size;
+	}
+
+	run = &chain->runs[chain->count++];
+	run->idx = chain->clusters;
+	run->clst = clst;
+	run->count = 1;
+	chain->clusters++;
+
+	return true;
+}
+
+/** Find a cluster in the run-length map of a cluster chain.
+ *
+ * @param chain		Locked map.
+ * @param idx		Index of the cluster within the chain. Must be covered
+ *			by the map.
+ *
+ * @return		Number of the cluster.
+ */
+static fat_cluster_t fat_chain_cache_lookup(fat_chain_cache_t *chain,
+    uint32_t idx)
+{
+	unsigned lo = 0;
+	unsigned hi = chain->count;
+
+	assert(idx < chain->clusters);
+
+	while (hi - lo > 1) {
+		unsigned mid = (lo + hi) / 2;
+
+		if (chain->runs[mid].idx <= idx)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	return chain->runs[lo].clst + (idx - chain->runs[lo].idx);
+}
+
+/** Extend the run-length map of a node's cluster chain from FAT1.
+ *
+ * The map is extended until it covers the cluster with index @a idx, the end
+ * of the chain is reached or the map cannot grow anymore.
+ *
+ * @param bs		Buffer holding the boot sector for the file.
+ * @param nodep		FAT node with a non-empty cluster chain and its map
+ *			locked.
+ * @param idx		Index of the cluster within the chain.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t fat_chain_cache_extend(fat_bs_t *bs, fat_node_t *nodep,
+    uint32_t idx)
+{
+	fat_chain_cache_t *chain = &nodep->chain;
+	fat_cluster_t clst_last1 = FAT_CLST_LAST1(bs);
+	fat_cluster_t clst;
+	fat_run_t *run;
+	errno_t rc;
+
+	while (!chain->complete && chain->clusters <= idx) {
+		if (chain->count == 0) {
+			clst = nodep->firstc;
+		} else {
+			run = &chain->runs[chain->count - 1];
+			rc = fat_get_cluster(bs, nodep->idx->service_id, FAT1,
+			    run->clst + run->count - 1, &clst);
+			if (rc != EOK)
+				return rc;
+		}
+
+		if (clst >= clst_last1) {
+			chain->complete = true;
+			break;
+		}
+
+		assert(clst >= FAT_CLST_FIRST && clst != FAT_CLST_BAD(bs));
+		if (!fat_chain_cache_append(chain, clst))
+			break;
+	}
+
+	return EOK;
+}
+
+/** Forget the clusters following a cluster in a node's run-length map.
+ *
+ * @param chain		Map of the node's cluster chain.
+ * @param lcl		Last cluster which remains in the chain or
+ *			FAT_CLST_RES0 if no cluster remains.
+ */
+static void fat_chain_cache_chop(fat_chain_cache_t *chain, fat_cluster_t lcl)
+{
+	unsigned i;
+
+	fibril_mutex_lock(&chain->lock);
+
+	if (lcl == FAT_CLST_RES0) {
+		chain->count = 0;
+		chain->clusters = 0;
+		chain->complete = false;
+	}
+
+	for (i = 0; i < chain->count; i++) {
+		fat_run_t *run = &chain->runs[i];
+
+		if (lcl >= run->clst && lcl < run->clst + run->count) {
+			run->count = lcl - run->clst + 1;
+			chain->count = i + 1;
+			chain->clusters = run->idx + run->count;
+			chain->complete = true;
+			break;
+		}
+	}
+
+	/* Otherwise the map only covers clusters preceding lcl. */
+
+	fibril_mutex_unlock(&chain->lock);
+}
 
 /** Walk the cluster chain.
  *
@@ -112,6 +394,82 @@ fat_cluster_walk(fat_bs_t *bs, service_id_t service_id, fat_cluster_t firstc,
 	return EOK;
 }
 
+/** Walk the cluster chain of a node.
+ *
+ * This works like fat_cluster_walk(), but the node's run-length map of its
+ * cluster chain is used and extended, so that FAT1 is only read for the
+ * clusters which have not been visited before.
+ *
+ * @param bs		Buffer holding the boot sector for the file.
+ * @param nodep		FAT node.
+ * @param lastc		If non-NULL, output argument hodling the last cluster
+ *			number visited.
+ * @param numc		If non-NULL, output argument holding the number of
+ *			clusters seen during the walk.
+ * @param max_clusters	Maximum number of clusters to visit.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t
+fat_node_cluster_walk(fat_bs_t *bs, fat_node_t *nodep, fat_cluster_t *lastc,
+    uint32_t *numc, uint32_t max_clusters)
+{
+	fat_chain_cache_t *chain = &nodep->chain;
+	fat_cluster_t clst;
+	uint32_t clusters, base;
+	errno_t rc;
+
+	if (nodep->firstc == FAT_CLST_RES0) {
+		/* No space allocated to the file. */
+		if (lastc)
+			*lastc = FAT_CLST_RES0;
+		if (numc)
+			*numc = 0;
+		return EOK;
+	}
+
+	fibril_mutex_lock(&chain->lock);
+
+	rc = fat_chain_cache_extend(bs, nodep, max_clusters);
+	if (rc != EOK) {
+		fibril_mutex_unlock(&chain->lock);
+		return rc;
+	}
+
+	if (max_clusters < chain->clusters || chain->complete) {
+		clusters = min(max_clusters, chain->clusters);
+		clst = fat_chain_cache_lookup(chain,
+		    min(max_clusters, chain->clusters - 1));
+		fibril_mutex_unlock(&chain->lock);
+	} else {
+		/*
+		 * The map cannot grow anymore. Walk the rest of the chain
+		 * starting with the last cluster covered by the map.
+		 */
+		if (chain->clusters > 0) {
+			base = chain->clusters - 1;
+			clst = fat_chain_cache_lookup(chain, base);
+		} else {
+			base = 0;
+			clst = nodep->firstc;
+		}
+		fibril_mutex_unlock(&chain->lock);
+
+		rc = fat_cluster_walk(bs, nodep->idx->service_id, clst, &clst,
+		    &clusters, max_clusters - base);
+		if (rc != EOK)
+			return rc;
+		clusters += base;
+	}
+
+	if (lastc)
+		*lastc = clst;
+	if (numc)
+		*numc = clusters;
+
+	return EOK;
+}
+
 /** Read block from file located on a FAT file system.
  *
  * @param block		Pointer to a block pointer for storing result.
@@ -126,50 +484,27 @@ errno_t
 fat_block_get(block_t **block, struct fat_bs *bs, fat_node_t *nodep,
     aoff64_t bn, int flags)
 {
-	fat_cluster_t firstc = nodep->firstc;
-	fat_cluster_t currc = 0;
-	aoff64_t relbn = bn;
+	fat_cluster_t c = 0;
+	uint32_t clusters;
+	uint32_t max_clusters;
 	errno_t rc;
 
-	if (!nodep->size)
+	if (!nodep->size || nodep->firstc == FAT_CLST_RES0)
 		return ELIMIT;
 
-	if (!FAT_IS_FAT32(bs) && nodep->firstc == FAT_CLST_ROOT)
-		goto fall_through;
-
-	if (((((nodep->size - 1) / BPS(bs)) / SPC(bs)) == bn / SPC(bs)) &&
-	    nodep->lastc_cached_valid) {
-		/*
-		 * This is a request to read a block within the last cluster
-		 * when fortunately we have the last cluster number cached.
-		 */
-		return block_get(block, nodep->idx->service_id,
-		    CLBN2PBN(bs, nodep->lastc_cached_value, bn), flags);
+	if (!FAT_IS_FAT32(bs) && nodep->firstc == FAT_CLST_ROOT) {
+		return _fat_block_get(block, bs, nodep->idx->service_id,
+		    nodep->firstc, NULL, bn, flags);
 	}
 
-	if (nodep->currc_cached_valid && bn >= nodep->currc_cached_bn) {
-		/*
-		 * We can start with the cluster cached by the previous call to
-		 * fat_block_get().
-		 */
-		firstc = nodep->currc_cached_value;
-		relbn -= (nodep->currc_cached_bn / SPC(bs)) * SPC(bs);
-	}
-
-fall_through:
-	rc = _fat_block_get(block, bs, nodep->idx->service_id, firstc,
-	    &currc, relbn, flags);
+	max_clusters = bn / SPC(bs);
+	rc = fat_node_cluster_walk(bs, nodep, &c, &clusters, max_clusters);
 	if (rc != EOK)
 		return rc;
+	assert(clusters == max_clusters);
 
-	/*
-	 * Update the "current" cluster cache.
-	 */
-	nodep->currc_cached_valid = true;
-	nodep->currc_cached_bn = bn;
-	nodep->currc_cached_value = currc;
-
-	return rc;
+	return block_get(block, nodep->idx->service_id,
+	    CLBN2PBN(bs, c, bn), flags);
 }
 
 /** Read block from file located on a FAT file system.
@@ -615,12 +950,15 @@ fat_set_cluster(fat_bs_t *bs, service_id_t service_id, unsigned fatno,
 
 	assert(fatno < FATCNT(bs));
 
-	if (FAT_IS_FAT12(bs))
+	if (FAT_IS_FAT12(bs)) {
+		fibril_mutex_lock(&fat12_lock);
 		rc = fat_set_cluster_fat12(bs, service_id, fatno, clst, value);
-	else if (FAT_IS_FAT16(bs))
+		fibril_mutex_unlock(&fat12_lock);
+	} else if (FAT_IS_FAT16(bs)) {
 		rc = fat_set_cluster_fat16(bs, service_id, fatno, clst, value);
-	else
+	} else {
 		rc = fat_set_cluster_fat32(bs, service_id, fatno, clst, value);
+	}
 
 	return rc;
 }
@@ -629,13 +967,13 @@ fat_set_cluster(fat_bs_t *bs, service_id_t service_id, unsigned fatno,
  *
  * @param bs		Buffer holding the boot sector of the file system.
  * @param service_id	Service ID of the file system.
- * @param lifo		Chain of allocated clusters.
- * @param nclsts	Number of clusters in the lifo chain.
+ * @param clsts		Allocated clusters in the order of the chain.
+ * @param nclsts	Number of clusters in the chain.
  *
  * @return		EOK on success or an error code.
  */
 errno_t fat_alloc_shadow_clusters(fat_bs_t *bs, service_id_t service_id,
-    fat_cluster_t *lifo, unsigned nclsts)
+    fat_cluster_t *clsts, unsigned nclsts)
 {
 	uint8_t fatno;
 	unsigned c;
@@ -644,8 +982,8 @@ errno_t fat_alloc_shadow_clusters(fat_bs_t *bs, service_id_t service_id,
 
 	for (fatno = FAT1 + 1; fatno < FATCNT(bs); fatno++) {
 		for (c = 0; c < nclsts; c++) {
-			rc = fat_set_cluster(bs, service_id, fatno, lifo[c],
-			    c == 0 ? clst_last1 : lifo[c - 1]);
+			rc = fat_set_cluster(bs, service_id, fatno, clsts[c],
+			    c + 1 == nclsts ? clst_last1 : clsts[c + 1]);
 			if (rc != EOK)
 				return rc;
 		}
@@ -661,6 +999,9 @@ errno_t fat_alloc_shadow_clusters(fat_bs_t *bs, service_id_t service_id,
  * clusters form an independent chain (i.e. a chain which does not belong to any
  * file yet).
  *
+ * The free clusters are taken from the file system's free cluster bitmap in
+ * ascending order, so the chain is contiguous whenever the free space allows.
+ *
  * @param bs		Buffer holding the boot sector of the file system.
  * @param service_id	Device service ID of the file system.
  * @param nclsts	Number of clusters to allocate.
@@ -675,63 +1016,62 @@ errno_t
 fat_alloc_clusters(fat_bs_t *bs, service_id_t service_id, unsigned nclsts,
     fat_cluster_t *mcl, fat_cluster_t *lcl)
 {
-	fat_cluster_t *lifo;    /* stack for storing free cluster numbers */
-	unsigned found = 0;     /* top of the free cluster number stack */
-	fat_cluster_t clst;
-	fat_cluster_t value = 0;
+	fat_bitmap_t *bm;
+	fat_cluster_t *clsts;	/* allocated clusters in the chain order */
 	fat_cluster_t clst_last1 = FAT_CLST_LAST1(bs);
+	unsigned c;
 	errno_t rc = EOK;
 
-	lifo = (fat_cluster_t *) malloc(nclsts * sizeof(fat_cluster_t));
-	if (!lifo)
+	bm = fat_bitmap_find(service_id, true);
+	if (!bm)
+		return ENOENT;
+
+	clsts = (fat_cluster_t *) malloc(nclsts * sizeof(fat_cluster_t));
+	if (!clsts)
 		return ENOMEM;
 
+	fibril_mutex_lock(&bm->lock);
+	if (bm->free < nclsts) {
+		fibril_mutex_unlock(&bm->lock);
+		free(clsts);
+		return ENOSPC;
+	}
+
+	for (c = 0; c < nclsts; c++)
+		clsts[c] = fat_bitmap_take(bm);
+
 	/*
-	 * Search FAT1 for unused clusters.
+	 * Link the clusters in FAT1 and then in the shadow copies.
 	 */
-	fibril_mutex_lock(&fat_alloc_lock);
-	for (clst = FAT_CLST_FIRST; clst < CC(bs) + 2 && found < nclsts;
-	    clst++) {
-		rc = fat_get_cluster(bs, service_id, FAT1, clst, &value);
+	for (c = 0; c < nclsts; c++) {
+		rc = fat_set_cluster(bs, service_id, FAT1, clsts[c],
+		    c + 1 == nclsts ? clst_last1 : clsts[c + 1]);
 		if (rc != EOK)
 			break;
-
-		if (value == FAT_CLST_RES0) {
-			/*
-			 * The cluster is free. Put it into our stack
-			 * of found clusters and mark it as non-free.
-			 */
-			lifo[found] = clst;
-			rc = fat_set_cluster(bs, service_id, FAT1, clst,
-			    (found == 0) ?  clst_last1 : lifo[found - 1]);
-			if (rc != EOK)
-				break;
-
-			found++;
-		}
 	}
 
-	if (rc == EOK && found == nclsts) {
-		rc = fat_alloc_shadow_clusters(bs, service_id, lifo, nclsts);
-		if (rc == EOK) {
-			*mcl = lifo[found - 1];
-			*lcl = lifo[0];
-			free(lifo);
-			fibril_mutex_unlock(&fat_alloc_lock);
-			return EOK;
-		}
+	if (rc == EOK)
+		rc = fat_alloc_shadow_clusters(bs, service_id, clsts, nclsts);
+
+	if (rc == EOK) {
+		*mcl = clsts[0];
+		*lcl = clsts[nclsts - 1];
+		fibril_mutex_unlock(&bm->lock);
+		free(clsts);
+		return EOK;
 	}
 
 	/* If something wrong - free the clusters */
-	while (found--) {
-		(void) fat_set_cluster(bs, service_id, FAT1, lifo[found],
+	for (c = 0; c < nclsts; c++) {
+		(void) fat_set_cluster(bs, service_id, FAT1, clsts[c],
 		    FAT_CLST_RES0);
+		fat_bitmap_put(bm, clsts[c]);
 	}
 
-	free(lifo);
-	fibril_mutex_unlock(&fat_alloc_lock);
+	fibril_mutex_unlock(&bm->lock);
+	free(clsts);
 
-	return ENOSPC;
+	return rc;
 }
 
 /** Free clusters forming a cluster chain in all copies of FAT.
@@ -745,11 +1085,14 @@ fat_alloc_clusters(fat_bs_t *bs, service_id_t service_id, unsigned nclsts,
 errno_t
 fat_free_clusters(fat_bs_t *bs, service_id_t service_id, fat_cluster_t firstc)
 {
+	fat_bitmap_t *bm;
 	unsigned fatno;
 	fat_cluster_t nextc = 0;
 	fat_cluster_t clst_bad = FAT_CLST_BAD(bs);
 	errno_t rc;
 
+	bm = fat_bitmap_find(service_id, true);
+
 	/* Mark all clusters in the chain as free in all copies of FAT. */
 	while (firstc < FAT_CLST_LAST1(bs)) {
 		assert(firstc >= FAT_CLST_FIRST && firstc < clst_bad);
@@ -765,6 +1108,16 @@ fat_free_clusters(fat_bs_t *bs, service_id_t service_id, fat_cluster_t firstc)
 				return rc;
 		}
 
+		/*
+		 * Only make the cluster available for allocation once it is
+		 * free in all copies of FAT.
+		 */
+		if (bm) {
+			fibril_mutex_lock(&bm->lock);
+			fat_bitmap_put(bm, firstc);
+			fibril_mutex_unlock(&bm->lock);
+		}
+
 		firstc = nextc;
 	}
 
@@ -793,26 +1146,26 @@ errno_t fat_append_clusters(fat_bs_t *bs, fat_node_t *nodep, fat_cluster_t mcl,
 		nodep->firstc = mcl;
 		nodep->dirty = true;	/* need to sync node */
 	} else {
-		if (nodep->lastc_cached_valid) {
-			lastc = nodep->lastc_cached_value;
-			nodep->lastc_cached_valid = false;
-		} else {
-			rc = fat_cluster_walk(bs, service_id, nodep->firstc,
-			    &lastc, NULL, (uint32_t) -1);
-			if (rc != EOK)
-				return rc;
-		}
+		rc = fat_node_cluster_walk(bs, nodep, &lastc, NULL,
+		    (uint32_t) -1);
+		if (rc != EOK)
+			return rc;
 
 		for (fatno = FAT1; fatno < FATCNT(bs); fatno++) {
-			rc = fat_set_cluster(bs, nodep->idx->service_id,
-			    fatno, lastc, mcl);
+			rc = fat_set_cluster(bs, service_id, fatno, lastc,
+			    mcl);
 			if (rc != EOK)
 				return rc;
 		}
 	}
 
-	nodep->lastc_cached_valid = true;
-	nodep->lastc_cached_value = lcl;
+	/*
+	 * The cached runs are still valid, but no longer cover the whole
+	 * chain.
+	 */
+	fibril_mutex_lock(&nodep->chain.lock);
+	nodep->chain.complete = false;
+	fibril_mutex_unlock(&nodep->chain.lock);
 
 	return EOK;
 }
@@ -834,11 +1187,9 @@ errno_t fat_chop_clusters(fat_bs_t *bs, fat_node_t *nodep, fat_cluster_t lcl)
 	service_id_t service_id = nodep->idx->service_id;
 
 	/*
-	 * Invalidate cached cluster numbers.
+	 * Forget the cached runs of the clusters which are going away.
 	 */
-	nodep->lastc_cached_valid = false;
-	if (nodep->currc_cached_value != lcl)
-		nodep->currc_cached_valid = false;
+	fat_chain_cache_chop(&nodep->chain, lcl);
 
 	if (lcl == FAT_CLST_RES0) {
 		/* The node will have zero size and no clusters allocated. */
@@ -869,12 +1220,6 @@ errno_t fat_chop_clusters(fat_bs_t *bs, fat_node_t *nodep, fat_cluster_t lcl)
 			return rc;
 	}
 
-	/*
-	 * Update and re-enable the last cluster cache.
-	 */
-	nodep->lastc_cached_valid = true;
-	nodep->lastc_cached_value = lcl;
-
 	return EOK;
 }
 
@@ -972,6 +1317,175 @@ errno_t fat_sanity_check(fat_bs_t *bs, service_id_t service_id)
 	return EOK;
 }
 
+/** Build the free cluster bitmap from FAT1.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param service_id	Device service ID of the file system.
+ * @param bm		Bitmap with all clusters marked as used.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t fat_bitmap_scan(fat_bs_t *bs, service_id_t service_id,
+    fat_bitmap_t *bm)
+{
+	fat_cluster_t clst, value;
+	bool fat32 = FAT_IS_FAT32(bs);
+	unsigned per_sector;
+	size_t sectors;
+	size_t s, i;
+	uint8_t *buf;
+	errno_t rc;
+
+	if (FAT_IS_FAT12(bs)) {
+		/*
+		 * FAT12 entries may span sector boundaries, but there are only
+		 * a few of them. Read them one by one.
+		 */
+		for (clst = FAT_CLST_FIRST; clst < bm->clusters; clst++) {
+			rc = fat_get_cluster(bs, service_id, FAT1, clst,
+			    &value);
+			if (rc != EOK)
+				return rc;
+			if (value == FAT_CLST_RES0)
+				fat_bitmap_put(bm, clst);
+		}
+		return EOK;
+	}
+
+	/*
+	 * Read FAT1 directly, bypassing the block cache, in large chunks.
+	 */
+	buf = malloc(FAT_BITMAP_SCAN_SECTORS * BPS(bs));
+	if (!buf)
+		return ENOMEM;
+
+	per_sector = BPS(bs) / FAT_CLST_SIZE(bs);
+	sectors = (bm->clusters + per_sector - 1) / per_sector;
+
+	for (s = 0; s < sectors; s += FAT_BITMAP_SCAN_SECTORS) {
+		size_t cnt = min(sectors - s, FAT_BITMAP_SCAN_SECTORS);
+
+		rc = block_read_direct(service_id, RSCNT(bs) + s, cnt, buf);
+		if (rc != EOK) {
+			free(buf);
+			return rc;
+		}
+
+		clst = s * per_sector;
+		for (i = 0; i < cnt * per_sector && clst < bm->clusters;
+		    i++, clst++) {
+			if (fat32) {
+				value = uint32_t_le2host(
+				    ((uint32_t *) buf)[i]) & FAT32_MASK;
+			} else {
+				value = uint16_t_le2host(((uint16_t *) buf)[i]);
+			}
+
+			if (clst >= FAT_CLST_FIRST && value == FAT_CLST_RES0)
+				fat_bitmap_put(bm, clst);
+		}
+	}
+
+	free(buf);
+	return EOK;
+}
+
+/** Build the free cluster bitmap of a file system.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param service_id	Device service ID of the file system.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t fat_bitmap_init_by_service_id(fat_bs_t *bs, service_id_t service_id)
+{
+	fat_bitmap_t *bm;
+	errno_t rc;
+
+	bm = (fat_bitmap_t *) malloc(sizeof(fat_bitmap_t));
+	if (!bm)
+		return ENOMEM;
+
+	link_initialize(&bm->link);
+	bm->service_id = service_id;
+	fibril_mutex_initialize(&bm->lock);
+	bm->free = 0;
+	bm->next = FAT_CLST_FIRST;
+
+	/* Do not trust a cluster count which does not fit into the FAT. */
+	bm->clusters = CC(bs) + 2;
+	if (!FAT_IS_FAT12(bs)) {
+		bm->clusters = min(bm->clusters,
+		    (uint64_t) SF(bs) * (BPS(bs) / FAT_CLST_SIZE(bs)));
+	}
+
+	bm->bitmap = calloc((bm->clusters + 31) / 32, sizeof(uint32_t));
+	if (!bm->bitmap) {
+		free(bm);
+		return ENOMEM;
+	}
+
+	rc = fat_bitmap_scan(bs, service_id, bm);
+	if (rc != EOK) {
+		free(bm->bitmap);
+		free(bm);
+		return rc;
+	}
+
+	fibril_mutex_lock(&bitmap_lock);
+	if (!fat_bitmap_find(service_id, false)) {
+		list_append(&bm->link, &bitmap_list);
+	} else {
+		free(bm->bitmap);
+		free(bm);
+		rc = EEXIST;
+	}
+	fibril_mutex_unlock(&bitmap_lock);
+
+	return rc;
+}
+
+/** Destroy the free cluster bitmap of a file system.
+ *
+ * @param service_id	Device service ID of the file system.
+ */
+void fat_bitmap_fini_by_service_id(service_id_t service_id)
+{
+	fat_bitmap_t *bm;
+
+	fibril_mutex_lock(&bitmap_lock);
+	bm = fat_bitmap_find(service_id, false);
+	assert(bm);
+	list_remove(&bm->link);
+	fibril_mutex_unlock(&bitmap_lock);
+
+	free(bm->bitmap);
+	free(bm);
+}
+
+/** Get the number of free clusters of a file system.
+ *
+ * @param service_id	Device service ID of the file system.
+ * @param count		Place to store the number of free clusters.
+ *
+ * @return		EOK on success or ENOENT if the file system does not
+ *			have a bitmap.
+ */
+errno_t fat_bitmap_free_count(service_id_t service_id, uint32_t *count)
+{
+	fat_bitmap_t *bm;
+
+	bm = fat_bitmap_find(service_id, true);
+	if (!bm)
+		return ENOENT;
+
+	fibril_mutex_lock(&bm->lock);
+	*count = bm->free;
+	fibril_mutex_unlock(&bm->lock);
+
+	return EOK;
+}
+
 /**
  * @}
  */
@@ -36,7 +36,9 @@
 
 #include "../../vfs/vfs.h"
 #include <stdint.h>
+#include <stdbool.h>
 #include <block.h>
+#include <fibril_synch.h>
 
 #define FAT1		0
 
@@ -105,10 +107,41 @@ struct fat_bs;
 
 typedef uint32_t fat_cluster_t;
 
+/** Run of consecutive clusters in a cluster chain. */
+typedef struct {
+	/** Index of the first cluster of the run within the chain. */
+	uint32_t	idx;
+	/** Number of the first cluster of the run. */
+	fat_cluster_t	clst;
+	/** Number of clusters in the run. */
+	uint32_t	count;
+} fat_run_t;
+
+/** Run-length map of the leading part of a node's cluster chain. */
+typedef struct {
+	/** Protects the map while it is extended from the FAT. */
+	fibril_mutex_t	lock;
+	/** Runs sorted by their index within the chain. */
+	fat_run_t	*runs;
+	/** Number of valid runs. */
+	unsigned	count;
+	/** Number of runs the array has room for. */
+	unsigned	size;
+	/** Number of clusters of the chain covered by the runs. */
+	uint32_t	clusters;
+	/** The runs cover the whole chain. */
+	bool		complete;
+} fat_chain_cache_t;
+
 #define fat_clusters_get(numc, bs, sid, fc) \
     fat_cluster_walk((bs), (sid), (fc), NULL, (numc), (uint32_t) -1)
 extern errno_t fat_cluster_walk(struct fat_bs *, service_id_t, fat_cluster_t,
     fat_cluster_t *, uint32_t *, uint32_t);
+extern errno_t fat_node_cluster_walk(struct fat_bs *, struct fat_node *,
+    fat_cluster_t *, uint32_t *, uint32_t);
+
+extern void fat_chain_cache_init(fat_chain_cache_t *);
+extern void fat_chain_cache_fini(fat_chain_cache_t *);
 
 extern errno_t fat_block_get(block_t **, struct fat_bs *, struct fat_node *,
     aoff64_t, int);
@@ -133,6 +166,10 @@ extern errno_t fat_fill_gap(struct fat_bs *, struct fat_node *, fat_cluster_t,
 extern errno_t fat_zero_cluster(struct fat_bs *, service_id_t, fat_cluster_t);
 extern errno_t fat_sanity_check(struct fat_bs *, service_id_t);
 
+extern errno_t fat_bitmap_init_by_service_id(struct fat_bs *, service_id_t);
+extern void fat_bitmap_fini_by_service_id(service_id_t);
+extern errno_t fat_bitmap_free_count(service_id_t, uint32_t *);
+
 #endif
 
 /**
@@ -106,11 +106,7 @@ static void fat_node_initialize(fat_node_t *node)
 	node->lnkcnt = 0;
 	node->refcnt = 0;
 	node->dirty = false;
-	node->lastc_cached_valid = false;
-	node->lastc_cached_value = 0;
-	node->currc_cached_valid = false;
-	node->currc_cached_bn = 0;
-	node->currc_cached_value = 0;
+	fat_chain_cache_init(&node->chain);
 }
 
 static errno_t fat_node_sync(fat_node_t *node)
@@ -192,6 +188,7 @@ restart:
 				return rc;
 		}
 		nodep->idx->nodep = NULL;
+		fat_chain_cache_fini(&nodep->chain);
 		free(nodep->bp);
 		free(nodep);
 
@@ -230,6 +227,7 @@ static errno_t fat_node_get_new(fat_node_t **nodepp)
 				idxp_tmp->nodep = NULL;
 				fibril_mutex_unlock(&nodep->lock);
 				fibril_mutex_unlock(&idxp_tmp->lock);
+				fat_chain_cache_fini(&nodep->chain);
 				free(nodep->bp);
 				free(nodep);
 				return rc;
@@ -238,6 +236,7 @@ static errno_t fat_node_get_new(fat_node_t **nodepp)
 		idxp_tmp->nodep = NULL;
 		fibril_mutex_unlock(&nodep->lock);
 		fibril_mutex_unlock(&idxp_tmp->lock);
+		fat_chain_cache_fini(&nodep->chain);
 		fn = FS_NODE(nodep);
 	} else {
 	skip_cache:
@@ -476,6 +475,7 @@ errno_t fat_node_put(fs_node_t *fn)
 	}
 	fibril_mutex_unlock(&nodep->lock);
 	if (destroy) {
+		fat_chain_cache_fini(&nodep->chain);
 		free(nodep->bp);
 		free(nodep);
 	}
@@ -569,6 +569,7 @@ errno_t fat_destroy_node(fs_node_t *fn)
 	}
 
 	fat_idx_destroy(nodep->idx);
+	fat_chain_cache_fini(&nodep->chain);
 	free(nodep->bp);
 	free(nodep);
 	return rc;
@@ -863,24 +864,13 @@ errno_t fat_total_block_count(service_id_t service_id, uint64_t *count)
 
 errno_t fat_free_block_count(service_id_t service_id, uint64_t *count)
 {
-	fat_bs_t *bs;
-	fat_cluster_t e0;
-	uint64_t block_count;
+	uint32_t clusters;
 	errno_t rc;
-	uint32_t cluster_no, clusters;
-
-	block_count = 0;
-	bs = block_bb_get(service_id);
-	clusters = (SPC(bs)) ? TS(bs) / SPC(bs) : 0;
-	for (cluster_no = 0; cluster_no < clusters; cluster_no++) {
-		rc = fat_get_cluster(bs, service_id, FAT1, cluster_no, &e0);
-		if (rc != EOK)
-			return EIO;
 
-		if (e0 == FAT_CLST_RES0)
-			block_count++;
-	}
-	*count = block_count;
+	rc = fat_bitmap_free_count(service_id, &clusters);
+	if (rc != EOK)
+		return rc;
+	*count = clusters;
 
 	return EOK;
 }
@@ -1024,6 +1014,7 @@ static errno_t fat_fs_open(service_id_t service_id, enum cache_mode cmode,
 
 static void fat_fs_close(service_id_t service_id, fs_node_t *rfn)
 {
+	fat_chain_cache_fini(&FAT_NODE(rfn)->chain);
 	free(rfn->data);
 	free(rfn);
 	(void) block_cache_fini(service_id);
@@ -1079,6 +1070,7 @@ fat_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
     aoff64_t *size)
 {
 	enum cache_mode cmode = CACHE_MODE_WB;
+	size_t cache_size = 0;
 	fat_instance_t *instance;
 	fat_idx_t *ridxp;
 	fs_node_t *rfn;
@@ -1097,6 +1089,8 @@ fat_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
 			cmode = CACHE_MODE_WT;
 		else if (str_cmp(opt, "nolfn") == 0)
 			instance->lfn_enabled = false;
+		else if (str_lcmp(opt, "cache=", 6) == 0)
+			(void) block_cache_size_parse(opt + 6, &cache_size);
 	}
 
 	rc = fat_fs_open(service_id, cmode, &rfn, &ridxp);
@@ -1105,11 +1099,24 @@ fat_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
 		return rc;
 	}
 
+	if (cache_size != 0)
+		(void) block_cache_resize(service_id, cache_size);
+
+	/* Find the free clusters. */
+	rc = fat_bitmap_init_by_service_id(block_bb_get(service_id),
+	    service_id);
+	if (rc != EOK) {
+		fat_fs_close(service_id, rfn);
+		free(instance);
+		return rc;
+	}
+
 	fibril_mutex_lock(&ridxp->lock);
 
 	rc = fs_instance_create(service_id, instance);
 	if (rc != EOK) {
 		fibril_mutex_unlock(&ridxp->lock);
+		fat_bitmap_fini_by_service_id(service_id);
 		fat_fs_close(service_id, rfn);
 		free(instance);
 		return rc;
@@ -1195,6 +1202,7 @@ static errno_t fat_unmounted(service_id_t service_id)
 	 * stop using libblock for this instance.
 	 */
 	(void) fat_node_fini_by_service_id(service_id);
+	fat_bitmap_fini_by_service_id(service_id);
 	fat_fs_close(service_id, fn);
 
 	void *data;
@@ -1495,8 +1503,8 @@ fat_truncate(service_id_t service_id, fs_index_t index, aoff64_t size)
 				goto out;
 		} else {
 			fat_cluster_t lastc;
-			rc = fat_cluster_walk(bs, service_id, nodep->firstc,
-			    &lastc, NULL, (size - 1) / BPC(bs));
+			rc = fat_node_cluster_walk(bs, nodep, &lastc, NULL,
+			    (size - 1) / BPC(bs));
 			if (rc != EOK)
 				goto out;
 			rc = fat_chop_clusters(bs, nodep, lastc);
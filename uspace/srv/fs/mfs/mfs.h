@@ -67,6 +67,17 @@
 #define MFS_BMAP_SIZE_BLOCKS(sbi, bid) \
     ((bid) == BMAP_ZONE ? (sbi)->zbmap_blocks : (sbi)->ibmap_blocks)
 
+/* Maximum number of unused nodes kept in memory */
+#define MFS_UNUSED_NODES_MAX	64
+
+/* Indirect zones cached by each in-core node */
+typedef enum {
+	MFS_IND_SINGLE,		/* The single indirect zone */
+	MFS_IND_DOUBLE,		/* The first zone of the double indirect chain */
+	MFS_IND_DOUBLE2,	/* The last used second zone of the chain */
+	MFS_IND_CACHE_SIZE
+} mfs_ind_slot_t;
+
 typedef uint32_t bitchunk_t;
 
 typedef enum {
@@ -116,6 +127,13 @@ struct mfs_sb_info {
 	 * is invoked.
 	 */
 	unsigned nfree_zones;
+	/*
+	 * Number of free bits in each block of the zone and inode bitmaps,
+	 * used to skip full bitmap blocks when allocating. NULL until the
+	 * bitmap is first scanned.
+	 */
+	uint16_t *zbmap_free;
+	uint16_t *ibmap_free;
 };
 
 /* Generic MinixFS inode */
@@ -151,6 +169,14 @@ struct mfs_dentry_info {
 	struct mfs_node *node;
 };
 
+/* In memory copy of an indirect zone */
+struct mfs_ind_zone {
+	/* Number of the cached zone, 0 if the entry is empty */
+	uint32_t zone;
+	/* Zone pointers stored in the zone */
+	uint32_t *ptrs;
+};
+
 struct mfs_instance {
 	service_id_t service_id;
 	struct mfs_sb_info *sbi;
@@ -164,6 +190,12 @@ struct mfs_node {
 	unsigned refcnt;
 	fs_node_t *fsnode;
 	ht_link_t link;
+	/* Link to the list of unused nodes, valid if refcnt is 0 */
+	link_t unused_link;
+	/* The inode has been freed, do not keep the node in memory */
+	bool destroyed;
+	/* Indirect zones of the inode resolved so far */
+	struct mfs_ind_zone ind_cache[MFS_IND_CACHE_SIZE];
 };
 
 /* mfs_ops.c */
@@ -186,7 +218,7 @@ mfs_inode_shrink(struct mfs_node *mnode, size_t size_shrink);
 
 /* mfs_rw.c */
 extern errno_t
-mfs_read_map(uint32_t *b, const struct mfs_node *mnode, const uint32_t pos);
+mfs_read_map(uint32_t *b, struct mfs_node *mnode, const uint32_t pos);
 
 extern errno_t
 mfs_write_map(struct mfs_node *mnode, uint32_t pos, uint32_t new_zone,
@@ -195,6 +227,12 @@ mfs_write_map(struct mfs_node *mnode, uint32_t pos, uint32_t new_zone,
 extern errno_t
 mfs_prune_ind_zones(struct mfs_node *mnode, size_t new_size);
 
+extern void
+mfs_ind_cache_init(struct mfs_node *mnode);
+
+extern void
+mfs_ind_cache_fini(struct mfs_node *mnode);
+
 /* mfs_dentry.c */
 extern errno_t
 mfs_read_dentry(struct mfs_node *mnode,
@@ -228,6 +266,9 @@ mfs_count_free_zones(struct mfs_instance *inst, uint32_t *zones);
 extern errno_t
 mfs_count_free_inodes(struct mfs_instance *inst, uint32_t *inodes);
 
+extern void
+mfs_bmap_fini(struct mfs_sb_info *sbi);
+
 /* mfs_utils.c */
 extern uint16_t
 conv16(bool native, uint16_t n);
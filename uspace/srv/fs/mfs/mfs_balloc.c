@@ -46,6 +46,10 @@ mfs_alloc_bit(struct mfs_instance *inst, uint32_t *idx, bmap_id_t bid);
 static errno_t
 mfs_count_free_bits(struct mfs_instance *inst, bmap_id_t bid, uint32_t *free);
 
+static errno_t
+mfs_bmap_summary_get(struct mfs_instance *inst, bmap_id_t bid,
+    uint16_t **summary);
+
 /**Allocate a new inode.
  *
  * @param inst		Pointer to the filesystem instance.
@@ -153,38 +157,67 @@ mfs_count_free_inodes(struct mfs_instance *inst, uint32_t *inodes)
 	return mfs_count_free_bits(inst, BMAP_INODE, inodes);
 }
 
-/** Count the number of free bits in a bitmap
+/** Release the free bit summaries of the bitmaps
+ *
+ * @param sbi           Pointer to the superblock info structure.
+ */
+void
+mfs_bmap_fini(struct mfs_sb_info *sbi)
+{
+	free(sbi->zbmap_free);
+	free(sbi->ibmap_free);
+	sbi->zbmap_free = NULL;
+	sbi->ibmap_free = NULL;
+}
+
+/** Get the number of free bits in each block of a bitmap
+ *
+ * The first call scans the whole bitmap, the summary is then kept up to
+ * date by mfs_alloc_bit() and mfs_free_bit(). Only the bits which can be
+ * allocated are accounted for.
  *
  * @param inst          Pointer to the instance structure.
  * @param bid           Type of the bitmap (inode or zone).
- * @param free          Pointer to the memory location where the result
- *                      will be stores.
+ * @param summary       Pointer to the memory location where the address of
+ *                      the summary will be stored.
  *
  * @return              EOK on success or an error code.
  */
 static errno_t
-mfs_count_free_bits(struct mfs_instance *inst, bmap_id_t bid, uint32_t *free)
+mfs_bmap_summary_get(struct mfs_instance *inst, bmap_id_t bid,
+    uint16_t **summary)
 {
 	errno_t r;
 	unsigned start_block;
 	unsigned long nblocks;
 	unsigned long nbits;
 	unsigned long block;
-	unsigned long free_bits = 0;
 	bitchunk_t chunk;
 	size_t const bitchunk_bits = sizeof(bitchunk_t) * 8;
 	block_t *b;
 	struct mfs_sb_info *sbi = inst->sbi;
+	uint16_t **sump = bid == BMAP_ZONE ? &sbi->zbmap_free :
+	    &sbi->ibmap_free;
+
+	if (*sump != NULL) {
+		*summary = *sump;
+		return EOK;
+	}
 
 	start_block = MFS_BMAP_START_BLOCK(sbi, bid);
 	nblocks = MFS_BMAP_SIZE_BLOCKS(sbi, bid);
-	nbits = MFS_BMAP_SIZE_BITS(sbi, bid);
+	/* Bits up to the limit can be allocated */
+	nbits = MFS_BMAP_SIZE_BITS(sbi, bid) + 1;
+
+	uint16_t *sum = calloc(nblocks, sizeof(uint16_t));
+	if (sum == NULL)
+		return ENOMEM;
 
-	for (block = 0; block < nblocks; ++block) {
+	for (block = 0; block < nblocks && nbits > 0; ++block) {
 		r = block_get(&b, inst->service_id, block + start_block,
 		    BLOCK_FLAGS_NONE);
 		if (r != EOK)
-			return r;
+			goto out_err;
 
 		size_t i;
 		bitchunk_t *data = (bitchunk_t *) b->data;
@@ -200,7 +233,7 @@ mfs_count_free_bits(struct mfs_instance *inst, bmap_id_t bid, uint32_t *free)
 			for (bit = 0; bit < bitchunk_bits && nbits > 0;
 			    ++bit, --nbits) {
 				if (!(chunk & (1 << bit)))
-					free_bits++;
+					sum[block]++;
 			}
 
 			if (nbits == 0)
@@ -209,12 +242,45 @@ mfs_count_free_bits(struct mfs_instance *inst, bmap_id_t bid, uint32_t *free)
 
 		r = block_put(b);
 		if (r != EOK)
-			return r;
+			goto out_err;
 	}
 
-	*free = free_bits;
-	assert(nbits == 0);
+	*sump = sum;
+	*summary = sum;
+	return EOK;
+
+out_err:
+	free(sum);
+	return r;
+}
 
+/** Count the number of free bits in a bitmap
+ *
+ * @param inst          Pointer to the instance structure.
+ * @param bid           Type of the bitmap (inode or zone).
+ * @param free          Pointer to the memory location where the result
+ *                      will be stores.
+ *
+ * @return              EOK on success or an error code.
+ */
+static errno_t
+mfs_count_free_bits(struct mfs_instance *inst, bmap_id_t bid, uint32_t *free)
+{
+	errno_t r;
+	unsigned long nblocks;
+	unsigned long block;
+	unsigned long free_bits = 0;
+	uint16_t *summary;
+
+	r = mfs_bmap_summary_get(inst, bid, &summary);
+	if (r != EOK)
+		return r;
+
+	nblocks = MFS_BMAP_SIZE_BLOCKS(inst->sbi, bid);
+	for (block = 0; block < nblocks; ++block)
+		free_bits += summary[block];
+
+	*free = free_bits;
 	return EOK;
 }
 
@@ -234,6 +300,7 @@ mfs_free_bit(struct mfs_instance *inst, uint32_t idx, bmap_id_t bid)
 	errno_t r;
 	unsigned start_block;
 	unsigned *search;
+	uint16_t *summary;
 	block_t *b;
 
 	sbi = inst->sbi;
@@ -257,24 +324,32 @@ mfs_free_bit(struct mfs_instance *inst, uint32_t idx, bmap_id_t bid)
 		}
 	}
 
+	r = mfs_bmap_summary_get(inst, bid, &summary);
+	if (r != EOK)
+		goto out_err;
+
 	/* Compute the bitmap block */
-	uint32_t block = idx / (sbi->block_size * 8) + start_block;
+	uint32_t bmap_block = idx / (sbi->block_size * 8);
+	uint32_t block = bmap_block + start_block;
 
 	r = block_get(&b, inst->service_id, block, BLOCK_FLAGS_NONE);
 	if (r != EOK)
 		goto out_err;
 
 	/* Compute the bit index in the block */
-	idx %= (sbi->block_size * 8);
+	uint32_t bit_idx = idx % (sbi->block_size * 8);
 	bitchunk_t *ptr = b->data;
 	bitchunk_t chunk;
 	const size_t chunk_bits = sizeof(bitchunk_t) * 8;
 
-	chunk = conv32(sbi->native, ptr[idx / chunk_bits]);
-	chunk &= ~(1 << (idx % chunk_bits));
-	ptr[idx / chunk_bits] = conv32(sbi->native, chunk);
+	chunk = conv32(sbi->native, ptr[bit_idx / chunk_bits]);
+	if (chunk & (1 << (bit_idx % chunk_bits))) {
+		chunk &= ~(1 << (bit_idx % chunk_bits));
+		ptr[bit_idx / chunk_bits] = conv32(sbi->native, chunk);
+		summary[bmap_block]++;
+		b->dirty = true;
+	}
 
-	b->dirty = true;
 	r = block_put(b);
 
 	if (*search > idx)
@@ -302,11 +377,16 @@ mfs_alloc_bit(struct mfs_instance *inst, uint32_t *idx, bmap_id_t bid)
 	unsigned long nblocks;
 	unsigned *search, i, start_block;
 	unsigned bits_per_block;
+	uint16_t *summary;
 	errno_t r;
 	int freebit;
 
 	sbi = inst->sbi;
 
+	r = mfs_bmap_summary_get(inst, bid, &summary);
+	if (r != EOK)
+		return r;
+
 	start_block = MFS_BMAP_START_BLOCK(sbi, bid);
 	limit = MFS_BMAP_SIZE_BITS(sbi, bid);
 	nblocks = MFS_BMAP_SIZE_BLOCKS(sbi, bid);
@@ -324,13 +404,21 @@ mfs_alloc_bit(struct mfs_instance *inst, uint32_t *idx, bmap_id_t bid)
 retry:
 
 	for (i = *search / bits_per_block; i < nblocks; ++i) {
+		if (summary[i] == 0) {
+			/* No free bit in this block, skip it without reading */
+			continue;
+		}
+
 		r = block_get(&b, inst->service_id, i + start_block,
 		    BLOCK_FLAGS_NONE);
 
 		if (r != EOK)
 			goto out;
 
-		unsigned tmp = *search % bits_per_block;
+		/* The search hint applies only to its own block */
+		unsigned tmp = 0;
+		if (i == *search / bits_per_block)
+			tmp = *search % bits_per_block;
 
 		freebit = find_free_bit_and_set(b->data, sbi->block_size,
 		    sbi->native, tmp);
@@ -353,6 +441,7 @@ retry:
 		}
 
 		*search = *idx;
+		summary[i]--;
 		b->dirty = true;
 		r = block_put(b);
 		goto out;
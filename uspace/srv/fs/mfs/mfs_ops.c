@@ -66,10 +66,20 @@ static bool is_power_of_two(uint32_t n);
 static errno_t mfs_size_block(service_id_t service_id, uint32_t *size);
 static errno_t mfs_total_block_count(service_id_t service_id, uint64_t *count);
 static errno_t mfs_free_block_count(service_id_t service_id, uint64_t *count);
+static void mfs_unused_nodes_flush(struct mfs_instance *inst);
 
+/*
+ * In-core nodes, including the unused ones which are kept in memory so that
+ * their inodes are written back in batches and their resolved indirect
+ * zones survive between requests.
+ */
 static hash_table_t open_nodes;
 static FIBRIL_MUTEX_INITIALIZE(open_nodes_lock);
 
+/* List of unused in-core nodes in the order they were last used */
+static LIST_INITIALIZE(unused_nodes);
+static unsigned unused_nodes_cnt = 0;
+
 libfs_ops_t mfs_libfs_ops = {
 	.size_get = mfs_size_get,
 	.root_get = mfs_root_get,
@@ -210,6 +220,8 @@ static errno_t mfs_read_sb(service_id_t service_id, struct mfs_sb_info **rsbi)
 	sbi->zsearch = 0;
 	sbi->nfree_zones_valid = false;
 	sbi->nfree_zones = 0;
+	sbi->zbmap_free = NULL;
+	sbi->ibmap_free = NULL;
 
 	if (version == MFS_VERSION_V3) {
 		sbi->ninodes = conv32(native, sb3->s_ninodes);
@@ -378,11 +390,14 @@ mfs_unmounted(service_id_t service_id)
 	if (inst->open_nodes_cnt != 0)
 		return EBUSY;
 
+	mfs_unused_nodes_flush(inst);
+
 	(void) block_cache_fini(service_id);
 	block_fini(service_id);
 
 	/* Remove and destroy the instance */
 	(void) fs_instance_destroy(service_id);
+	mfs_bmap_fini(inst->sbi);
 	free(inst->sbi);
 	free(inst);
 	return EOK;
@@ -457,6 +472,9 @@ mfs_create_node(fs_node_t **rfn, service_id_t service_id, int flags)
 	mnode->ino_i = ino_i;
 	mnode->instance = inst;
 	mnode->refcnt = 1;
+	link_initialize(&mnode->unused_link);
+	mnode->destroyed = false;
+	mfs_ind_cache_init(mnode);
 
 	fibril_mutex_lock(&open_nodes_lock);
 	hash_table_insert(&open_nodes, &mnode->link);
@@ -542,6 +560,55 @@ mfs_node_get(fs_node_t **rfn, service_id_t service_id,
 	return mfs_node_core_get(rfn, instance, index);
 }
 
+/** Write back and free an unused in-core node.
+ *
+ * The caller must hold open_nodes_lock and the node must not be on the list
+ * of unused nodes.
+ *
+ * @param mnode		Pointer to the in-core node.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t
+mfs_node_free(struct mfs_node *mnode)
+{
+	errno_t rc;
+
+	assert(mnode->refcnt == 0);
+
+	hash_table_remove_item(&open_nodes, &mnode->link);
+	rc = mfs_put_inode(mnode);
+	mfs_ind_cache_fini(mnode);
+	free(mnode->ino_i);
+	free(mnode->fsnode);
+	free(mnode);
+	return rc;
+}
+
+/** Write back and free all unused in-core nodes of an instance.
+ *
+ * @param inst		Pointer to the filesystem instance.
+ */
+static void
+mfs_unused_nodes_flush(struct mfs_instance *inst)
+{
+	fibril_mutex_lock(&open_nodes_lock);
+
+	list_foreach_safe(unused_nodes, cur, next) {
+		struct mfs_node *mnode = list_get_instance(cur,
+		    struct mfs_node, unused_link);
+
+		if (mnode->instance != inst)
+			continue;
+
+		list_remove(&mnode->unused_link);
+		unused_nodes_cnt--;
+		(void) mfs_node_free(mnode);
+	}
+
+	fibril_mutex_unlock(&open_nodes_lock);
+}
+
 static errno_t
 mfs_node_put(fs_node_t *fsnode)
 {
@@ -553,13 +620,27 @@ mfs_node_put(fs_node_t *fsnode)
 	assert(mnode->refcnt > 0);
 	mnode->refcnt--;
 	if (mnode->refcnt == 0) {
-		hash_table_remove_item(&open_nodes, &mnode->link);
 		assert(mnode->instance->open_nodes_cnt > 0);
 		mnode->instance->open_nodes_cnt--;
-		rc = mfs_put_inode(mnode);
-		free(mnode->ino_i);
-		free(mnode);
-		free(fsnode);
+
+		if (mnode->destroyed) {
+			rc = mfs_node_free(mnode);
+		} else {
+			/*
+			 * Keep the node in memory, its inode is written back
+			 * when the node is evicted.
+			 */
+			list_append(&mnode->unused_link, &unused_nodes);
+			if (++unused_nodes_cnt > MFS_UNUSED_NODES_MAX) {
+				struct mfs_node *lru = list_get_instance(
+				    list_first(&unused_nodes), struct mfs_node,
+				    unused_link);
+
+				list_remove(&lru->unused_link);
+				unused_nodes_cnt--;
+				rc = mfs_node_free(lru);
+			}
+		}
 	}
 
 	fibril_mutex_unlock(&open_nodes_lock);
@@ -620,6 +701,13 @@ mfs_node_core_get(fs_node_t **rfn, struct mfs_instance *inst,
 	if (already_open) {
 		mnode = hash_table_get_inst(already_open, struct mfs_node, link);
 
+		if (mnode->refcnt == 0) {
+			/* Reuse an unused node */
+			list_remove(&mnode->unused_link);
+			unused_nodes_cnt--;
+			inst->open_nodes_cnt++;
+		}
+
 		*rfn = mnode->fsnode;
 		mnode->refcnt++;
 
@@ -650,6 +738,9 @@ mfs_node_core_get(fs_node_t **rfn, struct mfs_instance *inst,
 	ino_i->index = index;
 	mnode->ino_i = ino_i;
 	mnode->refcnt = 1;
+	link_initialize(&mnode->unused_link);
+	mnode->destroyed = false;
+	mfs_ind_cache_init(mnode);
 
 	mnode->instance = inst;
 	node->data = mnode;
@@ -1052,6 +1143,10 @@ mfs_destroy_node(fs_node_t *fn)
 
 	/* Mark the inode as free in the bitmap */
 	r = mfs_free_inode(mnode->instance, mnode->ino_i->index);
+	if (r == EOK) {
+		/* The inode number may be reused, drop the node on put */
+		mnode->destroyed = true;
+	}
 
 out:
 	mfs_node_put(fn);
@@ -1170,6 +1265,13 @@ mfs_sync(service_id_t service_id, fs_index_t index)
 	struct mfs_node *mnode = fn->data;
 	mnode->ino_i->dirty = true;
 
+	/* The inode would be written only when the node gets evicted */
+	rc = mfs_put_inode(mnode);
+	if (rc != EOK) {
+		mfs_node_put(fn);
+		return rc;
+	}
+
 	return mfs_node_put(fn);
 }
 
@@ -34,7 +34,7 @@
 #include "mfs.h"
 
 static errno_t
-rw_map_ondisk(uint32_t *b, const struct mfs_node *mnode, int rblock,
+rw_map_ondisk(uint32_t *b, struct mfs_node *mnode, int rblock,
     bool write_mode, uint32_t w_block);
 
 static errno_t
@@ -44,7 +44,14 @@ static errno_t
 alloc_zone_and_clear(struct mfs_instance *inst, uint32_t *zone);
 
 static errno_t
-read_ind_zone(struct mfs_instance *inst, uint32_t zone, uint32_t **ind_zone);
+get_ind_zone(struct mfs_node *mnode, mfs_ind_slot_t slot, uint32_t zone,
+    uint32_t **ind_zone);
+
+static errno_t
+put_ind_zone(struct mfs_node *mnode, mfs_ind_slot_t slot);
+
+static errno_t
+read_ind_zone(struct mfs_instance *inst, uint32_t zone, uint32_t *ind_zone);
 
 static errno_t
 write_ind_zone(struct mfs_instance *inst, uint32_t zone, uint32_t *ind_zone);
@@ -60,7 +67,7 @@ write_ind_zone(struct mfs_instance *inst, uint32_t zone, uint32_t *ind_zone);
  * @return	EOK on success or an error code.
  */
 errno_t
-mfs_read_map(uint32_t *b, const struct mfs_node *mnode, uint32_t pos)
+mfs_read_map(uint32_t *b, struct mfs_node *mnode, uint32_t pos)
 {
 	errno_t r;
 	const struct mfs_sb_info *sbi = mnode->instance->sbi;
@@ -99,12 +106,12 @@ mfs_write_map(struct mfs_node *mnode, const uint32_t pos, uint32_t new_zone,
 }
 
 static errno_t
-rw_map_ondisk(uint32_t *b, const struct mfs_node *mnode, int rblock,
+rw_map_ondisk(uint32_t *b, struct mfs_node *mnode, int rblock,
     bool write_mode, uint32_t w_block)
 {
 	int nr_direct;
 	int ptrs_per_block;
-	uint32_t *ind_zone = NULL, *ind2_zone = NULL;
+	uint32_t *ind_zone, *ind2_zone;
 	errno_t r = EOK;
 
 	struct mfs_ino_info *ino_i = mnode->ino_i;
@@ -152,14 +159,15 @@ rw_map_ondisk(uint32_t *b, const struct mfs_node *mnode, int rblock,
 			}
 		}
 
-		r = read_ind_zone(inst, ino_i->i_izone[0], &ind_zone);
+		r = get_ind_zone(mnode, MFS_IND_SINGLE, ino_i->i_izone[0],
+		    &ind_zone);
 		if (r != EOK)
 			goto out;
 
 		*b = ind_zone[rblock];
 		if (write_mode) {
 			ind_zone[rblock] = w_block;
-			write_ind_zone(inst, ino_i->i_izone[0], ind_zone);
+			r = put_ind_zone(mnode, MFS_IND_SINGLE);
 		}
 
 		goto out;
@@ -186,7 +194,7 @@ rw_map_ondisk(uint32_t *b, const struct mfs_node *mnode, int rblock,
 		}
 	}
 
-	r = read_ind_zone(inst, ino_i->i_izone[1], &ind_zone);
+	r = get_ind_zone(mnode, MFS_IND_DOUBLE, ino_i->i_izone[1], &ind_zone);
 	if (r != EOK)
 		goto out;
 
@@ -205,7 +213,9 @@ rw_map_ondisk(uint32_t *b, const struct mfs_node *mnode, int rblock,
 				goto out;
 
 			ind_zone[ind2_off] = zone;
-			write_ind_zone(inst, ino_i->i_izone[1], ind_zone);
+			r = put_ind_zone(mnode, MFS_IND_DOUBLE);
+			if (r != EOK)
+				goto out;
 		} else {
 			/* Sparse block */
 			*b = 0;
@@ -213,19 +223,18 @@ rw_map_ondisk(uint32_t *b, const struct mfs_node *mnode, int rblock,
 		}
 	}
 
-	r = read_ind_zone(inst, ind_zone[ind2_off], &ind2_zone);
+	r = get_ind_zone(mnode, MFS_IND_DOUBLE2, ind_zone[ind2_off],
+	    &ind2_zone);
 	if (r != EOK)
 		goto out;
 
 	*b = ind2_zone[rblock - (ind2_off * ptrs_per_block)];
 	if (write_mode) {
 		ind2_zone[rblock - (ind2_off * ptrs_per_block)] = w_block;
-		write_ind_zone(inst, ind_zone[ind2_off], ind2_zone);
+		r = put_ind_zone(mnode, MFS_IND_DOUBLE2);
 	}
 
 out:
-	free(ind2_zone);
-	free(ind_zone);
 	return r;
 }
 
@@ -269,6 +278,7 @@ mfs_prune_ind_zones(struct mfs_node *mnode, size_t new_size)
 
 			ino_i->i_izone[0] = 0;
 			ino_i->dirty = true;
+			mnode->ind_cache[MFS_IND_SINGLE].zone = 0;
 		}
 	}
 
@@ -287,29 +297,72 @@ mfs_prune_ind_zones(struct mfs_node *mnode, size_t new_size)
 		return EOK;
 	}
 
-	r = read_ind_zone(inst, ino_i->i_izone[1], &dbl_zone);
+	r = get_ind_zone(mnode, MFS_IND_DOUBLE, ino_i->i_izone[1], &dbl_zone);
 	if (r != EOK)
 		return r;
 
+	/* The cached second zone of the chain may be freed below */
+	mnode->ind_cache[MFS_IND_DOUBLE2].zone = 0;
+
+	bool changed = false;
 	for (i = fzone_to_free; i < ptrs_per_block; ++i) {
 		if (dbl_zone[i] == 0)
 			continue;
 
 		r = mfs_free_zone(inst, dbl_zone[i]);
 		if (r != EOK)
-			goto out;
+			break;
+
+		dbl_zone[i] = 0;
+		changed = true;
 	}
 
 	if (fzone_to_free == 0) {
-		r = mfs_free_zone(inst, ino_i->i_izone[1]);
+		if (r == EOK)
+			r = mfs_free_zone(inst, ino_i->i_izone[1]);
 		ino_i->i_izone[1] = 0;
 		ino_i->dirty = true;
+		mnode->ind_cache[MFS_IND_DOUBLE].zone = 0;
+	} else if (changed) {
+		errno_t r2 = put_ind_zone(mnode, MFS_IND_DOUBLE);
+		if (r == EOK)
+			r = r2;
 	}
-out:
-	free(dbl_zone);
+
 	return r;
 }
 
+/**Initialize the cache of indirect zones of an in-core node.
+ *
+ * @param mnode		Pointer to a generic MINIX inode in memory.
+ */
+void
+mfs_ind_cache_init(struct mfs_node *mnode)
+{
+	int i;
+
+	for (i = 0; i < MFS_IND_CACHE_SIZE; ++i) {
+		mnode->ind_cache[i].zone = 0;
+		mnode->ind_cache[i].ptrs = NULL;
+	}
+}
+
+/**Release the cache of indirect zones of an in-core node.
+ *
+ * @param mnode		Pointer to a generic MINIX inode in memory.
+ */
+void
+mfs_ind_cache_fini(struct mfs_node *mnode)
+{
+	int i;
+
+	for (i = 0; i < MFS_IND_CACHE_SIZE; ++i) {
+		free(mnode->ind_cache[i].ptrs);
+		mnode->ind_cache[i].zone = 0;
+		mnode->ind_cache[i].ptrs = NULL;
+	}
+}
+
 static errno_t
 reset_zone_content(struct mfs_instance *inst, uint32_t zone)
 {
@@ -339,36 +392,95 @@ alloc_zone_and_clear(struct mfs_instance *inst, uint32_t *zone)
 	return r;
 }
 
+/**Get the pointers stored in an indirect zone of a node.
+ *
+ * The zone is read only if it is not the one cached in the given slot. The
+ * returned array belongs to the cache, changes made to it must be written
+ * with put_ind_zone().
+ *
+ * @param mnode		Pointer to a generic MINIX inode in memory.
+ * @param slot		Cache slot of the indirect zone.
+ * @param zone		Number of the indirect zone.
+ * @param ind_zone	Pointer where the address of the array will be stored.
+ *
+ * @return		EOK on success or an error code.
+ */
 static errno_t
-read_ind_zone(struct mfs_instance *inst, uint32_t zone, uint32_t **ind_zone)
+get_ind_zone(struct mfs_node *mnode, mfs_ind_slot_t slot, uint32_t zone,
+    uint32_t **ind_zone)
+{
+	struct mfs_ind_zone *iz = &mnode->ind_cache[slot];
+	const int max_ind_zone_ptrs = (MFS_MAX_BLOCKSIZE / sizeof(uint16_t)) *
+	    sizeof(uint32_t);
+	errno_t r;
+
+	if (iz->zone == zone && iz->ptrs != NULL) {
+		*ind_zone = iz->ptrs;
+		return EOK;
+	}
+
+	if (iz->ptrs == NULL) {
+		iz->ptrs = malloc(max_ind_zone_ptrs);
+		if (iz->ptrs == NULL)
+			return ENOMEM;
+	}
+
+	iz->zone = 0;
+	r = read_ind_zone(mnode->instance, zone, iz->ptrs);
+	if (r != EOK)
+		return r;
+
+	iz->zone = zone;
+	*ind_zone = iz->ptrs;
+	return EOK;
+}
+
+/**Write back the indirect zone cached in a slot.
+ *
+ * @param mnode		Pointer to a generic MINIX inode in memory.
+ * @param slot		Cache slot of the indirect zone.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t
+put_ind_zone(struct mfs_node *mnode, mfs_ind_slot_t slot)
+{
+	struct mfs_ind_zone *iz = &mnode->ind_cache[slot];
+	errno_t r;
+
+	assert(iz->zone != 0);
+
+	r = write_ind_zone(mnode->instance, iz->zone, iz->ptrs);
+	if (r != EOK) {
+		/* The cached copy no longer matches the disk */
+		iz->zone = 0;
+	}
+
+	return r;
+}
+
+static errno_t
+read_ind_zone(struct mfs_instance *inst, uint32_t zone, uint32_t *ind_zone)
 {
 	struct mfs_sb_info *sbi = inst->sbi;
 	errno_t r;
 	unsigned i;
 	block_t *b;
-	const int max_ind_zone_ptrs = (MFS_MAX_BLOCKSIZE / sizeof(uint16_t)) *
-	    sizeof(uint32_t);
-
-	*ind_zone = malloc(max_ind_zone_ptrs);
-	if (*ind_zone == NULL)
-		return ENOMEM;
 
 	r = block_get(&b, inst->service_id, zone, BLOCK_FLAGS_NONE);
-	if (r != EOK) {
-		free(*ind_zone);
+	if (r != EOK)
 		return r;
-	}
 
 	if (sbi->fs_version == MFS_VERSION_V1) {
 		uint16_t *src_ptr = b->data;
 
 		for (i = 0; i < sbi->block_size / sizeof(uint16_t); ++i)
-			(*ind_zone)[i] = conv16(sbi->native, src_ptr[i]);
+			ind_zone[i] = conv16(sbi->native, src_ptr[i]);
 	} else {
 		uint32_t *src_ptr = b->data;
 
 		for (i = 0; i < sbi->block_size / sizeof(uint32_t); ++i)
-			(*ind_zone)[i] = conv32(sbi->native, src_ptr[i]);
+			ind_zone[i] = conv32(sbi->native, src_ptr[i]);
 	}
 
 	return block_put(b);
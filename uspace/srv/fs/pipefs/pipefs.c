@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup pipefs
+ * @{
+ */
+
+/**
+ * @file	pipefs.c
+ * @brief	File system server providing pipes.
+ *
+ * Every directory created in the root of a pipefs instance is a pipe. It
+ * holds two files, @c r and @c w, which are the read end and the write end
+ * of the pipe. Data written to the write end is buffered in memory until it
+ * is read from the read end. Once the names are unlinked, the pipe lives as
+ * long as the handles to its ends do.
+ */
+
+#include "pipefs.h"
+#include <ipc/services.h>
+#include <ns.h>
+#include <async.h>
+#include <errno.h>
+#include <str_error.h>
+#include <stdio.h>
+#include <task.h>
+#include <libfs.h>
+#include <str.h>
+#include "../../vfs/vfs.h"
+
+#define NAME  "pipefs"
+
+vfs_info_t pipefs_vfs_info = {
+	.name = NAME,
+	/* Each end is only ever read or only ever written. */
+	.concurrent_read_write = true,
+	.write_retains_size = true,
+	.page_cache = false,
+	.name_cache = false,
+	.instance = 0,
+};
+
+int main(int argc, char **argv)
+{
+	printf("%s: HelenOS pipe file system server\n", NAME);
+
+	if (argc == 3) {
+		if (!str_cmp(argv[1], "--instance"))
+			pipefs_vfs_info.instance = strtol(argv[2], NULL, 10);
+		else {
+			printf("%s: Unrecognized parameters", NAME);
+			return -1;
+		}
+	}
+
+	if (!pipefs_init()) {
+		printf("%s: Failed to initialize PIPEFS\n", NAME);
+		return -1;
+	}
+
+	errno_t rc;
+	async_sess_t *vfs_sess = service_connect_blocking(SERVICE_VFS,
+	    INTERFACE_VFS_DRIVER, 0, &rc);
+	if (!vfs_sess) {
+		printf("%s: Unable to connect to VFS: %s\n", NAME, str_error(rc));
+		return -1;
+	}
+
+	rc = fs_register(vfs_sess, &pipefs_vfs_info, &pipefs_ops,
+	    &pipefs_libfs_ops);
+	if (rc != EOK) {
+		printf("%s: Failed to register file system: %s\n", NAME,
+		    str_error(rc));
+		return rc;
+	}
+
+	printf("%s: Accepting connections\n", NAME);
+	task_retval(0);
+	async_manager();
+
+	/* Not reached */
+	return 0;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup pipefs
+ * @{
+ */
+
+#ifndef PIPEFS_PIPEFS_H_
+#define PIPEFS_PIPEFS_H_
+
+#include <libfs.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <fibril_synch.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+
+#define PIPEFS_NODE(node)	((node) ? (pipefs_node_t *)(node)->data : NULL)
+#define FS_NODE(node)		((node) ? (node)->bp : NULL)
+
+/** Capacity of the buffer of a pipe in bytes. */
+#define PIPEFS_BUF_SIZE  16384
+
+typedef enum {
+	/** Root directory or directory holding the ends of a pipe */
+	PIPEFS_DIRECTORY,
+	/** Read end of a pipe */
+	PIPEFS_READER,
+	/** Write end of a pipe */
+	PIPEFS_WRITER
+} pipefs_node_type_t;
+
+/** Pipe shared by its read end and write end nodes. */
+typedef struct {
+	/** Protects all fields below */
+	fibril_mutex_t lock;
+	/** Signalled when data, space or the end of a pipe end arrives */
+	fibril_condvar_t cv;
+	/** The read end node was destroyed */
+	bool reader_gone;
+	/** The write end node was destroyed */
+	bool writer_gone;
+	/** Position of the first byte buffered in @c buf */
+	size_t head;
+	/** Number of bytes buffered in @c buf */
+	size_t count;
+	/** Ring buffer of the written but not yet read data */
+	uint8_t buf[PIPEFS_BUF_SIZE];
+} pipefs_pipe_t;
+
+/* forward declaration */
+struct pipefs_node;
+
+typedef struct pipefs_dentry {
+	link_t link;		/**< Linkage for the list of siblings. */
+	struct pipefs_node *node;/**< Back pointer to PIPEFS node. */
+	char *name;		/**< Name of dentry. */
+} pipefs_dentry_t;
+
+typedef struct pipefs_node {
+	fs_node_t *bp;		/**< Back pointer to the FS node. */
+	fs_index_t index;	/**< PIPEFS node index. */
+	service_id_t service_id;/**< Service ID of the instance. */
+	ht_link_t nh_link;	/**< Nodes hash table link. */
+	pipefs_node_type_t type;
+	unsigned lnkcnt;	/**< Link count. */
+	pipefs_pipe_t *pipe;	/**< Pipe of a read or write end. */
+	list_t cs_list;		/**< Child's siblings list. */
+} pipefs_node_t;
+
+extern vfs_out_ops_t pipefs_ops;
+extern libfs_ops_t pipefs_libfs_ops;
+
+extern bool pipefs_init(void);
+
+#endif
+
+/**
+ * @}
+ */
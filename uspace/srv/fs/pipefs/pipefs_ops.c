@@ -0,0 +1,819 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup pipefs
+ * @{
+ */
+
+/**
+ * @file	pipefs_ops.c
+ * @brief	Implementation of VFS operations for the PIPEFS file system
+ *		server.
+ */
+
+#include "pipefs.h"
+#include "../../vfs/vfs.h"
+#include <macros.h>
+#include <stdint.h>
+#include <async.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <str.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stddef.h>
+#include <adt/hash_table.h>
+#include <adt/hash.h>
+#include <libfs.h>
+
+/** All root nodes have index 0. */
+#define PIPEFS_SOME_ROOT  0
+
+/** Names of the ends in the directory of a pipe. */
+#define PIPEFS_READER_NAME  "r"
+#define PIPEFS_WRITER_NAME  "w"
+
+/** Global counter for assigning node indices. Shared by all instances. */
+static fs_index_t pipefs_next_index = 1;
+
+/*
+ * Implementation of the libfs interface.
+ */
+
+/* Forward declarations of static functions. */
+static errno_t pipefs_match(fs_node_t **, fs_node_t *, const char *);
+static errno_t pipefs_node_get(fs_node_t **, service_id_t, fs_index_t);
+static errno_t pipefs_node_open(fs_node_t *);
+static errno_t pipefs_node_put(fs_node_t *);
+static errno_t pipefs_create_node(fs_node_t **, service_id_t, int);
+static errno_t pipefs_destroy_node(fs_node_t *);
+static errno_t pipefs_link_node(fs_node_t *, fs_node_t *, const char *);
+static errno_t pipefs_unlink_node(fs_node_t *, fs_node_t *, const char *);
+
+/* Implementation of helper functions. */
+static errno_t pipefs_root_get(fs_node_t **rfn, service_id_t service_id)
+{
+	return pipefs_node_get(rfn, service_id, PIPEFS_SOME_ROOT);
+}
+
+static errno_t pipefs_has_children(bool *has_children, fs_node_t *fn)
+{
+	*has_children = !list_empty(&PIPEFS_NODE(fn)->cs_list);
+	return EOK;
+}
+
+static fs_index_t pipefs_index_get(fs_node_t *fn)
+{
+	return PIPEFS_NODE(fn)->index;
+}
+
+static aoff64_t pipefs_size_get(fs_node_t *fn)
+{
+	/* Pipes have no size, their data can only be read once. */
+	return 0;
+}
+
+static unsigned pipefs_lnkcnt_get(fs_node_t *fn)
+{
+	return PIPEFS_NODE(fn)->lnkcnt;
+}
+
+static bool pipefs_is_directory(fs_node_t *fn)
+{
+	return PIPEFS_NODE(fn)->type == PIPEFS_DIRECTORY;
+}
+
+static bool pipefs_is_file(fs_node_t *fn)
+{
+	return PIPEFS_NODE(fn)->type != PIPEFS_DIRECTORY;
+}
+
+static service_id_t pipefs_service_get(fs_node_t *fn)
+{
+	return 0;
+}
+
+/** libfs operations */
+libfs_ops_t pipefs_libfs_ops = {
+	.root_get = pipefs_root_get,
+	.match = pipefs_match,
+	.node_get = pipefs_node_get,
+	.node_open = pipefs_node_open,
+	.node_put = pipefs_node_put,
+	.create = pipefs_create_node,
+	.destroy = pipefs_destroy_node,
+	.link = pipefs_link_node,
+	.unlink = pipefs_unlink_node,
+	.has_children = pipefs_has_children,
+	.index_get = pipefs_index_get,
+	.size_get = pipefs_size_get,
+	.lnkcnt_get = pipefs_lnkcnt_get,
+	.is_directory = pipefs_is_directory,
+	.is_file = pipefs_is_file,
+	.service_get = pipefs_service_get
+};
+
+/** Hash table of all PIPEFS nodes. */
+static hash_table_t nodes;
+
+/*
+ * Implementation of hash table interface for the nodes hash table.
+ */
+
+typedef struct {
+	service_id_t service_id;
+	fs_index_t index;
+} node_key_t;
+
+static size_t nodes_key_hash(const void *k)
+{
+	const node_key_t *key = k;
+	return hash_combine(key->service_id, key->index);
+}
+
+static size_t nodes_hash(const ht_link_t *item)
+{
+	pipefs_node_t *nodep = hash_table_get_inst(item, pipefs_node_t, nh_link);
+	return hash_combine(nodep->service_id, nodep->index);
+}
+
+static bool nodes_key_equal(const void *key_arg, const ht_link_t *item)
+{
+	pipefs_node_t *node = hash_table_get_inst(item, pipefs_node_t, nh_link);
+	const node_key_t *key = key_arg;
+
+	return key->service_id == node->service_id && key->index == node->index;
+}
+
+/** Detach a read or write end from its pipe.
+ *
+ * The fibrils blocked on the other end are woken up so that they see the
+ * end of file or the broken pipe. The pipe is freed together with the
+ * second of its ends.
+ *
+ * @param nodep		Read or write end node
+ */
+static void pipefs_end_detach(pipefs_node_t *nodep)
+{
+	pipefs_pipe_t *pipe = nodep->pipe;
+	bool last;
+
+	if (!pipe)
+		return;
+
+	fibril_mutex_lock(&pipe->lock);
+	if (nodep->type == PIPEFS_READER)
+		pipe->reader_gone = true;
+	else
+		pipe->writer_gone = true;
+	last = pipe->reader_gone && pipe->writer_gone;
+	fibril_condvar_broadcast(&pipe->cv);
+	fibril_mutex_unlock(&pipe->lock);
+
+	nodep->pipe = NULL;
+	if (last)
+		free(pipe);
+}
+
+static void nodes_remove_callback(ht_link_t *item)
+{
+	pipefs_node_t *nodep = hash_table_get_inst(item, pipefs_node_t, nh_link);
+
+	while (!list_empty(&nodep->cs_list)) {
+		pipefs_dentry_t *dentryp = list_get_instance(
+		    list_first(&nodep->cs_list), pipefs_dentry_t, link);
+
+		assert(nodep->type == PIPEFS_DIRECTORY);
+		list_remove(&dentryp->link);
+		free(dentryp->name);
+		free(dentryp);
+	}
+
+	pipefs_end_detach(nodep);
+	free(nodep->bp);
+	free(nodep);
+}
+
+/** PIPEFS nodes hash table operations. */
+static const hash_table_ops_t nodes_ops = {
+	.hash = nodes_hash,
+	.key_hash = nodes_key_hash,
+	.key_equal = nodes_key_equal,
+	.equal = NULL,
+	.remove_callback = nodes_remove_callback
+};
+
+static void pipefs_node_initialize(pipefs_node_t *nodep)
+{
+	nodep->bp = NULL;
+	nodep->index = 0;
+	nodep->service_id = 0;
+	nodep->type = PIPEFS_DIRECTORY;
+	nodep->lnkcnt = 0;
+	nodep->pipe = NULL;
+	list_initialize(&nodep->cs_list);
+}
+
+static void pipefs_dentry_initialize(pipefs_dentry_t *dentryp)
+{
+	link_initialize(&dentryp->link);
+	dentryp->name = NULL;
+	dentryp->node = NULL;
+}
+
+bool pipefs_init(void)
+{
+	if (!hash_table_create(&nodes, 0, 0, &nodes_ops))
+		return false;
+
+	return true;
+}
+
+/** Look up a PIPEFS node by its index.
+ *
+ * @param service_id	Service ID of the instance
+ * @param index		Index of the node
+ *
+ * @return		PIPEFS node or @c NULL if there is no such node
+ */
+static pipefs_node_t *pipefs_node_find(service_id_t service_id,
+    fs_index_t index)
+{
+	node_key_t key = {
+		.service_id = service_id,
+		.index = index
+	};
+
+	ht_link_t *lnk = hash_table_find(&nodes, &key);
+	if (!lnk)
+		return NULL;
+
+	return hash_table_get_inst(lnk, pipefs_node_t, nh_link);
+}
+
+static bool pipefs_instance_init(service_id_t service_id)
+{
+	fs_node_t *rfn;
+	errno_t rc;
+
+	rc = pipefs_create_node(&rfn, service_id, L_DIRECTORY);
+	if (rc != EOK || !rfn)
+		return false;
+	PIPEFS_NODE(rfn)->lnkcnt = 0;	/* FS root is not linked */
+	return true;
+}
+
+static bool rm_service_id_nodes(ht_link_t *item, void *arg)
+{
+	service_id_t sid = *(service_id_t *)arg;
+	pipefs_node_t *node = hash_table_get_inst(item, pipefs_node_t, nh_link);
+
+	if (node->service_id == sid) {
+		hash_table_remove_item(&nodes, &node->nh_link);
+	}
+	return true;
+}
+
+static void pipefs_instance_done(service_id_t service_id)
+{
+	hash_table_apply(&nodes, rm_service_id_nodes, &service_id);
+}
+
+errno_t pipefs_match(fs_node_t **rfn, fs_node_t *pfn, const char *component)
+{
+	pipefs_node_t *parentp = PIPEFS_NODE(pfn);
+
+	list_foreach(parentp->cs_list, link, pipefs_dentry_t, dentryp) {
+		if (!str_cmp(dentryp->name, component)) {
+			*rfn = FS_NODE(dentryp->node);
+			return EOK;
+		}
+	}
+
+	*rfn = NULL;
+	return EOK;
+}
+
+errno_t pipefs_node_get(fs_node_t **rfn, service_id_t service_id,
+    fs_index_t index)
+{
+	pipefs_node_t *nodep = pipefs_node_find(service_id, index);
+
+	*rfn = FS_NODE(nodep);
+	return EOK;
+}
+
+errno_t pipefs_node_open(fs_node_t *fn)
+{
+	/* nothing to do */
+	return EOK;
+}
+
+errno_t pipefs_node_put(fs_node_t *fn)
+{
+	/* nothing to do */
+	return EOK;
+}
+
+/** Allocate a PIPEFS node.
+ *
+ * @param service_id	Service ID of the instance
+ * @param type		Type of the new node
+ *
+ * @return		New node inserted into the nodes hash table or @c NULL
+ *			if out of memory
+ */
+static pipefs_node_t *pipefs_node_alloc(service_id_t service_id,
+    pipefs_node_type_t type)
+{
+	fs_node_t *rootfn;
+	errno_t rc;
+
+	pipefs_node_t *nodep = malloc(sizeof(pipefs_node_t));
+	if (!nodep)
+		return NULL;
+
+	pipefs_node_initialize(nodep);
+	nodep->bp = malloc(sizeof(fs_node_t));
+	if (!nodep->bp) {
+		free(nodep);
+		return NULL;
+	}
+
+	fs_node_initialize(nodep->bp);
+	nodep->bp->data = nodep;  /* Link the FS and PIPEFS nodes */
+
+	rc = pipefs_root_get(&rootfn, service_id);
+	assert(rc == EOK);
+	if (!rootfn)
+		nodep->index = PIPEFS_SOME_ROOT;
+	else
+		nodep->index = pipefs_next_index++;
+
+	nodep->service_id = service_id;
+	nodep->type = type;
+
+	/* Insert the new node into the nodes hash table. */
+	hash_table_insert(&nodes, &nodep->nh_link);
+	return nodep;
+}
+
+errno_t pipefs_create_node(fs_node_t **rfn, service_id_t service_id,
+    int lflag)
+{
+	assert((lflag & L_FILE) ^ (lflag & L_DIRECTORY));
+
+	/* Files only come into existence as the ends of a new pipe. */
+	if (lflag & L_FILE)
+		return ENOTSUP;
+
+	pipefs_node_t *nodep = pipefs_node_alloc(service_id, PIPEFS_DIRECTORY);
+	if (!nodep)
+		return ENOMEM;
+
+	*rfn = FS_NODE(nodep);
+	return EOK;
+}
+
+errno_t pipefs_destroy_node(fs_node_t *fn)
+{
+	pipefs_node_t *nodep = PIPEFS_NODE(fn);
+
+	assert(!nodep->lnkcnt);
+	assert(list_empty(&nodep->cs_list));
+
+	hash_table_remove_item(&nodes, &nodep->nh_link);
+
+	/*
+	 * The nodes_remove_callback() function takes care of the actual
+	 * resource deallocation.
+	 */
+	return EOK;
+}
+
+/** Allocate a directory entry.
+ *
+ * @param nm		Name of the entry
+ *
+ * @return		New entry or @c NULL if out of memory
+ */
+static pipefs_dentry_t *pipefs_dentry_alloc(const char *nm)
+{
+	pipefs_dentry_t *dentryp = malloc(sizeof(pipefs_dentry_t));
+	if (!dentryp)
+		return NULL;
+	pipefs_dentry_initialize(dentryp);
+
+	dentryp->name = str_dup(nm);
+	if (!dentryp->name) {
+		free(dentryp);
+		return NULL;
+	}
+
+	return dentryp;
+}
+
+static void pipefs_dentry_free(pipefs_dentry_t *dentryp)
+{
+	if (dentryp) {
+		free(dentryp->name);
+		free(dentryp);
+	}
+}
+
+/** Link a directory entry to a directory.
+ *
+ * @param parentp	Directory
+ * @param dentryp	Entry allocated by pipefs_dentry_alloc()
+ * @param childp	Node the entry refers to
+ */
+static void pipefs_dentry_link(pipefs_node_t *parentp,
+    pipefs_dentry_t *dentryp, pipefs_node_t *childp)
+{
+	dentryp->node = childp;
+	childp->lnkcnt++;
+	list_append(&dentryp->link, &parentp->cs_list);
+}
+
+/** Populate the directory of a new pipe with the ends of the pipe.
+ *
+ * @param dirp		Empty directory of the pipe
+ *
+ * @return		EOK on success or ENOMEM
+ */
+static errno_t pipefs_pipe_create(pipefs_node_t *dirp)
+{
+	pipefs_pipe_t *pipe = NULL;
+	pipefs_node_t *readerp = NULL;
+	pipefs_node_t *writerp = NULL;
+	pipefs_dentry_t *rdentryp = NULL;
+	pipefs_dentry_t *wdentryp = NULL;
+
+	pipe = malloc(sizeof(pipefs_pipe_t));
+	if (!pipe)
+		goto error;
+
+	rdentryp = pipefs_dentry_alloc(PIPEFS_READER_NAME);
+	if (!rdentryp)
+		goto error;
+
+	wdentryp = pipefs_dentry_alloc(PIPEFS_WRITER_NAME);
+	if (!wdentryp)
+		goto error;
+
+	readerp = pipefs_node_alloc(dirp->service_id, PIPEFS_READER);
+	if (!readerp)
+		goto error;
+
+	writerp = pipefs_node_alloc(dirp->service_id, PIPEFS_WRITER);
+	if (!writerp)
+		goto error;
+
+	fibril_mutex_initialize(&pipe->lock);
+	fibril_condvar_initialize(&pipe->cv);
+	pipe->reader_gone = false;
+	pipe->writer_gone = false;
+	pipe->head = 0;
+	pipe->count = 0;
+
+	readerp->pipe = pipe;
+	writerp->pipe = pipe;
+	pipefs_dentry_link(dirp, rdentryp, readerp);
+	pipefs_dentry_link(dirp, wdentryp, writerp);
+	return EOK;
+error:
+	if (readerp)
+		hash_table_remove_item(&nodes, &readerp->nh_link);
+	pipefs_dentry_free(wdentryp);
+	pipefs_dentry_free(rdentryp);
+	free(pipe);
+	return ENOMEM;
+}
+
+errno_t pipefs_link_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
+{
+	pipefs_node_t *parentp = PIPEFS_NODE(pfn);
+	pipefs_node_t *childp = PIPEFS_NODE(cfn);
+	pipefs_dentry_t *dentryp;
+
+	assert(parentp->type == PIPEFS_DIRECTORY);
+
+	/*
+	 * Pipes can only be created in the root directory and the ends of a
+	 * pipe cannot be linked anywhere else.
+	 */
+	if (parentp->index != PIPEFS_SOME_ROOT ||
+	    childp->type != PIPEFS_DIRECTORY || childp->lnkcnt != 0)
+		return ENOTSUP;
+
+	/* Check for duplicit entries. */
+	list_foreach(parentp->cs_list, link, pipefs_dentry_t, dp) {
+		if (!str_cmp(dp->name, nm))
+			return EEXIST;
+	}
+
+	dentryp = pipefs_dentry_alloc(nm);
+	if (!dentryp)
+		return ENOMEM;
+
+	if (pipefs_pipe_create(childp) != EOK) {
+		pipefs_dentry_free(dentryp);
+		return ENOMEM;
+	}
+
+	pipefs_dentry_link(parentp, dentryp, childp);
+	return EOK;
+}
+
+errno_t pipefs_unlink_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
+{
+	pipefs_node_t *parentp = PIPEFS_NODE(pfn);
+	pipefs_node_t *childp = NULL;
+	pipefs_dentry_t *dentryp;
+
+	if (!parentp)
+		return EBUSY;
+
+	list_foreach(parentp->cs_list, link, pipefs_dentry_t, dp) {
+		if (!str_cmp(dp->name, nm)) {
+			dentryp = dp;
+			childp = dentryp->node;
+			assert(FS_NODE(childp) == cfn);
+			break;
+		}
+	}
+
+	if (!childp)
+		return ENOENT;
+
+	if ((childp->lnkcnt == 1) && !list_empty(&childp->cs_list))
+		return ENOTEMPTY;
+
+	list_remove(&dentryp->link);
+	pipefs_dentry_free(dentryp);
+	childp->lnkcnt--;
+
+	return EOK;
+}
+
+/*
+ * Implementation of the VFS_OUT interface.
+ */
+
+static errno_t pipefs_fsprobe(service_id_t service_id,
+    vfs_fs_probe_info_t *info)
+{
+	return ENOTSUP;
+}
+
+static errno_t
+pipefs_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
+    aoff64_t *size)
+{
+	fs_node_t *rootfn;
+	errno_t rc;
+
+	/* Check if this device is not already mounted. */
+	rc = pipefs_root_get(&rootfn, service_id);
+	if ((rc == EOK) && (rootfn)) {
+		(void) pipefs_node_put(rootfn);
+		return EEXIST;
+	}
+
+	/* Initialize PIPEFS instance. */
+	if (!pipefs_instance_init(service_id))
+		return ENOMEM;
+
+	rc = pipefs_root_get(&rootfn, service_id);
+	assert(rc == EOK);
+
+	*index = PIPEFS_NODE(rootfn)->index;
+	*size = 0;
+
+	return EOK;
+}
+
+static errno_t pipefs_unmounted(service_id_t service_id)
+{
+	pipefs_instance_done(service_id);
+	return EOK;
+}
+
+/** Read from the read end of a pipe.
+ *
+ * Blocks until there is some data in the pipe or the write end is gone,
+ * which reads as the end of file.
+ *
+ * @param nodep		Read end node
+ * @param call		Client's IPC_M_DATA_READ
+ * @param size		Size requested by the client
+ *
+ * @return		Number of bytes read
+ */
+static size_t pipefs_pipe_read(pipefs_node_t *nodep, ipc_call_t *call,
+    size_t size)
+{
+	pipefs_pipe_t *pipe = nodep->pipe;
+
+	fibril_mutex_lock(&pipe->lock);
+	while (pipe->count == 0 && !pipe->writer_gone)
+		fibril_condvar_wait(&pipe->cv, &pipe->lock);
+
+	/* Read at most up to the wrap-around of the buffer. */
+	size_t bytes = min(size, pipe->count);
+	bytes = min(bytes, PIPEFS_BUF_SIZE - pipe->head);
+
+	(void) async_data_read_finalize(call, pipe->buf + pipe->head, bytes);
+
+	pipe->head = (pipe->head + bytes) % PIPEFS_BUF_SIZE;
+	pipe->count -= bytes;
+	if (pipe->count == 0)
+		pipe->head = 0;
+	if (bytes > 0)
+		fibril_condvar_broadcast(&pipe->cv);
+	fibril_mutex_unlock(&pipe->lock);
+
+	return bytes;
+}
+
+/** Write to the write end of a pipe.
+ *
+ * Blocks until there is some free space in the pipe or the read end is
+ * gone, which fails with EPIPE.
+ *
+ * @param nodep		Write end node
+ * @param call		Client's IPC_M_DATA_WRITE
+ * @param size		Size offered by the client
+ * @param wbytes	Place to store the number of bytes written
+ *
+ * @return		EOK on success or EPIPE
+ */
+static errno_t pipefs_pipe_write(pipefs_node_t *nodep, ipc_call_t *call,
+    size_t size, size_t *wbytes)
+{
+	pipefs_pipe_t *pipe = nodep->pipe;
+
+	fibril_mutex_lock(&pipe->lock);
+	while (pipe->count == PIPEFS_BUF_SIZE && !pipe->reader_gone)
+		fibril_condvar_wait(&pipe->cv, &pipe->lock);
+
+	if (pipe->reader_gone) {
+		fibril_mutex_unlock(&pipe->lock);
+		async_answer_0(call, EPIPE);
+		return EPIPE;
+	}
+
+	/* Write at most up to the wrap-around of the buffer. */
+	size_t tail = (pipe->head + pipe->count) % PIPEFS_BUF_SIZE;
+	size_t bytes = min(size, PIPEFS_BUF_SIZE - pipe->count);
+	bytes = min(bytes, PIPEFS_BUF_SIZE - tail);
+
+	(void) async_data_write_finalize(call, pipe->buf + tail, bytes);
+
+	pipe->count += bytes;
+	fibril_condvar_broadcast(&pipe->cv);
+	fibril_mutex_unlock(&pipe->lock);
+
+	*wbytes = bytes;
+	return EOK;
+}
+
+static errno_t pipefs_read(service_id_t service_id, fs_index_t index,
+    aoff64_t pos, size_t *rbytes)
+{
+	pipefs_node_t *nodep = pipefs_node_find(service_id, index);
+	if (!nodep)
+		return ENOENT;
+
+	/*
+	 * Receive the read request.
+	 */
+	ipc_call_t call;
+	size_t size;
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(&call, EINVAL);
+		return EINVAL;
+	}
+
+	if (nodep->type == PIPEFS_READER) {
+		*rbytes = pipefs_pipe_read(nodep, &call, size);
+		return EOK;
+	}
+
+	if (nodep->type == PIPEFS_WRITER) {
+		async_answer_0(&call, EBADF);
+		return EBADF;
+	}
+
+	/*
+	 * Directories hold at most a few entries except for the root which
+	 * holds as many as there are pipes being set up at the moment.
+	 */
+	link_t *lnk = list_nth(&nodep->cs_list, pos);
+	if (lnk == NULL) {
+		async_answer_0(&call, ENOENT);
+		return ENOENT;
+	}
+
+	pipefs_dentry_t *dentryp = list_get_instance(lnk, pipefs_dentry_t,
+	    link);
+
+	(void) async_data_read_finalize(&call, dentryp->name,
+	    str_size(dentryp->name) + 1);
+	*rbytes = 1;
+	return EOK;
+}
+
+static errno_t
+pipefs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
+    size_t *wbytes, aoff64_t *nsize)
+{
+	pipefs_node_t *nodep = pipefs_node_find(service_id, index);
+	if (!nodep)
+		return ENOENT;
+
+	/*
+	 * Receive the write request.
+	 */
+	ipc_call_t call;
+	size_t size;
+	if (!async_data_write_receive(&call, &size)) {
+		async_answer_0(&call, EINVAL);
+		return EINVAL;
+	}
+
+	if (nodep->type != PIPEFS_WRITER) {
+		async_answer_0(&call, EBADF);
+		return EBADF;
+	}
+
+	*nsize = 0;
+	return pipefs_pipe_write(nodep, &call, size, wbytes);
+}
+
+static errno_t pipefs_truncate(service_id_t service_id, fs_index_t index,
+    aoff64_t size)
+{
+	return ENOTSUP;
+}
+
+static errno_t pipefs_close(service_id_t service_id, fs_index_t index)
+{
+	return EOK;
+}
+
+static errno_t pipefs_destroy(service_id_t service_id, fs_index_t index)
+{
+	pipefs_node_t *nodep = pipefs_node_find(service_id, index);
+	if (!nodep)
+		return ENOENT;
+
+	return pipefs_destroy_node(FS_NODE(nodep));
+}
+
+static errno_t pipefs_sync(service_id_t service_id, fs_index_t index)
+{
+	/* Nothing is ever stored, thus the sync operation is a no-op. */
+	return EOK;
+}
+
+vfs_out_ops_t pipefs_ops = {
+	.fsprobe = pipefs_fsprobe,
+	.mounted = pipefs_mounted,
+	.unmounted = pipefs_unmounted,
+	.read = pipefs_read,
+	.write = pipefs_write,
+	.truncate = pipefs_truncate,
+	.close = pipefs_close,
+	.destroy = pipefs_destroy,
+	.sync = pipefs_sync,
+};
+
+/**
+ * @}
+ */
@@ -64,7 +64,8 @@ typedef struct tmpfs_node {
 	tmpfs_dentry_type_t type;
 	unsigned lnkcnt;	/**< Link count. */
 	size_t size;		/**< File size if type is TMPFS_FILE. */
-	void *data;		/**< File content's if type is TMPFS_FILE. */
+	void **pages;		/**< File content's pages if type is TMPFS_FILE. */
+	size_t npages;		/**< Number of entries in pages. */
 	list_t cs_list;		/**< Child's siblings list. */
 } tmpfs_node_t;
 
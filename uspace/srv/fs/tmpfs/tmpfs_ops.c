@@ -58,6 +58,19 @@
 /** Global counter for assigning node indices. Shared by all instances. */
 fs_index_t tmpfs_next_index = 1;
 
+/**
+ * File contents are kept in separately allocated pages. Pages which were
+ * never written to are not allocated and read as zeros, so are the parts of
+ * allocated pages beyond the end of the file.
+ */
+#define TMPFS_PAGE_SIZE  PAGE_SIZE
+
+/** Minimum number of entries of a newly allocated page table. */
+#define TMPFS_PAGES_MIN  8
+
+/** Contents of the pages which are not allocated. */
+static const uint8_t tmpfs_zero_page[TMPFS_PAGE_SIZE];
+
 /*
  * Implementation of the libfs interface.
  */
@@ -166,6 +179,77 @@ static bool nodes_key_equal(const void *key_arg, const ht_link_t *item)
 	return key->service_id == node->service_id && key->index == node->index;
 }
 
+/** Make sure the page table of a file node has at least @a n entries.
+ *
+ * The table grows geometrically so that appending to a file costs O(1)
+ * amortized time and only the table, not the file content, is ever copied.
+ *
+ * @param nodep		TMPFS node
+ * @param n		Required number of entries
+ *
+ * @return		EOK on success or ENOMEM
+ */
+static errno_t tmpfs_pages_grow(tmpfs_node_t *nodep, size_t n)
+{
+	if (n <= nodep->npages)
+		return EOK;
+
+	size_t npages = max(max(n, 2 * nodep->npages), (size_t) TMPFS_PAGES_MIN);
+	if (npages > SIZE_MAX / sizeof(void *))
+		return ENOMEM;
+
+	void **pages = realloc(nodep->pages, npages * sizeof(void *));
+	if (!pages)
+		return ENOMEM;
+
+	memset(pages + nodep->npages, 0,
+	    (npages - nodep->npages) * sizeof(void *));
+	nodep->pages = pages;
+	nodep->npages = npages;
+	return EOK;
+}
+
+/** Release the content of a file node beyond a new size.
+ *
+ * Pages which lie entirely beyond @a size are freed and the rest of the
+ * last partial page is cleared so that it reads as zeros if the file grows
+ * again.
+ *
+ * @param nodep		TMPFS node
+ * @param size		New size of the file
+ */
+static void tmpfs_pages_trim(tmpfs_node_t *nodep, size_t size)
+{
+	size_t first = size / TMPFS_PAGE_SIZE;
+	size_t off = size % TMPFS_PAGE_SIZE;
+
+	if (off != 0) {
+		if (first < nodep->npages && nodep->pages[first]) {
+			memset(nodep->pages[first] + off, 0,
+			    TMPFS_PAGE_SIZE - off);
+		}
+		first++;
+	}
+
+	for (size_t i = first; i < nodep->npages; i++) {
+		free(nodep->pages[i]);
+		nodep->pages[i] = NULL;
+	}
+
+	if (first == 0) {
+		free(nodep->pages);
+		nodep->pages = NULL;
+		nodep->npages = 0;
+	} else if (first < nodep->npages / 4) {
+		/* Shrink the table, it is fine to keep it if this fails. */
+		void **pages = realloc(nodep->pages, first * sizeof(void *));
+		if (pages) {
+			nodep->pages = pages;
+			nodep->npages = first;
+		}
+	}
+}
+
 static void nodes_remove_callback(ht_link_t *item)
 {
 	tmpfs_node_t *nodep = hash_table_get_inst(item, tmpfs_node_t, nh_link);
@@ -179,9 +263,9 @@ static void nodes_remove_callback(ht_link_t *item)
 		free(dentryp);
 	}
 
-	if (nodep->data) {
+	if (nodep->pages) {
 		assert(nodep->type == TMPFS_FILE);
-		free(nodep->data);
+		tmpfs_pages_trim(nodep, 0);
 	}
 	free(nodep->bp);
 	free(nodep);
@@ -204,7 +288,8 @@ static void tmpfs_node_initialize(tmpfs_node_t *nodep)
 	nodep->type = TMPFS_NONE;
 	nodep->lnkcnt = 0;
 	nodep->size = 0;
-	nodep->data = NULL;
+	nodep->pages = NULL;
+	nodep->npages = 0;
 	list_initialize(&nodep->cs_list);
 }
 
@@ -491,9 +576,23 @@ static errno_t tmpfs_read(service_id_t service_id, fs_index_t index, aoff64_t po
 
 	size_t bytes;
 	if (nodep->type == TMPFS_FILE) {
+		if (pos >= nodep->size) {
+			(void) async_data_read_finalize(&call, NULL, 0);
+			*rbytes = 0;
+			return EOK;
+		}
+
+		/* Read at most one page. */
+		size_t idx = pos / TMPFS_PAGE_SIZE;
+		size_t off = pos % TMPFS_PAGE_SIZE;
 		bytes = min(nodep->size - pos, size);
-		(void) async_data_read_finalize(&call, nodep->data + pos,
-		    bytes);
+		bytes = min(bytes, TMPFS_PAGE_SIZE - off);
+
+		const uint8_t *page = tmpfs_zero_page;
+		if (idx < nodep->npages && nodep->pages[idx])
+			page = nodep->pages[idx];
+
+		(void) async_data_read_finalize(&call, page + off, bytes);
 	} else {
 		tmpfs_dentry_t *dentryp;
 		link_t *lnk;
@@ -552,34 +651,37 @@ tmpfs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
 		return EINVAL;
 	}
 
-	/*
-	 * Check whether the file needs to grow.
-	 */
-	if (pos + size <= nodep->size) {
-		/* The file size is not changing. */
-		(void) async_data_write_finalize(&call, nodep->data + pos,
-		    size);
+	if (pos + size > SIZE_MAX) {
+		async_answer_0(&call, ENOMEM);
+		size = 0;
 		goto out;
 	}
-	size_t delta = (pos + size) - nodep->size;
+
 	/*
-	 * At this point, we are deliberately extremely straightforward and
-	 * simply realloc the contents of the file on every write that grows the
-	 * file. In the end, the situation might not be as bad as it may look:
-	 * our heap allocator can save us and just grow the block whenever
-	 * possible.
+	 * Write at most one page and allocate it if it is a hole so far.
 	 */
-	void *newdata = realloc(nodep->data, nodep->size + delta);
-	if (!newdata) {
+	size_t idx = pos / TMPFS_PAGE_SIZE;
+	size_t off = pos % TMPFS_PAGE_SIZE;
+	size = min(size, TMPFS_PAGE_SIZE - off);
+
+	if (tmpfs_pages_grow(nodep, idx + 1) != EOK) {
 		async_answer_0(&call, ENOMEM);
 		size = 0;
 		goto out;
 	}
-	/* Clear any newly allocated memory in order to emulate gaps. */
-	memset(newdata + nodep->size, 0, delta);
-	nodep->size += delta;
-	nodep->data = newdata;
-	(void) async_data_write_finalize(&call, nodep->data + pos, size);
+
+	if (!nodep->pages[idx]) {
+		nodep->pages[idx] = calloc(1, TMPFS_PAGE_SIZE);
+		if (!nodep->pages[idx]) {
+			async_answer_0(&call, ENOMEM);
+			size = 0;
+			goto out;
+		}
+	}
+
+	(void) async_data_write_finalize(&call, nodep->pages[idx] + off, size);
+	if (pos + size > nodep->size)
+		nodep->size = pos + size;
 
 out:
 	*wbytes = size;
@@ -609,17 +711,11 @@ static errno_t tmpfs_truncate(service_id_t service_id, fs_index_t index,
 	if (size > SIZE_MAX)
 		return ENOMEM;
 
-	void *newdata = realloc(nodep->data, size);
-	if (!newdata && size)
-		return ENOMEM;
-
-	if (size > nodep->size) {
-		size_t delta = size - nodep->size;
-		memset(newdata + nodep->size, 0, delta);
-	}
+	/* Growing the file only leaves a hole. */
+	if (size < nodep->size)
+		tmpfs_pages_trim(nodep, size);
 
 	nodep->size = size;
-	nodep->data = newdata;
 	return EOK;
 }
 
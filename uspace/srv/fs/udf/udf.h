@@ -92,6 +92,17 @@ typedef struct {
 	uint64_t uaspace_start;
 	uint64_t uaspace_length;
 	uint8_t space_type;
+
+	/* Read-ahead window over file extents, see udf_read_file() */
+	fibril_mutex_t ra_lock;
+	uint8_t *ra_buf;
+	uint32_t ra_start;
+	size_t ra_count;
+
+	/* Parsed directories, see udf_dcache.c */
+	fibril_mutex_t dcache_lock;
+	hash_table_t dcache_dirs;
+	hash_table_t dcache_entries;
 } udf_instance_t;
 
 typedef struct udf_allocator {
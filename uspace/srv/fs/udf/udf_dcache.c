@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup udf
+ * @{
+ */
+/**
+ * @file udf_dcache.c
+ * @brief Cache of parsed UDF directories
+ *
+ * The first lookup in a directory decodes all of its FIDs and records
+ * every name in a per-instance hash table. Further lookups in the same
+ * directory are then answered by a single hash table search. Entries are
+ * keyed by the directory index rather than by the node, since UDF nodes
+ * are freed as soon as their last reference is put.
+ */
+
+#include <adt/hash_table.h>
+#include <adt/hash.h>
+#include <block.h>
+#include <byteorder.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <stdlib.h>
+#include <str.h>
+#include "udf.h"
+#include "udf_dcache.h"
+#include "udf_file.h"
+#include "udf_osta.h"
+#include "udf_volume.h"
+
+/** Directory whose FIDs have all been entered into the cache */
+typedef struct {
+	ht_link_t link;
+	fs_index_t index;
+} udf_dcache_dir_t;
+
+/** Cached directory entry */
+typedef struct {
+	ht_link_t link;
+	fs_index_t dir;
+	char *name;
+	fs_index_t index;
+} udf_dcache_entry_t;
+
+typedef struct {
+	fs_index_t dir;
+	const char *name;
+} udf_dcache_key_t;
+
+/*
+ * Names are compared case-insensitively, so the hash is computed over
+ * lower-cased characters to keep it consistent with str_casecmp().
+ */
+static size_t udf_dcache_name_hash(fs_index_t dir, const char *name)
+{
+	size_t hash = hash_mix(dir);
+	size_t off = 0;
+	char32_t c;
+
+	while ((c = str_decode(name, &off, STR_NO_LIMIT)) != 0)
+		hash = hash_combine(hash, tolower(c));
+
+	return hash;
+}
+
+static size_t udf_dcache_entry_hash(const ht_link_t *item)
+{
+	udf_dcache_entry_t *entry =
+	    hash_table_get_inst(item, udf_dcache_entry_t, link);
+	return udf_dcache_name_hash(entry->dir, entry->name);
+}
+
+static size_t udf_dcache_entry_key_hash(const void *k)
+{
+	const udf_dcache_key_t *key = k;
+	return udf_dcache_name_hash(key->dir, key->name);
+}
+
+static bool udf_dcache_entry_key_equal(const void *k, const ht_link_t *item)
+{
+	const udf_dcache_key_t *key = k;
+	udf_dcache_entry_t *entry =
+	    hash_table_get_inst(item, udf_dcache_entry_t, link);
+
+	return (key->dir == entry->dir) &&
+	    (str_casecmp(key->name, entry->name) == 0);
+}
+
+static void udf_dcache_entry_remove(ht_link_t *item)
+{
+	udf_dcache_entry_t *entry =
+	    hash_table_get_inst(item, udf_dcache_entry_t, link);
+
+	free(entry->name);
+	free(entry);
+}
+
+static const hash_table_ops_t udf_dcache_entry_ops = {
+	.hash = udf_dcache_entry_hash,
+	.key_hash = udf_dcache_entry_key_hash,
+	.key_equal = udf_dcache_entry_key_equal,
+	.equal = NULL,
+	.remove_callback = udf_dcache_entry_remove
+};
+
+static size_t udf_dcache_dir_hash(const ht_link_t *item)
+{
+	udf_dcache_dir_t *dir =
+	    hash_table_get_inst(item, udf_dcache_dir_t, link);
+	return hash_mix(dir->index);
+}
+
+static size_t udf_dcache_dir_key_hash(const void *k)
+{
+	const fs_index_t *index = k;
+	return hash_mix(*index);
+}
+
+static bool udf_dcache_dir_key_equal(const void *k, const ht_link_t *item)
+{
+	const fs_index_t *index = k;
+	udf_dcache_dir_t *dir =
+	    hash_table_get_inst(item, udf_dcache_dir_t, link);
+
+	return *index == dir->index;
+}
+
+static void udf_dcache_dir_remove(ht_link_t *item)
+{
+	free(hash_table_get_inst(item, udf_dcache_dir_t, link));
+}
+
+static const hash_table_ops_t udf_dcache_dir_ops = {
+	.hash = udf_dcache_dir_hash,
+	.key_hash = udf_dcache_dir_key_hash,
+	.key_equal = udf_dcache_dir_key_equal,
+	.equal = NULL,
+	.remove_callback = udf_dcache_dir_remove
+};
+
+/** Initialize directory cache of an instance
+ *
+ * @param instance UDF instance
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t udf_dcache_init(udf_instance_t *instance)
+{
+	fibril_mutex_initialize(&instance->dcache_lock);
+
+	if (!hash_table_create(&instance->dcache_dirs, 0, 0,
+	    &udf_dcache_dir_ops))
+		return ENOMEM;
+
+	if (!hash_table_create(&instance->dcache_entries, 0, 0,
+	    &udf_dcache_entry_ops)) {
+		hash_table_destroy(&instance->dcache_dirs);
+		return ENOMEM;
+	}
+
+	return EOK;
+}
+
+/** Drop all cached directories of an instance
+ *
+ * @param instance UDF instance
+ *
+ */
+void udf_dcache_fini(udf_instance_t *instance)
+{
+	hash_table_destroy(&instance->dcache_entries);
+	hash_table_destroy(&instance->dcache_dirs);
+}
+
+/** Enter one directory entry into the cache
+ *
+ * The first entry of a given name wins, which matches the order in which
+ * a linear scan of the directory would find it.
+ *
+ * @param instance UDF instance
+ * @param dir      Index of the directory
+ * @param name     Decoded name of the entry
+ * @param index    Index of the entry's ICB
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+static errno_t udf_dcache_insert(udf_instance_t *instance, fs_index_t dir,
+    const char *name, fs_index_t index)
+{
+	udf_dcache_key_t key = {
+		.dir = dir,
+		.name = name
+	};
+
+	if (hash_table_find(&instance->dcache_entries, &key) != NULL)
+		return EOK;
+
+	udf_dcache_entry_t *entry = malloc(sizeof(udf_dcache_entry_t));
+	if (entry == NULL)
+		return ENOMEM;
+
+	entry->name = str_dup(name);
+	if (entry->name == NULL) {
+		free(entry);
+		return ENOMEM;
+	}
+
+	entry->dir = dir;
+	entry->index = index;
+	hash_table_insert(&instance->dcache_entries, &entry->link);
+	return EOK;
+}
+
+/** Decode all FIDs of a directory into the cache
+ *
+ * @param node Directory node
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+static errno_t udf_dcache_parse(udf_node_t *node)
+{
+	udf_instance_t *instance = node->instance;
+
+	udf_dcache_dir_t *dir = malloc(sizeof(udf_dcache_dir_t));
+	if (dir == NULL)
+		return ENOMEM;
+
+	char *name = malloc(MAX_FILE_NAME_LEN + 1);
+	if (name == NULL) {
+		free(dir);
+		return ENOMEM;
+	}
+
+	block_t *block = NULL;
+	udf_file_identifier_descriptor_t *fid = NULL;
+	size_t pos = 0;
+	errno_t rc;
+
+	while (udf_get_fid(&fid, &block, node, pos) == EOK) {
+		udf_long_ad_t long_ad = fid->icb;
+
+		udf_to_unix_name(name, MAX_FILE_NAME_LEN,
+		    (char *) fid->implementation_use + FLE16(fid->length_iu),
+		    fid->length_file_id, &instance->charset);
+
+		if (block != NULL) {
+			rc = block_put(block);
+			if (rc != EOK)
+				goto error;
+		}
+
+		rc = udf_dcache_insert(instance, node->index, name,
+		    udf_long_ad_to_pos(instance, &long_ad));
+		if (rc != EOK)
+			goto error;
+
+		pos++;
+	}
+
+	dir->index = node->index;
+	hash_table_insert(&instance->dcache_dirs, &dir->link);
+	free(name);
+	return EOK;
+
+error:
+	/*
+	 * Entries entered so far stay in the cache. The directory is not
+	 * marked as parsed, so the next lookup scans it again.
+	 */
+	free(name);
+	free(dir);
+	return rc;
+}
+
+/** Look up a name in a directory
+ *
+ * @param node      Directory node
+ * @param component Name to look up
+ * @param index     Returned value - index of the entry's ICB
+ *
+ * @return EOK on success, ENOENT if the directory has no entry
+ *         of that name or another error code.
+ *
+ */
+errno_t udf_dcache_lookup(udf_node_t *node, const char *component,
+    fs_index_t *index)
+{
+	udf_instance_t *instance = node->instance;
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&instance->dcache_lock);
+
+	if (hash_table_find(&instance->dcache_dirs, &node->index) == NULL) {
+		rc = udf_dcache_parse(node);
+		if (rc != EOK)
+			goto out;
+	}
+
+	udf_dcache_key_t key = {
+		.dir = node->index,
+		.name = component
+	};
+
+	ht_link_t *link = hash_table_find(&instance->dcache_entries, &key);
+	if (link == NULL) {
+		rc = ENOENT;
+		goto out;
+	}
+
+	*index = hash_table_get_inst(link, udf_dcache_entry_t, link)->index;
+
+out:
+	fibril_mutex_unlock(&instance->dcache_lock);
+	return rc;
+}
+
+/**
+ * @}
+ */
@@ -34,9 +34,12 @@
  * @brief Implementation of file operations. Reading and writing functions.
  */
 
+#include <assert.h>
 #include <block.h>
 #include <libfs.h>
 #include <errno.h>
+#include <fibril_synch.h>
+#include <macros.h>
 #include <stdlib.h>
 #include <inttypes.h>
 #include <io/log.h>
@@ -46,6 +49,13 @@
 #include "udf_cksum.h"
 #include "udf_volume.h"
 
+/*
+ * Size of the read-ahead window used for file data. Optical drives pay
+ * dearly for every separate request, so sequential reads are served from
+ * large extent-sized chunks instead of one sector at a time.
+ */
+#define UDF_RA_SIZE  (128 * 1024)
+
 /** Read extended allocator in allocation sequence
  *
  * @paran node     UDF node
@@ -564,6 +574,89 @@ errno_t udf_get_fid_in_sector(udf_file_identifier_descriptor_t **fid,
 	return ENOENT;
 }
 
+/** Read sectors directly from the device, bypassing the block cache.
+ *
+ * @param instance UDF instance
+ * @param sector   First sector to read
+ * @param cnt      Number of sectors to read
+ * @param buf      Buffer large enough for @a cnt sectors
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+static errno_t udf_read_sectors(udf_instance_t *instance, uint32_t sector,
+    size_t cnt, void *buf)
+{
+	size_t bsize;
+	errno_t rc = block_get_bsize(instance->service_id, &bsize);
+	if (rc != EOK)
+		return rc;
+
+	if (bsize <= instance->sector_size &&
+	    (instance->sector_size % bsize) == 0) {
+		size_t n = instance->sector_size / bsize;
+		return block_read_direct(instance->service_id,
+		    (aoff64_t) sector * n, cnt * n, buf);
+	}
+
+	return block_read_bytes_direct(instance->service_id,
+	    (aoff64_t) sector * instance->sector_size,
+	    cnt * instance->sector_size, buf);
+}
+
+/** Get a sector of an extent through the read-ahead buffer.
+ *
+ * If the sector is not in the buffer, it is read together with the sectors
+ * following it up to the size of the buffer or the end of the extent.
+ * Must be called with the read-ahead lock of the instance held.
+ *
+ * The volume is mounted read-only, so the data cannot go stale with
+ * respect to the block cache.
+ *
+ * @param instance UDF instance
+ * @param sector   Sector to get
+ * @param end      Sector following the last sector of the extent
+ * @param data     Returned value - pointer to the data of the sector
+ * @param avail    Returned value - number of consecutive sectors of the
+ *                 extent available in the buffer starting at @a sector
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+static errno_t udf_ra_get(udf_instance_t *instance, uint32_t sector,
+    uint32_t end, uint8_t **data, size_t *avail)
+{
+	assert(fibril_mutex_is_locked(&instance->ra_lock));
+	assert(sector < end);
+
+	size_t ra_sectors = max(UDF_RA_SIZE / instance->sector_size, 1);
+
+	if (instance->ra_buf == NULL) {
+		instance->ra_buf = malloc(ra_sectors * instance->sector_size);
+		if (instance->ra_buf == NULL)
+			return ENOMEM;
+	}
+
+	if (instance->ra_count == 0 || sector < instance->ra_start ||
+	    sector >= instance->ra_start + instance->ra_count) {
+		size_t cnt = min(end - sector, ra_sectors);
+
+		instance->ra_count = 0;
+		errno_t rc = udf_read_sectors(instance, sector, cnt,
+		    instance->ra_buf);
+		if (rc != EOK)
+			return rc;
+
+		instance->ra_start = sector;
+		instance->ra_count = cnt;
+	}
+
+	*data = instance->ra_buf +
+	    (sector - instance->ra_start) * instance->sector_size;
+	*avail = min(instance->ra_start + instance->ra_count, end) - sector;
+	return EOK;
+}
+
 /** Read file if it is saved in allocators.
  *
  * @param read_len Returned value. Length file or part file which we could read.
@@ -578,8 +671,9 @@ errno_t udf_get_fid_in_sector(udf_file_identifier_descriptor_t **fid,
 errno_t udf_read_file(size_t *read_len, ipc_call_t *call, udf_node_t *node,
     aoff64_t pos, size_t len)
 {
+	udf_instance_t *instance = node->instance;
 	size_t i = 0;
-	size_t l = 0;
+	aoff64_t l = 0;
 
 	while (i < node->alloc_size) {
 		if (pos >= l + node->allocators[i].length) {
@@ -589,37 +683,35 @@ errno_t udf_read_file(size_t *read_len, ipc_call_t *call, udf_node_t *node,
 			break;
 	}
 
-	size_t sector_cnt = ALL_UP(l, node->instance->sector_size);
-	size_t sector_num = pos / node->instance->sector_size;
+	if (i == node->alloc_size) {
+		async_answer_0(call, EIO);
+		return EIO;
+	}
 
-	block_t *block = NULL;
-	errno_t rc = block_get(&block, node->instance->service_id,
-	    node->allocators[i].position + (sector_num - sector_cnt),
-	    BLOCK_FLAGS_NONE);
+	udf_allocator_t *ext = &node->allocators[i];
+	size_t ext_pos = pos - l;
+	size_t sector_pos = ext_pos % instance->sector_size;
+	uint32_t sector = ext->position + ext_pos / instance->sector_size;
+	uint32_t end = ext->position +
+	    ALL_UP(ext->length, instance->sector_size);
+
+	fibril_mutex_lock(&instance->ra_lock);
+
+	uint8_t *data;
+	size_t avail;
+	errno_t rc = udf_ra_get(instance, sector, end, &data, &avail);
 	if (rc != EOK) {
+		fibril_mutex_unlock(&instance->ra_lock);
 		async_answer_0(call, rc);
 		return rc;
 	}
 
-	size_t sector_pos = pos % node->instance->sector_size;
-
-	if (sector_pos + len < node->instance->sector_size)
-		*read_len = len;
-	else
-		*read_len = node->instance->sector_size - sector_pos;
-
-	if (ALL_UP(node->allocators[i].length, node->instance->sector_size) ==
-	    sector_num - sector_cnt + 1) {
-		if (pos + len > node->allocators[i].length + l)
-			*read_len = node->allocators[i].length -
-			    (sector_num - sector_cnt) * node->instance->sector_size -
-			    sector_pos;
-		else
-			*read_len = len;
-	}
+	*read_len = min(len, avail * instance->sector_size - sector_pos);
+	*read_len = min(*read_len, ext->length - ext_pos);
 
-	async_data_read_finalize(call, block->data + sector_pos, *read_len);
-	return block_put(block);
+	rc = async_data_read_finalize(call, data + sector_pos, *read_len);
+	fibril_mutex_unlock(&instance->ra_lock);
+	return rc;
 }
 
 /**
@@ -58,6 +58,7 @@
 #include "udf_cksum.h"
 #include "udf_volume.h"
 #include "udf_idx.h"
+#include "udf_dcache.h"
 #include "udf_file.h"
 #include "udf_osta.h"
 
@@ -108,43 +109,12 @@ static service_id_t udf_service_get(fs_node_t *node)
 
 static errno_t udf_match(fs_node_t **rfn, fs_node_t *pfn, const char *component)
 {
-	char *name = malloc(MAX_FILE_NAME_LEN + 1);
-	if (name == NULL)
-		return ENOMEM;
-
-	block_t *block = NULL;
-	udf_file_identifier_descriptor_t *fid = NULL;
-	size_t pos = 0;
-
-	while (udf_get_fid(&fid, &block, UDF_NODE(pfn), pos) == EOK) {
-		udf_long_ad_t long_ad = fid->icb;
-
-		udf_to_unix_name(name, MAX_FILE_NAME_LEN,
-		    (char *) fid->implementation_use + FLE16(fid->length_iu),
-		    fid->length_file_id, &UDF_NODE(pfn)->instance->charset);
-
-		if (str_casecmp(name, component) == 0) {
-			errno_t rc = udf_node_get(rfn, udf_service_get(pfn),
-			    udf_long_ad_to_pos(UDF_NODE(pfn)->instance, &long_ad));
-
-			if (block != NULL)
-				block_put(block);
-
-			free(name);
-			return rc;
-		}
-
-		if (block != NULL) {
-			errno_t rc = block_put(block);
-			if (rc != EOK)
-				return rc;
-		}
-
-		pos++;
-	}
+	fs_index_t index;
+	errno_t rc = udf_dcache_lookup(UDF_NODE(pfn), component, &index);
+	if (rc != EOK)
+		return rc;
 
-	free(name);
-	return ENOENT;
+	return udf_node_get(rfn, udf_service_get(pfn), index);
 }
 
 static errno_t udf_node_open(fs_node_t *fn)
@@ -312,6 +282,9 @@ static errno_t udf_mounted(service_id_t service_id, const char *opts,
 		return ENOMEM;
 
 	instance->sector_size = 0;
+	fibril_mutex_initialize(&instance->ra_lock);
+	instance->ra_buf = NULL;
+	instance->ra_count = 0;
 
 	/* Check for block size. Will be enhanced later */
 	if (str_cmp(opts, "bs=512") == 0)
@@ -391,10 +364,20 @@ static errno_t udf_mounted(service_id_t service_id, const char *opts,
 		return rc;
 	}
 
+	rc = udf_dcache_init(instance);
+	if (rc != EOK) {
+		fs_instance_destroy(service_id);
+		free(instance);
+		block_cache_fini(service_id);
+		block_fini(service_id);
+		return rc;
+	}
+
 	fs_node_t *rfn;
 	rc = udf_node_get(&rfn, service_id, instance->volumes[DEFAULT_VOL].root_dir);
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_NOTE, "Can't create root node");
+		udf_dcache_fini(instance);
 		fs_instance_destroy(service_id);
 		free(instance);
 		block_cache_fini(service_id);
@@ -435,7 +418,9 @@ static errno_t udf_unmounted(service_id_t service_id)
 	udf_node_put(fn);
 	udf_node_put(fn);
 
+	udf_dcache_fini(instance);
 	fs_instance_destroy(service_id);
+	free(instance->ra_buf);
 	free(instance);
 	block_cache_fini(service_id);
 	block_fini(service_id);
@@ -53,6 +53,7 @@
 #include <stdatomic.h>
 #include <stdlib.h>
 #include <str.h>
+#include <time.h>
 #include "console.h"
 
 #define NAME       "console"
@@ -60,6 +61,12 @@
 
 #define UTF8_CHAR_BUFFER_SIZE  (STR_BOUNDS(1) + 1)
 
+/** Number of characters decoded at a time when writing */
+#define WRITE_DECODE_CHUNK  64
+
+/** Minimum interval between output updates caused by writes (us) */
+#define CONS_FRAME_USEC  16667
+
 typedef struct {
 	atomic_flag refcnt;      /**< Connection reference count */
 	prodcons_t input_pc;  /**< Incoming console events */
@@ -86,6 +93,11 @@ typedef struct {
 	chargrid_t *frontbuf;    /**< Front buffer */
 	frontbuf_handle_t fbid;  /**< Front buffer handle */
 	con_srvs_t srvs;         /**< Console service setup */
+
+	/** Timer for updates coalescing writes or NULL */
+	fibril_timer_t *update_timer;
+	bool update_pending;         /**< Update timer is armed */
+	struct timespec last_update; /**< Time of the last output update */
 } console_t;
 
 /** Input server proxy */
@@ -199,10 +211,27 @@ static void cons_update(console_t *cons)
 		output_cursor_update(output_sess, cons->fbid);
 	}
 
+	getuptime(&cons->last_update);
+
 	fibril_mutex_unlock(&cons->mtx);
 	fibril_mutex_unlock(&switch_mtx);
 }
 
+/** Console update timer handler.
+ *
+ * @param arg Console
+ */
+static void cons_update_timer(void *arg)
+{
+	console_t *cons = (console_t *) arg;
+
+	fibril_mutex_lock(&cons->mtx);
+	cons->update_pending = false;
+	fibril_mutex_unlock(&cons->mtx);
+
+	cons_update(cons);
+}
+
 static void cons_update_cursor(console_t *cons)
 {
 	fibril_mutex_lock(&switch_mtx);
@@ -304,6 +333,7 @@ static void pointer_draw(void)
 
 	/* Make sure the cell gets updated */
 	ch->flags |= CHAR_FLAG_DIRTY;
+	chargrid_set_dirty_rows(active_console->frontbuf, row, row + 1);
 }
 
 /** Undraw mouse pointer. */
@@ -320,6 +350,7 @@ static void pointer_undraw(void)
 	ch = chargrid_charfield_at(active_console->frontbuf, col, row);
 	*ch = pointer_bg;
 	ch->flags |= CHAR_FLAG_DIRTY;
+	chargrid_set_dirty_rows(active_console->frontbuf, row, row + 1);
 }
 
 /** Queue console event.
@@ -467,35 +498,28 @@ static errno_t input_ev_dclick(input_t *input, unsigned pos_id, int bnum)
 	return EOK;
 }
 
-/** Process a character from the client (TTY emulation). */
+/** Process a character from the client (TTY emulation).
+ *
+ * @param cons Console, with @c mtx held
+ * @param ch Character
+ */
 static void cons_write_char(console_t *cons, char32_t ch)
 {
-	sysarg_t updated = 0;
-
-	fibril_mutex_lock(&cons->mtx);
-	pointer_undraw();
-
 	switch (ch) {
 	case '\n':
-		updated = chargrid_newline(cons->frontbuf);
+		chargrid_newline(cons->frontbuf);
 		break;
 	case '\r':
 		break;
 	case '\t':
-		updated = chargrid_tabstop(cons->frontbuf, 8);
+		chargrid_tabstop(cons->frontbuf, 8);
 		break;
 	case '\b':
-		updated = chargrid_backspace(cons->frontbuf);
+		chargrid_backspace(cons->frontbuf);
 		break;
 	default:
-		updated = chargrid_putuchar(cons->frontbuf, ch, true);
+		chargrid_putuchar(cons->frontbuf, ch, true);
 	}
-
-	pointer_draw();
-	fibril_mutex_unlock(&cons->mtx);
-
-	if (updated > 1)
-		cons_update(cons);
 }
 
 static void cons_set_cursor_vis(console_t *cons, bool visible)
@@ -568,10 +592,45 @@ static errno_t cons_read(con_srv_t *srv, void *buf, size_t size, size_t *nread)
 static errno_t cons_write(con_srv_t *srv, void *data, size_t size, size_t *nwritten)
 {
 	console_t *cons = srv_to_console(srv);
-
+	struct timespec now;
+	usec_t elapsed;
+	bool update = false;
+	char32_t buf[WRITE_DECODE_CHUNK];
 	size_t off = 0;
-	while (off < size)
-		cons_write_char(cons, str_decode(data, &off, size));
+	size_t n, i;
+
+	fibril_mutex_lock(&cons->mtx);
+	pointer_undraw();
+
+	while (off < size) {
+		n = str_decode_buf(data, &off, size, buf, WRITE_DECODE_CHUNK);
+		for (i = 0; i < n; i++)
+			cons_write_char(cons, buf[i]);
+	}
+
+	pointer_draw();
+
+	/*
+	 * Output arriving within one frame of the previous update is
+	 * coalesced and sent to the output server by the update timer.
+	 */
+	if (!cons->update_pending) {
+		getuptime(&now);
+		elapsed = NSEC2USEC(ts_sub_diff(&now, &cons->last_update));
+		if (elapsed >= CONS_FRAME_USEC || cons->update_timer == NULL) {
+			update = true;
+		} else {
+			cons->update_pending = true;
+			fibril_timer_set_locked(cons->update_timer,
+			    CONS_FRAME_USEC - elapsed, cons_update_timer,
+			    cons);
+		}
+	}
+
+	fibril_mutex_unlock(&cons->mtx);
+
+	if (update)
+		cons_update(cons);
 
 	*nwritten = size;
 	return EOK;
@@ -810,6 +869,7 @@ static void cons_buf_update(con_srv_t *srv, sysarg_t c0, sysarg_t r0,
 		}
 	}
 
+	chargrid_set_dirty_rows(cons->frontbuf, r0, r1);
 	pointer_draw();
 	fibril_mutex_unlock(&cons->mtx);
 
@@ -944,6 +1004,11 @@ static bool console_srv_init(char *input_svc, char *output_svc)
 				return false;
 			}
 
+			/* Without the timer, each write updates the output. */
+			consoles[i].update_timer =
+			    fibril_timer_create(&consoles[i].mtx);
+			consoles[i].update_pending = false;
+
 			con_srvs_init(&consoles[i].srvs);
 			consoles[i].srvs.ops = &con_ops;
 			consoles[i].srvs.sarg = &consoles[i];
@@ -39,6 +39,7 @@
 #include <assert.h>
 #include <gfx/color.h>
 #include <gfx/context.h>
+#include <gfx/coord.h>
 #include <gfx/render.h>
 #include <stdlib.h>
 #include "clonegc.h"
@@ -46,6 +47,7 @@
 static errno_t ds_clonegc_set_clip_rect(void *, gfx_rect_t *);
 static errno_t ds_clonegc_set_color(void *, gfx_color_t *);
 static errno_t ds_clonegc_fill_rect(void *, gfx_rect_t *);
+static errno_t ds_clonegc_update(void *);
 static errno_t ds_clonegc_bitmap_create(void *, gfx_bitmap_params_t *,
     gfx_bitmap_alloc_t *, void **);
 static errno_t ds_clonegc_bitmap_destroy(void *);
@@ -68,6 +70,7 @@ gfx_context_ops_t ds_clonegc_ops = {
 	.set_clip_rect = ds_clonegc_set_clip_rect,
 	.set_color = ds_clonegc_set_color,
 	.fill_rect = ds_clonegc_fill_rect,
+	.update = ds_clonegc_update,
 	.bitmap_create = ds_clonegc_bitmap_create,
 	.bitmap_destroy = ds_clonegc_bitmap_destroy,
 	.bitmap_render = ds_clonegc_bitmap_render,
@@ -137,8 +140,14 @@ static errno_t ds_clonegc_fill_rect(void *arg, gfx_rect_t *rect)
 {
 	ds_clonegc_t *cgc = (ds_clonegc_t *)arg;
 	ds_clonegc_output_t *output;
+	gfx_coord2_t dims;
 	errno_t rc;
 
+	gfx_rect_dims(rect, &dims);
+	++cgc->stats.fill_ops;
+	if (dims.x > 0 && dims.y > 0)
+		cgc->stats.fill_pixels += (uint64_t) dims.x * dims.y;
+
 	output = ds_clonegc_first_output(cgc);
 	while (output != NULL) {
 		rc = gfx_fill_rect(output->gc, rect);
@@ -151,6 +160,34 @@ static errno_t ds_clonegc_fill_rect(void *arg, gfx_rect_t *rect)
 	return EOK;
 }
 
+/** Update clone GC.
+ *
+ * Update all output GCs.
+ *
+ * @param arg Clone GC
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t ds_clonegc_update(void *arg)
+{
+	ds_clonegc_t *cgc = (ds_clonegc_t *)arg;
+	ds_clonegc_output_t *output;
+	errno_t rc;
+
+	++cgc->stats.updates;
+
+	output = ds_clonegc_first_output(cgc);
+	while (output != NULL) {
+		rc = gfx_update(output->gc);
+		if (rc != EOK)
+			return rc;
+
+		output = ds_clonegc_next_output(output);
+	}
+
+	return EOK;
+}
+
 /** Create cloning GC.
  *
  * Create graphics context for copying rendering into several GCs.
@@ -260,6 +297,16 @@ gfx_context_t *ds_clonegc_get_ctx(ds_clonegc_t *cgc)
 	return cgc->gc;
 }
 
+/** Get clone GC operation counters.
+ *
+ * @param cgc Clone GC
+ * @param stats Place to store operation counters
+ */
+void ds_clonegc_get_stats(ds_clonegc_t *cgc, ds_clonegc_stats_t *stats)
+{
+	*stats = cgc->stats;
+}
+
 /** Create bitmap in clone GC.
  *
  * @param arg Clone GC
@@ -362,8 +409,20 @@ static errno_t ds_clonegc_bitmap_render(void *bm, gfx_rect_t *srect0,
 {
 	ds_clonegc_bitmap_t *cbm = (ds_clonegc_bitmap_t *)bm;
 	ds_clonegc_outbitmap_t *outbm;
+	gfx_rect_t srect;
+	gfx_coord2_t dims;
 	errno_t rc;
 
+	if (srect0 != NULL)
+		gfx_rect_clip(srect0, &cbm->params.rect, &srect);
+	else
+		srect = cbm->params.rect;
+
+	gfx_rect_dims(&srect, &dims);
+	++cbm->clonegc->stats.render_ops;
+	if (dims.x > 0 && dims.y > 0)
+		cbm->clonegc->stats.render_pixels += (uint64_t) dims.x * dims.y;
+
 	outbm = ds_clonegc_bitmap_first_obm(cbm);
 	while (outbm != NULL) {
 		rc = gfx_bitmap_render(outbm->obitmap, srect0, offs0);
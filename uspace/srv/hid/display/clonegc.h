@@ -46,6 +46,7 @@ extern errno_t ds_clonegc_create(gfx_context_t *, ds_clonegc_t **);
 extern errno_t ds_clonegc_delete(ds_clonegc_t *);
 extern errno_t ds_clonegc_add_output(ds_clonegc_t *, gfx_context_t *);
 extern gfx_context_t *ds_clonegc_get_ctx(ds_clonegc_t *);
+extern void ds_clonegc_get_stats(ds_clonegc_t *, ds_clonegc_stats_t *);
 
 #endif
 
@@ -36,6 +36,7 @@
 #include <errno.h>
 #include <gfx/bitmap.h>
 #include <gfx/context.h>
+#include <gfx/region.h>
 #include <gfx/render.h>
 #include <io/log.h>
 #include <memgfx/memgc.h>
@@ -691,10 +692,7 @@ static errno_t ds_display_alloc_backbuf(ds_display_t *disp)
 	if (rc != EOK)
 		goto error;
 
-	disp->dirty_rect.p0.x = 0;
-	disp->dirty_rect.p0.y = 0;
-	disp->dirty_rect.p1.x = 0;
-	disp->dirty_rect.p1.y = 0;
+	gfx_region_init(&disp->dirty);
 
 	return EOK;
 error:
@@ -706,6 +704,23 @@ error:
 	return rc;
 }
 
+/** Determine if display device can be rendered to directly.
+ *
+ * A device which fills and copies by itself and only shows the result
+ * on update does not need a back buffer to avoid flicker. Rendering
+ * to it directly saves the copy from the back buffer and lets
+ * the device do the work.
+ *
+ * @param ddev Display device
+ * @return @c true iff device can be rendered to directly
+ */
+static bool ds_display_ddev_direct(ds_ddev_t *ddev)
+{
+	ddev_caps_t caps = ddev_cap_fill | ddev_cap_copy | ddev_cap_buffered;
+
+	return (ddev->info.caps & caps) == caps;
+}
+
 /** Add display device to display.
  *
  * @param disp Display
@@ -735,18 +750,33 @@ errno_t ds_display_add_ddev(ds_display_t *disp, ds_ddev_t *ddev)
 		if (rc != EOK)
 			goto error;
 
-		/* Allocate backbuffer */
-		rc = ds_display_alloc_backbuf(disp);
-		if (rc != EOK) {
-			ds_clonegc_delete(disp->fbgc);
-			disp->fbgc = NULL;
-			goto error;
+		/* Allocate backbuffer unless rendering to device directly */
+		if (!ds_display_ddev_direct(ddev)) {
+			rc = ds_display_alloc_backbuf(disp);
+			if (rc != EOK) {
+				ds_clonegc_delete(disp->fbgc);
+				disp->fbgc = NULL;
+				goto error;
+			}
 		}
 	} else {
 		/* Add new output device to cloning GC */
 		rc = ds_clonegc_add_output(disp->fbgc, ddev->gc);
 		if (rc != EOK)
 			goto error;
+
+		/*
+		 * If we were rendering directly, but the new device
+		 * cannot do that, switch to using a back buffer.
+		 */
+		if ((disp->flags & df_disp_double_buf) != 0 &&
+		    disp->bbgc == NULL && !ds_display_ddev_direct(ddev)) {
+			rc = ds_display_alloc_backbuf(disp);
+			if (rc != EOK)
+				goto error;
+
+			(void) ds_display_paint(disp, NULL);
+		}
 	}
 
 	ds_display_update_max_rect(disp);
@@ -969,7 +999,7 @@ static gfx_context_t *ds_display_get_unbuf_gc(ds_display_t *display)
  */
 gfx_context_t *ds_display_get_gc(ds_display_t *display)
 {
-	if ((display->flags & df_disp_double_buf) != 0)
+	if (display->bbgc != NULL)
 		return mem_gc_get_ctx(display->bbgc);
 	else
 		return ds_display_get_unbuf_gc(display);
@@ -1004,7 +1034,10 @@ errno_t ds_display_paint_bg(ds_display_t *disp, gfx_rect_t *rect)
 
 /** Update front buffer from back buffer.
  *
- * If the display is not double-buffered, no action is taken.
+ * Only the dirty region of the back buffer is copied to the front
+ * buffer, one rectangle at a time. If the display devices are rendered
+ * to directly, they are updated instead. If the display is not
+ * double-buffered, no action is taken.
  *
  * @param disp Display
  * @return EOK on success, or an error code
@@ -1012,42 +1045,89 @@ errno_t ds_display_paint_bg(ds_display_t *disp, gfx_rect_t *rect)
 static errno_t ds_display_update(ds_display_t *disp)
 {
 	errno_t rc;
+	size_t i;
 
 	if (disp->backbuf == NULL) {
+		/*
+		 * Display devices buffer by themselves, let them
+		 * show the result.
+		 */
+		if ((disp->flags & df_disp_double_buf) != 0 &&
+		    disp->fbgc != NULL)
+			return gfx_update(ds_display_get_unbuf_gc(disp));
+
 		/* Not double-buffered, nothing to do. */
 		return EOK;
 	}
 
-	rc = gfx_bitmap_render(disp->backbuf, &disp->dirty_rect, NULL);
-	if (rc != EOK)
-		return rc;
-
-	disp->dirty_rect.p0.x = 0;
-	disp->dirty_rect.p0.y = 0;
-	disp->dirty_rect.p1.x = 0;
-	disp->dirty_rect.p1.y = 0;
+	for (i = 0; i < disp->dirty.count; i++) {
+		rc = gfx_bitmap_render(disp->backbuf, &disp->dirty.rects[i],
+		    NULL);
+		if (rc != EOK)
+			return rc;
+	}
 
+	gfx_region_init(&disp->dirty);
 	return EOK;
 }
 
-/** Paint display.
+/** Find the bottom-most window that needs to be painted.
  *
- * @param display Display
- * @param rect Bounding rectangle or @c NULL to repaint entire display
+ * Windows are opaque, so anything below the top-most visible window
+ * which covers the entire rectangle is hidden and need not be painted.
+ *
+ * @param disp Display
+ * @param rect Display rectangle to paint
+ * @param rcovered Place to store @c true iff the returned window covers
+ *                 @a rect (i.e. the background need not be painted)
+ * @return Bottom-most window to paint or @c NULL if there is none
  */
-errno_t ds_display_paint(ds_display_t *disp, gfx_rect_t *rect)
+static ds_window_t *ds_display_paint_bottom(ds_display_t *disp,
+    gfx_rect_t *rect, bool *rcovered)
+{
+	ds_window_t *wnd;
+	gfx_rect_t drect;
+
+	wnd = ds_display_first_window(disp);
+	while (wnd != NULL) {
+		if (ds_window_is_visible(wnd) && wnd->bitmap != NULL) {
+			gfx_rect_translate(&wnd->dpos, &wnd->rect, &drect);
+			if (gfx_rect_is_inside(rect, &drect)) {
+				*rcovered = true;
+				return wnd;
+			}
+		}
+
+		wnd = ds_display_next_window(wnd);
+	}
+
+	*rcovered = false;
+	return ds_display_last_window(disp);
+}
+
+/** Paint display rectangle to the display GC.
+ *
+ * @param disp Display
+ * @param rect Display rectangle (clipped to display)
+ * @return EOK on success or an error code
+ */
+static errno_t ds_display_paint_rect(ds_display_t *disp, gfx_rect_t *rect)
 {
 	errno_t rc;
 	ds_window_t *wnd;
 	ds_seat_t *seat;
+	bool covered;
+
+	wnd = ds_display_paint_bottom(disp, rect, &covered);
 
 	/* Paint background */
-	rc = ds_display_paint_bg(disp, rect);
-	if (rc != EOK)
-		return rc;
+	if (!covered) {
+		rc = ds_display_paint_bg(disp, rect);
+		if (rc != EOK)
+			return rc;
+	}
 
 	/* Paint windows bottom to top */
-	wnd = ds_display_last_window(disp);
 	while (wnd != NULL) {
 		rc = ds_window_paint(wnd, rect);
 		if (rc != EOK)
@@ -1076,13 +1156,54 @@ errno_t ds_display_paint(ds_display_t *disp, gfx_rect_t *rect)
 		seat = ds_display_next_seat(seat);
 	}
 
+	return EOK;
+}
+
+/** Paint display.
+ *
+ * @param display Display
+ * @param rect Bounding rectangle or @c NULL to repaint entire display
+ */
+errno_t ds_display_paint(ds_display_t *disp, gfx_rect_t *rect)
+{
+	gfx_region_t region;
+
+	gfx_region_init(&region);
+	gfx_region_add_rect(&region, rect != NULL ? rect : &disp->rect);
+	return ds_display_paint_region(disp, &region);
+}
+
+/** Paint display region.
+ *
+ * Each rectangle of the region is painted separately and then only
+ * the damaged areas are flushed to the output devices.
+ *
+ * @param display Display
+ * @param region Region to repaint
+ */
+errno_t ds_display_paint_region(ds_display_t *disp, gfx_region_t *region)
+{
+	gfx_rect_t crect;
+	errno_t rc;
+	size_t i;
+
+	for (i = 0; i < region->count; i++) {
+		gfx_rect_clip(&region->rects[i], &disp->rect, &crect);
+		if (gfx_rect_is_empty(&crect))
+			continue;
+
+		rc = ds_display_paint_rect(disp, &crect);
+		if (rc != EOK)
+			return rc;
+	}
+
 	return ds_display_update(disp);
 }
 
 /** Display invalidate callback.
  *
  * Called by backbuffer memory GC when something is rendered into it.
- * Updates the display's dirty rectangle.
+ * Adds the rectangle to the display's dirty region.
  *
  * @param arg Argument (display cast as void *)
  * @param rect Rectangle to update
@@ -1090,10 +1211,8 @@ errno_t ds_display_paint(ds_display_t *disp, gfx_rect_t *rect)
 static void ds_display_invalidate_cb(void *arg, gfx_rect_t *rect)
 {
 	ds_display_t *disp = (ds_display_t *) arg;
-	gfx_rect_t env;
 
-	gfx_rect_envelope(&disp->dirty_rect, rect, &env);
-	disp->dirty_rect = env;
+	gfx_region_add_rect(&disp->dirty, rect);
 }
 
 /** Display update callback.
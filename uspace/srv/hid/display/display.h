@@ -102,6 +102,7 @@ extern void ds_display_crop_max_rect(gfx_rect_t *, gfx_rect_t *);
 extern gfx_context_t *ds_display_get_gc(ds_display_t *);
 extern errno_t ds_display_paint_bg(ds_display_t *, gfx_rect_t *);
 extern errno_t ds_display_paint(ds_display_t *, gfx_rect_t *);
+extern errno_t ds_display_paint_region(ds_display_t *, gfx_region_t *);
 
 #endif
 
@@ -36,6 +36,7 @@
 #include <adt/list.h>
 #include <errno.h>
 #include <gfx/color.h>
+#include <gfx/region.h>
 #include <gfx/render.h>
 #include <stdlib.h>
 #include <str.h>
@@ -361,32 +362,57 @@ void ds_seat_get_pointer_rect(ds_seat_t *seat, gfx_rect_t *rect)
 static errno_t ds_seat_repaint_pointer(ds_seat_t *seat, gfx_rect_t *old_rect)
 {
 	gfx_rect_t new_rect;
-	gfx_rect_t envelope;
-	errno_t rc;
+	gfx_region_t region;
 
 	ds_seat_get_pointer_rect(seat, &new_rect);
 
-	if (gfx_rect_is_incident(old_rect, &new_rect)) {
-		/* Rectangles do not intersect. Repaint them separately. */
-		rc = ds_display_paint(seat->display, &new_rect);
-		if (rc != EOK)
-			return rc;
+	/*
+	 * The region merges the rectangles if they are close, otherwise
+	 * they are repainted separately.
+	 */
+	gfx_region_init(&region);
+	gfx_region_add_rect(&region, old_rect);
+	gfx_region_add_rect(&region, &new_rect);
 
-		rc = ds_display_paint(seat->display, old_rect);
-		if (rc != EOK)
-			return rc;
-	} else {
-		/*
-		 * Rectangles intersect. As an optimization, repaint them
-		 * in a single operation.
-		 */
-		gfx_rect_envelope(old_rect, &new_rect, &envelope);
+	return ds_display_paint_region(seat->display, &region);
+}
 
-		rc = ds_display_paint(seat->display, &envelope);
-		if (rc != EOK)
-			return rc;
-	}
+/** Move seat pointer.
+ *
+ * Generate position event and repaint the pointer at its new position.
+ * Nothing is done if the pointer stays where it is, such as when it is
+ * pushed against the edge of the display.
+ *
+ * @param seat Seat
+ * @param pos_id Positioning device ID
+ * @param npos New pointer position
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t ds_seat_move_pointer(ds_seat_t *seat, unsigned pos_id,
+    gfx_coord2_t *npos)
+{
+	gfx_rect_t old_rect;
+	pos_event_t pevent;
+	errno_t rc;
+
+	if (npos->x == seat->pntpos.x && npos->y == seat->pntpos.y)
+		return EOK;
+
+	ds_seat_get_pointer_rect(seat, &old_rect);
+	seat->pntpos = *npos;
+
+	pevent.pos_id = pos_id;
+	pevent.type = POS_UPDATE;
+	pevent.btn_num = 0;
+	pevent.hpos = seat->pntpos.x;
+	pevent.vpos = seat->pntpos.y;
 
+	rc = ds_seat_post_pos_event(seat, &pevent);
+	if (rc != EOK)
+		return rc;
+
+	ds_seat_repaint_pointer(seat, &old_rect);
 	return EOK;
 }
 
@@ -403,7 +429,6 @@ errno_t ds_seat_post_ptd_event(ds_seat_t *seat, ptd_event_t *event)
 {
 	ds_display_t *disp = seat->display;
 	gfx_coord2_t npos;
-	gfx_rect_t old_rect;
 	ds_window_t *wnd;
 	pos_event_t pevent;
 	errno_t rc;
@@ -447,20 +472,9 @@ errno_t ds_seat_post_ptd_event(ds_seat_t *seat, ptd_event_t *event)
 		gfx_coord2_add(&seat->pntpos, &event->dmove, &npos);
 		gfx_coord2_clip(&npos, &disp->rect, &npos);
 
-		ds_seat_get_pointer_rect(seat, &old_rect);
-		seat->pntpos = npos;
-
-		pevent.pos_id = event->pos_id;
-		pevent.type = POS_UPDATE;
-		pevent.btn_num = 0;
-		pevent.hpos = seat->pntpos.x;
-		pevent.vpos = seat->pntpos.y;
-
-		rc = ds_seat_post_pos_event(seat, &pevent);
+		rc = ds_seat_move_pointer(seat, event->pos_id, &npos);
 		if (rc != EOK)
 			return rc;
-
-		ds_seat_repaint_pointer(seat, &old_rect);
 	}
 
 	if (event->type == PTD_ABS_MOVE) {
@@ -475,20 +489,9 @@ errno_t ds_seat_post_ptd_event(ds_seat_t *seat, ptd_event_t *event)
 
 		gfx_coord2_clip(&npos, &disp->rect, &npos);
 
-		ds_seat_get_pointer_rect(seat, &old_rect);
-		seat->pntpos = npos;
-
-		pevent.pos_id = event->pos_id;
-		pevent.type = POS_UPDATE;
-		pevent.btn_num = 0;
-		pevent.hpos = seat->pntpos.x;
-		pevent.vpos = seat->pntpos.y;
-
-		rc = ds_seat_post_pos_event(seat, &pevent);
+		rc = ds_seat_move_pointer(seat, event->pos_id, &npos);
 		if (rc != EOK)
 			return rc;
-
-		ds_seat_repaint_pointer(seat, &old_rect);
 	}
 
 	return EOK;
@@ -41,6 +41,7 @@ PCUT_TEST_SUITE(clonegc);
 static errno_t testgc_set_clip_rect(void *, gfx_rect_t *);
 static errno_t testgc_set_color(void *, gfx_color_t *);
 static errno_t testgc_fill_rect(void *, gfx_rect_t *);
+static errno_t testgc_update(void *);
 static errno_t testgc_bitmap_create(void *, gfx_bitmap_params_t *,
     gfx_bitmap_alloc_t *, void **);
 static errno_t testgc_bitmap_destroy(void *);
@@ -51,6 +52,7 @@ static gfx_context_ops_t ops = {
 	.set_clip_rect = testgc_set_clip_rect,
 	.set_color = testgc_set_color,
 	.fill_rect = testgc_fill_rect,
+	.update = testgc_update,
 	.bitmap_create = testgc_bitmap_create,
 	.bitmap_destroy = testgc_bitmap_destroy,
 	.bitmap_render = testgc_bitmap_render,
@@ -70,6 +72,8 @@ typedef struct {
 	bool fill_rect_called;
 	gfx_rect_t *fill_rect_rect;
 
+	bool update_called;
+
 	bool bm_created;
 	bool bm_destroyed;
 	gfx_bitmap_params_t bm_params;
@@ -314,6 +318,118 @@ PCUT_TEST(fill_rect)
 	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
 }
 
+/** Update with two output GCs */
+PCUT_TEST(update)
+{
+	ds_clonegc_t *cgc;
+	gfx_context_t *gc;
+	test_gc_t tgc1;
+	gfx_context_t *gc1;
+	test_gc_t tgc2;
+	gfx_context_t *gc2;
+	errno_t rc;
+
+	/* Create clone GC */
+	rc = ds_clonegc_create(NULL, &cgc);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	gc = ds_clonegc_get_ctx(cgc);
+	PCUT_ASSERT_NOT_NULL(gc);
+
+	/* Add two output GCs */
+
+	rc = gfx_context_new(&ops, &tgc1, &gc1);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = ds_clonegc_add_output(cgc, gc1);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gfx_context_new(&ops, &tgc2, &gc2);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = ds_clonegc_add_output(cgc, gc2);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Update returning error */
+
+	tgc1.update_called = false;
+	tgc2.update_called = false;
+	tgc1.rc = EINVAL;
+	tgc2.rc = EINVAL;
+
+	rc = gfx_update(gc);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, rc);
+
+	PCUT_ASSERT_TRUE(tgc1.update_called);
+	PCUT_ASSERT_FALSE(tgc2.update_called);
+
+	/* Update returning success for all outputs */
+	tgc1.update_called = false;
+	tgc2.update_called = false;
+	tgc1.rc = EOK;
+	tgc2.rc = EOK;
+
+	rc = gfx_update(gc);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	PCUT_ASSERT_TRUE(tgc1.update_called);
+	PCUT_ASSERT_TRUE(tgc2.update_called);
+
+	rc = ds_clonegc_delete(cgc);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+}
+
+/** Operation counters are updated by fill and update */
+PCUT_TEST(get_stats)
+{
+	ds_clonegc_t *cgc;
+	gfx_context_t *gc;
+	test_gc_t tgc;
+	gfx_context_t *gc1;
+	ds_clonegc_stats_t stats;
+	gfx_rect_t rect;
+	errno_t rc;
+
+	rc = ds_clonegc_create(NULL, &cgc);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	gc = ds_clonegc_get_ctx(cgc);
+	PCUT_ASSERT_NOT_NULL(gc);
+
+	rc = gfx_context_new(&ops, &tgc, &gc1);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = ds_clonegc_add_output(cgc, gc1);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	ds_clonegc_get_stats(cgc, &stats);
+	PCUT_ASSERT_INT_EQUALS(0, stats.fill_ops);
+	PCUT_ASSERT_INT_EQUALS(0, stats.fill_pixels);
+	PCUT_ASSERT_INT_EQUALS(0, stats.updates);
+
+	rect.p0.x = 1;
+	rect.p0.y = 2;
+	rect.p1.x = 4;
+	rect.p1.y = 6;
+
+	tgc.rc = EOK;
+
+	rc = gfx_fill_rect(gc, &rect);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gfx_update(gc);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	ds_clonegc_get_stats(cgc, &stats);
+	PCUT_ASSERT_INT_EQUALS(1, stats.fill_ops);
+	PCUT_ASSERT_INT_EQUALS(12, stats.fill_pixels);
+	PCUT_ASSERT_INT_EQUALS(0, stats.render_ops);
+	PCUT_ASSERT_INT_EQUALS(1, stats.updates);
+
+	rc = ds_clonegc_delete(cgc);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+}
+
 /** Operations on regular bitmap with two output GCs, callee allocation */
 PCUT_TEST(bitmap_twogc_callee_alloc)
 {
@@ -732,6 +848,14 @@ static errno_t testgc_fill_rect(void *arg, gfx_rect_t *rect)
 	return tgc->rc;
 }
 
+static errno_t testgc_update(void *arg)
+{
+	test_gc_t *tgc = (test_gc_t *) arg;
+
+	tgc->update_called = true;
+	return tgc->rc;
+}
+
 static errno_t testgc_bitmap_create(void *arg, gfx_bitmap_params_t *params,
     gfx_bitmap_alloc_t *alloc, void **rbm)
 {
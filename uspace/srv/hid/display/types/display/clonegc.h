@@ -38,6 +38,25 @@
 
 #include <adt/list.h>
 #include <gfx/context.h>
+#include <stdint.h>
+
+/** Clone GC operation counters.
+ *
+ * Counts operations passed through to the output GCs. When the outputs
+ * are accelerated devices, this is the work done on the device side.
+ */
+typedef struct {
+	/** Number of rectangle fills */
+	uint64_t fill_ops;
+	/** Number of pixels filled */
+	uint64_t fill_pixels;
+	/** Number of bitmap renders */
+	uint64_t render_ops;
+	/** Number of pixels rendered */
+	uint64_t render_pixels;
+	/** Number of updates */
+	uint64_t updates;
+} ds_clonegc_stats_t;
 
 /** Cloning graphic context.
  *
@@ -54,6 +73,8 @@ typedef struct {
 	list_t outputs;
 	/** Bitmaps (of ds_clonegc_bitmap_t) */
 	list_t bitmaps;
+	/** Operation counters */
+	ds_clonegc_stats_t stats;
 } ds_clonegc_t;
 
 /** Clone GC output */
@@ -43,6 +43,7 @@
 #include <io/input.h>
 #include <memgfx/memgc.h>
 #include <types/display/cursor.h>
+#include <types/gfx/region.h>
 #include "cursor.h"
 #include "clonegc.h"
 #include "seat.h"
@@ -116,8 +117,8 @@ typedef struct ds_display {
 	/** Frontbuffer (clone) GC */
 	ds_clonegc_t *fbgc;
 
-	/** Backbuffer dirty rectangle */
-	gfx_rect_t dirty_rect;
+	/** Backbuffer dirty region */
+	gfx_region_t dirty;
 
 	/** Display flags */
 	ds_display_flags_t flags;
@@ -92,6 +92,11 @@ typedef struct ds_window {
 	gfx_bitmap_t *bitmap;
 	/** Pixel map for accessing the window bitmap */
 	pixelmap_t pixelmap;
+	/**
+	 * Bitmap in the display device over the surface presented by
+	 * the client or @c NULL. Painted instead of @c bitmap if set.
+	 */
+	gfx_bitmap_t *surface;
 	/** Current drawing color */
 	pixel_t color;
 	/** Cursor set by client */
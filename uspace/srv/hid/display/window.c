@@ -37,10 +37,12 @@
 #include <gfx/color.h>
 #include <gfx/coord.h>
 #include <gfx/context.h>
+#include <gfx/region.h>
 #include <gfx/render.h>
 #include <io/log.h>
 #include <io/pixelmap.h>
 #include <macros.h>
+#include <mem.h>
 #include <memgfx/memgc.h>
 #include <stdlib.h>
 #include <str.h>
@@ -53,11 +55,14 @@
 
 static void ds_window_invalidate_cb(void *, gfx_rect_t *);
 static void ds_window_update_cb(void *);
+static errno_t ds_window_present_cb(void *, gfx_bitmap_alloc_t *);
+static void ds_window_drop_surface(ds_window_t *);
 static void ds_window_get_preview_rect(ds_window_t *, gfx_rect_t *);
 
 static mem_gc_cb_t ds_window_mem_gc_cb = {
 	.invalidate = ds_window_invalidate_cb,
-	.update = ds_window_update_cb
+	.update = ds_window_update_cb,
+	.present = ds_window_present_cb
 };
 
 /** Create window.
@@ -198,6 +203,7 @@ void ds_window_destroy(ds_window_t *wnd)
 	if ((wnd->flags & wndf_avoid) != 0)
 		ds_display_update_max_rect(disp);
 
+	ds_window_drop_surface(wnd);
 	mem_gc_delete(wnd->mgc);
 
 	if (wnd->bitmap != NULL)
@@ -250,6 +256,7 @@ errno_t ds_window_paint(ds_window_t *wnd, gfx_rect_t *rect)
 	gfx_rect_t srect;
 	gfx_rect_t *brect;
 	gfx_rect_t crect;
+	gfx_bitmap_t *bitmap;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "ds_window_paint");
 
@@ -270,11 +277,14 @@ errno_t ds_window_paint(ds_window_t *wnd, gfx_rect_t *rect)
 		brect = NULL;
 	}
 
+	/* Composite directly from client surface if there is one */
+	bitmap = wnd->surface != NULL ? wnd->surface : wnd->bitmap;
+
 	/* This can happen in unit tests */
-	if (wnd->bitmap == NULL)
+	if (bitmap == NULL)
 		return EOK;
 
-	return gfx_bitmap_render(wnd->bitmap, brect, &wnd->dpos);
+	return gfx_bitmap_render(bitmap, brect, &wnd->dpos);
 }
 
 /** Get the preview rectangle for a window.
@@ -394,11 +404,8 @@ errno_t ds_window_paint_preview(ds_window_t *wnd, gfx_rect_t *rect)
  */
 static errno_t ds_window_repaint_preview(ds_window_t *wnd, gfx_rect_t *old_rect)
 {
-	errno_t rc;
 	gfx_rect_t prect;
-	gfx_rect_t envelope;
-	bool oldr;
-	bool newr;
+	gfx_region_t region;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "ds_window_repaint_preview");
 
@@ -408,36 +415,17 @@ static errno_t ds_window_repaint_preview(ds_window_t *wnd, gfx_rect_t *old_rect)
 	 */
 	ds_window_get_preview_rect(wnd, &prect);
 
-	oldr = (old_rect != NULL) && !gfx_rect_is_empty(old_rect);
-	newr = !gfx_rect_is_empty(&prect);
-
-	if (oldr && newr && gfx_rect_is_incident(old_rect, &prect)) {
-		/*
-		 * As an optimization, repaint both rectangles in a single
-		 * operation.
-		 */
-
-		gfx_rect_envelope(old_rect, &prect, &envelope);
-
-		rc = ds_display_paint(wnd->display, &envelope);
-		if (rc != EOK)
-			return rc;
-	} else {
-		/* Repaint each rectangle separately */
-		if (oldr) {
-			rc = ds_display_paint(wnd->display, old_rect);
-			if (rc != EOK)
-				return rc;
-		}
-
-		if (newr) {
-			rc = ds_display_paint(wnd->display, &prect);
-			if (rc != EOK)
-				return rc;
-		}
-	}
+	/*
+	 * Repaint both rectangles. The region merges them if they are
+	 * close, otherwise each is repainted separately. Empty rectangles
+	 * are ignored.
+	 */
+	gfx_region_init(&region);
+	if (old_rect != NULL)
+		gfx_region_add_rect(&region, old_rect);
+	gfx_region_add_rect(&region, &prect);
 
-	return EOK;
+	return ds_display_paint_region(wnd->display, &region);
 }
 
 /** Start moving a window by mouse drag.
@@ -869,6 +857,9 @@ errno_t ds_window_resize(ds_window_t *wnd, gfx_coord2_t *offs,
 
 		/* TODO: Transfer contents within overlap */
 
+		/* Client surface no longer matches the window */
+		ds_window_drop_surface(wnd);
+
 		if (wnd->bitmap != NULL)
 			gfx_bitmap_destroy(wnd->bitmap);
 
@@ -1184,6 +1175,85 @@ static void ds_window_invalidate_cb(void *arg, gfx_rect_t *rect)
 	ds_display_unlock(wnd->display);
 }
 
+/** Window memory GC present callback.
+ *
+ * This is called by the window's memory GC when the client presents
+ * a surface, i.e. a bitmap it renders the entire window into. The surface
+ * is mapped to the display device as a bitmap and painted instead of
+ * the window bitmap, so no copying is needed.
+ *
+ * Requests to the window's GC are handled synchronously, so while
+ * the client waits for rendering of one surface to finish, we have
+ * stopped reading the previous one and it can be reused for drawing
+ * the next frame.
+ *
+ * @param arg Window
+ * @param alloc Surface allocation info or @c NULL to withdraw surface
+ * @return EOK on success or an error code
+ */
+static errno_t ds_window_present_cb(void *arg, gfx_bitmap_alloc_t *alloc)
+{
+	ds_window_t *wnd = (ds_window_t *)arg;
+	gfx_context_t *dgc;
+	gfx_bitmap_params_t params;
+	gfx_bitmap_alloc_t salloc;
+	gfx_bitmap_t *surface;
+	errno_t rc;
+
+	ds_display_lock(wnd->display);
+
+	if (alloc == NULL) {
+		/* Keep showing the last contents of the surface */
+		if (wnd->surface != NULL && wnd->pixelmap.data != NULL) {
+			rc = gfx_bitmap_get_alloc(wnd->surface, &salloc);
+			if (rc == EOK) {
+				memcpy(wnd->pixelmap.data, salloc.pixels,
+				    wnd->pixelmap.width *
+				    wnd->pixelmap.height * sizeof(pixel_t));
+			}
+		}
+
+		ds_window_drop_surface(wnd);
+		ds_display_unlock(wnd->display);
+		return EOK;
+	}
+
+	dgc = ds_display_get_gc(wnd->display);
+	if (dgc == NULL) {
+		/* This can happen in unit tests */
+		ds_display_unlock(wnd->display);
+		return ENOTSUP;
+	}
+
+	gfx_bitmap_params_init(&params);
+	params.rect = wnd->rect;
+
+	rc = gfx_bitmap_create(dgc, &params, alloc, &surface);
+	if (rc != EOK) {
+		ds_display_unlock(wnd->display);
+		return rc;
+	}
+
+	ds_window_drop_surface(wnd);
+	wnd->surface = surface;
+
+	ds_display_unlock(wnd->display);
+	return EOK;
+}
+
+/** Stop painting window from client surface.
+ *
+ * @param wnd Window
+ */
+static void ds_window_drop_surface(ds_window_t *wnd)
+{
+	if (wnd->surface == NULL)
+		return;
+
+	gfx_bitmap_destroy(wnd->surface);
+	wnd->surface = NULL;
+}
+
 /** Window memory GC update callback.
  *
  * This is called by the window's memory GC when it is to be updated.
@@ -38,6 +38,7 @@
 
 #include <adt/fifo.h>
 #include <adt/list.h>
+#include <assert.h>
 #include <async.h>
 #include <config.h>
 #include <errno.h>
@@ -55,6 +56,8 @@
 #include <stdlib.h>
 #include <str.h>
 #include <str_error.h>
+#include <task.h>
+#include <time.h>
 
 #include "input.h"
 #include "kbd.h"
@@ -67,6 +70,14 @@
 
 #define NUM_LAYOUTS 5
 
+/**
+ * Interval for coalescing pointer motion (us). Motion reported more often
+ * is accumulated and sent to clients once per interval, which spares the
+ * display server from repainting the pointer far more often than the screen
+ * is updated.
+ */
+#define MOVE_INTERVAL 8000
+
 static layout_ops_t *layout[NUM_LAYOUTS] = {
 	&us_qwerty_ops,
 	&us_dvorak_ops,
@@ -259,54 +270,146 @@ void kbd_push_event(kbd_dev_t *kdev, int type, unsigned int key)
 	}
 }
 
-/** Mouse pointer has moved (relative mode). */
-void mouse_push_event_move(mouse_dev_t *mdev, int dx, int dy, int dz)
+/** Send pointer motion not sent yet to the active clients.
+ *
+ * @param mdev Mouse device, with @c move_lock held.
+ */
+static void mouse_flush_move(mouse_dev_t *mdev)
 {
+	assert(fibril_mutex_is_locked(&mdev->move_lock));
+
+	if (!mdev->abs_pending && mdev->move_dx == 0 && mdev->move_dy == 0)
+		return;
+
 	list_foreach(clients, link, client_t, client) {
 		if (client->active) {
 			async_exch_t *exch = async_exchange_begin(client->sess);
 
-			if ((dx) || (dy))
+			if (mdev->abs_pending) {
+				async_msg_5(exch, INPUT_EVENT_ABS_MOVE,
+				    mdev->svc_id, mdev->abs_x, mdev->abs_y,
+				    mdev->abs_max_x, mdev->abs_max_y);
+			}
+
+			if ((mdev->move_dx) || (mdev->move_dy))
 				async_msg_3(exch, INPUT_EVENT_MOVE,
-				    mdev->svc_id, dx, dy);
+				    mdev->svc_id, mdev->move_dx, mdev->move_dy);
+
+			async_exchange_end(exch);
+		}
+	}
 
-			if (dz) {
-				// TODO: Implement proper wheel support
-				keycode_t code = dz > 0 ? KC_UP : KC_DOWN;
+	mdev->abs_pending = false;
+	mdev->move_dx = 0;
+	mdev->move_dy = 0;
+	getuptime(&mdev->move_sent);
+}
 
-				for (unsigned int i = 0; i < 3; i++)
-					async_msg_5(exch, INPUT_EVENT_KEY,
-					    0 /* XXX kbd_id */,
-					    KEY_PRESS, code, 0, 0);
+/** Send motion left over at the end of a coalescing interval. */
+static void mouse_move_timeout(void *arg)
+{
+	mouse_dev_t *mdev = (mouse_dev_t *) arg;
 
-				async_msg_5(exch, INPUT_EVENT_KEY, KEY_RELEASE,
-				    0 /* XXX kbd_id */, code, 0, 0);
-			}
+	fibril_mutex_lock(&mdev->move_lock);
+	mdev->move_timer_armed = false;
+	mouse_flush_move(mdev);
+	fibril_mutex_unlock(&mdev->move_lock);
+}
+
+/** Send the pending motion if the coalescing interval has elapsed.
+ *
+ * Otherwise arm the timer to send it at the end of the interval.
+ *
+ * @param mdev Mouse device, with @c move_lock held.
+ */
+static void mouse_update_move(mouse_dev_t *mdev)
+{
+	struct timespec now;
+	usec_t elapsed;
+
+	getuptime(&now);
+	elapsed = NSEC2USEC(ts_sub_diff(&now, &mdev->move_sent));
+
+	if (elapsed >= MOVE_INTERVAL || mdev->move_timer == NULL) {
+		mouse_flush_move(mdev);
+		return;
+	}
+
+	if (mdev->move_timer_armed)
+		return;
+
+	mdev->move_timer_armed = true;
+	fibril_timer_set_locked(mdev->move_timer, MOVE_INTERVAL - elapsed,
+	    mouse_move_timeout, mdev);
+}
+
+/** Mouse pointer has moved (relative mode). */
+void mouse_push_event_move(mouse_dev_t *mdev, int dx, int dy, int dz)
+{
+	fibril_mutex_lock(&mdev->move_lock);
+
+	if (dz) {
+		/* Keep the wheel keys ordered after the preceding motion. */
+		mouse_flush_move(mdev);
+
+		list_foreach(clients, link, client_t, client) {
+			if (!client->active)
+				continue;
+
+			async_exch_t *exch = async_exchange_begin(client->sess);
+
+			// TODO: Implement proper wheel support
+			keycode_t code = dz > 0 ? KC_UP : KC_DOWN;
+
+			for (unsigned int i = 0; i < 3; i++)
+				async_msg_5(exch, INPUT_EVENT_KEY,
+				    0 /* XXX kbd_id */,
+				    KEY_PRESS, code, 0, 0);
+
+			async_msg_5(exch, INPUT_EVENT_KEY, KEY_RELEASE,
+			    0 /* XXX kbd_id */, code, 0, 0);
 
 			async_exchange_end(exch);
 		}
 	}
+
+	if ((dx) || (dy)) {
+		mdev->move_dx += dx;
+		mdev->move_dy += dy;
+		mouse_update_move(mdev);
+	}
+
+	fibril_mutex_unlock(&mdev->move_lock);
 }
 
 /** Mouse pointer has moved (absolute mode). */
 void mouse_push_event_abs_move(mouse_dev_t *mdev, unsigned int x, unsigned int y,
     unsigned int max_x, unsigned int max_y)
 {
-	list_foreach(clients, link, client_t, client) {
-		if (client->active) {
-			if ((max_x) && (max_y)) {
-				async_exch_t *exch = async_exchange_begin(client->sess);
-				async_msg_5(exch, INPUT_EVENT_ABS_MOVE,
-				    mdev->svc_id, x, y, max_x, max_y);
-				async_exchange_end(exch);
-			}
-		}
-	}
+	if ((!max_x) || (!max_y))
+		return;
+
+	fibril_mutex_lock(&mdev->move_lock);
+
+	/* Only the latest position matters. */
+	mdev->abs_pending = true;
+	mdev->abs_x = x;
+	mdev->abs_y = y;
+	mdev->abs_max_x = max_x;
+	mdev->abs_max_y = max_y;
+	mouse_update_move(mdev);
+
+	fibril_mutex_unlock(&mdev->move_lock);
 }
 
 /** Mouse button has been pressed. */
 void mouse_push_event_button(mouse_dev_t *mdev, int bnum, int press)
 {
+	fibril_mutex_lock(&mdev->move_lock);
+
+	/* The button must not overtake the motion preceding it. */
+	mouse_flush_move(mdev);
+
 	list_foreach(clients, link, client_t, client) {
 		if (client->active) {
 			async_exch_t *exch = async_exchange_begin(client->sess);
@@ -315,11 +418,16 @@ void mouse_push_event_button(mouse_dev_t *mdev, int bnum, int press)
 			async_exchange_end(exch);
 		}
 	}
+
+	fibril_mutex_unlock(&mdev->move_lock);
 }
 
 /** Mouse button has been double-clicked. */
 void mouse_push_event_dclick(mouse_dev_t *mdev, int bnum)
 {
+	fibril_mutex_lock(&mdev->move_lock);
+	mouse_flush_move(mdev);
+
 	list_foreach(clients, link, client_t, client) {
 		if (client->active) {
 			async_exch_t *exch = async_exchange_begin(client->sess);
@@ -328,6 +436,8 @@ void mouse_push_event_dclick(mouse_dev_t *mdev, int bnum)
 			async_exchange_end(exch);
 		}
 	}
+
+	fibril_mutex_unlock(&mdev->move_lock);
 }
 
 /** Arbitrate client activation */
@@ -434,6 +544,10 @@ static mouse_dev_t *mouse_dev_new(void)
 	}
 
 	link_initialize(&mdev->link);
+	fibril_mutex_initialize(&mdev->move_lock);
+
+	/* Without the timer, motion is sent to clients right away. */
+	mdev->move_timer = fibril_timer_create(&mdev->move_lock);
 
 	return mdev;
 }
@@ -554,6 +668,8 @@ static int mouse_add_mousedev(service_id_t service_id, mouse_dev_t **mdevp)
 	return 0;
 
 fail:
+	if (mdev->move_timer != NULL)
+		fibril_timer_destroy(mdev->move_timer);
 	free(mdev);
 	return -1;
 }
@@ -885,6 +1001,12 @@ int main(int argc, char **argv)
 
 	printf("%s: HelenOS input service\n", NAME);
 
+	/* Deliver input events promptly regardless of other load */
+	rc = task_set_sched_class(SCHED_CLASS_FIFO);
+	if (rc != EOK)
+		printf("%s: Failed to enable real-time scheduling (%s)\n",
+		    NAME, str_error(rc));
+
 	list_initialize(&clients);
 	list_initialize(&kbd_devs);
 	list_initialize(&mouse_devs);
@@ -38,7 +38,10 @@
 #define MOUSE_H_
 
 #include <adt/list.h>
+#include <fibril_synch.h>
 #include <ipc/loc.h>
+#include <stdbool.h>
+#include <time.h>
 
 struct mouse_port_ops;
 struct mouse_proto_ops;
@@ -58,6 +61,29 @@ typedef struct mouse_dev {
 
 	/** Protocol ops */
 	struct mouse_proto_ops *proto_ops;
+
+	/** Protects the motion not sent to clients yet */
+	fibril_mutex_t move_lock;
+
+	/** Relative motion not sent to clients yet */
+	int move_dx;
+	int move_dy;
+
+	/** Absolute position not sent to clients yet */
+	bool abs_pending;
+	unsigned int abs_x;
+	unsigned int abs_y;
+	unsigned int abs_max_x;
+	unsigned int abs_max_y;
+
+	/** Time motion was last sent to clients */
+	struct timespec move_sent;
+
+	/** Timer sending motion left over at the end of an interval or NULL */
+	fibril_timer_t *move_timer;
+
+	/** The timer is armed */
+	bool move_timer_armed;
 } mouse_dev_t;
 
 extern void mouse_push_data(mouse_dev_t *, sysarg_t);
@@ -319,13 +319,18 @@ static void srv_update(ipc_call_t *icall)
 
 	chargrid_t *buf = (chargrid_t *) frontbuf->data;
 
+	/* Only rows with dirty fields need to be examined. */
+	sysarg_t r0;
+	sysarg_t r1;
+	chargrid_get_dirty_rows(buf, &r0, &r1);
+
 	list_foreach(outdevs, link, outdev_t, dev) {
 		assert(dev->ops.char_update);
 
 		if (srv_update_scroll(dev, buf))
 			continue;
 
-		for (sysarg_t y = 0; y < dev->rows; y++) {
+		for (sysarg_t y = r0; y < min(r1, dev->rows); y++) {
 			for (sysarg_t x = 0; x < dev->cols; x++) {
 				charfield_t *front_field =
 				    chargrid_charfield_at(buf, x, y);
@@ -357,6 +362,7 @@ static void srv_update(ipc_call_t *icall)
 		dev->ops.flush(dev);
 	}
 
+	chargrid_reset_dirty_rows(buf);
 	async_answer_0(icall, EOK);
 }
 
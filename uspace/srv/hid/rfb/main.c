@@ -92,29 +92,10 @@ static gfx_context_ops_t rfb_gc_ops = {
 
 static void rfb_gc_invalidate_rect(rfb_gc_t *rfbgc, gfx_rect_t *rect)
 {
-	rfb_t *rfb = &rfbgc->rfb;
-	gfx_rect_t old_rect;
-	gfx_rect_t new_rect;
-
 	if (gfx_rect_is_empty(rect))
 		return;
 
-	if (!rfb->damage_valid) {
-		old_rect.p0.x = old_rect.p0.y = 0;
-		old_rect.p1.x = old_rect.p1.y = 0;
-	} else {
-		old_rect.p0.x = rfb->damage_rect.x;
-		old_rect.p0.y = rfb->damage_rect.y;
-		old_rect.p1.x = rfb->damage_rect.x + rfb->damage_rect.width;
-		old_rect.p1.y = rfb->damage_rect.y + rfb->damage_rect.height;
-	}
-
-	gfx_rect_envelope(&old_rect, rect, &new_rect);
-
-	rfb->damage_rect.x = new_rect.p0.x;
-	rfb->damage_rect.y = new_rect.p0.y;
-	rfb->damage_rect.width = new_rect.p1.x - new_rect.p0.x;
-	rfb->damage_rect.height = new_rect.p1.y - new_rect.p0.y;
+	rfb_invalidate(&rfbgc->rfb, rect);
 }
 
 static errno_t rfb_ddev_get_gc(void *arg, sysarg_t *arg2, sysarg_t *arg3)
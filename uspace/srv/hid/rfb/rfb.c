@@ -27,9 +27,12 @@
  */
 
 #include <errno.h>
+#include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <fibril_synch.h>
+#include <gfx/coord.h>
+#include <gfx/region.h>
 #include <inet/addr.h>
 #include <inet/endpoint.h>
 #include <inet/tcp.h>
@@ -42,6 +45,12 @@
 
 #include "rfb.h"
 
+/** Delay for collecting damage before sending an update (us) */
+#define RFB_UPDATE_DELAY 10000
+
+/** Maximum length of a stored deflate block */
+#define ZLIB_STORED_MAX 65535
+
 static void rfb_new_conn(tcp_listener_t *, tcp_conn_t *);
 
 static tcp_listen_cb_t listen_cb = {
@@ -52,55 +61,101 @@ static tcp_cb_t conn_cb = {
 	.connected = NULL
 };
 
-/** Buffer for receiving the request. */
-#define BUFFER_SIZE  1024
+/** Refill the receive buffer */
+static errno_t recv_fill(rfb_client_t *client)
+{
+	size_t nrecv;
+	errno_t rc;
+
+	client->rbuf_out = 0;
+	client->rbuf_in = 0;
 
-static char rbuf[BUFFER_SIZE];
-static size_t rbuf_out;
-static size_t rbuf_in;
+	rc = tcp_conn_recv_wait(client->conn, client->rbuf, RFB_RBUF_SIZE,
+	    &nrecv);
+	if (rc != EOK)
+		return rc;
+
+	if (nrecv == 0)
+		return EIO;
+
+	client->rbuf_in = nrecv;
+	return EOK;
+}
 
 /** Receive one character (with buffering) */
-static errno_t recv_char(tcp_conn_t *conn, char *c)
+static errno_t recv_char(rfb_client_t *client, char *c)
 {
-	size_t nrecv;
 	errno_t rc;
 
-	if (rbuf_out == rbuf_in) {
-		rbuf_out = 0;
-		rbuf_in = 0;
-
-		rc = tcp_conn_recv_wait(conn, rbuf, BUFFER_SIZE, &nrecv);
+	if (client->rbuf_out == client->rbuf_in) {
+		rc = recv_fill(client);
 		if (rc != EOK)
 			return rc;
-
-		rbuf_in = nrecv;
 	}
 
-	*c = rbuf[rbuf_out++];
+	*c = client->rbuf[client->rbuf_out++];
 	return EOK;
 }
 
-/** Receive count characters (with buffering) */
+/** Receive count characters (with buffering)
+ *
+ * Whatever is buffered is copied at once. Reads which are larger than
+ * the buffer bypass it.
+ */
 static errno_t __attribute__((warn_unused_result))
-recv_chars(tcp_conn_t *conn, char *c, size_t count)
+recv_chars(rfb_client_t *client, char *c, size_t count)
 {
-	for (size_t i = 0; i < count; i++) {
-		errno_t rc = recv_char(conn, c);
-		if (rc != EOK)
-			return rc;
-		c++;
+	size_t nrecv;
+	size_t n;
+	errno_t rc;
+
+	while (count > 0) {
+		if (client->rbuf_out == client->rbuf_in) {
+			if (count >= RFB_RBUF_SIZE) {
+				rc = tcp_conn_recv_wait(client->conn, c, count,
+				    &nrecv);
+				if (rc != EOK)
+					return rc;
+				if (nrecv == 0)
+					return EIO;
+
+				c += nrecv;
+				count -= nrecv;
+				continue;
+			}
+
+			rc = recv_fill(client);
+			if (rc != EOK)
+				return rc;
+		}
+
+		n = min(count, client->rbuf_in - client->rbuf_out);
+		memcpy(c, client->rbuf + client->rbuf_out, n);
+		client->rbuf_out += n;
+		c += n;
+		count -= n;
 	}
+
 	return EOK;
 }
 
-static errno_t recv_skip_chars(tcp_conn_t *conn, size_t count)
+static errno_t recv_skip_chars(rfb_client_t *client, size_t count)
 {
-	for (size_t i = 0; i < count; i++) {
-		char c;
-		errno_t rc = recv_char(conn, &c);
-		if (rc != EOK)
-			return rc;
+	size_t n;
+	errno_t rc;
+
+	while (count > 0) {
+		if (client->rbuf_out == client->rbuf_in) {
+			rc = recv_fill(client);
+			if (rc != EOK)
+				return rc;
+		}
+
+		n = min(count, client->rbuf_in - client->rbuf_out);
+		client->rbuf_out += n;
+		count -= n;
 	}
+
 	return EOK;
 }
 
@@ -135,7 +190,7 @@ static void rfb_framebuffer_update_request_to_host(rfb_framebuffer_update_reques
     rfb_framebuffer_update_request_t *dst)
 {
 	dst->x = uint16_t_be2host(src->x);
-	dst->y = uint16_t_be2host(src->x);
+	dst->y = uint16_t_be2host(src->y);
 	dst->width = uint16_t_be2host(src->width);
 	dst->height = uint16_t_be2host(src->height);
 }
@@ -176,6 +231,7 @@ errno_t rfb_init(rfb_t *rfb, uint16_t width, uint16_t height, const char *name)
 {
 	memset(rfb, 0, sizeof(rfb_t));
 	fibril_mutex_initialize(&rfb->lock);
+	list_initialize(&rfb->clients);
 
 	rfb_pixel_format_t *pf = &rfb->pixel_format;
 	pf->bpp = 32;
@@ -190,7 +246,6 @@ errno_t rfb_init(rfb_t *rfb, uint16_t width, uint16_t height, const char *name)
 	pf->b_shift = 16;
 
 	rfb->name = str_dup(name);
-	rfb->supports_trle = false;
 
 	return rfb_set_size(rfb, width, height);
 }
@@ -215,11 +270,74 @@ errno_t rfb_set_size(rfb_t *rfb, uint16_t width, uint16_t height)
 	return EOK;
 }
 
+static void rfb_client_update_timer(void *);
+
+/** Schedule sending a framebuffer update to the client.
+ *
+ * The update is sent once the client has requested it and there is
+ * some damage to send. It is delayed a little so that damage from
+ * a burst of drawing operations is sent in one update.
+ *
+ * @param client Client, rfb->lock must be held
+ */
+static void rfb_client_schedule_update(rfb_client_t *client)
+{
+	assert(fibril_mutex_is_locked(&client->rfb->lock));
+
+	if (!client->update_requested || client->update_scheduled ||
+	    gfx_region_is_empty(&client->damage))
+		return;
+
+	client->update_scheduled = true;
+	fibril_timer_set_locked(client->update_timer, RFB_UPDATE_DELAY,
+	    rfb_client_update_timer, client);
+}
+
+/** Add rectangle to client damage.
+ *
+ * @param client Client, rfb->lock must be held
+ * @param rect Rectangle
+ */
+static void rfb_client_invalidate(rfb_client_t *client, gfx_rect_t *rect)
+{
+	gfx_rect_t fbrect;
+	gfx_rect_t crect;
+
+	fbrect.p0.x = 0;
+	fbrect.p0.y = 0;
+	fbrect.p1.x = client->rfb->width;
+	fbrect.p1.y = client->rfb->height;
+
+	gfx_rect_clip(rect, &fbrect, &crect);
+	if (gfx_rect_is_empty(&crect))
+		return;
+
+	gfx_region_add_rect(&client->damage, &crect);
+	rfb_client_schedule_update(client);
+}
+
+/** Invalidate framebuffer area.
+ *
+ * The area will be sent to all connected clients.
+ *
+ * @param rfb RFB
+ * @param rect Rectangle that has changed
+ */
+void rfb_invalidate(rfb_t *rfb, gfx_rect_t *rect)
+{
+	fibril_mutex_lock(&rfb->lock);
+
+	list_foreach(rfb->clients, link, rfb_client_t, client)
+		rfb_client_invalidate(client, rect);
+
+	fibril_mutex_unlock(&rfb->lock);
+}
+
 static errno_t __attribute__((warn_unused_result))
-recv_message(tcp_conn_t *conn, char type, void *buf, size_t size)
+recv_message(rfb_client_t *client, char type, void *buf, size_t size)
 {
 	memcpy(buf, &type, 1);
-	return recv_chars(conn, ((char *) buf) + 1, size - 1);
+	return recv_chars(client, ((char *) buf) + 1, size - 1);
 }
 
 static uint32_t rfb_scale_channel(uint8_t val, uint32_t max)
@@ -227,25 +345,27 @@ static uint32_t rfb_scale_channel(uint8_t val, uint32_t max)
 	return val * max / 255;
 }
 
-static void rfb_encode_index(rfb_t *rfb, uint8_t *buf, pixel_t pixel)
+static void rfb_encode_index(rfb_client_t *client, uint8_t *buf,
+    pixel_t pixel)
 {
 	int first_free_index = -1;
 	for (size_t i = 0; i < 256; i++) {
-		bool free = ALPHA(rfb->palette[i]) == 0;
+		bool free = ALPHA(client->palette[i]) == 0;
 		if (free && first_free_index == -1) {
 			first_free_index = i;
-		} else if (!free && RED(rfb->palette[i]) == RED(pixel) &&
-		    GREEN(rfb->palette[i]) == GREEN(pixel) &&
-		    BLUE(rfb->palette[i]) == BLUE(pixel)) {
+		} else if (!free && RED(client->palette[i]) == RED(pixel) &&
+		    GREEN(client->palette[i]) == GREEN(pixel) &&
+		    BLUE(client->palette[i]) == BLUE(pixel)) {
 			*buf = i;
 			return;
 		}
 	}
 
 	if (first_free_index != -1) {
-		rfb->palette[first_free_index] = PIXEL(255, RED(pixel), GREEN(pixel),
-		    BLUE(pixel));
-		rfb->palette_used = max(rfb->palette_used, (unsigned) first_free_index + 1);
+		client->palette[first_free_index] = PIXEL(255, RED(pixel),
+		    GREEN(pixel), BLUE(pixel));
+		client->palette_used = max(client->palette_used,
+		    (unsigned) first_free_index + 1);
 		*buf = first_free_index;
 		return;
 	}
@@ -283,12 +403,12 @@ static void rfb_encode_true_color(rfb_pixel_format_t *pf, void *buf,
 	}
 }
 
-static void rfb_encode_pixel(rfb_t *rfb, void *buf, pixel_t pixel)
+static void rfb_encode_pixel(rfb_client_t *client, void *buf, pixel_t pixel)
 {
-	if (rfb->pixel_format.true_color) {
-		rfb_encode_true_color(&rfb->pixel_format, buf, pixel);
+	if (client->pixel_format.true_color) {
+		rfb_encode_true_color(&client->pixel_format, buf, pixel);
 	} else {
-		rfb_encode_index(rfb, buf, pixel);
+		rfb_encode_index(client, buf, pixel);
 	}
 }
 
@@ -307,10 +427,10 @@ static void rfb_color_map_entry_to_be(rfb_color_map_entry_t *src,
 	dst->blue = host2uint16_t_be(src->blue);
 }
 
-static void *rfb_send_palette_message(rfb_t *rfb, size_t *psize)
+static void *rfb_send_palette_message(rfb_client_t *client, size_t *psize)
 {
 	size_t size = sizeof(rfb_set_color_map_entries_t) +
-	    rfb->palette_used * sizeof(rfb_color_map_entry_t);
+	    client->palette_used * sizeof(rfb_color_map_entry_t);
 
 	void *buf = malloc(size);
 	if (buf == NULL)
@@ -321,15 +441,15 @@ static void *rfb_send_palette_message(rfb_t *rfb, size_t *psize)
 	rfb_set_color_map_entries_t *scme = pos;
 	scme->message_type = RFB_SMSG_SET_COLOR_MAP_ENTRIES;
 	scme->first_color = 0;
-	scme->color_count = rfb->palette_used;
+	scme->color_count = client->palette_used;
 	rfb_set_color_map_entries_to_be(scme, scme);
 	pos += sizeof(rfb_set_color_map_entries_t);
 
 	rfb_color_map_entry_t *entries = pos;
-	for (unsigned i = 0; i < rfb->palette_used; i++) {
-		entries[i].red = 65535 * RED(rfb->palette[i]) / 255;
-		entries[i].green = 65535 * GREEN(rfb->palette[i]) / 255;
-		entries[i].blue = 65535 * BLUE(rfb->palette[i]) / 255;
+	for (unsigned i = 0; i < client->palette_used; i++) {
+		entries[i].red = 65535 * RED(client->palette[i]) / 255;
+		entries[i].green = 65535 * GREEN(client->palette[i]) / 255;
+		entries[i].blue = 65535 * BLUE(client->palette[i]) / 255;
 		rfb_color_map_entry_to_be(&entries[i], &entries[i]);
 	}
 
@@ -337,9 +457,10 @@ static void *rfb_send_palette_message(rfb_t *rfb, size_t *psize)
 	return buf;
 }
 
-static size_t rfb_rect_encode_raw(rfb_t *rfb, rfb_rectangle_t *rect, void *buf)
+static size_t rfb_rect_encode_raw(rfb_client_t *client, rfb_rectangle_t *rect,
+    void *buf)
 {
-	size_t pixel_size = rfb->pixel_format.bpp / 8;
+	size_t pixel_size = client->pixel_format.bpp / 8;
 	size_t size = (rect->width * rect->height * pixel_size);
 
 	if (buf == NULL)
@@ -347,9 +468,10 @@ static size_t rfb_rect_encode_raw(rfb_t *rfb, rfb_rectangle_t *rect, void *buf)
 
 	for (uint16_t y = 0; y < rect->height; y++) {
 		for (uint16_t x = 0; x < rect->width; x++) {
-			pixel_t pixel = pixelmap_get_pixel(&rfb->framebuffer,
-			    x + rect->x, y + rect->y);
-			rfb_encode_pixel(rfb, buf, pixel);
+			pixel_t pixel = pixelmap_get_pixel(
+			    &client->rfb->framebuffer, x + rect->x,
+			    y + rect->y);
+			rfb_encode_pixel(client, buf, pixel);
 			buf += pixel_size;
 		}
 	}
@@ -396,11 +518,11 @@ static void cpixel_context_init(cpixel_ctx_t *ctx, rfb_pixel_format_t *pixel_for
 	}
 }
 
-static void cpixel_encode(rfb_t *rfb, cpixel_ctx_t *cpixel, void *buf,
-    pixel_t pixel)
+static void cpixel_encode(rfb_client_t *client, cpixel_ctx_t *cpixel,
+    void *buf, pixel_t pixel)
 {
 	uint8_t data[4];
-	rfb_encode_pixel(rfb, data, pixel);
+	rfb_encode_pixel(client, data, pixel);
 
 	switch (cpixel->compress_type) {
 	case COMP_NONE:
@@ -412,7 +534,7 @@ static void cpixel_encode(rfb_t *rfb, cpixel_ctx_t *cpixel, void *buf,
 	}
 }
 
-static size_t rfb_tile_encode_raw(rfb_t *rfb, cpixel_ctx_t *cpixel,
+static size_t rfb_tile_encode_raw(rfb_client_t *client, cpixel_ctx_t *cpixel,
     rfb_rectangle_t *tile, void *buf)
 {
 	size_t size = tile->width * tile->height * cpixel->size;
@@ -421,44 +543,49 @@ static size_t rfb_tile_encode_raw(rfb_t *rfb, cpixel_ctx_t *cpixel,
 
 	for (uint16_t y = tile->y; y < tile->y + tile->height; y++) {
 		for (uint16_t x = tile->x; x < tile->x + tile->width; x++) {
-			pixel_t pixel = pixelmap_get_pixel(&rfb->framebuffer, x, y);
-			cpixel_encode(rfb, cpixel, buf, pixel);
+			pixel_t pixel = pixelmap_get_pixel(
+			    &client->rfb->framebuffer, x, y);
+			cpixel_encode(client, cpixel, buf, pixel);
+			buf += cpixel->size;
 		}
 	}
 
 	return size;
 }
 
-static errno_t rfb_tile_encode_solid(rfb_t *rfb, cpixel_ctx_t *cpixel,
-    rfb_rectangle_t *tile, void *buf, size_t *size)
+static errno_t rfb_tile_encode_solid(rfb_client_t *client,
+    cpixel_ctx_t *cpixel, rfb_rectangle_t *tile, void *buf, size_t *size)
 {
+	pixelmap_t *fb = &client->rfb->framebuffer;
+
 	/* Check if it is single color */
-	pixel_t the_color = pixelmap_get_pixel(&rfb->framebuffer, tile->x, tile->y);
+	pixel_t the_color = pixelmap_get_pixel(fb, tile->x, tile->y);
 	for (uint16_t y = tile->y; y < tile->y + tile->height; y++) {
 		for (uint16_t x = tile->x; x < tile->x + tile->width; x++) {
-			if (pixelmap_get_pixel(&rfb->framebuffer, x, y) != the_color)
+			if (pixelmap_get_pixel(fb, x, y) != the_color)
 				return EINVAL;
 		}
 	}
 
 	/* OK, encode it */
 	if (buf)
-		cpixel_encode(rfb, cpixel, buf, the_color);
+		cpixel_encode(client, cpixel, buf, the_color);
 	*size = cpixel->size;
 	return EOK;
 }
 
-static size_t rfb_rect_encode_trle(rfb_t *rfb, rfb_rectangle_t *rect, void *buf)
+static size_t rfb_rect_encode_trle(rfb_client_t *client, rfb_rectangle_t *rect,
+    void *buf)
 {
 	cpixel_ctx_t cpixel;
-	cpixel_context_init(&cpixel, &rfb->pixel_format);
+	cpixel_context_init(&cpixel, &client->pixel_format);
 
 	size_t size = 0;
 	for (uint16_t y = 0; y < rect->height; y += 16) {
 		for (uint16_t x = 0; x < rect->width; x += 16) {
 			rfb_rectangle_t tile = {
-				.x = x,
-				.y = y,
+				.x = rect->x + x,
+				.y = rect->y + y,
 				.width = (x + 16 <= rect->width ? 16 : rect->width - x),
 				.height = (y + 16 <= rect->height ? 16 : rect->height - y)
 			};
@@ -470,13 +597,15 @@ static size_t rfb_rect_encode_trle(rfb_t *rfb, rfb_rectangle_t *rect, void *buf)
 
 			uint8_t tile_enctype = RFB_TILE_ENCODING_SOLID;
 			size_t tile_size;
-			errno_t rc = rfb_tile_encode_solid(rfb, &cpixel, &tile, buf,
-			    &tile_size);
+			errno_t rc = rfb_tile_encode_solid(client, &cpixel,
+			    &tile, buf, &tile_size);
 			if (rc != EOK) {
-				tile_size = rfb_tile_encode_raw(rfb, &cpixel, &tile, buf);
+				tile_size = rfb_tile_encode_raw(client, &cpixel,
+				    &tile, buf);
 				tile_enctype = RFB_TILE_ENCODING_RAW;
 			}
 
+			size += tile_size;
 			if (buf) {
 				*tile_enctype_ptr = tile_enctype;
 				buf += tile_size;
@@ -486,57 +615,421 @@ static size_t rfb_rect_encode_trle(rfb_t *rfb, rfb_rectangle_t *rect, void *buf)
 	return size;
 }
 
-static errno_t rfb_send_framebuffer_update(rfb_t *rfb, tcp_conn_t *conn,
-    bool incremental)
+/** ZRLE tile statistics */
+typedef struct {
+	/** Tile colors, valid if @c palette_full is @c false */
+	pixel_t palette[RFB_ZRLE_PALETTE_RLE_MAX];
+	size_t palette_size;
+	/** Tile has more colors than fit in the palette */
+	bool palette_full;
+	/** Number of runs of the same color */
+	size_t runs;
+	/** Bytes needed to encode lengths of all runs */
+	size_t rl_all;
+	/** Bytes needed to encode lengths of runs longer than one pixel */
+	size_t rl_multi;
+} rfb_zrle_tile_t;
+
+/** Number of bytes encoding a ZRLE run length. */
+static size_t rfb_zrle_rl_size(size_t len)
+{
+	return (len - 1) / 255 + 1;
+}
+
+static uint8_t *rfb_zrle_put_rl(uint8_t *buf, size_t len)
+{
+	len -= 1;
+	while (len >= 255) {
+		*buf++ = 255;
+		len -= 255;
+	}
+
+	*buf++ = len;
+	return buf;
+}
+
+static size_t rfb_zrle_palette_index(rfb_zrle_tile_t *zt, pixel_t pixel)
+{
+	for (size_t i = 0; i < zt->palette_size; i++) {
+		if (zt->palette[i] == pixel)
+			return i;
+	}
+
+	return zt->palette_size;
+}
+
+static void rfb_zrle_add_run(rfb_zrle_tile_t *zt, size_t len)
+{
+	zt->runs++;
+	zt->rl_all += rfb_zrle_rl_size(len);
+	if (len > 1)
+		zt->rl_multi += rfb_zrle_rl_size(len);
+}
+
+/** Gather colors and runs of a ZRLE tile. */
+static void rfb_zrle_tile_scan(rfb_client_t *client, rfb_rectangle_t *tile,
+    rfb_zrle_tile_t *zt)
+{
+	pixelmap_t *fb = &client->rfb->framebuffer;
+	pixel_t run_color = 0;
+	size_t run_len = 0;
+
+	memset(zt, 0, sizeof(rfb_zrle_tile_t));
+
+	for (uint16_t y = tile->y; y < tile->y + tile->height; y++) {
+		for (uint16_t x = tile->x; x < tile->x + tile->width; x++) {
+			pixel_t pixel = pixelmap_get_pixel(fb, x, y);
+
+			if (run_len > 0 && pixel == run_color) {
+				run_len++;
+				continue;
+			}
+
+			if (run_len > 0)
+				rfb_zrle_add_run(zt, run_len);
+
+			run_color = pixel;
+			run_len = 1;
+
+			if (zt->palette_full)
+				continue;
+			if (rfb_zrle_palette_index(zt, pixel) < zt->palette_size)
+				continue;
+
+			if (zt->palette_size < RFB_ZRLE_PALETTE_RLE_MAX)
+				zt->palette[zt->palette_size++] = pixel;
+			else
+				zt->palette_full = true;
+		}
+	}
+
+	rfb_zrle_add_run(zt, run_len);
+}
+
+/** Encode ZRLE tile.
+ *
+ * Of the subencodings the client must support, the one yielding the
+ * smallest output is chosen.
+ *
+ * @param client Client
+ * @param cpixel CPIXEL context
+ * @param tile Tile (in framebuffer coordinates)
+ * @param buf Output buffer, at least 1 + width * height * cpixel size
+ *            bytes long
+ * @return Number of bytes written
+ */
+static size_t rfb_zrle_tile_encode(rfb_client_t *client, cpixel_ctx_t *cpixel,
+    rfb_rectangle_t *tile, uint8_t *buf)
+{
+	pixelmap_t *fb = &client->rfb->framebuffer;
+	rfb_zrle_tile_t zt;
+	size_t cps = cpixel->size;
+	size_t npixels = tile->width * tile->height;
+	unsigned bits = 0;
+	uint8_t subenc;
+	size_t size;
+	size_t psize;
+	uint8_t *pos = buf;
+
+	rfb_zrle_tile_scan(client, tile, &zt);
+
+	if (!zt.palette_full && zt.palette_size == 1) {
+		*pos++ = RFB_ZRLE_SOLID;
+		cpixel_encode(client, cpixel, pos, zt.palette[0]);
+		return 1 + cps;
+	}
+
+	/* Raw */
+	subenc = RFB_ZRLE_RAW;
+	size = npixels * cps;
+
+	/* Plain RLE */
+	psize = zt.runs * cps + zt.rl_all;
+	if (psize < size) {
+		subenc = RFB_ZRLE_PLAIN_RLE;
+		size = psize;
+	}
+
+	if (!zt.palette_full) {
+		/* Packed palette */
+		if (zt.palette_size <= RFB_ZRLE_PACKED_PALETTE_MAX) {
+			bits = zt.palette_size <= 2 ? 1 :
+			    zt.palette_size <= 4 ? 2 : 4;
+			psize = zt.palette_size * cps + tile->height *
+			    ((tile->width * bits + 7) / 8);
+			if (psize < size) {
+				subenc = zt.palette_size;
+				size = psize;
+			}
+		}
+
+		/* Palette RLE */
+		psize = zt.palette_size * cps + zt.runs + zt.rl_multi;
+		if (psize < size) {
+			subenc = RFB_ZRLE_PALETTE_RLE + zt.palette_size;
+			size = psize;
+		}
+	}
+
+	*pos++ = subenc;
+
+	if (subenc == RFB_ZRLE_RAW) {
+		return 1 + rfb_tile_encode_raw(client, cpixel, tile, pos);
+	}
+
+	if (subenc != RFB_ZRLE_PLAIN_RLE) {
+		for (size_t i = 0; i < zt.palette_size; i++) {
+			cpixel_encode(client, cpixel, pos, zt.palette[i]);
+			pos += cps;
+		}
+	}
+
+	if (subenc <= RFB_ZRLE_PACKED_PALETTE_MAX) {
+		/* Packed palette, rows are padded to whole bytes */
+		for (uint16_t y = tile->y; y < tile->y + tile->height; y++) {
+			uint8_t byte = 0;
+			unsigned nbits = 0;
+
+			for (uint16_t x = tile->x; x < tile->x + tile->width;
+			    x++) {
+				pixel_t pixel = pixelmap_get_pixel(fb, x, y);
+				byte = (byte << bits) |
+				    rfb_zrle_palette_index(&zt, pixel);
+				nbits += bits;
+				if (nbits == 8) {
+					*pos++ = byte;
+					byte = 0;
+					nbits = 0;
+				}
+			}
+
+			if (nbits > 0)
+				*pos++ = byte << (8 - nbits);
+		}
+
+		return pos - buf;
+	}
+
+	/* Plain or palette RLE, runs continue across rows */
+	pixel_t run_color = 0;
+	size_t run_len = 0;
+
+	for (size_t i = 0; i <= npixels; i++) {
+		pixel_t pixel = 0;
+
+		if (i < npixels) {
+			pixel = pixelmap_get_pixel(fb,
+			    tile->x + i % tile->width,
+			    tile->y + i / tile->width);
+			if (run_len > 0 && pixel == run_color) {
+				run_len++;
+				continue;
+			}
+		}
+
+		if (run_len > 0) {
+			if (subenc == RFB_ZRLE_PLAIN_RLE) {
+				cpixel_encode(client, cpixel, pos, run_color);
+				pos = rfb_zrle_put_rl(pos + cps, run_len);
+			} else if (run_len == 1) {
+				*pos++ = rfb_zrle_palette_index(&zt, run_color);
+			} else {
+				*pos++ = 128 |
+				    rfb_zrle_palette_index(&zt, run_color);
+				pos = rfb_zrle_put_rl(pos, run_len);
+			}
+		}
+
+		run_color = pixel;
+		run_len = 1;
+	}
+
+	return pos - buf;
+}
+
+/** Encode rectangle using ZRLE.
+ *
+ * There is no deflate implementation at hand, so the ZLIB stream
+ * consists of stored (uncompressed) blocks. The compression thus comes
+ * from the RLE and palette tile subencodings alone.
+ *
+ * @param client Client
+ * @param rect Rectangle
+ * @param buf Output buffer or @c NULL
+ * @return Number of bytes written or, if @a buf is @c NULL, the maximum
+ *         number of bytes that can be written
+ */
+static size_t rfb_rect_encode_zrle(rfb_client_t *client, rfb_rectangle_t *rect,
+    void *buf)
+{
+	cpixel_ctx_t cpixel;
+	cpixel_context_init(&cpixel, &client->pixel_format);
+
+	size_t tiles_x = (rect->width + RFB_ZRLE_TILE_SIZE - 1) /
+	    RFB_ZRLE_TILE_SIZE;
+	size_t tiles_y = (rect->height + RFB_ZRLE_TILE_SIZE - 1) /
+	    RFB_ZRLE_TILE_SIZE;
+	size_t data_max = tiles_x * tiles_y +
+	    rect->width * rect->height * cpixel.size;
+	size_t blocks_max = data_max / ZLIB_STORED_MAX + 1;
+
+	if (buf == NULL)
+		return sizeof(uint32_t) + 2 + blocks_max * 5 + data_max;
+
+	uint8_t *data = malloc(data_max);
+	if (data == NULL)
+		return 0;
+
+	size_t data_size = 0;
+	for (uint16_t y = 0; y < rect->height; y += RFB_ZRLE_TILE_SIZE) {
+		for (uint16_t x = 0; x < rect->width;
+		    x += RFB_ZRLE_TILE_SIZE) {
+			rfb_rectangle_t tile = {
+				.x = rect->x + x,
+				.y = rect->y + y,
+				.width = min(RFB_ZRLE_TILE_SIZE,
+				    rect->width - x),
+				.height = min(RFB_ZRLE_TILE_SIZE,
+				    rect->height - y)
+			};
+
+			data_size += rfb_zrle_tile_encode(client, &cpixel,
+			    &tile, data + data_size);
+		}
+	}
+
+	uint8_t *pos = (uint8_t *) buf + sizeof(uint32_t);
+
+	if (!client->zrle_started) {
+		/* ZLIB header, deflate with 32K window */
+		*pos++ = 0x78;
+		*pos++ = 0x01;
+		client->zrle_started = true;
+	}
+
+	size_t off = 0;
+	while (off < data_size) {
+		uint16_t len = min(data_size - off, ZLIB_STORED_MAX);
+
+		/* Non-final stored block header */
+		*pos++ = 0;
+		*pos++ = len & 0xff;
+		*pos++ = len >> 8;
+		*pos++ = ~len & 0xff;
+		*pos++ = (uint16_t) ~len >> 8;
+		memcpy(pos, data + off, len);
+		pos += len;
+		off += len;
+	}
+
+	free(data);
+
+	uint32_t zlen = host2uint32_t_be(pos - (uint8_t *) buf -
+	    sizeof(uint32_t));
+	memcpy(buf, &zlen, sizeof(uint32_t));
+
+	return pos - (uint8_t *) buf;
+}
+
+/** Encode rectangle using the encoding selected by the client.
+ *
+ * @param client Client
+ * @param rect Rectangle, its encoding type is filled in
+ * @param buf Output buffer or @c NULL
+ * @return Number of bytes written or, if @a buf is @c NULL, the maximum
+ *         number of bytes that can be written
+ */
+static size_t rfb_rect_encode(rfb_client_t *client, rfb_rectangle_t *rect,
+    void *buf)
 {
+	rect->enctype = client->encoding;
+
+	switch (client->encoding) {
+	case RFB_ENCODING_ZRLE:
+		return rfb_rect_encode_zrle(client, rect, buf);
+	case RFB_ENCODING_TRLE:
+		return rfb_rect_encode_trle(client, rect, buf);
+	default:
+		return rfb_rect_encode_raw(client, rect, buf);
+	}
+}
+
+/** Send framebuffer update with the damaged area to the client.
+ *
+ * Each rectangle of the damage region is sent as a separate rectangle
+ * of the update.
+ */
+static errno_t rfb_send_framebuffer_update(rfb_client_t *client)
+{
+	rfb_t *rfb = client->rfb;
+	rfb_rectangle_t rects[gfx_region_max_rects];
+	size_t nrects;
+	size_t i;
+
 	fibril_mutex_lock(&rfb->lock);
-	if (!incremental || !rfb->damage_valid) {
-		rfb->damage_rect.x = 0;
-		rfb->damage_rect.y = 0;
-		rfb->damage_rect.width = rfb->width;
-		rfb->damage_rect.height = rfb->height;
+
+	client->update_scheduled = false;
+	if (!client->update_requested ||
+	    gfx_region_is_empty(&client->damage)) {
+		fibril_mutex_unlock(&rfb->lock);
+		return EOK;
 	}
 
-	/* We send only single raw rectangle right now */
-	size_t buf_size = sizeof(rfb_framebuffer_update_t) +
-	    sizeof(rfb_rectangle_t) * 1 +
-	    rfb_rect_encode_raw(rfb, &rfb->damage_rect, NULL);
+	nrects = client->damage.count;
+	for (i = 0; i < nrects; i++) {
+		gfx_rect_t *drect = &client->damage.rects[i];
+
+		rects[i].x = drect->p0.x;
+		rects[i].y = drect->p0.y;
+		rects[i].width = drect->p1.x - drect->p0.x;
+		rects[i].height = drect->p1.y - drect->p0.y;
+	}
+
+	size_t buf_size = sizeof(rfb_framebuffer_update_t);
+	for (i = 0; i < nrects; i++) {
+		buf_size += sizeof(rfb_rectangle_t) +
+		    rfb_rect_encode(client, &rects[i], NULL);
+	}
 
 	void *buf = malloc(buf_size);
 	if (buf == NULL) {
 		fibril_mutex_unlock(&rfb->lock);
 		return ENOMEM;
 	}
-	memset(buf, 0, buf_size);
 
 	void *pos = buf;
 	rfb_framebuffer_update_t *fbu = buf;
 	fbu->message_type = RFB_SMSG_FRAMEBUFFER_UPDATE;
-	fbu->rect_count = 1;
+	fbu->pad = 0;
+	fbu->rect_count = nrects;
 	rfb_framebuffer_update_to_be(fbu, fbu);
 	pos += sizeof(rfb_framebuffer_update_t);
 
-	rfb_rectangle_t *rect = pos;
-	pos += sizeof(rfb_rectangle_t);
+	for (i = 0; i < nrects; i++) {
+		rfb_rectangle_t *rect = pos;
+		pos += sizeof(rfb_rectangle_t);
 
-	*rect = rfb->damage_rect;
+		*rect = rects[i];
+		size_t size = rfb_rect_encode(client, rect, pos);
+		if (size == 0 && rect->width > 0 && rect->height > 0) {
+			free(buf);
+			fibril_mutex_unlock(&rfb->lock);
+			return ENOMEM;
+		}
 
-	if (rfb->supports_trle) {
-		rect->enctype = RFB_ENCODING_TRLE;
-		pos += rfb_rect_encode_trle(rfb, rect, pos);
-	} else {
-		rect->enctype = RFB_ENCODING_RAW;
-		pos += rfb_rect_encode_raw(rfb, rect, pos);
+		pos += size;
+		rfb_rectangle_to_be(rect, rect);
 	}
-	rfb_rectangle_to_be(rect, rect);
 
-	rfb->damage_valid = false;
+	gfx_region_init(&client->damage);
+	client->update_requested = false;
 
 	size_t send_palette_size = 0;
 	void *send_palette = NULL;
 
-	if (!rfb->pixel_format.true_color) {
-		send_palette = rfb_send_palette_message(rfb, &send_palette_size);
+	if (!client->pixel_format.true_color) {
+		send_palette = rfb_send_palette_message(client,
+		    &send_palette_size);
 		if (send_palette == NULL) {
 			free(buf);
 			fibril_mutex_unlock(&rfb->lock);
@@ -546,39 +1039,80 @@ static errno_t rfb_send_framebuffer_update(rfb_t *rfb, tcp_conn_t *conn,
 
 	fibril_mutex_unlock(&rfb->lock);
 
-	if (!rfb->pixel_format.true_color) {
-		errno_t rc = tcp_conn_send(conn, send_palette, send_palette_size);
+	if (send_palette != NULL) {
+		errno_t rc = tcp_conn_send(client->conn, send_palette,
+		    send_palette_size);
+		free(send_palette);
 		if (rc != EOK) {
 			free(buf);
 			return rc;
 		}
 	}
 
-	errno_t rc = tcp_conn_send(conn, buf, buf_size);
+	errno_t rc = tcp_conn_send(client->conn, buf, pos - buf);
 	free(buf);
 
 	return rc;
 }
 
-static errno_t rfb_set_pixel_format(rfb_t *rfb, rfb_pixel_format_t *pixel_format)
+/** Client update timer handler. */
+static void rfb_client_update_timer(void *arg)
+{
+	rfb_client_t *client = (rfb_client_t *) arg;
+	errno_t rc;
+
+	rc = rfb_send_framebuffer_update(client);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN,
+		    "Failed sending framebuffer update: %s", str_error(rc));
+	}
+}
+
+/** Handle framebuffer update request.
+ *
+ * A non-incremental request adds the requested area to the damage.
+ * An incremental request is answered once there is some damage.
+ */
+static void rfb_framebuffer_update_request(rfb_client_t *client,
+    rfb_framebuffer_update_request_t *fbur)
 {
-	rfb->pixel_format = *pixel_format;
-	if (rfb->pixel_format.true_color) {
-		free(rfb->palette);
-		rfb->palette = NULL;
-		rfb->palette_used = 0;
+	gfx_rect_t rect;
+
+	fibril_mutex_lock(&client->rfb->lock);
+
+	client->update_requested = true;
+	if (!fbur->incremental) {
+		rect.p0.x = fbur->x;
+		rect.p0.y = fbur->y;
+		rect.p1.x = fbur->x + fbur->width;
+		rect.p1.y = fbur->y + fbur->height;
+		rfb_client_invalidate(client, &rect);
+	}
+
+	rfb_client_schedule_update(client);
+	fibril_mutex_unlock(&client->rfb->lock);
+}
+
+static errno_t rfb_set_pixel_format(rfb_client_t *client,
+    rfb_pixel_format_t *pixel_format)
+{
+	client->pixel_format = *pixel_format;
+	if (client->pixel_format.true_color) {
+		free(client->palette);
+		client->palette = NULL;
+		client->palette_used = 0;
 		log_msg(LOG_DEFAULT, LVL_DEBUG,
 		    "changed pixel format to %d-bit true color (%x<<%d, %x<<%d, %x<<%d)",
 		    pixel_format->depth, pixel_format->r_max, pixel_format->r_shift,
 		    pixel_format->g_max, pixel_format->g_shift, pixel_format->b_max,
 		    pixel_format->b_shift);
 	} else {
-		if (rfb->palette == NULL) {
-			rfb->palette = malloc(sizeof(pixel_t) * 256);
-			if (rfb->palette == NULL)
+		if (client->palette == NULL) {
+			client->palette = malloc(sizeof(pixel_t) * 256);
+			if (client->palette == NULL)
 				return ENOMEM;
-			memset(rfb->palette, 0, sizeof(pixel_t) * 256);
-			rfb->palette_used = 0;
+			memset(client->palette, 0, sizeof(pixel_t) * 256);
+			client->palette_used = 0;
 		}
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "changed pixel format to %d-bit palette",
 		    pixel_format->depth);
@@ -586,8 +1120,11 @@ static errno_t rfb_set_pixel_format(rfb_t *rfb, rfb_pixel_format_t *pixel_format
 	return EOK;
 }
 
-static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
+static void rfb_socket_connection(rfb_client_t *client)
 {
+	rfb_t *rfb = client->rfb;
+	tcp_conn_t *conn = client->conn;
+
 	/* Version handshake */
 	errno_t rc = tcp_conn_send(conn, "RFB 003.008\n", 12);
 	if (rc != EOK) {
@@ -597,7 +1134,7 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 	}
 
 	char client_version[12];
-	rc = recv_chars(conn, client_version, 12);
+	rc = recv_chars(client, client_version, 12);
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_WARN, "Failed receiving client version: %s",
 		    str_error(rc));
@@ -624,7 +1161,7 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 	}
 
 	char selected_sec_type = 0;
-	rc = recv_char(conn, &selected_sec_type);
+	rc = recv_char(client, &selected_sec_type);
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_WARN, "Failed receiving security type: %s",
 		    str_error(rc));
@@ -645,7 +1182,7 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 
 	/* Client init */
 	char shared_flag;
-	rc = recv_char(conn, &shared_flag);
+	rc = recv_char(client, &shared_flag);
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_WARN, "Failed receiving client init: %s",
 		    str_error(rc));
@@ -678,7 +1215,7 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 
 	while (true) {
 		char message_type = 0;
-		rc = recv_char(conn, &message_type);
+		rc = recv_char(client, &message_type);
 		if (rc != EOK) {
 			log_msg(LOG_DEFAULT, LVL_WARN,
 			    "Failed receiving client message type: %s",
@@ -694,7 +1231,8 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 		rfb_client_cut_text_t cct;
 		switch (message_type) {
 		case RFB_CMSG_SET_PIXEL_FORMAT:
-			rc = recv_message(conn, message_type, &spf, sizeof(spf));
+			rc = recv_message(client, message_type, &spf,
+			    sizeof(spf));
 			if (rc != EOK) {
 				log_msg(LOG_DEFAULT, LVL_WARN,
 				    "Failed receiving client message: %s",
@@ -704,13 +1242,14 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 			rfb_pixel_format_to_host(&spf.pixel_format, &spf.pixel_format);
 			log_msg(LOG_DEFAULT, LVL_DEBUG2, "Received SetPixelFormat message");
 			fibril_mutex_lock(&rfb->lock);
-			rc = rfb_set_pixel_format(rfb, &spf.pixel_format);
+			rc = rfb_set_pixel_format(client, &spf.pixel_format);
 			fibril_mutex_unlock(&rfb->lock);
 			if (rc != EOK)
 				return;
 			break;
 		case RFB_CMSG_SET_ENCODINGS:
-			rc = recv_message(conn, message_type, &se, sizeof(se));
+			rc = recv_message(client, message_type, &se,
+			    sizeof(se));
 			if (rc != EOK) {
 				log_msg(LOG_DEFAULT, LVL_WARN,
 				    "Failed receiving client message: %s",
@@ -719,21 +1258,36 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 			}
 			rfb_set_encodings_to_host(&se, &se);
 			log_msg(LOG_DEFAULT, LVL_DEBUG2, "Received SetEncodings message");
+
+			/* Use the first supported encoding the client prefers */
+			int32_t selected = RFB_ENCODING_RAW;
 			for (uint16_t i = 0; i < se.count; i++) {
 				int32_t encoding = 0;
-				rc = recv_chars(conn, (char *) &encoding, sizeof(int32_t));
+				rc = recv_chars(client, (char *) &encoding,
+				    sizeof(int32_t));
 				if (rc != EOK)
 					return;
 				encoding = uint32_t_be2host(encoding);
-				if (encoding == RFB_ENCODING_TRLE) {
+				if (selected != RFB_ENCODING_RAW)
+					continue;
+				if (encoding == RFB_ENCODING_ZRLE) {
+					log_msg(LOG_DEFAULT, LVL_DEBUG,
+					    "Using ZRLE encoding");
+					selected = encoding;
+				} else if (encoding == RFB_ENCODING_TRLE) {
 					log_msg(LOG_DEFAULT, LVL_DEBUG,
-					    "Client supports TRLE encoding");
-					rfb->supports_trle = true;
+					    "Using TRLE encoding");
+					selected = encoding;
 				}
 			}
+
+			fibril_mutex_lock(&rfb->lock);
+			client->encoding = selected;
+			fibril_mutex_unlock(&rfb->lock);
 			break;
 		case RFB_CMSG_FRAMEBUFFER_UPDATE_REQUEST:
-			rc = recv_message(conn, message_type, &fbur, sizeof(fbur));
+			rc = recv_message(client, message_type, &fbur,
+			    sizeof(fbur));
 			if (rc != EOK) {
 				log_msg(LOG_DEFAULT, LVL_WARN,
 				    "Failed receiving client message: %s",
@@ -743,10 +1297,11 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 			rfb_framebuffer_update_request_to_host(&fbur, &fbur);
 			log_msg(LOG_DEFAULT, LVL_DEBUG2,
 			    "Received FramebufferUpdateRequest message");
-			rfb_send_framebuffer_update(rfb, conn, fbur.incremental);
+			rfb_framebuffer_update_request(client, &fbur);
 			break;
 		case RFB_CMSG_KEY_EVENT:
-			rc = recv_message(conn, message_type, &ke, sizeof(ke));
+			rc = recv_message(client, message_type, &ke,
+			    sizeof(ke));
 			if (rc != EOK) {
 				log_msg(LOG_DEFAULT, LVL_WARN,
 				    "Failed receiving client message: %s",
@@ -757,7 +1312,8 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 			log_msg(LOG_DEFAULT, LVL_DEBUG2, "Received KeyEvent message");
 			break;
 		case RFB_CMSG_POINTER_EVENT:
-			rc = recv_message(conn, message_type, &pe, sizeof(pe));
+			rc = recv_message(client, message_type, &pe,
+			    sizeof(pe));
 			if (rc != EOK) {
 				log_msg(LOG_DEFAULT, LVL_WARN,
 				    "Failed receiving client message: %s",
@@ -768,7 +1324,8 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 			log_msg(LOG_DEFAULT, LVL_DEBUG2, "Received PointerEvent message");
 			break;
 		case RFB_CMSG_CLIENT_CUT_TEXT:
-			rc = recv_message(conn, message_type, &cct, sizeof(cct));
+			rc = recv_message(client, message_type, &cct,
+			    sizeof(cct));
 			if (rc != EOK) {
 				log_msg(LOG_DEFAULT, LVL_WARN,
 				    "Failed receiving client message: %s",
@@ -777,7 +1334,9 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 			}
 			rfb_client_cut_text_to_host(&cct, &cct);
 			log_msg(LOG_DEFAULT, LVL_DEBUG2, "Received ClientCutText message");
-			recv_skip_chars(conn, cct.length);
+			rc = recv_skip_chars(client, cct.length);
+			if (rc != EOK)
+				return;
 			break;
 		default:
 			log_msg(LOG_DEFAULT, LVL_WARN,
@@ -823,10 +1382,41 @@ error:
 static void rfb_new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
 {
 	rfb_t *rfb = (rfb_t *)tcp_listener_userptr(lst);
+	rfb_client_t *client;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Connection accepted");
 
-	rbuf_out = 0;
-	rbuf_in = 0;
+	client = calloc(1, sizeof(rfb_client_t));
+	if (client == NULL) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Out of memory.");
+		return;
+	}
+
+	client->update_timer = fibril_timer_create(&rfb->lock);
+	if (client->update_timer == NULL) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Out of memory.");
+		free(client);
+		return;
+	}
+
+	client->rfb = rfb;
+	client->conn = conn;
+	client->encoding = RFB_ENCODING_RAW;
+	gfx_region_init(&client->damage);
+
+	fibril_mutex_lock(&rfb->lock);
+	client->pixel_format = rfb->pixel_format;
+	list_append(&client->link, &rfb->clients);
+	fibril_mutex_unlock(&rfb->lock);
+
+	rfb_socket_connection(client);
+
+	fibril_mutex_lock(&rfb->lock);
+	list_remove(&client->link);
+	(void) fibril_timer_clear_locked(client->update_timer);
+	fibril_mutex_unlock(&rfb->lock);
 
-	rfb_socket_connection(rfb, conn);
+	fibril_timer_destroy(client->update_timer);
+	free(client->palette);
+	free(client);
 }
@@ -29,9 +29,12 @@
 #ifndef RFB_H__
 #define RFB_H__
 
+#include <adt/list.h>
 #include <inet/tcp.h>
 #include <io/pixelmap.h>
 #include <fibril_synch.h>
+#include <types/gfx/coord.h>
+#include <types/gfx/region.h>
 
 #define RFB_SECURITY_NONE 1
 #define RFB_SECURITY_HANDSHAKE_OK 0
@@ -50,10 +53,22 @@
 
 #define RFB_ENCODING_RAW 0
 #define RFB_ENCODING_TRLE 15
+#define RFB_ENCODING_ZRLE 16
 
 #define RFB_TILE_ENCODING_RAW 0
 #define RFB_TILE_ENCODING_SOLID 1
 
+#define RFB_ZRLE_TILE_SIZE 64
+#define RFB_ZRLE_RAW 0
+#define RFB_ZRLE_SOLID 1
+#define RFB_ZRLE_PACKED_PALETTE_MAX 16
+#define RFB_ZRLE_PLAIN_RLE 128
+#define RFB_ZRLE_PALETTE_RLE 128
+#define RFB_ZRLE_PALETTE_RLE_MAX 127
+
+/** Size of the per-connection receive buffer */
+#define RFB_RBUF_SIZE 1024
+
 typedef struct {
 	uint8_t bpp;
 	uint8_t depth;
@@ -154,16 +169,40 @@ typedef struct {
 	tcp_t *tcp;
 	tcp_listener_t *lst;
 	pixelmap_t framebuffer;
-	rfb_rectangle_t damage_rect;
-	bool damage_valid;
 	fibril_mutex_t lock;
+	list_t clients;
+} rfb_t;
+
+/** RFB client connection */
+typedef struct {
+	/** Link to rfb_t.clients */
+	link_t link;
+	rfb_t *rfb;
+	tcp_conn_t *conn;
+	/** Receive buffer */
+	char rbuf[RFB_RBUF_SIZE];
+	size_t rbuf_out;
+	size_t rbuf_in;
+	/** Pixel format requested by the client */
+	rfb_pixel_format_t pixel_format;
 	pixel_t *palette;
 	size_t palette_used;
-	bool supports_trle;
-} rfb_t;
+	/** Encoding used for framebuffer updates */
+	int32_t encoding;
+	/** Area changed since the last update sent to the client */
+	gfx_region_t damage;
+	/** Client is waiting for a framebuffer update */
+	bool update_requested;
+	/** Update timer is set */
+	bool update_scheduled;
+	fibril_timer_t *update_timer;
+	/** ZLIB stream header has been sent */
+	bool zrle_started;
+} rfb_client_t;
 
 extern errno_t rfb_init(rfb_t *, uint16_t, uint16_t, const char *);
 extern errno_t rfb_set_size(rfb_t *, uint16_t, uint16_t);
 extern errno_t rfb_listen(rfb_t *, uint16_t);
+extern void rfb_invalidate(rfb_t *, gfx_rect_t *);
 
 #endif
@@ -110,9 +110,12 @@ errno_t category_add_service(category_t *cat, loc_service_t *svc)
 	assert(fibril_mutex_is_locked(&cat->mutex));
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 
-	/* Verify that category does not contain this service yet. */
-	list_foreach(cat->svc_memb, cat_link, svc_categ_t, memb) {
-		if (memb->svc == svc) {
+	/*
+	 * Verify that category does not contain this service yet. A service
+	 * is in few categories, while a category can contain many services.
+	 */
+	list_foreach(svc->cat_memb, svc_link, svc_categ_t, memb) {
+		if (memb->cat == cat) {
 			return EEXIST;
 		}
 	}
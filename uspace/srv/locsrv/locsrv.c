@@ -35,6 +35,8 @@
 /** @file
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <ipc/services.h>
 #include <ns.h>
 #include <async.h>
@@ -65,6 +67,21 @@ LIST_INITIALIZE(services_list);
 LIST_INITIALIZE(namespaces_list);
 LIST_INITIALIZE(servers_list);
 
+/*
+ * Indexes of services_list and namespaces_list, protected by
+ * services_list_mutex as well.
+ */
+static hash_table_t services_by_id;
+static hash_table_t services_by_name;
+static hash_table_t namespaces_by_id;
+static hash_table_t namespaces_by_name;
+
+/** Key of services_by_name */
+typedef struct {
+	const char *ns_name;
+	const char *name;
+} loc_service_key_t;
+
 /*
  * Locking order:
  *  servers_list_mutex
@@ -180,34 +197,156 @@ static bool loc_fqsn_split(const char *fqsn, char **ns_name, char **name)
 	return true;
 }
 
+static size_t loc_name_hash(const char *name)
+{
+	size_t hash = 0;
+
+	while (*name != '\0')
+		hash = hash * 31 + (uint8_t) *name++;
+
+	return hash_mix(hash);
+}
+
+static size_t loc_id_key_hash(const void *key)
+{
+	const service_id_t *id = key;
+	return hash_mix(*id);
+}
+
+static size_t namespaces_by_id_hash(const ht_link_t *item)
+{
+	loc_namespace_t *namespace = hash_table_get_inst(item,
+	    loc_namespace_t, id_link);
+	return loc_id_key_hash(&namespace->id);
+}
+
+static bool namespaces_by_id_key_equal(const void *key,
+    const ht_link_t *item)
+{
+	const service_id_t *id = key;
+	loc_namespace_t *namespace = hash_table_get_inst(item,
+	    loc_namespace_t, id_link);
+	return namespace->id == *id;
+}
+
+static size_t namespaces_by_name_key_hash(const void *key)
+{
+	return loc_name_hash((const char *) key);
+}
+
+static size_t namespaces_by_name_hash(const ht_link_t *item)
+{
+	loc_namespace_t *namespace = hash_table_get_inst(item,
+	    loc_namespace_t, name_link);
+	return loc_name_hash(namespace->name);
+}
+
+static bool namespaces_by_name_key_equal(const void *key,
+    const ht_link_t *item)
+{
+	loc_namespace_t *namespace = hash_table_get_inst(item,
+	    loc_namespace_t, name_link);
+	return str_cmp(namespace->name, (const char *) key) == 0;
+}
+
+static size_t services_by_id_hash(const ht_link_t *item)
+{
+	loc_service_t *service = hash_table_get_inst(item, loc_service_t,
+	    id_link);
+	return loc_id_key_hash(&service->id);
+}
+
+static bool services_by_id_key_equal(const void *key, const ht_link_t *item)
+{
+	const service_id_t *id = key;
+	loc_service_t *service = hash_table_get_inst(item, loc_service_t,
+	    id_link);
+	return service->id == *id;
+}
+
+static size_t services_by_name_key_hash(const void *key)
+{
+	const loc_service_key_t *skey = key;
+	return hash_combine(loc_name_hash(skey->ns_name),
+	    loc_name_hash(skey->name));
+}
+
+static size_t services_by_name_hash(const ht_link_t *item)
+{
+	loc_service_t *service = hash_table_get_inst(item, loc_service_t,
+	    name_link);
+	loc_service_key_t skey = {
+		.ns_name = service->namespace->name,
+		.name = service->name
+	};
+
+	return services_by_name_key_hash(&skey);
+}
+
+static bool services_by_name_key_equal(const void *key,
+    const ht_link_t *item)
+{
+	const loc_service_key_t *skey = key;
+	loc_service_t *service = hash_table_get_inst(item, loc_service_t,
+	    name_link);
+	return (str_cmp(service->namespace->name, skey->ns_name) == 0) &&
+	    (str_cmp(service->name, skey->name) == 0);
+}
+
+static const hash_table_ops_t namespaces_by_id_ops = {
+	.hash = namespaces_by_id_hash,
+	.key_hash = loc_id_key_hash,
+	.key_equal = namespaces_by_id_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static const hash_table_ops_t namespaces_by_name_ops = {
+	.hash = namespaces_by_name_hash,
+	.key_hash = namespaces_by_name_key_hash,
+	.key_equal = namespaces_by_name_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static const hash_table_ops_t services_by_id_ops = {
+	.hash = services_by_id_hash,
+	.key_hash = loc_id_key_hash,
+	.key_equal = services_by_id_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static const hash_table_ops_t services_by_name_ops = {
+	.hash = services_by_name_hash,
+	.key_hash = services_by_name_key_hash,
+	.key_equal = services_by_name_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
 /** Find namespace with given name. */
 static loc_namespace_t *loc_namespace_find_name(const char *name)
 {
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 
-	list_foreach(namespaces_list, namespaces, loc_namespace_t, namespace) {
-		if (str_cmp(namespace->name, name) == 0)
-			return namespace;
-	}
+	ht_link_t *link = hash_table_find(&namespaces_by_name, name);
+	if (link == NULL)
+		return NULL;
 
-	return NULL;
+	return hash_table_get_inst(link, loc_namespace_t, name_link);
 }
 
-/** Find namespace with given ID.
- *
- * @todo: use hash table
- *
- */
+/** Find namespace with given ID. */
 static loc_namespace_t *loc_namespace_find_id(service_id_t id)
 {
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 
-	list_foreach(namespaces_list, namespaces, loc_namespace_t, namespace) {
-		if (namespace->id == id)
-			return namespace;
-	}
+	ht_link_t *link = hash_table_find(&namespaces_by_id, &id);
+	if (link == NULL)
+		return NULL;
 
-	return NULL;
+	return hash_table_get_inst(link, loc_namespace_t, id_link);
 }
 
 /** Find service with given name. */
@@ -216,30 +355,41 @@ static loc_service_t *loc_service_find_name(const char *ns_name,
 {
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 
-	list_foreach(services_list, services, loc_service_t, service) {
-		if ((str_cmp(service->namespace->name, ns_name) == 0) &&
-		    (str_cmp(service->name, name) == 0))
-			return service;
-	}
+	loc_service_key_t skey = {
+		.ns_name = ns_name,
+		.name = name
+	};
+
+	ht_link_t *link = hash_table_find(&services_by_name, &skey);
+	if (link == NULL)
+		return NULL;
 
-	return NULL;
+	return hash_table_get_inst(link, loc_service_t, name_link);
 }
 
-/** Find service with given ID.
- *
- * @todo: use hash table
- *
- */
+/** Find service with given ID. */
 static loc_service_t *loc_service_find_id(service_id_t id)
 {
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 
-	list_foreach(services_list, services, loc_service_t, service) {
-		if (service->id == id)
-			return service;
-	}
+	ht_link_t *link = hash_table_find(&services_by_id, &id);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, loc_service_t, id_link);
+}
 
-	return NULL;
+/** Insert service into list of all services and its indexes.
+ *
+ * The service must already have its ID, name and namespace.
+ */
+static void loc_service_insert(loc_service_t *service)
+{
+	assert(fibril_mutex_is_locked(&services_list_mutex));
+
+	list_append(&service->services, &services_list);
+	hash_table_insert(&services_by_id, &service->id_link);
+	hash_table_insert(&services_by_name, &service->name_link);
 }
 
 /** Create a namespace (if not already present). */
@@ -270,6 +420,8 @@ static loc_namespace_t *loc_namespace_create(const char *ns_name)
 	 * Insert new namespace into list of registered namespaces
 	 */
 	list_append(&(namespace->namespaces), &namespaces_list);
+	hash_table_insert(&namespaces_by_id, &namespace->id_link);
+	hash_table_insert(&namespaces_by_name, &namespace->name_link);
 
 	return namespace;
 }
@@ -281,6 +433,9 @@ static void loc_namespace_destroy(loc_namespace_t *namespace)
 
 	if (namespace->refcnt == 0) {
 		list_remove(&(namespace->namespaces));
+		hash_table_remove_item(&namespaces_by_id, &namespace->id_link);
+		hash_table_remove_item(&namespaces_by_name,
+		    &namespace->name_link);
 
 		free(namespace->name);
 		free(namespace);
@@ -312,8 +467,12 @@ static void loc_service_unregister_core(loc_service_t *service)
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 	assert(fibril_mutex_is_locked(&cdir.mutex));
 
-	loc_namespace_delref(service->namespace);
+	/* The name index hashes the namespace name, remove it first. */
+	hash_table_remove_item(&services_by_id, &service->id_link);
+	hash_table_remove_item(&services_by_name, &service->name_link);
 	list_remove(&(service->services));
+
+	loc_namespace_delref(service->namespace);
 	list_remove(&(service->server_services));
 
 	/* Remove service from all categories. */
@@ -524,7 +683,7 @@ static void loc_service_register(ipc_call_t *icall, loc_server_t *server)
 	service->server = server;
 
 	/* Insert service into list of all services  */
-	list_append(&service->services, &services_list);
+	loc_service_insert(service);
 
 	/* Insert service into list of services supplied by one server */
 	fibril_mutex_lock(&service->server->services_mutex);
@@ -926,6 +1085,85 @@ cleanup:
 	free(name);
 }
 
+/** Get IDs, names and server names of all services in a category.
+ *
+ * Like loc_category_get_svcs(), the size of the complete list is returned
+ * in the answer even if the buffer of the client is too small.
+ */
+static void loc_category_get_svc_descs(ipc_call_t *icall)
+{
+	ipc_call_t call;
+	size_t size;
+	size_t act_size;
+	size_t cnt;
+	size_t pos;
+
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(&call, EREFUSED);
+		async_answer_0(icall, EREFUSED);
+		return;
+	}
+
+	if ((size % sizeof(loc_svc_desc_t)) != 0) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	fibril_mutex_lock(&services_list_mutex);
+	fibril_mutex_lock(&cdir.mutex);
+
+	category_t *cat = category_get(&cdir, ipc_get_arg1(icall));
+	if (cat == NULL) {
+		fibril_mutex_unlock(&cdir.mutex);
+		fibril_mutex_unlock(&services_list_mutex);
+		async_answer_0(&call, ENOENT);
+		async_answer_0(icall, ENOENT);
+		return;
+	}
+
+	loc_svc_desc_t *desc = NULL;
+	if (size > 0) {
+		desc = malloc(size);
+		if (desc == NULL) {
+			fibril_mutex_unlock(&cdir.mutex);
+			fibril_mutex_unlock(&services_list_mutex);
+			async_answer_0(&call, ENOMEM);
+			async_answer_0(icall, ENOMEM);
+			return;
+		}
+	}
+
+	fibril_mutex_lock(&cat->mutex);
+
+	cnt = size / sizeof(loc_svc_desc_t);
+	pos = 0;
+	list_foreach(cat->svc_memb, cat_link, svc_categ_t, memb) {
+		loc_service_t *svc = memb->svc;
+
+		if (pos < cnt) {
+			desc[pos].id = svc->id;
+			snprintf(desc[pos].name, sizeof(desc[pos].name), "%s/%s",
+			    svc->namespace->name, svc->name);
+			str_cpy(desc[pos].server, sizeof(desc[pos].server),
+			    svc->server != NULL ? svc->server->name : "");
+		}
+
+		pos++;
+	}
+
+	fibril_mutex_unlock(&cat->mutex);
+	fibril_mutex_unlock(&cdir.mutex);
+	fibril_mutex_unlock(&services_list_mutex);
+
+	act_size = pos * sizeof(loc_svc_desc_t);
+	errno_t retval = async_data_read_finalize(&call, desc,
+	    min(size, act_size));
+	free(desc);
+
+	async_answer_1(icall, retval, act_size);
+}
+
 static void loc_id_probe(ipc_call_t *icall)
 {
 	fibril_mutex_lock(&services_list_mutex);
@@ -948,7 +1186,7 @@ static void loc_id_probe(ipc_call_t *icall)
 static void loc_get_namespace_count(ipc_call_t *icall)
 {
 	fibril_mutex_lock(&services_list_mutex);
-	async_answer_1(icall, EOK, list_count(&namespaces_list));
+	async_answer_1(icall, EOK, hash_table_size(&namespaces_by_id));
 	fibril_mutex_unlock(&services_list_mutex);
 }
 
@@ -1024,7 +1262,7 @@ static void loc_get_namespaces(ipc_call_t *icall)
 	fibril_mutex_lock(&services_list_mutex);
 
 	size_t count = size / sizeof(loc_sdesc_t);
-	if (count != list_count(&namespaces_list)) {
+	if (count != hash_table_size(&namespaces_by_id)) {
 		fibril_mutex_unlock(&services_list_mutex);
 		async_answer_0(&call, EOVERFLOW);
 		async_answer_0(icall, EOVERFLOW);
@@ -1234,7 +1472,7 @@ static void loc_null_create(ipc_call_t *icall)
 	 * Insert service into a dummy list of null server's services so that it
 	 * can be safely removed later.
 	 */
-	list_append(&service->services, &services_list);
+	loc_service_insert(service);
 	list_append(&service->server_services, &dummy_null_services);
 	null_services[i] = service;
 
@@ -1324,6 +1562,17 @@ static bool loc_init(void)
 	for (i = 0; i < NULL_SERVICES; i++)
 		null_services[i] = NULL;
 
+	if (!hash_table_create(&services_by_id, 0, 0, &services_by_id_ops) ||
+	    !hash_table_create(&services_by_name, 0, 0,
+	    &services_by_name_ops) ||
+	    !hash_table_create(&namespaces_by_id, 0, 0,
+	    &namespaces_by_id_ops) ||
+	    !hash_table_create(&namespaces_by_name, 0, 0,
+	    &namespaces_by_name_ops)) {
+		printf("%s: Out of memory\n", NAME);
+		return false;
+	}
+
 	categ_dir_init(&cdir);
 
 	cat = category_new("disk");
@@ -1501,6 +1750,9 @@ static void loc_connection_consumer(ipc_call_t *icall, void *arg)
 		case LOC_CATEGORY_GET_SVCS:
 			loc_category_get_svcs(&call);
 			break;
+		case LOC_CATEGORY_GET_SVC_DESCS:
+			loc_category_get_svc_descs(&call);
+			break;
 		case LOC_ID_PROBE:
 			loc_id_probe(&call);
 			break;
@@ -29,6 +29,8 @@
 /** @addtogroup logger
  * @{
  */
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <assert.h>
 #include <errno.h>
 #include <stdio.h>
@@ -39,6 +41,48 @@
 static FIBRIL_MUTEX_INITIALIZE(log_list_guard);
 static LIST_INITIALIZE(log_list);
 
+/** Logs indexed by their IDs (protected by log_list_guard) */
+static hash_table_t log_by_id;
+
+static size_t log_id_key_hash(const void *key)
+{
+	const sysarg_t *id = key;
+	return hash_mix(*id);
+}
+
+static size_t log_id_hash(const ht_link_t *item)
+{
+	logger_log_t *log = hash_table_get_inst(item, logger_log_t, id_link);
+	return hash_mix((sysarg_t) log);
+}
+
+static bool log_id_key_equal(const void *key, const ht_link_t *item)
+{
+	const sysarg_t *id = key;
+	logger_log_t *log = hash_table_get_inst(item, logger_log_t, id_link);
+	return (sysarg_t) log == *id;
+}
+
+static hash_table_ops_t log_by_id_ops = {
+	.hash = log_id_hash,
+	.key_hash = log_id_key_hash,
+	.key_equal = log_id_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Initialize the list of logs.
+ *
+ * @return EOK on success, ENOMEM if out of memory.
+ */
+errno_t logs_init(void)
+{
+	if (!hash_table_create(&log_by_id, 0, 0, &log_by_id_ops))
+		return ENOMEM;
+
+	return EOK;
+}
+
 static logger_log_t *find_log_by_name_and_parent_no_list_lock(const char *name, logger_log_t *parent)
 {
 	list_foreach(log_list, link, logger_log_t, log) {
@@ -59,6 +103,7 @@ static errno_t create_dest(const char *name, logger_dest_t **dest)
 		return ENOMEM;
 	}
 	result->logfile = NULL;
+	result->dirty = false;
 	fibril_mutex_initialize(&result->guard);
 	*dest = result;
 	return EOK;
@@ -122,6 +167,7 @@ logger_log_t *find_or_create_log_and_lock(const char *name, sysarg_t parent_id)
 		if (result == NULL)
 			goto leave;
 		list_append(&result->link, &log_list);
+		hash_table_insert(&log_by_id, &result->id_link);
 		if (result->parent != NULL) {
 			fibril_mutex_lock(&result->parent->guard);
 			result->parent->ref_counter++;
@@ -157,14 +203,13 @@ logger_log_t *find_log_by_name_and_lock(const char *name)
 logger_log_t *find_log_by_id_and_lock(sysarg_t id)
 {
 	logger_log_t *result = NULL;
+	ht_link_t *link;
 
 	fibril_mutex_lock(&log_list_guard);
-	list_foreach(log_list, link, logger_log_t, log) {
-		if ((sysarg_t) log == id) {
-			fibril_mutex_lock(&log->guard);
-			result = log;
-			break;
-		}
+	link = hash_table_find(&log_by_id, &id);
+	if (link != NULL) {
+		result = hash_table_get_inst(link, logger_log_t, id_link);
+		fibril_mutex_lock(&result->guard);
 	}
 	fibril_mutex_unlock(&log_list_guard);
 
@@ -256,6 +301,7 @@ void log_release(logger_log_t *log)
 	assert(log->ref_counter == 0);
 
 	list_remove(&log->link);
+	hash_table_remove_item(&log_by_id, &log->id_link);
 	fibril_mutex_unlock(&log_list_guard);
 	fibril_mutex_unlock(&log->guard);
 
@@ -282,6 +328,16 @@ void log_release(logger_log_t *log)
 	free(log);
 }
 
+/** Write message to the log destination.
+ *
+ * The message is buffered, use flush_log() to write it out.
+ *
+ * Precondition: log is locked.
+ *
+ * @param log Log to write to.
+ * @param level Message level.
+ * @param message The message.
+ */
 void write_to_log(logger_log_t *log, log_level_t level, const char *message)
 {
 	assert(fibril_mutex_is_locked(&log->guard));
@@ -294,7 +350,27 @@ void write_to_log(logger_log_t *log, log_level_t level, const char *message)
 		fprintf(log->dest->logfile, "[%s] %s: %s\n",
 		    log->full_name, log_level_str(level),
 		    (const char *) message);
+		log->dest->dirty = true;
+	}
+
+	fibril_mutex_unlock(&log->dest->guard);
+}
+
+/** Flush messages buffered for the log destination.
+ *
+ * Precondition: log is locked.
+ *
+ * @param log Log to flush.
+ */
+void flush_log(logger_log_t *log)
+{
+	assert(fibril_mutex_is_locked(&log->guard));
+	assert(log->dest != NULL);
+	fibril_mutex_lock(&log->dest->guard);
+
+	if (log->dest->dirty) {
 		fflush(log->dest->logfile);
+		log->dest->dirty = false;
 	}
 
 	fibril_mutex_unlock(&log->dest->guard);
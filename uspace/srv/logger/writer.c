@@ -45,8 +45,95 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <str_error.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include "logger.h"
 
+/** Maximum number of messages waiting to be written. */
+#define LOGGER_QUEUE_MAX 1024
+
+/** Message waiting to be written. */
+typedef struct {
+	/** Link to msg_queue */
+	link_t link;
+	/** Log (we hold a reference) */
+	logger_log_t *log;
+	/** Message level */
+	log_level_t level;
+	/** Message text */
+	char *message;
+} logger_msg_t;
+
+static FIBRIL_MUTEX_INITIALIZE(msg_queue_lock);
+static FIBRIL_CONDVAR_INITIALIZE(msg_queue_cv);
+static FIBRIL_CONDVAR_INITIALIZE(msg_queue_space_cv);
+static LIST_INITIALIZE(msg_queue);
+static size_t msg_queue_len;
+
+/** Log writer fibril.
+ *
+ * Takes all queued messages at once, writes them out and then flushes
+ * each log destination once per batch instead of once per message.
+ */
+static errno_t logger_writer_fibril(void *arg)
+{
+	list_t batch;
+
+	(void) arg;
+	list_initialize(&batch);
+
+	while (true) {
+		fibril_mutex_lock(&msg_queue_lock);
+		while (list_empty(&msg_queue))
+			fibril_condvar_wait(&msg_queue_cv, &msg_queue_lock);
+
+		list_concat(&batch, &msg_queue);
+		msg_queue_len = 0;
+		fibril_condvar_broadcast(&msg_queue_space_cv);
+		fibril_mutex_unlock(&msg_queue_lock);
+
+		list_foreach(batch, link, logger_msg_t, msg) {
+			fibril_mutex_lock(&msg->log->guard);
+			KLOG_PRINTF(msg->level, "[%s] %s: %s",
+			    msg->log->full_name, log_level_str(msg->level),
+			    msg->message);
+			write_to_log(msg->log, msg->level, msg->message);
+			log_unlock(msg->log);
+		}
+
+		while (!list_empty(&batch)) {
+			logger_msg_t *msg = list_get_instance(list_first(&batch),
+			    logger_msg_t, link);
+			list_remove(&msg->link);
+
+			fibril_mutex_lock(&msg->log->guard);
+			flush_log(msg->log);
+			log_release(msg->log);
+
+			free(msg->message);
+			free(msg);
+		}
+	}
+
+	return EOK;
+}
+
+/** Start the log writer fibril.
+ *
+ * @return EOK on success, ENOMEM if out of memory.
+ */
+errno_t logger_writer_init(void)
+{
+	fid_t fid;
+
+	fid = fibril_create(logger_writer_fibril, NULL);
+	if (fid == 0)
+		return ENOMEM;
+
+	fibril_add_ready(fid);
+	return EOK;
+}
+
 static logger_log_t *handle_create_log(sysarg_t parent)
 {
 	void *name;
@@ -77,12 +164,39 @@ static errno_t handle_receive_message(sysarg_t log_id, sysarg_t level)
 		goto leave;
 	}
 
-	KLOG_PRINTF(level, "[%s] %s: %s",
-	    log->full_name, log_level_str(level),
-	    (const char *) message);
-	write_to_log(log, level, message);
+	logger_msg_t *msg = calloc(1, sizeof(logger_msg_t));
+	if (msg == NULL) {
+		/* Write the message synchronously */
+		KLOG_PRINTF(level, "[%s] %s: %s",
+		    log->full_name, log_level_str(level),
+		    (const char *) message);
+		write_to_log(log, level, message);
+		flush_log(log);
+		rc = EOK;
+		goto leave;
+	}
+
+	/* The queued message holds a reference to the log */
+	log->ref_counter++;
+	log_unlock(log);
+
+	msg->log = log;
+	msg->level = level;
+	msg->message = message;
+	link_initialize(&msg->link);
+
+	fibril_mutex_lock(&msg_queue_lock);
+	while (msg_queue_len >= LOGGER_QUEUE_MAX) {
+		fibril_condvar_wait(&msg_queue_space_cv,
+		    &msg_queue_lock);
+	}
+
+	list_append(&msg->link, &msg_queue);
+	++msg_queue_len;
+	fibril_condvar_signal(&msg_queue_cv);
+	fibril_mutex_unlock(&msg_queue_lock);
 
-	rc = EOK;
+	return EOK;
 
 leave:
 	log_unlock(log);
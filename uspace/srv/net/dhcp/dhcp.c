@@ -46,32 +46,38 @@
 #include <inet/inetcfg.h>
 #include <io/log.h>
 #include <loc.h>
+#include <macros.h>
 #include <rndgen.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
+#include <time.h>
 
 #include "dhcp.h"
 #include "dhcp_std.h"
+#include "lease.h"
 #include "transport.h"
 
 enum {
-	/** In microseconds */
-	dhcp_discover_timeout_val = 5 * 1000 * 1000,
-	/** In microseconds */
-	dhcp_request_timeout_val = 1 * 1000 * 1000,
+	/** Initial retransmission delay in microseconds */
+	dhcp_retry_initial_val = 1000 * 1000,
+	/** Maximum retransmission delay in microseconds */
+	dhcp_retry_max_val = 16 * 1000 * 1000,
+	/** Maximum random part of retransmission delay in microseconds */
+	dhcp_retry_jitter_val = 250 * 1000,
 	dhcp_discover_retries = 5,
-	dhcp_request_retries = 3
+	dhcp_request_retries = 3,
+	dhcp_reboot_retries = 2
 };
 
-#define MAX_MSG_SIZE 1024
-static uint8_t msgbuf[MAX_MSG_SIZE];
-
 /** List of registered links (of dhcp_link_t) */
 static list_t dhcp_links;
+/** Protects dhcp_links */
+static FIBRIL_MUTEX_INITIALIZE(dhcp_links_lock);
 
 static void dhcpsrv_discover_timeout(void *);
 static void dhcpsrv_request_timeout(void *);
+static void dhcpsrv_reboot_timeout(void *);
 
 typedef enum {
 	ds_bound,
@@ -95,10 +101,20 @@ typedef struct {
 	inet_addr_t router;
 	/** DNS server */
 	inet_addr_t dns_server;
+	/** Lease time in seconds or zero if not known */
+	uint32_t lease_time;
+	/** Server committed the lease right away (RFC 4039) */
+	bool rapid_commit;
 	/** Transaction ID */
 	uint32_t xid;
 } dhcp_offer_t;
 
+/** DHCP link.
+ *
+ * Each link runs its own state machine, driven by received messages and
+ * by its timer, so that links are configured concurrently. The state
+ * machine runs with @c lock held.
+ */
 typedef struct {
 	/** Link to dhcp_links list */
 	link_t links;
@@ -108,16 +124,32 @@ typedef struct {
 	inet_link_info_t link_info;
 	/** Transport */
 	dhcp_transport_t dt;
+	/** Protects the link state */
+	fibril_mutex_t lock;
 	/** Transport timeout */
 	fibril_timer_t *timeout;
 	/** Number of retries */
 	int retries_left;
+	/** Next retransmission delay in microseconds */
+	usec_t retry_delay;
 	/** Link state */
 	dhcp_state_t state;
+	/** Transaction ID of the exchange in progress */
+	uint32_t xid;
 	/** Last received offer */
 	dhcp_offer_t offer;
+	/** @c true if the address (and route) have been configured */
+	bool configured;
+	/** Configured address object */
+	sysarg_t addr_id;
+	/** Configured address */
+	inet_naddr_t cfg_addr;
+	/** Configured default route or zero if none */
+	sysarg_t sroute_id;
 	/** Random number generator */
 	rndgen_t *rndgen;
+	/** Buffer for messages being sent */
+	uint8_t msgbuf[DHCP_MSG_BUF_SIZE];
 } dhcp_link_t;
 
 static void dhcpsrv_recv(void *, void *, size_t);
@@ -154,33 +186,24 @@ static uint32_t dhcp_uint32_decode(uint8_t *data)
 	    ((uint32_t)data[3]);
 }
 
-static errno_t dhcp_send_discover(dhcp_link_t *dlink)
+/** Fill in the fixed part of a request to send on the link. */
+static void dhcp_hdr_init(dhcp_link_t *dlink, dhcp_hdr_t *hdr)
 {
-	dhcp_hdr_t *hdr = (dhcp_hdr_t *)msgbuf;
-	uint8_t *opt = msgbuf + sizeof(dhcp_hdr_t);
-	uint32_t xid;
-	errno_t rc;
-	size_t i;
-
-	rc = rndgen_uint32(dlink->rndgen, &xid);
-	if (rc != EOK)
-		return rc;
-
-	memset(msgbuf, 0, MAX_MSG_SIZE);
+	memset(dlink->msgbuf, 0, DHCP_MSG_BUF_SIZE);
 	hdr->op = op_bootrequest;
 	hdr->htype = 1; /* AHRD_ETHERNET */
 	hdr->hlen = ETH_ADDR_SIZE;
-	hdr->xid = host2uint32_t_be(xid);
+	hdr->xid = host2uint32_t_be(dlink->xid);
 	hdr->flags = host2uint16_t_be(flag_broadcast);
 
 	eth_addr_encode(&dlink->link_info.mac_addr, hdr->chaddr);
 	hdr->opt_magic = host2uint32_t_be(dhcp_opt_magic);
+}
 
-	i = 0;
-
-	opt[i++] = opt_msg_type;
-	opt[i++] = 1;
-	opt[i++] = msg_dhcpdiscover;
+/** Encode parameter request list option. */
+static size_t dhcp_param_req_encode(uint8_t *opt)
+{
+	size_t i = 0;
 
 	opt[i++] = opt_param_req_list;
 	opt[i++] = 3;
@@ -188,25 +211,65 @@ static errno_t dhcp_send_discover(dhcp_link_t *dlink)
 	opt[i++] = 6; /* DNS server */
 	opt[i++] = 3; /* router */
 
+	return i;
+}
+
+/** Encode IPv4 address option. */
+static size_t dhcp_addr_opt_encode(uint8_t *opt, enum dhcp_option_code code,
+    addr32_t addr)
+{
+	size_t i = 0;
+
+	opt[i++] = code;
+	opt[i++] = 4;
+	opt[i++] = addr >> 24;
+	opt[i++] = (addr >> 16) & 0xff;
+	opt[i++] = (addr >> 8) & 0xff;
+	opt[i++] = addr & 0xff;
+
+	return i;
+}
+
+static errno_t dhcp_send_discover(dhcp_link_t *dlink)
+{
+	dhcp_hdr_t *hdr = (dhcp_hdr_t *)dlink->msgbuf;
+	uint8_t *opt = dlink->msgbuf + sizeof(dhcp_hdr_t);
+	size_t i;
+
+	dhcp_hdr_init(dlink, hdr);
+
+	i = 0;
+
+	opt[i++] = opt_msg_type;
+	opt[i++] = 1;
+	opt[i++] = msg_dhcpdiscover;
+
+	i += dhcp_param_req_encode(&opt[i]);
+
+	/* Let the server skip the offer and commit the lease right away */
+	opt[i++] = opt_rapid_commit;
+	opt[i++] = 0;
+
 	opt[i++] = opt_end;
 
-	return dhcp_send(&dlink->dt, msgbuf, sizeof(dhcp_hdr_t) + i);
+	return dhcp_send(&dlink->dt, dlink->msgbuf, sizeof(dhcp_hdr_t) + i);
 }
 
-static errno_t dhcp_send_request(dhcp_link_t *dlink, dhcp_offer_t *offer)
+/** Send DHCPREQUEST.
+ *
+ * @param dlink DHCP link
+ * @param offer Offer being requested or lease being verified
+ * @param reboot @c true to verify a previous lease in INIT-REBOOT state,
+ *               @c false to request an offer in REQUESTING state
+ */
+static errno_t dhcp_send_request(dhcp_link_t *dlink, dhcp_offer_t *offer,
+    bool reboot)
 {
-	dhcp_hdr_t *hdr = (dhcp_hdr_t *)msgbuf;
-	uint8_t *opt = msgbuf + sizeof(dhcp_hdr_t);
+	dhcp_hdr_t *hdr = (dhcp_hdr_t *)dlink->msgbuf;
+	uint8_t *opt = dlink->msgbuf + sizeof(dhcp_hdr_t);
 	size_t i;
 
-	memset(msgbuf, 0, MAX_MSG_SIZE);
-	hdr->op = op_bootrequest;
-	hdr->htype = 1; /* AHRD_ETHERNET */
-	hdr->hlen = 6;
-	hdr->xid = host2uint32_t_be(offer->xid);
-	hdr->flags = host2uint16_t_be(flag_broadcast);
-	eth_addr_encode(&dlink->link_info.mac_addr, hdr->chaddr);
-	hdr->opt_magic = host2uint32_t_be(dhcp_opt_magic);
+	dhcp_hdr_init(dlink, hdr);
 
 	i = 0;
 
@@ -214,23 +277,19 @@ static errno_t dhcp_send_request(dhcp_link_t *dlink, dhcp_offer_t *offer)
 	opt[i++] = 1;
 	opt[i++] = msg_dhcprequest;
 
-	opt[i++] = opt_req_ip_addr;
-	opt[i++] = 4;
-	opt[i++] = offer->oaddr.addr >> 24;
-	opt[i++] = (offer->oaddr.addr >> 16) & 0xff;
-	opt[i++] = (offer->oaddr.addr >> 8) & 0xff;
-	opt[i++] = offer->oaddr.addr & 0xff;
+	i += dhcp_addr_opt_encode(&opt[i], opt_req_ip_addr, offer->oaddr.addr);
 
-	opt[i++] = opt_server_id;
-	opt[i++] = 4;
-	opt[i++] = offer->srv_addr.addr >> 24;
-	opt[i++] = (offer->srv_addr.addr >> 16) & 0xff;
-	opt[i++] = (offer->srv_addr.addr >> 8) & 0xff;
-	opt[i++] = offer->srv_addr.addr & 0xff;
+	/* In INIT-REBOOT state, the server ID must not be sent */
+	if (!reboot) {
+		i += dhcp_addr_opt_encode(&opt[i], opt_server_id,
+		    offer->srv_addr.addr);
+	}
+
+	i += dhcp_param_req_encode(&opt[i]);
 
 	opt[i++] = opt_end;
 
-	return dhcp_send(&dlink->dt, msgbuf, sizeof(dhcp_hdr_t) + i);
+	return dhcp_send(&dlink->dt, dlink->msgbuf, sizeof(dhcp_hdr_t) + i);
 }
 
 static errno_t dhcp_parse_reply(void *msg, size_t size, dhcp_offer_t *offer)
@@ -327,6 +386,14 @@ static errno_t dhcp_parse_reply(void *msg, size_t size, dhcp_offer_t *offer)
 			inet_addr_set(dhcp_uint32_decode(&msgb[i]),
 			    &offer->router);
 			break;
+		case opt_lease_time:
+			if (opt_len != 4)
+				return EINVAL;
+			offer->lease_time = dhcp_uint32_decode(&msgb[i]);
+			break;
+		case opt_rapid_commit:
+			offer->rapid_commit = true;
+			break;
 		case opt_dns_server:
 			if (opt_len < 4 || opt_len % 4 != 0)
 				return EINVAL;
@@ -346,12 +413,16 @@ static errno_t dhcp_parse_reply(void *msg, size_t size, dhcp_offer_t *offer)
 
 	if (!have_server_id) {
 		log_msg(LOG_DEFAULT, LVL_ERROR, "Missing server ID option.");
-		return rc;
+		return EINVAL;
 	}
 
+	/* A NAK carries no configuration */
+	if (offer->msg_type == msg_dhcpnak)
+		return EOK;
+
 	if (!have_subnet_mask) {
 		log_msg(LOG_DEFAULT, LVL_ERROR, "Missing subnet mask option.");
-		return rc;
+		return EINVAL;
 	}
 
 	rc = inet_naddr_format(&offer->oaddr, &saddr);
@@ -382,25 +453,29 @@ static errno_t dhcp_parse_reply(void *msg, size_t size, dhcp_offer_t *offer)
 	return EOK;
 }
 
-static errno_t dhcp_cfg_create(service_id_t iplink, dhcp_offer_t *offer)
+/** Create address, default route and DNS configuration from lease. */
+static errno_t dhcp_cfg_create(dhcp_link_t *dlink, dhcp_offer_t *offer)
 {
 	errno_t rc;
-	service_id_t addr_id;
-	service_id_t sroute_id;
 	inet_naddr_t defr;
 
-	rc = inetcfg_addr_create_static("dhcp4a", &offer->oaddr, iplink,
-	    &addr_id);
+	rc = inetcfg_addr_create_static("dhcp4a", &offer->oaddr,
+	    dlink->link_id, &dlink->addr_id);
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_ERROR,
 		    "Error creating IP address %s: %s", "dhcp4a", str_error(rc));
 		return rc;
 	}
 
+	dlink->configured = true;
+	dlink->cfg_addr = offer->oaddr;
+	dlink->sroute_id = 0;
+
 	if (offer->router.addr != 0) {
 		inet_naddr_set(0, 0, &defr);
 
-		rc = inetcfg_sroute_create("dhcpdef", &defr, &offer->router, &sroute_id);
+		rc = inetcfg_sroute_create("dhcpdef", &defr, &offer->router,
+		    &dlink->sroute_id);
 		if (rc != EOK) {
 			log_msg(LOG_DEFAULT, LVL_ERROR, "Error creating "
 			    "default route %s: %s.", "dhcpdef", str_error(rc));
@@ -420,6 +495,45 @@ static errno_t dhcp_cfg_create(service_id_t iplink, dhcp_offer_t *offer)
 	return EOK;
 }
 
+/** Remove configuration created by dhcp_cfg_create(). */
+static void dhcp_cfg_delete(dhcp_link_t *dlink)
+{
+	if (!dlink->configured)
+		return;
+
+	if (dlink->sroute_id != 0)
+		(void) inetcfg_sroute_delete(dlink->sroute_id);
+	(void) inetcfg_addr_delete(dlink->addr_id);
+
+	dlink->configured = false;
+	dlink->sroute_id = 0;
+}
+
+/** Remember lease acknowledged by the server for the next start. */
+static void dhcp_link_lease_save(dhcp_link_t *dlink, dhcp_offer_t *offer)
+{
+	dhcp_lease_t lease;
+	struct timespec now;
+	errno_t rc;
+
+	if (offer->lease_time == 0)
+		return;
+
+	getrealtime(&now);
+
+	lease.addr = offer->oaddr;
+	lease.srv_addr = offer->srv_addr;
+	lease.router = offer->router;
+	lease.dns_server = offer->dns_server;
+	lease.expires = now.tv_sec + offer->lease_time;
+
+	rc = dhcp_lease_save(&dlink->link_info.mac_addr, &lease);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_NOTE, "%s: Could not save lease: %s",
+		    dlink->link_info.name, str_error(rc));
+	}
+}
+
 void dhcpsrv_links_init(void)
 {
 	list_initialize(&dhcp_links);
@@ -427,6 +541,8 @@ void dhcpsrv_links_init(void)
 
 static dhcp_link_t *dhcpsrv_link_find(service_id_t link_id)
 {
+	assert(fibril_mutex_is_locked(&dhcp_links_lock));
+
 	list_foreach(dhcp_links, links, dhcp_link_t, dlink) {
 		if (dlink->link_id == link_id)
 			return dlink;
@@ -435,6 +551,38 @@ static dhcp_link_t *dhcpsrv_link_find(service_id_t link_id)
 	return NULL;
 }
 
+/** Set link timer for the next retransmission.
+ *
+ * The retransmission delay doubles with every retry up to
+ * dhcp_retry_max_val. A random part keeps links and clients that start
+ * at the same time from retransmitting in lockstep.
+ */
+static void dhcp_link_timer_set(dhcp_link_t *dlink, fibril_timer_fun_t fun)
+{
+	uint32_t jitter;
+
+	assert(fibril_mutex_is_locked(&dlink->lock));
+
+	if (rndgen_uint32(dlink->rndgen, &jitter) != EOK)
+		jitter = 0;
+
+	if (dlink->timeout->state == fts_active)
+		(void) fibril_timer_clear_locked(dlink->timeout);
+
+	fibril_timer_set_locked(dlink->timeout, dlink->retry_delay +
+	    jitter % dhcp_retry_jitter_val, fun, dlink);
+
+	dlink->retry_delay = min(2 * dlink->retry_delay,
+	    (usec_t) dhcp_retry_max_val);
+}
+
+/** Start a new exchange with a fresh transaction ID and retry delay. */
+static errno_t dhcp_link_xid_new(dhcp_link_t *dlink)
+{
+	dlink->retry_delay = dhcp_retry_initial_val;
+	return rndgen_uint32(dlink->rndgen, &dlink->xid);
+}
+
 static void dhcp_link_set_failed(dhcp_link_t *dlink)
 {
 	log_msg(LOG_DEFAULT, LVL_NOTE, "Giving up on link %s",
@@ -442,47 +590,134 @@ static void dhcp_link_set_failed(dhcp_link_t *dlink)
 	dlink->state = ds_fail;
 }
 
+/** Enter bound state with lease acknowledged by the server. */
+static void dhcp_link_bind(dhcp_link_t *dlink, dhcp_offer_t *offer)
+{
+	errno_t rc;
+
+	dlink->offer = *offer;
+	dlink->state = ds_bound;
+
+	/* Keep configuration of a previous lease of the same address */
+	if (dlink->configured &&
+	    (dlink->cfg_addr.addr != offer->oaddr.addr ||
+	    dlink->cfg_addr.prefix != offer->oaddr.prefix))
+		dhcp_cfg_delete(dlink);
+
+	if (!dlink->configured) {
+		rc = dhcp_cfg_create(dlink, offer);
+		if (rc != EOK) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG,
+			    "Error creating configuration.");
+			return;
+		}
+	}
+
+	dhcp_link_lease_save(dlink, offer);
+
+	log_msg(LOG_DEFAULT, LVL_NOTE, "%s: Successfully configured.",
+	    dlink->link_info.name);
+}
+
 static errno_t dhcp_discover_proc(dhcp_link_t *dlink)
 {
+	errno_t rc;
+
+	assert(fibril_mutex_is_locked(&dlink->lock));
+
 	dlink->state = ds_selecting;
 
-	errno_t rc = dhcp_send_discover(dlink);
+	rc = dhcp_link_xid_new(dlink);
+	if (rc != EOK)
+		return rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "Send DHCPDISCOVER");
+	rc = dhcp_send_discover(dlink);
 	if (rc != EOK)
 		return EIO;
 
 	dlink->retries_left = dhcp_discover_retries;
+	dhcp_link_timer_set(dlink, dhcpsrv_discover_timeout);
+	return EOK;
+}
 
-	if ((dlink->timeout->state == fts_not_set) ||
-	    (dlink->timeout->state == fts_fired))
-		fibril_timer_set(dlink->timeout, dhcp_discover_timeout_val,
-		    dhcpsrv_discover_timeout, dlink);
+/** Reuse cached lease.
+ *
+ * The address is configured right away and the server is asked to
+ * confirm it in INIT-REBOOT state. If the server refuses the address,
+ * discovery starts from scratch.
+ */
+static errno_t dhcp_reboot_proc(dhcp_link_t *dlink, dhcp_lease_t *lease)
+{
+	dhcp_offer_t *offer = &dlink->offer;
+	struct timespec now;
+	errno_t rc;
 
-	return rc;
+	assert(fibril_mutex_is_locked(&dlink->lock));
+
+	getrealtime(&now);
+
+	memset(offer, 0, sizeof(*offer));
+	offer->msg_type = msg_dhcpack;
+	offer->oaddr = lease->addr;
+	offer->srv_addr = lease->srv_addr;
+	offer->router = lease->router;
+	offer->dns_server = lease->dns_server;
+	offer->lease_time = lease->expires - now.tv_sec;
+
+	rc = dhcp_cfg_create(dlink, offer);
+	if (rc != EOK)
+		return rc;
+
+	dlink->state = ds_init_reboot;
+
+	rc = dhcp_link_xid_new(dlink);
+	if (rc != EOK)
+		return rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "Send DHCPREQUEST (INIT-REBOOT)");
+	rc = dhcp_send_request(dlink, offer, true);
+	if (rc != EOK)
+		return EIO;
+
+	dlink->retries_left = dhcp_reboot_retries;
+	dhcp_link_timer_set(dlink, dhcpsrv_reboot_timeout);
+	return EOK;
 }
 
 errno_t dhcpsrv_link_add(service_id_t link_id)
 {
 	dhcp_link_t *dlink;
+	dhcp_lease_t lease;
+	bool have_transport = false;
 	errno_t rc;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "dhcpsrv_link_add(%zu)", link_id);
 
+	fibril_mutex_lock(&dhcp_links_lock);
+
 	if (dhcpsrv_link_find(link_id) != NULL) {
+		fibril_mutex_unlock(&dhcp_links_lock);
 		log_msg(LOG_DEFAULT, LVL_NOTE, "Link %zu already added",
 		    link_id);
 		return EEXIST;
 	}
 
 	dlink = calloc(1, sizeof(dhcp_link_t));
-	if (dlink == NULL)
+	if (dlink == NULL) {
+		fibril_mutex_unlock(&dhcp_links_lock);
 		return ENOMEM;
+	}
+
+	fibril_mutex_initialize(&dlink->lock);
+	dlink->state = ds_init;
 
 	rc = rndgen_create(&dlink->rndgen);
 	if (rc != EOK)
 		goto error;
 
 	dlink->link_id = link_id;
-	dlink->timeout = fibril_timer_create(NULL);
+	dlink->timeout = fibril_timer_create(&dlink->lock);
 	if (dlink->timeout == NULL) {
 		rc = ENOMEM;
 		goto error;
@@ -505,8 +740,27 @@ errno_t dhcpsrv_link_add(service_id_t link_id)
 		goto error;
 	}
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "Send DHCPDISCOVER");
-	rc = dhcp_discover_proc(dlink);
+	have_transport = true;
+
+	fibril_mutex_lock(&dlink->lock);
+
+	if (dhcp_lease_load(&dlink->link_info.mac_addr, &lease) == EOK) {
+		log_msg(LOG_DEFAULT, LVL_NOTE, "%s: Reusing cached lease.",
+		    dlink->link_info.name);
+		rc = dhcp_reboot_proc(dlink, &lease);
+		if (rc != EOK) {
+			log_msg(LOG_DEFAULT, LVL_ERROR, "Error reusing cached "
+			    "lease.");
+			dlink->state = ds_init;
+		}
+	}
+
+	rc = EOK;
+	if (dlink->state != ds_init_reboot)
+		rc = dhcp_discover_proc(dlink);
+
+	fibril_mutex_unlock(&dlink->lock);
+
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_ERROR, "Error sending DHCPDISCOVER.");
 		dhcp_link_set_failed(dlink);
@@ -515,12 +769,18 @@ errno_t dhcpsrv_link_add(service_id_t link_id)
 	}
 
 	list_append(&dlink->links, &dhcp_links);
+	fibril_mutex_unlock(&dhcp_links_lock);
 
 	return EOK;
 error:
-	if (dlink != NULL && dlink->rndgen != NULL)
+	fibril_mutex_unlock(&dhcp_links_lock);
+	if (have_transport) {
+		dhcp_cfg_delete(dlink);
+		dhcp_transport_fini(&dlink->dt);
+	}
+	if (dlink->rndgen != NULL)
 		rndgen_destroy(dlink->rndgen);
-	if (dlink != NULL && dlink->timeout != NULL)
+	if (dlink->timeout != NULL)
 		fibril_timer_destroy(dlink->timeout);
 	free(dlink);
 	return rc;
@@ -533,9 +793,14 @@ errno_t dhcpsrv_link_remove(service_id_t link_id)
 
 errno_t dhcpsrv_discover(service_id_t link_id)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "dhcpsrv_link_add(%zu)", link_id);
+	dhcp_link_t *dlink;
+	errno_t rc;
 
-	dhcp_link_t *dlink = dhcpsrv_link_find(link_id);
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "dhcpsrv_discover(%zu)", link_id);
+
+	fibril_mutex_lock(&dhcp_links_lock);
+	dlink = dhcpsrv_link_find(link_id);
+	fibril_mutex_unlock(&dhcp_links_lock);
 
 	if (dlink == NULL) {
 		log_msg(LOG_DEFAULT, LVL_NOTE, "Link %zu doesn't exist",
@@ -543,7 +808,11 @@ errno_t dhcpsrv_discover(service_id_t link_id)
 		return EINVAL;
 	}
 
-	return dhcp_discover_proc(dlink);
+	fibril_mutex_lock(&dlink->lock);
+	rc = dhcp_discover_proc(dlink);
+	fibril_mutex_unlock(&dlink->lock);
+
+	return rc;
 }
 
 static void dhcpsrv_recv_offer(dhcp_link_t *dlink, dhcp_offer_t *offer)
@@ -556,44 +825,58 @@ static void dhcpsrv_recv_offer(dhcp_link_t *dlink, dhcp_offer_t *offer)
 		return;
 	}
 
-	fibril_timer_clear(dlink->timeout);
+	fibril_timer_clear_locked(dlink->timeout);
 	dlink->offer = *offer;
 	dlink->state = ds_requesting;
+	dlink->retry_delay = dhcp_retry_initial_val;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Send DHCPREQUEST");
-	rc = dhcp_send_request(dlink, offer);
+	rc = dhcp_send_request(dlink, offer, false);
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "Error sending request.");
 		return;
 	}
 
 	dlink->retries_left = dhcp_request_retries;
-	fibril_timer_set(dlink->timeout, dhcp_request_timeout_val,
-	    dhcpsrv_request_timeout, dlink);
+	dhcp_link_timer_set(dlink, dhcpsrv_request_timeout);
 }
 
 static void dhcpsrv_recv_ack(dhcp_link_t *dlink, dhcp_offer_t *offer)
 {
-	errno_t rc;
-
-	if (dlink->state != ds_requesting) {
+	if (dlink->state == ds_selecting && offer->rapid_commit) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Received rapid commit ack");
+	} else if (dlink->state != ds_requesting &&
+	    dlink->state != ds_init_reboot) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "Received ack in state "
 		    " %d, ignoring.", (int)dlink->state);
 		return;
 	}
 
-	fibril_timer_clear(dlink->timeout);
-	dlink->offer = *offer;
-	dlink->state = ds_bound;
+	fibril_timer_clear_locked(dlink->timeout);
+	dhcp_link_bind(dlink, offer);
+}
 
-	rc = dhcp_cfg_create(dlink->link_id, offer);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "Error creating configuration.");
+static void dhcpsrv_recv_nak(dhcp_link_t *dlink, dhcp_offer_t *offer)
+{
+	errno_t rc;
+
+	if (dlink->state != ds_requesting && dlink->state != ds_init_reboot) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Received nak in state "
+		    " %d, ignoring.", (int)dlink->state);
 		return;
 	}
 
-	log_msg(LOG_DEFAULT, LVL_NOTE, "%s: Successfully configured.",
-	    dlink->link_info.name);
+	log_msg(LOG_DEFAULT, LVL_NOTE, "%s: Address refused by server, "
+	    "restarting discovery.", dlink->link_info.name);
+
+	fibril_timer_clear_locked(dlink->timeout);
+	dhcp_cfg_delete(dlink);
+
+	rc = dhcp_discover_proc(dlink);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Error sending DHCPDISCOVER");
+		dhcp_link_set_failed(dlink);
+	}
 }
 
 static void dhcpsrv_recv(void *arg, void *msg, size_t size)
@@ -611,6 +894,15 @@ static void dhcpsrv_recv(void *arg, void *msg, size_t size)
 		return;
 	}
 
+	fibril_mutex_lock(&dlink->lock);
+
+	if (offer.xid != dlink->xid) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Reply to another transaction, "
+		    "ignoring.");
+		fibril_mutex_unlock(&dlink->lock);
+		return;
+	}
+
 	switch (offer.msg_type) {
 	case msg_dhcpoffer:
 		dhcpsrv_recv_offer(dlink, &offer);
@@ -618,11 +910,16 @@ static void dhcpsrv_recv(void *arg, void *msg, size_t size)
 	case msg_dhcpack:
 		dhcpsrv_recv_ack(dlink, &offer);
 		break;
+	case msg_dhcpnak:
+		dhcpsrv_recv_nak(dlink, &offer);
+		break;
 	default:
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "Received unexpected "
 		    "message type. %d", (int)offer.msg_type);
 		break;
 	}
+
+	fibril_mutex_unlock(&dlink->lock);
 }
 
 static void dhcpsrv_discover_timeout(void *arg)
@@ -630,14 +927,19 @@ static void dhcpsrv_discover_timeout(void *arg)
 	dhcp_link_t *dlink = (dhcp_link_t *)arg;
 	errno_t rc;
 
-	assert(dlink->state == ds_selecting);
+	fibril_mutex_lock(&dlink->lock);
+
+	/* A reply may have arrived before we got the lock */
+	if (dlink->state != ds_selecting)
+		goto out;
+
 	log_msg(LOG_DEFAULT, LVL_NOTE, "%s: dhcpsrv_discover_timeout",
 	    dlink->link_info.name);
 
 	if (dlink->retries_left == 0) {
 		log_msg(LOG_DEFAULT, LVL_NOTE, "Retries exhausted");
 		dhcp_link_set_failed(dlink);
-		return;
+		goto out;
 	}
 	--dlink->retries_left;
 
@@ -646,11 +948,12 @@ static void dhcpsrv_discover_timeout(void *arg)
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_ERROR, "Error sending DHCPDISCOVER");
 		dhcp_link_set_failed(dlink);
-		return;
+		goto out;
 	}
 
-	fibril_timer_set(dlink->timeout, dhcp_discover_timeout_val,
-	    dhcpsrv_discover_timeout, dlink);
+	dhcp_link_timer_set(dlink, dhcpsrv_discover_timeout);
+out:
+	fibril_mutex_unlock(&dlink->lock);
 }
 
 static void dhcpsrv_request_timeout(void *arg)
@@ -658,27 +961,72 @@ static void dhcpsrv_request_timeout(void *arg)
 	dhcp_link_t *dlink = (dhcp_link_t *)arg;
 	errno_t rc;
 
-	assert(dlink->state == ds_requesting);
+	fibril_mutex_lock(&dlink->lock);
+
+	/* A reply may have arrived before we got the lock */
+	if (dlink->state != ds_requesting)
+		goto out;
+
 	log_msg(LOG_DEFAULT, LVL_NOTE, "%s: dhcpsrv_request_timeout",
 	    dlink->link_info.name);
 
 	if (dlink->retries_left == 0) {
 		log_msg(LOG_DEFAULT, LVL_NOTE, "Retries exhausted");
 		dhcp_link_set_failed(dlink);
-		return;
+		goto out;
 	}
 	--dlink->retries_left;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Send DHCPREQUEST");
-	rc = dhcp_send_request(dlink, &dlink->offer);
+	rc = dhcp_send_request(dlink, &dlink->offer, false);
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "Error sending request.");
 		dhcp_link_set_failed(dlink);
-		return;
+		goto out;
+	}
+
+	dhcp_link_timer_set(dlink, dhcpsrv_request_timeout);
+out:
+	fibril_mutex_unlock(&dlink->lock);
+}
+
+static void dhcpsrv_reboot_timeout(void *arg)
+{
+	dhcp_link_t *dlink = (dhcp_link_t *)arg;
+	errno_t rc;
+
+	fibril_mutex_lock(&dlink->lock);
+
+	/* A reply may have arrived before we got the lock */
+	if (dlink->state != ds_init_reboot)
+		goto out;
+
+	log_msg(LOG_DEFAULT, LVL_NOTE, "%s: dhcpsrv_reboot_timeout",
+	    dlink->link_info.name);
+
+	if (dlink->retries_left == 0) {
+		/*
+		 * No server to confirm the lease. It can be used until it
+		 * expires (RFC 2131, section 3.2).
+		 */
+		log_msg(LOG_DEFAULT, LVL_NOTE, "%s: No answer, keeping cached "
+		    "lease.", dlink->link_info.name);
+		dlink->state = ds_bound;
+		goto out;
+	}
+	--dlink->retries_left;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "Send DHCPREQUEST (INIT-REBOOT)");
+	rc = dhcp_send_request(dlink, &dlink->offer, true);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Error sending request.");
+		dlink->state = ds_bound;
+		goto out;
 	}
 
-	fibril_timer_set(dlink->timeout, dhcp_request_timeout_val,
-	    dhcpsrv_request_timeout, dlink);
+	dhcp_link_timer_set(dlink, dhcpsrv_reboot_timeout);
+out:
+	fibril_mutex_unlock(&dlink->lock);
 }
 
 /** @}
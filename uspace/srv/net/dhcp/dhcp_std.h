@@ -105,12 +105,16 @@ enum dhcp_option_code {
 	opt_dns_server = 6,
 	/** Requested IP address */
 	opt_req_ip_addr = 50,
+	/** IP address lease time */
+	opt_lease_time = 51,
 	/** DHCP message type */
 	opt_msg_type = 53,
 	/** Server identifier */
 	opt_server_id = 54,
 	/** Parameter request list */
 	opt_param_req_list = 55,
+	/** Rapid commit (RFC 4039) */
+	opt_rapid_commit = 80,
 	/** End */
 	opt_end = 255
 };
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup dhcp
+ * @{
+ */
+/**
+ * @file
+ * @brief DHCP lease cache
+ *
+ * Leases are kept in a SIF repository, one node per link hardware address,
+ * so that a link can ask for its previous address right after a restart
+ * instead of going through discovery.
+ */
+
+#include <errno.h>
+#include <fibril_synch.h>
+#include <inttypes.h>
+#include <io/log.h>
+#include <sif.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+
+#include "lease.h"
+
+static const char *dhcp_lease_file = "/w/cfg/dhcp.sif";
+
+/** Serializes access to the lease repository */
+static FIBRIL_MUTEX_INITIALIZE(dhcp_lease_lock);
+
+/** Open lease repository.
+ *
+ * @param create @c true to create the repository if it does not exist
+ * @param rrepo Place to store the repository session
+ * @param rleases Place to store the 'leases' node
+ * @return EOK on success or an error code
+ */
+static errno_t dhcp_lease_repo_open(bool create, sif_sess_t **rrepo,
+    sif_node_t **rleases)
+{
+	sif_sess_t *repo = NULL;
+	sif_trans_t *trans = NULL;
+	sif_node_t *node;
+	errno_t rc;
+
+	rc = sif_open(dhcp_lease_file, &repo);
+	if (rc == EOK) {
+		node = sif_node_first_child(sif_get_root(repo));
+		if (node == NULL ||
+		    str_cmp(sif_node_get_type(node), "leases") != 0) {
+			rc = EIO;
+			goto error;
+		}
+
+		*rrepo = repo;
+		*rleases = node;
+		return EOK;
+	}
+
+	if (!create)
+		return rc;
+
+	rc = sif_create(dhcp_lease_file, &repo);
+	if (rc != EOK)
+		return rc;
+
+	rc = sif_trans_begin(repo, &trans);
+	if (rc != EOK)
+		goto error;
+
+	rc = sif_node_append_child(trans, sif_get_root(repo), "leases", &node);
+	if (rc != EOK)
+		goto error;
+
+	rc = sif_trans_end(trans);
+	if (rc != EOK)
+		goto error;
+
+	*rrepo = repo;
+	*rleases = node;
+	return EOK;
+error:
+	if (trans != NULL)
+		sif_trans_abort(trans);
+	(void) sif_close(repo);
+	return rc;
+}
+
+/** Find lease node for link hardware address. */
+static sif_node_t *dhcp_lease_find(sif_node_t *nleases, eth_addr_str_t *mac)
+{
+	sif_node_t *nlease;
+	const char *attr;
+
+	nlease = sif_node_first_child(nleases);
+	while (nlease != NULL) {
+		attr = sif_node_get_attr(nlease, "mac");
+		if (str_cmp(sif_node_get_type(nlease), "lease") == 0 &&
+		    attr != NULL && str_cmp(attr, mac->str) == 0)
+			return nlease;
+
+		nlease = sif_node_next_child(nlease);
+	}
+
+	return NULL;
+}
+
+/** Parse optional address attribute of lease node. */
+static errno_t dhcp_lease_get_addr(sif_node_t *nlease, const char *aname,
+    inet_addr_t *addr)
+{
+	const char *attr;
+
+	attr = sif_node_get_attr(nlease, aname);
+	if (attr == NULL) {
+		inet_addr_set(0, addr);
+		return EOK;
+	}
+
+	return inet_addr_parse(attr, addr, NULL);
+}
+
+/** Load cached lease of a link.
+ *
+ * @param mac Link hardware address
+ * @param lease Place to store the lease
+ * @return EOK on success, ENOENT if there is no unexpired lease for the
+ *         link or an error code
+ */
+errno_t dhcp_lease_load(eth_addr_t *mac, dhcp_lease_t *lease)
+{
+	sif_sess_t *repo;
+	sif_node_t *nleases;
+	sif_node_t *nlease;
+	struct timespec now;
+	eth_addr_str_t smac;
+	const char *attr;
+	uint64_t expires;
+	errno_t rc;
+
+	eth_addr_format(mac, &smac);
+
+	fibril_mutex_lock(&dhcp_lease_lock);
+
+	rc = dhcp_lease_repo_open(false, &repo, &nleases);
+	if (rc != EOK) {
+		fibril_mutex_unlock(&dhcp_lease_lock);
+		return ENOENT;
+	}
+
+	nlease = dhcp_lease_find(nleases, &smac);
+	if (nlease == NULL) {
+		rc = ENOENT;
+		goto out;
+	}
+
+	attr = sif_node_get_attr(nlease, "addr");
+	if (attr == NULL) {
+		rc = EIO;
+		goto out;
+	}
+
+	rc = inet_naddr_parse(attr, &lease->addr, NULL);
+	if (rc != EOK)
+		goto out;
+
+	rc = dhcp_lease_get_addr(nlease, "server", &lease->srv_addr);
+	if (rc == EOK)
+		rc = dhcp_lease_get_addr(nlease, "router", &lease->router);
+	if (rc == EOK)
+		rc = dhcp_lease_get_addr(nlease, "dns", &lease->dns_server);
+	if (rc != EOK)
+		goto out;
+
+	attr = sif_node_get_attr(nlease, "expires");
+	if (attr == NULL ||
+	    str_uint64_t(attr, NULL, 10, true, &expires) != EOK) {
+		rc = EIO;
+		goto out;
+	}
+
+	lease->expires = expires;
+
+	getrealtime(&now);
+	if (lease->expires <= now.tv_sec)
+		rc = ENOENT;
+out:
+	(void) sif_close(repo);
+	fibril_mutex_unlock(&dhcp_lease_lock);
+	return rc;
+}
+
+/** Set address attribute of lease node, skipping unset addresses. */
+static errno_t dhcp_lease_set_addr(sif_trans_t *trans, sif_node_t *nlease,
+    const char *aname, inet_addr_t *addr)
+{
+	char *saddr;
+	errno_t rc;
+
+	if (addr->addr == 0) {
+		sif_node_unset_attr(trans, nlease, aname);
+		return EOK;
+	}
+
+	rc = inet_addr_format(addr, &saddr);
+	if (rc != EOK)
+		return rc;
+
+	rc = sif_node_set_attr(trans, nlease, aname, saddr);
+	free(saddr);
+	return rc;
+}
+
+/** Save lease of a link to the cache.
+ *
+ * @param mac Link hardware address
+ * @param lease Lease
+ * @return EOK on success or an error code
+ */
+errno_t dhcp_lease_save(eth_addr_t *mac, dhcp_lease_t *lease)
+{
+	sif_sess_t *repo;
+	sif_trans_t *trans = NULL;
+	sif_node_t *nleases;
+	sif_node_t *nlease;
+	eth_addr_str_t smac;
+	char *saddr = NULL;
+	char sexpires[24];
+	errno_t rc;
+
+	eth_addr_format(mac, &smac);
+	snprintf(sexpires, sizeof(sexpires), "%" PRIu64,
+	    (uint64_t) lease->expires);
+
+	rc = inet_naddr_format(&lease->addr, &saddr);
+	if (rc != EOK)
+		return rc;
+
+	fibril_mutex_lock(&dhcp_lease_lock);
+
+	rc = dhcp_lease_repo_open(true, &repo, &nleases);
+	if (rc != EOK) {
+		fibril_mutex_unlock(&dhcp_lease_lock);
+		free(saddr);
+		return rc;
+	}
+
+	rc = sif_trans_begin(repo, &trans);
+	if (rc != EOK)
+		goto error;
+
+	nlease = dhcp_lease_find(nleases, &smac);
+	if (nlease == NULL) {
+		rc = sif_node_append_child(trans, nleases, "lease", &nlease);
+		if (rc != EOK)
+			goto error;
+
+		rc = sif_node_set_attr(trans, nlease, "mac", smac.str);
+		if (rc != EOK)
+			goto error;
+	}
+
+	rc = sif_node_set_attr(trans, nlease, "addr", saddr);
+	if (rc == EOK)
+		rc = dhcp_lease_set_addr(trans, nlease, "server",
+		    &lease->srv_addr);
+	if (rc == EOK)
+		rc = dhcp_lease_set_addr(trans, nlease, "router",
+		    &lease->router);
+	if (rc == EOK)
+		rc = dhcp_lease_set_addr(trans, nlease, "dns",
+		    &lease->dns_server);
+	if (rc == EOK)
+		rc = sif_node_set_attr(trans, nlease, "expires", sexpires);
+	if (rc != EOK)
+		goto error;
+
+	rc = sif_trans_end(trans);
+	if (rc != EOK)
+		goto error;
+
+	(void) sif_close(repo);
+	fibril_mutex_unlock(&dhcp_lease_lock);
+	free(saddr);
+	return EOK;
+error:
+	if (trans != NULL)
+		sif_trans_abort(trans);
+	(void) sif_close(repo);
+	fibril_mutex_unlock(&dhcp_lease_lock);
+	free(saddr);
+	return rc;
+}
+
+/** @}
+ */
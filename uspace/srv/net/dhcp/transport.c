@@ -48,9 +48,6 @@
 #include "dhcp_std.h"
 #include "transport.h"
 
-#define MAX_MSG_SIZE 1024
-static uint8_t msgbuf[MAX_MSG_SIZE];
-
 typedef struct {
 	/** Message type */
 	enum dhcp_msg_type msg_type;
@@ -102,17 +99,17 @@ static void dhcp_recv_msg(udp_assoc_t *assoc, udp_rmsg_t *rmsg)
 
 	dt = (dhcp_transport_t *)udp_assoc_userptr(assoc);
 	s = udp_rmsg_size(rmsg);
-	if (s > MAX_MSG_SIZE)
-		s = MAX_MSG_SIZE; /* XXX */
+	if (s > DHCP_MSG_BUF_SIZE)
+		s = DHCP_MSG_BUF_SIZE; /* XXX */
 
-	rc = udp_rmsg_read(rmsg, 0, msgbuf, s);
+	rc = udp_rmsg_read(rmsg, 0, dt->rbuf, s);
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_ERROR, "Error receiving message.");
 		return;
 	}
 
 	log_msg(LOG_DEFAULT, LVL_NOTE, "dhcp_recv_msg() - call recv_cb");
-	dt->recv_cb(dt->cb_arg, msgbuf, s);
+	dt->recv_cb(dt->cb_arg, dt->rbuf, s);
 }
 
 static void dhcp_recv_err(udp_assoc_t *assoc, udp_rerr_t *rerr)
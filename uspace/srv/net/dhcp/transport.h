@@ -40,6 +40,10 @@
 #include <inet/udp.h>
 #include <ipc/loc.h>
 #include <stddef.h>
+#include <stdint.h>
+
+/** Size of buffers for DHCP messages */
+#define DHCP_MSG_BUF_SIZE 1024
 
 struct dhcp_transport;
 typedef struct dhcp_transport dhcp_transport_t;
@@ -55,6 +59,8 @@ struct dhcp_transport {
 	dhcp_recv_cb_t recv_cb;
 	/** Callback argument */
 	void *cb_arg;
+	/** Buffer for received message */
+	uint8_t rbuf[DHCP_MSG_BUF_SIZE];
 };
 
 extern errno_t dhcp_transport_init(dhcp_transport_t *, service_id_t,
@@ -203,6 +203,9 @@ static void dnsr_set_srvaddr_srv(dnsr_client_t *client, ipc_call_t *icall)
 		return;
 	}
 
+	/* Results from the previous server are no longer relevant */
+	dns_cache_flush();
+
 	async_answer_0(icall, rc);
 }
 
@@ -33,22 +33,187 @@
  * @file
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <assert.h>
+#include <ctype.h>
 #include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <io/log.h>
+#include <macros.h>
 #include <mem.h>
+#include <rndgen.h>
 #include <stdlib.h>
 #include <str.h>
+#include <time.h>
 #include "dns_msg.h"
 #include "dns_std.h"
 #include "dns_type.h"
 #include "query.h"
 #include "transport.h"
 
+/** Maximum number of cached query results */
+#define CACHE_MAX_ENTRIES 256
+
+/** Upper bound for the TTL of a cached result in seconds */
+#define CACHE_MAX_TTL 86400
+
+/** Upper bound for the TTL of a cached negative result in seconds */
+#define CACHE_MAX_NEG_TTL 3600
+
+/** Number of hits after which a result is refreshed before it expires.
+ *
+ * Zero disables the prefetch.
+ */
+#define CACHE_PREFETCH_HITS 3
+
+/** Cached result of a query for one name and type.
+ *
+ * While the query is in progress the entry is pending and further
+ * queries for the same name and type wait for its result instead of
+ * sending their own request.
+ */
+typedef struct {
+	/** Link to cache_table */
+	ht_link_t lcache;
+	/** Link to cache_lru */
+	link_t llru;
+	/** Number of references, including the one from the cache */
+	unsigned refcnt;
+	/** @c true while the entry is in the cache */
+	bool cached;
+	/** @c true while the query is in progress */
+	bool pending;
+	/** @c true while the result is being refreshed */
+	bool prefetch;
+	/** Queried name, lower case */
+	char *name;
+	/** Query type */
+	dns_qtype_t qtype;
+	/** EOK, ENOENT for a negative result or an error code */
+	errno_t rc;
+	/** Canonical name if rc is EOK */
+	char *cname;
+	/** Address if rc is EOK */
+	inet_addr_t addr;
+	/** Time to live in seconds */
+	uint32_t ttl;
+	/** Uptime in seconds when the entry expires */
+	time_t expires;
+	/** Number of hits since the result was received */
+	unsigned hits;
+} dns_cache_entry_t;
+
+/** Cache lookup key */
+typedef struct {
+	const char *name;
+	dns_qtype_t qtype;
+} dns_cache_key_t;
+
+static size_t dns_cache_key_hash(const void *);
+static size_t dns_cache_hash(const ht_link_t *);
+static bool dns_cache_key_equal(const void *, const ht_link_t *);
+static void dns_cache_remove_callback(ht_link_t *);
+
+static const hash_table_ops_t dns_cache_ops = {
+	.hash = dns_cache_hash,
+	.key_hash = dns_cache_key_hash,
+	.key_equal = dns_cache_key_equal,
+	.equal = NULL,
+	.remove_callback = dns_cache_remove_callback
+};
+
+static FIBRIL_MUTEX_INITIALIZE(cache_lock);
+/** Signalled when a pending entry receives its result */
+static FIBRIL_CONDVAR_INITIALIZE(cache_cv);
+static hash_table_t cache_table;
+static bool cache_initialized;
+/** Cached entries, least recently used first */
+static LIST_INITIALIZE(cache_lru);
+static size_t cache_count;
+
 static uint16_t msg_id;
 
+/** Get SOA minimum field.
+ *
+ * @param pdu     PDU containing the record
+ * @param rr      SOA resource record
+ * @param rminimum Place to store the minimum field
+ * @return EOK on success, EINVAL if the record is malformed or ENOMEM
+ */
+static errno_t dns_soa_minimum(dns_pdu_t *pdu, dns_rr_t *rr,
+    uint32_t *rminimum)
+{
+	char *name;
+	size_t eoff;
+	errno_t rc;
+
+	/* Skip MNAME and RNAME */
+	rc = dns_name_decode(pdu, rr->roff, &name, &eoff);
+	if (rc != EOK)
+		return rc;
+	free(name);
+
+	rc = dns_name_decode(pdu, eoff, &name, &eoff);
+	if (rc != EOK)
+		return rc;
+	free(name);
+
+	/* SERIAL, REFRESH, RETRY, EXPIRE and MINIMUM follow */
+	if (eoff + 5 * sizeof(uint32_t) > rr->roff + rr->rdata_size)
+		return EINVAL;
+
+	*rminimum = dns_uint32_t_decode(pdu->data + eoff +
+	    4 * sizeof(uint32_t), sizeof(uint32_t));
+	return EOK;
+}
+
+/** Get TTL of a negative answer (RFC 2308).
+ *
+ * @param amsg Answer message
+ * @param rttl Place to store TTL
+ * @return EOK on success, ENOENT if the answer carries no SOA record
+ */
+static errno_t dns_negative_ttl(dns_message_t *amsg, uint32_t *rttl)
+{
+	uint32_t minimum;
+
+	if (amsg->rcode != RC_OK && amsg->rcode != RC_NAME_ERR)
+		return ENOENT;
+
+	list_foreach(amsg->authority, msg, dns_rr_t, rr) {
+		if (rr->rtype != DTYPE_SOA || rr->rclass != DC_IN)
+			continue;
+
+		if (dns_soa_minimum(&amsg->pdu, rr, &minimum) != EOK)
+			continue;
+
+		*rttl = min(rr->ttl, minimum);
+		return EOK;
+	}
+
+	return ENOENT;
+}
+
+/** Query name server.
+ *
+ * @param name  Name to resolve
+ * @param qtype Query type
+ * @param info  Host info to fill in
+ * @param rttl  Place to store how long the result may be cached
+ *
+ * @return EOK on success, ENOENT if the name server answered that the
+ *         name has no such record, EIO if the name could not be resolved
+ *         otherwise or an error code
+ */
 static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
-    dns_host_info_t *info)
+    dns_host_info_t *info, uint32_t *rttl)
 {
+	/* Lowest TTL of the records on the way to the answer */
+	uint32_t ttl = UINT32_MAX;
+
 	/* Start with the caller-provided name */
 	char *sname = str_dup(name);
 	if (sname == NULL)
@@ -79,7 +244,9 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 		return ENOMEM;
 	}
 
-	msg->id = msg_id++;
+	/* Random IDs make forged answers harder to get accepted */
+	if (rndgen_fill_local(&msg->id, sizeof(msg->id)) != EOK)
+		msg->id = msg_id++;
 	msg->qr = QR_QUERY;
 	msg->opcode = OPC_QUERY;
 	msg->aa = false;
@@ -129,6 +296,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 			/* Continue looking for the more canonical name */
 			free(sname);
 			sname = cname;
+			ttl = min(ttl, rr->ttl);
 		}
 
 		if ((qtype == DTYPE_A) && (rr->rtype == DTYPE_A) &&
@@ -146,6 +314,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 
 			inet_addr_set(dns_uint32_t_decode(rr->rdata, rr->rdata_size),
 			    &info->addr);
+			*rttl = min(ttl, rr->ttl);
 
 			dns_message_destroy(msg);
 			dns_message_destroy(amsg);
@@ -171,6 +340,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 			dns_addr128_t_decode(rr->rdata, rr->rdata_size, addr);
 
 			inet_addr_set6(addr, &info->addr);
+			*rttl = min(ttl, rr->ttl);
 
 			dns_message_destroy(msg);
 			dns_message_destroy(amsg);
@@ -182,11 +352,380 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "'%s' not resolved, fail", sname);
 
+	errno_t retval = EIO;
+	if (dns_negative_ttl(amsg, &ttl) == EOK) {
+		*rttl = ttl;
+		retval = ENOENT;
+	}
+
 	dns_message_destroy(msg);
 	dns_message_destroy(amsg);
 	free(sname);
 
-	return EIO;
+	return retval;
+}
+
+static size_t dns_cache_key_hash(const void *arg)
+{
+	const dns_cache_key_t *key = arg;
+	const char *cp;
+	size_t hash = 0;
+
+	for (cp = key->name; *cp != '\0'; cp++)
+		hash = hash * 31 + (uint8_t) *cp;
+
+	return hash_combine(hash_mix(hash), key->qtype);
+}
+
+static size_t dns_cache_hash(const ht_link_t *item)
+{
+	dns_cache_entry_t *entry = hash_table_get_inst(item, dns_cache_entry_t,
+	    lcache);
+	dns_cache_key_t key;
+
+	key.name = entry->name;
+	key.qtype = entry->qtype;
+	return dns_cache_key_hash(&key);
+}
+
+static bool dns_cache_key_equal(const void *arg, const ht_link_t *item)
+{
+	const dns_cache_key_t *key = arg;
+	dns_cache_entry_t *entry = hash_table_get_inst(item, dns_cache_entry_t,
+	    lcache);
+
+	return entry->qtype == key->qtype && str_cmp(entry->name,
+	    key->name) == 0;
+}
+
+/** Drop a reference to a cache entry.
+ *
+ * Must be called with cache_lock held.
+ */
+static void dns_cache_entry_put(dns_cache_entry_t *entry)
+{
+	assert(fibril_mutex_is_locked(&cache_lock));
+	assert(entry->refcnt > 0);
+
+	if (--entry->refcnt > 0)
+		return;
+
+	free(entry->name);
+	free(entry->cname);
+	free(entry);
+}
+
+static void dns_cache_remove_callback(ht_link_t *item)
+{
+	dns_cache_entry_t *entry = hash_table_get_inst(item, dns_cache_entry_t,
+	    lcache);
+
+	list_remove(&entry->llru);
+	entry->cached = false;
+	--cache_count;
+	dns_cache_entry_put(entry);
+}
+
+/** Remove entry from the cache.
+ *
+ * Must be called with cache_lock held.
+ */
+static void dns_cache_remove(dns_cache_entry_t *entry)
+{
+	if (entry->cached)
+		hash_table_remove_item(&cache_table, &entry->lcache);
+}
+
+/** Duplicate name in lower case.
+ *
+ * Names are compared case-insensitively (RFC 1035 2.3.3).
+ */
+static char *dns_name_lower(const char *name)
+{
+	char *lname;
+	char *cp;
+
+	lname = str_dup(name);
+	if (lname == NULL)
+		return NULL;
+
+	for (cp = lname; *cp != '\0'; cp++)
+		*cp = tolower(*cp);
+
+	return lname;
+}
+
+static time_t dns_cache_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return ts.tv_sec;
+}
+
+/** Store query result in a cache entry.
+ *
+ * Must be called with cache_lock held.
+ */
+static void dns_cache_entry_set(dns_cache_entry_t *entry, errno_t rc,
+    dns_host_info_t *info, uint32_t ttl)
+{
+	free(entry->cname);
+	entry->cname = NULL;
+
+	entry->rc = rc;
+	entry->hits = 0;
+
+	if (rc == EOK) {
+		entry->cname = info->cname;
+		info->cname = NULL;
+		entry->addr = info->addr;
+		ttl = min(ttl, (uint32_t) CACHE_MAX_TTL);
+	} else {
+		ttl = min(ttl, (uint32_t) CACHE_MAX_NEG_TTL);
+	}
+
+	entry->ttl = ttl;
+	entry->expires = dns_cache_now() + ttl;
+}
+
+/** Copy result from cache entry to host info.
+ *
+ * Must be called with cache_lock held.
+ *
+ * @return EOK on success, EIO for a negative result or an error code
+ */
+static errno_t dns_cache_entry_get(dns_cache_entry_t *entry,
+    dns_host_info_t *info)
+{
+	if (entry->rc == ENOENT)
+		return EIO;
+	if (entry->rc != EOK)
+		return entry->rc;
+
+	info->cname = str_dup(entry->cname);
+	if (info->cname == NULL)
+		return ENOMEM;
+
+	info->addr = entry->addr;
+	return EOK;
+}
+
+/** Refresh cached result before it expires. */
+static errno_t dns_cache_prefetch_fibril(void *arg)
+{
+	dns_cache_entry_t *entry = arg;
+	dns_host_info_t info;
+	uint32_t ttl;
+	errno_t rc;
+
+	memset(&info, 0, sizeof(info));
+
+	/* The name does not change while we hold a reference */
+	rc = dns_name_query(entry->name, entry->qtype, &info, &ttl);
+
+	fibril_mutex_lock(&cache_lock);
+	if (entry->cached && (rc == EOK || rc == ENOENT)) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Refreshed '%s' type %u",
+		    entry->name, entry->qtype);
+		dns_cache_entry_set(entry, rc, &info, ttl);
+	}
+
+	entry->prefetch = false;
+	dns_cache_entry_put(entry);
+	fibril_mutex_unlock(&cache_lock);
+
+	free(info.cname);
+	return EOK;
+}
+
+/** Start refreshing a popular entry which is about to expire.
+ *
+ * Must be called with cache_lock held.
+ */
+static void dns_cache_prefetch_check(dns_cache_entry_t *entry, time_t now)
+{
+	fid_t fid;
+
+	if (CACHE_PREFETCH_HITS == 0 || entry->rc != EOK || entry->prefetch)
+		return;
+
+	/* Refresh in the last tenth of the TTL */
+	if (entry->hits < CACHE_PREFETCH_HITS ||
+	    (entry->expires - now) * 10 > entry->ttl)
+		return;
+
+	fid = fibril_create(dns_cache_prefetch_fibril, entry);
+	if (fid == 0)
+		return;
+
+	entry->prefetch = true;
+	++entry->refcnt;
+	fibril_add_ready(fid);
+}
+
+/** Make room for a new cache entry.
+ *
+ * Expired entries go first, then the least recently used ones. Pending
+ * entries are kept so that their waiters are not left behind.
+ *
+ * Must be called with cache_lock held.
+ */
+static void dns_cache_evict(time_t now)
+{
+	list_foreach_safe(cache_lru, cur, next) {
+		dns_cache_entry_t *entry = list_get_instance(cur,
+		    dns_cache_entry_t, llru);
+
+		if (!entry->pending && entry->expires <= now)
+			dns_cache_remove(entry);
+	}
+
+	list_foreach_safe(cache_lru, cur, next) {
+		if (cache_count < CACHE_MAX_ENTRIES)
+			break;
+
+		dns_cache_entry_t *entry = list_get_instance(cur,
+		    dns_cache_entry_t, llru);
+
+		if (!entry->pending)
+			dns_cache_remove(entry);
+	}
+}
+
+/** Resolve name using the cache.
+ *
+ * If a valid result is cached, it is returned right away. If the same
+ * query is already in progress, wait for its result. Otherwise query
+ * the name server and cache the result, including negative answers.
+ *
+ * @param name  Name to resolve
+ * @param qtype Query type
+ * @param info  Host info to fill in
+ * @return EOK on success, EIO if the name could not be resolved or an
+ *         error code
+ */
+static errno_t dns_cache_query(const char *name, dns_qtype_t qtype,
+    dns_host_info_t *info)
+{
+	dns_cache_entry_t *entry;
+	dns_cache_key_t key;
+	ht_link_t *link;
+	uint32_t ttl;
+	time_t now;
+	errno_t rc;
+
+	key.name = dns_name_lower(name);
+	if (key.name == NULL)
+		return ENOMEM;
+	key.qtype = qtype;
+
+	fibril_mutex_lock(&cache_lock);
+
+	if (!cache_initialized) {
+		if (!hash_table_create(&cache_table, 0, 0, &dns_cache_ops)) {
+			fibril_mutex_unlock(&cache_lock);
+			free((char *) key.name);
+			return ENOMEM;
+		}
+
+		cache_initialized = true;
+	}
+
+	now = dns_cache_now();
+	link = hash_table_find(&cache_table, &key);
+	if (link != NULL) {
+		entry = hash_table_get_inst(link, dns_cache_entry_t, lcache);
+
+		if (entry->pending) {
+			/* Wait for the query in progress */
+			++entry->refcnt;
+			while (entry->pending)
+				fibril_condvar_wait(&cache_cv, &cache_lock);
+
+			rc = dns_cache_entry_get(entry, info);
+			dns_cache_entry_put(entry);
+			fibril_mutex_unlock(&cache_lock);
+			free((char *) key.name);
+			return rc;
+		}
+
+		if (entry->expires > now) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Cache hit '%s' type %u",
+			    key.name, qtype);
+
+			++entry->hits;
+			list_remove(&entry->llru);
+			list_append(&entry->llru, &cache_lru);
+			dns_cache_prefetch_check(entry, now);
+
+			rc = dns_cache_entry_get(entry, info);
+			fibril_mutex_unlock(&cache_lock);
+			free((char *) key.name);
+			return rc;
+		}
+
+		dns_cache_remove(entry);
+	}
+
+	if (cache_count >= CACHE_MAX_ENTRIES)
+		dns_cache_evict(now);
+
+	entry = calloc(1, sizeof(dns_cache_entry_t));
+	if (entry == NULL) {
+		fibril_mutex_unlock(&cache_lock);
+		free((char *) key.name);
+		return ENOMEM;
+	}
+
+	/* One reference for the cache and one for us */
+	entry->refcnt = 2;
+	entry->cached = true;
+	entry->pending = true;
+	entry->name = (char *) key.name;
+	entry->qtype = qtype;
+	hash_table_insert(&cache_table, &entry->lcache);
+	list_append(&entry->llru, &cache_lru);
+	++cache_count;
+
+	fibril_mutex_unlock(&cache_lock);
+
+	rc = dns_name_query(name, qtype, info, &ttl);
+
+	fibril_mutex_lock(&cache_lock);
+
+	entry->pending = false;
+	if (rc == EOK || rc == ENOENT) {
+		dns_cache_entry_set(entry, rc, info, ttl);
+		rc = dns_cache_entry_get(entry, info);
+	} else {
+		/* Errors are passed to the waiters but not cached */
+		entry->rc = rc;
+		dns_cache_remove(entry);
+	}
+
+	fibril_condvar_broadcast(&cache_cv);
+	dns_cache_entry_put(entry);
+	fibril_mutex_unlock(&cache_lock);
+
+	return rc;
+}
+
+/** Discard all cached results.
+ *
+ * Queries in progress complete normally but their results are not kept.
+ */
+void dns_cache_flush(void)
+{
+	fibril_mutex_lock(&cache_lock);
+
+	list_foreach_safe(cache_lru, cur, next) {
+		dns_cache_entry_t *entry = list_get_instance(cur,
+		    dns_cache_entry_t, llru);
+		dns_cache_remove(entry);
+	}
+
+	fibril_mutex_unlock(&cache_lock);
 }
 
 errno_t dns_name2host(const char *name, dns_host_info_t **rinfo, ip_ver_t ver)
@@ -199,17 +738,17 @@ errno_t dns_name2host(const char *name, dns_host_info_t **rinfo, ip_ver_t ver)
 
 	switch (ver) {
 	case ip_any:
-		rc = dns_name_query(name, DTYPE_AAAA, info);
+		rc = dns_cache_query(name, DTYPE_AAAA, info);
 
 		if (rc != EOK)
-			rc = dns_name_query(name, DTYPE_A, info);
+			rc = dns_cache_query(name, DTYPE_A, info);
 
 		break;
 	case ip_v4:
-		rc = dns_name_query(name, DTYPE_A, info);
+		rc = dns_cache_query(name, DTYPE_A, info);
 		break;
 	case ip_v6:
-		rc = dns_name_query(name, DTYPE_AAAA, info);
+		rc = dns_cache_query(name, DTYPE_AAAA, info);
 		break;
 	default:
 		rc = EINVAL;
@@ -41,6 +41,7 @@
 
 extern errno_t dns_name2host(const char *, dns_host_info_t **, ip_ver_t);
 extern void dns_hostinfo_destroy(dns_host_info_t *);
+extern void dns_cache_flush(void);
 
 #endif
 
@@ -47,9 +47,6 @@
 #include "pdu.h"
 #include "std.h"
 
-/** Time to wait for ARP reply in microseconds */
-#define ARP_REQUEST_TIMEOUT (3 * 1000 * 1000)
-
 static errno_t arp_send_packet(ethip_nic_t *nic, arp_eth_packet_t *packet);
 
 void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
@@ -94,18 +91,37 @@ void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
 	}
 }
 
-errno_t arp_translate(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
-    eth_addr_t *mac_addr)
+/** Send encoded frame to IPv4 address.
+ *
+ * The destination MAC address of the frame is filled in. If it is not
+ * known yet, the frame is queued and sent when the ARP reply arrives.
+ *
+ * @param nic      NIC
+ * @param src_addr Source IPv4 address for the ARP request
+ * @param ip_addr  Destination IPv4 address
+ * @param data     Encoded frame
+ * @param size     Frame size
+ * @param csum     Checksum offload request or @c NULL
+ *
+ * @return EOK on success or an error code
+ */
+errno_t arp_send_frame(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
+    void *data, size_t size, const nic_csum_t *csum)
 {
+	eth_header_t *hdr = (eth_header_t *) data;
+	eth_addr_t bcast_addr;
+	bool request;
+
 	/* Broadcast address */
 	if (ip_addr == addr32_broadcast_all_hosts) {
-		*mac_addr = eth_addr_broadcast;
-		return EOK;
+		bcast_addr = eth_addr_broadcast;
+		eth_addr_encode(&bcast_addr, hdr->dest);
+		return ethip_nic_send(nic, data, size, csum);
 	}
 
-	errno_t rc = atrans_lookup(ip_addr, mac_addr);
-	if (rc == EOK)
-		return EOK;
+	errno_t rc = atrans_send(nic, ip_addr, data, size, csum, &request);
+	if (rc != EOK || !request)
+		return rc;
 
 	arp_eth_packet_t packet;
 
@@ -115,11 +131,8 @@ errno_t arp_translate(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
 	packet.target_hw_addr = eth_addr_broadcast;
 	packet.target_proto_addr = ip_addr;
 
-	rc = arp_send_packet(nic, &packet);
-	if (rc != EOK)
-		return rc;
-
-	return atrans_lookup_timeout(ip_addr, ARP_REQUEST_TIMEOUT, mac_addr);
+	(void) arp_send_packet(nic, &packet);
+	return EOK;
 }
 
 static errno_t arp_send_packet(ethip_nic_t *nic, arp_eth_packet_t *packet)
@@ -150,7 +163,7 @@ static errno_t arp_send_packet(ethip_nic_t *nic, arp_eth_packet_t *packet)
 		return rc;
 	}
 
-	rc = ethip_nic_send(nic, fdata, fsize);
+	rc = ethip_nic_send(nic, fdata, fsize, NULL);
 	free(fdata);
 	free(pdata);
 
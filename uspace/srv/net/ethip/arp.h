@@ -43,7 +43,8 @@
 #include "ethip.h"
 
 extern void arp_received(ethip_nic_t *, eth_frame_t *);
-extern errno_t arp_translate(ethip_nic_t *, addr32_t, addr32_t, eth_addr_t *);
+extern errno_t arp_send_frame(ethip_nic_t *, addr32_t, addr32_t, void *,
+    size_t, const nic_csum_t *);
 
 #endif
 
@@ -34,132 +34,438 @@
  * @brief
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <inet/eth_addr.h>
 #include <inet/iplink_srv.h>
+#include <io/log.h>
+#include <mem.h>
 #include <stdlib.h>
 
 #include "atrans.h"
 #include "ethip.h"
+#include "ethip_nic.h"
+#include "std.h"
 
-/** Address translation list (of ethip_atrans_t) */
+/** Seconds after confirmation after which a translation is refreshed */
+#define ATRANS_REACHABLE_TIME 60
+
+/** Seconds after confirmation after which a translation is discarded */
+#define ATRANS_STALE_TIME 600
+
+/** Minimum seconds between two requests for the same address */
+#define ATRANS_RETRY_TIME 1
+
+/** Unanswered requests after which waiting frames are dropped */
+#define ATRANS_REQUEST_MAX 3
+
+/** Maximum number of frames waiting for one address */
+#define ATRANS_PENDING_MAX 3
+
+/** Maximum number of entries in the translation table */
+#define ATRANS_MAX 512
+
+static size_t atrans_key_hash(const void *);
+static size_t atrans_hash(const ht_link_t *);
+static bool atrans_key_equal(const void *, const ht_link_t *);
+
+static const hash_table_ops_t atrans_map_ops = {
+	.hash = atrans_hash,
+	.key_hash = atrans_key_hash,
+	.key_equal = atrans_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Address translation table (of ethip_atrans_t) */
 static FIBRIL_MUTEX_INITIALIZE(atrans_list_lock);
 static LIST_INITIALIZE(atrans_list);
-static FIBRIL_CONDVAR_INITIALIZE(atrans_cv);
+static hash_table_t atrans_map;
+static bool atrans_map_initialized;
+static size_t atrans_count;
+static ethip_atrans_stats_t atrans_stats;
+
+static size_t atrans_key_hash(const void *arg)
+{
+	const addr32_t *ip_addr = arg;
+
+	return hash_mix32(*ip_addr);
+}
+
+static size_t atrans_hash(const ht_link_t *item)
+{
+	ethip_atrans_t *atrans = hash_table_get_inst(item, ethip_atrans_t,
+	    atrans_map);
+
+	return atrans_key_hash(&atrans->ip_addr);
+}
+
+static bool atrans_key_equal(const void *arg, const ht_link_t *item)
+{
+	const addr32_t *ip_addr = arg;
+	ethip_atrans_t *atrans = hash_table_get_inst(item, ethip_atrans_t,
+	    atrans_map);
+
+	return atrans->ip_addr == *ip_addr;
+}
+
+static time_t atrans_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return ts.tv_sec;
+}
+
+static errno_t atrans_init_locked(void)
+{
+	assert(fibril_mutex_is_locked(&atrans_list_lock));
+
+	if (atrans_map_initialized)
+		return EOK;
+
+	if (!hash_table_create(&atrans_map, 0, 0, &atrans_map_ops))
+		return ENOMEM;
+
+	atrans_map_initialized = true;
+	return EOK;
+}
 
 static ethip_atrans_t *atrans_find(addr32_t ip_addr)
 {
-	list_foreach(atrans_list, atrans_list, ethip_atrans_t, atrans) {
-		if (atrans->ip_addr == ip_addr)
-			return atrans;
+	ht_link_t *link;
+
+	assert(fibril_mutex_is_locked(&atrans_list_lock));
+
+	link = hash_table_find(&atrans_map, &ip_addr);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, ethip_atrans_t, atrans_map);
+}
+
+/** Drop all frames waiting for the translation. */
+static void atrans_pending_drop(ethip_atrans_t *atrans)
+{
+	link_t *link;
+
+	while ((link = list_first(&atrans->pending)) != NULL) {
+		ethip_atrans_pkt_t *pkt = list_get_instance(link,
+		    ethip_atrans_pkt_t, lpending);
+
+		list_remove(&pkt->lpending);
+		free(pkt->data);
+		free(pkt);
+		++atrans_stats.dropped;
 	}
 
-	return NULL;
+	atrans->npending = 0;
 }
 
-errno_t atrans_add(addr32_t ip_addr, eth_addr_t *mac_addr)
+/** Remove entry from the table and destroy it. */
+static void atrans_destroy(ethip_atrans_t *atrans)
+{
+	assert(fibril_mutex_is_locked(&atrans_list_lock));
+
+	hash_table_remove_item(&atrans_map, &atrans->atrans_map);
+	list_remove(&atrans->atrans_list);
+	--atrans_count;
+
+	atrans_pending_drop(atrans);
+	free(atrans);
+}
+
+/** Create new unresolved entry.
+ *
+ * If the table is full, the least recently confirmed entry is discarded.
+ */
+static ethip_atrans_t *atrans_create(addr32_t ip_addr)
 {
 	ethip_atrans_t *atrans;
-	ethip_atrans_t *prev;
+	link_t *link;
+
+	assert(fibril_mutex_is_locked(&atrans_list_lock));
+
+	if (atrans_count >= ATRANS_MAX) {
+		link = list_first(&atrans_list);
+		assert(link != NULL);
+		atrans_destroy(list_get_instance(link, ethip_atrans_t,
+		    atrans_list));
+	}
 
 	atrans = calloc(1, sizeof(ethip_atrans_t));
 	if (atrans == NULL)
-		return ENOMEM;
+		return NULL;
 
 	atrans->ip_addr = ip_addr;
-	atrans->mac_addr = *mac_addr;
+	list_initialize(&atrans->pending);
 
-	fibril_mutex_lock(&atrans_list_lock);
-	prev = atrans_find(ip_addr);
-	if (prev != NULL) {
-		list_remove(&prev->atrans_list);
-		free(prev);
+	hash_table_insert(&atrans_map, &atrans->atrans_map);
+	list_append(&atrans->atrans_list, &atrans_list);
+	++atrans_count;
+
+	return atrans;
+}
+
+/** Get valid translation from entry.
+ *
+ * Entries which have not been confirmed for too long are no longer used.
+ */
+static bool atrans_valid(ethip_atrans_t *atrans, time_t now)
+{
+	if (atrans->resolved && now - atrans->confirmed >= ATRANS_STALE_TIME) {
+		atrans->resolved = false;
+		atrans->nrequests = 0;
 	}
 
-	list_append(&atrans->atrans_list, &atrans_list);
-	fibril_mutex_unlock(&atrans_list_lock);
-	fibril_condvar_broadcast(&atrans_cv);
+	return atrans->resolved;
+}
 
-	return EOK;
+/** Fill in destination address of encoded frame and send it. */
+static errno_t atrans_frame_send(ethip_nic_t *nic, eth_addr_t *mac_addr,
+    void *data, size_t size, const nic_csum_t *csum)
+{
+	eth_header_t *hdr = (eth_header_t *) data;
+
+	assert(size >= sizeof(eth_header_t));
+	eth_addr_encode(mac_addr, hdr->dest);
+	return ethip_nic_send(nic, data, size, csum);
 }
 
-errno_t atrans_remove(addr32_t ip_addr)
+/** Add or confirm address translation.
+ *
+ * Frames waiting for the translation are sent.
+ *
+ * @param ip_addr  IPv4 address
+ * @param mac_addr MAC address
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t atrans_add(addr32_t ip_addr, eth_addr_t *mac_addr)
 {
 	ethip_atrans_t *atrans;
+	list_t pending;
+	link_t *link;
+	errno_t rc;
 
 	fibril_mutex_lock(&atrans_list_lock);
+
+	rc = atrans_init_locked();
+	if (rc != EOK) {
+		fibril_mutex_unlock(&atrans_list_lock);
+		return rc;
+	}
+
 	atrans = atrans_find(ip_addr);
 	if (atrans == NULL) {
-		fibril_mutex_unlock(&atrans_list_lock);
-		return ENOENT;
+		atrans = atrans_create(ip_addr);
+		if (atrans == NULL) {
+			fibril_mutex_unlock(&atrans_list_lock);
+			return ENOMEM;
+		}
 	}
 
+	atrans->mac_addr = *mac_addr;
+	atrans->resolved = true;
+	atrans->confirmed = atrans_now();
+	atrans->nrequests = 0;
+
+	/* Keep the list ordered by the time of confirmation */
 	list_remove(&atrans->atrans_list);
+	list_append(&atrans->atrans_list, &atrans_list);
+
+	list_initialize(&pending);
+	list_concat(&pending, &atrans->pending);
+	atrans->npending = 0;
+
 	fibril_mutex_unlock(&atrans_list_lock);
-	free(atrans);
+
+	while ((link = list_first(&pending)) != NULL) {
+		ethip_atrans_pkt_t *pkt = list_get_instance(link,
+		    ethip_atrans_pkt_t, lpending);
+
+		list_remove(&pkt->lpending);
+		(void) atrans_frame_send(pkt->nic, mac_addr, pkt->data,
+		    pkt->size, pkt->has_csum ? &pkt->csum : NULL);
+		free(pkt->data);
+		free(pkt);
+	}
 
 	return EOK;
 }
 
-static errno_t atrans_lookup_locked(addr32_t ip_addr, eth_addr_t *mac_addr)
+errno_t atrans_remove(addr32_t ip_addr)
 {
-	ethip_atrans_t *atrans = atrans_find(ip_addr);
-	if (atrans == NULL)
+	ethip_atrans_t *atrans;
+
+	fibril_mutex_lock(&atrans_list_lock);
+
+	if (!atrans_map_initialized) {
+		fibril_mutex_unlock(&atrans_list_lock);
 		return ENOENT;
+	}
+
+	atrans = atrans_find(ip_addr);
+	if (atrans == NULL) {
+		fibril_mutex_unlock(&atrans_list_lock);
+		return ENOENT;
+	}
+
+	atrans_destroy(atrans);
+	fibril_mutex_unlock(&atrans_list_lock);
 
-	*mac_addr = atrans->mac_addr;
 	return EOK;
 }
 
 errno_t atrans_lookup(addr32_t ip_addr, eth_addr_t *mac_addr)
 {
-	errno_t rc;
+	ethip_atrans_t *atrans;
+	errno_t rc = ENOENT;
 
 	fibril_mutex_lock(&atrans_list_lock);
-	rc = atrans_lookup_locked(ip_addr, mac_addr);
-	fibril_mutex_unlock(&atrans_list_lock);
 
+	if (atrans_map_initialized) {
+		atrans = atrans_find(ip_addr);
+		if (atrans != NULL && atrans_valid(atrans, atrans_now())) {
+			*mac_addr = atrans->mac_addr;
+			rc = EOK;
+		}
+	}
+
+	fibril_mutex_unlock(&atrans_list_lock);
 	return rc;
 }
 
-static void atrans_lookup_timeout_handler(void *arg)
+/** Send encoded frame to IPv4 address.
+ *
+ * If the address is resolved, the destination MAC address is filled in
+ * and the frame is sent right away. Otherwise a copy of the frame is
+ * queued until the translation is added, so that the sender does not
+ * need to wait.
+ *
+ * @param nic      NIC
+ * @param ip_addr  Destination IPv4 address
+ * @param data     Encoded frame
+ * @param size     Frame size
+ * @param csum     Checksum offload request or @c NULL
+ * @param rrequest Place to store @c true if the caller should send
+ *                 a request for @a ip_addr
+ *
+ * @return EOK on success or an error code
+ */
+errno_t atrans_send(ethip_nic_t *nic, addr32_t ip_addr, void *data,
+    size_t size, const nic_csum_t *csum, bool *rrequest)
 {
-	bool *timedout = (bool *)arg;
+	ethip_atrans_t *atrans;
+	ethip_atrans_pkt_t *pkt;
+	eth_addr_t mac_addr;
+	time_t now;
+	errno_t rc;
+
+	*rrequest = false;
+	now = atrans_now();
 
 	fibril_mutex_lock(&atrans_list_lock);
-	*timedout = true;
-	fibril_mutex_unlock(&atrans_list_lock);
-	fibril_condvar_broadcast(&atrans_cv);
-}
 
-errno_t atrans_lookup_timeout(addr32_t ip_addr, usec_t timeout,
-    eth_addr_t *mac_addr)
-{
-	fibril_timer_t *t;
-	bool timedout;
-	errno_t rc;
+	rc = atrans_init_locked();
+	if (rc != EOK) {
+		fibril_mutex_unlock(&atrans_list_lock);
+		return rc;
+	}
+
+	atrans = atrans_find(ip_addr);
+	if (atrans != NULL && atrans_valid(atrans, now)) {
+		++atrans_stats.hits;
+		mac_addr = atrans->mac_addr;
+
+		/* Refresh translation which was not confirmed lately */
+		if (now - atrans->confirmed >= ATRANS_REACHABLE_TIME &&
+		    now - atrans->requested >= ATRANS_RETRY_TIME) {
+			atrans->requested = now;
+			*rrequest = true;
+		}
+
+		fibril_mutex_unlock(&atrans_list_lock);
+		return atrans_frame_send(nic, &mac_addr, data, size, csum);
+	}
+
+	++atrans_stats.misses;
+
+	if (atrans == NULL) {
+		atrans = atrans_create(ip_addr);
+		if (atrans == NULL) {
+			fibril_mutex_unlock(&atrans_list_lock);
+			return ENOMEM;
+		}
+
+		*rrequest = true;
+	} else if (now - atrans->requested >= ATRANS_RETRY_TIME) {
+		/* Give up on frames waiting for too long */
+		if (atrans->nrequests >= ATRANS_REQUEST_MAX) {
+			atrans_pending_drop(atrans);
+			atrans->nrequests = 0;
+		}
+
+		*rrequest = true;
+	}
 
-	t = fibril_timer_create(NULL);
-	if (t == NULL)
+	if (*rrequest) {
+		atrans->requested = now;
+		++atrans->nrequests;
+	}
+
+	pkt = calloc(1, sizeof(ethip_atrans_pkt_t));
+	if (pkt == NULL) {
+		fibril_mutex_unlock(&atrans_list_lock);
+		return ENOMEM;
+	}
+
+	pkt->data = malloc(size);
+	if (pkt->data == NULL) {
+		free(pkt);
+		fibril_mutex_unlock(&atrans_list_lock);
 		return ENOMEM;
+	}
 
-	timedout = false;
-	fibril_timer_set(t, timeout, atrans_lookup_timeout_handler, &timedout);
+	memcpy(pkt->data, data, size);
+	pkt->nic = nic;
+	pkt->size = size;
+	if (csum != NULL) {
+		pkt->has_csum = true;
+		pkt->csum = *csum;
+	}
 
-	fibril_mutex_lock(&atrans_list_lock);
+	/* Make room by dropping the oldest frame */
+	if (atrans->npending >= ATRANS_PENDING_MAX) {
+		ethip_atrans_pkt_t *old = list_get_instance(
+		    list_first(&atrans->pending), ethip_atrans_pkt_t, lpending);
 
-	while ((rc = atrans_lookup_locked(ip_addr, mac_addr)) == ENOENT &&
-	    !timedout) {
-		fibril_condvar_wait(&atrans_cv, &atrans_list_lock);
+		list_remove(&old->lpending);
+		free(old->data);
+		free(old);
+		--atrans->npending;
+		++atrans_stats.dropped;
 	}
 
+	list_append(&pkt->lpending, &atrans->pending);
+	++atrans->npending;
+
 	fibril_mutex_unlock(&atrans_list_lock);
-	(void) fibril_timer_clear(t);
-	fibril_timer_destroy(t);
+	return EOK;
+}
 
-	return rc;
+/** Get address translation statistics.
+ *
+ * @param stats Place to store statistics
+ */
+void atrans_get_stats(ethip_atrans_stats_t *stats)
+{
+	fibril_mutex_lock(&atrans_list_lock);
+	*stats = atrans_stats;
+	fibril_mutex_unlock(&atrans_list_lock);
 }
 
 /** @}
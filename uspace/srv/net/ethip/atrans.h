@@ -45,7 +45,9 @@
 extern errno_t atrans_add(addr32_t, eth_addr_t *);
 extern errno_t atrans_remove(addr32_t);
 extern errno_t atrans_lookup(addr32_t, eth_addr_t *);
-extern errno_t atrans_lookup_timeout(addr32_t, usec_t, eth_addr_t *);
+extern errno_t atrans_send(ethip_nic_t *, addr32_t, void *, size_t,
+    const nic_csum_t *, bool *);
+extern void atrans_get_stats(ethip_atrans_stats_t *);
 
 #endif
 
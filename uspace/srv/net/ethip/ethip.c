@@ -44,6 +44,7 @@
 #include <loc.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <str_error.h>
 #include <task.h>
 #include "arp.h"
 #include "ethip.h"
@@ -58,6 +59,7 @@ static errno_t ethip_close(iplink_srv_t *srv);
 static errno_t ethip_send(iplink_srv_t *srv, iplink_sdu_t *sdu);
 static errno_t ethip_send6(iplink_srv_t *srv, iplink_sdu6_t *sdu);
 static errno_t ethip_get_mtu(iplink_srv_t *srv, size_t *mtu);
+static errno_t ethip_get_offload(iplink_srv_t *srv, bool *offload);
 static errno_t ethip_get_mac48(iplink_srv_t *srv, eth_addr_t *mac);
 static errno_t ethip_set_mac48(iplink_srv_t *srv, eth_addr_t *mac);
 static errno_t ethip_addr_add(iplink_srv_t *srv, inet_addr_t *addr);
@@ -71,6 +73,7 @@ static iplink_ops_t ethip_iplink_ops = {
 	.send = ethip_send,
 	.send6 = ethip_send6,
 	.get_mtu = ethip_get_mtu,
+	.get_offload = ethip_get_offload,
 	.get_mac48 = ethip_get_mac48,
 	.set_mac48 = ethip_set_mac48,
 	.addr_add = ethip_addr_add,
@@ -176,14 +179,10 @@ static errno_t ethip_send(iplink_srv_t *srv, iplink_sdu_t *sdu)
 
 	ethip_nic_t *nic = (ethip_nic_t *) srv->arg;
 	eth_frame_t frame;
+	nic_csum_t csum;
 
-	errno_t rc = arp_translate(nic, sdu->src, sdu->dest, &frame.dest);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Failed to look up IPv4 address 0x%"
-		    PRIx32, sdu->dest);
-		return rc;
-	}
-
+	/* Filled in by arp_send_frame() */
+	frame.dest = eth_addr_broadcast;
 	frame.src = nic->mac_addr;
 	frame.etype_len = ETYPE_IP;
 	frame.data = sdu->data;
@@ -191,11 +190,24 @@ static errno_t ethip_send(iplink_srv_t *srv, iplink_sdu_t *sdu)
 
 	void *data;
 	size_t size;
-	rc = eth_pdu_encode(&frame, &data, &size);
+	errno_t rc = eth_pdu_encode(&frame, &data, &size);
 	if (rc != EOK)
 		return rc;
 
-	rc = ethip_nic_send(nic, data, size);
+	if (sdu->csum_offset != 0) {
+		/* Let the NIC complete the checksum */
+		csum.start = sizeof(eth_header_t) + sdu->csum_start;
+		csum.offset = sdu->csum_offset;
+		rc = arp_send_frame(nic, sdu->src, sdu->dest, data, size, &csum);
+	} else {
+		rc = arp_send_frame(nic, sdu->src, sdu->dest, data, size, NULL);
+	}
+
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed to send to IPv4 address "
+		    "0x%" PRIx32, sdu->dest);
+	}
+
 	free(data);
 
 	return rc;
@@ -220,13 +232,61 @@ static errno_t ethip_send6(iplink_srv_t *srv, iplink_sdu6_t *sdu)
 	if (rc != EOK)
 		return rc;
 
-	rc = ethip_nic_send(nic, data, size);
+	rc = ethip_nic_send(nic, data, size, NULL);
 	free(data);
 
 	return rc;
 }
 
-errno_t ethip_received(iplink_srv_t *srv, void *data, size_t size)
+/** Pass a received SDU to the client.
+ *
+ * @param nic   NIC
+ * @param sdu   SDU
+ * @param ver   IP version
+ * @param batch Batch to add the SDU to or @c NULL to pass it right away
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t ethip_recv_sdu(ethip_nic_t *nic, iplink_recv_sdu_t *sdu,
+    ip_ver_t ver, iplink_batch_t *batch)
+{
+	errno_t rc;
+
+	if (batch == NULL)
+		return iplink_ev_recv(&nic->iplink, sdu, ver);
+
+	rc = iplink_batch_add_recv(batch, sdu, ver);
+	if (rc != ELIMIT)
+		return rc;
+
+	/* The batch is full, pass it and start a new one */
+	rc = iplink_ev_recv_batch(&nic->iplink, batch);
+	iplink_batch_clear(batch);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "iplink_ev_recv_batch() "
+		    "failed: %s", str_error_name(rc));
+	}
+
+	rc = iplink_batch_add_recv(batch, sdu, ver);
+	if (rc == ELIMIT)
+		return iplink_ev_recv(&nic->iplink, sdu, ver);
+
+	return rc;
+}
+
+/** Process a received Ethernet frame.
+ *
+ * @param srv   IP link server
+ * @param data  Frame data
+ * @param size  Frame size
+ * @param batch Batch to collect the received SDUs in or @c NULL to pass
+ *              them to the client right away. The caller passes the batch
+ *              to the client with iplink_ev_recv_batch().
+ *
+ * @return EOK on success or an error code
+ */
+errno_t ethip_received(iplink_srv_t *srv, void *data, size_t size,
+    iplink_batch_t *batch)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_received(): srv=%p", srv);
 	ethip_nic_t *nic = (ethip_nic_t *) srv->arg;
@@ -251,14 +311,14 @@ errno_t ethip_received(iplink_srv_t *srv, void *data, size_t size)
 		sdu.data = frame.data;
 		sdu.size = frame.size;
 		log_msg(LOG_DEFAULT, LVL_DEBUG, " - call iplink_ev_recv");
-		rc = iplink_ev_recv(&nic->iplink, &sdu, ip_v4);
+		rc = ethip_recv_sdu(nic, &sdu, ip_v4, batch);
 		break;
 	case ETYPE_IPV6:
 		log_msg(LOG_DEFAULT, LVL_DEBUG, " - construct SDU IPv6");
 		sdu.data = frame.data;
 		sdu.size = frame.size;
 		log_msg(LOG_DEFAULT, LVL_DEBUG, " - call iplink_ev_recv");
-		rc = iplink_ev_recv(&nic->iplink, &sdu, ip_v6);
+		rc = ethip_recv_sdu(nic, &sdu, ip_v6, batch);
 		break;
 	default:
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "Unknown ethertype 0x%" PRIx16,
@@ -276,6 +336,15 @@ static errno_t ethip_get_mtu(iplink_srv_t *srv, size_t *mtu)
 	return EOK;
 }
 
+static errno_t ethip_get_offload(iplink_srv_t *srv, bool *offload)
+{
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_get_offload()");
+
+	ethip_nic_t *nic = (ethip_nic_t *) srv->arg;
+	*offload = nic->tx_csum;
+	return EOK;
+}
+
 static errno_t ethip_get_mac48(iplink_srv_t *srv, eth_addr_t *mac)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_get_mac48()");
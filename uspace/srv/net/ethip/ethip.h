@@ -37,14 +37,19 @@
 #ifndef ETHIP_H_
 #define ETHIP_H_
 
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <async.h>
+#include <fibril_synch.h>
 #include <inet/addr.h>
 #include <inet/eth_addr.h>
 #include <inet/iplink_srv.h>
 #include <loc.h>
+#include <nic/nic.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 
 typedef struct {
 	link_t link;
@@ -56,6 +61,14 @@ typedef struct ethip_nic {
 	service_id_t svc_id;
 	char *svc_name;
 	async_sess_t *sess;
+	/** Frame rings shared with the NIC or @c NULL */
+	nic_rings_t *rings;
+	/** Lock for producing to the tx ring */
+	fibril_mutex_t tx_lock;
+	/** Batch of SDUs received from the rx ring or @c NULL */
+	iplink_batch_t *rx_batch;
+	/** NIC completes transport checksums of frames to send */
+	bool tx_csum;
 
 	iplink_srv_t iplink;
 	service_id_t iplink_sid;
@@ -109,15 +122,57 @@ typedef struct {
 	addr32_t target_proto_addr;
 } arp_eth_packet_t;
 
+/** Frame waiting for address translation */
+typedef struct {
+	/** Link to ethip_atrans_t.pending */
+	link_t lpending;
+	/** NIC to send the frame through */
+	ethip_nic_t *nic;
+	/** Encoded frame, destination address is filled in when resolved */
+	void *data;
+	/** Frame size */
+	size_t size;
+	/** @c true if @c csum is valid */
+	bool has_csum;
+	/** Checksum offload request */
+	nic_csum_t csum;
+} ethip_atrans_pkt_t;
+
 /** Address translation table element */
 typedef struct {
+	/** Link to atrans_map */
+	ht_link_t atrans_map;
+	/** Link to atrans_list, least recently confirmed first */
 	link_t atrans_list;
 	addr32_t ip_addr;
 	eth_addr_t mac_addr;
+	/** @c true if @c mac_addr is valid */
+	bool resolved;
+	/** Uptime in seconds when the translation was last confirmed */
+	time_t confirmed;
+	/** Uptime in seconds when the last request was sent */
+	time_t requested;
+	/** Number of requests sent since the last confirmation */
+	unsigned nrequests;
+	/** Frames waiting for resolution (of ethip_atrans_pkt_t) */
+	list_t pending;
+	/** Number of frames in @c pending */
+	size_t npending;
 } ethip_atrans_t;
 
+/** Address translation statistics */
+typedef struct {
+	/** Number of frames sent to a resolved address */
+	uint64_t hits;
+	/** Number of frames sent to an unresolved address */
+	uint64_t misses;
+	/** Number of frames dropped while waiting for resolution */
+	uint64_t dropped;
+} ethip_atrans_stats_t;
+
 extern errno_t ethip_iplink_init(ethip_nic_t *);
-extern errno_t ethip_received(iplink_srv_t *, void *, size_t);
+extern errno_t ethip_received(iplink_srv_t *, void *, size_t,
+    iplink_batch_t *);
 
 #endif
 
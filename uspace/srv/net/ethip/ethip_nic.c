@@ -35,6 +35,7 @@
  */
 
 #include <adt/list.h>
+#include <as.h>
 #include <async.h>
 #include <errno.h>
 #include <fibril_synch.h>
@@ -115,6 +116,7 @@ static ethip_nic_t *ethip_nic_new(void)
 
 	link_initialize(&nic->link);
 	list_initialize(&nic->addr_list);
+	fibril_mutex_initialize(&nic->tx_lock);
 
 	return nic;
 }
@@ -139,6 +141,11 @@ static void ethip_nic_delete(ethip_nic_t *nic)
 	if (nic->svc_name != NULL)
 		free(nic->svc_name);
 
+	if (nic->rings != NULL)
+		as_area_destroy(nic->rings);
+
+	iplink_batch_destroy(nic->rx_batch);
+
 	free(nic);
 }
 
@@ -147,6 +154,67 @@ static void ethip_link_addr_delete(ethip_link_addr_t *laddr)
 	free(laddr);
 }
 
+/** Share frame rings with the NIC.
+ *
+ * If the NIC does not support frame rings, frames keep being passed in IPC
+ * messages.
+ *
+ * @param nic	NIC
+ */
+static void ethip_nic_rings_setup(ethip_nic_t *nic)
+{
+	nic_rings_t *rings;
+	errno_t rc;
+
+	rings = as_area_create(AS_AREA_ANY, sizeof(nic_rings_t),
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (rings == AS_MAP_FAILED)
+		return;
+
+	nic_ring_init(&rings->rx);
+	nic_ring_init(&rings->tx);
+
+	rc = nic_rings_setup(nic->sess, rings);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "NIC '%s' does not use frame "
+		    "rings: %s.", nic->svc_name, str_error_name(rc));
+		as_area_destroy(rings);
+		return;
+	}
+
+	nic->rings = rings;
+
+	/*
+	 * Frames arrive from the ring in bursts, pass the SDUs to the client
+	 * in batches. Without a batch they are passed one by one.
+	 */
+	(void) iplink_batch_create(DATA_XFER_LIMIT, &nic->rx_batch);
+}
+
+/** Let the NIC complete transport checksums if it can.
+ *
+ * @param nic	NIC
+ */
+static void ethip_nic_offload_setup(ethip_nic_t *nic)
+{
+	uint32_t supported;
+	uint32_t active;
+	errno_t rc;
+
+	rc = nic_offload_probe(nic->sess, &supported, &active);
+	if (rc != EOK || (supported & NIC_OFFLOAD_TX_CSUM) == 0)
+		return;
+
+	rc = nic_offload_set(nic->sess, NIC_OFFLOAD_TX_CSUM,
+	    NIC_OFFLOAD_TX_CSUM);
+	if (rc != EOK)
+		return;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "NIC '%s' computes checksums.",
+	    nic->svc_name);
+	nic->tx_csum = true;
+}
+
 static errno_t ethip_nic_open(service_id_t sid)
 {
 	bool in_list = false;
@@ -178,6 +246,9 @@ static errno_t ethip_nic_open(service_id_t sid)
 		goto error;
 	}
 
+	ethip_nic_rings_setup(nic);
+	ethip_nic_offload_setup(nic);
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Opened NIC '%s'", nic->svc_name);
 	list_append(&nic->link, &ethip_nic_list);
 	in_list = true;
@@ -275,7 +346,7 @@ static void ethip_nic_received(ethip_nic_t *nic, ipc_call_t *call)
 	    size);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "call ethip_received");
-	rc = ethip_received(&nic->iplink, data, size);
+	rc = ethip_received(&nic->iplink, data, size, NULL);
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "free data");
 	free(data);
 
@@ -283,6 +354,37 @@ static void ethip_nic_received(ethip_nic_t *nic, ipc_call_t *call)
 	async_answer_0(call, rc);
 }
 
+/** Consume the frames the NIC put to the rx ring. */
+static void ethip_nic_rx_kick(ethip_nic_t *nic, ipc_call_t *call)
+{
+	nic_ring_t *ring;
+	nic_csum_t csum;
+	void *data;
+	size_t size;
+
+	async_answer_0(call, EOK);
+
+	if (nic->rings == NULL)
+		return;
+
+	ring = &nic->rings->rx;
+
+	do {
+		while ((data = nic_ring_peek(ring, &size, &csum)) != NULL) {
+			if (size <= NIC_RING_SLOT_SIZE) {
+				(void) ethip_received(&nic->iplink, data, size,
+				    nic->rx_batch);
+			}
+			nic_ring_pop(ring);
+		}
+
+		if (nic->rx_batch != NULL) {
+			(void) iplink_ev_recv_batch(&nic->iplink, nic->rx_batch);
+			iplink_batch_clear(nic->rx_batch);
+		}
+	} while (!nic_ring_idle(ring));
+}
+
 static void ethip_nic_device_state(ethip_nic_t *nic, ipc_call_t *call)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_device_state()");
@@ -314,6 +416,9 @@ static void ethip_nic_cb_conn(ipc_call_t *icall, void *arg)
 		case NIC_EV_DEVICE_STATE:
 			ethip_nic_device_state(nic, &call);
 			break;
+		case NIC_EV_RX_KICK:
+			ethip_nic_rx_kick(nic, &call);
+			break;
 		default:
 			log_msg(LOG_DEFAULT, LVL_DEBUG, "unknown IPC method: %" PRIun, ipc_get_imethod(&call));
 			async_answer_0(&call, ENOTSUP);
@@ -350,11 +455,54 @@ ethip_nic_t *ethip_nic_find_by_iplink_sid(service_id_t iplink_sid)
 	return NULL;
 }
 
-errno_t ethip_nic_send(ethip_nic_t *nic, void *data, size_t size)
+/** Send a frame using the tx ring.
+ *
+ * If the ring is full, wait for the NIC to drain it.
+ */
+static errno_t ethip_nic_send_ring(ethip_nic_t *nic, void *data, size_t size,
+    const nic_csum_t *csum)
+{
+	errno_t rc;
+	bool kick;
+
+	fibril_mutex_lock(&nic->tx_lock);
+
+	while (!nic_ring_put(&nic->rings->tx, data, size, csum, &kick)) {
+		rc = nic_tx_kick(nic->sess, true);
+		if (rc != EOK) {
+			fibril_mutex_unlock(&nic->tx_lock);
+			return rc;
+		}
+	}
+
+	fibril_mutex_unlock(&nic->tx_lock);
+
+	if (kick)
+		return nic_tx_kick(nic->sess, false);
+
+	return EOK;
+}
+
+/** Send a frame.
+ *
+ * @param nic	NIC
+ * @param data	Frame data
+ * @param size	Frame size
+ * @param csum	Checksum for the NIC to complete or @c NULL if the frame
+ *		is complete
+ *
+ * @return EOK on success or an error code
+ */
+errno_t ethip_nic_send(ethip_nic_t *nic, void *data, size_t size,
+    const nic_csum_t *csum)
 {
 	errno_t rc;
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_send(size=%zu)", size);
-	rc = nic_send_frame(nic->sess, data, size);
+
+	if (nic->rings != NULL && size <= NIC_RING_SLOT_SIZE)
+		return ethip_nic_send_ring(nic, data, size, csum);
+
+	rc = nic_send_frame(nic->sess, data, size, csum);
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "nic_send_frame -> %s", str_error_name(rc));
 	return rc;
 }
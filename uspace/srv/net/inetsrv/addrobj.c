@@ -46,6 +46,7 @@
 #include "inetsrv.h"
 #include "inet_link.h"
 #include "ndp.h"
+#include "rcache.h"
 
 static inet_addrobj_t *inet_addrobj_find_by_name_locked(const char *, inet_link_t *);
 
@@ -93,6 +94,8 @@ errno_t inet_addrobj_add(inet_addrobj_t *addr)
 	list_append(&addr->addr_list, &addr_list);
 	fibril_mutex_unlock(&addr_list_lock);
 
+	inet_rcache_flush();
+
 	return EOK;
 }
 
@@ -101,6 +104,8 @@ void inet_addrobj_remove(inet_addrobj_t *addr)
 	fibril_mutex_lock(&addr_list_lock);
 	list_remove(&addr->addr_list);
 	fibril_mutex_unlock(&addr_list_lock);
+
+	inet_rcache_flush();
 }
 
 /** Find address object matching address @a addr.
@@ -228,9 +233,6 @@ errno_t inet_addrobj_send_dgram(inet_addrobj_t *addr, inet_addr_t *ldest,
 	if (lsrc_ver != ldest_ver)
 		return EINVAL;
 
-	errno_t rc;
-	eth_addr_t ldest_mac;
-
 	switch (ldest_ver) {
 	case ip_v4:
 		return inet_link_send_dgram(addr->ilink, lsrc_v4, ldest_v4,
@@ -239,11 +241,7 @@ errno_t inet_addrobj_send_dgram(inet_addrobj_t *addr, inet_addr_t *ldest,
 		/*
 		 * Translate local destination IPv6 address.
 		 */
-		rc = ndp_translate(lsrc_v6, ldest_v6, &ldest_mac, addr->ilink);
-		if (rc != EOK)
-			return rc;
-
-		return inet_link_send_dgram6(addr->ilink, &ldest_mac, dgram,
+		return ndp_send_dgram(lsrc_v6, ldest_v6, addr->ilink, dgram,
 		    proto, ttl, df);
 	default:
 		assert(false);
@@ -38,6 +38,7 @@
 #include <fibril_synch.h>
 #include <inet/eth_addr.h>
 #include <inet/iplink.h>
+#include <inet/iplink_batch.h>
 #include <io/log.h>
 #include <loc.h>
 #include <stdbool.h>
@@ -47,8 +48,17 @@
 #include "addrobj.h"
 #include "inetsrv.h"
 #include "inet_link.h"
+#include "inet_std.h"
 #include "pdu.h"
 
+/** Transport protocols whose checksum can be left partial */
+#define IP_PROTO_TCP  6
+#define IP_PROTO_UDP  17
+
+/** Offsets of the checksum in the transport headers */
+#define TCP_CSUM_OFFSET  16
+#define UDP_CSUM_OFFSET  6
+
 static bool first_link = true;
 static bool first_link6 = true;
 
@@ -203,6 +213,11 @@ errno_t inet_link_open(service_id_t sid)
 		goto error;
 	}
 
+	/* Links which cannot tell leave the checksums to us */
+	rc = iplink_get_offload(ilink->iplink, &ilink->csum_offload);
+	if (rc != EOK)
+		ilink->csum_offload = false;
+
 	/*
 	 * Get the MAC address of the link. If the link has a MAC
 	 * address, we assume that it supports NDP.
@@ -302,7 +317,94 @@ error:
 	return rc;
 }
 
+/** Send a fragment of an IPv4 datagram.
+ *
+ * @param ilink Internet link
+ * @param batch Batch collecting the fragments of the datagram or @c NULL
+ *              to send the fragment right away
+ * @param sdu   Fragment
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t inet_link_send_frag(inet_link_t *ilink, iplink_batch_t *batch,
+    iplink_sdu_t *sdu)
+{
+	errno_t rc;
+
+	if (batch == NULL)
+		return iplink_send(ilink->iplink, sdu);
+
+	rc = iplink_batch_add_send(batch, sdu);
+	if (rc != ELIMIT)
+		return rc;
+
+	/* The batch is full, send it and start a new one */
+	rc = iplink_send_batch(ilink->iplink, batch);
+	iplink_batch_clear(batch);
+	if (rc != EOK)
+		return rc;
+
+	rc = iplink_batch_add_send(batch, sdu);
+	if (rc == ELIMIT)
+		return iplink_send(ilink->iplink, sdu);
+
+	return rc;
+}
+
+/** Get the offset of the checksum in a transport segment.
+ *
+ * @param proto Transport protocol
+ * @param size  Size of the segment
+ * @param roffs Place to store the offset
+ *
+ * @return EOK on success, EINVAL if the segment has no checksum
+ */
+static errno_t inet_link_csum_offset(uint8_t proto, size_t size,
+    uint16_t *roffs)
+{
+	uint16_t offs;
+
+	switch (proto) {
+	case IP_PROTO_TCP:
+		offs = TCP_CSUM_OFFSET;
+		break;
+	case IP_PROTO_UDP:
+		offs = UDP_CSUM_OFFSET;
+		break;
+	default:
+		return EINVAL;
+	}
+
+	if (size < (size_t) offs + sizeof(uint16_t))
+		return EINVAL;
+
+	*roffs = offs;
+	return EOK;
+}
+
+/** Complete a partial transport checksum.
+ *
+ * The checksum field contains the sum of the pseudo header, the sum
+ * of the segment is added to it. The datagram is modified in place.
+ *
+ * @param dgram Datagram
+ * @param offs  Offset of the checksum field in the datagram body
+ */
+static void inet_link_csum_complete(inet_dgram_t *dgram, uint16_t offs)
+{
+	uint8_t *field = (uint8_t *) dgram->data + offs;
+	uint16_t chksum;
+
+	chksum = inet_checksum_calc(INET_CHECKSUM_INIT, dgram->data,
+	    dgram->size);
+	field[0] = chksum >> 8;
+	field[1] = chksum & 0xff;
+}
+
 /** Send IPv4 datagram over Internet link
+ *
+ * If the transport checksum is partial and the link cannot complete it,
+ * or the datagram needs to be fragmented, the checksum is completed here.
  *
  * @param ilink Internet link
  * @param lsrc  Source IPv4 address
@@ -310,7 +412,7 @@ error:
  * @param dgram IPv4 datagram body
  * @param proto Protocol
  * @param ttl   Time-to-live
- * @param df    Do-not-Fragment flag
+ * @param df    Flags (INET_DF, INET_CSUM_PARTIAL)
  *
  * @return EOK on success
  * @return ENOMEM when not enough memory to create the datagram
@@ -336,9 +438,25 @@ errno_t inet_link_send_dgram(inet_link_t *ilink, addr32_t lsrc, addr32_t ldest,
 	 */
 
 	iplink_sdu_t sdu;
+	uint16_t csum_offs = 0;
+	errno_t rc;
+
+	if ((df & INET_CSUM_PARTIAL) != 0) {
+		rc = inet_link_csum_offset(proto, dgram->size, &csum_offs);
+		if (rc != EOK)
+			return rc;
+
+		if (!ilink->csum_offload ||
+		    sizeof(ip_header_t) + dgram->size > ilink->def_mtu) {
+			inet_link_csum_complete(dgram, csum_offs);
+			csum_offs = 0;
+		}
+	}
 
 	sdu.src = lsrc;
 	sdu.dest = ldest;
+	sdu.csum_start = sizeof(ip_header_t);
+	sdu.csum_offset = csum_offs;
 
 	inet_packet_t packet;
 
@@ -353,11 +471,11 @@ errno_t inet_link_send_dgram(inet_link_t *ilink, addr32_t lsrc, addr32_t ldest,
 	packet.ident = ++ip_ident;
 	fibril_mutex_unlock(&ip_ident_lock);
 
-	packet.df = df;
+	packet.df = (df & INET_DF) != 0;
 	packet.data = dgram->data;
 	packet.size = dgram->size;
 
-	errno_t rc;
+	iplink_batch_t *batch = NULL;
 	size_t offs = 0;
 
 	do {
@@ -367,14 +485,28 @@ errno_t inet_link_send_dgram(inet_link_t *ilink, addr32_t lsrc, addr32_t ldest,
 		rc = inet_pdu_encode(&packet, src_v4, dest_v4, offs, ilink->def_mtu,
 		    &sdu.data, &sdu.size, &roffs);
 		if (rc != EOK)
-			return rc;
+			break;
+
+		/*
+		 * If the datagram needs to be fragmented, pass the fragments
+		 * to the link in batches. Without a batch they are sent one
+		 * by one.
+		 */
+		if (offs == 0 && roffs < packet.size)
+			(void) iplink_batch_create(DATA_XFER_LIMIT, &batch);
 
 		/* Send the PDU */
-		rc = iplink_send(ilink->iplink, &sdu);
+		rc = inet_link_send_frag(ilink, batch, &sdu);
 
 		free(sdu.data);
 		offs = roffs;
-	} while (offs < packet.size);
+	} while (rc == EOK && offs < packet.size);
+
+	if (batch != NULL) {
+		if (rc == EOK)
+			rc = iplink_send_batch(ilink->iplink, batch);
+		iplink_batch_destroy(batch);
+	}
 
 	return rc;
 }
@@ -386,7 +518,7 @@ errno_t inet_link_send_dgram(inet_link_t *ilink, addr32_t lsrc, addr32_t ldest,
  * @param dgram IPv6 datagram body
  * @param proto Next header
  * @param ttl   Hop limit
- * @param df    Do-not-Fragment flag (unused)
+ * @param df    Flags (INET_DF is unused, INET_CSUM_PARTIAL)
  *
  * @return EOK on success
  * @return ENOMEM when not enough memory to create the datagram
@@ -426,12 +558,22 @@ errno_t inet_link_send_dgram6(inet_link_t *ilink, eth_addr_t *ldest,
 	packet.ident = ++ip_ident;
 	fibril_mutex_unlock(&ip_ident_lock);
 
-	packet.df = df;
+	packet.df = (df & INET_DF) != 0;
 	packet.data = dgram->data;
 	packet.size = dgram->size;
 
 	errno_t rc;
 	size_t offs = 0;
+	uint16_t csum_offs;
+
+	/* IPv6 links never complete the checksum */
+	if ((df & INET_CSUM_PARTIAL) != 0) {
+		rc = inet_link_csum_offset(proto, dgram->size, &csum_offs);
+		if (rc != EOK)
+			return rc;
+
+		inet_link_csum_complete(dgram, csum_offs);
+	}
 
 	do {
 		/* Encode one fragment */
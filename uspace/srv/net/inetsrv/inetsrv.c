@@ -47,6 +47,7 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <str.h>
 #include <task.h>
 #include "addrobj.h"
 #include "icmp.h"
@@ -57,6 +58,7 @@
 #include "inetcfg.h"
 #include "inetping.h"
 #include "inet_link.h"
+#include "rcache.h"
 #include "reass.h"
 #include "sroute.h"
 
@@ -81,6 +83,9 @@ static inet_addr_t multicast_all_nodes = {
 static FIBRIL_MUTEX_INITIALIZE(client_list_lock);
 static LIST_INITIALIZE(client_list);
 
+/** Forward datagrams not destined to this node */
+static bool inet_forwarding = false;
+
 static void inet_default_conn(ipc_call_t *, void *);
 
 static errno_t inet_init(void)
@@ -141,10 +146,16 @@ static errno_t inet_find_dir(inet_addr_t *src, inet_addr_t *dest, uint8_t tos,
 	/* XXX Handle case where source address is specified */
 	(void) src;
 
+	if (inet_rcache_find(dest, dir) == EOK)
+		return EOK;
+
 	dir->aobj = inet_addrobj_find(dest, iaf_net);
 	if (dir->aobj != NULL) {
 		dir->ldest = *dest;
-		dir->dtype = dt_direct;
+		if (inet_addrobj_find(dest, iaf_addr) != NULL)
+			dir->dtype = dt_local;
+		else
+			dir->dtype = dt_direct;
 	} else {
 		/* No direct path, try using a static route */
 		sr = inet_sroute_find(dest);
@@ -160,6 +171,7 @@ static errno_t inet_find_dir(inet_addr_t *src, inet_addr_t *dest, uint8_t tos,
 		return ENOENT;
 	}
 
+	inet_rcache_insert(dest, dir);
 	return EOK;
 }
 
@@ -504,36 +516,104 @@ errno_t inet_recv_dgram_local(inet_dgram_t *dgram, uint8_t proto)
 	return inet_ev_recv(client, dgram);
 }
 
-errno_t inet_recv_packet(inet_packet_t *packet)
+/** Deliver packet destined to this node. */
+static errno_t inet_recv_packet_local(inet_packet_t *packet)
 {
-	inet_addrobj_t *addr;
 	inet_dgram_t dgram;
 
-	addr = inet_addrobj_find(&packet->dest, iaf_addr);
-	if ((addr != NULL) ||
-	    (inet_naddr_compare_mask(&solicited_node_mask, &packet->dest)) ||
+	/* Check if packet is a complete datagram */
+	if (packet->offs == 0 && !packet->mf) {
+		/* It is complete deliver it immediately */
+		dgram.iplink = packet->link_id;
+		dgram.src = packet->src;
+		dgram.dest = packet->dest;
+		dgram.tos = packet->tos;
+		dgram.data = packet->data;
+		dgram.size = packet->size;
+
+		return inet_recv_dgram_local(&dgram, packet->proto);
+	} else {
+		/* It is a fragment, queue it for reassembly */
+		inet_reass_queue_packet(packet);
+	}
+
+	return ENOENT;
+}
+
+/** Forward packet destined to another node.
+ *
+ * Only complete unicast datagrams are forwarded. The TTL is decremented
+ * and datagrams which would have to leave over the link they came from are
+ * dropped.
+ *
+ * @param packet	Received packet
+ * @param dir		Direction to the destination of the packet
+ * @return		EOK on success or an error code
+ */
+static errno_t inet_forward_packet(inet_packet_t *packet, inet_dir_t *dir)
+{
+	inet_dgram_t dgram;
+
+	if (!inet_forwarding)
+		return ENOENT;
+
+	if (dir->dtype == dt_local || packet->offs != 0 || packet->mf)
+		return ENOENT;
+
+	/* Multicast and broadcast datagrams are not forwarded */
+	if ((packet->dest.version == ip_v4 && packet->dest.addr >= 0xe0000000) ||
+	    (packet->dest.version == ip_v6 && packet->dest.addr6[0] == 0xff))
+		return ENOENT;
+
+	if (packet->ttl <= 1) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_forward_packet: TTL expired.");
+		return ENOENT;
+	}
+
+	if (dir->aobj->ilink->svc_id == packet->link_id)
+		return ENOENT;
+
+	dgram.iplink = 0;
+	dgram.src = packet->src;
+	dgram.dest = packet->dest;
+	dgram.tos = packet->tos;
+	dgram.data = packet->data;
+	dgram.size = packet->size;
+
+	return inet_addrobj_send_dgram(dir->aobj, &dir->ldest, &dgram,
+	    packet->proto, packet->ttl - 1, packet->df ? INET_DF : 0);
+}
+
+errno_t inet_recv_packet(inet_packet_t *packet)
+{
+	inet_dir_t dir;
+	errno_t rc;
+
+	if ((inet_naddr_compare_mask(&solicited_node_mask, &packet->dest)) ||
 	    (inet_addr_compare(&multicast_all_nodes, &packet->dest)) ||
-	    (inet_addr_compare(&broadcast4_all_hosts, &packet->dest))) {
-		/* Destined for one of the local addresses */
+	    (inet_addr_compare(&broadcast4_all_hosts, &packet->dest)))
+		return inet_recv_packet_local(packet);
+
+	/* Fast path for destinations seen before */
+	if (inet_rcache_find(&packet->dest, &dir) == EOK) {
+		if (dir.dtype == dt_local)
+			return inet_recv_packet_local(packet);
+		return inet_forward_packet(packet, &dir);
+	}
 
-		/* Check if packet is a complete datagram */
-		if (packet->offs == 0 && !packet->mf) {
-			/* It is complete deliver it immediately */
-			dgram.iplink = packet->link_id;
-			dgram.src = packet->src;
-			dgram.dest = packet->dest;
-			dgram.tos = packet->tos;
-			dgram.data = packet->data;
-			dgram.size = packet->size;
-
-			return inet_recv_dgram_local(&dgram, packet->proto);
-		} else {
-			/* It is a fragment, queue it for reassembly */
-			inet_reass_queue_packet(packet);
-		}
+	if (inet_addrobj_find(&packet->dest, iaf_addr) != NULL) {
+		/* Destined for one of the local addresses */
+		return inet_recv_packet_local(packet);
 	}
 
-	return ENOENT;
+	if (!inet_forwarding)
+		return ENOENT;
+
+	rc = inet_find_dir(NULL, &packet->dest, packet->tos, &dir);
+	if (rc != EOK)
+		return rc;
+
+	return inet_forward_packet(packet, &dir);
 }
 
 int main(int argc, char *argv[])
@@ -542,6 +622,15 @@ int main(int argc, char *argv[])
 
 	printf(NAME ": HelenOS Internet Protocol service\n");
 
+	if (argc > 1) {
+		if (argc == 2 && str_cmp(argv[1], "--forward") == 0) {
+			inet_forwarding = true;
+		} else {
+			printf("Usage: " NAME " [--forward]\n");
+			return 1;
+		}
+	}
+
 	if (log_init(NAME) != EOK) {
 		printf(NAME ": Failed to initialize logging.\n");
 		return 1;
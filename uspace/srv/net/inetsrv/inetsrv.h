@@ -111,6 +111,8 @@ typedef struct {
 	size_t def_mtu;
 	eth_addr_t mac;
 	bool mac_valid;
+	/** Link completes partial transport checksums of IPv4 packets */
+	bool csum_offload;
 } inet_link_t;
 
 typedef struct {
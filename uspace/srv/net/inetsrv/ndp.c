@@ -46,9 +46,6 @@
 #include "inet_link.h"
 #include "ndp.h"
 
-/** Time to wait for NDP reply in microseconds */
-#define NDP_REQUEST_TIMEOUT  (3 * 1000 * 1000)
-
 static addr128_t solicited_node_ip =
     { 0xff, 0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0xff, 0, 0, 0 };
 
@@ -141,29 +138,40 @@ errno_t ndp_received(inet_dgram_t *dgram)
 	return EOK;
 }
 
-/** Translate IPv6 to MAC address
+/** Send datagram to IPv6 neighbor
+ *
+ * If the MAC address of the neighbor is not known yet, the datagram is
+ * queued and sent when the neighbor advertisement arrives.
  *
- * @param src  Source IPv6 address
- * @param dest Destination IPv6 address
- * @param mac  Target MAC address to be assigned
- * @param link Network interface
+ * @param src   Source IPv6 address
+ * @param dest  Destination IPv6 address
+ * @param ilink Network interface
+ * @param dgram Datagram
+ * @param proto Protocol
+ * @param ttl   Time to live
+ * @param df    Do not fragment
  *
- * @return EOK on success
- * @return ENOENT when NDP translation failed
+ * @return EOK on success or an error code
  *
  */
-errno_t ndp_translate(addr128_t src_addr, addr128_t ip_addr, eth_addr_t *mac_addr,
-    inet_link_t *ilink)
+errno_t ndp_send_dgram(addr128_t src_addr, addr128_t ip_addr,
+    inet_link_t *ilink, inet_dgram_t *dgram, uint8_t proto, uint8_t ttl,
+    int df)
 {
+	eth_addr_t mac_addr;
+	bool request;
+
 	if (!ilink->mac_valid) {
 		/* The link does not support NDP */
-		memset(mac_addr, 0, 6);
-		return EOK;
+		memset(&mac_addr, 0, sizeof(mac_addr));
+		return inet_link_send_dgram6(ilink, &mac_addr, dgram, proto,
+		    ttl, df);
 	}
 
-	errno_t rc = ntrans_lookup(ip_addr, mac_addr);
-	if (rc == EOK)
-		return EOK;
+	errno_t rc = ntrans_send(ilink, ip_addr, dgram, proto, ttl, df,
+	    &request);
+	if (rc != EOK || !request)
+		return rc;
 
 	ndp_packet_t packet;
 
@@ -174,11 +182,6 @@ errno_t ndp_translate(addr128_t src_addr, addr128_t ip_addr, eth_addr_t *mac_add
 	eth_addr_solicited_node(ip_addr, &packet.target_hw_addr);
 	ndp_solicited_node_ip(ip_addr, packet.target_proto_addr);
 
-	rc = ndp_send_packet(ilink, &packet);
-	if (rc != EOK)
-		return rc;
-
-	(void) ntrans_wait_timeout(NDP_REQUEST_TIMEOUT);
-
-	return ntrans_lookup(ip_addr, mac_addr);
+	(void) ndp_send_packet(ilink, &packet);
+	return EOK;
 }
@@ -35,18 +35,107 @@
  * @brief
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <adt/list.h>
+#include <assert.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <inet/eth_addr.h>
 #include <inet/iplink_srv.h>
+#include <mem.h>
 #include <stdlib.h>
+#include "inet_link.h"
 #include "ntrans.h"
 
-/** Address translation list (of inet_ntrans_t) */
+/** Seconds after confirmation after which a translation is refreshed */
+#define NTRANS_REACHABLE_TIME 60
+
+/** Seconds after confirmation after which a translation is discarded */
+#define NTRANS_STALE_TIME 600
+
+/** Minimum seconds between two solicitations for the same address */
+#define NTRANS_RETRY_TIME 1
+
+/** Unanswered solicitations after which waiting datagrams are dropped */
+#define NTRANS_REQUEST_MAX 3
+
+/** Maximum number of datagrams waiting for one address */
+#define NTRANS_PENDING_MAX 3
+
+/** Maximum number of entries in the translation table */
+#define NTRANS_MAX 512
+
+static size_t ntrans_key_hash(const void *);
+static size_t ntrans_hash(const ht_link_t *);
+static bool ntrans_key_equal(const void *, const ht_link_t *);
+
+static const hash_table_ops_t ntrans_map_ops = {
+	.hash = ntrans_hash,
+	.key_hash = ntrans_key_hash,
+	.key_equal = ntrans_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Address translation table (of inet_ntrans_t) */
 static FIBRIL_MUTEX_INITIALIZE(ntrans_list_lock);
 static LIST_INITIALIZE(ntrans_list);
-static FIBRIL_CONDVAR_INITIALIZE(ntrans_cv);
+static hash_table_t ntrans_map;
+static bool ntrans_map_initialized;
+static size_t ntrans_count;
+static inet_ntrans_stats_t ntrans_stats;
+
+static size_t ntrans_key_hash(const void *arg)
+{
+	const uint8_t *ip_addr = arg;
+	size_t hash = 0;
+	size_t i;
+
+	for (i = 0; i < sizeof(addr128_t); i++)
+		hash = hash_combine(hash, ip_addr[i]);
+
+	return hash;
+}
+
+static size_t ntrans_hash(const ht_link_t *item)
+{
+	inet_ntrans_t *ntrans = hash_table_get_inst(item, inet_ntrans_t,
+	    ntrans_map);
+
+	return ntrans_key_hash(ntrans->ip_addr);
+}
+
+static bool ntrans_key_equal(const void *arg, const ht_link_t *item)
+{
+	const uint8_t *ip_addr = arg;
+	inet_ntrans_t *ntrans = hash_table_get_inst(item, inet_ntrans_t,
+	    ntrans_map);
+
+	return addr128_compare(ntrans->ip_addr, ip_addr);
+}
+
+static time_t ntrans_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return ts.tv_sec;
+}
+
+static errno_t ntrans_init_locked(void)
+{
+	assert(fibril_mutex_is_locked(&ntrans_list_lock));
+
+	if (ntrans_map_initialized)
+		return EOK;
+
+	if (!hash_table_create(&ntrans_map, 0, 0, &ntrans_map_ops))
+		return ENOMEM;
+
+	ntrans_map_initialized = true;
+	return EOK;
+}
 
 /** Look for address in translation table
  *
@@ -57,15 +146,102 @@ static FIBRIL_CONDVAR_INITIALIZE(ntrans_cv);
  */
 static inet_ntrans_t *ntrans_find(addr128_t ip_addr)
 {
-	list_foreach(ntrans_list, ntrans_list, inet_ntrans_t, ntrans) {
-		if (addr128_compare(ntrans->ip_addr, ip_addr))
-			return ntrans;
+	ht_link_t *link;
+
+	assert(fibril_mutex_is_locked(&ntrans_list_lock));
+
+	link = hash_table_find(&ntrans_map, ip_addr);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, inet_ntrans_t, ntrans_map);
+}
+
+static void ntrans_pkt_destroy(inet_ntrans_pkt_t *pkt)
+{
+	free(pkt->dgram.data);
+	free(pkt);
+}
+
+/** Drop all datagrams waiting for the translation. */
+static void ntrans_pending_drop(inet_ntrans_t *ntrans)
+{
+	link_t *link;
+
+	while ((link = list_first(&ntrans->pending)) != NULL) {
+		inet_ntrans_pkt_t *pkt = list_get_instance(link,
+		    inet_ntrans_pkt_t, lpending);
+
+		list_remove(&pkt->lpending);
+		ntrans_pkt_destroy(pkt);
+		++ntrans_stats.dropped;
+	}
+
+	ntrans->npending = 0;
+}
+
+/** Remove entry from the table and destroy it. */
+static void ntrans_destroy(inet_ntrans_t *ntrans)
+{
+	assert(fibril_mutex_is_locked(&ntrans_list_lock));
+
+	hash_table_remove_item(&ntrans_map, &ntrans->ntrans_map);
+	list_remove(&ntrans->ntrans_list);
+	--ntrans_count;
+
+	ntrans_pending_drop(ntrans);
+	free(ntrans);
+}
+
+/** Create new unresolved entry.
+ *
+ * If the table is full, the least recently confirmed entry is discarded.
+ */
+static inet_ntrans_t *ntrans_create(addr128_t ip_addr)
+{
+	inet_ntrans_t *ntrans;
+	link_t *link;
+
+	assert(fibril_mutex_is_locked(&ntrans_list_lock));
+
+	if (ntrans_count >= NTRANS_MAX) {
+		link = list_first(&ntrans_list);
+		assert(link != NULL);
+		ntrans_destroy(list_get_instance(link, inet_ntrans_t,
+		    ntrans_list));
 	}
 
-	return NULL;
+	ntrans = calloc(1, sizeof(inet_ntrans_t));
+	if (ntrans == NULL)
+		return NULL;
+
+	addr128(ip_addr, ntrans->ip_addr);
+	list_initialize(&ntrans->pending);
+
+	hash_table_insert(&ntrans_map, &ntrans->ntrans_map);
+	list_append(&ntrans->ntrans_list, &ntrans_list);
+	++ntrans_count;
+
+	return ntrans;
+}
+
+/** Check if entry holds a translation which can be used.
+ *
+ * Entries which have not been confirmed for too long are no longer used.
+ */
+static bool ntrans_valid(inet_ntrans_t *ntrans, time_t now)
+{
+	if (ntrans->resolved && now - ntrans->confirmed >= NTRANS_STALE_TIME) {
+		ntrans->resolved = false;
+		ntrans->nrequests = 0;
+	}
+
+	return ntrans->resolved;
 }
 
 /** Add entry to translation table
+ *
+ * Datagrams waiting for the translation are sent.
  *
  * @param ip_addr  IPv6 address of the new entry
  * @param mac_addr MAC address of the new entry
@@ -77,25 +253,51 @@ static inet_ntrans_t *ntrans_find(addr128_t ip_addr)
 errno_t ntrans_add(addr128_t ip_addr, eth_addr_t *mac_addr)
 {
 	inet_ntrans_t *ntrans;
-	inet_ntrans_t *prev;
+	list_t pending;
+	link_t *link;
+	errno_t rc;
 
-	ntrans = calloc(1, sizeof(inet_ntrans_t));
-	if (ntrans == NULL)
-		return ENOMEM;
+	fibril_mutex_lock(&ntrans_list_lock);
 
-	addr128(ip_addr, ntrans->ip_addr);
-	ntrans->mac_addr = *mac_addr;
+	rc = ntrans_init_locked();
+	if (rc != EOK) {
+		fibril_mutex_unlock(&ntrans_list_lock);
+		return rc;
+	}
 
-	fibril_mutex_lock(&ntrans_list_lock);
-	prev = ntrans_find(ip_addr);
-	if (prev != NULL) {
-		list_remove(&prev->ntrans_list);
-		free(prev);
+	ntrans = ntrans_find(ip_addr);
+	if (ntrans == NULL) {
+		ntrans = ntrans_create(ip_addr);
+		if (ntrans == NULL) {
+			fibril_mutex_unlock(&ntrans_list_lock);
+			return ENOMEM;
+		}
 	}
 
+	ntrans->mac_addr = *mac_addr;
+	ntrans->resolved = true;
+	ntrans->confirmed = ntrans_now();
+	ntrans->nrequests = 0;
+
+	/* Keep the list ordered by the time of confirmation */
+	list_remove(&ntrans->ntrans_list);
 	list_append(&ntrans->ntrans_list, &ntrans_list);
+
+	list_initialize(&pending);
+	list_concat(&pending, &ntrans->pending);
+	ntrans->npending = 0;
+
 	fibril_mutex_unlock(&ntrans_list_lock);
-	fibril_condvar_broadcast(&ntrans_cv);
+
+	while ((link = list_first(&pending)) != NULL) {
+		inet_ntrans_pkt_t *pkt = list_get_instance(link,
+		    inet_ntrans_pkt_t, lpending);
+
+		list_remove(&pkt->lpending);
+		(void) inet_link_send_dgram6(pkt->ilink, mac_addr, &pkt->dgram,
+		    pkt->proto, pkt->ttl, pkt->df);
+		ntrans_pkt_destroy(pkt);
+	}
 
 	return EOK;
 }
@@ -113,15 +315,20 @@ errno_t ntrans_remove(addr128_t ip_addr)
 	inet_ntrans_t *ntrans;
 
 	fibril_mutex_lock(&ntrans_list_lock);
+
+	if (!ntrans_map_initialized) {
+		fibril_mutex_unlock(&ntrans_list_lock);
+		return ENOENT;
+	}
+
 	ntrans = ntrans_find(ip_addr);
 	if (ntrans == NULL) {
 		fibril_mutex_unlock(&ntrans_list_lock);
 		return ENOENT;
 	}
 
-	list_remove(&ntrans->ntrans_list);
+	ntrans_destroy(ntrans);
 	fibril_mutex_unlock(&ntrans_list_lock);
-	free(ntrans);
 
 	return EOK;
 }
@@ -137,34 +344,149 @@ errno_t ntrans_remove(addr128_t ip_addr)
  */
 errno_t ntrans_lookup(addr128_t ip_addr, eth_addr_t *mac_addr)
 {
+	inet_ntrans_t *ntrans;
+	errno_t rc = ENOENT;
+
 	fibril_mutex_lock(&ntrans_list_lock);
-	inet_ntrans_t *ntrans = ntrans_find(ip_addr);
-	if (ntrans == NULL) {
-		fibril_mutex_unlock(&ntrans_list_lock);
-		return ENOENT;
+
+	if (ntrans_map_initialized) {
+		ntrans = ntrans_find(ip_addr);
+		if (ntrans != NULL && ntrans_valid(ntrans, ntrans_now())) {
+			*mac_addr = ntrans->mac_addr;
+			rc = EOK;
+		}
 	}
 
 	fibril_mutex_unlock(&ntrans_list_lock);
-	*mac_addr = ntrans->mac_addr;
-	return EOK;
+	return rc;
 }
 
-/** Wait on translation table CV for some time
+/** Send datagram to IPv6 neighbor
  *
- * @param timeout Timeout in microseconds
+ * If the address is resolved, the datagram is sent right away. Otherwise
+ * a copy of it is queued until the translation is added, so that the
+ * sender does not need to wait.
  *
- * @return EOK if woken up by another fibril
- * @return ETIMEOUT if timed out
+ * @param ilink    Link to send the datagram through
+ * @param ip_addr  IPv6 address of the neighbor
+ * @param dgram    Datagram
+ * @param proto    Protocol
+ * @param ttl      Time to live
+ * @param df       Do not fragment
+ * @param rrequest Place to store @c true if the caller should send
+ *                 a solicitation for @a ip_addr
  *
+ * @return EOK on success or an error code
  */
-errno_t ntrans_wait_timeout(usec_t timeout)
+errno_t ntrans_send(inet_link_t *ilink, addr128_t ip_addr,
+    inet_dgram_t *dgram, uint8_t proto, uint8_t ttl, int df, bool *rrequest)
 {
+	inet_ntrans_t *ntrans;
+	inet_ntrans_pkt_t *pkt;
+	eth_addr_t mac_addr;
+	time_t now;
+	errno_t rc;
+
+	*rrequest = false;
+	now = ntrans_now();
+
 	fibril_mutex_lock(&ntrans_list_lock);
-	errno_t rc = fibril_condvar_wait_timeout(&ntrans_cv, &ntrans_list_lock,
-	    timeout);
+
+	rc = ntrans_init_locked();
+	if (rc != EOK) {
+		fibril_mutex_unlock(&ntrans_list_lock);
+		return rc;
+	}
+
+	ntrans = ntrans_find(ip_addr);
+	if (ntrans != NULL && ntrans_valid(ntrans, now)) {
+		++ntrans_stats.hits;
+		mac_addr = ntrans->mac_addr;
+
+		/* Refresh translation which was not confirmed lately */
+		if (now - ntrans->confirmed >= NTRANS_REACHABLE_TIME &&
+		    now - ntrans->requested >= NTRANS_RETRY_TIME) {
+			ntrans->requested = now;
+			*rrequest = true;
+		}
+
+		fibril_mutex_unlock(&ntrans_list_lock);
+		return inet_link_send_dgram6(ilink, &mac_addr, dgram, proto,
+		    ttl, df);
+	}
+
+	++ntrans_stats.misses;
+
+	if (ntrans == NULL) {
+		ntrans = ntrans_create(ip_addr);
+		if (ntrans == NULL) {
+			fibril_mutex_unlock(&ntrans_list_lock);
+			return ENOMEM;
+		}
+
+		*rrequest = true;
+	} else if (now - ntrans->requested >= NTRANS_RETRY_TIME) {
+		/* Give up on datagrams waiting for too long */
+		if (ntrans->nrequests >= NTRANS_REQUEST_MAX) {
+			ntrans_pending_drop(ntrans);
+			ntrans->nrequests = 0;
+		}
+
+		*rrequest = true;
+	}
+
+	if (*rrequest) {
+		ntrans->requested = now;
+		++ntrans->nrequests;
+	}
+
+	pkt = calloc(1, sizeof(inet_ntrans_pkt_t));
+	if (pkt == NULL) {
+		fibril_mutex_unlock(&ntrans_list_lock);
+		return ENOMEM;
+	}
+
+	pkt->dgram = *dgram;
+	pkt->dgram.data = malloc(dgram->size);
+	if (pkt->dgram.data == NULL) {
+		free(pkt);
+		fibril_mutex_unlock(&ntrans_list_lock);
+		return ENOMEM;
+	}
+
+	memcpy(pkt->dgram.data, dgram->data, dgram->size);
+	pkt->ilink = ilink;
+	pkt->proto = proto;
+	pkt->ttl = ttl;
+	pkt->df = df;
+
+	/* Make room by dropping the oldest datagram */
+	if (ntrans->npending >= NTRANS_PENDING_MAX) {
+		inet_ntrans_pkt_t *old = list_get_instance(
+		    list_first(&ntrans->pending), inet_ntrans_pkt_t, lpending);
+
+		list_remove(&old->lpending);
+		ntrans_pkt_destroy(old);
+		--ntrans->npending;
+		++ntrans_stats.dropped;
+	}
+
+	list_append(&pkt->lpending, &ntrans->pending);
+	++ntrans->npending;
+
 	fibril_mutex_unlock(&ntrans_list_lock);
+	return EOK;
+}
 
-	return rc;
+/** Get address translation statistics
+ *
+ * @param stats Place to store statistics
+ */
+void ntrans_get_stats(inet_ntrans_stats_t *stats)
+{
+	fibril_mutex_lock(&ntrans_list_lock);
+	*stats = ntrans_stats;
+	fibril_mutex_unlock(&ntrans_list_lock);
 }
 
 /** @}
@@ -38,21 +38,65 @@
 #ifndef NTRANS_H_
 #define NTRANS_H_
 
+#include <adt/hash_table.h>
+#include <adt/list.h>
 #include <inet/addr.h>
 #include <inet/eth_addr.h>
 #include <inet/iplink_srv.h>
+#include <time.h>
+#include "inetsrv.h"
+
+/** Datagram waiting for address translation */
+typedef struct {
+	/** Link to inet_ntrans_t.pending */
+	link_t lpending;
+	/** Link to send the datagram through */
+	inet_link_t *ilink;
+	/** Datagram, the data is owned by the entry */
+	inet_dgram_t dgram;
+	uint8_t proto;
+	uint8_t ttl;
+	int df;
+} inet_ntrans_pkt_t;
 
 /** Address translation table element */
 typedef struct {
+	/** Link to ntrans_map */
+	ht_link_t ntrans_map;
+	/** Link to ntrans_list, least recently confirmed first */
 	link_t ntrans_list;
 	addr128_t ip_addr;
 	eth_addr_t mac_addr;
+	/** @c true if @c mac_addr is valid */
+	bool resolved;
+	/** Uptime in seconds when the translation was last confirmed */
+	time_t confirmed;
+	/** Uptime in seconds when the last solicitation was sent */
+	time_t requested;
+	/** Number of solicitations sent since the last confirmation */
+	unsigned nrequests;
+	/** Datagrams waiting for resolution (of inet_ntrans_pkt_t) */
+	list_t pending;
+	/** Number of datagrams in @c pending */
+	size_t npending;
 } inet_ntrans_t;
 
+/** Address translation statistics */
+typedef struct {
+	/** Number of datagrams sent to a resolved address */
+	uint64_t hits;
+	/** Number of datagrams sent to an unresolved address */
+	uint64_t misses;
+	/** Number of datagrams dropped while waiting for resolution */
+	uint64_t dropped;
+} inet_ntrans_stats_t;
+
 extern errno_t ntrans_add(addr128_t, eth_addr_t *);
 extern errno_t ntrans_remove(addr128_t);
 extern errno_t ntrans_lookup(addr128_t, eth_addr_t *);
-extern errno_t ntrans_wait_timeout(usec_t);
+extern errno_t ntrans_send(inet_link_t *, addr128_t, inet_dgram_t *, uint8_t,
+    uint8_t, int, bool *);
+extern void ntrans_get_stats(inet_ntrans_stats_t *);
 
 #endif
 
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup inet
+ * @{
+ */
+/**
+ * @file
+ * @brief Route cache
+ *
+ * Directions to recently used destinations, so that sending and forwarding
+ * a datagram does not need to look through the address objects and static
+ * routes each time. The cache is direct-mapped, a new destination replaces
+ * the one with the same hash. Any change of the address objects or static
+ * routes flushes the whole cache.
+ */
+
+#include <fibril_synch.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "rcache.h"
+
+/** Number of route cache entries, must be a power of two */
+#define INET_RCACHE_SIZE  256
+
+typedef struct {
+	/** Entry is in use */
+	bool valid;
+	/** Destination address */
+	inet_addr_t dest;
+	/** Direction to the destination */
+	inet_dir_t dir;
+} inet_rcache_entry_t;
+
+static FIBRIL_MUTEX_INITIALIZE(rcache_lock);
+static inet_rcache_entry_t rcache[INET_RCACHE_SIZE];
+
+/** Compute route cache index of destination address. */
+static size_t inet_rcache_index(inet_addr_t *dest)
+{
+	uint32_t h;
+	size_t i;
+
+	if (dest->version == ip_v4) {
+		h = dest->addr;
+	} else {
+		h = 0;
+		for (i = 0; i < 16; i += 4) {
+			h ^= ((uint32_t) dest->addr6[i] << 24) |
+			    ((uint32_t) dest->addr6[i + 1] << 16) |
+			    ((uint32_t) dest->addr6[i + 2] << 8) |
+			    dest->addr6[i + 3];
+		}
+	}
+
+	/* Multiplicative hashing, take the top bits */
+	h *= UINT32_C(2654435761);
+	return (h >> 24) & (INET_RCACHE_SIZE - 1);
+}
+
+/** Find direction to destination in the route cache.
+ *
+ * @param dest	Destination address
+ * @param dir	Place to store the direction
+ * @return	EOK on success, ENOENT if the destination is not cached
+ */
+errno_t inet_rcache_find(inet_addr_t *dest, inet_dir_t *dir)
+{
+	inet_rcache_entry_t *entry = &rcache[inet_rcache_index(dest)];
+	errno_t rc = ENOENT;
+
+	fibril_mutex_lock(&rcache_lock);
+	if (entry->valid && inet_addr_compare(&entry->dest, dest)) {
+		*dir = entry->dir;
+		rc = EOK;
+	}
+	fibril_mutex_unlock(&rcache_lock);
+
+	return rc;
+}
+
+/** Insert direction to destination into the route cache.
+ *
+ * @param dest	Destination address
+ * @param dir	Direction to the destination
+ */
+void inet_rcache_insert(inet_addr_t *dest, inet_dir_t *dir)
+{
+	inet_rcache_entry_t *entry = &rcache[inet_rcache_index(dest)];
+
+	fibril_mutex_lock(&rcache_lock);
+	entry->valid = true;
+	entry->dest = *dest;
+	entry->dir = *dir;
+	fibril_mutex_unlock(&rcache_lock);
+}
+
+/** Remove all entries from the route cache.
+ *
+ * Must be called whenever an address object or a static route is added or
+ * removed, since the cached directions may no longer be valid.
+ */
+void inet_rcache_flush(void)
+{
+	size_t i;
+
+	fibril_mutex_lock(&rcache_lock);
+	for (i = 0; i < INET_RCACHE_SIZE; i++)
+		rcache[i].valid = false;
+	fibril_mutex_unlock(&rcache_lock);
+}
+
+/** @}
+ */
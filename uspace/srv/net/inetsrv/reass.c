@@ -34,46 +34,112 @@
  * @brief Datagram reassembly.
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <adt/odict.h>
+#include <assert.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <io/log.h>
 #include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "inetsrv.h"
 #include "inet_std.h"
 #include "reass.h"
 
-/** Datagram being reassembled.
+/** Seconds after which incomplete datagram is discarded */
+#define REASS_TIMEOUT 30
+
+/** Maximum number of datagrams being reassembled */
+#define REASS_DGRAM_MAX 64
+
+/** Maximum amount of fragment data held for reassembly in bytes */
+#define REASS_MEM_MAX (1024 * 1024)
+
+/** Datagram identification.
  *
- * Uniquely identified by (source address, destination address, protocol,
- * identification) per RFC 791 sec. 2.3 / Fragmentation.
+ * Uniquely identifies datagram per RFC 791 sec. 2.3 / Fragmentation.
  */
 typedef struct {
-	link_t map_link;
-	/** List of fragments, @c reass_frag_t */
-	list_t frags;
+	inet_addr_t src;
+	inet_addr_t dest;
+	uint8_t proto;
+	uint32_t ident;
+} reass_key_t;
+
+/** Datagram being reassembled. */
+typedef struct {
+	/** Link to @c reass_dgram_map */
+	ht_link_t map_link;
+	/** Link to @c reass_dgram_age */
+	link_t age_link;
+	/** Datagram identification */
+	reass_key_t key;
+	/** Fragments by offset, @c reass_frag_t. They never overlap. */
+	odict_t frags;
+	/** Number of bytes received */
+	size_t rcvd;
+	/** Datagram size, valid if @c have_last is @c true */
+	size_t size;
+	/** @c true if the last fragment was received */
+	bool have_last;
+	/** Link on which the last fragment was received */
+	service_id_t link_id;
+	/** Type of service of the last fragment */
+	uint8_t tos;
+	/** Uptime in seconds when the datagram is discarded */
+	time_t expires;
 } reass_dgram_t;
 
 /** One datagram fragment */
 typedef struct {
-	link_t dgram_link;
-	inet_packet_t packet;
+	odlink_t dgram_link;
+	/** Offset of fragment into datagram, in bytes */
+	size_t offs;
+	/** Fragment data size in bytes */
+	size_t size;
+	/** Fragment data */
+	uint8_t *data;
 } reass_frag_t;
 
-/** Datagram map, list of reass_dgram_t */
-static LIST_INITIALIZE(reass_dgram_map);
+static size_t reass_key_hash(const void *);
+static size_t reass_dgram_hash(const ht_link_t *);
+static bool reass_key_equal(const void *, const ht_link_t *);
+
+static const hash_table_ops_t reass_dgram_map_ops = {
+	.hash = reass_dgram_hash,
+	.key_hash = reass_key_hash,
+	.key_equal = reass_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Datagram map, hash table of reass_dgram_t */
+static hash_table_t reass_dgram_map;
+/** @c true if reass_dgram_map has been created */
+static bool reass_dgram_map_initialized;
+/** Datagrams in the order they were started, oldest first */
+static LIST_INITIALIZE(reass_dgram_age);
+/** Number of datagrams being reassembled */
+static size_t reass_dgram_count;
+/** Amount of fragment data held in bytes */
+static size_t reass_mem;
 /** Protects access to @c reass_dgram_map */
 static FIBRIL_MUTEX_INITIALIZE(reass_dgram_map_lock);
 
-static reass_dgram_t *reass_dgram_new(void);
-static reass_dgram_t *reass_dgram_get(inet_packet_t *);
+static reass_dgram_t *reass_dgram_new(inet_packet_t *, time_t);
+static reass_dgram_t *reass_dgram_get(inet_packet_t *, time_t);
 static errno_t reass_dgram_insert_frag(reass_dgram_t *, inet_packet_t *);
 static bool reass_dgram_complete(reass_dgram_t *);
 static void reass_dgram_remove(reass_dgram_t *);
 static errno_t reass_dgram_deliver(reass_dgram_t *);
 static void reass_dgram_destroy(reass_dgram_t *);
+static void reass_dgram_expire(time_t);
+static void reass_dgram_evict(reass_dgram_t *);
 
 /** Queue packet for datagram reassembly.
  *
@@ -83,14 +149,30 @@ static void reass_dgram_destroy(reass_dgram_t *);
 errno_t inet_reass_queue_packet(inet_packet_t *packet)
 {
 	reass_dgram_t *rdg;
+	struct timespec now;
 	errno_t rc;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_reass_queue_packet()");
 
+	getuptime(&now);
+
 	fibril_mutex_lock(&reass_dgram_map_lock);
 
+	if (!reass_dgram_map_initialized) {
+		if (!hash_table_create(&reass_dgram_map, 0, 0,
+		    &reass_dgram_map_ops)) {
+			fibril_mutex_unlock(&reass_dgram_map_lock);
+			return ENOMEM;
+		}
+
+		reass_dgram_map_initialized = true;
+	}
+
+	/* Discard datagrams which timed out */
+	reass_dgram_expire(now.tv_sec);
+
 	/* Get existing or new datagram */
-	rdg = reass_dgram_get(packet);
+	rdg = reass_dgram_get(packet, now.tv_sec);
 	if (rdg == NULL) {
 		/* Only happens when we are out of memory */
 		fibril_mutex_unlock(&reass_dgram_map_lock);
@@ -100,8 +182,15 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
 
 	/* Insert fragment into the datagram */
 	rc = reass_dgram_insert_frag(rdg, packet);
-	if (rc != EOK)
+	if (rc != EOK) {
+		if (odict_empty(&rdg->frags)) {
+			reass_dgram_remove(rdg);
+			reass_dgram_destroy(rdg);
+		}
+
+		fibril_mutex_unlock(&reass_dgram_map_lock);
 		return ENOMEM;
+	}
 
 	/* Check if datagram is complete */
 	if (reass_dgram_complete(rdg)) {
@@ -111,48 +200,118 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
 
 		/* Deliver complete datagram */
 		rc = reass_dgram_deliver(rdg);
+
+		fibril_mutex_lock(&reass_dgram_map_lock);
 		reass_dgram_destroy(rdg);
+		fibril_mutex_unlock(&reass_dgram_map_lock);
 		return rc;
 	}
 
+	/* Keep memory use within limits */
+	reass_dgram_evict(rdg);
+
 	fibril_mutex_unlock(&reass_dgram_map_lock);
 	return EOK;
 }
 
+static size_t reass_addr_hash(const inet_addr_t *addr)
+{
+	size_t hash;
+	size_t i;
+
+	switch (addr->version) {
+	case ip_v4:
+		return addr->addr;
+	case ip_v6:
+		hash = 0;
+		for (i = 0; i < 16; i++)
+			hash = hash_combine(hash, addr->addr6[i]);
+		return hash;
+	default:
+		return 0;
+	}
+}
+
+static size_t reass_key_hash(const void *arg)
+{
+	const reass_key_t *key = arg;
+	size_t hash;
+
+	hash = hash_combine(reass_addr_hash(&key->src),
+	    reass_addr_hash(&key->dest));
+	hash = hash_combine(hash, key->proto);
+	return hash_mix(hash_combine(hash, key->ident));
+}
+
+static size_t reass_dgram_hash(const ht_link_t *item)
+{
+	reass_dgram_t *rdg = hash_table_get_inst(item, reass_dgram_t,
+	    map_link);
+
+	return reass_key_hash(&rdg->key);
+}
+
+static bool reass_key_equal(const void *arg, const ht_link_t *item)
+{
+	const reass_key_t *key = arg;
+	reass_dgram_t *rdg = hash_table_get_inst(item, reass_dgram_t,
+	    map_link);
+
+	return inet_addr_compare(&rdg->key.src, &key->src) &&
+	    inet_addr_compare(&rdg->key.dest, &key->dest) &&
+	    rdg->key.proto == key->proto && rdg->key.ident == key->ident;
+}
+
+static void *reass_frag_getkey(odlink_t *odlink)
+{
+	return &odict_get_instance(odlink, reass_frag_t, dgram_link)->offs;
+}
+
+static int reass_frag_cmp(void *a, void *b)
+{
+	size_t oa = *(size_t *) a;
+	size_t ob = *(size_t *) b;
+
+	if (oa < ob)
+		return -1;
+	if (oa > ob)
+		return 1;
+	return 0;
+}
+
 /** Get datagram reassembly structure for packet.
  *
  * @param packet	Packet
+ * @param now		Current uptime in seconds
  * @return		Datagram reassembly structure matching @a packet
  */
-static reass_dgram_t *reass_dgram_get(inet_packet_t *packet)
+static reass_dgram_t *reass_dgram_get(inet_packet_t *packet, time_t now)
 {
-	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
+	reass_key_t key;
+	ht_link_t *link;
 
-	list_foreach(reass_dgram_map, map_link, reass_dgram_t, rdg) {
-		link_t *f1_link = list_first(&rdg->frags);
-		assert(f1_link != NULL);
+	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
 
-		reass_frag_t *f1 = list_get_instance(f1_link, reass_frag_t,
-		    dgram_link);
+	key.src = packet->src;
+	key.dest = packet->dest;
+	key.proto = packet->proto;
+	key.ident = packet->ident;
 
-		if ((inet_addr_compare(&f1->packet.src, &packet->src)) &&
-		    (inet_addr_compare(&f1->packet.dest, &packet->dest)) &&
-		    (f1->packet.proto == packet->proto) &&
-		    (f1->packet.ident == packet->ident)) {
-			/* Match */
-			return rdg;
-		}
-	}
+	link = hash_table_find(&reass_dgram_map, &key);
+	if (link != NULL)
+		return hash_table_get_inst(link, reass_dgram_t, map_link);
 
 	/* No existing reassembly structure. Create a new one. */
-	return reass_dgram_new();
+	return reass_dgram_new(packet, now);
 }
 
 /** Create new datagram reassembly structure.
  *
+ * @param packet	First received packet of the datagram
+ * @param now		Current uptime in seconds
  * @return New datagram reassembly structure.
  */
-static reass_dgram_t *reass_dgram_new(void)
+static reass_dgram_t *reass_dgram_new(inet_packet_t *packet, time_t now)
 {
 	reass_dgram_t *rdg;
 
@@ -160,72 +319,120 @@ static reass_dgram_t *reass_dgram_new(void)
 	if (rdg == NULL)
 		return NULL;
 
-	list_append(&rdg->map_link, &reass_dgram_map);
-	list_initialize(&rdg->frags);
+	rdg->key.src = packet->src;
+	rdg->key.dest = packet->dest;
+	rdg->key.proto = packet->proto;
+	rdg->key.ident = packet->ident;
+	rdg->expires = now + REASS_TIMEOUT;
+	odict_initialize(&rdg->frags, reass_frag_getkey, reass_frag_cmp);
+
+	hash_table_insert(&reass_dgram_map, &rdg->map_link);
+	list_append(&rdg->age_link, &reass_dgram_age);
+	++reass_dgram_count;
 
 	return rdg;
 }
 
-static reass_frag_t *reass_frag_new(void)
+/** Remove fragment from datagram and destroy it. */
+static void reass_frag_destroy(reass_dgram_t *rdg, reass_frag_t *frag)
 {
-	reass_frag_t *frag;
-
-	frag = calloc(1, sizeof(reass_frag_t));
-	if (frag == NULL)
-		return NULL;
-
-	link_initialize(&frag->dgram_link);
+	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
 
-	return frag;
+	odict_remove(&frag->dgram_link);
+	rdg->rcvd -= frag->size;
+	reass_mem -= frag->size;
+	free(frag->data);
+	free(frag);
 }
 
+/** Insert fragment into datagram.
+ *
+ * Only the data not yet received is stored, so fragments never overlap
+ * and the number of received bytes tells when the datagram is complete.
+ * Finding the neighbours of the new fragment takes logarithmic time.
+ *
+ * @param rdg		Datagram reassembly structure
+ * @param packet	Fragment
+ * @return		EOK on success or ENOMEM
+ */
 static errno_t reass_dgram_insert_frag(reass_dgram_t *rdg, inet_packet_t *packet)
 {
 	reass_frag_t *frag;
-	void *data_copy;
-	link_t *link;
+	reass_frag_t *qf;
+	odlink_t *link;
+	size_t b, e;
 
 	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
 
-	frag = reass_frag_new();
+	b = packet->offs;
+	e = packet->offs + packet->size;
 
-	/* Clone the packet */
+	if (!packet->mf && !rdg->have_last) {
+		rdg->have_last = true;
+		rdg->size = e;
+		rdg->link_id = packet->link_id;
+		rdg->tos = packet->tos;
 
-	data_copy = malloc(packet->size);
-	if (data_copy == NULL) {
-		free(frag);
-		return ENOMEM;
-	}
+		/* Discard anything beyond the end of datagram */
+		while ((link = odict_last(&rdg->frags)) != NULL) {
+			qf = odict_get_instance(link, reass_frag_t, dgram_link);
+			if (qf->offs + qf->size <= rdg->size)
+				break;
 
-	memcpy(data_copy, packet->data, packet->size);
+			reass_frag_destroy(rdg, qf);
+		}
+	}
 
-	frag->packet = *packet;
-	frag->packet.data = data_copy;
+	if (rdg->have_last)
+		e = min(e, rdg->size);
 
-	/*
-	 * XXX Make resource-consuming attacks harder, eliminate any duplicate
-	 * data immediately. Possibly eliminate redundant packet headers.
-	 */
+	/* Trim the part covered by the preceding fragment */
+	link = odict_find_leq(&rdg->frags, &b, NULL);
+	if (link != NULL) {
+		qf = odict_get_instance(link, reass_frag_t, dgram_link);
+		b = max(b, qf->offs + qf->size);
+	}
 
-	/*
-	 * Insert into the list, which is sorted by offs member ascending.
-	 */
+	/* Drop following fragments we cover, trim the part covered by next */
+	link = odict_find_gt(&rdg->frags, &packet->offs, NULL);
+	while (link != NULL && b < e) {
+		qf = odict_get_instance(link, reass_frag_t, dgram_link);
+		if (qf->offs >= e)
+			break;
 
-	link = list_first(&rdg->frags);
-	while (link != NULL) {
-		reass_frag_t *qf = list_get_instance(link, reass_frag_t,
-		    dgram_link);
+		link = odict_next(link, &rdg->frags);
 
-		if (qf->packet.offs >= packet->offs)
+		if (qf->offs + qf->size <= e && qf->offs >= b) {
+			reass_frag_destroy(rdg, qf);
+		} else {
+			e = max(b, qf->offs);
 			break;
+		}
+	}
 
-		link = list_next(link, &rdg->frags);
+	/* Duplicate data, nothing to add */
+	if (b >= e)
+		return EOK;
+
+	frag = calloc(1, sizeof(reass_frag_t));
+	if (frag == NULL)
+		return ENOMEM;
+
+	frag->data = malloc(e - b);
+	if (frag->data == NULL) {
+		free(frag);
+		return ENOMEM;
 	}
 
-	if (link != NULL)
-		list_insert_after(&frag->dgram_link, link);
-	else
-		list_append(&frag->dgram_link, &rdg->frags);
+	memcpy(frag->data, (uint8_t *) packet->data + (b - packet->offs),
+	    e - b);
+	frag->offs = b;
+	frag->size = e - b;
+
+	odlink_initialize(&frag->dgram_link);
+	odict_insert(&frag->dgram_link, &rdg->frags, NULL);
+	rdg->rcvd += frag->size;
+	reass_mem += frag->size;
 
 	return EOK;
 }
@@ -237,52 +444,74 @@ static errno_t reass_dgram_insert_frag(reass_dgram_t *rdg, inet_packet_t *packet
  */
 static bool reass_dgram_complete(reass_dgram_t *rdg)
 {
-	reass_frag_t *frag, *prev;
-	link_t *link;
-
 	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
-	assert(!list_empty(&rdg->frags));
-
-	link = list_first(&rdg->frags);
-	assert(link != NULL);
 
-	frag = list_get_instance(link, reass_frag_t,
-	    dgram_link);
+	/* Fragments do not overlap and lie within the datagram */
+	return rdg->have_last && rdg->rcvd == rdg->size;
+}
 
-	/* First fragment must be at offset zero */
-	if (frag->packet.offs != 0)
-		return false;
+/** Remove datagram from reassembly map.
+ *
+ * @param rdg		Datagram reassembly structure
+ */
+static void reass_dgram_remove(reass_dgram_t *rdg)
+{
+	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
+	hash_table_remove_item(&reass_dgram_map, &rdg->map_link);
+	list_remove(&rdg->age_link);
+	--reass_dgram_count;
+}
 
-	prev = frag;
+/** Discard datagrams which have not been completed in time.
+ *
+ * @param now		Current uptime in seconds
+ */
+static void reass_dgram_expire(time_t now)
+{
+	link_t *link;
 
-	while (true) {
-		link = list_next(link, &rdg->frags);
-		if (link == NULL)
-			break;
+	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
 
-		/* Each next fragment must follow immediately or overlap */
-		frag = list_get_instance(link, reass_frag_t, dgram_link);
-		if (frag->packet.offs > prev->packet.offs + prev->packet.size)
-			return false;
+	while ((link = list_first(&reass_dgram_age)) != NULL) {
+		reass_dgram_t *rdg = list_get_instance(link, reass_dgram_t,
+		    age_link);
 
-		/* No more fragments - datagram is complete */
-		if (!frag->packet.mf)
-			return true;
+		if (rdg->expires > now)
+			break;
 
-		prev = frag;
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Reassembly timed out, "
+		    "datagram dropped.");
+		reass_dgram_remove(rdg);
+		reass_dgram_destroy(rdg);
 	}
-
-	return false;
 }
 
-/** Remove datagram from reassembly map.
+/** Discard oldest datagrams while over the limits.
  *
- * @param rdg		Datagram reassembly structure
+ * @param cur		Datagram just updated, discarded last
  */
-static void reass_dgram_remove(reass_dgram_t *rdg)
+static void reass_dgram_evict(reass_dgram_t *cur)
 {
+	link_t *link;
+
 	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
-	list_remove(&rdg->map_link);
+
+	while (reass_mem > REASS_MEM_MAX ||
+	    reass_dgram_count > REASS_DGRAM_MAX) {
+		link = list_first(&reass_dgram_age);
+		assert(link != NULL);
+
+		reass_dgram_t *rdg = list_get_instance(link, reass_dgram_t,
+		    age_link);
+
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Reassembly over limit, "
+		    "datagram dropped.");
+		reass_dgram_remove(rdg);
+		reass_dgram_destroy(rdg);
+
+		if (rdg == cur)
+			break;
+	}
 }
 
 /** Deliver complete datagram.
@@ -294,26 +523,11 @@ static errno_t reass_dgram_deliver(reass_dgram_t *rdg)
 	size_t dgram_size;
 	size_t fragoff_limit;
 	inet_dgram_t dgram;
-	uint8_t proto;
-	reass_frag_t *frag;
+	odlink_t *link;
 	errno_t rc;
 
-	/*
-	 * Potentially there could be something beyond the first packet
-	 * that has !MF. Make sure we ignore that.
-	 */
-	frag = NULL;
-	list_foreach(rdg->frags, dgram_link, reass_frag_t, cfrag) {
-		if (!cfrag->packet.mf) {
-			frag = cfrag;
-			break;
-		}
-	}
-
-	assert(frag != NULL);
-	assert(!frag->packet.mf);
-
-	dgram_size = frag->packet.offs + frag->packet.size;
+	assert(rdg->have_last);
+	dgram_size = rdg->size;
 
 	/* Upper bound for fragment offset field */
 	fragoff_limit = 1 << (FF_FRAGOFF_h - FF_FRAGOFF_l + 1);
@@ -322,39 +536,29 @@ static errno_t reass_dgram_deliver(reass_dgram_t *rdg)
 	if (dgram_size > FRAG_OFFS_UNIT * fragoff_limit)
 		return ELIMIT;
 
-	dgram.data = calloc(dgram_size, 1);
+	dgram.data = malloc(dgram_size);
 	if (dgram.data == NULL)
 		return ENOMEM;
 
 	/* XXX What if different fragments came from different link? */
-	dgram.iplink = frag->packet.link_id;
+	dgram.iplink = rdg->link_id;
 	dgram.size = dgram_size;
-	dgram.src = frag->packet.src;
-	dgram.dest = frag->packet.dest;
-	dgram.tos = frag->packet.tos;
-	proto = frag->packet.proto;
+	dgram.src = rdg->key.src;
+	dgram.dest = rdg->key.dest;
+	dgram.tos = rdg->tos;
 
 	/* Pull together data from individual fragments */
+	link = odict_first(&rdg->frags);
+	while (link != NULL) {
+		reass_frag_t *frag = odict_get_instance(link, reass_frag_t,
+		    dgram_link);
 
-	size_t doffs = 0;
-
-	list_foreach(rdg->frags, dgram_link, reass_frag_t, cfrag) {
-		size_t cb, ce;
-
-		cb = max(doffs, cfrag->packet.offs);
-		ce = min(dgram_size, cfrag->packet.offs + cfrag->packet.size);
-
-		if (ce > cb) {
-			memcpy(dgram.data + cb,
-			    cfrag->packet.data + cb - cfrag->packet.offs,
-			    ce - cb);
-		}
-
-		if (!cfrag->packet.mf)
-			break;
+		memcpy((uint8_t *) dgram.data + frag->offs, frag->data,
+		    frag->size);
+		link = odict_next(link, &rdg->frags);
 	}
 
-	rc = inet_recv_dgram_local(&dgram, proto);
+	rc = inet_recv_dgram_local(&dgram, rdg->key.proto);
 	free(dgram.data);
 	return rc;
 }
@@ -365,14 +569,13 @@ static errno_t reass_dgram_deliver(reass_dgram_t *rdg)
  */
 static void reass_dgram_destroy(reass_dgram_t *rdg)
 {
-	while (!list_empty(&rdg->frags)) {
-		link_t *flink = list_first(&rdg->frags);
-		reass_frag_t *frag = list_get_instance(flink, reass_frag_t,
+	odlink_t *link;
+
+	while ((link = odict_first(&rdg->frags)) != NULL) {
+		reass_frag_t *frag = odict_get_instance(link, reass_frag_t,
 		    dgram_link);
 
-		list_remove(&frag->dgram_link);
-		free(frag->packet.data);
-		free(frag);
+		reass_frag_destroy(rdg, frag);
 	}
 
 	free(rdg);
@@ -34,6 +34,7 @@
  * @brief
  */
 
+#include <assert.h>
 #include <bitops.h>
 #include <errno.h>
 #include <fibril_synch.h>
@@ -41,14 +42,191 @@
 #include <ipc/loc.h>
 #include <stdlib.h>
 #include <str.h>
+#include "rcache.h"
 #include "sroute.h"
 #include "inetsrv.h"
 #include "inet_link.h"
 
+/** Node of the binary trie the routes are looked up in
+ *
+ * The path from the root gives the destination prefix, one bit per level,
+ * starting with the most significant bit of the address.
+ */
+typedef struct inet_sroute_node {
+	/** Child extending the prefix with 0 and 1 */
+	struct inet_sroute_node *child[2];
+	/** Route to the prefix of this node or @c NULL */
+	inet_sroute_t *sroute;
+} inet_sroute_node_t;
+
 static FIBRIL_MUTEX_INITIALIZE(sroute_list_lock);
 static LIST_INITIALIZE(sroute_list);
 static sysarg_t sroute_id = 0;
 
+/** Trie roots for IPv4 and IPv6 routes */
+static inet_sroute_node_t *sroute_trie4 = NULL;
+static inet_sroute_node_t *sroute_trie6 = NULL;
+
+/** Get trie root for address version.
+ *
+ * @param ver	IP version
+ * @return	Pointer to the root or @c NULL if the version is not valid
+ */
+static inet_sroute_node_t **inet_sroute_trie(ip_ver_t ver)
+{
+	switch (ver) {
+	case ip_v4:
+		return &sroute_trie4;
+	case ip_v6:
+		return &sroute_trie6;
+	default:
+		return NULL;
+	}
+}
+
+/** Get number of bits of an address.
+ *
+ * @param ver	IP version
+ * @return	Number of bits or zero if the version is not valid
+ */
+static unsigned inet_sroute_addr_bits(ip_ver_t ver)
+{
+	switch (ver) {
+	case ip_v4:
+		return 32;
+	case ip_v6:
+		return 128;
+	default:
+		return 0;
+	}
+}
+
+/** Get bit of an address.
+ *
+ * @param addr	IPv4 or IPv6 address
+ * @param i	Index of the bit, 0 is the most significant one
+ * @return	Value of the bit
+ */
+static unsigned inet_sroute_addr_bit(const inet_addr_t *addr, unsigned i)
+{
+	if (addr->version == ip_v4)
+		return (addr->addr >> (31 - i)) & 1;
+
+	return (addr->addr6[i / 8] >> (7 - i % 8)) & 1;
+}
+
+/** Find static route with the same destination network.
+ *
+ * @param dest	Destination network
+ * @param skip	Route to ignore
+ * @return	Route or @c NULL
+ */
+static inet_sroute_t *inet_sroute_find_dest_locked(inet_naddr_t *dest,
+    inet_sroute_t *skip)
+{
+	inet_addr_t addr;
+
+	assert(fibril_mutex_is_locked(&sroute_list_lock));
+	inet_naddr_addr(dest, &addr);
+
+	list_foreach(sroute_list, sroute_list, inet_sroute_t, sroute) {
+		if (sroute == skip)
+			continue;
+		if (sroute->dest.version == dest->version &&
+		    sroute->dest.prefix == dest->prefix &&
+		    inet_naddr_compare_mask(&sroute->dest, &addr))
+			return sroute;
+	}
+
+	return NULL;
+}
+
+/** Insert static route into the trie.
+ *
+ * When there already is a route to the same network, it is left in place.
+ *
+ * @param sroute	Static route
+ * @return		EOK on success, ENOMEM if out of memory
+ */
+static errno_t inet_sroute_trie_insert_locked(inet_sroute_t *sroute)
+{
+	inet_addr_t addr;
+	uint8_t bits;
+
+	inet_naddr_get(&sroute->dest, NULL, NULL, &bits);
+	inet_naddr_addr(&sroute->dest, &addr);
+
+	inet_sroute_node_t **np = inet_sroute_trie(addr.version);
+	if (np == NULL || bits > inet_sroute_addr_bits(addr.version))
+		return EINVAL;
+
+	for (unsigned i = 0; ; i++) {
+		if (*np == NULL) {
+			*np = calloc(1, sizeof(inet_sroute_node_t));
+			if (*np == NULL)
+				return ENOMEM;
+		}
+
+		if (i == bits)
+			break;
+
+		np = &(*np)->child[inet_sroute_addr_bit(&addr, i)];
+	}
+
+	if ((*np)->sroute == NULL)
+		(*np)->sroute = sroute;
+
+	return EOK;
+}
+
+/** Remove static route from the trie.
+ *
+ * Another route to the same network takes its place. Nodes which are
+ * left without a route and children are freed.
+ *
+ * @param sroute	Static route
+ */
+static void inet_sroute_trie_remove_locked(inet_sroute_t *sroute)
+{
+	inet_sroute_node_t **path[128 + 1];
+	inet_addr_t addr;
+	uint8_t bits;
+	unsigned i;
+
+	inet_naddr_get(&sroute->dest, NULL, NULL, &bits);
+	inet_naddr_addr(&sroute->dest, &addr);
+
+	inet_sroute_node_t **np = inet_sroute_trie(addr.version);
+	if (np == NULL)
+		return;
+
+	for (i = 0; *np != NULL && i < bits; i++) {
+		path[i] = np;
+		np = &(*np)->child[inet_sroute_addr_bit(&addr, i)];
+	}
+
+	if (*np == NULL || (*np)->sroute != sroute)
+		return;
+
+	path[i] = np;
+	(*np)->sroute = inet_sroute_find_dest_locked(&sroute->dest, sroute);
+
+	/* Prune the nodes which are no longer needed */
+	while (true) {
+		inet_sroute_node_t *node = *path[i];
+		if (node->sroute != NULL || node->child[0] != NULL ||
+		    node->child[1] != NULL)
+			break;
+
+		free(node);
+		*path[i] = NULL;
+
+		if (i == 0)
+			break;
+		--i;
+	}
+}
+
 inet_sroute_t *inet_sroute_new(void)
 {
 	inet_sroute_t *sroute = calloc(1, sizeof(inet_sroute_t));
@@ -74,57 +252,64 @@ void inet_sroute_delete(inet_sroute_t *sroute)
 	free(sroute);
 }
 
-void inet_sroute_add(inet_sroute_t *sroute)
+errno_t inet_sroute_add(inet_sroute_t *sroute)
 {
+	errno_t rc;
+
 	fibril_mutex_lock(&sroute_list_lock);
+	rc = inet_sroute_trie_insert_locked(sroute);
+	if (rc != EOK) {
+		fibril_mutex_unlock(&sroute_list_lock);
+		return rc;
+	}
+
 	list_append(&sroute->sroute_list, &sroute_list);
 	fibril_mutex_unlock(&sroute_list_lock);
+
+	inet_rcache_flush();
+	return EOK;
 }
 
 void inet_sroute_remove(inet_sroute_t *sroute)
 {
 	fibril_mutex_lock(&sroute_list_lock);
 	list_remove(&sroute->sroute_list);
+	inet_sroute_trie_remove_locked(sroute);
 	fibril_mutex_unlock(&sroute_list_lock);
+
+	inet_rcache_flush();
 }
 
 /** Find static route object matching address @a addr.
+ *
+ * The trie is walked along the bits of the address, the last route seen
+ * on the way is the most specific one.
  *
  * @param addr	Address
  */
 inet_sroute_t *inet_sroute_find(inet_addr_t *addr)
 {
-	ip_ver_t addr_ver = inet_addr_get(addr, NULL, NULL);
-
 	inet_sroute_t *best = NULL;
-	uint8_t best_bits = 0;
+	unsigned bits = inet_sroute_addr_bits(addr->version);
 
-	fibril_mutex_lock(&sroute_list_lock);
-
-	list_foreach(sroute_list, sroute_list, inet_sroute_t, sroute) {
-		uint8_t dest_bits;
-		ip_ver_t dest_ver = inet_naddr_get(&sroute->dest, NULL, NULL,
-		    &dest_bits);
-
-		/* Skip comparison with different address family */
-		if (addr_ver != dest_ver)
-			continue;
-
-		/* Look for the most specific route */
-		if ((best != NULL) && (best_bits >= dest_bits))
-			continue;
+	if (bits == 0)
+		return NULL;
 
-		if (inet_naddr_compare_mask(&sroute->dest, addr)) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find: found candidate %p",
-			    sroute);
+	fibril_mutex_lock(&sroute_list_lock);
 
-			best = sroute;
-			best_bits = dest_bits;
-		}
+	inet_sroute_node_t *node = *inet_sroute_trie(addr->version);
+	for (unsigned i = 0; node != NULL; i++) {
+		if (node->sroute != NULL)
+			best = node->sroute;
+		if (i == bits)
+			break;
+		node = node->child[inet_sroute_addr_bit(addr, i)];
 	}
 
 	if (best == NULL)
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find: Not found");
+	else
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find: found %p", best);
 
 	fibril_mutex_unlock(&sroute_list_lock);
 
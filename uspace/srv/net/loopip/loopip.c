@@ -34,7 +34,7 @@
  * @brief Loopback IP link provider
  */
 
-#include <adt/prodcons.h>
+#include <adt/mpmc.h>
 #include <async.h>
 #include <errno.h>
 #include <str_error.h>
@@ -73,11 +73,16 @@ static iplink_ops_t loopip_iplink_ops = {
 };
 
 static iplink_srv_t loopip_iplink;
-static prodcons_t loopip_rcv_queue;
 
-typedef struct {
-	link_t link;
+enum {
+	/** Number of packets the receive queue can hold */
+	loopip_rcv_queue_size = 1024
+};
+
+static mpmc_cell_t loopip_rcv_cells[loopip_rcv_queue_size];
+static mpmc_t loopip_rcv_queue;
 
+typedef struct {
 	/* XXX Version should be part of SDU */
 	ip_ver_t ver;
 	iplink_recv_sdu_t sdu;
@@ -87,9 +92,7 @@ static errno_t loopip_recv_fibril(void *arg)
 {
 	while (true) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "loopip_recv_fibril(): Wait for one item");
-		link_t *link = prodcons_consume(&loopip_rcv_queue);
-		rqueue_entry_t *rqe =
-		    list_get_instance(link, rqueue_entry_t, link);
+		rqueue_entry_t *rqe = mpmc_pop(&loopip_rcv_queue);
 
 		(void) iplink_ev_recv(&loopip_iplink, &rqe->sdu, rqe->ver);
 
@@ -114,7 +117,7 @@ static errno_t loopip_init(void)
 	loopip_iplink.ops = &loopip_iplink_ops;
 	loopip_iplink.arg = NULL;
 
-	prodcons_initialize(&loopip_rcv_queue);
+	mpmc_init(&loopip_rcv_queue, loopip_rcv_cells, loopip_rcv_queue_size);
 
 	const char *svc_name = "net/loopback";
 	service_id_t sid;
@@ -166,6 +169,24 @@ static errno_t loopip_close(iplink_srv_t *srv)
 	return EOK;
 }
 
+/** Insert entry to receive queue.
+ *
+ * Like a NIC with a full receive ring, drop the packet if the queue is full.
+ * Blocking here could deadlock with the receive fibril, which may be waiting
+ * for the stack to send another packet through the loopback.
+ *
+ * @param rqe Receive queue entry (ownership transferred)
+ */
+static void loopip_enqueue(rqueue_entry_t *rqe)
+{
+	if (mpmc_try_push(&loopip_rcv_queue, rqe) != EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Receive queue full, "
+		    "dropping packet.");
+		free(rqe->sdu.data);
+		free(rqe);
+	}
+}
+
 static errno_t loopip_send(iplink_srv_t *srv, iplink_sdu_t *sdu)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "loopip_send()");
@@ -187,11 +208,7 @@ static errno_t loopip_send(iplink_srv_t *srv, iplink_sdu_t *sdu)
 	memcpy(rqe->sdu.data, sdu->data, sdu->size);
 	rqe->sdu.size = sdu->size;
 
-	/*
-	 * Insert to receive queue
-	 */
-	prodcons_produce(&loopip_rcv_queue, &rqe->link);
-
+	loopip_enqueue(rqe);
 	return EOK;
 }
 
@@ -216,11 +233,7 @@ static errno_t loopip_send6(iplink_srv_t *srv, iplink_sdu6_t *sdu)
 	memcpy(rqe->sdu.data, sdu->data, sdu->size);
 	rqe->sdu.size = sdu->size;
 
-	/*
-	 * Insert to receive queue
-	 */
-	prodcons_produce(&loopip_rcv_queue, &rqe->link);
-
+	loopip_enqueue(rqe);
 	return EOK;
 }
 
@@ -40,8 +40,10 @@
 #include <io/log.h>
 #include <macros.h>
 #include <nettl/amap.h>
+#include <rndgen.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <time.h>
 #include "conn.h"
 #include "inet.h"
 #include "iqueue.h"
@@ -56,6 +58,13 @@
 #define RCV_BUF_SIZE 4096/*2*/
 #define SND_BUF_SIZE 4096
 
+/** Upper limit of send and receive buffer size */
+#define BUF_SIZE_MAX (4 * 1024 * 1024)
+/** Receive window shift count, BUF_SIZE_MAX >> RCV_WSCALE fits 16 bits */
+#define RCV_WSCALE 7
+/** Receive buffer auto-tuning period until RTT is known */
+#define RCV_AUTOTUNE_PERIOD MSEC2USEC(100)
+
 #define MAX_SEGMENT_LIFETIME	(15*1000*1000) //(2*60*1000*1000)
 #define TIME_WAIT_TIMEOUT	(2*MAX_SEGMENT_LIFETIME)
 
@@ -135,6 +144,9 @@ tcp_conn_t *tcp_conn_new(inet_ep2_t *epp)
 	conn->rcv_buf_size = RCV_BUF_SIZE;
 	conn->rcv_buf_used = 0;
 	conn->rcv_buf_fin = false;
+	conn->rcv_buf_autotune = true;
+	conn->rcv_buf_copied = 0;
+	getuptime(&conn->rcv_buf_at);
 
 	conn->rcv_buf = calloc(1, conn->rcv_buf_size);
 	if (conn->rcv_buf == NULL)
@@ -370,6 +382,23 @@ static void tcp_conn_state_set(tcp_conn_t *conn, tcp_cstate_t nstate)
 	}
 }
 
+/** Select initial send sequence number.
+ *
+ * Predictable sequence numbers make it easy to inject segments into
+ * or reset connections of other hosts (RFC 6528).
+ *
+ * @return Initial send sequence number
+ */
+static uint32_t tcp_conn_iss(void)
+{
+	uint32_t iss;
+
+	if (rndgen_fill_local(&iss, sizeof(iss)) != EOK)
+		return 1;
+
+	return iss;
+}
+
 /** Synchronize connection.
  *
  * This is the first step of an active connection attempt,
@@ -379,12 +408,16 @@ void tcp_conn_sync(tcp_conn_t *conn)
 {
 	assert(fibril_mutex_is_locked(&conn->lock));
 
-	/* XXX select ISS */
-	conn->iss = 1;
+	conn->iss = tcp_conn_iss();
 	conn->snd_nxt = conn->iss;
 	conn->snd_una = conn->iss;
 	conn->ap = ap_active;
 
+	/* Offer window scaling and timestamps */
+	conn->ws_ok = true;
+	conn->rcv_wscale = RCV_WSCALE;
+	conn->ts_ok = true;
+
 	tcp_tqueue_ctrl_seg(conn, CTL_SYN);
 	tcp_conn_state_set(conn, st_syn_sent);
 }
@@ -511,6 +544,187 @@ bool tcp_conn_got_syn(tcp_conn_t *conn)
 	assert(false);
 }
 
+/** Get current value of timestamp clock.
+ *
+ * @return	Milliseconds since boot modulo 2^32
+ */
+uint32_t tcp_conn_ts_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return SEC2MSEC(ts.tv_sec) + NSEC2MSEC(ts.tv_nsec);
+}
+
+/** Change receive buffer size.
+ *
+ * The receive window must not shrink, therefore the buffer can only be
+ * made smaller before the connection is synchronized.
+ *
+ * @param conn	Connection
+ * @param size	New size in bytes
+ * @return	EOK on success, EBUSY if the buffer cannot be shrunk,
+ *		ENOMEM if out of memory
+ */
+static errno_t tcp_conn_rcv_buf_realloc(tcp_conn_t *conn, size_t size)
+{
+	uint8_t *nbuf;
+
+	if (size < conn->rcv_buf_size && conn->cstate != st_listen)
+		return EBUSY;
+
+	nbuf = realloc(conn->rcv_buf, size);
+	if (nbuf == NULL)
+		return ENOMEM;
+
+	conn->rcv_buf = nbuf;
+	if (conn->cstate == st_listen)
+		conn->rcv_wnd = size;
+	else
+		conn->rcv_wnd += size - conn->rcv_buf_size;
+	conn->rcv_buf_size = size;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: receive buffer size %zu",
+	    conn->name, size);
+	return EOK;
+}
+
+/** Change send buffer size.
+ *
+ * @param conn	Connection
+ * @param size	New size in bytes
+ * @return	EOK on success, EBUSY if the buffer holds more data than
+ *		@a size, ENOMEM if out of memory
+ */
+static errno_t tcp_conn_snd_buf_realloc(tcp_conn_t *conn, size_t size)
+{
+	uint8_t *nbuf;
+
+	if (size < conn->snd_buf_used)
+		return EBUSY;
+
+	nbuf = realloc(conn->snd_buf, size);
+	if (nbuf == NULL)
+		return ENOMEM;
+
+	conn->snd_buf = nbuf;
+	conn->snd_buf_size = size;
+	fibril_condvar_broadcast(&conn->snd_buf_cv);
+	return EOK;
+}
+
+/** Set send and receive buffer size.
+ *
+ * Setting the receive buffer size disables its auto-tuning.
+ *
+ * @param conn		Connection
+ * @param snd_size	Send buffer size in bytes or zero to keep it
+ * @param rcv_size	Receive buffer size in bytes or zero to keep it
+ * @return		EOK on success, EINVAL if size is out of range,
+ *			EBUSY if the buffer cannot be shrunk now,
+ *			ENOMEM if out of memory
+ */
+errno_t tcp_conn_set_bufsize(tcp_conn_t *conn, size_t snd_size,
+    size_t rcv_size)
+{
+	errno_t rc;
+
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	if (snd_size > BUF_SIZE_MAX || rcv_size > BUF_SIZE_MAX)
+		return EINVAL;
+
+	if (snd_size != 0) {
+		rc = tcp_conn_snd_buf_realloc(conn, snd_size);
+		if (rc != EOK)
+			return rc;
+	}
+
+	if (rcv_size != 0) {
+		rc = tcp_conn_rcv_buf_realloc(conn, rcv_size);
+		if (rc != EOK)
+			return rc;
+		conn->rcv_buf_autotune = false;
+	}
+
+	return EOK;
+}
+
+/** Auto-tune receive buffer size after user removed data from it.
+ *
+ * If the user consumes at least half of the receive buffer per round-trip
+ * time, the receive window is likely limiting throughput and the buffer
+ * size is doubled. Without window scaling there is no point in growing
+ * the buffer beyond the largest window that can be advertised.
+ *
+ * @param conn		Connection
+ * @param copied	Number of bytes just removed from receive buffer
+ */
+void tcp_conn_rcv_buf_autotune(tcp_conn_t *conn, size_t copied)
+{
+	struct timespec now;
+	usec_t period;
+	usec_t elapsed;
+	size_t max_size;
+	size_t nsize;
+
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	if (!conn->rcv_buf_autotune)
+		return;
+
+	conn->rcv_buf_copied += copied;
+
+	period = conn->cc.rtt_valid ? max(conn->cc.srtt, (usec_t) 1) :
+	    RCV_AUTOTUNE_PERIOD;
+
+	getuptime(&now);
+	elapsed = NSEC2USEC(ts_sub_diff(&now, &conn->rcv_buf_at));
+	if (elapsed < period)
+		return;
+
+	/* Bytes consumed per round-trip time */
+	if ((uint64_t) conn->rcv_buf_copied * period / elapsed >=
+	    conn->rcv_buf_size / 2) {
+		max_size = conn->ws_ok ? BUF_SIZE_MAX : UINT16_MAX;
+		nsize = min(2 * conn->rcv_buf_size, max_size);
+		if (nsize > conn->rcv_buf_size)
+			(void) tcp_conn_rcv_buf_realloc(conn, nsize);
+	}
+
+	conn->rcv_buf_copied = 0;
+	conn->rcv_buf_at = now;
+}
+
+/** Process options of SYN received from peer.
+ *
+ * Window scaling and timestamps are only used if both sides include
+ * the respective option in their SYN.
+ *
+ * @param conn		Connection
+ * @param seg		SYN segment
+ */
+static void tcp_conn_syn_opts(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	if (conn->ws_ok && seg->ws_present) {
+		conn->snd_wscale = seg->ws_shift;
+		conn->rcv_wscale = RCV_WSCALE;
+	} else {
+		conn->ws_ok = false;
+		conn->snd_wscale = 0;
+		conn->rcv_wscale = 0;
+	}
+
+	if (conn->ts_ok && seg->ts_present)
+		conn->ts_recent = seg->ts_val;
+	else
+		conn->ts_ok = false;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: window scale %s (snd %u, rcv %u), "
+	    "timestamps %s", conn->name, conn->ws_ok ? "on" : "off",
+	    conn->snd_wscale, conn->rcv_wscale, conn->ts_ok ? "on" : "off");
+}
+
 /** Segment arrived in Listen state.
  *
  * @param conn		Connection
@@ -546,11 +760,15 @@ static void tcp_conn_sa_listen(tcp_conn_t *conn, tcp_segment_t *seg)
 	if (seg->len > 1)
 		log_msg(LOG_DEFAULT, LVL_WARN, "SYN combined with data, ignoring data.");
 
-	/* XXX select ISS */
-	conn->iss = 1;
+	conn->iss = tcp_conn_iss();
 	conn->snd_nxt = conn->iss;
 	conn->snd_una = conn->iss;
 
+	/* Use window scaling and timestamps if the peer offers them */
+	conn->ws_ok = true;
+	conn->ts_ok = true;
+	tcp_conn_syn_opts(conn, seg);
+
 	/*
 	 * Surprisingly the spec does not deal with initial window setting.
 	 * Set SND.WND = SEG.WND and set SND.WL1 so that next segment
@@ -615,6 +833,8 @@ static void tcp_conn_sa_syn_sent(tcp_conn_t *conn, tcp_segment_t *seg)
 	conn->rcv_nxt = seg->seq + 1;
 	conn->irs = seg->seq;
 
+	tcp_conn_syn_opts(conn, seg);
+
 	if ((seg->ctrl & CTL_ACK) != 0) {
 		conn->snd_una = seg->ack;
 
@@ -673,6 +893,15 @@ static void tcp_conn_sa_queue(tcp_conn_t *conn, tcp_segment_t *seg)
 		return;
 	}
 
+	/*
+	 * Remember the timestamp to echo from the newest segment that
+	 * does not start beyond RCV.NXT (RFC 7323 section 4.3).
+	 */
+	if (conn->ts_ok && seg->ts_present &&
+	    (int32_t) (seg->seq - conn->rcv_nxt) <= 0 &&
+	    (int32_t) (seg->ts_val - conn->ts_recent) >= 0)
+		conn->ts_recent = seg->ts_val;
+
 	/* Queue for processing */
 	tcp_iqueue_insert_seg(&conn->incoming, seg);
 
@@ -811,8 +1040,14 @@ static cproc_t tcp_conn_seg_proc_ack_sr(tcp_conn_t *conn, tcp_segment_t *seg)
  */
 static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 {
+	bool dup_ack = false;
+	uint32_t wnd;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_seg_proc_ack_est(%p, %p)", conn, seg);
 
+	/* Window in segments other than SYN is scaled */
+	wnd = (uint32_t) seg->wnd << conn->snd_wscale;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "SEG.ACK=%u, SND.UNA=%u, SND.NXT=%u",
 	    (unsigned)seg->ack, (unsigned)conn->snd_una,
 	    (unsigned)conn->snd_nxt);
@@ -827,15 +1062,28 @@ static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 			tcp_segment_delete(seg);
 			return cp_done;
 		} else {
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "Ignoring duplicate ACK.");
+			/*
+			 * Only a segment without data and window update
+			 * acknowledging SND.UNA counts as duplicate ACK for
+			 * the purpose of fast retransmit (RFC 5681 section 2).
+			 */
+			dup_ack = seg->ack == conn->snd_una && seg->len == 0 &&
+			    wnd == conn->snd_wnd;
 		}
 	} else {
 		/* Update SND.UNA */
 		conn->snd_una = seg->ack;
+
+		/* Measure RTT using echoed timestamp (RFC 7323 section 4) */
+		if (conn->ts_ok && seg->ts_present && seg->ts_ecr != 0) {
+			conn->cc.rtt_timing = false;
+			tcp_tqueue_rtt_sample(conn,
+			    MSEC2USEC((usec_t) (tcp_conn_ts_now() - seg->ts_ecr)));
+		}
 	}
 
 	if (seq_no_new_wnd_update(conn, seg)) {
-		conn->snd_wnd = seg->wnd;
+		conn->snd_wnd = wnd;
 		conn->snd_wl1 = seg->seq;
 		conn->snd_wl2 = seg->ack;
 
@@ -848,7 +1096,10 @@ static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 	 * Prune acked segments from retransmission queue and
 	 * possibly transmit more data.
 	 */
-	tcp_tqueue_ack_received(conn);
+	if (dup_ack)
+		tcp_tqueue_dup_ack(conn);
+	else
+		tcp_tqueue_ack_received(conn);
 
 	return cp_continue;
 }
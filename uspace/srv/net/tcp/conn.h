@@ -53,6 +53,9 @@ extern void tcp_conn_delref(tcp_conn_t *);
 extern void tcp_conn_lock(tcp_conn_t *);
 extern void tcp_conn_unlock(tcp_conn_t *);
 extern bool tcp_conn_got_syn(tcp_conn_t *);
+extern uint32_t tcp_conn_ts_now(void);
+extern errno_t tcp_conn_set_bufsize(tcp_conn_t *, size_t, size_t);
+extern void tcp_conn_rcv_buf_autotune(tcp_conn_t *, size_t);
 extern void tcp_conn_segment_arrived(tcp_conn_t *, inet_ep2_t *,
     tcp_segment_t *);
 extern void tcp_unexpected_segment(inet_ep2_t *, tcp_segment_t *);
@@ -38,6 +38,7 @@
 #include <byteorder.h>
 #include <errno.h>
 #include <inet/endpoint.h>
+#include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
 #include "pdu.h"
@@ -125,7 +126,118 @@ static void tcp_header_encode_flags(tcp_control_t ctl, uint16_t doff_flags0,
 	*rdoff_flags = doff_flags;
 }
 
-static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg, tcp_header_t *hdr)
+/** Get 32-bit big-endian value from unaligned option data. */
+static uint32_t tcp_opt_get32(uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+	    ((uint32_t)p[2] << 8) | p[3];
+}
+
+/** Store 32-bit big-endian value to unaligned option data. */
+static void tcp_opt_put32(uint8_t *p, uint32_t val)
+{
+	p[0] = val >> 24;
+	p[1] = (val >> 16) & 0xff;
+	p[2] = (val >> 8) & 0xff;
+	p[3] = val & 0xff;
+}
+
+/** Determine size of options that will be encoded for a segment.
+ *
+ * Options are padded with NOPs so that each option is aligned as
+ * recommended by RFC 7323 appendix A. The size is a multiple of four.
+ */
+static size_t tcp_header_opts_size(tcp_segment_t *seg)
+{
+	size_t size = 0;
+
+	if (seg->ws_present)
+		size += 1 + OPT_WINDOW_SCALE_LEN;
+	if (seg->ts_present)
+		size += 2 + OPT_TIMESTAMP_LEN;
+
+	return size;
+}
+
+/** Encode segment options.
+ *
+ * @param seg	Segment
+ * @param opt	Destination buffer of tcp_header_opts_size(seg) bytes
+ */
+static void tcp_header_encode_opts(tcp_segment_t *seg, uint8_t *opt)
+{
+	if (seg->ws_present) {
+		*opt++ = OPT_NOP;
+		*opt++ = OPT_WINDOW_SCALE;
+		*opt++ = OPT_WINDOW_SCALE_LEN;
+		*opt++ = seg->ws_shift;
+	}
+
+	if (seg->ts_present) {
+		*opt++ = OPT_NOP;
+		*opt++ = OPT_NOP;
+		*opt++ = OPT_TIMESTAMP;
+		*opt++ = OPT_TIMESTAMP_LEN;
+		tcp_opt_put32(opt, seg->ts_val);
+		tcp_opt_put32(opt + 4, seg->ts_ecr);
+	}
+}
+
+/** Decode segment options.
+ *
+ * Unknown options are skipped, decoding stops at a malformed option.
+ *
+ * @param opt	Option data
+ * @param size	Size of option data in bytes
+ * @param seg	Segment to fill in
+ */
+static void tcp_header_decode_opts(uint8_t *opt, size_t size,
+    tcp_segment_t *seg)
+{
+	size_t i;
+	uint8_t len;
+
+	i = 0;
+	while (i < size) {
+		if (opt[i] == OPT_END_LIST)
+			break;
+
+		if (opt[i] == OPT_NOP) {
+			++i;
+			continue;
+		}
+
+		if (i + 1 >= size)
+			break;
+
+		len = opt[i + 1];
+		if (len < 2 || len > size - i)
+			break;
+
+		switch (opt[i]) {
+		case OPT_WINDOW_SCALE:
+			if (len != OPT_WINDOW_SCALE_LEN)
+				break;
+			seg->ws_present = true;
+			seg->ws_shift = min(opt[i + 2], TCP_WSCALE_MAX);
+			break;
+		case OPT_TIMESTAMP:
+			if (len != OPT_TIMESTAMP_LEN)
+				break;
+			seg->ts_present = true;
+			seg->ts_val = tcp_opt_get32(&opt[i + 2]);
+			seg->ts_ecr = tcp_opt_get32(&opt[i + 6]);
+			break;
+		default:
+			break;
+		}
+
+		i += len;
+	}
+}
+
+static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg,
+    tcp_header_t *hdr, size_t hdr_size)
 {
 	uint16_t doff_flags;
 	uint16_t doff;
@@ -135,7 +247,7 @@ static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg, tcp_header_t *
 	hdr->seq = host2uint32_t_be(seg->seq);
 	hdr->ack = host2uint32_t_be(seg->ack);
 
-	doff = (sizeof(tcp_header_t) / sizeof(uint32_t)) << DF_DATA_OFFSET_l;
+	doff = (hdr_size / sizeof(uint32_t)) << DF_DATA_OFFSET_l;
 	tcp_header_encode_flags(seg->ctrl, doff, &doff_flags);
 
 	hdr->doff_flags = host2uint16_t_be(doff_flags);
@@ -194,14 +306,18 @@ static errno_t tcp_header_encode(inet_ep2_t *epp, tcp_segment_t *seg,
     void **header, size_t *size)
 {
 	tcp_header_t *hdr;
+	size_t hdr_size;
 
-	hdr = calloc(1, sizeof(tcp_header_t));
+	hdr_size = sizeof(tcp_header_t) + tcp_header_opts_size(seg);
+
+	hdr = calloc(1, hdr_size);
 	if (hdr == NULL)
 		return ENOMEM;
 
-	tcp_header_setup(epp, seg, hdr);
+	tcp_header_setup(epp, seg, hdr, hdr_size);
+	tcp_header_encode_opts(seg, (uint8_t *)(hdr + 1));
 	*header = hdr;
-	*size = sizeof(tcp_header_t);
+	*size = hdr_size;
 
 	return EOK;
 }
@@ -260,10 +376,14 @@ void tcp_pdu_delete(tcp_pdu_t *pdu)
 	free(pdu);
 }
 
+/** Compute the sum of the pseudo header to leave in the checksum field.
+ *
+ * The sum of the rest of the PDU is added to it and the checksum is
+ * completed by the network layer or by the NIC.
+ */
 static uint16_t tcp_pdu_checksum_calc(tcp_pdu_t *pdu)
 {
 	uint16_t cs_phdr;
-	uint16_t cs_headers;
 	tcp_phdr_t phdr;
 	tcp_phdr6_t phdr6;
 
@@ -281,8 +401,7 @@ static uint16_t tcp_pdu_checksum_calc(tcp_pdu_t *pdu)
 		assert(false);
 	}
 
-	cs_headers = tcp_checksum_calc(cs_phdr, pdu->header, pdu->header_size);
-	return tcp_checksum_calc(cs_headers, pdu->text, pdu->text_size);
+	return ~cs_phdr;
 }
 
 static void tcp_pdu_set_checksum(tcp_pdu_t *pdu, uint16_t checksum)
@@ -307,6 +426,10 @@ errno_t tcp_pdu_decode(tcp_pdu_t *pdu, inet_ep2_t *epp, tcp_segment_t **seg)
 	nseg->len += seq_no_control_len(nseg->ctrl);
 
 	hdr = (tcp_header_t *)pdu->header;
+	if (pdu->header_size > sizeof(tcp_header_t)) {
+		tcp_header_decode_opts((uint8_t *)(hdr + 1),
+		    pdu->header_size - sizeof(tcp_header_t), nseg);
+	}
 
 	epp->local.port = uint16_t_be2host(hdr->dest_port);
 	epp->local.addr = pdu->dest;
@@ -317,7 +440,10 @@ errno_t tcp_pdu_decode(tcp_pdu_t *pdu, inet_ep2_t *epp, tcp_segment_t **seg)
 	return EOK;
 }
 
-/** Encode outgoing PDU */
+/** Encode outgoing PDU
+ *
+ * The checksum is left partial, it needs to be sent with INET_CSUM_PARTIAL.
+ */
 errno_t tcp_pdu_encode(inet_ep2_t *epp, tcp_segment_t *seg, tcp_pdu_t **pdu)
 {
 	tcp_pdu_t *npdu;
@@ -348,7 +474,7 @@ errno_t tcp_pdu_encode(inet_ep2_t *epp, tcp_segment_t *seg, tcp_pdu_t **pdu)
 	npdu->text_size = text_size;
 	memcpy(npdu->text, seg->data, text_size);
 
-	/* Checksum calculation */
+	/* Partial checksum calculation */
 	checksum = tcp_pdu_checksum_calc(npdu);
 	tcp_pdu_set_checksum(npdu, checksum);
 
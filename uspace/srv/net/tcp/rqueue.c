@@ -32,23 +32,43 @@
 
 /**
  * @file Global segment receive queue
+ *
+ * The queue is split in shards, each served by its own fibril. Segments are
+ * assigned to shards by hash of their endpoint pair, so the segments of one
+ * connection are processed in order, while a connection waiting e.g. for its
+ * lock does not hold up segments of connections in other shards.
+ *
+ * The hash is the receive-side scaling hash NICs use to pick the receive
+ * queue, with the default key. With the default redirection table, which
+ * spreads the hash values over the queues in turn, and a number of queues
+ * dividing the number of shards, each shard only gets the segments received
+ * on a single NIC queue.
  */
 
-#include <adt/prodcons.h>
+#include <adt/mpmc.h>
 #include <errno.h>
 #include <io/log.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <fibril.h>
 #include <fibril_synch.h>
+#include <inet/rss.h>
 #include "conn.h"
 #include "rqueue.h"
 #include "segment.h"
 #include "tcp_type.h"
 #include "ucall.h"
 
-static prodcons_t rqueue;
-static bool fibril_active;
+enum {
+	/** Number of receive queue shards, a multiple of NIC queue counts */
+	rqueue_shards = 8,
+	/** Number of entries each shard can hold */
+	rqueue_shard_size = 256
+};
+
+static mpmc_cell_t rqueue_cells[rqueue_shards][rqueue_shard_size];
+static mpmc_t rqueue[rqueue_shards];
+static size_t fibrils_active;
 static fibril_mutex_t lock;
 static fibril_condvar_t cv;
 static tcp_rqueue_cb_t *rqueue_cb;
@@ -56,27 +76,85 @@ static tcp_rqueue_cb_t *rqueue_cb;
 /** Initialize segment receive queue. */
 void tcp_rqueue_init(tcp_rqueue_cb_t *rcb)
 {
-	prodcons_initialize(&rqueue);
+	size_t i;
+
+	for (i = 0; i < rqueue_shards; i++)
+		mpmc_init(&rqueue[i], rqueue_cells[i], rqueue_shard_size);
 	fibril_mutex_initialize(&lock);
 	fibril_condvar_initialize(&cv);
-	fibril_active = false;
+	fibrils_active = 0;
 	rqueue_cb = rcb;
 }
 
+/** Enqueue an entry to one receive queue shard.
+ *
+ * Segments are dropped if the shard is full, like a NIC drops packets
+ * when its receive ring is full, rather than holding up the IP link.
+ * Stop requests wait for space in the shard.
+ *
+ * @param shard Shard number
+ * @param epp   Endpoint pair, oriented for reception
+ * @param seg   Segment (ownership transferred to rqueue) or @c NULL to
+ *              stop the shard fibril
+ */
+static void tcp_rqueue_produce(size_t shard, inet_ep2_t *epp,
+    tcp_segment_t *seg)
+{
+	tcp_rqueue_entry_t *rqe;
+
+	rqe = calloc(1, sizeof(tcp_rqueue_entry_t));
+	if (rqe == NULL) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed allocating RQE.");
+		return;
+	}
+
+	rqe->epp = *epp;
+	rqe->seg = seg;
+
+	if (seg == NULL) {
+		mpmc_push(&rqueue[shard], rqe);
+		return;
+	}
+
+	if (mpmc_try_push(&rqueue[shard], rqe) != EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Receive queue shard full, "
+		    "dropping segment.");
+		tcp_segment_delete(seg);
+		free(rqe);
+	}
+}
+
 /** Finalize segment receive queue. */
 void tcp_rqueue_fini(void)
 {
 	inet_ep2_t epp;
+	size_t i;
 
 	inet_ep2_init(&epp);
-	tcp_rqueue_insert_seg(&epp, NULL);
+	for (i = 0; i < rqueue_shards; i++)
+		tcp_rqueue_produce(i, &epp, NULL);
 
 	fibril_mutex_lock(&lock);
-	while (fibril_active)
+	while (fibrils_active > 0)
 		fibril_condvar_wait(&cv, &lock);
 	fibril_mutex_unlock(&lock);
 }
 
+/** Determine receive queue shard for an endpoint pair.
+ *
+ * @param epp Endpoint pair, oriented for reception
+ * @return Shard number
+ */
+static size_t tcp_rqueue_shard(inet_ep2_t *epp)
+{
+	uint32_t hash;
+
+	hash = inet_rss_hash_flow(inet_rss_default_key, &epp->remote.addr,
+	    &epp->local.addr, epp->remote.port, epp->local.port);
+
+	return inet_rss_reta_index(hash) % rqueue_shards;
+}
+
 /** Insert segment into receive queue.
  *
  * @param epp	Endpoint pair, oriented for reception
@@ -84,36 +162,27 @@ void tcp_rqueue_fini(void)
  */
 void tcp_rqueue_insert_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 {
-	tcp_rqueue_entry_t *rqe;
-
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "tcp_rqueue_insert_seg()");
 
 	if (seg != NULL)
 		tcp_segment_dump(seg);
 
-	rqe = calloc(1, sizeof(tcp_rqueue_entry_t));
-	if (rqe == NULL) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed allocating RQE.");
-		return;
-	}
-
-	rqe->epp = *epp;
-	rqe->seg = seg;
-
-	prodcons_produce(&rqueue, &rqe->link);
+	tcp_rqueue_produce(tcp_rqueue_shard(epp), epp, seg);
 }
 
-/** Receive queue handler fibril. */
+/** Receive queue shard handler fibril.
+ *
+ * @param arg Shard queue (mpmc_t *)
+ */
 static errno_t tcp_rqueue_fibril(void *arg)
 {
-	link_t *link;
+	mpmc_t *queue = (mpmc_t *) arg;
 	tcp_rqueue_entry_t *rqe;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_rqueue_fibril()");
 
 	while (true) {
-		link = prodcons_consume(&rqueue);
-		rqe = list_get_instance(link, tcp_rqueue_entry_t, link);
+		rqe = mpmc_pop(queue);
 
 		if (rqe->seg == NULL) {
 			free(rqe);
@@ -128,28 +197,34 @@ static errno_t tcp_rqueue_fibril(void *arg)
 
 	/* Finished */
 	fibril_mutex_lock(&lock);
-	fibril_active = false;
+	fibrils_active--;
 	fibril_mutex_unlock(&lock);
 	fibril_condvar_broadcast(&cv);
 
 	return 0;
 }
 
-/** Start receive queue handler fibril. */
+/** Start receive queue handler fibrils. */
 void tcp_rqueue_fibril_start(void)
 {
 	fid_t fid;
+	size_t i;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_rqueue_fibril_start()");
 
-	fid = fibril_create(tcp_rqueue_fibril, NULL);
-	if (fid == 0) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed creating rqueue fibril.");
-		return;
-	}
+	for (i = 0; i < rqueue_shards; i++) {
+		fid = fibril_create(tcp_rqueue_fibril, &rqueue[i]);
+		if (fid == 0) {
+			log_msg(LOG_DEFAULT, LVL_ERROR, "Failed creating rqueue "
+			    "fibril.");
+			continue;
+		}
 
-	fibril_add_ready(fid);
-	fibril_active = true;
+		fibril_mutex_lock(&lock);
+		fibrils_active++;
+		fibril_mutex_unlock(&lock);
+		fibril_add_ready(fid);
+	}
 }
 
 /**
@@ -74,6 +74,11 @@ tcp_segment_t *tcp_segment_dup(tcp_segment_t *seg)
 	scopy->len = seg->len;
 	scopy->wnd = seg->wnd;
 	scopy->up = seg->up;
+	scopy->ws_present = seg->ws_present;
+	scopy->ws_shift = seg->ws_shift;
+	scopy->ts_present = seg->ts_present;
+	scopy->ts_val = seg->ts_val;
+	scopy->ts_ecr = seg->ts_ecr;
 
 	tsize = tcp_segment_text_size(seg);
 	scopy->data = calloc(tsize, 1);
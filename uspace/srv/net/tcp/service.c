@@ -34,6 +34,7 @@
  * @file HelenOS service implementation
  */
 
+#include <as.h>
 #include <async.h>
 #include <errno.h>
 #include <str_error.h>
@@ -68,6 +69,7 @@ static void tcp_service_recv_data(tcp_conn_t *, void *);
 static void tcp_service_lst_cstate_change(tcp_conn_t *, void *, tcp_cstate_t);
 
 static errno_t tcp_cconn_create(tcp_client_t *, tcp_conn_t *, tcp_cconn_t **);
+static void tcp_cconn_rx_fill(tcp_cconn_t *);
 
 /** Connection callbacks to tie us to lower layer */
 static tcp_cb_t tcp_service_cb = {
@@ -195,6 +197,11 @@ static void tcp_service_recv_data(tcp_conn_t *conn, void *arg)
 {
 	tcp_cconn_t *cconn = (tcp_cconn_t *)arg;
 
+	if (cconn->rings != NULL) {
+		tcp_cconn_rx_fill(cconn);
+		return;
+	}
+
 	tcp_ev_data(cconn);
 }
 
@@ -331,9 +338,95 @@ static errno_t tcp_cconn_create(tcp_client_t *client, tcp_conn_t *conn,
 static void tcp_cconn_destroy(tcp_cconn_t *cconn)
 {
 	list_remove(&cconn->lclient);
+	if (cconn->rings != NULL)
+		as_area_destroy(cconn->rings);
 	free(cconn);
 }
 
+/** Move received data to the rx ring shared with the client.
+ *
+ * The client is only notified when data is put to a ring it found empty.
+ * Data that does not fit in the ring is left in the receive buffer, closing
+ * the receive window, until the client frees space in the ring.
+ *
+ * @param cconn Client connection, its connection must be locked
+ */
+static void tcp_cconn_rx_fill(tcp_cconn_t *cconn)
+{
+	tcp_ring_t *ring = &cconn->rings->rx;
+	xflags_t xflags;
+	bool kick = false;
+	size_t space;
+	size_t rcvd;
+	tcp_error_t trc;
+	void *sp;
+
+	while (!atomic_load(&ring->fin)) {
+		sp = tcp_ring_wspace(ring, &space);
+		if (space == 0) {
+			if (tcp_ring_wr_idle(ring))
+				break;
+			continue;
+		}
+
+		trc = tcp_uc_receive_locked(cconn->conn, sp, space, &rcvd,
+		    &xflags);
+		if (trc == TCP_EAGAIN)
+			break;
+
+		if (trc != TCP_EOK) {
+			/* End of data or connection reset */
+			atomic_store(&ring->fin, true);
+			if (atomic_exchange(&ring->rd_kick, false))
+				kick = true;
+			break;
+		}
+
+		if (tcp_ring_produce(ring, rcvd))
+			kick = true;
+	}
+
+	if (kick)
+		tcp_ev_data(cconn);
+}
+
+/** Send the data the client put to the tx ring.
+ *
+ * @param cconn Client connection
+ * @return EOK on success or EIO if the data could not be sent
+ */
+static errno_t tcp_cconn_tx_drain(tcp_cconn_t *cconn)
+{
+	tcp_ring_t *ring;
+	tcp_error_t trc;
+	size_t size;
+	void *data;
+
+	if (cconn->rings == NULL)
+		return EOK;
+
+	ring = &cconn->rings->tx;
+
+	while (!atomic_load(&ring->fin)) {
+		data = tcp_ring_rdata(ring, &size);
+		if (size == 0) {
+			if (tcp_ring_rd_idle(ring))
+				break;
+			continue;
+		}
+
+		trc = tcp_uc_send(cconn->conn, data, size, 0);
+		if (trc != TCP_EOK) {
+			/* Make the client fail further sends */
+			atomic_store(&ring->fin, true);
+		}
+
+		(void) tcp_ring_consume(ring, size);
+	}
+
+	return atomic_load(&ring->fin) ? EIO : EOK;
+}
+
 /** Create client listener.
  *
  * Create client listener based on sentinel connection.
@@ -493,6 +586,7 @@ static errno_t tcp_conn_destroy_impl(tcp_client_t *client, sysarg_t conn_id)
 		return ENOENT;
 	}
 
+	(void) tcp_cconn_tx_drain(cconn);
 	tcp_uc_close(cconn->conn);
 	tcp_uc_delete(cconn->conn);
 	tcp_cconn_destroy(cconn);
@@ -593,7 +687,8 @@ static errno_t tcp_conn_send_fin_impl(tcp_client_t *client, sysarg_t conn_id)
 		return ENOENT;
 	}
 
-	(void) cconn;
+	/* Data sent before must go out first */
+	(void) tcp_cconn_tx_drain(cconn);
 	/* XXX TODO */
 	return EOK;
 }
@@ -618,11 +713,84 @@ static errno_t tcp_conn_push_impl(tcp_client_t *client, sysarg_t conn_id)
 		return ENOENT;
 	}
 
-	(void) cconn;
+	/* Data sent before must go out first */
+	(void) tcp_cconn_tx_drain(cconn);
 	/* XXX TODO */
 	return EOK;
 }
 
+/** Get connection statistics.
+ *
+ * Handle client request to get connection statistics (with parameters
+ * unmarshalled).
+ *
+ * @param client  TCP client
+ * @param conn_id Connection ID
+ * @param stats   Place to store statistics
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t tcp_conn_stats_impl(tcp_client_t *client, sysarg_t conn_id,
+    tcp_conn_stats_t *stats)
+{
+	tcp_cconn_t *cconn;
+	tcp_cc_t *cc;
+	errno_t rc;
+
+	rc = tcp_cconn_get(client, conn_id, &cconn);
+	if (rc != EOK) {
+		assert(rc == ENOENT);
+		return ENOENT;
+	}
+
+	tcp_conn_lock(cconn->conn);
+	cc = &cconn->conn->cc;
+	stats->cwnd = cc->cwnd;
+	stats->ssthresh = cc->ssthresh;
+	stats->srtt = cc->srtt;
+	stats->rttvar = cc->rttvar;
+	stats->rto = cc->rto;
+	stats->segs_out = cc->segs_out;
+	stats->segs_retrans = cc->segs_retrans;
+	stats->fast_retrans = cc->fast_retrans;
+	stats->timeouts = cc->timeouts;
+	stats->dupacks_in = cc->dupacks_in;
+	tcp_conn_unlock(cconn->conn);
+
+	return EOK;
+}
+
+/** Set connection buffer size.
+ *
+ * Handle client request to set connection buffer size (with parameters
+ * unmarshalled).
+ *
+ * @param client   TCP client
+ * @param conn_id  Connection ID
+ * @param snd_size Send buffer size or zero to keep current size
+ * @param rcv_size Receive buffer size or zero to keep current size
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t tcp_conn_set_bufsize_impl(tcp_client_t *client,
+    sysarg_t conn_id, size_t snd_size, size_t rcv_size)
+{
+	tcp_cconn_t *cconn;
+	errno_t rc;
+
+	rc = tcp_cconn_get(client, conn_id, &cconn);
+	if (rc != EOK) {
+		assert(rc == ENOENT);
+		return ENOENT;
+	}
+
+	tcp_conn_lock(cconn->conn);
+	rc = tcp_conn_set_bufsize(cconn->conn, snd_size, rcv_size);
+	tcp_conn_unlock(cconn->conn);
+
+	return rc;
+}
+
 /** Reset connection.
  *
  * Handle client request to reset connection (with parameters unmarshalled).
@@ -916,6 +1084,73 @@ static void tcp_conn_push_srv(tcp_client_t *client, ipc_call_t *icall)
 	async_answer_0(icall, rc);
 }
 
+/** Get connection statistics.
+ *
+ * Handle client request to get connection statistics.
+ *
+ * @param client TCP client
+ * @param icall  Async request data
+ *
+ */
+static void tcp_conn_stats_srv(tcp_client_t *client, ipc_call_t *icall)
+{
+	ipc_call_t call;
+	sysarg_t conn_id;
+	tcp_conn_stats_t stats;
+	size_t size;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_stats_srv()");
+
+	conn_id = ipc_get_arg1(icall);
+
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(&call, EREFUSED);
+		async_answer_0(icall, EREFUSED);
+		return;
+	}
+
+	if (size != sizeof(tcp_conn_stats_t)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	rc = tcp_conn_stats_impl(client, conn_id, &stats);
+	if (rc != EOK) {
+		async_answer_0(&call, rc);
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	rc = async_data_read_finalize(&call, &stats, size);
+	async_answer_0(icall, rc);
+}
+
+/** Set connection buffer size.
+ *
+ * Handle client request to set connection buffer size.
+ *
+ * @param client TCP client
+ * @param icall  Async request data
+ *
+ */
+static void tcp_conn_set_bufsize_srv(tcp_client_t *client, ipc_call_t *icall)
+{
+	sysarg_t conn_id;
+	size_t snd_size;
+	size_t rcv_size;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_set_bufsize_srv()");
+
+	conn_id = ipc_get_arg1(icall);
+	snd_size = ipc_get_arg2(icall);
+	rcv_size = ipc_get_arg3(icall);
+	rc = tcp_conn_set_bufsize_impl(client, conn_id, snd_size, rcv_size);
+	async_answer_0(icall, rc);
+}
+
 /** Reset connection.
  *
  * Handle client request to reset connection.
@@ -1111,6 +1346,111 @@ static void tcp_conn_recv_wait_srv(tcp_client_t *client, ipc_call_t *icall)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_recv_wait_srv(): OK");
 }
 
+/** Share rings with the client.
+ *
+ * Handle client request to pass data of a connection in rings in shared
+ * memory instead of IPC messages.
+ *
+ * @param client TCP client
+ * @param icall  Async request data
+ *
+ */
+static void tcp_conn_rings_setup_srv(tcp_client_t *client, ipc_call_t *icall)
+{
+	ipc_call_t call;
+	tcp_cconn_t *cconn;
+	unsigned int flags;
+	size_t size;
+	void *rings;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_rings_setup_srv()");
+
+	if (!async_share_out_receive(&call, &size, &flags)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	rc = tcp_cconn_get(client, ipc_get_arg1(icall), &cconn);
+	if (rc != EOK) {
+		async_answer_0(&call, rc);
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	if (cconn->rings != NULL || size < sizeof(tcp_rings_t)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	rc = async_share_out_finalize(&call, &rings);
+	if (rc != EOK || rings == AS_MAP_FAILED) {
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	cconn->rings = (tcp_rings_t *) rings;
+
+	/* Move data that has been received before */
+	tcp_conn_lock(cconn->conn);
+	tcp_cconn_rx_fill(cconn);
+	tcp_conn_unlock(cconn->conn);
+
+	async_answer_0(icall, EOK);
+}
+
+/** Refill the rx ring.
+ *
+ * Handle client notification that it freed space in the full rx ring.
+ *
+ * @param client TCP client
+ * @param icall  Async request data
+ *
+ */
+static void tcp_conn_rx_kick_srv(tcp_client_t *client, ipc_call_t *icall)
+{
+	tcp_cconn_t *cconn;
+	errno_t rc;
+
+	rc = tcp_cconn_get(client, ipc_get_arg1(icall), &cconn);
+	if (rc == EOK && cconn->rings == NULL)
+		rc = EINVAL;
+
+	if (rc == EOK) {
+		tcp_conn_lock(cconn->conn);
+		tcp_cconn_rx_fill(cconn);
+		tcp_conn_unlock(cconn->conn);
+	}
+
+	async_answer_0(icall, rc);
+}
+
+/** Drain the tx ring.
+ *
+ * Handle client notification that it put data to the empty tx ring or
+ * request to wait until the full ring is drained.
+ *
+ * @param client TCP client
+ * @param icall  Async request data
+ *
+ */
+static void tcp_conn_tx_kick_srv(tcp_client_t *client, ipc_call_t *icall)
+{
+	tcp_cconn_t *cconn;
+	errno_t rc;
+
+	rc = tcp_cconn_get(client, ipc_get_arg1(icall), &cconn);
+	if (rc == EOK && cconn->rings == NULL)
+		rc = EINVAL;
+
+	if (rc == EOK)
+		rc = tcp_cconn_tx_drain(cconn);
+
+	async_answer_0(icall, rc);
+}
+
 /** Initialize TCP client structure.
  *
  * @param client TCP client
@@ -1140,6 +1480,7 @@ static void tcp_client_fini(tcp_client_t *client)
 		while (!list_empty(&client->cconn)) {
 			cconn = list_get_instance(list_first(&client->cconn),
 			    tcp_cconn_t, lclient);
+			(void) tcp_cconn_tx_drain(cconn);
 			tcp_uc_close(cconn->conn);
 			tcp_uc_delete(cconn->conn);
 			tcp_cconn_destroy(cconn);
@@ -1223,6 +1564,21 @@ static void tcp_client_conn(ipc_call_t *icall, void *arg)
 		case TCP_CONN_RECV_WAIT:
 			tcp_conn_recv_wait_srv(&client, &call);
 			break;
+		case TCP_CONN_STATS:
+			tcp_conn_stats_srv(&client, &call);
+			break;
+		case TCP_CONN_SET_BUFSIZE:
+			tcp_conn_set_bufsize_srv(&client, &call);
+			break;
+		case TCP_CONN_RINGS_SETUP:
+			tcp_conn_rings_setup_srv(&client, &call);
+			break;
+		case TCP_CONN_RX_KICK:
+			tcp_conn_rx_kick_srv(&client, &call);
+			break;
+		case TCP_CONN_TX_KICK:
+			tcp_conn_tx_kick_srv(&client, &call);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 			break;
@@ -109,9 +109,24 @@ enum opt_kind {
 	/** No-operation */
 	OPT_NOP			= 1,
 	/** Maximum segment size */
-	OPT_MAX_SEG_SIZE	= 2
+	OPT_MAX_SEG_SIZE	= 2,
+	/** Window scale (RFC 7323) */
+	OPT_WINDOW_SCALE	= 3,
+	/** Timestamps (RFC 7323) */
+	OPT_TIMESTAMP		= 8
 };
 
+/** Option lengths */
+enum opt_length {
+	/** Window scale option length */
+	OPT_WINDOW_SCALE_LEN	= 3,
+	/** Timestamps option length */
+	OPT_TIMESTAMP_LEN	= 10
+};
+
+/** Maximum window scale shift count (RFC 7323 section 2.3) */
+#define TCP_WSCALE_MAX 14
+
 #endif
 
 /** @}
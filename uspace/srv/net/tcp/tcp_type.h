@@ -43,8 +43,10 @@
 #include <refcount.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 #include <inet/addr.h>
 #include <inet/endpoint.h>
+#include <ipc/tcp.h>
 
 struct tcp_conn;
 
@@ -169,6 +171,17 @@ typedef struct {
 	/** Segment urgent pointer */
 	uint32_t up;
 
+	/** Window scale option present */
+	bool ws_present;
+	/** Window scale shift count */
+	uint8_t ws_shift;
+	/** Timestamps option present */
+	bool ts_present;
+	/** Timestamp value */
+	uint32_t ts_val;
+	/** Timestamp echo reply */
+	uint32_t ts_ecr;
+
 	/** Segment data, may be moved when trimming segment */
 	void *data;
 	/** Segment data, original pointer used to free data */
@@ -177,7 +190,6 @@ typedef struct {
 
 /** Receive queue entry */
 typedef struct {
-	link_t link;
 	inet_ep2_t epp;
 	tcp_segment_t *seg;
 } tcp_rqueue_entry_t;
@@ -227,6 +239,53 @@ typedef struct {
 	tcp_tqueue_cb_t *cb;
 } tcp_tqueue_t;
 
+/** Congestion control and round-trip time estimation state.
+ *
+ * Slow start and congestion avoidance follow RFC 5681, fast retransmit and
+ * fast recovery follow NewReno (RFC 6582), retransmission timeout is
+ * computed according to RFC 6298.
+ */
+typedef struct {
+	/** Congestion window */
+	uint32_t cwnd;
+	/** Slow start threshold */
+	uint32_t ssthresh;
+	/** Bytes acknowledged since last congestion window increase */
+	uint32_t bytes_acked;
+	/** Number of consecutive duplicate ACKs */
+	unsigned dupacks;
+	/** In fast recovery */
+	bool in_recovery;
+	/** SND.NXT at the time fast recovery was entered */
+	uint32_t recover;
+
+	/** A segment is being timed */
+	bool rtt_timing;
+	/** Acknowledgement number which completes the timed segment */
+	uint32_t rtt_seq;
+	/** When the timed segment was sent */
+	struct timespec rtt_start;
+	/** @c true once the first RTT measurement has been made */
+	bool rtt_valid;
+	/** Smoothed round-trip time */
+	usec_t srtt;
+	/** Round-trip time variation */
+	usec_t rttvar;
+	/** Retransmission timeout */
+	usec_t rto;
+
+	/** Number of segments transmitted */
+	uint64_t segs_out;
+	/** Number of segments retransmitted */
+	uint64_t segs_retrans;
+	/** Number of fast retransmits */
+	uint64_t fast_retrans;
+	/** Number of retransmission timeouts */
+	uint64_t timeouts;
+	/** Number of duplicate ACKs received */
+	uint64_t dupacks_in;
+} tcp_cc_t;
+
 /** Connection */
 struct tcp_conn {
 	char *name;
@@ -267,6 +326,8 @@ struct tcp_conn {
 
 	/** Retransmission queue */
 	tcp_tqueue_t retransmit;
+	/** Congestion control state */
+	tcp_cc_t cc;
 
 	/** Time-Wait timeout timer */
 	fibril_timer_t *tw_timer;
@@ -281,6 +342,12 @@ struct tcp_conn {
 	bool rcv_buf_fin;
 	/** Receive buffer CV. Broadcast when new data is inserted */
 	fibril_condvar_t rcv_buf_cv;
+	/** Receive buffer size is adjusted automatically */
+	bool rcv_buf_autotune;
+	/** Bytes removed from receive buffer since @c rcv_buf_at */
+	size_t rcv_buf_copied;
+	/** Start of current receive buffer auto-tuning period */
+	struct timespec rcv_buf_at;
 
 	/** Send buffer */
 	uint8_t *snd_buf;
@@ -316,6 +383,17 @@ struct tcp_conn {
 	uint32_t rcv_up;
 	/** Initial receive sequence number */
 	uint32_t irs;
+
+	/** Window scale option offered or agreed */
+	bool ws_ok;
+	/** Shift count applied to windows received from peer */
+	uint8_t snd_wscale;
+	/** Shift count applied to windows sent to peer */
+	uint8_t rcv_wscale;
+	/** Timestamps option offered or agreed */
+	bool ts_ok;
+	/** Timestamp to echo to peer (TS.Recent) */
+	uint32_t ts_recent;
 };
 
 /** Continuation of processing.
@@ -353,6 +431,8 @@ typedef struct tcp_cconn {
 	/** Client */
 	struct tcp_client *client;
 	link_t lclient;
+	/** Rings shared with the client or @c NULL if data is passed in IPC */
+	tcp_rings_t *rings;
 } tcp_cconn_t;
 
 /** TCP client listener */
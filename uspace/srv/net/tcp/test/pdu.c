@@ -35,6 +35,7 @@
 #include "main.h"
 #include "../pdu.h"
 #include "../segment.h"
+#include "../std.h"
 
 PCUT_INIT;
 
@@ -108,4 +109,48 @@ PCUT_TEST(encdec_data)
 	free(data);
 }
 
+/** Test encode/decode round trip for PDU with options */
+PCUT_TEST(encdec_opts)
+{
+	tcp_segment_t *seg, *dseg;
+	tcp_pdu_t *pdu;
+	inet_ep2_t epp, depp;
+	errno_t rc;
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 1, 2, 3, 4);
+	inet_addr(&epp.remote.addr, 5, 6, 7, 8);
+
+	seg = tcp_segment_make_ctrl(CTL_SYN);
+	PCUT_ASSERT_NOT_NULL(seg);
+
+	seg->seq = 20;
+	seg->ack = 19;
+	seg->wnd = 18;
+	seg->up = 17;
+	seg->ws_present = true;
+	seg->ws_shift = 7;
+	seg->ts_present = true;
+	seg->ts_val = 0x01020304;
+	seg->ts_ecr = 0xa0b0c0d0;
+
+	rc = tcp_pdu_encode(&epp, seg, &pdu);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(sizeof(tcp_header_t) + 16, pdu->header_size);
+
+	rc = tcp_pdu_decode(pdu, &depp, &dseg);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	test_seg_same(seg, dseg);
+	PCUT_ASSERT_TRUE(dseg->ws_present);
+	PCUT_ASSERT_INT_EQUALS(7, dseg->ws_shift);
+	PCUT_ASSERT_TRUE(dseg->ts_present);
+	PCUT_ASSERT_INT_EQUALS(0x01020304, dseg->ts_val);
+	PCUT_ASSERT_INT_EQUALS(0xa0b0c0d0, dseg->ts_ecr);
+
+	tcp_segment_delete(dseg);
+	tcp_pdu_delete(pdu);
+	tcp_segment_delete(seg);
+}
+
 PCUT_EXPORT(pdu);
@@ -26,7 +26,6 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <adt/prodcons.h>
 #include <inet/endpoint.h>
 #include <io/log.h>
 #include <pcut/pcut.h>
@@ -50,9 +49,11 @@ static tcp_rqueue_cb_t rcb = {
 
 static int seg_cnt;
 static tcp_segment_t *recv_seg[test_seg_max];
+static uint16_t recv_port[test_seg_max];
 
 static void test_seg_received(inet_ep2_t *epp, tcp_segment_t *seg)
 {
+	recv_port[seg_cnt] = epp->remote.port;
 	recv_seg[seg_cnt++] = seg;
 }
 
@@ -126,4 +127,47 @@ PCUT_TEST(multiple_segments)
 
 }
 
+/** Test segments of several connections keep their order per connection */
+PCUT_TEST(multiple_conns)
+{
+	tcp_segment_t *seg[test_seg_max];
+	inet_ep2_t epp;
+	int last[2];
+	int i, j;
+
+	tcp_rqueue_init(&rcb);
+	seg_cnt = 0;
+
+	tcp_rqueue_fibril_start();
+
+	for (i = 0; i < test_seg_max; i++) {
+		inet_ep2_init(&epp);
+		epp.remote.port = 1 + i % 2;
+		seg[i] = tcp_segment_make_ctrl(CTL_ACK);
+		PCUT_ASSERT_NOT_NULL(seg[i]);
+		tcp_rqueue_insert_seg(&epp, seg[i]);
+	}
+
+	tcp_rqueue_fini();
+
+	PCUT_ASSERT_INT_EQUALS(test_seg_max, seg_cnt);
+
+	last[0] = last[1] = -1;
+	for (i = 0; i < test_seg_max; i++) {
+		/* Find the segment among the ones inserted */
+		for (j = 0; j < test_seg_max; j++) {
+			if (seg[j] == recv_seg[i])
+				break;
+		}
+
+		PCUT_ASSERT_TRUE(j < test_seg_max);
+		PCUT_ASSERT_INT_EQUALS(1 + j % 2, recv_port[i]);
+		PCUT_ASSERT_TRUE(j > last[j % 2]);
+		last[j % 2] = j;
+	}
+
+	for (i = 0; i < test_seg_max; i++)
+		tcp_segment_delete(seg[i]);
+}
+
 PCUT_EXPORT(rqueue);
@@ -257,6 +257,105 @@ PCUT_TEST(ack_received)
 	tcp_conn_delete(conn);
 }
 
+/** Test sending data limited by congestion window */
+PCUT_TEST(new_data_cwnd)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	int i;
+
+	/* XXX tqueue can only be created via tcp_conn_new */
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->cstate = st_established;
+	conn->snd_una = 10;
+	conn->snd_nxt = 10;
+	conn->snd_wnd = 65535;
+	conn->cc.cwnd = 2000;
+	conn->snd_buf_used = 4000;
+	conn->snd_buf_fin = false;
+
+	/* Redirect segment transmission */
+	conn->retransmit.cb = &tqueue_test_cb;
+	seg_cnt = 0;
+
+	tcp_conn_lock(conn);
+	tcp_tqueue_new_data(conn);
+
+	/* One full-sized segment and the rest of the congestion window */
+	PCUT_ASSERT_EQUALS(2010, conn->snd_nxt);
+	PCUT_ASSERT_EQUALS(2000, conn->snd_buf_used);
+	PCUT_ASSERT_INT_EQUALS(2, list_count(&conn->retransmit.list));
+
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+	tcp_conn_delete(conn);
+
+	PCUT_ASSERT_EQUALS(2, seg_cnt);
+	PCUT_ASSERT_EQUALS(10, trans_seg[0]->seq);
+	PCUT_ASSERT_EQUALS(1460, trans_seg[0]->len);
+	PCUT_ASSERT_EQUALS(1470, trans_seg[1]->seq);
+	PCUT_ASSERT_EQUALS(540, trans_seg[1]->len);
+	for (i = 0; i < seg_cnt; i++)
+		tcp_segment_delete(trans_seg[i]);
+}
+
+/** Test fast retransmit after three duplicate ACKs */
+PCUT_TEST(fast_retransmit)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	int i;
+
+	/* XXX tqueue can only be created via tcp_conn_new */
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->cstate = st_established;
+	conn->snd_una = 10;
+	conn->snd_nxt = 10;
+	conn->snd_wnd = 65535;
+	conn->snd_buf_used = 3000;
+	conn->snd_buf_fin = false;
+
+	/* Redirect segment transmission */
+	conn->retransmit.cb = &tqueue_test_cb;
+	seg_cnt = 0;
+
+	tcp_conn_lock(conn);
+	tcp_tqueue_new_data(conn);
+	PCUT_ASSERT_EQUALS(3, seg_cnt);
+
+	tcp_tqueue_dup_ack(conn);
+	tcp_tqueue_dup_ack(conn);
+	PCUT_ASSERT_EQUALS(3, seg_cnt);
+	PCUT_ASSERT_FALSE(conn->cc.in_recovery);
+
+	/* Third duplicate ACK retransmits the first segment */
+	tcp_tqueue_dup_ack(conn);
+	PCUT_ASSERT_EQUALS(4, seg_cnt);
+	PCUT_ASSERT_EQUALS(10, trans_seg[3]->seq);
+	PCUT_ASSERT_TRUE(conn->cc.in_recovery);
+	PCUT_ASSERT_EQUALS(2 * 1460, conn->cc.ssthresh);
+
+	/* Full acknowledgement exits fast recovery */
+	conn->snd_una = conn->snd_nxt;
+	tcp_tqueue_ack_received(conn);
+	PCUT_ASSERT_FALSE(conn->cc.in_recovery);
+	PCUT_ASSERT_EQUALS(conn->cc.ssthresh, conn->cc.cwnd);
+	PCUT_ASSERT_TRUE(list_empty(&conn->retransmit.list));
+
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+	tcp_conn_delete(conn);
+
+	for (i = 0; i < seg_cnt; i++)
+		tcp_segment_delete(trans_seg[i]);
+}
+
 static void tqueue_test_transmit_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 {
 	trans_seg[seg_cnt++] = tcp_segment_dup(seg);
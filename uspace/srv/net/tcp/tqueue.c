@@ -42,6 +42,7 @@
 #include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "conn.h"
 #include "inet.h"
@@ -49,10 +50,28 @@
 #include "rqueue.h"
 #include "segment.h"
 #include "seq_no.h"
+#include "std.h"
 #include "tqueue.h"
 #include "tcp_type.h"
 
-#define RETRANSMIT_TIMEOUT	(2*1000*1000)
+/*
+ * Sender maximum segment size. No MSS option is exchanged, so assume
+ * an Ethernet-sized path.
+ */
+#define TCP_SMSS		1460
+
+/** Size of timestamps option including padding */
+#define TCP_TS_OPT_SIZE		(2 + OPT_TIMESTAMP_LEN)
+
+/** Initial retransmission timeout */
+#define TCP_RTO_INIT		SEC2USEC(1)
+/** Lower bound of retransmission timeout */
+#define TCP_RTO_MIN		SEC2USEC(1)
+/** Upper bound of retransmission timeout */
+#define TCP_RTO_MAX		SEC2USEC(60)
+
+/** Number of duplicate ACKs that trigger fast retransmit */
+#define TCP_DUPACK_THRESH	3
 
 static void retransmit_timeout_func(void *);
 static void tcp_tqueue_timer_set(tcp_conn_t *);
@@ -73,9 +92,34 @@ errno_t tcp_tqueue_init(tcp_tqueue_t *tqueue, tcp_conn_t *conn,
 
 	list_initialize(&tqueue->list);
 
+	/* Initial window according to RFC 5681 section 3.1 */
+	conn->cc.cwnd = 3 * TCP_SMSS;
+	conn->cc.ssthresh = UINT32_MAX;
+	conn->cc.rto = TCP_RTO_INIT;
+
 	return EOK;
 }
 
+/** Determine if sequence number @a a is greater than or equal to @a b. */
+static bool tcp_tqueue_seq_ge(uint32_t a, uint32_t b)
+{
+	return ((a - b) & (0x1 << 31)) == 0;
+}
+
+/** Number of bytes in flight */
+static uint32_t tcp_tqueue_flight_size(tcp_conn_t *conn)
+{
+	return conn->snd_nxt - conn->snd_una;
+}
+
+/** Reduce slow start threshold after loss was detected. */
+static void tcp_tqueue_cc_loss(tcp_conn_t *conn)
+{
+	conn->cc.ssthresh = max(tcp_tqueue_flight_size(conn) / 2,
+	    2 * TCP_SMSS);
+	conn->cc.bytes_acked = 0;
+}
+
 void tcp_tqueue_clear(tcp_tqueue_t *tqueue)
 {
 	tcp_tqueue_timer_clear(tqueue->conn);
@@ -149,6 +193,16 @@ static void tcp_tqueue_seg(tcp_conn_t *conn, tcp_segment_t *seg)
 
 		list_append(&tqe->link, &conn->retransmit.list);
 
+		/*
+		 * Time one segment at a time, unless RTT is measured
+		 * using timestamps.
+		 */
+		if (!conn->cc.rtt_timing && !conn->ts_ok) {
+			conn->cc.rtt_timing = true;
+			conn->cc.rtt_seq = conn->snd_nxt + seg->len;
+			getuptime(&conn->cc.rtt_start);
+		}
+
 		/* Set retransmission timer */
 		tcp_tqueue_timer_set(conn);
 	}
@@ -173,6 +227,9 @@ static void tcp_prepare_transmit_segment(tcp_conn_t *conn, tcp_segment_t *seg)
 }
 
 /** Transmit data from the send buffer.
+ *
+ * Data is sent in segments of at most SMSS bytes, as long as both
+ * the send window and the congestion window permit.
  *
  * @param conn	Connection
  */
@@ -182,6 +239,9 @@ void tcp_tqueue_new_data(tcp_conn_t *conn)
 	size_t xfer_seqlen;
 	size_t snd_buf_seqlen;
 	size_t data_size;
+	size_t max_data;
+	uint32_t flight;
+	uint32_t wnd;
 	tcp_control_t ctrl;
 	bool send_fin;
 
@@ -189,52 +249,170 @@ void tcp_tqueue_new_data(tcp_conn_t *conn)
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_tqueue_new_data()", conn->name);
 
-	/* Number of free sequence numbers in send window */
-	avail_wnd = (conn->snd_una + conn->snd_wnd) - conn->snd_nxt;
-	snd_buf_seqlen = conn->snd_buf_used + (conn->snd_buf_fin ? 1 : 0);
+	/* Leave room for the timestamps option */
+	max_data = TCP_SMSS - (conn->ts_ok ? TCP_TS_OPT_SIZE : 0);
 
-	xfer_seqlen = min(snd_buf_seqlen, avail_wnd);
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: snd_buf_seqlen = %zu, SND.WND = %" PRIu32 ", "
-	    "xfer_seqlen = %zu", conn->name, snd_buf_seqlen, conn->snd_wnd,
-	    xfer_seqlen);
+	while (true) {
+		/* Number of free sequence numbers in send window */
+		wnd = min(conn->snd_wnd, conn->cc.cwnd);
+		flight = tcp_tqueue_flight_size(conn);
+		avail_wnd = flight < wnd ? wnd - flight : 0;
+		snd_buf_seqlen = conn->snd_buf_used + (conn->snd_buf_fin ? 1 : 0);
 
-	if (xfer_seqlen == 0)
-		return;
+		xfer_seqlen = min(snd_buf_seqlen, avail_wnd);
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: snd_buf_seqlen = %zu, "
+		    "SND.WND = %" PRIu32 ", cwnd = %" PRIu32 ", "
+		    "xfer_seqlen = %zu", conn->name, snd_buf_seqlen,
+		    conn->snd_wnd, conn->cc.cwnd, xfer_seqlen);
+
+		if (xfer_seqlen == 0)
+			return;
+
+		/* XXX Do not always send immediately */
+
+		send_fin = conn->snd_buf_fin && xfer_seqlen == snd_buf_seqlen &&
+		    conn->snd_buf_used <= max_data;
+		data_size = min(xfer_seqlen - (send_fin ? 1 : 0), max_data);
+
+		if (send_fin) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Sending out FIN.",
+			    conn->name);
+			/* We are sending out FIN */
+			ctrl = CTL_FIN;
+		} else {
+			ctrl = 0;
+		}
+
+		seg = tcp_segment_make_data(ctrl, conn->snd_buf, data_size);
+		if (seg == NULL) {
+			log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failure.");
+			return;
+		}
 
-	/* XXX Do not always send immediately */
+		/* Remove data from send buffer */
+		memmove(conn->snd_buf, conn->snd_buf + data_size,
+		    conn->snd_buf_used - data_size);
+		conn->snd_buf_used -= data_size;
 
-	send_fin = conn->snd_buf_fin && xfer_seqlen == snd_buf_seqlen;
-	data_size = xfer_seqlen - (send_fin ? 1 : 0);
+		if (send_fin)
+			conn->snd_buf_fin = false;
 
-	if (send_fin) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Sending out FIN.", conn->name);
-		/* We are sending out FIN */
-		ctrl = CTL_FIN;
+		fibril_condvar_broadcast(&conn->snd_buf_cv);
+
+		if (send_fin)
+			tcp_conn_fin_sent(conn);
+
+		tcp_tqueue_seg(conn, seg);
+		tcp_segment_delete(seg);
+	}
+}
+
+/** Update round-trip time estimate with a new measurement.
+ *
+ * @param conn	Connection
+ * @param r	Measured round-trip time
+ */
+void tcp_tqueue_rtt_sample(tcp_conn_t *conn, usec_t r)
+{
+	tcp_cc_t *cc = &conn->cc;
+	usec_t delta;
+
+	if (!cc->rtt_valid) {
+		cc->srtt = r;
+		cc->rttvar = r / 2;
+		cc->rtt_valid = true;
 	} else {
-		ctrl = 0;
+		delta = cc->srtt > r ? cc->srtt - r : r - cc->srtt;
+		cc->rttvar = (3 * cc->rttvar + delta) / 4;
+		cc->srtt = (7 * cc->srtt + r) / 8;
 	}
 
-	seg = tcp_segment_make_data(ctrl, conn->snd_buf, data_size);
-	if (seg == NULL) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failure.");
+	cc->rto = cc->srtt + max(4 * cc->rttvar, (usec_t) 1);
+	if (cc->rto < TCP_RTO_MIN)
+		cc->rto = TCP_RTO_MIN;
+	if (cc->rto > TCP_RTO_MAX)
+		cc->rto = TCP_RTO_MAX;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: RTT=%lld SRTT=%lld RTTVAR=%lld "
+	    "RTO=%lld", conn->name, (long long) r, (long long) cc->srtt,
+	    (long long) cc->rttvar, (long long) cc->rto);
+}
+
+/** Retransmit segment from the retransmission queue.
+ *
+ * @param conn	Connection
+ * @param tqe	Retransmission queue entry
+ */
+static void tcp_tqueue_retransmit(tcp_conn_t *conn, tcp_tqueue_entry_t *tqe)
+{
+	tcp_segment_t *rt_seg;
+
+	rt_seg = tcp_segment_dup(tqe->seg);
+	if (rt_seg == NULL) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failed.");
+		/* XXX Handle properly */
 		return;
 	}
 
-	/* Remove data from send buffer */
-	memmove(conn->snd_buf, conn->snd_buf + data_size,
-	    conn->snd_buf_used - data_size);
-	conn->snd_buf_used -= data_size;
+	/* Karn's algorithm: do not time retransmitted segments */
+	conn->cc.rtt_timing = false;
+	++conn->cc.segs_retrans;
 
-	if (send_fin)
-		conn->snd_buf_fin = false;
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmitting segment", conn->name);
+	tcp_conn_transmit_segment(conn, rt_seg);
+	tcp_segment_delete(rt_seg);
+}
 
-	fibril_condvar_broadcast(&conn->snd_buf_cv);
+/** Update congestion window after new data was acknowledged.
+ *
+ * @param conn	Connection
+ * @param acked	Number of newly acknowledged bytes
+ */
+static void tcp_tqueue_cc_ack(tcp_conn_t *conn, uint32_t acked)
+{
+	tcp_cc_t *cc = &conn->cc;
+	link_t *link;
 
-	if (send_fin)
-		tcp_conn_fin_sent(conn);
+	cc->dupacks = 0;
 
-	tcp_tqueue_seg(conn, seg);
-	tcp_segment_delete(seg);
+	if (cc->in_recovery) {
+		if (tcp_tqueue_seq_ge(conn->snd_una, cc->recover)) {
+			/* Full acknowledgement, exit fast recovery */
+			cc->in_recovery = false;
+			cc->cwnd = cc->ssthresh;
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Exit fast recovery, "
+			    "cwnd=%" PRIu32, conn->name, cc->cwnd);
+			return;
+		}
+
+		/*
+		 * Partial acknowledgement. Retransmit first unacknowledged
+		 * segment and deflate the congestion window by the amount
+		 * of newly acknowledged data (RFC 6582 section 3.2).
+		 */
+		link = list_first(&conn->retransmit.list);
+		if (link != NULL) {
+			tcp_tqueue_retransmit(conn, list_get_instance(link,
+			    tcp_tqueue_entry_t, link));
+		}
+
+		cc->cwnd -= min(acked, cc->cwnd);
+		if (acked >= TCP_SMSS)
+			cc->cwnd += TCP_SMSS;
+		return;
+	}
+
+	if (cc->cwnd < cc->ssthresh) {
+		/* Slow start */
+		cc->cwnd += min(acked, (uint32_t) TCP_SMSS);
+	} else {
+		/* Congestion avoidance */
+		cc->bytes_acked += acked;
+		if (cc->bytes_acked >= cc->cwnd) {
+			cc->bytes_acked -= cc->cwnd;
+			cc->cwnd += TCP_SMSS;
+		}
+	}
 }
 
 /** Remove ACKed segments from retransmission queue and possibly transmit
@@ -245,10 +423,20 @@ void tcp_tqueue_new_data(tcp_conn_t *conn)
 void tcp_tqueue_ack_received(tcp_conn_t *conn)
 {
 	link_t *cur, *next;
+	struct timespec now;
+	uint32_t acked = 0;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_tqueue_ack_received(%p)", conn->name,
 	    conn);
 
+	if (conn->cc.rtt_timing &&
+	    tcp_tqueue_seq_ge(conn->snd_una, conn->cc.rtt_seq)) {
+		conn->cc.rtt_timing = false;
+		getuptime(&now);
+		tcp_tqueue_rtt_sample(conn,
+		    NSEC2USEC(ts_sub_diff(&now, &conn->cc.rtt_start)));
+	}
+
 	cur = conn->retransmit.list.head.next;
 
 	while (cur != &conn->retransmit.list.head) {
@@ -270,6 +458,10 @@ void tcp_tqueue_ack_received(tcp_conn_t *conn)
 				conn->fin_is_acked = true;
 			}
 
+			/* SYN does not count towards congestion window growth */
+			if ((tqe->seg->ctrl & CTL_SYN) == 0)
+				acked += tqe->seg->len;
+
 			tcp_segment_delete(tqe->seg);
 			free(tqe);
 
@@ -280,6 +472,9 @@ void tcp_tqueue_ack_received(tcp_conn_t *conn)
 		cur = next;
 	}
 
+	if (acked > 0)
+		tcp_tqueue_cc_ack(conn, acked);
+
 	/* Clear retransmission timer if the queue is empty. */
 	if (list_empty(&conn->retransmit.list))
 		tcp_tqueue_timer_clear(conn);
@@ -288,18 +483,76 @@ void tcp_tqueue_ack_received(tcp_conn_t *conn)
 	tcp_tqueue_new_data(conn);
 }
 
+/** Process duplicate ACK.
+ *
+ * The third duplicate ACK in a row triggers fast retransmit and enters
+ * fast recovery. Each further duplicate ACK inflates the congestion window
+ * by one segment, possibly allowing more new data to be sent.
+ *
+ * @param conn	Connection
+ */
+void tcp_tqueue_dup_ack(tcp_conn_t *conn)
+{
+	tcp_cc_t *cc = &conn->cc;
+	link_t *link;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_tqueue_dup_ack(%p)", conn->name,
+	    conn);
+
+	link = list_first(&conn->retransmit.list);
+	if (link == NULL) {
+		/* No outstanding data, not a duplicate ACK */
+		return;
+	}
+
+	++cc->dupacks_in;
+	++cc->dupacks;
+
+	if (cc->in_recovery) {
+		cc->cwnd += TCP_SMSS;
+	} else if (cc->dupacks == TCP_DUPACK_THRESH) {
+		tcp_tqueue_cc_loss(conn);
+		cc->recover = conn->snd_nxt;
+		cc->in_recovery = true;
+		cc->cwnd = cc->ssthresh + TCP_DUPACK_THRESH * TCP_SMSS;
+		++cc->fast_retrans;
+
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Fast retransmit, "
+		    "ssthresh=%" PRIu32, conn->name, cc->ssthresh);
+		tcp_tqueue_retransmit(conn, list_get_instance(link,
+		    tcp_tqueue_entry_t, link));
+	}
+
+	/* Possibly transmit more data */
+	tcp_tqueue_new_data(conn);
+}
+
 static void tcp_conn_transmit_segment(tcp_conn_t *conn, tcp_segment_t *seg)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_conn_transmit_segment(%p, %p)",
 	    conn->name, conn, seg);
 
-	seg->wnd = conn->rcv_wnd;
+	/* Window in SYN segments is never scaled */
+	if ((seg->ctrl & CTL_SYN) != 0)
+		seg->wnd = min(conn->rcv_wnd, (uint32_t) UINT16_MAX);
+	else
+		seg->wnd = min(conn->rcv_wnd >> conn->rcv_wscale,
+		    (uint32_t) UINT16_MAX);
 
 	if ((seg->ctrl & CTL_ACK) != 0)
 		seg->ack = conn->rcv_nxt;
 	else
 		seg->ack = 0;
 
+	seg->ws_present = (seg->ctrl & CTL_SYN) != 0 && conn->ws_ok;
+	seg->ws_shift = conn->rcv_wscale;
+
+	seg->ts_present = conn->ts_ok && (seg->ctrl & CTL_RST) == 0;
+	if (seg->ts_present) {
+		seg->ts_val = tcp_conn_ts_now();
+		seg->ts_ecr = (seg->ctrl & CTL_ACK) != 0 ? conn->ts_recent : 0;
+	}
+
 	tcp_tqueue_send_immed(conn, seg);
 }
 
@@ -314,6 +567,7 @@ void tcp_tqueue_send_immed(tcp_conn_t *conn, tcp_segment_t *seg)
 
 	tcp_segment_dump(seg);
 
+	++conn->cc.segs_out;
 	conn->retransmit.cb->transmit_seg(&conn->ident, seg);
 }
 
@@ -321,7 +575,6 @@ static void retransmit_timeout_func(void *arg)
 {
 	tcp_conn_t *conn = (tcp_conn_t *) arg;
 	tcp_tqueue_entry_t *tqe;
-	tcp_segment_t *rt_seg;
 	link_t *link;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmit_timeout_func(%p)", conn->name, conn);
@@ -345,20 +598,21 @@ static void retransmit_timeout_func(void *arg)
 
 	tqe = list_get_instance(link, tcp_tqueue_entry_t, link);
 
-	rt_seg = tcp_segment_dup(tqe->seg);
-	if (rt_seg == NULL) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failed.");
-		tcp_conn_unlock(conn);
-		tcp_conn_delref(conn);
-		/* XXX Handle properly */
-		return;
-	}
+	/*
+	 * Collapse congestion window to the loss window and back off
+	 * the retransmission timer (RFC 5681 section 3.1, RFC 6298 section 5).
+	 */
+	++conn->cc.timeouts;
+	tcp_tqueue_cc_loss(conn);
+	conn->cc.cwnd = TCP_SMSS;
+	conn->cc.dupacks = 0;
+	conn->cc.in_recovery = false;
+	conn->cc.rto = min(2 * conn->cc.rto, TCP_RTO_MAX);
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmitting segment", conn->name);
-	tcp_conn_transmit_segment(tqe->conn, rt_seg);
+	tcp_tqueue_retransmit(conn, tqe);
 
 	/* Reset retransmission timer */
-	fibril_timer_set_locked(conn->retransmit.timer, RETRANSMIT_TIMEOUT,
+	fibril_timer_set_locked(conn->retransmit.timer, conn->cc.rto,
 	    retransmit_timeout_func, (void *) conn);
 
 	tcp_conn_unlock(conn);
@@ -377,7 +631,7 @@ static void tcp_tqueue_timer_set(tcp_conn_t *conn)
 	tcp_tqueue_timer_clear(conn);
 
 	tcp_conn_addref(conn);
-	fibril_timer_set_locked(conn->retransmit.timer, RETRANSMIT_TIMEOUT,
+	fibril_timer_set_locked(conn->retransmit.timer, conn->cc.rto,
 	    retransmit_timeout_func, (void *) conn);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: tcp_tqueue_timer_set() end", conn->name);
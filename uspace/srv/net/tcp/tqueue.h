@@ -46,6 +46,8 @@ extern void tcp_tqueue_fini(tcp_tqueue_t *);
 extern void tcp_tqueue_ctrl_seg(tcp_conn_t *, tcp_control_t);
 extern void tcp_tqueue_new_data(tcp_conn_t *);
 extern void tcp_tqueue_ack_received(tcp_conn_t *);
+extern void tcp_tqueue_dup_ack(tcp_conn_t *);
+extern void tcp_tqueue_rtt_sample(tcp_conn_t *, usec_t);
 
 #endif
 
@@ -179,25 +179,36 @@ tcp_error_t tcp_uc_send(tcp_conn_t *conn, void *data, size_t size,
 /** RECEIVE user call */
 tcp_error_t tcp_uc_receive(tcp_conn_t *conn, void *buf, size_t size,
     size_t *rcvd, xflags_t *xflags)
+{
+	tcp_error_t trc;
+
+	tcp_conn_lock(conn);
+	trc = tcp_uc_receive_locked(conn, buf, size, rcvd, xflags);
+	tcp_conn_unlock(conn);
+
+	return trc;
+}
+
+/** RECEIVE user call with the connection already locked.
+ *
+ * For use from connection callbacks, which are called with the connection
+ * locked.
+ */
+tcp_error_t tcp_uc_receive_locked(tcp_conn_t *conn, void *buf, size_t size,
+    size_t *rcvd, xflags_t *xflags)
 {
 	size_t xfer_size;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_uc_receive()", conn->name);
 
-	tcp_conn_lock(conn);
+	assert(fibril_mutex_is_locked(&conn->lock));
 
-	if (conn->cstate == st_closed) {
-		tcp_conn_unlock(conn);
+	if (conn->cstate == st_closed)
 		return TCP_ENOTEXIST;
-	}
 
-	/* Wait for data to become available */
-	while (conn->rcv_buf_used == 0 && !conn->rcv_buf_fin && !conn->reset) {
-		tcp_conn_unlock(conn);
+	/* Do not wait for data to become available */
+	if (conn->rcv_buf_used == 0 && !conn->rcv_buf_fin && !conn->reset)
 		return TCP_EAGAIN;
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_uc_receive() - wait for data");
-		fibril_condvar_wait(&conn->rcv_buf_cv, &conn->lock);
-	}
 
 	if (conn->rcv_buf_used == 0) {
 		*rcvd = 0;
@@ -205,12 +216,10 @@ tcp_error_t tcp_uc_receive(tcp_conn_t *conn, void *buf, size_t size,
 
 		if (conn->rcv_buf_fin) {
 			/* End of data, peer closed connection */
-			tcp_conn_unlock(conn);
 			return TCP_ECLOSING;
 		} else {
 			/* Connection was reset */
 			assert(conn->reset);
-			tcp_conn_unlock(conn);
 			return TCP_ERESET;
 		}
 	}
@@ -226,6 +235,8 @@ tcp_error_t tcp_uc_receive(tcp_conn_t *conn, void *buf, size_t size,
 	conn->rcv_buf_used -= xfer_size;
 	conn->rcv_wnd += xfer_size;
 
+	tcp_conn_rcv_buf_autotune(conn, xfer_size);
+
 	/* TODO */
 	*xflags = 0;
 
@@ -235,8 +246,6 @@ tcp_error_t tcp_uc_receive(tcp_conn_t *conn, void *buf, size_t size,
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_uc_receive() - returning %zu bytes",
 	    conn->name, xfer_size);
 
-	tcp_conn_unlock(conn);
-
 	return TCP_EOK;
 }
 
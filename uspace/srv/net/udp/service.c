@@ -34,6 +34,7 @@
  * @file HelenOS service implementation
  */
 
+#include <align.h>
 #include <async.h>
 #include <errno.h>
 #include <inet/endpoint.h>
@@ -42,6 +43,7 @@
 #include <ipc/udp.h>
 #include <loc.h>
 #include <macros.h>
+#include <mem.h>
 #include <stdlib.h>
 
 #include "assoc.h"
@@ -90,9 +92,15 @@ static void udp_ev_data(udp_client_t *client)
 static void udp_recv_msg_cassoc(void *arg, inet_ep2_t *epp, udp_msg_t *msg)
 {
 	udp_cassoc_t *cassoc = (udp_cassoc_t *) arg;
-
-	udp_cassoc_queue_msg(cassoc, epp, msg);
-	udp_ev_data(cassoc->client);
+	bool was_empty;
+
+	/*
+	 * The client reads all queued messages after an event, so it only
+	 * needs one when the queue becomes non-empty.
+	 */
+	was_empty = list_empty(&cassoc->client->crcv_queue);
+	if (udp_cassoc_queue_msg(cassoc, epp, msg) == EOK && was_empty)
+		udp_ev_data(cassoc->client);
 }
 
 /** Create association.
@@ -414,6 +422,88 @@ static void udp_assoc_send_msg_srv(udp_client_t *client, ipc_call_t *icall)
 	free(data);
 }
 
+/** Send batch of messages via association.
+ *
+ * Handle client request to send a batch of messages. The messages are sent
+ * in order until the first one that fails.
+ *
+ * @param client UDP client
+ * @param icall  Async request data
+ *
+ */
+static void udp_assoc_send_msgs_srv(udp_client_t *client, ipc_call_t *icall)
+{
+	ipc_call_t call;
+	udp_smsg_hdr_t hdr;
+	sysarg_t assoc_id;
+	size_t count;
+	size_t size;
+	size_t nsent;
+	size_t off;
+	size_t padded;
+	uint8_t *buf;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_assoc_send_msgs_srv()");
+
+	assoc_id = ipc_get_arg1(icall);
+	count = ipc_get_arg2(icall);
+
+	if (!async_data_write_receive(&call, &size)) {
+		async_answer_0(&call, EREFUSED);
+		async_answer_0(icall, EREFUSED);
+		return;
+	}
+
+	if (size > MAX_MSG_SIZE) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	buf = malloc(size);
+	if (buf == NULL) {
+		async_answer_0(&call, ENOMEM);
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	rc = async_data_write_finalize(&call, buf, size);
+	if (rc != EOK) {
+		async_answer_0(icall, rc);
+		free(buf);
+		return;
+	}
+
+	off = 0;
+	rc = EOK;
+	for (nsent = 0; nsent < count; nsent++) {
+		if (size - off < sizeof(hdr)) {
+			rc = EINVAL;
+			break;
+		}
+
+		memcpy(&hdr, buf + off, sizeof(hdr));
+		off += sizeof(hdr);
+
+		if (hdr.size > size - off) {
+			rc = EINVAL;
+			break;
+		}
+
+		rc = udp_assoc_send_msg_impl(client, assoc_id, &hdr.dest,
+		    buf + off, hdr.size);
+		if (rc != EOK)
+			break;
+
+		padded = (size_t) ALIGN_UP(hdr.size, UDP_BATCH_ALIGN);
+		off += min(padded, size - off);
+	}
+
+	free(buf);
+	async_answer_1(icall, rc, nsent);
+}
+
 /** Get next received message.
  *
  * @param client UDP Client
@@ -558,6 +648,99 @@ static void udp_rmsg_discard_srv(udp_client_t *client, ipc_call_t *icall)
 	async_answer_0(icall, EOK);
 }
 
+/** Read batch of received messages.
+ *
+ * Handle client request to read as many received messages as fit in its
+ * buffer at once. The messages read are discarded.
+ *
+ * @param client UDP client
+ * @param icall  Async request data
+ *
+ */
+static void udp_rmsg_read_batch_srv(udp_client_t *client, ipc_call_t *icall)
+{
+	ipc_call_t call;
+	udp_crcv_queue_entry_t *enext;
+	udp_rmsg_hdr_t hdr;
+	link_t *link;
+	size_t count;
+	size_t size;
+	size_t need;
+	size_t off;
+	size_t padded;
+	uint8_t *buf;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_rmsg_read_batch_srv()");
+
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(&call, EREFUSED);
+		async_answer_0(icall, EREFUSED);
+		return;
+	}
+
+	enext = udp_rmsg_get_next(client);
+	if (enext == NULL) {
+		async_answer_0(&call, ENOENT);
+		async_answer_0(icall, ENOENT);
+		return;
+	}
+
+	if (sizeof(hdr) + enext->msg->data_size > size) {
+		/* Client needs to read this one using UDP_RMSG_READ */
+		async_answer_0(&call, EOVERFLOW);
+		async_answer_0(icall, EOVERFLOW);
+		return;
+	}
+
+	size = min(size, MAX_MSG_SIZE);
+	buf = malloc(size);
+	if (buf == NULL) {
+		async_answer_0(&call, ENOMEM);
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	off = 0;
+	count = 0;
+	while (enext != NULL) {
+		need = sizeof(hdr) + enext->msg->data_size;
+		if (need > size - off)
+			break;
+
+		memset(&hdr, 0, sizeof(hdr));
+		hdr.assoc_id = enext->cassoc->id;
+		hdr.remote_ep = enext->epp.remote;
+		hdr.size = enext->msg->data_size;
+		memcpy(buf + off, &hdr, sizeof(hdr));
+		memcpy(buf + off + sizeof(hdr), enext->msg->data, hdr.size);
+		padded = (size_t) ALIGN_UP(need, UDP_BATCH_ALIGN);
+		off += min(padded, size - off);
+		++count;
+
+		link = list_next(&enext->link, &client->crcv_queue);
+		enext = link != NULL ? list_get_instance(link,
+		    udp_crcv_queue_entry_t, link) : NULL;
+	}
+
+	rc = async_data_read_finalize(&call, buf, min(off, size));
+	free(buf);
+	if (rc != EOK) {
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	/* The messages have been delivered */
+	for (size_t i = 0; i < count; i++) {
+		enext = udp_rmsg_get_next(client);
+		list_remove(&enext->link);
+		udp_msg_delete(enext->msg);
+		free(enext);
+	}
+
+	async_answer_1(icall, EOK, count);
+}
+
 /** Handle UDP client connection.
  *
  * @param icall Connect call data
@@ -617,6 +800,12 @@ static void udp_client_conn(ipc_call_t *icall, void *arg)
 		case UDP_RMSG_DISCARD:
 			udp_rmsg_discard_srv(&client, &call);
 			break;
+		case UDP_ASSOC_SEND_MSGS:
+			udp_assoc_send_msgs_srv(&client, &call);
+			break;
+		case UDP_RMSG_READ_BATCH:
+			udp_rmsg_read_batch_srv(&client, &call);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 			break;
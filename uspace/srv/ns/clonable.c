@@ -31,6 +31,7 @@
  */
 
 #include <async.h>
+#include <ipc/ns.h>
 #include <ipc/services.h>
 #include <adt/list.h>
 #include <stdbool.h>
@@ -62,7 +63,7 @@ errno_t ns_clonable_init(void)
 /** Return true if @a service is clonable. */
 bool ns_service_is_clonable(service_t service, iface_t iface)
 {
-	return (service == SERVICE_LOADER) && (iface == INTERFACE_LOADER);
+	return service_is_clonable(service, iface);
 }
 
 /** Register clonable service.
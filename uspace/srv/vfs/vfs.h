@@ -145,6 +145,16 @@ typedef struct {
 
 	/** Append on write. */
 	bool append;
+
+	/** Read from the file system, bypassing the page cache. */
+	bool direct;
+
+	/** Position following the last read, to detect sequential reads. */
+	aoff64_t ra_next;
+	/** Number of pages to read ahead of sequential reads. */
+	size_t ra_window;
+	/** Index of the page following those already read ahead. */
+	uint64_t ra_end;
 } vfs_file_t;
 
 extern fibril_mutex_t nodes_mutex;
@@ -160,14 +170,13 @@ extern vfs_pair_t rootfs;	/**< Root file system. */
 
 /** Each instance of this type describes one path lookup in progress. */
 typedef struct {
-	link_t	plb_link;	/**< Active PLB entries list link. */
 	unsigned index;		/**< Index of the first character in PLB. */
 	size_t len;		/**< Number of characters in this PLB entry. */
+	size_t chunks;		/**< Number of PLB chunks held by this entry. */
 } plb_entry_t;
 
-extern fibril_mutex_t plb_mutex;/**< Mutex protecting plb and plb_entries. */
+extern fibril_mutex_t plb_mutex;/**< Mutex protecting allocation of PLB. */
 extern uint8_t *plb;		/**< Path Lookup Buffer */
-extern list_t plb_entries;	/**< List of active PLB entries. */
 
 /** Holding this rwlock prevents changes in file system namespace. */
 extern fibril_rwlock_t namespace_rwlock;
@@ -214,6 +223,8 @@ extern errno_t vfs_op_mtab_get(void);
 extern errno_t vfs_op_open(int fd, int flags);
 extern errno_t vfs_op_put(int fd);
 extern errno_t vfs_op_read(int fd, aoff64_t, size_t *out_bytes);
+extern errno_t vfs_op_readdir(int fd, aoff64_t *pos, void *buf, size_t size,
+    size_t *out_bytes);
 extern errno_t vfs_op_rename(int basefd, char *old, char *new);
 extern errno_t vfs_op_resize(int fd, int64_t size);
 extern errno_t vfs_op_stat(int fd);
@@ -235,6 +246,33 @@ typedef struct {
 } rdwr_io_chunk_t;
 
 extern errno_t vfs_rdwr_internal(int, aoff64_t, bool, rdwr_io_chunk_t *);
+extern errno_t vfs_rdwr_page_in(int, aoff64_t, ipc_call_t *);
+
+extern void vfs_plb_stats(vfs_server_stats_t *);
+
+extern bool vfs_namecache_init(void);
+extern bool vfs_namecache_find(vfs_triplet_t *, const char *, size_t,
+    vfs_lookup_res_t *, size_t *);
+extern unsigned vfs_namecache_generation(void);
+extern void vfs_namecache_insert(unsigned, vfs_triplet_t *, const char *,
+    size_t, vfs_lookup_res_t *, size_t);
+extern void vfs_namecache_purge(fs_handle_t, service_id_t);
+
+extern bool vfs_cache_init(void);
+extern bool vfs_cache_enabled(vfs_node_t *);
+extern void vfs_cache_access(vfs_file_t *, aoff64_t, size_t);
+extern void vfs_cache_stats(vfs_server_stats_t *);
+extern bool vfs_cache_cached(vfs_node_t *);
+extern errno_t vfs_cache_read(async_exch_t *, vfs_node_t *, aoff64_t,
+    size_t *);
+extern errno_t vfs_cache_write(async_exch_t *, vfs_node_t *, aoff64_t,
+    ipc_call_t *, size_t *);
+extern errno_t vfs_cache_page_in(async_exch_t *, vfs_node_t *, aoff64_t,
+    ipc_call_t *);
+extern void vfs_cache_resize(vfs_node_t *, aoff64_t);
+extern void vfs_cache_unlinked(vfs_triplet_t *, bool);
+extern void vfs_cache_node_freed(vfs_node_t *);
+extern void vfs_cache_unmounted(fs_handle_t, service_id_t);
 
 extern void vfs_connection(ipc_call_t *, void *);
 
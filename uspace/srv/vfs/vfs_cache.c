@@ -0,0 +1,1008 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup vfs
+ * @{
+ */
+
+/**
+ * @file	vfs_cache.c
+ * @brief	Page cache of file contents.
+ *
+ * The cache holds page-sized, page-aligned pieces of regular files of file
+ * systems which allow it. It serves both reads and page-in requests of the
+ * VFS pager. Each cached page is an address space area of its own, so that
+ * the pager can hand its frame out to the tasks mapping the file. All
+ * mappings of a file and the VFS thus share the same frames, and writes
+ * going through VFS update the cached pages in place, which keeps the
+ * mappings coherent for as long as the pages stay cached.
+ *
+ * Writes are written through to the file system, so there are never dirty
+ * pages. Pages are evicted using the clock algorithm once there are more of
+ * them than the limit, which is lowered when free physical memory runs low.
+ *
+ * Pages are only filled and updated with the node's contents rwlock held,
+ * reads holding it for reading and writes for writing.
+ *
+ * Sequential reads of an open file are detected and the pages following them
+ * are read ahead by a separate fibril. The read-ahead window doubles with
+ * each sequential read, up to CACHE_RA_MAX_PAGES, and is reset by a read from
+ * anywhere else.
+ */
+
+#include "vfs.h"
+#include <adt/hash.h>
+#include <adt/list.h>
+#include <adt/odict.h>
+#include <adt/ohash_table.h>
+#include <align.h>
+#include <as.h>
+#include <assert.h>
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <macros.h>
+#include <mem.h>
+#include <stats.h>
+#include <stdlib.h>
+
+/** Upper limit on the number of cached pages. */
+#define CACHE_MAX_PAGES  4096
+
+/** The limit is never lowered below this number of pages. */
+#define CACHE_MIN_PAGES  64
+
+/** Free memory is checked each time this many pages are filled. */
+#define CACHE_PRESSURE_PERIOD  64
+
+/** Maximum number of pages a single read can return. */
+#define CACHE_READ_MAX_PAGES  16
+
+/** Initial read-ahead window. */
+#define CACHE_RA_MIN_PAGES  4
+
+/** Maximum read-ahead window. */
+#define CACHE_RA_MAX_PAGES  32
+
+/** Data of a larger write is only accepted up to this size at once. */
+#define CACHE_WRITE_MAX  (CACHE_READ_MAX_PAGES * PAGE_SIZE)
+
+/** Cached pages of a file. */
+typedef struct {
+	/** Link in objects */
+	ht_link_t link;
+	vfs_triplet_t triplet;
+	/** Pages ordered by their index, cache_page_t */
+	odict_t pages;
+	/**
+	 * The file was unlinked while in use and may be destroyed once it
+	 * is no longer used. Its pages are not cached anymore.
+	 */
+	bool unlinked;
+} cache_obj_t;
+
+/** Cached page of a file. */
+typedef struct {
+	/** Link in cache_obj_t.pages */
+	odlink_t olink;
+	/** Link in clock_list */
+	link_t clock_link;
+	cache_obj_t *obj;
+	/** Index of the page in the file */
+	uint64_t idx;
+	/** Address space area holding the page */
+	uint8_t *data;
+	/** Number of valid bytes, the rest of the page is zero */
+	size_t valid;
+	/** Recently used, spared by the next pass of the clock */
+	bool referenced;
+	/** Read ahead and not used yet */
+	bool readahead;
+	/** Number of users preventing eviction */
+	unsigned pins;
+} cache_page_t;
+
+/** Protects all of the cache. */
+static FIBRIL_MUTEX_INITIALIZE(cache_lock);
+
+/** Objects of files with any cached pages, cache_obj_t. */
+static ohash_table_t objects;
+
+/** All cached pages in clock order, cache_page_t. */
+static LIST_INITIALIZE(clock_list);
+
+static size_t cache_pages;
+static size_t cache_limit = CACHE_MAX_PAGES;
+static unsigned cache_fills;
+
+/** Read-ahead statistics. */
+static size_t ra_pages;
+static size_t ra_hits;
+static size_t ra_wasted;
+
+static size_t objects_key_hash(const void *key)
+{
+	const vfs_triplet_t *tri = key;
+	size_t hash = hash_combine(tri->fs_handle, tri->index);
+	return hash_combine(hash, tri->service_id);
+}
+
+static size_t objects_hash(const ht_link_t *item)
+{
+	cache_obj_t *obj = hash_table_get_inst(item, cache_obj_t, link);
+	return objects_key_hash(&obj->triplet);
+}
+
+static bool objects_key_equal(const void *key, const ht_link_t *item)
+{
+	const vfs_triplet_t *tri = key;
+	cache_obj_t *obj = hash_table_get_inst(item, cache_obj_t, link);
+	return obj->triplet.fs_handle == tri->fs_handle &&
+	    obj->triplet.service_id == tri->service_id &&
+	    obj->triplet.index == tri->index;
+}
+
+static const hash_table_ops_t objects_ops = {
+	.hash = objects_hash,
+	.key_hash = objects_key_hash,
+	.key_equal = objects_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static void *pages_getkey(odlink_t *olink)
+{
+	return &odict_get_instance(olink, cache_page_t, olink)->idx;
+}
+
+static int pages_cmp(void *a, void *b)
+{
+	uint64_t ia = *(uint64_t *) a;
+	uint64_t ib = *(uint64_t *) b;
+
+	if (ia == ib)
+		return 0;
+
+	return ia < ib ? -1 : 1;
+}
+
+/** Initialize the page cache.
+ *
+ * @return		Return true on success, false on failure.
+ */
+bool vfs_cache_init(void)
+{
+	return ohash_table_create(&objects, 0, &objects_ops);
+}
+
+static vfs_triplet_t node_triplet(vfs_node_t *node)
+{
+	vfs_triplet_t tri = {
+		.fs_handle = node->fs_handle,
+		.service_id = node->service_id,
+		.index = node->index
+	};
+
+	return tri;
+}
+
+static cache_obj_t *obj_find(vfs_triplet_t *triplet)
+{
+	ht_link_t *link = ohash_table_find(&objects, triplet);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, cache_obj_t, link);
+}
+
+static cache_obj_t *obj_get(vfs_triplet_t *triplet)
+{
+	cache_obj_t *obj = obj_find(triplet);
+	if (obj != NULL)
+		return obj;
+
+	obj = calloc(1, sizeof(cache_obj_t));
+	if (obj == NULL)
+		return NULL;
+
+	obj->triplet = *triplet;
+	odict_initialize(&obj->pages, pages_getkey, pages_cmp);
+
+	if (ohash_table_insert(&objects, &obj->link) != EOK) {
+		free(obj);
+		return NULL;
+	}
+
+	return obj;
+}
+
+static void page_destroy(cache_page_t *page)
+{
+	assert(page->pins == 0);
+
+	if (page->readahead)
+		ra_wasted++;
+
+	odict_remove(&page->olink);
+	list_remove(&page->clock_link);
+	cache_pages--;
+
+	/* Tasks which have the page mapped keep their reference to the frame. */
+	as_area_destroy(page->data);
+	free(page);
+}
+
+/** Destroy all pages of an object from page @a first on. */
+static void obj_truncate(cache_obj_t *obj, uint64_t first)
+{
+	odlink_t *olink = odict_find_geq(&obj->pages, &first, NULL);
+
+	while (olink != NULL) {
+		cache_page_t *page = odict_get_instance(olink, cache_page_t,
+		    olink);
+		olink = odict_next(olink, &obj->pages);
+
+		/*
+		 * A pinned page is being read from by a concurrent reader.
+		 * It will be dropped together with its object.
+		 */
+		if (page->pins == 0)
+			page_destroy(page);
+	}
+}
+
+static void obj_destroy(cache_obj_t *obj)
+{
+	obj_truncate(obj, 0);
+
+	if (!odict_empty(&obj->pages)) {
+		/* Keep the object until the pinned pages are released. */
+		obj->unlinked = true;
+		return;
+	}
+
+	ohash_table_remove_item(&objects, &obj->link);
+	free(obj);
+}
+
+/** Adjust the limit according to the amount of free physical memory. */
+static void check_pressure(void)
+{
+	stats_physmem_t *stats = stats_get_physmem();
+	if (stats == NULL)
+		return;
+
+	if (stats->free < stats->total / 16)
+		cache_limit = max(cache_pages / 2, CACHE_MIN_PAGES);
+	else if (stats->free > stats->total / 4)
+		cache_limit = min(cache_limit * 2, CACHE_MAX_PAGES);
+
+	free(stats);
+}
+
+/** Evict pages until there are no more than the limit. */
+static void evict(void)
+{
+	/* Give each page at most two chances. */
+	size_t scan = 2 * cache_pages;
+
+	while (cache_pages > cache_limit && scan-- > 0) {
+		link_t *link = list_first(&clock_list);
+		cache_page_t *page = list_get_instance(link, cache_page_t,
+		    clock_link);
+
+		if (page->referenced || page->pins > 0) {
+			page->referenced = false;
+			list_remove(link);
+			list_append(link, &clock_list);
+			continue;
+		}
+
+		cache_obj_t *obj = page->obj;
+		page_destroy(page);
+		if (odict_empty(&obj->pages))
+			obj_destroy(obj);
+	}
+}
+
+/** Read a page of a file system node from the file system.
+ *
+ * @param exch		Exchange with the node's file system
+ * @param node		Node
+ * @param idx		Index of the page
+ * @param data		Page-sized buffer to fill
+ * @param valid		Place to store the number of bytes read
+ *
+ * @return		EOK on success or an error code
+ */
+static errno_t page_read(async_exch_t *exch, vfs_node_t *node, uint64_t idx,
+    uint8_t *data, size_t *valid)
+{
+	aoff64_t pos = idx * PAGE_SIZE;
+	size_t want = 0;
+	size_t total = 0;
+
+	if (pos < node->size)
+		want = min(node->size - pos, (aoff64_t) PAGE_SIZE);
+
+	while (total < want) {
+		ipc_call_t answer;
+		aid_t msg = async_send_4(exch, VFS_OUT_READ, node->service_id,
+		    node->index, LOWER32(pos + total), UPPER32(pos + total),
+		    &answer);
+		if (msg == 0)
+			return EINVAL;
+
+		errno_t rc = async_data_read_start(exch, data + total,
+		    want - total);
+		if (rc != EOK) {
+			async_forget(msg);
+			return rc;
+		}
+
+		async_wait_for(msg, &rc);
+		if (rc != EOK)
+			return rc;
+
+		size_t nread = ipc_get_arg1(&answer);
+		if (nread == 0)
+			break;
+
+		total += nread;
+	}
+
+	/* Also makes sure the page is present when handed out to the pager. */
+	memset(data + total, 0, PAGE_SIZE - total);
+
+	*valid = total;
+	return EOK;
+}
+
+static void page_hit(cache_page_t *page, bool ahead)
+{
+	if (!ahead) {
+		page->referenced = true;
+		if (page->readahead) {
+			page->readahead = false;
+			ra_hits++;
+		}
+	}
+
+	page->pins++;
+}
+
+/** Get a pinned cached page of a node, reading it in if needed.
+ *
+ * Must be called with cache_lock held, which is released while reading.
+ *
+ * @param exch		Exchange with the node's file system
+ * @param node		Node
+ * @param idx		Index of the page
+ * @param ahead		The page is being read ahead
+ * @param rpage		Place to store the page
+ *
+ * @return		EOK on success or an error code
+ */
+static errno_t page_get(async_exch_t *exch, vfs_node_t *node, uint64_t idx,
+    bool ahead, cache_page_t **rpage)
+{
+	vfs_triplet_t triplet = node_triplet(node);
+	cache_obj_t *obj = obj_get(&triplet);
+	if (obj == NULL)
+		return ENOMEM;
+
+	odlink_t *olink = odict_find_eq(&obj->pages, &idx, NULL);
+	if (olink != NULL) {
+		cache_page_t *page = odict_get_instance(olink, cache_page_t,
+		    olink);
+		page_hit(page, ahead);
+		*rpage = page;
+		return EOK;
+	}
+
+	cache_page_t *page = calloc(1, sizeof(cache_page_t));
+	if (page == NULL)
+		return ENOMEM;
+
+	page->data = as_area_create(AS_AREA_ANY, PAGE_SIZE,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
+	    AS_AREA_UNPAGED);
+	if (page->data == AS_MAP_FAILED) {
+		free(page);
+		return ENOMEM;
+	}
+
+	/*
+	 * The node's contents rwlock is held, so nobody can change the
+	 * page while we are reading it. Concurrent readers can race
+	 * with us, though.
+	 */
+	fibril_mutex_unlock(&cache_lock);
+	errno_t rc = page_read(exch, node, idx, page->data, &page->valid);
+	fibril_mutex_lock(&cache_lock);
+
+	if (rc != EOK) {
+		as_area_destroy(page->data);
+		free(page);
+
+		obj = obj_find(&triplet);
+		if (obj != NULL && odict_empty(&obj->pages) && !obj->unlinked)
+			obj_destroy(obj);
+		return rc;
+	}
+
+	/* The object may have been replaced while not holding the lock. */
+	obj = obj_get(&triplet);
+	if (obj == NULL) {
+		as_area_destroy(page->data);
+		free(page);
+		return ENOMEM;
+	}
+
+	olink = odict_find_eq(&obj->pages, &idx, NULL);
+	if (olink != NULL) {
+		/* Someone else was faster. */
+		as_area_destroy(page->data);
+		free(page);
+		page = odict_get_instance(olink, cache_page_t, olink);
+		page_hit(page, ahead);
+		*rpage = page;
+		return EOK;
+	}
+
+	page->obj = obj;
+	page->idx = idx;
+	page->pins = 1;
+	page->readahead = ahead;
+	if (ahead)
+		ra_pages++;
+	odict_insert(&page->olink, &obj->pages, NULL);
+	list_append(&page->clock_link, &clock_list);
+	cache_pages++;
+
+	if (++cache_fills % CACHE_PRESSURE_PERIOD == 0)
+		check_pressure();
+	evict();
+
+	*rpage = page;
+	return EOK;
+}
+
+static void page_release(cache_page_t *page)
+{
+	assert(page->pins > 0);
+
+	if (--page->pins == 0 && page->obj->unlinked) {
+		cache_obj_t *obj = page->obj;
+		page_destroy(page);
+		if (odict_empty(&obj->pages))
+			obj_destroy(obj);
+	}
+}
+
+/** Check whether the contents of a node can be cached.
+ *
+ * @param node		Node
+ *
+ * @return		True if the node's pages can be cached.
+ */
+bool vfs_cache_enabled(vfs_node_t *node)
+{
+	if (node->type != VFS_NODE_FILE)
+		return false;
+
+	vfs_info_t *fs_info = fs_handle_to_info(node->fs_handle);
+	if (fs_info == NULL || !fs_info->page_cache)
+		return false;
+
+	/* Writes must exclude the readers filling the cache. */
+	if (fs_info->concurrent_read_write && fs_info->write_retains_size)
+		return false;
+
+	vfs_triplet_t triplet = node_triplet(node);
+
+	fibril_mutex_lock(&cache_lock);
+	cache_obj_t *obj = obj_find(&triplet);
+	bool enabled = (obj == NULL || !obj->unlinked);
+	fibril_mutex_unlock(&cache_lock);
+
+	return enabled;
+}
+
+/** Serve a client's read from the cache.
+ *
+ * The client's IPC_M_DATA_READ is received and answered with the data of
+ * the pages starting at @a pos.
+ *
+ * @param exch		Exchange with the node's file system
+ * @param node		Node, its contents rwlock held for reading
+ * @param pos		Position in the file to read from
+ * @param bytes		Place to store the number of bytes read
+ *
+ * @return		EOK on success or an error code
+ */
+errno_t vfs_cache_read(async_exch_t *exch, vfs_node_t *node, aoff64_t pos,
+    size_t *bytes)
+{
+	cache_page_t *pages[CACHE_READ_MAX_PAGES];
+	ipc_call_t call;
+	size_t size;
+	errno_t rc = EOK;
+
+	*bytes = 0;
+
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(&call, EINVAL);
+		return EINVAL;
+	}
+
+	if (pos >= node->size || size == 0)
+		return async_data_read_finalize(&call, NULL, 0);
+
+	size = min(size, node->size - pos);
+
+	uint64_t first = pos / PAGE_SIZE;
+	uint64_t last = (pos + size - 1) / PAGE_SIZE;
+	size_t npages = min(last - first + 1, (uint64_t) CACHE_READ_MAX_PAGES);
+
+	fibril_mutex_lock(&cache_lock);
+
+	size_t i;
+	for (i = 0; i < npages; i++) {
+		rc = page_get(exch, node, first + i, false, &pages[i]);
+		if (rc != EOK)
+			break;
+	}
+
+	/* Return what was read if a later page failed. */
+	size_t pinned = i;
+	npages = i;
+	if (npages == 0) {
+		fibril_mutex_unlock(&cache_lock);
+		async_answer_0(&call, rc);
+		return rc;
+	}
+
+	size_t off = pos % PAGE_SIZE;
+	size_t avail = 0;
+	for (i = 0; i < npages; i++) {
+		size_t start = (i == 0) ? off : 0;
+		if (pages[i]->valid > start)
+			avail += pages[i]->valid - start;
+		if (pages[i]->valid < PAGE_SIZE) {
+			npages = i + 1;
+			break;
+		}
+	}
+
+	size = min(size, avail);
+
+	if (npages == 1) {
+		rc = async_data_read_finalize(&call, pages[0]->data + off,
+		    size);
+	} else {
+		uint8_t *buf = malloc(size);
+		if (buf != NULL) {
+			size_t done = 0;
+			for (i = 0; done < size; i++) {
+				size_t start = (i == 0) ? off : 0;
+				size_t now = min(size - done,
+				    pages[i]->valid - start);
+				memcpy(buf + done, pages[i]->data + start, now);
+				done += now;
+			}
+
+			rc = async_data_read_finalize(&call, buf, size);
+			free(buf);
+		} else {
+			/* Fall back to returning just the first page. */
+			size = min(size, pages[0]->valid - off);
+			rc = async_data_read_finalize(&call,
+			    pages[0]->data + off, size);
+		}
+	}
+
+	for (i = 0; i < pinned; i++)
+		page_release(pages[i]);
+
+	fibril_mutex_unlock(&cache_lock);
+
+	if (rc == EOK)
+		*bytes = size;
+
+	return rc;
+}
+
+typedef struct {
+	vfs_node_t *node;
+	uint64_t first;
+	uint64_t end;
+} readahead_t;
+
+static errno_t readahead_fibril(void *arg)
+{
+	readahead_t *ra = arg;
+	vfs_node_t *node = ra->node;
+
+	fibril_rwlock_read_lock(&node->contents_rwlock);
+	async_exch_t *exch = vfs_exchange_grab(node->fs_handle);
+
+	fibril_mutex_lock(&cache_lock);
+
+	for (uint64_t idx = ra->first; idx < ra->end; idx++) {
+		if (idx * PAGE_SIZE >= node->size)
+			break;
+
+		cache_page_t *page;
+		if (page_get(exch, node, idx, true, &page) != EOK)
+			break;
+		page_release(page);
+	}
+
+	fibril_mutex_unlock(&cache_lock);
+
+	vfs_exchange_release(exch);
+	fibril_rwlock_read_unlock(&node->contents_rwlock);
+
+	vfs_node_delref(node);
+	free(ra);
+	return EOK;
+}
+
+/** Note a read of an open file and read ahead if it is sequential.
+ *
+ * @param file		Open file, locked by the caller
+ * @param pos		Position the file was read from
+ * @param bytes		Number of bytes read
+ */
+void vfs_cache_access(vfs_file_t *file, aoff64_t pos, size_t bytes)
+{
+	if (bytes == 0)
+		return;
+
+	if (pos == file->ra_next) {
+		file->ra_window = (file->ra_window == 0) ? CACHE_RA_MIN_PAGES :
+		    min(2 * file->ra_window, (size_t) CACHE_RA_MAX_PAGES);
+	} else {
+		file->ra_window = 0;
+		file->ra_end = 0;
+	}
+
+	file->ra_next = pos + bytes;
+
+	if (file->ra_window == 0)
+		return;
+
+	uint64_t next = ALIGN_UP(pos + bytes, PAGE_SIZE) / PAGE_SIZE;
+	uint64_t end = next + file->ra_window;
+	uint64_t first = max(next, file->ra_end);
+
+	/* Wait until at least half of the window can be requested. */
+	if (first >= end || end - first < file->ra_window / 2)
+		return;
+
+	if (first * PAGE_SIZE >= file->node->size)
+		return;
+
+	readahead_t *ra = malloc(sizeof(readahead_t));
+	if (ra == NULL)
+		return;
+
+	ra->node = file->node;
+	ra->first = first;
+	ra->end = end;
+
+	fid_t fid = fibril_create(readahead_fibril, ra);
+	if (fid == 0) {
+		free(ra);
+		return;
+	}
+
+	vfs_node_addref(file->node);
+	file->ra_end = end;
+	fibril_add_ready(fid);
+}
+
+/** Get statistics of the page cache.
+ *
+ * @param stats		Structure to fill in the page cache statistics of
+ */
+void vfs_cache_stats(vfs_server_stats_t *stats)
+{
+	fibril_mutex_lock(&cache_lock);
+	stats->cache_pages = cache_pages;
+	stats->ra_pages = ra_pages;
+	stats->ra_hits = ra_hits;
+	stats->ra_wasted = ra_wasted;
+	fibril_mutex_unlock(&cache_lock);
+}
+
+/** Check whether a node has any cached pages.
+ *
+ * @param node		Node
+ *
+ * @return		True if there are pages to be kept up to date on writes.
+ */
+bool vfs_cache_cached(vfs_node_t *node)
+{
+	vfs_triplet_t triplet = node_triplet(node);
+
+	fibril_mutex_lock(&cache_lock);
+	cache_obj_t *obj = obj_find(&triplet);
+	bool cached = (obj != NULL && !odict_empty(&obj->pages));
+	fibril_mutex_unlock(&cache_lock);
+
+	return cached;
+}
+
+/** Update the cached pages of a node after a write.
+ *
+ * @param node		Node, its contents rwlock held for writing
+ * @param pos		Position the data was written at
+ * @param buf		Written data
+ * @param size		Number of bytes written
+ * @param new_size	New size of the file
+ */
+static void cache_update(vfs_node_t *node, aoff64_t pos, const uint8_t *buf,
+    size_t size, aoff64_t new_size)
+{
+	vfs_triplet_t triplet = node_triplet(node);
+
+	fibril_mutex_lock(&cache_lock);
+
+	cache_obj_t *obj = obj_find(&triplet);
+	if (obj == NULL) {
+		fibril_mutex_unlock(&cache_lock);
+		return;
+	}
+
+	/* Pages between the old end of file and the write have grown, too. */
+	aoff64_t start = min(pos, node->size);
+	uint64_t first = start / PAGE_SIZE;
+	odlink_t *olink = odict_find_geq(&obj->pages, &first, NULL);
+
+	while (olink != NULL) {
+		cache_page_t *page = odict_get_instance(olink, cache_page_t,
+		    olink);
+		aoff64_t pgpos = page->idx * PAGE_SIZE;
+
+		if (pgpos >= max(pos + size, new_size))
+			break;
+
+		if (pgpos < pos + size && pgpos + PAGE_SIZE > pos) {
+			aoff64_t from = max(pos, pgpos);
+			aoff64_t to = min(pos + size, pgpos + PAGE_SIZE);
+			memcpy(page->data + (from - pgpos), buf + (from - pos),
+			    to - from);
+		}
+
+		if (new_size > pgpos) {
+			page->valid = max(page->valid,
+			    (size_t) min(new_size - pgpos, (aoff64_t) PAGE_SIZE));
+		}
+
+		olink = odict_next(olink, &obj->pages);
+	}
+
+	fibril_mutex_unlock(&cache_lock);
+}
+
+/** Write a client's data through the cache.
+ *
+ * The client's IPC_M_DATA_WRITE is received, the data written to the file
+ * system and the cached pages updated.
+ *
+ * @param exch		Exchange with the node's file system
+ * @param node		Node, its contents rwlock held for writing
+ * @param pos		Position in the file to write to
+ * @param answer	Answer of the file system's VFS_OUT_WRITE
+ * @param bytes		Place to store the number of bytes written
+ *
+ * @return		EOK on success or an error code
+ */
+errno_t vfs_cache_write(async_exch_t *exch, vfs_node_t *node, aoff64_t pos,
+    ipc_call_t *answer, size_t *bytes)
+{
+	ipc_call_t call;
+	size_t size;
+	errno_t rc;
+
+	*bytes = 0;
+
+	if (!async_data_write_receive(&call, &size)) {
+		async_answer_0(&call, EINVAL);
+		return EINVAL;
+	}
+
+	/* The client writes the rest in further requests. */
+	size = min(size, (size_t) CACHE_WRITE_MAX);
+
+	uint8_t *buf = malloc(size);
+	if (buf == NULL) {
+		async_answer_0(&call, ENOMEM);
+		return ENOMEM;
+	}
+
+	rc = async_data_write_finalize(&call, buf, size);
+	if (rc != EOK) {
+		free(buf);
+		return rc;
+	}
+
+	aid_t msg = async_send_4(exch, VFS_OUT_WRITE, node->service_id,
+	    node->index, LOWER32(pos), UPPER32(pos), answer);
+	if (msg == 0) {
+		free(buf);
+		return EINVAL;
+	}
+
+	rc = async_data_write_start(exch, buf, size);
+	if (rc != EOK) {
+		async_forget(msg);
+		free(buf);
+		return rc;
+	}
+
+	async_wait_for(msg, &rc);
+	if (rc == EOK) {
+		*bytes = ipc_get_arg1(answer);
+		cache_update(node, pos, buf, *bytes,
+		    MERGE_LOUP32(ipc_get_arg2(answer), ipc_get_arg3(answer)));
+	}
+
+	free(buf);
+	return rc;
+}
+
+/** Answer a page-in request from the cache.
+ *
+ * @param exch		Exchange with the node's file system
+ * @param node		Node, its contents rwlock held for reading
+ * @param pos		Page-aligned position in the file
+ * @param req		IPC_M_PAGE_IN request to answer
+ *
+ * @return		EOK if the request was answered or an error code
+ */
+errno_t vfs_cache_page_in(async_exch_t *exch, vfs_node_t *node, aoff64_t pos,
+    ipc_call_t *req)
+{
+	cache_page_t *page;
+
+	assert(pos % PAGE_SIZE == 0);
+
+	fibril_mutex_lock(&cache_lock);
+
+	errno_t rc = page_get(exch, node, pos / PAGE_SIZE, false, &page);
+	if (rc != EOK) {
+		fibril_mutex_unlock(&cache_lock);
+		return rc;
+	}
+
+	/* The kernel takes its own reference to the frame while answering. */
+	async_answer_1(req, EOK, (sysarg_t) page->data);
+
+	page_release(page);
+	fibril_mutex_unlock(&cache_lock);
+
+	return EOK;
+}
+
+/** Drop cached pages of a node beyond its new size.
+ *
+ * @param node		Node, its contents rwlock held for writing
+ * @param size		New size of the file
+ */
+void vfs_cache_resize(vfs_node_t *node, aoff64_t size)
+{
+	vfs_triplet_t triplet = node_triplet(node);
+
+	fibril_mutex_lock(&cache_lock);
+
+	cache_obj_t *obj = obj_find(&triplet);
+	if (obj != NULL) {
+		/* The page holding the end of file has changed as well. */
+		obj_truncate(obj, min(size, node->size) / PAGE_SIZE);
+		if (odict_empty(&obj->pages) && !obj->unlinked)
+			obj_destroy(obj);
+	}
+
+	fibril_mutex_unlock(&cache_lock);
+}
+
+/** Drop cached pages of a file which has been unlinked.
+ *
+ * @param triplet	File
+ * @param in_use	True if the file is still in use and will only be
+ *			destroyed once vfs_cache_node_freed() is called.
+ */
+void vfs_cache_unlinked(vfs_triplet_t *triplet, bool in_use)
+{
+	fibril_mutex_lock(&cache_lock);
+
+	cache_obj_t *obj = in_use ? obj_get(triplet) : obj_find(triplet);
+	if (obj != NULL) {
+		if (in_use) {
+			obj_truncate(obj, 0);
+			obj->unlinked = true;
+		} else {
+			obj_destroy(obj);
+		}
+	}
+
+	fibril_mutex_unlock(&cache_lock);
+}
+
+/** Forget an unlinked node that is no longer in use.
+ *
+ * @param node		Node
+ */
+void vfs_cache_node_freed(vfs_node_t *node)
+{
+	vfs_triplet_t triplet = node_triplet(node);
+
+	fibril_mutex_lock(&cache_lock);
+
+	cache_obj_t *obj = obj_find(&triplet);
+	if (obj != NULL && obj->unlinked)
+		obj_destroy(obj);
+
+	fibril_mutex_unlock(&cache_lock);
+}
+
+static bool unmounted_visitor(ht_link_t *item, void *arg)
+{
+	cache_obj_t *obj = hash_table_get_inst(item, cache_obj_t, link);
+	vfs_pair_t *pair = arg;
+
+	if (obj->triplet.fs_handle == pair->fs_handle &&
+	    obj->triplet.service_id == pair->service_id)
+		obj_destroy(obj);
+
+	return true;
+}
+
+/** Drop all cached pages of an unmounted file system instance.
+ *
+ * @param fs_handle	File system
+ * @param service_id	Instance
+ */
+void vfs_cache_unmounted(fs_handle_t fs_handle, service_id_t service_id)
+{
+	vfs_pair_t pair = {
+		.fs_handle = fs_handle,
+		.service_id = service_id
+	};
+
+	fibril_mutex_lock(&cache_lock);
+	ohash_table_apply(&objects, unmounted_visitor, &pair);
+	fibril_mutex_unlock(&cache_lock);
+}
+
+/**
+ * @}
+ */
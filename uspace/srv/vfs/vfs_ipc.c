@@ -183,6 +183,43 @@ static void vfs_in_read(ipc_call_t *req)
 	async_answer_1(req, rc, bytes);
 }
 
+static void vfs_in_readdir(ipc_call_t *req)
+{
+	int fd = ipc_get_arg1(req);
+	aoff64_t pos = MERGE_LOUP32(ipc_get_arg2(req),
+	    ipc_get_arg3(req));
+	ipc_call_t call;
+	size_t size;
+
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(req, EINVAL);
+		return;
+	}
+
+	if (size > VFS_READDIR_MAX)
+		size = VFS_READDIR_MAX;
+
+	char *buf = malloc(size);
+	if (buf == NULL) {
+		async_answer_0(&call, ENOMEM);
+		async_answer_0(req, ENOMEM);
+		return;
+	}
+
+	size_t bytes = 0;
+	errno_t rc = vfs_op_readdir(fd, &pos, buf, size, &bytes);
+	if (rc != EOK) {
+		free(buf);
+		async_answer_0(&call, rc);
+		async_answer_0(req, rc);
+		return;
+	}
+
+	rc = async_data_read_finalize(&call, buf, bytes);
+	free(buf);
+	async_answer_3(req, rc, bytes, LOWER32(pos), UPPER32(pos));
+}
+
 static void vfs_in_rename(ipc_call_t *req)
 {
 	/* The common base directory. */
@@ -250,6 +287,27 @@ static void vfs_in_statfs(ipc_call_t *req)
 	async_answer_0(req, rc);
 }
 
+static void vfs_in_stats(ipc_call_t *req)
+{
+	vfs_server_stats_t stats;
+	ipc_call_t call;
+	size_t size;
+
+	if (!async_data_read_receive(&call, &size) ||
+	    size != sizeof(vfs_server_stats_t)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(req, EINVAL);
+		return;
+	}
+
+	memset(&stats, 0, sizeof(stats));
+	vfs_plb_stats(&stats);
+	vfs_cache_stats(&stats);
+
+	errno_t rc = async_data_read_finalize(&call, &stats, sizeof(stats));
+	async_answer_0(req, rc);
+}
+
 static void vfs_in_sync(ipc_call_t *req)
 {
 	int fd = ipc_get_arg1(req);
@@ -356,6 +414,9 @@ void vfs_connection(ipc_call_t *icall, void *arg)
 		case VFS_IN_READ:
 			vfs_in_read(&call);
 			break;
+		case VFS_IN_READDIR:
+			vfs_in_readdir(&call);
+			break;
 		case VFS_IN_REGISTER:
 			vfs_register(&call);
 			cont = false;
@@ -372,6 +433,9 @@ void vfs_connection(ipc_call_t *icall, void *arg)
 		case VFS_IN_STATFS:
 			vfs_in_statfs(&call);
 			break;
+		case VFS_IN_STATS:
+			vfs_in_stats(&call);
+			break;
 		case VFS_IN_SYNC:
 			vfs_in_sync(&call);
 			break;
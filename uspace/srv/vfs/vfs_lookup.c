@@ -48,92 +48,149 @@
 #include <dirent.h>
 #include <assert.h>
 
+/*
+ * PLB is divided into chunks of PLB_CHUNK_SIZE bytes. Each lookup in progress
+ * holds a contiguous run of chunks for its path, so the lookups do not depend
+ * on each other to finish in order to make space for new ones. The last chunk
+ * is never used, because file system servers report positions in 16 bits and
+ * a path ending at PLB_SIZE would overflow them.
+ */
+#define PLB_CHUNK_SIZE	128
+#define PLB_CHUNKS	(PLB_SIZE / PLB_CHUNK_SIZE - 1)
+#define PLB_MAP_WORDS	((PLB_CHUNKS + 31) / 32)
+
 FIBRIL_MUTEX_INITIALIZE(plb_mutex);
-LIST_INITIALIZE(plb_entries);	/**< PLB entry ring buffer. */
+static FIBRIL_CONDVAR_INITIALIZE(plb_cv);
 uint8_t *plb = NULL;
 
-static errno_t plb_insert_entry(plb_entry_t *entry, char *path, size_t *start,
-    size_t len)
-{
-	fibril_mutex_lock(&plb_mutex);
-
-	link_initialize(&entry->plb_link);
-	entry->len = len;
+/** Bitmap of chunks in use. */
+static uint32_t plb_map[PLB_MAP_WORDS];
 
-	size_t first;	/* the first free index */
-	size_t last;	/* the last free index */
+/** Statistics of PLB use, protected by plb_mutex. */
+static size_t plb_lookups;
+static size_t plb_contended;
+static size_t plb_waits;
+static size_t plb_used;
+static size_t plb_peak;
 
-	if (list_empty(&plb_entries)) {
-		first = 0;
-		last = PLB_SIZE - 1;
-	} else {
-		plb_entry_t *oldest = list_get_instance(
-		    list_first(&plb_entries), plb_entry_t, plb_link);
-		plb_entry_t *newest = list_get_instance(
-		    list_last(&plb_entries), plb_entry_t, plb_link);
+static bool plb_chunk_used(size_t chunk)
+{
+	return (plb_map[chunk / 32] & (1U << (chunk % 32))) != 0;
+}
 
-		first = (newest->index + newest->len) % PLB_SIZE;
-		last = (oldest->index - 1) % PLB_SIZE;
+static void plb_chunks_set(size_t first, size_t count, bool used)
+{
+	for (size_t i = first; i < first + count; i++) {
+		if (used)
+			plb_map[i / 32] |= 1U << (i % 32);
+		else
+			plb_map[i / 32] &= ~(1U << (i % 32));
 	}
+}
 
-	if (first <= last) {
-		if ((last - first) + 1 < len) {
-			/*
-			 * The buffer cannot absorb the path.
-			 */
-			fibril_mutex_unlock(&plb_mutex);
-			return ELIMIT;
+/** Find a run of free chunks.
+ *
+ * @param count		Number of chunks
+ * @param first		Place to store the first chunk of the run
+ *
+ * @return		True if found, false if there is no such run now.
+ */
+static bool plb_chunks_find(size_t count, size_t *first)
+{
+	size_t run = 0;
+	size_t chunk = 0;
+
+	while (chunk < PLB_CHUNKS) {
+		/* Skip fully used words quickly. */
+		if (chunk % 32 == 0 && plb_map[chunk / 32] == UINT32_MAX) {
+			run = 0;
+			chunk += 32;
+			continue;
 		}
-	} else {
-		if (PLB_SIZE - ((first - last) + 1) < len) {
-			/*
-			 * The buffer cannot absorb the path.
-			 */
-			fibril_mutex_unlock(&plb_mutex);
-			return ELIMIT;
+
+		if (plb_chunk_used(chunk)) {
+			run = 0;
+		} else if (++run == count) {
+			*first = chunk + 1 - count;
+			return true;
 		}
+
+		chunk++;
 	}
 
-	/*
-	 * We know the first free index in PLB and we also know that there is
-	 * enough space in the buffer to hold our path.
-	 */
+	return false;
+}
 
-	entry->index = first;
-	entry->len = len;
+static errno_t plb_insert_entry(plb_entry_t *entry, char *path, size_t *start,
+    size_t len)
+{
+	size_t chunks = max((size_t) 1,
+	    (len + PLB_CHUNK_SIZE - 1) / PLB_CHUNK_SIZE);
+	if (chunks > PLB_CHUNKS)
+		return ELIMIT;
 
-	/*
-	 * Claim PLB space by inserting the entry into the PLB entry ring
-	 * buffer.
-	 */
-	list_append(&entry->plb_link, &plb_entries);
+	bool contended = !fibril_mutex_trylock(&plb_mutex);
+	if (contended)
+		fibril_mutex_lock(&plb_mutex);
+
+	plb_lookups++;
+	if (contended)
+		plb_contended++;
+
+	size_t first;
+	if (!plb_chunks_find(chunks, &first)) {
+		/* Wait for other lookups to finish and release their chunks. */
+		plb_waits++;
+		do {
+			fibril_condvar_wait(&plb_cv, &plb_mutex);
+		} while (!plb_chunks_find(chunks, &first));
+	}
+
+	plb_chunks_set(first, chunks, true);
+	plb_used += chunks;
+	plb_peak = max(plb_peak, plb_used);
 
 	fibril_mutex_unlock(&plb_mutex);
 
+	entry->index = first * PLB_CHUNK_SIZE;
+	entry->len = len;
+	entry->chunks = chunks;
+
 	/*
-	 * Copy the path into PLB.
+	 * Copy the path into PLB. The chunks are ours, so this needs no
+	 * locking.
 	 */
-	size_t cnt1 = min(len, (PLB_SIZE - first) + 1);
-	size_t cnt2 = len - cnt1;
-
-	memcpy(&plb[first], path, cnt1);
-	memcpy(plb, &path[cnt1], cnt2);
+	memcpy(&plb[entry->index], path, len);
 
-	*start = first;
+	*start = entry->index;
 	return EOK;
 }
 
 static void plb_clear_entry(plb_entry_t *entry, size_t first, size_t len)
 {
-	fibril_mutex_lock(&plb_mutex);
-	list_remove(&entry->plb_link);
 	/*
 	 * Erasing the path from PLB will come handy for debugging purposes.
 	 */
-	size_t cnt1 = min(len, (PLB_SIZE - first) + 1);
-	size_t cnt2 = len - cnt1;
-	memset(&plb[first], 0, cnt1);
-	memset(plb, 0, cnt2);
+	memset(&plb[first], 0, len);
+
+	fibril_mutex_lock(&plb_mutex);
+	plb_chunks_set(entry->index / PLB_CHUNK_SIZE, entry->chunks, false);
+	plb_used -= entry->chunks;
+	fibril_condvar_broadcast(&plb_cv);
+	fibril_mutex_unlock(&plb_mutex);
+}
+
+/** Get statistics of PLB use.
+ *
+ * @param stats		Structure to fill in the PLB statistics of
+ */
+void vfs_plb_stats(vfs_server_stats_t *stats)
+{
+	fibril_mutex_lock(&plb_mutex);
+	stats->plb_lookups = plb_lookups;
+	stats->plb_contended = plb_contended;
+	stats->plb_waits = plb_waits;
+	stats->plb_peak = plb_peak * PLB_CHUNK_SIZE;
 	fibril_mutex_unlock(&plb_mutex);
 }
 
@@ -202,6 +259,9 @@ errno_t vfs_link_internal(vfs_node_t *base, char *path, vfs_triplet_t *child)
 	if (orig_rc != EOK)
 		rc = orig_rc;
 
+	if (rc == EOK)
+		vfs_namecache_purge(triplet->fs_handle, triplet->service_id);
+
 out:
 	return rc;
 }
@@ -240,15 +300,16 @@ static errno_t out_lookup(vfs_triplet_t *base, size_t *pfirst, size_t *plen,
 static errno_t _vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
     vfs_lookup_res_t *result, size_t len)
 {
-	size_t first;
+	size_t first = 0;
+	bool in_plb = false;
 	errno_t rc;
 
 	plb_entry_t entry;
-	rc = plb_insert_entry(&entry, path, &first, len);
-	if (rc != EOK)
-		return rc;
 
-	size_t next = first;
+	/* Lookups which modify the namespace must not be cached. */
+	bool cacheable = !(lflag & (L_CREATE | L_UNLINK));
+
+	size_t off = 0;
 	size_t nlen = len;
 
 	vfs_lookup_res_t res;
@@ -264,10 +325,54 @@ static errno_t _vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
 			base = base->mount;
 		}
 
-		rc = out_lookup((vfs_triplet_t *) base, &next, &nlen, lflag,
-		    &res);
-		if (rc != EOK)
-			goto out;
+		vfs_triplet_t *tbase = (vfs_triplet_t *) base;
+		size_t consumed;
+
+		if (cacheable && vfs_namecache_find(tbase, path + off, nlen,
+		    &res, &consumed)) {
+			/* The file system would have checked the type. */
+			if (consumed == nlen) {
+				if ((lflag & L_FILE) &&
+				    res.type == VFS_NODE_DIRECTORY) {
+					rc = EISDIR;
+					goto out;
+				}
+				if ((lflag & L_DIRECTORY) &&
+				    res.type == VFS_NODE_FILE) {
+					rc = ENOTDIR;
+					goto out;
+				}
+			}
+		} else {
+			unsigned gen = vfs_namecache_generation();
+
+			/* The path is only needed in PLB on a cache miss. */
+			if (!in_plb) {
+				rc = plb_insert_entry(&entry, path, &first,
+				    len);
+				if (rc != EOK)
+					return rc;
+				in_plb = true;
+			}
+
+			size_t next = first + off;
+			size_t rlen = nlen;
+			rc = out_lookup(tbase, &next, &rlen, lflag, &res);
+			if (rc != EOK)
+				goto out;
+
+			consumed = nlen - rlen;
+			if (cacheable) {
+				vfs_namecache_insert(gen, tbase, path + off,
+				    nlen, &res, consumed);
+			} else {
+				vfs_namecache_purge(tbase->fs_handle,
+				    tbase->service_id);
+			}
+		}
+
+		off += consumed;
+		nlen -= consumed;
 
 		if (nlen > 0) {
 			base = vfs_node_peek(&res);
@@ -317,7 +422,8 @@ static errno_t _vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
 	}
 
 out:
-	plb_clear_entry(&entry, first, len);
+	if (in_plb)
+		plb_clear_entry(&entry, first, len);
 	return rc;
 }
 
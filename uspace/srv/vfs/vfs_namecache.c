@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup vfs
+ * @{
+ */
+
+/**
+ * @file	vfs_namecache.c
+ * @brief	Cache of path lookup results.
+ *
+ * The cache remembers the answers of file system servers to VFS_OUT_LOOKUP
+ * requests, keyed by the node the lookup started from and the looked up
+ * path. An answer either resolves the whole path, or only a part of it when
+ * the rest of the path does not exist or lies beyond a mount point. The
+ * latter thus also serve as negative entries.
+ *
+ * Each entry holds a reference to the node it resolves to, so that the size
+ * and type of the node are kept up to date by VFS. The entries of a file
+ * system instance are purged whenever a name is linked or unlinked in it and
+ * when it is unmounted.
+ */
+
+#include "vfs.h"
+#include <adt/hash.h>
+#include <adt/list.h>
+#include <adt/ohash_table.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <mem.h>
+#include <stdlib.h>
+
+/** Maximum number of cached lookups. */
+#define NAMECACHE_MAX  1024
+
+/** Cached result of a lookup. */
+typedef struct {
+	/** Link in names */
+	ht_link_t link;
+	/** Link in names_lru */
+	link_t lru_link;
+	/** Node the lookup started from */
+	vfs_triplet_t base;
+	/** Looked up path, not NUL-terminated */
+	char *path;
+	size_t len;
+	/** Number of bytes of path resolved by the lookup */
+	size_t consumed;
+	/** Node the lookup resolved to */
+	vfs_node_t *node;
+} name_t;
+
+typedef struct {
+	vfs_triplet_t *base;
+	const char *path;
+	size_t len;
+} name_key_t;
+
+/** Protects names, names_lru and names_gen. */
+static FIBRIL_MUTEX_INITIALIZE(names_lock);
+
+/** Cached lookups, name_t. */
+static ohash_table_t names;
+
+/** Cached lookups from the least to the most recently used, name_t. */
+static LIST_INITIALIZE(names_lru);
+
+/** Incremented by each purge to discard results of lookups in flight. */
+static unsigned names_gen;
+
+static size_t name_hash(vfs_triplet_t *base, const char *path, size_t len)
+{
+	size_t hash = hash_combine(base->fs_handle, base->service_id);
+	hash = hash_combine(hash, base->index);
+
+	for (size_t i = 0; i < len; i++)
+		hash = hash * 31 + (uint8_t) path[i];
+
+	return hash;
+}
+
+static size_t names_key_hash(const void *key)
+{
+	const name_key_t *nk = key;
+	return name_hash(nk->base, nk->path, nk->len);
+}
+
+static size_t names_hash(const ht_link_t *item)
+{
+	name_t *name = hash_table_get_inst(item, name_t, link);
+	return name_hash(&name->base, name->path, name->len);
+}
+
+static bool names_key_equal(const void *key, const ht_link_t *item)
+{
+	const name_key_t *nk = key;
+	name_t *name = hash_table_get_inst(item, name_t, link);
+
+	return name->base.fs_handle == nk->base->fs_handle &&
+	    name->base.service_id == nk->base->service_id &&
+	    name->base.index == nk->base->index &&
+	    name->len == nk->len &&
+	    memcmp(name->path, nk->path, nk->len) == 0;
+}
+
+static const hash_table_ops_t names_ops = {
+	.hash = names_hash,
+	.key_hash = names_key_hash,
+	.key_equal = names_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Initialize the name cache.
+ *
+ * @return		Return true on success, false on failure.
+ */
+bool vfs_namecache_init(void)
+{
+	return ohash_table_create(&names, 0, &names_ops);
+}
+
+static bool namecache_enabled(vfs_triplet_t *base)
+{
+	vfs_info_t *fs_info = fs_handle_to_info(base->fs_handle);
+	return fs_info != NULL && fs_info->name_cache;
+}
+
+/** Drop entries collected by the caller while holding names_lock. */
+static void names_free(list_t *dropped)
+{
+	list_foreach_safe(*dropped, cur, next) {
+		name_t *name = list_get_instance(cur, name_t, lru_link);
+		list_remove(cur);
+
+		vfs_node_put(name->node);
+		free(name->path);
+		free(name);
+	}
+}
+
+/** Look up a cached lookup result.
+ *
+ * @param base		Node to start the lookup from
+ * @param path		Path to look up, need not be NUL-terminated
+ * @param len		Length of @a path
+ * @param result	Place to store the result of the lookup
+ * @param consumed	Place to store the number of bytes of @a path resolved
+ *
+ * @return		True if the result was cached, false otherwise.
+ */
+bool vfs_namecache_find(vfs_triplet_t *base, const char *path, size_t len,
+    vfs_lookup_res_t *result, size_t *consumed)
+{
+	name_key_t key = {
+		.base = base,
+		.path = path,
+		.len = len
+	};
+
+	if (!namecache_enabled(base))
+		return false;
+
+	fibril_mutex_lock(&names_lock);
+
+	ht_link_t *link = ohash_table_find(&names, &key);
+	if (link == NULL) {
+		fibril_mutex_unlock(&names_lock);
+		return false;
+	}
+
+	name_t *name = hash_table_get_inst(link, name_t, link);
+	list_remove(&name->lru_link);
+	list_append(&name->lru_link, &names_lru);
+
+	result->triplet.fs_handle = name->node->fs_handle;
+	result->triplet.service_id = name->node->service_id;
+	result->triplet.index = name->node->index;
+	result->type = name->node->type;
+	result->size = name->node->size;
+	*consumed = name->consumed;
+
+	fibril_mutex_unlock(&names_lock);
+	return true;
+}
+
+/** Get the current generation of the name cache.
+ *
+ * The generation must be obtained before sending the lookup whose result
+ * is going to be inserted.
+ *
+ * @return		Current generation.
+ */
+unsigned vfs_namecache_generation(void)
+{
+	fibril_mutex_lock(&names_lock);
+	unsigned gen = names_gen;
+	fibril_mutex_unlock(&names_lock);
+
+	return gen;
+}
+
+/** Insert a lookup result into the cache.
+ *
+ * The result is not inserted if the cache has been purged since @a gen was
+ * obtained, because the result may be stale.
+ *
+ * @param gen		Generation obtained before sending the lookup
+ * @param base		Node the lookup started from
+ * @param path		Looked up path, need not be NUL-terminated
+ * @param len		Length of @a path
+ * @param result	Result of the lookup
+ * @param consumed	Number of bytes of @a path resolved by the lookup
+ */
+void vfs_namecache_insert(unsigned gen, vfs_triplet_t *base, const char *path,
+    size_t len, vfs_lookup_res_t *result, size_t consumed)
+{
+	name_key_t key = {
+		.base = base,
+		.path = path,
+		.len = len
+	};
+
+	if (!namecache_enabled(base))
+		return;
+
+	name_t *name = calloc(1, sizeof(name_t));
+	if (name == NULL)
+		return;
+
+	name->path = malloc(len);
+	if (name->path == NULL) {
+		free(name);
+		return;
+	}
+
+	name->node = vfs_node_get(result);
+	if (name->node == NULL) {
+		free(name->path);
+		free(name);
+		return;
+	}
+
+	memcpy(name->path, path, len);
+	name->len = len;
+	name->base = *base;
+	name->consumed = consumed;
+
+	list_t dropped;
+	list_initialize(&dropped);
+
+	fibril_mutex_lock(&names_lock);
+
+	if (gen != names_gen || ohash_table_find(&names, &key) != NULL) {
+		fibril_mutex_unlock(&names_lock);
+		list_append(&name->lru_link, &dropped);
+		names_free(&dropped);
+		return;
+	}
+
+	if (ohash_table_insert(&names, &name->link) != EOK) {
+		fibril_mutex_unlock(&names_lock);
+		list_append(&name->lru_link, &dropped);
+		names_free(&dropped);
+		return;
+	}
+
+	list_append(&name->lru_link, &names_lru);
+
+	while (ohash_table_size(&names) > NAMECACHE_MAX) {
+		name_t *old = list_get_instance(list_first(&names_lru), name_t,
+		    lru_link);
+		ohash_table_remove_item(&names, &old->link);
+		list_remove(&old->lru_link);
+		list_append(&old->lru_link, &dropped);
+	}
+
+	fibril_mutex_unlock(&names_lock);
+
+	names_free(&dropped);
+}
+
+typedef struct {
+	vfs_pair_t pair;
+	list_t *dropped;
+} purge_arg_t;
+
+static bool purge_visitor(ht_link_t *item, void *arg)
+{
+	name_t *name = hash_table_get_inst(item, name_t, link);
+	purge_arg_t *parg = arg;
+
+	if (name->base.fs_handle == parg->pair.fs_handle &&
+	    name->base.service_id == parg->pair.service_id) {
+		ohash_table_remove_item(&names, &name->link);
+		list_remove(&name->lru_link);
+		list_append(&name->lru_link, parg->dropped);
+	}
+
+	return true;
+}
+
+/** Purge all cached lookups in a file system instance.
+ *
+ * @param fs_handle	File system
+ * @param service_id	Instance
+ */
+void vfs_namecache_purge(fs_handle_t fs_handle, service_id_t service_id)
+{
+	list_t dropped;
+	list_initialize(&dropped);
+
+	purge_arg_t arg = {
+		.pair = {
+			.fs_handle = fs_handle,
+			.service_id = service_id
+		},
+		.dropped = &dropped
+	};
+
+	fibril_mutex_lock(&names_lock);
+	names_gen++;
+	ohash_table_apply(&names, purge_visitor, &arg);
+	fibril_mutex_unlock(&names_lock);
+
+	names_free(&dropped);
+}
+
+/**
+ * @}
+ */
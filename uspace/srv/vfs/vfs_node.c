@@ -40,6 +40,7 @@
 #include <str.h>
 #include <fibril_synch.h>
 #include <adt/hash_table.h>
+#include <adt/ohash_table.h>
 #include <adt/hash.h>
 #include <assert.h>
 #include <async.h>
@@ -53,7 +54,7 @@ FIBRIL_MUTEX_INITIALIZE(nodes_mutex);
 #define NODES_BUCKETS		(1 << NODES_BUCKETS_LOG)
 
 /** VFS node hash table containing all active, in-memory VFS nodes. */
-hash_table_t nodes;
+ohash_table_t nodes;
 
 #define KEY_FS_HANDLE	0
 #define KEY_DEV_HANDLE	1
@@ -79,7 +80,7 @@ const hash_table_ops_t nodes_ops = {
  */
 bool vfs_nodes_init(void)
 {
-	return hash_table_create(&nodes, 0, 0, &nodes_ops);
+	return ohash_table_create(&nodes, 0, &nodes_ops);
 }
 
 static inline void _vfs_node_addref(vfs_node_t *node)
@@ -117,7 +118,7 @@ void vfs_node_delref(vfs_node_t *node)
 		 * Remove it from the VFS node hash table.
 		 */
 
-		hash_table_remove_item(&nodes, &node->nh_link);
+		ohash_table_remove_item(&nodes, &node->nh_link);
 		free_node = true;
 	}
 
@@ -134,6 +135,7 @@ void vfs_node_delref(vfs_node_t *node)
 		    (sysarg_t)node->index);
 		vfs_exchange_release(exch);
 
+		vfs_cache_node_freed(node);
 		free(node);
 	}
 }
@@ -148,7 +150,7 @@ void vfs_node_delref(vfs_node_t *node)
 void vfs_node_forget(vfs_node_t *node)
 {
 	fibril_mutex_lock(&nodes_mutex);
-	hash_table_remove_item(&nodes, &node->nh_link);
+	ohash_table_remove_item(&nodes, &node->nh_link);
 	fibril_mutex_unlock(&nodes_mutex);
 	free(node);
 }
@@ -170,7 +172,7 @@ vfs_node_t *vfs_node_get(vfs_lookup_res_t *result)
 	vfs_node_t *node;
 
 	fibril_mutex_lock(&nodes_mutex);
-	ht_link_t *tmp = hash_table_find(&nodes, &result->triplet);
+	ht_link_t *tmp = ohash_table_find(&nodes, &result->triplet);
 	if (!tmp) {
 		node = (vfs_node_t *) malloc(sizeof(vfs_node_t));
 		if (!node) {
@@ -184,7 +186,11 @@ vfs_node_t *vfs_node_get(vfs_lookup_res_t *result)
 		node->size = result->size;
 		node->type = result->type;
 		fibril_rwlock_initialize(&node->contents_rwlock);
-		hash_table_insert(&nodes, &node->nh_link);
+		if (ohash_table_insert(&nodes, &node->nh_link) != EOK) {
+			fibril_mutex_unlock(&nodes_mutex);
+			free(node);
+			return NULL;
+		}
 	} else {
 		node = hash_table_get_inst(tmp, vfs_node_t, nh_link);
 	}
@@ -200,7 +206,7 @@ vfs_node_t *vfs_node_peek(vfs_lookup_res_t *result)
 	vfs_node_t *node = NULL;
 
 	fibril_mutex_lock(&nodes_mutex);
-	ht_link_t *tmp = hash_table_find(&nodes, &result->triplet);
+	ht_link_t *tmp = ohash_table_find(&nodes, &result->triplet);
 	if (tmp) {
 		node = hash_table_get_inst(tmp, vfs_node_t, nh_link);
 		_vfs_node_addref(node);
@@ -252,7 +258,7 @@ vfs_nodes_refcount_sum_get(fs_handle_t fs_handle, service_id_t service_id)
 	};
 
 	fibril_mutex_lock(&nodes_mutex);
-	hash_table_apply(&nodes, refcnt_visitor, &rd);
+	ohash_table_apply(&nodes, refcnt_visitor, &rd);
 	fibril_mutex_unlock(&nodes_mutex);
 
 	return rd.refcnt;
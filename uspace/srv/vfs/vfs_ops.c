@@ -208,13 +208,16 @@ errno_t vfs_op_fsprobe(const char *fs_name, service_id_t sid,
 	async_exch_t *exch = vfs_exchange_grab(fs_handle);
 	aid_t msg = async_send_1(exch, VFS_OUT_FSPROBE, (sysarg_t) sid,
 	    &answer);
-	if (msg == 0)
+	if (msg == 0) {
+		vfs_exchange_release(exch);
 		return EINVAL;
+	}
 
 	/* Read probe information */
 	retval = async_data_read_start(exch, info, sizeof(*info));
 	if (retval != EOK) {
 		async_forget(msg);
+		vfs_exchange_release(exch);
 		return retval;
 	}
 
@@ -312,7 +315,7 @@ errno_t vfs_op_open(int fd, int mode)
 	if (!file)
 		return EBADF;
 
-	if ((mode & ~file->permissions) != 0) {
+	if ((mode & ~(file->permissions | MODE_DIRECT)) != 0) {
 		vfs_file_put(file);
 		return EPERM;
 	}
@@ -325,6 +328,7 @@ errno_t vfs_op_open(int fd, int mode)
 	file->open_read = (mode & MODE_READ) != 0;
 	file->open_write = (mode & (MODE_WRITE | MODE_APPEND)) != 0;
 	file->append = (mode & MODE_APPEND) != 0;
+	file->direct = (mode & MODE_DIRECT) != 0;
 
 	if (!file->open_read && !file->open_write) {
 		vfs_file_put(file);
@@ -365,6 +369,17 @@ static errno_t rdwr_ipc_client(async_exch_t *exch, vfs_file_t *file, aoff64_t po
 	 * don't have to bother.
 	 */
 
+	if (read && !file->direct && vfs_cache_enabled(file->node)) {
+		rc = vfs_cache_read(exch, file->node, pos, bytes);
+		if (rc == EOK)
+			vfs_cache_access(file, pos, *bytes);
+		return rc;
+	}
+
+	/* Even direct writes must update pages cached for other readers. */
+	if (!read && vfs_cache_cached(file->node))
+		return vfs_cache_write(exch, file->node, pos, answer, bytes);
+
 	if (read) {
 		rc = async_data_read_forward_4_1(exch, VFS_OUT_READ,
 		    file->node->service_id, file->node->index,
@@ -407,6 +422,91 @@ static errno_t rdwr_ipc_internal(async_exch_t *exch, vfs_file_t *file, aoff64_t
 	return (errno_t) rc;
 }
 
+/** Directory entries being collected for a client. */
+typedef struct {
+	/** Buffer for the packed entry names */
+	char *buffer;
+	/** Size of the buffer */
+	size_t size;
+	/** Number of bytes filled in */
+	size_t used;
+	/** Position following the last entry read */
+	aoff64_t pos;
+} rdwr_readdir_t;
+
+static errno_t rdwr_ipc_readdir(async_exch_t *exch, vfs_file_t *file,
+    aoff64_t pos, ipc_call_t *answer, bool read, void *data)
+{
+	rdwr_readdir_t *rd = (rdwr_readdir_t *) data;
+	char name[VFS_DIRENT_NAME_SIZE];
+	errno_t rc = EOK;
+
+	if (exch == NULL)
+		return ENOENT;
+
+	if (file->node->type != VFS_NODE_DIRECTORY)
+		return ENOTDIR;
+
+	rd->used = 0;
+	rd->pos = pos;
+
+	/*
+	 * The file system servers return one entry per read. Collect as many
+	 * of them as fit so that the client needs only one request.
+	 */
+	while (rd->used < rd->size) {
+		aid_t msg = async_send_4(exch, VFS_OUT_READ,
+		    file->node->service_id, file->node->index,
+		    LOWER32(rd->pos), UPPER32(rd->pos), answer);
+		if (msg == 0) {
+			rc = EINVAL;
+			break;
+		}
+
+		errno_t retval = async_data_read_start(exch, name,
+		    sizeof(name));
+		if (retval != EOK) {
+			async_forget(msg);
+			rc = retval;
+			break;
+		}
+
+		async_wait_for(msg, &rc);
+		if (rc != EOK)
+			break;
+
+		size_t len = str_nsize(name, sizeof(name) - 1) + 1;
+		size_t step = ipc_get_arg1(answer);
+		if (step == 0 || len > rd->size - rd->used)
+			break;
+
+		memcpy(rd->buffer + rd->used, name, len - 1);
+		rd->buffer[rd->used + len - 1] = '\0';
+		rd->used += len;
+		rd->pos += step;
+	}
+
+	/*
+	 * Errors past the first entry, such as the end of the directory, are
+	 * reported by the next request.
+	 */
+	return rd->used > 0 ? EOK : rc;
+}
+
+static errno_t rdwr_ipc_page(async_exch_t *exch, vfs_file_t *file, aoff64_t pos,
+    ipc_call_t *answer, bool read, void *data)
+{
+	ipc_call_t *req = (ipc_call_t *) data;
+
+	if (exch == NULL)
+		return ENOENT;
+
+	if (!vfs_cache_enabled(file->node))
+		return ENOTSUP;
+
+	return vfs_cache_page_in(exch, file->node, pos, req);
+}
+
 static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
     void *ipc_cb_data)
 {
@@ -505,11 +605,56 @@ errno_t vfs_rdwr_internal(int fd, aoff64_t pos, bool read, rdwr_io_chunk_t *chun
 	return vfs_rdwr(fd, pos, read, rdwr_ipc_internal, chunk);
 }
 
+/** Answer a page-in request from the page cache.
+ *
+ * @param fd		File descriptor of the paged file
+ * @param pos		Page-aligned offset in the file
+ * @param req		IPC_M_PAGE_IN request, answered on success
+ *
+ * @return		EOK if the request was answered, ENOTSUP if the file
+ *			cannot be cached or another error code
+ */
+errno_t vfs_rdwr_page_in(int fd, aoff64_t pos, ipc_call_t *req)
+{
+	return vfs_rdwr(fd, pos, true, rdwr_ipc_page, req);
+}
+
 errno_t vfs_op_read(int fd, aoff64_t pos, size_t *out_bytes)
 {
 	return vfs_rdwr(fd, pos, true, rdwr_ipc_client, out_bytes);
 }
 
+/** Read several directory entries.
+ *
+ * @param fd		File descriptor of an open directory
+ * @param pos		Position of the first entry, updated to the position
+ *			following the last entry read
+ * @param buf		Buffer to fill with NUL-terminated entry names
+ * @param size		Size of the buffer
+ * @param out_bytes	Place to store the number of bytes filled in
+ *
+ * @return		EOK if at least one entry was read or an error code,
+ *			ENOENT at the end of the directory
+ */
+errno_t vfs_op_readdir(int fd, aoff64_t *pos, void *buf, size_t size,
+    size_t *out_bytes)
+{
+	rdwr_readdir_t rd = {
+		.buffer = buf,
+		.size = size,
+		.used = 0,
+		.pos = *pos
+	};
+
+	errno_t rc = vfs_rdwr(fd, *pos, true, rdwr_ipc_readdir, &rd);
+	if (rc != EOK)
+		return rc;
+
+	*pos = rd.pos;
+	*out_bytes = rd.used;
+	return EOK;
+}
+
 errno_t vfs_op_rename(int basefd, char *old, char *new)
 {
 	vfs_file_t *base_file = vfs_file_get(basefd);
@@ -600,6 +745,7 @@ errno_t vfs_op_rename(int basefd, char *old, char *new)
 	/* If the node is not held by anyone, try to destroy it. */
 	if (orig_unlinked) {
 		vfs_node_t *node = vfs_node_peek(&new_lr_orig);
+		vfs_cache_unlinked(&new_lr_orig.triplet, node != NULL);
 		if (!node)
 			out_destroy(&new_lr_orig.triplet);
 		else
@@ -626,8 +772,10 @@ errno_t vfs_op_resize(int fd, int64_t size)
 
 	errno_t rc = vfs_truncate_internal(file->node->fs_handle,
 	    file->node->service_id, file->node->index, size);
-	if (rc == EOK)
+	if (rc == EOK) {
+		vfs_cache_resize(file->node, size);
 		file->node->size = size;
+	}
 
 	fibril_rwlock_write_unlock(&file->node->contents_rwlock);
 	vfs_file_put(file);
@@ -768,6 +916,7 @@ errno_t vfs_op_unlink(int parentfd, int expectfd, char *path)
 
 	/* If the node is not held by anyone, try to destroy it. */
 	vfs_node_t *node = vfs_node_peek(&lr);
+	vfs_cache_unlinked(&lr.triplet, node != NULL);
 	if (!node)
 		out_destroy(&lr.triplet);
 	else
@@ -797,6 +946,10 @@ errno_t vfs_op_unmount(int mpfd)
 
 	fibril_rwlock_write_lock(&namespace_rwlock);
 
+	/* Cached lookups hold references to nodes of the file system. */
+	vfs_namecache_purge(mp->node->mount->fs_handle,
+	    mp->node->mount->service_id);
+
 	/*
 	 * Count the total number of references for the mounted file system. We
 	 * are expecting at least one, which is held by the mount point.
@@ -822,6 +975,8 @@ errno_t vfs_op_unmount(int mpfd)
 		return rc;
 	}
 
+	vfs_cache_unmounted(mp->node->mount->fs_handle,
+	    mp->node->mount->service_id);
 	vfs_node_forget(mp->node->mount);
 	vfs_node_put(mp->node);
 	mp->node->mount = NULL;
@@ -49,6 +49,16 @@ void vfs_page_in(ipc_call_t *req)
 	void *page;
 	errno_t rc;
 
+	if (page_size == PAGE_SIZE) {
+		rc = vfs_rdwr_page_in(fd, offset, req);
+		if (rc == EOK)
+			return;
+		if (rc != ENOTSUP) {
+			async_answer_0(req, rc);
+			return;
+		}
+	}
+
 	page = as_area_create(AS_AREA_ANY, page_size,
 	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
 	    AS_AREA_UNPAGED);
@@ -80,10 +90,8 @@ void vfs_page_in(ipc_call_t *req)
 	async_answer_1(req, rc, (sysarg_t) page);
 
 	/*
-	 * FIXME:
-	 * This is just for now until we implement proper page cache
-	 * management.  Not keeping the pages around in a cache results in
-	 * inherently non-coherent private mappings.
+	 * Files which cannot be cached get a fresh copy of the page, which
+	 * makes their mappings inherently non-coherent.
 	 */
 	as_area_destroy(page);
 }
@@ -36,6 +36,7 @@
 
 #include <adt/list.h>
 #include <errno.h>
+#include <fibril.h>
 #include <fibril_synch.h>
 #include <io/log.h>
 #include <loc.h>
@@ -53,6 +54,9 @@
 #include "volume.h"
 
 static errno_t vol_part_add_locked(vol_parts_t *, service_id_t);
+static errno_t vol_part_prepare(vol_parts_t *, service_id_t, vol_part_t **);
+static errno_t vol_part_add_probed_locked(vol_part_t *);
+static void vol_part_delete(vol_part_t *);
 static void vol_part_remove_locked(vol_part_t *);
 static errno_t vol_part_find_by_id_ref_locked(vol_parts_t *, service_id_t,
     vol_part_t **);
@@ -71,6 +75,29 @@ static struct fsname_type fstab[] = {
 	{ NULL, 0 }
 };
 
+/** Batch of partitions probed in parallel */
+typedef struct {
+	/** Synchronize access to @c pending */
+	fibril_mutex_t lock;
+	/** Signalled when the last probe finishes */
+	fibril_condvar_t done_cv;
+	/** Number of probes still running */
+	size_t pending;
+} vol_probe_batch_t;
+
+/** Probe of one partition within a batch */
+typedef struct {
+	/** Containing batch */
+	vol_probe_batch_t *batch;
+	/** Partition to probe */
+	vol_part_t *part;
+	/** Result of the probe */
+	errno_t rc;
+} vol_probe_job_t;
+
+static errno_t vol_part_probe_fs(vol_part_t *);
+static void vol_part_probe_batch(vol_probe_job_t *, size_t);
+
 static const char *fstype_str(vol_fstype_t fstype)
 {
 	struct fsname_type *fst;
@@ -94,6 +121,8 @@ static errno_t vol_part_check_new(vol_parts_t *parts)
 	category_id_t part_cat;
 	service_id_t *svcs;
 	size_t count, i;
+	size_t njobs;
+	vol_probe_job_t *jobs;
 	link_t *cur, *next;
 	vol_part_t *part;
 	errno_t rc;
@@ -115,7 +144,16 @@ static errno_t vol_part_check_new(vol_parts_t *parts)
 		return EIO;
 	}
 
+	jobs = calloc(count, sizeof(vol_probe_job_t));
+	if (count > 0 && jobs == NULL) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Out of memory.");
+		free(svcs);
+		fibril_mutex_unlock(&parts->lock);
+		return ENOMEM;
+	}
+
 	/* Check for new partitions */
+	njobs = 0;
 	for (i = 0; i < count; i++) {
 		already_known = false;
 
@@ -130,14 +168,37 @@ static errno_t vol_part_check_new(vol_parts_t *parts)
 		if (!already_known) {
 			log_msg(LOG_DEFAULT, LVL_DEBUG, "Found partition '%lu'",
 			    (unsigned long) svcs[i]);
-			rc = vol_part_add_locked(parts, svcs[i]);
+			rc = vol_part_prepare(parts, svcs[i], &part);
 			if (rc != EOK) {
 				log_msg(LOG_DEFAULT, LVL_ERROR, "Could not add "
 				    "partition.");
+				continue;
 			}
+
+			jobs[njobs++].part = part;
+		}
+	}
+
+	/*
+	 * Probing takes several round trips to the file system servers
+	 * for each partition, do it for all the new partitions at once.
+	 */
+	vol_part_probe_batch(jobs, njobs);
+
+	/* Add the new partitions in the order they were found */
+	for (i = 0; i < njobs; i++) {
+		rc = jobs[i].rc;
+		if (rc == EOK)
+			rc = vol_part_add_probed_locked(jobs[i].part);
+		if (rc != EOK) {
+			log_msg(LOG_DEFAULT, LVL_ERROR, "Could not add "
+			    "partition.");
+			vol_part_delete(jobs[i].part);
 		}
 	}
 
+	free(jobs);
+
 	/* Check for removed partitions */
 	cur = list_first(&parts->parts);
 	while (cur != NULL) {
@@ -200,19 +261,24 @@ static void vol_part_delete(vol_part_t *part)
 	free(part);
 }
 
-static errno_t vol_part_probe(vol_part_t *part)
+/** Determine the contents of a partition.
+ *
+ * This does not access the partition list, so it can be done for several
+ * partitions in parallel.
+ *
+ * @param part Partition
+ * @return EOK on success or an error code
+ */
+static errno_t vol_part_probe_fs(vol_part_t *part)
 {
 	bool empty;
 	vfs_fs_probe_info_t info;
 	struct fsname_type *fst;
 	char *label;
-	vol_volume_t *volume;
 	errno_t rc;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Probe partition %s", part->svc_name);
 
-	assert(fibril_mutex_is_locked(&part->parts->lock));
-
 	fst = &fstab[0];
 	while (fst->name != NULL) {
 		rc = vfs_fsprobe(fst->name, part->svc_id, &info);
@@ -255,16 +321,89 @@ static errno_t vol_part_probe(vol_part_t *part)
 		part->label = label;
 	}
 
+	return EOK;
+
+error:
+	return rc;
+}
+
+/** Fibril probing one partition of a batch.
+ *
+ * @param arg Probe job (vol_probe_job_t *)
+ * @return EOK
+ */
+static errno_t vol_part_probe_fibril(void *arg)
+{
+	vol_probe_job_t *job = (vol_probe_job_t *) arg;
+	vol_probe_batch_t *batch = job->batch;
+
+	job->rc = vol_part_probe_fs(job->part);
+
+	fibril_mutex_lock(&batch->lock);
+	if (--batch->pending == 0)
+		fibril_condvar_broadcast(&batch->done_cv);
+	fibril_mutex_unlock(&batch->lock);
+
+	return EOK;
+}
+
+/** Probe several partitions in parallel.
+ *
+ * Each partition is probed in its own fibril. Returns when all the probes
+ * have finished, the result of each is stored in its job.
+ *
+ * @param jobs Probe jobs
+ * @param njobs Number of jobs
+ */
+static void vol_part_probe_batch(vol_probe_job_t *jobs, size_t njobs)
+{
+	vol_probe_batch_t batch;
+	size_t i;
+
+	fibril_mutex_initialize(&batch.lock);
+	fibril_condvar_initialize(&batch.done_cv);
+	batch.pending = 0;
+
+	for (i = 0; i < njobs; i++) {
+		jobs[i].batch = &batch;
+
+		fid_t fid = fibril_create(vol_part_probe_fibril, &jobs[i]);
+		if (fid == 0) {
+			/* Probe it in this fibril instead */
+			jobs[i].rc = vol_part_probe_fs(jobs[i].part);
+			continue;
+		}
+
+		fibril_mutex_lock(&batch.lock);
+		batch.pending++;
+		fibril_mutex_unlock(&batch.lock);
+		fibril_add_ready(fid);
+	}
+
+	fibril_mutex_lock(&batch.lock);
+	while (batch.pending > 0)
+		fibril_condvar_wait(&batch.done_cv, &batch.lock);
+	fibril_mutex_unlock(&batch.lock);
+}
+
+static errno_t vol_part_probe(vol_part_t *part)
+{
+	vol_volume_t *volume;
+	errno_t rc;
+
+	assert(fibril_mutex_is_locked(&part->parts->lock));
+
+	rc = vol_part_probe_fs(part);
+	if (rc != EOK)
+		return rc;
+
 	/* Look up new or existing volume. */
 	rc = vol_volume_lookup_ref(part->parts->volumes, part->label, &volume);
 	if (rc != EOK)
-		goto error;
+		return rc;
 
 	part->volume = volume;
 	return EOK;
-
-error:
-	return rc;
 }
 
 /** Determine if partition is allowed to be mounted by default.
@@ -405,13 +544,21 @@ static errno_t vol_part_mount(vol_part_t *part)
 	return rc;
 }
 
-static errno_t vol_part_add_locked(vol_parts_t *parts, service_id_t sid)
+/** Create a structure for a new partition, without probing it.
+ *
+ * @param parts Partitions
+ * @param sid Service ID of the partition
+ * @param rpart Place to store pointer to the new partition
+ * @return EOK on success, EEXIST if the partition is already known or
+ *         an error code
+ */
+static errno_t vol_part_prepare(vol_parts_t *parts, service_id_t sid,
+    vol_part_t **rpart)
 {
 	vol_part_t *part;
 	errno_t rc;
 
 	assert(fibril_mutex_is_locked(&parts->lock));
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "vol_part_add_locked(%zu)", sid);
 
 	/* Check for duplicates */
 	rc = vol_part_find_by_id_ref_locked(parts, sid, &part);
@@ -432,22 +579,66 @@ static errno_t vol_part_add_locked(vol_parts_t *parts, service_id_t sid)
 	rc = loc_service_get_name(sid, &part->svc_name);
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed getting service name.");
-		goto error;
+		vol_part_delete(part);
+		return rc;
 	}
 
-	rc = vol_part_probe(part);
+	*rpart = part;
+	return EOK;
+}
+
+/** Add a probed partition to the list and mount it.
+ *
+ * @param part Partition whose contents have been probed
+ *        by vol_part_probe_fs()
+ * @return EOK on success or an error code
+ */
+static errno_t vol_part_add_probed_locked(vol_part_t *part)
+{
+	vol_volume_t *volume;
+	errno_t rc;
+
+	assert(fibril_mutex_is_locked(&part->parts->lock));
+
+	/* Look up new or existing volume. */
+	rc = vol_volume_lookup_ref(part->parts->volumes, part->label, &volume);
 	if (rc != EOK)
-		goto error;
+		return rc;
+
+	part->volume = volume;
 
 	rc = vol_part_mount(part);
 	if (rc != EOK)
-		goto error;
+		return rc;
 
-	list_append(&part->lparts, &parts->parts);
+	list_append(&part->lparts, &part->parts->parts);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Added partition %zu", part->svc_id);
 
 	return EOK;
+}
+
+static errno_t vol_part_add_locked(vol_parts_t *parts, service_id_t sid)
+{
+	vol_part_t *part;
+	errno_t rc;
+
+	assert(fibril_mutex_is_locked(&parts->lock));
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "vol_part_add_locked(%zu)", sid);
+
+	rc = vol_part_prepare(parts, sid, &part);
+	if (rc != EOK)
+		return rc;
+
+	rc = vol_part_probe_fs(part);
+	if (rc != EOK)
+		goto error;
+
+	rc = vol_part_add_probed_locked(part);
+	if (rc != EOK)
+		goto error;
+
+	return EOK;
 
 error:
 	vol_part_delete(part);